@@ -46,6 +46,10 @@
  * (MCK/PCK frequency configuration),
  * The second part allows user to enter in a mode To measure consumption.
  * An amperemeter has to be plugged on the board instead of the VIN jumper.
+ *
+ * Before entering backup mode, the clock configuration is saved as a warm
+ * boot checkpoint (see warmboot.h). On the wake-up, it is restored at once
+ * instead of the default one, and the time spent in backup mode is reported.
   *
  * \section Usage
  *
@@ -541,9 +545,20 @@ static void _TestWaitMode( void )
  */
 static void _TestBackupMode( void )
 {
+    uint8_t ucConfig = CLOCK_GetCurrConfig() ;
+
     printf( "Enter in Backup Mode\n\r" ) ;
     printf( " - Touch the LCD screen to wakeup\n\r" ) ;
 
+    /* Checkpoint the clock configuration, the flash is only programmed when it changes */
+    FLASHD_Initialize( CLOCK_GetCurrMCK()*1000000, 0 ) ;
+    WARMBOOT_Set( WARMBOOT_TAG_USER, &ucConfig, sizeof( ucConfig ) ) ;
+    WARMBOOT_SetWord( WARMBOOT_GetWord() + 1 ) ;
+    if ( WARMBOOT_Save() != WARMBOOT_OK )
+    {
+        printf( "-E- Warm boot checkpoint not saved\n\r" ) ;
+    }
+
     /* Delay for a while */
     _Delay( 500 ) ;
 
@@ -646,6 +661,9 @@ test_core_end:
  */
 int main(void)
 {
+    uint8_t ucConfig = 0 ;
+    uint32_t dwWarm ;
+
     /* Set FWS for Embedded Flash Access */
     EFC->EEFC_FMR = (1 << 8);
 
@@ -655,8 +673,13 @@ int main(void)
     /* initialize the chip for the power consumption test */
     _InitChip() ;
 
-    /* Set default clock */
-    CLOCK_SetConfig( 0 ) ;
+    /* Set default clock, or the one in use before the backup mode */
+    dwWarm = WARMBOOT_Restore() ;
+    if ( dwWarm )
+    {
+        WARMBOOT_Get( WARMBOOT_TAG_USER, &ucConfig, sizeof( ucConfig ) ) ;
+    }
+    CLOCK_SetConfig( ucConfig ) ;
     printf( "\n\rThe core (PCK) is running @ %dMhz and peripherals (MCK) @ %dMHz\n\r", CLOCK_GetCurrPCK(), CLOCK_GetCurrMCK() ) ;
 
     /* Output example information */
@@ -665,6 +688,11 @@ int main(void)
     printf( "-- %s\n\r", BOARD_NAME ) ;
     printf( "-- Compiled: %s %s --\n\r", __DATE__, __TIME__ ) ;
 
+    if ( dwWarm )
+    {
+        printf( "Warm wake #%u after %u s in backup mode\n\r", (unsigned int)WARMBOOT_GetWord(), (unsigned int)WARMBOOT_GetElapsed() ) ;
+    }
+
     /* Configure pios */
     /* pinPenIRQ for wait & backup mode wakeup input */
     /* pinPB1 for sleep mode wakeup input*/
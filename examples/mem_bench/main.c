@@ -0,0 +1,611 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page mem_bench Memory Benchmark Example
+ *
+ * \section Purpose
+ *
+ * The Memory Benchmark Example measures the bandwidth and the latency of the
+ * memories of the SAM3S-EK as seen by the core: internal SRAM, internal flash
+ * at each wait state setting, and the PSRAM and NorFlash on the SMC with the
+ * timings of board_memories.c. The figures tell which buffers are worth
+ * placing in the PSRAM (HEAP_PSRAM, HEAP_PSRAM_FIRST of heap.h) and which must
+ * stay in the internal SRAM.
+ *
+ * \section Description
+ *
+ * Each memory is accessed over BENCH_SIZE bytes with byte, halfword and word
+ * accesses, and with 8-word LDM/STM bursts:
+ * - sequential read and write, shown as a bandwidth in KB/s;
+ * - random read and write at BENCH_RANDOM_OPS offsets taken from a table in
+ *   SRAM, shown as core cycles per access (per burst for LDM/STM).
+ *
+ * The times are measured with the DWT cycle counter, interrupts masked, and
+ * the best of BENCH_RUNS passes is kept. The loop overhead is part of the
+ * figures, so the internal SRAM rows are the reference the other rows are
+ * compared with.
+ *
+ * The flash is read at every wait state setting from the one set at startup
+ * (the lowest allowed at BOARD_MCK) up to FLASH_MAX_FWS, then the setting is
+ * restored. With the flash target, the code is fetched from the flash too,
+ * which is what an application sees. The flash and the NorFlash are only read.
+ *
+ * Last, the cycles taken by MEM_Copy(), MEM_Set() and MEM_Zero() of memops.h
+ * are compared with the C library memcpy() and memset() in the SRAM.
+ *
+ * \warning The benchmark overwrites BENCH_SIZE bytes of the PSRAM.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it inside the evaluation board. Please
+ *    refer to the
+ *    <a href="http://www.atmel.com/dyn/resources/prod_documents/doc6224.pdf">
+ *    SAM-BA User Guide</a>, the
+ *    <a href="http://www.atmel.com/dyn/resources/prod_documents/doc6310.pdf">
+ *    GNU-Based Software Development</a> application note or to the
+ *    <a href="ftp://ftp.iar.se/WWWfiles/arm/Guides/EWARM_UserGuide.ENU.pdf">
+ *    IAR EWARM User Guide</a>, depending on your chosen solution.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 bauds
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application.
+ * -# In the terminal window, the following text should appear:
+ *     \code
+ *     -- Memory Benchmark Example xxx --
+ *     -- xxxxxx-xx
+ *     -- Compiled: xxx xx xxxx xx:xx:xx --
+ *     \endcode
+ * -# The SMC timings are printed, then one table row per memory and access
+ *    width, and the word read bandwidth of each memory relative to the SRAM.
+ */
+
+/**
+ * \file
+ *
+ * This file contains all the specific code for the
+ * mem_bench example.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "board.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Size of the area accessed in each memory, in bytes. */
+#define BENCH_SIZE          (8*1024)
+
+/** Number of accesses of a random run. */
+#define BENCH_RANDOM_OPS    1024
+
+/** Passes of each run, the fastest one is kept. */
+#define BENCH_RUNS          3
+
+/** Size of a LDM/STM burst, in bytes (8 registers). */
+#define BENCH_BURST         32
+
+/** Largest block of the memory primitives comparison, in bytes. */
+#define MEMOPS_MAX_SIZE     2048
+
+/** Highest flash wait state setting measured. */
+#define FLASH_MAX_FWS       6
+
+/** Maximum number of memories in the table. */
+#define MAX_REGIONS         (4 + FLASH_MAX_FWS)
+
+/** Run kinds. */
+#define KERNEL_SEQREAD      0
+#define KERNEL_SEQWRITE     1
+#define KERNEL_RANDREAD     2
+#define KERNEL_RANDWRITE    3
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Results of one memory. */
+typedef struct _BenchRegion {
+
+    /** Name printed in the table. */
+    char szName[16];
+    /** Word sequential read bandwidth, in KB/s. */
+    uint32_t dwWordReadKBs;
+
+} BenchRegion;
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Internal SRAM area. */
+static uint8_t sramBuffer[BENCH_SIZE] __attribute__ ((aligned (32)));
+
+/** Offsets of the random runs, in SRAM so that they cost the same for all
+    the memories. */
+static uint16_t randomOffsets[BENCH_RANDOM_OPS];
+
+/** Access widths, in bytes, and their names. */
+static const uint32_t benchWidths[] = {1, 2, 4, BENCH_BURST};
+static const char *widthNames[] = {"byte", "half", "word", "ldm"};
+
+/** Measured memories. */
+static BenchRegion regions[MAX_REGIONS];
+static uint32_t numRegions = 0;
+
+/** Sink of the read accesses. */
+static volatile uint32_t benchSink;
+
+/** Pseudo-random generator state. */
+static uint32_t randomState = 1;
+
+/** Pins used to access to the PSRAM. */
+static const Pin pPinsPsram[] = {PIN_EBI_DATA_BUS, PIN_EBI_NRD, PIN_EBI_NWE,
+                                 PIN_EBI_NCS1, PIN_EBI_PSRAM_ADDR_BUS,
+                                 PIN_EBI_PSRAM_NBS};
+#ifdef PINS_NORFLASH
+/** Pins used to access to the norflash. */
+static const Pin pPinsNor[] = {PINS_NORFLASH};
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Returns the next value of the pseudo-random generator.
+ */
+static uint32_t _Random(void)
+{
+    randomState = randomState * 1103515245 + 12345;
+    return randomState >> 8;
+}
+
+/**
+ * \brief Fills the random offsets table for an access width.
+ *
+ * \param dwWidth  Access width in bytes.
+ */
+static void _FillOffsets(uint32_t dwWidth)
+{
+    uint32_t i;
+
+    randomState = 1;
+    for (i = 0; i < BENCH_RANDOM_OPS; i++) {
+
+        randomOffsets[i] = (uint16_t)((_Random() % (BENCH_SIZE / dwWidth)) * dwWidth);
+    }
+}
+
+/**
+ * \brief Reads BENCH_SIZE bytes with 8-word LDM bursts.
+ */
+static void _LdmRead(uint32_t dwAddress)
+{
+    uint32_t dwEnd = dwAddress + BENCH_SIZE;
+
+    asm volatile(
+        "1: ldmia   %0!, {r3-r6, r8-r10, r12}\n\t"
+        "   cmp     %0, %1\n\t"
+        "   bne     1b\n\t"
+        : "+r" (dwAddress)
+        : "r" (dwEnd)
+        : "r3", "r4", "r5", "r6", "r8", "r9", "r10", "r12", "cc", "memory");
+}
+
+/**
+ * \brief Writes BENCH_SIZE bytes with 8-word STM bursts.
+ */
+static void _StmWrite(uint32_t dwAddress)
+{
+    uint32_t dwEnd = dwAddress + BENCH_SIZE;
+
+    asm volatile(
+        "   mov     r3, #0\n\t"
+        "   mov     r4, #0\n\t"
+        "   mov     r5, #0\n\t"
+        "   mov     r6, #0\n\t"
+        "   mov     r8, #0\n\t"
+        "   mov     r9, #0\n\t"
+        "   mov     r10, #0\n\t"
+        "   mov     r12, #0\n\t"
+        "1: stmia   %0!, {r3-r6, r8-r10, r12}\n\t"
+        "   cmp     %0, %1\n\t"
+        "   bne     1b\n\t"
+        : "+r" (dwAddress)
+        : "r" (dwEnd)
+        : "r3", "r4", "r5", "r6", "r8", "r9", "r10", "r12", "cc", "memory");
+}
+
+/**
+ * \brief Does one burst at each random offset, reading or writing.
+ */
+static void _LdmRandom(uint32_t dwAddress, uint8_t bWrite)
+{
+    uint32_t i;
+    uint32_t dwBurst;
+
+    for (i = 0; i < BENCH_RANDOM_OPS; i++) {
+
+        dwBurst = dwAddress + randomOffsets[i];
+        if (bWrite) {
+
+            asm volatile(
+                "   stmia   %0, {r3-r6, r8-r10, r12}\n\t"
+                :
+                : "r" (dwBurst)
+                : "memory");
+        }
+        else {
+
+            asm volatile(
+                "   ldmia   %0, {r3-r6, r8-r10, r12}\n\t"
+                :
+                : "r" (dwBurst)
+                : "r3", "r4", "r5", "r6", "r8", "r9", "r10", "r12", "memory");
+        }
+    }
+}
+
+/** Sequential and random loops of an access type, unrolled by four. */
+#define SEQREAD_LOOP(type) { \
+    const volatile type *p = (const volatile type *)dwAddress; \
+    for (i = 0; i < BENCH_SIZE / sizeof(type); i += 4) { \
+        dwSum += p[i]; dwSum += p[i+1]; dwSum += p[i+2]; dwSum += p[i+3]; \
+    } }
+#define SEQWRITE_LOOP(type) { \
+    volatile type *p = (volatile type *)dwAddress; \
+    for (i = 0; i < BENCH_SIZE / sizeof(type); i += 4) { \
+        p[i] = (type)i; p[i+1] = (type)i; p[i+2] = (type)i; p[i+3] = (type)i; \
+    } }
+#define RANDREAD_LOOP(type) { \
+    for (i = 0; i < BENCH_RANDOM_OPS; i++) { \
+        dwSum += *(const volatile type *)(dwAddress + randomOffsets[i]); \
+    } }
+#define RANDWRITE_LOOP(type) { \
+    for (i = 0; i < BENCH_RANDOM_OPS; i++) { \
+        *(volatile type *)(dwAddress + randomOffsets[i]) = (type)i; \
+    } }
+
+/**
+ * \brief Runs one pass of a kernel over a memory.
+ *
+ * \param dwAddress  Start of the area, aligned on BENCH_BURST.
+ * \param dwKernel  KERNEL_xxx.
+ * \param dwWidth  Access width in bytes, BENCH_BURST for LDM/STM.
+ *
+ * \return Duration of the pass, in core cycles.
+ */
+static uint32_t _RunPass(uint32_t dwAddress, uint32_t dwKernel, uint32_t dwWidth)
+{
+    uint32_t i;
+    uint32_t dwSum = 0;
+    uint32_t dwStart;
+    uint32_t dwCycles;
+
+    __disable_irq();
+    dwStart = DWT_CYCCNT;
+    switch (dwKernel) {
+
+    case KERNEL_SEQREAD:
+        if (dwWidth == 1)       SEQREAD_LOOP(uint8_t)
+        else if (dwWidth == 2)  SEQREAD_LOOP(uint16_t)
+        else if (dwWidth == 4)  SEQREAD_LOOP(uint32_t)
+        else                    _LdmRead(dwAddress);
+        break;
+
+    case KERNEL_SEQWRITE:
+        if (dwWidth == 1)       SEQWRITE_LOOP(uint8_t)
+        else if (dwWidth == 2)  SEQWRITE_LOOP(uint16_t)
+        else if (dwWidth == 4)  SEQWRITE_LOOP(uint32_t)
+        else                    _StmWrite(dwAddress);
+        break;
+
+    case KERNEL_RANDREAD:
+        if (dwWidth == 1)       RANDREAD_LOOP(uint8_t)
+        else if (dwWidth == 2)  RANDREAD_LOOP(uint16_t)
+        else if (dwWidth == 4)  RANDREAD_LOOP(uint32_t)
+        else                    _LdmRandom(dwAddress, 0);
+        break;
+
+    default:
+        if (dwWidth == 1)       RANDWRITE_LOOP(uint8_t)
+        else if (dwWidth == 2)  RANDWRITE_LOOP(uint16_t)
+        else if (dwWidth == 4)  RANDWRITE_LOOP(uint32_t)
+        else                    _LdmRandom(dwAddress, 1);
+        break;
+    }
+    dwCycles = DWT_CYCCNT - dwStart;
+    __enable_irq();
+
+    benchSink = dwSum;
+    return dwCycles;
+}
+
+/**
+ * \brief Runs a kernel BENCH_RUNS times and returns the fastest pass.
+ */
+static uint32_t _Run(uint32_t dwAddress, uint32_t dwKernel, uint32_t dwWidth)
+{
+    uint32_t i;
+    uint32_t dwCycles;
+    uint32_t dwBest = 0xFFFFFFFF;
+
+    if (dwKernel >= KERNEL_RANDREAD) {
+
+        _FillOffsets(dwWidth);
+    }
+    for (i = 0; i < BENCH_RUNS; i++) {
+
+        dwCycles = _RunPass(dwAddress, dwKernel, dwWidth);
+        if (dwCycles < dwBest) {
+
+            dwBest = dwCycles;
+        }
+    }
+    return dwBest;
+}
+
+/**
+ * \brief Converts the cycles of a sequential run to KB/s.
+ */
+static uint32_t _ToKBs(uint32_t dwCycles)
+{
+    return (uint32_t)(((uint64_t)BENCH_SIZE * BOARD_MCK) / ((uint64_t)dwCycles * 1024));
+}
+
+/**
+ * \brief Prints the cycles per access of a random run, with two decimals.
+ */
+static void _PrintLatency(uint32_t dwCycles)
+{
+    uint32_t dwHundredths = (dwCycles * 100 + BENCH_RANDOM_OPS / 2) / BENCH_RANDOM_OPS;
+
+    printf(" %6u.%02u", (unsigned int)(dwHundredths / 100), (unsigned int)(dwHundredths % 100));
+}
+
+/**
+ * \brief Measures a memory and prints its rows.
+ *
+ * \param pName  Name of the memory.
+ * \param dwAddress  Start of the area, aligned on BENCH_BURST.
+ * \param bWritable  Non-zero when the write runs can be done.
+ */
+static void _BenchRegion(const char *pName, uint32_t dwAddress, uint8_t bWritable)
+{
+    BenchRegion *pRegion = &regions[numRegions++];
+    uint32_t w;
+    uint32_t dwKBs;
+
+    snprintf(pRegion->szName, sizeof(pRegion->szName), "%s", pName);
+    for (w = 0; w < sizeof(benchWidths) / sizeof(benchWidths[0]); w++) {
+
+        printf("%-12s %-4s", pName, widthNames[w]);
+
+        dwKBs = _ToKBs(_Run(dwAddress, KERNEL_SEQREAD, benchWidths[w]));
+        if (benchWidths[w] == 4) {
+
+            pRegion->dwWordReadKBs = dwKBs;
+        }
+        printf(" %9u", (unsigned int)dwKBs);
+        if (bWritable) {
+
+            printf(" %9u", (unsigned int)_ToKBs(_Run(dwAddress, KERNEL_SEQWRITE, benchWidths[w])));
+        }
+        else {
+
+            printf("         -");
+        }
+
+        _PrintLatency(_Run(dwAddress, KERNEL_RANDREAD, benchWidths[w]));
+        if (bWritable) {
+
+            _PrintLatency(_Run(dwAddress, KERNEL_RANDWRITE, benchWidths[w]));
+        }
+        else {
+
+            printf("          -");
+        }
+        printf("\n\r");
+    }
+}
+
+/**
+ * \brief Prints the SMC timings of a chip select.
+ */
+static void _PrintSmcTimings(const char *pName, uint32_t dwCs)
+{
+    printf("-I- %s NCS%u: SETUP 0x%08x PULSE 0x%08x CYCLE 0x%08x MODE 0x%08x\n\r",
+           pName, (unsigned int)dwCs,
+           (unsigned int)SMC->SMC_CS_NUMBER[dwCs].SMC_SETUP,
+           (unsigned int)SMC->SMC_CS_NUMBER[dwCs].SMC_PULSE,
+           (unsigned int)SMC->SMC_CS_NUMBER[dwCs].SMC_CYCLE,
+           (unsigned int)SMC->SMC_CS_NUMBER[dwCs].SMC_MODE);
+}
+
+/**
+ * \brief Measures the internal flash at each wait state setting from the
+ * current one to FLASH_MAX_FWS. Lower settings are out of the flash timings
+ * at BOARD_MCK and are not tried.
+ */
+static void _BenchFlash(void)
+{
+    uint32_t dwFws;
+    uint32_t dwStartFws;
+    char szName[16];
+
+    dwStartFws = (EFC->EEFC_FMR & EEFC_FMR_FWS_Msk) >> EEFC_FMR_FWS_Pos;
+    for (dwFws = dwStartFws; dwFws <= FLASH_MAX_FWS; dwFws++) {
+
+        EFC_SetWaitState(EFC, (uint8_t)dwFws);
+        snprintf(szName, sizeof(szName), "Flash FWS=%u", (unsigned int)dwFws);
+        _BenchRegion(szName, IFLASH_ADDR, 0);
+    }
+    EFC_SetWaitState(EFC, (uint8_t)dwStartFws);
+}
+
+/**
+ * \brief Prints the cycles taken by MEM_Copy(), MEM_Set() and MEM_Zero() and
+ * by the C library memcpy() and memset(), for a few sizes and alignments.
+ * The blocks are taken from sramBuffer.
+ */
+static void _BenchMemOps(void)
+{
+    static const uint16_t sizes[] = {16, 64, 512, MEMOPS_MAX_SIZE};
+    uint8_t *pDst = sramBuffer;
+    uint8_t *pSrc = sramBuffer + MEMOPS_MAX_SIZE + 4;
+    uint32_t dwSize;
+    uint32_t dwLib;
+    uint32_t dwMem;
+    uint32_t dwOffset;
+    uint32_t i;
+
+    for (i = 0; i < MEMOPS_MAX_SIZE; i++) {
+
+        pSrc[i] = (uint8_t)i;
+    }
+
+    printf("-I- Memory primitives, cycles (C library / MEM_xxx):\n\r");
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+
+        dwSize = sizes[i];
+        for (dwOffset = 0; dwOffset < 2; dwOffset++) {
+
+            dwLib = DWT_CYCCNT;
+            memcpy(pDst, pSrc + dwOffset, dwSize - dwOffset);
+            dwLib = DWT_CYCCNT - dwLib;
+            dwMem = DWT_CYCCNT;
+            MEM_Copy(pDst, pSrc + dwOffset, dwSize - dwOffset);
+            dwMem = DWT_CYCCNT - dwMem;
+            printf("  copy %4u, src +%u : %6u / %6u\n\r", (unsigned int)dwSize, (unsigned int)dwOffset,
+                   (unsigned int)dwLib, (unsigned int)dwMem);
+            if (memcmp(pDst, pSrc + dwOffset, dwSize - dwOffset) != 0) {
+
+                printf("-E- MEM_Copy mismatch\n\r");
+            }
+        }
+
+        dwLib = DWT_CYCCNT;
+        memset(pDst, 0xA5, dwSize);
+        dwLib = DWT_CYCCNT - dwLib;
+        dwMem = DWT_CYCCNT;
+        MEM_Set(pDst, 0xA5, dwSize);
+        dwMem = DWT_CYCCNT - dwMem;
+        printf("  set  %4u         : %6u / %6u\n\r", (unsigned int)dwSize, (unsigned int)dwLib, (unsigned int)dwMem);
+
+        dwLib = DWT_CYCCNT;
+        memset(pDst, 0, dwSize);
+        dwLib = DWT_CYCCNT - dwLib;
+        dwMem = DWT_CYCCNT;
+        MEM_Zero(pDst, dwSize);
+        dwMem = DWT_CYCCNT - dwMem;
+        printf("  zero %4u         : %6u / %6u\n\r", (unsigned int)dwSize, (unsigned int)dwLib, (unsigned int)dwMem);
+    }
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief mem_bench Application entry point.
+ *
+ * \return Unused (ANSI-C compatibility).
+ */
+int main(void)
+{
+    uint8_t *pPsram;
+    uint32_t i;
+
+    /* Disable watchdog */
+    WDT_Disable( WDT ) ;
+
+    /* Output example information */
+    printf("-- Memory Benchmark Example %s --\n\r", SOFTPACK_VERSION);
+    printf("-- %s\n\r", BOARD_NAME);
+    printf("-- Compiled: %s %s --\n\r", __DATE__, __TIME__);
+
+    /* Start the cycle counter */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+
+    /* Configure the external memories with the board timings */
+    PIO_Configure(pPinsPsram, PIO_LISTSIZE(pPinsPsram));
+    BOARD_ConfigurePSRAM(SMC);
+    pPsram = (uint8_t*)BOARD_PsramAlloc(BENCH_SIZE);
+    _PrintSmcTimings("PSRAM", 1);
+#ifdef PINS_NORFLASH
+    PIO_Configure(pPinsNor, PIO_LISTSIZE(pPinsNor));
+    BOARD_ConfigureNorFlash(SMC);
+    _PrintSmcTimings("NorFlash", 3);
+#endif
+
+    printf("-I- %u bytes per run, %u random accesses, MCK %u Hz\n\r",
+           BENCH_SIZE, BENCH_RANDOM_OPS, BOARD_MCK);
+    printf("memory       acc   rd KB/s   wr KB/s  rnd rd cyc rnd wr cyc\n\r");
+
+    _BenchRegion("SRAM", (uint32_t)sramBuffer, 1);
+    _BenchFlash();
+    if (pPsram) {
+
+        _BenchRegion("PSRAM", (uint32_t)pPsram, 1);
+    }
+    else {
+
+        printf("-I- No PSRAM left\n\r");
+    }
+#ifdef PINS_NORFLASH
+    _BenchRegion("NorFlash", BOARD_NORFLASH_ADDR, 0);
+#endif
+
+    /* Word read bandwidth relative to the SRAM, for the heap placement */
+    printf("-I- Word read bandwidth relative to the SRAM:\n\r");
+    for (i = 1; i < numRegions; i++) {
+
+        printf("    %-12s %3u%%\n\r", regions[i].szName,
+               (unsigned int)((regions[i].dwWordReadKBs * 100) / regions[0].dwWordReadKBs));
+    }
+
+    _BenchMemOps();
+    printf("-I- Done\n\r");
+
+    while (1);
+}
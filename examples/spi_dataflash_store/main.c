@@ -225,8 +225,6 @@ unsigned int erase(void)
 
 void	fw_write(void)
 {
-	unsigned int addr, page, i;
-	char *pfw = fw;
 	char *info;
 
 	info	= (char *) pBuffer;
@@ -237,14 +235,8 @@ void	fw_write(void)
 	info += sprintf(info, "<SIZE>%u</SIZE>\r\n", fw_size);
 	AT45D_Write(&at45, pBuffer, pagesize, INFOBLOCK);
 
-	addr = 0;
-	for (page = 1; page < maxpage; page++) {
-		for (i = 0; i < pagesize; i++) {
-			pBuffer[i] = *pfw++;
-		}
-		AT45D_Write(&at45, pBuffer, pagesize, addr);
-		addr += pagesize;
-	}
+	/* Load each page while the previous one is programmed */
+	AT45D_WritePipelined(&at45, (const uint8_t *) fw, (maxpage - 1) * pagesize, 0);
 }
 
 unsigned int fw_verify(void)
@@ -66,13 +66,15 @@
  * <li>Configure TWI clock.</li>
  * <li>Initialize TWI as twi master.</li>
  * <li>TWI interrupt handler.</li>
+ * <li>Initialize the AT24 EEPROM driver, with a RAM copy of the first pages.</li>
  * <li>The main function, which implements the program behavior.</li>
  * <ol>
- * <li>Sets the first and second page of the EEPROM to all zeroes.</li>
+ * <li>Sets the first and second page of the EEPROM to all zeroes, with a
+ * single write split into page bursts by the driver.</li>
  * <li>Writes pattern in page 0. </li>
- * <li>Reads back data in page 0 and compare with original pattern (polling). </li>
- * <li>Writes pattern in page 1. </li>
- * <li>Reads back data in page 1 and compare with original pattern (interrupts). </li>
+ * <li>Reads back data in page 0 and compare with original pattern (synchronous). </li>
+ * <li>Writes pattern across pages 0 and 1 (asynchronous). </li>
+ * <li>Loads the RAM copy, reads back data from it and compare with original pattern. </li>
  * </ol>
  * </ul>
  *
@@ -107,6 +109,7 @@
  * - twi_eeprom/main.c
  * - twi.c
  * - twid.c
+ * - at24.c
  */
 
 /**
@@ -140,6 +143,12 @@
 /** Page size of an AT24C512 chip (in bytes)*/
 #define PAGE_SIZE       64
 
+/** Size of an AT24C512 chip (in bytes)*/
+#define AT24C_SIZE      (64 * 1024)
+
+/** Size of the RAM copy of the EEPROM (in bytes)*/
+#define SHADOW_SIZE     (2 * PAGE_SIZE)
+
 
 /*----------------------------------------------------------------------------
  *        Local variables
@@ -150,8 +159,17 @@ static const Pin pins[] = {BOARD_PINS_TWI_EEPROM};
 /** TWI driver instance.*/
 static Twid twid;
 
+/** AT24 driver instance.*/
+static At24 at24;
+
+/** RAM copy of the first pages of the EEPROM.*/
+static uint8_t shadow[SHADOW_SIZE];
+
 /** Page buffer.*/
-static uint8_t pData[PAGE_SIZE];
+static uint8_t pData[2 * PAGE_SIZE];
+
+/** Set by the completion callback.*/
+static volatile uint8_t done;
 
 /*----------------------------------------------------------------------------
  *        Local functions
@@ -165,11 +183,49 @@ void TWI1_IrqHandler( void )
 }
 
 /**
- * \brief Dummy callback, to test asynchronous transfer modes.
+ * \brief Completion callback, to test asynchronous transfer modes.
+ */
+static void TestCallback( uint8_t status, void *pArgument )
+{
+    printf( "-I- Callback fired, status %d !\n\r", status ) ;
+    done = 1 ;
+}
+
+/**
+ * \brief Fills a buffer with a checkerboard pattern.
  */
-static void TestCallback( void )
+static void FillPattern( uint8_t *pBuffer, uint32_t size )
 {
-    printf( "-I- Callback fired !\n\r" ) ;
+    uint32_t i ;
+
+    for ( i=0 ; i < size ; i++ )
+    {
+        pBuffer[i] = ((i & 1) == 0) ? 0xA5 : 0x5A ;
+    }
+}
+
+/**
+ * \brief Compares a buffer with the checkerboard pattern.
+ * \return Number of mismatching bytes.
+ */
+static uint32_t CheckPattern( const uint8_t *pBuffer, uint32_t size )
+{
+    uint32_t numErrors = 0 ;
+    uint8_t expected ;
+    uint32_t i ;
+
+    for ( i=0 ; i < size ; i++ )
+    {
+        expected = ((i & 1) == 0) ? 0xA5 : 0x5A ;
+        if ( pBuffer[i] != expected )
+        {
+            printf( "-E- Data mismatch at offset #%d: expected 0x%02X, read 0x%02X\n\r", (unsigned int)i, expected, pBuffer[i] ) ;
+            numErrors++ ;
+        }
+    }
+    printf( "-I- %u comparison error(s) found\n\r", (unsigned int)numErrors ) ;
+
+    return numErrors ;
 }
 
 /*----------------------------------------------------------------------------
@@ -184,10 +240,6 @@ static void TestCallback( void )
 
 extern int main( void )
 {
-    volatile uint32_t i;
-    Async async;
-    uint32_t numErrors;
-
     /* Disable watchdog */
     WDT_Disable( WDT ) ;
 
@@ -209,129 +261,50 @@ extern int main( void )
     TWI_ConfigureMaster(BOARD_BASE_TWI_EEPROM, TWCK, BOARD_MCK);
     TWID_Initialize(&twid, BOARD_BASE_TWI_EEPROM);
 
-    /* Configure TWI interrupts */
+    /* Configure TWI interrupts, the EEPROM driver needs them */
     NVIC_DisableIRQ(TWI1_IRQn);
     NVIC_ClearPendingIRQ(TWI1_IRQn);
     NVIC_SetPriority(TWI1_IRQn, 0);
     NVIC_EnableIRQ(TWI1_IRQn);
 
+    /* Configure the EEPROM driver */
+    AT24_Initialize(&at24, &twid, AT24C_ADDRESS, 2, PAGE_SIZE, AT24C_SIZE, shadow, SHADOW_SIZE);
 
-    /* Erase page #0 and #1 */
-    memset(pData, 0, PAGE_SIZE);
-    printf("-I- Filling page #0 with zeroes ...\n\r");
-    TWID_Write(&twid, AT24C_ADDRESS, 0x0000, 2, pData, PAGE_SIZE, 0);
-
-    /* Wait at least 10 ms */
-    for (i=0; i < 1000000; i++);
+    /* Erase page #0 and #1: the driver waits for the end of each write cycle */
+    memset(pData, 0, sizeof(pData));
+    printf("-I- Filling pages #0 and #1 with zeroes ...\n\r");
+    if (AT24_Write(&at24, 0x0000, pData, 2 * PAGE_SIZE, 0, 0)) {
 
-    printf("-I- Filling page #1 with zeroes ...\n\r");
-    TWID_Write(&twid, AT24C_ADDRESS, 0x0100, 2, pData, PAGE_SIZE, 0);
-
-    /* Wait at least 10 ms */
-    for (i=0; i < 1000000; i++);
+        printf("-E- Write error\n\r");
+    }
 
     /* Synchronous operation */
-    printf("-I- Read/write on page #0 (polling mode)\n\r");
+    printf("-I- Read/write on page #0 (synchronous)\n\r");
 
     /* Write checkerboard pattern in first page */
-    for ( i=0 ; i < PAGE_SIZE ; i++ )
-    {
-        /* Even*/
-        if ( (i & 1) == 0 )
-        {
-            pData[i] = 0xA5;
-        }
-        /* Odd */
-        else
-        {
-            pData[i] = 0x5A;
-        }
-    }
-    TWID_Write(&twid, AT24C_ADDRESS, 0x0000, 2, pData, PAGE_SIZE, 0);
-
-    /* Wait at least 10 ms */
-    for (i=0; i < 1000000; i++);
+    FillPattern(pData, PAGE_SIZE);
+    AT24_Write(&at24, 0x0000, pData, PAGE_SIZE, 0, 0);
 
     /* Read back data */
     memset(pData, 0, PAGE_SIZE);
-    TWID_Read(&twid, AT24C_ADDRESS, 0x0000, 2, pData, PAGE_SIZE, 0);
-
-    /* Compare */
-    numErrors = 0;
-    for (i=0; i < PAGE_SIZE; i++)
-    {
-        /* Even */
-        if ( ((i & 1) == 0) && (pData[i] != 0xA5) )
-        {
-            printf( "-E- Data mismatch at offset #%d: expected 0xA5, read 0x%02X\n\r", (unsigned int)i, pData[i] ) ;
-            numErrors++ ;
-        }
-        /* Odd */
-        else
-        {
-            if ( ((i & 1) == 1) && (pData[i] != 0x5A) )
-            {
-                printf( "-E- Data mismatch at offset #%d: expected 0x5A, read 0x%02X\n\r", (unsigned int)i, pData[i] ) ;
-                numErrors++;
-            }
-        }
-    }
-    printf("-I- %ld comparison error(s) found\n\r", numErrors);
+    AT24_Read(&at24, 0x0000, pData, PAGE_SIZE, 0, 0);
+    CheckPattern(pData, PAGE_SIZE);
 
     /* Asynchronous operation */
-    printf("-I- Read/write on page #1 (IRQ mode)\n\r");
+    printf("-I- Write across pages #0 and #1 (asynchronous)\n\r");
 
-    /* Write checkerboard pattern in first page */
-    for ( i=0 ; i < PAGE_SIZE ; i++ )
-    {
-        /* Even */
-        if ( (i & 1) == 0 )
-        {
-            pData[i] = 0xA5;
-        }
-        /* Odd */
-        else
-        {
-            pData[i] = 0x5A;
-        }
-    }
-
-    memset(&async, 0, sizeof(async));
-    async.callback = (void *) TestCallback;
-    TWID_Write(&twid, AT24C_ADDRESS, 0x0100, 2, pData, PAGE_SIZE, &async);
-    while (!ASYNC_IsFinished(&async));
+    /* Write checkerboard pattern in the second half of page #0 and the first half of page #1 */
+    FillPattern(pData, PAGE_SIZE);
+    done = 0;
+    AT24_Write(&at24, PAGE_SIZE / 2, pData, PAGE_SIZE, TestCallback, 0);
+    while (!done);
 
-    /* Wait at least 10 ms */
-    for ( i=0 ; i < 1000000 ; i++ ) ;
-
-    /* Read back data */
+    /* Read back data from the RAM copy */
+    printf("-I- Read from the RAM copy\n\r");
+    AT24_LoadShadow(&at24, 0, 0);
     memset(pData, 0, PAGE_SIZE);
-    memset(&async, 0, sizeof(async));
-    async.callback = (void *) TestCallback;
-    TWID_Read(&twid, AT24C_ADDRESS, 0x0100, 2, pData, PAGE_SIZE, &async);
-    while ( !ASYNC_IsFinished( &async ) ) ;
-
-    /* Compare */
-    numErrors = 0 ;
-    for ( i=0 ; i < PAGE_SIZE ; i++ )
-    {
-        /* Even */
-        if ( ((i & 1) == 0) && (pData[i] != 0xA5) )
-        {
-            printf( "-E- Data mismatch at offset #%d : expected 0xA5, read 0x%02X\n\r", (unsigned int)i, pData[i] ) ;
-            numErrors++ ;
-        }
-        /* Odd */
-        else
-        {
-            if ( ((i & 1) == 1) && (pData[i] != 0x5A) )
-            {
-                printf( "-E- Data mismatch at offset #%d : expected 0x5A, read 0x%02X\n\r", (unsigned int)i, pData[i] ) ;
-                numErrors++ ;
-            }
-        }
-    }
-    printf( "-I- %ld comparison error(s) found\n\r", numErrors ) ;
+    AT24_Read(&at24, PAGE_SIZE / 2, pData, PAGE_SIZE, 0, 0);
+    CheckPattern(pData, PAGE_SIZE);
 
     return 0 ;
 }
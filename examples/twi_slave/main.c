@@ -63,6 +63,10 @@
  * Reading is done in the same fashion, except that after receiving the memory
  * address, the device will start outputting data until a STOP condition is
  * sent by the master.
+ *
+ * The memory is served by the TWI slave driver (twis.c): the data bytes are
+ * moved by the PDC, the interrupt handler only takes care of the address.
+ *
  * The default address for the TWI slave is fixed to Ox50. If the board has a TWI
  * component with this adress, you can change the define AT24C_ADDRESS in main.c
  * of twi_eeprom example, and the define SLAVE_ADDRESS in main.c of twi_slave
@@ -114,6 +118,7 @@
  * - twi_eeprom/main.c
  * - twi.c
  * - twid.h
+ * - twis.c
  */
 
 /**
@@ -138,8 +143,6 @@
 #define SLAVE_ADDRESS       0x50
 /** Memory size in bytes (example AT24C512)*/
 #define MEMORY_SIZE         512
-/** Page size in bytes (example AT24C512)*/
-#define PAGE_SIZE           128
 
 /*----------------------------------------------------------------------------
  *        Local variables
@@ -147,100 +150,18 @@
 /** Pio pins to configure. */
 const Pin pins[] = {BOARD_PINS_TWI_SLAVE};
 
-/** The slave device instance*/
-typedef struct _SlaveDeviceDriver
-{
-    /** PageAddress of the slave device*/
-    uint16_t pageAddress;
-    /** Offset of the memory access*/
-    uint16_t offsetMemory;
-    /** Read address of the request*/
-    uint8_t acquireAddress;
-    /** Memory buffer*/
-    uint8_t pMemory[MEMORY_SIZE];
-} SlaveDeviceDriver ;
+/** Memory emulated by the slave, served by the PDC*/
+static uint8_t pMemory[MEMORY_SIZE];
 
-SlaveDeviceDriver EmulateDriver;
+/** TWI slave driver instance*/
+static Twis twis;
 
 /*----------------------------------------------------------------------------
  *        Global functions
  *----------------------------------------------------------------------------*/
 void TWI1_IrqHandler( void )
 {
-    uint32_t status ;
-
-    status = TWI_GetStatus( BOARD_BASE_TWI_SLAVE ) ;
-
-    if ( ((status & TWI_SR_SVACC) == TWI_SR_SVACC) && (EmulateDriver.acquireAddress == 0) )
-    {
-        TWI_DisableIt( BOARD_BASE_TWI_SLAVE, TWI_IDR_SVACC ) ;
-        TWI_EnableIt( BOARD_BASE_TWI_SLAVE, TWI_IER_RXRDY
-                                   | TWI_IER_GACC
-                                   | TWI_IER_NACK
-                                   | TWI_IER_EOSACC
-                                   | TWI_IER_SCL_WS ) ;
-        EmulateDriver.acquireAddress++;
-        EmulateDriver.pageAddress = 0;
-        EmulateDriver.offsetMemory = 0;
-    }
-
-    if ( (status & TWI_SR_GACC) == TWI_SR_GACC )
-    {
-        printf( "General Call Treatment\n\r" ) ;
-        printf( "not treated" ) ;
-    }
-
-    if ( ((status & TWI_SR_SVACC) == TWI_SR_SVACC ) && ((status & TWI_SR_GACC) == 0 ) && ((status & TWI_SR_RXRDY) == TWI_SR_RXRDY ) )
-    {
-
-        if ( EmulateDriver.acquireAddress == 1 )
-        {
-            /* Acquire LSB address */
-            EmulateDriver.pageAddress = (TWI_ReadByte(BOARD_BASE_TWI_SLAVE) & 0xFF);
-            EmulateDriver.acquireAddress++;
-        }
-        else
-        {
-            if ( EmulateDriver.acquireAddress == 2 )
-            {
-                /* Acquire MSB address */
-                EmulateDriver.pageAddress |= (TWI_ReadByte(BOARD_BASE_TWI_SLAVE) & 0xFF)<<8;
-                EmulateDriver.acquireAddress++;
-            }
-            else
-            {
-                /* Read one byte of data from master to slave device */
-                EmulateDriver.pMemory[(PAGE_SIZE*EmulateDriver.pageAddress)+EmulateDriver.offsetMemory] = (TWI_ReadByte(BOARD_BASE_TWI_SLAVE) & 0xFF);
-                EmulateDriver.offsetMemory++;
-            }
-        }
-    }
-    else
-    {
-        if( ((status & TWI_SR_TXRDY) == TWI_SR_TXRDY ) && ((status & TWI_SR_TXCOMP) == TWI_SR_TXCOMP ) && ((status & TWI_SR_EOSACC) == TWI_SR_EOSACC ) )
-        {
-            /* End of transfert, end of slave access */
-            EmulateDriver.offsetMemory = 0;
-            EmulateDriver.acquireAddress = 0;
-            EmulateDriver.pageAddress = 0;
-            TWI_EnableIt( BOARD_BASE_TWI_SLAVE, TWI_SR_SVACC ) ;
-            TWI_DisableIt( BOARD_BASE_TWI_SLAVE, TWI_IDR_RXRDY
-                                        | TWI_IDR_GACC
-                                        | TWI_IDR_NACK
-                                        | TWI_IDR_EOSACC
-                                        | TWI_IDR_SCL_WS );
-        }
-        else
-        {
-            if ( ((status & TWI_SR_SVACC) == TWI_SR_SVACC ) && ((status & TWI_SR_GACC) == 0 ) && ( EmulateDriver.acquireAddress == 3 )
-                && ((status & TWI_SR_SVREAD) == TWI_SR_SVREAD ) && ((status & TWI_SR_NACK) == 0 ) )
-            {
-                /* Write one byte of data from slave to master device */
-                TWI_WriteByte( BOARD_BASE_TWI_SLAVE, EmulateDriver.pMemory[(PAGE_SIZE*EmulateDriver.pageAddress)+EmulateDriver.offsetMemory] ) ;
-                EmulateDriver.offsetMemory++;
-            }
-        }
-    }
+    TWIS_Handler( &twis ) ;
 }
 
 /*----------------------------------------------------------------------------
@@ -248,7 +169,8 @@ void TWI1_IrqHandler( void )
  *----------------------------------------------------------------------------*/
 int main(void)
 {
-    uint32_t i;
+    uint32_t dwOffset;
+    uint32_t dwLength;
 
     /* Disable watchdog */
     WDT_Disable( WDT ) ;
@@ -261,23 +183,11 @@ int main(void)
     printf( "-- %s\n\r", BOARD_NAME ) ;
     printf( "-- Compiled: %s %s --\n\r", __DATE__, __TIME__ ) ;
 
-    /* Enable TWI peripheral clock */
-    REG_PMC_PCER0 = 1 << BOARD_ID_TWI_SLAVE;
+    memset( pMemory, 0, MEMORY_SIZE ) ;
 
-    for ( i=0 ; i < MEMORY_SIZE ; i++ )
-    {
-        EmulateDriver.pMemory[i] = 0;
-    }
-    EmulateDriver.offsetMemory = 0;
-    EmulateDriver.acquireAddress = 0;
-    EmulateDriver.pageAddress = 0;
-
-    /* Configure TWI as slave */
+    /* Configure TWI as slave, with 2 bytes memory addresses */
     printf( "-I- Configuring the TWI in slave mode\n\r" ) ;
-    TWI_ConfigureSlave( BOARD_BASE_TWI_SLAVE, SLAVE_ADDRESS ) ;
-
-    /* Clear receipt buffer */
-    TWI_ReadByte( BOARD_BASE_TWI_SLAVE ) ;
+    TWIS_Configure( &twis, BOARD_BASE_TWI_SLAVE, BOARD_ID_TWI_SLAVE, SLAVE_ADDRESS, 2, pMemory, MEMORY_SIZE ) ;
 
     TRACE_DEBUG( "TWI is in slave mode\n\r" ) ;
 
@@ -287,11 +197,14 @@ int main(void)
     NVIC_SetPriority( TWI1_IRQn, 0 ) ;
     NVIC_EnableIRQ( TWI1_IRQn ) ;
 
-    TWI_EnableIt( BOARD_BASE_TWI_SLAVE, TWI_SR_SVACC ) ;
-
     while ( 1 )
     {
+        /* Report the memory written by the master */
+        dwLength = TWIS_GetChanges( &twis, &dwOffset ) ;
+        if ( dwLength )
+        {
+            printf( "-I- %u byte(s) written from 0x%x\n\r", (unsigned int)dwLength, (unsigned int)dwOffset ) ;
+        }
     }
 }
 
-
@@ -46,8 +46,10 @@
  *  \section Description
  *  The iso7816 software provide in this examples is use to transform APDU
  *  commands to TPDU commands for the smart card.
- *  The iso7816 provide here is for the protocol T=0 only.
- *  The send and the receive of a character is made under polling.
+ *  After the ATR, the highest baud rate supported by the card (TA1) is
+ *  selected by a PPS exchange, together with the T=1 protocol if the card
+ *  offers it; T=1 blocks are moved by the PDC, otherwise the T=0 characters
+ *  are sent and received under polling.
  *  In the file ISO7816_Init is defined all pins of the card. User must have to
  *  change this pins according to his environment.
  *  The driver is compliant with CASE 1, 2, 3 of the ISO7816-4 specification.
@@ -129,6 +131,8 @@ static const uint8_t testCommand3[] = {0x00, 0x30, 0x00, 0x00, 0x02, 0x0A, 0x0B}
 static const Pin pinsISO7816[]    = {PINS_ISO7816};
 /** ISO7816 RST pin */
 static const Pin pinIso7816RstMC  = PIN_ISO7816_RSTMC;
+/** 1 if the T=1 protocol is in use */
+static uint8_t ucT1 = 0;
 /*------------------------------------------------------------------------------
  *         Internal functions
  *------------------------------------------------------------------------------*/
@@ -185,6 +189,58 @@ static void ConfigureCardDetection( void )
 
 #endif
 
+/**
+ * Sends an APDU with the protocol in use.
+ * \param pAPDU    APDU buffer
+ * \param pMessage Answer buffer
+ * \param wLength  APDU length
+ * \return         Answer length
+ */
+static uint16_t XfrAPDU( const uint8_t *pAPDU, uint8_t *pMessage, uint16_t wLength )
+{
+    if ( ucT1 )
+    {
+        return ISO7816_XfrBlockAPDU_T1( pAPDU, pMessage, wLength ) ;
+    }
+    return ISO7816_XfrBlockTPDU_T0( pAPDU, pMessage, wLength ) ;
+}
+
+/**
+ * Selects the protocol and the highest baud rate announced by the ATR.
+ * \param pAtr ATR buffer
+ */
+static void SelectProtocol( const uint8_t *pAtr )
+{
+    Iso7816Params params ;
+    uint8_t ucProtocol ;
+    uint8_t ucLength ;
+
+    ISO7816_ParseATR( pAtr, &params ) ;
+    ucProtocol = (params.bProtocols & (1 << ISO7816_PROTOCOL_T1)) ? ISO7816_PROTOCOL_T1 : ISO7816_PROTOCOL_T0 ;
+
+    /*  Cards in specific mode use the parameters of their ATR at once */
+    if ( !params.bSpecific && (ucProtocol != ISO7816_PROTOCOL_T0 || params.bTA1 != ISO7816_TA1_DEFAULT) )
+    {
+        if ( ISO7816_PPS( ucProtocol, params.bTA1 ) != ISO7816_STATUS_SUCCESS )
+        {
+            printf( "-E- PPS failed, using T=0 at the default baud rate\n\r" ) ;
+            ISO7816_warm_reset() ;
+            ISO7816_Datablock_ATR( (uint8_t *)pAtr, &ucLength ) ;
+            return ;
+        }
+        printf( "-I- PPS: T=%u, TA1 0x%02X\n\r", ucProtocol, params.bTA1 ) ;
+    }
+
+    if ( ucProtocol == ISO7816_PROTOCOL_T1 && ISO7816_T1_Init( &params ) == ISO7816_STATUS_SUCCESS )
+    {
+        ucT1 = 1 ;
+        if ( ISO7816_T1_SetIfsd( ISO7816_T1_IFS_MAX ) != ISO7816_STATUS_SUCCESS )
+        {
+            printf( "-W- IFSD not accepted\n\r" ) ;
+        }
+    }
+}
+
 /**
  * Displays a menu which enables the user to send several commands to the
  * smartcard and check its answers.
@@ -244,7 +300,7 @@ static void SendReceiveCommands( void )
                 printf( "0x%02X ", testCommand1[i] ) ;
             }
             printf( "...\n\r" ) ;
-            ucSize = ISO7816_XfrBlockTPDU_T0( testCommand1, pMessage, sizeof( testCommand1 ) ) ;
+            ucSize = XfrAPDU( testCommand1, pMessage, sizeof( testCommand1 ) ) ;
         }
         else
         {
@@ -256,7 +312,7 @@ static void SendReceiveCommands( void )
                     printf("0x%02X ", testCommand2[i] ) ;
                 }
                 printf( "...\n\r" ) ;
-                ucSize = ISO7816_XfrBlockTPDU_T0( testCommand2, pMessage, sizeof( testCommand2 ) ) ;
+                ucSize = XfrAPDU( testCommand2, pMessage, sizeof( testCommand2 ) ) ;
             }
             else
             {
@@ -268,7 +324,7 @@ static void SendReceiveCommands( void )
                         printf( "0x%02X ", testCommand3[i] ) ;
                     }
                     printf( "...\n\r" ) ;
-                    ucSize = ISO7816_XfrBlockTPDU_T0( testCommand3, pMessage, sizeof( testCommand3 ) ) ;
+                    ucSize = XfrAPDU( testCommand3, pMessage, sizeof( testCommand3 ) ) ;
                 }
             }
        }
@@ -326,6 +382,9 @@ extern int main( void )
     /*  Decode ATR */
     ISO7816_Decode_ATR( pAtr ) ;
 
+    /*  Select the protocol and the baud rate */
+    SelectProtocol( pAtr ) ;
+
     /*  Allow user to send some commands */
     SendReceiveCommands() ;
 
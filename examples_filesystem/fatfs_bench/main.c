@@ -0,0 +1,805 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ *  \page fatfs_bench FATFS Benchmark Example
+ *
+ *  \section Purpose
+ *
+ *  The FATFS Benchmark Example measures how the FatFs module behaves with
+ *  the workload shapes of the applications, on the NAND FLASH and on the SD
+ *  card: file create/delete rates, small appends with and without f_sync,
+ *  large sequential transfers, f_lseek on fragmented files and directories
+ *  with thousands of entries.
+ *
+ *  \section Requirements
+ *
+ *  This package can be used with sam3s-ek which has NAND FLASH device and
+ *  a SD card slot. The SD card is optional.
+ *
+ *  \section Description
+ *
+ *  The NAND FLASH (through the translation layer) is drive 0 and the SD
+ *  card is drive 1. Each drive can be formatted first, then the tests are
+ *  run in a "BENCH" directory which is removed at the end:
+ *  - create / delete: empty files created and removed one by one;
+ *  - append / append_sync: 64 bytes records appended to a file, without
+ *    and with f_sync after each record;
+ *  - seq_write / seq_read: a 1M file written and read by 8K chunks;
+ *  - seek / seek_fast: random f_lseek plus a 512 bytes read in a file
+ *    fragmented cluster by cluster, the second run with f_fastseek when
+ *    _USE_FASTSEEK is enabled;
+ *  - dir_create / dir_scan / dir_lookup / dir_delete: a directory of 1000
+ *    entries filled, enumerated with f_readdir, searched with f_stat and
+ *    emptied.
+ *
+ *  Each operation is timed with the DWT cycle counter. The results are
+ *  printed as comma separated lines, starting with "BENCH", after a
+ *  "BENCH_CONFIG" line giving the FatFs options of the build, so that the
+ *  output of several builds can be collected and compared by a script. The
+ *  options can be changed with FATFS_OPTIONS on the make command line, e.g.
+ *  \code
+ *  make FATFS_OPTIONS="-D_USE_FASTSEEK=0 -D_FS_NOFSINFO=3 -D_FS_DIRCACHE=0"
+ *  \endcode
+ *  File closing and syncing time at the end of a test is included in its
+ *  total time but not in the per-operation latencies.
+ *
+ *  \section Usage
+ *
+ *  -# Build the program and download it inside the evaluation board. Please
+ *     refer to the
+ *     <a href="http://www.atmel.com/dyn/resources/prod_documents/doc6224.pdf">
+ *     SAM-BA User Guide</a>, the
+ *     <a href="http://www.atmel.com/dyn/resources/prod_documents/doc6310.pdf">
+ *     GNU-Based Software Development</a> application note or to the
+ *     <a href="ftp://ftp.iar.se/WWWfiles/arm/Guides/EWARM_UserGuide.ENU.pdf">
+ *     IAR EWARM User Guide</a>, depending on your chosen solution.
+ *  -# On the computer, open and configure a terminal application
+ *     (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *    - 115200 bauds
+ *    - 8 bits of data
+ *    - No parity
+ *    - 1 stop bit
+ *    - No flow control
+ *  -# Start the application
+ *  -# In HyperTerminal, it will show something like
+ *     \code
+ *     -- FatFS Benchmark Example xxx --
+ *     -- SAMxxx
+ *     -- Compiled: xxx --
+ *     ...
+ *     BENCH_CONFIG,fastseek=1,nofsinfo=0,dircache=8,tiny=0,lfn=1
+ *     BENCH,drive,test,ops,bytes,total_us,min_us,avg_us,max_us
+ *     BENCH,nand,create,100,0,xxx,xxx,xxx,xxx
+ *     ...
+ *     \endcode
+ *
+ */
+
+/**
+ *  \file
+ *
+ *  This file contains all the specific code for the fatfs_bench example.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "board.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "memories.h"
+
+#include "fatfs_config.h"
+
+/*----------------------------------------------------------------------------
+ *        Local constants
+ *----------------------------------------------------------------------------*/
+
+/** Number of files of the create / delete test */
+#define NUM_FILES           100
+
+/** Number and size of the records of the append tests */
+#define NUM_APPENDS         256
+#define APPEND_SIZE         64
+
+/** Size of the sequential test file, and of its transfers */
+#define SEQ_SIZE            (1024*1024)
+#define SEQ_CHUNK           (8*1024)
+
+/** Number of clusters of each of the two interleaved seek test files */
+#define NUM_FRAGMENTS       64
+
+/** Number of seeks of each seek test, and size of the read after a seek */
+#define NUM_SEEKS           256
+#define SEEK_READ_SIZE      512
+
+/** Number of items of the cluster link map table (2 per fragment, +2) */
+#define LINKMAP_ITEMS       (2*NUM_FRAGMENTS + 4)
+
+/** Number of entries of the directory tests, and of lookups */
+#define NUM_DIR_ENTRIES     1000
+#define NUM_LOOKUPS         100
+
+/** Size of the reserved Nand Flash (4M) */
+#define NF_RESERVE_SIZE     (4*1024*1024)
+
+/** Size of the managed Nand Flash (128M) */
+#define NF_MANAGED_SIZE     (128*1024*1024)
+
+/** Core cycles per microsecond. */
+#define CYCLES_PER_US       (BOARD_MCK / 1000000)
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Results of a test. */
+typedef struct _BenchStat {
+
+    /** Operations done. */
+    uint32_t dwOps;
+    /** Bytes moved. */
+    uint32_t dwBytes;
+    /** Total time, in cycles (closing time included). */
+    uint64_t qwCycles;
+    /** Shortest and longest operations, in cycles. */
+    uint32_t dwMinCycles;
+    uint32_t dwMaxCycles;
+
+} BenchStat;
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Available medias, served by diskio_sam3s.c. */
+Media medias[MAX_MEDS];
+
+/** File system objects of the drives. */
+static FATFS fileSystems[MAX_MEDS];
+
+/** Drive names, as printed in the results. */
+static const char *driveNames[MAX_MEDS] = {"nand", "sd"};
+
+/** File objects of the tests. */
+static FIL fileA, fileB;
+
+/** Transfer buffer. */
+static uint8_t benchBuffer[SEQ_CHUNK] __attribute__ ((aligned (4)));
+
+/** Path buffer. */
+static char pathName[32];
+
+#if _USE_FASTSEEK
+/** Cluster link map table arena */
+static DWORD linkMap[LINKMAP_ITEMS];
+#endif
+
+/** Pseudo-random generator state. */
+static uint32_t randomState = 1;
+
+/** Pins used to access to nandflash. */
+static const Pin pPinsNf[] = {PINS_NANDFLASH};
+/** Nandflash device structure. */
+static struct TranslatedNandFlash translatedNf;
+/** Nandflash chip enable pin. */
+static const Pin nfCePin = BOARD_NF_CE_PIN;
+/** Nandflash ready/busy pin. */
+static const Pin nfRbPin = BOARD_NF_RB_PIN;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Returns the next value of the pseudo-random generator.
+ */
+static uint32_t _Random(void)
+{
+    randomState = randomState * 1103515245 + 12345;
+    return randomState >> 8;
+}
+
+/**
+ *  \brief Wait DEBUG Key Input
+ *  \param ms   Wait time in ms.
+ *  \return key or 0 for nothing.
+ */
+static uint8_t _WaitKey(uint32_t ms)
+{
+    uint32_t tick = GetTickCount();
+
+    do {
+
+        if (UART_IsRxReady()) {
+
+            return UART_GetChar();
+        }
+    } while (GetTickCount() - tick <= ms);
+
+    return 0;
+}
+
+/**
+ * \brief Builds the name of a file of a test directory in pathName.
+ * \param bDrv   Drive number.
+ * \param pDir   Directory name, under the drive root.
+ * \param dwNum  File number.
+ */
+static const char* _FileName(BYTE bDrv, const char *pDir, uint32_t dwNum)
+{
+    sprintf(pathName, "%d:/%s/F%04u.BIN", bDrv, pDir, (unsigned int)dwNum);
+    return pathName;
+}
+
+/**
+ * \brief Builds the name of a directory in pathName.
+ */
+static const char* _DirName(BYTE bDrv, const char *pDir)
+{
+    sprintf(pathName, "%d:/%s", bDrv, pDir);
+    return pathName;
+}
+
+/**
+ * \brief Clears the results of a test.
+ */
+static void _StatInit(BenchStat *pStat)
+{
+    memset(pStat, 0, sizeof(BenchStat));
+    pStat->dwMinCycles = 0xFFFFFFFF;
+}
+
+/**
+ * \brief Accounts one operation of a test.
+ * \param dwCycles  Duration of the operation, in cycles.
+ * \param dwBytes   Bytes moved by the operation.
+ */
+static void _StatAdd(BenchStat *pStat, uint32_t dwCycles, uint32_t dwBytes)
+{
+    pStat->dwOps ++;
+    pStat->dwBytes += dwBytes;
+    pStat->qwCycles += dwCycles;
+    if (dwCycles < pStat->dwMinCycles) pStat->dwMinCycles = dwCycles;
+    if (dwCycles > pStat->dwMaxCycles) pStat->dwMaxCycles = dwCycles;
+}
+
+/**
+ * \brief Prints the results of a test as a BENCH line.
+ */
+static void _StatPrint(BYTE bDrv, const char *pTest, const BenchStat *pStat)
+{
+    uint32_t dwAvg = pStat->dwOps ? pStat->qwCycles / pStat->dwOps : 0;
+
+    printf("BENCH,%s,%s,%u,%u,%u,%u,%u,%u\n\r",
+           driveNames[bDrv], pTest,
+           (unsigned int)pStat->dwOps,
+           (unsigned int)pStat->dwBytes,
+           (unsigned int)(pStat->qwCycles / CYCLES_PER_US),
+           (unsigned int)(pStat->dwOps ? pStat->dwMinCycles / CYCLES_PER_US : 0),
+           (unsigned int)(dwAvg / CYCLES_PER_US),
+           (unsigned int)(pStat->dwMaxCycles / CYCLES_PER_US));
+}
+
+/**
+ * \brief Closes a test file, the closing time is added to the test total.
+ */
+static FRESULT _CloseTimed(FIL *pFile, BenchStat *pStat)
+{
+    uint32_t dwStart = DWT_CYCCNT;
+    FRESULT res = f_close(pFile);
+
+    pStat->qwCycles += DWT_CYCCNT - dwStart;
+    return res;
+}
+
+/*----------------------------------------------------------------------------
+ *        Medias
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initializes the SD card media, if a card is inserted. MEDSdasync
+ * configures the pins and the drivers, and owns the HSMCI interrupt.
+ * \return true if the SD card is available.
+ */
+static bool _SdInitialize(void)
+{
+    Media *pMedia = &medias[DRV_MMC];
+
+    if (!MEDSdcard_Detect(pMedia, 0)) {
+
+        printf("-I- No SD card\n\r");
+        return false;
+    }
+    if (!MEDSdasync_Initialize(pMedia, 0)) {
+
+        printf("-E- SD card initialization failed\n\r");
+        return false;
+    }
+    printf("-I- SD card: %u blocks of %u bytes\n\r",
+           (unsigned int)pMedia->size, (unsigned int)pMedia->blockSize);
+    return true;
+}
+
+/**
+ * \brief Initializes the NandFlash translation layer and its media.
+ * \return true if the NandFlash is available.
+ */
+static bool _NandFlashInitialize(void)
+{
+    struct RawNandFlash *pRaw = (struct RawNandFlash*)&translatedNf;
+    struct NandFlashModel *pModel = (struct NandFlashModel*)&translatedNf;
+    uint16_t wBaseBlock;
+    uint32_t dwManagedMB;
+
+    BOARD_ConfigureNandFlash(SMC);
+    PIO_Configure(pPinsNf, PIO_LISTSIZE(pPinsNf));
+
+    if (RawNandFlash_Initialize(pRaw, 0,
+                                BOARD_NF_COMMAND_ADDR, BOARD_NF_ADDRESS_ADDR,
+                                BOARD_NF_DATA_ADDR, nfCePin, nfRbPin)) {
+
+        printf("-I- No NandFlash\n\r");
+        return false;
+    }
+    wBaseBlock = NF_RESERVE_SIZE / NandFlashModel_GetBlockSizeInBytes(pModel);
+    dwManagedMB = NandFlashModel_GetDeviceSizeInMBytes(pModel) - NF_RESERVE_SIZE/1024/1024;
+    if (dwManagedMB > NF_MANAGED_SIZE/1024/1024) {
+
+        dwManagedMB = NF_MANAGED_SIZE/1024/1024;
+    }
+    if (TranslatedNandFlash_Initialize(&translatedNf, 0,
+                                       BOARD_NF_COMMAND_ADDR, BOARD_NF_ADDRESS_ADDR,
+                                       BOARD_NF_DATA_ADDR, nfCePin, nfRbPin,
+                                       wBaseBlock,
+                                       dwManagedMB * 1024 * 1024
+                                       / NandFlashModel_GetBlockSizeInBytes(pModel))) {
+
+        printf("-E- NandFlash translation layer initialization failed\n\r");
+        return false;
+    }
+    MEDNandFlash_Initialize(&medias[DRV_NAND], &translatedNf);
+    printf("-I- NandFlash: %uM managed from block %u\n\r",
+           (unsigned int)dwManagedMB, wBaseBlock);
+    return true;
+}
+
+/*----------------------------------------------------------------------------
+ *        Tests
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Creates then deletes NUM_FILES empty files.
+ */
+static FRESULT _BenchCreateDelete(BYTE bDrv)
+{
+    BenchStat stat;
+    FRESULT res = FR_OK;
+    uint32_t dwStart, i;
+
+    _StatInit(&stat);
+    for (i = 0; i < NUM_FILES && res == FR_OK; i ++) {
+
+        _FileName(bDrv, "BENCH", i);
+        dwStart = DWT_CYCCNT;
+        res = f_open(&fileA, pathName, FA_CREATE_ALWAYS | FA_WRITE);
+        if (res == FR_OK) {
+
+            res = f_close(&fileA);
+        }
+        _StatAdd(&stat, DWT_CYCCNT - dwStart, 0);
+    }
+    if (res != FR_OK) return res;
+    _StatPrint(bDrv, "create", &stat);
+
+    _StatInit(&stat);
+    for (i = 0; i < NUM_FILES && res == FR_OK; i ++) {
+
+        _FileName(bDrv, "BENCH", i);
+        dwStart = DWT_CYCCNT;
+        res = f_unlink(pathName);
+        _StatAdd(&stat, DWT_CYCCNT - dwStart, 0);
+    }
+    if (res != FR_OK) return res;
+    _StatPrint(bDrv, "delete", &stat);
+
+    return FR_OK;
+}
+
+/**
+ * \brief Appends NUM_APPENDS small records to a file.
+ * \param bSync  Whether to sync the file after each record.
+ */
+static FRESULT _BenchAppend(BYTE bDrv, bool bSync)
+{
+    BenchStat stat;
+    FRESULT res;
+    UINT written;
+    uint32_t dwStart, i;
+
+    _StatInit(&stat);
+    memset(benchBuffer, 0x5A, APPEND_SIZE);
+    res = f_open(&fileA, _FileName(bDrv, "BENCH", 0), FA_CREATE_ALWAYS | FA_WRITE);
+    if (res != FR_OK) return res;
+
+    for (i = 0; i < NUM_APPENDS && res == FR_OK; i ++) {
+
+        dwStart = DWT_CYCCNT;
+        res = f_write(&fileA, benchBuffer, APPEND_SIZE, &written);
+        if (res == FR_OK && bSync) {
+
+            res = f_sync(&fileA);
+        }
+        _StatAdd(&stat, DWT_CYCCNT - dwStart, written);
+    }
+    if (res != FR_OK) {
+
+        f_close(&fileA);
+        return res;
+    }
+    res = _CloseTimed(&fileA, &stat);
+    if (res == FR_OK) {
+
+        _StatPrint(bDrv, bSync ? "append_sync" : "append", &stat);
+        res = f_unlink(pathName);
+    }
+    return res;
+}
+
+/**
+ * \brief Writes then reads a SEQ_SIZE file by SEQ_CHUNK transfers.
+ */
+static FRESULT _BenchSequential(BYTE bDrv)
+{
+    BenchStat stat;
+    FRESULT res;
+    UINT done;
+    uint32_t dwStart, dwOfs;
+
+    _StatInit(&stat);
+    memset(benchBuffer, 0xA5, SEQ_CHUNK);
+    res = f_open(&fileA, _FileName(bDrv, "BENCH", 0), FA_CREATE_ALWAYS | FA_WRITE);
+    if (res != FR_OK) return res;
+
+    for (dwOfs = 0; dwOfs < SEQ_SIZE && res == FR_OK; dwOfs += SEQ_CHUNK) {
+
+        dwStart = DWT_CYCCNT;
+        res = f_write(&fileA, benchBuffer, SEQ_CHUNK, &done);
+        _StatAdd(&stat, DWT_CYCCNT - dwStart, done);
+        if (res == FR_OK && done != SEQ_CHUNK) res = FR_DENIED;
+    }
+    if (res != FR_OK) {
+
+        f_close(&fileA);
+        return res;
+    }
+    res = _CloseTimed(&fileA, &stat);
+    if (res != FR_OK) return res;
+    _StatPrint(bDrv, "seq_write", &stat);
+
+    _StatInit(&stat);
+    res = f_open(&fileA, pathName, FA_OPEN_EXISTING | FA_READ);
+    if (res != FR_OK) return res;
+
+    for (dwOfs = 0; dwOfs < SEQ_SIZE && res == FR_OK; dwOfs += SEQ_CHUNK) {
+
+        dwStart = DWT_CYCCNT;
+        res = f_read(&fileA, benchBuffer, SEQ_CHUNK, &done);
+        _StatAdd(&stat, DWT_CYCCNT - dwStart, done);
+        if (res == FR_OK && done != SEQ_CHUNK) res = FR_INT_ERR;
+    }
+    f_close(&fileA);
+    if (res != FR_OK) return res;
+    _StatPrint(bDrv, "seq_read", &stat);
+
+    return f_unlink(pathName);
+}
+
+/**
+ * \brief Runs NUM_SEEKS random seeks and reads on fileA.
+ */
+static FRESULT _BenchSeekRun(BYTE bDrv, const char *pTest, uint32_t dwSize)
+{
+    BenchStat stat;
+    FRESULT res = FR_OK;
+    UINT read;
+    uint32_t dwStart, dwOfs, i;
+
+    randomState = 1;
+    _StatInit(&stat);
+    for (i = 0; i < NUM_SEEKS && res == FR_OK; i ++) {
+
+        /* Same pseudo random sector offsets for all the runs */
+        dwOfs = (_Random() % (dwSize / SEEK_READ_SIZE)) * SEEK_READ_SIZE;
+        read = 0;
+        dwStart = DWT_CYCCNT;
+        res = f_lseek(&fileA, dwOfs);
+        if (res == FR_OK) {
+
+            res = f_read(&fileA, benchBuffer, SEEK_READ_SIZE, &read);
+        }
+        _StatAdd(&stat, DWT_CYCCNT - dwStart, read);
+        if (res == FR_OK && read != SEEK_READ_SIZE) res = FR_INT_ERR;
+    }
+    if (res == FR_OK) {
+
+        _StatPrint(bDrv, pTest, &stat);
+    }
+    return res;
+}
+
+/**
+ * \brief Builds two files fragmented cluster by cluster, then measures the
+ * random seeks in the first one, without and with fast seek.
+ */
+static FRESULT _BenchSeek(BYTE bDrv)
+{
+    FRESULT res = FR_OK;
+    UINT written;
+    uint32_t dwCluster = fileSystems[bDrv].csize * _MAX_SS;
+    uint32_t dwOfs, dwChunk, i;
+    char nameB[sizeof(pathName)];
+
+    /* Interleave the clusters of the two files */
+    strcpy(nameB, _FileName(bDrv, "BENCH", 1));
+    res = f_open(&fileB, nameB, FA_CREATE_ALWAYS | FA_WRITE);
+    if (res != FR_OK) return res;
+    res = f_open(&fileA, _FileName(bDrv, "BENCH", 0), FA_CREATE_ALWAYS | FA_WRITE);
+    if (res != FR_OK) {
+
+        f_close(&fileB);
+        return res;
+    }
+    memset(benchBuffer, 0x3C, SEQ_CHUNK);
+    for (i = 0; i < NUM_FRAGMENTS && res == FR_OK; i ++) {
+
+        for (dwOfs = 0; dwOfs < dwCluster && res == FR_OK; dwOfs += dwChunk) {
+
+            dwChunk = (dwCluster - dwOfs > SEQ_CHUNK) ? SEQ_CHUNK : dwCluster - dwOfs;
+            res = f_write(&fileA, benchBuffer, dwChunk, &written);
+            if (res == FR_OK) {
+
+                res = f_write(&fileB, benchBuffer, dwChunk, &written);
+            }
+        }
+        /* Allocate the next clusters now so that they interleave */
+        if (res == FR_OK) res = f_sync(&fileA);
+        if (res == FR_OK) res = f_sync(&fileB);
+    }
+    f_close(&fileA);
+    f_close(&fileB);
+    if (res != FR_OK) return res;
+
+    res = f_open(&fileA, pathName, FA_OPEN_EXISTING | FA_READ);
+    if (res != FR_OK) return res;
+    res = _BenchSeekRun(bDrv, "seek", NUM_FRAGMENTS * dwCluster);
+#if _USE_FASTSEEK
+    if (res == FR_OK) {
+
+        res = f_fastseek(&fileA, linkMap, LINKMAP_ITEMS);
+    }
+    if (res == FR_OK) {
+
+        res = _BenchSeekRun(bDrv, "seek_fast", NUM_FRAGMENTS * dwCluster);
+    }
+#endif
+    f_close(&fileA);
+    if (res != FR_OK) return res;
+
+    res = f_unlink(_FileName(bDrv, "BENCH", 0));
+    if (res == FR_OK) {
+
+        res = f_unlink(nameB);
+    }
+    return res;
+}
+
+/**
+ * \brief Fills a directory with NUM_DIR_ENTRIES files, enumerates and
+ * searches it, then empties and removes it.
+ */
+static FRESULT _BenchDirectory(BYTE bDrv)
+{
+    BenchStat stat;
+    FRESULT res;
+    DIR dir;
+    FILINFO info;
+    uint32_t dwStart, dwEntries, i;
+
+    res = f_mkdir(_DirName(bDrv, "BENCH/DIR"));
+    if (res != FR_OK) return res;
+
+    _StatInit(&stat);
+    for (i = 0; i < NUM_DIR_ENTRIES && res == FR_OK; i ++) {
+
+        _FileName(bDrv, "BENCH/DIR", i);
+        dwStart = DWT_CYCCNT;
+        res = f_open(&fileA, pathName, FA_CREATE_NEW | FA_WRITE);
+        if (res == FR_OK) {
+
+            res = f_close(&fileA);
+        }
+        _StatAdd(&stat, DWT_CYCCNT - dwStart, 0);
+    }
+    if (res != FR_OK) return res;
+    _StatPrint(bDrv, "dir_create", &stat);
+
+    /* Enumeration, short names only */
+    memset(&info, 0, sizeof(info));
+    _StatInit(&stat);
+    dwStart = DWT_CYCCNT;
+    res = f_opendir(&dir, _DirName(bDrv, "BENCH/DIR"));
+    stat.qwCycles += DWT_CYCCNT - dwStart;
+    for (dwEntries = 0; res == FR_OK; dwEntries ++) {
+
+        dwStart = DWT_CYCCNT;
+        res = f_readdir(&dir, &info);
+        if (res != FR_OK || info.fname[0] == 0) {
+
+            stat.qwCycles += DWT_CYCCNT - dwStart;
+            break;
+        }
+        _StatAdd(&stat, DWT_CYCCNT - dwStart, 0);
+    }
+    if (res != FR_OK) return res;
+    if (dwEntries != NUM_DIR_ENTRIES) {
+
+        printf("-E- %u entries found\n\r", (unsigned int)dwEntries);
+        return FR_INT_ERR;
+    }
+    _StatPrint(bDrv, "dir_scan", &stat);
+
+    /* Random lookups */
+    randomState = 1;
+    _StatInit(&stat);
+    for (i = 0; i < NUM_LOOKUPS && res == FR_OK; i ++) {
+
+        _FileName(bDrv, "BENCH/DIR", _Random() % NUM_DIR_ENTRIES);
+        dwStart = DWT_CYCCNT;
+        res = f_stat(pathName, &info);
+        _StatAdd(&stat, DWT_CYCCNT - dwStart, 0);
+    }
+    if (res != FR_OK) return res;
+    _StatPrint(bDrv, "dir_lookup", &stat);
+
+    _StatInit(&stat);
+    for (i = 0; i < NUM_DIR_ENTRIES && res == FR_OK; i ++) {
+
+        _FileName(bDrv, "BENCH/DIR", i);
+        dwStart = DWT_CYCCNT;
+        res = f_unlink(pathName);
+        _StatAdd(&stat, DWT_CYCCNT - dwStart, 0);
+    }
+    if (res != FR_OK) return res;
+    _StatPrint(bDrv, "dir_delete", &stat);
+
+    return f_unlink(_DirName(bDrv, "BENCH/DIR"));
+}
+
+/**
+ * \brief Mounts a drive, formats it on request, and runs all the tests.
+ */
+static void _BenchDrive(BYTE bDrv)
+{
+    FRESULT res;
+
+    memset(&fileSystems[bDrv], 0, sizeof(FATFS));
+    res = f_mount(bDrv, &fileSystems[bDrv]);
+    if (res != FR_OK) {
+
+        printf("-E- f_mount %d pb: 0x%X\n\r", bDrv, res);
+        return;
+    }
+
+    printf("!! Format drive %d (%s), all data will be lost? (y/n):", bDrv, driveNames[bDrv]);
+    if (_WaitKey(3000) == 'y') {
+
+        printf(" Please wait...");
+        res = f_mkfs(bDrv, 0, 0);
+        if (res != FR_OK) {
+
+            printf("\n\r-E- f_mkfs pb: 0x%X\n\r", res);
+            return;
+        }
+    }
+    printf("\n\r");
+
+    /* The first access mounts the volume */
+    res = f_mkdir(_DirName(bDrv, "BENCH"));
+    if (res != FR_OK && res != FR_EXIST) {
+
+        printf("-E- Drive %d not usable: 0x%X\n\r", bDrv, res);
+        return;
+    }
+    printf("-I- Drive %d: %u bytes per cluster\n\r",
+           bDrv, (unsigned int)(fileSystems[bDrv].csize * _MAX_SS));
+
+    res = _BenchCreateDelete(bDrv);
+    if (res == FR_OK) res = _BenchAppend(bDrv, false);
+    if (res == FR_OK) res = _BenchAppend(bDrv, true);
+    if (res == FR_OK) res = _BenchSequential(bDrv);
+    if (res == FR_OK) res = _BenchSeek(bDrv);
+    if (res == FR_OK) res = _BenchDirectory(bDrv);
+    if (res == FR_OK) res = f_unlink(_DirName(bDrv, "BENCH"));
+    if (res != FR_OK) {
+
+        printf("-E- Drive %d test pb: 0x%X\n\r", bDrv, res);
+    }
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ *  \brief Application entry point for FATFS Benchmark Example
+ */
+int main( void )
+{
+    bool bNand, bSd;
+
+    /* Disable watchdog */
+    WDT_Disable( WDT ) ;
+
+    /* Output example information */
+    printf("-- FatFS Benchmark Example %s --\n\r", SOFTPACK_VERSION);
+    printf("-- %s\n\r", BOARD_NAME);
+    printf("-- Compiled: %s %s --\n\r", __DATE__, __TIME__);
+
+    /* Configure systick for 1 ms. */
+    if ( TimeTick_Configure( BOARD_MCK ) != 0 )
+    {
+        printf("-F- Systick configuration error\n\r" ) ;
+        return 0;
+    }
+
+    /* Enable the cycle counter */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+
+    bNand = _NandFlashInitialize();
+    bSd = _SdInitialize();
+
+    printf("BENCH_CONFIG,fastseek=%d,nofsinfo=%d,dircache=%d,tiny=%d,lfn=%d\n\r",
+           _USE_FASTSEEK, _FS_NOFSINFO, _FS_DIRCACHE, _FS_TINY, _USE_LFN);
+    printf("BENCH,drive,test,ops,bytes,total_us,min_us,avg_us,max_us\n\r");
+
+    if (bNand) _BenchDrive(DRV_NAND);
+    if (bSd) _BenchDrive(DRV_MMC);
+
+    printf("-I- Benchmark done\n\r");
+
+    return 0;
+}
@@ -0,0 +1,417 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ *  \page fatfs_fastseek_nandflash FATFS Fast Seek Example
+ *
+ *  \section Purpose
+ *
+ *  The FATFS Fast Seek Example measures the f_lseek latency on a file with a
+ *  long cluster chain (one sector per cluster) with and without the FatFs
+ *  fast seek feature, through a NAND FLASH based filesystem.
+ *
+ *  \section Requirements
+ *
+ *  This package can be used with sam3s-ek which has NAND FLASH device.
+ *
+ *  \section Description
+ *
+ *  A test file is created, then the same sequence of random seeks is run twice:
+ *  first walking the FAT chain on each f_lseek (normal seek), then with a
+ *  cluster link map table given by f_fastseek(). The table is built on the
+ *  first seek. Data read at each position is checked and the elapsed time of
+ *  both runs is displayed.
+ *
+ *  \section Usage
+ *
+ *  -# Build the program and download it inside the evaluation board. Please
+ *     refer to the
+ *     <a href="http://www.atmel.com/dyn/resources/prod_documents/doc6224.pdf">
+ *     SAM-BA User Guide</a>, the
+ *     <a href="http://www.atmel.com/dyn/resources/prod_documents/doc6310.pdf">
+ *     GNU-Based Software Development</a> application note or to the
+ *     <a href="ftp://ftp.iar.se/WWWfiles/arm/Guides/EWARM_UserGuide.ENU.pdf">
+ *     IAR EWARM User Guide</a>, depending on your chosen solution.
+ *  -# On the computer, open and configure a terminal application
+ *     (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *    - 115200 bauds
+ *    - 8 bits of data
+ *    - No parity
+ *    - 1 stop bit
+ *    - No flow control
+ *  -# Start the application
+ *  -# In HyperTerminal, it will show something like
+ *     \code
+ *     -- FatFS Fast Seek with NAND Example xxx --
+ *     -- SAMxxx
+ *     -- Compiled: xxx --
+ *     ...
+ *     -I- Normal seek: 256 seeks in xxx ms
+ *     -I- Fast seek: 256 seeks in xxx ms
+ *     \endcode
+ *
+ */
+
+/**
+ *  \file
+ *
+ *  This file contains all the specific code for the fatfs_fastseek_nandflash
+ *  example.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "board.h"
+
+/* These headers were introduced in C99 by working group ISO/IEC JTC1/SC22/WG14. */
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include "memories.h"
+
+#include "fatfs_config.h"
+
+/*----------------------------------------------------------------------------
+ *        Local constants
+ *----------------------------------------------------------------------------*/
+
+/** Maximum number of Medias which can be defined. */
+#define MAX_MEDS        1
+
+/** Size of the test file (256 clusters of one sector) */
+#define FILE_SIZE       (256*512)
+
+/** Number of seeks of each run */
+#define NUM_SEEKS       256
+
+/** Number of items of the cluster link map table (2 per fragment, +2) */
+#define LINKMAP_ITEMS   32
+
+/** Size of the reserved Nand Flash (4M) */
+#define NF_RESERVE_SIZE     (4*1024*1024)
+
+/** Size of the managed Nand Flash (128M) */
+#define NF_MANAGED_SIZE     (128*1024*1024)
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+#define STR_ROOT_DIRECTORY "0:"
+
+/** Available medias. */
+Media medias[MAX_MEDS];
+
+/** File name */
+const char* FileName = STR_ROOT_DIRECTORY "Seek.bin";
+
+/** Buffer used to create the file */
+uint32_t data[512/4];
+
+/** Cluster link map table arena */
+DWORD linkMap[LINKMAP_ITEMS];
+
+/** Pins used to access to nandflash. */
+static const Pin pPinsNf[] = {PINS_NANDFLASH};
+/** Nandflash device structure. */
+static struct TranslatedNandFlash translatedNf;
+/** Address for transferring command bytes to the nandflash. */
+static uint32_t cmdBytesAddr = BOARD_NF_COMMAND_ADDR;
+/** Address for transferring address bytes to the nandflash. */
+static uint32_t addrBytesAddr = BOARD_NF_ADDRESS_ADDR;
+/** Address for transferring data bytes to the nandflash. */
+static uint32_t dataBytesAddr = BOARD_NF_DATA_ADDR;
+/** Nandflash chip enable pin. */
+static const Pin nfCePin = BOARD_NF_CE_PIN;
+/** Nandflash ready/busy pin. */
+static const Pin nfRbPin = BOARD_NF_RB_PIN;
+
+/*----------------------------------------------------------------------------
+ *        Local Functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ *  \brief Wait DEBUG Key Input
+ *  \param ms   Wait time in ms.
+ *  \param echo Wether echo the key.
+ *  \return key or 0 for nothing.
+ */
+static uint8_t WaitKey(volatile uint32_t ms, bool echo)
+{
+    uint8_t key;
+    uint32_t tick = GetTickCount();
+    do {
+
+        if (UART_IsRxReady()) {
+
+            key = UART_GetChar();
+            if (echo) UART_PutChar(key);
+            return key;
+        }
+
+        /* ms > 0, check tick */
+        if (ms && (GetTickCount() - tick > ms)) {
+            break;
+        }
+    } while (1);
+
+    return 0;
+}
+
+/**
+ *  \brief Initialize Nand Flash
+ *  \return true if initialized succesfully.
+ */
+static uint8_t NandFlashInitialize(void)
+{
+    uint8_t  nfRc;
+    uint16_t nfBaseBlock = 0;
+    struct RawNandFlash *pRaw = (struct RawNandFlash*)&translatedNf;
+    struct NandFlashModel *pModel = (struct NandFlashModel*)&translatedNf;
+    uint32_t nfManagedSize;
+
+    /* Configure for NandFlash */
+    BOARD_ConfigureNandFlash(SMC);
+    /* Configure PIO for Nand Flash */
+    PIO_Configure(pPinsNf, PIO_LISTSIZE(pPinsNf));
+
+    /* Nand Flash Initialize (ALL flash mapped) */
+    nfRc = RawNandFlash_Initialize(pRaw,
+                                   0,
+                                   cmdBytesAddr,
+                                   addrBytesAddr,
+                                   dataBytesAddr,
+                                   nfCePin,
+                                   nfRbPin);
+    if ( nfRc )
+    {
+        printf("Nand not found\n\r");
+        return false;
+    }
+    else
+    {
+        printf("NF\tNb Blocks %d\n\r", NandFlashModel_GetDeviceSizeInBlocks(pModel));
+        printf("\tBlock Size %dK\n\r", NandFlashModel_GetBlockSizeInBytes(pModel)/1024);
+        printf("\tPage Size %d\n\r", NandFlashModel_GetPageDataSize(pModel));
+        nfBaseBlock = NF_RESERVE_SIZE / NandFlashModel_GetBlockSizeInBytes(pModel);
+    }
+    printf("NF disk will use area from %dM(B%d)\n\r", NF_RESERVE_SIZE/1024/1024, nfBaseBlock);
+
+    /* Wait 1.2s for input */
+    printf("!! Erase the NF Disk? (y/n):");
+
+    if ( WaitKey( 1200, 0 ) == 'y' )
+    {
+        if ( nfRc == 0 )
+        {
+            uint32_t block;
+            printf(" Erase from %d ... ", nfBaseBlock ) ;
+            for ( block = nfBaseBlock ; block < NandFlashModel_GetDeviceSizeInBlocks(pModel); block ++ )
+            {
+                RawNandFlash_EraseBlock(pRaw, block);
+            }
+            printf("OK");
+        }
+    }
+    printf("\n\r");
+
+    nfManagedSize = ((NandFlashModel_GetDeviceSizeInMBytes(pModel) - NF_RESERVE_SIZE/1024/1024) > NF_MANAGED_SIZE/1024/1024) ? \
+                        NF_MANAGED_SIZE/1024/1024 : (NandFlashModel_GetDeviceSizeInMBytes(pModel) - NF_RESERVE_SIZE/1024/1024);
+    if (TranslatedNandFlash_Initialize(&translatedNf,
+                                       0,
+                                       cmdBytesAddr,
+                                       addrBytesAddr,
+                                       dataBytesAddr,
+                                       nfCePin,
+                                       nfRbPin,
+                                       nfBaseBlock, nfManagedSize * 1024 * 1024/NandFlashModel_GetBlockSizeInBytes(pModel))) {
+        printf("Nand init error\n\r");
+        return false;
+    }
+    /* Media initialize */
+    MEDNandFlash_Initialize(&medias[DRV_NAND], &translatedNf);
+
+    return true;
+}
+
+/**
+ *  \brief Create the test file, each word holds its own offset.
+ *  \return FR_OK if successful.
+ */
+static FRESULT CreateTestFile(void)
+{
+    FIL file;
+    FRESULT res;
+    UINT written;
+    uint32_t ofs, i;
+
+    res = f_open(&file, FileName, FA_CREATE_ALWAYS|FA_WRITE);
+    if (res != FR_OK) return res;
+
+    for (ofs = 0; ofs < FILE_SIZE && res == FR_OK; ofs += sizeof(data)) {
+        for (i = 0; i < sizeof(data)/4; i ++) {
+            data[i] = ofs + i * 4;
+        }
+        res = f_write(&file, data, sizeof(data), &written);
+        if (res == FR_OK && written != sizeof(data)) res = FR_DENIED;
+    }
+    if (res == FR_OK) {
+        res = f_close(&file);
+    }
+    else {
+        f_close(&file);
+    }
+    return res;
+}
+
+/**
+ *  \brief Run the random seek sequence on the test file.
+ *  \param fast Whether to enable fast seek.
+ *  \param pTime Pointer to the elapsed time in ms.
+ *  \return FR_OK if successful.
+ */
+static FRESULT RunSeeks(bool fast, uint32_t *pTime)
+{
+    FIL file;
+    FRESULT res;
+    UINT read;
+    uint32_t seed = 0x1234;
+    uint32_t ofs, value, i;
+    uint32_t tick;
+
+    res = f_open(&file, FileName, FA_OPEN_EXISTING|FA_READ);
+    if (res != FR_OK) return res;
+    if (fast) {
+        res = f_fastseek(&file, linkMap, LINKMAP_ITEMS);
+    }
+
+    tick = GetTickCount();
+    for (i = 0; i < NUM_SEEKS && res == FR_OK; i ++) {
+        /* Same pseudo random word offsets for both runs */
+        seed = seed * 1103515245 + 12345;
+        ofs = ((seed >> 8) % (FILE_SIZE / 4)) * 4;
+
+        res = f_lseek(&file, ofs);
+        if (res == FR_OK) {
+            res = f_read(&file, &value, 4, &read);
+        }
+        if (res == FR_OK && (read != 4 || value != ofs)) {
+            printf("-E- Bad data at %u: %u\n\r", (unsigned int)ofs, (unsigned int)value);
+            res = FR_INT_ERR;
+        }
+    }
+    *pTime = GetTickCount() - tick;
+
+    f_close(&file);
+    return res;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ *  \brief Application entry point for FATFS Fast Seek Example
+ */
+int main( void )
+{
+    FATFS fs;             // File system object
+    FRESULT res;
+    uint32_t timeNormal, timeFast;
+
+    /* Disable watchdog */
+    WDT_Disable( WDT ) ;
+
+    /* Output example information */
+    printf("-- FatFS Fast Seek with NAND Example %s --\n\r", SOFTPACK_VERSION);
+    printf("-- %s\n\r", BOARD_NAME);
+    printf("-- Compiled: %s %s --\n\r", __DATE__, __TIME__);
+
+    /* Configure systick for 1 ms. */
+    if ( TimeTick_Configure( BOARD_MCK ) != 0 )
+    {
+        printf("-F- Systick configuration error\n\r" ) ;
+        return 0;
+    }
+
+    /* Init NandFlash Disk */
+    if (!NandFlashInitialize()) {
+        printf("-F- NF Init FAIL\n\r");
+        return 0;
+    }
+
+    /* Mount Disk */
+    printf("-I- Mount disk 0\n\r");
+    memset(&fs, 0, sizeof(FATFS));  // Clear file system object
+    res = f_mount(0, &fs);
+    if( res != FR_OK ) {
+        printf("-F- f_mount pb\n\r");
+        return 0;
+    }
+
+    /* Format disk with one sector per cluster, for a long cluster chain */
+    printf("-I- Format disk 0\n\r");
+    printf("-I- Please wait a moment during formating...\n\r");
+    res = f_mkfs(0,    /* Drv */
+                 0,    /* FDISK partition */
+                 512); /* AllocSize */
+    if( res != FR_OK ) {
+        printf("-E- f_mkfs 0x%Xpb\n\r", res);
+        return 0;
+    }
+
+    printf("-I- Create a %d bytes file : \"%s\"\n\r", FILE_SIZE, FileName);
+    res = CreateTestFile();
+    if( res != FR_OK ) {
+        printf("-E- Create file pb: 0x%X\n\r", res);
+        return 0;
+    }
+
+    res = RunSeeks(false, &timeNormal);
+    if( res != FR_OK ) {
+        printf("-E- Normal seek pb: 0x%X\n\r", res);
+        return 0;
+    }
+    printf("-I- Normal seek: %d seeks in %u ms\n\r", NUM_SEEKS, (unsigned int)timeNormal);
+
+    res = RunSeeks(true, &timeFast);
+    if( res != FR_OK ) {
+        printf("-E- Fast seek pb: 0x%X\n\r", res);
+        return 0;
+    }
+    printf("-I- Fast seek: %d seeks in %u ms\n\r", NUM_SEEKS, (unsigned int)timeFast);
+
+    printf("-I- Test passed !\n\r");
+
+    return 0;
+}
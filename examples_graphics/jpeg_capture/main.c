@@ -0,0 +1,755 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page jpeg_capture JPEG Capture Example
+ *
+ * \section Purpose
+ *
+ * This example shows how to compress the frames of a CMOS image sensor to JPEG
+ * files while they are captured, without any frame buffer.
+ *
+ * \section Requirements
+ *
+ * This package can be used with SAM3S evaluation kits which have a NAND FLASH
+ * device holding a FAT file system, for instance formatted with the
+ * fatfs_nandflash example. An 8-bit CMOS image sensor must be wired to the PIO
+ * Parallel Capture pins and configured beforehand (e.g. through its SCCB
+ * interface) for QVGA YCbYCr 4:2:2 output:
+ *   - PA23 PIODCCLK: pixel clock
+ *   - PA24 to PA31 PIODC0 to PIODC7: pixel data
+ *   - PA15 PIODCEN1: frame valid (VSYNC), high during the active lines
+ *   - PA16 PIODCEN2: line valid (HREF), high during the active pixels
+ *
+ * \section Description
+ *
+ * The PIO Parallel Capture only samples the data while both data enables
+ * are high, so the PDC receives the active pixels only. The frame is captured
+ * in strips of 8 lines, into two strip buffers used in ping-pong: while the
+ * PDC fills one strip, the other one is converted line by line from YCbYCr to
+ * YCbCr and given to jpeg_write_scanlines(), which encodes one MCU row per
+ * strip (4:2:2 sampling, like the sensor). The compressed data goes to a
+ * FatFs file through a 512-byte buffer.
+ *
+ * The strip just compressed is queued as the next PDC buffer with
+ * PIO_CaptureNextBuffer(), so the capture never stops within a frame. The
+ * compression of a strip must therefore not last longer than the capture of
+ * the other one: otherwise the PDC runs out of buffer, the frame is dropped
+ * and the sensor pixel clock must be lowered. The compression uses the
+ * Cortex-M3 tuned DCT and Huffman coder (JDCT_M3); at startup, the encoder
+ * speed of the DCT methods is measured on synthetic frames.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it inside the evaluation board. Please
+ *    refer to the
+ *    <a href="http://www.atmel.com/dyn/resources/prod_documents/doc6224.pdf">
+ *    SAM-BA User Guide</a>, the
+ *    <a href="http://www.atmel.com/dyn/resources/prod_documents/doc6310.pdf">
+ *    GNU-Based Software Development</a> application note or to the
+ *    <a href="ftp://ftp.iar.se/WWWfiles/arm/Guides/EWARM_UserGuide.ENU.pdf">
+ *    IAR EWARM User Guide</a>, depending on your chosen solution.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 bauds
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application.
+ * -# In the terminal window, the following text should appear:
+ *    \code
+ *     -- JPEG_CAPTURE Example xxx --
+ *     -- xxxxxx-xx
+ *     -- Compiled: xxx xx xxxx xx:xx:xx --
+ *     -I- Encoder ISLOW: x.x fps, xxxxx bytes per frame
+ *     -I- Encoder IFAST: x.x fps, xxxxx bytes per frame
+ *     -I- Encoder M3: x.x fps, xxxxx bytes per frame
+ *     -I- CAP000.JPG: 320x240, xxxxx bytes, xxx ms
+ *     ...
+ *    \endcode
+ *
+ * \section References
+ * - jpeg_capture/main.c
+ * - pio_capture.c
+ * - jcapistd.c
+ * - ff.c
+ */
+
+/**
+ * \file
+ *
+ * This file contains all the specific code for the jpeg_capture example.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "board.h"
+#include "memories.h"
+
+/* These headers were introduced in C99 by working group ISO/IEC JTC1/SC22/WG14. */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <setjmp.h>
+
+#include "fatfs_config.h"
+
+#include "jpeglib.h"
+#include "jerror.h"
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Maximum number of Medias which can be defined. */
+#define MAX_MEDS            1
+
+/** Size of the reserved Nand Flash (4M) */
+#define NF_RESERVE_SIZE     (4*1024*1024)
+
+/** Size of the managed Nand Flash (128M) */
+#define NF_MANAGED_SIZE     (128*1024*1024)
+
+/** Captured frame size */
+#define CAPTURE_WIDTH       320
+#define CAPTURE_HEIGHT      240
+
+/** Lines per strip, one MCU row with 4:2:2 sampling */
+#define STRIP_LINES         8
+
+/** Number of strips in a frame */
+#define STRIP_COUNT         (CAPTURE_HEIGHT / STRIP_LINES)
+
+/** Size of a strip in PDC words, 2 bytes per pixel */
+#define STRIP_WORDS         (CAPTURE_WIDTH * 2 * STRIP_LINES / 4)
+
+/** Number of frames recorded */
+#define CAPTURE_FRAMES      10
+
+/** JPEG quality of the recorded frames */
+#define JPEG_QUALITY        75
+
+/** DCT method of the capture, JDCT_M3 is the fastest on the Cortex-M3 */
+#define JPEG_DCT_METHOD     JDCT_M3
+
+/** Number of frames encoded for each DCT method by the encoder benchmark */
+#define BENCH_FRAMES        4
+
+/** Size of the file write buffer of the JPEG destination manager */
+#define OUTPUT_BUFFER_SIZE  512
+
+#if _FS_TINY == 0
+#define STR_ROOT_DIRECTORY "0:"
+#else
+#define STR_ROOT_DIRECTORY ""
+#endif
+
+/** Parallel Capture Mode Data Enable1, frame valid of the sensor */
+#define PIN_PIODCEN1_VSYNC  {PIO_PA15, PIOA, ID_PIOA, PIO_INPUT, PIO_DEFAULT}
+
+/** JPEG destination manager writing a FatFs file */
+typedef struct _SFileDestination
+{
+    struct jpeg_destination_mgr pub ;
+    FIL* pFile ;
+    JOCTET aucBuffer[OUTPUT_BUFFER_SIZE] ;
+} SFileDestination ;
+
+/** JPEG error manager returning to the capture loop instead of exiting */
+typedef struct _SErrorManager
+{
+    struct jpeg_error_mgr pub ;
+    jmp_buf jmpBuffer ;
+} SErrorManager ;
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Available medias. */
+Media medias[MAX_MEDS];
+
+/** Pins used to access to nandflash. */
+static const Pin pPinsNf[] = {PINS_NANDFLASH};
+/** Nandflash device structure. */
+static struct TranslatedNandFlash translatedNf;
+/** Address for transferring command bytes to the nandflash. */
+static uint32_t cmdBytesAddr = BOARD_NF_COMMAND_ADDR;
+/** Address for transferring address bytes to the nandflash. */
+static uint32_t addrBytesAddr = BOARD_NF_ADDRESS_ADDR;
+/** Address for transferring data bytes to the nandflash. */
+static uint32_t dataBytesAddr = BOARD_NF_DATA_ADDR;
+/** Nandflash chip enable pin. */
+static const Pin nfCePin = BOARD_NF_CE_PIN;
+/** Nandflash ready/busy pin. */
+static const Pin nfRbPin = BOARD_NF_RB_PIN;
+
+/** Sensor frame valid pin */
+static const Pin pinVsync = PIN_PIODCEN1_VSYNC ;
+
+/** File system object */
+static FATFS fs ;
+/** Currently recorded file */
+static FIL jpegFile ;
+/** Destination manager of the currently recorded file */
+static SFileDestination fileDestination ;
+
+/** API for PIO Parallel Capture */
+static SpioCaptureInit pioCapture ;
+
+/** Strip buffers filled in turn by the PDC */
+BOARD_NOINIT_SECTION static uint32_t adwStrips[2][STRIP_WORDS] ;
+
+/** Strips of the frame given to the PDC */
+static volatile uint32_t dwStripsQueued ;
+/** Strips of the frame fully captured */
+static volatile uint32_t dwStripsFull ;
+/** Set when the PDC ran out of buffer within a frame */
+static volatile uint8_t ucOverrun ;
+
+/** YCbCr line given to the compressor */
+static JSAMPLE aucLine[CAPTURE_WIDTH * 3] ;
+
+/** Compressed bytes counted by the benchmark destination */
+static uint32_t dwBenchBytes ;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Handler for SysTick interrupt. Increments the timestamp counter.
+ */
+void SysTick_Handler( void )
+{
+    TimeTick_Increment() ;
+}
+
+/**
+ *  \brief Initialize Nand Flash
+ *  \return true if initialized succesfully.
+ */
+static uint8_t NandFlashInitialize( void )
+{
+    uint16_t nfBaseBlock ;
+    struct RawNandFlash *pRaw = (struct RawNandFlash*)&translatedNf ;
+    struct NandFlashModel *pModel = (struct NandFlashModel*)&translatedNf ;
+    uint32_t nfManagedSize ;
+
+    /* Configure for NandFlash */
+    BOARD_ConfigureNandFlash( SMC ) ;
+    /* Configure PIO for Nand Flash */
+    PIO_Configure( pPinsNf, PIO_LISTSIZE( pPinsNf ) ) ;
+
+    /* Nand Flash Initialize (ALL flash mapped) */
+    if ( RawNandFlash_Initialize( pRaw, 0, cmdBytesAddr, addrBytesAddr, dataBytesAddr, nfCePin, nfRbPin ) )
+    {
+        printf( "-E- Nand not found\n\r" ) ;
+        return false ;
+    }
+    nfBaseBlock = NF_RESERVE_SIZE / NandFlashModel_GetBlockSizeInBytes( pModel ) ;
+
+    nfManagedSize = ((NandFlashModel_GetDeviceSizeInMBytes(pModel) - NF_RESERVE_SIZE/1024/1024) > NF_MANAGED_SIZE/1024/1024) ? \
+                        NF_MANAGED_SIZE/1024/1024 : (NandFlashModel_GetDeviceSizeInMBytes(pModel) - NF_RESERVE_SIZE/1024/1024);
+    if ( TranslatedNandFlash_Initialize( &translatedNf, 0, cmdBytesAddr, addrBytesAddr, dataBytesAddr, nfCePin, nfRbPin,
+                                         nfBaseBlock, nfManagedSize * 1024 * 1024/NandFlashModel_GetBlockSizeInBytes(pModel) ) )
+    {
+        printf( "-E- Nand init error\n\r" ) ;
+        return false ;
+    }
+    /* Media initialize */
+    MEDNandFlash_Initialize( &medias[DRV_NAND], &translatedNf ) ;
+
+    return true ;
+}
+
+/**
+ * \brief Callback on end of reception transfer, a strip is full and the PDC
+ * goes on with the queued one.
+ *
+ * The interrupt stays disabled until the next strip is queued, as the flag is
+ * only cleared by writing the next counter.
+ */
+static void OnEndOfReception( SpioCaptureInit* pParam )
+{
+    dwStripsFull++ ;
+    PIO_CaptureDisableIt( PIO_PCISR_ENDRX ) ;
+}
+
+/**
+ * \brief Callback on reception buffer full, the PDC stopped as all the queued
+ * strips are full: at the end of the frame, or when the compression is late.
+ */
+static void OnReceptionBufferFull( SpioCaptureInit* pParam )
+{
+    PIO_CaptureDisableIt( PIO_PCISR_RXBUFF|PIO_PCISR_ENDRX ) ;
+    PIO_CaptureDisable() ;
+
+    dwStripsFull = dwStripsQueued ;
+    if ( dwStripsQueued < STRIP_COUNT )
+    {
+        ucOverrun = 1 ;
+    }
+}
+
+/**
+ * \brief Starts the capture of a frame into the two strips, at the next frame
+ * start.
+ */
+static void CaptureStart( void )
+{
+    dwStripsFull = 0 ;
+    ucOverrun = 0 ;
+
+    /* Word data, the PDC receives the pixels of the enabled lines only */
+    pioCapture.dsize = 2 ;
+    pioCapture.dPDCsize = STRIP_WORDS ;
+    pioCapture.pData = adwStrips[0] ;
+    pioCapture.alwaysSampling = 0 ;
+    pioCapture.halfSampling = 0 ;
+    pioCapture.modeFirstSample = 0 ;
+    pioCapture.CbkDataReady = NULL ;
+    pioCapture.CbkOverrun = NULL ;
+    pioCapture.CbkEndReception = OnEndOfReception ;
+    pioCapture.CbkBuffFull = OnReceptionBufferFull ;
+    pioCapture.pParam = NULL ;
+
+    PIO_CaptureInit( &pioCapture ) ;
+    PIO_CaptureNextBuffer( adwStrips[1], STRIP_WORDS ) ;
+    dwStripsQueued = 2 ;
+
+    /* Enable during the vertical blanking, so the capture starts with the first line */
+    while ( PIO_Get( &pinVsync ) )
+    {
+    }
+    PIO_CaptureEnable() ;
+}
+
+/**
+ * \brief Waits for a strip of the frame to be captured.
+ *
+ * \return false if the frame was dropped.
+ */
+static bool CaptureWaitStrip( uint32_t dwStrip )
+{
+    while ( (dwStripsFull <= dwStrip) && !ucOverrun )
+    {
+    }
+
+    return !ucOverrun ;
+}
+
+/**
+ * \brief Gives a compressed strip back to the PDC, as the buffer of a strip
+ * not queued yet.
+ */
+static void CaptureReleaseStrip( uint32_t dwStrip )
+{
+    if ( dwStripsQueued >= STRIP_COUNT )
+    {
+        return ;
+    }
+
+    __disable_irq() ;
+    /* A stopped PDC is reported by the buffer full interrupt, never restarted */
+    if ( PIOA->PIO_RCR != 0 )
+    {
+        PIO_CaptureNextBuffer( adwStrips[dwStrip & 1], STRIP_WORDS ) ;
+        dwStripsQueued++ ;
+        PIO_CaptureEnableIt( PIO_PCISR_ENDRX ) ;
+    }
+    __enable_irq() ;
+}
+
+/**
+ * \brief Stops the capture.
+ */
+static void CaptureStop( void )
+{
+    PIO_CaptureDisableIt( PIO_PCISR_RXBUFF|PIO_PCISR_ENDRX ) ;
+    PIO_CaptureDisable() ;
+}
+
+/**
+ * \brief Destination manager init method, the write buffer gets empty.
+ */
+static void FileDestination_Init( j_compress_ptr cinfo )
+{
+    fileDestination.pub.next_output_byte = fileDestination.aucBuffer ;
+    fileDestination.pub.free_in_buffer = OUTPUT_BUFFER_SIZE ;
+}
+
+/**
+ * \brief Destination manager method writing the full buffer to the file.
+ */
+static boolean FileDestination_Empty( j_compress_ptr cinfo )
+{
+    UINT dwWritten = 0 ;
+
+    if ( (f_write( fileDestination.pFile, fileDestination.aucBuffer, OUTPUT_BUFFER_SIZE, &dwWritten ) != FR_OK)
+      || (dwWritten != OUTPUT_BUFFER_SIZE) )
+    {
+        ERREXIT( cinfo, JERR_FILE_WRITE ) ;
+    }
+
+    fileDestination.pub.next_output_byte = fileDestination.aucBuffer ;
+    fileDestination.pub.free_in_buffer = OUTPUT_BUFFER_SIZE ;
+
+    return TRUE ;
+}
+
+/**
+ * \brief Destination manager termination method, writes the data left.
+ */
+static void FileDestination_Term( j_compress_ptr cinfo )
+{
+    UINT dwCount = OUTPUT_BUFFER_SIZE - fileDestination.pub.free_in_buffer ;
+    UINT dwWritten = 0 ;
+
+    if ( dwCount != 0 )
+    {
+        if ( (f_write( fileDestination.pFile, fileDestination.aucBuffer, dwCount, &dwWritten ) != FR_OK)
+          || (dwWritten != dwCount) )
+        {
+            ERREXIT( cinfo, JERR_FILE_WRITE ) ;
+        }
+    }
+}
+
+/**
+ * \brief Makes a compressor write a file opened by the caller.
+ */
+static void FileDestination_Attach( j_compress_ptr cinfo, FIL* pFile )
+{
+    fileDestination.pFile = pFile ;
+    fileDestination.pub.init_destination = FileDestination_Init ;
+    fileDestination.pub.empty_output_buffer = FileDestination_Empty ;
+    fileDestination.pub.term_destination = FileDestination_Term ;
+    cinfo->dest = &fileDestination.pub ;
+}
+
+/**
+ * \brief Benchmark destination manager init method, nothing is counted yet.
+ */
+static void BenchDestination_Init( j_compress_ptr cinfo )
+{
+    fileDestination.pub.next_output_byte = fileDestination.aucBuffer ;
+    fileDestination.pub.free_in_buffer = OUTPUT_BUFFER_SIZE ;
+    dwBenchBytes = 0 ;
+}
+
+/**
+ * \brief Benchmark destination manager method counting and dropping the full buffer.
+ */
+static boolean BenchDestination_Empty( j_compress_ptr cinfo )
+{
+    dwBenchBytes += OUTPUT_BUFFER_SIZE ;
+    fileDestination.pub.next_output_byte = fileDestination.aucBuffer ;
+    fileDestination.pub.free_in_buffer = OUTPUT_BUFFER_SIZE ;
+
+    return TRUE ;
+}
+
+/**
+ * \brief Benchmark destination manager termination method, counts the data left.
+ */
+static void BenchDestination_Term( j_compress_ptr cinfo )
+{
+    dwBenchBytes += OUTPUT_BUFFER_SIZE - fileDestination.pub.free_in_buffer ;
+}
+
+/**
+ * \brief Error manager exit method: prints the message and aborts the frame.
+ */
+static void ErrorManager_Exit( j_common_ptr cinfo )
+{
+    SErrorManager* pErr = (SErrorManager*)cinfo->err ;
+
+    (*cinfo->err->output_message)( cinfo ) ;
+    longjmp( pErr->jmpBuffer, 1 ) ;
+}
+
+/**
+ * \brief Converts a YCbYCr 4:2:2 line of a strip to the YCbCr pixels expected
+ * by the compressor, each chroma pair being shared by two pixels.
+ */
+static void ConvertLine( const uint8_t* pucIn, JSAMPLE* pucOut )
+{
+    uint32_t i ;
+
+    for ( i = 0 ; i < CAPTURE_WIDTH / 2 ; i++ )
+    {
+        pucOut[0] = pucIn[0] ;
+        pucOut[1] = pucIn[1] ;
+        pucOut[2] = pucIn[3] ;
+        pucOut[3] = pucIn[2] ;
+        pucOut[4] = pucIn[1] ;
+        pucOut[5] = pucIn[3] ;
+        pucIn += 4 ;
+        pucOut += 6 ;
+    }
+}
+
+/**
+ * \brief Captures a frame and compresses it to a JPEG file, strip by strip.
+ *
+ * \param pszName  File name.
+ *
+ * \return 0 if the file was recorded, 1 otherwise.
+ */
+static uint32_t CaptureJpegFile( const char* pszName )
+{
+    struct jpeg_compress_struct cinfo ;
+    SErrorManager jerr ;
+    JSAMPROW pRow = aucLine ;
+    const uint8_t* pucStrip ;
+    uint32_t dwStart ;
+    uint32_t dwStrip ;
+    uint32_t dwLine ;
+
+    if ( f_open( &jpegFile, pszName, FA_CREATE_ALWAYS|FA_WRITE ) != FR_OK )
+    {
+        printf( "-E- %s: create failed\n\r", pszName ) ;
+        return 1 ;
+    }
+
+    cinfo.err = jpeg_std_error( &jerr.pub ) ;
+    jerr.pub.error_exit = ErrorManager_Exit ;
+    if ( setjmp( jerr.jmpBuffer ) )
+    {
+        CaptureStop() ;
+        jpeg_destroy_compress( &cinfo ) ;
+        f_close( &jpegFile ) ;
+        f_unlink( pszName ) ;
+        return 1 ;
+    }
+
+    jpeg_create_compress( &cinfo ) ;
+    FileDestination_Attach( &cinfo, &jpegFile ) ;
+
+    /* YCbCr input, no color conversion, and 4:2:2 sampling like the sensor */
+    cinfo.image_width = CAPTURE_WIDTH ;
+    cinfo.image_height = CAPTURE_HEIGHT ;
+    cinfo.input_components = 3 ;
+    cinfo.in_color_space = JCS_YCbCr ;
+    jpeg_set_defaults( &cinfo ) ;
+    jpeg_set_quality( &cinfo, JPEG_QUALITY, TRUE ) ;
+    cinfo.dct_method = JPEG_DCT_METHOD ;
+    cinfo.comp_info[0].h_samp_factor = 2 ;
+    cinfo.comp_info[0].v_samp_factor = 1 ;
+
+    /* The headers are written before the capture, to keep up with the first strip */
+    jpeg_start_compress( &cinfo, TRUE ) ;
+
+    dwStart = GetTickCount() ;
+    CaptureStart() ;
+
+    for ( dwStrip = 0 ; dwStrip < STRIP_COUNT ; dwStrip++ )
+    {
+        if ( !CaptureWaitStrip( dwStrip ) )
+        {
+            printf( "-E- %s: strip %u overrun, lower the sensor clock\n\r", pszName, (unsigned int)dwStrip ) ;
+            CaptureStop() ;
+            jpeg_destroy_compress( &cinfo ) ;
+            f_close( &jpegFile ) ;
+            f_unlink( pszName ) ;
+            return 1 ;
+        }
+
+        pucStrip = (const uint8_t*)adwStrips[dwStrip & 1] ;
+        for ( dwLine = 0 ; dwLine < STRIP_LINES ; dwLine++ )
+        {
+            ConvertLine( pucStrip + dwLine * CAPTURE_WIDTH * 2, aucLine ) ;
+            jpeg_write_scanlines( &cinfo, &pRow, 1 ) ;
+        }
+
+        /* The strip is compressed, its buffer can receive the strip after next */
+        CaptureReleaseStrip( dwStrip ) ;
+    }
+
+    CaptureStop() ;
+    jpeg_finish_compress( &cinfo ) ;
+    jpeg_destroy_compress( &cinfo ) ;
+
+    printf( "-I- %s: %ux%u, %u bytes, %u ms\n\r", pszName, CAPTURE_WIDTH, CAPTURE_HEIGHT,
+            (unsigned int)jpegFile.fsize, (unsigned int)(GetTickCount() - dwStart) ) ;
+    f_close( &jpegFile ) ;
+
+    return 0 ;
+}
+
+/**
+ * \brief Measures the encoder speed with a DCT method, on synthetic QVGA frames
+ * compressed like the captured ones but without capture nor file writes.
+ *
+ * \param eMethod  DCT method.
+ * \param pszName  Method name to print.
+ */
+static void BenchmarkEncoder( J_DCT_METHOD eMethod, const char* pszName )
+{
+    struct jpeg_compress_struct cinfo ;
+    SErrorManager jerr ;
+    JSAMPROW pRow = aucLine ;
+    uint8_t* pucStrip = (uint8_t*)adwStrips[0] ;
+    uint32_t dwStart ;
+    uint32_t dwTime ;
+    uint32_t dwFrame ;
+    uint32_t dwLine ;
+    uint32_t dwBytes = 0 ;
+    uint32_t i ;
+
+    cinfo.err = jpeg_std_error( &jerr.pub ) ;
+    jerr.pub.error_exit = ErrorManager_Exit ;
+    if ( setjmp( jerr.jmpBuffer ) )
+    {
+        jpeg_destroy_compress( &cinfo ) ;
+        return ;
+    }
+
+    jpeg_create_compress( &cinfo ) ;
+    fileDestination.pub.init_destination = BenchDestination_Init ;
+    fileDestination.pub.empty_output_buffer = BenchDestination_Empty ;
+    fileDestination.pub.term_destination = BenchDestination_Term ;
+    cinfo.dest = &fileDestination.pub ;
+
+    cinfo.image_width = CAPTURE_WIDTH ;
+    cinfo.image_height = CAPTURE_HEIGHT ;
+    cinfo.input_components = 3 ;
+    cinfo.in_color_space = JCS_YCbCr ;
+    jpeg_set_defaults( &cinfo ) ;
+    jpeg_set_quality( &cinfo, JPEG_QUALITY, TRUE ) ;
+    cinfo.dct_method = eMethod ;
+    cinfo.comp_info[0].h_samp_factor = 2 ;
+    cinfo.comp_info[0].v_samp_factor = 1 ;
+
+    dwStart = GetTickCount() ;
+
+    for ( dwFrame = 0 ; dwFrame < BENCH_FRAMES ; dwFrame++ )
+    {
+        jpeg_start_compress( &cinfo, TRUE ) ;
+
+        while ( cinfo.next_scanline < cinfo.image_height )
+        {
+            /* Fill a strip with a gradient and some texture, as the sensor would */
+            if ( (cinfo.next_scanline % STRIP_LINES) == 0 )
+            {
+                for ( i = 0 ; i < STRIP_WORDS * 4 ; i++ )
+                {
+                    pucStrip[i] = (uint8_t)( (i & 1) ? (128 + (i >> 6)) : (cinfo.next_scanline + (i >> 2) + ((i * 7) & 0x1F)) ) ;
+                }
+            }
+
+            dwLine = cinfo.next_scanline % STRIP_LINES ;
+            ConvertLine( pucStrip + dwLine * CAPTURE_WIDTH * 2, aucLine ) ;
+            jpeg_write_scanlines( &cinfo, &pRow, 1 ) ;
+        }
+
+        jpeg_finish_compress( &cinfo ) ;
+        dwBytes += dwBenchBytes ;
+    }
+
+    dwTime = GetTickCount() - dwStart ;
+    jpeg_destroy_compress( &cinfo ) ;
+
+    if ( dwTime == 0 )
+    {
+        dwTime = 1 ;
+    }
+
+    printf( "-I- Encoder %s: %u.%u fps, %u bytes per frame\n\r", pszName,
+            (unsigned int)(BENCH_FRAMES * 1000 / dwTime), (unsigned int)((BENCH_FRAMES * 10000 / dwTime) % 10),
+            (unsigned int)(dwBytes / BENCH_FRAMES) ) ;
+}
+
+/*----------------------------------------------------------------------------
+ *         Global functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Application entry point for jpeg_capture example.
+ *
+ * \return Unused (ANSI-C compatibility).
+ */
+extern int main( void )
+{
+    char szName[16] ;
+    uint32_t dwFrame ;
+
+    /* Disable watchdog */
+    WDT_Disable( WDT ) ;
+
+    /* Output example information */
+    printf( "-- JPEG_CAPTURE Example %s --\n\r", SOFTPACK_VERSION ) ;
+    printf( "-- %s\n\r", BOARD_NAME ) ;
+    printf( "-- Compiled: %s %s --\n\r", __DATE__, __TIME__ ) ;
+
+    /* Configure systick for 1 ms. */
+    if ( TimeTick_Configure( BOARD_MCK ) != 0 )
+    {
+        printf( "-F- Systick configuration error\n\r" ) ;
+    }
+
+    /* QVGA encoder speed of each DCT method, the capture uses JPEG_DCT_METHOD */
+    BenchmarkEncoder( JDCT_ISLOW, "ISLOW" ) ;
+    BenchmarkEncoder( JDCT_IFAST, "IFAST" ) ;
+    BenchmarkEncoder( JDCT_M3, "M3" ) ;
+
+    /* Init NandFlash Disk and mount it */
+    if ( !NandFlashInitialize() )
+    {
+        printf( "-F- NF Init FAIL\n\r" ) ;
+        return 0 ;
+    }
+
+    memset( &fs, 0, sizeof( FATFS ) ) ;
+    if ( f_mount( 0, &fs ) != FR_OK )
+    {
+        printf( "-F- f_mount pb\n\r" ) ;
+        return 0 ;
+    }
+
+    /* The capture interrupts come through the PIOA handler */
+    PIO_InitializeInterrupts( 0 ) ;
+    PIO_Configure( &pinVsync, 1 ) ;
+
+    for ( dwFrame = 0 ; dwFrame < CAPTURE_FRAMES ; dwFrame++ )
+    {
+        sprintf( szName, STR_ROOT_DIRECTORY "CAP%03u.JPG", (unsigned int)dwFrame ) ;
+        CaptureJpegFile( szName ) ;
+    }
+
+    printf( "-I- Done\n\r" ) ;
+
+    return 0 ;
+}
@@ -0,0 +1,887 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page jpeg_lcd JPEG LCD Example
+ *
+ * \section Purpose
+ *
+ * This example shows how to decode JPEG images stored on a FAT file system
+ * straight into the LCD frame memory, without any full frame or RGB line
+ * buffer.
+ *
+ * \section Requirements
+ *
+ * This package can be used with SAM3S evaluation kits which have a NAND FLASH
+ * device. The NAND FLASH must hold a FAT file system with some baseline JPEG
+ * files (*.jpg) in its root directory, for instance written with the
+ * fatfs_nandflash example or the USB mass storage examples.
+ *
+ * \section Description
+ *
+ * The example mounts the NAND FLASH disk and loops over the JPEG files of its
+ * root directory. Each image is scaled down by 1/2, 1/4 or 1/8 when needed to
+ * fit the screen, and centered. The LCD window is opened on the image area,
+ * then jpeg_set_output_port() makes the libjpeg color conversion write each
+ * pixel to the ILI9325 data register as soon as it is converted: the decoded
+ * lines go from the IDCT and upsampling buffers to the frame memory in one
+ * burst, so only the libjpeg working buffers are needed in RAM.
+ *
+ * Before mounting the disk, a splash image is shown if one is found at the
+ * start of the last 32 KB of the internal flash, or else at address 0 of an
+ * AT45 DataFlash wired on the SPI (NPCS0). The image is decoded where it
+ * lives: jpeg_mem_src() reads the internal flash in place, and
+ * jpeg_chunk_src() streams the DataFlash through two 512-byte chunks, the
+ * SPI PDC reading the next chunk while the current one is decoded. A splash
+ * image can be programmed with SAM-BA, provided the program code does not
+ * reach the splash area.
+ *
+ * At startup, the first image is decoded with each IDCT method (JDCT_ISLOW,
+ * JDCT_IFAST and the Cortex-M3 tuned JDCT_M3) at each scaling, without
+ * display, and the decoding speed is printed in core cycles per MCU. The
+ * slideshow then uses JDCT_M3.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it inside the evaluation board. Please
+ *    refer to the
+ *    <a href="http://www.atmel.com/dyn/resources/prod_documents/doc6224.pdf">
+ *    SAM-BA User Guide</a>, the
+ *    <a href="http://www.atmel.com/dyn/resources/prod_documents/doc6310.pdf">
+ *    GNU-Based Software Development</a> application note or to the
+ *    <a href="ftp://ftp.iar.se/WWWfiles/arm/Guides/EWARM_UserGuide.ENU.pdf">
+ *    IAR EWARM User Guide</a>, depending on your chosen solution.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 bauds
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application.
+ * -# In the terminal window, the following text should appear:
+ *    \code
+ *     -- JPEG_LCD Example xxx --
+ *     -- xxxxxx-xx
+ *     -- Compiled: xxx xx xxxx xx:xx:xx --
+ *     -I- Benchmark of xxx.jpg, 640x480
+ *     -I- islow 1/1: xxx ms, xxxx cycles per MCU
+ *     ...
+ *     -I- m3    1/8: xx ms, xxx cycles per MCU
+ *     -I- xxx.jpg: 640x480 shown as 160x120, xx ms
+ *    \endcode
+ * -# The images are shown on the LCD one after another.
+ *
+ * \section References
+ * - jpeg_lcd/main.c
+ * - jdcolor.c
+ * - jdatasrc_chunk.c
+ * - jidctm3.c
+ * - ili9325.c
+ * - ff.c
+ */
+
+/**
+ * \file
+ *
+ * This file contains all the specific code for the jpeg_lcd example.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "board.h"
+#include "memories.h"
+
+/* These headers were introduced in C99 by working group ISO/IEC JTC1/SC22/WG14. */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <setjmp.h>
+
+#include "fatfs_config.h"
+
+#include "jpeglib.h"
+#include "jerror.h"
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Maximum number of Medias which can be defined. */
+#define MAX_MEDS            1
+
+/** Size of the reserved Nand Flash (4M) */
+#define NF_RESERVE_SIZE     (4*1024*1024)
+
+/** Size of the managed Nand Flash (128M) */
+#define NF_MANAGED_SIZE     (128*1024*1024)
+
+/** Size of the file read buffer of the JPEG source manager */
+#define INPUT_BUFFER_SIZE   512
+
+/** Time each image stays on the screen, in ms */
+#define DISPLAY_DELAY       2000
+
+/** Number of IDCT methods compared by the benchmark */
+#define BENCH_METHODS       3
+
+/** Size of the internal flash area holding the splash image */
+#define SPLASH_IFLASH_SIZE  (32*1024)
+
+/** Start of the internal flash splash image */
+#define SPLASH_IFLASH_ADDR  (IFLASH_ADDR + IFLASH_SIZE - SPLASH_IFLASH_SIZE)
+
+/** DataFlash address of the splash image */
+#define SPLASH_AT45_ADDRESS 0
+
+/** SPI clock frequency of the DataFlash, in Hz */
+#define SPLASH_AT45_SPCK    20000000
+
+/** Size of the DataFlash source buffer, two chunks */
+#define SPLASH_BUFFER_SIZE  1024
+
+#if _FS_TINY == 0
+#define STR_ROOT_DIRECTORY "0:"
+#else
+#define STR_ROOT_DIRECTORY ""
+#endif
+
+/** JPEG source manager reading a FatFs file */
+typedef struct _SFileSource
+{
+    struct jpeg_source_mgr pub ;
+    FIL* pFile ;
+    JOCTET aucBuffer[INPUT_BUFFER_SIZE] ;
+} SFileSource ;
+
+/** JPEG chunk reader streaming the DataFlash through the SPI PDC */
+typedef struct _SDataflashReader
+{
+    struct jpeg_chunk_reader pub ;
+    At45* pAt45 ;
+    uint32_t dwError ;
+} SDataflashReader ;
+
+/** JPEG error manager returning to the decode loop instead of exiting */
+typedef struct _SErrorManager
+{
+    struct jpeg_error_mgr pub ;
+    jmp_buf jmpBuffer ;
+} SErrorManager ;
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Available medias. */
+Media medias[MAX_MEDS];
+
+/** Pins used to access to nandflash. */
+static const Pin pPinsNf[] = {PINS_NANDFLASH};
+/** Nandflash device structure. */
+static struct TranslatedNandFlash translatedNf;
+/** Address for transferring command bytes to the nandflash. */
+static uint32_t cmdBytesAddr = BOARD_NF_COMMAND_ADDR;
+/** Address for transferring address bytes to the nandflash. */
+static uint32_t addrBytesAddr = BOARD_NF_ADDRESS_ADDR;
+/** Address for transferring data bytes to the nandflash. */
+static uint32_t dataBytesAddr = BOARD_NF_DATA_ADDR;
+/** Nandflash chip enable pin. */
+static const Pin nfCePin = BOARD_NF_CE_PIN;
+/** Nandflash ready/busy pin. */
+static const Pin nfRbPin = BOARD_NF_RB_PIN;
+
+/** Pins used to access to the DataFlash. */
+static const Pin pPinsSpi[] = {PINS_SPI, PIN_SPI_NPCS0_PA11};
+/** SPI driver instance. */
+static Spid spid ;
+/** AT45 driver instance. */
+static At45 at45 ;
+/** Reader of the DataFlash splash image */
+static SDataflashReader dataflashReader ;
+/** Chunks of the DataFlash splash image */
+static JOCTET aucSplashBuffer[SPLASH_BUFFER_SIZE] ;
+
+/** File system object */
+static FATFS fs ;
+/** Currently decoded file */
+static FIL jpegFile ;
+/** Source manager of the currently decoded file */
+static SFileSource fileSource ;
+
+/** Data port receiving the benchmark output */
+static volatile JSAMPLE benchPort ;
+
+/** IDCT methods compared by the benchmark, and their names */
+static const J_DCT_METHOD benchMethods[BENCH_METHODS] = { JDCT_ISLOW, JDCT_IFAST, JDCT_M3 } ;
+static const char* benchNames[BENCH_METHODS] = { "islow", "ifast", "m3   " } ;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Handler for SysTick interrupt. Increments the timestamp counter.
+ */
+void SysTick_Handler( void )
+{
+    TimeTick_Increment() ;
+}
+
+/**
+ *  \brief Initialize Nand Flash
+ *  \return true if initialized succesfully.
+ */
+static uint8_t NandFlashInitialize( void )
+{
+    uint16_t nfBaseBlock ;
+    struct RawNandFlash *pRaw = (struct RawNandFlash*)&translatedNf ;
+    struct NandFlashModel *pModel = (struct NandFlashModel*)&translatedNf ;
+    uint32_t nfManagedSize ;
+
+    /* Configure for NandFlash */
+    BOARD_ConfigureNandFlash( SMC ) ;
+    /* Configure PIO for Nand Flash */
+    PIO_Configure( pPinsNf, PIO_LISTSIZE( pPinsNf ) ) ;
+
+    /* Nand Flash Initialize (ALL flash mapped) */
+    if ( RawNandFlash_Initialize( pRaw, 0, cmdBytesAddr, addrBytesAddr, dataBytesAddr, nfCePin, nfRbPin ) )
+    {
+        printf( "-E- Nand not found\n\r" ) ;
+        return false ;
+    }
+    nfBaseBlock = NF_RESERVE_SIZE / NandFlashModel_GetBlockSizeInBytes( pModel ) ;
+
+    nfManagedSize = ((NandFlashModel_GetDeviceSizeInMBytes(pModel) - NF_RESERVE_SIZE/1024/1024) > NF_MANAGED_SIZE/1024/1024) ? \
+                        NF_MANAGED_SIZE/1024/1024 : (NandFlashModel_GetDeviceSizeInMBytes(pModel) - NF_RESERVE_SIZE/1024/1024);
+    if ( TranslatedNandFlash_Initialize( &translatedNf, 0, cmdBytesAddr, addrBytesAddr, dataBytesAddr, nfCePin, nfRbPin,
+                                         nfBaseBlock, nfManagedSize * 1024 * 1024/NandFlashModel_GetBlockSizeInBytes(pModel) ) )
+    {
+        printf( "-E- Nand init error\n\r" ) ;
+        return false ;
+    }
+    /* Media initialize */
+    MEDNandFlash_Initialize( &medias[DRV_NAND], &translatedNf ) ;
+
+    return true ;
+}
+
+/**
+ * \brief Source manager init method, nothing to do as the file is already open.
+ */
+static void FileSource_Init( j_decompress_ptr cinfo )
+{
+}
+
+/**
+ * \brief Source manager method refilling the input buffer from the file.
+ *
+ * At the end of the file, a fake EOI marker is inserted so that a truncated
+ * file still gives a (partial) image.
+ */
+static boolean FileSource_Fill( j_decompress_ptr cinfo )
+{
+    SFileSource* pSrc = (SFileSource*)cinfo->src ;
+    UINT dwRead = 0 ;
+
+    if ( (f_read( pSrc->pFile, pSrc->aucBuffer, INPUT_BUFFER_SIZE, &dwRead ) != FR_OK) || (dwRead == 0) )
+    {
+        WARNMS( cinfo, JWRN_JPEG_EOF ) ;
+        pSrc->aucBuffer[0] = (JOCTET)0xFF ;
+        pSrc->aucBuffer[1] = (JOCTET)JPEG_EOI ;
+        dwRead = 2 ;
+    }
+
+    pSrc->pub.next_input_byte = pSrc->aucBuffer ;
+    pSrc->pub.bytes_in_buffer = dwRead ;
+
+    return TRUE ;
+}
+
+/**
+ * \brief Source manager method skipping data, typically unused APPn markers.
+ */
+static void FileSource_Skip( j_decompress_ptr cinfo, long lBytes )
+{
+    struct jpeg_source_mgr* pSrc = cinfo->src ;
+
+    if ( lBytes <= 0 )
+    {
+        return ;
+    }
+
+    while ( lBytes > (long)pSrc->bytes_in_buffer )
+    {
+        lBytes -= (long)pSrc->bytes_in_buffer ;
+        FileSource_Fill( cinfo ) ;
+    }
+    pSrc->next_input_byte += (size_t)lBytes ;
+    pSrc->bytes_in_buffer -= (size_t)lBytes ;
+}
+
+/**
+ * \brief Source manager termination method, the file is closed by the caller.
+ */
+static void FileSource_Term( j_decompress_ptr cinfo )
+{
+}
+
+/**
+ * \brief Makes a decompressor read a file opened by the caller.
+ */
+static void FileSource_Attach( j_decompress_ptr cinfo, FIL* pFile )
+{
+    fileSource.pFile = pFile ;
+    fileSource.pub.init_source = FileSource_Init ;
+    fileSource.pub.fill_input_buffer = FileSource_Fill ;
+    fileSource.pub.skip_input_data = FileSource_Skip ;
+    fileSource.pub.resync_to_restart = jpeg_resync_to_restart ;
+    fileSource.pub.term_source = FileSource_Term ;
+    fileSource.pub.bytes_in_buffer = 0 ;
+    fileSource.pub.next_input_byte = NULL ;
+    cinfo->src = &fileSource.pub ;
+}
+
+/**
+ * \brief Chunk reader method starting a DataFlash read, the SPI PDC moves the
+ * data while the previous chunk is decoded.
+ */
+static void DataflashReader_Start( struct jpeg_chunk_reader* pReader, JOCTET* pucBuffer,
+                                   unsigned long dwOffset, size_t dwLength )
+{
+    SDataflashReader* pDf = (SDataflashReader*)pReader ;
+
+    pDf->dwError = AT45_SendCommand( pDf->pAt45, AT45_CONTINUOUS_READ_LEG, 8, pucBuffer, dwLength, dwOffset, 0, 0 ) ;
+}
+
+/**
+ * \brief Chunk reader method waiting for the DataFlash read, polling the SPI
+ * driver as its interrupt is not used.
+ */
+static boolean DataflashReader_Wait( struct jpeg_chunk_reader* pReader )
+{
+    SDataflashReader* pDf = (SDataflashReader*)pReader ;
+
+    while ( AT45_IsBusy( pDf->pAt45 ) )
+    {
+        SPID_Handler( pDf->pAt45->pSpid ) ;
+    }
+
+    return (pDf->dwError == 0) ? TRUE : FALSE ;
+}
+
+/**
+ * \brief Initializes the SPI and the AT45 drivers, and identifies the DataFlash.
+ *
+ * \return true if a DataFlash was found.
+ */
+static bool DataflashInitialize( void )
+{
+    PIO_Configure( pPinsSpi, PIO_LISTSIZE( pPinsSpi ) ) ;
+    SPID_Configure( &spid, SPI, ID_SPI ) ;
+    SPID_ConfigureCS( &spid, 0, AT45_CSR( BOARD_MCK, SPLASH_AT45_SPCK ) ) ;
+    AT45_Configure( &at45, &spid, 0 ) ;
+
+    if ( AT45_FindDevice( &at45, AT45D_GetStatus( &at45 ) ) == NULL )
+    {
+        return false ;
+    }
+
+    dataflashReader.pub.start_read = DataflashReader_Start ;
+    dataflashReader.pub.wait_read = DataflashReader_Wait ;
+    dataflashReader.pAt45 = &at45 ;
+    dataflashReader.dwError = 0 ;
+
+    return true ;
+}
+
+/**
+ * \brief Error manager exit method: prints the message and aborts the image.
+ */
+static void ErrorManager_Exit( j_common_ptr cinfo )
+{
+    SErrorManager* pErr = (SErrorManager*)cinfo->err ;
+
+    (*cinfo->err->output_message)( cinfo ) ;
+    longjmp( pErr->jmpBuffer, 1 ) ;
+}
+
+/**
+ * \brief Checks whether a file name has the .jpg or .jpeg extension.
+ */
+static bool IsJpegFile( const char* pszName )
+{
+    const char* pszExt = strrchr( pszName, '.' ) ;
+    char szExt[6] ;
+    uint32_t i ;
+
+    if ( (pszExt == NULL) || (strlen( pszExt ) >= sizeof( szExt )) )
+    {
+        return false ;
+    }
+
+    for ( i = 0 ; pszExt[i] != 0 ; i++ )
+    {
+        szExt[i] = (char)toupper( (int)pszExt[i] ) ;
+    }
+    szExt[i] = 0 ;
+
+    return (strcmp( szExt, ".JPG" ) == 0) || (strcmp( szExt, ".JPEG" ) == 0) ;
+}
+
+/**
+ * \brief Decodes the image of a decompressor, its source being attached, into
+ * the LCD frame memory. Decoding errors exit through the error manager.
+ *
+ * \param cinfo    Decompressor.
+ * \param pszName  Image name, for the trace.
+ *
+ * \return 0 if the image was displayed, 1 if it is too large.
+ */
+static uint32_t DecodeToLcd( j_decompress_ptr cinfo, const char* pszName )
+{
+    JSAMPROW pDummyRow = NULL ;
+    uint32_t dwX ;
+    uint32_t dwY ;
+    uint32_t dwStart ;
+
+    dwStart = GetTickCount() ;
+    jpeg_read_header( cinfo, TRUE ) ;
+
+    /* Pixels go straight to the panel: RGB output, no quantization, no merged upsampling */
+    cinfo->out_color_space = JCS_RGB ;
+    cinfo->quantize_colors = FALSE ;
+    cinfo->do_fancy_upsampling = TRUE ;
+    cinfo->dct_method = JDCT_M3 ;
+
+    /* Scale the image down until it fits the screen */
+    cinfo->scale_num = 1 ;
+    for ( cinfo->scale_denom = 1 ; cinfo->scale_denom <= 8 ; cinfo->scale_denom *= 2 )
+    {
+        jpeg_calc_output_dimensions( cinfo ) ;
+        if ( (cinfo->output_width <= BOARD_LCD_WIDTH) && (cinfo->output_height <= BOARD_LCD_HEIGHT) )
+        {
+            break ;
+        }
+    }
+
+    if ( (cinfo->output_width > BOARD_LCD_WIDTH) || (cinfo->output_height > BOARD_LCD_HEIGHT) )
+    {
+        printf( "-E- %s: %ux%u is too large\n\r", pszName, (unsigned int)cinfo->image_width, (unsigned int)cinfo->image_height ) ;
+        return 1 ;
+    }
+
+    jpeg_start_decompress( cinfo ) ;
+
+    /* Open the LCD window on the centered image area and start a GRAM burst */
+    LCDD_Fill( COLOR_BLACK ) ;
+    dwX = (BOARD_LCD_WIDTH - cinfo->output_width) / 2 ;
+    dwY = (BOARD_LCD_HEIGHT - cinfo->output_height) / 2 ;
+    LCD_SetWindow( dwX, dwY, cinfo->output_width, cinfo->output_height ) ;
+    LCD_SetCursor( dwX, dwY ) ;
+    LCD_WriteRAM_Prepare() ;
+
+    /* The color conversion feeds the data register, the scanline buffer is never written */
+    jpeg_set_output_port( cinfo, (volatile JSAMPLE*)&LCD_D() ) ;
+    while ( cinfo->output_scanline < cinfo->output_height )
+    {
+        jpeg_read_scanlines( cinfo, &pDummyRow, 1 ) ;
+    }
+
+    LCD_SetWindow( 0, 0, BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT ) ;
+
+    printf( "-I- %s: %ux%u shown as %ux%u, %u ms\n\r", pszName,
+            (unsigned int)cinfo->image_width, (unsigned int)cinfo->image_height,
+            (unsigned int)cinfo->output_width, (unsigned int)cinfo->output_height,
+            (unsigned int)(GetTickCount() - dwStart) ) ;
+
+    jpeg_finish_decompress( cinfo ) ;
+
+    return 0 ;
+}
+
+/**
+ * \brief Decodes a JPEG file into the LCD frame memory.
+ *
+ * \param pszName  File name.
+ *
+ * \return 0 if the image was displayed, 1 otherwise.
+ */
+static uint32_t ShowJpegFile( const char* pszName )
+{
+    struct jpeg_decompress_struct cinfo ;
+    SErrorManager jerr ;
+    uint32_t dwResult ;
+
+    if ( f_open( &jpegFile, pszName, FA_OPEN_EXISTING|FA_READ ) != FR_OK )
+    {
+        printf( "-E- %s: open failed\n\r", pszName ) ;
+        return 1 ;
+    }
+
+    cinfo.err = jpeg_std_error( &jerr.pub ) ;
+    jerr.pub.error_exit = ErrorManager_Exit ;
+    if ( setjmp( jerr.jmpBuffer ) )
+    {
+        /* Decoding error: give the whole screen back and skip the file */
+        LCD_SetWindow( 0, 0, BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT ) ;
+        jpeg_destroy_decompress( &cinfo ) ;
+        f_close( &jpegFile ) ;
+        return 1 ;
+    }
+
+    jpeg_create_decompress( &cinfo ) ;
+    FileSource_Attach( &cinfo, &jpegFile ) ;
+
+    dwResult = DecodeToLcd( &cinfo, pszName ) ;
+
+    jpeg_destroy_decompress( &cinfo ) ;
+    f_close( &jpegFile ) ;
+
+    return dwResult ;
+}
+
+/**
+ * \brief Checks whether some data starts with a JPEG SOI marker.
+ */
+static bool IsJpegData( const uint8_t* pucData )
+{
+    return (pucData[0] == 0xFF) && (pucData[1] == 0xD8) ;
+}
+
+/**
+ * \brief Decodes the splash image from the internal flash or, if there is none,
+ * from the DataFlash, without copying it to RAM.
+ *
+ * \return 0 if a splash image was displayed, 1 otherwise.
+ */
+static uint32_t ShowSplashImage( void )
+{
+    struct jpeg_decompress_struct cinfo ;
+    SErrorManager jerr ;
+    const uint8_t* pucIFlash = (const uint8_t*)SPLASH_IFLASH_ADDR ;
+    uint8_t aucSoi[2] ;
+    bool bDataflash ;
+    uint32_t dwSize = 0 ;
+    uint32_t dwResult ;
+
+    if ( IsJpegData( pucIFlash ) )
+    {
+        bDataflash = false ;
+    }
+    else if ( DataflashInitialize() )
+    {
+        AT45D_Read( &at45, aucSoi, sizeof( aucSoi ), SPLASH_AT45_ADDRESS ) ;
+        if ( !IsJpegData( aucSoi ) )
+        {
+            return 1 ;
+        }
+        bDataflash = true ;
+        dwSize = AT45_PageNumber( &at45 ) * AT45_PageSize( &at45 ) - SPLASH_AT45_ADDRESS ;
+    }
+    else
+    {
+        return 1 ;
+    }
+
+    cinfo.err = jpeg_std_error( &jerr.pub ) ;
+    jerr.pub.error_exit = ErrorManager_Exit ;
+    if ( setjmp( jerr.jmpBuffer ) )
+    {
+        /* The chunk read started ahead must be over before leaving */
+        if ( bDataflash )
+        {
+            DataflashReader_Wait( &dataflashReader.pub ) ;
+        }
+        LCD_SetWindow( 0, 0, BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT ) ;
+        jpeg_destroy_decompress( &cinfo ) ;
+        return 1 ;
+    }
+
+    jpeg_create_decompress( &cinfo ) ;
+
+    /* The decoding stops at the EOI marker, whatever the size given */
+    if ( bDataflash )
+    {
+        jpeg_chunk_src( &cinfo, &dataflashReader.pub, SPLASH_AT45_ADDRESS, dwSize,
+                        aucSplashBuffer, sizeof( aucSplashBuffer ) ) ;
+        dwResult = DecodeToLcd( &cinfo, "DataFlash splash" ) ;
+        DataflashReader_Wait( &dataflashReader.pub ) ;
+    }
+    else
+    {
+        jpeg_mem_src( &cinfo, pucIFlash, SPLASH_IFLASH_SIZE ) ;
+        dwResult = DecodeToLcd( &cinfo, "Flash splash" ) ;
+    }
+
+    jpeg_destroy_decompress( &cinfo ) ;
+
+    return dwResult ;
+}
+
+/**
+ * \brief Decodes a JPEG file with each IDCT method and each scaling, and
+ * prints the decoding time in core cycles per MCU.
+ *
+ * The pixels are sent to a dummy data port, so the time covers the whole
+ * decoding (file reading, entropy decoding, IDCT, upsampling and color
+ * conversion) without the LCD transfers.
+ *
+ * \param pszName  File name.
+ */
+static void BenchmarkJpegFile( const char* pszName )
+{
+    struct jpeg_decompress_struct cinfo ;
+    SErrorManager jerr ;
+    JSAMPROW pDummyRow = NULL ;
+    uint32_t dwMethod ;
+    uint32_t dwScale ;
+    uint32_t dwStart ;
+    uint32_t dwElapsed ;
+    uint32_t dwMCUs ;
+
+    if ( f_open( &jpegFile, pszName, FA_OPEN_EXISTING|FA_READ ) != FR_OK )
+    {
+        return ;
+    }
+
+    cinfo.err = jpeg_std_error( &jerr.pub ) ;
+    jerr.pub.error_exit = ErrorManager_Exit ;
+    if ( setjmp( jerr.jmpBuffer ) )
+    {
+        jpeg_destroy_decompress( &cinfo ) ;
+        f_close( &jpegFile ) ;
+        return ;
+    }
+
+    jpeg_create_decompress( &cinfo ) ;
+
+    for ( dwMethod = 0 ; dwMethod < BENCH_METHODS ; dwMethod++ )
+    {
+        for ( dwScale = 1 ; dwScale <= 8 ; dwScale *= 2 )
+        {
+            f_lseek( &jpegFile, 0 ) ;
+            FileSource_Attach( &cinfo, &jpegFile ) ;
+
+            dwStart = GetTickCount() ;
+            jpeg_read_header( &cinfo, TRUE ) ;
+            cinfo.out_color_space = JCS_RGB ;
+            cinfo.do_fancy_upsampling = TRUE ;
+            cinfo.dct_method = benchMethods[dwMethod] ;
+            cinfo.scale_num = 1 ;
+            cinfo.scale_denom = dwScale ;
+            jpeg_start_decompress( &cinfo ) ;
+
+            if ( (dwMethod == 0) && (dwScale == 1) )
+            {
+                printf( "-I- Benchmark of %s, %ux%u\n\r", pszName,
+                        (unsigned int)cinfo.image_width, (unsigned int)cinfo.image_height ) ;
+            }
+            dwMCUs = cinfo.MCUs_per_row * cinfo.MCU_rows_in_scan ;
+
+            jpeg_set_output_port( &cinfo, &benchPort ) ;
+            while ( cinfo.output_scanline < cinfo.output_height )
+            {
+                jpeg_read_scanlines( &cinfo, &pDummyRow, 1 ) ;
+            }
+            jpeg_finish_decompress( &cinfo ) ;
+            dwElapsed = GetTickCount() - dwStart ;
+
+            printf( "-I- %s 1/%u: %u ms, %u cycles per MCU\n\r", benchNames[dwMethod], (unsigned int)dwScale,
+                    (unsigned int)dwElapsed, (unsigned int)(dwElapsed * (BOARD_MCK / 1000) / dwMCUs) ) ;
+        }
+    }
+
+    jpeg_destroy_decompress( &cinfo ) ;
+    f_close( &jpegFile ) ;
+}
+
+/**
+ * \brief Finds the first JPEG file of the root directory.
+ *
+ * \param pszName  Buffer receiving the file name.
+ * \param dwSize   Size of the buffer.
+ *
+ * \return true if a file was found.
+ */
+static bool FindFirstJpegFile( char* pszName, uint32_t dwSize )
+{
+    FILINFO fno ;
+    DIR dir ;
+    char* pszFound ;
+#if _USE_LFN
+    static char lfn[_MAX_LFN * (_DF1S ? 2 : 1) + 1] ;
+    fno.lfname = lfn ;
+    fno.lfsize = sizeof( lfn ) ;
+#endif
+
+    if ( f_opendir( &dir, STR_ROOT_DIRECTORY ) != FR_OK )
+    {
+        return false ;
+    }
+
+    while ( (f_readdir( &dir, &fno ) == FR_OK) && (fno.fname[0] != 0) )
+    {
+#if _USE_LFN
+        pszFound = *fno.lfname ? fno.lfname : fno.fname ;
+#else
+        pszFound = fno.fname ;
+#endif
+        if ( !(fno.fattrib & AM_DIR) && IsJpegFile( pszFound ) && (strlen( pszFound ) < dwSize) )
+        {
+            strcpy( pszName, pszFound ) ;
+            return true ;
+        }
+    }
+
+    return false ;
+}
+
+/**
+ * \brief Shows all the JPEG files of the root directory once.
+ *
+ * \return Number of images displayed.
+ */
+static uint32_t ShowAllJpegFiles( void )
+{
+    FILINFO fno ;
+    DIR dir ;
+    char* pszName ;
+    uint32_t dwCount = 0 ;
+#if _USE_LFN
+    static char lfn[_MAX_LFN * (_DF1S ? 2 : 1) + 1] ;
+    fno.lfname = lfn ;
+    fno.lfsize = sizeof( lfn ) ;
+#endif
+
+    if ( f_opendir( &dir, STR_ROOT_DIRECTORY ) != FR_OK )
+    {
+        printf( "-E- No file system on the disk\n\r" ) ;
+        return 0 ;
+    }
+
+    for ( ; ; )
+    {
+        if ( (f_readdir( &dir, &fno ) != FR_OK) || (fno.fname[0] == 0) )
+        {
+            break ;
+        }
+#if _USE_LFN
+        pszName = *fno.lfname ? fno.lfname : fno.fname ;
+#else
+        pszName = fno.fname ;
+#endif
+        if ( (fno.fattrib & AM_DIR) || !IsJpegFile( pszName ) )
+        {
+            continue ;
+        }
+
+        if ( ShowJpegFile( pszName ) == 0 )
+        {
+            dwCount++ ;
+            Wait( DISPLAY_DELAY ) ;
+        }
+    }
+
+    return dwCount ;
+}
+
+/*----------------------------------------------------------------------------
+ *         Global functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Application entry point for jpeg_lcd example.
+ *
+ * \return Unused (ANSI-C compatibility).
+ */
+extern int main( void )
+{
+    static char szBenchFile[_MAX_LFN + 1] ;
+
+    /* Disable watchdog */
+    WDT_Disable( WDT ) ;
+
+    /* Output example information */
+    printf( "-- JPEG_LCD Example %s --\n\r", SOFTPACK_VERSION ) ;
+    printf( "-- %s\n\r", BOARD_NAME ) ;
+    printf( "-- Compiled: %s %s --\n\r", __DATE__, __TIME__ ) ;
+
+    /* Configure systick for 1 ms. */
+    if ( TimeTick_Configure( BOARD_MCK ) != 0 )
+    {
+        printf( "-F- Systick configuration error\n\r" ) ;
+    }
+
+    /* Initialize LCD */
+    LCDD_Initialize() ;
+    LCDD_Fill( COLOR_BLACK ) ;
+    LCDD_On() ;
+
+    /* Show the splash image, if any, straight from where it is stored */
+    if ( ShowSplashImage() == 0 )
+    {
+        Wait( DISPLAY_DELAY ) ;
+    }
+
+    /* Init NandFlash Disk and mount it */
+    if ( !NandFlashInitialize() )
+    {
+        printf( "-F- NF Init FAIL\n\r" ) ;
+        return 0 ;
+    }
+
+    memset( &fs, 0, sizeof( FATFS ) ) ;
+    if ( f_mount( 0, &fs ) != FR_OK )
+    {
+        printf( "-F- f_mount pb\n\r" ) ;
+        return 0 ;
+    }
+
+    /* Compare the IDCT methods on the first image */
+    if ( FindFirstJpegFile( szBenchFile, sizeof( szBenchFile ) ) )
+    {
+        BenchmarkJpegFile( szBenchFile ) ;
+    }
+
+    /* Show the images forever */
+    while ( ShowAllJpegFiles() != 0 )
+    {
+    }
+
+    printf( "-F- No JPEG file found in the root directory\n\r" ) ;
+    LCDD_DrawString( 30, 150, (uint8_t *)"No JPEG file found", COLOR_WHITE ) ;
+
+    return 0 ;
+}
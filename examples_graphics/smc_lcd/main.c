@@ -68,6 +68,8 @@
  *     -- SMC_LCD Example xxx --
  *     -- xxxxxx-xx
  *     -- Compiled: xxx xx xxxx xx:xx:xx --
+ *     -I- Full screen fill: xx ms
+ *     -I- 100x50 image draw: xx ms
  *    \endcode
  * -# Some text, image and basic shapes should be displayed on the LCD.
  *
@@ -108,13 +110,15 @@
 #define N_BLK_HOR       5
 /** Number of color block in vertical direction of test image */
 #define N_BLK_VERT      4
+/** Number of iterations of each benchmark pass. */
+#define BENCH_LOOPS     10
 
 /*----------------------------------------------------------------------------
  *        Local variables
  *----------------------------------------------------------------------------*/
 
 /** Image buffer. */
-uint8_t gImageBuffer[IMAGE_HEIGHT * IMAGE_WIDTH * 3];
+BOARD_NOINIT_SECTION uint8_t gImageBuffer[IMAGE_HEIGHT * IMAGE_WIDTH * 3];
 
 /** Color pattern for make image. */
 const uint32_t gColorPattern[N_BLK_HOR*N_BLK_VERT] = {
@@ -168,6 +172,34 @@ static void MakeTestImage( uint8_t *pBuffer )
     }
 }
 
+/**
+ * \brief Measure the time taken by full screen fills and test image draws, and
+ * print the results on the console.
+ */
+static void Benchmark( void )
+{
+    uint32_t dwStart ;
+    uint32_t dwElapsed ;
+    uint32_t i ;
+
+    dwStart = GetTickCount() ;
+    for ( i = 0 ; i < BENCH_LOOPS ; i++ )
+    {
+        LCDD_Fill( (i & 1) ? COLOR_BLACK : COLOR_WHITE ) ;
+    }
+    dwElapsed = GetTickCount() - dwStart ;
+    printf( "-I- Full screen fill: %u ms\n\r", (unsigned int)(dwElapsed / BENCH_LOOPS) ) ;
+
+    dwStart = GetTickCount() ;
+    for ( i = 0 ; i < BENCH_LOOPS ; i++ )
+    {
+        LCDD_DrawImage( 60, 60, (const uint8_t *)gImageBuffer, IMAGE_WIDTH, IMAGE_HEIGHT ) ;
+    }
+    dwElapsed = GetTickCount() - dwStart ;
+    printf( "-I- %ux%u image draw: %u ms\n\r", IMAGE_WIDTH, IMAGE_HEIGHT,
+            (unsigned int)(dwElapsed / BENCH_LOOPS) ) ;
+}
+
 /*----------------------------------------------------------------------------
  *         Global functions
  *----------------------------------------------------------------------------*/
@@ -200,10 +232,14 @@ extern int main( void )
     /* Turn on LCD */
     LCDD_On() ;
 
+    /* Measure the drawing speed, then clear the screen */
+    MakeTestImage(gImageBuffer);
+    Benchmark() ;
+    LCDD_Fill( COLOR_WHITE ) ;
+
     /* Draw text, image and basic shapes on the LCD */
     LCDD_DrawString( 30, 20, (uint8_t *)"smc_lcd example", COLOR_BLACK ) ;
 
-    MakeTestImage(gImageBuffer);
     LCDD_DrawImage(60, 60, (const uint8_t *)gImageBuffer, IMAGE_WIDTH, IMAGE_HEIGHT);
 
     LCDD_DrawCircle(60,  160, 40, COLOR_RED);
@@ -0,0 +1,713 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page media_bench Media Benchmark Example
+ *
+ * \section Purpose
+ *
+ * The Media Benchmark Example measures the storage media through the
+ * generic Media interface (MED_Read() / MED_Write()), so that the SD card,
+ * the NandFlash translation layer, the NorFlash, the PSRAM RAM disk and a
+ * sector cache can be compared with the same patterns, and that a change in
+ * a media driver shows up as throughput and latency figures.
+ *
+ * \section Description
+ *
+ * Each initialized media runs sequential read, sequential write, random read
+ * and random write patterns, at transfer sizes of 512 bytes, 4 KB and 32 KB,
+ * in the first BENCH_AREA_SIZE bytes of the media. A run stops after
+ * BENCH_RUN_MS of media time or BENCH_MAX_OPS transfers. The write runs end
+ * with MED_Flush(), whose time is part of the throughput.
+ *
+ * For each run the console shows the throughput (KB/s), the transfers per
+ * second (IOPS), the minimum, average and maximum latencies, and a histogram
+ * of the latencies with power-of-two buckets (in microseconds). The times are
+ * measured with the DWT cycle counter.
+ *
+ * The medias of the SAM3S-EK are:
+ * - the SD card on the HSMCI through MEDSdasync, the queued SD media,
+ * - the NandFlash through MEDNandFlash and TranslatedNandFlash,
+ * - the same NandFlash behind a MEDCache sector cache,
+ * - the NorFlash, read only (its sectors must be erased before writing),
+ * - a RAM disk in the PSRAM left free (MEDRamDisk).
+ * The missing ones are skipped.
+ *
+ * \warning The write runs destroy the data of the tested area, the console
+ * asks before running them.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it inside the evaluation board. Please
+ *    refer to the
+ *    <a href="http://www.atmel.com/dyn/resources/prod_documents/doc6224.pdf">
+ *    SAM-BA User Guide</a>, the
+ *    <a href="http://www.atmel.com/dyn/resources/prod_documents/doc6310.pdf">
+ *    GNU-Based Software Development</a> application note or to the
+ *    <a href="ftp://ftp.iar.se/WWWfiles/arm/Guides/EWARM_UserGuide.ENU.pdf">
+ *    IAR EWARM User Guide</a>, depending on your chosen solution.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 bauds
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application.
+ * -# In the terminal window, the following text should appear:
+ *     \code
+ *     -- Media Benchmark Example xxx --
+ *     -- xxxxxx-xx
+ *     -- Compiled: xxx xx xxxx xx:xx:xx --
+ *     \endcode
+ * -# Answer 'y' to run the write patterns, then one table is printed per
+ *    media, followed by its MED_IOCTL_STATS report: operation counts, latency
+ *    histograms, queue depth and busy time, and the NAND layer counters for
+ *    the NandFlash medias.
+ */
+
+/**
+ * \file
+ *
+ * This file contains all the specific code for the
+ * media_bench example.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "board.h"
+#include "memories.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Maximum number of medias. */
+#define MAX_MEDS            5
+
+/** Size of one block in bytes. */
+#define BLOCK_SIZE          512
+
+/** Size of the tested area at the start of each media. */
+#define BENCH_AREA_SIZE     (4*1024*1024)
+
+/** Media time of a run, in ms. */
+#define BENCH_RUN_MS        1000
+
+/** Maximum number of transfers of a run. */
+#define BENCH_MAX_OPS       2048
+
+/** Largest transfer, in bytes. */
+#define BENCH_MAX_TRANSFER  (32*1024)
+
+/** Number of latency histogram buckets: bucket n counts the latencies of
+    2^(n+4) to 2^(n+5)-1 us, the first and last buckets extend down and up. */
+#define BENCH_NUM_BUCKETS   12
+#define BENCH_BUCKET_SHIFT  4
+
+/** Run patterns. */
+#define PATTERN_SEQREAD     0
+#define PATTERN_SEQWRITE    1
+#define PATTERN_RANDREAD    2
+#define PATTERN_RANDWRITE   3
+
+/** Size of the managed NandFlash (16M). */
+#define NF_MANAGED_SIZE     (16*1024*1024)
+
+/** Core cycles per microsecond. */
+#define CYCLES_PER_US       (BOARD_MCK / 1000000)
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Results of a run. */
+typedef struct _BenchRun {
+
+    /** Transfers done. */
+    uint32_t dwOps;
+    /** Transfers failed. */
+    uint32_t dwErrors;
+    /** Bytes moved. */
+    uint32_t dwBytes;
+    /** Total media time, in cycles (flush included). */
+    uint64_t qwCycles;
+    /** Shortest and longest transfers, in cycles. */
+    uint32_t dwMinCycles;
+    uint32_t dwMaxCycles;
+    /** Latency histogram. */
+    uint32_t adwBuckets[BENCH_NUM_BUCKETS];
+
+} BenchRun;
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Available medias and their names. */
+static Media medias[MAX_MEDS];
+static const char *mediaNames[MAX_MEDS];
+static uint32_t numBenchMedias = 0;
+
+/** Statistics attached to each media. */
+static MEDStats mediaStats[MAX_MEDS];
+
+/** Transfer buffer. */
+static uint8_t benchBuffer[BENCH_MAX_TRANSFER] __attribute__ ((aligned (4)));
+
+/** Transfer sizes, in bytes. */
+static const uint32_t benchSizes[] = {512, 4*1024, 32*1024};
+
+/** Pattern names. */
+static const char *patternNames[] = {"seq read", "seq write", "rand read", "rand write"};
+
+/** Completion flag of the current transfer, and its status. */
+static volatile uint8_t xferDone;
+static volatile uint8_t xferStatus;
+
+/** Pseudo-random generator state. */
+static uint32_t randomState = 1;
+
+/** Pins used to access to nandflash. */
+static const Pin pPinsNf[] = {PINS_NANDFLASH};
+/** Nandflash device structure. */
+static struct TranslatedNandFlash translatedNf;
+/** Nandflash chip enable pin. */
+static const Pin nfCePin = BOARD_NF_CE_PIN;
+/** Nandflash ready/busy pin. */
+static const Pin nfRbPin = BOARD_NF_RB_PIN;
+
+/** Sector cache over the NandFlash media, and its lines. */
+static MEDCache nfCache;
+static uint8_t nfCacheBuffer[MEDCACHE_LINES*BLOCK_SIZE];
+
+/** Norflash device structure. */
+static NorFlash norFlash;
+#ifdef PINS_NORFLASH
+/** Pins used to access to the norflash. */
+static const Pin pPinsNor[] = {PINS_NORFLASH};
+#endif
+
+/** Pins used to access to the PSRAM. */
+static const Pin pPinsPsram[] = {PIN_EBI_DATA_BUS, PIN_EBI_NRD, PIN_EBI_NWE,
+                                 PIN_EBI_NCS1, PIN_EBI_PSRAM_ADDR_BUS,
+                                 PIN_EBI_PSRAM_NBS};
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Returns the next value of the pseudo-random generator.
+ */
+static uint32_t _Random(void)
+{
+    randomState = randomState * 1103515245 + 12345;
+    return randomState >> 8;
+}
+
+/**
+ * \brief Completion callback of the benchmark transfers.
+ */
+static void _XferCallback(void *pArg, uint8_t bStatus, uint32_t dwTransferred, uint32_t dwRemaining)
+{
+    xferStatus = bStatus;
+    xferDone = 1;
+}
+
+/**
+ * \brief Adds a media to the benchmark list.
+ */
+static Media* _AddMedia(const char *pName)
+{
+    if (numBenchMedias >= MAX_MEDS) {
+
+        return 0;
+    }
+    mediaNames[numBenchMedias] = pName;
+    return &medias[numBenchMedias++];
+}
+
+/*----------------------------------------------------------------------------
+ *        SD card media
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initializes the SD card media, if a card is inserted. MEDSdasync
+ * configures the pins and the drivers, and owns the HSMCI interrupt.
+ */
+static void _SdInitialize(void)
+{
+    Media *pMedia;
+
+    if (!MEDSdcard_Detect(0, 0)) {
+
+        printf("-I- No SD card\n\r");
+        return;
+    }
+
+    pMedia = _AddMedia("SD card");
+    if (pMedia && !MEDSdasync_Initialize(pMedia, 0)) {
+
+        printf("-E- SD card initialization failed\n\r");
+        numBenchMedias--;
+    }
+}
+
+/*----------------------------------------------------------------------------
+ *        NorFlash media (read only)
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Reads blocks of the NorFlash (Media_read).
+ */
+static uint8_t _NorRead(Media *pMedia, uint32_t dwAddress, void *pData, uint32_t dwLength,
+                        MediaCallback fCallback, void *pArg)
+{
+    uint8_t bStatus;
+
+    bStatus = NORFLASH_ReadData((NorFlash*)pMedia->interface, dwAddress * pMedia->blockSize,
+                                (uint8_t*)pData, dwLength * pMedia->blockSize)
+              ? MED_STATUS_ERROR : MED_STATUS_SUCCESS;
+    if (fCallback) {
+
+        fCallback(pArg, bStatus, dwLength * pMedia->blockSize, 0);
+    }
+    return bStatus;
+}
+
+/**
+ * \brief Detects the NorFlash and initializes its media.
+ */
+static void _NorInitialize(void)
+{
+    Media *pMedia;
+
+#ifdef PINS_NORFLASH
+    PIO_Configure(pPinsNor, PIO_LISTSIZE(pPinsNor));
+#endif
+    norFlash.norFlashInfo.baseAddress = BOARD_NORFLASH_ADDR;
+    BOARD_ConfigureNorFlash(SMC);
+    NorFlash_CFI_Detect(&norFlash, FLASH_CHIP_WIDTH_8BITS);
+    if (norFlash.norFlashInfo.cfiCompatible == 0) {
+
+        printf("-I- No NorFlash\n\r");
+        return;
+    }
+
+    pMedia = _AddMedia("NorFlash");
+    memset(pMedia, 0, sizeof(Media));
+    pMedia->interface = &norFlash;
+    pMedia->read = _NorRead;
+    pMedia->blockSize = BLOCK_SIZE;
+    pMedia->size = NorFlash_GetDeviceSizeInBytes(&(norFlash.norFlashInfo)) / BLOCK_SIZE;
+    pMedia->protected = 1;
+    pMedia->state = MED_STATE_READY;
+}
+
+/*----------------------------------------------------------------------------
+ *        NandFlash and RAM disk medias
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initializes the NandFlash media, and a cached media over it.
+ */
+static void _NandFlashInitialize(void)
+{
+    struct RawNandFlash *pRaw = (struct RawNandFlash*)&translatedNf;
+    struct NandFlashModel *pModel = (struct NandFlashModel*)&translatedNf;
+    Media *pMedia;
+    Media *pCached;
+    uint32_t dwBlocks;
+
+    BOARD_ConfigureNandFlash(SMC);
+    PIO_Configure(pPinsNf, PIO_LISTSIZE(pPinsNf));
+
+    if (RawNandFlash_Initialize(pRaw, 0, BOARD_NF_COMMAND_ADDR, BOARD_NF_ADDRESS_ADDR,
+                                BOARD_NF_DATA_ADDR, nfCePin, nfRbPin)) {
+
+        printf("-I- No NandFlash\n\r");
+        return;
+    }
+    dwBlocks = NF_MANAGED_SIZE / NandFlashModel_GetBlockSizeInBytes(pModel);
+    if (dwBlocks > NandFlashModel_GetDeviceSizeInBlocks(pModel)) {
+
+        dwBlocks = NandFlashModel_GetDeviceSizeInBlocks(pModel);
+    }
+    if (TranslatedNandFlash_Initialize(&translatedNf, 0, BOARD_NF_COMMAND_ADDR,
+                                       BOARD_NF_ADDRESS_ADDR, BOARD_NF_DATA_ADDR,
+                                       nfCePin, nfRbPin, 0, dwBlocks)) {
+
+        printf("-E- NandFlash initialization failed\n\r");
+        return;
+    }
+
+    pMedia = _AddMedia("NandFlash");
+    MEDNandFlash_Initialize(pMedia, &translatedNf);
+    RawNandFlash_ConfigureReadyInterrupt(pRaw);
+
+    pCached = _AddMedia("NandFlash+cache");
+    if (pCached && !MEDCache_Initialize(pCached, &nfCache, pMedia, nfCacheBuffer)) {
+
+        numBenchMedias--;
+    }
+}
+
+/**
+ * \brief Initializes a RAM disk in the PSRAM left after the allocations.
+ */
+static void _RamDiskInitialize(void)
+{
+    Media *pMedia;
+    uint32_t dwSize;
+    uint32_t dwSkip;
+    uint8_t *pDisk;
+
+    PIO_Configure(pPinsPsram, PIO_LISTSIZE(pPinsPsram));
+    BOARD_ConfigurePSRAM(SMC);
+
+    dwSize = BOARD_PsramGetFreeSize();
+    pDisk = (uint8_t*)BOARD_PsramAlloc(dwSize);
+    if (pDisk == 0) {
+
+        printf("-I- No PSRAM\n\r");
+        return;
+    }
+
+    /* The disk address is given in blocks */
+    dwSkip = (BLOCK_SIZE - (uint32_t)pDisk % BLOCK_SIZE) % BLOCK_SIZE;
+    pDisk += dwSkip;
+    dwSize -= dwSkip;
+    pMedia = _AddMedia("PSRAM disk");
+    if (pMedia && !MEDRamDisk_Initialize(pMedia, BLOCK_SIZE, (uint32_t)pDisk / BLOCK_SIZE,
+                                         dwSize / BLOCK_SIZE)) {
+
+        numBenchMedias--;
+    }
+}
+
+/*----------------------------------------------------------------------------
+ *        Benchmark
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Runs one transfer and waits for its end.
+ *
+ * \return the media status.
+ */
+static uint8_t _Transfer(Media *pMedia, uint8_t bWrite, uint32_t dwAddress, uint32_t dwLength)
+{
+    uint32_t dwRc;
+
+    xferDone = 0;
+    xferStatus = MED_STATUS_SUCCESS;
+    if (bWrite) {
+
+        dwRc = MED_Write(pMedia, dwAddress, benchBuffer, dwLength, _XferCallback, 0);
+    }
+    else {
+
+        dwRc = MED_Read(pMedia, dwAddress, benchBuffer, dwLength, _XferCallback, 0);
+    }
+    if (dwRc != MED_STATUS_SUCCESS) {
+
+        return MED_STATUS_ERROR;
+    }
+    while (!xferDone) {
+
+        MED_Handler(pMedia);
+    }
+
+    return xferStatus;
+}
+
+/**
+ * \brief Runs a pattern at a transfer size on a media.
+ */
+static void _Run(Media *pMedia, uint8_t bPattern, uint32_t dwSize, BenchRun *pRun)
+{
+    uint8_t bWrite = (bPattern == PATTERN_SEQWRITE) || (bPattern == PATTERN_RANDWRITE);
+    uint8_t bRandom = (bPattern == PATTERN_RANDREAD) || (bPattern == PATTERN_RANDWRITE);
+    uint32_t dwLength = dwSize / pMedia->blockSize;
+    uint32_t dwArea = BENCH_AREA_SIZE / pMedia->blockSize;
+    uint64_t qwBudget = (uint64_t)BOARD_MCK * BENCH_RUN_MS / 1000;
+    uint32_t dwAddress = 0;
+    uint32_t dwStart;
+    uint32_t dwCycles;
+    uint32_t dwUs;
+    uint32_t i;
+
+    memset(pRun, 0, sizeof(BenchRun));
+    pRun->dwMinCycles = 0xFFFFFFFF;
+    if (dwArea > pMedia->size) {
+
+        dwArea = pMedia->size;
+    }
+
+    while ((pRun->dwOps < BENCH_MAX_OPS) && (pRun->qwCycles < qwBudget)) {
+
+        if (bRandom) {
+
+            dwAddress = (_Random() % (dwArea / dwLength)) * dwLength;
+        }
+        else if (dwAddress + dwLength > dwArea) {
+
+            dwAddress = 0;
+        }
+
+        dwStart = DWT_CYCCNT;
+        if (_Transfer(pMedia, bWrite, dwAddress, dwLength) != MED_STATUS_SUCCESS) {
+
+            pRun->dwErrors++;
+        }
+        dwCycles = DWT_CYCCNT - dwStart;
+
+        pRun->dwOps++;
+        pRun->dwBytes += dwSize;
+        pRun->qwCycles += dwCycles;
+        if (dwCycles < pRun->dwMinCycles) pRun->dwMinCycles = dwCycles;
+        if (dwCycles > pRun->dwMaxCycles) pRun->dwMaxCycles = dwCycles;
+        dwUs = (dwCycles / CYCLES_PER_US) >> BENCH_BUCKET_SHIFT;
+        for (i = 0; (dwUs > 1) && (i < BENCH_NUM_BUCKETS - 1); i++) {
+
+            dwUs >>= 1;
+        }
+        pRun->adwBuckets[i]++;
+
+        if (!bRandom) {
+
+            dwAddress += dwLength;
+        }
+    }
+
+    /* The data left in the write buffers is part of the run */
+    if (bWrite) {
+
+        dwStart = DWT_CYCCNT;
+        MED_Flush(pMedia);
+        pRun->qwCycles += DWT_CYCCNT - dwStart;
+    }
+}
+
+/**
+ * \brief Prints the results of a run.
+ */
+static void _PrintRun(uint8_t bPattern, uint32_t dwSize, const BenchRun *pRun)
+{
+    uint32_t dwUs = (uint32_t)(pRun->qwCycles / CYCLES_PER_US);
+    uint32_t dwKBps;
+    uint32_t dwIops;
+    uint32_t i;
+
+    if (dwUs == 0) {
+
+        dwUs = 1;
+    }
+    dwKBps = (uint32_t)(((uint64_t)pRun->dwBytes * 1000000 / 1024) / dwUs);
+    dwIops = (uint32_t)((uint64_t)pRun->dwOps * 1000000 / dwUs);
+
+    printf("  %-10s %6uB %6u KB/s %6u IOPS  lat %u/%u/%u us",
+           patternNames[bPattern], (unsigned int)dwSize,
+           (unsigned int)dwKBps, (unsigned int)dwIops,
+           (unsigned int)(pRun->dwMinCycles / CYCLES_PER_US),
+           (unsigned int)(dwUs / pRun->dwOps),
+           (unsigned int)(pRun->dwMaxCycles / CYCLES_PER_US));
+    if (pRun->dwErrors) {
+
+        printf("  %u errors", (unsigned int)pRun->dwErrors);
+    }
+    printf("\n\r    hist");
+    for (i = 0; i < BENCH_NUM_BUCKETS; i++) {
+
+        if (pRun->adwBuckets[i]) {
+
+            printf(" <%u:%u", (unsigned int)(1u << (i + BENCH_BUCKET_SHIFT + 1)),
+                   (unsigned int)pRun->adwBuckets[i]);
+        }
+    }
+    printf("\n\r");
+}
+
+/**
+ * \brief Prints the counters and latency histogram of an operation.
+ */
+static void _PrintOpStats(const char *pName, const MEDOpStats *pOp)
+{
+    uint32_t dwAvg = 0;
+    uint32_t i;
+
+    if (pOp->timed) {
+
+        dwAvg = (uint32_t)(pOp->totalLatency / pOp->timed);
+    }
+    printf("%-6s %8u %8u %10u %8u %8u\n\r", pName, (unsigned int)pOp->count, (unsigned int)pOp->errors,
+           (unsigned int)(pOp->bytes >> 10), (unsigned int)dwAvg, (unsigned int)pOp->maxLatency);
+
+    for (i = 0; i < MED_STATS_BUCKETS; i++) {
+
+        if (pOp->histogram[i]) {
+
+            printf("  <%uus: %u\n\r", 2u << i, (unsigned int)pOp->histogram[i]);
+        }
+    }
+}
+
+/**
+ * \brief Prints the statistics of a media read with MED_IOCTL_STATS,
+ * followed by the NAND counters when the media serves MED_IOCTL_NANDSTATS.
+ */
+static void _PrintMediaStats(Media *pMedia)
+{
+    MEDStats stats;
+    struct NandStats nand;
+    uint32_t dwElapsed;
+    uint32_t dwBusy;
+
+    if (MED_Ioctl(pMedia, MED_IOCTL_STATS, &stats) != MED_STATUS_SUCCESS) {
+
+        printf("-I- No statistics attached\n\r");
+        return;
+    }
+
+    printf("%-6s %8s %8s %10s %8s %8s\n\r", "op", "count", "errors", "KB", "avg(us)", "max(us)");
+    _PrintOpStats("read", &stats.read);
+    _PrintOpStats("write", &stats.write);
+    _PrintOpStats("flush", &stats.flush);
+
+    dwElapsed = (uint32_t)(stats.elapsedCycles / stats.cyclesPerUs / 1000);
+    dwBusy = (uint32_t)(stats.busyCycles / stats.cyclesPerUs / 1000);
+    printf("depth max %u avg %u.%02u, busy %u/%u ms (%u%%)\n\r", (unsigned int)stats.maxDepth,
+           (unsigned int)(stats.tracked ? stats.depthSum / stats.tracked : 0),
+           (unsigned int)(stats.tracked ? (stats.depthSum * 100 / stats.tracked) % 100 : 0),
+           (unsigned int)dwBusy, (unsigned int)dwElapsed,
+           (unsigned int)(stats.elapsedCycles ? stats.busyCycles * 100 / stats.elapsedCycles : 0));
+
+    if (MED_Ioctl(pMedia, MED_IOCTL_NANDSTATS, &nand) == MED_STATUS_SUCCESS) {
+
+        printf("nand: %u page reads, %u page writes, %u ECC corrected, %u ECC failures\n\r",
+               (unsigned int)nand.pageReads, (unsigned int)nand.pageWrites,
+               (unsigned int)nand.eccCorrected, (unsigned int)nand.eccFailures);
+        printf("nand: %u block erases, %u page copies, %u block copies\n\r",
+               (unsigned int)nand.blockErases, (unsigned int)nand.pageCopies,
+               (unsigned int)nand.blockCopies);
+    }
+}
+
+/**
+ * \brief Runs all the patterns on a media.
+ */
+static void _BenchMedia(Media *pMedia, const char *pName, uint8_t bWrites)
+{
+    BenchRun run;
+    uint8_t bPattern;
+    uint32_t i;
+
+    printf("-I- %s: %u blocks of %u bytes\n\r", pName,
+           (unsigned int)pMedia->size, (unsigned int)pMedia->blockSize);
+
+    for (bPattern = PATTERN_SEQREAD; bPattern <= PATTERN_RANDWRITE; bPattern++) {
+
+        if (((bPattern == PATTERN_SEQWRITE) || (bPattern == PATTERN_RANDWRITE))
+            && (!bWrites || pMedia->protected || !pMedia->write)) {
+
+            continue;
+        }
+        for (i = 0; i < sizeof(benchSizes) / sizeof(benchSizes[0]); i++) {
+
+            if ((benchSizes[i] < pMedia->blockSize)
+                || (benchSizes[i] / pMedia->blockSize > pMedia->size)) {
+
+                continue;
+            }
+            _Run(pMedia, bPattern, benchSizes[i], &run);
+            _PrintRun(bPattern, benchSizes[i], &run);
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief media_bench Application entry point.
+ *
+ * \return Unused (ANSI-C compatibility).
+ */
+int main(void)
+{
+    uint8_t bWrites;
+    uint32_t i;
+
+    /* Disable watchdog */
+    WDT_Disable( WDT ) ;
+
+    /* Output example information */
+    printf("-- Media Benchmark Example %s --\n\r", SOFTPACK_VERSION);
+    printf("-- %s\n\r", BOARD_NAME);
+    printf("-- Compiled: %s %s --\n\r", __DATE__, __TIME__);
+
+    /* Start the cycle counter */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+
+    /* Initialize the medias */
+    _SdInitialize();
+    _NandFlashInitialize();
+    _NorInitialize();
+    _RamDiskInitialize();
+
+    printf("!! Run the write patterns (the first %uK of each media are lost)? (y/n):",
+           BENCH_AREA_SIZE / 1024);
+    bWrites = (UART_GetChar() == 'y');
+    printf("\n\r");
+
+    /* Fill the write buffer with a non-blank pattern */
+    for (i = 0; i < sizeof(benchBuffer); i++) {
+
+        benchBuffer[i] = (uint8_t)(i * 7 + (i >> 9));
+    }
+
+    for (i = 0; i < numBenchMedias; i++) {
+
+        MED_StatsAttach(&medias[i], &mediaStats[i], BOARD_MCK);
+        _BenchMedia(&medias[i], mediaNames[i], bWrites);
+        _PrintMediaStats(&medias[i]);
+        MED_StatsDetach(&medias[i]);
+    }
+    printf("-I- Done\n\r");
+
+    while (1);
+}
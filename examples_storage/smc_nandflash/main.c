@@ -49,6 +49,8 @@
  * <li> Prepare a buffer and calculate the ECC by software.</li>
  * <li> Write the buffer into a NAND flash page and store the ECC.</li>
  * <li> Read the page and check that ECC is correct.</li>
+ * <li> Measure the software ECC computation and verification time, for the
+ *      Hamming code and for the 4-bit and 8-bit BCH codes.</li>
  * </ul>
  * \section Usage
  *
@@ -125,6 +127,100 @@ static const Pin nfCePin = BOARD_NF_CE_PIN;
 /** Nandflash ready/busy pin.*/
 static const Pin nfRbPin = BOARD_NF_RB_PIN;
 
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Measures the software hamming ECC on a page buffer, and displays the
+ * number of core cycles needed per 256-byte chunk.
+ *
+ * \param pBuffer  Page buffer.
+ * \param size  Page size in bytes (multiple of 256).
+ */
+static void BenchmarkHamming( unsigned char *pBuffer, unsigned int size )
+{
+    unsigned char code[NandCommon_MAXSPAREECCBYTES] ;
+    unsigned int computeCycles, verifyCycles ;
+    unsigned int start ;
+
+    /* SysTick counts down from LOAD at the core clock, interrupt disabled*/
+    SysTick->LOAD = SysTick_LOAD_RELOAD_Msk ;
+    SysTick->VAL = 0 ;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk ;
+
+    start = SysTick->VAL ;
+    Hamming_Compute256x( pBuffer, size, code ) ;
+    computeCycles = (start - SysTick->VAL) & SysTick_LOAD_RELOAD_Msk ;
+
+    start = SysTick->VAL ;
+    Hamming_Verify256x( pBuffer, size, code ) ;
+    verifyCycles = (start - SysTick->VAL) & SysTick_LOAD_RELOAD_Msk ;
+
+    SysTick->CTRL = 0 ;
+
+    printf( "-I- Hamming ECC: compute %u, verify %u cycles per 256 bytes\n\r",
+            computeCycles / (size / 256), verifyCycles / (size / 256) ) ;
+}
+
+/**
+ * \brief Measures the software BCH ECC on a page buffer, and displays the
+ * number of core cycles needed per page to compute the code, to verify an
+ * error-free page and to correct the maximum number of bit errors in each
+ * 512-byte sector.
+ *
+ * \param pBuffer  Page buffer, restored on return.
+ * \param size  Page size in bytes (multiple of 512).
+ * \param strength  Number of bit errors corrected per 512 bytes.
+ */
+static void BenchmarkBch( unsigned char *pBuffer, unsigned int size, unsigned char strength )
+{
+    unsigned char code[NandCommon_MAXSPAREECCBYTES] ;
+    unsigned int computeCycles, verifyCycles, correctCycles ;
+    unsigned int start ;
+    unsigned int sector, bit ;
+    unsigned char error ;
+
+    if ( (size % Bch_SECTORSIZE) != 0 )
+    {
+        return ;
+    }
+
+    /* SysTick counts down from LOAD at the core clock, interrupt disabled*/
+    SysTick->LOAD = SysTick_LOAD_RELOAD_Msk ;
+    SysTick->VAL = 0 ;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk ;
+
+    /* First call computes the tables*/
+    Bch_Compute512x( pBuffer, size, strength, code ) ;
+
+    start = SysTick->VAL ;
+    Bch_Compute512x( pBuffer, size, strength, code ) ;
+    computeCycles = (start - SysTick->VAL) & SysTick_LOAD_RELOAD_Msk ;
+
+    start = SysTick->VAL ;
+    Bch_Verify512x( pBuffer, size, strength, code ) ;
+    verifyCycles = (start - SysTick->VAL) & SysTick_LOAD_RELOAD_Msk ;
+
+    /* strength bit errors, spread over each sector*/
+    for ( sector = 0 ; sector < size ; sector += Bch_SECTORSIZE )
+    {
+        for ( bit = 0 ; bit < strength ; bit++ )
+        {
+            pBuffer[sector + bit * (Bch_SECTORSIZE / strength)] ^= 1 << bit ;
+        }
+    }
+    start = SysTick->VAL ;
+    error = Bch_Verify512x( pBuffer, size, strength, code ) ;
+    correctCycles = (start - SysTick->VAL) & SysTick_LOAD_RELOAD_Msk ;
+
+    SysTick->CTRL = 0 ;
+
+    printf( "-I- %u-bit BCH ECC: compute %u, verify %u, correct %u cycles per page%s\n\r",
+            strength, computeCycles, verifyCycles, correctCycles,
+            (error == Bch_ERROR_CORRECTED) ? "" : " (correction failed)" ) ;
+}
+
 /*----------------------------------------------------------------------------
  *         Global functions
  *----------------------------------------------------------------------------*/
@@ -257,6 +353,10 @@ extern int main( void )
     printf("-I- Read data matches SRAM buffer.\n\r");
 
     printf("-I- Test passed.\n\r");
+
+    BenchmarkHamming( pageBuffer, pageSize ) ;
+    BenchmarkBch( pageBuffer, pageSize, 4 ) ;
+    BenchmarkBch( pageBuffer, pageSize, 8 ) ;
     return 0;
 }
 
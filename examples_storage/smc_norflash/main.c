@@ -104,6 +104,9 @@
 
 #define min( a, b ) (((a) < (b)) ? (a) : (b))
 
+/** NRD pulse of the accesses inside a page, in MCK cycles (page access time). */
+#define NORFLASH_PAGE_NRD_PULSE   4
+
 /*----------------------------------------------------------------------------
  *        Local variables
  *----------------------------------------------------------------------------*/
@@ -122,6 +125,37 @@ static const Pin pPins[] =
 /** Temporary buffer for unaligned read/write operations. */
 static uint8_t pBuffer[1024];
 
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Enables the SMC page mode on NCS3 when the device supports
+ * asynchronous page reads: the first access of a page uses the NCS pulse,
+ * the following ones the shorter NRD pulse.
+ */
+static void _ConfigurePageMode( void )
+{
+    uint32_t pageSize = NorFlash_GetPageReadSize( &(norFlash.norFlashInfo) ) ;
+    uint32_t mode ;
+
+    if ( pageSize < 4 )
+    {
+        return ;
+    }
+
+    if ( pageSize >= 32 )      mode = SMC_MODE_PS_32_BYTE ;
+    else if ( pageSize >= 16 ) mode = SMC_MODE_PS_16_BYTE ;
+    else if ( pageSize >= 8 )  mode = SMC_MODE_PS_8_BYTE ;
+    else                       mode = SMC_MODE_PS_4_BYTE ;
+
+    SMC->SMC_CS_NUMBER[3].SMC_PULSE = (SMC->SMC_CS_NUMBER[3].SMC_PULSE & ~SMC_PULSE_NRD_PULSE_Msk)
+                                    | SMC_PULSE_NRD_PULSE( NORFLASH_PAGE_NRD_PULSE ) ;
+    SMC->SMC_CS_NUMBER[3].SMC_MODE = (SMC->SMC_CS_NUMBER[3].SMC_MODE & ~SMC_MODE_PS_Msk)
+                                   | SMC_MODE_PMEN | mode ;
+    printf( "Page mode enabled, %u-byte pages\n\r", (unsigned int) pageSize ) ;
+}
+
 /*----------------------------------------------------------------------------
  *         Global functions
  *----------------------------------------------------------------------------*/
@@ -164,6 +198,11 @@ int main(void)
     }
 
     printf("CFI detected and driver initialized\n\r");
+    _ConfigurePageMode();
+    if (NorFlash_GetWriteBufferSize(&(norFlash.norFlashInfo))) {
+        printf("Buffered programming, %u bytes per command\n\r",
+               (unsigned int)NorFlash_GetWriteBufferSize(&(norFlash.norFlashInfo)));
+    }
     printf("manufactureID : 0x%08x, deviceID : 0x%08x\n\r",
             (unsigned int)NORFLASH_ReadManufactoryID(&norFlash),
             (unsigned int)NORFLASH_ReadDeviceID(&norFlash));
@@ -170,7 +170,8 @@ extern const USBDDriverDescriptors auddSpeakerPhoneDriverDescriptors;
  *         Internal variables
  *----------------------------------------------------------------------------*/
 
-/**  Data buffers for receiving audio frames from the USB host. */
+/**  Data buffers for receiving audio frames from the USB host, the USB
+     receives into them and the DAC plays them in place. */
 static uint8_t buffers[BUFFER_NUMBER][BUFFER_SIZE];
 /**  Number of samples stored in each data buffer. */
 static uint32_t bufferSizes[BUFFER_NUMBER];
@@ -178,8 +179,18 @@ static uint32_t bufferSizes[BUFFER_NUMBER];
 static uint32_t inBufferIndex = 0;
 /**  Next buffer which should be sent to the DAC. */
 static uint32_t outBufferIndex = 0;
+/**  Next buffer to give back to the USB once played. */
+static uint32_t releaseIndex = 0;
 /**  Number of buffers that can be sent to the DAC. */
 static volatile uint32_t numBuffersToSend = 0;
+/**  Number of buffers loaded in the DAC PDC. */
+static volatile uint32_t numBuffersPlaying = 0;
+/**  Buffer list information for the read frame list */
+static USBDTransferBuffer frmRxMbl[BUFFER_NUMBER];
+/**  Next slot of the read frame list to be filled. */
+static uint32_t rxSlot = 0;
+/**  Current state of the read frame list (all buffers given to USB). */
+static volatile uint8_t isRxQueued = 0;
 /**  Data buffers for mic */
 static uint8_t micBuffers[BUFFER_NUMBER_MIC][BUFFER_SIZE];
 /**  Number of samples in each buffer */
@@ -470,6 +481,27 @@ static void Adc2PcmTranslate( int16_t *pBuffer, uint32_t size, uint8_t  expandCh
     }
 }
 
+static void FrameReceived( void *pArg, uint8_t status );
+
+/**
+ * Gives played buffers back to the USB read frame list, in playing order.
+ * \param count Number of buffers to release.
+ */
+static void ReleaseBuffers( uint32_t count )
+{
+    while ( count -- )
+    {
+        if ( isRxQueued )
+        {
+            AUDDSpeakerPhoneDriver_Read( buffers[releaseIndex],
+                                         AUDDevice_BYTESPERFRAME,
+                                         (TransferCallback) FrameReceived,
+                                         0 ) ; // No optional argument
+        }
+        releaseIndex = (releaseIndex + 1) % BUFFER_NUMBER;
+    }
+}
+
 /**
  * Handles interrupts coming from the DACC.
  */
@@ -485,12 +517,19 @@ void DAC_IrqHandler( void )
         DACC_DisableIt(pDac, DACC_IDR_TXBUFE | DACC_IDR_ENDTX);
         pDac->DACC_PTCR = DACC_PTCR_TXTDIS;
         isDacActive = 0;
-        /* Reset playback index */
-        inBufferIndex = outBufferIndex = 0;
+        /* Give back played and pending buffers */
+        ReleaseBuffers(numBuffersPlaying + numBuffersToSend);
+        outBufferIndex = releaseIndex;
+        numBuffersPlaying = 0;
+        numBuffersToSend = 0;
     }
     else
         if (sr & DACC_ISR_ENDTX)
     {
+        /* Oldest buffer played */
+        ReleaseBuffers(1);
+        numBuffersPlaying --;
+
         if (numBuffersToSend)
         {
             /* Check the number of available buffers */
@@ -537,6 +576,7 @@ void DAC_IrqHandler( void )
                           AUDDevice_NUMCHANNELS);
             outBufferIndex = (outBufferIndex + 1) % BUFFER_NUMBER;
             numBuffersToSend --;
+            numBuffersPlaying ++;
         }
         else
         {
@@ -695,16 +735,19 @@ static void FrameSent( uint32_t unused, uint8_t status, uint32_t transferred, ui
 }
 
 /**
- *  Invoked when a frame has been received.
+ *  Invoked when a frame has been received in the next buffer of the read
+ *  frame list, or when the list is stopped.
  */
-static void FrameReceived( uint32_t unused, uint8_t status, uint32_t transferred, uint32_t remaining )
+static void FrameReceived( void *pArg, uint8_t status )
 {
     Dacc *pDac = DACC;
 
-    if (status == USBD_STATUS_SUCCESS)
+    if (status == USBD_STATUS_PARTIAL_DONE)
     {
         /* Update input status data */
-        bufferSizes[inBufferIndex] = transferred / AUDDevice_BYTESPERSAMPLE;
+        bufferSizes[inBufferIndex] = frmRxMbl[rxSlot].transferred
+                                        / AUDDevice_BYTESPERSAMPLE;
+        rxSlot = (rxSlot + 1) % BUFFER_NUMBER;
         inBufferIndex = (inBufferIndex + 1) % BUFFER_NUMBER;
         numBuffersToSend++;
 
@@ -739,6 +782,7 @@ static void FrameReceived( uint32_t unused, uint8_t status, uint32_t transferred
                                   AUDDevice_NUMCHANNELS);
                     outBufferIndex = (outBufferIndex + 1) % BUFFER_NUMBER;
                     numBuffersToSend --;
+                    numBuffersPlaying = 2;
 
                     DACC_EnableIt(pDac, DACC_IER_TXBUFE | DACC_IER_ENDTX);
                     pDac->DACC_PTCR = DACC_PTCR_TXTEN;
@@ -748,24 +792,9 @@ static void FrameReceived( uint32_t unused, uint8_t status, uint32_t transferred
     }
     else
     {
-        if (status == USBD_STATUS_ABORTED)
-        {
-            /* Error , ABORT, add NULL buffer */
-            bufferSizes[inBufferIndex] = 0;
-            inBufferIndex = (inBufferIndex + 1) % BUFFER_NUMBER;
-            numBuffersToSend++;
-        }
-        else
-        {
-            /* Packet is discarded */
-        }
+        /* List emptied or canceled, restarts from its first slot */
+        rxSlot = 0;
     }
-
-    /* Receive next packet */
-    AUDDSpeakerPhoneDriver_Read( buffers[inBufferIndex],
-                           AUDDevice_BYTESPERFRAME,
-                           (TransferCallback) FrameReceived,
-                           0); // No optional argument
 }
 
 /**
@@ -795,6 +824,12 @@ void USBDDriverCallbacks_ConfigurationChanged( uint8_t cfgnum )
 {
     AUDDSpeakerPhoneDriver_ConfigurationChangeHandler(cfgnum);
 
+    /* USB audio frame read configure (After EP parsed) */
+    AUDDSpeakerPhoneDriver_SetupRead(frmRxMbl,
+                                     BUFFER_NUMBER,
+                                     (TransferCallback) FrameReceived,
+                                     NULL);
+
     /* USB audio frame write configure (After EP parsed) */
     AUDDSpeakerPhoneDriver_SetupWrite(frmMbl,
                                       NULL,
@@ -879,6 +914,10 @@ void AUDDSpeakerPhoneDriver_StreamSettingChanged( uint8_t mic, uint8_t newSettin
             LED_Clear( LED_BLUE ) ;
         }
         isPlyActive = (newSetting > 0);
+        if ( !isPlyActive )
+        {
+            isRxQueued = 0;
+        }
     }
     else
     {
@@ -955,13 +994,15 @@ extern int main( void )
         }
         else
         {
-            if ( isPlyActive )
+            if ( isPlyActive && !isRxQueued
+                && (DACC->DACC_PTSR & DACC_PTSR_TXTEN) == 0 )
             {
-                /* Try to Start Reading the incoming audio stream */
-                AUDDSpeakerPhoneDriver_Read(buffers[inBufferIndex],
-                                       AUDDevice_BYTESPERFRAME,
-                                       (TransferCallback) FrameReceived,
-                                       0); // No optional argument
+                /* Start Reading the incoming audio stream: give all the
+                   buffers to the read frame list, in order */
+                inBufferIndex = outBufferIndex = releaseIndex = 0;
+                numBuffersToSend = 0;
+                isRxQueued = 1;
+                ReleaseBuffers(BUFFER_NUMBER);
             }
         }
 
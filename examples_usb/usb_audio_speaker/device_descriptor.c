@@ -114,13 +114,13 @@ const USBDeviceDescriptor deviceDescriptor = {
 };
 
 /** Configuration descriptors for a USB audio speaker driver. */
-const AUDDSpeakerDriverConfigurationDescriptors fsConfigurationDescriptors = {
+const AUDDSpeakerDriverAsyncConfigurationDescriptors fsConfigurationDescriptors = {
 
     /* Configuration descriptor */
     {
         sizeof(USBConfigurationDescriptor),
         USBGenericDescriptor_CONFIGURATION,
-        sizeof(AUDDSpeakerDriverConfigurationDescriptors),
+        sizeof(AUDDSpeakerDriverAsyncConfigurationDescriptors),
         2, /* This configuration has 2 interfaces */
         1, /* This is configuration #1 */
         0, /* No string descriptor */
@@ -214,7 +214,7 @@ const AUDDSpeakerDriverConfigurationDescriptors fsConfigurationDescriptors = {
         USBGenericDescriptor_INTERFACE,
         AUDDSpeakerDriverDescriptors_STREAMING,
         1, /* This is alternate setting #1 */
-        1, /* This interface uses 1 endpoint */
+        2, /* This interface uses 2 endpoints (data & feedback) */
         AUDStreamingInterfaceDescriptor_CLASS,
         AUDStreamingInterfaceDescriptor_SUBCLASS,
         AUDStreamingInterfaceDescriptor_PROTOCOL,
@@ -254,11 +254,14 @@ const AUDDSpeakerDriverConfigurationDescriptors fsConfigurationDescriptors = {
         USBEndpointDescriptor_ADDRESS(
             USBEndpointDescriptor_OUT,
             AUDDSpeakerDriverDescriptors_DATAOUT),
-        USBEndpointDescriptor_ISOCHRONOUS,
+        USBEndpointDescriptor_ISOCHRONOUS
+        | USBEndpointDescriptor_ASYNCHRONOUS,
         CHIP_USB_ENDPOINTS_MAXPACKETSIZE(AUDDSpeakerDriverDescriptors_DATAOUT),
         AUDDSpeakerDriverDescriptors_FS_INTERVAL, /* Polling interval = 1 ms */
         0, /* This is not a synchronization endpoint */
-        0  /* No associated synchronization endpoint */
+        USBEndpointDescriptor_ADDRESS(
+            USBEndpointDescriptor_IN,
+            AUDDSpeakerDriverDescriptors_FEEDBACK)
     },
     /* Audio streaming endpoint class-specific descriptor */
     {
@@ -268,6 +271,20 @@ const AUDDSpeakerDriverConfigurationDescriptors fsConfigurationDescriptors = {
         0, /* No attributes */
         0, /* Endpoint is not synchronized */
         0  /* Endpoint is not synchronized */
+    },
+    /* Audio streaming feedback endpoint standard descriptor */
+    {
+        sizeof(AUDEndpointDescriptor),
+        USBGenericDescriptor_ENDPOINT,
+        USBEndpointDescriptor_ADDRESS(
+            USBEndpointDescriptor_IN,
+            AUDDSpeakerDriverDescriptors_FEEDBACK),
+        USBEndpointDescriptor_ISOCHRONOUS
+        | USBEndpointDescriptor_FEEDBACK,
+        AUDDSpeakerDriver_FEEDBACKSIZE,
+        1, /* Polling interval = 1 ms */
+        AUDDSpeakerDriverDescriptors_FS_REFRESH, /* Refresh = 4 ms */
+        0  /* No associated synchronization endpoint */
     }
 };
 
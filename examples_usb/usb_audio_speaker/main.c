@@ -68,6 +68,12 @@
  *  amplifier. At the same time, the %audio stream received is also sent
  *  back to host from EK for recording.
  *
+ *  The stream is asynchronous: the DAC is paced by its own timer and the
+ *  rate to send is returned to the host on a feedback endpoint, computed
+ *  from the fill level of the playback buffers (see \ref AUDDRateAdapter.h).
+ *  If the host does not follow the feedback, the received frames are
+ *  resampled once the measured drift exceeds \ref DRIFT_THRESHOLD.
+ *
  *  \section Usage
  *
  *  -# Build the program and download it inside the evaluation board. Please
@@ -121,6 +127,7 @@
 #include "include/USBD_Config.h"
 
 #include "AUDDSpeakerDriver.h"
+#include "AUDDRateAdapter.h"
 
 #include <stdio.h>
 #include <stdbool.h>
@@ -132,13 +139,25 @@
 
 /**  Number of available audio buffers. */
 #define BUFFER_NUMBER   6
+/**  Size of the USB receive buffer in bytes: one frame more than nominal,
+     as the host follows the feedback. */
+#define RECEIVE_SIZE    (AUDDevice_BYTESPERFRAME + AUDDevice_BYTESPERSUBFRAME)
 /**  Size of one buffer in bytes. */
-#define BUFFER_SIZE     (AUDDevice_BYTESPERFRAME)
+#define BUFFER_SIZE     (AUDDRateAdapter_OUTFRAMES(RECEIVE_SIZE \
+                                                   / AUDDevice_BYTESPERSUBFRAME) \
+                         * AUDDevice_BYTESPERSUBFRAME)
 
 /**  Delay in ms for starting the DAC transmission
      after a frame has been received. */
 #define DAC_DELAY           2
 
+/**  Fill level (frames) kept by the feedback: buffers queued when the DAC
+     starts. */
+#define FILL_TARGET     ((DAC_DELAY + 2) * AUDDevice_SAMPLESPERFRAME \
+                         / AUDDevice_NUMCHANNELS)
+/**  Drift (ppm) between host and DAC rates engaging the resampler. */
+#define DRIFT_THRESHOLD     500
+
 /** Audio output channel RIGHT */
 #define CHANNEL_R       DACC_CHANNEL_0
 /** Audio output channel LEFT */
@@ -160,7 +179,9 @@ extern const USBDDriverDescriptors auddSpeakerDriverDescriptors;
  *         Internal variables
  *----------------------------------------------------------------------------*/
 
-/**  Data buffers for receiving audio frames from the USB host. */
+/**  Buffer for receiving audio frames from the USB host. */
+static uint8_t usbBuffer[RECEIVE_SIZE];
+/**  Data buffers for audio frames to send to the DAC. */
 static uint8_t buffers[BUFFER_NUMBER][BUFFER_SIZE];
 /**  Number of samples stored in each data buffer. */
 static uint32_t bufferSizes[BUFFER_NUMBER];
@@ -176,8 +197,10 @@ static volatile uint32_t isDacActive = 0;
 /**  Number of buffers to wait for before the DAC starts to transmit data. */
 static volatile uint32_t dacDelay;
 
-/**  Basic RA configure value for sampling frequency control */
-static uint32_t bakRA;
+/**  DAC sample rate, 10.14 samples per frame. */
+static uint32_t dacFeedback;
+/**  Rate adaptation of the received stream. */
+static AUDDRateAdapter rateAdapter;
 
 /*----------------------------------------------------------------------------
  *         VBus monitoring (optional)
@@ -286,7 +309,9 @@ static void ConfigureAudioPlay(uint32_t sampleRate,
     rc = (((double)mck/div)/(freq)   + 0.99);
     TC0->TC_CHANNEL[0].TC_RA = (uint32_t)ra;
     TC0->TC_CHANNEL[0].TC_RC = (uint32_t)ra*2;
-    bakRA = (uint32_t)ra;
+    /* Actual sample rate given by the TC, as feedback value */
+    dacFeedback = (uint32_t)(((double)mck/div) * 16384
+                             / ((uint32_t)ra*2*nbChannels) / 1000 + 0.5);
 
     printf("-I- MCK %dKHz, Div %d(%x), RA: %d*.01(%x), RC: %d*.01(%x)\n\r",
             (int)mck/1000, (int)div, (unsigned int)div,
@@ -452,36 +477,10 @@ void DAC_IrqHandler(void)
         isDacActive = 0;
         /* Reset playback index */
         inBufferIndex = outBufferIndex = 0;
+        /* Back to the nominal rate until the playback restarts */
+        AUDDSpeakerDriver_SetFeedback(dacFeedback);
     }
     else if (numBuffersToSend) {
-        /* Check the number of available buffers */
-        if (numBuffersToSend > DAC_DELAY) {
-            //printf("%d+", numBuffersToSend);
-            /* Speed up DAC freq (TC) */
-            {   uint32_t newRA = bakRA - (numBuffersToSend-DAC_DELAY);
-                if (TC0->TC_CHANNEL[0].TC_RA != newRA) {
-                    TC0->TC_CHANNEL[0].TC_RA =  newRA;
-                    TC0->TC_CHANNEL[0].TC_RC =  newRA*2;
-                }
-            }
-        }
-        else if (numBuffersToSend < DAC_DELAY) {
-            //printf("%d-", numBuffersToSend);
-            /* Slow down DAC (TC) */
-            {   uint32_t newRA = bakRA + (DAC_DELAY-numBuffersToSend);
-                if (TC0->TC_CHANNEL[0].TC_RA != newRA) {
-                    TC0->TC_CHANNEL[0].TC_RA = newRA;
-                    TC0->TC_CHANNEL[0].TC_RC = newRA*2;
-                }
-            }
-        }
-        else {
-            /* Keep DAC (TC) */
-            if (TC0->TC_CHANNEL[0].TC_RA != bakRA) {
-                TC0->TC_CHANNEL[0].TC_RA = bakRA;
-                TC0->TC_CHANNEL[0].TC_RC = bakRA*2;
-            }
-        }
         /* Load next buffer */
         DacPlayBuffer(buffers[outBufferIndex],
                       bufferSizes[outBufferIndex],
@@ -495,6 +494,23 @@ void DAC_IrqHandler(void)
     }
 }
 
+/**
+ * Returns the number of frames waiting for playback: queued buffers and
+ * samples left in the DAC PDC.
+ */
+static uint32_t DacFillLevel(void)
+{
+    uint32_t samples = DACC->DACC_TCR + DACC->DACC_TNCR;
+    uint32_t index = outBufferIndex;
+    uint32_t i;
+
+    for (i = 0; i < numBuffersToSend; i ++) {
+        samples += bufferSizes[index];
+        index = (index + 1) % BUFFER_NUMBER;
+    }
+    return samples / AUDDevice_NUMCHANNELS;
+}
+
 /**
  *  Invoked when a frame has been received.
  */
@@ -507,11 +523,22 @@ static void FrameReceived(uint32_t unused,
 
     if (status == USBD_STATUS_SUCCESS) {
 
-        bufferSizes[inBufferIndex] = transferred
-                                        / AUDDevice_BYTESPERSAMPLE;
+        uint32_t frames = transferred / AUDDevice_BYTESPERSUBFRAME;
+
+        bufferSizes[inBufferIndex] =
+            AUDDRateAdapter_Process(&rateAdapter,
+                                    (int16_t*)usbBuffer, frames,
+                                    (int16_t*)buffers[inBufferIndex])
+            * AUDDevice_NUMCHANNELS;
         inBufferIndex = (inBufferIndex + 1) % BUFFER_NUMBER;
         numBuffersToSend++;
 
+        /* Rate feedback from the fill level while playing */
+        if (pDac->DACC_PTSR & DACC_PTSR_TXTEN) {
+            AUDDSpeakerDriver_SetFeedback(
+                AUDDRateAdapter_Update(&rateAdapter, frames, DacFillLevel()));
+        }
+
         /* Start DAc transmission if necessary */
         if (!isDacActive) {
 
@@ -525,6 +552,7 @@ static void FrameReceived(uint32_t unused,
         }
         /* Start sending buffers */
         else if ((pDac->DACC_PTSR & DACC_PTSR_TXTEN) == 0) {
+            AUDDRateAdapter_Reset(&rateAdapter);
             AudioPlayEnable(1);
             DacPlayBuffer(buffers[outBufferIndex],
                           bufferSizes[outBufferIndex],
@@ -551,8 +579,8 @@ static void FrameReceived(uint32_t unused,
     }
 
     /* Receive next packet */
-    AUDDSpeakerDriver_Read(buffers[inBufferIndex],
-                           AUDDevice_BYTESPERFRAME,
+    AUDDSpeakerDriver_Read(usbBuffer,
+                           RECEIVE_SIZE,
                            (TransferCallback) FrameReceived,
                            0); // No optional argument
 }
@@ -611,6 +639,12 @@ int main(void)
                        AUDDevice_NUMCHANNELS,
                        BOARD_MCK);
 
+    /* Rate feedback & adaptation from the DAC rate */
+    AUDDRateAdapter_Initialize(&rateAdapter, dacFeedback,
+                               AUDDevice_NUMCHANNELS,
+                               FILL_TARGET, DRIFT_THRESHOLD);
+    AUDDSpeakerDriver_SetFeedback(dacFeedback);
+
     /* USB audio driver initialization */
     AUDDSpeakerDriver_Initialize(&auddSpeakerDriverDescriptors);
 
@@ -638,8 +672,8 @@ int main(void)
 
         if (usbConn == 0) {
             /* Start Reading the incoming audio stream */
-            AUDDSpeakerDriver_Read(buffers[inBufferIndex],
-                                   AUDDevice_BYTESPERFRAME,
+            AUDDSpeakerDriver_Read(usbBuffer,
+                                   RECEIVE_SIZE,
                                    (TransferCallback) FrameReceived,
                                    0); // No optional argument
         }
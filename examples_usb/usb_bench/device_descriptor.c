@@ -0,0 +1,193 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file
+ *
+ * Descriptors of the vendor source/sink device of the USB benchmark
+ * (BENCH_MODE BENCH_SOURCESINK). The other modes use the descriptors of the
+ * usb_cdc_serial, usb_massstorage and usb_hid_transfer examples.
+ */
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include "board.h"
+#include "include/USBD_Config.h"
+#include "USBDescriptors.h"
+#include "device_descriptor.h"
+
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Device product ID. */
+#define BenchDriverDescriptors_PRODUCTID    0x6140
+/** Device vendor ID (Atmel). */
+#define BenchDriverDescriptors_VENDORID     0x03EB
+/** Device release number. */
+#define BenchDriverDescriptors_RELEASE      0x0100
+
+/** Vendor specific class code */
+#define BenchDriverDescriptors_CLASS        0xFF
+
+/*------------------------------------------------------------------------------
+ *         Macros
+ *------------------------------------------------------------------------------*/
+
+/** Returns the minimum between two values. */
+#define MIN(a, b)       ((a < b) ? a : b)
+
+/** Bulk endpoint descriptor of the vendor interface. */
+#define BENCH_BULK_EP(dir, ep) \
+    { \
+        sizeof(USBEndpointDescriptor), \
+        USBGenericDescriptor_ENDPOINT, \
+        USBEndpointDescriptor_ADDRESS(dir, ep), \
+        USBEndpointDescriptor_BULK, \
+        MIN(CHIP_USB_ENDPOINTS_MAXPACKETSIZE(ep), \
+            USBEndpointDescriptor_MAXBULKSIZE_FS), \
+        0 /* Must be 0 for full-speed bulk endpoints */ \
+    }
+
+/*------------------------------------------------------------------------------
+ *         Exported variables
+ *------------------------------------------------------------------------------*/
+
+/** Standard USB device descriptor for the vendor source/sink device */
+const USBDeviceDescriptor deviceDescriptor = {
+
+    sizeof(USBDeviceDescriptor),
+    USBGenericDescriptor_DEVICE,
+    USBDeviceDescriptor_USB2_00,
+    0, /* Class defined by the interface */
+    0,
+    0,
+    CHIP_USB_ENDPOINTS_MAXPACKETSIZE(0),
+    BenchDriverDescriptors_VENDORID,
+    BenchDriverDescriptors_PRODUCTID,
+    BenchDriverDescriptors_RELEASE,
+    0, /* No string descriptor for manufacturer */
+    1, /* Index of product string descriptor is #1 */
+    0, /* No string descriptor for serial number */
+    1 /* Device has 1 possible configuration */
+};
+
+/** Standard USB configuration descriptor for the vendor source/sink device */
+const BenchConfigurationDescriptors configurationDescriptorsFS = {
+
+    /* Standard configuration descriptor */
+    {
+        sizeof(USBConfigurationDescriptor),
+        USBGenericDescriptor_CONFIGURATION,
+        sizeof(BenchConfigurationDescriptors),
+        1, /* There is one interface in this configuration */
+        1, /* This is configuration #1 */
+        0, /* No string descriptor for this configuration */
+        USBD_BMATTRIBUTES,
+        USBConfigurationDescriptor_POWER(100)
+    },
+    /* Vendor interface, source/sink setting */
+    {
+        sizeof(USBInterfaceDescriptor),
+        USBGenericDescriptor_INTERFACE,
+        0, /* This is interface #0 */
+        BENCH_SETTING_SOURCESINK,
+        2, /* This interface uses 2 endpoints */
+        BenchDriverDescriptors_CLASS,
+        0,
+        0,
+        0  /* No string descriptor for this interface */
+    },
+    BENCH_BULK_EP(USBEndpointDescriptor_OUT, BENCH_EPOUT),
+    BENCH_BULK_EP(USBEndpointDescriptor_IN, BENCH_EPIN),
+    /* Vendor interface, loopback setting */
+    {
+        sizeof(USBInterfaceDescriptor),
+        USBGenericDescriptor_INTERFACE,
+        0, /* This is interface #0 */
+        BENCH_SETTING_LOOPBACK,
+        2, /* This interface uses 2 endpoints */
+        BenchDriverDescriptors_CLASS,
+        0,
+        0,
+        0  /* No string descriptor for this interface */
+    },
+    BENCH_BULK_EP(USBEndpointDescriptor_OUT, BENCH_EPOUT),
+    BENCH_BULK_EP(USBEndpointDescriptor_IN, BENCH_EPIN)
+};
+
+/** Language ID string descriptor */
+const unsigned char languageIdStringDescriptor[] = {
+
+    USBStringDescriptor_LENGTH(1),
+    USBGenericDescriptor_STRING,
+    USBStringDescriptor_ENGLISH_US
+};
+
+/** Product string descriptor */
+const unsigned char productStringDescriptor[] = {
+
+    USBStringDescriptor_LENGTH(12),
+    USBGenericDescriptor_STRING,
+    USBStringDescriptor_UNICODE('A'),
+    USBStringDescriptor_UNICODE('T'),
+    USBStringDescriptor_UNICODE('9'),
+    USBStringDescriptor_UNICODE('1'),
+    USBStringDescriptor_UNICODE('U'),
+    USBStringDescriptor_UNICODE('S'),
+    USBStringDescriptor_UNICODE('B'),
+    USBStringDescriptor_UNICODE('B'),
+    USBStringDescriptor_UNICODE('e'),
+    USBStringDescriptor_UNICODE('n'),
+    USBStringDescriptor_UNICODE('c'),
+    USBStringDescriptor_UNICODE('h')
+};
+
+/** List of string descriptors used by the device */
+const unsigned char *stringDescriptors[] = {
+
+    languageIdStringDescriptor,
+    productStringDescriptor,
+};
+
+/** List of standard descriptors for the vendor source/sink device. */
+const USBDDriverDescriptors benchDriverDescriptors = {
+
+    &deviceDescriptor,
+    (USBConfigurationDescriptor *) &(configurationDescriptorsFS),
+    0, /* No full-speed device qualifier descriptor */
+    0, /* No full-speed other speed configuration */
+    0, /* No high-speed device descriptor */
+    0, /* No high-speed configuration descriptor */
+    0, /* No high-speed device qualifier descriptor */
+    0, /* No high-speed other speed configuration descriptor */
+    stringDescriptors,
+    2 /* 2 string descriptors in list */
+};
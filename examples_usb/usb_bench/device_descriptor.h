@@ -0,0 +1,97 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Definitions shared by the USB benchmark application and its vendor
+ * source/sink descriptors.
+ */
+
+#ifndef _BENCH_DESCRIPTORS_
+#define _BENCH_DESCRIPTORS_
+
+#include "USBDDriver.h"
+
+/** \addtogroup usb_bench_modes Benchmark modes
+ *      @{
+ * The class measured is selected at build time with BENCH_MODE.
+ */
+/** CDC serial port echoing each bulk packet */
+#define BENCH_LOOPBACK              0
+/** Vendor interface: bulk source/sink (setting 0) or loopback (setting 1) */
+#define BENCH_SOURCESINK            1
+/** Mass storage with a RAM disk LUN */
+#define BENCH_MSD                   2
+/** HID transfer device echoing each output report */
+#define BENCH_HID                   3
+/**      @}*/
+
+#ifndef BENCH_MODE
+#define BENCH_MODE                  BENCH_SOURCESINK
+#endif
+
+/** Bulk OUT endpoint of the vendor interface */
+#define BENCH_EPOUT                 1
+/** Bulk IN endpoint of the vendor interface */
+#define BENCH_EPIN                  2
+
+/** Vendor interface setting streaming both ways at once */
+#define BENCH_SETTING_SOURCESINK    0
+/** Vendor interface setting echoing each packet */
+#define BENCH_SETTING_LOOPBACK      1
+
+/** Vendor request (device, IN) returning the BenchStats, whatever the mode.
+ *  Bit 0 of wValue clears the statistics once read. */
+#define BENCH_REQ_GETSTATS          0x01
+
+/** Configuration descriptor list of the vendor source/sink device. */
+typedef struct _BenchConfigurationDescriptors {
+
+    /** Standard configuration descriptor. */
+    USBConfigurationDescriptor configuration;
+    /** Source/sink setting of the vendor interface. */
+    USBInterfaceDescriptor sourceSink;
+    /** Sink OUT endpoint descriptor. */
+    USBEndpointDescriptor sinkOut;
+    /** Source IN endpoint descriptor. */
+    USBEndpointDescriptor sourceIn;
+    /** Loopback setting of the vendor interface. */
+    USBInterfaceDescriptor loopback;
+    /** Loopback OUT endpoint descriptor. */
+    USBEndpointDescriptor loopbackOut;
+    /** Loopback IN endpoint descriptor. */
+    USBEndpointDescriptor loopbackIn;
+
+} __attribute__ ((packed)) BenchConfigurationDescriptors;
+
+/** Vendor source/sink Driver Descriptors List */
+extern const USBDDriverDescriptors benchDriverDescriptors;
+
+#endif // _BENCH_DESCRIPTORS_
@@ -0,0 +1,765 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page usb_bench USB Device Benchmark Example
+ *
+ * \section Purpose
+ *
+ * The USB Benchmark Example measures the USB device stack end to end, so
+ * that a change in the UDP driver (USBD_HAL.c) or in a class driver shows up
+ * as throughput, latency and CPU load figures.
+ *
+ * \section Description
+ *
+ * The class measured is selected at build time with BENCH_MODE (make
+ * BENCH_MODE=n), the endpoints of the UDP not allowing all of them at once:
+ * - 0: CDC serial port, each bulk packet received is sent back
+ *   (descriptors of the usb_cdc_serial example).
+ * - 1: vendor interface with two bulk endpoints; setting 0 sinks all the OUT
+ *   data and sources IN data without end, setting 1 sends back each packet.
+ * - 2: mass storage, one LUN on a RAM disk (MEDRamDisk), so that the medium
+ *   adds no latency (descriptors of the usb_massstorage example).
+ * - 3: HID transfer device, each output report is sent back as an input
+ *   report through the report queues (descriptors of the usb_hid_transfer
+ *   example).
+ *
+ * In all the modes, the device counts the bytes and the packets moved, the
+ * core clock cycles spent in the USB interrupt (USBD_HAL_EnableIrqStats())
+ * and, for the MSD and HID modes which move the data from the main loop,
+ * the cycles spent in the main loop processing. The figures are returned by
+ * the vendor request BENCH_REQ_GETSTATS and printed on the DBGU every second.
+ * The per-endpoint counters of the USB stack (USBD_EnableStats()) are
+ * answered as well, and can be followed with
+ * libraries/usb/device/core/usbdstats.py while a run goes on.
+ *
+ * The host measures the throughput and the latencies with usb_bench.py,
+ * which reads the device figures before and after each run.
+ *
+ * \section Usage
+ *
+ * -# Build the program with the wanted BENCH_MODE and download it inside the
+ *    evaluation board. Please refer to the
+ *    <a href="http://www.atmel.com/dyn/resources/prod_documents/doc6224.pdf">
+ *    SAM-BA User Guide</a>, the
+ *    <a href="http://www.atmel.com/dyn/resources/prod_documents/doc6310.pdf">
+ *    GNU-Based Software Development</a> application note or to the
+ *    <a href="ftp://ftp.iar.se/WWWfiles/arm/Guides/EWARM_UserGuide.ENU.pdf">
+ *    IAR EWARM User Guide</a>, depending on your chosen solution.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 bauds
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application.
+ * -# In the terminal window, the following text should appear:
+ *     \code
+ *     -- USB Device Benchmark Example xxx --
+ *     -- xxxxxx-xx
+ *     -- Compiled: xxx xx xxxx xx:xx:xx --
+ *     -- Mode x
+ *     \endcode
+ * -# Connect the USB cable and run usb_bench.py on the host, e.g.
+ *    "usb_bench.py sourcesink" or "usb_bench.py msd --disk /dev/sdb".
+ */
+
+/**
+ * \file
+ *
+ * This file contains all the specific code for the
+ * usb_bench example.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "board.h"
+
+#include "USBD.h"
+#include "USBDDriver.h"
+#include "USBD_HAL.h"
+#include "device_descriptor.h"
+
+#if BENCH_MODE == BENCH_LOOPBACK
+#include "CDCDSerialDriver.h"
+#elif BENCH_MODE == BENCH_MSD
+#include "MSDDriver.h"
+#include "MSDLun.h"
+#include "memories.h"
+#elif BENCH_MODE == BENCH_HID
+#include "HIDDTransferDriver.h"
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Full speed bulk packet size, also the size of a loopback transfer */
+#define BENCH_PACKET_SIZE   64
+
+/** Size of the source and sink transfers, multiple of BENCH_PACKET_SIZE */
+#define BENCH_BUFFER_SIZE   4096
+
+/** Size of a RAM disk block */
+#define BLOCK_SIZE          512
+
+/** Number of blocks of the RAM disk */
+#define RAMDISK_BLOCKS      64
+
+/** Size of the MSD read/write buffer */
+#define MSD_BUFFER_SIZE     (8*BLOCK_SIZE)
+
+/** Number of report slots of each HID queue */
+#define HID_QUEUE_SLOTS     8
+
+/** Delay between two console reports, tick is 250ms */
+#define UPDATE_DELAY        4
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Figures returned by BENCH_REQ_GETSTATS, little endian words. */
+typedef struct _BenchStats {
+
+    /** BENCH_MODE of the firmware */
+    uint32_t dwMode;
+    /** Core clock frequency, cycles per second */
+    uint32_t dwMck;
+    /** Packets moved, both directions */
+    uint32_t dwPackets;
+    /** Bytes moved, both directions */
+    uint32_t dwBytes;
+    /** Cycles spent moving the data from the main loop (MSD, HID) */
+    uint32_t dwLoopCycles;
+    /** USB interrupts serviced */
+    uint32_t dwIrqCount;
+    /** Cycles spent servicing the USB interrupts */
+    uint32_t dwIrqCycles;
+    /** Longest USB interrupt service, in cycles */
+    uint32_t dwIrqMaxCycles;
+
+} BenchStats;
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Packets moved since the last reset. */
+static volatile uint32_t benchPackets = 0;
+/** Bytes moved since the last reset. */
+static volatile uint32_t benchBytes = 0;
+/** Main loop cycles since the last reset. */
+static volatile uint32_t benchLoopCycles = 0;
+
+/** Figures being sent for BENCH_REQ_GETSTATS. */
+static BenchStats benchStats;
+
+/** Update delay counter, tick is 250ms */
+static volatile uint32_t updateDelay = UPDATE_DELAY;
+
+/** Flag to update the console report */
+static volatile uint8_t updateView = 0;
+
+#if BENCH_MODE == BENCH_LOOPBACK
+
+/** CDC serial Driver Descriptors List */
+extern const USBDDriverDescriptors cdcdSerialDriverDescriptors;
+
+/** Packet sent back to the host. */
+static uint8_t loopBuffer[BENCH_PACKET_SIZE];
+
+#elif BENCH_MODE == BENCH_SOURCESINK
+
+/** Current setting of the vendor interface. */
+static uint8_t benchSettings[1];
+
+/** Data streamed to the host. */
+static uint8_t sourceBuffer[BENCH_BUFFER_SIZE];
+/** Data received from the host, dropped. */
+static uint8_t sinkBuffer[BENCH_BUFFER_SIZE];
+/** Packet sent back to the host. */
+static uint8_t loopBuffer[BENCH_PACKET_SIZE];
+
+#elif BENCH_MODE == BENCH_MSD
+
+/** MSD Driver Descriptors List */
+extern const USBDDriverDescriptors msdDriverDescriptors;
+
+/** RAM disk media. */
+static Media ramDiskMedia;
+/** Device LUN. */
+static MSDLun lun;
+/** LUN read/write buffer. */
+BOARD_NOINIT_SECTION static uint8_t msdBuffer[MSD_BUFFER_SIZE];
+/** RAM disk, whose address is given in blocks to MEDRamDisk. */
+static uint8_t ramDisk[RAMDISK_BLOCKS*BLOCK_SIZE] __attribute__ ((aligned (BLOCK_SIZE)));
+
+#elif BENCH_MODE == BENCH_HID
+
+/** HID Transfer Driver Descriptors List */
+extern USBDDriverDescriptors hiddTransferDriverDescriptors;
+
+/** Input report queue and its slots. */
+static HIDDReportQueue hidInQueue;
+static uint8_t hidInSlots[HID_QUEUE_SLOTS*HIDDTransferDriver_REPORTSIZE];
+/** Output report queue and its slots. */
+static HIDDReportQueue hidOutQueue;
+static uint8_t hidOutSlots[HID_QUEUE_SLOTS*HIDDTransferDriver_REPORTSIZE];
+/** Report sent back to the host. */
+static uint8_t hidReport[HIDDTransferDriver_REPORTSIZE];
+/** 1 while hidReport waits for room in the input queue. */
+static uint8_t hidPending = 0;
+
+#endif
+
+/*----------------------------------------------------------------------------
+ *        VBus monitoring (optional)
+ *----------------------------------------------------------------------------*/
+
+/** VBus pin instance. */
+static const Pin pinVbus = PIN_USB_VBUS;
+
+/**
+ * \brief Handles interrupts coming from PIO controllers.
+ */
+static void ISR_Vbus(const Pin *pPin)
+{
+    /* Check current level on VBus */
+    if (PIO_Get(&pinVbus)) {
+
+        TRACE_INFO("VBUS conn\n\r");
+        USBD_Connect();
+    }
+    else {
+
+        TRACE_INFO("VBUS discon\n\r");
+        USBD_Disconnect();
+    }
+}
+
+/**
+ * \brief Configures the VBus Pin
+ *
+ * To trigger an interrupt when the level on that pin changes.
+ */
+static void VBus_Configure( void )
+{
+    TRACE_INFO("VBus configuration\n\r");
+
+    /* Configure PIO */
+    PIO_Configure(&pinVbus, 1);
+    PIO_ConfigureIt(&pinVbus, ISR_Vbus);
+    PIO_EnableIt(&pinVbus);
+
+    /* Check current level on VBus */
+    if (PIO_Get(&pinVbus)) {
+
+        /* if VBUS present, force the connect */
+        TRACE_INFO("conn\n\r");
+        USBD_Connect();
+    }
+    else {
+        USBD_Disconnect();
+    }
+}
+
+/*----------------------------------------------------------------------------
+ *        Statistics
+ *----------------------------------------------------------------------------*/
+
+/**
+ * Counts a transfer done, in any direction.
+ * \param dwBytes  Bytes transferred.
+ */
+static void _Count(uint32_t dwBytes)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    benchPackets += (dwBytes + BENCH_PACKET_SIZE - 1) / BENCH_PACKET_SIZE;
+    benchBytes += dwBytes;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * Gathers the figures since the last reset.
+ * \param pStats  Filled with the figures.
+ * \param bReset  1 to clear the figures once read.
+ */
+static void _GetStats(BenchStats *pStats, uint8_t bReset)
+{
+    USBDIrqStats irqStats;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    USBD_HAL_GetIrqStats(&irqStats, bReset);
+    pStats->dwMode = BENCH_MODE;
+    pStats->dwMck = BOARD_MCK;
+    pStats->dwPackets = benchPackets;
+    pStats->dwBytes = benchBytes;
+    pStats->dwLoopCycles = benchLoopCycles;
+    pStats->dwIrqCount = irqStats.dwCount;
+    pStats->dwIrqCycles = irqStats.dwCycles;
+    pStats->dwIrqMaxCycles = irqStats.dwMaxCycles;
+    if (bReset) {
+
+        benchPackets = 0;
+        benchBytes = 0;
+        benchLoopCycles = 0;
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * Handles the vendor requests, which are the same in all the modes.
+ * \param request  Pointer to a USBGenericRequest instance.
+ */
+static void _VendorRequest(const USBGenericRequest *request)
+{
+    uint16_t wLength = USBGenericRequest_GetLength(request);
+
+    if (USBGenericRequest_GetRequest(request) != BENCH_REQ_GETSTATS
+        || USBGenericRequest_GetDirection(request) != USBGenericRequest_IN) {
+
+        USBD_Stall(0);
+        return;
+    }
+
+    _GetStats(&benchStats, USBGenericRequest_GetValue(request) & 1);
+    if (wLength > sizeof(BenchStats))
+        wLength = sizeof(BenchStats);
+    USBD_Write(0, &benchStats, wLength, 0, 0);
+}
+
+/*----------------------------------------------------------------------------
+ *        Data pipes
+ *----------------------------------------------------------------------------*/
+
+#if BENCH_MODE == BENCH_LOOPBACK
+
+static void _CdcReceived(void *pArg, uint8_t status,
+                         uint32_t received, uint32_t remaining);
+
+/**
+ * Invoked when a packet has been sent back, waits for the next one.
+ */
+static void _CdcSent(void *pArg, uint8_t status,
+                     uint32_t sent, uint32_t remaining)
+{
+    if (status != USBD_STATUS_SUCCESS)
+        return;
+
+    _Count(sent);
+    CDCDSerialDriver_Read(loopBuffer, BENCH_PACKET_SIZE, _CdcReceived, 0);
+}
+
+/**
+ * Invoked when a packet has been received, sends it back.
+ */
+static void _CdcReceived(void *pArg, uint8_t status,
+                         uint32_t received, uint32_t remaining)
+{
+    if (status != USBD_STATUS_SUCCESS)
+        return;
+
+    _Count(received);
+    CDCDSerialDriver_Write(loopBuffer, received, _CdcSent, 0);
+}
+
+#elif BENCH_MODE == BENCH_SOURCESINK
+
+static void _LoopbackReceived(void *pArg, uint8_t status,
+                              uint32_t received, uint32_t remaining);
+
+/**
+ * Invoked when a sink transfer is done, starts the next one.
+ */
+static void _SinkDone(void *pArg, uint8_t status,
+                      uint32_t received, uint32_t remaining)
+{
+    if (status != USBD_STATUS_SUCCESS)
+        return;
+
+    _Count(received);
+    USBD_Read(BENCH_EPOUT, sinkBuffer, BENCH_BUFFER_SIZE, _SinkDone, 0);
+}
+
+/**
+ * Invoked when a source transfer is done, starts the next one.
+ */
+static void _SourceDone(void *pArg, uint8_t status,
+                        uint32_t sent, uint32_t remaining)
+{
+    if (status != USBD_STATUS_SUCCESS)
+        return;
+
+    _Count(sent);
+    USBD_Write(BENCH_EPIN, sourceBuffer, BENCH_BUFFER_SIZE, _SourceDone, 0);
+}
+
+/**
+ * Invoked when a packet has been sent back, waits for the next one.
+ */
+static void _LoopbackSent(void *pArg, uint8_t status,
+                          uint32_t sent, uint32_t remaining)
+{
+    if (status != USBD_STATUS_SUCCESS)
+        return;
+
+    _Count(sent);
+    USBD_Read(BENCH_EPOUT, loopBuffer, BENCH_PACKET_SIZE,
+              _LoopbackReceived, 0);
+}
+
+/**
+ * Invoked when a packet has been received, sends it back.
+ */
+static void _LoopbackReceived(void *pArg, uint8_t status,
+                              uint32_t received, uint32_t remaining)
+{
+    if (status != USBD_STATUS_SUCCESS)
+        return;
+
+    _Count(received);
+    USBD_Write(BENCH_EPIN, loopBuffer, received, _LoopbackSent, 0);
+}
+
+/**
+ * Starts the transfers of a setting of the vendor interface.
+ * \param setting  BENCH_SETTING_SOURCESINK or BENCH_SETTING_LOOPBACK.
+ */
+static void _VendorStart(uint8_t setting)
+{
+    if (setting == BENCH_SETTING_LOOPBACK) {
+
+        USBD_Read(BENCH_EPOUT, loopBuffer, BENCH_PACKET_SIZE,
+                  _LoopbackReceived, 0);
+    }
+    else {
+
+        USBD_Read(BENCH_EPOUT, sinkBuffer, BENCH_BUFFER_SIZE, _SinkDone, 0);
+        USBD_Write(BENCH_EPIN, sourceBuffer, BENCH_BUFFER_SIZE,
+                   _SourceDone, 0);
+    }
+}
+
+#elif BENCH_MODE == BENCH_MSD
+
+/**
+ * Invoked when the MSD finish a READ/WRITE.
+ * \param flowDirection 1 - device to host (READ10)
+ *                      0 - host to device (WRITE10)
+ * \param dataLength Length of data transferred in bytes.
+ * \param fifoNullCount Times that FIFO is NULL to wait
+ * \param fifoFullCount Times that FIFO is filled to wait
+ */
+static void MSDCallbacks_Data(uint8_t flowDirection, uint32_t dataLength,
+                              uint32_t fifoNullCount, uint32_t fifoFullCount)
+{
+    _Count(dataLength);
+}
+
+#endif
+
+/*-----------------------------------------------------------------------------
+ *         Callback re-implementation
+ *-----------------------------------------------------------------------------*/
+
+/**
+ * Invoked after the USB driver has been initialized. By default, configures
+ * the UDP/UDPHS interrupt.
+ */
+void USBDCallbacks_Initialized(void)
+{
+    NVIC_EnableIRQ(UDP_IRQn);
+}
+
+/**
+ * Invoked when a new SETUP request is received from the host. Handles the
+ * vendor requests and forwards the others to the driver of the mode.
+ * \param request  Pointer to a USBGenericRequest instance.
+ */
+void USBDCallbacks_RequestReceived(const USBGenericRequest *request)
+{
+    if (USBGenericRequest_GetType(request) == USBGenericRequest_VENDOR) {
+
+        _VendorRequest(request);
+        return;
+    }
+
+#if BENCH_MODE == BENCH_LOOPBACK
+    CDCDSerialDriver_RequestHandler(request);
+#elif BENCH_MODE == BENCH_SOURCESINK
+    USBDDriver_RequestHandler(USBD_GetDriver(), request);
+#elif BENCH_MODE == BENCH_MSD
+    MSDDriver_RequestHandler(request);
+#elif BENCH_MODE == BENCH_HID
+    HIDDTransferDriver_RequestHandler(request);
+#endif
+}
+
+/**
+ * Invoked when the configuration of the device changes. Configures the
+ * driver of the mode and starts the data pipes.
+ * \param cfgnum New configuration number.
+ */
+void USBDDriverCallbacks_ConfigurationChanged(uint8_t cfgnum)
+{
+#if BENCH_MODE == BENCH_LOOPBACK
+    CDCDSerialDriver_ConfigurationChangedHandler(cfgnum);
+    if (cfgnum)
+        CDCDSerialDriver_Read(loopBuffer, BENCH_PACKET_SIZE, _CdcReceived, 0);
+#elif BENCH_MODE == BENCH_SOURCESINK
+    benchSettings[0] = BENCH_SETTING_SOURCESINK;
+    if (cfgnum)
+        _VendorStart(BENCH_SETTING_SOURCESINK);
+#elif BENCH_MODE == BENCH_MSD
+    MSDDriver_ConfigurationChangeHandler(cfgnum);
+#elif BENCH_MODE == BENCH_HID
+    HIDDTransferDriver_ConfigurationChangedHandler(cfgnum);
+#endif
+}
+
+#if BENCH_MODE == BENCH_SOURCESINK
+/**
+ * Invoked when the vendor interface setting changes. Cancels the transfers
+ * of the previous setting and starts the ones of the new setting.
+ * \param interface Interface number.
+ * \param setting   New alternate setting.
+ */
+void USBDDriverCallbacks_InterfaceSettingChanged(uint8_t interface,
+                                                 uint8_t setting)
+{
+    USBD_HAL_CancelIo(bmEP(BENCH_EPOUT) | bmEP(BENCH_EPIN));
+    _VendorStart(setting);
+}
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Interrupt handler for TC0.
+ */
+void TC0_IrqHandler(void)
+{
+    volatile uint32_t dummy;
+    /* Clear status bit to acknowledge interrupt */
+    dummy = TC0->TC_CHANNEL[0].TC_SR;
+
+    if (-- updateDelay == 0) {
+
+        updateDelay = UPDATE_DELAY;
+        updateView = 1;
+    }
+}
+
+/**
+ * \brief Configure 48MHz Clock for USB
+ */
+static void _ConfigureUsbClock(void)
+{
+    /* Enable PLLB for USB */
+    PMC->CKGR_PLLBR = CKGR_PLLBR_DIVB(1)
+                    | CKGR_PLLBR_MULB(7)
+                    | CKGR_PLLBR_PLLBCOUNT_Msk;
+    while((PMC->PMC_SR & PMC_SR_LOCKB) == 0);
+    /* USB Clock uses PLLB */
+    PMC->PMC_USB = PMC_USB_USBDIV(1)    /* /2   */
+                 | PMC_USB_USBS;        /* PLLB */
+}
+
+/**
+ * \brief Configure Timer Counter 0
+ *
+ *  Configure TC0 to generate an interrupt every 250ms.
+ */
+static void _ConfigureTc0(void)
+{
+    uint32_t div;
+    uint32_t tcclks;
+
+    /* Enable peripheral clock */
+    PMC->PMC_PCER0 = 1 << ID_TC0;
+
+    /* Configure TC for a 4Hz frequency and trigger on RC compare */
+    TC_FindMckDivisor(4, BOARD_MCK, &div, &tcclks, BOARD_MCK);
+    TC_Configure(TC0, 0, tcclks | TC_CMR_CPCTRG);
+    TC0->TC_CHANNEL[0].TC_RC = (BOARD_MCK / div) / 4;
+
+    /* Configure and enable interrupt on RC compare */
+    NVIC_EnableIRQ((IRQn_Type)ID_TC0);
+    TC0->TC_CHANNEL[0].TC_IER = TC_IER_CPCS;
+
+    TC_Start(TC0, 0);
+}
+
+/**
+ * \brief Initializes the class driver of the mode.
+ */
+static void _DriverInitialize(void)
+{
+#if BENCH_MODE == BENCH_LOOPBACK
+    CDCDSerialDriver_Initialize(&cdcdSerialDriverDescriptors);
+#elif BENCH_MODE == BENCH_SOURCESINK
+    uint32_t i;
+
+    for (i = 0; i < BENCH_BUFFER_SIZE; i ++)
+        sourceBuffer[i] = (uint8_t)i;
+
+    USBDDriver_Initialize(USBD_GetDriver(),
+                          &benchDriverDescriptors,
+                          benchSettings);
+    USBD_Init();
+#elif BENCH_MODE == BENCH_MSD
+    if (!MEDRamDisk_Initialize(&ramDiskMedia, BLOCK_SIZE,
+                               (uint32_t)ramDisk / BLOCK_SIZE,
+                               RAMDISK_BLOCKS)) {
+
+        printf("RAM disk init error\n\r");
+    }
+    LUN_Init(&lun, &ramDiskMedia,
+             msdBuffer, MSD_BUFFER_SIZE,
+             0, 0, 0, 0,
+             MSDCallbacks_Data);
+    MSDDriver_Initialize(&msdDriverDescriptors, &lun, 1);
+#elif BENCH_MODE == BENCH_HID
+    HIDDTransferDriver_Initialize(&hiddTransferDriverDescriptors);
+    HIDDFunction_InitializeQueue(&hidInQueue, hidInSlots,
+                                 HIDDTransferDriver_REPORTSIZE,
+                                 HID_QUEUE_SLOTS);
+    HIDDFunction_InitializeQueue(&hidOutQueue, hidOutSlots,
+                                 HIDDTransferDriver_REPORTSIZE,
+                                 HID_QUEUE_SLOTS);
+    HIDDTransferDriver_SetQueues(&hidInQueue, &hidOutQueue);
+#endif
+}
+
+/**
+ * \brief Moves the data handled from the main loop, counting its cycles.
+ */
+static void _LoopService(void)
+{
+#if BENCH_MODE == BENCH_MSD || BENCH_MODE == BENCH_HID
+    uint32_t dwStart;
+
+    if (USBD_GetState() < USBD_STATE_CONFIGURED)
+        return;
+
+    dwStart = DWT_CYCCNT;
+  #if BENCH_MODE == BENCH_MSD
+    MSDDriver_StateMachine();
+  #else
+    if (!hidPending) {
+
+        if (!HIDDTransferDriver_QueueRead(hidReport))
+            return;
+        hidPending = 1;
+    }
+    /* Keep the report until the input queue has room */
+    if (HIDDTransferDriver_QueueWrite(hidReport) != USBRC_SUCCESS)
+        return;
+    hidPending = 0;
+    _Count(HIDDTransferDriver_REPORTSIZE);
+    _Count(HIDDTransferDriver_REPORTSIZE);
+  #endif
+    benchLoopCycles += DWT_CYCCNT - dwStart;
+#endif
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief usb_bench Application entry point.
+ *
+ * Configures TC0, the USB driver of the mode and runs it, printing the
+ * figures every second.
+ *
+ * \return Unused (ANSI-C compatibility).
+ */
+int main(void)
+{
+    BenchStats stats;
+
+    /* Disable watchdog */
+    WDT_Disable( WDT ) ;
+
+    printf("-- USB Device Benchmark Example %s --\n\r", SOFTPACK_VERSION);
+    printf("-- %s\n\r", BOARD_NAME);
+    printf("-- Compiled: %s %s --\n\r", __DATE__, __TIME__);
+    printf("-- Mode %d\n\r", BENCH_MODE);
+
+    /* If they are present, configure Vbus & Wake-up pins */
+    PIO_InitializeInterrupts(0);
+
+    /* Enable UPLL for USB */
+    _ConfigureUsbClock();
+
+    /* Start TC for status update */
+    _ConfigureTc0();
+
+    /* Count the cycles of the USB interrupt and the endpoint traffic */
+    USBD_EnableStats(1);
+
+    /* Driver of the mode */
+    _DriverInitialize();
+
+    /* connect if needed */
+    VBus_Configure();
+
+    /* Infinite loop */
+    while (1) {
+
+        _LoopService();
+
+        if (updateView) {
+
+            updateView = 0;
+            _GetStats(&stats, 0);
+            printf("%u pkts, %u KB, %u cyc/pkt, IRQ %u cyc, max %u  \r",
+                   (unsigned int)stats.dwPackets,
+                   (unsigned int)(stats.dwBytes / 1024),
+                   (unsigned int)(stats.dwPackets ?
+                       (stats.dwIrqCycles + stats.dwLoopCycles)
+                           / stats.dwPackets : 0),
+                   (unsigned int)stats.dwIrqCycles,
+                   (unsigned int)stats.dwIrqMaxCycles);
+        }
+    }
+}
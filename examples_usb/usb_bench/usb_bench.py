@@ -0,0 +1,245 @@
+#!/usr/bin/env python
+# ----------------------------------------------------------------------------
+#         ATMEL Microcontroller Software Support
+# ----------------------------------------------------------------------------
+# Copyright (c) 2010, Atmel Corporation
+#
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# - Redistributions of source code must retain the above copyright notice,
+# this list of conditions and the disclaimer below.
+#
+# Atmel's name may not be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+# IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+# DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+# OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+# EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+# ----------------------------------------------------------------------------
+
+"""Host side of the usb_bench example: measures the throughput and the
+latencies of the class selected in the firmware (BENCH_MODE), and reads the
+device figures (cycles per packet, USB interrupt time) through the vendor
+request BENCH_REQ_GETSTATS. Needs pyusb, and pyserial for the CDC mode.
+
+    usb_bench.py sourcesink [--size 4096] [--count 1000]
+    usb_bench.py vloop [--count 1000]
+    usb_bench.py cdc --port /dev/ttyACM0 [--count 1000]
+    usb_bench.py msd --disk /dev/sdb [--size 4096] [--count 100] [--write]
+    usb_bench.py hid [--count 1000]
+
+The loopback tests (vloop, cdc, hid) send one packet or report and wait for
+it to come back, so their latencies are round trips; the stream tests
+(sourcesink, msd) time each transfer of --size bytes.
+"""
+
+import os
+import struct
+import sys
+import time
+
+VENDOR_ATMEL = 0x03EB
+PRODUCTS = {'sourcesink': 0x6140, 'vloop': 0x6140, 'cdc': 0x6119,
+            'msd': 0x6129, 'hid': 0x6201}
+MODES = {0: 'CDC loopback', 1: 'vendor source/sink', 2: 'MSD RAM disk',
+         3: 'HID echo'}
+
+BENCH_REQ_GETSTATS = 0x01
+STATS = struct.Struct('<8I')
+STATS_FIELDS = ('mode', 'mck', 'packets', 'bytes', 'loop_cycles',
+                'irq_count', 'irq_cycles', 'irq_max_cycles')
+
+SETTING_SOURCESINK = 0
+SETTING_LOOPBACK = 1
+PACKET_SIZE = 64
+HID_REPORT_SIZE = 32
+
+
+def find_device(product):
+    import usb.core
+    dev = usb.core.find(idVendor=VENDOR_ATMEL, idProduct=product)
+    if dev is None:
+        raise SystemExit('device %04x:%04x not found'
+                         % (VENDOR_ATMEL, product))
+    return dev
+
+
+def get_stats(dev, reset=False):
+    """Returns the device figures as a dict, clearing them if reset."""
+    data = dev.ctrl_transfer(0xC0, BENCH_REQ_GETSTATS, 1 if reset else 0, 0,
+                             STATS.size)
+    return dict(zip(STATS_FIELDS, STATS.unpack(bytes(bytearray(data)))))
+
+
+def percentile(values, pct):
+    """Nearest rank percentile of a sorted list."""
+    if not values:
+        return 0.0
+    rank = int(round(pct / 100.0 * (len(values) - 1)))
+    return values[min(len(values) - 1, rank)]
+
+
+def show(name, moved, elapsed, latencies, stats, out=sys.stdout):
+    """Prints the host and device figures of a run."""
+    latencies = sorted(latencies)
+    elapsed = elapsed or 1e-9
+    out.write('%s: %d bytes in %.3f s, %.3f MB/s\n'
+              % (name, moved, elapsed, moved / elapsed / 1e6))
+    out.write('  latency (us) min %.0f p50 %.0f p90 %.0f p99 %.0f max %.0f\n'
+              % tuple(1e6 * percentile(latencies, pct)
+                      for pct in (0, 50, 90, 99, 100)))
+    mck = float(stats['mck'] or 1)
+    packets = stats['packets'] or 1
+    out.write('  device (%s): %d packets, %d cycles/packet, '
+              '%d cycles/packet in IRQ\n'
+              % (MODES.get(stats['mode'], 'mode %d' % stats['mode']),
+                 stats['packets'],
+                 (stats['irq_cycles'] + stats['loop_cycles']) // packets,
+                 stats['irq_cycles'] // packets))
+    out.write('  device IRQ: %d serviced, %.1f %% of the CPU, '
+              'longest %.1f us\n'
+              % (stats['irq_count'],
+                 100.0 * stats['irq_cycles'] / (elapsed * mck),
+                 1e6 * stats['irq_max_cycles'] / mck))
+
+
+def run(name, dev, transfer, count, out=sys.stdout):
+    """Times count calls of transfer(), which returns the bytes moved."""
+    latencies = []
+    moved = 0
+    get_stats(dev, reset=True)
+    start = time.time()
+    for _ in range(count):
+        begin = time.time()
+        moved += transfer()
+        latencies.append(time.time() - begin)
+    elapsed = time.time() - start
+    show(name, moved, elapsed, latencies, get_stats(dev), out)
+
+
+def bench_sourcesink(options):
+    dev = find_device(PRODUCTS['sourcesink'])
+    dev.set_configuration()
+    dev.set_interface_altsetting(0, SETTING_SOURCESINK)
+    data = bytearray(options.size or 4096)
+    run('sink (OUT)', dev, lambda: dev.write(0x01, data, timeout=1000),
+        options.count)
+    run('source (IN)', dev,
+        lambda: len(dev.read(0x82, len(data), timeout=1000)), options.count)
+
+
+def bench_vloop(options):
+    dev = find_device(PRODUCTS['vloop'])
+    dev.set_configuration()
+    dev.set_interface_altsetting(0, SETTING_LOOPBACK)
+    data = bytearray(range(PACKET_SIZE))
+
+    def echo():
+        dev.write(0x01, data, timeout=1000)
+        return 2 * len(dev.read(0x82, PACKET_SIZE, timeout=1000))
+    run('vendor loopback', dev, echo, options.count)
+
+
+def bench_cdc(options):
+    import serial
+    if not options.port:
+        raise SystemExit('give the CDC serial port with --port')
+    dev = find_device(PRODUCTS['cdc'])
+    port = serial.Serial(options.port, timeout=1)
+    data = bytes(bytearray(range(PACKET_SIZE)))
+
+    def echo():
+        port.write(data)
+        back = port.read(len(data))
+        if len(back) != len(data):
+            raise SystemExit('CDC loopback timeout')
+        return 2 * len(back)
+    run('CDC loopback', dev, echo, options.count)
+
+
+def bench_msd(options):
+    if not options.disk:
+        raise SystemExit('give the block device of the RAM disk with --disk')
+    dev = find_device(PRODUCTS['msd'])
+    size = options.size or 4096
+    fd = os.open(options.disk, os.O_RDWR if options.write else os.O_RDONLY)
+    disk_size = os.lseek(fd, 0, os.SEEK_END)
+    state = {'offset': 0}
+    data = b'\x55' * size
+
+    def transfer():
+        if state['offset'] + size > disk_size:
+            state['offset'] = 0
+        # Drop the host cache so that every read reaches the device
+        if hasattr(os, 'posix_fadvise'):
+            os.posix_fadvise(fd, state['offset'], size, os.POSIX_FADV_DONTNEED)
+        os.lseek(fd, state['offset'], os.SEEK_SET)
+        if options.write:
+            moved = os.write(fd, data)
+            os.fsync(fd)
+        else:
+            moved = len(os.read(fd, size))
+        state['offset'] += size
+        return moved
+    run('MSD ' + ('write' if options.write else 'read'), dev, transfer,
+        options.count)
+    os.close(fd)
+
+
+def bench_hid(options):
+    import usb.util
+    dev = find_device(PRODUCTS['hid'])
+    if dev.is_kernel_driver_active(0):
+        dev.detach_kernel_driver(0)
+    intf = dev.get_active_configuration()[(0, 0)]
+
+    def endpoint(direction):
+        return usb.util.find_descriptor(intf, custom_match=lambda e:
+            usb.util.endpoint_direction(e.bEndpointAddress) == direction)
+    ep_in = endpoint(usb.util.ENDPOINT_IN)
+    ep_out = endpoint(usb.util.ENDPOINT_OUT)
+    data = bytearray(range(HID_REPORT_SIZE))
+
+    def echo():
+        ep_out.write(data, timeout=1000)
+        return 2 * len(ep_in.read(HID_REPORT_SIZE, timeout=1000))
+    run('HID echo', dev, echo, options.count)
+    usb.util.dispose_resources(dev)
+
+
+BENCHES = {'sourcesink': bench_sourcesink, 'vloop': bench_vloop,
+           'cdc': bench_cdc, 'msd': bench_msd, 'hid': bench_hid}
+
+
+def main(argv):
+    import optparse
+    parser = optparse.OptionParser(
+        usage='%prog [options] ' + '|'.join(sorted(BENCHES)))
+    parser.add_option('-n', '--count', type='int', default=1000,
+                      help='transfers or round trips [%default]')
+    parser.add_option('-s', '--size', type='int', default=0,
+                      help='bytes per stream transfer [4096]')
+    parser.add_option('-p', '--port', help='CDC serial port (cdc)')
+    parser.add_option('-d', '--disk', help='RAM disk block device (msd)')
+    parser.add_option('-w', '--write', action='store_true', default=False,
+                      help='measure the writes instead of the reads (msd)')
+    (options, args) = parser.parse_args(argv[1:])
+
+    if len(args) != 1 or args[0] not in BENCHES:
+        parser.error('give one of ' + ', '.join(sorted(BENCHES)))
+    BENCHES[args[0]](options)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
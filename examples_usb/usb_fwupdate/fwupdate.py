@@ -0,0 +1,95 @@
+#!/usr/bin/env python
+# ----------------------------------------------------------------------------
+#         ATMEL Microcontroller Software Support
+# ----------------------------------------------------------------------------
+# Copyright (c) 2010, Atmel Corporation
+#
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# - Redistributions of source code must retain the above copyright notice,
+# this list of conditions and the disclaimer below.
+#
+# Atmel's name may not be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+# IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+# DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+# OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+# EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+# ----------------------------------------------------------------------------
+
+"""Host side of the usb_fwupdate example: sends a binary image to the board
+through its CDC serial port. Needs pyserial.
+
+    fwupdate.py --port /dev/ttyACM0 new_firmware.bin
+
+The header carries the image size and the CRC the CRCCU computes over the
+image, i.e. the complement of the zlib CRC-32. Each step is answered by one
+status byte, a FWUPD_xxx code of fwupdate.h.
+"""
+
+import struct
+import sys
+import time
+import zlib
+
+FWUPD_MAGIC = b'FWUP'
+
+STATUS_NAMES = {0: 'ok', 1: 'size error', 2: 'sequence error',
+                3: 'flash error', 4: 'CRC mismatch'}
+
+
+def crccu_crc(data):
+    """CRCCU_SR value after a CCIT802.3 computation from the reset value."""
+    return (zlib.crc32(data) & 0xFFFFFFFF) ^ 0xFFFFFFFF
+
+
+def read_status(port):
+    status = port.read(1)
+    if not status:
+        raise SystemExit('no answer from the board')
+    status = ord(status)
+    return status, STATUS_NAMES.get(status, 'error %d' % status)
+
+
+def main(argv):
+    import optparse
+    import serial
+    parser = optparse.OptionParser(usage='%prog --port PORT image.bin')
+    parser.add_option('-p', '--port', help='CDC serial port of the board')
+    parser.add_option('-t', '--timeout', type='float', default=30.0,
+                      help='seconds to wait for an answer [%default]')
+    (options, args) = parser.parse_args(argv[1:])
+
+    if len(args) != 1 or not options.port:
+        parser.error('give the serial port and the image')
+    data = open(args[0], 'rb').read()
+
+    port = serial.Serial(options.port, timeout=options.timeout)
+    port.write(FWUPD_MAGIC + struct.pack('<II', len(data), crccu_crc(data)))
+    status, name = read_status(port)
+    if status:
+        print('header refused: %s' % name)
+        return 1
+
+    start = time.time()
+    port.write(data)
+    status, name = read_status(port)
+    elapsed = time.time() - start
+
+    print('%d bytes staged in %.2f s (%.1f KB/s): %s' %
+          (len(data), elapsed, len(data) / 1024.0 / elapsed, name))
+    return status and 1 or 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,477 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page usb_fwupdate USB Firmware Update Example
+ *
+ * \section Purpose
+ *
+ * The USB Firmware Update example shows how to use the firmware update
+ * engine (\ref fwupdate.h) to replace the application in the internal flash
+ * with an image streamed through a USB CDC serial port.
+ *
+ * \section Requirements
+ *
+ * This package can be used with SAM3S evaluation kits. The example binary
+ * must fit in the lower half of the internal flash.
+ *
+ * \section Description
+ *
+ * The device enumerates as the CDC serial port of the usb_cdc_serial example.
+ * The host sends a 12-byte header, the "FWUP" magic, then the image size and
+ * the image CRC as little-endian 32-bit words, and gets one status byte back
+ * (a FWUPD_xxx code). The image follows, and once it is staged and checked, a
+ * second status byte is sent and the image is installed.
+ *
+ * The image is received in two buffers of FWUPD_CHUNK_SIZE bytes: the read of
+ * the next chunk is queued before the current one is given to FWUPD_Write(),
+ * so the host keeps sending while the flash pages are programmed, and no RAM
+ * copy of the image is needed.
+ *
+ * Other sources use the same sequence. With FatFs, for instance, call
+ * FWUPD_Write() with each block returned by f_read() on the image file.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it inside the evaluation board. Please
+ *    refer to the
+ *    <a href="http://www.atmel.com/dyn/resources/prod_documents/doc6421.pdf">
+ *    SAM-BA User Guide</a>, the
+ *    <a href="http://www.atmel.com/dyn/resources/prod_documents/doc6310.pdf">
+ *    GNU-Based Software Development</a> application note or to the
+ *    <a href="ftp://ftp.iar.se/WWWfiles/arm/Guides/EWARM_UserGuide.ENU.pdf">
+ *    IAR EWARM User Guide</a>, depending on your chosen solution.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 bauds
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application.
+ * -# In the terminal window, the following text should appear:
+ *     \code
+ *     -- USB Firmware Update Example xxx --
+ *     -- xxxxxx-xx
+ *     -- Compiled: xxx xx xxxx xx:xx:xx --
+ *     \endcode
+ * -# Connect the USB cable and send the new binary with the fwupdate.py
+ *    script of this directory:
+ *     \code
+ *     fwupdate.py --port /dev/ttyACM0 new_firmware.bin
+ *     \endcode
+ * -# The board resets and runs the new firmware. Would the copy be
+ *    interrupted, the board boots the SAM-BA monitor instead, from which the
+ *    flash can be programmed again.
+ */
+
+/**
+ * \file
+ *
+ * This file contains all the specific code for the
+ * usb_fwupdate example.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include "board.h"
+
+#include "CDCDSerialDriver.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *      Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Size of each receive buffer, a multiple of the endpoint size */
+#define FWUPD_CHUNK_SIZE    1024
+
+/** Header magic, "FWUP" */
+#define FWUPD_MAGIC         0x50555746
+
+/** Size of the header */
+#define FWUPD_HEADER_SIZE   12
+
+/** Value of rxLength[] while the buffer is not filled */
+#define RX_PENDING          0xFFFFFFFF
+
+/*----------------------------------------------------------------------------
+ *      External variables
+ *----------------------------------------------------------------------------*/
+
+extern const USBDDriverDescriptors cdcdSerialDriverDescriptors;
+
+/*----------------------------------------------------------------------------
+ *      Internal variables
+ *----------------------------------------------------------------------------*/
+
+/** Receive buffers, word aligned for the header decoding */
+static uint32_t rxBuffers[2][FWUPD_CHUNK_SIZE/4];
+
+/** Bytes received in each buffer, RX_PENDING while being filled */
+static volatile uint32_t rxLength[2] = {RX_PENDING, RX_PENDING};
+
+/** Buffer holding the next chunk */
+static uint8_t rxCurrent = 0;
+
+/** Image size announced by the header, 0 while waiting for a header */
+static uint32_t imageSize = 0;
+
+/** Image bytes requested from the host */
+static uint32_t imageRequested = 0;
+
+/** Image bytes received from the host */
+static uint32_t imageReceived = 0;
+
+/** First error of the update, FWUPD_OK if none */
+static uint32_t imageStatus = FWUPD_OK;
+
+/** Status byte sent to the host */
+static uint8_t txStatus;
+
+/** Set when the status byte is sent */
+static volatile uint8_t txDone = 0;
+
+/*----------------------------------------------------------------------------
+ *         VBus monitoring
+ *----------------------------------------------------------------------------*/
+
+/** VBus pin instance. */
+static const Pin pinVbus = PIN_USB_VBUS;
+
+/**
+ * Handles interrupts coming from PIO controllers.
+ */
+static void ISR_Vbus(const Pin *pPin)
+{
+    /* Check current level on VBus */
+    if (PIO_Get(&pinVbus)) {
+
+        TRACE_INFO("VBUS conn\n\r");
+        USBD_Connect();
+    }
+    else {
+
+        TRACE_INFO("VBUS discon\n\r");
+        USBD_Disconnect();
+    }
+}
+
+/**
+ * Configures the VBus pin to trigger an interrupt when the level on that pin
+ * changes.
+ */
+static void VBus_Configure( void )
+{
+    TRACE_INFO("VBus configuration\n\r");
+
+    /* Configure PIO */
+    PIO_Configure(&pinVbus, 1);
+    PIO_ConfigureIt(&pinVbus, ISR_Vbus);
+    PIO_EnableIt(&pinVbus);
+
+    /* Check current level on VBus */
+    if (PIO_Get(&pinVbus)) {
+
+        /* if VBUS present, force the connect */
+        TRACE_INFO("conn\n\r");
+        USBD_Connect();
+    }
+    else {
+        USBD_Disconnect();
+    }
+}
+
+/*----------------------------------------------------------------------------
+ *         Internal functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * Callback invoked when a receive buffer is filled.
+ * \param index  Index of the buffer.
+ */
+static void _UsbDataReceived(uint32_t index,
+                             uint8_t status,
+                             uint32_t received,
+                             uint32_t remaining)
+{
+    rxLength[index] = (status == USBD_STATUS_SUCCESS) ? received : 0;
+}
+
+/**
+ * Callback invoked when the status byte has been sent.
+ */
+static void _UsbDataSent(void)
+{
+    txDone = 1;
+}
+
+/**
+ * Queues the read of a buffer.
+ * \param index  Index of the buffer.
+ * \param size  Bytes to read.
+ */
+static void _Receive(uint8_t index, uint32_t size)
+{
+    rxLength[index] = RX_PENDING;
+    if (CDCDSerialDriver_Read(rxBuffers[index], size,
+                              (TransferCallback) _UsbDataReceived,
+                              (void*)(uint32_t)index) != USBD_STATUS_SUCCESS) {
+
+        rxLength[index] = 0;
+    }
+}
+
+/**
+ * Sends a status byte to the host and waits for its end.
+ * \param status  FWUPD_xxx code.
+ */
+static void _SendStatus(uint32_t status)
+{
+    txStatus = (uint8_t)status;
+    txDone = 0;
+    if (CDCDSerialDriver_Write(&txStatus, 1,
+                               (TransferCallback) _UsbDataSent,
+                               0) == USBD_STATUS_SUCCESS) {
+
+        while (!txDone);
+    }
+}
+
+/**
+ * Waits for the next header.
+ */
+static void _Restart(void)
+{
+    imageSize = 0;
+    rxCurrent = 0;
+    _Receive(0, FWUPD_HEADER_SIZE);
+}
+
+/**
+ * Decodes a header and starts the update.
+ * \param length  Bytes received.
+ */
+static void _ProcessHeader(uint32_t length)
+{
+    uint32_t *pHeader = rxBuffers[rxCurrent];
+    uint32_t status;
+
+    if ((length != FWUPD_HEADER_SIZE) || (pHeader[0] != FWUPD_MAGIC)) {
+
+        TRACE_WARNING("Bad header\n\r");
+        _SendStatus(FWUPD_ERROR_STATE);
+        _Restart();
+        return;
+    }
+
+    status = FWUPD_Begin(pHeader[1], pHeader[2]);
+    _SendStatus(status);
+    if (status != FWUPD_OK) {
+
+        _Restart();
+        return;
+    }
+
+    printf("-I- Receiving %u bytes\n\r", (unsigned int)pHeader[1]);
+    imageSize = pHeader[1];
+    imageReceived = 0;
+    imageStatus = FWUPD_OK;
+    imageRequested = min(FWUPD_CHUNK_SIZE, imageSize);
+    rxCurrent = 0;
+    _Receive(0, imageRequested);
+}
+
+/**
+ * Stages a received chunk, the next one being received meanwhile. After an
+ * error, the rest of the image is still received, and dropped, before
+ * reporting it.
+ * \param length  Bytes received.
+ */
+static void _ProcessChunk(uint32_t length)
+{
+    uint8_t index = rxCurrent;
+    uint32_t size;
+
+    if (length == 0) {
+
+        /* Transfer failed, the host has to start again */
+        FWUPD_Abort();
+        _SendStatus(FWUPD_ERROR_SIZE);
+        _Restart();
+        return;
+    }
+    imageReceived += length;
+
+    /* Keep the host sending while the flash is programmed */
+    if (imageRequested < imageSize) {
+
+        size = min(FWUPD_CHUNK_SIZE, imageSize - imageRequested);
+        imageRequested += size;
+        _Receive(1 - index, size);
+    }
+    rxCurrent = 1 - index;
+
+    if (imageStatus == FWUPD_OK)
+        imageStatus = FWUPD_Write(rxBuffers[index], length);
+
+    if (imageReceived < imageSize)
+        return;
+
+    if (imageStatus == FWUPD_OK)
+        imageStatus = FWUPD_End();
+    else
+        FWUPD_Abort();
+
+    printf("-I- Update status %u\n\r", (unsigned int)imageStatus);
+    _SendStatus(imageStatus);
+
+    if (imageStatus == FWUPD_OK) {
+
+        printf("-I- Installing\n\r");
+        USBD_Disconnect();
+        FWUPD_Install();
+        printf("-E- Install failed\n\r");
+        USBD_Connect();
+    }
+    _Restart();
+}
+
+/**
+ * \brief Configure 48MHz Clock for USB
+ */
+static void _ConfigureUsbClock(void)
+{
+    /* Enable PLLB for USB */
+    PMC->CKGR_PLLBR = CKGR_PLLBR_DIVB(1)
+                    | CKGR_PLLBR_MULB(7)
+                    | CKGR_PLLBR_PLLBCOUNT_Msk;
+    while((PMC->PMC_SR & PMC_SR_LOCKB) == 0);
+    /* USB Clock uses PLLB */
+    PMC->PMC_USB = PMC_USB_USBDIV(1)       /* /2   */
+                 | PMC_USB_USBS;           /* PLLB */
+}
+
+/*-----------------------------------------------------------------------------
+ *         Callback re-implementation
+ *-----------------------------------------------------------------------------*/
+
+/**
+ * Invoked after the USB driver has been initialized. By default, configures
+ * the UDP/UDPHS interrupt.
+ */
+void USBDCallbacks_Initialized(void)
+{
+    NVIC_EnableIRQ(UDP_IRQn);
+}
+
+/**
+ * Invoked when the configuration of the device changes. Starts waiting for
+ * a header.
+ * \param cfgnum New configuration number.
+ */
+void USBDDriverCallbacks_ConfigurationChanged(unsigned char cfgnum)
+{
+    CDCDSerialDriver_ConfigurationChangedHandler(cfgnum);
+
+    if (cfgnum > 0) {
+
+        if (imageSize)
+            FWUPD_Abort();
+        _Restart();
+    }
+}
+
+/**
+ * Invoked when a new SETUP request is received from the host. Forwards the
+ * request to the CDC serial device driver handler function.
+ * \param request  Pointer to a USBGenericRequest instance.
+ */
+void USBDCallbacks_RequestReceived(const USBGenericRequest *request)
+{
+    CDCDSerialDriver_RequestHandler(request);
+}
+
+/*----------------------------------------------------------------------------
+ *          Main
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief usb_fwupdate Application entry point.
+ *
+ * Initializes the flash and USB drivers and stages the images sent by the
+ * host.
+ *
+ * \return Unused (ANSI-C compatibility).
+ */
+int main(void)
+{
+    uint32_t length;
+
+    /* Disable watchdog */
+    WDT_Disable( WDT );
+
+    /* Output example information */
+    printf("-- USB Firmware Update Example %s --\n\r", SOFTPACK_VERSION);
+    printf("-- %s\n\r", BOARD_NAME);
+    printf("-- Compiled: %s %s --\n\r", __DATE__, __TIME__);
+
+    /* Flash driver, programming from RAM */
+    FLASHD_Initialize(BOARD_MCK, 0);
+
+    /* If they are present, configure Vbus & Wake-up pins */
+    PIO_InitializeInterrupts(0);
+
+    /* Enable UPLL for USB */
+    _ConfigureUsbClock();
+
+    /* CDC serial driver initialization */
+    CDCDSerialDriver_Initialize(&cdcdSerialDriverDescriptors);
+
+    /* connect if needed */
+    VBus_Configure();
+
+    /* Infinite loop */
+    while (1) {
+
+        length = rxLength[rxCurrent];
+        if (length == RX_PENDING)
+            continue;
+
+        if (imageSize == 0)
+            _ProcessHeader(length);
+        else
+            _ProcessChunk(length);
+    }
+}
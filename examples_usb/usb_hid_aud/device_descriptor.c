@@ -376,6 +376,25 @@ const unsigned char *stringDescriptors[] = {
     serialNumberDescriptor,
 };
 
+/** Interfaces and endpoints of each function, written with the same
+ *  defines as the descriptors above. */
+static const USBDFunctionMap functionMaps[] = {
+
+    /* HID keyboard function */
+    {
+        HIDAUDDDriverDescriptors_HID_INTERFACE, 1,
+        HIDD_Descriptors_INTERRUPTIN, HIDD_Descriptors_INTERRUPTOUT,
+        0, sizeof(HIDDKeyboardInputReport),
+        (const USBGenericDescriptor *) &fsConfigurationDescriptors.hid
+    },
+    /* Audio function: control and speaker streaming interfaces */
+    {
+        HIDAUDDDriverDescriptors_AUD_INTERFACE, 2,
+        0, AUDD_Descriptors_DATAOUT,
+        0, 0, 0
+    }
+};
+
 /*----------------------------------------------------------------------------
  *         Exported functions
  *----------------------------------------------------------------------------*/
@@ -387,7 +406,8 @@ const USBDDriverDescriptors hidauddDriverDescriptors = {
     (const USBConfigurationDescriptor *) &fsConfigurationDescriptors,
     0, 0, 0, 0, 0, 0,
     stringDescriptors,
-    4 /* Number of string descriptors */
+    4, /* Number of string descriptors */
+    functionMaps
 };
 
 /**@}*/
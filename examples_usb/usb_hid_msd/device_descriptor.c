@@ -258,6 +258,25 @@ static const unsigned char *stringDescriptors[] = {
     serialNumberDescriptor,
 };
 
+/** Interfaces and endpoints of each function, written with the same
+ *  defines as the descriptors above. */
+static const USBDFunctionMap functionMaps[] = {
+
+    /* HID keyboard function */
+    {
+        HIDMSDDriverDescriptors_HID_INTERFACE, 1,
+        HIDD_Descriptors_INTERRUPTIN, HIDD_Descriptors_INTERRUPTOUT,
+        0, sizeof(HIDDKeyboardInputReport),
+        (const USBGenericDescriptor *) &configurationDescriptorsFS.hid
+    },
+    /* Mass Storage function */
+    {
+        HIDMSDDriverDescriptors_MSD_INTERFACE, 1,
+        MSDD_Descriptors_BULKIN, MSDD_Descriptors_BULKOUT,
+        0, 0, 0
+    }
+};
+
 /*----------------------------------------------------------------------------
  *         Exported variables
  *----------------------------------------------------------------------------*/
@@ -269,7 +288,8 @@ const USBDDriverDescriptors hidmsddDriverDescriptors = {
     (const USBConfigurationDescriptor *) &configurationDescriptorsFS,
     0, 0, 0, 0, 0, 0,
     stringDescriptors,
-    4 /* Number of string descriptors */
+    4, /* Number of string descriptors */
+    functionMaps
 };
 /**@}*/
 
@@ -244,7 +244,7 @@ Media medias[MAX_LUNS];
 MSDLun luns[MAX_LUNS];
 
 /** LUN read/write buffer. */
-uint8_t msdBuffer[MSD_BUFFER_SIZE];
+BOARD_NOINIT_SECTION uint8_t msdBuffer[MSD_BUFFER_SIZE];
 
 /** Total data write to disk */
 uint32_t msdWriteTotal = 0;
@@ -441,6 +441,24 @@ const unsigned char *stringDescriptors[] = {
     serialNumberDescriptor,
 };
 
+/** Interfaces and endpoints of each function, written with the same
+ *  defines as the descriptors above. */
+static const USBDFunctionMap functionMaps[] = {
+
+    /* CDC serial function */
+    {
+        CDCAUDDDriverDescriptors_CDC_INTERFACE, 2,
+        CDCD_Descriptors_DATAIN0, CDCD_Descriptors_DATAOUT0,
+        CDCD_Descriptors_NOTIFICATION0, 0, 0
+    },
+    /* Audio function: control and speaker streaming interfaces */
+    {
+        CDCAUDDDriverDescriptors_AUD_INTERFACE, 2,
+        0, AUDD_Descriptors_DATAOUT,
+        0, 0, 0
+    }
+};
+
 /*------------------------------------------------------------------------------
  *         Exported functions
  *------------------------------------------------------------------------------*/
@@ -452,7 +470,8 @@ const USBDDriverDescriptors cdcauddDriverDescriptors = {
     (const USBConfigurationDescriptor *) &fsConfigurationDescriptors,
     0, 0, 0, 0, 0, 0,
     stringDescriptors,
-    4 /* Number of string descriptors */
+    4, /* Number of string descriptors */
+    functionMaps
 };
 
 /**@}*/
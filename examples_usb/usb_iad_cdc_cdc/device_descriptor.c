@@ -376,6 +376,24 @@ static const unsigned char *stringDescriptors[] = {
     serialNumberDescriptor,
 };
 
+/// Interfaces and endpoints of each function, written with the same
+/// defines as the descriptors above.
+static const USBDFunctionMap functionMaps[] = {
+
+    // CDC serial port 0
+    {
+        DUALCDCDDriverDescriptors_INTERFACENUM0, 2,
+        CDCD_Descriptors_DATAIN0, CDCD_Descriptors_DATAOUT0,
+        CDCD_Descriptors_NOTIFICATION0, 0, 0
+    },
+    // CDC serial port 1
+    {
+        DUALCDCDDriverDescriptors_INTERFACENUM1, 2,
+        CDCD_Descriptors_DATAIN1, CDCD_Descriptors_DATAOUT1,
+        CDCD_Descriptors_NOTIFICATION1, 0, 0
+    }
+};
+
 //------------------------------------------------------------------------------
 //         Exported variables
 //------------------------------------------------------------------------------
@@ -387,7 +405,8 @@ const USBDDriverDescriptors dualcdcdDriverDescriptors = {
     (const USBConfigurationDescriptor *) &configurationDescriptorsFS,
     0, 0, 0, 0, 0, 0,
     stringDescriptors,
-    4 // Number of string descriptors
+    4, // Number of string descriptors
+    functionMaps
 };
 /**@}*/
 
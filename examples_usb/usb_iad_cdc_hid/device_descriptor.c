@@ -332,6 +332,25 @@ static const unsigned char *stringDescriptors[] = {
     serialNumberDescriptor,
 };
 
+/** Interfaces and endpoints of each function, written with the same
+ *  defines as the descriptors above. */
+static const USBDFunctionMap functionMaps[] = {
+
+    /* CDC serial function */
+    {
+        CDCHIDDDriverDescriptors_CDC_INTERFACE, 2,
+        CDCD_Descriptors_DATAIN0, CDCD_Descriptors_DATAOUT0,
+        CDCD_Descriptors_NOTIFICATION0, 0, 0
+    },
+    /* HID keyboard function */
+    {
+        CDCHIDDDriverDescriptors_HID_INTERFACE, 1,
+        HIDD_Descriptors_INTERRUPTIN, HIDD_Descriptors_INTERRUPTOUT,
+        0, sizeof(HIDDKeyboardInputReport),
+        (const USBGenericDescriptor *) &configurationDescriptorsFS.hid
+    }
+};
+
 /*----------------------------------------------------------------------------
  *         Exported variables
  *----------------------------------------------------------------------------*/
@@ -343,7 +362,8 @@ const USBDDriverDescriptors cdchiddDriverDescriptors = {
     (const USBConfigurationDescriptor *) &configurationDescriptorsFS,
     0, 0, 0, 0, 0, 0,
     stringDescriptors,
-    4 /* Number of string descriptors */
+    4, /* Number of string descriptors */
+    functionMaps
 };
 /**@}*/
 
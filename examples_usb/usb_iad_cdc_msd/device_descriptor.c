@@ -309,6 +309,24 @@ static const unsigned char *stringDescriptors[] = {
     serialNumberDescriptor,
 };
 
+/** Interfaces and endpoints of each function, written with the same
+ *  defines as the descriptors above. */
+static const USBDFunctionMap functionMaps[] = {
+
+    /* CDC serial function */
+    {
+        CDCMSDDriverDescriptors_CDC_INTERFACE, 2,
+        CDCD_Descriptors_DATAIN0, CDCD_Descriptors_DATAOUT0,
+        CDCD_Descriptors_NOTIFICATION0, 0, 0
+    },
+    /* Mass Storage function */
+    {
+        CDCMSDDriverDescriptors_MSD_INTERFACE, 1,
+        MSDD_Descriptors_BULKIN, MSDD_Descriptors_BULKOUT,
+        0, 0, 0
+    }
+};
+
 /*----------------------------------------------------------------------------
  *         Exported variables
  *----------------------------------------------------------------------------*/
@@ -320,7 +338,8 @@ const USBDDriverDescriptors cdcmsddDriverDescriptors = {
     (const USBConfigurationDescriptor *) &configurationDescriptorsFS,
     0, 0, 0, 0, 0, 0,
     stringDescriptors,
-    4 /* Number of string descriptors */
+    4, /* Number of string descriptors */
+    functionMaps
 };
 /**@}*/
 
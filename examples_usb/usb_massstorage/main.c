@@ -69,6 +69,11 @@
  * If there is no SDRAM but only internal flash, the disk is about 30K and
  * only small file can be tested.
  *
+ * On the SAM3S-EK, the first disk is a RAM disk in the external PSRAM, a
+ * fast scratch drive which wears no flash. Built with RAMDISK_COMPRESSED=1,
+ * it keeps its blocks compressed and shows RAMDISK_LZ_SIZE bytes to the
+ * host, as long as the data written fits the PSRAM once compressed.
+ *
  * \section Usage
  *
  * -# Build the program and download it inside the evaluation board. Please
@@ -160,6 +165,14 @@
 /* Ramdisk size: 20K (WinXP can not format the disk if lower than 20K) */
 /* #define RAMDISK_SIZE    (20*1024) */
 
+/** 1 to keep the PSRAM RAM disk blocks compressed */
+#ifndef RAMDISK_COMPRESSED
+#define RAMDISK_COMPRESSED  0
+#endif
+
+/** Size of the compressed RAM disk seen by the host (4M) */
+#define RAMDISK_LZ_SIZE     (4*1024*1024)
+
 /** Size of the reserved Nand Flash (4M) */
 #define NF_RESERVE_SIZE     (4*1024*1024)
 
@@ -184,7 +197,7 @@ Media medias[MAX_LUNS];
 MSDLun luns[MAX_LUNS];
 
 /** LUN read/write buffer. */
-uint8_t msdBuffer[MSD_BUFFER_SIZE];
+BOARD_NOINIT_SECTION uint8_t msdBuffer[MSD_BUFFER_SIZE];
 
 /** Total data read/write by MSD */
 unsigned int msdReadTotal = 0;
@@ -213,6 +226,16 @@ static const Pin nfCePin = BOARD_NF_CE_PIN;
 /** Nandflash ready/busy pin. */
 static const Pin nfRbPin = BOARD_NF_RB_PIN;
 
+/** Pins used to access to the PSRAM. */
+static const Pin pPinsPsram[] = {PIN_EBI_DATA_BUS, PIN_EBI_NRD, PIN_EBI_NWE,
+                                 PIN_EBI_NCS1, PIN_EBI_PSRAM_ADDR_BUS,
+                                 PIN_EBI_PSRAM_NBS};
+
+#if RAMDISK_COMPRESSED == 1
+/** Compressed RAM disk tables. */
+static MEDRamDiskLz ramDiskLz;
+#endif
+
 /*----------------------------------------------------------------------------
  *        VBus monitoring (optional)
  *----------------------------------------------------------------------------*/
@@ -470,6 +493,9 @@ static void NandFlashInitialize(void)
     /* Media initialize */
     MEDNandFlash_Initialize(&medias[DRV_NAND], &translatedNf);
 
+    /* Background erases complete on the ready/busy interrupt */
+    RawNandFlash_ConfigureReadyInterrupt(pRaw);
+
     /* Initialize LUN */
     LUN_Init(&(luns[DRV_NAND]), &(medias[DRV_NAND]),
              msdBuffer, MSD_BUFFER_SIZE,
@@ -477,6 +503,57 @@ static void NandFlashInitialize(void)
              MSDCallbacks_Data);
 }
 
+/**
+ * Initialize the PSRAM RAM disk for LUN, in the PSRAM left after the
+ * allocations.
+ */
+static void RamDiskInitialize(void)
+{
+    uint32_t dwSize;
+    uint32_t dwSkip;
+    uint8_t *pDisk;
+
+    /* Configure SMC and PIO for the PSRAM */
+    PIO_Configure(pPinsPsram, PIO_LISTSIZE(pPinsPsram));
+    BOARD_ConfigurePSRAM(SMC);
+
+    dwSize = BOARD_PsramGetFreeSize();
+    pDisk = (uint8_t*)BOARD_PsramAlloc(dwSize);
+    if (pDisk == 0) {
+        printf("PSRAM not available\n\r");
+        return;
+    }
+
+#if RAMDISK_COMPRESSED == 1
+    if (!MEDRamDisk_InitializeCompressed(&medias[DRV_RAMDISK], &ramDiskLz,
+                                         BLOCK_SIZE, pDisk, dwSize,
+                                         RAMDISK_LZ_SIZE / BLOCK_SIZE)) {
+        printf("RAM disk init error\n\r");
+        return;
+    }
+    printf("RAM disk %dK, compressed in %dK of PSRAM\n\r",
+           RAMDISK_LZ_SIZE / 1024, MEDRamDisk_GetPoolFree(&ramDiskLz) / 1024);
+#else
+    /* The disk address is given in blocks */
+    dwSkip = (BLOCK_SIZE - (uint32_t)pDisk % BLOCK_SIZE) % BLOCK_SIZE;
+    pDisk += dwSkip;
+    dwSize -= dwSkip;
+    if (!MEDRamDisk_Initialize(&medias[DRV_RAMDISK], BLOCK_SIZE,
+                               (uint32_t)pDisk / BLOCK_SIZE,
+                               dwSize / BLOCK_SIZE)) {
+        printf("RAM disk init error\n\r");
+        return;
+    }
+    printf("RAM disk %dK in PSRAM\n\r", dwSize / 1024);
+#endif
+
+    /* Initialize LUN */
+    LUN_Init(&(luns[DRV_RAMDISK]), &(medias[DRV_RAMDISK]),
+             msdBuffer, MSD_BUFFER_SIZE,
+             0, 0, 0, 0,
+             MSDCallbacks_Data);
+}
+
 /**
  * \brief Initialize all medias and LUNs.
  */
@@ -488,6 +565,9 @@ static void MemoryInitialization(void)
 
     // TODO: Add LUN Init here
 
+    /* PSRAM RAM disk Init */
+    RamDiskInitialize();
+
     /* Nand Flash Init */
     NandFlashInitialize();
 }
@@ -546,8 +626,12 @@ int main( void )
 
             updateView = 0;
 
-            if (msdWriteTotal < 50 * 1000)
+            /* Host mostly idle: save pending data and erase blocks ahead */
+            if (msdWriteTotal < 50 * 1000) {
+
                 MED_Flush(&medias[DRV_NAND]);
+                TranslatedNandFlash_CollectGarbage(&translatedNf, 4);
+            }
 
             printf("Read %5dK, Write %5dK, IO %5dK; Null %4d, Full %4d\r",
                 msdReadTotal/(UPDATE_DELAY*250),
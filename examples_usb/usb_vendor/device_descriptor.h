@@ -0,0 +1,71 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Definitions shared by the USB vendor bulk application and its
+ * descriptors.
+ */
+
+#ifndef _VENDOR_DESCRIPTORS_
+#define _VENDOR_DESCRIPTORS_
+
+#include "USBDDriver.h"
+
+/** Bulk OUT endpoint of the vendor interface */
+#define VENDOR_EPOUT                1
+/** Bulk IN endpoint of the vendor interface */
+#define VENDOR_EPIN                 2
+
+/** DeviceInterfaceGUID given to Windows for the WinUSB applications */
+#define VENDOR_INTERFACE_GUID       "{5A0E4E6C-7B1D-4C38-9D3A-2F6B8E1C0A51}"
+
+/** Vendor request (device, IN) returning the DumpStats. Bit 0 of wValue
+ *  clears the statistics once read. */
+#define VENDOR_REQ_GETSTATS         0x01
+
+/** Configuration descriptor list of the vendor bulk device. */
+typedef struct _VendorConfigurationDescriptors {
+
+    /** Standard configuration descriptor. */
+    USBConfigurationDescriptor configuration;
+    /** Vendor interface. */
+    USBInterfaceDescriptor vendor;
+    /** Bulk OUT endpoint descriptor. */
+    USBEndpointDescriptor bulkOut;
+    /** Bulk IN endpoint descriptor. */
+    USBEndpointDescriptor bulkIn;
+
+} __attribute__ ((packed)) VendorConfigurationDescriptors;
+
+/** Vendor bulk Driver Descriptors List */
+extern const USBDDriverDescriptors vendorDriverDescriptors;
+
+#endif // _VENDOR_DESCRIPTORS_
@@ -0,0 +1,483 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page usb_vendor USB Device Vendor Bulk Example
+ *
+ * \section Purpose
+ *
+ * The USB Vendor Bulk Example shows a raw bulk pipe in each direction,
+ * without class protocol, for data dumps running at the full-speed bulk
+ * rate.
+ *
+ * \section Description
+ *
+ * The device has one vendor interface (VENDDFunction) with a bulk OUT and a
+ * bulk IN endpoint. It answers the Microsoft OS descriptors, so that Windows
+ * binds WinUSB to it without any INF file; on the other hosts libusb opens
+ * it directly.
+ *
+ * The bulk IN endpoint streams a dump: the main loop fills the free buffers
+ * with a running 32-bit counter, standing for the captured data, and queues
+ * them on the stream. The bulk OUT endpoint sinks the data sent by the host,
+ * checking that it is a running counter too. The vendor request
+ * VENDOR_REQ_GETSTATS returns the bytes moved and the errors seen.
+ *
+ * The host reads and writes the pipes with vendor_dump.py, which prints the
+ * throughput and checks the counter.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it inside the evaluation board. Please
+ *    refer to the
+ *    <a href="http://www.atmel.com/dyn/resources/prod_documents/doc6224.pdf">
+ *    SAM-BA User Guide</a>, the
+ *    <a href="http://www.atmel.com/dyn/resources/prod_documents/doc6310.pdf">
+ *    GNU-Based Software Development</a> application note or to the
+ *    <a href="ftp://ftp.iar.se/WWWfiles/arm/Guides/EWARM_UserGuide.ENU.pdf">
+ *    IAR EWARM User Guide</a>, depending on your chosen solution.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 bauds
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application.
+ * -# In the terminal window, the following text should appear:
+ *     \code
+ *     -- USB Device Vendor Bulk Example xxx --
+ *     -- xxxxxx-xx
+ *     -- Compiled: xxx xx xxxx xx:xx:xx --
+ *     \endcode
+ * -# Connect the USB cable and run vendor_dump.py on the host, e.g.
+ *    "vendor_dump.py read --size 16M --check" or
+ *    "vendor_dump.py write --size 16M".
+ */
+
+/**
+ * \file
+ *
+ * This file contains all the specific code for the
+ * usb_vendor example.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "board.h"
+
+#include "USBD.h"
+#include "USBDDriver.h"
+#include "VENDDFunction.h"
+#include "device_descriptor.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Size of each dump buffer, multiple of the bulk packet size */
+#define DUMP_BUFFER_SIZE    4096
+
+/** Number of IN buffers, at most VENDDFunction_IN_BUFFERS */
+#define DUMP_IN_BUFFERS     3
+
+/** Number of OUT buffers, at most VENDDFunction_OUT_BUFFERS */
+#define DUMP_OUT_BUFFERS    3
+
+/** Delay between two console reports, in ms */
+#define UPDATE_DELAY        1000
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Figures returned by VENDOR_REQ_GETSTATS, little endian words. */
+typedef struct _DumpStats {
+
+    /** Bytes sent on the bulk IN endpoint */
+    uint32_t dwInBytes;
+    /** Bytes received on the bulk OUT endpoint */
+    uint32_t dwOutBytes;
+    /** Words received which break the running counter */
+    uint32_t dwOutErrors;
+
+} DumpStats;
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Vendor bulk function */
+static VENDDFunction vendd;
+
+/** Dump buffers sent to the host */
+static uint32_t inBuffers[DUMP_IN_BUFFERS][DUMP_BUFFER_SIZE / 4];
+/** IN buffers free for the main loop, one bit per buffer */
+static volatile uint32_t inFree = 0;
+/** Next word of the IN running counter */
+static uint32_t inWord = 0;
+
+/** Buffers receiving the host data */
+static uint32_t outBuffers[DUMP_OUT_BUFFERS][DUMP_BUFFER_SIZE / 4];
+/** OUT buffers to check and requeue by the main loop, one bit per buffer */
+static volatile uint32_t outFull = 0;
+/** Bytes received in each OUT buffer */
+static volatile uint32_t outLength[DUMP_OUT_BUFFERS];
+/** Expected word of the OUT running counter */
+static uint32_t outWord = 0;
+/** 0 until the first OUT word has been seen */
+static volatile uint8_t outSync = 0;
+/** OUT counter errors */
+static volatile uint32_t outErrors = 0;
+
+/** Statistics returned by VENDOR_REQ_GETSTATS */
+static DumpStats dumpStats;
+
+/*----------------------------------------------------------------------------
+ *        VBus monitoring (optional)
+ *----------------------------------------------------------------------------*/
+
+/**  VBus pin instance. */
+static const Pin pinVbus = PIN_USB_VBUS;
+
+/**
+ * \brief Handles interrupts coming from PIO controllers.
+ */
+static void ISR_Vbus(const Pin *pPin)
+{
+    /* Check current level on VBus */
+    if (PIO_Get(&pinVbus)) {
+
+        TRACE_INFO("VBUS conn\n\r");
+        USBD_Connect();
+    }
+    else {
+
+        TRACE_INFO("VBUS discon\n\r");
+        USBD_Disconnect();
+    }
+}
+
+/**
+ * \brief Configures the VBus Pin
+ *
+ * To trigger an interrupt when the level on that pin changes.
+ */
+static void VBus_Configure( void )
+{
+    TRACE_INFO("VBus configuration\n\r");
+
+    /* Configure PIO */
+    PIO_Configure(&pinVbus, 1);
+    PIO_ConfigureIt(&pinVbus, ISR_Vbus);
+    PIO_EnableIt(&pinVbus);
+
+    /* Check current level on VBus */
+    if (PIO_Get(&pinVbus)) {
+
+        /* if VBUS present, force the connect */
+        TRACE_INFO("conn\n\r");
+        USBD_Connect();
+    }
+    else {
+        USBD_Disconnect();
+    }
+}
+
+/*----------------------------------------------------------------------------
+ *        Data pipes
+ *----------------------------------------------------------------------------*/
+
+/**
+ * Invoked when an IN buffer has been sent, gives it back to the main loop.
+ */
+static void _InDone(void *pArg, uint8_t *pBuffer, uint32_t dwLength)
+{
+    uint32_t i = ((uint32_t*)pBuffer - inBuffers[0]) / (DUMP_BUFFER_SIZE / 4);
+
+    inFree |= 1 << i;
+}
+
+/**
+ * Invoked when an OUT buffer has been received, gives it to the main loop.
+ */
+static void _OutDone(void *pArg, uint8_t *pBuffer, uint32_t dwLength)
+{
+    uint32_t i = ((uint32_t*)pBuffer - outBuffers[0]) / (DUMP_BUFFER_SIZE / 4);
+
+    outLength[i] = dwLength;
+    outFull |= 1 << i;
+}
+
+/**
+ * Clears bits of a mask shared with the USB interrupt.
+ */
+static void _ClearBits(volatile uint32_t *pMask, uint32_t dwBits)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    *pMask &= ~dwBits;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * Fills the free IN buffers with the running counter and queues them.
+ */
+static void _ServiceIn(void)
+{
+    uint32_t i, j;
+
+    for (i = 0; i < DUMP_IN_BUFFERS; i ++) {
+
+        if ((inFree & (1 << i)) == 0)
+            continue;
+
+        for (j = 0; j < DUMP_BUFFER_SIZE / 4; j ++)
+            inBuffers[i][j] = inWord + j;
+
+        if (VENDDFunction_Write(&vendd, inBuffers[i], DUMP_BUFFER_SIZE)
+                != USBD_STATUS_SUCCESS)
+            break;
+
+        inWord += DUMP_BUFFER_SIZE / 4;
+        _ClearBits(&inFree, 1 << i);
+    }
+}
+
+/**
+ * Checks the received OUT buffers against the running counter and queues
+ * them again.
+ */
+static void _ServiceOut(void)
+{
+    uint32_t i, j, dwWords;
+
+    for (i = 0; i < DUMP_OUT_BUFFERS; i ++) {
+
+        if ((outFull & (1 << i)) == 0)
+            continue;
+
+        dwWords = outLength[i] / 4;
+        for (j = 0; j < dwWords; j ++) {
+
+            if (outSync && outBuffers[i][j] != outWord)
+                outErrors ++;
+            outWord = outBuffers[i][j] + 1;
+            outSync = 1;
+        }
+
+        if (VENDDFunction_Read(&vendd, outBuffers[i], DUMP_BUFFER_SIZE)
+                != USBD_STATUS_SUCCESS)
+            break;
+
+        _ClearBits(&outFull, 1 << i);
+    }
+}
+
+/**
+ * Handles the vendor requests of the example.
+ * \param request  Pointer to a USBGenericRequest instance.
+ */
+static void _VendorRequest(const USBGenericRequest *request)
+{
+    uint16_t wLength = USBGenericRequest_GetLength(request);
+
+    if (USBGenericRequest_GetRequest(request) != VENDOR_REQ_GETSTATS
+        || USBGenericRequest_GetDirection(request) != USBGenericRequest_IN) {
+
+        USBD_Stall(0);
+        return;
+    }
+
+    dumpStats.dwInBytes = vendd.dwInBytes;
+    dumpStats.dwOutBytes = vendd.dwOutBytes;
+    dumpStats.dwOutErrors = outErrors;
+    if (USBGenericRequest_GetValue(request) & 1) {
+
+        vendd.dwInBytes = 0;
+        vendd.dwOutBytes = 0;
+        outErrors = 0;
+        outSync = 0;
+    }
+    if (wLength > sizeof(DumpStats))
+        wLength = sizeof(DumpStats);
+    USBD_Write(0, &dumpStats, wLength, 0, 0);
+}
+
+/*-----------------------------------------------------------------------------
+ *         Callback re-implementation
+ *-----------------------------------------------------------------------------*/
+
+/**
+ * Invoked after the USB driver has been initialized. By default, configures
+ * the UDP/UDPHS interrupt.
+ */
+void USBDCallbacks_Initialized(void)
+{
+    NVIC_EnableIRQ(UDP_IRQn);
+}
+
+/**
+ * Invoked when a new SETUP request is received from the host. The
+ * Microsoft OS descriptor requests go to the vendor function first.
+ * \param request  Pointer to a USBGenericRequest instance.
+ */
+void USBDCallbacks_RequestReceived(const USBGenericRequest *request)
+{
+    if (VENDDFunction_RequestHandler(&vendd, request) == USBRC_SUCCESS)
+        return;
+
+    if (USBGenericRequest_GetType(request) == USBGenericRequest_VENDOR) {
+
+        _VendorRequest(request);
+        return;
+    }
+
+    USBDDriver_RequestHandler(USBD_GetDriver(), request);
+}
+
+/**
+ * Invoked when the configuration of the device changes. Starts the bulk
+ * pipes, all the buffers being handed to the main loop.
+ * \param cfgnum New configuration number.
+ */
+void USBDDriverCallbacks_ConfigurationChanged(uint8_t cfgnum)
+{
+    USBConfigurationDescriptor *pDesc;
+
+    VENDDFunction_Stop(&vendd);
+    if (cfgnum == 0)
+        return;
+
+    pDesc = USBDDriver_GetCfgDescriptors(USBD_GetDriver(), cfgnum);
+    VENDDFunction_ParseInterfaces(&vendd, (USBGenericDescriptor *)pDesc,
+                                  pDesc->wTotalLength);
+    if (VENDDFunction_Start(&vendd, _InDone, 0, _OutDone, 0)
+            == USBD_STATUS_SUCCESS) {
+
+        inFree = (1 << DUMP_IN_BUFFERS) - 1;
+        outFull = (1 << DUMP_OUT_BUFFERS) - 1;
+    }
+}
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ *  \brief Handler for System Tick interrupt.
+ */
+void SysTick_Handler(void)
+{
+    TimeTick_Increment();
+}
+
+/**
+ * \brief Configure 48MHz Clock for USB
+ */
+static void _ConfigureUsbClock(void)
+{
+    /* Enable PLLB for USB */
+    PMC->CKGR_PLLBR = CKGR_PLLBR_DIVB(1)
+                    | CKGR_PLLBR_MULB(7)
+                    | CKGR_PLLBR_PLLBCOUNT_Msk;
+    while((PMC->PMC_SR & PMC_SR_LOCKB) == 0);
+    /* USB Clock uses PLLB */
+    PMC->PMC_USB = PMC_USB_USBDIV(1)    /* /2   */
+                 | PMC_USB_USBS;        /* PLLB */
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief usb_vendor Application entry point.
+ *
+ * Runs the vendor bulk function, printing the throughput every second.
+ *
+ * \return Unused (ANSI-C compatibility).
+ */
+int main(void)
+{
+    uint32_t dwTick, dwIn = 0, dwOut = 0;
+
+    /* Disable watchdog */
+    WDT_Disable( WDT ) ;
+
+    printf("-- USB Device Vendor Bulk Example %s --\n\r", SOFTPACK_VERSION);
+    printf("-- %s\n\r", BOARD_NAME);
+    printf("-- Compiled: %s %s --\n\r", __DATE__, __TIME__);
+
+    /* If they are present, configure Vbus & Wake-up pins */
+    PIO_InitializeInterrupts(0);
+
+    /* Enable UPLL for USB */
+    _ConfigureUsbClock();
+
+    /* 1ms tick for the console reports */
+    TimeTick_Configure(BOARD_MCK);
+
+    /* Vendor function on interface 0, then the USB driver */
+    VENDDFunction_Initialize(&vendd, USBD_GetDriver(), 0,
+                             VENDOR_INTERFACE_GUID);
+    USBDDriver_Initialize(USBD_GetDriver(), &vendorDriverDescriptors, 0);
+    USBD_Init();
+
+    /* connect if needed */
+    VBus_Configure();
+
+    /* Infinite loop */
+    dwTick = GetTickCount();
+    while (1) {
+
+        if (USBD_GetState() >= USBD_STATE_CONFIGURED) {
+
+            _ServiceIn();
+            _ServiceOut();
+        }
+
+        if (GetTickCount() - dwTick >= UPDATE_DELAY) {
+
+            dwTick += UPDATE_DELAY;
+            printf("IN %u KB/s, OUT %u KB/s, errors %u  \r",
+                   (unsigned int)((vendd.dwInBytes - dwIn) / 1024),
+                   (unsigned int)((vendd.dwOutBytes - dwOut) / 1024),
+                   (unsigned int)outErrors);
+            dwIn = vendd.dwInBytes;
+            dwOut = vendd.dwOutBytes;
+        }
+    }
+}
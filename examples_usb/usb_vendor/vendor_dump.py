@@ -0,0 +1,172 @@
+#!/usr/bin/env python
+# ----------------------------------------------------------------------------
+#         ATMEL Microcontroller Software Support
+# ----------------------------------------------------------------------------
+# Copyright (c) 2010, Atmel Corporation
+#
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# - Redistributions of source code must retain the above copyright notice,
+# this list of conditions and the disclaimer below.
+#
+# Atmel's name may not be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+# IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+# DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+# OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+# EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+# ----------------------------------------------------------------------------
+
+"""Host side of the usb_vendor example: reads the dump streamed on the bulk
+IN endpoint or writes a running counter to the bulk OUT endpoint, printing
+the throughput, and reads the device figures through the vendor request
+VENDOR_REQ_GETSTATS. Needs pyusb; on Windows the device binds to WinUSB by
+itself, through its Microsoft OS descriptors.
+
+    vendor_dump.py read [--size 16M] [--chunk 64K] [--check]
+    vendor_dump.py write [--size 16M] [--chunk 64K]
+    vendor_dump.py stats [--reset]
+
+The device sends a running little endian 32-bit counter and checks that it
+receives one, so that both directions also test the data integrity.
+"""
+
+import struct
+import sys
+import time
+
+VENDOR_ATMEL = 0x03EB
+PRODUCT_VENDOR = 0x6141
+
+VENDOR_EPOUT = 0x01
+VENDOR_EPIN = 0x82
+
+VENDOR_REQ_GETSTATS = 0x01
+STATS = struct.Struct('<3I')
+STATS_FIELDS = ('in_bytes', 'out_bytes', 'out_errors')
+
+
+def find_device():
+    import usb.core
+    dev = usb.core.find(idVendor=VENDOR_ATMEL, idProduct=PRODUCT_VENDOR)
+    if dev is None:
+        raise SystemExit('device %04x:%04x not found'
+                         % (VENDOR_ATMEL, PRODUCT_VENDOR))
+    dev.set_configuration()
+    return dev
+
+
+def get_stats(dev, reset=False):
+    """Returns the device figures as a dict, clearing them if reset."""
+    data = dev.ctrl_transfer(0xC0, VENDOR_REQ_GETSTATS, 1 if reset else 0, 0,
+                             STATS.size)
+    return dict(zip(STATS_FIELDS, STATS.unpack(bytes(bytearray(data)))))
+
+
+def parse_size(text):
+    """Bytes from a count with an optional K or M suffix."""
+    scale = {'K': 1024, 'M': 1024 * 1024}.get(text[-1:].upper(), 1)
+    if scale != 1:
+        text = text[:-1]
+    return int(text) * scale
+
+
+def counter_errors(data, expected):
+    """Counts the words of data breaking the running counter. Returns the
+    error count and the next expected word, None to resynchronise."""
+    words = struct.unpack('<%dI' % (len(data) // 4),
+                          bytes(data[:len(data) & ~3]))
+    errors = 0
+    for word in words:
+        if expected is not None and word != expected:
+            errors += 1
+        expected = (word + 1) & 0xFFFFFFFF
+    return errors, expected
+
+
+def show(name, moved, elapsed, out=sys.stdout):
+    elapsed = elapsed or 1e-9
+    out.write('%s: %d bytes in %.3f s, %.3f MB/s\n'
+              % (name, moved, elapsed, moved / elapsed / 1e6))
+
+
+def dump_read(options):
+    dev = find_device()
+    total = parse_size(options.size)
+    chunk = parse_size(options.chunk)
+    moved = 0
+    errors = 0
+    expected = None
+    start = time.time()
+    while moved < total:
+        data = dev.read(VENDOR_EPIN, min(chunk, total - moved), timeout=1000)
+        if options.check:
+            (count, expected) = counter_errors(data, expected)
+            errors += count
+        moved += len(data)
+    show('read (IN)', moved, time.time() - start)
+    if options.check:
+        sys.stdout.write('  counter errors: %d\n' % errors)
+
+
+def dump_write(options):
+    dev = find_device()
+    total = parse_size(options.size)
+    chunk = parse_size(options.chunk) & ~3
+    get_stats(dev, reset=True)
+    moved = 0
+    word = 0
+    start = time.time()
+    while moved < total:
+        words = min(chunk, total - moved) // 4 or 1
+        data = struct.pack('<%dI' % words,
+                           *[(word + i) & 0xFFFFFFFF for i in range(words)])
+        moved += dev.write(VENDOR_EPOUT, data, timeout=1000)
+        word += words
+    show('write (OUT)', moved, time.time() - start)
+    stats = get_stats(dev)
+    sys.stdout.write('  device: %d bytes received, %d counter errors\n'
+                     % (stats['out_bytes'], stats['out_errors']))
+
+
+def dump_stats(options):
+    stats = get_stats(find_device(), options.reset)
+    for name in STATS_FIELDS:
+        sys.stdout.write('%s: %d\n' % (name, stats[name]))
+
+
+MODES = {'read': dump_read, 'write': dump_write, 'stats': dump_stats}
+
+
+def main(argv):
+    import optparse
+    parser = optparse.OptionParser(
+        usage='%prog [options] ' + '|'.join(sorted(MODES)))
+    parser.add_option('-s', '--size', default='16M',
+                      help='bytes to move, K or M suffix [%default]')
+    parser.add_option('-c', '--chunk', default='64K',
+                      help='bytes per bulk transfer [%default]')
+    parser.add_option('-k', '--check', action='store_true', default=False,
+                      help='check the running counter of the dump (read)')
+    parser.add_option('-r', '--reset', action='store_true', default=False,
+                      help='clear the device figures (stats)')
+    (options, args) = parser.parse_args(argv[1:])
+
+    if len(args) != 1 or args[0] not in MODES:
+        parser.error('give one of ' + ', '.join(sorted(MODES)))
+    MODES[args[0]](options)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -53,6 +53,9 @@ DRESULT disk_ioctl (BYTE, BYTE, void*);
 #define CTRL_POWER			4
 #define CTRL_LOCK			5
 #define CTRL_EJECT			6
+#define CTRL_MAP			7	/* Address of sectors of a memory mapped drive (DMAP), for f_forward() */
+#define CTRL_ALIGN			8	/* Buffer alignment for direct transfers (DWORD), RES_PARERR if none */
+#define CTRL_READAHEAD		9	/* Cluster a file enters and the next one in its chain (DRUN), for the read-ahead */
 /* MMC/SDC command */
 #define MMC_GET_TYPE		10
 #define MMC_GET_CSD			11
@@ -64,6 +67,21 @@ DRESULT disk_ioctl (BYTE, BYTE, void*);
 #define ATA_GET_MODEL		21
 #define ATA_GET_SN			22
 
+/* Argument of CTRL_MAP: on success, data points to count sectors from sector */
+typedef struct {
+	DWORD sector;		/* In: first sector */
+	BYTE count;			/* In: number of sectors */
+	const BYTE *data;	/* Out: address of the sectors */
+} DMAP;
+
+/* Argument of CTRL_READAHEAD: the file reads sectors sector..sector+count-1,
+/  then goes on at sector next (0 at the end of the cluster chain) */
+typedef struct {
+	DWORD sector;		/* First sector of the cluster */
+	DWORD count;		/* Sectors in the cluster */
+	DWORD next;			/* First sector of the next cluster, or 0 */
+} DRUN;
+
 
 #define _DISKIO
 #endif
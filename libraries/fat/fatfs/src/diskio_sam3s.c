@@ -16,9 +16,190 @@
 #include <stdio.h>
 #include <assert.h>
 
+/* Number of medias, the application can define it in fatfs_config.h to
+/  serve several drives (the medias[] array is owned by the application) */
+#ifndef MAX_MEDS
 #define MAX_MEDS        1
+#endif
 extern Media medias[MAX_MEDS];
 
+/* Size of the read-ahead buffer in default sectors, 0 to disable. When
+/  sequential disk_read are detected, the following sectors are read into
+/  this buffer (asynchronously if the media supports it) so that the next
+/  disk_read is served from RAM. The reads of a buffer's worth or more, the
+/  whole sectors f_read() moves straight into the user buffer, neither use
+/  nor refill it, so that they are done without intermediate copy.
+/  f_read() gives the cluster it enters and the next one in the file chain
+/  (CTRL_READAHEAD): the read-ahead then stops at the end of a fragmented
+/  cluster and goes on at the first sectors of the next cluster, instead
+/  of reading the unrelated sectors that follow on the media. */
+#ifndef DISKIO_READAHEAD_SECTORS
+#define DISKIO_READAHEAD_SECTORS    4
+#endif
+
+#if DISKIO_READAHEAD_SECTORS > 0
+
+/* Read-ahead buffer states */
+#define RA_IDLE         0   /* Nothing staged */
+#define RA_PENDING      1   /* Read on going */
+#define RA_VALID        2   /* Staged data valid */
+
+/* Read-ahead buffer of a drive. Each drive owns its buffer so that the
+/  volumes can be accessed from different tasks when _FS_REENTRANT is set
+/  (FatFs only serializes the accesses to the same volume). */
+typedef struct {
+    volatile BYTE state;    /* RA_xxx */
+    DWORD addr;             /* First staged media block */
+    DWORD len;              /* Number of staged media blocks */
+    DWORD lastEnd;          /* Media block following the last disk_read */
+    DWORD runStart;         /* Cluster of the file read (CTRL_READAHEAD), */
+    DWORD runEnd;           /* 0 if none */
+    DWORD runNext;          /* Next cluster in the chain, 0 at the end */
+    DWORD buffer[DISKIO_READAHEAD_SECTORS * SECTOR_SIZE_DEFAULT / 4];
+} ReadAhead;
+
+static ReadAhead readAhead[MAX_MEDS];
+
+/*-----------------------------------------------------------------------*/
+/* Read-ahead completion callback                                        */
+/*-----------------------------------------------------------------------*/
+
+static void ReadAheadDone (
+	ReadAhead *ra,
+	unsigned char status,
+	unsigned int transferred,
+	unsigned int remaining
+)
+{
+    ra->state = (status == MED_STATUS_SUCCESS) ? RA_VALID : RA_IDLE;
+}
+
+/*-----------------------------------------------------------------------*/
+/* Wait for the on going read-ahead, so that the media is free           */
+/*-----------------------------------------------------------------------*/
+
+static void ReadAheadWait (
+	BYTE drv
+)
+{
+    while (readAhead[drv].state == RA_PENDING) {
+        MED_Handler(&medias[drv]);
+    }
+}
+
+/*-----------------------------------------------------------------------*/
+/* Serve a read from the read-ahead buffer, returns 1 if done            */
+/*-----------------------------------------------------------------------*/
+
+static int ReadAheadGet (
+	BYTE drv,
+	BYTE *buff,
+	unsigned int addr,
+	unsigned int len
+)
+{
+    ReadAhead *ra = &readAhead[drv];
+    unsigned int blockSize = medias[drv].blockSize;
+
+    if (   ra->state != RA_VALID
+        || addr < ra->addr
+        || addr + len > ra->addr + ra->len) {
+        return 0;
+    }
+    memcpy(buff,
+           (BYTE*)ra->buffer + (addr - ra->addr) * blockSize,
+           len * blockSize);
+    return 1;
+}
+
+/*-----------------------------------------------------------------------*/
+/* Start reading ahead from a media block if the reads are sequential    */
+/*-----------------------------------------------------------------------*/
+
+static void ReadAheadNext (
+	BYTE drv,
+	unsigned int addr,
+	unsigned int len
+)
+{
+    ReadAhead *ra = &readAhead[drv];
+    unsigned int next = addr + len;
+    unsigned int count = sizeof(ra->buffer) / medias[drv].blockSize;
+    unsigned int size;
+    unsigned char sequential;
+
+    /* Entering the cluster given by f_read() is sequential too, whatever
+       was read in between (FAT) */
+    sequential = (addr == ra->lastEnd)
+                 || (ra->runEnd && addr == ra->runStart);
+    ra->lastEnd = next;
+
+    /* Not sequential, or large reads */
+    if (!sequential || count == 0 || len >= count) {
+        return;
+    }
+
+    /* Follow the cluster chain of the file, only the next cluster is
+       known to hold file data */
+    if (ra->runEnd && next > ra->runStart && next <= ra->runEnd) {
+
+        size = ra->runEnd - ra->runStart;
+        if (next == ra->runEnd) {
+            next = ra->runNext;
+            if (next == 0) return;      /* End of the file */
+            if (count > size) count = size;
+        }
+        else if (ra->runNext != ra->runEnd) {
+            if (next + count > ra->runEnd) count = ra->runEnd - next;
+        }
+        else if (next + count > ra->runEnd + size) {
+            count = ra->runEnd + size - next;
+        }
+    }
+
+    /* Next blocks already staged */
+    if (   ra->state == RA_VALID
+        && next >= ra->addr
+        && next < ra->addr + ra->len) {
+        return;
+    }
+
+    if (next + count > medias[drv].size) {
+        if (next >= medias[drv].size) return;
+        count = medias[drv].size - next;
+    }
+
+    ra->state = RA_PENDING;
+    ra->addr = next;
+    ra->len = count;
+    if (MED_Read(&medias[drv], next, (void*)ra->buffer, count,
+                 (MediaCallback)ReadAheadDone, ra)
+            != MED_STATUS_SUCCESS) {
+        ra->state = RA_IDLE;
+    }
+}
+
+/*-----------------------------------------------------------------------*/
+/* Drop the staged data overwritten by a write                           */
+/*-----------------------------------------------------------------------*/
+
+static void ReadAheadInvalidate (
+	BYTE drv,
+	unsigned int addr,
+	unsigned int len
+)
+{
+    ReadAhead *ra = &readAhead[drv];
+
+    ReadAheadWait(drv);
+    if (   addr < ra->addr + ra->len
+        && addr + len > ra->addr) {
+        ra->state = RA_IDLE;
+    }
+}
+
+#endif /* DISKIO_READAHEAD_SECTORS */
+
 
 /*-----------------------------------------------------------------------*/
 /* Initialize a Drive                                                    */
@@ -89,8 +270,11 @@ DRESULT disk_read (
 {
     unsigned char result;
     DRESULT res = RES_ERROR;
+    void *mapped;
 
     unsigned int addr, len;
+
+    PROF_Enter(PROF_ID_DISK_READ);
     if (medias[drv].blockSize < SECTOR_SIZE_DEFAULT)
     {
         addr = sector * (SECTOR_SIZE_DEFAULT / medias[drv].blockSize);
@@ -102,17 +286,39 @@ DRESULT disk_read (
         len  = count;
     }
 
+    /* Memory mapped media: plain copy from the media memory, nothing
+       to read ahead */
+    if (medias[drv].mappedRD
+        && MED_Map(&medias[drv], addr, len, &mapped) == MED_STATUS_SUCCESS)
+    {
+        memcpy(buff, mapped, len * medias[drv].blockSize);
+        PROF_Exit(PROF_ID_DISK_READ);
+        return RES_OK;
+    }
+
+#if DISKIO_READAHEAD_SECTORS > 0
+    ReadAheadWait(drv);
+    if (ReadAheadGet(drv, buff, addr, len))
+    {
+        result = MED_STATUS_SUCCESS;
+    }
+    else
+#endif
     result = MED_Read(&medias[drv], addr, (void*)buff, len, NULL, NULL);
 
     if( result == MED_STATUS_SUCCESS )
     {
         res = RES_OK;
+#if DISKIO_READAHEAD_SECTORS > 0
+        ReadAheadNext(drv, addr, len);
+#endif
     }
     else
     {
         TRACE_ERROR("MED_Read pb: 0x%X\n\r", result);
         res = RES_ERROR;
     }
+    PROF_Exit(PROF_ID_DISK_READ);
    return res;
 }
 
@@ -139,6 +345,8 @@ DRESULT disk_write (
     tmp = (void *) buff;
 
     unsigned int addr, len;
+
+    PROF_Enter(PROF_ID_DISK_WRITE);
     if (medias[drv].blockSize < SECTOR_SIZE_DEFAULT)
     {
         addr = sector * (SECTOR_SIZE_DEFAULT / medias[drv].blockSize);
@@ -150,6 +358,9 @@ DRESULT disk_write (
         len  = count;
     }
 
+#if DISKIO_READAHEAD_SECTORS > 0
+    ReadAheadInvalidate(drv, addr, len);
+#endif
     result = MED_Write(&medias[drv], addr, (void*)tmp, len, NULL, NULL);
 
     if( result == MED_STATUS_SUCCESS )
@@ -161,6 +372,7 @@ DRESULT disk_write (
         TRACE_ERROR("MED_Write pb: 0x%X\n\r", result);
         res = RES_ERROR;
     }
+    PROF_Exit(PROF_ID_DISK_WRITE);
 
     return res;
 }
@@ -181,6 +393,17 @@ DRESULT disk_write (
 // of sector into the DWORD variable pointed by Buffer.
 // When the erase block size is unknown or magnetic disk device, return 1.
 // This command is used in only f_mkfs function.
+//
+//CTRL_MAP    Returns the address of sectors of a memory mapped media (DMAP),
+// so that f_forward streams them in place. Other medias return RES_PARERR.
+//
+//CTRL_ALIGN    Returns into the DWORD variable pointed by Buffer the alignment
+// a buffer needs for the media to transfer it directly (DMA), see
+// MED_GetAlignment(). Buffers declared MED_ALIGNED or taken from
+// MED_AllocBuffer() suit all the drives.
+//
+//CTRL_READAHEAD    Takes from f_read the cluster a file enters and the next
+// one in its chain (DRUN), so that the read-ahead follows the file.
 /*-----------------------------------------------------------------------*/
 
 DRESULT disk_ioctl (
@@ -190,6 +413,61 @@ DRESULT disk_ioctl (
 )
 {
     DRESULT res=RES_PARERR;
+    DMAP *pMap;
+    void *mapped;
+    unsigned int ratio;
+
+    /* Memory mapped media: address of the sectors, for f_forward() */
+    if (ctrl == CTRL_MAP)
+    {
+        pMap = (DMAP*)buff;
+        if (drv >= MAX_MEDS || !medias[drv].mappedRD)
+        {
+            return RES_PARERR;
+        }
+        ratio = (medias[drv].blockSize < SECTOR_SIZE_DEFAULT) ?
+                    SECTOR_SIZE_DEFAULT / medias[drv].blockSize : 1;
+        if (MED_Map(&medias[drv], pMap->sector * ratio, pMap->count * ratio,
+                    &mapped) != MED_STATUS_SUCCESS)
+        {
+            return RES_ERROR;
+        }
+        pMap->data = (const BYTE*)mapped;
+        return RES_OK;
+    }
+
+    /* Cluster chain of the file read, nothing to wait for */
+    if (ctrl == CTRL_READAHEAD)
+    {
+        if (drv >= MAX_MEDS)
+        {
+            return RES_PARERR;
+        }
+#if DISKIO_READAHEAD_SECTORS > 0
+        ratio = (medias[drv].blockSize < SECTOR_SIZE_DEFAULT) ?
+                    SECTOR_SIZE_DEFAULT / medias[drv].blockSize : 1;
+        readAhead[drv].runStart = ((DRUN*)buff)->sector * ratio;
+        readAhead[drv].runEnd = readAhead[drv].runStart
+                                + ((DRUN*)buff)->count * ratio;
+        readAhead[drv].runNext = ((DRUN*)buff)->next * ratio;
+#endif
+        return RES_OK;
+    }
+
+    /* Alignment of the direct transfers, nothing to wait for */
+    if (ctrl == CTRL_ALIGN)
+    {
+        if (drv >= MAX_MEDS)
+        {
+            return RES_PARERR;
+        }
+        *(DWORD*)buff = MED_GetAlignment(&medias[drv]);
+        return RES_OK;
+    }
+
+#if DISKIO_READAHEAD_SECTORS > 0
+    if (drv < MAX_MEDS) ReadAheadWait(drv);
+#endif
 
     switch (drv)
     {
@@ -228,6 +506,7 @@ DRESULT disk_ioctl (
                 break;
 
             case CTRL_SYNC :   /* Make sure that data has been written */
+                MED_Flush(&medias[drv]);
                 res = RES_OK;
                 break;
 
@@ -271,6 +550,7 @@ DRESULT disk_ioctl (
                 break;
 
             case CTRL_SYNC :   /* Make sure that data has been written */
+                MED_Flush(&medias[drv]);
                 res = RES_OK;
                 break;
 
@@ -85,6 +85,9 @@
 
 #include "ff.h"			/* FatFs configurations and declarations */
 #include "diskio.h"		/* Declarations of low level disk I/O functions */
+#if _USE_MEMOPS
+#include "chip.h"		/* MEM_Copy and MEM_Set */
+#endif
 
 
 /*--------------------------------------------------------------------------
@@ -131,6 +134,17 @@
 #define	ABORT(fs, res)		{ fp->flag |= FA__ERROR; LEAVE_FF(fs, res); }
 
 
+/* Fast seek cluster link map table states */
+#if _USE_FASTSEEK
+#define	CLMT_NONE		0	/* Not built yet, or out of date */
+#define	CLMT_VALID		1	/* Built */
+#define	CLMT_NOCORE		2	/* Arena too small for the file fragments */
+#define	INVALIDATE_LINKMAP(fp)	{ (fp)->clstat = CLMT_NONE; }
+#else
+#define	INVALIDATE_LINKMAP(fp)
+#endif
+
+
 /* Character code support macros */
 #define IsUpper(c)	(((c)>='A')&&((c)<='Z'))
 #define IsLower(c)	(((c)>='a')&&((c)<='z'))
@@ -230,6 +244,9 @@ static WCHAR LfnBuf[_MAX_LFN + 1];
 /* Copy memory to memory */
 static
 void mem_cpy (void* dst, const void* src, int cnt) {
+#if _USE_MEMOPS
+	MEM_Copy(dst, src, (DWORD)cnt);
+#else
 	BYTE *d = (BYTE*)dst;
 	const BYTE *s = (const BYTE*)src;
 
@@ -242,15 +259,20 @@ void mem_cpy (void* dst, const void* src, int cnt) {
 #endif
 	while (cnt--)
 		*d++ = *s++;
+#endif
 }
 
 /* Fill memory */
 static
 void mem_set (void* dst, int val, int cnt) {
+#if _USE_MEMOPS
+	MEM_Set(dst, (BYTE)val, (DWORD)cnt);
+#else
 	BYTE *d = (BYTE*)dst;
 
 	while (cnt--)
 		*d++ = (BYTE)val;
+#endif
 }
 
 /* Compare memory to memory */
@@ -617,6 +639,10 @@ FRESULT remove_chain (
 				fs->free_clust++;
 				fs->fsi_flag = 1;
 			}
+#if _USE_CHKFREE
+			if (clst < fs->chk_clst)			/* Freed in the part already checked */
+				fs->chk_free++;
+#endif
 			clst = nxt;	/* Next cluster */
 		}
 	}
@@ -678,6 +704,10 @@ DWORD create_chain (	/* 0:No free cluster, 1:Internal error, 0xFFFFFFFF:Disk err
 		fs->free_clust--;
 		fs->fsi_flag = 1;
 	}
+#if _USE_CHKFREE
+	if (ncl < fs->chk_clst)				/* Allocated in the part already checked */
+		fs->chk_free--;
+#endif
 
 	return ncl;		/* Return new cluster number */
 }
@@ -991,13 +1021,86 @@ BYTE sum_sfn (
 
 
 
+/*-----------------------------------------------------------------------*/
+/* Name lookup cache - Hash/Search/Store a looked up name                */
+/*-----------------------------------------------------------------------*/
+#if _FS_DIRCACHE
+static
+WORD dc_hash (		/* Hash of the name to be found (never 0) */
+	DIR *dj			/* Pointer to the directory object linked to the file name */
+)
+{
+	WORD h = 0;
+	int i;
+#if _USE_LFN
+	WCHAR *lfn;
+#endif
+
+
+	for (i = 0; i < 12; i++)		/* SFN and name status */
+		h = (h >> 1) + (h << 15) + dj->fn[i];
+#if _USE_LFN
+	lfn = dj->lfn;
+	if (lfn) {						/* LFN, case insensitive */
+		while (*lfn)
+			h = (h >> 1) + (h << 15) + ff_wtoupper(*lfn++);
+	}
+#endif
+	return h ? h : 1;
+}
+
+
+static
+DIRCACHE* dc_search (	/* Pointer to the cache slot of the name, 0:Not cached */
+	DIR *dj,			/* Pointer to the directory object */
+	WORD hash			/* Hash of the name */
+)
+{
+	DIRCACHE *dc = dj->fs->dcache;
+	int i;
+
+
+	for (i = 0; i < _FS_DIRCACHE; i++, dc++) {
+		if (dc->hash == hash && dc->sclust == dj->sclust) return dc;
+	}
+	return 0;
+}
+
+
+static
+void dc_store (
+	DIR *dj,			/* Pointer to the directory object pointing the found SFN entry */
+	WORD hash,			/* Hash of the name */
+	WORD idx			/* Index of the first entry of the object */
+)
+{
+	FATFS *fs = dj->fs;
+	DIRCACHE *dc;
+
+
+	dc = dc_search(dj, hash);		/* Refresh the slot of the name if any */
+	if (!dc) {						/* Else replace the slots in turn */
+		dc = &fs->dcache[fs->dc_next];
+		if (++fs->dc_next >= _FS_DIRCACHE) fs->dc_next = 0;
+	}
+	dc->sclust = dj->sclust;
+	dc->hash = hash;
+	dc->idx = idx;
+	dc->cnt = (BYTE)(dj->index - idx + 1);
+}
+#endif
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Directory handling - Find an object in the directory                  */
 /*-----------------------------------------------------------------------*/
 
 static
-FRESULT dir_find (
-	DIR *dj			/* Pointer to the directory object linked to the file name */
+FRESULT dir_match (	/* FR_OK:Found, FR_NO_FILE:Not found */
+	DIR *dj,		/* Pointer to the directory object pointing the first entry to check */
+	WORD cnt		/* Number of entries to check (0:Up to the end of table) */
 )
 {
 	FRESULT res;
@@ -1006,9 +1109,6 @@ FRESULT dir_find (
 	BYTE a, ord, sum;
 #endif
 
-	res = dir_sdi(dj, 0);			/* Rewind directory object */
-	if (res != FR_OK) return res;
-
 #if _USE_LFN
 	ord = sum = 0xFF;
 #endif
@@ -1043,6 +1143,7 @@ FRESULT dir_find (
 		if (!(dir[DIR_Attr] & AM_VOL) && !mem_cmp(dir, dj->fn, 11)) /* Is it a valid entry? */
 			break;
 #endif
+		if (cnt && !--cnt) { res = FR_NO_FILE; break; }	/* Reached to end of range */
 		res = dir_next(dj, 0);		/* Next entry */
 	} while (res == FR_OK);
 
@@ -1050,6 +1151,45 @@ FRESULT dir_find (
 }
 
 
+static
+FRESULT dir_find (
+	DIR *dj			/* Pointer to the directory object linked to the file name */
+)
+{
+	FRESULT res;
+#if _FS_DIRCACHE
+	DIRCACHE *dc;
+	WORD hash;
+
+
+	hash = dc_hash(dj);
+	dc = dc_search(dj, hash);
+	if (dc) {						/* The name has been found before, check the entries it was found at */
+		res = dir_sdi(dj, dc->idx);
+		if (res == FR_OK) res = dir_match(dj, dc->cnt);
+		if (res == FR_OK) return res;
+		dc->hash = 0;				/* Stale slot, search the whole directory */
+	}
+#endif
+
+	res = dir_sdi(dj, 0);			/* Rewind directory object */
+	if (res != FR_OK) return res;
+
+	res = dir_match(dj, 0);
+#if _FS_DIRCACHE
+	if (res == FR_OK) {
+#if _USE_LFN
+		dc_store(dj, hash, dj->lfn_idx != 0xFFFF ? dj->lfn_idx : dj->index);
+#else
+		dc_store(dj, hash, dj->index);
+#endif
+	}
+#endif
+
+	return res;
+}
+
+
 
 
 /*-----------------------------------------------------------------------*/
@@ -1778,6 +1918,9 @@ FRESULT chk_mounted (	/* FR_OK(0): successful, !=0: any error occurred */
 	/* Initialize cluster allocation information */
 	fs->free_clust = 0xFFFFFFFF;
 	fs->last_clust = 0;
+#if _USE_CHKFREE
+	fs->chk_clst = 0;
+#endif
 
 	/* Get fsinfo if available */
 	if (fmt == FS_FAT32) {
@@ -1787,8 +1930,14 @@ FRESULT chk_mounted (	/* FR_OK(0): successful, !=0: any error occurred */
 			LD_WORD(fs->win+BS_55AA) == 0xAA55 &&
 			LD_DWORD(fs->win+FSI_LeadSig) == 0x41615252 &&
 			LD_DWORD(fs->win+FSI_StrucSig) == 0x61417272) {
+#if !(_FS_NOFSINFO & 2)
 				fs->last_clust = LD_DWORD(fs->win+FSI_Nxt_Free);
+#endif
+#if !(_FS_NOFSINFO & 1)
 				fs->free_clust = LD_DWORD(fs->win+FSI_Free_Count);
+				if (fs->free_clust > nclst)		/* (Out of range count is unknown) */
+					fs->free_clust = 0xFFFFFFFF;
+#endif
 		}
 	}
 #endif
@@ -1803,6 +1952,10 @@ FRESULT chk_mounted (	/* FR_OK(0): successful, !=0: any error occurred */
 	for (vol = 0; vol < _FS_SHARE; vol++)
 		fs->flsem[vol].ctr = 0;
 #endif
+#if _FS_DIRCACHE			/* Clear name lookup cache */
+	mem_set(fs->dcache, 0, sizeof(fs->dcache));
+	fs->dc_next = 0;
+#endif
 
 	return FR_OK;
 }
@@ -1852,6 +2005,7 @@ FRESULT f_mount (
 )
 {
 	FATFS *rfs;
+	FRESULT res = FR_OK;
 
 
 	if (vol >= _DRIVES)				/* Check if the drive number is valid */
@@ -1859,6 +2013,18 @@ FRESULT f_mount (
 	rfs = FatFs[vol];				/* Get current fs object */
 
 	if (rfs) {
+#if !_FS_READONLY
+		if (rfs->fs_type && rfs->fsi_flag) {	/* Write back the FSInfo of the current volume */
+#if _FS_REENTRANT
+			if (!lock_fs(rfs)) return FR_TIMEOUT;
+#endif
+			if (!(disk_status(rfs->drv) & STA_NOINIT))
+				res = sync(rfs);
+#if _FS_REENTRANT
+			ff_rel_grant(rfs->sobj);
+#endif
+		}
+#endif
 #if _FS_REENTRANT					/* Discard sync object of the current volume */
 		if (!ff_del_syncobj(rfs->sobj)) return FR_INT_ERR;
 #endif
@@ -1873,7 +2039,7 @@ FRESULT f_mount (
 	}
 	FatFs[vol] = fs;				/* Register new fs object */
 
-	return FR_OK;
+	return res;
 }
 
 
@@ -2001,6 +2167,7 @@ FRESULT f_open (
 		fp->dsect = 0;
 #if _USE_FASTSEEK
 		fp->cltbl = 0;						/* No cluster link map table */
+		fp->clstat = CLMT_NONE;
 #endif
 		fp->fs = dj.fs; fp->id = dj.fs->id;	/* Validate file object */
 	}
@@ -2026,6 +2193,7 @@ FRESULT f_read (
 	DWORD clst, sect, remain;
 	UINT rcnt, cc;
 	BYTE csect, *rbuff = buff;
+	DRUN run;
 
 
 	*br = 0;	/* Initialize byte counter */
@@ -2049,6 +2217,14 @@ FRESULT f_read (
 				if (clst <= 1) ABORT(fp->fs, FR_INT_ERR);
 				if (clst == 0xFFFFFFFF) ABORT(fp->fs, FR_DISK_ERR);
 				fp->curr_clust = clst;				/* Update current cluster */
+				run.sector = clust2sect(fp->fs, clst);	/* Tell the read-ahead where the chain goes */
+				run.count = fp->fs->csize;
+				run.next = 0;
+				if (fp->fsize - fp->fptr > (DWORD)SS(fp->fs) * fp->fs->csize) {	/* File goes on past this cluster */
+					clst = get_fat(fp->fs, clst);
+					if (clst >= 2 && clst < fp->fs->n_fatent) run.next = clust2sect(fp->fs, clst);
+				}
+				disk_ioctl(fp->fs->drv, CTRL_READAHEAD, &run);
 			}
 			sect = clust2sect(fp->fs, fp->curr_clust);	/* Get current sector */
 			if (!sect) ABORT(fp->fs, FR_INT_ERR);
@@ -2209,7 +2385,10 @@ FRESULT f_write (
 #endif
 	}
 
-	if (fp->fptr > fp->fsize) fp->fsize = fp->fptr;	/* Update file size if needed */
+	if (fp->fptr > fp->fsize) {						/* Update file size if needed */
+		fp->fsize = fp->fptr;
+		INVALIDATE_LINKMAP(fp);						/* The cluster chain may have been stretched */
+	}
 	fp->flag |= FA__WRITTEN;						/* Set file changed flag */
 
 	LEAVE_FF(fp->fs, FR_OK);
@@ -2362,6 +2541,76 @@ FRESULT f_chdir (
 
 
 #if _FS_MINIMIZE <= 2
+#if _USE_FASTSEEK
+/*-----------------------------------------------------------------------*/
+/* Create the cluster link map table of a file                           */
+/*-----------------------------------------------------------------------*/
+
+static
+FRESULT create_linkmap (
+	FIL *fp		/* Pointer to the file object with a link map arena */
+)
+{
+	DWORD cl, pcl, ncl, tcl, tlen, *tbl = fp->cltbl;
+
+
+	tlen = *tbl++;
+	cl = fp->org_clust;
+	if (cl) {
+		do {
+			if (tlen < 4) {	/* Not enough table items */
+				fp->clstat = CLMT_NOCORE;
+				return FR_NOT_ENOUGH_CORE;
+			}
+			tcl = cl; ncl = 0;
+			do {		/* Get a fragment and store the top and length */
+				pcl = cl; ncl++;
+				cl = get_fat(fp->fs, cl);
+				if (cl <= 1) return FR_INT_ERR;
+				if (cl == 0xFFFFFFFF) return FR_DISK_ERR;
+			} while (cl == pcl + 1);
+			*tbl++ = ncl; *tbl++ = tcl;
+			tlen -= 2;
+		} while (cl < fp->fs->n_fatent);
+	}
+	*tbl = 0;	/* Terminate table */
+	fp->clstat = CLMT_VALID;
+
+	return FR_OK;
+}
+
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Enable Fast Seek on a File                                            */
+/*-----------------------------------------------------------------------*/
+
+FRESULT f_fastseek (
+	FIL *fp,		/* Pointer to the file object */
+	DWORD *tbl,		/* Link map arena, 0 to disable fast seek */
+	UINT items		/* Number of items in the arena (2 per file fragment, +2) */
+)
+{
+	FRESULT res;
+
+
+	res = validate(fp->fs, fp->id);		/* Check validity of the object */
+	if (res != FR_OK) LEAVE_FF(fp->fs, res);
+	if (tbl && items < 4)				/* At least one fragment and the terminator */
+		LEAVE_FF(fp->fs, FR_NOT_ENOUGH_CORE);
+
+	fp->cltbl = tbl;
+	if (tbl) *tbl = items;
+	fp->clstat = CLMT_NONE;				/* The table is built on the first seek */
+
+	LEAVE_FF(fp->fs, FR_OK);
+}
+#endif
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Seek File R/W Pointer                                                 */
 /*-----------------------------------------------------------------------*/
@@ -2380,63 +2629,50 @@ FRESULT f_lseek (
 		LEAVE_FF(fp->fs, FR_INT_ERR);
 
 #if _USE_FASTSEEK
-	if (fp->cltbl) {	/* Fast seek */
-		DWORD cl, pcl, ncl, tcl, dsc, tlen, *tbl = fp->cltbl;
+	if (fp->cltbl && (ofs == CREATE_LINKMAP || fp->clstat == CLMT_NONE)) {
+		res = create_linkmap(fp);		/* Create link map table on request or on first seek */
+		if (res == FR_INT_ERR || res == FR_DISK_ERR) ABORT(fp->fs, res);
+		if (ofs == CREATE_LINKMAP) LEAVE_FF(fp->fs, res);
+		res = FR_OK;					/* Use normal seek if the table does not fit */
+	}
+	if (fp->cltbl && fp->clstat == CLMT_VALID
+#if !_FS_READONLY
+		&& (ofs <= fp->fsize || !(fp->flag & FA_WRITE))	/* Stretching a file needs normal seek */
+#endif
+		) {								/* Fast seek */
+		DWORD cl, ncl, dsc, *tbl = fp->cltbl + 1;
 		BYTE csc;
 
-		tlen = *tbl++;
-		if (ofs == CREATE_LINKMAP) {	/* Create link map table */
-			cl = fp->org_clust;
-			if (cl) {
-				do {
-					if (tlen < 4) {	/* Not enough table items */
-						res = FR_NOT_ENOUGH_CORE; break;
-					}
-					tcl = cl; ncl = 0;
-					do {		/* Get a fragment and store the top and length */
-						pcl = cl; ncl++;
-						cl = get_fat(fp->fs, cl);
-						if (cl <= 1) ABORT(fp->fs, FR_INT_ERR);
-						if (cl == 0xFFFFFFFF) ABORT(fp->fs, FR_DISK_ERR);
-					} while (cl == pcl + 1);
-					*tbl++ = ncl; *tbl++ = tcl;
-					tlen -= 2;
-				} while (cl < fp->fs->n_fatent);
+		if (ofs > fp->fsize)		/* Clip offset at the file size */
+			ofs = fp->fsize;
+		fp->fptr = ofs;				/* Set file pointer */
+		if (ofs) {
+			dsc = (ofs - 1) / SS(fp->fs);
+			cl = dsc / fp->fs->csize;
+			for (;;) {
+				ncl = *tbl++;
+				if (!ncl) ABORT(fp->fs, FR_INT_ERR);
+				if (cl < ncl) break;
+				cl -= ncl; tbl++;
 			}
-			*tbl = 0;	/* Terminate table */
-
-		} else {						/* Fast seek */
-			if (ofs > fp->fsize)		/* Clip offset at the file size */
-				ofs = fp->fsize;
-			fp->fptr = ofs;				/* Set file pointer */
-			if (ofs) {
-				dsc = (ofs - 1) / SS(fp->fs);
-				cl = dsc / fp->fs->csize;
-				for (;;) {
-					ncl = *tbl++;
-					if (!ncl) ABORT(fp->fs, FR_INT_ERR);
-					if (cl < ncl) break;
-					cl -= ncl; tbl++;
-				}
-				fp->curr_clust = cl + *tbl;
-				csc = (BYTE)(dsc & (fp->fs->csize - 1));
-				dsc = clust2sect(fp->fs, fp->curr_clust);
-				if (!dsc) ABORT(fp->fs, FR_INT_ERR);
-				dsc += csc;
-				if (fp->fptr % SS(fp->fs) && dsc != fp->dsect) {
+			fp->curr_clust = cl + *tbl;
+			csc = (BYTE)(dsc & (fp->fs->csize - 1));
+			dsc = clust2sect(fp->fs, fp->curr_clust);
+			if (!dsc) ABORT(fp->fs, FR_INT_ERR);
+			dsc += csc;
+			if (fp->fptr % SS(fp->fs) && dsc != fp->dsect) {
 #if !_FS_TINY
 #if !_FS_READONLY
-					if (fp->flag & FA__DIRTY) {		/* Flush dirty buffer if needed */
-						if (disk_write(fp->fs->drv, fp->buf, fp->dsect, 1) != RES_OK)
-							ABORT(fp->fs, FR_DISK_ERR);
-						fp->flag &= ~FA__DIRTY;
-					}
-#endif
-					if (disk_read(fp->fs->drv, fp->buf, dsc, 1) != RES_OK)
+				if (fp->flag & FA__DIRTY) {		/* Flush dirty buffer if needed */
+					if (disk_write(fp->fs->drv, fp->buf, fp->dsect, 1) != RES_OK)
 						ABORT(fp->fs, FR_DISK_ERR);
-#endif
-					fp->dsect = dsc;
+					fp->flag &= ~FA__DIRTY;
 				}
+#endif
+				if (disk_read(fp->fs->drv, fp->buf, dsc, 1) != RES_OK)
+					ABORT(fp->fs, FR_DISK_ERR);
+#endif
+				fp->dsect = dsc;
 			}
 		}
 	} else
@@ -2516,6 +2752,7 @@ FRESULT f_lseek (
 		if (fp->fptr > fp->fsize) {			/* Set changed flag if the file size is extended */
 			fp->fsize = fp->fptr;
 			fp->flag |= FA__WRITTEN;
+			INVALIDATE_LINKMAP(fp);
 		}
 #endif
 	}
@@ -2708,6 +2945,56 @@ FRESULT f_getfree (
 
 
 
+#if _USE_CHKFREE
+/*-----------------------------------------------------------------------*/
+/* Validate the Number of Free Clusters Step by Step                     */
+/*-----------------------------------------------------------------------*/
+
+FRESULT f_chkfree (
+	const TCHAR *path,	/* Pointer to the logical drive number (root dir) */
+	DWORD step,			/* Number of clusters to check in this call */
+	DWORD *remain		/* Pointer to the variable to return number of clusters left to check */
+)
+{
+	FRESULT res;
+	FATFS *fs;
+	DWORD stat;
+
+
+	/* Get drive number */
+	res = chk_mounted(&path, &fs, 0);
+	if (res == FR_OK) {
+		if (!fs->chk_clst) {			/* Start a new pass */
+			fs->chk_clst = 2;
+			fs->chk_free = 0;
+		}
+		for ( ; step && fs->chk_clst < fs->n_fatent; step--) {
+			stat = get_fat(fs, fs->chk_clst);
+			if (stat == 0xFFFFFFFF) { res = FR_DISK_ERR; break; }
+			if (stat == 1) { res = FR_INT_ERR; break; }
+			if (stat == 0) fs->chk_free++;
+			fs->chk_clst++;
+		}
+		if (res != FR_OK) {				/* Abort the pass */
+			fs->chk_clst = 0;
+		} else {
+			*remain = fs->n_fatent - fs->chk_clst;
+			if (!*remain) {				/* End of pass, fix up the free cluster count */
+				if (fs->free_clust != fs->chk_free) {
+					fs->free_clust = fs->chk_free;
+					if (fs->fs_type == FS_FAT32) fs->fsi_flag = 1;
+				}
+				fs->chk_clst = 0;
+			}
+		}
+	}
+	LEAVE_FF(fs, res);
+}
+#endif /* _USE_CHKFREE */
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Truncate File                                                         */
 /*-----------------------------------------------------------------------*/
@@ -2733,6 +3020,7 @@ FRESULT f_truncate (
 		if (fp->fsize > fp->fptr) {
 			fp->fsize = fp->fptr;	/* Set file size to current R/W point */
 			fp->flag |= FA__WRITTEN;
+			INVALIDATE_LINKMAP(fp);	/* Clusters are removed */
 			if (fp->fptr == 0) {	/* When set file size to zero, remove entire cluster chain */
 				res = remove_chain(fp->fs, fp->org_clust);
 				fp->org_clust = 0;
@@ -2756,6 +3044,92 @@ FRESULT f_truncate (
 
 
 
+#if _USE_EXPAND
+/*-----------------------------------------------------------------------*/
+/* Allocate a Contiguous Blocks to the File                              */
+/*-----------------------------------------------------------------------*/
+
+FRESULT f_expand (
+	FIL *fp,		/* Pointer to the file object */
+	DWORD fsz,		/* File size to be expanded to */
+	BYTE opt		/* 0:Find and prepare only, 1:Allocate now */
+)
+{
+	FRESULT res;
+	FATFS *fs;
+	DWORD n, clst, stcl, scl, ncl, tcl, lcl;
+
+
+	res = validate(fp->fs, fp->id);		/* Check validity of the object */
+	if (res != FR_OK) LEAVE_FF(fp->fs, res);
+	fs = fp->fs;
+	if (fp->flag & FA__ERROR)			/* Check abort flag */
+		LEAVE_FF(fs, FR_INT_ERR);
+	if (!fsz || fp->fsize || fp->org_clust || !(fp->flag & FA_WRITE))	/* Only an empty file opened for writing */
+		LEAVE_FF(fs, FR_DENIED);
+
+	n = (DWORD)fs->csize * SS(fs);		/* Cluster size */
+	tcl = fsz / n + ((fsz % n) ? 1 : 0);	/* Number of clusters required */
+	if (fs->free_clust <= fs->n_fatent - 2 && fs->free_clust < tcl)
+		LEAVE_FF(fs, FR_DENIED);		/* Not enough free clusters */
+
+	/* Find a contiguous free block from the allocation hint. A block cannot wrap
+	   around the end of the FAT, but it may span the hint: the scan goes on past
+	   the hint while a block is in progress */
+	stcl = fs->last_clust;
+	if (stcl < 2 || stcl >= fs->n_fatent) stcl = 2;
+	scl = clst = stcl; ncl = 0; lcl = fs->n_fatent - 2;	/* Clusters left to scan */
+	for (;;) {
+		n = get_fat(fs, clst);
+		if (n == 1) { res = FR_INT_ERR; break; }
+		if (n == 0xFFFFFFFF) { res = FR_DISK_ERR; break; }
+		if (n == 0) {						/* Free cluster, the block grows */
+			if (++ncl == tcl) break;
+		} else {
+			ncl = 0;
+		}
+		if (++clst >= fs->n_fatent) {		/* Wrap around, restart the block */
+			clst = 2; ncl = 0;
+		}
+		if (!ncl) scl = clst;				/* Next block candidate */
+		if (lcl) lcl--;
+		if (!lcl && !ncl) { res = FR_DENIED; break; }	/* No block large enough */
+	}
+
+	if (res == FR_OK) {
+		if (opt) {							/* Build the chain in the block */
+			for (clst = scl, n = tcl; n; clst++, n--) {
+				res = put_fat(fs, clst, (n == 1) ? 0x0FFFFFFF : clst + 1);
+				if (res != FR_OK) break;
+			}
+			if (res == FR_OK) {
+				fs->last_clust = scl + tcl - 1;
+				if (fs->free_clust != 0xFFFFFFFF) {	/* Update FSInfo */
+					fs->free_clust -= tcl;
+					fs->fsi_flag = 1;
+				}
+#if _USE_CHKFREE
+				if (scl < fs->chk_clst)		/* Allocated in the part already checked */
+					fs->chk_free -= (fs->chk_clst - scl < tcl) ? fs->chk_clst - scl : tcl;
+#endif
+				fp->org_clust = scl;
+				fp->fsize = fsz;
+				fp->flag |= FA__WRITTEN;
+				INVALIDATE_LINKMAP(fp);
+			}
+		} else {							/* Next allocations start at the block */
+			fs->last_clust = scl - 1;
+		}
+	}
+	if (res != FR_OK && res != FR_DENIED) fp->flag |= FA__ERROR;
+
+	LEAVE_FF(fs, res);
+}
+#endif /* _USE_EXPAND */
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Delete a File or Directory                                            */
 /*-----------------------------------------------------------------------*/
@@ -3063,9 +3437,30 @@ FRESULT f_rename (
 
 
 /*-----------------------------------------------------------------------*/
-/* Forward data to the stream directly (available on only tiny cfg)      */
+/* Forward data to the stream directly                                    */
 /*-----------------------------------------------------------------------*/
-#if _USE_FORWARD && _FS_TINY
+#if _USE_FORWARD
+#if !_FS_TINY
+static
+FRESULT load_buf (	/* Load a sector into the file I/O buffer */
+	FIL *fp,		/* Pointer to the file object */
+	DWORD sect		/* Sector to load */
+)
+{
+	if (fp->dsect == sect) return FR_OK;
+#if !_FS_READONLY
+	if (fp->flag & FA__DIRTY) {					/* Write sector I/O buffer if needed */
+		if (disk_write(fp->fs->drv, fp->buf, fp->dsect, 1) != RES_OK)
+			return FR_DISK_ERR;
+		fp->flag &= ~FA__DIRTY;
+	}
+#endif
+	if (disk_read(fp->fs->drv, fp->buf, sect, 1) != RES_OK)
+		return FR_DISK_ERR;
+	fp->dsect = sect;
+	return FR_OK;
+}
+#endif
 
 FRESULT f_forward (
 	FIL *fp, 						/* Pointer to the file object */
@@ -3078,6 +3473,10 @@ FRESULT f_forward (
 	DWORD remain, clst, sect;
 	UINT rcnt;
 	BYTE csect;
+#if !_FS_TINY
+	DMAP map;
+	UINT ofs;
+#endif
 
 
 	*bf = 0;	/* Initialize byte counter */
@@ -3107,6 +3506,7 @@ FRESULT f_forward (
 		sect = clust2sect(fp->fs, fp->curr_clust);	/* Get current data sector */
 		if (!sect) ABORT(fp->fs, FR_INT_ERR);
 		sect += csect;
+#if _FS_TINY
 		if (move_window(fp->fs, sect))				/* Move sector window */
 			ABORT(fp->fs, FR_DISK_ERR);
 		fp->dsect = sect;
@@ -3114,6 +3514,29 @@ FRESULT f_forward (
 		if (rcnt > btr) rcnt = btr;
 		rcnt = (*func)(&fp->fs->win[(WORD)fp->fptr % SS(fp->fs)], rcnt);
 		if (!rcnt) ABORT(fp->fs, FR_INT_ERR);
+#else
+		ofs = (UINT)(fp->fptr % SS(fp->fs));
+		map.sector = sect;							/* Rest of the cluster */
+		map.count = fp->fs->csize - csect;
+		if (!((fp->flag & FA__DIRTY) && fp->dsect - sect < map.count)	/* No newer data in the sector I/O buffer */
+			&& disk_ioctl(fp->fs->drv, CTRL_MAP, &map) == RES_OK) {
+			rcnt = (UINT)map.count * SS(fp->fs) - ofs;	/* Forward data in place from the memory mapped drive */
+			if (rcnt > btr) rcnt = btr;
+			rcnt = (*func)(map.data + ofs, rcnt);
+			if (!rcnt) ABORT(fp->fs, FR_INT_ERR);
+			if ((ofs + rcnt) % SS(fp->fs)) {		/* Stopped inside a sector: the sector I/O buffer must hold it */
+				if (load_buf(fp, sect + (ofs + rcnt) / SS(fp->fs)) != FR_OK)
+					ABORT(fp->fs, FR_DISK_ERR);
+			}
+		} else {
+			if (load_buf(fp, sect) != FR_OK)		/* Forward data from the sector I/O buffer */
+				ABORT(fp->fs, FR_DISK_ERR);
+			rcnt = SS(fp->fs) - ofs;
+			if (rcnt > btr) rcnt = btr;
+			rcnt = (*func)(&fp->buf[ofs], rcnt);
+			if (!rcnt) ABORT(fp->fs, FR_INT_ERR);
+		}
+#endif
 	}
 
 	LEAVE_FF(fp->fs, FR_OK);
@@ -23,6 +23,7 @@ extern "C" {
 
 #include "integer.h"	/* Basic integer types */
 #include "ffconf.h"		/* FatFs configuration options */
+#include "ffsync.h"		/* O/S of the sync objects (_FS_REENTRANT) */
 
 #if _FATFS != _FFCONF
 #error Wrong configuration file (ffconf.h).
@@ -281,6 +282,19 @@ typedef struct {
 
 
 
+/* Definitions corresponds to name lookup cache */
+
+#if _FS_DIRCACHE
+typedef struct {
+	DWORD sclust;			/* Directory start cluster (0:root) */
+	WORD hash;				/* Hash of the looked up name (0:Blank slot) */
+	WORD idx;				/* Index of the first entry of the object in the directory */
+	BYTE cnt;				/* Number of entries of the object (LFN entries + SFN entry) */
+} DIRCACHE;
+#endif
+
+
+
 /* File system object structure (FATFS) */
 
 typedef struct {
@@ -302,6 +316,10 @@ typedef struct {
 	DWORD	last_clust;		/* Last allocated cluster */
 	DWORD	free_clust;		/* Number of free clusters */
 	DWORD	fsi_sector;		/* fsinfo sector (FAT32) */
+#if _USE_CHKFREE
+	DWORD	chk_clst;		/* Next cluster to check by f_chkfree (0:No pass in progress) */
+	DWORD	chk_free;		/* Free clusters found below chk_clst */
+#endif
 #endif
 #if _FS_RPATH
 	DWORD	cdir;			/* Current directory start cluster (0:root) */
@@ -316,6 +334,10 @@ typedef struct {
 #if _FS_SHARE
 	FILESEM	flsem[_FS_SHARE];	/* File lock semaphores */
 #endif
+#if _FS_DIRCACHE
+	DIRCACHE dcache[_FS_DIRCACHE];	/* Name lookup cache */
+	BYTE	dc_next;		/* Next cache slot to be replaced */
+#endif
 } FATFS;
 
 
@@ -326,7 +348,11 @@ typedef struct {
 	FATFS*	fs;				/* Pointer to the owner file system object */
 	WORD	id;				/* Owner file system mount ID */
 	BYTE	flag;			/* File status flags */
+#if _USE_FASTSEEK
+	BYTE	clstat;			/* Cluster link map table state */
+#else
 	BYTE	pad1;
+#endif
 	DWORD	fptr;			/* File read/write pointer */
 	DWORD	fsize;			/* File size */
 	DWORD	org_clust;		/* File start cluster (0 when fsize==0) */
@@ -417,6 +443,9 @@ FRESULT f_mount (BYTE, FATFS*);						/* Mount/Unmount a logical drive */
 FRESULT f_open (FIL*, const TCHAR*, BYTE);			/* Open or create a file */
 FRESULT f_read (FIL*, void*, UINT, UINT*);			/* Read data from a file */
 FRESULT f_lseek (FIL*, DWORD);						/* Move file pointer of a file object */
+#if _USE_FASTSEEK
+FRESULT f_fastseek (FIL*, DWORD*, UINT);			/* Enable fast seek with a link map arena */
+#endif
 FRESULT f_close (FIL*);								/* Close an open file object */
 FRESULT f_opendir (DIR*, const TCHAR*);				/* Open an existing directory */
 FRESULT f_readdir (DIR*, FILINFO*);					/* Read a directory item */
@@ -425,15 +454,24 @@ FRESULT f_stat (const TCHAR*, FILINFO*);			/* Get file status */
 FRESULT f_write (FIL*, const void*, UINT, UINT*);	/* Write data to a file */
 FRESULT f_getfree (const TCHAR*, DWORD*, FATFS**);	/* Get number of free clusters on the drive */
 FRESULT f_truncate (FIL*);							/* Truncate file */
+#if _USE_EXPAND
+FRESULT f_expand (FIL*, DWORD, BYTE);				/* Allocate a contiguous block to the file */
+#endif
 FRESULT f_sync (FIL*);								/* Flush cached data of a writing file */
 FRESULT f_unlink (const TCHAR*);					/* Delete an existing file or directory */
 FRESULT	f_mkdir (const TCHAR*);						/* Create a new directory */
 FRESULT f_chmod (const TCHAR*, BYTE, BYTE);			/* Change attriburte of the file/dir */
 FRESULT f_utime (const TCHAR*, const FILINFO*);		/* Change timestamp of the file/dir */
 FRESULT f_rename (const TCHAR*, const TCHAR*);		/* Rename/Move a file or directory */
+#if _USE_CHKFREE
+FRESULT f_chkfree (const TCHAR*, DWORD, DWORD*);		/* Validate the free cluster count step by step */
+#endif
 #endif
 #if _USE_FORWARD
 FRESULT f_forward (FIL*, UINT(*)(const BYTE*,UINT), UINT, UINT*);	/* Forward data to the stream */
+/* ATMEL modification: f_forward to a USB device IN endpoint (option/usbd_forward.c) */
+FRESULT ff_usbd_forward (FIL*, BYTE, DWORD, void(*)(void*,FRESULT,DWORD), void*);	/* Start streaming a file to an IN endpoint */
+FRESULT ff_usbd_forward_sync (FIL*, BYTE, DWORD, DWORD*);	/* Stream a file to an IN endpoint and wait */
 #endif
 #if _USE_MKFS
 FRESULT f_mkfs (BYTE, BYTE, UINT);					/* Create a file system on the drive */
@@ -47,12 +47,40 @@
 /* To enable f_mkfs function, set _USE_MKFS to 1 and set _FS_READONLY to 0 */
 
 
-#define	_USE_FORWARD	0	/* 0:Disable or 1:Enable */
-/* To enable f_forward function, set _USE_FORWARD to 1 and set _FS_TINY to 1. */
+#define	_USE_FORWARD	1	/* 0:Disable or 1:Enable */
+/* To enable f_forward function, set _USE_FORWARD to 1. When _FS_TINY is 0,
+/  data is forwarded from the file object buffer, or in place from a memory
+/  mapped drive. */
 
 
-#define	_USE_FASTSEEK	0	/* 0:Disable or 1:Enable */
-/* To enable fast seek feature, set _USE_FASTSEEK to 1. */
+#define	_USE_FASTSEEK	1	/* 0:Disable or 1:Enable */
+/* To enable fast seek feature, set _USE_FASTSEEK to 1. Fast seek is enabled
+/  per file with f_fastseek(), the cluster link map table is then built in
+/  the given arena on the first f_lseek and rebuilt after the file has been
+/  extended or truncated. */
+
+
+#define	_USE_EXPAND	1		/* 0:Disable or 1:Enable */
+/* To enable f_expand function, set _USE_EXPAND to 1 and set _FS_READONLY to 0.
+/  f_expand gives an empty file a contiguous cluster block, so that later
+/  writes do not search the FAT and stream whole clusters with disk_write. */
+
+
+#define	_FS_NOFSINFO	0	/* 0 to 3 */
+/* The FSInfo sector of a FAT32 volume gives the free cluster count and the
+/  next free cluster hint. They are loaded at mount time, kept up to date on
+/  each allocation and written back by f_sync, f_close and the unmount.
+/
+/   bit0=0: Use the free cluster count, f_getfree returns it without any scan.
+/   bit0=1: Do not trust the free cluster count, the first f_getfree scans the FAT.
+/   bit1=0: Use the next free cluster hint as allocation start point.
+/   bit1=1: Do not trust the hint, allocation starts from the volume top. */
+
+
+#define	_USE_CHKFREE	1	/* 0:Disable or 1:Enable */
+/* To enable f_chkfree function, set _USE_CHKFREE to 1 and set _FS_READONLY
+/  to 0. f_chkfree counts the free clusters a few at a time, so that an idle
+/  loop can validate the trusted FSInfo count without a long blocking scan. */
 
 
 
@@ -90,10 +118,13 @@
 /   862  - Hebrew (OEM)
 /   874  - Thai (OEM, Windows)
 /	1    - ASCII only (Valid for non LFN cfg.)
-*/
+/
+/  With LFN, the DBCS code pages need option/cc932.c to cc950.c, or the
+/  indexed cc932i.c to cc950i.c (ccindex.py): constant time conversion and
+/  about 40% less flash. */
 
 
-#define	_USE_LFN	0		/* 0 to 3 */
+#define	_USE_LFN	1		/* 0 to 3 */
 #define	_MAX_LFN	255		/* Maximum LFN length to handle (12 to 255) */
 /* The _USE_LFN option switches the LFN support.
 /
@@ -105,7 +136,8 @@
 /  The LFN working buffer occupies (_MAX_LFN + 1) * 2 bytes. When enable LFN,
 /  Unicode handling functions ff_convert() and ff_wtoupper() must be added
 /  to the project. When enable to use heap, memory control functions
-/  ff_memalloc() and ff_memfree() must be added to the project. */
+/  ff_memalloc() and ff_memfree() must be added to the project
+/  (option/syscall_heap.c). */
 
 
 #define	_LFN_UNICODE	0	/* 0:ANSI/OEM or 1:Unicode */
@@ -159,19 +191,25 @@
 /  If it is not the case, the value can also be set to 1 to improve the
 /  performance and code size. */
 
+#ifndef _USE_MEMOPS
+#define _USE_MEMOPS	1	/* 0:Byte loops or 1:MEM_Copy/MEM_Set of libchip */
+#endif
+/* When _USE_MEMOPS is set to 1, mem_cpy() and mem_set() go through the
+/  word and burst optimized MEM_Copy() and MEM_Set() of the chip library
+/  (memops.h), which move the sector data with LDM/STM on the Cortex-M3. */
+
 
+#ifndef _FS_REENTRANT
 #define _FS_REENTRANT	0		/* 0:Disable or 1:Enable */
+#endif
 #define _FS_TIMEOUT		1000	/* Timeout period in unit of time ticks */
-#define	_SYNC_t			HANDLE	/* O/S dependent type of sync object. e.g. HANDLE, OS_EVENT*, ID and etc.. */
-/* Include a header file here to define O/S system calls */
-/* #include <windows.h>, <ucos_ii.h.h>, <semphr.h> or ohters. */
 
 /* The _FS_REENTRANT option switches the reentrancy of the FatFs module.
 /
 /   0: Disable reentrancy. _SYNC_t and _FS_TIMEOUT have no effect.
 /   1: Enable reentrancy. Also user provided synchronization handlers,
 /      ff_req_grant, ff_rel_grant, ff_del_syncobj and ff_cre_syncobj
-/      function must be added to the project. */
+/      function must be added to the project: see ffsync.h. */
 
 
 #define	_FS_SHARE	0	/* 0:Disable or >=1:Enable */
@@ -181,4 +219,12 @@
    per volume. */
 
 
+#define	_FS_DIRCACHE	8	/* 0:Disable or >=1:Enable */
+/* To enable the name lookup cache, set _FS_DIRCACHE to >= 1. The value defines
+/  number of looked up names remembered per volume with their directory and
+/  entry index, so that opening the same path again only reads back the
+/  entries of the object instead of scanning each directory from its top.
+/  A cached entry is always verified against the directory before use. */
+
+
 #endif /* _FFCONFIG */
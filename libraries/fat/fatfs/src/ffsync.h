@@ -0,0 +1,37 @@
+/*---------------------------------------------------------------------------/
+/  FatFs - O/S binding of the reentrancy option
+/----------------------------------------------------------------------------/
+/
+/ Included by ff.h after the configuration file, which sets _FS_REENTRANT
+/ and _FS_TIMEOUT.
+/
+/ _FS_OS selects the O/S providing the sync objects, one per volume created
+/ by f_mount, so that tasks working on different volumes do not block each
+/ other. The handlers ff_cre_syncobj, ff_del_syncobj, ff_req_grant and
+/ ff_rel_grant are in option/syscall_freertos.c or option/syscall_coos.c.
+/ _FS_REENTRANT and _FS_OS can be set from the compiler command line. For
+/ another O/S, the configuration file defines its own _SYNC_t and handlers.
+/
+/----------------------------------------------------------------------------*/
+
+#ifndef _FFSYNC
+#define _FFSYNC
+
+#define _FS_OS_FREERTOS	1		/* option/syscall_freertos.c */
+#define _FS_OS_COOS		2		/* option/syscall_coos.c */
+#ifndef _FS_OS
+#define _FS_OS			_FS_OS_FREERTOS	/* O/S providing the sync objects */
+#endif
+
+#if _FS_REENTRANT && _FS_OS == _FS_OS_FREERTOS
+#include "FreeRTOS.h"
+#include "semphr.h"
+#define	_SYNC_t			xSemaphoreHandle	/* One mutex per volume */
+#elif _FS_REENTRANT && _FS_OS == _FS_OS_COOS
+#include "CoOS.h"
+#define	_SYNC_t			OS_EventID	/* One binary semaphore per volume */
+#elif !defined(_SYNC_t)
+#define	_SYNC_t			HANDLE	/* O/S dependent type of sync object. e.g. HANDLE, OS_EVENT*, ID and etc.. */
+#endif
+
+#endif /* _FFSYNC */
@@ -0,0 +1,5107 @@
+/*------------------------------------------------------------------------*/
+/* Unicode - OEM code bidirectional converter  (C)ChaN, 2009              */
+/*                                                                        */
+/* CP949 (Korean EUC-KR)                                                  */
+/* Indexed tables generated from cc949.c by ccindex.py                    */
+/*------------------------------------------------------------------------*/
+
+#include "../ff.h"
+
+
+#if !_USE_LFN || _CODE_PAGE != 949
+#error This file is not needed in current configuration. Remove from the project.
+#endif
+
+/* Unicode to OEM */
+static
+const BYTE uni2oem_page[] = {
+	0x00, 0x01, 0x02, 0x03, 0x04, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x10, 0x11,
+	0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21,
+	0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31,
+	0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F, 0x40, 0x41,
+	0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F, 0x50, 0x51,
+	0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x5B, 0x5C, 0x5D, 0x5E, 0x5F, 0x60, 0x61,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x62, 0x63, 0x64, 0x65,
+	0x66, 0x67, 0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F, 0x70, 0x71, 0x72, 0x73, 0x74, 0x75,
+	0x76, 0x77, 0x78, 0x79, 0x7A, 0x7B, 0x7C, 0x7D, 0x7E, 0x7F, 0x80, 0x81, 0x82, 0x83, 0x84, 0x85,
+	0x86, 0x87, 0x88, 0x89, 0x8A, 0x8B, 0x8C, 0x8D, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x8E, 0x8F, 0xFF, 0xFF, 0xFF, 0xFF, 0x90,
+};
+
+static
+const DWORD uni2oem_bits[] = {
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xF7DF6592,
+	0xC1810040, 0x41810040, 0x00020000, 0x810E00C0, 0x000C0E07, 0x000000C0,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x2F010080, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xFFFE0000, 0xFFFE03FB,
+	0x000003FB, 0x00000000, 0xFFFF0002, 0xFFFFFFFF, 0x0002FFFF, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x33200000, 0x080D0063,
+	0x00000000, 0x80100000, 0x0000001E, 0x00001000, 0x00000000, 0x00000000,
+	0x00480208, 0x00000846, 0x78180000, 0x03FF03FF, 0x03FF0000, 0x00000000,
+	0x00140000, 0x00000000, 0x6402898D, 0x30305FA1, 0x00040000, 0x00000C33,
+	0x020000CC, 0x00000020, 0x00000000, 0x00000000, 0x00040000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0xFFF07FFF, 0xF0000007, 0x003FFFFF,
+	0xFFFF0000, 0x000003FF, 0xFFFFF00F, 0xFFFFFFFF, 0x00000FFF, 0x00000000,
+	0x00040000, 0x30CC03FB, 0x0003C9C3, 0x00000000, 0x5000C060, 0x00000000,
+	0x00000005, 0x000037BB, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x003BFF0F, 0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x000FFFFF, 0xFFFFFFFE,
+	0xFFFFFFFF, 0x007FFFFF, 0x00000000, 0xFFFE0000, 0xFFFFFFFF, 0xFFFFFFFF,
+	0x00007FFF, 0x00000000, 0x00000000, 0x00000000, 0x1FFFFFFF, 0x00000000,
+	0x00000000, 0x8FFFFFFF, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xFFFFFF1F, 0xFFFFFFFF,
+	0x394987FF, 0x00000000, 0x43722F8B, 0x0B042000, 0xE340E82C, 0x40C82800,
+	0x49375944, 0x04407976, 0xA3F02C93, 0x08C50038, 0x0003EE02, 0x35508000,
+	0x1E23E1C8, 0xC4498200, 0x2942AD5A, 0x8060C000, 0xA49A461C, 0x052AC003,
+	0xD6462A44, 0x08003DDA, 0x14208388, 0x01700020, 0x03022021, 0x40AC3000,
+	0x44628620, 0x8A0020A0, 0x80040253, 0x14840402, 0x10047BFB, 0x11E27FA4,
+	0x00A42441, 0x20C01421, 0x70003A50, 0x27430002, 0x208245C9, 0x0FC14630,
+	0x28503C88, 0xA0248602, 0x88062388, 0x40000E19, 0xEB6422AA, 0xCD28001C,
+	0x02E1A120, 0x8200840B, 0x549E279B, 0xA0B38141, 0x85080010, 0x08002061,
+	0x08D02F08, 0x010FBE3E, 0xA803F718, 0x5B080A41, 0x00020504, 0x382A0500,
+	0x00015041, 0x21081910, 0x00000313, 0x04046122, 0x100140D0, 0x40228000,
+	0x40488050, 0x10000008, 0x370006D1, 0x00005E80, 0x941000A0, 0x60000018,
+	0x00900240, 0x00548000, 0x00080000, 0x00100900, 0x00000040, 0x10105020,
+	0x4C022400, 0x06010001, 0x814C2918, 0x08012100, 0x00036485, 0x10214452,
+	0x00080904, 0x0000000D, 0x80004988, 0x16910001, 0x40000765, 0x04338492,
+	0x45928C00, 0x52200016, 0xD0080228, 0x4C084300, 0xC32A40A2, 0x2E009810,
+	0x16708000, 0x40826E84, 0x04B3C390, 0x21187C85, 0x02C8041C, 0x4A001120,
+	0x361B0A48, 0x89005540, 0x9902000A, 0x10400221, 0x04000242, 0x00000044,
+	0x0C040000, 0x00000010, 0x00001216, 0x00000242, 0x00401A20, 0x00000400,
+	0xB5B30009, 0x15230A18, 0x1FE89BA0, 0x8379507C, 0xC09D10FD, 0x0560DBF6,
+	0x0242EF92, 0xDF020110, 0x08226961, 0x02029035, 0x00030000, 0x45AA1A02,
+	0x02000001, 0x28518101, 0x02D26080, 0x00000280, 0x00011800, 0x00009200,
+	0x20000880, 0x35000405, 0x60442000, 0x609E49E6, 0x2A42104C, 0xA1482820,
+	0x802010B1, 0x7B9C000E, 0x14A08490, 0x41E028C1, 0x8C490704, 0x0CC8100D,
+	0x89BA8412, 0x142202C0, 0x0AC05500, 0x92833EC4, 0x43871CA3, 0x22A04703,
+	0x03C03028, 0xA0200801, 0x30448000, 0x000085A3, 0x2225200E, 0x0001B73C,
+	0x8C503220, 0x315D0099, 0x940200A0, 0x0E4B0003, 0x8C20E342, 0xD0910080,
+	0xA3281D94, 0x60C1499C, 0x07134406, 0x44445A90, 0x00000F88, 0x95C40040,
+	0x84477581, 0xC0534402, 0x01082B83, 0x92424000, 0x09A60611, 0x32220800,
+	0x1BDDB384, 0xC08AF000, 0x00020282, 0x6C008800, 0x00219200, 0x8C844180,
+	0x09441308, 0x000007A7, 0x0C418051, 0x00D06002, 0x10D0A000, 0x44003004,
+	0x01000000, 0x07008201, 0x440E0100, 0x08056830, 0x051464B2, 0x441410E6,
+	0x21000011, 0xCBC09C08, 0x40C2E120, 0x41B4304C, 0x9A8310AC, 0x328198B2,
+	0x00849822, 0xBC123369, 0xC03BD6C0, 0x0C53A1A1, 0xEA008A1E, 0x05D8CBF0,
+	0x21C34390, 0x4A1C4805, 0x324002D0, 0xD79D0041, 0xE8B02B09, 0x24527DC0,
+	0xD04BC240, 0xC8ABA000, 0x34A98A80, 0x41C98000, 0x241F8010, 0x487B9200,
+	0x00CC0000, 0x33008406, 0x001B410F, 0x80402000, 0xA0988022, 0x006BA186,
+	0x85A42A30, 0x06044181, 0x00046021, 0xA0010080, 0x46B80400, 0x03A0E90F,
+	0x18200000, 0x081040A0, 0x0001380A, 0xA8000500, 0xC28A0404, 0x2720000A,
+	0x830C0910, 0x00000802, 0x10806211, 0x0808000C, 0x0C08000C, 0x08400000,
+	0x00441410, 0x6404000B, 0x800150C0, 0x8984047E, 0x41400658, 0x94A4C000,
+	0x09DCA862, 0x00001800, 0x000A8100, 0x41900008, 0xE4A14007, 0x64452501,
+	0x0E7D11EE, 0xFB084800, 0x08A81616, 0x0009C92E, 0x4A821800, 0x6B6406A0,
+	0x16000002, 0x83905648, 0x002A73A0, 0x00248000, 0x470288F9, 0x0FAA4D02,
+	0x8E800000, 0x7554B87B, 0xD9402418, 0x040CC880, 0xB0410000, 0x04428C24,
+	0x001A5A34, 0xC1108000, 0x00328046, 0x8106180D, 0xCD920002, 0x74016014,
+	0x00916112, 0x420AC098, 0x8420040F, 0x40029A13, 0xFD228A62, 0x40808188,
+	0x21031000, 0x31010808, 0x07044420, 0x0388B812, 0xA3008900, 0x22020000,
+	0x46001210, 0x00410042, 0x52415680, 0x200052F0, 0x82148610, 0x46021004,
+	0x8035430A, 0xD80060E0, 0x08010041, 0x6C653400, 0xAB0411C1, 0x22040286,
+	0x00000003, 0x00009084, 0x02814015, 0x33000202, 0x38400400, 0xC0C00E20,
+	0x00850030, 0x0D250500, 0x81D04AD0, 0x020C2280, 0x6240B605, 0x62802679,
+	0x080802EA, 0x8579DD67, 0xDEA0081B, 0x40008735, 0xD1000A8C, 0xA22505AA,
+	0x15108440, 0x0080404D, 0x8D220012, 0x058F1968, 0x3A1A9080, 0x85618464,
+	0x2002CCC0, 0x732E0820, 0x0B3420A4, 0x14150004, 0x82002001, 0x08000057,
+	0x00445004, 0x79051212, 0x000940D0, 0x84004000, 0xD844054C, 0x5114409A,
+	0x40000B12, 0x15800201, 0x08002001, 0xC200084A, 0x40020800, 0x98093020,
+	0x18800000, 0x0008E22C, 0x00040004, 0x001410E0, 0x20008020, 0x10009800,
+	0x00827082, 0x1C000288, 0x00014C22, 0x08209100, 0x00404002, 0x44001C00,
+	0x7CC10383, 0x84002121, 0x0002E002, 0xE20A44C0, 0x81260E03, 0x080002D0,
+	0x96902921, 0xB8C24001, 0x00806241, 0xA6510A06, 0x812C0112, 0x0400C600,
+	0xA2800CB0, 0x8640A429, 0x4A028000, 0x02003041, 0x0057BA40, 0x20205001,
+	0x24B08880, 0x01122002, 0x000402D3, 0x00000211, 0x40040080, 0xE0000C82,
+	0x00003008, 0x00081011, 0x81A40208, 0x420E40A0, 0xC0400400, 0x48000081,
+	0x0F912DF5, 0x0629D807, 0x4001007C, 0x824E4546, 0x1008C000, 0xED363005,
+	0x65400C80, 0x0810930B, 0xE8200600, 0x6082C80A, 0x403400CA, 0x12012E02,
+	0x19489004, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x05400000,
+	0x00311000, 0x02A54C00, 0x44105520, 0x23040310, 0x80345422, 0x12010A03,
+	0x01A1126B, 0xA0482000, 0x45400448, 0xE08D8000, 0x28401AF0, 0x04168626,
+	0x4C005018, 0x21120032, 0x0D0005E4, 0x42008A08, 0x00334800, 0x87030860,
+	0x34008501, 0xE4280109, 0x81002045, 0x5C1825A8, 0xD80435A0, 0x02E01C02,
+	0x020000A1, 0x4146C050, 0xA6046800, 0xBB8AF260, 0xC8B60000, 0x600200E2,
+	0x0080023E, 0x03728900, 0x00068681, 0x08880000, 0x41404600, 0x20000E04,
+	0x10481622, 0x22178A00, 0x00007418, 0x21021200, 0x08800200, 0x0420984A,
+	0x12110000, 0x99040002, 0x04022A55, 0x10105000, 0x459A0000, 0xA000B02A,
+	0x0208420A, 0x00002708, 0x08128090, 0x04018740, 0x3020E202, 0x8C800630,
+	0x04C004C4, 0x80002000, 0xD8314000, 0x02000080, 0x00081400, 0x00000218,
+	0x8A100880, 0x40002010, 0x1500010D, 0x00000000, 0x80A04000, 0x01500140,
+	0x80002004, 0x04080004, 0x00000010, 0x4A049001, 0x80000020, 0x0842000C,
+	0x2A8C3041, 0xC085090E, 0x40C42906, 0x00100800, 0xB2308006, 0x21380102,
+	0x030D0080, 0x09400420, 0x80000012, 0x80040410, 0x004888CA, 0x24040602,
+	0x00040001, 0x01100008, 0xA9C8550D, 0x0C522428, 0x48310000, 0x022F624D,
+	0x412830A0, 0xD205057B, 0x1844A894, 0x45C26CC2, 0x2ED14017, 0x02081901,
+	0x1500C202, 0x20919040, 0x044D0401, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0x80800000, 0x04201542, 0x06000C02, 0x60001404, 0xB9D99F87,
+	0x540A059F, 0x3810245D, 0x004825B0, 0x00000000, 0x00000000, 0x00990850,
+	0x02000420, 0x44080108, 0x28009840, 0x0008810A, 0x40018400, 0x00210400,
+	0x82000794, 0x00500001, 0x00002482, 0x00001C00, 0x80043C01, 0x49000800,
+	0xF83C0228, 0xCB0886C0, 0xA0006230, 0x00000004, 0x18000000, 0x0007A148,
+	0x00124024, 0x22852C40, 0xE6B3A96F, 0x5126400F, 0x723B6C86, 0xB5A4E20B,
+	0x0222859F, 0x0123854C, 0x40000402, 0x20202102, 0x02240004, 0x00042080,
+	0x00047E00, 0x01A01604, 0x10042A80, 0x0032D800, 0x3183FA81, 0x00200488,
+	0x40872000, 0x84100000, 0x48800221, 0x00000074, 0x114A0029, 0x02C80000,
+	0x00049000, 0x11000410, 0xC5010010, 0x0000C957, 0x08102D00, 0x50204000,
+	0x04501000, 0x00013088, 0x40020008, 0x00400012, 0x01000010, 0x01200820,
+	0x08060010, 0xA0000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0x00800000, 0x011E8A09, 0x18022138,
+	0x10700480, 0x00000006, 0x10000000, 0x88044402, 0xF8013815, 0x21E9041C,
+	0x1B306C60, 0x08820588, 0x1A607AF3, 0x0AC5870C, 0x524A00C1, 0x22050080,
+	0x50420114, 0x04902206, 0x0000A800, 0x00002901, 0x10080840, 0x88480000,
+	0x018F156F, 0x0B012000, 0x45107040, 0x000088A0, 0x00000000, 0x00028100,
+	0x98000090, 0x7010E006, 0x41091608, 0x00000101, 0x00963A20, 0x00000000,
+	0x22400000, 0x021A7120, 0xA2270002, 0x80022000, 0x0200C102, 0x00C10800,
+	0x8CA02029, 0x00000624, 0x00000000, 0x01000100, 0x01180000, 0x00004020,
+	0x04000000, 0x10020480, 0x0410803E, 0x00008000, 0x80024000, 0x00004800,
+	0x00400200, 0x00000110, 0x00252000, 0x08040020, 0x00800280, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0x005802A0, 0x08000200, 0x08000140,
+	0x20020000, 0x00041003, 0x00000000, 0x00108200, 0x00800010, 0x07040000,
+	0x44000000, 0x00000000, 0x00000000, 0xA2200000, 0xA08C0000, 0x48300020,
+	0x59126008, 0x00100100, 0x00084180, 0x08000001, 0x80044C00, 0x00801482,
+	0x10212000, 0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x0000000F,
+	0x00000000, 0x00000000, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+	0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x00000FFF, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0x0000006F,
+};
+
+static
+const WORD uni2oem_base[] = {
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0015, 0x001B,
+	0x0020, 0x0021, 0x0028, 0x0030, 0x0032, 0x0032, 0x0032, 0x0032,
+	0x0032, 0x0032, 0x0032, 0x0032, 0x0032, 0x0032, 0x0032, 0x0039,
+	0x0039, 0x0039, 0x0039, 0x0039, 0x0039, 0x0048, 0x0060, 0x0069,
+	0x0069, 0x007A, 0x009A, 0x00AB, 0x00AB, 0x00AB, 0x00AB, 0x00AB,
+	0x00AB, 0x00B0, 0x00B8, 0x00B8, 0x00BA, 0x00BE, 0x00BF, 0x00BF,
+	0x00BF, 0x00C3, 0x00C7, 0x00CD, 0x00E1, 0x00EB, 0x00EB, 0x00ED,
+	0x00ED, 0x00F8, 0x0105, 0x0106, 0x010C, 0x0111, 0x0112, 0x0112,
+	0x0112, 0x0113, 0x0113, 0x0113, 0x0113, 0x0113, 0x0113, 0x0113,
+	0x0113, 0x0113, 0x0113, 0x0113, 0x012E, 0x0135, 0x014B, 0x015B,
+	0x0165, 0x017D, 0x019D, 0x01A9, 0x01A9, 0x01AA, 0x01B9, 0x01C3,
+	0x01C3, 0x01C9, 0x01C9, 0x01CB, 0x01D6, 0x01D6, 0x01D6, 0x01D6,
+	0x01D6, 0x01E7, 0x01E7, 0x0206, 0x0226, 0x023A, 0x0259, 0x0279,
+	0x0290, 0x0290, 0x029F, 0x02BF, 0x02DF, 0x02EE, 0x02EE, 0x02EE,
+	0x02EE, 0x030B, 0x030B, 0x030B, 0x0328, 0x0328, 0x0328, 0x0328,
+	0x0328, 0x0328, 0x0328, 0x0328, 0x0328, 0x0345, 0x0365, 0x0378,
+	0x0378, 0x0388, 0x038D, 0x039A, 0x03A0, 0x03AE, 0x03BA, 0x03C9,
+	0x03D1, 0x03DA, 0x03E1, 0x03EF, 0x03F7, 0x0405, 0x040A, 0x0417,
+	0x0420, 0x042D, 0x0438, 0x0440, 0x0445, 0x044B, 0x0452, 0x045B,
+	0x0461, 0x0468, 0x046E, 0x047D, 0x048D, 0x0494, 0x049B, 0x04A4,
+	0x04AC, 0x04B6, 0x04C2, 0x04CC, 0x04D4, 0x04DD, 0x04E4, 0x04F3,
+	0x04FD, 0x0506, 0x050D, 0x051E, 0x0529, 0x052E, 0x0533, 0x053D,
+	0x054D, 0x055B, 0x0565, 0x0569, 0x0571, 0x0576, 0x057D, 0x0582,
+	0x0589, 0x058F, 0x0593, 0x0599, 0x059B, 0x05A6, 0x05AC, 0x05B2,
+	0x05B6, 0x05BA, 0x05BE, 0x05BF, 0x05C2, 0x05C3, 0x05C8, 0x05CE,
+	0x05D2, 0x05DC, 0x05E0, 0x05E8, 0x05F0, 0x05F4, 0x05F7, 0x05FD,
+	0x0604, 0x060C, 0x0616, 0x061F, 0x0626, 0x062D, 0x0634, 0x063F,
+	0x0647, 0x064E, 0x0658, 0x0664, 0x0670, 0x0678, 0x067E, 0x068A,
+	0x0692, 0x0699, 0x069E, 0x06A2, 0x06A4, 0x06A7, 0x06A8, 0x06AD,
+	0x06B0, 0x06B5, 0x06B6, 0x06C2, 0x06CC, 0x06DC, 0x06EB, 0x06FA,
+	0x070A, 0x0717, 0x0721, 0x072B, 0x0733, 0x0735, 0x0740, 0x0742,
+	0x074A, 0x0752, 0x0754, 0x0757, 0x075A, 0x075D, 0x0764, 0x0769,
+	0x0778, 0x0781, 0x0789, 0x0790, 0x079D, 0x07A5, 0x07AF, 0x07B9,
+	0x07C2, 0x07CE, 0x07D5, 0x07DD, 0x07EB, 0x07F9, 0x0803, 0x080B,
+	0x0810, 0x0815, 0x081C, 0x0825, 0x0830, 0x0839, 0x0845, 0x084B,
+	0x0854, 0x085F, 0x0866, 0x0873, 0x087F, 0x0889, 0x0893, 0x0899,
+	0x08A1, 0x08AE, 0x08B7, 0x08C0, 0x08C6, 0x08D0, 0x08D6, 0x08E7,
+	0x08F0, 0x08F4, 0x08FA, 0x08FF, 0x0907, 0x090F, 0x0917, 0x091F,
+	0x0925, 0x092B, 0x0930, 0x0931, 0x0937, 0x093D, 0x0945, 0x0950,
+	0x095A, 0x095E, 0x096A, 0x0973, 0x097E, 0x098A, 0x0996, 0x099D,
+	0x09AC, 0x09BA, 0x09C6, 0x09D2, 0x09E1, 0x09EC, 0x09F6, 0x09FE,
+	0x0A0B, 0x0A18, 0x0A25, 0x0A30, 0x0A3A, 0x0A45, 0x0A4C, 0x0A55,
+	0x0A60, 0x0A64, 0x0A6C, 0x0A76, 0x0A79, 0x0A81, 0x0A8C, 0x0A97,
+	0x0A9E, 0x0AA3, 0x0AA7, 0x0AAF, 0x0ABC, 0x0ABF, 0x0AC4, 0x0ACA,
+	0x0ACF, 0x0AD7, 0x0ADE, 0x0AE6, 0x0AE8, 0x0AEF, 0x0AF3, 0x0AF8,
+	0x0AFA, 0x0AFF, 0x0B06, 0x0B0C, 0x0B18, 0x0B20, 0x0B28, 0x0B35,
+	0x0B37, 0x0B3B, 0x0B40, 0x0B4B, 0x0B55, 0x0B66, 0x0B70, 0x0B7A,
+	0x0B84, 0x0B8B, 0x0B97, 0x0B9B, 0x0BA6, 0x0BB0, 0x0BB3, 0x0BC0,
+	0x0BCD, 0x0BD2, 0x0BE4, 0x0BEE, 0x0BF5, 0x0BFA, 0x0C02, 0x0C0C,
+	0x0C11, 0x0C18, 0x0C21, 0x0C2A, 0x0C33, 0x0C3B, 0x0C44, 0x0C4C,
+	0x0C55, 0x0C64, 0x0C6A, 0x0C6F, 0x0C75, 0x0C7C, 0x0C86, 0x0C8D,
+	0x0C90, 0x0C96, 0x0C9A, 0x0CA4, 0x0CAC, 0x0CB4, 0x0CBA, 0x0CC4,
+	0x0CCD, 0x0CD1, 0x0CDC, 0x0CE7, 0x0CEE, 0x0CF0, 0x0CF4, 0x0CFB,
+	0x0D01, 0x0D06, 0x0D0E, 0x0D13, 0x0D1B, 0x0D26, 0x0D2C, 0x0D37,
+	0x0D43, 0x0D4B, 0x0D5E, 0x0D6B, 0x0D74, 0x0D7D, 0x0D89, 0x0D90,
+	0x0D96, 0x0D9E, 0x0DAB, 0x0DB5, 0x0DC0, 0x0DC8, 0x0DD3, 0x0DDD,
+	0x0DE3, 0x0DE7, 0x0DED, 0x0DF2, 0x0DFD, 0x0E03, 0x0E06, 0x0E11,
+	0x0E1B, 0x0E21, 0x0E27, 0x0E2A, 0x0E31, 0x0E34, 0x0E3C, 0x0E3F,
+	0x0E47, 0x0E49, 0x0E4F, 0x0E52, 0x0E56, 0x0E5D, 0x0E63, 0x0E69,
+	0x0E6E, 0x0E71, 0x0E76, 0x0E83, 0x0E89, 0x0E8E, 0x0E98, 0x0EA2,
+	0x0EA7, 0x0EB2, 0x0EBB, 0x0EC1, 0x0ECC, 0x0ED4, 0x0ED9, 0x0EE2,
+	0x0EEC, 0x0EF1, 0x0EF6, 0x0F01, 0x0F06, 0x0F0E, 0x0F13, 0x0F1A,
+	0x0F1D, 0x0F20, 0x0F27, 0x0F2A, 0x0F2E, 0x0F35, 0x0F3D, 0x0F41,
+	0x0F45, 0x0F56, 0x0F62, 0x0F69, 0x0F75, 0x0F79, 0x0F87, 0x0F8F,
+	0x0F98, 0x0F9F, 0x0FA8, 0x0FB0, 0x0FB8, 0x0FC0, 0x0FC0, 0x0FC0,
+	0x0FC0, 0x0FC0, 0x0FC3, 0x0FC7, 0x0FCF, 0x0FD7, 0x0FDE, 0x0FE7,
+	0x0FEE, 0x0FF9, 0x0FFE, 0x1005, 0x100D, 0x1017, 0x1021, 0x1028,
+	0x102F, 0x1038, 0x103E, 0x1044, 0x104D, 0x1054, 0x105D, 0x1063,
+	0x106F, 0x107A, 0x1082, 0x1086, 0x108F, 0x1097, 0x10A7, 0x10AF,
+	0x10B6, 0x10BD, 0x10C6, 0x10CD, 0x10D0, 0x10D6, 0x10DB, 0x10E3,
+	0x10EC, 0x10F2, 0x10F7, 0x10FA, 0x1102, 0x1106, 0x110C, 0x1115,
+	0x1119, 0x1120, 0x1128, 0x112E, 0x1133, 0x1139, 0x1140, 0x1148,
+	0x1150, 0x1157, 0x1159, 0x1161, 0x1163, 0x1166, 0x1169, 0x116F,
+	0x1172, 0x1179, 0x1179, 0x117D, 0x1182, 0x1185, 0x1188, 0x1189,
+	0x1190, 0x1192, 0x1197, 0x11A1, 0x11AB, 0x11B4, 0x11B6, 0x11BF,
+	0x11C6, 0x11CC, 0x11D1, 0x11D4, 0x11D8, 0x11E0, 0x11E6, 0x11E8,
+	0x11EB, 0x11F9, 0x1202, 0x1207, 0x1214, 0x121C, 0x122A, 0x1234,
+	0x1241, 0x124E, 0x1254, 0x125B, 0x1262, 0x1269, 0x1269, 0x1269,
+	0x1269, 0x1269, 0x126B, 0x1272, 0x1277, 0x127C, 0x1290, 0x129D,
+	0x12A8, 0x12B0, 0x12B0, 0x12B0, 0x12B7, 0x12BA, 0x12BF, 0x12C5,
+	0x12CA, 0x12CE, 0x12D1, 0x12D9, 0x12DC, 0x12E0, 0x12E3, 0x12EA,
+	0x12EE, 0x12FA, 0x1305, 0x130C, 0x130D, 0x130F, 0x1317, 0x131C,
+	0x1325, 0x1339, 0x1344, 0x1354, 0x1363, 0x136F, 0x1379, 0x137C,
+	0x1381, 0x1385, 0x1388, 0x138F, 0x1396, 0x139C, 0x13A3, 0x13B1,
+	0x13B5, 0x13BB, 0x13BE, 0x13C4, 0x13C8, 0x13D0, 0x13D4, 0x13D7,
+	0x13DB, 0x13E1, 0x13EA, 0x13F0, 0x13F4, 0x13F8, 0x13FD, 0x1400,
+	0x1403, 0x1405, 0x1409, 0x140D, 0x140F, 0x140F, 0x140F, 0x140F,
+	0x140F, 0x140F, 0x140F, 0x140F, 0x1410, 0x141A, 0x1422, 0x1428,
+	0x142A, 0x142B, 0x1431, 0x143D, 0x1448, 0x1454, 0x145B, 0x146B,
+	0x1477, 0x1480, 0x1485, 0x148C, 0x1493, 0x1496, 0x149A, 0x149E,
+	0x14A2, 0x14B1, 0x14B6, 0x14BE, 0x14C2, 0x14C2, 0x14C5, 0x14CA,
+	0x14D3, 0x14DB, 0x14DD, 0x14E6, 0x14E6, 0x14E9, 0x14F2, 0x14FA,
+	0x14FD, 0x1502, 0x1506, 0x150F, 0x1513, 0x1513, 0x1515, 0x1518,
+	0x151A, 0x151B, 0x151F, 0x1527, 0x1528, 0x152B, 0x152D, 0x152F,
+	0x1531, 0x1535, 0x1538, 0x153B, 0x153B, 0x153B, 0x153B, 0x153B,
+	0x1541, 0x1543, 0x1546, 0x1548, 0x154C, 0x154C, 0x154F, 0x1551,
+	0x1555, 0x1557, 0x1557, 0x1557, 0x155B, 0x1560, 0x1565, 0x156E,
+	0x1570, 0x1574, 0x1576, 0x157B, 0x1580, 0x1584, 0x1584, 0x1584,
+	0x1584, 0x15A4, 0x15C4, 0x15E4, 0x1604, 0x1624, 0x1644, 0x1664,
+	0x1684, 0x16A4, 0x16C4, 0x16E4, 0x1704, 0x1724, 0x1744, 0x1764,
+	0x1784, 0x17A4, 0x17C4, 0x17E4, 0x1804, 0x1824, 0x1844, 0x1864,
+	0x1884, 0x18A4, 0x18C4, 0x18E4, 0x1904, 0x1924, 0x1944, 0x1964,
+	0x1984, 0x19A4, 0x19C4, 0x19E4, 0x1A04, 0x1A24, 0x1A44, 0x1A64,
+	0x1A84, 0x1AA4, 0x1AC4, 0x1AE4, 0x1B04, 0x1B24, 0x1B44, 0x1B64,
+	0x1B84, 0x1BA4, 0x1BC4, 0x1BE4, 0x1C04, 0x1C24, 0x1C44, 0x1C64,
+	0x1C84, 0x1CA4, 0x1CC4, 0x1CE4, 0x1D04, 0x1D24, 0x1D44, 0x1D64,
+	0x1D84, 0x1DA4, 0x1DC4, 0x1DE4, 0x1E04, 0x1E24, 0x1E44, 0x1E64,
+	0x1E84, 0x1EA4, 0x1EC4, 0x1EE4, 0x1F04, 0x1F24, 0x1F44, 0x1F64,
+	0x1F84, 0x1FA4, 0x1FC4, 0x1FE4, 0x2004, 0x2024, 0x2044, 0x2064,
+	0x2084, 0x20A4, 0x20C4, 0x20E4, 0x2104, 0x2124, 0x2144, 0x2164,
+	0x2184, 0x21A4, 0x21C4, 0x21E4, 0x2204, 0x2224, 0x2244, 0x2264,
+	0x2284, 0x22A4, 0x22C4, 0x22E4, 0x2304, 0x2324, 0x2344, 0x2364,
+	0x2384, 0x23A4, 0x23C4, 0x23E4, 0x2404, 0x2424, 0x2444, 0x2464,
+	0x2484, 0x24A4, 0x24C4, 0x24E4, 0x2504, 0x2524, 0x2544, 0x2564,
+	0x2584, 0x25A4, 0x25C4, 0x25E4, 0x2604, 0x2624, 0x2644, 0x2664,
+	0x2684, 0x26A4, 0x26C4, 0x26E4, 0x2704, 0x2724, 0x2744, 0x2764,
+	0x2784, 0x27A4, 0x27C4, 0x27E4, 0x2804, 0x2824, 0x2844, 0x2864,
+	0x2884, 0x28A4, 0x28C4, 0x28E4, 0x2904, 0x2924, 0x2944, 0x2964,
+	0x2984, 0x29A4, 0x29C4, 0x29E4, 0x2A04, 0x2A24, 0x2A44, 0x2A64,
+	0x2A84, 0x2AA4, 0x2AC4, 0x2AE4, 0x2B04, 0x2B24, 0x2B44, 0x2B64,
+	0x2B84, 0x2BA4, 0x2BC4, 0x2BE4, 0x2C04, 0x2C24, 0x2C44, 0x2C64,
+	0x2C84, 0x2CA4, 0x2CC4, 0x2CE4, 0x2D04, 0x2D24, 0x2D44, 0x2D64,
+	0x2D84, 0x2DA4, 0x2DC4, 0x2DE4, 0x2E04, 0x2E24, 0x2E44, 0x2E64,
+	0x2E84, 0x2EA4, 0x2EC4, 0x2EE4, 0x2F04, 0x2F24, 0x2F44, 0x2F64,
+	0x2F84, 0x2FA4, 0x2FC4, 0x2FE4, 0x3004, 0x3024, 0x3044, 0x3064,
+	0x3084, 0x30A4, 0x30C4, 0x30E4, 0x3104, 0x3124, 0x3144, 0x3164,
+	0x3184, 0x31A4, 0x31C4, 0x31E4, 0x3204, 0x3224, 0x3244, 0x3264,
+	0x3284, 0x32A4, 0x32C4, 0x32E4, 0x3304, 0x3324, 0x3344, 0x3364,
+	0x3384, 0x33A4, 0x33C4, 0x33E4, 0x3404, 0x3424, 0x3444, 0x3464,
+	0x3484, 0x34A4, 0x34C4, 0x34E4, 0x3504, 0x3524, 0x3544, 0x3564,
+	0x3584, 0x35A4, 0x35C4, 0x35E4, 0x3604, 0x3624, 0x3644, 0x3664,
+	0x3684, 0x36A4, 0x36C4, 0x36E4, 0x3704, 0x3724, 0x3744, 0x3764,
+	0x3784, 0x37A4, 0x37C4, 0x37E4, 0x3804, 0x3824, 0x3844, 0x3864,
+	0x3884, 0x38A4, 0x38C4, 0x38E4, 0x3904, 0x3924, 0x3944, 0x3964,
+	0x3984, 0x39A4, 0x39C4, 0x39E4, 0x3A04, 0x3A24, 0x3A44, 0x3A64,
+	0x3A84, 0x3AA4, 0x3AC4, 0x3AE4, 0x3B04, 0x3B24, 0x3B44, 0x3B64,
+	0x3B84, 0x3BA4, 0x3BC4, 0x3BE4, 0x3C04, 0x3C24, 0x3C44, 0x3C64,
+	0x3C84, 0x3CA4, 0x3CC4, 0x3CE4, 0x3D04, 0x3D24, 0x3D44, 0x3D64,
+	0x3D84, 0x3DA4, 0x3DC4, 0x3DE4, 0x3E04, 0x3E24, 0x3E44, 0x3E64,
+	0x3E84, 0x3EA4, 0x3EC4, 0x3EE4, 0x3F04, 0x3F24, 0x3F44, 0x3F64,
+	0x3F84, 0x3FA4, 0x3FC4, 0x3FE4, 0x4004, 0x4024, 0x4044, 0x4064,
+	0x4084, 0x40A4, 0x40C4, 0x40E4, 0x4104, 0x4124, 0x4128, 0x4128,
+	0x4128, 0x4148, 0x4168, 0x4188, 0x41A8, 0x41C8, 0x41E8, 0x4208,
+	0x4228, 0x4234, 0x4234, 0x4234, 0x4234, 0x4234, 0x4234, 0x4234,
+	0x4234, 0x4253, 0x4273, 0x4292, 0x4292, 0x4292, 0x4292, 0x4292,
+};
+
+static
+const WCHAR uni2oem_code[] = {
+	0xA2AE, 0xA2B4, 0xA1D7, 0xA1A7, 0xA8A3, 0xA1A9, 0xA2E7, 0xA1C6,
+	0xA1BE, 0xA9F7, 0xA9F8, 0xA2A5, 0xA2D2, 0xA1A4, 0xA2AC, 0xA9F6,
+	0xA8AC, 0xA8F9, 0xA8F6, 0xA8FA, 0xA2AF, 0xA8A1, 0xA8A2, 0xA1BF,
+	0xA8AA, 0xA8AD, 0xA9AC, 0xA9A1, 0xA9A3, 0xA1C0, 0xA9AA, 0xA9AD,
+	0xA9A2, 0xA8A4, 0xA9A4, 0xA9A5, 0xA8A6, 0xA9A6, 0xA9A7, 0xA8A8,
+	0xA9A8, 0xA8A9, 0xA9A9, 0xA9B0, 0xA8AF, 0xA9AF, 0xA8AB, 0xA9AB,
+	0xA8AE, 0xA9AE, 0xA2A7, 0xA2B0, 0xA2A8, 0xA2AB, 0xA2AA, 0xA2AD,
+	0xA2A9, 0xA5C1, 0xA5C2, 0xA5C3, 0xA5C4, 0xA5C5, 0xA5C6, 0xA5C7,
+	0xA5C8, 0xA5C9, 0xA5CA, 0xA5CB, 0xA5CC, 0xA5CD, 0xA5CE, 0xA5CF,
+	0xA5D0, 0xA5D1, 0xA5D2, 0xA5D3, 0xA5D4, 0xA5D5, 0xA5D6, 0xA5D7,
+	0xA5D8, 0xA5E1, 0xA5E2, 0xA5E3, 0xA5E4, 0xA5E5, 0xA5E6, 0xA5E7,
+	0xA5E8, 0xA5E9, 0xA5EA, 0xA5EB, 0xA5EC, 0xA5ED, 0xA5EE, 0xA5EF,
+	0xA5F0, 0xA5F1, 0xA5F2, 0xA5F3, 0xA5F4, 0xA5F5, 0xA5F6, 0xA5F7,
+	0xA5F8, 0xACA7, 0xACA1, 0xACA2, 0xACA3, 0xACA4, 0xACA5, 0xACA6,
+	0xACA8, 0xACA9, 0xACAA, 0xACAB, 0xACAC, 0xACAD, 0xACAE, 0xACAF,
+	0xACB0, 0xACB1, 0xACB2, 0xACB3, 0xACB4, 0xACB5, 0xACB6, 0xACB7,
+	0xACB8, 0xACB9, 0xACBA, 0xACBB, 0xACBC, 0xACBD, 0xACBE, 0xACBF,
+	0xACC0, 0xACC1, 0xACD1, 0xACD2, 0xACD3, 0xACD4, 0xACD5, 0xACD6,
+	0xACD8, 0xACD9, 0xACDA, 0xACDB, 0xACDC, 0xACDD, 0xACDE, 0xACDF,
+	0xACE0, 0xACE1, 0xACE2, 0xACE3, 0xACE4, 0xACE5, 0xACE6, 0xACE7,
+	0xACE8, 0xACE9, 0xACEA, 0xACEB, 0xACEC, 0xACED, 0xACEE, 0xACEF,
+	0xACF0, 0xACF1, 0xACD7, 0xA1AA, 0xA1AE, 0xA1AF, 0xA1B0, 0xA1B1,
+	0xA2D3, 0xA2D4, 0xA1A5, 0xA1A6, 0xA2B6, 0xA1C7, 0xA1C8, 0xA1D8,
+	0xA9F9, 0xA9FA, 0xA9FB, 0xA9FC, 0xA9FD, 0xA9FE, 0xA2E6, 0xA1C9,
+	0xA2B5, 0xA7A4, 0xA2E0, 0xA2E5, 0xA2E2, 0xA7D9, 0xA1CA, 0xA8F7,
+	0xA8F8, 0xA8FB, 0xA8FC, 0xA8FD, 0xA8FE, 0xA5B0, 0xA5B1, 0xA5B2,
+	0xA5B3, 0xA5B4, 0xA5B5, 0xA5B6, 0xA5B7, 0xA5B8, 0xA5B9, 0xA5A1,
+	0xA5A2, 0xA5A3, 0xA5A4, 0xA5A5, 0xA5A6, 0xA5A7, 0xA5A8, 0xA5A9,
+	0xA5AA, 0xA1E7, 0xA1E8, 0xA1E6, 0xA1E9, 0xA1EA, 0xA2D5, 0xA2D8,
+	0xA2D6, 0xA2D9, 0xA2D7, 0xA2A1, 0xA2A2, 0xA2A3, 0xA1D3, 0xA2A4,
+	0xA1D4, 0xA1F4, 0xA1F5, 0xA2B3, 0xA2B2, 0xA1EE, 0xA1F0, 0xA1C4,
+	0xA1D0, 0xA1AB, 0xA1FC, 0xA1FD, 0xA1FB, 0xA1FA, 0xA1F2, 0xA1F3,
+	0xA2B1, 0xA1C5, 0xA1F1, 0xA1AD, 0xA1EF, 0xA1D6, 0xA1C1, 0xA1D5,
+	0xA1C2, 0xA1C3, 0xA1EC, 0xA1ED, 0xA1F8, 0xA1F9, 0xA1F6, 0xA1F7,
+	0xA2C1, 0xA1D1, 0xA1D2, 0xA8E7, 0xA8E8, 0xA8E9, 0xA8EA, 0xA8EB,
+	0xA8EC, 0xA8ED, 0xA8EE, 0xA8EF, 0xA8F0, 0xA8F1, 0xA8F2, 0xA8F3,
+	0xA8F4, 0xA8F5, 0xA9E7, 0xA9E8, 0xA9E9, 0xA9EA, 0xA9EB, 0xA9EC,
+	0xA9ED, 0xA9EE, 0xA9EF, 0xA9F0, 0xA9F1, 0xA9F2, 0xA9F3, 0xA9F4,
+	0xA9F5, 0xA9CD, 0xA9CE, 0xA9CF, 0xA9D0, 0xA9D1, 0xA9D2, 0xA9D3,
+	0xA9D4, 0xA9D5, 0xA9D6, 0xA9D7, 0xA9D8, 0xA9D9, 0xA9DA, 0xA9DB,
+	0xA9DC, 0xA9DD, 0xA9DE, 0xA9DF, 0xA9E0, 0xA9E1, 0xA9E2, 0xA9E3,
+	0xA9E4, 0xA9E5, 0xA9E6, 0xA8CD, 0xA8CE, 0xA8CF, 0xA8D0, 0xA8D1,
+	0xA8D2, 0xA8D3, 0xA8D4, 0xA8D5, 0xA8D6, 0xA8D7, 0xA8D8, 0xA8D9,
+	0xA8DA, 0xA8DB, 0xA8DC, 0xA8DD, 0xA8DE, 0xA8DF, 0xA8E0, 0xA8E1,
+	0xA8E2, 0xA8E3, 0xA8E4, 0xA8E5, 0xA8E6, 0xA6A1, 0xA6AC, 0xA6A2,
+	0xA6AD, 0xA6A3, 0xA6C8, 0xA6C7, 0xA6AE, 0xA6A4, 0xA6C2, 0xA6C1,
+	0xA6AF, 0xA6A6, 0xA6C6, 0xA6C5, 0xA6B1, 0xA6A5, 0xA6C4, 0xA6C3,
+	0xA6B0, 0xA6A7, 0xA6BC, 0xA6C9, 0xA6CA, 0xA6B7, 0xA6CB, 0xA6CC,
+	0xA6B2, 0xA6A9, 0xA6BE, 0xA6CD, 0xA6CE, 0xA6B9, 0xA6CF, 0xA6D0,
+	0xA6B4, 0xA6A8, 0xA6D1, 0xA6D2, 0xA6B8, 0xA6BD, 0xA6D3, 0xA6D4,
+	0xA6B3, 0xA6AA, 0xA6D5, 0xA6D6, 0xA6BA, 0xA6BF, 0xA6D7, 0xA6D8,
+	0xA6B5, 0xA6AB, 0xA6D9, 0xA6DA, 0xA6BB, 0xA6DB, 0xA6DC, 0xA6C0,
+	0xA6DD, 0xA6DE, 0xA6DF, 0xA6E0, 0xA6E1, 0xA6E2, 0xA6E3, 0xA6E4,
+	0xA6B6, 0xA2C6, 0xA1E1, 0xA1E0, 0xA2C3, 0xA2C7, 0xA2C8, 0xA2CB,
+	0xA2CA, 0xA2C9, 0xA2CC, 0xA1E3, 0xA1E2, 0xA2BA, 0xA2B9, 0xA1E5,
+	0xA1E4, 0xA2B8, 0xA2B7, 0xA1DF, 0xA1DE, 0xA2C2, 0xA1DB, 0xA1DD,
+	0xA1DC, 0xA2C4, 0xA2C5, 0xA1DA, 0xA1D9, 0xA2CF, 0xA2CE, 0xA2D0,
+	0xA2D1, 0xA1CF, 0xA1CE, 0xA2BC, 0xA2BD, 0xA2C0, 0xA2BB, 0xA2BE,
+	0xA2BF, 0xA2CD, 0xA2DB, 0xA2DC, 0xA2DD, 0xA2DA, 0xA1A1, 0xA1A2,
+	0xA1A3, 0xA1A8, 0xA1B4, 0xA1B5, 0xA1B6, 0xA1B7, 0xA1B8, 0xA1B9,
+	0xA1BA, 0xA1BB, 0xA1BC, 0xA1BD, 0xA1EB, 0xA1B2, 0xA1B3, 0xAAA1,
+	0xAAA2, 0xAAA3, 0xAAA4, 0xAAA5, 0xAAA6, 0xAAA7, 0xAAA8, 0xAAA9,
+	0xAAAA, 0xAAAB, 0xAAAC, 0xAAAD, 0xAAAE, 0xAAAF, 0xAAB0, 0xAAB1,
+	0xAAB2, 0xAAB3, 0xAAB4, 0xAAB5, 0xAAB6, 0xAAB7, 0xAAB8, 0xAAB9,
+	0xAABA, 0xAABB, 0xAABC, 0xAABD, 0xAABE, 0xAABF, 0xAAC0, 0xAAC1,
+	0xAAC2, 0xAAC3, 0xAAC4, 0xAAC5, 0xAAC6, 0xAAC7, 0xAAC8, 0xAAC9,
+	0xAACA, 0xAACB, 0xAACC, 0xAACD, 0xAACE, 0xAACF, 0xAAD0, 0xAAD1,
+	0xAAD2, 0xAAD3, 0xAAD4, 0xAAD5, 0xAAD6, 0xAAD7, 0xAAD8, 0xAAD9,
+	0xAADA, 0xAADB, 0xAADC, 0xAADD, 0xAADE, 0xAADF, 0xAAE0, 0xAAE1,
+	0xAAE2, 0xAAE3, 0xAAE4, 0xAAE5, 0xAAE6, 0xAAE7, 0xAAE8, 0xAAE9,
+	0xAAEA, 0xAAEB, 0xAAEC, 0xAAED, 0xAAEE, 0xAAEF, 0xAAF0, 0xAAF1,
+	0xAAF2, 0xAAF3, 0xABA1, 0xABA2, 0xABA3, 0xABA4, 0xABA5, 0xABA6,
+	0xABA7, 0xABA8, 0xABA9, 0xABAA, 0xABAB, 0xABAC, 0xABAD, 0xABAE,
+	0xABAF, 0xABB0, 0xABB1, 0xABB2, 0xABB3, 0xABB4, 0xABB5, 0xABB6,
+	0xABB7, 0xABB8, 0xABB9, 0xABBA, 0xABBB, 0xABBC, 0xABBD, 0xABBE,
+	0xABBF, 0xABC0, 0xABC1, 0xABC2, 0xABC3, 0xABC4, 0xABC5, 0xABC6,
+	0xABC7, 0xABC8, 0xABC9, 0xABCA, 0xABCB, 0xABCC, 0xABCD, 0xABCE,
+	0xABCF, 0xABD0, 0xABD1, 0xABD2, 0xABD3, 0xABD4, 0xABD5, 0xABD6,
+	0xABD7, 0xABD8, 0xABD9, 0xABDA, 0xABDB, 0xABDC, 0xABDD, 0xABDE,
+	0xABDF, 0xABE0, 0xABE1, 0xABE2, 0xABE3, 0xABE4, 0xABE5, 0xABE6,
+	0xABE7, 0xABE8, 0xABE9, 0xABEA, 0xABEB, 0xABEC, 0xABED, 0xABEE,
+	0xABEF, 0xABF0, 0xABF1, 0xABF2, 0xABF3, 0xABF4, 0xABF5, 0xABF6,
+	0xA4A1, 0xA4A2, 0xA4A3, 0xA4A4, 0xA4A5, 0xA4A6, 0xA4A7, 0xA4A8,
+	0xA4A9, 0xA4AA, 0xA4AB, 0xA4AC, 0xA4AD, 0xA4AE, 0xA4AF, 0xA4B0,
+	0xA4B1, 0xA4B2, 0xA4B3, 0xA4B4, 0xA4B5, 0xA4B6, 0xA4B7, 0xA4B8,
+	0xA4B9, 0xA4BA, 0xA4BB, 0xA4BC, 0xA4BD, 0xA4BE, 0xA4BF, 0xA4C0,
+	0xA4C1, 0xA4C2, 0xA4C3, 0xA4C4, 0xA4C5, 0xA4C6, 0xA4C7, 0xA4C8,
+	0xA4C9, 0xA4CA, 0xA4CB, 0xA4CC, 0xA4CD, 0xA4CE, 0xA4CF, 0xA4D0,
+	0xA4D1, 0xA4D2, 0xA4D3, 0xA4D4, 0xA4D5, 0xA4D6, 0xA4D7, 0xA4D8,
+	0xA4D9, 0xA4DA, 0xA4DB, 0xA4DC, 0xA4DD, 0xA4DE, 0xA4DF, 0xA4E0,
+	0xA4E1, 0xA4E2, 0xA4E3, 0xA4E4, 0xA4E5, 0xA4E6, 0xA4E7, 0xA4E8,
+	0xA4E9, 0xA4EA, 0xA4EB, 0xA4EC, 0xA4ED, 0xA4EE, 0xA4EF, 0xA4F0,
+	0xA4F1, 0xA4F2, 0xA4F3, 0xA4F4, 0xA4F5, 0xA4F6, 0xA4F7, 0xA4F8,
+	0xA4F9, 0xA4FA, 0xA4FB, 0xA4FC, 0xA4FD, 0xA4FE, 0xA9B1, 0xA9B2,
+	0xA9B3, 0xA9B4, 0xA9B5, 0xA9B6, 0xA9B7, 0xA9B8, 0xA9B9, 0xA9BA,
+	0xA9BB, 0xA9BC, 0xA9BD, 0xA9BE, 0xA9BF, 0xA9C0, 0xA9C1, 0xA9C2,
+	0xA9C3, 0xA9C4, 0xA9C5, 0xA9C6, 0xA9C7, 0xA9C8, 0xA9C9, 0xA9CA,
+	0xA9CB, 0xA9CC, 0xA2DF, 0xA8B1, 0xA8B2, 0xA8B3, 0xA8B4, 0xA8B5,
+	0xA8B6, 0xA8B7, 0xA8B8, 0xA8B9, 0xA8BA, 0xA8BB, 0xA8BC, 0xA8BD,
+	0xA8BE, 0xA8BF, 0xA8C0, 0xA8C1, 0xA8C2, 0xA8C3, 0xA8C4, 0xA8C5,
+	0xA8C6, 0xA8C7, 0xA8C8, 0xA8C9, 0xA8CA, 0xA8CB, 0xA8CC, 0xA2DE,
+	0xA7C9, 0xA7CA, 0xA7CB, 0xA7CC, 0xA7CD, 0xA7BA, 0xA7BB, 0xA7DC,
+	0xA7DD, 0xA7DE, 0xA7B6, 0xA7B7, 0xA7B8, 0xA7D4, 0xA7D5, 0xA7D6,
+	0xA7D7, 0xA7D8, 0xA7A1, 0xA7A2, 0xA7A3, 0xA7A5, 0xA7AB, 0xA7AC,
+	0xA7AD, 0xA7AE, 0xA7AF, 0xA7B0, 0xA7B1, 0xA7B2, 0xA7B3, 0xA7B4,
+	0xA7A7, 0xA7A8, 0xA7A9, 0xA7AA, 0xA7BD, 0xA7BE, 0xA7E5, 0xA7E6,
+	0xA7E7, 0xA7E8, 0xA7E1, 0xA7E2, 0xA7E3, 0xA7BF, 0xA7C0, 0xA7C1,
+	0xA7C2, 0xA7C3, 0xA7C4, 0xA7C5, 0xA7C6, 0xA7C7, 0xA7C8, 0xA7CE,
+	0xA7CF, 0xA7D0, 0xA7D1, 0xA7D2, 0xA7D3, 0xA7DA, 0xA7DB, 0xA2E3,
+	0xA7EC, 0xA7A6, 0xA7E0, 0xA7EF, 0xA2E1, 0xA7BC, 0xA7ED, 0xA7B5,
+	0xA7B9, 0xA7EA, 0xA7EB, 0xA7DF, 0xA2E4, 0xA7E4, 0xA7EE, 0xA7E9,
+	0xECE9, 0xEFCB, 0xF6D2, 0xD8B2, 0xEDDB, 0xDFB2, 0xDFBE, 0xF9BB,
+	0xDCF4, 0xF5E4, 0xF3A6, 0xDDE0, 0xE1A6, 0xCEF8, 0xDCB0, 0xE3AA,
+	0xF1E9, 0xCDFA, 0xFCAF, 0xD3A1, 0xF1AB, 0xE7D1, 0xD2AC, 0xCEF9,
+	0xF1FD, 0xDEBF, 0xFBBA, 0xF9B9, 0xCED2, 0xE3AB, 0xEBE0, 0xCEFA,
+	0xCBF7, 0xE5A5, 0xCAE1, 0xD4CC, 0xEAE1, 0xDCE3, 0xDFAD, 0xCBEB,
+	0xD5AF, 0xD6F5, 0xE5F8, 0xDEC0, 0xECA3, 0xE9CD, 0xEAA7, 0xE9F6,
+	0xFBBB, 0xE7E9, 0xEFCC, 0xD0E6, 0xDEC1, 0xE4AC, 0xD8CC, 0xF9F1,
+	0xCEDF, 0xFAA4, 0xE6B2, 0xFAFB, 0xFABD, 0xCCC8, 0xEFCD, 0xD5D5,
+	0xD3A2, 0xECD1, 0xE4A7, 0xECD2, 0xF6B1, 0xCEFB, 0xD0D1, 0xCBBF,
+	0xEDA4, 0xEDA8, 0xDEC2, 0xF6E2, 0xEDDC, 0xDCF5, 0xE0B9, 0xD4CE,
+	0xF4B5, 0xD3DB, 0xD6B5, 0xECA4, 0xE4E6, 0xF1EA, 0xCBEC, 0xCBC0,
+	0xECF2, 0xD0EA, 0xF9F2, 0xECA5, 0xD0DF, 0xE7EA, 0xD0EB, 0xDCD1,
+	0xDBE9, 0xFDCC, 0xDBD7, 0xDAE1, 0xD6B6, 0xE3DF, 0xDEC3, 0xDEC4,
+	0xCAA1, 0xEEEC, 0xD3A3, 0xEEB7, 0xF8CF, 0xEAC8, 0xEEB8, 0xF1AC,
+	0xF1A5, 0xE9CE, 0xF9BC, 0xE5F9, 0xECEA, 0xDDD6, 0xEDC2, 0xF8A5,
+	0xE5BA, 0xDBD8, 0xCAA2, 0xD1CD, 0xEEED, 0xECEB, 0xDEC5, 0xE3E0,
+	0xCAC9, 0xF2E9, 0xD5CE, 0xF6B6, 0xCEC2, 0xD6C7, 0xE3B4, 0xF1AD,
+	0xEAE2, 0xD7C2, 0xF3A7, 0xCDEA, 0xEBEE, 0xD9B2, 0xFDA5, 0xF6D5,
+	0xD5E2, 0xF8B5, 0xCCF5, 0xF5B5, 0xE4AD, 0xE7EB, 0xF1D5, 0xF0BB,
+	0xE9B5, 0xCCC9, 0xFAD5, 0xE1D4, 0xD7D6, 0xDCC1, 0xDEC6, 0xFAEF,
+	0xE3E1, 0xE1F3, 0xDCF6, 0xCEFC, 0xDBC4, 0xF8F1, 0xDCE4, 0xE5EF,
+	0xDCB1, 0xD5D6, 0xF3DA, 0xCBC1, 0xDBC3, 0xD9FA, 0xD3EE, 0xFAB8,
+	0xFDA6, 0xEBEF, 0xF4A6, 0xCCCA, 0xF3A8, 0xF3DB, 0xDBA7, 0xF6B7,
+	0xCFE6, 0xF0F2, 0xCBDA, 0xE7D2, 0xD7C3, 0xF6F0, 0xE8DE, 0xE5A6,
+	0xE5E7, 0xCAA3, 0xCCA7, 0xEAC9, 0xF8B6, 0xFAA5, 0xF1AE, 0xEFCE,
+	0xCBED, 0xF6B0, 0xEFCF, 0xE9CF, 0xF7DE, 0xCED3, 0xDCF7, 0xDBA8,
+	0xCBF8, 0xDFA1, 0xDDE1, 0xF5CA, 0xE9B6, 0xE7EC, 0xEEEE, 0xF3F0,
+	0xDFBF, 0xCCCB, 0xD0C1, 0xF4D2, 0xE0BA, 0xDFC0, 0xCEE0, 0xDCD2,
+	0xFDEA, 0xD6F6, 0xEACA, 0xE8E9, 0xE3AC, 0xF3D0, 0xCAA4, 0xDBF8,
+	0xDEC7, 0xEBF0, 0xF1D6, 0xE5E2, 0xCCCC, 0xCBFB, 0xEAE3, 0xDFC1,
+	0xD6ED, 0xE9D0, 0xEEB9, 0xD5E3, 0xD1D3, 0xE5F0, 0xE8B4, 0xEBC3,
+	0xEAAA, 0xFAFC, 0xF5F6, 0xF0BC, 0xFDD4, 0xE0BB, 0xCEC3, 0xD0BA,
+	0xF7BA, 0xD8F3, 0xF7CD, 0xE4AE, 0xD4DF, 0xD0E7, 0xECFD, 0xD2AE,
+	0xEEEF, 0xD5D7, 0xEAE4, 0xF8A2, 0xCDEB, 0xD7BF, 0xFBB1, 0xCDEC,
+	0xDCB2, 0xD0EC, 0xCEFD, 0xEEF0, 0xCCC2, 0xD0ED, 0xE5F7, 0xF3FC,
+	0xEEA2, 0xD9B3, 0xD8F4, 0xE9B7, 0xCEAE, 0xD9A2, 0xD8F1, 0xD4CF,
+	0xE5A7, 0xD5D2, 0xD6A9, 0xF4A2, 0xF1D7, 0xD5D8, 0xF0BD, 0xD7D0,
+	0xD4D0, 0xD7CF, 0xEBEA, 0xFDEB, 0xDBED, 0xFCC5, 0xCBC2, 0xFDD5,
+	0xF4C8, 0xE8EA, 0xF5F3, 0xF9DE, 0xD3EF, 0xECD3, 0xDDC2, 0xEFB7,
+	0xE7D4, 0xCACA, 0xD9FB, 0xFAFD, 0xD6AA, 0xF4F8, 0xF7F7, 0xDCAC,
+	0xD7D7, 0xDFA2, 0xCEBE, 0xD3F0, 0xF0A4, 0xE1EC, 0xCFE7, 0xF3CB,
+	0xEDA9, 0xCABE, 0xF4EF, 0xF6CE, 0xDEFB, 0xD0BB, 0xD5B7, 0xEEF1,
+	0xF4A8, 0xDCF8, 0xCBA7, 0xDACE, 0xE0E6, 0xEDA5, 0xEEF2, 0xDCF9,
+	0xF9DC, 0xF3DC, 0xF8F2, 0xF4F9, 0xFCF1, 0xD0BC, 0xDBF9, 0xD7B1,
+	0xCBFC, 0xF0A5, 0xCBFD, 0xD5F4, 0xCDED, 0xCAA5, 0xD6AB, 0xD0C2,
+	0xF0BE, 0xD2BD, 0xCCA4, 0xFAB6, 0xCCCD, 0xDAFA, 0xF6CF, 0xE9B8,
+	0xD8F5, 0xCCCE, 0xD7CD, 0xD4D1, 0xE9ED, 0xCAEB, 0xD9E2, 0xFDB2,
+	0xE3AD, 0xD6CC, 0xD9B4, 0xE1A7, 0xEED3, 0xD0C3, 0xFDB3, 0xD5E4,
+	0xCFE8, 0xEDC3, 0xD0B2, 0xCEFE, 0xDAA8, 0xF8D0, 0xFDD6, 0xF8D1,
+	0xF8D2, 0xDCD3, 0xDDE2, 0xFBF9, 0xDDC1, 0xE3B5, 0xEDDD, 0xCEC4,
+	0xCBA1, 0xDDE3, 0xFCDD, 0xF9AF, 0xD2FB, 0xCFA1, 0xE4A8, 0xF4B6,
+	0xECFE, 0xE3AE, 0xE7ED, 0xFDC1, 0xDAE2, 0xD8B3, 0xDDE4, 0xF0EF,
+	0xF6F1, 0xFAF0, 0xD1F5, 0xDACF, 0xDCD4, 0xDCA6, 0xEFBF, 0xCECF,
+	0xE0D9, 0xD9D6, 0xECD4, 0xEACB, 0xCABF, 0xD5B0, 0xCFE9, 0xF1ED,
+	0xCCCF, 0xE4F8, 0xE4ED, 0xD7D8, 0xFDA7, 0xEAAB, 0xF6B2, 0xCFF0,
+	0xF9BD, 0xE6F4, 0xCBDB, 0xF3D1, 0xE9D1, 0xF3A9, 0xD0E0, 0xE9D2,
+	0xDAE3, 0xE2D2, 0xF6A2, 0xE1F4, 0xDAE4, 0xE7D5, 0xF5BF, 0xCFA2,
+	0xCDAF, 0xCFA3, 0xCDB0, 0xF1FE, 0xD0A3, 0xE1AF, 0xF8A3, 0xCAA6,
+	0xF7BB, 0xF2EA, 0xDEC8, 0xE9D3, 0xDEC9, 0xFDDE, 0xCAC0, 0xF9EA,
+	0xD1CE, 0xEED4, 0xD4D2, 0xD9A3, 0xFDA8, 0xD7D9, 0xF7CE, 0xFABE,
+	0xCFD6, 0xD7F0, 0xEBE1, 0xF8C5, 0xDCFA, 0xDDC3, 0xF9DF, 0xE7EF,
+	0xFDE5, 0xF6A3, 0xD9FC, 0xFDA9, 0xE7EE, 0xD5E5, 0xEFD0, 0xCDB1,
+	0xF7A2, 0xF1B2, 0xF1B1, 0xCDB2, 0xDAAB, 0xCAA7, 0xE3E2, 0xFBBC,
+	0xD9A4, 0xEEBA, 0xF8D3, 0xFBFA, 0xCFA4, 0xDCFB, 0xF6E3, 0xEDAA,
+	0xF2A1, 0xCEE1, 0xFAA6, 0xF9E0, 0xECD6, 0xE4EE, 0xF9A1, 0xFBEF,
+	0xF9EB, 0xEEA3, 0xEAAC, 0xCAA8, 0xF4FA, 0xCDD6, 0xFCF6, 0xF4C9,
+	0xF8D4, 0xF8A6, 0xDECA, 0xF2C6, 0xD7DA, 0xD3D0, 0xD8C5, 0xEAE6,
+	0xF3DD, 0xE4DA, 0xF6E4, 0xF6F2, 0xDFC2, 0xD9FD, 0xCCF6, 0xD3BA,
+	0xE4AF, 0xF9E1, 0xF0A6, 0xCBD3, 0xE0BC, 0xF4CA, 0xD4FA, 0xFDAA,
+	0xF9E2, 0xF4B7, 0xFDC2, 0xFCB0, 0xFDEC, 0xCAE2, 0xFDBD, 0xEAE7,
+	0xDFC3, 0xD1D2, 0xCEE2, 0xD3A4, 0xFDAB, 0xDFE0, 0xF2C7, 0xE7F0,
+	0xD0EE, 0xF3AA, 0xDECB, 0xF6B8, 0xE1F5, 0xF1B3, 0xF7A3, 0xCAA9,
+	0xCFA5, 0xDFC4, 0xE1B0, 0xF0BF, 0xF6A4, 0xE3B6, 0xFAC6, 0xD0EF,
+	0xFDED, 0xDDC4, 0xFCF7, 0xE6BF, 0xDEAD, 0xFABF, 0xE5F1, 0xEDC4,
+	0xD2A5, 0xFDEE, 0xF5B6, 0xE1F6, 0xDECC, 0xFCDE, 0xECD7, 0xCDDD,
+	0xD6B7, 0xCDB3, 0xF8D5, 0xE5D8, 0xCFEA, 0xCFD0, 0xEACC, 0xEAAE,
+	0xEAAD, 0xD3F1, 0xD3A5, 0xF7CF, 0xEEA4, 0xD0A4, 0xF2A2, 0xD0F0,
+	0xF2A3, 0xF7F8, 0xD0B3, 0xDBA9, 0xD3BB, 0xCAEC, 0xF1A6, 0xCBD5,
+	0xF7E7, 0xCDDE, 0xF7A4, 0xF8C0, 0xD3DD, 0xCCD0, 0xCFA6, 0xF6F3,
+	0xE1F7, 0xD3DC, 0xFAFE, 0xFAA7, 0xEBD9, 0xCFA7, 0xEAAF, 0xE4EF,
+	0xE9B9, 0xF1D8, 0xD8D8, 0xE0F2, 0xE6B4, 0xDCFC, 0xF3F1, 0xE3D0,
+	0xF2FB, 0xDBC6, 0xD0F1, 0xD0F2, 0xCFDC, 0xD3D1, 0xCCB1, 0xF7D8,
+	0xCBA8, 0xEBBC, 0xE4BE, 0xF4DC, 0xDCC2, 0xF0A7, 0xE6C0, 0xCAED,
+	0xE8EB, 0xE5E8, 0xDCC3, 0xEDDE, 0xD3F2, 0xCCF7, 0xCED4, 0xE7AB,
+	0xCBC3, 0xE1B1, 0xF7B2, 0xD3F3, 0xD3D2, 0xF5C0, 0xDFDD, 0xEEF3,
+	0xE7F1, 0xFDB4, 0xF2C8, 0xF3D2, 0xEEF4, 0xE2D3, 0xCCD1, 0xDFEA,
+	0xE9BA, 0xD9D7, 0xF5CD, 0xF1F2, 0xFAC7, 0xD9F8, 0xD4C2, 0xF6E5,
+	0xDDC5, 0xE7F2, 0xEDDF, 0xCACB, 0xDBFA, 0xE8B5, 0xD3A6, 0xFDB5,
+	0xF9C9, 0xE4E2, 0xFBBD, 0xD7A4, 0xCEC5, 0xCED5, 0xD6E6, 0xE5BD,
+	0xDECD, 0xECF3, 0xEDE0, 0xECEC, 0xFBBE, 0xDFEB, 0xE1F8, 0xF9BE,
+	0xD0F3, 0xE0AA, 0xE8E2, 0xE2D4, 0xD2FD, 0xE5A8, 0xD9D3, 0xD3DE,
+	0xF4B8, 0xF7BC, 0xDCFD, 0xE8EC, 0xE4E7, 0xE3F7, 0xECA8, 0xFAF1,
+	0xE5F2, 0xD0F4, 0xD2AF, 0xDCE5, 0xD0A5, 0xF1B4, 0xFCB1, 0xCCF8,
+	0xDDC6, 0xFAD1, 0xF7DF, 0xFAA8, 0xEEF5, 0xDECE, 0xE7F3, 0xF7AC,
+	0xEBC4, 0xEDE1, 0xE0AB, 0xDDC7, 0xD2B3, 0xD2BF, 0xCACC, 0xFBBF,
+	0xE5FD, 0xDDE5, 0xD8CD, 0xECF4, 0xD0F5, 0xE8ED, 0xD0D2, 0xD9D8,
+	0xF6E6, 0xDBAA, 0xF7E0, 0xD8D9, 0xF4A3, 0xF4DD, 0xEFD1, 0xD9B5,
+	0xEDAB, 0xE3B7, 0xEEBB, 0xCDB4, 0xE0F3, 0xEACD, 0xECF5, 0xE8EE,
+	0xCBA9, 0xF1AF, 0xCACD, 0xECA9, 0xF2EB, 0xFDEF, 0xF9F3, 0xE6C1,
+	0xECD8, 0xEDAC, 0xEACE, 0xE8DF, 0xDECF, 0xD2A6, 0xE7F4, 0xD1D6,
+	0xE6C2, 0xE3E3, 0xE4B0, 0xD8B4, 0xF6A5, 0xF3DE, 0xD7A5, 0xF7E8,
+	0xE8C6, 0xFBE6, 0xDDE6, 0xDCFE, 0xD8DA, 0xDAAC, 0xEAB0, 0xE3B8,
+	0xCAAA, 0xE1F9, 0xEAB1, 0xF2EC, 0xFAEE, 0xEED5, 0xF9F4, 0xD2EC,
+	0xFBFB, 0xFDF0, 0xE0BD, 0xCEE3, 0xF8C6, 0xDEAE, 0xDFC5, 0xE5BE,
+	0xEDAD, 0xFAEA, 0xCDEE, 0xEDA6, 0xEDAE, 0xF0ED, 0xDDA1, 0xEDAF,
+	0xFCF8, 0xD8EB, 0xCCF9, 0xCDB5, 0xFAA9, 0xE1DD, 0xE2D5, 0xEDCF,
+	0xDDA2, 0xF9CA, 0xEAE8, 0xE5ED, 0xD3EB, 0xE9D4, 0xE1FA, 0xE4CC,
+	0xE1E4, 0xE8C7, 0xCEDB, 0xDCD5, 0xF7B5, 0xFCF3, 0xF0F3, 0xCEAF,
+	0xF1B5, 0xEFD2, 0xE8C8, 0xEBF1, 0xCBD4, 0xE0BE, 0xE3F8, 0xEAE9,
+	0xFCB2, 0xE0F4, 0xCFE0, 0xEEA5, 0xFAAA, 0xE6C3, 0xE1B2, 0xCAAB,
+	0xE3E4, 0xE9BB, 0xE2D6, 0xF3F2, 0xEED6, 0xEAB2, 0xD0F6, 0xECD9,
+	0xDACB, 0xCFA8, 0xDDA3, 0xD8DB, 0xF9CE, 0xE9D5, 0xE3D1, 0xD2BC,
+	0xD8AC, 0xF3CC, 0xCDFB, 0xF6D6, 0xE7F5, 0xE8EF, 0xE3F9, 0xD2BB,
+	0xF3F3, 0xE3FB, 0xDED0, 0xCEB0, 0xD6F7, 0xF1D9, 0xF5C1, 0xDCC4,
+	0xF5BB, 0xDED1, 0xDCE6, 0xDED2, 0xEDE2, 0xEEF6, 0xEACF, 0xF0EE,
+	0xE3FC, 0xD3DF, 0xD3F4, 0xE1B3, 0xE1B4, 0xF4D3, 0xDFC6, 0xE9D6,
+	0xDBAB, 0xF6A6, 0xE3B9, 0xEBC5, 0xF4A9, 0xCDB6, 0xD2F9, 0xDAAD,
+	0xD2E3, 0xCFD1, 0xCBDC, 0xCCFA, 0xCFDD, 0xE8A9, 0xE3BB, 0xE3BA,
+	0xE0DA, 0xEEF7, 0xDCB3, 0xD3F5, 0xD7A6, 0xF6B5, 0xD7DB, 0xE1D5,
+	0xD4EA, 0xDFA3, 0xFDDF, 0xD0F7, 0xEDD4, 0xCBAA, 0xE4DB, 0xE1FB,
+	0xCBA2, 0xD3E0, 0xE4BF, 0xFBC0, 0xDABE, 0xE4CD, 0xD6B9, 0xEFC0,
+	0xE1FC, 0xF6B9, 0xDFC7, 0xE4B1, 0xDCE7, 0xDCE8, 0xFAD6, 0xD3F6,
+	0xF1DA, 0xFAF2, 0xE2FD, 0xD5CF, 0xD0F8, 0xCDDF, 0xF5CB, 0xE4F0,
+	0xCBAB, 0xD7C4, 0xE2FE, 0xDDDA, 0xDAAE, 0xCAEE, 0xD5B9, 0xE3A1,
+	0xE8E3, 0xF3AB, 0xCFA9, 0xD3F7, 0xD4F1, 0xCEE4, 0xE8F2, 0xE5F5,
+	0xE7AE, 0xD6BA, 0xDFEC, 0xE4C0, 0xE8E4, 0xD8B5, 0xE4DC, 0xF4B9,
+	0xF1B6, 0xE2DE, 0xE1B5, 0xCDEF, 0xF1A7, 0xCEE5, 0xCBDD, 0xD9E3,
+	0xF3AC, 0xD0F9, 0xECAB, 0xDED3, 0xF7E9, 0xF9F5, 0xE1DE, 0xCBEE,
+	0xE3BC, 0xF8D6, 0xDBEE, 0xFDF1, 0xF7B6, 0xF4DE, 0xF2ED, 0xDBD9,
+	0xF0A8, 0xE1FD, 0xDED4, 0xE0AC, 0xEDE3, 0xD3E1, 0xDFC8, 0xD9B6,
+	0xFDAC, 0xEFD3, 0xE4C1, 0xF8EB, 0xDBAC, 0xFCC6, 0xD8AD, 0xF6BA,
+	0xDBDF, 0xD3D3, 0xF8C7, 0xCACE, 0xF8C1, 0xD2B4, 0xDCB4, 0xFAB9,
+	0xCACF, 0xFCB3, 0xEAEA, 0xEAEB, 0xD0FA, 0xEDE4, 0xDDE7, 0xDFC9,
+	0xDFED, 0xEEBC, 0xEFC1, 0xCCD2, 0xDDA4, 0xDFCA, 0xD3F8, 0xF1A8,
+	0xCDB7, 0xEFD4, 0xE4DD, 0xDFEE, 0xCBAC, 0xE9BC, 0xEAEC, 0xDFCB,
+	0xF9BF, 0xD6AF, 0xD5C6, 0xCFAA, 0xCEA9, 0xD6F8, 0xF1B7, 0xEEF8,
+	0xD9D9, 0xF3DF, 0xF8C8, 0xCEC6, 0xD5E6, 0xF4E6, 0xE6C5, 0xEFD5,
+	0xCBEF, 0xFCDF, 0xDCA7, 0xD6E7, 0xF8C9, 0xE3D2, 0xE3BD, 0xCFE1,
+	0xF0C0, 0xECDA, 0xDDD7, 0xFBF0, 0xECAC, 0xF0A9, 0xFAD7, 0xFBC1,
+	0xD2C0, 0xE5B0, 0xEDE5, 0xCBAD, 0xF9B0, 0xF7A5, 0xCBAE, 0xDAAF,
+	0xD8B6, 0xD3A7, 0xFBB2, 0xFDC4, 0xECAD, 0xFBA1, 0xE5E9, 0xE9EE,
+	0xF3F4, 0xF8F3, 0xF0C1, 0xDEAF, 0xF8B0, 0xF3E0, 0xE7AF, 0xDBAD,
+	0xE6B5, 0xF9A8, 0xDDD8, 0xE8D9, 0xEFD6, 0xD3E2, 0xE2DF, 0xFCE0,
+	0xD7C8, 0xFDAD, 0xDFEF, 0xCCD3, 0xD3F9, 0xD4F0, 0xDBC7, 0xDED5,
+	0xF0F4, 0xD5D0, 0xE5D9, 0xFCC7, 0xDCD6, 0xE2E0, 0xDAB0, 0xF3A3,
+	0xD3EC, 0xF4CB, 0xFDC5, 0xE3FD, 0xF9B1, 0xD0FB, 0xECDB, 0xF5BC,
+	0xF2A4, 0xD8CE, 0xD8CF, 0xF5F7, 0xF6E1, 0xD2B7, 0xFBEC, 0xDDC8,
+	0xE4E8, 0xD2C1, 0xF8D7, 0xD6BB, 0xDED6, 0xF7BD, 0xECAE, 0xD0E1,
+	0xE0F5, 0xEAB3, 0xCED6, 0xCCA5, 0xECF6, 0xE2E1, 0xE3BE, 0xFCC8,
+	0xCDF0, 0xF9F6, 0xDFF0, 0xE5BF, 0xCEBF, 0xFCE1, 0xEDB0, 0xFDD1,
+	0xF6BB, 0xF9CF, 0xEBDA, 0xCAC1, 0xD2B8, 0xCDF1, 0xE3D3, 0xFDE6,
+	0xE6ED, 0xE3FA, 0xF0AA, 0xF9D0, 0xFCE2, 0xF8A7, 0xE1E5, 0xEEF9,
+	0xE7F6, 0xEAED, 0xFCB4, 0xF5C2, 0xD7DC, 0xF0F5, 0xDDE8, 0xD3ED,
+	0xF5FC, 0xDABF, 0xCCFB, 0xD3FA, 0xF4A4, 0xEFD7, 0xD4C3, 0xFBE3,
+	0xFBED, 0xE0AD, 0xEAEE, 0xFBB3, 0xE4C2, 0xF6E7, 0xD2DD, 0xDFCC,
+	0xFCC9, 0xE5A9, 0xE0F6, 0xF6B3, 0xE1FE, 0xCBF0, 0xEAEF, 0xEAF0,
+	0xDAC0, 0xF8B4, 0xEBF2, 0xE4C3, 0xE9D7, 0xE4F1, 0xCAEF, 0xCED7,
+	0xFCCA, 0xF3E1, 0xCBC4, 0xE3E5, 0xCBC5, 0xEAB4, 0xE9BD, 0xD7C9,
+	0xEBDB, 0xEDB1, 0xCCC3, 0xF7BE, 0xFCCB, 0xF8F4, 0xD9B7, 0xF3D3,
+	0xF3D4, 0xF7E4, 0xF7D1, 0xD8B7, 0xCEB1, 0xCAC2, 0xFBB4, 0xCBC6,
+	0xF0F6, 0xD5E7, 0xEAD0, 0xCCD4, 0xCBAF, 0xF4AA, 0xE9AF, 0xF5C3,
+	0xE9D8, 0xDDE9, 0xF1F3, 0xD5FB, 0xDEBB, 0xF4FB, 0xFDF3, 0xFDF2,
+	0xF7A6, 0xDDC9, 0xD4D3, 0xCCA8, 0xDAC1, 0xCCD5, 0xD9E4, 0xFACA,
+	0xE5E3, 0xD3BC, 0xCAF0, 0xD0C4, 0xCAD0, 0xFAAB, 0xEBEB, 0xE7F8,
+	0xD9E5, 0xD1D7, 0xF3A4, 0xD4FB, 0xFCE3, 0xFAD8, 0xF3D5, 0xCFAB,
+	0xEBF3, 0xD5FC, 0xD3D4, 0xCDFC, 0xD9E6, 0xE2F9, 0xE2A1, 0xEBD4,
+	0xE0F7, 0xE4B2, 0xCCFC, 0xFBE4, 0xF4AB, 0xD0BD, 0xCAF1, 0xEFB8,
+	0xD7C0, 0xEEFA, 0xFDF4, 0xD3E3, 0xFBC2, 0xD5E8, 0xDBAE, 0xE1B6,
+	0xF8B7, 0xE0BF, 0xFBC3, 0xDDEA, 0xE2A2, 0xEEA6, 0xF6E8, 0xF6F5,
+	0xDDCA, 0xD0E2, 0xDDA6, 0xDDEB, 0xE4F9, 0xE3AF, 0xD0FC, 0xF4FC,
+	0xCCBC, 0xF7EA, 0xE5E4, 0xDFF1, 0xF7E1, 0xF9F7, 0xEFB9, 0xF8D8,
+	0xF9A9, 0xF8D9, 0xEEBD, 0xD8C6, 0xE4E3, 0xF5CE, 0xDDD9, 0xD9E7,
+	0xD2B9, 0xD5C3, 0xDAE5, 0xDAD0, 0xD1D9, 0xCED8, 0xCBDE, 0xF4AC,
+	0xDAFB, 0xF6E9, 0xE8F3, 0xCFAC, 0xF0F0, 0xF4FD, 0xDBC8, 0xCEC0,
+	0xE3D4, 0xD1CF, 0xF1F5, 0xCDF2, 0xCFEB, 0xCDB8, 0xE3A6, 0xD1DA,
+	0xF2A5, 0xF2A6, 0xE4CE, 0xD3FB, 0xF1A9, 0xF2C9, 0xEFD8, 0xE6C9,
+	0xD8B8, 0xFAF3, 0xF3B5, 0xF8A4, 0xD1F3, 0xE6C8, 0xF8DA, 0xDCE9,
+	0xDED7, 0xCBDF, 0xCFEC, 0xF4DF, 0xD1F4, 0xD2BA, 0xDFF2, 0xE1B7,
+	0xE2A3, 0xD3FC, 0xEDE6, 0xDBC9, 0xE4FA, 0xCFDE, 0xCED0, 0xD5D3,
+	0xF3F5, 0xF7AE, 0xEFC8, 0xCDF3, 0xF5CF, 0xE5F3, 0xF0C2, 0xCAD1,
+	0xEAF1, 0xD0A6, 0xD9DA, 0xF0AB, 0xEBE7, 0xE5C0, 0xFCB5, 0xE4C4,
+	0xCCA9, 0xFDC6, 0xEAB5, 0xE5AA, 0xDFBA, 0xE1DF, 0xDAD1, 0xE1B8,
+	0xE8F4, 0xD3FD, 0xE2A4, 0xF2CA, 0xDAE6, 0xF7B3, 0xFDCD, 0xF3B6,
+	0xEED7, 0xF5C4, 0xD8A4, 0xF2A7, 0xD9B8, 0xD9B9, 0xEFC9, 0xD6CE,
+	0xF7CB, 0xDFAE, 0xE8F5, 0xD2B5, 0xD3D5, 0xF4CC, 0xDAFC, 0xD9E8,
+	0xF7EB, 0xF5C9, 0xF3BC, 0xDAD2, 0xD3B5, 0xE8B6, 0xD6CF, 0xF4BA,
+	0xF7C9, 0xCCAA, 0xF0C3, 0xCCD6, 0xD0D3, 0xD3BD, 0xDBFB, 0xCBE0,
+	0xD3E4, 0xF6F7, 0xD5BA, 0xF3CD, 0xCBE1, 0xEBF4, 0xF4AD, 0xFCAA,
+	0xF7EC, 0xE8F6, 0xDAE7, 0xF7CC, 0xE5C1, 0xE0EE, 0xD5FD, 0xCEE6,
+	0xFCAB, 0xD5BB, 0xF2A8, 0xE2A5, 0xCDB9, 0xEAF2, 0xCBC7, 0xCDF4,
+	0xDBAF, 0xEFD9, 0xCDBA, 0xFCF9, 0xDFF3, 0xCEE7, 0xDAC2, 0xCFAD,
+	0xE7F9, 0xF8A8, 0xF3E2, 0xCAF2, 0xDFA4, 0xD4C4, 0xCCD7, 0xE5C2,
+	0xCDBB, 0xEFDA, 0xEED8, 0xDDA7, 0xE2A6, 0xE0C0, 0xD6B0, 0xF8CA,
+	0xFCFA, 0xD9FE, 0xDEB0, 0xDDEC, 0xDAE8, 0xD4E0, 0xD6F9, 0xCDD7,
+	0xDED8, 0xF2F8, 0xE4D6, 0xD0C5, 0xF4AE, 0xDDA8, 0xEDC5, 0xF3D6,
+	0xDED9, 0xE3E6, 0xD3A8, 0xDBB0, 0xE5DA, 0xE3BF, 0xDBB1, 0xD5E9,
+	0xE0C1, 0xEFDB, 0xF0E9, 0xD7B2, 0xD0FD, 0xD9E9, 0xD0FE, 0xECED,
+	0xD3A9, 0xF2A9, 0xF0C4, 0xE2E2, 0xE9EF, 0xF9D1, 0xE9D9, 0xE8DA,
+	0xDAC3, 0xDAC4, 0xD4C5, 0xE7FA, 0xCDE0, 0xE3B0, 0xDBB2, 0xFBC4,
+	0xF3E3, 0xD9A5, 0xFBE7, 0xDDCB, 0xD0D4, 0xE6B6, 0xE0AE, 0xFDDA,
+	0xDCB5, 0xE0F8, 0xE7B1, 0xF5F0, 0xD8DC, 0xEDC6, 0xE1B9, 0xE3C0,
+	0xF9C0, 0xE9F0, 0xD9DB, 0xF3E4, 0xDCB6, 0xE4E9, 0xF0C5, 0xE3C1,
+	0xFCCC, 0xFCCD, 0xF2CB, 0xF2CC, 0xE4CF, 0xF1DB, 0xFAD9, 0xF1B8,
+	0xFDF5, 0xE0F9, 0xE7FB, 0xFCB7, 0xFCE4, 0xFBC5, 0xE3E7, 0xD8B9,
+	0xF6F8, 0xDCC5, 0xCCD8, 0xE0AF, 0xF4E7, 0xEFDC, 0xCFFC, 0xEFDD,
+	0xF2AA, 0xFDBE, 0xCAAC, 0xFDBB, 0xFDC7, 0xE7B2, 0xEAD1, 0xDFF4,
+	0xD1EC, 0xE4DE, 0xE5C3, 0xD9A6, 0xCDBC, 0xF3E5, 0xEDD5, 0xD9BA,
+	0xEDE7, 0xFBB5, 0xF8EC, 0xE0E7, 0xCCD9, 0xD4C6, 0xE7A5, 0xD5F5,
+	0xD3BE, 0xFCFB, 0xE4F2, 0xDFF5, 0xE8F8, 0xF8ED, 0xCEC7, 0xFDF6,
+	0xE8D8, 0xCDD8, 0xE7D6, 0xCCDA, 0xCAE3, 0xDFF6, 0xF0C7, 0xF0C6,
+	0xD8BA, 0xF1F4, 0xF4F0, 0xF5CC, 0xFCE5, 0xEAC5, 0xEAF3, 0xDDDB,
+	0xDCD7, 0xDEFD, 0xF2F9, 0xD5C7, 0xD8D0, 0xF0C8, 0xD1A1, 0xD1A2,
+	0xD9D4, 0xD6E8, 0xD9CA, 0xDAB1, 0xD8C7, 0xDCE2, 0xF3CE, 0xF5F4,
+	0xF1B9, 0xDAD3, 0xF6EA, 0xCFF5, 0xFDAE, 0xCAD2, 0xDFB4, 0xD7DD,
+	0xFABA, 0xEEA7, 0xF5BD, 0xF8F5, 0xEDE8, 0xD4E1, 0xD1A3, 0xE1D6,
+	0xF9F8, 0xDBCA, 0xCBF9, 0xD4D4, 0xD9DC, 0xEEBE, 0xF7ED, 0xD2EE,
+	0xE1E6, 0xF7F9, 0xDDED, 0xE8DB, 0xDBB3, 0xD1F7, 0xE0B0, 0xD4E2,
+	0xF6D7, 0xD7F9, 0xD8DD, 0xCDFD, 0xF2AB, 0xCDBD, 0xF8C2, 0xF2AC,
+	0xCAAD, 0xCAAE, 0xCFAE, 0xE3C2, 0xDCB7, 0xDBDA, 0xD9BB, 0xCAF3,
+	0xF6D3, 0xE6F8, 0xEAF5, 0xEAF6, 0xF6F9, 0xCFAF, 0xCAD3, 0xCAAF,
+	0xD2B0, 0xF1BA, 0xD7B3, 0xE3C3, 0xF3FD, 0xDEDA, 0xDEDB, 0xEFDE,
+	0xE2E3, 0xEEFB, 0xDFF7, 0xD7CA, 0xCEE8, 0xDBDB, 0xF1BB, 0xE9F1,
+	0xFAB7, 0xD0C6, 0xCCAB, 0xEEA8, 0xCBFA, 0xF9F9, 0xCCFD, 0xD3FE,
+	0xE4D0, 0xF2EE, 0xD4D5, 0xDFCD, 0xFCB8, 0xD1D0, 0xF2CD, 0xF7D2,
+	0xCAD4, 0xD5D9, 0xD8DE, 0xCDD9, 0xEEA9, 0xF6BC, 0xCCDB, 0xF0C9,
+	0xFCFC, 0xE8C9, 0xF4FE, 0xE7FC, 0xD7DE, 0xDEDC, 0xF0AC, 0xCCFE,
+	0xCDE1, 0xE1BA, 0xDBEF, 0xDAB2, 0xD1A5, 0xDCB8, 0xD8F6, 0xD1A4,
+	0xCDE2, 0xDCEA, 0xF0F7, 0xF0CA, 0xD0BE, 0xDDDC, 0xD4D6, 0xD3D6,
+	0xEDD0, 0xCDA1, 0xDFB5, 0xDFF8, 0xD4A1, 0xCEB2, 0xE8CA, 0xEBF5,
+	0xE3D5, 0xF5D0, 0xF5A1, 0xD9A7, 0xE5AB, 0xE6CB, 0xF5F1, 0xE5C5,
+	0xF9A3, 0xE0DB, 0xF6EB, 0xCBF1, 0xD9EA, 0xF5A2, 0xD7D1, 0xD1F8,
+	0xEAF8, 0xEAF9, 0xDAB3, 0xEFDF, 0xF1EF, 0xE5F6, 0xEEBF, 0xE2E4,
+	0xD0BF, 0xFAAC, 0xF5D1, 0xE7B3, 0xE9BE, 0xF2CE, 0xDBB4, 0xFCCE,
+	0xDDEE, 0xE7B4, 0xD7B4, 0xF7B4, 0xCDBE, 0xDAE9, 0xCFB0, 0xF7D9,
+	0xF3E6, 0xCED9, 0xCEAA, 0xCBC8, 0xD0A7, 0xF0CB, 0xD0C7, 0xE4C5,
+	0xDBE0, 0xD5DA, 0xD7A7, 0xEEC0, 0xF8F6, 0xF5D2, 0xEDE9, 0xD9BC,
+	0xE5C6, 0xF5A3, 0xDAD4, 0xE2A7, 0xFBFC, 0xF1DC, 0xCAF4, 0xE8FA,
+	0xCEE9, 0xE9F8, 0xE2E5, 0xD0B9, 0xD4F2, 0xD1A6, 0xDFCE, 0xFCF4,
+	0xD3AA, 0xCCAC, 0xEFE0, 0xE5E5, 0xD0D5, 0xDBFC, 0xFCE6, 0xCBFE,
+	0xEDEA, 0xDEB1, 0xF9E3, 0xD4A2, 0xCFF6, 0xD6D0, 0xD5EA, 0xF1EE,
+	0xFACB, 0xE5A1, 0xD5B1, 0xCFED, 0xEDEB, 0xD5B2, 0xD5BC, 0xFDE2,
+	0xF3AD, 0xFDDB, 0xE9B0, 0xD1A7, 0xFDE3, 0xCEB3, 0xFDE4, 0xFACE,
+	0xCAB0, 0xF7A7, 0xCFB1, 0xE6A2, 0xFCB6, 0xF2AD, 0xEFE1, 0xF3AE,
+	0xDCC6, 0xD9EB, 0xE8E0, 0xE1A8, 0xD5F6, 0xCFFD, 0xDEDD, 0xD9D1,
+	0xE4EA, 0xF2CF, 0xF7BF, 0xE2E6, 0xE2A8, 0xE3D6, 0xEDD1, 0xE9F9,
+	0xD6B1, 0xDEB2, 0xE0E8, 0xD3AB, 0xEBDC, 0xDFAF, 0xCAC3, 0xEEFC,
+	0xFDC3, 0xEBF6, 0xCFB2, 0xD9EC, 0xD9BD, 0xD8DF, 0xD4B8, 0xEBBE,
+	0xDDEF, 0xDDF0, 0xDDF1, 0xDDF2, 0xD9BE, 0xFBC6, 0xCFB3, 0xEEFD,
+	0xE4AB, 0xDAC5, 0xD8EC, 0xD1A8, 0xE2A9, 0xDEBC, 0xE7B5, 0xDBF0,
+	0xEFE2, 0xF1F0, 0xCFB4, 0xDBF1, 0xE0B1, 0xDFA5, 0xF9D2, 0xE7FD,
+	0xE6A3, 0xFBF1, 0xCBB0, 0xF2AE, 0xCDE7, 0xE8DC, 0xE7D7, 0xF7C0,
+	0xD0E3, 0xDAA1, 0xCCBD, 0xD1A9, 0xDDCC, 0xE3FE, 0xD1AA, 0xE8AA,
+	0xEAB6, 0xF9FA, 0xE6CC, 0xF6D8, 0xD4C7, 0xD9CB, 0xD9D2, 0xD3CB,
+	0xD8F7, 0xDAA9, 0xF5F8, 0xDEDE, 0xF2AF, 0xF8A9, 0xD8C8, 0xEEC1,
+	0xF9C1, 0xDDF3, 0xEAFA, 0xF6BD, 0xE1BB, 0xCDBF, 0xF4D4, 0xE6CD,
+	0xFCCF, 0xFBA2, 0xE0DC, 0xF4BB, 0xDAD5, 0xF9B2, 0xFBF2, 0xDBF6,
+	0xDEDF, 0xDBF2, 0xF8DC, 0xF7EE, 0xEBE8, 0xD2FA, 0xF1BC, 0xFADA,
+	0xDAEA, 0xDAC6, 0xF7C1, 0xE7B6, 0xE5C7, 0xD6AC, 0xDCC7, 0xE1A9,
+	0xE2AA, 0xD5A6, 0xD4D7, 0xF2D0, 0xEAFB, 0xE0DD, 0xFBF3, 0xF1BD,
+	0xE2E7, 0xFDD7, 0xCEC8, 0xEAB7, 0xFCC0, 0xFDE7, 0xF7EF, 0xD7B5,
+	0xEFBA, 0xF1DD, 0xDEB3, 0xE8CB, 0xF8DD, 0xFBC7, 0xD5C8, 0xD7DF,
+	0xDDA9, 0xE9B1, 0xFAAD, 0xF6D9, 0xFAF4, 0xF8AA, 0xE6EE, 0xCCDC,
+	0xE1BC, 0xE0EF, 0xE9BF, 0xFCFD, 0xE6CE, 0xE1D7, 0xE6CF, 0xF4F1,
+	0xE4F3, 0xE4FB, 0xF9E4, 0xEFE3, 0xCFEE, 0xF6BE, 0xE0B2, 0xFCFE,
+	0xD1AB, 0xD7FA, 0xFBC8, 0xE2D7, 0xD4A3, 0xF0F8, 0xD7A8, 0xE1E7,
+	0xD3BF, 0xEFE4, 0xD7C5, 0xEBE2, 0xFCE7, 0xE4A2, 0xE2E8, 0xE6D0,
+	0xFBE8, 0xF4E8, 0xE5F4, 0xF4BC, 0xF4D5, 0xDFB6, 0xFCB9, 0xEEC2,
+	0xCAF5, 0xEFE5, 0xCBE2, 0xD4A4, 0xDEE0, 0xDAFD, 0xE4C6, 0xE8BE,
+	0xE0DE, 0xF6B4, 0xEAD2, 0xF9FB, 0xE0C2, 0xCAE4, 0xE7B7, 0xEAFD,
+	0xD9DD, 0xDAB4, 0xEEAA, 0xFBE9, 0xDBCB, 0xDAB5, 0xF1BE, 0xD3AC,
+	0xFBC9, 0xDFCF, 0xD3C0, 0xE3D7, 0xEFE6, 0xFCD0, 0xE9C0, 0xF5D3,
+	0xECDC, 0xF7B7, 0xEAB8, 0xD1F9, 0xDCC8, 0xEAB9, 0xF1DE, 0xD7B6,
+	0xCFB5, 0xD9A8, 0xECEE, 0xDDAA, 0xCDA2, 0xE8AE, 0xE1BD, 0xF2D1,
+	0xE9C1, 0xD2FC, 0xDBB5, 0xF3E7, 0xD8FE, 0xFCD1, 0xEDB2, 0xF4AF,
+	0xFBA3, 0xFCC1, 0xEEAB, 0xD4A5, 0xF4F2, 0xEED9, 0xFBCA, 0xCDE3,
+	0xD8BB, 0xE5DB, 0xF8F7, 0xF6D4, 0xD7A9, 0xCBC9, 0xE6D1, 0xF0CC,
+	0xD8AE, 0xF9D3, 0xD5FE, 0xD8BC, 0xF2B0, 0xE2AB, 0xF3E8, 0xEFC2,
+	0xEDEC, 0xE7B8, 0xDAFE, 0xCCBE, 0xF2FC, 0xDAEB, 0xE2D8, 0xEDD6,
+	0xD6D1, 0xE0B3, 0xFCD2, 0xEBC8, 0xD3C1, 0xF0CD, 0xCFF7, 0xEDD2,
+	0xD4D8, 0xDCC9, 0xD7F1, 0xDFBB, 0xF3A5, 0xF4CD, 0xF1BF, 0xF8B1,
+	0xE9FA, 0xFBCB, 0xCAD5, 0xF9D4, 0xF7CA, 0xD6C8, 0xFCE8, 0xF3BD,
+	0xEEFE, 0xE7FE, 0xD3C2, 0xD3B6, 0xCCAD, 0xF6FA, 0xD6B2, 0xD2D8,
+	0xE7D8, 0xE3A5, 0xE7B9, 0xF0AD, 0xFBCC, 0xEBA1, 0xD4A6, 0xFBCD,
+	0xD5BD, 0xF1DF, 0xF6FB, 0xDEB4, 0xD5EB, 0xE5C8, 0xFBA4, 0xD4B9,
+	0xDEE1, 0xE4A3, 0xD7B7, 0xF8EE, 0xDEB5, 0xD6D2, 0xF9D5, 0xE7BA,
+	0xEBD5, 0xD5F7, 0xEFE7, 0xE1BE, 0xFAAE, 0xD6E9, 0xD6EE, 0xE7BB,
+	0xECCB, 0xD5B3, 0xCEB4, 0xFBA5, 0xE1EE, 0xF7A8, 0xFBCE, 0xD8BD,
+	0xFBFD, 0xFCE9, 0xCFB6, 0xEDC7, 0xEEAC, 0xCCDD, 0xF6A7, 0xE6FA,
+	0xF5A4, 0xFDDC, 0xEDB3, 0xCEC9, 0xEFE8, 0xE1BF, 0xFADB, 0xCBE3,
+	0xF7A9, 0xFBA6, 0xDCB9, 0xF1C0, 0xEDC8, 0xEFC3, 0xD6AD, 0xFDCE,
+	0xE8A1, 0xFBF4, 0xD5A7, 0xF1F6, 0xE6D3, 0xCCDE, 0xF8B2, 0xDCEB,
+	0xFDB6, 0xE5EA, 0xF1E0, 0xDBCC, 0xDDCD, 0xD4C8, 0xD9ED, 0xF5A5,
+	0xE6FB, 0xE6D4, 0xFDC8, 0xD6A1, 0xFDBF, 0xFCD3, 0xEFA1, 0xE7BC,
+	0xD1EE, 0xE6D5, 0xE9F2, 0xDFB0, 0xD8E0, 0xFCBA, 0xFDAF, 0xF0CE,
+	0xDBE1, 0xE5C9, 0xEDB4, 0xE0C3, 0xE3D8, 0xE9FB, 0xEAA8, 0xFDB7,
+	0xFBA7, 0xE9C2, 0xFDF7, 0xE2D9, 0xDCEC, 0xE8A2, 0xE6F0, 0xFDF8,
+	0xFDF9, 0xF6BF, 0xE7A7, 0xE6D7, 0xD4F3, 0xD4C9, 0xD6FA, 0xD7F2,
+	0xE1C0, 0xDBE2, 0xE6D8, 0xE7BD, 0xF0CF, 0xF3BE, 0xE2AC, 0xF5B7,
+	0xE0F0, 0xFDB8, 0xE3E8, 0xD4A7, 0xE8FC, 0xFAD2, 0xF8EF, 0xD6D3,
+	0xD5B4, 0xF0D0, 0xF7F0, 0xEEB3, 0xEABA, 0xEAD3, 0xEDC9, 0xDDAB,
+	0xE5AC, 0xFDA1, 0xDFD0, 0xECB3, 0xDFD1, 0xEDED, 0xF8B8, 0xF7FA,
+	0xF8AB, 0xF4E0, 0xD4BA, 0xE4B3, 0xE9DA, 0xDEB6, 0xD9BF, 0xD9C0,
+	0xD6EF, 0xD9CC, 0xDAAA, 0xDFE5, 0xF7E5, 0xCCB2, 0xDFF9, 0xD7E0,
+	0xD4BB, 0xFDFA, 0xCCB3, 0xDBF3, 0xDFD2, 0xCECA, 0xEEDA, 0xE4E4,
+	0xFBCF, 0xCFB7, 0xEEC3, 0xCEEA, 0xE2AD, 0xD7E1, 0xFAF5, 0xD5C9,
+	0xF8AC, 0xE7D9, 0xF3E9, 0xD8ED, 0xE3C4, 0xF0F1, 0xE8E5, 0xE0FA,
+	0xEEC4, 0xD9DE, 0xEBA2, 0xEBA3, 0xFCC2, 0xEABB, 0xE8AB, 0xDEE2,
+	0xEDEF, 0xE8A3, 0xCFF1, 0xD4BC, 0xFCEA, 0xE7BE, 0xFCF2, 0xD6B4,
+	0xE2AE, 0xD3B7, 0xFACC, 0xFADC, 0xEDB5, 0xE1E3, 0xE8AC, 0xE8DD,
+	0xEFE9, 0xF4BD, 0xCFB8, 0xE9DB, 0xD1AC, 0xDAC7, 0xEBC9, 0xE8CC,
+	0xDEB7, 0xD6BC, 0xD3E5, 0xFADD, 0xDAD6, 0xCAB1, 0xDAC8, 0xDFA6,
+	0xF9B3, 0xF2D2, 0xCAC4, 0xCECB, 0xCDF5, 0xFDB0, 0xD5A8, 0xF1C1,
+	0xE2E9, 0xDCCA, 0xECB4, 0xFAC0, 0xFBA8, 0xD0A8, 0xDAEC, 0xD9EE,
+	0xE0FB, 0xEFEA, 0xFADE, 0xE0C4, 0xCFB9, 0xD5CA, 0xD7E2, 0xE2AF,
+	0xD7B8, 0xE8CD, 0xF6DA, 0xEFA2, 0xE2DA, 0xF6FC, 0xFBD0, 0xD1AD,
+	0xCDE4, 0xD1AE, 0xDCED, 0xE8CE, 0xF0F9, 0xCEB5, 0xE6FC, 0xD7FB,
+	0xD0D6, 0xDDF5, 0xF7F1, 0xF6FD, 0xDBF7, 0xFBEA, 0xE9DC, 0xD9C1,
+	0xF5F2, 0xE0C5, 0xEAD4, 0xF9C2, 0xEABC, 0xD2C5, 0xFBD1, 0xE7C0,
+	0xEBA5, 0xDFFA, 0xE3A2, 0xD7B9, 0xE9C3, 0xE8FD, 0xE8AF, 0xF2D3,
+	0xFBA9, 0xD8A5, 0xD5CB, 0xD0C8, 0xD1AF, 0xD7E3, 0xE0C6, 0xD6A2,
+	0xEDF0, 0xD7F3, 0xFCD4, 0xDAD7, 0xCCDF, 0xF2D4, 0xD1B0, 0xCCE0,
+	0xDBFD, 0xF3BF, 0xF0D1, 0xFCBB, 0xE2B0, 0xE6A5, 0xE2DB, 0xDFDE,
+	0xE0C7, 0xF2EF, 0xCCE1, 0xD6EA, 0xE7C2, 0xCEB6, 0xF3C0, 0xCDFE,
+	0xFBD2, 0xF8F8, 0xF7FB, 0xE8BF, 0xE8B7, 0xEDB6, 0xDCBA, 0xCCB4,
+	0xF1F7, 0xE8B8, 0xCAF6, 0xE4A4, 0xF4D6, 0xDFE6, 0xDFA7, 0xDFE7,
+	0xE1C1, 0xE9C4, 0xDCCB, 0xE9C5, 0xEFA3, 0xEBA6, 0xCBA3, 0xE3E9,
+	0xD1FB, 0xEFA4, 0xEFEB, 0xD0B4, 0xCDA3, 0xE8E6, 0xEFA5, 0xD3CC,
+	0xDAED, 0xD7BA, 0xF2D5, 0xF5E5, 0xD9EF, 0xF9B4, 0xD5D4, 0xFDCF,
+	0xDBE3, 0xF1E1, 0xECB6, 0xFBFE, 0xD3D7, 0xD1B1, 0xCBB1, 0xD1B2,
+	0xCBB2, 0xF1C2, 0xF4E1, 0xF9B5, 0xE1C3, 0xE1C2, 0xEBF7, 0xDFA8,
+	0xCBCA, 0xE6B9, 0xF8DE, 0xF9AA, 0xCAF7, 0xEDB7, 0xD3B8, 0xF2D6,
+	0xD4D9, 0xEEC5, 0xF2F0, 0xCAB2, 0xDCBB, 0xF1F8, 0xECB7, 0xE5CA,
+	0xF6C0, 0xFDDD, 0xD4E3, 0xCCE2, 0xF7D4, 0xD7E5, 0xD3C3, 0xD8A6,
+	0xF6C1, 0xDDF6, 0xCDC0, 0xE5DC, 0xE5CB, 0xE1C4, 0xE8B0, 0xF4B0,
+	0xF3EA, 0xDAEE, 0xD7BB, 0xE2B1, 0xD7AA, 0xD6FB, 0xE4DF, 0xCAD6,
+	0xEBA8, 0xDBFE, 0xF6C2, 0xEFBB, 0xD4FD, 0xE0C8, 0xE8B9, 0xEFA6,
+	0xCDA4, 0xD4F4, 0xDBA1, 0xDBDC, 0xDBDD, 0xEEDC, 0xCBCB, 0xFCD5,
+	0xCEEB, 0xCDC1, 0xFBD3, 0xF9AB, 0xF5D4, 0xD9A9, 0xE9DD, 0xDBCD,
+	0xDDCE, 0xE7C3, 0xECCC, 0xF9EC, 0xCBCC, 0xE0FC, 0xD4A8, 0xEDD3,
+	0xD8EF, 0xF2D7, 0xCAF8, 0xDAEF, 0xD6D4, 0xD9CD, 0xD8EE, 0xF2C1,
+	0xDFD3, 0xDAF0, 0xE2EA, 0xE0FD, 0xD8F8, 0xF7AF, 0xDAB6, 0xCAD7,
+	0xF2D8, 0xD8F9, 0xFADF, 0xCFEF, 0xD9C2, 0xF0D2, 0xE4D1, 0xF3B7,
+	0xFAE0, 0xEFEC, 0xE2B2, 0xD4BD, 0xD9CE, 0xF4E2, 0xD4A9, 0xCDC2,
+	0xE7DA, 0xF2D9, 0xD9AA, 0xD8BE, 0xDCAD, 0xE2EB, 0xD6FC, 0xCAF9,
+	0xD4DA, 0xF4D7, 0xCCA1, 0xCFBA, 0xF5B8, 0xD9C3, 0xD0E8, 0xE3C5,
+	0xEBF8, 0xF2B1, 0xCFBB, 0xD3AD, 0xE8E1, 0xCEEC, 0xE0B4, 0xDEE3,
+	0xDDF7, 0xF2B2, 0xF3F6, 0xF6DB, 0xD7FE, 0xF8DF, 0xF7F2, 0xD0A9,
+	0xE6DA, 0xF5A6, 0xD7BC, 0xCCE3, 0xE6DB, 0xDDDD, 0xD1B3, 0xEFED,
+	0xD6DE, 0xE4F4, 0xE1EF, 0xDDF8, 0xE8CF, 0xCAE5, 0xDCA1, 0xE0B5,
+	0xFCAC, 0xFCAD, 0xD8A7, 0xEDB8, 0xDBB6, 0xD6F0, 0xF3AF, 0xCDA5,
+	0xDAF1, 0xD8A8, 0xCCE4, 0xD1B4, 0xCAD8, 0xDAF2, 0xF5A7, 0xF5A8,
+	0xE6A6, 0xD5EC, 0xD5F8, 0xDAF3, 0xE3C6, 0xDEE4, 0xDEE5, 0xD1B5,
+	0xD1B6, 0xD1B7, 0xF2B3, 0xE9DE, 0xF0D3, 0xF2B4, 0xF0D4, 0xCBE4,
+	0xFBD4, 0xF5E6, 0xE3EA, 0xDEE6, 0xDFD4, 0xF8F9, 0xF0AE, 0xD1B8,
+	0xD6DF, 0xD0D7, 0xFCA1, 0xEFEE, 0xDCD8, 0xE9DF, 0xE5DD, 0xFDFB,
+	0xE0C9, 0xD6C9, 0xD4AA, 0xE5CC, 0xE9E0, 0xD0D8, 0xFCA2, 0xD4BE,
+	0xE2B3, 0xDEE7, 0xDCBC, 0xD2B6, 0xF5D5, 0xCEA1, 0xF5A9, 0xDDF9,
+	0xDDFA, 0xF0D5, 0xF6DF, 0xF2DA, 0xE4EB, 0xF2F1, 0xECB9, 0xFDFC,
+	0xE1AA, 0xCAD9, 0xEFEF, 0xF5AA, 0xECF9, 0xF8AD, 0xF2C2, 0xF6C3,
+	0xD7D2, 0xF9A2, 0xF0D6, 0xF0FA, 0xF6E0, 0xE9F3, 0xF2C3, 0xD4AB,
+	0xCAB3, 0xCDA6, 0xCDC3, 0xCDDA, 0xD9CF, 0xF6C4, 0xEEDD, 0xE7C4,
+	0xE2B4, 0xDFE2, 0xE7DB, 0xE8B1, 0xFCAE, 0xE5CD, 0xFAEB, 0xCFBC,
+	0xCFE2, 0xCDF6, 0xEFF0, 0xF4BE, 0xD4CD, 0xF3B8, 0xE9A1, 0xF2F2,
+	0xF3EB, 0xF0D7, 0xCFD7, 0xCFDF, 0xE8C0, 0xE8C1, 0xCFE3, 0xE9A2,
+	0xD0AA, 0xF3C1, 0xD0AB, 0xD4E4, 0xEFBC, 0xD8A1, 0xD9DF, 0xF3D7,
+	0xDCBD, 0xCCE5, 0xEDF1, 0xF1E2, 0xD4DB, 0xE2B5, 0xCAE6, 0xD3AE,
+	0xCCE6, 0xF1D3, 0xF5E7, 0xCADA, 0xFBEE, 0xE1C5, 0xDFE9, 0xEEDE,
+	0xF7C2, 0xD8A2, 0xDDAC, 0xF0AF, 0xD6BD, 0xE1AB, 0xF9B6, 0xD4F5,
+	0xD0C9, 0xEFA7, 0xE2EC, 0xDBEA, 0xCECC, 0xF5E8, 0xF7D5, 0xD3CD,
+	0xF3FE, 0xD0B5, 0xE0FE, 0xDFFB, 0xE6DD, 0xE8A4, 0xCBCD, 0xEFA8,
+	0xEEB4, 0xDAD8, 0xD1B9, 0xDFA9, 0xF3B0, 0xCCC4, 0xCEB7, 0xEFA9,
+	0xDFD5, 0xEDD7, 0xEEC6, 0xEFBD, 0xFCD6, 0xDBF4, 0xEFAA, 0xF8B9,
+	0xF5E9, 0xE3D9, 0xE1C6, 0xD4BF, 0xDEE8, 0xF0EA, 0xF3C2, 0xD3AF,
+	0xCADB, 0xFCD7, 0xEDD8, 0xE1C7, 0xF4D8, 0xD6B3, 0xDDAD, 0xD5BE,
+	0xF1C3, 0xEEDF, 0xD6EB, 0xF4D9, 0xD7E6, 0xDAB7, 0xDDFB, 0xDDCF,
+	0xD8A3, 0xDAD9, 0xF0D8, 0xEFC4, 0xE1D8, 0xF1D4, 0xEDF2, 0xD5DB,
+	0xD5DC, 0xF3C4, 0xCBD7, 0xE2B6, 0xEFF1, 0xFBD5, 0xD3D8, 0xDDD0,
+	0xF0D9, 0xCBB3, 0xD5DD, 0xCDA7, 0xD0AC, 0xD1BA, 0xF1C4, 0xE5B3,
+	0xFBF5, 0xE9E1, 0xFDE0, 0xFCBC, 0xDAA2, 0xDAA3, 0xD2A1, 0xD2EF,
+	0xE2ED, 0xDEE9, 0xCEDC, 0xF2B5, 0xD0E4, 0xDDD1, 0xE1C8, 0xDBB7,
+	0xDFE3, 0xEDB9, 0xF1C5, 0xF3CF, 0xD7AB, 0xE1AC, 0xE3EB, 0xEEC7,
+	0xE1C9, 0xCAFA, 0xF0FB, 0xFAE1, 0xF0DA, 0xCCE7, 0xDAF4, 0xCCBF,
+	0xCEED, 0xD5A9, 0xFAE2, 0xD0E5, 0xEBD6, 0xECDF, 0xDFFC, 0xF7D6,
+	0xDEEA, 0xCBB4, 0xEFBE, 0xCCB5, 0xCFBD, 0xEFF2, 0xE2B7, 0xCCE8,
+	0xF0FC, 0xD6E0, 0xF1C6, 0xE2B8, 0xEBAB, 0xCBB5, 0xD8D1, 0xF4CE,
+	0xF3F7, 0xD7C6, 0xD1BB, 0xF7AA, 0xEDCA, 0xD7D3, 0xD8FA, 0xF6C5,
+	0xD1CC, 0xDDFC, 0xDFFD, 0xF9E5, 0xE0CA, 0xF2FD, 0xD3B0, 0xF4F3,
+	0xDAC9, 0xE6DE, 0xF8BA, 0xE8D0, 0xD8FB, 0xEAD5, 0xD6A3, 0xF6C6,
+	0xF2DB, 0xE4FC, 0xE8B2, 0xDADA, 0xF2DC, 0xFBD6, 0xE9B2, 0xEEAD,
+	0xFAE3, 0xDCEE, 0xF5EA, 0xE6E0, 0xF0FD, 0xD7AC, 0xF5C5, 0xEEE0,
+	0xDBE5, 0xDDDE, 0xD9F0, 0xE9A3, 0xF1F9, 0xF2C4, 0xE0CB, 0xE9A4,
+	0xE2B9, 0xE3B1, 0xFCEB, 0xCDA8, 0xCCB6, 0xF0DB, 0xE6BA, 0xCDA9,
+	0xF3C3, 0xE1D9, 0xEFAB, 0xE7C5, 0xE0E9, 0xF3C5, 0xD4C0, 0xD5BF,
+	0xDDAE, 0xF9FC, 0xCCC0, 0xE5A2, 0xCEB8, 0xD8D2, 0xF9D6, 0xF1AA,
+	0xCED1, 0xF6C7, 0xDBEB, 0xDFFE, 0xD8E1, 0xF7F3, 0xD7E7, 0xD4FE,
+	0xD1BC, 0xE5CF, 0xCBB6, 0xDAB8, 0xCDC4, 0xD6BE, 0xE2BA, 0xCFD8,
+	0xE0CC, 0xEBF9, 0xFDFD, 0xD7E8, 0xCBD8, 0xE9E2, 0xE8BA, 0xE3C7,
+	0xECCD, 0xECCE, 0xD6BF, 0xE3A7, 0xDFD6, 0xFDE8, 0xEEE1, 0xF6A8,
+	0xDDFD, 0xF8BB, 0xE8D1, 0xF9D7, 0xCEEE, 0xECCF, 0xE9A5, 0xD6D5,
+	0xCDC5, 0xEDBA, 0xD1BD, 0xCFBE, 0xECBB, 0xD2B1, 0xCCE9, 0xD9C4,
+	0xE9FC, 0xD1BE, 0xECBC, 0xE5AD, 0xF7B0, 0xCCEA, 0xD3C4, 0xD6C0,
+	0xD6FD, 0xE1A1, 0xDEBD, 0xF6A9, 0xDAA4, 0xD6A4, 0xF5C6, 0xE1A2,
+	0xE9C6, 0xF2C5, 0xF4E9, 0xD6EC, 0xEBD3, 0xECBD, 0xE2DC, 0xDEEB,
+	0xF0DC, 0xEBBF, 0xD7CE, 0xD1BF, 0xF5AB, 0xF9FD, 0xCADC, 0xCDC6,
+	0xF2B6, 0xDDFE, 0xCCB7, 0xDBB8, 0xD0E9, 0xCEDD, 0xEBC0, 0xFDA2,
+	0xF8CB, 0xEAD6, 0xF1B0, 0xDBCE, 0xF7C3, 0xDBCF, 0xCBA4, 0xF8E0,
+	0xFBD7, 0xEBCA, 0xE0A1, 0xCECD, 0xD4DC, 0xFDD8, 0xD2F6, 0xF2B7,
+	0xFAF6, 0xF6AA, 0xFAF7, 0xD8E6, 0xF4B1, 0xE8D2, 0xCAC5, 0xCCEB,
+	0xE2EE, 0xE2BB, 0xF7AD, 0xF8E1, 0xF3EC, 0xDEA1, 0xE4FD, 0xE3EC,
+	0xDDAF, 0xDDB0, 0xCBB7, 0xE8D3, 0xE1A3, 0xD2E0, 0xF0FE, 0xE9A6,
+	0xCBF2, 0xEDF3, 0xDCD9, 0xE0CD, 0xF7DA, 0xDBB9, 0xCCAE, 0xDADB,
+	0xCDC7, 0xDDB1, 0xD8AF, 0xE3A3, 0xCEEF, 0xF2F3, 0xF8B3, 0xE0CE,
+	0xF5FD, 0xEBEC, 0xD3C5, 0xFCEC, 0xD2DB, 0xD4EB, 0xDEA2, 0xE5E6,
+	0xF0B0, 0xD5C4, 0xEDF4, 0xE3ED, 0xE8C2, 0xEDF5, 0xD7FC, 0xEDBB,
+	0xF6AB, 0xF2B8, 0xF6C8, 0xD3E6, 0xF2DD, 0xCFBF, 0xEBAC, 0xCFC0,
+	0xE6A8, 0xFDE9, 0xCFC1, 0xE0DF, 0xDEEC, 0xE0A2, 0xF4BF, 0xE2EF,
+	0xD9F1, 0xF1C7, 0xCBB8, 0xF9FE, 0xDBBA, 0xDAF5, 0xF6EC, 0xDADC,
+	0xFAE4, 0xE0CF, 0xDDB2, 0xE6A9, 0xEFF3, 0xF3ED, 0xEBFA, 0xF9E6,
+	0xCADD, 0xD5DE, 0xCADE, 0xDFE4, 0xE6FD, 0xF5AC, 0xE4F5, 0xE9E3,
+	0xEDCB, 0xCFE4, 0xD8D3, 0xDDB3, 0xD4EC, 0xF2B9, 0xDFB7, 0xCBCE,
+	0xFBD8, 0xD0D9, 0xDDD2, 0xF7F4, 0xE7DC, 0xE4A5, 0xFCA3, 0xDBBB,
+	0xF2BA, 0xE9FD, 0xD0CA, 0xF5D6, 0xD9C5, 0xE4B4, 0xEDA7, 0xEABD,
+	0xE6FE, 0xF7C4, 0xF5AD, 0xD9E0, 0xCAB4, 0xF8E2, 0xCFC2, 0xECBE,
+	0xE5B4, 0xCDC8, 0xEEC8, 0xE7C8, 0xCDC9, 0xF9B7, 0xF1E8, 0xD9F2,
+	0xDBF5, 0xCAB5, 0xD9C6, 0xD8C9, 0xD9AB, 0xEDBC, 0xD8D4, 0xDCDA,
+	0xE2BC, 0xFCED, 0xECE0, 0xD2FE, 0xE9C7, 0xE6AA, 0xE2F0, 0xFABB,
+	0xF5AE, 0xFBAA, 0xECFB, 0xECBF, 0xFCD8, 0xD4E5, 0xF9C3, 0xEEE2,
+	0xD7E9, 0xEDF6, 0xDEED, 0xCCEC, 0xE3EE, 0xE8D4, 0xFAF8, 0xDDB4,
+	0xE4B5, 0xD8B0, 0xD8D5, 0xF4EA, 0xCEB9, 0xD6E1, 0xCFD2, 0xD0B6,
+	0xCEA2, 0xF3EE, 0xF3F8, 0xDCCC, 0xD0CB, 0xFCA4, 0xCDCA, 0xD7D4,
+	0xDEA3, 0xE4E0, 0xEEC9, 0xE2DD, 0xF5FE, 0xD4AC, 0xD5D1, 0xD8F0,
+	0xF8C3, 0xEAD7, 0xF5D7, 0xD8BF, 0xFDC0, 0xEBAD, 0xD5AA, 0xE7A8,
+	0xEECA, 0xCAE7, 0xF8E3, 0xD4DD, 0xEAD8, 0xFBD9, 0xEDF7, 0xE5B5,
+	0xD0AD, 0xF1F1, 0xE2BD, 0xE3C8, 0xD9D5, 0xDFAA, 0xDBBC, 0xF8E4,
+	0xF1FA, 0xE5B6, 0xF3EF, 0xFBDA, 0xE1E0, 0xD9AC, 0xF5EB, 0xE0B6,
+	0xE9C8, 0xCBCF, 0xE3C9, 0xDEEE, 0xE2BE, 0xDCEF, 0xD6A5, 0xE2F1,
+	0xD6FE, 0xD9A1, 0xD8C0, 0xDCDB, 0xEDBD, 0xDFB8, 0xEAA5, 0xD7AD,
+	0xF3F9, 0xEDF8, 0xF5C7, 0xE1CA, 0xEBE3, 0xF2DE, 0xF8CC, 0xEAD9,
+	0xD3C6, 0xDBE6, 0xF5AF, 0xCEF0, 0xE9FE, 0xFBB6, 0xE2F2, 0xCFF2,
+	0xF7B9, 0xD9F3, 0xE1CB, 0xDADD, 0xDAB9, 0xEBFB, 0xCBB9, 0xEDF9,
+	0xE0E0, 0xF4C0, 0xFDBC, 0xDFB1, 0xE3EF, 0xE0A3, 0xFDB9, 0xF0B1,
+	0xCDCB, 0xEDBE, 0xD5C0, 0xE3F0, 0xEDFA, 0xE9E4, 0xD5ED, 0xE7DD,
+	0xD4F6, 0xE5B7, 0xDBE7, 0xE2BF, 0xEECB, 0xD7F4, 0xF0DD, 0xCEAB,
+	0xE7DE, 0xD6D6, 0xE1CC, 0xE8B3, 0xE5EE, 0xDCA2, 0xE0D0, 0xD5B5,
+	0xD5A1, 0xFBDB, 0xF9CB, 0xCBF3, 0xF4A5, 0xFAC8, 0xD6D7, 0xE9E5,
+	0xFBDC, 0xFDD0, 0xFBF6, 0xDAA5, 0xDBBD, 0xECE2, 0xCDF7, 0xF0DE,
+	0xF6C9, 0xDEEF, 0xD3B1, 0xFCEE, 0xE8C3, 0xF1C8, 0xCEF1, 0xF9ED,
+	0xF2F4, 0xE4B6, 0xF5B9, 0xDCF0, 0xE3F1, 0xE8A5, 0xF2BB, 0xDEA4,
+	0xDACC, 0xCAE9, 0xE3DA, 0xFCD9, 0xEADA, 0xF9C4, 0xE3A4, 0xFBDD,
+	0xEFCA, 0xE8C4, 0xD5CC, 0xEBD7, 0xD9AD, 0xFBAB, 0xD3D9, 0xD5A2,
+	0xF6DE, 0xDAF6, 0xE0D1, 0xE9A8, 0xF5F9, 0xFAAF, 0xEBFC, 0xE0EA,
+	0xE3B2, 0xD5C5, 0xF1E3, 0xD5EE, 0xCDCC, 0xEDD9, 0xD8C1, 0xFAEC,
+	0xF1EB, 0xFABC, 0xE6E2, 0xFAE5, 0xE2FA, 0xCAB6, 0xE4B7, 0xEADB,
+	0xF5FA, 0xFBAC, 0xCFC3, 0xEBFD, 0xF8FA, 0xDFB9, 0xE1F1, 0xD2A4,
+	0xF5FB, 0xD0DA, 0xD0DB, 0xEABE, 0xD9B1, 0xCAB7, 0xD3E7, 0xF8E5,
+	0xD3B2, 0xE2C0, 0xF2DF, 0xCDE5, 0xF9AC, 0xCDCD, 0xEEAE, 0xD6AE,
+	0xD7EA, 0xE7E0, 0xEBAE, 0xCFD9, 0xDCCD, 0xEDFB, 0xDEF0, 0xD7EB,
+	0xDEA5, 0xDFD7, 0xDBD0, 0xDBD1, 0xD5A3, 0xF0B2, 0xDCDC, 0xCAE8,
+	0xF8E6, 0xDCCE, 0xEADC, 0xDBD2, 0xE9B3, 0xF7DB, 0xE3A8, 0xD7AE,
+	0xE0E1, 0xCBBA, 0xE5D1, 0xD0DC, 0xD5C1, 0xD8CA, 0xE3A9, 0xE0A4,
+	0xE9A9, 0xD3C7, 0xDCDD, 0xF8AE, 0xCCB8, 0xD0AE, 0xD8F2, 0xE3CA,
+	0xCCAF, 0xD4AD, 0xF6D1, 0xD0CC, 0xCAC6, 0xD5C2, 0xCEBA, 0xCAC7,
+	0xFAB0, 0xDFD8, 0xF5BA, 0xE5EB, 0xEFF4, 0xDDB5, 0xCDAA, 0xE3F2,
+	0xFBF7, 0xF7D0, 0xFDBA, 0xFDE1, 0xF6FE, 0xD1C0, 0xE8C5, 0xE4B8,
+	0xE1E8, 0xCCC1, 0xD2ED, 0xDBBE, 0xE0E2, 0xFAC9, 0xE1CD, 0xCAB8,
+	0xF2E0, 0xF1C9, 0xDEF1, 0xF0DF, 0xF8C4, 0xEECC, 0xDEF2, 0xE7C9,
+	0xE2F3, 0xE7E1, 0xE3CB, 0xE3CC, 0xCFF8, 0xEFAC, 0xFDFE, 0xFCA5,
+	0xFAB1, 0xDFD9, 0xE0D2, 0xF4DA, 0xF1CA, 0xCEA3, 0xF2BC, 0xECE3,
+	0xE0A5, 0xF7AB, 0xEBAF, 0xE5DE, 0xE1A4, 0xCDAB, 0xD9F4, 0xE8A6,
+	0xCDCE, 0xE1E9, 0xFCEF, 0xE0E3, 0xE2C1, 0xCEA4, 0xDEA6, 0xEBFE,
+	0xEBDD, 0xF0E0, 0xF4DB, 0xE2F4, 0xD3C8, 0xF4EB, 0xEEB5, 0xF5D8,
+	0xD5DF, 0xD6E5, 0xEBB0, 0xF4E3, 0xE3CD, 0xF4F4, 0xFAB2, 0xEFF5,
+	0xCADF, 0xEBB1, 0xEDBF, 0xFDC9, 0xE4A6, 0xF9A4, 0xF0B3, 0xE5EC,
+	0xD1E7, 0xD9C7, 0xE4D7, 0xEADD, 0xD4F7, 0xDABA, 0xDACD, 0xF9CC,
+	0xE1DA, 0xDBBF, 0xCCC5, 0xECD0, 0xCBBB, 0xDEF3, 0xE9AA, 0xD9C8,
+	0xEEE3, 0xD7BD, 0xCFC4, 0xD0CD, 0xFCA6, 0xF1FB, 0xFDD2, 0xD1C1,
+	0xE3DB, 0xD3C9, 0xDCCF, 0xCCED, 0xDEA7, 0xE6BB, 0xECA1, 0xCCB9,
+	0xFBDE, 0xE7E2, 0xD4C1, 0xDCA8, 0xE2C2, 0xF3D8, 0xE5D3, 0xF3D9,
+	0xF3C6, 0xCDDB, 0xCDAC, 0xFCC3, 0xD4E7, 0xD1C2, 0xF9A5, 0xE8D5,
+	0xE3CE, 0xD4CA, 0xDFDA, 0xFBDF, 0xE7E3, 0xF8FB, 0xE3CF, 0xF5B0,
+	0xD8E7, 0xD9C9, 0xF8AF, 0xEFF6, 0xDDB6, 0xEEAF, 0xCDF8, 0xDEB8,
+	0xFCA7, 0xF7FC, 0xF7B1, 0xCEBB, 0xF4A1, 0xEECD, 0xE1AE, 0xECC3,
+	0xCFFE, 0xF8BF, 0xD8E2, 0xD3E8, 0xDEA8, 0xF4E4, 0xECC2, 0xD9F5,
+	0xF9C5, 0xDDD3, 0xD6F1, 0xECFC, 0xFCF0, 0xEDC0, 0xCAB9, 0xEEE4,
+	0xF2E1, 0xDEB9, 0xD6F2, 0xDEF4, 0xDFDB, 0xDBD3, 0xFAE7, 0xD8E3,
+	0xF4C1, 0xDDB7, 0xF2F5, 0xD4AE, 0xD6F3, 0xDDB8, 0xCFC5, 0xDFDF,
+	0xF2BE, 0xF6A1, 0xEBCB, 0xF1FC, 0xF3C7, 0xE0EB, 0xEDFC, 0xE1DB,
+	0xEEE5, 0xDEF5, 0xFAD3, 0xF1CB, 0xD0AF, 0xDDB9, 0xD1C3, 0xF5B1,
+	0xEAC6, 0xF0E1, 0xF6AC, 0xF5D9, 0xF0EB, 0xDDBA, 0xF2BF, 0xF7C5,
+	0xDBA2, 0xF2F6, 0xCABA, 0xF7F5, 0xCBE5, 0xEEE6, 0xE0D3, 0xCEA5,
+	0xD6D8, 0xD4AF, 0xE9C9, 0xD3CE, 0xF4C2, 0xCBE6, 0xF1A1, 0xEBB2,
+	0xF1A2, 0xEBB3, 0xF0B4, 0xCBF4, 0xD4B0, 0xF3B2, 0xFBB7, 0xF5EC,
+	0xEEE7, 0xF4B2, 0xF5ED, 0xCFF3, 0xF0E2, 0xEECE, 0xF1CC, 0xE5B8,
+	0xD7F5, 0xE3F3, 0xCFE5, 0xCFC6, 0xF3B3, 0xE4D8, 0xCFF9, 0xCFDA,
+	0xFACD, 0xE6E3, 0xF2E2, 0xF5EE, 0xCABB, 0xE3DC, 0xCEF2, 0xD6D9,
+	0xEEB0, 0xF4E5, 0xD8C2, 0xDCD0, 0xCCEE, 0xD5E0, 0xF6CA, 0xFDCA,
+	0xD8D6, 0xF4CF, 0xD6A6, 0xDCBE, 0xDBD4, 0xD7C7, 0xF2FE, 0xF1CD,
+	0xE2C3, 0xDCDE, 0xDCDF, 0xEFAD, 0xE6AB, 0xF9DD, 0xEABF, 0xEFAE,
+	0xF4D0, 0xCEF3, 0xE6AC, 0xCEDE, 0xD5F9, 0xE3F4, 0xCDD0, 0xD5B8,
+	0xF7FD, 0xDCA9, 0xDEF6, 0xDCAA, 0xF2E3, 0xE9B4, 0xD2DC, 0xE9E6,
+	0xE3F6, 0xE7CA, 0xD0CE, 0xDAF7, 0xCABC, 0xEEE8, 0xDADE, 0xF2F7,
+	0xE2FB, 0xCCA6, 0xDABB, 0xEEE9, 0xF5DA, 0xF7DC, 0xE1EA, 0xCEC1,
+	0xD4B1, 0xFDB1, 0xE6BD, 0xFBAD, 0xF8E7, 0xE1CE, 0xF7E2, 0xF5EF,
+	0xCFC7, 0xD4B2, 0xCCEF, 0xD4E8, 0xEECF, 0xF7D7, 0xE0A6, 0xD6C1,
+	0xE1DC, 0xF0E3, 0xF1E4, 0xDCF1, 0xD6A7, 0xF4F5, 0xF1CE, 0xF2E4,
+	0xD0B0, 0xECEF, 0xF9BA, 0xEBB5, 0xD4ED, 0xE2C4, 0xE9E7, 0xEBB4,
+	0xEAA1, 0xF8BC, 0xCEA6, 0xF9C6, 0xFCDA, 0xD4B3, 0xD3B9, 0xEADE,
+	0xE9AB, 0xE1E1, 0xD3CF, 0xF4F6, 0xEAC0, 0xE1CF, 0xCCBA, 0xEEEA,
+	0xF0E4, 0xF3B4, 0xD4EE, 0xF2C0, 0xF1E5, 0xF4C3, 0xE0D4, 0xEBB6,
+	0xD7A1, 0xCBE8, 0xF9AD, 0xE9AD, 0xD8E4, 0xFAB3, 0xE2C5, 0xFCBD,
+	0xECC4, 0xD8B1, 0xDCAB, 0xD5A4, 0xEBE9, 0xE8BB, 0xD8D7, 0xFBAE,
+	0xD1E1, 0xDBC0, 0xF5BE, 0xDEF7, 0xCAFB, 0xF7C6, 0xCFC8, 0xE1D0,
+	0xEED0, 0xE9F4, 0xCEF4, 0xD5CD, 0xCFDB, 0xDDBB, 0xCEAC, 0xE9E8,
+	0xD4B4, 0xE4C7, 0xF5DB, 0xFAC1, 0xDEA9, 0xD4F8, 0xEFF7, 0xD3B3,
+	0xEBB7, 0xEFF8, 0xF5DC, 0xEDCC, 0xDBD5, 0xF1CF, 0xF1D0, 0xF5B2,
+	0xD9AE, 0xD5AC, 0xE2C6, 0xFDA3, 0xFBE5, 0xDFAB, 0xE2F5, 0xF6AD,
+	0xF5B3, 0xF0B5, 0xE1A5, 0xF5DD, 0xECA2, 0xEDFD, 0xF5B4, 0xFBB8,
+	0xDBA3, 0xD6CA, 0xCBD9, 0xE5D4, 0xF3FA, 0xEBB8, 0xE0B7, 0xD7EC,
+	0xF1EC, 0xE5AF, 0xD5E1, 0xD7ED, 0xD1D1, 0xE1F2, 0xEFF9, 0xDDBC,
+	0xF6DC, 0xF0E5, 0xF4C4, 0xE9E9, 0xF3FB, 0xD4EF, 0xCCA2, 0xF7FE,
+	0xDFBC, 0xEBCD, 0xD0B7, 0xD6C2, 0xE8AD, 0xEFAF, 0xCBA5, 0xCBE9,
+	0xFAE8, 0xCCC6, 0xE6E7, 0xEAC7, 0xDBA4, 0xCFC9, 0xE2FC, 0xEFFA,
+	0xEBDE, 0xF5C8, 0xD4DE, 0xE0D5, 0xEFB0, 0xE2C7, 0xD9AF, 0xF9E7,
+	0xE7E5, 0xCFCA, 0xE1D1, 0xE2C8, 0xEFFB, 0xFAF9, 0xDCF2, 0xE0A7,
+	0xF8E8, 0xCBEA, 0xCBBC, 0xD6E2, 0xF5DE, 0xF5DF, 0xEEB6, 0xE2F6,
+	0xD3CA, 0xEFFC, 0xD1C4, 0xEFB1, 0xD1C5, 0xD0DE, 0xD9E1, 0xE0B8,
+	0xCDD1, 0xF3B9, 0xE7CC, 0xD6A8, 0xCEA7, 0xD4B5, 0xE4C8, 0xD3B4,
+	0xEBB9, 0xCBF5, 0xF6DD, 0xF1A3, 0xCCC7, 0xE9CA, 0xE1F0, 0xF5E0,
+	0xFBAF, 0xCBD1, 0xFBE0, 0xF2E5, 0xECF0, 0xF0EC, 0xEEEB, 0xE9CB,
+	0xCCF0, 0xD7AF, 0xF3A1, 0xFCF5, 0xF1A4, 0xE0D6, 0xEFB2, 0xF4D1,
+	0xF7A1, 0xF1D1, 0xCAFC, 0xCAFD, 0xCECE, 0xF3C8, 0xF3BA, 0xEDFE,
+	0xDAA6, 0xE0EC, 0xF8CD, 0xCBD2, 0xEBCE, 0xF9D8, 0xF9D9, 0xCAE0,
+	0xDACA, 0xCBA6, 0xCAC8, 0xF9EE, 0xDBEC, 0xD0B1, 0xD5EF, 0xE6F3,
+	0xE7A2, 0xE4D9, 0xE4E1, 0xFCC4, 0xF9EF, 0xCFF4, 0xF7E6, 0xCEBC,
+	0xF4C5, 0xDCA3, 0xDDBD, 0xF4C6, 0xF8A1, 0xE8D6, 0xDBC1, 0xF0E6,
+	0xE4B9, 0xF6ED, 0xF9AE, 0xDDBE, 0xD7B0, 0xD8E8, 0xCBBD, 0xF9DA,
+	0xF8CE, 0xF9F0, 0xE0ED, 0xE3B3, 0xF4B3, 0xEAC2, 0xF2E6, 0xF0B6,
+	0xDBD6, 0xEBE4, 0xF2E7, 0xD7D5, 0xD4B6, 0xF9E8, 0xD7C1, 0xE5D5,
+	0xE9EA, 0xD7CC, 0xD3E9, 0xE2C9, 0xFCDB, 0xCDAD, 0xCCB0, 0xEAA2,
+	0xE4F6, 0xD0C0, 0xF0B7, 0xEEA1, 0xD7F6, 0xE2CA, 0xE2CB, 0xFACF,
+	0xEBDF, 0xD6CB, 0xF4B4, 0xEDCD, 0xE4D2, 0xEAA9, 0xE4BA, 0xF3A2,
+	0xCDD2, 0xF6CB, 0xF1E6, 0xEDC1, 0xE8BC, 0xEED1, 0xF0E7, 0xE2CC,
+	0xE4AA, 0xF5E1, 0xEDDA, 0xD7EE, 0xD1F1, 0xE9EB, 0xE9EC, 0xE0E4,
+	0xDAA7, 0xDDD4, 0xEAA3, 0xD6C3, 0xD6F4, 0xDADF, 0xEFB3, 0xE2CD,
+	0xEFFD, 0xF2E8, 0xEFC5, 0xE7E7, 0xD7FD, 0xE7CE, 0xDFDC, 0xF9C7,
+	0xD9F6, 0xDFAC, 0xD6DA, 0xDCA4, 0xF0B8, 0xD5FA, 0xE4F7, 0xD6C4,
+	0xF4EC, 0xEFFE, 0xF0A1, 0xDEAA, 0xDABC, 0xD8FC, 0xFAD4, 0xECE5,
+	0xFCA8, 0xECE6, 0xD8CB, 0xFBB9, 0xE4D3, 0xCDF9, 0xCFD3, 0xCAEA,
+	0xCFD4, 0xF8BD, 0xF4C7, 0xEADF, 0xF9DB, 0xD4B7, 0xEBE5, 0xE1D2,
+	0xEAA4, 0xFAC2, 0xFBE1, 0xFAED, 0xF0A2, 0xCCF1, 0xFAA3, 0xE2F7,
+	0xE2CE, 0xE9F5, 0xE1EB, 0xE7E8, 0xE8D7, 0xDAF8, 0xD4CB, 0xF7F6,
+	0xD6C5, 0xD4E9, 0xFAFA, 0xCCF2, 0xF7DD, 0xDEBA, 0xCEA8, 0xF0B9,
+	0xE4FE, 0xE4C9, 0xE4D4, 0xEAC3, 0xEFB4, 0xD7BE, 0xFBE2, 0xCDD3,
+	0xEFB5, 0xFAE9, 0xF9A6, 0xDFBD, 0xF7C7, 0xF8FD, 0xF8FC, 0xDEAB,
+	0xDBE8, 0xE3DD, 0xE1E2, 0xD1C6, 0xF6D0, 0xEBE6, 0xDAF9, 0xECC7,
+	0xDEF8, 0xF8E9, 0xE3DE, 0xCEF5, 0xFAC3, 0xE5D7, 0xECC8, 0xF3C9,
+	0xE4BB, 0xE6AE, 0xEFB6, 0xDCBF, 0xCEBD, 0xD8C3, 0xD0CF, 0xCFFA,
+	0xF3CA, 0xE0D7, 0xD1C7, 0xE9AE, 0xE8BD, 0xFAC4, 0xE2CF, 0xFAC5,
+	0xF9B8, 0xDCE0, 0xFBB0, 0xD8A9, 0xE5DF, 0xF9A7, 0xF6EE, 0xF6CC,
+	0xE2F8, 0xECF1, 0xDAE0, 0xF1D2, 0xD2CC, 0xCFCB, 0xCABD, 0xDDBF,
+	0xF6EF, 0xDEF9, 0xFAB4, 0xD5AD, 0xF1E7, 0xDEBE, 0xDCC0, 0xD1C8,
+	0xD1C9, 0xF8BE, 0xCBF6, 0xD4F9, 0xF5E2, 0xE1D3, 0xD8E9, 0xF8FE,
+	0xCFCC, 0xFDA4, 0xCEF6, 0xFAD0, 0xCCF3, 0xE6BE, 0xF6AE, 0xD5F0,
+	0xD1CA, 0xFCBE, 0xD5F1, 0xCDE9, 0xFAB5, 0xE2D0, 0xF4F7, 0xCDD4,
+	0xE7A3, 0xDBA5, 0xE2D1, 0xD7A2, 0xF7E3, 0xEAA6, 0xD0A1, 0xCEDA,
+	0xFBEB, 0xDBA6, 0xDBDE, 0xD8E5, 0xEAE0, 0xD8AA, 0xE5E0, 0xD6DB,
+	0xEFC6, 0xF8EA, 0xE4D5, 0xCEF7, 0xE0D8, 0xD7EF, 0xF4ED, 0xCDE6,
+	0xCCF4, 0xF5E3, 0xE4CA, 0xDCE1, 0xF9C8, 0xFCBF, 0xE8A7, 0xD8C4,
+	0xCBBE, 0xDCAE, 0xD7F7, 0xF0E8, 0xDDC0, 0xCFCD, 0xDCF3, 0xD9B0,
+	0xE6E9, 0xE4BC, 0xEAC4, 0xE4EC, 0xE4E5, 0xFBF8, 0xCCBB, 0xE4BD,
+	0xCDDC, 0xD9F7, 0xDDDF, 0xEDCE, 0xD9D0, 0xE5A3, 0xF9CD, 0xCDAE,
+	0xCFCE, 0xF6AF, 0xFDD3, 0xEBED, 0xD6DC, 0xE5A4, 0xD5B6, 0xD6DD,
+	0xF9E9, 0xE7A4, 0xD6E3, 0xD1CB, 0xD6E4, 0xD5F2, 0xDEFA, 0xD7F8,
+	0xD8EA, 0xCFD5, 0xD8FD, 0xD8AB, 0xFDCB, 0xFCDC, 0xE0A8, 0xD5F3,
+	0xFDD9, 0xCCA3, 0xD9F9, 0xD3EA, 0xF5F5, 0xEFC7, 0xD3DA, 0xDABD,
+	0xE8A8, 0xDCAF, 0xF0A3, 0xCDD5, 0xE0A9, 0xDEAC, 0xF0BA, 0xEEB1,
+	0xEEB2, 0xF6CD, 0xEED2, 0xD6C6, 0xE0E5, 0xF3BB, 0xE5E1, 0xE4CB,
+	0xD7A3, 0xDBC2, 0xCAFE, 0xCFCF, 0xB0A1, 0xB0A2, 0x8141, 0x8142,
+	0xB0A3, 0x8143, 0x8144, 0xB0A4, 0xB0A5, 0xB0A6, 0xB0A7, 0x8145,
+	0x8146, 0x8147, 0x8148, 0x8149, 0xB0A8, 0xB0A9, 0xB0AA, 0xB0AB,
+	0xB0AC, 0xB0AD, 0xB0AE, 0xB0AF, 0x814A, 0xB0B0, 0xB0B1, 0xB0B2,
+	0xB0B3, 0xB0B4, 0x814B, 0x814C, 0xB0B5, 0x814D, 0x814E, 0x814F,
+	0xB0B6, 0x8150, 0x8151, 0x8152, 0x8153, 0x8154, 0x8155, 0x8156,
+	0xB0B7, 0xB0B8, 0x8157, 0xB0B9, 0xB0BA, 0xB0BB, 0x8158, 0x8159,
+	0x815A, 0x8161, 0x8162, 0x8163, 0xB0BC, 0xB0BD, 0x8164, 0x8165,
+	0xB0BE, 0x8166, 0x8167, 0x8168, 0xB0BF, 0x8169, 0x816A, 0x816B,
+	0x816C, 0x816D, 0x816E, 0x816F, 0x8170, 0x8171, 0x8172, 0xB0C0,
+	0x8173, 0xB0C1, 0x8174, 0x8175, 0x8176, 0x8177, 0x8178, 0x8179,
+	0xB0C2, 0x817A, 0x8181, 0x8182, 0xB0C3, 0x8183, 0x8184, 0x8185,
+	0xB0C4, 0x8186, 0x8187, 0x8188, 0x8189, 0x818A, 0x818B, 0x818C,
+	0x818D, 0x818E, 0x818F, 0x8190, 0x8191, 0x8192, 0x8193, 0x8194,
+	0x8195, 0x8196, 0x8197, 0x8198, 0xB0C5, 0xB0C6, 0x8199, 0x819A,
+	0xB0C7, 0x819B, 0x819C, 0xB0C8, 0xB0C9, 0x819D, 0xB0CA, 0x819E,
+	0x819F, 0x81A0, 0x81A1, 0x81A2, 0xB0CB, 0xB0CC, 0x81A3, 0xB0CD,
+	0xB0CE, 0xB0CF, 0xB0D0, 0x81A4, 0x81A5, 0xB0D1, 0xB0D2, 0xB0D3,
+	0xB0D4, 0x81A6, 0x81A7, 0x81A8, 0xB0D5, 0x81A9, 0x81AA, 0x81AB,
+	0xB0D6, 0x81AC, 0x81AD, 0x81AE, 0x81AF, 0x81B0, 0x81B1, 0x81B2,
+	0xB0D7, 0xB0D8, 0x81B3, 0xB0D9, 0xB0DA, 0xB0DB, 0x81B4, 0x81B5,
+	0x81B6, 0x81B7, 0x81B8, 0x81B9, 0xB0DC, 0xB0DD, 0xB0DE, 0x81BA,
+	0xB0DF, 0x81BB, 0x81BC, 0xB0E0, 0xB0E1, 0x81BD, 0x81BE, 0x81BF,
+	0x81C0, 0x81C1, 0x81C2, 0x81C3, 0xB0E2, 0xB0E3, 0x81C4, 0xB0E4,
+	0xB0E5, 0xB0E6, 0x81C5, 0x81C6, 0x81C7, 0xB0E7, 0x81C8, 0x81C9,
+	0xB0E8, 0x81CA, 0x81CB, 0x81CC, 0xB0E9, 0x81CD, 0x81CE, 0x81CF,
+	0xB0EA, 0x81D0, 0x81D1, 0x81D2, 0x81D3, 0x81D4, 0x81D5, 0x81D6,
+	0x81D7, 0xB0EB, 0x81D8, 0xB0EC, 0x81D9, 0x81DA, 0x81DB, 0x81DC,
+	0x81DD, 0x81DE, 0x81DF, 0x81E0, 0xB0ED, 0xB0EE, 0x81E1, 0x81E2,
+	0xB0EF, 0x81E3, 0x81E4, 0xB0F0, 0xB0F1, 0x81E5, 0xB0F2, 0x81E6,
+	0xB0F3, 0x81E7, 0x81E8, 0xB0F4, 0xB0F5, 0xB0F6, 0x81E9, 0xB0F7,
+	0x81EA, 0xB0F8, 0xB0F9, 0x81EB, 0x81EC, 0x81ED, 0x81EE, 0x81EF,
+	0xB0FA, 0xB0FB, 0x81F0, 0x81F1, 0xB0FC, 0x81F2, 0x81F3, 0x81F4,
+	0xB0FD, 0x81F5, 0xB0FE, 0x81F6, 0x81F7, 0x81F8, 0x81F9, 0x81FA,
+	0xB1A1, 0xB1A2, 0x81FB, 0xB1A3, 0x81FC, 0xB1A4, 0x81FD, 0x81FE,
+	0x8241, 0x8242, 0x8243, 0x8244, 0xB1A5, 0x8245, 0x8246, 0x8247,
+	0xB1A6, 0x8248, 0x8249, 0x824A, 0xB1A7, 0x824B, 0x824C, 0x824D,
+	0x824E, 0x824F, 0x8250, 0x8251, 0x8252, 0xB1A8, 0x8253, 0x8254,
+	0xB1A9, 0xB1AA, 0x8255, 0x8256, 0x8257, 0x8258, 0x8259, 0x825A,
+	0xB1AB, 0xB1AC, 0x8261, 0x8262, 0xB1AD, 0x8263, 0x8264, 0x8265,
+	0xB1AE, 0x8266, 0x8267, 0x8268, 0x8269, 0x826A, 0x826B, 0x826C,
+	0xB1AF, 0xB1B0, 0x826D, 0xB1B1, 0x826E, 0xB1B2, 0x826F, 0x8270,
+	0x8271, 0x8272, 0x8273, 0x8274, 0xB1B3, 0x8275, 0x8276, 0x8277,
+	0xB1B4, 0x8278, 0x8279, 0x827A, 0xB1B5, 0x8281, 0x8282, 0x8283,
+	0x8284, 0x8285, 0x8286, 0x8287, 0x8288, 0xB1B6, 0x8289, 0xB1B7,
+	0x828A, 0x828B, 0x828C, 0x828D, 0x828E, 0x828F, 0x8290, 0x8291,
+	0xB1B8, 0xB1B9, 0x8292, 0x8293, 0xB1BA, 0x8294, 0x8295, 0xB1BB,
+	0xB1BC, 0xB1BD, 0xB1BE, 0x8296, 0x8297, 0x8298, 0x8299, 0xB1BF,
+	0xB1C0, 0xB1C1, 0x829A, 0xB1C2, 0x829B, 0xB1C3, 0xB1C4, 0x829C,
+	0x829D, 0x829E, 0x829F, 0x82A0, 0xB1C5, 0xB1C6, 0x82A1, 0x82A2,
+	0xB1C7, 0x82A3, 0x82A4, 0x82A5, 0xB1C8, 0x82A6, 0x82A7, 0x82A8,
+	0x82A9, 0x82AA, 0x82AB, 0x82AC, 0x82AD, 0x82AE, 0x82AF, 0x82B0,
+	0xB1C9, 0xB1CA, 0x82B1, 0x82B2, 0x82B3, 0x82B4, 0x82B5, 0x82B6,
+	0xB1CB, 0x82B7, 0x82B8, 0x82B9, 0x82BA, 0x82BB, 0x82BC, 0x82BD,
+	0x82BE, 0x82BF, 0x82C0, 0x82C1, 0x82C2, 0x82C3, 0x82C4, 0x82C5,
+	0x82C6, 0x82C7, 0x82C8, 0xB1CC, 0x82C9, 0x82CA, 0x82CB, 0x82CC,
+	0x82CD, 0x82CE, 0x82CF, 0x82D0, 0xB1CD, 0xB1CE, 0x82D1, 0x82D2,
+	0xB1CF, 0x82D3, 0x82D4, 0x82D5, 0xB1D0, 0x82D6, 0x82D7, 0x82D8,
+	0x82D9, 0x82DA, 0x82DB, 0x82DC, 0xB1D1, 0xB1D2, 0x82DD, 0xB1D3,
+	0x82DE, 0x82DF, 0x82E0, 0x82E1, 0x82E2, 0x82E3, 0x82E4, 0x82E5,
+	0xB1D4, 0x82E6, 0x82E7, 0x82E8, 0xB1D5, 0x82E9, 0x82EA, 0x82EB,
+	0xB1D6, 0x82EC, 0x82ED, 0x82EE, 0x82EF, 0x82F0, 0x82F1, 0x82F2,
+	0x82F3, 0x82F4, 0x82F5, 0x82F6, 0x82F7, 0x82F8, 0x82F9, 0x82FA,
+	0x82FB, 0x82FC, 0x82FD, 0x82FE, 0xB1D7, 0xB1D8, 0x8341, 0x8342,
+	0xB1D9, 0x8343, 0x8344, 0xB1DA, 0xB1DB, 0xB1DC, 0x8345, 0x8346,
+	0x8347, 0x8348, 0x8349, 0x834A, 0xB1DD, 0xB1DE, 0x834B, 0xB1DF,
+	0x834C, 0xB1E0, 0x834D, 0x834E, 0x834F, 0x8350, 0x8351, 0x8352,
+	0xB1E1, 0x8353, 0x8354, 0x8355, 0x8356, 0x8357, 0x8358, 0x8359,
+	0x835A, 0x8361, 0x8362, 0x8363, 0x8364, 0x8365, 0x8366, 0x8367,
+	0x8368, 0x8369, 0x836A, 0x836B, 0x836C, 0x836D, 0x836E, 0x836F,
+	0x8370, 0x8371, 0x8372, 0x8373, 0xB1E2, 0xB1E3, 0x8374, 0x8375,
+	0xB1E4, 0x8376, 0x8377, 0xB1E5, 0xB1E6, 0x8378, 0xB1E7, 0x8379,
+	0x837A, 0x8381, 0x8382, 0x8383, 0xB1E8, 0xB1E9, 0x8384, 0xB1EA,
+	0x8385, 0xB1EB, 0xB1EC, 0x8386, 0x8387, 0x8388, 0xB1ED, 0x8389,
+	0xB1EE, 0xB1EF, 0xB1F0, 0x838A, 0xB1F1, 0x838B, 0x838C, 0x838D,
+	0xB1F2, 0x838E, 0xB1F3, 0x838F, 0x8390, 0x8391, 0x8392, 0x8393,
+	0xB1F4, 0xB1F5, 0x8394, 0xB1F6, 0xB1F7, 0xB1F8, 0x8395, 0x8396,
+	0x8397, 0xB1F9, 0x8398, 0x8399, 0xB1FA, 0xB1FB, 0x839A, 0x839B,
+	0xB1FC, 0x839C, 0x839D, 0x839E, 0xB1FD, 0x839F, 0x83A0, 0x83A1,
+	0x83A2, 0x83A3, 0x83A4, 0x83A5, 0xB1FE, 0xB2A1, 0x83A6, 0xB2A2,
+	0xB2A3, 0xB2A4, 0x83A7, 0x83A8, 0x83A9, 0x83AA, 0x83AB, 0x83AC,
+	0xB2A5, 0xB2A6, 0x83AD, 0x83AE, 0x83AF, 0x83B0, 0x83B1, 0x83B2,
+	0xB2A7, 0x83B3, 0x83B4, 0x83B5, 0x83B6, 0x83B7, 0x83B8, 0x83B9,
+	0x83BA, 0x83BB, 0x83BC, 0x83BD, 0x83BE, 0x83BF, 0x83C0, 0x83C1,
+	0x83C2, 0x83C3, 0x83C4, 0x83C5, 0x83C6, 0x83C7, 0x83C8, 0x83C9,
+	0x83CA, 0x83CB, 0x83CC, 0x83CD, 0x83CE, 0x83CF, 0x83D0, 0x83D1,
+	0x83D2, 0x83D3, 0x83D4, 0x83D5, 0x83D6, 0x83D7, 0x83D8, 0x83D9,
+	0x83DA, 0x83DB, 0x83DC, 0x83DD, 0x83DE, 0x83DF, 0x83E0, 0x83E1,
+	0xB2A8, 0xB2A9, 0xB2AA, 0x83E2, 0xB2AB, 0x83E3, 0x83E4, 0x83E5,
+	0xB2AC, 0x83E6, 0x83E7, 0x83E8, 0x83E9, 0x83EA, 0x83EB, 0x83EC,
+	0xB2AD, 0xB2AE, 0x83ED, 0xB2AF, 0xB2B0, 0xB2B1, 0x83EE, 0x83EF,
+	0x83F0, 0x83F1, 0x83F2, 0x83F3, 0xB2B2, 0xB2B3, 0x83F4, 0x83F5,
+	0xB2B4, 0x83F6, 0x83F7, 0x83F8, 0x83F9, 0x83FA, 0x83FB, 0x83FC,
+	0x83FD, 0x83FE, 0x8441, 0x8442, 0xB2B5, 0x8443, 0x8444, 0xB2B6,
+	0x8445, 0xB2B7, 0x8446, 0x8447, 0x8448, 0x8449, 0x844A, 0x844B,
+	0xB2B8, 0x844C, 0x844D, 0x844E, 0xB2B9, 0x844F, 0x8450, 0x8451,
+	0xB2BA, 0x8452, 0x8453, 0x8454, 0x8455, 0x8456, 0x8457, 0x8458,
+	0x8459, 0x845A, 0x8461, 0xB2BB, 0xB2BC, 0x8462, 0x8463, 0x8464,
+	0x8465, 0xB2BD, 0x8466, 0x8467, 0xB2BE, 0x8468, 0x8469, 0x846A,
+	0x846B, 0x846C, 0x846D, 0x846E, 0x846F, 0x8470, 0x8471, 0x8472,
+	0x8473, 0x8474, 0x8475, 0x8476, 0x8477, 0x8478, 0x8479, 0x847A,
+	0x8481, 0x8482, 0x8483, 0x8484, 0x8485, 0x8486, 0x8487, 0x8488,
+	0xB2BF, 0xB2C0, 0x8489, 0x848A, 0xB2C1, 0x848B, 0xB2C2, 0x848C,
+	0xB2C3, 0x848D, 0x848E, 0x848F, 0x8490, 0x8491, 0x8492, 0x8493,
+	0xB2C4, 0xB2C5, 0x8494, 0xB2C6, 0x8495, 0xB2C7, 0xB2C8, 0xB2C9,
+	0x8496, 0x8497, 0x8498, 0x8499, 0xB2CA, 0xB2CB, 0x849A, 0x849B,
+	0x849C, 0x849D, 0x849E, 0x849F, 0xB2CC, 0x84A0, 0x84A1, 0x84A2,
+	0x84A3, 0x84A4, 0x84A5, 0x84A6, 0x84A7, 0x84A8, 0x84A9, 0x84AA,
+	0xB2CD, 0xB2CE, 0x84AB, 0x84AC, 0x84AD, 0x84AE, 0x84AF, 0x84B0,
+	0xB2CF, 0xB2D0, 0x84B1, 0x84B2, 0x84B3, 0x84B4, 0x84B5, 0x84B6,
+	0x84B7, 0x84B8, 0x84B9, 0x84BA, 0x84BB, 0x84BC, 0x84BD, 0x84BE,
+	0x84BF, 0x84C0, 0x84C1, 0x84C2, 0x84C3, 0xB2D1, 0x84C4, 0x84C5,
+	0x84C6, 0x84C7, 0x84C8, 0x84C9, 0xB2D2, 0x84CA, 0x84CB, 0x84CC,
+	0xB2D3, 0x84CD, 0x84CE, 0x84CF, 0xB2D4, 0x84D0, 0x84D1, 0x84D2,
+	0x84D3, 0x84D4, 0x84D5, 0x84D6, 0xB2D5, 0xB2D6, 0x84D7, 0x84D8,
+	0x84D9, 0xB2D7, 0x84DA, 0x84DB, 0x84DC, 0x84DD, 0x84DE, 0x84DF,
+	0xB2D8, 0x84E0, 0x84E1, 0x84E2, 0x84E3, 0x84E4, 0x84E5, 0x84E6,
+	0x84E7, 0x84E8, 0x84E9, 0x84EA, 0x84EB, 0x84EC, 0x84ED, 0x84EE,
+	0x84EF, 0x84F0, 0x84F1, 0x84F2, 0x84F3, 0x84F4, 0x84F5, 0x84F6,
+	0x84F7, 0x84F8, 0x84F9, 0x84FA, 0xB2D9, 0xB2DA, 0x84FB, 0x84FC,
+	0xB2DB, 0x84FD, 0x84FE, 0x8541, 0xB2DC, 0x8542, 0x8543, 0x8544,
+	0x8545, 0x8546, 0x8547, 0xB2DD, 0xB2DE, 0xB2DF, 0x8548, 0xB2E0,
+	0x8549, 0xB2E1, 0xB2E2, 0x854A, 0x854B, 0x854C, 0x854D, 0x854E,
+	0xB2E3, 0x854F, 0x8550, 0x8551, 0x8552, 0x8553, 0x8554, 0x8555,
+	0xB2E4, 0x8556, 0x8557, 0x8558, 0x8559, 0x855A, 0x8561, 0x8562,
+	0x8563, 0x8564, 0x8565, 0x8566, 0xB2E5, 0xB2E6, 0x8567, 0x8568,
+	0x8569, 0x856A, 0x856B, 0x856C, 0xB2E7, 0xB2E8, 0x856D, 0x856E,
+	0xB2E9, 0x856F, 0x8570, 0x8571, 0xB2EA, 0x8572, 0x8573, 0x8574,
+	0x8575, 0x8576, 0x8577, 0x8578, 0xB2EB, 0xB2EC, 0x8579, 0x857A,
+	0xB2ED, 0x8581, 0x8582, 0x8583, 0x8584, 0x8585, 0x8586, 0x8587,
+	0xB2EE, 0x8588, 0x8589, 0x858A, 0xB2EF, 0x858B, 0x858C, 0x858D,
+	0xB2F0, 0x858E, 0x858F, 0x8590, 0x8591, 0x8592, 0x8593, 0x8594,
+	0xB2F1, 0xB2F2, 0x8595, 0x8596, 0x8597, 0x8598, 0x8599, 0x859A,
+	0x859B, 0x859C, 0x859D, 0x859E, 0xB2F3, 0x859F, 0x85A0, 0x85A1,
+	0x85A2, 0x85A3, 0x85A4, 0x85A5, 0x85A6, 0x85A7, 0x85A8, 0x85A9,
+	0x85AA, 0x85AB, 0x85AC, 0x85AD, 0x85AE, 0x85AF, 0x85B0, 0x85B1,
+	0x85B2, 0x85B3, 0x85B4, 0x85B5, 0x85B6, 0x85B7, 0x85B8, 0x85B9,
+	0xB2F4, 0xB2F5, 0x85BA, 0x85BB, 0xB2F6, 0x85BC, 0xB2F7, 0x85BD,
+	0xB2F8, 0x85BE, 0xB2F9, 0x85BF, 0x85C0, 0x85C1, 0x85C2, 0xB2FA,
+	0xB2FB, 0xB2FC, 0x85C3, 0xB2FD, 0x85C4, 0xB2FE, 0x85C5, 0x85C6,
+	0x85C7, 0xB3A1, 0x85C8, 0x85C9, 0x85CA, 0x85CB, 0x85CC, 0x85CD,
+	0x85CE, 0x85CF, 0x85D0, 0x85D1, 0x85D2, 0x85D3, 0x85D4, 0x85D5,
+	0x85D6, 0x85D7, 0x85D8, 0x85D9, 0x85DA, 0x85DB, 0x85DC, 0x85DD,
+	0x85DE, 0x85DF, 0x85E0, 0x85E1, 0x85E2, 0x85E3, 0x85E4, 0x85E5,
+	0xB3A2, 0xB3A3, 0x85E6, 0x85E7, 0xB3A4, 0x85E8, 0x85E9, 0x85EA,
+	0xB3A5, 0x85EB, 0x85EC, 0x85ED, 0x85EE, 0x85EF, 0x85F0, 0x85F1,
+	0xB3A6, 0xB3A7, 0x85F2, 0xB3A8, 0x85F3, 0xB3A9, 0x85F4, 0x85F5,
+	0x85F6, 0x85F7, 0x85F8, 0x85F9, 0xB3AA, 0xB3AB, 0xB3AC, 0x85FA,
+	0xB3AD, 0x85FB, 0x85FC, 0xB3AE, 0xB3AF, 0xB3B0, 0xB3B1, 0x85FD,
+	0x85FE, 0x8641, 0x8642, 0x8643, 0xB3B2, 0xB3B3, 0x8644, 0xB3B4,
+	0xB3B5, 0xB3B6, 0xB3B7, 0xB3B8, 0x8645, 0xB3B9, 0x8646, 0xB3BA,
+	0xB3BB, 0xB3BC, 0x8647, 0x8648, 0xB3BD, 0x8649, 0x864A, 0x864B,
+	0xB3BE, 0x864C, 0x864D, 0x864E, 0x864F, 0x8650, 0x8651, 0x8652,
+	0xB3BF, 0xB3C0, 0x8653, 0xB3C1, 0xB3C2, 0xB3C3, 0x8654, 0x8655,
+	0x8656, 0x8657, 0x8658, 0x8659, 0xB3C4, 0xB3C5, 0x865A, 0x8661,
+	0xB3C6, 0x8662, 0x8663, 0x8664, 0xB3C7, 0x8665, 0x8666, 0x8667,
+	0x8668, 0x8669, 0x866A, 0x866B, 0xB3C8, 0x866C, 0x866D, 0x866E,
+	0x866F, 0xB3C9, 0x8670, 0x8671, 0x8672, 0x8673, 0x8674, 0x8675,
+	0x8676, 0x8677, 0x8678, 0x8679, 0x867A, 0x8681, 0x8682, 0x8683,
+	0x8684, 0x8685, 0x8686, 0x8687, 0x8688, 0x8689, 0x868A, 0x868B,
+	0x868C, 0x868D, 0x868E, 0x868F, 0x8690, 0x8691, 0x8692, 0x8693,
+	0x8694, 0x8695, 0x8696, 0x8697, 0xB3CA, 0xB3CB, 0x8698, 0xB3CC,
+	0xB3CD, 0x8699, 0x869A, 0x869B, 0xB3CE, 0x869C, 0xB3CF, 0xB3D0,
+	0x869D, 0x869E, 0x869F, 0x86A0, 0xB3D1, 0xB3D2, 0x86A1, 0xB3D3,
+	0xB3D4, 0xB3D5, 0x86A2, 0x86A3, 0x86A4, 0x86A5, 0x86A6, 0xB3D6,
+	0xB3D7, 0xB3D8, 0x86A7, 0x86A8, 0xB3D9, 0x86A9, 0x86AA, 0x86AB,
+	0xB3DA, 0x86AC, 0x86AD, 0x86AE, 0x86AF, 0x86B0, 0x86B1, 0x86B2,
+	0xB3DB, 0xB3DC, 0x86B3, 0xB3DD, 0xB3DE, 0xB3DF, 0x86B4, 0x86B5,
+	0x86B6, 0x86B7, 0x86B8, 0x86B9, 0xB3E0, 0xB3E1, 0x86BA, 0x86BB,
+	0xB3E2, 0x86BC, 0x86BD, 0x86BE, 0xB3E3, 0x86BF, 0x86C0, 0x86C1,
+	0x86C2, 0x86C3, 0x86C4, 0x86C5, 0xB3E4, 0xB3E5, 0x86C6, 0x86C7,
+	0xB3E6, 0xB3E7, 0x86C8, 0x86C9, 0xB3E8, 0x86CA, 0x86CB, 0x86CC,
+	0xB3E9, 0x86CD, 0x86CE, 0x86CF, 0xB3EA, 0x86D0, 0x86D1, 0x86D2,
+	0x86D3, 0x86D4, 0x86D5, 0x86D6, 0x86D7, 0x86D8, 0x86D9, 0x86DA,
+	0x86DB, 0x86DC, 0x86DD, 0x86DE, 0x86DF, 0x86E0, 0x86E1, 0x86E2,
+	0x86E3, 0x86E4, 0x86E5, 0x86E6, 0xB3EB, 0xB3EC, 0x86E7, 0x86E8,
+	0xB3ED, 0x86E9, 0x86EA, 0x86EB, 0xB3EE, 0x86EC, 0xB3EF, 0x86ED,
+	0x86EE, 0x86EF, 0x86F0, 0x86F1, 0xB3F0, 0xB3F1, 0x86F2, 0xB3F2,
+	0x86F3, 0xB3F3, 0x86F4, 0x86F5, 0x86F6, 0x86F7, 0xB3F4, 0xB3F5,
+	0xB3F6, 0x86F8, 0x86F9, 0x86FA, 0xB3F7, 0x86FB, 0x86FC, 0x86FD,
+	0xB3F8, 0x86FE, 0x8741, 0x8742, 0x8743, 0x8744, 0x8745, 0x8746,
+	0x8747, 0x8748, 0x8749, 0x874A, 0xB3F9, 0x874B, 0x874C, 0x874D,
+	0x874E, 0x874F, 0x8750, 0x8751, 0x8752, 0x8753, 0x8754, 0x8755,
+	0x8756, 0x8757, 0x8758, 0x8759, 0x875A, 0x8761, 0x8762, 0x8763,
+	0x8764, 0x8765, 0x8766, 0x8767, 0x8768, 0x8769, 0x876A, 0x876B,
+	0x876C, 0x876D, 0x876E, 0x876F, 0x8770, 0x8771, 0x8772, 0x8773,
+	0xB3FA, 0x8774, 0x8775, 0x8776, 0xB3FB, 0x8777, 0x8778, 0x8779,
+	0xB3FC, 0x877A, 0x8781, 0x8782, 0x8783, 0x8784, 0x8785, 0x8786,
+	0xB3FD, 0xB3FE, 0x8787, 0xB4A1, 0x8788, 0x8789, 0x878A, 0x878B,
+	0x878C, 0x878D, 0x878E, 0x878F, 0xB4A2, 0xB4A3, 0x8790, 0x8791,
+	0xB4A4, 0x8792, 0x8793, 0x8794, 0xB4A5, 0x8795, 0x8796, 0x8797,
+	0x8798, 0x8799, 0x879A, 0x879B, 0x879C, 0xB4A6, 0x879D, 0xB4A7,
+	0x879E, 0xB4A8, 0x879F, 0x87A0, 0x87A1, 0x87A2, 0x87A3, 0x87A4,
+	0xB4A9, 0xB4AA, 0x87A5, 0x87A6, 0xB4AB, 0x87A7, 0x87A8, 0xB4AC,
+	0xB4AD, 0x87A9, 0x87AA, 0x87AB, 0x87AC, 0x87AD, 0x87AE, 0x87AF,
+	0xB4AE, 0xB4AF, 0x87B0, 0xB4B0, 0x87B1, 0xB4B1, 0x87B2, 0x87B3,
+	0x87B4, 0x87B5, 0x87B6, 0x87B7, 0xB4B2, 0x87B8, 0x87B9, 0x87BA,
+	0x87BB, 0x87BC, 0x87BD, 0x87BE, 0x87BF, 0x87C0, 0x87C1, 0x87C2,
+	0x87C3, 0x87C4, 0x87C5, 0x87C6, 0x87C7, 0x87C8, 0x87C9, 0x87CA,
+	0xB4B3, 0x87CB, 0x87CC, 0x87CD, 0x87CE, 0x87CF, 0x87D0, 0x87D1,
+	0xB4B4, 0x87D2, 0x87D3, 0x87D4, 0x87D5, 0x87D6, 0x87D7, 0x87D8,
+	0x87D9, 0x87DA, 0x87DB, 0x87DC, 0x87DD, 0x87DE, 0x87DF, 0x87E0,
+	0x87E1, 0x87E2, 0x87E3, 0x87E4, 0x87E5, 0x87E6, 0x87E7, 0x87E8,
+	0x87E9, 0x87EA, 0x87EB, 0x87EC, 0xB4B5, 0x87ED, 0x87EE, 0x87EF,
+	0xB4B6, 0x87F0, 0x87F1, 0x87F2, 0xB4B7, 0x87F3, 0x87F4, 0x87F5,
+	0x87F6, 0x87F7, 0x87F8, 0x87F9, 0xB4B8, 0xB4B9, 0x87FA, 0x87FB,
+	0x87FC, 0x87FD, 0x87FE, 0x8841, 0x8842, 0x8843, 0x8844, 0x8845,
+	0xB4BA, 0xB4BB, 0x8846, 0x8847, 0x8848, 0x8849, 0x884A, 0x884B,
+	0xB4BC, 0x884C, 0x884D, 0x884E, 0x884F, 0x8850, 0x8851, 0x8852,
+	0xB4BD, 0xB4BE, 0x8853, 0x8854, 0x8855, 0xB4BF, 0x8856, 0x8857,
+	0x8858, 0x8859, 0x885A, 0x8861, 0xB4C0, 0xB4C1, 0x8862, 0x8863,
+	0xB4C2, 0x8864, 0x8865, 0x8866, 0xB4C3, 0xB4C4, 0xB4C5, 0x8867,
+	0x8868, 0x8869, 0x886A, 0x886B, 0xB4C6, 0xB4C7, 0x886C, 0xB4C8,
+	0x886D, 0xB4C9, 0xB4CA, 0x886E, 0x886F, 0x8870, 0xB4CB, 0x8871,
+	0xB4CC, 0x8872, 0x8873, 0x8874, 0xB4CD, 0x8875, 0x8876, 0x8877,
+	0xB4CE, 0x8878, 0x8879, 0x887A, 0x8881, 0x8882, 0x8883, 0x8884,
+	0x8885, 0x8886, 0x8887, 0x8888, 0x8889, 0x888A, 0x888B, 0x888C,
+	0x888D, 0x888E, 0x888F, 0x8890, 0xB4CF, 0xB4D0, 0x8891, 0x8892,
+	0xB4D1, 0x8893, 0x8894, 0x8895, 0xB4D2, 0x8896, 0xB4D3, 0x8897,
+	0x8898, 0x8899, 0x889A, 0x889B, 0xB4D4, 0xB4D5, 0x889C, 0xB4D6,
+	0x889D, 0xB4D7, 0x889E, 0x889F, 0x88A0, 0x88A1, 0xB4D8, 0x88A2,
+	0xB4D9, 0xB4DA, 0xB4DB, 0x88A3, 0xB4DC, 0x88A4, 0x88A5, 0xB4DD,
+	0xB4DE, 0xB4DF, 0xB4E0, 0xB4E1, 0x88A6, 0x88A7, 0x88A8, 0xB4E2,
+	0xB4E3, 0xB4E4, 0x88A9, 0xB4E5, 0xB4E6, 0xB4E7, 0xB4E8, 0xB4E9,
+	0x88AA, 0x88AB, 0x88AC, 0xB4EA, 0xB4EB, 0xB4EC, 0x88AD, 0x88AE,
+	0xB4ED, 0x88AF, 0x88B0, 0x88B1, 0xB4EE, 0x88B2, 0x88B3, 0x88B4,
+	0x88B5, 0x88B6, 0x88B7, 0x88B8, 0xB4EF, 0xB4F0, 0x88B9, 0xB4F1,
+	0xB4F2, 0xB4F3, 0x88BA, 0x88BB, 0x88BC, 0x88BD, 0x88BE, 0x88BF,
+	0xB4F4, 0x88C0, 0x88C1, 0x88C2, 0x88C3, 0x88C4, 0x88C5, 0x88C6,
+	0x88C7, 0x88C8, 0x88C9, 0x88CA, 0x88CB, 0x88CC, 0x88CD, 0x88CE,
+	0x88CF, 0x88D0, 0x88D1, 0x88D2, 0x88D3, 0x88D4, 0x88D5, 0x88D6,
+	0x88D7, 0x88D8, 0x88D9, 0x88DA, 0x88DB, 0x88DC, 0x88DD, 0x88DE,
+	0x88DF, 0x88E0, 0x88E1, 0x88E2, 0x88E3, 0x88E4, 0x88E5, 0x88E6,
+	0x88E7, 0x88E8, 0x88E9, 0x88EA, 0x88EB, 0x88EC, 0x88ED, 0x88EE,
+	0x88EF, 0x88F0, 0x88F1, 0x88F2, 0x88F3, 0x88F4, 0x88F5, 0x88F6,
+	0xB4F5, 0xB4F6, 0xB4F7, 0x88F7, 0xB4F8, 0x88F8, 0x88F9, 0xB4F9,
+	0xB4FA, 0x88FA, 0xB4FB, 0xB4FC, 0x88FB, 0x88FC, 0x88FD, 0x88FE,
+	0xB4FD, 0xB4FE, 0x8941, 0xB5A1, 0x8942, 0xB5A2, 0x8943, 0xB5A3,
+	0x8944, 0x8945, 0xB5A4, 0x8946, 0xB5A5, 0xB5A6, 0x8947, 0x8948,
+	0xB5A7, 0x8949, 0x894A, 0x894B, 0xB5A8, 0x894C, 0x894D, 0x894E,
+	0x894F, 0x8950, 0x8951, 0x8952, 0xB5A9, 0xB5AA, 0x8953, 0xB5AB,
+	0xB5AC, 0xB5AD, 0x8954, 0x8955, 0x8956, 0x8957, 0x8958, 0x8959,
+	0xB5AE, 0x895A, 0x8961, 0x8962, 0xB5AF, 0x8963, 0x8964, 0x8965,
+	0xB5B0, 0x8966, 0x8967, 0x8968, 0x8969, 0x896A, 0x896B, 0x896C,
+	0x896D, 0x896E, 0x896F, 0x8970, 0xB5B1, 0xB5B2, 0x8971, 0x8972,
+	0x8973, 0x8974, 0x8975, 0x8976, 0xB5B3, 0x8977, 0x8978, 0x8979,
+	0xB5B4, 0x897A, 0x8981, 0x8982, 0x8983, 0x8984, 0x8985, 0x8986,
+	0x8987, 0x8988, 0x8989, 0x898A, 0x898B, 0x898C, 0x898D, 0x898E,
+	0x898F, 0x8990, 0x8991, 0x8992, 0x8993, 0x8994, 0x8995, 0x8996,
+	0xB5B5, 0xB5B6, 0x8997, 0x8998, 0xB5B7, 0x8999, 0x899A, 0xB5B8,
+	0xB5B9, 0x899B, 0xB5BA, 0x899C, 0xB5BB, 0x899D, 0x899E, 0x899F,
+	0xB5BC, 0xB5BD, 0x89A0, 0xB5BE, 0x89A1, 0xB5BF, 0x89A2, 0xB5C0,
+	0x89A3, 0xB5C1, 0x89A4, 0x89A5, 0xB5C2, 0x89A6, 0x89A7, 0x89A8,
+	0xB5C3, 0x89A9, 0x89AA, 0x89AB, 0xB5C4, 0x89AC, 0x89AD, 0x89AE,
+	0x89AF, 0x89B0, 0x89B1, 0x89B2, 0x89B3, 0x89B4, 0x89B5, 0x89B6,
+	0x89B7, 0x89B8, 0x89B9, 0x89BA, 0x89BB, 0x89BC, 0x89BD, 0x89BE,
+	0xB5C5, 0x89BF, 0x89C0, 0x89C1, 0x89C2, 0x89C3, 0x89C4, 0x89C5,
+	0x89C6, 0x89C7, 0x89C8, 0x89C9, 0x89CA, 0x89CB, 0x89CC, 0x89CD,
+	0x89CE, 0x89CF, 0x89D0, 0x89D1, 0xB5C6, 0x89D2, 0x89D3, 0x89D4,
+	0x89D5, 0x89D6, 0x89D7, 0x89D8, 0xB5C7, 0x89D9, 0x89DA, 0x89DB,
+	0xB5C8, 0x89DC, 0x89DD, 0x89DE, 0xB5C9, 0x89DF, 0x89E0, 0x89E1,
+	0x89E2, 0x89E3, 0x89E4, 0x89E5, 0xB5CA, 0xB5CB, 0x89E6, 0xB5CC,
+	0x89E7, 0x89E8, 0x89E9, 0x89EA, 0x89EB, 0x89EC, 0x89ED, 0x89EE,
+	0xB5CD, 0x89EF, 0x89F0, 0x89F1, 0x89F2, 0x89F3, 0x89F4, 0x89F5,
+	0x89F6, 0x89F7, 0x89F8, 0x89F9, 0x89FA, 0x89FB, 0x89FC, 0x89FD,
+	0x89FE, 0x8A41, 0x8A42, 0x8A43, 0x8A44, 0x8A45, 0x8A46, 0x8A47,
+	0x8A48, 0x8A49, 0x8A4A, 0x8A4B, 0xB5CE, 0xB5CF, 0x8A4C, 0x8A4D,
+	0xB5D0, 0x8A4E, 0x8A4F, 0x8A50, 0xB5D1, 0x8A51, 0x8A52, 0x8A53,
+	0x8A54, 0x8A55, 0x8A56, 0x8A57, 0xB5D2, 0xB5D3, 0x8A58, 0xB5D4,
+	0x8A59, 0xB5D5, 0x8A5A, 0x8A61, 0x8A62, 0x8A63, 0x8A64, 0x8A65,
+	0xB5D6, 0x8A66, 0x8A67, 0x8A68, 0x8A69, 0x8A6A, 0x8A6B, 0x8A6C,
+	0x8A6D, 0x8A6E, 0x8A6F, 0x8A70, 0x8A71, 0x8A72, 0x8A73, 0x8A74,
+	0x8A75, 0x8A76, 0x8A77, 0x8A78, 0xB5D7, 0x8A79, 0x8A7A, 0x8A81,
+	0x8A82, 0x8A83, 0x8A84, 0x8A85, 0xB5D8, 0x8A86, 0x8A87, 0x8A88,
+	0x8A89, 0x8A8A, 0x8A8B, 0x8A8C, 0x8A8D, 0x8A8E, 0x8A8F, 0x8A90,
+	0x8A91, 0x8A92, 0x8A93, 0x8A94, 0x8A95, 0x8A96, 0x8A97, 0x8A98,
+	0x8A99, 0xB5D9, 0x8A9A, 0x8A9B, 0x8A9C, 0x8A9D, 0x8A9E, 0x8A9F,
+	0xB5DA, 0x8AA0, 0x8AA1, 0x8AA2, 0xB5DB, 0x8AA3, 0x8AA4, 0x8AA5,
+	0xB5DC, 0x8AA6, 0x8AA7, 0x8AA8, 0x8AA9, 0x8AAA, 0x8AAB, 0x8AAC,
+	0x8AAD, 0xB5DD, 0x8AAE, 0xB5DE, 0x8AAF, 0xB5DF, 0x8AB0, 0x8AB1,
+	0x8AB2, 0x8AB3, 0x8AB4, 0x8AB5, 0xB5E0, 0x8AB6, 0x8AB7, 0x8AB8,
+	0xB5E1, 0x8AB9, 0x8ABA, 0x8ABB, 0xB5E2, 0x8ABC, 0x8ABD, 0x8ABE,
+	0x8ABF, 0x8AC0, 0x8AC1, 0x8AC2, 0xB5E3, 0x8AC3, 0x8AC4, 0x8AC5,
+	0x8AC6, 0xB5E4, 0x8AC7, 0x8AC8, 0x8AC9, 0x8ACA, 0x8ACB, 0x8ACC,
+	0xB5E5, 0xB5E6, 0x8ACD, 0x8ACE, 0xB5E7, 0x8ACF, 0x8AD0, 0xB5E8,
+	0xB5E9, 0x8AD1, 0xB5EA, 0x8AD2, 0x8AD3, 0x8AD4, 0x8AD5, 0x8AD6,
+	0xB5EB, 0xB5EC, 0x8AD7, 0xB5ED, 0x8AD8, 0xB5EE, 0x8AD9, 0x8ADA,
+	0x8ADB, 0x8ADC, 0x8ADD, 0x8ADE, 0xB5EF, 0x8ADF, 0x8AE0, 0x8AE1,
+	0x8AE2, 0x8AE3, 0x8AE4, 0x8AE5, 0x8AE6, 0x8AE7, 0x8AE8, 0x8AE9,
+	0x8AEA, 0x8AEB, 0x8AEC, 0x8AED, 0x8AEE, 0x8AEF, 0x8AF0, 0x8AF1,
+	0x8AF2, 0x8AF3, 0x8AF4, 0x8AF5, 0x8AF6, 0x8AF7, 0x8AF8, 0x8AF9,
+	0xB5F0, 0xB5F1, 0x8AFA, 0x8AFB, 0xB5F2, 0x8AFC, 0x8AFD, 0xB5F3,
+	0xB5F4, 0x8AFE, 0x8B41, 0x8B42, 0x8B43, 0x8B44, 0x8B45, 0x8B46,
+	0xB5F5, 0xB5F6, 0x8B47, 0xB5F7, 0xB5F8, 0xB5F9, 0xB5FA, 0x8B48,
+	0x8B49, 0x8B4A, 0x8B4B, 0x8B4C, 0xB5FB, 0xB5FC, 0x8B4D, 0x8B4E,
+	0xB5FD, 0x8B4F, 0x8B50, 0x8B51, 0xB5FE, 0x8B52, 0x8B53, 0x8B54,
+	0x8B55, 0x8B56, 0x8B57, 0x8B58, 0xB6A1, 0xB6A2, 0x8B59, 0xB6A3,
+	0xB6A4, 0xB6A5, 0x8B5A, 0x8B61, 0x8B62, 0x8B63, 0x8B64, 0xB6A6,
+	0xB6A7, 0xB6A8, 0x8B65, 0x8B66, 0xB6A9, 0x8B67, 0x8B68, 0x8B69,
+	0xB6AA, 0x8B6A, 0x8B6B, 0x8B6C, 0x8B6D, 0x8B6E, 0x8B6F, 0x8B70,
+	0xB6AB, 0xB6AC, 0x8B71, 0xB6AD, 0xB6AE, 0xB6AF, 0x8B72, 0x8B73,
+	0x8B74, 0x8B75, 0x8B76, 0x8B77, 0x8B78, 0x8B79, 0x8B7A, 0x8B81,
+	0x8B82, 0x8B83, 0x8B84, 0x8B85, 0x8B86, 0x8B87, 0x8B88, 0x8B89,
+	0x8B8A, 0x8B8B, 0x8B8C, 0x8B8D, 0x8B8E, 0x8B8F, 0x8B90, 0x8B91,
+	0x8B92, 0x8B93, 0x8B94, 0x8B95, 0x8B96, 0x8B97, 0x8B98, 0x8B99,
+	0x8B9A, 0x8B9B, 0x8B9C, 0x8B9D, 0x8B9E, 0x8B9F, 0x8BA0, 0x8BA1,
+	0x8BA2, 0x8BA3, 0x8BA4, 0x8BA5, 0x8BA6, 0x8BA7, 0x8BA8, 0x8BA9,
+	0x8BAA, 0x8BAB, 0x8BAC, 0x8BAD, 0x8BAE, 0x8BAF, 0x8BB0, 0x8BB1,
+	0x8BB2, 0x8BB3, 0x8BB4, 0x8BB5, 0xB6B0, 0xB6B1, 0x8BB6, 0x8BB7,
+	0xB6B2, 0x8BB8, 0x8BB9, 0x8BBA, 0xB6B3, 0x8BBB, 0xB6B4, 0xB6B5,
+	0x8BBC, 0x8BBD, 0x8BBE, 0x8BBF, 0xB6B6, 0xB6B7, 0x8BC0, 0xB6B8,
+	0xB6B9, 0xB6BA, 0x8BC1, 0x8BC2, 0x8BC3, 0x8BC4, 0x8BC5, 0xB6BB,
+	0xB6BC, 0xB6BD, 0x8BC6, 0x8BC7, 0xB6BE, 0x8BC8, 0x8BC9, 0x8BCA,
+	0xB6BF, 0x8BCB, 0x8BCC, 0x8BCD, 0x8BCE, 0x8BCF, 0x8BD0, 0x8BD1,
+	0xB6C0, 0xB6C1, 0x8BD2, 0xB6C2, 0xB6C3, 0xB6C4, 0x8BD3, 0x8BD4,
+	0x8BD5, 0x8BD6, 0x8BD7, 0x8BD8, 0xB6C5, 0x8BD9, 0x8BDA, 0x8BDB,
+	0x8BDC, 0x8BDD, 0x8BDE, 0x8BDF, 0x8BE0, 0x8BE1, 0x8BE2, 0x8BE3,
+	0x8BE4, 0x8BE5, 0x8BE6, 0x8BE7, 0x8BE8, 0x8BE9, 0x8BEA, 0x8BEB,
+	0xB6C6, 0x8BEC, 0x8BED, 0x8BEE, 0x8BEF, 0x8BF0, 0x8BF1, 0x8BF2,
+	0x8BF3, 0x8BF4, 0x8BF5, 0x8BF6, 0x8BF7, 0x8BF8, 0x8BF9, 0x8BFA,
+	0x8BFB, 0x8BFC, 0x8BFD, 0x8BFE, 0x8C41, 0x8C42, 0x8C43, 0x8C44,
+	0x8C45, 0x8C46, 0x8C47, 0x8C48, 0x8C49, 0x8C4A, 0x8C4B, 0x8C4C,
+	0x8C4D, 0x8C4E, 0x8C4F, 0x8C50, 0xB6C7, 0xB6C8, 0x8C51, 0x8C52,
+	0xB6C9, 0x8C53, 0x8C54, 0x8C55, 0xB6CA, 0x8C56, 0x8C57, 0x8C58,
+	0x8C59, 0x8C5A, 0x8C61, 0x8C62, 0x8C63, 0x8C64, 0x8C65, 0x8C66,
+	0x8C67, 0xB6CB, 0x8C68, 0x8C69, 0x8C6A, 0x8C6B, 0x8C6C, 0x8C6D,
+	0xB6CC, 0x8C6E, 0x8C6F, 0x8C70, 0x8C71, 0x8C72, 0x8C73, 0x8C74,
+	0xB6CD, 0x8C75, 0x8C76, 0x8C77, 0x8C78, 0x8C79, 0x8C7A, 0x8C81,
+	0x8C82, 0x8C83, 0x8C84, 0x8C85, 0x8C86, 0x8C87, 0x8C88, 0x8C89,
+	0x8C8A, 0x8C8B, 0x8C8C, 0x8C8D, 0xB6CE, 0x8C8E, 0x8C8F, 0x8C90,
+	0x8C91, 0x8C92, 0x8C93, 0x8C94, 0x8C95, 0x8C96, 0x8C97, 0x8C98,
+	0x8C99, 0x8C9A, 0x8C9B, 0x8C9C, 0x8C9D, 0x8C9E, 0x8C9F, 0x8CA0,
+	0x8CA1, 0x8CA2, 0x8CA3, 0x8CA4, 0x8CA5, 0x8CA6, 0x8CA7, 0x8CA8,
+	0xB6CF, 0x8CA9, 0x8CAA, 0x8CAB, 0xB6D0, 0x8CAC, 0x8CAD, 0x8CAE,
+	0x8CAF, 0x8CB0, 0x8CB1, 0x8CB2, 0x8CB3, 0x8CB4, 0x8CB5, 0x8CB6,
+	0x8CB7, 0x8CB8, 0x8CB9, 0x8CBA, 0x8CBB, 0x8CBC, 0x8CBD, 0x8CBE,
+	0x8CBF, 0x8CC0, 0x8CC1, 0x8CC2, 0x8CC3, 0x8CC4, 0x8CC5, 0x8CC6,
+	0x8CC7, 0x8CC8, 0x8CC9, 0x8CCA, 0x8CCB, 0x8CCC, 0x8CCD, 0x8CCE,
+	0x8CCF, 0x8CD0, 0x8CD1, 0x8CD2, 0x8CD3, 0x8CD4, 0x8CD5, 0x8CD6,
+	0x8CD7, 0x8CD8, 0x8CD9, 0x8CDA, 0x8CDB, 0x8CDC, 0x8CDD, 0x8CDE,
+	0xB6D1, 0xB6D2, 0x8CDF, 0x8CE0, 0xB6D3, 0x8CE1, 0x8CE2, 0x8CE3,
+	0xB6D4, 0x8CE4, 0x8CE5, 0x8CE6, 0x8CE7, 0x8CE8, 0x8CE9, 0xB6D5,
+	0xB6D6, 0x8CEA, 0x8CEB, 0x8CEC, 0x8CED, 0xB6D7, 0x8CEE, 0x8CEF,
+	0x8CF0, 0x8CF1, 0x8CF2, 0x8CF3, 0x8CF4, 0x8CF5, 0x8CF6, 0x8CF7,
+	0x8CF8, 0x8CF9, 0x8CFA, 0x8CFB, 0x8CFC, 0x8CFD, 0x8CFE, 0x8D41,
+	0x8D42, 0x8D43, 0x8D44, 0x8D45, 0x8D46, 0x8D47, 0x8D48, 0x8D49,
+	0x8D4A, 0x8D4B, 0x8D4C, 0x8D4D, 0x8D4E, 0x8D4F, 0x8D50, 0x8D51,
+	0xB6D8, 0x8D52, 0x8D53, 0x8D54, 0x8D55, 0x8D56, 0x8D57, 0x8D58,
+	0x8D59, 0x8D5A, 0x8D61, 0x8D62, 0x8D63, 0x8D64, 0x8D65, 0x8D66,
+	0x8D67, 0x8D68, 0x8D69, 0x8D6A, 0x8D6B, 0x8D6C, 0x8D6D, 0x8D6E,
+	0x8D6F, 0x8D70, 0x8D71, 0x8D72, 0xB6D9, 0x8D73, 0x8D74, 0x8D75,
+	0xB6DA, 0x8D76, 0x8D77, 0x8D78, 0xB6DB, 0x8D79, 0x8D7A, 0x8D81,
+	0x8D82, 0x8D83, 0x8D84, 0x8D85, 0xB6DC, 0xB6DD, 0x8D86, 0x8D87,
+	0x8D88, 0xB6DE, 0x8D89, 0x8D8A, 0x8D8B, 0x8D8C, 0x8D8D, 0x8D8E,
+	0x8D8F, 0x8D90, 0x8D91, 0x8D92, 0x8D93, 0x8D94, 0x8D95, 0x8D96,
+	0x8D97, 0x8D98, 0x8D99, 0x8D9A, 0x8D9B, 0x8D9C, 0x8D9D, 0x8D9E,
+	0x8D9F, 0x8DA0, 0x8DA1, 0x8DA2, 0x8DA3, 0x8DA4, 0x8DA5, 0x8DA6,
+	0x8DA7, 0x8DA8, 0x8DA9, 0x8DAA, 0xB6DF, 0xB6E0, 0x8DAB, 0x8DAC,
+	0xB6E1, 0x8DAD, 0x8DAE, 0xB6E2, 0xB6E3, 0x8DAF, 0x8DB0, 0x8DB1,
+	0x8DB2, 0x8DB3, 0x8DB4, 0x8DB5, 0xB6E4, 0xB6E5, 0x8DB6, 0xB6E6,
+	0x8DB7, 0x8DB8, 0x8DB9, 0x8DBA, 0x8DBB, 0x8DBC, 0x8DBD, 0x8DBE,
+	0xB6E7, 0x8DBF, 0x8DC0, 0x8DC1, 0xB6E8, 0x8DC2, 0x8DC3, 0x8DC4,
+	0xB6E9, 0x8DC5, 0x8DC6, 0x8DC7, 0x8DC8, 0x8DC9, 0x8DCA, 0x8DCB,
+	0xB6EA, 0xB6EB, 0x8DCC, 0x8DCD, 0x8DCE, 0x8DCF, 0x8DD0, 0x8DD1,
+	0x8DD2, 0x8DD3, 0x8DD4, 0x8DD5, 0xB6EC, 0x8DD6, 0x8DD7, 0x8DD8,
+	0xB6ED, 0x8DD9, 0x8DDA, 0x8DDB, 0xB6EE, 0x8DDC, 0x8DDD, 0x8DDE,
+	0x8DDF, 0x8DE0, 0x8DE1, 0x8DE2, 0xB6EF, 0xB6F0, 0x8DE3, 0xB6F1,
+	0x8DE4, 0xB6F2, 0x8DE5, 0x8DE6, 0x8DE7, 0x8DE8, 0x8DE9, 0x8DEA,
+	0xB6F3, 0xB6F4, 0x8DEB, 0x8DEC, 0xB6F5, 0x8DED, 0x8DEE, 0x8DEF,
+	0xB6F6, 0x8DF0, 0x8DF1, 0x8DF2, 0x8DF3, 0x8DF4, 0x8DF5, 0x8DF6,
+	0xB6F7, 0xB6F8, 0x8DF7, 0xB6F9, 0xB6FA, 0xB6FB, 0xB6FC, 0x8DF8,
+	0x8DF9, 0x8DFA, 0xB6FD, 0xB6FE, 0xB7A1, 0xB7A2, 0x8DFB, 0x8DFC,
+	0xB7A3, 0x8DFD, 0x8DFE, 0x8E41, 0xB7A4, 0x8E42, 0x8E43, 0x8E44,
+	0x8E45, 0x8E46, 0x8E47, 0x8E48, 0xB7A5, 0xB7A6, 0x8E49, 0xB7A7,
+	0xB7A8, 0xB7A9, 0x8E4A, 0x8E4B, 0x8E4C, 0x8E4D, 0x8E4E, 0x8E4F,
+	0xB7AA, 0xB7AB, 0x8E50, 0x8E51, 0xB7AC, 0x8E52, 0x8E53, 0x8E54,
+	0x8E55, 0x8E56, 0x8E57, 0x8E58, 0x8E59, 0x8E5A, 0x8E61, 0x8E62,
+	0x8E63, 0x8E64, 0x8E65, 0xB7AD, 0x8E66, 0xB7AE, 0x8E67, 0x8E68,
+	0x8E69, 0x8E6A, 0x8E6B, 0x8E6C, 0x8E6D, 0x8E6E, 0x8E6F, 0x8E70,
+	0x8E71, 0x8E72, 0x8E73, 0x8E74, 0x8E75, 0x8E76, 0x8E77, 0x8E78,
+	0x8E79, 0x8E7A, 0x8E81, 0x8E82, 0x8E83, 0x8E84, 0x8E85, 0x8E86,
+	0x8E87, 0x8E88, 0x8E89, 0x8E8A, 0x8E8B, 0x8E8C, 0x8E8D, 0x8E8E,
+	0xB7AF, 0xB7B0, 0x8E8F, 0x8E90, 0xB7B1, 0x8E91, 0x8E92, 0x8E93,
+	0xB7B2, 0x8E94, 0x8E95, 0x8E96, 0x8E97, 0x8E98, 0x8E99, 0x8E9A,
+	0xB7B3, 0xB7B4, 0x8E9B, 0xB7B5, 0xB7B6, 0xB7B7, 0x8E9C, 0x8E9D,
+	0x8E9E, 0x8E9F, 0x8EA0, 0xB7B8, 0xB7B9, 0xB7BA, 0x8EA1, 0x8EA2,
+	0xB7BB, 0x8EA3, 0x8EA4, 0x8EA5, 0xB7BC, 0x8EA6, 0x8EA7, 0x8EA8,
+	0x8EA9, 0x8EAA, 0x8EAB, 0x8EAC, 0xB7BD, 0xB7BE, 0x8EAD, 0xB7BF,
+	0x8EAE, 0xB7C0, 0x8EAF, 0x8EB0, 0x8EB1, 0x8EB2, 0x8EB3, 0x8EB4,
+	0xB7C1, 0xB7C2, 0x8EB5, 0x8EB6, 0xB7C3, 0x8EB7, 0x8EB8, 0x8EB9,
+	0xB7C4, 0x8EBA, 0x8EBB, 0x8EBC, 0x8EBD, 0x8EBE, 0x8EBF, 0x8EC0,
+	0xB7C5, 0xB7C6, 0x8EC1, 0xB7C7, 0xB7C8, 0xB7C9, 0x8EC2, 0x8EC3,
+	0x8EC4, 0x8EC5, 0x8EC6, 0x8EC7, 0xB7CA, 0x8EC8, 0x8EC9, 0x8ECA,
+	0xB7CB, 0x8ECB, 0x8ECC, 0x8ECD, 0x8ECE, 0x8ECF, 0x8ED0, 0x8ED1,
+	0x8ED2, 0x8ED3, 0x8ED4, 0x8ED5, 0x8ED6, 0xB7CC, 0x8ED7, 0xB7CD,
+	0x8ED8, 0x8ED9, 0x8EDA, 0x8EDB, 0x8EDC, 0x8EDD, 0x8EDE, 0x8EDF,
+	0xB7CE, 0xB7CF, 0x8EE0, 0x8EE1, 0xB7D0, 0x8EE2, 0x8EE3, 0x8EE4,
+	0xB7D1, 0x8EE5, 0x8EE6, 0x8EE7, 0x8EE8, 0x8EE9, 0x8EEA, 0x8EEB,
+	0xB7D2, 0xB7D3, 0x8EEC, 0xB7D4, 0x8EED, 0xB7D5, 0x8EEE, 0x8EEF,
+	0x8EF0, 0x8EF1, 0x8EF2, 0x8EF3, 0xB7D6, 0x8EF4, 0x8EF5, 0x8EF6,
+	0xB7D7, 0x8EF7, 0x8EF8, 0x8EF9, 0x8EFA, 0x8EFB, 0x8EFC, 0x8EFD,
+	0x8EFE, 0x8F41, 0x8F42, 0x8F43, 0x8F44, 0x8F45, 0x8F46, 0x8F47,
+	0x8F48, 0xB7D8, 0x8F49, 0x8F4A, 0x8F4B, 0x8F4C, 0x8F4D, 0x8F4E,
+	0x8F4F, 0x8F50, 0x8F51, 0x8F52, 0x8F53, 0x8F54, 0x8F55, 0x8F56,
+	0x8F57, 0x8F58, 0x8F59, 0x8F5A, 0x8F61, 0x8F62, 0x8F63, 0x8F64,
+	0x8F65, 0x8F66, 0x8F67, 0x8F68, 0xB7D9, 0x8F69, 0x8F6A, 0x8F6B,
+	0x8F6C, 0x8F6D, 0x8F6E, 0x8F6F, 0xB7DA, 0x8F70, 0x8F71, 0x8F72,
+	0xB7DB, 0x8F73, 0x8F74, 0x8F75, 0xB7DC, 0x8F76, 0x8F77, 0x8F78,
+	0x8F79, 0x8F7A, 0x8F81, 0x8F82, 0xB7DD, 0xB7DE, 0x8F83, 0xB7DF,
+	0x8F84, 0xB7E0, 0x8F85, 0x8F86, 0x8F87, 0x8F88, 0x8F89, 0x8F8A,
+	0xB7E1, 0x8F8B, 0x8F8C, 0x8F8D, 0xB7E2, 0x8F8E, 0x8F8F, 0x8F90,
+	0xB7E3, 0x8F91, 0x8F92, 0x8F93, 0x8F94, 0x8F95, 0x8F96, 0x8F97,
+	0x8F98, 0xB7E4, 0x8F99, 0xB7E5, 0x8F9A, 0xB7E6, 0x8F9B, 0x8F9C,
+	0x8F9D, 0x8F9E, 0x8F9F, 0x8FA0, 0xB7E7, 0xB7E8, 0x8FA1, 0x8FA2,
+	0xB7E9, 0x8FA3, 0x8FA4, 0x8FA5, 0xB7EA, 0x8FA6, 0x8FA7, 0x8FA8,
+	0x8FA9, 0x8FAA, 0x8FAB, 0x8FAC, 0xB7EB, 0xB7EC, 0x8FAD, 0xB7ED,
+	0x8FAE, 0xB7EE, 0x8FAF, 0x8FB0, 0x8FB1, 0x8FB2, 0x8FB3, 0x8FB4,
+	0xB7EF, 0x8FB5, 0x8FB6, 0x8FB7, 0x8FB8, 0x8FB9, 0x8FBA, 0x8FBB,
+	0x8FBC, 0x8FBD, 0x8FBE, 0x8FBF, 0x8FC0, 0x8FC1, 0x8FC2, 0x8FC3,
+	0x8FC4, 0x8FC5, 0x8FC6, 0x8FC7, 0xB7F0, 0x8FC8, 0x8FC9, 0x8FCA,
+	0x8FCB, 0x8FCC, 0x8FCD, 0x8FCE, 0xB7F1, 0x8FCF, 0x8FD0, 0x8FD1,
+	0x8FD2, 0x8FD3, 0x8FD4, 0x8FD5, 0x8FD6, 0x8FD7, 0x8FD8, 0x8FD9,
+	0x8FDA, 0x8FDB, 0x8FDC, 0x8FDD, 0x8FDE, 0x8FDF, 0x8FE0, 0x8FE1,
+	0x8FE2, 0x8FE3, 0x8FE4, 0x8FE5, 0x8FE6, 0x8FE7, 0x8FE8, 0x8FE9,
+	0xB7F2, 0xB7F3, 0x8FEA, 0x8FEB, 0xB7F4, 0x8FEC, 0x8FED, 0x8FEE,
+	0xB7F5, 0x8FEF, 0x8FF0, 0x8FF1, 0x8FF2, 0x8FF3, 0x8FF4, 0x8FF5,
+	0xB7F6, 0x8FF6, 0x8FF7, 0xB7F7, 0x8FF8, 0xB7F8, 0x8FF9, 0x8FFA,
+	0x8FFB, 0x8FFC, 0x8FFD, 0x8FFE, 0xB7F9, 0xB7FA, 0x9041, 0x9042,
+	0xB7FB, 0x9043, 0x9044, 0x9045, 0xB7FC, 0x9046, 0x9047, 0x9048,
+	0x9049, 0x904A, 0x904B, 0x904C, 0xB7FD, 0xB7FE, 0x904D, 0xB8A1,
+	0x904E, 0xB8A2, 0x904F, 0x9050, 0x9051, 0x9052, 0x9053, 0x9054,
+	0xB8A3, 0xB8A4, 0x9055, 0x9056, 0xB8A5, 0x9057, 0x9058, 0x9059,
+	0xB8A6, 0x905A, 0x9061, 0x9062, 0x9063, 0x9064, 0x9065, 0x9066,
+	0xB8A7, 0xB8A8, 0x9067, 0xB8A9, 0x9068, 0xB8AA, 0xB8AB, 0x9069,
+	0x906A, 0xB8AC, 0xB8AD, 0x906B, 0x906C, 0x906D, 0x906E, 0x906F,
+	0x9070, 0x9071, 0x9072, 0x9073, 0x9074, 0x9075, 0x9076, 0x9077,
+	0x9078, 0x9079, 0x907A, 0x9081, 0x9082, 0x9083, 0x9084, 0x9085,
+	0x9086, 0x9087, 0x9088, 0x9089, 0x908A, 0x908B, 0x908C, 0x908D,
+	0xB8AE, 0xB8AF, 0x908E, 0x908F, 0xB8B0, 0x9090, 0x9091, 0x9092,
+	0xB8B1, 0x9093, 0x9094, 0x9095, 0x9096, 0x9097, 0x9098, 0x9099,
+	0xB8B2, 0xB8B3, 0x909A, 0xB8B4, 0x909B, 0xB8B5, 0x909C, 0x909D,
+	0x909E, 0x909F, 0x90A0, 0x90A1, 0xB8B6, 0xB8B7, 0x90A2, 0x90A3,
+	0xB8B8, 0x90A4, 0xB8B9, 0xB8BA, 0xB8BB, 0xB8BC, 0xB8BD, 0x90A5,
+	0x90A6, 0x90A7, 0x90A8, 0x90A9, 0xB8BE, 0xB8BF, 0x90AA, 0xB8C0,
+	0x90AB, 0xB8C1, 0xB8C2, 0x90AC, 0x90AD, 0xB8C3, 0x90AE, 0xB8C4,
+	0xB8C5, 0xB8C6, 0x90AF, 0x90B0, 0xB8C7, 0x90B1, 0x90B2, 0x90B3,
+	0xB8C8, 0x90B4, 0x90B5, 0x90B6, 0x90B7, 0x90B8, 0x90B9, 0x90BA,
+	0xB8C9, 0xB8CA, 0x90BB, 0xB8CB, 0xB8CC, 0xB8CD, 0xB8CE, 0x90BC,
+	0x90BD, 0x90BE, 0x90BF, 0x90C0, 0xB8CF, 0xB8D0, 0x90C1, 0x90C2,
+	0x90C3, 0x90C4, 0x90C5, 0x90C6, 0xB8D1, 0x90C7, 0x90C8, 0x90C9,
+	0x90CA, 0x90CB, 0x90CC, 0x90CD, 0x90CE, 0x90CF, 0x90D0, 0x90D1,
+	0x90D2, 0xB8D2, 0x90D3, 0x90D4, 0x90D5, 0x90D6, 0x90D7, 0x90D8,
+	0x90D9, 0x90DA, 0x90DB, 0x90DC, 0x90DD, 0x90DE, 0x90DF, 0x90E0,
+	0x90E1, 0x90E2, 0x90E3, 0x90E4, 0x90E5, 0x90E6, 0x90E7, 0x90E8,
+	0x90E9, 0x90EA, 0x90EB, 0x90EC, 0x90ED, 0x90EE, 0x90EF, 0x90F0,
+	0x90F1, 0x90F2, 0x90F3, 0x90F4, 0xB8D3, 0xB8D4, 0x90F5, 0x90F6,
+	0xB8D5, 0x90F7, 0x90F8, 0x90F9, 0xB8D6, 0x90FA, 0xB8D7, 0x90FB,
+	0x90FC, 0x90FD, 0x90FE, 0x9141, 0xB8D8, 0xB8D9, 0x9142, 0xB8DA,
+	0x9143, 0xB8DB, 0xB8DC, 0x9144, 0x9145, 0x9146, 0x9147, 0xB8DD,
+	0xB8DE, 0xB8DF, 0x9148, 0x9149, 0xB8E0, 0x914A, 0x914B, 0x914C,
+	0xB8E1, 0x914D, 0x914E, 0x914F, 0x9150, 0x9151, 0x9152, 0x9153,
+	0xB8E2, 0xB8E3, 0x9154, 0xB8E4, 0xB8E5, 0xB8E6, 0x9155, 0x9156,
+	0x9157, 0x9158, 0x9159, 0x915A, 0xB8E7, 0xB8E8, 0x9161, 0x9162,
+	0xB8E9, 0x9163, 0x9164, 0x9165, 0xB8EA, 0x9166, 0x9167, 0x9168,
+	0x9169, 0x916A, 0x916B, 0x916C, 0x916D, 0x916E, 0x916F, 0xB8EB,
+	0xB8EC, 0xB8ED, 0x9170, 0xB8EE, 0x9171, 0x9172, 0x9173, 0x9174,
+	0xB8EF, 0x9175, 0x9176, 0x9177, 0x9178, 0x9179, 0x917A, 0x9181,
+	0x9182, 0x9183, 0x9184, 0x9185, 0x9186, 0x9187, 0x9188, 0x9189,
+	0x918A, 0x918B, 0x918C, 0x918D, 0x918E, 0x918F, 0x9190, 0x9191,
+	0x9192, 0x9193, 0x9194, 0x9195, 0xB8F0, 0xB8F1, 0x9196, 0xB8F2,
+	0xB8F3, 0x9197, 0x9198, 0x9199, 0xB8F4, 0x919A, 0xB8F5, 0x919B,
+	0x919C, 0x919D, 0x919E, 0x919F, 0xB8F6, 0xB8F7, 0x91A0, 0xB8F8,
+	0x91A1, 0xB8F9, 0x91A2, 0x91A3, 0x91A4, 0x91A5, 0x91A6, 0x91A7,
+	0xB8FA, 0x91A8, 0x91A9, 0x91AA, 0xB8FB, 0x91AB, 0x91AC, 0x91AD,
+	0x91AE, 0x91AF, 0x91B0, 0x91B1, 0x91B2, 0x91B3, 0x91B4, 0x91B5,
+	0x91B6, 0x91B7, 0x91B8, 0x91B9, 0xB8FC, 0xB8FD, 0x91BA, 0x91BB,
+	0x91BC, 0x91BD, 0x91BE, 0x91BF, 0x91C0, 0x91C1, 0x91C2, 0x91C3,
+	0x91C4, 0x91C5, 0x91C6, 0x91C7, 0x91C8, 0x91C9, 0x91CA, 0x91CB,
+	0x91CC, 0x91CD, 0x91CE, 0x91CF, 0x91D0, 0x91D1, 0x91D2, 0x91D3,
+	0x91D4, 0x91D5, 0x91D6, 0x91D7, 0x91D8, 0x91D9, 0x91DA, 0x91DB,
+	0xB8FE, 0x91DC, 0x91DD, 0x91DE, 0xB9A1, 0x91DF, 0x91E0, 0x91E1,
+	0xB9A2, 0x91E2, 0x91E3, 0x91E4, 0x91E5, 0x91E6, 0x91E7, 0x91E8,
+	0x91E9, 0xB9A3, 0x91EA, 0xB9A4, 0x91EB, 0xB9A5, 0x91EC, 0x91ED,
+	0x91EE, 0x91EF, 0x91F0, 0x91F1, 0xB9A6, 0x91F2, 0x91F3, 0x91F4,
+	0xB9A7, 0x91F5, 0x91F6, 0x91F7, 0xB9A8, 0x91F8, 0x91F9, 0x91FA,
+	0x91FB, 0x91FC, 0x91FD, 0x91FE, 0x9241, 0xB9A9, 0x9242, 0xB9AA,
+	0x9243, 0x9244, 0x9245, 0x9246, 0x9247, 0x9248, 0x9249, 0x924A,
+	0xB9AB, 0xB9AC, 0xB9AD, 0x924B, 0xB9AE, 0x924C, 0x924D, 0xB9AF,
+	0xB9B0, 0xB9B1, 0xB9B2, 0x924E, 0x924F, 0x9250, 0x9251, 0x9252,
+	0xB9B3, 0xB9B4, 0x9253, 0xB9B5, 0x9254, 0xB9B6, 0x9255, 0x9256,
+	0x9257, 0xB9B7, 0x9258, 0xB9B8, 0xB9B9, 0x9259, 0x925A, 0x9261,
+	0xB9BA, 0x9262, 0x9263, 0x9264, 0xB9BB, 0x9265, 0x9266, 0x9267,
+	0x9268, 0x9269, 0x926A, 0x926B, 0x926C, 0xB9BC, 0x926D, 0xB9BD,
+	0x926E, 0x926F, 0x9270, 0x9271, 0x9272, 0x9273, 0x9274, 0x9275,
+	0xB9BE, 0x9276, 0x9277, 0x9278, 0x9279, 0x927A, 0x9281, 0x9282,
+	0x9283, 0x9284, 0x9285, 0x9286, 0x9287, 0x9288, 0x9289, 0x928A,
+	0x928B, 0x928C, 0x928D, 0x928E, 0x928F, 0x9290, 0x9291, 0x9292,
+	0x9293, 0x9294, 0x9295, 0x9296, 0xB9BF, 0x9297, 0x9298, 0x9299,
+	0xB9C0, 0x929A, 0x929B, 0x929C, 0xB9C1, 0x929D, 0x929E, 0x929F,
+	0x92A0, 0x92A1, 0x92A2, 0x92A3, 0x92A4, 0x92A5, 0x92A6, 0x92A7,
+	0x92A8, 0x92A9, 0x92AA, 0x92AB, 0x92AC, 0x92AD, 0x92AE, 0x92AF,
+	0xB9C2, 0x92B0, 0x92B1, 0x92B2, 0xB9C3, 0x92B3, 0x92B4, 0x92B5,
+	0xB9C4, 0x92B6, 0x92B7, 0x92B8, 0x92B9, 0x92BA, 0x92BB, 0x92BC,
+	0xB9C5, 0x92BD, 0x92BE, 0xB9C6, 0x92BF, 0x92C0, 0x92C1, 0x92C2,
+	0x92C3, 0x92C4, 0x92C5, 0x92C6, 0xB9C7, 0x92C7, 0x92C8, 0x92C9,
+	0xB9C8, 0x92CA, 0x92CB, 0x92CC, 0xB9C9, 0x92CD, 0x92CE, 0x92CF,
+	0x92D0, 0x92D1, 0x92D2, 0x92D3, 0xB9CA, 0x92D4, 0x92D5, 0xB9CB,
+	0x92D6, 0x92D7, 0x92D8, 0x92D9, 0x92DA, 0x92DB, 0x92DC, 0x92DD,
+	0x92DE, 0x92DF, 0x92E0, 0x92E1, 0x92E2, 0x92E3, 0x92E4, 0x92E5,
+	0x92E6, 0x92E7, 0x92E8, 0x92E9, 0x92EA, 0x92EB, 0x92EC, 0x92ED,
+	0x92EE, 0x92EF, 0x92F0, 0x92F1, 0x92F2, 0x92F3, 0x92F4, 0x92F5,
+	0x92F6, 0x92F7, 0x92F8, 0x92F9, 0xB9CC, 0xB9CD, 0x92FA, 0x92FB,
+	0xB9CE, 0x92FC, 0x92FD, 0xB9CF, 0xB9D0, 0x92FE, 0xB9D1, 0x9341,
+	0x9342, 0x9343, 0x9344, 0x9345, 0xB9D2, 0xB9D3, 0x9346, 0xB9D4,
+	0xB9D5, 0xB9D6, 0x9347, 0xB9D7, 0x9348, 0xB9D8, 0x9349, 0x934A,
+	0xB9D9, 0xB9DA, 0xB9DB, 0xB9DC, 0xB9DD, 0x934B, 0x934C, 0xB9DE,
+	0xB9DF, 0xB9E0, 0xB9E1, 0xB9E2, 0x934D, 0x934E, 0x934F, 0x9350,
+	0xB9E3, 0xB9E4, 0x9351, 0xB9E5, 0x9352, 0xB9E6, 0x9353, 0x9354,
+	0x9355, 0xB9E7, 0x9356, 0x9357, 0xB9E8, 0xB9E9, 0x9358, 0x9359,
+	0xB9EA, 0x935A, 0x9361, 0x9362, 0xB9EB, 0x9363, 0x9364, 0x9365,
+	0x9366, 0x9367, 0x9368, 0x9369, 0xB9EC, 0xB9ED, 0x936A, 0xB9EE,
+	0xB9EF, 0xB9F0, 0x936B, 0x936C, 0x936D, 0xB9F1, 0x936E, 0x936F,
+	0xB9F2, 0xB9F3, 0x9370, 0x9371, 0xB9F4, 0x9372, 0x9373, 0x9374,
+	0x9375, 0x9376, 0x9377, 0x9378, 0x9379, 0x937A, 0x9381, 0x9382,
+	0x9383, 0xB9F5, 0x9384, 0x9385, 0x9386, 0x9387, 0x9388, 0x9389,
+	0x938A, 0x938B, 0x938C, 0x938D, 0x938E, 0x938F, 0x9390, 0x9391,
+	0x9392, 0x9393, 0x9394, 0x9395, 0x9396, 0x9397, 0x9398, 0x9399,
+	0x939A, 0x939B, 0x939C, 0x939D, 0x939E, 0x939F, 0x93A0, 0x93A1,
+	0x93A2, 0x93A3, 0x93A4, 0x93A5, 0x93A6, 0x93A7, 0x93A8, 0x93A9,
+	0xB9F6, 0xB9F7, 0x93AA, 0x93AB, 0xB9F8, 0x93AC, 0x93AD, 0xB9F9,
+	0xB9FA, 0x93AE, 0xB9FB, 0x93AF, 0x93B0, 0x93B1, 0x93B2, 0x93B3,
+	0xB9FC, 0xB9FD, 0x93B4, 0xB9FE, 0x93B5, 0xBAA1, 0xBAA2, 0x93B6,
+	0x93B7, 0x93B8, 0x93B9, 0x93BA, 0xBAA3, 0xBAA4, 0x93BB, 0x93BC,
+	0xBAA5, 0x93BD, 0x93BE, 0xBAA6, 0xBAA7, 0x93BF, 0x93C0, 0x93C1,
+	0x93C2, 0x93C3, 0x93C4, 0x93C5, 0xBAA8, 0xBAA9, 0x93C6, 0xBAAA,
+	0xBAAB, 0xBAAC, 0x93C7, 0x93C8, 0x93C9, 0x93CA, 0x93CB, 0x93CC,
+	0xBAAD, 0xBAAE, 0x93CD, 0x93CE, 0xBAAF, 0x93CF, 0x93D0, 0x93D1,
+	0xBAB0, 0x93D2, 0x93D3, 0x93D4, 0x93D5, 0x93D6, 0x93D7, 0x93D8,
+	0x93D9, 0xBAB1, 0x93DA, 0xBAB2, 0xBAB3, 0xBAB4, 0x93DB, 0x93DC,
+	0x93DD, 0xBAB5, 0x93DE, 0x93DF, 0xBAB6, 0x93E0, 0x93E1, 0x93E2,
+	0xBAB7, 0x93E3, 0x93E4, 0x93E5, 0x93E6, 0x93E7, 0x93E8, 0x93E9,
+	0x93EA, 0x93EB, 0x93EC, 0x93ED, 0x93EE, 0x93EF, 0x93F0, 0x93F1,
+	0x93F2, 0x93F3, 0x93F4, 0x93F5, 0x93F6, 0x93F7, 0x93F8, 0x93F9,
+	0xBAB8, 0xBAB9, 0xBABA, 0x93FA, 0xBABB, 0x93FB, 0x93FC, 0x93FD,
+	0xBABC, 0x93FE, 0x9441, 0x9442, 0x9443, 0x9444, 0x9445, 0x9446,
+	0xBABD, 0xBABE, 0x9447, 0xBABF, 0x9448, 0xBAC0, 0x9449, 0x944A,
+	0x944B, 0x944C, 0x944D, 0x944E, 0xBAC1, 0x944F, 0x9450, 0x9451,
+	0xBAC2, 0x9452, 0x9453, 0x9454, 0x9455, 0x9456, 0x9457, 0x9458,
+	0x9459, 0x945A, 0x9461, 0x9462, 0x9463, 0x9464, 0x9465, 0x9466,
+	0xBAC3, 0x9467, 0x9468, 0x9469, 0x946A, 0x946B, 0x946C, 0x946D,
+	0xBAC4, 0x946E, 0x946F, 0x9470, 0x9471, 0x9472, 0x9473, 0x9474,
+	0x9475, 0x9476, 0x9477, 0x9478, 0x9479, 0x947A, 0x9481, 0x9482,
+	0x9483, 0x9484, 0x9485, 0x9486, 0xBAC5, 0x9487, 0x9488, 0x9489,
+	0x948A, 0x948B, 0x948C, 0x948D, 0xBAC6, 0xBAC7, 0x948E, 0x948F,
+	0xBAC8, 0x9490, 0x9491, 0x9492, 0xBAC9, 0x9493, 0x9494, 0x9495,
+	0x9496, 0x9497, 0x9498, 0x9499, 0xBACA, 0xBACB, 0x949A, 0x949B,
+	0x949C, 0x949D, 0x949E, 0x949F, 0x94A0, 0x94A1, 0x94A2, 0x94A3,
+	0xBACC, 0x94A4, 0x94A5, 0x94A6, 0xBACD, 0x94A7, 0x94A8, 0x94A9,
+	0x94AA, 0x94AB, 0x94AC, 0x94AD, 0x94AE, 0x94AF, 0x94B0, 0x94B1,
+	0x94B2, 0x94B3, 0x94B4, 0x94B5, 0x94B6, 0x94B7, 0x94B8, 0x94B9,
+	0x94BA, 0x94BB, 0x94BC, 0x94BD, 0xBACE, 0xBACF, 0x94BE, 0x94BF,
+	0xBAD0, 0x94C0, 0x94C1, 0xBAD1, 0xBAD2, 0xBAD3, 0xBAD4, 0x94C2,
+	0x94C3, 0x94C4, 0x94C5, 0x94C6, 0xBAD5, 0xBAD6, 0x94C7, 0xBAD7,
+	0x94C8, 0xBAD8, 0x94C9, 0x94CA, 0x94CB, 0xBAD9, 0xBADA, 0x94CC,
+	0xBADB, 0x94CD, 0x94CE, 0x94CF, 0x94D0, 0x94D1, 0x94D2, 0x94D3,
+	0xBADC, 0x94D4, 0x94D5, 0x94D6, 0x94D7, 0x94D8, 0x94D9, 0x94DA,
+	0x94DB, 0x94DC, 0x94DD, 0x94DE, 0xBADD, 0x94DF, 0x94E0, 0x94E1,
+	0x94E2, 0x94E3, 0x94E4, 0x94E5, 0xBADE, 0x94E6, 0x94E7, 0x94E8,
+	0x94E9, 0x94EA, 0x94EB, 0x94EC, 0x94ED, 0x94EE, 0x94EF, 0x94F0,
+	0x94F1, 0x94F2, 0x94F3, 0x94F4, 0x94F5, 0x94F6, 0x94F7, 0x94F8,
+	0x94F9, 0x94FA, 0x94FB, 0x94FC, 0x94FD, 0x94FE, 0x9541, 0x9542,
+	0xBADF, 0xBAE0, 0x9543, 0x9544, 0xBAE1, 0x9545, 0x9546, 0x9547,
+	0xBAE2, 0x9548, 0x9549, 0x954A, 0x954B, 0x954C, 0x954D, 0x954E,
+	0x954F, 0x9550, 0x9551, 0x9552, 0x9553, 0xBAE3, 0x9554, 0x9555,
+	0x9556, 0x9557, 0x9558, 0x9559, 0xBAE4, 0x955A, 0x9561, 0x9562,
+	0xBAE5, 0x9563, 0x9564, 0x9565, 0xBAE6, 0x9566, 0x9567, 0x9568,
+	0x9569, 0x956A, 0x956B, 0x956C, 0xBAE7, 0x956D, 0x956E, 0xBAE8,
+	0x956F, 0xBAE9, 0x9570, 0x9571, 0x9572, 0x9573, 0x9574, 0x9575,
+	0xBAEA, 0xBAEB, 0x9576, 0x9577, 0xBAEC, 0x9578, 0x9579, 0x957A,
+	0xBAED, 0x9581, 0x9582, 0x9583, 0x9584, 0x9585, 0x9586, 0x9587,
+	0xBAEE, 0xBAEF, 0x9588, 0xBAF0, 0x9589, 0x958A, 0x958B, 0x958C,
+	0x958D, 0x958E, 0x958F, 0x9590, 0x9591, 0x9592, 0x9593, 0x9594,
+	0x9595, 0x9596, 0x9597, 0x9598, 0x9599, 0x959A, 0x959B, 0x959C,
+	0x959D, 0x959E, 0x959F, 0x95A0, 0x95A1, 0x95A2, 0x95A3, 0x95A4,
+	0x95A5, 0x95A6, 0x95A7, 0x95A8, 0x95A9, 0x95AA, 0x95AB, 0x95AC,
+	0xBAF1, 0xBAF2, 0x95AD, 0x95AE, 0xBAF3, 0x95AF, 0x95B0, 0x95B1,
+	0xBAF4, 0x95B2, 0xBAF5, 0x95B3, 0x95B4, 0x95B5, 0x95B6, 0x95B7,
+	0xBAF6, 0xBAF7, 0x95B8, 0xBAF8, 0x95B9, 0xBAF9, 0xBAFA, 0xBAFB,
+	0x95BA, 0x95BB, 0x95BC, 0x95BD, 0xBAFC, 0xBAFD, 0x95BE, 0x95BF,
+	0xBAFE, 0x95C0, 0x95C1, 0x95C2, 0xBBA1, 0x95C3, 0xBBA2, 0x95C4,
+	0x95C5, 0x95C6, 0x95C7, 0x95C8, 0xBBA3, 0xBBA4, 0x95C9, 0xBBA5,
+	0xBBA6, 0xBBA7, 0x95CA, 0x95CB, 0x95CC, 0x95CD, 0x95CE, 0xBBA8,
+	0xBBA9, 0xBBAA, 0x95CF, 0x95D0, 0xBBAB, 0x95D1, 0x95D2, 0x95D3,
+	0xBBAC, 0x95D4, 0x95D5, 0x95D6, 0x95D7, 0x95D8, 0x95D9, 0x95DA,
+	0xBBAD, 0xBBAE, 0x95DB, 0xBBAF, 0xBBB0, 0xBBB1, 0x95DC, 0x95DD,
+	0x95DE, 0x95DF, 0x95E0, 0x95E1, 0xBBB2, 0xBBB3, 0x95E2, 0x95E3,
+	0x95E4, 0x95E5, 0x95E6, 0x95E7, 0x95E8, 0x95E9, 0x95EA, 0x95EB,
+	0x95EC, 0x95ED, 0x95EE, 0x95EF, 0xBBB4, 0x95F0, 0x95F1, 0x95F2,
+	0x95F3, 0x95F4, 0x95F5, 0x95F6, 0x95F7, 0x95F8, 0x95F9, 0x95FA,
+	0x95FB, 0x95FC, 0x95FD, 0x95FE, 0x9641, 0x9642, 0x9643, 0x9644,
+	0x9645, 0x9646, 0x9647, 0x9648, 0x9649, 0x964A, 0x964B, 0x964C,
+	0x964D, 0x964E, 0x964F, 0x9650, 0x9651, 0x9652, 0x9653, 0x9654,
+	0x9655, 0x9656, 0x9657, 0x9658, 0xBBB5, 0xBBB6, 0x9659, 0x965A,
+	0xBBB7, 0x9661, 0x9662, 0xBBB8, 0xBBB9, 0x9663, 0x9664, 0x9665,
+	0x9666, 0x9667, 0x9668, 0x9669, 0xBBBA, 0x966A, 0x966B, 0xBBBB,
+	0xBBBC, 0xBBBD, 0x966C, 0x966D, 0x966E, 0x966F, 0x9670, 0x9671,
+	0xBBBE, 0x9672, 0x9673, 0x9674, 0x9675, 0x9676, 0x9677, 0x9678,
+	0x9679, 0x967A, 0x9681, 0x9682, 0x9683, 0x9684, 0x9685, 0x9686,
+	0x9687, 0x9688, 0x9689, 0x968A, 0x968B, 0xBBBF, 0x968C, 0x968D,
+	0x968E, 0x968F, 0x9690, 0x9691, 0xBBC0, 0xBBC1, 0x9692, 0x9693,
+	0x9694, 0x9695, 0x9696, 0x9697, 0x9698, 0x9699, 0x969A, 0x969B,
+	0x969C, 0x969D, 0x969E, 0x969F, 0xBBC2, 0xBBC3, 0x96A0, 0xBBC4,
+	0xBBC5, 0xBBC6, 0x96A1, 0x96A2, 0x96A3, 0x96A4, 0x96A5, 0x96A6,
+	0x96A7, 0x96A8, 0x96A9, 0x96AA, 0x96AB, 0x96AC, 0x96AD, 0x96AE,
+	0x96AF, 0x96B0, 0x96B1, 0x96B2, 0x96B3, 0x96B4, 0x96B5, 0x96B6,
+	0x96B7, 0x96B8, 0x96B9, 0x96BA, 0x96BB, 0x96BC, 0x96BD, 0x96BE,
+	0x96BF, 0x96C0, 0x96C1, 0x96C2, 0xBBC7, 0xBBC8, 0x96C3, 0x96C4,
+	0xBBC9, 0x96C5, 0x96C6, 0x96C7, 0xBBCA, 0x96C8, 0x96C9, 0x96CA,
+	0x96CB, 0x96CC, 0x96CD, 0x96CE, 0xBBCB, 0xBBCC, 0x96CF, 0x96D0,
+	0x96D1, 0xBBCD, 0x96D2, 0x96D3, 0x96D4, 0x96D5, 0x96D6, 0x96D7,
+	0x96D8, 0x96D9, 0x96DA, 0x96DB, 0x96DC, 0x96DD, 0x96DE, 0x96DF,
+	0x96E0, 0x96E1, 0x96E2, 0x96E3, 0x96E4, 0x96E5, 0x96E6, 0x96E7,
+	0x96E8, 0x96E9, 0x96EA, 0x96EB, 0x96EC, 0x96ED, 0x96EE, 0x96EF,
+	0x96F0, 0x96F1, 0x96F2, 0x96F3, 0x96F4, 0x96F5, 0x96F6, 0x96F7,
+	0x96F8, 0x96F9, 0x96FA, 0x96FB, 0x96FC, 0x96FD, 0x96FE, 0x9741,
+	0x9742, 0x9743, 0x9744, 0x9745, 0x9746, 0x9747, 0x9748, 0x9749,
+	0x974A, 0x974B, 0x974C, 0x974D, 0x974E, 0x974F, 0x9750, 0x9751,
+	0xBBCE, 0x9752, 0x9753, 0x9754, 0x9755, 0x9756, 0x9757, 0x9758,
+	0x9759, 0x975A, 0x9761, 0x9762, 0x9763, 0x9764, 0x9765, 0x9766,
+	0x9767, 0x9768, 0x9769, 0x976A, 0x976B, 0x976C, 0x976D, 0x976E,
+	0x976F, 0x9770, 0x9771, 0x9772, 0xBBCF, 0x9773, 0x9774, 0x9775,
+	0x9776, 0x9777, 0x9778, 0x9779, 0x977A, 0x9781, 0x9782, 0x9783,
+	0x9784, 0x9785, 0x9786, 0x9787, 0x9788, 0x9789, 0x978A, 0x978B,
+	0x978C, 0xBBD0, 0x978D, 0x978E, 0x978F, 0x9790, 0x9791, 0x9792,
+	0xBBD1, 0xBBD2, 0x9793, 0x9794, 0xBBD3, 0x9795, 0x9796, 0x9797,
+	0xBBD4, 0x9798, 0x9799, 0x979A, 0x979B, 0x979C, 0x979D, 0x979E,
+	0xBBD5, 0x979F, 0x97A0, 0xBBD6, 0x97A1, 0xBBD7, 0x97A2, 0x97A3,
+	0x97A4, 0x97A5, 0x97A6, 0x97A7, 0x97A8, 0x97A9, 0x97AA, 0x97AB,
+	0x97AC, 0x97AD, 0x97AE, 0x97AF, 0x97B0, 0x97B1, 0x97B2, 0x97B3,
+	0x97B4, 0x97B5, 0x97B6, 0x97B7, 0x97B8, 0x97B9, 0x97BA, 0x97BB,
+	0x97BC, 0x97BD, 0x97BE, 0x97BF, 0x97C0, 0x97C1, 0x97C2, 0x97C3,
+	0x97C4, 0x97C5, 0x97C6, 0x97C7, 0x97C8, 0x97C9, 0x97CA, 0x97CB,
+	0x97CC, 0x97CD, 0x97CE, 0x97CF, 0x97D0, 0x97D1, 0x97D2, 0x97D3,
+	0x97D4, 0x97D5, 0x97D6, 0x97D7, 0x97D8, 0x97D9, 0x97DA, 0x97DB,
+	0x97DC, 0x97DD, 0x97DE, 0x97DF, 0x97E0, 0x97E1, 0x97E2, 0x97E3,
+	0x97E4, 0x97E5, 0x97E6, 0x97E7, 0x97E8, 0x97E9, 0x97EA, 0x97EB,
+	0x97EC, 0x97ED, 0x97EE, 0x97EF, 0x97F0, 0x97F1, 0x97F2, 0x97F3,
+	0x97F4, 0x97F5, 0x97F6, 0x97F7, 0x97F8, 0x97F9, 0x97FA, 0x97FB,
+	0xBBD8, 0x97FC, 0x97FD, 0x97FE, 0x9841, 0x9842, 0x9843, 0x9844,
+	0x9845, 0x9846, 0x9847, 0x9848, 0x9849, 0x984A, 0x984B, 0x984C,
+	0x984D, 0x984E, 0x984F, 0x9850, 0x9851, 0xBBD9, 0x9852, 0x9853,
+	0x9854, 0x9855, 0x9856, 0x9857, 0xBBDA, 0x9858, 0x9859, 0x985A,
+	0xBBDB, 0x9861, 0x9862, 0x9863, 0xBBDC, 0x9864, 0x9865, 0x9866,
+	0x9867, 0x9868, 0x9869, 0x986A, 0xBBDD, 0xBBDE, 0x986B, 0x986C,
+	0x986D, 0x986E, 0x986F, 0x9870, 0x9871, 0x9872, 0x9873, 0x9874,
+	0x9875, 0x9876, 0x9877, 0x9878, 0x9879, 0x987A, 0x9881, 0x9882,
+	0x9883, 0x9884, 0x9885, 0x9886, 0x9887, 0x9888, 0x9889, 0x988A,
+	0x988B, 0x988C, 0x988D, 0x988E, 0x988F, 0x9890, 0x9891, 0x9892,
+	0x9893, 0x9894, 0x9895, 0x9896, 0xBBDF, 0xBBE0, 0x9897, 0x9898,
+	0xBBE1, 0x9899, 0x989A, 0x989B, 0xBBE2, 0x989C, 0x989D, 0x989E,
+	0x989F, 0x98A0, 0x98A1, 0x98A2, 0xBBE3, 0xBBE4, 0x98A3, 0xBBE5,
+	0x98A4, 0xBBE6, 0x98A5, 0x98A6, 0x98A7, 0x98A8, 0x98A9, 0x98AA,
+	0xBBE7, 0xBBE8, 0x98AB, 0xBBE9, 0xBBEA, 0x98AC, 0x98AD, 0xBBEB,
+	0xBBEC, 0xBBED, 0xBBEE, 0x98AE, 0x98AF, 0x98B0, 0x98B1, 0x98B2,
+	0xBBEF, 0xBBF0, 0x98B3, 0xBBF1, 0xBBF2, 0xBBF3, 0x98B4, 0x98B5,
+	0x98B6, 0xBBF4, 0x98B7, 0x98B8, 0xBBF5, 0xBBF6, 0x98B9, 0x98BA,
+	0xBBF7, 0x98BB, 0x98BC, 0x98BD, 0xBBF8, 0x98BE, 0x98BF, 0x98C0,
+	0x98C1, 0x98C2, 0x98C3, 0x98C4, 0xBBF9, 0xBBFA, 0x98C5, 0xBBFB,
+	0xBBFC, 0xBBFD, 0x98C6, 0x98C7, 0x98C8, 0x98C9, 0x98CA, 0x98CB,
+	0xBBFE, 0xBCA1, 0x98CC, 0x98CD, 0xBCA2, 0x98CE, 0x98CF, 0x98D0,
+	0xBCA3, 0x98D1, 0x98D2, 0x98D3, 0x98D4, 0x98D5, 0x98D6, 0x98D7,
+	0xBCA4, 0xBCA5, 0x98D8, 0xBCA6, 0x98D9, 0xBCA7, 0x98DA, 0x98DB,
+	0x98DC, 0x98DD, 0x98DE, 0x98DF, 0xBCA8, 0x98E0, 0x98E1, 0x98E2,
+	0xBCA9, 0x98E3, 0x98E4, 0x98E5, 0xBCAA, 0x98E6, 0x98E7, 0x98E8,
+	0x98E9, 0x98EA, 0x98EB, 0x98EC, 0xBCAB, 0x98ED, 0x98EE, 0x98EF,
+	0x98F0, 0xBCAC, 0x98F1, 0x98F2, 0x98F3, 0x98F4, 0x98F5, 0x98F6,
+	0xBCAD, 0xBCAE, 0xBCAF, 0xBCB0, 0xBCB1, 0x98F7, 0x98F8, 0xBCB2,
+	0xBCB3, 0x98F9, 0xBCB4, 0xBCB5, 0x98FA, 0x98FB, 0x98FC, 0x98FD,
+	0xBCB6, 0xBCB7, 0x98FE, 0xBCB8, 0xBCB9, 0xBCBA, 0x9941, 0x9942,
+	0x9943, 0x9944, 0xBCBB, 0x9945, 0xBCBC, 0xBCBD, 0x9946, 0x9947,
+	0xBCBE, 0x9948, 0x9949, 0x994A, 0xBCBF, 0x994B, 0x994C, 0x994D,
+	0x994E, 0x994F, 0x9950, 0x9951, 0xBCC0, 0xBCC1, 0x9952, 0xBCC2,
+	0xBCC3, 0xBCC4, 0x9953, 0x9954, 0x9955, 0x9956, 0x9957, 0x9958,
+	0xBCC5, 0xBCC6, 0x9959, 0x995A, 0xBCC7, 0x9961, 0x9962, 0x9963,
+	0xBCC8, 0x9964, 0x9965, 0x9966, 0x9967, 0x9968, 0x9969, 0x996A,
+	0xBCC9, 0xBCCA, 0x996B, 0xBCCB, 0xBCCC, 0xBCCD, 0x996C, 0x996D,
+	0x996E, 0x996F, 0x9970, 0x9971, 0xBCCE, 0x9972, 0x9973, 0x9974,
+	0xBCCF, 0x9975, 0x9976, 0x9977, 0xBCD0, 0x9978, 0x9979, 0x997A,
+	0x9981, 0x9982, 0x9983, 0x9984, 0x9985, 0x9986, 0x9987, 0x9988,
+	0x9989, 0xBCD1, 0x998A, 0x998B, 0x998C, 0x998D, 0x998E, 0x998F,
+	0xBCD2, 0xBCD3, 0xBCD4, 0x9990, 0xBCD5, 0x9991, 0x9992, 0x9993,
+	0xBCD6, 0x9994, 0xBCD7, 0x9995, 0x9996, 0x9997, 0x9998, 0x9999,
+	0xBCD8, 0xBCD9, 0x999A, 0xBCDA, 0x999B, 0xBCDB, 0x999C, 0x999D,
+	0x999E, 0xBCDC, 0x999F, 0x99A0, 0xBCDD, 0xBCDE, 0x99A1, 0x99A2,
+	0xBCDF, 0x99A3, 0x99A4, 0x99A5, 0xBCE0, 0x99A6, 0x99A7, 0x99A8,
+	0x99A9, 0x99AA, 0x99AB, 0x99AC, 0x99AD, 0x99AE, 0x99AF, 0x99B0,
+	0x99B1, 0xBCE1, 0x99B2, 0x99B3, 0x99B4, 0x99B5, 0x99B6, 0x99B7,
+	0xBCE2, 0x99B8, 0x99B9, 0x99BA, 0xBCE3, 0x99BB, 0x99BC, 0x99BD,
+	0xBCE4, 0x99BE, 0x99BF, 0x99C0, 0x99C1, 0x99C2, 0x99C3, 0x99C4,
+	0xBCE5, 0x99C5, 0x99C6, 0xBCE6, 0xBCE7, 0x99C7, 0x99C8, 0x99C9,
+	0x99CA, 0x99CB, 0x99CC, 0x99CD, 0xBCE8, 0x99CE, 0x99CF, 0x99D0,
+	0xBCE9, 0x99D1, 0x99D2, 0x99D3, 0xBCEA, 0x99D4, 0x99D5, 0x99D6,
+	0x99D7, 0x99D8, 0x99D9, 0x99DA, 0xBCEB, 0xBCEC, 0x99DB, 0xBCED,
+	0x99DC, 0x99DD, 0x99DE, 0x99DF, 0x99E0, 0x99E1, 0x99E2, 0x99E3,
+	0xBCEE, 0xBCEF, 0x99E4, 0x99E5, 0xBCF0, 0x99E6, 0x99E7, 0x99E8,
+	0xBCF1, 0x99E9, 0x99EA, 0x99EB, 0x99EC, 0x99ED, 0x99EE, 0x99EF,
+	0xBCF2, 0xBCF3, 0x99F0, 0xBCF4, 0x99F1, 0xBCF5, 0x99F2, 0x99F3,
+	0x99F4, 0x99F5, 0x99F6, 0x99F7, 0xBCF6, 0xBCF7, 0x99F8, 0x99F9,
+	0xBCF8, 0x99FA, 0x99FB, 0xBCF9, 0xBCFA, 0x99FC, 0x99FD, 0x99FE,
+	0x9A41, 0x9A42, 0x9A43, 0x9A44, 0xBCFB, 0xBCFC, 0x9A45, 0xBCFD,
+	0x9A46, 0xBCFE, 0x9A47, 0xBDA1, 0x9A48, 0xBDA2, 0xBDA3, 0x9A49,
+	0xBDA4, 0x9A4A, 0x9A4B, 0x9A4C, 0x9A4D, 0x9A4E, 0x9A4F, 0x9A50,
+	0x9A51, 0x9A52, 0x9A53, 0x9A54, 0x9A55, 0x9A56, 0x9A57, 0x9A58,
+	0x9A59, 0x9A5A, 0x9A61, 0x9A62, 0xBDA5, 0x9A63, 0x9A64, 0x9A65,
+	0x9A66, 0x9A67, 0x9A68, 0x9A69, 0xBDA6, 0xBDA7, 0x9A6A, 0x9A6B,
+	0xBDA8, 0x9A6C, 0x9A6D, 0x9A6E, 0xBDA9, 0x9A6F, 0x9A70, 0x9A71,
+	0x9A72, 0x9A73, 0x9A74, 0x9A75, 0xBDAA, 0x9A76, 0x9A77, 0x9A78,
+	0x9A79, 0xBDAB, 0x9A7A, 0x9A81, 0x9A82, 0x9A83, 0x9A84, 0x9A85,
+	0xBDAC, 0xBDAD, 0x9A86, 0x9A87, 0xBDAE, 0x9A88, 0x9A89, 0x9A8A,
+	0xBDAF, 0x9A8B, 0x9A8C, 0x9A8D, 0x9A8E, 0x9A8F, 0x9A90, 0x9A91,
+	0xBDB0, 0xBDB1, 0x9A92, 0xBDB2, 0x9A93, 0xBDB3, 0x9A94, 0x9A95,
+	0x9A96, 0x9A97, 0x9A98, 0x9A99, 0xBDB4, 0xBDB5, 0x9A9A, 0x9A9B,
+	0x9A9C, 0x9A9D, 0x9A9E, 0x9A9F, 0xBDB6, 0x9AA0, 0x9AA1, 0x9AA2,
+	0x9AA3, 0x9AA4, 0x9AA5, 0x9AA6, 0xBDB7, 0x9AA7, 0x9AA8, 0xBDB8,
+	0x9AA9, 0xBDB9, 0x9AAA, 0x9AAB, 0x9AAC, 0x9AAD, 0x9AAE, 0x9AAF,
+	0xBDBA, 0xBDBB, 0x9AB0, 0x9AB1, 0xBDBC, 0x9AB2, 0x9AB3, 0x9AB4,
+	0xBDBD, 0xBDBE, 0x9AB5, 0x9AB6, 0x9AB7, 0x9AB8, 0x9AB9, 0x9ABA,
+	0xBDBF, 0xBDC0, 0x9ABB, 0xBDC1, 0x9ABC, 0xBDC2, 0x9ABD, 0x9ABE,
+	0x9ABF, 0x9AC0, 0x9AC1, 0x9AC2, 0x9AC3, 0x9AC4, 0x9AC5, 0x9AC6,
+	0x9AC7, 0x9AC8, 0x9AC9, 0x9ACA, 0x9ACB, 0x9ACC, 0x9ACD, 0x9ACE,
+	0x9ACF, 0x9AD0, 0x9AD1, 0x9AD2, 0x9AD3, 0x9AD4, 0x9AD5, 0x9AD6,
+	0x9AD7, 0x9AD8, 0x9AD9, 0x9ADA, 0x9ADB, 0x9ADC, 0x9ADD, 0x9ADE,
+	0xBDC3, 0xBDC4, 0x9ADF, 0x9AE0, 0xBDC5, 0x9AE1, 0x9AE2, 0xBDC6,
+	0xBDC7, 0x9AE3, 0x9AE4, 0x9AE5, 0x9AE6, 0x9AE7, 0x9AE8, 0xBDC8,
+	0xBDC9, 0xBDCA, 0x9AE9, 0xBDCB, 0x9AEA, 0xBDCC, 0x9AEB, 0x9AEC,
+	0x9AED, 0x9AEE, 0xBDCD, 0x9AEF, 0xBDCE, 0xBDCF, 0x9AF0, 0xBDD0,
+	0xBDD1, 0x9AF1, 0x9AF2, 0x9AF3, 0xBDD2, 0x9AF4, 0x9AF5, 0x9AF6,
+	0x9AF7, 0x9AF8, 0x9AF9, 0x9AFA, 0xBDD3, 0xBDD4, 0x9AFB, 0x9AFC,
+	0xBDD5, 0xBDD6, 0x9AFD, 0x9AFE, 0x9B41, 0x9B42, 0x9B43, 0xBDD7,
+	0xBDD8, 0xBDD9, 0x9B44, 0x9B45, 0xBDDA, 0x9B46, 0x9B47, 0x9B48,
+	0xBDDB, 0x9B49, 0x9B4A, 0x9B4B, 0x9B4C, 0x9B4D, 0x9B4E, 0x9B4F,
+	0xBDDC, 0xBDDD, 0x9B50, 0x9B51, 0xBDDE, 0xBDDF, 0x9B52, 0x9B53,
+	0x9B54, 0x9B55, 0x9B56, 0x9B57, 0x9B58, 0x9B59, 0x9B5A, 0x9B61,
+	0x9B62, 0x9B63, 0x9B64, 0x9B65, 0x9B66, 0x9B67, 0x9B68, 0x9B69,
+	0x9B6A, 0x9B6B, 0x9B6C, 0x9B6D, 0x9B6E, 0x9B6F, 0x9B70, 0x9B71,
+	0x9B72, 0xBDE0, 0x9B73, 0x9B74, 0x9B75, 0x9B76, 0x9B77, 0x9B78,
+	0x9B79, 0x9B7A, 0x9B81, 0x9B82, 0x9B83, 0x9B84, 0x9B85, 0x9B86,
+	0x9B87, 0x9B88, 0x9B89, 0x9B8A, 0x9B8B, 0x9B8C, 0x9B8D, 0x9B8E,
+	0x9B8F, 0x9B90, 0x9B91, 0x9B92, 0x9B93, 0x9B94, 0x9B95, 0x9B96,
+	0x9B97, 0x9B98, 0x9B99, 0x9B9A, 0xBDE1, 0xBDE2, 0x9B9B, 0x9B9C,
+	0xBDE3, 0x9B9D, 0x9B9E, 0x9B9F, 0xBDE4, 0x9BA0, 0xBDE5, 0x9BA1,
+	0x9BA2, 0x9BA3, 0x9BA4, 0x9BA5, 0xBDE6, 0xBDE7, 0x9BA6, 0x9BA7,
+	0xBDE8, 0xBDE9, 0x9BA8, 0x9BA9, 0x9BAA, 0x9BAB, 0x9BAC, 0x9BAD,
+	0xBDEA, 0x9BAE, 0x9BAF, 0x9BB0, 0xBDEB, 0x9BB1, 0x9BB2, 0x9BB3,
+	0xBDEC, 0x9BB4, 0x9BB5, 0x9BB6, 0x9BB7, 0x9BB8, 0x9BB9, 0x9BBA,
+	0x9BBB, 0x9BBC, 0x9BBD, 0x9BBE, 0x9BBF, 0x9BC0, 0x9BC1, 0x9BC2,
+	0x9BC3, 0x9BC4, 0x9BC5, 0x9BC6, 0x9BC7, 0x9BC8, 0x9BC9, 0x9BCA,
+	0x9BCB, 0x9BCC, 0x9BCD, 0x9BCE, 0x9BCF, 0x9BD0, 0x9BD1, 0x9BD2,
+	0x9BD3, 0x9BD4, 0x9BD5, 0x9BD6, 0x9BD7, 0x9BD8, 0x9BD9, 0x9BDA,
+	0x9BDB, 0x9BDC, 0x9BDD, 0x9BDE, 0x9BDF, 0x9BE0, 0x9BE1, 0x9BE2,
+	0x9BE3, 0x9BE4, 0x9BE5, 0x9BE6, 0xBDED, 0x9BE7, 0x9BE8, 0x9BE9,
+	0x9BEA, 0x9BEB, 0x9BEC, 0x9BED, 0x9BEE, 0x9BEF, 0x9BF0, 0x9BF1,
+	0x9BF2, 0x9BF3, 0x9BF4, 0x9BF5, 0x9BF6, 0x9BF7, 0x9BF8, 0x9BF9,
+	0x9BFA, 0x9BFB, 0x9BFC, 0x9BFD, 0xBDEE, 0xBDEF, 0x9BFE, 0x9C41,
+	0xBDF0, 0x9C42, 0x9C43, 0xBDF1, 0xBDF2, 0x9C44, 0xBDF3, 0x9C45,
+	0x9C46, 0x9C47, 0x9C48, 0x9C49, 0xBDF4, 0xBDF5, 0x9C4A, 0x9C4B,
+	0x9C4C, 0xBDF6, 0x9C4D, 0x9C4E, 0x9C4F, 0x9C50, 0x9C51, 0x9C52,
+	0xBDF7, 0xBDF8, 0x9C53, 0x9C54, 0xBDF9, 0x9C55, 0x9C56, 0x9C57,
+	0x9C58, 0x9C59, 0x9C5A, 0x9C61, 0x9C62, 0x9C63, 0x9C64, 0x9C65,
+	0x9C66, 0x9C67, 0x9C68, 0x9C69, 0xBDFA, 0x9C6A, 0x9C6B, 0x9C6C,
+	0x9C6D, 0x9C6E, 0x9C6F, 0x9C70, 0xBDFB, 0x9C71, 0x9C72, 0x9C73,
+	0x9C74, 0x9C75, 0x9C76, 0x9C77, 0x9C78, 0x9C79, 0x9C7A, 0x9C81,
+	0x9C82, 0x9C83, 0x9C84, 0x9C85, 0x9C86, 0x9C87, 0x9C88, 0x9C89,
+	0xBDFC, 0x9C8A, 0x9C8B, 0x9C8C, 0x9C8D, 0x9C8E, 0x9C8F, 0x9C90,
+	0xBDFD, 0x9C91, 0x9C92, 0x9C93, 0xBDFE, 0x9C94, 0x9C95, 0x9C96,
+	0xBEA1, 0x9C97, 0x9C98, 0x9C99, 0x9C9A, 0x9C9B, 0x9C9C, 0x9C9D,
+	0xBEA2, 0xBEA3, 0x9C9E, 0x9C9F, 0x9CA0, 0x9CA1, 0x9CA2, 0x9CA3,
+	0x9CA4, 0x9CA5, 0x9CA6, 0x9CA7, 0xBEA4, 0x9CA8, 0x9CA9, 0x9CAA,
+	0x9CAB, 0x9CAC, 0x9CAD, 0x9CAE, 0x9CAF, 0x9CB0, 0x9CB1, 0x9CB2,
+	0x9CB3, 0x9CB4, 0x9CB5, 0x9CB6, 0x9CB7, 0x9CB8, 0x9CB9, 0x9CBA,
+	0x9CBB, 0x9CBC, 0x9CBD, 0x9CBE, 0x9CBF, 0x9CC0, 0x9CC1, 0x9CC2,
+	0xBEA5, 0xBEA6, 0x9CC3, 0x9CC4, 0xBEA7, 0x9CC5, 0x9CC6, 0x9CC7,
+	0xBEA8, 0x9CC8, 0x9CC9, 0x9CCA, 0x9CCB, 0x9CCC, 0x9CCD, 0x9CCE,
+	0xBEA9, 0xBEAA, 0x9CCF, 0x9CD0, 0x9CD1, 0xBEAB, 0x9CD2, 0x9CD3,
+	0x9CD4, 0x9CD5, 0x9CD6, 0x9CD7, 0xBEAC, 0x9CD8, 0x9CD9, 0x9CDA,
+	0x9CDB, 0x9CDC, 0x9CDD, 0x9CDE, 0x9CDF, 0x9CE0, 0x9CE1, 0x9CE2,
+	0x9CE3, 0x9CE4, 0x9CE5, 0x9CE6, 0x9CE7, 0x9CE8, 0x9CE9, 0x9CEA,
+	0xBEAD, 0x9CEB, 0x9CEC, 0x9CED, 0x9CEE, 0x9CEF, 0x9CF0, 0x9CF1,
+	0xBEAE, 0x9CF2, 0x9CF3, 0x9CF4, 0x9CF5, 0x9CF6, 0x9CF7, 0x9CF8,
+	0x9CF9, 0x9CFA, 0x9CFB, 0x9CFC, 0x9CFD, 0x9CFE, 0x9D41, 0x9D42,
+	0x9D43, 0x9D44, 0x9D45, 0x9D46, 0x9D47, 0x9D48, 0x9D49, 0x9D4A,
+	0x9D4B, 0x9D4C, 0x9D4D, 0x9D4E, 0xBEAF, 0x9D4F, 0x9D50, 0x9D51,
+	0xBEB0, 0x9D52, 0x9D53, 0x9D54, 0x9D55, 0x9D56, 0x9D57, 0x9D58,
+	0x9D59, 0x9D5A, 0x9D61, 0x9D62, 0x9D63, 0x9D64, 0x9D65, 0x9D66,
+	0x9D67, 0x9D68, 0x9D69, 0x9D6A, 0x9D6B, 0x9D6C, 0x9D6D, 0x9D6E,
+	0x9D6F, 0x9D70, 0x9D71, 0x9D72, 0x9D73, 0x9D74, 0x9D75, 0x9D76,
+	0x9D77, 0x9D78, 0x9D79, 0x9D7A, 0x9D81, 0x9D82, 0x9D83, 0x9D84,
+	0x9D85, 0x9D86, 0x9D87, 0x9D88, 0x9D89, 0xBEB1, 0x9D8A, 0x9D8B,
+	0x9D8C, 0x9D8D, 0x9D8E, 0x9D8F, 0xBEB2, 0xBEB3, 0x9D90, 0x9D91,
+	0xBEB4, 0x9D92, 0x9D93, 0x9D94, 0xBEB5, 0x9D95, 0xBEB6, 0x9D96,
+	0x9D97, 0x9D98, 0x9D99, 0xBEB7, 0xBEB8, 0xBEB9, 0x9D9A, 0x9D9B,
+	0x9D9C, 0x9D9D, 0x9D9E, 0x9D9F, 0x9DA0, 0x9DA1, 0x9DA2, 0x9DA3,
+	0xBEBA, 0x9DA4, 0x9DA5, 0x9DA6, 0xBEBB, 0x9DA7, 0x9DA8, 0x9DA9,
+	0xBEBC, 0x9DAA, 0x9DAB, 0x9DAC, 0x9DAD, 0x9DAE, 0x9DAF, 0x9DB0,
+	0xBEBD, 0x9DB1, 0x9DB2, 0x9DB3, 0x9DB4, 0x9DB5, 0x9DB6, 0x9DB7,
+	0x9DB8, 0x9DB9, 0x9DBA, 0x9DBB, 0xBEBE, 0xBEBF, 0x9DBC, 0x9DBD,
+	0xBEC0, 0x9DBE, 0x9DBF, 0x9DC0, 0xBEC1, 0x9DC1, 0x9DC2, 0x9DC3,
+	0x9DC4, 0x9DC5, 0x9DC6, 0x9DC7, 0xBEC2, 0xBEC3, 0x9DC8, 0xBEC4,
+	0x9DC9, 0xBEC5, 0x9DCA, 0x9DCB, 0x9DCC, 0x9DCD, 0x9DCE, 0x9DCF,
+	0xBEC6, 0xBEC7, 0x9DD0, 0x9DD1, 0xBEC8, 0xBEC9, 0xBECA, 0x9DD2,
+	0xBECB, 0xBECC, 0xBECD, 0x9DD3, 0x9DD4, 0x9DD5, 0x9DD6, 0xBECE,
+	0xBECF, 0xBED0, 0x9DD7, 0xBED1, 0xBED2, 0xBED3, 0x9DD8, 0x9DD9,
+	0x9DDA, 0xBED4, 0xBED5, 0x9DDB, 0xBED6, 0xBED7, 0x9DDC, 0x9DDD,
+	0xBED8, 0x9DDE, 0x9DDF, 0x9DE0, 0xBED9, 0x9DE1, 0x9DE2, 0x9DE3,
+	0x9DE4, 0x9DE5, 0x9DE6, 0x9DE7, 0xBEDA, 0xBEDB, 0x9DE8, 0xBEDC,
+	0xBEDD, 0xBEDE, 0x9DE9, 0x9DEA, 0x9DEB, 0x9DEC, 0x9DED, 0x9DEE,
+	0xBEDF, 0xBEE0, 0x9DEF, 0x9DF0, 0xBEE1, 0x9DF1, 0x9DF2, 0x9DF3,
+	0xBEE2, 0x9DF4, 0x9DF5, 0xBEE3, 0x9DF6, 0x9DF7, 0x9DF8, 0x9DF9,
+	0xBEE4, 0xBEE5, 0x9DFA, 0xBEE6, 0x9DFB, 0xBEE7, 0x9DFC, 0x9DFD,
+	0x9DFE, 0xBEE8, 0x9E41, 0xBEE9, 0xBEEA, 0x9E42, 0x9E43, 0x9E44,
+	0xBEEB, 0x9E45, 0x9E46, 0x9E47, 0xBEEC, 0x9E48, 0x9E49, 0x9E4A,
+	0x9E4B, 0x9E4C, 0x9E4D, 0x9E4E, 0x9E4F, 0xBEED, 0x9E50, 0x9E51,
+	0x9E52, 0x9E53, 0x9E54, 0x9E55, 0x9E56, 0x9E57, 0x9E58, 0x9E59,
+	0xBEEE, 0xBEEF, 0x9E5A, 0x9E61, 0xBEF0, 0xBEF1, 0x9E62, 0xBEF2,
+	0xBEF3, 0xBEF4, 0xBEF5, 0x9E63, 0x9E64, 0x9E65, 0x9E66, 0x9E67,
+	0xBEF6, 0xBEF7, 0xBEF8, 0xBEF9, 0xBEFA, 0xBEFB, 0xBEFC, 0x9E68,
+	0xBEFD, 0x9E69, 0xBEFE, 0x9E6A, 0xBFA1, 0xBFA2, 0x9E6B, 0x9E6C,
+	0xBFA3, 0x9E6D, 0x9E6E, 0x9E6F, 0xBFA4, 0x9E70, 0x9E71, 0x9E72,
+	0x9E73, 0x9E74, 0x9E75, 0x9E76, 0xBFA5, 0xBFA6, 0x9E77, 0xBFA7,
+	0x9E78, 0xBFA8, 0x9E79, 0x9E7A, 0x9E81, 0x9E82, 0x9E83, 0x9E84,
+	0xBFA9, 0xBFAA, 0xBFAB, 0x9E85, 0xBFAC, 0x9E86, 0x9E87, 0x9E88,
+	0xBFAD, 0x9E89, 0xBFAE, 0xBFAF, 0x9E8A, 0x9E8B, 0x9E8C, 0x9E8D,
+	0xBFB0, 0xBFB1, 0xBFB2, 0xBFB3, 0xBFB4, 0xBFB5, 0x9E8E, 0x9E8F,
+	0x9E90, 0xBFB6, 0xBFB7, 0xBFB8, 0xBFB9, 0x9E91, 0x9E92, 0x9E93,
+	0xBFBA, 0x9E94, 0x9E95, 0x9E96, 0xBFBB, 0x9E97, 0x9E98, 0x9E99,
+	0x9E9A, 0x9E9B, 0x9E9C, 0x9E9D, 0xBFBC, 0xBFBD, 0x9E9E, 0xBFBE,
+	0xBFBF, 0x9E9F, 0x9EA0, 0x9EA1, 0x9EA2, 0x9EA3, 0x9EA4, 0x9EA5,
+	0xBFC0, 0xBFC1, 0x9EA6, 0x9EA7, 0xBFC2, 0x9EA8, 0x9EA9, 0x9EAA,
+	0xBFC3, 0xBFC4, 0xBFC5, 0x9EAB, 0xBFC6, 0x9EAC, 0x9EAD, 0xBFC7,
+	0xBFC8, 0xBFC9, 0x9EAE, 0xBFCA, 0x9EAF, 0xBFCB, 0x9EB0, 0xBFCC,
+	0x9EB1, 0x9EB2, 0x9EB3, 0x9EB4, 0xBFCD, 0xBFCE, 0x9EB5, 0x9EB6,
+	0xBFCF, 0x9EB7, 0x9EB8, 0x9EB9, 0xBFD0, 0x9EBA, 0x9EBB, 0x9EBC,
+	0x9EBD, 0x9EBE, 0x9EBF, 0x9EC0, 0xBFD1, 0xBFD2, 0x9EC1, 0xBFD3,
+	0xBFD4, 0xBFD5, 0x9EC2, 0x9EC3, 0x9EC4, 0x9EC5, 0x9EC6, 0x9EC7,
+	0xBFD6, 0xBFD7, 0x9EC8, 0x9EC9, 0xBFD8, 0x9ECA, 0x9ECB, 0x9ECC,
+	0x9ECD, 0x9ECE, 0x9ECF, 0x9ED0, 0x9ED1, 0x9ED2, 0x9ED3, 0x9ED4,
+	0xBFD9, 0x9ED5, 0x9ED6, 0xBFDA, 0x9ED7, 0xBFDB, 0x9ED8, 0x9ED9,
+	0x9EDA, 0x9EDB, 0x9EDC, 0x9EDD, 0xBFDC, 0xBFDD, 0x9EDE, 0x9EDF,
+	0xBFDE, 0x9EE0, 0x9EE1, 0x9EE2, 0xBFDF, 0x9EE3, 0x9EE4, 0x9EE5,
+	0x9EE6, 0x9EE7, 0x9EE8, 0x9EE9, 0xBFE0, 0xBFE1, 0x9EEA, 0xBFE2,
+	0x9EEB, 0xBFE3, 0x9EEC, 0x9EED, 0x9EEE, 0x9EEF, 0x9EF0, 0x9EF1,
+	0xBFE4, 0xBFE5, 0x9EF2, 0x9EF3, 0xBFE6, 0x9EF4, 0x9EF5, 0x9EF6,
+	0xBFE7, 0x9EF7, 0x9EF8, 0x9EF9, 0x9EFA, 0x9EFB, 0x9EFC, 0x9EFD,
+	0xBFE8, 0xBFE9, 0x9EFE, 0xBFEA, 0x9F41, 0xBFEB, 0x9F42, 0x9F43,
+	0x9F44, 0x9F45, 0x9F46, 0x9F47, 0xBFEC, 0xBFED, 0x9F48, 0x9F49,
+	0xBFEE, 0x9F4A, 0x9F4B, 0x9F4C, 0xBFEF, 0xBFF0, 0xBFF1, 0x9F4D,
+	0x9F4E, 0x9F4F, 0x9F50, 0x9F51, 0xBFF2, 0xBFF3, 0x9F52, 0xBFF4,
+	0x9F53, 0xBFF5, 0x9F54, 0x9F55, 0x9F56, 0x9F57, 0x9F58, 0x9F59,
+	0xBFF6, 0xBFF7, 0x9F5A, 0x9F61, 0xBFF8, 0x9F62, 0x9F63, 0x9F64,
+	0xBFF9, 0x9F65, 0x9F66, 0x9F67, 0x9F68, 0x9F69, 0x9F6A, 0x9F6B,
+	0xBFFA, 0xBFFB, 0x9F6C, 0x9F6D, 0xBFFC, 0xBFFD, 0x9F6E, 0x9F6F,
+	0x9F70, 0x9F71, 0x9F72, 0x9F73, 0xBFFE, 0xC0A1, 0x9F74, 0x9F75,
+	0xC0A2, 0x9F76, 0x9F77, 0x9F78, 0xC0A3, 0x9F79, 0x9F7A, 0x9F81,
+	0x9F82, 0x9F83, 0x9F84, 0x9F85, 0xC0A4, 0xC0A5, 0x9F86, 0x9F87,
+	0x9F88, 0xC0A6, 0x9F89, 0x9F8A, 0x9F8B, 0x9F8C, 0x9F8D, 0x9F8E,
+	0xC0A7, 0xC0A8, 0x9F8F, 0x9F90, 0xC0A9, 0x9F91, 0x9F92, 0x9F93,
+	0xC0AA, 0x9F94, 0x9F95, 0x9F96, 0x9F97, 0x9F98, 0x9F99, 0x9F9A,
+	0xC0AB, 0xC0AC, 0x9F9B, 0xC0AD, 0x9F9C, 0xC0AE, 0x9F9D, 0x9F9E,
+	0x9F9F, 0x9FA0, 0x9FA1, 0x9FA2, 0xC0AF, 0xC0B0, 0x9FA3, 0x9FA4,
+	0xC0B1, 0x9FA5, 0x9FA6, 0x9FA7, 0xC0B2, 0x9FA8, 0x9FA9, 0x9FAA,
+	0x9FAB, 0x9FAC, 0x9FAD, 0x9FAE, 0xC0B3, 0xC0B4, 0x9FAF, 0xC0B5,
+	0x9FB0, 0xC0B6, 0x9FB1, 0xC0B7, 0x9FB2, 0x9FB3, 0x9FB4, 0x9FB5,
+	0xC0B8, 0xC0B9, 0x9FB6, 0x9FB7, 0xC0BA, 0x9FB8, 0x9FB9, 0x9FBA,
+	0xC0BB, 0x9FBB, 0x9FBC, 0x9FBD, 0x9FBE, 0x9FBF, 0xC0BC, 0x9FC0,
+	0xC0BD, 0xC0BE, 0x9FC1, 0xC0BF, 0x9FC2, 0xC0C0, 0xC0C1, 0xC0C2,
+	0xC0C3, 0xC0C4, 0xC0C5, 0xC0C6, 0xC0C7, 0x9FC3, 0x9FC4, 0x9FC5,
+	0xC0C8, 0x9FC6, 0x9FC7, 0x9FC8, 0xC0C9, 0x9FC9, 0x9FCA, 0x9FCB,
+	0x9FCC, 0x9FCD, 0x9FCE, 0x9FCF, 0xC0CA, 0x9FD0, 0x9FD1, 0xC0CB,
+	0x9FD2, 0x9FD3, 0x9FD4, 0x9FD5, 0x9FD6, 0x9FD7, 0x9FD8, 0x9FD9,
+	0xC0CC, 0xC0CD, 0x9FDA, 0x9FDB, 0xC0CE, 0x9FDC, 0x9FDD, 0x9FDE,
+	0xC0CF, 0xC0D0, 0xC0D1, 0x9FDF, 0x9FE0, 0x9FE1, 0x9FE2, 0xC0D2,
+	0xC0D3, 0xC0D4, 0x9FE3, 0xC0D5, 0xC0D6, 0xC0D7, 0xC0D8, 0x9FE4,
+	0x9FE5, 0x9FE6, 0xC0D9, 0x9FE7, 0xC0DA, 0xC0DB, 0x9FE8, 0x9FE9,
+	0xC0DC, 0x9FEA, 0xC0DD, 0xC0DE, 0xC0DF, 0x9FEB, 0xC0E0, 0x9FEC,
+	0x9FED, 0x9FEE, 0x9FEF, 0x9FF0, 0xC0E1, 0xC0E2, 0x9FF1, 0xC0E3,
+	0xC0E4, 0xC0E5, 0xC0E6, 0x9FF2, 0x9FF3, 0x9FF4, 0x9FF5, 0x9FF6,
+	0xC0E7, 0xC0E8, 0x9FF7, 0x9FF8, 0xC0E9, 0x9FF9, 0x9FFA, 0x9FFB,
+	0xC0EA, 0x9FFC, 0x9FFD, 0x9FFE, 0xA041, 0xA042, 0xA043, 0xA044,
+	0xC0EB, 0xC0EC, 0xA045, 0xC0ED, 0xC0EE, 0xC0EF, 0xA046, 0xA047,
+	0xA048, 0xA049, 0xA04A, 0xA04B, 0xC0F0, 0xC0F1, 0xA04C, 0xA04D,
+	0xC0F2, 0xA04E, 0xC0F3, 0xA04F, 0xC0F4, 0xA050, 0xA051, 0xA052,
+	0xA053, 0xA054, 0xA055, 0xA056, 0xC0F5, 0xA057, 0xA058, 0xA059,
+	0xA05A, 0xC0F6, 0xA061, 0xA062, 0xA063, 0xA064, 0xA065, 0xA066,
+	0xC0F7, 0xA067, 0xA068, 0xA069, 0xC0F8, 0xA06A, 0xA06B, 0xA06C,
+	0xC0F9, 0xA06D, 0xA06E, 0xA06F, 0xA070, 0xA071, 0xA072, 0xA073,
+	0xA074, 0xA075, 0xA076, 0xA077, 0xA078, 0xA079, 0xA07A, 0xA081,
+	0xA082, 0xA083, 0xA084, 0xA085, 0xC0FA, 0xC0FB, 0xA086, 0xA087,
+	0xC0FC, 0xA088, 0xA089, 0xA08A, 0xC0FD, 0xA08B, 0xC0FE, 0xA08C,
+	0xA08D, 0xA08E, 0xA08F, 0xA090, 0xC1A1, 0xC1A2, 0xA091, 0xC1A3,
+	0xA092, 0xC1A4, 0xC1A5, 0xA093, 0xA094, 0xA095, 0xA096, 0xA097,
+	0xC1A6, 0xC1A7, 0xA098, 0xA099, 0xC1A8, 0xA09A, 0xA09B, 0xA09C,
+	0xC1A9, 0xA09D, 0xA09E, 0xA09F, 0xA0A0, 0xA0A1, 0xA0A2, 0xA0A3,
+	0xC1AA, 0xC1AB, 0xA0A4, 0xC1AC, 0xA0A5, 0xC1AD, 0xA0A6, 0xA0A7,
+	0xA0A8, 0xA0A9, 0xA0AA, 0xA0AB, 0xC1AE, 0xA0AC, 0xA0AD, 0xA0AE,
+	0xC1AF, 0xA0AF, 0xA0B0, 0xA0B1, 0xC1B0, 0xA0B2, 0xA0B3, 0xA0B4,
+	0xA0B5, 0xA0B6, 0xA0B7, 0xA0B8, 0xC1B1, 0xC1B2, 0xA0B9, 0xA0BA,
+	0xC1B3, 0xC1B4, 0xA0BB, 0xA0BC, 0xA0BD, 0xA0BE, 0xA0BF, 0xA0C0,
+	0xC1B5, 0xA0C1, 0xA0C2, 0xA0C3, 0xA0C4, 0xA0C5, 0xA0C6, 0xA0C7,
+	0xA0C8, 0xA0C9, 0xA0CA, 0xA0CB, 0xA0CC, 0xA0CD, 0xA0CE, 0xA0CF,
+	0xA0D0, 0xA0D1, 0xA0D2, 0xA0D3, 0xA0D4, 0xA0D5, 0xA0D6, 0xA0D7,
+	0xA0D8, 0xA0D9, 0xA0DA, 0xA0DB, 0xC1B6, 0xC1B7, 0xA0DC, 0xA0DD,
+	0xC1B8, 0xA0DE, 0xA0DF, 0xA0E0, 0xC1B9, 0xA0E1, 0xC1BA, 0xA0E2,
+	0xA0E3, 0xA0E4, 0xA0E5, 0xA0E6, 0xC1BB, 0xC1BC, 0xA0E7, 0xC1BD,
+	0xA0E8, 0xC1BE, 0xC1BF, 0xC1C0, 0xA0E9, 0xA0EA, 0xA0EB, 0xC1C1,
+	0xC1C2, 0xC1C3, 0xA0EC, 0xA0ED, 0xA0EE, 0xA0EF, 0xA0F0, 0xA0F1,
+	0xC1C4, 0xA0F2, 0xA0F3, 0xA0F4, 0xA0F5, 0xA0F6, 0xA0F7, 0xA0F8,
+	0xA0F9, 0xC1C5, 0xA0FA, 0xC1C6, 0xA0FB, 0xC1C7, 0xA0FC, 0xA0FD,
+	0xA0FE, 0xA141, 0xA142, 0xA143, 0xC1C8, 0xA144, 0xA145, 0xA146,
+	0xA147, 0xA148, 0xA149, 0xA14A, 0xA14B, 0xA14C, 0xA14D, 0xA14E,
+	0xA14F, 0xA150, 0xA151, 0xA152, 0xA153, 0xA154, 0xA155, 0xA156,
+	0xC1C9, 0xC1CA, 0xA157, 0xA158, 0xA159, 0xA15A, 0xA161, 0xA162,
+	0xC1CB, 0xA163, 0xA164, 0xA165, 0xC1CC, 0xA166, 0xA167, 0xA168,
+	0xC1CD, 0xA169, 0xA16A, 0xA16B, 0xA16C, 0xA16D, 0xA16E, 0xA16F,
+	0xC1CE, 0xC1CF, 0xA170, 0xC1D0, 0xA171, 0xC1D1, 0xA172, 0xA173,
+	0xA174, 0xA175, 0xA176, 0xA177, 0xC1D2, 0xC1D3, 0xA178, 0xA179,
+	0xC1D4, 0xA17A, 0xA181, 0xA182, 0xA183, 0xA184, 0xA185, 0xA186,
+	0xA187, 0xA188, 0xA189, 0xA18A, 0xA18B, 0xA18C, 0xA18D, 0xA18E,
+	0xA18F, 0xC1D5, 0xA190, 0xA191, 0xA192, 0xA193, 0xA194, 0xA195,
+	0xC1D6, 0xC1D7, 0xA196, 0xA197, 0xC1D8, 0xA198, 0xA199, 0xA19A,
+	0xC1D9, 0xC1DA, 0xC1DB, 0xA19B, 0xA19C, 0xA19D, 0xA19E, 0xA19F,
+	0xC1DC, 0xC1DD, 0xA1A0, 0xC1DE, 0xA241, 0xC1DF, 0xA242, 0xA243,
+	0xA244, 0xA245, 0xA246, 0xA247, 0xC1E0, 0xA248, 0xA249, 0xA24A,
+	0xA24B, 0xA24C, 0xA24D, 0xA24E, 0xA24F, 0xA250, 0xA251, 0xA252,
+	0xA253, 0xA254, 0xA255, 0xA256, 0xA257, 0xA258, 0xA259, 0xA25A,
+	0xC1E1, 0xA261, 0xA262, 0xA263, 0xA264, 0xA265, 0xA266, 0xA267,
+	0xC1E2, 0xA268, 0xA269, 0xA26A, 0xA26B, 0xA26C, 0xA26D, 0xA26E,
+	0xA26F, 0xA270, 0xA271, 0xA272, 0xA273, 0xA274, 0xA275, 0xA276,
+	0xA277, 0xA278, 0xA279, 0xA27A, 0xA281, 0xA282, 0xA283, 0xA284,
+	0xA285, 0xA286, 0xA287, 0xA288, 0xC1E3, 0xC1E4, 0xA289, 0xA28A,
+	0xC1E5, 0xA28B, 0xA28C, 0xA28D, 0xC1E6, 0xA28E, 0xA28F, 0xA290,
+	0xA291, 0xA292, 0xA293, 0xA294, 0xC1E7, 0xC1E8, 0xA295, 0xC1E9,
+	0xA296, 0xA297, 0xA298, 0xA299, 0xA29A, 0xA29B, 0xA29C, 0xA29D,
+	0xC1EA, 0xA29E, 0xA29F, 0xA2A0, 0xC1EB, 0xA341, 0xA342, 0xA343,
+	0xC1EC, 0xA344, 0xA345, 0xA346, 0xA347, 0xA348, 0xA349, 0xA34A,
+	0xC1ED, 0xA34B, 0xA34C, 0xA34D, 0xA34E, 0xA34F, 0xA350, 0xA351,
+	0xA352, 0xA353, 0xA354, 0xA355, 0xC1EE, 0xC1EF, 0xA356, 0xA357,
+	0xC1F0, 0xA358, 0xA359, 0xA35A, 0xC1F1, 0xA361, 0xA362, 0xA363,
+	0xA364, 0xA365, 0xA366, 0xA367, 0xC1F2, 0xC1F3, 0xA368, 0xC1F4,
+	0xA369, 0xC1F5, 0xA36A, 0xA36B, 0xA36C, 0xA36D, 0xA36E, 0xA36F,
+	0xA370, 0xA371, 0xA372, 0xA373, 0xA374, 0xA375, 0xA376, 0xA377,
+	0xA378, 0xA379, 0xA37A, 0xA381, 0xA382, 0xA383, 0xA384, 0xA385,
+	0xA386, 0xA387, 0xA388, 0xA389, 0xA38A, 0xA38B, 0xA38C, 0xA38D,
+	0xA38E, 0xA38F, 0xA390, 0xA391, 0xC1F6, 0xC1F7, 0xA392, 0xA393,
+	0xC1F8, 0xA394, 0xA395, 0xC1F9, 0xC1FA, 0xA396, 0xC1FB, 0xA397,
+	0xA398, 0xA399, 0xA39A, 0xA39B, 0xC1FC, 0xC1FD, 0xA39C, 0xC1FE,
+	0xA39D, 0xC2A1, 0xC2A2, 0xA39E, 0xA39F, 0xC2A3, 0xC2A4, 0xA3A0,
+	0xC2A5, 0xC2A6, 0xA441, 0xA442, 0xC2A7, 0xA443, 0xC2A8, 0xA444,
+	0xC2A9, 0xA445, 0xA446, 0xC2AA, 0xA447, 0xA448, 0xA449, 0xA44A,
+	0xC2AB, 0xC2AC, 0xA44B, 0xC2AD, 0xC2AE, 0xC2AF, 0xA44C, 0xA44D,
+	0xA44E, 0xA44F, 0xA450, 0xA451, 0xC2B0, 0xC2B1, 0xA452, 0xA453,
+	0xC2B2, 0xA454, 0xA455, 0xA456, 0xC2B3, 0xA457, 0xA458, 0xA459,
+	0xA45A, 0xA461, 0xA462, 0xA463, 0xC2B4, 0xC2B5, 0xA464, 0xC2B6,
+	0xC2B7, 0xC2B8, 0xA465, 0xA466, 0xA467, 0xA468, 0xA469, 0xA46A,
+	0xC2B9, 0xA46B, 0xA46C, 0xA46D, 0xC2BA, 0xA46E, 0xA46F, 0xA470,
+	0xA471, 0xA472, 0xA473, 0xA474, 0xA475, 0xA476, 0xA477, 0xA478,
+	0xA479, 0xA47A, 0xA481, 0xA482, 0xA483, 0xC2BB, 0xA484, 0xA485,
+	0xA486, 0xA487, 0xA488, 0xA489, 0xA48A, 0xA48B, 0xA48C, 0xA48D,
+	0xA48E, 0xA48F, 0xA490, 0xA491, 0xA492, 0xA493, 0xA494, 0xA495,
+	0xA496, 0xA497, 0xA498, 0xA499, 0xA49A, 0xA49B, 0xA49C, 0xA49D,
+	0xA49E, 0xA49F, 0xA4A0, 0xA541, 0xA542, 0xA543, 0xA544, 0xA545,
+	0xC2BC, 0xC2BD, 0xA546, 0xA547, 0xC2BE, 0xA548, 0xA549, 0xA54A,
+	0xC2BF, 0xA54B, 0xA54C, 0xA54D, 0xA54E, 0xA54F, 0xA550, 0xA551,
+	0xC2C0, 0xC2C1, 0xA552, 0xC2C2, 0xC2C3, 0xC2C4, 0xA553, 0xA554,
+	0xA555, 0xA556, 0xA557, 0xA558, 0xC2C5, 0xA559, 0xA55A, 0xA561,
+	0xA562, 0xA563, 0xA564, 0xA565, 0xA566, 0xA567, 0xA568, 0xA569,
+	0xA56A, 0xA56B, 0xA56C, 0xA56D, 0xA56E, 0xA56F, 0xA570, 0xA571,
+	0xA572, 0xC2C6, 0xA573, 0xA574, 0xA575, 0xA576, 0xA577, 0xA578,
+	0xC2C7, 0xA579, 0xA57A, 0xA581, 0xA582, 0xA583, 0xA584, 0xA585,
+	0xA586, 0xA587, 0xA588, 0xA589, 0xA58A, 0xA58B, 0xA58C, 0xA58D,
+	0xA58E, 0xA58F, 0xA590, 0xA591, 0xC2C8, 0xA592, 0xA593, 0xA594,
+	0xA595, 0xA596, 0xA597, 0xA598, 0xA599, 0xA59A, 0xA59B, 0xA59C,
+	0xA59D, 0xA59E, 0xA59F, 0xA5A0, 0xA641, 0xA642, 0xA643, 0xA644,
+	0xA645, 0xA646, 0xA647, 0xA648, 0xA649, 0xA64A, 0xA64B, 0xA64C,
+	0xA64D, 0xA64E, 0xA64F, 0xA650, 0xA651, 0xA652, 0xA653, 0xA654,
+	0xC2C9, 0xC2CA, 0xA655, 0xA656, 0xC2CB, 0xA657, 0xA658, 0xA659,
+	0xC2CC, 0xA65A, 0xA661, 0xA662, 0xA663, 0xA664, 0xA665, 0xA666,
+	0xC2CD, 0xC2CE, 0xA667, 0xC2CF, 0xA668, 0xC2D0, 0xA669, 0xC2D1,
+	0xA66A, 0xA66B, 0xA66C, 0xA66D, 0xC2D2, 0xC2D3, 0xA66E, 0xA66F,
+	0xA670, 0xA671, 0xA672, 0xA673, 0xC2D4, 0xA674, 0xA675, 0xA676,
+	0xA677, 0xA678, 0xA679, 0xA67A, 0xA681, 0xA682, 0xA683, 0xA684,
+	0xC2D5, 0xA685, 0xA686, 0xA687, 0xA688, 0xA689, 0xA68A, 0xA68B,
+	0xC2D6, 0xA68C, 0xA68D, 0xA68E, 0xA68F, 0xA690, 0xA691, 0xA692,
+	0xA693, 0xA694, 0xA695, 0xA696, 0xA697, 0xA698, 0xA699, 0xA69A,
+	0xA69B, 0xA69C, 0xA69D, 0xA69E, 0xC2D7, 0xA69F, 0xA6A0, 0xA741,
+	0xA742, 0xA743, 0xA744, 0xA745, 0xC2D8, 0xA746, 0xA747, 0xA748,
+	0xC2D9, 0xA749, 0xA74A, 0xA74B, 0xC2DA, 0xA74C, 0xA74D, 0xA74E,
+	0xA74F, 0xA750, 0xA751, 0xA752, 0xC2DB, 0xC2DC, 0xA753, 0xA754,
+	0xA755, 0xA756, 0xA757, 0xA758, 0xA759, 0xA75A, 0xA761, 0xA762,
+	0xA763, 0xA764, 0xA765, 0xA766, 0xA767, 0xA768, 0xA769, 0xA76A,
+	0xA76B, 0xA76C, 0xA76D, 0xA76E, 0xA76F, 0xA770, 0xA771, 0xA772,
+	0xA773, 0xA774, 0xA775, 0xA776, 0xA777, 0xC2DD, 0xA778, 0xA779,
+	0xA77A, 0xA781, 0xA782, 0xA783, 0xC2DE, 0xC2DF, 0xA784, 0xA785,
+	0xC2E0, 0xA786, 0xA787, 0xA788, 0xC2E1, 0xA789, 0xA78A, 0xA78B,
+	0xA78C, 0xA78D, 0xA78E, 0xA78F, 0xC2E2, 0xC2E3, 0xA790, 0xA791,
+	0xA792, 0xC2E4, 0xA793, 0xA794, 0xA795, 0xA796, 0xA797, 0xA798,
+	0xC2E5, 0xA799, 0xA79A, 0xA79B, 0xA79C, 0xA79D, 0xA79E, 0xA79F,
+	0xA7A0, 0xA841, 0xA842, 0xA843, 0xA844, 0xA845, 0xA846, 0xA847,
+	0xA848, 0xA849, 0xA84A, 0xA84B, 0xC2E6, 0xC2E7, 0xA84C, 0xA84D,
+	0xA84E, 0xA84F, 0xA850, 0xA851, 0xA852, 0xA853, 0xA854, 0xA855,
+	0xA856, 0xA857, 0xA858, 0xA859, 0xA85A, 0xA861, 0xA862, 0xA863,
+	0xA864, 0xA865, 0xA866, 0xA867, 0xA868, 0xA869, 0xA86A, 0xA86B,
+	0xA86C, 0xA86D, 0xA86E, 0xA86F, 0xA870, 0xA871, 0xA872, 0xA873,
+	0xC2E8, 0xA874, 0xA875, 0xA876, 0xA877, 0xA878, 0xA879, 0xA87A,
+	0xA881, 0xA882, 0xA883, 0xA884, 0xA885, 0xA886, 0xA887, 0xA888,
+	0xA889, 0xA88A, 0xA88B, 0xA88C, 0xA88D, 0xA88E, 0xA88F, 0xA890,
+	0xA891, 0xA892, 0xA893, 0xA894, 0xC2E9, 0xA895, 0xA896, 0xA897,
+	0xA898, 0xA899, 0xA89A, 0xA89B, 0xA89C, 0xA89D, 0xA89E, 0xA89F,
+	0xA8A0, 0xA941, 0xA942, 0xA943, 0xA944, 0xA945, 0xA946, 0xA947,
+	0xA948, 0xA949, 0xA94A, 0xA94B, 0xA94C, 0xA94D, 0xA94E, 0xA94F,
+	0xC2EA, 0xA950, 0xA951, 0xA952, 0xA953, 0xA954, 0xA955, 0xA956,
+	0xA957, 0xA958, 0xA959, 0xA95A, 0xA961, 0xA962, 0xA963, 0xA964,
+	0xC2EB, 0xA965, 0xA966, 0xC2EC, 0xA967, 0xC2ED, 0xA968, 0xA969,
+	0xA96A, 0xA96B, 0xA96C, 0xA96D, 0xA96E, 0xA96F, 0xA970, 0xA971,
+	0xA972, 0xA973, 0xA974, 0xA975, 0xA976, 0xA977, 0xA978, 0xA979,
+	0xA97A, 0xA981, 0xA982, 0xA983, 0xA984, 0xA985, 0xA986, 0xA987,
+	0xA988, 0xA989, 0xA98A, 0xA98B, 0xA98C, 0xA98D, 0xA98E, 0xA98F,
+	0xC2EE, 0xC2EF, 0xA990, 0xA991, 0xC2F0, 0xA992, 0xA993, 0xA994,
+	0xC2F1, 0xA995, 0xA996, 0xA997, 0xA998, 0xA999, 0xA99A, 0xA99B,
+	0xC2F2, 0xC2F3, 0xA99C, 0xA99D, 0xA99E, 0xC2F4, 0xC2F5, 0xA99F,
+	0xA9A0, 0xAA41, 0xAA42, 0xC2F6, 0xC2F7, 0xC2F8, 0xAA43, 0xAA44,
+	0xC2F9, 0xAA45, 0xC2FA, 0xAA46, 0xC2FB, 0xAA47, 0xAA48, 0xAA49,
+	0xAA4A, 0xAA4B, 0xAA4C, 0xAA4D, 0xC2FC, 0xC2FD, 0xAA4E, 0xC2FE,
+	0xC3A1, 0xC3A2, 0xC3A3, 0xAA4F, 0xAA50, 0xAA51, 0xAA52, 0xAA53,
+	0xC3A4, 0xC3A5, 0xAA54, 0xAA55, 0xC3A6, 0xAA56, 0xAA57, 0xAA58,
+	0xC3A7, 0xAA59, 0xAA5A, 0xAA61, 0xAA62, 0xAA63, 0xAA64, 0xAA65,
+	0xC3A8, 0xC3A9, 0xAA66, 0xC3AA, 0xC3AB, 0xC3AC, 0xAA67, 0xAA68,
+	0xAA69, 0xAA6A, 0xAA6B, 0xAA6C, 0xC3AD, 0xAA6D, 0xAA6E, 0xAA6F,
+	0xC3AE, 0xAA70, 0xC3AF, 0xAA71, 0xC3B0, 0xAA72, 0xAA73, 0xAA74,
+	0xAA75, 0xAA76, 0xAA77, 0xAA78, 0xC3B1, 0xAA79, 0xAA7A, 0xAA81,
+	0xAA82, 0xC3B2, 0xAA83, 0xAA84, 0xAA85, 0xAA86, 0xAA87, 0xAA88,
+	0xAA89, 0xAA8A, 0xAA8B, 0xAA8C, 0xAA8D, 0xAA8E, 0xAA8F, 0xAA90,
+	0xAA91, 0xAA92, 0xAA93, 0xAA94, 0xAA95, 0xAA96, 0xAA97, 0xAA98,
+	0xAA99, 0xAA9A, 0xAA9B, 0xAA9C, 0xAA9D, 0xAA9E, 0xAA9F, 0xAAA0,
+	0xAB41, 0xAB42, 0xAB43, 0xAB44, 0xC3B3, 0xC3B4, 0xAB45, 0xAB46,
+	0xC3B5, 0xAB47, 0xAB48, 0xAB49, 0xC3B6, 0xAB4A, 0xAB4B, 0xAB4C,
+	0xAB4D, 0xAB4E, 0xAB4F, 0xAB50, 0xC3B7, 0xC3B8, 0xAB51, 0xC3B9,
+	0xC3BA, 0xC3BB, 0xAB52, 0xAB53, 0xAB54, 0xAB55, 0xAB56, 0xAB57,
+	0xC3BC, 0xC3BD, 0xAB58, 0xAB59, 0xC3BE, 0xAB5A, 0xAB61, 0xAB62,
+	0xC3BF, 0xAB63, 0xAB64, 0xAB65, 0xAB66, 0xAB67, 0xAB68, 0xAB69,
+	0xC3C0, 0xC3C1, 0xAB6A, 0xC3C2, 0xAB6B, 0xC3C3, 0xAB6C, 0xAB6D,
+	0xAB6E, 0xAB6F, 0xAB70, 0xAB71, 0xC3C4, 0xAB72, 0xAB73, 0xAB74,
+	0xC3C5, 0xAB75, 0xAB76, 0xAB77, 0xAB78, 0xAB79, 0xAB7A, 0xAB81,
+	0xAB82, 0xAB83, 0xAB84, 0xAB85, 0xAB86, 0xAB87, 0xAB88, 0xAB89,
+	0xC3C6, 0xAB8A, 0xAB8B, 0xAB8C, 0xAB8D, 0xAB8E, 0xAB8F, 0xAB90,
+	0xC3C7, 0xAB91, 0xAB92, 0xAB93, 0xC3C8, 0xAB94, 0xAB95, 0xAB96,
+	0xAB97, 0xAB98, 0xAB99, 0xAB9A, 0xAB9B, 0xAB9C, 0xAB9D, 0xAB9E,
+	0xAB9F, 0xABA0, 0xAC41, 0xAC42, 0xAC43, 0xC3C9, 0xAC44, 0xAC45,
+	0xAC46, 0xAC47, 0xAC48, 0xAC49, 0xC3CA, 0xC3CB, 0xAC4A, 0xAC4B,
+	0xC3CC, 0xAC4C, 0xAC4D, 0xAC4E, 0xC3CD, 0xAC4F, 0xAC50, 0xAC51,
+	0xAC52, 0xAC53, 0xAC54, 0xAC55, 0xC3CE, 0xC3CF, 0xAC56, 0xC3D0,
+	0xAC57, 0xC3D1, 0xAC58, 0xAC59, 0xAC5A, 0xAC61, 0xAC62, 0xAC63,
+	0xC3D2, 0xAC64, 0xAC65, 0xAC66, 0xC3D3, 0xAC67, 0xAC68, 0xAC69,
+	0xC3D4, 0xAC6A, 0xAC6B, 0xAC6C, 0xAC6D, 0xAC6E, 0xAC6F, 0xAC70,
+	0xAC71, 0xAC72, 0xAC73, 0xAC74, 0xAC75, 0xC3D5, 0xAC76, 0xAC77,
+	0xAC78, 0xAC79, 0xAC7A, 0xAC81, 0xAC82, 0xAC83, 0xAC84, 0xAC85,
+	0xAC86, 0xAC87, 0xAC88, 0xAC89, 0xAC8A, 0xAC8B, 0xAC8C, 0xAC8D,
+	0xAC8E, 0xAC8F, 0xAC90, 0xAC91, 0xAC92, 0xAC93, 0xAC94, 0xAC95,
+	0xAC96, 0xAC97, 0xAC98, 0xAC99, 0xAC9A, 0xAC9B, 0xAC9C, 0xAC9D,
+	0xC3D6, 0xAC9E, 0xAC9F, 0xACA0, 0xC3D7, 0xAD41, 0xAD42, 0xAD43,
+	0xC3D8, 0xAD44, 0xAD45, 0xAD46, 0xAD47, 0xAD48, 0xAD49, 0xAD4A,
+	0xC3D9, 0xC3DA, 0xAD4B, 0xC3DB, 0xAD4C, 0xC3DC, 0xAD4D, 0xAD4E,
+	0xAD4F, 0xAD50, 0xAD51, 0xAD52, 0xC3DD, 0xAD53, 0xAD54, 0xAD55,
+	0xAD56, 0xAD57, 0xAD58, 0xAD59, 0xAD5A, 0xAD61, 0xAD62, 0xAD63,
+	0xAD64, 0xAD65, 0xAD66, 0xAD67, 0xC3DE, 0xAD68, 0xAD69, 0xAD6A,
+	0xAD6B, 0xAD6C, 0xAD6D, 0xAD6E, 0xAD6F, 0xAD70, 0xAD71, 0xAD72,
+	0xC3DF, 0xC3E0, 0xAD73, 0xAD74, 0xC3E1, 0xAD75, 0xAD76, 0xAD77,
+	0xC3E2, 0xAD78, 0xAD79, 0xAD7A, 0xAD81, 0xAD82, 0xAD83, 0xAD84,
+	0xC3E3, 0xC3E4, 0xAD85, 0xC3E5, 0xAD86, 0xC3E6, 0xAD87, 0xAD88,
+	0xAD89, 0xAD8A, 0xAD8B, 0xAD8C, 0xC3E7, 0xAD8D, 0xAD8E, 0xAD8F,
+	0xAD90, 0xAD91, 0xAD92, 0xAD93, 0xAD94, 0xAD95, 0xAD96, 0xAD97,
+	0xAD98, 0xAD99, 0xAD9A, 0xAD9B, 0xAD9C, 0xAD9D, 0xAD9E, 0xAD9F,
+	0xC3E8, 0xADA0, 0xAE41, 0xAE42, 0xAE43, 0xAE44, 0xAE45, 0xAE46,
+	0xC3E9, 0xAE47, 0xAE48, 0xAE49, 0xC3EA, 0xAE4A, 0xAE4B, 0xAE4C,
+	0xAE4D, 0xAE4E, 0xAE4F, 0xAE50, 0xAE51, 0xAE52, 0xAE53, 0xAE54,
+	0xAE55, 0xAE56, 0xAE57, 0xAE58, 0xAE59, 0xAE5A, 0xAE61, 0xAE62,
+	0xAE63, 0xAE64, 0xAE65, 0xAE66, 0xC3EB, 0xAE67, 0xAE68, 0xAE69,
+	0xC3EC, 0xAE6A, 0xAE6B, 0xAE6C, 0xC3ED, 0xAE6D, 0xAE6E, 0xAE6F,
+	0xAE70, 0xAE71, 0xAE72, 0xAE73, 0xC3EE, 0xC3EF, 0xAE74, 0xC3F0,
+	0xAE75, 0xC3F1, 0xAE76, 0xAE77, 0xAE78, 0xAE79, 0xAE7A, 0xAE81,
+	0xC3F2, 0xAE82, 0xAE83, 0xAE84, 0xC3F3, 0xAE85, 0xAE86, 0xAE87,
+	0xC3F4, 0xAE88, 0xAE89, 0xAE8A, 0xAE8B, 0xAE8C, 0xAE8D, 0xAE8E,
+	0xC3F5, 0xAE8F, 0xAE90, 0xAE91, 0xAE92, 0xC3F6, 0xAE93, 0xAE94,
+	0xAE95, 0xAE96, 0xAE97, 0xAE98, 0xC3F7, 0xC3F8, 0xAE99, 0xAE9A,
+	0xC3F9, 0xAE9B, 0xAE9C, 0xAE9D, 0xC3FA, 0xAE9E, 0xAE9F, 0xAEA0,
+	0xAF41, 0xAF42, 0xAF43, 0xAF44, 0xC3FB, 0xC3FC, 0xAF45, 0xC3FD,
+	0xAF46, 0xC3FE, 0xAF47, 0xAF48, 0xAF49, 0xAF4A, 0xAF4B, 0xAF4C,
+	0xAF4D, 0xAF4E, 0xAF4F, 0xAF50, 0xAF51, 0xAF52, 0xAF53, 0xAF54,
+	0xAF55, 0xAF56, 0xAF57, 0xAF58, 0xAF59, 0xAF5A, 0xAF61, 0xAF62,
+	0xAF63, 0xAF64, 0xAF65, 0xAF66, 0xAF67, 0xAF68, 0xAF69, 0xAF6A,
+	0xAF6B, 0xAF6C, 0xAF6D, 0xAF6E, 0xC4A1, 0xC4A2, 0xAF6F, 0xAF70,
+	0xC4A3, 0xAF71, 0xAF72, 0xC4A4, 0xC4A5, 0xC4A6, 0xAF73, 0xAF74,
+	0xAF75, 0xAF76, 0xAF77, 0xAF78, 0xC4A7, 0xC4A8, 0xAF79, 0xC4A9,
+	0xAF7A, 0xC4AA, 0xAF81, 0xAF82, 0xAF83, 0xAF84, 0xAF85, 0xAF86,
+	0xC4AB, 0xC4AC, 0xAF87, 0xAF88, 0xC4AD, 0xAF89, 0xAF8A, 0xAF8B,
+	0xC4AE, 0xAF8C, 0xAF8D, 0xAF8E, 0xAF8F, 0xAF90, 0xAF91, 0xAF92,
+	0xC4AF, 0xC4B0, 0xAF93, 0xC4B1, 0xAF94, 0xC4B2, 0xAF95, 0xAF96,
+	0xAF97, 0xAF98, 0xAF99, 0xAF9A, 0xC4B3, 0xC4B4, 0xAF9B, 0xAF9C,
+	0xC4B5, 0xAF9D, 0xAF9E, 0xAF9F, 0xC4B6, 0xAFA0, 0xB041, 0xB042,
+	0xB043, 0xB044, 0xB045, 0xB046, 0xC4B7, 0xC4B8, 0xB047, 0xC4B9,
+	0xC4BA, 0xC4BB, 0xB048, 0xB049, 0xB04A, 0xB04B, 0xB04C, 0xB04D,
+	0xC4BC, 0xC4BD, 0xB04E, 0xB04F, 0xB050, 0xB051, 0xB052, 0xB053,
+	0xB054, 0xB055, 0xB056, 0xB057, 0xB058, 0xB059, 0xB05A, 0xB061,
+	0xB062, 0xB063, 0xB064, 0xB065, 0xB066, 0xC4BE, 0xB067, 0xB068,
+	0xB069, 0xB06A, 0xB06B, 0xB06C, 0xB06D, 0xB06E, 0xB06F, 0xB070,
+	0xB071, 0xB072, 0xB073, 0xB074, 0xB075, 0xB076, 0xB077, 0xB078,
+	0xB079, 0xB07A, 0xB081, 0xB082, 0xB083, 0xB084, 0xB085, 0xB086,
+	0xB087, 0xB088, 0xB089, 0xB08A, 0xB08B, 0xB08C, 0xB08D, 0xB08E,
+	0xC4BF, 0xC4C0, 0xB08F, 0xB090, 0xC4C1, 0xB091, 0xB092, 0xC4C2,
+	0xC4C3, 0xB093, 0xB094, 0xB095, 0xB096, 0xB097, 0xB098, 0xB099,
+	0xC4C4, 0xC4C5, 0xB09A, 0xC4C6, 0xC4C7, 0xC4C8, 0xB09B, 0xB09C,
+	0xB09D, 0xB09E, 0xB09F, 0xB0A0, 0xC4C9, 0xC4CA, 0xB141, 0xB142,
+	0xC4CB, 0xB143, 0xB144, 0xB145, 0xC4CC, 0xB146, 0xB147, 0xB148,
+	0xB149, 0xB14A, 0xB14B, 0xB14C, 0xC4CD, 0xC4CE, 0xB14D, 0xC4CF,
+	0xB14E, 0xC4D0, 0xB14F, 0xB150, 0xB151, 0xB152, 0xB153, 0xB154,
+	0xC4D1, 0xB155, 0xB156, 0xB157, 0xC4D2, 0xB158, 0xB159, 0xB15A,
+	0xC4D3, 0xB161, 0xB162, 0xB163, 0xB164, 0xB165, 0xB166, 0xB167,
+	0xC4D4, 0xC4D5, 0xB168, 0xC4D6, 0xC4D7, 0xC4D8, 0xB169, 0xB16A,
+	0xB16B, 0xB16C, 0xB16D, 0xB16E, 0xC4D9, 0xB16F, 0xB170, 0xB171,
+	0xB172, 0xB173, 0xB174, 0xB175, 0xB176, 0xB177, 0xB178, 0xB179,
+	0xB17A, 0xB181, 0xB182, 0xB183, 0xB184, 0xB185, 0xB186, 0xB187,
+	0xB188, 0xB189, 0xB18A, 0xB18B, 0xB18C, 0xB18D, 0xB18E, 0xB18F,
+	0xC4DA, 0xC4DB, 0xB190, 0xB191, 0xC4DC, 0xB192, 0xB193, 0xB194,
+	0xC4DD, 0xB195, 0xB196, 0xB197, 0xB198, 0xB199, 0xB19A, 0xB19B,
+	0xC4DE, 0xC4DF, 0xB19C, 0xC4E0, 0xB19D, 0xC4E1, 0xB19E, 0xB19F,
+	0xB1A0, 0xB241, 0xB242, 0xB243, 0xC4E2, 0xC4E3, 0xB244, 0xB245,
+	0xC4E4, 0xB246, 0xB247, 0xB248, 0xC4E5, 0xB249, 0xB24A, 0xB24B,
+	0xB24C, 0xB24D, 0xB24E, 0xB24F, 0xC4E6, 0xB250, 0xB251, 0xB252,
+	0xB253, 0xC4E7, 0xB254, 0xB255, 0xB256, 0xB257, 0xB258, 0xB259,
+	0xC4E8, 0xB25A, 0xB261, 0xB262, 0xB263, 0xB264, 0xB265, 0xB266,
+	0xB267, 0xB268, 0xB269, 0xB26A, 0xB26B, 0xB26C, 0xB26D, 0xB26E,
+	0xB26F, 0xB270, 0xB271, 0xB272, 0xB273, 0xC4E9, 0xB274, 0xB275,
+	0xB276, 0xB277, 0xB278, 0xB279, 0xC4EA, 0xB27A, 0xB281, 0xB282,
+	0xB283, 0xB284, 0xB285, 0xB286, 0xC4EB, 0xB287, 0xB288, 0xB289,
+	0xB28A, 0xB28B, 0xB28C, 0xB28D, 0xB28E, 0xB28F, 0xB290, 0xB291,
+	0xB292, 0xB293, 0xB294, 0xB295, 0xB296, 0xB297, 0xB298, 0xB299,
+	0xC4EC, 0xB29A, 0xB29B, 0xB29C, 0xB29D, 0xB29E, 0xB29F, 0xB2A0,
+	0xB341, 0xB342, 0xB343, 0xB344, 0xB345, 0xB346, 0xB347, 0xB348,
+	0xB349, 0xB34A, 0xB34B, 0xB34C, 0xB34D, 0xB34E, 0xB34F, 0xB350,
+	0xB351, 0xB352, 0xB353, 0xB354, 0xC4ED, 0xC4EE, 0xB355, 0xB356,
+	0xC4EF, 0xB357, 0xB358, 0xB359, 0xC4F0, 0xB35A, 0xB361, 0xB362,
+	0xB363, 0xB364, 0xB365, 0xB366, 0xC4F1, 0xC4F2, 0xB367, 0xC4F3,
+	0xB368, 0xC4F4, 0xB369, 0xB36A, 0xB36B, 0xB36C, 0xB36D, 0xB36E,
+	0xC4F5, 0xB36F, 0xB370, 0xB371, 0xC4F6, 0xB372, 0xB373, 0xB374,
+	0xC4F7, 0xB375, 0xB376, 0xB377, 0xB378, 0xB379, 0xB37A, 0xB381,
+	0xB382, 0xB383, 0xB384, 0xB385, 0xB386, 0xC4F8, 0xB387, 0xB388,
+	0xB389, 0xB38A, 0xB38B, 0xB38C, 0xC4F9, 0xB38D, 0xB38E, 0xB38F,
+	0xB390, 0xB391, 0xB392, 0xB393, 0xB394, 0xB395, 0xB396, 0xB397,
+	0xB398, 0xB399, 0xB39A, 0xB39B, 0xB39C, 0xB39D, 0xB39E, 0xB39F,
+	0xB3A0, 0xC4FA, 0xB441, 0xB442, 0xB443, 0xB444, 0xB445, 0xB446,
+	0xC4FB, 0xC4FC, 0xB447, 0xB448, 0xC4FD, 0xB449, 0xB44A, 0xB44B,
+	0xC4FE, 0xB44C, 0xB44D, 0xB44E, 0xB44F, 0xB450, 0xB451, 0xB452,
+	0xC5A1, 0xC5A2, 0xB453, 0xC5A3, 0xB454, 0xC5A4, 0xB455, 0xB456,
+	0xB457, 0xB458, 0xB459, 0xB45A, 0xC5A5, 0xB461, 0xB462, 0xB463,
+	0xC5A6, 0xB464, 0xB465, 0xB466, 0xC5A7, 0xB467, 0xB468, 0xB469,
+	0xB46A, 0xB46B, 0xB46C, 0xB46D, 0xC5A8, 0xB46E, 0xB46F, 0xB470,
+	0xB471, 0xB472, 0xB473, 0xB474, 0xB475, 0xB476, 0xB477, 0xB478,
+	0xC5A9, 0xC5AA, 0xB479, 0xB47A, 0xC5AB, 0xB481, 0xB482, 0xB483,
+	0xC5AC, 0xB484, 0xB485, 0xB486, 0xB487, 0xB488, 0xB489, 0xB48A,
+	0xC5AD, 0xC5AE, 0xB48B, 0xB48C, 0xB48D, 0xC5AF, 0xB48E, 0xB48F,
+	0xB490, 0xB491, 0xB492, 0xB493, 0xB494, 0xB495, 0xB496, 0xB497,
+	0xB498, 0xB499, 0xB49A, 0xB49B, 0xB49C, 0xB49D, 0xB49E, 0xB49F,
+	0xB4A0, 0xB541, 0xB542, 0xB543, 0xB544, 0xB545, 0xB546, 0xB547,
+	0xB548, 0xB549, 0xB54A, 0xB54B, 0xB54C, 0xB54D, 0xB54E, 0xB54F,
+	0xC5B0, 0xC5B1, 0xB550, 0xB551, 0xC5B2, 0xB552, 0xB553, 0xB554,
+	0xC5B3, 0xB555, 0xB556, 0xB557, 0xB558, 0xB559, 0xB55A, 0xB561,
+	0xC5B4, 0xC5B5, 0xB562, 0xC5B6, 0xB563, 0xC5B7, 0xB564, 0xB565,
+	0xB566, 0xB567, 0xB568, 0xB569, 0xC5B8, 0xC5B9, 0xB56A, 0xB56B,
+	0xC5BA, 0xB56C, 0xB56D, 0xB56E, 0xC5BB, 0xC5BC, 0xB56F, 0xB570,
+	0xB571, 0xB572, 0xB573, 0xB574, 0xC5BD, 0xC5BE, 0xB575, 0xC5BF,
+	0xC5C0, 0xC5C1, 0xB576, 0xB577, 0xB578, 0xB579, 0xB57A, 0xB581,
+	0xC5C2, 0xC5C3, 0xB582, 0xB583, 0xC5C4, 0xB584, 0xB585, 0xB586,
+	0xC5C5, 0xB587, 0xB588, 0xB589, 0xB58A, 0xB58B, 0xB58C, 0xB58D,
+	0xC5C6, 0xC5C7, 0xB58E, 0xC5C8, 0xC5C9, 0xC5CA, 0xB58F, 0xB590,
+	0xB591, 0xB592, 0xB593, 0xB594, 0xC5CB, 0xB595, 0xB596, 0xB597,
+	0xB598, 0xB599, 0xB59A, 0xB59B, 0xB59C, 0xB59D, 0xB59E, 0xB59F,
+	0xB5A0, 0xB641, 0xB642, 0xB643, 0xB644, 0xB645, 0xB646, 0xB647,
+	0xB648, 0xC5CC, 0xB649, 0xB64A, 0xB64B, 0xB64C, 0xB64D, 0xB64E,
+	0xB64F, 0xB650, 0xB651, 0xB652, 0xB653, 0xB654, 0xB655, 0xB656,
+	0xB657, 0xB658, 0xB659, 0xB65A, 0xB661, 0xB662, 0xB663, 0xB664,
+	0xB665, 0xB666, 0xB667, 0xB668, 0xB669, 0xB66A, 0xB66B, 0xB66C,
+	0xB66D, 0xB66E, 0xB66F, 0xB670, 0xC5CD, 0xC5CE, 0xB671, 0xB672,
+	0xC5CF, 0xB673, 0xB674, 0xB675, 0xC5D0, 0xB676, 0xC5D1, 0xB677,
+	0xB678, 0xB679, 0xB67A, 0xB681, 0xC5D2, 0xC5D3, 0xB682, 0xC5D4,
+	0xC5D5, 0xC5D6, 0xB683, 0xB684, 0xB685, 0xB686, 0xB687, 0xB688,
+	0xC5D7, 0xC5D8, 0xB689, 0xB68A, 0xC5D9, 0xB68B, 0xB68C, 0xB68D,
+	0xC5DA, 0xB68E, 0xB68F, 0xB690, 0xB691, 0xB692, 0xB693, 0xB694,
+	0xC5DB, 0xC5DC, 0xB695, 0xC5DD, 0xB696, 0xC5DE, 0xB697, 0xB698,
+	0xB699, 0xB69A, 0xB69B, 0xB69C, 0xC5DF, 0xB69D, 0xB69E, 0xB69F,
+	0xC5E0, 0xB6A0, 0xB741, 0xB742, 0xB743, 0xB744, 0xB745, 0xB746,
+	0xB747, 0xB748, 0xB749, 0xB74A, 0xB74B, 0xB74C, 0xB74D, 0xB74E,
+	0xC5E1, 0xB74F, 0xB750, 0xB751, 0xB752, 0xB753, 0xB754, 0xB755,
+	0xC5E2, 0xB756, 0xB757, 0xB758, 0xC5E3, 0xB759, 0xB75A, 0xB761,
+	0xB762, 0xB763, 0xB764, 0xB765, 0xB766, 0xB767, 0xB768, 0xB769,
+	0xB76A, 0xB76B, 0xB76C, 0xB76D, 0xB76E, 0xB76F, 0xB770, 0xB771,
+	0xB772, 0xB773, 0xB774, 0xB775, 0xC5E4, 0xC5E5, 0xB776, 0xB777,
+	0xC5E6, 0xB778, 0xB779, 0xB77A, 0xC5E7, 0xB781, 0xB782, 0xB783,
+	0xB784, 0xB785, 0xB786, 0xB787, 0xC5E8, 0xC5E9, 0xB788, 0xC5EA,
+	0xB789, 0xC5EB, 0xB78A, 0xB78B, 0xB78C, 0xB78D, 0xC5EC, 0xB78E,
+	0xC5ED, 0xB78F, 0xB790, 0xB791, 0xC5EE, 0xB792, 0xB793, 0xB794,
+	0xB795, 0xB796, 0xB797, 0xB798, 0xB799, 0xB79A, 0xB79B, 0xB79C,
+	0xB79D, 0xB79E, 0xB79F, 0xB7A0, 0xB841, 0xB842, 0xB843, 0xB844,
+	0xB845, 0xB846, 0xB847, 0xB848, 0xC5EF, 0xB849, 0xB84A, 0xB84B,
+	0xB84C, 0xB84D, 0xB84E, 0xB84F, 0xB850, 0xB851, 0xB852, 0xB853,
+	0xB854, 0xB855, 0xB856, 0xB857, 0xB858, 0xB859, 0xB85A, 0xB861,
+	0xB862, 0xB863, 0xB864, 0xB865, 0xB866, 0xB867, 0xB868, 0xB869,
+	0xC5F0, 0xB86A, 0xB86B, 0xB86C, 0xC5F1, 0xB86D, 0xB86E, 0xB86F,
+	0xB870, 0xB871, 0xB872, 0xB873, 0xB874, 0xB875, 0xB876, 0xB877,
+	0xB878, 0xB879, 0xB87A, 0xC5F2, 0xB881, 0xC5F3, 0xB882, 0xB883,
+	0xB884, 0xB885, 0xB886, 0xB887, 0xC5F4, 0xB888, 0xB889, 0xB88A,
+	0xB88B, 0xB88C, 0xB88D, 0xB88E, 0xB88F, 0xB890, 0xB891, 0xB892,
+	0xB893, 0xB894, 0xB895, 0xB896, 0xB897, 0xB898, 0xB899, 0xB89A,
+	0xB89B, 0xB89C, 0xB89D, 0xB89E, 0xB89F, 0xB8A0, 0xB941, 0xB942,
+	0xC5F5, 0xC5F6, 0xB943, 0xB944, 0xC5F7, 0xB945, 0xB946, 0xB947,
+	0xC5F8, 0xB948, 0xB949, 0xB94A, 0xB94B, 0xB94C, 0xB94D, 0xB94E,
+	0xC5F9, 0xC5FA, 0xB94F, 0xC5FB, 0xB950, 0xC5FC, 0xB951, 0xB952,
+	0xB953, 0xB954, 0xB955, 0xB956, 0xC5FD, 0xB957, 0xB958, 0xB959,
+	0xB95A, 0xB961, 0xB962, 0xB963, 0xB964, 0xB965, 0xB966, 0xB967,
+	0xB968, 0xB969, 0xB96A, 0xB96B, 0xB96C, 0xB96D, 0xB96E, 0xB96F,
+	0xC5FE, 0xB970, 0xB971, 0xB972, 0xB973, 0xB974, 0xB975, 0xB976,
+	0xC6A1, 0xB977, 0xB978, 0xB979, 0xB97A, 0xB981, 0xB982, 0xB983,
+	0xB984, 0xB985, 0xB986, 0xB987, 0xB988, 0xB989, 0xB98A, 0xB98B,
+	0xB98C, 0xB98D, 0xB98E, 0xB98F, 0xB990, 0xB991, 0xB992, 0xB993,
+	0xB994, 0xB995, 0xB996, 0xB997, 0xC6A2, 0xC6A3, 0xB998, 0xB999,
+	0xC6A4, 0xB99A, 0xB99B, 0xB99C, 0xC6A5, 0xB99D, 0xB99E, 0xB99F,
+	0xB9A0, 0xBA41, 0xBA42, 0xBA43, 0xC6A6, 0xC6A7, 0xBA44, 0xBA45,
+	0xBA46, 0xC6A8, 0xBA47, 0xBA48, 0xBA49, 0xBA4A, 0xBA4B, 0xBA4C,
+	0xC6A9, 0xBA4D, 0xBA4E, 0xBA4F, 0xC6AA, 0xBA50, 0xBA51, 0xBA52,
+	0xC6AB, 0xBA53, 0xBA54, 0xBA55, 0xBA56, 0xBA57, 0xBA58, 0xBA59,
+	0xC6AC, 0xBA5A, 0xBA61, 0xBA62, 0xBA63, 0xC6AD, 0xBA64, 0xBA65,
+	0xBA66, 0xBA67, 0xBA68, 0xBA69, 0xC6AE, 0xC6AF, 0xBA6A, 0xBA6B,
+	0xC6B0, 0xBA6C, 0xBA6D, 0xC6B1, 0xC6B2, 0xBA6E, 0xC6B3, 0xBA6F,
+	0xBA70, 0xBA71, 0xBA72, 0xBA73, 0xC6B4, 0xC6B5, 0xBA74, 0xC6B6,
+	0xBA75, 0xBA76, 0xBA77, 0xBA78, 0xBA79, 0xBA7A, 0xBA81, 0xBA82,
+	0xC6B7, 0xBA83, 0xBA84, 0xBA85, 0xC6B8, 0xBA86, 0xBA87, 0xBA88,
+	0xC6B9, 0xBA89, 0xBA8A, 0xBA8B, 0xBA8C, 0xBA8D, 0xBA8E, 0xBA8F,
+	0xC6BA, 0xC6BB, 0xBA90, 0xBA91, 0xBA92, 0xBA93, 0xBA94, 0xBA95,
+	0xBA96, 0xBA97, 0xBA98, 0xBA99, 0xC6BC, 0xC6BD, 0xBA9A, 0xBA9B,
+	0xC6BE, 0xBA9C, 0xBA9D, 0xBA9E, 0xC6BF, 0xBA9F, 0xBAA0, 0xBB41,
+	0xBB42, 0xBB43, 0xBB44, 0xBB45, 0xC6C0, 0xC6C1, 0xBB46, 0xC6C2,
+	0xBB47, 0xC6C3, 0xBB48, 0xBB49, 0xBB4A, 0xBB4B, 0xBB4C, 0xBB4D,
+	0xC6C4, 0xC6C5, 0xC6C6, 0xBB4E, 0xC6C7, 0xBB4F, 0xBB50, 0xBB51,
+	0xC6C8, 0xBB52, 0xC6C9, 0xBB53, 0xBB54, 0xBB55, 0xBB56, 0xBB57,
+	0xC6CA, 0xC6CB, 0xBB58, 0xC6CC, 0xC6CD, 0xC6CE, 0xBB59, 0xBB5A,
+	0xBB61, 0xC6CF, 0xBB62, 0xBB63, 0xC6D0, 0xC6D1, 0xBB64, 0xBB65,
+	0xC6D2, 0xBB66, 0xBB67, 0xBB68, 0xC6D3, 0xBB69, 0xBB6A, 0xBB6B,
+	0xBB6C, 0xBB6D, 0xBB6E, 0xBB6F, 0xC6D4, 0xC6D5, 0xBB70, 0xC6D6,
+	0xC6D7, 0xC6D8, 0xBB71, 0xBB72, 0xBB73, 0xBB74, 0xBB75, 0xBB76,
+	0xC6D9, 0xC6DA, 0xBB77, 0xBB78, 0xBB79, 0xBB7A, 0xBB81, 0xBB82,
+	0xBB83, 0xBB84, 0xBB85, 0xBB86, 0xBB87, 0xBB88, 0xBB89, 0xBB8A,
+	0xBB8B, 0xBB8C, 0xBB8D, 0xBB8E, 0xBB8F, 0xBB90, 0xBB91, 0xBB92,
+	0xBB93, 0xBB94, 0xBB95, 0xBB96, 0xBB97, 0xBB98, 0xBB99, 0xBB9A,
+	0xBB9B, 0xBB9C, 0xBB9D, 0xBB9E, 0xBB9F, 0xBBA0, 0xBC41, 0xBC42,
+	0xBC43, 0xBC44, 0xBC45, 0xBC46, 0xBC47, 0xBC48, 0xBC49, 0xBC4A,
+	0xBC4B, 0xBC4C, 0xBC4D, 0xBC4E, 0xBC4F, 0xBC50, 0xBC51, 0xBC52,
+	0xC6DB, 0xC6DC, 0xBC53, 0xBC54, 0xC6DD, 0xBC55, 0xBC56, 0xBC57,
+	0xC6DE, 0xBC58, 0xBC59, 0xBC5A, 0xBC61, 0xBC62, 0xBC63, 0xBC64,
+	0xC6DF, 0xC6E0, 0xBC65, 0xC6E1, 0xC6E2, 0xC6E3, 0xBC66, 0xBC67,
+	0xBC68, 0xBC69, 0xBC6A, 0xBC6B, 0xC6E4, 0xC6E5, 0xBC6C, 0xBC6D,
+	0xC6E6, 0xBC6E, 0xBC6F, 0xBC70, 0xC6E7, 0xBC71, 0xBC72, 0xBC73,
+	0xBC74, 0xBC75, 0xBC76, 0xBC77, 0xC6E8, 0xC6E9, 0xBC78, 0xC6EA,
+	0xBC79, 0xC6EB, 0xBC7A, 0xBC81, 0xBC82, 0xBC83, 0xBC84, 0xBC85,
+	0xC6EC, 0xBC86, 0xBC87, 0xBC88, 0xC6ED, 0xBC89, 0xBC8A, 0xBC8B,
+	0xC6EE, 0xBC8C, 0xBC8D, 0xBC8E, 0xBC8F, 0xBC90, 0xBC91, 0xBC92,
+	0xC6EF, 0xC6F0, 0xBC93, 0xBC94, 0xC6F1, 0xC6F2, 0xBC95, 0xBC96,
+	0xBC97, 0xBC98, 0xBC99, 0xBC9A, 0xC6F3, 0xBC9B, 0xBC9C, 0xBC9D,
+	0xBC9E, 0xBC9F, 0xBCA0, 0xBD41, 0xC6F4, 0xBD42, 0xBD43, 0xBD44,
+	0xBD45, 0xBD46, 0xBD47, 0xBD48, 0xBD49, 0xC6F5, 0xBD4A, 0xC6F6,
+	0xBD4B, 0xBD4C, 0xBD4D, 0xBD4E, 0xBD4F, 0xBD50, 0xBD51, 0xBD52,
+	0xC6F7, 0xC6F8, 0xBD53, 0xBD54, 0xC6F9, 0xBD55, 0xBD56, 0xBD57,
+	0xC6FA, 0xBD58, 0xBD59, 0xBD5A, 0xBD61, 0xBD62, 0xBD63, 0xBD64,
+	0xC6FB, 0xC6FC, 0xBD65, 0xC6FD, 0xBD66, 0xC6FE, 0xBD67, 0xBD68,
+	0xBD69, 0xBD6A, 0xBD6B, 0xBD6C, 0xC7A1, 0xBD6D, 0xBD6E, 0xBD6F,
+	0xBD70, 0xBD71, 0xBD72, 0xBD73, 0xBD74, 0xBD75, 0xBD76, 0xBD77,
+	0xBD78, 0xBD79, 0xBD7A, 0xBD81, 0xBD82, 0xBD83, 0xBD84, 0xBD85,
+	0xBD86, 0xC7A2, 0xBD87, 0xBD88, 0xBD89, 0xBD8A, 0xBD8B, 0xBD8C,
+	0xBD8D, 0xBD8E, 0xBD8F, 0xBD90, 0xBD91, 0xBD92, 0xBD93, 0xBD94,
+	0xBD95, 0xBD96, 0xBD97, 0xBD98, 0xBD99, 0xBD9A, 0xBD9B, 0xBD9C,
+	0xBD9D, 0xBD9E, 0xBD9F, 0xBDA0, 0xBE41, 0xBE42, 0xBE43, 0xBE44,
+	0xBE45, 0xBE46, 0xBE47, 0xBE48, 0xC7A3, 0xBE49, 0xBE4A, 0xBE4B,
+	0xC7A4, 0xBE4C, 0xBE4D, 0xBE4E, 0xBE4F, 0xBE50, 0xBE51, 0xBE52,
+	0xBE53, 0xBE54, 0xBE55, 0xBE56, 0xBE57, 0xBE58, 0xBE59, 0xBE5A,
+	0xBE61, 0xBE62, 0xBE63, 0xBE64, 0xBE65, 0xBE66, 0xBE67, 0xBE68,
+	0xC7A5, 0xBE69, 0xBE6A, 0xBE6B, 0xC7A6, 0xBE6C, 0xBE6D, 0xBE6E,
+	0xC7A7, 0xBE6F, 0xBE70, 0xBE71, 0xBE72, 0xBE73, 0xBE74, 0xBE75,
+	0xBE76, 0xC7A8, 0xBE77, 0xC7A9, 0xBE78, 0xBE79, 0xBE7A, 0xBE81,
+	0xBE82, 0xBE83, 0xBE84, 0xBE85, 0xC7AA, 0xC7AB, 0xBE86, 0xBE87,
+	0xC7AC, 0xBE88, 0xBE89, 0xC7AD, 0xC7AE, 0xBE8A, 0xC7AF, 0xBE8B,
+	0xBE8C, 0xBE8D, 0xBE8E, 0xBE8F, 0xC7B0, 0xC7B1, 0xBE90, 0xC7B2,
+	0xBE91, 0xC7B3, 0xBE92, 0xBE93, 0xBE94, 0xBE95, 0xBE96, 0xBE97,
+	0xC7B4, 0xBE98, 0xBE99, 0xBE9A, 0xBE9B, 0xBE9C, 0xBE9D, 0xBE9E,
+	0xBE9F, 0xBEA0, 0xBF41, 0xBF42, 0xBF43, 0xBF44, 0xBF45, 0xBF46,
+	0xBF47, 0xBF48, 0xBF49, 0xBF4A, 0xBF4B, 0xC7B5, 0xBF4C, 0xBF4D,
+	0xBF4E, 0xBF4F, 0xBF50, 0xBF51, 0xBF52, 0xBF53, 0xBF54, 0xBF55,
+	0xBF56, 0xBF57, 0xBF58, 0xBF59, 0xBF5A, 0xBF61, 0xBF62, 0xBF63,
+	0xBF64, 0xBF65, 0xBF66, 0xBF67, 0xBF68, 0xBF69, 0xBF6A, 0xBF6B,
+	0xBF6C, 0xBF6D, 0xBF6E, 0xBF6F, 0xBF70, 0xBF71, 0xBF72, 0xBF73,
+	0xC7B6, 0xBF74, 0xBF75, 0xBF76, 0xC7B7, 0xBF77, 0xBF78, 0xBF79,
+	0xC7B8, 0xBF7A, 0xBF81, 0xBF82, 0xBF83, 0xBF84, 0xBF85, 0xBF86,
+	0xC7B9, 0xBF87, 0xBF88, 0xC7BA, 0xBF89, 0xBF8A, 0xBF8B, 0xBF8C,
+	0xBF8D, 0xBF8E, 0xBF8F, 0xBF90, 0xC7BB, 0xBF91, 0xBF92, 0xBF93,
+	0xC7BC, 0xBF94, 0xBF95, 0xBF96, 0xC7BD, 0xBF97, 0xBF98, 0xBF99,
+	0xBF9A, 0xBF9B, 0xBF9C, 0xBF9D, 0xC7BE, 0xBF9E, 0xBF9F, 0xC7BF,
+	0xBFA0, 0xC7C0, 0xC041, 0xC042, 0xC043, 0xC044, 0xC045, 0xC046,
+	0xC7C1, 0xC047, 0xC048, 0xC049, 0xC7C2, 0xC04A, 0xC04B, 0xC04C,
+	0xC7C3, 0xC04D, 0xC04E, 0xC04F, 0xC050, 0xC051, 0xC052, 0xC053,
+	0xC7C4, 0xC7C5, 0xC054, 0xC7C6, 0xC055, 0xC056, 0xC057, 0xC058,
+	0xC059, 0xC05A, 0xC061, 0xC062, 0xC063, 0xC064, 0xC065, 0xC066,
+	0xC067, 0xC068, 0xC069, 0xC06A, 0xC06B, 0xC06C, 0xC06D, 0xC06E,
+	0xC06F, 0xC070, 0xC071, 0xC072, 0xC073, 0xC074, 0xC075, 0xC076,
+	0xC077, 0xC078, 0xC079, 0xC07A, 0xC081, 0xC082, 0xC083, 0xC084,
+	0xC7C7, 0xC7C8, 0xC085, 0xC086, 0xC7C9, 0xC087, 0xC088, 0xC089,
+	0xC7CA, 0xC08A, 0xC08B, 0xC08C, 0xC08D, 0xC08E, 0xC08F, 0xC090,
+	0xC7CB, 0xC7CC, 0xC091, 0xC7CD, 0xC092, 0xC7CE, 0xC093, 0xC094,
+	0xC095, 0xC096, 0xC097, 0xC098, 0xC7CF, 0xC7D0, 0xC099, 0xC09A,
+	0xC7D1, 0xC09B, 0xC09C, 0xC09D, 0xC7D2, 0xC09E, 0xC09F, 0xC0A0,
+	0xC141, 0xC7D3, 0xC142, 0xC143, 0xC7D4, 0xC7D5, 0xC144, 0xC7D6,
+	0xC145, 0xC7D7, 0xC146, 0xC147, 0xC148, 0xC149, 0xC14A, 0xC14B,
+	0xC7D8, 0xC7D9, 0xC14C, 0xC14D, 0xC7DA, 0xC14E, 0xC14F, 0xC150,
+	0xC7DB, 0xC151, 0xC152, 0xC153, 0xC154, 0xC155, 0xC156, 0xC157,
+	0xC7DC, 0xC7DD, 0xC158, 0xC7DE, 0xC7DF, 0xC7E0, 0xC159, 0xC15A,
+	0xC161, 0xC162, 0xC163, 0xC164, 0xC7E1, 0xC165, 0xC166, 0xC167,
+	0xC168, 0xC169, 0xC16A, 0xC16B, 0xC16C, 0xC16D, 0xC16E, 0xC16F,
+	0xC170, 0xC171, 0xC172, 0xC173, 0xC174, 0xC175, 0xC176, 0xC177,
+	0xC178, 0xC7E2, 0xC179, 0xC17A, 0xC181, 0xC182, 0xC183, 0xC184,
+	0xC185, 0xC186, 0xC187, 0xC188, 0xC189, 0xC18A, 0xC18B, 0xC18C,
+	0xC18D, 0xC18E, 0xC18F, 0xC190, 0xC191, 0xC192, 0xC193, 0xC194,
+	0xC195, 0xC196, 0xC197, 0xC198, 0xC199, 0xC19A, 0xC19B, 0xC19C,
+	0xC19D, 0xC19E, 0xC19F, 0xC1A0, 0xC7E3, 0xC7E4, 0xC241, 0xC242,
+	0xC7E5, 0xC243, 0xC244, 0xC245, 0xC7E6, 0xC246, 0xC7E7, 0xC247,
+	0xC248, 0xC249, 0xC24A, 0xC24B, 0xC7E8, 0xC7E9, 0xC24C, 0xC7EA,
+	0xC24D, 0xC7EB, 0xC24E, 0xC24F, 0xC250, 0xC251, 0xC252, 0xC253,
+	0xC7EC, 0xC7ED, 0xC254, 0xC255, 0xC7EE, 0xC256, 0xC257, 0xC258,
+	0xC7EF, 0xC259, 0xC25A, 0xC261, 0xC262, 0xC263, 0xC264, 0xC265,
+	0xC7F0, 0xC7F1, 0xC266, 0xC7F2, 0xC267, 0xC7F3, 0xC268, 0xC269,
+	0xC26A, 0xC26B, 0xC26C, 0xC26D, 0xC7F4, 0xC7F5, 0xC26E, 0xC26F,
+	0xC7F6, 0xC270, 0xC271, 0xC272, 0xC7F7, 0xC273, 0xC274, 0xC275,
+	0xC276, 0xC277, 0xC278, 0xC279, 0xC7F8, 0xC7F9, 0xC27A, 0xC7FA,
+	0xC7FB, 0xC7FC, 0xC281, 0xC282, 0xC283, 0xC284, 0xC285, 0xC286,
+	0xC7FD, 0xC287, 0xC288, 0xC289, 0xC7FE, 0xC28A, 0xC28B, 0xC28C,
+	0xC8A1, 0xC28D, 0xC28E, 0xC28F, 0xC290, 0xC291, 0xC292, 0xC293,
+	0xC294, 0xC8A2, 0xC295, 0xC296, 0xC297, 0xC298, 0xC299, 0xC29A,
+	0xC29B, 0xC29C, 0xC29D, 0xC29E, 0xC8A3, 0xC8A4, 0xC29F, 0xC2A0,
+	0xC8A5, 0xC341, 0xC342, 0xC343, 0xC8A6, 0xC344, 0xC345, 0xC346,
+	0xC347, 0xC8A7, 0xC348, 0xC349, 0xC8A8, 0xC8A9, 0xC34A, 0xC8AA,
+	0xC34B, 0xC8AB, 0xC34C, 0xC34D, 0xC34E, 0xC8AC, 0xC34F, 0xC350,
+	0xC8AD, 0xC8AE, 0xC351, 0xC352, 0xC8AF, 0xC353, 0xC354, 0xC355,
+	0xC8B0, 0xC356, 0xC357, 0xC358, 0xC359, 0xC35A, 0xC361, 0xC362,
+	0xC363, 0xC364, 0xC365, 0xC8B1, 0xC366, 0xC8B2, 0xC367, 0xC368,
+	0xC369, 0xC36A, 0xC36B, 0xC36C, 0xC8B3, 0xC8B4, 0xC36D, 0xC36E,
+	0xC8B5, 0xC36F, 0xC370, 0xC371, 0xC372, 0xC373, 0xC374, 0xC375,
+	0xC376, 0xC377, 0xC378, 0xC379, 0xC37A, 0xC381, 0xC382, 0xC8B6,
+	0xC383, 0xC8B7, 0xC384, 0xC385, 0xC386, 0xC387, 0xC388, 0xC389,
+	0xC8B8, 0xC8B9, 0xC38A, 0xC38B, 0xC8BA, 0xC38C, 0xC38D, 0xC38E,
+	0xC8BB, 0xC38F, 0xC390, 0xC391, 0xC392, 0xC393, 0xC394, 0xC395,
+	0xC396, 0xC8BC, 0xC397, 0xC8BD, 0xC398, 0xC8BE, 0xC399, 0xC39A,
+	0xC39B, 0xC39C, 0xC39D, 0xC39E, 0xC8BF, 0xC39F, 0xC3A0, 0xC441,
+	0xC8C0, 0xC442, 0xC443, 0xC444, 0xC8C1, 0xC445, 0xC446, 0xC447,
+	0xC448, 0xC449, 0xC44A, 0xC44B, 0xC44C, 0xC8C2, 0xC44D, 0xC8C3,
+	0xC44E, 0xC44F, 0xC450, 0xC451, 0xC452, 0xC453, 0xC454, 0xC455,
+	0xC8C4, 0xC8C5, 0xC456, 0xC457, 0xC8C6, 0xC458, 0xC459, 0xC45A,
+	0xC8C7, 0xC461, 0xC462, 0xC463, 0xC464, 0xC8C8, 0xC465, 0xC466,
+	0xC8C9, 0xC467, 0xC468, 0xC8CA, 0xC469, 0xC8CB, 0xC46A, 0xC46B,
+	0xC46C, 0xC46D, 0xC46E, 0xC46F, 0xC8CC, 0xC470, 0xC471, 0xC472,
+	0xC8CD, 0xC473, 0xC474, 0xC475, 0xC8CE, 0xC476, 0xC477, 0xC478,
+	0xC479, 0xC47A, 0xC481, 0xC482, 0xC8CF, 0xC483, 0xC484, 0xC485,
+	0xC486, 0xC8D0, 0xC487, 0xC488, 0xC489, 0xC48A, 0xC48B, 0xC48C,
+	0xC8D1, 0xC8D2, 0xC48D, 0xC48E, 0xC8D3, 0xC48F, 0xC490, 0xC491,
+	0xC8D4, 0xC492, 0xC493, 0xC494, 0xC495, 0xC496, 0xC497, 0xC498,
+	0xC499, 0xC49A, 0xC49B, 0xC49C, 0xC49D, 0xC8D5, 0xC49E, 0xC49F,
+	0xC4A0, 0xC541, 0xC542, 0xC543, 0xC8D6, 0xC8D7, 0xC544, 0xC545,
+	0xC8D8, 0xC546, 0xC547, 0xC548, 0xC8D9, 0xC549, 0xC54A, 0xC54B,
+	0xC54C, 0xC54D, 0xC54E, 0xC54F, 0xC8DA, 0xC8DB, 0xC550, 0xC8DC,
+	0xC551, 0xC8DD, 0xC552, 0xC553, 0xC554, 0xC555, 0xC556, 0xC557,
+	0xC8DE, 0xC8DF, 0xC558, 0xC559, 0xC8E0, 0xC55A, 0xC561, 0xC562,
+	0xC8E1, 0xC563, 0xC564, 0xC565, 0xC566, 0xC567, 0xC568, 0xC569,
+	0xC8E2, 0xC56A, 0xC56B, 0xC8E3, 0xC56C, 0xC8E4, 0xC56D, 0xC56E,
+	0xC56F, 0xC570, 0xC571, 0xC572, 0xC8E5, 0xC8E6, 0xC573, 0xC574,
+	0xC8E7, 0xC575, 0xC8E8, 0xC8E9, 0xC8EA, 0xC8EB, 0xC576, 0xC577,
+	0xC578, 0xC579, 0xC57A, 0xC581, 0xC8EC, 0xC8ED, 0xC582, 0xC8EE,
+	0xC583, 0xC8EF, 0xC584, 0xC585, 0xC586, 0xC8F0, 0xC587, 0xC588,
+	0xC8F1, 0xC589, 0xC58A, 0xC58B, 0xC8F2, 0xC58C, 0xC58D, 0xC58E,
+	0xC8F3, 0xC58F, 0xC590, 0xC591, 0xC592, 0xC593, 0xC594, 0xC595,
+	0xC8F4, 0xC8F5, 0xC596, 0xC597, 0xC598, 0xC8F6, 0xC599, 0xC59A,
+	0xC59B, 0xC59C, 0xC59D, 0xC59E, 0xC8F7, 0xC8F8, 0xC59F, 0xC5A0,
+	0xC8F9, 0xC641, 0xC642, 0xC643, 0xC8FA, 0xC644, 0xC645, 0xC646,
+	0xC647, 0xC648, 0xC649, 0xC64A, 0xC8FB, 0xC8FC, 0xC64B, 0xC8FD,
+	0xC64C, 0xC8FE, 0xC64D, 0xC64E, 0xC64F, 0xC650, 0xC651, 0xC652,
+	0xCBD0, 0xCBD6, 0xCBE7, 0xCDCF, 0xCDE8, 0xCEAD, 0xCFFB, 0xD0A2,
+	0xD0B8, 0xD0D0, 0xD0DD, 0xD1D4, 0xD1D5, 0xD1D8, 0xD1DB, 0xD1DC,
+	0xD1DD, 0xD1DE, 0xD1DF, 0xD1E0, 0xD1E2, 0xD1E3, 0xD1E4, 0xD1E5,
+	0xD1E6, 0xD1E8, 0xD1E9, 0xD1EA, 0xD1EB, 0xD1ED, 0xD1EF, 0xD1F0,
+	0xD1F2, 0xD1F6, 0xD1FA, 0xD1FC, 0xD1FD, 0xD1FE, 0xD2A2, 0xD2A3,
+	0xD2A7, 0xD2A8, 0xD2A9, 0xD2AA, 0xD2AB, 0xD2AD, 0xD2B2, 0xD2BE,
+	0xD2C2, 0xD2C3, 0xD2C4, 0xD2C6, 0xD2C7, 0xD2C8, 0xD2C9, 0xD2CA,
+	0xD2CB, 0xD2CD, 0xD2CE, 0xD2CF, 0xD2D0, 0xD2D1, 0xD2D2, 0xD2D3,
+	0xD2D4, 0xD2D5, 0xD2D6, 0xD2D7, 0xD2D9, 0xD2DA, 0xD2DE, 0xD2DF,
+	0xD2E1, 0xD2E2, 0xD2E4, 0xD2E5, 0xD2E6, 0xD2E7, 0xD2E8, 0xD2E9,
+	0xD2EA, 0xD2EB, 0xD2F0, 0xD2F1, 0xD2F2, 0xD2F3, 0xD2F4, 0xD2F5,
+	0xD2F7, 0xD2F8, 0xD4E6, 0xD4FC, 0xD5A5, 0xD5AB, 0xD5AE, 0xD6B8,
+	0xD6CD, 0xD7CB, 0xD7E4, 0xDBC5, 0xDBE4, 0xDCA5, 0xDDA5, 0xDDD5,
+	0xDDF4, 0xDEFC, 0xDEFE, 0xDFB3, 0xDFE1, 0xDFE8, 0xE0F1, 0xE1AD,
+	0xE1ED, 0xE3F5, 0xE4A1, 0xE4A9, 0xE5AE, 0xE5B1, 0xE5B2, 0xE5B9,
+	0xE5BB, 0xE5BC, 0xE5C4, 0xE5CE, 0xE5D0, 0xE5D2, 0xE5D6, 0xE5FA,
+	0xE5FB, 0xE5FC, 0xE5FE, 0xE6A1, 0xE6A4, 0xE6A7, 0xE6AD, 0xE6AF,
+	0xE6B0, 0xE6B1, 0xE6B3, 0xE6B7, 0xE6B8, 0xE6BC, 0xE6C4, 0xE6C6,
+	0xE6C7, 0xE6CA, 0xE6D2, 0xE6D6, 0xE6D9, 0xE6DC, 0xE6DF, 0xE6E1,
+	0xE6E4, 0xE6E5, 0xE6E6, 0xE6E8, 0xE6EA, 0xE6EB, 0xE6EC, 0xE6EF,
+	0xE6F1, 0xE6F2, 0xE6F5, 0xE6F6, 0xE6F7, 0xE6F9, 0xE7A1, 0xE7A6,
+	0xE7A9, 0xE7AA, 0xE7AC, 0xE7AD, 0xE7B0, 0xE7BF, 0xE7C1, 0xE7C6,
+	0xE7C7, 0xE7CB, 0xE7CD, 0xE7CF, 0xE7D0, 0xE7D3, 0xE7DF, 0xE7E4,
+	0xE7E6, 0xE7F7, 0xE8E7, 0xE8E8, 0xE8F0, 0xE8F1, 0xE8F7, 0xE8F9,
+	0xE8FB, 0xE8FE, 0xE9A7, 0xE9AC, 0xE9CC, 0xE9F7, 0xEAC1, 0xEAE5,
+	0xEAF4, 0xEAF7, 0xEAFC, 0xEAFE, 0xEBA4, 0xEBA7, 0xEBA9, 0xEBAA,
+	0xEBBA, 0xEBBB, 0xEBBD, 0xEBC1, 0xEBC2, 0xEBC6, 0xEBC7, 0xEBCC,
+	0xEBCF, 0xEBD0, 0xEBD1, 0xEBD2, 0xEBD8, 0xECA6, 0xECA7, 0xECAA,
+	0xECAF, 0xECB0, 0xECB1, 0xECB2, 0xECB5, 0xECB8, 0xECBA, 0xECC0,
+	0xECC1, 0xECC5, 0xECC6, 0xECC9, 0xECCA, 0xECD5, 0xECDD, 0xECDE,
+	0xECE1, 0xECE4, 0xECE7, 0xECE8, 0xECF7, 0xECF8, 0xECFA, 0xEDA1,
+	0xEDA2, 0xEDA3, 0xEDEE, 0xEEDB, 0xF2BD, 0xF2FA, 0xF3B1, 0xF4A7,
+	0xF4EE, 0xF6F4, 0xF6F6, 0xF7B8, 0xF7C8, 0xF7D3, 0xF8DB, 0xF8F0,
+	0xFAA1, 0xFAA2, 0xFAE6, 0xFCA9, 0xA3A1, 0xA3A2, 0xA3A3, 0xA3A4,
+	0xA3A5, 0xA3A6, 0xA3A7, 0xA3A8, 0xA3A9, 0xA3AA, 0xA3AB, 0xA3AC,
+	0xA3AD, 0xA3AE, 0xA3AF, 0xA3B0, 0xA3B1, 0xA3B2, 0xA3B3, 0xA3B4,
+	0xA3B5, 0xA3B6, 0xA3B7, 0xA3B8, 0xA3B9, 0xA3BA, 0xA3BB, 0xA3BC,
+	0xA3BD, 0xA3BE, 0xA3BF, 0xA3C0, 0xA3C1, 0xA3C2, 0xA3C3, 0xA3C4,
+	0xA3C5, 0xA3C6, 0xA3C7, 0xA3C8, 0xA3C9, 0xA3CA, 0xA3CB, 0xA3CC,
+	0xA3CD, 0xA3CE, 0xA3CF, 0xA3D0, 0xA3D1, 0xA3D2, 0xA3D3, 0xA3D4,
+	0xA3D5, 0xA3D6, 0xA3D7, 0xA3D8, 0xA3D9, 0xA3DA, 0xA3DB, 0xA1AC,
+	0xA3DD, 0xA3DE, 0xA3DF, 0xA3E0, 0xA3E1, 0xA3E2, 0xA3E3, 0xA3E4,
+	0xA3E5, 0xA3E6, 0xA3E7, 0xA3E8, 0xA3E9, 0xA3EA, 0xA3EB, 0xA3EC,
+	0xA3ED, 0xA3EE, 0xA3EF, 0xA3F0, 0xA3F1, 0xA3F2, 0xA3F3, 0xA3F4,
+	0xA3F5, 0xA3F6, 0xA3F7, 0xA3F8, 0xA3F9, 0xA3FA, 0xA3FB, 0xA3FC,
+	0xA3FD, 0xA2A6, 0xA1CB, 0xA1CC, 0xA1FE, 0xA3FE, 0xA1CD, 0xA3DC,
+};
+
+/* OEM to Unicode */
+static
+const BYTE oem2uni_page[] = {
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+	0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E,
+	0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E,
+	0x2F, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E,
+	0x3F, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0xFF, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D,
+	0x4E, 0x4F, 0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x5B, 0x5C, 0x5D,
+	0x5E, 0x5F, 0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x6D,
+	0x6E, 0x6F, 0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x7B, 0xFF, 0xFF,
+};
+
+static
+const DWORD oem2uni_bits[] = {
+	0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE,
+	0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE,
+	0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE,
+	0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE,
+	0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE,
+	0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE,
+	0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE,
+	0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE,
+	0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE,
+	0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE,
+	0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE,
+	0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF,
+	0xFFFFFFFF, 0x000000FF, 0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE,
+	0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0x03FF07FF,
+	0x01FFFFFE, 0x01FFFFFE, 0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE,
+	0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x0000001F, 0x00000000, 0x00000000,
+	0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x0000FFFF,
+	0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFEFF5F,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE,
+	0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x000FFFFF,
+	0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF,
+	0xFFFFFFFF, 0x007FFFFF, 0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE,
+	0xFFFFFFFE, 0xFFFFFFFF, 0xFFFE0003, 0x0003FFFF, 0x00000000, 0x00000000,
+	0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0x00000001, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0x00000001,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE,
+	0xFFFFFFFE, 0x00000001, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE,
+	0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE,
+	0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE,
+	0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE,
+	0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE,
+	0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE,
+	0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x07FFFFFE, 0x07FFFFFE,
+	0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x07FFFFFE, 0x07FFFFFE, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x0007FFFE, 0x00000000, 0x00000000, 0xFFFFFFFE,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE,
+	0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE, 0xFFFFFFFF, 0x7FFFFFFF,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFE,
+	0xFFFFFFFF, 0x7FFFFFFF,
+};
+
+static
+const WORD oem2uni_base[] = {
+	0x0000, 0x0000, 0x0000, 0x001A, 0x0034, 0x0053, 0x0073, 0x0093,
+	0x00B2, 0x00B2, 0x00B2, 0x00CC, 0x00E6, 0x0105, 0x0125, 0x0145,
+	0x0164, 0x0164, 0x0164, 0x017E, 0x0198, 0x01B7, 0x01D7, 0x01F7,
+	0x0216, 0x0216, 0x0216, 0x0230, 0x024A, 0x0269, 0x0289, 0x02A9,
+	0x02C8, 0x02C8, 0x02C8, 0x02E2, 0x02FC, 0x031B, 0x033B, 0x035B,
+	0x037A, 0x037A, 0x037A, 0x0394, 0x03AE, 0x03CD, 0x03ED, 0x040D,
+	0x042C, 0x042C, 0x042C, 0x0446, 0x0460, 0x047F, 0x049F, 0x04BF,
+	0x04DE, 0x04DE, 0x04DE, 0x04F8, 0x0512, 0x0531, 0x0551, 0x0571,
+	0x0590, 0x0590, 0x0590, 0x05AA, 0x05C4, 0x05E3, 0x0603, 0x0623,
+	0x0642, 0x0642, 0x0642, 0x065C, 0x0676, 0x0695, 0x06B5, 0x06D5,
+	0x06F4, 0x06F4, 0x06F4, 0x070E, 0x0728, 0x0747, 0x0767, 0x0787,
+	0x07A6, 0x07A6, 0x07A6, 0x07C0, 0x07DA, 0x07F9, 0x0819, 0x0839,
+	0x0858, 0x0858, 0x0858, 0x0872, 0x088C, 0x08AB, 0x08CB, 0x08EB,
+	0x090A, 0x090A, 0x090A, 0x0924, 0x093E, 0x095D, 0x097D, 0x099D,
+	0x09BC, 0x09BC, 0x09BC, 0x09D6, 0x09F0, 0x0A0F, 0x0A2F, 0x0A4F,
+	0x0A6E, 0x0A6E, 0x0A6E, 0x0A88, 0x0AA2, 0x0AC1, 0x0AE1, 0x0B01,
+	0x0B20, 0x0B20, 0x0B20, 0x0B3A, 0x0B54, 0x0B73, 0x0B93, 0x0BB3,
+	0x0BD2, 0x0BD2, 0x0BD2, 0x0BEC, 0x0C06, 0x0C25, 0x0C45, 0x0C65,
+	0x0C84, 0x0C84, 0x0C84, 0x0C9E, 0x0CB8, 0x0CD7, 0x0CF7, 0x0D17,
+	0x0D36, 0x0D36, 0x0D36, 0x0D50, 0x0D6A, 0x0D89, 0x0DA9, 0x0DC9,
+	0x0DE8, 0x0DE8, 0x0DE8, 0x0E02, 0x0E1C, 0x0E3B, 0x0E5B, 0x0E7B,
+	0x0E9A, 0x0E9A, 0x0E9A, 0x0EB4, 0x0ECE, 0x0EED, 0x0F0D, 0x0F2D,
+	0x0F4C, 0x0F4C, 0x0F4C, 0x0F66, 0x0F80, 0x0F9F, 0x0FBF, 0x0FDF,
+	0x0FFE, 0x0FFE, 0x0FFE, 0x1018, 0x1032, 0x1051, 0x1071, 0x1091,
+	0x10B0, 0x10B0, 0x10B0, 0x10CA, 0x10E4, 0x1103, 0x1123, 0x1143,
+	0x1162, 0x1162, 0x1162, 0x117C, 0x1196, 0x11B5, 0x11D5, 0x11F5,
+	0x1214, 0x1214, 0x1214, 0x122E, 0x1248, 0x1267, 0x1287, 0x12A7,
+	0x12C6, 0x12C6, 0x12C6, 0x12E0, 0x12FA, 0x1319, 0x1339, 0x1359,
+	0x1378, 0x1378, 0x1378, 0x1392, 0x13AC, 0x13CB, 0x13EB, 0x140B,
+	0x142A, 0x142A, 0x142A, 0x1444, 0x145E, 0x147D, 0x149D, 0x14BD,
+	0x14DC, 0x14DC, 0x14DC, 0x14F6, 0x1510, 0x152F, 0x154F, 0x156F,
+	0x158E, 0x158E, 0x158E, 0x15A8, 0x15C2, 0x15E1, 0x1601, 0x1621,
+	0x1640, 0x1640, 0x1640, 0x165A, 0x1674, 0x1693, 0x16B3, 0x16D3,
+	0x16F2, 0x16F2, 0x16F2, 0x170C, 0x1726, 0x1745, 0x1765, 0x1785,
+	0x178D, 0x178D, 0x178D, 0x17A7, 0x17C1, 0x17E0, 0x1800, 0x1820,
+	0x183F, 0x183F, 0x183F, 0x1859, 0x1873, 0x1892, 0x18B2, 0x18D2,
+	0x18F1, 0x18F1, 0x18F1, 0x190B, 0x1925, 0x1944, 0x1959, 0x1971,
+	0x1989, 0x1989, 0x1989, 0x19A3, 0x19BD, 0x19DC, 0x19FC, 0x1A1C,
+	0x1A21, 0x1A21, 0x1A21, 0x1A3B, 0x1A55, 0x1A74, 0x1A94, 0x1AB4,
+	0x1AC4, 0x1AC4, 0x1AC4, 0x1ADE, 0x1AF8, 0x1B17, 0x1B34, 0x1B54,
+	0x1B73, 0x1B73, 0x1B73, 0x1B8D, 0x1BA7, 0x1BC6, 0x1BE6, 0x1C06,
+	0x1C25, 0x1C25, 0x1C25, 0x1C3F, 0x1C59, 0x1C78, 0x1C98, 0x1CB8,
+	0x1CCC, 0x1CCC, 0x1CCC, 0x1CE6, 0x1D00, 0x1D1F, 0x1D3F, 0x1D5F,
+	0x1D76, 0x1D76, 0x1D76, 0x1D90, 0x1DAA, 0x1DC9, 0x1DE9, 0x1DFA,
+	0x1E0C, 0x1E0C, 0x1E0C, 0x1E26, 0x1E40, 0x1E5F, 0x1E60, 0x1E60,
+	0x1E60, 0x1E60, 0x1E60, 0x1E7A, 0x1E94, 0x1EB3, 0x1EB4, 0x1EB4,
+	0x1EB4, 0x1EB4, 0x1EB4, 0x1ECE, 0x1EE8, 0x1F07, 0x1F08, 0x1F08,
+	0x1F08, 0x1F08, 0x1F08, 0x1F22, 0x1F3C, 0x1F5B, 0x1F7B, 0x1F9B,
+	0x1FBA, 0x1FBA, 0x1FBA, 0x1FD4, 0x1FEE, 0x200D, 0x202D, 0x204D,
+	0x206C, 0x206C, 0x206C, 0x2086, 0x20A0, 0x20BF, 0x20DF, 0x20FF,
+	0x211E, 0x211E, 0x211E, 0x2138, 0x2152, 0x2171, 0x2191, 0x21B1,
+	0x21D0, 0x21D0, 0x21D0, 0x21EA, 0x2204, 0x2223, 0x2243, 0x2263,
+	0x2282, 0x2282, 0x2282, 0x229C, 0x22B6, 0x22D5, 0x22F5, 0x2315,
+	0x2334, 0x2334, 0x2334, 0x234E, 0x2368, 0x2387, 0x23A7, 0x23C7,
+	0x23E6, 0x23E6, 0x23E6, 0x2400, 0x241A, 0x2439, 0x2459, 0x2479,
+	0x2498, 0x2498, 0x2498, 0x24B2, 0x24CC, 0x24EB, 0x250B, 0x252B,
+	0x254A, 0x254A, 0x254A, 0x2564, 0x257E, 0x259D, 0x25BD, 0x25DD,
+	0x25FC, 0x25FC, 0x25FC, 0x2616, 0x2630, 0x264F, 0x266F, 0x268F,
+	0x26AE, 0x26AE, 0x26AE, 0x26C8, 0x26E2, 0x2701, 0x2721, 0x2741,
+	0x2760, 0x2760, 0x2760, 0x277A, 0x2794, 0x27B3, 0x27D3, 0x27F3,
+	0x2812, 0x2812, 0x2812, 0x282C, 0x2846, 0x2865, 0x2885, 0x28A5,
+	0x28C4, 0x28C4, 0x28C4, 0x28DE, 0x28F8, 0x2917, 0x2937, 0x2957,
+	0x2976, 0x2976, 0x2976, 0x2990, 0x29AA, 0x29C9, 0x29E9, 0x2A09,
+	0x2A28, 0x2A28, 0x2A28, 0x2A42, 0x2A5C, 0x2A7B, 0x2A9B, 0x2ABB,
+	0x2ADA, 0x2ADA, 0x2ADA, 0x2AF4, 0x2B0E, 0x2B2D, 0x2B4D, 0x2B6D,
+	0x2B8C, 0x2B8C, 0x2B8C, 0x2BA6, 0x2BC0, 0x2BDF, 0x2BFF, 0x2C1F,
+	0x2C3E, 0x2C3E, 0x2C3E, 0x2C58, 0x2C72, 0x2C91, 0x2CB1, 0x2CD1,
+	0x2CF0, 0x2CF0, 0x2CF0, 0x2D0A, 0x2D24, 0x2D43, 0x2D63, 0x2D83,
+	0x2DA2, 0x2DA2, 0x2DA2, 0x2DBC, 0x2DD6, 0x2DF5, 0x2E15, 0x2E35,
+	0x2E54, 0x2E54, 0x2E54, 0x2E66, 0x2E66, 0x2E66, 0x2E85, 0x2EA5,
+	0x2EC4, 0x2EC4, 0x2EC4, 0x2EC4, 0x2EC4, 0x2EC4, 0x2EE3, 0x2F03,
+	0x2F22, 0x2F22, 0x2F22, 0x2F22, 0x2F22, 0x2F22, 0x2F41, 0x2F61,
+	0x2F80, 0x2F80, 0x2F80, 0x2F80, 0x2F80, 0x2F80, 0x2F9F, 0x2FBF,
+	0x2FDE, 0x2FDE, 0x2FDE, 0x2FDE, 0x2FDE, 0x2FDE, 0x2FFD, 0x301D,
+	0x303C, 0x303C, 0x303C, 0x303C, 0x303C, 0x303C, 0x305B, 0x307B,
+	0x309A, 0x309A, 0x309A, 0x309A, 0x309A, 0x309A, 0x30B9, 0x30D9,
+	0x30F8, 0x30F8, 0x30F8, 0x30F8, 0x30F8, 0x30F8, 0x3117, 0x3137,
+	0x3156, 0x3156, 0x3156, 0x3156, 0x3156, 0x3156, 0x3175, 0x3195,
+	0x31B4, 0x31B4, 0x31B4, 0x31B4, 0x31B4, 0x31B4, 0x31D3, 0x31F3,
+	0x3212, 0x3212, 0x3212, 0x3212, 0x3212, 0x3212, 0x3231, 0x3251,
+	0x3270, 0x3270, 0x3270, 0x3270, 0x3270, 0x3270, 0x328F, 0x32AF,
+	0x32CE, 0x32CE, 0x32CE, 0x32CE, 0x32CE, 0x32CE, 0x32ED, 0x330D,
+	0x332C, 0x332C, 0x332C, 0x332C, 0x332C, 0x332C, 0x334B, 0x336B,
+	0x338A, 0x338A, 0x338A, 0x338A, 0x338A, 0x338A, 0x33A9, 0x33C9,
+	0x33E8, 0x33E8, 0x33E8, 0x33E8, 0x33E8, 0x33E8, 0x3407, 0x3427,
+	0x3446, 0x3446, 0x3446, 0x3446, 0x3446, 0x3446, 0x3465, 0x3485,
+	0x34A4, 0x34A4, 0x34A4, 0x34A4, 0x34A4, 0x34A4, 0x34C3, 0x34E3,
+	0x3502, 0x3502, 0x3502, 0x3502, 0x3502, 0x3502, 0x3521, 0x3541,
+	0x3560, 0x3560, 0x3560, 0x3560, 0x3560, 0x3560, 0x357F, 0x359F,
+	0x35BE, 0x35BE, 0x35BE, 0x35BE, 0x35BE, 0x35BE, 0x35DD, 0x35FD,
+	0x361C, 0x361C, 0x361C, 0x361C, 0x361C, 0x361C, 0x363B, 0x365B,
+	0x367A, 0x367A, 0x367A, 0x367A, 0x367A, 0x367A, 0x3699, 0x36B9,
+	0x36D8, 0x36D8, 0x36D8, 0x36D8, 0x36D8, 0x36D8, 0x36F7, 0x3717,
+	0x3736, 0x3736, 0x3736, 0x3736, 0x3736, 0x3736, 0x3755, 0x3775,
+	0x3794, 0x3794, 0x3794, 0x3794, 0x3794, 0x3794, 0x37B3, 0x37D3,
+	0x37F2, 0x37F2, 0x37F2, 0x37F2, 0x37F2, 0x37F2, 0x3811, 0x3831,
+	0x3850, 0x3850, 0x3850, 0x3850, 0x3850, 0x3850, 0x386F, 0x388F,
+	0x38AE, 0x38AE, 0x38AE, 0x38AE, 0x38AE, 0x38AE, 0x38CD, 0x38ED,
+	0x390C, 0x390C, 0x390C, 0x390C, 0x390C, 0x390C, 0x392B, 0x394B,
+	0x396A, 0x396A, 0x396A, 0x396A, 0x396A, 0x396A, 0x3989, 0x39A9,
+	0x39C8, 0x39C8, 0x39C8, 0x39C8, 0x39C8, 0x39C8, 0x39E7, 0x3A07,
+	0x3A26, 0x3A26, 0x3A26, 0x3A26, 0x3A26, 0x3A26, 0x3A45, 0x3A65,
+	0x3A84, 0x3A84, 0x3A84, 0x3A84, 0x3A84, 0x3A84, 0x3AA3, 0x3AC3,
+	0x3AE2, 0x3AE2, 0x3AE2, 0x3AE2, 0x3AE2, 0x3AE2, 0x3B01, 0x3B21,
+	0x3B40, 0x3B40, 0x3B40, 0x3B40, 0x3B40, 0x3B40, 0x3B5F, 0x3B7F,
+	0x3B9E, 0x3B9E, 0x3B9E, 0x3B9E, 0x3B9E, 0x3B9E, 0x3BBD, 0x3BDD,
+	0x3BFC, 0x3BFC, 0x3BFC, 0x3BFC, 0x3BFC, 0x3BFC, 0x3C1B, 0x3C3B,
+	0x3C5A, 0x3C5A, 0x3C5A, 0x3C5A, 0x3C5A, 0x3C5A, 0x3C79, 0x3C99,
+	0x3CB8, 0x3CB8, 0x3CB8, 0x3CB8, 0x3CB8, 0x3CB8, 0x3CD7, 0x3CF7,
+	0x3D16, 0x3D16, 0x3D16, 0x3D16, 0x3D16, 0x3D16, 0x3D35, 0x3D55,
+	0x3D74, 0x3D74, 0x3D74, 0x3D74, 0x3D74, 0x3D74, 0x3D93, 0x3DB3,
+	0x3DD2, 0x3DD2, 0x3DD2, 0x3DD2, 0x3DD2, 0x3DD2, 0x3DF1, 0x3E11,
+	0x3E30, 0x3E30, 0x3E30, 0x3E30, 0x3E30, 0x3E30, 0x3E4F, 0x3E6F,
+	0x3E8E, 0x3E8E, 0x3E8E, 0x3E8E, 0x3E8E, 0x3E8E, 0x3EAD, 0x3ECD,
+	0x3EEC, 0x3EEC, 0x3EEC, 0x3EEC, 0x3EEC, 0x3EEC, 0x3F0B, 0x3F2B,
+	0x3F4A, 0x3F4A, 0x3F4A, 0x3F4A, 0x3F4A, 0x3F4A, 0x3F69, 0x3F89,
+	0x3FA8, 0x3FA8, 0x3FA8, 0x3FA8, 0x3FA8, 0x3FA8, 0x3FC7, 0x3FE7,
+	0x4006, 0x4006, 0x4006, 0x4006, 0x4006, 0x4006, 0x4025, 0x4045,
+	0x4064, 0x4064, 0x4064, 0x4064, 0x4064, 0x4064, 0x4083, 0x40A3,
+	0x40C2, 0x40C2, 0x40C2, 0x40C2, 0x40C2, 0x40C2, 0x40E1, 0x4101,
+	0x4120, 0x4120, 0x4120, 0x4120, 0x4120, 0x4120, 0x413F, 0x415F,
+	0x417E, 0x417E, 0x417E, 0x417E, 0x417E, 0x417E, 0x419D, 0x41BD,
+	0x41DC, 0x41DC, 0x41DC, 0x41DC, 0x41DC, 0x41DC, 0x41FB, 0x421B,
+	0x423A, 0x423A, 0x423A, 0x423A, 0x423A, 0x423A, 0x4259, 0x4279,
+};
+
+static
+const WCHAR oem2uni_code[] = {
+	0xAC02, 0xAC03, 0xAC05, 0xAC06, 0xAC0B, 0xAC0C, 0xAC0D, 0xAC0E,
+	0xAC0F, 0xAC18, 0xAC1E, 0xAC1F, 0xAC21, 0xAC22, 0xAC23, 0xAC25,
+	0xAC26, 0xAC27, 0xAC28, 0xAC29, 0xAC2A, 0xAC2B, 0xAC2E, 0xAC32,
+	0xAC33, 0xAC34, 0xAC35, 0xAC36, 0xAC37, 0xAC3A, 0xAC3B, 0xAC3D,
+	0xAC3E, 0xAC3F, 0xAC41, 0xAC42, 0xAC43, 0xAC44, 0xAC45, 0xAC46,
+	0xAC47, 0xAC48, 0xAC49, 0xAC4A, 0xAC4C, 0xAC4E, 0xAC4F, 0xAC50,
+	0xAC51, 0xAC52, 0xAC53, 0xAC55, 0xAC56, 0xAC57, 0xAC59, 0xAC5A,
+	0xAC5B, 0xAC5D, 0xAC5E, 0xAC5F, 0xAC60, 0xAC61, 0xAC62, 0xAC63,
+	0xAC64, 0xAC65, 0xAC66, 0xAC67, 0xAC68, 0xAC69, 0xAC6A, 0xAC6B,
+	0xAC6C, 0xAC6D, 0xAC6E, 0xAC6F, 0xAC72, 0xAC73, 0xAC75, 0xAC76,
+	0xAC79, 0xAC7B, 0xAC7C, 0xAC7D, 0xAC7E, 0xAC7F, 0xAC82, 0xAC87,
+	0xAC88, 0xAC8D, 0xAC8E, 0xAC8F, 0xAC91, 0xAC92, 0xAC93, 0xAC95,
+	0xAC96, 0xAC97, 0xAC98, 0xAC99, 0xAC9A, 0xAC9B, 0xAC9E, 0xACA2,
+	0xACA3, 0xACA4, 0xACA5, 0xACA6, 0xACA7, 0xACAB, 0xACAD, 0xACAE,
+	0xACB1, 0xACB2, 0xACB3, 0xACB4, 0xACB5, 0xACB6, 0xACB7, 0xACBA,
+	0xACBE, 0xACBF, 0xACC0, 0xACC2, 0xACC3, 0xACC5, 0xACC6, 0xACC7,
+	0xACC9, 0xACCA, 0xACCB, 0xACCD, 0xACCE, 0xACCF, 0xACD0, 0xACD1,
+	0xACD2, 0xACD3, 0xACD4, 0xACD6, 0xACD8, 0xACD9, 0xACDA, 0xACDB,
+	0xACDC, 0xACDD, 0xACDE, 0xACDF, 0xACE2, 0xACE3, 0xACE5, 0xACE6,
+	0xACE9, 0xACEB, 0xACED, 0xACEE, 0xACF2, 0xACF4, 0xACF7, 0xACF8,
+	0xACF9, 0xACFA, 0xACFB, 0xACFE, 0xACFF, 0xAD01, 0xAD02, 0xAD03,
+	0xAD05, 0xAD07, 0xAD08, 0xAD09, 0xAD0A, 0xAD0B, 0xAD0E, 0xAD10,
+	0xAD12, 0xAD13, 0xAD14, 0xAD15, 0xAD16, 0xAD17, 0xAD19, 0xAD1A,
+	0xAD1B, 0xAD1D, 0xAD1E, 0xAD1F, 0xAD21, 0xAD22, 0xAD23, 0xAD24,
+	0xAD25, 0xAD26, 0xAD27, 0xAD28, 0xAD2A, 0xAD2B, 0xAD2E, 0xAD2F,
+	0xAD30, 0xAD31, 0xAD32, 0xAD33, 0xAD36, 0xAD37, 0xAD39, 0xAD3A,
+	0xAD3B, 0xAD3D, 0xAD3E, 0xAD3F, 0xAD40, 0xAD41, 0xAD42, 0xAD43,
+	0xAD46, 0xAD48, 0xAD4A, 0xAD4B, 0xAD4C, 0xAD4D, 0xAD4E, 0xAD4F,
+	0xAD51, 0xAD52, 0xAD53, 0xAD55, 0xAD56, 0xAD57, 0xAD59, 0xAD5A,
+	0xAD5B, 0xAD5C, 0xAD5D, 0xAD5E, 0xAD5F, 0xAD60, 0xAD62, 0xAD64,
+	0xAD65, 0xAD66, 0xAD67, 0xAD68, 0xAD69, 0xAD6A, 0xAD6B, 0xAD6E,
+	0xAD6F, 0xAD71, 0xAD72, 0xAD77, 0xAD78, 0xAD79, 0xAD7A, 0xAD7E,
+	0xAD80, 0xAD83, 0xAD84, 0xAD85, 0xAD86, 0xAD87, 0xAD8A, 0xAD8B,
+	0xAD8D, 0xAD8E, 0xAD8F, 0xAD91, 0xAD92, 0xAD93, 0xAD94, 0xAD95,
+	0xAD96, 0xAD97, 0xAD98, 0xAD99, 0xAD9A, 0xAD9B, 0xAD9E, 0xAD9F,
+	0xADA0, 0xADA1, 0xADA2, 0xADA3, 0xADA5, 0xADA6, 0xADA7, 0xADA8,
+	0xADA9, 0xADAA, 0xADAB, 0xADAC, 0xADAD, 0xADAE, 0xADAF, 0xADB0,
+	0xADB1, 0xADB2, 0xADB3, 0xADB4, 0xADB5, 0xADB6, 0xADB8, 0xADB9,
+	0xADBA, 0xADBB, 0xADBC, 0xADBD, 0xADBE, 0xADBF, 0xADC2, 0xADC3,
+	0xADC5, 0xADC6, 0xADC7, 0xADC9, 0xADCA, 0xADCB, 0xADCC, 0xADCD,
+	0xADCE, 0xADCF, 0xADD2, 0xADD4, 0xADD5, 0xADD6, 0xADD7, 0xADD8,
+	0xADD9, 0xADDA, 0xADDB, 0xADDD, 0xADDE, 0xADDF, 0xADE1, 0xADE2,
+	0xADE3, 0xADE5, 0xADE6, 0xADE7, 0xADE8, 0xADE9, 0xADEA, 0xADEB,
+	0xADEC, 0xADED, 0xADEE, 0xADEF, 0xADF0, 0xADF1, 0xADF2, 0xADF3,
+	0xADF4, 0xADF5, 0xADF6, 0xADF7, 0xADFA, 0xADFB, 0xADFD, 0xADFE,
+	0xAE02, 0xAE03, 0xAE04, 0xAE05, 0xAE06, 0xAE07, 0xAE0A, 0xAE0C,
+	0xAE0E, 0xAE0F, 0xAE10, 0xAE11, 0xAE12, 0xAE13, 0xAE15, 0xAE16,
+	0xAE17, 0xAE18, 0xAE19, 0xAE1A, 0xAE1B, 0xAE1C, 0xAE1D, 0xAE1E,
+	0xAE1F, 0xAE20, 0xAE21, 0xAE22, 0xAE23, 0xAE24, 0xAE25, 0xAE26,
+	0xAE27, 0xAE28, 0xAE29, 0xAE2A, 0xAE2B, 0xAE2C, 0xAE2D, 0xAE2E,
+	0xAE2F, 0xAE32, 0xAE33, 0xAE35, 0xAE36, 0xAE39, 0xAE3B, 0xAE3C,
+	0xAE3D, 0xAE3E, 0xAE3F, 0xAE42, 0xAE44, 0xAE47, 0xAE48, 0xAE49,
+	0xAE4B, 0xAE4F, 0xAE51, 0xAE52, 0xAE53, 0xAE55, 0xAE57, 0xAE58,
+	0xAE59, 0xAE5A, 0xAE5B, 0xAE5E, 0xAE62, 0xAE63, 0xAE64, 0xAE66,
+	0xAE67, 0xAE6A, 0xAE6B, 0xAE6D, 0xAE6E, 0xAE6F, 0xAE71, 0xAE72,
+	0xAE73, 0xAE74, 0xAE75, 0xAE76, 0xAE77, 0xAE7A, 0xAE7E, 0xAE7F,
+	0xAE80, 0xAE81, 0xAE82, 0xAE83, 0xAE86, 0xAE87, 0xAE88, 0xAE89,
+	0xAE8A, 0xAE8B, 0xAE8D, 0xAE8E, 0xAE8F, 0xAE90, 0xAE91, 0xAE92,
+	0xAE93, 0xAE94, 0xAE95, 0xAE96, 0xAE97, 0xAE98, 0xAE99, 0xAE9A,
+	0xAE9B, 0xAE9C, 0xAE9D, 0xAE9E, 0xAE9F, 0xAEA0, 0xAEA1, 0xAEA2,
+	0xAEA3, 0xAEA4, 0xAEA5, 0xAEA6, 0xAEA7, 0xAEA8, 0xAEA9, 0xAEAA,
+	0xAEAB, 0xAEAC, 0xAEAD, 0xAEAE, 0xAEAF, 0xAEB0, 0xAEB1, 0xAEB2,
+	0xAEB3, 0xAEB4, 0xAEB5, 0xAEB6, 0xAEB7, 0xAEB8, 0xAEB9, 0xAEBA,
+	0xAEBB, 0xAEBF, 0xAEC1, 0xAEC2, 0xAEC3, 0xAEC5, 0xAEC6, 0xAEC7,
+	0xAEC8, 0xAEC9, 0xAECA, 0xAECB, 0xAECE, 0xAED2, 0xAED3, 0xAED4,
+	0xAED5, 0xAED6, 0xAED7, 0xAEDA, 0xAEDB, 0xAEDD, 0xAEDE, 0xAEDF,
+	0xAEE0, 0xAEE1, 0xAEE2, 0xAEE3, 0xAEE4, 0xAEE5, 0xAEE6, 0xAEE7,
+	0xAEE9, 0xAEEA, 0xAEEC, 0xAEEE, 0xAEEF, 0xAEF0, 0xAEF1, 0xAEF2,
+	0xAEF3, 0xAEF5, 0xAEF6, 0xAEF7, 0xAEF9, 0xAEFA, 0xAEFB, 0xAEFD,
+	0xAEFE, 0xAEFF, 0xAF00, 0xAF01, 0xAF02, 0xAF03, 0xAF04, 0xAF05,
+	0xAF06, 0xAF09, 0xAF0A, 0xAF0B, 0xAF0C, 0xAF0E, 0xAF0F, 0xAF11,
+	0xAF12, 0xAF13, 0xAF14, 0xAF15, 0xAF16, 0xAF17, 0xAF18, 0xAF19,
+	0xAF1A, 0xAF1B, 0xAF1C, 0xAF1D, 0xAF1E, 0xAF1F, 0xAF20, 0xAF21,
+	0xAF22, 0xAF23, 0xAF24, 0xAF25, 0xAF26, 0xAF27, 0xAF28, 0xAF29,
+	0xAF2A, 0xAF2B, 0xAF2E, 0xAF2F, 0xAF31, 0xAF33, 0xAF35, 0xAF36,
+	0xAF37, 0xAF38, 0xAF39, 0xAF3A, 0xAF3B, 0xAF3E, 0xAF40, 0xAF44,
+	0xAF45, 0xAF46, 0xAF47, 0xAF4A, 0xAF4B, 0xAF4C, 0xAF4D, 0xAF4E,
+	0xAF4F, 0xAF51, 0xAF52, 0xAF53, 0xAF54, 0xAF55, 0xAF56, 0xAF57,
+	0xAF58, 0xAF59, 0xAF5A, 0xAF5B, 0xAF5E, 0xAF5F, 0xAF60, 0xAF61,
+	0xAF62, 0xAF63, 0xAF66, 0xAF67, 0xAF68, 0xAF69, 0xAF6A, 0xAF6B,
+	0xAF6C, 0xAF6D, 0xAF6E, 0xAF6F, 0xAF70, 0xAF71, 0xAF72, 0xAF73,
+	0xAF74, 0xAF75, 0xAF76, 0xAF77, 0xAF78, 0xAF7A, 0xAF7B, 0xAF7C,
+	0xAF7D, 0xAF7E, 0xAF7F, 0xAF81, 0xAF82, 0xAF83, 0xAF85, 0xAF86,
+	0xAF87, 0xAF89, 0xAF8A, 0xAF8B, 0xAF8C, 0xAF8D, 0xAF8E, 0xAF8F,
+	0xAF92, 0xAF93, 0xAF94, 0xAF96, 0xAF97, 0xAF98, 0xAF99, 0xAF9A,
+	0xAF9B, 0xAF9D, 0xAF9E, 0xAF9F, 0xAFA0, 0xAFA1, 0xAFA2, 0xAFA3,
+	0xAFA4, 0xAFA5, 0xAFA6, 0xAFA7, 0xAFA8, 0xAFA9, 0xAFAA, 0xAFAB,
+	0xAFAC, 0xAFAD, 0xAFAE, 0xAFAF, 0xAFB0, 0xAFB1, 0xAFB2, 0xAFB3,
+	0xAFB4, 0xAFB5, 0xAFB6, 0xAFB7, 0xAFBA, 0xAFBB, 0xAFBD, 0xAFBE,
+	0xAFBF, 0xAFC1, 0xAFC2, 0xAFC3, 0xAFC4, 0xAFC5, 0xAFC6, 0xAFCA,
+	0xAFCC, 0xAFCF, 0xAFD0, 0xAFD1, 0xAFD2, 0xAFD3, 0xAFD5, 0xAFD6,
+	0xAFD7, 0xAFD8, 0xAFD9, 0xAFDA, 0xAFDB, 0xAFDD, 0xAFDE, 0xAFDF,
+	0xAFE0, 0xAFE1, 0xAFE2, 0xAFE3, 0xAFE4, 0xAFE5, 0xAFE6, 0xAFE7,
+	0xAFEA, 0xAFEB, 0xAFEC, 0xAFED, 0xAFEE, 0xAFEF, 0xAFF2, 0xAFF3,
+	0xAFF5, 0xAFF6, 0xAFF7, 0xAFF9, 0xAFFA, 0xAFFB, 0xAFFC, 0xAFFD,
+	0xAFFE, 0xAFFF, 0xB002, 0xB003, 0xB005, 0xB006, 0xB007, 0xB008,
+	0xB009, 0xB00A, 0xB00B, 0xB00D, 0xB00E, 0xB00F, 0xB011, 0xB012,
+	0xB013, 0xB015, 0xB016, 0xB017, 0xB018, 0xB019, 0xB01A, 0xB01B,
+	0xB01E, 0xB01F, 0xB020, 0xB021, 0xB022, 0xB023, 0xB024, 0xB025,
+	0xB026, 0xB027, 0xB029, 0xB02A, 0xB02B, 0xB02C, 0xB02D, 0xB02E,
+	0xB02F, 0xB030, 0xB031, 0xB032, 0xB033, 0xB034, 0xB035, 0xB036,
+	0xB037, 0xB038, 0xB039, 0xB03A, 0xB03B, 0xB03C, 0xB03D, 0xB03E,
+	0xB03F, 0xB040, 0xB041, 0xB042, 0xB043, 0xB046, 0xB047, 0xB049,
+	0xB04B, 0xB04D, 0xB04F, 0xB050, 0xB051, 0xB052, 0xB056, 0xB058,
+	0xB05A, 0xB05B, 0xB05C, 0xB05E, 0xB05F, 0xB060, 0xB061, 0xB062,
+	0xB063, 0xB064, 0xB065, 0xB066, 0xB067, 0xB068, 0xB069, 0xB06A,
+	0xB06B, 0xB06C, 0xB06D, 0xB06E, 0xB06F, 0xB070, 0xB071, 0xB072,
+	0xB073, 0xB074, 0xB075, 0xB076, 0xB077, 0xB078, 0xB079, 0xB07A,
+	0xB07B, 0xB07E, 0xB07F, 0xB081, 0xB082, 0xB083, 0xB085, 0xB086,
+	0xB087, 0xB088, 0xB089, 0xB08A, 0xB08B, 0xB08E, 0xB090, 0xB092,
+	0xB093, 0xB094, 0xB095, 0xB096, 0xB097, 0xB09B, 0xB09D, 0xB09E,
+	0xB0A3, 0xB0A4, 0xB0A5, 0xB0A6, 0xB0A7, 0xB0AA, 0xB0B0, 0xB0B2,
+	0xB0B6, 0xB0B7, 0xB0B9, 0xB0BA, 0xB0BB, 0xB0BD, 0xB0BE, 0xB0BF,
+	0xB0C0, 0xB0C1, 0xB0C2, 0xB0C3, 0xB0C6, 0xB0CA, 0xB0CB, 0xB0CC,
+	0xB0CD, 0xB0CE, 0xB0CF, 0xB0D2, 0xB0D3, 0xB0D5, 0xB0D6, 0xB0D7,
+	0xB0D9, 0xB0DA, 0xB0DB, 0xB0DC, 0xB0DD, 0xB0DE, 0xB0DF, 0xB0E1,
+	0xB0E2, 0xB0E3, 0xB0E4, 0xB0E6, 0xB0E7, 0xB0E8, 0xB0E9, 0xB0EA,
+	0xB0EB, 0xB0EC, 0xB0ED, 0xB0EE, 0xB0EF, 0xB0F0, 0xB0F1, 0xB0F2,
+	0xB0F3, 0xB0F4, 0xB0F5, 0xB0F6, 0xB0F7, 0xB0F8, 0xB0F9, 0xB0FA,
+	0xB0FB, 0xB0FC, 0xB0FD, 0xB0FE, 0xB0FF, 0xB100, 0xB101, 0xB102,
+	0xB103, 0xB104, 0xB105, 0xB106, 0xB107, 0xB10A, 0xB10D, 0xB10E,
+	0xB10F, 0xB111, 0xB114, 0xB115, 0xB116, 0xB117, 0xB11A, 0xB11E,
+	0xB11F, 0xB120, 0xB121, 0xB122, 0xB126, 0xB127, 0xB129, 0xB12A,
+	0xB12B, 0xB12D, 0xB12E, 0xB12F, 0xB130, 0xB131, 0xB132, 0xB133,
+	0xB136, 0xB13A, 0xB13B, 0xB13C, 0xB13D, 0xB13E, 0xB13F, 0xB142,
+	0xB143, 0xB145, 0xB146, 0xB147, 0xB149, 0xB14A, 0xB14B, 0xB14C,
+	0xB14D, 0xB14E, 0xB14F, 0xB152, 0xB153, 0xB156, 0xB157, 0xB159,
+	0xB15A, 0xB15B, 0xB15D, 0xB15E, 0xB15F, 0xB161, 0xB162, 0xB163,
+	0xB164, 0xB165, 0xB166, 0xB167, 0xB168, 0xB169, 0xB16A, 0xB16B,
+	0xB16C, 0xB16D, 0xB16E, 0xB16F, 0xB170, 0xB171, 0xB172, 0xB173,
+	0xB174, 0xB175, 0xB176, 0xB177, 0xB17A, 0xB17B, 0xB17D, 0xB17E,
+	0xB17F, 0xB181, 0xB183, 0xB184, 0xB185, 0xB186, 0xB187, 0xB18A,
+	0xB18C, 0xB18E, 0xB18F, 0xB190, 0xB191, 0xB195, 0xB196, 0xB197,
+	0xB199, 0xB19A, 0xB19B, 0xB19D, 0xB19E, 0xB19F, 0xB1A0, 0xB1A1,
+	0xB1A2, 0xB1A3, 0xB1A4, 0xB1A5, 0xB1A6, 0xB1A7, 0xB1A9, 0xB1AA,
+	0xB1AB, 0xB1AC, 0xB1AD, 0xB1AE, 0xB1AF, 0xB1B0, 0xB1B1, 0xB1B2,
+	0xB1B3, 0xB1B4, 0xB1B5, 0xB1B6, 0xB1B7, 0xB1B8, 0xB1B9, 0xB1BA,
+	0xB1BB, 0xB1BC, 0xB1BD, 0xB1BE, 0xB1BF, 0xB1C0, 0xB1C1, 0xB1C2,
+	0xB1C3, 0xB1C4, 0xB1C5, 0xB1C6, 0xB1C7, 0xB1C8, 0xB1C9, 0xB1CA,
+	0xB1CB, 0xB1CD, 0xB1CE, 0xB1CF, 0xB1D1, 0xB1D2, 0xB1D3, 0xB1D5,
+	0xB1D6, 0xB1D7, 0xB1D8, 0xB1D9, 0xB1DA, 0xB1DB, 0xB1DE, 0xB1E0,
+	0xB1E1, 0xB1E2, 0xB1E3, 0xB1E4, 0xB1E5, 0xB1E6, 0xB1E7, 0xB1EA,
+	0xB1EB, 0xB1ED, 0xB1EE, 0xB1EF, 0xB1F1, 0xB1F2, 0xB1F3, 0xB1F4,
+	0xB1F5, 0xB1F6, 0xB1F7, 0xB1F8, 0xB1FA, 0xB1FC, 0xB1FE, 0xB1FF,
+	0xB200, 0xB201, 0xB202, 0xB203, 0xB206, 0xB207, 0xB209, 0xB20A,
+	0xB20D, 0xB20E, 0xB20F, 0xB210, 0xB211, 0xB212, 0xB213, 0xB216,
+	0xB218, 0xB21A, 0xB21B, 0xB21C, 0xB21D, 0xB21E, 0xB21F, 0xB221,
+	0xB222, 0xB223, 0xB224, 0xB225, 0xB226, 0xB227, 0xB228, 0xB229,
+	0xB22A, 0xB22B, 0xB22C, 0xB22D, 0xB22E, 0xB22F, 0xB230, 0xB231,
+	0xB232, 0xB233, 0xB235, 0xB236, 0xB237, 0xB238, 0xB239, 0xB23A,
+	0xB23B, 0xB23D, 0xB23E, 0xB23F, 0xB240, 0xB241, 0xB242, 0xB243,
+	0xB244, 0xB245, 0xB246, 0xB247, 0xB248, 0xB249, 0xB24A, 0xB24B,
+	0xB24C, 0xB24D, 0xB24E, 0xB24F, 0xB250, 0xB251, 0xB252, 0xB253,
+	0xB254, 0xB255, 0xB256, 0xB257, 0xB259, 0xB25A, 0xB25B, 0xB25D,
+	0xB25E, 0xB25F, 0xB261, 0xB262, 0xB263, 0xB264, 0xB265, 0xB266,
+	0xB267, 0xB26A, 0xB26B, 0xB26C, 0xB26D, 0xB26E, 0xB26F, 0xB270,
+	0xB271, 0xB272, 0xB273, 0xB276, 0xB277, 0xB278, 0xB279, 0xB27A,
+	0xB27B, 0xB27D, 0xB27E, 0xB27F, 0xB280, 0xB281, 0xB282, 0xB283,
+	0xB286, 0xB287, 0xB288, 0xB28A, 0xB28B, 0xB28C, 0xB28D, 0xB28E,
+	0xB28F, 0xB292, 0xB293, 0xB295, 0xB296, 0xB297, 0xB29B, 0xB29C,
+	0xB29D, 0xB29E, 0xB29F, 0xB2A2, 0xB2A4, 0xB2A7, 0xB2A8, 0xB2A9,
+	0xB2AB, 0xB2AD, 0xB2AE, 0xB2AF, 0xB2B1, 0xB2B2, 0xB2B3, 0xB2B5,
+	0xB2B6, 0xB2B7, 0xB2B8, 0xB2B9, 0xB2BA, 0xB2BB, 0xB2BC, 0xB2BD,
+	0xB2BE, 0xB2BF, 0xB2C0, 0xB2C1, 0xB2C2, 0xB2C3, 0xB2C4, 0xB2C5,
+	0xB2C6, 0xB2C7, 0xB2CA, 0xB2CB, 0xB2CD, 0xB2CE, 0xB2CF, 0xB2D1,
+	0xB2D3, 0xB2D4, 0xB2D5, 0xB2D6, 0xB2D7, 0xB2DA, 0xB2DC, 0xB2DE,
+	0xB2DF, 0xB2E0, 0xB2E1, 0xB2E3, 0xB2E7, 0xB2E9, 0xB2EA, 0xB2F0,
+	0xB2F1, 0xB2F2, 0xB2F6, 0xB2FC, 0xB2FD, 0xB2FE, 0xB302, 0xB303,
+	0xB305, 0xB306, 0xB307, 0xB309, 0xB30A, 0xB30B, 0xB30C, 0xB30D,
+	0xB30E, 0xB30F, 0xB312, 0xB316, 0xB317, 0xB318, 0xB319, 0xB31A,
+	0xB31B, 0xB31D, 0xB31E, 0xB31F, 0xB320, 0xB321, 0xB322, 0xB323,
+	0xB324, 0xB325, 0xB326, 0xB327, 0xB328, 0xB329, 0xB32A, 0xB32B,
+	0xB32C, 0xB32D, 0xB32E, 0xB32F, 0xB330, 0xB331, 0xB332, 0xB333,
+	0xB334, 0xB335, 0xB336, 0xB337, 0xB338, 0xB339, 0xB33A, 0xB33B,
+	0xB33C, 0xB33D, 0xB33E, 0xB33F, 0xB340, 0xB341, 0xB342, 0xB343,
+	0xB344, 0xB345, 0xB346, 0xB347, 0xB348, 0xB349, 0xB34A, 0xB34B,
+	0xB34C, 0xB34D, 0xB34E, 0xB34F, 0xB350, 0xB351, 0xB352, 0xB353,
+	0xB357, 0xB359, 0xB35A, 0xB35D, 0xB360, 0xB361, 0xB362, 0xB363,
+	0xB366, 0xB368, 0xB36A, 0xB36C, 0xB36D, 0xB36F, 0xB372, 0xB373,
+	0xB375, 0xB376, 0xB377, 0xB379, 0xB37A, 0xB37B, 0xB37C, 0xB37D,
+	0xB37E, 0xB37F, 0xB382, 0xB386, 0xB387, 0xB388, 0xB389, 0xB38A,
+	0xB38B, 0xB38D, 0xB38E, 0xB38F, 0xB391, 0xB392, 0xB393, 0xB395,
+	0xB396, 0xB397, 0xB398, 0xB399, 0xB39A, 0xB39B, 0xB39C, 0xB39D,
+	0xB39E, 0xB39F, 0xB3A2, 0xB3A3, 0xB3A4, 0xB3A5, 0xB3A6, 0xB3A7,
+	0xB3A9, 0xB3AA, 0xB3AB, 0xB3AD, 0xB3AE, 0xB3AF, 0xB3B0, 0xB3B1,
+	0xB3B2, 0xB3B3, 0xB3B4, 0xB3B5, 0xB3B6, 0xB3B7, 0xB3B8, 0xB3B9,
+	0xB3BA, 0xB3BB, 0xB3BC, 0xB3BD, 0xB3BE, 0xB3BF, 0xB3C0, 0xB3C1,
+	0xB3C2, 0xB3C3, 0xB3C6, 0xB3C7, 0xB3C9, 0xB3CA, 0xB3CD, 0xB3CF,
+	0xB3D1, 0xB3D2, 0xB3D3, 0xB3D6, 0xB3D8, 0xB3DA, 0xB3DC, 0xB3DE,
+	0xB3DF, 0xB3E1, 0xB3E2, 0xB3E3, 0xB3E5, 0xB3E6, 0xB3E7, 0xB3E9,
+	0xB3EA, 0xB3EB, 0xB3EC, 0xB3ED, 0xB3EE, 0xB3EF, 0xB3F0, 0xB3F1,
+	0xB3F2, 0xB3F3, 0xB3F4, 0xB3F5, 0xB3F6, 0xB3F7, 0xB3F8, 0xB3F9,
+	0xB3FA, 0xB3FB, 0xB3FD, 0xB3FE, 0xB3FF, 0xB400, 0xB401, 0xB402,
+	0xB403, 0xB404, 0xB405, 0xB406, 0xB407, 0xB408, 0xB409, 0xB40A,
+	0xB40B, 0xB40C, 0xB40D, 0xB40E, 0xB40F, 0xB411, 0xB412, 0xB413,
+	0xB414, 0xB415, 0xB416, 0xB417, 0xB419, 0xB41A, 0xB41B, 0xB41D,
+	0xB41E, 0xB41F, 0xB421, 0xB422, 0xB423, 0xB424, 0xB425, 0xB426,
+	0xB427, 0xB42A, 0xB42C, 0xB42D, 0xB42E, 0xB42F, 0xB430, 0xB431,
+	0xB432, 0xB433, 0xB435, 0xB436, 0xB437, 0xB438, 0xB439, 0xB43A,
+	0xB43B, 0xB43C, 0xB43D, 0xB43E, 0xB43F, 0xB440, 0xB441, 0xB442,
+	0xB443, 0xB444, 0xB445, 0xB446, 0xB447, 0xB448, 0xB449, 0xB44A,
+	0xB44B, 0xB44C, 0xB44D, 0xB44E, 0xB44F, 0xB452, 0xB453, 0xB455,
+	0xB456, 0xB457, 0xB459, 0xB45A, 0xB45B, 0xB45C, 0xB45D, 0xB45E,
+	0xB45F, 0xB462, 0xB464, 0xB466, 0xB467, 0xB468, 0xB469, 0xB46A,
+	0xB46B, 0xB46D, 0xB46E, 0xB46F, 0xB470, 0xB471, 0xB472, 0xB473,
+	0xB474, 0xB475, 0xB476, 0xB477, 0xB478, 0xB479, 0xB47A, 0xB47B,
+	0xB47C, 0xB47D, 0xB47E, 0xB47F, 0xB481, 0xB482, 0xB483, 0xB484,
+	0xB485, 0xB486, 0xB487, 0xB489, 0xB48A, 0xB48B, 0xB48C, 0xB48D,
+	0xB48E, 0xB48F, 0xB490, 0xB491, 0xB492, 0xB493, 0xB494, 0xB495,
+	0xB496, 0xB497, 0xB498, 0xB499, 0xB49A, 0xB49B, 0xB49C, 0xB49E,
+	0xB49F, 0xB4A0, 0xB4A1, 0xB4A2, 0xB4A3, 0xB4A5, 0xB4A6, 0xB4A7,
+	0xB4A9, 0xB4AA, 0xB4AB, 0xB4AD, 0xB4AE, 0xB4AF, 0xB4B0, 0xB4B1,
+	0xB4B2, 0xB4B3, 0xB4B4, 0xB4B6, 0xB4B8, 0xB4BA, 0xB4BB, 0xB4BC,
+	0xB4BD, 0xB4BE, 0xB4BF, 0xB4C1, 0xB4C2, 0xB4C3, 0xB4C5, 0xB4C6,
+	0xB4C7, 0xB4C9, 0xB4CA, 0xB4CB, 0xB4CC, 0xB4CD, 0xB4CE, 0xB4CF,
+	0xB4D1, 0xB4D2, 0xB4D3, 0xB4D4, 0xB4D6, 0xB4D7, 0xB4D8, 0xB4D9,
+	0xB4DA, 0xB4DB, 0xB4DE, 0xB4DF, 0xB4E1, 0xB4E2, 0xB4E5, 0xB4E7,
+	0xB4E8, 0xB4E9, 0xB4EA, 0xB4EB, 0xB4EE, 0xB4F0, 0xB4F2, 0xB4F3,
+	0xB4F4, 0xB4F5, 0xB4F6, 0xB4F7, 0xB4F9, 0xB4FA, 0xB4FB, 0xB4FC,
+	0xB4FD, 0xB4FE, 0xB4FF, 0xB500, 0xB501, 0xB502, 0xB503, 0xB504,
+	0xB505, 0xB506, 0xB507, 0xB508, 0xB509, 0xB50A, 0xB50B, 0xB50C,
+	0xB50D, 0xB50E, 0xB50F, 0xB510, 0xB511, 0xB512, 0xB513, 0xB516,
+	0xB517, 0xB519, 0xB51A, 0xB51D, 0xB51E, 0xB51F, 0xB520, 0xB521,
+	0xB522, 0xB523, 0xB526, 0xB52B, 0xB52C, 0xB52D, 0xB52E, 0xB52F,
+	0xB532, 0xB533, 0xB535, 0xB536, 0xB537, 0xB539, 0xB53A, 0xB53B,
+	0xB53C, 0xB53D, 0xB53E, 0xB53F, 0xB542, 0xB546, 0xB547, 0xB548,
+	0xB549, 0xB54A, 0xB54E, 0xB54F, 0xB551, 0xB552, 0xB553, 0xB555,
+	0xB556, 0xB557, 0xB558, 0xB559, 0xB55A, 0xB55B, 0xB55E, 0xB562,
+	0xB563, 0xB564, 0xB565, 0xB566, 0xB567, 0xB568, 0xB569, 0xB56A,
+	0xB56B, 0xB56C, 0xB56D, 0xB56E, 0xB56F, 0xB570, 0xB571, 0xB572,
+	0xB573, 0xB574, 0xB575, 0xB576, 0xB577, 0xB578, 0xB579, 0xB57A,
+	0xB57B, 0xB57C, 0xB57D, 0xB57E, 0xB57F, 0xB580, 0xB581, 0xB582,
+	0xB583, 0xB584, 0xB585, 0xB586, 0xB587, 0xB588, 0xB589, 0xB58A,
+	0xB58B, 0xB58C, 0xB58D, 0xB58E, 0xB58F, 0xB590, 0xB591, 0xB592,
+	0xB593, 0xB594, 0xB595, 0xB596, 0xB597, 0xB598, 0xB599, 0xB59A,
+	0xB59B, 0xB59C, 0xB59D, 0xB59E, 0xB59F, 0xB5A2, 0xB5A3, 0xB5A5,
+	0xB5A6, 0xB5A7, 0xB5A9, 0xB5AC, 0xB5AD, 0xB5AE, 0xB5AF, 0xB5B2,
+	0xB5B6, 0xB5B7, 0xB5B8, 0xB5B9, 0xB5BA, 0xB5BE, 0xB5BF, 0xB5C1,
+	0xB5C2, 0xB5C3, 0xB5C5, 0xB5C6, 0xB5C7, 0xB5C8, 0xB5C9, 0xB5CA,
+	0xB5CB, 0xB5CE, 0xB5D2, 0xB5D3, 0xB5D4, 0xB5D5, 0xB5D6, 0xB5D7,
+	0xB5D9, 0xB5DA, 0xB5DB, 0xB5DC, 0xB5DD, 0xB5DE, 0xB5DF, 0xB5E0,
+	0xB5E1, 0xB5E2, 0xB5E3, 0xB5E4, 0xB5E5, 0xB5E6, 0xB5E7, 0xB5E8,
+	0xB5E9, 0xB5EA, 0xB5EB, 0xB5ED, 0xB5EE, 0xB5EF, 0xB5F0, 0xB5F1,
+	0xB5F2, 0xB5F3, 0xB5F4, 0xB5F5, 0xB5F6, 0xB5F7, 0xB5F8, 0xB5F9,
+	0xB5FA, 0xB5FB, 0xB5FC, 0xB5FD, 0xB5FE, 0xB5FF, 0xB600, 0xB601,
+	0xB602, 0xB603, 0xB604, 0xB605, 0xB606, 0xB607, 0xB608, 0xB609,
+	0xB60A, 0xB60B, 0xB60C, 0xB60D, 0xB60E, 0xB60F, 0xB612, 0xB613,
+	0xB615, 0xB616, 0xB617, 0xB619, 0xB61A, 0xB61B, 0xB61C, 0xB61D,
+	0xB61E, 0xB61F, 0xB620, 0xB621, 0xB622, 0xB623, 0xB624, 0xB626,
+	0xB627, 0xB628, 0xB629, 0xB62A, 0xB62B, 0xB62D, 0xB62E, 0xB62F,
+	0xB630, 0xB631, 0xB632, 0xB633, 0xB635, 0xB636, 0xB637, 0xB638,
+	0xB639, 0xB63A, 0xB63B, 0xB63C, 0xB63D, 0xB63E, 0xB63F, 0xB640,
+	0xB641, 0xB642, 0xB643, 0xB644, 0xB645, 0xB646, 0xB647, 0xB649,
+	0xB64A, 0xB64B, 0xB64C, 0xB64D, 0xB64E, 0xB64F, 0xB650, 0xB651,
+	0xB652, 0xB653, 0xB654, 0xB655, 0xB656, 0xB657, 0xB658, 0xB659,
+	0xB65A, 0xB65B, 0xB65C, 0xB65D, 0xB65E, 0xB65F, 0xB660, 0xB661,
+	0xB662, 0xB663, 0xB665, 0xB666, 0xB667, 0xB669, 0xB66A, 0xB66B,
+	0xB66C, 0xB66D, 0xB66E, 0xB66F, 0xB670, 0xB671, 0xB672, 0xB673,
+	0xB674, 0xB675, 0xB676, 0xB677, 0xB678, 0xB679, 0xB67A, 0xB67B,
+	0xB67C, 0xB67D, 0xB67E, 0xB67F, 0xB680, 0xB681, 0xB682, 0xB683,
+	0xB684, 0xB685, 0xB686, 0xB687, 0xB688, 0xB689, 0xB68A, 0xB68B,
+	0xB68C, 0xB68D, 0xB68E, 0xB68F, 0xB690, 0xB691, 0xB692, 0xB693,
+	0xB694, 0xB695, 0xB696, 0xB697, 0xB698, 0xB699, 0xB69A, 0xB69B,
+	0xB69E, 0xB69F, 0xB6A1, 0xB6A2, 0xB6A3, 0xB6A5, 0xB6A6, 0xB6A7,
+	0xB6A8, 0xB6A9, 0xB6AA, 0xB6AD, 0xB6AE, 0xB6AF, 0xB6B0, 0xB6B2,
+	0xB6B3, 0xB6B4, 0xB6B5, 0xB6B6, 0xB6B7, 0xB6B8, 0xB6B9, 0xB6BA,
+	0xB6BB, 0xB6BC, 0xB6BD, 0xB6BE, 0xB6BF, 0xB6C0, 0xB6C1, 0xB6C2,
+	0xB6C3, 0xB6C4, 0xB6C5, 0xB6C6, 0xB6C7, 0xB6C8, 0xB6C9, 0xB6CA,
+	0xB6CB, 0xB6CC, 0xB6CD, 0xB6CE, 0xB6CF, 0xB6D0, 0xB6D1, 0xB6D2,
+	0xB6D3, 0xB6D5, 0xB6D6, 0xB6D7, 0xB6D8, 0xB6D9, 0xB6DA, 0xB6DB,
+	0xB6DC, 0xB6DD, 0xB6DE, 0xB6DF, 0xB6E0, 0xB6E1, 0xB6E2, 0xB6E3,
+	0xB6E4, 0xB6E5, 0xB6E6, 0xB6E7, 0xB6E8, 0xB6E9, 0xB6EA, 0xB6EB,
+	0xB6EC, 0xB6ED, 0xB6EE, 0xB6EF, 0xB6F1, 0xB6F2, 0xB6F3, 0xB6F5,
+	0xB6F6, 0xB6F7, 0xB6F9, 0xB6FA, 0xB6FB, 0xB6FC, 0xB6FD, 0xB6FE,
+	0xB6FF, 0xB702, 0xB703, 0xB704, 0xB706, 0xB707, 0xB708, 0xB709,
+	0xB70A, 0xB70B, 0xB70C, 0xB70D, 0xB70E, 0xB70F, 0xB710, 0xB711,
+	0xB712, 0xB713, 0xB714, 0xB715, 0xB716, 0xB717, 0xB718, 0xB719,
+	0xB71A, 0xB71B, 0xB71C, 0xB71D, 0xB71E, 0xB71F, 0xB720, 0xB721,
+	0xB722, 0xB723, 0xB724, 0xB725, 0xB726, 0xB727, 0xB72A, 0xB72B,
+	0xB72D, 0xB72E, 0xB731, 0xB732, 0xB733, 0xB734, 0xB735, 0xB736,
+	0xB737, 0xB73A, 0xB73C, 0xB73D, 0xB73E, 0xB73F, 0xB740, 0xB741,
+	0xB742, 0xB743, 0xB745, 0xB746, 0xB747, 0xB749, 0xB74A, 0xB74B,
+	0xB74D, 0xB74E, 0xB74F, 0xB750, 0xB751, 0xB752, 0xB753, 0xB756,
+	0xB757, 0xB758, 0xB759, 0xB75A, 0xB75B, 0xB75C, 0xB75D, 0xB75E,
+	0xB75F, 0xB761, 0xB762, 0xB763, 0xB765, 0xB766, 0xB767, 0xB769,
+	0xB76A, 0xB76B, 0xB76C, 0xB76D, 0xB76E, 0xB76F, 0xB772, 0xB774,
+	0xB776, 0xB777, 0xB778, 0xB779, 0xB77A, 0xB77B, 0xB77E, 0xB77F,
+	0xB781, 0xB782, 0xB783, 0xB785, 0xB786, 0xB787, 0xB788, 0xB789,
+	0xB78A, 0xB78B, 0xB78E, 0xB793, 0xB794, 0xB795, 0xB79A, 0xB79B,
+	0xB79D, 0xB79E, 0xB79F, 0xB7A1, 0xB7A2, 0xB7A3, 0xB7A4, 0xB7A5,
+	0xB7A6, 0xB7A7, 0xB7AA, 0xB7AE, 0xB7AF, 0xB7B0, 0xB7B1, 0xB7B2,
+	0xB7B3, 0xB7B6, 0xB7B7, 0xB7B9, 0xB7BA, 0xB7BB, 0xB7BC, 0xB7BD,
+	0xB7BE, 0xB7BF, 0xB7C0, 0xB7C1, 0xB7C2, 0xB7C3, 0xB7C4, 0xB7C5,
+	0xB7C6, 0xB7C8, 0xB7CA, 0xB7CB, 0xB7CC, 0xB7CD, 0xB7CE, 0xB7CF,
+	0xB7D0, 0xB7D1, 0xB7D2, 0xB7D3, 0xB7D4, 0xB7D5, 0xB7D6, 0xB7D7,
+	0xB7D8, 0xB7D9, 0xB7DA, 0xB7DB, 0xB7DC, 0xB7DD, 0xB7DE, 0xB7DF,
+	0xB7E0, 0xB7E1, 0xB7E2, 0xB7E3, 0xB7E4, 0xB7E5, 0xB7E6, 0xB7E7,
+	0xB7E8, 0xB7E9, 0xB7EA, 0xB7EB, 0xB7EE, 0xB7EF, 0xB7F1, 0xB7F2,
+	0xB7F3, 0xB7F5, 0xB7F6, 0xB7F7, 0xB7F8, 0xB7F9, 0xB7FA, 0xB7FB,
+	0xB7FE, 0xB802, 0xB803, 0xB804, 0xB805, 0xB806, 0xB80A, 0xB80B,
+	0xB80D, 0xB80E, 0xB80F, 0xB811, 0xB812, 0xB813, 0xB814, 0xB815,
+	0xB816, 0xB817, 0xB81A, 0xB81C, 0xB81E, 0xB81F, 0xB820, 0xB821,
+	0xB822, 0xB823, 0xB826, 0xB827, 0xB829, 0xB82A, 0xB82B, 0xB82D,
+	0xB82E, 0xB82F, 0xB830, 0xB831, 0xB832, 0xB833, 0xB836, 0xB83A,
+	0xB83B, 0xB83C, 0xB83D, 0xB83E, 0xB83F, 0xB841, 0xB842, 0xB843,
+	0xB845, 0xB846, 0xB847, 0xB848, 0xB849, 0xB84A, 0xB84B, 0xB84C,
+	0xB84D, 0xB84E, 0xB84F, 0xB850, 0xB852, 0xB854, 0xB855, 0xB856,
+	0xB857, 0xB858, 0xB859, 0xB85A, 0xB85B, 0xB85E, 0xB85F, 0xB861,
+	0xB862, 0xB863, 0xB865, 0xB866, 0xB867, 0xB868, 0xB869, 0xB86A,
+	0xB86B, 0xB86E, 0xB870, 0xB872, 0xB873, 0xB874, 0xB875, 0xB876,
+	0xB877, 0xB879, 0xB87A, 0xB87B, 0xB87D, 0xB87E, 0xB87F, 0xB880,
+	0xB881, 0xB882, 0xB883, 0xB884, 0xB885, 0xB886, 0xB887, 0xB888,
+	0xB889, 0xB88A, 0xB88B, 0xB88C, 0xB88E, 0xB88F, 0xB890, 0xB891,
+	0xB892, 0xB893, 0xB894, 0xB895, 0xB896, 0xB897, 0xB898, 0xB899,
+	0xB89A, 0xB89B, 0xB89C, 0xB89D, 0xB89E, 0xB89F, 0xB8A0, 0xB8A1,
+	0xB8A2, 0xB8A3, 0xB8A4, 0xB8A5, 0xB8A6, 0xB8A7, 0xB8A9, 0xB8AA,
+	0xB8AB, 0xB8AC, 0xB8AD, 0xB8AE, 0xB8AF, 0xB8B1, 0xB8B2, 0xB8B3,
+	0xB8B5, 0xB8B6, 0xB8B7, 0xB8B9, 0xB8BA, 0xB8BB, 0xB8BC, 0xB8BD,
+	0xB8BE, 0xB8BF, 0xB8C2, 0xB8C4, 0xB8C6, 0xB8C7, 0xB8C8, 0xB8C9,
+	0xB8CA, 0xB8CB, 0xB8CD, 0xB8CE, 0xB8CF, 0xB8D1, 0xB8D2, 0xB8D3,
+	0xB8D5, 0xB8D6, 0xB8D7, 0xB8D8, 0xB8D9, 0xB8DA, 0xB8DB, 0xB8DC,
+	0xB8DE, 0xB8E0, 0xB8E2, 0xB8E3, 0xB8E4, 0xB8E5, 0xB8E6, 0xB8E7,
+	0xB8EA, 0xB8EB, 0xB8ED, 0xB8EE, 0xB8EF, 0xB8F1, 0xB8F2, 0xB8F3,
+	0xB8F4, 0xB8F5, 0xB8F6, 0xB8F7, 0xB8FA, 0xB8FC, 0xB8FE, 0xB8FF,
+	0xB900, 0xB901, 0xB902, 0xB903, 0xB905, 0xB906, 0xB907, 0xB908,
+	0xB909, 0xB90A, 0xB90B, 0xB90C, 0xB90D, 0xB90E, 0xB90F, 0xB910,
+	0xB911, 0xB912, 0xB913, 0xB914, 0xB915, 0xB916, 0xB917, 0xB919,
+	0xB91A, 0xB91B, 0xB91C, 0xB91D, 0xB91E, 0xB91F, 0xB921, 0xB922,
+	0xB923, 0xB924, 0xB925, 0xB926, 0xB927, 0xB928, 0xB929, 0xB92A,
+	0xB92B, 0xB92C, 0xB92D, 0xB92E, 0xB92F, 0xB930, 0xB931, 0xB932,
+	0xB933, 0xB934, 0xB935, 0xB936, 0xB937, 0xB938, 0xB939, 0xB93A,
+	0xB93B, 0xB93E, 0xB93F, 0xB941, 0xB942, 0xB943, 0xB945, 0xB946,
+	0xB947, 0xB948, 0xB949, 0xB94A, 0xB94B, 0xB94D, 0xB94E, 0xB950,
+	0xB952, 0xB953, 0xB954, 0xB955, 0xB956, 0xB957, 0xB95A, 0xB95B,
+	0xB95D, 0xB95E, 0xB95F, 0xB961, 0xB962, 0xB963, 0xB964, 0xB965,
+	0xB966, 0xB967, 0xB96A, 0xB96C, 0xB96E, 0xB96F, 0xB970, 0xB971,
+	0xB972, 0xB973, 0xB976, 0xB977, 0xB979, 0xB97A, 0xB97B, 0xB97D,
+	0xB97E, 0xB97F, 0xB980, 0xB981, 0xB982, 0xB983, 0xB986, 0xB988,
+	0xB98B, 0xB98C, 0xB98F, 0xB990, 0xB991, 0xB992, 0xB993, 0xB994,
+	0xB995, 0xB996, 0xB997, 0xB998, 0xB999, 0xB99A, 0xB99B, 0xB99C,
+	0xB99D, 0xB99E, 0xB99F, 0xB9A0, 0xB9A1, 0xB9A2, 0xB9A3, 0xB9A4,
+	0xB9A5, 0xB9A6, 0xB9A7, 0xB9A8, 0xB9A9, 0xB9AA, 0xB9AB, 0xB9AE,
+	0xB9AF, 0xB9B1, 0xB9B2, 0xB9B3, 0xB9B5, 0xB9B6, 0xB9B7, 0xB9B8,
+	0xB9B9, 0xB9BA, 0xB9BB, 0xB9BE, 0xB9C0, 0xB9C2, 0xB9C3, 0xB9C4,
+	0xB9C5, 0xB9C6, 0xB9C7, 0xB9CA, 0xB9CB, 0xB9CD, 0xB9D3, 0xB9D4,
+	0xB9D5, 0xB9D6, 0xB9D7, 0xB9DA, 0xB9DC, 0xB9DF, 0xB9E0, 0xB9E2,
+	0xB9E6, 0xB9E7, 0xB9E9, 0xB9EA, 0xB9EB, 0xB9ED, 0xB9EE, 0xB9EF,
+	0xB9F0, 0xB9F1, 0xB9F2, 0xB9F3, 0xB9F6, 0xB9FB, 0xB9FC, 0xB9FD,
+	0xB9FE, 0xB9FF, 0xBA02, 0xBA03, 0xBA04, 0xBA05, 0xBA06, 0xBA07,
+	0xBA09, 0xBA0A, 0xBA0B, 0xBA0C, 0xBA0D, 0xBA0E, 0xBA0F, 0xBA10,
+	0xBA11, 0xBA12, 0xBA13, 0xBA14, 0xBA16, 0xBA17, 0xBA18, 0xBA19,
+	0xBA1A, 0xBA1B, 0xBA1C, 0xBA1D, 0xBA1E, 0xBA1F, 0xBA20, 0xBA21,
+	0xBA22, 0xBA23, 0xBA24, 0xBA25, 0xBA26, 0xBA27, 0xBA28, 0xBA29,
+	0xBA2A, 0xBA2B, 0xBA2C, 0xBA2D, 0xBA2E, 0xBA2F, 0xBA30, 0xBA31,
+	0xBA32, 0xBA33, 0xBA34, 0xBA35, 0xBA36, 0xBA37, 0xBA3A, 0xBA3B,
+	0xBA3D, 0xBA3E, 0xBA3F, 0xBA41, 0xBA43, 0xBA44, 0xBA45, 0xBA46,
+	0xBA47, 0xBA4A, 0xBA4C, 0xBA4F, 0xBA50, 0xBA51, 0xBA52, 0xBA56,
+	0xBA57, 0xBA59, 0xBA5A, 0xBA5B, 0xBA5D, 0xBA5E, 0xBA5F, 0xBA60,
+	0xBA61, 0xBA62, 0xBA63, 0xBA66, 0xBA6A, 0xBA6B, 0xBA6C, 0xBA6D,
+	0xBA6E, 0xBA6F, 0xBA72, 0xBA73, 0xBA75, 0xBA76, 0xBA77, 0xBA79,
+	0xBA7A, 0xBA7B, 0xBA7C, 0xBA7D, 0xBA7E, 0xBA7F, 0xBA80, 0xBA81,
+	0xBA82, 0xBA86, 0xBA88, 0xBA89, 0xBA8A, 0xBA8B, 0xBA8D, 0xBA8E,
+	0xBA8F, 0xBA90, 0xBA91, 0xBA92, 0xBA93, 0xBA94, 0xBA95, 0xBA96,
+	0xBA97, 0xBA98, 0xBA99, 0xBA9A, 0xBA9B, 0xBA9C, 0xBA9D, 0xBA9E,
+	0xBA9F, 0xBAA0, 0xBAA1, 0xBAA2, 0xBAA3, 0xBAA4, 0xBAA5, 0xBAA6,
+	0xBAA7, 0xBAAA, 0xBAAD, 0xBAAE, 0xBAAF, 0xBAB1, 0xBAB3, 0xBAB4,
+	0xBAB5, 0xBAB6, 0xBAB7, 0xBABA, 0xBABC, 0xBABE, 0xBABF, 0xBAC0,
+	0xBAC1, 0xBAC2, 0xBAC3, 0xBAC5, 0xBAC6, 0xBAC7, 0xBAC9, 0xBACA,
+	0xBACB, 0xBACC, 0xBACD, 0xBACE, 0xBACF, 0xBAD0, 0xBAD1, 0xBAD2,
+	0xBAD3, 0xBAD4, 0xBAD5, 0xBAD6, 0xBAD7, 0xBADA, 0xBADB, 0xBADC,
+	0xBADD, 0xBADE, 0xBADF, 0xBAE0, 0xBAE1, 0xBAE2, 0xBAE3, 0xBAE4,
+	0xBAE5, 0xBAE6, 0xBAE7, 0xBAE8, 0xBAE9, 0xBAEA, 0xBAEB, 0xBAEC,
+	0xBAED, 0xBAEE, 0xBAEF, 0xBAF0, 0xBAF1, 0xBAF2, 0xBAF3, 0xBAF4,
+	0xBAF5, 0xBAF6, 0xBAF7, 0xBAF8, 0xBAF9, 0xBAFA, 0xBAFB, 0xBAFD,
+	0xBAFE, 0xBAFF, 0xBB01, 0xBB02, 0xBB03, 0xBB05, 0xBB06, 0xBB07,
+	0xBB08, 0xBB09, 0xBB0A, 0xBB0B, 0xBB0C, 0xBB0E, 0xBB10, 0xBB12,
+	0xBB13, 0xBB14, 0xBB15, 0xBB16, 0xBB17, 0xBB19, 0xBB1A, 0xBB1B,
+	0xBB1D, 0xBB1E, 0xBB1F, 0xBB21, 0xBB22, 0xBB23, 0xBB24, 0xBB25,
+	0xBB26, 0xBB27, 0xBB28, 0xBB2A, 0xBB2C, 0xBB2D, 0xBB2E, 0xBB2F,
+	0xBB30, 0xBB31, 0xBB32, 0xBB33, 0xBB37, 0xBB39, 0xBB3A, 0xBB3F,
+	0xBB40, 0xBB41, 0xBB42, 0xBB43, 0xBB46, 0xBB48, 0xBB4A, 0xBB4B,
+	0xBB4C, 0xBB4E, 0xBB51, 0xBB52, 0xBB53, 0xBB55, 0xBB56, 0xBB57,
+	0xBB59, 0xBB5A, 0xBB5B, 0xBB5C, 0xBB5D, 0xBB5E, 0xBB5F, 0xBB60,
+	0xBB62, 0xBB64, 0xBB65, 0xBB66, 0xBB67, 0xBB68, 0xBB69, 0xBB6A,
+	0xBB6B, 0xBB6D, 0xBB6E, 0xBB6F, 0xBB70, 0xBB71, 0xBB72, 0xBB73,
+	0xBB74, 0xBB75, 0xBB76, 0xBB77, 0xBB78, 0xBB79, 0xBB7A, 0xBB7B,
+	0xBB7C, 0xBB7D, 0xBB7E, 0xBB7F, 0xBB80, 0xBB81, 0xBB82, 0xBB83,
+	0xBB84, 0xBB85, 0xBB86, 0xBB87, 0xBB89, 0xBB8A, 0xBB8B, 0xBB8D,
+	0xBB8E, 0xBB8F, 0xBB91, 0xBB92, 0xBB93, 0xBB94, 0xBB95, 0xBB96,
+	0xBB97, 0xBB98, 0xBB99, 0xBB9A, 0xBB9B, 0xBB9C, 0xBB9D, 0xBB9E,
+	0xBB9F, 0xBBA0, 0xBBA1, 0xBBA2, 0xBBA3, 0xBBA5, 0xBBA6, 0xBBA7,
+	0xBBA9, 0xBBAA, 0xBBAB, 0xBBAD, 0xBBAE, 0xBBAF, 0xBBB0, 0xBBB1,
+	0xBBB2, 0xBBB3, 0xBBB5, 0xBBB6, 0xBBB8, 0xBBB9, 0xBBBA, 0xBBBB,
+	0xBBBC, 0xBBBD, 0xBBBE, 0xBBBF, 0xBBC1, 0xBBC2, 0xBBC3, 0xBBC5,
+	0xBBC6, 0xBBC7, 0xBBC9, 0xBBCA, 0xBBCB, 0xBBCC, 0xBBCD, 0xBBCE,
+	0xBBCF, 0xBBD1, 0xBBD2, 0xBBD4, 0xBBD5, 0xBBD6, 0xBBD7, 0xBBD8,
+	0xBBD9, 0xBBDA, 0xBBDB, 0xBBDC, 0xBBDD, 0xBBDE, 0xBBDF, 0xBBE0,
+	0xBBE1, 0xBBE2, 0xBBE3, 0xBBE4, 0xBBE5, 0xBBE6, 0xBBE7, 0xBBE8,
+	0xBBE9, 0xBBEA, 0xBBEB, 0xBBEC, 0xBBED, 0xBBEE, 0xBBEF, 0xBBF0,
+	0xBBF1, 0xBBF2, 0xBBF3, 0xBBF4, 0xBBF5, 0xBBF6, 0xBBF7, 0xBBFA,
+	0xBBFB, 0xBBFD, 0xBBFE, 0xBC01, 0xBC03, 0xBC04, 0xBC05, 0xBC06,
+	0xBC07, 0xBC0A, 0xBC0E, 0xBC10, 0xBC12, 0xBC13, 0xBC19, 0xBC1A,
+	0xBC20, 0xBC21, 0xBC22, 0xBC23, 0xBC26, 0xBC28, 0xBC2A, 0xBC2B,
+	0xBC2C, 0xBC2E, 0xBC2F, 0xBC32, 0xBC33, 0xBC35, 0xBC36, 0xBC37,
+	0xBC39, 0xBC3A, 0xBC3B, 0xBC3C, 0xBC3D, 0xBC3E, 0xBC3F, 0xBC42,
+	0xBC46, 0xBC47, 0xBC48, 0xBC4A, 0xBC4B, 0xBC4E, 0xBC4F, 0xBC51,
+	0xBC52, 0xBC53, 0xBC54, 0xBC55, 0xBC56, 0xBC57, 0xBC58, 0xBC59,
+	0xBC5A, 0xBC5B, 0xBC5C, 0xBC5E, 0xBC5F, 0xBC60, 0xBC61, 0xBC62,
+	0xBC63, 0xBC64, 0xBC65, 0xBC66, 0xBC67, 0xBC68, 0xBC69, 0xBC6A,
+	0xBC6B, 0xBC6C, 0xBC6D, 0xBC6E, 0xBC6F, 0xBC70, 0xBC71, 0xBC72,
+	0xBC73, 0xBC74, 0xBC75, 0xBC76, 0xBC77, 0xBC78, 0xBC79, 0xBC7A,
+	0xBC7B, 0xBC7C, 0xBC7D, 0xBC7E, 0xBC7F, 0xBC80, 0xBC81, 0xBC82,
+	0xBC83, 0xBC86, 0xBC87, 0xBC89, 0xBC8A, 0xBC8D, 0xBC8F, 0xBC90,
+	0xBC91, 0xBC92, 0xBC93, 0xBC96, 0xBC98, 0xBC9B, 0xBC9C, 0xBC9D,
+	0xBC9E, 0xBC9F, 0xBCA2, 0xBCA3, 0xBCA5, 0xBCA6, 0xBCA9, 0xBCAA,
+	0xBCAB, 0xBCAC, 0xBCAD, 0xBCAE, 0xBCAF, 0xBCB2, 0xBCB6, 0xBCB7,
+	0xBCB8, 0xBCB9, 0xBCBA, 0xBCBB, 0xBCBE, 0xBCBF, 0xBCC1, 0xBCC2,
+	0xBCC3, 0xBCC5, 0xBCC6, 0xBCC7, 0xBCC8, 0xBCC9, 0xBCCA, 0xBCCB,
+	0xBCCC, 0xBCCE, 0xBCD2, 0xBCD3, 0xBCD4, 0xBCD6, 0xBCD7, 0xBCD9,
+	0xBCDA, 0xBCDB, 0xBCDD, 0xBCDE, 0xBCDF, 0xBCE0, 0xBCE1, 0xBCE2,
+	0xBCE3, 0xBCE4, 0xBCE5, 0xBCE6, 0xBCE7, 0xBCE8, 0xBCE9, 0xBCEA,
+	0xBCEB, 0xBCEC, 0xBCED, 0xBCEE, 0xBCEF, 0xBCF0, 0xBCF1, 0xBCF2,
+	0xBCF3, 0xBCF7, 0xBCF9, 0xBCFA, 0xBCFB, 0xBCFD, 0xBCFE, 0xBCFF,
+	0xBD00, 0xBD01, 0xBD02, 0xBD03, 0xBD06, 0xBD08, 0xBD0A, 0xBD0B,
+	0xBD0C, 0xBD0D, 0xBD0E, 0xBD0F, 0xBD11, 0xBD12, 0xBD13, 0xBD15,
+	0xBD16, 0xBD17, 0xBD18, 0xBD19, 0xBD1A, 0xBD1B, 0xBD1C, 0xBD1D,
+	0xBD1E, 0xBD1F, 0xBD20, 0xBD21, 0xBD22, 0xBD23, 0xBD25, 0xBD26,
+	0xBD27, 0xBD28, 0xBD29, 0xBD2A, 0xBD2B, 0xBD2D, 0xBD2E, 0xBD2F,
+	0xBD30, 0xBD31, 0xBD32, 0xBD33, 0xBD34, 0xBD35, 0xBD36, 0xBD37,
+	0xBD38, 0xBD39, 0xBD3A, 0xBD3B, 0xBD3C, 0xBD3D, 0xBD3E, 0xBD3F,
+	0xBD41, 0xBD42, 0xBD43, 0xBD44, 0xBD45, 0xBD46, 0xBD47, 0xBD4A,
+	0xBD4B, 0xBD4D, 0xBD4E, 0xBD4F, 0xBD51, 0xBD52, 0xBD53, 0xBD54,
+	0xBD55, 0xBD56, 0xBD57, 0xBD5A, 0xBD5B, 0xBD5C, 0xBD5D, 0xBD5E,
+	0xBD5F, 0xBD60, 0xBD61, 0xBD62, 0xBD63, 0xBD65, 0xBD66, 0xBD67,
+	0xBD69, 0xBD6A, 0xBD6B, 0xBD6C, 0xBD6D, 0xBD6E, 0xBD6F, 0xBD70,
+	0xBD71, 0xBD72, 0xBD73, 0xBD74, 0xBD75, 0xBD76, 0xBD77, 0xBD78,
+	0xBD79, 0xBD7A, 0xBD7B, 0xBD7C, 0xBD7D, 0xBD7E, 0xBD7F, 0xBD82,
+	0xBD83, 0xBD85, 0xBD86, 0xBD8B, 0xBD8C, 0xBD8D, 0xBD8E, 0xBD8F,
+	0xBD92, 0xBD94, 0xBD96, 0xBD97, 0xBD98, 0xBD9B, 0xBD9D, 0xBD9E,
+	0xBD9F, 0xBDA0, 0xBDA1, 0xBDA2, 0xBDA3, 0xBDA5, 0xBDA6, 0xBDA7,
+	0xBDA8, 0xBDA9, 0xBDAA, 0xBDAB, 0xBDAC, 0xBDAD, 0xBDAE, 0xBDAF,
+	0xBDB1, 0xBDB2, 0xBDB3, 0xBDB4, 0xBDB5, 0xBDB6, 0xBDB7, 0xBDB9,
+	0xBDBA, 0xBDBB, 0xBDBC, 0xBDBD, 0xBDBE, 0xBDBF, 0xBDC0, 0xBDC1,
+	0xBDC2, 0xBDC3, 0xBDC4, 0xBDC5, 0xBDC6, 0xBDC7, 0xBDC8, 0xBDC9,
+	0xBDCA, 0xBDCB, 0xBDCC, 0xBDCD, 0xBDCE, 0xBDCF, 0xBDD0, 0xBDD1,
+	0xBDD2, 0xBDD3, 0xBDD6, 0xBDD7, 0xBDD9, 0xBDDA, 0xBDDB, 0xBDDD,
+	0xBDDE, 0xBDDF, 0xBDE0, 0xBDE1, 0xBDE2, 0xBDE3, 0xBDE4, 0xBDE5,
+	0xBDE6, 0xBDE7, 0xBDE8, 0xBDEA, 0xBDEB, 0xBDEC, 0xBDED, 0xBDEE,
+	0xBDEF, 0xBDF1, 0xBDF2, 0xBDF3, 0xBDF5, 0xBDF6, 0xBDF7, 0xBDF9,
+	0xBDFA, 0xBDFB, 0xBDFC, 0xBDFD, 0xBDFE, 0xBDFF, 0xBE01, 0xBE02,
+	0xBE04, 0xBE06, 0xBE07, 0xBE08, 0xBE09, 0xBE0A, 0xBE0B, 0xBE0E,
+	0xBE0F, 0xBE11, 0xBE12, 0xBE13, 0xBE15, 0xBE16, 0xBE17, 0xBE18,
+	0xBE19, 0xBE1A, 0xBE1B, 0xBE1E, 0xBE20, 0xBE21, 0xBE22, 0xBE23,
+	0xBE24, 0xBE25, 0xBE26, 0xBE27, 0xBE28, 0xBE29, 0xBE2A, 0xBE2B,
+	0xBE2C, 0xBE2D, 0xBE2E, 0xBE2F, 0xBE30, 0xBE31, 0xBE32, 0xBE33,
+	0xBE34, 0xBE35, 0xBE36, 0xBE37, 0xBE38, 0xBE39, 0xBE3A, 0xBE3B,
+	0xBE3C, 0xBE3D, 0xBE3E, 0xBE3F, 0xBE40, 0xBE41, 0xBE42, 0xBE43,
+	0xBE46, 0xBE47, 0xBE49, 0xBE4A, 0xBE4B, 0xBE4D, 0xBE4F, 0xBE50,
+	0xBE51, 0xBE52, 0xBE53, 0xBE56, 0xBE58, 0xBE5C, 0xBE5D, 0xBE5E,
+	0xBE5F, 0xBE62, 0xBE63, 0xBE65, 0xBE66, 0xBE67, 0xBE69, 0xBE6B,
+	0xBE6C, 0xBE6D, 0xBE6E, 0xBE6F, 0xBE72, 0xBE76, 0xBE77, 0xBE78,
+	0xBE79, 0xBE7A, 0xBE7E, 0xBE7F, 0xBE81, 0xBE82, 0xBE83, 0xBE85,
+	0xBE86, 0xBE87, 0xBE88, 0xBE89, 0xBE8A, 0xBE8B, 0xBE8E, 0xBE92,
+	0xBE93, 0xBE94, 0xBE95, 0xBE96, 0xBE97, 0xBE9A, 0xBE9B, 0xBE9C,
+	0xBE9D, 0xBE9E, 0xBE9F, 0xBEA0, 0xBEA1, 0xBEA2, 0xBEA3, 0xBEA4,
+	0xBEA5, 0xBEA6, 0xBEA7, 0xBEA9, 0xBEAA, 0xBEAB, 0xBEAC, 0xBEAD,
+	0xBEAE, 0xBEAF, 0xBEB0, 0xBEB1, 0xBEB2, 0xBEB3, 0xBEB4, 0xBEB5,
+	0xBEB6, 0xBEB7, 0xBEB8, 0xBEB9, 0xBEBA, 0xBEBB, 0xBEBC, 0xBEBD,
+	0xBEBE, 0xBEBF, 0xBEC0, 0xBEC1, 0xBEC2, 0xBEC3, 0xBEC4, 0xBEC5,
+	0xBEC6, 0xBEC7, 0xBEC8, 0xBEC9, 0xBECA, 0xBECB, 0xBECC, 0xBECD,
+	0xBECE, 0xBECF, 0xBED2, 0xBED3, 0xBED5, 0xBED6, 0xBED9, 0xBEDA,
+	0xBEDB, 0xBEDC, 0xBEDD, 0xBEDE, 0xBEDF, 0xBEE1, 0xBEE2, 0xBEE6,
+	0xBEE7, 0xBEE8, 0xBEE9, 0xBEEA, 0xBEEB, 0xBEED, 0xBEEE, 0xBEEF,
+	0xBEF0, 0xBEF1, 0xBEF2, 0xBEF3, 0xBEF4, 0xBEF5, 0xBEF6, 0xBEF7,
+	0xBEF8, 0xBEF9, 0xBEFA, 0xBEFB, 0xBEFC, 0xBEFD, 0xBEFE, 0xBEFF,
+	0xBF00, 0xBF02, 0xBF03, 0xBF04, 0xBF05, 0xBF06, 0xBF07, 0xBF0A,
+	0xBF0B, 0xBF0C, 0xBF0D, 0xBF0E, 0xBF0F, 0xBF10, 0xBF11, 0xBF12,
+	0xBF13, 0xBF14, 0xBF15, 0xBF16, 0xBF17, 0xBF1A, 0xBF1E, 0xBF1F,
+	0xBF20, 0xBF21, 0xBF22, 0xBF23, 0xBF24, 0xBF25, 0xBF26, 0xBF27,
+	0xBF28, 0xBF29, 0xBF2A, 0xBF2B, 0xBF2C, 0xBF2D, 0xBF2E, 0xBF2F,
+	0xBF30, 0xBF31, 0xBF32, 0xBF33, 0xBF34, 0xBF35, 0xBF36, 0xBF37,
+	0xBF38, 0xBF39, 0xBF3A, 0xBF3B, 0xBF3C, 0xBF3D, 0xBF3E, 0xBF3F,
+	0xBF42, 0xBF43, 0xBF45, 0xBF46, 0xBF47, 0xBF49, 0xBF4A, 0xBF4B,
+	0xBF4C, 0xBF4D, 0xBF4E, 0xBF4F, 0xBF52, 0xBF53, 0xBF54, 0xBF56,
+	0xBF57, 0xBF58, 0xBF59, 0xBF5A, 0xBF5B, 0xBF5C, 0xBF5D, 0xBF5E,
+	0xBF5F, 0xBF60, 0xBF61, 0xBF62, 0xBF63, 0xBF64, 0xBF65, 0xBF66,
+	0xBF67, 0xBF68, 0xBF69, 0xBF6A, 0xBF6B, 0xBF6C, 0xBF6D, 0xBF6E,
+	0xBF6F, 0xBF70, 0xBF71, 0xBF72, 0xBF73, 0xBF74, 0xBF75, 0xBF76,
+	0xBF77, 0xBF78, 0xBF79, 0xBF7A, 0xBF7B, 0xBF7C, 0xBF7D, 0xBF7E,
+	0xBF7F, 0xBF80, 0xBF81, 0xBF82, 0xBF83, 0xBF84, 0xBF85, 0xBF86,
+	0xBF87, 0xBF88, 0xBF89, 0xBF8A, 0xBF8B, 0xBF8C, 0xBF8D, 0xBF8E,
+	0xBF8F, 0xBF90, 0xBF91, 0xBF92, 0xBF93, 0xBF95, 0xBF96, 0xBF97,
+	0xBF98, 0xBF99, 0xBF9A, 0xBF9B, 0xBF9C, 0xBF9D, 0xBF9E, 0xBF9F,
+	0xBFA0, 0xBFA1, 0xBFA2, 0xBFA3, 0xBFA4, 0xBFA5, 0xBFA6, 0xBFA7,
+	0xBFA8, 0xBFA9, 0xBFAA, 0xBFAB, 0xBFAC, 0xBFAD, 0xBFAE, 0xBFAF,
+	0xBFB1, 0xBFB2, 0xBFB3, 0xBFB4, 0xBFB5, 0xBFB6, 0xBFB7, 0xBFB8,
+	0xBFB9, 0xBFBA, 0xBFBB, 0xBFBC, 0xBFBD, 0xBFBE, 0xBFBF, 0xBFC0,
+	0xBFC1, 0xBFC2, 0xBFC3, 0xBFC4, 0xBFC6, 0xBFC7, 0xBFC8, 0xBFC9,
+	0xBFCA, 0xBFCB, 0xBFCE, 0xBFCF, 0xBFD1, 0xBFD2, 0xBFD3, 0xBFD5,
+	0xBFD6, 0xBFD7, 0xBFD8, 0xBFD9, 0xBFDA, 0xBFDB, 0xBFDD, 0xBFDE,
+	0xBFE0, 0xBFE2, 0xBFE3, 0xBFE4, 0xBFE5, 0xBFE6, 0xBFE7, 0xBFE8,
+	0xBFE9, 0xBFEA, 0xBFEB, 0xBFEC, 0xBFED, 0xBFEE, 0xBFEF, 0xBFF0,
+	0xBFF1, 0xBFF2, 0xBFF3, 0xBFF4, 0xBFF5, 0xBFF6, 0xBFF7, 0xBFF8,
+	0xBFF9, 0xBFFA, 0xBFFB, 0xBFFC, 0xBFFD, 0xBFFE, 0xBFFF, 0xC000,
+	0xC001, 0xC002, 0xC003, 0xC004, 0xC005, 0xC006, 0xC007, 0xC008,
+	0xC009, 0xC00A, 0xC00B, 0xC00C, 0xC00D, 0xC00E, 0xC00F, 0xC010,
+	0xC011, 0xC012, 0xC013, 0xC014, 0xC015, 0xC016, 0xC017, 0xC018,
+	0xC019, 0xC01A, 0xC01B, 0xC01C, 0xC01D, 0xC01E, 0xC01F, 0xC020,
+	0xC021, 0xC022, 0xC023, 0xC024, 0xC025, 0xC026, 0xC027, 0xC028,
+	0xC029, 0xC02A, 0xC02B, 0xC02C, 0xC02D, 0xC02E, 0xC02F, 0xC030,
+	0xC031, 0xC032, 0xC033, 0xC034, 0xC035, 0xC036, 0xC037, 0xC038,
+	0xC039, 0xC03A, 0xC03B, 0xC03D, 0xC03E, 0xC03F, 0xC040, 0xC041,
+	0xC042, 0xC043, 0xC044, 0xC045, 0xC046, 0xC047, 0xC048, 0xC049,
+	0xC04A, 0xC04B, 0xC04C, 0xC04D, 0xC04E, 0xC04F, 0xC050, 0xC052,
+	0xC053, 0xC054, 0xC055, 0xC056, 0xC057, 0xC059, 0xC05A, 0xC05B,
+	0xC05D, 0xC05E, 0xC05F, 0xC061, 0xC062, 0xC063, 0xC064, 0xC065,
+	0xC066, 0xC067, 0xC06A, 0xC06B, 0xC06C, 0xC06D, 0xC06E, 0xC06F,
+	0xC070, 0xC071, 0xC072, 0xC073, 0xC074, 0xC075, 0xC076, 0xC077,
+	0xC078, 0xC079, 0xC07A, 0xC07B, 0xC07C, 0xC07D, 0xC07E, 0xC07F,
+	0xC080, 0xC081, 0xC082, 0xC083, 0xC084, 0xC085, 0xC086, 0xC087,
+	0xC088, 0xC089, 0xC08A, 0xC08B, 0xC08C, 0xC08D, 0xC08E, 0xC08F,
+	0xC092, 0xC093, 0xC095, 0xC096, 0xC097, 0xC099, 0xC09A, 0xC09B,
+	0xC09C, 0xC09D, 0xC09E, 0xC09F, 0xC0A2, 0xC0A4, 0xC0A6, 0xC0A7,
+	0xC0A8, 0xC0A9, 0xC0AA, 0xC0AB, 0xC0AE, 0xC0B1, 0xC0B2, 0xC0B7,
+	0xC0B8, 0xC0B9, 0xC0BA, 0xC0BB, 0xC0BE, 0xC0C2, 0xC0C3, 0xC0C4,
+	0xC0C6, 0xC0C7, 0xC0CA, 0xC0CB, 0xC0CD, 0xC0CE, 0xC0CF, 0xC0D1,
+	0xC0D2, 0xC0D3, 0xC0D4, 0xC0D5, 0xC0D6, 0xC0D7, 0xC0DA, 0xC0DE,
+	0xC0DF, 0xC0E0, 0xC0E1, 0xC0E2, 0xC0E3, 0xC0E6, 0xC0E7, 0xC0E9,
+	0xC0EA, 0xC0EB, 0xC0ED, 0xC0EE, 0xC0EF, 0xC0F0, 0xC0F1, 0xC0F2,
+	0xC0F3, 0xC0F6, 0xC0F8, 0xC0FA, 0xC0FB, 0xC0FC, 0xC0FD, 0xC0FE,
+	0xC0FF, 0xC101, 0xC102, 0xC103, 0xC105, 0xC106, 0xC107, 0xC109,
+	0xC10A, 0xC10B, 0xC10C, 0xC10D, 0xC10E, 0xC10F, 0xC111, 0xC112,
+	0xC113, 0xC114, 0xC116, 0xC117, 0xC118, 0xC119, 0xC11A, 0xC11B,
+	0xC121, 0xC122, 0xC125, 0xC128, 0xC129, 0xC12A, 0xC12B, 0xC12E,
+	0xC132, 0xC133, 0xC134, 0xC135, 0xC137, 0xC13A, 0xC13B, 0xC13D,
+	0xC13E, 0xC13F, 0xC141, 0xC142, 0xC143, 0xC144, 0xC145, 0xC146,
+	0xC147, 0xC14A, 0xC14E, 0xC14F, 0xC150, 0xC151, 0xC152, 0xC153,
+	0xC156, 0xC157, 0xC159, 0xC15A, 0xC15B, 0xC15D, 0xC15E, 0xC15F,
+	0xC160, 0xC161, 0xC162, 0xC163, 0xC166, 0xC16A, 0xC16B, 0xC16C,
+	0xC16D, 0xC16E, 0xC16F, 0xC171, 0xC172, 0xC173, 0xC175, 0xC176,
+	0xC177, 0xC179, 0xC17A, 0xC17B, 0xC17C, 0xC17D, 0xC17E, 0xC17F,
+	0xC180, 0xC181, 0xC182, 0xC183, 0xC184, 0xC186, 0xC187, 0xC188,
+	0xC189, 0xC18A, 0xC18B, 0xC18F, 0xC191, 0xC192, 0xC193, 0xC195,
+	0xC197, 0xC198, 0xC199, 0xC19A, 0xC19B, 0xC19E, 0xC1A0, 0xC1A2,
+	0xC1A3, 0xC1A4, 0xC1A6, 0xC1A7, 0xC1AA, 0xC1AB, 0xC1AD, 0xC1AE,
+	0xC1AF, 0xC1B1, 0xC1B2, 0xC1B3, 0xC1B4, 0xC1B5, 0xC1B6, 0xC1B7,
+	0xC1B8, 0xC1B9, 0xC1BA, 0xC1BB, 0xC1BC, 0xC1BE, 0xC1BF, 0xC1C0,
+	0xC1C1, 0xC1C2, 0xC1C3, 0xC1C5, 0xC1C6, 0xC1C7, 0xC1C9, 0xC1CA,
+	0xC1CB, 0xC1CD, 0xC1CE, 0xC1CF, 0xC1D0, 0xC1D1, 0xC1D2, 0xC1D3,
+	0xC1D5, 0xC1D6, 0xC1D9, 0xC1DA, 0xC1DB, 0xC1DC, 0xC1DD, 0xC1DE,
+	0xC1DF, 0xC1E1, 0xC1E2, 0xC1E3, 0xC1E5, 0xC1E6, 0xC1E7, 0xC1E9,
+	0xC1EA, 0xC1EB, 0xC1EC, 0xC1ED, 0xC1EE, 0xC1EF, 0xC1F2, 0xC1F4,
+	0xC1F5, 0xC1F6, 0xC1F7, 0xC1F8, 0xC1F9, 0xC1FA, 0xC1FB, 0xC1FE,
+	0xC1FF, 0xC201, 0xC202, 0xC203, 0xC205, 0xC206, 0xC207, 0xC208,
+	0xC209, 0xC20A, 0xC20B, 0xC20E, 0xC210, 0xC212, 0xC213, 0xC214,
+	0xC215, 0xC216, 0xC217, 0xC21A, 0xC21B, 0xC21D, 0xC21E, 0xC221,
+	0xC222, 0xC223, 0xC224, 0xC225, 0xC226, 0xC227, 0xC22A, 0xC22C,
+	0xC22E, 0xC230, 0xC233, 0xC235, 0xC236, 0xC237, 0xC238, 0xC239,
+	0xC23A, 0xC23B, 0xC23C, 0xC23D, 0xC23E, 0xC23F, 0xC240, 0xC241,
+	0xC242, 0xC243, 0xC244, 0xC245, 0xC246, 0xC247, 0xC249, 0xC24A,
+	0xC24B, 0xC24C, 0xC24D, 0xC24E, 0xC24F, 0xC252, 0xC253, 0xC255,
+	0xC256, 0xC257, 0xC259, 0xC25A, 0xC25B, 0xC25C, 0xC25D, 0xC25E,
+	0xC25F, 0xC261, 0xC262, 0xC263, 0xC264, 0xC266, 0xC267, 0xC268,
+	0xC269, 0xC26A, 0xC26B, 0xC26E, 0xC26F, 0xC271, 0xC272, 0xC273,
+	0xC275, 0xC276, 0xC277, 0xC278, 0xC279, 0xC27A, 0xC27B, 0xC27E,
+	0xC280, 0xC282, 0xC283, 0xC284, 0xC285, 0xC286, 0xC287, 0xC28A,
+	0xC28B, 0xC28C, 0xC28D, 0xC28E, 0xC28F, 0xC291, 0xC292, 0xC293,
+	0xC294, 0xC295, 0xC296, 0xC297, 0xC299, 0xC29A, 0xC29C, 0xC29E,
+	0xC29F, 0xC2A0, 0xC2A1, 0xC2A2, 0xC2A3, 0xC2A6, 0xC2A7, 0xC2A9,
+	0xC2AA, 0xC2AB, 0xC2AE, 0xC2AF, 0xC2B0, 0xC2B1, 0xC2B2, 0xC2B3,
+	0xC2B6, 0xC2B8, 0xC2BA, 0xC2BB, 0xC2BC, 0xC2BD, 0xC2BE, 0xC2BF,
+	0xC2C0, 0xC2C1, 0xC2C2, 0xC2C3, 0xC2C4, 0xC2C5, 0xC2C6, 0xC2C7,
+	0xC2C8, 0xC2C9, 0xC2CA, 0xC2CB, 0xC2CC, 0xC2CD, 0xC2CE, 0xC2CF,
+	0xC2D0, 0xC2D1, 0xC2D2, 0xC2D3, 0xC2D4, 0xC2D5, 0xC2D6, 0xC2D7,
+	0xC2D8, 0xC2D9, 0xC2DA, 0xC2DB, 0xC2DE, 0xC2DF, 0xC2E1, 0xC2E2,
+	0xC2E5, 0xC2E6, 0xC2E7, 0xC2E8, 0xC2E9, 0xC2EA, 0xC2EE, 0xC2F0,
+	0xC2F2, 0xC2F3, 0xC2F4, 0xC2F5, 0xC2F7, 0xC2FA, 0xC2FD, 0xC2FE,
+	0xC2FF, 0xC301, 0xC302, 0xC303, 0xC304, 0xC305, 0xC306, 0xC307,
+	0xC30A, 0xC30B, 0xC30E, 0xC30F, 0xC310, 0xC311, 0xC312, 0xC316,
+	0xC317, 0xC319, 0xC31A, 0xC31B, 0xC31D, 0xC31E, 0xC31F, 0xC320,
+	0xC321, 0xC322, 0xC323, 0xC326, 0xC327, 0xC32A, 0xC32B, 0xC32C,
+	0xC32D, 0xC32E, 0xC32F, 0xC330, 0xC331, 0xC332, 0xC333, 0xC334,
+	0xC335, 0xC336, 0xC337, 0xC338, 0xC339, 0xC33A, 0xC33B, 0xC33C,
+	0xC33D, 0xC33E, 0xC33F, 0xC340, 0xC341, 0xC342, 0xC343, 0xC344,
+	0xC346, 0xC347, 0xC348, 0xC349, 0xC34A, 0xC34B, 0xC34C, 0xC34D,
+	0xC34E, 0xC34F, 0xC350, 0xC351, 0xC352, 0xC353, 0xC354, 0xC355,
+	0xC356, 0xC357, 0xC358, 0xC359, 0xC35A, 0xC35B, 0xC35C, 0xC35D,
+	0xC35E, 0xC35F, 0xC360, 0xC361, 0xC362, 0xC363, 0xC364, 0xC365,
+	0xC366, 0xC367, 0xC36A, 0xC36B, 0xC36D, 0xC36E, 0xC36F, 0xC371,
+	0xC373, 0xC374, 0xC375, 0xC376, 0xC377, 0xC37A, 0xC37B, 0xC37E,
+	0xC37F, 0xC380, 0xC381, 0xC382, 0xC383, 0xC385, 0xC386, 0xC387,
+	0xC389, 0xC38A, 0xC38B, 0xC38D, 0xC38E, 0xC38F, 0xC390, 0xC391,
+	0xC392, 0xC393, 0xC394, 0xC395, 0xC396, 0xC397, 0xC398, 0xC399,
+	0xC39A, 0xC39B, 0xC39C, 0xC39D, 0xC39E, 0xC39F, 0xC3A0, 0xC3A1,
+	0xC3A2, 0xC3A3, 0xC3A4, 0xC3A5, 0xC3A6, 0xC3A7, 0xC3A8, 0xC3A9,
+	0xC3AA, 0xC3AB, 0xC3AC, 0xC3AD, 0xC3AE, 0xC3AF, 0xC3B0, 0xC3B1,
+	0xC3B2, 0xC3B3, 0xC3B4, 0xC3B5, 0xC3B6, 0xC3B7, 0xC3B8, 0xC3B9,
+	0xC3BA, 0xC3BB, 0xC3BC, 0xC3BD, 0xC3BE, 0xC3BF, 0xC3C1, 0xC3C2,
+	0xC3C3, 0xC3C4, 0xC3C5, 0xC3C6, 0xC3C7, 0xC3C8, 0xC3C9, 0xC3CA,
+	0xC3CB, 0xC3CC, 0xC3CD, 0xC3CE, 0xC3CF, 0xC3D0, 0xC3D1, 0xC3D2,
+	0xC3D3, 0xC3D4, 0xC3D5, 0xC3D6, 0xC3D7, 0xC3DA, 0xC3DB, 0xC3DD,
+	0xC3DE, 0xC3E1, 0xC3E3, 0xC3E4, 0xC3E5, 0xC3E6, 0xC3E7, 0xC3EA,
+	0xC3EB, 0xC3EC, 0xC3EE, 0xC3EF, 0xC3F0, 0xC3F1, 0xC3F2, 0xC3F3,
+	0xC3F6, 0xC3F7, 0xC3F9, 0xC3FA, 0xC3FB, 0xC3FC, 0xC3FD, 0xC3FE,
+	0xC3FF, 0xC400, 0xC401, 0xC402, 0xC403, 0xC404, 0xC405, 0xC406,
+	0xC407, 0xC409, 0xC40A, 0xC40B, 0xC40C, 0xC40D, 0xC40E, 0xC40F,
+	0xC411, 0xC412, 0xC413, 0xC414, 0xC415, 0xC416, 0xC417, 0xC418,
+	0xC419, 0xC41A, 0xC41B, 0xC41C, 0xC41D, 0xC41E, 0xC41F, 0xC420,
+	0xC421, 0xC422, 0xC423, 0xC425, 0xC426, 0xC427, 0xC428, 0xC429,
+	0xC42A, 0xC42B, 0xC42D, 0xC42E, 0xC42F, 0xC431, 0xC432, 0xC433,
+	0xC435, 0xC436, 0xC437, 0xC438, 0xC439, 0xC43A, 0xC43B, 0xC43E,
+	0xC43F, 0xC440, 0xC441, 0xC442, 0xC443, 0xC444, 0xC445, 0xC446,
+	0xC447, 0xC449, 0xC44A, 0xC44B, 0xC44C, 0xC44D, 0xC44E, 0xC44F,
+	0xC450, 0xC451, 0xC452, 0xC453, 0xC454, 0xC455, 0xC456, 0xC457,
+	0xC458, 0xC459, 0xC45A, 0xC45B, 0xC45C, 0xC45D, 0xC45E, 0xC45F,
+	0xC460, 0xC461, 0xC462, 0xC463, 0xC466, 0xC467, 0xC469, 0xC46A,
+	0xC46B, 0xC46D, 0xC46E, 0xC46F, 0xC470, 0xC471, 0xC472, 0xC473,
+	0xC476, 0xC477, 0xC478, 0xC47A, 0xC47B, 0xC47C, 0xC47D, 0xC47E,
+	0xC47F, 0xC481, 0xC482, 0xC483, 0xC484, 0xC485, 0xC486, 0xC487,
+	0xC488, 0xC489, 0xC48A, 0xC48B, 0xC48C, 0xC48D, 0xC48E, 0xC48F,
+	0xC490, 0xC491, 0xC492, 0xC493, 0xC495, 0xC496, 0xC497, 0xC498,
+	0xC499, 0xC49A, 0xC49B, 0xC49D, 0xC49E, 0xC49F, 0xC4A0, 0xC4A1,
+	0xC4A2, 0xC4A3, 0xC4A4, 0xC4A5, 0xC4A6, 0xC4A7, 0xC4A8, 0xC4A9,
+	0xC4AA, 0xC4AB, 0xC4AC, 0xC4AD, 0xC4AE, 0xC4AF, 0xC4B0, 0xC4B1,
+	0xC4B2, 0xC4B3, 0xC4B4, 0xC4B5, 0xC4B6, 0xC4B7, 0xC4B9, 0xC4BA,
+	0xC4BB, 0xC4BD, 0xC4BE, 0xC4BF, 0xC4C0, 0xC4C1, 0xC4C2, 0xC4C3,
+	0xC4C4, 0xC4C5, 0xC4C6, 0xC4C7, 0xC4C8, 0xC4C9, 0xC4CA, 0xC4CB,
+	0xC4CC, 0xC4CD, 0xC4CE, 0xC4CF, 0xC4D0, 0xC4D1, 0xC4D2, 0xC4D3,
+	0xC4D4, 0xC4D5, 0xC4D6, 0xC4D7, 0xC4D8, 0xC4D9, 0xC4DA, 0xC4DB,
+	0xC4DC, 0xC4DD, 0xC4DE, 0xC4DF, 0xC4E0, 0xC4E1, 0xC4E2, 0xC4E3,
+	0xC4E4, 0xC4E5, 0xC4E6, 0xC4E7, 0xC4E8, 0xC4EA, 0xC4EB, 0xC4EC,
+	0xC4ED, 0xC4EE, 0xC4EF, 0xC4F2, 0xC4F3, 0xC4F5, 0xC4F6, 0xC4F7,
+	0xC4F9, 0xC4FB, 0xC4FC, 0xC4FD, 0xC4FE, 0xC502, 0xC503, 0xC504,
+	0xC505, 0xC506, 0xC507, 0xC508, 0xC509, 0xC50A, 0xC50B, 0xC50D,
+	0xC50E, 0xC50F, 0xC511, 0xC512, 0xC513, 0xC515, 0xC516, 0xC517,
+	0xC518, 0xC519, 0xC51A, 0xC51B, 0xC51D, 0xC51E, 0xC51F, 0xC520,
+	0xC521, 0xC522, 0xC523, 0xC524, 0xC525, 0xC526, 0xC527, 0xC52A,
+	0xC52B, 0xC52D, 0xC52E, 0xC52F, 0xC531, 0xC532, 0xC533, 0xC534,
+	0xC535, 0xC536, 0xC537, 0xC53A, 0xC53C, 0xC53E, 0xC53F, 0xC540,
+	0xC541, 0xC542, 0xC543, 0xC546, 0xC547, 0xC54B, 0xC54F, 0xC550,
+	0xC551, 0xC552, 0xC556, 0xC55A, 0xC55B, 0xC55C, 0xC55F, 0xC562,
+	0xC563, 0xC565, 0xC566, 0xC567, 0xC569, 0xC56A, 0xC56B, 0xC56C,
+	0xC56D, 0xC56E, 0xC56F, 0xC572, 0xC576, 0xC577, 0xC578, 0xC579,
+	0xC57A, 0xC57B, 0xC57E, 0xC57F, 0xC581, 0xC582, 0xC583, 0xC585,
+	0xC586, 0xC588, 0xC589, 0xC58A, 0xC58B, 0xC58E, 0xC590, 0xC592,
+	0xC593, 0xC594, 0xC596, 0xC599, 0xC59A, 0xC59B, 0xC59D, 0xC59E,
+	0xC59F, 0xC5A1, 0xC5A2, 0xC5A3, 0xC5A4, 0xC5A5, 0xC5A6, 0xC5A7,
+	0xC5A8, 0xC5AA, 0xC5AB, 0xC5AC, 0xC5AD, 0xC5AE, 0xC5AF, 0xC5B0,
+	0xC5B1, 0xC5B2, 0xC5B3, 0xC5B6, 0xC5B7, 0xC5BA, 0xC5BF, 0xC5C0,
+	0xC5C1, 0xC5C2, 0xC5C3, 0xC5CB, 0xC5CD, 0xC5CF, 0xC5D2, 0xC5D3,
+	0xC5D5, 0xC5D6, 0xC5D7, 0xC5D9, 0xC5DA, 0xC5DB, 0xC5DC, 0xC5DD,
+	0xC5DE, 0xC5DF, 0xC5E2, 0xC5E4, 0xC5E6, 0xC5E7, 0xC5E8, 0xC5E9,
+	0xC5EA, 0xC5EB, 0xC5EF, 0xC5F1, 0xC5F2, 0xC5F3, 0xC5F5, 0xC5F8,
+	0xC5F9, 0xC5FA, 0xC5FB, 0xC602, 0xC603, 0xC604, 0xC609, 0xC60A,
+	0xC60B, 0xC60D, 0xC60E, 0xC60F, 0xC611, 0xC612, 0xC613, 0xC614,
+	0xC615, 0xC616, 0xC617, 0xC61A, 0xC61D, 0xC61E, 0xC61F, 0xC620,
+	0xC621, 0xC622, 0xC623, 0xC626, 0xC627, 0xC629, 0xC62A, 0xC62B,
+	0xC62F, 0xC631, 0xC632, 0xC636, 0xC638, 0xC63A, 0xC63C, 0xC63D,
+	0xC63E, 0xC63F, 0xC642, 0xC643, 0xC645, 0xC646, 0xC647, 0xC649,
+	0xC64A, 0xC64B, 0xC64C, 0xC64D, 0xC64E, 0xC64F, 0xC652, 0xC656,
+	0xC657, 0xC658, 0xC659, 0xC65A, 0xC65B, 0xC65E, 0xC65F, 0xC661,
+	0xC662, 0xC663, 0xC664, 0xC665, 0xC666, 0xC667, 0xC668, 0xC669,
+	0xC66A, 0xC66B, 0xC66D, 0xC66E, 0xC670, 0xC672, 0xC673, 0xC674,
+	0xC675, 0xC676, 0xC677, 0xC67A, 0xC67B, 0xC67D, 0xC67E, 0xC67F,
+	0xC681, 0xC682, 0xC683, 0xC684, 0xC685, 0xC686, 0xC687, 0xC68A,
+	0xC68C, 0xC68E, 0xC68F, 0xC690, 0xC691, 0xC692, 0xC693, 0xC696,
+	0xC697, 0xC699, 0xC69A, 0xC69B, 0xC69D, 0xC69E, 0xC69F, 0xC6A0,
+	0xC6A1, 0xC6A2, 0xC6A3, 0xC6A6, 0xC6A8, 0xC6AA, 0xC6AB, 0xC6AC,
+	0xC6AD, 0xC6AE, 0xC6AF, 0xC6B2, 0xC6B3, 0xC6B5, 0xC6B6, 0xC6B7,
+	0xC6BB, 0xC6BC, 0xC6BD, 0xC6BE, 0xC6BF, 0xC6C2, 0xC6C4, 0xC6C6,
+	0xC6C7, 0xC6C8, 0xC6C9, 0xC6CA, 0xC6CB, 0xC6CE, 0xC6CF, 0xC6D1,
+	0xC6D2, 0xC6D3, 0xC6D5, 0xC6D6, 0xC6D7, 0xC6D8, 0xC6D9, 0xC6DA,
+	0xC6DB, 0xC6DE, 0xC6DF, 0xC6E2, 0xC6E3, 0xC6E4, 0xC6E5, 0xC6E6,
+	0xC6E7, 0xC6EA, 0xC6EB, 0xC6ED, 0xC6EE, 0xC6EF, 0xC6F1, 0xC6F2,
+	0xC6F3, 0xC6F4, 0xC6F5, 0xC6F6, 0xC6F7, 0xC6FA, 0xC6FB, 0xC6FC,
+	0xC6FE, 0xC6FF, 0xC700, 0xC701, 0xC702, 0xC703, 0xC706, 0xC707,
+	0xC709, 0xC70A, 0xC70B, 0xC70D, 0xC70E, 0xC70F, 0xC710, 0xC711,
+	0xC712, 0xC713, 0xC716, 0xC718, 0xC71A, 0xC71B, 0xC71C, 0xC71D,
+	0xC71E, 0xC71F, 0xC722, 0xC723, 0xC725, 0xC726, 0xC727, 0xC729,
+	0xC72A, 0xC72B, 0xC72C, 0xC72D, 0xC72E, 0xC72F, 0xC732, 0xC734,
+	0xC736, 0xC738, 0xC739, 0xC73A, 0xC73B, 0xC73E, 0xC73F, 0xC741,
+	0xC742, 0xC743, 0xC745, 0xC746, 0xC747, 0xC748, 0xC749, 0xC74B,
+	0xC74E, 0xC750, 0xC759, 0xC75A, 0xC75B, 0xC75D, 0xC75E, 0xC75F,
+	0xC761, 0xC762, 0xC763, 0xC764, 0xC765, 0xC766, 0xC767, 0xC769,
+	0xC76A, 0xC76C, 0xC76D, 0xC76E, 0xC76F, 0xC770, 0xC771, 0xC772,
+	0xC773, 0xC776, 0xC777, 0xC779, 0xC77A, 0xC77B, 0xC77F, 0xC780,
+	0xC781, 0xC782, 0xC786, 0xC78B, 0xC78C, 0xC78D, 0xC78F, 0xC792,
+	0xC793, 0xC795, 0xC799, 0xC79B, 0xC79C, 0xC79D, 0xC79E, 0xC79F,
+	0xC7A2, 0xC7A7, 0xC7A8, 0xC7A9, 0xC7AA, 0xC7AB, 0xC7AE, 0xC7AF,
+	0xC7B1, 0xC7B2, 0xC7B3, 0xC7B5, 0xC7B6, 0xC7B7, 0xC7B8, 0xC7B9,
+	0xC7BA, 0xC7BB, 0xC7BE, 0xC7C2, 0xC7C3, 0xC7C4, 0xC7C5, 0xC7C6,
+	0xC7C7, 0xC7CA, 0xC7CB, 0xC7CD, 0xC7CF, 0xC7D1, 0xC7D2, 0xC7D3,
+	0xC7D4, 0xC7D5, 0xC7D6, 0xC7D7, 0xC7D9, 0xC7DA, 0xC7DB, 0xC7DC,
+	0xC7DE, 0xC7DF, 0xC7E0, 0xC7E1, 0xC7E2, 0xC7E3, 0xC7E5, 0xC7E6,
+	0xC7E7, 0xC7E9, 0xC7EA, 0xC7EB, 0xC7ED, 0xC7EE, 0xC7EF, 0xC7F0,
+	0xC7F1, 0xC7F2, 0xC7F3, 0xC7F4, 0xC7F5, 0xC7F6, 0xC7F7, 0xC7F8,
+	0xC7F9, 0xC7FA, 0xC7FB, 0xC7FC, 0xC7FD, 0xC7FE, 0xC7FF, 0xC802,
+	0xC803, 0xC805, 0xC806, 0xC807, 0xC809, 0xC80B, 0xC80C, 0xC80D,
+	0xC80E, 0xC80F, 0xC812, 0xC814, 0xC817, 0xC818, 0xC819, 0xC81A,
+	0xC81B, 0xC81E, 0xC81F, 0xC821, 0xC822, 0xC823, 0xC825, 0xC826,
+	0xC827, 0xC828, 0xC829, 0xC82A, 0xC82B, 0xC82E, 0xC830, 0xC832,
+	0xC833, 0xC834, 0xC835, 0xC836, 0xC837, 0xC839, 0xC83A, 0xC83B,
+	0xC83D, 0xC83E, 0xC83F, 0xC841, 0xC842, 0xC843, 0xC844, 0xC845,
+	0xC846, 0xC847, 0xC84A, 0xC84B, 0xC84E, 0xC84F, 0xC850, 0xC851,
+	0xC852, 0xC853, 0xC855, 0xC856, 0xC857, 0xC858, 0xC859, 0xC85A,
+	0xC85B, 0xC85C, 0xC85D, 0xC85E, 0xC85F, 0xC860, 0xC861, 0xC862,
+	0xC863, 0xC864, 0xC865, 0xC866, 0xC867, 0xC868, 0xC869, 0xC86A,
+	0xC86B, 0xC86C, 0xC86D, 0xC86E, 0xC86F, 0xC872, 0xC873, 0xC875,
+	0xC876, 0xC877, 0xC879, 0xC87B, 0xC87C, 0xC87D, 0xC87E, 0xC87F,
+	0xC882, 0xC884, 0xC888, 0xC889, 0xC88A, 0xC88E, 0xC88F, 0xC890,
+	0xC891, 0xC892, 0xC893, 0xC895, 0xC896, 0xC897, 0xC898, 0xC899,
+	0xC89A, 0xC89B, 0xC89C, 0xC89E, 0xC8A0, 0xC8A2, 0xC8A3, 0xC8A4,
+	0xC8A5, 0xC8A6, 0xC8A7, 0xC8A9, 0xC8AA, 0xC8AB, 0xC8AC, 0xC8AD,
+	0xC8AE, 0xC8AF, 0xC8B0, 0xC8B1, 0xC8B2, 0xC8B3, 0xC8B4, 0xC8B5,
+	0xC8B6, 0xC8B7, 0xC8B8, 0xC8B9, 0xC8BA, 0xC8BB, 0xC8BE, 0xC8BF,
+	0xC8C0, 0xC8C1, 0xC8C2, 0xC8C3, 0xC8C5, 0xC8C6, 0xC8C7, 0xC8C9,
+	0xC8CA, 0xC8CB, 0xC8CD, 0xC8CE, 0xC8CF, 0xC8D0, 0xC8D1, 0xC8D2,
+	0xC8D3, 0xC8D6, 0xC8D8, 0xC8DA, 0xC8DB, 0xC8DC, 0xC8DD, 0xC8DE,
+	0xC8DF, 0xC8E2, 0xC8E3, 0xC8E5, 0xC8E6, 0xC8E7, 0xC8E8, 0xC8E9,
+	0xC8EA, 0xC8EB, 0xC8EC, 0xC8ED, 0xC8EE, 0xC8EF, 0xC8F0, 0xC8F1,
+	0xC8F2, 0xC8F3, 0xC8F4, 0xC8F6, 0xC8F7, 0xC8F8, 0xC8F9, 0xC8FA,
+	0xC8FB, 0xC8FE, 0xC8FF, 0xC901, 0xC902, 0xC903, 0xC907, 0xC908,
+	0xC909, 0xC90A, 0xC90B, 0xC90E, 0x3000, 0x3001, 0x3002, 0x00B7,
+	0x2025, 0x2026, 0x00A8, 0x3003, 0x00AD, 0x2015, 0x2225, 0xFF3C,
+	0x223C, 0x2018, 0x2019, 0x201C, 0x201D, 0x3014, 0x3015, 0x3008,
+	0x3009, 0x300A, 0x300B, 0x300C, 0x300D, 0x300E, 0x300F, 0x3010,
+	0x3011, 0x00B1, 0x00D7, 0x00F7, 0x2260, 0x2264, 0x2265, 0x221E,
+	0x2234, 0x00B0, 0x2032, 0x2033, 0x2103, 0x212B, 0xFFE0, 0xFFE1,
+	0xFFE5, 0x2642, 0x2640, 0x2220, 0x22A5, 0x2312, 0x2202, 0x2207,
+	0x2261, 0x2252, 0x00A7, 0x203B, 0x2606, 0x2605, 0x25CB, 0x25CF,
+	0x25CE, 0x25C7, 0x25C6, 0x25A1, 0x25A0, 0x25B3, 0x25B2, 0x25BD,
+	0x25BC, 0x2192, 0x2190, 0x2191, 0x2193, 0x2194, 0x3013, 0x226A,
+	0x226B, 0x221A, 0x223D, 0x221D, 0x2235, 0x222B, 0x222C, 0x2208,
+	0x220B, 0x2286, 0x2287, 0x2282, 0x2283, 0x222A, 0x2229, 0x2227,
+	0x2228, 0xFFE2, 0xC910, 0xC912, 0xC913, 0xC914, 0xC915, 0xC916,
+	0xC917, 0xC919, 0xC91A, 0xC91B, 0xC91C, 0xC91D, 0xC91E, 0xC91F,
+	0xC920, 0xC921, 0xC922, 0xC923, 0xC924, 0xC925, 0xC926, 0xC927,
+	0xC928, 0xC929, 0xC92A, 0xC92B, 0xC92D, 0xC92E, 0xC92F, 0xC930,
+	0xC931, 0xC932, 0xC933, 0xC935, 0xC936, 0xC937, 0xC938, 0xC939,
+	0xC93A, 0xC93B, 0xC93C, 0xC93D, 0xC93E, 0xC93F, 0xC940, 0xC941,
+	0xC942, 0xC943, 0xC944, 0xC945, 0xC946, 0xC947, 0xC948, 0xC949,
+	0xC94A, 0xC94B, 0xC94C, 0xC94D, 0xC94E, 0xC94F, 0xC952, 0xC953,
+	0xC955, 0xC956, 0xC957, 0xC959, 0xC95A, 0xC95B, 0xC95C, 0xC95D,
+	0xC95E, 0xC95F, 0xC962, 0xC964, 0xC965, 0xC966, 0xC967, 0xC968,
+	0xC969, 0xC96A, 0xC96B, 0xC96D, 0xC96E, 0xC96F, 0x21D2, 0x21D4,
+	0x2200, 0x2203, 0x00B4, 0xFF5E, 0x02C7, 0x02D8, 0x02DD, 0x02DA,
+	0x02D9, 0x00B8, 0x02DB, 0x00A1, 0x00BF, 0x02D0, 0x222E, 0x2211,
+	0x220F, 0x00A4, 0x2109, 0x2030, 0x25C1, 0x25C0, 0x25B7, 0x25B6,
+	0x2664, 0x2660, 0x2661, 0x2665, 0x2667, 0x2663, 0x2299, 0x25C8,
+	0x25A3, 0x25D0, 0x25D1, 0x2592, 0x25A4, 0x25A5, 0x25A8, 0x25A7,
+	0x25A6, 0x25A9, 0x2668, 0x260F, 0x260E, 0x261C, 0x261E, 0x00B6,
+	0x2020, 0x2021, 0x2195, 0x2197, 0x2199, 0x2196, 0x2198, 0x266D,
+	0x2669, 0x266A, 0x266C, 0x327F, 0x321C, 0x2116, 0x33C7, 0x2122,
+	0x33C2, 0x33D8, 0x2121, 0x20AC, 0x00AE, 0xC971, 0xC972, 0xC973,
+	0xC975, 0xC976, 0xC977, 0xC978, 0xC979, 0xC97A, 0xC97B, 0xC97D,
+	0xC97E, 0xC97F, 0xC980, 0xC981, 0xC982, 0xC983, 0xC984, 0xC985,
+	0xC986, 0xC987, 0xC98A, 0xC98B, 0xC98D, 0xC98E, 0xC98F, 0xC991,
+	0xC992, 0xC993, 0xC994, 0xC995, 0xC996, 0xC997, 0xC99A, 0xC99C,
+	0xC99E, 0xC99F, 0xC9A0, 0xC9A1, 0xC9A2, 0xC9A3, 0xC9A4, 0xC9A5,
+	0xC9A6, 0xC9A7, 0xC9A8, 0xC9A9, 0xC9AA, 0xC9AB, 0xC9AC, 0xC9AD,
+	0xC9AE, 0xC9AF, 0xC9B0, 0xC9B1, 0xC9B2, 0xC9B3, 0xC9B4, 0xC9B5,
+	0xC9B6, 0xC9B7, 0xC9B8, 0xC9B9, 0xC9BA, 0xC9BB, 0xC9BC, 0xC9BD,
+	0xC9BE, 0xC9BF, 0xC9C2, 0xC9C3, 0xC9C5, 0xC9C6, 0xC9C9, 0xC9CB,
+	0xC9CC, 0xC9CD, 0xC9CE, 0xC9CF, 0xC9D2, 0xC9D4, 0xC9D7, 0xC9D8,
+	0xC9DB, 0xFF01, 0xFF02, 0xFF03, 0xFF04, 0xFF05, 0xFF06, 0xFF07,
+	0xFF08, 0xFF09, 0xFF0A, 0xFF0B, 0xFF0C, 0xFF0D, 0xFF0E, 0xFF0F,
+	0xFF10, 0xFF11, 0xFF12, 0xFF13, 0xFF14, 0xFF15, 0xFF16, 0xFF17,
+	0xFF18, 0xFF19, 0xFF1A, 0xFF1B, 0xFF1C, 0xFF1D, 0xFF1E, 0xFF1F,
+	0xFF20, 0xFF21, 0xFF22, 0xFF23, 0xFF24, 0xFF25, 0xFF26, 0xFF27,
+	0xFF28, 0xFF29, 0xFF2A, 0xFF2B, 0xFF2C, 0xFF2D, 0xFF2E, 0xFF2F,
+	0xFF30, 0xFF31, 0xFF32, 0xFF33, 0xFF34, 0xFF35, 0xFF36, 0xFF37,
+	0xFF38, 0xFF39, 0xFF3A, 0xFF3B, 0xFFE6, 0xFF3D, 0xFF3E, 0xFF3F,
+	0xFF40, 0xFF41, 0xFF42, 0xFF43, 0xFF44, 0xFF45, 0xFF46, 0xFF47,
+	0xFF48, 0xFF49, 0xFF4A, 0xFF4B, 0xFF4C, 0xFF4D, 0xFF4E, 0xFF4F,
+	0xFF50, 0xFF51, 0xFF52, 0xFF53, 0xFF54, 0xFF55, 0xFF56, 0xFF57,
+	0xFF58, 0xFF59, 0xFF5A, 0xFF5B, 0xFF5C, 0xFF5D, 0xFFE3, 0xC9DE,
+	0xC9DF, 0xC9E1, 0xC9E3, 0xC9E5, 0xC9E6, 0xC9E8, 0xC9E9, 0xC9EA,
+	0xC9EB, 0xC9EE, 0xC9F2, 0xC9F3, 0xC9F4, 0xC9F5, 0xC9F6, 0xC9F7,
+	0xC9FA, 0xC9FB, 0xC9FD, 0xC9FE, 0xC9FF, 0xCA01, 0xCA02, 0xCA03,
+	0xCA04, 0xCA05, 0xCA06, 0xCA07, 0xCA0A, 0xCA0E, 0xCA0F, 0xCA10,
+	0xCA11, 0xCA12, 0xCA13, 0xCA15, 0xCA16, 0xCA17, 0xCA19, 0xCA1A,
+	0xCA1B, 0xCA1C, 0xCA1D, 0xCA1E, 0xCA1F, 0xCA20, 0xCA21, 0xCA22,
+	0xCA23, 0xCA24, 0xCA25, 0xCA26, 0xCA27, 0xCA28, 0xCA2A, 0xCA2B,
+	0xCA2C, 0xCA2D, 0xCA2E, 0xCA2F, 0xCA30, 0xCA31, 0xCA32, 0xCA33,
+	0xCA34, 0xCA35, 0xCA36, 0xCA37, 0xCA38, 0xCA39, 0xCA3A, 0xCA3B,
+	0xCA3C, 0xCA3D, 0xCA3E, 0xCA3F, 0xCA40, 0xCA41, 0xCA42, 0xCA43,
+	0xCA44, 0xCA45, 0xCA46, 0x3131, 0x3132, 0x3133, 0x3134, 0x3135,
+	0x3136, 0x3137, 0x3138, 0x3139, 0x313A, 0x313B, 0x313C, 0x313D,
+	0x313E, 0x313F, 0x3140, 0x3141, 0x3142, 0x3143, 0x3144, 0x3145,
+	0x3146, 0x3147, 0x3148, 0x3149, 0x314A, 0x314B, 0x314C, 0x314D,
+	0x314E, 0x314F, 0x3150, 0x3151, 0x3152, 0x3153, 0x3154, 0x3155,
+	0x3156, 0x3157, 0x3158, 0x3159, 0x315A, 0x315B, 0x315C, 0x315D,
+	0x315E, 0x315F, 0x3160, 0x3161, 0x3162, 0x3163, 0x3164, 0x3165,
+	0x3166, 0x3167, 0x3168, 0x3169, 0x316A, 0x316B, 0x316C, 0x316D,
+	0x316E, 0x316F, 0x3170, 0x3171, 0x3172, 0x3173, 0x3174, 0x3175,
+	0x3176, 0x3177, 0x3178, 0x3179, 0x317A, 0x317B, 0x317C, 0x317D,
+	0x317E, 0x317F, 0x3180, 0x3181, 0x3182, 0x3183, 0x3184, 0x3185,
+	0x3186, 0x3187, 0x3188, 0x3189, 0x318A, 0x318B, 0x318C, 0x318D,
+	0x318E, 0xCA47, 0xCA48, 0xCA49, 0xCA4A, 0xCA4B, 0xCA4E, 0xCA4F,
+	0xCA51, 0xCA52, 0xCA53, 0xCA55, 0xCA56, 0xCA57, 0xCA58, 0xCA59,
+	0xCA5A, 0xCA5B, 0xCA5E, 0xCA62, 0xCA63, 0xCA64, 0xCA65, 0xCA66,
+	0xCA67, 0xCA69, 0xCA6A, 0xCA6B, 0xCA6C, 0xCA6D, 0xCA6E, 0xCA6F,
+	0xCA70, 0xCA71, 0xCA72, 0xCA73, 0xCA74, 0xCA75, 0xCA76, 0xCA77,
+	0xCA78, 0xCA79, 0xCA7A, 0xCA7B, 0xCA7C, 0xCA7E, 0xCA7F, 0xCA80,
+	0xCA81, 0xCA82, 0xCA83, 0xCA85, 0xCA86, 0xCA87, 0xCA88, 0xCA89,
+	0xCA8A, 0xCA8B, 0xCA8C, 0xCA8D, 0xCA8E, 0xCA8F, 0xCA90, 0xCA91,
+	0xCA92, 0xCA93, 0xCA94, 0xCA95, 0xCA96, 0xCA97, 0xCA99, 0xCA9A,
+	0xCA9B, 0xCA9C, 0xCA9D, 0xCA9E, 0xCA9F, 0xCAA0, 0xCAA1, 0xCAA2,
+	0xCAA3, 0xCAA4, 0xCAA5, 0xCAA6, 0xCAA7, 0x2170, 0x2171, 0x2172,
+	0x2173, 0x2174, 0x2175, 0x2176, 0x2177, 0x2178, 0x2179, 0x2160,
+	0x2161, 0x2162, 0x2163, 0x2164, 0x2165, 0x2166, 0x2167, 0x2168,
+	0x2169, 0x0391, 0x0392, 0x0393, 0x0394, 0x0395, 0x0396, 0x0397,
+	0x0398, 0x0399, 0x039A, 0x039B, 0x039C, 0x039D, 0x039E, 0x039F,
+	0x03A0, 0x03A1, 0x03A3, 0x03A4, 0x03A5, 0x03A6, 0x03A7, 0x03A8,
+	0x03A9, 0x03B1, 0x03B2, 0x03B3, 0x03B4, 0x03B5, 0x03B6, 0x03B7,
+	0x03B8, 0x03B9, 0x03BA, 0x03BB, 0x03BC, 0x03BD, 0x03BE, 0x03BF,
+	0x03C0, 0x03C1, 0x03C3, 0x03C4, 0x03C5, 0x03C6, 0x03C7, 0x03C8,
+	0x03C9, 0xCAA8, 0xCAA9, 0xCAAA, 0xCAAB, 0xCAAC, 0xCAAD, 0xCAAE,
+	0xCAAF, 0xCAB0, 0xCAB1, 0xCAB2, 0xCAB3, 0xCAB4, 0xCAB5, 0xCAB6,
+	0xCAB7, 0xCAB8, 0xCAB9, 0xCABA, 0xCABB, 0xCABE, 0xCABF, 0xCAC1,
+	0xCAC2, 0xCAC3, 0xCAC5, 0xCAC6, 0xCAC7, 0xCAC8, 0xCAC9, 0xCACA,
+	0xCACB, 0xCACE, 0xCAD0, 0xCAD2, 0xCAD4, 0xCAD5, 0xCAD6, 0xCAD7,
+	0xCADA, 0xCADB, 0xCADC, 0xCADD, 0xCADE, 0xCADF, 0xCAE1, 0xCAE2,
+	0xCAE3, 0xCAE4, 0xCAE5, 0xCAE6, 0xCAE7, 0xCAE8, 0xCAE9, 0xCAEA,
+	0xCAEB, 0xCAED, 0xCAEE, 0xCAEF, 0xCAF0, 0xCAF1, 0xCAF2, 0xCAF3,
+	0xCAF5, 0xCAF6, 0xCAF7, 0xCAF8, 0xCAF9, 0xCAFA, 0xCAFB, 0xCAFC,
+	0xCAFD, 0xCAFE, 0xCAFF, 0xCB00, 0xCB01, 0xCB02, 0xCB03, 0xCB04,
+	0xCB05, 0xCB06, 0xCB07, 0xCB09, 0xCB0A, 0x2500, 0x2502, 0x250C,
+	0x2510, 0x2518, 0x2514, 0x251C, 0x252C, 0x2524, 0x2534, 0x253C,
+	0x2501, 0x2503, 0x250F, 0x2513, 0x251B, 0x2517, 0x2523, 0x2533,
+	0x252B, 0x253B, 0x254B, 0x2520, 0x252F, 0x2528, 0x2537, 0x253F,
+	0x251D, 0x2530, 0x2525, 0x2538, 0x2542, 0x2512, 0x2511, 0x251A,
+	0x2519, 0x2516, 0x2515, 0x250E, 0x250D, 0x251E, 0x251F, 0x2521,
+	0x2522, 0x2526, 0x2527, 0x2529, 0x252A, 0x252D, 0x252E, 0x2531,
+	0x2532, 0x2535, 0x2536, 0x2539, 0x253A, 0x253D, 0x253E, 0x2540,
+	0x2541, 0x2543, 0x2544, 0x2545, 0x2546, 0x2547, 0x2548, 0x2549,
+	0x254A, 0xCB0B, 0xCB0C, 0xCB0D, 0xCB0E, 0xCB0F, 0xCB11, 0xCB12,
+	0xCB13, 0xCB15, 0xCB16, 0xCB17, 0xCB19, 0xCB1A, 0xCB1B, 0xCB1C,
+	0xCB1D, 0xCB1E, 0xCB1F, 0xCB22, 0xCB23, 0xCB24, 0xCB25, 0xCB26,
+	0xCB27, 0xCB28, 0xCB29, 0xCB2A, 0xCB2B, 0xCB2C, 0xCB2D, 0xCB2E,
+	0xCB2F, 0xCB30, 0xCB31, 0xCB32, 0xCB33, 0xCB34, 0xCB35, 0xCB36,
+	0xCB37, 0xCB38, 0xCB39, 0xCB3A, 0xCB3B, 0xCB3C, 0xCB3D, 0xCB3E,
+	0xCB3F, 0xCB40, 0xCB42, 0xCB43, 0xCB44, 0xCB45, 0xCB46, 0xCB47,
+	0xCB4A, 0xCB4B, 0xCB4D, 0xCB4E, 0xCB4F, 0xCB51, 0xCB52, 0xCB53,
+	0xCB54, 0xCB55, 0xCB56, 0xCB57, 0xCB5A, 0xCB5B, 0xCB5C, 0xCB5E,
+	0xCB5F, 0xCB60, 0xCB61, 0xCB62, 0xCB63, 0xCB65, 0xCB66, 0xCB67,
+	0xCB68, 0xCB69, 0xCB6A, 0xCB6B, 0xCB6C, 0x3395, 0x3396, 0x3397,
+	0x2113, 0x3398, 0x33C4, 0x33A3, 0x33A4, 0x33A5, 0x33A6, 0x3399,
+	0x339A, 0x339B, 0x339C, 0x339D, 0x339E, 0x339F, 0x33A0, 0x33A1,
+	0x33A2, 0x33CA, 0x338D, 0x338E, 0x338F, 0x33CF, 0x3388, 0x3389,
+	0x33C8, 0x33A7, 0x33A8, 0x33B0, 0x33B1, 0x33B2, 0x33B3, 0x33B4,
+	0x33B5, 0x33B6, 0x33B7, 0x33B8, 0x33B9, 0x3380, 0x3381, 0x3382,
+	0x3383, 0x3384, 0x33BA, 0x33BB, 0x33BC, 0x33BD, 0x33BE, 0x33BF,
+	0x3390, 0x3391, 0x3392, 0x3393, 0x3394, 0x2126, 0x33C0, 0x33C1,
+	0x338A, 0x338B, 0x338C, 0x33D6, 0x33C5, 0x33AD, 0x33AE, 0x33AF,
+	0x33DB, 0x33A9, 0x33AA, 0x33AB, 0x33AC, 0x33DD, 0x33D0, 0x33D3,
+	0x33C3, 0x33C9, 0x33DC, 0x33C6, 0xCB6D, 0xCB6E, 0xCB6F, 0xCB70,
+	0xCB71, 0xCB72, 0xCB73, 0xCB74, 0xCB75, 0xCB76, 0xCB77, 0xCB7A,
+	0xCB7B, 0xCB7C, 0xCB7D, 0xCB7E, 0xCB7F, 0xCB80, 0xCB81, 0xCB82,
+	0xCB83, 0xCB84, 0xCB85, 0xCB86, 0xCB87, 0xCB88, 0xCB89, 0xCB8A,
+	0xCB8B, 0xCB8C, 0xCB8D, 0xCB8E, 0xCB8F, 0xCB90, 0xCB91, 0xCB92,
+	0xCB93, 0xCB94, 0xCB95, 0xCB96, 0xCB97, 0xCB98, 0xCB99, 0xCB9A,
+	0xCB9B, 0xCB9D, 0xCB9E, 0xCB9F, 0xCBA0, 0xCBA1, 0xCBA2, 0xCBA3,
+	0xCBA4, 0xCBA5, 0xCBA6, 0xCBA7, 0xCBA8, 0xCBA9, 0xCBAA, 0xCBAB,
+	0xCBAC, 0xCBAD, 0xCBAE, 0xCBAF, 0xCBB0, 0xCBB1, 0xCBB2, 0xCBB3,
+	0xCBB4, 0xCBB5, 0xCBB6, 0xCBB7, 0xCBB9, 0xCBBA, 0xCBBB, 0xCBBC,
+	0xCBBD, 0xCBBE, 0xCBBF, 0xCBC0, 0xCBC1, 0xCBC2, 0xCBC3, 0xCBC4,
+	0x00C6, 0x00D0, 0x00AA, 0x0126, 0x0132, 0x013F, 0x0141, 0x00D8,
+	0x0152, 0x00BA, 0x00DE, 0x0166, 0x014A, 0x3260, 0x3261, 0x3262,
+	0x3263, 0x3264, 0x3265, 0x3266, 0x3267, 0x3268, 0x3269, 0x326A,
+	0x326B, 0x326C, 0x326D, 0x326E, 0x326F, 0x3270, 0x3271, 0x3272,
+	0x3273, 0x3274, 0x3275, 0x3276, 0x3277, 0x3278, 0x3279, 0x327A,
+	0x327B, 0x24D0, 0x24D1, 0x24D2, 0x24D3, 0x24D4, 0x24D5, 0x24D6,
+	0x24D7, 0x24D8, 0x24D9, 0x24DA, 0x24DB, 0x24DC, 0x24DD, 0x24DE,
+	0x24DF, 0x24E0, 0x24E1, 0x24E2, 0x24E3, 0x24E4, 0x24E5, 0x24E6,
+	0x24E7, 0x24E8, 0x24E9, 0x2460, 0x2461, 0x2462, 0x2463, 0x2464,
+	0x2465, 0x2466, 0x2467, 0x2468, 0x2469, 0x246A, 0x246B, 0x246C,
+	0x246D, 0x246E, 0x00BD, 0x2153, 0x2154, 0x00BC, 0x00BE, 0x215B,
+	0x215C, 0x215D, 0x215E, 0xCBC5, 0xCBC6, 0xCBC7, 0xCBC8, 0xCBC9,
+	0xCBCA, 0xCBCB, 0xCBCC, 0xCBCD, 0xCBCE, 0xCBCF, 0xCBD0, 0xCBD1,
+	0xCBD2, 0xCBD3, 0xCBD5, 0xCBD6, 0xCBD7, 0xCBD8, 0xCBD9, 0xCBDA,
+	0xCBDB, 0xCBDC, 0xCBDD, 0xCBDE, 0xCBDF, 0xCBE0, 0xCBE1, 0xCBE2,
+	0xCBE3, 0xCBE5, 0xCBE6, 0xCBE8, 0xCBEA, 0xCBEB, 0xCBEC, 0xCBED,
+	0xCBEE, 0xCBEF, 0xCBF0, 0xCBF1, 0xCBF2, 0xCBF3, 0xCBF4, 0xCBF5,
+	0xCBF6, 0xCBF7, 0xCBF8, 0xCBF9, 0xCBFA, 0xCBFB, 0xCBFC, 0xCBFD,
+	0xCBFE, 0xCBFF, 0xCC00, 0xCC01, 0xCC02, 0xCC03, 0xCC04, 0xCC05,
+	0xCC06, 0xCC07, 0xCC08, 0xCC09, 0xCC0A, 0xCC0B, 0xCC0E, 0xCC0F,
+	0xCC11, 0xCC12, 0xCC13, 0xCC15, 0xCC16, 0xCC17, 0xCC18, 0xCC19,
+	0xCC1A, 0xCC1B, 0xCC1E, 0xCC1F, 0xCC20, 0xCC23, 0xCC24, 0x00E6,
+	0x0111, 0x00F0, 0x0127, 0x0131, 0x0133, 0x0138, 0x0140, 0x0142,
+	0x00F8, 0x0153, 0x00DF, 0x00FE, 0x0167, 0x014B, 0x0149, 0x3200,
+	0x3201, 0x3202, 0x3203, 0x3204, 0x3205, 0x3206, 0x3207, 0x3208,
+	0x3209, 0x320A, 0x320B, 0x320C, 0x320D, 0x320E, 0x320F, 0x3210,
+	0x3211, 0x3212, 0x3213, 0x3214, 0x3215, 0x3216, 0x3217, 0x3218,
+	0x3219, 0x321A, 0x321B, 0x249C, 0x249D, 0x249E, 0x249F, 0x24A0,
+	0x24A1, 0x24A2, 0x24A3, 0x24A4, 0x24A5, 0x24A6, 0x24A7, 0x24A8,
+	0x24A9, 0x24AA, 0x24AB, 0x24AC, 0x24AD, 0x24AE, 0x24AF, 0x24B0,
+	0x24B1, 0x24B2, 0x24B3, 0x24B4, 0x24B5, 0x2474, 0x2475, 0x2476,
+	0x2477, 0x2478, 0x2479, 0x247A, 0x247B, 0x247C, 0x247D, 0x247E,
+	0x247F, 0x2480, 0x2481, 0x2482, 0x00B9, 0x00B2, 0x00B3, 0x2074,
+	0x207F, 0x2081, 0x2082, 0x2083, 0x2084, 0xCC25, 0xCC26, 0xCC2A,
+	0xCC2B, 0xCC2D, 0xCC2F, 0xCC31, 0xCC32, 0xCC33, 0xCC34, 0xCC35,
+	0xCC36, 0xCC37, 0xCC3A, 0xCC3F, 0xCC40, 0xCC41, 0xCC42, 0xCC43,
+	0xCC46, 0xCC47, 0xCC49, 0xCC4A, 0xCC4B, 0xCC4D, 0xCC4E, 0xCC4F,
+	0xCC50, 0xCC51, 0xCC52, 0xCC53, 0xCC56, 0xCC5A, 0xCC5B, 0xCC5C,
+	0xCC5D, 0xCC5E, 0xCC5F, 0xCC61, 0xCC62, 0xCC63, 0xCC65, 0xCC67,
+	0xCC69, 0xCC6A, 0xCC6B, 0xCC6C, 0xCC6D, 0xCC6E, 0xCC6F, 0xCC71,
+	0xCC72, 0xCC73, 0xCC74, 0xCC76, 0xCC77, 0xCC78, 0xCC79, 0xCC7A,
+	0xCC7B, 0xCC7C, 0xCC7D, 0xCC7E, 0xCC7F, 0xCC80, 0xCC81, 0xCC82,
+	0xCC83, 0xCC84, 0xCC85, 0xCC86, 0xCC87, 0xCC88, 0xCC89, 0xCC8A,
+	0xCC8B, 0xCC8C, 0xCC8D, 0xCC8E, 0xCC8F, 0xCC90, 0xCC91, 0xCC92,
+	0xCC93, 0x3041, 0x3042, 0x3043, 0x3044, 0x3045, 0x3046, 0x3047,
+	0x3048, 0x3049, 0x304A, 0x304B, 0x304C, 0x304D, 0x304E, 0x304F,
+	0x3050, 0x3051, 0x3052, 0x3053, 0x3054, 0x3055, 0x3056, 0x3057,
+	0x3058, 0x3059, 0x305A, 0x305B, 0x305C, 0x305D, 0x305E, 0x305F,
+	0x3060, 0x3061, 0x3062, 0x3063, 0x3064, 0x3065, 0x3066, 0x3067,
+	0x3068, 0x3069, 0x306A, 0x306B, 0x306C, 0x306D, 0x306E, 0x306F,
+	0x3070, 0x3071, 0x3072, 0x3073, 0x3074, 0x3075, 0x3076, 0x3077,
+	0x3078, 0x3079, 0x307A, 0x307B, 0x307C, 0x307D, 0x307E, 0x307F,
+	0x3080, 0x3081, 0x3082, 0x3083, 0x3084, 0x3085, 0x3086, 0x3087,
+	0x3088, 0x3089, 0x308A, 0x308B, 0x308C, 0x308D, 0x308E, 0x308F,
+	0x3090, 0x3091, 0x3092, 0x3093, 0xCC94, 0xCC95, 0xCC96, 0xCC97,
+	0xCC9A, 0xCC9B, 0xCC9D, 0xCC9E, 0xCC9F, 0xCCA1, 0xCCA2, 0xCCA3,
+	0xCCA4, 0xCCA5, 0xCCA6, 0xCCA7, 0xCCAA, 0xCCAE, 0xCCAF, 0xCCB0,
+	0xCCB1, 0xCCB2, 0xCCB3, 0xCCB6, 0xCCB7, 0xCCB9, 0xCCBA, 0xCCBB,
+	0xCCBD, 0xCCBE, 0xCCBF, 0xCCC0, 0xCCC1, 0xCCC2, 0xCCC3, 0xCCC6,
+	0xCCC8, 0xCCCA, 0xCCCB, 0xCCCC, 0xCCCD, 0xCCCE, 0xCCCF, 0xCCD1,
+	0xCCD2, 0xCCD3, 0xCCD5, 0xCCD6, 0xCCD7, 0xCCD8, 0xCCD9, 0xCCDA,
+	0xCCDB, 0xCCDC, 0xCCDD, 0xCCDE, 0xCCDF, 0xCCE0, 0xCCE1, 0xCCE2,
+	0xCCE3, 0xCCE5, 0xCCE6, 0xCCE7, 0xCCE8, 0xCCE9, 0xCCEA, 0xCCEB,
+	0xCCED, 0xCCEE, 0xCCEF, 0xCCF1, 0xCCF2, 0xCCF3, 0xCCF4, 0xCCF5,
+	0xCCF6, 0xCCF7, 0xCCF8, 0xCCF9, 0xCCFA, 0xCCFB, 0xCCFC, 0xCCFD,
+	0x30A1, 0x30A2, 0x30A3, 0x30A4, 0x30A5, 0x30A6, 0x30A7, 0x30A8,
+	0x30A9, 0x30AA, 0x30AB, 0x30AC, 0x30AD, 0x30AE, 0x30AF, 0x30B0,
+	0x30B1, 0x30B2, 0x30B3, 0x30B4, 0x30B5, 0x30B6, 0x30B7, 0x30B8,
+	0x30B9, 0x30BA, 0x30BB, 0x30BC, 0x30BD, 0x30BE, 0x30BF, 0x30C0,
+	0x30C1, 0x30C2, 0x30C3, 0x30C4, 0x30C5, 0x30C6, 0x30C7, 0x30C8,
+	0x30C9, 0x30CA, 0x30CB, 0x30CC, 0x30CD, 0x30CE, 0x30CF, 0x30D0,
+	0x30D1, 0x30D2, 0x30D3, 0x30D4, 0x30D5, 0x30D6, 0x30D7, 0x30D8,
+	0x30D9, 0x30DA, 0x30DB, 0x30DC, 0x30DD, 0x30DE, 0x30DF, 0x30E0,
+	0x30E1, 0x30E2, 0x30E3, 0x30E4, 0x30E5, 0x30E6, 0x30E7, 0x30E8,
+	0x30E9, 0x30EA, 0x30EB, 0x30EC, 0x30ED, 0x30EE, 0x30EF, 0x30F0,
+	0x30F1, 0x30F2, 0x30F3, 0x30F4, 0x30F5, 0x30F6, 0xCCFE, 0xCCFF,
+	0xCD00, 0xCD02, 0xCD03, 0xCD04, 0xCD05, 0xCD06, 0xCD07, 0xCD0A,
+	0xCD0B, 0xCD0D, 0xCD0E, 0xCD0F, 0xCD11, 0xCD12, 0xCD13, 0xCD14,
+	0xCD15, 0xCD16, 0xCD17, 0xCD1A, 0xCD1C, 0xCD1E, 0xCD1F, 0xCD20,
+	0xCD21, 0xCD22, 0xCD23, 0xCD25, 0xCD26, 0xCD27, 0xCD29, 0xCD2A,
+	0xCD2B, 0xCD2D, 0xCD2E, 0xCD2F, 0xCD30, 0xCD31, 0xCD32, 0xCD33,
+	0xCD34, 0xCD35, 0xCD36, 0xCD37, 0xCD38, 0xCD3A, 0xCD3B, 0xCD3C,
+	0xCD3D, 0xCD3E, 0xCD3F, 0xCD40, 0xCD41, 0xCD42, 0xCD43, 0xCD44,
+	0xCD45, 0xCD46, 0xCD47, 0xCD48, 0xCD49, 0xCD4A, 0xCD4B, 0xCD4C,
+	0xCD4D, 0xCD4E, 0xCD4F, 0xCD50, 0xCD51, 0xCD52, 0xCD53, 0xCD54,
+	0xCD55, 0xCD56, 0xCD57, 0xCD58, 0xCD59, 0xCD5A, 0xCD5B, 0xCD5D,
+	0xCD5E, 0xCD5F, 0x0410, 0x0411, 0x0412, 0x0413, 0x0414, 0x0415,
+	0x0401, 0x0416, 0x0417, 0x0418, 0x0419, 0x041A, 0x041B, 0x041C,
+	0x041D, 0x041E, 0x041F, 0x0420, 0x0421, 0x0422, 0x0423, 0x0424,
+	0x0425, 0x0426, 0x0427, 0x0428, 0x0429, 0x042A, 0x042B, 0x042C,
+	0x042D, 0x042E, 0x042F, 0x0430, 0x0431, 0x0432, 0x0433, 0x0434,
+	0x0435, 0x0451, 0x0436, 0x0437, 0x0438, 0x0439, 0x043A, 0x043B,
+	0x043C, 0x043D, 0x043E, 0x043F, 0x0440, 0x0441, 0x0442, 0x0443,
+	0x0444, 0x0445, 0x0446, 0x0447, 0x0448, 0x0449, 0x044A, 0x044B,
+	0x044C, 0x044D, 0x044E, 0x044F, 0xCD61, 0xCD62, 0xCD63, 0xCD65,
+	0xCD66, 0xCD67, 0xCD68, 0xCD69, 0xCD6A, 0xCD6B, 0xCD6E, 0xCD70,
+	0xCD72, 0xCD73, 0xCD74, 0xCD75, 0xCD76, 0xCD77, 0xCD79, 0xCD7A,
+	0xCD7B, 0xCD7C, 0xCD7D, 0xCD7E, 0xCD7F, 0xCD80, 0xCD81, 0xCD82,
+	0xCD83, 0xCD84, 0xCD85, 0xCD86, 0xCD87, 0xCD89, 0xCD8A, 0xCD8B,
+	0xCD8C, 0xCD8D, 0xCD8E, 0xCD8F, 0xCD90, 0xCD91, 0xCD92, 0xCD93,
+	0xCD96, 0xCD97, 0xCD99, 0xCD9A, 0xCD9B, 0xCD9D, 0xCD9E, 0xCD9F,
+	0xCDA0, 0xCDA1, 0xCDA2, 0xCDA3, 0xCDA6, 0xCDA8, 0xCDAA, 0xCDAB,
+	0xCDAC, 0xCDAD, 0xCDAE, 0xCDAF, 0xCDB1, 0xCDB2, 0xCDB3, 0xCDB4,
+	0xCDB5, 0xCDB6, 0xCDB7, 0xCDB8, 0xCDB9, 0xCDBA, 0xCDBB, 0xCDBC,
+	0xCDBD, 0xCDBE, 0xCDBF, 0xCDC0, 0xCDC1, 0xCDC2, 0xCDC3, 0xCDC5,
+	0xCDC6, 0xCDC7, 0xCDC8, 0xCDC9, 0xCDCA, 0xCDCB, 0xCDCD, 0xCDCE,
+	0xCDCF, 0xCDD1, 0xCDD2, 0xCDD3, 0xCDD4, 0xCDD5, 0xCDD6, 0xCDD7,
+	0xCDD8, 0xCDD9, 0xCDDA, 0xCDDB, 0xCDDC, 0xCDDD, 0xCDDE, 0xCDDF,
+	0xCDE0, 0xCDE1, 0xCDE2, 0xCDE3, 0xCDE4, 0xCDE5, 0xCDE6, 0xCDE7,
+	0xCDE9, 0xCDEA, 0xCDEB, 0xCDED, 0xCDEE, 0xCDEF, 0xCDF1, 0xCDF2,
+	0xCDF3, 0xCDF4, 0xCDF5, 0xCDF6, 0xCDF7, 0xCDFA, 0xCDFC, 0xCDFE,
+	0xCDFF, 0xCE00, 0xCE01, 0xCE02, 0xCE03, 0xCE05, 0xCE06, 0xCE07,
+	0xCE09, 0xCE0A, 0xCE0B, 0xCE0D, 0xCE0E, 0xCE0F, 0xCE10, 0xCE11,
+	0xCE12, 0xCE13, 0xCE15, 0xCE16, 0xCE17, 0xCE18, 0xCE1A, 0xCE1B,
+	0xCE1C, 0xCE1D, 0xCE1E, 0xCE1F, 0xCE22, 0xCE23, 0xCE25, 0xCE26,
+	0xCE27, 0xCE29, 0xCE2A, 0xCE2B, 0xCE2C, 0xCE2D, 0xCE2E, 0xCE2F,
+	0xCE32, 0xCE34, 0xCE36, 0xCE37, 0xCE38, 0xCE39, 0xCE3A, 0xCE3B,
+	0xCE3C, 0xCE3D, 0xCE3E, 0xCE3F, 0xCE40, 0xCE41, 0xCE42, 0xCE43,
+	0xCE44, 0xCE45, 0xCE46, 0xCE47, 0xCE48, 0xCE49, 0xCE4A, 0xCE4B,
+	0xCE4C, 0xCE4D, 0xCE4E, 0xCE4F, 0xCE50, 0xCE51, 0xCE52, 0xCE53,
+	0xCE54, 0xCE55, 0xCE56, 0xCE57, 0xCE5A, 0xCE5B, 0xCE5D, 0xCE5E,
+	0xCE62, 0xCE63, 0xCE64, 0xCE65, 0xCE66, 0xCE67, 0xCE6A, 0xCE6C,
+	0xCE6E, 0xCE6F, 0xCE70, 0xCE71, 0xCE72, 0xCE73, 0xCE76, 0xCE77,
+	0xCE79, 0xCE7A, 0xCE7B, 0xCE7D, 0xCE7E, 0xCE7F, 0xCE80, 0xCE81,
+	0xCE82, 0xCE83, 0xCE86, 0xCE88, 0xCE8A, 0xCE8B, 0xCE8C, 0xCE8D,
+	0xCE8E, 0xCE8F, 0xCE92, 0xCE93, 0xCE95, 0xCE96, 0xCE97, 0xCE99,
+	0xCE9A, 0xCE9B, 0xCE9C, 0xCE9D, 0xCE9E, 0xCE9F, 0xCEA2, 0xCEA6,
+	0xCEA7, 0xCEA8, 0xCEA9, 0xCEAA, 0xCEAB, 0xCEAE, 0xCEAF, 0xCEB0,
+	0xCEB1, 0xCEB2, 0xCEB3, 0xCEB4, 0xCEB5, 0xCEB6, 0xCEB7, 0xCEB8,
+	0xCEB9, 0xCEBA, 0xCEBB, 0xCEBC, 0xCEBD, 0xCEBE, 0xCEBF, 0xCEC0,
+	0xCEC2, 0xCEC3, 0xCEC4, 0xCEC5, 0xCEC6, 0xCEC7, 0xCEC8, 0xCEC9,
+	0xCECA, 0xCECB, 0xCECC, 0xCECD, 0xCECE, 0xCECF, 0xCED0, 0xCED1,
+	0xCED2, 0xCED3, 0xCED4, 0xCED5, 0xCED6, 0xCED7, 0xCED8, 0xCED9,
+	0xCEDA, 0xCEDB, 0xCEDC, 0xCEDD, 0xCEDE, 0xCEDF, 0xCEE0, 0xCEE1,
+	0xCEE2, 0xCEE3, 0xCEE6, 0xCEE7, 0xCEE9, 0xCEEA, 0xCEED, 0xCEEE,
+	0xCEEF, 0xCEF0, 0xCEF1, 0xCEF2, 0xCEF3, 0xCEF6, 0xCEFA, 0xCEFB,
+	0xCEFC, 0xCEFD, 0xCEFE, 0xCEFF, 0xAC00, 0xAC01, 0xAC04, 0xAC07,
+	0xAC08, 0xAC09, 0xAC0A, 0xAC10, 0xAC11, 0xAC12, 0xAC13, 0xAC14,
+	0xAC15, 0xAC16, 0xAC17, 0xAC19, 0xAC1A, 0xAC1B, 0xAC1C, 0xAC1D,
+	0xAC20, 0xAC24, 0xAC2C, 0xAC2D, 0xAC2F, 0xAC30, 0xAC31, 0xAC38,
+	0xAC39, 0xAC3C, 0xAC40, 0xAC4B, 0xAC4D, 0xAC54, 0xAC58, 0xAC5C,
+	0xAC70, 0xAC71, 0xAC74, 0xAC77, 0xAC78, 0xAC7A, 0xAC80, 0xAC81,
+	0xAC83, 0xAC84, 0xAC85, 0xAC86, 0xAC89, 0xAC8A, 0xAC8B, 0xAC8C,
+	0xAC90, 0xAC94, 0xAC9C, 0xAC9D, 0xAC9F, 0xACA0, 0xACA1, 0xACA8,
+	0xACA9, 0xACAA, 0xACAC, 0xACAF, 0xACB0, 0xACB8, 0xACB9, 0xACBB,
+	0xACBC, 0xACBD, 0xACC1, 0xACC4, 0xACC8, 0xACCC, 0xACD5, 0xACD7,
+	0xACE0, 0xACE1, 0xACE4, 0xACE7, 0xACE8, 0xACEA, 0xACEC, 0xACEF,
+	0xACF0, 0xACF1, 0xACF3, 0xACF5, 0xACF6, 0xACFC, 0xACFD, 0xAD00,
+	0xAD04, 0xAD06, 0xCF02, 0xCF03, 0xCF05, 0xCF06, 0xCF07, 0xCF09,
+	0xCF0A, 0xCF0B, 0xCF0C, 0xCF0D, 0xCF0E, 0xCF0F, 0xCF12, 0xCF14,
+	0xCF16, 0xCF17, 0xCF18, 0xCF19, 0xCF1A, 0xCF1B, 0xCF1D, 0xCF1E,
+	0xCF1F, 0xCF21, 0xCF22, 0xCF23, 0xCF25, 0xCF26, 0xCF27, 0xCF28,
+	0xCF29, 0xCF2A, 0xCF2B, 0xCF2E, 0xCF32, 0xCF33, 0xCF34, 0xCF35,
+	0xCF36, 0xCF37, 0xCF39, 0xCF3A, 0xCF3B, 0xCF3C, 0xCF3D, 0xCF3E,
+	0xCF3F, 0xCF40, 0xCF41, 0xCF42, 0xCF43, 0xCF44, 0xCF45, 0xCF46,
+	0xCF47, 0xCF48, 0xCF49, 0xCF4A, 0xCF4B, 0xCF4C, 0xCF4D, 0xCF4E,
+	0xCF4F, 0xCF50, 0xCF51, 0xCF52, 0xCF53, 0xCF56, 0xCF57, 0xCF59,
+	0xCF5A, 0xCF5B, 0xCF5D, 0xCF5E, 0xCF5F, 0xCF60, 0xCF61, 0xCF62,
+	0xCF63, 0xCF66, 0xCF68, 0xCF6A, 0xCF6B, 0xCF6C, 0xAD0C, 0xAD0D,
+	0xAD0F, 0xAD11, 0xAD18, 0xAD1C, 0xAD20, 0xAD29, 0xAD2C, 0xAD2D,
+	0xAD34, 0xAD35, 0xAD38, 0xAD3C, 0xAD44, 0xAD45, 0xAD47, 0xAD49,
+	0xAD50, 0xAD54, 0xAD58, 0xAD61, 0xAD63, 0xAD6C, 0xAD6D, 0xAD70,
+	0xAD73, 0xAD74, 0xAD75, 0xAD76, 0xAD7B, 0xAD7C, 0xAD7D, 0xAD7F,
+	0xAD81, 0xAD82, 0xAD88, 0xAD89, 0xAD8C, 0xAD90, 0xAD9C, 0xAD9D,
+	0xADA4, 0xADB7, 0xADC0, 0xADC1, 0xADC4, 0xADC8, 0xADD0, 0xADD1,
+	0xADD3, 0xADDC, 0xADE0, 0xADE4, 0xADF8, 0xADF9, 0xADFC, 0xADFF,
+	0xAE00, 0xAE01, 0xAE08, 0xAE09, 0xAE0B, 0xAE0D, 0xAE14, 0xAE30,
+	0xAE31, 0xAE34, 0xAE37, 0xAE38, 0xAE3A, 0xAE40, 0xAE41, 0xAE43,
+	0xAE45, 0xAE46, 0xAE4A, 0xAE4C, 0xAE4D, 0xAE4E, 0xAE50, 0xAE54,
+	0xAE56, 0xAE5C, 0xAE5D, 0xAE5F, 0xAE60, 0xAE61, 0xAE65, 0xAE68,
+	0xAE69, 0xAE6C, 0xAE70, 0xAE78, 0xCF6D, 0xCF6E, 0xCF6F, 0xCF72,
+	0xCF73, 0xCF75, 0xCF76, 0xCF77, 0xCF79, 0xCF7A, 0xCF7B, 0xCF7C,
+	0xCF7D, 0xCF7E, 0xCF7F, 0xCF81, 0xCF82, 0xCF83, 0xCF84, 0xCF86,
+	0xCF87, 0xCF88, 0xCF89, 0xCF8A, 0xCF8B, 0xCF8D, 0xCF8E, 0xCF8F,
+	0xCF90, 0xCF91, 0xCF92, 0xCF93, 0xCF94, 0xCF95, 0xCF96, 0xCF97,
+	0xCF98, 0xCF99, 0xCF9A, 0xCF9B, 0xCF9C, 0xCF9D, 0xCF9E, 0xCF9F,
+	0xCFA0, 0xCFA2, 0xCFA3, 0xCFA4, 0xCFA5, 0xCFA6, 0xCFA7, 0xCFA9,
+	0xCFAA, 0xCFAB, 0xCFAC, 0xCFAD, 0xCFAE, 0xCFAF, 0xCFB1, 0xCFB2,
+	0xCFB3, 0xCFB4, 0xCFB5, 0xCFB6, 0xCFB7, 0xCFB8, 0xCFB9, 0xCFBA,
+	0xCFBB, 0xCFBC, 0xCFBD, 0xCFBE, 0xCFBF, 0xCFC0, 0xCFC1, 0xCFC2,
+	0xCFC3, 0xCFC5, 0xCFC6, 0xCFC7, 0xCFC8, 0xCFC9, 0xCFCA, 0xCFCB,
+	0xAE79, 0xAE7B, 0xAE7C, 0xAE7D, 0xAE84, 0xAE85, 0xAE8C, 0xAEBC,
+	0xAEBD, 0xAEBE, 0xAEC0, 0xAEC4, 0xAECC, 0xAECD, 0xAECF, 0xAED0,
+	0xAED1, 0xAED8, 0xAED9, 0xAEDC, 0xAEE8, 0xAEEB, 0xAEED, 0xAEF4,
+	0xAEF8, 0xAEFC, 0xAF07, 0xAF08, 0xAF0D, 0xAF10, 0xAF2C, 0xAF2D,
+	0xAF30, 0xAF32, 0xAF34, 0xAF3C, 0xAF3D, 0xAF3F, 0xAF41, 0xAF42,
+	0xAF43, 0xAF48, 0xAF49, 0xAF50, 0xAF5C, 0xAF5D, 0xAF64, 0xAF65,
+	0xAF79, 0xAF80, 0xAF84, 0xAF88, 0xAF90, 0xAF91, 0xAF95, 0xAF9C,
+	0xAFB8, 0xAFB9, 0xAFBC, 0xAFC0, 0xAFC7, 0xAFC8, 0xAFC9, 0xAFCB,
+	0xAFCD, 0xAFCE, 0xAFD4, 0xAFDC, 0xAFE8, 0xAFE9, 0xAFF0, 0xAFF1,
+	0xAFF4, 0xAFF8, 0xB000, 0xB001, 0xB004, 0xB00C, 0xB010, 0xB014,
+	0xB01C, 0xB01D, 0xB028, 0xB044, 0xB045, 0xB048, 0xB04A, 0xB04C,
+	0xB04E, 0xB053, 0xB054, 0xB055, 0xB057, 0xB059, 0xCFCC, 0xCFCD,
+	0xCFCE, 0xCFCF, 0xCFD0, 0xCFD1, 0xCFD2, 0xCFD3, 0xCFD4, 0xCFD5,
+	0xCFD6, 0xCFD7, 0xCFD8, 0xCFD9, 0xCFDA, 0xCFDB, 0xCFDC, 0xCFDD,
+	0xCFDE, 0xCFDF, 0xCFE2, 0xCFE3, 0xCFE5, 0xCFE6, 0xCFE7, 0xCFE9,
+	0xCFEA, 0xCFEB, 0xCFEC, 0xCFED, 0xCFEE, 0xCFEF, 0xCFF2, 0xCFF4,
+	0xCFF6, 0xCFF7, 0xCFF8, 0xCFF9, 0xCFFA, 0xCFFB, 0xCFFD, 0xCFFE,
+	0xCFFF, 0xD001, 0xD002, 0xD003, 0xD005, 0xD006, 0xD007, 0xD008,
+	0xD009, 0xD00A, 0xD00B, 0xD00C, 0xD00D, 0xD00E, 0xD00F, 0xD010,
+	0xD012, 0xD013, 0xD014, 0xD015, 0xD016, 0xD017, 0xD019, 0xD01A,
+	0xD01B, 0xD01C, 0xD01D, 0xD01E, 0xD01F, 0xD020, 0xD021, 0xD022,
+	0xD023, 0xD024, 0xD025, 0xD026, 0xD027, 0xD028, 0xD029, 0xD02A,
+	0xD02B, 0xD02C, 0xB05D, 0xB07C, 0xB07D, 0xB080, 0xB084, 0xB08C,
+	0xB08D, 0xB08F, 0xB091, 0xB098, 0xB099, 0xB09A, 0xB09C, 0xB09F,
+	0xB0A0, 0xB0A1, 0xB0A2, 0xB0A8, 0xB0A9, 0xB0AB, 0xB0AC, 0xB0AD,
+	0xB0AE, 0xB0AF, 0xB0B1, 0xB0B3, 0xB0B4, 0xB0B5, 0xB0B8, 0xB0BC,
+	0xB0C4, 0xB0C5, 0xB0C7, 0xB0C8, 0xB0C9, 0xB0D0, 0xB0D1, 0xB0D4,
+	0xB0D8, 0xB0E0, 0xB0E5, 0xB108, 0xB109, 0xB10B, 0xB10C, 0xB110,
+	0xB112, 0xB113, 0xB118, 0xB119, 0xB11B, 0xB11C, 0xB11D, 0xB123,
+	0xB124, 0xB125, 0xB128, 0xB12C, 0xB134, 0xB135, 0xB137, 0xB138,
+	0xB139, 0xB140, 0xB141, 0xB144, 0xB148, 0xB150, 0xB151, 0xB154,
+	0xB155, 0xB158, 0xB15C, 0xB160, 0xB178, 0xB179, 0xB17C, 0xB180,
+	0xB182, 0xB188, 0xB189, 0xB18B, 0xB18D, 0xB192, 0xB193, 0xB194,
+	0xB198, 0xB19C, 0xB1A8, 0xB1CC, 0xB1D0, 0xB1D4, 0xB1DC, 0xB1DD,
+	0xD02E, 0xD02F, 0xD030, 0xD031, 0xD032, 0xD033, 0xD036, 0xD037,
+	0xD039, 0xD03A, 0xD03B, 0xD03D, 0xD03E, 0xD03F, 0xD040, 0xD041,
+	0xD042, 0xD043, 0xD046, 0xD048, 0xD04A, 0xD04B, 0xD04C, 0xD04D,
+	0xD04E, 0xD04F, 0xD051, 0xD052, 0xD053, 0xD055, 0xD056, 0xD057,
+	0xD059, 0xD05A, 0xD05B, 0xD05C, 0xD05D, 0xD05E, 0xD05F, 0xD061,
+	0xD062, 0xD063, 0xD064, 0xD065, 0xD066, 0xD067, 0xD068, 0xD069,
+	0xD06A, 0xD06B, 0xD06E, 0xD06F, 0xD071, 0xD072, 0xD073, 0xD075,
+	0xD076, 0xD077, 0xD078, 0xD079, 0xD07A, 0xD07B, 0xD07E, 0xD07F,
+	0xD080, 0xD082, 0xD083, 0xD084, 0xD085, 0xD086, 0xD087, 0xD088,
+	0xD089, 0xD08A, 0xD08B, 0xD08C, 0xD08D, 0xD08E, 0xD08F, 0xD090,
+	0xD091, 0xD092, 0xD093, 0xD094, 0xB1DF, 0xB1E8, 0xB1E9, 0xB1EC,
+	0xB1F0, 0xB1F9, 0xB1FB, 0xB1FD, 0xB204, 0xB205, 0xB208, 0xB20B,
+	0xB20C, 0xB214, 0xB215, 0xB217, 0xB219, 0xB220, 0xB234, 0xB23C,
+	0xB258, 0xB25C, 0xB260, 0xB268, 0xB269, 0xB274, 0xB275, 0xB27C,
+	0xB284, 0xB285, 0xB289, 0xB290, 0xB291, 0xB294, 0xB298, 0xB299,
+	0xB29A, 0xB2A0, 0xB2A1, 0xB2A3, 0xB2A5, 0xB2A6, 0xB2AA, 0xB2AC,
+	0xB2B0, 0xB2B4, 0xB2C8, 0xB2C9, 0xB2CC, 0xB2D0, 0xB2D2, 0xB2D8,
+	0xB2D9, 0xB2DB, 0xB2DD, 0xB2E2, 0xB2E4, 0xB2E5, 0xB2E6, 0xB2E8,
+	0xB2EB, 0xB2EC, 0xB2ED, 0xB2EE, 0xB2EF, 0xB2F3, 0xB2F4, 0xB2F5,
+	0xB2F7, 0xB2F8, 0xB2F9, 0xB2FA, 0xB2FB, 0xB2FF, 0xB300, 0xB301,
+	0xB304, 0xB308, 0xB310, 0xB311, 0xB313, 0xB314, 0xB315, 0xB31C,
+	0xB354, 0xB355, 0xB356, 0xB358, 0xB35B, 0xB35C, 0xB35E, 0xB35F,
+	0xB364, 0xB365, 0xD095, 0xD096, 0xD097, 0xD098, 0xD099, 0xD09A,
+	0xD09B, 0xD09C, 0xD09D, 0xD09E, 0xD09F, 0xD0A0, 0xD0A1, 0xD0A2,
+	0xD0A3, 0xD0A6, 0xD0A7, 0xD0A9, 0xD0AA, 0xD0AB, 0xD0AD, 0xD0AE,
+	0xD0AF, 0xD0B0, 0xD0B1, 0xD0B2, 0xD0B3, 0xD0B6, 0xD0B8, 0xD0BA,
+	0xD0BB, 0xD0BC, 0xD0BD, 0xD0BE, 0xD0BF, 0xD0C2, 0xD0C3, 0xD0C5,
+	0xD0C6, 0xD0C7, 0xD0CA, 0xD0CB, 0xD0CC, 0xD0CD, 0xD0CE, 0xD0CF,
+	0xD0D2, 0xD0D6, 0xD0D7, 0xD0D8, 0xD0D9, 0xD0DA, 0xD0DB, 0xD0DE,
+	0xD0DF, 0xD0E1, 0xD0E2, 0xD0E3, 0xD0E5, 0xD0E6, 0xD0E7, 0xD0E8,
+	0xD0E9, 0xD0EA, 0xD0EB, 0xD0EE, 0xD0F2, 0xD0F3, 0xD0F4, 0xD0F5,
+	0xD0F6, 0xD0F7, 0xD0F9, 0xD0FA, 0xD0FB, 0xD0FC, 0xD0FD, 0xD0FE,
+	0xD0FF, 0xD100, 0xD101, 0xD102, 0xD103, 0xD104, 0xB367, 0xB369,
+	0xB36B, 0xB36E, 0xB370, 0xB371, 0xB374, 0xB378, 0xB380, 0xB381,
+	0xB383, 0xB384, 0xB385, 0xB38C, 0xB390, 0xB394, 0xB3A0, 0xB3A1,
+	0xB3A8, 0xB3AC, 0xB3C4, 0xB3C5, 0xB3C8, 0xB3CB, 0xB3CC, 0xB3CE,
+	0xB3D0, 0xB3D4, 0xB3D5, 0xB3D7, 0xB3D9, 0xB3DB, 0xB3DD, 0xB3E0,
+	0xB3E4, 0xB3E8, 0xB3FC, 0xB410, 0xB418, 0xB41C, 0xB420, 0xB428,
+	0xB429, 0xB42B, 0xB434, 0xB450, 0xB451, 0xB454, 0xB458, 0xB460,
+	0xB461, 0xB463, 0xB465, 0xB46C, 0xB480, 0xB488, 0xB49D, 0xB4A4,
+	0xB4A8, 0xB4AC, 0xB4B5, 0xB4B7, 0xB4B9, 0xB4C0, 0xB4C4, 0xB4C8,
+	0xB4D0, 0xB4D5, 0xB4DC, 0xB4DD, 0xB4E0, 0xB4E3, 0xB4E4, 0xB4E6,
+	0xB4EC, 0xB4ED, 0xB4EF, 0xB4F1, 0xB4F8, 0xB514, 0xB515, 0xB518,
+	0xB51B, 0xB51C, 0xB524, 0xB525, 0xB527, 0xB528, 0xB529, 0xB52A,
+	0xB530, 0xB531, 0xB534, 0xB538, 0xD105, 0xD106, 0xD107, 0xD108,
+	0xD109, 0xD10A, 0xD10B, 0xD10C, 0xD10E, 0xD10F, 0xD110, 0xD111,
+	0xD112, 0xD113, 0xD114, 0xD115, 0xD116, 0xD117, 0xD118, 0xD119,
+	0xD11A, 0xD11B, 0xD11C, 0xD11D, 0xD11E, 0xD11F, 0xD120, 0xD121,
+	0xD122, 0xD123, 0xD124, 0xD125, 0xD126, 0xD127, 0xD128, 0xD129,
+	0xD12A, 0xD12B, 0xD12C, 0xD12D, 0xD12E, 0xD12F, 0xD132, 0xD133,
+	0xD135, 0xD136, 0xD137, 0xD139, 0xD13B, 0xD13C, 0xD13D, 0xD13E,
+	0xD13F, 0xD142, 0xD146, 0xD147, 0xD148, 0xD149, 0xD14A, 0xD14B,
+	0xD14E, 0xD14F, 0xD151, 0xD152, 0xD153, 0xD155, 0xD156, 0xD157,
+	0xD158, 0xD159, 0xD15A, 0xD15B, 0xD15E, 0xD160, 0xD162, 0xD163,
+	0xD164, 0xD165, 0xD166, 0xD167, 0xD169, 0xD16A, 0xD16B, 0xD16D,
+	0xB540, 0xB541, 0xB543, 0xB544, 0xB545, 0xB54B, 0xB54C, 0xB54D,
+	0xB550, 0xB554, 0xB55C, 0xB55D, 0xB55F, 0xB560, 0xB561, 0xB5A0,
+	0xB5A1, 0xB5A4, 0xB5A8, 0xB5AA, 0xB5AB, 0xB5B0, 0xB5B1, 0xB5B3,
+	0xB5B4, 0xB5B5, 0xB5BB, 0xB5BC, 0xB5BD, 0xB5C0, 0xB5C4, 0xB5CC,
+	0xB5CD, 0xB5CF, 0xB5D0, 0xB5D1, 0xB5D8, 0xB5EC, 0xB610, 0xB611,
+	0xB614, 0xB618, 0xB625, 0xB62C, 0xB634, 0xB648, 0xB664, 0xB668,
+	0xB69C, 0xB69D, 0xB6A0, 0xB6A4, 0xB6AB, 0xB6AC, 0xB6B1, 0xB6D4,
+	0xB6F0, 0xB6F4, 0xB6F8, 0xB700, 0xB701, 0xB705, 0xB728, 0xB729,
+	0xB72C, 0xB72F, 0xB730, 0xB738, 0xB739, 0xB73B, 0xB744, 0xB748,
+	0xB74C, 0xB754, 0xB755, 0xB760, 0xB764, 0xB768, 0xB770, 0xB771,
+	0xB773, 0xB775, 0xB77C, 0xB77D, 0xB780, 0xB784, 0xB78C, 0xB78D,
+	0xB78F, 0xB790, 0xB791, 0xB792, 0xB796, 0xB797, 0xD16E, 0xD16F,
+	0xD170, 0xD171, 0xD172, 0xD173, 0xD174, 0xD175, 0xD176, 0xD177,
+	0xD178, 0xD179, 0xD17A, 0xD17B, 0xD17D, 0xD17E, 0xD17F, 0xD180,
+	0xD181, 0xD182, 0xD183, 0xD185, 0xD186, 0xD187, 0xD189, 0xD18A,
+	0xD18B, 0xD18C, 0xD18D, 0xD18E, 0xD18F, 0xD190, 0xD191, 0xD192,
+	0xD193, 0xD194, 0xD195, 0xD196, 0xD197, 0xD198, 0xD199, 0xD19A,
+	0xD19B, 0xD19C, 0xD19D, 0xD19E, 0xD19F, 0xD1A2, 0xD1A3, 0xD1A5,
+	0xD1A6, 0xD1A7, 0xD1A9, 0xD1AA, 0xD1AB, 0xD1AC, 0xD1AD, 0xD1AE,
+	0xD1AF, 0xD1B2, 0xD1B4, 0xD1B6, 0xD1B7, 0xD1B8, 0xD1B9, 0xD1BB,
+	0xD1BD, 0xD1BE, 0xD1BF, 0xD1C1, 0xD1C2, 0xD1C3, 0xD1C4, 0xD1C5,
+	0xD1C6, 0xD1C7, 0xD1C8, 0xD1C9, 0xD1CA, 0xD1CB, 0xD1CC, 0xD1CD,
+	0xD1CE, 0xD1CF, 0xB798, 0xB799, 0xB79C, 0xB7A0, 0xB7A8, 0xB7A9,
+	0xB7AB, 0xB7AC, 0xB7AD, 0xB7B4, 0xB7B5, 0xB7B8, 0xB7C7, 0xB7C9,
+	0xB7EC, 0xB7ED, 0xB7F0, 0xB7F4, 0xB7FC, 0xB7FD, 0xB7FF, 0xB800,
+	0xB801, 0xB807, 0xB808, 0xB809, 0xB80C, 0xB810, 0xB818, 0xB819,
+	0xB81B, 0xB81D, 0xB824, 0xB825, 0xB828, 0xB82C, 0xB834, 0xB835,
+	0xB837, 0xB838, 0xB839, 0xB840, 0xB844, 0xB851, 0xB853, 0xB85C,
+	0xB85D, 0xB860, 0xB864, 0xB86C, 0xB86D, 0xB86F, 0xB871, 0xB878,
+	0xB87C, 0xB88D, 0xB8A8, 0xB8B0, 0xB8B4, 0xB8B8, 0xB8C0, 0xB8C1,
+	0xB8C3, 0xB8C5, 0xB8CC, 0xB8D0, 0xB8D4, 0xB8DD, 0xB8DF, 0xB8E1,
+	0xB8E8, 0xB8E9, 0xB8EC, 0xB8F0, 0xB8F8, 0xB8F9, 0xB8FB, 0xB8FD,
+	0xB904, 0xB918, 0xB920, 0xB93C, 0xB93D, 0xB940, 0xB944, 0xB94C,
+	0xB94F, 0xB951, 0xB958, 0xB959, 0xB95C, 0xB960, 0xB968, 0xB969,
+	0xD1D0, 0xD1D1, 0xD1D2, 0xD1D3, 0xD1D4, 0xD1D5, 0xD1D6, 0xD1D7,
+	0xD1D9, 0xD1DA, 0xD1DB, 0xD1DC, 0xD1DD, 0xD1DE, 0xD1DF, 0xD1E0,
+	0xD1E1, 0xD1E2, 0xD1E3, 0xD1E4, 0xD1E5, 0xD1E6, 0xD1E7, 0xD1E8,
+	0xD1E9, 0xD1EA, 0xD1EB, 0xD1EC, 0xD1ED, 0xD1EE, 0xD1EF, 0xD1F0,
+	0xD1F1, 0xD1F2, 0xD1F3, 0xD1F5, 0xD1F6, 0xD1F7, 0xD1F9, 0xD1FA,
+	0xD1FB, 0xD1FC, 0xD1FD, 0xD1FE, 0xD1FF, 0xD200, 0xD201, 0xD202,
+	0xD203, 0xD204, 0xD205, 0xD206, 0xD208, 0xD20A, 0xD20B, 0xD20C,
+	0xD20D, 0xD20E, 0xD20F, 0xD211, 0xD212, 0xD213, 0xD214, 0xD215,
+	0xD216, 0xD217, 0xD218, 0xD219, 0xD21A, 0xD21B, 0xD21C, 0xD21D,
+	0xD21E, 0xD21F, 0xD220, 0xD221, 0xD222, 0xD223, 0xD224, 0xD225,
+	0xD226, 0xD227, 0xD228, 0xD229, 0xB96B, 0xB96D, 0xB974, 0xB975,
+	0xB978, 0xB97C, 0xB984, 0xB985, 0xB987, 0xB989, 0xB98A, 0xB98D,
+	0xB98E, 0xB9AC, 0xB9AD, 0xB9B0, 0xB9B4, 0xB9BC, 0xB9BD, 0xB9BF,
+	0xB9C1, 0xB9C8, 0xB9C9, 0xB9CC, 0xB9CE, 0xB9CF, 0xB9D0, 0xB9D1,
+	0xB9D2, 0xB9D8, 0xB9D9, 0xB9DB, 0xB9DD, 0xB9DE, 0xB9E1, 0xB9E3,
+	0xB9E4, 0xB9E5, 0xB9E8, 0xB9EC, 0xB9F4, 0xB9F5, 0xB9F7, 0xB9F8,
+	0xB9F9, 0xB9FA, 0xBA00, 0xBA01, 0xBA08, 0xBA15, 0xBA38, 0xBA39,
+	0xBA3C, 0xBA40, 0xBA42, 0xBA48, 0xBA49, 0xBA4B, 0xBA4D, 0xBA4E,
+	0xBA53, 0xBA54, 0xBA55, 0xBA58, 0xBA5C, 0xBA64, 0xBA65, 0xBA67,
+	0xBA68, 0xBA69, 0xBA70, 0xBA71, 0xBA74, 0xBA78, 0xBA83, 0xBA84,
+	0xBA85, 0xBA87, 0xBA8C, 0xBAA8, 0xBAA9, 0xBAAB, 0xBAAC, 0xBAB0,
+	0xBAB2, 0xBAB8, 0xBAB9, 0xBABB, 0xBABD, 0xBAC4, 0xBAC8, 0xBAD8,
+	0xBAD9, 0xBAFC, 0xD22A, 0xD22B, 0xD22E, 0xD22F, 0xD231, 0xD232,
+	0xD233, 0xD235, 0xD236, 0xD237, 0xD238, 0xD239, 0xD23A, 0xD23B,
+	0xD23E, 0xD240, 0xD242, 0xD243, 0xD244, 0xD245, 0xD246, 0xD247,
+	0xD249, 0xD24A, 0xD24B, 0xD24C, 0xD24D, 0xD24E, 0xD24F, 0xD250,
+	0xD251, 0xD252, 0xD253, 0xD254, 0xD255, 0xD256, 0xD257, 0xD258,
+	0xD259, 0xD25A, 0xD25B, 0xD25D, 0xD25E, 0xD25F, 0xD260, 0xD261,
+	0xD262, 0xD263, 0xD265, 0xD266, 0xD267, 0xD268, 0xD269, 0xD26A,
+	0xD26B, 0xD26C, 0xD26D, 0xD26E, 0xD26F, 0xD270, 0xD271, 0xD272,
+	0xD273, 0xD274, 0xD275, 0xD276, 0xD277, 0xD278, 0xD279, 0xD27A,
+	0xD27B, 0xD27C, 0xD27D, 0xD27E, 0xD27F, 0xD282, 0xD283, 0xD285,
+	0xD286, 0xD287, 0xD289, 0xD28A, 0xD28B, 0xD28C, 0xBB00, 0xBB04,
+	0xBB0D, 0xBB0F, 0xBB11, 0xBB18, 0xBB1C, 0xBB20, 0xBB29, 0xBB2B,
+	0xBB34, 0xBB35, 0xBB36, 0xBB38, 0xBB3B, 0xBB3C, 0xBB3D, 0xBB3E,
+	0xBB44, 0xBB45, 0xBB47, 0xBB49, 0xBB4D, 0xBB4F, 0xBB50, 0xBB54,
+	0xBB58, 0xBB61, 0xBB63, 0xBB6C, 0xBB88, 0xBB8C, 0xBB90, 0xBBA4,
+	0xBBA8, 0xBBAC, 0xBBB4, 0xBBB7, 0xBBC0, 0xBBC4, 0xBBC8, 0xBBD0,
+	0xBBD3, 0xBBF8, 0xBBF9, 0xBBFC, 0xBBFF, 0xBC00, 0xBC02, 0xBC08,
+	0xBC09, 0xBC0B, 0xBC0C, 0xBC0D, 0xBC0F, 0xBC11, 0xBC14, 0xBC15,
+	0xBC16, 0xBC17, 0xBC18, 0xBC1B, 0xBC1C, 0xBC1D, 0xBC1E, 0xBC1F,
+	0xBC24, 0xBC25, 0xBC27, 0xBC29, 0xBC2D, 0xBC30, 0xBC31, 0xBC34,
+	0xBC38, 0xBC40, 0xBC41, 0xBC43, 0xBC44, 0xBC45, 0xBC49, 0xBC4C,
+	0xBC4D, 0xBC50, 0xBC5D, 0xBC84, 0xBC85, 0xBC88, 0xBC8B, 0xBC8C,
+	0xBC8E, 0xBC94, 0xBC95, 0xBC97, 0xD28D, 0xD28E, 0xD28F, 0xD292,
+	0xD293, 0xD294, 0xD296, 0xD297, 0xD298, 0xD299, 0xD29A, 0xD29B,
+	0xD29D, 0xD29E, 0xD29F, 0xD2A1, 0xD2A2, 0xD2A3, 0xD2A5, 0xD2A6,
+	0xD2A7, 0xD2A8, 0xD2A9, 0xD2AA, 0xD2AB, 0xD2AD, 0xD2AE, 0xD2AF,
+	0xD2B0, 0xD2B2, 0xD2B3, 0xD2B4, 0xD2B5, 0xD2B6, 0xD2B7, 0xD2BA,
+	0xD2BB, 0xD2BD, 0xD2BE, 0xD2C1, 0xD2C3, 0xD2C4, 0xD2C5, 0xD2C6,
+	0xD2C7, 0xD2CA, 0xD2CC, 0xD2CD, 0xD2CE, 0xD2CF, 0xD2D0, 0xD2D1,
+	0xD2D2, 0xD2D3, 0xD2D5, 0xD2D6, 0xD2D7, 0xD2D9, 0xD2DA, 0xD2DB,
+	0xD2DD, 0xD2DE, 0xD2DF, 0xD2E0, 0xD2E1, 0xD2E2, 0xD2E3, 0xD2E6,
+	0xD2E7, 0xD2E8, 0xD2E9, 0xD2EA, 0xD2EB, 0xD2EC, 0xD2ED, 0xD2EE,
+	0xD2EF, 0xD2F2, 0xD2F3, 0xD2F5, 0xD2F6, 0xD2F7, 0xD2F9, 0xD2FA,
+	0xBC99, 0xBC9A, 0xBCA0, 0xBCA1, 0xBCA4, 0xBCA7, 0xBCA8, 0xBCB0,
+	0xBCB1, 0xBCB3, 0xBCB4, 0xBCB5, 0xBCBC, 0xBCBD, 0xBCC0, 0xBCC4,
+	0xBCCD, 0xBCCF, 0xBCD0, 0xBCD1, 0xBCD5, 0xBCD8, 0xBCDC, 0xBCF4,
+	0xBCF5, 0xBCF6, 0xBCF8, 0xBCFC, 0xBD04, 0xBD05, 0xBD07, 0xBD09,
+	0xBD10, 0xBD14, 0xBD24, 0xBD2C, 0xBD40, 0xBD48, 0xBD49, 0xBD4C,
+	0xBD50, 0xBD58, 0xBD59, 0xBD64, 0xBD68, 0xBD80, 0xBD81, 0xBD84,
+	0xBD87, 0xBD88, 0xBD89, 0xBD8A, 0xBD90, 0xBD91, 0xBD93, 0xBD95,
+	0xBD99, 0xBD9A, 0xBD9C, 0xBDA4, 0xBDB0, 0xBDB8, 0xBDD4, 0xBDD5,
+	0xBDD8, 0xBDDC, 0xBDE9, 0xBDF0, 0xBDF4, 0xBDF8, 0xBE00, 0xBE03,
+	0xBE05, 0xBE0C, 0xBE0D, 0xBE10, 0xBE14, 0xBE1C, 0xBE1D, 0xBE1F,
+	0xBE44, 0xBE45, 0xBE48, 0xBE4C, 0xBE4E, 0xBE54, 0xBE55, 0xBE57,
+	0xBE59, 0xBE5A, 0xBE5B, 0xBE60, 0xBE61, 0xBE64, 0xD2FB, 0xD2FC,
+	0xD2FD, 0xD2FE, 0xD2FF, 0xD302, 0xD304, 0xD306, 0xD307, 0xD308,
+	0xD309, 0xD30A, 0xD30B, 0xD30F, 0xD311, 0xD312, 0xD313, 0xD315,
+	0xD317, 0xD318, 0xD319, 0xD31A, 0xD31B, 0xD31E, 0xD322, 0xD323,
+	0xD324, 0xD326, 0xD327, 0xD32A, 0xD32B, 0xD32D, 0xD32E, 0xD32F,
+	0xD331, 0xD332, 0xD333, 0xD334, 0xD335, 0xD336, 0xD337, 0xD33A,
+	0xD33E, 0xD33F, 0xD340, 0xD341, 0xD342, 0xD343, 0xD346, 0xD347,
+	0xD348, 0xD349, 0xD34A, 0xD34B, 0xD34C, 0xD34D, 0xD34E, 0xD34F,
+	0xD350, 0xD351, 0xD352, 0xD353, 0xD354, 0xD355, 0xD356, 0xD357,
+	0xD358, 0xD359, 0xD35A, 0xD35B, 0xD35C, 0xD35D, 0xD35E, 0xD35F,
+	0xD360, 0xD361, 0xD362, 0xD363, 0xD364, 0xD365, 0xD366, 0xD367,
+	0xD368, 0xD369, 0xBE68, 0xBE6A, 0xBE70, 0xBE71, 0xBE73, 0xBE74,
+	0xBE75, 0xBE7B, 0xBE7C, 0xBE7D, 0xBE80, 0xBE84, 0xBE8C, 0xBE8D,
+	0xBE8F, 0xBE90, 0xBE91, 0xBE98, 0xBE99, 0xBEA8, 0xBED0, 0xBED1,
+	0xBED4, 0xBED7, 0xBED8, 0xBEE0, 0xBEE3, 0xBEE4, 0xBEE5, 0xBEEC,
+	0xBF01, 0xBF08, 0xBF09, 0xBF18, 0xBF19, 0xBF1B, 0xBF1C, 0xBF1D,
+	0xBF40, 0xBF41, 0xBF44, 0xBF48, 0xBF50, 0xBF51, 0xBF55, 0xBF94,
+	0xBFB0, 0xBFC5, 0xBFCC, 0xBFCD, 0xBFD0, 0xBFD4, 0xBFDC, 0xBFDF,
+	0xBFE1, 0xC03C, 0xC051, 0xC058, 0xC05C, 0xC060, 0xC068, 0xC069,
+	0xC090, 0xC091, 0xC094, 0xC098, 0xC0A0, 0xC0A1, 0xC0A3, 0xC0A5,
+	0xC0AC, 0xC0AD, 0xC0AF, 0xC0B0, 0xC0B3, 0xC0B4, 0xC0B5, 0xC0B6,
+	0xC0BC, 0xC0BD, 0xC0BF, 0xC0C0, 0xC0C1, 0xC0C5, 0xC0C8, 0xC0C9,
+	0xC0CC, 0xC0D0, 0xC0D8, 0xC0D9, 0xC0DB, 0xC0DC, 0xC0DD, 0xC0E4,
+	0xD36A, 0xD36B, 0xD36C, 0xD36D, 0xD36E, 0xD36F, 0xD370, 0xD371,
+	0xD372, 0xD373, 0xD374, 0xD375, 0xD376, 0xD377, 0xD378, 0xD379,
+	0xD37A, 0xD37B, 0xD37E, 0xD37F, 0xD381, 0xD382, 0xD383, 0xD385,
+	0xD386, 0xD387, 0xD388, 0xD389, 0xD38A, 0xD38B, 0xD38E, 0xD392,
+	0xD393, 0xD394, 0xD395, 0xD396, 0xD397, 0xD39A, 0xD39B, 0xD39D,
+	0xD39E, 0xD39F, 0xD3A1, 0xD3A2, 0xD3A3, 0xD3A4, 0xD3A5, 0xD3A6,
+	0xD3A7, 0xD3AA, 0xD3AC, 0xD3AE, 0xD3AF, 0xD3B0, 0xD3B1, 0xD3B2,
+	0xD3B3, 0xD3B5, 0xD3B6, 0xD3B7, 0xD3B9, 0xD3BA, 0xD3BB, 0xD3BD,
+	0xD3BE, 0xD3BF, 0xD3C0, 0xD3C1, 0xD3C2, 0xD3C3, 0xD3C6, 0xD3C7,
+	0xD3CA, 0xD3CB, 0xD3CC, 0xD3CD, 0xD3CE, 0xD3CF, 0xD3D1, 0xD3D2,
+	0xD3D3, 0xD3D4, 0xD3D5, 0xD3D6, 0xC0E5, 0xC0E8, 0xC0EC, 0xC0F4,
+	0xC0F5, 0xC0F7, 0xC0F9, 0xC100, 0xC104, 0xC108, 0xC110, 0xC115,
+	0xC11C, 0xC11D, 0xC11E, 0xC11F, 0xC120, 0xC123, 0xC124, 0xC126,
+	0xC127, 0xC12C, 0xC12D, 0xC12F, 0xC130, 0xC131, 0xC136, 0xC138,
+	0xC139, 0xC13C, 0xC140, 0xC148, 0xC149, 0xC14B, 0xC14C, 0xC14D,
+	0xC154, 0xC155, 0xC158, 0xC15C, 0xC164, 0xC165, 0xC167, 0xC168,
+	0xC169, 0xC170, 0xC174, 0xC178, 0xC185, 0xC18C, 0xC18D, 0xC18E,
+	0xC190, 0xC194, 0xC196, 0xC19C, 0xC19D, 0xC19F, 0xC1A1, 0xC1A5,
+	0xC1A8, 0xC1A9, 0xC1AC, 0xC1B0, 0xC1BD, 0xC1C4, 0xC1C8, 0xC1CC,
+	0xC1D4, 0xC1D7, 0xC1D8, 0xC1E0, 0xC1E4, 0xC1E8, 0xC1F0, 0xC1F1,
+	0xC1F3, 0xC1FC, 0xC1FD, 0xC200, 0xC204, 0xC20C, 0xC20D, 0xC20F,
+	0xC211, 0xC218, 0xC219, 0xC21C, 0xC21F, 0xC220, 0xC228, 0xC229,
+	0xC22B, 0xC22D, 0xD3D7, 0xD3D9, 0xD3DA, 0xD3DB, 0xD3DC, 0xD3DD,
+	0xD3DE, 0xD3DF, 0xD3E0, 0xD3E2, 0xD3E4, 0xD3E5, 0xD3E6, 0xD3E7,
+	0xD3E8, 0xD3E9, 0xD3EA, 0xD3EB, 0xD3EE, 0xD3EF, 0xD3F1, 0xD3F2,
+	0xD3F3, 0xD3F5, 0xD3F6, 0xD3F7, 0xD3F8, 0xD3F9, 0xD3FA, 0xD3FB,
+	0xD3FE, 0xD400, 0xD402, 0xD403, 0xD404, 0xD405, 0xD406, 0xD407,
+	0xD409, 0xD40A, 0xD40B, 0xD40C, 0xD40D, 0xD40E, 0xD40F, 0xD410,
+	0xD411, 0xD412, 0xD413, 0xD414, 0xD415, 0xD416, 0xD417, 0xD418,
+	0xD419, 0xD41A, 0xD41B, 0xD41C, 0xD41E, 0xD41F, 0xD420, 0xD421,
+	0xD422, 0xD423, 0xD424, 0xD425, 0xD426, 0xD427, 0xD428, 0xD429,
+	0xD42A, 0xD42B, 0xD42C, 0xD42D, 0xD42E, 0xD42F, 0xD430, 0xD431,
+	0xD432, 0xD433, 0xD434, 0xD435, 0xD436, 0xD437, 0xC22F, 0xC231,
+	0xC232, 0xC234, 0xC248, 0xC250, 0xC251, 0xC254, 0xC258, 0xC260,
+	0xC265, 0xC26C, 0xC26D, 0xC270, 0xC274, 0xC27C, 0xC27D, 0xC27F,
+	0xC281, 0xC288, 0xC289, 0xC290, 0xC298, 0xC29B, 0xC29D, 0xC2A4,
+	0xC2A5, 0xC2A8, 0xC2AC, 0xC2AD, 0xC2B4, 0xC2B5, 0xC2B7, 0xC2B9,
+	0xC2DC, 0xC2DD, 0xC2E0, 0xC2E3, 0xC2E4, 0xC2EB, 0xC2EC, 0xC2ED,
+	0xC2EF, 0xC2F1, 0xC2F6, 0xC2F8, 0xC2F9, 0xC2FB, 0xC2FC, 0xC300,
+	0xC308, 0xC309, 0xC30C, 0xC30D, 0xC313, 0xC314, 0xC315, 0xC318,
+	0xC31C, 0xC324, 0xC325, 0xC328, 0xC329, 0xC345, 0xC368, 0xC369,
+	0xC36C, 0xC370, 0xC372, 0xC378, 0xC379, 0xC37C, 0xC37D, 0xC384,
+	0xC388, 0xC38C, 0xC3C0, 0xC3D8, 0xC3D9, 0xC3DC, 0xC3DF, 0xC3E0,
+	0xC3E2, 0xC3E8, 0xC3E9, 0xC3ED, 0xC3F4, 0xC3F5, 0xC3F8, 0xC408,
+	0xC410, 0xC424, 0xC42C, 0xC430, 0xD438, 0xD439, 0xD43A, 0xD43B,
+	0xD43C, 0xD43D, 0xD43E, 0xD43F, 0xD441, 0xD442, 0xD443, 0xD445,
+	0xD446, 0xD447, 0xD448, 0xD449, 0xD44A, 0xD44B, 0xD44C, 0xD44D,
+	0xD44E, 0xD44F, 0xD450, 0xD451, 0xD452, 0xD453, 0xD454, 0xD455,
+	0xD456, 0xD457, 0xD458, 0xD459, 0xD45A, 0xD45B, 0xD45D, 0xD45E,
+	0xD45F, 0xD461, 0xD462, 0xD463, 0xD465, 0xD466, 0xD467, 0xD468,
+	0xD469, 0xD46A, 0xD46B, 0xD46C, 0xD46E, 0xD470, 0xD471, 0xD472,
+	0xD473, 0xD474, 0xD475, 0xD476, 0xD477, 0xD47A, 0xD47B, 0xD47D,
+	0xD47E, 0xD481, 0xD483, 0xD484, 0xD485, 0xD486, 0xD487, 0xD48A,
+	0xD48C, 0xD48E, 0xD48F, 0xD490, 0xD491, 0xD492, 0xD493, 0xD495,
+	0xD496, 0xD497, 0xD498, 0xD499, 0xD49A, 0xD49B, 0xD49C, 0xD49D,
+	0xC434, 0xC43C, 0xC43D, 0xC448, 0xC464, 0xC465, 0xC468, 0xC46C,
+	0xC474, 0xC475, 0xC479, 0xC480, 0xC494, 0xC49C, 0xC4B8, 0xC4BC,
+	0xC4E9, 0xC4F0, 0xC4F1, 0xC4F4, 0xC4F8, 0xC4FA, 0xC4FF, 0xC500,
+	0xC501, 0xC50C, 0xC510, 0xC514, 0xC51C, 0xC528, 0xC529, 0xC52C,
+	0xC530, 0xC538, 0xC539, 0xC53B, 0xC53D, 0xC544, 0xC545, 0xC548,
+	0xC549, 0xC54A, 0xC54C, 0xC54D, 0xC54E, 0xC553, 0xC554, 0xC555,
+	0xC557, 0xC558, 0xC559, 0xC55D, 0xC55E, 0xC560, 0xC561, 0xC564,
+	0xC568, 0xC570, 0xC571, 0xC573, 0xC574, 0xC575, 0xC57C, 0xC57D,
+	0xC580, 0xC584, 0xC587, 0xC58C, 0xC58D, 0xC58F, 0xC591, 0xC595,
+	0xC597, 0xC598, 0xC59C, 0xC5A0, 0xC5A9, 0xC5B4, 0xC5B5, 0xC5B8,
+	0xC5B9, 0xC5BB, 0xC5BC, 0xC5BD, 0xC5BE, 0xC5C4, 0xC5C5, 0xC5C6,
+	0xC5C7, 0xC5C8, 0xC5C9, 0xC5CA, 0xC5CC, 0xC5CE, 0xD49E, 0xD49F,
+	0xD4A0, 0xD4A1, 0xD4A2, 0xD4A3, 0xD4A4, 0xD4A5, 0xD4A6, 0xD4A7,
+	0xD4A8, 0xD4AA, 0xD4AB, 0xD4AC, 0xD4AD, 0xD4AE, 0xD4AF, 0xD4B0,
+	0xD4B1, 0xD4B2, 0xD4B3, 0xD4B4, 0xD4B5, 0xD4B6, 0xD4B7, 0xD4B8,
+	0xD4B9, 0xD4BA, 0xD4BB, 0xD4BC, 0xD4BD, 0xD4BE, 0xD4BF, 0xD4C0,
+	0xD4C1, 0xD4C2, 0xD4C3, 0xD4C4, 0xD4C5, 0xD4C6, 0xD4C7, 0xD4C8,
+	0xD4C9, 0xD4CA, 0xD4CB, 0xD4CD, 0xD4CE, 0xD4CF, 0xD4D1, 0xD4D2,
+	0xD4D3, 0xD4D5, 0xD4D6, 0xD4D7, 0xD4D8, 0xD4D9, 0xD4DA, 0xD4DB,
+	0xD4DD, 0xD4DE, 0xD4E0, 0xD4E1, 0xD4E2, 0xD4E3, 0xD4E4, 0xD4E5,
+	0xD4E6, 0xD4E7, 0xD4E9, 0xD4EA, 0xD4EB, 0xD4ED, 0xD4EE, 0xD4EF,
+	0xD4F1, 0xD4F2, 0xD4F3, 0xD4F4, 0xD4F5, 0xD4F6, 0xD4F7, 0xD4F9,
+	0xD4FA, 0xD4FC, 0xC5D0, 0xC5D1, 0xC5D4, 0xC5D8, 0xC5E0, 0xC5E1,
+	0xC5E3, 0xC5E5, 0xC5EC, 0xC5ED, 0xC5EE, 0xC5F0, 0xC5F4, 0xC5F6,
+	0xC5F7, 0xC5FC, 0xC5FD, 0xC5FE, 0xC5FF, 0xC600, 0xC601, 0xC605,
+	0xC606, 0xC607, 0xC608, 0xC60C, 0xC610, 0xC618, 0xC619, 0xC61B,
+	0xC61C, 0xC624, 0xC625, 0xC628, 0xC62C, 0xC62D, 0xC62E, 0xC630,
+	0xC633, 0xC634, 0xC635, 0xC637, 0xC639, 0xC63B, 0xC640, 0xC641,
+	0xC644, 0xC648, 0xC650, 0xC651, 0xC653, 0xC654, 0xC655, 0xC65C,
+	0xC65D, 0xC660, 0xC66C, 0xC66F, 0xC671, 0xC678, 0xC679, 0xC67C,
+	0xC680, 0xC688, 0xC689, 0xC68B, 0xC68D, 0xC694, 0xC695, 0xC698,
+	0xC69C, 0xC6A4, 0xC6A5, 0xC6A7, 0xC6A9, 0xC6B0, 0xC6B1, 0xC6B4,
+	0xC6B8, 0xC6B9, 0xC6BA, 0xC6C0, 0xC6C1, 0xC6C3, 0xC6C5, 0xC6CC,
+	0xC6CD, 0xC6D0, 0xC6D4, 0xC6DC, 0xC6DD, 0xC6E0, 0xC6E1, 0xC6E8,
+	0xD4FE, 0xD4FF, 0xD500, 0xD501, 0xD502, 0xD503, 0xD505, 0xD506,
+	0xD507, 0xD509, 0xD50A, 0xD50B, 0xD50D, 0xD50E, 0xD50F, 0xD510,
+	0xD511, 0xD512, 0xD513, 0xD516, 0xD518, 0xD519, 0xD51A, 0xD51B,
+	0xD51C, 0xD51D, 0xD51E, 0xD51F, 0xD520, 0xD521, 0xD522, 0xD523,
+	0xD524, 0xD525, 0xD526, 0xD527, 0xD528, 0xD529, 0xD52A, 0xD52B,
+	0xD52C, 0xD52D, 0xD52E, 0xD52F, 0xD530, 0xD531, 0xD532, 0xD533,
+	0xD534, 0xD535, 0xD536, 0xD537, 0xD538, 0xD539, 0xD53A, 0xD53B,
+	0xD53E, 0xD53F, 0xD541, 0xD542, 0xD543, 0xD545, 0xD546, 0xD547,
+	0xD548, 0xD549, 0xD54A, 0xD54B, 0xD54E, 0xD550, 0xD552, 0xD553,
+	0xD554, 0xD555, 0xD556, 0xD557, 0xD55A, 0xD55B, 0xD55D, 0xD55E,
+	0xD55F, 0xD561, 0xD562, 0xD563, 0xC6E9, 0xC6EC, 0xC6F0, 0xC6F8,
+	0xC6F9, 0xC6FD, 0xC704, 0xC705, 0xC708, 0xC70C, 0xC714, 0xC715,
+	0xC717, 0xC719, 0xC720, 0xC721, 0xC724, 0xC728, 0xC730, 0xC731,
+	0xC733, 0xC735, 0xC737, 0xC73C, 0xC73D, 0xC740, 0xC744, 0xC74A,
+	0xC74C, 0xC74D, 0xC74F, 0xC751, 0xC752, 0xC753, 0xC754, 0xC755,
+	0xC756, 0xC757, 0xC758, 0xC75C, 0xC760, 0xC768, 0xC76B, 0xC774,
+	0xC775, 0xC778, 0xC77C, 0xC77D, 0xC77E, 0xC783, 0xC784, 0xC785,
+	0xC787, 0xC788, 0xC789, 0xC78A, 0xC78E, 0xC790, 0xC791, 0xC794,
+	0xC796, 0xC797, 0xC798, 0xC79A, 0xC7A0, 0xC7A1, 0xC7A3, 0xC7A4,
+	0xC7A5, 0xC7A6, 0xC7AC, 0xC7AD, 0xC7B0, 0xC7B4, 0xC7BC, 0xC7BD,
+	0xC7BF, 0xC7C0, 0xC7C1, 0xC7C8, 0xC7C9, 0xC7CC, 0xC7CE, 0xC7D0,
+	0xC7D8, 0xC7DD, 0xC7E4, 0xC7E8, 0xC7EC, 0xC800, 0xC801, 0xC804,
+	0xC808, 0xC80A, 0xD564, 0xD566, 0xD567, 0xD56A, 0xD56C, 0xD56E,
+	0xD56F, 0xD570, 0xD571, 0xD572, 0xD573, 0xD576, 0xD577, 0xD579,
+	0xD57A, 0xD57B, 0xD57D, 0xD57E, 0xD57F, 0xD580, 0xD581, 0xD582,
+	0xD583, 0xD586, 0xD58A, 0xD58B, 0xD58C, 0xD58D, 0xD58E, 0xD58F,
+	0xD591, 0xD592, 0xD593, 0xD594, 0xD595, 0xD596, 0xD597, 0xD598,
+	0xD599, 0xD59A, 0xD59B, 0xD59C, 0xD59D, 0xD59E, 0xD59F, 0xD5A0,
+	0xD5A1, 0xD5A2, 0xD5A3, 0xD5A4, 0xD5A6, 0xD5A7, 0xD5A8, 0xD5A9,
+	0xD5AA, 0xD5AB, 0xD5AC, 0xD5AD, 0xD5AE, 0xD5AF, 0xD5B0, 0xD5B1,
+	0xD5B2, 0xD5B3, 0xD5B4, 0xD5B5, 0xD5B6, 0xD5B7, 0xD5B8, 0xD5B9,
+	0xD5BA, 0xD5BB, 0xD5BC, 0xD5BD, 0xD5BE, 0xD5BF, 0xD5C0, 0xD5C1,
+	0xD5C2, 0xD5C3, 0xD5C4, 0xD5C5, 0xD5C6, 0xD5C7, 0xC810, 0xC811,
+	0xC813, 0xC815, 0xC816, 0xC81C, 0xC81D, 0xC820, 0xC824, 0xC82C,
+	0xC82D, 0xC82F, 0xC831, 0xC838, 0xC83C, 0xC840, 0xC848, 0xC849,
+	0xC84C, 0xC84D, 0xC854, 0xC870, 0xC871, 0xC874, 0xC878, 0xC87A,
+	0xC880, 0xC881, 0xC883, 0xC885, 0xC886, 0xC887, 0xC88B, 0xC88C,
+	0xC88D, 0xC894, 0xC89D, 0xC89F, 0xC8A1, 0xC8A8, 0xC8BC, 0xC8BD,
+	0xC8C4, 0xC8C8, 0xC8CC, 0xC8D4, 0xC8D5, 0xC8D7, 0xC8D9, 0xC8E0,
+	0xC8E1, 0xC8E4, 0xC8F5, 0xC8FC, 0xC8FD, 0xC900, 0xC904, 0xC905,
+	0xC906, 0xC90C, 0xC90D, 0xC90F, 0xC911, 0xC918, 0xC92C, 0xC934,
+	0xC950, 0xC951, 0xC954, 0xC958, 0xC960, 0xC961, 0xC963, 0xC96C,
+	0xC970, 0xC974, 0xC97C, 0xC988, 0xC989, 0xC98C, 0xC990, 0xC998,
+	0xC999, 0xC99B, 0xC99D, 0xC9C0, 0xC9C1, 0xC9C4, 0xC9C7, 0xC9C8,
+	0xC9CA, 0xC9D0, 0xC9D1, 0xC9D3, 0xD5CA, 0xD5CB, 0xD5CD, 0xD5CE,
+	0xD5CF, 0xD5D1, 0xD5D3, 0xD5D4, 0xD5D5, 0xD5D6, 0xD5D7, 0xD5DA,
+	0xD5DC, 0xD5DE, 0xD5DF, 0xD5E0, 0xD5E1, 0xD5E2, 0xD5E3, 0xD5E6,
+	0xD5E7, 0xD5E9, 0xD5EA, 0xD5EB, 0xD5ED, 0xD5EE, 0xD5EF, 0xD5F0,
+	0xD5F1, 0xD5F2, 0xD5F3, 0xD5F6, 0xD5F8, 0xD5FA, 0xD5FB, 0xD5FC,
+	0xD5FD, 0xD5FE, 0xD5FF, 0xD602, 0xD603, 0xD605, 0xD606, 0xD607,
+	0xD609, 0xD60A, 0xD60B, 0xD60C, 0xD60D, 0xD60E, 0xD60F, 0xD612,
+	0xD616, 0xD617, 0xD618, 0xD619, 0xD61A, 0xD61B, 0xD61D, 0xD61E,
+	0xD61F, 0xD621, 0xD622, 0xD623, 0xD625, 0xD626, 0xD627, 0xD628,
+	0xD629, 0xD62A, 0xD62B, 0xD62C, 0xD62E, 0xD62F, 0xD630, 0xD631,
+	0xD632, 0xD633, 0xD634, 0xD635, 0xD636, 0xD637, 0xD63A, 0xD63B,
+	0xC9D5, 0xC9D6, 0xC9D9, 0xC9DA, 0xC9DC, 0xC9DD, 0xC9E0, 0xC9E2,
+	0xC9E4, 0xC9E7, 0xC9EC, 0xC9ED, 0xC9EF, 0xC9F0, 0xC9F1, 0xC9F8,
+	0xC9F9, 0xC9FC, 0xCA00, 0xCA08, 0xCA09, 0xCA0B, 0xCA0C, 0xCA0D,
+	0xCA14, 0xCA18, 0xCA29, 0xCA4C, 0xCA4D, 0xCA50, 0xCA54, 0xCA5C,
+	0xCA5D, 0xCA5F, 0xCA60, 0xCA61, 0xCA68, 0xCA7D, 0xCA84, 0xCA98,
+	0xCABC, 0xCABD, 0xCAC0, 0xCAC4, 0xCACC, 0xCACD, 0xCACF, 0xCAD1,
+	0xCAD3, 0xCAD8, 0xCAD9, 0xCAE0, 0xCAEC, 0xCAF4, 0xCB08, 0xCB10,
+	0xCB14, 0xCB18, 0xCB20, 0xCB21, 0xCB41, 0xCB48, 0xCB49, 0xCB4C,
+	0xCB50, 0xCB58, 0xCB59, 0xCB5D, 0xCB64, 0xCB78, 0xCB79, 0xCB9C,
+	0xCBB8, 0xCBD4, 0xCBE4, 0xCBE7, 0xCBE9, 0xCC0C, 0xCC0D, 0xCC10,
+	0xCC14, 0xCC1C, 0xCC1D, 0xCC21, 0xCC22, 0xCC27, 0xCC28, 0xCC29,
+	0xCC2C, 0xCC2E, 0xCC30, 0xCC38, 0xCC39, 0xCC3B, 0xD63D, 0xD63E,
+	0xD63F, 0xD641, 0xD642, 0xD643, 0xD644, 0xD646, 0xD647, 0xD64A,
+	0xD64C, 0xD64E, 0xD64F, 0xD650, 0xD652, 0xD653, 0xD656, 0xD657,
+	0xD659, 0xD65A, 0xD65B, 0xD65D, 0xD65E, 0xD65F, 0xD660, 0xD661,
+	0xD662, 0xD663, 0xD664, 0xD665, 0xD666, 0xD668, 0xD66A, 0xD66B,
+	0xD66C, 0xD66D, 0xD66E, 0xD66F, 0xD672, 0xD673, 0xD675, 0xD676,
+	0xD677, 0xD678, 0xD679, 0xD67A, 0xD67B, 0xD67C, 0xD67D, 0xD67E,
+	0xD67F, 0xD680, 0xD681, 0xD682, 0xD684, 0xD686, 0xD687, 0xD688,
+	0xD689, 0xD68A, 0xD68B, 0xD68E, 0xD68F, 0xD691, 0xD692, 0xD693,
+	0xD695, 0xD696, 0xD697, 0xD698, 0xD699, 0xD69A, 0xD69B, 0xD69C,
+	0xD69E, 0xD6A0, 0xD6A2, 0xD6A3, 0xD6A4, 0xD6A5, 0xD6A6, 0xD6A7,
+	0xD6A9, 0xD6AA, 0xCC3C, 0xCC3D, 0xCC3E, 0xCC44, 0xCC45, 0xCC48,
+	0xCC4C, 0xCC54, 0xCC55, 0xCC57, 0xCC58, 0xCC59, 0xCC60, 0xCC64,
+	0xCC66, 0xCC68, 0xCC70, 0xCC75, 0xCC98, 0xCC99, 0xCC9C, 0xCCA0,
+	0xCCA8, 0xCCA9, 0xCCAB, 0xCCAC, 0xCCAD, 0xCCB4, 0xCCB5, 0xCCB8,
+	0xCCBC, 0xCCC4, 0xCCC5, 0xCCC7, 0xCCC9, 0xCCD0, 0xCCD4, 0xCCE4,
+	0xCCEC, 0xCCF0, 0xCD01, 0xCD08, 0xCD09, 0xCD0C, 0xCD10, 0xCD18,
+	0xCD19, 0xCD1B, 0xCD1D, 0xCD24, 0xCD28, 0xCD2C, 0xCD39, 0xCD5C,
+	0xCD60, 0xCD64, 0xCD6C, 0xCD6D, 0xCD6F, 0xCD71, 0xCD78, 0xCD88,
+	0xCD94, 0xCD95, 0xCD98, 0xCD9C, 0xCDA4, 0xCDA5, 0xCDA7, 0xCDA9,
+	0xCDB0, 0xCDC4, 0xCDCC, 0xCDD0, 0xCDE8, 0xCDEC, 0xCDF0, 0xCDF8,
+	0xCDF9, 0xCDFB, 0xCDFD, 0xCE04, 0xCE08, 0xCE0C, 0xCE14, 0xCE19,
+	0xCE20, 0xCE21, 0xCE24, 0xCE28, 0xCE30, 0xCE31, 0xCE33, 0xCE35,
+	0xD6AB, 0xD6AD, 0xD6AE, 0xD6AF, 0xD6B1, 0xD6B2, 0xD6B3, 0xD6B4,
+	0xD6B5, 0xD6B6, 0xD6B7, 0xD6B8, 0xD6BA, 0xD6BC, 0xD6BD, 0xD6BE,
+	0xD6BF, 0xD6C0, 0xD6C1, 0xD6C2, 0xD6C3, 0xD6C6, 0xD6C7, 0xD6C9,
+	0xD6CA, 0xD6CB, 0xD6CD, 0xD6CE, 0xD6CF, 0xD6D0, 0xD6D2, 0xD6D3,
+	0xD6D5, 0xD6D6, 0xD6D8, 0xD6DA, 0xD6DB, 0xD6DC, 0xD6DD, 0xD6DE,
+	0xD6DF, 0xD6E1, 0xD6E2, 0xD6E3, 0xD6E5, 0xD6E6, 0xD6E7, 0xD6E9,
+	0xD6EA, 0xD6EB, 0xD6EC, 0xD6ED, 0xD6EE, 0xD6EF, 0xD6F1, 0xD6F2,
+	0xD6F3, 0xD6F4, 0xD6F6, 0xD6F7, 0xD6F8, 0xD6F9, 0xD6FA, 0xD6FB,
+	0xD6FE, 0xD6FF, 0xD701, 0xD702, 0xD703, 0xD705, 0xD706, 0xD707,
+	0xD708, 0xD709, 0xD70A, 0xD70B, 0xD70C, 0xD70D, 0xD70E, 0xD70F,
+	0xD710, 0xD712, 0xD713, 0xD714, 0xCE58, 0xCE59, 0xCE5C, 0xCE5F,
+	0xCE60, 0xCE61, 0xCE68, 0xCE69, 0xCE6B, 0xCE6D, 0xCE74, 0xCE75,
+	0xCE78, 0xCE7C, 0xCE84, 0xCE85, 0xCE87, 0xCE89, 0xCE90, 0xCE91,
+	0xCE94, 0xCE98, 0xCEA0, 0xCEA1, 0xCEA3, 0xCEA4, 0xCEA5, 0xCEAC,
+	0xCEAD, 0xCEC1, 0xCEE4, 0xCEE5, 0xCEE8, 0xCEEB, 0xCEEC, 0xCEF4,
+	0xCEF5, 0xCEF7, 0xCEF8, 0xCEF9, 0xCF00, 0xCF01, 0xCF04, 0xCF08,
+	0xCF10, 0xCF11, 0xCF13, 0xCF15, 0xCF1C, 0xCF20, 0xCF24, 0xCF2C,
+	0xCF2D, 0xCF2F, 0xCF30, 0xCF31, 0xCF38, 0xCF54, 0xCF55, 0xCF58,
+	0xCF5C, 0xCF64, 0xCF65, 0xCF67, 0xCF69, 0xCF70, 0xCF71, 0xCF74,
+	0xCF78, 0xCF80, 0xCF85, 0xCF8C, 0xCFA1, 0xCFA8, 0xCFB0, 0xCFC4,
+	0xCFE0, 0xCFE1, 0xCFE4, 0xCFE8, 0xCFF0, 0xCFF1, 0xCFF3, 0xCFF5,
+	0xCFFC, 0xD000, 0xD004, 0xD011, 0xD018, 0xD02D, 0xD034, 0xD035,
+	0xD038, 0xD03C, 0xD715, 0xD716, 0xD717, 0xD71A, 0xD71B, 0xD71D,
+	0xD71E, 0xD71F, 0xD721, 0xD722, 0xD723, 0xD724, 0xD725, 0xD726,
+	0xD727, 0xD72A, 0xD72C, 0xD72E, 0xD72F, 0xD730, 0xD731, 0xD732,
+	0xD733, 0xD736, 0xD737, 0xD739, 0xD73A, 0xD73B, 0xD73D, 0xD73E,
+	0xD73F, 0xD740, 0xD741, 0xD742, 0xD743, 0xD745, 0xD746, 0xD748,
+	0xD74A, 0xD74B, 0xD74C, 0xD74D, 0xD74E, 0xD74F, 0xD752, 0xD753,
+	0xD755, 0xD75A, 0xD75B, 0xD75C, 0xD75D, 0xD75E, 0xD75F, 0xD762,
+	0xD764, 0xD766, 0xD767, 0xD768, 0xD76A, 0xD76B, 0xD76D, 0xD76E,
+	0xD76F, 0xD771, 0xD772, 0xD773, 0xD775, 0xD776, 0xD777, 0xD778,
+	0xD779, 0xD77A, 0xD77B, 0xD77E, 0xD77F, 0xD780, 0xD782, 0xD783,
+	0xD784, 0xD785, 0xD786, 0xD787, 0xD78A, 0xD78B, 0xD044, 0xD045,
+	0xD047, 0xD049, 0xD050, 0xD054, 0xD058, 0xD060, 0xD06C, 0xD06D,
+	0xD070, 0xD074, 0xD07C, 0xD07D, 0xD081, 0xD0A4, 0xD0A5, 0xD0A8,
+	0xD0AC, 0xD0B4, 0xD0B5, 0xD0B7, 0xD0B9, 0xD0C0, 0xD0C1, 0xD0C4,
+	0xD0C8, 0xD0C9, 0xD0D0, 0xD0D1, 0xD0D3, 0xD0D4, 0xD0D5, 0xD0DC,
+	0xD0DD, 0xD0E0, 0xD0E4, 0xD0EC, 0xD0ED, 0xD0EF, 0xD0F0, 0xD0F1,
+	0xD0F8, 0xD10D, 0xD130, 0xD131, 0xD134, 0xD138, 0xD13A, 0xD140,
+	0xD141, 0xD143, 0xD144, 0xD145, 0xD14C, 0xD14D, 0xD150, 0xD154,
+	0xD15C, 0xD15D, 0xD15F, 0xD161, 0xD168, 0xD16C, 0xD17C, 0xD184,
+	0xD188, 0xD1A0, 0xD1A1, 0xD1A4, 0xD1A8, 0xD1B0, 0xD1B1, 0xD1B3,
+	0xD1B5, 0xD1BA, 0xD1BC, 0xD1C0, 0xD1D8, 0xD1F4, 0xD1F8, 0xD207,
+	0xD209, 0xD210, 0xD22C, 0xD22D, 0xD230, 0xD234, 0xD23C, 0xD23D,
+	0xD23F, 0xD241, 0xD248, 0xD25C, 0xD78D, 0xD78E, 0xD78F, 0xD791,
+	0xD792, 0xD793, 0xD794, 0xD795, 0xD796, 0xD797, 0xD79A, 0xD79C,
+	0xD79E, 0xD79F, 0xD7A0, 0xD7A1, 0xD7A2, 0xD7A3, 0xD264, 0xD280,
+	0xD281, 0xD284, 0xD288, 0xD290, 0xD291, 0xD295, 0xD29C, 0xD2A0,
+	0xD2A4, 0xD2AC, 0xD2B1, 0xD2B8, 0xD2B9, 0xD2BC, 0xD2BF, 0xD2C0,
+	0xD2C2, 0xD2C8, 0xD2C9, 0xD2CB, 0xD2D4, 0xD2D8, 0xD2DC, 0xD2E4,
+	0xD2E5, 0xD2F0, 0xD2F1, 0xD2F4, 0xD2F8, 0xD300, 0xD301, 0xD303,
+	0xD305, 0xD30C, 0xD30D, 0xD30E, 0xD310, 0xD314, 0xD316, 0xD31C,
+	0xD31D, 0xD31F, 0xD320, 0xD321, 0xD325, 0xD328, 0xD329, 0xD32C,
+	0xD330, 0xD338, 0xD339, 0xD33B, 0xD33C, 0xD33D, 0xD344, 0xD345,
+	0xD37C, 0xD37D, 0xD380, 0xD384, 0xD38C, 0xD38D, 0xD38F, 0xD390,
+	0xD391, 0xD398, 0xD399, 0xD39C, 0xD3A0, 0xD3A8, 0xD3A9, 0xD3AB,
+	0xD3AD, 0xD3B4, 0xD3B8, 0xD3BC, 0xD3C4, 0xD3C5, 0xD3C8, 0xD3C9,
+	0xD3D0, 0xD3D8, 0xD3E1, 0xD3E3, 0xD3EC, 0xD3ED, 0xD3F0, 0xD3F4,
+	0xD3FC, 0xD3FD, 0xD3FF, 0xD401, 0xD408, 0xD41D, 0xD440, 0xD444,
+	0xD45C, 0xD460, 0xD464, 0xD46D, 0xD46F, 0xD478, 0xD479, 0xD47C,
+	0xD47F, 0xD480, 0xD482, 0xD488, 0xD489, 0xD48B, 0xD48D, 0xD494,
+	0xD4A9, 0xD4CC, 0xD4D0, 0xD4D4, 0xD4DC, 0xD4DF, 0xD4E8, 0xD4EC,
+	0xD4F0, 0xD4F8, 0xD4FB, 0xD4FD, 0xD504, 0xD508, 0xD50C, 0xD514,
+	0xD515, 0xD517, 0xD53C, 0xD53D, 0xD540, 0xD544, 0xD54C, 0xD54D,
+	0xD54F, 0xD551, 0xD558, 0xD559, 0xD55C, 0xD560, 0xD565, 0xD568,
+	0xD569, 0xD56B, 0xD56D, 0xD574, 0xD575, 0xD578, 0xD57C, 0xD584,
+	0xD585, 0xD587, 0xD588, 0xD589, 0xD590, 0xD5A5, 0xD5C8, 0xD5C9,
+	0xD5CC, 0xD5D0, 0xD5D2, 0xD5D8, 0xD5D9, 0xD5DB, 0xD5DD, 0xD5E4,
+	0xD5E5, 0xD5E8, 0xD5EC, 0xD5F4, 0xD5F5, 0xD5F7, 0xD5F9, 0xD600,
+	0xD601, 0xD604, 0xD608, 0xD610, 0xD611, 0xD613, 0xD614, 0xD615,
+	0xD61C, 0xD620, 0xD624, 0xD62D, 0xD638, 0xD639, 0xD63C, 0xD640,
+	0xD645, 0xD648, 0xD649, 0xD64B, 0xD64D, 0xD651, 0xD654, 0xD655,
+	0xD658, 0xD65C, 0xD667, 0xD669, 0xD670, 0xD671, 0xD674, 0xD683,
+	0xD685, 0xD68C, 0xD68D, 0xD690, 0xD694, 0xD69D, 0xD69F, 0xD6A1,
+	0xD6A8, 0xD6AC, 0xD6B0, 0xD6B9, 0xD6BB, 0xD6C4, 0xD6C5, 0xD6C8,
+	0xD6CC, 0xD6D1, 0xD6D4, 0xD6D7, 0xD6D9, 0xD6E0, 0xD6E4, 0xD6E8,
+	0xD6F0, 0xD6F5, 0xD6FC, 0xD6FD, 0xD700, 0xD704, 0xD711, 0xD718,
+	0xD719, 0xD71C, 0xD720, 0xD728, 0xD729, 0xD72B, 0xD72D, 0xD734,
+	0xD735, 0xD738, 0xD73C, 0xD744, 0xD747, 0xD749, 0xD750, 0xD751,
+	0xD754, 0xD756, 0xD757, 0xD758, 0xD759, 0xD760, 0xD761, 0xD763,
+	0xD765, 0xD769, 0xD76C, 0xD770, 0xD774, 0xD77C, 0xD77D, 0xD781,
+	0xD788, 0xD789, 0xD78C, 0xD790, 0xD798, 0xD799, 0xD79B, 0xD79D,
+	0x4F3D, 0x4F73, 0x5047, 0x50F9, 0x52A0, 0x53EF, 0x5475, 0x54E5,
+	0x5609, 0x5AC1, 0x5BB6, 0x6687, 0x67B6, 0x67B7, 0x67EF, 0x6B4C,
+	0x73C2, 0x75C2, 0x7A3C, 0x82DB, 0x8304, 0x8857, 0x8888, 0x8A36,
+	0x8CC8, 0x8DCF, 0x8EFB, 0x8FE6, 0x99D5, 0x523B, 0x5374, 0x5404,
+	0x606A, 0x6164, 0x6BBC, 0x73CF, 0x811A, 0x89BA, 0x89D2, 0x95A3,
+	0x4F83, 0x520A, 0x58BE, 0x5978, 0x59E6, 0x5E72, 0x5E79, 0x61C7,
+	0x63C0, 0x6746, 0x67EC, 0x687F, 0x6F97, 0x764E, 0x770B, 0x78F5,
+	0x7A08, 0x7AFF, 0x7C21, 0x809D, 0x826E, 0x8271, 0x8AEB, 0x9593,
+	0x4E6B, 0x559D, 0x66F7, 0x6E34, 0x78A3, 0x7AED, 0x845B, 0x8910,
+	0x874E, 0x97A8, 0x52D8, 0x574E, 0x582A, 0x5D4C, 0x611F, 0x61BE,
+	0x6221, 0x6562, 0x67D1, 0x6A44, 0x6E1B, 0x7518, 0x75B3, 0x76E3,
+	0x77B0, 0x7D3A, 0x90AF, 0x9451, 0x9452, 0x9F95, 0x5323, 0x5CAC,
+	0x7532, 0x80DB, 0x9240, 0x9598, 0x525B, 0x5808, 0x59DC, 0x5CA1,
+	0x5D17, 0x5EB7, 0x5F3A, 0x5F4A, 0x6177, 0x6C5F, 0x757A, 0x7586,
+	0x7CE0, 0x7D73, 0x7DB1, 0x7F8C, 0x8154, 0x8221, 0x8591, 0x8941,
+	0x8B1B, 0x92FC, 0x964D, 0x9C47, 0x4ECB, 0x4EF7, 0x500B, 0x51F1,
+	0x584F, 0x6137, 0x613E, 0x6168, 0x6539, 0x69EA, 0x6F11, 0x75A5,
+	0x7686, 0x76D6, 0x7B87, 0x82A5, 0x84CB, 0xF900, 0x93A7, 0x958B,
+	0x5580, 0x5BA2, 0x5751, 0xF901, 0x7CB3, 0x7FB9, 0x91B5, 0x5028,
+	0x53BB, 0x5C45, 0x5DE8, 0x62D2, 0x636E, 0x64DA, 0x64E7, 0x6E20,
+	0x70AC, 0x795B, 0x8DDD, 0x8E1E, 0xF902, 0x907D, 0x9245, 0x92F8,
+	0x4E7E, 0x4EF6, 0x5065, 0x5DFE, 0x5EFA, 0x6106, 0x6957, 0x8171,
+	0x8654, 0x8E47, 0x9375, 0x9A2B, 0x4E5E, 0x5091, 0x6770, 0x6840,
+	0x5109, 0x528D, 0x5292, 0x6AA2, 0x77BC, 0x9210, 0x9ED4, 0x52AB,
+	0x602F, 0x8FF2, 0x5048, 0x61A9, 0x63ED, 0x64CA, 0x683C, 0x6A84,
+	0x6FC0, 0x8188, 0x89A1, 0x9694, 0x5805, 0x727D, 0x72AC, 0x7504,
+	0x7D79, 0x7E6D, 0x80A9, 0x898B, 0x8B74, 0x9063, 0x9D51, 0x6289,
+	0x6C7A, 0x6F54, 0x7D50, 0x7F3A, 0x8A23, 0x517C, 0x614A, 0x7B9D,
+	0x8B19, 0x9257, 0x938C, 0x4EAC, 0x4FD3, 0x501E, 0x50BE, 0x5106,
+	0x52C1, 0x52CD, 0x537F, 0x5770, 0x5883, 0x5E9A, 0x5F91, 0x6176,
+	0x61AC, 0x64CE, 0x656C, 0x666F, 0x66BB, 0x66F4, 0x6897, 0x6D87,
+	0x7085, 0x70F1, 0x749F, 0x74A5, 0x74CA, 0x75D9, 0x786C, 0x78EC,
+	0x7ADF, 0x7AF6, 0x7D45, 0x7D93, 0x8015, 0x803F, 0x811B, 0x8396,
+	0x8B66, 0x8F15, 0x9015, 0x93E1, 0x9803, 0x9838, 0x9A5A, 0x9BE8,
+	0x4FC2, 0x5553, 0x583A, 0x5951, 0x5B63, 0x5C46, 0x60B8, 0x6212,
+	0x6842, 0x68B0, 0x68E8, 0x6EAA, 0x754C, 0x7678, 0x78CE, 0x7A3D,
+	0x7CFB, 0x7E6B, 0x7E7C, 0x8A08, 0x8AA1, 0x8C3F, 0x968E, 0x9DC4,
+	0x53E4, 0x53E9, 0x544A, 0x5471, 0x56FA, 0x59D1, 0x5B64, 0x5C3B,
+	0x5EAB, 0x62F7, 0x6537, 0x6545, 0x6572, 0x66A0, 0x67AF, 0x69C1,
+	0x6CBD, 0x75FC, 0x7690, 0x777E, 0x7A3F, 0x7F94, 0x8003, 0x80A1,
+	0x818F, 0x82E6, 0x82FD, 0x83F0, 0x85C1, 0x8831, 0x88B4, 0x8AA5,
+	0xF903, 0x8F9C, 0x932E, 0x96C7, 0x9867, 0x9AD8, 0x9F13, 0x54ED,
+	0x659B, 0x66F2, 0x688F, 0x7A40, 0x8C37, 0x9D60, 0x56F0, 0x5764,
+	0x5D11, 0x6606, 0x68B1, 0x68CD, 0x6EFE, 0x7428, 0x889E, 0x9BE4,
+	0x6C68, 0xF904, 0x9AA8, 0x4F9B, 0x516C, 0x5171, 0x529F, 0x5B54,
+	0x5DE5, 0x6050, 0x606D, 0x62F1, 0x63A7, 0x653B, 0x73D9, 0x7A7A,
+	0x86A3, 0x8CA2, 0x978F, 0x4E32, 0x5BE1, 0x6208, 0x679C, 0x74DC,
+	0x79D1, 0x83D3, 0x8A87, 0x8AB2, 0x8DE8, 0x904E, 0x934B, 0x9846,
+	0x5ED3, 0x69E8, 0x85FF, 0x90ED, 0xF905, 0x51A0, 0x5B98, 0x5BEC,
+	0x6163, 0x68FA, 0x6B3E, 0x704C, 0x742F, 0x74D8, 0x7BA1, 0x7F50,
+	0x83C5, 0x89C0, 0x8CAB, 0x95DC, 0x9928, 0x522E, 0x605D, 0x62EC,
+	0x9002, 0x4F8A, 0x5149, 0x5321, 0x58D9, 0x5EE3, 0x66E0, 0x6D38,
+	0x709A, 0x72C2, 0x73D6, 0x7B50, 0x80F1, 0x945B, 0x5366, 0x639B,
+	0x7F6B, 0x4E56, 0x5080, 0x584A, 0x58DE, 0x602A, 0x6127, 0x62D0,
+	0x69D0, 0x9B41, 0x5B8F, 0x7D18, 0x80B1, 0x8F5F, 0x4EA4, 0x50D1,
+	0x54AC, 0x55AC, 0x5B0C, 0x5DA0, 0x5DE7, 0x652A, 0x654E, 0x6821,
+	0x6A4B, 0x72E1, 0x768E, 0x77EF, 0x7D5E, 0x7FF9, 0x81A0, 0x854E,
+	0x86DF, 0x8F03, 0x8F4E, 0x90CA, 0x9903, 0x9A55, 0x9BAB, 0x4E18,
+	0x4E45, 0x4E5D, 0x4EC7, 0x4FF1, 0x5177, 0x52FE, 0x5340, 0x53E3,
+	0x53E5, 0x548E, 0x5614, 0x5775, 0x57A2, 0x5BC7, 0x5D87, 0x5ED0,
+	0x61FC, 0x62D8, 0x6551, 0x67B8, 0x67E9, 0x69CB, 0x6B50, 0x6BC6,
+	0x6BEC, 0x6C42, 0x6E9D, 0x7078, 0x72D7, 0x7396, 0x7403, 0x77BF,
+	0x77E9, 0x7A76, 0x7D7F, 0x8009, 0x81FC, 0x8205, 0x820A, 0x82DF,
+	0x8862, 0x8B33, 0x8CFC, 0x8EC0, 0x9011, 0x90B1, 0x9264, 0x92B6,
+	0x99D2, 0x9A45, 0x9CE9, 0x9DD7, 0x9F9C, 0x570B, 0x5C40, 0x83CA,
+	0x97A0, 0x97AB, 0x9EB4, 0x541B, 0x7A98, 0x7FA4, 0x88D9, 0x8ECD,
+	0x90E1, 0x5800, 0x5C48, 0x6398, 0x7A9F, 0x5BAE, 0x5F13, 0x7A79,
+	0x7AAE, 0x828E, 0x8EAC, 0x5026, 0x5238, 0x52F8, 0x5377, 0x5708,
+	0x62F3, 0x6372, 0x6B0A, 0x6DC3, 0x7737, 0x53A5, 0x7357, 0x8568,
+	0x8E76, 0x95D5, 0x673A, 0x6AC3, 0x6F70, 0x8A6D, 0x8ECC, 0x994B,
+	0xF906, 0x6677, 0x6B78, 0x8CB4, 0x9B3C, 0xF907, 0x53EB, 0x572D,
+	0x594E, 0x63C6, 0x69FB, 0x73EA, 0x7845, 0x7ABA, 0x7AC5, 0x7CFE,
+	0x8475, 0x898F, 0x8D73, 0x9035, 0x95A8, 0x52FB, 0x5747, 0x7547,
+	0x7B60, 0x83CC, 0x921E, 0xF908, 0x6A58, 0x514B, 0x524B, 0x5287,
+	0x621F, 0x68D8, 0x6975, 0x9699, 0x50C5, 0x52A4, 0x52E4, 0x61C3,
+	0x65A4, 0x6839, 0x69FF, 0x747E, 0x7B4B, 0x82B9, 0x83EB, 0x89B2,
+	0x8B39, 0x8FD1, 0x9949, 0xF909, 0x4ECA, 0x5997, 0x64D2, 0x6611,
+	0x6A8E, 0x7434, 0x7981, 0x79BD, 0x82A9, 0x887E, 0x887F, 0x895F,
+	0xF90A, 0x9326, 0x4F0B, 0x53CA, 0x6025, 0x6271, 0x6C72, 0x7D1A,
+	0x7D66, 0x4E98, 0x5162, 0x77DC, 0x80AF, 0x4F01, 0x4F0E, 0x5176,
+	0x5180, 0x55DC, 0x5668, 0x573B, 0x57FA, 0x57FC, 0x5914, 0x5947,
+	0x5993, 0x5BC4, 0x5C90, 0x5D0E, 0x5DF1, 0x5E7E, 0x5FCC, 0x6280,
+	0x65D7, 0x65E3, 0x671E, 0x671F, 0x675E, 0x68CB, 0x68C4, 0x6A5F,
+	0x6B3A, 0x6C23, 0x6C7D, 0x6C82, 0x6DC7, 0x7398, 0x7426, 0x742A,
+	0x7482, 0x74A3, 0x7578, 0x757F, 0x7881, 0x78EF, 0x7941, 0x7947,
+	0x7948, 0x797A, 0x7B95, 0x7D00, 0x7DBA, 0x7F88, 0x8006, 0x802D,
+	0x808C, 0x8A18, 0x8B4F, 0x8C48, 0x8D77, 0x9321, 0x9324, 0x98E2,
+	0x9951, 0x9A0E, 0x9A0F, 0x9A65, 0x9E92, 0x7DCA, 0x4F76, 0x5409,
+	0x62EE, 0x6854, 0x91D1, 0x55AB, 0x513A, 0xF90B, 0xF90C, 0x5A1C,
+	0x61E6, 0xF90D, 0x62CF, 0x62FF, 0xF90E, 0xF90F, 0xF910, 0xF911,
+	0xF912, 0xF913, 0x90A3, 0xF914, 0xF915, 0xF916, 0xF917, 0xF918,
+	0x8AFE, 0xF919, 0xF91A, 0xF91B, 0xF91C, 0x6696, 0xF91D, 0x7156,
+	0xF91E, 0xF91F, 0x96E3, 0xF920, 0x634F, 0x637A, 0x5357, 0xF921,
+	0x678F, 0x6960, 0x6E73, 0xF922, 0x7537, 0xF923, 0xF924, 0xF925,
+	0x7D0D, 0xF926, 0xF927, 0x8872, 0x56CA, 0x5A18, 0xF928, 0xF929,
+	0xF92A, 0xF92B, 0xF92C, 0x4E43, 0xF92D, 0x5167, 0x5948, 0x67F0,
+	0x8010, 0xF92E, 0x5973, 0x5E74, 0x649A, 0x79CA, 0x5FF5, 0x606C,
+	0x62C8, 0x637B, 0x5BE7, 0x5BD7, 0x52AA, 0xF92F, 0x5974, 0x5F29,
+	0x6012, 0xF930, 0xF931, 0xF932, 0x7459, 0xF933, 0xF934, 0xF935,
+	0xF936, 0xF937, 0xF938, 0x99D1, 0xF939, 0xF93A, 0xF93B, 0xF93C,
+	0xF93D, 0xF93E, 0xF93F, 0xF940, 0xF941, 0xF942, 0xF943, 0x6FC3,
+	0xF944, 0xF945, 0x81BF, 0x8FB2, 0x60F1, 0xF946, 0xF947, 0x8166,
+	0xF948, 0xF949, 0x5C3F, 0xF94A, 0xF94B, 0xF94C, 0xF94D, 0xF94E,
+	0xF94F, 0xF950, 0xF951, 0x5AE9, 0x8A25, 0x677B, 0x7D10, 0xF952,
+	0xF953, 0xF954, 0xF955, 0xF956, 0xF957, 0x80FD, 0xF958, 0xF959,
+	0x5C3C, 0x6CE5, 0x533F, 0x6EBA, 0x591A, 0x8336, 0x4E39, 0x4EB6,
+	0x4F46, 0x55AE, 0x5718, 0x58C7, 0x5F56, 0x65B7, 0x65E6, 0x6A80,
+	0x6BB5, 0x6E4D, 0x77ED, 0x7AEF, 0x7C1E, 0x7DDE, 0x86CB, 0x8892,
+	0x9132, 0x935B, 0x64BB, 0x6FBE, 0x737A, 0x75B8, 0x9054, 0x5556,
+	0x574D, 0x61BA, 0x64D4, 0x66C7, 0x6DE1, 0x6E5B, 0x6F6D, 0x6FB9,
+	0x75F0, 0x8043, 0x81BD, 0x8541, 0x8983, 0x8AC7, 0x8B5A, 0x931F,
+	0x6C93, 0x7553, 0x7B54, 0x8E0F, 0x905D, 0x5510, 0x5802, 0x5858,
+	0x5E62, 0x6207, 0x649E, 0x68E0, 0x7576, 0x7CD6, 0x87B3, 0x9EE8,
+	0x4EE3, 0x5788, 0x576E, 0x5927, 0x5C0D, 0x5CB1, 0x5E36, 0x5F85,
+	0x6234, 0x64E1, 0x73B3, 0x81FA, 0x888B, 0x8CB8, 0x968A, 0x9EDB,
+	0x5B85, 0x5FB7, 0x60B3, 0x5012, 0x5200, 0x5230, 0x5716, 0x5835,
+	0x5857, 0x5C0E, 0x5C60, 0x5CF6, 0x5D8B, 0x5EA6, 0x5F92, 0x60BC,
+	0x6311, 0x6389, 0x6417, 0x6843, 0x68F9, 0x6AC2, 0x6DD8, 0x6E21,
+	0x6ED4, 0x6FE4, 0x71FE, 0x76DC, 0x7779, 0x79B1, 0x7A3B, 0x8404,
+	0x89A9, 0x8CED, 0x8DF3, 0x8E48, 0x9003, 0x9014, 0x9053, 0x90FD,
+	0x934D, 0x9676, 0x97DC, 0x6BD2, 0x7006, 0x7258, 0x72A2, 0x7368,
+	0x7763, 0x79BF, 0x7BE4, 0x7E9B, 0x8B80, 0x58A9, 0x60C7, 0x6566,
+	0x65FD, 0x66BE, 0x6C8C, 0x711E, 0x71C9, 0x8C5A, 0x9813, 0x4E6D,
+	0x7A81, 0x4EDD, 0x51AC, 0x51CD, 0x52D5, 0x540C, 0x61A7, 0x6771,
+	0x6850, 0x68DF, 0x6D1E, 0x6F7C, 0x75BC, 0x77B3, 0x7AE5, 0x80F4,
+	0x8463, 0x9285, 0x515C, 0x6597, 0x675C, 0x6793, 0x75D8, 0x7AC7,
+	0x8373, 0xF95A, 0x8C46, 0x9017, 0x982D, 0x5C6F, 0x81C0, 0x829A,
+	0x9041, 0x906F, 0x920D, 0x5F97, 0x5D9D, 0x6A59, 0x71C8, 0x767B,
+	0x7B49, 0x85E4, 0x8B04, 0x9127, 0x9A30, 0x5587, 0x61F6, 0xF95B,
+	0x7669, 0x7F85, 0x863F, 0x87BA, 0x88F8, 0x908F, 0xF95C, 0x6D1B,
+	0x70D9, 0x73DE, 0x7D61, 0x843D, 0xF95D, 0x916A, 0x99F1, 0xF95E,
+	0x4E82, 0x5375, 0x6B04, 0x6B12, 0x703E, 0x721B, 0x862D, 0x9E1E,
+	0x524C, 0x8FA3, 0x5D50, 0x64E5, 0x652C, 0x6B16, 0x6FEB, 0x7C43,
+	0x7E9C, 0x85CD, 0x8964, 0x89BD, 0x62C9, 0x81D8, 0x881F, 0x5ECA,
+	0x6717, 0x6D6A, 0x72FC, 0x7405, 0x746F, 0x8782, 0x90DE, 0x4F86,
+	0x5D0D, 0x5FA0, 0x840A, 0x51B7, 0x63A0, 0x7565, 0x4EAE, 0x5006,
+	0x5169, 0x51C9, 0x6881, 0x6A11, 0x7CAE, 0x7CB1, 0x7CE7, 0x826F,
+	0x8AD2, 0x8F1B, 0x91CF, 0x4FB6, 0x5137, 0x52F5, 0x5442, 0x5EEC,
+	0x616E, 0x623E, 0x65C5, 0x6ADA, 0x6FFE, 0x792A, 0x85DC, 0x8823,
+	0x95AD, 0x9A62, 0x9A6A, 0x9E97, 0x9ECE, 0x529B, 0x66C6, 0x6B77,
+	0x701D, 0x792B, 0x8F62, 0x9742, 0x6190, 0x6200, 0x6523, 0x6F23,
+	0x7149, 0x7489, 0x7DF4, 0x806F, 0x84EE, 0x8F26, 0x9023, 0x934A,
+	0x51BD, 0x5217, 0x52A3, 0x6D0C, 0x70C8, 0x88C2, 0x5EC9, 0x6582,
+	0x6BAE, 0x6FC2, 0x7C3E, 0x7375, 0x4EE4, 0x4F36, 0x56F9, 0xF95F,
+	0x5CBA, 0x5DBA, 0x601C, 0x73B2, 0x7B2D, 0x7F9A, 0x7FCE, 0x8046,
+	0x901E, 0x9234, 0x96F6, 0x9748, 0x9818, 0x9F61, 0x4F8B, 0x6FA7,
+	0x79AE, 0x91B4, 0x96B7, 0x52DE, 0xF960, 0x6488, 0x64C4, 0x6AD3,
+	0x6F5E, 0x7018, 0x7210, 0x76E7, 0x8001, 0x8606, 0x865C, 0x8DEF,
+	0x8F05, 0x9732, 0x9B6F, 0x9DFA, 0x9E75, 0x788C, 0x797F, 0x7DA0,
+	0x83C9, 0x9304, 0x9E7F, 0x9E93, 0x8AD6, 0x58DF, 0x5F04, 0x6727,
+	0x7027, 0x74CF, 0x7C60, 0x807E, 0x5121, 0x7028, 0x7262, 0x78CA,
+	0x8CC2, 0x8CDA, 0x8CF4, 0x96F7, 0x4E86, 0x50DA, 0x5BEE, 0x5ED6,
+	0x6599, 0x71CE, 0x7642, 0x77AD, 0x804A, 0x84FC, 0x907C, 0x9B27,
+	0x9F8D, 0x58D8, 0x5A41, 0x5C62, 0x6A13, 0x6DDA, 0x6F0F, 0x763B,
+	0x7D2F, 0x7E37, 0x851E, 0x8938, 0x93E4, 0x964B, 0x5289, 0x65D2,
+	0x67F3, 0x69B4, 0x6D41, 0x6E9C, 0x700F, 0x7409, 0x7460, 0x7559,
+	0x7624, 0x786B, 0x8B2C, 0x985E, 0x516D, 0x622E, 0x9678, 0x4F96,
+	0x502B, 0x5D19, 0x6DEA, 0x7DB8, 0x8F2A, 0x5F8B, 0x6144, 0x6817,
+	0xF961, 0x9686, 0x52D2, 0x808B, 0x51DC, 0x51CC, 0x695E, 0x7A1C,
+	0x7DBE, 0x83F1, 0x9675, 0x4FDA, 0x5229, 0x5398, 0x540F, 0x550E,
+	0x5C65, 0x60A7, 0x674E, 0x68A8, 0x6D6C, 0x7281, 0x72F8, 0x7406,
+	0x7483, 0xF962, 0x75E2, 0x7C6C, 0x7F79, 0x7FB8, 0x8389, 0x88CF,
+	0x88E1, 0x91CC, 0x91D0, 0x96E2, 0x9BC9, 0x541D, 0x6F7E, 0x71D0,
+	0x7498, 0x85FA, 0x8EAA, 0x96A3, 0x9C57, 0x9E9F, 0x6797, 0x6DCB,
+	0x7433, 0x81E8, 0x9716, 0x782C, 0x7ACB, 0x7B20, 0x7C92, 0x6469,
+	0x746A, 0x75F2, 0x78BC, 0x78E8, 0x99AC, 0x9B54, 0x9EBB, 0x5BDE,
+	0x5E55, 0x6F20, 0x819C, 0x83AB, 0x9088, 0x4E07, 0x534D, 0x5A29,
+	0x5DD2, 0x5F4E, 0x6162, 0x633D, 0x6669, 0x66FC, 0x6EFF, 0x6F2B,
+	0x7063, 0x779E, 0x842C, 0x8513, 0x883B, 0x8F13, 0x9945, 0x9C3B,
+	0x551C, 0x62B9, 0x672B, 0x6CAB, 0x8309, 0x896A, 0x977A, 0x4EA1,
+	0x5984, 0x5FD8, 0x5FD9, 0x671B, 0x7DB2, 0x7F54, 0x8292, 0x832B,
+	0x83BD, 0x8F1E, 0x9099, 0x57CB, 0x59B9, 0x5A92, 0x5BD0, 0x6627,
+	0x679A, 0x6885, 0x6BCF, 0x7164, 0x7F75, 0x8CB7, 0x8CE3, 0x9081,
+	0x9B45, 0x8108, 0x8C8A, 0x964C, 0x9A40, 0x9EA5, 0x5B5F, 0x6C13,
+	0x731B, 0x76F2, 0x76DF, 0x840C, 0x51AA, 0x8993, 0x514D, 0x5195,
+	0x52C9, 0x68C9, 0x6C94, 0x7704, 0x7720, 0x7DBF, 0x7DEC, 0x9762,
+	0x9EB5, 0x6EC5, 0x8511, 0x51A5, 0x540D, 0x547D, 0x660E, 0x669D,
+	0x6927, 0x6E9F, 0x76BF, 0x7791, 0x8317, 0x84C2, 0x879F, 0x9169,
+	0x9298, 0x9CF4, 0x8882, 0x4FAE, 0x5192, 0x52DF, 0x59C6, 0x5E3D,
+	0x6155, 0x6478, 0x6479, 0x66AE, 0x67D0, 0x6A21, 0x6BCD, 0x6BDB,
+	0x725F, 0x7261, 0x7441, 0x7738, 0x77DB, 0x8017, 0x82BC, 0x8305,
+	0x8B00, 0x8B28, 0x8C8C, 0x6728, 0x6C90, 0x7267, 0x76EE, 0x7766,
+	0x7A46, 0x9DA9, 0x6B7F, 0x6C92, 0x5922, 0x6726, 0x8499, 0x536F,
+	0x5893, 0x5999, 0x5EDF, 0x63CF, 0x6634, 0x6773, 0x6E3A, 0x732B,
+	0x7AD7, 0x82D7, 0x9328, 0x52D9, 0x5DEB, 0x61AE, 0x61CB, 0x620A,
+	0x62C7, 0x64AB, 0x65E0, 0x6959, 0x6B66, 0x6BCB, 0x7121, 0x73F7,
+	0x755D, 0x7E46, 0x821E, 0x8302, 0x856A, 0x8AA3, 0x8CBF, 0x9727,
+	0x9D61, 0x58A8, 0x9ED8, 0x5011, 0x520E, 0x543B, 0x554F, 0x6587,
+	0x6C76, 0x7D0A, 0x7D0B, 0x805E, 0x868A, 0x9580, 0x96EF, 0x52FF,
+	0x6C95, 0x7269, 0x5473, 0x5A9A, 0x5C3E, 0x5D4B, 0x5F4C, 0x5FAE,
+	0x672A, 0x68B6, 0x6963, 0x6E3C, 0x6E44, 0x7709, 0x7C73, 0x7F8E,
+	0x8587, 0x8B0E, 0x8FF7, 0x9761, 0x9EF4, 0x5CB7, 0x60B6, 0x610D,
+	0x61AB, 0x654F, 0x65FB, 0x65FC, 0x6C11, 0x6CEF, 0x739F, 0x73C9,
+	0x7DE1, 0x9594, 0x5BC6, 0x871C, 0x8B10, 0x525D, 0x535A, 0x62CD,
+	0x640F, 0x64B2, 0x6734, 0x6A38, 0x6CCA, 0x73C0, 0x749E, 0x7B94,
+	0x7C95, 0x7E1B, 0x818A, 0x8236, 0x8584, 0x8FEB, 0x96F9, 0x99C1,
+	0x4F34, 0x534A, 0x53CD, 0x53DB, 0x62CC, 0x642C, 0x6500, 0x6591,
+	0x69C3, 0x6CEE, 0x6F58, 0x73ED, 0x7554, 0x7622, 0x76E4, 0x76FC,
+	0x78D0, 0x78FB, 0x792C, 0x7D46, 0x822C, 0x87E0, 0x8FD4, 0x9812,
+	0x98EF, 0x52C3, 0x62D4, 0x64A5, 0x6E24, 0x6F51, 0x767C, 0x8DCB,
+	0x91B1, 0x9262, 0x9AEE, 0x9B43, 0x5023, 0x508D, 0x574A, 0x59A8,
+	0x5C28, 0x5E47, 0x5F77, 0x623F, 0x653E, 0x65B9, 0x65C1, 0x6609,
+	0x678B, 0x699C, 0x6EC2, 0x78C5, 0x7D21, 0x80AA, 0x8180, 0x822B,
+	0x82B3, 0x84A1, 0x868C, 0x8A2A, 0x8B17, 0x90A6, 0x9632, 0x9F90,
+	0x500D, 0x4FF3, 0xF963, 0x57F9, 0x5F98, 0x62DC, 0x6392, 0x676F,
+	0x6E43, 0x7119, 0x76C3, 0x80CC, 0x80DA, 0x88F4, 0x88F5, 0x8919,
+	0x8CE0, 0x8F29, 0x914D, 0x966A, 0x4F2F, 0x4F70, 0x5E1B, 0x67CF,
+	0x6822, 0x767D, 0x767E, 0x9B44, 0x5E61, 0x6A0A, 0x7169, 0x71D4,
+	0x756A, 0xF964, 0x7E41, 0x8543, 0x85E9, 0x98DC, 0x4F10, 0x7B4F,
+	0x7F70, 0x95A5, 0x51E1, 0x5E06, 0x68B5, 0x6C3E, 0x6C4E, 0x6CDB,
+	0x72AF, 0x7BC4, 0x8303, 0x6CD5, 0x743A, 0x50FB, 0x5288, 0x58C1,
+	0x64D8, 0x6A97, 0x74A7, 0x7656, 0x78A7, 0x8617, 0x95E2, 0x9739,
+	0xF965, 0x535E, 0x5F01, 0x8B8A, 0x8FA8, 0x8FAF, 0x908A, 0x5225,
+	0x77A5, 0x9C49, 0x9F08, 0x4E19, 0x5002, 0x5175, 0x5C5B, 0x5E77,
+	0x661E, 0x663A, 0x67C4, 0x68C5, 0x70B3, 0x7501, 0x75C5, 0x79C9,
+	0x7ADD, 0x8F27, 0x9920, 0x9A08, 0x4FDD, 0x5821, 0x5831, 0x5BF6,
+	0x666E, 0x6B65, 0x6D11, 0x6E7A, 0x6F7D, 0x73E4, 0x752B, 0x83E9,
+	0x88DC, 0x8913, 0x8B5C, 0x8F14, 0x4F0F, 0x50D5, 0x5310, 0x535C,
+	0x5B93, 0x5FA9, 0x670D, 0x798F, 0x8179, 0x832F, 0x8514, 0x8907,
+	0x8986, 0x8F39, 0x8F3B, 0x99A5, 0x9C12, 0x672C, 0x4E76, 0x4FF8,
+	0x5949, 0x5C01, 0x5CEF, 0x5CF0, 0x6367, 0x68D2, 0x70FD, 0x71A2,
+	0x742B, 0x7E2B, 0x84EC, 0x8702, 0x9022, 0x92D2, 0x9CF3, 0x4E0D,
+	0x4ED8, 0x4FEF, 0x5085, 0x5256, 0x526F, 0x5426, 0x5490, 0x57E0,
+	0x592B, 0x5A66, 0x5B5A, 0x5B75, 0x5BCC, 0x5E9C, 0xF966, 0x6276,
+	0x6577, 0x65A7, 0x6D6E, 0x6EA5, 0x7236, 0x7B26, 0x7C3F, 0x7F36,
+	0x8150, 0x8151, 0x819A, 0x8240, 0x8299, 0x83A9, 0x8A03, 0x8CA0,
+	0x8CE6, 0x8CFB, 0x8D74, 0x8DBA, 0x90E8, 0x91DC, 0x961C, 0x9644,
+	0x99D9, 0x9CE7, 0x5317, 0x5206, 0x5429, 0x5674, 0x58B3, 0x5954,
+	0x596E, 0x5FFF, 0x61A4, 0x626E, 0x6610, 0x6C7E, 0x711A, 0x76C6,
+	0x7C89, 0x7CDE, 0x7D1B, 0x82AC, 0x8CC1, 0x96F0, 0xF967, 0x4F5B,
+	0x5F17, 0x5F7F, 0x62C2, 0x5D29, 0x670B, 0x68DA, 0x787C, 0x7E43,
+	0x9D6C, 0x4E15, 0x5099, 0x5315, 0x532A, 0x5351, 0x5983, 0x5A62,
+	0x5E87, 0x60B2, 0x618A, 0x6249, 0x6279, 0x6590, 0x6787, 0x69A7,
+	0x6BD4, 0x6BD6, 0x6BD7, 0x6BD8, 0x6CB8, 0xF968, 0x7435, 0x75FA,
+	0x7812, 0x7891, 0x79D5, 0x79D8, 0x7C83, 0x7DCB, 0x7FE1, 0x80A5,
+	0x813E, 0x81C2, 0x83F2, 0x871A, 0x88E8, 0x8AB9, 0x8B6C, 0x8CBB,
+	0x9119, 0x975E, 0x98DB, 0x9F3B, 0x56AC, 0x5B2A, 0x5F6C, 0x658C,
+	0x6AB3, 0x6BAF, 0x6D5C, 0x6FF1, 0x7015, 0x725D, 0x73AD, 0x8CA7,
+	0x8CD3, 0x983B, 0x6191, 0x6C37, 0x8058, 0x9A01, 0x4E4D, 0x4E8B,
+	0x4E9B, 0x4ED5, 0x4F3A, 0x4F3C, 0x4F7F, 0x4FDF, 0x50FF, 0x53F2,
+	0x53F8, 0x5506, 0x55E3, 0x56DB, 0x58EB, 0x5962, 0x5A11, 0x5BEB,
+	0x5BFA, 0x5C04, 0x5DF3, 0x5E2B, 0x5F99, 0x601D, 0x6368, 0x659C,
+	0x65AF, 0x67F6, 0x67FB, 0x68AD, 0x6B7B, 0x6C99, 0x6CD7, 0x6E23,
+	0x7009, 0x7345, 0x7802, 0x793E, 0x7940, 0x7960, 0x79C1, 0x7BE9,
+	0x7D17, 0x7D72, 0x8086, 0x820D, 0x838E, 0x84D1, 0x86C7, 0x88DF,
+	0x8A50, 0x8A5E, 0x8B1D, 0x8CDC, 0x8D66, 0x8FAD, 0x90AA, 0x98FC,
+	0x99DF, 0x9E9D, 0x524A, 0xF969, 0x6714, 0xF96A, 0x5098, 0x522A,
+	0x5C71, 0x6563, 0x6C55, 0x73CA, 0x7523, 0x759D, 0x7B97, 0x849C,
+	0x9178, 0x9730, 0x4E77, 0x6492, 0x6BBA, 0x715E, 0x85A9, 0x4E09,
+	0xF96B, 0x6749, 0x68EE, 0x6E17, 0x829F, 0x8518, 0x886B, 0x63F7,
+	0x6F81, 0x9212, 0x98AF, 0x4E0A, 0x50B7, 0x50CF, 0x511F, 0x5546,
+	0x55AA, 0x5617, 0x5B40, 0x5C19, 0x5CE0, 0x5E38, 0x5E8A, 0x5EA0,
+	0x5EC2, 0x60F3, 0x6851, 0x6A61, 0x6E58, 0x723D, 0x7240, 0x72C0,
+	0x76F8, 0x7965, 0x7BB1, 0x7FD4, 0x88F3, 0x89F4, 0x8A73, 0x8C61,
+	0x8CDE, 0x971C, 0x585E, 0x74BD, 0x8CFD, 0x55C7, 0xF96C, 0x7A61,
+	0x7D22, 0x8272, 0x7272, 0x751F, 0x7525, 0xF96D, 0x7B19, 0x5885,
+	0x58FB, 0x5DBC, 0x5E8F, 0x5EB6, 0x5F90, 0x6055, 0x6292, 0x637F,
+	0x654D, 0x6691, 0x66D9, 0x66F8, 0x6816, 0x68F2, 0x7280, 0x745E,
+	0x7B6E, 0x7D6E, 0x7DD6, 0x7F72, 0x80E5, 0x8212, 0x85AF, 0x897F,
+	0x8A93, 0x901D, 0x92E4, 0x9ECD, 0x9F20, 0x5915, 0x596D, 0x5E2D,
+	0x60DC, 0x6614, 0x6673, 0x6790, 0x6C50, 0x6DC5, 0x6F5F, 0x77F3,
+	0x78A9, 0x84C6, 0x91CB, 0x932B, 0x4ED9, 0x50CA, 0x5148, 0x5584,
+	0x5B0B, 0x5BA3, 0x6247, 0x657E, 0x65CB, 0x6E32, 0x717D, 0x7401,
+	0x7444, 0x7487, 0x74BF, 0x766C, 0x79AA, 0x7DDA, 0x7E55, 0x7FA8,
+	0x817A, 0x81B3, 0x8239, 0x861A, 0x87EC, 0x8A75, 0x8DE3, 0x9078,
+	0x9291, 0x9425, 0x994D, 0x9BAE, 0x5368, 0x5C51, 0x6954, 0x6CC4,
+	0x6D29, 0x6E2B, 0x820C, 0x859B, 0x893B, 0x8A2D, 0x8AAA, 0x96EA,
+	0x9F67, 0x5261, 0x66B9, 0x6BB2, 0x7E96, 0x87FE, 0x8D0D, 0x9583,
+	0x965D, 0x651D, 0x6D89, 0x71EE, 0xF96E, 0x57CE, 0x59D3, 0x5BAC,
+	0x6027, 0x60FA, 0x6210, 0x661F, 0x665F, 0x7329, 0x73F9, 0x76DB,
+	0x7701, 0x7B6C, 0x8056, 0x8072, 0x8165, 0x8AA0, 0x9192, 0x4E16,
+	0x52E2, 0x6B72, 0x6D17, 0x7A05, 0x7B39, 0x7D30, 0xF96F, 0x8CB0,
+	0x53EC, 0x562F, 0x5851, 0x5BB5, 0x5C0F, 0x5C11, 0x5DE2, 0x6240,
+	0x6383, 0x6414, 0x662D, 0x68B3, 0x6CBC, 0x6D88, 0x6EAF, 0x701F,
+	0x70A4, 0x71D2, 0x7526, 0x758F, 0x758E, 0x7619, 0x7B11, 0x7BE0,
+	0x7C2B, 0x7D20, 0x7D39, 0x852C, 0x856D, 0x8607, 0x8A34, 0x900D,
+	0x9061, 0x90B5, 0x92B7, 0x97F6, 0x9A37, 0x4FD7, 0x5C6C, 0x675F,
+	0x6D91, 0x7C9F, 0x7E8C, 0x8B16, 0x8D16, 0x901F, 0x5B6B, 0x5DFD,
+	0x640D, 0x84C0, 0x905C, 0x98E1, 0x7387, 0x5B8B, 0x609A, 0x677E,
+	0x6DDE, 0x8A1F, 0x8AA6, 0x9001, 0x980C, 0x5237, 0xF970, 0x7051,
+	0x788E, 0x9396, 0x8870, 0x91D7, 0x4FEE, 0x53D7, 0x55FD, 0x56DA,
+	0x5782, 0x58FD, 0x5AC2, 0x5B88, 0x5CAB, 0x5CC0, 0x5E25, 0x6101,
+	0x620D, 0x624B, 0x6388, 0x641C, 0x6536, 0x6578, 0x6A39, 0x6B8A,
+	0x6C34, 0x6D19, 0x6F31, 0x71E7, 0x72E9, 0x7378, 0x7407, 0x74B2,
+	0x7626, 0x7761, 0x79C0, 0x7A57, 0x7AEA, 0x7CB9, 0x7D8F, 0x7DAC,
+	0x7E61, 0x7F9E, 0x8129, 0x8331, 0x8490, 0x84DA, 0x85EA, 0x8896,
+	0x8AB0, 0x8B90, 0x8F38, 0x9042, 0x9083, 0x916C, 0x9296, 0x92B9,
+	0x968B, 0x96A7, 0x96A8, 0x96D6, 0x9700, 0x9808, 0x9996, 0x9AD3,
+	0x9B1A, 0x53D4, 0x587E, 0x5919, 0x5B70, 0x5BBF, 0x6DD1, 0x6F5A,
+	0x719F, 0x7421, 0x74B9, 0x8085, 0x83FD, 0x5DE1, 0x5F87, 0x5FAA,
+	0x6042, 0x65EC, 0x6812, 0x696F, 0x6A53, 0x6B89, 0x6D35, 0x6DF3,
+	0x73E3, 0x76FE, 0x77AC, 0x7B4D, 0x7D14, 0x8123, 0x821C, 0x8340,
+	0x84F4, 0x8563, 0x8A62, 0x8AC4, 0x9187, 0x931E, 0x9806, 0x99B4,
+	0x620C, 0x8853, 0x8FF0, 0x9265, 0x5D07, 0x5D27, 0x5D69, 0x745F,
+	0x819D, 0x8768, 0x6FD5, 0x62FE, 0x7FD2, 0x8936, 0x8972, 0x4E1E,
+	0x4E58, 0x50E7, 0x52DD, 0x5347, 0x627F, 0x6607, 0x7E69, 0x8805,
+	0x965E, 0x4F8D, 0x5319, 0x5636, 0x59CB, 0x5AA4, 0x5C38, 0x5C4E,
+	0x5C4D, 0x5E02, 0x5F11, 0x6043, 0x65BD, 0x662F, 0x6642, 0x67BE,
+	0x67F4, 0x731C, 0x77E2, 0x793A, 0x7FC5, 0x8494, 0x84CD, 0x8996,
+	0x8A66, 0x8A69, 0x8AE1, 0x8C55, 0x8C7A, 0x57F4, 0x5BD4, 0x5F0F,
+	0x606F, 0x62ED, 0x690D, 0x6B96, 0x6E5C, 0x7184, 0x7BD2, 0x8755,
+	0x8B58, 0x8EFE, 0x98DF, 0x98FE, 0x4F38, 0x4F81, 0x4FE1, 0x547B,
+	0x5A20, 0x5BB8, 0x613C, 0x65B0, 0x6668, 0x71FC, 0x7533, 0x795E,
+	0x7D33, 0x814E, 0x81E3, 0x8398, 0x85AA, 0x85CE, 0x8703, 0x8A0A,
+	0x8EAB, 0x8F9B, 0xF971, 0x8FC5, 0x5931, 0x5BA4, 0x5BE6, 0x6089,
+	0x5BE9, 0x5C0B, 0x5FC3, 0x6C81, 0xF972, 0x6DF1, 0x700B, 0x751A,
+	0x82AF, 0x8AF6, 0x4EC0, 0x5341, 0xF973, 0x96D9, 0x6C0F, 0x4E9E,
+	0x4FC4, 0x5152, 0x555E, 0x5A25, 0x5CE8, 0x6211, 0x7259, 0x82BD,
+	0x83AA, 0x86FE, 0x8859, 0x8A1D, 0x963F, 0x96C5, 0x9913, 0x9D09,
+	0x9D5D, 0x580A, 0x5CB3, 0x5DBD, 0x5E44, 0x60E1, 0x6115, 0x63E1,
+	0x6A02, 0x6E25, 0x9102, 0x9354, 0x984E, 0x9C10, 0x9F77, 0x5B89,
+	0x5CB8, 0x6309, 0x664F, 0x6848, 0x773C, 0x96C1, 0x978D, 0x9854,
+	0x9B9F, 0x65A1, 0x8B01, 0x8ECB, 0x95BC, 0x5535, 0x5CA9, 0x5DD6,
+	0x5EB5, 0x6697, 0x764C, 0x83F4, 0x95C7, 0x58D3, 0x62BC, 0x72CE,
+	0x9D28, 0x4EF0, 0x592E, 0x600F, 0x663B, 0x6B83, 0x79E7, 0x9D26,
+	0x5393, 0x54C0, 0x57C3, 0x5D16, 0x611B, 0x66D6, 0x6DAF, 0x788D,
+	0x827E, 0x9698, 0x9744, 0x5384, 0x627C, 0x6396, 0x6DB2, 0x7E0A,
+	0x814B, 0x984D, 0x6AFB, 0x7F4C, 0x9DAF, 0x9E1A, 0x4E5F, 0x503B,
+	0x51B6, 0x591C, 0x60F9, 0x63F6, 0x6930, 0x723A, 0x8036, 0xF974,
+	0x91CE, 0x5F31, 0xF975, 0xF976, 0x7D04, 0x82E5, 0x846F, 0x84BB,
+	0x85E5, 0x8E8D, 0xF977, 0x4F6F, 0xF978, 0xF979, 0x58E4, 0x5B43,
+	0x6059, 0x63DA, 0x6518, 0x656D, 0x6698, 0xF97A, 0x694A, 0x6A23,
+	0x6D0B, 0x7001, 0x716C, 0x75D2, 0x760D, 0x79B3, 0x7A70, 0xF97B,
+	0x7F8A, 0xF97C, 0x8944, 0xF97D, 0x8B93, 0x91C0, 0x967D, 0xF97E,
+	0x990A, 0x5704, 0x5FA1, 0x65BC, 0x6F01, 0x7600, 0x79A6, 0x8A9E,
+	0x99AD, 0x9B5A, 0x9F6C, 0x5104, 0x61B6, 0x6291, 0x6A8D, 0x81C6,
+	0x5043, 0x5830, 0x5F66, 0x7109, 0x8A00, 0x8AFA, 0x5B7C, 0x8616,
+	0x4FFA, 0x513C, 0x56B4, 0x5944, 0x63A9, 0x6DF9, 0x5DAA, 0x696D,
+	0x5186, 0x4E88, 0x4F59, 0xF97F, 0xF980, 0xF981, 0x5982, 0xF982,
+	0xF983, 0x6B5F, 0x6C5D, 0xF984, 0x74B5, 0x7916, 0xF985, 0x8207,
+	0x8245, 0x8339, 0x8F3F, 0x8F5D, 0xF986, 0x9918, 0xF987, 0xF988,
+	0xF989, 0x4EA6, 0xF98A, 0x57DF, 0x5F79, 0x6613, 0xF98B, 0xF98C,
+	0x75AB, 0x7E79, 0x8B6F, 0xF98D, 0x9006, 0x9A5B, 0x56A5, 0x5827,
+	0x59F8, 0x5A1F, 0x5BB4, 0xF98E, 0x5EF6, 0xF98F, 0xF990, 0x6350,
+	0x633B, 0xF991, 0x693D, 0x6C87, 0x6CBF, 0x6D8E, 0x6D93, 0x6DF5,
+	0x6F14, 0xF992, 0x70DF, 0x7136, 0x7159, 0xF993, 0x71C3, 0x71D5,
+	0xF994, 0x784F, 0x786F, 0xF995, 0x7B75, 0x7DE3, 0xF996, 0x7E2F,
+	0xF997, 0x884D, 0x8EDF, 0xF998, 0xF999, 0xF99A, 0x925B, 0xF99B,
+	0x9CF6, 0xF99C, 0xF99D, 0xF99E, 0x6085, 0x6D85, 0xF99F, 0x71B1,
+	0xF9A0, 0xF9A1, 0x95B1, 0x53AD, 0xF9A2, 0xF9A3, 0xF9A4, 0x67D3,
+	0xF9A5, 0x708E, 0x7130, 0x7430, 0x8276, 0x82D2, 0xF9A6, 0x95BB,
+	0x9AE5, 0x9E7D, 0x66C4, 0xF9A7, 0x71C1, 0x8449, 0xF9A8, 0xF9A9,
+	0x584B, 0xF9AA, 0xF9AB, 0x5DB8, 0x5F71, 0xF9AC, 0x6620, 0x668E,
+	0x6979, 0x69AE, 0x6C38, 0x6CF3, 0x6E36, 0x6F41, 0x6FDA, 0x701B,
+	0x702F, 0x7150, 0x71DF, 0x7370, 0xF9AD, 0x745B, 0xF9AE, 0x74D4,
+	0x76C8, 0x7A4E, 0x7E93, 0xF9AF, 0xF9B0, 0x82F1, 0x8A60, 0x8FCE,
+	0xF9B1, 0x9348, 0xF9B2, 0x9719, 0xF9B3, 0xF9B4, 0x4E42, 0x502A,
+	0xF9B5, 0x5208, 0x53E1, 0x66F3, 0x6C6D, 0x6FCA, 0x730A, 0x777F,
+	0x7A62, 0x82AE, 0x85DD, 0x8602, 0xF9B6, 0x88D4, 0x8A63, 0x8B7D,
+	0x8C6B, 0xF9B7, 0x92B3, 0xF9B8, 0x9713, 0x9810, 0x4E94, 0x4F0D,
+	0x4FC9, 0x50B2, 0x5348, 0x543E, 0x5433, 0x55DA, 0x5862, 0x58BA,
+	0x5967, 0x5A1B, 0x5BE4, 0x609F, 0xF9B9, 0x61CA, 0x6556, 0x65FF,
+	0x6664, 0x68A7, 0x6C5A, 0x6FB3, 0x70CF, 0x71AC, 0x7352, 0x7B7D,
+	0x8708, 0x8AA4, 0x9C32, 0x9F07, 0x5C4B, 0x6C83, 0x7344, 0x7389,
+	0x923A, 0x6EAB, 0x7465, 0x761F, 0x7A69, 0x7E15, 0x860A, 0x5140,
+	0x58C5, 0x64C1, 0x74EE, 0x7515, 0x7670, 0x7FC1, 0x9095, 0x96CD,
+	0x9954, 0x6E26, 0x74E6, 0x7AA9, 0x7AAA, 0x81E5, 0x86D9, 0x8778,
+	0x8A1B, 0x5A49, 0x5B8C, 0x5B9B, 0x68A1, 0x6900, 0x6D63, 0x73A9,
+	0x7413, 0x742C, 0x7897, 0x7DE9, 0x7FEB, 0x8118, 0x8155, 0x839E,
+	0x8C4C, 0x962E, 0x9811, 0x66F0, 0x5F80, 0x65FA, 0x6789, 0x6C6A,
+	0x738B, 0x502D, 0x5A03, 0x6B6A, 0x77EE, 0x5916, 0x5D6C, 0x5DCD,
+	0x7325, 0x754F, 0xF9BA, 0xF9BB, 0x50E5, 0x51F9, 0x582F, 0x592D,
+	0x5996, 0x59DA, 0x5BE5, 0xF9BC, 0xF9BD, 0x5DA2, 0x62D7, 0x6416,
+	0x6493, 0x64FE, 0xF9BE, 0x66DC, 0xF9BF, 0x6A48, 0xF9C0, 0x71FF,
+	0x7464, 0xF9C1, 0x7A88, 0x7AAF, 0x7E47, 0x7E5E, 0x8000, 0x8170,
+	0xF9C2, 0x87EF, 0x8981, 0x8B20, 0x9059, 0xF9C3, 0x9080, 0x9952,
+	0x617E, 0x6B32, 0x6D74, 0x7E1F, 0x8925, 0x8FB1, 0x4FD1, 0x50AD,
+	0x5197, 0x52C7, 0x57C7, 0x5889, 0x5BB9, 0x5EB8, 0x6142, 0x6995,
+	0x6D8C, 0x6E67, 0x6EB6, 0x7194, 0x7462, 0x7528, 0x752C, 0x8073,
+	0x8338, 0x84C9, 0x8E0A, 0x9394, 0x93DE, 0xF9C4, 0x4E8E, 0x4F51,
+	0x5076, 0x512A, 0x53C8, 0x53CB, 0x53F3, 0x5B87, 0x5BD3, 0x5C24,
+	0x611A, 0x6182, 0x65F4, 0x725B, 0x7397, 0x7440, 0x76C2, 0x7950,
+	0x7991, 0x79B9, 0x7D06, 0x7FBD, 0x828B, 0x85D5, 0x865E, 0x8FC2,
+	0x9047, 0x90F5, 0x91EA, 0x9685, 0x96E8, 0x96E9, 0x52D6, 0x5F67,
+	0x65ED, 0x6631, 0x682F, 0x715C, 0x7A36, 0x90C1, 0x980A, 0x4E91,
+	0xF9C5, 0x6A52, 0x6B9E, 0x6F90, 0x7189, 0x8018, 0x82B8, 0x8553,
+	0x904B, 0x9695, 0x96F2, 0x97FB, 0x851A, 0x9B31, 0x4E90, 0x718A,
+	0x96C4, 0x5143, 0x539F, 0x54E1, 0x5713, 0x5712, 0x57A3, 0x5A9B,
+	0x5AC4, 0x5BC3, 0x6028, 0x613F, 0x63F4, 0x6C85, 0x6D39, 0x6E72,
+	0x6E90, 0x7230, 0x733F, 0x7457, 0x82D1, 0x8881, 0x8F45, 0x9060,
+	0xF9C6, 0x9662, 0x9858, 0x9D1B, 0x6708, 0x8D8A, 0x925E, 0x4F4D,
+	0x5049, 0x50DE, 0x5371, 0x570D, 0x59D4, 0x5A01, 0x5C09, 0x6170,
+	0x6690, 0x6E2D, 0x7232, 0x744B, 0x7DEF, 0x80C3, 0x840E, 0x8466,
+	0x853F, 0x875F, 0x885B, 0x8918, 0x8B02, 0x9055, 0x97CB, 0x9B4F,
+	0x4E73, 0x4F91, 0x5112, 0x516A, 0xF9C7, 0x552F, 0x55A9, 0x5B7A,
+	0x5BA5, 0x5E7C, 0x5E7D, 0x5EBE, 0x60A0, 0x60DF, 0x6108, 0x6109,
+	0x63C4, 0x6538, 0x6709, 0xF9C8, 0x67D4, 0x67DA, 0xF9C9, 0x6961,
+	0x6962, 0x6CB9, 0x6D27, 0xF9CA, 0x6E38, 0xF9CB, 0x6FE1, 0x7336,
+	0x7337, 0xF9CC, 0x745C, 0x7531, 0xF9CD, 0x7652, 0xF9CE, 0xF9CF,
+	0x7DAD, 0x81FE, 0x8438, 0x88D5, 0x8A98, 0x8ADB, 0x8AED, 0x8E30,
+	0x8E42, 0x904A, 0x903E, 0x907A, 0x9149, 0x91C9, 0x936E, 0xF9D0,
+	0xF9D1, 0x5809, 0xF9D2, 0x6BD3, 0x8089, 0x80B2, 0xF9D3, 0xF9D4,
+	0x5141, 0x596B, 0x5C39, 0xF9D5, 0xF9D6, 0x6F64, 0x73A7, 0x80E4,
+	0x8D07, 0xF9D7, 0x9217, 0x958F, 0xF9D8, 0xF9D9, 0xF9DA, 0xF9DB,
+	0x807F, 0x620E, 0x701C, 0x7D68, 0x878D, 0xF9DC, 0x57A0, 0x6069,
+	0x6147, 0x6BB7, 0x8ABE, 0x9280, 0x96B1, 0x4E59, 0x541F, 0x6DEB,
+	0x852D, 0x9670, 0x97F3, 0x98EE, 0x63D6, 0x6CE3, 0x9091, 0x51DD,
+	0x61C9, 0x81BA, 0x9DF9, 0x4F9D, 0x501A, 0x5100, 0x5B9C, 0x610F,
+	0x61FF, 0x64EC, 0x6905, 0x6BC5, 0x7591, 0x77E3, 0x7FA9, 0x8264,
+	0x858F, 0x87FB, 0x8863, 0x8ABC, 0x8B70, 0x91AB, 0x4E8C, 0x4EE5,
+	0x4F0A, 0xF9DD, 0xF9DE, 0x5937, 0x59E8, 0xF9DF, 0x5DF2, 0x5F1B,
+	0x5F5B, 0x6021, 0xF9E0, 0xF9E1, 0xF9E2, 0xF9E3, 0x723E, 0x73E5,
+	0xF9E4, 0x7570, 0x75CD, 0xF9E5, 0x79FB, 0xF9E6, 0x800C, 0x8033,
+	0x8084, 0x82E1, 0x8351, 0xF9E7, 0xF9E8, 0x8CBD, 0x8CB3, 0x9087,
+	0xF9E9, 0xF9EA, 0x98F4, 0x990C, 0xF9EB, 0xF9EC, 0x7037, 0x76CA,
+	0x7FCA, 0x7FCC, 0x7FFC, 0x8B1A, 0x4EBA, 0x4EC1, 0x5203, 0x5370,
+	0xF9ED, 0x54BD, 0x56E0, 0x59FB, 0x5BC5, 0x5F15, 0x5FCD, 0x6E6E,
+	0xF9EE, 0xF9EF, 0x7D6A, 0x8335, 0xF9F0, 0x8693, 0x8A8D, 0xF9F1,
+	0x976D, 0x9777, 0xF9F2, 0xF9F3, 0x4E00, 0x4F5A, 0x4F7E, 0x58F9,
+	0x65E5, 0x6EA2, 0x9038, 0x93B0, 0x99B9, 0x4EFB, 0x58EC, 0x598A,
+	0x59D9, 0x6041, 0xF9F4, 0xF9F5, 0x7A14, 0xF9F6, 0x834F, 0x8CC3,
+	0x5165, 0x5344, 0xF9F7, 0xF9F8, 0xF9F9, 0x4ECD, 0x5269, 0x5B55,
+	0x82BF, 0x4ED4, 0x523A, 0x54A8, 0x59C9, 0x59FF, 0x5B50, 0x5B57,
+	0x5B5C, 0x6063, 0x6148, 0x6ECB, 0x7099, 0x716E, 0x7386, 0x74F7,
+	0x75B5, 0x78C1, 0x7D2B, 0x8005, 0x81EA, 0x8328, 0x8517, 0x85C9,
+	0x8AEE, 0x8CC7, 0x96CC, 0x4F5C, 0x52FA, 0x56BC, 0x65AB, 0x6628,
+	0x707C, 0x70B8, 0x7235, 0x7DBD, 0x828D, 0x914C, 0x96C0, 0x9D72,
+	0x5B71, 0x68E7, 0x6B98, 0x6F7A, 0x76DE, 0x5C91, 0x66AB, 0x6F5B,
+	0x7BB4, 0x7C2A, 0x8836, 0x96DC, 0x4E08, 0x4ED7, 0x5320, 0x5834,
+	0x58BB, 0x58EF, 0x596C, 0x5C07, 0x5E33, 0x5E84, 0x5F35, 0x638C,
+	0x66B2, 0x6756, 0x6A1F, 0x6AA3, 0x6B0C, 0x6F3F, 0x7246, 0xF9FA,
+	0x7350, 0x748B, 0x7AE0, 0x7CA7, 0x8178, 0x81DF, 0x81E7, 0x838A,
+	0x846C, 0x8523, 0x8594, 0x85CF, 0x88DD, 0x8D13, 0x91AC, 0x9577,
+	0x969C, 0x518D, 0x54C9, 0x5728, 0x5BB0, 0x624D, 0x6750, 0x683D,
+	0x6893, 0x6E3D, 0x6ED3, 0x707D, 0x7E21, 0x88C1, 0x8CA1, 0x8F09,
+	0x9F4B, 0x9F4E, 0x722D, 0x7B8F, 0x8ACD, 0x931A, 0x4F47, 0x4F4E,
+	0x5132, 0x5480, 0x59D0, 0x5E95, 0x62B5, 0x6775, 0x696E, 0x6A17,
+	0x6CAE, 0x6E1A, 0x72D9, 0x732A, 0x75BD, 0x7BB8, 0x7D35, 0x82E7,
+	0x83F9, 0x8457, 0x85F7, 0x8A5B, 0x8CAF, 0x8E87, 0x9019, 0x90B8,
+	0x96CE, 0x9F5F, 0x52E3, 0x540A, 0x5AE1, 0x5BC2, 0x6458, 0x6575,
+	0x6EF4, 0x72C4, 0xF9FB, 0x7684, 0x7A4D, 0x7B1B, 0x7C4D, 0x7E3E,
+	0x7FDF, 0x837B, 0x8B2B, 0x8CCA, 0x8D64, 0x8DE1, 0x8E5F, 0x8FEA,
+	0x8FF9, 0x9069, 0x93D1, 0x4F43, 0x4F7A, 0x50B3, 0x5168, 0x5178,
+	0x524D, 0x526A, 0x5861, 0x587C, 0x5960, 0x5C08, 0x5C55, 0x5EDB,
+	0x609B, 0x6230, 0x6813, 0x6BBF, 0x6C08, 0x6FB1, 0x714E, 0x7420,
+	0x7530, 0x7538, 0x7551, 0x7672, 0x7B4C, 0x7B8B, 0x7BAD, 0x7BC6,
+	0x7E8F, 0x8A6E, 0x8F3E, 0x8F49, 0x923F, 0x9293, 0x9322, 0x942B,
+	0x96FB, 0x985A, 0x986B, 0x991E, 0x5207, 0x622A, 0x6298, 0x6D59,
+	0x7664, 0x7ACA, 0x7BC0, 0x7D76, 0x5360, 0x5CBE, 0x5E97, 0x6F38,
+	0x70B9, 0x7C98, 0x9711, 0x9B8E, 0x9EDE, 0x63A5, 0x647A, 0x8776,
+	0x4E01, 0x4E95, 0x4EAD, 0x505C, 0x5075, 0x5448, 0x59C3, 0x5B9A,
+	0x5E40, 0x5EAD, 0x5EF7, 0x5F81, 0x60C5, 0x633A, 0x653F, 0x6574,
+	0x65CC, 0x6676, 0x6678, 0x67FE, 0x6968, 0x6A89, 0x6B63, 0x6C40,
+	0x6DC0, 0x6DE8, 0x6E1F, 0x6E5E, 0x701E, 0x70A1, 0x738E, 0x73FD,
+	0x753A, 0x775B, 0x7887, 0x798E, 0x7A0B, 0x7A7D, 0x7CBE, 0x7D8E,
+	0x8247, 0x8A02, 0x8AEA, 0x8C9E, 0x912D, 0x914A, 0x91D8, 0x9266,
+	0x92CC, 0x9320, 0x9706, 0x9756, 0x975C, 0x9802, 0x9F0E, 0x5236,
+	0x5291, 0x557C, 0x5824, 0x5E1D, 0x5F1F, 0x608C, 0x63D0, 0x68AF,
+	0x6FDF, 0x796D, 0x7B2C, 0x81CD, 0x85BA, 0x88FD, 0x8AF8, 0x8E44,
+	0x918D, 0x9664, 0x969B, 0x973D, 0x984C, 0x9F4A, 0x4FCE, 0x5146,
+	0x51CB, 0x52A9, 0x5632, 0x5F14, 0x5F6B, 0x63AA, 0x64CD, 0x65E9,
+	0x6641, 0x66FA, 0x66F9, 0x671D, 0x689D, 0x68D7, 0x69FD, 0x6F15,
+	0x6F6E, 0x7167, 0x71E5, 0x722A, 0x74AA, 0x773A, 0x7956, 0x795A,
+	0x79DF, 0x7A20, 0x7A95, 0x7C97, 0x7CDF, 0x7D44, 0x7E70, 0x8087,
+	0x85FB, 0x86A4, 0x8A54, 0x8ABF, 0x8D99, 0x8E81, 0x9020, 0x906D,
+	0x91E3, 0x963B, 0x96D5, 0x9CE5, 0x65CF, 0x7C07, 0x8DB3, 0x93C3,
+	0x5B58, 0x5C0A, 0x5352, 0x62D9, 0x731D, 0x5027, 0x5B97, 0x5F9E,
+	0x60B0, 0x616B, 0x68D5, 0x6DD9, 0x742E, 0x7A2E, 0x7D42, 0x7D9C,
+	0x7E31, 0x816B, 0x8E2A, 0x8E35, 0x937E, 0x9418, 0x4F50, 0x5750,
+	0x5DE6, 0x5EA7, 0x632B, 0x7F6A, 0x4E3B, 0x4F4F, 0x4F8F, 0x505A,
+	0x59DD, 0x80C4, 0x546A, 0x5468, 0x55FE, 0x594F, 0x5B99, 0x5DDE,
+	0x5EDA, 0x665D, 0x6731, 0x67F1, 0x682A, 0x6CE8, 0x6D32, 0x6E4A,
+	0x6F8D, 0x70B7, 0x73E0, 0x7587, 0x7C4C, 0x7D02, 0x7D2C, 0x7DA2,
+	0x821F, 0x86DB, 0x8A3B, 0x8A85, 0x8D70, 0x8E8A, 0x8F33, 0x9031,
+	0x914E, 0x9152, 0x9444, 0x99D0, 0x7AF9, 0x7CA5, 0x4FCA, 0x5101,
+	0x51C6, 0x57C8, 0x5BEF, 0x5CFB, 0x6659, 0x6A3D, 0x6D5A, 0x6E96,
+	0x6FEC, 0x710C, 0x756F, 0x7AE3, 0x8822, 0x9021, 0x9075, 0x96CB,
+	0x99FF, 0x8301, 0x4E2D, 0x4EF2, 0x8846, 0x91CD, 0x537D, 0x6ADB,
+	0x696B, 0x6C41, 0x847A, 0x589E, 0x618E, 0x66FE, 0x62EF, 0x70DD,
+	0x7511, 0x75C7, 0x7E52, 0x84B8, 0x8B49, 0x8D08, 0x4E4B, 0x53EA,
+	0x54AB, 0x5730, 0x5740, 0x5FD7, 0x6301, 0x6307, 0x646F, 0x652F,
+	0x65E8, 0x667A, 0x679D, 0x67B3, 0x6B62, 0x6C60, 0x6C9A, 0x6F2C,
+	0x77E5, 0x7825, 0x7949, 0x7957, 0x7D19, 0x80A2, 0x8102, 0x81F3,
+	0x829D, 0x82B7, 0x8718, 0x8A8C, 0xF9FC, 0x8D04, 0x8DBE, 0x9072,
+	0x76F4, 0x7A19, 0x7A37, 0x7E54, 0x8077, 0x5507, 0x55D4, 0x5875,
+	0x632F, 0x6422, 0x6649, 0x664B, 0x686D, 0x699B, 0x6B84, 0x6D25,
+	0x6EB1, 0x73CD, 0x7468, 0x74A1, 0x755B, 0x75B9, 0x76E1, 0x771E,
+	0x778B, 0x79E6, 0x7E09, 0x7E1D, 0x81FB, 0x852F, 0x8897, 0x8A3A,
+	0x8CD1, 0x8EEB, 0x8FB0, 0x9032, 0x93AD, 0x9663, 0x9673, 0x9707,
+	0x4F84, 0x53F1, 0x59EA, 0x5AC9, 0x5E19, 0x684E, 0x74C6, 0x75BE,
+	0x79E9, 0x7A92, 0x81A3, 0x86ED, 0x8CEA, 0x8DCC, 0x8FED, 0x659F,
+	0x6715, 0xF9FD, 0x57F7, 0x6F57, 0x7DDD, 0x8F2F, 0x93F6, 0x96C6,
+	0x5FB5, 0x61F2, 0x6F84, 0x4E14, 0x4F98, 0x501F, 0x53C9, 0x55DF,
+	0x5D6F, 0x5DEE, 0x6B21, 0x6B64, 0x78CB, 0x7B9A, 0xF9FE, 0x8E49,
+	0x8ECA, 0x906E, 0x6349, 0x643E, 0x7740, 0x7A84, 0x932F, 0x947F,
+	0x9F6A, 0x64B0, 0x6FAF, 0x71E6, 0x74A8, 0x74DA, 0x7AC4, 0x7C12,
+	0x7E82, 0x7CB2, 0x7E98, 0x8B9A, 0x8D0A, 0x947D, 0x9910, 0x994C,
+	0x5239, 0x5BDF, 0x64E6, 0x672D, 0x7D2E, 0x50ED, 0x53C3, 0x5879,
+	0x6158, 0x6159, 0x61FA, 0x65AC, 0x7AD9, 0x8B92, 0x8B96, 0x5009,
+	0x5021, 0x5275, 0x5531, 0x5A3C, 0x5EE0, 0x5F70, 0x6134, 0x655E,
+	0x660C, 0x6636, 0x66A2, 0x69CD, 0x6EC4, 0x6F32, 0x7316, 0x7621,
+	0x7A93, 0x8139, 0x8259, 0x83D6, 0x84BC, 0x50B5, 0x57F0, 0x5BC0,
+	0x5BE8, 0x5F69, 0x63A1, 0x7826, 0x7DB5, 0x83DC, 0x8521, 0x91C7,
+	0x91F5, 0x518A, 0x67F5, 0x7B56, 0x8CAC, 0x51C4, 0x59BB, 0x60BD,
+	0x8655, 0x501C, 0xF9FF, 0x5254, 0x5C3A, 0x617D, 0x621A, 0x62D3,
+	0x64F2, 0x65A5, 0x6ECC, 0x7620, 0x810A, 0x8E60, 0x965F, 0x96BB,
+	0x4EDF, 0x5343, 0x5598, 0x5929, 0x5DDD, 0x64C5, 0x6CC9, 0x6DFA,
+	0x7394, 0x7A7F, 0x821B, 0x85A6, 0x8CE4, 0x8E10, 0x9077, 0x91E7,
+	0x95E1, 0x9621, 0x97C6, 0x51F8, 0x54F2, 0x5586, 0x5FB9, 0x64A4,
+	0x6F88, 0x7DB4, 0x8F1F, 0x8F4D, 0x9435, 0x50C9, 0x5C16, 0x6CBE,
+	0x6DFB, 0x751B, 0x77BB, 0x7C3D, 0x7C64, 0x8A79, 0x8AC2, 0x581E,
+	0x59BE, 0x5E16, 0x6377, 0x7252, 0x758A, 0x776B, 0x8ADC, 0x8CBC,
+	0x8F12, 0x5EF3, 0x6674, 0x6DF8, 0x807D, 0x83C1, 0x8ACB, 0x9751,
+	0x9BD6, 0xFA00, 0x5243, 0x66FF, 0x6D95, 0x6EEF, 0x7DE0, 0x8AE6,
+	0x902E, 0x905E, 0x9AD4, 0x521D, 0x527F, 0x54E8, 0x6194, 0x6284,
+	0x62DB, 0x68A2, 0x6912, 0x695A, 0x6A35, 0x7092, 0x7126, 0x785D,
+	0x7901, 0x790E, 0x79D2, 0x7A0D, 0x8096, 0x8278, 0x82D5, 0x8349,
+	0x8549, 0x8C82, 0x8D85, 0x9162, 0x918B, 0x91AE, 0x4FC3, 0x56D1,
+	0x71ED, 0x77D7, 0x8700, 0x89F8, 0x5BF8, 0x5FD6, 0x6751, 0x90A8,
+	0x53E2, 0x585A, 0x5BF5, 0x60A4, 0x6181, 0x6460, 0x7E3D, 0x8070,
+	0x8525, 0x9283, 0x64AE, 0x50AC, 0x5D14, 0x6700, 0x589C, 0x62BD,
+	0x63A8, 0x690E, 0x6978, 0x6A1E, 0x6E6B, 0x76BA, 0x79CB, 0x82BB,
+	0x8429, 0x8ACF, 0x8DA8, 0x8FFD, 0x9112, 0x914B, 0x919C, 0x9310,
+	0x9318, 0x939A, 0x96DB, 0x9A36, 0x9C0D, 0x4E11, 0x755C, 0x795D,
+	0x7AFA, 0x7B51, 0x7BC9, 0x7E2E, 0x84C4, 0x8E59, 0x8E74, 0x8EF8,
+	0x9010, 0x6625, 0x693F, 0x7443, 0x51FA, 0x672E, 0x9EDC, 0x5145,
+	0x5FE0, 0x6C96, 0x87F2, 0x885D, 0x8877, 0x60B4, 0x81B5, 0x8403,
+	0x8D05, 0x53D6, 0x5439, 0x5634, 0x5A36, 0x5C31, 0x708A, 0x7FE0,
+	0x805A, 0x8106, 0x81ED, 0x8DA3, 0x9189, 0x9A5F, 0x9DF2, 0x5074,
+	0x4EC4, 0x53A0, 0x60FB, 0x6E2C, 0x5C64, 0x4F88, 0x5024, 0x55E4,
+	0x5CD9, 0x5E5F, 0x6065, 0x6894, 0x6CBB, 0x6DC4, 0x71BE, 0x75D4,
+	0x75F4, 0x7661, 0x7A1A, 0x7A49, 0x7DC7, 0x7DFB, 0x7F6E, 0x81F4,
+	0x86A9, 0x8F1C, 0x96C9, 0x99B3, 0x9F52, 0x5247, 0x52C5, 0x98ED,
+	0x89AA, 0x4E03, 0x67D2, 0x6F06, 0x4FB5, 0x5BE2, 0x6795, 0x6C88,
+	0x6D78, 0x741B, 0x7827, 0x91DD, 0x937C, 0x87C4, 0x79E4, 0x7A31,
+	0x5FEB, 0x4ED6, 0x54A4, 0x553E, 0x58AE, 0x59A5, 0x60F0, 0x6253,
+	0x62D6, 0x6736, 0x6955, 0x8235, 0x9640, 0x99B1, 0x99DD, 0x502C,
+	0x5353, 0x5544, 0x577C, 0xFA01, 0x6258, 0xFA02, 0x64E2, 0x666B,
+	0x67DD, 0x6FC1, 0x6FEF, 0x7422, 0x7438, 0x8A17, 0x9438, 0x5451,
+	0x5606, 0x5766, 0x5F48, 0x619A, 0x6B4E, 0x7058, 0x70AD, 0x7DBB,
+	0x8A95, 0x596A, 0x812B, 0x63A2, 0x7708, 0x803D, 0x8CAA, 0x5854,
+	0x642D, 0x69BB, 0x5B95, 0x5E11, 0x6E6F, 0xFA03, 0x8569, 0x514C,
+	0x53F0, 0x592A, 0x6020, 0x614B, 0x6B86, 0x6C70, 0x6CF0, 0x7B1E,
+	0x80CE, 0x82D4, 0x8DC6, 0x90B0, 0x98B1, 0xFA04, 0x64C7, 0x6FA4,
+	0x6491, 0x6504, 0x514E, 0x5410, 0x571F, 0x8A0E, 0x615F, 0x6876,
+	0xFA05, 0x75DB, 0x7B52, 0x7D71, 0x901A, 0x5806, 0x69CC, 0x817F,
+	0x892A, 0x9000, 0x9839, 0x5078, 0x5957, 0x59AC, 0x6295, 0x900F,
+	0x9B2A, 0x615D, 0x7279, 0x95D6, 0x5761, 0x5A46, 0x5DF4, 0x628A,
+	0x64AD, 0x64FA, 0x6777, 0x6CE2, 0x6D3E, 0x722C, 0x7436, 0x7834,
+	0x7F77, 0x82AD, 0x8DDB, 0x9817, 0x5224, 0x5742, 0x677F, 0x7248,
+	0x74E3, 0x8CA9, 0x8FA6, 0x9211, 0x962A, 0x516B, 0x53ED, 0x634C,
+	0x4F69, 0x5504, 0x6096, 0x6557, 0x6C9B, 0x6D7F, 0x724C, 0x72FD,
+	0x7A17, 0x8987, 0x8C9D, 0x5F6D, 0x6F8E, 0x70F9, 0x81A8, 0x610E,
+	0x4FBF, 0x504F, 0x6241, 0x7247, 0x7BC7, 0x7DE8, 0x7FE9, 0x904D,
+	0x97AD, 0x9A19, 0x8CB6, 0x576A, 0x5E73, 0x67B0, 0x840D, 0x8A55,
+	0x5420, 0x5B16, 0x5E63, 0x5EE2, 0x5F0A, 0x6583, 0x80BA, 0x853D,
+	0x9589, 0x965B, 0x4F48, 0x5305, 0x530D, 0x530F, 0x5486, 0x54FA,
+	0x5703, 0x5E03, 0x6016, 0x629B, 0x62B1, 0x6355, 0xFA06, 0x6CE1,
+	0x6D66, 0x75B1, 0x7832, 0x80DE, 0x812F, 0x82DE, 0x8461, 0x84B2,
+	0x888D, 0x8912, 0x900B, 0x92EA, 0x98FD, 0x9B91, 0x5E45, 0x66B4,
+	0x66DD, 0x7011, 0x7206, 0xFA07, 0x4FF5, 0x527D, 0x5F6A, 0x6153,
+	0x6753, 0x6A19, 0x6F02, 0x74E2, 0x7968, 0x8868, 0x8C79, 0x98C7,
+	0x98C4, 0x9A43, 0x54C1, 0x7A1F, 0x6953, 0x8AF7, 0x8C4A, 0x98A8,
+	0x99AE, 0x5F7C, 0x62AB, 0x75B2, 0x76AE, 0x88AB, 0x907F, 0x9642,
+	0x5339, 0x5F3C, 0x5FC5, 0x6CCC, 0x73CC, 0x7562, 0x758B, 0x7B46,
+	0x82FE, 0x999D, 0x4E4F, 0x903C, 0x4E0B, 0x4F55, 0x53A6, 0x590F,
+	0x5EC8, 0x6630, 0x6CB3, 0x7455, 0x8377, 0x8766, 0x8CC0, 0x9050,
+	0x971E, 0x9C15, 0x58D1, 0x5B78, 0x8650, 0x8B14, 0x9DB4, 0x5BD2,
+	0x6068, 0x608D, 0x65F1, 0x6C57, 0x6F22, 0x6FA3, 0x701A, 0x7F55,
+	0x7FF0, 0x9591, 0x9592, 0x9650, 0x97D3, 0x5272, 0x8F44, 0x51FD,
+	0x542B, 0x54B8, 0x5563, 0x558A, 0x6ABB, 0x6DB5, 0x7DD8, 0x8266,
+	0x929C, 0x9677, 0x9E79, 0x5408, 0x54C8, 0x76D2, 0x86E4, 0x95A4,
+	0x95D4, 0x965C, 0x4EA2, 0x4F09, 0x59EE, 0x5AE6, 0x5DF7, 0x6052,
+	0x6297, 0x676D, 0x6841, 0x6C86, 0x6E2F, 0x7F38, 0x809B, 0x822A,
+	0xFA08, 0xFA09, 0x9805, 0x4EA5, 0x5055, 0x54B3, 0x5793, 0x595A,
+	0x5B69, 0x5BB3, 0x61C8, 0x6977, 0x6D77, 0x7023, 0x87F9, 0x89E3,
+	0x8A72, 0x8AE7, 0x9082, 0x99ED, 0x9AB8, 0x52BE, 0x6838, 0x5016,
+	0x5E78, 0x674F, 0x8347, 0x884C, 0x4EAB, 0x5411, 0x56AE, 0x73E6,
+	0x9115, 0x97FF, 0x9909, 0x9957, 0x9999, 0x5653, 0x589F, 0x865B,
+	0x8A31, 0x61B2, 0x6AF6, 0x737B, 0x8ED2, 0x6B47, 0x96AA, 0x9A57,
+	0x5955, 0x7200, 0x8D6B, 0x9769, 0x4FD4, 0x5CF4, 0x5F26, 0x61F8,
+	0x665B, 0x6CEB, 0x70AB, 0x7384, 0x73B9, 0x73FE, 0x7729, 0x774D,
+	0x7D43, 0x7D62, 0x7E23, 0x8237, 0x8852, 0xFA0A, 0x8CE2, 0x9249,
+	0x986F, 0x5B51, 0x7A74, 0x8840, 0x9801, 0x5ACC, 0x4FE0, 0x5354,
+	0x593E, 0x5CFD, 0x633E, 0x6D79, 0x72F9, 0x8105, 0x8107, 0x83A2,
+	0x92CF, 0x9830, 0x4EA8, 0x5144, 0x5211, 0x578B, 0x5F62, 0x6CC2,
+	0x6ECE, 0x7005, 0x7050, 0x70AF, 0x7192, 0x73E9, 0x7469, 0x834A,
+	0x87A2, 0x8861, 0x9008, 0x90A2, 0x93A3, 0x99A8, 0x516E, 0x5F57,
+	0x60E0, 0x6167, 0x66B3, 0x8559, 0x8E4A, 0x91AF, 0x978B, 0x4E4E,
+	0x4E92, 0x547C, 0x58D5, 0x58FA, 0x597D, 0x5CB5, 0x5F27, 0x6236,
+	0x6248, 0x660A, 0x6667, 0x6BEB, 0x6D69, 0x6DCF, 0x6E56, 0x6EF8,
+	0x6F94, 0x6FE0, 0x6FE9, 0x705D, 0x72D0, 0x7425, 0x745A, 0x74E0,
+	0x7693, 0x795C, 0x7CCA, 0x7E1E, 0x80E1, 0x82A6, 0x846B, 0x84BF,
+	0x864E, 0x865F, 0x8774, 0x8B77, 0x8C6A, 0x93AC, 0x9800, 0x9865,
+	0x60D1, 0x6216, 0x9177, 0x5A5A, 0x660F, 0x6DF7, 0x6E3E, 0x743F,
+	0x9B42, 0x5FFD, 0x60DA, 0x7B0F, 0x54C4, 0x5F18, 0x6C5E, 0x6CD3,
+	0x6D2A, 0x70D8, 0x7D05, 0x8679, 0x8A0C, 0x9D3B, 0x5316, 0x548C,
+	0x5B05, 0x6A3A, 0x706B, 0x7575, 0x798D, 0x79BE, 0x82B1, 0x83EF,
+	0x8A71, 0x8B41, 0x8CA8, 0x9774, 0xFA0B, 0x64F4, 0x652B, 0x78BA,
+	0x78BB, 0x7A6B, 0x4E38, 0x559A, 0x5950, 0x5BA6, 0x5E7B, 0x60A3,
+	0x63DB, 0x6B61, 0x6665, 0x6853, 0x6E19, 0x7165, 0x74B0, 0x7D08,
+	0x9084, 0x9A69, 0x9C25, 0x6D3B, 0x6ED1, 0x733E, 0x8C41, 0x95CA,
+	0x51F0, 0x5E4C, 0x5FA8, 0x604D, 0x60F6, 0x6130, 0x614C, 0x6643,
+	0x6644, 0x69A5, 0x6CC1, 0x6E5F, 0x6EC9, 0x6F62, 0x714C, 0x749C,
+	0x7687, 0x7BC1, 0x7C27, 0x8352, 0x8757, 0x9051, 0x968D, 0x9EC3,
+	0x532F, 0x56DE, 0x5EFB, 0x5F8A, 0x6062, 0x6094, 0x61F7, 0x6666,
+	0x6703, 0x6A9C, 0x6DEE, 0x6FAE, 0x7070, 0x736A, 0x7E6A, 0x81BE,
+	0x8334, 0x86D4, 0x8AA8, 0x8CC4, 0x5283, 0x7372, 0x5B96, 0x6A6B,
+	0x9404, 0x54EE, 0x5686, 0x5B5D, 0x6548, 0x6585, 0x66C9, 0x689F,
+	0x6D8D, 0x6DC6, 0x723B, 0x80B4, 0x9175, 0x9A4D, 0x4FAF, 0x5019,
+	0x539A, 0x540E, 0x543C, 0x5589, 0x55C5, 0x5E3F, 0x5F8C, 0x673D,
+	0x7166, 0x73DD, 0x9005, 0x52DB, 0x52F3, 0x5864, 0x58CE, 0x7104,
+	0x718F, 0x71FB, 0x85B0, 0x8A13, 0x6688, 0x85A8, 0x55A7, 0x6684,
+	0x714A, 0x8431, 0x5349, 0x5599, 0x6BC1, 0x5F59, 0x5FBD, 0x63EE,
+	0x6689, 0x7147, 0x8AF1, 0x8F1D, 0x9EBE, 0x4F11, 0x643A, 0x70CB,
+	0x7566, 0x8667, 0x6064, 0x8B4E, 0x9DF8, 0x5147, 0x51F6, 0x5308,
+	0x6D36, 0x80F8, 0x9ED1, 0x6615, 0x6B23, 0x7098, 0x75D5, 0x5403,
+	0x5C79, 0x7D07, 0x8A16, 0x6B20, 0x6B3D, 0x6B46, 0x5438, 0x6070,
+	0x6D3D, 0x7FD5, 0x8208, 0x50D6, 0x51DE, 0x559C, 0x566B, 0x56CD,
+	0x59EC, 0x5B09, 0x5E0C, 0x6199, 0x6198, 0x6231, 0x665E, 0x66E6,
+	0x7199, 0x71B9, 0x71BA, 0x72A7, 0x79A7, 0x7A00, 0x7FB2, 0x8A70,
+};
+
+/* Lower to upper case */
+static
+const BYTE upper_page[] = {
+	0x00, 0x01, 0xFF, 0x02, 0x03, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0x04, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x05,
+};
+
+static
+const DWORD upper_bits[] = {
+	0x00000000, 0x00000000, 0x00000000, 0x07FFFFFE, 0x00000000, 0x0000902E,
+	0x00000000, 0xFF7FFFFF, 0xAAAAAAAA, 0x54AAAAAA, 0xAAAAA955, 0x54AAAAAA,
+	0x00040000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0xFFFE0000, 0x000007FB, 0x00000000,
+	0x00000000, 0xFFFF0000, 0xDFFEFFFF, 0x00000000, 0x00000000, 0x00000000,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xFFFF0000,
+	0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+	0x07FFFFFE, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+};
+
+static
+const WORD upper_base[] = {
+	0x0000, 0x0000, 0x0000, 0x0000, 0x001A, 0x001A, 0x0020, 0x0020,
+	0x003F, 0x004F, 0x005E, 0x006E, 0x007D, 0x007E, 0x007E, 0x007E,
+	0x007E, 0x007E, 0x007E, 0x007E, 0x007E, 0x007E, 0x008D, 0x0097,
+	0x0097, 0x0097, 0x00A7, 0x00C5, 0x00C5, 0x00C5, 0x00C5, 0x00C5,
+	0x00C5, 0x00C5, 0x00C5, 0x00C5, 0x00D5, 0x00D5, 0x00D5, 0x00D5,
+	0x00D5, 0x00D5, 0x00D5, 0x00EF, 0x00EF, 0x00EF, 0x00EF, 0x00EF,
+};
+
+static
+const WCHAR upper_code[] = {
+	0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048,
+	0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F, 0x0050,
+	0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058,
+	0x0059, 0x005A, 0x0021, 0xFFE0, 0xFFE1, 0xFFE5, 0xFFE2, 0xFFE3,
+	0x00C0, 0x00C1, 0x00C2, 0x00C3, 0x00C4, 0x00C5, 0x00C6, 0x00C7,
+	0x00C8, 0x00C9, 0x00CA, 0x00CB, 0x00CC, 0x00CD, 0x00CE, 0x00CF,
+	0x00D0, 0x00D1, 0x00D2, 0x00D3, 0x00D4, 0x00D5, 0x00D6, 0x00D8,
+	0x00D9, 0x00DA, 0x00DB, 0x00DC, 0x00DD, 0x00DE, 0x0178, 0x0100,
+	0x0102, 0x0104, 0x0106, 0x0108, 0x010A, 0x010C, 0x010E, 0x0110,
+	0x0112, 0x0114, 0x0116, 0x0118, 0x011A, 0x011C, 0x011E, 0x0120,
+	0x0122, 0x0124, 0x0126, 0x0128, 0x012A, 0x012C, 0x012E, 0x0130,
+	0x0132, 0x0134, 0x0136, 0x0139, 0x013B, 0x013D, 0x013F, 0x0141,
+	0x0143, 0x0145, 0x0147, 0x014A, 0x014C, 0x014E, 0x0150, 0x0152,
+	0x0154, 0x0156, 0x0158, 0x015A, 0x015C, 0x015E, 0x0160, 0x0162,
+	0x0164, 0x0166, 0x0168, 0x016A, 0x016C, 0x016E, 0x0170, 0x0172,
+	0x0174, 0x0176, 0x0179, 0x017B, 0x017D, 0x0191, 0x0391, 0x0392,
+	0x0393, 0x0394, 0x0395, 0x0396, 0x0397, 0x0398, 0x0399, 0x039A,
+	0x039B, 0x039C, 0x039D, 0x039E, 0x039F, 0x03A0, 0x03A1, 0x03A3,
+	0x03A4, 0x03A5, 0x03A6, 0x03A7, 0x03A8, 0x03A9, 0x03AA, 0x0410,
+	0x0411, 0x0412, 0x0413, 0x0414, 0x0415, 0x0416, 0x0417, 0x0418,
+	0x0419, 0x041A, 0x041B, 0x041C, 0x041D, 0x041E, 0x041F, 0x0420,
+	0x0421, 0x0422, 0x0423, 0x0424, 0x0425, 0x0426, 0x0427, 0x0428,
+	0x0429, 0x042A, 0x042B, 0x042C, 0x042D, 0x042E, 0x042F, 0x0401,
+	0x0402, 0x0403, 0x0404, 0x0405, 0x0406, 0x0407, 0x0408, 0x0409,
+	0x040A, 0x040B, 0x040C, 0x040E, 0x040F, 0x2160, 0x2161, 0x2162,
+	0x2163, 0x2164, 0x2165, 0x2166, 0x2167, 0x2168, 0x2169, 0x216A,
+	0x216B, 0x216C, 0x216D, 0x216E, 0x216F, 0xFF21, 0xFF22, 0xFF23,
+	0xFF24, 0xFF25, 0xFF26, 0xFF27, 0xFF28, 0xFF29, 0xFF2A, 0xFF2B,
+	0xFF2C, 0xFF2D, 0xFF2E, 0xFF2F, 0xFF30, 0xFF31, 0xFF32, 0xFF33,
+	0xFF34, 0xFF35, 0xFF36, 0xFF37, 0xFF38, 0xFF39, 0xFF3A,
+};
+
+#define CC_MAP(n)	{ n##_page, n##_bits, n##_base, n##_code }
+
+typedef struct {
+	const BYTE *page;	/* Row of each page, 0xFF: no code */
+	const DWORD *bits;	/* Mapped codes of each block of 32 codes */
+	const WORD *base;	/* Index in code of the first code of each block */
+	const WCHAR *code;	/* Mapped codes */
+} CCMAP;
+
+static
+const CCMAP cc_maps[3] = { CC_MAP(uni2oem), CC_MAP(oem2uni), CC_MAP(upper) };
+
+
+static
+WCHAR cc_lookup (	/* Mapped code, 0 means no code */
+	const CCMAP *map,	/* Map to look up */
+	WCHAR c				/* Code to look up */
+)
+{
+	BYTE row;
+	UINT b;
+	DWORD bit, m;
+
+
+	row = map->page[c >> 8];
+	if (row == 0xFF) return 0;
+	b = row * 8 + ((c >> 5) & 7);
+	bit = (DWORD)1 << (c & 31);
+	if (!(map->bits[b] & bit)) return 0;
+	m = map->bits[b] & (bit - 1);					/* Count the mapped codes below c */
+	m = m - ((m >> 1) & 0x55555555);
+	m = (m & 0x33333333) + ((m >> 2) & 0x33333333);
+	m = ((((m + (m >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24) & 0xFF;
+	return map->code[map->base[b] + m];
+}
+
+
+
+WCHAR ff_convert (	/* Converted code, 0 means conversion error */
+	WCHAR	src,	/* Character code to be converted */
+	UINT	dir		/* 0: Unicode to OEMCP, 1: OEMCP to Unicode */
+)
+{
+	if (src < 0x80)	/* ASCII */
+		return src;
+
+	return cc_lookup(&cc_maps[dir ? 1 : 0], src);
+}
+
+
+
+WCHAR ff_wtoupper (	/* Upper converted character */
+	WCHAR chr		/* Input character */
+)
+{
+	WCHAR c = cc_lookup(&cc_maps[2], chr);
+
+	return c ? c : chr;
+}
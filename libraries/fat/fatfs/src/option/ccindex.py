@@ -0,0 +1,275 @@
+#!/usr/bin/env python
+# ----------------------------------------------------------------------------
+#         ATMEL Microcontroller Software Support
+# ----------------------------------------------------------------------------
+# Copyright (c) 2009, Atmel Corporation
+#
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# - Redistributions of source code must retain the above copyright notice,
+# this list of conditions and the disclaimer below.
+#
+# Atmel's name may not be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+# IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+# DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+# OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+# EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+# ----------------------------------------------------------------------------
+
+"""Converts the flat code page tables of FatFs (cc932.c, cc936.c, cc949.c,
+cc950.c) to the indexed format of cc932i.c, cc936i.c, cc949i.c and
+cc950i.c, a drop-in replacement for the LFN support with DBCS.
+
+    ccindex.py cc936.c [-o cc936i.c]
+
+ff_convert() of the flat files searches sorted pairs (binary search per
+character); the indexed files give the code in constant time and about half
+the flash. Each direction of the conversion, and the upper case table of
+ff_wtoupper(), is a map of 16-bit codes stored as:
+
+    page[256]     row of the 256 codes of a page (high byte), or 0xFF
+    bits[row*8+b] bitmap of the mapped codes of block b (32 codes) of a row
+    base[row*8+b] index in code[] of the first mapped code of the block
+    code[]        mapped codes, in the order of the source codes
+
+The code of c is code[base + number of bits set below bit c & 31], when the
+bit is set. Pages without any mapped code cost one byte.
+"""
+
+import re
+import sys
+
+BLOCK = 32
+BLOCKS_PER_ROW = 256 // BLOCK
+NO_ROW = 0xFF
+
+
+def parse_table(source, name):
+    m = re.search(r'const WCHAR %s\[\] = \{(.*?)\};' % name, source, re.S)
+    if not m:
+        raise ValueError('table %s not found' % name)
+    body = re.sub(r'/\*.*?\*/', '', m.group(1))
+    return [int(x, 16) for x in re.findall(r'0x[0-9A-Fa-f]+', body)]
+
+
+def parse_source(source):
+    """Unicode to OEM pairs, OEM to Unicode pairs, lower to upper pairs and
+    the highest code converted as is."""
+    names = re.findall(r'const WCHAR (\w+)\[\] = ', source)
+    uni2oem = parse_table(source, names[0])
+    oem2uni = parse_table(source, names[1])
+    lower = parse_table(source, 'tbl_lower')
+    upper = parse_table(source, 'tbl_upper')
+    m = re.search(r'if \(src (<=?) 0x80\)', source)
+    ascii_max = 0x80 if m.group(1) == '<=' else 0x7F
+    return (list(zip(uni2oem[0::2], uni2oem[1::2])),
+            list(zip(oem2uni[0::2], oem2uni[1::2])),
+            list(zip(lower, upper)), ascii_max)
+
+
+def flat_search(pairs, c):
+    """Code found by the binary search of the flat ff_convert(), or None."""
+    li, hi = 0, len(pairs) - 1
+    for n in range(16):
+        i = li + (hi - li) // 2
+        if pairs[i][0] == c:
+            return pairs[i][1]
+        if c > pairs[i][0]:
+            li = i
+        else:
+            hi = i
+    return None
+
+
+def build_map(pairs):
+    """A code mapped twice (CP950 has a few) keeps the code the flat
+    ff_convert() returned."""
+    codes = {}
+    for a, b in pairs:
+        codes.setdefault(a, b)
+    for a in codes:
+        found = flat_search(pairs, a)
+        if found is not None:
+            codes[a] = found
+    page = [NO_ROW] * 256
+    bits, base, code = [], [], []
+    for p in range(256):
+        if not any((p << 8) + i in codes for i in range(256)):
+            continue
+        if len(base) // BLOCKS_PER_ROW >= NO_ROW:
+            raise ValueError('too many pages')
+        page[p] = len(base) // BLOCKS_PER_ROW
+        for b in range(BLOCKS_PER_ROW):
+            mask = 0
+            base.append(len(code))
+            for i in range(BLOCK):
+                c = (p << 8) + b * BLOCK + i
+                if c in codes:
+                    mask |= 1 << i
+                    code.append(codes[c])
+            bits.append(mask)
+    if len(code) > 0xFFFF:
+        raise ValueError('too many codes')
+    return page, bits, base, code
+
+
+def lookup(table, c):
+    page, bits, base, code = table
+    row = page[c >> 8]
+    if row == NO_ROW:
+        return 0
+    b = row * BLOCKS_PER_ROW + ((c >> 5) & 7)
+    bit = 1 << (c & 31)
+    if not bits[b] & bit:
+        return 0
+    return code[base[b] + bin(bits[b] & (bit - 1)).count('1')]
+
+
+def c_array(ctype, name, values, width, per_line):
+    fmt = '0x%%0%dX' % width
+    lines = ['static', 'const %s %s[] = {' % (ctype, name)]
+    for i in range(0, len(values), per_line):
+        lines.append('\t' + ', '.join(fmt % v for v in values[i:i + per_line])
+                     + ',')
+    lines.append('};')
+    return lines
+
+
+def c_map(name, table):
+    page, bits, base, code = table
+    return (c_array('BYTE', name + '_page', page, 2, 16) + [''] +
+            c_array('DWORD', name + '_bits', bits, 8, 6) + [''] +
+            c_array('WORD', name + '_base', base, 4, 8) + [''] +
+            c_array('WCHAR', name + '_code', code, 4, 8) + [''])
+
+
+CODE = '''
+#define CC_MAP(n)	{ n##_page, n##_bits, n##_base, n##_code }
+
+typedef struct {
+	const BYTE *page;	/* Row of each page, 0xFF: no code */
+	const DWORD *bits;	/* Mapped codes of each block of 32 codes */
+	const WORD *base;	/* Index in code of the first code of each block */
+	const WCHAR *code;	/* Mapped codes */
+} CCMAP;
+
+static
+const CCMAP cc_maps[3] = { CC_MAP(uni2oem), CC_MAP(oem2uni), CC_MAP(upper) };
+
+
+static
+WCHAR cc_lookup (	/* Mapped code, 0 means no code */
+	const CCMAP *map,	/* Map to look up */
+	WCHAR c				/* Code to look up */
+)
+{
+	BYTE row;
+	UINT b;
+	DWORD bit, m;
+
+
+	row = map->page[c >> 8];
+	if (row == 0xFF) return 0;
+	b = row * 8 + ((c >> 5) & 7);
+	bit = (DWORD)1 << (c & 31);
+	if (!(map->bits[b] & bit)) return 0;
+	m = map->bits[b] & (bit - 1);					/* Count the mapped codes below c */
+	m = m - ((m >> 1) & 0x55555555);
+	m = (m & 0x33333333) + ((m >> 2) & 0x33333333);
+	m = ((((m + (m >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24) & 0xFF;
+	return map->code[map->base[b] + m];
+}
+
+
+
+WCHAR ff_convert (	/* Converted code, 0 means conversion error */
+	WCHAR	src,	/* Character code to be converted */
+	UINT	dir		/* 0: Unicode to OEMCP, 1: OEMCP to Unicode */
+)
+{
+	if (src %s 0x80)	/* ASCII */
+		return src;
+
+	return cc_lookup(&cc_maps[dir ? 1 : 0], src);
+}
+
+
+
+WCHAR ff_wtoupper (	/* Upper converted character */
+	WCHAR chr		/* Input character */
+)
+{
+	WCHAR c = cc_lookup(&cc_maps[2], chr);
+
+	return c ? c : chr;
+}
+'''
+
+
+def generate(source, name):
+    uni2oem, oem2uni, upper, ascii_max = parse_source(source)
+    maps = [build_map(uni2oem), build_map(oem2uni), build_map(upper)]
+    for table, pairs in zip(maps, (uni2oem, oem2uni, upper)):
+        for a, b in pairs:
+            assert lookup(table, a) in (b, flat_search(pairs, a))
+    cp = re.search(r'_CODE_PAGE != (\d+)', source).group(1)
+    title = re.search(r'/\* (CP%s .*?)\s*\*/' % cp, source).group(1)
+    out = [
+        '/*------------------------------------------------------------------------*/',
+        '/* Unicode - OEM code bidirectional converter  (C)ChaN, 2009              */',
+        '/*                                                                        */',
+        '/* %-70s */' % title,
+        '/* Indexed tables generated from %-40s */' % (name + ' by ccindex.py'),
+        '/*------------------------------------------------------------------------*/',
+        '',
+        '#include "../ff.h"',
+        '',
+        '',
+        '#if !_USE_LFN || _CODE_PAGE != %s' % cp,
+        '#error This file is not needed in current configuration. Remove from the project.',
+        '#endif',
+        '',
+        '/* Unicode to OEM */',
+    ]
+    out += c_map('uni2oem', maps[0])
+    out += ['/* OEM to Unicode */']
+    out += c_map('oem2uni', maps[1])
+    out += ['/* Lower to upper case */']
+    out += c_map('upper', maps[2])
+    out += (CODE % ('<=' if ascii_max == 0x80 else '<')).split('\n')[1:]
+    size = sum(len(t[0]) + 4 * len(t[1]) + 2 * len(t[2]) + 2 * len(t[3])
+               for t in maps)
+    flat = 4 * (len(uni2oem) + len(oem2uni) + len(upper))
+    return '\r\n'.join(out), size, flat
+
+
+def main(argv):
+    if not argv or argv[0] in ('-h', '--help'):
+        print(__doc__)
+        return 1
+    name = argv[0]
+    output = re.sub(r'\.c$', 'i.c', name)
+    if len(argv) == 3 and argv[1] == '-o':
+        output = argv[2]
+    with open(name) as f:
+        source = f.read()
+    text, size, flat = generate(source, name.split('/')[-1])
+    with open(output, 'wb') as f:
+        f.write(text.encode('ascii'))
+    print('%s: %d bytes of tables (flat: %d)' % (output, size, flat))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,312 @@
+/*------------------------------------------------------------------------*/
+/* Data logger: ADC stream to a preallocated file                         */
+/* for FatFs R0.08 on the SAM3S-EK                                        */
+/*------------------------------------------------------------------------*/
+/* See logger.h for the pipeline and the record format.
+*/
+
+#include "logger.h"
+#include <string.h>
+
+#if _USE_EXPAND
+
+#if _MAX_SS != 512
+#error ff_logger writes 512-byte sectors
+#endif
+
+#define UNIT_BYTES	(FF_LOGGER_UNIT * 512)
+
+
+/*------------------------------------------------------------------------*/
+/* Pack a record, returns its size                                        */
+/*------------------------------------------------------------------------*/
+
+static UINT logger_pack (
+	FFLOGGER *lg,
+	BYTE ch,
+	const WORD *smp,
+	UINT n
+)
+{
+	BYTE *p = lg->pack + FF_LOGGER_HEADER, flags = 0;
+	WORD prev;
+	int d;
+	UINT i;
+
+
+	if (lg->delta) {					/* Delta coding, raw if a difference does not fit in 15 bits */
+		prev = smp[0];
+		*p++ = (BYTE)prev; *p++ = (BYTE)(prev >> 8);
+		for (i = 1; i < n; i++) {
+			d = (int)smp[i] - (int)prev;
+			prev = smp[i];
+			if (d >= -64 && d < 64) {
+				*p++ = (BYTE)(d & 0x7F);
+			} else {
+				if (d < -16384 || d > 16383) break;
+				*p++ = (BYTE)(0x80 | ((d >> 8) & 0x7F));
+				*p++ = (BYTE)d;
+			}
+		}
+		if (i == n) flags = FF_LOGGER_DELTA;
+		else p = lg->pack + FF_LOGGER_HEADER;
+	}
+	if (!flags) {
+		for (i = 0; i < n; i++) {
+			*p++ = (BYTE)smp[i]; *p++ = (BYTE)(smp[i] >> 8);
+		}
+	}
+
+	i = (UINT)(p - lg->pack) - FF_LOGGER_HEADER;	/* Payload bytes */
+	p = lg->pack;
+	p[0] = FF_LOGGER_SYNC; p[1] = ch; p[2] = flags; p[3] = lg->lostrun;
+	p[4] = (BYTE)n; p[5] = (BYTE)(n >> 8);
+	p[6] = (BYTE)i; p[7] = (BYTE)(i >> 8);
+
+	return FF_LOGGER_HEADER + i;
+}
+
+
+/*------------------------------------------------------------------------*/
+/* Queue samples (interrupt)                                              */
+/*------------------------------------------------------------------------*/
+
+FRESULT ff_logger_put (
+	FFLOGGER *lg,		/* Logger */
+	BYTE ch,			/* Channel of the samples */
+	const WORD *smp,	/* Samples */
+	UINT cnt			/* Number of samples */
+)
+{
+	UINT n, sz;
+	FRESULT res = FR_OK;
+
+
+	while (cnt) {
+		n = (cnt > FF_LOGGER_MAX_SAMPLES) ? FF_LOGGER_MAX_SAMPLES : cnt;
+		sz = logger_pack(lg, ch, smp, n);
+		if (lg->res != FR_OK || RING_GetFree(&lg->ring) < sz) {	/* Ring full or logging stopped: drop */
+			lg->lost++;
+			lg->lostsamples += n;
+			if (lg->lostrun < 255) lg->lostrun++;
+			res = FR_DENIED;
+		} else {
+			RING_Write(&lg->ring, lg->pack, sz);
+			lg->records++;
+			lg->lostrun = 0;
+		}
+		smp += n; cnt -= n;
+	}
+
+	return res;
+}
+
+
+void ff_logger_adc (
+	AdcStream *stream,	/* ADC stream, pArgument is the logger */
+	uint32_t ch,		/* Channel */
+	uint16_t *smp,		/* Samples of the bank */
+	uint32_t cnt		/* Number of samples */
+)
+{
+	FFLOGGER *lg = (FFLOGGER*)stream->pArgument;
+
+
+	lg->adc = stream;
+	ff_logger_put(lg, (BYTE)ch, smp, (UINT)cnt);
+}
+
+
+/*------------------------------------------------------------------------*/
+/* Unit written (SD interrupt)                                            */
+/*------------------------------------------------------------------------*/
+
+static void logger_sent (
+	uint8_t status,
+	void *arg
+)
+{
+	FFLOGGER *lg = (FFLOGGER*)arg;
+
+
+	lg->status = status;
+	lg->busy = 0;
+}
+
+
+/*------------------------------------------------------------------------*/
+/* Start logging                                                          */
+/*------------------------------------------------------------------------*/
+
+FRESULT ff_logger_open (
+	FFLOGGER *lg,		/* Logger */
+	FIL *fp,			/* Empty file opened for writing */
+	SdCard *sd,			/* Card of the volume, 0: write with f_write */
+	BYTE *buf,			/* Ring storage */
+	DWORD sz,			/* Ring size, power of 2, at least 2 units */
+	DWORD fsz,			/* File size to preallocate */
+	BYTE delta			/* 1: delta coded records */
+)
+{
+	FRESULT res;
+	FATFS *fs;
+	DWORD pre;
+
+
+	if (sz < 2 * UNIT_BYTES || (sz & (sz - 1))) return FR_INT_ERR;
+	if (!RING_Initialize(&lg->ring, buf, sz)) return FR_INT_ERR;
+
+	fsz = (fsz + UNIT_BYTES - 1) / UNIT_BYTES * UNIT_BYTES;
+	res = f_expand(fp, fsz, 1);			/* Contiguous sectors */
+	if (res == FR_OK) res = f_sync(fp);	/* Allocation on the volume before the card is streamed */
+	if (res != FR_OK) return res;
+
+	fs = fp->fs;
+	lg->fp = fp;
+	lg->sd = sd;
+	lg->delta = delta;
+	lg->lostrun = 0;
+	lg->issued = lg->busy = 0;
+	lg->status = 0;
+	lg->res = FR_OK;
+	lg->sect = fs->database + (fp->org_clust - 2) * fs->csize;
+	lg->nsect = fsz / 512;
+	lg->written = lg->records = lg->lost = lg->lostsamples = 0;
+	lg->peak = lg->waits = 0;
+	lg->adc = 0;
+
+	if (sd) {
+		pre = (lg->nsect > 0x7FFFFF) ? 0x7FFFFF : lg->nsect;	/* ACMD23 count is 23 bits */
+		if (SD_StreamOpen(sd, lg->sect, pre, 0)) return FR_DISK_ERR;
+	}
+
+	return FR_OK;
+}
+
+
+/*------------------------------------------------------------------------*/
+/* Write the ring to the file (main loop)                                 */
+/*------------------------------------------------------------------------*/
+
+static void logger_release (	/* The unit issued is on the card */
+	FFLOGGER *lg
+)
+{
+	RING_Consume(&lg->ring, UNIT_BYTES);
+	lg->sect += FF_LOGGER_UNIT;
+	lg->nsect -= FF_LOGGER_UNIT;
+	lg->written += UNIT_BYTES;
+	lg->issued = 0;
+}
+
+
+static FRESULT logger_write (	/* Write sectors from the ring, synchronous with f_write */
+	FFLOGGER *lg,
+	BYTE *p,
+	UINT nsect
+)
+{
+	UINT bw;
+	uint8_t err;
+
+
+	if (lg->sd) {
+		lg->busy = 1;
+		err = SD_StreamAppend(lg->sd, p, (uint16_t)nsect, logger_sent, lg);
+		if (err == SDMMC_ERROR_NOT_INITIALIZED) {	/* Session closed by another access: restart it here */
+			err = SD_StreamOpen(lg->sd, lg->sect, 0, 0);
+			if (!err) err = SD_StreamAppend(lg->sd, p, (uint16_t)nsect, logger_sent, lg);
+		}
+		if (err) {
+			lg->busy = 0;
+			return FR_DISK_ERR;
+		}
+		return FR_OK;
+	}
+
+	if (f_write(lg->fp, p, nsect * 512, &bw) != FR_OK || bw != nsect * 512) return FR_DISK_ERR;
+	return FR_OK;
+}
+
+
+FRESULT ff_logger_poll (
+	FFLOGGER *lg		/* Logger */
+)
+{
+	DWORD n;
+	BYTE *p;
+
+
+	if (lg->res != FR_OK) return lg->res;
+
+	n = RING_GetCount(&lg->ring);
+	if (n > lg->peak) lg->peak = n;
+
+	if (lg->issued) {
+		if (lg->busy) {
+			if (n >= 2 * UNIT_BYTES) lg->waits++;	/* Next unit ready behind the one in progress */
+			return FR_OK;
+		}
+		if (lg->status) return lg->res = FR_DISK_ERR;
+		logger_release(lg);
+		n -= UNIT_BYTES;
+	}
+
+	if (n < UNIT_BYTES) return FR_OK;
+	if (lg->nsect < FF_LOGGER_UNIT) return lg->res = FR_DENIED;	/* File full */
+
+	RING_Peek(&lg->ring, &p);			/* Units never wrap, the ring being a multiple of them */
+	lg->res = logger_write(lg, p, FF_LOGGER_UNIT);
+	if (lg->res != FR_OK) return lg->res;
+	lg->issued = 1;
+	if (!lg->sd) logger_release(lg);
+
+	return FR_OK;
+}
+
+
+/*------------------------------------------------------------------------*/
+/* Stop logging, the ADC stream must be stopped before                    */
+/*------------------------------------------------------------------------*/
+
+FRESULT ff_logger_close (
+	FFLOGGER *lg		/* Logger */
+)
+{
+	FRESULT res, fr;
+	DWORD n, ns;
+	BYTE *p;
+
+
+	do {								/* Units in progress and complete ones */
+		res = ff_logger_poll(lg);
+	} while (res == FR_OK && (lg->issued || RING_GetCount(&lg->ring) >= UNIT_BYTES));
+
+	n = RING_GetCount(&lg->ring);		/* Last records, padded with zeros up to a sector */
+	if (res == FR_OK && n) {
+		ns = (n + 511) / 512;
+		if (ns > lg->nsect) {
+			res = FR_DENIED;
+		} else {
+			RING_Peek(&lg->ring, &p);
+			memset(p + n, 0, ns * 512 - n);
+			res = logger_write(lg, p, ns);
+			while (lg->busy) ;
+			if (res == FR_OK && lg->sd && lg->status) res = FR_DISK_ERR;
+			if (res == FR_OK) {
+				RING_Consume(&lg->ring, n);
+				lg->written += n;
+			}
+		}
+	}
+	if (lg->sd && SD_StreamClose(lg->sd) && res == FR_OK) res = FR_DISK_ERR;
+	lg->res = (res == FR_OK) ? FR_DENIED : res;	/* Further samples are dropped */
+
+	fr = f_lseek(lg->fp, lg->written);	/* Cut the file to the data */
+	if (fr == FR_OK) fr = f_truncate(lg->fp);
+	if (fr == FR_OK) fr = f_sync(lg->fp);
+
+	return (res != FR_OK) ? res : fr;
+}
+
+#endif /* _USE_EXPAND */
@@ -0,0 +1,88 @@
+/*------------------------------------------------------------------------*/
+/* Data logger: ADC stream to a preallocated file                         */
+/* for FatFs R0.08 on the SAM3S-EK                                        */
+/*------------------------------------------------------------------------*/
+/* The samples go from the ADC PDC banks (adc.h, ADC_StreamStart with a
+/  TC trigger, optional boxcar decimation) through a ring (ringbuf.h), in
+/  SRAM or PSRAM, to a file preallocated with f_expand. ff_logger_adc is
+/  the stream callback: it packs the samples of each bank, raw or delta
+/  coded, into a record of the ring, from the ADC interrupt. A record the
+/  ring has no room for is dropped and counted (backpressure): the ring is
+/  never overwritten, and the next record tells how many were lost.
+/  ff_logger_poll, from the main loop, writes the ring by units of
+/  FF_LOGGER_UNIT sectors, straight from the ring to the card in one open
+/  ended multiple block write (SD_StreamAppend), while the next records
+/  come in: the card busy pauses are absorbed by the ring.
+/
+/  The file sectors being contiguous, the FAT and the directory are not
+/  written while logging; the volume must not be used from ff_logger_open
+/  to ff_logger_close, which writes the last sectors and truncates the file
+/  to the data. Without card driver (sd = 0), the units are written with
+/  f_write, sector aligned so that FatFs transfers them directly too.
+/
+/  Record: BYTE sync (FF_LOGGER_SYNC), BYTE channel, BYTE flags
+/  (FF_LOGGER_DELTA), BYTE records lost just before (saturated), WORD
+/  samples, WORD payload bytes (little endian), then the payload. Raw: one
+/  WORD per sample. Delta: first sample as WORD, then each difference to
+/  the previous sample, in one byte if in -64..63 (bit 7 clear), else in
+/  two bytes, big endian, bit 15 set, 15-bit signed.
+/  The tail of a file not closed (power loss) is zero filled or stale:
+/  parsing stops at the first record without sync.
+*/
+
+#ifndef _FF_LOGGER
+#define _FF_LOGGER
+
+#include "../ff.h"
+#include "chip.h"
+#include "memories.h"
+
+#if _USE_EXPAND
+
+/* Sectors per write, the ring size must be a multiple of it */
+#ifndef FF_LOGGER_UNIT
+#define FF_LOGGER_UNIT		8
+#endif
+
+/* Largest number of samples per record, longer banks are split */
+#ifndef FF_LOGGER_MAX_SAMPLES
+#define FF_LOGGER_MAX_SAMPLES	256
+#endif
+
+#define FF_LOGGER_SYNC		0xA5
+#define FF_LOGGER_HEADER	8
+#define FF_LOGGER_DELTA		0x01	/* Record flag: delta coded payload */
+
+/* Logger state */
+typedef struct _FFLOGGER {
+	FIL *fp;					/* File being written */
+	SdCard *sd;					/* Card of the volume, 0: write with f_write */
+	RingBuffer ring;			/* Records */
+	BYTE delta;					/* Delta coding of the records */
+	BYTE lostrun;				/* Records lost since the last one queued */
+	BYTE issued;				/* A unit was issued and not yet released from the ring */
+	volatile BYTE busy;			/* A unit is being written to the card */
+	volatile BYTE status;		/* SD status of the last unit */
+	FRESULT res;				/* First error, logging stops on it */
+	DWORD sect;					/* Next sector of the file on the card */
+	DWORD nsect;				/* Sectors left in the file */
+	/* Counters */
+	DWORD written;				/* Bytes written to the file */
+	volatile DWORD records;		/* Records queued */
+	volatile DWORD lost;		/* Records dropped, ring full */
+	volatile DWORD lostsamples;	/* Samples of the dropped records */
+	DWORD peak;					/* Highest ring fill, in bytes */
+	DWORD waits;				/* Polls with a unit ready while the card was busy */
+	AdcStream *adc;				/* Stream of the samples, for its overrun count */
+	BYTE pack[FF_LOGGER_HEADER + FF_LOGGER_MAX_SAMPLES * 2];	/* Record being packed */
+} FFLOGGER;
+
+FRESULT ff_logger_open (FFLOGGER*, FIL*, SdCard*, BYTE*, DWORD, DWORD, BYTE);	/* Preallocate the file and start logging */
+void ff_logger_adc (AdcStream*, uint32_t, uint16_t*, uint32_t);		/* ADC stream callback, pArgument is the logger */
+FRESULT ff_logger_put (FFLOGGER*, BYTE, const WORD*, UINT);		/* Queue samples, from one interrupt level only */
+FRESULT ff_logger_poll (FFLOGGER*);							/* Write the ring to the file */
+FRESULT ff_logger_close (FFLOGGER*);						/* Write the rest and truncate the file */
+
+#endif /* _USE_EXPAND */
+
+#endif /* _FF_LOGGER */
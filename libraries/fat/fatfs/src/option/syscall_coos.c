@@ -0,0 +1,78 @@
+/*------------------------------------------------------------------------*/
+/* Sample code of OS dependent synchronization object controls            */
+/* for FatFs R0.08 on CoOS                                    */
+/*------------------------------------------------------------------------*/
+
+#include "../ff.h"
+
+#if _FS_REENTRANT && _FS_OS == _FS_OS_COOS
+
+/*------------------------------------------------------------------------*/
+/* Create a Synchronization Object                                        */
+/*------------------------------------------------------------------------*/
+/* This function is called in f_mount function to create a new
+/  synchronization object, such as semaphore and mutex. When a FALSE is
+/  returned, the f_mount function fails with FR_INT_ERR.
+/  CoOS mutexes have neither timeout nor delete, a binary semaphore is
+/  used instead.
+*/
+
+int ff_cre_syncobj (	/* TRUE:Function succeeded, FALSE:Could not create due to any error */
+	BYTE vol,			/* Corresponding logical drive being processed */
+	_SYNC_t *sobj		/* Pointer to return the created sync object */
+)
+{
+	*sobj = CoCreateSem(1, 1, EVENT_SORT_TYPE_FIFO);
+
+	return (*sobj != E_CREATE_FAIL);
+}
+
+
+
+/*------------------------------------------------------------------------*/
+/* Delete a Synchronization Object                                        */
+/*------------------------------------------------------------------------*/
+/* This function is called in f_mount function to delete a synchronization
+/  object that created with ff_cre_syncobj function. When a FALSE is
+/  returned, the f_mount function fails with FR_INT_ERR.
+*/
+
+int ff_del_syncobj (	/* TRUE:Function succeeded, FALSE:Could not delete due to any error */
+	_SYNC_t sobj		/* Sync object tied to the logical drive to be deleted */
+)
+{
+	return (CoDelSem(sobj, OPT_DEL_ANYWAY) == E_OK);
+}
+
+
+
+/*------------------------------------------------------------------------*/
+/* Request Grant to Access the Volume                                     */
+/*------------------------------------------------------------------------*/
+/* This function is called on entering file functions to lock the volume.
+/  When a FALSE is returned, the file function fails with FR_TIMEOUT.
+*/
+
+int ff_req_grant (	/* TRUE:Got a grant to access the volume, FALSE:Could not get a grant */
+	_SYNC_t sobj	/* Sync object to wait */
+)
+{
+	return (CoPendSem(sobj, _FS_TIMEOUT) == E_OK);
+}
+
+
+
+/*------------------------------------------------------------------------*/
+/* Release Grant to Access the Volume                                     */
+/*------------------------------------------------------------------------*/
+/* This function is called on leaving file functions to unlock the volume.
+*/
+
+void ff_rel_grant (
+	_SYNC_t sobj	/* Sync object to be signaled */
+)
+{
+	CoPostSem(sobj);
+}
+
+#endif /* _FS_REENTRANT && _FS_OS == _FS_OS_COOS */
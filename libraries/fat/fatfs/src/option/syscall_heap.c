@@ -0,0 +1,42 @@
+/*------------------------------------------------------------------------*/
+/* Sample code of the memory control functions                            */
+/* for FatFs R0.08 on the SAM3S-EK multi-region heap                      */
+/*------------------------------------------------------------------------*/
+
+#include "../ff.h"
+
+#if _USE_LFN == 3
+
+#include "board.h"
+
+/* Region of the LFN working buffers: HEAP_SRAM, HEAP_PSRAM or HEAP_ANY */
+#ifndef _FS_HEAP_FLAGS
+#define _FS_HEAP_FLAGS	HEAP_ANY
+#endif
+
+/*------------------------------------------------------------------------*/
+/* Allocate a memory block                                                */
+/*------------------------------------------------------------------------*/
+/* If a NULL is returned, the file function fails with FR_NOT_ENOUGH_CORE.
+*/
+
+void* ff_memalloc (	/* Returns pointer to the allocated memory block */
+	UINT size		/* Number of bytes to allocate */
+)
+{
+	return HEAP_Alloc(size, _FS_HEAP_FLAGS);
+}
+
+
+/*------------------------------------------------------------------------*/
+/* Free a memory block                                                    */
+/*------------------------------------------------------------------------*/
+
+void ff_memfree (
+	void* mblock	/* Pointer to the memory block to free */
+)
+{
+	HEAP_Free(mblock);
+}
+
+#endif
@@ -0,0 +1,189 @@
+/*------------------------------------------------------------------------*/
+/* Streaming of a file to a USB device IN endpoint with f_forward         */
+/* for FatFs R0.08 on the SAM3S-EK USB device stack                       */
+/*------------------------------------------------------------------------*/
+/* The data goes from the sector I/O buffer of the file object, or in
+/  place from a memory mapped drive, to the endpoint (USBD_Write); the
+/  application needs no buffer and does no copy.
+/  USBD_Write keeps the data until the transfer completes, so f_forward
+/  forwards one block per transfer: the stream is busy until then.
+/  One stream runs at a time. The file and its volume must not be used
+/  until the stream completes (unless _FS_REENTRANT), since the sector
+/  I/O buffer or the window is being sent.
+*/
+
+#include "../ff.h"
+
+#if _USE_FORWARD
+
+#include "USBD.h"
+#include "workq.h"
+
+static struct {
+	FIL *fp;					/* File being streamed, 0: idle */
+	BYTE ep;					/* IN endpoint */
+	volatile BYTE busy;			/* A transfer is pending */
+	volatile BYTE status;		/* USBD status of the last transfer */
+	DWORD remain;				/* Bytes left to forward */
+	DWORD sent;					/* Bytes forwarded */
+	void (*done)(void*,FRESULT,DWORD);	/* Completion callback, 0: synchronous */
+	void *arg;					/* Argument of the callback */
+} stream;
+
+
+/*------------------------------------------------------------------------*/
+/* Transfer completion (USB interrupt, or work queue when deferred)       */
+/*------------------------------------------------------------------------*/
+
+static void usbd_resume (void *arg, uint32_t status);
+
+static void usbd_sent (
+	void *arg,
+	uint8_t status,
+	uint32_t transferred,
+	uint32_t remaining
+)
+{
+	stream.status = status;
+	stream.busy = 0;
+	if (stream.done && !WORKQ_Post(usbd_resume, 0, status)) {
+		stream.status = USBD_STATUS_ABORTED;	/* Queue full: end the stream */
+		usbd_resume(0, USBD_STATUS_ABORTED);
+	}
+}
+
+
+/*------------------------------------------------------------------------*/
+/* Stream function given to f_forward                                     */
+/*------------------------------------------------------------------------*/
+
+static UINT usbd_stream (	/* Returns number of bytes sent or stream status */
+	const BYTE *p,		/* Pointer to the data block to be sent */
+	UINT btf			/* >0: Transfer call, 0: Sense call */
+)
+{
+	if (!btf) return !stream.busy;
+
+	stream.busy = 1;
+	if (USBD_Write(stream.ep, p, btf, usbd_sent, 0) != USBD_STATUS_SUCCESS) {
+		stream.busy = 0;
+		return 0;		/* f_forward fails with FR_INT_ERR */
+	}
+	return btf;
+}
+
+
+/*------------------------------------------------------------------------*/
+/* Forward the next block, or end the stream                              */
+/*------------------------------------------------------------------------*/
+
+static void usbd_end (
+	FRESULT res
+)
+{
+	void (*done)(void*,FRESULT,DWORD) = stream.done;
+
+	stream.fp = 0;
+	if (done) done(stream.arg, res, stream.sent);
+}
+
+static void usbd_resume (
+	void *arg,
+	uint32_t status
+)
+{
+	FRESULT res;
+	UINT n;
+
+	if (status != USBD_STATUS_SUCCESS) {
+		usbd_end(FR_INT_ERR);
+		return;
+	}
+	if (!stream.remain) {
+		usbd_end(FR_OK);
+		return;
+	}
+	res = f_forward(stream.fp, usbd_stream, (UINT)stream.remain, &n);
+	stream.remain -= n;
+	stream.sent += n;
+	if (res != FR_OK)
+		usbd_end(res);
+	else if (!n)		/* End of file */
+		usbd_end(FR_OK);
+}
+
+
+/*------------------------------------------------------------------------*/
+/* Start streaming a file to an IN endpoint                               */
+/*------------------------------------------------------------------------*/
+/* Forwards btf bytes from the file pointer, or up to the end of the file.
+/  The transfer callbacks post the next blocks to the work queue (workq.h),
+/  and done is called from there with the result and the number of bytes
+/  sent.
+*/
+
+FRESULT ff_usbd_forward (
+	FIL *fp,			/* Pointer to the file object */
+	BYTE ep,			/* IN endpoint number */
+	DWORD btf,			/* Number of bytes to forward */
+	void (*done)(void*,FRESULT,DWORD),	/* Completion callback */
+	void *arg			/* Argument of the callback */
+)
+{
+	if (stream.fp) return FR_LOCKED;
+	if (!done) return FR_INT_ERR;
+
+	stream.fp = fp;
+	stream.ep = ep;
+	stream.busy = 0;
+	stream.status = USBD_STATUS_SUCCESS;
+	stream.remain = btf;
+	stream.sent = 0;
+	stream.done = done;
+	stream.arg = arg;
+	usbd_resume(0, USBD_STATUS_SUCCESS);
+	return FR_OK;
+}
+
+
+/*------------------------------------------------------------------------*/
+/* Stream a file to an IN endpoint and wait                               */
+/*------------------------------------------------------------------------*/
+
+FRESULT ff_usbd_forward_sync (
+	FIL *fp,			/* Pointer to the file object */
+	BYTE ep,			/* IN endpoint number */
+	DWORD btf,			/* Number of bytes to forward */
+	DWORD *bf			/* Pointer to number of bytes forwarded */
+)
+{
+	FRESULT res = FR_OK;
+	UINT n;
+
+	*bf = 0;
+	if (stream.fp) return FR_LOCKED;
+
+	stream.fp = fp;
+	stream.ep = ep;
+	stream.busy = 0;
+	stream.status = USBD_STATUS_SUCCESS;
+	stream.done = 0;
+	while (btf) {
+		res = f_forward(fp, usbd_stream, (UINT)btf, &n);
+		if (res != FR_OK) break;
+		if (stream.status != USBD_STATUS_SUCCESS) {
+			res = FR_INT_ERR;
+			break;
+		}
+		if (!n && !stream.busy) break;	/* End of file */
+		btf -= n;
+		*bf += n;
+	}
+	while (stream.busy);
+	if (res == FR_OK && stream.status != USBD_STATUS_SUCCESS)
+		res = FR_INT_ERR;
+	stream.fp = 0;
+	return res;
+}
+
+#endif
@@ -77,14 +77,19 @@
 #include "chip.h"
 
 #include "include/ads7843.h"
+#include "include/at24.h"
 #include "include/at45d.h"
 #include "include/at45_spi.h"
+#include "include/bench.h"
 #include "include/bitbanding.h"
 #include "include/bmp.h"
 #include "include/board_lowlevel.h"
 #include "include/board_memories.h"
+#include "include/bootseq.h"
 #include "include/clock.h"
+#include "include/dsp.h"
 #include "include/hamming.h"
+#include "include/heap.h"
 #include "include/ili9325.h"
 #include "include/frame_buffer.h"
 #include "include/iso7816_4.h"
@@ -94,8 +99,11 @@
 #include "include/lcd_font.h"
 #include "include/lcd_font10x14.h"
 #include "include/lcd_gimp_image.h"
+#include "include/lcd_raster.h"
 #include "include/led.h"
 #include "include/math.h"
+#include "include/mixer.h"
+#include "include/timebase.h"
 #include "include/timetick.h"
 #include "include/tsd.h"
 #include "include/tsd_ads7843.h"
@@ -328,6 +336,9 @@
 #define PIN_EBI_NWE                 {1 << 8,  PIOC, ID_PIOC, PIO_PERIPH_A, PIO_PULLUP}
 /** EBI NCS0 pin */
 #define PIN_EBI_NCS0                {1 << 20, PIOB, ID_PIOB, PIO_PERIPH_A, PIO_PULLUP}
+/** Base address and size of the external PSRAM, on NCS1 */
+#define BOARD_PSRAM_ADDR            0x61000000
+#define BOARD_PSRAM_SIZE            (1024 * 1024)
 /** EBI pins for PSRAM address bus */
 #define PIN_EBI_PSRAM_ADDR_BUS      {0x3f00fff, PIOC, ID_PIOC, PIO_PERIPH_A, PIO_PULLUP}
 /** EBI pins for PSRAM NBS pins */
@@ -351,6 +362,8 @@
 #define PIN_LED_1   {PIO_PC21, PIOC, ID_PIOC, PIO_OUTPUT_1, PIO_DEFAULT}
 /** LED #2 pin definition (RED). */
 #define PIN_LED_2   {PIO_PC22, PIOC, ID_PIOC, PIO_OUTPUT_1, PIO_DEFAULT}
+/** The three LEDs as a group, bit n being LED #n; lit by a low level. */
+#define PINGROUP_LEDS   PIO_GROUP( PIOC, ID_PIOC, 20, 3 )
 #endif
 
 #ifdef BOARD_REV_B
@@ -28,7 +28,7 @@
 
 # Makefile for compiling libchip
 .SUFFIXES: .o .a .c .s
-SUB_MAKEFILES=debug.mk gcc.mk iar.mk mdk.mk release.mk win.mk linux.mk sam3s-ek.mk
+SUB_MAKEFILES=debug.mk gcc.mk iar.mk mdk.mk perf.mk release.mk win.mk linux.mk sam3s-ek.mk
 
 SERIE=sam3s
 CHIP=$(SERIE)4
@@ -80,8 +80,12 @@ INCLUDES += -I$(PROJECT_BASE_PATH)/../usb/include
 ifdef DEBUG
 include debug.mk
 else
+ifdef PERF
+include perf.mk
+else
 include release.mk
 endif
+endif
 
 #-------------------------------------------------------------------------------
 # Tools
@@ -94,9 +98,14 @@ ifdef DEBUG
 OUTPUT_OBJ=debug
 OUTPUT_LIB=$(LIBNAME)_$(BOARD)_$(TOOLCHAIN)_dbg.a
 else
+ifdef PERF
+OUTPUT_OBJ=perf
+OUTPUT_LIB=$(LIBNAME)_$(BOARD)_$(TOOLCHAIN)_perf.a
+else
 OUTPUT_OBJ=release
 OUTPUT_LIB=$(LIBNAME)_$(BOARD)_$(TOOLCHAIN)_rel.a
 endif
+endif
 
 OUTPUT_PATH=$(OUTPUT_OBJ)_$(BOARD)
 
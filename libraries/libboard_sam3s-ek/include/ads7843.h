@@ -42,6 +42,13 @@
 
 #include <stdint.h>
 
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Maximum number of X/Y samples acquired in one chained transfer */
+#define ADS7843_MAX_SAMPLES    8
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -52,4 +59,12 @@ extern void ADS7843_Reset( void ) ;
 
 extern void ADS7843_GetPosition( uint32_t *px_pos, uint32_t *py_pos ) ;
 
+extern void ADS7843_StartSamples( uint32_t dwCount ) ;
+
+extern uint32_t ADS7843_IsSamplesReady( void ) ;
+
+extern uint32_t ADS7843_GetSamples( uint16_t *pwX, uint16_t *pwY ) ;
+
+extern uint32_t ADS7843_ReadSamples( uint16_t *pwX, uint16_t *pwY, uint32_t dwCount ) ;
+
 #endif /* #ifndef _ADS7843_H */
@@ -0,0 +1,142 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+  * \file
+  *
+  * Interface of the AT24 serial EEPROM driver.
+  *
+  */
+
+#ifndef _AT24_
+#define _AT24_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "chip.h"
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** The TWI driver is busy with another transfer. */
+#define AT24_ERROR_BUSY         TWID_ERROR_BUSY
+/** The EEPROM did not acknowledge a transfer. */
+#define AT24_ERROR_NACK         TWID_ERROR_NACK
+/** The EEPROM did not complete its write cycle in time. */
+#define AT24_ERROR_TIMEOUT      3
+
+/** Maximum number of acknowledge polls after a page write; about 30 us
+    each at 400 kHz, the default covers the 10 ms write cycle with margin. */
+#ifndef AT24_MAX_POLLS
+#define AT24_MAX_POLLS          1000
+#endif
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Completion callback of an AT24 operation, invoked from the TWI interrupt.
+    ASYNC_StatusCallback() completes an AsyncRequest given as argument. */
+typedef void (*At24Callback)( uint8_t status, void *pArgument ) ;
+
+/** \brief AT24 driver instance. */
+typedef struct _At24
+{
+    /** TWI driver used to access the EEPROM. */
+    Twid *pTwid ;
+    /** Slave address of the EEPROM. */
+    uint8_t slave ;
+    /** Internal address size in bytes (1 or 2). */
+    uint8_t isize ;
+    /** Page size in bytes, a power of 2. */
+    uint16_t pageSize ;
+    /** Size of the EEPROM in bytes. */
+    uint32_t size ;
+    /** Optional RAM copy of the first shadowSize bytes of the EEPROM. */
+    uint8_t *pShadow ;
+    /** Size of the RAM copy in bytes. */
+    uint32_t shadowSize ;
+    /** Set once the RAM copy has been loaded. */
+    uint8_t shadowValid ;
+    /** Current operation (internal). */
+    volatile uint8_t state ;
+    /** Status of the last operation. */
+    volatile uint8_t status ;
+    /** Byte read by the acknowledge polls. */
+    uint8_t probe ;
+    /** Number of acknowledge polls of the current page. */
+    uint16_t polls ;
+    /** EEPROM address of the next burst. */
+    uint32_t address ;
+    /** Data of the next burst. */
+    uint8_t *pData ;
+    /** Number of bytes left to transfer. */
+    uint32_t remaining ;
+    /** Completion callback of the current operation. */
+    At24Callback callback ;
+    /** Argument of the completion callback. */
+    void *pArgument ;
+    /** Segment of the current burst or poll. */
+    TwidSegment segment ;
+    /** Transaction of the current burst or poll. */
+    TwidTransaction transaction ;
+} At24 ;
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+extern void AT24_Initialize( At24 *pAt24, Twid *pTwid, uint8_t slave, uint8_t isize,
+                             uint16_t pageSize, uint32_t size,
+                             uint8_t *pShadow, uint32_t shadowSize ) ;
+
+extern uint8_t AT24_Read( At24 *pAt24, uint32_t address, uint8_t *pData, uint32_t num,
+                          At24Callback callback, void *pArgument ) ;
+
+extern uint8_t AT24_Write( At24 *pAt24, uint32_t address, const uint8_t *pData, uint32_t num,
+                           At24Callback callback, void *pArgument ) ;
+
+extern uint8_t AT24_LoadShadow( At24 *pAt24, At24Callback callback, void *pArgument ) ;
+
+extern uint32_t AT24_IsBusy( At24 *pAt24 ) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _AT24_ */
@@ -53,10 +53,24 @@ extern uint32_t AT45D_GetStatus( At45* pAt45 ) ;
 
 extern void AT45D_Read( At45* pAt45, uint8_t* pucBuffer, uint32_t dwSize, uint32_t dwAddress ) ;
 
+extern void AT45D_ReadFast( At45* pAt45, uint8_t* pucBuffer, uint32_t dwSize, uint32_t dwAddress ) ;
+
 extern void AT45D_Write( At45* pAt45, uint8_t *pucBuffer, uint32_t dwSize, uint32_t dwAddress ) ;
 
+extern void AT45D_WriteBuffer( At45* pAt45, uint8_t ucBuffer, const uint8_t* pucBuffer, uint32_t dwSize, uint32_t dwOffset ) ;
+
+extern void AT45D_LoadBuffer( At45* pAt45, uint8_t ucBuffer, uint32_t dwAddress ) ;
+
+extern void AT45D_ProgramBuffer( At45* pAt45, uint8_t ucBuffer, uint32_t dwAddress, uint8_t ucErase ) ;
+
+extern void AT45D_WritePipelined( At45* pAt45, const uint8_t* pucBuffer, uint32_t dwSize, uint32_t dwAddress ) ;
+
 extern void AT45D_Erase( At45* pAt45, uint32_t dwAddress ) ;
 
+extern void AT45D_EraseBlock( At45* pAt45, uint32_t dwAddress ) ;
+
+extern uint32_t AT45D_IsBinaryPage( At45* pAt45 ) ;
+
 extern void AT45D_BinaryPage( At45* pAt45 ) ;
 
 #endif /* #ifndef _AT45D_ */
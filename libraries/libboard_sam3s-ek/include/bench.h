@@ -0,0 +1,169 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ *  \file
+ *
+ *  \par Purpose
+ *
+ *  Benchmark harness: timing, warm-up, repetitions, percentile statistics and
+ *  machine-readable results, shared by the benchmark examples.
+ *
+ *  A benchmark case is a function doing one iteration of the measured work
+ *  and returning the number of bytes it processed (0 when a throughput makes
+ *  no sense). BENCH_RunCase() calls it wWarmup times untimed, then wRepeat
+ *  times timed, and computes the minimum, median, 90th and 99th percentiles,
+ *  maximum and mean of the iteration times, and the throughput.
+ *
+ *  The times are taken with the DWT cycle counter (BENCH_TIMER_CYCLES, in
+ *  core cycles, default) or with the TC timebase of timebase.h
+ *  (BENCH_TIMER_US, in microseconds, for iterations longer than the 32-bit
+ *  cycle counter can hold).
+ *
+ *  Each result is written as one JSON object per line (JSON lines), e.g.
+ *  \code
+ *  {"bench":"fatfs.read.4k","tag":"2.0","unit":"cycles","n":100,"min":51230,
+ *   "p50":51304,"p90":51411,"p99":52007,"max":52007,"mean":51330,"bytes":4096,"kbps":4987}
+ *  \endcode
+ *  preceded by a {"meta":...} line at the start of BENCH_RunAll(). The lines
+ *  go to the console by default, or to any stream set with BENCH_SetOutput()
+ *  (e.g. a function queuing them to CDCDSerialDriver_Write()). The host
+ *  script bench.py collects the lines and compares two runs.
+ *
+ *  \par Usage
+ *
+ *  -# Declare the cases with BENCH_REGISTER() at file scope. With GCC they
+ *     are registered before main() by a constructor; with the other
+ *     compilers call BENCH_Register( &benchCase_<name> ) from main().
+ *  -# Optionally call BENCH_SetTimer() and BENCH_SetOutput().
+ *  -# Call BENCH_RunAll() with a tag identifying the firmware version, or
+ *     BENCH_RunCase() for a single case.
+ *  -# Use BENCH_WriteMetric() for the figures measured elsewhere (e.g. by the
+ *     USB host), so that they end up in the same result stream.
+ *
+ */
+
+#ifndef _BENCH_
+#define _BENCH_
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *         Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Maximum number of timed iterations of a case (samples kept for the percentiles) */
+#define BENCH_MAX_SAMPLES       256
+
+/** Size of a result line, terminating zero included */
+#define BENCH_LINE_SIZE         256
+
+/** Time sources */
+#define BENCH_TIMER_CYCLES      0
+#define BENCH_TIMER_US          1
+
+/** Defines and registers a benchmark case; the case structure is benchCase_<name> */
+#if defined ( __GNUC__ ) && !defined ( __ICCARM__ )
+#define BENCH_REGISTER( name, fRun, pArg, wWarmup, wRepeat ) \
+    BenchCase benchCase_##name = { #name, fRun, pArg, wWarmup, wRepeat, 0 } ; \
+    static void __attribute__ ((constructor)) _BenchRegister_##name( void ) \
+    { \
+        BENCH_Register( &benchCase_##name ) ; \
+    }
+#else
+#define BENCH_REGISTER( name, fRun, pArg, wWarmup, wRepeat ) \
+    BenchCase benchCase_##name = { #name, fRun, pArg, wWarmup, wRepeat, 0 }
+#endif
+
+/*----------------------------------------------------------------------------
+ *         Types
+ *----------------------------------------------------------------------------*/
+
+/** Does one iteration of a case, returns the bytes processed */
+typedef uint32_t (*BenchFunction)( void* pArg ) ;
+
+/** Writes a result line (zero terminated, end of line included) */
+typedef void (*BenchWriteFunction)( const char* pszLine, uint32_t dwLength, void* pArg ) ;
+
+/** Benchmark case */
+typedef struct _BenchCase
+{
+    /** Name, reported in the "bench" field */
+    const char* pszName ;
+    /** Iteration function */
+    BenchFunction fRun ;
+    /** Argument of the iteration function */
+    void* pArg ;
+    /** Untimed iterations before the measure */
+    uint16_t wWarmup ;
+    /** Timed iterations, at most BENCH_MAX_SAMPLES */
+    uint16_t wRepeat ;
+    /** Next registered case */
+    struct _BenchCase* pNext ;
+} BenchCase ;
+
+/** Statistics of a case, in timer units */
+typedef struct _BenchResult
+{
+    uint32_t dwCount ;
+    uint32_t dwMin ;
+    uint32_t dwP50 ;
+    uint32_t dwP90 ;
+    uint32_t dwP99 ;
+    uint32_t dwMax ;
+    uint32_t dwMean ;
+    /** Bytes processed by one iteration (last one) */
+    uint32_t dwBytes ;
+    /** Throughput over the timed iterations, in KB/s, 0 when no bytes */
+    uint32_t dwKBs ;
+} BenchResult ;
+
+/*----------------------------------------------------------------------------
+ *         Global functions
+ *----------------------------------------------------------------------------*/
+
+extern void BENCH_Register( BenchCase* pCase ) ;
+
+extern void BENCH_SetTimer( uint8_t ucTimer, uint32_t dwMck ) ;
+
+extern void BENCH_SetOutput( BenchWriteFunction fWrite, void* pArg ) ;
+
+extern uint32_t BENCH_GetTime( void ) ;
+
+extern void BENCH_RunCase( BenchCase* pCase, const char* pszTag, BenchResult* pResult ) ;
+
+extern uint32_t BENCH_RunAll( const char* pszTag ) ;
+
+extern void BENCH_WriteMetric( const char* pszBench, const char* pszTag, const char* pszMetric, uint32_t dwValue, const char* pszUnit ) ;
+
+#endif /* _BENCH_ */
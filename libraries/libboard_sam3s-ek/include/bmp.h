@@ -90,6 +90,51 @@ typedef struct _BMPHeader
 
 #pragma pack()
 
+/** Describe the BMP palette */
+typedef struct _BMPPaletteEntry
+{
+    /** Blue value */
+    uint8_t b;
+    /** Green value */
+    uint8_t g;
+    /** Red value */
+    uint8_t r;
+    /** Filler character value */
+    uint8_t filler;
+} BMPPaletteEntry ;
+
+/** Rows decoded by BMP_StreamReadRow() as R, G, B bytes */
+#define BMP_ORDER_RGB   0
+/** Rows decoded by BMP_StreamReadRow() as B, G, R bytes */
+#define BMP_ORDER_BGR   1
+
+/** Read up to dwSize bytes of a BMP file, returns the number of bytes read */
+typedef uint32_t (*BMP_ReadFunc)( void* pContext, uint8_t* pBuffer, uint32_t dwSize ) ;
+
+/** Row by row BMP decoder, reading the file through a small buffer */
+typedef struct _BMPStream
+{
+    /** File header */
+    BMPHeader header ;
+    /** File access */
+    BMP_ReadFunc Read ;
+    void* pContext ;
+    /** Read buffer between the file and the decoded rows */
+    uint8_t* pBuffer ;
+    uint32_t dwBufferSize ;
+    uint32_t dwBufferStart ;
+    uint32_t dwBufferCount ;
+    /** Image height in pixels, rows stored top first if ucTopDown */
+    uint32_t dwHeight ;
+    uint8_t ucTopDown ;
+    /** Output byte order, BMP_ORDER_RGB or BMP_ORDER_BGR */
+    uint8_t ucOrder ;
+    /** Number of rows already decoded */
+    uint32_t dwRow ;
+    /** Palette of 8 bits images */
+    BMPPaletteEntry palette[256] ;
+} BMPStream ;
+
 /*------------------------------------------------------------------------------
  *         Exported functions
  *------------------------------------------------------------------------------*/
@@ -99,6 +144,8 @@ extern uint8_t BMP_Decode( void *file, uint8_t *buffer, uint32_t width, uint32_t
 extern void WriteBMPheader( uint32_t* pAddressHeader, uint32_t  bmpHSize, uint32_t  bmpVSize, uint8_t nbByte_Pixels );
 extern void BMP_displayHeader(uint32_t* pAddressHeader);
 extern void RGB565toBGR555( uint8_t *fileSource, uint8_t *fileDestination, uint32_t width, uint32_t height, uint8_t bpp );
+extern uint8_t BMP_StreamOpen( BMPStream *pStream, BMP_ReadFunc Read, void *pContext, uint8_t *pBuffer, uint32_t dwBufferSize, uint8_t ucOrder );
+extern uint8_t BMP_StreamReadRow( BMPStream *pStream, uint8_t *pRow, uint32_t *pdwY );
 
 #endif //#ifndef BMP_H
 
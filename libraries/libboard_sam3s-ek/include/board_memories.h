@@ -37,6 +37,38 @@
 #ifndef BOARD_MEMORIES_H
 #define BOARD_MEMORIES_H
 
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * Places a variable in the external PSRAM (.psram section), for the large
+ * buffers the libraries take from the application: sam-gui tiles
+ * (DBE_TILE_Initialize()), libjpeg arena (jpeg_arena_init()), MSD LUN cache,
+ * NAND translation tables, FreeRTOS heap (configHEAP_BASE_ADDRESS). The
+ * internal SRAM is then kept for the stacks and the latency critical data.
+ * The section is not initialized by the startup code: its content is
+ * undefined, and it can only be accessed after BOARD_ConfigurePSRAM().
+ */
+#if defined ( __ICCARM__ )
+#define BOARD_PSRAM_SECTION _Pragma("location=\".psram\"") __no_init
+#else
+#define BOARD_PSRAM_SECTION __attribute__ ((section (".psram")))
+#endif
+
+/**
+ * Places a variable in the internal SRAM .noinit section, which the startup
+ * code does not clear: for the large buffers written before being read (MSD
+ * FIFO, NAND page buffers, frame strips), whose zeroing would only delay
+ * main(). The content is undefined at reset; the owner initializes what it
+ * needs, when it first uses the buffer.
+ */
+#if defined ( __ICCARM__ )
+#define BOARD_NOINIT_SECTION __no_init
+#else
+#define BOARD_NOINIT_SECTION __attribute__ ((section (".noinit")))
+#endif
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -45,5 +77,8 @@ extern void BOARD_ConfigureNandFlash( Smc* pSmc ) ;
 extern void BOARD_ConfigureNorFlash( Smc* pSmc ) ;
 extern void BOARD_ConfigurePSRAM( Smc* pSmc ) ;
 
+extern void* BOARD_PsramAlloc( uint32_t dwSize ) ;
+extern uint32_t BOARD_PsramGetFreeSize( void ) ;
+
 #endif /* #ifndef BOARD_MEMORIES_H */
 
@@ -0,0 +1,134 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ *  \file
+ *
+ *  \par Purpose
+ *
+ *  Cooperative boot sequencer, interleaving the initializations that spend
+ *  most of their time waiting (LCD power ramp, SD card power up polling...).
+ *
+ *  Each initialization is split into steps. A step does the work that does
+ *  not wait, then returns the delay in ms before the next step can run, so
+ *  that the steps of the other initializations run meanwhile. A step returns
+ *  BOOTSEQ_DONE once the initialization is complete, or BOOTSEQ_FAILED.
+ *  The progress of a task is kept in a state word, 0 at start, that belongs
+ *  to the step function.
+ *
+ *  \par Usage
+ *
+ *  -# Configure the System Tick with TimeTick_Configure(), the delays are
+ *     counted with GetTickCount().
+ *  -# Add the tasks with BOOTSEQ_Add(). A task can wait for another one to be
+ *     done before its first step, e.g. a file system mount after the SD card
+ *     init.
+ *  -# Use BOOTSEQ_Run() to run the steps until a given task is done, e.g. the
+ *     LCD to draw the first frame, then call BOOTSEQ_Poll() from the main loop
+ *     to complete the other tasks in the background.
+ *  -# BOOTSEQ_DisplayTimings() reports the start and end ticks of the tasks.
+ *
+ */
+
+#ifndef _BOOTSEQ_
+#define _BOOTSEQ_
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *         Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Step return value: the initialization is complete */
+#define BOOTSEQ_DONE            0xFFFFFFFFu
+/** Step return value: the initialization failed, the tasks waiting for it are not run */
+#define BOOTSEQ_FAILED          0xFFFFFFFEu
+/** Longest delay a step can ask for, in ms */
+#define BOOTSEQ_MAX_DELAY       0xFFFF0000u
+
+/** Task is waiting for its first step */
+#define BOOTSEQ_TASK_PENDING    0
+/** Task has run its first step */
+#define BOOTSEQ_TASK_RUNNING    1
+/** Task is complete */
+#define BOOTSEQ_TASK_DONE       2
+/** Task, or the task it waited for, failed */
+#define BOOTSEQ_TASK_FAILED     3
+
+/**
+ * Runs the next step of an initialization.
+ * \param pArg      Argument given to BOOTSEQ_Add().
+ * \param pdwState  Progress of the task, 0 at start.
+ * \return Delay in ms before the next step, BOOTSEQ_DONE or BOOTSEQ_FAILED.
+ */
+typedef uint32_t (*BootSeqStep)( void* pArg, uint32_t* pdwState ) ;
+
+/** Boot sequencer task, provided by the caller and kept until the task ends */
+typedef struct _BootSeqTask
+{
+    /** Name in the timing report */
+    const char* pszName ;
+    /** Step function */
+    BootSeqStep fStep ;
+    /** Step function argument */
+    void* pArg ;
+    /** Task to be done before the first step, NULL for none */
+    struct _BootSeqTask* pAfter ;
+    /** Next task in the sequencer list */
+    struct _BootSeqTask* pNext ;
+    /** Progress of the task, owned by the step function */
+    uint32_t dwState ;
+    /** BOOTSEQ_TASK_xxx */
+    uint32_t dwStatus ;
+    /** Tick of the next step */
+    uint32_t dwWake ;
+    /** Ticks of the first step and of the end of the task */
+    uint32_t dwStart ;
+    uint32_t dwEnd ;
+} BootSeqTask ;
+
+/*----------------------------------------------------------------------------
+ *         Global functions
+ *----------------------------------------------------------------------------*/
+
+extern void BOOTSEQ_Add( BootSeqTask* pTask, const char* pszName, BootSeqStep fStep, void* pArg, BootSeqTask* pAfter ) ;
+
+extern uint32_t BOOTSEQ_Poll( void ) ;
+
+extern uint32_t BOOTSEQ_Run( BootSeqTask* pTask ) ;
+
+extern uint32_t BOOTSEQ_GetStatus( const BootSeqTask* pTask ) ;
+
+extern void BOOTSEQ_DisplayTimings( void ) ;
+
+#endif /* _BOOTSEQ_ */
@@ -27,6 +27,36 @@
  * ----------------------------------------------------------------------------
  */
 
+/**
+ *  \file
+ *
+ *  \par Purpose
+ *
+ *  PMC clock configurations, clock change notifications and a frequency
+ *  governor.
+ *
+ *  The configurations are ordered by increasing MCK. CLOCK_SetConfig() sets
+ *  the flash wait states for the faster of the two clocks around the switch,
+ *  then reloads the SysTick (the tick count is kept) and the DBGU baud rate.
+ *  The drivers with clock dependent dividers register a ClockNotifier: the
+ *  callback is called with CLOCK_NOTIFY_PRE_CHANGE before the switch, to
+ *  stop or drain a transfer, and with CLOCK_NOTIFY_POST_CHANGE after it, to
+ *  compute the dividers again for the new MCK.
+ *
+ *  \par Usage of the governor
+ *
+ *  -# Start it with CLOCK_GovernorStart(), giving the idle configuration and
+ *     how long the clock stays up after the last load went away.
+ *  -# Each load source (USB transfer, JPEG decode...) calls
+ *     CLOCK_GovernorRequest() with the configuration it needs, which raises
+ *     MCK at once if needed, and CLOCK_GovernorRelease() when it is done.
+ *  -# Call CLOCK_GovernorPoll() from the main loop, it lowers MCK to what
+ *     the remaining loads need once the hold time has elapsed.
+ *
+ *  The clock is switched and the notifiers are called in the context of the
+ *  caller, so the governor functions are not to be called from interrupts.
+ */
+
 #ifndef _CLOCK_
 #define _CLOCK_
 
@@ -36,6 +66,42 @@
 
 #include <stdint.h>
 
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Notification before the clock switch. */
+#define CLOCK_NOTIFY_PRE_CHANGE     0
+/** Notification after the clock switch. */
+#define CLOCK_NOTIFY_POST_CHANGE    1
+
+/** Number of governor clients. */
+#define CLOCK_GOV_CLIENTS           8
+/** Governor client of the USB device stack. */
+#define CLOCK_GOV_CLIENT_USB        0
+/** Governor client of the JPEG codec. */
+#define CLOCK_GOV_CLIENT_JPEG       1
+/** First governor client free for the application. */
+#define CLOCK_GOV_CLIENT_USER       2
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Clock change callback, the clocks are given in Hz. */
+typedef void (*ClockNotifyCallback)( uint32_t dwEvent, uint32_t dwOldMck, uint32_t dwNewMck, void* pArg ) ;
+
+/** Clock change notifier; the structure must stay valid while registered. */
+typedef struct _ClockNotifier
+{
+    /** Function called around each clock change. */
+    ClockNotifyCallback fCallback ;
+    /** Argument of the callback. */
+    void* pArg ;
+    /** Next registered notifier. */
+    struct _ClockNotifier* pNext ;
+} ClockNotifier ;
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -50,5 +116,23 @@ extern uint16_t CLOCK_GetCurrMCK( void ) ;
 
 extern uint16_t CLOCK_GetCurrPCK( void ) ;
 
+extern uint8_t CLOCK_GetCurrConfig( void ) ;
+
+extern uint8_t CLOCK_GetNbConfig( void ) ;
+
+extern void CLOCK_RegisterNotifier( ClockNotifier* pNotifier ) ;
+
+extern void CLOCK_UnregisterNotifier( ClockNotifier* pNotifier ) ;
+
+extern void CLOCK_GovernorStart( uint8_t ucIdleConfig, uint32_t dwHoldMs ) ;
+
+extern void CLOCK_GovernorStop( void ) ;
+
+extern void CLOCK_GovernorRequest( uint8_t ucClient, uint8_t ucConfig ) ;
+
+extern void CLOCK_GovernorRelease( uint8_t ucClient ) ;
+
+extern void CLOCK_GovernorPoll( void ) ;
+
 #endif /* #ifndef _CLOCK_ */
 
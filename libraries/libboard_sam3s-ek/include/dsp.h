@@ -0,0 +1,127 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Interface of the fixed-point DSP kernels.
+ *
+ * Block processing in Q15 and Q31 for the sample pipelines fed by the ADC
+ * stream: FIR filter, cascade of biquads, radix-4 complex FFT and block
+ * statistics (RMS, peak). Products are accumulated on 64 bits (SMLAL) and
+ * results saturated, the inner loops are unrolled for the Cortex-M3.
+ *
+ * DSP_Benchmark(), which prints the cost of the kernels on the console, is
+ * only built for bench applications defining DSP_BENCHMARK.
+ *
+ */
+
+#ifndef _DSP_
+#define _DSP_
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+#ifdef DSP_BENCHMARK
+/** Size of the work area of DSP_Benchmark(), in halfwords */
+#define DSP_BENCH_WORK_SIZE     3072
+#endif
+
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+/** \brief Q15 FIR filter */
+typedef struct _DspFirQ15
+{
+    /** Coefficients in Q15, in time order */
+    const int16_t* psCoeffs ;
+    /** State, dwTaps + dwBlock - 1 samples */
+    int16_t* psState ;
+    /** Number of taps */
+    uint32_t dwTaps ;
+} DspFirQ15 ;
+
+/** \brief Cascade of Q31 biquads, direct form I */
+typedef struct _DspBiquadQ31
+{
+    /** b0, b1, b2, a1, a2 of each stage in Q31, divided by 2^bPostShift;
+        a1 and a2 are the negated feedback coefficients, added to the sum */
+    const int32_t* plCoeffs ;
+    /** State, x[n-1], x[n-2], y[n-1], y[n-2] of each stage */
+    int32_t* plState ;
+    /** Number of stages */
+    uint32_t dwStages ;
+    /** Scaling of the coefficients, for gains of 1 or more */
+    uint8_t bPostShift ;
+} DspBiquadQ31 ;
+
+/** \brief Radix-4 complex Q15 FFT */
+typedef struct _DspFftQ15
+{
+    /** Twiddles, cos and sin interleaved, 3/4 of dwSize entries */
+    int16_t* psTwiddles ;
+    /** Number of points, a power of 4 */
+    uint32_t dwSize ;
+} DspFftQ15 ;
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+extern void DSP_AdcToQ15( const uint16_t* pwIn, int16_t* psOut, uint32_t dwCount, uint8_t bBits ) ;
+extern void DSP_Q15ToQ31( const int16_t* psIn, int32_t* plOut, uint32_t dwCount ) ;
+extern void DSP_Q31ToQ15( const int32_t* plIn, int16_t* psOut, uint32_t dwCount ) ;
+
+extern void DSP_FirQ15Initialize( DspFirQ15* pFir, const int16_t* psCoeffs, uint32_t dwTaps, int16_t* psState ) ;
+extern void DSP_FirQ15( DspFirQ15* pFir, const int16_t* psIn, int16_t* psOut, uint32_t dwCount ) ;
+
+extern void DSP_BiquadQ31Initialize( DspBiquadQ31* pBiquad, const int32_t* plCoeffs, uint32_t dwStages, uint8_t bPostShift, int32_t* plState ) ;
+extern void DSP_BiquadQ31( DspBiquadQ31* pBiquad, const int32_t* plIn, int32_t* plOut, uint32_t dwCount ) ;
+
+extern uint32_t DSP_FftQ15Initialize( DspFftQ15* pFft, uint32_t dwSize, int16_t* psTwiddles ) ;
+extern void DSP_FftQ15( DspFftQ15* pFft, int16_t* psData ) ;
+extern void DSP_MagnitudeSquaredQ15( const int16_t* psData, uint32_t* pdwOut, uint32_t dwCount ) ;
+
+extern int16_t DSP_RmsQ15( const int16_t* psIn, uint32_t dwCount ) ;
+extern int16_t DSP_PeakQ15( const int16_t* psIn, uint32_t dwCount, uint32_t* pdwIndex ) ;
+extern int32_t DSP_MeanQ15( const int16_t* psIn, uint32_t dwCount ) ;
+
+#ifdef DSP_BENCHMARK
+extern void DSP_Benchmark( int16_t* psWork ) ;
+#endif
+
+#endif /* #ifndef _DSP_ */
@@ -0,0 +1,109 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Interface of the multi-region heap.
+ *
+ * HEAP_Alloc() takes a buffer from the internal SRAM heap (newlib malloc()
+ * over _sbrk(), which stops before the main stack) or from an arena in the
+ * external PSRAM, according to its flags. A buffer is given back with
+ * HEAP_Free() whatever its region. The libraries are steered to a region
+ * without change: the libjpeg arena (jpeg_arena_init()), the sam-gui tiles
+ * (DBE_TILE_Initialize()) and the FatFs LFN buffers (ff_memalloc()) take
+ * their memory from HEAP_Alloc().
+ *
+ * The PSRAM arena is a first-fit free list with coalescing, carved out of
+ * BOARD_PsramAlloc() by HEAP_PsramInitialize(), after BOARD_ConfigurePSRAM().
+ * Until then, the PSRAM allocations fail. The functions mask the interrupts
+ * while they update the arena, but malloc() is not reentrant: the SRAM
+ * allocations shall not be done from an interrupt.
+ *
+ */
+
+#ifndef _HEAP_
+#define _HEAP_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Allocation flags: regions the buffer may come from */
+#define HEAP_SRAM           (1u << 0)
+#define HEAP_PSRAM          (1u << 1)
+#define HEAP_ANY            (HEAP_SRAM | HEAP_PSRAM)
+/** With HEAP_ANY, try the PSRAM before the SRAM, for the bulk buffers */
+#define HEAP_PSRAM_FIRST    (1u << 2)
+
+/** Region identifiers, returned by HEAP_GetRegion() */
+#define HEAP_REGION_NONE    0
+#define HEAP_REGION_SRAM    1
+#define HEAP_REGION_PSRAM   2
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** \brief Statistics of the PSRAM arena. */
+typedef struct _HeapStats
+{
+    /** Size of the arena, in bytes */
+    uint32_t dwSize ;
+    /** Bytes allocated, block headers included */
+    uint32_t dwUsed ;
+    /** Highest dwUsed */
+    uint32_t dwMaxUsed ;
+    /** Largest free block, in bytes */
+    uint32_t dwLargestFree ;
+    /** Number of allocations which failed */
+    uint32_t dwFailures ;
+} HeapStats ;
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern uint32_t HEAP_PsramInitialize( uint32_t dwSize ) ;
+
+extern void* HEAP_Alloc( uint32_t dwSize, uint32_t dwFlags ) ;
+
+extern void HEAP_Free( void* pBuffer ) ;
+
+extern uint32_t HEAP_GetRegion( const void* pBuffer ) ;
+
+extern void HEAP_GetPsramStats( HeapStats* pStats ) ;
+
+#endif /* #ifndef _HEAP_ */
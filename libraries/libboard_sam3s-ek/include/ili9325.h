@@ -155,8 +155,11 @@ typedef volatile uint8_t REG8;
  *----------------------------------------------------------------------------*/
 extern void LCD_WriteRAM_Prepare( void );
 extern  void LCD_WriteRAM( LcdColor_t dwColor );
+extern void LCD_WriteRAMFill( LcdColor_t dwColor, uint32_t dwCount );
+extern void LCD_WriteRAMPacked( const uint8_t *pucTriplets, uint32_t dwCount );
 extern void LCD_ReadRAM_Prepare( void );
 extern uint32_t LCD_ReadRAM( void );
+extern uint32_t LCD_InitializeStep( uint32_t* pdwState );
 extern uint32_t LCD_Initialize( void );
 extern void LCD_On( void );
 extern void LCD_Off( void );
@@ -173,6 +176,7 @@ extern uint32_t LCD_DrawPixel( uint32_t x, uint32_t y );
 extern void LCD_TestPattern( uint32_t dwRGB );
 extern uint32_t LCD_DrawFilledRectangle( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2 );
 extern uint32_t LCD_DrawPicture( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2, const LcdColor_t *pBuffer );
+extern uint32_t LCD_DrawPicture565( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2, const uint16_t *pwBuffer );
 extern uint32_t LCD_DrawLine ( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2 );
 extern uint32_t LCD_DrawCircle( uint32_t dwX, uint32_t dwY, uint32_t dwR );
 extern uint32_t LCD_DrawFilledCircle( uint32_t dwX, uint32_t dwY, uint32_t dwRadius);
@@ -39,6 +39,9 @@
  *  -# ISO7816_Init
  *  -# ISO7816_IccPowerOff
  *  -# ISO7816_XfrBlockTPDU_T0
+ *  -# ISO7816_XfrTPDU_T0_Start, ISO7816_Handler, ISO7816_XfrAbort
+ *  -# ISO7816_ParseATR, ISO7816_PPS
+ *  -# ISO7816_T1_Init, ISO7816_T1_SetIfsd, ISO7816_XfrBlockAPDU_T1
  *  -# ISO7816_Escape
  *  -# ISO7816_RestartClock
  *  -# ISO7816_StopClock
@@ -64,6 +67,86 @@
 /** NULL byte to restart byte procedure */
 #define ISO_NULL_VAL            0x60
 
+/** Asynchronous TPDU status: exchange completed, status words available */
+#define ISO7816_STATUS_SUCCESS  0
+/** Asynchronous TPDU status: the card did not answer within the WWT */
+#define ISO7816_STATUS_TIMEOUT  1
+/** Asynchronous TPDU status: character repetitions exhausted, or unexpected
+    procedure byte */
+#define ISO7816_STATUS_ERROR    2
+/** Asynchronous TPDU status: exchange aborted by ISO7816_XfrAbort() */
+#define ISO7816_STATUS_ABORTED  3
+
+/** Work waiting time in etu for the default WI of 10 (960 x WI x Di) */
+#define ISO7816_WWT_ETU         9600
+
+/** Protocol numbers, as in the TD bytes of the ATR and in PPS0 */
+#define ISO7816_PROTOCOL_T0     0
+#define ISO7816_PROTOCOL_T1     1
+
+/** Default Fi/Di (TA1) after a reset: Fi = 372, Di = 1 */
+#define ISO7816_TA1_DEFAULT     0x11
+
+/** Default information field size of T=1 */
+#define ISO7816_T1_IFS_DEFAULT  32
+/** Maximum information field size of T=1 */
+#define ISO7816_T1_IFS_MAX      254
+/** Number of times an erroneous T=1 block is asked again before giving up */
+#define ISO7816_T1_RETRIES      3
+
+/*------------------------------------------------------------------------------
+ * Types
+ *----------------------------------------------------------------------------*/
+
+/** Callback invoked (from the USART interrupt) when a TPDU exchange ends */
+typedef void (*Iso7816Callback)( uint8_t bStatus, void *pArgument );
+
+/**
+ * T=0 TPDU exchanged by the USART PDC and interrupts: the header, the data
+ * and the received bytes are moved by the PDC, only the procedure bytes are
+ * handled by the interrupt handler.
+ */
+typedef struct _Iso7816Tpdu
+{
+    /** CLA INS P1 P2 P3 */
+    uint8_t abHeader[5];
+    /** 1 if the data goes from the card to the reader (case 2) */
+    uint8_t bReceive;
+    /** Status words SW1 SW2 returned by the card */
+    uint8_t abSW[2];
+    /** Data to send to the card, or buffer for the data from the card */
+    uint8_t *pData;
+    /** Number of data bytes to exchange (up to 256) */
+    uint16_t wLength;
+    /** Number of data bytes exchanged */
+    uint16_t wTransferred;
+    /** Completion callback */
+    Iso7816Callback fCallback;
+    /** Completion callback argument */
+    void *pArgument;
+} Iso7816Tpdu;
+
+/** Interface parameters announced by the card in its ATR */
+typedef struct _Iso7816Params
+{
+    /** TA1: Fi in the high nibble, Di in the low nibble */
+    uint8_t bTA1;
+    /** Bit n set if protocol T=n is offered */
+    uint8_t bProtocols;
+    /** 1 if TA2 is present: the card is in specific mode, no PPS */
+    uint8_t bSpecific;
+    /** TC1: extra guard time N in etu */
+    uint8_t bN;
+    /** T=1 information field size of the card (IFSC) */
+    uint8_t bIfsc;
+    /** T=1 character waiting time integer */
+    uint8_t bCwi;
+    /** T=1 block waiting time integer */
+    uint8_t bBwi;
+    /** 1 if the card asks for a CRC instead of the LRC (not supported) */
+    uint8_t bCrc;
+} Iso7816Params;
+
 /*------------------------------------------------------------------------------
  *         Exported functions
  *----------------------------------------------------------------------------*/
@@ -72,6 +155,10 @@ extern void ISO7816_IccPowerOff(void);
 extern uint16_t ISO7816_XfrBlockTPDU_T0(const uint8_t *pAPDU,
                                         uint8_t *pMessage,
                                         uint16_t wLength );
+extern uint8_t ISO7816_XfrTPDU_T0_Start( Iso7816Tpdu *pTpdu );
+extern void ISO7816_XfrAbort( void );
+extern uint8_t ISO7816_IsXfrBusy( void );
+extern void ISO7816_Handler( void );
 extern void ISO7816_Escape( void );
 extern void ISO7816_RestartClock(void);
 extern void ISO7816_StopClock( void );
@@ -82,6 +169,13 @@ extern uint8_t ISO7816_StatusReset( void );
 extern void ISO7816_cold_reset( void );
 extern void ISO7816_warm_reset( void );
 extern void ISO7816_Decode_ATR( uint8_t* pAtr );
+extern void ISO7816_ParseATR( const uint8_t* pAtr, Iso7816Params* pParams );
+extern uint8_t ISO7816_PPS( uint8_t bProtocol, uint8_t bTA1 );
+extern uint8_t ISO7816_T1_Init( const Iso7816Params* pParams );
+extern uint8_t ISO7816_T1_SetIfsd( uint8_t bIfsd );
+extern uint16_t ISO7816_XfrBlockAPDU_T1( const uint8_t *pAPDU,
+                                         uint8_t *pMessage,
+                                         uint16_t wLength );
 
 #endif /* ISO7816_4_H */
 
@@ -78,6 +78,27 @@ typedef struct _Font {
 	uint8_t height;
 } Font;
 
+/** \brief Run-length encoded font, with four coverage levels for anti-aliasing.
+ *
+ * Glyphs are scanned line by line from the upper-left pixel. Each byte is a
+ * run of pixels: bits 7-6 hold the coverage (0 for background to 3 for font
+ * color, levels 1 and 2 blend both colors) and bits 5-0 the run length minus
+ * one. Fonts in this format are generated off-line.
+ */
+typedef struct _FontRLE {
+	/* Glyph width in pixels. */
+	uint8_t width;
+	/* Glyph height in pixels. */
+	uint8_t height;
+	/* First and last characters of the font. */
+	uint8_t firstChar;
+	uint8_t lastChar;
+	/* Start offset of each glyph in pData, plus the end of the last glyph. */
+	const uint16_t *pOffsets;
+	/* Runs of all glyphs. */
+	const uint8_t *pData;
+} FontRLE;
+
 /*----------------------------------------------------------------------------
  *        Variables
  *----------------------------------------------------------------------------*/
@@ -93,5 +114,9 @@ extern void LCDD_DrawChar( uint32_t x, uint32_t y, uint8_t c, uint32_t color ) ;
 
 extern void LCDD_DrawCharWithBGColor( uint32_t x, uint32_t y, uint8_t c, uint32_t fontColor, uint32_t bgColor ) ;
 
+extern void LCDD_DrawCharRLE( uint32_t x, uint32_t y, uint8_t c, const FontRLE *pFont, uint32_t fontColor, uint32_t bgColor ) ;
+
+extern void LCDD_DrawStringRLE( uint32_t x, uint32_t y, const char *pString, const FontRLE *pFont, uint32_t fontColor, uint32_t bgColor ) ;
+
 #endif /* #ifndef LCD_FONT_ */
 
@@ -42,4 +42,7 @@
 /** Char set of font 10x14 */
 extern const uint8_t pCharset10x14[] ;
 
+/** Run-length encoded font 10x14 */
+extern const FontRLE gFont10x14RLE ;
+
 #endif /* #ifdef _LCD_FONT_10x14_ */
@@ -0,0 +1,67 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Interface of the span rasterizer shared by the LCD drawing layers.
+ *
+ * Shapes are decomposed into horizontal or vertical runs, handed to a
+ * caller supplied box filler which can set a GRAM window once and write the
+ * whole run as one burst. Coordinates are signed, the box filler is
+ * responsible for clipping.
+ *
+ */
+
+#ifndef _LCD_RASTER_
+#define _LCD_RASTER_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Fill a box of dwWidth x dwHeight pixels at (iX, iY) */
+typedef void (*LCDR_FillBoxFunc)( void* pContext, int32_t iX, int32_t iY, uint32_t dwWidth, uint32_t dwHeight ) ;
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern void LCDR_Line( int32_t iX1, int32_t iY1, int32_t iX2, int32_t iY2, LCDR_FillBoxFunc FillBox, void* pContext ) ;
+extern void LCDR_Rectangle( int32_t iX1, int32_t iY1, int32_t iX2, int32_t iY2, LCDR_FillBoxFunc FillBox, void* pContext ) ;
+extern void LCDR_Circle( int32_t iX, int32_t iY, uint32_t dwRadius, LCDR_FillBoxFunc FillBox, void* pContext ) ;
+extern void LCDR_FilledCircle( int32_t iX, int32_t iY, uint32_t dwRadius, LCDR_FillBoxFunc FillBox, void* pContext ) ;
+
+#endif /* #ifndef _LCD_RASTER_ */
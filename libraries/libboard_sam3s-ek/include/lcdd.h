@@ -43,6 +43,8 @@
 
 extern void LCDD_Initialize(void);
 
+extern uint32_t LCDD_InitializeStep( void* pArg, uint32_t* pdwState );
+
 extern void LCDD_On(void);
 
 extern void LCDD_Off(void);
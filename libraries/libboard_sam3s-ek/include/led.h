@@ -68,5 +68,7 @@ extern uint32_t LED_Clear( uint32_t dwLed ) ;
 
 extern uint32_t LED_Toggle( uint32_t dwLed ) ;
 
+extern uint32_t LED_Write( uint32_t dwLeds ) ;
+
 #endif /* #ifndef LED_H */
 
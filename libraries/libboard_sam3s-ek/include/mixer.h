@@ -0,0 +1,127 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Interface of the fixed-point audio mixer.
+ *
+ * Up to MIXER_MAX_STREAMS sources, each producing interleaved 16-bit stereo
+ * frames in Q15, are scaled by their own gain and summed with saturation
+ * into the buffers of a SSC stream or into the banks of a DACC stream. The
+ * mixer runs in the sink's interrupt, one PDC buffer at a time; sources
+ * are read-ahead rings filled by their own producer.
+ *
+ */
+
+#ifndef _MIXER_
+#define _MIXER_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of streams of a mixer */
+#define MIXER_MAX_STREAMS   4
+
+/** Unity gain, in Q15 (gains go up to 0xFFFF, nearly x2) */
+#define MIXER_GAIN_UNITY    0x8000
+
+/** Stream flag: released when its source first returns no frame */
+#define MIXER_ONESHOT       0x01
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Reads up to dwFrames stereo Q15 frames, returns the number read */
+typedef uint32_t (*MixerReadFunc)( void* pArgument, int16_t* psFrames, uint32_t dwFrames ) ;
+
+/** \brief One source of a mixer */
+typedef struct _MixerStream
+{
+    /** Source, 0 if the stream is free */
+    volatile MixerReadFunc read ;
+    /** Argument of the source */
+    void* pArgument ;
+    /** Gain in Q15 */
+    volatile uint16_t wGain ;
+    /** MIXER_ONESHOT or 0 */
+    uint8_t bFlags ;
+    /** Frames mixed */
+    uint32_t dwFrames ;
+} MixerStream ;
+
+/** \brief Mixer; use the MIXER functions to access it */
+typedef struct _Mixer
+{
+    MixerStream streams[MIXER_MAX_STREAMS] ;
+    /** Source scratch, dwBlock stereo frames */
+    int16_t* psScratch ;
+    /** Mix buffer for the DACC sink, dwBlock stereo frames */
+    int16_t* psMix ;
+    /** Frames processed per pass */
+    uint32_t dwBlock ;
+    /** Samples clipped by the saturation */
+    volatile uint32_t dwClipped ;
+} Mixer ;
+
+/** \brief Source reading a RingBuffer of stereo 16-bit frames, as filled by
+    the audio OUT endpoint of a AUDDStream */
+typedef struct _MixerRingSource
+{
+    RingBuffer* pRing ;
+    /** Reads the ring could serve only in part */
+    volatile uint32_t dwShort ;
+} MixerRingSource ;
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern void MIXER_Initialize( Mixer* pMixer, int16_t* psScratch, int16_t* psMix, uint32_t dwBlock ) ;
+extern int32_t MIXER_Add( Mixer* pMixer, MixerReadFunc read, void* pArgument, uint16_t wGain, uint8_t bFlags ) ;
+extern void MIXER_Remove( Mixer* pMixer, int32_t iStream ) ;
+extern void MIXER_SetGain( Mixer* pMixer, int32_t iStream, uint16_t wGain ) ;
+extern uint32_t MIXER_IsActive( Mixer* pMixer, int32_t iStream ) ;
+
+extern void MIXER_Process( Mixer* pMixer, int16_t* psOut, uint32_t dwFrames ) ;
+extern uint32_t MIXER_SscFill( Mixer* pMixer, SscStream* pStream ) ;
+extern void MIXER_DaccFill( void* pArgument, uint16_t* pwBank, uint32_t dwSize ) ;
+
+extern uint32_t MIXER_RingRead( void* pArgument, int16_t* psFrames, uint32_t dwFrames ) ;
+extern uint32_t MIXER_DdsRead( void* pArgument, int16_t* psFrames, uint32_t dwFrames ) ;
+
+#endif /* #ifndef _MIXER_ */
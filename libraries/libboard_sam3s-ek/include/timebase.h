@@ -0,0 +1,111 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ *  \file
+ *
+ *  \par Purpose
+ *
+ *  64-bit microsecond timebase and microsecond software timers.
+ *
+ *  The timebase uses the first two channels of the TC1 block, chained inside
+ *  the chip: TC3 divides MCK down to a 1 MHz square wave on TIOA3, which
+ *  clocks the 16-bit counter of TC4 through XC1. The TC4 overflows extend the
+ *  count to 64 bits, so the time never wraps. No pin is used.
+ *
+ *  The software timers are kept sorted by expiry time; the RC compare of TC4
+ *  interrupts at the first expiry, so the timer callbacks are called from the
+ *  TC4 interrupt within a few microseconds of their deadline, with no periodic
+ *  tick in between.
+ *
+ *  \par Usage
+ *
+ *  -# Start the timebase with TimeBase_Configure() once MCK is set; MCK must
+ *     be a multiple of 4 MHz. The later changes made by CLOCK_SetConfig()
+ *     are followed through a clock notifier.
+ *  -# Use TimeBase_GetUs() to read the time, TimeBase_WaitUs() to spin for a
+ *     few microseconds and TimeBase_SleepUs() to wait with the core stopped
+ *     (WFI) until the delay has elapsed.
+ *  -# Use TimeBase_StartTimer() for driver timeouts and scheduling, and
+ *     TimeBase_StopTimer() to cancel a timer which has not expired. Zero a
+ *     timer structure before its first use. The callbacks run in the TC4
+ *     interrupt, with the interrupts enabled.
+ *
+ */
+
+#ifndef _TIMEBASE_
+#define _TIMEBASE_
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *         Types
+ *----------------------------------------------------------------------------*/
+
+/** Timer callback, called from the TC4 interrupt. */
+typedef void (*TimeBaseCallback)( void* pArg ) ;
+
+/** Software timer; the structure must stay valid while the timer runs. */
+typedef struct _TimeBaseTimer
+{
+    /** Expiry time, in us. */
+    uint64_t qwExpiry ;
+    /** Function called at expiry, may be 0. */
+    TimeBaseCallback fCallback ;
+    /** Argument of the callback. */
+    void* pArg ;
+    /** Next timer to expire. */
+    struct _TimeBaseTimer* pNext ;
+    /** Is the timer running. */
+    volatile uint8_t ucRunning ;
+} TimeBaseTimer ;
+
+/*----------------------------------------------------------------------------
+ *         Global functions
+ *----------------------------------------------------------------------------*/
+
+extern uint32_t TimeBase_Configure( uint32_t dwMck ) ;
+
+extern uint64_t TimeBase_GetUs( void ) ;
+
+extern void TimeBase_WaitUs( uint32_t dwUs ) ;
+
+extern void TimeBase_SleepUs( uint32_t dwUs ) ;
+
+extern void TimeBase_StartTimer( TimeBaseTimer* pTimer, uint32_t dwUs, TimeBaseCallback fCallback, void* pArg ) ;
+
+extern void TimeBase_StartTimerAt( TimeBaseTimer* pTimer, uint64_t qwExpiry, TimeBaseCallback fCallback, void* pArg ) ;
+
+extern void TimeBase_StopTimer( TimeBaseTimer* pTimer ) ;
+
+#endif /* _TIMEBASE_ */
@@ -67,6 +67,8 @@
 
 extern uint32_t TimeTick_Configure( uint32_t dwNew_MCK ) ;
 
+extern uint32_t TimeTick_SetMck( uint32_t dwNew_MCK ) ;
+
 extern void TimeTick_Increment( void ) ;
 
 extern uint32_t GetTickCount( void ) ;
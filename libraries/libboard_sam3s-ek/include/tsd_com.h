@@ -36,10 +36,29 @@
 #ifndef _TSD_COM_
 #define _TSD_COM_
 
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Fractional bits of the IIR filter state. */
+#define TSD_FILTER_SHIFT    4
+/** IIR filter strength: each measurement contributes 1/2^TSD_IIR_SHIFT. */
+#define TSD_IIR_SHIFT       1
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
 
+extern uint32_t TSDCom_Median( uint16_t *pwSamples, uint32_t dwCount ) ;
+
+extern void TSDCom_FilterMeasurement( int32_t *pState, uint32_t *pData, uint8_t bReset ) ;
+
 extern void TSDCom_InterpolateMeasurement( const uint32_t *pData, uint32_t *pPoint ) ;
 
 uint8_t TSDCom_Calibrate( void ) ;
@@ -32,11 +32,24 @@
 #define _UART_CONSOLE_
 
 #include <stdint.h>
+#include <stdarg.h>
+
+/** Policies of the transmit ring, see UART_EnableTxBuffer() */
+#define UART_TX_BLOCK           1
+#define UART_TX_DROP_OLDEST     2
 
 extern void UART_Configure( uint32_t dwBaudrate, uint32_t dwMasterClock ) ;
 extern void UART_PutChar( uint8_t uc ) ;
 extern uint32_t UART_GetChar( void ) ;
 extern uint32_t UART_IsRxReady( void ) ;
+extern void UART_EnableRxBuffer( void ) ;
+extern uint32_t UART_PdcSend( const uint8_t* pucData, uint32_t dwSize, void (*fCallback)( uint32_t dwSize ) ) ;
+extern void UART_EnableTxBuffer( uint32_t dwPolicy ) ;
+extern void UART_Write( const uint8_t* pucData, uint32_t dwSize ) ;
+extern void UART_TxFlush( void ) ;
+extern uint32_t UART_GetTxDropped( void ) ;
+extern int UART_VPrintf( const char* pszFormat, va_list ap ) ;
+extern int UART_Printf( const char* pszFormat, ... ) ;
 
 
 extern void UART_DumpFrame( uint8_t* pucFrame, uint32_t dwSize ) ;
@@ -34,6 +34,12 @@
  *        Headers
  *----------------------------------------------------------------------------*/
 
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
 /* Standard WAV file header information. */
 typedef struct _WavHeader
 {
@@ -66,6 +72,46 @@ typedef struct _WavHeader
 
 } WavHeader;
 
+/** Output of a WavPlayer: 16-bit stereo words for the SSC (WM8731) or a
+    Mixer. */
+#define WAV_OUTPUT_SSC16     0
+/** Output of a WavPlayer: 12-bit unsigned mono samples for the DACC. */
+#define WAV_OUTPUT_DACC12    1
+
+/** Reads up to dwSize bytes of the file, returns the number of bytes read. */
+typedef uint32_t (*WavReadFunc)(void *pContext, uint8_t *pBuffer, uint32_t dwSize);
+
+/** Streaming player: file data read ahead into a RingBuffer by the task,
+    converted to the output format as the SSC or DACC stream drains it. */
+typedef struct _WavPlayer
+{
+    /** Header of the file being played. */
+    WavHeader header;
+    /** File access. */
+    WavReadFunc read;
+    void *pContext;
+    /** Read-ahead ring of raw sample data. */
+    RingBuffer ring;
+    /** Bytes per read, a power of two dividing the ring size. */
+    uint32_t dwChunk;
+    /** Sample data left in the file. */
+    volatile uint32_t dwRemaining;
+    /** WAV_OUTPUT_xxx. */
+    uint8_t bOutput;
+    /** Set once the output starved, cleared by the next sample played. */
+    volatile uint8_t bStarved;
+    /** Frames sent to the output. */
+    volatile uint32_t dwFrames;
+    /** Times the output found the ring empty before the end of the file. */
+    volatile uint32_t dwUnderruns;
+    /** Silent frames inserted because of underruns. */
+    volatile uint32_t dwSilence;
+    /** Fewest bytes seen in the ring by the output since the start. */
+    volatile uint32_t dwLowWater;
+    /** Longest single read, in ms. */
+    uint32_t dwReadMax;
+} WavPlayer;
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -74,5 +120,23 @@ extern unsigned char WAV_IsValid(const WavHeader *header);
 
 extern void WAV_DisplayInfo(const WavHeader *header);
 
+extern uint32_t WAV_GetRingSize(const WavHeader *header, uint32_t dwLatency,
+                                uint32_t dwChunk);
+
+extern uint8_t WAV_PlayerOpen(WavPlayer *pPlayer, WavReadFunc read,
+                              void *pContext, uint8_t *pRing,
+                              uint32_t dwRingSize, uint32_t dwChunk,
+                              uint8_t bOutput);
+
+extern uint32_t WAV_PlayerFill(WavPlayer *pPlayer);
+
+extern uint8_t WAV_PlayerIsDone(WavPlayer *pPlayer);
+
+extern uint32_t WAV_PlayerSscFill(WavPlayer *pPlayer, SscStream *pStream);
+
+extern void WAV_PlayerDaccFill(void *pArgument, uint16_t *pwBank, uint32_t dwSize);
+
+extern uint32_t WAV_PlayerRead(void *pArgument, int16_t *psFrames, uint32_t dwFrames);
+
 #endif //#ifndef WAV_H
 
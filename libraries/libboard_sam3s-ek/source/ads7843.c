@@ -65,6 +65,11 @@
 #define DELAY_BEFORE_SPCK          200 /* 2us min (tCSS) <=> 200/100 000 000 = 2us */
 #define DELAY_BETWEEN_CONS_COM     0xf /* 5us min (tCSH) <=> (32 * 15) / (100 000 000) = 5us */
 
+/* Bytes clocked for one conversion (command + 2 bytes of result) */
+#define ADS7843_FRAME_SIZE     3
+/* Size of the chained transfer: X and Y frames per sample plus the final penIRQ frame */
+#define ADS7843_BATCH_SIZE     (((ADS7843_MAX_SAMPLES * 2) + 1) * ADS7843_FRAME_SIZE)
+
 /*----------------------------------------------------------------------------
  *        Local variables
  *----------------------------------------------------------------------------*/
@@ -75,6 +80,15 @@ static const Pin pinsSPI[]  = {BOARD_TSC_SPI_PINS, BOARD_TSC_NPCS_PIN};
 /** Touch screen BUSY pin */
 static const Pin pinBusy[] = {PIN_TSC_BUSY};
 
+/** Command stream of the chained batch transfer */
+static uint8_t batchTX[ADS7843_BATCH_SIZE];
+
+/** Results of the chained batch transfer (volatile, written by the PDC) */
+static volatile uint8_t batchRX[ADS7843_BATCH_SIZE];
+
+/** Number of samples of the batch in progress, 0 if none */
+static uint32_t batchSamples = 0;
+
 /*----------------------------------------------------------------------------
  *        Local functions
  *----------------------------------------------------------------------------*/
@@ -135,10 +149,143 @@ static uint32_t SendCommand( uint8_t bCmd )
     return uResult;
 }
 
+/**
+ * \brief Extract the result of one conversion from the batch reception buffer.
+ *
+ * \param dwFrame index of the conversion frame in the batch
+ *
+ * \return conversion result
+ */
+static uint16_t GetBatchResult( uint32_t dwFrame )
+{
+    uint32_t dwOffset = dwFrame * ADS7843_FRAME_SIZE ;
+
+    return (uint16_t)((((uint32_t)batchRX[dwOffset+1] << 8) | (uint32_t)batchRX[dwOffset+2]) >> 4) ;
+}
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
 
+/**
+ * \brief Start a chained acquisition of several X/Y samples.
+ *
+ * All the conversions are queued in a single PDC transfer, followed by the
+ * command enabling penIRQ again, so the function returns immediately and the
+ * CPU is not involved until ADS7843_GetSamples() is called. The penIRQ line
+ * toggles during the conversions, its interrupt should be masked by the caller
+ * until the batch is complete.
+ *
+ * \param dwCount number of X/Y samples to acquire (1 to ADS7843_MAX_SAMPLES)
+ */
+extern void ADS7843_StartSamples( uint32_t dwCount )
+{
+    Pdc *pPdc = (Pdc *)SPI;
+    uint32_t dwSize ;
+    uint32_t i ;
+
+    if ( dwCount > ADS7843_MAX_SAMPLES )
+    {
+        dwCount = ADS7843_MAX_SAMPLES ;
+    }
+    dwSize = ((dwCount * 2) + 1) * ADS7843_FRAME_SIZE ;
+
+    for ( i=0 ; i < dwSize ; i++ )
+    {
+        batchTX[i] = 0 ;
+    }
+    for ( i=0 ; i < dwCount ; i++ )
+    {
+        batchTX[(2*i)*ADS7843_FRAME_SIZE] = CMD_X_POSITION ;
+        batchTX[(2*i+1)*ADS7843_FRAME_SIZE] = CMD_Y_POSITION ;
+    }
+    /* Switch back to low power mode with penIRQ enabled */
+    batchTX[(2*dwCount)*ADS7843_FRAME_SIZE] = CMD_ENABLE_PENIRQ ;
+
+    batchSamples = dwCount ;
+
+    pPdc->PERIPH_PTCR = PERIPH_PTCR_RXTDIS;
+    pPdc->PERIPH_RPR = (uint32_t) batchRX;
+    pPdc->PERIPH_RCR = dwSize;
+
+    pPdc->PERIPH_PTCR = PERIPH_PTCR_TXTDIS;
+    pPdc->PERIPH_TPR = (uint32_t) batchTX;
+    pPdc->PERIPH_TCR = dwSize;
+
+    pPdc->PERIPH_PTCR = PERIPH_PTCR_RXTEN;
+    pPdc->PERIPH_PTCR = PERIPH_PTCR_TXTEN;
+}
+
+/**
+ * \brief Check if the batch started by ADS7843_StartSamples() is complete.
+ *
+ * \return 1 if the samples are available, 0 otherwise (or if no batch was started)
+ */
+extern uint32_t ADS7843_IsSamplesReady( void )
+{
+    if ( batchSamples == 0 )
+    {
+        return 0 ;
+    }
+
+    return ((REG_SPI_SR & SPI_SR_RXBUFF) == SPI_SR_RXBUFF) ? 1 : 0 ;
+}
+
+/**
+ * \brief Retrieve the samples of a completed batch.
+ *
+ * \param pwX buffer receiving the horizontal samples
+ * \param pwY buffer receiving the vertical samples
+ *
+ * \return number of samples stored in each buffer
+ */
+extern uint32_t ADS7843_GetSamples( uint16_t *pwX, uint16_t *pwY )
+{
+    Pdc *pPdc = (Pdc *)SPI;
+    uint32_t dwCount = batchSamples ;
+    uint32_t i ;
+
+    pPdc->PERIPH_PTCR = PERIPH_PTCR_RXTDIS;
+    pPdc->PERIPH_PTCR = PERIPH_PTCR_TXTDIS;
+
+    for ( i=0 ; i < dwCount ; i++ )
+    {
+        pwX[i] = GetBatchResult( 2*i ) ;
+        pwY[i] = GetBatchResult( 2*i+1 ) ;
+    }
+    batchSamples = 0 ;
+
+    return dwCount ;
+}
+
+/**
+ * \brief Acquire several X/Y samples in one chained transfer and wait for them.
+ *
+ * \param pwX buffer receiving the horizontal samples
+ * \param pwY buffer receiving the vertical samples
+ * \param dwCount number of samples to acquire (1 to ADS7843_MAX_SAMPLES)
+ *
+ * \return number of samples stored in each buffer, 0 on timeout
+ */
+extern uint32_t ADS7843_ReadSamples( uint16_t *pwX, uint16_t *pwY, uint32_t dwCount )
+{
+    uint32_t uTimeout = 0;
+
+    ADS7843_StartSamples( dwCount ) ;
+
+    while ( !ADS7843_IsSamplesReady() )
+    {
+        if ( ++uTimeout >= ADS7843_TIMEOUT )
+        {
+            ADS7843_GetSamples( pwX, pwY ) ;
+
+            return 0 ;
+        }
+    }
+
+    return ADS7843_GetSamples( pwX, pwY ) ;
+}
+
 /**
  * \brief Get position of the pen by ask the ADS controller (SPI).
  *
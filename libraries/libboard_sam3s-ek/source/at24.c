@@ -0,0 +1,425 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \addtogroup external_component External Component
+ *
+ * \addtogroup at24_module AT24 driver
+ * \ingroup external_component
+ * The AT24 driver accesses a serial EEPROM through a TWI driver (Twid),
+ * using TWID_Transaction() so that the bytes are moved by the PDC.
+ *
+ * \section Usage
+ * <ul>
+ * <li> Initializes an At24 instance with AT24_Initialize(), giving the slave
+ * address, the internal address size, the page size and the size of the
+ * EEPROM, and optionally a RAM buffer mirroring the beginning of the EEPROM.</li>
+ * <li> Writes any number of bytes at any address using AT24_Write(): the data
+ * is split into bursts that never cross a page. After each burst the EEPROM
+ * is polled until it acknowledges again, which ends as soon as the write
+ * cycle is over instead of waiting for the worst case time.</li>
+ * <li> Reads any number of bytes using AT24_Read(). Once AT24_LoadShadow()
+ * has filled the RAM copy, reads within the copy are served without bus
+ * access; writes keep it up to date.</li>
+ * </ul>
+ * All the operations are asynchronous when a callback is given, and
+ * synchronous otherwise. In both cases TWID_Handler() must be called from
+ * the interrupt handler of the TWI peripheral.
+ *
+ * Related files :\n
+ * \ref at24.c\n
+ * \ref at24.h.\n
+ */
+ /*@{*/
+ /*@}*/
+
+
+/**
+  * \file
+  *
+  * Implementation of the AT24 serial EEPROM driver.
+  *
+  */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "board.h"
+
+#include <assert.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** No operation in progress. */
+#define AT24_STATE_IDLE         0
+/** Reading a burst. */
+#define AT24_STATE_READ         1
+/** Reading a burst into the RAM copy. */
+#define AT24_STATE_LOAD         2
+/** Writing a page burst. */
+#define AT24_STATE_WRITE        3
+/** Polling the EEPROM until its write cycle is over. */
+#define AT24_STATE_POLL         4
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Starts the next burst of the current operation. A write burst stops
+ * at the end of the page; a read burst at the end of the range addressed
+ * by the internal address, the upper address bits being part of the slave
+ * address.
+ * \param pAt24  Pointer to an At24 instance.
+ * \return 0 if the burst has been started; otherwise a TWI error code.
+ */
+static uint8_t AT24_StartBurst( At24 *pAt24 )
+{
+    TwidSegment *pSegment = &pAt24->segment ;
+    uint32_t span = 1 << (8 * pAt24->isize) ;
+    uint32_t num ;
+
+    if ( pAt24->state == AT24_STATE_WRITE )
+    {
+        num = pAt24->pageSize - (pAt24->address & (pAt24->pageSize - 1)) ;
+        pSegment->direction = TWID_SEGMENT_WRITE ;
+    }
+    else
+    {
+        num = span - (pAt24->address & (span - 1)) ;
+        pSegment->direction = TWID_SEGMENT_READ ;
+    }
+    if ( num > pAt24->remaining )
+    {
+        num = pAt24->remaining ;
+    }
+
+    pSegment->address = pAt24->slave | ((pAt24->address >> (8 * pAt24->isize)) & 0x7) ;
+    pSegment->isize = pAt24->isize ;
+    pSegment->iaddress = pAt24->address & (span - 1) ;
+    pSegment->pData = pAt24->pData ;
+    pSegment->num = num ;
+
+    return TWID_Transaction( pAt24->pTwid, &pAt24->transaction ) ;
+}
+
+/**
+ * \brief Starts an acknowledge poll: a current address read of one byte,
+ * which the EEPROM does not acknowledge until its write cycle is over.
+ * The slave address of the last burst is kept.
+ * \param pAt24  Pointer to an At24 instance.
+ * \return 0 if the poll has been started; otherwise a TWI error code.
+ */
+static uint8_t AT24_StartPoll( At24 *pAt24 )
+{
+    TwidSegment *pSegment = &pAt24->segment ;
+
+    pSegment->isize = 0 ;
+    pSegment->direction = TWID_SEGMENT_READ ;
+    pSegment->iaddress = 0 ;
+    pSegment->pData = &pAt24->probe ;
+    pSegment->num = 1 ;
+
+    return TWID_Transaction( pAt24->pTwid, &pAt24->transaction ) ;
+}
+
+/**
+ * \brief Ends the current operation and invokes its callback.
+ * \param pAt24  Pointer to an At24 instance.
+ * \param status  Operation status, 0 if successful.
+ */
+static void AT24_Finish( At24 *pAt24, uint8_t status )
+{
+    At24Callback callback = pAt24->callback ;
+    void *pArgument = pAt24->pArgument ;
+
+    if ( pAt24->state == AT24_STATE_LOAD )
+    {
+        pAt24->shadowValid = (status == 0) ;
+    }
+    /* The EEPROM content is unknown after a failed write */
+    else if ( status && pAt24->state != AT24_STATE_READ )
+    {
+        pAt24->shadowValid = 0 ;
+    }
+
+    pAt24->status = status ;
+    pAt24->state = AT24_STATE_IDLE ;
+    if ( callback )
+    {
+        callback( status, pArgument ) ;
+    }
+}
+
+/**
+ * \brief Transaction callback, invoked from TWID_Handler() at the end of each
+ * burst and poll; starts the next one.
+ * \param pTransaction  Pointer to the finished transaction.
+ */
+static void AT24_TransactionCallback( TwidTransaction *pTransaction )
+{
+    At24 *pAt24 = (At24 *)pTransaction->pArgument ;
+    uint8_t status = pTransaction->status ;
+    uint32_t num ;
+
+    if ( pAt24->state == AT24_STATE_POLL )
+    {
+        /* Still in its write cycle */
+        if ( status == TWID_ERROR_NACK )
+        {
+            if ( ++pAt24->polls >= AT24_MAX_POLLS )
+            {
+                AT24_Finish( pAt24, AT24_ERROR_TIMEOUT ) ;
+                return ;
+            }
+            status = AT24_StartPoll( pAt24 ) ;
+        }
+        else if ( status == 0 )
+        {
+            if ( pAt24->remaining == 0 )
+            {
+                AT24_Finish( pAt24, 0 ) ;
+                return ;
+            }
+            pAt24->state = AT24_STATE_WRITE ;
+            status = AT24_StartBurst( pAt24 ) ;
+        }
+    }
+    else if ( status == 0 )
+    {
+        num = pAt24->segment.num ;
+
+        /* Keep the RAM copy in step with the EEPROM */
+        if ( pAt24->state == AT24_STATE_WRITE && pAt24->shadowValid
+          && pAt24->address < pAt24->shadowSize )
+        {
+            memcpy( &pAt24->pShadow[pAt24->address], pAt24->pData,
+                    ((pAt24->address + num) <= pAt24->shadowSize) ? num : (pAt24->shadowSize - pAt24->address) ) ;
+        }
+        pAt24->address += num ;
+        pAt24->pData += num ;
+        pAt24->remaining -= num ;
+
+        if ( pAt24->state == AT24_STATE_WRITE )
+        {
+            pAt24->state = AT24_STATE_POLL ;
+            pAt24->polls = 0 ;
+            status = AT24_StartPoll( pAt24 ) ;
+        }
+        else if ( pAt24->remaining == 0 )
+        {
+            AT24_Finish( pAt24, 0 ) ;
+            return ;
+        }
+        else
+        {
+            status = AT24_StartBurst( pAt24 ) ;
+        }
+    }
+
+    if ( status )
+    {
+        AT24_Finish( pAt24, status ) ;
+    }
+}
+
+/**
+ * \brief Starts an operation, then waits for its end if no callback is given.
+ * \param pAt24  Pointer to an At24 instance.
+ * \param state  AT24_STATE_READ, AT24_STATE_LOAD or AT24_STATE_WRITE.
+ * \return 0 if the operation has been started (asynchronous) or is
+ * successful (synchronous); otherwise an AT24 error code.
+ */
+static uint8_t AT24_Start( At24 *pAt24, uint8_t state, uint32_t address, uint8_t *pData,
+                           uint32_t num, At24Callback callback, void *pArgument )
+{
+    uint8_t status ;
+
+    assert( (address + num) <= pAt24->size ) ;
+
+    if ( pAt24->state != AT24_STATE_IDLE )
+    {
+        return AT24_ERROR_BUSY ;
+    }
+    if ( num == 0 )
+    {
+        if ( callback )
+        {
+            callback( 0, pArgument ) ;
+        }
+        return 0 ;
+    }
+
+    pAt24->state = state ;
+    pAt24->address = address ;
+    pAt24->pData = pData ;
+    pAt24->remaining = num ;
+    pAt24->callback = callback ;
+    pAt24->pArgument = pArgument ;
+
+    status = AT24_StartBurst( pAt24 ) ;
+    if ( status )
+    {
+        pAt24->state = AT24_STATE_IDLE ;
+        return status ;
+    }
+
+    if ( callback == NULL )
+    {
+        while ( pAt24->state != AT24_STATE_IDLE ) ;
+        return pAt24->status ;
+    }
+
+    return 0 ;
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initializes an AT24 driver instance. The TWI driver must have been
+ * initialized, and its interrupt forwarded to TWID_Handler().
+ * \param pAt24  Pointer to the At24 instance to initialize.
+ * \param pTwid  Pointer to the TWI driver.
+ * \param slave  Slave address of the EEPROM. Address bits beyond the internal
+ * address are added to it, as required by the smaller devices.
+ * \param isize  Internal address size in bytes (1 or 2).
+ * \param pageSize  Page size in bytes, a power of 2.
+ * \param size  Size of the EEPROM in bytes.
+ * \param pShadow  Optional RAM copy of the beginning of the EEPROM, or 0.
+ * \param shadowSize  Size of the RAM copy in bytes.
+ */
+void AT24_Initialize( At24 *pAt24, Twid *pTwid, uint8_t slave, uint8_t isize,
+                      uint16_t pageSize, uint32_t size,
+                      uint8_t *pShadow, uint32_t shadowSize )
+{
+    assert( pAt24 != NULL ) ;
+    assert( pTwid != NULL ) ;
+    assert( isize == 1 || isize == 2 ) ;
+    assert( pageSize && (pageSize & (pageSize - 1)) == 0 ) ;
+    assert( shadowSize <= size ) ;
+
+    memset( pAt24, 0, sizeof( At24 ) ) ;
+    pAt24->pTwid = pTwid ;
+    pAt24->slave = slave ;
+    pAt24->isize = isize ;
+    pAt24->pageSize = pageSize ;
+    pAt24->size = size ;
+    pAt24->pShadow = pShadow ;
+    pAt24->shadowSize = pShadow ? shadowSize : 0 ;
+
+    pAt24->transaction.numSegments = 1 ;
+    pAt24->transaction.pSegments = &pAt24->segment ;
+    pAt24->transaction.callback = AT24_TransactionCallback ;
+    pAt24->transaction.pArgument = pAt24 ;
+}
+
+/**
+ * \brief Reads data from the EEPROM. The data is copied from the RAM copy
+ * if it holds the whole range.
+ * \param pAt24  Pointer to an At24 instance.
+ * \param address  EEPROM address of the first byte.
+ * \param pData  Buffer receiving the data.
+ * \param num  Number of bytes to read.
+ * \param callback  Optional completion callback; without it the function
+ * returns once the data has been read.
+ * \param pArgument  Argument of the callback.
+ * \return 0 if successful (or started); otherwise an AT24 error code.
+ */
+uint8_t AT24_Read( At24 *pAt24, uint32_t address, uint8_t *pData, uint32_t num,
+                   At24Callback callback, void *pArgument )
+{
+    assert( pAt24 != NULL ) ;
+
+    if ( pAt24->shadowValid && pAt24->state == AT24_STATE_IDLE
+      && (address + num) <= pAt24->shadowSize )
+    {
+        memcpy( pData, &pAt24->pShadow[address], num ) ;
+        if ( callback )
+        {
+            callback( 0, pArgument ) ;
+        }
+        return 0 ;
+    }
+
+    return AT24_Start( pAt24, AT24_STATE_READ, address, pData, num, callback, pArgument ) ;
+}
+
+/**
+ * \brief Writes data to the EEPROM, one page burst after the other, each one
+ * followed by acknowledge polling until the write cycle is over.
+ * \param pAt24  Pointer to an At24 instance.
+ * \param address  EEPROM address of the first byte.
+ * \param pData  Data to write; it must remain valid until the end of the write.
+ * \param num  Number of bytes to write.
+ * \param callback  Optional completion callback; without it the function
+ * returns once the data has been programmed.
+ * \param pArgument  Argument of the callback.
+ * \return 0 if successful (or started); otherwise an AT24 error code.
+ */
+uint8_t AT24_Write( At24 *pAt24, uint32_t address, const uint8_t *pData, uint32_t num,
+                    At24Callback callback, void *pArgument )
+{
+    assert( pAt24 != NULL ) ;
+
+    return AT24_Start( pAt24, AT24_STATE_WRITE, address, (uint8_t *)pData, num, callback, pArgument ) ;
+}
+
+/**
+ * \brief Fills the RAM copy given to AT24_Initialize() from the EEPROM.
+ * \param pAt24  Pointer to an At24 instance.
+ * \param callback  Optional completion callback; without it the function
+ * returns once the copy has been loaded.
+ * \param pArgument  Argument of the callback.
+ * \return 0 if successful (or started); otherwise an AT24 error code.
+ */
+uint8_t AT24_LoadShadow( At24 *pAt24, At24Callback callback, void *pArgument )
+{
+    assert( pAt24 != NULL ) ;
+
+    pAt24->shadowValid = 0 ;
+    return AT24_Start( pAt24, AT24_STATE_LOAD, 0, pAt24->pShadow, pAt24->shadowSize, callback, pArgument ) ;
+}
+
+/**
+ * \brief Tells whether an operation is in progress.
+ * \param pAt24  Pointer to an At24 instance.
+ * \return 1 if the driver is busy, 0 otherwise.
+ */
+uint32_t AT24_IsBusy( At24 *pAt24 )
+{
+    assert( pAt24 != NULL ) ;
+
+    return (pAt24->state != AT24_STATE_IDLE) ;
+}
@@ -43,7 +43,12 @@
  * <ul>
  * <li> Reads data from the At45 at the specified address using AT45D_Read().</li>
  * <li> Writes data on the At45 at the specified address using AT45D_Write().</li>
- * <li> Erases a page of data at the given address using AT45D_Erase().</li>
+ * <li> Erases a page of data at the given address using AT45D_Erase(), or a
+ * block of 8 pages using AT45D_EraseBlock().</li>
+ * <li> Writes several pages using AT45D_WritePipelined(): while one SRAM buffer
+ * is programmed into the main memory, the next page is loaded into the other
+ * one, so the SPI transfers are hidden behind the page program times.</li>
+ * <li> Switches the At45 to power-of-2 page size using AT45D_BinaryPage().</li>
  * <li> Poll until the At45 has completed of corresponding operations using
  * AT45D_WaitReady().</li>
  * <li> Retrieves and returns the At45 current using AT45D_GetStatus().</li>
@@ -72,6 +77,13 @@
 #include <assert.h>
 #include <string.h>
 
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Largest data transfer of one command, the PDC counters being 16-bit */
+#define AT45D_MAX_TRANSFER      0xFFFF
+
 /*----------------------------------------------------------------------------
  *        Local functions
  *----------------------------------------------------------------------------*/
@@ -152,18 +164,70 @@ extern uint32_t AT45D_GetStatus( At45* pAt45 )
 extern void AT45D_Read( At45* pAt45, uint8_t* pucBuffer, uint32_t dwSize, uint32_t dwAddress )
 {
     uint32_t dwError ;
+    uint32_t dwChunk ;
 
     assert( pAt45 != NULL ) ;
     assert( pucBuffer != NULL ) ;
 
-    /* Issue a continuous read array command. */
-    dwError = AT45_SendCommand( pAt45, AT45_CONTINUOUS_READ_LEG, 8, pucBuffer, dwSize, dwAddress, 0, 0 ) ;
-    assert( !dwError ) ;
+    while ( dwSize )
+    {
+        dwChunk = (dwSize > AT45D_MAX_TRANSFER) ? AT45D_MAX_TRANSFER : dwSize ;
 
-    /* Wait for the read command to execute. */
-    while ( AT45_IsBusy( pAt45 ) )
+        /* Issue a continuous read array command. */
+        dwError = AT45_SendCommand( pAt45, AT45_CONTINUOUS_READ_LEG, 8, pucBuffer, dwChunk, dwAddress, 0, 0 ) ;
+        assert( !dwError ) ;
+
+        /* Wait for the read command to execute. */
+        while ( AT45_IsBusy( pAt45 ) )
+        {
+            AT45D_Wait( pAt45 ) ;
+        }
+
+        pucBuffer += dwChunk ;
+        dwAddress += dwChunk ;
+        dwSize -= dwChunk ;
+    }
+}
+
+/**
+ * \brief Reads data from the At45 using the high frequency continuous array
+ * read command (0x0B), which needs a single dummy byte instead of the four of
+ * AT45D_Read(). As AT45D_Read(), there is no restriction on the size and
+ * address.
+ *
+ * \param pAt45  Pointer to an AT45 driver instance.
+ * \param pucBuffer  Data buffer.
+ * \param dwSize  Number of bytes to read.
+ * \param dwAddress  Address at which data shall be read.
+ */
+extern void AT45D_ReadFast( At45* pAt45, uint8_t* pucBuffer, uint32_t dwSize, uint32_t dwAddress )
+{
+    uint32_t dwError ;
+    uint32_t dwChunk ;
+    uint8_t ucCmdSize ;
+
+    assert( pAt45 != NULL ) ;
+    assert( pucBuffer != NULL ) ;
+
+    /* Opcode, address and dummy byte; AT45_SendCommand() does not add the
+       fourth address byte of the large parts for this command */
+    ucCmdSize = (AT45_PageNumber( pAt45 ) >= 16384) ? 6 : 5 ;
+
+    while ( dwSize )
     {
-        AT45D_Wait( pAt45 ) ;
+        dwChunk = (dwSize > AT45D_MAX_TRANSFER) ? AT45D_MAX_TRANSFER : dwSize ;
+
+        dwError = AT45_SendCommand( pAt45, AT45_CONTINUOUS_READ, ucCmdSize, pucBuffer, dwChunk, dwAddress, 0, 0 ) ;
+        assert( !dwError ) ;
+
+        while ( AT45_IsBusy( pAt45 ) )
+        {
+            AT45D_Wait( pAt45 ) ;
+        }
+
+        pucBuffer += dwChunk ;
+        dwAddress += dwChunk ;
+        dwSize -= dwChunk ;
     }
 }
 
@@ -200,6 +264,166 @@ extern void AT45D_Write( At45* pAt45, uint8_t *pucBuffer, uint32_t dwSize, uint3
     AT45D_WaitReady( pAt45 ) ;
 }
 
+/**
+ * \brief Loads data into one of the two SRAM buffers of the At45. The buffers
+ * can be written while the device programs the other buffer into the main
+ * memory, so the status is not checked here.
+ *
+ * \param pAt45  Pointer to an AT45 driver instance.
+ * \param ucBuffer  SRAM buffer, 0 or 1.
+ * \param pucBuffer  Data buffer.
+ * \param dwSize  Number of bytes to write.
+ * \param dwOffset  Byte offset in the SRAM buffer.
+ */
+extern void AT45D_WriteBuffer( At45* pAt45, uint8_t ucBuffer, const uint8_t* pucBuffer, uint32_t dwSize, uint32_t dwOffset )
+{
+    uint32_t dwError ;
+
+    assert( pAt45 != NULL ) ;
+    assert( pucBuffer != NULL ) ;
+    assert( (dwOffset + dwSize) <= AT45_PageSize( pAt45 ) ) ;
+
+    dwError = AT45_SendCommand( pAt45, ucBuffer ? AT45_BUF2_WRITE : AT45_BUF1_WRITE, 4,
+                                (uint8_t*)pucBuffer, dwSize, dwOffset, 0, 0 ) ;
+    assert( !dwError ) ;
+
+    while ( AT45_IsBusy( pAt45 ) )
+    {
+        AT45D_Wait( pAt45 ) ;
+    }
+}
+
+/**
+ * \brief Transfers a main memory page into one of the SRAM buffers, so that
+ * the page can be programmed again with only some of its bytes changed.
+ * \param pAt45  Pointer to an AT45 driver instance.
+ * \param ucBuffer  SRAM buffer, 0 or 1.
+ * \param dwAddress  Address of the page.
+ */
+extern void AT45D_LoadBuffer( At45* pAt45, uint8_t ucBuffer, uint32_t dwAddress )
+{
+    uint32_t dwError ;
+
+    assert( pAt45 != NULL ) ;
+
+    AT45D_WaitReady( pAt45 ) ;
+
+    dwError = AT45_SendCommand( pAt45, ucBuffer ? AT45_PAGE_BUF2_TX : AT45_PAGE_BUF1_TX, 4,
+                                0, 0, dwAddress, 0, 0 ) ;
+    assert( !dwError ) ;
+
+    while ( AT45_IsBusy( pAt45 ) )
+    {
+        AT45D_Wait( pAt45 ) ;
+    }
+
+    /* Wait for the end of the transfer into the buffer */
+    AT45D_WaitReady( pAt45 ) ;
+}
+
+/**
+ * \brief Starts programming one of the SRAM buffers into a main memory page.
+ * The function returns as soon as the command is sent, the device staying busy
+ * for the page program time: AT45D_WaitReady() must be called before the next
+ * command using the main memory.
+ *
+ * \param pAt45  Pointer to an AT45 driver instance.
+ * \param ucBuffer  SRAM buffer, 0 or 1.
+ * \param dwAddress  Address of the destination page.
+ * \param ucErase  Erase the page before programming it when not 0.
+ */
+extern void AT45D_ProgramBuffer( At45* pAt45, uint8_t ucBuffer, uint32_t dwAddress, uint8_t ucErase )
+{
+    uint32_t dwError ;
+    uint8_t ucCmd ;
+
+    assert( pAt45 != NULL ) ;
+
+    if ( ucErase )
+    {
+        ucCmd = ucBuffer ? AT45_BUF2_MEM_ERASE : AT45_BUF1_MEM_ERASE ;
+    }
+    else
+    {
+        ucCmd = ucBuffer ? AT45_BUF2_MEM_NOERASE : AT45_BUF1_MEM_NOERASE ;
+    }
+
+    dwError = AT45_SendCommand( pAt45, ucCmd, 4, 0, 0, dwAddress, 0, 0 ) ;
+    assert( !dwError ) ;
+
+    while ( AT45_IsBusy( pAt45 ) )
+    {
+        AT45D_Wait( pAt45 ) ;
+    }
+}
+
+/**
+ * \brief Writes data over any number of pages of the At45, alternating the two
+ * SRAM buffers: each page is loaded into a buffer while the previous one is
+ * being programmed from the other buffer, and the device status is only polled
+ * before the next page program. Pages partially covered by the data are first
+ * read back into the buffer, so the rest of their content is kept.
+ *
+ * \param pAt45  Pointer to an AT45 driver instance.
+ * \param pucBuffer  Data buffer.
+ * \param dwSize  Number of bytes to write.
+ * \param dwAddress  Destination address on the At45.
+ */
+extern void AT45D_WritePipelined( At45* pAt45, const uint8_t* pucBuffer, uint32_t dwSize, uint32_t dwAddress )
+{
+    uint32_t dwError ;
+    uint32_t dwPageSize ;
+    uint32_t dwOffset ;
+    uint32_t dwChunk ;
+    uint8_t ucBuffer = 0 ;
+
+    assert( pAt45 != NULL ) ;
+    assert( pucBuffer != NULL ) ;
+
+    dwPageSize = AT45_PageSize( pAt45 ) ;
+
+    while ( dwSize )
+    {
+        dwOffset = dwAddress % dwPageSize ;
+        dwChunk = dwPageSize - dwOffset ;
+        if ( dwChunk > dwSize )
+        {
+            dwChunk = dwSize ;
+        }
+
+        /* Partial page, the transfer of its current content into the buffer
+           reads the main memory */
+        if ( dwChunk != dwPageSize )
+        {
+            AT45D_WaitReady( pAt45 ) ;
+
+            dwError = AT45_SendCommand( pAt45, ucBuffer ? AT45_PAGE_BUF2_TX : AT45_PAGE_BUF1_TX, 4,
+                                        0, 0, dwAddress - dwOffset, 0, 0 ) ;
+            assert( !dwError ) ;
+
+            while ( AT45_IsBusy( pAt45 ) )
+            {
+                AT45D_Wait( pAt45 ) ;
+            }
+        }
+
+        /* Load the buffer, possibly while the other one is programmed */
+        AT45D_WriteBuffer( pAt45, ucBuffer, pucBuffer, dwChunk, dwOffset ) ;
+
+        /* Wait for the previous page program then start this one */
+        AT45D_WaitReady( pAt45 ) ;
+        AT45D_ProgramBuffer( pAt45, ucBuffer, dwAddress - dwOffset, 1 ) ;
+
+        ucBuffer ^= 1 ;
+        pucBuffer += dwChunk ;
+        dwAddress += dwChunk ;
+        dwSize -= dwChunk ;
+    }
+
+    /* Wait for the last page program */
+    AT45D_WaitReady( pAt45 ) ;
+}
+
 /**
  * \brief Erases a page of data at the given address in the At45.
  *
@@ -227,7 +451,48 @@ extern void AT45D_Erase( At45* pAt45, uint32_t dwAddress )
 }
 
 /**
- * \brief Configure power-of-2 binary page size in the At45.
+ * \brief Erases a block of 8 pages in the At45.
+ *
+ * \param pAt45  Pointer to an AT45 driver instance.
+ * \param dwAddress  Address of the first page of the block.
+ */
+extern void AT45D_EraseBlock( At45* pAt45, uint32_t dwAddress )
+{
+    uint32_t dwError ;
+
+    assert( pAt45 != NULL ) ;
+
+    /* Issue a block erase command. */
+    dwError = AT45_SendCommand( pAt45, AT45_BLOCK_ERASE, 4, 0, 0, dwAddress, 0, 0 ) ;
+    assert( !dwError ) ;
+
+    /* Wait for end of transfer. */
+    while ( AT45_IsBusy( pAt45 ) )
+    {
+        AT45D_Wait( pAt45 ) ;
+    }
+
+    /* Poll until the At45 has completed the erase operation. */
+    AT45D_WaitReady( pAt45 ) ;
+}
+
+/**
+ * \brief Tells whether the At45 is configured with power-of-2 binary pages.
+ *
+ * \param pAt45  Pointer to an AT45 driver instance.
+ */
+extern uint32_t AT45D_IsBinaryPage( At45* pAt45 )
+{
+    assert( pAt45 != NULL ) ;
+
+    return AT45_STATUS_BINARY( AT45D_GetStatus( pAt45 ) ) ;
+}
+
+/**
+ * \brief Configure power-of-2 binary page size in the At45. The setting is
+ * one-time programmable and takes effect after the next power cycle, when
+ * AT45_FindDevice() picks it up from the status register; nothing is sent if
+ * the device is already configured.
  *
  * \param pAt45  Pointer to an AT45 driver instance.
  */
@@ -237,6 +502,11 @@ extern void AT45D_BinaryPage( At45* pAt45 )
     uint8_t opcode[3]= {AT45_BINARY_PAGE};
     assert( pAt45 != NULL ) ;
 
+    if ( AT45D_IsBinaryPage( pAt45 ) )
+    {
+        return ;
+    }
+
     /* Issue a binary page command. */
 
     dwError = AT45_SendCommand( pAt45, AT45_BINARY_PAGE_FIRST_OPCODE, 1, opcode, 3, 0, 0, 0 ) ;
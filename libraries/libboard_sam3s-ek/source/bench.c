@@ -0,0 +1,408 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Implementation of the benchmark harness.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "board.h"
+
+#include <stdio.h>
+#include <stdarg.h>
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Registered cases, in registration order */
+static BenchCase* _pFirstCase = 0 ;
+static BenchCase* _pLastCase = 0 ;
+
+/** Time source and its frequency */
+static uint8_t _ucTimer = BENCH_TIMER_CYCLES ;
+static uint32_t _dwTimerHz = BOARD_MCK ;
+
+/** Result stream, the console when 0 */
+static BenchWriteFunction _fWrite = 0 ;
+static void* _pWriteArg = 0 ;
+
+/** Iteration times of the current case */
+static uint32_t _adwSamples[BENCH_MAX_SAMPLES] ;
+
+/** Result line being built, and its length */
+static char _szLine[BENCH_LINE_SIZE] ;
+static uint32_t _dwLineLength ;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Appends formatted text to the result line, truncating it if full.
+ */
+static void _BENCH_Append( const char* pszFormat, ... )
+{
+    va_list ap ;
+    int len ;
+
+    if ( _dwLineLength >= sizeof( _szLine ) - 1 )
+    {
+        return ;
+    }
+    va_start( ap, pszFormat ) ;
+    len = vsnprintf( &_szLine[_dwLineLength], sizeof( _szLine ) - _dwLineLength, pszFormat, ap ) ;
+    va_end( ap ) ;
+
+    if ( len > 0 )
+    {
+        _dwLineLength += (uint32_t)len ;
+        if ( _dwLineLength > sizeof( _szLine ) - 1 )
+        {
+            _dwLineLength = sizeof( _szLine ) - 1 ;
+        }
+    }
+}
+
+/**
+ * \brief Appends a JSON string, escaping the quotes and backslashes and
+ * dropping the control characters.
+ */
+static void _BENCH_AppendString( const char* pszString )
+{
+    _BENCH_Append( "\"" ) ;
+    for ( ; (pszString != 0) && (*pszString != 0) ; pszString++ )
+    {
+        if ( (*pszString == '"') || (*pszString == '\\') )
+        {
+            _BENCH_Append( "\\%c", *pszString ) ;
+        }
+        else if ( (uint8_t)*pszString >= ' ' )
+        {
+            _BENCH_Append( "%c", *pszString ) ;
+        }
+    }
+    _BENCH_Append( "\"" ) ;
+}
+
+/**
+ * \brief Starts a result line with its first key.
+ */
+static void _BENCH_StartLine( const char* pszKey, const char* pszValue )
+{
+    _dwLineLength = 0 ;
+    _BENCH_Append( "{\"%s\":", pszKey ) ;
+    _BENCH_AppendString( pszValue ) ;
+}
+
+/**
+ * \brief Closes the result line and writes it to the result stream. The
+ * closing brace and the end of line are kept even if the line was truncated.
+ */
+static void _BENCH_EndLine( void )
+{
+    if ( _dwLineLength > sizeof( _szLine ) - 4 )
+    {
+        _dwLineLength = sizeof( _szLine ) - 4 ;
+    }
+    _szLine[_dwLineLength++] = '}' ;
+    _szLine[_dwLineLength++] = '\n' ;
+    _szLine[_dwLineLength++] = '\r' ;
+    _szLine[_dwLineLength] = 0 ;
+
+    if ( _fWrite )
+    {
+        _fWrite( _szLine, _dwLineLength, _pWriteArg ) ;
+    }
+    else
+    {
+        printf( "%s", _szLine ) ;
+    }
+}
+
+/**
+ * \brief Returns the name of the time unit.
+ */
+static const char* _BENCH_Unit( void )
+{
+    return (_ucTimer == BENCH_TIMER_US) ? "us" : "cycles" ;
+}
+
+/**
+ * \brief Sorts the samples in increasing order (insertion sort, the samples
+ * are few and often nearly sorted).
+ */
+static void _BENCH_Sort( uint32_t* pdwSamples, uint32_t dwCount )
+{
+    uint32_t i ;
+    uint32_t j ;
+    uint32_t dwValue ;
+
+    for ( i = 1 ; i < dwCount ; i++ )
+    {
+        dwValue = pdwSamples[i] ;
+        for ( j = i ; (j > 0) && (pdwSamples[j - 1] > dwValue) ; j-- )
+        {
+            pdwSamples[j] = pdwSamples[j - 1] ;
+        }
+        pdwSamples[j] = dwValue ;
+    }
+}
+
+/**
+ * \brief Returns a percentile of sorted samples (nearest rank).
+ */
+static uint32_t _BENCH_Percentile( const uint32_t* pdwSamples, uint32_t dwCount, uint32_t dwPercent )
+{
+    uint32_t dwRank ;
+
+    dwRank = (dwCount * dwPercent + 99) / 100 ;
+    if ( dwRank == 0 )
+    {
+        dwRank = 1 ;
+    }
+
+    return pdwSamples[dwRank - 1] ;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Adds a case to the list run by BENCH_RunAll().
+ *
+ * \param pCase  Case, which must stay valid.
+ */
+extern void BENCH_Register( BenchCase* pCase )
+{
+    pCase->pNext = 0 ;
+    if ( _pLastCase )
+    {
+        _pLastCase->pNext = pCase ;
+    }
+    else
+    {
+        _pFirstCase = pCase ;
+    }
+    _pLastCase = pCase ;
+}
+
+/**
+ * \brief Selects the time source of the measures.
+ *
+ * \param ucTimer  BENCH_TIMER_CYCLES or BENCH_TIMER_US. BENCH_TIMER_US needs
+ * the timebase started with TimeBase_Configure().
+ * \param dwMck  Core clock in Hz, to convert the cycles to a throughput; 0
+ * keeps BOARD_MCK.
+ */
+extern void BENCH_SetTimer( uint8_t ucTimer, uint32_t dwMck )
+{
+    _ucTimer = ucTimer ;
+    if ( ucTimer == BENCH_TIMER_US )
+    {
+        _dwTimerHz = 1000000 ;
+    }
+    else
+    {
+        _dwTimerHz = dwMck ? dwMck : BOARD_MCK ;
+    }
+}
+
+/**
+ * \brief Sets the stream of the result lines.
+ *
+ * \param fWrite  Function writing a line, 0 for the console.
+ * \param pArg  Argument of fWrite.
+ */
+extern void BENCH_SetOutput( BenchWriteFunction fWrite, void* pArg )
+{
+    _fWrite = fWrite ;
+    _pWriteArg = pArg ;
+}
+
+/**
+ * \brief Returns the current time of the selected time source, for the
+ * benchmarks timing their own sections.
+ */
+extern uint32_t BENCH_GetTime( void )
+{
+    if ( _ucTimer == BENCH_TIMER_US )
+    {
+        return (uint32_t)TimeBase_GetUs() ;
+    }
+
+    return DWT_CYCCNT ;
+}
+
+/**
+ * \brief Runs a case and writes its result line.
+ *
+ * \param pCase  Case to run.
+ * \param pszTag  Firmware identification written in the "tag" field, may be 0.
+ * \param pResult  Receives the statistics, may be 0.
+ */
+extern void BENCH_RunCase( BenchCase* pCase, const char* pszTag, BenchResult* pResult )
+{
+    BenchResult result ;
+    uint32_t dwCount ;
+    uint32_t dwStart ;
+    uint32_t i ;
+    uint64_t qwTotalTime = 0 ;
+    uint64_t qwTotalBytes = 0 ;
+
+    if ( _ucTimer == BENCH_TIMER_CYCLES )
+    {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk ;
+        DWT_CTRL |= DWT_CTRL_CYCCNTENA ;
+    }
+
+    for ( i = 0 ; i < pCase->wWarmup ; i++ )
+    {
+        pCase->fRun( pCase->pArg ) ;
+    }
+
+    dwCount = pCase->wRepeat ;
+    if ( dwCount > BENCH_MAX_SAMPLES )
+    {
+        dwCount = BENCH_MAX_SAMPLES ;
+    }
+    if ( dwCount == 0 )
+    {
+        dwCount = 1 ;
+    }
+
+    result.dwBytes = 0 ;
+    for ( i = 0 ; i < dwCount ; i++ )
+    {
+        dwStart = BENCH_GetTime() ;
+        result.dwBytes = pCase->fRun( pCase->pArg ) ;
+        _adwSamples[i] = BENCH_GetTime() - dwStart ;
+
+        qwTotalTime += _adwSamples[i] ;
+        qwTotalBytes += result.dwBytes ;
+    }
+
+    _BENCH_Sort( _adwSamples, dwCount ) ;
+    result.dwCount = dwCount ;
+    result.dwMin = _adwSamples[0] ;
+    result.dwP50 = _BENCH_Percentile( _adwSamples, dwCount, 50 ) ;
+    result.dwP90 = _BENCH_Percentile( _adwSamples, dwCount, 90 ) ;
+    result.dwP99 = _BENCH_Percentile( _adwSamples, dwCount, 99 ) ;
+    result.dwMax = _adwSamples[dwCount - 1] ;
+    result.dwMean = (uint32_t)(qwTotalTime / dwCount) ;
+    result.dwKBs = 0 ;
+    if ( qwTotalTime && qwTotalBytes )
+    {
+        result.dwKBs = (uint32_t)((qwTotalBytes * _dwTimerHz) / (qwTotalTime * 1024)) ;
+    }
+
+    _BENCH_StartLine( "bench", pCase->pszName ) ;
+    _BENCH_Append( ",\"tag\":" ) ;
+    _BENCH_AppendString( pszTag ) ;
+    _BENCH_Append( ",\"unit\":\"%s\",\"n\":%u,\"min\":%u,\"p50\":%u,\"p90\":%u,\"p99\":%u,\"max\":%u,\"mean\":%u",
+                   _BENCH_Unit(), (unsigned int)result.dwCount, (unsigned int)result.dwMin,
+                   (unsigned int)result.dwP50, (unsigned int)result.dwP90, (unsigned int)result.dwP99,
+                   (unsigned int)result.dwMax, (unsigned int)result.dwMean ) ;
+    if ( result.dwBytes )
+    {
+        _BENCH_Append( ",\"bytes\":%u,\"kbps\":%u", (unsigned int)result.dwBytes, (unsigned int)result.dwKBs ) ;
+    }
+    _BENCH_EndLine() ;
+
+    if ( pResult )
+    {
+        *pResult = result ;
+    }
+}
+
+/**
+ * \brief Runs the registered cases in registration order, after a "meta" line
+ * giving the tag, the time source and the clock.
+ *
+ * \param pszTag  Firmware identification written in each line, may be 0.
+ *
+ * \return Number of cases run.
+ */
+extern uint32_t BENCH_RunAll( const char* pszTag )
+{
+    BenchCase* pCase ;
+    uint32_t dwCount = 0 ;
+
+    _BENCH_StartLine( "meta", "start" ) ;
+    _BENCH_Append( ",\"tag\":" ) ;
+    _BENCH_AppendString( pszTag ) ;
+    _BENCH_Append( ",\"board\":" ) ;
+    _BENCH_AppendString( BOARD_NAME ) ;
+    _BENCH_Append( ",\"unit\":\"%s\",\"hz\":%u", _BENCH_Unit(), (unsigned int)_dwTimerHz ) ;
+    _BENCH_EndLine() ;
+
+    for ( pCase = _pFirstCase ; pCase != 0 ; pCase = pCase->pNext )
+    {
+        BENCH_RunCase( pCase, pszTag, 0 ) ;
+        dwCount++ ;
+    }
+
+    _BENCH_StartLine( "meta", "end" ) ;
+    _BENCH_Append( ",\"cases\":%u", (unsigned int)dwCount ) ;
+    _BENCH_EndLine() ;
+
+    return dwCount ;
+}
+
+/**
+ * \brief Writes a figure measured outside the harness as a result line.
+ *
+ * \param pszBench  Benchmark name.
+ * \param pszTag  Firmware identification, may be 0.
+ * \param pszMetric  Name of the figure, used as the JSON key.
+ * \param dwValue  Value.
+ * \param pszUnit  Unit of the value, may be 0.
+ */
+extern void BENCH_WriteMetric( const char* pszBench, const char* pszTag, const char* pszMetric, uint32_t dwValue, const char* pszUnit )
+{
+    _BENCH_StartLine( "bench", pszBench ) ;
+    _BENCH_Append( ",\"tag\":" ) ;
+    _BENCH_AppendString( pszTag ) ;
+    if ( pszUnit )
+    {
+        _BENCH_Append( ",\"unit\":" ) ;
+        _BENCH_AppendString( pszUnit ) ;
+    }
+    _BENCH_Append( "," ) ;
+    _BENCH_AppendString( pszMetric ) ;
+    _BENCH_Append( ":%u", (unsigned int)dwValue ) ;
+    _BENCH_EndLine() ;
+}
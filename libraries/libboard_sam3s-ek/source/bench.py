@@ -0,0 +1,156 @@
+#!/usr/bin/env python
+# ----------------------------------------------------------------------------
+#         ATMEL Microcontroller Software Support
+# ----------------------------------------------------------------------------
+# Copyright (c) 2010, Atmel Corporation
+#
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# - Redistributions of source code must retain the above copyright notice,
+# this list of conditions and the disclaimer below.
+#
+# Atmel's name may not be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+# IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+# DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+# OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+# EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+# ----------------------------------------------------------------------------
+
+"""Collects and compares the results of the benchmark harness (bench.h).
+
+The firmware writes one JSON object per line; the other console lines are
+ignored. collect reads the lines from a serial port (UART console or CDC
+serial, needs pyserial) until the {"meta":"end"} line, or from a capture
+file, and saves the results. compare matches the benchmarks of two result
+files by name and shows the change of the median (p50) and of the
+throughput; a slowdown above the threshold is a regression, and the exit
+status is 1 when there is one.
+
+    bench.py collect --port /dev/ttyACM0 -o v2.1.jsonl
+    bench.py collect capture.txt -o v2.1.jsonl
+    bench.py compare v2.0.jsonl v2.1.jsonl [--threshold 5]
+"""
+
+import json
+import sys
+
+
+def parse_lines(lines):
+    """Returns the result objects found in the lines."""
+    results = []
+    for line in lines:
+        line = line.strip()
+        if not line.startswith('{'):
+            continue
+        try:
+            results.append(json.loads(line))
+        except ValueError:
+            pass
+    return results
+
+
+def read_serial(port, baud):
+    """Reads the lines of a serial port up to the end of a BENCH_RunAll()."""
+    import serial
+    stream = serial.Serial(port, baud, timeout=1)
+    lines = []
+    while True:
+        line = stream.readline().decode('latin-1')
+        if not line:
+            continue
+        sys.stderr.write(line.replace('\r', ''))
+        lines.append(line)
+        if line.strip().startswith('{"meta":"end"'):
+            return lines
+
+
+def load(path):
+    """Returns the benchmark results of a file, by name (the last one wins)."""
+    with open(path) as f:
+        results = parse_lines(f)
+    return dict((r['bench'], r) for r in results if 'bench' in r)
+
+
+def change(old, new):
+    """Returns the relative change from old to new in percent, or None."""
+    if not old:
+        return None
+    return 100.0 * (new - old) / old
+
+
+def compare(old, new, threshold):
+    """Prints the comparison table, returns the number of regressions."""
+    regressions = 0
+    print('%-32s %12s %12s %8s %9s %9s %8s' % ('bench', 'old p50', 'new p50', 'p50 %',
+                                               'old KB/s', 'new KB/s', 'KB/s %'))
+    for name in sorted(set(old) | set(new)):
+        if name not in old or name not in new:
+            print('%-32s %s' % (name, 'only in new' if name in new else 'only in old'))
+            continue
+        (o, n) = (old[name], new[name])
+        if o.get('unit') != n.get('unit'):
+            print('%-32s units differ (%s, %s)' % (name, o.get('unit'), n.get('unit')))
+            continue
+        flags = []
+        dp50 = change(o.get('p50'), n.get('p50', 0))
+        dkbps = change(o.get('kbps'), n.get('kbps', 0))
+        if dp50 is not None and dp50 > threshold:
+            flags.append('slower')
+        if dkbps is not None and dkbps < -threshold:
+            flags.append('throughput')
+        if flags:
+            regressions += 1
+        print('%-32s %12s %12s %8s %9s %9s %8s %s' % (
+            name, o.get('p50', '-'), n.get('p50', '-'),
+            '-' if dp50 is None else '%+.1f' % dp50,
+            o.get('kbps', '-'), n.get('kbps', '-'),
+            '-' if dkbps is None else '%+.1f' % dkbps,
+            ' '.join(flags)))
+    print('%d regression(s) above %.1f%%' % (regressions, threshold))
+    return regressions
+
+
+def main(argv):
+    import optparse
+    parser = optparse.OptionParser(
+        usage='%prog collect [capture file] -o results\n'
+              '       %prog compare old new')
+    parser.add_option('-p', '--port', help='serial port to read live')
+    parser.add_option('-b', '--baud', type='int', default=115200,
+                      help='serial port baud rate [%default]')
+    parser.add_option('-o', '--output', help='results file written by collect')
+    parser.add_option('-t', '--threshold', type='float', default=5.0,
+                      help='regression threshold in percent [%default]')
+    (options, args) = parser.parse_args(argv[1:])
+
+    if args and args[0] == 'collect':
+        if options.port:
+            lines = read_serial(options.port, options.baud)
+        elif len(args) == 2:
+            lines = open(args[1]).readlines()
+        else:
+            parser.error('give a capture file or a serial port')
+        results = parse_lines(lines)
+        out = open(options.output, 'w') if options.output else sys.stdout
+        for result in results:
+            out.write(json.dumps(result, sort_keys=True) + '\n')
+        sys.stderr.write('%d results\n' % len([r for r in results if 'bench' in r]))
+        return 0
+    if args and args[0] == 'compare' and len(args) == 3:
+        return 1 if compare(load(args[1]), load(args[2]), options.threshold) else 0
+    parser.error('give collect or compare')
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
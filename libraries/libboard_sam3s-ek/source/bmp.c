@@ -48,23 +48,132 @@
 
 
 //------------------------------------------------------------------------------
-//         Internal types
+//         Internal functions
 //------------------------------------------------------------------------------
 
 //------------------------------------------------------------------------------
-/// Describe the BMP palette
+/// Convert a row of 24 bits BMP pixels (B, G, R) to R, G, B. Aligned rows are
+/// processed four pixels (three words) at a time. pSrc and pDst may be the
+/// same buffer.
+/// \param pSrc  Source pixels.
+/// \param pDst  Destination pixels.
+/// \param width  Number of pixels.
 //------------------------------------------------------------------------------
-typedef struct _BMPPaletteEntry
+static void _BMP_SwapRow24( const uint8_t *pSrc, uint8_t *pDst, uint32_t width )
 {
-    /// Blue value
+    const uint32_t *pdwSrc;
+    uint32_t *pdwDst;
+    uint32_t w0, w1, w2;
     uint8_t b;
-    /// Green value
-    uint8_t g;
-    /// Red value
-    uint8_t r;
-    /// Filler character value
-    uint8_t filler;
-} BMPPaletteEntry ;
+
+    if ( (((uint32_t)pSrc | (uint32_t)pDst) & 3) == 0 )
+    {
+        pdwSrc = (const uint32_t*)pSrc;
+        pdwDst = (uint32_t*)pDst;
+
+        // Little endian: w0 = B0 G0 R0 B1, w1 = G1 R1 B2 G2, w2 = R2 B3 G3 R3
+        for ( ; width >= 4 ; width -= 4 )
+        {
+            w0 = *pdwSrc++;
+            w1 = *pdwSrc++;
+            w2 = *pdwSrc++;
+
+            *pdwDst++ = ((w0 >> 16) & 0xFF) | (w0 & 0xFF00) | ((w0 & 0xFF) << 16) | ((w1 & 0xFF00) << 16);
+            *pdwDst++ = (w1 & 0xFF) | ((w0 >> 24) << 8) | ((w2 & 0xFF) << 16) | (w1 & 0xFF000000);
+            *pdwDst++ = ((w1 >> 16) & 0xFF) | ((w2 >> 24) << 8) | (w2 & 0xFF0000) | ((w2 & 0xFF00) << 16);
+        }
+
+        pSrc = (const uint8_t*)pdwSrc;
+        pDst = (uint8_t*)pdwDst;
+    }
+
+    for ( ; width > 0 ; width-- )
+    {
+        b = pSrc[0];
+        pDst[1] = pSrc[1];
+        pDst[0] = pSrc[2];
+        pDst[2] = b;
+        pSrc += 3;
+        pDst += 3;
+    }
+}
+
+//------------------------------------------------------------------------------
+/// Expand a row of 8 bits BMP pixels through the palette. Done from the end of
+/// the row so that pSrc may be the start of pDst.
+/// \param pSrc  Source pixels.
+/// \param pDst  Destination pixels, 3 bytes each.
+/// \param width  Number of pixels.
+/// \param pPalette  Image palette.
+/// \param order  BMP_ORDER_RGB or BMP_ORDER_BGR.
+//------------------------------------------------------------------------------
+static void _BMP_ExpandRow8( const uint8_t *pSrc, uint8_t *pDst, uint32_t width, const BMPPaletteEntry *pPalette, uint8_t order )
+{
+    const BMPPaletteEntry *pEntry;
+
+    pDst += width * 3;
+    while ( width-- > 0 )
+    {
+        pEntry = &pPalette[pSrc[width]];
+        pDst -= 3;
+        if ( order == BMP_ORDER_RGB )
+        {
+            pDst[2] = pEntry->b;
+            pDst[1] = pEntry->g;
+            pDst[0] = pEntry->r;
+        }
+        else
+        {
+            pDst[2] = pEntry->r;
+            pDst[1] = pEntry->g;
+            pDst[0] = pEntry->b;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/// Take bytes from the stream read buffer, refilling it from the file with reads
+/// of the whole buffer size.
+/// \param pStream  Stream.
+/// \param pDst  Destination buffer, or 0 to skip the bytes.
+/// \param size  Number of bytes.
+/// \return Number of bytes taken, less than size at end of file.
+//------------------------------------------------------------------------------
+static uint32_t _BMP_StreamGet( BMPStream *pStream, uint8_t *pDst, uint32_t size )
+{
+    uint32_t done = 0;
+    uint32_t chunk;
+
+    while ( done < size )
+    {
+        if ( pStream->dwBufferCount == 0 )
+        {
+            pStream->dwBufferStart = 0;
+            pStream->dwBufferCount = pStream->Read( pStream->pContext, pStream->pBuffer, pStream->dwBufferSize );
+            if ( pStream->dwBufferCount == 0 )
+            {
+                break;
+            }
+        }
+
+        chunk = size - done;
+        if ( chunk > pStream->dwBufferCount )
+        {
+            chunk = pStream->dwBufferCount;
+        }
+
+        if ( pDst )
+        {
+            memcpy( &pDst[done], &pStream->pBuffer[pStream->dwBufferStart], chunk );
+        }
+
+        done += chunk;
+        pStream->dwBufferStart += chunk;
+        pStream->dwBufferCount -= chunk;
+    }
+
+    return done;
+}
 
 //------------------------------------------------------------------------------
 //         Exported functions
@@ -178,9 +287,13 @@ void BMP_displayHeader( uint32_t* pAddressHeader )
 uint8_t BMP_Decode( void *file, uint8_t *buffer, uint32_t width, uint32_t height, uint8_t bpp )
 {
     BMPHeader *header;
-    uint32_t i, j;
+    uint32_t i;
+#if defined(BOARD_LCD_RGB565)
+    uint32_t j;
     uint8_t r, g, b;
+#endif //#if defined(BOARD_LCD_RGB565)
     uint8_t *image;
+    uint32_t lineBytes;
 
     // Read header information
     header = (BMPHeader*) file;
@@ -205,8 +318,9 @@ uint8_t BMP_Decode( void *file, uint8_t *buffer, uint32_t width, uint32_t height
         return 2;
     }
 
-    // Get image data
+    // Get image data, rows are padded to a multiple of 4 bytes
     image = (uint8_t *) ((uint32_t) file + header->offset);
+    lineBytes = ((width * header->bits + 31) / 32) * 4;
 
     // Check that the bpp resolution is supported
     // Only a 24-bit output & 24- or 8-bit input are supported
@@ -223,16 +337,16 @@ uint8_t BMP_Decode( void *file, uint8_t *buffer, uint32_t width, uint32_t height
             // Decoding is ok
             if (!buffer) return 0;
 
-            // Get image data (swapping red & blue)
+            // Get image data (reversing row order, swapping red & blue)
             for ( i=0 ; i < height ; i++ )
             {
+    #if defined(BOARD_LCD_RGB565)
                 for ( j=0 ; j < width; j++ )
                 {
-                    r = image[((height - i - 1) * width + j) * 3 + 2];
-                    g = image[((height - i - 1) * width + j) * 3 + 1];
-                    b = image[((height - i - 1) * width + j) * 3];
+                    r = image[(height - i - 1) * lineBytes + j * 3 + 2];
+                    g = image[(height - i - 1) * lineBytes + j * 3 + 1];
+                    b = image[(height - i - 1) * lineBytes + j * 3];
 
-    #if defined(BOARD_LCD_RGB565)
                     // Interlacing
                     r = ((r << 1) & 0xF0) | ((g & 0x80) >> 4) | ((r & 0x80) >> 5);
                     g = (g << 1) & 0xF8;
@@ -241,13 +355,10 @@ uint8_t BMP_Decode( void *file, uint8_t *buffer, uint32_t width, uint32_t height
                     buffer[(i * width + j) * 3] = b;
                     buffer[(i * width + j) * 3 + 1] = g;
                     buffer[(i * width + j) * 3 + 2] = r;
-
+                }
     #else
-                    buffer[(i * width + j) * 3] = r;
-                    buffer[(i * width + j) * 3 + 1] = g;
-                    buffer[(i * width + j) * 3 + 2] = b;
+                _BMP_SwapRow24( &image[(height - i - 1) * lineBytes], &buffer[i * width * 3], width );
     #endif //#if defined(BOARD_LCD_RGB565)
-                }
             }
         }
         else
@@ -260,21 +371,13 @@ uint8_t BMP_Decode( void *file, uint8_t *buffer, uint32_t width, uint32_t height
                 if (!buffer) return 0;
 
                 // Retrieve palette
-                memcpy( palette, (uint8_t *) ((uint32_t) file + sizeof( BMPHeader )), header->offset - sizeof( BMPHeader ) ) ;
+                i = header->offset - sizeof( BMPHeader );
+                memcpy( palette, (uint8_t *) ((uint32_t) file + sizeof( BMPHeader )), (i < sizeof( palette )) ? i : sizeof( palette ) ) ;
 
                 // Decode image (reversing row order)
                 for ( i=0 ; i < height ; i++ )
                 {
-                    for (j=0; j < width; j++)
-                    {
-                        r = palette[image[(height - i - 1) * width + j]].r;
-                        g = palette[image[(height - i - 1) * width + j]].g;
-                        b = palette[image[(height - i - 1) * width + j]].b;
-
-                        buffer[(i * width + j) * 3] = r;
-                        buffer[(i * width + j) * 3 + 1] = g;
-                        buffer[(i * width + j) * 3 + 2] = b;
-                    }
+                    _BMP_ExpandRow8( &image[(height - i - 1) * lineBytes], &buffer[i * width * 3], width, palette, BMP_ORDER_RGB );
                 }
             }
             else
@@ -300,20 +403,174 @@ uint8_t BMP_Decode( void *file, uint8_t *buffer, uint32_t width, uint32_t height
 //------------------------------------------------------------------------------
 void RGB565toBGR555( uint8_t *fileSource, uint8_t *fileDestination, uint32_t width, uint32_t height, uint8_t bpp )
 {
-    uint32_t i;
-    uint32_t j;
-    uint32_t row;
+    uint32_t size = width * height * (bpp / 8);
+    const uint32_t *pSrc;
+    uint32_t *pDst;
+    uint32_t w;
 
-    for (i=0; i < height*(bpp/8); i++)
+    // Two pixels per word when both buffers are aligned
+    if ( (((uint32_t)fileSource | (uint32_t)fileDestination) & 3) == 0 )
     {
-        row = (i*width*(bpp/8));
+        pSrc = (const uint32_t*)fileSource;
+        pDst = (uint32_t*)fileDestination;
 
-        for (j=0; j <= width*(bpp/8); j+=2)
+        for ( ; size >= 4 ; size -= 4 )
         {
-            fileDestination[row+j] = ((fileSource[row+j+1]>>3)&0x1F)
-                                    | (fileSource[row+j]&0xE0);
-            fileDestination[row+j+1] = (fileSource[row+j+1]&0x03)
-                                    | ((fileSource[row+j]&0x1F)<<2);
+            w = *pSrc++;
+            *pDst++ = ((w >> 11) & 0x001F001F) | (w & 0x03E003E0) | ((w & 0x001F001F) << 10);
         }
+
+        fileSource = (uint8_t*)pSrc;
+        fileDestination = (uint8_t*)pDst;
+    }
+
+    for ( ; size >= 2 ; size -= 2 )
+    {
+        w = fileSource[0] | (fileSource[1] << 8);
+        w = ((w >> 11) & 0x001F) | (w & 0x03E0) | ((w & 0x001F) << 10);
+        fileDestination[0] = w & 0xFF;
+        fileDestination[1] = w >> 8;
+        fileSource += 2;
+        fileDestination += 2;
     }
 }
+
+//------------------------------------------------------------------------------
+/// Start decoding a BMP file row by row. Reads the header and the palette and
+/// moves to the image data. Only the read buffer and one row are kept in
+/// memory, bottom-up and top-down files are supported.
+/// \param pStream  Stream to initialize.
+/// \param Read  File read function.
+/// \param pContext  Parameter of the read function.
+/// \param pBuffer  Read buffer, a multiple of the file system sector size.
+/// \param dwBufferSize  Read buffer size in bytes.
+/// \param ucOrder  Decoded byte order, BMP_ORDER_RGB or BMP_ORDER_BGR.
+/// \return 0 if the image can be decoded; otherwise returns an error code.
+//------------------------------------------------------------------------------
+uint8_t BMP_StreamOpen( BMPStream *pStream, BMP_ReadFunc Read, void *pContext, uint8_t *pBuffer, uint32_t dwBufferSize, uint8_t ucOrder )
+{
+    BMPHeader *header = &pStream->header;
+    uint32_t colours;
+    uint32_t skip;
+
+    pStream->Read = Read;
+    pStream->pContext = pContext;
+    pStream->pBuffer = pBuffer;
+    pStream->dwBufferSize = dwBufferSize;
+    pStream->dwBufferStart = 0;
+    pStream->dwBufferCount = 0;
+    pStream->ucOrder = ucOrder;
+    pStream->dwRow = 0;
+
+    if ( _BMP_StreamGet( pStream, (uint8_t*)header, sizeof( BMPHeader ) ) != sizeof( BMPHeader ) )
+    {
+        TRACE_ERROR("BMP_StreamOpen: File too short\n\r");
+
+        return 1;
+    }
+
+    if ( !BMP_IsValid( header ) )
+    {
+        TRACE_ERROR("BMP_StreamOpen: File type is not 'BM' (0x%04X).\n\r", header->type);
+
+        return 1;
+    }
+
+    if ( header->compression != 0 )
+    {
+        TRACE_ERROR("BMP_StreamOpen: File format not supported\n\r");
+        TRACE_ERROR(" -> .compression = %u\n\r", (unsigned int)header->compression);
+
+        return 2;
+    }
+
+    // A negative height stands for a top-down file
+    pStream->ucTopDown = ((int32_t)header->height < 0);
+    pStream->dwHeight = pStream->ucTopDown ? -(int32_t)header->height : header->height;
+
+    skip = header->offset - sizeof( BMPHeader );
+
+    switch ( header->bits )
+    {
+        case 24:
+        break;
+
+        case 8:
+            colours = header->ncolours ? header->ncolours : 256;
+            if ( colours > 256 )
+            {
+                colours = 256;
+            }
+            if ( (colours * sizeof( BMPPaletteEntry ) > skip)
+              || (_BMP_StreamGet( pStream, (uint8_t*)pStream->palette, colours * sizeof( BMPPaletteEntry ) ) != colours * sizeof( BMPPaletteEntry )) )
+            {
+                TRACE_ERROR("BMP_StreamOpen: Bad palette\n\r");
+
+                return 2;
+            }
+            skip -= colours * sizeof( BMPPaletteEntry );
+        break;
+
+        default:
+            TRACE_ERROR("BMP_StreamOpen: Input resolution not supported\n\r");
+            TRACE_INFO("header->bits 0x%X \n\r", header->bits);
+
+        return 4;
+    }
+
+    // Move to the image data
+    if ( _BMP_StreamGet( pStream, 0, skip ) != skip )
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+/// Decode the next row of a BMP file, rows come in file order.
+/// \param pStream  Stream opened by BMP_StreamOpen().
+/// \param pRow  Buffer of width * 3 bytes receiving the row, word aligned for
+/// the fastest conversion.
+/// \param pdwY  If not 0, receives the image line of the row (0 at top).
+/// \return 0 if a row has been decoded; otherwise returns an error code.
+//------------------------------------------------------------------------------
+uint8_t BMP_StreamReadRow( BMPStream *pStream, uint8_t *pRow, uint32_t *pdwY )
+{
+    uint32_t width = pStream->header.width;
+    uint32_t pixelBytes = (width * pStream->header.bits) / 8;
+    uint32_t lineBytes = ((width * pStream->header.bits + 31) / 32) * 4;
+
+    if ( pStream->dwRow >= pStream->dwHeight )
+    {
+        return 1;
+    }
+
+    if ( (_BMP_StreamGet( pStream, pRow, pixelBytes ) != pixelBytes)
+      || (_BMP_StreamGet( pStream, 0, lineBytes - pixelBytes ) != lineBytes - pixelBytes) )
+    {
+        TRACE_ERROR("BMP_StreamReadRow: Unexpected end of file\n\r");
+
+        return 1;
+    }
+
+    if ( pStream->header.bits == 8 )
+    {
+        _BMP_ExpandRow8( pRow, pRow, width, pStream->palette, pStream->ucOrder );
+    }
+    else
+    {
+        if ( pStream->ucOrder == BMP_ORDER_RGB )
+        {
+            _BMP_SwapRow24( pRow, pRow, width );
+        }
+    }
+
+    if ( pdwY )
+    {
+        *pdwY = pStream->ucTopDown ? pStream->dwRow : pStream->dwHeight - pStream->dwRow - 1;
+    }
+    pStream->dwRow++;
+
+    return 0;
+}
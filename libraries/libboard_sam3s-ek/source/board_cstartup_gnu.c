@@ -37,6 +37,12 @@
  *        Exported variables
  *----------------------------------------------------------------------------*/
 
+/* Run the interrupts from a copy of the vector table in SRAM when the code
+   is in flash, unless BOARD_RAM_VECTORS is defined to 0 */
+#if !defined(BOARD_RAM_VECTORS)
+#define BOARD_RAM_VECTORS 1
+#endif
+
 /* Stack Configuration */  
 #define STACK_SIZE       0x900     /** Stack size (in DWords) */
 __attribute__ ((aligned(8),section(".stack")))
@@ -124,6 +130,12 @@ IntFunc exception_table[] = {
     IrqHandlerNotUsed   /* 35 not used */
 };
 
+#if (BOARD_RAM_VECTORS == 1)
+/* SRAM copy of the exception table */
+__attribute__((section(".ramvectors")))
+IntFunc ram_exception_table[sizeof( exception_table ) / sizeof( IntFunc )] ;
+#endif
+
 /**
  * \brief This is the code that gets called on processor reset.
  * To initialize the device, and call the main() routine.
@@ -132,29 +144,37 @@ void ResetException( void )
 {
     uint32_t *pSrc, *pDest ;
 
-    /* Low level Initialize */
+    /* Low level Initialize: the PLL runs before the segments are copied */
     LowLevelInit() ;
 
-    /* Initialize the relocate segment */
+    /* Initialize the relocate segment, by bursts of 32 bytes */
     pSrc = &_etext ;
     pDest = &_srelocate ;
 
     if ( pSrc != pDest )
     {
-        for ( ; pDest < &_erelocate ; )
-        {
-            *pDest++ = *pSrc++ ;
-        }
+        MEM_Copy( pDest, pSrc, (uint32_t)&_erelocate - (uint32_t)&_srelocate ) ;
     }
 
-    /* Clear the zero segment */
-    for ( pDest = &_szero ; pDest < &_ezero ; )
-    {
-        *pDest++ = 0;
-    }
+    /* Clear the zero segment; the .noinit section is left as it is */
+    MEM_Zero( &_szero, (uint32_t)&_ezero - (uint32_t)&_szero ) ;
 
     /* Set the vector table base address */
     pSrc = (uint32_t *)&_sfixed;
+
+#if (BOARD_RAM_VECTORS == 1)
+    /* From flash, take the vectors from SRAM: the interrupt latency no longer
+       depends on the flash wait states, nor on a flash programming */
+    if ( ((uint32_t)pSrc < IRAM_ADDR) || ((uint32_t)pSrc >= IRAM_ADDR+IRAM_SIZE) )
+    {
+        for ( pDest = (uint32_t *)ram_exception_table ; pDest < (uint32_t *)&ram_exception_table[sizeof( exception_table ) / sizeof( IntFunc )] ; )
+        {
+            *pDest++ = *pSrc++ ;
+        }
+        pSrc = (uint32_t *)ram_exception_table ;
+    }
+#endif
+
     SCB->VTOR = ( (uint32_t)pSrc & SCB_VTOR_TBLOFF_Msk ) ;
     
     if ( ((uint32_t)pSrc >= IRAM_ADDR) && ((uint32_t)pSrc < IRAM_ADDR+IRAM_SIZE) )
@@ -39,6 +39,60 @@
  *----------------------------------------------------------------------------*/
 #include "board.h"
 
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Alignment of the PSRAM allocations */
+#define PSRAM_ALIGNMENT             8
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+#if defined ( __ICCARM__ )
+#pragma section = ".psram"
+#elif defined ( __GNUC__ )
+/** Bounds of the .psram section and of the PSRAM, from the linker script */
+extern uint8_t _epsram ;
+extern uint8_t _psram_limit ;
+#endif
+
+/** First free byte of the PSRAM, 0 until the first allocation */
+static uint32_t _dwPsramFree = 0 ;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Returns the end of the PSRAM space usable by BOARD_PsramAlloc().
+ */
+static uint32_t _PsramLimit( void )
+{
+#if defined ( __GNUC__ ) && !defined ( __ICCARM__ )
+    return (uint32_t)&_psram_limit ;
+#else
+    /* IAR: PSRAM_region of the .icf file */
+    return BOARD_PSRAM_ADDR + BOARD_PSRAM_SIZE ;
+#endif
+}
+
+/**
+ * \brief Returns the first PSRAM byte after the variables placed with
+ * BOARD_PSRAM_SECTION.
+ */
+static uint32_t _PsramStart( void )
+{
+#if defined ( __ICCARM__ )
+    return (uint32_t)__section_end( ".psram" ) ;
+#elif defined ( __GNUC__ )
+    return (uint32_t)&_epsram ;
+#else
+    return BOARD_PSRAM_ADDR ;
+#endif
+}
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -151,3 +205,49 @@ extern void BOARD_ConfigurePSRAM( Smc* pSmc )
                                      | SMC_MODE_DBW_8_BIT ;
 }
 
+/**
+ * \brief Allocates a buffer in the external PSRAM, after the variables placed
+ * with BOARD_PSRAM_SECTION. The buffers are aligned on 8 bytes and cannot be
+ * freed: the function is meant for the large buffers allocated at startup,
+ * after BOARD_ConfigurePSRAM(). Not reentrant.
+ *
+ * \param dwSize  Size of the buffer in bytes.
+ *
+ * \return Address of the buffer, or NULL if the PSRAM is full.
+ */
+extern void* BOARD_PsramAlloc( uint32_t dwSize )
+{
+    uint32_t dwAddress ;
+
+    if ( _dwPsramFree == 0 )
+    {
+        _dwPsramFree = (_PsramStart() + PSRAM_ALIGNMENT - 1) & ~(uint32_t)(PSRAM_ALIGNMENT - 1) ;
+    }
+
+    if ( dwSize > _PsramLimit() - _dwPsramFree )
+    {
+        return NULL ;
+    }
+
+    dwAddress = _dwPsramFree ;
+    _dwPsramFree = (dwAddress + dwSize + PSRAM_ALIGNMENT - 1) & ~(uint32_t)(PSRAM_ALIGNMENT - 1) ;
+    if ( _dwPsramFree > _PsramLimit() )
+    {
+        _dwPsramFree = _PsramLimit() ;
+    }
+
+    return (void*)dwAddress ;
+}
+
+/**
+ * \brief Returns the PSRAM space left to BOARD_PsramAlloc(), in bytes.
+ */
+extern uint32_t BOARD_PsramGetFreeSize( void )
+{
+    if ( _dwPsramFree == 0 )
+    {
+        return _PsramLimit() - _PsramStart() ;
+    }
+
+    return _PsramLimit() - _dwPsramFree ;
+}
@@ -0,0 +1,228 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ *  \file
+ *  Cooperative boot sequencer, see bootseq.h.
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include "board.h"
+
+#include <stdio.h>
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Tasks in the order they were added */
+static BootSeqTask* _pFirstTask = NULL ;
+static BootSeqTask* _pLastTask = NULL ;
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Ends a task, recording its status and end tick.
+ * The tasks stay in the list for the timing report.
+ */
+static void _BOOTSEQ_End( BootSeqTask* pTask, uint32_t dwStatus, uint32_t dwNow )
+{
+    pTask->dwStatus = dwStatus ;
+    pTask->dwEnd = dwNow ;
+}
+
+/**
+ * \brief Runs the step of a task if it is due.
+ * \return 1 if the task is not finished.
+ */
+static uint32_t _BOOTSEQ_RunTask( BootSeqTask* pTask )
+{
+    uint32_t dwNow = GetTickCount() ;
+    uint32_t dwDelay ;
+
+    if ( pTask->dwStatus >= BOOTSEQ_TASK_DONE )
+    {
+        return 0 ;
+    }
+
+    if ( pTask->dwStatus == BOOTSEQ_TASK_PENDING )
+    {
+        if ( pTask->pAfter != NULL )
+        {
+            if ( pTask->pAfter->dwStatus == BOOTSEQ_TASK_FAILED )
+            {
+                _BOOTSEQ_End( pTask, BOOTSEQ_TASK_FAILED, dwNow ) ;
+                return 0 ;
+            }
+            if ( pTask->pAfter->dwStatus != BOOTSEQ_TASK_DONE )
+            {
+                return 1 ;
+            }
+        }
+        pTask->dwStatus = BOOTSEQ_TASK_RUNNING ;
+        pTask->dwStart = dwNow ;
+    }
+    /* Wrap safe comparison with the wake up tick */
+    else if ( (int32_t)(dwNow - pTask->dwWake) < 0 )
+    {
+        return 1 ;
+    }
+
+    dwDelay = pTask->fStep( pTask->pArg, &pTask->dwState ) ;
+    dwNow = GetTickCount() ;
+
+    if ( dwDelay == BOOTSEQ_DONE )
+    {
+        _BOOTSEQ_End( pTask, BOOTSEQ_TASK_DONE, dwNow ) ;
+        return 0 ;
+    }
+    if ( dwDelay == BOOTSEQ_FAILED )
+    {
+        _BOOTSEQ_End( pTask, BOOTSEQ_TASK_FAILED, dwNow ) ;
+        return 0 ;
+    }
+
+    if ( dwDelay > BOOTSEQ_MAX_DELAY )
+    {
+        dwDelay = BOOTSEQ_MAX_DELAY ;
+    }
+    pTask->dwWake = dwNow + dwDelay ;
+
+    return 1 ;
+}
+
+/*----------------------------------------------------------------------------
+ *         Exported Functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Adds a task to the boot sequencer.
+ * The first step runs at the next BOOTSEQ_Poll(), or once pAfter is done.
+ * A task is added once, it is not removed from the sequencer.
+ * \param pTask     Task instance, kept by the sequencer.
+ * \param pszName   Task name for BOOTSEQ_DisplayTimings().
+ * \param fStep     Step function.
+ * \param pArg      Step function argument.
+ * \param pAfter    Task to be done first, NULL for none.
+ */
+extern void BOOTSEQ_Add( BootSeqTask* pTask, const char* pszName, BootSeqStep fStep, void* pArg, BootSeqTask* pAfter )
+{
+    pTask->pszName = pszName ;
+    pTask->fStep = fStep ;
+    pTask->pArg = pArg ;
+    pTask->pAfter = pAfter ;
+    pTask->pNext = NULL ;
+    pTask->dwState = 0 ;
+    pTask->dwStatus = BOOTSEQ_TASK_PENDING ;
+    pTask->dwWake = 0 ;
+    pTask->dwStart = 0 ;
+    pTask->dwEnd = 0 ;
+
+    if ( _pLastTask == NULL )
+    {
+        _pFirstTask = pTask ;
+    }
+    else
+    {
+        _pLastTask->pNext = pTask ;
+    }
+    _pLastTask = pTask ;
+}
+
+/**
+ * \brief Runs the steps that are due, once each.
+ * \return Number of tasks not finished.
+ */
+extern uint32_t BOOTSEQ_Poll( void )
+{
+    BootSeqTask* pTask ;
+    uint32_t dwLeft = 0 ;
+
+    for ( pTask = _pFirstTask ; pTask != NULL ; pTask = pTask->pNext )
+    {
+        dwLeft += _BOOTSEQ_RunTask( pTask ) ;
+    }
+
+    return dwLeft ;
+}
+
+/**
+ * \brief Runs the steps of all the tasks until the given one is finished.
+ * \param pTask  Task to wait for, NULL to wait for all the tasks.
+ * \return Status of the task (BOOTSEQ_TASK_DONE or BOOTSEQ_TASK_FAILED), or
+ * BOOTSEQ_TASK_DONE when all the tasks are finished.
+ */
+extern uint32_t BOOTSEQ_Run( BootSeqTask* pTask )
+{
+    if ( pTask == NULL )
+    {
+        while ( BOOTSEQ_Poll() != 0 ) ;
+
+        return BOOTSEQ_TASK_DONE ;
+    }
+
+    while ( pTask->dwStatus < BOOTSEQ_TASK_DONE )
+    {
+        if ( BOOTSEQ_Poll() == 0 )
+        {
+            /* Not added to the sequencer */
+            break ;
+        }
+    }
+
+    return pTask->dwStatus ;
+}
+
+/**
+ * \brief Returns the BOOTSEQ_TASK_xxx status of a task.
+ */
+extern uint32_t BOOTSEQ_GetStatus( const BootSeqTask* pTask )
+{
+    return pTask->dwStatus ;
+}
+
+/**
+ * \brief Displays the start and end ticks of the tasks on the console.
+ */
+extern void BOOTSEQ_DisplayTimings( void )
+{
+    static const char* const apszStatus[] = { "pending", "running", "done", "failed" } ;
+    BootSeqTask* pTask ;
+
+    for ( pTask = _pFirstTask ; pTask != NULL ; pTask = pTask->pNext )
+    {
+        printf( "-I- Boot %-8s %-7s %6u - %6u ms\n\r", pTask->pszName, apszStatus[pTask->dwStatus],
+                (unsigned int)pTask->dwStart, (unsigned int)pTask->dwEnd ) ;
+    }
+}
@@ -52,6 +52,8 @@ typedef struct _ClockConfiguration
     uint32_t pllr;
     /** PMC_MCKR register value. */
     uint32_t mckr;
+    /** Flash wait states (EEFC_FMR.FWS) needed at this clock. */
+    uint8_t fws;
 } ClockConfiguration ;
 
 /*----------------------------------------------------------------------------
@@ -72,21 +74,21 @@ static const ClockConfiguration clockConfigurations[] = {
     {24, 24, (CKGR_PLLAR_STUCKTO1 | (7 << CKGR_MUL_SHIFT) \
         | (0x3f << CKGR_PLLCOUNT_SHIFT) \
         | (2 << CKGR_DIV_SHIFT)),
-        ( PMC_MCKR_PRES_CLK_2 | PMC_MCKR_CSS_PLLA_CLK)},
+        ( PMC_MCKR_PRES_CLK_2 | PMC_MCKR_CSS_PLLA_CLK), 1},
     /* PCK = 48 MHz, MCK = 48 MHz
      * PCK = 12000000 * (7+1) / 1 / 2 = 48 MHz
      */
     {48, 48, (CKGR_PLLAR_STUCKTO1 | (7 << CKGR_MUL_SHIFT) \
         | (0x3f << CKGR_PLLCOUNT_SHIFT) \
         | (1 << CKGR_DIV_SHIFT)),
-        ( PMC_MCKR_PRES_CLK_2 | PMC_MCKR_CSS_PLLA_CLK)},
+        ( PMC_MCKR_PRES_CLK_2 | PMC_MCKR_CSS_PLLA_CLK), 2},
     /* PCK = 64 MHz, MCK = 64 MHz
      * PCK = 12000000 * (15+1) / 3 / 1 = 64 MHz
      */
     {64, 64, (CKGR_PLLAR_STUCKTO1 | (15 << CKGR_MUL_SHIFT) \
         | (0x3f << CKGR_PLLCOUNT_SHIFT) \
         | (3 << CKGR_DIV_SHIFT)),
-        ( PMC_MCKR_PRES_CLK | PMC_MCKR_CSS_PLLA_CLK)}
+        ( PMC_MCKR_PRES_CLK | PMC_MCKR_CSS_PLLA_CLK), 3}
 };
 
 /* Number of available clock configurations */
@@ -95,6 +97,52 @@ static const ClockConfiguration clockConfigurations[] = {
 /* Current clock configuration */
 uint32_t currentConfig = 0; /* 0 have to be the default configuration */
 
+/* Registered clock change notifiers */
+static ClockNotifier* pNotifiers = 0;
+
+/* Governor state */
+static uint8_t govRunning = 0;
+static uint8_t govIdleConfig = 0;
+static uint32_t govHoldMs = 0;
+static uint32_t govReleaseTick = 0;
+/* Configuration needed by each client, 0xFF when the client has no load */
+static uint8_t govClientConfig[CLOCK_GOV_CLIENTS];
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Calls the registered notifiers.
+ */
+static void CLOCK_Notify(uint32_t event, uint32_t oldMck, uint32_t newMck)
+{
+    ClockNotifier* pNotifier;
+
+    for (pNotifier = pNotifiers; pNotifier; pNotifier = pNotifier->pNext) {
+
+        pNotifier->fCallback(event, oldMck, newMck, pNotifier->pArg);
+    }
+}
+
+/**
+ * \brief Returns the configuration needed by the governor clients.
+ */
+static uint8_t CLOCK_GovernorTarget(void)
+{
+    uint8_t target = govIdleConfig;
+    uint32_t i;
+
+    for (i = 0; i < CLOCK_GOV_CLIENTS; i++) {
+
+        if ((govClientConfig[i] != 0xFF) && (govClientConfig[i] > target)) {
+
+            target = govClientConfig[i];
+        }
+    }
+    return target;
+}
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -106,9 +154,22 @@ uint32_t currentConfig = 0; /* 0 have to be the default configuration */
  */
 void CLOCK_SetConfig(uint8_t configuration)
 {
+    uint32_t oldMck = clockConfigurations[currentConfig].mck*1000000;
+    uint32_t newMck = clockConfigurations[configuration].mck*1000000;
+    uint8_t oldFws = clockConfigurations[currentConfig].fws;
+    uint8_t newFws = clockConfigurations[configuration].fws;
+
     TRACE_DEBUG("Setting clock configuration #%d ... ", configuration);
+    CLOCK_Notify(CLOCK_NOTIFY_PRE_CHANGE, oldMck, newMck);
     currentConfig = configuration;
 
+    /* The flash must be slowed down before the clock goes up; the main
+     * oscillator used during the switch only needs fewer wait states */
+    if (newFws > oldFws) {
+
+        EFC_SetWaitState(EFC, newFws);
+    }
+
     /* Switch to main oscillator in two operations */
     PMC->PMC_MCKR = (PMC->PMC_MCKR & (uint32_t)~PMC_MCKR_CSS_Msk) | PMC_MCKR_CSS_MAIN_CLK;
     while ((PMC->PMC_SR & PMC_SR_MCKRDY) == 0);
@@ -123,8 +184,15 @@ void CLOCK_SetConfig(uint8_t configuration)
     PMC->PMC_MCKR = clockConfigurations[configuration].mckr;
     while ((PMC->PMC_SR & PMC_SR_MCKRDY) == 0);
 
-    /* DBGU reconfiguration */
-    UART_Configure(115200, clockConfigurations[configuration].mck*1000000);
+    if (newFws < oldFws) {
+
+        EFC_SetWaitState(EFC, newFws);
+    }
+
+    /* System tick and DBGU reconfiguration */
+    TimeTick_SetMck(newMck);
+    UART_Configure(115200, newMck);
+    CLOCK_Notify(CLOCK_NOTIFY_POST_CHANGE, oldMck, newMck);
     TRACE_DEBUG("done.\n\r");
 }
 
@@ -162,6 +230,137 @@ uint16_t CLOCK_GetCurrPCK(void)
     return clockConfigurations[currentConfig].pck;
 }
 
+/**
+ * \brief Get the index of the current configuration
+ */
+uint8_t CLOCK_GetCurrConfig(void)
+{
+    return (uint8_t)currentConfig;
+}
+
+/**
+ * \brief Get the number of configurations, ordered by increasing MCK
+ */
+uint8_t CLOCK_GetNbConfig(void)
+{
+    return NB_CLOCK_CONFIGURATION;
+}
+
+/**
+ * \brief Registers a clock change notifier.
+ *
+ * \param pNotifier  Notifier with its callback set.
+ */
+void CLOCK_RegisterNotifier(ClockNotifier* pNotifier)
+{
+    pNotifier->pNext = pNotifiers;
+    pNotifiers = pNotifier;
+}
+
+/**
+ * \brief Removes a registered clock change notifier.
+ */
+void CLOCK_UnregisterNotifier(ClockNotifier* pNotifier)
+{
+    ClockNotifier** ppNotifier;
+
+    for (ppNotifier = &pNotifiers; *ppNotifier; ppNotifier = &(*ppNotifier)->pNext) {
+
+        if (*ppNotifier == pNotifier) {
+
+            *ppNotifier = pNotifier->pNext;
+            break;
+        }
+    }
+}
+
+/**
+ * \brief Starts the governor, with no load: the clock stays as it is until
+ * the first CLOCK_GovernorPoll().
+ *
+ * \param idleConfig  Configuration used without load.
+ * \param holdMs      Time the clock is kept up after a load went away, in ms.
+ */
+void CLOCK_GovernorStart(uint8_t idleConfig, uint32_t holdMs)
+{
+    uint32_t i;
+
+    for (i = 0; i < CLOCK_GOV_CLIENTS; i++) {
+
+        govClientConfig[i] = 0xFF;
+    }
+    govIdleConfig = (idleConfig < NB_CLOCK_CONFIGURATION) ? idleConfig : 0;
+    govHoldMs = holdMs;
+    govReleaseTick = GetTickCount();
+    govRunning = 1;
+}
+
+/**
+ * \brief Stops the governor, the clock stays as it is.
+ */
+void CLOCK_GovernorStop(void)
+{
+    govRunning = 0;
+}
+
+/**
+ * \brief Declares a load: MCK is raised at once to the configuration if it
+ * is lower.
+ *
+ * \param client  Client index, lower than CLOCK_GOV_CLIENTS.
+ * \param config  Configuration the load needs.
+ */
+void CLOCK_GovernorRequest(uint8_t client, uint8_t config)
+{
+    if ((client >= CLOCK_GOV_CLIENTS) || (config >= NB_CLOCK_CONFIGURATION)) {
+
+        return;
+    }
+    govClientConfig[client] = config;
+
+    if (govRunning && (config > currentConfig)) {
+
+        CLOCK_SetConfig(config);
+    }
+}
+
+/**
+ * \brief Ends the load of a client, MCK is lowered by CLOCK_GovernorPoll()
+ * after the hold time.
+ */
+void CLOCK_GovernorRelease(uint8_t client)
+{
+    if ((client < CLOCK_GOV_CLIENTS) && (govClientConfig[client] != 0xFF)) {
+
+        govClientConfig[client] = 0xFF;
+        govReleaseTick = GetTickCount();
+    }
+}
+
+/**
+ * \brief Lowers MCK to the configuration needed by the remaining loads once
+ * the hold time has elapsed since the last release.
+ */
+void CLOCK_GovernorPoll(void)
+{
+    uint8_t target;
+
+    if (!govRunning) {
+
+        return;
+    }
+
+    target = CLOCK_GovernorTarget();
+    if ((target < currentConfig) && ((GetTickCount() - govReleaseTick) >= govHoldMs)) {
+
+        CLOCK_SetConfig(target);
+    }
+    else if (target > currentConfig) {
+
+        CLOCK_SetConfig(target);
+    }
+}
+
 /**
  * \brief Change clock configuration.
  */
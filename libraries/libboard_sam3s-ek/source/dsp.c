@@ -0,0 +1,692 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Fixed-point DSP kernels.
+ *
+ * Q15 samples are multiplied into 64-bit sums, which GCC maps to SMLAL;
+ * results are brought back with the SSAT saturation. The FFT scales by 1/4
+ * at each radix-4 stage, its output is the transform divided by the size.
+ *
+ */
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include "board.h"
+
+#include <stdint.h>
+#include <string.h>
+#ifdef DSP_BENCHMARK
+#include <stdio.h>
+#endif
+
+/*------------------------------------------------------------------------------
+ *         Local definitions
+ *------------------------------------------------------------------------------*/
+
+/** 2.pi in Q30 */
+#define DSP_TWO_PI_Q30      6746518852LL
+
+/*------------------------------------------------------------------------------
+ *         Local functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * \brief Saturates a value to a signed 16-bit sample.
+ */
+static inline int32_t _Sat16( int32_t lValue )
+{
+#if defined( __GNUC__ ) && defined( __thumb2__ )
+    int32_t lResult ;
+
+    __asm ( "ssat %0, #16, %1" : "=r" (lResult) : "r" (lValue) ) ;
+
+    return lResult ;
+#else
+    if ( lValue > 32767 )
+    {
+        return 32767 ;
+    }
+    if ( lValue < -32768 )
+    {
+        return -32768 ;
+    }
+
+    return lValue ;
+#endif
+}
+
+/**
+ * \brief Saturates a 64-bit sum to a signed 32-bit value.
+ */
+static inline int32_t _Sat32( int64_t llValue )
+{
+    if ( llValue > 0x7FFFFFFFLL )
+    {
+        return 0x7FFFFFFF ;
+    }
+    if ( llValue < -0x80000000LL )
+    {
+        return (int32_t)0x80000000 ;
+    }
+
+    return (int32_t)llValue ;
+}
+
+/**
+ * \brief Integer square root of a 64-bit value.
+ */
+static uint32_t _Sqrt64( uint64_t qwValue )
+{
+    uint64_t qwBit = 1ULL << 62 ;
+    uint64_t qwRoot = 0 ;
+
+    while ( qwBit > qwValue )
+    {
+        qwBit >>= 2 ;
+    }
+    while ( qwBit )
+    {
+        if ( qwValue >= qwRoot + qwBit )
+        {
+            qwValue -= qwRoot + qwBit ;
+            qwRoot = (qwRoot >> 1) + qwBit ;
+        }
+        else
+        {
+            qwRoot >>= 1 ;
+        }
+        qwBit >>= 2 ;
+    }
+
+    return (uint32_t)qwRoot ;
+}
+
+/**
+ * \brief Rounds a Q30 value to Q15.
+ */
+static int16_t _Q30ToQ15( int64_t llValue )
+{
+    return _Sat16( (int32_t)((llValue + (1 << 14)) >> 15) ) ;
+}
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * \brief Converts unsigned ADC samples to Q15, mid-scale becoming 0.
+ *
+ * \param pwIn  ADC samples, as given by the ADC stream.
+ * \param psOut  Q15 samples (may be the input).
+ * \param dwCount  Number of samples.
+ * \param bBits  Resolution of the ADC, 10 or 12.
+ */
+extern void DSP_AdcToQ15( const uint16_t* pwIn, int16_t* psOut, uint32_t dwCount, uint8_t bBits )
+{
+    uint32_t dwShift = 16 - bBits ;
+
+    for ( ; dwCount >= 4 ; dwCount -= 4 )
+    {
+        psOut[0] = (int16_t)((pwIn[0] << dwShift) - 0x8000) ;
+        psOut[1] = (int16_t)((pwIn[1] << dwShift) - 0x8000) ;
+        psOut[2] = (int16_t)((pwIn[2] << dwShift) - 0x8000) ;
+        psOut[3] = (int16_t)((pwIn[3] << dwShift) - 0x8000) ;
+        psOut += 4 ;
+        pwIn += 4 ;
+    }
+    while ( dwCount-- )
+    {
+        *psOut++ = (int16_t)((*pwIn++ << dwShift) - 0x8000) ;
+    }
+}
+
+/**
+ * \brief Converts Q15 samples to Q31.
+ */
+extern void DSP_Q15ToQ31( const int16_t* psIn, int32_t* plOut, uint32_t dwCount )
+{
+    while ( dwCount-- )
+    {
+        *plOut++ = (int32_t)*psIn++ << 16 ;
+    }
+}
+
+/**
+ * \brief Converts Q31 samples to Q15, with rounding.
+ */
+extern void DSP_Q31ToQ15( const int32_t* plIn, int16_t* psOut, uint32_t dwCount )
+{
+    while ( dwCount-- )
+    {
+        *psOut++ = _Sat16( (int32_t)(((int64_t)*plIn++ + 0x8000) >> 16) ) ;
+    }
+}
+
+/**
+ * \brief Initializes a Q15 FIR filter, with a cleared history.
+ *
+ * \param pFir  Filter to initialize.
+ * \param psCoeffs  dwTaps coefficients in Q15, b[0] first.
+ * \param dwTaps  Number of taps.
+ * \param psState  State of dwTaps + dwBlock - 1 samples, dwBlock being the
+ *                 largest block given to DSP_FirQ15().
+ */
+extern void DSP_FirQ15Initialize( DspFirQ15* pFir, const int16_t* psCoeffs, uint32_t dwTaps, int16_t* psState )
+{
+    pFir->psCoeffs = psCoeffs ;
+    pFir->psState = psState ;
+    pFir->dwTaps = dwTaps ;
+    memset( psState, 0, (dwTaps - 1) * sizeof( int16_t ) ) ;
+}
+
+/**
+ * \brief Filters a block of Q15 samples: y[n] = sum b[k].x[n-k].
+ *
+ * \param pFir  Filter.
+ * \param psIn  Input samples.
+ * \param psOut  Output samples (may be the input).
+ * \param dwCount  Number of samples, at most the block size of the state.
+ */
+extern void DSP_FirQ15( DspFirQ15* pFir, const int16_t* psIn, int16_t* psOut, uint32_t dwCount )
+{
+    const int16_t* psCoeffs = pFir->psCoeffs ;
+    int16_t* psState = pFir->psState ;
+    uint32_t dwTaps = pFir->dwTaps ;
+    const int16_t* psC ;
+    const int16_t* psX ;
+    int64_t llAcc ;
+    uint32_t dwCount4 ;
+    uint32_t i ;
+    uint32_t k ;
+
+    /* The history is followed by the new samples */
+    memcpy( psState + dwTaps - 1, psIn, dwCount * sizeof( int16_t ) ) ;
+
+    for ( i = 0 ; i < dwCount ; i++ )
+    {
+        psC = psCoeffs ;
+        psX = psState + i + dwTaps - 1 ;
+        llAcc = 0 ;
+
+        /* Four taps per iteration, b[k] with x[n-k] */
+        for ( dwCount4 = dwTaps >> 2 ; dwCount4 ; dwCount4-- )
+        {
+            llAcc += (int32_t)psC[0] * psX[0] ;
+            llAcc += (int32_t)psC[1] * psX[-1] ;
+            llAcc += (int32_t)psC[2] * psX[-2] ;
+            llAcc += (int32_t)psC[3] * psX[-3] ;
+            psC += 4 ;
+            psX -= 4 ;
+        }
+        for ( k = dwTaps & 3 ; k ; k-- )
+        {
+            llAcc += (int32_t)*psC++ * *psX-- ;
+        }
+
+        psOut[i] = _Sat16( (int32_t)(llAcc >> 15) ) ;
+    }
+
+    /* Keep the last dwTaps - 1 samples as history */
+    memmove( psState, psState + dwCount, (dwTaps - 1) * sizeof( int16_t ) ) ;
+}
+
+/**
+ * \brief Initializes a cascade of Q31 biquads, with a cleared state.
+ *
+ * \param pBiquad  Filter to initialize.
+ * \param plCoeffs  b0, b1, b2, a1, a2 for each stage, see DspBiquadQ31.
+ * \param dwStages  Number of stages.
+ * \param bPostShift  The coefficients are divided by 2^bPostShift.
+ * \param plState  State of 4 x dwStages values.
+ */
+extern void DSP_BiquadQ31Initialize( DspBiquadQ31* pBiquad, const int32_t* plCoeffs, uint32_t dwStages, uint8_t bPostShift, int32_t* plState )
+{
+    pBiquad->plCoeffs = plCoeffs ;
+    pBiquad->plState = plState ;
+    pBiquad->dwStages = dwStages ;
+    pBiquad->bPostShift = bPostShift ;
+    memset( plState, 0, 4 * dwStages * sizeof( int32_t ) ) ;
+}
+
+/**
+ * \brief Filters a block of Q31 samples through the cascade, one stage at a
+ * time over the whole block.
+ *
+ * \param pBiquad  Filter.
+ * \param plIn  Input samples.
+ * \param plOut  Output samples (may be the input).
+ * \param dwCount  Number of samples.
+ */
+extern void DSP_BiquadQ31( DspBiquadQ31* pBiquad, const int32_t* plIn, int32_t* plOut, uint32_t dwCount )
+{
+    const int32_t* plCoeffs = pBiquad->plCoeffs ;
+    int32_t* plState = pBiquad->plState ;
+    uint32_t dwShift = 31 - pBiquad->bPostShift ;
+    const int32_t* plSrc = plIn ;
+    int32_t b0, b1, b2, a1, a2 ;
+    int32_t x0, x1, x2, y1, y2 ;
+    int64_t llAcc ;
+    uint32_t dwStage ;
+    uint32_t i ;
+
+    for ( dwStage = pBiquad->dwStages ; dwStage ; dwStage-- )
+    {
+        b0 = plCoeffs[0] ;
+        b1 = plCoeffs[1] ;
+        b2 = plCoeffs[2] ;
+        a1 = plCoeffs[3] ;
+        a2 = plCoeffs[4] ;
+        x1 = plState[0] ;
+        x2 = plState[1] ;
+        y1 = plState[2] ;
+        y2 = plState[3] ;
+
+        for ( i = 0 ; i < dwCount ; i++ )
+        {
+            x0 = plSrc[i] ;
+            llAcc = (int64_t)b0 * x0 ;
+            llAcc += (int64_t)b1 * x1 ;
+            llAcc += (int64_t)b2 * x2 ;
+            llAcc += (int64_t)a1 * y1 ;
+            llAcc += (int64_t)a2 * y2 ;
+            x2 = x1 ;
+            x1 = x0 ;
+            y2 = y1 ;
+            y1 = _Sat32( llAcc >> dwShift ) ;
+            plOut[i] = y1 ;
+        }
+
+        plState[0] = x1 ;
+        plState[1] = x2 ;
+        plState[2] = y1 ;
+        plState[3] = y2 ;
+        plCoeffs += 5 ;
+        plState += 4 ;
+        /* Next stages work in place on the output */
+        plSrc = plOut ;
+    }
+}
+
+/**
+ * \brief Initializes a radix-4 FFT and computes its twiddles.
+ *
+ * \param pFft  FFT to initialize.
+ * \param dwSize  Number of points: 16, 64, 256, 1024 or 4096.
+ * \param psTwiddles  Storage of 3 x dwSize / 2 halfwords.
+ * \return 0 if successful; 1 if the size is not supported.
+ */
+extern uint32_t DSP_FftQ15Initialize( DspFftQ15* pFft, uint32_t dwSize, int16_t* psTwiddles )
+{
+    int64_t llTheta ;
+    int64_t llTheta2 ;
+    int64_t llCos ;
+    int64_t llSin ;
+    int64_t llC ;
+    int64_t llS ;
+    int64_t llTmp ;
+    uint32_t i ;
+
+    if ( (dwSize < 16) || (dwSize > 4096) || ((dwSize & (dwSize - 1)) != 0) || ((dwSize & 0x1555) == 0) )
+    {
+        return 1 ;
+    }
+    pFft->psTwiddles = psTwiddles ;
+    pFft->dwSize = dwSize ;
+
+    /* Rotation by 2.pi/dwSize from its Taylor series, in Q30 */
+    llTheta = DSP_TWO_PI_Q30 / dwSize ;
+    llTheta2 = (llTheta * llTheta) >> 30 ;
+    llCos = (1LL << 30) - (llTheta2 >> 1) + (((llTheta2 * llTheta2) >> 30) / 24)
+            - (((((llTheta2 * llTheta2) >> 30) * llTheta2) >> 30) / 720) ;
+    llSin = (1LL << 30) - (llTheta2 / 6) + (((llTheta2 * llTheta2) >> 30) / 120)
+            - (((((llTheta2 * llTheta2) >> 30) * llTheta2) >> 30) / 5040) ;
+    llSin = (llSin * llTheta) >> 30 ;
+
+    /* W^k = cos(2.pi.k/N) - j.sin(2.pi.k/N), k < 3N/4 */
+    llC = 1LL << 30 ;
+    llS = 0 ;
+    for ( i = 0 ; i < 3 * dwSize / 4 ; i++ )
+    {
+        psTwiddles[2 * i] = _Q30ToQ15( llC ) ;
+        psTwiddles[2 * i + 1] = _Q30ToQ15( llS ) ;
+        llTmp = (llC * llCos - llS * llSin) >> 30 ;
+        llS = (llS * llCos + llC * llSin) >> 30 ;
+        llC = llTmp ;
+    }
+
+    return 0 ;
+}
+
+/**
+ * \brief Computes in place the forward FFT of dwSize complex Q15 points,
+ * real and imaginary parts interleaved. The result is divided by dwSize and
+ * in natural order.
+ */
+extern void DSP_FftQ15( DspFftQ15* pFft, int16_t* psData )
+{
+    const int16_t* psTwiddles = pFft->psTwiddles ;
+    uint32_t dwSize = pFft->dwSize ;
+    uint32_t dwN1 ;
+    uint32_t dwN2 ;
+    uint32_t dwStep ;
+    uint32_t dwDigits ;
+    uint32_t i0, i1, i2, i3 ;
+    uint32_t i, j, r ;
+    int32_t ar, ai, br, bi, cr, ci, dr, di ;
+    int32_t t0r, t0i, t1r, t1i, t2r, t2i, t3r, t3i ;
+    int32_t c1, s1, c2, s2, c3, s3 ;
+    int32_t yr, yi ;
+    int16_t* psA ;
+    int16_t* psB ;
+    int16_t sTmp ;
+
+    /* Decimation in frequency, 1/4 scaling at each stage */
+    for ( dwN1 = dwSize, dwStep = 1 ; dwN1 > 1 ; dwN1 >>= 2, dwStep <<= 2 )
+    {
+        dwN2 = dwN1 >> 2 ;
+        for ( j = 0 ; j < dwN2 ; j++ )
+        {
+            c1 = psTwiddles[2 * j * dwStep] ;
+            s1 = psTwiddles[2 * j * dwStep + 1] ;
+            c2 = psTwiddles[4 * j * dwStep] ;
+            s2 = psTwiddles[4 * j * dwStep + 1] ;
+            c3 = psTwiddles[6 * j * dwStep] ;
+            s3 = psTwiddles[6 * j * dwStep + 1] ;
+
+            for ( i0 = j ; i0 < dwSize ; i0 += dwN1 )
+            {
+                i1 = i0 + dwN2 ;
+                i2 = i1 + dwN2 ;
+                i3 = i2 + dwN2 ;
+
+                ar = psData[2 * i0] >> 2 ;
+                ai = psData[2 * i0 + 1] >> 2 ;
+                br = psData[2 * i1] >> 2 ;
+                bi = psData[2 * i1 + 1] >> 2 ;
+                cr = psData[2 * i2] >> 2 ;
+                ci = psData[2 * i2 + 1] >> 2 ;
+                dr = psData[2 * i3] >> 2 ;
+                di = psData[2 * i3 + 1] >> 2 ;
+
+                t0r = ar + cr ;
+                t0i = ai + ci ;
+                t1r = ar - cr ;
+                t1i = ai - ci ;
+                t2r = br + dr ;
+                t2i = bi + di ;
+                t3r = br - dr ;
+                t3i = bi - di ;
+
+                psData[2 * i0] = _Sat16( t0r + t2r ) ;
+                psData[2 * i0 + 1] = _Sat16( t0i + t2i ) ;
+
+                if ( dwN2 == 1 )
+                {
+                    /* Last stage: all twiddles are 1 */
+                    psData[2 * i1] = _Sat16( t1r + t3i ) ;
+                    psData[2 * i1 + 1] = _Sat16( t1i - t3r ) ;
+                    psData[2 * i2] = _Sat16( t0r - t2r ) ;
+                    psData[2 * i2 + 1] = _Sat16( t0i - t2i ) ;
+                    psData[2 * i3] = _Sat16( t1r - t3i ) ;
+                    psData[2 * i3 + 1] = _Sat16( t1i + t3r ) ;
+                    continue ;
+                }
+
+                /* (a - j.b - c + j.d).W^j */
+                yr = t1r + t3i ;
+                yi = t1i - t3r ;
+                psData[2 * i1] = _Sat16( (yr * c1 + yi * s1) >> 15 ) ;
+                psData[2 * i1 + 1] = _Sat16( (yi * c1 - yr * s1) >> 15 ) ;
+
+                /* (a - b + c - d).W^2j */
+                yr = t0r - t2r ;
+                yi = t0i - t2i ;
+                psData[2 * i2] = _Sat16( (yr * c2 + yi * s2) >> 15 ) ;
+                psData[2 * i2 + 1] = _Sat16( (yi * c2 - yr * s2) >> 15 ) ;
+
+                /* (a + j.b - c - j.d).W^3j */
+                yr = t1r - t3i ;
+                yi = t1i + t3r ;
+                psData[2 * i3] = _Sat16( (yr * c3 + yi * s3) >> 15 ) ;
+                psData[2 * i3 + 1] = _Sat16( (yi * c3 - yr * s3) >> 15 ) ;
+            }
+        }
+    }
+
+    /* Base 4 digit reversal of the indexes */
+    for ( dwDigits = 0, i = dwSize ; i > 1 ; i >>= 2 )
+    {
+        dwDigits++ ;
+    }
+    for ( i = 1 ; i < dwSize - 1 ; i++ )
+    {
+        for ( r = 0, j = i, i0 = dwDigits ; i0 ; i0--, j >>= 2 )
+        {
+            r = (r << 2) | (j & 3) ;
+        }
+        if ( r > i )
+        {
+            psA = &psData[2 * i] ;
+            psB = &psData[2 * r] ;
+            sTmp = psA[0] ; psA[0] = psB[0] ; psB[0] = sTmp ;
+            sTmp = psA[1] ; psA[1] = psB[1] ; psB[1] = sTmp ;
+        }
+    }
+}
+
+/**
+ * \brief Computes re^2 + im^2 of complex Q15 points, in Q30.
+ */
+extern void DSP_MagnitudeSquaredQ15( const int16_t* psData, uint32_t* pdwOut, uint32_t dwCount )
+{
+    while ( dwCount-- )
+    {
+        *pdwOut++ = (uint32_t)((int32_t)psData[0] * psData[0]) + (uint32_t)((int32_t)psData[1] * psData[1]) ;
+        psData += 2 ;
+    }
+}
+
+/**
+ * \brief Returns the RMS value of a block of Q15 samples.
+ */
+extern int16_t DSP_RmsQ15( const int16_t* psIn, uint32_t dwCount )
+{
+    uint64_t qwSum = 0 ;
+    uint32_t dwRms ;
+    uint32_t i ;
+
+    if ( dwCount == 0 )
+    {
+        return 0 ;
+    }
+
+    for ( i = dwCount ; i >= 4 ; i -= 4 )
+    {
+        qwSum += (int32_t)psIn[0] * psIn[0] ;
+        qwSum += (int32_t)psIn[1] * psIn[1] ;
+        qwSum += (int32_t)psIn[2] * psIn[2] ;
+        qwSum += (int32_t)psIn[3] * psIn[3] ;
+        psIn += 4 ;
+    }
+    while ( i-- )
+    {
+        qwSum += (int32_t)*psIn * *psIn ;
+        psIn++ ;
+    }
+
+    dwRms = _Sqrt64( qwSum / dwCount ) ;
+
+    return (dwRms > 32767) ? 32767 : dwRms ;
+}
+
+/**
+ * \brief Returns the largest absolute value of a block of Q15 samples.
+ *
+ * \param psIn  Samples.
+ * \param dwCount  Number of samples.
+ * \param pdwIndex  Receives the index of the peak, if not 0.
+ */
+extern int16_t DSP_PeakQ15( const int16_t* psIn, uint32_t dwCount, uint32_t* pdwIndex )
+{
+    int32_t lPeak = 0 ;
+    int32_t lValue ;
+    uint32_t dwIndex = 0 ;
+    uint32_t i ;
+
+    for ( i = 0 ; i < dwCount ; i++ )
+    {
+        lValue = psIn[i] ;
+        if ( lValue < 0 )
+        {
+            lValue = -lValue ;
+        }
+        if ( lValue > lPeak )
+        {
+            lPeak = lValue ;
+            dwIndex = i ;
+        }
+    }
+
+    if ( pdwIndex )
+    {
+        *pdwIndex = dwIndex ;
+    }
+
+    return (lPeak > 32767) ? 32767 : lPeak ;
+}
+
+/**
+ * \brief Returns the mean of a block of Q15 samples.
+ */
+extern int32_t DSP_MeanQ15( const int16_t* psIn, uint32_t dwCount )
+{
+    int32_t lSum = 0 ;
+    uint32_t i ;
+
+    if ( dwCount == 0 )
+    {
+        return 0 ;
+    }
+
+    for ( i = dwCount ; i >= 4 ; i -= 4 )
+    {
+        lSum += psIn[0] + psIn[1] + psIn[2] + psIn[3] ;
+        psIn += 4 ;
+    }
+    while ( i-- )
+    {
+        lSum += *psIn++ ;
+    }
+
+    return lSum / (int32_t)dwCount ;
+}
+
+#ifdef DSP_BENCHMARK
+/**
+ * \brief Measures the kernels with the DWT cycle counter on 256 samples and
+ * prints the cycles per sample on the console.
+ *
+ * \param psWork  Work area of DSP_BENCH_WORK_SIZE halfwords, word aligned.
+ */
+extern void DSP_Benchmark( int16_t* psWork )
+{
+    int16_t* psIn = psWork ;
+    int16_t* psOut = psIn + 256 ;
+    int16_t* psState = psOut + 256 ;
+    int16_t* psCoeffs = psState + 256 + 63 + 1 ;
+    int16_t* psTwiddles = psCoeffs + 64 ;
+    int16_t* psFftData = psTwiddles + 384 ;
+    int32_t* plSamples = (int32_t*)(psFftData + 512) ;
+    int32_t* plState = plSamples + 256 ;
+    static const int32_t alBiquad[5] = { 0x04000000, 0x08000000, 0x04000000, 0x40000000, -0x10000000 } ;
+    int32_t alCoeffs[4 * 5] ;
+    DspFirQ15 fir ;
+    DspBiquadQ31 biquad ;
+    DspFftQ15 fft ;
+    uint32_t dwCycles ;
+    uint32_t i ;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk ;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA ;
+
+    for ( i = 0 ; i < 256 ; i++ )
+    {
+        psIn[i] = (int16_t)((i * 2654435761u) >> 17) ;
+    }
+    for ( i = 0 ; i < 64 ; i++ )
+    {
+        psCoeffs[i] = 512 ;
+    }
+    for ( i = 0 ; i < 4 ; i++ )
+    {
+        memcpy( &alCoeffs[5 * i], alBiquad, sizeof( alBiquad ) ) ;
+    }
+
+    printf( "-I- DSP kernels, cycles per sample:\n\r" ) ;
+
+    DSP_FirQ15Initialize( &fir, psCoeffs, 64, psState ) ;
+    dwCycles = DWT_CYCCNT ;
+    DSP_FirQ15( &fir, psIn, psOut, 256 ) ;
+    dwCycles = DWT_CYCCNT - dwCycles ;
+    printf( "  FIR Q15, 64 taps      : %u\n\r", (unsigned int)(dwCycles / 256) ) ;
+
+    DSP_Q15ToQ31( psIn, plSamples, 256 ) ;
+    DSP_BiquadQ31Initialize( &biquad, alCoeffs, 4, 1, plState ) ;
+    dwCycles = DWT_CYCCNT ;
+    DSP_BiquadQ31( &biquad, plSamples, plSamples, 256 ) ;
+    dwCycles = DWT_CYCCNT - dwCycles ;
+    printf( "  Biquad Q31, 4 stages  : %u\n\r", (unsigned int)(dwCycles / 256) ) ;
+
+    DSP_FftQ15Initialize( &fft, 256, psTwiddles ) ;
+    for ( i = 0 ; i < 256 ; i++ )
+    {
+        psFftData[2 * i] = psIn[i] ;
+        psFftData[2 * i + 1] = 0 ;
+    }
+    dwCycles = DWT_CYCCNT ;
+    DSP_FftQ15( &fft, psFftData ) ;
+    dwCycles = DWT_CYCCNT - dwCycles ;
+    printf( "  FFT Q15, 256 points   : %u (%u per FFT)\n\r", (unsigned int)(dwCycles / 256), (unsigned int)dwCycles ) ;
+
+    dwCycles = DWT_CYCCNT ;
+    DSP_RmsQ15( psIn, 256 ) ;
+    dwCycles = DWT_CYCCNT - dwCycles ;
+    printf( "  RMS Q15               : %u\n\r", (unsigned int)(dwCycles / 256) ) ;
+
+    dwCycles = DWT_CYCCNT ;
+    DSP_PeakQ15( psIn, 256, 0 ) ;
+    dwCycles = DWT_CYCCNT - dwCycles ;
+    printf( "  Peak Q15              : %u\n\r", (unsigned int)(dwCycles / 256) ) ;
+}
+#endif /* DSP_BENCHMARK */
@@ -40,8 +40,6 @@
 #include <stdint.h>
 #include <string.h>
 
-/** Frame buffer color cache size used to optimize memcpy */
-#define FB_COLOR_CACHE_SIZE 8
 /*----------------------------------------------------------------------------
  *        Local variables
  *----------------------------------------------------------------------------*/
@@ -50,39 +48,30 @@
 */
 static LcdColor_t *gpBuffer;
 /** Frame buffer width */
-static uint8_t gucWidth;
+static uint16_t gwWidth;
 /** Frame buffer height */
-static uint8_t gucHeight;
-/* Pixel color cache */
-static LcdColor_t gFbPixelCache[FB_COLOR_CACHE_SIZE];
+static uint16_t gwHeight;
+/** Screen coordinates of the frame buffer first pixel */
+static uint32_t gdwOriginX;
+static uint32_t gdwOriginY;
+/* Current drawing color */
+static LcdColor_t gFbColor;
 
 /*----------------------------------------------------------------------------
  *        Static functions
  *----------------------------------------------------------------------------*/
 /**
- * \brief Check Box coordinates. Return upper left and bottom right coordinates.
+ * \brief Sort Box coordinates. Return upper left and bottom right coordinates.
  *
  * \param pX1      X-coordinate of upper-left corner on LCD.
  * \param pY1      Y-coordinate of upper-left corner on LCD.
  * \param pX2      X-coordinate of lower-right corner on LCD.
  * \param pY2      Y-coordinate of lower-right corner on LCD.
  */
-static void CheckBoxCoordinates( uint32_t *pX1, uint32_t *pY1, uint32_t *pX2, uint32_t *pY2 )
+static void SortBoxCoordinates( uint32_t *pX1, uint32_t *pY1, uint32_t *pX2, uint32_t *pY2 )
 {
     uint32_t dw;
 
-    if ( *pX1 >= gucWidth )
-        *pX1=gucWidth-1 ;
-
-    if ( *pX2 >= gucWidth )
-        *pX2=gucWidth-1 ;
-
-    if ( *pY1 >= gucHeight )
-        *pY1=gucHeight-1 ;
-
-    if ( *pY2 >= gucHeight )
-        *pY2=gucHeight-1 ;
-
     if (*pX1 > *pX2) {
         dw = *pX1;
         *pX1 = *pX2;
@@ -95,6 +84,38 @@ static void CheckBoxCoordinates( uint32_t *pX1, uint32_t *pY1, uint32_t *pX2, ui
     }
 }
 
+/**
+ * \brief Check Box coordinates. Sort them, clip the box to the frame buffer
+ * area and convert them to frame buffer coordinates.
+ *
+ * \param pX1      X-coordinate of upper-left corner on LCD.
+ * \param pY1      Y-coordinate of upper-left corner on LCD.
+ * \param pX2      X-coordinate of lower-right corner on LCD.
+ * \param pY2      Y-coordinate of lower-right corner on LCD.
+ *
+ * \return 0 if the box is outside of the frame buffer, 1 otherwise.
+ */
+static uint32_t CheckBoxCoordinates( uint32_t *pX1, uint32_t *pY1, uint32_t *pX2, uint32_t *pY2 )
+{
+    SortBoxCoordinates(pX1, pY1, pX2, pY2);
+
+    if ((*pX2 < gdwOriginX) || (*pX1 >= gdwOriginX + gwWidth)
+     || (*pY2 < gdwOriginY) || (*pY1 >= gdwOriginY + gwHeight)) {
+        return 0;
+    }
+
+    *pX1 = (*pX1 < gdwOriginX) ? 0 : *pX1 - gdwOriginX;
+    *pY1 = (*pY1 < gdwOriginY) ? 0 : *pY1 - gdwOriginY;
+    *pX2 -= gdwOriginX;
+    *pY2 -= gdwOriginY;
+    if (*pX2 >= gwWidth)
+        *pX2 = gwWidth - 1;
+    if (*pY2 >= gwHeight)
+        *pY2 = gwHeight - 1;
+
+    return 1;
+}
+
 /*
  * \brief Draw a line on LCD, which is not horizontal or vertical.
  *
@@ -167,19 +188,36 @@ static uint32_t DrawLineBresenham( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2,
 /**
  * \brief Configure the current frame buffer.
  * Next frame buffer operations will take place in this frame buffer area.
+ * The frame buffer origin is reset to (0, 0).
  * \param pBuffer 16 bit aligned sram buffer. PDC shall be able to access this
  *        memory area.
- * \param ucWidth frame buffer width
- * \param ucHeight frame buffer height
+ * \param wWidth frame buffer width
+ * \param wHeight frame buffer height
  */
-extern void FB_SetFrameBuffer(LcdColor_t *pBuffer, uint8_t ucWidth, uint8_t ucHeight)
+extern void FB_SetFrameBuffer(LcdColor_t *pBuffer, uint16_t wWidth, uint16_t wHeight)
 {
     /* Sanity check */
     assert(pBuffer != NULL);
 
     gpBuffer = pBuffer;
-    gucWidth = ucWidth;
-    gucHeight = ucHeight;
+    gwWidth = wWidth;
+    gwHeight = wHeight;
+    gdwOriginX = 0;
+    gdwOriginY = 0;
+}
+
+/**
+ * \brief Place the frame buffer on the screen. Drawing coordinates are screen
+ * coordinates; what falls outside of the frame buffer area is clipped, so a
+ * small buffer can render the screen tile by tile.
+ *
+ * \param dwX  Screen X-coordinate of the frame buffer first pixel.
+ * \param dwY  Screen Y-coordinate of the frame buffer first pixel.
+ */
+extern void FB_SetOrigin(uint32_t dwX, uint32_t dwY)
+{
+    gdwOriginX = dwX;
+    gdwOriginY = dwY;
 }
 
 
@@ -190,17 +228,7 @@ extern void FB_SetFrameBuffer(LcdColor_t *pBuffer, uint8_t ucWidth, uint8_t ucHe
  */
 extern void FB_SetColor(uint32_t dwRgb24Bits)
 {
-    uint16_t i;
-//    LcdColor_t wColor;
-
-//    wColor = (dwRgb24Bits & 0xF80000) >> 8 |
-//             (dwRgb24Bits & 0x00FC00) >> 5 |
-//             (dwRgb24Bits & 0x0000F8) >> 3;
-
-    /* Fill the cache with selected color */
-    for (i = 0; i < FB_COLOR_CACHE_SIZE; ++i) {
-        gFbPixelCache[i] = dwRgb24Bits ;
-    }
+    gFbColor = dwRgb24Bits ;
 }
 /**
  * \brief Draw a pixel on FB of given color.
@@ -214,10 +242,12 @@ extern uint32_t FB_DrawPixel(
     uint32_t dwX,
     uint32_t dwY)
 {
-    if ((dwX >= gucWidth) || (dwY >= gucHeight)) {
+    dwX -= gdwOriginX;
+    dwY -= gdwOriginY;
+    if ((dwX >= gwWidth) || (dwY >= gwHeight)) {
         return 1;
     }
-    gpBuffer[dwX + dwY * gucWidth] = gFbPixelCache[0];
+    gpBuffer[dwX + dwY * gwWidth] = gFbColor;
 
     return 0;
 }
@@ -225,9 +255,7 @@ extern uint32_t FB_DrawPixel(
 /**
  * \brief Write several pixels with the same color to FB.
  *
- * Pixel color is set by the LCD_SetColor() function.
- * This function is optimized using an sram buffer to transfer block instead of
- * individual pixels in order to limit the number of SPI interrupts.
+ * Pixel color is set by the FB_SetColor() function.
  * \param dwX1      X-coordinate of upper-left corner on LCD.
  * \param dwY1      Y-coordinate of upper-left corner on LCD.
  * \param dwX2      X-coordinate of lower-right corner on LCD.
@@ -237,26 +265,20 @@ extern uint32_t FB_DrawPixel(
  */
 extern uint32_t FB_DrawFilledRectangle( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2 )
 {
-    LcdColor_t *pFbBuffer, *pDestFbBuffer;
-    uint32_t dwY, blocks, bytes;
-
-    /* Swap coordinates if necessary */
-    CheckBoxCoordinates(&dwX1, &dwY1, &dwX2, &dwY2);
+    LcdColor_t *pFbBuffer;
+    uint32_t dwX, dwY;
 
-    blocks  = ((dwX2 - dwX1 + 1) / FB_COLOR_CACHE_SIZE);
-    bytes   = ((dwX2 - dwX1 + 1) % FB_COLOR_CACHE_SIZE);
+    /* Swap coordinates if necessary, clip to the frame buffer */
+    if (!CheckBoxCoordinates(&dwX1, &dwY1, &dwX2, &dwY2)) {
+        return 0;
+    }
 
-    /* Each row is sent by block to benefit from memcpy optimizations */
-    pFbBuffer = &(gpBuffer[dwY1 * gucWidth + dwX1]);
+    pFbBuffer = &(gpBuffer[dwY1 * gwWidth]);
     for (dwY = dwY1; dwY <= dwY2; ++dwY) {
-        pDestFbBuffer = pFbBuffer;
-        while (blocks--) {
-            memcpy(pDestFbBuffer, gFbPixelCache, FB_COLOR_CACHE_SIZE * sizeof(LcdColor_t));
-            pDestFbBuffer += FB_COLOR_CACHE_SIZE;
-
+        for (dwX = dwX1; dwX <= dwX2; ++dwX) {
+            pFbBuffer[dwX] = gFbColor;
         }
-       memcpy(pDestFbBuffer, gFbPixelCache, bytes * sizeof(LcdColor_t));
-       pFbBuffer += gucWidth;
+        pFbBuffer += gwWidth;
     }
 
     return 0;
@@ -273,21 +295,68 @@ extern uint32_t FB_DrawFilledRectangle( uint32_t dwX1, uint32_t dwY1, uint32_t d
  */
 extern uint32_t FB_DrawPicture( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2, const void *pBuffer )
 {
+    const LcdColor_t *pPicture = (const LcdColor_t *)pBuffer;
     LcdColor_t *pFbBuffer;
-    uint32_t dwY;
+    uint32_t dwX, dwY, dwStride;
 
-    /* Swap coordinates if necessary */
-    CheckBoxCoordinates(&dwX1, &dwY1, &dwX2, &dwY2);
+    SortBoxCoordinates(&dwX1, &dwY1, &dwX2, &dwY2);
+    dwStride = dwX2 - dwX1 + 1;
+    dwX = dwX1;
+    dwY = dwY1;
 
-    pFbBuffer = &(gpBuffer[dwY1 * gucWidth + dwX1]);
+    /* Clip to the frame buffer, skip the hidden part of the picture */
+    if (!CheckBoxCoordinates(&dwX1, &dwY1, &dwX2, &dwY2)) {
+        return 0;
+    }
+    pPicture += (dwY1 + gdwOriginY - dwY) * dwStride + (dwX1 + gdwOriginX - dwX);
+
+    pFbBuffer = &(gpBuffer[dwY1 * gwWidth + dwX1]);
     for (dwY = dwY1; dwY <= dwY2; ++dwY) {
-       memcpy(pFbBuffer, pBuffer, (dwX2 - dwX1 + 1) * sizeof(LcdColor_t));
-       pFbBuffer += gucWidth;
+       memcpy(pFbBuffer, pPicture, (dwX2 - dwX1 + 1) * sizeof(LcdColor_t));
+       pFbBuffer += gwWidth;
+       pPicture += dwStride;
     }
 
     return 0 ;
 }
 
+/**
+ * \brief Write an RGB image (3 bytes per pixel, red first) to FB.
+ *
+ * \param dwX       X-coordinate of upper-left corner on LCD.
+ * \param dwY       Y-coordinate of upper-left corner on LCD.
+ * \param dwWidth   image width.
+ * \param dwHeight  image height.
+ * \param pucImage  image data.
+ */
+extern uint32_t FB_DrawImage( uint32_t dwX, uint32_t dwY, uint32_t dwWidth, uint32_t dwHeight, const uint8_t *pucImage )
+{
+    LcdColor_t *pFbBuffer;
+    const uint8_t *pucLine;
+    uint32_t dwX1, dwY1, dwX2, dwY2, dwCol, dwRow;
+
+    if ((dwWidth == 0) || (dwHeight == 0)) {
+        return 0;
+    }
+    dwX1 = dwX;
+    dwY1 = dwY;
+    dwX2 = dwX + dwWidth - 1;
+    dwY2 = dwY + dwHeight - 1;
+    if (!CheckBoxCoordinates(&dwX1, &dwY1, &dwX2, &dwY2)) {
+        return 0;
+    }
+
+    for (dwRow = dwY1; dwRow <= dwY2; ++dwRow) {
+        pFbBuffer = &(gpBuffer[dwRow * gwWidth]);
+        pucLine = pucImage + ((dwRow + gdwOriginY - dwY) * dwWidth + (dwX1 + gdwOriginX - dwX)) * 3;
+        for (dwCol = dwX1; dwCol <= dwX2; ++dwCol, pucLine += 3) {
+            pFbBuffer[dwCol] = (pucLine[0] << 16) | (pucLine[1] << 8) | pucLine[2];
+        }
+    }
+
+    return 0;
+}
+
 /*
  * \brief Draw a line on LCD, horizontal and vertical line are supported.
  *
@@ -408,9 +477,7 @@ extern uint32_t FB_DrawFilledCircle( uint32_t dwX, uint32_t dwY, uint32_t dwRadi
 }
 
 /**
-* Pixel color is set by the LCD_SetColor() function.
-* This function is optimized using an sram buffer to transfer block instead of
-* individual pixels in order to limit the number of SPI interrupts.
+* Draw a rectangle frame. Pixel color is set by the FB_SetColor() function.
 * \param dwX1      X-coordinate of upper-left corner on LCD.
 * \param dwY1      Y-coordinate of upper-left corner on LCD.
 * \param dwX2      X-coordinate of lower-right corner on LCD.
@@ -420,7 +487,7 @@ extern uint32_t FB_DrawFilledCircle( uint32_t dwX, uint32_t dwY, uint32_t dwRadi
 */
 extern uint32_t FB_DrawRectangle( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2 )
 {
-    CheckBoxCoordinates(&dwX1, &dwY1, &dwX2, &dwY2);
+    SortBoxCoordinates(&dwX1, &dwY1, &dwX2, &dwY2);
 
     FB_DrawFilledRectangle( dwX1, dwY1, dwX2, dwY1 ) ;
     FB_DrawFilledRectangle( dwX1, dwY2, dwX2, dwY2 ) ;
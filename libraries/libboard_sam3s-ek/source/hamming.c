@@ -33,6 +33,32 @@
 
 #include "board.h"
 
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Parity of the low nibble of x (0x6996 holds the parity of 0 to 15) */
+#define NIBBLEPARITY(x)     ((0x6996 >> ((x) & 0xF)) & 1)
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Number of bits set in each nibble value */
+static const uint8_t _aucBitsInNibble[16] =
+{
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+} ;
+
+/** Nibble bits spread to the even bit positions (bit n moved to bit 2n) */
+static const uint8_t _aucSpreadNibble[16] =
+{
+    0x00, 0x01, 0x04, 0x05, 0x10, 0x11, 0x14, 0x15,
+    0x40, 0x41, 0x44, 0x45, 0x50, 0x51, 0x54, 0x55
+} ;
+
 /*----------------------------------------------------------------------------
  *         Internal function
  *----------------------------------------------------------------------------*/
@@ -43,18 +69,16 @@
  */
 static uint8_t CountBitsInByte(uint8_t byte)
 {
-    uint8_t count = 0;
-
-    while (byte > 0)
-    {
-        if (byte & 1)
-        {
-            count++;
-        }
-        byte >>= 1;
-    }
+    return _aucBitsInNibble[byte & 0xF] + _aucBitsInNibble[byte >> 4];
+}
 
-    return count;
+/**
+ *  Returns the parity (1 if the number of bits set is odd) of the given byte.
+ *  \param byte  Byte to check.
+ */
+static uint32_t ParityOfByte(uint32_t byte)
+{
+    return NIBBLEPARITY(byte ^ (byte >> 4));
 }
 
 /**
@@ -66,6 +90,17 @@ static uint8_t CountBitsInCode256(uint8_t *code)
     return CountBitsInByte(code[0]) + CountBitsInByte(code[1]) + CountBitsInByte(code[2]);
 }
 
+/**
+ *  Interleaves two nibbles, to obtain the layout of a code byte:
+ *  odd3 even3 odd2 even2 odd1 even1 odd0 even0.
+ *  \param odd  Nibble of the odd parity groups.
+ *  \param even  Nibble of the even parity groups.
+ */
+static uint8_t Interleave(uint32_t odd, uint32_t even)
+{
+    return (_aucSpreadNibble[odd & 0xF] << 1) | _aucSpreadNibble[even & 0xF];
+}
+
 /**
  *  Calculates the 22-bit hamming code for a 256-bytes block of data.
  *  \param data  Data buffer to calculate code for.
@@ -74,66 +109,92 @@ static uint8_t CountBitsInCode256(uint8_t *code)
 static void Compute256(const uint8_t *data, uint8_t *code)
 {
     uint32_t i;
-    uint8_t columnSum = 0;
-    uint8_t evenLineCode = 0;
-    uint8_t oddLineCode = 0;
-    uint8_t evenColumnCode = 0;
-    uint8_t oddColumnCode = 0;
-
-    // Xor all bytes together to get the column sum;
-    // At the same time, calculate the even and odd line codes
-    for (i=0; i < 256; i++)
+    uint32_t word;
+    uint32_t columnWord = 0;
+    uint32_t columnSum;
+    uint32_t parity;
+    uint32_t evenLineCode;
+    uint32_t oddLineCode = 0;
+    uint32_t evenColumnCode;
+    uint32_t oddColumnCode = 0;
+
+    // Parity groups are formed by forcing a particular index bit to 0
+    // (even) or 1 (odd).
+    // Example on one byte:
+    //
+    // bits (dec)  7   6   5   4   3   2   1   0
+    //      (bin) 111 110 101 100 011 010 001 000
+    //                            '---'---'---'----------.
+    //                                                   |
+    // groups P4' ooooooooooooooo eeeeeeeeeeeeeee P4     |
+    //        P2' ooooooo eeeeeee ooooooo eeeeeee P2     |
+    //        P1' ooo eee ooo eee ooo eee ooo eee P1     |
+    //                                                   |
+    // We can see that:                                  |
+    //  - P4  -> bit 2 of index is 0 --------------------'
+    //  - P4' -> bit 2 of index is 1.
+    //  - P2  -> bit 1 of index if 0.
+    //  - etc...
+    // We deduce that a bit position has an impact on all even Px if
+    // the log2(x)nth bit of its index is 0
+    //     ex: log2(4) = 2, bit2 of the index must be 0 (-> 0 1 2 3)
+    // and on all odd Px' if the log2(x)nth bit of its index is 1
+    //     ex: log2(2) = 1, bit1 of the index must be 1 (-> 0 1 4 5)
+    //
+    // The line codes are the xor of the indexes of the bytes having an odd
+    // parity (odd groups), or of their complements (even groups):
+    //     evenLineCode bits: P128  P64  P32  P16  P8  P4  P2  P1
+    //     oddLineCode  bits: P128' P64' P32' P16' P8' P4' P2' P1'
+    //
+    // The data is processed by 32-bit words (little endian, byte #i of the
+    // block is byte #(i % 4) of word #(i / 4)):
+    //  - the upper 6 bits of the indexes are the word index, they are xored
+    //    when the word has an odd parity;
+    //  - the lower 2 bits are the byte position in the word, their xor only
+    //    depends on the parity of each byte lane over the whole block, which
+    //    is the parity of the corresponding byte of the xor of all words.
+    for (i=0; i < 64; i++)
     {
-        columnSum ^= data[i];
+        memcpy(&word, data, 4);
+        data += 4;
+        columnWord ^= word;
 
-        // If the xor sum of the byte is 0, then this byte has no incidence on
-        // the computed code; so check if the sum is 1.
-        if ((CountBitsInByte(data[i]) & 1) == 1)
+        word ^= word >> 16;
+        word ^= word >> 8;
+        if (ParityOfByte(word & 0xFF))
         {
-            // Parity groups are formed by forcing a particular index bit to 0
-            // (even) or 1 (odd).
-            // Example on one byte:
-            //
-            // bits (dec)  7   6   5   4   3   2   1   0
-            //      (bin) 111 110 101 100 011 010 001 000
-            //                            '---'---'---'----------.
-            //                                                   |
-            // groups P4' ooooooooooooooo eeeeeeeeeeeeeee P4     |
-            //        P2' ooooooo eeeeeee ooooooo eeeeeee P2     |
-            //        P1' ooo eee ooo eee ooo eee ooo eee P1     |
-            //                                                   |
-            // We can see that:                                  |
-            //  - P4  -> bit 2 of index is 0 --------------------'
-            //  - P4' -> bit 2 of index is 1.
-            //  - P2  -> bit 1 of index if 0.
-            //  - etc...
-            // We deduce that a bit position has an impact on all even Px if
-            // the log2(x)nth bit of its index is 0
-            //     ex: log2(4) = 2, bit2 of the index must be 0 (-> 0 1 2 3)
-            // and on all odd Px' if the log2(x)nth bit of its index is 1
-            //     ex: log2(2) = 1, bit1 of the index must be 1 (-> 0 1 4 5)
-            //
-            // As such, we calculate all the possible Px and Px' values at the
-            // same time in two variables, evenLineCode and oddLineCode, such as
-            //     evenLineCode bits: P128  P64  P32  P16  P8  P4  P2  P1
-            //     oddLineCode  bits: P128' P64' P32' P16' P8' P4' P2' P1'
-            //
-            evenLineCode ^= (255 - i);
-            oddLineCode ^= i;
+            oddLineCode ^= i << 2;
         }
     }
+    if (ParityOfByte((columnWord >> 8) & 0xFF))
+    {
+        oddLineCode ^= 1;
+    }
+    if (ParityOfByte((columnWord >> 16) & 0xFF))
+    {
+        oddLineCode ^= 2;
+    }
+    if (ParityOfByte(columnWord >> 24))
+    {
+        oddLineCode ^= 3;
+    }
 
-    // At this point, we have the line parities, and the column sum. First, We
-    // must caculate the parity group values on the column sum.
+    // Xor of all bytes together to get the column sum; its parity is the
+    // parity of the whole block, i.e. of the number of complements xored
+    columnSum = columnWord ^ (columnWord >> 16);
+    columnSum = (columnSum ^ (columnSum >> 8)) & 0xFF;
+    parity = ParityOfByte(columnSum);
+    evenLineCode = oddLineCode ^ (parity ? 0xFF : 0x00);
+
+    // Parity group values on the column sum, the same way on bit indexes
     for (i=0; i < 8; i++)
     {
-        if (columnSum & 1)
+        if (columnSum & (1 << i))
         {
-            evenColumnCode ^= (7 - i);
             oddColumnCode ^= i;
         }
-        columnSum >>= 1;
     }
+    evenColumnCode = oddColumnCode ^ (parity ? 7 : 0);
 
     // Now, we must interleave the parity values, to obtain the following layout:
     // Code[0] = Line1
@@ -141,59 +202,10 @@ static void Compute256(const uint8_t *data, uint8_t *code)
     // Code[2] = Column
     // Line = Px' Px P(x-1)- P(x-1) ...
     // Column = P4' P4 P2' P2 P1' P1 PadBit PadBit
-    code[0] = 0;
-    code[1] = 0;
-    code[2] = 0;
-
-    for (i=0; i < 4; i++)
-    {
-        code[0] <<= 2;
-        code[1] <<= 2;
-        code[2] <<= 2;
-
-        // Line 1
-        if ((oddLineCode & 0x80) != 0)
-        {
-            code[0] |= 2;
-        }
-
-        if ((evenLineCode & 0x80) != 0)
-        {
-            code[0] |= 1;
-        }
-
-        // Line 2
-        if ((oddLineCode & 0x08) != 0)
-        {
-            code[1] |= 2;
-        }
-
-        if ((evenLineCode & 0x08) != 0)
-        {
-            code[1] |= 1;
-        }
-
-        // Column
-        if ((oddColumnCode & 0x04) != 0)
-        {
-            code[2] |= 2;
-        }
-
-        if ((evenColumnCode & 0x04) != 0)
-        {
-            code[2] |= 1;
-        }
-
-        oddLineCode <<= 1;
-        evenLineCode <<= 1;
-        oddColumnCode <<= 1;
-        evenColumnCode <<= 1;
-    }
-
     // Invert codes (linux compatibility)
-    code[0] = (~(uint32_t)code[0]);
-    code[1] = (~(uint32_t)code[1]);
-    code[2] = (~(uint32_t)code[2]);
+    code[0] = ~Interleave(oddLineCode >> 4, evenLineCode >> 4);
+    code[1] = ~Interleave(oddLineCode, evenLineCode);
+    code[2] = ~Interleave(oddColumnCode << 1, evenColumnCode << 1);
 
     TRACE_DEBUG("Computed code = %02X %02X %02X\n\r",
               code[0], code[1], code[2]);
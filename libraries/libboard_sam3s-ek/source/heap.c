@@ -0,0 +1,331 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Implementation of the multi-region heap.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "board.h"
+
+#include <stdlib.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Alignment of the PSRAM blocks, as malloc() */
+#define HEAP_ALIGNMENT      8
+/** Smallest block, header included */
+#define HEAP_MIN_BLOCK      16
+/** Marks the header of an allocated block */
+#define HEAP_MAGIC          ((struct _HeapBlock*)0x48454150)
+
+/** Header of a PSRAM block, followed by the buffer. */
+typedef struct _HeapBlock
+{
+    /** Size of the block, header included, multiple of HEAP_ALIGNMENT */
+    uint32_t dwSize ;
+    /** Next free block in address order, HEAP_MAGIC once allocated */
+    struct _HeapBlock* pNext ;
+} HeapBlock ;
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Bounds of the PSRAM arena, 0 until HEAP_PsramInitialize() */
+static uint8_t* _pucArenaStart = 0 ;
+static uint8_t* _pucArenaEnd = 0 ;
+/** Free blocks of the arena, in address order */
+static HeapBlock* _pFreeList = 0 ;
+/** Statistics of the arena */
+static HeapStats _stats ;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Takes a block from the PSRAM arena, first fit.
+ */
+static void* _HEAP_ArenaAlloc( uint32_t dwSize )
+{
+    HeapBlock** ppLink ;
+    HeapBlock* pBlock ;
+    HeapBlock* pRest ;
+    uint32_t dwNeed ;
+    uint32_t primask ;
+
+    if ( (_pucArenaStart == 0) || (dwSize > _stats.dwSize) )
+    {
+        return NULL ;
+    }
+
+    dwNeed = (dwSize + sizeof( HeapBlock ) + HEAP_ALIGNMENT - 1) & ~(uint32_t)(HEAP_ALIGNMENT - 1) ;
+
+    primask = __get_PRIMASK() ;
+    __disable_irq() ;
+    for ( ppLink = &_pFreeList ; (*ppLink != 0) && ((*ppLink)->dwSize < dwNeed) ; ppLink = &(*ppLink)->pNext ) ;
+
+    pBlock = *ppLink ;
+    if ( pBlock == 0 )
+    {
+        __set_PRIMASK( primask ) ;
+        return NULL ;
+    }
+
+    /* Split the block unless the rest is too small to be used */
+    if ( pBlock->dwSize - dwNeed >= HEAP_MIN_BLOCK )
+    {
+        pRest = (HeapBlock*)((uint8_t*)pBlock + dwNeed) ;
+        pRest->dwSize = pBlock->dwSize - dwNeed ;
+        pRest->pNext = pBlock->pNext ;
+        pBlock->dwSize = dwNeed ;
+        *ppLink = pRest ;
+    }
+    else
+    {
+        *ppLink = pBlock->pNext ;
+    }
+    pBlock->pNext = HEAP_MAGIC ;
+
+    _stats.dwUsed += pBlock->dwSize ;
+    if ( _stats.dwUsed > _stats.dwMaxUsed )
+    {
+        _stats.dwMaxUsed = _stats.dwUsed ;
+    }
+    __set_PRIMASK( primask ) ;
+
+    return pBlock + 1 ;
+}
+
+/**
+ * \brief Gives a block back to the PSRAM arena, merging it with its free
+ * neighbours.
+ */
+static void _HEAP_ArenaFree( void* pBuffer )
+{
+    HeapBlock* pBlock = (HeapBlock*)pBuffer - 1 ;
+    HeapBlock* pPrev ;
+    HeapBlock* pNext ;
+    uint32_t primask ;
+
+    if ( pBlock->pNext != HEAP_MAGIC )
+    {
+        TRACE_ERROR( "HEAP_Free: bad block 0x%08X\n\r", (unsigned int)pBuffer ) ;
+        return ;
+    }
+
+    primask = __get_PRIMASK() ;
+    __disable_irq() ;
+    _stats.dwUsed -= pBlock->dwSize ;
+
+    for ( pPrev = 0, pNext = _pFreeList ; (pNext != 0) && (pNext < pBlock) ; pPrev = pNext, pNext = pNext->pNext ) ;
+
+    /* Merge with the next free block */
+    if ( (uint8_t*)pBlock + pBlock->dwSize == (uint8_t*)pNext )
+    {
+        pBlock->dwSize += pNext->dwSize ;
+        pNext = pNext->pNext ;
+    }
+    pBlock->pNext = pNext ;
+
+    /* Merge with the previous free block */
+    if ( pPrev == 0 )
+    {
+        _pFreeList = pBlock ;
+    }
+    else if ( (uint8_t*)pPrev + pPrev->dwSize == (uint8_t*)pBlock )
+    {
+        pPrev->dwSize += pBlock->dwSize ;
+        pPrev->pNext = pBlock->pNext ;
+    }
+    else
+    {
+        pPrev->pNext = pBlock ;
+    }
+    __set_PRIMASK( primask ) ;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Creates the PSRAM arena with BOARD_PsramAlloc(). To be called once,
+ * after BOARD_ConfigurePSRAM().
+ *
+ * \param dwSize  Size of the arena in bytes, 0 for all the PSRAM left.
+ *
+ * \return 0 if successful, 1 if the arena exists, 2 if the PSRAM is too small.
+ */
+extern uint32_t HEAP_PsramInitialize( uint32_t dwSize )
+{
+    uint8_t* pucStart ;
+
+    if ( _pucArenaStart != 0 )
+    {
+        return 1 ;
+    }
+
+    if ( dwSize == 0 )
+    {
+        dwSize = BOARD_PsramGetFreeSize() ;
+    }
+    dwSize &= ~(uint32_t)(HEAP_ALIGNMENT - 1) ;
+    if ( dwSize < HEAP_MIN_BLOCK )
+    {
+        return 2 ;
+    }
+
+    pucStart = (uint8_t*)BOARD_PsramAlloc( dwSize ) ;
+    if ( pucStart == NULL )
+    {
+        TRACE_ERROR( "HEAP_PsramInitialize: %u bytes not available\n\r", (unsigned int)dwSize ) ;
+        return 2 ;
+    }
+
+    _pFreeList = (HeapBlock*)pucStart ;
+    _pFreeList->dwSize = dwSize ;
+    _pFreeList->pNext = 0 ;
+    _stats.dwSize = dwSize ;
+    _stats.dwUsed = 0 ;
+    _stats.dwMaxUsed = 0 ;
+    _stats.dwFailures = 0 ;
+    _pucArenaEnd = pucStart + dwSize ;
+    _pucArenaStart = pucStart ;
+
+    return 0 ;
+}
+
+/**
+ * \brief Allocates a buffer in the regions given by the flags: the SRAM
+ * first, unless HEAP_PSRAM_FIRST is set.
+ *
+ * \param dwSize  Size of the buffer in bytes.
+ * \param dwFlags  HEAP_SRAM, HEAP_PSRAM or HEAP_ANY, with HEAP_PSRAM_FIRST.
+ *
+ * \return Address of the buffer, aligned on 8 bytes, or NULL.
+ */
+extern void* HEAP_Alloc( uint32_t dwSize, uint32_t dwFlags )
+{
+    void* pBuffer = NULL ;
+
+    if ( (dwFlags & (HEAP_PSRAM_FIRST | HEAP_PSRAM)) == (HEAP_PSRAM_FIRST | HEAP_PSRAM) )
+    {
+        pBuffer = _HEAP_ArenaAlloc( dwSize ) ;
+    }
+    if ( (pBuffer == NULL) && (dwFlags & HEAP_SRAM) )
+    {
+        pBuffer = malloc( dwSize ) ;
+    }
+    if ( (pBuffer == NULL) && ((dwFlags & (HEAP_PSRAM_FIRST | HEAP_PSRAM)) == HEAP_PSRAM) )
+    {
+        pBuffer = _HEAP_ArenaAlloc( dwSize ) ;
+    }
+
+    if ( pBuffer == NULL )
+    {
+        _stats.dwFailures++ ;
+    }
+
+    return pBuffer ;
+}
+
+/**
+ * \brief Frees a buffer allocated by HEAP_Alloc(), in any region.
+ *
+ * \param pBuffer  Buffer to free, or NULL.
+ */
+extern void HEAP_Free( void* pBuffer )
+{
+    switch ( HEAP_GetRegion( pBuffer ) )
+    {
+        case HEAP_REGION_PSRAM :
+            _HEAP_ArenaFree( pBuffer ) ;
+        break ;
+
+        case HEAP_REGION_SRAM :
+            free( pBuffer ) ;
+        break ;
+
+        default :
+        break ;
+    }
+}
+
+/**
+ * \brief Returns the region of a buffer, HEAP_REGION_xxx.
+ */
+extern uint32_t HEAP_GetRegion( const void* pBuffer )
+{
+    if ( pBuffer == NULL )
+    {
+        return HEAP_REGION_NONE ;
+    }
+
+    if ( ((const uint8_t*)pBuffer >= _pucArenaStart) && ((const uint8_t*)pBuffer < _pucArenaEnd) )
+    {
+        return HEAP_REGION_PSRAM ;
+    }
+
+    return HEAP_REGION_SRAM ;
+}
+
+/**
+ * \brief Gets the statistics of the PSRAM arena.
+ *
+ * \param pStats  Filled with the statistics; dwFailures counts the failed
+ * HEAP_Alloc() calls of every region.
+ */
+extern void HEAP_GetPsramStats( HeapStats* pStats )
+{
+    HeapBlock* pBlock ;
+    uint32_t primask ;
+
+    primask = __get_PRIMASK() ;
+    __disable_irq() ;
+    *pStats = _stats ;
+    pStats->dwLargestFree = 0 ;
+    for ( pBlock = _pFreeList ; pBlock != 0 ; pBlock = pBlock->pNext )
+    {
+        if ( pBlock->dwSize - sizeof( HeapBlock ) > pStats->dwLargestFree )
+        {
+            pStats->dwLargestFree = pBlock->dwSize - sizeof( HeapBlock ) ;
+        }
+    }
+    __set_PRIMASK( primask ) ;
+}
@@ -48,9 +48,11 @@
  *        Local variables
  *----------------------------------------------------------------------------*/
 
-/* Pixel cache used to speed up communication */
-#define LCD_DATA_CACHE_SIZE BOARD_LCD_WIDTH
-static LcdColor_t gLcdPixelCache[LCD_DATA_CACHE_SIZE];
+/* Current drawing color */
+static LcdColor_t gLcdColor ;
+
+/* Entry mode (R03h) set by LCD_SetDisplayPortrait()/LCD_SetDisplayLandscape() */
+static uint16_t gLcdEntryMode ;
 
 /*----------------------------------------------------------------------------
  *        Export functions
@@ -65,10 +67,12 @@ static LcdColor_t gLcdPixelCache[LCD_DATA_CACHE_SIZE];
  */
 static void LCD_WriteReg( uint8_t reg, uint16_t data )
 {
+    BUS_Acquire( BUS_SMC ) ;
     LCD_IR() = 0;
     LCD_IR() = reg;
     LCD_D()  = (data >> 8) & 0xFF;
     LCD_D()  = data & 0xFF;
+    BUS_Release( BUS_SMC ) ;
 }
 
 /**
@@ -82,11 +86,13 @@ static uint16_t LCD_ReadReg( uint8_t reg )
 {
     uint16_t value;
 
+    BUS_Acquire( BUS_SMC ) ;
     LCD_IR() = 0;
     LCD_IR() = reg;
 
     value = LCD_D();
     value = (value << 8) | LCD_D();
+    BUS_Release( BUS_SMC ) ;
 
     return value;
 }
@@ -94,6 +100,10 @@ static uint16_t LCD_ReadReg( uint8_t reg )
 
 /**
  * \brief Prepare to write GRAM data.
+ *
+ * When the SMC is arbitrated (see bus.h), the caller holds it with
+ * BUS_Acquire( BUS_SMC ) from this call to the last LCD_WriteRAM*() call;
+ * the LCD_Draw*() functions do it themselves.
  */
 extern void LCD_WriteRAM_Prepare( void )
 {
@@ -116,16 +126,77 @@ extern  void LCD_WriteRAM( LcdColor_t dwColor )
 /**
  * \brief Write mutiple data in buffer to LCD controller.
  *
+ * The bytes of the 24-bits colors are stored directly (little endian), four
+ * pixels per loop.
  * \param pBuf  data buffer.
  * \param size  size in pixels.
  */
 static void LCD_WriteRAMBuffer(const LcdColor_t *pBuf, uint32_t size)
 {
-    uint32_t addr ;
+    const uint8_t *pucPixel = (const uint8_t *)pBuf ;
+
+    for ( ; size >= 4 ; size -= 4, pucPixel += 16 )
+    {
+        LCD_D() = pucPixel[2] ;  LCD_D() = pucPixel[1] ;  LCD_D() = pucPixel[0] ;
+        LCD_D() = pucPixel[6] ;  LCD_D() = pucPixel[5] ;  LCD_D() = pucPixel[4] ;
+        LCD_D() = pucPixel[10] ; LCD_D() = pucPixel[9] ;  LCD_D() = pucPixel[8] ;
+        LCD_D() = pucPixel[14] ; LCD_D() = pucPixel[13] ; LCD_D() = pucPixel[12] ;
+    }
+    for ( ; size ; size--, pucPixel += 4 )
+    {
+        LCD_D() = pucPixel[2] ;  LCD_D() = pucPixel[1] ;  LCD_D() = pucPixel[0] ;
+    }
+}
 
-    for ( addr = 0 ; addr < size ; addr++ )
+/**
+ * \brief Write several pixels of the same color to LCD GRAM, the color bytes
+ * being computed once (run-length fill).
+ *
+ * \param dwColor  24-bits RGB color.
+ * \param dwCount  number of pixels.
+ */
+extern void LCD_WriteRAMFill( LcdColor_t dwColor, uint32_t dwCount )
+{
+    uint8_t r = (dwColor >> 16) & 0xFF ;
+    uint8_t g = (dwColor >> 8) & 0xFF ;
+    uint8_t b = dwColor & 0xFF ;
+
+    for ( ; dwCount >= 8 ; dwCount -= 8 )
+    {
+        LCD_D() = r ; LCD_D() = g ; LCD_D() = b ;
+        LCD_D() = r ; LCD_D() = g ; LCD_D() = b ;
+        LCD_D() = r ; LCD_D() = g ; LCD_D() = b ;
+        LCD_D() = r ; LCD_D() = g ; LCD_D() = b ;
+        LCD_D() = r ; LCD_D() = g ; LCD_D() = b ;
+        LCD_D() = r ; LCD_D() = g ; LCD_D() = b ;
+        LCD_D() = r ; LCD_D() = g ; LCD_D() = b ;
+        LCD_D() = r ; LCD_D() = g ; LCD_D() = b ;
+    }
+    for ( ; dwCount ; dwCount-- )
     {
-        LCD_WriteRAM(pBuf[addr]);
+        LCD_D() = r ; LCD_D() = g ; LCD_D() = b ;
+    }
+}
+
+/**
+ * \brief Write pixels pre-packed as 18-bits triplets (R, G, B bytes, 6 bits
+ * MSB aligned) to LCD GRAM.
+ *
+ * \param pucTriplets  pixels, 3 bytes each.
+ * \param dwCount  number of pixels.
+ */
+extern void LCD_WriteRAMPacked( const uint8_t *pucTriplets, uint32_t dwCount )
+{
+    for ( ; dwCount >= 4 ; dwCount -= 4 )
+    {
+        LCD_D() = *pucTriplets++ ; LCD_D() = *pucTriplets++ ; LCD_D() = *pucTriplets++ ;
+        LCD_D() = *pucTriplets++ ; LCD_D() = *pucTriplets++ ; LCD_D() = *pucTriplets++ ;
+        LCD_D() = *pucTriplets++ ; LCD_D() = *pucTriplets++ ; LCD_D() = *pucTriplets++ ;
+        LCD_D() = *pucTriplets++ ; LCD_D() = *pucTriplets++ ; LCD_D() = *pucTriplets++ ;
+    }
+    for ( ; dwCount ; dwCount-- )
+    {
+        LCD_D() = *pucTriplets++ ; LCD_D() = *pucTriplets++ ; LCD_D() = *pucTriplets++ ;
     }
 }
 
@@ -212,9 +283,11 @@ static void CheckBoxCoordinates( uint32_t *pX1, uint32_t *pY1, uint32_t *pX2, ui
 }
 
 /**
- * \brief Initialize the LCD controller.
+ * \brief Starts the LCD controller initialization, up to the power ramp.
+ * \return Delay in ms before the next step, or BOOTSEQ_FAILED if the chip ID
+ * is wrong.
  */
-extern uint32_t LCD_Initialize( void )
+static uint32_t _LCD_InitializeStart( void )
 {
     uint16_t chipid ;
 
@@ -223,7 +296,7 @@ extern uint32_t LCD_Initialize( void )
     if ( chipid != ILI9325_DEVICE_CODE )
     {
         printf( "Read ILI9325 chip ID (0x%04x) error, skip initialization.\r\n", chipid ) ;
-        return 1 ;
+        return BOOTSEQ_FAILED ;
     }
 
     /* Turn off LCD */
@@ -248,17 +321,15 @@ extern uint32_t LCD_Initialize( void )
     LCD_WriteReg(ILI9325_R11H, 0x0000); /* DC1[2:0], DC0[2:0], VC[2:0] */
     LCD_WriteReg(ILI9325_R12H, 0x0000); /* VREG1OUT voltage */
     LCD_WriteReg(ILI9325_R13H, 0x0000); /* VDV[4:0] for VCOM amplitude */
-    Wait( 200 ) ;                       /* Dis-charge capacitor power voltage */
-    LCD_WriteReg(ILI9325_R10H, 0x1290); /* SAP, BT[3:0], AP, DSTB, SLP, STB */
-    LCD_WriteReg(ILI9325_R11H, 0x0227); /* DC1[2:0], DC0[2:0], VC[2:0] */
-    Wait( 50 ) ;
-    LCD_WriteReg(ILI9325_R12H, 0x001B); /* Internal reference voltage= Vci; */
-    Wait( 50 ) ;
-    LCD_WriteReg(ILI9325_R13H, 0x1100); /* Set VDV[4:0] for VCOM amplitude */
-    LCD_WriteReg(ILI9325_R29H, 0x0019); /* Set VCM[5:0] for VCOMH */
-    LCD_WriteReg(ILI9325_R2BH, 0x000D); /* Set Frame Rate */
-    Wait( 50 ) ;
 
+    return 200 ;                        /* Dis-charge capacitor power voltage */
+}
+
+/**
+ * \brief Ends the LCD controller initialization, once the power is up.
+ */
+static void _LCD_InitializeEnd( void )
+{
     /* Adjust the Gamma Curve */
     LCD_WriteReg(ILI9325_R30H, 0x0000);
     LCD_WriteReg(ILI9325_R31H, 0x0204);
@@ -291,8 +362,71 @@ extern uint32_t LCD_Initialize( void )
 
     LCD_SetWindow( 0, 0, BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT ) ;
     LCD_SetCursor( 0, 0 ) ;
+}
 
-    return 0 ;
+/**
+ * \brief Runs the next step of the LCD controller initialization.
+ * The initialization is cut at the power ramp delays, so that other
+ * initializations can run meanwhile (see bootseq.h).
+ * \param pdwState  Initialization progress, 0 at start.
+ * \return Delay in ms before the next step, BOOTSEQ_DONE when the controller
+ * is initialized, or BOOTSEQ_FAILED if the chip ID is wrong.
+ */
+extern uint32_t LCD_InitializeStep( uint32_t* pdwState )
+{
+    switch ( (*pdwState)++ )
+    {
+        case 0 :
+        return _LCD_InitializeStart() ;
+
+        case 1 :
+            LCD_WriteReg(ILI9325_R10H, 0x1290); /* SAP, BT[3:0], AP, DSTB, SLP, STB */
+            LCD_WriteReg(ILI9325_R11H, 0x0227); /* DC1[2:0], DC0[2:0], VC[2:0] */
+        return 50 ;
+
+        case 2 :
+            LCD_WriteReg(ILI9325_R12H, 0x001B); /* Internal reference voltage= Vci; */
+        return 50 ;
+
+        case 3 :
+            LCD_WriteReg(ILI9325_R13H, 0x1100); /* Set VDV[4:0] for VCOM amplitude */
+            LCD_WriteReg(ILI9325_R29H, 0x0019); /* Set VCM[5:0] for VCOMH */
+            LCD_WriteReg(ILI9325_R2BH, 0x000D); /* Set Frame Rate */
+        return 50 ;
+
+        case 4 :
+            _LCD_InitializeEnd() ;
+        return BOOTSEQ_DONE ;
+
+        default :
+        return BOOTSEQ_FAILED ;
+    }
+}
+
+/**
+ * \brief Initialize the LCD controller.
+ * Runs all the steps of LCD_InitializeStep(), waiting for the power ramp.
+ * \return 0 if successful, 1 if the chip ID is wrong.
+ */
+extern uint32_t LCD_Initialize( void )
+{
+    uint32_t dwState = 0 ;
+    uint32_t dwDelay ;
+
+    for ( ;; )
+    {
+        dwDelay = LCD_InitializeStep( &dwState ) ;
+
+        if ( dwDelay == BOOTSEQ_DONE )
+        {
+            return 0 ;
+        }
+        if ( dwDelay == BOOTSEQ_FAILED )
+        {
+            return 1 ;
+        }
+        Wait( dwDelay ) ;
+    }
 }
 
 /**
@@ -345,13 +479,7 @@ extern void LCD_PowerDown( void )
  */
 extern uint32_t LCD_SetColor( uint32_t dwRgb24Bits )
 {
-    uint32_t i ;
-
-    /* Fill the cache with selected color */
-    for ( i = 0 ; i < LCD_DATA_CACHE_SIZE ; ++i )
-    {
-        gLcdPixelCache[i] = dwRgb24Bits ;
-    }
+    gLcdColor = dwRgb24Bits ;
 
     return 0;
 }
@@ -404,6 +532,7 @@ extern void LCD_SetDisplayLandscape( uint32_t dwRGB )
         dwValue |= ILI9325_R03H_BGR ;
     }
     LCD_WriteReg( ILI9325_R03H, dwValue ) ;
+    gLcdEntryMode = dwValue ;
 
     //    LCD_WriteReg( ILI9325_R60H, (0x1d<<8)|0x00 ) ; /*Gate Scan Control */
 
@@ -426,6 +555,7 @@ extern void LCD_SetDisplayPortrait( uint32_t dwRGB )
         dwValue |= ILI9325_R03H_BGR ;
     }
     LCD_WriteReg( ILI9325_R03H, dwValue ) ;
+    gLcdEntryMode = dwValue ;
     /* Gate Scan Control (R60h, R61h, R6Ah) */
     /* SCN[5:0] = 00 */
     /* NL[5:0]: Sets the number of lines to drive the LCD at an interval of 8 lines. */
@@ -478,12 +608,16 @@ extern uint32_t LCD_DrawPixel( uint32_t x, uint32_t y )
         return 1;
     }
 
+    BUS_Acquire( BUS_SMC ) ;
+
     /* Set cursor */
     LCD_SetCursor( x, y );
 
     /* Prepare to write in GRAM */
     LCD_WriteRAM_Prepare();
-    LCD_WriteRAM( *gLcdPixelCache );
+    LCD_WriteRAM( gLcdColor );
+
+    BUS_Release( BUS_SMC ) ;
 
     return 0;
 }
@@ -495,6 +629,8 @@ extern void LCD_TestPattern( uint32_t dwRGB )
     uint32_t dwLine ;
     uint32_t dw ;
 
+    BUS_Acquire( BUS_SMC ) ;
+
     LCD_SetWindow( 10, 10, 100, 20 ) ;
     LCD_SetCursor( 10, 10 ) ;
     LCD_WriteRAM_Prepare() ;
@@ -557,6 +693,8 @@ extern void LCD_TestPattern( uint32_t dwRGB )
     }
 
     LCD_SetWindow( 0, 0, BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT ) ;
+
+    BUS_Release( BUS_SMC ) ;
 }
 
 
@@ -564,8 +702,6 @@ extern void LCD_TestPattern( uint32_t dwRGB )
  * \brief Write several pixels with the same color to LCD GRAM.
  *
  * LcdColor_t color is set by the LCD_SetColor() function.
- * This function is optimized using an sram buffer to transfer block instead of
- * individual pixels in order to limit the number of SPI interrupts.
  * \param dwX1      X-coordinate of upper-left corner on LCD.
  * \param dwY1      Y-coordinate of upper-left corner on LCD.
  * \param dwX2      X-coordinate of lower-right corner on LCD.
@@ -573,11 +709,14 @@ extern void LCD_TestPattern( uint32_t dwRGB )
  */
 extern uint32_t LCD_DrawFilledRectangle( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2 )
 {
-    uint32_t size, blocks;
+    uint32_t size;
 
     /* Swap coordinates if necessary */
     CheckBoxCoordinates(&dwX1, &dwY1, &dwX2, &dwY2);
 
+    /* The window is set up and filled in one go */
+    BUS_Acquire( BUS_SMC ) ;
+
     /* Determine the refresh window area */
     /* Horizontal and Vertical RAM Address Position (R50h, R51h, R52h, R53h) */
     LCD_WriteReg(ILI9325_R50H, (uint16_t)dwX1);
@@ -592,14 +731,7 @@ extern uint32_t LCD_DrawFilledRectangle( uint32_t dwX1, uint32_t dwY1, uint32_t
     LCD_WriteRAM_Prepare();
 
     size = (dwX2 - dwX1 + 1) * (dwY2 - dwY1 + 1);
-    /* Send pixels blocks => one SPI IT / block */
-    blocks = size / LCD_DATA_CACHE_SIZE;
-    while (blocks--)
-    {
-        LCD_WriteRAMBuffer(gLcdPixelCache, LCD_DATA_CACHE_SIZE);
-    }
-    /* Send remaining pixels */
-    LCD_WriteRAMBuffer(gLcdPixelCache, size % LCD_DATA_CACHE_SIZE);
+    LCD_WriteRAMFill(gLcdColor, size);
 
     /* Reset the refresh window area */
     /* Horizontal and Vertical RAM Address Position (R50h, R51h, R52h, R53h) */
@@ -608,6 +740,8 @@ extern uint32_t LCD_DrawFilledRectangle( uint32_t dwX1, uint32_t dwY1, uint32_t
     LCD_WriteReg(ILI9325_R52H, (uint16_t)0) ;
     LCD_WriteReg(ILI9325_R53H, (uint16_t)BOARD_LCD_HEIGHT - 1  ) ;
 
+    BUS_Release( BUS_SMC ) ;
+
     return 0 ;
 }
 
@@ -622,12 +756,16 @@ extern uint32_t LCD_DrawFilledRectangle( uint32_t dwX1, uint32_t dwY1, uint32_t
  */
 extern uint32_t LCD_DrawPicture( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2, const LcdColor_t *pBuffer )
 {
-    uint32_t size, blocks;
-    LcdColor_t currentColor;
+    uint32_t size;
+
+    PROF_Enter( PROF_ID_LCD_BLIT ) ;
 
     /* Swap coordinates if necessary */
     CheckBoxCoordinates(&dwX1, &dwY1, &dwX2, &dwY2);
 
+    /* The window is set up and filled in one go */
+    BUS_Acquire( BUS_SMC ) ;
+
     /* Determine the refresh window area */
     /* Horizontal and Vertical RAM Address Position (R50h, R51h, R52h, R53h) */
     LCD_WriteReg(ILI9325_R50H, (uint16_t)dwX1 ) ;
@@ -643,32 +781,78 @@ extern uint32_t LCD_DrawPicture( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, ui
 
     size = (dwX2 - dwX1 + 1) * (dwY2 - dwY1 + 1);
 
-    /* Check if the buffer is within the SRAM */
-    if ((IRAM_ADDR <= (uint32_t)pBuffer) && ((uint32_t)pBuffer < (IRAM_ADDR+IRAM_SIZE)))
+    /* The CPU reads flash as fast as SRAM: no copy through a cache */
+    LCD_WriteRAMBuffer(pBuffer, size);
+
+    /* Reset the refresh window area */
+    /* Horizontal and Vertical RAM Address Position (R50h, R51h, R52h, R53h) */
+    LCD_WriteReg(ILI9325_R50H, (uint16_t)0 ) ;
+    LCD_WriteReg(ILI9325_R51H, (uint16_t)BOARD_LCD_WIDTH - 1 ) ;
+    LCD_WriteReg(ILI9325_R52H, (uint16_t)0 ) ;
+    LCD_WriteReg(ILI9325_R53H, (uint16_t)BOARD_LCD_HEIGHT - 1 ) ;
+
+    BUS_Release( BUS_SMC ) ;
+    PROF_Exit( PROF_ID_LCD_BLIT ) ;
+
+    return 0 ;
+}
+
+/**
+ * \brief Write pixels in RGB565 format to LCD GRAM: the controller is switched
+ * to the 8-bit x 2 transfers mode (TRI = 0) for the transfer, so each pixel
+ * takes two bus cycles instead of three.
+ *
+ * \param dwX1      X-coordinate of upper-left corner on LCD.
+ * \param dwY1      Y-coordinate of upper-left corner on LCD.
+ * \param dwX2      X-coordinate of lower-right corner on LCD.
+ * \param dwY2      Y-coordinate of lower-right corner on LCD.
+ * \param pwBuffer  RGB565 pixels.
+ */
+extern uint32_t LCD_DrawPicture565( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2, const uint16_t *pwBuffer )
+{
+    uint32_t size;
+    uint16_t w;
+
+    PROF_Enter( PROF_ID_LCD_BLIT ) ;
+
+    /* Swap coordinates if necessary */
+    CheckBoxCoordinates(&dwX1, &dwY1, &dwX2, &dwY2);
+
+    /* The window is set up and filled in one go */
+    BUS_Acquire( BUS_SMC ) ;
+
+    /* Determine the refresh window area */
+    /* Horizontal and Vertical RAM Address Position (R50h, R51h, R52h, R53h) */
+    LCD_WriteReg(ILI9325_R50H, (uint16_t)dwX1 ) ;
+    LCD_WriteReg(ILI9325_R51H, (uint16_t)dwX2 ) ;
+    LCD_WriteReg(ILI9325_R52H, (uint16_t)dwY1 ) ;
+    LCD_WriteReg(ILI9325_R53H, (uint16_t)dwY2 ) ;
+
+    /* 16-bits pixels: 8-bit x 2 transfers */
+    LCD_WriteReg( ILI9325_R03H, gLcdEntryMode & ~(ILI9325_R03H_TRI | ILI9325_R03H_DFM) ) ;
+
+    /* Set cursor */
+    LCD_SetCursor( dwX1, dwY1 );
+
+    /* Prepare to write in GRAM */
+    LCD_WriteRAM_Prepare();
+
+    size = (dwX2 - dwX1 + 1) * (dwY2 - dwY1 + 1);
+    for ( ; size >= 4 ; size -= 4 )
     {
-        LCD_WriteRAMBuffer(pBuffer, size);
+        w = *pwBuffer++ ; LCD_D() = w >> 8 ; LCD_D() = w ;
+        w = *pwBuffer++ ; LCD_D() = w >> 8 ; LCD_D() = w ;
+        w = *pwBuffer++ ; LCD_D() = w >> 8 ; LCD_D() = w ;
+        w = *pwBuffer++ ; LCD_D() = w >> 8 ; LCD_D() = w ;
     }
-    /* If the buffer is not in SRAM, transfer it in SRAM first before transfer */
-    else
+    for ( ; size ; size-- )
     {
-        /* Use color buffer as a cache */
-        currentColor = gLcdPixelCache[0];
-        /* Send pixels blocks => one SPI IT / block */
-        blocks = size / LCD_DATA_CACHE_SIZE;
-        while (blocks--)
-        {
-            memcpy(gLcdPixelCache, pBuffer, LCD_DATA_CACHE_SIZE * sizeof(LcdColor_t));
-            LCD_WriteRAMBuffer(gLcdPixelCache, LCD_DATA_CACHE_SIZE);
-            pBuffer += LCD_DATA_CACHE_SIZE;
-        }
-        /* Send remaining pixels */
-        memcpy(gLcdPixelCache, pBuffer, (size % LCD_DATA_CACHE_SIZE) * sizeof(LcdColor_t));
-        LCD_WriteRAMBuffer(gLcdPixelCache, size % LCD_DATA_CACHE_SIZE);
-
-        /* Restore the color cache */
-        LCD_SetColor(currentColor);
+        w = *pwBuffer++ ; LCD_D() = w >> 8 ; LCD_D() = w ;
     }
 
+    /* Back to 18-bits pixels */
+    LCD_WriteReg( ILI9325_R03H, gLcdEntryMode ) ;
+
     /* Reset the refresh window area */
     /* Horizontal and Vertical RAM Address Position (R50h, R51h, R52h, R53h) */
     LCD_WriteReg(ILI9325_R50H, (uint16_t)0 ) ;
@@ -676,6 +860,9 @@ extern uint32_t LCD_DrawPicture( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, ui
     LCD_WriteReg(ILI9325_R52H, (uint16_t)0 ) ;
     LCD_WriteReg(ILI9325_R53H, (uint16_t)BOARD_LCD_HEIGHT - 1 ) ;
 
+    BUS_Release( BUS_SMC ) ;
+    PROF_Exit( PROF_ID_LCD_BLIT ) ;
+
     return 0 ;
 }
 
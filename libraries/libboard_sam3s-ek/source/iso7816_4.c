@@ -45,6 +45,8 @@
 
 #include "board.h"
 
+#include <string.h>
+
 /*------------------------------------------------------------------------------
  *         Definitions
  *------------------------------------------------------------------------------*/
@@ -57,6 +59,18 @@
 #define USART_SEND 0
 #define USART_RCV  1
 
+/** Asynchronous TPDU states */
+#define XFR_IDLE   0 /* No exchange */
+#define XFR_SEND   1 /* PDC sending, wait for ENDTX */
+#define XFR_FLUSH  2 /* Last character sending, wait for TXEMPTY */
+#define XFR_PROC   3 /* Wait for a procedure byte */
+#define XFR_SW2    4 /* Wait for SW2 */
+#define XFR_RECV   5 /* PDC receiving */
+
+/** USART interrupts used by the asynchronous TPDU exchange */
+#define XFR_IT_ALL (US_IDR_ENDTX | US_IDR_TXEMPTY | US_IDR_RXRDY \
+                    | US_IDR_ENDRX | US_IDR_TIMEOUT | US_IDR_ITER)
+
 #if !defined(BOARD_ISO7816_BASE_USART)
   #define BOARD_ISO7816_BASE_USART USART1
   #define BOARD_ISO7816_ID_USART   ID_USART1
@@ -69,6 +83,38 @@
 static uint8_t StateUsartGlobal = USART_RCV;
 /** Pin reset master card */
 static Pin st_pinIso7816RstMC;
+/** Asynchronous TPDU in progress */
+static Iso7816Tpdu * volatile pXfr = 0;
+/** Asynchronous TPDU state */
+static volatile uint8_t bXfrState = XFR_IDLE;
+/** Number of data bytes of the current PDC transfer */
+static uint16_t wXfrChunk;
+/** Fi and Di in use, coded as TA1 */
+static uint8_t bFiDi = ISO7816_TA1_DEFAULT;
+/** Fi values, indexed by the high nibble of TA1 (0: RFU) */
+static const uint16_t awFi[16] = { 372, 372, 558, 744, 1116, 1488, 1860, 0,
+                                   0, 512, 768, 1024, 1536, 2048, 0, 0 };
+/** Di values, indexed by the low nibble of TA1 (0: RFU) */
+static const uint8_t abDi[16] = { 0, 1, 2, 4, 8, 16, 32, 64,
+                                  12, 20, 0, 0, 0, 0, 0, 0 };
+/** T=1 send sequence number of the next I-block */
+static uint8_t bT1Ns;
+/** T=1 sequence number expected in the next I-block of the card */
+static uint8_t bT1Nr;
+/** T=1 information field size of the card */
+static uint8_t bT1Ifsc = ISO7816_T1_IFS_DEFAULT;
+/** T=1 waiting time extension asked by the card, 0 if none */
+static uint8_t bT1Wtx;
+/** T=1 block waiting time in etu */
+static uint32_t dwT1Bwt;
+/** T=1 character waiting time in etu */
+static uint32_t dwT1Cwt;
+/** Last T=1 I-block sent, kept for retransmission */
+static uint8_t abT1Tx[3 + ISO7816_T1_IFS_MAX + 1];
+/** Last T=1 R-block or S-block sent */
+static uint8_t abT1Ctl[5];
+/** Last T=1 block received, LEN may be up to 255 */
+static uint8_t abT1Rx[3 + 255 + 1];
 
 /*----------------------------------------------------------------------------
  *          Internal functions
@@ -158,6 +204,341 @@ static uint32_t ISO7816_SendChar( uint8_t CharToSend )
 }
 
 
+/**
+ * Ends the asynchronous TPDU and invokes its callback.
+ * \param bStatus ISO7816_STATUS_xxx.
+ */
+static void _XfrEnd( uint8_t bStatus )
+{
+    Usart *pUs = BOARD_ISO7816_BASE_USART;
+    Iso7816Tpdu *pTpdu = pXfr;
+
+    pUs->US_IDR = XFR_IT_ALL;
+    pUs->US_PTCR = US_PTCR_RXTDIS | US_PTCR_TXTDIS;
+    pUs->US_RTOR = 0;
+    bXfrState = XFR_IDLE;
+    pXfr = 0;
+
+    if ( bStatus != ISO7816_STATUS_SUCCESS ) {
+        TRACE_DEBUG("XfrEnd %u\n\r", bStatus);
+        pUs->US_CR = US_CR_RSTSTA | US_CR_RSTIT | US_CR_RSTNACK;
+    }
+    if ( pTpdu->fCallback ) {
+        pTpdu->fCallback( bStatus, pTpdu->pArgument );
+    }
+}
+
+/**
+ * Sends a block to the card through the PDC.
+ * \param pData   Bytes to send.
+ * \param wLength Number of bytes.
+ */
+static void _XfrSend( const uint8_t *pData, uint16_t wLength )
+{
+    Usart *pUs = BOARD_ISO7816_BASE_USART;
+
+    if( StateUsartGlobal == USART_RCV ) {
+        pUs->US_CR = US_CR_RSTSTA | US_CR_RSTIT | US_CR_RSTNACK;
+        StateUsartGlobal = USART_SEND;
+    }
+    bXfrState = XFR_SEND;
+    pUs->US_TPR = (uint32_t)pData;
+    pUs->US_TCR = wLength;
+    pUs->US_PTCR = US_PTCR_TXTEN;
+    pUs->US_IER = US_IER_ENDTX | US_IER_ITER;
+}
+
+/**
+ * Receives a block from the card through the PDC.
+ * \param pData   Buffer for the received bytes.
+ * \param wLength Number of bytes.
+ */
+static void _XfrRecv( uint8_t *pData, uint16_t wLength )
+{
+    Usart *pUs = BOARD_ISO7816_BASE_USART;
+
+    bXfrState = XFR_RECV;
+    pUs->US_IDR = US_IDR_RXRDY;
+    pUs->US_RPR = (uint32_t)pData;
+    pUs->US_RCR = wLength;
+    pUs->US_PTCR = US_PTCR_RXTEN;
+    pUs->US_IER = US_IER_ENDRX | US_IER_TIMEOUT;
+}
+
+/**
+ * Handles a procedure byte of the asynchronous TPDU.
+ * \param bProc Received procedure byte.
+ */
+static void _XfrProcedure( uint8_t bProc )
+{
+    Usart *pUs = BOARD_ISO7816_BASE_USART;
+    Iso7816Tpdu *pTpdu = pXfr;
+    uint16_t wLeft = pTpdu->wLength - pTpdu->wTransferred;
+    uint8_t bIns = pTpdu->abHeader[1];
+
+    /* NULL: the card asks for more time */
+    if ( bProc == ISO_NULL_VAL ) {
+        return;
+    }
+    /* SW1 */
+    if ( ((bProc & 0xF0) == 0x60) || ((bProc & 0xF0) == 0x90) ) {
+        pTpdu->abSW[0] = bProc;
+        bXfrState = XFR_SW2;
+        return;
+    }
+    /* INS: all remaining data, INS ^ 0xFF: next byte only */
+    if ( wLeft && ((bProc == bIns) || (bProc == (bIns ^ 0xFF))) ) {
+        wXfrChunk = (bProc == bIns) ? wLeft : 1;
+        if ( pTpdu->bReceive ) {
+            _XfrRecv( &pTpdu->pData[pTpdu->wTransferred], wXfrChunk );
+        }
+        else {
+            pUs->US_IDR = US_IDR_RXRDY | US_IDR_TIMEOUT;
+            _XfrSend( &pTpdu->pData[pTpdu->wTransferred], wXfrChunk );
+        }
+        return;
+    }
+    TRACE_DEBUG("procByte=0x%X\n\r", bProc);
+    _XfrEnd( ISO7816_STATUS_ERROR );
+}
+
+/**
+ * Waits for the next procedure byte, the work waiting time being counted
+ * from now on and restarted by each received character.
+ */
+static void _XfrWaitProcedure( void )
+{
+    Usart *pUs = BOARD_ISO7816_BASE_USART;
+
+    bXfrState = XFR_PROC;
+    pUs->US_RTOR = ISO7816_WWT_ETU;
+    pUs->US_CR = US_CR_STTTO;
+    pUs->US_CR = US_CR_RETTO;
+    pUs->US_IER = US_IER_RXRDY | US_IER_TIMEOUT;
+}
+
+/**
+ * Returns the value of the FIDI register for a TA1 coding.
+ * \param bTA1 Fi in the high nibble, Di in the low nibble.
+ * \return Fi/Di rounded to the nearest integer, 0 if Fi or Di is RFU.
+ */
+static uint32_t _GetFiDiRatio( uint8_t bTA1 )
+{
+    uint32_t dwFi = awFi[bTA1 >> 4];
+    uint32_t dwDi = abDi[bTA1 & 0x0F];
+
+    if ( (dwFi == 0) || (dwDi == 0) ) {
+        return 0;
+    }
+    return (dwFi + dwDi / 2) / dwDi;
+}
+
+/**
+ * Switches the USART between the T=0 and T=1 modes.
+ * \param dwMode US_MR_USART_MODE_IS07816_T_0 or US_MR_USART_MODE_IS07816_T_1.
+ */
+static void _SetMode( uint32_t dwMode )
+{
+    Usart *pUs = BOARD_ISO7816_BASE_USART;
+
+    pUs->US_CR = US_CR_RXDIS | US_CR_TXDIS;
+    pUs->US_MR = (pUs->US_MR & ~US_MR_USART_MODE_Msk) | dwMode;
+    pUs->US_CR = US_CR_RSTSTA | US_CR_RXEN | US_CR_TXEN;
+}
+
+/**
+ * Restores the T=0 mode and the default Fi/Di, which the card uses after a
+ * reset.
+ */
+static void _SetDefaults( void )
+{
+    _SetMode( US_MR_USART_MODE_IS07816_T_0 );
+    BOARD_ISO7816_BASE_USART->US_FIDI = 372;
+    BOARD_ISO7816_BASE_USART->US_TTGR = 5;
+    bFiDi = ISO7816_TA1_DEFAULT;
+}
+
+/**
+ * Waits for the given time, counted by the receiver time-out.
+ * \param dwEtu Time in etu (up to 65535).
+ */
+static void _WaitEtu( uint32_t dwEtu )
+{
+    Usart *pUs = BOARD_ISO7816_BASE_USART;
+
+    pUs->US_RTOR = dwEtu;
+    pUs->US_CR = US_CR_STTTO;
+    pUs->US_CR = US_CR_RETTO;
+    while ( (pUs->US_CSR & US_CSR_TIMEOUT) == 0 ) {}
+    pUs->US_RTOR = 0;
+}
+
+/**
+ * Sends characters through the PDC and waits until the last one is out.
+ * \param pData   Characters to send.
+ * \param wLength Number of characters.
+ */
+static void _Send( const uint8_t *pData, uint16_t wLength )
+{
+    Usart *pUs = BOARD_ISO7816_BASE_USART;
+
+    pUs->US_CR = US_CR_RSTSTA | US_CR_RSTIT | US_CR_RSTNACK;
+    StateUsartGlobal = USART_SEND;
+    pUs->US_TPR = (uint32_t)pData;
+    pUs->US_TCR = wLength;
+    pUs->US_PTCR = US_PTCR_TXTEN;
+    while ( (pUs->US_CSR & US_CSR_ENDTX) == 0 ) {}
+    while ( (pUs->US_CSR & US_CSR_TXEMPTY) == 0 ) {}
+    pUs->US_PTCR = US_PTCR_TXTDIS;
+
+    pUs->US_RHR;
+    pUs->US_CR = US_CR_RSTSTA | US_CR_RSTIT | US_CR_RSTNACK;
+    StateUsartGlobal = USART_RCV;
+}
+
+/**
+ * Receives characters through the PDC, the CPU only watching the time-outs.
+ * The time-out counter is 16-bit wide, longer waits before the first
+ * character are counted in several rounds.
+ * \param pData   Buffer for the received characters.
+ * \param wLength Number of characters.
+ * \param dwWait  Time in etu allowed before the first character.
+ * \param dwCwt   Time in etu allowed between two characters (up to 65535).
+ * \return ISO7816_STATUS_SUCCESS, ISO7816_STATUS_TIMEOUT, or
+ *         ISO7816_STATUS_ERROR on a parity, framing or overrun error.
+ */
+static uint8_t _Receive( uint8_t *pData, uint16_t wLength, uint32_t dwWait, uint32_t dwCwt )
+{
+    Usart *pUs = BOARD_ISO7816_BASE_USART;
+    uint32_t dwRounds = (dwWait - 1) / 0xFFFF;
+    uint8_t bStatus = ISO7816_STATUS_SUCCESS;
+
+    pUs->US_RPR = (uint32_t)pData;
+    pUs->US_RCR = wLength;
+    pUs->US_PTCR = US_PTCR_RXTEN;
+
+    /* Wait for the first character */
+    pUs->US_RTOR = (dwWait > 0xFFFF) ? 0xFFFF : dwWait;
+    pUs->US_CR = US_CR_STTTO;
+    pUs->US_CR = US_CR_RETTO;
+    while ( pUs->US_RCR == wLength ) {
+        if ( pUs->US_CSR & US_CSR_TIMEOUT ) {
+            if ( dwRounds == 0 ) {
+                bStatus = ISO7816_STATUS_TIMEOUT;
+                break;
+            }
+            dwRounds--;
+            pUs->US_CR = US_CR_STTTO;
+            pUs->US_CR = US_CR_RETTO;
+        }
+    }
+
+    /* Then the counter is reloaded by each character */
+    if ( bStatus == ISO7816_STATUS_SUCCESS ) {
+        pUs->US_RTOR = dwCwt;
+        pUs->US_CR = US_CR_STTTO;
+        pUs->US_CR = US_CR_RETTO;
+        while ( pUs->US_RCR ) {
+            if ( pUs->US_CSR & US_CSR_TIMEOUT ) {
+                bStatus = ISO7816_STATUS_TIMEOUT;
+                break;
+            }
+        }
+    }
+    pUs->US_PTCR = US_PTCR_RXTDIS;
+    pUs->US_RTOR = 0;
+
+    if ( (bStatus == ISO7816_STATUS_SUCCESS)
+      && (pUs->US_CSR & (US_CSR_PARE | US_CSR_FRAME | US_CSR_OVRE)) ) {
+        bStatus = ISO7816_STATUS_ERROR;
+    }
+    return bStatus;
+}
+
+/**
+ * Computes the longitudinal redundancy check of a T=1 block.
+ * \param pBlock  Block.
+ * \param wLength Number of bytes.
+ * \return XOR of the bytes, 0 over a block including a valid LRC.
+ */
+static uint8_t _T1Lrc( const uint8_t *pBlock, uint16_t wLength )
+{
+    uint8_t bLrc = 0;
+
+    while ( wLength-- ) {
+        bLrc ^= *pBlock++;
+    }
+    return bLrc;
+}
+
+/**
+ * Builds an R-block or an S-block in abT1Ctl.
+ * \param bPcb    Protocol control byte.
+ * \param bLength 0 or 1.
+ * \param bInf    Information byte, if any.
+ */
+static void _T1BuildCtl( uint8_t bPcb, uint8_t bLength, uint8_t bInf )
+{
+    abT1Ctl[0] = 0;
+    abT1Ctl[1] = bPcb;
+    abT1Ctl[2] = bLength;
+    abT1Ctl[3] = bInf;
+}
+
+/**
+ * Builds in abT1Tx the I-block carrying the next part of a command APDU.
+ * \param pAPDU   Command APDU.
+ * \param wLength APDU length.
+ * \param wOffset Offset of the first byte of the block in the APDU.
+ * \return Number of APDU bytes in the block.
+ */
+static uint16_t _T1BuildI( const uint8_t *pAPDU, uint16_t wLength, uint16_t wOffset )
+{
+    uint16_t wChunk = wLength - wOffset;
+
+    if ( wChunk > bT1Ifsc ) {
+        wChunk = bT1Ifsc;
+    }
+    abT1Tx[0] = 0;
+    abT1Tx[1] = (bT1Ns << 6) | (((wOffset + wChunk) < wLength) ? 0x20 : 0);
+    abT1Tx[2] = wChunk;
+    memcpy( &abT1Tx[3], &pAPDU[wOffset], wChunk );
+
+    return wChunk;
+}
+
+/**
+ * Sends a T=1 block and receives the answer of the card in abT1Rx, both
+ * moved by the PDC.
+ * \param pBlock Block to send, its LRC is computed here.
+ * \return ISO7816_STATUS_SUCCESS, ISO7816_STATUS_TIMEOUT, or
+ *         ISO7816_STATUS_ERROR if the received block is invalid.
+ */
+static uint8_t _T1Exchange( uint8_t *pBlock )
+{
+    uint32_t dwBwt = bT1Wtx ? (dwT1Bwt * bT1Wtx) : dwT1Bwt;
+    uint8_t bStatus;
+
+    bT1Wtx = 0;
+    pBlock[3 + pBlock[2]] = _T1Lrc( pBlock, 3 + pBlock[2] );
+
+    /* Block guard time since the last character of the card */
+    _WaitEtu( 22 );
+    _Send( pBlock, 4 + pBlock[2] );
+
+    /* Prologue, then the information field and the LRC */
+    bStatus = _Receive( abT1Rx, 3, dwBwt, dwT1Cwt );
+    if ( bStatus == ISO7816_STATUS_SUCCESS ) {
+        bStatus = _Receive( &abT1Rx[3], abT1Rx[2] + 1, dwT1Cwt, dwT1Cwt );
+    }
+    if ( (bStatus == ISO7816_STATUS_SUCCESS)
+      && ((abT1Rx[0] != 0) || (abT1Rx[2] > ISO7816_T1_IFS_MAX)
+          || (_T1Lrc( abT1Rx, 4 + abT1Rx[2] ) != 0)) ) {
+        bStatus = ISO7816_STATUS_ERROR;
+    }
+    return bStatus;
+}
+
 /**
  *  Iso 7816 ICC power on
  */
@@ -314,6 +695,406 @@ uint16_t ISO7816_XfrBlockTPDU_T0(const uint8_t *pAPDU,
 
 }
 
+/**
+ * Starts a T=0 TPDU exchange driven by the USART PDC and interrupt, then
+ * returns at once: the callback of the TPDU is invoked from
+ * ISO7816_Handler() once the status words have been received. The USART
+ * interrupt handler of the application must call ISO7816_Handler().
+ *
+ * The header, pData and the TPDU must be kept until the callback.
+ * \param pTpdu TPDU to exchange, abHeader, bReceive, pData, wLength and
+ *              fCallback set.
+ * \return 0 if the exchange has been started, 1 if an exchange is in
+ *         progress.
+ */
+uint8_t ISO7816_XfrTPDU_T0_Start( Iso7816Tpdu *pTpdu )
+{
+    if ( bXfrState != XFR_IDLE ) {
+        return 1;
+    }
+
+    TRACE_DEBUG("XfrT0 %02X %02X %u\n\r", pTpdu->abHeader[1], pTpdu->abHeader[4],
+                                          pTpdu->wLength);
+
+    pTpdu->wTransferred = 0;
+    pTpdu->abSW[0] = pTpdu->abSW[1] = 0;
+    pXfr = pTpdu;
+    wXfrChunk = 0;
+    _XfrSend( pTpdu->abHeader, 5 );
+
+    return 0;
+}
+
+/**
+ * Aborts the asynchronous TPDU in progress, its callback is invoked with
+ * ISO7816_STATUS_ABORTED.
+ */
+void ISO7816_XfrAbort( void )
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if ( bXfrState != XFR_IDLE ) {
+        _XfrEnd( ISO7816_STATUS_ABORTED );
+    }
+    __set_PRIMASK( primask );
+}
+
+/**
+ * \return 1 if an asynchronous TPDU is in progress.
+ */
+uint8_t ISO7816_IsXfrBusy( void )
+{
+    return (bXfrState != XFR_IDLE);
+}
+
+/**
+ * USART interrupt service of the asynchronous TPDU exchange, to be called
+ * from the USART interrupt handler.
+ */
+void ISO7816_Handler( void )
+{
+    Usart *pUs = BOARD_ISO7816_BASE_USART;
+    uint32_t status = pUs->US_CSR & pUs->US_IMR;
+
+    if ( bXfrState == XFR_IDLE ) {
+        return;
+    }
+    /* Repetitions exhausted or card mute */
+    if ( status & US_CSR_ITER ) {
+        _XfrEnd( ISO7816_STATUS_ERROR );
+        return;
+    }
+    if ( status & US_CSR_TIMEOUT ) {
+        _XfrEnd( ISO7816_STATUS_TIMEOUT );
+        return;
+    }
+
+    switch ( bXfrState ) {
+
+        case XFR_SEND:
+            /* Last character in the transmitter, wait until it is out */
+            if ( status & US_CSR_ENDTX ) {
+                pUs->US_IDR = US_IDR_ENDTX;
+                bXfrState = XFR_FLUSH;
+                pUs->US_IER = US_IER_TXEMPTY;
+            }
+            break;
+
+        case XFR_FLUSH:
+            /* Turn the line around for the procedure byte */
+            if ( status & US_CSR_TXEMPTY ) {
+                pUs->US_IDR = US_IDR_TXEMPTY | US_IDR_ITER;
+                pUs->US_PTCR = US_PTCR_TXTDIS;
+                pUs->US_CR = US_CR_RSTSTA | US_CR_RSTIT | US_CR_RSTNACK;
+                StateUsartGlobal = USART_RCV;
+                pXfr->wTransferred += wXfrChunk;
+                wXfrChunk = 0;
+                _XfrWaitProcedure();
+            }
+            break;
+
+        case XFR_RECV:
+            if ( status & US_CSR_ENDRX ) {
+                pUs->US_IDR = US_IDR_ENDRX;
+                pUs->US_PTCR = US_PTCR_RXTDIS;
+                pXfr->wTransferred += wXfrChunk;
+                wXfrChunk = 0;
+                _XfrWaitProcedure();
+            }
+            break;
+
+        case XFR_PROC:
+            if ( status & US_CSR_RXRDY ) {
+                _XfrProcedure( pUs->US_RHR & 0xFF );
+            }
+            break;
+
+        case XFR_SW2:
+            if ( status & US_CSR_RXRDY ) {
+                pXfr->abSW[1] = pUs->US_RHR & 0xFF;
+                _XfrEnd( ISO7816_STATUS_SUCCESS );
+            }
+            break;
+    }
+}
+
+/**
+ * Reads the interface parameters from an ATR.
+ * \param pAtr    ATR, as read by ISO7816_Datablock_ATR().
+ * \param pParams Parameters, the defaults being used for the absent bytes.
+ */
+void ISO7816_ParseATR( const uint8_t* pAtr, Iso7816Params* pParams )
+{
+    uint32_t i = 2;
+    uint32_t dwLevel = 1;
+    uint32_t y = pAtr[1] & 0xF0;
+    uint8_t bProtocol = ISO7816_PROTOCOL_T0;
+
+    pParams->bTA1 = ISO7816_TA1_DEFAULT;
+    pParams->bProtocols = 0;
+    pParams->bSpecific = 0;
+    pParams->bN = 0;
+    pParams->bIfsc = ISO7816_T1_IFS_DEFAULT;
+    pParams->bCwi = 13;
+    pParams->bBwi = 4;
+    pParams->bCrc = 0;
+
+    while ( y ) {
+
+        /* The bytes of level 3 and beyond following a TD for T=1 are specific to T=1 */
+        if ( y & 0x10 ) {  /* TA[i] */
+            if ( dwLevel == 1 ) {
+                pParams->bTA1 = pAtr[i];
+            }
+            else if ( dwLevel == 2 ) {
+                pParams->bSpecific = 1;
+            }
+            else if ( bProtocol == ISO7816_PROTOCOL_T1 ) {
+                pParams->bIfsc = pAtr[i];
+            }
+            i++;
+        }
+        if ( y & 0x20 ) {  /* TB[i] */
+            if ( (dwLevel > 2) && (bProtocol == ISO7816_PROTOCOL_T1) ) {
+                pParams->bBwi = pAtr[i] >> 4;
+                pParams->bCwi = pAtr[i] & 0x0F;
+            }
+            i++;
+        }
+        if ( y & 0x40 ) {  /* TC[i] */
+            if ( dwLevel == 1 ) {
+                pParams->bN = pAtr[i];
+            }
+            else if ( (dwLevel > 2) && (bProtocol == ISO7816_PROTOCOL_T1) ) {
+                pParams->bCrc = pAtr[i] & 1;
+            }
+            i++;
+        }
+        if ( y & 0x80 ) {  /* TD[i] */
+            bProtocol = pAtr[i] & 0x0F;
+            if ( bProtocol < 8 ) {
+                pParams->bProtocols |= 1 << bProtocol;
+            }
+            y = pAtr[i++] & 0xF0;
+        }
+        else {
+            y = 0;
+        }
+        dwLevel++;
+    }
+
+    /* Without TD1, only T=0 is offered */
+    if ( pParams->bProtocols == 0 ) {
+        pParams->bProtocols = 1 << ISO7816_PROTOCOL_T0;
+    }
+}
+
+/**
+ * Protocol and parameters selection, right after the ATR: proposes a
+ * protocol and Fi/Di to the card, usually the TA1 of its ATR which gives
+ * the highest baud rate the card supports. The new Fi/Di is used once the
+ * card has accepted it.
+ * \param bProtocol ISO7816_PROTOCOL_T0 or ISO7816_PROTOCOL_T1.
+ * \param bTA1      Fi in the high nibble, Di in the low nibble.
+ * \return ISO7816_STATUS_SUCCESS if the card accepted the protocol (the
+ *         Fi/Di may have been left to the default by the card),
+ *         ISO7816_STATUS_TIMEOUT if it did not answer, otherwise
+ *         ISO7816_STATUS_ERROR; the card must then be reset.
+ */
+uint8_t ISO7816_PPS( uint8_t bProtocol, uint8_t bTA1 )
+{
+    uint8_t abPps[4];
+    uint8_t abAnswer[6];
+    uint8_t bStatus;
+    uint8_t bLength;
+
+    if ( _GetFiDiRatio( bTA1 ) == 0 ) {
+        return ISO7816_STATUS_ERROR;
+    }
+
+    /* PPSS, PPS0 announcing PPS1, PPS1, PCK */
+    abPps[0] = 0xFF;
+    abPps[1] = 0x10 | bProtocol;
+    abPps[2] = bTA1;
+    abPps[3] = _T1Lrc( abPps, 3 );
+    _Send( abPps, 4 );
+
+    /* PPSS and PPS0, then PPS1 to PPS3 as announced by PPS0, and PCK */
+    bStatus = _Receive( abAnswer, 2, ISO7816_WWT_ETU, ISO7816_WWT_ETU );
+    if ( bStatus == ISO7816_STATUS_SUCCESS ) {
+        bLength = ((abAnswer[1] >> 4) & 1) + ((abAnswer[1] >> 5) & 1)
+                + ((abAnswer[1] >> 6) & 1) + 1;
+        bStatus = _Receive( &abAnswer[2], bLength, ISO7816_WWT_ETU, ISO7816_WWT_ETU );
+    }
+    if ( bStatus != ISO7816_STATUS_SUCCESS ) {
+        TRACE_DEBUG("PPS %u\n\r", bStatus);
+        return bStatus;
+    }
+
+    if ( (abAnswer[0] != 0xFF) || ((abAnswer[1] & 0x0F) != bProtocol)
+      || (_T1Lrc( abAnswer, 2 + bLength ) != 0) ) {
+        return ISO7816_STATUS_ERROR;
+    }
+    /* PPS1 echoed: the card switches to the new Fi/Di */
+    if ( abAnswer[1] & 0x10 ) {
+        if ( abAnswer[2] != bTA1 ) {
+            return ISO7816_STATUS_ERROR;
+        }
+        BOARD_ISO7816_BASE_USART->US_FIDI = _GetFiDiRatio( bTA1 );
+        bFiDi = bTA1;
+    }
+    return ISO7816_STATUS_SUCCESS;
+}
+
+/**
+ * Switches to the T=1 protocol, after the ATR and the PPS if any.
+ * \param pParams Parameters read from the ATR by ISO7816_ParseATR().
+ * \return ISO7816_STATUS_SUCCESS, or ISO7816_STATUS_ERROR if the card asks
+ *         for a CRC.
+ */
+uint8_t ISO7816_T1_Init( const Iso7816Params* pParams )
+{
+    uint32_t dwFi = awFi[bFiDi >> 4];
+    uint32_t dwDi = abDi[bFiDi & 0x0F];
+    uint32_t dwBwi = (pParams->bBwi > 9) ? 9 : pParams->bBwi;
+
+    if ( pParams->bCrc ) {
+        return ISO7816_STATUS_ERROR;
+    }
+
+    /* BWT = 11 etu + 2^BWI x 960 x 372 / f, CWT = 11 + 2^CWI etu */
+    dwT1Bwt = 11 + ((960 << dwBwi) * dwDi / dwFi) * 372;
+    dwT1Cwt = 11 + (1 << pParams->bCwi);
+    bT1Ifsc = pParams->bIfsc ? pParams->bIfsc : ISO7816_T1_IFS_DEFAULT;
+    if ( bT1Ifsc > ISO7816_T1_IFS_MAX ) {
+        bT1Ifsc = ISO7816_T1_IFS_MAX;
+    }
+    bT1Ns = 0;
+    bT1Nr = 0;
+    bT1Wtx = 0;
+
+    /* Character guard time 11 + N etu, 11 etu for N = 255 */
+    _SetMode( US_MR_USART_MODE_IS07816_T_1 );
+    BOARD_ISO7816_BASE_USART->US_TTGR = (pParams->bN == 255) ? 0 : pParams->bN;
+
+    return ISO7816_STATUS_SUCCESS;
+}
+
+/**
+ * Tells the card the size of the T=1 blocks the reader accepts (IFSD),
+ * 32 bytes until then.
+ * \param bIfsd Information field size, up to ISO7816_T1_IFS_MAX.
+ * \return ISO7816_STATUS_SUCCESS if the card acknowledged the new size.
+ */
+uint8_t ISO7816_T1_SetIfsd( uint8_t bIfsd )
+{
+    uint8_t bRetries;
+
+    for ( bRetries = 0; bRetries <= ISO7816_T1_RETRIES; bRetries++ ) {
+        _T1BuildCtl( 0xC1, 1, bIfsd );
+        if ( (_T1Exchange( abT1Ctl ) == ISO7816_STATUS_SUCCESS)
+          && (abT1Rx[1] == 0xE1) && (abT1Rx[2] == 1) && (abT1Rx[3] == bIfsd) ) {
+            return ISO7816_STATUS_SUCCESS;
+        }
+    }
+    return ISO7816_STATUS_ERROR;
+}
+
+/**
+ * Transfert an APDU with the T=1 block protocol. The command is chained
+ * over several I-blocks if it exceeds the IFSC; the response may be chained
+ * too. Each block is sent and received by the PDC.
+ * \param pAPDU    APDU buffer
+ * \param pMessage Buffer for the response, data and status words
+ * \param wLength  APDU length
+ * \return         Response length, 0 on error (the card should then be reset)
+ */
+uint16_t ISO7816_XfrBlockAPDU_T1( const uint8_t *pAPDU,
+                                  uint8_t *pMessage,
+                                  uint16_t wLength )
+{
+    uint16_t wSent = 0;
+    uint16_t wChunk;
+    uint16_t wReceived = 0;
+    uint8_t *pBlock = abT1Tx;
+    uint8_t bPending = 1;
+    uint8_t bRetries = 0;
+    uint8_t bStatus;
+    uint8_t bPcb;
+
+    wChunk = _T1BuildI( pAPDU, wLength, 0 );
+
+    while ( bRetries <= ISO7816_T1_RETRIES ) {
+
+        bStatus = _T1Exchange( pBlock );
+        bPcb = abT1Rx[1];
+
+        /* Invalid block, or I-block out of sequence: ask for it again */
+        if ( (bStatus != ISO7816_STATUS_SUCCESS)
+          || (((bPcb & 0x80) == 0)
+              && ((((bPcb >> 6) & 1) != bT1Nr) || ((wSent + wChunk) < wLength))) ) {
+            TRACE_DEBUG("T1 err %u %02X\n\r", bStatus, bPcb);
+            bRetries++;
+            _T1BuildCtl( 0x80 | (bT1Nr << 4) | ((bStatus == ISO7816_STATUS_ERROR) ? 1 : 2), 0, 0 );
+            pBlock = abT1Ctl;
+        }
+        /* I-block: the response or a part of it, acknowledging the command */
+        else if ( (bPcb & 0x80) == 0 ) {
+            if ( bPending ) {
+                bT1Ns ^= 1;
+                bPending = 0;
+            }
+            memcpy( &pMessage[wReceived], &abT1Rx[3], abT1Rx[2] );
+            wReceived += abT1Rx[2];
+            bT1Nr ^= 1;
+            bRetries = 0;
+            if ( (bPcb & 0x20) == 0 ) {
+                return wReceived;
+            }
+            _T1BuildCtl( 0x80 | (bT1Nr << 4), 0, 0 );
+            pBlock = abT1Ctl;
+        }
+        /* R-block acknowledging a chained command block: send the next one */
+        else if ( ((bPcb & 0xC0) == 0x80) && bPending
+               && (((bPcb >> 4) & 1) != bT1Ns) && ((wSent + wChunk) < wLength) ) {
+            bT1Ns ^= 1;
+            wSent += wChunk;
+            wChunk = _T1BuildI( pAPDU, wLength, wSent );
+            pBlock = abT1Tx;
+            bRetries = 0;
+        }
+        /* Other R-block: the card asks for our last block again */
+        else if ( (bPcb & 0xC0) == 0x80 ) {
+            bRetries++;
+            if ( bPending ) {
+                pBlock = abT1Tx;
+            }
+        }
+        /* S-block requests: IFS and WTX are answered, ABORT and RESYNCH
+           are not supported */
+        else if ( ((bPcb == 0xC1) || (bPcb == 0xC3)) && (abT1Rx[2] == 1) ) {
+            if ( bPcb == 0xC1 ) {
+                bT1Ifsc = abT1Rx[3] ? abT1Rx[3] : ISO7816_T1_IFS_DEFAULT;
+                if ( bT1Ifsc > ISO7816_T1_IFS_MAX ) {
+                    bT1Ifsc = ISO7816_T1_IFS_MAX;
+                }
+            }
+            else {
+                bT1Wtx = abT1Rx[3];
+            }
+            _T1BuildCtl( bPcb | 0x20, 1, abT1Rx[3] );
+            pBlock = abT1Ctl;
+        }
+        else {
+            TRACE_DEBUG("T1 S-block %02X\n\r", bPcb);
+            break;
+        }
+    }
+
+    return 0;
+}
+
 /**
  *  Escape ISO7816
  */
@@ -444,6 +1225,7 @@ void ISO7816_cold_reset( void )
 
     BOARD_ISO7816_BASE_USART->US_RHR;
     BOARD_ISO7816_BASE_USART->US_CR = US_CR_RSTSTA | US_CR_RSTIT | US_CR_RSTNACK;
+    _SetDefaults();
 
     ISO7816_IccPowerOn();
 }
@@ -463,6 +1245,7 @@ void ISO7816_warm_reset( void )
 
     BOARD_ISO7816_BASE_USART->US_RHR;
     BOARD_ISO7816_BASE_USART->US_CR = US_CR_RSTSTA | US_CR_RSTIT | US_CR_RSTNACK;
+    _SetDefaults();
 
     ISO7816_IccPowerOn();
 }
@@ -590,8 +1373,10 @@ void ISO7816_Init( const Pin pPinIso7816RstMC )
 
     /* Configure USART */
     PMC_EnablePeripheral(BOARD_ISO7816_ID_USART);
-    /* Disable interrupts */
+    /* Disable interrupts, the USART interrupt only serves
+       ISO7816_XfrTPDU_T0_Start() */
     BOARD_ISO7816_BASE_USART->US_IDR = (uint32_t) -1;
+    NVIC_EnableIRQ( (IRQn_Type) BOARD_ISO7816_ID_USART );
 
     BOARD_ISO7816_BASE_USART->US_FIDI = 372;  /* by default */
     /* Define the baud rate divisor register */
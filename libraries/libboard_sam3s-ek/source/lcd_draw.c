@@ -45,6 +45,50 @@
 #include <string.h>
 #include <assert.h>
 
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Box filler of the span rasterizer: clips the box to the screen and
+ * writes it as one burst through a GRAM window.
+ *
+ * \param pContext  Pointer to the fill color.
+ */
+static void _LCDD_FillBox( void* pContext, int32_t iX, int32_t iY, uint32_t dwWidth, uint32_t dwHeight )
+{
+    int32_t iX2 = iX + (int32_t)dwWidth - 1 ;
+    int32_t iY2 = iY + (int32_t)dwHeight - 1 ;
+
+    if ( iX < 0 ) iX = 0 ;
+    if ( iY < 0 ) iY = 0 ;
+    if ( iX2 >= BOARD_LCD_WIDTH ) iX2 = BOARD_LCD_WIDTH - 1 ;
+    if ( iY2 >= BOARD_LCD_HEIGHT ) iY2 = BOARD_LCD_HEIGHT - 1 ;
+
+    if ( (iX > iX2) || (iY > iY2) )
+    {
+        return ;
+    }
+
+    dwWidth = iX2 - iX + 1 ;
+    dwHeight = iY2 - iY + 1 ;
+
+    if ( dwHeight == 1 )
+    {
+        /* A single line needs no window: GRAM address increments along it */
+        LCD_SetCursor( iX, iY ) ;
+        LCD_WriteRAM_Prepare() ;
+        LCD_WriteRAMFill( *(uint32_t*)pContext, dwWidth ) ;
+        return ;
+    }
+
+    LCD_SetWindow( iX, iY, dwWidth, dwHeight ) ;
+    LCD_SetCursor( iX, iY ) ;
+    LCD_WriteRAM_Prepare() ;
+    LCD_WriteRAMFill( *(uint32_t*)pContext, dwWidth * dwHeight ) ;
+    LCD_SetWindow( 0, 0, BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT ) ;
+}
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -56,15 +100,10 @@
  */
 void LCDD_Fill( uint32_t dwColor )
 {
-    uint32_t dw ;
-
     LCD_SetCursor( 0, 0 ) ;
     LCD_WriteRAM_Prepare() ;
 
-    for ( dw = BOARD_LCD_WIDTH * BOARD_LCD_HEIGHT; dw > 0; dw-- )
-    {
-        LCD_WriteRAM( dwColor ) ;
-    }
+    LCD_WriteRAMFill( dwColor, BOARD_LCD_WIDTH * BOARD_LCD_HEIGHT ) ;
 }
 
 /**
@@ -111,30 +150,35 @@ extern uint32_t LCDD_ReadPixel( uint32_t x, uint32_t y )
  */
 extern void LCDD_DrawLine( uint32_t x, uint32_t y, uint32_t length, uint32_t direction, uint32_t color )
 {
-    uint32_t i = 0 ;
-
-    LCD_SetCursor( x, y ) ;
+    if ( length == 0 )
+    {
+        return ;
+    }
 
     if ( direction == DIRECTION_HLINE )
     {
-        LCD_WriteRAM_Prepare() ;
-        for ( i = 0; i < length; i++ )
-        {
-            LCD_WriteRAM( color ) ;
-        }
+        _LCDD_FillBox( &color, x, y, length, 1 ) ;
     }
     else
     {
-        for ( i = 0; i < length; i++ )
-        {
-            LCD_WriteRAM_Prepare() ;
-            LCD_WriteRAM( color ) ;
-            y++ ;
-            LCD_SetCursor( x, y ) ;
-        }
+        _LCDD_FillBox( &color, x, y, 1, length ) ;
     }
 }
 
+/**
+ * \brief Draw a line of any slope on LCD.
+ *
+ * \param dwX1    X-coordinate of line start.
+ * \param dwY1    Y-coordinate of line start.
+ * \param dwX2    X-coordinate of line end.
+ * \param dwY2    Y-coordinate of line end.
+ * \param dwColor Line color.
+ */
+extern void LCDD_DrawLineTo( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2, uint32_t dwColor )
+{
+    LCDR_Line( dwX1, dwY1, dwX2, dwY2, _LCDD_FillBox, &dwColor ) ;
+}
+
 /*
  * \brief Draws a rectangle on LCD, at the given coordinates.
  *
@@ -164,17 +208,12 @@ extern void LCDD_DrawRectangle( uint32_t x, uint32_t y, uint32_t width, uint32_t
  */
 extern void LCDD_DrawRectangleWithFill( uint32_t dwX, uint32_t dwY, uint32_t dwWidth, uint32_t dwHeight, uint32_t dwColor )
 {
-    uint32_t i ;
-
-    LCD_SetWindow( dwX, dwY, dwWidth, dwHeight ) ;
-    LCD_SetCursor( dwX, dwY ) ;
-    LCD_WriteRAM_Prepare() ;
-
-    for ( i = dwWidth * dwHeight; i > 0; i-- )
+    if ( (dwWidth == 0) || (dwHeight == 0) )
     {
-        LCD_WriteRAM( dwColor ) ;
+        return ;
     }
-    LCD_SetWindow( 0, 0, BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT ) ;
+
+    _LCDD_FillBox( &dwColor, dwX, dwY, dwWidth, dwHeight ) ;
     LCD_SetCursor( 0, 0 ) ;
 }
 
@@ -188,34 +227,20 @@ extern void LCDD_DrawRectangleWithFill( uint32_t dwX, uint32_t dwY, uint32_t dwW
  */
 extern void LCDD_DrawCircle( uint32_t x, uint32_t y, uint32_t r, uint32_t color )
 {
-    signed int    d;    /* Decision Variable */
-    uint32_t  curX; /* Current X Value */
-    uint32_t  curY; /* Current Y Value */
-
-    d = 3 - (r << 1);
-    curX = 0;
-    curY = r;
+    LCDR_Circle( x, y, r, _LCDD_FillBox, &color ) ;
+}
 
-    while (curX <= curY)
-    {
-        LCDD_DrawPixel(x + curX, y + curY, color);
-        LCDD_DrawPixel(x + curX, y - curY, color);
-        LCDD_DrawPixel(x - curX, y + curY, color);
-        LCDD_DrawPixel(x - curX, y - curY, color);
-        LCDD_DrawPixel(x + curY, y + curX, color);
-        LCDD_DrawPixel(x + curY, y - curX, color);
-        LCDD_DrawPixel(x - curY, y + curX, color);
-        LCDD_DrawPixel(x - curY, y - curX, color);
-
-        if (d < 0) {
-            d += (curX << 2) + 6;
-        }
-        else {
-            d += ((curX - curY) << 2) + 10;
-            curY--;
-        }
-        curX++;
-    }
+/**
+ * \brief Draws a filled circle on LCD, at the given coordinates.
+ *
+ * \param x      X-coordinate of circle center.
+ * \param y      Y-coordinate of circle center.
+ * \param r      circle radius.
+ * \param color  circle color.
+ */
+extern void LCDD_DrawFilledCircle( uint32_t x, uint32_t y, uint32_t r, uint32_t color )
+{
+    LCDR_FilledCircle( x, y, r, _LCDD_FillBox, &color ) ;
 }
 
 /**
@@ -279,6 +304,38 @@ extern void LCDD_DrawStringWithBGColor( uint32_t x, uint32_t y, const char *pStr
     }
 }
 
+/**
+ * \brief Draws a string with a run-length encoded font, at the given coordinates
+ * with given background color. Line breaks will be honored.
+ *
+ * \param x         X-coordinate of string top-left corner.
+ * \param y         Y-coordinate of string top-left corner.
+ * \param pString   String to display.
+ * \param pFont     Font.
+ * \param fontColor String color.
+ * \param bgColor   Background color.
+ */
+extern void LCDD_DrawStringRLE( uint32_t x, uint32_t y, const char *pString, const FontRLE *pFont, uint32_t fontColor, uint32_t bgColor )
+{
+    uint32_t xorg = x ;
+
+    while ( *pString != 0 )
+    {
+        if ( *pString == '\n' )
+        {
+            y += pFont->height + 2 ;
+            x = xorg ;
+        }
+        else
+        {
+            LCDD_DrawCharRLE( x, y, *pString, pFont, fontColor, bgColor ) ;
+            x += pFont->width + 2 ;
+        }
+
+        pString++ ;
+    }
+}
+
 /**
  * \brief Returns the width & height in pixels that a string will occupy on the screen
  * if drawn using LCDD_DrawString.
@@ -335,18 +392,11 @@ extern void LCDD_GetStringSize( const uint8_t *pString, uint32_t *pWidth, uint32
  */
 void LCDD_DrawImage( uint32_t dwX, uint32_t dwY, const uint8_t *pImage, uint32_t dwWidth, uint32_t dwHeight )
 {
-    uint32_t dwCursor ;
-
     LCD_SetWindow( dwX, dwY, dwWidth, dwHeight ) ;
     LCD_SetCursor( dwX, dwY ) ;
     LCD_WriteRAM_Prepare() ;
 
-    for ( dwCursor=dwWidth*dwHeight; dwCursor != 0; dwCursor-- )
-    {
-        LCD_D() = *pImage++ ;
-        LCD_D() = *pImage++ ;
-        LCD_D() = *pImage++ ;
-    }
+    LCD_WriteRAMPacked( pImage, dwWidth*dwHeight ) ;
 
     LCD_SetWindow( 0, 0, BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT ) ;
 }
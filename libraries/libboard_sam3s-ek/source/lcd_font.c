@@ -43,6 +43,25 @@
 #include <stdint.h>
 #include <assert.h>
 
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of glyphs kept pre-rendered by LCDD_DrawCharWithBGColor() */
+#define LCD_GLYPH_CACHE_SIZE    8
+
+/** Glyph pre-rendered for a font/background color pair, in panel format */
+typedef struct _GlyphCacheEntry {
+    /* Character, 0 for a free entry */
+    uint8_t c;
+    uint32_t fontColor;
+    uint32_t bgColor;
+    /* Last use stamp, for least recently used replacement */
+    uint32_t lastUse;
+    /* 3 bytes (R, G, B) per pixel, line by line */
+    uint8_t pixels[10 * 14 * 3];
+} GlyphCacheEntry;
+
 /*----------------------------------------------------------------------------
  *        Local variables
  *----------------------------------------------------------------------------*/
@@ -50,6 +69,92 @@
 /** Global variable describing the font being instancied. */
 const Font gFont = {10, 14};
 
+/** Pre-rendered glyphs */
+static GlyphCacheEntry gGlyphCache[LCD_GLYPH_CACHE_SIZE];
+
+/** Glyph cache use counter */
+static uint32_t gGlyphCacheStamp;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Returns the pre-rendered glyph of a character for a color pair,
+ * rendering it in the least recently used entry if not cached.
+ */
+static const GlyphCacheEntry *GetGlyph( uint8_t c, uint32_t fontColor, uint32_t bgColor )
+{
+    GlyphCacheEntry *pEntry = &gGlyphCache[0];
+    const uint8_t *pGlyph;
+    uint8_t *pPixel;
+    uint32_t i, row, col, color ;
+
+    gGlyphCacheStamp++;
+
+    for ( i = 0 ; i < LCD_GLYPH_CACHE_SIZE ; i++ )
+    {
+        if ( (gGlyphCache[i].c == c) && (gGlyphCache[i].fontColor == fontColor) && (gGlyphCache[i].bgColor == bgColor) )
+        {
+            gGlyphCache[i].lastUse = gGlyphCacheStamp;
+            return &gGlyphCache[i];
+        }
+
+        if ( gGlyphCache[i].lastUse < pEntry->lastUse )
+        {
+            pEntry = &gGlyphCache[i];
+        }
+    }
+
+    /* Render the glyph line by line from the column organized font */
+    pGlyph = &pCharset10x14[(c - 0x20) * 20];
+    pPixel = pEntry->pixels;
+    for ( row = 0 ; row < 14 ; row++ )
+    {
+        for ( col = 0 ; col < 10 ; col++ )
+        {
+            if ( row < 8 )
+            {
+                color = ((pGlyph[col * 2] >> (7 - row)) & 0x1) ? fontColor : bgColor;
+            }
+            else
+            {
+                color = ((pGlyph[col * 2 + 1] >> (15 - row)) & 0x1) ? fontColor : bgColor;
+            }
+            *pPixel++ = (color >> 16) & 0xFF;
+            *pPixel++ = (color >> 8) & 0xFF;
+            *pPixel++ = color & 0xFF;
+        }
+    }
+
+    pEntry->c = c;
+    pEntry->fontColor = fontColor;
+    pEntry->bgColor = bgColor;
+    pEntry->lastUse = gGlyphCacheStamp;
+
+    return pEntry;
+}
+
+/**
+ * \brief Blend two colors.
+ *
+ * \param level  Coverage of the font color, from 0 to 3.
+ */
+static uint32_t BlendColor( uint32_t fontColor, uint32_t bgColor, uint32_t level )
+{
+    uint32_t shift, result = 0;
+    int32_t f, b;
+
+    for ( shift = 0 ; shift < 24 ; shift += 8 )
+    {
+        f = (fontColor >> shift) & 0xFF;
+        b = (bgColor >> shift) & 0xFF;
+        result |= (uint32_t)(b + ((f - b) * (int32_t)level) / 3) << shift;
+    }
+
+    return result;
+}
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -64,28 +169,34 @@ const Font gFont = {10, 14};
  */
 extern void LCDD_DrawChar( uint32_t x, uint32_t y, uint8_t c, uint32_t color )
 {
-    uint32_t row, col ;
+    uint32_t row, col, start, bits ;
 
     assert( (c >= 0x20) && (c <= 0x7F) ) ;
 
+    /* Each glyph column is written through a one pixel wide window, one
+       burst per run of set pixels, the background being left untouched */
     for ( col = 0 ; col < 10 ; col++ )
     {
-        for ( row = 0 ; row < 8 ; row++ )
-        {
-            if ( (pCharset10x14[((c - 0x20) * 20) + col * 2] >> (7 - row)) & 0x1 )
-            {
-                LCDD_DrawPixel( x+col, y+row, color ) ;
-            }
-        }
+        bits = (pCharset10x14[((c - 0x20) * 20) + col * 2] << 8) | pCharset10x14[((c - 0x20) * 20) + col * 2 + 1] ;
 
-        for (row = 0; row < 6; row++ )
+        LCD_SetWindow( x+col, y, 1, 14 ) ;
+        for ( row = 0 ; row < 14 ; )
         {
-            if ((pCharset10x14[((c - 0x20) * 20) + col * 2 + 1] >> (7 - row)) & 0x1)
+            if ( ((bits >> (15 - row)) & 0x1) == 0 )
             {
-                LCDD_DrawPixel( x+col, y+row+8, color ) ;
+                row++ ;
+                continue ;
             }
+
+            for ( start = row ; (row < 14) && ((bits >> (15 - row)) & 0x1) ; row++ ) ;
+
+            LCD_SetCursor( x+col, y+start ) ;
+            LCD_WriteRAM_Prepare() ;
+            LCD_WriteRAMFill( color, row - start ) ;
         }
     }
+
+    LCD_SetWindow( 0, 0, BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT ) ;
 }
 
 /**
@@ -99,35 +210,50 @@ extern void LCDD_DrawChar( uint32_t x, uint32_t y, uint8_t c, uint32_t color )
  */
 extern void LCDD_DrawCharWithBGColor( uint32_t x, uint32_t y, uint8_t c, uint32_t fontColor, uint32_t bgColor )
 {
-    uint32_t row, col ;
+    const GlyphCacheEntry *pGlyph ;
 
     assert( (c >= 0x20) && (c <= 0x7F) ) ;
 
-    for (col = 0; col < 10; col++)
-    {
-        for (row = 0 ; row < 8 ; row++)
-        {
-            if ( (pCharset10x14[((c - 0x20) * 20) + col * 2] >> (7 - row)) & 0x1 )
-            {
-                LCDD_DrawPixel( x+col, y+row, fontColor ) ;
-            }
-            else
-            {
-                LCDD_DrawPixel( x+col, y+row, bgColor ) ;
-            }
-        }
+    /* Whole glyph pushed in one windowed burst */
+    pGlyph = GetGlyph( c, fontColor, bgColor ) ;
+    LCDD_DrawImage( x, y, pGlyph->pixels, 10, 14 ) ;
+}
 
-        for ( row = 0 ; row < 6 ; row++ )
-        {
-            if ( (pCharset10x14[((c - 0x20) * 20) + col * 2 + 1] >> (7 - row)) & 0x1 )
-            {
-                LCDD_DrawPixel( x+col, y+row+8, fontColor ) ;
-            }
-            else
-            {
-                LCDD_DrawPixel( x+col, y+row+8, bgColor ) ;
-            }
-        }
+/**
+ * \brief Draws a character of a run-length encoded font on LCD. Each run is
+ * written as one burst of the blended color.
+ *
+ * \param x          X-coordinate of character upper-left corner.
+ * \param y          Y-coordinate of character upper-left corner.
+ * \param c          Character to output.
+ * \param pFont      Font.
+ * \param fontColor  Character color.
+ * \param bgColor    Background color.
+ */
+extern void LCDD_DrawCharRLE( uint32_t x, uint32_t y, uint8_t c, const FontRLE *pFont, uint32_t fontColor, uint32_t bgColor )
+{
+    uint32_t palette[4] ;
+    const uint8_t *pRun, *pEnd ;
+
+    assert( (c >= pFont->firstChar) && (c <= pFont->lastChar) ) ;
+
+    palette[0] = bgColor ;
+    palette[1] = BlendColor( fontColor, bgColor, 1 ) ;
+    palette[2] = BlendColor( fontColor, bgColor, 2 ) ;
+    palette[3] = fontColor ;
+
+    pRun = &pFont->pData[pFont->pOffsets[c - pFont->firstChar]] ;
+    pEnd = &pFont->pData[pFont->pOffsets[c - pFont->firstChar + 1]] ;
+
+    LCD_SetWindow( x, y, pFont->width, pFont->height ) ;
+    LCD_SetCursor( x, y ) ;
+    LCD_WriteRAM_Prepare() ;
+
+    for ( ; pRun < pEnd ; pRun++ )
+    {
+        LCD_WriteRAMFill( palette[*pRun >> 6], (*pRun & 0x3F) + 1 ) ;
     }
+
+    LCD_SetWindow( 0, 0, BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT ) ;
 }
 
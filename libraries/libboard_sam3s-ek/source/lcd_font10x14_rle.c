@@ -0,0 +1,313 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+ /**
+ * \file
+ *
+ * Run-length encoded version of the 10x14 font, generated off-line from
+ * pCharset10x14 (two coverage levels only, the source font is not
+ * anti-aliased). See FontRLE for the encoding.
+ *
+ */
+
+#include "board.h"
+
+/** Start of each glyph in gucFont10x14RLEData, plus the end of the last one */
+static const uint16_t gwFont10x14RLEOffsets[] = {
+	   0,    3,   28,   46,   91,  124,  169,  217,  231,  260,
+	 289,  324,  343,  357,  360,  370,  399,  434,  463,  491,
+	 522,  557,  581,  612,  638,  671,  702,  719,  740,  769,
+	 774,  803,  832,  875,  901,  929,  960,  988, 1009, 1033,
+	1064, 1089, 1118, 1151, 1192, 1217, 1252, 1285, 1316, 1344,
+	1380, 1415, 1440, 1466, 1496, 1528, 1564, 1599, 1631, 1654,
+	1683, 1704, 1733, 1751, 1754, 1766, 1789, 1817, 1840, 1868,
+	1889, 1920, 1939, 1979, 2000, 2029, 2072, 2101, 2127, 2153,
+	2176, 2197, 2217, 2242, 2259, 2290, 2313, 2338, 2367, 2395,
+	2420, 2436, 2465, 2495, 2524, 2527, 2530
+} ;
+
+/** Glyph runs */
+static const uint8_t gucFont10x14RLEData[] = {
+	0x3F, 0x3F, 0x0B, 0x03, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07,
+	0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07,
+	0xC1, 0x07, 0xC1, 0x1B, 0xC1, 0x07, 0xC1, 0x03, 0x01, 0xC1,
+	0x01, 0xC1, 0x03, 0xC1, 0x01, 0xC1, 0x03, 0xC1, 0x01, 0xC1,
+	0x03, 0xC1, 0x01, 0xC1, 0x3F, 0x25, 0x01, 0xC1, 0x01, 0xC1,
+	0x03, 0xC1, 0x01, 0xC1, 0x03, 0xC1, 0x01, 0xC1, 0x03, 0xC1,
+	0x01, 0xC1, 0x01, 0xD3, 0x01, 0xC1, 0x01, 0xC1, 0x03, 0xC1,
+	0x01, 0xC1, 0x01, 0xD3, 0x01, 0xC1, 0x01, 0xC1, 0x03, 0xC1,
+	0x01, 0xC1, 0x03, 0xC1, 0x01, 0xC1, 0x03, 0xC1, 0x01, 0xC1,
+	0x01, 0x03, 0xC1, 0x07, 0xC1, 0x05, 0xC6, 0x01, 0xCB, 0x00,
+	0xC1, 0x01, 0xC4, 0x00, 0xC1, 0x04, 0xC6, 0x03, 0xC6, 0x04,
+	0xC1, 0x00, 0xC4, 0x01, 0xC1, 0x00, 0xCB, 0x01, 0xC6, 0x05,
+	0xC1, 0x07, 0xC1, 0x03, 0x00, 0xC1, 0x03, 0xC1, 0x00, 0xC3,
+	0x02, 0xC1, 0x00, 0xC3, 0x01, 0xC1, 0x02, 0xC1, 0x02, 0xC1,
+	0x06, 0xC1, 0x07, 0xC1, 0x06, 0xC1, 0x07, 0xC1, 0x06, 0xC1,
+	0x07, 0xC1, 0x06, 0xC1, 0x02, 0xC1, 0x02, 0xC1, 0x01, 0xC3,
+	0x00, 0xC1, 0x02, 0xC3, 0x00, 0xC1, 0x03, 0xC1, 0x00, 0x01,
+	0xC3, 0x04, 0xC5, 0x02, 0xC1, 0x03, 0xC1, 0x01, 0xC1, 0x02,
+	0xC2, 0x01, 0xC1, 0x01, 0xC2, 0x02, 0xC1, 0x00, 0xC2, 0x04,
+	0xC3, 0x05, 0xC3, 0x04, 0xC1, 0x00, 0xC2, 0x01, 0xC3, 0x01,
+	0xC2, 0x00, 0xC3, 0x02, 0xC3, 0x00, 0xC2, 0x02, 0xC2, 0x01,
+	0xC5, 0x00, 0xC1, 0x01, 0xC3, 0x01, 0xC1, 0x03, 0xC1, 0x06,
+	0xC3, 0x06, 0xC2, 0x07, 0xC1, 0x06, 0xC1, 0x06, 0xC1, 0x3F,
+	0x14, 0x05, 0xC1, 0x05, 0xC3, 0x04, 0xC2, 0x06, 0xC1, 0x06,
+	0xC2, 0x06, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07,
+	0xC2, 0x07, 0xC1, 0x07, 0xC2, 0x07, 0xC3, 0x07, 0xC1, 0x01,
+	0x01, 0xC1, 0x07, 0xC3, 0x07, 0xC2, 0x07, 0xC1, 0x07, 0xC2,
+	0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x06, 0xC2,
+	0x06, 0xC1, 0x06, 0xC2, 0x04, 0xC3, 0x05, 0xC1, 0x05, 0x17,
+	0xC1, 0x07, 0xC1, 0x03, 0xC1, 0x01, 0xC1, 0x01, 0xC4, 0x00,
+	0xC1, 0x00, 0xC2, 0x00, 0xC7, 0x02, 0xC5, 0x02, 0xC7, 0x00,
+	0xC2, 0x00, 0xC1, 0x00, 0xC4, 0x01, 0xC1, 0x01, 0xC1, 0x03,
+	0xC1, 0x07, 0xC1, 0x0D, 0x17, 0xC1, 0x07, 0xC1, 0x07, 0xC1,
+	0x07, 0xC1, 0x03, 0xD3, 0x03, 0xC1, 0x07, 0xC1, 0x07, 0xC1,
+	0x07, 0xC1, 0x17, 0x3F, 0x10, 0xC1, 0x06, 0xC3, 0x06, 0xC2,
+	0x07, 0xC1, 0x06, 0xC1, 0x06, 0xC1, 0x07, 0x3B, 0xD3, 0x3B,
+	0x3F, 0x24, 0xC1, 0x06, 0xC3, 0x05, 0xC3, 0x06, 0xC1, 0x06,
+	0x06, 0xC1, 0x07, 0xC1, 0x06, 0xC1, 0x07, 0xC1, 0x06, 0xC1,
+	0x07, 0xC1, 0x06, 0xC1, 0x07, 0xC1, 0x06, 0xC1, 0x07, 0xC1,
+	0x06, 0xC1, 0x07, 0xC1, 0x06, 0xC1, 0x07, 0xC1, 0x06, 0x01,
+	0xC5, 0x02, 0xC7, 0x00, 0xC2, 0x03, 0xC4, 0x04, 0xC4, 0x03,
+	0xC5, 0x02, 0xC6, 0x01, 0xC2, 0x00, 0xC3, 0x00, 0xC2, 0x01,
+	0xC6, 0x02, 0xC5, 0x03, 0xC4, 0x04, 0xC4, 0x03, 0xC2, 0x00,
+	0xC7, 0x02, 0xC5, 0x01, 0x03, 0xC1, 0x06, 0xC2, 0x05, 0xC3,
+	0x05, 0xC3, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1,
+	0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x05, 0xC5,
+	0x03, 0xC5, 0x01, 0x01, 0xC5, 0x02, 0xC7, 0x00, 0xC2, 0x03,
+	0xC4, 0x05, 0xC1, 0x07, 0xC1, 0x06, 0xC2, 0x05, 0xC2, 0x05,
+	0xC2, 0x05, 0xC2, 0x05, 0xC2, 0x05, 0xC2, 0x05, 0xC2, 0x05,
+	0xD3, 0x01, 0xC5, 0x02, 0xC7, 0x00, 0xC2, 0x03, 0xC4, 0x05,
+	0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x04, 0xC3, 0x05, 0xC3, 0x08,
+	0xC1, 0x07, 0xC3, 0x05, 0xC4, 0x03, 0xC2, 0x00, 0xC7, 0x02,
+	0xC5, 0x01, 0x05, 0xC1, 0x06, 0xC2, 0x05, 0xC3, 0x04, 0xC4,
+	0x03, 0xC2, 0x00, 0xC1, 0x02, 0xC2, 0x01, 0xC1, 0x01, 0xC2,
+	0x02, 0xC1, 0x01, 0xC1, 0x03, 0xC1, 0x01, 0xD3, 0x05, 0xC1,
+	0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x01, 0xD5, 0x07, 0xC1,
+	0x07, 0xC7, 0x01, 0xC8, 0x07, 0xC2, 0x07, 0xC1, 0x07, 0xC1,
+	0x07, 0xC3, 0x05, 0xC4, 0x03, 0xC2, 0x00, 0xC7, 0x02, 0xC5,
+	0x01, 0x01, 0xC5, 0x02, 0xC7, 0x00, 0xC2, 0x03, 0xC4, 0x05,
+	0xC3, 0x07, 0xC1, 0x07, 0xC7, 0x01, 0xC8, 0x00, 0xC1, 0x04,
+	0xC4, 0x05, 0xC3, 0x05, 0xC4, 0x03, 0xC2, 0x00, 0xC7, 0x02,
+	0xC5, 0x01, 0xD3, 0x07, 0xC1, 0x06, 0xC2, 0x05, 0xC2, 0x05,
+	0xC2, 0x05, 0xC2, 0x06, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07,
+	0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x03, 0x01, 0xC5,
+	0x02, 0xC7, 0x00, 0xC2, 0x03, 0xC4, 0x05, 0xC3, 0x05, 0xC4,
+	0x03, 0xC2, 0x00, 0xC7, 0x01, 0xC7, 0x00, 0xC2, 0x03, 0xC4,
+	0x05, 0xC3, 0x05, 0xC4, 0x03, 0xC2, 0x00, 0xC7, 0x02, 0xC5,
+	0x01, 0x01, 0xC5, 0x02, 0xC7, 0x00, 0xC2, 0x03, 0xC4, 0x05,
+	0xC3, 0x05, 0xC4, 0x03, 0xC2, 0x00, 0xC8, 0x01, 0xC7, 0x06,
+	0xC2, 0x05, 0xC2, 0x05, 0xC2, 0x05, 0xC2, 0x04, 0xC3, 0x05,
+	0xC2, 0x04, 0x17, 0xC1, 0x06, 0xC3, 0x05, 0xC3, 0x06, 0xC1,
+	0x1B, 0xC1, 0x06, 0xC3, 0x05, 0xC3, 0x06, 0xC1, 0x17, 0x17,
+	0xC1, 0x06, 0xC3, 0x05, 0xC3, 0x06, 0xC1, 0x1B, 0xC1, 0x06,
+	0xC3, 0x06, 0xC2, 0x07, 0xC1, 0x06, 0xC1, 0x06, 0xC1, 0x04,
+	0x06, 0xC1, 0x06, 0xC2, 0x05, 0xC2, 0x05, 0xC2, 0x05, 0xC2,
+	0x05, 0xC2, 0x05, 0xC2, 0x06, 0xC2, 0x07, 0xC2, 0x07, 0xC2,
+	0x07, 0xC2, 0x07, 0xC2, 0x07, 0xC2, 0x07, 0xC1, 0x00, 0x27,
+	0xD3, 0x13, 0xD3, 0x27, 0x00, 0xC1, 0x07, 0xC2, 0x07, 0xC2,
+	0x07, 0xC2, 0x07, 0xC2, 0x07, 0xC2, 0x07, 0xC2, 0x06, 0xC2,
+	0x05, 0xC2, 0x05, 0xC2, 0x05, 0xC2, 0x05, 0xC2, 0x05, 0xC2,
+	0x06, 0xC1, 0x06, 0x01, 0xC5, 0x02, 0xC7, 0x00, 0xC2, 0x03,
+	0xC4, 0x05, 0xC1, 0x07, 0xC1, 0x06, 0xC2, 0x04, 0xC3, 0x04,
+	0xC2, 0x06, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x11, 0xC1, 0x07,
+	0xC1, 0x03, 0x01, 0xC5, 0x02, 0xC7, 0x00, 0xC2, 0x03, 0xC4,
+	0x05, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x01, 0xC3, 0x01, 0xC1,
+	0x00, 0xC4, 0x01, 0xC4, 0x00, 0xC1, 0x01, 0xC3, 0x01, 0xC1,
+	0x01, 0xC3, 0x01, 0xC1, 0x01, 0xC4, 0x00, 0xC1, 0x00, 0xC2,
+	0x00, 0xC7, 0x02, 0xC5, 0x01, 0x01, 0xC5, 0x02, 0xC7, 0x00,
+	0xC2, 0x03, 0xC4, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05,
+	0xC3, 0x05, 0xD7, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05,
+	0xC1, 0xC7, 0x01, 0xC8, 0x00, 0xC1, 0x04, 0xC4, 0x05, 0xC3,
+	0x05, 0xC3, 0x04, 0xCB, 0x00, 0xC8, 0x00, 0xC1, 0x04, 0xC4,
+	0x05, 0xC3, 0x05, 0xC3, 0x04, 0xCB, 0x00, 0xC7, 0x01, 0x01,
+	0xC5, 0x02, 0xC7, 0x00, 0xC2, 0x03, 0xC4, 0x05, 0xC3, 0x07,
+	0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07,
+	0xC1, 0x05, 0xC4, 0x03, 0xC2, 0x00, 0xC7, 0x02, 0xC5, 0x01,
+	0xC7, 0x01, 0xC8, 0x00, 0xC1, 0x04, 0xC4, 0x05, 0xC3, 0x05,
+	0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05,
+	0xC3, 0x05, 0xC3, 0x04, 0xCB, 0x00, 0xC7, 0x01, 0xD5, 0x07,
+	0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC7, 0x01, 0xC7, 0x01,
+	0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xD3, 0xD5,
+	0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC7, 0x01, 0xC7,
+	0x01, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1,
+	0x07, 0xC1, 0x07, 0x01, 0xC5, 0x02, 0xC7, 0x00, 0xC2, 0x03,
+	0xC4, 0x05, 0xC3, 0x07, 0xC1, 0x07, 0xC1, 0x02, 0xC6, 0x02,
+	0xC6, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC4, 0x03, 0xC2, 0x00,
+	0xC7, 0x02, 0xC5, 0x01, 0xC1, 0x05, 0xC3, 0x05, 0xC3, 0x05,
+	0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xD7, 0x05, 0xC3, 0x05,
+	0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC1, 0x01,
+	0xC5, 0x03, 0xC5, 0x05, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07,
+	0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07,
+	0xC1, 0x07, 0xC1, 0x05, 0xC5, 0x03, 0xC5, 0x01, 0x01, 0xC7,
+	0x01, 0xC7, 0x05, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1,
+	0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x01, 0xC1,
+	0x03, 0xC1, 0x01, 0xC2, 0x01, 0xC2, 0x02, 0xC5, 0x04, 0xC3,
+	0x03, 0xC1, 0x05, 0xC3, 0x04, 0xC4, 0x03, 0xC2, 0x00, 0xC1,
+	0x02, 0xC2, 0x01, 0xC1, 0x01, 0xC2, 0x02, 0xC5, 0x03, 0xC4,
+	0x04, 0xC4, 0x04, 0xC5, 0x03, 0xC1, 0x01, 0xC2, 0x02, 0xC1,
+	0x02, 0xC2, 0x01, 0xC1, 0x03, 0xC2, 0x00, 0xC1, 0x04, 0xC4,
+	0x05, 0xC1, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07,
+	0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07,
+	0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xD3, 0xC1, 0x05, 0xC4,
+	0x03, 0xC6, 0x01, 0xCF, 0x00, 0xC3, 0x00, 0xC3, 0x01, 0xC1,
+	0x01, 0xC3, 0x01, 0xC1, 0x01, 0xC3, 0x01, 0xC1, 0x01, 0xC3,
+	0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3,
+	0x05, 0xC1, 0xC1, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC4, 0x04,
+	0xC5, 0x03, 0xC6, 0x02, 0xC3, 0x00, 0xC2, 0x01, 0xC3, 0x01,
+	0xC2, 0x00, 0xC3, 0x02, 0xC6, 0x03, 0xC5, 0x04, 0xC4, 0x05,
+	0xC3, 0x05, 0xC3, 0x05, 0xC1, 0x01, 0xC5, 0x02, 0xC7, 0x00,
+	0xC2, 0x03, 0xC4, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05,
+	0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC4, 0x03,
+	0xC2, 0x00, 0xC7, 0x02, 0xC5, 0x01, 0xC7, 0x01, 0xC8, 0x00,
+	0xC1, 0x04, 0xC4, 0x05, 0xC3, 0x05, 0xC3, 0x04, 0xCB, 0x00,
+	0xC7, 0x01, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07,
+	0xC1, 0x07, 0xC1, 0x07, 0x01, 0xC5, 0x02, 0xC7, 0x00, 0xC2,
+	0x03, 0xC4, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3,
+	0x05, 0xC3, 0x01, 0xC1, 0x01, 0xC3, 0x01, 0xC2, 0x00, 0xC3,
+	0x02, 0xC7, 0x02, 0xC2, 0x01, 0xC8, 0x01, 0xC4, 0x00, 0xC1,
+	0xC7, 0x01, 0xC8, 0x00, 0xC1, 0x04, 0xC4, 0x05, 0xC3, 0x05,
+	0xC3, 0x04, 0xCB, 0x00, 0xC7, 0x01, 0xC1, 0x00, 0xC3, 0x02,
+	0xC1, 0x02, 0xC2, 0x01, 0xC1, 0x04, 0xC1, 0x00, 0xC1, 0x04,
+	0xC4, 0x05, 0xC3, 0x05, 0xC1, 0x01, 0xC6, 0x01, 0xCB, 0x04,
+	0xC3, 0x07, 0xC1, 0x07, 0xC2, 0x07, 0xC6, 0x03, 0xC6, 0x07,
+	0xC2, 0x07, 0xC1, 0x07, 0xC3, 0x04, 0xCB, 0x01, 0xC6, 0x01,
+	0xD3, 0x03, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07,
+	0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07,
+	0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x03, 0xC1, 0x05, 0xC3, 0x05,
+	0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05,
+	0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC4, 0x03,
+	0xC2, 0x00, 0xC7, 0x02, 0xC5, 0x01, 0xC1, 0x05, 0xC3, 0x05,
+	0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05,
+	0xC3, 0x05, 0xC3, 0x05, 0xC4, 0x03, 0xC2, 0x00, 0xC2, 0x01,
+	0xC2, 0x02, 0xC5, 0x04, 0xC3, 0x06, 0xC1, 0x03, 0xC1, 0x05,
+	0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05,
+	0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x01, 0xC1, 0x01, 0xC3, 0x01,
+	0xC1, 0x01, 0xC3, 0x00, 0xC3, 0x00, 0xCB, 0x00, 0xC7, 0x02,
+	0xC1, 0x01, 0xC1, 0x01, 0xC1, 0x05, 0xC3, 0x05, 0xC3, 0x05,
+	0xC4, 0x03, 0xC2, 0x00, 0xC2, 0x01, 0xC2, 0x02, 0xC5, 0x04,
+	0xC3, 0x05, 0xC3, 0x04, 0xC5, 0x02, 0xC2, 0x01, 0xC2, 0x00,
+	0xC2, 0x03, 0xC4, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC1, 0xC1,
+	0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC4,
+	0x03, 0xC2, 0x00, 0xC2, 0x01, 0xC2, 0x02, 0xC5, 0x04, 0xC3,
+	0x06, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1,
+	0x03, 0xD3, 0x07, 0xC1, 0x06, 0xC2, 0x05, 0xC2, 0x05, 0xC2,
+	0x05, 0xC2, 0x05, 0xC2, 0x05, 0xC2, 0x05, 0xC2, 0x05, 0xC2,
+	0x06, 0xC1, 0x07, 0xD3, 0x01, 0xC4, 0x04, 0xC4, 0x04, 0xC1,
+	0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1,
+	0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC4,
+	0x04, 0xC4, 0x02, 0x13, 0xC1, 0x07, 0xC1, 0x09, 0xC1, 0x07,
+	0xC1, 0x09, 0xC1, 0x07, 0xC1, 0x09, 0xC1, 0x07, 0xC1, 0x09,
+	0xC1, 0x07, 0xC1, 0x13, 0x01, 0xC4, 0x04, 0xC4, 0x07, 0xC1,
+	0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1,
+	0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x04, 0xC4,
+	0x04, 0xC4, 0x02, 0x03, 0xC1, 0x06, 0xC3, 0x04, 0xC5, 0x02,
+	0xC2, 0x01, 0xC2, 0x00, 0xC2, 0x03, 0xC4, 0x05, 0xC1, 0x3F,
+	0x0F, 0x3F, 0x37, 0xD3, 0x01, 0xC1, 0x07, 0xC2, 0x07, 0xC2,
+	0x07, 0xC2, 0x07, 0xC1, 0x3F, 0x1C, 0x29, 0xC5, 0x02, 0xC7,
+	0x01, 0xC1, 0x03, 0xC2, 0x07, 0xC1, 0x01, 0xC7, 0x00, 0xCB,
+	0x04, 0xC4, 0x04, 0xC1, 0x00, 0xC8, 0x01, 0xC6, 0x00, 0xC1,
+	0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1,
+	0x07, 0xC7, 0x01, 0xC8, 0x00, 0xC1, 0x04, 0xC4, 0x05, 0xC3,
+	0x05, 0xC3, 0x04, 0xCB, 0x00, 0xC7, 0x01, 0x29, 0xC5, 0x02,
+	0xC7, 0x00, 0xC2, 0x03, 0xC4, 0x05, 0xC3, 0x07, 0xC1, 0x07,
+	0xC1, 0x05, 0xC4, 0x03, 0xC2, 0x00, 0xC7, 0x02, 0xC5, 0x01,
+	0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1,
+	0x07, 0xC1, 0x01, 0xC7, 0x00, 0xCB, 0x04, 0xC3, 0x05, 0xC3,
+	0x05, 0xC4, 0x04, 0xC1, 0x00, 0xC8, 0x01, 0xC7, 0x29, 0xC5,
+	0x02, 0xC7, 0x00, 0xC2, 0x03, 0xC4, 0x05, 0xD4, 0x00, 0xC1,
+	0x07, 0xC2, 0x03, 0xC2, 0x00, 0xC7, 0x02, 0xC5, 0x01, 0x03,
+	0xC1, 0x06, 0xC3, 0x04, 0xC5, 0x03, 0xC1, 0x01, 0xC1, 0x03,
+	0xC1, 0x07, 0xC1, 0x06, 0xC4, 0x04, 0xC4, 0x05, 0xC1, 0x07,
+	0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x05,
+	0x29, 0xC6, 0x01, 0xCB, 0x04, 0xC4, 0x04, 0xC1, 0x00, 0xC8,
+	0x01, 0xC7, 0x07, 0xC3, 0x04, 0xCB, 0x01, 0xC6, 0x01, 0xC1,
+	0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1,
+	0x07, 0xC6, 0x02, 0xC7, 0x01, 0xC1, 0x03, 0xC2, 0x00, 0xC1,
+	0x04, 0xC1, 0x00, 0xC1, 0x04, 0xC1, 0x00, 0xC1, 0x04, 0xC1,
+	0x00, 0xC1, 0x04, 0xC1, 0x00, 0xC1, 0x04, 0xC1, 0x00, 0x21,
+	0xC1, 0x07, 0xC1, 0x11, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07,
+	0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x03,
+	0x06, 0xC1, 0x07, 0xC1, 0x1B, 0xC1, 0x07, 0xC1, 0x07, 0xC1,
+	0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x01, 0xC1, 0x03, 0xC1,
+	0x01, 0xC2, 0x01, 0xC2, 0x02, 0xC5, 0x04, 0xC3, 0x02, 0x00,
+	0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x03,
+	0xC1, 0x01, 0xC1, 0x02, 0xC2, 0x01, 0xC1, 0x01, 0xC2, 0x02,
+	0xC1, 0x00, 0xC2, 0x03, 0xC4, 0x04, 0xC4, 0x04, 0xC5, 0x03,
+	0xC1, 0x01, 0xC2, 0x02, 0xC1, 0x02, 0xC2, 0x01, 0xC1, 0x03,
+	0xC1, 0x00, 0x01, 0xC3, 0x05, 0xC3, 0x07, 0xC1, 0x07, 0xC1,
+	0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1,
+	0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x05, 0xC5, 0x03, 0xC5,
+	0x01, 0x27, 0xC2, 0x03, 0xC6, 0x01, 0xCF, 0x00, 0xC3, 0x00,
+	0xC3, 0x01, 0xC1, 0x01, 0xC3, 0x01, 0xC1, 0x01, 0xC3, 0x05,
+	0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC1, 0x27, 0xC1, 0x01,
+	0xC3, 0x01, 0xC1, 0x00, 0xC5, 0x00, 0xC4, 0x01, 0xC6, 0x03,
+	0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05,
+	0xC3, 0x05, 0xC1, 0x29, 0xC5, 0x02, 0xC7, 0x00, 0xC2, 0x03,
+	0xC4, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC4, 0x03,
+	0xC2, 0x00, 0xC7, 0x02, 0xC5, 0x01, 0x27, 0xC7, 0x01, 0xC8,
+	0x00, 0xC1, 0x04, 0xC4, 0x04, 0xCB, 0x00, 0xC7, 0x01, 0xC1,
+	0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0x29, 0xC7, 0x00,
+	0xCB, 0x04, 0xC4, 0x04, 0xC1, 0x00, 0xC8, 0x01, 0xC7, 0x07,
+	0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x27, 0xC1, 0x01,
+	0xC3, 0x01, 0xC1, 0x00, 0xC5, 0x00, 0xC4, 0x01, 0xC6, 0x03,
+	0xC4, 0x06, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07,
+	0xC1, 0x07, 0x29, 0xC6, 0x01, 0xCB, 0x04, 0xC4, 0x07, 0xC6,
+	0x03, 0xC6, 0x07, 0xC4, 0x04, 0xCB, 0x01, 0xC6, 0x01, 0x02,
+	0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x05, 0xC7, 0x01,
+	0xC7, 0x03, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC1, 0x07,
+	0xC1, 0x01, 0xC1, 0x03, 0xC5, 0x04, 0xC3, 0x06, 0xC1, 0x02,
+	0x27, 0xC1, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3,
+	0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC4, 0x03, 0xC2, 0x00, 0xC7,
+	0x02, 0xC5, 0x01, 0x27, 0xC1, 0x05, 0xC3, 0x05, 0xC3, 0x05,
+	0xC3, 0x05, 0xC3, 0x05, 0xC4, 0x03, 0xC2, 0x00, 0xC2, 0x01,
+	0xC2, 0x02, 0xC5, 0x04, 0xC3, 0x06, 0xC1, 0x03, 0x27, 0xC1,
+	0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x05, 0xC3, 0x01, 0xC1,
+	0x01, 0xC3, 0x01, 0xC1, 0x01, 0xC3, 0x01, 0xC1, 0x01, 0xCB,
+	0x00, 0xC7, 0x02, 0xC1, 0x01, 0xC1, 0x01, 0x27, 0xC1, 0x05,
+	0xC4, 0x03, 0xC2, 0x00, 0xC2, 0x01, 0xC2, 0x02, 0xC5, 0x04,
+	0xC3, 0x05, 0xC3, 0x04, 0xC5, 0x02, 0xC2, 0x01, 0xC2, 0x00,
+	0xC2, 0x03, 0xC4, 0x05, 0xC1, 0x27, 0xC1, 0x05, 0xC4, 0x03,
+	0xC2, 0x00, 0xC2, 0x01, 0xC2, 0x02, 0xC5, 0x04, 0xC3, 0x06,
+	0xC1, 0x07, 0xC1, 0x06, 0xC2, 0x05, 0xC2, 0x06, 0xC1, 0x05,
+	0x27, 0xD3, 0x05, 0xC2, 0x05, 0xC2, 0x05, 0xC2, 0x05, 0xC2,
+	0x05, 0xC2, 0x05, 0xC2, 0x05, 0xD3, 0x04, 0xC3, 0x04, 0xC4,
+	0x03, 0xC2, 0x06, 0xC1, 0x07, 0xC1, 0x06, 0xC2, 0x05, 0xC2,
+	0x06, 0xC2, 0x07, 0xC2, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC2,
+	0x07, 0xC4, 0x05, 0xC3, 0x00, 0x03, 0xC3, 0x04, 0xC5, 0x02,
+	0xC2, 0x01, 0xC2, 0x01, 0xC1, 0x03, 0xC1, 0x01, 0xC1, 0x07,
+	0xC1, 0x05, 0xC5, 0x03, 0xC5, 0x05, 0xC1, 0x07, 0xC1, 0x07,
+	0xC1, 0x07, 0xC1, 0x05, 0xD3, 0x00, 0xC3, 0x05, 0xC4, 0x07,
+	0xC2, 0x07, 0xC1, 0x07, 0xC1, 0x07, 0xC2, 0x07, 0xC2, 0x06,
+	0xC2, 0x05, 0xC2, 0x06, 0xC1, 0x07, 0xC1, 0x06, 0xC2, 0x03,
+	0xC4, 0x04, 0xC3, 0x04, 0xD3, 0x3F, 0x37, 0xFF, 0xFF, 0xCB
+} ;
+
+/** Run-length encoded 10x14 font */
+const FontRLE gFont10x14RLE = { 10, 14, 0x20, 0x20 + 96 - 1, gwFont10x14RLEOffsets, gucFont10x14RLEData } ;
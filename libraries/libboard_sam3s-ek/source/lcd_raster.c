@@ -0,0 +1,301 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Span rasterizer for lines, rectangles and circles.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "board.h"
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Emit a horizontal run between two columns, in any order.
+ */
+static void _HRun( int32_t iX1, int32_t iX2, int32_t iY, LCDR_FillBoxFunc FillBox, void* pContext )
+{
+    if ( iX1 > iX2 )
+    {
+        FillBox( pContext, iX2, iY, iX1 - iX2 + 1, 1 ) ;
+    }
+    else
+    {
+        FillBox( pContext, iX1, iY, iX2 - iX1 + 1, 1 ) ;
+    }
+}
+
+/**
+ * \brief Emit a vertical run between two lines, in any order.
+ */
+static void _VRun( int32_t iX, int32_t iY1, int32_t iY2, LCDR_FillBoxFunc FillBox, void* pContext )
+{
+    if ( iY1 > iY2 )
+    {
+        FillBox( pContext, iX, iY2, 1, iY1 - iY2 + 1 ) ;
+    }
+    else
+    {
+        FillBox( pContext, iX, iY1, 1, iY2 - iY1 + 1 ) ;
+    }
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Rasterize a line. Axis-aligned lines are a single run, other lines
+ * are split by Bresenham algorithm into runs along their major axis.
+ *
+ * \param iX1  X-coordinate of line start.
+ * \param iY1  Y-coordinate of line start.
+ * \param iX2  X-coordinate of line end.
+ * \param iY2  Y-coordinate of line end.
+ * \param FillBox   Box filler.
+ * \param pContext  Box filler context.
+ */
+extern void LCDR_Line( int32_t iX1, int32_t iY1, int32_t iX2, int32_t iY2, LCDR_FillBoxFunc FillBox, void* pContext )
+{
+    int32_t dx, dy ;
+    int32_t xinc, yinc, cumul ;
+    int32_t i, start ;
+
+    if ( iY1 == iY2 )
+    {
+        _HRun( iX1, iX2, iY1, FillBox, pContext ) ;
+        return ;
+    }
+
+    if ( iX1 == iX2 )
+    {
+        _VRun( iX1, iY1, iY2, FillBox, pContext ) ;
+        return ;
+    }
+
+    dx = iX2 - iX1 ;
+    dy = iY2 - iY1 ;
+
+    xinc = ( dx > 0 ) ? 1 : -1 ;
+    yinc = ( dy > 0 ) ? 1 : -1 ;
+    dx = ( dx > 0 ) ? dx : -dx ;
+    dy = ( dy > 0 ) ? dy : -dy ;
+
+    if ( dx > dy )
+    {
+        cumul = dx / 2 ;
+        start = iX1 ;
+        for ( i = 1 ; i <= dx ; i++ )
+        {
+            iX1 += xinc ;
+            cumul += dy ;
+
+            if ( cumul >= dx )
+            {
+                /* Line changes, flush the run up to the previous pixel */
+                cumul -= dx ;
+                _HRun( start, iX1 - xinc, iY1, FillBox, pContext ) ;
+                iY1 += yinc ;
+                start = iX1 ;
+            }
+        }
+        _HRun( start, iX1, iY1, FillBox, pContext ) ;
+    }
+    else
+    {
+        cumul = dy / 2 ;
+        start = iY1 ;
+        for ( i = 1 ; i <= dy ; i++ )
+        {
+            iY1 += yinc ;
+            cumul += dx ;
+
+            if ( cumul >= dy )
+            {
+                /* Column changes, flush the run up to the previous pixel */
+                cumul -= dy ;
+                _VRun( iX1, start, iY1 - yinc, FillBox, pContext ) ;
+                iX1 += xinc ;
+                start = iY1 ;
+            }
+        }
+        _VRun( iX1, start, iY1, FillBox, pContext ) ;
+    }
+}
+
+/**
+ * \brief Rasterize a rectangle frame as four runs.
+ *
+ * \param iX1  X-coordinate of a corner.
+ * \param iY1  Y-coordinate of a corner.
+ * \param iX2  X-coordinate of the opposite corner.
+ * \param iY2  Y-coordinate of the opposite corner.
+ * \param FillBox   Box filler.
+ * \param pContext  Box filler context.
+ */
+extern void LCDR_Rectangle( int32_t iX1, int32_t iY1, int32_t iX2, int32_t iY2, LCDR_FillBoxFunc FillBox, void* pContext )
+{
+    _HRun( iX1, iX2, iY1, FillBox, pContext ) ;
+    _HRun( iX1, iX2, iY2, FillBox, pContext ) ;
+    _VRun( iX1, iY1, iY2, FillBox, pContext ) ;
+    _VRun( iX2, iY1, iY2, FillBox, pContext ) ;
+}
+
+/**
+ * \brief Rasterize a circle outline. Midpoint algorithm, consecutive points
+ * of an octant sharing the same line (or column) are merged into one run.
+ *
+ * \param iX  X-coordinate of circle center.
+ * \param iY  Y-coordinate of circle center.
+ * \param dwRadius  Circle radius.
+ * \param FillBox   Box filler.
+ * \param pContext  Box filler context.
+ */
+extern void LCDR_Circle( int32_t iX, int32_t iY, uint32_t dwRadius, LCDR_FillBoxFunc FillBox, void* pContext )
+{
+    int32_t d ;     /* Decision Variable */
+    int32_t cx ;    /* Current X Value */
+    int32_t cy ;    /* Current Y Value */
+    int32_t start ; /* First X Value of the current run */
+    uint32_t step ;
+
+    d = 3 - ((int32_t)dwRadius << 1) ;
+    cx = 0 ;
+    cy = dwRadius ;
+    start = 0 ;
+
+    while ( cx <= cy )
+    {
+        if ( d < 0 )
+        {
+            d += (cx << 2) + 6 ;
+            step = 0 ;
+        }
+        else
+        {
+            d += ((cx - cy) << 2) + 10 ;
+            step = 1 ;
+        }
+
+        /* Flush the runs [start..cx] before cy changes or on the last point */
+        if ( step || (cx + 1 > cy) )
+        {
+            if ( start == 0 )
+            {
+                _HRun( iX - cx, iX + cx, iY + cy, FillBox, pContext ) ;
+                _HRun( iX - cx, iX + cx, iY - cy, FillBox, pContext ) ;
+                _VRun( iX + cy, iY - cx, iY + cx, FillBox, pContext ) ;
+                _VRun( iX - cy, iY - cx, iY + cx, FillBox, pContext ) ;
+            }
+            else
+            {
+                _HRun( iX + start, iX + cx, iY + cy, FillBox, pContext ) ;
+                _HRun( iX - start, iX - cx, iY + cy, FillBox, pContext ) ;
+                _HRun( iX + start, iX + cx, iY - cy, FillBox, pContext ) ;
+                _HRun( iX - start, iX - cx, iY - cy, FillBox, pContext ) ;
+                _VRun( iX + cy, iY + start, iY + cx, FillBox, pContext ) ;
+                _VRun( iX + cy, iY - start, iY - cx, FillBox, pContext ) ;
+                _VRun( iX - cy, iY + start, iY + cx, FillBox, pContext ) ;
+                _VRun( iX - cy, iY - start, iY - cx, FillBox, pContext ) ;
+            }
+            start = cx + 1 ;
+        }
+
+        if ( step )
+        {
+            cy-- ;
+        }
+        cx++ ;
+    }
+}
+
+/**
+ * \brief Rasterize a filled circle as one horizontal run per line.
+ *
+ * \param iX  X-coordinate of circle center.
+ * \param iY  Y-coordinate of circle center.
+ * \param dwRadius  Circle radius.
+ * \param FillBox   Box filler.
+ * \param pContext  Box filler context.
+ */
+extern void LCDR_FilledCircle( int32_t iX, int32_t iY, uint32_t dwRadius, LCDR_FillBoxFunc FillBox, void* pContext )
+{
+    int32_t d ;     /* Decision Variable */
+    int32_t cx ;    /* Current X Value */
+    int32_t cy ;    /* Current Y Value */
+    uint32_t step ;
+
+    d = 3 - ((int32_t)dwRadius << 1) ;
+    cx = 0 ;
+    cy = dwRadius ;
+
+    while ( cx <= cy )
+    {
+        /* Lines iY +/- cx, each met once */
+        _HRun( iX - cy, iX + cy, iY + cx, FillBox, pContext ) ;
+        if ( cx != 0 )
+        {
+            _HRun( iX - cy, iX + cy, iY - cx, FillBox, pContext ) ;
+        }
+
+        if ( d < 0 )
+        {
+            d += (cx << 2) + 6 ;
+            step = 0 ;
+        }
+        else
+        {
+            d += ((cx - cy) << 2) + 10 ;
+            step = 1 ;
+        }
+
+        /* Lines iY +/- cy, at their widest point only */
+        if ( (step || (cx + 1 > cy)) && (cy != cx) )
+        {
+            _HRun( iX - cx, iX + cx, iY + cy, FillBox, pContext ) ;
+            _HRun( iX - cx, iX + cx, iY - cy, FillBox, pContext ) ;
+        }
+
+        if ( step )
+        {
+            cy-- ;
+        }
+        cx++ ;
+    }
+}
@@ -43,14 +43,13 @@
 #include <stdint.h>
 
 /*----------------------------------------------------------------------------
- *        Exported functions
+ *        Local functions
  *----------------------------------------------------------------------------*/
 
 /**
- * \brief Initializes the LCD controller.
- * Configure SMC to access LCD controller at 64MHz MCK.
+ * \brief Configure SMC to access LCD controller at 64MHz MCK.
  */
-extern void LCDD_Initialize( void )
+static void _LCDD_ConfigureSmc( void )
 {
     const Pin pPins[] = {BOARD_LCD_PINS};
     Smc *pSmc = SMC;
@@ -78,6 +77,19 @@ extern void LCDD_Initialize( void )
     pSmc->SMC_CS_NUMBER[1].SMC_MODE = SMC_MODE_READ_MODE
                                     | SMC_MODE_WRITE_MODE
                                     | SMC_MODE_DBW_8_BIT;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initializes the LCD controller.
+ * Configure SMC to access LCD controller at 64MHz MCK.
+ */
+extern void LCDD_Initialize( void )
+{
+    _LCDD_ConfigureSmc() ;
 
     /* Initialize LCD controller */
     LCD_Initialize() ;
@@ -89,6 +101,43 @@ extern void LCDD_Initialize( void )
     LCDD_SetBacklight( 2 ) ;
 }
 
+/**
+ * \brief Runs the next step of the LCD initialization, as a boot sequencer
+ * task (see bootseq.h). The steps do the same as LCDD_Initialize(), the
+ * controller power ramp delays being left to the other tasks.
+ * \param pArg      Not used.
+ * \param pdwState  Initialization progress, 0 at start.
+ * \return Delay in ms before the next step, BOOTSEQ_DONE or BOOTSEQ_FAILED.
+ */
+extern uint32_t LCDD_InitializeStep( void* pArg, uint32_t* pdwState )
+{
+    uint32_t dwLcdState ;
+    uint32_t dwDelay ;
+
+    if ( *pdwState == 0 )
+    {
+        _LCDD_ConfigureSmc() ;
+        *pdwState = 1 ;
+
+        return 0 ;
+    }
+
+    /* States from 1 on are the controller states */
+    dwLcdState = *pdwState - 1 ;
+    dwDelay = LCD_InitializeStep( &dwLcdState ) ;
+    *pdwState = dwLcdState + 1 ;
+
+    if ( dwDelay != BOOTSEQ_DONE )
+    {
+        return dwDelay ;
+    }
+
+    LCD_SetDisplayPortrait( 0 ) ;
+    LCDD_SetBacklight( 2 ) ;
+
+    return BOOTSEQ_DONE ;
+}
+
 /**
  * \brief Turn on the LCD.
  */
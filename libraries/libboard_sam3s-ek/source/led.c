@@ -46,6 +46,10 @@ static const Pin pinsLeds[] = { PINS_LEDS } ;
 static const uint32_t numLeds = PIO_LISTSIZE( pinsLeds ) ;
 #endif
 
+#ifdef PINGROUP_LEDS
+static const PinGroup groupLeds = PINGROUP_LEDS ;
+#endif
+
 /*------------------------------------------------------------------------------
  *         Global Functions
  *------------------------------------------------------------------------------*/
@@ -166,3 +170,37 @@ extern uint32_t LED_Toggle( uint32_t dwLed )
 #endif
 }
 
+/**
+ *  Turns on the LEDs whose bits are 1 and turns off the others: with
+ *  PINGROUP_LEDS, by two PIO stores whatever the number of LEDs.
+ *
+ *  \param dwLeds  Bit n gives the state of the LED number n.
+ *  \return 1 if the LEDs have been written; 0 if there is no LED.
+ */
+extern uint32_t LED_Write( uint32_t dwLeds )
+{
+#if defined( PINGROUP_LEDS )
+    PIO_GroupClear( &groupLeds, dwLeds ) ;
+    PIO_GroupSet( &groupLeds, ~dwLeds ) ;
+
+    return 1 ;
+#elif defined( PINS_LEDS )
+    uint32_t dwLed ;
+
+    for ( dwLed=0 ; dwLed < numLeds ; dwLed++ )
+    {
+        if ( dwLeds & (1 << dwLed) )
+        {
+            LED_Set( dwLed ) ;
+        }
+        else
+        {
+            LED_Clear( dwLed ) ;
+        }
+    }
+
+    return 1 ;
+#else
+    return 0 ;
+#endif
+}
@@ -0,0 +1,403 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Fixed-point audio mixer.
+ *
+ * Each pass reads one block of every stream into a scratch buffer, scales
+ * it by the stream gain and accumulates it in the output with a saturating
+ * add, so the mix never wraps around when loud streams overlap. Streams
+ * are added and removed from the task while the sink's interrupt mixes:
+ * a stream is published by writing its source last.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "board.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Saturates a value to a signed 16-bit sample.
+ */
+static inline int32_t _Sat16( int32_t lValue )
+{
+#if defined( __GNUC__ ) && defined( __thumb2__ )
+    int32_t lResult ;
+
+    __asm ( "ssat %0, #16, %1" : "=r" (lResult) : "r" (lValue) ) ;
+
+    return lResult ;
+#else
+    if ( lValue > 32767 )
+    {
+        return 32767 ;
+    }
+    if ( lValue < -32768 )
+    {
+        return -32768 ;
+    }
+
+    return lValue ;
+#endif
+}
+
+/**
+ * \brief Writes dwSamples samples scaled by a Q15 gain to the output.
+ * \return Number of samples clipped.
+ */
+static uint32_t _MIXER_Scale( int16_t* psOut, const int16_t* psIn, uint32_t dwSamples, int32_t lGain )
+{
+    uint32_t dwClipped = 0 ;
+    int32_t lValue ;
+    int32_t lSat ;
+
+    if ( lGain == MIXER_GAIN_UNITY )
+    {
+        memcpy( psOut, psIn, dwSamples * sizeof( int16_t ) ) ;
+
+        return 0 ;
+    }
+
+    while ( dwSamples-- )
+    {
+        lValue = (*psIn++ * lGain) >> 15 ;
+        lSat = _Sat16( lValue ) ;
+        dwClipped += (lSat != lValue) ;
+        *psOut++ = lSat ;
+    }
+
+    return dwClipped ;
+}
+
+/**
+ * \brief Adds dwSamples samples scaled by a Q15 gain to the output, with
+ * saturation.
+ * \return Number of samples clipped.
+ */
+static uint32_t _MIXER_Accumulate( int16_t* psOut, const int16_t* psIn, uint32_t dwSamples, int32_t lGain )
+{
+    uint32_t dwClipped = 0 ;
+    int32_t lValue ;
+    int32_t lSat ;
+
+    /* Stereo frames: two samples per iteration */
+    for ( ; dwSamples >= 2 ; dwSamples -= 2 )
+    {
+        lValue = psOut[0] + ((psIn[0] * lGain) >> 15) ;
+        lSat = _Sat16( lValue ) ;
+        dwClipped += (lSat != lValue) ;
+        psOut[0] = lSat ;
+
+        lValue = psOut[1] + ((psIn[1] * lGain) >> 15) ;
+        lSat = _Sat16( lValue ) ;
+        dwClipped += (lSat != lValue) ;
+        psOut[1] = lSat ;
+
+        psOut += 2 ;
+        psIn += 2 ;
+    }
+    if ( dwSamples )
+    {
+        lValue = psOut[0] + ((psIn[0] * lGain) >> 15) ;
+        lSat = _Sat16( lValue ) ;
+        dwClipped += (lSat != lValue) ;
+        psOut[0] = lSat ;
+    }
+
+    return dwClipped ;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initializes a mixer without streams.
+ *
+ * \param pMixer  Mixer to initialize.
+ * \param psScratch  Scratch buffer of dwBlock stereo frames.
+ * \param psMix  Buffer of dwBlock stereo frames, used by MIXER_DaccFill()
+ *               only (0 otherwise).
+ * \param dwBlock  Frames mixed per pass: the size of the PDC buffers of the
+ *                 sink gives one pass per buffer.
+ */
+extern void MIXER_Initialize( Mixer* pMixer, int16_t* psScratch, int16_t* psMix, uint32_t dwBlock )
+{
+    memset( pMixer, 0, sizeof( Mixer ) ) ;
+    pMixer->psScratch = psScratch ;
+    pMixer->psMix = psMix ;
+    pMixer->dwBlock = dwBlock ;
+}
+
+/**
+ * \brief Adds a stream to the mix.
+ *
+ * \param pMixer  Mixer.
+ * \param read  Source of the stream.
+ * \param pArgument  Argument of the source.
+ * \param wGain  Gain in Q15, MIXER_GAIN_UNITY for unity.
+ * \param bFlags  MIXER_ONESHOT to release the stream when its source is
+ *                exhausted (click sounds held in memory), 0 to keep it.
+ * \return Index of the stream, -1 if all streams are in use.
+ */
+extern int32_t MIXER_Add( Mixer* pMixer, MixerReadFunc read, void* pArgument, uint16_t wGain, uint8_t bFlags )
+{
+    MixerStream* pStream ;
+    int32_t i ;
+
+    for ( i = 0 ; i < MIXER_MAX_STREAMS ; i++ )
+    {
+        pStream = &pMixer->streams[i] ;
+        if ( pStream->read == 0 )
+        {
+            pStream->pArgument = pArgument ;
+            pStream->wGain = wGain ;
+            pStream->bFlags = bFlags ;
+            pStream->dwFrames = 0 ;
+            /* The stream is set up before the interrupt can see it */
+            __DMB() ;
+            pStream->read = read ;
+
+            return i ;
+        }
+    }
+
+    return -1 ;
+}
+
+/**
+ * \brief Removes a stream from the mix; its source is not called after the
+ * mixing pass in progress, if any.
+ */
+extern void MIXER_Remove( Mixer* pMixer, int32_t iStream )
+{
+    pMixer->streams[iStream].read = 0 ;
+}
+
+/**
+ * \brief Changes the gain of a stream, in Q15.
+ */
+extern void MIXER_SetGain( Mixer* pMixer, int32_t iStream, uint16_t wGain )
+{
+    pMixer->streams[iStream].wGain = wGain ;
+}
+
+/**
+ * \brief Returns 1 while a stream is mixed, 0 once removed or, for a
+ * MIXER_ONESHOT stream, played out.
+ */
+extern uint32_t MIXER_IsActive( Mixer* pMixer, int32_t iStream )
+{
+    return pMixer->streams[iStream].read != 0 ;
+}
+
+/**
+ * \brief Mixes dwFrames stereo frames of all streams into a buffer.
+ *
+ * Streams returning fewer frames than asked are completed with silence.
+ *
+ * \param pMixer  Mixer.
+ * \param psOut  Output, interleaved stereo Q15.
+ * \param dwFrames  Number of frames.
+ */
+extern void MIXER_Process( Mixer* pMixer, int16_t* psOut, uint32_t dwFrames )
+{
+    MixerStream* pStream ;
+    MixerReadFunc read ;
+    uint32_t dwCount ;
+    uint32_t dwGot ;
+    uint32_t dwClipped = 0 ;
+    uint32_t dwFirst ;
+    uint32_t i ;
+
+    while ( dwFrames )
+    {
+        dwCount = (dwFrames < pMixer->dwBlock) ? dwFrames : pMixer->dwBlock ;
+        dwFirst = 1 ;
+
+        for ( i = 0 ; i < MIXER_MAX_STREAMS ; i++ )
+        {
+            pStream = &pMixer->streams[i] ;
+            read = pStream->read ;
+            if ( read == 0 )
+            {
+                continue ;
+            }
+
+            dwGot = read( pStream->pArgument, pMixer->psScratch, dwCount ) ;
+            if ( (dwGot == 0) && (pStream->bFlags & MIXER_ONESHOT) )
+            {
+                pStream->read = 0 ;
+                continue ;
+            }
+            pStream->dwFrames += dwGot ;
+
+            if ( dwFirst )
+            {
+                /* First stream: no accumulation, silence after its end */
+                dwClipped += _MIXER_Scale( psOut, pMixer->psScratch, dwGot * 2, pStream->wGain ) ;
+                memset( psOut + dwGot * 2, 0, (dwCount - dwGot) * 2 * sizeof( int16_t ) ) ;
+                dwFirst = 0 ;
+            }
+            else
+            {
+                dwClipped += _MIXER_Accumulate( psOut, pMixer->psScratch, dwGot * 2, pStream->wGain ) ;
+            }
+        }
+
+        if ( dwFirst )
+        {
+            memset( psOut, 0, dwCount * 2 * sizeof( int16_t ) ) ;
+        }
+
+        psOut += dwCount * 2 ;
+        dwFrames -= dwCount ;
+    }
+
+    pMixer->dwClipped += dwClipped ;
+}
+
+/**
+ * \brief Mixes into every free transmit buffer of a SSC stream configured
+ * for 16-bit words (WM8731 in 16-bit I2S). Call it from the SSC interrupt
+ * after SSC_StreamHandler(), and once to prime the stream.
+ *
+ * \return Number of frames queued.
+ */
+extern uint32_t MIXER_SscFill( Mixer* pMixer, SscStream* pStream )
+{
+    uint32_t dwFrames = pStream->tx.dwBufferSize / 4 ;
+    uint32_t dwTotal = 0 ;
+    uint8_t* pBuffer ;
+
+    while ( (pBuffer = SSC_StreamGetTxBuffer( pStream )) != 0 )
+    {
+        MIXER_Process( pMixer, (int16_t*)pBuffer, dwFrames ) ;
+        SSC_StreamCommitTx( pStream, dwFrames * 4 ) ;
+        dwTotal += dwFrames ;
+    }
+
+    return dwTotal ;
+}
+
+/**
+ * \brief DaccStreamFill function, pArgument being the Mixer: the mix is
+ * brought down to 12-bit unsigned mono. The mixer needs its psMix buffer.
+ */
+extern void MIXER_DaccFill( void* pArgument, uint16_t* pwBank, uint32_t dwSize )
+{
+    Mixer* pMixer = (Mixer*)pArgument ;
+    const int16_t* psMix ;
+    uint32_t dwCount ;
+
+    while ( dwSize )
+    {
+        dwCount = (dwSize < pMixer->dwBlock) ? dwSize : pMixer->dwBlock ;
+        MIXER_Process( pMixer, pMixer->psMix, dwCount ) ;
+
+        dwSize -= dwCount ;
+        psMix = pMixer->psMix ;
+        while ( dwCount-- )
+        {
+            /* (l + r) / 2 + 0x8000, to 12 bits */
+            *pwBank++ = (uint32_t)(psMix[0] + psMix[1] + 0x10000) >> 5 ;
+            psMix += 2 ;
+        }
+    }
+}
+
+/**
+ * \brief MixerReadFunc of a MixerRingSource: takes the stereo 16-bit frames
+ * the USB audio OUT endpoint committed to the ring. The ring size must be a
+ * multiple of 4 and the producer commit whole frames.
+ */
+extern uint32_t MIXER_RingRead( void* pArgument, int16_t* psFrames, uint32_t dwFrames )
+{
+    MixerRingSource* pSource = (MixerRingSource*)pArgument ;
+    uint32_t dwDone = 0 ;
+    uint32_t dwCount ;
+    uint8_t* pData ;
+
+    while ( (dwDone < dwFrames) && ((dwCount = RING_Peek( pSource->pRing, &pData ) / 4) != 0) )
+    {
+        if ( dwCount > dwFrames - dwDone )
+        {
+            dwCount = dwFrames - dwDone ;
+        }
+        memcpy( psFrames + dwDone * 2, pData, dwCount * 4 ) ;
+        RING_Consume( pSource->pRing, dwCount * 4 ) ;
+        dwDone += dwCount ;
+    }
+
+    if ( (dwDone != 0) && (dwDone < dwFrames) )
+    {
+        pSource->dwShort++ ;
+    }
+
+    return dwDone ;
+}
+
+/**
+ * \brief MixerReadFunc of a tone generator, pArgument being a DaccDds: the
+ * same waveform on both channels, the offset of the DDS being ignored.
+ */
+extern uint32_t MIXER_DdsRead( void* pArgument, int16_t* psFrames, uint32_t dwFrames )
+{
+    DaccDds* pDds = (DaccDds*)pArgument ;
+    const int16_t* pwTable = pDds->pwTable ;
+    uint32_t dwShift = 32 - pDds->bTableBits ;
+    uint32_t dwPhase = pDds->dwPhase ;
+    uint32_t dwIncrement = pDds->dwIncrement ;
+    int32_t lGain = pDds->lGain ;
+    uint32_t dwCount = dwFrames ;
+    int32_t lSample ;
+
+    while ( dwCount-- )
+    {
+        lSample = _Sat16( (pwTable[dwPhase >> dwShift] * lGain) >> 15 ) ;
+        psFrames[0] = lSample ;
+        psFrames[1] = lSample ;
+        psFrames += 2 ;
+        dwPhase += dwIncrement ;
+    }
+    pDds->dwPhase = dwPhase ;
+
+    return dwFrames ;
+}
@@ -45,6 +45,14 @@
 #include <stdarg.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <errno.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Bytes kept free under the main stack when the heap grows towards it */
+#define SBRK_STACK_MARGIN   256
 
 /*----------------------------------------------------------------------------
  *        Exported variables
@@ -61,15 +69,37 @@ extern void _exit( int status ) ;
 extern void _kill( int pid, int sig ) ;
 extern int _getpid ( void ) ;
 
+/**
+ * \brief Grows the SRAM heap of malloc(), from _end up to the end of the SRAM,
+ * or up to SBRK_STACK_MARGIN bytes under the main stack if the stack is above
+ * the heap. The external PSRAM is given by HEAP_Alloc().
+ */
 extern caddr_t _sbrk ( int incr )
 {
     static unsigned char *heap = NULL ;
     unsigned char *prev_heap ;
+    unsigned char *limit ;
+    unsigned char *sp ;
 
     if ( heap == NULL )
     {
         heap = (unsigned char *)&_end ;
     }
+
+    limit = (unsigned char *)(IRAM_ADDR + IRAM_SIZE) ;
+    sp = (unsigned char *)__get_MSP() ;
+    if ( (sp > heap) && (sp - SBRK_STACK_MARGIN < limit) )
+    {
+        limit = sp - SBRK_STACK_MARGIN ;
+    }
+
+    /* Collision with the stack or the end of the SRAM */
+    if ( (incr > 0) && ((heap >= limit) || (incr > limit - heap)) )
+    {
+        errno = ENOMEM ;
+        return (caddr_t) -1 ;
+    }
+
     prev_heap = heap;
 
     heap += incr ;
@@ -111,16 +141,10 @@ extern int _read(int file, char *ptr, int len)
 
 extern int _write( int file, char *ptr, int len )
 {
-    int iIndex ;
-    
-    
-//    for ( ; *ptr != 0 ; ptr++ )
-    for ( iIndex=0 ; iIndex < len ; iIndex++, ptr++ )
-    {
-        UART_PutChar( *ptr ) ;
-    }
+    /* Through the transmit ring once UART_EnableTxBuffer() is called */
+    UART_Write( (const uint8_t*)ptr, (uint32_t)len ) ;
 
-    return iIndex ;
+    return len ;
 }
 
 extern void _exit( int status )
@@ -0,0 +1,352 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ *  \file
+ *  Implement the microsecond timebase and the software timers.
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include "board.h"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Prescaler channel, TC3: 1 MHz on TIOA3. */
+#define TIMEBASE_PRESCALER      (TC1->TC_CHANNEL[0])
+/** Counter channel, TC4, clocked by TIOA3 through XC1. */
+#define TIMEBASE_COUNTER        (TC1->TC_CHANNEL[1])
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Time of the last TC4 overflow, in us. */
+static uint64_t _qwTimeHigh = 0 ;
+
+/** Running timers, sorted by expiry time. */
+static TimeBaseTimer* _pTimers = 0 ;
+
+/** TC4 status bits read by _TimeBase_Now() since the last interrupt. */
+static uint32_t _dwStatus = 0 ;
+
+/** Clock change notifier, registered by the first TimeBase_Configure(). */
+static ClockNotifier _clockNotifier ;
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ *  \brief Reads the time, with the interrupts masked. The overflow reported
+ *  by the status register is accounted for here as in the interrupt, as
+ *  reading the status clears it; the status bits are kept in _dwStatus.
+ */
+static uint64_t _TimeBase_Now( void )
+{
+    uint32_t dwSr ;
+    uint32_t dwCv ;
+
+    dwSr = TIMEBASE_COUNTER.TC_SR ;
+    _dwStatus |= dwSr ;
+    if ( dwSr & TC_SR_COVFS )
+    {
+        _qwTimeHigh += 0x10000 ;
+    }
+    dwCv = TIMEBASE_COUNTER.TC_CV ;
+
+    /* Overflow between the two reads */
+    dwSr = TIMEBASE_COUNTER.TC_SR ;
+    _dwStatus |= dwSr ;
+    if ( dwSr & TC_SR_COVFS )
+    {
+        _qwTimeHigh += 0x10000 ;
+        dwCv = TIMEBASE_COUNTER.TC_CV ;
+    }
+
+    return _qwTimeHigh + (dwCv & 0xFFFF) ;
+}
+
+/**
+ *  \brief Sets the TC3 period for a new MCK and restarts TC3, so that TC4
+ *  keeps counting microseconds; less than 1 us is lost.
+ */
+static void _TimeBase_ClockChange( uint32_t dwEvent, uint32_t dwOldMck, uint32_t dwNewMck, void* pArg )
+{
+    uint32_t primask = __get_PRIMASK() ;
+
+    if ( (dwEvent != CLOCK_NOTIFY_POST_CHANGE) || ((dwNewMck % 4000000) != 0) )
+    {
+        return ;
+    }
+
+    __disable_irq() ;
+    TIMEBASE_PRESCALER.TC_RC = dwNewMck / 4000000 ;
+    TIMEBASE_PRESCALER.TC_CCR = TC_CCR_CLKEN | TC_CCR_SWTRG ;
+    __set_PRIMASK( primask ) ;
+}
+
+/*----------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ *  \brief TC4 interrupt: counter overflow and timer expiry. Calls the expired
+ *  timers, with the interrupts enabled, then sets the RC compare to the next
+ *  expiry if it falls before the next overflow.
+ */
+extern void TC4_IrqHandler( void )
+{
+    TimeBaseTimer* pTimer ;
+    TimeBaseCallback fCallback ;
+    void* pArg ;
+    uint32_t primask = __get_PRIMASK() ;
+
+    /* The events from now on pend the interrupt again */
+    NVIC_ClearPendingIRQ( TC4_IRQn ) ;
+
+    __disable_irq() ;
+    while ( 1 )
+    {
+        /* Expired timers */
+        if ( _pTimers && (_pTimers->qwExpiry <= _TimeBase_Now()) )
+        {
+            pTimer = _pTimers ;
+            _pTimers = pTimer->pNext ;
+            pTimer->ucRunning = 0 ;
+            fCallback = pTimer->fCallback ;
+            pArg = pTimer->pArg ;
+
+            /* The callback may restart the timer */
+            if ( fCallback )
+            {
+                __set_PRIMASK( primask ) ;
+                fCallback( pArg ) ;
+                __disable_irq() ;
+            }
+            continue ;
+        }
+
+        if ( !_pTimers || ((_pTimers->qwExpiry & ~0xFFFFull) != _qwTimeHigh) )
+        {
+            /* Nothing to expire before the overflow interrupt */
+            TIMEBASE_COUNTER.TC_IDR = TC_IDR_CPCS ;
+            break ;
+        }
+
+        TIMEBASE_COUNTER.TC_RC = (uint32_t)_pTimers->qwExpiry & 0xFFFF ;
+        TIMEBASE_COUNTER.TC_IER = TC_IER_CPCS ;
+
+        /* The compare value may have been passed while it was set */
+        if ( _TimeBase_Now() < _pTimers->qwExpiry )
+        {
+            break ;
+        }
+    }
+    _dwStatus = 0 ;
+    __set_PRIMASK( primask ) ;
+}
+
+/**
+ *  \brief Configures TC3 and TC4 as the microsecond timebase and starts it
+ *  from 0. The running timers are dropped.
+ *
+ *  \param dwMck  Current master clock, a multiple of 4 MHz.
+ *  \return 0 if successful; 1 if MCK is not a multiple of 4 MHz.
+ */
+extern uint32_t TimeBase_Configure( uint32_t dwMck )
+{
+    if ( (dwMck < 4000000) || ((dwMck % 4000000) != 0) )
+    {
+        return 1 ;
+    }
+
+    NVIC_DisableIRQ( TC4_IRQn ) ;
+    PMC_EnablePeripheral( ID_TC3 ) ;
+    PMC_EnablePeripheral( ID_TC4 ) ;
+
+    /* TC3: MCK/2, toggling TIOA3 every dwMck/4 MHz periods gives 1 MHz */
+    TC_Configure( TC1, 0, TC_CMR_TCCLKS_TIMER_CLOCK1 | TC_CMR_WAVE | TC_CMR_WAVSEL_UP_RC | TC_CMR_ACPC_TOGGLE ) ;
+    TIMEBASE_PRESCALER.TC_RC = dwMck / 4000000 ;
+
+    /* TC4: counts the TIOA3 periods */
+    TC1->TC_BMR = (TC1->TC_BMR & ~TC_BMR_TC1XC1S_Msk) | TC_BMR_TC1XC1S_TIOA0 ;
+    TC_Configure( TC1, 1, TC_CMR_TCCLKS_XC1 ) ;
+    TIMEBASE_COUNTER.TC_IER = TC_IER_COVFS ;
+
+    _qwTimeHigh = 0 ;
+    _pTimers = 0 ;
+
+    TC_Start( TC1, 1 ) ;
+    TC_Start( TC1, 0 ) ;
+
+    NVIC_ClearPendingIRQ( TC4_IRQn ) ;
+    NVIC_EnableIRQ( TC4_IRQn ) ;
+
+    /* Follow the MCK changes made by CLOCK_SetConfig() */
+    if ( _clockNotifier.fCallback == 0 )
+    {
+        _clockNotifier.fCallback = _TimeBase_ClockChange ;
+        CLOCK_RegisterNotifier( &_clockNotifier ) ;
+    }
+
+    return 0 ;
+}
+
+/**
+ *  \brief Returns the time since TimeBase_Configure(), in us.
+ */
+extern uint64_t TimeBase_GetUs( void )
+{
+    uint64_t qwNow ;
+    uint32_t primask = __get_PRIMASK() ;
+
+    __disable_irq() ;
+    qwNow = _TimeBase_Now() ;
+
+    /* A RC compare read here is left to the interrupt */
+    if ( _dwStatus & TC_SR_CPCS )
+    {
+        _dwStatus = 0 ;
+        NVIC_SetPendingIRQ( TC4_IRQn ) ;
+    }
+    __set_PRIMASK( primask ) ;
+
+    return qwNow ;
+}
+
+/**
+ *  \brief Waits for several us, spinning on the timebase.
+ */
+extern void TimeBase_WaitUs( uint32_t dwUs )
+{
+    uint64_t qwEnd = TimeBase_GetUs() + dwUs ;
+
+    while ( TimeBase_GetUs() < qwEnd ) ;
+}
+
+/**
+ *  \brief Waits for several us with the core stopped (WFI): a timer wakes
+ *  it up at the end of the delay, other interrupts keep being serviced.
+ */
+extern void TimeBase_SleepUs( uint32_t dwUs )
+{
+    TimeBaseTimer timer ;
+    uint32_t primask = __get_PRIMASK() ;
+
+    timer.ucRunning = 0 ;
+    TimeBase_StartTimer( &timer, dwUs, 0, 0 ) ;
+
+    /* WFI returns on a pending interrupt even when masked: no wake-up lost
+       between the test and the WFI */
+    __disable_irq() ;
+    while ( timer.ucRunning )
+    {
+        __WFI() ;
+        __set_PRIMASK( primask ) ;
+        __disable_irq() ;
+    }
+    __set_PRIMASK( primask ) ;
+}
+
+/**
+ *  \brief Starts a timer expiring in dwUs us; a running timer is restarted.
+ *
+ *  \param pTimer  Timer, must stay valid until it expires or is stopped.
+ *  \param dwUs  Delay in us.
+ *  \param fCallback  Function called from the TC4 interrupt at expiry, may be 0.
+ *  \param pArg  Argument of the callback.
+ */
+extern void TimeBase_StartTimer( TimeBaseTimer* pTimer, uint32_t dwUs, TimeBaseCallback fCallback, void* pArg )
+{
+    TimeBase_StartTimerAt( pTimer, TimeBase_GetUs() + dwUs, fCallback, pArg ) ;
+}
+
+/**
+ *  \brief Starts a timer expiring at a given time, for periodic scheduling
+ *  without drift; a running timer is restarted.
+ *
+ *  \param pTimer  Timer, must stay valid until it expires or is stopped.
+ *  \param qwExpiry  Expiry time, in us (see TimeBase_GetUs()).
+ *  \param fCallback  Function called from the TC4 interrupt at expiry, may be 0.
+ *  \param pArg  Argument of the callback.
+ */
+extern void TimeBase_StartTimerAt( TimeBaseTimer* pTimer, uint64_t qwExpiry, TimeBaseCallback fCallback, void* pArg )
+{
+    TimeBaseTimer** ppPos ;
+    uint32_t primask = __get_PRIMASK() ;
+
+    __disable_irq() ;
+    TimeBase_StopTimer( pTimer ) ;
+
+    pTimer->qwExpiry = qwExpiry ;
+    pTimer->fCallback = fCallback ;
+    pTimer->pArg = pArg ;
+    pTimer->ucRunning = 1 ;
+
+    /* After the timers expiring at the same time */
+    for ( ppPos=&_pTimers ; *ppPos && ((*ppPos)->qwExpiry <= qwExpiry) ; ppPos=&(*ppPos)->pNext ) ;
+    pTimer->pNext = *ppPos ;
+    *ppPos = pTimer ;
+
+    /* New first timer: the interrupt sets the RC compare */
+    if ( _pTimers == pTimer )
+    {
+        NVIC_SetPendingIRQ( TC4_IRQn ) ;
+    }
+    __set_PRIMASK( primask ) ;
+}
+
+/**
+ *  \brief Stops a timer; does nothing if it is not running.
+ */
+extern void TimeBase_StopTimer( TimeBaseTimer* pTimer )
+{
+    TimeBaseTimer** ppPos ;
+    uint32_t primask = __get_PRIMASK() ;
+
+    __disable_irq() ;
+    if ( pTimer->ucRunning )
+    {
+        for ( ppPos=&_pTimers ; *ppPos ; ppPos=&(*ppPos)->pNext )
+        {
+            if ( *ppPos == pTimer )
+            {
+                *ppPos = pTimer->pNext ;
+                break ;
+            }
+        }
+        pTimer->ucRunning = 0 ;
+    }
+    __set_PRIMASK( primask ) ;
+}
@@ -52,7 +52,7 @@ static volatile uint32_t _dwTickCount=0 ;
 /**
  *  \brief Handler for Sytem Tick interrupt.
  */
-extern void TimeTick_Increment( void )
+IRQ_RAMFUNC extern void TimeTick_Increment( void )
 {
     _dwTickCount++ ;
 }
@@ -69,6 +69,20 @@ extern uint32_t TimeTick_Configure( uint32_t new_mck )
     return SysTick_Config( new_mck/1000 ) ;
 }
 
+/**
+ *  \brief Reloads the SysTick period after a MCK change, if the SysTick is
+ *  running. The tick count is kept.
+ *  \param new_mck  New master clock.
+ */
+extern uint32_t TimeTick_SetMck( uint32_t new_mck )
+{
+    if ( (SysTick->CTRL & SysTick_CTRL_ENABLE_Msk) == 0 )
+    {
+        return 0 ;
+    }
+    return SysTick_Config( new_mck/1000 ) ;
+}
+
 /**
  *  \brief Get current Tick Count, in ms.
  */
@@ -34,6 +34,33 @@
 
 #include "board.h"
 
+#include <stdarg.h>
+
+/*------------------------------------------------------------------------------
+ *         Internal definitions
+ *------------------------------------------------------------------------------*/
+
+/** Size of the binary trace ring, a power of two. */
+#ifndef TRACE_BINARY_BUFFER_SIZE
+#define TRACE_BINARY_BUFFER_SIZE  1024
+#endif
+
+/** Drain the binary traces with the console UART PDC. */
+#ifndef TRACE_BINARY_UART
+#define TRACE_BINARY_UART  1
+#endif
+
+/** With the ITM, the binary traces bypass the ring. */
+#if (TRACE_ITM == 1)
+#undef TRACE_BINARY_UART
+#define TRACE_BINARY_UART  0
+#endif
+
+/** Size of the line buffer of the ITM text traces. */
+#ifndef TRACE_ITM_LINE_SIZE
+#define TRACE_ITM_LINE_SIZE  128
+#endif
+
 /*------------------------------------------------------------------------------
  *         Internal variables
  *------------------------------------------------------------------------------*/
@@ -43,17 +70,216 @@
     uint32_t dwTraceLevel = TRACE_LEVEL ;
 #endif
 
+#if (TRACE_BINARY == 1)
+/** Binary trace records, word aligned. */
+static uint32_t _adwTraceBuffer[TRACE_BINARY_BUFFER_SIZE/4] ;
+/** Ring of the binary trace records. */
+static RingBuffer _traceRing = { (uint8_t*)_adwTraceBuffer, TRACE_BINARY_BUFFER_SIZE-1, 0, 0 } ;
+/** Sequence number of the next record. */
+static uint32_t _dwTraceSequence = 0 ;
+/** Number of records dropped as the ring was full. */
+static uint32_t _dwTraceDropped = 0 ;
+#if (TRACE_BINARY_UART == 1)
+/** Is a part of the ring being sent by the UART PDC. */
+static uint8_t _ucTraceSending = 0 ;
+#endif
+#endif
+
+/*------------------------------------------------------------------------------
+ *         Internal functions
+ *------------------------------------------------------------------------------*/
+
+#if (TRACE_BINARY == 1) && (TRACE_BINARY_UART == 1)
+static void _TRACE_BinarySend( void ) ;
+
+/**
+ *  Releases the records sent by the UART PDC and sends the following ones.
+ */
+static void _TRACE_BinarySent( uint32_t dwSize )
+{
+    RING_Consume( &_traceRing, dwSize ) ;
+    _ucTraceSending = 0 ;
+    _TRACE_BinarySend() ;
+}
+
+/**
+ *  Hands the contiguous records at the tail of the ring to the UART PDC,
+ *  unless a part of the ring is already being sent.
+ */
+static void _TRACE_BinarySend( void )
+{
+    uint8_t* pucData ;
+    uint32_t dwSize ;
+    uint32_t primask = __get_PRIMASK() ;
+
+    __disable_irq() ;
+    if ( !_ucTraceSending )
+    {
+        dwSize = RING_Peek( &_traceRing, &pucData ) ;
+        if ( dwSize > 0xFFFF )
+        {
+            dwSize = 0xFFFF & ~3u ;
+        }
+        /* Retried on the next record if the UART is busy */
+        if ( (dwSize != 0) && (UART_PdcSend( pucData, dwSize, _TRACE_BinarySent ) == 0) )
+        {
+            _ucTraceSending = 1 ;
+        }
+    }
+    __set_PRIMASK( primask ) ;
+}
+#endif
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
 /**
- *  Initializes the U(S)ART Console
+ *  Initializes the U(S)ART Console, or the SWO at TRACE_ITM_BAUD when
+ *  TRACE_ITM is 1: the UART is then left to the application.
  *
  *  \param dwBaudRate  U(S)ART baudrate.
  *  \param dwMCk  Master clock frequency.
  */
 extern void TRACE_CONFIGURE( uint32_t dwBaudRate, uint32_t dwMCk )
 {
+#if (TRACE_ITM == 1)
+    ITM_Configure( TRACE_ITM_BAUD, dwMCk, (1u << ITM_PORT_TEXT) | (1u << ITM_PORT_BINARY) ) ;
+#else
     const Pin pinsUART0[] = { PINS_UART } ;
 
     PIO_Configure( pinsUART0, PIO_LISTSIZE( pinsUART0 ) ) ;
 
     UART_Configure( dwBaudRate, dwMCk ) ;
+#endif
 }
+
+#if (TRACE_ITM == 1) && (TRACE_BINARY == 0)
+/**
+ *  Formats a text trace in a line buffer and sends it on the ITM text port;
+ *  called by the TRACE_xxx macros when TRACE_ITM is 1. The traces longer
+ *  than TRACE_ITM_LINE_SIZE are truncated.
+ *
+ *  \param pszFormat  Format string.
+ *  \return Number of characters sent.
+ */
+extern int TRACE_ItmPrintf( const char* pszFormat, ... )
+{
+    char acLine[TRACE_ITM_LINE_SIZE] ;
+    int iCount ;
+    va_list ap ;
+
+    if ( !ITM_IsEnabled( ITM_PORT_TEXT ) )
+    {
+        return 0 ;
+    }
+
+    va_start( ap, pszFormat ) ;
+    iCount = vsnprintf( acLine, sizeof( acLine ), pszFormat, ap ) ;
+    va_end( ap ) ;
+    if ( iCount < 0 )
+    {
+        return 0 ;
+    }
+    if ( iCount >= (int)sizeof( acLine ) )
+    {
+        iCount = sizeof( acLine ) - 1 ;
+    }
+
+    ITM_Write( ITM_PORT_TEXT, (const uint8_t*)acLine, iCount ) ;
+
+    return iCount ;
+}
+#endif
+
+#if (TRACE_BINARY == 1)
+/**
+ *  Stores a binary trace record in the ring; called by the TRACE_xxx macros
+ *  when TRACE_BINARY is 1. The record is dropped if the ring is full. Can be
+ *  called from an interrupt handler.
+ *
+ *  \param dwHeader  TRACE_BINARY_HEADER() of the record.
+ *  \param pszFormat  Format string, stored by address.
+ *  \param ...  Argument words, as many as given in the header.
+ */
+extern void TRACE_BinaryWrite( uint32_t dwHeader, const char* pszFormat, ... )
+{
+    uint32_t adwRecord[2+15] ;
+    uint32_t dwCount = (dwHeader >> 8) & 0xF ;
+    uint32_t primask ;
+    uint32_t i ;
+    va_list ap ;
+
+    adwRecord[1] = (uint32_t)pszFormat ;
+    va_start( ap, pszFormat ) ;
+    for ( i=0 ; i < dwCount ; i++ )
+    {
+        adwRecord[2+i] = va_arg( ap, uint32_t ) ;
+    }
+    va_end( ap ) ;
+
+#if (TRACE_ITM == 1)
+    /* Straight to the stimulus port, whole records in order */
+    primask = __get_PRIMASK() ;
+    __disable_irq() ;
+    adwRecord[0] = (dwHeader & 0xFFFF) | ((_dwTraceSequence++ & 0xFFFF) << 16) ;
+    if ( ITM_IsEnabled( ITM_PORT_BINARY ) )
+    {
+        for ( i=0 ; i < 2+dwCount ; i++ )
+        {
+            ITM_WriteWord( ITM_PORT_BINARY, adwRecord[i] ) ;
+        }
+    }
+    __set_PRIMASK( primask ) ;
+#else
+    /* The ring is shared by all the contexts: whole records, in order */
+    primask = __get_PRIMASK() ;
+    __disable_irq() ;
+    adwRecord[0] = (dwHeader & 0xFFFF) | ((_dwTraceSequence++ & 0xFFFF) << 16) ;
+    if ( RING_GetFree( &_traceRing ) >= (2+dwCount)*4 )
+    {
+        RING_Write( &_traceRing, (const uint8_t*)adwRecord, (2+dwCount)*4 ) ;
+    }
+    else
+    {
+        _dwTraceDropped++ ;
+    }
+    __set_PRIMASK( primask ) ;
+#endif
+
+#if (TRACE_BINARY_UART == 1)
+    _TRACE_BinarySend() ;
+#endif
+}
+
+/**
+ *  Returns the contiguous binary trace data at the tail of the ring, to be
+ *  sent by the application and then released with TRACE_BinaryConsume().
+ *  Only used when TRACE_BINARY_UART and TRACE_ITM are 0.
+ *
+ *  \param ppData  Receives the start of the data.
+ *  \return Number of bytes, 0 if there is no trace.
+ */
+extern uint32_t TRACE_BinaryPeek( uint8_t** ppData )
+{
+    return RING_Peek( &_traceRing, ppData ) ;
+}
+
+/**
+ *  Releases binary trace data returned by TRACE_BinaryPeek().
+ *
+ *  \param dwSize  Number of bytes sent.
+ */
+extern void TRACE_BinaryConsume( uint32_t dwSize )
+{
+    RING_Consume( &_traceRing, dwSize ) ;
+}
+
+/**
+ *  Returns the number of binary trace records dropped as the ring was full.
+ */
+extern uint32_t TRACE_BinaryGetDropped( void )
+{
+    return _dwTraceDropped ;
+}
+#endif
@@ -0,0 +1,233 @@
+#!/usr/bin/env python
+# ----------------------------------------------------------------------------
+#         ATMEL Microcontroller Software Support
+# ----------------------------------------------------------------------------
+# Copyright (c) 2010, Atmel Corporation
+#
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# - Redistributions of source code must retain the above copyright notice,
+# this list of conditions and the disclaimer below.
+#
+# Atmel's name may not be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+# IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+# DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+# OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+# EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+# ----------------------------------------------------------------------------
+
+"""Decodes the binary traces (TRACE_BINARY=1, see trace.h).
+
+Each record holds the address of its format string and its argument words;
+the strings are read from the ELF file of the application. The records are
+searched in a capture file or read live from a serial port (UART console or
+CDC serial, needs pyserial). With TRACE_ITM=1, the capture of the SWO pin
+(openOCD/sam3s_swo.cfg) holds ITM packets: --itm keeps the data of the
+binary trace port, or prints the text trace port with --itm 0.
+
+    tracebin.py app.elf capture.bin
+    tracebin.py app.elf --port /dev/ttyUSB0 --baud 115200
+    tracebin.py app.elf swo.bin --itm 1
+"""
+
+import re
+import struct
+import sys
+
+SYNC = 0xB7
+HEADER = struct.Struct('<II')
+PREFIXES = {5: '-D- ', 4: '-I- ', 3: '-W- ', 2: '-E- ', 1: '-F- '}
+CONVERSION = re.compile(r'%([-+ #0]*)(\d*|\*)(?:\.(\d*|\*))?(hh|h|ll|l|z|j|t)?([diouxXcspn%])')
+
+
+class Elf(object):
+    """Contents of the allocated sections of a 32-bit little endian ELF file."""
+
+    def __init__(self, path):
+        data = open(path, 'rb').read()
+        if data[:4] != b'\x7fELF' or data[4:6] != b'\x01\x01':
+            raise ValueError('%s: not a 32-bit little endian ELF file' % path)
+        (shoff,) = struct.unpack_from('<I', data, 0x20)
+        (shentsize, shnum) = struct.unpack_from('<HH', data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            (_, sh_type, flags, addr, offset,
+             size) = struct.unpack_from('<IIIIII', data, shoff + i * shentsize)
+            # SHT_PROGBITS sections with SHF_ALLOC
+            if sh_type == 1 and (flags & 2) and size:
+                self.sections.append((addr, data[offset:offset + size]))
+
+    def string(self, address):
+        """Returns the NUL terminated string at address, or None."""
+        for (addr, data) in self.sections:
+            if addr <= address < addr + len(data):
+                end = data.find(b'\0', address - addr)
+                if end < 0:
+                    return None
+                return data[address - addr:end].decode('latin-1')
+        return None
+
+
+def format_record(elf, fmt, args):
+    """Applies the C format string fmt to the argument words."""
+    args = list(args)
+    out = []
+    pos = 0
+    for match in CONVERSION.finditer(fmt):
+        out.append(fmt[pos:match.start()])
+        pos = match.end()
+        (flags, width, precision, _, conv) = match.groups()
+        if conv == '%':
+            out.append('%')
+            continue
+        if width == '*':
+            width = str(args.pop(0)) if args else ''
+        if precision == '*':
+            precision = str(args.pop(0)) if args else ''
+        spec = '%' + flags + (width or '')
+        if precision is not None:
+            spec += '.' + precision
+        value = args.pop(0) if args else 0
+        if conv in 'di':
+            if value & 0x80000000:
+                value -= 0x100000000
+            out.append((spec + 'd') % value)
+        elif conv in 'ouxX':
+            out.append((spec + conv.replace('u', 'd')) % value)
+        elif conv == 'c':
+            out.append((spec + 'c') % chr(value & 0xFF))
+        elif conv == 's':
+            text = elf.string(value)
+            out.append((spec + 's') % (text if text is not None
+                                       else '<0x%08x>' % value))
+        elif conv == 'p':
+            out.append('0x%08x' % value)
+    out.append(fmt[pos:])
+    return ''.join(out)
+
+
+def itm_demux(buf, port):
+    """Returns (data, rest): the data written to the stimulus port in the
+    ITM packets of buf, and the bytes of an incomplete packet."""
+    data = bytearray()
+    buf = bytearray(buf)
+    pos = 0
+    while pos < len(buf):
+        header = buf[pos]
+        if header in (0x00, 0x80):          # Synchronization
+            pos += 1
+            continue
+        if header & 3:                      # Source packet, 1, 2 or 4 bytes
+            size = (1, 2, 4)[(header & 3) - 1]
+            if pos + 1 + size > len(buf):
+                break
+            if not header & 4 and (header >> 3) == port:
+                data += buf[pos + 1:pos + 1 + size]
+            pos += 1 + size
+            continue
+        if header == 0x70 or not header & 0x80:  # Overflow, short timestamp
+            pos += 1
+            continue
+        end = pos + 1                       # Timestamp or extension, continued
+        while end < len(buf) and buf[end] & 0x80:
+            end += 1
+        if end >= len(buf):
+            break
+        pos = end + 1
+    return bytes(data), bytes(buf[pos:])
+
+
+def parse(elf, buf):
+    """Returns (lines, dropped, rest): the traces decoded from buf, the count
+    of records lost before them, and the bytes kept for the next call since
+    they may start an incomplete record."""
+    lines = []
+    dropped = 0
+    while True:
+        start = buf.find(bytearray([SYNC]))
+        if start < 0:
+            return lines, dropped, b''
+        buf = buf[start:]
+        if len(buf) < HEADER.size:
+            return lines, dropped, buf
+        (header, address) = HEADER.unpack_from(buf)
+        count = (header >> 8) & 0xF
+        fmt = elf.string(address)
+        if fmt is None:
+            buf = buf[1:]
+            continue
+        size = HEADER.size + 4 * count
+        if len(buf) < size:
+            return lines, dropped, buf
+        args = struct.unpack_from('<%dI' % count, buf, HEADER.size)
+        sequence = header >> 16
+        if parse.sequence is not None:
+            dropped += (sequence - parse.sequence - 1) & 0xFFFF
+        parse.sequence = sequence
+        text = format_record(elf, fmt, args)
+        if (header >> 15) & 1:
+            text = PREFIXES.get((header >> 12) & 7, '') + text
+        lines.append(text)
+        buf = buf[size:]
+
+parse.sequence = None
+
+
+def main(argv):
+    import optparse
+    parser = optparse.OptionParser(usage='%prog [options] elf [capture file]')
+    parser.add_option('-p', '--port', help='serial port to read live')
+    parser.add_option('-b', '--baud', type='int', default=115200,
+                      help='serial port baud rate [%default]')
+    parser.add_option('-i', '--itm', type='int', metavar='PORT',
+                      help='decode the ITM packets of a SWO capture, keeping '
+                      'the given stimulus port (1: binary traces, 0: text)')
+    (options, args) = parser.parse_args(argv[1:])
+
+    if not args:
+        parser.error('give the ELF file of the application')
+    elf = Elf(args[0])
+    if options.port:
+        import serial
+        stream = serial.Serial(options.port, options.baud, timeout=0.5)
+    elif len(args) == 2:
+        stream = open(args[1], 'rb')
+    else:
+        parser.error('give a capture file or a serial port')
+
+    rest = b''
+    itm_rest = b''
+    while True:
+        data = stream.read(1024)
+        if not data:
+            if not options.port:
+                break
+            continue
+        if options.itm is not None:
+            data, itm_rest = itm_demux(itm_rest + data, options.itm)
+            if options.itm == 0:
+                sys.stdout.write(data.decode('latin-1').replace('\r', ''))
+                sys.stdout.flush()
+                continue
+        lines, dropped, rest = parse(elf, rest + data)
+        if dropped:
+            sys.stdout.write('--- %d traces dropped ---\n' % dropped)
+        for line in lines:
+            sys.stdout.write(line.replace('\r', ''))
+        sys.stdout.flush()
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -60,6 +60,9 @@
 /** Maximum difference in pixels between the test point and the measured point. */
 #define POINTS_MAX_ERROR    5
 
+/** Number of conversions per axis acquired for one measurement. */
+#define TSD_SAMPLES         5
+
 /*----------------------------------------------------------------------------
  *        Types
  *----------------------------------------------------------------------------*/
@@ -93,6 +96,15 @@ static volatile e_pen_state penState = STATE_PEN_RELEASED;
 /** Touch screen initiallized flag */
 static uint32_t tsInitFlag = 0;
 
+/** Set while a sample batch started by the timer handler is in progress */
+static uint8_t bSampling = 0;
+
+/** Set when the IIR filter must restart from the next measurement */
+static uint8_t bFilterReset = 1;
+
+/** IIR filter state of the pen position */
+static int32_t filterState[2];
+
 /*----------------------------------------------------------------------------
  *        Local functions
  *----------------------------------------------------------------------------*/
@@ -102,10 +114,17 @@ static uint32_t tsInitFlag = 0;
  * Determine the state "Pen Pressed" or "Pen Released". To change state,
  * the penIRQ has to keep the same value during DEBOUNCE_TIME.
  *
+ * The measurement is pipelined over two ticks: a tick starts a chained
+ * acquisition of TSD_SAMPLES conversions per axis and returns immediately, the
+ * next tick collects it, takes the median of each axis, feeds the IIR filter
+ * and interpolates the result. The handler never waits for the SPI.
+ *
  * \note External timer interrupt should call it per 10ms.
  */
 void TSD_TimerHandler( void )
 {
+    uint16_t awX[TSD_SAMPLES];
+    uint16_t awY[TSD_SAMPLES];
     uint32_t data[2];
     uint32_t timeKeep;
     static uint32_t point[2];
@@ -113,15 +132,27 @@ void TSD_TimerHandler( void )
     if (!tsInitFlag) return;
 
     timestamp++;
-    /* Get the current position of the pen if penIRQ has low value (pen pressed) */
-    if ( PIO_Get(&pinPenIRQ) == 0 )
+
+    /* Collect the batch started by the previous tick */
+    if ( bSampling && ADS7843_IsSamplesReady() )
     {
-        /* Get the current position of the pressed pen */
-        if ( TSDCom_IsCalibrationOk() )
+        ADS7843_GetSamples(awX, awY);
+        bSampling = 0;
+        PIO_EnableIt(&pinPenIRQ);
+
+        if ( PIO_Get(&pinPenIRQ) == 0 )
         {
-            TSD_GetRawMeasurement(data);
+            data[0] = TSDCom_Median(awX, TSD_SAMPLES);
+            data[1] = TSDCom_Median(awY, TSD_SAMPLES);
+            TSDCom_FilterMeasurement(filterState, data, bFilterReset);
+            bFilterReset = 0;
             TSDCom_InterpolateMeasurement(data, point);
         }
+    }
+
+    /* Get the current position of the pen if penIRQ has low value (pen pressed) */
+    if ( PIO_Get(&pinPenIRQ) == 0 )
+    {
 
         /* call the callback function */
         if ( penState == STATE_PEN_PRESSED )
@@ -176,6 +207,21 @@ void TSD_TimerHandler( void )
             }
         }
     }
+
+    /* Start the acquisition collected by the next tick */
+    if ( PIO_Get(&pinPenIRQ) == 0 )
+    {
+        if ( TSDCom_IsCalibrationOk() && !bSampling )
+        {
+            PIO_DisableIt(&pinPenIRQ);
+            ADS7843_StartSamples(TSD_SAMPLES);
+            bSampling = 1;
+        }
+    }
+    else
+    {
+        bFilterReset = 1;
+    }
 }
 
 /**
@@ -227,14 +273,32 @@ static void ConfigurePenIRQ( void )
 /**
  * \brief Reads and store a touchscreen measurement in the provided array.
  *
+ * The measurement is the median of TSD_SAMPLES conversions per axis, acquired
+ * in one chained transfer.
+ *
  * \param pData  Array where the measurements will be stored
  */
 extern void TSD_GetRawMeasurement( uint32_t* pdwData )
 {
+    uint16_t awX[TSD_SAMPLES] ;
+    uint16_t awY[TSD_SAMPLES] ;
+    uint32_t dwCount ;
+
     /* Get the current position of the pressed pen */
     PIO_DisableIt( &pinPenIRQ ) ;
-    ADS7843_GetPosition( &pdwData[0], &pdwData[1] ) ;
+    dwCount = ADS7843_ReadSamples( awX, awY, TSD_SAMPLES ) ;
     PIO_EnableIt( &pinPenIRQ ) ;
+
+    if ( dwCount == 0 )
+    {
+        pdwData[0] = 0 ;
+        pdwData[1] = 0 ;
+
+        return ;
+    }
+
+    pdwData[0] = TSDCom_Median( awX, dwCount ) ;
+    pdwData[1] = TSDCom_Median( awY, dwCount ) ;
 }
 
 /**
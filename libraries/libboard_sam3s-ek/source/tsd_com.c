@@ -55,6 +55,9 @@
 /** Delay at the end of calibartion for result display */
 #define DELAY_RESULT_DISPLAY 4000000
 
+/** Fractional bits of the precomputed reciprocal slopes. */
+#define SLOPE_INV_SHIFT     16
+
 /*----------------------------------------------------------------------------
  *        Types
  *----------------------------------------------------------------------------*/
@@ -82,6 +85,10 @@ static volatile uint8_t bCalibrationOk = 0;
 static int32_t xSlope;
 /** Slope for interpoling touchscreen measurements along the Y-axis. */
 static int32_t ySlope;
+/** Reciprocal of xSlope (Q16), avoids a division per measurement. */
+static int32_t xSlopeInv;
+/** Reciprocal of ySlope (Q16), avoids a division per measurement. */
+static int32_t ySlopeInv;
 
 /** Calibration points. */
 static CalibrationPoint calibrationPoints[] = {
@@ -151,6 +158,15 @@ static void ClearCalibrationPoint(const CalibrationPoint *pPoint)
                                COLOR_WHITE);
 }
 
+/**
+ * \brief Precompute the reciprocal slopes used by TSDCom_InterpolateMeasurement().
+ */
+static void UpdateSlopeInverse(void)
+{
+    xSlopeInv = (xSlope != 0) ? (int32_t)((1024L << SLOPE_INV_SHIFT) / xSlope) : 0;
+    ySlopeInv = (ySlope != 0) ? (int32_t)((1024L << SLOPE_INV_SHIFT) / ySlope) : 0;
+}
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -169,22 +185,88 @@ uint8_t TSDCom_IsCalibrationOk(void)
     }
 }
 
+/**
+ * \brief Return the median of a batch of samples.
+ *
+ * The batch is sorted in place (insertion sort, the batches are a few samples
+ * long), which rejects the outliers caused by pen bounces and noise spikes.
+ *
+ * \param pwSamples  Samples, sorted on return.
+ * \param dwCount  Number of samples (at least 1).
+ *
+ * \return Median value of the batch.
+ */
+uint32_t TSDCom_Median(uint16_t *pwSamples, uint32_t dwCount)
+{
+    uint32_t i, j;
+    uint16_t wValue;
+
+    for (i = 1; i < dwCount; i++) {
+
+        wValue = pwSamples[i];
+        for (j = i; (j > 0) && (pwSamples[j-1] > wValue); j--) {
+
+            pwSamples[j] = pwSamples[j-1];
+        }
+        pwSamples[j] = wValue;
+    }
+
+    return pwSamples[dwCount / 2];
+}
+
+/**
+ * \brief Feed a raw measurement into a first-order IIR low-pass filter.
+ *
+ * The filter state holds both coordinates with TSD_FILTER_SHIFT fractional
+ * bits. Each new measurement moves the state by 1/2^TSD_IIR_SHIFT of the
+ * difference; when bReset is set the state is loaded with the measurement,
+ * so that a new contact does not start from the previous pen position.
+ *
+ * \param pState  Filter state (2 words).
+ * \param pData  Raw measurement (2 words), replaced by the filtered value.
+ * \param bReset  1 to restart the filter from this measurement.
+ */
+void TSDCom_FilterMeasurement(int32_t *pState, uint32_t *pData, uint8_t bReset)
+{
+    uint32_t i;
+    int32_t lInput;
+
+    for (i = 0; i < 2; i++) {
+
+        lInput = (int32_t) pData[i] << TSD_FILTER_SHIFT;
+        if (bReset) {
+
+            pState[i] = lInput;
+        }
+        else {
+
+            pState[i] += (lInput - pState[i]) >> TSD_IIR_SHIFT;
+        }
+        pData[i] = (uint32_t) ((pState[i] + (1 << (TSD_FILTER_SHIFT - 1))) >> TSD_FILTER_SHIFT);
+    }
+}
+
 /**
  * \brief Interpolates the provided raw measurements using the previously calculated
  * slope. The resulting x and y coordinates are stored in an array.
  *
+ * The slopes are applied through their precomputed Q16 reciprocals, so the
+ * interpolation costs two multiplications and no division.
+ *
  * \param pData  Raw measurement data, as returned by TSD_GetRawMeasurement().
  * \param pPoint  Array in which x and y will be stored.
  */
 void TSDCom_InterpolateMeasurement(const uint32_t *pData, uint32_t *pPoint)
 {
+    int32_t lDelta;
+
+    lDelta = (int32_t) calibrationPoints[0].data[0] - (int32_t) pData[0];
     pPoint[0] = calibrationPoints[0].x
-                - (((int32_t) calibrationPoints[0].data[0] - (int32_t) pData[0]) * 1024)
-                / xSlope;
+                - (int32_t) ((((int64_t) lDelta * xSlopeInv) + (1 << (SLOPE_INV_SHIFT - 1))) >> SLOPE_INV_SHIFT);
 
+    lDelta = (int32_t) calibrationPoints[0].data[1] - (int32_t) pData[1];
     pPoint[1] = calibrationPoints[0].y
-                - (((int32_t) calibrationPoints[0].data[1] - (int32_t) pData[1]) * 1024)
-                / ySlope;
+                - (int32_t) ((((int64_t) lDelta * ySlopeInv) + (1 << (SLOPE_INV_SHIFT - 1))) >> SLOPE_INV_SHIFT);
 
     if(pPoint[0] & 0x80000000) /* Is pPoint[0] negative ? */
     {
@@ -276,6 +358,7 @@ uint8_t TSDCom_Calibrate(void)
     slope2 *= 1024;
     slope2 /= ((int32_t) calibrationPoints[1].y) - ((int32_t) calibrationPoints[3].y);
     ySlope = (slope1 + slope2) / 2;
+    UpdateSlopeInverse();
 
     /* Test point */
     LCDD_Fill(0xFFFFFF);
@@ -366,4 +449,6 @@ void TSDCom_RestoreCalibrateData(void *pBuffer, uint32_t size)
     pSrc += sizeof(ySlope);
     memcpy(&calibrationPoints[0].data, pSrc, sizeof(calibrationPoints[0].data));
     pSrc += sizeof(calibrationPoints[0].data);
+
+    UpdateSlopeInverse();
 }
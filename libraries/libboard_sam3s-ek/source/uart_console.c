@@ -42,6 +42,7 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <stdarg.h>
 
 /*----------------------------------------------------------------------------
  *        Definitions
@@ -55,6 +56,18 @@
 #define CONSOLE_ID          ID_UART0
 /** Pins description corresponding to Rxd,Txd, (UART pins) */
 #define CONSOLE_PINS        {PINS_UART}
+/** Size of the receive ring used after UART_EnableRxBuffer(), a power of two. */
+#ifndef CONSOLE_RX_BUFFER_SIZE
+#define CONSOLE_RX_BUFFER_SIZE  64
+#endif
+/** Size of the transmit ring used after UART_EnableTxBuffer(), a power of two. */
+#ifndef CONSOLE_TX_BUFFER_SIZE
+#define CONSOLE_TX_BUFFER_SIZE  1024
+#endif
+/** Size of the two PDC buffers the transmit ring is copied to. */
+#define CONSOLE_TX_CHUNK_SIZE   64
+/** Size of the buffer of UART_Printf(), written at once to the line. */
+#define CONSOLE_PRINTF_BUFFER_SIZE  64
 
 /*----------------------------------------------------------------------------
  *        Variables
@@ -63,6 +76,79 @@
 /** Is Console Initialized. */
 static uint8_t _ucIsConsoleInitialized=0 ;
 
+/** Is the reception buffered by the UART interrupt. */
+static uint8_t _ucIsRxBuffered=0 ;
+/** Receive ring, filled by UART0_IrqHandler() and drained by UART_GetChar(). */
+static RingBuffer _rxRing ;
+static uint8_t _aucRxBuffer[CONSOLE_RX_BUFFER_SIZE] ;
+
+/** Completion callback of the running UART_PdcSend(), 0 if none. */
+static void (*volatile _fTxCallback)( uint32_t dwSize ) ;
+/** Size of the running UART_PdcSend(). */
+static uint32_t _dwTxSize ;
+
+/** Policy of the transmit ring, UART_TX_xxx; 0 while the output is direct. */
+static uint8_t _ucTxPolicy=0 ;
+/** Transmit ring, filled by UART_Write() and drained by the UART PDC. */
+static RingBuffer _txRing ;
+static uint8_t _aucTxBuffer[CONSOLE_TX_BUFFER_SIZE] ;
+/** PDC buffers: one is sent while the other is queued in the next pointer. */
+static uint8_t _aucTxChunks[2][CONSOLE_TX_CHUNK_SIZE] ;
+static uint8_t _ucTxChunk=0 ;
+/** Number of bytes dropped by the UART_TX_DROP_OLDEST policy. */
+static volatile uint32_t _dwTxDropped=0 ;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Copies the transmit ring to the free PDC buffers and queues them;
+ * called with the interrupts masked or from the UART interrupt.
+ */
+static void _UART_TxFill( Uart *pUart )
+{
+    uint32_t dwSize ;
+
+    while ( pUart->UART_TNCR == 0 )
+    {
+        dwSize=RING_Read( &_txRing, _aucTxChunks[_ucTxChunk], CONSOLE_TX_CHUNK_SIZE ) ;
+        if ( dwSize == 0 )
+        {
+            pUart->UART_IDR=UART_IDR_ENDTX ;
+            return ;
+        }
+
+        if ( pUart->UART_TCR == 0 )
+        {
+            pUart->UART_TPR=(uint32_t)_aucTxChunks[_ucTxChunk] ;
+            pUart->UART_TCR=dwSize ;
+        }
+        else
+        {
+            pUart->UART_TNPR=(uint32_t)_aucTxChunks[_ucTxChunk] ;
+            pUart->UART_TNCR=dwSize ;
+        }
+        _ucTxChunk ^= 1 ;
+    }
+
+    /* Refill when the current buffer is sent and the next one takes over */
+    pUart->UART_IER=UART_IER_ENDTX ;
+}
+
+/**
+ * \brief Is the caller unable to wait for the UART interrupt: an exception
+ * handler, or interrupts masked.
+ */
+static uint32_t _UART_CannotWait( void )
+{
+    return ((SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) != 0) || (__get_PRIMASK() != 0) ;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
 /**
  * \brief Configures an USART peripheral with the specified parameters.
  *
@@ -103,19 +189,27 @@ extern void UART_Configure( uint32_t baudrate, uint32_t masterClock)
 /**
  * \brief Outputs a character on the UART line.
  *
- * \note This function is synchronous (i.e. uses polling).
+ * \note This function is synchronous (i.e. uses polling), unless the transmit
+ * ring is enabled by UART_EnableTxBuffer().
  * \param c  Character to send.
  */
 extern void UART_PutChar( uint8_t c )
 {
     Uart *pUart=CONSOLE_USART ;
 
+    if ( _ucTxPolicy != 0 )
+    {
+        UART_Write( &c, 1 ) ;
+        return ;
+    }
+
     if ( !_ucIsConsoleInitialized )
     {
         UART_Configure(CONSOLE_BAUDRATE, BOARD_MCK);
     }
 
-    /* Wait for the transmitter to be ready */
+    /* Wait for the transmitter to be ready, after any PDC transmission */
+    while ( pUart->UART_TCR != 0 ) ;
     while ( (pUart->UART_SR & UART_SR_TXEMPTY) == 0 ) ;
 
     /* Send character */
@@ -123,6 +217,221 @@ extern void UART_PutChar( uint8_t c )
 
 }
 
+/**
+ * \brief Buffers the characters received by the console in a ring, from the
+ * UART interrupt, so that none is lost while the application does not poll
+ * the line. UART_GetChar() and UART_IsRxReady() then use the ring.
+ */
+extern void UART_EnableRxBuffer( void )
+{
+    Uart *pUart=CONSOLE_USART ;
+
+    if ( !_ucIsConsoleInitialized )
+    {
+        UART_Configure( CONSOLE_BAUDRATE, BOARD_MCK ) ;
+    }
+
+    RING_Initialize( &_rxRing, _aucRxBuffer, sizeof( _aucRxBuffer ) ) ;
+    _ucIsRxBuffered=1 ;
+
+    pUart->UART_IER=UART_IER_RXRDY ;
+    NVIC_EnableIRQ( UART0_IRQn ) ;
+}
+
+/**
+ * \brief Buffers the characters sent by the console in a ring, which the UART
+ * PDC drains in the background: UART_PutChar(), UART_Write(), UART_Printf()
+ * and printf() no longer wait for the line. When the ring is full,
+ * UART_TX_BLOCK waits for room, except in an interrupt handler or with the
+ * interrupts masked, where the oldest characters are dropped as with
+ * UART_TX_DROP_OLDEST. UART_PdcSend() is no longer available.
+ *
+ * \param dwPolicy  UART_TX_BLOCK or UART_TX_DROP_OLDEST.
+ */
+extern void UART_EnableTxBuffer( uint32_t dwPolicy )
+{
+    Uart *pUart=CONSOLE_USART ;
+
+    if ( !_ucIsConsoleInitialized )
+    {
+        UART_Configure( CONSOLE_BAUDRATE, BOARD_MCK ) ;
+    }
+
+    /* Let any character or PDC transmission complete */
+    while ( pUart->UART_TCR != 0 ) ;
+    while ( (pUart->UART_SR & UART_SR_TXEMPTY) == 0 ) ;
+
+    RING_Initialize( &_txRing, _aucTxBuffer, sizeof( _aucTxBuffer ) ) ;
+    _dwTxDropped=0 ;
+    _ucTxPolicy=(uint8_t)dwPolicy ;
+
+    pUart->UART_PTCR=UART_PTCR_TXTEN ;
+    NVIC_EnableIRQ( UART0_IRQn ) ;
+}
+
+/**
+ * \brief Outputs a buffer on the UART line: through the transmit ring once
+ * UART_EnableTxBuffer() has been called, by polling otherwise.
+ *
+ * \param pucData  Data to send.
+ * \param dwSize  Number of bytes.
+ */
+extern void UART_Write( const uint8_t* pucData, uint32_t dwSize )
+{
+    Uart *pUart=CONSOLE_USART ;
+    uint32_t dwFree ;
+    uint32_t dwDone ;
+    uint32_t primask ;
+
+    if ( _ucTxPolicy == 0 )
+    {
+        for ( ; dwSize != 0 ; dwSize-- )
+        {
+            UART_PutChar( *pucData++ ) ;
+        }
+        return ;
+    }
+
+    if ( (_ucTxPolicy == UART_TX_DROP_OLDEST) || _UART_CannotWait() )
+    {
+        /* Keep the newest characters */
+        if ( dwSize > CONSOLE_TX_BUFFER_SIZE )
+        {
+            _dwTxDropped += dwSize - CONSOLE_TX_BUFFER_SIZE ;
+            pucData += dwSize - CONSOLE_TX_BUFFER_SIZE ;
+            dwSize=CONSOLE_TX_BUFFER_SIZE ;
+        }
+
+        primask=__get_PRIMASK() ;
+        __disable_irq() ;
+        dwFree=RING_GetFree( &_txRing ) ;
+        if ( dwFree < dwSize )
+        {
+            RING_Consume( &_txRing, dwSize - dwFree ) ;
+            _dwTxDropped += dwSize - dwFree ;
+        }
+        RING_Write( &_txRing, pucData, dwSize ) ;
+        _UART_TxFill( pUart ) ;
+        __set_PRIMASK( primask ) ;
+
+        return ;
+    }
+
+    while ( dwSize != 0 )
+    {
+        /* Wait for room, the PDC empties the ring from the UART interrupt */
+        while ( RING_GetFree( &_txRing ) == 0 ) ;
+
+        __disable_irq() ;
+        dwDone=RING_Write( &_txRing, pucData, dwSize ) ;
+        _UART_TxFill( pUart ) ;
+        __enable_irq() ;
+
+        pucData += dwDone ;
+        dwSize -= dwDone ;
+    }
+}
+
+/**
+ * \brief Waits until the transmit ring is empty and the last character is
+ * out of the UART, e.g. before a reset or a low power mode.
+ */
+extern void UART_TxFlush( void )
+{
+    Uart *pUart=CONSOLE_USART ;
+
+    if ( !_ucIsConsoleInitialized )
+    {
+        return ;
+    }
+
+    while ( (_ucTxPolicy != 0) && (RING_GetCount( &_txRing ) != 0) ) ;
+    while ( (pUart->UART_TCR != 0) || (pUart->UART_TNCR != 0) ) ;
+    while ( (pUart->UART_SR & UART_SR_TXEMPTY) == 0 ) ;
+}
+
+/**
+ * \brief Returns the number of characters dropped because the transmit ring
+ * was full.
+ */
+extern uint32_t UART_GetTxDropped( void )
+{
+    return _dwTxDropped ;
+}
+
+/**
+ * \brief Sends a buffer on the UART line with the PDC, in the background.
+ * The buffer must not change until the callback, which is called from the UART
+ * interrupt once the PDC has taken the last byte.
+ *
+ * \param pucData  Data to send.
+ * \param dwSize  Number of bytes, 1 to 65535.
+ * \param fCallback  Completion callback, receiving dwSize; can be 0.
+ * \return 0 if the transmission is started, 1 if one is already running or
+ * if the transmit ring is enabled.
+ */
+extern uint32_t UART_PdcSend( const uint8_t* pucData, uint32_t dwSize, void (*fCallback)( uint32_t dwSize ) )
+{
+    Uart *pUart=CONSOLE_USART ;
+
+    if ( !_ucIsConsoleInitialized )
+    {
+        UART_Configure( CONSOLE_BAUDRATE, BOARD_MCK ) ;
+    }
+
+    if ( (_ucTxPolicy != 0) || (pUart->UART_TCR != 0) || (pUart->UART_IMR & UART_IMR_ENDTX) )
+    {
+        return 1 ;
+    }
+
+    _fTxCallback=fCallback ;
+    _dwTxSize=dwSize ;
+
+    pUart->UART_TPR=(uint32_t)pucData ;
+    pUart->UART_TCR=dwSize ;
+    pUart->UART_PTCR=UART_PTCR_TXTEN ;
+    pUart->UART_IER=UART_IER_ENDTX ;
+    NVIC_EnableIRQ( UART0_IRQn ) ;
+
+    return 0 ;
+}
+
+/**
+ * \brief Console interrupt: moves the received characters to the ring, where
+ * they are dropped when the ring is full, refills the transmit PDC from the
+ * transmit ring and completes UART_PdcSend().
+ */
+extern void UART0_IrqHandler( void )
+{
+    Uart *pUart=CONSOLE_USART ;
+    void (*fCallback)( uint32_t dwSize ) ;
+    uint32_t dwStatus=pUart->UART_SR & pUart->UART_IMR ;
+
+    if ( ((dwStatus & UART_SR_ENDTX) != 0) && (_ucTxPolicy != 0) )
+    {
+        _UART_TxFill( pUart ) ;
+    }
+    else if ( (dwStatus & UART_SR_ENDTX) != 0 )
+    {
+        pUart->UART_IDR=UART_IDR_ENDTX ;
+        fCallback=_fTxCallback ;
+        _fTxCallback=0 ;
+        if ( fCallback )
+        {
+            fCallback( _dwTxSize ) ;
+        }
+    }
+
+    if ( (dwStatus & UART_SR_RXRDY) != 0 )
+    {
+        while ( (pUart->UART_SR & UART_SR_RXRDY) != 0 )
+        {
+            RING_Put( &_rxRing, (uint8_t)pUart->UART_RHR ) ;
+        }
+        IOEVT_Raise( IOEVT_CONSOLE_RX ) ;
+    }
+}
+
 /**
  * \brief Input a character from the UART line.
  *
@@ -132,12 +441,20 @@ extern void UART_PutChar( uint8_t c )
 extern uint32_t UART_GetChar( void )
 {
     Uart *pUart=CONSOLE_USART ;
+    uint8_t uc ;
 
     if ( !_ucIsConsoleInitialized )
     {
         UART_Configure(CONSOLE_BAUDRATE, BOARD_MCK);
     }
 
+    if ( _ucIsRxBuffered )
+    {
+        while ( RING_Get( &_rxRing, &uc ) != 0 ) ;
+
+        return uc ;
+    }
+
     while ( (pUart->UART_SR & UART_SR_RXRDY) == 0 ) ;
 
     return pUart->UART_RHR ;
@@ -157,9 +474,235 @@ extern uint32_t UART_IsRxReady( void )
         UART_Configure( CONSOLE_BAUDRATE, BOARD_MCK ) ;
     }
 
+    if ( _ucIsRxBuffered )
+    {
+        return RING_GetCount( &_rxRing ) > 0 ;
+    }
+
     return (pUart->UART_SR & UART_SR_RXRDY) > 0 ;
 }
 
+/**
+ * \brief Formats a string like vprintf(), with integers only, and outputs it
+ * with UART_Write(): far smaller and faster than the C library formatter.
+ * Supports the %d, %i, %u, %x, %X, %c, %s, %p and %% conversions, with the
+ * '-' and '0' flags and a width; a precision is taken as a zero-padded
+ * width, the 'l' and 'h' length modifiers are accepted and ignored, the
+ * arguments being 32-bit.
+ *
+ * \param pszFormat  Format string.
+ * \param ap  Arguments.
+ * \return Number of characters output.
+ */
+extern int UART_VPrintf( const char* pszFormat, va_list ap )
+{
+    char acBuffer[CONSOLE_PRINTF_BUFFER_SIZE] ;
+    char acDigits[10] ;
+    const char* pszString ;
+    uint32_t dwLength=0 ;
+    uint32_t dwTotal=0 ;
+    uint32_t dwValue ;
+    uint32_t dwWidth ;
+    uint32_t dwBase ;
+    uint32_t dwCount ;
+    uint8_t ucLeft ;
+    char cPad ;
+    char cSign ;
+    char cUpper ;
+
+/* Appends a character, the buffer being written to the line when full */
+#define _UART_PRINTF_OUT( c ) { acBuffer[dwLength++]=(c) ; \
+                                if ( dwLength == sizeof( acBuffer ) ) { UART_Write( (const uint8_t*)acBuffer, dwLength ) ; dwTotal += dwLength ; dwLength=0 ; } }
+
+    for ( ; *pszFormat != 0 ; pszFormat++ )
+    {
+        if ( *pszFormat != '%' )
+        {
+            _UART_PRINTF_OUT( *pszFormat ) ;
+            continue ;
+        }
+
+        /* Flags, width and length modifiers */
+        pszFormat++ ;
+        ucLeft=0 ;
+        cPad=' ' ;
+        for ( ; (*pszFormat == '-') || (*pszFormat == '0') ; pszFormat++ )
+        {
+            if ( *pszFormat == '-' )
+            {
+                ucLeft=1 ;
+            }
+            else
+            {
+                cPad='0' ;
+            }
+        }
+        for ( dwWidth=0 ; (*pszFormat >= '0') && (*pszFormat <= '9') ; pszFormat++ )
+        {
+            dwWidth=dwWidth*10 + (*pszFormat - '0') ;
+        }
+        if ( *pszFormat == '.' )
+        {
+            cPad='0' ;
+            for ( dwWidth=0, pszFormat++ ; (*pszFormat >= '0') && (*pszFormat <= '9') ; pszFormat++ )
+            {
+                dwWidth=dwWidth*10 + (*pszFormat - '0') ;
+            }
+        }
+        while ( (*pszFormat == 'l') || (*pszFormat == 'h') )
+        {
+            pszFormat++ ;
+        }
+
+        /* Conversion, to acDigits in reverse order or to pszString */
+        pszString=0 ;
+        dwCount=0 ;
+        cSign=0 ;
+        dwBase=10 ;
+        cUpper=0 ;
+        switch ( *pszFormat )
+        {
+            case 'd' :
+            case 'i' :
+                dwValue=va_arg( ap, uint32_t ) ;
+                if ( (int32_t)dwValue < 0 )
+                {
+                    cSign='-' ;
+                    dwValue=0 - dwValue ;
+                }
+            break ;
+
+            case 'u' :
+                dwValue=va_arg( ap, uint32_t ) ;
+            break ;
+
+            case 'p' :
+                dwValue=(uint32_t)va_arg( ap, void* ) ;
+                dwBase=16 ;
+                cPad='0' ;
+                dwWidth=8 ;
+            break ;
+
+            case 'X' :
+                cUpper=1 ;
+            /* Fall through */
+            case 'x' :
+                dwValue=va_arg( ap, uint32_t ) ;
+                dwBase=16 ;
+            break ;
+
+            case 'c' :
+                acDigits[0]=(char)va_arg( ap, int ) ;
+                dwCount=1 ;
+            break ;
+
+            case 's' :
+                pszString=va_arg( ap, const char* ) ;
+                if ( pszString == 0 )
+                {
+                    pszString="(null)" ;
+                }
+                while ( pszString[dwCount] != 0 )
+                {
+                    dwCount++ ;
+                }
+            break ;
+
+            case 0 :
+                pszFormat-- ;
+            /* Fall through: a trailing '%' is output as it is */
+            default :
+                acDigits[0]=*pszFormat ;
+                dwCount=1 ;
+                dwWidth=0 ;
+            break ;
+        }
+
+        if ( (dwCount == 0) && (pszString == 0) )
+        {
+            do
+            {
+                acDigits[dwCount++]=(char)((dwValue % dwBase < 10) ? ('0' + dwValue % dwBase)
+                                                                    : ((cUpper ? 'A' : 'a') + dwValue % dwBase - 10)) ;
+                dwValue /= dwBase ;
+            } while ( dwValue != 0 ) ;
+        }
+
+        /* Sign and padding; the sign precedes zeroes, follows spaces */
+        if ( cSign != 0 )
+        {
+            if ( dwWidth != 0 )
+            {
+                dwWidth-- ;
+            }
+            if ( cPad == '0' )
+            {
+                _UART_PRINTF_OUT( cSign ) ;
+            }
+        }
+        while ( !ucLeft && (dwWidth > dwCount) )
+        {
+            _UART_PRINTF_OUT( cPad ) ;
+            dwWidth-- ;
+        }
+        if ( (cSign != 0) && (cPad != '0') )
+        {
+            _UART_PRINTF_OUT( cSign ) ;
+        }
+
+        if ( pszString != 0 )
+        {
+            while ( *pszString != 0 )
+            {
+                _UART_PRINTF_OUT( *pszString++ ) ;
+            }
+        }
+        else
+        {
+            while ( dwCount != 0 )
+            {
+                if ( dwWidth != 0 )
+                {
+                    dwWidth-- ;
+                }
+                _UART_PRINTF_OUT( acDigits[--dwCount] ) ;
+            }
+        }
+        while ( ucLeft && (dwWidth > dwCount) )
+        {
+            _UART_PRINTF_OUT( ' ' ) ;
+            dwWidth-- ;
+        }
+    }
+
+#undef _UART_PRINTF_OUT
+
+    if ( dwLength != 0 )
+    {
+        UART_Write( (const uint8_t*)acBuffer, dwLength ) ;
+    }
+
+    return (int)(dwTotal + dwLength) ;
+}
+
+/**
+ * \brief Formats a string with UART_VPrintf() and outputs it.
+ *
+ * \param pszFormat  Format string.
+ * \return Number of characters output.
+ */
+extern int UART_Printf( const char* pszFormat, ... )
+{
+    va_list ap ;
+    int iCount ;
+
+    va_start( ap, pszFormat ) ;
+    iCount=UART_VPrintf( pszFormat, ap ) ;
+    va_end( ap ) ;
+
+    return iCount ;
+}
+
 /**
  *  Displays the content of the given frame on the UART0.
  *
@@ -172,10 +715,10 @@ extern void UART_DumpFrame( uint8_t* pucFrame, uint32_t dwSize )
 
     for ( dw=0 ; dw < dwSize ; dw++ )
     {
-        printf( "%02X ", pucFrame[dw] ) ;
+        UART_Printf( "%02X ", pucFrame[dw] ) ;
     }
 
-    printf( "\n\r" ) ;
+    UART_Printf( "\n\r" ) ;
 }
 
 /**
@@ -194,12 +737,12 @@ extern void UART_DumpMemory( uint8_t* pucBuffer, uint32_t dwSize, uint32_t dwAdd
 
     for ( i=0 ; i < (dwSize / 16) ; i++ )
     {
-        printf( "0x%08X: ", (unsigned int)(dwAddress + (i*16)) ) ;
+        UART_Printf( "0x%08X: ", (unsigned int)(dwAddress + (i*16)) ) ;
         pucTmp = (uint8_t*)&pucBuffer[i*16] ;
 
         for ( j=0 ; j < 4 ; j++ )
         {
-            printf( "%02X%02X%02X%02X ", pucTmp[0], pucTmp[1], pucTmp[2], pucTmp[3] ) ;
+            UART_Printf( "%02X%02X%02X%02X ", pucTmp[0], pucTmp[1], pucTmp[2], pucTmp[3] ) ;
             pucTmp += 4 ;
         }
 
@@ -210,38 +753,38 @@ extern void UART_DumpMemory( uint8_t* pucBuffer, uint32_t dwSize, uint32_t dwAdd
             UART_PutChar( *pucTmp++ ) ;
         }
 
-        printf( "\n\r" ) ;
+        UART_Printf( "\n\r" ) ;
     }
 
     if ( (dwSize%16) != 0 )
     {
         dwLastLineStart=dwSize - (dwSize%16) ;
 
-        printf( "0x%08X: ", (unsigned int)(dwAddress + dwLastLineStart) ) ;
+        UART_Printf( "0x%08X: ", (unsigned int)(dwAddress + dwLastLineStart) ) ;
         for ( j=dwLastLineStart ; j < dwLastLineStart+16 ; j++ )
         {
             if ( (j!=dwLastLineStart) && (j%4 == 0) )
             {
-                printf( " " ) ;
+                UART_Printf( " " ) ;
             }
 
             if ( j < dwSize )
             {
-                printf( "%02X", pucBuffer[j] ) ;
+                UART_Printf( "%02X", pucBuffer[j] ) ;
             }
             else
             {
-                printf("  ") ;
+                UART_Printf("  ") ;
             }
         }
 
-        printf( " " ) ;
+        UART_Printf( " " ) ;
         for ( j=dwLastLineStart ; j < dwSize ; j++ )
         {
             UART_PutChar( pucBuffer[j] ) ;
         }
 
-        printf( "\n\r" ) ;
+        UART_Printf( "\n\r" ) ;
     }
 }
 
@@ -45,6 +45,159 @@
 #define WAV_FORMAT        0x45564157
 /* WAV letters "fmt "*/
 #define WAV_SUBCHUNKID    0x20746D66
+/* WAV letters "data"*/
+#define WAV_DATAID        0x61746164
+
+/* Size of the canonical header, up to the first chunk after "fmt " */
+#define WAV_HEADER_SIZE   44
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Converts frames to 16-bit stereo words, left channel in the low
+ * halfword as the SSC sends them.
+ */
+static void _WAV_ConvertSsc16(const uint8_t *pSrc, uint32_t *pDst,
+                              uint32_t frames, uint32_t bits, uint32_t channels)
+{
+    const uint16_t *pHalf = (const uint16_t *)pSrc;
+    const uint32_t *pWord = (const uint32_t *)pSrc;
+    uint32_t value;
+
+    if (bits == 16 && channels == 2) {
+
+        /* Already in output format: word copy, unrolled */
+        for (; frames >= 4; frames -= 4) {
+
+            pDst[0] = pWord[0];
+            pDst[1] = pWord[1];
+            pDst[2] = pWord[2];
+            pDst[3] = pWord[3];
+            pDst += 4;
+            pWord += 4;
+        }
+        while (frames--) {
+
+            *pDst++ = *pWord++;
+        }
+    }
+    else if (bits == 16) {
+
+        while (frames--) {
+
+            value = *pHalf++;
+            *pDst++ = value | (value << 16);
+        }
+    }
+    else if (channels == 2) {
+
+        /* 8-bit samples are unsigned: flip the sign bit, scale to 16 bits */
+        while (frames--) {
+
+            *pDst++ = ((pSrc[0] ^ 0x80) << 8) | ((pSrc[1] ^ 0x80) << 24);
+            pSrc += 2;
+        }
+    }
+    else {
+
+        while (frames--) {
+
+            value = (*pSrc++ ^ 0x80) << 8;
+            *pDst++ = value | (value << 16);
+        }
+    }
+}
+
+/**
+ * \brief Converts frames to 12-bit unsigned samples for the DACC, stereo
+ * being mixed down to mono.
+ */
+static void _WAV_ConvertDacc12(const uint8_t *pSrc, uint16_t *pDst,
+                               uint32_t frames, uint32_t bits, uint32_t channels)
+{
+    const int16_t *pHalf = (const int16_t *)pSrc;
+
+    if (bits == 16 && channels == 2) {
+
+        /* (l + r) / 2 + 0x8000, to 12 bits */
+        while (frames--) {
+
+            *pDst++ = (uint32_t)(pHalf[0] + pHalf[1] + 0x10000) >> 5;
+            pHalf += 2;
+        }
+    }
+    else if (bits == 16) {
+
+        while (frames--) {
+
+            *pDst++ = (uint16_t)(*pHalf++ ^ 0x8000) >> 4;
+        }
+    }
+    else if (channels == 2) {
+
+        while (frames--) {
+
+            *pDst++ = (pSrc[0] + pSrc[1]) << 3;
+            pSrc += 2;
+        }
+    }
+    else {
+
+        while (frames--) {
+
+            *pDst++ = *pSrc++ << 4;
+        }
+    }
+}
+
+/**
+ * \brief Converts up to the given number of frames from the ring into the
+ * output buffer, in place in the ring.
+ * \return Number of frames converted.
+ */
+static uint32_t _WAV_Drain(WavPlayer *pPlayer, void *pDst, uint32_t frames)
+{
+    uint32_t align = pPlayer->header.blockAlign;
+    uint32_t bits = pPlayer->header.bitsPerSample;
+    uint32_t channels = pPlayer->header.numChannels;
+    uint32_t done = 0;
+    uint32_t count;
+    uint32_t area;
+    uint8_t *pSrc;
+
+    /* The ring size is a multiple of the frame size, so that frames never
+       straddle the end of the storage */
+    while ((done < frames)
+           && ((area = RING_Peek(&pPlayer->ring, &pSrc)) >= align)) {
+
+        count = area / align;
+        if (count > frames - done) {
+
+            count = frames - done;
+        }
+        if (pPlayer->bOutput == WAV_OUTPUT_SSC16) {
+
+            _WAV_ConvertSsc16(pSrc, (uint32_t *)pDst + done, count, bits, channels);
+        }
+        else {
+
+            _WAV_ConvertDacc12(pSrc, (uint16_t *)pDst + done, count, bits, channels);
+        }
+        RING_Consume(&pPlayer->ring, count * align);
+        done += count;
+    }
+
+    count = RING_GetCount(&pPlayer->ring);
+    if (count < pPlayer->dwLowWater) {
+
+        pPlayer->dwLowWater = count;
+    }
+    pPlayer->dwFrames += done;
+
+    return done;
+}
 
 /*----------------------------------------------------------------------------
  *        Exported functions
@@ -88,3 +241,293 @@ void WAV_DisplayInfo(const WavHeader *header)
     printf( "  - Subchunk2 ID    = 0x%08X\n\r", header->subchunk2ID);
     printf( "  - Subchunk2 Size  = %u\n\r",     header->subchunk2Size);
 }
+
+/**
+ * \brief Returns the size of the read-ahead ring a file needs to play
+ * without gap while a read may take up to the given latency.
+ *
+ * The ring holds the audio played during the slowest read plus the chunk
+ * being read, rounded up to a power of two. Measure the latency on the
+ * target media with WavPlayer.dwReadMax: SD cards commonly stall for
+ * 100-250 ms while erasing, NAND FTL garbage collection for less.
+ *
+ * \param header  Wav header of the file.
+ * \param dwLatency  Worst read latency in ms.
+ * \param dwChunk  Size of one read, a power of two.
+ * \return Size of the ring in bytes.
+ */
+uint32_t WAV_GetRingSize(const WavHeader *header, uint32_t dwLatency,
+                         uint32_t dwChunk)
+{
+    uint32_t needed = (uint32_t)(((uint64_t)header->byteRate * dwLatency) / 1000)
+                      + dwChunk;
+    uint32_t size = dwChunk * 2;
+
+    while (size < needed) {
+
+        size <<= 1;
+    }
+    return size;
+}
+
+/**
+ * \brief Reads the header of a Wav file and prepares a player for it.
+ *
+ * The file is accessed through the read function only, from a FatFs file
+ * (f_read() on a FIL given as context) or any other media. Reads are done
+ * dwChunk bytes at a time in place in the ring, so a chunk which is a
+ * multiple of the sector size goes straight from the media to the ring.
+ * Chunks other than "data" found after "fmt " are skipped.
+ *
+ * \param pPlayer  Player to initialize.
+ * \param read  File access function.
+ * \param pContext  Argument of the read function.
+ * \param pRing  Ring storage, word aligned, see WAV_GetRingSize().
+ * \param dwRingSize  Size of the ring, a power of two.
+ * \param dwChunk  Bytes per read, a power of two of at least 4 dividing the
+ *                 ring size.
+ * \param bOutput  WAV_OUTPUT_SSC16 or WAV_OUTPUT_DACC12.
+ * \return 0 if the file can be played; 1 on a read error, 2 if the format
+ * is not supported (PCM 8 or 16 bits, mono or stereo), 3 on bad parameters.
+ */
+uint8_t WAV_PlayerOpen(WavPlayer *pPlayer, WavReadFunc read, void *pContext,
+                       uint8_t *pRing, uint32_t dwRingSize, uint32_t dwChunk,
+                       uint8_t bOutput)
+{
+    WavHeader *header = &pPlayer->header;
+    uint32_t skip;
+    uint32_t size;
+
+    if ((dwChunk < 4) || ((dwChunk & (dwChunk - 1)) != 0)
+        || (dwRingSize < dwChunk)
+        || RING_Initialize(&pPlayer->ring, pRing, dwRingSize)) {
+
+        TRACE_ERROR("WAV_PlayerOpen: Bad ring or chunk size\n\r");
+        return 3;
+    }
+
+    if (read(pContext, (uint8_t *)header, WAV_HEADER_SIZE) != WAV_HEADER_SIZE) {
+
+        TRACE_ERROR("WAV_PlayerOpen: File too short\n\r");
+        return 1;
+    }
+    if (!WAV_IsValid(header) || (header->audioFormat != 1)
+        || (header->numChannels < 1) || (header->numChannels > 2)
+        || ((header->bitsPerSample != 8) && (header->bitsPerSample != 16))
+        || (header->blockAlign != header->numChannels * header->bitsPerSample / 8)) {
+
+        TRACE_ERROR("WAV_PlayerOpen: Format not supported\n\r");
+        return 2;
+    }
+
+    /* Skip "LIST" and other chunks, using the ring as scratch */
+    while (header->subchunk2ID != WAV_DATAID) {
+
+        skip = (header->subchunk2Size + 1) & ~1;
+        while (skip) {
+
+            size = (skip < dwRingSize) ? skip : dwRingSize;
+            if (read(pContext, pRing, size) != size) {
+
+                TRACE_ERROR("WAV_PlayerOpen: No data chunk\n\r");
+                return 1;
+            }
+            skip -= size;
+        }
+        if (read(pContext, (uint8_t *)&header->subchunk2ID, 8) != 8) {
+
+            TRACE_ERROR("WAV_PlayerOpen: No data chunk\n\r");
+            return 1;
+        }
+    }
+
+    pPlayer->read = read;
+    pPlayer->pContext = pContext;
+    pPlayer->dwChunk = dwChunk;
+    pPlayer->dwRemaining = header->subchunk2Size;
+    pPlayer->bOutput = bOutput;
+    pPlayer->bStarved = 0;
+    pPlayer->dwFrames = 0;
+    pPlayer->dwUnderruns = 0;
+    pPlayer->dwSilence = 0;
+    pPlayer->dwLowWater = dwRingSize;
+    pPlayer->dwReadMax = 0;
+
+    return 0;
+}
+
+/**
+ * \brief Reads ahead as many chunks as the ring can take. Called from the
+ * task (main loop) only; a read that comes short ends the file.
+ *
+ * \param pPlayer  Player opened by WAV_PlayerOpen().
+ * \return Number of bytes read.
+ */
+uint32_t WAV_PlayerFill(WavPlayer *pPlayer)
+{
+    uint32_t total = 0;
+    uint32_t remaining;
+    uint32_t size;
+    uint32_t got;
+    uint32_t ticks;
+    uint8_t *pData;
+
+    while ((remaining = pPlayer->dwRemaining) != 0) {
+
+        /* Whole chunks only, so that reads stay sector aligned */
+        size = RING_Reserve(&pPlayer->ring, &pData);
+        if (size > pPlayer->dwChunk) {
+
+            size = pPlayer->dwChunk;
+        }
+        if (size > remaining) {
+
+            size = remaining;
+        }
+        else if (size < pPlayer->dwChunk) {
+
+            break;
+        }
+
+        ticks = GetTickCount();
+        got = pPlayer->read(pPlayer->pContext, pData, size);
+        ticks = GetTickCount() - ticks;
+        if (ticks > pPlayer->dwReadMax) {
+
+            pPlayer->dwReadMax = ticks;
+        }
+
+        RING_Commit(&pPlayer->ring, got);
+        total += got;
+        if (got != size) {
+
+            TRACE_WARNING("WAV_PlayerFill: Read error, %u bytes lost\n\r",
+                          (unsigned int)(remaining - got));
+            pPlayer->dwRemaining = 0;
+            break;
+        }
+        pPlayer->dwRemaining = remaining - got;
+    }
+
+    return total;
+}
+
+/**
+ * \brief Returns 1 once every frame of the file has been sent to the output.
+ */
+uint8_t WAV_PlayerIsDone(WavPlayer *pPlayer)
+{
+    return (pPlayer->dwRemaining == 0)
+           && (RING_GetCount(&pPlayer->ring) < pPlayer->header.blockAlign);
+}
+
+/**
+ * \brief Converts the read-ahead data into the free transmit buffers of a
+ * SSC stream configured for 16-bit words (WM8731 in 16-bit I2S).
+ *
+ * Only whole buffers are queued, except the last one of the file, so the
+ * stream never sends a partial buffer in the middle of the file. An
+ * underrun is counted when the stream has run dry while the ring lacks a
+ * buffer worth of data. Call it after WAV_PlayerFill() in the task, or from
+ * the SSC interrupt after SSC_StreamHandler(), but from one context only.
+ *
+ * \param pPlayer  Player opened with WAV_OUTPUT_SSC16.
+ * \param pStream  Started SSC stream.
+ * \return Number of frames queued.
+ */
+uint32_t WAV_PlayerSscFill(WavPlayer *pPlayer, SscStream *pStream)
+{
+    uint32_t frames = pStream->tx.dwBufferSize / 4;
+    uint32_t total = 0;
+    uint32_t done;
+    uint8_t *pBuffer;
+
+    while ((pBuffer = SSC_StreamGetTxBuffer(pStream)) != 0) {
+
+        if ((pPlayer->dwRemaining != 0)
+            && (RING_GetCount(&pPlayer->ring) < frames * pPlayer->header.blockAlign)) {
+
+            if ((pStream->tx.dwApp == pStream->tx.dwDone) && !pPlayer->bStarved) {
+
+                pPlayer->bStarved = 1;
+                pPlayer->dwUnderruns++;
+            }
+            break;
+        }
+
+        done = _WAV_Drain(pPlayer, pBuffer, frames);
+        if (done == 0) {
+
+            break;
+        }
+        pPlayer->bStarved = 0;
+        SSC_StreamCommitTx(pStream, done * 4);
+        total += done;
+    }
+
+    return total;
+}
+
+/**
+ * \brief DaccStreamFill function playing a file, pArgument being a player
+ * opened with WAV_OUTPUT_DACC12: give it to DACC_StreamStart().
+ *
+ * Runs in the DACC interrupt. When the ring runs dry before the end of the
+ * file the bank is completed with mid-scale samples, counted in dwSilence,
+ * and one underrun is counted per gap.
+ */
+void WAV_PlayerDaccFill(void *pArgument, uint16_t *pwBank, uint32_t dwSize)
+{
+    WavPlayer *pPlayer = (WavPlayer *)pArgument;
+    uint32_t done = _WAV_Drain(pPlayer, pwBank, dwSize);
+    uint32_t missing = dwSize - done;
+
+    if (missing == 0) {
+
+        pPlayer->bStarved = 0;
+        return;
+    }
+
+    if (pPlayer->dwRemaining != 0) {
+
+        if (!pPlayer->bStarved) {
+
+            pPlayer->bStarved = 1;
+            pPlayer->dwUnderruns++;
+        }
+        pPlayer->dwSilence += missing;
+    }
+
+    pwBank += done;
+    while (missing--) {
+
+        *pwBank++ = 0x800;
+    }
+}
+
+/**
+ * \brief MixerReadFunc playing a file, pArgument being a player opened with
+ * WAV_OUTPUT_SSC16: give it to MIXER_Add(). Underruns are counted as for
+ * WAV_PlayerDaccFill(), the mixer completing the block with silence.
+ */
+uint32_t WAV_PlayerRead(void *pArgument, int16_t *psFrames, uint32_t dwFrames)
+{
+    WavPlayer *pPlayer = (WavPlayer *)pArgument;
+    uint32_t done = _WAV_Drain(pPlayer, psFrames, dwFrames);
+
+    if (done == dwFrames) {
+
+        pPlayer->bStarved = 0;
+    }
+    else if (pPlayer->dwRemaining != 0) {
+
+        if (!pPlayer->bStarved) {
+
+            pPlayer->bStarved = 1;
+            pPlayer->dwUnderruns++;
+        }
+        pPlayer->dwSilence += dwFrames - done;
+    }
+
+    return done;
+}
@@ -3,7 +3,7 @@
 CROSS_COMPILE = arm-none-eabi-
 
 # Compilation tools
-AR = $(CROSS_COMPILE)ar
+AR = $(CROSS_COMPILE)$(ARCHIVER)
 CC = $(CROSS_COMPILE)gcc
 AS = $(CROSS_COMPILE)as
 #LD = $(CROSS_COMPILE)ld
@@ -13,6 +13,10 @@ NM = $(CROSS_COMPILE)nm
 
 # Flags
 
+# Long calls and archiver, replaced by perf.mk
+LONG_CALLS ?= -mlong-calls
+ARCHIVER ?= ar
+
 CFLAGS += -Wall -Wchar-subscripts -Wcomment -Wformat=2 -Wimplicit-int
 CFLAGS += -Werror-implicit-function-declaration -Wmain -Wparentheses
 CFLAGS += -Wsequence-point -Wreturn-type -Wswitch -Wtrigraphs -Wunused
@@ -30,6 +34,6 @@ CFLAGS += -Wcast-align
 # To reduce application size use only integer printf function.
 CFLAGS += -Dprintf=iprintf
 
-CFLAGS += --param max-inline-insns-single=500 -mcpu=cortex-m3 -mthumb -mlong-calls -ffunction-sections
+CFLAGS += --param max-inline-insns-single=500 -mcpu=cortex-m3 -mthumb $(LONG_CALLS) -ffunction-sections
 CFLAGS += $(OPTIMIZATION) $(INCLUDES) -D$(CHIP) -DTRACE_LEVEL=$(TRACE_LEVEL)
 ASFLAGS = -mcpu=cortex-m3 -mthumb -Wall -g $(OPTIMIZATION) $(INCLUDES) -D$(CHIP) -D__ASSEMBLY__
@@ -0,0 +1,27 @@
+# Performance build: 'make perf', giving the *_perf.a libraries.
+#
+# Link-time optimization across libchip, libboard, usb and memories, and
+# across the application and FatFs when the example is built with PERF=1
+# too. Calls are direct BL: the linker adds a veneer where a branch does not
+# reach (flash <-> SRAM), the RAM functions (IRQ_RAMFUNC, FLASHD_RAMFUNC...)
+# being declared long_call. The archives are made with gcc-ar so that the
+# LTO plugin indexes them.
+
+# Trace level used for compilation
+# (can be overriden by adding TRACE_LEVEL=#number to the command-line)
+# TRACE_LEVEL_DEBUG      5
+# TRACE_LEVEL_INFO       4
+# TRACE_LEVEL_WARNING    3
+# TRACE_LEVEL_ERROR      2
+# TRACE_LEVEL_FATAL      1
+# TRACE_LEVEL_NO_TRACE   0
+TRACE_LEVEL = 1
+
+# Optimization level
+OPTIMIZATION = -O2 -flto -ffat-lto-objects
+
+# No -mlong-calls
+LONG_CALLS =
+
+# Archiver with the LTO plugin
+ARCHIVER = gcc-ar
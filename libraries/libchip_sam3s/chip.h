@@ -45,28 +45,43 @@
 #include "include/acc.h"
 #include "include/adc.h"
 #include "include/async.h"
+#include "include/bitmap.h"
+#include "include/bus.h"
 #include "include/crccu.h"
 #include "include/dacc.h"
+#include "include/dwt.h"
 #include "include/efc.h"
 #include "include/flashd.h"
+#include "include/fwupdate.h"
 #include "include/hsmci.h"
+#include "include/ioevent.h"
+#include "include/itm.h"
+#include "include/memops.h"
+#include "include/mempool.h"
+#include "include/pcsamp.h"
 #include "include/pio.h"
 #include "include/pio_it.h"
 #include "include/pio_capture.h"
 #include "include/pmc.h"
+#include "include/prof.h"
 #include "include/pwmc.h"
+#include "include/ringbuf.h"
 #include "include/rtc.h"
 #include "include/rtt.h"
 #include "include/spi.h"
 #include "include/spi_pdc.h"
+#include "include/spis.h"
 #include "include/ssc.h"
 #include "include/tc.h"
 #include "include/twi.h"
 #include "include/twid.h"
+#include "include/twis.h"
 #include "include/usart.h"
+#include "include/warmboot.h"
 //#include "include/USBD_Config.h"
 
 #include "include/trace.h"
 #include "include/wdt.h"
+#include "include/workq.h"
 
 #endif /* _LIB_SAM3S_ */
@@ -165,18 +165,24 @@
  *      @{
  * This page lists the definitions for USB Audio Speaker Device Driver.
  * - \ref AUDDSpeakerDriverDescriptors_DATAOUT
+ * - \ref AUDDSpeakerDriverDescriptors_FEEDBACK
  * - \ref AUDDSpeakerDriverDescriptors_FS_INTERVAL
  * - \ref AUDDSpeakerDriverDescriptors_HS_INTERVAL
+ * - \ref AUDDSpeakerDriverDescriptors_FS_REFRESH
  *
  * \note for UDP, uses IN EPs that support double buffer; for UDPHS, uses
  *       IN EPs that support DMA and High bandwidth.
  */
 /** Data out endpoint number. */
 #define AUDDSpeakerDriverDescriptors_DATAOUT            0x04
+/** Feedback in endpoint number (asynchronous stream). */
+#define AUDDSpeakerDriverDescriptors_FEEDBACK           0x05
 /** Endpoint polling interval 2^(x-1) * 125us */
 #define AUDDSpeakerDriverDescriptors_HS_INTERVAL        0x04
 /** Endpoint polling interval 2^(x-1) * ms */
 #define AUDDSpeakerDriverDescriptors_FS_INTERVAL        0x01
+/** Feedback refresh interval 2^x * ms */
+#define AUDDSpeakerDriverDescriptors_FS_REFRESH         0x02
 /**     @}*/
 
 /*----------------------------------------------------------------------------
@@ -43,6 +43,19 @@
  *  -# Wait the end of the conversion by polling status with ADC_GetStatus()
  *  -# Finally, get the converted data using ADC_GetConvertedData()
  *
+ *  For a continuous acquisition, configure the trigger (ADC_CfgTrigering(),
+ *  e.g. a TC output) and the sequence (ADC_CfgChannelMode()), then use
+ *  ADC_StreamInitialize() and ADC_StreamStart(), and call ADC_StreamHandler()
+ *  from ADC_IrqHandler(): the samples of each channel are delivered to the
+ *  stream callback, optionally decimated.
+ *  For a low power acquisition, configure a slow trigger (e.g. a TC channel
+ *  clocked by SLCK, TC_CMR_TCCLKS_TIMER_CLOCK5, toggling TIOA on RC compare)
+ *  and the startup time, then use ADC_MonitorInitialize() and
+ *  ADC_MonitorStart(), and call ADC_MonitorHandler() from ADC_IrqHandler().
+ *  The ADC sleeps between the conversions and the PDC batches the samples in
+ *  SRAM: the core, waiting in sleep mode (__WFI), is only woken up when a
+ *  batch is full or when a sample is out of the comparison window.
+ *
 */
 #ifndef _ADC_
 #define _ADC_
@@ -86,6 +99,92 @@
  extern "C" {
 #endif
 
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+struct _AdcStream ;
+
+/** Stream callback: receives the samples of one channel for one bank. */
+typedef void (*AdcStreamCallback)( struct _AdcStream* pStream, uint32_t dwChannel, uint16_t* pwSamples, uint32_t dwCount ) ;
+
+/**
+ * \brief Continuous ADC acquisition: the PDC fills two banks in turn, the
+ * handler re-arming each bank once it has been de-interleaved. The
+ * decimation is a boxcar (first order CIC) filter: each output sample is the
+ * sum of dwDecimation input samples, shifted right by bShift.
+ */
+typedef struct _AdcStream
+{
+    /** ADC peripheral */
+    Adc* pAdc ;
+    /** PDC buffer, two banks of dwBankSize samples */
+    uint16_t* pwBuffer ;
+    /** Samples per bank, a multiple of the number of channels */
+    uint32_t dwBankSize ;
+    /** Output buffer, dwBankSize / number of channels + 1 samples */
+    uint16_t* pwOutput ;
+    /** Number of channels in the sequence */
+    uint8_t bNumChannels ;
+    /** Channel of each sequence slot */
+    uint8_t pbChannels[16] ;
+    /** Right shift of the decimated sums */
+    uint8_t bShift ;
+    /** Decimation factor, 1 for none */
+    uint32_t dwDecimation ;
+    /** Number of samples in the accumulators */
+    uint32_t dwAccuCount ;
+    /** Accumulator of each sequence slot */
+    uint32_t pdwAccu[16] ;
+    /** Number of banks acquired */
+    volatile uint32_t dwBanks ;
+    /** Number of acquisition restarts after a sample loss */
+    volatile uint32_t dwOverruns ;
+    /** Function receiving the samples */
+    AdcStreamCallback callback ;
+    /** Argument of the callback */
+    void* pArgument ;
+} AdcStream ;
+
+struct _AdcMonitor ;
+
+/** Monitor event: a batch of samples is full */
+#define ADC_MONITOR_BATCH       (1u << 0)
+/** Monitor event: a sample of the compared channel is out of the window */
+#define ADC_MONITOR_OUT         (1u << 1)
+
+/** Monitor callback: receives a full batch, or the out of window sample. */
+typedef void (*AdcMonitorCallback)( struct _AdcMonitor* pMonitor, uint32_t dwEvent, uint16_t* pwSamples, uint32_t dwCount ) ;
+
+/**
+ * \brief Low power acquisition: the PDC fills two batches in turn while the
+ * core sleeps, the comparison window raising an event on out of band samples.
+ * The batches hold the raw ADC_LCDR values, the channels interleaved.
+ */
+typedef struct _AdcMonitor
+{
+    /** ADC peripheral */
+    Adc* pAdc ;
+    /** PDC buffer, two batches of dwBatchSize samples */
+    uint16_t* pwBuffer ;
+    /** Samples per batch */
+    uint32_t dwBatchSize ;
+    /** Compared channel, 16 for all the channels */
+    uint32_t dwCmpChannel ;
+    /** Number of batches acquired */
+    volatile uint32_t dwBatches ;
+    /** Number of out of window samples */
+    volatile uint32_t dwOutEvents ;
+    /** Last out of window sample */
+    volatile uint16_t wOutSample ;
+    /** ADC_MONITOR_xxx events not yet read by ADC_MonitorGetEvents() */
+    volatile uint32_t dwPending ;
+    /** Function receiving the events, NULL for none */
+    AdcMonitorCallback callback ;
+    /** Argument of the callback */
+    void* pArgument ;
+} AdcMonitor ;
+
 /*------------------------------------------------------------------------------
  *         Macros function of register access
  *------------------------------------------------------------------------------*/
@@ -150,6 +249,29 @@ extern uint32_t ADC_IsStatusSet( Adc* pAdc, uint32_t dwFlag ) ;
 extern uint32_t ADC_IsChannelInterruptStatusSet( uint32_t adc_sr, uint32_t dwChannel ) ;
 extern uint32_t ADC_ReadBuffer( Adc* pADC, int16_t *pwBuffer, uint32_t dwSize ) ;
 
+extern void ADC_StreamInitialize( AdcStream* pStream, Adc* pAdc, uint16_t* pwBuffer, uint32_t dwBankSize, uint16_t* pwOutput ) ;
+
+extern void ADC_StreamSetDecimation( AdcStream* pStream, uint32_t dwDecimation, uint8_t bShift ) ;
+
+extern void ADC_StreamStart( AdcStream* pStream, uint32_t dwChannels, AdcStreamCallback callback, void* pArgument ) ;
+
+extern void ADC_StreamStop( AdcStream* pStream ) ;
+
+extern void ADC_StreamHandler( AdcStream* pStream ) ;
+
+extern void ADC_MonitorInitialize( AdcMonitor* pMonitor, Adc* pAdc, uint16_t* pwBuffer, uint32_t dwBatchSize ) ;
+
+extern void ADC_MonitorStart( AdcMonitor* pMonitor, uint32_t dwChannels, uint32_t dwCmpChannel,
+                              uint16_t wLow, uint16_t wHigh, AdcMonitorCallback callback, void* pArgument ) ;
+
+extern void ADC_MonitorSetWindow( AdcMonitor* pMonitor, uint16_t wLow, uint16_t wHigh ) ;
+
+extern void ADC_MonitorStop( AdcMonitor* pMonitor ) ;
+
+extern void ADC_MonitorHandler( AdcMonitor* pMonitor ) ;
+
+extern uint32_t ADC_MonitorGetEvents( AdcMonitor* pMonitor ) ;
+
 #ifdef __cplusplus
 }
 #endif
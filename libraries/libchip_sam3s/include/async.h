@@ -48,6 +48,8 @@
  *----------------------------------------------------------------------------*/
 /** Transfer is still pending.*/
 #define ASYNC_STATUS_PENDING        0xFF
+/** Request could not be started, or a previous request of its chain failed.*/
+#define ASYNC_STATUS_ERROR          0xFE
 
 #ifdef __cplusplus
  extern "C" {
@@ -67,11 +69,59 @@ typedef struct _Async
     uint32_t pStorage[4] ;
 } Async ;
 
+struct _AsyncRequest ;
+
+/** Starts the operation of a request; returns 0 if it has been started.*/
+typedef uint8_t (*AsyncStart)( struct _AsyncRequest *pRequest ) ;
+
+/** Completion callback of a request.*/
+typedef void (*AsyncCallback)( struct _AsyncRequest *pRequest ) ;
+
+/**
+ * \brief Asynchronous request, common to the drivers. The driver operation
+ * is started by the start function; its completion callback reports to the
+ * request through ASYNC_StatusCallback() or ASYNC_MediaCallback(). Chained
+ * requests are started one after the other, without polling.
+ */
+typedef struct _AsyncRequest
+{
+    /** Request status: ASYNC_STATUS_PENDING, then the driver status.*/
+    volatile uint8_t status ;
+    /** Number of bytes transferred.*/
+    uint32_t transferred ;
+    /** Starts the driver operation of the request.*/
+    AsyncStart start ;
+    /** Optional function invoked when the request is complete.*/
+    AsyncCallback callback ;
+    /** Argument available to the start and callback functions.*/
+    void *pArgument ;
+    /** Optional request started once this one succeeded.*/
+    struct _AsyncRequest *pNext ;
+    /** Optional RTOS event signalled on completion (see ASYNC_SignalEvent()).*/
+    void *pEvent ;
+} AsyncRequest ;
+
 /*----------------------------------------------------------------------------
  *        Global functions
  *----------------------------------------------------------------------------*/
 extern uint32_t ASYNC_IsFinished( Async* pAsync ) ;
 
+extern void ASYNC_InitRequest( AsyncRequest* pRequest, AsyncStart start, void* pArgument ) ;
+
+extern void ASYNC_Chain( AsyncRequest* pRequest, AsyncRequest* pNext ) ;
+
+extern uint8_t ASYNC_Submit( AsyncRequest* pRequest ) ;
+
+extern void ASYNC_Complete( AsyncRequest* pRequest, uint8_t status, uint32_t transferred ) ;
+
+extern uint32_t ASYNC_IsRequestFinished( AsyncRequest* pRequest ) ;
+
+extern void ASYNC_StatusCallback( uint8_t status, void* pArgument ) ;
+
+extern void ASYNC_MediaCallback( void* pArgument, uint8_t status, uint32_t transferred, uint32_t remaining ) ;
+
+extern void ASYNC_SignalEvent( void* pEvent ) ;
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,154 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Bitmaps of flags updated through the Cortex-M3 bit-banding.
+ *
+ * A bitmap is an array of words, bit n being bit (n%32) of word n/32. When
+ * the bitmap lies in the bit-band SRAM region (0x20000000 to 0x200FFFFF,
+ * which covers the whole internal SRAM), setting or clearing a bit is a
+ * single store to its alias word. The update is atomic, so a bitmap shared
+ * with interrupt handlers needs no critical section. Bitmaps placed out of
+ * that region (external PSRAM) fall back to a read-modify-write with the
+ * interrupts masked.
+ *
+ */
+
+#ifndef _BITMAP_
+#define _BITMAP_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "chip.h"
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definition
+ *----------------------------------------------------------------------------*/
+/** Number of words of a bitmap of dwBits bits.*/
+#define BITMAP_WORDS( dwBits )            (((dwBits)+31)/32)
+
+/** Start of the SRAM bit-band region.*/
+#define BITMAP_BITBAND_BASE               0x20000000u
+/** Size of the SRAM bit-band region.*/
+#define BITMAP_BITBAND_SIZE               0x00100000u
+/** Start of the SRAM bit-band alias region.*/
+#define BITMAP_ALIAS_BASE                 0x22000000u
+
+/** Tells if a word can be accessed through the bit-band alias (can be
+    redefined to 0 where there is no bit-band, e.g. host builds).*/
+#if !defined(BITMAP_IS_BITBAND)
+#define BITMAP_IS_BITBAND( pdwWord )      (((uint32_t)(pdwWord)-BITMAP_BITBAND_BASE) < BITMAP_BITBAND_SIZE)
+#endif
+/** Alias word of bit dwBit (0 to 31) of a word of the bit-band region.*/
+#define BITMAP_ALIAS( pdwWord, dwBit )    ((volatile uint32_t*)(BITMAP_ALIAS_BASE+(((uint32_t)(pdwWord)-BITMAP_BITBAND_BASE)*32)+((dwBit)*4)))
+
+/** Value returned by BITMAP_FindFirst when no bit is set.*/
+#define BITMAP_NONE                       0xFFFFFFFFu
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Inline functions
+ *----------------------------------------------------------------------------*/
+/**
+ * \brief Sets a bit of a bitmap; can be called from an interrupt handler.
+ * \param pdwBitmap  Pointer to the bitmap.
+ * \param dwBit  Index of the bit.
+ */
+static __INLINE void BITMAP_Set( uint32_t* pdwBitmap, uint32_t dwBit )
+{
+    uint32_t* pdwWord = pdwBitmap + (dwBit >> 5) ;
+    uint32_t primask ;
+
+    if ( BITMAP_IS_BITBAND( pdwWord ) )
+    {
+        *BITMAP_ALIAS( pdwWord, dwBit & 0x1F ) = 1 ;
+    }
+    else
+    {
+        primask = __get_PRIMASK() ;
+        __disable_irq() ;
+        *pdwWord |= 1u << (dwBit & 0x1F) ;
+        __set_PRIMASK( primask ) ;
+    }
+}
+
+/**
+ * \brief Clears a bit of a bitmap; can be called from an interrupt handler.
+ * \param pdwBitmap  Pointer to the bitmap.
+ * \param dwBit  Index of the bit.
+ */
+static __INLINE void BITMAP_Clear( uint32_t* pdwBitmap, uint32_t dwBit )
+{
+    uint32_t* pdwWord = pdwBitmap + (dwBit >> 5) ;
+    uint32_t primask ;
+
+    if ( BITMAP_IS_BITBAND( pdwWord ) )
+    {
+        *BITMAP_ALIAS( pdwWord, dwBit & 0x1F ) = 0 ;
+    }
+    else
+    {
+        primask = __get_PRIMASK() ;
+        __disable_irq() ;
+        *pdwWord &= ~(1u << (dwBit & 0x1F)) ;
+        __set_PRIMASK( primask ) ;
+    }
+}
+
+/**
+ * \brief Tells if a bit of a bitmap is set.
+ * \param pdwBitmap  Pointer to the bitmap.
+ * \param dwBit  Index of the bit.
+ * \return 1 if the bit is set; otherwise returns 0.
+ */
+static __INLINE uint32_t BITMAP_Test( const uint32_t* pdwBitmap, uint32_t dwBit )
+{
+    return (pdwBitmap[dwBit >> 5] >> (dwBit & 0x1F)) & 1 ;
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+extern uint32_t BITMAP_FindFirst( const uint32_t* pdwBitmap, uint32_t dwStart, uint32_t dwBits ) ;
+
+extern uint32_t BITMAP_Count( const uint32_t* pdwBitmap, uint32_t dwBits ) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _BITMAP_ */
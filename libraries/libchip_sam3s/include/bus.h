@@ -0,0 +1,85 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Shared bus arbitration hooks.
+ *
+ * The drivers of the devices sharing a bus (the NAND flash and the LCD on the
+ * SMC, the devices of the SPI) call BUS_Acquire() before and BUS_Release()
+ * after each sequence of accesses which must not be interleaved with the
+ * accesses of another driver, e.g. while the NAND chip enable is asserted.
+ *
+ * Without an arbiter, as in the bare-metal examples, the calls do nothing.
+ * The RTOS glue sets an arbiter with BUS_SetArbiter(), usually a priority
+ * inheritance mutex per bus (BUSLOCK_ConnectBus(), FreeRTOS drivers,
+ * bus_lock.h). The arbiter must accept nested acquisitions by the same
+ * task. The hooks are called in task context only, never from an interrupt
+ * handler.
+ *
+ */
+
+#ifndef _BUS_
+#define _BUS_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definition
+ *----------------------------------------------------------------------------*/
+
+/** Static Memory Controller: NAND flash, LCD, PSRAM. */
+#define BUS_SMC         0
+/** SPI master. */
+#define BUS_SPI         1
+/** Number of arbitrated buses. */
+#define BUS_NUM         2
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Acquires or releases a bus, blocking the calling task until it is free. */
+typedef void (*BusArbiterFunc)( uint32_t dwBus ) ;
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern void BUS_SetArbiter( BusArbiterFunc fAcquire, BusArbiterFunc fRelease ) ;
+
+extern void BUS_Acquire( uint32_t dwBus ) ;
+
+extern void BUS_Release( uint32_t dwBus ) ;
+
+#endif /* #ifndef _BUS_ */
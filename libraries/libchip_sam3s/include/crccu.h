@@ -31,6 +31,18 @@
  * \file
  *
  * Interface for Cyclic Redundancy Check Calculation Unit (CRCCU).
+ *
+ * Besides the single block functions, the driver offers a CRC stream: after
+ * CRCCU_StreamStart() selects the polynomial, buffers of any length and
+ * location are queued with CRCCU_StreamAppend() or CRCCU_StreamAppendList(),
+ * and the CRCCU reads them by DMA one after the other, the end of transfer
+ * interrupt starting the next one. The CRC carries on from one buffer to the
+ * next until the stream is started again; CRCCU_StreamGetCrc() waits for the
+ * queued buffers and returns the running value. The buffers must stay
+ * unchanged until CRCCU_StreamIsIdle() returns 1.
+ *
+ * The CRC value cannot be loaded in the CRCCU, so a single stream runs at a
+ * time, and the single block functions must not be used meanwhile.
  */
 
 #ifndef _CRCCU_
@@ -53,6 +65,22 @@ typedef struct
     uint32_t TR_CTRL ;
 } CrcDscr ;
 
+/** Buffer of a scattered CRC computation. */
+typedef struct
+{
+    const void* pvData ;
+    uint32_t dwSize ;
+} CrcSegment ;
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of buffers the CRC stream can queue. */
+#ifndef CRCCU_STREAM_QUEUE_SIZE
+#define CRCCU_STREAM_QUEUE_SIZE  8
+#endif
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -61,5 +89,12 @@ extern void CRCCU_ResetCrcValue( Crccu* pCrccu ) ;
 extern void CRCCU_Configure( Crccu* pCrccu, uint32_t dwDscrAddr, uint32_t dwMode ) ;
 extern uint32_t CRCCU_ComputeCrc( Crccu* pCrccu ) ;
 
+extern void CRCCU_StreamStart( uint32_t dwPolynomial ) ;
+extern uint32_t CRCCU_StreamAppend( const void* pvData, uint32_t dwSize ) ;
+extern uint32_t CRCCU_StreamAppendList( const CrcSegment* pSegments, uint32_t dwCount ) ;
+extern uint32_t CRCCU_StreamIsIdle( void ) ;
+extern void CRCCU_StreamWait( void ) ;
+extern uint32_t CRCCU_StreamGetCrc( void ) ;
+
 #endif /* #ifndef _CRCCU_ */
 
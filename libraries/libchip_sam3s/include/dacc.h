@@ -43,6 +43,11 @@
  *  -# Wait the end of the conversion by polling status with DACC_GetStatus()
  *  -# Finally, get the converted data using DACC_GetConvertedData()
  *
+ *  For a waveform output, trigger the DACC with a TC (DACC_Initialize()),
+ *  start a DaccStream with DACC_StreamStart() and call DACC_StreamHandler()
+ *  from DAC_IrqHandler(). The idle bank is refilled by the stream callback,
+ *  e.g. DACC_DdsStreamFill() for a table synthesizer, or replayed as is.
+ *
 */
 #ifndef _DACC_
 #define _DACC_
@@ -65,6 +70,55 @@
  extern "C" {
 #endif
 
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+/** Stream callback: fills a bank of dwSize samples to convert. */
+typedef void (*DaccStreamFill)( void* pArgument, uint16_t* pwBank, uint32_t dwSize ) ;
+
+/**
+ * \brief Continuous DACC output: the PDC plays two banks in turn, the
+ * handler refilling and re-arming each bank once it has been played.
+ */
+typedef struct _DaccStream
+{
+    /** DACC peripheral */
+    Dacc* pDacc ;
+    /** PDC buffer, two banks of dwBankSize samples */
+    uint16_t* pwBuffer ;
+    /** Samples per bank */
+    uint32_t dwBankSize ;
+    /** Number of banks played */
+    volatile uint32_t dwBanks ;
+    /** Number of restarts after both banks were played (gap in the output) */
+    volatile uint32_t dwUnderruns ;
+    /** Optional fill function; without it the banks are replayed as is */
+    DaccStreamFill fill ;
+    /** Argument of the fill function */
+    void* pArgument ;
+} DaccStream ;
+
+/**
+ * \brief Table synthesizer (DDS): a 32-bit phase accumulator indexes a table
+ * of 2^bTableBits signed samples, scaled by a Q15 gain around an offset.
+ */
+typedef struct _DaccDds
+{
+    /** One period of the waveform */
+    const int16_t* pwTable ;
+    /** log2 of the table size */
+    uint8_t bTableBits ;
+    /** Output offset (mid-scale) */
+    uint16_t wOffset ;
+    /** Gain in Q15 */
+    int32_t lGain ;
+    /** Phase accumulator */
+    uint32_t dwPhase ;
+    /** Phase increment per sample */
+    uint32_t dwIncrement ;
+} DaccDds ;
+
 /*------------------------------------------------------------------------------
  *         Macros function of register access
  *------------------------------------------------------------------------------*/
@@ -139,6 +193,18 @@ extern void DACC_SetConversionData( Dacc* pDACC, uint32_t dwData ) ;
 
 extern uint32_t DACC_WriteBuffer( Dacc* pDACC, uint16_t* pwBuffer, uint32_t dwSize ) ;
 
+extern void DACC_StreamStart( DaccStream* pStream, Dacc* pDACC, uint16_t* pwBuffer, uint32_t dwBankSize, DaccStreamFill fill, void* pArgument ) ;
+
+extern void DACC_StreamStop( DaccStream* pStream ) ;
+
+extern void DACC_StreamHandler( DaccStream* pStream ) ;
+
+extern void DACC_DdsInitialize( DaccDds* pDds, const int16_t* pwTable, uint8_t bTableBits, int32_t lGain, uint16_t wOffset ) ;
+
+extern void DACC_DdsSetFrequency( DaccDds* pDds, uint32_t dwFrequency, uint32_t dwSampleRate ) ;
+
+extern void DACC_DdsStreamFill( void* pArgument, uint16_t* pwBank, uint32_t dwSize ) ;
+
 #ifdef __cplusplus
 }
 #endif
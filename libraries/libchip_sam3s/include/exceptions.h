@@ -35,6 +35,28 @@
 #ifndef _EXCEPTIONS_
 #define _EXCEPTIONS_
 
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/* Hot interrupt handlers are placed in SRAM (.ramfunc, copied by the
+   startup) unless IRQ_RAMFUNC_ENABLE is defined to 0: their latency then
+   depends neither on the flash wait states nor on a flash programming in
+   progress. */
+#if !defined(IRQ_RAMFUNC_ENABLE)
+#define IRQ_RAMFUNC_ENABLE  1
+#endif
+
+#if (IRQ_RAMFUNC_ENABLE == 1)
+#if defined ( __ICCARM__ )
+#define IRQ_RAMFUNC __ramfunc /* IAR */
+#else
+#define IRQ_RAMFUNC __attribute__ ((section (".ramfunc"), noinline, long_call)) // GCC
+#endif
+#else
+#define IRQ_RAMFUNC
+#endif
+
 /*----------------------------------------------------------------------------
  *        Types
  *----------------------------------------------------------------------------*/
@@ -53,6 +53,14 @@ extern uint32_t FLASHD_Erase( uint32_t dwAddress ) ;
 
 extern uint32_t FLASHD_Write( uint32_t dwAddress, const void *pvBuffer, uint32_t dwSize ) ;
 
+extern uint32_t FLASHD_WriteBuffered( uint32_t dwAddress, const void *pvBuffer, uint32_t dwSize ) ;
+
+extern uint32_t FLASHD_Flush( void ) ;
+
+extern uint32_t FLASHD_WriteNoErase( uint32_t dwAddress, const void *pvBuffer, uint32_t dwSize ) ;
+
+extern uint32_t FLASHD_ErasePages( uint32_t dwAddress, uint32_t dwSize ) ;
+
 extern uint32_t FLASHD_Lock( uint32_t dwStart, uint32_t dwEnd, uint32_t *pdwActualStart, uint32_t *pdwActualEnd ) ;
 
 extern uint32_t FLASHD_Unlock( uint32_t dwStart, uint32_t dwEnd, uint32_t *pdwActualStart, uint32_t *pdwActualEnd ) ;
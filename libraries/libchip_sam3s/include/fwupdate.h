@@ -0,0 +1,114 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Safe internal flash firmware update.
+ *
+ * The new image is streamed chunk by chunk into the staging half of the
+ * internal flash while the running firmware keeps executing from the lower
+ * half:
+ * <ul>
+ * <li> FWUPD_Begin() gives the image size and its expected CRC.</li>
+ * <li> FWUPD_Write() is called with each chunk, of any size, as it arrives from
+ *    the CDC, MSD or FatFs source. Chunks are merged into whole page programs
+ *    by FLASHD_WriteBuffered(), and every programmed page is handed to the
+ *    CRCCU, which reads it back from the flash by DMA while the caller fetches
+ *    the next chunk.</li>
+ * <li> FWUPD_End() programs the last page and checks the CRC of the staged
+ *    image.</li>
+ * <li> FWUPD_Install() copies the staged image over the running one from RAM,
+ *    verifies it and resets the chip.</li>
+ * </ul>
+ * No RAM copy of the image is needed. To overlap the chunk transfers with the
+ * page programs, queue the transfer of the next chunk (e.g. USBD_Read() in a
+ * second buffer) before calling FWUPD_Write() with the current one.
+ *
+ * The SAM3S has a single flash bank, so the boot bank cannot be swapped.
+ * Instead, FWUPD_Install() clears GPNVM bit 1 before overwriting the running
+ * image, so that a reset or power loss during the copy boots the SAM-BA
+ * monitor from ROM instead of a partial image, and sets it back with
+ * FLASHD_SetGPNVM() once the copy is verified. The running firmware must then
+ * fit in the lower half of the flash: FWUPD_Begin() refuses to stage over it.
+ *
+ * The expected CRC is the value of CRCCU_SR after a CRC-32 (CCIT802.3
+ * polynomial) computation over the whole image, starting from the reset value.
+ * As the CRCCU does not complement its result, it is the bitwise complement of
+ * the usual CRC-32 (zlib crc32()) of the image.
+ *
+ * FLASHD_Initialize() must have been called before FWUPD_Begin(), and the flash
+ * driver must not be used for anything else during the update.
+ */
+
+#ifndef _FWUPDATE_
+#define _FWUPDATE_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Start address of the staging area, a page boundary. */
+#ifndef FWUPD_STAGING_ADDR
+#define FWUPD_STAGING_ADDR  (IFLASH_ADDR + IFLASH_SIZE/2)
+#endif
+
+/** Largest image size. */
+#define FWUPD_MAX_IMAGE_SIZE  (IFLASH_ADDR + IFLASH_SIZE - FWUPD_STAGING_ADDR)
+
+/** Return codes. */
+#define FWUPD_OK            0
+#define FWUPD_ERROR_SIZE    1   /**< Image too large, or more data than announced */
+#define FWUPD_ERROR_STATE   2   /**< Call out of the Begin/Write/End sequence */
+#define FWUPD_ERROR_FLASH   3   /**< Page program or unlock failed */
+#define FWUPD_ERROR_CRC     4   /**< Staged image CRC mismatch */
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern uint32_t FWUPD_Begin( uint32_t dwImageSize, uint32_t dwImageCrc ) ;
+
+extern uint32_t FWUPD_Write( const void* pvData, uint32_t dwSize ) ;
+
+extern uint32_t FWUPD_End( void ) ;
+
+extern void FWUPD_Abort( void ) ;
+
+extern uint32_t FWUPD_GetWrittenSize( void ) ;
+
+extern void FWUPD_Install( void ) ;
+
+#endif /* #ifndef _FWUPDATE_ */
+
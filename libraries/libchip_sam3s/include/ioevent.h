@@ -0,0 +1,92 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * I/O event notification.
+ *
+ * The drivers raise an event bit when an I/O source becomes ready; the bits
+ * go to a single sink, set by the application or the RTOS glue, which
+ * usually sets them in event flags a task is waiting for. A gateway task can
+ * then sleep until any of its sources is ready, instead of polling them:
+ * <ul>
+ * <li> FreeRTOS: EVF_ConnectIoEvents() (FreeRTOS drivers, event_flags.h).</li>
+ * <li> CoOS: a sink calling isr_SetFlag() for each raised bit, each bit being
+ *    mapped to a flag created by CoCreateFlag(); the task waits with
+ *    CoWaitForMultipleFlags( flags, OPT_WAIT_ANY, timeout, &err ).</li>
+ * </ul>
+ *
+ * The bits below IOEVT_USER are raised by the libraries themselves. The
+ * completion of a USB transfer (USBD_Read(), CDCDSerialDriver_Read(), ...) or
+ * of a Media access (MED_Read(), MED_Write()) raises the bits given as
+ * argument when IOEVT_TransferCallback() is used as callback, e.g.:
+ * \code
+ * CDCDSerialDriver_Read( aBuffer, sizeof( aBuffer ), IOEVT_TransferCallback, (void*)IOEVT_USER ) ;
+ * \endcode
+ *
+ */
+
+#ifndef _IOEVENT_
+#define _IOEVENT_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definition
+ *----------------------------------------------------------------------------*/
+
+/** The USB device state changed (see USBD_GetState()). */
+#define IOEVT_USB_STATE   (1u << 0)
+/** A character was received by the buffered console (UART_EnableRxBuffer()). */
+#define IOEVT_CONSOLE_RX  (1u << 1)
+/** First bit free for the application. */
+#define IOEVT_USER        (1u << 8)
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Receives the raised bits, possibly from an interrupt handler. */
+typedef void (*IoEventSink)( uint32_t dwEvents ) ;
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern void IOEVT_SetSink( IoEventSink fSink ) ;
+
+extern void IOEVT_Raise( uint32_t dwEvents ) ;
+
+extern void IOEVT_TransferCallback( void* pArg, uint8_t bStatus, uint32_t dwTransferred, uint32_t dwRemaining ) ;
+
+#endif /* #ifndef _IOEVENT_ */
@@ -0,0 +1,104 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Instrumentation Trace Macrocell output on the Serial Wire Output pin.
+ *
+ * ITM_Configure() routes the ITM stimulus ports to the SWO pin (TDO/PB5),
+ * in NRZ (UART) mode at a baud rate up to MCK/2: the TPIU formatter is
+ * bypassed and the prescaler divides the core clock. A write to a stimulus
+ * port costs a few cycles: the core only waits when the ITM FIFO is full,
+ * which at a few MBd is rare. When no debugger has enabled the trace (no
+ * TRCENA, or port disabled), the writes are discarded at once.
+ *
+ * Each write is sent in a packet: a header byte (port << 3 | size code)
+ * then 1, 2 or 4 bytes little endian, so several ports can share the pin;
+ * the host demultiplexes them (tracebin.py --itm). openOCD/sam3s_swo.cfg
+ * captures the pin to a file with the debug probe.
+ *
+ */
+
+#ifndef _ITM_
+#define _ITM_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "chip.h"
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definition
+ *----------------------------------------------------------------------------*/
+
+/** Stimulus port of the text traces, as ITM_SendChar(). */
+#define ITM_PORT_TEXT           0
+/** Stimulus port of the binary traces. */
+#define ITM_PORT_BINARY         1
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+extern uint32_t ITM_Configure( uint32_t dwSwoBaud, uint32_t dwMck, uint32_t dwPorts ) ;
+
+extern void ITM_Write( uint32_t dwPort, const uint8_t* pucData, uint32_t dwSize ) ;
+
+/**
+ * \brief Tells whether the writes to a stimulus port are sent.
+ */
+static inline uint32_t ITM_IsEnabled( uint32_t dwPort )
+{
+    return ((CoreDebug->DEMCR & CoreDebug_DEMCR_TRCENA_Msk) != 0)
+        && ((ITM->TCR & ITM_TCR_ITMENA_Msk) != 0)
+        && ((ITM->TER & (1u << dwPort)) != 0) ;
+}
+
+/**
+ * \brief Sends a word on an enabled stimulus port, waiting for room in the
+ * ITM FIFO.
+ */
+static inline void ITM_WriteWord( uint32_t dwPort, uint32_t dwWord )
+{
+    while ( ITM->PORT[dwPort].u32 == 0 ) ;
+    ITM->PORT[dwPort].u32 = dwWord ;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _ITM_ */
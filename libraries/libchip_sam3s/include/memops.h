@@ -0,0 +1,73 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Memory copy and fill primitives tuned for the Cortex-M3.
+ *
+ * MEM_Copy() and MEM_Set() are drop-in replacements for memcpy() and
+ * memset(). The destination is aligned on a word first; when the source is
+ * aligned too, the bulk moves by bursts of 32 bytes with LDM/STM, otherwise by
+ * unaligned word loads, which the Cortex-M3 supports. The remaining bytes are
+ * moved one by one. MEM_Zero() is the zeroing fast path, used to clear the
+ * page and sector buffers.
+ *
+ * The bursts are written in inline assembly for GCC; other compilers use an
+ * unrolled word loop. The mem_bench example compares the primitives with the
+ * C library ones.
+ *
+ */
+
+#ifndef _MEMOPS_
+#define _MEMOPS_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include <stdint.h>
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+extern void* MEM_Copy( void* pDst, const void* pSrc, uint32_t dwSize ) ;
+
+extern void* MEM_Set( void* pDst, uint8_t ucValue, uint32_t dwSize ) ;
+
+extern void MEM_Zero( void* pDst, uint32_t dwSize ) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _MEMOPS_ */
@@ -0,0 +1,111 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Fixed-size block pools.
+ *
+ * A pool hands out blocks of a single size, carved out of a storage area
+ * given by the application, in constant time and without fragmentation.
+ * The free blocks are chained through their first word. Allocating and
+ * releasing a block only masks the interrupts for a few instructions, so
+ * pools can be used from the interrupt handlers and with or without an RTOS.
+ *
+ * Drivers drawing their transfer buffers from a pool (CDCDSerialBridge,
+ * MEDNandFlash) can share one pool set up by the application, so that the
+ * RAM of a function is only used while that function runs. The high-water
+ * mark of a pool gives the number of blocks it actually needs.
+ *
+ */
+
+#ifndef _MEMPOOL_
+#define _MEMPOOL_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definition
+ *----------------------------------------------------------------------------*/
+/** Number of words of the storage of dwCount blocks of dwBlockSize bytes.*/
+#define MEMPOOL_STORAGE_WORDS( dwBlockSize, dwCount )  ((((dwBlockSize)+3)/4)*(dwCount))
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Type
+ *----------------------------------------------------------------------------*/
+/** \brief Fixed-size block pool; use the MEMPOOL functions to access it. */
+typedef struct _MemPool
+{
+    /** First free block, 0 when the pool is exhausted.*/
+    void* pFree ;
+    /** Storage of the blocks.*/
+    uint8_t* pStart ;
+    /** End of the storage.*/
+    uint8_t* pEnd ;
+    /** Size of a block in bytes, multiple of 4.*/
+    uint32_t dwBlockSize ;
+    /** Number of blocks of the pool.*/
+    uint16_t wCount ;
+    /** Number of blocks currently allocated.*/
+    uint16_t wUsed ;
+    /** Highest number of blocks allocated at the same time.*/
+    uint16_t wHighWater ;
+    /** Number of allocations which failed, the pool being exhausted.*/
+    uint16_t wFailures ;
+} MemPool ;
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+extern uint32_t MEMPOOL_Initialize( MemPool* pPool, uint32_t* pStorage, uint32_t dwBlockSize, uint32_t dwCount ) ;
+
+extern void* MEMPOOL_Alloc( MemPool* pPool ) ;
+
+extern uint32_t MEMPOOL_Free( MemPool* pPool, void* pBlock ) ;
+
+extern uint32_t MEMPOOL_GetBlockSize( MemPool* pPool ) ;
+
+extern uint32_t MEMPOOL_GetFreeCount( MemPool* pPool ) ;
+
+extern uint32_t MEMPOOL_GetHighWater( MemPool* pPool ) ;
+
+extern void MEMPOOL_ResetHighWater( MemPool* pPool ) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _MEMPOOL_ */
@@ -0,0 +1,151 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Statistical PC-sampling profiler.
+ *
+ * A TC channel interrupts the core at a given rate; its handler reads the
+ * PC (and optionally the LR) stacked in the exception frame of the
+ * interrupted code, thread or handler, and counts it in a hash table in RAM.
+ * Unlike the DWT probes of prof.h, no code needs to be instrumented: the
+ * samples show where the time goes in libjpeg, FatFs, the USB stack or the
+ * application, on the hardware as deployed.
+ *
+ * The sampling period is dithered by up to 1/8 from a pseudo-random sequence,
+ * so that code running at a multiple of the sampling rate is not aliased.
+ * The handler runs at the highest priority by default, so that the
+ * interrupt handlers are sampled too; it costs a few tens of cycles.
+ *
+ * PCSAMP_Dump() sends the table in a binary frame through any byte writer
+ * (UART console, CDC serial). The frame starts with the "PCSM" signature, so
+ * that it can be found in a console log, and ends with a CRC-16;
+ * libraries/libchip_sam3s/source/pcsamp.py decodes it and symbolizes the
+ * addresses against the ELF file of the application. The frame layout, all
+ * fields little-endian:
+ * \code
+ * Header, 24 bytes:
+ *   0  char[4]   "PCSM"
+ *   4  uint8_t   format version (PCSAMP_VERSION)
+ *   5  uint8_t   flags given to PCSAMP_Start()
+ *   6  uint16_t  size of a record (PCSAMP_RECORD_SIZE)
+ *   8  uint32_t  sampling rate in Hz
+ *  12  uint32_t  samples taken since the last PCSAMP_Reset()
+ *  16  uint32_t  samples not counted, the table being full
+ *  20  uint16_t  number of records
+ *  22  uint16_t  reserved, 0
+ * Record, 12 bytes:
+ *   0  uint32_t  PC
+ *   4  uint32_t  LR, 0 without PCSAMP_FLAG_LR
+ *   8  uint32_t  number of samples
+ * Trailer:
+ *   0  uint16_t  CRC-16/CCITT (0x1021, initial 0xFFFF) of header and records
+ * \endcode
+ *
+ */
+
+#ifndef _PCSAMP_
+#define _PCSAMP_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definition
+ *----------------------------------------------------------------------------*/
+
+/** Number of entries of the hash table, power of two (12 bytes each). */
+#ifndef PCSAMP_TABLE_SIZE
+#define PCSAMP_TABLE_SIZE       256
+#endif
+
+/** Entries probed for a free one before a sample is dropped. */
+#ifndef PCSAMP_MAX_PROBES
+#define PCSAMP_MAX_PROBES       8
+#endif
+
+/** TC channel of the sampling timer, and its interrupt. */
+#ifndef PCSAMP_TC
+#define PCSAMP_TC               TC0
+#define PCSAMP_TC_CHANNEL       1
+#define PCSAMP_TC_ID            ID_TC1
+#define PCSAMP_TC_IRQn          TC1_IRQn
+#define PCSAMP_TC_HANDLER       TC1_IrqHandler
+#endif
+
+/** Priority of the sampling interrupt: the handlers of lower or equal
+    priority are sampled. */
+#ifndef PCSAMP_TC_PRIORITY
+#define PCSAMP_TC_PRIORITY      0
+#endif
+
+/** Flag of PCSAMP_Start(): counts the (PC, LR) pairs instead of the PCs,
+    giving the caller of the leaf functions (memcpy, ...). */
+#define PCSAMP_FLAG_LR          0x01
+
+/** Version of the binary frame. */
+#define PCSAMP_VERSION          1
+/** Size of the frame header. */
+#define PCSAMP_HEADER_SIZE      24
+/** Size of a record. */
+#define PCSAMP_RECORD_SIZE      12
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Byte writer used to send a dump, e.g. a loop over UART_PutChar(). */
+typedef void (*PcSampWrite)( const uint8_t* pData, uint32_t dwSize ) ;
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+extern uint32_t PCSAMP_Start( uint32_t dwRate, uint32_t dwFlags, uint32_t dwMck ) ;
+
+extern void PCSAMP_Stop( void ) ;
+
+extern void PCSAMP_Reset( void ) ;
+
+extern void PCSAMP_Sample( const uint32_t* pdwFrame ) ;
+
+extern uint32_t PCSAMP_Dump( PcSampWrite fWrite ) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _PCSAMP_ */
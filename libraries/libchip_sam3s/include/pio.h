@@ -62,6 +62,19 @@
  *     PIO_Clear and PIO_Get methods.
  *  -# Get the level being currently output by a user-controlled pin configured
  *     as an output using PIO_GetOutputDataStatus().
+ *  -# Drive a bus of output pins of one controller at once with a PinGroup,
+ *     whose masks are computed at compile time by PIO_GROUP():
+ *     \code
+ *        // PC0..PC7, written as an 8-bit value
+ *        const PinGroup dataBus = PIO_GROUP( PIOC, ID_PIOC, 0, 8 );
+ *        PIO_GroupConfigure( &dataBus, 0 );
+ *        PIO_GroupWrite( &dataBus, 0xA5 );
+ *     \endcode
+ *     PIO_GroupWrite() is a single PIO_ODSR store: all the pins of the group
+ *     change on the same cycle, and the other pins of the controller are left
+ *     unchanged by the PIO_OWSR write mask. A controller has one write mask,
+ *     given to a group by PIO_GroupConfigure() or PIO_GroupAcquire(); the
+ *     PIO_GroupSet() and PIO_GroupClear() stores do not need it.
  */
 
 #ifndef _PIO_
@@ -139,6 +152,21 @@
  */
 #define PIO_LISTSIZE(pPins)    (sizeof(pPins) / sizeof(Pin))
 
+/**
+ *  Mask of the width consecutive pins starting at pin shift.
+ */
+#define PIO_GROUP_MASK( shift, width )  ((uint32_t)(((uint64_t)1 << (width)) - 1) << (shift))
+
+/**
+ *  Initializer of a PinGroup of width consecutive pins of a controller, the
+ *  lowest being pin shift; the group value is the pin levels from there.
+ *  \param pio  PIO controller, e.g. PIOC.
+ *  \param id  Peripheral ID of the controller, e.g. ID_PIOC.
+ *  \param shift  Number of the lowest pin.
+ *  \param width  Number of pins, 1 to 32.
+ */
+#define PIO_GROUP( pio, id, shift, width )  { PIO_GROUP_MASK( shift, width ), (pio), (id), (shift) }
+
 /*
  *         Global Types
  */
@@ -178,10 +206,71 @@ typedef struct _Pin
     uint8_t attribute;
 } Pin ;
 
+/*
+ *  Describes a group of output pins of one PIO controller, driven at once.
+ *  The group value is shifted left by #shift# onto the controller pins; only
+ *  the pins set in #mask# are driven. Use PIO_GROUP() to initialize it.
+ */
+typedef struct _PinGroup
+{
+    /*  Bitmask of the pins of the group. */
+    uint32_t mask;
+    /*  Pointer to the PIO controller which has the pins. */
+    Pio    *pio;
+    /*  Peripheral ID of the PIO controller which has the pins. */
+    uint8_t id;
+    /*  Pin number of the bit 0 of the group value. */
+    uint8_t shift;
+} PinGroup ;
+
 /*
  *         Global Access Macros
  */
 
+/**
+ * \brief Gives the PIO_ODSR write mask of the controller to a group, for the
+ * following PIO_GroupWrite(); another group of the controller loses it.
+ */
+static inline void PIO_GroupAcquire( const PinGroup *group )
+{
+    group->pio->PIO_OWDR = ~group->mask;
+    group->pio->PIO_OWER = group->mask;
+}
+
+/**
+ * \brief Outputs a value on the pins of a group, in a single store: the
+ * group shall have the write mask of its controller.
+ */
+static inline void PIO_GroupWrite( const PinGroup *group, uint32_t value )
+{
+    group->pio->PIO_ODSR = value << group->shift;
+}
+
+/**
+ * \brief Sets the pins of a group whose bits are 1 in value, in a single store.
+ */
+static inline void PIO_GroupSet( const PinGroup *group, uint32_t value )
+{
+    group->pio->PIO_SODR = (value << group->shift) & group->mask;
+}
+
+/**
+ * \brief Clears the pins of a group whose bits are 1 in value, in a single
+ * store.
+ */
+static inline void PIO_GroupClear( const PinGroup *group, uint32_t value )
+{
+    group->pio->PIO_CODR = (value << group->shift) & group->mask;
+}
+
+/**
+ * \brief Returns the levels of the pins of a group, as a group value.
+ */
+static inline uint32_t PIO_GroupRead( const PinGroup *group )
+{
+    return (group->pio->PIO_PDSR & group->mask) >> group->shift;
+}
+
 /*
  *         Global Functions
  */
@@ -197,6 +286,7 @@ extern uint8_t PIO_Get( const Pin *pin ) ;
 extern uint8_t PIO_GetOutputDataStatus( const Pin *pin ) ;
 
 extern void PIO_SetDebounceFilter( const Pin *pin, uint32_t cuttoff );
+extern void PIO_GroupConfigure( const PinGroup *group, uint32_t value ) ;
 
 #ifdef __cplusplus
 }
@@ -49,6 +49,16 @@
  *     PIO_CaptureDisableIt(). Otherway, the PDC will send an interrupt.
  *  -# The data receive by the PIO Parallel Capture is inside the buffer passed in the
  *     PIO_CaptureInit().
+ *  -# For a continuous capture, PIO_CaptureNextBuffer() queues the buffer the PDC
+ *     switches to when the current one is full. The End of Reception callback is
+ *     then invoked for each buffer, and Reception Buffer Full means that no buffer
+ *     was queued in time.
+ *  -# For a streaming capture (camera lines, logic analyzer traces), give a ring
+ *     of buffers to PIO_CaptureStreamInit() and call PIO_CaptureStreamStart():
+ *     the handler keeps two buffers queued to the PDC. The consumer takes the
+ *     full buffers in order with PIO_CaptureStreamGet() and gives them back with
+ *     PIO_CaptureStreamRelease(), processing one buffer while the next ones are
+ *     captured. The handler only writes the head and the consumer the tail.
  *
  */
 
@@ -90,6 +100,37 @@ typedef struct _SpioCaptureInit {
 
 } SpioCaptureInit ;
 
+/** \brief PIO Parallel Capture streaming over a ring of buffers.
+ *
+ * The buffers are counted with free running indexes: dwHead buffers were
+ * filled, dwTail were released by the consumer and dwQueued were handed to
+ * the PDC.
+ */
+typedef struct _PioCaptureStream {
+
+    /** Ring of dwMask + 1 buffers */
+    uint8_t *pBuffers;
+    /** Size of a buffer in bytes */
+    uint32_t dwBufferSize;
+    /** Number of buffers minus one */
+    uint32_t dwMask;
+    /** log2 of the transfer size, the PIO_PCMR DSIZE */
+    uint8_t bShift;
+    /** Buffers filled; written by the interrupt handler only */
+    volatile uint32_t dwHead;
+    /** Buffers released; written by the consumer only */
+    volatile uint32_t dwTail;
+    /** Buffers handed to the PDC */
+    volatile uint32_t dwQueued;
+    /** Number of PDC stops for lack of free buffer */
+    volatile uint32_t dwStalls;
+    /** Number of PIO capture overruns */
+    volatile uint32_t dwOverruns;
+    /** Capture configuration, see PIO_CaptureStreamInit() */
+    SpioCaptureInit captureInit;
+
+} PioCaptureStream ;
+
 
 /*----------------------------------------------------------------------------
  *        Global Functions
@@ -99,6 +140,14 @@ extern void PIO_CaptureEnableIt( uint32_t itToEnable ) ;
 extern void PIO_CaptureEnable( void ) ;
 extern void PIO_CaptureDisable( void ) ;
 extern void PIO_CaptureInit( SpioCaptureInit* pInit ) ;
+extern void PIO_CaptureNextBuffer( uint32_t* pData, uint16_t dwSize ) ;
+
+extern void PIO_CaptureStreamInit( PioCaptureStream* pStream, uint8_t* pBuffers, uint32_t dwBufferSize,
+                                   uint32_t dwCount, uint8_t dsize ) ;
+extern void PIO_CaptureStreamStart( PioCaptureStream* pStream ) ;
+extern void PIO_CaptureStreamStop( PioCaptureStream* pStream ) ;
+extern uint32_t PIO_CaptureStreamGet( PioCaptureStream* pStream, uint8_t** ppData ) ;
+extern void PIO_CaptureStreamRelease( PioCaptureStream* pStream ) ;
 
 #endif /* #ifndef PIO_CAPTURE_H */
 
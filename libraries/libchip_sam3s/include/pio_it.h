@@ -44,7 +44,9 @@
  *  in particular applications:
  *     - It enables the clocks of all PIO controllers
  *     - PIO controllers all share the same interrupt handler, which does the
- *       demultiplexing and can be slower than direct configuration
+ *       demultiplexing and can be slower than direct configuration; its cost
+ *       only depends on the number of pending pins, not on the number of
+ *       sources
  *     - It reserves space for a fixed number of interrupts, which can be
  *       increased by modifying the appropriate constant in pio_it.c.
  *
@@ -53,7 +55,11 @@
  *  -# Initialize the PIO interrupt mechanism using PIO_InitializeInterrupts()
  *     with the desired priority (0 ... 7).
  *  -# Configure a status change interrupt on one or more pin(s) with
- *     PIO_ConfigureIt().
+ *     PIO_ConfigureIt(), or with PIO_ConfigureItMask() to get a single call
+ *     with the mask of the pending pins of a group.
+ *  -# For mechanical contacts (keys, encoders), set the PIO_DEBOUNCE
+ *     attribute and the filter period with PIO_SetDebounceFilter(): the
+ *     debouncing is done by the PIO controller, not in the handler.
  *  -# Enable & disable interrupts on pins using PIO_EnableIt() and
  *     PIO_DisableIt().
  */
@@ -79,6 +85,8 @@ extern void PIO_InitializeInterrupts( uint32_t dwPriority ) ;
 
 extern void PIO_ConfigureIt( const Pin *pPin, void (*handler)( const Pin* ) ) ;
 
+extern void PIO_ConfigureItMask( const Pin *pPin, void (*handler)( const Pin*, uint32_t ) ) ;
+
 extern void PIO_EnableIt( const Pin *pPin ) ;
 
 extern void PIO_DisableIt( const Pin *pPin ) ;
@@ -35,6 +35,19 @@
  *----------------------------------------------------------------------------*/
 #include <stdint.h>
 
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Working clock saved by PMC_SwitchMckToSlowClock(). */
+typedef struct _PmcClockConfig
+{
+    uint32_t dwMor ;
+    uint32_t dwPllar ;
+    uint32_t dwPllbr ;
+    uint32_t dwMckr ;
+} PmcClockConfig ;
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -51,6 +64,12 @@ extern void PMC_DisableAllPeripherals( void ) ;
 
 extern uint32_t PMC_IsPeriphEnabled( uint32_t dwId ) ;
 
+extern void PMC_AcquirePeripheral( uint32_t dwId ) ;
+extern void PMC_ReleasePeripheral( uint32_t dwId ) ;
+
+extern void PMC_SwitchMckToSlowClock( PmcClockConfig* pSave ) ;
+extern void PMC_RestoreMck( const PmcClockConfig* pSaved ) ;
+
 #ifdef __cplusplus
 }
 #endif
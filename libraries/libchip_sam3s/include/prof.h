@@ -0,0 +1,145 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Hot path profiler on the Cortex-M3 DWT cycle counter.
+ *
+ * A probe measures the core clock cycles between PROF_Enter(id) and
+ * PROF_Exit(id), and keeps the count, the minimum, the maximum, the total and
+ * a histogram of the measures, with power-of-two buckets. Probes sit in the
+ * USB, SPI, media, FatFs, NAND and LCD hot paths; the PROF_ID_USERx probes
+ * are left to the application. Only the outermost level of a nested probe
+ * is measured.
+ *
+ * The probes are compiled out unless PROF_ENABLE is defined to 1. Measuring
+ * starts with PROF_Start(); PROF_GetStats() reads the statistics of a probe,
+ * and PROF_Dump(), only built with the probes, prints them on the console.
+ * A probe costs a few tens of cycles, interrupts are masked while its
+ * statistics are updated.
+ *
+ */
+
+#ifndef _PROF_
+#define _PROF_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definition
+ *----------------------------------------------------------------------------*/
+/* By default, the probes are compiled out */
+#if !defined(PROF_ENABLE)
+#define PROF_ENABLE  0
+#endif
+
+/** Probe identifiers.*/
+#define PROF_ID_USBD_IRQ        0
+#define PROF_ID_UDP_ENDPOINT    1
+#define PROF_ID_SPID_HANDLER    2
+#define PROF_ID_MED_READ        3
+#define PROF_ID_MED_WRITE       4
+#define PROF_ID_DISK_READ       5
+#define PROF_ID_DISK_WRITE      6
+#define PROF_ID_NAND_READPAGE   7
+#define PROF_ID_LCD_BLIT        8
+#define PROF_ID_USER0           9
+#define PROF_ID_USER1           10
+#define PROF_ID_USER2           11
+#define PROF_ID_USER3           12
+/** Number of probes.*/
+#define PROF_NUM_PROBES         13
+
+/** Number of histogram buckets: bucket n counts the measures of 2^(n+4) to
+    2^(n+5)-1 cycles, the first and last buckets extend down and up.*/
+#define PROF_NUM_BUCKETS        12
+#define PROF_BUCKET_SHIFT       4
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Type
+ *----------------------------------------------------------------------------*/
+/** \brief Statistics of a probe. */
+typedef struct _ProfStats
+{
+    /** Number of measures.*/
+    uint32_t dwCount ;
+    /** Shortest measure, in cycles.*/
+    uint32_t dwMinCycles ;
+    /** Longest measure, in cycles.*/
+    uint32_t dwMaxCycles ;
+    /** Sum of the measures, in cycles.*/
+    uint64_t qwTotalCycles ;
+    /** Histogram of the measures.*/
+    uint32_t adwBuckets[PROF_NUM_BUCKETS] ;
+} ProfStats ;
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+#if (PROF_ENABLE == 1)
+
+#define PROF_Enter( dwId )  PROF_EnterProbe( dwId )
+#define PROF_Exit( dwId )   PROF_ExitProbe( dwId )
+
+#else
+
+#define PROF_Enter( dwId )  { }
+#define PROF_Exit( dwId )   { }
+
+#endif
+
+extern void PROF_Start( void ) ;
+
+extern void PROF_Stop( void ) ;
+
+extern void PROF_Reset( void ) ;
+
+extern void PROF_EnterProbe( uint32_t dwId ) ;
+
+extern void PROF_ExitProbe( uint32_t dwId ) ;
+
+extern void PROF_GetStats( uint32_t dwId, ProfStats* pStats ) ;
+
+#if (PROF_ENABLE == 1)
+extern void PROF_Dump( uint32_t dwMck ) ;
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _PROF_ */
@@ -51,6 +51,11 @@
  *    -# Control PWM override output using \ref PWMC_SetOverrideValue(),
  *       \ref PWMC_EnableOverrideOutput() and \ref PWMC_DisableOverrideOutput().
  *    -# Send data through the transmitter using \ref PWMC_WriteBuffer().
+ *    -# Play duty cycle tables on the synchronous channels continuously with
+ *       \ref PWMC_WaveInitialize(), \ref PWMC_WaveStart() and \ref PWMC_WaveHandler()
+ *       called from the PWM interrupt. Double buffered tables are rewritten with
+ *       \ref PWMC_WaveGetFreeTable() and \ref PWMC_WaveSubmit(), and ADC
+ *       conversions are triggered with \ref PWMC_WaveConfigureAdcTrigger().
  *
  */
 
@@ -69,6 +74,32 @@
  extern "C" {
 #endif
 
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Synchronous channels waveform engine */
+typedef struct _PwmcWave {
+    /** PWM instance */
+    Pwm *pPwm;
+    /** Duty cycle tables, the second one is optional */
+    uint16_t *apTables[2];
+    /** Duty cycles per table */
+    uint32_t dwLength;
+    /** Number of synchronous channels */
+    uint8_t bChannels;
+    /** Table played by the PDC */
+    volatile uint8_t bActive;
+    /** Table queued in the PDC next bank */
+    volatile uint8_t bQueued;
+    /** Table to queue at the end of the played one */
+    volatile uint8_t bNext;
+    /** Number of tables played */
+    volatile uint32_t dwCycles;
+    /** Number of synchronous update underruns */
+    volatile uint32_t dwUnderruns;
+} PwmcWave;
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -119,6 +150,15 @@ extern void PWMC_EnableFaultProtection( Pwm* pPwm, uint32_t value);
 extern void PWMC_ConfigureComparisonUnit( Pwm* pPwm, uint32_t x, uint32_t value, uint32_t mode);
 extern void PWMC_ConfigureEventLineMode( Pwm* pPwm, uint32_t x, uint32_t mode);
 
+extern void PWMC_WaveInitialize( PwmcWave* pWave, Pwm* pPwm, uint32_t channels,
+    uint16_t* pTable0, uint16_t* pTable1, uint32_t dwSteps, uint8_t updatePeriod);
+extern void PWMC_WaveStart( PwmcWave* pWave );
+extern void PWMC_WaveStop( PwmcWave* pWave );
+extern uint16_t* PWMC_WaveGetFreeTable( PwmcWave* pWave );
+extern void PWMC_WaveSubmit( PwmcWave* pWave );
+extern void PWMC_WaveHandler( PwmcWave* pWave, uint32_t isr2 );
+extern void PWMC_WaveConfigureAdcTrigger( Pwm* pPwm, uint32_t x, uint32_t line, uint32_t value);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,269 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Lock-free single-producer, single-consumer byte ring buffer.
+ *
+ * The producer (typically an interrupt handler or a DMA completion) only
+ * writes dwHead, the consumer (typically a task) only writes dwTail, so that
+ * neither side masks the interrupts. Both indices run freely and are reduced
+ * with the size mask, the size being a power of two; the buffer can then be
+ * completely filled.
+ *
+ * Besides the byte and block copies, the producer can fill the ring in place
+ * with RING_Reserve() / RING_Commit(), e.g. to hand the contiguous free area
+ * to a PDC channel, and the consumer can drain it in place with RING_Peek() /
+ * RING_Consume().
+ *
+ */
+
+#ifndef _RINGBUF_
+#define _RINGBUF_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Type
+ *----------------------------------------------------------------------------*/
+/** \brief Byte ring buffer; use the RING functions to access it. */
+typedef struct _RingBuffer
+{
+    /** Storage, dwMask+1 bytes.*/
+    uint8_t* pBuffer ;
+    /** Size of the storage minus one.*/
+    uint32_t dwMask ;
+    /** Number of bytes ever written; written by the producer only.*/
+    volatile uint32_t dwHead ;
+    /** Number of bytes ever read; written by the consumer only.*/
+    volatile uint32_t dwTail ;
+} RingBuffer ;
+
+/*----------------------------------------------------------------------------
+ *        Inline functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initializes an empty ring over a storage area.
+ * \param pRing  Pointer to a RingBuffer instance.
+ * \param pBuffer  Storage of the ring.
+ * \param dwSize  Size of the storage, a power of two.
+ * \return 0 if successful; 1 if the size is not a power of two.
+ */
+static inline uint32_t RING_Initialize( RingBuffer* pRing, uint8_t* pBuffer, uint32_t dwSize )
+{
+    if ( (dwSize == 0) || ((dwSize & (dwSize-1)) != 0) )
+    {
+        return 1 ;
+    }
+
+    pRing->pBuffer = pBuffer ;
+    pRing->dwMask = dwSize-1 ;
+    pRing->dwHead = 0 ;
+    pRing->dwTail = 0 ;
+
+    return 0 ;
+}
+
+/** \brief Returns the number of bytes in the ring. */
+static inline uint32_t RING_GetCount( RingBuffer* pRing )
+{
+    return pRing->dwHead - pRing->dwTail ;
+}
+
+/** \brief Returns the number of bytes which can be written in the ring. */
+static inline uint32_t RING_GetFree( RingBuffer* pRing )
+{
+    return pRing->dwMask + 1 - (pRing->dwHead - pRing->dwTail) ;
+}
+
+/*----------------------------------------------------------------------------
+ *        Producer side
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Returns the contiguous free area at the head of the ring, to be
+ * filled in place and then published with RING_Commit().
+ * \param pRing  Pointer to a RingBuffer instance.
+ * \param ppData  Receives the start of the area.
+ * \return Size of the area in bytes, 0 if the ring is full.
+ */
+static inline uint32_t RING_Reserve( RingBuffer* pRing, uint8_t** ppData )
+{
+    uint32_t dwHead = pRing->dwHead ;
+    uint32_t dwFree = pRing->dwMask + 1 - (dwHead - pRing->dwTail) ;
+    uint32_t dwToEnd = pRing->dwMask + 1 - (dwHead & pRing->dwMask) ;
+
+    *ppData = &pRing->pBuffer[dwHead & pRing->dwMask] ;
+
+    return (dwFree < dwToEnd) ? dwFree : dwToEnd ;
+}
+
+/**
+ * \brief Publishes dwSize bytes written in the area given by RING_Reserve().
+ */
+static inline void RING_Commit( RingBuffer* pRing, uint32_t dwSize )
+{
+    /* The data is written before the consumer can see it */
+    __DMB() ;
+    pRing->dwHead += dwSize ;
+}
+
+/**
+ * \brief Writes a byte; returns 0 if successful, 1 if the ring is full.
+ */
+static inline uint32_t RING_Put( RingBuffer* pRing, uint8_t ucData )
+{
+    uint32_t dwHead = pRing->dwHead ;
+
+    if ( dwHead - pRing->dwTail > pRing->dwMask )
+    {
+        return 1 ;
+    }
+    pRing->pBuffer[dwHead & pRing->dwMask] = ucData ;
+    __DMB() ;
+    pRing->dwHead = dwHead + 1 ;
+
+    return 0 ;
+}
+
+/**
+ * \brief Writes up to dwSize bytes; returns the number of bytes written.
+ */
+static inline uint32_t RING_Write( RingBuffer* pRing, const uint8_t* pData, uint32_t dwSize )
+{
+    uint8_t* pArea ;
+    uint32_t dwArea ;
+    uint32_t dwDone = 0 ;
+
+    /* At most two areas: up to the end of the storage, then from its start */
+    while ( (dwDone < dwSize) && ((dwArea = RING_Reserve( pRing, &pArea )) != 0) )
+    {
+        if ( dwArea > dwSize - dwDone )
+        {
+            dwArea = dwSize - dwDone ;
+        }
+        memcpy( pArea, &pData[dwDone], dwArea ) ;
+        RING_Commit( pRing, dwArea ) ;
+        dwDone += dwArea ;
+    }
+
+    return dwDone ;
+}
+
+/*----------------------------------------------------------------------------
+ *        Consumer side
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Returns the contiguous data area at the tail of the ring, to be read
+ * in place and then released with RING_Consume().
+ * \param pRing  Pointer to a RingBuffer instance.
+ * \param ppData  Receives the start of the area.
+ * \return Size of the area in bytes, 0 if the ring is empty.
+ */
+static inline uint32_t RING_Peek( RingBuffer* pRing, uint8_t** ppData )
+{
+    uint32_t dwTail = pRing->dwTail ;
+    uint32_t dwCount = pRing->dwHead - dwTail ;
+    uint32_t dwToEnd = pRing->dwMask + 1 - (dwTail & pRing->dwMask) ;
+
+    /* The data is read after the producer published it */
+    __DMB() ;
+    *ppData = &pRing->pBuffer[dwTail & pRing->dwMask] ;
+
+    return (dwCount < dwToEnd) ? dwCount : dwToEnd ;
+}
+
+/**
+ * \brief Releases dwSize bytes read from the area given by RING_Peek().
+ */
+static inline void RING_Consume( RingBuffer* pRing, uint32_t dwSize )
+{
+    /* The data is read before the producer can overwrite it */
+    __DMB() ;
+    pRing->dwTail += dwSize ;
+}
+
+/**
+ * \brief Reads a byte; returns 0 if successful, 1 if the ring is empty.
+ */
+static inline uint32_t RING_Get( RingBuffer* pRing, uint8_t* pucData )
+{
+    uint32_t dwTail = pRing->dwTail ;
+
+    if ( dwTail == pRing->dwHead )
+    {
+        return 1 ;
+    }
+    __DMB() ;
+    *pucData = pRing->pBuffer[dwTail & pRing->dwMask] ;
+    __DMB() ;
+    pRing->dwTail = dwTail + 1 ;
+
+    return 0 ;
+}
+
+/**
+ * \brief Reads up to dwSize bytes; returns the number of bytes read.
+ */
+static inline uint32_t RING_Read( RingBuffer* pRing, uint8_t* pData, uint32_t dwSize )
+{
+    uint8_t* pArea ;
+    uint32_t dwArea ;
+    uint32_t dwDone = 0 ;
+
+    while ( (dwDone < dwSize) && ((dwArea = RING_Peek( pRing, &pArea )) != 0) )
+    {
+        if ( dwArea > dwSize - dwDone )
+        {
+            dwArea = dwSize - dwDone ;
+        }
+        memcpy( &pData[dwDone], pArea, dwArea ) ;
+        RING_Consume( pRing, dwArea ) ;
+        dwDone += dwArea ;
+    }
+
+    return dwDone ;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _RINGBUF_ */
@@ -52,6 +52,12 @@
 /** SPI driver is currently in use.*/
 #define SPID_ERROR_LOCK     2
 
+/** Number of chip selects of a USART SPI bus.*/
+#define SPID_USART_NUM_CS   4
+
+/** Smallest clock divider (US_BRGR.CD) of a USART in SPI master mode.*/
+#define SPID_USART_MIN_CD   6
+
 /*----------------------------------------------------------------------------
  *        Macros
  *----------------------------------------------------------------------------*/
@@ -97,20 +103,43 @@ typedef struct _SpidCmd
 	SpidCallback callback;
     /** Callback arguments. */
 	void *pArgument;
+    /** Next command in the driver queue (managed by the driver). */
+	struct _SpidCmd *pNext;
 } SpidCmd ;
 
+/** \brief USART in SPI master mode, driven by a Spid as a second SPI bus.
+ *
+ * The USART has a single NSS output (RTS): chip select 0 uses it, the other
+ * chip selects are GPIO pins set with SPID_ConfigureUsartCS().
+ */
+typedef struct _SpidUsart
+{
+    /** Pointer to USART Hardware registers */
+    Usart* pUsartHw ;
+    /** US_MR value of each chip select, from SPID_ConfigureCS() */
+    uint32_t adwMr[SPID_USART_NUM_CS] ;
+    /** US_BRGR value of each chip select, from SPID_ConfigureCS() */
+    uint32_t adwBrgr[SPID_USART_NUM_CS] ;
+    /** Chip select pins, 0 to use the NSS (RTS) line */
+    const Pin* apCsPins[SPID_USART_NUM_CS] ;
+} SpidUsart ;
+
 /** Constant structure associated with SPI port. This structure prevents
     client applications to have access in the same time. */
 typedef struct _Spid
 {
-    /** Pointer to SPI Hardware registers */
+    /** Pointer to SPI Hardware registers, 0 for a USART bus */
 	Spi* pSpiHw ;
     /** SPI Id as defined in the product datasheet */
 	char spiId ;
-    /** Current SpiCommand being processed */
+    /** Current SpiCommand being processed, head of the command queue */
 	SpidCmd *pCurrentCommand ;
+    /** Last queued SpiCommand */
+	SpidCmd *pLastCommand ;
     /** Mutual exclusion semaphore. */
 	volatile char semaphore ;
+    /** USART used as SPI bus, 0 for the SPI peripheral */
+	SpidUsart* pUsart ;
 } Spid ;
 
 /*----------------------------------------------------------------------------
@@ -119,10 +148,16 @@ typedef struct _Spid
 
 extern uint32_t SPID_Configure( Spid* pSpid, Spi* pSpiHw, uint8_t spiId ) ;
 
+extern uint32_t SPID_ConfigureUsart( Spid* pSpid, SpidUsart* pUsart, Usart* pUsartHw, uint8_t usartId ) ;
+
 extern void SPID_ConfigureCS( Spid* pSpid, uint32_t dwCS, uint32_t dwCsr ) ;
+
+extern void SPID_ConfigureUsartCS( Spid* pSpid, uint32_t dwCS, const Pin* pCsPin ) ;
 	
 extern uint32_t SPID_SendCommand( Spid* pSpid, SpidCmd* pCommand ) ;
 
+extern uint32_t SPID_QueueCommand( Spid* pSpid, SpidCmd* pCommand ) ;
+
 extern void SPID_Handler( Spid* pSpid ) ;
 
 extern uint32_t SPID_IsBusy( const Spid* pSpid ) ;
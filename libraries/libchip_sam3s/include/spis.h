@@ -0,0 +1,150 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Interface of the SPI slave streaming driver.
+ *
+ */
+
+#ifndef _SPIS_
+#define _SPIS_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "chip.h"
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Invalid ring buffer or chunk size.*/
+#define SPIS_ERROR_PARAM     1
+
+/** Number of received frames waiting for SPIS_ReleaseFrame(), a power of two.*/
+#if !defined(SPIS_MAX_FRAMES)
+#define SPIS_MAX_FRAMES      8
+#endif
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+struct _Spis ;
+
+/** End of frame (NSS rising) callback, invoked from SPIS_Handler().*/
+typedef void (*SpisCallback)( struct _Spis* pSpis, void* pArgument ) ;
+
+/** \brief Frame received between a falling and a rising edge of NSS.
+ *
+ * The data is left in the receive ring: it is in two parts when the frame
+ * wraps at the end of the ring.
+ */
+typedef struct _SpisFrame
+{
+    /** First part of the frame.*/
+    uint8_t* pData ;
+    /** Size of the first part in bytes.*/
+    uint32_t dwLength ;
+    /** Second part of the frame, at the start of the ring.*/
+    uint8_t* pWrapData ;
+    /** Size of the second part in bytes, 0 if the frame does not wrap.*/
+    uint32_t dwWrapLength ;
+} SpisFrame ;
+
+/** \brief SPI slave driver structure. Holds the internal state of the driver.*/
+typedef struct _Spis
+{
+    /** Pointer to SPI Hardware registers */
+    Spi* pSpiHw ;
+    /** SPI Id as defined in the product datasheet */
+    uint8_t spiId ;
+    /** Largest PDC buffer, i.e. bytes between two PDC interrupts */
+    uint32_t dwChunk ;
+    /** Receive ring, filled by the PDC */
+    RingBuffer rx ;
+    /** Position of the end of the receive PDC buffers */
+    uint32_t dwRxArmed ;
+    /** The receive ring is full, the PDC has no next buffer */
+    volatile uint8_t bRxStalled ;
+    /** Transmit ring, drained by the PDC */
+    RingBuffer tx ;
+    /** Position of the end of the transmit PDC buffers */
+    uint32_t dwTxArmed ;
+    /** The transmit ring is empty, the PDC has no next buffer */
+    volatile uint8_t bTxStalled ;
+    /** Receive ring positions of the frame ends */
+    uint32_t adwFrameEnd[SPIS_MAX_FRAMES] ;
+    /** Frames ever received, and ever released */
+    volatile uint32_t dwFrameHead ;
+    volatile uint32_t dwFrameTail ;
+    /** Frames merged with the previous one, the frame queue being full */
+    uint32_t dwFramesMerged ;
+    /** Overrun errors seen, bytes received while the receive ring was full */
+    uint32_t dwOverruns ;
+    /** Optional end of frame callback */
+    SpisCallback callback ;
+    /** Argument of the callback */
+    void* pArgument ;
+} Spis ;
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern uint32_t SPIS_Configure( Spis* pSpis, Spi* pSpiHw, uint8_t spiId, uint32_t dwCsr,
+                                uint8_t* pRxBuffer, uint32_t dwRxSize,
+                                uint8_t* pTxBuffer, uint32_t dwTxSize, uint32_t dwChunk ) ;
+
+extern void SPIS_SetCallback( Spis* pSpis, SpisCallback callback, void* pArgument ) ;
+
+extern void SPIS_Handler( Spis* pSpis ) ;
+
+extern uint32_t SPIS_GetFrame( Spis* pSpis, SpisFrame* pFrame ) ;
+
+extern void SPIS_ReleaseFrame( Spis* pSpis, const SpisFrame* pFrame ) ;
+
+extern uint32_t SPIS_Write( Spis* pSpis, const uint8_t* pData, uint32_t dwSize ) ;
+
+extern void SPIS_Stop( Spis* pSpis ) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _SPIS_ */
@@ -44,10 +44,56 @@
 
 #include <stdint.h>
 
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Maximum number of buffers of a stream ring. */
+#define SSC_STREAM_MAXBUFFERS   8
+
 #ifdef __cplusplus
  extern "C" {
 #endif
 
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** \brief Ring of buffers exchanged between the SSC PDC and the application.
+    The counters are free running. */
+typedef struct _SscRing {
+
+    /** Buffers, dwBufferSize bytes each. */
+    uint8_t *pBuffers;
+    /** Size of one buffer in bytes. */
+    uint32_t dwBufferSize;
+    /** Number of buffers (up to SSC_STREAM_MAXBUFFERS). */
+    uint8_t bNumBuffers;
+    /** Number of valid bytes of each buffer. */
+    uint32_t pdwLength[SSC_STREAM_MAXBUFFERS];
+    /** Buffers handed to the PDC. */
+    volatile uint32_t dwArmed;
+    /** Buffers completed by the PDC. */
+    volatile uint32_t dwDone;
+    /** Buffers produced (transmit) or consumed (receive) by the application. */
+    volatile uint32_t dwApp;
+    /** Transmit underruns or receive overruns: the PDC ran out of buffers. */
+    volatile uint32_t dwErrors;
+} SscRing;
+
+/** \brief Full-duplex SSC stream: a transmit ring filled by the application
+    (e.g. from the USB audio OUT endpoint) and a receive ring filled by the
+    PDC (e.g. sent to the USB audio IN endpoint), without copies. */
+typedef struct _SscStream {
+
+    /** Transmit ring. */
+    SscRing tx;
+    /** Receive ring. */
+    SscRing rx;
+    /** Bytes per SSC data transfer (1, 2 or 4). */
+    uint8_t bWordSize;
+} SscStream;
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -65,6 +111,24 @@ extern uint32_t SSC_Read(void);
 extern uint8_t SSC_WriteBuffer(void *buffer, uint32_t length);
 extern uint8_t SSC_ReadBuffer(void *buffer, uint32_t length);
 
+extern void SSC_StreamInitialize(SscStream *pStream,
+                                 uint8_t *pTxBuffers, uint8_t *pRxBuffers,
+                                 uint32_t bufferSize, uint8_t numBuffers,
+                                 uint8_t wordSize);
+extern void SSC_StreamStart(SscStream *pStream);
+extern void SSC_StreamStop(SscStream *pStream);
+extern void SSC_StreamHandler(SscStream *pStream);
+extern uint8_t *SSC_StreamGetTxBuffer(SscStream *pStream);
+extern void SSC_StreamCommitTx(SscStream *pStream, uint32_t length);
+extern uint8_t *SSC_StreamGetRxBuffer(SscStream *pStream, uint32_t *pLength);
+extern void SSC_StreamReleaseRx(SscStream *pStream);
+extern void SSC_StreamTxTransferCallback(void *pArg, uint8_t status,
+                                         uint32_t transferred,
+                                         uint32_t remaining);
+extern void SSC_StreamRxTransferCallback(void *pArg, uint8_t status,
+                                         uint32_t transferred,
+                                         uint32_t remaining);
+
 #ifdef __cplusplus
 }
 #endif
@@ -41,12 +41,16 @@
 extern
 #ifdef __ICCARM__
 __ramfunc /* IAR */
+#else
+__attribute__ ((long_call)) /* GCC, in SRAM */
 #endif
 void SUPC_EnableFlash( Supc* pSupc, uint32_t dwTime ) ;
 
 extern
 #ifdef __ICCARM__
 __ramfunc /* IAR */
+#else
+__attribute__ ((long_call)) /* GCC, in SRAM */
 #endif
 void SUPC_DisableFlash( Supc* pSupc ) ;
 
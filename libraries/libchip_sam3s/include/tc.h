@@ -39,6 +39,11 @@
  *     TCCLKS field value automatically.
  *  -# Configure a Timer Counter in the desired mode using TC_Configure().
  *  -# Start or stop the timer clock using TC_Start() and TC_Stop().
+ *  -# For a 32-bit or 48-bit time base or edge counter, chain channels with
+ *     TC_ChainStart() and read them with TC_ChainRead().
+ *  -# For period and duty cycle measurements, start a capture with
+ *     TC_CaptureStart(), call TC_CaptureHandler() from the channel interrupt
+ *     and get batch results with TC_CaptureGetStats().
  */
 
 #ifndef _TC_
@@ -52,6 +57,50 @@
 
 #include <stdint.h>
 
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+/** One captured period, in counter clocks */
+typedef struct _TcCaptureSample
+{
+    /** Low time */
+    uint32_t dwLow ;
+    /** Period */
+    uint32_t dwPeriod ;
+} TcCaptureSample ;
+
+/** Period and duty cycle capture on a TC channel */
+typedef struct _TcCapture
+{
+    Tc* pTc ;
+    uint32_t dwChannel ;
+    /** Ring of dwMask + 1 samples */
+    TcCaptureSample* pSamples ;
+    uint32_t dwMask ;
+    /** Samples stored, written by the interrupt handler only */
+    volatile uint32_t dwHead ;
+    /** Samples consumed */
+    uint32_t dwTail ;
+    /** Counter overflows in the current period */
+    volatile uint32_t dwOverflows ;
+    /** Low time of the current period */
+    volatile uint32_t dwLowTime ;
+    /** Periods lost, ring full or load overrun */
+    volatile uint32_t dwLost ;
+} TcCapture ;
+
+/** Statistics of a batch of captured periods, in counter clocks */
+typedef struct _TcCaptureStats
+{
+    uint32_t dwSamples ;
+    uint32_t dwPeriodMin ;
+    uint32_t dwPeriodMax ;
+    uint32_t dwPeriodMean ;
+    /** High time over period */
+    uint32_t dwDutyPerThousand ;
+} TcCaptureStats ;
+
 /*------------------------------------------------------------------------------
  *         Global functions
  *------------------------------------------------------------------------------*/
@@ -68,6 +117,19 @@ extern void TC_Stop( Tc *pTc, uint32_t dwChannel ) ;
 
 extern uint32_t TC_FindMckDivisor( uint32_t dwFreq, uint32_t dwMCk, uint32_t *dwDiv, uint32_t *dwTcClks, uint32_t dwBoardMCK ) ;
 
+extern void TC_ChainStart( Tc *pTc, uint32_t dwChannels, uint32_t dwTcClks ) ;
+
+extern uint64_t TC_ChainRead( Tc *pTc, uint32_t dwChannels ) ;
+
+extern void TC_CaptureStart( TcCapture *pCapture, Tc *pTc, uint32_t dwChannel, uint32_t dwTcClks,
+                             TcCaptureSample *pSamples, uint32_t dwCount ) ;
+
+extern void TC_CaptureStop( TcCapture *pCapture ) ;
+
+extern void TC_CaptureHandler( TcCapture *pCapture ) ;
+
+extern uint32_t TC_CaptureGetStats( TcCapture *pCapture, TcCaptureStats *pStats ) ;
+
 #ifdef __cplusplus
 }
 #endif
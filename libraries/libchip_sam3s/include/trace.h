@@ -48,6 +48,30 @@
  *     the trace level can be modified in runtime. If static disabling is selected
  *     the disabled traces are not compiled.
  *
+ *  -# Traces are formatted by printf on the console, which takes the time of
+ *     the whole output. Compiling with TRACE_BINARY=1 selects the binary
+ *     traces instead: each trace only stores the address of its format string
+ *     and its arguments (up to 12 words) in a RAM ring, which is drained in
+ *     the background by the console UART PDC (TRACE_BINARY_UART=1, default),
+ *     or by the application with TRACE_BinaryPeek() and TRACE_BinaryConsume()
+ *     (e.g. over a CDC serial port). tracebin.py decodes the stream on the
+ *     host with the format strings of the ELF file. Floating point arguments
+ *     are not supported, %s arguments are decoded when they point to constant
+ *     strings of the ELF file. With TRACE_BINARY_UART=1, the console only
+ *     carries the binary stream.
+ *  -# Compiling with TRACE_LIGHT=1 formats the traces with the integer-only
+ *     UART_Printf() of the board console instead of printf: no C library
+ *     formatter, and no wait for the line once UART_EnableTxBuffer() has
+ *     been called.
+ *  -# Compiling with TRACE_ITM=1 sends the traces on the SWO pin through the
+ *     ITM (itm.h) instead of the console UART, which is left to the
+ *     application: TRACE_CONFIGURE() sets the SWO at TRACE_ITM_BAUD. The
+ *     text traces are formatted in a line buffer and sent on ITM_PORT_TEXT;
+ *     with TRACE_BINARY=1, the records are written straight to
+ *     ITM_PORT_BINARY, a few cycles per word, without ring nor PDC. The SWO
+ *     is captured with openOCD/sam3s_swo.cfg and decoded with
+ *     tracebin.py --itm.
+ *
  *  \par traceLevels Trace level description
  *  -# TRACE_DEBUG (5): Traces whose only purpose is for debugging the program,
  *     and which do not produce meaningful information otherwise.
@@ -91,6 +115,26 @@
 #define TRACE_LEVEL TRACE_LEVEL_INFO
 #endif
 
+/* By default, traces are formatted by printf */
+#if !defined(TRACE_BINARY)
+#define TRACE_BINARY 0
+#endif
+
+/* By default, traces are not formatted by UART_Printf */
+#if !defined(TRACE_LIGHT)
+#define TRACE_LIGHT 0
+#endif
+
+/* By default, traces are sent on the console UART, not on the SWO */
+#if !defined(TRACE_ITM)
+#define TRACE_ITM 0
+#endif
+
+/* SWO baud rate of TRACE_ITM, MCK must be a multiple of it */
+#if !defined(TRACE_ITM_BAUD)
+#define TRACE_ITM_BAUD 2000000
+#endif
+
 /* By default, trace level is static (not dynamic) */
 #if !defined(DYN_TRACES)
 #define DYN_TRACES 0
@@ -137,6 +181,53 @@ extern void TRACE_CONFIGURE( uint32_t dwBaudRate, uint32_t dwMCk ) ;
     }
 #endif
 
+/**
+ *  Binary trace record: a header word (TRACE_BINARY_SYNC, number of argument
+ *  words, level, prefix flag, then a 16-bit sequence number which shows the
+ *  records dropped when the ring was full), the address of the format string
+ *  and the argument words.
+ */
+#define TRACE_BINARY_SYNC      0xB7
+#define TRACE_BINARY_HEADER( dwLevel, dwPrefix, dwCount ) \
+    (TRACE_BINARY_SYNC | ((dwCount) << 8) | ((dwLevel) << 12) | ((dwPrefix) << 15))
+
+#if (TRACE_BINARY == 1)
+
+/* Number of arguments after the format string, 0 to 12 */
+#define _TRACE_NARGS(...)      _TRACE_NARGS_( __VA_ARGS__, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 )
+#define _TRACE_NARGS_( f, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, n, ... ) n
+
+#define _TRACE_PRINTF( dwLevel, prefix, ... ) \
+    TRACE_BinaryWrite( TRACE_BINARY_HEADER( dwLevel, 1, _TRACE_NARGS( __VA_ARGS__ ) ), __VA_ARGS__ )
+#define _TRACE_PRINTF_WP( dwLevel, ... ) \
+    TRACE_BinaryWrite( TRACE_BINARY_HEADER( dwLevel, 0, _TRACE_NARGS( __VA_ARGS__ ) ), __VA_ARGS__ )
+
+extern void TRACE_BinaryWrite( uint32_t dwHeader, const char* pszFormat, ... ) ;
+extern uint32_t TRACE_BinaryPeek( uint8_t** ppData ) ;
+extern void TRACE_BinaryConsume( uint32_t dwSize ) ;
+extern uint32_t TRACE_BinaryGetDropped( void ) ;
+
+#elif (TRACE_ITM == 1)
+
+#define _TRACE_PRINTF( dwLevel, prefix, ... )  TRACE_ItmPrintf( prefix __VA_ARGS__ )
+#define _TRACE_PRINTF_WP( dwLevel, ... )       TRACE_ItmPrintf( __VA_ARGS__ )
+
+extern int TRACE_ItmPrintf( const char* pszFormat, ... ) ;
+
+#elif (TRACE_LIGHT == 1)
+
+#define _TRACE_PRINTF( dwLevel, prefix, ... )  UART_Printf( prefix __VA_ARGS__ )
+#define _TRACE_PRINTF_WP( dwLevel, ... )       UART_Printf( __VA_ARGS__ )
+
+extern int UART_Printf( const char* pszFormat, ... ) ;
+
+#else
+
+#define _TRACE_PRINTF( dwLevel, prefix, ... )  printf( prefix __VA_ARGS__ )
+#define _TRACE_PRINTF_WP( dwLevel, ... )       printf( __VA_ARGS__ )
+
+#endif
+
 /**
  *  Outputs a formatted string using 'printf' if the log level is high
  *  enough. Can be disabled by defining TRACE_LEVEL=0 during compilation.
@@ -160,56 +251,56 @@ extern void TRACE_CONFIGURE( uint32_t dwBaudRate, uint32_t dwMCk ) ;
 #elif (DYN_TRACES == 1)
 
 /* Trace output depends on dwTraceLevel value */
-#define TRACE_DEBUG(...)      { if (dwTraceLevel >= TRACE_LEVEL_DEBUG)   { printf("-D- " __VA_ARGS__); } }
-#define TRACE_INFO(...)       { if (dwTraceLevel >= TRACE_LEVEL_INFO)    { printf("-I- " __VA_ARGS__); } }
-#define TRACE_WARNING(...)    { if (dwTraceLevel >= TRACE_LEVEL_WARNING) { printf("-W- " __VA_ARGS__); } }
-#define TRACE_ERROR(...)      { if (dwTraceLevel >= TRACE_LEVEL_ERROR)   { printf("-E- " __VA_ARGS__); } }
-#define TRACE_FATAL(...)      { if (dwTraceLevel >= TRACE_LEVEL_FATAL)   { printf("-F- " __VA_ARGS__); while(1); } }
-
-#define TRACE_DEBUG_WP(...)   { if (dwTraceLevel >= TRACE_LEVEL_DEBUG)   { printf(__VA_ARGS__); } }
-#define TRACE_INFO_WP(...)    { if (dwTraceLevel >= TRACE_LEVEL_INFO)    { printf(__VA_ARGS__); } }
-#define TRACE_WARNING_WP(...) { if (dwTraceLevel >= TRACE_LEVEL_WARNING) { printf(__VA_ARGS__); } }
-#define TRACE_ERROR_WP(...)   { if (dwTraceLevel >= TRACE_LEVEL_ERROR)   { printf(__VA_ARGS__); } }
-#define TRACE_FATAL_WP(...)   { if (dwTraceLevel >= TRACE_LEVEL_FATAL)   { printf(__VA_ARGS__); while(1); } }
+#define TRACE_DEBUG(...)      { if (dwTraceLevel >= TRACE_LEVEL_DEBUG)   { _TRACE_PRINTF( TRACE_LEVEL_DEBUG, "-D- ", __VA_ARGS__ ); } }
+#define TRACE_INFO(...)       { if (dwTraceLevel >= TRACE_LEVEL_INFO)    { _TRACE_PRINTF( TRACE_LEVEL_INFO, "-I- ", __VA_ARGS__ ); } }
+#define TRACE_WARNING(...)    { if (dwTraceLevel >= TRACE_LEVEL_WARNING) { _TRACE_PRINTF( TRACE_LEVEL_WARNING, "-W- ", __VA_ARGS__ ); } }
+#define TRACE_ERROR(...)      { if (dwTraceLevel >= TRACE_LEVEL_ERROR)   { _TRACE_PRINTF( TRACE_LEVEL_ERROR, "-E- ", __VA_ARGS__ ); } }
+#define TRACE_FATAL(...)      { if (dwTraceLevel >= TRACE_LEVEL_FATAL)   { _TRACE_PRINTF( TRACE_LEVEL_FATAL, "-F- ", __VA_ARGS__ ); while(1); } }
+
+#define TRACE_DEBUG_WP(...)   { if (dwTraceLevel >= TRACE_LEVEL_DEBUG)   { _TRACE_PRINTF_WP( TRACE_LEVEL_DEBUG, __VA_ARGS__ ); } }
+#define TRACE_INFO_WP(...)    { if (dwTraceLevel >= TRACE_LEVEL_INFO)    { _TRACE_PRINTF_WP( TRACE_LEVEL_INFO, __VA_ARGS__ ); } }
+#define TRACE_WARNING_WP(...) { if (dwTraceLevel >= TRACE_LEVEL_WARNING) { _TRACE_PRINTF_WP( TRACE_LEVEL_WARNING, __VA_ARGS__ ); } }
+#define TRACE_ERROR_WP(...)   { if (dwTraceLevel >= TRACE_LEVEL_ERROR)   { _TRACE_PRINTF_WP( TRACE_LEVEL_ERROR, __VA_ARGS__ ); } }
+#define TRACE_FATAL_WP(...)   { if (dwTraceLevel >= TRACE_LEVEL_FATAL)   { _TRACE_PRINTF_WP( TRACE_LEVEL_FATAL, __VA_ARGS__ ); while(1); } }
 
 #else
 
 /* Trace compilation depends on TRACE_LEVEL value */
 #if (TRACE_LEVEL >= TRACE_LEVEL_DEBUG)
-#define TRACE_DEBUG(...)      { printf("-D- " __VA_ARGS__); }
-#define TRACE_DEBUG_WP(...)   { printf(__VA_ARGS__); }
+#define TRACE_DEBUG(...)      { _TRACE_PRINTF( TRACE_LEVEL_DEBUG, "-D- ", __VA_ARGS__ ); }
+#define TRACE_DEBUG_WP(...)   { _TRACE_PRINTF_WP( TRACE_LEVEL_DEBUG, __VA_ARGS__ ); }
 #else
 #define TRACE_DEBUG(...)      { }
 #define TRACE_DEBUG_WP(...)   { }
 #endif
 
 #if (TRACE_LEVEL >= TRACE_LEVEL_INFO)
-#define TRACE_INFO(...)       { printf("-I- " __VA_ARGS__); }
-#define TRACE_INFO_WP(...)    { printf(__VA_ARGS__); }
+#define TRACE_INFO(...)       { _TRACE_PRINTF( TRACE_LEVEL_INFO, "-I- ", __VA_ARGS__ ); }
+#define TRACE_INFO_WP(...)    { _TRACE_PRINTF_WP( TRACE_LEVEL_INFO, __VA_ARGS__ ); }
 #else
 #define TRACE_INFO(...)       { }
 #define TRACE_INFO_WP(...)    { }
 #endif
 
 #if (TRACE_LEVEL >= TRACE_LEVEL_WARNING)
-#define TRACE_WARNING(...)    { printf("-W- " __VA_ARGS__); }
-#define TRACE_WARNING_WP(...) { printf(__VA_ARGS__); }
+#define TRACE_WARNING(...)    { _TRACE_PRINTF( TRACE_LEVEL_WARNING, "-W- ", __VA_ARGS__ ); }
+#define TRACE_WARNING_WP(...) { _TRACE_PRINTF_WP( TRACE_LEVEL_WARNING, __VA_ARGS__ ); }
 #else
 #define TRACE_WARNING(...)    { }
 #define TRACE_WARNING_WP(...) { }
 #endif
 
 #if (TRACE_LEVEL >= TRACE_LEVEL_ERROR)
-#define TRACE_ERROR(...)      { printf("-E- " __VA_ARGS__); }
-#define TRACE_ERROR_WP(...)   { printf(__VA_ARGS__); }
+#define TRACE_ERROR(...)      { _TRACE_PRINTF( TRACE_LEVEL_ERROR, "-E- ", __VA_ARGS__ ); }
+#define TRACE_ERROR_WP(...)   { _TRACE_PRINTF_WP( TRACE_LEVEL_ERROR, __VA_ARGS__ ); }
 #else
 #define TRACE_ERROR(...)      { }
 #define TRACE_ERROR_WP(...)   { }
 #endif
 
 #if (TRACE_LEVEL >= TRACE_LEVEL_FATAL)
-#define TRACE_FATAL(...)      { printf("-F- " __VA_ARGS__); while(1); }
-#define TRACE_FATAL_WP(...)   { printf(__VA_ARGS__); while(1); }
+#define TRACE_FATAL(...)      { _TRACE_PRINTF( TRACE_LEVEL_FATAL, "-F- ", __VA_ARGS__ ); while(1); }
+#define TRACE_FATAL_WP(...)   { _TRACE_PRINTF_WP( TRACE_LEVEL_FATAL, __VA_ARGS__ ); while(1); }
 #else
 #define TRACE_FATAL(...)      { while(1); }
 #define TRACE_FATAL_WP(...)   { while(1); }
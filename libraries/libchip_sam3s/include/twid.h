@@ -44,6 +44,12 @@
 
 /** TWI driver is currently busy. */
 #define TWID_ERROR_BUSY              1
+/** A slave did not acknowledge a transaction segment. */
+#define TWID_ERROR_NACK              2
+
+/** Transaction segment directions. */
+#define TWID_SEGMENT_WRITE           0
+#define TWID_SEGMENT_READ            1
 
 #ifdef __cplusplus
  extern "C" {
@@ -53,13 +59,56 @@
  *        Types
  *----------------------------------------------------------------------------*/
 
+/** \brief One read or write access of a TWI transaction.*/
+typedef struct _TwidSegment
+{
+    /** TWI slave address.*/
+    uint8_t address ;
+    /** Internal address size in bytes.*/
+    uint8_t isize ;
+    /** TWID_SEGMENT_READ or TWID_SEGMENT_WRITE.*/
+    uint8_t direction ;
+    /** Optional slave internal address.*/
+    uint32_t iaddress ;
+    /** Data buffer to send or to store the received bytes.*/
+    uint8_t *pData ;
+    /** Number of bytes to transfer (at least one).*/
+    uint32_t num ;
+} TwidSegment ;
+
+struct _TwidTransaction ;
+
+/** TWI transaction callback function.*/
+typedef void (*TwidTransactionCallback)( struct _TwidTransaction * ) ;
+
+/** \brief List of segments executed back to back by TWID_Transaction().*/
+typedef struct _TwidTransaction
+{
+    /** Transaction status: ASYNC_STATUS_PENDING, 0 or TWID_ERROR_NACK.*/
+    volatile uint8_t status ;
+    /** Number of segments.*/
+    uint8_t numSegments ;
+    /** Index of the segment being transferred (index of the failed segment on error).*/
+    volatile uint8_t current ;
+    /** Array of segments.*/
+    TwidSegment *pSegments ;
+    /** Optional function invoked when the transaction completes or fails.*/
+    TwidTransactionCallback callback ;
+    /** Optional argument of the callback.*/
+    void *pArgument ;
+} TwidTransaction ;
+
 /** \brief TWI driver structure. Holds the internal state of the driver.*/
 typedef struct _Twid
 {
     /** Pointer to the underlying TWI peripheral.*/
     Twi *pTwi ;
+    /** Peripheral ID of the TWI, its clock is taken during the transfers.*/
+    uint8_t twiId ;
     /** Current asynchronous transfer being processed.*/
     Async *pTransfer ;
+    /** Current transaction being processed.*/
+    TwidTransaction *pTransaction ;
 } Twid;
 
 /*----------------------------------------------------------------------------
@@ -87,6 +136,10 @@ extern uint8_t TWID_Write(
     uint32_t num,
     Async *pAsync);
 
+extern uint8_t TWID_Transaction( Twid *pTwid, TwidTransaction *pTransaction ) ;
+
+extern void TWID_AsyncCallback( TwidTransaction *pTransaction ) ;
+
 #ifdef __cplusplus
 }
 #endif
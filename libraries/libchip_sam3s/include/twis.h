@@ -0,0 +1,124 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Interface of the TWI slave register-file driver.
+ *
+ */
+
+#ifndef _TWIS_
+#define _TWIS_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "chip.h"
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definition
+ *----------------------------------------------------------------------------*/
+
+/** Invalid register address size or register file. */
+#define TWIS_ERROR_PARAM             1
+
+/** Driver states. */
+#define TWIS_STATE_IDLE              0
+#define TWIS_STATE_ADDRESS           1
+#define TWIS_STATE_WRITE             2
+#define TWIS_STATE_READ              3
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+struct _Twis ;
+
+/** Invoked at the end of each master write, with the offset and number of
+    bytes written (the range wraps at the end of the register file). */
+typedef void (*TwisCallback)( struct _Twis* pTwis, uint32_t dwOffset, uint32_t dwLength ) ;
+
+/** \brief TWI slave driver structure. Holds the internal state of the driver.*/
+typedef struct _Twis
+{
+    /** Pointer to the underlying TWI peripheral.*/
+    Twi* pTwi ;
+    /** Peripheral ID of the TWI.*/
+    uint8_t twiId ;
+    /** Register address size in bytes (1 or 2).*/
+    uint8_t isize ;
+    /** TWIS_STATE_xxx.*/
+    volatile uint8_t state ;
+    /** Register address received from the master, MSB first.*/
+    uint8_t abAddress[2] ;
+    /** Register file.*/
+    uint8_t* pRegs ;
+    /** Register file size in bytes.*/
+    uint32_t dwSize ;
+    /** Register pointer, where the next access starts.*/
+    volatile uint32_t dwPointer ;
+    /** Bytes transferred by completed wraps of the register file.*/
+    uint32_t dwWrapped ;
+    /** Registers written since the last TWIS_GetChanges(): first, end (excluded).*/
+    volatile uint32_t dwDirtyFirst ;
+    volatile uint32_t dwDirtyEnd ;
+    /** Optional function invoked at the end of each master write.*/
+    TwisCallback callback ;
+    /** Optional argument of the callback.*/
+    void* pArgument ;
+} Twis ;
+
+/*----------------------------------------------------------------------------
+ *        Export functions
+ *----------------------------------------------------------------------------*/
+
+extern uint32_t TWIS_Configure( Twis* pTwis, Twi* pTwi, uint8_t twiId, uint8_t address,
+                                uint8_t isize, uint8_t* pRegs, uint32_t dwSize ) ;
+
+extern void TWIS_SetCallback( Twis* pTwis, TwisCallback callback, void* pArgument ) ;
+
+extern void TWIS_Handler( Twis* pTwis ) ;
+
+extern uint32_t TWIS_GetChanges( Twis* pTwis, uint32_t* pdwOffset ) ;
+
+extern void TWIS_Stop( Twis* pTwis ) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _TWIS_ */
@@ -49,6 +49,10 @@
  *    with USART_IsDataAvailable.
  * -# Disable the transmitter and/or the receiver of the USART with
  *    USART_SetTransmitterEnabled and USART_SetReceiverEnabled.
+ *
+ * For a continuous reception, USART_RingStart makes the PDC fill a circular
+ * buffer forever, the receiver time-out marking the end of the frames; the
+ * data is accessed in place with USART_RingPeek and USART_RingConsume.
  */
 
 #ifndef _USART_
@@ -95,6 +99,40 @@
  extern "C" {
 #endif
 
+/*------------------------------------------------------------------------------*/
+/*         Types                                                                */
+/*------------------------------------------------------------------------------*/
+
+struct _UsartRing ;
+
+/** Function invoked by USART_RingHandler at the end of each frame.*/
+typedef void (*UsartRingCallback)( struct _UsartRing *pRing ) ;
+
+/**
+ * \brief Continuous PDC reception in a circular buffer. The buffer is made of
+ * two halves, the PDC current and next banks, the handler re-arming the next
+ * bank each time one becomes full. The counters are free running.
+ */
+typedef struct _UsartRing
+{
+    /** USART peripheral.*/
+    Usart *pUsart ;
+    /** Circular buffer.*/
+    uint8_t *pBuffer ;
+    /** Size of one PDC bank, half of the buffer.*/
+    uint32_t bankSize ;
+    /** Number of banks filled by the PDC.*/
+    volatile uint32_t banks ;
+    /** Number of bytes received at the end of the last frame.*/
+    volatile uint32_t frameEnd ;
+    /** Number of bytes consumed.*/
+    uint32_t consumed ;
+    /** Number of bytes lost because the buffer was full.*/
+    uint32_t overruns ;
+    /** Optional function invoked at the end of each frame.*/
+    UsartRingCallback callback ;
+} UsartRing ;
+
 /*------------------------------------------------------------------------------*/
 /*         Exported functions                                                   */
 /*------------------------------------------------------------------------------*/
@@ -125,6 +163,20 @@ extern uint32_t USART_IsRxReady( Usart *usart ) ;
 
 extern uint8_t USART_GetChar( Usart *usart ) ;
 
+extern void USART_RingStart( UsartRing *pRing, Usart *usart, uint8_t *pBuffer, uint32_t size, uint32_t timeout ) ;
+
+extern void USART_RingStop( UsartRing *pRing ) ;
+
+extern void USART_RingHandler( UsartRing *pRing ) ;
+
+extern uint32_t USART_RingGetReceived( UsartRing *pRing ) ;
+
+extern uint32_t USART_RingPeek( UsartRing *pRing, uint8_t **ppData ) ;
+
+extern void USART_RingConsume( UsartRing *pRing, uint32_t size ) ;
+
+extern uint32_t USART_RingGetFrameSize( UsartRing *pRing ) ;
+
 #ifdef __cplusplus
 }
 #endif
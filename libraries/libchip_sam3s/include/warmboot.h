@@ -0,0 +1,139 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * \section Purpose
+ * Warm wake from backup mode: a checkpoint of the application state kept
+ * across backup mode, so that the boot following a wake-up can skip what a
+ * cold boot has to rebuild (NAND block scan, splash screen and menus, sensor
+ * calibration...).
+ *
+ * The checkpoint has two parts:
+ * - the general purpose backup registers GPBR4 to GPBR6, powered in backup
+ *   mode: a header word, the RTC time of the save and one application word.
+ *   They are written at every save.
+ * - a page of the internal flash holding tagged records of up to
+ *   WARMBOOT_MAX_RECORD bytes (FTL checkpoint position, GUI page, sensor
+ *   state...). The page is only programmed when the records changed since
+ *   the last save, so that a logger waking every few seconds with the same
+ *   records does not wear the flash.
+ * The backup register header gives the sequence number of the flash page
+ * saved along, a page from an older save is never used.
+ *
+ * A boot is warm only after a backup reset (RSTC_SR RSTTYP 1) with a valid
+ * header. The header is cleared by \ref WARMBOOT_Restore(), a second wake-up
+ * without save thus boots cold.
+ *
+ * GPBR4 to GPBR6 are also context words of the watchdog supervisor
+ * post-mortem record: do not use WDT_SupervisorSetContext() along.
+ *
+ * \section Usage
+ * -# At the start of main(), call \ref WARMBOOT_Restore(). It returns 1 on a
+ *    warm boot, and the records saved before the backup mode can be read with
+ *    \ref WARMBOOT_Get() and \ref WARMBOOT_GetWord(); \ref WARMBOOT_GetElapsed()
+ *    gives the time spent in backup mode.
+ * -# Take the fast path where a record allows it, else initialize as on a
+ *    cold boot.
+ * -# Before entering backup mode, update the records with \ref WARMBOOT_Set()
+ *    and \ref WARMBOOT_SetWord(), then call \ref WARMBOOT_Save(). The flash
+ *    driver must have been initialized with FLASHD_Initialize().
+ * -# \ref WARMBOOT_Invalidate() makes the next wake-up boot cold, e.g. after a
+ *    configuration change the records do not cover.
+ *
+ * The flash page at WARMBOOT_FLASH_ADDR, the last one by default, must be
+ * left out of the code by the linker script.
+ */
+
+#ifndef _WARMBOOT_
+#define _WARMBOOT_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Flash page of the records, page aligned */
+#ifndef WARMBOOT_FLASH_ADDR
+#define WARMBOOT_FLASH_ADDR     (IFLASH_ADDR + IFLASH_SIZE - IFLASH_PAGE_SIZE)
+#endif
+
+/** Largest record, in bytes */
+#define WARMBOOT_MAX_RECORD     64
+
+/** Record tags, 1 to 255 */
+#define WARMBOOT_TAG_TIME       1   /**< Timestamps aligned on the RTC, e.g. next log slot */
+#define WARMBOOT_TAG_FTL        2   /**< Mount checkpoint of the NAND translation layer */
+#define WARMBOOT_TAG_GUI        3   /**< Current GUI page */
+#define WARMBOOT_TAG_SENSOR     4   /**< Sensor configuration and calibration */
+#define WARMBOOT_TAG_USER       16  /**< First application tag */
+
+/** Return codes */
+#define WARMBOOT_OK             0
+#define WARMBOOT_ERROR_SIZE     1   /**< Record too large, or no room left in the page */
+#define WARMBOOT_ERROR_TAG      2   /**< Tag 0 */
+#define WARMBOOT_ERROR_FLASH    3   /**< Page program failed */
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern uint32_t WARMBOOT_Restore( void ) ;
+
+extern uint32_t WARMBOOT_IsWarm( void ) ;
+
+extern uint32_t WARMBOOT_Get( uint32_t dwTag, void* pvData, uint32_t dwSize ) ;
+
+extern uint32_t WARMBOOT_Set( uint32_t dwTag, const void* pvData, uint32_t dwSize ) ;
+
+extern uint32_t WARMBOOT_GetWord( void ) ;
+
+extern void WARMBOOT_SetWord( uint32_t dwValue ) ;
+
+extern uint32_t WARMBOOT_GetElapsed( void ) ;
+
+extern uint32_t WARMBOOT_Save( void ) ;
+
+extern void WARMBOOT_Invalidate( void ) ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _WARMBOOT_ */
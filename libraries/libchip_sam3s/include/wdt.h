@@ -39,6 +39,10 @@
  * -# Restart the watchdog using \ref WDT_Restart().
  * -# Get watchdog status using \ref  WDT_GetStatus().
  * -# Caculate watchdog period value using \ref WDT_GetPeriod().
+ * -# Supervise tasks with \ref WDT_SupervisorRegister(), \ref WDT_SupervisorBeat(),
+ *    \ref WDT_SupervisorStart() and \ref WDT_SupervisorCheck(); report a task
+ *    fault, e.g. a stack overflow, with \ref WDT_SupervisorFault(); read the record
+ *    of the last reset with \ref WDT_SupervisorGetPostMortem().
  */
 
 #ifndef _WDT_
@@ -52,6 +56,51 @@
  extern "C" {
 #endif
 
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Post-mortem culprit when no heartbeat was late */
+#define WDT_SUPERVISOR_NONE   0xFFFFu
+/** Post-mortem culprit of a reset by \ref WDT_SupervisorFault() */
+#define WDT_SUPERVISOR_FAULT  0xFFFEu
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Heartbeat of a supervised task */
+typedef struct _WdtHeartbeat
+{
+    struct _WdtHeartbeat* pNext ;
+    const char* pszName ;
+    /** Deadline, in supervisor checks */
+    uint32_t dwMaxChecks ;
+    /** Written by the task only */
+    volatile uint32_t dwBeats ;
+    /** Beats seen by the last check */
+    uint32_t dwSeen ;
+    /** Checks since the last beat */
+    uint32_t dwMissed ;
+} WdtHeartbeat ;
+
+/** Record of the last reset, from the general purpose backup registers */
+typedef struct _WdtPostMortem
+{
+    /** RSTC_SR RSTTYP: 0 general, 1 backup, 2 watchdog, 3 software, 4 user */
+    uint32_t dwResetType ;
+    /** Index of the late heartbeat, WDT_SUPERVISOR_NONE or WDT_SUPERVISOR_FAULT */
+    uint32_t dwCulprit ;
+    /** Checks the late heartbeat missed, or task of a WDT_SUPERVISOR_FAULT */
+    uint32_t dwMissed ;
+    /** Supervisor checks before the reset */
+    uint32_t dwChecks ;
+    /** Faulting address of a WDT_SUPERVISOR_FAULT */
+    uint32_t dwFaultAddress ;
+    /** Words stored with WDT_SupervisorSetContext() */
+    uint32_t adwContext[4] ;
+} WdtPostMortem ;
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -66,6 +115,20 @@ extern uint32_t WDT_GetStatus( Wdt* pWDT ) ;
 
 extern uint32_t WDT_GetPeriod( uint32_t dwMs ) ;
 
+extern uint32_t WDT_SupervisorRegister( WdtHeartbeat* pHeartbeat, const char* pszName, uint32_t dwMaxChecks ) ;
+
+extern void WDT_SupervisorBeat( WdtHeartbeat* pHeartbeat ) ;
+
+extern void WDT_SupervisorStart( void ) ;
+
+extern void WDT_SupervisorSetContext( uint32_t dwIndex, uint32_t dwValue ) ;
+
+extern void WDT_SupervisorCheck( Wdt* pWDT ) ;
+
+extern void WDT_SupervisorFault( uint32_t dwTask, uint32_t dwAddress ) ;
+
+extern uint32_t WDT_SupervisorGetPostMortem( WdtPostMortem* pPostMortem ) ;
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,105 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Deferred interrupt work queue.
+ *
+ * An interrupt handler posts a work item (a function, a pointer and a word)
+ * and returns; the item runs later, in FIFO order, out of the interrupt
+ * context. The interrupts of higher priority, e.g. PWM control loops, thus
+ * no longer wait behind long processing done in the handlers.
+ *
+ * The items are run by WORKQ_Run(), called by the worker the queue kicks
+ * when it stops being empty:
+ * <ul>
+ * <li> Bare metal: WORKQ_InitializePendSV() runs the items from PendSV_Handler,
+ *    at the lowest exception priority, i.e. after all the pending interrupts
+ *    but before the main loop.</li>
+ * <li> FreeRTOS: WORKQ_StartTask() (FreeRTOS drivers, workq_task.h) runs them
+ *    in a task of high priority.</li>
+ * <li> CoOS, or any other kernel: give WORKQ_Initialize() a kick function
+ *    posting a semaphore (isr_PostSem() under CoOS), and let a task of high
+ *    priority wait for it and call WORKQ_Run().</li>
+ * </ul>
+ * The queue can be posted to from any interrupt priority and from the main
+ * context; the posting masks the interrupts for a few instructions only.
+ *
+ * USBD_HAL_SetDeferredIrq() moves the processing of the USB device interrupt,
+ * class requests and transfer callbacks included, to the queue.
+ *
+ */
+
+#ifndef _WORKQ_
+#define _WORKQ_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definition
+ *----------------------------------------------------------------------------*/
+
+/** Number of work items the queue can hold. */
+#ifndef WORKQ_SIZE
+#define WORKQ_SIZE  16
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Work function, called with the pointer and the word given when posted. */
+typedef void (*WorkFunc)( void* pArg, uint32_t dwParam ) ;
+
+/** Function waking up the worker, called from the posting context. */
+typedef void (*WorkKick)( void ) ;
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern void WORKQ_Initialize( WorkKick fKick ) ;
+
+extern void WORKQ_InitializePendSV( void ) ;
+
+extern uint32_t WORKQ_Post( WorkFunc fFunc, void* pArg, uint32_t dwParam ) ;
+
+extern uint32_t WORKQ_Run( void ) ;
+
+extern uint32_t WORKQ_GetPending( void ) ;
+
+extern uint32_t WORKQ_GetHighWater( void ) ;
+
+extern uint32_t WORKQ_GetOverflows( void ) ;
+
+#endif /* #ifndef _WORKQ_ */
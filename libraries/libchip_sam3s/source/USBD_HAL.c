@@ -51,6 +51,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
 /*---------------------------------------------------------------------------
  *      Definitions
@@ -111,6 +112,7 @@
  *  - UDP_ENDPOINT_RECEIVING
  *  - UDP_ENDPOINT_SENDINGM
  *  - UDP_ENDPOINT_RECEIVINGM
+ *  - UDP_ENDPOINT_STREAMING
  */
 
 /**  Endpoint states: Endpoint is disabled */
@@ -127,6 +129,8 @@
 #define UDP_ENDPOINT_SENDINGM       5
 /**  Endpoint states: Endpoint is receiving MBL */
 #define UDP_ENDPOINT_RECEIVINGM     6
+/**  Endpoint states: Endpoint is streaming from a buffer ring */
+#define UDP_ENDPOINT_STREAMING      7
 
 /**
  *  \section udp_csr_register_access_sec "UDP CSR register access"
@@ -211,6 +215,13 @@
 /** Buffer list is null */
 #define MBL_NULL        2
 
+/** Transfer type: single buffer */
+#define UDP_TRANS_SINGLE    0
+/** Transfer type: multi-buffer list */
+#define UDP_TRANS_MBL       1
+/** Transfer type: double-bank stream from a buffer ring */
+#define UDP_TRANS_STREAM    2
+
 /*---------------------------------------------------------------------------
  *      Types
  *---------------------------------------------------------------------------*/
@@ -243,6 +254,10 @@ typedef struct {
     int32_t          transferred;
     /**  Number of bytes which have not been buffered/transferred yet. */
     int32_t          remaining;
+    /**  Current descriptor of a scatter-gather list (NULL if single). */
+    USBDTransferBuffer *pList;
+    /**  Number of descriptors left after the current one. */
+    uint16_t         listLeft;
 } Transfer;
 
 /**  Describes Multi Buffer List transfer on a UDP endpoint. */
@@ -269,6 +284,36 @@ typedef struct {
     uint16_t            inCurr;
 } MblTransfer;
 
+/**  Describes a ping-pong stream transfer on a UDP IN endpoint. */
+typedef struct {
+    /**  Optional callback invoked for each buffer sent and on underrun. */
+    MblTransferCallback fCallback;
+    /**  Optional argument to the callback function. */
+    void                *pArgument;
+    /** Transfer type */
+    volatile uint8_t    transType;
+    /**  Number of packets loaded in the FIFO banks (0..2) */
+    volatile uint8_t    banks;
+    /**  Index of the oldest loaded packet in pktDone (run time) */
+    uint8_t             pktHead;
+    /**  Number of buffers each loaded packet finishes */
+    uint8_t             pktDone[2];
+    /**  Buffer ring size */
+    uint16_t            listSize;
+    /**  Pointer to the buffer ring */
+    USBDTransferBuffer *pMbl;
+    /**  Oldest buffer not yet released to the caller (run time) */
+    uint16_t            doneCurr;
+    /**  Buffer being loaded into the FIFO (run time) */
+    uint16_t            outCurr;
+    /**  Next free ring slot (run time) */
+    uint16_t            inCurr;
+    /**  Buffers in the ring, not released yet */
+    volatile uint16_t   queued;
+    /**  Buffers which still have data to load into the FIFO */
+    volatile uint16_t   pending;
+} StreamTransfer;
+
 /**
  *  Describes the state of an endpoint of the UDP controller.
  */
@@ -288,6 +333,7 @@ typedef struct {
         TransferHeader transHdr;
         Transfer       singleTransfer;
         MblTransfer    mblTransfer;
+        StreamTransfer streamTransfer;
     } transfer;
 } Endpoint;
 
@@ -298,6 +344,31 @@ typedef struct {
 /** Holds the internal state for each endpoint of the UDP. */
 static Endpoint endpoints[CHIP_USB_NUMENDPOINTS];
 
+/** 1 when the UDP interrupt is processed from the work queue. */
+static uint8_t deferredIrq = 0;
+
+/** 1 when the time spent servicing the UDP interrupt is measured. */
+static uint8_t irqStatsOn = 0;
+
+/** Time spent servicing the UDP interrupt. */
+static USBDIrqStats irqStats;
+
+/** Counters of each endpoint, updated while irqStatsOn. */
+static USBDEPStats epStats[CHIP_USB_NUMENDPOINTS];
+
+#if CHIP_USB_NUMENDPOINTS > USBD_STATS_ENDPOINTS
+#error USBD_STATS_ENDPOINTS is too small for the UDP endpoints
+#endif
+
+/** Clock setting of the suspended device, see USBD_HAL_SetSuspendPowerMode(). */
+static uint8_t suspendPowerMode = USBD_SUSPEND_RUN;
+
+/** Working clock saved while the master clock runs from the slow clock. */
+static PmcClockConfig suspendClock;
+
+/** 1 while the master clock runs from the slow clock. */
+static uint8_t suspendClockDropped = 0;
+
 /*---------------------------------------------------------------------------
  *      Internal Functions
  *---------------------------------------------------------------------------*/
@@ -355,6 +426,20 @@ static inline void UDP_DisableTransceiver(void)
     UDP->UDP_TXVC |= UDP_TXVC_TXVDIS;
 }
 
+/**
+ * Restores the working clock if the device was suspended in
+ * USBD_SUSPEND_SLOWCLOCK mode.
+ */
+static void UDP_RestoreWorkingClock(void)
+{
+    if (suspendClockDropped) {
+
+        PMC_RestoreMck(&suspendClock);
+        PMC->PMC_FSMR &= ~(uint32_t)PMC_FSMR_USBAL;
+        suspendClockDropped = 0;
+    }
+}
+
 /**
  * Handles a completed transfer on the given endpoint, invoking the
  * configured callback if any.
@@ -382,6 +467,8 @@ static void UDP_EndOfTransfer(uint8_t bEndpoint, uint8_t bStatus)
         pTransfer->transferred = -1;
         pTransfer->buffered = -1;
         pTransfer->remaining = -1;
+        pTransfer->pList = 0;
+        pTransfer->listLeft = 0;
 
         // Invoke callback is present
         if (pTransfer->fCallback != 0) {
@@ -422,6 +509,23 @@ static void UDP_EndOfTransfer(uint8_t bEndpoint, uint8_t bStatus)
             TRACE_DEBUG_WP("NoCB ");
         }
     }
+    else if (pEndpoint->state == UDP_ENDPOINT_STREAMING) {
+
+        StreamTransfer *pStream = (StreamTransfer*)&(pEndpoint->transfer);
+
+        TRACE_DEBUG_WP("EoST ");
+
+        /* Endpoint returns in Idle state, drop queued buffers */
+        pEndpoint->state = UDP_ENDPOINT_IDLE;
+        pStream->banks = 0;
+        pStream->queued = pStream->pending = 0;
+        pStream->doneCurr = pStream->outCurr = pStream->inCurr = 0;
+        /* Invoke callback */
+        if (pStream->fCallback != 0) {
+
+            pStream->fCallback(pStream->pArgument, bStatus);
+        }
+    }
 }
 
 /**
@@ -449,6 +553,135 @@ static void UDP_ClearRxFlag(uint8_t bEndpoint)
     }
 }
 
+/**
+ * Pushes a block of bytes into an endpoint FIFO.
+ * The UDP FIFO data port is byte wide, so the speed-up comes from fetching
+ * the source one word at a time when it is aligned and from unrolling the
+ * store sequence: full 64-byte (and multiples) packets use a 16-bytes
+ * unrolled loop, smaller packets an 8-bytes one, and the tail is byte-copied.
+ * \param bEndpoint Endpoint number.
+ * \param pBytes    Pointer to the source data.
+ * \param size      Number of bytes to write.
+ */
+IRQ_RAMFUNC static void UDP_WriteFifo(uint8_t bEndpoint,
+                          const uint8_t *pBytes,
+                          int32_t size)
+{
+    volatile uint32_t *pFifo = &(UDP->UDP_FDR[bEndpoint]);
+
+    if (irqStatsOn)
+        epStats[bEndpoint].dwBytes += size;
+
+    /* Aligned source: load one word for every 4 FIFO writes */
+    if ((((uint32_t)pBytes) & 0x3) == 0) {
+
+        const uint32_t *pWords = (const uint32_t *)pBytes;
+        uint32_t w;
+
+        /* 64 and 256/512 bytes packets: 16 bytes per iteration */
+        if (size >= 64) {
+            int32_t c16 = size >> 4;
+            for (; c16; c16 --) {
+                w = *(pWords ++);
+                *pFifo = w; *pFifo = w >> 8; *pFifo = w >> 16; *pFifo = w >> 24;
+                w = *(pWords ++);
+                *pFifo = w; *pFifo = w >> 8; *pFifo = w >> 16; *pFifo = w >> 24;
+                w = *(pWords ++);
+                *pFifo = w; *pFifo = w >> 8; *pFifo = w >> 16; *pFifo = w >> 24;
+                w = *(pWords ++);
+                *pFifo = w; *pFifo = w >> 8; *pFifo = w >> 16; *pFifo = w >> 24;
+            }
+            size &= 0xF;
+        }
+        /* 8 bytes packets (and remaining of larger ones) */
+        for (; size >= 4; size -= 4) {
+            w = *(pWords ++);
+            *pFifo = w; *pFifo = w >> 8; *pFifo = w >> 16; *pFifo = w >> 24;
+        }
+        pBytes = (const uint8_t *)pWords;
+    }
+    /* Unaligned source: 8 bytes per iteration */
+    else {
+        int32_t c8 = size >> 3;
+        for (; c8; c8 --) {
+            *pFifo = *(pBytes ++); *pFifo = *(pBytes ++);
+            *pFifo = *(pBytes ++); *pFifo = *(pBytes ++);
+            *pFifo = *(pBytes ++); *pFifo = *(pBytes ++);
+            *pFifo = *(pBytes ++); *pFifo = *(pBytes ++);
+        }
+        size &= 0x7;
+    }
+    /* Tail */
+    for (; size; size --) {
+        *pFifo = *(pBytes ++);
+    }
+}
+
+/**
+ * Pulls a block of bytes out of an endpoint FIFO.
+ * When the destination is aligned, four FIFO reads are packed into one
+ * word store; see UDP_WriteFifo() for the unrolling scheme.
+ * \param bEndpoint Endpoint number.
+ * \param pBytes    Pointer to the destination buffer.
+ * \param size      Number of bytes to read.
+ */
+IRQ_RAMFUNC static void UDP_ReadFifo(uint8_t bEndpoint,
+                         uint8_t *pBytes,
+                         int32_t size)
+{
+    volatile uint32_t *pFifo = &(UDP->UDP_FDR[bEndpoint]);
+
+    if (irqStatsOn)
+        epStats[bEndpoint].dwBytes += size;
+
+    /* Aligned destination: store one word for every 4 FIFO reads */
+    if ((((uint32_t)pBytes) & 0x3) == 0) {
+
+        uint32_t *pWords = (uint32_t *)pBytes;
+        uint32_t w;
+
+        if (size >= 64) {
+            int32_t c16 = size >> 4;
+            for (; c16; c16 --) {
+                w  = (*pFifo & 0xFF);       w |= (*pFifo & 0xFF) << 8;
+                w |= (*pFifo & 0xFF) << 16; w |= (*pFifo & 0xFF) << 24;
+                *(pWords ++) = w;
+                w  = (*pFifo & 0xFF);       w |= (*pFifo & 0xFF) << 8;
+                w |= (*pFifo & 0xFF) << 16; w |= (*pFifo & 0xFF) << 24;
+                *(pWords ++) = w;
+                w  = (*pFifo & 0xFF);       w |= (*pFifo & 0xFF) << 8;
+                w |= (*pFifo & 0xFF) << 16; w |= (*pFifo & 0xFF) << 24;
+                *(pWords ++) = w;
+                w  = (*pFifo & 0xFF);       w |= (*pFifo & 0xFF) << 8;
+                w |= (*pFifo & 0xFF) << 16; w |= (*pFifo & 0xFF) << 24;
+                *(pWords ++) = w;
+            }
+            size &= 0xF;
+        }
+        for (; size >= 4; size -= 4) {
+            w  = (*pFifo & 0xFF);       w |= (*pFifo & 0xFF) << 8;
+            w |= (*pFifo & 0xFF) << 16; w |= (*pFifo & 0xFF) << 24;
+            *(pWords ++) = w;
+        }
+        pBytes = (uint8_t *)pWords;
+    }
+    /* Unaligned destination: 8 bytes per iteration */
+    else {
+        int32_t c8 = size >> 3;
+        for (; c8; c8 --) {
+            *(pBytes ++) = (uint8_t)*pFifo; *(pBytes ++) = (uint8_t)*pFifo;
+            *(pBytes ++) = (uint8_t)*pFifo; *(pBytes ++) = (uint8_t)*pFifo;
+            *(pBytes ++) = (uint8_t)*pFifo; *(pBytes ++) = (uint8_t)*pFifo;
+            *(pBytes ++) = (uint8_t)*pFifo; *(pBytes ++) = (uint8_t)*pFifo;
+        }
+        size &= 0x7;
+    }
+    /* Tail */
+    for (; size; size --) {
+        *(pBytes ++) = (uint8_t)*pFifo;
+    }
+}
+
 /**
  * Update multi-buffer-transfer descriptors.
  * \param pTransfer Pointer to instance MblTransfer.
@@ -489,6 +722,42 @@ static uint8_t UDP_MblUpdate(MblTransfer *pTransfer,
     return 0;
 }
 
+/**
+ * Transfers a received data payload from the endpoint FIFO into the current
+ * buffer of the multi-buffer list, in place. A buffer ends when it is full,
+ * on a short packet, or after each packet of an isochronous endpoint, so that
+ * one ring buffer holds exactly one audio frame.
+ * \param bEndpoint   Number of the endpoint which is receiving data.
+ * \param wPacketSize Size of the received packet.
+ * \return 1 if current buffer ended.
+ */
+static uint8_t UDP_MblReadPayload(uint8_t bEndpoint, uint16_t wPacketSize)
+{
+    Endpoint    *pEndpoint   = &(endpoints[bEndpoint]);
+    MblTransfer *pTransfer   = (MblTransfer*)&(pEndpoint->transfer);
+    USBDTransferBuffer *pBi = &(pTransfer->pMbl[pTransfer->outCurr]);
+    uint32_t status = UDP->UDP_CSR[bEndpoint];
+    uint16_t size = wPacketSize;
+    uint8_t forceEnd;
+
+    /* Data beyond the buffer end is discarded */
+    if (size > pBi->remaining) {
+
+        TRACE_WARNING("MblRd: %d bytes lost\n\r", size - pBi->remaining);
+        size = pBi->remaining;
+    }
+    if (size) {
+
+        UDP_ReadFifo(bEndpoint, &(pBi->pBuffer[pBi->transferred]), size);
+    }
+    pBi->transferred += size;
+
+    forceEnd = (wPacketSize < pEndpoint->size)
+            || ((status & UDP_CSR_EPTYPE_Msk) == UDP_CSR_EPTYPE_ISO_OUT);
+
+    return UDP_MblUpdate(pTransfer, pBi, size, forceEnd);
+}
+
 /**
  * Transfers a data payload from the current tranfer buffer to the endpoint
  * FIFO
@@ -501,7 +770,7 @@ static uint8_t UDP_MblWriteFifo(uint8_t bEndpoint)
     USBDTransferBuffer *pBi = &(pTransfer->pMbl[pTransfer->outCurr]);
     int32_t size;
 
-    volatile uint8_t * pBytes;
+    uint8_t * pBytes;
     volatile uint8_t bufferEnd = 1;
 
     /* Get the number of bytes to send */
@@ -519,24 +788,117 @@ static uint8_t UDP_MblWriteFifo(uint8_t bEndpoint)
 
     /* Write packet in the FIFO buffer */
     if (size) {
-        int32_t c8 = size >> 3;
-        int32_t c1 = size & 0x7;
-        for (; c8; c8 --) {
-            UDP->UDP_FDR[bEndpoint] = *(pBytes ++);
-            UDP->UDP_FDR[bEndpoint] = *(pBytes ++);
-            UDP->UDP_FDR[bEndpoint] = *(pBytes ++);
-            UDP->UDP_FDR[bEndpoint] = *(pBytes ++);
-
-            UDP->UDP_FDR[bEndpoint] = *(pBytes ++);
-            UDP->UDP_FDR[bEndpoint] = *(pBytes ++);
-            UDP->UDP_FDR[bEndpoint] = *(pBytes ++);
-            UDP->UDP_FDR[bEndpoint] = *(pBytes ++);
+        UDP_WriteFifo(bEndpoint, pBytes, size);
+    }
+    return bufferEnd;
+}
+
+/**
+ * Loads one packet of a stream transfer into the free FIFO bank.
+ * Unlike UDP_MblWriteFifo(), a packet can span several ring buffers so that
+ * only the last packet before an underrun may be short.
+ * \param bEndpoint Number of the endpoint which is streaming data.
+ */
+static void UDP_StreamWriteFifo(uint8_t bEndpoint)
+{
+    Endpoint       *pEndpoint = &(endpoints[bEndpoint]);
+    StreamTransfer *pStream   = (StreamTransfer*)&(pEndpoint->transfer);
+    USBDTransferBuffer *pBi;
+    int32_t  free = pEndpoint->size;
+    int32_t  size;
+    uint8_t  done = 0;
+
+    while (free && pStream->pending) {
+
+        pBi = &(pStream->pMbl[pStream->outCurr]);
+        size = pBi->remaining;
+        if (size > free) size = free;
+
+        UDP_WriteFifo(bEndpoint, &(pBi->pBuffer[pBi->buffered]), size);
+        pBi->buffered  += size;
+        pBi->remaining -= size;
+        free -= size;
+
+        /* Buffer fully loaded, continue with the next one */
+        if (pBi->remaining == 0) {
+
+            done ++;
+            if (++ pStream->outCurr == pStream->listSize)
+                pStream->outCurr = 0;
+            pStream->pending --;
         }
-        for (; c1; c1 --) {
-            UDP->UDP_FDR[bEndpoint] = *(pBytes ++);
+    }
+    TRACE_DEBUG_WP("s%d.%d ", pEndpoint->size - free, done);
+
+    pStream->pktDone[(pStream->pktHead + pStream->banks) & 1] = done;
+    pStream->banks ++;
+}
+
+/**
+ * Releases the ring buffers finished by the packet just sent, notifying the
+ * stream callback with USBD_STATUS_PARTIAL_DONE for each of them.
+ * \param bEndpoint Number of the streaming endpoint.
+ */
+static void UDP_StreamRelease(uint8_t bEndpoint)
+{
+    Endpoint       *pEndpoint = &(endpoints[bEndpoint]);
+    StreamTransfer *pStream   = (StreamTransfer*)&(pEndpoint->transfer);
+    USBDTransferBuffer *pBi;
+    uint8_t done = pStream->pktDone[pStream->pktHead];
+
+    pStream->pktHead ^= 1;
+    pStream->banks --;
+
+    for (; done; done --) {
+
+        pBi = &(pStream->pMbl[pStream->doneCurr]);
+        pBi->transferred = pBi->buffered;
+        pBi->buffered = 0;
+        if (++ pStream->doneCurr == pStream->listSize)
+            pStream->doneCurr = 0;
+        pStream->queued --;
+        if (pStream->fCallback) {
+            pStream->fCallback(pStream->pArgument, USBD_STATUS_PARTIAL_DONE);
         }
     }
-    return bufferEnd;
+}
+
+/**
+ * Moves a payload between an endpoint FIFO and a scatter-gather list,
+ * walking to the next descriptor each time one is exhausted.
+ * \param bEndpoint Endpoint number.
+ * \param pTransfer Pointer to the transfer with a descriptor list.
+ * \param size      Number of bytes to move.
+ * \param bWrite    1 to write the FIFO (IN), 0 to read it (OUT).
+ */
+static void UDP_ListPayload(uint8_t bEndpoint,
+                            Transfer *pTransfer,
+                            int32_t size,
+                            uint8_t bWrite)
+{
+    USBDTransferBuffer *pBi = pTransfer->pList;
+    int32_t chunk;
+
+    while (size > 0) {
+
+        /* Current descriptor done, go on with the next one */
+        if (pBi->remaining == 0) {
+
+            if (pTransfer->listLeft == 0) break;
+            pTransfer->listLeft --;
+            pBi = ++ pTransfer->pList;
+            pTransfer->pData = pBi->pBuffer;
+            continue;
+        }
+
+        chunk = (size > pBi->remaining) ? pBi->remaining : size;
+        if (bWrite) UDP_WriteFifo(bEndpoint, pTransfer->pData, chunk);
+        else        UDP_ReadFifo(bEndpoint, pTransfer->pData, chunk);
+        pTransfer->pData += chunk;
+        pBi->transferred += chunk;
+        pBi->remaining   -= chunk;
+        size -= chunk;
+    }
 }
 
 /**
@@ -562,11 +924,14 @@ static void UDP_WritePayload(uint8_t bEndpoint)
     pTransfer->remaining -= size;
 
     // Write packet in the FIFO buffer
-    while (size > 0) {
+    if (pTransfer->pList) {
 
-        UDP->UDP_FDR[bEndpoint] = *(pTransfer->pData);
-        pTransfer->pData++;
-        size--;
+        UDP_ListPayload(bEndpoint, pTransfer, size, 1);
+    }
+    else if (size > 0) {
+
+        UDP_WriteFifo(bEndpoint, pTransfer->pData, size);
+        pTransfer->pData += size;
     }
 }
 
@@ -593,11 +958,14 @@ static void UDP_ReadPayload(uint8_t bEndpoint, int32_t wPacketSize)
     pTransfer->transferred += wPacketSize;
 
     // Retrieve packet
-    while (wPacketSize > 0) {
+    if (pTransfer->pList) {
 
-        *(pTransfer->pData) = (uint8_t) UDP->UDP_FDR[bEndpoint];
-        pTransfer->pData++;
-        wPacketSize--;
+        UDP_ListPayload(bEndpoint, pTransfer, wPacketSize, 0);
+    }
+    else if (wPacketSize > 0) {
+
+        UDP_ReadFifo(bEndpoint, pTransfer->pData, wPacketSize);
+        pTransfer->pData += wPacketSize;
     }
 }
 
@@ -607,15 +975,8 @@ static void UDP_ReadPayload(uint8_t bEndpoint, int32_t wPacketSize)
  */
 static void UDP_ReadRequest(USBGenericRequest *pRequest)
 {
-    uint8_t *pData = (uint8_t *)pRequest;
-    uint32_t i;
-
     // Copy packet
-    for (i = 0; i < 8; i++) {
-
-        *pData = (uint8_t) UDP->UDP_FDR[0];
-        pData++;
-    }
+    UDP_ReadFifo(0, (uint8_t *)pRequest, 8);
 }
 
 /**
@@ -649,7 +1010,7 @@ static uint8_t UDP_IsTransferFinished(uint8_t bEndpoint)
  * Handle IN/OUT transfers, received SETUP packets and STALLing
  * \param bEndpoint Index of endpoint
  */
-static void UDP_EndpointHandler(uint8_t bEndpoint)
+IRQ_RAMFUNC static void UDP_EndpointHandler(uint8_t bEndpoint)
 {
     Endpoint *pEndpoint = &(endpoints[bEndpoint]);
     Transfer *pTransfer = (Transfer*)&(pEndpoint->transfer);
@@ -666,9 +1027,54 @@ static void UDP_EndpointHandler(uint8_t bEndpoint)
     if ((status & UDP_CSR_TXCOMP) != 0) {
 
         TRACE_DEBUG_WP("Wr ");
+        if (irqStatsOn)
+            epStats[bEndpoint].dwPackets ++;
+
+        // Check that endpoint was in Streaming state
+        if (pEndpoint->state == UDP_ENDPOINT_STREAMING) {
+
+            StreamTransfer *pStream = (StreamTransfer*)&(pEndpoint->transfer);
+
+            TRACE_DEBUG_WP("TxS%d ", pStream->banks);
+
+            UDP_StreamRelease(bEndpoint);
+
+            // The other bank is loaded: validate it then refill this one
+            if (pStream->banks) {
+
+                SET_CSR(bEndpoint, UDP_CSR_TXPKTRDY);
+                CLEAR_CSR(bEndpoint, UDP_CSR_TXCOMP);
+                if (pStream->pending) {
+                    UDP_StreamWriteFifo(bEndpoint);
+                }
+            }
+            // Both banks empty but data fed meanwhile: restart the pair
+            else if (pStream->pending) {
 
+                CLEAR_CSR(bEndpoint, UDP_CSR_TXCOMP);
+                UDP_StreamWriteFifo(bEndpoint);
+                SET_CSR(bEndpoint, UDP_CSR_TXPKTRDY);
+                if ((CHIP_USB_ENDPOINTS_BANKS(bEndpoint) > 1)
+                    && pStream->pending) {
+                    UDP_StreamWriteFifo(bEndpoint);
+                }
+            }
+            // Underrun, back to idle until USBD_HAL_StreamFeed() kicks it
+            else {
+
+                if (irqStatsOn)
+                    epStats[bEndpoint].dwStarved ++;
+                pEndpoint->state = UDP_ENDPOINT_IDLE;
+                UDP->UDP_IDR = 1 << bEndpoint;
+                CLEAR_CSR(bEndpoint, UDP_CSR_TXCOMP);
+                if (pStream->fCallback) {
+                    pStream->fCallback(pStream->pArgument,
+                                       USBD_STATUS_SUCCESS);
+                }
+            }
+        }
         // Check that endpoint was in MBL Sending state
-        if (pEndpoint->state == UDP_ENDPOINT_SENDINGM) {
+        else if (pEndpoint->state == UDP_ENDPOINT_SENDINGM) {
 
             USBDTransferBuffer * pMbli = &(pMblt->pMbl[pMblt->outLast]);
             uint8_t bufferEnd = 0;
@@ -776,8 +1182,34 @@ static void UDP_EndpointHandler(uint8_t bEndpoint)
 
         TRACE_DEBUG_WP("Rd ");
 
+        // Check that the endpoint is receiving into a buffer list
+        if (pEndpoint->state == UDP_ENDPOINT_RECEIVINGM) {
+
+            uint8_t bufferEnd;
+
+            wPacketSize = (uint16_t) (status >> 16);
+            TRACE_DEBUG_WP("%d ", wPacketSize);
+            if (irqStatsOn)
+                epStats[bEndpoint].dwPackets ++;
+            bufferEnd = UDP_MblReadPayload(bEndpoint, wPacketSize);
+            UDP_ClearRxFlag(bEndpoint);
+
+            // Release the filled buffer, the callback may queue new ones
+            if (bufferEnd && pMblt->fCallback) {
+                ((MblTransferCallback) pMblt->fCallback)
+                    (pMblt->pArgument,
+                     USBD_STATUS_PARTIAL_DONE);
+            }
+
+            // No buffer left to receive into
+            if (pMblt->listState == MBL_NULL) {
+
+                UDP->UDP_IDR = 1 << bEndpoint;
+                UDP_EndOfTransfer(bEndpoint, USBD_STATUS_SUCCESS);
+            }
+        }
         // Check that the endpoint is in Receiving state
-        if (pEndpoint->state != UDP_ENDPOINT_RECEIVING) {
+        else if (pEndpoint->state != UDP_ENDPOINT_RECEIVING) {
 
             // Check if an ACK has been received on a Control endpoint
             if (((status & UDP_CSR_EPTYPE_Msk) == UDP_CSR_EPTYPE_CTRL)
@@ -798,6 +1230,8 @@ static void UDP_EndpointHandler(uint8_t bEndpoint)
             else {
 
                 TRACE_DEBUG_WP("Nak ");
+                if (irqStatsOn)
+                    epStats[bEndpoint].dwStarved ++;
                 UDP->UDP_IDR = 1 << bEndpoint;
             }
         }
@@ -807,6 +1241,8 @@ static void UDP_EndpointHandler(uint8_t bEndpoint)
             // Retrieve data and store it into the current transfer buffer
             wPacketSize = (uint16_t) (status >> 16);
             TRACE_DEBUG_WP("%d ", wPacketSize);
+            if (irqStatsOn)
+                epStats[bEndpoint].dwPackets ++;
             UDP_ReadPayload(bEndpoint, wPacketSize);
             UDP_ClearRxFlag(bEndpoint);
 
@@ -827,12 +1263,17 @@ static void UDP_EndpointHandler(uint8_t bEndpoint)
     if ((status & UDP_CSR_STALLSENTISOERROR) != 0) {
 
         CLEAR_CSR(bEndpoint, UDP_CSR_STALLSENTISOERROR);
+        if (irqStatsOn)
+            epStats[bEndpoint].dwStalls ++;
 
         if (   (status & UDP_CSR_EPTYPE_Msk) == UDP_CSR_EPTYPE_ISO_IN
             || (status & UDP_CSR_EPTYPE_Msk) == UDP_CSR_EPTYPE_ISO_OUT ) {
 
             TRACE_WARNING("Isoe [%d] ", bEndpoint);
-            UDP_EndOfTransfer(bEndpoint, USBD_STATUS_ABORTED);
+            // A corrupted packet does not end a buffer list reception
+            if (pEndpoint->state != UDP_ENDPOINT_RECEIVINGM) {
+                UDP_EndOfTransfer(bEndpoint, USBD_STATUS_ABORTED);
+            }
         }
         else {
 
@@ -851,6 +1292,8 @@ static void UDP_EndpointHandler(uint8_t bEndpoint)
     if ((status & UDP_CSR_RXSETUP) != 0) {
 
         TRACE_DEBUG_WP("Stp ");
+        if (irqStatsOn)
+            epStats[bEndpoint].dwPackets ++;
 
         // If a transfer was pending, complete it
         // Handles the case where during the status phase of a control write
@@ -915,6 +1358,8 @@ static inline uint8_t UDP_Write(uint8_t    bEndpoint,
     pTransfer->remaining = dLength;
     pTransfer->buffered = 0;
     pTransfer->transferred = 0;
+    pTransfer->pList = 0;
+    pTransfer->listLeft = 0;
 
     /* Send the first packet */
     pEndpoint->state = UDP_ENDPOINT_SENDING;
@@ -935,6 +1380,36 @@ static inline uint8_t UDP_Write(uint8_t    bEndpoint,
     return USBD_STATUS_SUCCESS;
 }
 
+/**
+ * Initializes a scatter-gather descriptor list for a transfer.
+ * \param pTransfer Pointer to the transfer to set up.
+ * \param pList     Pointer to the descriptor list.
+ * \param listSize  Number of descriptors in the list.
+ * \return Total number of bytes described by the list.
+ */
+static uint32_t UDP_SetupList(Transfer *pTransfer,
+                              USBDTransferBuffer *pList,
+                              uint16_t listSize)
+{
+    uint32_t total = 0;
+    uint16_t i;
+
+    for (i = 0; i < listSize; i ++) {
+
+        pList[i].transferred = 0;
+        pList[i].buffered    = 0;
+        pList[i].remaining   = pList[i].size;
+        total += pList[i].size;
+    }
+    pTransfer->pData       = pList[0].pBuffer;
+    pTransfer->remaining   = total;
+    pTransfer->buffered    = 0;
+    pTransfer->transferred = 0;
+    pTransfer->pList       = pList;
+    pTransfer->listLeft    = listSize - 1;
+    return total;
+}
+
 /**
  * Sends data through a USB endpoint. Sets up the transfer descriptor list,
  * writes one or two data payloads (depending on the number of FIFO bank
@@ -1008,6 +1483,71 @@ static inline uint8_t UDP_AddWr(uint8_t    bEndpoint,
     return USBD_STATUS_SUCCESS;
 }
 
+/**
+ * Add a buffer to the multi-buffer-list of an OUT endpoint, reception starts
+ * with the first buffer queued. The packets are read by the endpoint handler
+ * directly into the queued buffers, which are released in order through the
+ * MBL callback (USBD_STATUS_PARTIAL_DONE) and then owned by the application
+ * until queued again: a buffer can be played from where it was received.
+ *
+ * *The buffer must be kept allocated until it is released*.
+ *
+ * \param bEndpoint Endpoint number.
+ * \param pData Pointer to a buffer for the data to receive.
+ * \param dLength Size of the data buffer.
+ * \return USBD_STATUS_SUCCESS if the buffer has been queued;
+ *         otherwise, the corresponding error status code.
+ */
+static inline uint8_t UDP_AddRd(uint8_t  bEndpoint,
+                                void     *pData,
+                                uint32_t dLength)
+{
+    Endpoint *pEndpoint = &(endpoints[bEndpoint]);
+    MblTransfer *pMbl = (MblTransfer*)&(pEndpoint->transfer);
+    USBDTransferBuffer *pRx;
+
+    /* Check parameter */
+    if (dLength >= 0x10000)
+        return USBD_STATUS_INVALID_PARAMETER;
+
+    /* Endpoint must be idle or already receiving */
+    if (pEndpoint->state != UDP_ENDPOINT_IDLE
+        && pEndpoint->state != UDP_ENDPOINT_RECEIVINGM) {
+        return USBD_STATUS_LOCKED;
+    }
+
+    /* Keep the endpoint handler out while the list is updated */
+    UDP->UDP_IDR = 1 << bEndpoint;
+
+    if (pEndpoint->state == UDP_ENDPOINT_RECEIVINGM
+        && pMbl->listState == MBL_FULL) {
+        UDP->UDP_IER = 1 << bEndpoint;
+        return USBD_STATUS_LOCKED;
+    }
+
+    TRACE_DEBUG_WP("AddR%d(%d) ", bEndpoint, dLength);
+
+    /* Add buffer to buffer list and update index */
+    pRx = &(pMbl->pMbl[pMbl->inCurr]);
+    pRx->pBuffer = (uint8_t*)pData;
+    pRx->size = pRx->remaining = dLength;
+    pRx->transferred = pRx->buffered = 0;
+    /* Update input index */
+    if (pMbl->inCurr >= (pMbl->listSize-1)) pMbl->inCurr = 0;
+    else                                    pMbl->inCurr ++;
+    if (pMbl->inCurr == pMbl->outCurr)      pMbl->listState = MBL_FULL;
+    else                                    pMbl->listState = 0;
+    /* Start receiving */
+    if (pEndpoint->state == UDP_ENDPOINT_IDLE) {
+        TRACE_DEBUG_WP("StartR ");
+        pEndpoint->state = UDP_ENDPOINT_RECEIVINGM;
+    }
+    /* Enable interrupt on endpoint */
+    UDP->UDP_IER = 1 << bEndpoint;
+
+    return USBD_STATUS_SUCCESS;
+}
+
 /**
  * Reads incoming data on an USB endpoint This methods sets the transfer
  * descriptor and activate the endpoint interrupt. The actual transfer is
@@ -1044,6 +1584,8 @@ static inline uint8_t UDP_Read(uint8_t  bEndpoint,
     pTransfer->remaining = dLength;
     pTransfer->buffered = 0;
     pTransfer->transferred = 0;
+    pTransfer->pList = 0;
+    pTransfer->listLeft = 0;
 
     /* Enable interrupt on endpoint */
     UDP->UDP_IER = 1 << bEndpoint;
@@ -1052,20 +1594,20 @@ static inline uint8_t UDP_Read(uint8_t  bEndpoint,
 }
 
 
-/*---------------------------------------------------------------------------
- *      Exported functions
- *---------------------------------------------------------------------------*/
-
 /**
- * USBD (UDP) interrupt handler
+ * Services the UDP interrupt.
  * Manages device resume, suspend, end of bus reset.
  * Forwards endpoint events to the appropriate handler.
  */
-void USBD_IrqHandler(void)
+IRQ_RAMFUNC static void UDP_IrqService(void)
 {
     uint32_t status;
     int32_t eptnum = 0;
 
+    /* Bus activity while suspended: working clock first, the handlers and
+       their traces need it */
+    UDP_RestoreWorkingClock();
+
     /* Enable peripheral ? */
     //UDP_EnablePeripheralClock();
 
@@ -1153,7 +1695,20 @@ void USBD_IrqHandler(void)
             /* Check if endpoint has a pending interrupt */
             if ((status & (1 << eptnum)) != 0) {
 
-                UDP_EndpointHandler(eptnum);
+                PROF_Enter(PROF_ID_UDP_ENDPOINT);
+                if (irqStatsOn) {
+
+                    uint32_t dwStart = DWT_CYCCNT;
+
+                    UDP_EndpointHandler(eptnum);
+                    epStats[eptnum].dwIrqCount ++;
+                    epStats[eptnum].dwIrqCycles += DWT_CYCCNT - dwStart;
+                }
+                else {
+
+                    UDP_EndpointHandler(eptnum);
+                }
+                PROF_Exit(PROF_ID_UDP_ENDPOINT);
                 status &= ~(1 << eptnum);
 
                 if (status != 0) {
@@ -1174,6 +1729,176 @@ void USBD_IrqHandler(void)
     }
 }
 
+/**
+ * Services the UDP interrupt, counting the core clock cycles spent if
+ * USBD_HAL_EnableIrqStats() was called.
+ */
+IRQ_RAMFUNC static void UDP_IrqServiceTimed(void)
+{
+    uint32_t dwStart;
+    uint32_t dwCycles;
+
+    PROF_Enter(PROF_ID_USBD_IRQ);
+    if (!irqStatsOn) {
+
+        UDP_IrqService();
+        PROF_Exit(PROF_ID_USBD_IRQ);
+        return;
+    }
+
+    dwStart = DWT_CYCCNT;
+    UDP_IrqService();
+    dwCycles = DWT_CYCCNT - dwStart;
+    PROF_Exit(PROF_ID_USBD_IRQ);
+
+    irqStats.dwCount ++;
+    irqStats.dwCycles += dwCycles;
+    if (dwCycles > irqStats.dwMaxCycles)
+        irqStats.dwMaxCycles = dwCycles;
+}
+
+/**
+ * Work queue item servicing the UDP interrupt, which stays disabled in the
+ * NVIC until it has been serviced.
+ */
+static void UDP_DeferredIrq(void *pArg, uint32_t dwParam)
+{
+    UDP_IrqServiceTimed();
+    NVIC_EnableIRQ(UDP_IRQn);
+}
+
+
+/*---------------------------------------------------------------------------
+ *      Exported functions
+ *---------------------------------------------------------------------------*/
+
+/**
+ * USBD (UDP) interrupt handler
+ * Services the interrupt, or defers it to the work queue if
+ * USBD_HAL_SetDeferredIrq() was called; the interrupt is then masked until
+ * the queue worker has serviced it. If the queue is full, the interrupt is
+ * serviced at once.
+ */
+IRQ_RAMFUNC void USBD_IrqHandler(void)
+{
+    if (deferredIrq) {
+
+        NVIC_DisableIRQ(UDP_IRQn);
+        if (WORKQ_Post(UDP_DeferredIrq, 0, 0)) {
+
+            return;
+        }
+        NVIC_EnableIRQ(UDP_IRQn);
+    }
+
+    UDP_IrqServiceTimed();
+}
+
+/**
+ * \brief Selects where the USB device interrupt is processed.
+ *
+ * In deferred mode, the UDP handler only posts the processing to the
+ * work queue (see workq.h): the standard and class requests, the transfer
+ * callbacks and the Media callbacks they call run from the queue worker, out
+ * of the interrupt context. The work queue must be initialized beforehand.
+ * \param bDefer  1 to process the interrupt from the work queue, 0 to process
+ *                it in the handler.
+ */
+void USBD_HAL_SetDeferredIrq(uint8_t bDefer)
+{
+    deferredIrq = bDefer;
+}
+
+/**
+ * \brief Selects the clock setting of the suspended device.
+ *
+ * In USBD_SUSPEND_SLOWCLOCK mode, USBD_HAL_Suspend() also moves the master
+ * clock to the slow clock and stops the PLLs and the main oscillators,
+ * through PMC_SwitchMckToSlowClock(), and enables the USB fast startup so
+ * that bus activity ends the wait mode. The working clock is restored by
+ * the first UDP interrupt (resume or bus reset) or by USBD_HAL_RemoteWakeUp(),
+ * within the crystal start-up and PLL lock times: keep these below the 10 ms
+ * resume recovery time.
+ *
+ * While suspended, the code runs at the slow clock rate and the peripherals
+ * clocked by MCK (UART, TC, SysTick) do not keep their rates: the
+ * application should wait for the next USB state change (IOEVT_USB_STATE)
+ * instead of polling, and under FreeRTOS let the tickless idle put the
+ * processor in wait mode.
+ * \param bMode  USBD_SUSPEND_RUN (default) or USBD_SUSPEND_SLOWCLOCK.
+ */
+void USBD_HAL_SetSuspendPowerMode(uint8_t bMode)
+{
+    suspendPowerMode = bMode;
+}
+
+/**
+ * \brief Measures the time spent servicing the USB device interrupt, and
+ * counts the traffic of each endpoint (see USBD_HAL_GetEPStats()).
+ *
+ * The core clock cycles are counted with the DWT cycle counter, which is
+ * started here. In deferred mode, the time the queue worker is preempted
+ * is counted as well.
+ * \param bEnable  1 to clear the statistics and start measuring, 0 to stop.
+ */
+void USBD_HAL_EnableIrqStats(uint8_t bEnable)
+{
+    if (bEnable) {
+
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+        USBD_HAL_GetIrqStats(0, 1);
+        USBD_HAL_GetEPStats(0, 1);
+    }
+    irqStatsOn = bEnable;
+}
+
+/**
+ * \brief Gets the time spent servicing the USB device interrupt.
+ * \param pStats  Filled with the statistics since the last reset, may be 0.
+ * \param bReset  1 to clear the statistics once read.
+ */
+void USBD_HAL_GetIrqStats(USBDIrqStats *pStats, uint8_t bReset)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (pStats)
+        *pStats = irqStats;
+    if (bReset) {
+
+        irqStats.dwCount = 0;
+        irqStats.dwCycles = 0;
+        irqStats.dwMaxCycles = 0;
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * \brief Gets the counters of the endpoints, updated while the interrupt is
+ * measured (USBD_HAL_EnableIrqStats()).
+ *
+ * The bytes written into the FIFO from the application context (first
+ * packets of a transfer, stream feeds) are counted as well.
+ * \param pStats  Array of USBD_STATS_ENDPOINTS entries filled with the
+ *                counters since the last reset, may be 0.
+ * \param bReset  1 to clear the counters once read.
+ */
+void USBD_HAL_GetEPStats(USBDEPStats *pStats, uint8_t bReset)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (pStats) {
+
+        memset(pStats, 0, USBD_STATS_ENDPOINTS * sizeof(USBDEPStats));
+        memcpy(pStats, epStats, sizeof(epStats));
+    }
+    if (bReset)
+        memset(epStats, 0, sizeof(epStats));
+    __set_PRIMASK(primask);
+}
+
 /**
  * \brief Reset endpoints and disable them.
  * -# Terminate transfer if there is any, with given status;
@@ -1297,9 +2022,14 @@ uint8_t USBD_HAL_ConfigureEP(const USBEndpointDescriptor *pDescriptor)
     if ((pEndpoint->state == UDP_ENDPOINT_RECEIVING)
         || (pEndpoint->state == UDP_ENDPOINT_SENDING)
         || (pEndpoint->state == UDP_ENDPOINT_RECEIVINGM)
-        || (pEndpoint->state == UDP_ENDPOINT_SENDINGM)) {
+        || (pEndpoint->state == UDP_ENDPOINT_SENDINGM)
+        || (pEndpoint->state == UDP_ENDPOINT_STREAMING)) {
         UDP_EndOfTransfer(bEndpoint, USBD_STATUS_RESET);
     }
+    /* Streaming mode does not survive endpoint re-configuration */
+    if (pEndpoint->transfer.transHdr.transType == UDP_TRANS_STREAM) {
+        pEndpoint->transfer.transHdr.transType = UDP_TRANS_SINGLE;
+    }
     pEndpoint->state = UDP_ENDPOINT_IDLE;
 
     /* Reset Endpoint Fifos */
@@ -1349,7 +2079,9 @@ uint8_t USBD_HAL_SetTransferCallback(uint8_t          bEP,
 
 /**
  * Configure an endpoint to use multi-buffer-list transfer mode.
- * The buffers can be added by _Read/_Write function.
+ * The buffers can be added by _Read/_Write function. On an OUT endpoint the
+ * packets are received in place into the queued buffers, one buffer per
+ * packet for isochronous endpoints, and startOffset is not used.
  * \param pMbList  Pointer to a multi-buffer list used, NULL to disable MBL.
  * \param mblSize  Multi-buffer list size (number of buffers can be queued)
  * \param startOffset When number of buffer achieve this offset transfer start
@@ -1370,7 +2102,7 @@ uint8_t USBD_HAL_SetupMblTransfer( uint8_t bEndpoint,
     /* Enable Multi-Buffer Transfer List */
     if (pMbList) {
         /* Reset list items */
-        for (i = 0; i < mblSize; i --) {
+        for (i = 0; i < mblSize; i ++) {
             pMbList[i].pBuffer     = NULL;
             pMbList[i].size        = 0;
             pMbList[i].transferred = 0;
@@ -1396,6 +2128,149 @@ uint8_t USBD_HAL_SetupMblTransfer( uint8_t bEndpoint,
     return USBD_STATUS_SUCCESS;
 }
 
+/**
+ * Configure an IN endpoint in ping-pong streaming mode.
+ * Buffers are queued in the given ring by USBD_HAL_StreamFeed() (or
+ * USBD_HAL_Write()), and packed back-to-back into both FIFO banks: a
+ * short packet is only sent when the ring underruns.
+ * The callback is invoked with USBD_STATUS_PARTIAL_DONE each time a ring
+ * buffer has been sent (it can then be reused), with USBD_STATUS_SUCCESS
+ * when the ring is empty, and with the abort status if the stream is
+ * stopped, reset or halted.
+ * \param bEndpoint Endpoint number.
+ * \param pRing     Pointer to the buffer ring used.
+ * \param ringSize  Number of buffers in the ring.
+ * \param fCallback Optional stream event callback.
+ * \param pArgument Optional argument to the callback function.
+ * \return USBD_STATUS_SUCCESS, USBD_STATUS_LOCKED if the endpoint is busy,
+ *         USBD_STATUS_INVALID_PARAMETER if the ring is not usable.
+ */
+uint8_t USBD_HAL_StreamStart(uint8_t bEndpoint,
+                             USBDTransferBuffer *pRing,
+                             uint16_t ringSize,
+                             MblTransferCallback fCallback,
+                             void *pArgument)
+{
+    Endpoint *pEndpoint = &(endpoints[bEndpoint]);
+    StreamTransfer *pStream = (StreamTransfer*)&(pEndpoint->transfer);
+
+    if (pRing == 0 || ringSize == 0) {
+        return USBD_STATUS_INVALID_PARAMETER;
+    }
+    /* Check that the endpoint is not transferring */
+    if (pEndpoint->state != UDP_ENDPOINT_IDLE) {
+        return USBD_STATUS_LOCKED;
+    }
+    TRACE_DEBUG_WP("sStrm%d ", bEndpoint);
+
+    pStream->fCallback = fCallback;
+    pStream->pArgument = pArgument;
+    pStream->pMbl      = pRing;
+    pStream->listSize  = ringSize;
+    pStream->banks     = 0;
+    pStream->pktHead   = 0;
+    pStream->doneCurr  = pStream->outCurr = pStream->inCurr = 0;
+    pStream->queued    = pStream->pending = 0;
+    pStream->transType = UDP_TRANS_STREAM;
+    return USBD_STATUS_SUCCESS;
+}
+
+/**
+ * Queue a buffer to a streaming endpoint, and start sending if both FIFO
+ * banks were empty.
+ * *The buffer must be kept allocated until it is released by the stream
+ *  callback (USBD_STATUS_PARTIAL_DONE)*.
+ * \param bEndpoint Endpoint number.
+ * \param pData     Pointer to the data to send.
+ * \param dLength   Size of the data buffer (up to 64K-1).
+ * \return USBD_STATUS_SUCCESS, USBD_STATUS_LOCKED if the ring is full,
+ *         USBD_STATUS_WRONG_STATE if the endpoint is not streaming.
+ */
+uint8_t USBD_HAL_StreamFeed(uint8_t bEndpoint,
+                            const void *pData,
+                            uint32_t dLength)
+{
+    Endpoint *pEndpoint = &(endpoints[bEndpoint]);
+    StreamTransfer *pStream = (StreamTransfer*)&(pEndpoint->transfer);
+    USBDTransferBuffer *pTx;
+
+    if (pStream->transType != UDP_TRANS_STREAM) {
+        return USBD_STATUS_WRONG_STATE;
+    }
+    if (dLength == 0 || dLength >= 0x10000) {
+        return USBD_STATUS_INVALID_PARAMETER;
+    }
+    if (pStream->queued >= pStream->listSize) {
+        return USBD_STATUS_LOCKED;
+    }
+
+    /* Keep the endpoint handler out while the ring is updated */
+    UDP->UDP_IDR = 1 << bEndpoint;
+
+    /* Halted or aborted: leave the ring untouched */
+    if (pEndpoint->state != UDP_ENDPOINT_IDLE
+        && pEndpoint->state != UDP_ENDPOINT_STREAMING) {
+
+        UDP->UDP_IER = 1 << bEndpoint;
+        return USBD_STATUS_WRONG_STATE;
+    }
+
+    pTx = &(pStream->pMbl[pStream->inCurr]);
+    pTx->pBuffer = (uint8_t*)pData;
+    pTx->size = pTx->remaining = dLength;
+    pTx->transferred = pTx->buffered = 0;
+    if (++ pStream->inCurr == pStream->listSize)
+        pStream->inCurr = 0;
+    pStream->queued ++;
+    pStream->pending ++;
+
+    /* Kick the stream when both banks are empty */
+    if (pEndpoint->state == UDP_ENDPOINT_IDLE) {
+
+        TRACE_DEBUG_WP("StartS ");
+        pEndpoint->state = UDP_ENDPOINT_STREAMING;
+        while((UDP->UDP_CSR[bEndpoint]&UDP_CSR_TXPKTRDY)==UDP_CSR_TXPKTRDY);
+        UDP_StreamWriteFifo(bEndpoint);
+        SET_CSR(bEndpoint, UDP_CSR_TXPKTRDY);
+        if ((CHIP_USB_ENDPOINTS_BANKS(bEndpoint) > 1) && pStream->pending) {
+            UDP_StreamWriteFifo(bEndpoint);
+        }
+    }
+    /* Second bank free: preload it now */
+    else if ((CHIP_USB_ENDPOINTS_BANKS(bEndpoint) > 1)
+             && (pStream->banks == 1)) {
+
+        UDP_StreamWriteFifo(bEndpoint);
+    }
+
+    UDP->UDP_IER = 1 << bEndpoint;
+    return USBD_STATUS_SUCCESS;
+}
+
+/**
+ * Leave ping-pong streaming mode. Pending buffers are dropped and the
+ * stream callback is invoked with USBD_STATUS_CANCELED.
+ * \param bEndpoint Endpoint number.
+ */
+void USBD_HAL_StreamStop(uint8_t bEndpoint)
+{
+    Endpoint *pEndpoint = &(endpoints[bEndpoint]);
+    StreamTransfer *pStream = (StreamTransfer*)&(pEndpoint->transfer);
+
+    if (pStream->transType != UDP_TRANS_STREAM) {
+        return;
+    }
+    if (pEndpoint->state == UDP_ENDPOINT_STREAMING) {
+
+        UDP->UDP_IDR = 1 << bEndpoint;
+        CLEAR_CSR(bEndpoint, UDP_CSR_TXPKTRDY);
+        UDP->UDP_RST_EP |= (1 << bEndpoint);
+        UDP->UDP_RST_EP &= ~(1 << bEndpoint);
+        UDP_EndOfTransfer(bEndpoint, USBD_STATUS_CANCELED);
+    }
+    pStream->transType = UDP_TRANS_SINGLE;
+}
+
 /**
  * Sends data through a USB endpoint. Sets up the transfer descriptor,
  * writes one or two data payloads (depending on the number of FIFO bank
@@ -1418,7 +2293,11 @@ uint8_t USBD_HAL_Write( uint8_t          bEndpoint,
                         const void       *pData,
                         uint32_t         dLength)
 {
-    if (endpoints[bEndpoint].transfer.transHdr.transType)
+    uint8_t transType = endpoints[bEndpoint].transfer.transHdr.transType;
+
+    if (transType == UDP_TRANS_STREAM)
+        return USBD_HAL_StreamFeed(bEndpoint, pData, dLength);
+    else if (transType)
         return UDP_AddWr(bEndpoint, pData, dLength);
     else
         return UDP_Write(bEndpoint, pData, dLength);
@@ -1442,12 +2321,114 @@ uint8_t USBD_HAL_Read(uint8_t    bEndpoint,
                       void       *pData,
                       uint32_t   dLength)
 {
-    if (endpoints[bEndpoint].transfer.transHdr.transType)
+    uint8_t transType = endpoints[bEndpoint].transfer.transHdr.transType;
+
+    if (transType == UDP_TRANS_MBL)
+        return UDP_AddRd(bEndpoint, pData, dLength);
+    else if (transType)
         return USBD_STATUS_SW_NOT_SUPPORTED;
     else
         return UDP_Read(bEndpoint, pData, dLength);
 }
 
+/**
+ * Sends a scatter-gather list of buffers through a bulk or interrupt
+ * endpoint as one single transfer: packets are filled across descriptor
+ * boundaries and the transfer callback is invoked once, when all the
+ * buffers have been sent.
+ *
+ * *The list and all its buffers must be kept allocated until the transfer
+ *  is finished*.
+ * \param bEndpoint Endpoint number.
+ * \param pList     Pointer to the list of buffers (pBuffer and size set).
+ * \param listSize  Number of buffers in the list.
+ * \return USBD_STATUS_SUCCESS if the transfer has been started;
+ *         otherwise, the corresponding error status code.
+ */
+uint8_t USBD_HAL_WriteList(uint8_t            bEndpoint,
+                           USBDTransferBuffer *pList,
+                           uint16_t           listSize)
+{
+    Endpoint *pEndpoint = &(endpoints[bEndpoint]);
+    Transfer *pTransfer = (Transfer*)&(pEndpoint->transfer);
+
+    if (pList == 0 || listSize == 0) {
+        return USBD_STATUS_INVALID_PARAMETER;
+    }
+    /* Not available in MBL or streaming modes */
+    if (pTransfer->transType) {
+        return USBD_STATUS_SW_NOT_SUPPORTED;
+    }
+    /* Check that the endpoint is in Idle state */
+    if (pEndpoint->state != UDP_ENDPOINT_IDLE) {
+        return USBD_STATUS_LOCKED;
+    }
+    TRACE_DEBUG_WP("WriteL%d(%d) ", bEndpoint, listSize);
+
+    UDP_SetupList(pTransfer, pList, listSize);
+
+    /* Send the first packet */
+    pEndpoint->state = UDP_ENDPOINT_SENDING;
+    while((UDP->UDP_CSR[bEndpoint]&UDP_CSR_TXPKTRDY)==UDP_CSR_TXPKTRDY);
+    UDP_WritePayload(bEndpoint);
+    SET_CSR(bEndpoint, UDP_CSR_TXPKTRDY);
+
+    /* If double buffering is enabled and there is data remaining,
+       prepare another packet */
+    if ((CHIP_USB_ENDPOINTS_BANKS(bEndpoint) > 1) && (pTransfer->remaining > 0)) {
+
+        UDP_WritePayload(bEndpoint);
+    }
+
+    /* Enable interrupt on endpoint */
+    UDP->UDP_IER = 1 << bEndpoint;
+
+    return USBD_STATUS_SUCCESS;
+}
+
+/**
+ * Receives data from a bulk or interrupt endpoint into a scatter-gather
+ * list of buffers. The transfer finishes when all the buffers are full or
+ * a short packet is received; the transferred field of each descriptor
+ * gives the number of bytes stored in it.
+ *
+ * *The list and all its buffers must be kept allocated until the transfer
+ *  is finished*.
+ * \param bEndpoint Endpoint number.
+ * \param pList     Pointer to the list of buffers (pBuffer and size set).
+ * \param listSize  Number of buffers in the list.
+ * \return USBD_STATUS_SUCCESS if the read operation has been started;
+ *         otherwise, the corresponding error code.
+ */
+uint8_t USBD_HAL_ReadList(uint8_t            bEndpoint,
+                          USBDTransferBuffer *pList,
+                          uint16_t           listSize)
+{
+    Endpoint *pEndpoint = &(endpoints[bEndpoint]);
+    Transfer *pTransfer = (Transfer*)&(pEndpoint->transfer);
+
+    if (pList == 0 || listSize == 0) {
+        return USBD_STATUS_INVALID_PARAMETER;
+    }
+    if (pTransfer->transType) {
+        return USBD_STATUS_SW_NOT_SUPPORTED;
+    }
+    /* Return if the endpoint is not in IDLE state */
+    if (pEndpoint->state != UDP_ENDPOINT_IDLE) {
+        return USBD_STATUS_LOCKED;
+    }
+    TRACE_DEBUG_WP("ReadL%d(%d) ", bEndpoint, listSize);
+
+    /* Endpoint enters Receiving state */
+    pEndpoint->state = UDP_ENDPOINT_RECEIVING;
+    UDP_SetupList(pTransfer, pList, listSize);
+
+    /* Enable interrupt on endpoint */
+    UDP->UDP_IER = 1 << bEndpoint;
+
+    return USBD_STATUS_SUCCESS;
+}
+
 /**
  *  \brief Enable Pull-up, connect.
  *
@@ -1481,6 +2462,7 @@ void USBD_HAL_Disconnect(void)
  */
 void USBD_HAL_RemoteWakeUp(void)
 {
+    UDP_RestoreWorkingClock();
     UDP_EnablePeripheralClock();
     UDP_EnableUsbClock();
     UDP_EnableTransceiver();
@@ -1640,6 +2622,7 @@ uint8_t USBD_HAL_IsHighSpeed(void)
  * -# Disable transceiver
  * -# Disable USB Clock
  * -# Disable USB Peripheral
+ * -# In USBD_SUSPEND_SLOWCLOCK mode, run the master clock from the slow clock
  */
 void USBD_HAL_Suspend(void)
 {
@@ -1647,16 +2630,26 @@ void USBD_HAL_Suspend(void)
     UDP_DisableTransceiver();
     UDP_DisableUsbClock();
     UDP_DisablePeripheralClock();
+
+    if (suspendPowerMode == USBD_SUSPEND_SLOWCLOCK && !suspendClockDropped) {
+
+        /* Bus activity also ends the wait mode */
+        PMC->PMC_FSMR |= PMC_FSMR_USBAL;
+        PMC_SwitchMckToSlowClock(&suspendClock);
+        suspendClockDropped = 1;
+    }
 }
 
 /**
  * Activate USB Device HW Interface
+ * -# Restore the working clock if it was dropped by USBD_HAL_Suspend()
  * -# Enable USB Peripheral
  * -# Enable USB Clock
  * -# Enable transceiver
  */
 void USBD_HAL_Activate(void)
 {
+    UDP_RestoreWorkingClock();
     UDP_EnablePeripheralClock();
     UDP_EnableUsbClock();
     UDP_EnableTransceiver();
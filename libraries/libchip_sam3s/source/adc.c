@@ -415,3 +415,404 @@ extern uint32_t ADC_ReadBuffer( Adc* pADC, int16_t *pwBuffer, uint32_t dwSize )
     }
 }
 
+/**
+ * \brief Arms both PDC banks of a stream.
+ */
+static void ADC_StreamArm( AdcStream* pStream )
+{
+    Adc* pAdc = pStream->pAdc ;
+
+    pAdc->ADC_PTCR = ADC_PTCR_RXTDIS ;
+    pAdc->ADC_RPR = (uint32_t)pStream->pwBuffer ;
+    pAdc->ADC_RCR = pStream->dwBankSize ;
+    pAdc->ADC_RNPR = (uint32_t)(pStream->pwBuffer + pStream->dwBankSize) ;
+    pAdc->ADC_RNCR = pStream->dwBankSize ;
+    pAdc->ADC_PTCR = ADC_PTCR_RXTEN ;
+}
+
+/**
+ * \brief Initializes a continuous acquisition.
+ *
+ * \param pStream the stream to initialize
+ * \param pAdc the pointer of adc peripheral
+ * \param pwBuffer PDC buffer of 2 * dwBankSize samples
+ * \param dwBankSize samples per bank, a multiple of the number of channels
+ * \param pwOutput output buffer of dwBankSize / number of channels + 1 samples
+ */
+extern void ADC_StreamInitialize( AdcStream* pStream, Adc* pAdc, uint16_t* pwBuffer, uint32_t dwBankSize, uint16_t* pwOutput )
+{
+    pStream->pAdc = pAdc ;
+    pStream->pwBuffer = pwBuffer ;
+    pStream->dwBankSize = dwBankSize ;
+    pStream->pwOutput = pwOutput ;
+    pStream->bNumChannels = 0 ;
+    pStream->dwDecimation = 1 ;
+    pStream->bShift = 0 ;
+    pStream->callback = 0 ;
+}
+
+/**
+ * \brief Sets the decimation of a stream, before ADC_StreamStart().
+ *
+ * \param pStream the stream
+ * \param dwDecimation number of input samples summed per output sample
+ * \param bShift right shift of the sums (log2(dwDecimation) keeps 12 bits)
+ */
+extern void ADC_StreamSetDecimation( AdcStream* pStream, uint32_t dwDecimation, uint8_t bShift )
+{
+    assert( dwDecimation > 0 ) ;
+
+    pStream->dwDecimation = dwDecimation ;
+    pStream->bShift = bShift ;
+}
+
+/**
+ * \brief Enables the channels and starts the acquisition; the conversions
+ * then run at the rate of the trigger configured with ADC_CfgTrigering().
+ * In user sequence mode (ADC_CfgChannelMode()), the slots follow ADC_SEQR1
+ * and ADC_SEQR2, otherwise the channels are in numeric order.
+ *
+ * \param pStream the stream
+ * \param dwChannels mask of the channels to convert
+ * \param callback function receiving the samples, from the interrupt
+ * \param pArgument argument of the callback
+ */
+extern void ADC_StreamStart( AdcStream* pStream, uint32_t dwChannels, AdcStreamCallback callback, void* pArgument )
+{
+    Adc* pAdc = pStream->pAdc ;
+    uint32_t dwChannel ;
+    uint8_t i ;
+
+    /* Sequence slots */
+    pStream->bNumChannels = 0 ;
+    for ( dwChannel = 0 ; dwChannel < 16 ; dwChannel++ )
+    {
+        if ( dwChannels & (1u << dwChannel) )
+        {
+            pStream->pbChannels[pStream->bNumChannels++] = dwChannel ;
+        }
+    }
+    if ( pAdc->ADC_MR & ADC_MR_USEQ )
+    {
+        for ( i = 0 ; i < pStream->bNumChannels ; i++ )
+        {
+            pStream->pbChannels[i] = ((i < 8 ? pAdc->ADC_SEQR1 : pAdc->ADC_SEQR2) >> ((i & 7) * 4)) & 0xF ;
+        }
+    }
+    assert( pStream->bNumChannels > 0 ) ;
+    assert( (pStream->dwBankSize % pStream->bNumChannels) == 0 ) ;
+
+    for ( i = 0 ; i < pStream->bNumChannels ; i++ )
+    {
+        pStream->pdwAccu[i] = 0 ;
+    }
+    pStream->dwAccuCount = 0 ;
+    pStream->dwBanks = 0 ;
+    pStream->dwOverruns = 0 ;
+    pStream->callback = callback ;
+    pStream->pArgument = pArgument ;
+
+    pAdc->ADC_CHER = dwChannels ;
+    ADC_StreamArm( pStream ) ;
+    pAdc->ADC_IER = ADC_IER_ENDRX ;
+}
+
+/**
+ * \brief Stops the acquisition of a stream.
+ *
+ * \param pStream the stream
+ */
+extern void ADC_StreamStop( AdcStream* pStream )
+{
+    Adc* pAdc = pStream->pAdc ;
+
+    pAdc->ADC_IDR = ADC_IDR_ENDRX ;
+    pAdc->ADC_PTCR = ADC_PTCR_RXTDIS ;
+    pAdc->ADC_RCR = 0 ;
+    pAdc->ADC_RNCR = 0 ;
+}
+
+/**
+ * \brief Stream interrupt handling: re-arms the bank completed as the next
+ * bank, then de-interleaves (and decimates) it; this must be done within a
+ * bank time.
+ * When both banks have been filled before the handler ran, samples are
+ * lost: the acquisition restarts and dwOverruns is incremented.
+ *
+ * \param pStream the stream
+ */
+extern void ADC_StreamHandler( AdcStream* pStream )
+{
+    Adc* pAdc = pStream->pAdc ;
+    uint32_t dwStatus = pAdc->ADC_ISR & pAdc->ADC_IMR ;
+    uint16_t* pwBank ;
+    uint16_t* pwIn ;
+    uint16_t* pwOut ;
+    uint32_t dwAccu ;
+    uint32_t dwCount ;
+    uint32_t dwPerChannel ;
+    uint32_t dwStep = pStream->bNumChannels ;
+    uint32_t dwIndex ;
+    uint32_t i ;
+    uint8_t bSlot ;
+
+    if ( (dwStatus & ADC_ISR_ENDRX) == 0 )
+    {
+        return ;
+    }
+
+    pwBank = pStream->pwBuffer + (pStream->dwBanks & 1) * pStream->dwBankSize ;
+    pStream->dwBanks++ ;
+
+    /* Both banks full: the bank being processed is overwritten next */
+    if ( pAdc->ADC_RCR == 0 )
+    {
+        pStream->dwOverruns++ ;
+        pStream->dwBanks = 0 ;
+        pStream->dwAccuCount = 0 ;
+        for ( i = 0 ; i < pStream->bNumChannels ; i++ )
+        {
+            pStream->pdwAccu[i] = 0 ;
+        }
+        ADC_StreamArm( pStream ) ;
+
+        return ;
+    }
+
+    /* The bank completed follows the one being filled: it is only
+       overwritten one bank time from now */
+    pAdc->ADC_RNPR = (uint32_t)pwBank ;
+    pAdc->ADC_RNCR = pStream->dwBankSize ;
+
+    dwPerChannel = pStream->dwBankSize / dwStep ;
+    for ( bSlot = 0 ; bSlot < pStream->bNumChannels ; bSlot++ )
+    {
+        pwIn = pwBank + bSlot ;
+        pwOut = pStream->pwOutput ;
+
+        /* De-interleave */
+        if ( pStream->dwDecimation == 1 )
+        {
+            for ( i = 0 ; i < dwPerChannel ; i++ )
+            {
+                *pwOut++ = *pwIn & ADC_LCDR_LDATA_Msk ;
+                pwIn += dwStep ;
+            }
+        }
+        /* De-interleave and decimate, the sums carried over the banks */
+        else
+        {
+            dwAccu = pStream->pdwAccu[bSlot] ;
+            dwCount = pStream->dwAccuCount ;
+            for ( i = 0 ; i < dwPerChannel ; i++ )
+            {
+                dwAccu += *pwIn & ADC_LCDR_LDATA_Msk ;
+                pwIn += dwStep ;
+                if ( ++dwCount == pStream->dwDecimation )
+                {
+                    *pwOut++ = dwAccu >> pStream->bShift ;
+                    dwAccu = 0 ;
+                    dwCount = 0 ;
+                }
+            }
+            pStream->pdwAccu[bSlot] = dwAccu ;
+        }
+
+        dwIndex = pwOut - pStream->pwOutput ;
+        if ( dwIndex && pStream->callback )
+        {
+            pStream->callback( pStream, pStream->pbChannels[bSlot], pStream->pwOutput, dwIndex ) ;
+        }
+    }
+    pStream->dwAccuCount = (pStream->dwAccuCount + dwPerChannel) % pStream->dwDecimation ;
+}
+
+/**
+ * \brief Arms both PDC batches of a monitor.
+ */
+static void ADC_MonitorArm( AdcMonitor* pMonitor )
+{
+    Adc* pAdc = pMonitor->pAdc ;
+
+    pAdc->ADC_PTCR = ADC_PTCR_RXTDIS ;
+    pAdc->ADC_RPR = (uint32_t)pMonitor->pwBuffer ;
+    pAdc->ADC_RCR = pMonitor->dwBatchSize ;
+    pAdc->ADC_RNPR = (uint32_t)(pMonitor->pwBuffer + pMonitor->dwBatchSize) ;
+    pAdc->ADC_RNCR = pMonitor->dwBatchSize ;
+    pAdc->ADC_PTCR = ADC_PTCR_RXTEN ;
+}
+
+/**
+ * \brief Initializes a low power acquisition.
+ *
+ * \param pMonitor the monitor to initialize
+ * \param pAdc the pointer of adc peripheral
+ * \param pwBuffer PDC buffer of 2 * dwBatchSize samples, in SRAM
+ * \param dwBatchSize samples per batch, a multiple of the number of channels
+ */
+extern void ADC_MonitorInitialize( AdcMonitor* pMonitor, Adc* pAdc, uint16_t* pwBuffer, uint32_t dwBatchSize )
+{
+    assert( dwBatchSize > 0 ) ;
+
+    pMonitor->pAdc = pAdc ;
+    pMonitor->pwBuffer = pwBuffer ;
+    pMonitor->dwBatchSize = dwBatchSize ;
+    pMonitor->dwCmpChannel = 16 ;
+    pMonitor->dwPending = 0 ;
+    pMonitor->callback = 0 ;
+}
+
+/**
+ * \brief Enables the channels and starts the acquisition; the conversions
+ * then run at the rate of the trigger configured with ADC_CfgTrigering().
+ * The ADC is put in sleep mode between the conversions: the startup time
+ * set with ADC_cfgFrequency() is spent before each conversion.
+ *
+ * \param pMonitor the monitor
+ * \param dwChannels mask of the channels to convert
+ * \param dwCmpChannel channel compared with the window, 16 for all
+ * \param wLow lowest sample in the band
+ * \param wHigh highest sample in the band
+ * \param callback function receiving the events, from the interrupt
+ * \param pArgument argument of the callback
+ */
+extern void ADC_MonitorStart( AdcMonitor* pMonitor, uint32_t dwChannels, uint32_t dwCmpChannel,
+                              uint16_t wLow, uint16_t wHigh, AdcMonitorCallback callback, void* pArgument )
+{
+    Adc* pAdc = pMonitor->pAdc ;
+
+    assert( dwChannels != 0 ) ;
+
+    pMonitor->dwCmpChannel = dwCmpChannel ;
+    pMonitor->dwBatches = 0 ;
+    pMonitor->dwOutEvents = 0 ;
+    pMonitor->wOutSample = 0 ;
+    pMonitor->dwPending = 0 ;
+    pMonitor->callback = callback ;
+    pMonitor->pArgument = pArgument ;
+
+    /* ADC core and reference off between the conversions */
+    pAdc->ADC_MR &= ~ADC_MR_FWUP ;
+    ADC_CfgPowerSave( pAdc, 1, 0 ) ;
+
+    /* Event on the samples out of [wLow, wHigh] */
+    ADC_SetCompareChannel( pAdc, dwCmpChannel ) ;
+    ADC_SetCompareMode( pAdc, ADC_EMR_CMPMODE_OUT ) ;
+    ADC_MonitorSetWindow( pMonitor, wLow, wHigh ) ;
+
+    pAdc->ADC_CHER = dwChannels ;
+    ADC_MonitorArm( pMonitor ) ;
+
+    /* Clear the stale comparison event */
+    ADC_GetStatus( pAdc ) ;
+    pAdc->ADC_IER = ADC_IER_ENDRX | ADC_IER_COMPE ;
+}
+
+/**
+ * \brief Changes the comparison window of a running monitor.
+ *
+ * \param pMonitor the monitor
+ * \param wLow lowest sample in the band
+ * \param wHigh highest sample in the band
+ */
+extern void ADC_MonitorSetWindow( AdcMonitor* pMonitor, uint16_t wLow, uint16_t wHigh )
+{
+    assert( wLow <= wHigh ) ;
+
+    ADC_SetComparisonWindow( pMonitor->pAdc, ADC_CWR_LOWTHRES( wLow ) | ADC_CWR_HIGHTHRES( wHigh ) ) ;
+}
+
+/**
+ * \brief Stops the acquisition of a monitor.
+ *
+ * \param pMonitor the monitor
+ */
+extern void ADC_MonitorStop( AdcMonitor* pMonitor )
+{
+    Adc* pAdc = pMonitor->pAdc ;
+
+    pAdc->ADC_IDR = ADC_IDR_ENDRX | ADC_IDR_COMPE ;
+    pAdc->ADC_PTCR = ADC_PTCR_RXTDIS ;
+    pAdc->ADC_RCR = 0 ;
+    pAdc->ADC_RNCR = 0 ;
+}
+
+/**
+ * \brief Monitor interrupt handling: re-arms the completed batch as the next
+ * batch and gives it to the callback, reports the out of window samples.
+ * The batch must be used before the other one is full.
+ *
+ * \param pMonitor the monitor
+ */
+extern void ADC_MonitorHandler( AdcMonitor* pMonitor )
+{
+    Adc* pAdc = pMonitor->pAdc ;
+    uint32_t dwStatus = pAdc->ADC_ISR & pAdc->ADC_IMR ;
+    uint16_t* pwBatch ;
+    uint16_t wSample ;
+
+    if ( dwStatus & ADC_ISR_COMPE )
+    {
+        if ( pMonitor->dwCmpChannel < 16 )
+        {
+            wSample = ADC_GetConvertedData( pAdc, pMonitor->dwCmpChannel ) & ADC_LCDR_LDATA_Msk ;
+        }
+        else
+        {
+            wSample = ADC_GetLastConvertedData( pAdc ) & ADC_LCDR_LDATA_Msk ;
+        }
+        pMonitor->wOutSample = wSample ;
+        pMonitor->dwOutEvents++ ;
+        pMonitor->dwPending |= ADC_MONITOR_OUT ;
+
+        if ( pMonitor->callback )
+        {
+            pMonitor->callback( pMonitor, ADC_MONITOR_OUT, &wSample, 1 ) ;
+        }
+    }
+
+    if ( dwStatus & ADC_ISR_ENDRX )
+    {
+        pwBatch = pMonitor->pwBuffer + (pMonitor->dwBatches & 1) * pMonitor->dwBatchSize ;
+        pMonitor->dwBatches++ ;
+
+        /* Both batches full: restart from the first one */
+        if ( pAdc->ADC_RCR == 0 )
+        {
+            pMonitor->dwBatches = 0 ;
+            ADC_MonitorArm( pMonitor ) ;
+        }
+        else
+        {
+            pAdc->ADC_RNPR = (uint32_t)pwBatch ;
+            pAdc->ADC_RNCR = pMonitor->dwBatchSize ;
+        }
+        pMonitor->dwPending |= ADC_MONITOR_BATCH ;
+
+        if ( pMonitor->callback )
+        {
+            pMonitor->callback( pMonitor, ADC_MONITOR_BATCH, pwBatch, pMonitor->dwBatchSize ) ;
+        }
+    }
+}
+
+/**
+ * \brief Returns and clears the events raised since the last call, for a
+ * main loop sleeping between the events.
+ *
+ * \param pMonitor the monitor
+ * \return ADC_MONITOR_xxx events mask.
+ */
+extern uint32_t ADC_MonitorGetEvents( AdcMonitor* pMonitor )
+{
+    uint32_t dwPrimask ;
+    uint32_t dwEvents ;
+
+    dwPrimask = __get_PRIMASK() ;
+    __disable_irq() ;
+    dwEvents = pMonitor->dwPending ;
+    pMonitor->dwPending = 0 ;
+    __set_PRIMASK( dwPrimask ) ;
+
+    return dwEvents ;
+}
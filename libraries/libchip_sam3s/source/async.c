@@ -51,3 +51,138 @@ uint32_t ASYNC_IsFinished( Async* pAsync )
     return (pAsync->status != ASYNC_STATUS_PENDING) ;
 }
 
+/**
+ * \brief Initializes a request.
+ * \param pRequest  Pointer to an AsyncRequest instance.
+ * \param start  Function starting the driver operation.
+ * \param pArgument  Argument of the start and callback functions.
+ */
+void ASYNC_InitRequest( AsyncRequest* pRequest, AsyncStart start, void* pArgument )
+{
+    pRequest->status = 0 ;
+    pRequest->transferred = 0 ;
+    pRequest->start = start ;
+    pRequest->callback = 0 ;
+    pRequest->pArgument = pArgument ;
+    pRequest->pNext = 0 ;
+    pRequest->pEvent = 0 ;
+}
+
+/**
+ * \brief Appends a request at the end of the chain of another one.
+ * \param pRequest  First request of the chain.
+ * \param pNext  Request started after the last one of the chain.
+ */
+void ASYNC_Chain( AsyncRequest* pRequest, AsyncRequest* pNext )
+{
+    while ( pRequest->pNext )
+    {
+        pRequest = pRequest->pNext ;
+    }
+    pRequest->pNext = pNext ;
+}
+
+/**
+ * \brief Starts a request; the following requests of its chain are started
+ * by ASYNC_Complete().
+ * \param pRequest  Pointer to an AsyncRequest instance.
+ * \return 0 if the request has been started; otherwise returns the error of
+ * the start function (the request and its chain are then complete).
+ */
+uint8_t ASYNC_Submit( AsyncRequest* pRequest )
+{
+    uint8_t status ;
+
+    pRequest->status = ASYNC_STATUS_PENDING ;
+    pRequest->transferred = 0 ;
+
+    status = pRequest->start( pRequest ) ;
+    if ( status )
+    {
+        ASYNC_Complete( pRequest, status, 0 ) ;
+    }
+
+    return status ;
+}
+
+/**
+ * \brief Completes a request, usually from the completion callback of the
+ * driver: invokes its callback, signals its event, then starts the next
+ * request of the chain, or fails the rest of the chain.
+ * \param pRequest  Pointer to an AsyncRequest instance.
+ * \param status  Driver status, 0 if successful.
+ * \param transferred  Number of bytes transferred.
+ */
+void ASYNC_Complete( AsyncRequest* pRequest, uint8_t status, uint32_t transferred )
+{
+    AsyncRequest* pNext = pRequest->pNext ;
+
+    pRequest->transferred = transferred ;
+    pRequest->status = status ;
+    if ( pRequest->callback )
+    {
+        pRequest->callback( pRequest ) ;
+    }
+    if ( pRequest->pEvent )
+    {
+        ASYNC_SignalEvent( pRequest->pEvent ) ;
+    }
+
+    if ( pNext )
+    {
+        if ( status == 0 )
+        {
+            ASYNC_Submit( pNext ) ;
+        }
+        else
+        {
+            pNext->status = ASYNC_STATUS_PENDING ;
+            ASYNC_Complete( pNext, ASYNC_STATUS_ERROR, 0 ) ;
+        }
+    }
+}
+
+/**
+ * \brief Returns 1 if the given request has ended; otherwise returns 0.
+ * \param pRequest  Pointer to an AsyncRequest instance.
+ */
+uint32_t ASYNC_IsRequestFinished( AsyncRequest* pRequest )
+{
+    return (pRequest->status != ASYNC_STATUS_PENDING) ;
+}
+
+/**
+ * \brief Completion callback for the drivers reporting a status only
+ * (SpidCallback, SdmmcCallback); its argument is the AsyncRequest.
+ * \param status  Driver status, 0 if successful.
+ * \param pArgument  Pointer to the AsyncRequest instance.
+ */
+void ASYNC_StatusCallback( uint8_t status, void* pArgument )
+{
+    ASYNC_Complete( (AsyncRequest*)pArgument, status, 0 ) ;
+}
+
+/**
+ * \brief Completion callback for the media drivers (MediaCallback); its
+ * argument is the AsyncRequest.
+ * \param pArgument  Pointer to the AsyncRequest instance.
+ * \param status  Media status, 0 if successful.
+ * \param transferred  Number of bytes transferred.
+ * \param remaining  Number of bytes not transferred.
+ */
+void ASYNC_MediaCallback( void* pArgument, uint8_t status, uint32_t transferred, uint32_t remaining )
+{
+    (void)remaining ;
+    ASYNC_Complete( (AsyncRequest*)pArgument, status, transferred ) ;
+}
+
+/**
+ * \brief Signals the RTOS event bound to a completed request. Called from
+ * the completion context (usually an interrupt); the default implementation
+ * does nothing, an RTOS application overrides it (e.g. to give a semaphore).
+ * \param pEvent  Event of the request.
+ */
+WEAK void ASYNC_SignalEvent( void* pEvent )
+{
+    (void)pEvent ;
+}
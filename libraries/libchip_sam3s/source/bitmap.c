@@ -0,0 +1,128 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Implementation of the bitmap searches.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "chip.h"
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+/** Position of the lowest set bit, indexed by the de Bruijn product of that bit.*/
+static const uint8_t _aucLowestBit[32] =
+{
+     0,  1, 28,  2, 29, 14, 24,  3, 30, 22, 20, 15, 25, 17,  4,  8,
+    31, 27, 13, 23, 21, 19, 16,  7, 26, 12, 18,  6, 11,  5, 10,  9
+} ;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+/**
+ * \brief Returns the position of the lowest set bit of a non-zero word.
+ */
+static uint32_t _LowestBit( uint32_t dwWord )
+{
+    return _aucLowestBit[((dwWord & (0u-dwWord)) * 0x077CB531u) >> 27] ;
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Finds the first set bit of a bitmap, from a given bit on. The bitmap
+ * is scanned a word at a time.
+ * \param pdwBitmap  Pointer to the bitmap.
+ * \param dwStart  Index of the first bit to look at.
+ * \param dwBits  Number of bits of the bitmap.
+ * \return Index of the first set bit at or after dwStart, or BITMAP_NONE.
+ */
+uint32_t BITMAP_FindFirst( const uint32_t* pdwBitmap, uint32_t dwStart, uint32_t dwBits )
+{
+    uint32_t dwIndex ;
+    uint32_t dwWord ;
+    uint32_t dwBit ;
+
+    if ( dwStart >= dwBits )
+    {
+        return BITMAP_NONE ;
+    }
+
+    dwIndex = dwStart >> 5 ;
+    dwWord = pdwBitmap[dwIndex] & (0xFFFFFFFFu << (dwStart & 0x1F)) ;
+    while ( dwWord == 0 )
+    {
+        if ( ++dwIndex >= BITMAP_WORDS( dwBits ) )
+        {
+            return BITMAP_NONE ;
+        }
+        dwWord = pdwBitmap[dwIndex] ;
+    }
+
+    dwBit = (dwIndex << 5) + _LowestBit( dwWord ) ;
+
+    return (dwBit < dwBits) ? dwBit : BITMAP_NONE ;
+}
+
+/**
+ * \brief Counts the set bits of a bitmap.
+ * \param pdwBitmap  Pointer to the bitmap.
+ * \param dwBits  Number of bits of the bitmap.
+ * \return Number of set bits.
+ */
+uint32_t BITMAP_Count( const uint32_t* pdwBitmap, uint32_t dwBits )
+{
+    uint32_t dwCount = 0 ;
+    uint32_t dwWord ;
+    uint32_t i ;
+
+    for ( i=0 ; i < BITMAP_WORDS( dwBits ) ; i++ )
+    {
+        dwWord = pdwBitmap[i] ;
+        if ( (i == dwBits/32) && (dwBits & 0x1F) )
+        {
+            dwWord &= (1u << (dwBits & 0x1F)) - 1 ;
+        }
+        for ( ; dwWord != 0 ; dwCount++ )
+        {
+            dwWord &= dwWord - 1 ;
+        }
+    }
+
+    return dwCount ;
+}
@@ -0,0 +1,98 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Implementation of the shared bus arbitration hooks.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "chip.h"
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Arbiter functions, none by default. */
+static BusArbiterFunc _fAcquire = 0 ;
+static BusArbiterFunc _fRelease = 0 ;
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Sets the functions arbitrating the shared buses. Shall be called
+ * while no bus is in use, before the drivers start.
+ * \param fAcquire  Acquire function, or 0 to disable the arbitration.
+ * \param fRelease  Release function, or 0 to disable the arbitration.
+ */
+extern void BUS_SetArbiter( BusArbiterFunc fAcquire, BusArbiterFunc fRelease )
+{
+    if ( (fAcquire == 0) || (fRelease == 0) )
+    {
+        fAcquire = 0 ;
+        fRelease = 0 ;
+    }
+    _fRelease = fRelease ;
+    _fAcquire = fAcquire ;
+}
+
+/**
+ * \brief Acquires a bus for a sequence of accesses; returns at once when no
+ * arbiter is set.
+ * \param dwBus  BUS_SMC or BUS_SPI.
+ */
+extern void BUS_Acquire( uint32_t dwBus )
+{
+    BusArbiterFunc fAcquire = _fAcquire ;
+
+    if ( fAcquire != 0 )
+    {
+        fAcquire( dwBus ) ;
+    }
+}
+
+/**
+ * \brief Releases a bus acquired with BUS_Acquire().
+ * \param dwBus  BUS_SMC or BUS_SPI.
+ */
+extern void BUS_Release( uint32_t dwBus )
+{
+    BusArbiterFunc fRelease = _fRelease ;
+
+    if ( fRelease != 0 )
+    {
+        fRelease( dwBus ) ;
+    }
+}
@@ -70,6 +70,87 @@
  *----------------------------------------------------------------------------*/
 #define CRCCU_TIMEOUT    0xFFFFFFFF
 
+/** Largest DMA transfer, BTSIZE being 16-bit */
+#define CRCCU_MAX_TRANSFER  0xFFFF
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+#ifdef __ICCARM__          /* IAR */
+#pragma data_alignment=512
+#define __attribute__(...)
+#endif
+/** Descriptor of the stream transfers, the CRCCU requires a 512-byte alignment */
+static __attribute__ ((aligned(512))) CrcDscr _streamDscr ;
+
+/** Queued buffers, the first one being read by the DMA */
+static CrcSegment _aStreamQueue[CRCCU_STREAM_QUEUE_SIZE] ;
+
+/** Index of the first queued buffer */
+static uint32_t _dwStreamFirst = 0 ;
+
+/** Number of queued buffers */
+static volatile uint32_t _dwStreamPending = 0 ;
+
+/** Bytes of the first buffer handed to the running transfer, 0 if none */
+static volatile uint32_t _dwStreamRunning = 0 ;
+
+/** Polynomial of the stream */
+static uint32_t _dwStreamPolynomial = CRCCU_MR_PTYPE_CCIT8023 ;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Retires the finished transfer and starts the next one, with the
+ * interrupts masked or from the CRCCU handler.
+ */
+static void _StreamService( void )
+{
+    CrcSegment* pSegment ;
+    uint32_t dwLength ;
+
+    if ( (CRCCU->CRCCU_DMA_SR & CRCCU_DMA_SR_DMASR) == CRCCU_DMA_SR_DMASR )
+    {
+        return ;
+    }
+
+    /* Retire the bytes of the finished transfer */
+    if ( _dwStreamRunning != 0 )
+    {
+        pSegment = &_aStreamQueue[_dwStreamFirst] ;
+        pSegment->pvData = (const uint8_t*)pSegment->pvData + _dwStreamRunning ;
+        pSegment->dwSize -= _dwStreamRunning ;
+        _dwStreamRunning = 0 ;
+
+        if ( pSegment->dwSize == 0 )
+        {
+            _dwStreamFirst = (_dwStreamFirst+1) % CRCCU_STREAM_QUEUE_SIZE ;
+            _dwStreamPending-- ;
+        }
+    }
+
+    if ( _dwStreamPending == 0 )
+    {
+        return ;
+    }
+
+    pSegment = &_aStreamQueue[_dwStreamFirst] ;
+    dwLength = pSegment->dwSize ;
+    if ( dwLength > CRCCU_MAX_TRANSFER )
+    {
+        dwLength = CRCCU_MAX_TRANSFER ;
+    }
+
+    _streamDscr.TR_ADDR = (uint32_t)pSegment->pvData ;
+    _streamDscr.TR_CTRL = (0 << 24) |    /* TRWIDTH: 0 - byte */
+                          dwLength ;     /* BTSIZE */
+    _dwStreamRunning = dwLength ;
+    CRCCU->CRCCU_DMA_EN = CRCCU_DMA_EN_DMAEN ;
+}
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -110,3 +191,151 @@ extern uint32_t CRCCU_ComputeCrc( Crccu* pCrccu )
     return (pCrccu->CRCCU_SR) ;
 }
 
+/**
+ * \brief CRCCU interrupt handler, chains the queued stream buffers.
+ */
+extern void CRCCU_IrqHandler( void )
+{
+    /* Acknowledge the end of transfer */
+    CRCCU->CRCCU_DMA_ISR ;
+    _StreamService() ;
+}
+
+/**
+ * \brief Starts a CRC stream, from the reset value of the CRC.
+ *
+ * Waits for the buffers of the previous stream, then drops its CRC.
+ *
+ * \param dwPolynomial  CRCCU_MR_PTYPE_CCIT8023, CRCCU_MR_PTYPE_CASTAGNOLI or
+ * CRCCU_MR_PTYPE_CCIT16.
+ */
+extern void CRCCU_StreamStart( uint32_t dwPolynomial )
+{
+    PMC_EnablePeripheral( ID_CRCCU ) ;
+    CRCCU_StreamWait() ;
+
+    _dwStreamPolynomial = dwPolynomial & CRCCU_MR_PTYPE_Msk ;
+    CRCCU_ResetCrcValue( CRCCU ) ;
+    CRCCU_Configure( CRCCU, (uint32_t)&_streamDscr, CRCCU_MR_ENABLE | _dwStreamPolynomial ) ;
+
+    CRCCU->CRCCU_DMA_ISR ;
+    CRCCU->CRCCU_DMA_IER = CRCCU_DMA_IER_DMAIER ;
+    NVIC_ClearPendingIRQ( CRCCU_IRQn ) ;
+    NVIC_EnableIRQ( CRCCU_IRQn ) ;
+}
+
+/**
+ * \brief Queues a buffer in the CRC stream, without waiting for its
+ * computation.
+ *
+ * \param pvData  Buffer, in SRAM or in flash. It must stay unchanged until
+ * the stream is idle.
+ * \param dwSize  Size of the buffer in bytes, any size.
+ * \return 1 if the buffer is queued, 0 if the queue is full.
+ */
+extern uint32_t CRCCU_StreamAppend( const void* pvData, uint32_t dwSize )
+{
+    CrcSegment* pSegment ;
+    uint32_t primask ;
+
+    if ( dwSize == 0 )
+    {
+        return 1 ;
+    }
+
+    primask = __get_PRIMASK() ;
+    __disable_irq() ;
+    if ( _dwStreamPending == CRCCU_STREAM_QUEUE_SIZE )
+    {
+        __set_PRIMASK( primask ) ;
+
+        return 0 ;
+    }
+
+    pSegment = &_aStreamQueue[(_dwStreamFirst+_dwStreamPending) % CRCCU_STREAM_QUEUE_SIZE] ;
+    pSegment->pvData = pvData ;
+    pSegment->dwSize = dwSize ;
+    _dwStreamPending++ ;
+
+    if ( _dwStreamRunning == 0 )
+    {
+        _StreamService() ;
+    }
+    __set_PRIMASK( primask ) ;
+
+    return 1 ;
+}
+
+/**
+ * \brief Queues scattered buffers in the CRC stream, waiting for room in the
+ * queue when needed.
+ *
+ * \param pSegments  Buffers, in the order of the computation.
+ * \param dwCount  Number of buffers.
+ * \return Number of buffers queued, i.e. dwCount.
+ */
+extern uint32_t CRCCU_StreamAppendList( const CrcSegment* pSegments, uint32_t dwCount )
+{
+    uint32_t dwQueued ;
+    uint32_t primask ;
+
+    for ( dwQueued=0 ; dwQueued < dwCount ; dwQueued++ )
+    {
+        while ( !CRCCU_StreamAppend( pSegments[dwQueued].pvData, pSegments[dwQueued].dwSize ) )
+        {
+            /* Serves the queue too when interrupts are masked */
+            primask = __get_PRIMASK() ;
+            __disable_irq() ;
+            _StreamService() ;
+            __set_PRIMASK( primask ) ;
+        }
+    }
+
+    return dwQueued ;
+}
+
+/**
+ * \brief Tells whether all the queued buffers are computed.
+ *
+ * \return 1 if the stream is idle, 0 otherwise.
+ */
+extern uint32_t CRCCU_StreamIsIdle( void )
+{
+    return ( _dwStreamPending == 0 ) ? 1 : 0 ;
+}
+
+/**
+ * \brief Waits for the queued buffers to be computed.
+ */
+extern void CRCCU_StreamWait( void )
+{
+    uint32_t primask ;
+
+    while ( _dwStreamPending != 0 )
+    {
+        /* Serves the queue too when interrupts are masked */
+        primask = __get_PRIMASK() ;
+        __disable_irq() ;
+        _StreamService() ;
+        __set_PRIMASK( primask ) ;
+    }
+}
+
+/**
+ * \brief Returns the CRC of the data streamed since CRCCU_StreamStart(),
+ * waiting for the queued buffers. The stream can go on afterwards.
+ *
+ * \return The CRC, 16-bit for CRCCU_MR_PTYPE_CCIT16.
+ */
+extern uint32_t CRCCU_StreamGetCrc( void )
+{
+    CRCCU_StreamWait() ;
+
+    if ( _dwStreamPolynomial == CRCCU_MR_PTYPE_CCIT16 )
+    {
+        return CRCCU->CRCCU_SR & 0xFFFF ;
+    }
+
+    return CRCCU->CRCCU_SR ;
+}
+
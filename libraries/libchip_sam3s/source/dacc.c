@@ -180,4 +180,162 @@ extern uint32_t DACC_WriteBuffer( Dacc* pDACC, uint16_t *pwBuffer, uint32_t dwSi
 
 }
 
+/**
+ * \brief Fills (if needed) and arms both PDC banks of a stream.
+ */
+static void DACC_StreamArm( DaccStream* pStream )
+{
+    Dacc* pDACC = pStream->pDacc ;
+
+    if ( pStream->fill )
+    {
+        pStream->fill( pStream->pArgument, pStream->pwBuffer, pStream->dwBankSize ) ;
+        pStream->fill( pStream->pArgument, pStream->pwBuffer + pStream->dwBankSize, pStream->dwBankSize ) ;
+    }
+
+    pDACC->DACC_PTCR = DACC_PTCR_TXTDIS ;
+    pDACC->DACC_TPR = (uint32_t)pStream->pwBuffer ;
+    pDACC->DACC_TCR = pStream->dwBankSize ;
+    pDACC->DACC_TNPR = (uint32_t)(pStream->pwBuffer + pStream->dwBankSize) ;
+    pDACC->DACC_TNCR = pStream->dwBankSize ;
+    pDACC->DACC_PTCR = DACC_PTCR_TXTEN ;
+}
+
+/**
+ * \brief Starts a continuous output; the conversions run at the rate of the
+ * trigger selected in DACC_Initialize().
+ * \param pStream the stream to start
+ * \param pDACC the pointer of DACC peripheral
+ * \param pwBuffer PDC buffer of 2 * dwBankSize samples
+ * \param dwBankSize samples per bank
+ * \param fill function refilling a bank, from the interrupt; 0 to replay the
+ * buffer content (e.g. an integral number of periods) without CPU work
+ * \param pArgument argument of the fill function
+ */
+extern void DACC_StreamStart( DaccStream* pStream, Dacc* pDACC, uint16_t* pwBuffer, uint32_t dwBankSize, DaccStreamFill fill, void* pArgument )
+{
+    pStream->pDacc = pDACC ;
+    pStream->pwBuffer = pwBuffer ;
+    pStream->dwBankSize = dwBankSize ;
+    pStream->dwBanks = 0 ;
+    pStream->dwUnderruns = 0 ;
+    pStream->fill = fill ;
+    pStream->pArgument = pArgument ;
+
+    DACC_StreamArm( pStream ) ;
+    pDACC->DACC_IER = DACC_IER_ENDTX ;
+}
+
+/**
+ * \brief Stops the output of a stream.
+ * \param pStream the stream
+ */
+extern void DACC_StreamStop( DaccStream* pStream )
+{
+    Dacc* pDACC = pStream->pDacc ;
+
+    pDACC->DACC_IDR = DACC_IDR_ENDTX ;
+    pDACC->DACC_PTCR = DACC_PTCR_TXTDIS ;
+    pDACC->DACC_TCR = 0 ;
+    pDACC->DACC_TNCR = 0 ;
+}
+
+/**
+ * \brief Stream interrupt handling: refills the bank just played and
+ * queues it after the bank being played. When both banks have been played
+ * before the handler ran, the output restarts and dwUnderruns is incremented.
+ * \param pStream the stream
+ */
+extern void DACC_StreamHandler( DaccStream* pStream )
+{
+    Dacc* pDACC = pStream->pDacc ;
+    uint16_t* pwBank ;
+
+    if ( (pDACC->DACC_ISR & pDACC->DACC_IMR & DACC_ISR_ENDTX) == 0 )
+    {
+        return ;
+    }
+
+    pwBank = pStream->pwBuffer + (pStream->dwBanks & 1) * pStream->dwBankSize ;
+    pStream->dwBanks++ ;
 
+    /* Both banks played */
+    if ( pDACC->DACC_TCR == 0 )
+    {
+        pStream->dwUnderruns++ ;
+        pStream->dwBanks = 0 ;
+        DACC_StreamArm( pStream ) ;
+
+        return ;
+    }
+
+    if ( pStream->fill )
+    {
+        pStream->fill( pStream->pArgument, pwBank, pStream->dwBankSize ) ;
+    }
+    pDACC->DACC_TNPR = (uint32_t)pwBank ;
+    pDACC->DACC_TNCR = pStream->dwBankSize ;
+}
+
+/**
+ * \brief Initializes a table synthesizer, at phase 0 and frequency 0.
+ * \param pDds the synthesizer
+ * \param pwTable one period of the waveform, 2^bTableBits signed samples
+ * \param bTableBits log2 of the table size
+ * \param lGain gain in Q15 (32767: full table amplitude)
+ * \param wOffset output offset, e.g. 2048 (mid-scale)
+ */
+extern void DACC_DdsInitialize( DaccDds* pDds, const int16_t* pwTable, uint8_t bTableBits, int32_t lGain, uint16_t wOffset )
+{
+    assert( (bTableBits > 0) && (bTableBits < 32) ) ;
+
+    pDds->pwTable = pwTable ;
+    pDds->bTableBits = bTableBits ;
+    pDds->lGain = lGain ;
+    pDds->wOffset = wOffset ;
+    pDds->dwPhase = 0 ;
+    pDds->dwIncrement = 0 ;
+}
+
+/**
+ * \brief Sets the output frequency of a synthesizer.
+ * \param pDds the synthesizer
+ * \param dwFrequency waveform frequency in Hz
+ * \param dwSampleRate conversion rate in Hz
+ */
+extern void DACC_DdsSetFrequency( DaccDds* pDds, uint32_t dwFrequency, uint32_t dwSampleRate )
+{
+    pDds->dwIncrement = (uint32_t)(((uint64_t)dwFrequency << 32) / dwSampleRate) ;
+}
+
+/**
+ * \brief DaccStreamFill function of a synthesizer, pArgument being the
+ * DaccDds: fills a bank with the next samples, clamped to 12 bits.
+ */
+extern void DACC_DdsStreamFill( void* pArgument, uint16_t* pwBank, uint32_t dwSize )
+{
+    DaccDds* pDds = (DaccDds*)pArgument ;
+    const int16_t* pwTable = pDds->pwTable ;
+    uint32_t dwShift = 32 - pDds->bTableBits ;
+    uint32_t dwPhase = pDds->dwPhase ;
+    uint32_t dwIncrement = pDds->dwIncrement ;
+    int32_t lGain = pDds->lGain ;
+    int32_t lOffset = pDds->wOffset ;
+    int32_t lSample ;
+
+    while ( dwSize-- )
+    {
+        lSample = lOffset + ((pwTable[dwPhase >> dwShift] * lGain) >> 15) ;
+        if ( lSample < 0 )
+        {
+            lSample = 0 ;
+        }
+        else if ( lSample > 0xFFF )
+        {
+            lSample = 0xFFF ;
+        }
+        *pwBank++ = lSample ;
+        dwPhase += dwIncrement ;
+    }
+    pDds->dwPhase = dwPhase ;
+}
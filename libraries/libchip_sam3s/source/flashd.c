@@ -50,6 +50,20 @@
  *
  * A 128-bit factory programmed unique ID could be read to serve several purposes.
  *
+ * Small writes, such as configuration records, can go through FLASHD_WriteBuffered().
+ * The data is merged in a RAM copy of the page it targets, and the page is only
+ * programmed once a write reaches its end, targets another page, or FLASHD_Flush()
+ * is called, so consecutive sub-page writes cost a single page program. Until then
+ * the flash still holds the previous content.
+ *
+ * The page programs are run by a routine located in RAM: it starts the command,
+ * enables the EEFC ready interrupt (EFC_EnableFrdyIt()) and sleeps until
+ * EEFC_IrqHandler() reports the end of the command. Interrupts keep being served
+ * meanwhile: handlers located in RAM, with the vector table relocated to RAM, run
+ * at once, while any flash access (a handler or a vector in flash) is stalled
+ * until the end of the program. When called with the interrupts masked, or in IAP
+ * mode, the command is completed by polling instead.
+ *
  * The driver accesses the flash memory by calling the lowlevel module provided in \ref efc_module.
  * For more accurate information, please look at the EEFC section of the Datasheet.
  *
@@ -87,12 +101,26 @@ static NO_INIT uint32_t _adwPageBuffer[IFLASH_PAGE_SIZE/4] ;
 static uint8_t* _aucPageBuffer = (uint8_t*)_adwPageBuffer;
 static NO_INIT uint32_t _dwUseIAP ;
 
+/** Address of the page held by _adwPageBuffer for FLASHD_WriteBuffered(), 0 if none */
+static uint32_t _dwBufferedPage = 0 ;
+/** Set by EEFC_IrqHandler() when the running command is over */
+static volatile uint32_t _dwCommandDone ;
+/** Status read by EEFC_IrqHandler() at the end of the command */
+static volatile uint32_t _dwCommandStatus ;
+
 /*----------------------------------------------------------------------------
  *        Local macros
  *----------------------------------------------------------------------------*/
 
 #define min( a, b ) (((a) < (b)) ? (a) : (b))
 
+/* Places a function in RAM, so that it can run while the flash is programmed */
+#if defined ( __ICCARM__ )
+#define FLASHD_RAMFUNC __ramfunc /* IAR */
+#else
+#define FLASHD_RAMFUNC __attribute__ ((section (".ramfunc"), noinline, long_call)) // GCC
+#endif
+
 /*----------------------------------------------------------------------------
  *        Local functions
  *----------------------------------------------------------------------------*/
@@ -135,6 +163,91 @@ static void ComputeLockRange( uint32_t dwStart, uint32_t dwEnd, uint32_t *pdwAct
     TRACE_DEBUG( "Actual lock range is 0x%06X - 0x%06X\n\r", *pdwActualStart, *pdwActualEnd ) ;
 }
 
+/**
+ * \brief Performs a flash command from RAM and waits for its end.
+ *
+ * The command end is reported by the EEFC ready interrupt, the core sleeping in
+ * between. If the interrupts are masked, FSR is polled instead. Nothing located in
+ * flash may be called here, hence the inline instructions.
+ *
+ * \param pEfc  Pointer to an Efc instance.
+ * \param dwCommand  Command to perform.
+ * \param dwArgument  Optional command argument.
+ * \return 0 if successful, otherwise returns an error code.
+ */
+FLASHD_RAMFUNC static uint32_t _PerformCommandFromRam( Efc* pEfc, uint32_t dwCommand, uint32_t dwArgument )
+{
+    uint32_t dwPrimask ;
+    uint32_t dwStatus ;
+
+    __asm volatile ( "mrs %0, primask" : "=r" (dwPrimask) ) ;
+
+    _dwCommandDone = 0 ;
+    pEfc->EEFC_FCR = EEFC_FCR_FKEY(0x5A) | EEFC_FCR_FARG(dwArgument) | EEFC_FCR_FCMD(dwCommand) ;
+
+    if ( dwPrimask )
+    {
+        do
+        {
+            dwStatus = pEfc->EEFC_FSR ;
+        }
+        while ( (dwStatus & EEFC_FSR_FRDY) != EEFC_FSR_FRDY ) ;
+    }
+    else
+    {
+        /* Sleep with the interrupts masked, so that a command end between the
+           test and the WFI still wakes up the core */
+        __asm volatile ( "cpsid i" ) ;
+        pEfc->EEFC_FMR |= EEFC_FMR_FRDY ;
+        while ( _dwCommandDone == 0 )
+        {
+            __asm volatile ( "wfi" ) ;
+            __asm volatile ( "cpsie i" ) ;
+            __asm volatile ( "isb" ) ;
+            __asm volatile ( "cpsid i" ) ;
+        }
+        __asm volatile ( "cpsie i" ) ;
+        dwStatus = _dwCommandStatus ;
+    }
+
+    return ( dwStatus & (EEFC_FSR_FLOCKE | EEFC_FSR_FCMDE) ) ;
+}
+
+/**
+ * \brief Programs a flash page with the content of _adwPageBuffer.
+ *
+ * \param pEfc  Pointer to an Efc instance.
+ * \param wPage  Page number.
+ * \param dwPageAddress  Page address.
+ * \param dwCommand  EFC_FCMD_EWP, or EFC_FCMD_WP to program without erasing.
+ * \return 0 if successful, otherwise returns an error code.
+ */
+static uint32_t _WritePageBuffer( Efc* pEfc, uint16_t wPage, uint32_t dwPageAddress, uint32_t dwCommand )
+{
+    uint32_t* pAlignedDestination ;
+    uint32_t* pAlignedSource ;
+    uint32_t dwSize ;
+
+    /* Fill the latch buffer
+     * Writing 8-bit and 16-bit data is not allowed and may lead to unpredictable data corruption
+     */
+    pAlignedDestination = (uint32_t*)dwPageAddress ;
+    pAlignedSource = (uint32_t*)_adwPageBuffer ;
+
+    for ( dwSize = IFLASH_PAGE_SIZE ; dwSize >= 4 ; dwSize -= 4 )
+    {
+        *pAlignedDestination++ = *pAlignedSource++ ;
+    }
+
+    /* Send writing command */
+    if ( _dwUseIAP )
+    {
+        return EFC_PerformCommand( pEfc, dwCommand, wPage, _dwUseIAP ) ;
+    }
+
+    return _PerformCommandFromRam( pEfc, dwCommand, wPage ) ;
+}
+
 
 /*----------------------------------------------------------------------------
  *        Exported functions
@@ -167,6 +280,21 @@ extern void FLASHD_Initialize( uint32_t dwMCk, uint32_t dwUseIAP )
 	}
 
     _dwUseIAP=dwUseIAP ;
+    _dwBufferedPage=0 ;
+
+    NVIC_ClearPendingIRQ( EFC_IRQn ) ;
+    NVIC_EnableIRQ( EFC_IRQn ) ;
+}
+
+/**
+ * \brief EEFC interrupt handler, reports the end of the command started by
+ * _PerformCommandFromRam().
+ */
+FLASHD_RAMFUNC extern void EEFC_IrqHandler( void )
+{
+    EFC->EEFC_FMR &= ~EEFC_FMR_FRDY ;
+    _dwCommandStatus = EFC->EEFC_FSR ;
+    _dwCommandDone = 1 ;
 }
 
 /**
@@ -195,7 +323,8 @@ extern uint32_t FLASHD_Erase( uint32_t dwAddress )
  * \brief Writes a data buffer in the internal flash
  *
  * \note This function works in polling mode, and thus only returns when the
- * data has been effectively written.
+ * data has been effectively written. A page pending in FLASHD_WriteBuffered() is
+ * programmed first.
  * \param address  Write address.
  * \param pBuffer  Data buffer.
  * \param size  Size of data buffer in bytes.
@@ -210,14 +339,18 @@ extern uint32_t FLASHD_Write( uint32_t dwAddress, const void *pvBuffer, uint32_t
     uint32_t pageAddress ;
     uint16_t padding ;
     uint32_t dwError ;
-    uint32_t sizeTmp ;
-    uint32_t *pAlignedDestination ;
-    uint32_t *pAlignedSource ;
 
     assert( pvBuffer ) ;
     assert( dwAddress >=IFLASH_ADDR ) ;
     assert( (dwAddress + dwSize) <= (IFLASH_ADDR + IFLASH_SIZE) ) ;
 
+    /* The page buffer is shared with FLASHD_WriteBuffered() */
+    dwError = FLASHD_Flush() ;
+    if ( dwError )
+    {
+        return dwError ;
+    }
+
     /* Translate write address */
     EFC_TranslateAddress( &pEfc, dwAddress, &page, &offset ) ;
 
@@ -230,29 +363,16 @@ extern uint32_t FLASHD_Write( uint32_t dwAddress, const void *pvBuffer, uint32_t
         padding = IFLASH_PAGE_SIZE - offset - writeSize ;
 
         /* Pre-buffer data */
-        memcpy( _aucPageBuffer, (void *) pageAddress, offset);
+        MEM_Copy( _aucPageBuffer, (void *) pageAddress, offset);
 
         /* Buffer data */
-        memcpy( _aucPageBuffer + offset, pvBuffer, writeSize);
+        MEM_Copy( _aucPageBuffer + offset, pvBuffer, writeSize);
 
         /* Post-buffer data */
-        memcpy( _aucPageBuffer + offset + writeSize, (void *) (pageAddress + offset + writeSize), padding);
-
-        /* Write page
-         * Writing 8-bit and 16-bit data is not allowed and may lead to unpredictable data corruption
-         */
-        pAlignedDestination = (uint32_t*)pageAddress ;
-        pAlignedSource = (uint32_t*)_adwPageBuffer ;
-        sizeTmp = IFLASH_PAGE_SIZE ;
-
-        while ( sizeTmp >= 4 )
-        {
-            *pAlignedDestination++ = *pAlignedSource++;
-            sizeTmp -= 4;
-        }
+        MEM_Copy( _aucPageBuffer + offset + writeSize, (void *) (pageAddress + offset + writeSize), padding);
 
-        /* Send writing command */
-        dwError = EFC_PerformCommand( pEfc, EFC_FCMD_EWP, page, _dwUseIAP ) ;
+        /* Write page */
+        dwError = _WritePageBuffer( pEfc, page, pageAddress, EFC_FCMD_EWP ) ;
         if ( dwError )
         {
             return dwError ;
@@ -268,6 +388,207 @@ extern uint32_t FLASHD_Write( uint32_t dwAddress, const void *pvBuffer, uint32_t
 
     return 0 ;
 }
+
+/**
+ * \brief Writes a data buffer in the internal flash, merging consecutive writes
+ * to the same page into a single page program.
+ *
+ * The data is copied in the RAM image of its page. That page is programmed when
+ * the write reaches its end, when a write targets another page, and by
+ * FLASHD_Flush() or FLASHD_Write(). Reading the flash returns the previous content
+ * until then.
+ *
+ * \note This function is not reentrant, it must not be called from a handler
+ * interrupting another flash operation.
+ * \param dwAddress  Write address.
+ * \param pvBuffer  Data buffer.
+ * \param dwSize  Size of data buffer in bytes.
+ * \return 0 if successful, otherwise returns the error code of a page program.
+ */
+extern uint32_t FLASHD_WriteBuffered( uint32_t dwAddress, const void *pvBuffer, uint32_t dwSize )
+{
+    Efc* pEfc ;
+    uint16_t wPage ;
+    uint16_t wOffset ;
+    uint32_t dwWriteSize ;
+    uint32_t dwPageAddress ;
+    uint32_t dwError ;
+
+    assert( pvBuffer ) ;
+    assert( dwAddress >=IFLASH_ADDR ) ;
+    assert( (dwAddress + dwSize) <= (IFLASH_ADDR + IFLASH_SIZE) ) ;
+
+    while ( dwSize > 0 )
+    {
+        EFC_TranslateAddress( &pEfc, dwAddress, &wPage, &wOffset ) ;
+        EFC_ComputeAddress( pEfc, wPage, 0, &dwPageAddress ) ;
+        dwWriteSize = min( (uint32_t)IFLASH_PAGE_SIZE - wOffset, dwSize ) ;
+
+        /* Program the buffered page before moving to another one */
+        if ( (_dwBufferedPage != 0) && (_dwBufferedPage != dwPageAddress) )
+        {
+            dwError = FLASHD_Flush() ;
+            if ( dwError )
+            {
+                return dwError ;
+            }
+        }
+
+        if ( _dwBufferedPage == 0 )
+        {
+            MEM_Copy( _aucPageBuffer, (void *)dwPageAddress, IFLASH_PAGE_SIZE ) ;
+            _dwBufferedPage = dwPageAddress ;
+        }
+
+        MEM_Copy( _aucPageBuffer + wOffset, pvBuffer, dwWriteSize ) ;
+
+        /* A sequential stream won't come back to a page it has filled */
+        if ( wOffset + dwWriteSize == IFLASH_PAGE_SIZE )
+        {
+            dwError = FLASHD_Flush() ;
+            if ( dwError )
+            {
+                return dwError ;
+            }
+        }
+
+        dwAddress += dwWriteSize ;
+        pvBuffer = (void *)((uint32_t) pvBuffer + dwWriteSize) ;
+        dwSize -= dwWriteSize ;
+    }
+
+    return 0 ;
+}
+
+/**
+ * \brief Programs the page buffered by FLASHD_WriteBuffered(), if any.
+ *
+ * \return 0 if successful, otherwise returns an error code. On error the page
+ * stays buffered.
+ */
+extern uint32_t FLASHD_Flush( void )
+{
+    Efc* pEfc ;
+    uint16_t wPage ;
+    uint32_t dwError ;
+
+    if ( _dwBufferedPage == 0 )
+    {
+        return 0 ;
+    }
+
+    EFC_TranslateAddress( &pEfc, _dwBufferedPage, &wPage, 0 ) ;
+    dwError = _WritePageBuffer( pEfc, wPage, _dwBufferedPage, EFC_FCMD_EWP ) ;
+    if ( dwError == 0 )
+    {
+        _dwBufferedPage = 0 ;
+    }
+
+    return dwError ;
+}
+
+/**
+ * \brief Programs a data buffer in erased internal flash, without erasing the
+ * pages first.
+ *
+ * The other bytes of the pages are programmed with 0xFF, i.e. left as they
+ * are: as programming can only clear bits, small records can thus be appended
+ * to a page one after the other, each write costing a page program but no
+ * erase.
+ *
+ * \param dwAddress  Write address.
+ * \param pvBuffer  Data buffer.
+ * \param dwSize  Size of data buffer in bytes.
+ * \return 0 if successful, otherwise returns an error code.
+ */
+extern uint32_t FLASHD_WriteNoErase( uint32_t dwAddress, const void *pvBuffer, uint32_t dwSize )
+{
+    Efc* pEfc ;
+    uint16_t wPage ;
+    uint16_t wOffset ;
+    uint32_t dwWriteSize ;
+    uint32_t dwPageAddress ;
+    uint32_t dwError ;
+
+    assert( pvBuffer ) ;
+    assert( dwAddress >=IFLASH_ADDR ) ;
+    assert( (dwAddress + dwSize) <= (IFLASH_ADDR + IFLASH_SIZE) ) ;
+
+    /* The page buffer is shared with FLASHD_WriteBuffered() */
+    dwError = FLASHD_Flush() ;
+    if ( dwError )
+    {
+        return dwError ;
+    }
+
+    while ( dwSize > 0 )
+    {
+        EFC_TranslateAddress( &pEfc, dwAddress, &wPage, &wOffset ) ;
+        EFC_ComputeAddress( pEfc, wPage, 0, &dwPageAddress ) ;
+        dwWriteSize = min( (uint32_t)IFLASH_PAGE_SIZE - wOffset, dwSize ) ;
+
+        MEM_Set( _aucPageBuffer, 0xFF, IFLASH_PAGE_SIZE ) ;
+        MEM_Copy( _aucPageBuffer + wOffset, pvBuffer, dwWriteSize ) ;
+
+        dwError = _WritePageBuffer( pEfc, wPage, dwPageAddress, EFC_FCMD_WP ) ;
+        if ( dwError )
+        {
+            return dwError ;
+        }
+
+        dwAddress += dwWriteSize ;
+        pvBuffer = (void *)((uint32_t) pvBuffer + dwWriteSize) ;
+        dwSize -= dwWriteSize ;
+    }
+
+    return 0 ;
+}
+
+/**
+ * \brief Erases the pages of an address range, leaving them at 0xFF.
+ *
+ * \param dwAddress  Start address, rounded down to a page boundary.
+ * \param dwSize  Size of the range in bytes, rounded up to whole pages.
+ * \return 0 if successful, otherwise returns an error code.
+ */
+extern uint32_t FLASHD_ErasePages( uint32_t dwAddress, uint32_t dwSize )
+{
+    Efc* pEfc ;
+    uint16_t wPage ;
+    uint16_t wOffset ;
+    uint32_t dwPageAddress ;
+    uint32_t dwError ;
+
+    assert( dwAddress >=IFLASH_ADDR ) ;
+    assert( (dwAddress + dwSize) <= (IFLASH_ADDR + IFLASH_SIZE) ) ;
+
+    /* The page buffer is shared with FLASHD_WriteBuffered() */
+    dwError = FLASHD_Flush() ;
+    if ( dwError )
+    {
+        return dwError ;
+    }
+
+    EFC_TranslateAddress( &pEfc, dwAddress, &wPage, &wOffset ) ;
+    dwSize += wOffset ;
+    MEM_Set( _aucPageBuffer, 0xFF, IFLASH_PAGE_SIZE ) ;
+
+    while ( dwSize > 0 )
+    {
+        EFC_ComputeAddress( pEfc, wPage, 0, &dwPageAddress ) ;
+        dwError = _WritePageBuffer( pEfc, wPage, dwPageAddress, EFC_FCMD_EWP ) ;
+        if ( dwError )
+        {
+            return dwError ;
+        }
+
+        dwSize -= min( (uint32_t)IFLASH_PAGE_SIZE, dwSize ) ;
+        wPage++ ;
+    }
+
+    return 0 ;
+}
+
 /**
  * \brief Locks all the regions in the given address range. The actual lock range is
  * reported through two output parameters.
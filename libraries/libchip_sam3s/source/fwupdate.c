@@ -0,0 +1,336 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Implementation of the safe internal flash firmware update.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "chip.h"
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Update states. */
+#define FWUPD_IDLE      0
+#define FWUPD_STAGING   1
+#define FWUPD_STAGED    2
+
+/* Places a function in RAM, so that it can run while the flash is programmed */
+#if defined ( __ICCARM__ )
+#define FWUPD_RAMFUNC __ramfunc /* IAR */
+#else
+#define FWUPD_RAMFUNC __attribute__ ((section (".ramfunc"), noinline, long_call)) // GCC
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Update state */
+static uint32_t _dwState = FWUPD_IDLE ;
+/** Announced image size */
+static uint32_t _dwImageSize ;
+/** Expected image CRC */
+static uint32_t _dwImageCrc ;
+/** Bytes given to FWUPD_Write() */
+static uint32_t _dwWritten ;
+/** Bytes handed to the CRCCU */
+static uint32_t _dwCrcDone ;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Hands the staged bytes up to dwEnd to the CRC stream, without waiting
+ * for the computation.
+ *
+ * \param dwEnd  Staged size covered once the stream is idle.
+ */
+static void _StartCrc( uint32_t dwEnd )
+{
+    if ( dwEnd <= _dwCrcDone )
+    {
+        return ;
+    }
+
+    /* The queue is empty, see FWUPD_Write() */
+    CRCCU_StreamAppend( (const void*)(FWUPD_STAGING_ADDR + _dwCrcDone), dwEnd - _dwCrcDone ) ;
+    _dwCrcDone = dwEnd ;
+}
+
+/**
+ * \brief Copies the staged image over the running one, verifies it and resets
+ * the chip.
+ *
+ * Runs from RAM with the interrupts masked, as the flash code, the vector table
+ * included, is overwritten. On a program error or a mismatch, the chip is reset
+ * with GPNVM bit 1 still cleared, i.e. into the SAM-BA monitor.
+ *
+ * \param dwSize  Image size.
+ */
+FWUPD_RAMFUNC static void _Install( uint32_t dwSize )
+{
+    uint32_t dwPages = (dwSize + IFLASH_PAGE_SIZE - 1) / IFLASH_PAGE_SIZE ;
+    uint32_t dwPage ;
+    uint32_t dwWord ;
+    uint32_t dwStatus ;
+    volatile uint32_t* pdwDestination ;
+    volatile uint32_t* pdwSource ;
+
+    __asm volatile ( "cpsid i" ) ;
+
+    for ( dwPage=0 ; dwPage < dwPages ; dwPage++ )
+    {
+        WDT->WDT_CR = WDT_CR_KEY(0xA5) | WDT_CR_WDRSTT ;
+
+        /* Fill the latch buffer with words only */
+        pdwDestination = (volatile uint32_t*)(IFLASH_ADDR + dwPage*IFLASH_PAGE_SIZE) ;
+        pdwSource = (volatile uint32_t*)(FWUPD_STAGING_ADDR + dwPage*IFLASH_PAGE_SIZE) ;
+        for ( dwWord=0 ; dwWord < IFLASH_PAGE_SIZE/4 ; dwWord++ )
+        {
+            pdwDestination[dwWord] = pdwSource[dwWord] ;
+        }
+
+        EFC->EEFC_FCR = EEFC_FCR_FKEY(0x5A) | EEFC_FCR_FARG(dwPage) | EEFC_FCR_FCMD(EFC_FCMD_EWP) ;
+        do
+        {
+            dwStatus = EFC->EEFC_FSR ;
+        }
+        while ( (dwStatus & EEFC_FSR_FRDY) != EEFC_FSR_FRDY ) ;
+
+        if ( dwStatus & (EEFC_FSR_FLOCKE | EEFC_FSR_FCMDE) )
+        {
+            break ;
+        }
+
+        for ( dwWord=0 ; dwWord < IFLASH_PAGE_SIZE/4 ; dwWord++ )
+        {
+            if ( pdwDestination[dwWord] != pdwSource[dwWord] )
+            {
+                break ;
+            }
+        }
+
+        if ( dwWord != IFLASH_PAGE_SIZE/4 )
+        {
+            break ;
+        }
+    }
+
+    if ( dwPage == dwPages )
+    {
+        /* Boot from flash again */
+        EFC->EEFC_FCR = EEFC_FCR_FKEY(0x5A) | EEFC_FCR_FARG(1) | EEFC_FCR_FCMD(EFC_FCMD_SFB) ;
+        while ( (EFC->EEFC_FSR & EEFC_FSR_FRDY) != EEFC_FSR_FRDY ) ;
+    }
+
+    RSTC->RSTC_CR = RSTC_CR_KEY(0xA5) | RSTC_CR_PROCRST | RSTC_CR_PERRST ;
+    for ( ;; ) ;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Starts an update.
+ *
+ * \param dwImageSize  Size of the new image in bytes.
+ * \param dwImageCrc  Expected CRCCU value of the image, see \ref fwupdate.h.
+ * \return FWUPD_OK, FWUPD_ERROR_SIZE if the image does not fit in the staging
+ * area or the running firmware overlaps it, FWUPD_ERROR_FLASH if the staging
+ * area cannot be unlocked.
+ */
+extern uint32_t FWUPD_Begin( uint32_t dwImageSize, uint32_t dwImageCrc )
+{
+    uint32_t dwFirmwareEnd = IFLASH_ADDR ;
+#if defined ( __GNUC__ )
+    extern uint32_t _etext ;
+    extern uint32_t _srelocate ;
+    extern uint32_t _erelocate ;
+
+    /* The running firmware ends with its initialized data image */
+    dwFirmwareEnd = (uint32_t)&_etext + ((uint32_t)&_erelocate - (uint32_t)&_srelocate) ;
+#endif
+
+    if ( (dwImageSize == 0) || (dwImageSize > FWUPD_MAX_IMAGE_SIZE) || (dwFirmwareEnd > FWUPD_STAGING_ADDR) )
+    {
+        return FWUPD_ERROR_SIZE ;
+    }
+
+    if ( FLASHD_Unlock( FWUPD_STAGING_ADDR, FWUPD_STAGING_ADDR + dwImageSize, 0, 0 ) )
+    {
+        return FWUPD_ERROR_FLASH ;
+    }
+
+    CRCCU_StreamStart( CRCCU_MR_PTYPE_CCIT8023 ) ;
+
+    _dwImageSize = dwImageSize ;
+    _dwImageCrc = dwImageCrc ;
+    _dwWritten = 0 ;
+    _dwCrcDone = 0 ;
+    _dwState = FWUPD_STAGING ;
+
+    return FWUPD_OK ;
+}
+
+/**
+ * \brief Stages the next chunk of the image.
+ *
+ * The pages completed by the chunk are programmed before returning, and the
+ * CRCCU starts reading them back. The flash holding the previous pages is not
+ * touched again.
+ *
+ * \param pvData  Chunk data.
+ * \param dwSize  Chunk size in bytes, any size.
+ * \return FWUPD_OK or an error code; after an error, the update must be started
+ * again.
+ */
+extern uint32_t FWUPD_Write( const void* pvData, uint32_t dwSize )
+{
+    uint32_t dwProgrammed ;
+
+    if ( _dwState != FWUPD_STAGING )
+    {
+        return FWUPD_ERROR_STATE ;
+    }
+
+    if ( dwSize > _dwImageSize - _dwWritten )
+    {
+        _dwState = FWUPD_IDLE ;
+        return FWUPD_ERROR_SIZE ;
+    }
+
+    /* The CRCCU must not read the flash while a page is programmed */
+    CRCCU_StreamWait() ;
+
+    if ( FLASHD_WriteBuffered( FWUPD_STAGING_ADDR + _dwWritten, pvData, dwSize ) )
+    {
+        _dwState = FWUPD_IDLE ;
+        return FWUPD_ERROR_FLASH ;
+    }
+    _dwWritten += dwSize ;
+
+    /* Whole pages behind the write pointer are programmed */
+    dwProgrammed = _dwWritten - (_dwWritten % IFLASH_PAGE_SIZE) ;
+    _StartCrc( dwProgrammed ) ;
+
+    return FWUPD_OK ;
+}
+
+/**
+ * \brief Programs the last page and checks the CRC of the staged image.
+ *
+ * \return FWUPD_OK when the staged image can be installed, FWUPD_ERROR_SIZE if
+ * less data than announced was written, FWUPD_ERROR_FLASH or FWUPD_ERROR_CRC.
+ */
+extern uint32_t FWUPD_End( void )
+{
+    uint32_t dwCrc ;
+
+    if ( _dwState != FWUPD_STAGING )
+    {
+        return FWUPD_ERROR_STATE ;
+    }
+
+    _dwState = FWUPD_IDLE ;
+
+    if ( _dwWritten != _dwImageSize )
+    {
+        return FWUPD_ERROR_SIZE ;
+    }
+
+    CRCCU_StreamWait() ;
+    if ( FLASHD_Flush() )
+    {
+        return FWUPD_ERROR_FLASH ;
+    }
+
+    _StartCrc( _dwImageSize ) ;
+    dwCrc = CRCCU_StreamGetCrc() ;
+
+    TRACE_DEBUG( "FWUPD: staged CRC 0x%08X, expected 0x%08X\n\r", dwCrc, _dwImageCrc ) ;
+
+    if ( dwCrc != _dwImageCrc )
+    {
+        return FWUPD_ERROR_CRC ;
+    }
+
+    _dwState = FWUPD_STAGED ;
+
+    return FWUPD_OK ;
+}
+
+/**
+ * \brief Drops the update in progress. The staging area is left as is.
+ */
+extern void FWUPD_Abort( void )
+{
+    CRCCU_StreamWait() ;
+    FLASHD_Flush() ;
+    _dwState = FWUPD_IDLE ;
+}
+
+/**
+ * \brief Returns the number of image bytes staged so far.
+ */
+extern uint32_t FWUPD_GetWrittenSize( void )
+{
+    return _dwWritten ;
+}
+
+/**
+ * \brief Installs the image checked by FWUPD_End() and resets the chip.
+ *
+ * Returns only if no image is ready or the flash cannot be prepared.
+ */
+extern void FWUPD_Install( void )
+{
+    if ( _dwState != FWUPD_STAGED )
+    {
+        return ;
+    }
+
+    /* Fall back to the SAM-BA monitor until the new image is complete */
+    if ( FLASHD_Unlock( IFLASH_ADDR, IFLASH_ADDR + _dwImageSize, 0, 0 ) || FLASHD_ClearGPNVM( 1 ) )
+    {
+        return ;
+    }
+
+    _Install( _dwImageSize ) ;
+}
+
@@ -151,8 +151,9 @@ uint32_t MCI_SetSpeed( Mcid* pMci, uint32_t mciSpeed, uint32_t mck )
     if (mciSpeed > 0)
     {
         clkdiv = (mck / 2 / mciSpeed);
-        /* Speed should not bigger than expired one */
-        if (mciSpeed < mck/2/clkdiv)
+        /* Speed should not bigger than expired one, nor than MCK/2 (e.g. a
+           50MHz high speed clock with MCK = 64MHz) */
+        if (clkdiv == 0 || mciSpeed < mck/2/clkdiv)
         {
             clkdiv ++;
         }
@@ -89,7 +89,7 @@ void MCI_Init( Mcid *pMci, Hsmci *pMciHw, uint8_t mciId, uint32_t dwMCk )
     pMci->pCommand  = NULL;
 
     /* Enable the MCI peripheral */
-    PMC_EnablePeripheral( mciId ) ;
+    PMC_AcquirePeripheral( mciId ) ;
 
     /* Reset the MCI */
     pMciHw->HSMCI_CR = HSMCI_CR_SWRST;
@@ -120,7 +120,7 @@ void MCI_Init( Mcid *pMci, Hsmci *pMciHw, uint8_t mciId, uint32_t dwMCk )
                       | ((1 << 4) & HSMCI_CFG_FERRCTRL);
 
     /* Disable the MCI peripheral clock. */
-    PMC_DisablePeripheral(mciId);
+    PMC_ReleasePeripheral(mciId);
 }
 
 /**
@@ -131,13 +131,11 @@ void MCI_Init( Mcid *pMci, Hsmci *pMciHw, uint8_t mciId, uint32_t dwMCk )
 void MCI_Reset(Mcid *pMci, uint8_t keepSettings)
 {
     Hsmci *pMciHw = pMci->pMciHw;
-    uint8_t mciDis;
 
     assert(pMci);
     assert(pMci->pMciHw);
 
-    PMC_EnablePeripheral(pMci->mciId);
-    mciDis = PMC_IsPeriphEnabled(pMci->mciId);
+    PMC_AcquirePeripheral(pMci->mciId);
     if (keepSettings)
     {
         uint32_t mr, sdcr, dtor, cstor;
@@ -160,10 +158,7 @@ void MCI_Reset(Mcid *pMci, uint8_t keepSettings)
         MCI_RESET(pMciHw);
         MCI_Disable(pMciHw);
     }
-    if ( mciDis )
-    {
-        PMC_DisablePeripheral( pMci->mciId ) ;
-    }
+    PMC_ReleasePeripheral(pMci->mciId);
 }
 
 /**
@@ -179,13 +174,11 @@ uint32_t MCI_SetSpeed( Mcid* pMci, uint32_t mciSpeed, uint32_t mck )
     Hsmci *pMciHw = pMci->pMciHw;
     uint32_t mciMr;
     uint32_t clkdiv;
-    uint8_t  mciDis;
 
     assert(pMci);
     assert(pMciHw);
 
-    PMC_EnablePeripheral(pMci->mciId);
-    mciDis = PMC_IsPeriphEnabled(pMci->mciId);
+    PMC_AcquirePeripheral(pMci->mciId);
 
     mciMr = pMciHw->HSMCI_MR & (~(uint32_t)HSMCI_MR_CLKDIV_Msk);
     /* Multimedia Card Interface clock (MCCK or MCI_CK) is Master Clock (MCK)
@@ -194,8 +187,9 @@ uint32_t MCI_SetSpeed( Mcid* pMci, uint32_t mciSpeed, uint32_t mck )
     if (mciSpeed > 0)
     {
         clkdiv = (mck / 2 / mciSpeed);
-        /* Speed should not bigger than expired one */
-        if (mciSpeed < mck/2/clkdiv)
+        /* Speed should not bigger than expired one, nor than MCK/2 (e.g. a
+           50MHz high speed clock with MCK = 64MHz) */
+        if (clkdiv == 0 || mciSpeed < mck/2/clkdiv)
         {
             clkdiv ++;
         }
@@ -215,10 +209,7 @@ uint32_t MCI_SetSpeed( Mcid* pMci, uint32_t mciSpeed, uint32_t mck )
     mciSpeed = mck / 2 / (clkdiv + 1);
     /* Modify MR */
     pMciHw->HSMCI_MR = mciMr | clkdiv;
-    if ( mciDis )
-    {
-        PMC_DisablePeripheral( pMci->mciId ) ;
-    }
+    PMC_ReleasePeripheral(pMci->mciId);
 
     return (mciSpeed);
 }
@@ -232,14 +223,12 @@ uint8_t MCI_EnableHsMode(Mcid* pMci, uint8_t hsEnable)
 {
     Hsmci *pMciHw = pMci->pMciHw;
     uint32_t cfgr;
-    uint8_t mciDis;
     uint8_t rc = 0;
 
     assert(pMci);
     assert(pMci->pMciHw);
 
-    PMC_EnablePeripheral(pMci->mciId);
-    mciDis = PMC_IsPeriphEnabled(pMci->mciId);
+    PMC_AcquirePeripheral(pMci->mciId);
 
     cfgr = pMciHw->HSMCI_CFG;
     if (hsEnable == 1)
@@ -259,10 +248,7 @@ uint8_t MCI_EnableHsMode(Mcid* pMci, uint8_t hsEnable)
     }
 
     pMciHw->HSMCI_CFG = cfgr;
-    if (mciDis)
-    {
-        PMC_DisablePeripheral(pMci->mciId);
-    }
+    PMC_ReleasePeripheral(pMci->mciId);
 
     return rc;
 }
@@ -277,7 +263,6 @@ uint32_t MCI_SetBusWidth(Mcid*pMci, uint32_t busWidth)
 {
     Hsmci *pMciHw = pMci->pMciHw;
     uint32_t mciSdcr;
-    uint8_t mciDis;
 
     assert(pMci);
     assert(pMci->pMciHw);
@@ -289,16 +274,12 @@ uint32_t MCI_SetBusWidth(Mcid*pMci, uint32_t busWidth)
 
     busWidth &= HSMCI_SDCR_SDCBUS_Msk ;
 
-    PMC_EnablePeripheral(pMci->mciId);
-    mciDis = PMC_IsPeriphEnabled(pMci->mciId);
+    PMC_AcquirePeripheral(pMci->mciId);
 
     mciSdcr = (pMciHw->HSMCI_SDCR & ~(uint32_t)(HSMCI_SDCR_SDCBUS_Msk));
     pMciHw->HSMCI_SDCR = mciSdcr | busWidth;
 
-    if (mciDis)
-    {
-        PMC_DisablePeripheral(pMci->mciId);
-    }
+    PMC_ReleasePeripheral(pMci->mciId);
 
     return 0;
 }
@@ -0,0 +1,87 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Implementation of the I/O event notification.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "chip.h"
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Receives the raised bits. */
+static volatile IoEventSink _fSink = 0 ;
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Sets the function receiving the raised events.
+ * \param fSink  Sink function, or 0 to drop the events.
+ */
+extern void IOEVT_SetSink( IoEventSink fSink )
+{
+    _fSink = fSink ;
+}
+
+/**
+ * \brief Raises event bits; called by the drivers from their completion
+ * paths, in interrupt or task context.
+ * \param dwEvents  Bits to raise.
+ */
+extern void IOEVT_Raise( uint32_t dwEvents )
+{
+    IoEventSink fSink = _fSink ;
+
+    if ( fSink != 0 )
+    {
+        fSink( dwEvents ) ;
+    }
+}
+
+/**
+ * \brief Transfer and Media callback raising the bits given as argument.
+ * \param pArg  Bits to raise, cast to a pointer.
+ * \param bStatus  Transfer status, not used.
+ * \param dwTransferred  Bytes transferred, not used.
+ * \param dwRemaining  Bytes not transferred, not used.
+ */
+extern void IOEVT_TransferCallback( void* pArg, uint8_t bStatus, uint32_t dwTransferred, uint32_t dwRemaining )
+{
+    IOEVT_Raise( (uint32_t)pArg ) ;
+}
@@ -0,0 +1,143 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Implementation of the ITM output on the Serial Wire Output pin.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "chip.h"
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+/** TPIU registers, not defined by the CMSIS header. */
+#define TPI_ACPR            (*(volatile uint32_t *)0xE0040010)
+#define TPI_SPPR            (*(volatile uint32_t *)0xE00400F0)
+#define TPI_FFCR            (*(volatile uint32_t *)0xE0040304)
+/** TPI_SPPR protocol: asynchronous NRZ (UART). */
+#define TPI_SPPR_NRZ        2
+/** TPI_FFCR: formatter bypassed, as needed by the SWO. */
+#define TPI_FFCR_TRIGIN     (1u << 8)
+
+/** Key unlocking the ITM registers. */
+#define ITM_LAR_KEY         0xC5ACCE55
+
+/** ATB identifier of the ITM. */
+#define ITM_ATB_ID          1
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Configures the TPIU and the ITM to send the given stimulus ports on
+ * the SWO pin. The JTAG TDO pin is used: the debug probe must use SWD.
+ *
+ * \param dwSwoBaud  Baud rate of the SWO, MCK/n with n from 1 to 8192.
+ * \param dwMck  Master clock frequency, the core clock of the TPIU.
+ * \param dwPorts  Bit mask of the stimulus ports to enable.
+ *
+ * \return 1 if configured, 0 if the baud rate is off by more than 3%.
+ */
+extern uint32_t ITM_Configure( uint32_t dwSwoBaud, uint32_t dwMck, uint32_t dwPorts )
+{
+    uint32_t dwDiv ;
+
+    if ( dwSwoBaud == 0 )
+    {
+        return 0 ;
+    }
+    dwDiv = (dwMck + dwSwoBaud/2) / dwSwoBaud ;
+    if ( (dwDiv == 0) || (dwDiv > 8192) )
+    {
+        return 0 ;
+    }
+    /* |MCK/div - baud| > 3% of baud */
+    if ( (uint64_t)100 * ((dwMck > dwDiv*dwSwoBaud) ? (dwMck - dwDiv*dwSwoBaud) : (dwDiv*dwSwoBaud - dwMck)) > (uint64_t)3 * dwDiv * dwSwoBaud )
+    {
+        return 0 ;
+    }
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk ;
+
+    /* PB5 as TDO/TRACESWO */
+    MATRIX->CCFG_SYSIO &= ~CCFG_SYSIO_SYSIO5 ;
+
+    TPI_SPPR = TPI_SPPR_NRZ ;
+    TPI_ACPR = dwDiv - 1 ;
+    TPI_FFCR = TPI_FFCR_TRIGIN ;
+
+    ITM->LAR = ITM_LAR_KEY ;
+    ITM->TCR = 0 ;
+    while ( (ITM->TCR & ITM_TCR_BUSY_Msk) != 0 ) ;
+    ITM->TPR = 0 ;
+    ITM->TCR = (ITM_ATB_ID << ITM_TCR_ATBID_Pos) | ITM_TCR_DWTENA_Msk | ITM_TCR_ITMENA_Msk ;
+    ITM->TER = dwPorts ;
+
+    return 1 ;
+}
+
+/**
+ * \brief Sends a buffer on a stimulus port, by words then by halfword and
+ * byte for the tail; nothing is sent if the port is disabled.
+ *
+ * \param dwPort  Stimulus port, 0 to 31.
+ * \param pucData  Data to send.
+ * \param dwSize  Number of bytes.
+ */
+extern void ITM_Write( uint32_t dwPort, const uint8_t* pucData, uint32_t dwSize )
+{
+    if ( !ITM_IsEnabled( dwPort ) )
+    {
+        return ;
+    }
+
+    for ( ; dwSize >= 4 ; dwSize -= 4, pucData += 4 )
+    {
+        ITM_WriteWord( dwPort, pucData[0] | (pucData[1] << 8) | (pucData[2] << 16) | ((uint32_t)pucData[3] << 24) ) ;
+    }
+    if ( dwSize >= 2 )
+    {
+        while ( ITM->PORT[dwPort].u32 == 0 ) ;
+        ITM->PORT[dwPort].u16 = pucData[0] | (pucData[1] << 8) ;
+        pucData += 2 ;
+        dwSize -= 2 ;
+    }
+    if ( dwSize )
+    {
+        while ( ITM->PORT[dwPort].u32 == 0 ) ;
+        ITM->PORT[dwPort].u8 = pucData[0] ;
+    }
+}
@@ -0,0 +1,282 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Implementation of the Cortex-M3 memory copy and fill primitives.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "chip.h"
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+/** Below this size, the setup of the bursts costs more than a byte loop. */
+#define MEM_SMALL_SIZE      16
+/** Size of a burst: 8 registers. */
+#define MEM_BURST_SIZE      32
+
+#if defined( __GNUC__ ) && defined( __thumb2__ )
+#define MEM_ASM_BURSTS      1
+/** Word read at any address; the Cortex-M3 handles unaligned LDR. */
+typedef struct { uint32_t dw ; } __attribute__ ((packed)) _MemUnalignedWord ;
+#else
+#define MEM_ASM_BURSTS      0
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Copies whole bursts between word-aligned buffers.
+ * \param ppdwDst  Destination, advanced past the copied bursts.
+ * \param ppdwSrc  Source, advanced past the copied bursts.
+ * \param dwBursts  Number of 32-byte bursts, not 0.
+ */
+static void _MEM_CopyBursts( uint32_t** ppdwDst, const uint32_t** ppdwSrc, uint32_t dwBursts )
+{
+#if (MEM_ASM_BURSTS == 1)
+    uint32_t* pdwDst = *ppdwDst ;
+    const uint32_t* pdwSrc = *ppdwSrc ;
+
+    /* r7 is left out of the list, it may be the frame pointer */
+    __asm volatile (
+        "1:                                         \n\t"
+        "ldmia  %1!, {r3-r6, r8-r10, r12}           \n\t"
+        "subs   %2, %2, #1                          \n\t"
+        "stmia  %0!, {r3-r6, r8-r10, r12}           \n\t"
+        "bne    1b                                  \n\t"
+        : "+r" (pdwDst), "+r" (pdwSrc), "+r" (dwBursts)
+        :
+        : "r3", "r4", "r5", "r6", "r8", "r9", "r10", "r12", "cc", "memory" ) ;
+
+    *ppdwDst = pdwDst ;
+    *ppdwSrc = pdwSrc ;
+#else
+    uint32_t* pdwDst = *ppdwDst ;
+    const uint32_t* pdwSrc = *ppdwSrc ;
+
+    do
+    {
+        pdwDst[0] = pdwSrc[0] ; pdwDst[1] = pdwSrc[1] ;
+        pdwDst[2] = pdwSrc[2] ; pdwDst[3] = pdwSrc[3] ;
+        pdwDst[4] = pdwSrc[4] ; pdwDst[5] = pdwSrc[5] ;
+        pdwDst[6] = pdwSrc[6] ; pdwDst[7] = pdwSrc[7] ;
+        pdwDst += 8 ;
+        pdwSrc += 8 ;
+    } while ( --dwBursts ) ;
+
+    *ppdwDst = pdwDst ;
+    *ppdwSrc = pdwSrc ;
+#endif
+}
+
+/**
+ * \brief Fills whole bursts of a word-aligned buffer.
+ * \param pdwDst  Destination.
+ * \param dwPattern  Word written.
+ * \param dwBursts  Number of 32-byte bursts, not 0.
+ * \return Destination past the filled bursts.
+ */
+static uint32_t* _MEM_FillBursts( uint32_t* pdwDst, uint32_t dwPattern, uint32_t dwBursts )
+{
+#if (MEM_ASM_BURSTS == 1)
+    __asm volatile (
+        "mov    r3, %2                              \n\t"
+        "mov    r4, %2                              \n\t"
+        "mov    r5, %2                              \n\t"
+        "mov    r6, %2                              \n\t"
+        "mov    r8, %2                              \n\t"
+        "mov    r9, %2                              \n\t"
+        "mov    r10, %2                             \n\t"
+        "mov    r12, %2                             \n\t"
+        "1:                                         \n\t"
+        "stmia  %0!, {r3-r6, r8-r10, r12}           \n\t"
+        "subs   %1, %1, #1                          \n\t"
+        "bne    1b                                  \n\t"
+        : "+r" (pdwDst), "+r" (dwBursts)
+        : "r" (dwPattern)
+        : "r3", "r4", "r5", "r6", "r8", "r9", "r10", "r12", "cc", "memory" ) ;
+#else
+    do
+    {
+        pdwDst[0] = dwPattern ; pdwDst[1] = dwPattern ;
+        pdwDst[2] = dwPattern ; pdwDst[3] = dwPattern ;
+        pdwDst[4] = dwPattern ; pdwDst[5] = dwPattern ;
+        pdwDst[6] = dwPattern ; pdwDst[7] = dwPattern ;
+        pdwDst += 8 ;
+    } while ( --dwBursts ) ;
+#endif
+
+    return pdwDst ;
+}
+
+/**
+ * \brief Fills a buffer with a word pattern, the bytes of which are equal.
+ */
+static void _MEM_Fill( uint8_t* pucDst, uint32_t dwPattern, uint32_t dwSize )
+{
+    uint32_t* pdwDst ;
+
+    if ( dwSize >= MEM_SMALL_SIZE )
+    {
+        /* Head: align the destination on a word */
+        while ( ((uint32_t)pucDst & 3) != 0 )
+        {
+            *pucDst++ = (uint8_t)dwPattern ;
+            dwSize-- ;
+        }
+
+        pdwDst = (uint32_t*)pucDst ;
+        if ( dwSize >= MEM_BURST_SIZE )
+        {
+            pdwDst = _MEM_FillBursts( pdwDst, dwPattern, dwSize / MEM_BURST_SIZE ) ;
+            dwSize %= MEM_BURST_SIZE ;
+        }
+        while ( dwSize >= 4 )
+        {
+            *pdwDst++ = dwPattern ;
+            dwSize -= 4 ;
+        }
+        pucDst = (uint8_t*)pdwDst ;
+    }
+
+    /* Tail */
+    while ( dwSize-- )
+    {
+        *pucDst++ = (uint8_t)dwPattern ;
+    }
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Copies a buffer; the buffers shall not overlap.
+ * \param pDst  Destination.
+ * \param pSrc  Source.
+ * \param dwSize  Number of bytes to copy.
+ * \return pDst, like memcpy().
+ */
+extern void* MEM_Copy( void* pDst, const void* pSrc, uint32_t dwSize )
+{
+    uint8_t* pucDst = (uint8_t*)pDst ;
+    const uint8_t* pucSrc = (const uint8_t*)pSrc ;
+    uint32_t* pdwDst ;
+    const uint32_t* pdwSrc ;
+
+    if ( dwSize >= MEM_SMALL_SIZE )
+    {
+        /* Head: align the destination on a word */
+        while ( ((uint32_t)pucDst & 3) != 0 )
+        {
+            *pucDst++ = *pucSrc++ ;
+            dwSize-- ;
+        }
+
+        pdwDst = (uint32_t*)pucDst ;
+        if ( ((uint32_t)pucSrc & 3) == 0 )
+        {
+            pdwSrc = (const uint32_t*)pucSrc ;
+            if ( dwSize >= MEM_BURST_SIZE )
+            {
+                _MEM_CopyBursts( &pdwDst, &pdwSrc, dwSize / MEM_BURST_SIZE ) ;
+                dwSize %= MEM_BURST_SIZE ;
+            }
+            while ( dwSize >= 4 )
+            {
+                *pdwDst++ = *pdwSrc++ ;
+                dwSize -= 4 ;
+            }
+            pucSrc = (const uint8_t*)pdwSrc ;
+        }
+#if (MEM_ASM_BURSTS == 1)
+        else
+        {
+            /* Misaligned source: unaligned loads, aligned stores */
+            while ( dwSize >= 16 )
+            {
+                pdwDst[0] = ((const _MemUnalignedWord*)pucSrc)[0].dw ;
+                pdwDst[1] = ((const _MemUnalignedWord*)pucSrc)[1].dw ;
+                pdwDst[2] = ((const _MemUnalignedWord*)pucSrc)[2].dw ;
+                pdwDst[3] = ((const _MemUnalignedWord*)pucSrc)[3].dw ;
+                pdwDst += 4 ;
+                pucSrc += 16 ;
+                dwSize -= 16 ;
+            }
+            while ( dwSize >= 4 )
+            {
+                *pdwDst++ = ((const _MemUnalignedWord*)pucSrc)->dw ;
+                pucSrc += 4 ;
+                dwSize -= 4 ;
+            }
+        }
+#endif
+        pucDst = (uint8_t*)pdwDst ;
+    }
+
+    /* Tail */
+    while ( dwSize-- )
+    {
+        *pucDst++ = *pucSrc++ ;
+    }
+
+    return pDst ;
+}
+
+/**
+ * \brief Fills a buffer with a byte value.
+ * \param pDst  Destination.
+ * \param ucValue  Value written.
+ * \param dwSize  Number of bytes to fill.
+ * \return pDst, like memset().
+ */
+extern void* MEM_Set( void* pDst, uint8_t ucValue, uint32_t dwSize )
+{
+    _MEM_Fill( (uint8_t*)pDst, ucValue * 0x01010101u, dwSize ) ;
+
+    return pDst ;
+}
+
+/**
+ * \brief Clears a buffer.
+ * \param pDst  Destination.
+ * \param dwSize  Number of bytes to clear.
+ */
+extern void MEM_Zero( void* pDst, uint32_t dwSize )
+{
+    _MEM_Fill( (uint8_t*)pDst, 0, dwSize ) ;
+}
@@ -0,0 +1,184 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Implementation of the fixed-size block pools.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "chip.h"
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initializes a pool over a storage area; the blocks are all free.
+ * \param pPool  Pointer to a MemPool instance.
+ * \param pStorage  Storage of the blocks, MEMPOOL_STORAGE_WORDS( dwBlockSize, dwCount ) words.
+ * \param dwBlockSize  Size of a block in bytes, rounded up to a multiple of 4.
+ * \param dwCount  Number of blocks, at most 65535.
+ * \return 0 if successful; otherwise returns 1.
+ */
+uint32_t MEMPOOL_Initialize( MemPool* pPool, uint32_t* pStorage, uint32_t dwBlockSize, uint32_t dwCount )
+{
+    uint8_t* pBlock ;
+    uint32_t i ;
+
+    if ( (dwBlockSize == 0) || (dwCount > 0xFFFF) )
+    {
+        return 1 ;
+    }
+
+    pPool->dwBlockSize = (dwBlockSize+3) & ~3u ;
+    pPool->wCount = dwCount ;
+    pPool->wUsed = 0 ;
+    pPool->wHighWater = 0 ;
+    pPool->wFailures = 0 ;
+    pPool->pStart = (uint8_t*)pStorage ;
+    pPool->pEnd = pPool->pStart + pPool->dwBlockSize*dwCount ;
+
+    /* Chain the blocks in address order */
+    pPool->pFree = (dwCount != 0) ? pPool->pStart : 0 ;
+    for ( i=0, pBlock=pPool->pStart ; i < dwCount ; i++, pBlock+=pPool->dwBlockSize )
+    {
+        *(void**)pBlock = (i+1 < dwCount) ? (pBlock+pPool->dwBlockSize) : 0 ;
+    }
+
+    return 0 ;
+}
+
+/**
+ * \brief Takes a block out of a pool; can be called from an interrupt handler.
+ * \param pPool  Pointer to a MemPool instance.
+ * \return Pointer to the block (word aligned), or 0 if the pool is exhausted.
+ */
+void* MEMPOOL_Alloc( MemPool* pPool )
+{
+    void* pBlock ;
+    uint32_t primask = __get_PRIMASK() ;
+
+    __disable_irq() ;
+    pBlock = pPool->pFree ;
+    if ( pBlock )
+    {
+        pPool->pFree = *(void**)pBlock ;
+        if ( ++pPool->wUsed > pPool->wHighWater )
+        {
+            pPool->wHighWater = pPool->wUsed ;
+        }
+    }
+    else
+    {
+        pPool->wFailures++ ;
+    }
+    __set_PRIMASK( primask ) ;
+
+    return pBlock ;
+}
+
+/**
+ * \brief Gives a block back to its pool; can be called from an interrupt handler.
+ * \param pPool  Pointer to the MemPool instance the block comes from.
+ * \param pBlock  Block returned by MEMPOOL_Alloc(); 0 is ignored.
+ * \return 0 if successful; otherwise returns 1 (not a block of the pool).
+ */
+uint32_t MEMPOOL_Free( MemPool* pPool, void* pBlock )
+{
+    uint8_t* p = (uint8_t*)pBlock ;
+    uint32_t primask ;
+
+    if ( p == 0 )
+    {
+        return 0 ;
+    }
+
+    if ( (p < pPool->pStart) || (p >= pPool->pEnd) || (((uint32_t)(p - pPool->pStart) % pPool->dwBlockSize) != 0) )
+    {
+        TRACE_ERROR( "MEMPOOL_Free: block 0x%X not in the pool\n\r", (unsigned int)p ) ;
+        return 1 ;
+    }
+
+    primask = __get_PRIMASK() ;
+    __disable_irq() ;
+    *(void**)p = pPool->pFree ;
+    pPool->pFree = p ;
+    pPool->wUsed-- ;
+    __set_PRIMASK( primask ) ;
+
+    return 0 ;
+}
+
+/**
+ * \brief Returns the size of the blocks of a pool, in bytes.
+ * \param pPool  Pointer to a MemPool instance.
+ */
+uint32_t MEMPOOL_GetBlockSize( MemPool* pPool )
+{
+    return pPool->dwBlockSize ;
+}
+
+/**
+ * \brief Returns the number of free blocks of a pool.
+ * \param pPool  Pointer to a MemPool instance.
+ */
+uint32_t MEMPOOL_GetFreeCount( MemPool* pPool )
+{
+    return pPool->wCount - pPool->wUsed ;
+}
+
+/**
+ * \brief Returns the highest number of blocks allocated at the same time since
+ * the pool initialization or the last MEMPOOL_ResetHighWater().
+ * \param pPool  Pointer to a MemPool instance.
+ */
+uint32_t MEMPOOL_GetHighWater( MemPool* pPool )
+{
+    return pPool->wHighWater ;
+}
+
+/**
+ * \brief Restarts the high-water mark of a pool from the blocks currently
+ * allocated, and clears its failure count.
+ * \param pPool  Pointer to a MemPool instance.
+ */
+void MEMPOOL_ResetHighWater( MemPool* pPool )
+{
+    uint32_t primask = __get_PRIMASK() ;
+
+    __disable_irq() ;
+    pPool->wHighWater = pPool->wUsed ;
+    pPool->wFailures = 0 ;
+    __set_PRIMASK( primask ) ;
+}
@@ -0,0 +1,345 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Implementation of the PC-sampling profiler.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "chip.h"
+
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+#if (PCSAMP_TABLE_SIZE & (PCSAMP_TABLE_SIZE-1)) != 0
+#error PCSAMP_TABLE_SIZE must be a power of two
+#endif
+
+/** Records sent per call of the writer. */
+#define PCSAMP_RECORDS_PER_WRITE    8
+
+/** Channel of the sampling timer. */
+#define _TcChannel                  (PCSAMP_TC->TC_CHANNEL[PCSAMP_TC_CHANNEL])
+
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+/** Entry of the hash table, free when dwCount is 0. */
+typedef struct _PcSampEntry
+{
+    uint32_t dwPc ;
+    uint32_t dwLr ;
+    uint32_t dwCount ;
+} PcSampEntry ;
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+/** Hash table of the samples. */
+static PcSampEntry _aTable[PCSAMP_TABLE_SIZE] ;
+
+/** Samples taken since the last reset. */
+static uint32_t _dwSamples ;
+
+/** Samples dropped since the last reset, the table being full. */
+static uint32_t _dwDropped ;
+
+/** Sampling rate, flags, mean period and dithering mask of the timer. */
+static uint32_t _dwRate ;
+static uint32_t _dwFlags ;
+static uint32_t _dwPeriod ;
+static uint32_t _dwDither ;
+
+/** State of the dithering sequence, never 0. */
+static uint32_t _dwLfsr = 1 ;
+
+/** Are the samples counted. */
+static volatile uint8_t _ucRunning = 0 ;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _Put16( uint8_t* p, uint32_t dw )
+{
+    p[0] = (uint8_t)dw ;
+    p[1] = (uint8_t)(dw >> 8) ;
+}
+
+static void _Put32( uint8_t* p, uint32_t dw )
+{
+    p[0] = (uint8_t)dw ;
+    p[1] = (uint8_t)(dw >> 8) ;
+    p[2] = (uint8_t)(dw >> 16) ;
+    p[3] = (uint8_t)(dw >> 24) ;
+}
+
+/**
+ * \brief Updates a CRC-16/CCITT (polynomial 0x1021).
+ */
+static uint32_t _Crc16( uint32_t dwCrc, const uint8_t* pData, uint32_t dwSize )
+{
+    uint32_t i ;
+
+    while ( dwSize-- )
+    {
+        dwCrc ^= (uint32_t)(*pData++) << 8 ;
+        for ( i=0 ; i < 8 ; i++ )
+        {
+            dwCrc = (dwCrc & 0x8000) ? ((dwCrc << 1) ^ 0x1021) : (dwCrc << 1) ;
+        }
+    }
+
+    return dwCrc & 0xFFFF ;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+#if defined(__GNUC__)
+/**
+ * \brief Interrupt of the sampling timer: passes the exception frame of the
+ * interrupted code, on the main or the process stack, to PCSAMP_Sample().
+ * With other compilers, the application handler does it.
+ */
+extern void PCSAMP_TC_HANDLER( void ) __attribute__(( naked )) ;
+extern void PCSAMP_TC_HANDLER( void )
+{
+    __asm volatile
+    (
+        "   tst     lr, #4          \n"
+        "   ite     eq              \n"
+        "   mrseq   r0, msp         \n"
+        "   mrsne   r0, psp         \n"
+        "   b       PCSAMP_Sample   \n"
+    ) ;
+}
+#endif
+
+/**
+ * \brief Counts one sample; called by the interrupt of the sampling timer.
+ *
+ * \param pdwFrame  Exception frame of the interrupted code: r0-r3, r12, LR,
+ * PC, xPSR.
+ */
+extern void PCSAMP_Sample( const uint32_t* pdwFrame )
+{
+    PcSampEntry* pEntry ;
+    uint32_t dwPc ;
+    uint32_t dwLr ;
+    uint32_t dwIndex ;
+    uint32_t i ;
+
+    if ( (_TcChannel.TC_SR & TC_SR_CPCS) == 0 )
+    {
+        return ;
+    }
+
+    /* Next period, dithered around the mean one */
+    _dwLfsr = (_dwLfsr >> 1) ^ ((0u - (_dwLfsr & 1u)) & 0x80200003u) ;
+    _TcChannel.TC_RC = _dwPeriod - (_dwDither >> 1) + (_dwLfsr & _dwDither) ;
+
+    if ( !_ucRunning )
+    {
+        return ;
+    }
+
+    dwPc = pdwFrame[6] & ~1u ;
+    dwLr = (_dwFlags & PCSAMP_FLAG_LR) ? pdwFrame[5] : 0 ;
+    _dwSamples++ ;
+
+    dwIndex = ((dwPc ^ (dwLr << 7)) * 0x9E3779B1u) >> 16 ;
+    for ( i=0 ; i < PCSAMP_MAX_PROBES ; i++ )
+    {
+        pEntry = &_aTable[(dwIndex + i) & (PCSAMP_TABLE_SIZE-1)] ;
+        if ( pEntry->dwCount == 0 )
+        {
+            pEntry->dwPc = dwPc ;
+            pEntry->dwLr = dwLr ;
+            pEntry->dwCount = 1 ;
+            return ;
+        }
+        if ( (pEntry->dwPc == dwPc) && (pEntry->dwLr == dwLr) )
+        {
+            pEntry->dwCount++ ;
+            return ;
+        }
+    }
+    _dwDropped++ ;
+}
+
+/**
+ * \brief Clears the samples and starts sampling.
+ *
+ * \param dwRate  Sampling rate in Hz, e.g. 1000 to 10000.
+ * \param dwFlags  PCSAMP_FLAG_xxx.
+ * \param dwMck  Master clock frequency in Hz.
+ *
+ * \return 1 if sampling started, 0 if the rate cannot be reached.
+ */
+extern uint32_t PCSAMP_Start( uint32_t dwRate, uint32_t dwFlags, uint32_t dwMck )
+{
+    uint32_t dwDiv ;
+    uint32_t dwTcClks ;
+
+    if ( (dwRate == 0) || !TC_FindMckDivisor( dwRate, dwMck, &dwDiv, &dwTcClks, dwMck ) )
+    {
+        return 0 ;
+    }
+
+    PCSAMP_Stop() ;
+
+    _dwRate = dwRate ;
+    _dwFlags = dwFlags ;
+    _dwPeriod = dwMck / dwDiv / dwRate ;
+    /* Largest 2^n-1 up to 1/8 of the period */
+    for ( _dwDither=1 ; (_dwDither << 4) <= _dwPeriod ; _dwDither <<= 1 ) ;
+    _dwDither-- ;
+    PCSAMP_Reset() ;
+
+    PMC_EnablePeripheral( PCSAMP_TC_ID ) ;
+    TC_Configure( PCSAMP_TC, PCSAMP_TC_CHANNEL, dwTcClks | TC_CMR_WAVE | TC_CMR_WAVSEL_UP_RC ) ;
+    _TcChannel.TC_RC = _dwPeriod ;
+    _TcChannel.TC_IER = TC_IER_CPCS ;
+
+    NVIC_ClearPendingIRQ( PCSAMP_TC_IRQn ) ;
+    NVIC_SetPriority( PCSAMP_TC_IRQn, PCSAMP_TC_PRIORITY ) ;
+    NVIC_EnableIRQ( PCSAMP_TC_IRQn ) ;
+
+    _ucRunning = 1 ;
+    TC_Start( PCSAMP_TC, PCSAMP_TC_CHANNEL ) ;
+
+    return 1 ;
+}
+
+/**
+ * \brief Stops sampling; the samples are kept.
+ */
+extern void PCSAMP_Stop( void )
+{
+    _ucRunning = 0 ;
+    NVIC_DisableIRQ( PCSAMP_TC_IRQn ) ;
+    TC_Stop( PCSAMP_TC, PCSAMP_TC_CHANNEL ) ;
+    _TcChannel.TC_IDR = TC_IDR_CPCS ;
+}
+
+/**
+ * \brief Clears the samples.
+ */
+extern void PCSAMP_Reset( void )
+{
+    uint32_t primask = __get_PRIMASK() ;
+
+    __disable_irq() ;
+    memset( _aTable, 0, sizeof( _aTable ) ) ;
+    _dwSamples = 0 ;
+    _dwDropped = 0 ;
+    __set_PRIMASK( primask ) ;
+}
+
+/**
+ * \brief Sends the samples in a binary frame, whose layout is given in
+ * pcsamp.h.
+ *
+ * Sampling is paused while the frame is written, so that the dump does not
+ * profile itself; the other interrupts stay enabled. Not reentrant.
+ *
+ * \param fWrite  Function writing the frame bytes.
+ *
+ * \return Size of the frame in bytes.
+ */
+extern uint32_t PCSAMP_Dump( PcSampWrite fWrite )
+{
+    uint8_t aBuffer[PCSAMP_RECORDS_PER_WRITE*PCSAMP_RECORD_SIZE+2] ;
+    uint8_t* pRecord ;
+    uint32_t dwCount = 0 ;
+    uint32_t dwCrc ;
+    uint32_t dwEnabled ;
+    uint32_t i ;
+
+    dwEnabled = NVIC->ISER[(uint32_t)PCSAMP_TC_IRQn >> 5] & (1u << ((uint32_t)PCSAMP_TC_IRQn & 0x1F)) ;
+    NVIC_DisableIRQ( PCSAMP_TC_IRQn ) ;
+
+    for ( i=0 ; i < PCSAMP_TABLE_SIZE ; i++ )
+    {
+        if ( _aTable[i].dwCount != 0 )
+        {
+            dwCount++ ;
+        }
+    }
+
+    memcpy( aBuffer, "PCSM", 4 ) ;
+    aBuffer[4] = PCSAMP_VERSION ;
+    aBuffer[5] = (uint8_t)_dwFlags ;
+    _Put16( aBuffer+6, PCSAMP_RECORD_SIZE ) ;
+    _Put32( aBuffer+8, _dwRate ) ;
+    _Put32( aBuffer+12, _dwSamples ) ;
+    _Put32( aBuffer+16, _dwDropped ) ;
+    _Put16( aBuffer+20, dwCount ) ;
+    _Put16( aBuffer+22, 0 ) ;
+    dwCrc = _Crc16( 0xFFFF, aBuffer, PCSAMP_HEADER_SIZE ) ;
+    fWrite( aBuffer, PCSAMP_HEADER_SIZE ) ;
+
+    pRecord = aBuffer ;
+    for ( i=0 ; i < PCSAMP_TABLE_SIZE ; i++ )
+    {
+        if ( _aTable[i].dwCount == 0 )
+        {
+            continue ;
+        }
+        _Put32( pRecord, _aTable[i].dwPc ) ;
+        _Put32( pRecord+4, _aTable[i].dwLr ) ;
+        _Put32( pRecord+8, _aTable[i].dwCount ) ;
+        pRecord += PCSAMP_RECORD_SIZE ;
+        if ( pRecord == aBuffer+PCSAMP_RECORDS_PER_WRITE*PCSAMP_RECORD_SIZE )
+        {
+            dwCrc = _Crc16( dwCrc, aBuffer, pRecord-aBuffer ) ;
+            fWrite( aBuffer, pRecord-aBuffer ) ;
+            pRecord = aBuffer ;
+        }
+    }
+    dwCrc = _Crc16( dwCrc, aBuffer, pRecord-aBuffer ) ;
+    _Put16( pRecord, dwCrc ) ;
+    fWrite( aBuffer, pRecord-aBuffer+2 ) ;
+
+    if ( dwEnabled )
+    {
+        NVIC_EnableIRQ( PCSAMP_TC_IRQn ) ;
+    }
+
+    return PCSAMP_HEADER_SIZE + dwCount*PCSAMP_RECORD_SIZE + 2 ;
+}
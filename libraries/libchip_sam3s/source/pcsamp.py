@@ -0,0 +1,236 @@
+#!/usr/bin/env python
+# ----------------------------------------------------------------------------
+#         ATMEL Microcontroller Software Support
+# ----------------------------------------------------------------------------
+# Copyright (c) 2010, Atmel Corporation
+#
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# - Redistributions of source code must retain the above copyright notice,
+# this list of conditions and the disclaimer below.
+#
+# Atmel's name may not be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+# IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+# DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+# OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+# EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+# ----------------------------------------------------------------------------
+
+"""Decodes and symbolizes the PC-sampling profiler frames (see pcsamp.h).
+
+The frames sent by PCSAMP_Dump() are searched in a capture file or read live
+from a serial port (UART console or CDC serial, needs pyserial); text around
+them is ignored. The sampled addresses are mapped to the functions of the ELF
+file of the application, and to source lines with addr2line when asked.
+
+    pcsamp.py app.elf capture.bin
+    pcsamp.py app.elf --port /dev/ttyACM0 --callers
+    pcsamp.py app.elf capture.bin --lines --addr2line arm-none-eabi-addr2line
+"""
+
+import bisect
+import struct
+import subprocess
+import sys
+
+SIGNATURE = b'PCSM'
+HEADER = struct.Struct('<4sBBHIIIHH')
+RECORD = struct.Struct('<III')
+FLAG_LR = 0x01
+
+
+def crc16(data):
+    """CRC-16/CCITT, polynomial 0x1021, initial value 0xFFFF."""
+    crc = 0xFFFF
+    for byte in bytearray(data):
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+class Symbols(object):
+    """Function symbols of a 32-bit little endian ELF file."""
+
+    def __init__(self, path):
+        data = open(path, 'rb').read()
+        if data[:4] != b'\x7fELF' or data[4:6] != b'\x01\x01':
+            raise ValueError('%s: not a 32-bit little endian ELF file' % path)
+        (shoff,) = struct.unpack_from('<I', data, 0x20)
+        (shentsize, shnum) = struct.unpack_from('<HH', data, 0x2E)
+        sections = [struct.unpack_from('<IIIIIIIIII', data, shoff + i * shentsize)
+                    for i in range(shnum)]
+        functions = {}
+        for (_, sh_type, _, _, offset, size, link, _, _, entsize) in sections:
+            if sh_type != 2:            # SHT_SYMTAB
+                continue
+            strtab = sections[link]
+            strings = data[strtab[4]:strtab[4] + strtab[5]]
+            for pos in range(offset, offset + size, entsize or 16):
+                (name, value, sym_size, info, _,
+                 shndx) = struct.unpack_from('<IIIBBH', data, pos)
+                if (info & 0xF) != 2 or not shndx:  # STT_FUNC, defined
+                    continue
+                end = strings.find(b'\0', name)
+                functions[value & ~1] = (strings[name:end].decode('latin-1'),
+                                         sym_size)
+        self.addresses = sorted(functions)
+        self.functions = [functions[a] for a in self.addresses]
+
+    def lookup(self, address):
+        """Returns (function name, offset) of address, or (None, 0)."""
+        i = bisect.bisect_right(self.addresses, address) - 1
+        if i < 0:
+            return None, 0
+        (name, size) = self.functions[i]
+        offset = address - self.addresses[i]
+        if size and offset >= size:
+            return None, 0
+        return name, offset
+
+    def function(self, address):
+        """Returns the name of the function holding address."""
+        name = self.lookup(address)[0]
+        return name if name else '0x%08x' % address
+
+
+def parse(buf):
+    """Returns (frames, rest): the frames decoded from buf, and the bytes
+    kept for the next call since they may start an incomplete frame."""
+    frames = []
+    while True:
+        start = buf.find(SIGNATURE)
+        if start < 0:
+            return frames, buf[-(len(SIGNATURE) - 1):]
+        buf = buf[start:]
+        if len(buf) < HEADER.size:
+            return frames, buf
+        (_, version, flags, record_size, rate, samples, dropped, count,
+         _) = HEADER.unpack_from(buf)
+        if version != 1 or record_size != RECORD.size:
+            buf = buf[1:]
+            continue
+        size = HEADER.size + count * record_size
+        if len(buf) < size + 2:
+            return frames, buf
+        (crc,) = struct.unpack_from('<H', buf, size)
+        if crc != crc16(buf[:size]):
+            buf = buf[1:]
+            continue
+        records = [RECORD.unpack_from(buf, HEADER.size + i * record_size)
+                   for i in range(count)]
+        frames.append({'flags': flags,
+                       'rate': rate,
+                       'samples': samples,
+                       'dropped': dropped,
+                       'records': records})
+        buf = buf[size + 2:]
+
+
+def source_lines(tool, elf, addresses):
+    """Returns {address: 'file:line'} from addr2line."""
+    if not addresses:
+        return {}
+    output = subprocess.check_output(
+        [tool, '-e', elf] + ['0x%x' % a for a in addresses])
+    lines = output.decode('latin-1').splitlines()
+    return dict(zip(addresses, lines))
+
+
+def show(frame, symbols, options, out=sys.stdout):
+    """Prints the profile of a frame, by function then by caller or line."""
+    total = frame['samples'] or 1
+    out.write('%d samples at %d Hz (%.2f s), %d dropped, %d addresses\n'
+              % (frame['samples'], frame['rate'],
+                 float(frame['samples']) / (frame['rate'] or 1),
+                 frame['dropped'], len(frame['records'])))
+
+    by_function = {}
+    for (pc, lr, count) in frame['records']:
+        entry = by_function.setdefault(symbols.function(pc),
+                                       {'count': 0, 'pcs': {}, 'callers': {}})
+        entry['count'] += count
+        entry['pcs'][pc] = entry['pcs'].get(pc, 0) + count
+        if frame['flags'] & FLAG_LR:
+            caller = symbols.function(lr & ~1)
+            entry['callers'][caller] = entry['callers'].get(caller, 0) + count
+
+    ranked = sorted(by_function.items(), key=lambda f: -f[1]['count'])
+    ranked = ranked[:options.top]
+    lines = {}
+    if options.lines:
+        hot = set()
+        for (_, entry) in ranked:
+            hot.update(sorted(entry['pcs'], key=lambda a: -entry['pcs'][a])[:3])
+        lines = source_lines(options.addr2line, options.elf, sorted(hot))
+
+    out.write('%7s %8s  %s\n' % ('%', 'samples', 'function'))
+    for (name, entry) in ranked:
+        out.write('%6.2f%% %8d  %s\n'
+                  % (100.0 * entry['count'] / total, entry['count'], name))
+        if options.callers:
+            for (caller, count) in sorted(entry['callers'].items(),
+                                          key=lambda c: -c[1])[:3]:
+                out.write('%16s  from %s (%d)\n' % ('', caller, count))
+        if options.lines:
+            for pc in sorted(entry['pcs'], key=lambda a: -entry['pcs'][a])[:3]:
+                out.write('%16s  0x%08x %s (%d)\n'
+                          % ('', pc, lines.get(pc, ''), entry['pcs'][pc]))
+    out.write('\n')
+
+
+def main(argv):
+    import optparse
+    parser = optparse.OptionParser(usage='%prog [options] elf [capture file]')
+    parser.add_option('-p', '--port', help='serial port to read live')
+    parser.add_option('-b', '--baud', type='int', default=115200,
+                      help='serial port baud rate [%default]')
+    parser.add_option('-n', '--top', type='int', default=20,
+                      help='functions shown [%default]')
+    parser.add_option('-c', '--callers', action='store_true',
+                      help='show the callers (needs PCSAMP_FLAG_LR)')
+    parser.add_option('-l', '--lines', action='store_true',
+                      help='show the hottest source lines of each function')
+    parser.add_option('--addr2line', default='arm-none-eabi-addr2line',
+                      help='addr2line of the toolchain [%default]')
+    (options, args) = parser.parse_args(argv[1:])
+
+    if not args:
+        parser.error('give the ELF file of the application')
+    options.elf = args[0]
+    symbols = Symbols(args[0])
+    if options.port:
+        import serial
+        stream = serial.Serial(options.port, options.baud, timeout=0.5)
+    elif len(args) == 2:
+        stream = open(args[1], 'rb')
+    else:
+        parser.error('give a capture file or a serial port')
+
+    rest = b''
+    while True:
+        data = stream.read(1024)
+        if not data:
+            if not options.port:
+                break
+            continue
+        frames, rest = parse(rest + data)
+        for frame in frames:
+            show(frame, symbols, options)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -438,6 +438,7 @@ unsigned char PIO_GetOutputDataStatus(const Pin *pin)
 
 /*
  * \brief Configures Glitch or Debouncing filter for input.
+ * The debouncing period is common to all the pins of the PIO controller.
  *
  * \param pin  Pointer to a Pin instance describing one or more pins.
  * \param cuttoff  Cutt off frequency for debounce filter.
@@ -445,7 +446,42 @@ unsigned char PIO_GetOutputDataStatus(const Pin *pin)
 void PIO_SetDebounceFilter( const Pin *pin, uint32_t cuttoff )
 {
     Pio *pio = pin->pio;
+    uint32_t div;
+
+    assert( cuttoff > 0 ) ;
+
+    /* Slow clock divided by 2 * (div + 1) */
+    div = 32768 / (2 * cuttoff);
+    div = (div > 0) ? div - 1 : 0;
+    if (div > 0x3FFF) div = 0x3FFF; /* the lowest 14 bits work */
 
     pio->PIO_IFSCER = pin->mask; /* set Debouncing, 0 bit field no effect */
-    pio->PIO_SCDR = ((32678/(2*(cuttoff))) - 1) & 0x3FFF; /* the lowest 14 bits work */
+    pio->PIO_SCDR = div;
+    pio->PIO_IFER = pin->mask; /* enable the input filter */
+}
+
+/**
+ * \brief Configures the pins of a group as outputs driven to a first value,
+ * without pull-up nor multi-drive, and gives the PIO_ODSR write mask of the
+ * controller to the group.
+ *
+ * \param group  Pointer to a PinGroup instance.
+ * \param value  First value of the group.
+ */
+void PIO_GroupConfigure( const PinGroup *group, uint32_t value )
+{
+    Pio *pio = group->pio;
+
+    /* Clock for PIO_GroupRead() */
+    PMC_EnablePeripheral(group->id);
+
+    pio->PIO_IDR = group->mask;
+    pio->PIO_PUDR = group->mask;
+    pio->PIO_MDDR = group->mask;
+
+    PIO_GroupAcquire(group);
+    PIO_GroupWrite(group, value);
+
+    pio->PIO_OER = group->mask;
+    pio->PIO_PER = group->mask;
 }
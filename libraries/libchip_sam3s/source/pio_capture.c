@@ -71,6 +71,7 @@
 #include "chip.h"
 
 #include <assert.h>
+#include <string.h>
 
 /*----------------------------------------------------------------------------
  *        Local Functions
@@ -201,6 +202,24 @@ void PIO_CaptureDisable( void )
     PIOA->PIO_PCMR &= (uint32_t)(~PIO_PCMR_PCEN) ;
 }
 
+/*----------------------------------------------------------------------------*/
+/**
+ * \brief Queue the next buffer of the PIO Capture
+ * The PDC switches to this buffer when the current one is full, and the
+ * capture goes on without interruption. Writing the next counter also
+ * clears the End of Reception Transfer flag.
+ * \param pData : Next buffer for the received data
+ * \param dwSize : Size of the next buffer, in data of the PIO_PCRHR size
+ */
+/*----------------------------------------------------------------------------*/
+void PIO_CaptureNextBuffer( uint32_t* pData, uint16_t dwSize )
+{
+    /* PDC: Receive Next Pointer Register */
+    PIOA->PIO_RNPR = (uint32_t)pData ;
+    /* PDC: Receive Next Counter Register */
+    PIOA->PIO_RNCR = PIO_RNCR_RXNCTR(dwSize) ;
+}
+
 /*----------------------------------------------------------------------------*/
 /**
  * \brief Initialize the PIO Capture
@@ -281,3 +300,229 @@ void PIO_CaptureInit( SpioCaptureInit *pInit )
 
 }
 
+/*----------------------------------------------------------------------------
+ *        Streaming capture
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Returns the start of a buffer of the ring.
+ */
+static uint8_t* _CaptureStreamBuffer( PioCaptureStream* pStream, uint32_t dwIndex )
+{
+    return pStream->pBuffers + (dwIndex & pStream->dwMask) * pStream->dwBufferSize ;
+}
+
+/**
+ * \brief Hands the free buffers to the PDC, up to the current and the next
+ * buffer, then enables the interrupts matching the PDC state: End of
+ * Reception while a next buffer is queued, Reception Buffer Full while the
+ * last one is being filled. Interrupts must be masked if called from a task.
+ */
+static void _CaptureStreamQueue( PioCaptureStream* pStream )
+{
+    uint32_t dwTransfers = pStream->dwBufferSize >> pStream->bShift ;
+    uint8_t* pData ;
+
+    while (    (pStream->dwQueued - pStream->dwHead < 2)
+            && (pStream->dwQueued - pStream->dwTail < pStream->dwMask + 1) )
+    {
+        pData = _CaptureStreamBuffer( pStream, pStream->dwQueued ) ;
+        if ( PIOA->PIO_RCR == 0 )
+        {
+            PIOA->PIO_RPR = (uint32_t)pData ;
+            PIOA->PIO_RCR = PIO_RCR_RXCTR( dwTransfers ) ;
+        }
+        else
+        {
+            PIOA->PIO_RNPR = (uint32_t)pData ;
+            PIOA->PIO_RNCR = PIO_RNCR_RXNCTR( dwTransfers ) ;
+        }
+        pStream->dwQueued++ ;
+    }
+
+    /* The PDC flags stay set until a counter is written */
+    if ( PIOA->PIO_RNCR != 0 )
+    {
+        PIOA->PIO_PCIER = PIO_PCIER_ENDRX ;
+    }
+    else
+    {
+        PIOA->PIO_PCIDR = PIO_PCIDR_ENDRX ;
+    }
+    if ( PIOA->PIO_RCR != 0 )
+    {
+        PIOA->PIO_PCIER = PIO_PCIER_RXBUFF ;
+    }
+    else
+    {
+        /* Stalled: the capture restarts when a buffer is released */
+        PIOA->PIO_PCIDR = PIO_PCIDR_RXBUFF ;
+    }
+}
+
+/**
+ * \brief End of Reception and Reception Buffer Full callback: publishes the
+ * buffers the PDC is done with and queues the free ones.
+ */
+static void _CaptureStreamIt( SpioCaptureInit* pInit )
+{
+    PioCaptureStream* pStream = (PioCaptureStream*)pInit->pParam ;
+    uint32_t dwInPdc = pStream->dwQueued - pStream->dwHead ;
+    uint32_t dwFilled ;
+
+    /* PDC stopped: all the queued buffers are full, and samples are lost
+       until a buffer is queued */
+    if ( PIOA->PIO_RCR == 0 )
+    {
+        dwFilled = dwInPdc ;
+        pStream->dwStalls++ ;
+    }
+    else
+    {
+        dwFilled = dwInPdc - ((PIOA->PIO_RNCR != 0) ? 2 : 1) ;
+    }
+
+    /* The buffers are written before the consumer can see them */
+    __DMB() ;
+    pStream->dwHead += dwFilled ;
+
+    _CaptureStreamQueue( pStream ) ;
+}
+
+/**
+ * \brief Overrun callback: a sample was not read in time by the PDC.
+ */
+static void _CaptureStreamOverrun( SpioCaptureInit* pInit )
+{
+    ((PioCaptureStream*)pInit->pParam)->dwOverruns++ ;
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+ * \brief Initialize a streaming capture over a ring of buffers.
+ * The sampling options of pStream->captureInit (alwaysSampling, halfSampling,
+ * modeFirstSample) can be changed before PIO_CaptureStreamStart().
+ * \param pStream : Stream to initialize
+ * \param pBuffers : dwCount buffers of dwBufferSize bytes, word aligned
+ * \param dwBufferSize : Size of a buffer in bytes, multiple of the transfer size
+ * \param dwCount : Number of buffers, a power of two, at least 2 (4 or more
+ * lets the consumer hold a buffer while two are queued to the PDC)
+ * \param dsize : Samples packed per transfer, as PIO_PCMR DSIZE:
+ * 0 = 1 sample (BYTE), 1 = 2 samples (HALF-WORD), 2 = 4 samples (WORD).
+ */
+/*----------------------------------------------------------------------------*/
+void PIO_CaptureStreamInit( PioCaptureStream* pStream, uint8_t* pBuffers, uint32_t dwBufferSize,
+                            uint32_t dwCount, uint8_t dsize )
+{
+    assert( (dwCount >= 2) && ((dwCount & (dwCount - 1)) == 0) ) ;
+    assert( dsize < 3 ) ;
+    assert( (dwBufferSize & ((1u << dsize) - 1)) == 0 ) ;
+    assert( (dwBufferSize >> dsize) <= 0xFFFF ) ;
+    assert( ((uint32_t)pBuffers & 3) == 0 ) ;
+
+    pStream->pBuffers = pBuffers ;
+    pStream->dwBufferSize = dwBufferSize ;
+    pStream->dwMask = dwCount - 1 ;
+    pStream->bShift = dsize ;
+    pStream->dwHead = 0 ;
+    pStream->dwTail = 0 ;
+    pStream->dwQueued = 0 ;
+    pStream->dwStalls = 0 ;
+    pStream->dwOverruns = 0 ;
+
+    memset( &pStream->captureInit, 0, sizeof( pStream->captureInit ) ) ;
+    pStream->captureInit.dsize = dsize ;
+    pStream->captureInit.CbkOverrun = _CaptureStreamOverrun ;
+    pStream->captureInit.CbkEndReception = _CaptureStreamIt ;
+    pStream->captureInit.CbkBuffFull = _CaptureStreamIt ;
+    pStream->captureInit.pParam = pStream ;
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+ * \brief Start a streaming capture: the first two buffers are queued to the
+ * PDC and the capture is enabled.
+ * \param pStream : Stream initialized with PIO_CaptureStreamInit()
+ */
+/*----------------------------------------------------------------------------*/
+void PIO_CaptureStreamStart( PioCaptureStream* pStream )
+{
+    pStream->dwHead = 0 ;
+    pStream->dwTail = 0 ;
+    pStream->dwQueued = 1 ;
+
+    pStream->captureInit.pData = (uint32_t*)_CaptureStreamBuffer( pStream, 0 ) ;
+    pStream->captureInit.dPDCsize = pStream->dwBufferSize >> pStream->bShift ;
+    PIO_CaptureInit( &pStream->captureInit ) ;
+
+    _CaptureStreamQueue( pStream ) ;
+    PIO_CaptureEnable() ;
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+ * \brief Stop a streaming capture. The buffers already published can still
+ * be read.
+ * \param pStream : Stream
+ */
+/*----------------------------------------------------------------------------*/
+void PIO_CaptureStreamStop( PioCaptureStream* pStream )
+{
+    PIO_CaptureDisable() ;
+    PIOA->PIO_PCIDR = PIO_PCIDR_DRDY | PIO_PCIDR_OVRE | PIO_PCIDR_ENDRX | PIO_PCIDR_RXBUFF ;
+    PIOA->PIO_PTCR = PIO_PTCR_RXTDIS ;
+    PIOA->PIO_RCR = 0 ;
+    PIOA->PIO_RNCR = 0 ;
+    pStream->dwQueued = pStream->dwHead ;
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+ * \brief Get the oldest full buffer of a streaming capture, to be processed
+ * in place and then given back with PIO_CaptureStreamRelease(). The other
+ * buffers are filled meanwhile.
+ * \param pStream : Stream
+ * \param ppData : Receives the start of the buffer
+ * \return Size of the buffer in bytes, 0 if no buffer is full.
+ */
+/*----------------------------------------------------------------------------*/
+uint32_t PIO_CaptureStreamGet( PioCaptureStream* pStream, uint8_t** ppData )
+{
+    if ( pStream->dwHead == pStream->dwTail )
+    {
+        return 0 ;
+    }
+    /* The buffer content is read after the head */
+    __DMB() ;
+    *ppData = _CaptureStreamBuffer( pStream, pStream->dwTail ) ;
+
+    return pStream->dwBufferSize ;
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+ * \brief Give back the buffer returned by PIO_CaptureStreamGet(), and
+ * restart the capture if it was stalled for lack of free buffer.
+ * \param pStream : Stream
+ */
+/*----------------------------------------------------------------------------*/
+void PIO_CaptureStreamRelease( PioCaptureStream* pStream )
+{
+    uint32_t dwPrimask ;
+
+    assert( pStream->dwHead != pStream->dwTail ) ;
+
+    pStream->dwTail++ ;
+
+    /* The PDC may be waiting for this buffer */
+    if ( pStream->dwQueued - pStream->dwHead < 2 )
+    {
+        dwPrimask = __get_PRIMASK() ;
+        __disable_irq() ;
+        if ( PIOA->PIO_PCMR & PIO_PCMR_PCEN )
+        {
+            _CaptureStreamQueue( pStream ) ;
+        }
+        __set_PRIMASK( dwPrimask ) ;
+    }
+}
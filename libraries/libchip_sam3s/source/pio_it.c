@@ -38,6 +38,7 @@
 #include "chip.h"
 
 #include <assert.h>
+#include <string.h>
 
 /*----------------------------------------------------------------------------
  *        Local definitions
@@ -46,7 +47,19 @@
 /* Maximum number of interrupt sources that can be defined. This
  * constant can be increased, but the current value is the smallest possible
  * that will be compatible with all existing projects. */
+#ifndef MAX_INTERRUPT_SOURCES
 #define MAX_INTERRUPT_SOURCES       7
+#endif
+
+/* Count of the leading zeros of a non-zero word, one CLZ instruction */
+#if defined   ( __CC_ARM   )
+  #define PIO_CLZ( dw )             __clz( dw )
+#elif defined ( __ICCARM__ )
+  #include <intrinsics.h>
+  #define PIO_CLZ( dw )             __CLZ( dw )
+#elif defined (  __GNUC__  )
+  #define PIO_CLZ( dw )             __builtin_clz( dw )
+#endif
 
 /*----------------------------------------------------------------------------
  *        Local types
@@ -63,6 +76,9 @@ typedef struct _InterruptSource
 
     /* Interrupt handler. */
     void (*handler)( const Pin* ) ;
+
+    /* Interrupt handler receiving the pending pins, NULL if handler is used. */
+    void (*handlerMask)( const Pin*, uint32_t ) ;
 } InterruptSource ;
 
 /*----------------------------------------------------------------------------
@@ -75,6 +91,11 @@ static InterruptSource _aIntSources[MAX_INTERRUPT_SOURCES] ;
 /* Number of currently defined interrupt sources. */
 static uint32_t _dwNumSources = 0;
 
+/* Source of each pin of each PIO controller, indexed by id-ID_PIOA and by the
+ * bit position: source index + 1, 0 for none. Only the pending pins of the
+ * interrupted controller are looked at. */
+static uint8_t _aucPinSources[3][32] ;
+
 /*----------------------------------------------------------------------------
  *        Local Functions
  *----------------------------------------------------------------------------*/
@@ -92,10 +113,13 @@ static uint32_t _dwNumSources = 0;
  * \param id  PIO controller ID.
  * \param pPio  PIO controller base address.
  */
-extern void PioInterruptHandler( uint32_t id, Pio *pPio )
+IRQ_RAMFUNC extern void PioInterruptHandler( uint32_t id, Pio *pPio )
 {
     uint32_t status;
-    uint32_t i;
+    uint32_t dwBit;
+    uint32_t dwSource;
+    const InterruptSource *pSource;
+    const uint8_t *pucSources = _aucPinSources[id - ID_PIOA];
 
     /* Read PIO controller status */
     status = pPio->PIO_ISR;
@@ -106,26 +130,33 @@ extern void PioInterruptHandler( uint32_t id, Pio *pPio )
     {
         TRACE_DEBUG( "PIO interrupt on PIO controller #%d\n\r", id ) ;
 
-        /* Find triggering source */
-        i = 0;
+        /* Look at the pending pins only, highest first */
         while ( status != 0 )
         {
+            dwBit = 31 - PIO_CLZ( status ) ;
+            dwSource = pucSources[dwBit] ;
+
             /* There cannot be an unconfigured source enabled. */
-            assert(i < _dwNumSources);
+            assert( dwSource != 0 ) ;
+            if ( dwSource == 0 )
+            {
+                status &= ~(1u << dwBit) ;
+                continue ;
+            }
+
+            pSource = &_aIntSources[dwSource - 1] ;
+            TRACE_DEBUG( "Interrupt source #%d triggered\n\r", dwSource - 1 ) ;
 
-            /* Source is configured on the same controller */
-            if (_aIntSources[i].pPin->id == id)
+            /* One call per source, whatever the number of its pending pins */
+            if ( pSource->handlerMask != NULL )
             {
-                /* Source has PIOs whose statuses have changed */
-                if ( (status & _aIntSources[i].pPin->mask) != 0 )
-                {
-                    TRACE_DEBUG( "Interrupt source #%d triggered\n\r", i ) ;
-
-                    _aIntSources[i].handler(_aIntSources[i].pPin);
-                    status &= ~(_aIntSources[i].pPin->mask);
-                }
+                pSource->handlerMask( pSource->pPin, status & pSource->pPin->mask ) ;
             }
-            i++;
+            else
+            {
+                pSource->handler( pSource->pPin ) ;
+            }
+            status &= ~(pSource->pPin->mask) ;
         }
     }
 }
@@ -138,9 +169,11 @@ extern void PioInterruptHandler( uint32_t id, Pio *pPio )
  * \brief Parallel IO Controller A interrupt handler
  * \Redefined PIOA interrupt handler for NVIC interrupt table.
  */
-extern void PIOA_IrqHandler( void )
+IRQ_RAMFUNC extern void PIOA_IrqHandler( void )
 {
-    if ( PIOA->PIO_PCISR != 0 )
+    /* Capture interrupts enabled: the status register is only read by
+       the capture handler, reading it clears the overrun flag */
+    if ( PIOA->PIO_PCIMR != 0 )
     {
         PIO_CaptureHandler() ;
     }
@@ -152,7 +185,7 @@ extern void PIOA_IrqHandler( void )
  * \brief Parallel IO Controller B interrupt handler
  * \Redefined PIOB interrupt handler for NVIC interrupt table.
  */
-extern void PIOB_IrqHandler( void )
+IRQ_RAMFUNC extern void PIOB_IrqHandler( void )
 {
     PioInterruptHandler( ID_PIOB, PIOB ) ;
 }
@@ -161,7 +194,7 @@ extern void PIOB_IrqHandler( void )
  * \brief Parallel IO Controller C interrupt handler
  * \Redefined PIOC interrupt handler for NVIC interrupt table.
  */
-extern void PIOC_IrqHandler( void )
+IRQ_RAMFUNC extern void PIOC_IrqHandler( void )
 {
     PioInterruptHandler( ID_PIOC, PIOC ) ;
 }
@@ -181,6 +214,7 @@ extern void PIO_InitializeInterrupts( uint32_t dwPriority )
 
     /* Reset sources */
     _dwNumSources = 0 ;
+    memset( _aucPinSources, 0, sizeof( _aucPinSources ) ) ;
 
     /* Configure PIO interrupt sources */
     TRACE_DEBUG( "PIO_Initialize: Configuring PIOA\n\r" ) ;
@@ -212,32 +246,41 @@ extern void PIO_InitializeInterrupts( uint32_t dwPriority )
 }
 
 /**
- * Configures a PIO or a group of PIO to generate an interrupt on status
- * change. The provided interrupt handler will be called with the triggering
- * pin as its parameter (enabling different pin instances to share the same
- * handler).
+ * Defines a new interrupt source and configures the additional interrupt
+ * modes of its pins. Each pin belongs to the last source defined on it.
  * \param pPin  Pointer to a Pin instance.
- * \param handler  Interrupt handler function pointer.
+ * \return Pointer to the new source.
  */
-extern void PIO_ConfigureIt( const Pin *pPin, void (*handler)( const Pin* ) )
+static InterruptSource* _PIO_AddSource( const Pin *pPin )
 {
     Pio* pio ;
     InterruptSource* pSource ;
-
-    TRACE_DEBUG( "PIO_ConfigureIt()\n\r" ) ;
+    uint8_t* pucSources ;
+    uint32_t dwBit ;
 
     assert( pPin ) ;
     pio = pPin->pio ;
     assert( _dwNumSources < MAX_INTERRUPT_SOURCES ) ;
+    assert( (pPin->id >= ID_PIOA) && (pPin->id <= ID_PIOC) ) ;
 
     /* Define new source */
     TRACE_DEBUG( "PIO_ConfigureIt: Defining new source #%d.\n\r",  _dwNumSources ) ;
 
     pSource = &(_aIntSources[_dwNumSources]) ;
     pSource->pPin = pPin ;
-    pSource->handler = handler ;
+    pSource->handler = NULL ;
+    pSource->handlerMask = NULL ;
     _dwNumSources++ ;
 
+    pucSources = _aucPinSources[pPin->id - ID_PIOA] ;
+    for ( dwBit = 0 ; dwBit < 32 ; dwBit++ )
+    {
+        if ( pPin->mask & (1u << dwBit) )
+        {
+            pucSources[dwBit] = _dwNumSources ;
+        }
+    }
+
     /* PIO3 with additional interrupt support
      * Configure additional interrupt mode registers */
     if ( pPin->attribute & PIO_IT_AIME )
@@ -266,6 +309,40 @@ extern void PIO_ConfigureIt( const Pin *pPin, void (*handler)( const Pin* ) )
         /* disable additional interrupt mode */
         pio->PIO_AIMDR       = pPin->mask;
     }
+
+    return pSource ;
+}
+
+/**
+ * Configures a PIO or a group of PIO to generate an interrupt on status
+ * change. The provided interrupt handler will be called with the triggering
+ * pin as its parameter (enabling different pin instances to share the same
+ * handler).
+ * \param pPin  Pointer to a Pin instance.
+ * \param handler  Interrupt handler function pointer.
+ */
+extern void PIO_ConfigureIt( const Pin *pPin, void (*handler)( const Pin* ) )
+{
+    TRACE_DEBUG( "PIO_ConfigureIt()\n\r" ) ;
+
+    _PIO_AddSource( pPin )->handler = handler ;
+}
+
+/**
+ * Configures a group of PIO to generate an interrupt on status change, the
+ * pending pins being coalesced: the handler is called once per interrupt
+ * with the pin instance and the mask of its pins whose status changed
+ * (e.g. all the rows of a keypad, the two phases of an encoder).
+ * \param pPin  Pointer to a Pin instance.
+ * \param handler  Interrupt handler function pointer.
+ */
+extern void PIO_ConfigureItMask( const Pin *pPin, void (*handler)( const Pin*, uint32_t ) )
+{
+    TRACE_DEBUG( "PIO_ConfigureItMask()\n\r" ) ;
+
+    assert( handler != NULL ) ;
+
+    _PIO_AddSource( pPin )->handlerMask = handler ;
 }
 
 /**
@@ -42,6 +42,19 @@
 #define MASK_STATUS0 0xFFFFFFFC
 #define MASK_STATUS1 0xFFFFFFFF
 
+/** Number of peripheral IDs with a peripheral clock */
+#define PMC_PERIPH_COUNT 35
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Users of each peripheral clock, see PMC_AcquirePeripheral() */
+static uint8_t _aucPeriphRefs[PMC_PERIPH_COUNT] ;
+
+/** Clocks found enabled by their first user, left enabled by their last one */
+static uint32_t _adwPeriphKept[2] ;
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -165,3 +178,133 @@ extern uint32_t PMC_IsPeriphEnabled( uint32_t dwId )
         return ( PMC->PMC_PCSR1 & (1 << (dwId - 32)) ) ;
     }
 }
+
+/**
+ * \brief Takes a reference on the clock of a peripheral, enabling it for the
+ * first user. The drivers take it when a transfer starts and release it with
+ * PMC_ReleasePeripheral() when the transfer completes, so the clock of an
+ * idle peripheral is gated. May be called from an interrupt.
+ *
+ * A clock already enabled by PMC_EnablePeripheral() when its first reference
+ * is taken is left enabled when the last one is released.
+ *
+ * \param dwId  Peripheral ID (ID_xxx).
+ */
+extern void PMC_AcquirePeripheral( uint32_t dwId )
+{
+    uint32_t dwPrimask = __get_PRIMASK() ;
+
+    assert( dwId < PMC_PERIPH_COUNT ) ;
+
+    __disable_irq() ;
+    if ( _aucPeriphRefs[dwId]++ == 0 )
+    {
+        if ( PMC_IsPeriphEnabled( dwId ) )
+        {
+            _adwPeriphKept[dwId >> 5] |= (uint32_t)1 << (dwId & 0x1F) ;
+        }
+        else
+        {
+            _adwPeriphKept[dwId >> 5] &= ~((uint32_t)1 << (dwId & 0x1F)) ;
+            PMC_EnablePeripheral( dwId ) ;
+        }
+    }
+    assert( _aucPeriphRefs[dwId] != 0 ) ;
+    __set_PRIMASK( dwPrimask ) ;
+}
+
+/**
+ * \brief Releases a reference taken by PMC_AcquirePeripheral(), disabling the
+ * clock when the last user releases it. May be called from an interrupt.
+ *
+ * \param dwId  Peripheral ID (ID_xxx).
+ */
+extern void PMC_ReleasePeripheral( uint32_t dwId )
+{
+    uint32_t dwPrimask = __get_PRIMASK() ;
+
+    assert( dwId < PMC_PERIPH_COUNT ) ;
+
+    __disable_irq() ;
+    assert( _aucPeriphRefs[dwId] != 0 ) ;
+    if ( (_aucPeriphRefs[dwId] != 0) && (--_aucPeriphRefs[dwId] == 0) )
+    {
+        if ( (_adwPeriphKept[dwId >> 5] & ((uint32_t)1 << (dwId & 0x1F))) == 0 )
+        {
+            PMC_DisablePeripheral( dwId ) ;
+        }
+    }
+    __set_PRIMASK( dwPrimask ) ;
+}
+
+/**
+ * \brief Saves the working clock and runs the master clock from the slow
+ * clock, the PLLs and the main oscillators being stopped.
+ *
+ * Nothing clocked by the PLLs or the main clock (USB, ...) must be running,
+ * and the peripherals clocked by MCK run at the slow clock rate.
+ * \param pSave  Filled with the working clock, for PMC_RestoreMck().
+ */
+extern void PMC_SwitchMckToSlowClock( PmcClockConfig* pSave )
+{
+    pSave->dwMor = PMC->CKGR_MOR ;
+    pSave->dwPllar = PMC->CKGR_PLLAR ;
+    pSave->dwPllbr = PMC->CKGR_PLLBR ;
+    pSave->dwMckr = PMC->PMC_MCKR ;
+
+    /* Clock source first, then the prescaler */
+    PMC->PMC_MCKR = (PMC->PMC_MCKR & (uint32_t)~PMC_MCKR_CSS_Msk) | PMC_MCKR_CSS_SLOW_CLK ;
+    while ( !(PMC->PMC_SR & PMC_SR_MCKRDY) ) ;
+    PMC->PMC_MCKR = (PMC->PMC_MCKR & (uint32_t)~PMC_MCKR_PRES_Msk) | PMC_MCKR_PRES_CLK ;
+    while ( !(PMC->PMC_SR & PMC_SR_MCKRDY) ) ;
+
+    /* Stop the PLLs, then the crystal and the fast RC oscillator */
+    PMC->CKGR_PLLAR = CKGR_PLLAR_STUCKTO1 ;
+    PMC->CKGR_PLLBR = 0 ;
+    PMC->CKGR_MOR = CKGR_MOR_KEY(0x37) | (pSave->dwMor & CKGR_MOR_MOSCXTST_Msk) ;
+}
+
+/**
+ * \brief Restores the working clock saved by PMC_SwitchMckToSlowClock(),
+ * waiting for the crystal and the PLLs to be stable.
+ * \param pSaved  Working clock to restore.
+ */
+extern void PMC_RestoreMck( const PmcClockConfig* pSaved )
+{
+    uint32_t dwMor = (pSaved->dwMor & (uint32_t)~(CKGR_MOR_KEY_Msk | CKGR_MOR_MOSCSEL)) | CKGR_MOR_KEY(0x37) ;
+
+    /* Restart the main oscillators, the fast RC one for the switch */
+    PMC->CKGR_MOR = dwMor | CKGR_MOR_MOSCRCEN ;
+    while ( !(PMC->PMC_SR & PMC_SR_MOSCRCS) ) ;
+    if ( dwMor & CKGR_MOR_MOSCXTEN )
+    {
+        while ( !(PMC->PMC_SR & PMC_SR_MOSCXTS) ) ;
+    }
+    if ( pSaved->dwMor & CKGR_MOR_MOSCSEL )
+    {
+        PMC->CKGR_MOR = dwMor | CKGR_MOR_MOSCRCEN | CKGR_MOR_MOSCSEL ;
+        while ( !(PMC->PMC_SR & PMC_SR_MOSCSELS) ) ;
+    }
+
+    /* Restart the PLLs */
+    if ( (pSaved->dwPllar & CKGR_PLLAR_MULA_Msk) != 0 )
+    {
+        PMC->CKGR_PLLAR = pSaved->dwPllar | CKGR_PLLAR_STUCKTO1 ;
+        while ( !(PMC->PMC_SR & PMC_SR_LOCKA) ) ;
+    }
+
+    if ( (pSaved->dwPllbr & CKGR_PLLBR_MULB_Msk) != 0 )
+    {
+        PMC->CKGR_PLLBR = pSaved->dwPllbr ;
+        while ( !(PMC->PMC_SR & PMC_SR_LOCKB) ) ;
+    }
+
+    /* Prescaler first, then the clock source */
+    PMC->PMC_MCKR = (PMC->PMC_MCKR & (uint32_t)~PMC_MCKR_PRES_Msk) | (pSaved->dwMckr & PMC_MCKR_PRES_Msk) ;
+    while ( !(PMC->PMC_SR & PMC_SR_MCKRDY) ) ;
+    PMC->PMC_MCKR = pSaved->dwMckr ;
+    while ( !(PMC->PMC_SR & PMC_SR_MCKRDY) ) ;
+
+    /* Fast RC oscillator stopped again if it was */
+    PMC->CKGR_MOR = (pSaved->dwMor & (uint32_t)~CKGR_MOR_KEY_Msk) | CKGR_MOR_KEY(0x37) ;
+}
@@ -0,0 +1,251 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Implementation of the hot path profiler.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "chip.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+#if (PROF_ENABLE == 1)
+/** Probe names, indexed by PROF_ID_xxx. */
+static const char* const _apszProbeNames[PROF_NUM_PROBES] =
+{
+    "USBD_IrqHandler",
+    "UDP_EndpointHandler",
+    "SPID_Handler",
+    "MED_Read",
+    "MED_Write",
+    "disk_read",
+    "disk_write",
+    "EccNand_ReadPage",
+    "LCD_DrawPicture",
+    "user0",
+    "user1",
+    "user2",
+    "user3"
+} ;
+#endif
+
+/** Statistics of the probes. */
+static ProfStats _aStats[PROF_NUM_PROBES] ;
+/** Cycle counter at the entry of each probe. */
+static uint32_t _adwStart[PROF_NUM_PROBES] ;
+/** Nesting level of each probe. */
+static uint8_t _aucDepth[PROF_NUM_PROBES] ;
+/** Are the probes measuring. */
+static volatile uint8_t _ucRunning = 0 ;
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Starts the DWT cycle counter, clears the statistics and starts
+ * measuring.
+ */
+void PROF_Start( void )
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk ;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA ;
+    PROF_Reset() ;
+    _ucRunning = 1 ;
+}
+
+/**
+ * \brief Stops measuring; the statistics are kept.
+ */
+void PROF_Stop( void )
+{
+    _ucRunning = 0 ;
+}
+
+/**
+ * \brief Clears the statistics of all the probes.
+ */
+void PROF_Reset( void )
+{
+    uint32_t primask = __get_PRIMASK() ;
+    uint32_t i ;
+
+    __disable_irq() ;
+    memset( _aStats, 0, sizeof( _aStats ) ) ;
+    for ( i=0 ; i < PROF_NUM_PROBES ; i++ )
+    {
+        _aStats[i].dwMinCycles = 0xFFFFFFFF ;
+    }
+    memset( _aucDepth, 0, sizeof( _aucDepth ) ) ;
+    __set_PRIMASK( primask ) ;
+}
+
+/**
+ * \brief Starts a measure; called by PROF_Enter().
+ * \param dwId  Probe identifier, PROF_ID_xxx.
+ */
+void PROF_EnterProbe( uint32_t dwId )
+{
+    uint32_t primask ;
+
+    if ( !_ucRunning || (dwId >= PROF_NUM_PROBES) )
+    {
+        return ;
+    }
+
+    primask = __get_PRIMASK() ;
+    __disable_irq() ;
+    if ( _aucDepth[dwId]++ == 0 )
+    {
+        _adwStart[dwId] = DWT_CYCCNT ;
+    }
+    __set_PRIMASK( primask ) ;
+}
+
+/**
+ * \brief Ends a measure and updates the statistics; called by PROF_Exit().
+ * \param dwId  Probe identifier, PROF_ID_xxx.
+ */
+void PROF_ExitProbe( uint32_t dwId )
+{
+    uint32_t dwCycles = DWT_CYCCNT ;
+    uint32_t dwBucket ;
+    uint32_t dw ;
+    uint32_t primask ;
+    ProfStats* pStats ;
+
+    if ( dwId >= PROF_NUM_PROBES )
+    {
+        return ;
+    }
+
+    primask = __get_PRIMASK() ;
+    __disable_irq() ;
+    /* Ignore the exits of the probes entered before PROF_Start() */
+    if ( (_aucDepth[dwId] == 0) || (--_aucDepth[dwId] != 0) || !_ucRunning )
+    {
+        __set_PRIMASK( primask ) ;
+        return ;
+    }
+
+    dwCycles -= _adwStart[dwId] ;
+    pStats = &_aStats[dwId] ;
+    pStats->dwCount++ ;
+    pStats->qwTotalCycles += dwCycles ;
+    if ( dwCycles < pStats->dwMinCycles )
+    {
+        pStats->dwMinCycles = dwCycles ;
+    }
+    if ( dwCycles > pStats->dwMaxCycles )
+    {
+        pStats->dwMaxCycles = dwCycles ;
+    }
+
+    /* Bucket of the highest bit set above PROF_BUCKET_SHIFT */
+    for ( dwBucket=0, dw=dwCycles >> (PROF_BUCKET_SHIFT+1) ; (dw != 0) && (dwBucket < PROF_NUM_BUCKETS-1) ; dw >>= 1 )
+    {
+        dwBucket++ ;
+    }
+    pStats->adwBuckets[dwBucket]++ ;
+    __set_PRIMASK( primask ) ;
+}
+
+/**
+ * \brief Gets the statistics of a probe.
+ * \param dwId  Probe identifier, PROF_ID_xxx.
+ * \param pStats  Filled with the statistics since the last reset.
+ */
+void PROF_GetStats( uint32_t dwId, ProfStats* pStats )
+{
+    uint32_t primask ;
+
+    if ( dwId >= PROF_NUM_PROBES )
+    {
+        memset( pStats, 0, sizeof( ProfStats ) ) ;
+        return ;
+    }
+
+    primask = __get_PRIMASK() ;
+    __disable_irq() ;
+    *pStats = _aStats[dwId] ;
+    __set_PRIMASK( primask ) ;
+}
+
+#if (PROF_ENABLE == 1)
+/**
+ * \brief Prints the statistics of the probes which have measures, in
+ * cycles and microseconds, followed by their histograms.
+ * \param dwMck  Core clock frequency in Hz.
+ */
+void PROF_Dump( uint32_t dwMck )
+{
+    ProfStats stats ;
+    uint32_t dwAvg ;
+    uint32_t dwMhz = (dwMck + 500000) / 1000000 ;
+    uint32_t i ;
+    uint32_t j ;
+
+    if ( dwMhz == 0 )
+    {
+        dwMhz = 1 ;
+    }
+
+    printf( "%-20s %8s %8s %8s %8s %8s\n\r", "probe", "count", "min", "avg", "max", "max(us)" ) ;
+    for ( i=0 ; i < PROF_NUM_PROBES ; i++ )
+    {
+        PROF_GetStats( i, &stats ) ;
+        if ( stats.dwCount == 0 )
+        {
+            continue ;
+        }
+
+        dwAvg = (uint32_t)(stats.qwTotalCycles / stats.dwCount) ;
+        printf( "%-20s %8u %8u %8u %8u %8u\n\r", _apszProbeNames[i], (unsigned int)stats.dwCount,
+                (unsigned int)stats.dwMinCycles, (unsigned int)dwAvg, (unsigned int)stats.dwMaxCycles,
+                (unsigned int)(stats.dwMaxCycles / dwMhz) ) ;
+
+        printf( "  <%u:", 1u << (PROF_BUCKET_SHIFT+1) ) ;
+        for ( j=0 ; j < PROF_NUM_BUCKETS ; j++ )
+        {
+            printf( " %u", (unsigned int)stats.adwBuckets[j] ) ;
+        }
+        printf( " :>=%u\n\r", 1u << (PROF_BUCKET_SHIFT+PROF_NUM_BUCKETS-1) ) ;
+    }
+}
+#endif
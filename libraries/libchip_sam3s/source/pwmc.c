@@ -606,3 +606,175 @@ void PWMC_ConfigureEventLineMode( Pwm* pPwm, uint32_t x, uint32_t mode)
         pPwm->PWM_ELxMR[1] = mode;
     }
 }
+
+/*----------------------------------------------------------------------------
+ *        Synchronous channels waveform engine
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initializes a waveform engine playing duty cycle tables on the
+ * synchronous channels through the PDC. The channels must be configured
+ * (\ref PWMC_ConfigureChannel(), \ref PWMC_SetPeriod()) and still disabled.
+ *
+ * A table holds dwSteps steps, each step being one duty cycle per
+ * synchronous channel in ascending channel order. A step is applied every
+ * updatePeriod + 1 periods of channel 0.
+ *
+ * \param pWave         Waveform engine.
+ * \param pPwm          PWM instance.
+ * \param channels      Bitwise OR of PWM_SCM_SYNCx, channel 0 included.
+ * \param pTable0       First duty cycle table, played first.
+ * \param pTable1       Second table for double buffering, or NULL.
+ * \param dwSteps       Number of steps of a table.
+ * \param updatePeriod  Update period, see \ref PWMC_SetSyncChannelUpdatePeriod().
+ */
+void PWMC_WaveInitialize( PwmcWave* pWave, Pwm* pPwm, uint32_t channels,
+    uint16_t* pTable0, uint16_t* pTable1, uint32_t dwSteps, uint8_t updatePeriod)
+{
+    uint32_t i;
+
+    assert((channels & PWM_SCM_SYNC0) != 0);
+    assert(pTable0 != NULL);
+
+    pWave->pPwm = pPwm;
+    pWave->apTables[0] = pTable0;
+    pWave->apTables[1] = pTable1;
+    pWave->bChannels = 0;
+    for (i = 0; i < 4; i++) {
+        if (channels & (PWM_SCM_SYNC0 << i)) {
+            pWave->bChannels++;
+        }
+    }
+    pWave->dwLength = dwSteps * pWave->bChannels;
+    assert(pWave->dwLength <= 0xFFFF);
+    pWave->bActive = 0;
+    pWave->bQueued = 0;
+    pWave->bNext = 0;
+    pWave->dwCycles = 0;
+    pWave->dwUnderruns = 0;
+
+    /* PDC requests on Write Ready, i.e. when the update period elapses */
+    PWMC_ConfigureSyncChannel(pPwm, channels, PWM_SCM_UPDM_MODE2, 0, 0);
+    PWMC_SetSyncChannelUpdatePeriod(pPwm, PWM_SCUP_UPR(updatePeriod));
+}
+
+/**
+ * \brief Starts the waveform: the first table is loaded in both PDC banks,
+ * then the synchronous channels are enabled together through channel 0.
+ * The PWM interrupt must be enabled in the NVIC, its handler calling
+ * \ref PWMC_WaveHandler().
+ *
+ * \param pWave  Waveform engine.
+ */
+void PWMC_WaveStart( PwmcWave* pWave )
+{
+    Pwm* pPwm = pWave->pPwm;
+    uint16_t* pTable = pWave->apTables[pWave->bNext];
+
+    pWave->bActive = pWave->bNext;
+    pWave->bQueued = pWave->bNext;
+
+    pPwm->PWM_TPR = (uint32_t)pTable;
+    pPwm->PWM_TCR = pWave->dwLength;
+    pPwm->PWM_TNPR = (uint32_t)pTable;
+    pPwm->PWM_TNCR = pWave->dwLength;
+    pPwm->PWM_PTCR = PERIPH_PTCR_TXTEN;
+
+    PWMC_EnableIt(pPwm, 0, PWM_IER2_ENDTX | PWM_IER2_UNRE);
+    PWMC_EnableChannel(pPwm, 0);
+}
+
+/**
+ * \brief Stops the waveform. The outputs keep the last duty cycles until
+ * the channels are disabled.
+ *
+ * \param pWave  Waveform engine.
+ */
+void PWMC_WaveStop( PwmcWave* pWave )
+{
+    Pwm* pPwm = pWave->pPwm;
+
+    PWMC_DisableIt(pPwm, 0, PWM_IDR2_ENDTX | PWM_IDR2_UNRE);
+    pPwm->PWM_PTCR = PERIPH_PTCR_TXTDIS;
+    pPwm->PWM_TCR = 0;
+    pPwm->PWM_TNCR = 0;
+}
+
+/**
+ * \brief Returns the table the application may rewrite, the one neither
+ * played nor queued to the PDC, or NULL if there is none (single table, or
+ * a submitted table not played yet).
+ *
+ * \param pWave  Waveform engine.
+ */
+uint16_t* PWMC_WaveGetFreeTable( PwmcWave* pWave )
+{
+    uint8_t bFree = pWave->bActive ^ 1;
+
+    if ((pWave->apTables[1] == NULL) || (pWave->bQueued == bFree)
+        || (pWave->bNext == bFree)) {
+        return NULL;
+    }
+
+    return pWave->apTables[bFree];
+}
+
+/**
+ * \brief Plays the table returned by \ref PWMC_WaveGetFreeTable() once the
+ * current table ends; it then loops until the next submission. The switch
+ * happens on a table boundary, at most two table lengths later.
+ *
+ * \param pWave  Waveform engine.
+ */
+void PWMC_WaveSubmit( PwmcWave* pWave )
+{
+    assert(pWave->apTables[1] != NULL);
+
+    pWave->bNext = pWave->bActive ^ 1;
+}
+
+/**
+ * \brief Waveform interrupt handler, to be called from the PWM interrupt
+ * handler. On End of TX Buffer the queued table becomes the played one and
+ * the next table is queued in the free PDC bank, so the duty cycles are
+ * updated without the CPU for a whole table.
+ *
+ * \param pWave  Waveform engine.
+ * \param isr2   PWM_ISR2 value, read once by the caller.
+ */
+void PWMC_WaveHandler( PwmcWave* pWave, uint32_t isr2 )
+{
+    Pwm* pPwm = pWave->pPwm;
+
+    if (isr2 & PWM_ISR2_ENDTX) {
+        pWave->bActive = pWave->bQueued;
+        pWave->bQueued = pWave->bNext;
+        pPwm->PWM_TNPR = (uint32_t)pWave->apTables[pWave->bQueued];
+        pPwm->PWM_TNCR = pWave->dwLength;
+        pWave->dwCycles++;
+    }
+
+    /* Update period elapsed before the PDC could write the duty cycles */
+    if (isr2 & PWM_ISR2_UNRE) {
+        pWave->dwUnderruns++;
+    }
+}
+
+/**
+ * \brief Uses a comparison unit to start conversions of the ADC through a
+ * PWM event line, e.g. at the center of center aligned channels where the
+ * phase currents are stable. Select the line with ADC_MR_TRGSEL_ADC_TRIG4
+ * (event line 0) or ADC_MR_TRGSEL_ADC_TRIG5 (event line 1) in the ADC.
+ *
+ * \param pPwm   PWM instance.
+ * \param x      Comparison unit index.
+ * \param line   Event line, 0 or 1.
+ * \param value  Channel 0 counter value of the trigger, as PWM_CMPxV: with
+ *               center aligned channels, the period value is the center, and
+ *               PWM_CMPxV_CVM selects the decrementing half.
+ */
+void PWMC_WaveConfigureAdcTrigger( Pwm* pPwm, uint32_t x, uint32_t line, uint32_t value)
+{
+    PWMC_ConfigureComparisonUnit(pPwm, x, value, PWM_CMPxM_CEN);
+    PWMC_ConfigureEventLineMode(pPwm, line, pPwm->PWM_ELxMR[line] | (PWM_EL0MR_CSEL0 << x));
+}
@@ -41,7 +41,21 @@
  *    transfers delay and Baud Rate) for the device corresponding to the
  *    chip select using SPID_ConfigureCS().</li>
  * <li> Starts a SPI master transfer using SPID_SendCommand().
- *    The transfer is performed using the PDC channels. </li>
+ *    The transfer is performed using the PDC channels: the command, address
+ *    and dummy bytes are programmed in the current buffer and the data in the
+ *    next buffer, so the PDC goes from one to the other without the CPU.</li>
+ * <li> Several devices sharing the SPI can queue their transfers using
+ *    SPID_QueueCommand() instead: the commands are executed in order, each
+ *    one with its own chip select, the next one being started from
+ *    SPID_Handler() before the callback of the previous one is invoked.
+ *    A queued SpidCmd must not be modified until its callback is invoked.</li>
+ * <li> A USART in SPI master mode can be used as a second SPI bus with the same
+ *    interface: initialize it with SPID_ConfigureUsart() instead of
+ *    SPID_Configure(). SPID_ConfigureCS() takes the same SPI_CSR value, the
+ *    clock polarity, phase and SCBR being converted to US_MR and US_BRGR
+ *    (the DLYBS and DLYBCT delays are not supported). Chip select 0 is the
+ *    USART RTS line; other chip selects need a GPIO pin, set with
+ *    SPID_ConfigureUsartCS(). The USART interrupt handler calls SPID_Handler().</li>
  *    <li> It enable the SPI clock.</li>
  *    <li> Set the corresponding peripheral chip select.</li>
  *    <li> Initialize the two SPI PDC buffers.</li>
@@ -92,6 +106,172 @@
  *----------------------------------------------------------------------------*/
 #include "chip.h"
 
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Drives the chip select of a USART bus.
+ *
+ * \param pUsart  Pointer to a SpidUsart instance.
+ * \param dwCS  Chip select number.
+ * \param bSelect  1 to select the device, 0 to release it.
+ */
+static void _UsartSelect( SpidUsart* pUsart, uint32_t dwCS, uint32_t bSelect )
+{
+    const Pin* pPin = pUsart->apCsPins[dwCS] ;
+
+    if ( pPin )
+    {
+        if ( bSelect )
+        {
+            PIO_Clear( pPin ) ;
+        }
+        else
+        {
+            PIO_Set( pPin ) ;
+        }
+    }
+    else
+    {
+        pUsart->pUsartHw->US_CR = bSelect ? US_CR_FCS : US_CR_RCS ;
+    }
+}
+
+/**
+ * \brief Programs the mode and chip select of a USART bus and its PDC
+ * channels for a command, and starts the transfer.
+ *
+ * \param pUsart  Pointer to a SpidUsart instance.
+ * \param pCommand Pointer to the SPI command to execute.
+ */
+static void _StartUsartCommand( SpidUsart* pUsart, SpidCmd* pCommand )
+{
+    Usart* pUsartHw = pUsart->pUsartHw ;
+    uint32_t dwCS = pCommand->spiCs & (SPID_USART_NUM_CS - 1) ;
+
+    /* Disable transmitter and receiver*/
+    pUsartHw->US_PTCR = US_PTCR_RXTDIS | US_PTCR_TXTDIS ;
+
+    /* Devices on the bus may use different modes and clocks */
+    if ( pUsartHw->US_MR != pUsart->adwMr[dwCS] )
+    {
+        pUsartHw->US_CR = US_CR_RXDIS | US_CR_TXDIS ;
+        pUsartHw->US_MR = pUsart->adwMr[dwCS] ;
+        pUsartHw->US_CR = US_CR_RXEN | US_CR_TXEN ;
+    }
+    pUsartHw->US_BRGR = pUsart->adwBrgr[dwCS] ;
+
+    _UsartSelect( pUsart, dwCS, 1 ) ;
+
+    /* Initialize the two PDC buffer*/
+    pUsartHw->US_RPR = (uint32_t)pCommand->pCmd ;
+    pUsartHw->US_RCR = pCommand->cmdSize ;
+    pUsartHw->US_RNPR = (uint32_t)pCommand->pData ;
+    pUsartHw->US_RNCR = pCommand->dataSize ;
+    pUsartHw->US_TPR = (uint32_t)pCommand->pCmd ;
+    pUsartHw->US_TCR = pCommand->cmdSize ;
+    pUsartHw->US_TNPR = (uint32_t)pCommand->pData ;
+    pUsartHw->US_TNCR = pCommand->dataSize ;
+
+    /* Enable transmitter and receiver*/
+    pUsartHw->US_PTCR = US_PTCR_RXTEN | US_PTCR_TXTEN ;
+}
+
+/**
+ * \brief Programs the chip select and the PDC channels for a command, and
+ * starts the transfer.
+ *
+ * \param pSpid  Pointer to a Spid instance.
+ * \param pCommand Pointer to the SPI command to execute.
+ */
+static void _StartCommand( Spid* pSpid, SpidCmd* pCommand )
+{
+    Spi* pSpiHw = pSpid->pSpiHw ;
+    uint32_t dwSpiMr ;
+
+    if ( pSpid->pUsart )
+    {
+        _StartUsartCommand( pSpid->pUsart, pCommand ) ;
+
+        return ;
+    }
+
+    /* Disable transmitter and receiver*/
+    SPI_PdcDisableRx( pSpiHw ) ;
+    SPI_PdcDisableTx( pSpiHw ) ;
+
+    /* Write to the MR register*/
+    dwSpiMr = pSpiHw->SPI_MR ;
+    dwSpiMr |= SPI_MR_PCS_Msk ;
+    dwSpiMr &= ~((1 << pCommand->spiCs) << 16 ) ;
+    pSpiHw->SPI_MR=dwSpiMr ;
+
+    /* Initialize the two SPI PDC buffer*/
+    SPI_PdcSetRx( pSpiHw, pCommand->pCmd, pCommand->cmdSize, pCommand->pData, pCommand->dataSize ) ;
+    SPI_PdcSetTx( pSpiHw, pCommand->pCmd, pCommand->cmdSize, pCommand->pData, pCommand->dataSize ) ;
+
+    /* Enable transmitter and receiver*/
+    SPI_PdcEnableRx( pSpiHw ) ;
+    SPI_PdcEnableTx( pSpiHw ) ;
+}
+
+/**
+ * \brief Appends a command to the queue, and starts it if the driver is idle.
+ *
+ * \param pSpid  Pointer to a Spid instance.
+ * \param pCommand Pointer to the SPI command to execute.
+ * \param bOnlyIfIdle Do not queue the command if the driver is busy.
+ * \return 0 if the command has been queued; otherwise returns SPID_ERROR_LOCK.
+ */
+static uint32_t _QueueCommand( Spid* pSpid, SpidCmd* pCommand, uint32_t bOnlyIfIdle )
+{
+    uint32_t dwPrimask ;
+
+    pCommand->pNext = 0 ;
+
+    /* The queue is shared with SPID_Handler() */
+    dwPrimask = __get_PRIMASK() ;
+    __disable_irq() ;
+
+    if ( pSpid->pCurrentCommand == 0 )
+    {
+        /* Queue empty, start the command */
+        pSpid->semaphore-- ;
+        pSpid->pCurrentCommand = pCommand ;
+        pSpid->pLastCommand = pCommand ;
+
+        /* Clock the SPI until the queue is empty */
+        PMC_AcquirePeripheral( pSpid->spiId ) ;
+        _StartCommand( pSpid, pCommand ) ;
+
+        /* Enable buffer complete interrupt*/
+        if ( pSpid->pUsart )
+        {
+            pSpid->pUsart->pUsartHw->US_IER = US_IER_RXBUFF ;
+        }
+        else
+        {
+            SPI_EnableIt( pSpid->pSpiHw, SPI_IER_RXBUFF ) ;
+        }
+    }
+    else
+    {
+        if ( bOnlyIfIdle )
+        {
+            __set_PRIMASK( dwPrimask ) ;
+
+            return SPID_ERROR_LOCK ;
+        }
+        pSpid->pLastCommand->pNext = pCommand ;
+        pSpid->pLastCommand = pCommand ;
+    }
+
+    __set_PRIMASK( dwPrimask ) ;
+
+    return 0 ;
+}
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -111,9 +291,11 @@ extern uint32_t SPID_Configure( Spid* pSpid, Spi* pSpiHw, uint8_t spiId )
     pSpid->spiId  = spiId ;
     pSpid->semaphore = 1 ;
     pSpid->pCurrentCommand = 0 ;
+    pSpid->pLastCommand = 0 ;
+    pSpid->pUsart = 0 ;
 
     /* Enable the SPI clock*/
-    PMC_EnablePeripheral( pSpid->spiId ) ;
+    PMC_AcquirePeripheral( pSpid->spiId ) ;
 
     /* Configure SPI in Master Mode with No CS selected !!! */
     SPI_Configure( pSpiHw, pSpid->spiId, SPI_MR_MSTR | SPI_MR_MODFDIS | SPI_MR_PCS_Msk ) ;
@@ -122,7 +304,59 @@ extern uint32_t SPID_Configure( Spid* pSpid, Spi* pSpiHw, uint8_t spiId )
     SPI_Enable( pSpiHw ) ;
 
     /* Disable the SPI clock */
-    PMC_DisablePeripheral( pSpid->spiId ) ;
+    PMC_ReleasePeripheral( pSpid->spiId ) ;
+
+    return 0 ;
+}
+
+/**
+ * \brief Initializes the Spid structure for a USART used in SPI master mode,
+ * and the corresponding USART hardware.
+ *
+ * All chip selects are initialized to mode 0 at the slowest clock, on the
+ * NSS (RTS) line; use SPID_ConfigureCS() and SPID_ConfigureUsartCS() to set
+ * them up.
+ *
+ * \param pSpid  Pointer to a Spid instance.
+ * \param pUsart  USART bus state, must remain valid while the Spid is used.
+ * \param pUsartHw Associated USART peripheral.
+ * \param usartId USART peripheral identifier.
+ * \return 0.
+ */
+extern uint32_t SPID_ConfigureUsart( Spid* pSpid, SpidUsart* pUsart, Usart* pUsartHw, uint8_t usartId )
+{
+    uint32_t dwCS ;
+
+    /* Initialize the SPI structure*/
+    pSpid->pSpiHw = 0 ;
+    pSpid->spiId  = usartId ;
+    pSpid->semaphore = 1 ;
+    pSpid->pCurrentCommand = 0 ;
+    pSpid->pLastCommand = 0 ;
+    pSpid->pUsart = pUsart ;
+
+    pUsart->pUsartHw = pUsartHw ;
+    for ( dwCS = 0 ; dwCS < SPID_USART_NUM_CS ; dwCS++ )
+    {
+        pUsart->adwMr[dwCS] = US_MR_USART_MODE_SPI_MASTER | US_MR_USCLKS_MCK | US_MR_CHRL_8_BIT
+                            | US_MR_CHMODE_NORMAL | US_MR_CLKO | US_MR_CPHA ;
+        pUsart->adwBrgr[dwCS] = 0xFFFF ;
+        pUsart->apCsPins[dwCS] = 0 ;
+    }
+
+    /* Enable the USART clock*/
+    PMC_AcquirePeripheral( usartId ) ;
+
+    /* Reset and configure in SPI Master Mode with No CS selected */
+    pUsartHw->US_IDR = 0xFFFFFFFF ;
+    pUsartHw->US_PTCR = US_PTCR_RXTDIS | US_PTCR_TXTDIS ;
+    pUsartHw->US_CR = US_CR_RSTRX | US_CR_RSTTX | US_CR_RXDIS | US_CR_TXDIS | US_CR_RCS ;
+    pUsartHw->US_MR = pUsart->adwMr[0] ;
+    pUsartHw->US_BRGR = pUsart->adwBrgr[0] ;
+    pUsartHw->US_CR = US_CR_RXEN | US_CR_TXEN ;
+
+    /* Disable the USART clock */
+    PMC_ReleasePeripheral( usartId ) ;
 
     return 0 ;
 }
@@ -130,13 +364,75 @@ extern uint32_t SPID_Configure( Spid* pSpid, Spi* pSpiHw, uint8_t spiId )
 /**
  * \brief Configures the parameters for the device corresponding to the cs.
  *
+ * On a USART bus, the clock polarity, phase and SCBR of the SPI_CSR value are
+ * converted to the USART registers; the other fields are ignored.
+ *
  * \param pSpid  Pointer to a Spid instance.
  * \param cs  number corresponding to the SPI chip select.
  * \param csr  SPI_CSR value to setup.
  */
 extern void SPID_ConfigureCS( Spid* pSpid, uint32_t dwCS, uint32_t dwCSR )
 {
-    SPI_ConfigureNPCS( pSpid->pSpiHw, dwCS, dwCSR ) ;
+    SpidUsart* pUsart = pSpid->pUsart ;
+    uint32_t dwMr ;
+    uint32_t dwCd ;
+
+    if ( pUsart == 0 )
+    {
+        SPI_ConfigureNPCS( pSpid->pSpiHw, dwCS, dwCSR ) ;
+
+        return ;
+    }
+
+    dwCS &= SPID_USART_NUM_CS - 1 ;
+
+    /* SPI NCPHA and USART CPHA have the same meaning */
+    dwMr = US_MR_USART_MODE_SPI_MASTER | US_MR_USCLKS_MCK | US_MR_CHRL_8_BIT
+         | US_MR_CHMODE_NORMAL | US_MR_CLKO ;
+    if ( dwCSR & SPI_CSR_CPOL )
+    {
+        dwMr |= US_MR_CPOL ;
+    }
+    if ( dwCSR & SPI_CSR_NCPHA )
+    {
+        dwMr |= US_MR_CPHA ;
+    }
+
+    /* SPCK = MCK / SCBR on both peripherals */
+    dwCd = (dwCSR & SPI_CSR_SCBR_Msk) >> SPI_CSR_SCBR_Pos ;
+    if ( dwCd < SPID_USART_MIN_CD )
+    {
+        dwCd = SPID_USART_MIN_CD ;
+    }
+
+    pUsart->adwMr[dwCS] = dwMr ;
+    pUsart->adwBrgr[dwCS] = dwCd ;
+}
+
+/**
+ * \brief Sets the GPIO pin used as chip select on a USART bus.
+ *
+ * The pin is configured and driven high (released). Chip selects without pin
+ * use the NSS (RTS) line of the USART, which should then be shared by one
+ * device only.
+ *
+ * \param pSpid  Pointer to a Spid instance configured with SPID_ConfigureUsart().
+ * \param dwCS  Chip select number.
+ * \param pCsPin  Chip select pin, configured as output, or 0 for the NSS line.
+ */
+extern void SPID_ConfigureUsartCS( Spid* pSpid, uint32_t dwCS, const Pin* pCsPin )
+{
+    SpidUsart* pUsart = pSpid->pUsart ;
+
+    assert( pUsart ) ;
+
+    dwCS &= SPID_USART_NUM_CS - 1 ;
+    pUsart->apCsPins[dwCS] = pCsPin ;
+    if ( pCsPin )
+    {
+        PIO_Configure( pCsPin, 1 ) ;
+        PIO_Set( pCsPin ) ;
+    }
 }
 
 /**
@@ -151,76 +447,103 @@ extern void SPID_ConfigureCS( Spid* pSpid, uint32_t dwCS, uint32_t dwCSR )
  */
 extern uint32_t SPID_SendCommand( Spid* pSpid, SpidCmd* pCommand )
 {
-    Spi* pSpiHw = pSpid->pSpiHw ;
-    uint32_t dwSpiMr ;
-
-    /* Try to get the dataflash semaphore */
-    if ( pSpid->semaphore == 0 )
-    {
-        return SPID_ERROR_LOCK ;
-    }
-    pSpid->semaphore-- ;
-
-    /* Enable the SPI clock */
-    PMC_EnablePeripheral( pSpid->spiId ) ;
-
-    /* Disable transmitter and receiver*/
-    SPI_PdcDisableRx( pSpiHw ) ;
-    SPI_PdcDisableTx( pSpiHw ) ;
-
-    /* Write to the MR register*/
-    dwSpiMr = pSpiHw->SPI_MR ;
-    dwSpiMr |= SPI_MR_PCS_Msk ;
-    dwSpiMr &= ~((1 << pCommand->spiCs) << 16 ) ;
-    pSpiHw->SPI_MR=dwSpiMr ;
-
-    /* Initialize the two SPI PDC buffer*/
-    SPI_PdcSetRx( pSpiHw, pCommand->pCmd, pCommand->cmdSize, pCommand->pData, pCommand->dataSize ) ;
-    SPI_PdcSetTx( pSpiHw, pCommand->pCmd, pCommand->cmdSize, pCommand->pData, pCommand->dataSize ) ;
-
-    /* Initialize the callback*/
-    pSpid->pCurrentCommand = pCommand ;
-
-    /* Enable transmitter and receiver*/
-    SPI_PdcEnableRx( pSpiHw ) ;
-    SPI_PdcEnableTx( pSpiHw ) ;
-
-    /* Enable buffer complete interrupt*/
-    SPI_EnableIt( pSpiHw, SPI_IER_RXBUFF ) ;
+    return _QueueCommand( pSpid, pCommand, 1 ) ;
+}
 
-    return 0 ;
+/**
+ * \brief Queues a SPI master transfer. This is a non blocking function. The
+ * command is started at once if the driver is idle; otherwise it is started
+ * from SPID_Handler() when the commands queued before are complete.
+ *
+ * \param pSpid  Pointer to a Spid instance.
+ * \param pCommand Pointer to the SPI command to execute.
+ * \return 0.
+ */
+extern uint32_t SPID_QueueCommand( Spid* pSpid, SpidCmd* pCommand )
+{
+    return _QueueCommand( pSpid, pCommand, 0 ) ;
 }
 
 /**
  * \brief The SPI_Handler must be called by the SPI Interrupt Service Routine with the
  * corresponding Spi instance.
  *
- * \note The SPI_Handler will unlock the Spi semaphore and invoke the upper application
- * callback.
+ * \note The SPI_Handler will start the next queued command, or unlock the Spi
+ * semaphore if there is none, and invoke the upper application callback.
  * \param pSpid  Pointer to a Spid instance.
  */
-extern void SPID_Handler( Spid* pSpid )
+IRQ_RAMFUNC extern void SPID_Handler( Spid* pSpid )
 {
-    SpidCmd *pSpidCmd = pSpid->pCurrentCommand ;
+    SpidCmd *pSpidCmd ;
     Spi *pSpiHw = pSpid->pSpiHw ;
+    SpidUsart *pUsart = pSpid->pUsart ;
     volatile uint32_t spiSr ;
+    uint32_t dwPrimask ;
+    uint32_t dwDone ;
+
+    PROF_Enter( PROF_ID_SPID_HANDLER ) ;
+
+    /* The handler may also be polled, outside of the interrupt */
+    dwPrimask = __get_PRIMASK() ;
+    __disable_irq() ;
 
     /* Read the status register*/
-    spiSr = pSpiHw->SPI_SR ;
-    if ( spiSr & SPI_SR_RXBUFF )
+    pSpidCmd = pSpid->pCurrentCommand ;
+    if ( pUsart )
+    {
+        spiSr = pUsart->pUsartHw->US_CSR ;
+        dwDone = spiSr & US_CSR_RXBUFF ;
+    }
+    else
+    {
+        spiSr = pSpiHw->SPI_SR ;
+        dwDone = spiSr & SPI_SR_RXBUFF ;
+    }
+    if ( !pSpidCmd || !dwDone )
+    {
+        __set_PRIMASK( dwPrimask ) ;
+    }
+    else
     {
         /* Disable transmitter and receiver */
-        SPI_PdcDisableRx( pSpiHw ) ;
-        SPI_PdcDisableTx( pSpiHw ) ;
+        if ( pUsart )
+        {
+            pUsart->pUsartHw->US_PTCR = US_PTCR_RXTDIS | US_PTCR_TXTDIS ;
+            _UsartSelect( pUsart, pSpidCmd->spiCs & (SPID_USART_NUM_CS - 1), 0 ) ;
+        }
+        else
+        {
+            SPI_PdcDisableRx( pSpiHw ) ;
+            SPI_PdcDisableTx( pSpiHw ) ;
+        }
 
-        /* Disable the SPI clock*/
-        PMC_DisablePeripheral( pSpid->spiId ) ;
+        pSpid->pCurrentCommand = pSpidCmd->pNext ;
+        if ( pSpid->pCurrentCommand )
+        {
+            /* Start the next queued command at once */
+            _StartCommand( pSpid, pSpid->pCurrentCommand ) ;
+        }
+        else
+        {
+            pSpid->pLastCommand = 0 ;
 
-        /* Disable buffer complete interrupt */
-        SPI_DisableIt( pSpiHw, SPI_IDR_RXBUFF ) ;
+            /* Disable buffer complete interrupt, while the SPI is clocked */
+            if ( pUsart )
+            {
+                pUsart->pUsartHw->US_IDR = US_IDR_RXBUFF ;
+            }
+            else
+            {
+                SPI_DisableIt( pSpiHw, SPI_IDR_RXBUFF ) ;
+            }
 
-        /* Release the dataflash semaphore*/
-        pSpid->semaphore++ ;
+            /* Release the SPI clock */
+            PMC_ReleasePeripheral( pSpid->spiId ) ;
+
+            /* Release the dataflash semaphore*/
+            pSpid->semaphore++ ;
+        }
+        __set_PRIMASK( dwPrimask ) ;
 
         /* Invoke the callback associated with the current command*/
         if ( pSpidCmd && pSpidCmd->callback )
@@ -231,6 +554,8 @@ extern void SPID_Handler( Spid* pSpid )
         /* Nothing must be done after. A new DF operation may have been started
            in the callback function.*/
     }
+
+    PROF_Exit( PROF_ID_SPID_HANDLER ) ;
 }
 
 /**
@@ -0,0 +1,478 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \addtogroup spis_module SPI slave streaming driver
+ *
+ * The SPI slave driver streams data with a SPI master, e.g. a host processor,
+ * without byte interrupts: both PDC channels keep running over two rings,
+ * from one chip select frame to the next, and are only reprogrammed every
+ * chunk of up to dwChunk bytes with their next buffer registers.
+ *
+ * The received bytes are cut in frames at the rising edges of NSS. A frame is
+ * handed to the application in place in the receive ring, as a SpisFrame
+ * descriptor, and its space is reused once released. The bytes to send are
+ * queued in the transmit ring, and clocked out by the master as it transfers
+ * frames.
+ *
+ * \section Usage
+ * <ul>
+ * <li> Configure the SPI pins (including NPCS0 as NSS), then start the driver
+ *    with SPIS_Configure().</li>
+ * <li> Call SPIS_Handler() from the SPI interrupt handler, and enable the SPI
+ *    interrupt in the NVIC.</li>
+ * <li> Get the received frames in order with SPIS_GetFrame(), and release them
+ *    with SPIS_ReleaseFrame(); SPIS_SetCallback() sets a function invoked at
+ *    the end of each frame.</li>
+ * <li> Queue the data to send with SPIS_Write().</li>
+ * </ul>
+ *
+ * \note When the receive ring is full, the bytes received are lost and counted
+ * in dwOverruns; when the transmit ring is empty, the SPI underruns. When the
+ * frame queue is full, a new frame is merged with the last one queued.
+ *
+ * Related files :\n
+ * \ref spis.c\n
+ * \ref spis.h.\n
+ */
+/*@{*/
+/*@}*/
+
+/**
+ * \file
+ *
+ * Implementation of the SPI slave streaming driver.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "chip.h"
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Returns the number of bytes left in the current and next buffers of
+ * a PDC channel.
+ * \param pdwPdc  Pointer to the PR register of the channel; CR follows it,
+ * and NPR, NCR are 0x10 bytes further.
+ */
+static uint32_t _GetPdcLeft( volatile uint32_t* pdwPdc )
+{
+    uint32_t dwCount ;
+    uint32_t dwNext ;
+
+    /* Read again if the PDC moved to the next buffer in between */
+    do
+    {
+        dwCount = pdwPdc[1] ;
+        dwNext = pdwPdc[5] ;
+    } while ( dwCount != pdwPdc[1] ) ;
+
+    return dwCount + dwNext ;
+}
+
+/**
+ * \brief Gives the free area of the receive ring to the PDC, as current and
+ * next buffers, and marks the receiver stalled if the ring is full.
+ * \param pSpis  Pointer to a Spis instance.
+ */
+static void _ArmRx( Spis* pSpis )
+{
+    Spi* pSpiHw = pSpis->pSpiHw ;
+    RingBuffer* pRing = &pSpis->rx ;
+    uint32_t dwSize = pRing->dwMask + 1 ;
+    uint32_t dwArea ;
+    uint32_t dwToEnd ;
+    uint8_t* pArea ;
+
+    while ( pSpiHw->SPI_RNCR == 0 )
+    {
+        dwArea = pRing->dwTail + dwSize - pSpis->dwRxArmed ;
+        dwToEnd = dwSize - (pSpis->dwRxArmed & pRing->dwMask) ;
+        if ( dwArea > dwToEnd )
+        {
+            dwArea = dwToEnd ;
+        }
+        if ( dwArea > pSpis->dwChunk )
+        {
+            dwArea = pSpis->dwChunk ;
+        }
+        if ( dwArea == 0 )
+        {
+            /* Re-armed by SPIS_ReleaseFrame() */
+            pSpis->bRxStalled = 1 ;
+            SPI_DisableIt( pSpiHw, SPI_IDR_ENDRX ) ;
+
+            return ;
+        }
+
+        pArea = &pRing->pBuffer[pSpis->dwRxArmed & pRing->dwMask] ;
+        if ( pSpiHw->SPI_RCR == 0 )
+        {
+            pSpiHw->SPI_RPR = (uint32_t)pArea ;
+            pSpiHw->SPI_RCR = dwArea ;
+        }
+        else
+        {
+            pSpiHw->SPI_RNPR = (uint32_t)pArea ;
+            pSpiHw->SPI_RNCR = dwArea ;
+        }
+        pSpis->dwRxArmed += dwArea ;
+    }
+
+    pSpis->bRxStalled = 0 ;
+    SPI_EnableIt( pSpiHw, SPI_IER_ENDRX ) ;
+}
+
+/**
+ * \brief Gives the data of the transmit ring to the PDC, as current and next
+ * buffers, and marks the transmitter stalled if the ring is empty.
+ * \param pSpis  Pointer to a Spis instance.
+ */
+static void _ArmTx( Spis* pSpis )
+{
+    Spi* pSpiHw = pSpis->pSpiHw ;
+    RingBuffer* pRing = &pSpis->tx ;
+    uint32_t dwArea ;
+    uint32_t dwToEnd ;
+    uint8_t* pArea ;
+
+    while ( pSpiHw->SPI_TNCR == 0 )
+    {
+        dwArea = pRing->dwHead - pSpis->dwTxArmed ;
+        dwToEnd = pRing->dwMask + 1 - (pSpis->dwTxArmed & pRing->dwMask) ;
+        if ( dwArea > dwToEnd )
+        {
+            dwArea = dwToEnd ;
+        }
+        if ( dwArea > pSpis->dwChunk )
+        {
+            dwArea = pSpis->dwChunk ;
+        }
+        if ( dwArea == 0 )
+        {
+            /* Re-armed by SPIS_Write() */
+            pSpis->bTxStalled = 1 ;
+            SPI_DisableIt( pSpiHw, SPI_IDR_ENDTX ) ;
+
+            return ;
+        }
+
+        /* The data is read by the PDC after it was written */
+        __DMB() ;
+        pArea = &pRing->pBuffer[pSpis->dwTxArmed & pRing->dwMask] ;
+        if ( pSpiHw->SPI_TCR == 0 )
+        {
+            pSpiHw->SPI_TPR = (uint32_t)pArea ;
+            pSpiHw->SPI_TCR = dwArea ;
+        }
+        else
+        {
+            pSpiHw->SPI_TNPR = (uint32_t)pArea ;
+            pSpiHw->SPI_TNCR = dwArea ;
+        }
+        pSpis->dwTxArmed += dwArea ;
+    }
+
+    pSpis->bTxStalled = 0 ;
+    SPI_EnableIt( pSpiHw, SPI_IER_ENDTX ) ;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initializes the driver, configures the SPI in slave mode and starts
+ * the PDC on the rings.
+ *
+ * The SPI clock stays enabled until SPIS_Stop().
+ * \param pSpis  Pointer to a Spis instance.
+ * \param pSpiHw  SPI peripheral.
+ * \param spiId  SPI peripheral identifier.
+ * \param dwCsr  SPI_CSR0 value (clock polarity and phase, bits per transfer).
+ * \param pRxBuffer  Storage of the receive ring.
+ * \param dwRxSize  Size of the receive ring, a power of two.
+ * \param pTxBuffer  Storage of the transmit ring, 0 if the slave only receives.
+ * \param dwTxSize  Size of the transmit ring, a power of two.
+ * \param dwChunk  Largest PDC buffer in bytes, at most 65535.
+ * \return 0 if successful; otherwise returns SPIS_ERROR_PARAM.
+ */
+extern uint32_t SPIS_Configure( Spis* pSpis, Spi* pSpiHw, uint8_t spiId, uint32_t dwCsr,
+                                uint8_t* pRxBuffer, uint32_t dwRxSize,
+                                uint8_t* pTxBuffer, uint32_t dwTxSize, uint32_t dwChunk )
+{
+    if ( dwChunk == 0 || dwChunk > 0xFFFF || RING_Initialize( &pSpis->rx, pRxBuffer, dwRxSize ) )
+    {
+        TRACE_ERROR( "SPIS_Configure: invalid receive ring\n\r" ) ;
+
+        return SPIS_ERROR_PARAM ;
+    }
+    if ( pTxBuffer )
+    {
+        if ( RING_Initialize( &pSpis->tx, pTxBuffer, dwTxSize ) )
+        {
+            TRACE_ERROR( "SPIS_Configure: invalid transmit ring\n\r" ) ;
+
+            return SPIS_ERROR_PARAM ;
+        }
+    }
+    else
+    {
+        /* Always empty */
+        RING_Initialize( &pSpis->tx, 0, 1 ) ;
+    }
+
+    pSpis->pSpiHw = pSpiHw ;
+    pSpis->spiId = spiId ;
+    pSpis->dwChunk = dwChunk ;
+    pSpis->dwRxArmed = 0 ;
+    pSpis->dwTxArmed = 0 ;
+    pSpis->dwFrameHead = 0 ;
+    pSpis->dwFrameTail = 0 ;
+    pSpis->dwFramesMerged = 0 ;
+    pSpis->dwOverruns = 0 ;
+    pSpis->callback = 0 ;
+    pSpis->pArgument = 0 ;
+
+    /* Slave mode, enables the SPI clock */
+    SPI_Configure( pSpiHw, spiId, 0 ) ;
+    SPI_ConfigureNPCS( pSpiHw, 0, dwCsr ) ;
+    SPI_DisableIt( pSpiHw, 0xFFFFFFFF ) ;
+
+    SPI_PdcDisableRx( pSpiHw ) ;
+    SPI_PdcDisableTx( pSpiHw ) ;
+    SPI_PdcSetRx( pSpiHw, 0, 0, 0, 0 ) ;
+    SPI_PdcSetTx( pSpiHw, 0, 0, 0, 0 ) ;
+    _ArmRx( pSpis ) ;
+    _ArmTx( pSpis ) ;
+    SPI_PdcEnableRx( pSpiHw ) ;
+    SPI_PdcEnableTx( pSpiHw ) ;
+
+    /* Clear NSSR and OVRES, then wait for the end of the frames */
+    SPI_GetStatus( pSpiHw ) ;
+    SPI_EnableIt( pSpiHw, SPI_IER_NSSR ) ;
+    SPI_Enable( pSpiHw ) ;
+
+    return 0 ;
+}
+
+/**
+ * \brief Sets the function invoked at the end of each frame.
+ * \param pSpis  Pointer to a Spis instance.
+ * \param callback  Callback, invoked from SPIS_Handler(), or 0.
+ * \param pArgument  Argument of the callback.
+ */
+extern void SPIS_SetCallback( Spis* pSpis, SpisCallback callback, void* pArgument )
+{
+    uint32_t dwPrimask ;
+
+    dwPrimask = __get_PRIMASK() ;
+    __disable_irq() ;
+    pSpis->callback = callback ;
+    pSpis->pArgument = pArgument ;
+    __set_PRIMASK( dwPrimask ) ;
+}
+
+/**
+ * \brief SPI slave interrupt handler. Must be called by the SPI interrupt
+ * handler of the application.
+ *
+ * Publishes the bytes received and releases the bytes sent, gives the next
+ * buffers to the PDC, and queues a frame on a rising edge of NSS.
+ * \param pSpis  Pointer to a Spis instance.
+ */
+IRQ_RAMFUNC extern void SPIS_Handler( Spis* pSpis )
+{
+    Spi* pSpiHw = pSpis->pSpiHw ;
+    RingBuffer* pRing = &pSpis->rx ;
+    uint32_t dwSr ;
+    uint32_t dwEnd ;
+    uint32_t dwLast ;
+
+    /* NSSR and OVRES are cleared on read */
+    dwSr = pSpiHw->SPI_SR ;
+    if ( dwSr & SPI_SR_OVRES )
+    {
+        pSpis->dwOverruns++ ;
+    }
+
+    dwEnd = pSpis->dwRxArmed - _GetPdcLeft( &pSpiHw->SPI_RPR ) ;
+    if ( dwEnd != pRing->dwHead )
+    {
+        RING_Commit( pRing, dwEnd - pRing->dwHead ) ;
+    }
+    _ArmRx( pSpis ) ;
+
+    RING_Consume( &pSpis->tx, pSpis->dwTxArmed - _GetPdcLeft( &pSpiHw->SPI_TPR ) - pSpis->tx.dwTail ) ;
+    _ArmTx( pSpis ) ;
+
+    if ( dwSr & SPI_SR_NSSR )
+    {
+        if ( pSpis->dwFrameHead == pSpis->dwFrameTail )
+        {
+            dwLast = pRing->dwTail ;
+        }
+        else
+        {
+            dwLast = pSpis->adwFrameEnd[(pSpis->dwFrameHead - 1) & (SPIS_MAX_FRAMES - 1)] ;
+        }
+
+        /* Ignore NSS pulses without data */
+        if ( dwEnd != dwLast )
+        {
+            if ( pSpis->dwFrameHead - pSpis->dwFrameTail == SPIS_MAX_FRAMES )
+            {
+                pSpis->adwFrameEnd[(pSpis->dwFrameHead - 1) & (SPIS_MAX_FRAMES - 1)] = dwEnd ;
+                pSpis->dwFramesMerged++ ;
+            }
+            else
+            {
+                pSpis->adwFrameEnd[pSpis->dwFrameHead & (SPIS_MAX_FRAMES - 1)] = dwEnd ;
+                __DMB() ;
+                pSpis->dwFrameHead++ ;
+            }
+
+            if ( pSpis->callback )
+            {
+                pSpis->callback( pSpis, pSpis->pArgument ) ;
+            }
+        }
+    }
+}
+
+/**
+ * \brief Returns the oldest frame received, without removing it.
+ * \param pSpis  Pointer to a Spis instance.
+ * \param pFrame  Receives the frame descriptor.
+ * \return 1 if a frame was received; otherwise returns 0.
+ */
+extern uint32_t SPIS_GetFrame( Spis* pSpis, SpisFrame* pFrame )
+{
+    RingBuffer* pRing = &pSpis->rx ;
+    uint32_t dwStart ;
+    uint32_t dwLength ;
+    uint32_t dwToEnd ;
+
+    if ( pSpis->dwFrameTail == pSpis->dwFrameHead )
+    {
+        return 0 ;
+    }
+
+    /* The frame end is read after it was published */
+    __DMB() ;
+    dwStart = pRing->dwTail ;
+    dwLength = pSpis->adwFrameEnd[pSpis->dwFrameTail & (SPIS_MAX_FRAMES - 1)] - dwStart ;
+    dwToEnd = pRing->dwMask + 1 - (dwStart & pRing->dwMask) ;
+
+    pFrame->pData = &pRing->pBuffer[dwStart & pRing->dwMask] ;
+    if ( dwLength > dwToEnd )
+    {
+        pFrame->dwLength = dwToEnd ;
+        pFrame->pWrapData = pRing->pBuffer ;
+        pFrame->dwWrapLength = dwLength - dwToEnd ;
+    }
+    else
+    {
+        pFrame->dwLength = dwLength ;
+        pFrame->pWrapData = 0 ;
+        pFrame->dwWrapLength = 0 ;
+    }
+
+    return 1 ;
+}
+
+/**
+ * \brief Releases the oldest frame, returned by SPIS_GetFrame(): its space
+ * in the receive ring can be reused.
+ * \param pSpis  Pointer to a Spis instance.
+ * \param pFrame  Frame descriptor.
+ */
+extern void SPIS_ReleaseFrame( Spis* pSpis, const SpisFrame* pFrame )
+{
+    uint32_t dwPrimask ;
+
+    /* The frame queue and the ring tail are read by SPIS_Handler() */
+    dwPrimask = __get_PRIMASK() ;
+    __disable_irq() ;
+
+    RING_Consume( &pSpis->rx, pFrame->dwLength + pFrame->dwWrapLength ) ;
+    pSpis->dwFrameTail++ ;
+    if ( pSpis->bRxStalled )
+    {
+        _ArmRx( pSpis ) ;
+    }
+
+    __set_PRIMASK( dwPrimask ) ;
+}
+
+/**
+ * \brief Queues data to send to the master.
+ * \param pSpis  Pointer to a Spis instance.
+ * \param pData  Data to send.
+ * \param dwSize  Number of bytes to send.
+ * \return Number of bytes queued, less than dwSize if the transmit ring is full.
+ */
+extern uint32_t SPIS_Write( Spis* pSpis, const uint8_t* pData, uint32_t dwSize )
+{
+    uint32_t dwPrimask ;
+    uint32_t dwDone ;
+
+    dwDone = RING_Write( &pSpis->tx, pData, dwSize ) ;
+
+    if ( pSpis->bTxStalled && dwDone )
+    {
+        dwPrimask = __get_PRIMASK() ;
+        __disable_irq() ;
+        _ArmTx( pSpis ) ;
+        __set_PRIMASK( dwPrimask ) ;
+    }
+
+    return dwDone ;
+}
+
+/**
+ * \brief Stops the PDC and disables the SPI and its clock.
+ * \param pSpis  Pointer to a Spis instance.
+ */
+extern void SPIS_Stop( Spis* pSpis )
+{
+    Spi* pSpiHw = pSpis->pSpiHw ;
+
+    SPI_DisableIt( pSpiHw, 0xFFFFFFFF ) ;
+    SPI_PdcDisableRx( pSpiHw ) ;
+    SPI_PdcDisableTx( pSpiHw ) ;
+    SPI_Disable( pSpiHw ) ;
+
+    PMC_DisablePeripheral( pSpis->spiId ) ;
+}
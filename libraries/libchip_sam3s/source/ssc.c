@@ -71,6 +71,8 @@
 
 #include "chip.h"
 
+#include <assert.h>
+
 /*----------------------------------------------------------------------------
  *       Exported functions
  *----------------------------------------------------------------------------*/
@@ -245,3 +247,249 @@ uint8_t SSC_ReadBuffer(void *buffer, uint32_t length)
     }
     return 0;
 }
+
+/*----------------------------------------------------------------------------
+ *        Streaming
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Hands the transmit buffers produced to the free PDC banks.
+ * Called with the interrupts disabled.
+ */
+static void SSC_StreamArmTx(SscStream *pStream)
+{
+    SscRing *pRing = &pStream->tx;
+    uint32_t index;
+
+    while ((pRing->dwArmed - pRing->dwDone) < 2
+           && pRing->dwArmed != pRing->dwApp) {
+
+        index = pRing->dwArmed % pRing->bNumBuffers;
+        SSC_WriteBuffer(&pRing->pBuffers[index * pRing->dwBufferSize],
+                        pRing->pdwLength[index] / pStream->bWordSize);
+        pRing->dwArmed++;
+    }
+    if (pRing->dwArmed != pRing->dwDone) {
+
+        SSC->SSC_IER = SSC_IER_ENDTX;
+    }
+}
+
+/**
+ * \brief Hands the free receive buffers to the free PDC banks.
+ * Called with the interrupts disabled.
+ */
+static void SSC_StreamArmRx(SscStream *pStream)
+{
+    SscRing *pRing = &pStream->rx;
+    uint32_t index;
+
+    while ((pRing->dwArmed - pRing->dwDone) < 2
+           && (pRing->dwArmed - pRing->dwApp) < pRing->bNumBuffers) {
+
+        index = pRing->dwArmed % pRing->bNumBuffers;
+        pRing->pdwLength[index] = pRing->dwBufferSize;
+        SSC_ReadBuffer(&pRing->pBuffers[index * pRing->dwBufferSize],
+                       pRing->dwBufferSize / pStream->bWordSize);
+        pRing->dwArmed++;
+    }
+    if (pRing->dwArmed != pRing->dwDone) {
+
+        SSC->SSC_IER = SSC_IER_ENDRX;
+    }
+}
+
+/**
+ * \brief Initializes a full-duplex SSC stream. The SSC must be configured
+ * (transmit and receive frame formats) by the application or codec driver.
+ * \param pStream  Stream to initialize.
+ * \param pTxBuffers  numBuffers transmit buffers of bufferSize bytes, or 0.
+ * \param pRxBuffers  numBuffers receive buffers of bufferSize bytes, or 0.
+ * \param bufferSize  Size of a buffer in bytes.
+ * \param numBuffers  Number of buffers of each ring.
+ * \param wordSize  Bytes per SSC data transfer (1, 2 or 4).
+ */
+void SSC_StreamInitialize(SscStream *pStream,
+                          uint8_t *pTxBuffers, uint8_t *pRxBuffers,
+                          uint32_t bufferSize, uint8_t numBuffers,
+                          uint8_t wordSize)
+{
+    assert(numBuffers >= 2 && numBuffers <= SSC_STREAM_MAXBUFFERS);
+
+    pStream->tx.pBuffers = pTxBuffers;
+    pStream->rx.pBuffers = pRxBuffers;
+    pStream->tx.dwBufferSize = pStream->rx.dwBufferSize = bufferSize;
+    pStream->tx.bNumBuffers = pStream->rx.bNumBuffers = numBuffers;
+    pStream->tx.dwArmed = pStream->tx.dwDone = pStream->tx.dwApp = 0;
+    pStream->rx.dwArmed = pStream->rx.dwDone = pStream->rx.dwApp = 0;
+    pStream->tx.dwErrors = pStream->rx.dwErrors = 0;
+    pStream->bWordSize = wordSize;
+}
+
+/**
+ * \brief Starts the reception of a stream; the transmission starts with the
+ * first buffer committed. SSC_StreamHandler() must be called from the SSC
+ * interrupt.
+ * \param pStream  Stream to start.
+ */
+void SSC_StreamStart(SscStream *pStream)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (pStream->rx.pBuffers) {
+
+        SSC_StreamArmRx(pStream);
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * \brief Stops both directions of a stream.
+ * \param pStream  Stream to stop.
+ */
+void SSC_StreamStop(SscStream *pStream)
+{
+    SSC->SSC_IDR = SSC_IDR_ENDTX | SSC_IDR_ENDRX;
+    SSC->SSC_PTCR = SSC_PTCR_TXTDIS | SSC_PTCR_RXTDIS;
+    SSC->SSC_TCR = SSC->SSC_TNCR = 0;
+    SSC->SSC_RCR = SSC->SSC_RNCR = 0;
+    SSC_StreamInitialize(pStream, pStream->tx.pBuffers, pStream->rx.pBuffers,
+                         pStream->tx.dwBufferSize, pStream->tx.bNumBuffers,
+                         pStream->bWordSize);
+}
+
+/**
+ * \brief SSC interrupt handling of a stream: retires the buffers completed by
+ * the PDC and arms the next ones. A ring whose PDC banks both ran out counts
+ * an error (underrun or overrun), and restarts with the next buffer available.
+ * \param pStream  Stream.
+ */
+void SSC_StreamHandler(SscStream *pStream)
+{
+    uint32_t status = SSC->SSC_SR & SSC->SSC_IMR;
+    uint32_t inPdc;
+
+    if (status & SSC_SR_ENDTX) {
+
+        inPdc = (SSC->SSC_TCR != 0) + (SSC->SSC_TNCR != 0);
+        pStream->tx.dwDone = pStream->tx.dwArmed - inPdc;
+        SSC_StreamArmTx(pStream);
+        if (pStream->tx.dwArmed == pStream->tx.dwDone) {
+
+            /* Nothing left to play */
+            SSC->SSC_IDR = SSC_IDR_ENDTX;
+            pStream->tx.dwErrors++;
+        }
+    }
+
+    if (status & SSC_SR_ENDRX) {
+
+        inPdc = (SSC->SSC_RCR != 0) + (SSC->SSC_RNCR != 0);
+        pStream->rx.dwDone = pStream->rx.dwArmed - inPdc;
+        SSC_StreamArmRx(pStream);
+        if (pStream->rx.dwArmed == pStream->rx.dwDone) {
+
+            /* All buffers held by the application */
+            SSC->SSC_IDR = SSC_IDR_ENDRX;
+            pStream->rx.dwErrors++;
+        }
+    }
+}
+
+/**
+ * \brief Returns the next transmit buffer to fill (dwBufferSize bytes), or 0
+ * if all are queued.
+ * \param pStream  Stream.
+ */
+uint8_t *SSC_StreamGetTxBuffer(SscStream *pStream)
+{
+    SscRing *pRing = &pStream->tx;
+
+    if ((pRing->dwApp - pRing->dwDone) >= pRing->bNumBuffers) {
+
+        return 0;
+    }
+    return &pRing->pBuffers[(pRing->dwApp % pRing->bNumBuffers)
+                            * pRing->dwBufferSize];
+}
+
+/**
+ * \brief Queues the buffer returned by SSC_StreamGetTxBuffer() for
+ * transmission.
+ * \param pStream  Stream.
+ * \param length  Number of bytes to send (multiple of the word size).
+ */
+void SSC_StreamCommitTx(SscStream *pStream, uint32_t length)
+{
+    SscRing *pRing = &pStream->tx;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (length) {
+
+        pRing->pdwLength[pRing->dwApp % pRing->bNumBuffers] = length;
+        pRing->dwApp++;
+        SSC_StreamArmTx(pStream);
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * \brief Returns the oldest buffer received, in place, or 0 if none.
+ * \param pStream  Stream.
+ * \param pLength  Set to the number of bytes received.
+ */
+uint8_t *SSC_StreamGetRxBuffer(SscStream *pStream, uint32_t *pLength)
+{
+    SscRing *pRing = &pStream->rx;
+    uint32_t index = pRing->dwApp % pRing->bNumBuffers;
+
+    if (pRing->dwApp == pRing->dwDone) {
+
+        return 0;
+    }
+    *pLength = pRing->pdwLength[index];
+    return &pRing->pBuffers[index * pRing->dwBufferSize];
+}
+
+/**
+ * \brief Gives back the buffer returned by SSC_StreamGetRxBuffer().
+ * \param pStream  Stream.
+ */
+void SSC_StreamReleaseRx(SscStream *pStream)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    pStream->rx.dwApp++;
+    SSC_StreamArmRx(pStream);
+    __set_PRIMASK(primask);
+}
+
+/**
+ * \brief USB transfer callback (TransferCallback) committing a transmit
+ * buffer: read the audio OUT endpoint into SSC_StreamGetTxBuffer(), with the
+ * stream as argument, and the samples go to the SSC without copy.
+ */
+void SSC_StreamTxTransferCallback(void *pArg, uint8_t status,
+                                  uint32_t transferred, uint32_t remaining)
+{
+    (void)remaining;
+    if (status == 0) {
+
+        SSC_StreamCommitTx((SscStream *)pArg, transferred);
+    }
+}
+
+/**
+ * \brief USB transfer callback (TransferCallback) releasing a receive
+ * buffer: write SSC_StreamGetRxBuffer() to the audio IN endpoint, with the
+ * stream as argument.
+ */
+void SSC_StreamRxTransferCallback(void *pArg, uint8_t status,
+                                  uint32_t transferred, uint32_t remaining)
+{
+    (void)status; (void)transferred; (void)remaining;
+    SSC_StreamReleaseRx((SscStream *)pArg);
+}
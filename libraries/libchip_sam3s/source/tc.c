@@ -173,3 +173,234 @@ extern uint32_t TC_FindMckDivisor( uint32_t dwFreq, uint32_t dwMCk, uint32_t *dw
     return 1 ;
 }
 
+/**
+ * \brief Starts chained channels as one free running counter
+ *
+ * Channel 0 counts the given clock and the following channels count the
+ * wraps of the previous one, through TIOA0 (XC1) and TIOA1 (XC2): two
+ * channels give a 32-bit counter, three a 48-bit counter. With an MCK
+ * divisor the counter is a time base for timestamps; with TC_CMR_TCCLKS_XC0
+ * and TCLK0 selected in TC_BMR it counts input edges without any interrupt,
+ * a frequency being the difference of two readings over a known interval.
+ *
+ * The chained channels drive TIOA0 (and TIOA1), which must not be used as
+ * outputs of the board.
+ *
+ * \param pTc  Pointer to a Tc instance.
+ * \param dwChannels  Number of chained channels, 2 or 3.
+ * \param dwTcClks  TCCLKS field value of channel 0.
+ */
+extern void TC_ChainStart( Tc *pTc, uint32_t dwChannels, uint32_t dwTcClks )
+{
+    /* TIOA rises on each wrap: set at 0, cleared halfway */
+    const uint32_t dwWave = TC_CMR_WAVE | TC_CMR_WAVSEL_UP | TC_CMR_ACPA_SET | TC_CMR_ACPC_CLEAR | TC_CMR_EEVT_XC0 ;
+    uint32_t dwChannel ;
+
+    assert( (dwChannels == 2) || (dwChannels == 3) ) ;
+
+    pTc->TC_BMR = (pTc->TC_BMR & ~(TC_BMR_TC1XC1S_Msk | TC_BMR_TC2XC2S_Msk)) | TC_BMR_TC1XC1S_TIOA0 | TC_BMR_TC2XC2S_TIOA1 ;
+
+    TC_Configure( pTc, 0, dwWave | dwTcClks ) ;
+    TC_Configure( pTc, 1, dwWave | TC_CMR_TCCLKS_XC1 ) ;
+    if ( dwChannels == 3 )
+    {
+        TC_Configure( pTc, 2, TC_CMR_WAVE | TC_CMR_WAVSEL_UP | TC_CMR_EEVT_XC0 | TC_CMR_TCCLKS_XC2 ) ;
+    }
+
+    for ( dwChannel = 0 ; dwChannel < dwChannels ; dwChannel++ )
+    {
+        pTc->TC_CHANNEL[dwChannel].TC_RA = 0 ;
+        pTc->TC_CHANNEL[dwChannel].TC_RC = 0x8000 ;
+    }
+
+    /* Each start edge is seen before the next channel runs, which then
+       starts from 0 */
+    for ( dwChannel = 0 ; dwChannel < dwChannels ; dwChannel++ )
+    {
+        TC_Start( pTc, dwChannel ) ;
+    }
+}
+
+/**
+ * \brief Reads chained channels started with TC_ChainStart()
+ *
+ * The upper channels are read before and after the lower ones until they
+ * match, so that the result is consistent across a wrap.
+ *
+ * \param pTc  Pointer to a Tc instance.
+ * \param dwChannels  Number of chained channels, 2 or 3.
+ *
+ * \return The 32-bit or 48-bit counter value.
+ */
+extern uint64_t TC_ChainRead( Tc *pTc, uint32_t dwChannels )
+{
+    uint32_t dwHigh ;
+    uint32_t dwMid ;
+    uint32_t dwLow ;
+
+    do
+    {
+        dwHigh = (dwChannels == 3) ? pTc->TC_CHANNEL[2].TC_CV : 0 ;
+        dwMid = pTc->TC_CHANNEL[1].TC_CV ;
+        dwLow = pTc->TC_CHANNEL[0].TC_CV ;
+    } while ( (dwMid != pTc->TC_CHANNEL[1].TC_CV) || ((dwChannels == 3) && (dwHigh != pTc->TC_CHANNEL[2].TC_CV)) ) ;
+
+    return ((uint64_t)(dwHigh & 0xFFFF) << 32) | ((dwMid & 0xFFFF) << 16) | (dwLow & 0xFFFF) ;
+}
+
+/**
+ * \brief Starts period and duty cycle capture on TIOA of a channel
+ *
+ * The counter is reset on each falling edge; RA is loaded on the rising
+ * edge (low time) and RB on the next falling edge (period), so a single
+ * interrupt per period stores both in the samples ring. Counter overflows
+ * extend the 16-bit captures for periods longer than 65535 clocks.
+ *
+ * \param pCapture  Capture instance.
+ * \param pTc  Pointer to a Tc instance.
+ * \param dwChannel Channel number.
+ * \param dwTcClks  TCCLKS field value.
+ * \param pSamples  Ring of samples.
+ * \param dwCount  Number of samples of the ring, a power of two.
+ */
+extern void TC_CaptureStart( TcCapture *pCapture, Tc *pTc, uint32_t dwChannel, uint32_t dwTcClks,
+                             TcCaptureSample *pSamples, uint32_t dwCount )
+{
+    assert( (dwCount != 0) && ((dwCount & (dwCount - 1)) == 0) ) ;
+
+    pCapture->pTc = pTc ;
+    pCapture->dwChannel = dwChannel ;
+    pCapture->pSamples = pSamples ;
+    pCapture->dwMask = dwCount - 1 ;
+    pCapture->dwHead = 0 ;
+    pCapture->dwTail = 0 ;
+    pCapture->dwOverflows = 0 ;
+    pCapture->dwLowTime = 0 ;
+    pCapture->dwLost = 0 ;
+
+    TC_Configure( pTc, dwChannel, dwTcClks | TC_CMR_LDRA_RISING | TC_CMR_LDRB_FALLING | TC_CMR_ABETRG | TC_CMR_ETRGEDG_FALLING ) ;
+    pTc->TC_CHANNEL[dwChannel].TC_IER = TC_IER_LDRAS | TC_IER_LDRBS | TC_IER_COVFS ;
+    TC_Start( pTc, dwChannel ) ;
+}
+
+/**
+ * \brief Stops a capture; the stored samples can still be read.
+ *
+ * \param pCapture  Capture instance.
+ */
+extern void TC_CaptureStop( TcCapture *pCapture )
+{
+    TcChannel* pTcCh = pCapture->pTc->TC_CHANNEL+pCapture->dwChannel ;
+
+    pTcCh->TC_IDR = 0xFFFFFFFF ;
+    pTcCh->TC_CCR = TC_CCR_CLKDIS ;
+}
+
+/**
+ * \brief Capture interrupt handler, to be called from the TC channel
+ * interrupt handler.
+ *
+ * \param pCapture  Capture instance.
+ */
+extern void TC_CaptureHandler( TcCapture *pCapture )
+{
+    TcChannel* pTcCh = pCapture->pTc->TC_CHANNEL+pCapture->dwChannel ;
+    uint32_t dwStatus = pTcCh->TC_SR ;
+    uint32_t dwOverflows = pCapture->dwOverflows ;
+    TcCaptureSample* pSample ;
+    uint32_t dwRa ;
+
+    /* RB load resets the counter, so a pending overflow always precedes it */
+    if ( dwStatus & TC_SR_COVFS )
+    {
+        dwOverflows++ ;
+    }
+
+    if ( dwStatus & TC_SR_LDRAS )
+    {
+        dwRa = pTcCh->TC_RA & 0xFFFF ;
+        /* A capture close to the wrap was loaded before the overflow */
+        if ( (dwStatus & TC_SR_COVFS) && (dwRa >= 0x8000) )
+        {
+            pCapture->dwLowTime = ((dwOverflows - 1) << 16) | dwRa ;
+        }
+        else
+        {
+            pCapture->dwLowTime = (dwOverflows << 16) | dwRa ;
+        }
+    }
+
+    if ( dwStatus & TC_SR_LDRBS )
+    {
+        if ( (pCapture->dwHead - pCapture->dwTail) > pCapture->dwMask )
+        {
+            pCapture->dwLost++ ;
+        }
+        else
+        {
+            pSample = pCapture->pSamples + (pCapture->dwHead & pCapture->dwMask) ;
+            pSample->dwLow = pCapture->dwLowTime ;
+            pSample->dwPeriod = (dwOverflows << 16) | (pTcCh->TC_RB & 0xFFFF) ;
+            __DMB() ;
+            pCapture->dwHead++ ;
+        }
+        /* The counter was reset by the falling edge */
+        dwOverflows = 0 ;
+    }
+
+    /* Load overrun: an edge came before the previous capture was read */
+    if ( dwStatus & TC_SR_LOVRS )
+    {
+        pCapture->dwLost++ ;
+    }
+
+    pCapture->dwOverflows = dwOverflows ;
+}
+
+/**
+ * \brief Consumes the stored samples and computes their statistics
+ *
+ * \param pCapture  Capture instance.
+ * \param pStats  Receives the statistics, left unchanged apart from
+ * dwSamples if no sample is available.
+ *
+ * \return The number of samples consumed.
+ */
+extern uint32_t TC_CaptureGetStats( TcCapture *pCapture, TcCaptureStats *pStats )
+{
+    uint32_t dwHead = pCapture->dwHead ;
+    uint64_t qwPeriods = 0 ;
+    uint64_t qwHigh = 0 ;
+    TcCaptureSample* pSample ;
+    uint32_t dwCount ;
+
+    __DMB() ;
+    dwCount = dwHead - pCapture->dwTail ;
+    pStats->dwSamples = dwCount ;
+    if ( dwCount == 0 )
+    {
+        return 0 ;
+    }
+
+    pStats->dwPeriodMin = 0xFFFFFFFF ;
+    pStats->dwPeriodMax = 0 ;
+    for ( ; pCapture->dwTail != dwHead ; pCapture->dwTail++ )
+    {
+        pSample = pCapture->pSamples + (pCapture->dwTail & pCapture->dwMask) ;
+        qwPeriods += pSample->dwPeriod ;
+        qwHigh += pSample->dwPeriod - pSample->dwLow ;
+        if ( pSample->dwPeriod < pStats->dwPeriodMin )
+        {
+            pStats->dwPeriodMin = pSample->dwPeriod ;
+        }
+        if ( pSample->dwPeriod > pStats->dwPeriodMax )
+        {
+            pStats->dwPeriodMax = pSample->dwPeriod ;
+        }
+    }
+
+    pStats->dwPeriodMean = (uint32_t)(qwPeriods / dwCount) ;
+    pStats->dwDutyPerThousand = qwPeriods ? (uint32_t)((qwHigh * 1000) / qwPeriods) : 0 ;
+
+    return dwCount ;
+}
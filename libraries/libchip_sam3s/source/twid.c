@@ -63,6 +63,138 @@ typedef struct _AsyncTwi {
 
 } AsyncTwi;
 
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Starts the current segment of a transaction. The PDC transfers the
+ * bytes of the segment, except the last byte of a read which must be read
+ * after the STOP condition is requested.
+ * \param pTwi  Pointer to the TWI peripheral.
+ * \param pSegment  Segment to start.
+ */
+static void TWID_StartSegment( Twi *pTwi, TwidSegment *pSegment )
+{
+    assert( (pSegment->address & 0x80) == 0 ) ;
+    assert( (pSegment->iaddress & 0xFF000000) == 0 ) ;
+    assert( pSegment->isize < 4 ) ;
+    assert( pSegment->num > 0 ) ;
+
+    /* Set slave address and internal address */
+    pTwi->TWI_MMR = 0;
+    pTwi->TWI_MMR = (pSegment->isize << 8) | (pSegment->address << 16)
+                  | ((pSegment->direction == TWID_SEGMENT_READ) ? TWI_MMR_MREAD : 0);
+    pTwi->TWI_IADR = 0;
+    pTwi->TWI_IADR = pSegment->iaddress;
+
+    if (pSegment->direction == TWID_SEGMENT_READ) {
+
+        /* Single byte: START and STOP at once */
+        if (pSegment->num == 1) {
+
+            pTwi->TWI_CR = TWI_CR_START | TWI_CR_STOP;
+            TWI_EnableIt(pTwi, TWI_IER_RXRDY | TWI_IER_NACK);
+        }
+        else {
+
+            pTwi->TWI_RPR = (uint32_t)pSegment->pData;
+            pTwi->TWI_RCR = pSegment->num - 1;
+            pTwi->TWI_PTCR = TWI_PTCR_RXTEN;
+            pTwi->TWI_CR = TWI_CR_START;
+            TWI_EnableIt(pTwi, TWI_IER_ENDRX | TWI_IER_NACK);
+        }
+    }
+    else {
+
+        /* The first byte written by the PDC starts the transfer */
+        pTwi->TWI_TPR = (uint32_t)pSegment->pData;
+        pTwi->TWI_TCR = pSegment->num;
+        pTwi->TWI_PTCR = TWI_PTCR_TXTEN;
+        TWI_EnableIt(pTwi, TWI_IER_ENDTX | TWI_IER_NACK);
+    }
+}
+
+/**
+ * \brief Interrupt handler of a transaction: about three interrupts per
+ * segment whatever its size (end of PDC buffer, last byte, end of transfer).
+ * \param pTwid  Pointer to a Twid instance.
+ */
+static void TWID_TransactionHandler( Twid *pTwid )
+{
+    TwidTransaction *pTransaction = pTwid->pTransaction ;
+    TwidSegment *pSegment = &pTransaction->pSegments[pTransaction->current] ;
+    Twi *pTwi = pTwid->pTwi ;
+    uint32_t status ;
+
+    /* Retrieve interrupt status */
+    status = TWI_GetMaskedStatus(pTwi);
+
+    /* Slave did not acknowledge: the TWI has released the bus */
+    if (status & TWI_SR_NACK) {
+
+        pTwi->TWI_PTCR = TWI_PTCR_RXTDIS | TWI_PTCR_TXTDIS;
+        TWI_DisableIt(pTwi, 0xFFFFFFFF);
+        pTransaction->status = TWID_ERROR_NACK;
+    }
+    /* All bytes but the last received */
+    else if (status & TWI_SR_ENDRX) {
+
+        pTwi->TWI_PTCR = TWI_PTCR_RXTDIS;
+        TWI_DisableIt(pTwi, TWI_IDR_ENDRX);
+        TWI_Stop(pTwi);
+        TWI_EnableIt(pTwi, TWI_IER_RXRDY);
+        return;
+    }
+    /* Last byte received */
+    else if (TWI_STATUS_RXRDY(status)) {
+
+        pSegment->pData[pSegment->num - 1] = TWI_ReadByte(pTwi);
+        TWI_DisableIt(pTwi, TWI_IDR_RXRDY);
+        TWI_EnableIt(pTwi, TWI_IER_TXCOMP);
+        return;
+    }
+    /* All bytes written, wait for the last one to leave THR */
+    else if (status & TWI_SR_ENDTX) {
+
+        pTwi->TWI_PTCR = TWI_PTCR_TXTDIS;
+        TWI_DisableIt(pTwi, TWI_IDR_ENDTX);
+        TWI_EnableIt(pTwi, TWI_IER_TXRDY);
+        return;
+    }
+    else if (TWI_STATUS_TXRDY(status)) {
+
+        TWI_DisableIt(pTwi, TWI_IDR_TXRDY);
+        TWI_SendSTOPCondition(pTwi);
+        TWI_EnableIt(pTwi, TWI_IER_TXCOMP);
+        return;
+    }
+    /* Segment complete: start the next one back to back */
+    else if (TWI_STATUS_TXCOMP(status)) {
+
+        TWI_DisableIt(pTwi, TWI_IDR_TXCOMP | TWI_IDR_NACK);
+        if ((pTransaction->current + 1) < pTransaction->numSegments) {
+
+            pTransaction->current++;
+            TWID_StartSegment(pTwi, &pTransaction->pSegments[pTransaction->current]);
+            return;
+        }
+        pTransaction->status = 0;
+    }
+    else {
+
+        return;
+    }
+
+    /* Transaction finished or failed */
+    pTwid->pTransaction = 0;
+    PMC_ReleasePeripheral(pTwid->twiId);
+    if (pTransaction->callback) {
+
+        pTransaction->callback(pTransaction);
+    }
+}
+
 /*----------------------------------------------------------------------------
  *        Global functions
  *----------------------------------------------------------------------------*/
@@ -80,7 +212,9 @@ void TWID_Initialize(Twid *pTwid, Twi *pTwi)
 
     /* Initialize driver. */
     pTwid->pTwi = pTwi;
+    pTwid->twiId = (pTwi == TWI0) ? ID_TWI0 : ID_TWI1;
     pTwid->pTransfer = 0;
+    pTwid->pTransaction = 0;
 }
 
 
@@ -98,6 +232,12 @@ void TWID_Handler( Twid *pTwid )
 
     assert( pTwid != NULL ) ;
 
+    if ( pTwid->pTransaction ) {
+
+        TWID_TransactionHandler( pTwid ) ;
+        return ;
+    }
+
     pTransfer = (AsyncTwi*)pTwid->pTransfer ;
     assert( pTransfer != NULL ) ;
     pTwi = pTwid->pTwi ;
@@ -145,6 +285,7 @@ void TWID_Handler( Twid *pTwid )
     else if (TWI_STATUS_TXCOMP(status)) {
 
         TWI_DisableIt(pTwi, TWI_IDR_TXCOMP);
+        PMC_ReleasePeripheral(pTwid->twiId);
         pTransfer->status = 0;
         if (pTransfer->callback) {
 
@@ -188,12 +329,15 @@ uint8_t TWID_Read(
     assert( isize < 4 ) ;
 
     /* Check that no transfer is already pending*/
-    if (pTransfer) {
+    if (pTransfer || pTwid->pTransaction) {
 
         TRACE_ERROR("TWID_Read: A transfer is already pending\n\r");
         return TWID_ERROR_BUSY;
     }
 
+    /* Clock the TWI until the end of the transfer */
+    PMC_AcquirePeripheral(pTwid->twiId);
+
     /* Set STOP signal if only one byte is sent*/
     if (num == 1) {
 
@@ -246,6 +390,7 @@ uint8_t TWID_Read(
         if (timeout == TWITIMEOUTMAX) {
             TRACE_ERROR("TWID Timeout TC\n\r");
         }
+        PMC_ReleasePeripheral(pTwid->twiId);
     }
 
     return 0;
@@ -282,12 +427,15 @@ uint8_t TWID_Write(
     assert( isize < 4 ) ;
 
     /* Check that no transfer is already pending */
-    if (pTransfer) {
+    if (pTransfer || pTwid->pTransaction) {
 
         TRACE_ERROR("TWI_Write: A transfer is already pending\n\r");
         return TWID_ERROR_BUSY;
     }
 
+    /* Clock the TWI until the end of the transfer */
+    PMC_AcquirePeripheral(pTwid->twiId);
+
     /* Asynchronous transfer */
     if (pAsync) {
 
@@ -334,9 +482,63 @@ uint8_t TWID_Write(
         if (timeout == TWITIMEOUTMAX) {
             TRACE_ERROR("TWID Timeout TC2\n\r");
         }
+        PMC_ReleasePeripheral(pTwid->twiId);
+
+    }
+
+    return 0;
+}
 
+/**
+ * \brief Asynchronously executes a list of read and write segments, each
+ * one a complete access (START ... STOP) to a slave, back to back. The
+ * bytes are transferred by the PDC; the optional callback of the transaction
+ * is invoked from TWID_Handler() once all the segments are complete, or when
+ * a slave does not acknowledge.
+ * \param pTwid  Pointer to a Twid instance.
+ * \param pTransaction  Transaction to execute; it must remain valid until the
+ * transaction is finished (see its status).
+ * \return 0 if the transaction has been started; otherwise returns a TWI error code.
+ */
+uint8_t TWID_Transaction( Twid *pTwid, TwidTransaction *pTransaction )
+{
+    assert( pTwid != NULL ) ;
+    assert( pTransaction != NULL ) ;
+    assert( pTransaction->numSegments > 0 ) ;
+
+    /* Check that no transfer is already pending */
+    if (pTwid->pTransfer || pTwid->pTransaction) {
+
+        TRACE_ERROR("TWID_Transaction: A transfer is already pending\n\r");
+        return TWID_ERROR_BUSY;
     }
 
+    pTransaction->status = ASYNC_STATUS_PENDING;
+    pTransaction->current = 0;
+    pTwid->pTransaction = pTransaction;
+    PMC_AcquirePeripheral(pTwid->twiId);
+    TWID_StartSegment(pTwid->pTwi, &pTransaction->pSegments[0]);
+
     return 0;
 }
 
+/**
+ * \brief Transaction callback completing the AsyncRequest given as the
+ * transaction argument, to chain the transaction with other requests.
+ * \param pTransaction  Pointer to the finished transaction.
+ */
+void TWID_AsyncCallback( TwidTransaction *pTransaction )
+{
+    uint32_t transferred = 0;
+    uint8_t i;
+
+    for (i = 0; i < pTransaction->current; i++) {
+
+        transferred += pTransaction->pSegments[i].num;
+    }
+    if (pTransaction->status == 0) {
+
+        transferred += pTransaction->pSegments[pTransaction->current].num;
+    }
+    ASYNC_Complete((AsyncRequest *)pTransaction->pArgument, pTransaction->status, transferred);
+}
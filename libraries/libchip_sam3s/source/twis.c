@@ -0,0 +1,425 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \addtogroup twis_module TWI slave register-file driver
+ *
+ * The TWI slave driver makes a memory buffer, the register file, readable and
+ * writable by a TWI master, like a serial EEPROM or a sensor register map.
+ *
+ * Only the register address phase is handled by the interrupt handler: the
+ * data bytes are moved by the PDC from and to the register file, so the
+ * master is not held by clock stretching while it reads or writes a block.
+ * A master write sets the register pointer with 1 or 2 address bytes (MSB
+ * first) followed by the data; a master read returns the registers from the
+ * pointer on. Both wrap at the end of the register file.
+ *
+ * \section Usage
+ * <ul>
+ * <li> Configure the TWI pins, then initialize the driver with
+ *    TWIS_Configure().</li>
+ * <li> Call TWIS_Handler() from the TWI interrupt handler, and enable the TWI
+ *    interrupt in the NVIC.</li>
+ * <li> The changes made by the master are reported once per write access to
+ *    the callback set with TWIS_SetCallback(), and accumulated for
+ *    TWIS_GetChanges() so a main loop can process several writes at once.</li>
+ * </ul>
+ *
+ * \note The PDC loads one byte in advance when the master reads; that byte is
+ * dropped by the NACK of the master, and not counted in the register pointer.
+ * The first byte of a read is loaded from the interrupt handler, which holds
+ * the clock for the time of the interrupt latency.
+ *
+ * Related files :\n
+ * \ref twis.c\n
+ * \ref twis.h.\n
+ */
+/*@{*/
+/*@}*/
+
+/**
+ * \file
+ *
+ * Implementation of the TWI slave register-file driver.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "chip.h"
+
+#include <assert.h>
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Programs a PDC channel to go through the whole register file, from
+ * the register pointer to the end and then from the start to the pointer.
+ * \param pTwis  Pointer to a Twis instance.
+ * \param pdwPdc  Pointer to the PR register of the channel; CR follows it,
+ * and NPR, NCR are 0x10 bytes further.
+ */
+static void _ArmPdc( Twis* pTwis, volatile uint32_t* pdwPdc )
+{
+    uint32_t dwPointer = pTwis->dwPointer ;
+
+    pdwPdc[0] = (uint32_t)&pTwis->pRegs[dwPointer] ;
+    pdwPdc[1] = pTwis->dwSize - dwPointer ;
+    pdwPdc[4] = (uint32_t)pTwis->pRegs ;
+    pdwPdc[5] = dwPointer ;
+}
+
+/**
+ * \brief Returns the number of bytes moved by a PDC channel programmed with
+ * _ArmPdc().
+ * \param pTwis  Pointer to a Twis instance.
+ * \param pdwPdc  Pointer to the PR register of the channel.
+ */
+static uint32_t _GetPdcCount( Twis* pTwis, volatile uint32_t* pdwPdc )
+{
+    return pTwis->dwWrapped + pTwis->dwSize - pdwPdc[1] - pdwPdc[5] ;
+}
+
+/**
+ * \brief Starts a master write, once the register address has been received.
+ * \param pTwis  Pointer to a Twis instance.
+ */
+static void _StartWrite( Twis* pTwis )
+{
+    Twi* pTwi = pTwis->pTwi ;
+    uint32_t dwAddress ;
+
+    dwAddress = pTwis->abAddress[0] ;
+    if ( pTwis->isize == 2 )
+    {
+        dwAddress = (dwAddress << 8) | pTwis->abAddress[1] ;
+    }
+    pTwis->dwPointer = dwAddress % pTwis->dwSize ;
+    pTwis->dwWrapped = 0 ;
+
+    _ArmPdc( pTwis, &pTwi->TWI_RPR ) ;
+    pTwi->TWI_IDR = TWI_IDR_ENDRX ;
+    pTwi->TWI_IER = TWI_IER_RXBUFF ;
+    pTwis->state = TWIS_STATE_WRITE ;
+}
+
+/**
+ * \brief Ends a master write: updates the register pointer and the changed
+ * registers, and invokes the callback.
+ * \param pTwis  Pointer to a Twis instance.
+ */
+static void _EndWrite( Twis* pTwis )
+{
+    Twi* pTwi = pTwis->pTwi ;
+    uint32_t dwStart = pTwis->dwPointer ;
+    uint32_t dwOffset = dwStart ;
+    uint32_t dwLength ;
+    uint32_t dwEnd ;
+
+    pTwi->TWI_PTCR = TWI_PTCR_RXTDIS ;
+    pTwi->TWI_IDR = TWI_IDR_RXBUFF ;
+    pTwis->state = TWIS_STATE_IDLE ;
+
+    dwLength = _GetPdcCount( pTwis, &pTwi->TWI_RPR ) ;
+    if ( dwLength == 0 )
+    {
+        /* Register pointer set for a read */
+        return ;
+    }
+    pTwis->dwPointer = (dwOffset + dwLength) % pTwis->dwSize ;
+
+    /* Merge in the changed registers, a wrapping range marks all */
+    dwEnd = dwOffset + dwLength ;
+    if ( dwEnd > pTwis->dwSize )
+    {
+        dwOffset = 0 ;
+        dwEnd = pTwis->dwSize ;
+    }
+    if ( pTwis->dwDirtyEnd == 0 )
+    {
+        pTwis->dwDirtyFirst = dwOffset ;
+        pTwis->dwDirtyEnd = dwEnd ;
+    }
+    else
+    {
+        if ( dwOffset < pTwis->dwDirtyFirst )
+        {
+            pTwis->dwDirtyFirst = dwOffset ;
+        }
+        if ( dwEnd > pTwis->dwDirtyEnd )
+        {
+            pTwis->dwDirtyEnd = dwEnd ;
+        }
+    }
+
+    if ( pTwis->callback )
+    {
+        pTwis->callback( pTwis, dwStart, dwLength ) ;
+    }
+}
+
+/**
+ * \brief Starts a master read from the register pointer.
+ * \param pTwis  Pointer to a Twis instance.
+ */
+static void _StartRead( Twis* pTwis )
+{
+    Twi* pTwi = pTwis->pTwi ;
+
+    pTwis->dwWrapped = 0 ;
+    _ArmPdc( pTwis, &pTwi->TWI_TPR ) ;
+    pTwi->TWI_PTCR = TWI_PTCR_TXTEN ;
+    pTwi->TWI_IDR = TWI_IDR_SCL_WS ;
+    pTwi->TWI_IER = TWI_IER_TXBUFE ;
+    pTwis->state = TWIS_STATE_READ ;
+}
+
+/**
+ * \brief Ends a master read, and advances the register pointer.
+ * \param pTwis  Pointer to a Twis instance.
+ */
+static void _EndRead( Twis* pTwis )
+{
+    Twi* pTwi = pTwis->pTwi ;
+    uint32_t dwLength ;
+
+    pTwi->TWI_PTCR = TWI_PTCR_TXTDIS ;
+    pTwi->TWI_IDR = TWI_IDR_TXBUFE ;
+    pTwis->state = TWIS_STATE_IDLE ;
+
+    /* The byte loaded after the last one acknowledged is dropped */
+    dwLength = _GetPdcCount( pTwis, &pTwi->TWI_TPR ) ;
+    if ( dwLength )
+    {
+        pTwis->dwPointer = (pTwis->dwPointer + dwLength - 1) % pTwis->dwSize ;
+    }
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initializes the driver and configures the TWI in slave mode.
+ *
+ * The TWI clock stays enabled until TWIS_Stop().
+ * \param pTwis  Pointer to a Twis instance.
+ * \param pTwi  TWI peripheral.
+ * \param twiId  TWI peripheral identifier.
+ * \param address  Slave address on the TWI bus.
+ * \param isize  Register address size in bytes, 1 or 2.
+ * \param pRegs  Register file.
+ * \param dwSize  Register file size in bytes.
+ * \return 0 if successful; otherwise returns TWIS_ERROR_PARAM.
+ */
+extern uint32_t TWIS_Configure( Twis* pTwis, Twi* pTwi, uint8_t twiId, uint8_t address,
+                                uint8_t isize, uint8_t* pRegs, uint32_t dwSize )
+{
+    if ( isize < 1 || isize > 2 || pRegs == 0 || dwSize == 0 )
+    {
+        TRACE_ERROR( "TWIS_Configure: invalid register file\n\r" ) ;
+
+        return TWIS_ERROR_PARAM ;
+    }
+
+    pTwis->pTwi = pTwi ;
+    pTwis->twiId = twiId ;
+    pTwis->isize = isize ;
+    pTwis->state = TWIS_STATE_IDLE ;
+    pTwis->pRegs = pRegs ;
+    pTwis->dwSize = dwSize ;
+    pTwis->dwPointer = 0 ;
+    pTwis->dwWrapped = 0 ;
+    pTwis->dwDirtyFirst = 0 ;
+    pTwis->dwDirtyEnd = 0 ;
+    pTwis->callback = 0 ;
+    pTwis->pArgument = 0 ;
+
+    PMC_EnablePeripheral( twiId ) ;
+
+    pTwi->TWI_IDR = 0xFFFFFFFF ;
+    pTwi->TWI_PTCR = TWI_PTCR_RXTDIS | TWI_PTCR_TXTDIS ;
+    TWI_ConfigureSlave( pTwi, address ) ;
+
+    /* Clear receipt buffer */
+    pTwi->TWI_RHR ;
+
+    pTwi->TWI_IER = TWI_IER_SVACC ;
+
+    return 0 ;
+}
+
+/**
+ * \brief Sets the function invoked at the end of each master write.
+ * \param pTwis  Pointer to a Twis instance.
+ * \param callback  Callback, invoked from TWIS_Handler(), or 0.
+ * \param pArgument  Argument stored in pTwis->pArgument.
+ */
+extern void TWIS_SetCallback( Twis* pTwis, TwisCallback callback, void* pArgument )
+{
+    uint32_t dwPrimask ;
+
+    dwPrimask = __get_PRIMASK() ;
+    __disable_irq() ;
+    pTwis->callback = callback ;
+    pTwis->pArgument = pArgument ;
+    __set_PRIMASK( dwPrimask ) ;
+}
+
+/**
+ * \brief TWI slave interrupt handler. Must be called by the TWI interrupt
+ * handler of the application.
+ * \param pTwis  Pointer to a Twis instance.
+ */
+IRQ_RAMFUNC extern void TWIS_Handler( Twis* pTwis )
+{
+    Twi* pTwi = pTwis->pTwi ;
+    uint32_t dwSr ;
+    uint32_t dwStatus ;
+
+    /* EOSACC and NACK are cleared on read */
+    dwSr = pTwi->TWI_SR ;
+    dwStatus = dwSr & pTwi->TWI_IMR ;
+
+    /* Start of an access */
+    if ( (dwStatus & TWI_SR_SVACC) && pTwis->state == TWIS_STATE_IDLE )
+    {
+        pTwi->TWI_IDR = TWI_IDR_SVACC ;
+        pTwi->TWI_IER = TWI_IER_EOSACC ;
+        if ( dwSr & TWI_SR_SVREAD )
+        {
+            _StartRead( pTwis ) ;
+        }
+        else
+        {
+            /* Receive the register address, then let the ISR move the PDC to the registers */
+            pTwi->TWI_RPR = (uint32_t)pTwis->abAddress ;
+            pTwi->TWI_RCR = pTwis->isize ;
+            pTwi->TWI_RNCR = 0 ;
+            pTwi->TWI_PTCR = TWI_PTCR_RXTEN ;
+            pTwi->TWI_IER = TWI_IER_ENDRX | TWI_IER_SCL_WS ;
+            pTwis->state = TWIS_STATE_ADDRESS ;
+        }
+    }
+
+    /* Register address received */
+    if ( (dwStatus & TWI_SR_ENDRX) && pTwis->state == TWIS_STATE_ADDRESS )
+    {
+        _StartWrite( pTwis ) ;
+    }
+
+    /* The whole register file was transferred, go on around it */
+    if ( (dwStatus & TWI_SR_RXBUFF) && pTwis->state == TWIS_STATE_WRITE )
+    {
+        pTwis->dwWrapped += pTwis->dwSize ;
+        _ArmPdc( pTwis, &pTwi->TWI_RPR ) ;
+    }
+    if ( (dwStatus & TWI_SR_TXBUFE) && pTwis->state == TWIS_STATE_READ )
+    {
+        pTwis->dwWrapped += pTwis->dwSize ;
+        _ArmPdc( pTwis, &pTwi->TWI_TPR ) ;
+    }
+
+    /* Repeated START for a read: the slave holds the clock until data is loaded */
+    if ( (dwStatus & TWI_SR_SCLWS) && (dwSr & TWI_SR_SVREAD) && pTwis->state != TWIS_STATE_READ )
+    {
+        if ( pTwis->state == TWIS_STATE_WRITE )
+        {
+            _EndWrite( pTwis ) ;
+        }
+        else
+        {
+            pTwi->TWI_PTCR = TWI_PTCR_RXTDIS ;
+            pTwi->TWI_IDR = TWI_IDR_ENDRX ;
+        }
+        _StartRead( pTwis ) ;
+    }
+
+    /* STOP, or START for another slave */
+    if ( dwStatus & TWI_SR_EOSACC )
+    {
+        if ( pTwis->state == TWIS_STATE_WRITE )
+        {
+            _EndWrite( pTwis ) ;
+        }
+        else
+        {
+            if ( pTwis->state == TWIS_STATE_READ )
+            {
+                _EndRead( pTwis ) ;
+            }
+        }
+        pTwi->TWI_PTCR = TWI_PTCR_RXTDIS | TWI_PTCR_TXTDIS ;
+        pTwi->TWI_IDR = 0xFFFFFFFF ;
+        pTwi->TWI_IER = TWI_IER_SVACC ;
+        pTwis->state = TWIS_STATE_IDLE ;
+    }
+}
+
+/**
+ * \brief Returns the range of registers written by the master since the last
+ * call, and clears it.
+ * \param pTwis  Pointer to a Twis instance.
+ * \param pdwOffset  Receives the offset of the first register written.
+ * \return Number of registers in the range, 0 if none was written.
+ */
+extern uint32_t TWIS_GetChanges( Twis* pTwis, uint32_t* pdwOffset )
+{
+    uint32_t dwPrimask ;
+    uint32_t dwLength ;
+
+    dwPrimask = __get_PRIMASK() ;
+    __disable_irq() ;
+    *pdwOffset = pTwis->dwDirtyFirst ;
+    dwLength = pTwis->dwDirtyEnd - pTwis->dwDirtyFirst ;
+    pTwis->dwDirtyFirst = 0 ;
+    pTwis->dwDirtyEnd = 0 ;
+    __set_PRIMASK( dwPrimask ) ;
+
+    return dwLength ;
+}
+
+/**
+ * \brief Disables the TWI slave and its clock.
+ * \param pTwis  Pointer to a Twis instance.
+ */
+extern void TWIS_Stop( Twis* pTwis )
+{
+    Twi* pTwi = pTwis->pTwi ;
+
+    pTwi->TWI_IDR = 0xFFFFFFFF ;
+    pTwi->TWI_PTCR = TWI_PTCR_RXTDIS | TWI_PTCR_TXTDIS ;
+    pTwi->TWI_CR = TWI_CR_SVDIS ;
+    pTwis->state = TWIS_STATE_IDLE ;
+
+    PMC_DisablePeripheral( pTwis->twiId ) ;
+}
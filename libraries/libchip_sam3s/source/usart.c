@@ -407,3 +407,179 @@ uint8_t USART_GetChar(Usart *usart)
     while ((usart->US_CSR & US_CSR_RXRDY) == 0);
     return usart->US_RHR;
 }
+
+/**
+ * \brief Starts the continuous reception of an USART in a circular buffer.
+ * USART_RingHandler must then be called from the USART interrupt, whose
+ * latency must stay below the reception time of half the buffer.
+ *
+ * \param pRing  Pointer to the UsartRing instance to initialize.
+ * \param usart  Pointer to an USART peripheral, its receiver enabled.
+ * \param pBuffer  Circular buffer.
+ * \param size  Size of the buffer in bytes (even).
+ * \param timeout  Receiver time-out in bit periods ending a frame (US_RTOR),
+ * 0 to disable the framing.
+ */
+void USART_RingStart( UsartRing *pRing, Usart *usart, uint8_t *pBuffer, uint32_t size, uint32_t timeout )
+{
+    assert( pRing != NULL ) ;
+    assert( (size >= 2) && ((size & 1) == 0) ) ;
+
+    pRing->pUsart = usart ;
+    pRing->pBuffer = pBuffer ;
+    pRing->bankSize = size / 2 ;
+    pRing->banks = 0 ;
+    pRing->frameEnd = 0 ;
+    pRing->consumed = 0 ;
+    pRing->overruns = 0 ;
+
+    /* Both PDC banks cover the buffer */
+    usart->US_PTCR = US_PTCR_RXTDIS ;
+    usart->US_RPR = (uint32_t)pBuffer ;
+    usart->US_RCR = pRing->bankSize ;
+    usart->US_RNPR = (uint32_t)(pBuffer + pRing->bankSize) ;
+    usart->US_RNCR = pRing->bankSize ;
+    usart->US_PTCR = US_PTCR_RXTEN ;
+
+    /* The time-out counter is started by the next character received */
+    usart->US_RTOR = US_RTOR_TO( timeout ) ;
+    if ( timeout )
+    {
+        usart->US_CR = US_CR_STTTO ;
+        usart->US_IER = US_IER_ENDRX | US_IER_TIMEOUT ;
+    }
+    else
+    {
+        usart->US_IER = US_IER_ENDRX ;
+    }
+}
+
+/**
+ * \brief Stops the continuous reception of an USART.
+ *
+ * \param pRing  Pointer to an UsartRing instance.
+ */
+void USART_RingStop( UsartRing *pRing )
+{
+    Usart *usart = pRing->pUsart ;
+
+    usart->US_IDR = US_IDR_ENDRX | US_IDR_TIMEOUT ;
+    usart->US_PTCR = US_PTCR_RXTDIS ;
+    usart->US_RTOR = 0 ;
+}
+
+/**
+ * \brief Interrupt handler of the continuous reception: re-arms the PDC next
+ * bank with the bank just filled, and records the end of the frames.
+ *
+ * \param pRing  Pointer to an UsartRing instance.
+ */
+void USART_RingHandler( UsartRing *pRing )
+{
+    Usart *usart = pRing->pUsart ;
+    uint32_t status = usart->US_CSR & usart->US_IMR ;
+
+    /* A bank full: the PDC switched to the next one */
+    if ( status & US_CSR_ENDRX )
+    {
+        pRing->banks++ ;
+        usart->US_RNPR = (uint32_t)(pRing->pBuffer + ((pRing->banks + 1) & 1) * pRing->bankSize) ;
+        usart->US_RNCR = pRing->bankSize ;
+    }
+
+    /* Line idle after a character: end of frame */
+    if ( status & US_CSR_TIMEOUT )
+    {
+        pRing->frameEnd = USART_RingGetReceived( pRing ) ;
+        usart->US_CR = US_CR_STTTO ;
+        if ( pRing->callback )
+        {
+            pRing->callback( pRing ) ;
+        }
+    }
+}
+
+/**
+ * \brief Returns the number of bytes received since USART_RingStart (free
+ * running counter).
+ *
+ * \param pRing  Pointer to an UsartRing instance.
+ */
+uint32_t USART_RingGetReceived( UsartRing *pRing )
+{
+    uint32_t banks ;
+    uint32_t remaining ;
+
+    /* Consistent bank count and PDC counter */
+    do
+    {
+        banks = pRing->banks ;
+        remaining = pRing->pUsart->US_RCR ;
+    } while ( banks != pRing->banks ) ;
+
+    return banks * pRing->bankSize + (pRing->bankSize - remaining) ;
+}
+
+/**
+ * \brief Returns the data received and not consumed yet, in place: the
+ * size returned is the contiguous part, up to the end of the buffer. Data
+ * overwritten before it was consumed is skipped and counted in overruns.
+ *
+ * \param pRing  Pointer to an UsartRing instance.
+ * \param ppData  Set to the first byte not consumed.
+ * \return Number of contiguous bytes available at *ppData.
+ */
+uint32_t USART_RingPeek( UsartRing *pRing, uint8_t **ppData )
+{
+    uint32_t size = 2 * pRing->bankSize ;
+    uint32_t received = USART_RingGetReceived( pRing ) ;
+    uint32_t offset ;
+    uint32_t available ;
+
+    /* The buffer only holds the last bytes received */
+    if ( (received - pRing->consumed) > size )
+    {
+        pRing->overruns += received - size - pRing->consumed ;
+        pRing->consumed = received - size ;
+    }
+
+    offset = pRing->consumed % size ;
+    available = received - pRing->consumed ;
+    if ( available > (size - offset) )
+    {
+        available = size - offset ;
+    }
+    *ppData = &(pRing->pBuffer[offset]) ;
+
+    return available ;
+}
+
+/**
+ * \brief Releases the space of bytes returned by USART_RingPeek.
+ *
+ * \param pRing  Pointer to an UsartRing instance.
+ * \param size  Number of bytes consumed.
+ */
+void USART_RingConsume( UsartRing *pRing, uint32_t size )
+{
+    pRing->consumed += size ;
+}
+
+/**
+ * \brief Returns the number of bytes not consumed up to the end of the last
+ * frame, 0 if no complete frame is pending.
+ *
+ * \param pRing  Pointer to an UsartRing instance.
+ */
+uint32_t USART_RingGetFrameSize( UsartRing *pRing )
+{
+    uint32_t size = pRing->frameEnd - pRing->consumed ;
+
+    /* Frame end already consumed */
+    if ( size > 2 * pRing->bankSize )
+    {
+        return 0 ;
+    }
+
+    return size ;
+}
@@ -0,0 +1,386 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Implementation of the warm wake from backup mode.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "chip.h"
+
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Backup register header: magic in the upper half, page sequence in the lower half */
+#define WARMBOOT_GPBR_MAGIC     0x5742u
+/** Flash page magic */
+#define WARMBOOT_PAGE_MAGIC     0x57415250u
+
+/** RSTC_SR RSTTYP of a wake-up from backup mode */
+#define WARMBOOT_RSTTYP_BACKUP  (1u << RSTC_SR_RSTTYP_Pos)
+
+/** Bytes before the data of a record: tag and size */
+#define WARMBOOT_RECORD_HEADER  2
+
+/** Flash page of the records */
+typedef struct _WarmPage
+{
+    uint32_t dwMagic ;
+    /** 1 to 0xFFFF */
+    uint32_t dwSequence ;
+    /** Bytes used in aucRecords */
+    uint32_t dwLength ;
+    /** CRC-32 of the used bytes of aucRecords */
+    uint32_t dwCrc ;
+    /** Records: tag, size, then size bytes of data */
+    uint8_t aucRecords[IFLASH_PAGE_SIZE - 16] ;
+} WarmPage ;
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** RAM image of the records */
+static WarmPage _sPage ;
+/** Application word */
+static uint32_t _dwWord = 0 ;
+/** 1 after a warm boot */
+static uint32_t _dwWarm = 0 ;
+/** Seconds spent in backup mode */
+static uint32_t _dwElapsed = 0 ;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief CRC-32 (zlib crc32() polynomial) of a buffer.
+ */
+static uint32_t _Crc32( const uint8_t* pucData, uint32_t dwSize )
+{
+    uint32_t dwCrc = 0xFFFFFFFFu ;
+    uint32_t dwBit ;
+
+    while ( dwSize-- )
+    {
+        dwCrc ^= *pucData++ ;
+        for ( dwBit = 0 ; dwBit < 8 ; dwBit++ )
+        {
+            dwCrc = (dwCrc >> 1) ^ (0xEDB88320u & (0u - (dwCrc & 1))) ;
+        }
+    }
+
+    return ~dwCrc ;
+}
+
+/**
+ * \brief Tells whether a page holds valid records.
+ */
+static uint32_t _IsPageValid( const WarmPage* pPage )
+{
+    return (pPage->dwMagic == WARMBOOT_PAGE_MAGIC)
+        && (pPage->dwLength <= sizeof( pPage->aucRecords ))
+        && (pPage->dwCrc == _Crc32( pPage->aucRecords, pPage->dwLength )) ;
+}
+
+/**
+ * \brief Looks for a record of the RAM image.
+ *
+ * \return Offset of the record in aucRecords, or _sPage.dwLength if none.
+ */
+static uint32_t _Find( uint32_t dwTag )
+{
+    uint32_t dwOffset = 0 ;
+
+    while ( (dwOffset < _sPage.dwLength) && (_sPage.aucRecords[dwOffset] != dwTag) )
+    {
+        dwOffset += WARMBOOT_RECORD_HEADER + _sPage.aucRecords[dwOffset + 1] ;
+    }
+
+    return dwOffset ;
+}
+
+/**
+ * \brief Reads the RTC as seconds since 2000-01-01.
+ */
+static uint32_t _GetRtcSeconds( void )
+{
+    uint16_t wYear ;
+    uint8_t ucMonth, ucDay, ucWeek ;
+    uint8_t ucHour, ucMinute, ucSecond ;
+    uint8_t ucHourAfter, ucMinuteAfter, ucSecondAfter ;
+    uint32_t dwYears ;
+    uint32_t dwDays ;
+
+    /* Read the date again if the time wrapped at midnight meanwhile */
+    do
+    {
+        RTC_GetTime( RTC, &ucHour, &ucMinute, &ucSecond ) ;
+        RTC_GetDate( RTC, &wYear, &ucMonth, &ucDay, &ucWeek ) ;
+        RTC_GetTime( RTC, &ucHourAfter, &ucMinuteAfter, &ucSecondAfter ) ;
+    } while ( ucHourAfter < ucHour ) ;
+
+    /* Days from 1600-03-01, years starting in March so that the leap day ends
+     * them, then from 2000-01-01 */
+    if ( ucMonth <= 2 )
+    {
+        wYear-- ;
+        ucMonth += 12 ;
+    }
+    dwYears = wYear - 1600 ;
+    dwDays = 365u*dwYears + dwYears/4 - dwYears/100 + dwYears/400
+           + (153u*(ucMonth - 3) + 2)/5 + ucDay - 1 - 146037u ;
+
+    return ((dwDays*24 + ucHour)*60 + ucMinute)*60 + ucSecond ;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Checks whether the chip wakes up from backup mode with a checkpoint,
+ * and loads it.
+ *
+ * To be called once, early at boot. The checkpoint is consumed: the next
+ * wake-up is warm only if \ref WARMBOOT_Save() is called again.
+ *
+ * \return 1 on a warm boot, 0 on a cold boot (the records are then empty).
+ */
+extern uint32_t WARMBOOT_Restore( void )
+{
+    volatile uint32_t* pdwGpbr = &GPBR->SYS_GPBR4 ;
+    const WarmPage* pFlash = (const WarmPage*)WARMBOOT_FLASH_ADDR ;
+    uint32_t dwHeader = pdwGpbr[0] ;
+
+    _dwWarm = 0 ;
+    _dwElapsed = 0 ;
+    _dwWord = 0 ;
+    _sPage.dwLength = 0 ;
+
+    if ( ((RSTC->RSTC_SR & RSTC_SR_RSTTYP_Msk) != WARMBOOT_RSTTYP_BACKUP)
+      || ((dwHeader >> 16) != WARMBOOT_GPBR_MAGIC) )
+    {
+        return 0 ;
+    }
+
+    pdwGpbr[0] = 0 ;
+
+    /* The page must be the one saved along with the registers */
+    if ( !_IsPageValid( pFlash ) || (pFlash->dwSequence != (dwHeader & 0xFFFFu)) )
+    {
+        return 0 ;
+    }
+
+    memcpy( &_sPage, pFlash, sizeof( _sPage ) ) ;
+    _dwElapsed = _GetRtcSeconds() - pdwGpbr[1] ;
+    _dwWord = pdwGpbr[2] ;
+    _dwWarm = 1 ;
+
+    return 1 ;
+}
+
+/**
+ * \brief Tells whether the last \ref WARMBOOT_Restore() found a checkpoint.
+ */
+extern uint32_t WARMBOOT_IsWarm( void )
+{
+    return _dwWarm ;
+}
+
+/**
+ * \brief Reads a record.
+ *
+ * \param dwTag   Record tag.
+ * \param pvData  Buffer for the record data.
+ * \param dwSize  Buffer size, the data beyond are not copied.
+ *
+ * \return Size of the record, 0 if there is none.
+ */
+extern uint32_t WARMBOOT_Get( uint32_t dwTag, void* pvData, uint32_t dwSize )
+{
+    uint32_t dwOffset = _Find( dwTag ) ;
+    uint32_t dwRecord ;
+
+    if ( dwOffset >= _sPage.dwLength )
+    {
+        return 0 ;
+    }
+
+    dwRecord = _sPage.aucRecords[dwOffset + 1] ;
+    memcpy( pvData, &_sPage.aucRecords[dwOffset + WARMBOOT_RECORD_HEADER], (dwSize < dwRecord) ? dwSize : dwRecord ) ;
+
+    return dwRecord ;
+}
+
+/**
+ * \brief Adds or replaces a record, in RAM until \ref WARMBOOT_Save().
+ *
+ * \param dwTag   Record tag, 1 to 255.
+ * \param pvData  Record data.
+ * \param dwSize  Size of the data, up to WARMBOOT_MAX_RECORD bytes.
+ *
+ * \return WARMBOOT_OK, WARMBOOT_ERROR_TAG or WARMBOOT_ERROR_SIZE.
+ */
+extern uint32_t WARMBOOT_Set( uint32_t dwTag, const void* pvData, uint32_t dwSize )
+{
+    uint32_t dwOffset ;
+    uint32_t dwRecord ;
+
+    if ( (dwTag == 0) || (dwTag > 0xFF) )
+    {
+        return WARMBOOT_ERROR_TAG ;
+    }
+
+    if ( dwSize > WARMBOOT_MAX_RECORD )
+    {
+        return WARMBOOT_ERROR_SIZE ;
+    }
+
+    /* Same size: overwritten in place, else removed and appended */
+    dwOffset = _Find( dwTag ) ;
+    if ( dwOffset < _sPage.dwLength )
+    {
+        dwRecord = WARMBOOT_RECORD_HEADER + _sPage.aucRecords[dwOffset + 1] ;
+        if ( dwRecord == WARMBOOT_RECORD_HEADER + dwSize )
+        {
+            memcpy( &_sPage.aucRecords[dwOffset + WARMBOOT_RECORD_HEADER], pvData, dwSize ) ;
+
+            return WARMBOOT_OK ;
+        }
+
+        memmove( &_sPage.aucRecords[dwOffset], &_sPage.aucRecords[dwOffset + dwRecord], _sPage.dwLength - dwOffset - dwRecord ) ;
+        _sPage.dwLength -= dwRecord ;
+    }
+
+    if ( _sPage.dwLength + WARMBOOT_RECORD_HEADER + dwSize > sizeof( _sPage.aucRecords ) )
+    {
+        return WARMBOOT_ERROR_SIZE ;
+    }
+
+    _sPage.aucRecords[_sPage.dwLength] = dwTag ;
+    _sPage.aucRecords[_sPage.dwLength + 1] = dwSize ;
+    memcpy( &_sPage.aucRecords[_sPage.dwLength + WARMBOOT_RECORD_HEADER], pvData, dwSize ) ;
+    _sPage.dwLength += WARMBOOT_RECORD_HEADER + dwSize ;
+
+    return WARMBOOT_OK ;
+}
+
+/**
+ * \brief Returns the application word of the checkpoint, 0 on a cold boot.
+ */
+extern uint32_t WARMBOOT_GetWord( void )
+{
+    return _dwWord ;
+}
+
+/**
+ * \brief Sets the application word, kept in a backup register: for a value
+ * changing at every wake-up, e.g. a sample counter, that would otherwise
+ * cause a flash program at every save.
+ */
+extern void WARMBOOT_SetWord( uint32_t dwValue )
+{
+    _dwWord = dwValue ;
+}
+
+/**
+ * \brief Returns the seconds spent in backup mode, measured with the RTC,
+ * 0 on a cold boot.
+ */
+extern uint32_t WARMBOOT_GetElapsed( void )
+{
+    return _dwElapsed ;
+}
+
+/**
+ * \brief Saves the checkpoint, to be called just before entering backup mode.
+ *
+ * The flash page is programmed only if the records differ from the ones it
+ * holds. The backup registers are written last, a save interrupted by a reset
+ * thus leaves no checkpoint.
+ *
+ * \return WARMBOOT_OK or WARMBOOT_ERROR_FLASH.
+ */
+extern uint32_t WARMBOOT_Save( void )
+{
+    volatile uint32_t* pdwGpbr = &GPBR->SYS_GPBR4 ;
+    const WarmPage* pFlash = (const WarmPage*)WARMBOOT_FLASH_ADDR ;
+    uint32_t dwSequence = 0 ;
+
+    pdwGpbr[0] = 0 ;
+
+    _sPage.dwMagic = WARMBOOT_PAGE_MAGIC ;
+    _sPage.dwCrc = _Crc32( _sPage.aucRecords, _sPage.dwLength ) ;
+
+    if ( _IsPageValid( pFlash ) )
+    {
+        dwSequence = pFlash->dwSequence ;
+    }
+
+    if ( (dwSequence == 0) || (pFlash->dwLength != _sPage.dwLength)
+      || (memcmp( pFlash->aucRecords, _sPage.aucRecords, _sPage.dwLength ) != 0) )
+    {
+        dwSequence = (dwSequence & 0xFFFFu) + 1 ;
+        if ( dwSequence > 0xFFFFu )
+        {
+            dwSequence = 1 ;
+        }
+        _sPage.dwSequence = dwSequence ;
+
+        if ( (FLASHD_Write( WARMBOOT_FLASH_ADDR, &_sPage, sizeof( _sPage ) ) != 0)
+          || (memcmp( pFlash, &_sPage, sizeof( _sPage ) ) != 0) )
+        {
+            return WARMBOOT_ERROR_FLASH ;
+        }
+    }
+    _sPage.dwSequence = dwSequence ;
+
+    pdwGpbr[1] = _GetRtcSeconds() ;
+    pdwGpbr[2] = _dwWord ;
+    pdwGpbr[0] = (WARMBOOT_GPBR_MAGIC << 16) | dwSequence ;
+
+    return WARMBOOT_OK ;
+}
+
+/**
+ * \brief Makes the next wake-up from backup mode boot cold.
+ */
+extern void WARMBOOT_Invalidate( void )
+{
+    GPBR->SYS_GPBR4 = 0 ;
+}
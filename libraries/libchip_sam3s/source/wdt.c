@@ -52,6 +52,17 @@
  * <li>Restart the watchdog using \ref WDT_Restart() within the watchdog period.
  * </ul>
  *
+ * Under an RTOS, the supervisor restarts the watchdog on behalf of the tasks:
+ * <ul>
+ * <li>Each task registers a heartbeat with \ref WDT_SupervisorRegister() and
+ * calls \ref WDT_SupervisorBeat() in its loop.
+ * <li>\ref WDT_SupervisorStart() arms the post-mortem record, then
+ * \ref WDT_SupervisorCheck() is called at a low rate and restarts the
+ * watchdog only while all the heartbeats meet their deadlines.
+ * <li>After reset, \ref WDT_SupervisorGetPostMortem() returns the reset cause
+ * and the late task, kept in the general purpose backup registers.
+ * </ul>
+ *
  * For more accurate information, please look at the WDT section of the
  * Datasheet.
  *
@@ -72,6 +83,7 @@
 #include "chip.h"
 
 #include <stdint.h>
+#include <assert.h>
 
 /*----------------------------------------------------------------------------
  *        Exported functions
@@ -130,3 +142,198 @@ extern uint32_t WDT_GetPeriod( uint32_t dwMs )
     }
     return ((dwMs << 8) / 1000) ;
 }
+
+/*----------------------------------------------------------------------------
+ *        Supervisor
+ *----------------------------------------------------------------------------*/
+
+/** Marks a post-mortem record in the backup registers ("WDPM") */
+#define WDT_POSTMORTEM_MAGIC  0x5744504Du
+
+/** Reset command key of the RSTC */
+#define WDT_RSTC_KEY          0xA5u
+
+/** Registered heartbeats, in registration order */
+static WdtHeartbeat* _pHeartbeats = NULL ;
+
+/** Number of registered heartbeats */
+static uint32_t _dwHeartbeats = 0 ;
+
+/** Supervisor checks since the start */
+static uint32_t _dwChecks = 0 ;
+
+/**
+ * \brief Register a heartbeat with the supervisor.
+ *
+ * The task owning it must call \ref WDT_SupervisorBeat() at least once every
+ * dwMaxChecks calls of \ref WDT_SupervisorCheck(). Heartbeats are registered
+ * at initialization, before the checks start.
+ *
+ * \param pHeartbeat   Heartbeat, kept by the supervisor
+ * \param pszName      Name of the task, for traces
+ * \param dwMaxChecks  Deadline, in supervisor checks
+ *
+ * \return Index of the heartbeat, reported by \ref WDT_SupervisorGetPostMortem().
+ */
+extern uint32_t WDT_SupervisorRegister( WdtHeartbeat* pHeartbeat, const char* pszName, uint32_t dwMaxChecks )
+{
+    WdtHeartbeat** ppLast = &_pHeartbeats ;
+
+    pHeartbeat->pNext = NULL ;
+    pHeartbeat->pszName = pszName ;
+    pHeartbeat->dwMaxChecks = dwMaxChecks ;
+    pHeartbeat->dwBeats = 0 ;
+    pHeartbeat->dwSeen = 0 ;
+    pHeartbeat->dwMissed = 0 ;
+
+    while ( *ppLast != NULL )
+    {
+        ppLast = &(*ppLast)->pNext ;
+    }
+    *ppLast = pHeartbeat ;
+
+    return _dwHeartbeats++ ;
+}
+
+/**
+ * \brief Report that a supervised task is alive. Only the owning task writes
+ * its heartbeat, so no locking is needed.
+ *
+ * \param pHeartbeat   Heartbeat registered with \ref WDT_SupervisorRegister()
+ */
+extern void WDT_SupervisorBeat( WdtHeartbeat* pHeartbeat )
+{
+    pHeartbeat->dwBeats++ ;
+}
+
+/**
+ * \brief Arm the post-mortem record in the backup registers.
+ *
+ * From now on, a reset without a supervisor record (watchdog fired because
+ * the checks stopped, user reset...) is reported with WDT_SUPERVISOR_NONE
+ * as culprit.
+ */
+extern void WDT_SupervisorStart( void )
+{
+    _dwChecks = 0 ;
+    GPBR->SYS_GPBR1 = WDT_SUPERVISOR_NONE ;
+    GPBR->SYS_GPBR2 = 0 ;
+    GPBR->SYS_GPBR3 = 0 ;
+    GPBR->SYS_GPBR0 = WDT_POSTMORTEM_MAGIC ;
+}
+
+/**
+ * \brief Store an application word in the post-mortem record, e.g. the
+ * trace sequence number or the current state of a task.
+ *
+ * \param dwIndex   Word index, 0 to 3
+ * \param dwValue   Value
+ */
+extern void WDT_SupervisorSetContext( uint32_t dwIndex, uint32_t dwValue )
+{
+    volatile uint32_t* pdwContext = &GPBR->SYS_GPBR4 ;
+
+    assert( dwIndex < 4 ) ;
+    pdwContext[dwIndex] = dwValue ;
+}
+
+/**
+ * \brief Supervisor check, called at a low rate (timer, or a low priority
+ * task) with a period well below the watchdog period.
+ *
+ * The watchdog is restarted only if every registered heartbeat has been
+ * reported within its deadline. Otherwise the late task is recorded in the
+ * backup registers and the device is reset at once, rather than at the end
+ * of the watchdog period.
+ *
+ * \param pWDT   Watchdog instance
+ */
+extern void WDT_SupervisorCheck( Wdt* pWDT )
+{
+    WdtHeartbeat* pHeartbeat ;
+    uint32_t dwIndex = 0 ;
+    uint32_t dwBeats ;
+
+    _dwChecks++ ;
+
+    for ( pHeartbeat = _pHeartbeats ; pHeartbeat != NULL ; pHeartbeat = pHeartbeat->pNext, dwIndex++ )
+    {
+        dwBeats = pHeartbeat->dwBeats ;
+        if ( dwBeats != pHeartbeat->dwSeen )
+        {
+            pHeartbeat->dwSeen = dwBeats ;
+            pHeartbeat->dwMissed = 0 ;
+        }
+        else
+        {
+            if ( ++pHeartbeat->dwMissed > pHeartbeat->dwMaxChecks )
+            {
+                GPBR->SYS_GPBR1 = dwIndex | (pHeartbeat->dwMissed << 16) ;
+                GPBR->SYS_GPBR2 = _dwChecks ;
+                GPBR->SYS_GPBR0 = WDT_POSTMORTEM_MAGIC ;
+
+                RSTC->RSTC_CR = RSTC_CR_KEY( WDT_RSTC_KEY ) | RSTC_CR_PROCRST | RSTC_CR_PERRST ;
+                while ( 1 ) ;
+            }
+        }
+    }
+
+    GPBR->SYS_GPBR2 = _dwChecks ;
+    WDT_Restart( pWDT ) ;
+}
+
+/**
+ * \brief Record a fault of a task and reset the device, from a fault handler.
+ *
+ * Used for the faults a task cannot recover from, such as a stack overflow
+ * caught by an MPU stack guard. The record reports WDT_SUPERVISOR_FAULT as
+ * culprit, the task in dwMissed and the faulting address.
+ *
+ * \param dwTask     Task identifier, 16 bits (task ID, or low bits of the
+ *                   task control block address)
+ * \param dwAddress  Faulting address
+ */
+extern void WDT_SupervisorFault( uint32_t dwTask, uint32_t dwAddress )
+{
+    GPBR->SYS_GPBR1 = WDT_SUPERVISOR_FAULT | (dwTask << 16) ;
+    GPBR->SYS_GPBR2 = _dwChecks ;
+    GPBR->SYS_GPBR3 = dwAddress ;
+    GPBR->SYS_GPBR0 = WDT_POSTMORTEM_MAGIC ;
+
+    RSTC->RSTC_CR = RSTC_CR_KEY( WDT_RSTC_KEY ) | RSTC_CR_PROCRST | RSTC_CR_PERRST ;
+    while ( 1 ) ;
+}
+
+/**
+ * \brief Get the post-mortem record left before the last reset, and the
+ * reset cause. The record is cleared, so it is reported once.
+ *
+ * \param pPostMortem   Receives the record
+ *
+ * \return 1 if a record was found, 0 otherwise (only dwResetType is set).
+ */
+extern uint32_t WDT_SupervisorGetPostMortem( WdtPostMortem* pPostMortem )
+{
+    volatile uint32_t* pdwContext = &GPBR->SYS_GPBR4 ;
+    uint32_t dw ;
+
+    pPostMortem->dwResetType = (RSTC->RSTC_SR & RSTC_SR_RSTTYP_Msk) >> RSTC_SR_RSTTYP_Pos ;
+
+    if ( GPBR->SYS_GPBR0 != WDT_POSTMORTEM_MAGIC )
+    {
+        return 0 ;
+    }
+
+    pPostMortem->dwCulprit = GPBR->SYS_GPBR1 & 0xFFFF ;
+    pPostMortem->dwMissed = GPBR->SYS_GPBR1 >> 16 ;
+    pPostMortem->dwChecks = GPBR->SYS_GPBR2 ;
+    pPostMortem->dwFaultAddress = GPBR->SYS_GPBR3 ;
+    for ( dw = 0 ; dw < 4 ; dw++ )
+    {
+        pPostMortem->adwContext[dw] = pdwContext[dw] ;
+    }
+
+    GPBR->SYS_GPBR0 = 0 ;
+
+    return 1 ;
+}
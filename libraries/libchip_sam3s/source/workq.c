@@ -0,0 +1,195 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Implementation of the deferred interrupt work queue.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "chip.h"
+
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+
+/** Posted work item. */
+typedef struct _WorkItem
+{
+    WorkFunc fFunc ;
+    void* pArg ;
+    uint32_t dwParam ;
+} WorkItem ;
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Ring of the posted items. */
+static WorkItem _aItems[WORKQ_SIZE] ;
+
+/** Index of the oldest item. */
+static uint32_t _dwFirst = 0 ;
+
+/** Number of items in the ring. */
+static volatile uint32_t _dwPending = 0 ;
+
+/** Highest number of items in the ring. */
+static uint32_t _dwHighWater = 0 ;
+
+/** Items refused because the ring was full. */
+static uint32_t _dwOverflows = 0 ;
+
+/** Function waking up the worker. */
+static WorkKick _fKick = 0 ;
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Empties the queue and sets the function waking up its worker.
+ * \param fKick  Function called when an item is posted to the empty queue;
+ *               the worker then calls WORKQ_Run().
+ */
+extern void WORKQ_Initialize( WorkKick fKick )
+{
+    uint32_t primask = __get_PRIMASK() ;
+
+    __disable_irq() ;
+    _dwFirst = 0 ;
+    _dwPending = 0 ;
+    _dwHighWater = 0 ;
+    _dwOverflows = 0 ;
+    _fKick = fKick ;
+    __set_PRIMASK( primask ) ;
+}
+
+/**
+ * \brief Posts a work item, from an interrupt handler or from the main context.
+ * \param fFunc  Function to run.
+ * \param pArg  Pointer given to the function.
+ * \param dwParam  Word given to the function.
+ * \return 1 if the item is posted, 0 if the queue is full.
+ */
+extern uint32_t WORKQ_Post( WorkFunc fFunc, void* pArg, uint32_t dwParam )
+{
+    WorkItem* pItem ;
+    uint32_t dwPending ;
+    uint32_t primask = __get_PRIMASK() ;
+
+    __disable_irq() ;
+    dwPending = _dwPending ;
+    if ( dwPending == WORKQ_SIZE )
+    {
+        _dwOverflows++ ;
+        __set_PRIMASK( primask ) ;
+
+        return 0 ;
+    }
+
+    pItem = &_aItems[(_dwFirst+dwPending) % WORKQ_SIZE] ;
+    pItem->fFunc = fFunc ;
+    pItem->pArg = pArg ;
+    pItem->dwParam = dwParam ;
+    _dwPending = dwPending+1 ;
+    if ( _dwPending > _dwHighWater )
+    {
+        _dwHighWater = _dwPending ;
+    }
+    __set_PRIMASK( primask ) ;
+
+    /* The worker empties the queue before it sleeps: only wake it up once */
+    if ( (dwPending == 0) && (_fKick != 0) )
+    {
+        _fKick() ;
+    }
+
+    return 1 ;
+}
+
+/**
+ * \brief Runs the posted items until the queue is empty; called by the
+ * worker only.
+ * \return Number of items run.
+ */
+extern uint32_t WORKQ_Run( void )
+{
+    WorkItem item ;
+    uint32_t dwCount = 0 ;
+    uint32_t primask ;
+
+    for ( ; ; )
+    {
+        primask = __get_PRIMASK() ;
+        __disable_irq() ;
+        if ( _dwPending == 0 )
+        {
+            __set_PRIMASK( primask ) ;
+
+            return dwCount ;
+        }
+        item = _aItems[_dwFirst] ;
+        _dwFirst = (_dwFirst+1) % WORKQ_SIZE ;
+        _dwPending-- ;
+        __set_PRIMASK( primask ) ;
+
+        item.fFunc( item.pArg, item.dwParam ) ;
+        dwCount++ ;
+    }
+}
+
+/**
+ * \brief Returns the number of items waiting in the queue.
+ */
+extern uint32_t WORKQ_GetPending( void )
+{
+    return _dwPending ;
+}
+
+/**
+ * \brief Returns the highest number of items the queue held; a value close
+ * to WORKQ_SIZE means the worker is late.
+ */
+extern uint32_t WORKQ_GetHighWater( void )
+{
+    return _dwHighWater ;
+}
+
+/**
+ * \brief Returns the number of items refused because the queue was full.
+ */
+extern uint32_t WORKQ_GetOverflows( void )
+{
+    return _dwOverflows ;
+}
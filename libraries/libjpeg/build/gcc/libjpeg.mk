@@ -39,6 +39,16 @@ CHIP=$(SERIE)4
 BOARD=$(SERIE)_ek
 LIBNAME=libjpeg
 TOOLCHAIN=gcc
+# Memory manager: nobs (malloc) or arena (fixed caller-provided arena, see jmemarena.h)
+JPEG_MEMMGR=nobs
+# Build profile: full, decode (baseline decoder), decode_scale (baseline
+# decoder with IDCT scaling) or encode (baseline encoder), see jmorecfg.h
+JPEG_PROFILE=full
+# Backing store for the virtual arrays exceeding the RAM budget: none, fatfs
+# (temp files on the FatFs volume) or psram (external RAM), see jmembs.h
+JPEG_BACKING=none
+# Directory of the application fatfs_config.h, for JPEG_BACKING=fatfs
+JPEG_FATFS_CONFIG=../../../sam-gui/source/file
 
 #-------------------------------------------------------------------------------
 # we detect OS (Linux/Windows/Cygwin)
@@ -78,6 +88,12 @@ INCLUDES = -I$(PROJECT_BASE_PATH)
 INCLUDES += -I$(PROJECT_BASE_PATH)/include
 
 
+ifeq ($(JPEG_BACKING), fatfs)
+INCLUDES += -I$(PROJECT_BASE_PATH)/..
+INCLUDES += -I$(PROJECT_BASE_PATH)/../fat/fatfs/src
+INCLUDES += -I$(JPEG_FATFS_CONFIG)
+endif
+
 #-------------------------------------------------------------------------------
 ifdef DEBUG
 include debug.mk
@@ -102,6 +118,11 @@ endif
 
 OUTPUT_PATH=$(OUTPUT_OBJ)_$(CORE)
 
+# The profiles build the same library name with their own objects
+ifneq ($(JPEG_PROFILE), full)
+OUTPUT_PATH=$(OUTPUT_OBJ)_$(CORE)_$(JPEG_PROFILE)
+endif
+
 #-------------------------------------------------------------------------------
 # C source files and objects
 #-------------------------------------------------------------------------------
@@ -142,6 +163,49 @@ C_OBJ_FILTER += wrppm.o
 C_OBJ_FILTER += wrrle.o
 C_OBJ_FILTER += wrtarga.o
 
+ifeq ($(JPEG_MEMMGR), arena)
+C_OBJ_FILTER += jmemnobs.o
+else
+C_OBJ_FILTER += jmemarena.o
+endif
+
+# The backing store I/O is done in whole FatFs sectors, see jmemmgr.c
+ifeq ($(JPEG_BACKING), fatfs)
+CFLAGS += -DJPEG_BACKING_FATFS -DBS_SECTOR_SIZE=512
+else ifeq ($(JPEG_BACKING), psram)
+CFLAGS += -DJPEG_BACKING_PSRAM
+else
+C_OBJ_FILTER += jmembs.o
+endif
+
+# Modules left out by the reduced profiles, the matching features are
+# switched off in jmorecfg.h by the JPEG_PROFILE_xxx define
+C_OBJ_DECODE_FILTER  = jaricom.o jcarith.o jdarith.o jctrans.o jdtrans.o
+C_OBJ_DECODE_FILTER += jquant1.o jquant2.o jidctflt.o jidctfst.o
+C_OBJ_DECODE_FILTER += $(filter-out jcomapi.o, $(filter jc%.o, $(C_OBJ_TEMP)))
+C_OBJ_DECODE_FILTER += $(filter jfdct%.o, $(C_OBJ_TEMP))
+C_OBJ_DECODE_FILTER += $(filter jdatadst%.o, $(C_OBJ_TEMP))
+
+ifeq ($(JPEG_PROFILE), decode)
+CFLAGS += -DJPEG_PROFILE_DECODE
+C_OBJ_FILTER += $(C_OBJ_DECODE_FILTER)
+C_OBJ_FILTER += jidctint.o jdmerge.o
+endif
+
+ifeq ($(JPEG_PROFILE), decode_scale)
+CFLAGS += -DJPEG_PROFILE_DECODE_SCALE
+C_OBJ_FILTER += $(C_OBJ_DECODE_FILTER)
+endif
+
+ifeq ($(JPEG_PROFILE), encode)
+CFLAGS += -DJPEG_PROFILE_ENCODE
+C_OBJ_FILTER += jaricom.o jcarith.o jctrans.o jdtrans.o
+C_OBJ_FILTER += jfdctflt.o jfdctfst.o jfdctint.o
+C_OBJ_FILTER += $(filter-out jdatadst%.o, $(filter jd%.o, $(C_OBJ_TEMP)))
+C_OBJ_FILTER += $(filter jidct%.o, $(C_OBJ_TEMP))
+C_OBJ_FILTER += jquant1.o jquant2.o
+endif
+
 
 C_OBJ=$(filter-out $(C_OBJ_FILTER), $(C_OBJ_TEMP))
 
@@ -191,7 +255,16 @@ $(addprefix $(OUTPUT_PATH)/,$(A_OBJ)): $(OUTPUT_PATH)/%.o: %.s
 	@$(AS) -c $(ASFLAGS) $< -o $@
 
 $(OUTPUT_LIB): $(addprefix $(OUTPUT_PATH)/, $(C_OBJ)) $(addprefix $(OUTPUT_PATH)/, $(A_OBJ))
+	-@$(CS_RM) -f $(OUTPUT_BIN)/$@ 1>$(NULL) 2>&1
 	@$(AR) -r $(OUTPUT_BIN)/$@ $^
+	@echo --- $(OUTPUT_LIB) profile $(JPEG_PROFILE) code and RAM size
+	@$(SIZE) -t $(OUTPUT_BIN)/$@
+
+# Code (text) and RAM (data+bss) of each module and of the whole library;
+# the application link still drops the unreferenced functions
+.PHONY: size
+size: $(OUTPUT_LIB)
+	@$(SIZE) -t $(OUTPUT_BIN)/$(OUTPUT_LIB)
 
 .PHONY: clean
 clean:
@@ -36,6 +36,8 @@ typedef int DCTELEM;		/* 16 or 32 bits is fine */
 #else
 typedef INT32 DCTELEM;		/* must have 32 bits */
 #endif
+#define FM3_SCALE_BITS  4	/* extra fractional bits of jfdctm3.c outputs */
+typedef unsigned int FM3_RECIP_TYPE; /* quantizer reciprocals, 32 bits */
 
 typedef JMETHOD(void, forward_DCT_method_ptr, (DCTELEM * data,
 					       JSAMPARRAY sample_data,
@@ -71,6 +73,8 @@ typedef INT32 IFAST_MULT_TYPE;	/* need 32 bits for scaled quantizers */
 #define IFAST_SCALE_BITS  13	/* fractional bits in scale factors */
 #endif
 typedef FAST_FLOAT FLOAT_MULT_TYPE; /* preferred floating type */
+typedef INT32 IM3_MULT_TYPE;	/* AA&N scaled quantizers in 32-bit words */
+#define IM3_SCALE_BITS  4	/* fractional bits in scale factors */
 
 
 /*
@@ -93,6 +97,7 @@ typedef FAST_FLOAT FLOAT_MULT_TYPE; /* preferred floating type */
 #define jpeg_fdct_islow		jFDislow
 #define jpeg_fdct_ifast		jFDifast
 #define jpeg_fdct_float		jFDfloat
+#define jpeg_fdct_m3		jFDm3
 #define jpeg_fdct_7x7		jFD7x7
 #define jpeg_fdct_6x6		jFD6x6
 #define jpeg_fdct_5x5		jFD5x5
@@ -158,6 +163,10 @@ typedef FAST_FLOAT FLOAT_MULT_TYPE; /* preferred floating type */
 #define jpeg_idct_3x6		jRD3x8
 #define jpeg_idct_2x4		jRD2x4
 #define jpeg_idct_1x2		jRD1x2
+#define jpeg_idct_m3		jRDm3
+#define jpeg_idct_m3_4x4	jRDm34x4
+#define jpeg_idct_m3_2x2	jRDm32x2
+#define jpeg_idct_m3_1x1	jRDm31x1
 #endif /* NEED_SHORT_EXTERNAL_NAMES */
 
 /* Extern declarations for the forward and inverse DCT routines. */
@@ -168,6 +177,8 @@ EXTERN(void) jpeg_fdct_ifast
     JPP((DCTELEM * data, JSAMPARRAY sample_data, JDIMENSION start_col));
 EXTERN(void) jpeg_fdct_float
     JPP((FAST_FLOAT * data, JSAMPARRAY sample_data, JDIMENSION start_col));
+EXTERN(void) jpeg_fdct_m3
+    JPP((DCTELEM * data, JSAMPARRAY sample_data, JDIMENSION start_col));
 EXTERN(void) jpeg_fdct_7x7
     JPP((DCTELEM * data, JSAMPARRAY sample_data, JDIMENSION start_col));
 EXTERN(void) jpeg_fdct_6x6
@@ -333,6 +344,18 @@ EXTERN(void) jpeg_idct_2x4
 EXTERN(void) jpeg_idct_1x2
     JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
 	 JCOEFPTR coef_block, JSAMPARRAY output_buf, JDIMENSION output_col));
+EXTERN(void) jpeg_idct_m3
+    JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	 JCOEFPTR coef_block, JSAMPARRAY output_buf, JDIMENSION output_col));
+EXTERN(void) jpeg_idct_m3_4x4
+    JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	 JCOEFPTR coef_block, JSAMPARRAY output_buf, JDIMENSION output_col));
+EXTERN(void) jpeg_idct_m3_2x2
+    JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	 JCOEFPTR coef_block, JSAMPARRAY output_buf, JDIMENSION output_col));
+EXTERN(void) jpeg_idct_m3_1x1
+    JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	 JCOEFPTR coef_block, JSAMPARRAY output_buf, JDIMENSION output_col));
 
 
 /*
@@ -0,0 +1,38 @@
+/*
+ * jmemarena.h
+ *
+ * This file is part of the Independent JPEG Group's software.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * Interface of the fixed arena memory manager (jmemarena.c), which takes
+ * the place of jmemnobs.c when the library is built with JPEG_MEMMGR=arena.
+ *
+ * All the memory of the codec objects comes from one caller-provided
+ * block, set with jpeg_arena_init() before jpeg_create_compress() or
+ * jpeg_create_decompress().  The arena serves one codec object at a time
+ * and is reset as a whole when that object is destroyed.
+ *
+ * To size the arena, decode a representative image of the wanted geometry
+ * with a generous arena and read the peak usage: every buffer is allocated
+ * by jpeg_start_decompress(), so the peak only depends on the image
+ * geometry and the decompression parameters.  The peak includes the spare
+ * room jmemmgr.c adds to its small pools (up to 16000 bytes for the image
+ * pool), which jmemmgr.c gives up when the arena is tighter: an arena of the
+ * peak size is always enough, a somewhat smaller one may still be.
+ */
+
+#ifndef JMEMARENA_H
+#define JMEMARENA_H
+
+typedef struct {
+  size_t size;			/* total arena size in bytes */
+  size_t used;			/* bytes currently allocated, overhead included */
+  size_t peak;			/* highest value of used since the last reset */
+  long allocations;		/* number of blocks currently allocated */
+} jpeg_arena_stats;
+
+EXTERN(void) jpeg_arena_init JPP((void * pool, size_t size));
+EXTERN(void) jpeg_arena_get_stats JPP((jpeg_arena_stats * stats));
+EXTERN(void) jpeg_arena_reset_peak JPP((void));
+
+#endif /* JMEMARENA_H */
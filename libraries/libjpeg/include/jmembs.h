@@ -0,0 +1,51 @@
+/*
+ * jmembs.h
+ *
+ * This file is part of the Independent JPEG Group's software.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * Interface of the backing store (jmembs.c) of the virtual arrays, built
+ * with JPEG_BACKING=fatfs (FatFs temporary files) or JPEG_BACKING=psram
+ * (an external RAM area) instead of the "no backing store" stub of
+ * jmemnobs.c and jmemarena.c.
+ *
+ * With a backing store, the allocators honor max_memory_to_use, which
+ * jpeg_mem_init() sets to JPEG_MAX_MEMORY: the virtual arrays of the
+ * progressive and multi-scan images (whole-image coefficient buffers) are
+ * then given the RAM left under that budget, and swap the rest of their
+ * rows to the store.  The application may change the budget with
+ * cinfo->mem->max_memory_to_use after jpeg_create_decompress().
+ *
+ * The FatFs store creates one contiguous temporary file per virtual array
+ * in JPEG_BS_PATH, on a volume mounted by the application, and seeks it
+ * with a fast-seek map.  jmemmgr.c aligns the windows of the swapped
+ * arrays on BS_SECTOR_SIZE in the file, so that FatFs moves whole sectors
+ * straight between the disk and the buffers.  The PSRAM store carves the
+ * arrays out of the area given to jpeg_bs_psram_init().
+ */
+
+#ifndef JMEMBS_H
+#define JMEMBS_H
+
+#ifndef JPEG_MAX_MEMORY		/* RAM budget of a codec object, in bytes */
+#define JPEG_MAX_MEMORY  20000L
+#endif
+
+#ifndef JPEG_BS_PATH		/* directory of the temporary files */
+#define JPEG_BS_PATH  "0:"
+#endif
+
+typedef struct {
+  long opened;			/* stores currently open */
+  long bytes_read;		/* bytes read back since the last reset */
+  long bytes_written;		/* bytes swapped out since the last reset */
+  long peak;			/* most bytes held by the open stores */
+} jpeg_bs_stats;
+
+#ifdef JPEG_BACKING_PSRAM
+EXTERN(void) jpeg_bs_psram_init JPP((void FAR * area, long size));
+#endif
+EXTERN(void) jpeg_bs_get_stats JPP((jpeg_bs_stats * stats));
+EXTERN(void) jpeg_bs_reset_stats JPP((void));
+
+#endif /* JMEMBS_H */
@@ -133,6 +133,14 @@ typedef union {
 #include <Files.h>
 #endif /* USE_MAC_MEMMGR */
 
+#ifdef JPEG_BACKING_FATFS	/* FatFs temporary files, see jmembs.h */
+#include "ff.h"
+#endif /* JPEG_BACKING_FATFS */
+
+#if defined(JPEG_BACKING_FATFS) || defined(JPEG_BACKING_PSRAM)
+#define JPEG_BACKING_STORE	/* jmembs.c supplies the backing store */
+#endif
+
 
 typedef struct backing_store_struct * backing_store_ptr;
 
@@ -162,6 +170,18 @@ typedef struct backing_store_struct {
   char temp_name[TEMP_NAME_LENGTH]; /* name if it's a file */
 #  else
 #    ifdef USE_HEAP_MEMMGR
+#      ifdef JPEG_BACKING_FATFS
+  /* For the FatFs backing store (jmembs.c), we need: */
+  FIL temp_file;		/* FatFs temp file */
+  DWORD link_map[4];		/* fast seek map of the contiguous file */
+  long temp_size;		/* bytes reserved */
+  char temp_name[TEMP_NAME_LENGTH]; /* name of temp file */
+#      endif
+#      ifdef JPEG_BACKING_PSRAM
+  /* For the PSRAM backing store (jmembs.c), we need: */
+  char FAR * area;		/* start of the rows in the PSRAM */
+  long area_size;		/* bytes reserved */
+#      endif
 #    else
   /* For a typical implementation with temp files, we need: */
   FILE * temp_file;		/* stdio reference to temp file */
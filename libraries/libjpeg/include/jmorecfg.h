@@ -270,6 +270,7 @@ typedef int boolean;
 #define DCT_ISLOW_SUPPORTED	/* slow but accurate integer algorithm */
 #define DCT_IFAST_SUPPORTED	/* faster, less accurate integer method */
 #undef DCT_FLOAT_SUPPORTED	/* floating-point: accurate, fast on fast HW */
+#define DCT_M3_SUPPORTED	/* Cortex-M3 tuned integer FDCT and IDCT */
 
 /* Encoder capability options: */
 
@@ -293,7 +294,7 @@ typedef int boolean;
 #define D_ARITH_CODING_SUPPORTED    /* Arithmetic coding back end? */
 #undef D_MULTISCAN_FILES_SUPPORTED /* Multiple-scan JPEG files? */
 #undef D_PROGRESSIVE_SUPPORTED	    /* Progressive JPEG? (Requires MULTISCAN)*/
-#undef IDCT_SCALING_SUPPORTED	    /* Output rescaling via IDCT? */
+#define IDCT_SCALING_SUPPORTED	    /* Output rescaling via IDCT? */
 #undef SAVE_MARKERS_SUPPORTED	    /* jpeg_save_markers() needed? */
 #undef BLOCK_SMOOTHING_SUPPORTED   /* Block smoothing? (Progressive only) */
 #undef  UPSAMPLE_SCALING_SUPPORTED  /* Output rescaling at upsample stage? */
@@ -304,6 +305,44 @@ typedef int boolean;
 /* more capability options later, no doubt */
 
 
+/*
+ * Reduced-footprint build profiles, selected by JPEG_PROFILE in
+ * build/gcc/libjpeg.mk, which also leaves out the matching source files.
+ * JPEG_PROFILE_DECODE keeps a baseline Huffman decoder with the Cortex-M3
+ * IDCT only, JPEG_PROFILE_DECODE_SCALE adds IDCT scaling (which needs the
+ * ISLOW kernels for the sizes jidctm3.c does not cover) and merged
+ * upsampling, JPEG_PROFILE_ENCODE keeps a baseline Huffman encoder with the
+ * Cortex-M3 FDCT only.  Without a profile, the full option list above holds.
+ * The DCT method defaults move to JDCT_M3 whenever ISLOW may be missing.
+ */
+
+#if defined(JPEG_PROFILE_DECODE) || defined(JPEG_PROFILE_DECODE_SCALE)
+#undef DCT_IFAST_SUPPORTED
+#undef D_ARITH_CODING_SUPPORTED
+#undef QUANT_1PASS_SUPPORTED
+#undef QUANT_2PASS_SUPPORTED
+#endif
+
+#ifdef JPEG_PROFILE_DECODE
+#undef DCT_ISLOW_SUPPORTED
+#undef IDCT_SCALING_SUPPORTED
+#undef UPSAMPLE_MERGING_SUPPORTED
+#endif
+
+#ifdef JPEG_PROFILE_ENCODE
+#undef DCT_ISLOW_SUPPORTED
+#undef DCT_IFAST_SUPPORTED
+#undef C_ARITH_CODING_SUPPORTED
+#undef INPUT_SMOOTHING_SUPPORTED
+#endif
+
+#if defined(JPEG_PROFILE_DECODE) || defined(JPEG_PROFILE_DECODE_SCALE) || \
+    defined(JPEG_PROFILE_ENCODE)
+#define JDCT_DEFAULT  JDCT_M3
+#define JDCT_FASTEST  JDCT_M3
+#endif
+
+
 /*
  * Ordering of RGB data in scanlines passed to or from the application.
  * If your application wants to deal with data in the order B,G,R, just
@@ -143,6 +143,14 @@ struct jpeg_decomp_master {
 
   /* State variables made visible to other modules */
   boolean is_dummy_pass;	/* True during 1st pass for 2-pass quant */
+
+  /* Horizontal crop window (see jpeg_crop_scanline), inclusive ranges of
+   * iMCU columns, and of block columns for each component.
+   */
+  JDIMENSION first_iMCU_col;
+  JDIMENSION last_iMCU_col;
+  JDIMENSION first_block_col[MAX_COMPONENTS];
+  JDIMENSION last_block_col[MAX_COMPONENTS];
 };
 
 /* Input control module */
@@ -213,6 +221,12 @@ struct jpeg_entropy_decoder {
   JMETHOD(void, start_pass, (j_decompress_ptr cinfo));
   JMETHOD(boolean, decode_mcu, (j_decompress_ptr cinfo,
 				JBLOCKROW *MCU_data));
+  /* Optional methods for cropped output, NULL if the scan can't do it: */
+  /* Decode an MCU only to keep the DC predictions, storing nothing */
+  JMETHOD(boolean, skip_mcu, (j_decompress_ptr cinfo));
+  /* Jump from MCU MCU_num towards MCU target, returns the MCU reached */
+  JMETHOD(JDIMENSION, seek_mcu, (j_decompress_ptr cinfo,
+				 JDIMENSION MCU_num, JDIMENSION target));
 };
 
 /* Inverse DCT (also performs dequantization) */
@@ -224,7 +224,8 @@ typedef enum {
 typedef enum {
 	JDCT_ISLOW,		/* slow but accurate integer algorithm */
 	JDCT_IFAST,		/* faster, less accurate integer method */
-	JDCT_FLOAT		/* floating-point: accurate, fast on fast HW */
+	JDCT_FLOAT,		/* floating-point: accurate, fast on fast HW */
+	JDCT_M3			/* Cortex-M3 tuned integer method */
 } J_DCT_METHOD;
 
 #ifndef JDCT_DEFAULT		/* may be overridden in jconfig.h */
@@ -469,6 +470,9 @@ struct jpeg_decompress_struct {
   boolean do_fancy_upsampling;	/* TRUE=apply fancy upsampling */
   boolean do_block_smoothing;	/* TRUE=apply interblock smoothing */
 
+  /* Optional restart marker index, used with jpeg_crop_scanline() */
+  struct jpeg_restart_index * restart_index;
+
   boolean quantize_colors;	/* TRUE=colormapped output wanted */
   /* the following are ignored if not quantize_colors: */
   J_DITHER_MODE dither_mode;	/* type of color dithering to use */
@@ -771,6 +775,37 @@ struct jpeg_source_mgr {
 };
 
 
+/* Device reader used by the chunked data source (jdatasrc_chunk.c).
+ * start_read may return before the transfer is done (e.g. a DMA read);
+ * wait_read then blocks until it is, and returns FALSE on a device error.
+ * Only one read is outstanding at any time.
+ */
+
+struct jpeg_chunk_reader {
+  JMETHOD(void, start_read, (struct jpeg_chunk_reader * reader,
+			     JOCTET * buffer, unsigned long offset,
+			     size_t length));
+  JMETHOD(boolean, wait_read, (struct jpeg_chunk_reader * reader));
+};
+
+
+/* Restart marker index, kept by the application across the decodes of one
+ * image held in memory (jpeg_mem_src).  The first decode records where the
+ * data of each restart interval starts; when a later decode is cropped with
+ * jpeg_crop_scanline(), the Huffman decoder jumps over the intervals lying
+ * outside the crop window.  The application sets offsets and max_entries
+ * and clears num_entries; the other fields belong to the library.
+ */
+
+struct jpeg_restart_index {
+  const JOCTET * scan_data;	/* start of the indexed entropy-coded data */
+  unsigned int interval;	/* MCUs per restart interval */
+  JDIMENSION num_entries;	/* intervals indexed so far */
+  JDIMENSION max_entries;	/* size of offsets[] */
+  unsigned long * offsets;	/* offset of each interval from scan_data */
+};
+
+
 /* Memory manager object.
  * Allocates "small" objects (a few K total), "large" objects (tens of K),
  * and "really big" objects (virtual arrays with backing store if needed).
@@ -875,6 +910,7 @@ typedef JMETHOD(boolean, jpeg_marker_parser_method, (j_decompress_ptr cinfo));
 #define jpeg_stdio_src		jStdSrc
 #define jpeg_mem_dest		jMemDest
 #define jpeg_mem_src		jMemSrc
+#define jpeg_chunk_src		jChunkSrc
 #define jpeg_set_defaults	jSetDefaults
 #define jpeg_set_colorspace	jSetColorspace
 #define jpeg_default_colorspace	jDefColorspace
@@ -901,6 +937,8 @@ typedef JMETHOD(boolean, jpeg_marker_parser_method, (j_decompress_ptr cinfo));
 #define jpeg_read_scanlines	jReadScanlines
 #define jpeg_finish_decompress	jFinDecompress
 #define jpeg_read_raw_data	jReadRawData
+#define jpeg_set_output_port	jSetOutPort
+#define jpeg_crop_scanline	jCropScanline
 #define jpeg_has_multiple_scans	jHasMultScn
 #define jpeg_start_output	jStrtOutput
 #define jpeg_finish_output	jFinOutput
@@ -957,8 +995,13 @@ EXTERN(void) jpeg_mem_dest JPP((j_compress_ptr cinfo,
 			       unsigned char ** outbuffer,
 			       unsigned long * outsize));
 EXTERN(void) jpeg_mem_src JPP((j_decompress_ptr cinfo,
-			      unsigned char * inbuffer,
+			      const unsigned char * inbuffer,
 			      unsigned long insize));
+/* Data source manager: chunked reads from a device, double-buffered. */
+EXTERN(void) jpeg_chunk_src JPP((j_decompress_ptr cinfo,
+				struct jpeg_chunk_reader * reader,
+				unsigned long offset, unsigned long insize,
+				JOCTET * buffer, size_t bufsize));
 
 /* Default parameter setup for compression */
 EXTERN(void) jpeg_set_defaults JPP((j_compress_ptr cinfo));
@@ -1038,6 +1081,20 @@ EXTERN(JDIMENSION) jpeg_read_raw_data JPP((j_decompress_ptr cinfo,
 					   JSAMPIMAGE data,
 					   JDIMENSION max_lines));
 
+/* Sends RGB pixels to a data port instead of the jpeg_read_scanlines buffer.
+ * Call after jpeg_start_decompress; see jdcolor.c.
+ */
+EXTERN(void) jpeg_set_output_port JPP((j_decompress_ptr cinfo,
+				       volatile JSAMPLE * port));
+
+/* Restricts the output to a horizontal window of the image.
+ * Call after jpeg_start_decompress, before reading any scanline;
+ * see jdapistd.c.
+ */
+EXTERN(void) jpeg_crop_scanline JPP((j_decompress_ptr cinfo,
+				     JDIMENSION * xoffset,
+				     JDIMENSION * width));
+
 /* Additional entry points for buffered-image mode. */
 EXTERN(boolean) jpeg_has_multiple_scans JPP((j_decompress_ptr cinfo));
 EXTERN(boolean) jpeg_start_output JPP((j_decompress_ptr cinfo,
@@ -31,6 +31,11 @@ typedef struct {
    */
   DCTELEM * divisors[NUM_QUANT_TBLS];
 
+#ifdef DCT_M3_SUPPORTED
+  /* Reciprocals of the JDCT_M3 divisors, scaled up by 2^32. */
+  FM3_RECIP_TYPE * m3_reciprocals[NUM_QUANT_TBLS];
+#endif
+
 #ifdef DCT_FLOAT_SUPPORTED
   /* Same as above for the floating-point case. */
   float_DCT_method_ptr do_float_dct[MAX_COMPONENTS];
@@ -52,6 +57,36 @@ typedef my_fdct_controller * my_fdct_ptr;
 #endif
 #endif
 
+/* The AA&N scale factors are shared by the IFAST and M3 divisor tables. */
+#ifdef DCT_IFAST_SUPPORTED
+#define PROVIDE_AAN_TABLES
+#else
+#ifdef DCT_M3_SUPPORTED
+#define PROVIDE_AAN_TABLES
+#endif
+#endif
+
+#ifdef PROVIDE_AAN_TABLES
+/* Divisors for the AA&N methods are equal to quantization coefficients
+ * scaled by scalefactor[row]*scalefactor[col], where
+ *   scalefactor[0] = 1
+ *   scalefactor[k] = cos(k*PI/16) * sqrt(2)    for k=1..7
+ * The table holds these products scaled up by AAN_CONST_BITS.
+ */
+#define AAN_CONST_BITS 14
+static const INT16 aanscales[DCTSIZE2] = {
+  /* precomputed values scaled up by 14 bits */
+  16384, 22725, 21407, 19266, 16384, 12873,  8867,  4520,
+  22725, 31521, 29692, 26722, 22725, 17855, 12299,  6270,
+  21407, 29692, 27969, 25172, 21407, 16819, 11585,  5906,
+  19266, 26722, 25172, 22654, 19266, 15137, 10426,  5315,
+  16384, 22725, 21407, 19266, 16384, 12873,  8867,  4520,
+  12873, 17855, 16819, 15137, 12873, 10114,  6967,  3552,
+   8867, 12299, 11585, 10426,  8867,  6967,  4799,  2446,
+   4520,  6270,  5906,  5315,  4520,  3552,  2446,  1247
+};
+#endif
+
 
 /*
  * Perform forward DCT on one or more blocks of a component.
@@ -122,6 +157,61 @@ forward_DCT (j_compress_ptr cinfo, jpeg_component_info * compptr,
 }
 
 
+#ifdef DCT_M3_SUPPORTED
+
+/* High word of an unsigned 32x32 product: a single UMULL on the Cortex-M3. */
+#define MULTIPLY_HIGH(a,b)  ((FM3_RECIP_TYPE) \
+  (((unsigned long long) (a) * (FM3_RECIP_TYPE) (b)) >> 32))
+
+METHODDEF(void)
+forward_DCT_m3 (j_compress_ptr cinfo, jpeg_component_info * compptr,
+		JSAMPARRAY sample_data, JBLOCKROW coef_blocks,
+		JDIMENSION start_row, JDIMENSION start_col,
+		JDIMENSION num_blocks)
+/* This version is used for the Cortex-M3 tuned DCT. */
+{
+  /* This routine is heavily used, so it's worth coding it tightly. */
+  my_fdct_ptr fdct = (my_fdct_ptr) cinfo->fdct;
+  DCTELEM * divisors = fdct->divisors[compptr->quant_tbl_no];
+  FM3_RECIP_TYPE * reciprocals = fdct->m3_reciprocals[compptr->quant_tbl_no];
+  DCTELEM workspace[DCTSIZE2];	/* work area for FDCT subroutine */
+  JDIMENSION bi;
+
+  sample_data += start_row;	/* fold in the vertical offset once */
+
+  for (bi = 0; bi < num_blocks; bi++, start_col += DCTSIZE) {
+    /* Perform the DCT */
+    jpeg_fdct_m3(workspace, sample_data, start_col);
+
+    /* Quantize/descale the coefficients, and store into coef_blocks[] */
+    { register DCTELEM temp;
+      register int i;
+      register JCOEFPTR output_ptr = coef_blocks[bi];
+
+      for (i = 0; i < DCTSIZE2; i++) {
+	temp = workspace[i];
+	/* Divide by multiplying with the reciprocal, ceil(2^32/divisor).
+	 * With dividends under 2^20 the quotient is exact for divisors
+	 * below 2^12; a larger divisor may round up a dividend lying within
+	 * 1/4096 of its next multiple, i.e. only move a rounding tie.
+	 */
+	if (temp < 0) {
+	  temp = -temp;
+	  temp += divisors[i]>>1;	/* for rounding */
+	  temp = - (DCTELEM) MULTIPLY_HIGH(temp, reciprocals[i]);
+	} else {
+	  temp += divisors[i]>>1;	/* for rounding */
+	  temp = (DCTELEM) MULTIPLY_HIGH(temp, reciprocals[i]);
+	}
+	output_ptr[i] = (JCOEF) temp;
+      }
+    }
+  }
+}
+
+#endif /* DCT_M3_SUPPORTED */
+
+
 #ifdef DCT_FLOAT_SUPPORTED
 
 METHODDEF(void)
@@ -330,6 +420,12 @@ start_pass_fdctmgr (j_compress_ptr cinfo)
 	method = JDCT_IFAST;
 	break;
 #endif
+#ifdef DCT_M3_SUPPORTED
+      case JDCT_M3:
+	fdct->do_dct[ci] = jpeg_fdct_m3; /* called directly by forward_DCT_m3 */
+	method = JDCT_M3;
+	break;
+#endif
 #ifdef DCT_FLOAT_SUPPORTED
       case JDCT_FLOAT:
 	fdct->do_float_dct[ci] = jpeg_fdct_float;
@@ -376,23 +472,9 @@ start_pass_fdctmgr (j_compress_ptr cinfo)
     case JDCT_IFAST:
       {
 	/* For AA&N IDCT method, divisors are equal to quantization
-	 * coefficients scaled by scalefactor[row]*scalefactor[col], where
-	 *   scalefactor[0] = 1
-	 *   scalefactor[k] = cos(k*PI/16) * sqrt(2)    for k=1..7
+	 * coefficients scaled by the AA&N scale factors (see aanscales).
 	 * We apply a further scale factor of 8.
 	 */
-#define CONST_BITS 14
-	static const INT16 aanscales[DCTSIZE2] = {
-	  /* precomputed values scaled up by 14 bits */
-	  16384, 22725, 21407, 19266, 16384, 12873,  8867,  4520,
-	  22725, 31521, 29692, 26722, 22725, 17855, 12299,  6270,
-	  21407, 29692, 27969, 25172, 21407, 16819, 11585,  5906,
-	  19266, 26722, 25172, 22654, 19266, 15137, 10426,  5315,
-	  16384, 22725, 21407, 19266, 16384, 12873,  8867,  4520,
-	  12873, 17855, 16819, 15137, 12873, 10114,  6967,  3552,
-	   8867, 12299, 11585, 10426,  8867,  6967,  4799,  2446,
-	   4520,  6270,  5906,  5315,  4520,  3552,  2446,  1247
-	};
 	SHIFT_TEMPS
 
 	if (fdct->divisors[qtblno] == NULL) {
@@ -405,12 +487,45 @@ start_pass_fdctmgr (j_compress_ptr cinfo)
 	  dtbl[i] = (DCTELEM)
 	    DESCALE(MULTIPLY16V16((INT32) qtbl->quantval[i],
 				  (INT32) aanscales[i]),
-		    CONST_BITS-3);
+		    AAN_CONST_BITS-3);
 	}
       }
       fdct->pub.forward_DCT[ci] = forward_DCT;
       break;
 #endif
+#ifdef DCT_M3_SUPPORTED
+    case JDCT_M3:
+      {
+	/* As for IFAST, with the further 2^FM3_SCALE_BITS of jfdctm3.c.
+	 * The reciprocals let forward_DCT_m3 quantize without division.
+	 */
+	FM3_RECIP_TYPE * rtbl;
+	SHIFT_TEMPS
+
+	if (fdct->divisors[qtblno] == NULL) {
+	  fdct->divisors[qtblno] = (DCTELEM *)
+	    (*cinfo->mem->alloc_small) ((j_common_ptr) cinfo, JPOOL_IMAGE,
+					DCTSIZE2 * SIZEOF(DCTELEM));
+	}
+	if (fdct->m3_reciprocals[qtblno] == NULL) {
+	  fdct->m3_reciprocals[qtblno] = (FM3_RECIP_TYPE *)
+	    (*cinfo->mem->alloc_small) ((j_common_ptr) cinfo, JPOOL_IMAGE,
+					DCTSIZE2 * SIZEOF(FM3_RECIP_TYPE));
+	}
+	dtbl = fdct->divisors[qtblno];
+	rtbl = fdct->m3_reciprocals[qtblno];
+	for (i = 0; i < DCTSIZE2; i++) {
+	  dtbl[i] = (DCTELEM)
+	    DESCALE((INT32) qtbl->quantval[i] * (INT32) aanscales[i],
+		    AAN_CONST_BITS-3-FM3_SCALE_BITS);
+	  /* ceil(2^32/divisor), the divisors are at least 10 */
+	  rtbl[i] = (FM3_RECIP_TYPE)
+	    (0xFFFFFFFFUL / (FM3_RECIP_TYPE) dtbl[i] + 1);
+	}
+      }
+      fdct->pub.forward_DCT[ci] = forward_DCT_m3;
+      break;
+#endif
 #ifdef DCT_FLOAT_SUPPORTED
     case JDCT_FLOAT:
       {
@@ -475,6 +590,9 @@ jinit_forward_dct (j_compress_ptr cinfo)
   /* Mark divisor tables unallocated */
   for (i = 0; i < NUM_QUANT_TBLS; i++) {
     fdct->divisors[i] = NULL;
+#ifdef DCT_M3_SUPPORTED
+    fdct->m3_reciprocals[i] = NULL;
+#endif
 #ifdef DCT_FLOAT_SUPPORTED
     fdct->float_divisors[i] = NULL;
 #endif
@@ -1008,6 +1008,138 @@ encode_one_block (working_state * state, JCOEFPTR block, int last_dc_val,
 }
 
 
+#ifdef DCT_M3_SUPPORTED
+
+/* Variant of encode_one_block used with the JDCT_M3 method, tuned for the
+ * Cortex-M3.  The bits are accumulated right-justified in a local 32-bit
+ * word and two bytes are written out whenever 16 bits are held, instead
+ * of testing for a full byte after each field; coefficient sizes come from
+ * CLZ.  The output is identical to encode_one_block's, and the bit buffer
+ * is handed back in the usual left-justified form with less than 8 bits,
+ * so flushing and restart handling are shared with the generic path.
+ */
+
+#if defined(__GNUC__)
+#define M3_NBITS(nbits,temp)  \
+	((nbits) = 32 - __builtin_clz((unsigned int) (temp)))
+#else
+#define M3_NBITS(nbits,temp)  \
+	{ register int t_ = (temp); \
+	  (nbits) = 0; \
+	  while (t_) { (nbits)++; t_ >>= 1; } }
+#endif
+
+/* Write out the top byte held in put_buffer, stuffing a zero after 0xFF */
+#define M3_EMIT_BYTE(state)  \
+	{ register int c_; \
+	  put_bits -= 8; \
+	  c_ = (int) ((put_buffer >> put_bits) & 0xFF); \
+	  emit_byte_s(state, c_, return FALSE); \
+	  if (c_ == 0xFF) \
+	    emit_byte_s(state, 0, return FALSE); }
+
+/* Append size bits of code (size <= 16, high bits of code clear) */
+#define M3_PUT_BITS(state,code,size)  \
+	{ put_buffer = (put_buffer << (size)) | (code); \
+	  if ((put_bits += (size)) >= 16) { \
+	    M3_EMIT_BYTE(state); \
+	    M3_EMIT_BYTE(state); \
+	  } }
+
+/* Append the Huffman code of a symbol */
+#define M3_PUT_CODE(state,tbl,symbol)  \
+	{ register int s_ = (tbl)->ehufsi[symbol]; \
+	  /* if size is 0, caller used an invalid Huffman table entry */ \
+	  if (s_ == 0) \
+	    ERREXIT(state->cinfo, JERR_HUFF_MISSING_CODE); \
+	  M3_PUT_BITS(state, (tbl)->ehufco[symbol], s_); }
+
+LOCAL(boolean)
+encode_one_block_m3 (working_state * state, JCOEFPTR block, int last_dc_val,
+		     c_derived_tbl *dctbl, c_derived_tbl *actbl)
+{
+  register unsigned int put_buffer;
+  register int put_bits = state->cur.put_bits;
+  register int temp, temp2;
+  register int nbits;
+  register int k, r, i;
+  int Se = state->cinfo->lim_Se;
+  const int * natural_order = state->cinfo->natural_order;
+
+  /* Load the bit buffer right-justified */
+  put_buffer = (unsigned int) (state->cur.put_buffer >> (24 - put_bits)) &
+	       ((1U << put_bits) - 1);
+
+  /* Encode the DC coefficient difference per section F.1.2.1 */
+
+  temp = temp2 = block[0] - last_dc_val;
+
+  if (temp < 0) {
+    temp = -temp;		/* temp is abs value of input */
+    /* This code assumes we are on a two's complement machine */
+    temp2--;
+  }
+
+  nbits = 0;
+  if (temp)
+    M3_NBITS(nbits, temp);
+  /* Since we're encoding a difference, the range limit is twice as much. */
+  if (nbits > MAX_COEF_BITS+1)
+    ERREXIT(state->cinfo, JERR_BAD_DCT_COEF);
+
+  M3_PUT_CODE(state, dctbl, nbits);
+  M3_PUT_BITS(state, (unsigned int) temp2 & ((1U << nbits) - 1), nbits);
+
+  /* Encode the AC coefficients per section F.1.2.2 */
+
+  r = 0;			/* r = run length of zeros */
+
+  for (k = 1; k <= Se; k++) {
+    if ((temp = block[natural_order[k]]) == 0) {
+      r++;
+    } else {
+      /* if run length > 15, must emit special run-length-16 codes (0xF0) */
+      while (r > 15) {
+	M3_PUT_CODE(state, actbl, 0xF0);
+	r -= 16;
+      }
+
+      temp2 = temp;
+      if (temp < 0) {
+	temp = -temp;		/* temp is abs value of input */
+	/* This code assumes we are on a two's complement machine */
+	temp2--;
+      }
+
+      M3_NBITS(nbits, temp);
+      if (nbits > MAX_COEF_BITS)
+	ERREXIT(state->cinfo, JERR_BAD_DCT_COEF);
+
+      i = (r << 4) + nbits;
+      M3_PUT_CODE(state, actbl, i);
+      M3_PUT_BITS(state, (unsigned int) temp2 & ((1U << nbits) - 1), nbits);
+
+      r = 0;
+    }
+  }
+
+  /* If the last coef(s) were zero, emit an end-of-block code */
+  if (r > 0)
+    M3_PUT_CODE(state, actbl, 0);
+
+  /* Hand back less than 8 bits, left-justified in 24 bits */
+  while (put_bits >= 8)
+    M3_EMIT_BYTE(state);
+  state->cur.put_buffer = (INT32) ((put_buffer & ((1U << put_bits) - 1))
+				   << (24 - put_bits));
+  state->cur.put_bits = put_bits;
+
+  return TRUE;
+}
+
+#endif /* DCT_M3_SUPPORTED */
+
+
 /*
  * Encode and output one MCU's worth of Huffman-compressed coefficients.
  */
@@ -1037,6 +1169,15 @@ encode_mcu_huff (j_compress_ptr cinfo, JBLOCKROW *MCU_data)
   for (blkn = 0; blkn < cinfo->blocks_in_MCU; blkn++) {
     ci = cinfo->MCU_membership[blkn];
     compptr = cinfo->cur_comp_info[ci];
+#ifdef DCT_M3_SUPPORTED
+    if (cinfo->dct_method == JDCT_M3) {
+      if (! encode_one_block_m3(&state,
+				MCU_data[blkn][0], state.cur.last_dc_val[ci],
+				entropy->dc_derived_tbls[compptr->dc_tbl_no],
+				entropy->ac_derived_tbls[compptr->ac_tbl_no]))
+	return FALSE;
+    } else
+#endif
     if (! encode_one_block(&state,
 			   MCU_data[blkn][0], state.cur.last_dc_val[ci],
 			   entropy->dc_derived_tbls[compptr->dc_tbl_no],
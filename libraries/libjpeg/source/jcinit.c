@@ -41,9 +41,13 @@ jinit_compress_master (j_compress_ptr cinfo)
   /* Forward DCT */
   jinit_forward_dct(cinfo);
   /* Entropy encoding: either Huffman or arithmetic coding. */
-  if (cinfo->arith_code)
+  if (cinfo->arith_code) {
+#ifdef C_ARITH_CODING_SUPPORTED
     jinit_arith_encoder(cinfo);
-  else {
+#else
+    ERREXIT(cinfo, JERR_NOT_COMPILED);
+#endif
+  } else {
     jinit_huff_encoder(cinfo);
   }
 
@@ -176,6 +176,74 @@ jpeg_read_scanlines (j_decompress_ptr cinfo, JSAMPARRAY scanlines,
 }
 
 
+/*
+ * Restrict the output to a horizontal window of the image, for panning
+ * over images wider than the display.
+ * Call after jpeg_start_decompress (or jpeg_start_output), before reading
+ * any scanline.  *xoffset and *width give the wanted window in output
+ * pixels; the window is widened on the left to an iMCU column boundary,
+ * and *xoffset and *width are updated to the window actually returned,
+ * which output_width now gives.
+ *
+ * The blocks outside the window get no IDCT.  In a sequential file their
+ * coefficients are not even stored, and with a restart marker index
+ * (cinfo->restart_index) the decoder jumps over the restart intervals
+ * lying outside the window once the index is built.
+ *
+ * The window must be set before the first output pass if 2-pass color
+ * quantization is used.
+ */
+
+GLOBAL(void)
+jpeg_crop_scanline (j_decompress_ptr cinfo, JDIMENSION * xoffset,
+		    JDIMENSION * width)
+{
+  struct jpeg_decomp_master * master;
+  jpeg_component_info *compptr;
+  JDIMENSION full_width, align, first_col, last_col;
+  int ci;
+
+  if ((cinfo->global_state != DSTATE_SCANNING &&
+       cinfo->global_state != DSTATE_RAW_OK) || cinfo->output_scanline != 0)
+    ERREXIT1(cinfo, JERR_BAD_STATE, cinfo->global_state);
+
+  /* Uncropped output width, as computed by jpeg_calc_output_dimensions */
+  full_width = (JDIMENSION)
+    jdiv_round_up((long) cinfo->image_width *
+		  (long) cinfo->min_DCT_h_scaled_size,
+		  (long) cinfo->block_size);
+  if (*width == 0 || *xoffset >= full_width ||
+      *width > full_width - *xoffset)
+    ERREXIT(cinfo, JERR_BAD_CROP_SPEC);
+
+  /* Round the window to whole iMCU columns on the left */
+  align = (JDIMENSION) (cinfo->max_h_samp_factor *
+			cinfo->min_DCT_h_scaled_size);
+  first_col = *xoffset / align;
+  last_col = (*xoffset + *width - 1) / align;
+  *width += *xoffset - first_col * align;
+  *xoffset = first_col * align;
+  cinfo->output_width = *width;
+
+  master = cinfo->master;
+  master->first_iMCU_col = first_col;
+  master->last_iMCU_col = last_col;
+  for (ci = 0, compptr = cinfo->comp_info; ci < cinfo->num_components;
+       ci++, compptr++) {
+    /* An iMCU column holds h_samp_factor blocks of each component */
+    master->first_block_col[ci] = first_col * compptr->h_samp_factor;
+    master->last_block_col[ci] = (last_col + 1) * compptr->h_samp_factor - 1;
+    if (master->last_block_col[ci] >= compptr->width_in_blocks)
+      master->last_block_col[ci] = compptr->width_in_blocks - 1;
+    /* Size in samples of the window, after IDCT scaling */
+    compptr->downsampled_width = (JDIMENSION)
+      jdiv_round_up((long) cinfo->output_width *
+		    (long) (compptr->h_samp_factor * compptr->DCT_h_scaled_size),
+		    (long) align);
+  }
+}
+
+
 /*
  * Alternate entry point to read raw data.
  * Processes exactly one iMCU row per call, unless suspended.
@@ -748,6 +748,9 @@ jinit_arith_decoder (j_decompress_ptr cinfo)
 				SIZEOF(arith_entropy_decoder));
   cinfo->entropy = (struct jpeg_entropy_decoder *) entropy;
   entropy->pub.start_pass = start_pass;
+  /* Cropped output just decodes the MCUs outside the window */
+  entropy->pub.skip_mcu = NULL;
+  entropy->pub.seek_mcu = NULL;
 
   /* Mark tables unallocated */
   for (i = 0; i < NUM_ARITH_TBLS; i++) {
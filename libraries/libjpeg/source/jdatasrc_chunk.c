@@ -0,0 +1,260 @@
+/*
+ * jdatasrc_chunk.c
+ *
+ * This file is part of the Independent JPEG Group's software.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * This file contains a decompression data source manager reading the JPEG
+ * data from a random-access device, such as a serial dataflash, through
+ * an application supplied reader (struct jpeg_chunk_reader).  The data is
+ * read in chunks into the two halves of a caller supplied buffer: while the
+ * decompressor consumes one half, the next chunk is read into the other one,
+ * so a device read done by DMA overlaps the decoding.  Only the buffer is
+ * needed in RAM, whatever the size of the image.
+ */
+
+/* this is not a core library module, so it doesn't define JPEG_INTERNALS */
+#include "jinclude.h"
+#include "jpeglib.h"
+#include "jerror.h"
+
+
+/* Expanded data source object for chunked input */
+
+typedef struct {
+  struct jpeg_source_mgr pub;	/* public fields */
+
+  struct jpeg_chunk_reader * reader; /* device access methods */
+  unsigned long start_offset;	/* device offset of the JPEG data */
+  unsigned long insize;		/* size of the JPEG data */
+  unsigned long next_offset;	/* device offset of the next chunk */
+  unsigned long remaining;	/* bytes not requested to the device yet */
+
+  JOCTET * buffer[2];		/* the two halves of the input buffer */
+  size_t chunk_size;		/* size of each half */
+  int fill_index;		/* half receiving the outstanding read */
+  size_t pending;		/* length of the outstanding read, 0 if none */
+
+  JOCTET eoi_buffer[2];		/* a place to put a dummy EOI */
+} my_source_mgr;
+
+typedef my_source_mgr * my_src_ptr;
+
+
+/*
+ * Start reading the next chunk into the free half of the buffer.
+ */
+
+LOCAL(void)
+start_next_chunk (my_src_ptr src)
+{
+  size_t length = src->chunk_size;
+
+  if (src->remaining == 0)
+    return;
+  if ((unsigned long) length > src->remaining)
+    length = (size_t) src->remaining;
+
+  (*src->reader->start_read) (src->reader, src->buffer[src->fill_index],
+			      src->next_offset, length);
+  src->next_offset += (unsigned long) length;
+  src->remaining -= (unsigned long) length;
+  src->pending = length;
+}
+
+
+/*
+ * Wait for the outstanding read, if any.
+ */
+
+LOCAL(void)
+wait_chunk (j_decompress_ptr cinfo, my_src_ptr src)
+{
+  if (src->pending == 0)
+    return;
+  if (! (*src->reader->wait_read) (src->reader)) {
+    src->pending = 0;
+    ERREXIT(cinfo, JERR_FILE_READ);
+  }
+}
+
+
+/*
+ * Initialize source --- called by jpeg_read_header
+ * before any data is actually read.
+ * Each image restarts from the beginning of the JPEG data.
+ */
+
+METHODDEF(void)
+init_source (j_decompress_ptr cinfo)
+{
+  my_src_ptr src = (my_src_ptr) cinfo->src;
+
+  wait_chunk(cinfo, src);	/* in case the previous image was aborted */
+  src->next_offset = src->start_offset;
+  src->remaining = src->insize;
+  src->fill_index = 0;
+  src->pending = 0;
+  src->pub.next_input_byte = NULL;
+  src->pub.bytes_in_buffer = 0;
+  start_next_chunk(src);
+}
+
+
+/*
+ * Fill the input buffer --- called whenever buffer is emptied.
+ *
+ * The half holding the outstanding read is handed to the decompressor, and
+ * the read of the following chunk is started into the half just consumed.
+ * Past the end of the data, dummy EOI markers are supplied, as the other
+ * source managers do.
+ */
+
+METHODDEF(boolean)
+fill_input_buffer (j_decompress_ptr cinfo)
+{
+  my_src_ptr src = (my_src_ptr) cinfo->src;
+
+  if (src->pending == 0) {
+    WARNMS(cinfo, JWRN_JPEG_EOF);
+    /* Insert a fake EOI marker */
+    src->eoi_buffer[0] = (JOCTET) 0xFF;
+    src->eoi_buffer[1] = (JOCTET) JPEG_EOI;
+    src->pub.next_input_byte = src->eoi_buffer;
+    src->pub.bytes_in_buffer = 2;
+    return TRUE;
+  }
+
+  wait_chunk(cinfo, src);
+  src->pub.next_input_byte = src->buffer[src->fill_index];
+  src->pub.bytes_in_buffer = src->pending;
+  src->pending = 0;
+
+  src->fill_index ^= 1;
+  start_next_chunk(src);
+
+  return TRUE;
+}
+
+
+/*
+ * Skip data --- used to skip over a potentially large amount of
+ * uninteresting data (such as an APPn marker).
+ *
+ * A skip beyond the outstanding chunk moves the device offset instead of
+ * reading the skipped data, so large thumbnails cost no transfer.
+ */
+
+METHODDEF(void)
+skip_input_data (j_decompress_ptr cinfo, long num_bytes)
+{
+  my_src_ptr src = (my_src_ptr) cinfo->src;
+  unsigned long skip;
+
+  if (num_bytes <= 0)
+    return;
+
+  if (num_bytes > (long) src->pub.bytes_in_buffer) {
+    num_bytes -= (long) src->pub.bytes_in_buffer;
+    src->pub.bytes_in_buffer = 0;
+
+    if (src->pending != 0 && num_bytes >= (long) src->pending) {
+      /* Drop the outstanding chunk and the whole chunks after it */
+      wait_chunk(cinfo, src);
+      num_bytes -= (long) src->pending;
+      src->pending = 0;
+      skip = (unsigned long) num_bytes;
+      if (skip > src->remaining)
+	skip = src->remaining;
+      src->next_offset += skip;
+      src->remaining -= skip;
+      num_bytes -= (long) skip;
+      start_next_chunk(src);
+    }
+
+    while (num_bytes > (long) src->pub.bytes_in_buffer) {
+      num_bytes -= (long) src->pub.bytes_in_buffer;
+      (void) fill_input_buffer(cinfo);
+    }
+  }
+
+  src->pub.next_input_byte += (size_t) num_bytes;
+  src->pub.bytes_in_buffer -= (size_t) num_bytes;
+}
+
+
+/*
+ * An additional method that can be provided by data source modules is the
+ * resync_to_restart method for error recovery in the presence of RST markers.
+ * For the moment, this source module just uses the default resync method
+ * provided by the JPEG library.  That method assumes that no backtracking
+ * is possible.
+ */
+
+
+/*
+ * Terminate source --- called by jpeg_finish_decompress
+ * after all data has been read.
+ * The read started ahead must be over before the buffer can be reused.
+ */
+
+METHODDEF(void)
+term_source (j_decompress_ptr cinfo)
+{
+  my_src_ptr src = (my_src_ptr) cinfo->src;
+
+  if (src->pending != 0) {
+    (void) (*src->reader->wait_read) (src->reader);
+    src->pending = 0;
+  }
+}
+
+
+/*
+ * Prepare for input of insize bytes stored at the given offset of a device.
+ * The buffer is split in two chunks; it must stay allocated, and untouched,
+ * until the decompression is finished.  An application aborting an image
+ * (error exit or jpeg_abort) must itself wait for the outstanding read with
+ * the reader before reusing the buffer.
+ */
+
+GLOBAL(void)
+jpeg_chunk_src (j_decompress_ptr cinfo, struct jpeg_chunk_reader * reader,
+		unsigned long offset, unsigned long insize,
+		JOCTET * buffer, size_t bufsize)
+{
+  my_src_ptr src;
+
+  if (insize == 0)		/* Treat empty input as fatal error */
+    ERREXIT(cinfo, JERR_INPUT_EMPTY);
+  if (reader == NULL || buffer == NULL || bufsize < 2)
+    ERREXIT(cinfo, JERR_BUFFER_SIZE);
+
+  /* The source object is made permanent so that a series of JPEG images
+   * can be read from the same device by calling jpeg_chunk_src only before
+   * the first one.
+   */
+  if (cinfo->src == NULL) {	/* first time for this JPEG object? */
+    cinfo->src = (struct jpeg_source_mgr *)
+      (*cinfo->mem->alloc_small) ((j_common_ptr) cinfo, JPOOL_PERMANENT,
+				  SIZEOF(my_source_mgr));
+  }
+
+  src = (my_src_ptr) cinfo->src;
+  src->pub.init_source = init_source;
+  src->pub.fill_input_buffer = fill_input_buffer;
+  src->pub.skip_input_data = skip_input_data;
+  src->pub.resync_to_restart = jpeg_resync_to_restart; /* use default method */
+  src->pub.term_source = term_source;
+  src->pub.bytes_in_buffer = 0; /* forces fill_input_buffer on first read */
+  src->pub.next_input_byte = NULL; /* until buffer loaded */
+  src->reader = reader;
+  src->start_offset = offset;
+  src->insize = insize;
+  src->remaining = 0;
+  src->pending = 0;
+  src->chunk_size = bufsize / 2;
+  src->buffer[0] = buffer;
+  src->buffer[1] = buffer + src->chunk_size;
+  src->fill_index = 0;
+}
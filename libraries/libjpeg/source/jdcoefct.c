@@ -34,6 +34,11 @@ typedef struct {
   int MCU_vert_offset;		/* counts MCU rows within iMCU row */
   int MCU_rows_per_iMCU_row;	/* number of such rows needed */
 
+  /* With a crop window, the entropy decoder may jump ahead of us:
+   * MCUs of the scan before this one were passed over without decoding.
+   */
+  JDIMENSION next_MCU_num;
+
   /* The output side's location is represented by cinfo->output_iMCU_row. */
 
   /* In single-pass modes, it's sufficient to buffer just one MCU.
@@ -106,7 +111,10 @@ start_iMCU_row (j_decompress_ptr cinfo)
 METHODDEF(void)
 start_input_pass (j_decompress_ptr cinfo)
 {
+  my_coef_ptr coef = (my_coef_ptr) cinfo->coef;
+
   cinfo->input_iMCU_row = 0;
+  coef->next_MCU_num = 0;
   start_iMCU_row(cinfo);
 }
 
@@ -141,6 +149,10 @@ start_output_pass (j_decompress_ptr cinfo)
  *
  * NB: output_buf contains a plane for each component in image,
  * which we index according to the component's SOF position.
+ *
+ * The MCUs outside the crop window (see jpeg_crop_scanline) are decoded
+ * only as far as needed to keep the DC predictions, or jumped over when
+ * the entropy decoder can seek to a later restart interval.
  */
 
 METHODDEF(int)
@@ -150,17 +162,63 @@ decompress_onepass (j_decompress_ptr cinfo, JSAMPIMAGE output_buf)
   JDIMENSION MCU_col_num;	/* index of current MCU within row */
   JDIMENSION last_MCU_col = cinfo->MCUs_per_row - 1;
   JDIMENSION last_iMCU_row = cinfo->total_iMCU_rows - 1;
+  JDIMENSION first_crop_col, last_crop_col; /* crop window, in MCUs */
+  JDIMENSION MCU_row_start, MCU_num, target;
   int blkn, ci, xindex, yindex, yoffset, useful_width;
   JSAMPARRAY output_ptr;
   JDIMENSION start_col, output_col;
   jpeg_component_info *compptr;
   inverse_DCT_method_ptr inverse_DCT;
+  boolean decoded;
+
+  /* An MCU is an iMCU column wide in an interleaved scan, a block otherwise */
+  if (cinfo->comps_in_scan > 1) {
+    first_crop_col = cinfo->master->first_iMCU_col;
+    last_crop_col = cinfo->master->last_iMCU_col;
+    MCU_row_start = cinfo->input_iMCU_row;
+  } else {
+    ci = cinfo->cur_comp_info[0]->component_index;
+    first_crop_col = cinfo->master->first_block_col[ci];
+    last_crop_col = cinfo->master->last_block_col[ci];
+    MCU_row_start = cinfo->input_iMCU_row *
+		    cinfo->cur_comp_info[0]->v_samp_factor;
+  }
 
   /* Loop to process as much as one whole iMCU row */
   for (yoffset = coef->MCU_vert_offset; yoffset < coef->MCU_rows_per_iMCU_row;
        yoffset++) {
+    /* Index within the scan of the first MCU of this row */
+    MCU_num = (MCU_row_start + (JDIMENSION) yoffset) * cinfo->MCUs_per_row;
     for (MCU_col_num = coef->MCU_ctr; MCU_col_num <= last_MCU_col;
 	 MCU_col_num++) {
+      if (MCU_col_num < first_crop_col || MCU_col_num > last_crop_col) {
+	/* Outside the crop window: skip the MCUs already jumped over, else
+	 * try to jump to the window of this row, or of the next one.
+	 */
+	if (MCU_num + MCU_col_num < coef->next_MCU_num)
+	  continue;
+	if (cinfo->entropy->seek_mcu != NULL) {
+	  target = MCU_num + first_crop_col;
+	  if (MCU_col_num > last_crop_col)
+	    target += cinfo->MCUs_per_row;
+	  coef->next_MCU_num = (*cinfo->entropy->seek_mcu)
+	    (cinfo, MCU_num + MCU_col_num, target);
+	  if (coef->next_MCU_num > MCU_num + MCU_col_num)
+	    continue;
+	}
+	/* The coefficients are not used, so the buffer needs no zeroing */
+	if (cinfo->entropy->skip_mcu != NULL)
+	  decoded = (*cinfo->entropy->skip_mcu) (cinfo);
+	else
+	  decoded = (*cinfo->entropy->decode_mcu) (cinfo, coef->MCU_buffer);
+	if (! decoded) {
+	  /* Suspension forced; update state counters and exit */
+	  coef->MCU_vert_offset = yoffset;
+	  coef->MCU_ctr = MCU_col_num;
+	  return JPEG_SUSPENDED;
+	}
+	continue;
+      }
       /* Try to fetch an MCU.  Entropy decoder expects buffer to be zeroed. */
       jzero_far((void FAR *) coef->MCU_buffer[0],
 		(size_t) (cinfo->blocks_in_MCU * SIZEOF(JBLOCK)));
@@ -188,7 +246,7 @@ decompress_onepass (j_decompress_ptr cinfo, JSAMPIMAGE output_buf)
 						    : compptr->last_col_width;
 	output_ptr = output_buf[compptr->component_index] +
 	  yoffset * compptr->DCT_v_scaled_size;
-	start_col = MCU_col_num * compptr->MCU_sample_width;
+	start_col = (MCU_col_num - first_crop_col) * compptr->MCU_sample_width;
 	for (yindex = 0; yindex < compptr->MCU_height; yindex++) {
 	  if (cinfo->input_iMCU_row < last_iMCU_row ||
 	      yoffset+yindex < compptr->last_row_height) {
@@ -354,11 +412,12 @@ decompress_data (j_decompress_ptr cinfo, JSAMPIMAGE output_buf)
     }
     inverse_DCT = cinfo->idct->inverse_DCT[ci];
     output_ptr = output_buf[ci];
-    /* Loop over all DCT blocks to be processed. */
+    /* Loop over all DCT blocks to be processed, within the crop window. */
     for (block_row = 0; block_row < block_rows; block_row++) {
-      buffer_ptr = buffer[block_row];
+      buffer_ptr = buffer[block_row] + cinfo->master->first_block_col[ci];
       output_col = 0;
-      for (block_num = 0; block_num < compptr->width_in_blocks; block_num++) {
+      for (block_num = cinfo->master->first_block_col[ci];
+	   block_num <= cinfo->master->last_block_col[ci]; block_num++) {
 	(*inverse_DCT) (cinfo, compptr, (JCOEFPTR) buffer_ptr,
 			output_ptr, output_col);
 	buffer_ptr++;
@@ -558,7 +617,19 @@ decompress_smooth_data (j_decompress_ptr cinfo, JSAMPIMAGE output_buf)
       DC7 = DC8 = DC9 = (int) next_block_row[0][0];
       output_col = 0;
       last_block_column = compptr->width_in_blocks - 1;
-      for (block_num = 0; block_num <= last_block_column; block_num++) {
+      /* Start at the crop window, with the DC values left of it */
+      block_num = cinfo->master->first_block_col[ci];
+      if (block_num > 0) {
+	buffer_ptr += block_num, prev_block_row += block_num,
+	  next_block_row += block_num;
+	DC1 = (int) prev_block_row[-1][0];
+	DC2 = DC3 = (int) prev_block_row[0][0];
+	DC4 = (int) buffer_ptr[-1][0];
+	DC5 = DC6 = (int) buffer_ptr[0][0];
+	DC7 = (int) next_block_row[-1][0];
+	DC8 = DC9 = (int) next_block_row[0][0];
+      }
+      for (; block_num <= cinfo->master->last_block_col[ci]; block_num++) {
 	/* Fetch current DCT block into workspace so we can modify it. */
 	jcopy_block_row(buffer_ptr, (JBLOCKROW) workspace, (JDIMENSION) 1);
 	/* Update DC values */
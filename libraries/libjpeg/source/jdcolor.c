@@ -23,6 +23,9 @@ typedef struct {
   int * Cb_b_tab;		/* => table for Cb to B conversion */
   INT32 * Cr_g_tab;		/* => table for Cr to G conversion */
   INT32 * Cb_g_tab;		/* => table for Cb to G conversion */
+
+  /* Private state for direct output (see jpeg_set_output_port) */
+  volatile JSAMPLE * port;	/* => data register receiving the pixels */
 } my_color_deconverter;
 
 typedef my_color_deconverter * my_cconvert_ptr;
@@ -285,6 +288,142 @@ ycck_cmyk_convert (j_decompress_ptr cinfo,
 }
 
 
+/**************** Direct output to a data port **************/
+
+/*
+ * These methods replace the RGB conversions above when the application
+ * has called jpeg_set_output_port().  Each converted pixel is written
+ * straight to the port as R, G, B samples, in the order of the scanlines,
+ * instead of being stored in the caller's output buffer: this suits a
+ * display controller whose frame memory is filled through a single data
+ * register, after the application has opened the output window.
+ * output_buf is not used, and the dummy buffer given to jpeg_read_scanlines
+ * is never written.
+ */
+
+METHODDEF(void)
+ycc_port_convert (j_decompress_ptr cinfo,
+		  JSAMPIMAGE input_buf, JDIMENSION input_row,
+		  JSAMPARRAY output_buf, int num_rows)
+{
+  my_cconvert_ptr cconvert = (my_cconvert_ptr) cinfo->cconvert;
+  register int y, cb, cr;
+  register JSAMPROW inptr0, inptr1, inptr2;
+  register JDIMENSION col;
+  JDIMENSION num_cols = cinfo->output_width;
+  /* copy these pointers into registers if possible */
+  register volatile JSAMPLE * port = cconvert->port;
+  register JSAMPLE * range_limit = cinfo->sample_range_limit;
+  register int * Crrtab = cconvert->Cr_r_tab;
+  register int * Cbbtab = cconvert->Cb_b_tab;
+  register INT32 * Crgtab = cconvert->Cr_g_tab;
+  register INT32 * Cbgtab = cconvert->Cb_g_tab;
+  SHIFT_TEMPS
+
+  while (--num_rows >= 0) {
+    inptr0 = input_buf[0][input_row];
+    inptr1 = input_buf[1][input_row];
+    inptr2 = input_buf[2][input_row];
+    input_row++;
+    for (col = 0; col < num_cols; col++) {
+      y  = GETJSAMPLE(inptr0[col]);
+      cb = GETJSAMPLE(inptr1[col]);
+      cr = GETJSAMPLE(inptr2[col]);
+      *port = range_limit[y + Crrtab[cr]];
+      *port = range_limit[y +
+			  ((int) RIGHT_SHIFT(Cbgtab[cb] + Crgtab[cr],
+					     SCALEBITS))];
+      *port = range_limit[y + Cbbtab[cb]];
+    }
+  }
+}
+
+
+METHODDEF(void)
+gray_port_convert (j_decompress_ptr cinfo,
+		   JSAMPIMAGE input_buf, JDIMENSION input_row,
+		   JSAMPARRAY output_buf, int num_rows)
+{
+  my_cconvert_ptr cconvert = (my_cconvert_ptr) cinfo->cconvert;
+  register volatile JSAMPLE * port = cconvert->port;
+  register JSAMPROW inptr;
+  register JSAMPLE gray;
+  register JDIMENSION col;
+  JDIMENSION num_cols = cinfo->output_width;
+
+  while (--num_rows >= 0) {
+    inptr = input_buf[0][input_row++];
+    for (col = 0; col < num_cols; col++) {
+      gray = inptr[col];
+      *port = gray;
+      *port = gray;
+      *port = gray;
+    }
+  }
+}
+
+
+METHODDEF(void)
+rgb_port_convert (j_decompress_ptr cinfo,
+		  JSAMPIMAGE input_buf, JDIMENSION input_row,
+		  JSAMPARRAY output_buf, int num_rows)
+{
+  my_cconvert_ptr cconvert = (my_cconvert_ptr) cinfo->cconvert;
+  register volatile JSAMPLE * port = cconvert->port;
+  register JSAMPROW inptr0, inptr1, inptr2;
+  register JDIMENSION col;
+  JDIMENSION num_cols = cinfo->output_width;
+
+  while (--num_rows >= 0) {
+    inptr0 = input_buf[0][input_row];
+    inptr1 = input_buf[1][input_row];
+    inptr2 = input_buf[2][input_row];
+    input_row++;
+    for (col = 0; col < num_cols; col++) {
+      *port = inptr0[col];
+      *port = inptr1[col];
+      *port = inptr2[col];
+    }
+  }
+}
+
+
+/*
+ * Route the decoded pixels to a data port instead of the output buffer.
+ * Must be called after jpeg_start_decompress() (or jpeg_start_output() in
+ * buffered-image mode), for RGB output without color quantization nor
+ * merged upsampling (do_fancy_upsampling must stay TRUE for 2h1v and 2h2v
+ * sampled files).  The color conversion then packs each pixel into the
+ * port as it is produced, so no RGB scanline is stored in memory.
+ */
+
+GLOBAL(void)
+jpeg_set_output_port (j_decompress_ptr cinfo, volatile JSAMPLE * port)
+{
+  my_cconvert_ptr cconvert = (my_cconvert_ptr) cinfo->cconvert;
+
+  if (cinfo->global_state != DSTATE_SCANNING &&
+      cinfo->global_state != DSTATE_BUFIMAGE)
+    ERREXIT1(cinfo, JERR_BAD_STATE, cinfo->global_state);
+  if (cconvert == NULL || cinfo->quantize_colors ||
+      cinfo->out_color_space != JCS_RGB)
+    ERREXIT(cinfo, JERR_CONVERSION_NOTIMPL);
+
+  if (cconvert->pub.color_convert == ycc_rgb_convert)
+    cconvert->pub.color_convert = ycc_port_convert;
+  else if (cconvert->pub.color_convert == gray_rgb_convert)
+    cconvert->pub.color_convert = gray_port_convert;
+  else if (cconvert->pub.color_convert == null_convert)
+    cconvert->pub.color_convert = rgb_port_convert;
+  else if (cconvert->pub.color_convert != ycc_port_convert &&
+	   cconvert->pub.color_convert != gray_port_convert &&
+	   cconvert->pub.color_convert != rgb_port_convert)
+    ERREXIT(cinfo, JERR_CONVERSION_NOTIMPL);
+
+  cconvert->port = port;
+}
+
+
 /*
  * Empty method for start_pass.
  */
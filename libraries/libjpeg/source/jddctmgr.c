@@ -65,6 +65,9 @@ typedef union {
 #ifdef DCT_FLOAT_SUPPORTED
   FLOAT_MULT_TYPE float_array[DCTSIZE2];
 #endif
+#ifdef DCT_M3_SUPPORTED
+  IM3_MULT_TYPE im3_array[DCTSIZE2];
+#endif
 } multiplier_table;
 
 
@@ -80,6 +83,31 @@ typedef union {
 #endif
 
 
+#if defined(DCT_IFAST_SUPPORTED) || defined(DCT_M3_SUPPORTED)
+
+/* AA&N scale factors of the IFAST and M3 multiplier tables:
+ *   scalefactor[0] = 1
+ *   scalefactor[k] = cos(k*PI/16) * sqrt(2)    for k=1..7
+ * aanscales[row*8+col] = scalefactor[row]*scalefactor[col], scaled up by
+ * CONST_BITS.
+ */
+
+#define CONST_BITS 14
+static const INT16 aanscales[DCTSIZE2] = {
+  /* precomputed values scaled up by 14 bits */
+  16384, 22725, 21407, 19266, 16384, 12873,  8867,  4520,
+  22725, 31521, 29692, 26722, 22725, 17855, 12299,  6270,
+  21407, 29692, 27969, 25172, 21407, 16819, 11585,  5906,
+  19266, 26722, 25172, 22654, 19266, 15137, 10426,  5315,
+  16384, 22725, 21407, 19266, 16384, 12873,  8867,  4520,
+  12873, 17855, 16819, 15137, 12873, 10114,  6967,  3552,
+   8867, 12299, 11585, 10426,  8867,  6967,  4799,  2446,
+   4520,  6270,  5906,  5315,  4520,  3552,  2446,  1247
+};
+
+#endif
+
+
 /*
  * Prepare for an output pass.
  * Here we select the proper IDCT routine for each component and build
@@ -102,10 +130,20 @@ start_pass (j_decompress_ptr cinfo)
     switch ((compptr->DCT_h_scaled_size << 8) + compptr->DCT_v_scaled_size) {
 #ifdef IDCT_SCALING_SUPPORTED
     case ((1 << 8) + 1):
+#ifdef DCT_M3_SUPPORTED
+      if (cinfo->dct_method == JDCT_M3)
+	method_ptr = jpeg_idct_m3_1x1;
+      else
+#endif
       method_ptr = jpeg_idct_1x1;
       method = JDCT_ISLOW;	/* jidctint uses islow-style table */
       break;
     case ((2 << 8) + 2):
+#ifdef DCT_M3_SUPPORTED
+      if (cinfo->dct_method == JDCT_M3)
+	method_ptr = jpeg_idct_m3_2x2;
+      else
+#endif
       method_ptr = jpeg_idct_2x2;
       method = JDCT_ISLOW;	/* jidctint uses islow-style table */
       break;
@@ -114,6 +152,11 @@ start_pass (j_decompress_ptr cinfo)
       method = JDCT_ISLOW;	/* jidctint uses islow-style table */
       break;
     case ((4 << 8) + 4):
+#ifdef DCT_M3_SUPPORTED
+      if (cinfo->dct_method == JDCT_M3)
+	method_ptr = jpeg_idct_m3_4x4;
+      else
+#endif
       method_ptr = jpeg_idct_4x4;
       method = JDCT_ISLOW;	/* jidctint uses islow-style table */
       break;
@@ -245,6 +288,12 @@ start_pass (j_decompress_ptr cinfo)
 	method_ptr = jpeg_idct_float;
 	method = JDCT_FLOAT;
 	break;
+#endif
+#ifdef DCT_M3_SUPPORTED
+      case JDCT_M3:
+	method_ptr = jpeg_idct_m3;
+	method = JDCT_M3;
+	break;
 #endif
       default:
 	ERREXIT(cinfo, JERR_NOT_COMPILED);
@@ -295,18 +344,6 @@ start_pass (j_decompress_ptr cinfo)
 	 * IFAST_SCALE_BITS.
 	 */
 	IFAST_MULT_TYPE * ifmtbl = (IFAST_MULT_TYPE *) compptr->dct_table;
-#define CONST_BITS 14
-	static const INT16 aanscales[DCTSIZE2] = {
-	  /* precomputed values scaled up by 14 bits */
-	  16384, 22725, 21407, 19266, 16384, 12873,  8867,  4520,
-	  22725, 31521, 29692, 26722, 22725, 17855, 12299,  6270,
-	  21407, 29692, 27969, 25172, 21407, 16819, 11585,  5906,
-	  19266, 26722, 25172, 22654, 19266, 15137, 10426,  5315,
-	  16384, 22725, 21407, 19266, 16384, 12873,  8867,  4520,
-	  12873, 17855, 16819, 15137, 12873, 10114,  6967,  3552,
-	   8867, 12299, 11585, 10426,  8867,  6967,  4799,  2446,
-	   4520,  6270,  5906,  5315,  4520,  3552,  2446,  1247
-	};
 	SHIFT_TEMPS
 
 	for (i = 0; i < DCTSIZE2; i++) {
@@ -318,6 +355,24 @@ start_pass (j_decompress_ptr cinfo)
       }
       break;
 #endif
+#ifdef DCT_M3_SUPPORTED
+    case JDCT_M3:
+      {
+	/* Same AA&N scaled multipliers as for JDCT_IFAST, but kept in
+	 * 32-bit entries with IM3_SCALE_BITS fractional bits.
+	 */
+	IM3_MULT_TYPE * im3tbl = (IM3_MULT_TYPE *) compptr->dct_table;
+	SHIFT_TEMPS
+
+	for (i = 0; i < DCTSIZE2; i++) {
+	  im3tbl[i] = (IM3_MULT_TYPE)
+	    DESCALE(MULTIPLY16V16((INT32) qtbl->quantval[i],
+				  (INT32) aanscales[i]),
+		    CONST_BITS-IM3_SCALE_BITS);
+	}
+      }
+      break;
+#endif
 #ifdef DCT_FLOAT_SUPPORTED
     case JDCT_FLOAT:
       {
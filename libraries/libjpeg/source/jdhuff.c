@@ -23,7 +23,7 @@
 
 /* Derived data constructed for each Huffman table */
 
-#define HUFF_LOOKAHEAD	8	/* # of bits of lookahead */
+#define HUFF_LOOKAHEAD	9	/* # of bits of lookahead */
 
 typedef struct {
   /* Basic tables: (element [0] of each array is unused) */
@@ -38,15 +38,27 @@ typedef struct {
   /* Link to public Huffman table (needed only in jpeg_huff_decode) */
   JHUFF_TBL *pub;
 
-  /* Lookahead tables: indexed by the next HUFF_LOOKAHEAD bits of
+  /* Lookahead table: indexed by the next HUFF_LOOKAHEAD bits of
    * the input data stream.  If the next Huffman code is no more
    * than HUFF_LOOKAHEAD bits long, we can obtain its length and
-   * the corresponding symbol directly from these tables.
+   * the corresponding symbol directly from this table.
+   * Each entry is (# bits << 8) | symbol, # bits being 0 if too long.
    */
-  int look_nbits[1<<HUFF_LOOKAHEAD]; /* # bits, or 0 if too long */
-  UINT8 look_sym[1<<HUFF_LOOKAHEAD]; /* symbol, or unused */
+  UINT16 lookup[1<<HUFF_LOOKAHEAD];
+
+  /* Combined lookahead table of AC tables (NULL for DC tables): when the
+   * next code and its extra bits fit in HUFF_LOOKAHEAD bits, the entry
+   * gives at once (total # bits << 12) | (run << 8) | coefficient value,
+   * the value being a signed byte, 0 for EOB and ZRL.  A zero entry means
+   * that the code must be decoded the usual way.
+   */
+  UINT16 * look_ac;
 } d_derived_tbl;
 
+#define LOOK_AC_NBITS(e)  ((e) >> 12)
+#define LOOK_AC_RUN(e)    (((e) >> 8) & 15)
+#define LOOK_AC_VALUE(e)  ((int) (((e) & 0xFF) ^ 0x80) - 0x80)
+
 
 /*
  * Fetching the next N bits from the input stream is a time-critical operation
@@ -174,10 +186,10 @@ typedef struct {		/* Bitreading working state within an MCU */
       nb = 1; goto slowlabel; \
     } \
   } \
-  look = PEEK_BITS(HUFF_LOOKAHEAD); \
-  if ((nb = htbl->look_nbits[look]) != 0) { \
+  look = htbl->lookup[PEEK_BITS(HUFF_LOOKAHEAD)]; \
+  if ((nb = look >> 8) != 0) { \
     DROP_BITS(nb); \
-    result = htbl->look_sym[look]; \
+    result = look & 0xFF; \
   } else { \
     nb = HUFF_LOOKAHEAD+1; \
 slowlabel: \
@@ -232,6 +244,11 @@ typedef struct {
   boolean insufficient_data;	/* set TRUE after emitting warning */
   unsigned int restarts_to_go;	/* MCUs left in this restart interval */
 
+  /* Restart marker index state (sequential mode only) */
+  struct jpeg_restart_index * index; /* cinfo->restart_index, if usable */
+  const JOCTET * scan_data;	/* start of the entropy-coded data */
+  JDIMENSION cur_interval;	/* number of the current restart interval */
+
   /* Following two fields used only in progressive mode */
 
   /* Pointers to derived tables (these workspaces have image lifespan) */
@@ -326,7 +343,7 @@ jpeg_make_d_derived_tbl (j_decompress_ptr cinfo, boolean isDC, int tblno,
   JHUFF_TBL *htbl;
   d_derived_tbl *dtbl;
   int p, i, l, si, numsymbols;
-  int lookbits, ctr;
+  int lookbits, ctr, r, s, v;
   char huffsize[257];
   unsigned int huffcode[257];
   unsigned int code;
@@ -344,10 +361,12 @@ jpeg_make_d_derived_tbl (j_decompress_ptr cinfo, boolean isDC, int tblno,
     ERREXIT1(cinfo, JERR_NO_HUFF_TABLE, tblno);
 
   /* Allocate a workspace if we haven't already done so. */
-  if (*pdtbl == NULL)
+  if (*pdtbl == NULL) {
     *pdtbl = (d_derived_tbl *)
       (*cinfo->mem->alloc_small) ((j_common_ptr) cinfo, JPOOL_IMAGE,
 				  SIZEOF(d_derived_tbl));
+    (*pdtbl)->look_ac = NULL;
+  }
   dtbl = *pdtbl;
   dtbl->pub = htbl;		/* fill in back link */
   
@@ -408,7 +427,7 @@ jpeg_make_d_derived_tbl (j_decompress_ptr cinfo, boolean isDC, int tblno,
    * with that code.
    */
 
-  MEMZERO(dtbl->look_nbits, SIZEOF(dtbl->look_nbits));
+  MEMZERO(dtbl->lookup, SIZEOF(dtbl->lookup));
 
   p = 0;
   for (l = 1; l <= HUFF_LOOKAHEAD; l++) {
@@ -417,13 +436,42 @@ jpeg_make_d_derived_tbl (j_decompress_ptr cinfo, boolean isDC, int tblno,
       /* Generate left-justified code followed by all possible bit sequences */
       lookbits = huffcode[p] << (HUFF_LOOKAHEAD-l);
       for (ctr = 1 << (HUFF_LOOKAHEAD-l); ctr > 0; ctr--) {
-	dtbl->look_nbits[lookbits] = l;
-	dtbl->look_sym[lookbits] = htbl->huffval[p];
+	dtbl->lookup[lookbits] = (UINT16) ((l << 8) | htbl->huffval[p]);
 	lookbits++;
       }
     }
   }
 
+  /* For AC tables, also resolve the extra bits of the codes when they fit
+   * in the lookahead with a value in signed byte range (up to 7 extra bits).
+   * This includes most coefficients of high quality images.
+   */
+  if (! isDC) {
+    if (dtbl->look_ac == NULL)
+      dtbl->look_ac = (UINT16 *)
+	(*cinfo->mem->alloc_small) ((j_common_ptr) cinfo, JPOOL_IMAGE,
+				    (1<<HUFF_LOOKAHEAD) * SIZEOF(UINT16));
+    for (lookbits = 0; lookbits < (1<<HUFF_LOOKAHEAD); lookbits++) {
+      l = dtbl->lookup[lookbits] >> 8;
+      r = (dtbl->lookup[lookbits] >> 4) & 15;
+      s = dtbl->lookup[lookbits] & 15;
+      dtbl->look_ac[lookbits] = 0;
+      if (l == 0 || l + s > HUFF_LOOKAHEAD || s > 7)
+	continue;		/* decoded the usual way */
+      if (s) {
+	/* Fetch the extra bits following the code, and extend the sign */
+	v = (lookbits >> (HUFF_LOOKAHEAD - l - s)) & ((1 << s) - 1);
+	if (v < (1 << (s - 1)))
+	  v -= (1 << s) - 1;
+      } else {
+	if (r != 0 && r != 15)
+	  continue;		/* not EOB nor ZRL, left to the usual way */
+	v = 0;
+      }
+      dtbl->look_ac[lookbits] = (UINT16) (((l + s) << 12) | (r << 8) | (v & 0xFF));
+    }
+  }
+
   /* Validate symbols as being reasonable.
    * For AC tables, we make no check, but accept all byte values 0..255.
    * For DC tables, we require the symbols to be in range 0..15.
@@ -477,6 +525,34 @@ jpeg_fill_bit_buffer (bitread_working_state * state,
   /* We fail to do so only if we hit a marker or are forced to suspend. */
 
   if (cinfo->unread_marker == 0) {	/* cannot advance past a marker */
+#if BIT_BUF_SIZE == 32 && ! defined(SLOW_SHIFT_32)
+    /* Fast path: when the next four bytes are in the buffer and none of
+     * them is 0xFF, there can be no stuffed byte nor marker among them,
+     * so as many whole bytes as fit are shifted in at once.  This always
+     * reaches MIN_GET_BITS; the byte loop below handles the other cases.
+     */
+    if (bits_left < MIN_GET_BITS && bytes_in_buffer >= 4) {
+      register unsigned long word;
+      register int nbytes;
+
+      word = ((unsigned long) GETJOCTET(next_input_byte[0]) << 24) |
+	     ((unsigned long) GETJOCTET(next_input_byte[1]) << 16) |
+	     ((unsigned long) GETJOCTET(next_input_byte[2]) << 8) |
+	      (unsigned long) GETJOCTET(next_input_byte[3]);
+      /* Zero unless the complement has a zero byte, i.e. word has a 0xFF */
+      if (((~word - 0x01010101UL) & word & 0x80808080UL) == 0) {
+	nbytes = (BIT_BUF_SIZE - bits_left) >> 3;
+	if (nbytes == 4)
+	  get_buffer = (bit_buf_type) word;
+	else
+	  get_buffer = (get_buffer << (nbytes << 3)) |
+		       (bit_buf_type) (word >> ((4 - nbytes) << 3));
+	bits_left += nbytes << 3;
+	next_input_byte += nbytes;
+	bytes_in_buffer -= nbytes;
+      }
+    }
+#endif
     while (bits_left < MIN_GET_BITS) {
       register int c;
 
@@ -656,6 +732,14 @@ process_restart (j_decompress_ptr cinfo)
   /* Reset restart counter */
   entropy->restarts_to_go = cinfo->restart_interval;
 
+  /* Record where the new interval starts, if it extends the index */
+  entropy->cur_interval++;
+  if (entropy->index != NULL &&
+      entropy->cur_interval == entropy->index->num_entries &&
+      entropy->index->num_entries < entropy->index->max_entries)
+    entropy->index->offsets[entropy->index->num_entries++] = (unsigned long)
+      (cinfo->src->next_input_byte - entropy->scan_data);
+
   /* Reset out-of-data flag, unless read_restart_marker left us smack up
    * against a marker.  In that case we will end up treating the next data
    * segment as empty, and we can avoid producing bogus output pixels by
@@ -1240,6 +1324,28 @@ decode_mcu (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 	/* Section F.2.2.2: decode the AC coefficients */
 	/* Since zeroes are skipped, output area must be cleared beforehand */
 	for (; k < coef_limit; k++) {
+	  /* Most codes and their extra bits are resolved by one lookup */
+	  if (bits_left < HUFF_LOOKAHEAD) {
+	    if (! jpeg_fill_bit_buffer(&br_state,get_buffer,bits_left, 0))
+	      return FALSE;
+	    get_buffer = br_state.get_buffer; bits_left = br_state.bits_left;
+	  }
+	  if (bits_left >= HUFF_LOOKAHEAD &&
+	      (r = htbl->look_ac[PEEK_BITS(HUFF_LOOKAHEAD)]) != 0) {
+	    DROP_BITS(LOOK_AC_NBITS(r));
+	    s = LOOK_AC_VALUE(r);
+	    r = LOOK_AC_RUN(r);
+	    if (s) {
+	      k += r;
+	      (*block)[jpeg_natural_order[k]] = (JCOEF) s;
+	      continue;
+	    }
+	    if (r != 15)
+	      goto EndOfBlock;
+	    k += 15;
+	    continue;
+	  }
+
 	  HUFF_DECODE(s, br_state, htbl, return FALSE, label2);
 
 	  r = s >> 4;
@@ -1302,6 +1408,134 @@ decode_mcu (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 }
 
 
+/*
+ * Decode one MCU of a sequential scan without storing anything, for
+ * cropped output.  Only the DC predictions are kept.
+ */
+
+METHODDEF(boolean)
+skip_mcu (j_decompress_ptr cinfo)
+{
+  huff_entropy_ptr entropy = (huff_entropy_ptr) cinfo->entropy;
+  int Se = cinfo->lim_Se;
+  int blkn;
+  BITREAD_STATE_VARS;
+  savable_state state;
+
+  /* Process restart marker if needed; may have to suspend */
+  if (cinfo->restart_interval) {
+    if (entropy->restarts_to_go == 0)
+      if (! process_restart(cinfo))
+	return FALSE;
+  }
+
+  if (! entropy->insufficient_data) {
+
+    /* Load up working state */
+    BITREAD_LOAD_STATE(cinfo,entropy->bitstate);
+    ASSIGN_STATE(state, entropy->saved);
+
+    for (blkn = 0; blkn < cinfo->blocks_in_MCU; blkn++) {
+      d_derived_tbl * htbl;
+      register int s, k, r;
+
+      /* Section F.2.2.1: decode the DC coefficient difference */
+      htbl = entropy->dc_cur_tbls[blkn];
+      HUFF_DECODE(s, br_state, htbl, return FALSE, label1);
+
+      if (entropy->coef_limit[blkn]) {
+	/* Update last_dc_val, as decode_mcu does */
+	if (s) {
+	  CHECK_BIT_BUFFER(br_state, s, return FALSE);
+	  r = GET_BITS(s);
+	  s = HUFF_EXTEND(r, s);
+	}
+	state.last_dc_val[cinfo->MCU_membership[blkn]] += s;
+      } else {
+	if (s) {
+	  CHECK_BIT_BUFFER(br_state, s, return FALSE);
+	  DROP_BITS(s);
+	}
+      }
+
+      /* Section F.2.2.2: discard the AC coefficients */
+      htbl = entropy->ac_cur_tbls[blkn];
+      for (k = 1; k <= Se; k++) {
+	HUFF_DECODE(s, br_state, htbl, return FALSE, label2);
+
+	r = s >> 4;
+	s &= 15;
+
+	if (s) {
+	  k += r;
+	  CHECK_BIT_BUFFER(br_state, s, return FALSE);
+	  DROP_BITS(s);
+	} else {
+	  if (r != 15)
+	    break;
+	  k += 15;
+	}
+      }
+    }
+
+    /* Completed MCU, so update state */
+    BITREAD_SAVE_STATE(cinfo,entropy->bitstate);
+    ASSIGN_STATE(entropy->saved, state);
+  }
+
+  /* Account for restart interval (no-op if not using restarts) */
+  entropy->restarts_to_go--;
+
+  return TRUE;
+}
+
+
+/*
+ * Jump from the MCU MCU_num of a sequential scan to the start of the
+ * restart interval holding the MCU target, when the restart index knows
+ * this interval and it starts after MCU_num.  Returns the number of the
+ * next MCU to decode, MCU_num if no jump was possible.
+ * The offsets are only meaningful with a source holding the whole image
+ * in memory, and the jump is done through skip_input_data().
+ */
+
+METHODDEF(JDIMENSION)
+seek_mcu (j_decompress_ptr cinfo, JDIMENSION MCU_num, JDIMENSION target)
+{
+  huff_entropy_ptr entropy = (huff_entropy_ptr) cinfo->entropy;
+  JDIMENSION interval;
+  const JOCTET * data;
+  int ci;
+
+  if (entropy->index == NULL)
+    return MCU_num;
+  interval = target / cinfo->restart_interval;
+  if (interval >= entropy->index->num_entries ||
+      interval * cinfo->restart_interval <= MCU_num)
+    return MCU_num;
+  data = entropy->scan_data + entropy->index->offsets[interval];
+  if (data < cinfo->src->next_input_byte)
+    return MCU_num;		/* not ahead of us: corrupt index or data */
+
+  /* Drop the bit buffer and any marker met, and move to the interval data */
+  entropy->bitstate.bits_left = 0;
+  cinfo->unread_marker = 0;
+  if (data > cinfo->src->next_input_byte)
+    (*cinfo->src->skip_input_data) (cinfo,
+				    (long) (data - cinfo->src->next_input_byte));
+
+  /* Start the interval as process_restart would */
+  for (ci = 0; ci < cinfo->comps_in_scan; ci++)
+    entropy->saved.last_dc_val[ci] = 0;
+  entropy->restarts_to_go = cinfo->restart_interval;
+  entropy->insufficient_data = FALSE;
+  entropy->cur_interval = interval;
+  cinfo->marker->next_restart_num = (int) (interval & 7);
+
+  return interval * cinfo->restart_interval;
+}
+
+
 /*
  * Initialize for a Huffman-compressed scan.
  */
@@ -1396,6 +1630,11 @@ start_pass_huff_decoder (j_decompress_ptr cinfo)
 
     /* Initialize private state variables */
     entropy->saved.EOBRUN = 0;
+
+    /* Cropped output is handled by the coefficient arrays */
+    entropy->pub.skip_mcu = NULL;
+    entropy->pub.seek_mcu = NULL;
+    entropy->index = NULL;
   } else {
     /* Check that the scan parameters Ss, Se, Ah/Al are OK for sequential JPEG.
      * This ought to be an error condition, but we make it a warning because
@@ -1417,6 +1656,29 @@ start_pass_huff_decoder (j_decompress_ptr cinfo)
       entropy->pub.decode_mcu = decode_mcu_sub;
     else
       entropy->pub.decode_mcu = decode_mcu;
+    entropy->pub.skip_mcu = skip_mcu;
+    entropy->pub.seek_mcu = seek_mcu;
+
+    /* Set up the restart marker index, restarting it if it was built
+     * for other data.  The scan data start is only known for certain
+     * when the source buffer still holds some of it.
+     */
+    entropy->index = cinfo->restart_index;
+    entropy->scan_data = cinfo->src->next_input_byte;
+    entropy->cur_interval = 0;
+    if (entropy->index != NULL) {
+      if (cinfo->restart_interval == 0 || cinfo->src->bytes_in_buffer == 0 ||
+	  entropy->index->max_entries == 0)
+	entropy->index = NULL;
+      else if (entropy->index->num_entries == 0 ||
+	       entropy->index->scan_data != entropy->scan_data ||
+	       entropy->index->interval != cinfo->restart_interval) {
+	entropy->index->scan_data = entropy->scan_data;
+	entropy->index->interval = cinfo->restart_interval;
+	entropy->index->offsets[0] = 0;
+	entropy->index->num_entries = 1;
+      }
+    }
 
     for (ci = 0; ci < cinfo->comps_in_scan; ci++) {
       compptr = cinfo->cur_comp_info[ci];
@@ -355,9 +355,13 @@ master_selection (j_decompress_ptr cinfo)
   /* Inverse DCT */
   jinit_inverse_dct(cinfo);
   /* Entropy decoding: either Huffman or arithmetic coding. */
-  if (cinfo->arith_code)
+  if (cinfo->arith_code) {
+#ifdef D_ARITH_CODING_SUPPORTED
     jinit_arith_decoder(cinfo);
-  else {
+#else
+    ERREXIT(cinfo, JERR_NOT_COMPILED);
+#endif
+  } else {
     jinit_huff_decoder(cinfo);
   }
 
@@ -519,6 +523,8 @@ GLOBAL(void)
 jinit_master_decompress (j_decompress_ptr cinfo)
 {
   my_master_ptr master;
+  jpeg_component_info *compptr;
+  int ci;
 
   master = (my_master_ptr)
       (*cinfo->mem->alloc_small) ((j_common_ptr) cinfo, JPOOL_IMAGE,
@@ -529,5 +535,16 @@ jinit_master_decompress (j_decompress_ptr cinfo)
 
   master->pub.is_dummy_pass = FALSE;
 
+  /* No crop window until jpeg_crop_scanline says otherwise */
+  master->pub.first_iMCU_col = 0;
+  master->pub.last_iMCU_col = (JDIMENSION)
+    jdiv_round_up((long) cinfo->image_width,
+		  (long) (cinfo->max_h_samp_factor * cinfo->block_size)) - 1;
+  for (ci = 0, compptr = cinfo->comp_info; ci < cinfo->num_components;
+       ci++, compptr++) {
+    master->pub.first_block_col[ci] = 0;
+    master->pub.last_block_col[ci] = compptr->width_in_blocks - 1;
+  }
+
   master_selection(cinfo);
 }
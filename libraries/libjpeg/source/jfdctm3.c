@@ -0,0 +1,189 @@
+/*
+ * jfdctm3.c
+ *
+ * This file is part of the Independent JPEG Group's software.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * This file contains a forward DCT routine tuned for the ARM Cortex-M3
+ * (JDCT_M3).
+ *
+ * It uses the same Arai, Agui, and Nakajima algorithm as jfdctfst.c, with
+ * its 5 multiplies and 29 adds per 1-D DCT, the AA&N scale factors being
+ * folded into the quantization step.  As in jidctm3.c, the single-cycle
+ * 32x32->32 multiplier of the Cortex-M3 lets us keep more fractional bits:
+ * the first pass outputs carry FM3_SCALE_BITS of them and the constants 10,
+ * for about the cost of JDCT_IFAST but much closer to JDCT_ISLOW results.
+ * The outputs are thus scaled up by 8 * 2^FM3_SCALE_BITS and by the AA&N
+ * scale factors; jcdctmgr.c accounts for both in the JDCT_M3 divisors,
+ * which it applies by multiplying with reciprocals rather than dividing.
+ */
+
+#define JPEG_INTERNALS
+#include "jinclude.h"
+#include "jpeglib.h"
+#include "jdct.h"		/* Private declarations for DCT subsystem */
+
+#ifdef DCT_M3_SUPPORTED
+
+
+/*
+ * This module is specialized to the case DCTSIZE = 8 and 8-bit samples.
+ */
+
+#if DCTSIZE != 8
+  Sorry, this code only copes with 8x8 DCTs. /* deliberate syntax err */
+#endif
+
+#if BITS_IN_JSAMPLE != 8
+  Sorry, this code only copes with 8-bit samples. /* deliberate syntax err */
+#endif
+
+
+/* The second pass products reach about 2^28, so DCTELEM must be 32 bits
+ * wide, as int is on the Cortex-M3.
+ */
+
+#define CONST_BITS  10
+#define PASS1_BITS  FM3_SCALE_BITS
+
+#define FIX_0_382683433  ((INT32)  392)		/* FIX(0.382683433) */
+#define FIX_0_541196100  ((INT32)  554)		/* FIX(0.541196100) */
+#define FIX_0_707106781  ((INT32)  724)		/* FIX(0.707106781) */
+#define FIX_1_306562965  ((INT32)  1338)	/* FIX(1.306562965) */
+
+
+/* Multiply a DCTELEM variable by an INT32 constant and descale by n bits,
+ * with rounding.
+ */
+
+#define MULTIPLY(var,const,n)  ((DCTELEM) DESCALE((var) * (const), (n)))
+
+
+/*
+ * Perform the forward DCT on one block of samples.
+ */
+
+GLOBAL(void)
+jpeg_fdct_m3 (DCTELEM * data, JSAMPARRAY sample_data, JDIMENSION start_col)
+{
+  DCTELEM tmp0, tmp1, tmp2, tmp3, tmp4, tmp5, tmp6, tmp7;
+  DCTELEM tmp10, tmp11, tmp12, tmp13;
+  DCTELEM z1, z2, z3, z4, z5, z11, z13;
+  DCTELEM *dataptr;
+  JSAMPROW elemptr;
+  int ctr;
+  SHIFT_TEMPS
+
+  /* Pass 1: process rows.
+   * The outputs are scaled up by 2^PASS1_BITS: the sums by a shift, and
+   * the products by descaling them CONST_BITS-PASS1_BITS bits only.
+   */
+
+  dataptr = data;
+  for (ctr = 0; ctr < DCTSIZE; ctr++) {
+    elemptr = sample_data[ctr] + start_col;
+
+    /* Load data into workspace */
+    tmp0 = GETJSAMPLE(elemptr[0]) + GETJSAMPLE(elemptr[7]);
+    tmp7 = GETJSAMPLE(elemptr[0]) - GETJSAMPLE(elemptr[7]);
+    tmp1 = GETJSAMPLE(elemptr[1]) + GETJSAMPLE(elemptr[6]);
+    tmp6 = GETJSAMPLE(elemptr[1]) - GETJSAMPLE(elemptr[6]);
+    tmp2 = GETJSAMPLE(elemptr[2]) + GETJSAMPLE(elemptr[5]);
+    tmp5 = GETJSAMPLE(elemptr[2]) - GETJSAMPLE(elemptr[5]);
+    tmp3 = GETJSAMPLE(elemptr[3]) + GETJSAMPLE(elemptr[4]);
+    tmp4 = GETJSAMPLE(elemptr[3]) - GETJSAMPLE(elemptr[4]);
+
+    /* Even part */
+
+    tmp10 = tmp0 + tmp3;	/* phase 2 */
+    tmp13 = tmp0 - tmp3;
+    tmp11 = tmp1 + tmp2;
+    tmp12 = tmp1 - tmp2;
+
+    /* Apply unsigned->signed conversion */
+    dataptr[0] = (tmp10 + tmp11 - 8 * CENTERJSAMPLE) << PASS1_BITS; /* phase 3 */
+    dataptr[4] = (tmp10 - tmp11) << PASS1_BITS;
+
+    z1 = MULTIPLY(tmp12 + tmp13, FIX_0_707106781, CONST_BITS-PASS1_BITS); /* c4 */
+    tmp13 <<= PASS1_BITS;
+    dataptr[2] = tmp13 + z1;	/* phase 5 */
+    dataptr[6] = tmp13 - z1;
+
+    /* Odd part */
+
+    tmp10 = tmp4 + tmp5;	/* phase 2 */
+    tmp11 = tmp5 + tmp6;
+    tmp12 = tmp6 + tmp7;
+
+    /* The rotator is modified from fig 4-8 to avoid extra negations. */
+    z5 = MULTIPLY(tmp10 - tmp12, FIX_0_382683433, CONST_BITS-PASS1_BITS); /* c6 */
+    z2 = MULTIPLY(tmp10, FIX_0_541196100, CONST_BITS-PASS1_BITS) + z5; /* c2-c6 */
+    z4 = MULTIPLY(tmp12, FIX_1_306562965, CONST_BITS-PASS1_BITS) + z5; /* c2+c6 */
+    z3 = MULTIPLY(tmp11, FIX_0_707106781, CONST_BITS-PASS1_BITS); /* c4 */
+
+    tmp7 <<= PASS1_BITS;
+    z11 = tmp7 + z3;		/* phase 5 */
+    z13 = tmp7 - z3;
+
+    dataptr[5] = z13 + z2;	/* phase 6 */
+    dataptr[3] = z13 - z2;
+    dataptr[1] = z11 + z4;
+    dataptr[7] = z11 - z4;
+
+    dataptr += DCTSIZE;		/* advance pointer to next row */
+  }
+
+  /* Pass 2: process columns.
+   * The scaling of pass 1 is kept, the products are fully descaled.
+   */
+
+  dataptr = data;
+  for (ctr = DCTSIZE-1; ctr >= 0; ctr--) {
+    tmp0 = dataptr[DCTSIZE*0] + dataptr[DCTSIZE*7];
+    tmp7 = dataptr[DCTSIZE*0] - dataptr[DCTSIZE*7];
+    tmp1 = dataptr[DCTSIZE*1] + dataptr[DCTSIZE*6];
+    tmp6 = dataptr[DCTSIZE*1] - dataptr[DCTSIZE*6];
+    tmp2 = dataptr[DCTSIZE*2] + dataptr[DCTSIZE*5];
+    tmp5 = dataptr[DCTSIZE*2] - dataptr[DCTSIZE*5];
+    tmp3 = dataptr[DCTSIZE*3] + dataptr[DCTSIZE*4];
+    tmp4 = dataptr[DCTSIZE*3] - dataptr[DCTSIZE*4];
+
+    /* Even part */
+
+    tmp10 = tmp0 + tmp3;	/* phase 2 */
+    tmp13 = tmp0 - tmp3;
+    tmp11 = tmp1 + tmp2;
+    tmp12 = tmp1 - tmp2;
+
+    dataptr[DCTSIZE*0] = tmp10 + tmp11; /* phase 3 */
+    dataptr[DCTSIZE*4] = tmp10 - tmp11;
+
+    z1 = MULTIPLY(tmp12 + tmp13, FIX_0_707106781, CONST_BITS); /* c4 */
+    dataptr[DCTSIZE*2] = tmp13 + z1; /* phase 5 */
+    dataptr[DCTSIZE*6] = tmp13 - z1;
+
+    /* Odd part */
+
+    tmp10 = tmp4 + tmp5;	/* phase 2 */
+    tmp11 = tmp5 + tmp6;
+    tmp12 = tmp6 + tmp7;
+
+    /* The rotator is modified from fig 4-8 to avoid extra negations. */
+    z5 = MULTIPLY(tmp10 - tmp12, FIX_0_382683433, CONST_BITS); /* c6 */
+    z2 = MULTIPLY(tmp10, FIX_0_541196100, CONST_BITS) + z5; /* c2-c6 */
+    z4 = MULTIPLY(tmp12, FIX_1_306562965, CONST_BITS) + z5; /* c2+c6 */
+    z3 = MULTIPLY(tmp11, FIX_0_707106781, CONST_BITS); /* c4 */
+
+    z11 = tmp7 + z3;		/* phase 5 */
+    z13 = tmp7 - z3;
+
+    dataptr[DCTSIZE*5] = z13 + z2; /* phase 6 */
+    dataptr[DCTSIZE*3] = z13 - z2;
+    dataptr[DCTSIZE*1] = z11 + z4;
+    dataptr[DCTSIZE*7] = z11 - z4;
+
+    dataptr++;			/* advance pointer to next column */
+  }
+}
+
+#endif /* DCT_M3_SUPPORTED */
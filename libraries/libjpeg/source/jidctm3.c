@@ -0,0 +1,492 @@
+/*
+ * jidctm3.c
+ *
+ * This file is part of the Independent JPEG Group's software.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * This file contains inverse DCT routines tuned for the ARM Cortex-M3
+ * (JDCT_M3).  In the IJG code, these routines must also perform
+ * dequantization of the input coefficients.
+ *
+ * The full-size routine uses the same Arai, Agui, and Nakajima algorithm as
+ * jidctfst.c, with its 5 multiplies and 29 adds per 1-D IDCT, and the AA&N
+ * scale factors folded into the dequantization table.  The Cortex-M3 has a
+ * single-cycle 32x32->32 multiplier, so unlike jidctfst.c the dequantized
+ * coefficients, the constants and all the intermediate values are kept in
+ * 32-bit words with more fractional bits.  This removes most of the
+ * accuracy loss of JDCT_IFAST at the same cost.
+ *
+ * The reduced-size routines (4x4, 2x2 and 1x1 outputs) are selected for
+ * the 1/2, 1/4 and 1/8 output scalings.  They use the ISLOW-style
+ * multiplier table, like their jidctint.c counterparts.
+ *
+ * Every routine adds CENTERJSAMPLE and the rounding fudge factor to the DC
+ * term before the last pass, so that each output sample only needs a right
+ * shift and a clamp to 0..MAXJSAMPLE.  On Thumb-2 both are done by a single
+ * USAT instruction, which replaces the mask-and-table-lookup range limiting
+ * of the other IDCT modules.
+ */
+
+#define JPEG_INTERNALS
+#include "jinclude.h"
+#include "jpeglib.h"
+#include "jdct.h"		/* Private declarations for DCT subsystem */
+
+#ifdef DCT_M3_SUPPORTED
+
+
+/*
+ * This module is specialized to the case DCTSIZE = 8 and 8-bit samples.
+ */
+
+#if DCTSIZE != 8
+  Sorry, this code only copes with 8x8 DCTs. /* deliberate syntax err */
+#endif
+
+#if BITS_IN_JSAMPLE != 8
+  Sorry, this code only copes with 8-bit samples. /* deliberate syntax err */
+#endif
+
+
+/* The dequantized coefficients of the full-size routine carry
+ * IM3_SCALE_BITS fractional bits, and the first pass keeps them so that
+ * both passes have the same input scaling.  The reduced-size routines
+ * scale their first pass outputs up by the same amount.
+ *
+ * Each product is descaled as soon as it is formed, as in jidctfst.c.
+ * With 8-bit samples, the multiply inputs never exceed about 2^17, which
+ * leaves room for 10 fractional bits in the constants (jidctfst.c has 8).
+ */
+
+#define CONST_BITS  10
+#define PASS1_BITS  IM3_SCALE_BITS
+
+#define FIX_0_541196100  ((INT32)  554)		/* FIX(0.541196100) */
+#define FIX_0_765366865  ((INT32)  784)		/* FIX(0.765366865) */
+#define FIX_1_082392200  ((INT32)  1108)	/* FIX(1.082392200) */
+#define FIX_1_414213562  ((INT32)  1448)	/* FIX(1.414213562) */
+#define FIX_1_847759065  ((INT32)  1892)	/* FIX(1.847759065) */
+#define FIX_2_613125930  ((INT32)  2676)	/* FIX(2.613125930) */
+
+
+/* Multiply an INT32 variable by an INT32 constant, and immediately
+ * descale to yield an INT32 result.
+ */
+
+#define MULTIPLY(var,const)  RIGHT_SHIFT((var) * (const), CONST_BITS)
+
+
+/* Dequantize a coefficient by multiplying it by the multiplier-table
+ * entry: a single 32-bit multiply, the AA&N scaling being already in
+ * the table for the full-size routine.
+ */
+
+#define DEQUANTIZE(coef,quantval)  (((INT32) (coef)) * (quantval))
+
+
+/* Bias to add to the DC term of the last pass, for a final descale
+ * of n bits: converts the output to unsigned form and rounds it.
+ */
+
+#define OUTPUT_BIAS(n)  (((INT32) CENTERJSAMPLE << (n)) + ((INT32) 1 << ((n)-1)))
+
+
+/* Descale a biased output value by n bits and clamp it to 0..MAXJSAMPLE.
+ * On Thumb-2, USAT does both in one instruction; otherwise we fall back on
+ * the usual range-limit table, undoing the CENTERJSAMPLE bias first.
+ */
+
+#if defined(__GNUC__) && defined(__thumb2__)
+
+#define RANGE_LIMIT_TEMPS
+#define OUTPUT_SAMPLE(x,n)  \
+    ({ INT32 usat_temp; \
+       __asm__ ("usat %0, #8, %1, asr %2" \
+		: "=r" (usat_temp) : "r" ((INT32) (x)), "I" (n)); \
+       (JSAMPLE) usat_temp; })
+
+#else
+
+#define RANGE_LIMIT_TEMPS	JSAMPLE *range_limit = IDCT_range_limit(cinfo);
+#define OUTPUT_SAMPLE(x,n)  \
+    range_limit[((int) RIGHT_SHIFT(x, n) - CENTERJSAMPLE) & RANGE_MASK]
+
+#endif
+
+
+/*
+ * Perform dequantization and inverse DCT on one block of coefficients.
+ */
+
+GLOBAL(void)
+jpeg_idct_m3 (j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	      JCOEFPTR coef_block,
+	      JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  INT32 tmp0, tmp1, tmp2, tmp3, tmp4, tmp5, tmp6, tmp7;
+  INT32 tmp10, tmp11, tmp12, tmp13;
+  INT32 z5, z10, z11, z12, z13;
+  JCOEFPTR inptr;
+  IM3_MULT_TYPE * quantptr;
+  INT32 * wsptr;
+  JSAMPROW outptr;
+  int ctr;
+  INT32 workspace[DCTSIZE2];	/* buffers data between passes */
+  RANGE_LIMIT_TEMPS
+  SHIFT_TEMPS
+
+  /* Pass 1: process columns from input, store into work array. */
+
+  inptr = coef_block;
+  quantptr = (IM3_MULT_TYPE *) compptr->dct_table;
+  wsptr = workspace;
+  for (ctr = DCTSIZE; ctr > 0; ctr--) {
+    /* Columns with all AC terms zero are frequent; each output is then
+     * equal to the dequantized DC coefficient.  See jidctfst.c.
+     */
+
+    if ((inptr[DCTSIZE*1] | inptr[DCTSIZE*2] | inptr[DCTSIZE*3] |
+	 inptr[DCTSIZE*4] | inptr[DCTSIZE*5] | inptr[DCTSIZE*6] |
+	 inptr[DCTSIZE*7]) == 0) {
+      /* AC terms all zero */
+      INT32 dcval = DEQUANTIZE(inptr[DCTSIZE*0], quantptr[DCTSIZE*0]);
+
+      wsptr[DCTSIZE*0] = dcval;
+      wsptr[DCTSIZE*1] = dcval;
+      wsptr[DCTSIZE*2] = dcval;
+      wsptr[DCTSIZE*3] = dcval;
+      wsptr[DCTSIZE*4] = dcval;
+      wsptr[DCTSIZE*5] = dcval;
+      wsptr[DCTSIZE*6] = dcval;
+      wsptr[DCTSIZE*7] = dcval;
+
+      inptr++;			/* advance pointers to next column */
+      quantptr++;
+      wsptr++;
+      continue;
+    }
+
+    /* Even part */
+
+    tmp0 = DEQUANTIZE(inptr[DCTSIZE*0], quantptr[DCTSIZE*0]);
+    tmp1 = DEQUANTIZE(inptr[DCTSIZE*2], quantptr[DCTSIZE*2]);
+    tmp2 = DEQUANTIZE(inptr[DCTSIZE*4], quantptr[DCTSIZE*4]);
+    tmp3 = DEQUANTIZE(inptr[DCTSIZE*6], quantptr[DCTSIZE*6]);
+
+    tmp10 = tmp0 + tmp2;	/* phase 3 */
+    tmp11 = tmp0 - tmp2;
+
+    tmp13 = tmp1 + tmp3;	/* phases 5-3 */
+    tmp12 = MULTIPLY(tmp1 - tmp3, FIX_1_414213562) - tmp13; /* 2*c4 */
+
+    tmp0 = tmp10 + tmp13;	/* phase 2 */
+    tmp3 = tmp10 - tmp13;
+    tmp1 = tmp11 + tmp12;
+    tmp2 = tmp11 - tmp12;
+
+    /* Odd part */
+
+    tmp4 = DEQUANTIZE(inptr[DCTSIZE*1], quantptr[DCTSIZE*1]);
+    tmp5 = DEQUANTIZE(inptr[DCTSIZE*3], quantptr[DCTSIZE*3]);
+    tmp6 = DEQUANTIZE(inptr[DCTSIZE*5], quantptr[DCTSIZE*5]);
+    tmp7 = DEQUANTIZE(inptr[DCTSIZE*7], quantptr[DCTSIZE*7]);
+
+    z13 = tmp6 + tmp5;		/* phase 6 */
+    z10 = tmp6 - tmp5;
+    z11 = tmp4 + tmp7;
+    z12 = tmp4 - tmp7;
+
+    tmp7 = z11 + z13;		/* phase 5 */
+    tmp11 = MULTIPLY(z11 - z13, FIX_1_414213562); /* 2*c4 */
+
+    z5 = MULTIPLY(z10 + z12, FIX_1_847759065); /* 2*c2 */
+    tmp10 = MULTIPLY(z12, FIX_1_082392200) - z5; /* 2*(c2-c6) */
+    tmp12 = MULTIPLY(z10, - FIX_2_613125930) + z5; /* -2*(c2+c6) */
+
+    tmp6 = tmp12 - tmp7;	/* phase 2 */
+    tmp5 = tmp11 - tmp6;
+    tmp4 = tmp10 + tmp5;
+
+    wsptr[DCTSIZE*0] = tmp0 + tmp7;
+    wsptr[DCTSIZE*7] = tmp0 - tmp7;
+    wsptr[DCTSIZE*1] = tmp1 + tmp6;
+    wsptr[DCTSIZE*6] = tmp1 - tmp6;
+    wsptr[DCTSIZE*2] = tmp2 + tmp5;
+    wsptr[DCTSIZE*5] = tmp2 - tmp5;
+    wsptr[DCTSIZE*4] = tmp3 + tmp4;
+    wsptr[DCTSIZE*3] = tmp3 - tmp4;
+
+    inptr++;			/* advance pointers to next column */
+    quantptr++;
+    wsptr++;
+  }
+
+  /* Pass 2: process rows from work array, store into output array. */
+  /* Note that we must descale the results by a factor of 8 == 2**3, */
+  /* and also undo the PASS1_BITS scaling. */
+
+  wsptr = workspace;
+  for (ctr = 0; ctr < DCTSIZE; ctr++) {
+    outptr = output_buf[ctr] + output_col;
+
+    /* Add the output bias here, the DC term reaches every output. */
+    tmp0 = wsptr[0] + OUTPUT_BIAS(PASS1_BITS+3);
+
+    /* Rows of zeroes are exploited as in jidctfst.c; all the rows of
+     * a block holding only a DC term take this path.
+     */
+
+    if ((wsptr[1] | wsptr[2] | wsptr[3] | wsptr[4] |
+	 wsptr[5] | wsptr[6] | wsptr[7]) == 0) {
+      /* AC terms all zero */
+      JSAMPLE dcval = OUTPUT_SAMPLE(tmp0, PASS1_BITS+3);
+
+      outptr[0] = dcval;
+      outptr[1] = dcval;
+      outptr[2] = dcval;
+      outptr[3] = dcval;
+      outptr[4] = dcval;
+      outptr[5] = dcval;
+      outptr[6] = dcval;
+      outptr[7] = dcval;
+
+      wsptr += DCTSIZE;		/* advance pointer to next row */
+      continue;
+    }
+
+    /* Even part */
+
+    tmp10 = tmp0 + wsptr[4];
+    tmp11 = tmp0 - wsptr[4];
+
+    tmp13 = wsptr[2] + wsptr[6];
+    tmp12 = MULTIPLY(wsptr[2] - wsptr[6], FIX_1_414213562) - tmp13;
+
+    tmp0 = tmp10 + tmp13;
+    tmp3 = tmp10 - tmp13;
+    tmp1 = tmp11 + tmp12;
+    tmp2 = tmp11 - tmp12;
+
+    /* Odd part */
+
+    z13 = wsptr[5] + wsptr[3];
+    z10 = wsptr[5] - wsptr[3];
+    z11 = wsptr[1] + wsptr[7];
+    z12 = wsptr[1] - wsptr[7];
+
+    tmp7 = z11 + z13;		/* phase 5 */
+    tmp11 = MULTIPLY(z11 - z13, FIX_1_414213562); /* 2*c4 */
+
+    z5 = MULTIPLY(z10 + z12, FIX_1_847759065); /* 2*c2 */
+    tmp10 = MULTIPLY(z12, FIX_1_082392200) - z5; /* 2*(c2-c6) */
+    tmp12 = MULTIPLY(z10, - FIX_2_613125930) + z5; /* -2*(c2+c6) */
+
+    tmp6 = tmp12 - tmp7;	/* phase 2 */
+    tmp5 = tmp11 - tmp6;
+    tmp4 = tmp10 + tmp5;
+
+    /* Final output stage: scale down by a factor of 8 and range-limit */
+
+    outptr[0] = OUTPUT_SAMPLE(tmp0 + tmp7, PASS1_BITS+3);
+    outptr[7] = OUTPUT_SAMPLE(tmp0 - tmp7, PASS1_BITS+3);
+    outptr[1] = OUTPUT_SAMPLE(tmp1 + tmp6, PASS1_BITS+3);
+    outptr[6] = OUTPUT_SAMPLE(tmp1 - tmp6, PASS1_BITS+3);
+    outptr[2] = OUTPUT_SAMPLE(tmp2 + tmp5, PASS1_BITS+3);
+    outptr[5] = OUTPUT_SAMPLE(tmp2 - tmp5, PASS1_BITS+3);
+    outptr[4] = OUTPUT_SAMPLE(tmp3 + tmp4, PASS1_BITS+3);
+    outptr[3] = OUTPUT_SAMPLE(tmp3 - tmp4, PASS1_BITS+3);
+
+    wsptr += DCTSIZE;		/* advance pointer to next row */
+  }
+}
+
+
+#ifdef IDCT_SCALING_SUPPORTED
+
+
+/*
+ * Perform dequantization and inverse DCT on one block of coefficients,
+ * producing a reduced-size 4x4 output block (1/2 scaling).
+ *
+ * Same algorithm as jpeg_idct_4x4 in jidctint.c, with 3 multiplications
+ * in the 1-D kernel, plus the zero-AC column shortcut.
+ * cK represents sqrt(2) * cos(K*pi/16) [refers to 8-point IDCT].
+ */
+
+GLOBAL(void)
+jpeg_idct_m3_4x4 (j_decompress_ptr cinfo, jpeg_component_info * compptr,
+		  JCOEFPTR coef_block,
+		  JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  INT32 tmp0, tmp2, tmp10, tmp12;
+  INT32 z1, z2, z3;
+  JCOEFPTR inptr;
+  ISLOW_MULT_TYPE * quantptr;
+  INT32 * wsptr;
+  JSAMPROW outptr;
+  int ctr;
+  INT32 workspace[4*4];	/* buffers data between passes */
+  RANGE_LIMIT_TEMPS
+  SHIFT_TEMPS
+
+  /* Pass 1: process columns from input, store into work array. */
+
+  inptr = coef_block;
+  quantptr = (ISLOW_MULT_TYPE *) compptr->dct_table;
+  wsptr = workspace;
+  for (ctr = 0; ctr < 4; ctr++, inptr++, quantptr++, wsptr++) {
+    if ((inptr[DCTSIZE*1] | inptr[DCTSIZE*2] | inptr[DCTSIZE*3]) == 0) {
+      /* AC terms all zero */
+      INT32 dcval = DEQUANTIZE(inptr[DCTSIZE*0], quantptr[DCTSIZE*0])
+		    << PASS1_BITS;
+
+      wsptr[4*0] = dcval;
+      wsptr[4*1] = dcval;
+      wsptr[4*2] = dcval;
+      wsptr[4*3] = dcval;
+      continue;
+    }
+
+    /* Even part */
+
+    tmp0 = DEQUANTIZE(inptr[DCTSIZE*0], quantptr[DCTSIZE*0]);
+    tmp2 = DEQUANTIZE(inptr[DCTSIZE*2], quantptr[DCTSIZE*2]);
+
+    tmp10 = (tmp0 + tmp2) << PASS1_BITS;
+    tmp12 = (tmp0 - tmp2) << PASS1_BITS;
+
+    /* Odd part */
+    /* Same rotation as in the even part of the 8x8 LL&M IDCT */
+
+    z2 = DEQUANTIZE(inptr[DCTSIZE*1], quantptr[DCTSIZE*1]) << PASS1_BITS;
+    z3 = DEQUANTIZE(inptr[DCTSIZE*3], quantptr[DCTSIZE*3]) << PASS1_BITS;
+
+    z1 = MULTIPLY(z2 + z3, FIX_0_541196100);   /* c6 */
+    tmp0 = z1 + MULTIPLY(z2, FIX_0_765366865); /* c2-c6 */
+    tmp2 = z1 - MULTIPLY(z3, FIX_1_847759065); /* c2+c6 */
+
+    /* Final output stage */
+
+    wsptr[4*0] = tmp10 + tmp0;
+    wsptr[4*3] = tmp10 - tmp0;
+    wsptr[4*1] = tmp12 + tmp2;
+    wsptr[4*2] = tmp12 - tmp2;
+  }
+
+  /* Pass 2: process 4 rows from work array, store into output array. */
+
+  wsptr = workspace;
+  for (ctr = 0; ctr < 4; ctr++) {
+    outptr = output_buf[ctr] + output_col;
+
+    /* Even part */
+
+    /* Add the output bias here, the DC term reaches every output. */
+    tmp0 = wsptr[0] + OUTPUT_BIAS(PASS1_BITS+3);
+    tmp2 = wsptr[2];
+
+    tmp10 = tmp0 + tmp2;
+    tmp12 = tmp0 - tmp2;
+
+    /* Odd part */
+
+    z2 = wsptr[1];
+    z3 = wsptr[3];
+
+    z1 = MULTIPLY(z2 + z3, FIX_0_541196100);   /* c6 */
+    tmp0 = z1 + MULTIPLY(z2, FIX_0_765366865); /* c2-c6 */
+    tmp2 = z1 - MULTIPLY(z3, FIX_1_847759065); /* c2+c6 */
+
+    /* Final output stage */
+
+    outptr[0] = OUTPUT_SAMPLE(tmp10 + tmp0, PASS1_BITS+3);
+    outptr[3] = OUTPUT_SAMPLE(tmp10 - tmp0, PASS1_BITS+3);
+    outptr[1] = OUTPUT_SAMPLE(tmp12 + tmp2, PASS1_BITS+3);
+    outptr[2] = OUTPUT_SAMPLE(tmp12 - tmp2, PASS1_BITS+3);
+
+    wsptr += 4;		/* advance pointer to next row */
+  }
+}
+
+
+/*
+ * Perform dequantization and inverse DCT on one block of coefficients,
+ * producing a reduced-size 2x2 output block (1/4 scaling).
+ *
+ * Multiplication-less algorithm, see jpeg_idct_2x2 in jidctint.c.
+ */
+
+GLOBAL(void)
+jpeg_idct_m3_2x2 (j_decompress_ptr cinfo, jpeg_component_info * compptr,
+		  JCOEFPTR coef_block,
+		  JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  INT32 tmp0, tmp1, tmp2, tmp3, tmp4, tmp5;
+  ISLOW_MULT_TYPE * quantptr;
+  JSAMPROW outptr;
+  RANGE_LIMIT_TEMPS
+  SHIFT_TEMPS
+
+  /* Pass 1: process columns from input. */
+
+  quantptr = (ISLOW_MULT_TYPE *) compptr->dct_table;
+
+  /* Column 0 */
+  tmp4 = DEQUANTIZE(coef_block[DCTSIZE*0], quantptr[DCTSIZE*0]);
+  tmp5 = DEQUANTIZE(coef_block[DCTSIZE*1], quantptr[DCTSIZE*1]);
+  /* Add the output bias here, the DC term reaches every output. */
+  tmp4 += OUTPUT_BIAS(3);
+
+  tmp0 = tmp4 + tmp5;
+  tmp2 = tmp4 - tmp5;
+
+  /* Column 1 */
+  tmp4 = DEQUANTIZE(coef_block[DCTSIZE*0+1], quantptr[DCTSIZE*0+1]);
+  tmp5 = DEQUANTIZE(coef_block[DCTSIZE*1+1], quantptr[DCTSIZE*1+1]);
+
+  tmp1 = tmp4 + tmp5;
+  tmp3 = tmp4 - tmp5;
+
+  /* Pass 2: process 2 rows, store into output array. */
+
+  /* Row 0 */
+  outptr = output_buf[0] + output_col;
+
+  outptr[0] = OUTPUT_SAMPLE(tmp0 + tmp1, 3);
+  outptr[1] = OUTPUT_SAMPLE(tmp0 - tmp1, 3);
+
+  /* Row 1 */
+  outptr = output_buf[1] + output_col;
+
+  outptr[0] = OUTPUT_SAMPLE(tmp2 + tmp3, 3);
+  outptr[1] = OUTPUT_SAMPLE(tmp2 - tmp3, 3);
+}
+
+
+/*
+ * Perform dequantization and inverse DCT on one block of coefficients,
+ * producing a reduced-size 1x1 output block (1/8 scaling).
+ *
+ * Just take the average pixel value, which is one-eighth of the DC
+ * coefficient.
+ */
+
+GLOBAL(void)
+jpeg_idct_m3_1x1 (j_decompress_ptr cinfo, jpeg_component_info * compptr,
+		  JCOEFPTR coef_block,
+		  JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  INT32 dcval;
+  ISLOW_MULT_TYPE * quantptr;
+  RANGE_LIMIT_TEMPS
+  SHIFT_TEMPS
+
+  quantptr = (ISLOW_MULT_TYPE *) compptr->dct_table;
+  dcval = DEQUANTIZE(coef_block[0], quantptr[0]) + OUTPUT_BIAS(3);
+
+  output_buf[0][output_col] = OUTPUT_SAMPLE(dcval, 3);
+}
+
+#endif /* IDCT_SCALING_SUPPORTED */
+
+#endif /* DCT_M3_SUPPORTED */
@@ -0,0 +1,255 @@
+/*
+ * jmemarena.c
+ *
+ * This file is part of the Independent JPEG Group's software.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * This file provides a system-dependent portion of the JPEG memory manager
+ * that never calls malloc(): all the space is carved out of a fixed arena
+ * given by the application with jpeg_arena_init().  Long running systems
+ * thus cannot fail because of heap fragmentation.
+ *
+ * Allocation just bumps a pointer.  Each block carries its size in a header
+ * and in a trailer, so that when the topmost block is freed the arena top
+ * moves back over it and over any freed block below it.  jmemmgr.c releases
+ * the pools in roughly the reverse order of their allocation, so the space
+ * of the image pool is recovered by jpeg_finish_decompress().  Whatever is
+ * left is dropped by jpeg_mem_term(), called when the object is destroyed.
+ *
+ * As with jmemnobs.c, max_memory_to_use is ignored and no backing store is
+ * available, unless the library is built with one (jmembs.c).
+ */
+
+#define JPEG_INTERNALS
+#include "jinclude.h"
+#include "jpeglib.h"
+#include "jmemsys.h"		/* import the system-dependent declarations */
+#include "jmemarena.h"
+#ifdef JPEG_BACKING_STORE
+#include "jmembs.h"
+#endif
+
+
+/*
+ * Block header and trailer.  The union keeps the payload aligned on
+ * a double, as jmemmgr.c expects from malloc().
+ */
+
+typedef union {
+  struct {
+    size_t size;		/* whole block size, header and trailer included */
+    size_t freed;		/* nonzero once released */
+  } hdr;
+  double dummy;			/* included in union to ensure alignment */
+} arena_hdr;
+
+#define ARENA_ALIGN		SIZEOF(arena_hdr)
+#define ARENA_OVERHEAD		(2 * SIZEOF(arena_hdr))
+
+static char * arena_base = NULL; /* first byte of the arena */
+static size_t arena_size = 0;	/* size of the arena, multiple of ARENA_ALIGN */
+static size_t arena_top = 0;	/* offset of the first free byte */
+static size_t arena_peak = 0;	/* highest arena_top */
+static long arena_count = 0;	/* blocks currently allocated */
+
+
+/*
+ * Set the arena used by the following codec objects.
+ * The pool is realigned if needed; its content is not preserved.
+ */
+
+GLOBAL(void)
+jpeg_arena_init (void * pool, size_t size)
+{
+  size_t odd_bytes = (size_t) pool % ARENA_ALIGN;
+
+  if (odd_bytes != 0) {
+    odd_bytes = ARENA_ALIGN - odd_bytes;
+    if (size < odd_bytes)
+      odd_bytes = size;
+    pool = (void *) ((char *) pool + odd_bytes);
+    size -= odd_bytes;
+  }
+
+  arena_base = (char *) pool;
+  arena_size = size - (size % ARENA_ALIGN);
+  arena_top = 0;
+  arena_peak = 0;
+  arena_count = 0;
+}
+
+
+/*
+ * Report the arena usage.  The peak gives the arena size needed to
+ * run again the same work.
+ */
+
+GLOBAL(void)
+jpeg_arena_get_stats (jpeg_arena_stats * stats)
+{
+  stats->size = arena_size;
+  stats->used = arena_top;
+  stats->peak = arena_peak;
+  stats->allocations = arena_count;
+}
+
+GLOBAL(void)
+jpeg_arena_reset_peak (void)
+{
+  arena_peak = arena_top;
+}
+
+
+/*
+ * Carve a block at the arena top.
+ */
+
+LOCAL(void *)
+arena_alloc (size_t sizeofobject)
+{
+  arena_hdr * hdr;
+  size_t odd_bytes;
+  size_t size;
+
+  /* Round up the requested size to a multiple of ARENA_ALIGN */
+  odd_bytes = sizeofobject % ARENA_ALIGN;
+  if (odd_bytes > 0)
+    sizeofobject += ARENA_ALIGN - odd_bytes;
+
+  if (arena_size - arena_top < ARENA_OVERHEAD ||
+      sizeofobject > arena_size - arena_top - ARENA_OVERHEAD)
+    return NULL;		/* out of arena space, jmemmgr reports it */
+
+  size = sizeofobject + ARENA_OVERHEAD;
+
+  hdr = (arena_hdr *) (arena_base + arena_top);
+  hdr->hdr.size = size;
+  hdr->hdr.freed = 0;
+  hdr = (arena_hdr *) (arena_base + arena_top + size - SIZEOF(arena_hdr));
+  hdr->hdr.size = size;
+
+  arena_top += size;
+  if (arena_top > arena_peak)
+    arena_peak = arena_top;
+  arena_count++;
+
+  return (void *) (arena_base + arena_top - size + SIZEOF(arena_hdr));
+}
+
+
+/*
+ * Mark a block as released and move the top back over the freed blocks.
+ */
+
+LOCAL(void)
+arena_free (void * object)
+{
+  arena_hdr * hdr = (arena_hdr *) object - 1;
+  arena_hdr * trailer;
+
+  hdr->hdr.freed = 1;
+  arena_count--;
+
+  while (arena_top > 0) {
+    trailer = (arena_hdr *) (arena_base + arena_top) - 1;
+    hdr = (arena_hdr *) (arena_base + arena_top - trailer->hdr.size);
+    if (! hdr->hdr.freed)
+      break;
+    arena_top -= trailer->hdr.size;
+  }
+}
+
+
+/*
+ * Small and large objects come from the same arena.
+ */
+
+GLOBAL(void *)
+jpeg_get_small (j_common_ptr cinfo, size_t sizeofobject)
+{
+  return arena_alloc(sizeofobject);
+}
+
+GLOBAL(void)
+jpeg_free_small (j_common_ptr cinfo, void * object, size_t sizeofobject)
+{
+  arena_free(object);
+}
+
+GLOBAL(void FAR *)
+jpeg_get_large (j_common_ptr cinfo, size_t sizeofobject)
+{
+  return (void FAR *) arena_alloc(sizeofobject);
+}
+
+GLOBAL(void)
+jpeg_free_large (j_common_ptr cinfo, void FAR * object, size_t sizeofobject)
+{
+  arena_free((void *) object);
+}
+
+
+/*
+ * This routine computes the total memory space available for allocation:
+ * what is left above the arena top, and under max_memory_to_use when a
+ * backing store can take the rest.
+ */
+
+GLOBAL(long)
+jpeg_mem_available (j_common_ptr cinfo, long min_bytes_needed,
+		    long max_bytes_needed, long already_allocated)
+{
+  long avail = (long) (arena_size - arena_top);
+
+  avail -= ARENA_OVERHEAD;
+#ifdef JPEG_BACKING_STORE
+  if (cinfo->mem->max_memory_to_use > 0 &&
+      avail > cinfo->mem->max_memory_to_use - already_allocated)
+    avail = cinfo->mem->max_memory_to_use - already_allocated;
+#endif
+  if (avail < 0)
+    avail = 0;
+
+  return (avail < max_bytes_needed) ? avail : max_bytes_needed;
+}
+
+
+#ifndef JPEG_BACKING_STORE
+
+/*
+ * Backing store (temporary file) management.
+ * There is none; jmemmgr only asks for it when the arena is too small.
+ */
+
+GLOBAL(void)
+jpeg_open_backing_store (j_common_ptr cinfo, backing_store_ptr info,
+			 long total_bytes_needed)
+{
+  ERREXIT(cinfo, JERR_NO_BACKING_STORE);
+}
+
+#endif
+
+
+/*
+ * These routines take care of any system-dependent initialization and
+ * cleanup required.  The arena must have been set beforehand; the
+ * cleanup drops the whole arena content, the codec object being gone.
+ */
+
+GLOBAL(long)
+jpeg_mem_init (j_common_ptr cinfo)
+{
+#ifdef JPEG_BACKING_STORE
+  return JPEG_MAX_MEMORY;	/* RAM budget, the rest is swapped */
+#else
+  return 0;			/* just set max_memory_to_use to 0 */
+#endif
+}
+
+GLOBAL(void)
+jpeg_mem_term (j_common_ptr cinfo)
+{
+  arena_top = 0;
+  arena_count = 0;
+}
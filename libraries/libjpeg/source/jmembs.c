@@ -0,0 +1,261 @@
+/*
+ * jmembs.c
+ *
+ * This file is part of the Independent JPEG Group's software.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * This file provides the backing store of the virtual arrays for the
+ * system-dependent portion of the JPEG memory manager, jmemnobs.c or
+ * jmemarena.c supplying the memory itself.  It is built with
+ * JPEG_BACKING_FATFS, to swap the arrays to FatFs temporary files, or with
+ * JPEG_BACKING_PSRAM, to keep them in an external RAM area; see jmembs.h.
+ *
+ * jmemmgr.c only asks for a backing store when an array does not fit in
+ * the RAM budget (max_memory_to_use).  It then reads and writes whole rows
+ * at offsets of the array image, which are kept on sector boundaries when
+ * BS_SECTOR_SIZE is defined.
+ */
+
+#define JPEG_INTERNALS
+#include "jinclude.h"
+#include "jpeglib.h"
+#include "jmemsys.h"		/* import the system-dependent declarations */
+#include "jmembs.h"
+
+#if !defined(JPEG_BACKING_FATFS) && !defined(JPEG_BACKING_PSRAM)
+  #error jmembs.c needs JPEG_BACKING_FATFS or JPEG_BACKING_PSRAM
+#endif
+
+
+static jpeg_bs_stats bs_stats;	/* usage of the stores */
+static long bs_held = 0;	/* bytes held by the open stores */
+
+
+/*
+ * Account for a store being opened or closed.
+ */
+
+LOCAL(void)
+count_store (long size)
+{
+  if (size > 0)
+    bs_stats.opened++;
+  else
+    bs_stats.opened--;
+  bs_held += size;
+  if (bs_held > bs_stats.peak)
+    bs_stats.peak = bs_held;
+}
+
+
+/*
+ * Report the usage of the stores.
+ */
+
+GLOBAL(void)
+jpeg_bs_get_stats (jpeg_bs_stats * stats)
+{
+  *stats = bs_stats;
+}
+
+GLOBAL(void)
+jpeg_bs_reset_stats (void)
+{
+  bs_stats.bytes_read = 0;
+  bs_stats.bytes_written = 0;
+  bs_stats.peak = bs_held;
+}
+
+
+#ifdef JPEG_BACKING_FATFS
+
+/*
+ * Backing store in FatFs temporary files.
+ */
+
+static unsigned int temp_count = 0; /* to give unique names */
+
+
+METHODDEF(void)
+read_file_store (j_common_ptr cinfo, backing_store_ptr info,
+		 void FAR * buffer_address,
+		 long file_offset, long byte_count)
+{
+  UINT done;
+
+  if (f_lseek(&info->temp_file, (DWORD) file_offset) != FR_OK)
+    ERREXIT(cinfo, JERR_TFILE_SEEK);
+  if (f_read(&info->temp_file, buffer_address, (UINT) byte_count, &done)
+      != FR_OK || done != (UINT) byte_count)
+    ERREXIT(cinfo, JERR_TFILE_READ);
+  bs_stats.bytes_read += byte_count;
+}
+
+
+METHODDEF(void)
+write_file_store (j_common_ptr cinfo, backing_store_ptr info,
+		  void FAR * buffer_address,
+		  long file_offset, long byte_count)
+{
+  UINT done;
+
+  if (f_lseek(&info->temp_file, (DWORD) file_offset) != FR_OK)
+    ERREXIT(cinfo, JERR_TFILE_SEEK);
+  if (f_write(&info->temp_file, buffer_address, (UINT) byte_count, &done)
+      != FR_OK || done != (UINT) byte_count)
+    ERREXIT(cinfo, JERR_TFILE_WRITE);
+  bs_stats.bytes_written += byte_count;
+}
+
+
+METHODDEF(void)
+close_file_store (j_common_ptr cinfo, backing_store_ptr info)
+{
+  count_store(- info->temp_size);
+  f_close(&info->temp_file);	/* close the file */
+  f_unlink(info->temp_name);	/* delete the file */
+  TRACEMSS(cinfo, 1, JTRC_TFILE_CLOSE, info->temp_name);
+}
+
+
+/*
+ * Create a temporary file named JPEG_BS_PATH "~JPGnn.TMP".  The file is
+ * allocated contiguously when the volume allows it, and then seeked
+ * through a fast seek map instead of its FAT chain.
+ */
+
+LOCAL(void)
+open_file_store (j_common_ptr cinfo, backing_store_ptr info,
+		 long total_bytes_needed)
+{
+  static const char hex[] = "0123456789ABCDEF";
+  char * name = info->temp_name;
+  const char * path = JPEG_BS_PATH;
+  long size;
+
+  while (*path && name < info->temp_name + TEMP_NAME_LENGTH - 11)
+    *name++ = *path++;
+  MEMCOPY(name, "~JPG", 4);
+  name[4] = hex[(temp_count >> 4) & 0xF];
+  name[5] = hex[temp_count & 0xF];
+  MEMCOPY(name + 6, ".TMP", 5);
+  temp_count++;
+
+  if (f_open(&info->temp_file, info->temp_name,
+	     FA_READ | FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+    ERREXITS(cinfo, JERR_TFILE_CREATE, info->temp_name);
+
+  size = total_bytes_needed + _MAX_SS - 1;
+  size -= size % _MAX_SS;
+#if _USE_EXPAND
+  if (f_expand(&info->temp_file, (DWORD) size, 1) == FR_OK) {
+#if _USE_FASTSEEK
+    f_fastseek(&info->temp_file, info->link_map, 4);
+#endif
+  }
+#endif
+  info->temp_size = size;
+  count_store(size);
+
+  info->read_backing_store = read_file_store;
+  info->write_backing_store = write_file_store;
+  info->close_backing_store = close_file_store;
+  TRACEMSS(cinfo, 1, JTRC_TFILE_OPEN, info->temp_name);
+}
+
+#endif /* JPEG_BACKING_FATFS */
+
+
+#ifdef JPEG_BACKING_PSRAM
+
+/*
+ * Backing store in an external RAM area, carved like a stack: the space
+ * of the topmost store comes back when it is closed, the whole area when
+ * the last store is closed.
+ */
+
+static char FAR * psram_base = NULL; /* first byte of the area */
+static long psram_size = 0;	/* size of the area */
+static long psram_top = 0;	/* offset of the first free byte */
+
+
+GLOBAL(void)
+jpeg_bs_psram_init (void FAR * area, long size)
+{
+  psram_base = (char FAR *) area;
+  psram_size = size;
+  psram_top = 0;
+}
+
+
+METHODDEF(void)
+read_psram_store (j_common_ptr cinfo, backing_store_ptr info,
+		  void FAR * buffer_address,
+		  long file_offset, long byte_count)
+{
+  if (file_offset + byte_count > info->area_size)
+    ERREXIT(cinfo, JERR_TFILE_READ);
+  MEMCOPY(buffer_address, info->area + file_offset, byte_count);
+  bs_stats.bytes_read += byte_count;
+}
+
+
+METHODDEF(void)
+write_psram_store (j_common_ptr cinfo, backing_store_ptr info,
+		   void FAR * buffer_address,
+		   long file_offset, long byte_count)
+{
+  if (file_offset + byte_count > info->area_size)
+    ERREXIT(cinfo, JERR_TFILE_WRITE);
+  MEMCOPY(info->area + file_offset, buffer_address, byte_count);
+  bs_stats.bytes_written += byte_count;
+}
+
+
+METHODDEF(void)
+close_psram_store (j_common_ptr cinfo, backing_store_ptr info)
+{
+  if (info->area + info->area_size == psram_base + psram_top)
+    psram_top -= info->area_size;
+  count_store(- info->area_size);
+  if (bs_stats.opened == 0)
+    psram_top = 0;
+}
+
+
+LOCAL(void)
+open_psram_store (j_common_ptr cinfo, backing_store_ptr info,
+		  long total_bytes_needed)
+{
+  long size = (total_bytes_needed + 3) & ~3L;
+
+  if (psram_base == NULL || size > psram_size - psram_top)
+    ERREXITS(cinfo, JERR_TFILE_CREATE, "PSRAM");
+
+  info->area = psram_base + psram_top;
+  info->area_size = size;
+  psram_top += size;
+  count_store(size);
+
+  info->read_backing_store = read_psram_store;
+  info->write_backing_store = write_psram_store;
+  info->close_backing_store = close_psram_store;
+}
+
+#endif /* JPEG_BACKING_PSRAM */
+
+
+/*
+ * Initial opening of a backing-store object.
+ */
+
+GLOBAL(void)
+jpeg_open_backing_store (j_common_ptr cinfo, backing_store_ptr info,
+			 long total_bytes_needed)
+{
+#ifdef JPEG_BACKING_FATFS
+  open_file_store(cinfo, info, total_bytes_needed);
+#else
+  open_psram_store(cinfo, info, total_bytes_needed);
+#endif
+}
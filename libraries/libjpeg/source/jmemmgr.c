@@ -160,6 +160,9 @@ struct jvirt_sarray_control {
   boolean pre_zero;		/* pre-zero mode requested? */
   boolean dirty;		/* do current buffer contents need written? */
   boolean b_s_open;		/* is backing-store data valid? */
+#ifdef BS_SECTOR_SIZE
+  JDIMENSION align_rows;	/* window start granularity, see sector_rows */
+#endif
   jvirt_sarray_ptr next;	/* link to next virtual sarray control block */
   backing_store_info b_s_info;	/* System-dependent control info */
 };
@@ -176,6 +179,9 @@ struct jvirt_barray_control {
   boolean pre_zero;		/* pre-zero mode requested? */
   boolean dirty;		/* do current buffer contents need written? */
   boolean b_s_open;		/* is backing-store data valid? */
+#ifdef BS_SECTOR_SIZE
+  JDIMENSION align_rows;	/* window start granularity, see sector_rows */
+#endif
   jvirt_barray_ptr next;	/* link to next virtual barray control block */
   backing_store_info b_s_info;	/* System-dependent control info */
 };
@@ -543,6 +549,9 @@ request_virt_sarray (j_common_ptr cinfo, int pool_id, boolean pre_zero,
   result->maxaccess = maxaccess;
   result->pre_zero = pre_zero;
   result->b_s_open = FALSE;	/* no associated backing-store object */
+#ifdef BS_SECTOR_SIZE
+  result->align_rows = 1;
+#endif
   result->next = mem->virt_sarray_list; /* add to list of virtual arrays */
   mem->virt_sarray_list = result;
 
@@ -573,6 +582,9 @@ request_virt_barray (j_common_ptr cinfo, int pool_id, boolean pre_zero,
   result->maxaccess = maxaccess;
   result->pre_zero = pre_zero;
   result->b_s_open = FALSE;	/* no associated backing-store object */
+#ifdef BS_SECTOR_SIZE
+  result->align_rows = 1;
+#endif
   result->next = mem->virt_barray_list; /* add to list of virtual arrays */
   mem->virt_barray_list = result;
 
@@ -580,6 +592,32 @@ request_virt_barray (j_common_ptr cinfo, int pool_id, boolean pre_zero,
 }
 
 
+#ifdef BS_SECTOR_SIZE
+
+/*
+ * The backing store works in sectors of BS_SECTOR_SIZE bytes.  The window
+ * of a swapped array then starts on a multiple of the rows making a whole
+ * number of sectors, so that its I/O moves whole sectors; the buffer gets
+ * as many more rows, minus one, to keep the accessed rows in the window.
+ * Arrays needing too many extra rows for it are left unaligned.
+ */
+
+LOCAL(JDIMENSION)
+sector_rows (long bytesperrow, JDIMENSION rows_in_mem)
+{
+  JDIMENSION rows = 1;
+
+  while ((rows * bytesperrow) % BS_SECTOR_SIZE != 0)
+    rows++;
+  /* Not worth more than a quarter of the window */
+  if ((rows - 1) * 4 > rows_in_mem)
+    return 1;
+  return rows;
+}
+
+#endif
+
+
 METHODDEF(void)
 realize_virt_arrays (j_common_ptr cinfo)
 /* Allocate the in-memory buffers for any unrealized virtual arrays */
@@ -646,6 +684,13 @@ realize_virt_arrays (j_common_ptr cinfo)
       } else {
 	/* It doesn't fit in memory, create backing store. */
 	sptr->rows_in_mem = (JDIMENSION) (max_minheights * sptr->maxaccess);
+#ifdef BS_SECTOR_SIZE
+	sptr->align_rows = sector_rows((long) sptr->samplesperrow *
+				       SIZEOF(JSAMPLE), sptr->rows_in_mem);
+	sptr->rows_in_mem += sptr->align_rows - 1;
+	if (sptr->rows_in_mem > sptr->rows_in_array)
+	  sptr->rows_in_mem = sptr->rows_in_array;
+#endif
 	jpeg_open_backing_store(cinfo, & sptr->b_s_info,
 				(long) sptr->rows_in_array *
 				(long) sptr->samplesperrow *
@@ -670,6 +715,13 @@ realize_virt_arrays (j_common_ptr cinfo)
       } else {
 	/* It doesn't fit in memory, create backing store. */
 	bptr->rows_in_mem = (JDIMENSION) (max_minheights * bptr->maxaccess);
+#ifdef BS_SECTOR_SIZE
+	bptr->align_rows = sector_rows((long) bptr->blocksperrow *
+				       SIZEOF(JBLOCK), bptr->rows_in_mem);
+	bptr->rows_in_mem += bptr->align_rows - 1;
+	if (bptr->rows_in_mem > bptr->rows_in_array)
+	  bptr->rows_in_mem = bptr->rows_in_array;
+#endif
 	jpeg_open_backing_store(cinfo, & bptr->b_s_info,
 				(long) bptr->rows_in_array *
 				(long) bptr->blocksperrow *
@@ -788,6 +840,9 @@ access_virt_sarray (j_common_ptr cinfo, jvirt_sarray_ptr ptr,
      */
     if (start_row > ptr->cur_start_row) {
       ptr->cur_start_row = start_row;
+#ifdef BS_SECTOR_SIZE
+      ptr->cur_start_row -= start_row % ptr->align_rows;
+#endif
     } else {
       /* use long arithmetic here to avoid overflow & unsigned problems */
       long ltemp;
@@ -795,6 +850,9 @@ access_virt_sarray (j_common_ptr cinfo, jvirt_sarray_ptr ptr,
       ltemp = (long) end_row - (long) ptr->rows_in_mem;
       if (ltemp < 0)
 	ltemp = 0;		/* don't fall off front end of file */
+#ifdef BS_SECTOR_SIZE
+      ltemp += (ptr->align_rows - ltemp % ptr->align_rows) % ptr->align_rows;
+#endif
       ptr->cur_start_row = (JDIMENSION) ltemp;
     }
     /* Read in the selected part of the array.
@@ -873,6 +931,9 @@ access_virt_barray (j_common_ptr cinfo, jvirt_barray_ptr ptr,
      */
     if (start_row > ptr->cur_start_row) {
       ptr->cur_start_row = start_row;
+#ifdef BS_SECTOR_SIZE
+      ptr->cur_start_row -= start_row % ptr->align_rows;
+#endif
     } else {
       /* use long arithmetic here to avoid overflow & unsigned problems */
       long ltemp;
@@ -880,6 +941,9 @@ access_virt_barray (j_common_ptr cinfo, jvirt_barray_ptr ptr,
       ltemp = (long) end_row - (long) ptr->rows_in_mem;
       if (ltemp < 0)
 	ltemp = 0;		/* don't fall off front end of file */
+#ifdef BS_SECTOR_SIZE
+      ltemp += (ptr->align_rows - ltemp % ptr->align_rows) % ptr->align_rows;
+#endif
       ptr->cur_start_row = (JDIMENSION) ltemp;
     }
     /* Read in the selected part of the array.
@@ -12,13 +12,17 @@
  * This is very portable in the sense that it'll compile on almost anything,
  * but you'd better have lots of main memory (or virtual memory) if you want
  * to process big images.
- * Note that the max_memory_to_use option is ignored by this implementation.
+ * Note that the max_memory_to_use option is ignored by this implementation,
+ * unless the library is built with a backing store (jmembs.c).
  */
 
 #define JPEG_INTERNALS
 #include "jinclude.h"
 #include "jpeglib.h"
 #include "jmemsys.h"		/* import the system-dependent declarations */
+#ifdef JPEG_BACKING_STORE
+#include "jmembs.h"
+#endif
 
 #ifndef HAVE_STDLIB_H		/* <stdlib.h> should declare malloc(),free() */
 extern void * malloc JPP((size_t size));
@@ -66,17 +70,26 @@ jpeg_free_large (j_common_ptr cinfo, void FAR * object, size_t sizeofobject)
 
 /*
  * This routine computes the total memory space available for allocation.
- * Here we always say, "we got all you want bud!"
+ * Here we always say, "we got all you want bud!", unless a backing store
+ * can take what exceeds max_memory_to_use.
  */
 
 GLOBAL(long)
 jpeg_mem_available (j_common_ptr cinfo, long min_bytes_needed,
 		    long max_bytes_needed, long already_allocated)
 {
+#ifdef JPEG_BACKING_STORE
+  long avail = cinfo->mem->max_memory_to_use - already_allocated;
+
+  if (cinfo->mem->max_memory_to_use > 0 && avail < max_bytes_needed)
+    return (avail > 0) ? avail : 0;
+#endif
   return max_bytes_needed;
 }
 
 
+#ifndef JPEG_BACKING_STORE
+
 /*
  * Backing store (temporary file) management.
  * Since jpeg_mem_available always promised the moon,
@@ -90,6 +103,8 @@ jpeg_open_backing_store (j_common_ptr cinfo, backing_store_ptr info,
   ERREXIT(cinfo, JERR_NO_BACKING_STORE);
 }
 
+#endif
+
 
 /*
  * These routines take care of any system-dependent initialization and
@@ -99,7 +114,11 @@ jpeg_open_backing_store (j_common_ptr cinfo, backing_store_ptr info,
 GLOBAL(long)
 jpeg_mem_init (j_common_ptr cinfo)
 {
+#ifdef JPEG_BACKING_STORE
+  return JPEG_MAX_MEMORY;	/* RAM budget, the rest is swapped */
+#else
   return 0;			/* just set max_memory_to_use to 0 */
+#endif
 }
 
 GLOBAL(void)
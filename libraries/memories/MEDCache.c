@@ -0,0 +1,572 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2008, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+//------------------------------------------------------------------------------
+//         Headers
+//------------------------------------------------------------------------------
+
+#include "memories.h"
+
+#include <string.h>
+
+//------------------------------------------------------------------------------
+//      Internal Functions
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+/// Callback used to wait for backing media accesses.
+//------------------------------------------------------------------------------
+static void MEDCache_Done(void     *argument,
+                          uint8_t  status,
+                          uint32_t transferred,
+                          uint32_t remaining)
+{
+    *(volatile uint8_t*)argument = (status == MED_STATUS_SUCCESS) ? 1 : 2;
+}
+
+//------------------------------------------------------------------------------
+/// Reads or writes blocks on the backing media and waits for the completion,
+/// whether the backing media is synchronous or not.
+/// \param  pCache  Pointer to the cache instance.
+/// \param  isWrite 1 to write, 0 to read.
+/// \param  block   First block address.
+/// \param  data    Data buffer.
+/// \param  length  Number of blocks.
+/// \return Operation result code.
+//------------------------------------------------------------------------------
+static uint8_t MEDCache_Access(MEDCache *pCache,
+                               uint8_t  isWrite,
+                               uint32_t block,
+                               void     *data,
+                               uint32_t length)
+{
+    Media *pMed = pCache->pMedia;
+    volatile uint8_t done = 0;
+    uint32_t status;
+
+    do {
+        if (isWrite) {
+
+            status = MED_Write(pMed, block, data, length,
+                               MEDCache_Done, (void*)&done);
+        }
+        else {
+
+            status = MED_Read(pMed, block, data, length,
+                              MEDCache_Done, (void*)&done);
+        }
+        if (status == MED_STATUS_BUSY) {
+
+            MED_Handler(pMed);
+        }
+    } while (status == MED_STATUS_BUSY);
+
+    if (status != MED_STATUS_SUCCESS) {
+
+        TRACE_WARNING("MEDCache_Access(%u,%u): %u\n\r",
+                      (unsigned int)block, (unsigned int)length,
+                      (unsigned int)status);
+        return status;
+    }
+    while (!done) {
+
+        MED_Handler(pMed);
+    }
+    return (done == 1) ? MED_STATUS_SUCCESS : MED_STATUS_ERROR;
+}
+
+//------------------------------------------------------------------------------
+/// Returns the data of a cache line.
+//------------------------------------------------------------------------------
+static uint8_t * MEDCache_Data(MEDCache *pCache, MEDCacheLine *pLine)
+{
+    return &pCache->pBuffer[(pLine - pCache->lines)
+                            * pCache->pMedia->blockSize];
+}
+
+//------------------------------------------------------------------------------
+/// Looks for a block in the cache.
+/// \return Pointer to the line holding the block, 0 if not cached.
+//------------------------------------------------------------------------------
+static MEDCacheLine * MEDCache_Find(MEDCache *pCache, uint32_t block)
+{
+    MEDCacheLine *pLine = &pCache->lines[(block % MEDCACHE_SETS)
+                                         * MEDCACHE_WAYS];
+    uint32_t way;
+
+    for (way = 0; way < MEDCACHE_WAYS; way ++, pLine ++) {
+
+        if (pLine->valid && pLine->block == block) {
+
+            pLine->age = ++ pCache->tick;
+            return pLine;
+        }
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+/// Writes a dirty line back to the backing media.
+//------------------------------------------------------------------------------
+static uint8_t MEDCache_Clean(MEDCache *pCache, MEDCacheLine *pLine)
+{
+    uint8_t status;
+
+    if (!pLine->valid || !pLine->dirty) {
+
+        return MED_STATUS_SUCCESS;
+    }
+    status = MEDCache_Access(pCache, 1, pLine->block,
+                             MEDCache_Data(pCache, pLine), 1);
+    if (status == MED_STATUS_SUCCESS) {
+
+        pLine->dirty = 0;
+    }
+    return status;
+}
+
+//------------------------------------------------------------------------------
+/// Allocates a line for a block which is not cached: takes a free line of
+/// the set, or else evicts the least recently used one (written back first
+/// if dirty).
+/// \return Pointer to the allocated line, 0 if the eviction failed.
+//------------------------------------------------------------------------------
+static MEDCacheLine * MEDCache_Allocate(MEDCache *pCache, uint32_t block)
+{
+    MEDCacheLine *pLine = &pCache->lines[(block % MEDCACHE_SETS)
+                                         * MEDCACHE_WAYS];
+    MEDCacheLine *pVictim = pLine;
+    uint32_t way;
+
+    for (way = 0; way < MEDCACHE_WAYS; way ++, pLine ++) {
+
+        if (!pLine->valid) {
+
+            pVictim = pLine;
+            break;
+        }
+        if ((int32_t)(pLine->age - pVictim->age) < 0) {
+
+            pVictim = pLine;
+        }
+    }
+    if (MEDCache_Clean(pCache, pVictim) != MED_STATUS_SUCCESS) {
+
+        return 0;
+    }
+    pVictim->block = block;
+    pVictim->age   = ++ pCache->tick;
+    pVictim->valid = 1;
+    pVictim->dirty = 0;
+    return pVictim;
+}
+
+//------------------------------------------------------------------------------
+//! \brief  Reads blocks through the cache. Cached blocks are copied from the
+//!         cache, runs of missing blocks are read from the backing media in
+//!         one access, and allocated in the cache unless the access is long.
+//! \param  media    Pointer to a Media instance
+//! \param  address  Address of the data to read
+//! \param  data     Pointer to the buffer in which to store the retrieved
+//!                   data
+//! \param  length   Length of the buffer
+//! \param  callback Optional pointer to a callback function to invoke when
+//!                   the operation is finished
+//! \param  argument Optional pointer to an argument for the callback
+//! \return Operation result code
+//------------------------------------------------------------------------------
+static uint8_t MEDCache_Read(Media         *media,
+                             uint32_t      address,
+                             void          *data,
+                             uint32_t      length,
+                             MediaCallback callback,
+                             void          *argument)
+{
+    MEDCache     *pCache = (MEDCache*)media->interface;
+    MEDCacheLine *pLine;
+    uint8_t      *pData = (uint8_t*)data;
+    uint32_t     blockSize = media->blockSize;
+    uint32_t     total = length;
+    uint32_t     run, i;
+    uint8_t      status = MED_STATUS_SUCCESS;
+
+    // Check that the media is ready
+    if (media->state != MED_STATE_READY) {
+
+        TRACE_INFO("MEDCache_Read: busy\n\r");
+        return MED_STATUS_BUSY;
+    }
+
+    // Check that the data to read is not too big
+    if ((length + address) > media->size) {
+
+        TRACE_WARNING("MEDCache_Read: Data too big: %u, %u\n\r",
+                      (unsigned int)length, (unsigned int)address);
+        return MED_STATUS_ERROR;
+    }
+
+    // Enter Busy state
+    media->state = MED_STATE_BUSY;
+
+    while (length && status == MED_STATUS_SUCCESS) {
+
+        // Hit
+        pLine = MEDCache_Find(pCache, address);
+        if (pLine) {
+
+            memcpy(pData, MEDCache_Data(pCache, pLine), blockSize);
+            pData += blockSize;
+            address ++;
+            length --;
+            continue;
+        }
+
+        // Read the run of missing blocks at once
+        for (run = 1; run < length; run ++) {
+
+            if (MEDCache_Find(pCache, address + run)) break;
+        }
+        status = MEDCache_Access(pCache, 0, address, pData, run);
+        if (status != MED_STATUS_SUCCESS) break;
+
+        // Read allocate
+        for (i = 0; i < run && total < MEDCACHE_BYPASS_LENGTH; i ++) {
+
+            pLine = MEDCache_Allocate(pCache, address + i);
+            if (pLine) {
+
+                memcpy(MEDCache_Data(pCache, pLine),
+                       &pData[i * blockSize], blockSize);
+            }
+        }
+        pData += run * blockSize;
+        address += run;
+        length -= run;
+    }
+
+    // Leave the Busy state
+    media->state = MED_STATE_READY;
+
+    // Invoke callback
+    if (callback != 0) {
+
+        callback(argument, status, (total - length) * blockSize, length);
+    }
+
+    return status;
+}
+
+//------------------------------------------------------------------------------
+//! \brief  Writes blocks through the cache. Short writes are kept in the
+//!         cache as dirty lines; long writes go directly to the backing
+//!         media and update the lines already caching the blocks.
+//! \param  media    Pointer to a Media instance
+//! \param  address  Address at which to write
+//! \param  data     Pointer to the data to write
+//! \param  length   Size of the data buffer
+//! \param  callback Optional pointer to a callback function to invoke when
+//!                   the write operation terminates
+//! \param  argument Optional argument for the callback function
+//! \return Operation result code
+//! \see    Media
+//! \see    MediaCallback
+//------------------------------------------------------------------------------
+static uint8_t MEDCache_Write(Media         *media,
+                              uint32_t      address,
+                              void          *data,
+                              uint32_t      length,
+                              MediaCallback callback,
+                              void          *argument)
+{
+    MEDCache     *pCache = (MEDCache*)media->interface;
+    MEDCacheLine *pLine;
+    uint8_t      *pData = (uint8_t*)data;
+    uint32_t     blockSize = media->blockSize;
+    uint32_t     i;
+    uint8_t      status = MED_STATUS_SUCCESS;
+
+    // Check that the media if ready
+    if (media->state != MED_STATE_READY) {
+
+        TRACE_WARNING("MEDCache_Write: busy\n\r");
+        return MED_STATUS_BUSY;
+    }
+
+    // Check that the data to write is not too big
+    if ((length + address) > media->size) {
+
+        TRACE_WARNING("MEDCache_Write: Data too big\n\r");
+        return MED_STATUS_ERROR;
+    }
+
+    // Put the media in Busy state
+    media->state = MED_STATE_BUSY;
+
+    if (length >= MEDCACHE_BYPASS_LENGTH) {
+
+        // Write through, and keep the cached copies coherent
+        status = MEDCache_Access(pCache, 1, address, pData, length);
+        for (i = 0; i < length && status == MED_STATUS_SUCCESS; i ++) {
+
+            pLine = MEDCache_Find(pCache, address + i);
+            if (pLine) {
+
+                memcpy(MEDCache_Data(pCache, pLine),
+                       &pData[i * blockSize], blockSize);
+                pLine->dirty = 0;
+            }
+        }
+    }
+    else {
+
+        // Write back: whole blocks are written, no need to read them first
+        for (i = 0; i < length; i ++) {
+
+            pLine = MEDCache_Find(pCache, address + i);
+            if (pLine == 0) {
+
+                pLine = MEDCache_Allocate(pCache, address + i);
+            }
+            if (pLine == 0) {
+
+                status = MED_STATUS_ERROR;
+                break;
+            }
+            memcpy(MEDCache_Data(pCache, pLine),
+                   &pData[i * blockSize], blockSize);
+            pLine->dirty = 1;
+        }
+    }
+
+    // Leave the Busy state
+    media->state = MED_STATE_READY;
+
+    // Invoke the callback if it exists
+    if (callback != 0) {
+
+        callback(argument, status, length * blockSize, 0);
+    }
+
+    return status;
+}
+
+//------------------------------------------------------------------------------
+//! \brief  Writes all the dirty lines back, in block order so that the
+//!         backing media sees sequential accesses, then flushes the backing
+//!         media.
+//! \param  media Pointer to a Media instance
+//! \return Operation result code
+//------------------------------------------------------------------------------
+static uint8_t MEDCache_Flush(Media *media)
+{
+    MEDCache     *pCache = (MEDCache*)media->interface;
+    MEDCacheLine *pLine, *pNext;
+    uint32_t     i;
+    uint8_t      status = MED_STATUS_SUCCESS;
+
+    if (media->state != MED_STATE_READY) {
+
+        return MED_STATUS_BUSY;
+    }
+    media->state = MED_STATE_BUSY;
+
+    do {
+        // Lowest dirty block
+        pNext = 0;
+        for (i = 0, pLine = pCache->lines; i < MEDCACHE_LINES; i ++, pLine ++) {
+
+            if (pLine->valid && pLine->dirty
+                && (pNext == 0 || pLine->block < pNext->block)) {
+
+                pNext = pLine;
+            }
+        }
+        if (pNext) {
+
+            status = MEDCache_Clean(pCache, pNext);
+        }
+    } while (pNext && status == MED_STATUS_SUCCESS);
+
+    media->state = MED_STATE_READY;
+
+    if (status == MED_STATUS_SUCCESS) {
+
+        status = MED_Flush(pCache->pMedia);
+    }
+    return status;
+}
+
+//------------------------------------------------------------------------------
+//! \brief  Control method: MED_IOCTL_SYNC writes the dirty lines back and
+//!         flushes the backing media; MED_IOCTL_DISCARD drops the cached
+//!         lines of the range, dirty or not, before the backing media
+//!         discards it; MED_IOCTL_MAP writes the dirty lines back, so that
+//!         the backing media memory is up to date. The other codes go to the
+//!         backing media.
+//! \param  media Pointer to a Media instance
+//! \param  ctrl  MED_IOCTL_xxx code
+//! \param  buff  Code parameter
+//! \return Operation result code
+//------------------------------------------------------------------------------
+static uint8_t MEDCache_Ioctl(Media *media, uint8_t ctrl, void *buff)
+{
+    MEDCache     *pCache = (MEDCache*)media->interface;
+    MEDDiscard   *pRange = (MEDDiscard*)buff;
+    MEDCacheLine *pLine;
+    uint32_t     i;
+
+    switch (ctrl) {
+
+        case MED_IOCTL_SYNC:
+            return MEDCache_Flush(media);
+
+        case MED_IOCTL_DISCARD:
+            for (i = 0, pLine = pCache->lines; i < MEDCACHE_LINES; i ++, pLine ++) {
+
+                if (pLine->valid && pLine->block >= pRange->address
+                    && pLine->block - pRange->address < pRange->length) {
+
+                    pLine->valid = 0;
+                    pLine->dirty = 0;
+                }
+            }
+            break;
+
+        case MED_IOCTL_MAP:
+            if (MEDCache_Flush(media) != MED_STATUS_SUCCESS) {
+
+                return MED_STATUS_ERROR;
+            }
+            break;
+    }
+
+    return MED_Ioctl(pCache->pMedia, ctrl, buff);
+}
+
+//------------------------------------------------------------------------------
+/// Forwards the handler to the backing media.
+//------------------------------------------------------------------------------
+static void MEDCache_Handler(Media *media)
+{
+    MED_Handler(((MEDCache*)media->interface)->pMedia);
+}
+
+//------------------------------------------------------------------------------
+//      Exported Functions
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//! \brief  Initializes a Media instance as a write-back cache of another,
+//!         already initialized, Media.
+//! \param  media    Pointer to the Media instance to initialize
+//! \param  pCache   Pointer to the cache instance to use
+//! \param  pBacking Pointer to the backing Media instance
+//! \param  pBuffer  Buffer for the cache lines, MEDCACHE_LINES blocks
+//!                  of the backing media, word aligned
+//! \return 1 if initialize sucessfully, 0 if any error.
+//! \see    Media
+//------------------------------------------------------------------------------
+uint8_t MEDCache_Initialize(Media    *media,
+                            MEDCache *pCache,
+                            Media    *pBacking,
+                            uint8_t  *pBuffer)
+{
+    uint32_t i;
+
+    TRACE_INFO("MEDCache init\n\r");
+
+    if (!MED_IsInitialized(pBacking)) {
+
+        TRACE_ERROR("MEDCache: backing media not ready\n\r");
+        return 0;
+    }
+
+    pCache->pMedia  = pBacking;
+    pCache->pBuffer = pBuffer;
+    pCache->tick    = 0;
+    for (i = 0; i < MEDCACHE_LINES; i ++) {
+
+        pCache->lines[i].valid = 0;
+        pCache->lines[i].dirty = 0;
+        pCache->lines[i].age   = 0;
+    }
+
+    // Initialize media fields
+    media->interface = pCache;
+    media->write = MEDCache_Write;
+    media->read = MEDCache_Read;
+    media->cancelIo = 0;
+    media->lock = 0;
+    media->unlock = 0;
+    media->handler = MEDCache_Handler;
+    media->flush = MEDCache_Flush;
+    media->ioctl = MEDCache_Ioctl;
+
+    media->blockSize = pBacking->blockSize;
+    media->baseAddress = 0;
+    media->size = pBacking->size;
+
+    media->mappedRD  = 0;
+    media->mappedWR  = 0;
+    media->protected = pBacking->protected;
+    media->removable = pBacking->removable;
+    media->state = MED_STATE_READY;
+
+    media->transfer.data = 0;
+    media->transfer.address = 0;
+    media->transfer.length = 0;
+    media->transfer.callback = 0;
+    media->transfer.argument = 0;
+
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+//! \brief  Writes the dirty lines back and drops all the cached blocks, e.g.
+//!         when the backing media has been modified by another path.
+//! \param  media Pointer to a cached Media instance
+//! \return Operation result code
+//------------------------------------------------------------------------------
+uint8_t MEDCache_Invalidate(Media *media)
+{
+    MEDCache *pCache = (MEDCache*)media->interface;
+    uint32_t i;
+    uint8_t  status;
+
+    status = MEDCache_Flush(media);
+    if (status != MED_STATUS_SUCCESS) {
+
+        return status;
+    }
+    for (i = 0; i < MEDCACHE_LINES; i ++) {
+
+        pCache->lines[i].valid = 0;
+    }
+    return MED_STATUS_SUCCESS;
+}
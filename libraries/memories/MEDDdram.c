@@ -263,6 +263,7 @@ void MEDDdram_Initialize(Media *media,
     media->unlock = 0;
     media->handler = 0;
     media->flush = 0;
+    media->ioctl = 0;
 
     media->blockSize = blockSize;
     media->baseAddress = baseAddress;
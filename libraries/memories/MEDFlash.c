@@ -57,7 +57,7 @@ static unsigned char FLA_Read(Media      *media,
                                MediaCallback   callback,
                                void         *argument)
 {
-    unsigned char *source = (unsigned char *) address;
+    unsigned char *source = (unsigned char *) (media->baseAddress + address);
     unsigned char *dest = (unsigned char *) data;
 
     // Check that the media is ready
@@ -161,7 +161,7 @@ static unsigned char FLA_Write(Media      *media,
     media->transfer.argument = argument;
 
     // Start the write operation
-    error = FLASHD_Write( address, data, length);
+    error = FLASHD_Write( media->baseAddress + address, data, length);
     assert( !error ) ; /* "-F- Error when trying to write page (0x%02X)\n\r", error */
 
     // End of transfer
@@ -189,7 +189,7 @@ static unsigned char FLA_Write(Media      *media,
 //------------------------------------------------------------------------------
 static unsigned char FLA_Lock( Media* media, uint32_t start, uint32_t end, uint32_t *pActualStart, uint32_t *pActualEnd )
 {
-    if ( FLASHD_Lock( start, end, pActualStart, pActualEnd ) )
+    if ( FLASHD_Lock( media->baseAddress + start, media->baseAddress + end, pActualStart, pActualEnd ) )
     {
         return MED_STATUS_ERROR ;
     }
@@ -209,7 +209,7 @@ static unsigned char FLA_Lock( Media* media, uint32_t start, uint32_t end, uint3
 //------------------------------------------------------------------------------
 static unsigned char FLA_Unlock( Media* media, uint32_t start, uint32_t end, uint32_t *pActualStart, uint32_t *pActualEnd )
 {
-    if ( FLASHD_Unlock( start, end, pActualStart, pActualEnd ) )
+    if ( FLASHD_Unlock( media->baseAddress + start, media->baseAddress + end, pActualStart, pActualEnd ) )
     {
         return MED_STATUS_ERROR ;
     }
@@ -236,14 +236,15 @@ void FLA_Initialize( Media *media, Efc *efc )
     media->lock = FLA_Lock;
     media->unlock = FLA_Unlock;
     media->flush = 0;
+    media->ioctl = 0;
     media->handler = 0;
 
     media->blockSize = 1;
-    media->baseAddress = 0; // Address based on whole memory space
+    media->baseAddress = IFLASH_ADDR; // Media addresses are offsets in the flash
     media->size = IFLASH_SIZE;
     media->interface = efc;
 
-    media->mappedRD  = 0;
+    media->mappedRD  = 1;
     media->mappedWR  = 0;
     media->protected = 0;
     media->removable = 0;
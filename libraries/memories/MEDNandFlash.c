@@ -54,48 +54,230 @@
 //         Internal variables
 //------------------------------------------------------------------------------
 
-static unsigned char pageWriteBuffer[NandCommon_MAXPAGEDATASIZE];
-static signed short currentWriteBlock;
-static signed short currentWritePage;
-
-static unsigned char pageReadBuffer[NandCommon_MAXPAGEDATASIZE];
+/// Page of the write-combining buffer
+struct WritePage {
+
+    /// Block and page numbers, -1 if the entry is unused
+    signed short block;
+    signed short page;
+    /// Order in which the page has been buffered, pages are flushed in this
+    /// order
+    unsigned int order;
+    /// Sectors written since the page is buffered, all set once the whole
+    /// page data is valid
+    unsigned int dirtySectors;
+    /// Page data, drawn from the page pool while the entry is used
+    unsigned char *data;
+};
+
+static struct WritePage writePages[MEDNANDFLASH_WRITEPAGES];
+
+/// Order given to the next page entering the write buffer
+static unsigned int writeOrder;
+
+#if MEDNANDFLASH_POOLPAGES > 0
+/// Storage of the driver own page pool, chained by MEMPOOL_Initialize()
+BOARD_NOINIT_SECTION static uint32_t pagePoolStorage[MEMPOOL_STORAGE_WORDS(NandCommon_MAXPAGEDATASIZE,
+                                                                           MEDNANDFLASH_POOLPAGES)];
+/// Driver own page pool, used unless another one is given
+static MemPool pagePool;
+#endif
+
+/// Pool of the buffered page data
+static MemPool *pPagePool = 0;
+
+/// Last page read, valid once currentReadBlock/currentReadPage are set
+BOARD_NOINIT_SECTION static unsigned char pageReadBuffer[NandCommon_MAXPAGEDATASIZE];
 static signed short currentReadBlock;
 static signed short currentReadPage;
 
+/// Write-back mode: the buffered pages and the mapping are only written when
+/// the media is flushed (MED_Flush(), MED_IOCTL_SYNC) or the buffer is full
+static unsigned char writeBack = 0;
+
 //------------------------------------------------------------------------------
 //         Internal functions
 //------------------------------------------------------------------------------
 
 //------------------------------------------------------------------------------
-/// Writes the current page of data on the NandFlash.
+/// Returns the dirty mask of a page whose sectors have all been written.
+/// \param pageDataSize  Size of the page data area.
+//------------------------------------------------------------------------------
+static unsigned int FullSectorMask(unsigned short pageDataSize)
+{
+    unsigned int numSectors = (pageDataSize + MEDNANDFLASH_SECTORSIZE - 1)
+                              / MEDNANDFLASH_SECTORSIZE;
+
+    assert( numSectors < 32 ) ;
+    return (1 << numSectors) - 1;
+}
+
+//------------------------------------------------------------------------------
+/// Copies the sectors selected by a mask from one page buffer to another.
+/// \param destination  Destination page buffer.
+/// \param source  Source page buffer.
+/// \param mask  Sectors to copy.
+/// \param pageDataSize  Size of the page data area.
+//------------------------------------------------------------------------------
+static void CopySectors(
+    unsigned char *destination,
+    const unsigned char *source,
+    unsigned int mask,
+    unsigned short pageDataSize)
+{
+    unsigned int offset;
+
+    for (offset = 0; mask != 0; offset += MEDNANDFLASH_SECTORSIZE, mask >>= 1) {
+
+        if (mask & 1) {
+
+            MEM_Copy(&(destination[offset]),
+                   &(source[offset]),
+                   min(MEDNANDFLASH_SECTORSIZE, pageDataSize - offset));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/// Returns the buffered copy of a page, or 0 if the page is not buffered.
+/// \param block  Number of the block.
+/// \param page  Number of the page.
+//------------------------------------------------------------------------------
+static struct WritePage * FindWritePage(unsigned short block, unsigned short page)
+{
+    unsigned int i;
+
+    for (i = 0; i < MEDNANDFLASH_WRITEPAGES; i++) {
+
+        if ((writePages[i].block == block) && (writePages[i].page == page)) {
+
+            return &(writePages[i]);
+        }
+    }
+
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+/// Releases an entry of the write-combining buffer and gives its page data
+/// back to the pool.
+/// \param writePage  Buffered page.
+//------------------------------------------------------------------------------
+static void ReleaseWritePage(struct WritePage *writePage)
+{
+    MEMPOOL_Free(pPagePool, writePage->data);
+    writePage->data = 0;
+    writePage->block = -1;
+    writePage->page = -1;
+}
+
+//------------------------------------------------------------------------------
+/// Completes a buffered page with the sectors which have not been written,
+/// taken from the read buffer or from the NandFlash.
 /// Returns 0 if successful; otherwise returns 1.
-/// \param tnf  Pointer to a TranslatedNandFlash instance.
+/// \param media  Pointer to a nandflash Media instance.
+/// \param writePage  Buffered page.
 //------------------------------------------------------------------------------
-static unsigned char FlushCurrentPage( Media *media )
+static unsigned char FillWritePage(Media *media, struct WritePage *writePage)
 {
-    // Make sure there is a page to flush
-    if ( currentWritePage == -1 )
-    {
-        return 0 ;
+    unsigned short pageDataSize = NandFlashModel_GetPageDataSize(MODEL(media->interface));
+    unsigned int fullMask = FullSectorMask(pageDataSize);
+
+    if (writePage->dirtySectors == fullMask) {
+
+        return 0;
     }
 
-    TRACE_DEBUG("FlushCurrentPage(B#%d:P#%d)\n\r",
-              currentWriteBlock, currentWritePage);
+    // The read buffer holds the up-to-date page data if it is the current
+    // read page; load it otherwise
+    if ((currentReadBlock != writePage->block)
+        || (currentReadPage != writePage->page)) {
+
+        currentReadBlock = -1;
+        currentReadPage = -1;
+        if (TranslatedNandFlash_ReadPage(TRANSLATED(media->interface),
+                                         writePage->block,
+                                         writePage->page,
+                                         pageReadBuffer,
+                                         0)) {
+
+            TRACE_ERROR("FillWritePage: Could not read existing page data\n\r");
+            return 1;
+        }
+        CopySectors(pageReadBuffer, writePage->data, writePage->dirtySectors, pageDataSize);
+        currentReadBlock = writePage->block;
+        currentReadPage = writePage->page;
+    }
+
+    CopySectors(writePage->data, pageReadBuffer, fullMask & ~writePage->dirtySectors, pageDataSize);
+    writePage->dirtySectors = fullMask;
+
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+/// Writes a buffered page on the NandFlash and releases its entry.
+/// Returns 0 if successful; otherwise returns 1.
+/// \param media  Pointer to a nandflash Media instance.
+/// \param writePage  Buffered page.
+//------------------------------------------------------------------------------
+static unsigned char FlushWritePage(Media *media, struct WritePage *writePage)
+{
+    TRACE_DEBUG("FlushWritePage(B#%d:P#%d)\n\r",
+              writePage->block, writePage->page);
+
+    if (FillWritePage(media, writePage)) {
+
+        return 1;
+    }
 
     // Write page
     if (TranslatedNandFlash_WritePage(TRANSLATED(media->interface),
-                                      currentWriteBlock,
-                                      currentWritePage,
-                                      pageWriteBuffer,
+                                      writePage->block,
+                                      writePage->page,
+                                      writePage->data,
                                       0)) {
 
-        TRACE_ERROR("FlushCurrentPage: Failed to write page.\n\r");
+        TRACE_ERROR("FlushWritePage: Failed to write page.\n\r");
         return 1;
     }
 
-    // No current write page & block
-    currentWriteBlock = -1;
-    currentWritePage = -1;
+    ReleaseWritePage(writePage);
+
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+/// Writes all the buffered pages on the NandFlash, in the order they have
+/// been buffered, so that the data pages of a file reach the NandFlash before
+/// the FAT and directory pages written after them.
+/// Returns 0 if successful; otherwise returns 1.
+/// \param media  Pointer to a nandflash Media instance.
+//------------------------------------------------------------------------------
+static unsigned char FlushWritePages(Media *media)
+{
+    struct WritePage *writePage;
+    unsigned int i;
+
+    do {
+
+        // Oldest buffered page
+        writePage = 0;
+        for (i = 0; i < MEDNANDFLASH_WRITEPAGES; i++) {
+
+            if ((writePages[i].block != -1)
+                && (!writePage
+                    || ((int) (writePages[i].order - writePage->order) < 0))) {
+
+                writePage = &(writePages[i]);
+            }
+        }
+        if (writePage && FlushWritePage(media, writePage)) {
+
+            return 1;
+        }
+    }
+    while (writePage);
 
     return 0;
 }
@@ -103,7 +285,8 @@ static unsigned char FlushCurrentPage( Media *media )
 //------------------------------------------------------------------------------
 /// Writes data at an unaligned (page-wise) address and size. The address is
 /// provided as the block & page number plus an offset. The data to write MUST
-/// NOT span more than one page.
+/// NOT span more than one page. The page is written on the NandFlash once all
+/// of it has been written, or when the write buffer is flushed.
 /// Returns 0 if the data has been written; 1 otherwise.
 /// \param media  Pointer to a nandflash Media instance.
 /// \param block  Number of the block to write.
@@ -120,9 +303,11 @@ static unsigned char UnalignedWritePage(
     unsigned char *buffer,
     unsigned int size)
 {
-    unsigned char error;
     unsigned short pageDataSize = NandFlashModel_GetPageDataSize(MODEL(media->interface));
-    unsigned char writePage = ((size + offset) == pageDataSize);
+    struct WritePage *writePage;
+    unsigned char *data;
+    unsigned int end = offset + size;
+    unsigned int i;
 
     TRACE_DEBUG( "UnalignedWritePage(B%d:P%d@%d, %d)\n\r", (int)block, (int)page, (int)offset, (int)size ) ;
     assert( (size + offset) <= pageDataSize ) ; /* "UnalignedWrite: Write size and offset exceed page data size\n\r" */
@@ -133,47 +318,68 @@ static unsigned char UnalignedWritePage(
         return 0 ;
     }
 
-    // If this is not the current page, flush the previous one
-    if ((currentWriteBlock != block) || (currentWritePage != page))
-    {
-        // Flush and make page the new current page
-        FlushCurrentPage(media);
-        TRACE_DEBUG("Current write page: B#%d:P#%d\n\r", block, page);
-        currentWriteBlock = block;
-        currentWritePage = page;
+    // Look for the page in the write buffer, or for a free entry
+    writePage = FindWritePage(block, page);
+    if (!writePage) {
 
-        // Read existing page data in a temporary buffer if the page is not
-        // entirely written
-        if (size != pageDataSize) {
+        for (i = 0; (i < MEDNANDFLASH_WRITEPAGES) && (writePages[i].block != -1); i++);
+        data = (i < MEDNANDFLASH_WRITEPAGES) ? MEMPOOL_Alloc(pPagePool) : 0;
+        if (!data) {
 
-            error = TranslatedNandFlash_ReadPage(TRANSLATED(media->interface),
-                                                 block,
-                                                 page,
-                                                 pageWriteBuffer,
-                                                 0);
-            if (error) {
+            // Buffer full, or no page left in the pool
+            if (FlushWritePages(media)) {
+
+                return 1;
+            }
+            i = 0;
+            data = MEMPOOL_Alloc(pPagePool);
+            if (!data) {
 
-                TRACE_ERROR(
-                          "UnalignedWrite: Could not read existing page data\n\r");
+                TRACE_ERROR("UnalignedWritePage: No page buffer available\n\r");
                 return 1;
             }
         }
+        TRACE_DEBUG("Buffered write page: B#%d:P#%d\n\r", block, page);
+        writePage = &(writePages[i]);
+        writePage->data = data;
+        writePage->block = block;
+        writePage->page = page;
+        writePage->dirtySectors = 0;
+        writePage->order = writeOrder++;
+    }
+
+    // Sectors partially written need their existing data
+    if (((offset % MEDNANDFLASH_SECTORSIZE) != 0)
+        || (((end % MEDNANDFLASH_SECTORSIZE) != 0) && (end != pageDataSize))) {
+
+        if (FillWritePage(media, writePage)) {
+
+            // Release the entry if nothing had been written in it
+            if (writePage->dirtySectors == 0) {
+
+                ReleaseWritePage(writePage);
+            }
+            return 1;
+        }
     }
 
-    // Copy data in temporary buffer
-    memcpy(&(pageWriteBuffer[offset]), buffer, size);
+    // Copy data in the buffered page
+    MEM_Copy(&(writePage->data[offset]), buffer, size);
+    for (i = offset / MEDNANDFLASH_SECTORSIZE; i <= (end - 1) / MEDNANDFLASH_SECTORSIZE; i++) {
+
+        writePage->dirtySectors |= 1 << i;
+    }
     // Update read buffer if necessary
-    if ((currentReadPage == currentWritePage)
-        && (currentReadBlock == currentWriteBlock)) {
+    if ((currentReadPage == page) && (currentReadBlock == block)) {
 
         TRACE_DEBUG("Updating current read buffer\n\r");
-        memcpy(&(pageReadBuffer[offset]), buffer, size);
+        MEM_Copy(&(pageReadBuffer[offset]), buffer, size);
     }
 
-    // Flush page if it is complete
-    if (writePage) {
+    // Write page if it is complete
+    if (writePage->dirtySectors == FullSectorMask(pageDataSize)) {
 
-        FlushCurrentPage(media);
+        return FlushWritePage(media, writePage);
     }
 
     return 0;
@@ -284,6 +490,7 @@ static unsigned char UnalignedReadPage(
 {
     unsigned char error;
     unsigned short pageDataSize = NandFlashModel_GetPageDataSize(MODEL(media->interface));
+    struct WritePage *writePage;
 
     TRACE_DEBUG("UnalignedReadPage(B%d:P%d@%d, %d)\n\r", (int)block, (int)page, (int)offset, (int)size);
 
@@ -296,13 +503,14 @@ static unsigned char UnalignedReadPage(
         TRACE_DEBUG("Current read page: B#%d:P#%d\n\r", block, page);
         currentReadBlock = block;
         currentReadPage = page;
+        writePage = FindWritePage(block, page);
 
-        // Check if this is the current write page
-        if ((currentReadBlock == currentWriteBlock)
-            && (currentReadPage == currentWritePage)) {
+        // Check if this page is entirely in the write buffer
+        if (writePage
+            && (writePage->dirtySectors == FullSectorMask(pageDataSize))) {
 
-            TRACE_DEBUG("Reading current write page\n\r");
-            memcpy(pageReadBuffer, pageWriteBuffer, NandCommon_MAXPAGEDATASIZE);
+            TRACE_DEBUG("Reading buffered write page\n\r");
+            MEM_Copy(pageReadBuffer, writePage->data, pageDataSize);
         }
         else {
 
@@ -317,18 +525,37 @@ static unsigned char UnalignedReadPage(
                 TRACE_ERROR("UnalignedRead: Could not read page\n\r");
                 return 1;
             }
+
+            // Sectors written but not flushed yet
+            if (writePage) {
+
+                CopySectors(pageReadBuffer, writePage->data, writePage->dirtySectors, pageDataSize);
+            }
         }
     }
 
     // Copy data into buffer
-    memcpy(buffer, &(pageReadBuffer[offset]), size);
+    MEM_Copy(buffer, &(pageReadBuffer[offset]), size);
 
     return 0;
 }
 
+//------------------------------------------------------------------------------
+/// Returns the alignment of the buffers the raw layer fills with its bus
+/// width accesses, 2 on a 16-bit device and 1 on an 8-bit one.
+/// \param media  Pointer to a nandflash Media instance.
+//------------------------------------------------------------------------------
+static unsigned int BufferAlignment(Media *media)
+{
+    return NandFlashModel_GetDataBusWidth(MODEL(media->interface)) / 8;
+}
+
 //------------------------------------------------------------------------------
 /// Reads data at the specified address of a NandFlash media. An optional
 /// callback is invoked when the transfer completes.
+/// The whole pages neither buffered for writing nor held by the read page
+/// buffer are read straight into the data buffer when it has the alignment
+/// of BufferAlignment(); the other pages go through the read page buffer.
 /// Returns 1 if the transfer has been started; otherwise returns 0.
 /// \param media  Pointer to the NandFlash Media to read.
 /// \param address  Address at which the data shall be read.
@@ -352,6 +579,7 @@ static unsigned char MEDNandFlash_Read(
     unsigned int readSize;
     unsigned char *buffer = (unsigned char *) data;
     unsigned char status;
+    unsigned char error;
 
     TRACE_INFO("MEDNandFlash_Read(0x%08X, %d)\n\r", address, (int)length);
 
@@ -374,7 +602,22 @@ static unsigned char MEDNandFlash_Read(
 
         // Read page
         readSize = min((unsigned int)(pageDataSize-offset), remainingLength);
-        if (UnalignedReadPage(media, block, page, offset, buffer, readSize)) {
+        if (readSize == pageDataSize
+            && ((unsigned int) buffer & (BufferAlignment(media) - 1)) == 0
+            && ((block != currentReadBlock) || (page != currentReadPage))
+            && !FindWritePage(block, page)) {
+
+            error = TranslatedNandFlash_ReadPage(TRANSLATED(media->interface),
+                                                 block,
+                                                 page,
+                                                 buffer,
+                                                 0);
+        }
+        else {
+
+            error = UnalignedReadPage(media, block, page, offset, buffer, readSize);
+        }
+        if (error) {
 
             TRACE_ERROR("MEDNandFlash_Read: Could not read page\n\r");
             status = MED_STATUS_ERROR;
@@ -412,47 +655,177 @@ static unsigned char MEDNandFlash_Flush(Media *media)
 {
     TRACE_INFO("MEDNandFlash_Flush()\n\r");
 
-    if (FlushCurrentPage(media)) {
+    if (FlushWritePages(media)) {
 
-        TRACE_ERROR("MEDNandFlash_Flush: Could not flush current page\n\r");
+        TRACE_ERROR("MEDNandFlash_Flush: Could not flush write buffer\n\r");
         return MED_STATUS_ERROR;
     }
 
-    if (TranslatedNandFlash_Flush(TRANSLATED(media->interface))) {
+    // The logs of the blocks being written are saved with the mapping, so
+    // there is no need to merge them (TranslatedNandFlash_Flush) here
+    if (TranslatedNandFlash_SaveLogicalMapping(TRANSLATED(media->interface))) {
 
-        TRACE_ERROR("MEDNandFlash_Flush: Could not flush translated nand\n\r");
+        TRACE_ERROR("MEDNandFlash_Flush: Could not save the logical mapping\n\r");
         return MED_STATUS_ERROR;
     }
 
-    if (TranslatedNandFlash_SaveLogicalMapping(TRANSLATED(media->interface))) {
+    return MED_STATUS_SUCCESS;
+}
 
-        TRACE_ERROR("MEDNandFlash_Flush: Could not save the logical mapping\n\r");
-        return MED_STATUS_ERROR;
+//------------------------------------------------------------------------------
+/// Drops the whole logical blocks of a range no longer used, with their
+/// buffered pages; the partial blocks at both ends of the range are kept.
+/// Returns MED_STATUS_SUCCESS if succesful; otherwise, returns
+/// MED_STATUS_ERROR.
+/// \param media  Pointer to a NandFlash Media instance.
+/// \param range  Range to discard, in bytes.
+//------------------------------------------------------------------------------
+static unsigned char Discard(Media *media, const MEDDiscard *range)
+{
+    unsigned char blockShift =
+                NandFlashModel_GetPageShift(MODEL(media->interface))
+                + NandFlashModel_GetBlockShift(MODEL(media->interface));
+    unsigned int block = (range->address + (1 << blockShift) - 1) >> blockShift;
+    unsigned int end = (range->address + range->length) >> blockShift;
+    unsigned int i;
+
+    TRACE_INFO("MEDNandFlash_Discard(0x%08X, %d)\n\r",
+               (unsigned int)range->address, (int)range->length);
+
+    for (; block < end; block++) {
+
+        for (i = 0; i < MEDNANDFLASH_WRITEPAGES; i++) {
+
+            if (writePages[i].block == (signed short)block) {
+
+                ReleaseWritePage(&(writePages[i]));
+            }
+        }
+        if (currentReadBlock == (signed short)block) {
+
+            currentReadBlock = -1;
+            currentReadPage = -1;
+        }
+        if (TranslatedNandFlash_DiscardBlock(TRANSLATED(media->interface),
+                                             block)) {
+
+            TRACE_ERROR("MEDNandFlash_Discard: Could not discard LB#%d\n\r", block);
+            return MED_STATUS_ERROR;
+        }
     }
 
     return MED_STATUS_SUCCESS;
 }
 
+//------------------------------------------------------------------------------
+/// Control method of the nandflash media (MED_IOCTL_SYNC, MED_IOCTL_DISCARD,
+/// MED_IOCTL_NANDSTATS, MED_IOCTL_ALIGN).
+/// Returns MED_STATUS_SUCCESS if succesful; otherwise, returns
+/// MED_STATUS_ERROR.
+/// \param media  Pointer to a NandFlash Media instance.
+/// \param ctrl  MED_IOCTL_xxx code.
+/// \param buff  Code parameter.
+//------------------------------------------------------------------------------
+static unsigned char MEDNandFlash_Ioctl(Media *media, unsigned char ctrl, void *buff)
+{
+    switch (ctrl) {
+
+        case MED_IOCTL_SYNC:
+            return MEDNandFlash_Flush(media);
+
+        case MED_IOCTL_DISCARD:
+            return Discard(media, (const MEDDiscard *) buff);
+
+        case MED_IOCTL_NANDSTATS:
+            memcpy(buff, &nandStats, sizeof(struct NandStats));
+            return MED_STATUS_SUCCESS;
+
+        case MED_IOCTL_ALIGN:
+            *(unsigned int *) buff = BufferAlignment(media);
+            return MED_STATUS_SUCCESS;
+
+        default:
+            return MED_STATUS_ERROR;
+    }
+}
+
 //------------------------------------------------------------------------------
 /// Interrupt handler for the nandflash media. Triggered when the flush timer
-/// expires, initiating a MEDNandFlash_Flush().
+/// expires, initiating a MEDNandFlash_Flush(), posted by the ready/busy
+/// interrupt (MED_Notify()), or called from the idle loop (MED_HandleAll()). Completes the background erase once the device is
+/// ready, flushes the media unless in write-back mode, then runs a garbage
+/// collection step so that the next writes find erased blocks; returns at
+/// once while the device is busy.
 /// \param media  Pointer to a nandflash Media instance.
 //------------------------------------------------------------------------------
 static void MEDNandFlash_InterruptHandler(Media *media)
 {
     //volatile unsigned int dummy;
 
+    if (RawNandFlash_Poll((struct RawNandFlash *) media->interface)) {
+
+        return;
+    }
+
     TRACE_DEBUG("Flush timer expired\n\r");
-    MEDNandFlash_Flush(media);
+    if (!writeBack) {
+
+        MEDNandFlash_Flush(media);
+    }
+    TranslatedNandFlash_CollectGarbage(TRANSLATED(media->interface), 1);
 
     // Acknowledge interrupt
     //dummy = AT91C_BASE_NANDFLUSHTIMER->TC_SR;
 }
 
+//------------------------------------------------------------------------------
+/// Called by the ready/busy interrupt at the end of a background erase: the
+/// handler completes it and goes on with the garbage collection.
+/// \param argument  Pointer to the nandflash Media instance.
+//------------------------------------------------------------------------------
+static void MEDNandFlash_Ready(void *argument)
+{
+    MED_Notify((Media *) argument);
+}
+
 //------------------------------------------------------------------------------
 //         Exported functions
 //------------------------------------------------------------------------------
 
+//------------------------------------------------------------------------------
+/// Makes the write-combining buffer draw its pages from the given pool, e.g.
+/// a pool shared with functions which do not run at the same time. Must be
+/// called before MEDNandFlash_Initialize(); the pages are given back to the
+/// pool when the media is flushed.
+/// Returns 0 if successful; 1 if the blocks of the pool are smaller than
+/// NandCommon_MAXPAGEDATASIZE.
+/// \param pool  Pointer to an initialized MemPool instance.
+//------------------------------------------------------------------------------
+unsigned char MEDNandFlash_SetBufferPool(MemPool *pool)
+{
+    if (MEMPOOL_GetBlockSize(pool) < NandCommon_MAXPAGEDATASIZE) {
+
+        TRACE_ERROR("MEDNandFlash_SetBufferPool: Blocks too small\n\r");
+        return 1;
+    }
+    pPagePool = pool;
+
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+/// Selects the write-back mode: the data stays in the write-combining buffer
+/// and the mapping in RAM until the media is flushed, e.g. on the SYNCHRONIZE
+/// CACHE command of a USB host, instead of being written on each idle call of
+/// the handler. Fewer pages and mappings are programmed, but the data written
+/// since the last flush is lost on a power failure.
+/// \param enable  1 for write-back, 0 for write-through (default).
+//------------------------------------------------------------------------------
+void MEDNandFlash_SetWriteBack(unsigned char enable)
+{
+    writeBack = enable;
+}
+
 //------------------------------------------------------------------------------
 /// Initializes a media instance to operate on the given NandFlash device.
 /// \param media  Pointer to a Media instance.
@@ -460,6 +833,8 @@ static void MEDNandFlash_InterruptHandler(Media *media)
 //------------------------------------------------------------------------------
 void MEDNandFlash_Initialize( Media* pMedia, struct TranslatedNandFlash *translated )
 {
+    unsigned int i;
+
     TRACE_INFO( "MEDNandFlash_Initialize()\n\r" ) ;
 
     pMedia->write = (Media_write)MEDNandFlash_Write;
@@ -467,9 +842,11 @@ void MEDNandFlash_Initialize( Media* pMedia, struct TranslatedNandFlash *transla
     pMedia->lock = 0;
     pMedia->unlock = 0;
     pMedia->flush = MEDNandFlash_Flush;
+    pMedia->ioctl = (Media_ioctl)MEDNandFlash_Ioctl;
     pMedia->handler = MEDNandFlash_InterruptHandler;
 
     pMedia->interface = translated;
+    RawNandFlash_SetReadyNotify(MEDNandFlash_Ready, pMedia);
 
     pMedia->baseAddress = 0;
     pMedia->blockSize   = 1;
@@ -483,8 +860,23 @@ void MEDNandFlash_Initialize( Media* pMedia, struct TranslatedNandFlash *transla
     pMedia->removable = 0;
     pMedia->state = MED_STATE_READY;
 
-    currentWriteBlock = -1;
-    currentWritePage = -1;
+#if MEDNANDFLASH_POOLPAGES > 0
+    if (!pPagePool) {
+
+        MEMPOOL_Initialize(&pagePool, pagePoolStorage,
+                           NandCommon_MAXPAGEDATASIZE, MEDNANDFLASH_POOLPAGES);
+        pPagePool = &pagePool;
+    }
+#endif
+    if (!pPagePool) {
+
+        TRACE_ERROR("MEDNandFlash_Initialize: No page pool\n\r");
+    }
+
+    for (i = 0; i < MEDNANDFLASH_WRITEPAGES; i++) {
+
+        ReleaseWritePage(&(writePages[i]));
+    }
     currentReadBlock = -1;
     currentReadPage = -1;
 
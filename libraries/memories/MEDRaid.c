@@ -0,0 +1,681 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+//------------------------------------------------------------------------------
+//         Headers
+//------------------------------------------------------------------------------
+
+#include "memories.h"
+
+#include <string.h>
+
+//------------------------------------------------------------------------------
+//      Internal Functions
+//------------------------------------------------------------------------------
+
+static void MEDRaid_Pump(MEDRaid *pRaid);
+
+//------------------------------------------------------------------------------
+/// Returns the first block of a chunk, relative to the request.
+//------------------------------------------------------------------------------
+static uint32_t MEDRaid_ChunkStart(MEDRaid *pRaid, uint32_t chunk)
+{
+    if (chunk == 0) {
+
+        return 0;
+    }
+    return (pRaid->firstStripe + chunk) * pRaid->unit
+           - pRaid->media->transfer.address;
+}
+
+//------------------------------------------------------------------------------
+/// Returns the end of a chunk (first block after it), relative to the request.
+//------------------------------------------------------------------------------
+static uint32_t MEDRaid_ChunkEnd(MEDRaid *pRaid, uint32_t chunk)
+{
+    uint32_t end = (pRaid->firstStripe + chunk + 1) * pRaid->unit
+                   - pRaid->media->transfer.address;
+
+    return (end < pRaid->media->transfer.length)
+           ? end : pRaid->media->transfer.length;
+}
+
+//------------------------------------------------------------------------------
+/// Returns the address of a block on its member.
+/// \param  pRaid   Pointer to the composite media instance.
+/// \param  address Block address on the composite media.
+//------------------------------------------------------------------------------
+static uint32_t MEDRaid_MemberAddress(MEDRaid *pRaid, uint32_t address)
+{
+    if (pRaid->mode == MEDRAID_MIRROR) {
+
+        return address;
+    }
+    return (address / pRaid->unit / pRaid->numMembers) * pRaid->unit
+           + address % pRaid->unit;
+}
+
+//------------------------------------------------------------------------------
+/// Completion callback of the member accesses.
+//------------------------------------------------------------------------------
+static void MEDRaid_Done(void     *argument,
+                         uint8_t  status,
+                         uint32_t transferred,
+                         uint32_t remaining)
+{
+    MEDRaidMember *pMember = (MEDRaidMember*)argument;
+
+    pMember->status = status;
+    pMember->completed = 1;
+    MEDRaid_Pump(pMember->pRaid);
+}
+
+//------------------------------------------------------------------------------
+/// Gives the next chunk to an idle member.
+/// \return 1 if the member has a chunk to start, 0 if it has nothing left.
+//------------------------------------------------------------------------------
+static uint8_t MEDRaid_GetWork(MEDRaid *pRaid, MEDRaidMember *pMember)
+{
+    MEDRaidMember *pOther;
+    uint32_t      i;
+
+    if (pMember->failed) {
+
+        return 0;
+    }
+    if (pMember->pending) {
+
+        return 1;
+    }
+
+    if (pRaid->mode == MEDRAID_MIRROR && !pRaid->isWrite) {
+
+        // Chunks left by failed members first, then the next one
+        for (i = 0, pOther = pRaid->members; i < pRaid->numMembers; i ++, pOther ++) {
+
+            if (pOther->failed && pOther->pending) {
+
+                pOther->pending = 0;
+                pMember->chunk = pOther->chunk;
+                pMember->pending = 1;
+                return 1;
+            }
+        }
+        if (pRaid->nextChunk < pRaid->numChunks) {
+
+            pMember->chunk = pRaid->nextChunk ++;
+            pMember->pending = 1;
+            return 1;
+        }
+        return 0;
+    }
+
+    if (pMember->next < pRaid->numChunks) {
+
+        pMember->chunk = pMember->next;
+        pMember->next += (pRaid->mode == MEDRAID_STRIPE) ? pRaid->numMembers : 1;
+        pMember->pending = 1;
+        return 1;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+/// Starts the chunk of a member.
+//------------------------------------------------------------------------------
+static void MEDRaid_Start(MEDRaid *pRaid, MEDRaidMember *pMember)
+{
+    Media    *media = pRaid->media;
+    uint32_t start = MEDRaid_ChunkStart(pRaid, pMember->chunk);
+    uint32_t length = MEDRaid_ChunkEnd(pRaid, pMember->chunk) - start;
+    uint32_t address = MEDRaid_MemberAddress(pRaid, media->transfer.address + start);
+    uint8_t  *pData = (uint8_t*)media->transfer.data + start * media->blockSize;
+    uint32_t status;
+
+    pMember->completed = 0;
+    pMember->busy = 1;
+    if (pRaid->isWrite) {
+
+        status = MED_Write(pMember->pMedia, address, pData, length,
+                           MEDRaid_Done, pMember);
+    }
+    else {
+
+        status = MED_Read(pMember->pMedia, address, pData, length,
+                          MEDRaid_Done, pMember);
+    }
+
+    if (status == MED_STATUS_BUSY) {
+
+        // Started again by the next MED_Handler()
+        pMember->busy = 0;
+        return;
+    }
+    pMember->pending = 0;
+    if (status != MED_STATUS_SUCCESS && !pMember->completed) {
+
+        pMember->status = status;
+        pMember->completed = 1;
+    }
+}
+
+//------------------------------------------------------------------------------
+/// Takes the result of the chunk of a member.
+//------------------------------------------------------------------------------
+static void MEDRaid_Complete(MEDRaid *pRaid, MEDRaidMember *pMember)
+{
+    pMember->completed = 0;
+    pMember->busy = 0;
+    if (pMember->status == MED_STATUS_SUCCESS) {
+
+        return;
+    }
+
+    TRACE_WARNING("MEDRaid: member %u failed\n\r",
+                  (unsigned int)(pMember - pRaid->members));
+    if (pRaid->mode == MEDRAID_STRIPE) {
+
+        // No other copy, the member stops there
+        pRaid->error = 1;
+        pMember->next = pRaid->numChunks;
+    }
+    else {
+
+        // The chunk of a read is left to the other members
+        pMember->failed = 1;
+        pMember->pending = !pRaid->isWrite;
+        pRaid->repump = 1;
+    }
+}
+
+//------------------------------------------------------------------------------
+/// Ends the request: the media is ready again and the callback is invoked.
+//------------------------------------------------------------------------------
+static void MEDRaid_Finish(MEDRaid *pRaid)
+{
+    Media         *media = pRaid->media;
+    MEDRaidMember *pMember;
+    MediaCallback callback = media->transfer.callback;
+    uint32_t      length = media->transfer.length;
+    uint32_t      i;
+    uint8_t       alive = 0;
+
+    for (i = 0, pMember = pRaid->members; i < pRaid->numMembers; i ++, pMember ++) {
+
+        alive |= !pMember->failed;
+        // A read chunk nobody could read
+        if (pMember->failed && pMember->pending) {
+
+            pMember->pending = 0;
+            pRaid->error = 1;
+        }
+    }
+    if (!alive) {
+
+        pRaid->error = 1;
+    }
+
+    pRaid->status = pRaid->error ? MED_STATUS_ERROR : MED_STATUS_SUCCESS;
+    media->transfer.callback = 0;
+    media->state = MED_STATE_READY;
+
+    if (callback != 0) {
+
+        callback(media->transfer.argument, pRaid->status,
+                 pRaid->error ? 0 : length * media->blockSize,
+                 pRaid->error ? length : 0);
+    }
+}
+
+//------------------------------------------------------------------------------
+/// Services the members: takes the results of the completed chunks, starts
+/// the next ones, and ends the request once all the members are done. Called
+/// again by the completion callbacks, possibly from an interrupt, in which
+/// case the running service loop is asked to go on.
+//------------------------------------------------------------------------------
+static void MEDRaid_Pump(MEDRaid *pRaid)
+{
+    MEDRaidMember *pMember;
+    uint32_t      i;
+    uint8_t       active;
+
+    if (pRaid->pumping) {
+
+        pRaid->repump = 1;
+        return;
+    }
+
+    do {
+        pRaid->pumping = 1;
+        pRaid->repump = 0;
+        if (pRaid->media->state != MED_STATE_BUSY) {
+
+            break;
+        }
+
+        active = 0;
+        for (i = 0, pMember = pRaid->members; i < pRaid->numMembers; i ++, pMember ++) {
+
+            if (pMember->busy && pMember->completed) {
+
+                MEDRaid_Complete(pRaid, pMember);
+            }
+            if (!pMember->busy && MEDRaid_GetWork(pRaid, pMember)) {
+
+                MEDRaid_Start(pRaid, pMember);
+                if (pMember->completed) {
+
+                    pRaid->repump = 1;
+                }
+            }
+            active |= pMember->busy | (pMember->pending && !pMember->failed);
+        }
+        if (!active && !pRaid->repump) {
+
+            MEDRaid_Finish(pRaid);
+        }
+        pRaid->pumping = 0;
+    } while (pRaid->repump);
+    pRaid->pumping = 0;
+}
+
+//------------------------------------------------------------------------------
+/// Starts a request, and waits for its end when there is no callback.
+//------------------------------------------------------------------------------
+static uint8_t MEDRaid_Access(Media         *media,
+                              uint8_t       isWrite,
+                              uint32_t      address,
+                              void          *data,
+                              uint32_t      length,
+                              MediaCallback callback,
+                              void          *argument)
+{
+    MEDRaid       *pRaid = (MEDRaid*)media->interface;
+    MEDRaidMember *pMember;
+    uint32_t      first;
+    uint32_t      i;
+
+    // Check that the media is ready
+    if (media->state != MED_STATE_READY) {
+
+        TRACE_INFO("MEDRaid_Access: busy\n\r");
+        return MED_STATUS_BUSY;
+    }
+
+    // Check that the data is not too big
+    if ((length + address) > media->size) {
+
+        TRACE_WARNING("MEDRaid_Access: Data too big: %u, %u\n\r",
+                      (unsigned int)length, (unsigned int)address);
+        return MED_STATUS_ERROR;
+    }
+
+    // Enter Busy state
+    media->state = MED_STATE_BUSY;
+    media->transfer.data = data;
+    media->transfer.address = address;
+    media->transfer.length = length;
+    media->transfer.callback = callback;
+    media->transfer.argument = argument;
+
+    pRaid->isWrite = isWrite;
+    pRaid->error = 0;
+    pRaid->firstStripe = address / pRaid->unit;
+    pRaid->numChunks = length ? (address + length - 1) / pRaid->unit
+                                - pRaid->firstStripe + 1
+                              : 0;
+    pRaid->nextChunk = 0;
+
+    // First chunk of each member
+    for (i = 0, pMember = pRaid->members; i < pRaid->numMembers; i ++, pMember ++) {
+
+        first = 0;
+        if (pRaid->mode == MEDRAID_STRIPE) {
+
+            first = (i + pRaid->numMembers - pRaid->firstStripe % pRaid->numMembers)
+                    % pRaid->numMembers;
+        }
+        pMember->next = first;
+        pMember->pending = 0;
+        pMember->busy = 0;
+        pMember->completed = 0;
+    }
+
+    MEDRaid_Pump(pRaid);
+    if (callback != 0) {
+
+        return MED_STATUS_SUCCESS;
+    }
+
+    while (media->state == MED_STATE_BUSY) {
+
+        MED_Handler(media);
+    }
+    return pRaid->status;
+}
+
+//------------------------------------------------------------------------------
+//! \brief  Reads blocks from the members.
+//! \param  media    Pointer to a Media instance
+//! \param  address  Address of the data to read
+//! \param  data     Pointer to the buffer in which to store the retrieved
+//!                   data
+//! \param  length   Length of the buffer
+//! \param  callback Optional pointer to a callback function to invoke when
+//!                   the operation is finished
+//! \param  argument Optional pointer to an argument for the callback
+//! \return Operation result code
+//------------------------------------------------------------------------------
+static uint8_t MEDRaid_Read(Media         *media,
+                            uint32_t      address,
+                            void          *data,
+                            uint32_t      length,
+                            MediaCallback callback,
+                            void          *argument)
+{
+    return MEDRaid_Access(media, 0, address, data, length, callback, argument);
+}
+
+//------------------------------------------------------------------------------
+//! \brief  Writes blocks on the members.
+//! \param  media    Pointer to a Media instance
+//! \param  address  Address at which to write
+//! \param  data     Pointer to the data to write
+//! \param  length   Size of the data buffer
+//! \param  callback Optional pointer to a callback function to invoke when
+//!                   the write operation terminates
+//! \param  argument Optional argument for the callback function
+//! \return Operation result code
+//! \see    Media
+//! \see    MediaCallback
+//------------------------------------------------------------------------------
+static uint8_t MEDRaid_Write(Media         *media,
+                             uint32_t      address,
+                             void          *data,
+                             uint32_t      length,
+                             MediaCallback callback,
+                             void          *argument)
+{
+    return MEDRaid_Access(media, 1, address, data, length, callback, argument);
+}
+
+//------------------------------------------------------------------------------
+//! \brief  Flushes the members still in use.
+//! \param  media Pointer to a Media instance
+//! \return Operation result code
+//------------------------------------------------------------------------------
+static uint8_t MEDRaid_Flush(Media *media)
+{
+    MEDRaid       *pRaid = (MEDRaid*)media->interface;
+    MEDRaidMember *pMember;
+    uint32_t      i;
+    uint8_t       status = MED_STATUS_SUCCESS;
+
+    if (media->state != MED_STATE_READY) {
+
+        return MED_STATUS_BUSY;
+    }
+
+    for (i = 0, pMember = pRaid->members; i < pRaid->numMembers; i ++, pMember ++) {
+
+        if (!pMember->failed && MED_Flush(pMember->pMedia) != MED_STATUS_SUCCESS) {
+
+            status = MED_STATUS_ERROR;
+        }
+    }
+    return status;
+}
+
+//------------------------------------------------------------------------------
+//! \brief  Control method: MED_IOCTL_SYNC flushes the members;
+//!         MED_IOCTL_DISCARD discards the blocks of the range on each member
+//!         (the blocks of a member inside a striped range are consecutive on
+//!         the member). The media is not mapped.
+//! \param  media Pointer to a Media instance
+//! \param  ctrl  MED_IOCTL_xxx code
+//! \param  buff  Code parameter
+//! \return Operation result code
+//------------------------------------------------------------------------------
+static uint8_t MEDRaid_Ioctl(Media *media, uint8_t ctrl, void *buff)
+{
+    MEDRaid       *pRaid = (MEDRaid*)media->interface;
+    MEDDiscard    *pRange = (MEDDiscard*)buff;
+    MEDDiscard    range;
+    MEDRaidMember *pMember;
+    uint32_t      unit = pRaid->unit;
+    uint32_t      n = pRaid->numMembers;
+    uint32_t      first, last, stripe;
+    uint32_t      i;
+
+    switch (ctrl) {
+
+        case MED_IOCTL_SYNC:
+            return MEDRaid_Flush(media);
+
+        case MED_IOCTL_DISCARD:
+            if (pRange->length == 0) {
+
+                return MED_STATUS_SUCCESS;
+            }
+            for (i = 0, pMember = pRaid->members; i < n; i ++, pMember ++) {
+
+                if (pMember->failed) continue;
+                if (pRaid->mode == MEDRAID_MIRROR) {
+
+                    MED_Ioctl(pMember->pMedia, ctrl, pRange);
+                    continue;
+                }
+
+                // First block of the member in the range
+                first = pRange->address;
+                stripe = first / unit;
+                if (stripe % n != i) {
+
+                    stripe += (i + n - stripe % n) % n;
+                    first = stripe * unit;
+                }
+                // Last block of the member in the range
+                last = pRange->address + pRange->length - 1;
+                stripe = last / unit;
+                if (stripe % n != i) {
+
+                    if (stripe < (stripe % n + n - i) % n) continue;
+                    stripe -= (stripe % n + n - i) % n;
+                    last = stripe * unit + unit - 1;
+                }
+                if (first > last || first >= pRange->address + pRange->length
+                    || last < pRange->address) continue;
+
+                range.address = MEDRaid_MemberAddress(pRaid, first);
+                range.length = MEDRaid_MemberAddress(pRaid, last) + 1 - range.address;
+                MED_Ioctl(pMember->pMedia, ctrl, &range);
+            }
+            return MED_STATUS_SUCCESS;
+    }
+
+    return MED_STATUS_ERROR;
+}
+
+//------------------------------------------------------------------------------
+/// Calls the handlers of the members, and services them.
+//------------------------------------------------------------------------------
+static void MEDRaid_Handler(Media *media)
+{
+    MEDRaid  *pRaid = (MEDRaid*)media->interface;
+    uint32_t i;
+
+    for (i = 0; i < pRaid->numMembers; i ++) {
+
+        MED_Handler(pRaid->members[i].pMedia);
+    }
+    MEDRaid_Pump(pRaid);
+}
+
+//------------------------------------------------------------------------------
+//      Exported Functions
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//! \brief  Initializes a Media instance striping or mirroring blocks over
+//!         other, already initialized, Medias of the same block size.
+//! \param  media      Pointer to the Media instance to initialize
+//! \param  pRaid      Pointer to the composite media instance to use
+//! \param  pMembers   Member Media instances
+//! \param  numMembers Number of members, 2 to MEDRAID_MAX_MEMBERS
+//! \param  mode       MEDRAID_STRIPE or MEDRAID_MIRROR
+//! \param  unit       Stripe unit, in blocks (size of the chunks handed to
+//!                    the members in both modes)
+//! \return 1 if initialize sucessfully, 0 if any error.
+//! \see    Media
+//------------------------------------------------------------------------------
+uint8_t MEDRaid_Initialize(Media    *media,
+                           MEDRaid  *pRaid,
+                           Media    **pMembers,
+                           uint8_t  numMembers,
+                           uint8_t  mode,
+                           uint32_t unit)
+{
+    MEDRaidMember *pMember;
+    uint32_t      size = 0xFFFFFFFF;
+    uint32_t      i;
+
+    TRACE_INFO("MEDRaid init\n\r");
+
+    if (numMembers < 2 || numMembers > MEDRAID_MAX_MEMBERS || unit == 0) {
+
+        TRACE_ERROR("MEDRaid: %u members, unit %u\n\r",
+                    (unsigned int)numMembers, (unsigned int)unit);
+        return 0;
+    }
+
+    memset(pRaid, 0, sizeof(*pRaid));
+    for (i = 0, pMember = pRaid->members; i < numMembers; i ++, pMember ++) {
+
+        if (!MED_IsInitialized(pMembers[i])
+            || pMembers[i]->blockSize != pMembers[0]->blockSize) {
+
+            TRACE_ERROR("MEDRaid: member %u not ready or block size differs\n\r",
+                        (unsigned int)i);
+            return 0;
+        }
+        if (pMembers[i]->size < size) {
+
+            size = pMembers[i]->size;
+        }
+        pMember->pMedia = pMembers[i];
+        pMember->pRaid = pRaid;
+    }
+    pRaid->media = media;
+    pRaid->unit = unit;
+    pRaid->numMembers = numMembers;
+    pRaid->mode = mode;
+
+    // Initialize media fields
+    media->interface = pRaid;
+    media->write = MEDRaid_Write;
+    media->read = MEDRaid_Read;
+    media->cancelIo = 0;
+    media->lock = 0;
+    media->unlock = 0;
+    media->handler = MEDRaid_Handler;
+    media->flush = MEDRaid_Flush;
+    media->ioctl = MEDRaid_Ioctl;
+
+    media->blockSize = pMembers[0]->blockSize;
+    media->baseAddress = 0;
+    if (mode == MEDRAID_STRIPE) {
+
+        media->size = (size / unit) * unit * numMembers;
+    }
+    else {
+
+        media->size = size;
+    }
+
+    media->mappedRD  = 0;
+    media->mappedWR  = 0;
+    media->protected = 0;
+    media->removable = 0;
+    for (i = 0; i < numMembers; i ++) {
+
+        media->protected |= pMembers[i]->protected;
+        media->removable |= pMembers[i]->removable;
+    }
+    media->state = MED_STATE_READY;
+
+    media->transfer.data = 0;
+    media->transfer.address = 0;
+    media->transfer.length = 0;
+    media->transfer.callback = 0;
+    media->transfer.argument = 0;
+
+    TRACE_INFO("MEDRaid: %s of %u members, %u blocks\n\r",
+               (mode == MEDRAID_STRIPE) ? "stripe" : "mirror",
+               (unsigned int)numMembers, (unsigned int)media->size);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+//! \brief  Returns the members of a mirror which failed and are not used any
+//!         more.
+//! \param  media Pointer to a composite Media instance
+//! \return Bit i set if member i failed.
+//------------------------------------------------------------------------------
+uint8_t MEDRaid_GetFailed(Media *media)
+{
+    MEDRaid  *pRaid = (MEDRaid*)media->interface;
+    uint32_t i;
+    uint8_t  failed = 0;
+
+    for (i = 0; i < pRaid->numMembers; i ++) {
+
+        if (pRaid->members[i].failed) {
+
+            failed |= 1 << i;
+        }
+    }
+    return failed;
+}
+
+//------------------------------------------------------------------------------
+//! \brief  Uses a failed member of a mirror again, once its data has been
+//!         copied back from another member.
+//! \param  media  Pointer to a composite Media instance
+//! \param  member Index of the member
+//------------------------------------------------------------------------------
+void MEDRaid_Restore(Media *media, uint8_t member)
+{
+    MEDRaid *pRaid = (MEDRaid*)media->interface;
+
+    if (member < pRaid->numMembers) {
+
+        pRaid->members[member].failed = 0;
+        pRaid->members[member].pending = 0;
+    }
+}
@@ -33,6 +33,8 @@
 
 #include "memories.h"
 
+#include <string.h>
+
 //------------------------------------------------------------------------------
 //      Types
 //------------------------------------------------------------------------------
@@ -208,6 +210,504 @@ static unsigned char MEDRamDisk_Write(Media         *media,
     return MED_STATUS_SUCCESS;
 }
 
+//------------------------------------------------------------------------------
+//      Compressed RAM disk
+//------------------------------------------------------------------------------
+
+/// Positions of the last sequences seen by the compressor, by hash
+static unsigned short lzHash[1 << MEDRAMDISK_LZ_HASH_BITS];
+
+//------------------------------------------------------------------------------
+/// Reads a little endian word at any alignment
+//------------------------------------------------------------------------------
+static unsigned int LzRead32(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+//------------------------------------------------------------------------------
+/// Writes an LZ4 length extension, returns the next output byte
+//------------------------------------------------------------------------------
+static unsigned char *LzPutLength(unsigned char *op, unsigned int length)
+{
+    for (; length >= 255; length -= 255) {
+        *op ++ = 255;
+    }
+    *op ++ = (unsigned char)length;
+    return op;
+}
+
+//------------------------------------------------------------------------------
+/// Compresses a block in the LZ4 block format: a token (literal and match
+/// lengths), the literals, the 16-bit match offset, the length extensions.
+/// \param src    Block to compress
+/// \param length Block length, less than 64K
+/// \param dst    Output buffer
+/// \param max    Output buffer size
+/// \return Compressed length, 0 if it does not fit in max bytes
+//------------------------------------------------------------------------------
+static unsigned int LzCompress(const unsigned char *src,
+                               unsigned int length,
+                               unsigned char *dst,
+                               unsigned int max)
+{
+    const unsigned int mfLimit = (length > 12) ? length - 12 : 0;
+    const unsigned int matchLimit = (length > 5) ? length - 5 : 0;
+    unsigned char *op = dst;
+    unsigned char *token;
+    unsigned int ip = 0, anchor = 0;
+    unsigned int ref, sequence, h;
+    unsigned int literals, match;
+
+    memset(lzHash, 0, sizeof(lzHash));
+
+    while (ip < mfLimit) {
+
+        sequence = LzRead32(&src[ip]);
+        h = (sequence * 2654435761u) >> (32 - MEDRAMDISK_LZ_HASH_BITS);
+        ref = lzHash[h];
+        lzHash[h] = (unsigned short)ip;
+
+        if (ref >= ip || LzRead32(&src[ref]) != sequence) {
+
+            ip ++;
+            continue;
+        }
+
+        // Extend the match, the last 5 bytes staying literals
+        match = 4;
+        while (ip + match < matchLimit && src[ref + match] == src[ip + match]) {
+            match ++;
+        }
+
+        // Worst case size of the sequence
+        literals = ip - anchor;
+        if ((unsigned int)(op - dst) + 1 + literals + literals / 255 + 1
+                + 2 + (match - 4) / 255 + 1 > max) {
+
+            return 0;
+        }
+
+        token = op ++;
+        if (literals >= 15) {
+
+            *token = 15 << 4;
+            op = LzPutLength(op, literals - 15);
+        }
+        else {
+
+            *token = literals << 4;
+        }
+        memcpy(op, &src[anchor], literals);
+        op += literals;
+
+        *op ++ = (unsigned char)(ip - ref);
+        *op ++ = (unsigned char)((ip - ref) >> 8);
+        if (match - 4 >= 15) {
+
+            *token |= 15;
+            op = LzPutLength(op, match - 4 - 15);
+        }
+        else {
+
+            *token |= match - 4;
+        }
+
+        ip += match;
+        anchor = ip;
+    }
+
+    // Last literals
+    literals = length - anchor;
+    if ((unsigned int)(op - dst) + 1 + literals / 255 + 1 + literals > max) {
+
+        return 0;
+    }
+    if (literals >= 15) {
+
+        *op ++ = 15 << 4;
+        op = LzPutLength(op, literals - 15);
+    }
+    else {
+
+        *op ++ = literals << 4;
+    }
+    memcpy(op, &src[anchor], literals);
+    op += literals;
+
+    return op - dst;
+}
+
+//------------------------------------------------------------------------------
+/// Decompresses an LZ4 block, checking every length against the buffers.
+/// \param src    Compressed block
+/// \param length Compressed length
+/// \param dst    Output buffer
+/// \param max    Output buffer size
+/// \return Decompressed length, 0 if the block is corrupted
+//------------------------------------------------------------------------------
+static unsigned int LzDecompress(const unsigned char *src,
+                                 unsigned int length,
+                                 unsigned char *dst,
+                                 unsigned int max)
+{
+    unsigned int ip = 0, op = 0;
+    unsigned int token, count, offset;
+    unsigned char b;
+
+    while (ip < length) {
+
+        token = src[ip ++];
+
+        // Literals
+        count = token >> 4;
+        if (count == 15) {
+            do {
+                if (ip >= length) {
+                    return 0;
+                }
+                b = src[ip ++];
+                count += b;
+            } while (b == 255);
+        }
+        if (count > length - ip || count > max - op) {
+            return 0;
+        }
+        memcpy(&dst[op], &src[ip], count);
+        ip += count;
+        op += count;
+
+        // The last sequence has no match
+        if (ip == length) {
+            break;
+        }
+
+        // Match
+        if (length - ip < 2) {
+            return 0;
+        }
+        offset = src[ip] | (src[ip + 1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op) {
+            return 0;
+        }
+        count = token & 15;
+        if (count == 15) {
+            do {
+                if (ip >= length) {
+                    return 0;
+                }
+                b = src[ip ++];
+                count += b;
+            } while (b == 255);
+        }
+        count += 4;
+        if (count > max - op) {
+            return 0;
+        }
+        // Byte copy, the match may overlap the output
+        for (; count > 0; count --, op ++) {
+            dst[op] = dst[op - offset];
+        }
+    }
+
+    return op;
+}
+
+//------------------------------------------------------------------------------
+/// Number of granules holding a stored block length
+//------------------------------------------------------------------------------
+static unsigned int LzGranules(unsigned int length)
+{
+    return (length + MEDRAMDISK_GRANULE_SIZE - 1) / MEDRAMDISK_GRANULE_SIZE;
+}
+
+//------------------------------------------------------------------------------
+/// Gives the granules of a block back to the free list, the block then
+/// reads as zeros
+//------------------------------------------------------------------------------
+static void LzFreeBlock(MEDRamDiskLz *lz, unsigned int block)
+{
+    unsigned int count = LzGranules(lz->lengths[block]);
+    unsigned short granule = lz->blocks[block];
+    unsigned short next;
+
+    lz->freeGranules += count;
+    for (; count > 0; count --) {
+
+        next = lz->next[granule];
+        lz->next[granule] = lz->freeList;
+        lz->freeList = granule;
+        granule = next;
+    }
+
+    lz->blocks[block] = MEDRAMDISK_NO_GRANULE;
+    lz->lengths[block] = 0;
+}
+
+//------------------------------------------------------------------------------
+/// Reads a compressed RAM disk block
+/// \return 1 if the block is valid, 0 if it is corrupted
+//------------------------------------------------------------------------------
+static unsigned char LzReadBlock(MEDRamDiskLz *lz,
+                                 unsigned int block,
+                                 unsigned char *dest,
+                                 unsigned int blockSize)
+{
+    unsigned int length = lz->lengths[block];
+    unsigned short granule = lz->blocks[block];
+    unsigned char *out;
+    unsigned int n, left;
+
+    if (length == 0) {
+
+        memset(dest, 0, blockSize);
+        return 1;
+    }
+
+    // Gather the chain, straight to the destination when uncompressed
+    out = (length == blockSize) ? dest : lz->scratch;
+    for (left = length; left > 0; left -= n) {
+
+        n = (left < MEDRAMDISK_GRANULE_SIZE) ? left : MEDRAMDISK_GRANULE_SIZE;
+        memcpy(out, &lz->granules[granule * MEDRAMDISK_GRANULE_SIZE], n);
+        out += n;
+        granule = lz->next[granule];
+    }
+
+    if (length == blockSize) {
+
+        return 1;
+    }
+
+    return LzDecompress(lz->scratch, length, dest, blockSize) == blockSize;
+}
+
+//------------------------------------------------------------------------------
+/// Compresses and stores a block, in place of its previous content
+/// \return 1 if the block is stored, 0 if the pool is full
+//------------------------------------------------------------------------------
+static unsigned char LzWriteBlock(MEDRamDiskLz *lz,
+                                  unsigned int block,
+                                  const unsigned char *source,
+                                  unsigned int blockSize)
+{
+    const unsigned char *data = lz->scratch;
+    unsigned int length, count, n, i;
+    unsigned short granule = MEDRAMDISK_NO_GRANULE;
+
+    // Zero blocks, the most common ones on a fresh file system, take no space
+    for (i = 0; i < blockSize && source[i] == 0; i ++);
+    if (i == blockSize) {
+
+        LzFreeBlock(lz, block);
+        return 1;
+    }
+
+    // Blocks which do not compress are stored as is
+    length = LzCompress(source, blockSize, lz->scratch, blockSize - 1);
+    if (length == 0) {
+
+        data = source;
+        length = blockSize;
+    }
+
+    count = LzGranules(length);
+    if (count > lz->freeGranules + LzGranules(lz->lengths[block])) {
+
+        TRACE_WARNING("RamDisk_Write: pool full\n\r");
+        return 0;
+    }
+    LzFreeBlock(lz, block);
+
+    // Take the chain from the free list and scatter the data in it
+    lz->freeGranules -= count;
+    for (i = 0; i < count; i ++) {
+
+        if (i == 0) {
+
+            lz->blocks[block] = lz->freeList;
+        }
+        else {
+
+            lz->next[granule] = lz->freeList;
+        }
+        granule = lz->freeList;
+        lz->freeList = lz->next[granule];
+
+        n = (length - i * MEDRAMDISK_GRANULE_SIZE < MEDRAMDISK_GRANULE_SIZE)
+                ? length - i * MEDRAMDISK_GRANULE_SIZE : MEDRAMDISK_GRANULE_SIZE;
+        memcpy(&lz->granules[granule * MEDRAMDISK_GRANULE_SIZE],
+               &data[i * MEDRAMDISK_GRANULE_SIZE], n);
+    }
+    lz->lengths[block] = (unsigned short)length;
+
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+//! \brief  Reads blocks from a compressed RAM disk
+//! \param  media    Pointer to a Media instance
+//! \param  address  First block to read
+//! \param  data     Pointer to the buffer in which to store the blocks
+//! \param  length   Number of blocks
+//! \param  callback Optional pointer to a callback function to invoke when
+//!                   the operation is finished
+//! \param  argument Optional pointer to an argument for the callback
+//! \return Operation result code
+//------------------------------------------------------------------------------
+static unsigned char MEDRamDiskLz_Read(Media         *media,
+                                       unsigned int  address,
+                                       void          *data,
+                                       unsigned int  length,
+                                       MediaCallback callback,
+                                       void          *argument)
+{
+    MEDRamDiskLz *lz = (MEDRamDiskLz *)media->interface;
+    unsigned char *dest = (unsigned char *)data;
+    unsigned char status = MED_STATUS_SUCCESS;
+
+    // Check that the media is ready
+    if (media->state != MED_STATE_READY) {
+
+        TRACE_INFO("Media busy\n\r");
+        return MED_STATUS_BUSY;
+    }
+
+    // Check that the data to read is not too big
+    if ((length + address) > media->size) {
+
+        TRACE_WARNING("RamDisk_Read: Data too big: %u, 0x%08X\n\r",
+                      length, address);
+        return MED_STATUS_ERROR;
+    }
+
+    // Enter Busy state
+    media->state = MED_STATE_BUSY;
+
+    for (; length > 0; length --, address ++) {
+
+        if (!LzReadBlock(lz, address, dest, media->blockSize)) {
+
+            TRACE_ERROR("RamDisk_Read: block %u corrupted\n\r", address);
+            status = MED_STATUS_ERROR;
+            break;
+        }
+        dest += media->blockSize;
+    }
+
+    // Leave the Busy state
+    media->state = MED_STATE_READY;
+
+    // Invoke callback
+    if (callback != 0) {
+
+        callback(argument, status, 0, 0);
+    }
+
+    return status;
+}
+
+//------------------------------------------------------------------------------
+//! \brief  Writes blocks on a compressed RAM disk
+//! \param  media    Pointer to a Media instance
+//! \param  address  First block to write
+//! \param  data     Pointer to the blocks to write
+//! \param  length   Number of blocks
+//! \param  callback Optional pointer to a callback function to invoke when
+//!                   the write operation terminates
+//! \param  argument Optional argument for the callback function
+//! \return Operation result code, MED_STATUS_ERROR once the pool is full
+//------------------------------------------------------------------------------
+static unsigned char MEDRamDiskLz_Write(Media         *media,
+                                        unsigned int  address,
+                                        void          *data,
+                                        unsigned int  length,
+                                        MediaCallback callback,
+                                        void          *argument)
+{
+    MEDRamDiskLz *lz = (MEDRamDiskLz *)media->interface;
+    unsigned char *source = (unsigned char *)data;
+    unsigned char status = MED_STATUS_SUCCESS;
+
+    // Check that the media if ready
+    if (media->state != MED_STATE_READY) {
+
+        TRACE_WARNING("RamDisk_Write: busy\n\r");
+        return MED_STATUS_BUSY;
+    }
+
+    // Check that the data to write is not too big
+    if ((length + address) > media->size) {
+
+        TRACE_WARNING("RamDisk_Write: Data too big\n\r");
+        return MED_STATUS_ERROR;
+    }
+
+    // Put the media in Busy state
+    media->state = MED_STATE_BUSY;
+
+    for (; length > 0; length --, address ++) {
+
+        if (!LzWriteBlock(lz, address, source, media->blockSize)) {
+
+            status = MED_STATUS_ERROR;
+            break;
+        }
+        source += media->blockSize;
+    }
+
+    // Leave the Busy state
+    media->state = MED_STATE_READY;
+
+    // Invoke the callback if it exists
+    if (callback != 0) {
+
+        callback(argument, status, 0, 0);
+    }
+
+    return status;
+}
+
+//------------------------------------------------------------------------------
+//! \brief  Control method of a compressed RAM disk: MED_IOCTL_DISCARD frees
+//!         the space of a range, which then reads as zeros
+//! \param  media Pointer to a Media instance
+//! \param  ctrl  MED_IOCTL_xxx code
+//! \param  buff  Code parameter
+//! \return Operation result code
+//------------------------------------------------------------------------------
+static unsigned char MEDRamDiskLz_Ioctl(Media *media,
+                                        unsigned char ctrl,
+                                        void *buff)
+{
+    MEDRamDiskLz *lz = (MEDRamDiskLz *)media->interface;
+    MEDDiscard *discard = (MEDDiscard *)buff;
+    unsigned int block;
+
+    switch (ctrl) {
+
+        case MED_IOCTL_SYNC:
+            return MED_STATUS_SUCCESS;
+
+        case MED_IOCTL_DISCARD:
+            if (discard->address + discard->length > media->size) {
+
+                return MED_STATUS_ERROR;
+            }
+            for (block = discard->address;
+                 block < discard->address + discard->length;
+                 block ++) {
+
+                LzFreeBlock(lz, block);
+            }
+            return MED_STATUS_SUCCESS;
+
+        default:
+            return MED_STATUS_ERROR;
+    }
+}
+
 //------------------------------------------------------------------------------
 //      Exported Functions
 //------------------------------------------------------------------------------
@@ -261,11 +761,113 @@ unsigned char MEDRamDisk_Initialize(Media *media,
     media->unlock = 0;
     media->handler = 0;
     media->flush = 0;
+    media->ioctl = 0;
 
     media->blockSize = blockSize;
     media->baseAddress = baseAddress;
     media->size = size;
 
+    media->mappedRD  = 1;
+    media->mappedWR  = 1;
+    media->protected = 0;
+    media->removable = 0;
+    media->state = MED_STATE_READY;
+
+    media->transfer.data = 0;
+    media->transfer.address = 0;
+    media->transfer.length = 0;
+    media->transfer.callback = 0;
+    media->transfer.argument = 0;
+
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+//! \brief  Initializes a compressed RAM disk. The tables (4 bytes per disk
+//!         block, 2 bytes per granule and a block work buffer) are taken
+//!         from the start of the pool, the rest holds the granules.
+//! \param  media     Pointer to the Media instance to initialize
+//! \param  lz        Compressed RAM disk state
+//! \param  blockSize Block size in bytes, 16 to 32768
+//! \param  pool      Pool memory (SRAM or PSRAM)
+//! \param  poolSize  Pool size in bytes
+//! \param  size      Disk size in blocks, may exceed the pool size
+//! \return 1 if initialize sucessfully, 0 if the pool is too small.
+//! \see    Media
+//------------------------------------------------------------------------------
+unsigned char MEDRamDisk_InitializeCompressed(Media *media,
+                                              MEDRamDiskLz *lz,
+                                              unsigned int blockSize,
+                                              void *pool,
+                                              unsigned int poolSize,
+                                              unsigned int size)
+{
+    unsigned char *area = (unsigned char *)pool;
+    unsigned int tables;
+    unsigned int i;
+
+    TRACE_INFO("RAM Disk (compressed) init\n\r");
+
+    if (blockSize < 16 || blockSize > 32768) {
+
+        TRACE_ERROR("RamDisk: bad block size %u\n\r", blockSize);
+        return 0;
+    }
+
+    // Align the tables on half-words
+    if (((unsigned int)area & 1) != 0 && poolSize > 0) {
+
+        area ++;
+        poolSize --;
+    }
+
+    tables = size * 4 + blockSize;
+    if (poolSize < tables + MEDRAMDISK_GRANULE_SIZE + 2) {
+
+        TRACE_ERROR("RamDisk: pool too small for %u blocks\n\r", size);
+        return 0;
+    }
+
+    lz->numGranules = (poolSize - tables) / (MEDRAMDISK_GRANULE_SIZE + 2);
+    if (lz->numGranules > MEDRAMDISK_NO_GRANULE) {
+
+        lz->numGranules = MEDRAMDISK_NO_GRANULE;
+    }
+
+    lz->blocks   = (unsigned short *)area;
+    lz->lengths  = lz->blocks + size;
+    lz->next     = lz->lengths + size;
+    lz->scratch  = (unsigned char *)(lz->next + lz->numGranules);
+    lz->granules = lz->scratch + blockSize;
+
+    // Empty disk: all blocks read as zeros, all granules free
+    for (i = 0; i < size; i ++) {
+
+        lz->blocks[i] = MEDRAMDISK_NO_GRANULE;
+        lz->lengths[i] = 0;
+    }
+    for (i = 0; i < lz->numGranules; i ++) {
+
+        lz->next[i] = (unsigned short)(i + 1);
+    }
+    lz->next[lz->numGranules - 1] = MEDRAMDISK_NO_GRANULE;
+    lz->freeList = 0;
+    lz->freeGranules = lz->numGranules;
+
+    // Initialize media fields
+    media->write = (Media_write)MEDRamDiskLz_Write;
+    media->read = (Media_read)MEDRamDiskLz_Read;
+    media->lock = 0;
+    media->unlock = 0;
+    media->handler = 0;
+    media->flush = 0;
+    media->ioctl = (Media_ioctl)MEDRamDiskLz_Ioctl;
+    media->interface = lz;
+
+    media->blockSize = blockSize;
+    media->baseAddress = 0;
+    media->size = size;
+
     media->mappedRD  = 0;
     media->mappedWR  = 0;
     media->protected = 0;
@@ -280,3 +882,12 @@ unsigned char MEDRamDisk_Initialize(Media *media,
 
     return 1;
 }
+
+//------------------------------------------------------------------------------
+//! \brief  Returns the pool space left to a compressed RAM disk, in bytes
+//! \param  lz Compressed RAM disk state
+//------------------------------------------------------------------------------
+unsigned int MEDRamDisk_GetPoolFree(const MEDRamDiskLz *lz)
+{
+    return lz->freeGranules * MEDRAMDISK_GRANULE_SIZE;
+}
@@ -43,6 +43,60 @@
 /// Number of SD Slots
 #define NUM_SD_SLOTS            1
 
+/// Number of outstanding requests accepted by the asynchronous SD media
+#ifndef MEDSD_QUEUE_SIZE
+#define MEDSD_QUEUE_SIZE        4
+#endif
+
+/// Alignment of the buffers the PDC moves by words, the others are moved
+/// byte per byte (see MED_IOCTL_ALIGN)
+#define MEDSD_DMA_ALIGN         4
+
+/// Operations of the queued requests
+#define MEDSD_OP_READ           0
+#define MEDSD_OP_WRITE          1
+#define MEDSD_OP_ERASE          2
+
+//------------------------------------------------------------------------------
+//         Types
+//------------------------------------------------------------------------------
+
+/// Queued asynchronous SD request
+typedef struct _MEDSdRequest {
+    /// Data buffer
+    void          *data;
+    /// Start block
+    uint32_t      address;
+    /// Number of blocks
+    uint32_t      length;
+    /// Optional completion callback
+    MediaCallback callback;
+    /// Callback argument
+    void          *argument;
+    /// Operation (MEDSD_OP_xxx)
+    uint8_t       op;
+    /// Number of times a younger request has been started first
+    uint8_t       passed;
+} MEDSdRequest;
+
+/// Asynchronous SD request queue, one per slot
+typedef struct _MEDSdQueue {
+    /// Request ring
+    MEDSdRequest  requests[MEDSD_QUEUE_SIZE];
+    /// Index of the oldest request (the one in progress if active)
+    volatile uint8_t head;
+    /// Number of requests in the ring
+    volatile uint8_t count;
+    /// 1 when the head request has been started on the card
+    volatile uint8_t active;
+    /// Operation of the last started request
+    uint8_t       lastOp;
+    /// Block following the last started request
+    uint32_t      nextBlock;
+    /// Allocation unit of the card, in blocks
+    uint32_t      auBlocks;
+} MEDSdQueue;
+
 //------------------------------------------------------------------------------
 //         Local variables
 //------------------------------------------------------------------------------
@@ -53,6 +107,9 @@ static Mcid mciDrv[NUM_SD_SLOTS];
 /// SDCard driver instance.
 static SdCard sdDrv[NUM_SD_SLOTS];
 
+/// Asynchronous request queues.
+static MEDSdQueue sdQueue[NUM_SD_SLOTS];
+
 #if MCI_BUSY_CHECK_FIX && defined(BOARD_SD_DAT0)
 /// SD DAT0 pin
 static const Pin pinSdDAT0 = BOARD_SD_DAT0;
@@ -63,9 +120,11 @@ static const Pin pinSdDAT0 = BOARD_SD_DAT0;
 //------------------------------------------------------------------------------
 
 //------------------------------------------------------------------------------
-/// MCI0 interrupt handler. Forwards the event to the MCI driver handler.
+/// HSMCI interrupt handler. Forwards the event to the MCI driver handler.
+/// Replaces the default (weak) handler: applications using the SD medias must
+/// not define their own MCI_IrqHandler().
 //------------------------------------------------------------------------------
-static void MCI0_IrqHandler( void )
+void MCI_IrqHandler( void )
 {
     MCI_Handler( mciDrv ) ;
 }
@@ -175,6 +234,37 @@ static void ConfigurePIO(uint8_t mciID)
     }
 }
 
+//------------------------------------------------------------------------------
+/// Initializes the HSMCI driver and the SD card driver of a slot. The SD card
+/// driver sets the bus width and the transfer speed itself.
+/// \return 1 if success.
+//------------------------------------------------------------------------------
+static uint8_t ConfigureDrivers(uint8_t mciID)
+{
+    if (mciID >= NUM_SD_SLOTS) {
+
+        TRACE_ERROR("SD/MMC card initialization failed (MCI%d not supported)\n\r",
+                    mciID);
+        return 0;
+    }
+
+    MCI_Init(&mciDrv[mciID], HSMCI, ID_HSMCI, BOARD_MCK);
+    NVIC_EnableIRQ(HSMCI_IRQn);
+#if MCI_BUSY_CHECK_FIX && defined(BOARD_SD_DAT0)
+    MCI_SetBusyFix(&mciDrv[mciID], &pinSdDAT0);
+#endif
+
+    if (SD_Init(&sdDrv[mciID], &mciDrv[mciID])) {
+
+        TRACE_ERROR("SD/MMC card initialization failed\n\r");
+        return 0;
+    }
+    TRACE_INFO("SD/MMC card initialization successful\n\r");
+    TRACE_INFO("Card size: %d MB\n\r",
+               (int)(SD_GetTotalSizeKB(&sdDrv[mciID])/1024));
+    return 1;
+}
+
 //------------------------------------------------------------------------------
 //! \brief  Reads a specified amount of data from a SDCARD memory
 //! \param  media    Pointer to a Media instance
@@ -214,7 +304,8 @@ static uint8_t MEDSdcard_Read(Media         *media,
     // Enter Busy state
     media->state = MED_STATE_BUSY;
 
-    error = SD_ReadBlock((SdCard*)media->interface, address, length, data);
+    // One multiple block transfer, the PDC fills the buffer directly
+    error = SD_Read((SdCard*)media->interface, address, data, length, 0, 0);
 
     // Leave the Busy state
     media->state = MED_STATE_READY;
@@ -222,10 +313,11 @@ static uint8_t MEDSdcard_Read(Media         *media,
     // Invoke callback
     if (callback != 0) {
 
-        callback(argument, MED_STATUS_SUCCESS, 0, 0);
+        callback(argument, error ? MED_STATUS_ERROR : MED_STATUS_SUCCESS,
+                 0, 0);
     }
 
-    return MED_STATUS_SUCCESS;
+    return (error ? MED_STATUS_ERROR : MED_STATUS_SUCCESS);
 }
 
 //------------------------------------------------------------------------------
@@ -267,7 +359,8 @@ static uint8_t MEDSdcard_Write(Media         *media,
     // Put the media in Busy state
     media->state = MED_STATE_BUSY;
 
-    error = SD_WriteBlock((SdCard*)media->interface, address, length, data);
+    // One multiple block transfer, the PDC reads the buffer directly
+    error = SD_Write((SdCard*)media->interface, address, data, length, 0, 0);
 
     // Leave the Busy state
     media->state = MED_STATE_READY;
@@ -275,25 +368,25 @@ static uint8_t MEDSdcard_Write(Media         *media,
     // Invoke the callback if it exists
     if (callback != 0) {
 
-        callback(argument, MED_STATUS_SUCCESS, 0, 0);
+        callback(argument, error ? MED_STATUS_ERROR : MED_STATUS_SUCCESS,
+                 0, 0);
     }
 
-    return MED_STATUS_SUCCESS;
+    return (error ? MED_STATUS_ERROR : MED_STATUS_SUCCESS);
 }
 
 //------------------------------------------------------------------------------
 //! \brief Callback invoked when SD/MMC transfer done
 //------------------------------------------------------------------------------
-static void SdMmcCallback( uint8_t status, void *pCommand )
+static void SdMmcCallback( uint8_t status, void *pArg )
 {
-    SdCmd       * pCmd = (SdCmd*)pCommand;
-    Media       * pMed = pCmd->pArg;
+    Media       * pMed = (Media*)pArg;
     MEDTransfer * pXfr = &pMed->transfer;
 
     TRACE_INFO_WP("SDCb ");
 
     // Error
-    if (status == SD_ERROR_BUSY) {
+    if (status == SDMMC_ERROR_BUSY) {
         status = MED_STATUS_BUSY;
     }
     else if (status) {
@@ -423,6 +516,582 @@ static uint8_t MEDSdusb_Write(Media         *media,
     return (error ? MED_STATUS_ERROR : MED_STATUS_SUCCESS);
 }
 
+//------------------------------------------------------------------------------
+/// Checks a discarded range and reduces it to the erase units it fully
+/// covers: the other blocks of a partly discarded unit still hold data.
+/// \param  media   Pointer to the Media instance.
+/// \param  pRange  Discarded range.
+/// \param  pStart  First block to erase.
+/// \param  pLength Number of blocks to erase, 0 if no whole unit is covered.
+/// \return Operation result code
+//------------------------------------------------------------------------------
+static uint8_t MEDSdcard_EraseRange(Media            *media,
+                                    const MEDDiscard *pRange,
+                                    uint32_t         *pStart,
+                                    uint32_t         *pLength)
+{
+    uint32_t unit = SD_GetEraseBlocks((SdCard*)media->interface);
+    uint32_t start = ((pRange->address + unit - 1) / unit) * unit;
+    uint32_t end = ((pRange->address + pRange->length) / unit) * unit;
+
+    if (media->protected) {
+
+        return MED_STATUS_PROTECTED;
+    }
+    if ((pRange->address + pRange->length) > media->size) {
+
+        TRACE_WARNING("MEDSdcard: Discard too big: %d, %d\n\r",
+                      (int)pRange->length, (int)pRange->address);
+        return MED_STATUS_ERROR;
+    }
+    *pStart = start;
+    *pLength = (end > start) ? (end - start) : 0;
+    return MED_STATUS_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+/// Control method of the synchronous SD media (MED_IOCTL_SYNC,
+/// MED_IOCTL_DISCARD, MED_IOCTL_ALIGN). The discarded blocks are erased on the card, so that
+/// it does not copy them when the rest of their allocation unit is written.
+/// \param  media Pointer to the Media instance.
+/// \param  ctrl  MED_IOCTL_xxx code.
+/// \param  buff  Code parameter.
+/// \return Operation result code
+//------------------------------------------------------------------------------
+static uint8_t MEDSdcard_Ioctl(Media *media, uint8_t ctrl, void *buff)
+{
+    uint32_t start;
+    uint32_t length;
+    uint8_t status;
+
+    switch (ctrl) {
+
+        case MED_IOCTL_SYNC:
+            // Writes are done on the card when they return
+            return MED_STATUS_SUCCESS;
+
+        case MED_IOCTL_ALIGN:
+            *(uint32_t*)buff = MEDSD_DMA_ALIGN;
+            return MED_STATUS_SUCCESS;
+
+        case MED_IOCTL_DISCARD:
+            status = MEDSdcard_EraseRange(media, (const MEDDiscard*)buff,
+                                          &start, &length);
+            if (status != MED_STATUS_SUCCESS || length == 0) {
+
+                return status;
+            }
+            if (SD_Erase((SdCard*)media->interface, start, length)) {
+
+                return MED_STATUS_ERROR;
+            }
+            return MED_STATUS_SUCCESS;
+
+        default:
+            return MED_STATUS_ERROR;
+    }
+}
+
+//------------------------------------------------------------------------------
+//         Asynchronous, queued access
+//------------------------------------------------------------------------------
+
+static uint8_t MEDSdasync_Start(Media *media);
+
+//------------------------------------------------------------------------------
+/// Returns the request queue associated to a SD media.
+//------------------------------------------------------------------------------
+static MEDSdQueue * MEDSdasync_GetQueue(Media *media)
+{
+    return &sdQueue[(SdCard*)media->interface - sdDrv];
+}
+
+//------------------------------------------------------------------------------
+/// Returns the ring index of the n-th oldest request of a queue.
+//------------------------------------------------------------------------------
+static uint8_t MEDSdasync_Slot(MEDSdQueue *pQ, uint8_t n)
+{
+    uint8_t slot = pQ->head + n;
+
+    if (slot >= MEDSD_QUEUE_SIZE) slot -= MEDSD_QUEUE_SIZE;
+    return slot;
+}
+
+//------------------------------------------------------------------------------
+/// Returns 1 if two requests must run in their queuing order: they share
+/// blocks and at least one of them changes the card content.
+//------------------------------------------------------------------------------
+static uint8_t MEDSdasync_Depends(const MEDSdRequest *pA,
+                                  const MEDSdRequest *pB)
+{
+    if (pA->op == MEDSD_OP_READ && pB->op == MEDSD_OP_READ) {
+
+        return 0;
+    }
+    return (pA->address < pB->address + pB->length)
+        && (pB->address < pA->address + pA->length);
+}
+
+//------------------------------------------------------------------------------
+/// Moves the pending request to run next to the head of the queue. First
+/// comes the request continuing the last started one, which is chained on the
+/// open multi-block command; then a request of the same operation in the same
+/// allocation unit, then the lowest address following the last request (one
+/// way elevator), then the lowest address. A request never passes an older
+/// one it depends on, and the oldest request is no longer passed once it has
+/// been MEDSD_QUEUE_SIZE times.
+/// Called from the HSMCI interrupt or with it masked, while no request is
+/// active.
+/// \param  pQ Pointer to the request queue.
+//------------------------------------------------------------------------------
+static void MEDSdasync_Schedule(MEDSdQueue *pQ)
+{
+    MEDSdRequest *pR;
+    MEDSdRequest request;
+    uint32_t au = pQ->auBlocks ? pQ->auBlocks : 1;
+    uint32_t bestAddress = 0;
+    uint8_t bestRank = 0;
+    uint8_t best = 0;
+    uint8_t rank;
+    uint8_t n, i;
+
+    if (pQ->active || pQ->count < 2
+        || pQ->requests[pQ->head].passed >= MEDSD_QUEUE_SIZE) {
+
+        return;
+    }
+
+    for (n = 0; n < pQ->count; n ++) {
+
+        pR = &pQ->requests[MEDSdasync_Slot(pQ, n)];
+        for (i = 0; i < n; i ++) {
+
+            if (MEDSdasync_Depends(&pQ->requests[MEDSdasync_Slot(pQ, i)], pR)) {
+
+                break;
+            }
+        }
+        if (i < n) {
+
+            continue;
+        }
+
+        if (pR->op == pQ->lastOp && pR->op != MEDSD_OP_ERASE
+            && pR->address == pQ->nextBlock) {
+
+            rank = 0;
+        }
+        else if (pR->op == pQ->lastOp
+                 && pR->address / au == pQ->nextBlock / au) {
+
+            rank = 1;
+        }
+        else if (pR->address >= pQ->nextBlock) {
+
+            rank = 2;
+        }
+        else {
+
+            rank = 3;
+        }
+
+        if (n == 0 || rank < bestRank
+            || (rank == bestRank && pR->address < bestAddress)) {
+
+            best = n;
+            bestRank = rank;
+            bestAddress = pR->address;
+        }
+    }
+
+    if (best) {
+
+        pQ->requests[pQ->head].passed ++;
+        request = pQ->requests[MEDSdasync_Slot(pQ, best)];
+        for (n = best; n > 0; n --) {
+
+            pQ->requests[MEDSdasync_Slot(pQ, n)] =
+                pQ->requests[MEDSdasync_Slot(pQ, n - 1)];
+        }
+        pQ->requests[pQ->head] = request;
+    }
+}
+
+//------------------------------------------------------------------------------
+/// Completion callback used for requests queued without callback: flags the
+/// waiting caller.
+//------------------------------------------------------------------------------
+static void MEDSdasync_SyncDone(void     *argument,
+                                uint8_t  status,
+                                uint32_t transferred,
+                                uint32_t remaining)
+{
+    *(volatile uint8_t*)argument = (status == MED_STATUS_SUCCESS) ? 1 : 2;
+}
+
+//------------------------------------------------------------------------------
+/// Completes the request at the head of the queue, schedules the pending
+/// ones, then chains the next one directly if it continues the open
+/// multi-block command. Any other request is left for the media handler
+/// (MED_Notify, or MED_HandleAll) since it needs a blocking command sequence,
+/// which must not run in interrupt context.
+/// \param  media  Pointer to the Media instance.
+/// \param  status Request status (MED_STATUS_xxx).
+//------------------------------------------------------------------------------
+static void MEDSdasync_Complete(Media *media, uint8_t status)
+{
+    MEDSdQueue   *pQ = MEDSdasync_GetQueue(media);
+    MEDSdRequest *pR = &pQ->requests[pQ->head];
+    MediaCallback callback = pR->callback;
+    void          *argument = pR->argument;
+    uint32_t      length = pR->length;
+
+    // Remove the request from the queue before invoking its callback, so
+    // that the callback can queue a new request
+    if (++ pQ->head == MEDSD_QUEUE_SIZE) pQ->head = 0;
+    pQ->count --;
+    pQ->active = 0;
+    if (pQ->count == 0) {
+
+        media->state = MED_STATE_READY;
+    }
+
+    if (callback) {
+
+        callback(argument, status, length * media->blockSize, 0);
+    }
+
+    // Chain next request if it continues the current multi-block access
+    if (pQ->count && !pQ->active && status == MED_STATUS_SUCCESS) {
+
+        MEDSdasync_Schedule(pQ);
+        pR = &pQ->requests[pQ->head];
+        if (pR->op == pQ->lastOp && pR->op != MEDSD_OP_ERASE
+            && pR->address == pQ->nextBlock) {
+
+            MEDSdasync_Start(media);
+        }
+    }
+    if (pQ->count && !pQ->active) {
+
+        MED_Notify(media);
+    }
+}
+
+//------------------------------------------------------------------------------
+/// Callback invoked by the SD driver (HSMCI interrupt) when a queued request
+/// is done.
+//------------------------------------------------------------------------------
+static void MEDSdasync_Callback(uint8_t status, void *pArg)
+{
+    TRACE_INFO_WP("SDaCb ");
+
+    if (status == SDMMC_ERROR_BUSY) {
+        status = MED_STATUS_BUSY;
+    }
+    else if (status) {
+        status = MED_STATUS_ERROR;
+    }
+
+    MEDSdasync_Complete((Media*)pArg, status);
+}
+
+//------------------------------------------------------------------------------
+/// Starts the request at the head of the queue on the card. An erase is only
+/// marked active: its commands wait for the HSMCI interrupt, so the caller
+/// runs it with MEDSdasync_Erase() once the interrupt is enabled again.
+/// \param  media Pointer to the Media instance.
+/// \return 1 if a request has been started, 2 if an erase is to be run.
+//------------------------------------------------------------------------------
+static uint8_t MEDSdasync_Start(Media *media)
+{
+    MEDSdQueue   *pQ = MEDSdasync_GetQueue(media);
+    MEDSdRequest *pR;
+    uint8_t error;
+
+    if (pQ->active || pQ->count == 0) {
+
+        return 0;
+    }
+    pR = &pQ->requests[pQ->head];
+    pQ->active = 1;
+    pQ->lastOp = pR->op;
+    pQ->nextBlock = pR->address + pR->length;
+
+    media->transfer.data     = pR->data;
+    media->transfer.address  = pR->address;
+    media->transfer.length   = pR->length;
+    media->transfer.callback = pR->callback;
+    media->transfer.argument = pR->argument;
+
+    if (pR->op == MEDSD_OP_ERASE) {
+
+        return 2;
+    }
+    if (pR->op == MEDSD_OP_WRITE) {
+
+        error = SD_Write((SdCard*)media->interface, pR->address, pR->data,
+                         pR->length, MEDSdasync_Callback, media);
+    }
+    else {
+
+        error = SD_Read((SdCard*)media->interface, pR->address, pR->data,
+                        pR->length, MEDSdasync_Callback, media);
+    }
+    if (error) {
+
+        // The driver will not call back, complete the request here
+        TRACE_WARNING("MEDSdasync_Start: %d\n\r", error);
+        MEDSdasync_Complete(media, MED_STATUS_ERROR);
+    }
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+/// Runs the erase request at the head of the queue, made active by
+/// MEDSdasync_Start(). Must be called with the HSMCI interrupt enabled.
+//------------------------------------------------------------------------------
+static void MEDSdasync_Erase(Media *media)
+{
+    MEDSdQueue   *pQ = MEDSdasync_GetQueue(media);
+    MEDSdRequest *pR = &pQ->requests[pQ->head];
+    uint8_t error;
+
+    error = SD_Erase((SdCard*)media->interface, pR->address, pR->length);
+    if (error) {
+
+        TRACE_WARNING("MEDSdasync_Erase: %d\n\r", error);
+    }
+    NVIC_DisableIRQ(HSMCI_IRQn);
+    MEDSdasync_Complete(media, error ? MED_STATUS_ERROR : MED_STATUS_SUCCESS);
+    NVIC_EnableIRQ(HSMCI_IRQn);
+}
+
+//------------------------------------------------------------------------------
+/// Media handler: schedules and starts the queued request that could not be
+/// chained from the interrupt. Posted by MED_Notify(), or called by
+/// MED_HandleAll().
+//------------------------------------------------------------------------------
+static void MEDSdasync_Handler(Media *media)
+{
+    uint8_t started;
+
+    NVIC_DisableIRQ(HSMCI_IRQn);
+    MEDSdasync_Schedule(MEDSdasync_GetQueue(media));
+    started = MEDSdasync_Start(media);
+    NVIC_EnableIRQ(HSMCI_IRQn);
+
+    if (started == 2) {
+
+        MEDSdasync_Erase(media);
+    }
+}
+
+//------------------------------------------------------------------------------
+/// Queues a read, write or erase request and starts it if the card is idle.
+/// Without callback the function waits for the completion of a read or a
+/// write, so that synchronous users (FatFs diskio) keep working on the same
+/// media; an erase without callback is not waited for.
+//------------------------------------------------------------------------------
+static uint8_t MEDSdasync_Queue(Media         *media,
+                                uint32_t      address,
+                                void          *data,
+                                uint32_t      length,
+                                MediaCallback callback,
+                                void          *argument,
+                                uint8_t       op)
+{
+    MEDSdQueue   *pQ = MEDSdasync_GetQueue(media);
+    MEDSdRequest *pR;
+    volatile uint8_t done = 0;
+    uint8_t wait = (callback == 0 && op != MEDSD_OP_ERASE);
+    uint8_t started;
+    uint8_t slot;
+
+    if (media->state == MED_STATE_NOT_READY) {
+
+        return MED_STATUS_ERROR;
+    }
+    if (op != MEDSD_OP_READ && media->protected) {
+
+        return MED_STATUS_PROTECTED;
+    }
+    if ((length + address) > media->size) {
+
+        TRACE_WARNING("MEDSdasync: Data too big: %d, %d\n\r",
+                      (int)length, (int)address);
+        return MED_STATUS_ERROR;
+    }
+
+    // Add to queue, with the interrupt masked while the ring is updated
+    NVIC_DisableIRQ(HSMCI_IRQn);
+    if (pQ->count >= MEDSD_QUEUE_SIZE) {
+
+        NVIC_EnableIRQ(HSMCI_IRQn);
+        TRACE_INFO("MEDSdasync: Queue full\n\r");
+        return MED_STATUS_BUSY;
+    }
+    slot = pQ->head + pQ->count;
+    if (slot >= MEDSD_QUEUE_SIZE) slot -= MEDSD_QUEUE_SIZE;
+    pR = &pQ->requests[slot];
+    pR->data     = data;
+    pR->address  = address;
+    pR->length   = length;
+    pR->op       = op;
+    pR->passed   = 0;
+    if (wait) {
+
+        pR->callback = MEDSdasync_SyncDone;
+        pR->argument = (void*)&done;
+    }
+    else {
+
+        pR->callback = callback;
+        pR->argument = argument;
+    }
+    pQ->count ++;
+    media->state = MED_STATE_BUSY;
+    MEDSdasync_Schedule(pQ);
+    started = MEDSdasync_Start(media);
+    NVIC_EnableIRQ(HSMCI_IRQn);
+
+    if (started == 2) {
+
+        MEDSdasync_Erase(media);
+    }
+    if (wait) {
+
+        while (!done) {
+
+            MEDSdasync_Handler(media);
+        }
+        return (done == 1) ? MED_STATUS_SUCCESS : MED_STATUS_ERROR;
+    }
+    return MED_STATUS_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+//! \brief  Queues a read from the SD card.
+//! \see    MEDSdusb_Read
+//------------------------------------------------------------------------------
+static uint8_t MEDSdasync_Read(Media         *media,
+                               uint32_t      address,
+                               void          *data,
+                               uint32_t      length,
+                               MediaCallback callback,
+                               void          *argument)
+{
+    TRACE_INFO_WP("SDaRd(%d,%d) ", (int)address, (int)length);
+    return MEDSdasync_Queue(media, address, data, length,
+                            callback, argument, MEDSD_OP_READ);
+}
+
+//------------------------------------------------------------------------------
+//! \brief  Queues a write to the SD card.
+//! \see    MEDSdusb_Write
+//------------------------------------------------------------------------------
+static uint8_t MEDSdasync_Write(Media         *media,
+                                uint32_t      address,
+                                void          *data,
+                                uint32_t      length,
+                                MediaCallback callback,
+                                void          *argument)
+{
+    TRACE_INFO_WP("SDaWr(%d,%d) ", (int)address, (int)length);
+    return MEDSdasync_Queue(media, address, data, length,
+                            callback, argument, MEDSD_OP_WRITE);
+}
+
+//------------------------------------------------------------------------------
+/// Waits until all the queued requests are done.
+//------------------------------------------------------------------------------
+static uint8_t MEDSdasync_Flush(Media *media)
+{
+    MEDSdQueue *pQ = MEDSdasync_GetQueue(media);
+
+    while (pQ->count) {
+
+        MEDSdasync_Handler(media);
+    }
+    return MED_STATUS_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+/// Control method of the asynchronous SD media (MED_IOCTL_SYNC,
+/// MED_IOCTL_DISCARD, MED_IOCTL_ALIGN). The erase of the discarded blocks is queued like the
+/// other requests, after the older requests on the same blocks; the function
+/// only waits for a free request slot.
+/// \param  media Pointer to the Media instance.
+/// \param  ctrl  MED_IOCTL_xxx code.
+/// \param  buff  Code parameter.
+/// \return Operation result code
+//------------------------------------------------------------------------------
+static uint8_t MEDSdasync_Ioctl(Media *media, uint8_t ctrl, void *buff)
+{
+    MEDSdQueue *pQ = MEDSdasync_GetQueue(media);
+    uint32_t start;
+    uint32_t length;
+    uint8_t status;
+
+    switch (ctrl) {
+
+        case MED_IOCTL_SYNC:
+            return MEDSdasync_Flush(media);
+
+        case MED_IOCTL_ALIGN:
+            *(uint32_t*)buff = MEDSD_DMA_ALIGN;
+            return MED_STATUS_SUCCESS;
+
+        case MED_IOCTL_DISCARD:
+            status = MEDSdcard_EraseRange(media, (const MEDDiscard*)buff,
+                                          &start, &length);
+            if (status != MED_STATUS_SUCCESS || length == 0) {
+
+                return status;
+            }
+            while (pQ->count >= MEDSD_QUEUE_SIZE) {
+
+                MEDSdasync_Handler(media);
+            }
+            return MEDSdasync_Queue(media, start, 0, length, 0, 0,
+                                    MEDSD_OP_ERASE);
+
+        default:
+            return MED_STATUS_ERROR;
+    }
+}
+
+//------------------------------------------------------------------------------
+/// Drops the queued requests which are not started yet. Their callbacks are
+/// invoked with MED_STATUS_ERROR; the request on the card completes normally.
+//------------------------------------------------------------------------------
+static uint8_t MEDSdasync_CancelIo(Media *media)
+{
+    MEDSdQueue   *pQ = MEDSdasync_GetQueue(media);
+    MEDSdRequest *pR;
+    uint8_t slot;
+
+    NVIC_DisableIRQ(HSMCI_IRQn);
+    while (pQ->count > pQ->active) {
+
+        slot = pQ->head + pQ->count - 1;
+        if (slot >= MEDSD_QUEUE_SIZE) slot -= MEDSD_QUEUE_SIZE;
+        pR = &pQ->requests[slot];
+        pQ->count --;
+        if (pR->callback) {
+
+            pR->callback(pR->argument, MED_STATUS_ERROR, 0,
+                         pR->length * media->blockSize);
+        }
+    }
+    if (pQ->count == 0) {
+
+        media->state = MED_STATE_READY;
+    }
+    NVIC_EnableIRQ(HSMCI_IRQn);
+    return MED_STATUS_SUCCESS;
+}
+
 //------------------------------------------------------------------------------
 //      Exported Functions
 //------------------------------------------------------------------------------
@@ -455,52 +1124,21 @@ uint8_t MEDSdcard_Initialize(Media *media, uint8_t mciID)
     // Configure SDcard pins
     ConfigurePIO(mciID);
 
-#if defined(MCI2_INTERFACE)
-    DMAD_Initialize(BOARD_MCI_DMA_CHANNEL, DMAD_NO_DEFAULT_IT);
-#endif
-
-    // Initialize the MCI driver
-    if ( mciID == 0 )
-    {
-        IRQ_ConfigureIT(BOARD_SD_MCI_ID,  1, MCI0_IrqHandler);
-        MCI_Init(mciDrv, BOARD_SD_MCI_BASE, BOARD_SD_MCI_ID, BOARD_SD_SLOT, BOARD_MCK );
-        IRQ_EnableIT(BOARD_SD_MCI_ID);
-    }
-    else
-    {
-        #ifdef BOARD_SD_MCI1_ID
-        IRQ_ConfigureIT(BOARD_SD_MCI1_ID,  1, MCI0_IrqHandler);
-        MCI_Init(mciDrv, BOARD_SD_MCI1_BASE, BOARD_SD_MCI1_ID, BOARD_SD_MCI1_SLOT, BOARD_MCK );
-        IRQ_EnableIT(BOARD_SD_MCI1_ID);
-        #else
-        TRACE_ERROR("SD/MMC card initialization failed (MCI1 not supported)\n\r");
-        #endif
-    }
-#if MCI_BUSY_CHECK_FIX && defined(BOARD_SD_DAT0)
-    MCI_SetBusyFix(mciDrv, &pinSdDAT0);
-#endif
+    // Initialize the MCI driver and the SD card driver
+    if (!ConfigureDrivers(mciID)) {
 
-    // Initialize the SD card driver
-    if (SD_Init(sdDrv, (SdDriver *)mciDrv))
-    {
-        TRACE_ERROR("SD/MMC card initialization failed\n\r");
         return 0;
     }
-    else
-    {
-        //SD_DisplayRegisterCSD(&sdDrv);
-        TRACE_INFO("SD/MMC card initialization successful\n\r");
-        TRACE_INFO("Card size: %d MB\n\r", (int)(MMC_GetTotalSizeKB(sdDrv)/1024));
-    }
-    MCI_SetSpeed(mciDrv, sdDrv->transSpeed, sdDrv->transSpeed, BOARD_MCK);
 
     // Initialize media fields
     //--------------------------------------------------------------------------
-    media->interface = sdDrv;
+    media->interface = &sdDrv[mciID];
     #if !defined(OP_BOOTSTRAP_MCI_on)
     media->write = MEDSdcard_Write;
+    media->ioctl = MEDSdcard_Ioctl;
     #else
     media->write = 0;
+    media->ioctl = 0;
     #endif
     media->read = MEDSdcard_Read;
     media->lock = 0;
@@ -508,9 +1146,9 @@ uint8_t MEDSdcard_Initialize(Media *media, uint8_t mciID)
     media->handler = 0;
     media->flush = 0;
 
-    media->blockSize = SD_BLOCK_SIZE;
+    media->blockSize = SD_GetBlockSize(&sdDrv[mciID]);
     media->baseAddress = 0;
-    media->size = SD_TOTAL_BLOCK(sdDrv);
+    media->size = SD_GetNumberBlocks(&sdDrv[mciID]);
 
     media->mappedRD  = 0;
     media->mappedWR  = 0;
@@ -545,56 +1183,26 @@ uint8_t MEDSdusb_Initialize(Media *media, uint8_t mciID)
     // Configure SDcard pins
     ConfigurePIO(mciID);
 
-#if defined(MCI2_INTERFACE)
-    DMAD_Initialize(BOARD_MCI_DMA_CHANNEL, DMAD_NO_DEFAULT_IT);
-#endif
-    // Initialize the MCI driver
-    if ( mciID == 0 )
-    {
-        IRQ_ConfigureIT(BOARD_SD_MCI_ID,  1, MCI0_IrqHandler);
-        MCI_Init(mciDrv, BOARD_SD_MCI_BASE, BOARD_SD_MCI_ID, BOARD_SD_SLOT, BOARD_MCK );
-        IRQ_EnableIT(BOARD_SD_MCI_ID);
-    }
-    else
-    {
-#ifdef BOARD_SD_MCI1_ID
-        IRQ_ConfigureIT(BOARD_SD_MCI1_ID,  1, MCI0_IrqHandler);
-        MCI_Init(mciDrv, BOARD_SD_MCI1_BASE, BOARD_SD_MCI1_ID, BOARD_SD_SLOT, BOARD_MCK );
-        IRQ_EnableIT(BOARD_SD_MCI1_ID);
-#else
-        TRACE_ERROR("SD/MMC card initialization failed (MCI1 not supported)\n\r");
-#endif
-    }
-#if MCI_BUSY_CHECK_FIX && defined(BOARD_SD_DAT0)
-    MCI_SetBusyFix(mciDrv, &pinSdDAT0);
-#endif
+    // Initialize the MCI driver and the SD card driver
+    if (!ConfigureDrivers(mciID)) {
 
-    // Initialize the SD card driver
-    if (SD_Init(sdDrv, (SdDriver *)mciDrv))
-    {
-        TRACE_ERROR("SD/MMC card initialization failed\n\r");
         return 0;
     }
-    else
-    {
-        TRACE_INFO("SD/MMC card initialization successful\n\r");
-        TRACE_INFO("Card size: %d MB\n\r", (int)(MMC_GetTotalSizeKB(sdDrv)/1024));
-    }
-    MCI_SetSpeed(mciDrv, sdDrv->transSpeed, sdDrv->transSpeed, BOARD_MCK);
 
     // Initialize media fields
     //--------------------------------------------------------------------------
-    media->interface = sdDrv;
+    media->interface = &sdDrv[mciID];
     media->write = MEDSdusb_Write;
     media->read = MEDSdusb_Read;
     media->lock = 0;
     media->unlock = 0;
     media->handler = 0;
     media->flush = 0;
+    media->ioctl = MEDSdcard_Ioctl;
 
-    media->blockSize = SD_BLOCK_SIZE;
+    media->blockSize = SD_GetBlockSize(&sdDrv[mciID]);
     media->baseAddress = 0;
-    media->size = SD_TOTAL_BLOCK(sdDrv);
+    media->size = SD_GetNumberBlocks(&sdDrv[mciID]);
 
     media->mappedRD  = 0;
     media->mappedWR  = 0;
@@ -613,44 +1221,83 @@ uint8_t MEDSdusb_Initialize(Media *media, uint8_t mciID)
 }
 
 //------------------------------------------------------------------------------
-/// erase all the Sdcard
+/// Initializes a Media instance for asynchronous, queued access to the SD
+/// card. Read and write requests return as soon as they are queued and
+/// complete through their MediaCallback, invoked from the HSMCI interrupt.
+/// Pending requests are reordered by address (see MEDSdasync_Schedule()), and
+/// consecutive requests in the same direction are chained on the open
+/// multi-block command; the others are started by MED_HandleAll(), which must
+/// then be polled by the application. Requests without callback are
+/// synchronous. MED_IOCTL_DISCARD queues an erase of the discarded blocks.
+/// \param  media Pointer to the Media instance to initialize
+/// \param  mciID MCI interface index
+/// \return 1 if success.
+//------------------------------------------------------------------------------
+uint8_t MEDSdasync_Initialize(Media *media, uint8_t mciID)
+{
+    MEDSdQueue *pQ;
+
+    if (!MEDSdusb_Initialize(media, mciID)) {
+
+        return 0;
+    }
+    pQ = MEDSdasync_GetQueue(media);
+    pQ->head = 0;
+    pQ->count = 0;
+    pQ->active = 0;
+    pQ->lastOp = MEDSD_OP_READ;
+    pQ->nextBlock = 0;
+    pQ->auBlocks = SD_GetAuBlocks((SdCard*)media->interface);
+
+    media->write    = MEDSdasync_Write;
+    media->read     = MEDSdasync_Read;
+    media->handler  = MEDSdasync_Handler;
+    media->flush    = MEDSdasync_Flush;
+    media->ioctl    = MEDSdasync_Ioctl;
+    media->cancelIo = MEDSdasync_CancelIo;
+
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+/// erase all the Sdcard, with the card erase commands
 /// \param  media Pointer to the Media instance to initialize
 //------------------------------------------------------------------------------
 void MEDSdcard_EraseAll(Media *media)
 {
-    uint8_t buffer[SD_BLOCK_SIZE];
-    uint32_t block;
-    uint32_t multiBlock = 1; // change buffer size for multiblocks
+    SdCard *pSd = (SdCard*)media->interface;
+    uint32_t unit = SD_GetEraseBlocks(pSd);
     uint8_t error;
 
     TRACE_INFO("MEDSdcard Erase All ...\n\r");
 
-    // Clear the block buffer
-    memset(buffer, 0, media->blockSize * multiBlock);
-
-    for (block=0;
-         block < (SD_TOTAL_BLOCK((SdCard*)media->interface)-multiBlock);
-         block += multiBlock)
-    {
-        error = SD_WriteBlock((SdCard*)media->interface, block, multiBlock, buffer);
-        assert( !error ); /* "\n\r-F- Failed to write block (%d) #%u\n\r", error, block */
-    }
+    error = SD_Erase(pSd, 0, (SD_TOTAL_BLOCK(pSd) / unit) * unit);
+    assert( !error ); /* "\n\r-F- Failed to erase card (%d)\n\r", error */
 }
 
 //------------------------------------------------------------------------------
-/// erase block
+/// erase block, with the card erase commands when the card erases single
+/// blocks; otherwise the block is written with zeros, as erasing its whole
+/// erase unit would lose the other blocks
 /// \param  media Pointer to the Media instance to initialize
 /// \param  block to erase
 //------------------------------------------------------------------------------
 void MEDSdcard_EraseBlock(Media *media, uint32_t block)
 {
-    uint8_t buffer[SD_BLOCK_SIZE];
+    uint8_t buffer[SDMMC_BLOCK_SIZE];
     uint8_t error;
 
+    if (SD_GetEraseBlocks((SdCard*)media->interface) == 1) {
+
+        error = SD_Erase((SdCard*)media->interface, block, 1);
+        assert( !error ) ; /* "\n\r-F- Failed to erase block (%d) #%u\n\r", error, block */
+        return;
+    }
+
     // Clear the block buffer
     memset(buffer, 0, media->blockSize);
 
-    error = SD_WriteBlock((SdCard*)media->interface, block, 1, buffer);
+    error = SD_WriteBlock((SdCard*)media->interface, block, buffer);
     assert( !error ) ; /* "\n\r-F- Failed to write block (%d) #%u\n\r", error, block */
 }
 
@@ -322,6 +322,7 @@ uint8_t MEDSdcard_Initialize(Media *media, SdCard * sdDrv, uint8_t protected)
     media->unlock = 0;
     media->handler = 0;
     media->flush = 0;
+    media->ioctl = 0;
 
     media->baseAddress = 0;
 
@@ -390,6 +391,7 @@ void MEDSdusb_Initialize(Media *media, SdCard * sdDrv, uint8_t protected)
     media->unlock = 0;
     media->handler = 0;
     media->flush = 0;
+    media->ioctl = 0;
 
     media->baseAddress = 0;
     if ( SD_TOTAL_SIZE(sdDrv) == 0xFFFFFFFF)
@@ -426,31 +428,24 @@ void MEDSdusb_Initialize(Media *media, SdCard * sdDrv, uint8_t protected)
 }
 
 /**
- *  erase all the Sdcard
+ *  erase all the Sdcard, with the card erase commands
  *  \param  media Pointer to the Media instance to initialize
  *------------------------------------------------------------------------------*/
 void MEDSdcard_EraseAll(Media *media)
 {
-    uint8_t buffer[SD_BLOCK_SIZE];
-    uint32_t block;
-    uint32_t multiBlock = 1; // change buffer size for multiblocks
+    SdCard *pSd = (SdCard*)media->interface;
+    uint32_t unit = SD_GetEraseBlocks(pSd);
     uint8_t error;
 
     TRACE_INFO("MEDSdcard Erase All ...\n\r");
 
-    // Clear the block buffer
-    memset(buffer, 0, media->blockSize * multiBlock);
-
-    for ( block=0 ; block < (SD_TOTAL_BLOCK((SdCard*)media->interface)-multiBlock) ; block += multiBlock )
-    {
-
-        error = SD_WriteBlock((SdCard*)media->interface, block, multiBlock, buffer);
-        assert( error == 0 ) ; /* "\n\r-F- Failed to write block (%d) #%u\n\r", error, block */
-    }
+    error = SD_Erase(pSd, 0, (SD_TOTAL_BLOCK(pSd) / unit) * unit);
+    assert( error == 0 ) ; /* "\n\r-F- Failed to erase card (%d)\n\r", error */
 }
 
 /**
- *  erase block
+ *  erase block, with the card erase commands when the card erases single
+ *  blocks; otherwise the block is written with zeros
  *  \param  media Pointer to the Media instance to initialize
  *  \param  block to erase
  *------------------------------------------------------------------------------*/
@@ -459,6 +454,13 @@ void MEDSdcard_EraseBlock(Media *media, uint32_t block)
     uint8_t buffer[SD_BLOCK_SIZE];
     uint8_t error;
 
+    if ( SD_GetEraseBlocks((SdCard*)media->interface) == 1 )
+    {
+        error = SD_Erase((SdCard*)media->interface, block, 1);
+        assert( error == 0 ) ; /* "\n\r-F- Failed to erase block (%d) #%u\n\r", error, block */
+        return;
+    }
+
     // Clear the block buffer
     memset(buffer, 0, media->blockSize);
 
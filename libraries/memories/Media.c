@@ -33,6 +33,196 @@
 
 #include "memories.h"
 
+#include <string.h>
+#include <assert.h>
+
+/*------------------------------------------------------------------------------
+//      Statistics
+ *------------------------------------------------------------------------------*/
+
+/// Statistics attached to the medias, see MED_StatsAttach()
+static MEDStats* pStatsList = 0 ;
+
+/**
+ *  \brief  Finds the statistics of a media
+ *  \param  pMedia  Pointer to a Media instance
+ *  \return Pointer to the statistics, or 0 if none is attached
+ */
+static MEDStats* MED_FindStats( Media* pMedia )
+{
+    MEDStats* pStats ;
+
+    for ( pStats = pStatsList ; pStats != 0 ; pStats = pStats->pNext )
+    {
+        if ( pStats->pMedia == pMedia )
+        {
+            break ;
+        }
+    }
+
+    return pStats ;
+}
+
+/**
+ *  \brief  Charges the time since the last event to the elapsed time, and
+ *          to the busy time if requests are in flight; called with the
+ *          interrupts masked
+ *  \param  pStats  Statistics of the media
+ *  \return Cycle counter
+ */
+static uint32_t MED_StatsClock( MEDStats* pStats )
+{
+    uint32_t dwNow = DWT_CYCCNT ;
+    uint32_t dwDelta = dwNow - pStats->lastTime ;
+
+    pStats->elapsedCycles += dwDelta ;
+    if ( pStats->depth != 0 )
+    {
+        pStats->busyCycles += dwDelta ;
+    }
+    pStats->lastTime = dwNow ;
+
+    return dwNow ;
+}
+
+/**
+ *  \brief  Counts an operation and starts timing it
+ *  \param  pStats    Statistics of the media
+ *  \param  pOp       Statistics of the kind of operation
+ *  \param  dwBytes   Bytes requested
+ *  \param  callback  Callback of the caller
+ *  \param  argument  Argument of the callback
+ *  \return Request timed, or 0 if MED_STATS_PENDING requests are already
+ *          in flight: the operation is then counted but not timed
+ */
+static MEDStatsRequest* MED_StatsBegin( MEDStats* pStats, MEDOpStats* pOp, uint32_t dwBytes,
+                                        MediaCallback callback, void* argument )
+{
+    MEDStatsRequest* pRequest = 0 ;
+    uint32_t primask = __get_PRIMASK() ;
+    uint32_t dwNow ;
+    uint32_t i ;
+
+    __disable_irq() ;
+    dwNow = MED_StatsClock( pStats ) ;
+    pOp->count++ ;
+    pOp->bytes += dwBytes ;
+    for ( i = 0 ; i < MED_STATS_PENDING ; i++ )
+    {
+        if ( pStats->requests[i].pStats == 0 )
+        {
+            pRequest = &(pStats->requests[i]) ;
+            pRequest->pStats = pStats ;
+            pRequest->pOp = pOp ;
+            pRequest->callback = callback ;
+            pRequest->argument = argument ;
+            pRequest->start = dwNow ;
+
+            pStats->tracked++ ;
+            if ( ++pStats->depth > pStats->maxDepth )
+            {
+                pStats->maxDepth = pStats->depth ;
+            }
+            pStats->depthSum += pStats->depth ;
+            break ;
+        }
+    }
+    __set_PRIMASK( primask ) ;
+
+    return pRequest ;
+}
+
+/**
+ *  \brief  Ends a timed request and charges its latency
+ *  \param  pRequest  Request returned by MED_StatsBegin()
+ *  \param  bStatus   Result of the operation
+ */
+static void MED_StatsEnd( MEDStatsRequest* pRequest, uint8_t bStatus )
+{
+    MEDStats* pStats = pRequest->pStats ;
+    MEDOpStats* pOp = pRequest->pOp ;
+    uint32_t primask = __get_PRIMASK() ;
+    uint32_t dwUs ;
+    uint32_t dwBucket ;
+
+    __disable_irq() ;
+    dwUs = (MED_StatsClock( pStats ) - pRequest->start) / pStats->cyclesPerUs ;
+    pStats->depth-- ;
+    if ( bStatus != MED_STATUS_SUCCESS )
+    {
+        pOp->errors++ ;
+    }
+    else
+    {
+        pOp->timed++ ;
+        pOp->totalLatency += dwUs ;
+        if ( dwUs > pOp->maxLatency )
+        {
+            pOp->maxLatency = dwUs ;
+        }
+        for ( dwBucket = 0 ; ((dwUs >> 1) != 0) && (dwBucket < MED_STATS_BUCKETS-1) ; dwUs >>= 1 )
+        {
+            dwBucket++ ;
+        }
+        pOp->histogram[dwBucket]++ ;
+    }
+    pRequest->pStats = 0 ;
+    __set_PRIMASK( primask ) ;
+}
+
+/**
+ *  \brief  Completion of a timed transfer, passed on to the caller
+ */
+static void MED_StatsCallback( void* argument, uint8_t status, uint32_t transferred, uint32_t remaining )
+{
+    MEDStatsRequest* pRequest = (MEDStatsRequest*)argument ;
+    MediaCallback callback = pRequest->callback ;
+    void* pArg = pRequest->argument ;
+
+    MED_StatsEnd( pRequest, status ) ;
+    if ( callback )
+    {
+        callback( pArg, status, transferred, remaining ) ;
+    }
+}
+
+/**
+ *  \brief  Reads or writes a media with statistics. A request without
+ *          callback is timed until the method returns; otherwise until the
+ *          callback, which is wrapped.
+ */
+static uint32_t MED_StatsTransfer( Media* pMedia, MEDStats* pStats, uint8_t bWrite, uint32_t address,
+                                   void* data, uint32_t length, MediaCallback callback, void* argument )
+{
+    Media_read fTransfer = bWrite ? pMedia->write : pMedia->read ;
+    MEDStatsRequest* pRequest ;
+    uint32_t dwResult ;
+
+    pRequest = MED_StatsBegin( pStats, bWrite ? &(pStats->write) : &(pStats->read),
+                               length * pMedia->blockSize, callback, argument ) ;
+    if ( pRequest == 0 )
+    {
+        return fTransfer( pMedia, address, data, length, callback, argument ) ;
+    }
+
+    if ( callback == 0 )
+    {
+        dwResult = fTransfer( pMedia, address, data, length, 0, 0 ) ;
+        MED_StatsEnd( pRequest, dwResult ) ;
+    }
+    else
+    {
+        dwResult = fTransfer( pMedia, address, data, length, MED_StatsCallback, pRequest ) ;
+        if ( dwResult != MED_STATUS_SUCCESS )
+        {
+            // Refused, the callback will not be invoked
+            MED_StatsEnd( pRequest, dwResult ) ;
+        }
+    }
+
+    return dwResult ;
+}
+
 /*------------------------------------------------------------------------------
 //      Inline Functions
  *------------------------------------------------------------------------------*/
@@ -50,7 +240,22 @@
  */
 extern uint32_t MED_Write( Media* pMedia, uint32_t address, void* data, uint32_t length, MediaCallback callback, void* argument )
 {
-    return pMedia->write( pMedia, address, data, length, callback, argument ) ;
+    uint32_t dwResult ;
+
+    MEDStats* pStats = MED_FindStats( pMedia ) ;
+
+    PROF_Enter( PROF_ID_MED_WRITE ) ;
+    if ( pStats )
+    {
+        dwResult = MED_StatsTransfer( pMedia, pStats, 1, address, data, length, callback, argument ) ;
+    }
+    else
+    {
+        dwResult = pMedia->write( pMedia, address, data, length, callback, argument ) ;
+    }
+    PROF_Exit( PROF_ID_MED_WRITE ) ;
+
+    return dwResult ;
 }
 
 /**
@@ -69,7 +274,22 @@ extern uint32_t MED_Write( Media* pMedia, uint32_t address, void* data, uint32_t
  */
 extern uint32_t MED_Read( Media* pMedia, uint32_t address, void* data, uint32_t length, MediaCallback callback, void* argument )
 {
-    return pMedia->read( pMedia, address, data, length, callback, argument ) ;
+    uint32_t dwResult ;
+
+    MEDStats* pStats = MED_FindStats( pMedia ) ;
+
+    PROF_Enter( PROF_ID_MED_READ ) ;
+    if ( pStats )
+    {
+        dwResult = MED_StatsTransfer( pMedia, pStats, 0, address, data, length, callback, argument ) ;
+    }
+    else
+    {
+        dwResult = pMedia->read( pMedia, address, data, length, callback, argument ) ;
+    }
+    PROF_Exit( PROF_ID_MED_READ ) ;
+
+    return dwResult ;
 }
 
 /**
@@ -120,14 +340,201 @@ extern inline uint32_t MED_Unlock( Media* pMedia, uint32_t start, uint32_t end,
  */
 extern uint32_t MED_Flush( Media* pMedia )
 {
-    if ( pMedia->flush )
+    MEDStats* pStats ;
+    MEDStatsRequest* pRequest ;
+    uint32_t dwResult ;
+
+    if ( !pMedia->flush )
+    {
+        return MED_STATUS_SUCCESS ;
+    }
+
+    pStats = MED_FindStats( pMedia ) ;
+    if ( !pStats )
     {
         return pMedia->flush( pMedia ) ;
     }
-    else {
 
-        return MED_STATUS_SUCCESS ;
+    pRequest = MED_StatsBegin( pStats, &(pStats->flush), 0, 0, 0 ) ;
+    dwResult = pMedia->flush( pMedia ) ;
+    if ( pRequest )
+    {
+        MED_StatsEnd( pRequest, dwResult ) ;
     }
+
+    return dwResult ;
+}
+
+/**
+ *  \brief  Gives the memory address of a range of a mapped media, whose
+ *          blocks are laid out at blockSize * (baseAddress + block).
+ *  \param  media Pointer to the Media instance to use
+ *  \param  pMap  Range to map, receives its address
+ *  \return Operation result code
+ */
+static uint32_t MED_MapDefault( Media* pMedia, MEDMap* pMap )
+{
+    if ( !pMedia->mappedRD || (pMap->address + pMap->length) > pMedia->size )
+    {
+        return MED_STATUS_ERROR ;
+    }
+
+    pMap->data = (void*)(pMedia->blockSize * (pMedia->baseAddress + pMap->address)) ;
+
+    return MED_STATUS_SUCCESS ;
+}
+
+/**
+ *  \brief  Copies the statistics of a media
+ *  \param  media Pointer to the Media instance to use
+ *  \param  pCopy Receives the statistics
+ *  \return Operation result code, MED_STATUS_ERROR without statistics
+ */
+static uint32_t MED_StatsCopy( Media* pMedia, MEDStats* pCopy )
+{
+    MEDStats* pStats = MED_FindStats( pMedia ) ;
+    uint32_t primask ;
+
+    if ( !pStats )
+    {
+        return MED_STATUS_ERROR ;
+    }
+
+    primask = __get_PRIMASK() ;
+    __disable_irq() ;
+    MED_StatsClock( pStats ) ;
+    memcpy( pCopy, pStats, sizeof( MEDStats ) ) ;
+    __set_PRIMASK( primask ) ;
+
+    return MED_STATUS_SUCCESS ;
+}
+
+/**
+ *  \brief  Sends a control code to a media. MED_IOCTL_STATS is served here
+ *          from the attached statistics. Without a control method,
+ *          MED_IOCTL_SYNC flushes the media, MED_IOCTL_DISCARD, a hint,
+ *          is ignored and MED_IOCTL_MAP is served from the media geometry
+ *          when the media is mappedRD.
+ *  \param  media Pointer to the Media instance to use
+ *  \param  ctrl  MED_IOCTL_xxx code
+ *  \param  buff  Code parameter (MEDDiscard for MED_IOCTL_DISCARD, MEDMap
+ *                for MED_IOCTL_MAP, uint32_t for MED_IOCTL_ALIGN)
+ *  \return Operation result code
+ */
+extern uint32_t MED_Ioctl( Media* pMedia, uint8_t ctrl, void* buff )
+{
+    if ( ctrl == MED_IOCTL_STATS )
+    {
+        return MED_StatsCopy( pMedia, (MEDStats*)buff ) ;
+    }
+
+    if ( pMedia->ioctl )
+    {
+        return pMedia->ioctl( pMedia, ctrl, buff ) ;
+    }
+
+    switch ( ctrl )
+    {
+        case MED_IOCTL_SYNC :
+            return MED_Flush( pMedia ) ;
+
+        case MED_IOCTL_DISCARD :
+            return MED_STATUS_SUCCESS ;
+
+        case MED_IOCTL_MAP :
+            return MED_MapDefault( pMedia, (MEDMap*)buff ) ;
+
+        case MED_IOCTL_ALIGN :
+            /* The media without ioctl copy the data with the core */
+            *(uint32_t*)buff = 1 ;
+            return MED_STATUS_SUCCESS ;
+
+        default :
+            return MED_STATUS_ERROR ;
+    }
+}
+
+/**
+ *  \brief  Gives the memory address of a range of a mapped media, so that
+ *          the data can be read in place instead of through MED_Read()
+ *  \param  media    Pointer to the Media instance to use
+ *  \param  address  First block of the range
+ *  \param  length   Number of blocks
+ *  \param  pData    Receives the memory address of the first block
+ *  \return MED_STATUS_SUCCESS, or MED_STATUS_ERROR if the media or the
+ *          range is not mapped
+ */
+extern uint32_t MED_Map( Media* pMedia, uint32_t address, uint32_t length, void** pData )
+{
+    MEDMap map ;
+    uint32_t status ;
+
+    map.address = address ;
+    map.length = length ;
+    map.data = 0 ;
+
+    status = MED_Ioctl( pMedia, MED_IOCTL_MAP, &map ) ;
+    if ( status == MED_STATUS_SUCCESS )
+    {
+        *pData = map.data ;
+    }
+
+    return status ;
+}
+
+/**
+ *  \brief  Gives the alignment a buffer needs for the media to transfer
+ *          straight from or to it (DMA), with MED_IOCTL_ALIGN
+ *  \param  media Pointer to the Media instance to use
+ *  \return Alignment in bytes, 1 if the media has no constraint
+ */
+extern uint32_t MED_GetAlignment( Media* pMedia )
+{
+    uint32_t dwAlign = 1 ;
+
+    if ( MED_Ioctl( pMedia, MED_IOCTL_ALIGN, &dwAlign ) != MED_STATUS_SUCCESS )
+    {
+        dwAlign = 1 ;
+    }
+
+    return dwAlign ;
+}
+
+/**
+ *  \brief  Tells whether a buffer can be transferred directly by a media
+ *  \param  media   Pointer to the Media instance to use
+ *  \param  pBuffer Data buffer
+ *  \return 1 if the buffer has the alignment of the media, otherwise 0
+ */
+extern uint32_t MED_IsAligned( Media* pMedia, const void* pBuffer )
+{
+    return ((uint32_t)pBuffer & (MED_GetAlignment( pMedia ) - 1)) == 0 ;
+}
+
+/**
+ *  \brief  Allocates a buffer suiting the direct transfers of every media
+ *          (MED_ALIGN_MAX), from the regions of HEAP_Alloc()
+ *  \param  dwSize  Size of the buffer, in bytes
+ *  \param  dwFlags HEAP_xxx regions the buffer may come from
+ *  \return Address of the buffer, or NULL
+ */
+extern void* MED_AllocBuffer( uint32_t dwSize, uint32_t dwFlags )
+{
+    void* pBuffer = HEAP_Alloc( dwSize, dwFlags ) ;
+
+    /* The heap regions are aligned on 8 bytes */
+    assert( ((uint32_t)pBuffer & (MED_ALIGN_MAX - 1)) == 0 ) ;
+
+    return pBuffer ;
+}
+
+/**
+ *  \brief  Frees a buffer taken from MED_AllocBuffer()
+ *  \param  pBuffer Buffer to free, or NULL
+ */
+extern void MED_FreeBuffer( void* pBuffer )
+{
+    HEAP_Free( pBuffer ) ;
 }
 
 /**
@@ -167,6 +574,22 @@ extern inline uint32_t MED_IsInitialized( Media* pMedia )
 /// Number of medias which are effectively used.
 uint32_t numMedias =0 ;
 
+/// Handlers posted to the work queue by MED_Notify()
+static uint8_t bDeferredHandler = 0 ;
+
+/**
+ *  \brief  Work queue item running the handler of a media
+ *  \param  pArg    Media instance
+ *  \param  dwParam Unused
+ */
+static void MED_DeferredHandler( void* pArg, uint32_t dwParam )
+{
+    Media* pMedia = (Media*)pArg ;
+
+    pMedia->notified = 0 ;
+    MED_Handler( pMedia ) ;
+}
+
 /**
  *  \brief  Handle interrupts on specified media
  *  \param  pMedia    List of media
@@ -183,3 +606,121 @@ extern void MED_HandleAll( Media* pMedia, uint8_t bNumMedia )
         MED_Handler( &(pMedia[i]) ) ;
     }
 }
+
+/**
+ *  \brief  Selects how the media handlers needed by the interrupts run.
+ *
+ *  In deferred mode, MED_Notify() posts the handler to the work queue (see
+ *  workq.h), which must be initialized beforehand; otherwise the handlers
+ *  only run from MED_HandleAll().
+ *  \param  bDefer  1 to post the handlers to the work queue, 0 to leave them
+ *                  to MED_HandleAll()
+ */
+extern void MED_SetDeferredHandler( uint8_t bDefer )
+{
+    bDeferredHandler = bDefer ;
+}
+
+/**
+ *  \brief  Requests a run of the media handler, e.g. from the media interrupt
+ *          once a request is done and the next one can not be started in the
+ *          interrupt. The handler is posted once until it runs; nothing is
+ *          done out of the deferred mode, MED_HandleAll() running it.
+ *  \param  pMedia  Pointer to the Media instance
+ */
+extern void MED_Notify( Media* pMedia )
+{
+    if ( !bDeferredHandler || pMedia->notified || !pMedia->handler )
+    {
+        return ;
+    }
+
+    pMedia->notified = 1 ;
+    if ( !WORKQ_Post( MED_DeferredHandler, pMedia, 0 ) )
+    {
+        // Queue full, left to MED_HandleAll()
+        pMedia->notified = 0 ;
+    }
+}
+
+/**
+ *  \brief  Attaches statistics to a media: MED_Read(), MED_Write() and
+ *          MED_Flush() then count and time the operations of the media.
+ *  \param  pMedia  Pointer to a Media instance
+ *  \param  pStats  Statistics, kept until MED_StatsDetach()
+ *  \param  dwMck   Core clock frequency in Hz, to convert the cycles
+ */
+extern void MED_StatsAttach( Media* pMedia, MEDStats* pStats, uint32_t dwMck )
+{
+    uint32_t primask ;
+
+    MED_StatsDetach( pMedia ) ;
+
+    memset( pStats, 0, sizeof( MEDStats ) ) ;
+    pStats->pMedia = pMedia ;
+    pStats->cyclesPerUs = (dwMck + 500000) / 1000000 ;
+    if ( pStats->cyclesPerUs == 0 )
+    {
+        pStats->cyclesPerUs = 1 ;
+    }
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk ;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA ;
+    pStats->lastTime = DWT_CYCCNT ;
+
+    primask = __get_PRIMASK() ;
+    __disable_irq() ;
+    pStats->pNext = pStatsList ;
+    pStatsList = pStats ;
+    __set_PRIMASK( primask ) ;
+}
+
+/**
+ *  \brief  Detaches the statistics of a media. Requests in flight must
+ *          have completed.
+ *  \param  pMedia  Pointer to a Media instance
+ */
+extern void MED_StatsDetach( Media* pMedia )
+{
+    MEDStats** ppStats ;
+    uint32_t primask = __get_PRIMASK() ;
+
+    __disable_irq() ;
+    for ( ppStats = &pStatsList ; *ppStats != 0 ; ppStats = &((*ppStats)->pNext) )
+    {
+        if ( (*ppStats)->pMedia == pMedia )
+        {
+            *ppStats = (*ppStats)->pNext ;
+            break ;
+        }
+    }
+    __set_PRIMASK( primask ) ;
+}
+
+/**
+ *  \brief  Clears the counters of a media; requests in flight stay timed.
+ *  \param  pMedia  Pointer to a Media instance
+ */
+extern void MED_StatsReset( Media* pMedia )
+{
+    MEDStats* pStats = MED_FindStats( pMedia ) ;
+    uint32_t primask ;
+
+    if ( !pStats )
+    {
+        return ;
+    }
+
+    primask = __get_PRIMASK() ;
+    __disable_irq() ;
+    memset( &(pStats->read), 0, sizeof( MEDOpStats ) ) ;
+    memset( &(pStats->write), 0, sizeof( MEDOpStats ) ) ;
+    memset( &(pStats->flush), 0, sizeof( MEDOpStats ) ) ;
+    pStats->maxDepth = pStats->depth ;
+    pStats->tracked = 0 ;
+    pStats->depthSum = 0 ;
+    pStats->busyCycles = 0 ;
+    pStats->elapsedCycles = 0 ;
+    pStats->lastTime = DWT_CYCCNT ;
+    __set_PRIMASK( primask ) ;
+}
@@ -28,7 +28,7 @@
 
 # Makefile for compiling libmemories
 .SUFFIXES: .o .a .c .s
-SUB_MAKEFILES=debug.mk gcc.mk iar.mk mdk.mk release.mk win.mk linux.mk
+SUB_MAKEFILES=debug.mk gcc.mk iar.mk mdk.mk perf.mk release.mk win.mk linux.mk
 
 #-------------------------------------------------------------------------------
 # User-modifiable options
@@ -89,8 +89,12 @@ INCLUDES += -I$(PROJECT_BASE_PATH)/../libchip_$(SERIE)
 ifdef DEBUG
 include debug.mk
 else
+ifdef PERF
+include perf.mk
+else
 include release.mk
 endif
+endif
 
 #-------------------------------------------------------------------------------
 # Tools
@@ -103,9 +107,14 @@ ifdef DEBUG
 OUTPUT_OBJ=debug
 OUTPUT_LIB=$(LIBNAME)_$(SERIE)_$(TOOLCHAIN)_dbg.a
 else
+ifdef PERF
+OUTPUT_OBJ=perf
+OUTPUT_LIB=$(LIBNAME)_$(SERIE)_$(TOOLCHAIN)_perf.a
+else
 OUTPUT_OBJ=release
 OUTPUT_LIB=$(LIBNAME)_$(SERIE)_$(TOOLCHAIN)_rel.a
 endif
+endif
 
 OUTPUT_PATH=$(OUTPUT_OBJ)_$(BOARD)
 
@@ -121,14 +130,7 @@ C_SRC+=$(wildcard $(PROJECT_BASE_PATH)/spi-flash/*.c)
 C_OBJ_TEMP=$(patsubst %.c, %.o, $(notdir $(C_SRC)))
 
 # during development, remove some files
-C_OBJ_FILTER=at26.o
-C_OBJ_FILTER+=at26d.o
-C_OBJ_FILTER+=at45.o
-C_OBJ_FILTER+=at45d.o
-C_OBJ_FILTER+=spid.o
-C_OBJ_FILTER+=spid_dma.o
-C_OBJ_FILTER+=MEDSdcard.o
-C_OBJ_FILTER+=MEDSdmmc.o
+C_OBJ_FILTER=MEDSdmmc.o
 
 ifneq '$(TOOLCHAIN)' 'gcc'
 C_OBJ_FILTER+=syscalls.o board_cstartup_gnu.o
@@ -0,0 +1,77 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Cortex-M3 core header for the host build: includes the CMSIS header
+ * without its GNU inline assembly, and provides the intrinsics used by the
+ * libraries as no-ops (the host build is single-threaded).
+ *
+ */
+
+#ifndef _HOST_CORE_CM3_
+#define _HOST_CORE_CM3_
+
+#include <stdint.h>
+
+#define __INLINE         inline
+#define __ASM            __asm
+
+static inline void __enable_irq( void ) { }
+static inline void __disable_irq( void ) { }
+static inline void __enable_fault_irq( void ) { }
+static inline void __disable_fault_irq( void ) { }
+static inline void __NOP( void ) { }
+static inline void __WFI( void ) { }
+static inline void __WFE( void ) { }
+static inline void __SEV( void ) { }
+static inline void __ISB( void ) { }
+static inline void __DSB( void ) { __sync_synchronize() ; }
+static inline void __DMB( void ) { __sync_synchronize() ; }
+static inline void __CLREX( void ) { }
+
+static inline uint32_t __get_PRIMASK( void ) { return 0 ; }
+static inline void __set_PRIMASK( uint32_t priMask ) { (void)priMask ; }
+static inline uint32_t __get_BASEPRI( void ) { return 0 ; }
+static inline void __set_BASEPRI( uint32_t basePri ) { (void)basePri ; }
+static inline uint32_t __get_CONTROL( void ) { return 0 ; }
+static inline void __set_CONTROL( uint32_t control ) { (void)control ; }
+static inline uint32_t __get_MSP( void ) { return 0 ; }
+static inline uint32_t __get_PSP( void ) { return 0 ; }
+static inline uint32_t __RBIT( uint32_t value ) { uint32_t r = 0 ; int i ; for ( i = 0 ; i < 32 ; i++ ) { r = (r << 1) | ((value >> i) & 1) ; } return r ; }
+static inline uint32_t __REV( uint32_t value ) { return __builtin_bswap32( value ) ; }
+
+/* No compiler section of the CMSIS header matches */
+#pragma push_macro("__GNUC__")
+#undef __GNUC__
+#include "../../../../../libchip_sam3s/cmsis/core_cm3.h"
+#pragma pop_macro("__GNUC__")
+
+#endif /* _HOST_CORE_CM3_ */
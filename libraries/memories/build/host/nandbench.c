@@ -0,0 +1,756 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * NandFlash/FatFs benchmark running on the host over the simulated
+ * NandFlash (SimNandFlash). A FatFs workload, either a trace file or a
+ * synthetic data logger, goes through MEDNandFlash and the
+ * TranslatedNandFlash layers, and the simulated device reports:
+ * - the write amplification (bytes programmed / bytes written by the host),
+ * - the erase count distribution over the managed blocks,
+ * - the simulated device time and throughput,
+ * - the bit flips, failures and power cuts survived.
+ *
+ * The raw streaming mode (-r) erases, programs and reads back whole blocks
+ * with RawNandFlash_WritePages / RawNandFlash_ReadPages, to compare the
+ * throughput of one die with the one of dies striped on several chip
+ * enables (-d).
+ *
+ * Trace file lines (offsets and sizes in bytes, '#' starts a comment):
+ * \code
+ * write <path> <offset> <size>
+ * read <path> <offset> <size>
+ * delete <path>
+ * sync
+ * \endcode
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "board.h"
+#include "memories.h"
+#include "fatfs_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of medias (must match diskio_sam3s.c).*/
+#define MAX_MEDS                1
+
+/** Largest transfer of one trace line.*/
+#define MAX_TRANSFER            (64 * 1024)
+
+/** Synthetic workload: number of log files, record and index sizes.*/
+#define SYNTH_NUMFILES          4
+#define SYNTH_RECORDSIZE        1536
+#define SYNTH_INDEXSIZE         512
+#define SYNTH_INDEXPERIOD       8
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Available medias (used by diskio_sam3s.c).*/
+Media medias[MAX_MEDS];
+
+/** NandFlash stack.*/
+static struct TranslatedNandFlash translatedNf;
+
+/** File system.*/
+static FATFS fs;
+
+/** Currently open file, and its path.*/
+static FIL file;
+static char openPath[64];
+
+/** Number of managed blocks (0 for the whole device).*/
+static unsigned short numManagedBlocks;
+
+/** Model with a BCH spare scheme, or 0 to autodetect the model.*/
+static struct NandFlashModel bchModel;
+static const struct NandFlashModel *model;
+
+/** Program/erase operations between the power cuts (0 for none).*/
+static unsigned int powerCutPeriod;
+
+/** Counters of the workload.*/
+static struct {
+
+    unsigned long long bytesWritten;
+    unsigned long long bytesRead;
+    unsigned int operations;
+    unsigned int errors;
+    unsigned int mismatches;
+    unsigned int powerCuts;
+} host;
+
+/** Transfer buffers, aligned for the direct media transfers.*/
+MED_ALIGNED static unsigned char buffer[MAX_TRANSFER];
+MED_ALIGNED static unsigned char pattern[MAX_TRANSFER];
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief The host has no PSRAM: HEAP_Alloc() (MED_AllocBuffer()) only takes
+ * the buffers from malloc().
+ */
+void* BOARD_PsramAlloc(uint32_t dwSize)
+{
+    return NULL;
+}
+
+uint32_t BOARD_PsramGetFreeSize(void)
+{
+    return 0;
+}
+
+/**
+ * \brief Fills a buffer with the expected contents of a file area, so that
+ * reads can be checked.
+ */
+static void FillPattern(
+    unsigned char *data,
+    const char *path,
+    unsigned int offset,
+    unsigned int size)
+{
+    unsigned int seed = 5381;
+    unsigned int i;
+
+    while (*path) {
+
+        seed = seed * 33 + (unsigned char) *path++;
+    }
+    for (i=0; i < size; i++) {
+
+        data[i] = (unsigned char) (seed + ((offset + i) * 7) + ((offset + i) >> 9));
+    }
+}
+
+/**
+ * \brief Initializes the NandFlash stack and mounts the volume, formatting
+ * it if needed.
+ *
+ * \param format  Forces the formatting when set.
+ * \return 0 if successful; otherwise 1.
+ */
+static unsigned char Mount(unsigned char format)
+{
+    static const Pin pinNone;
+    FRESULT res;
+    DIR dir;
+
+    if (TranslatedNandFlash_Initialize(&translatedNf, model, 0, 0, 0,
+                                       pinNone, pinNone,
+                                       0, numManagedBlocks)) {
+
+        printf("-E- TranslatedNandFlash_Initialize failed\n\r");
+        return 1;
+    }
+    MEDNandFlash_Initialize(&medias[DRV_NAND], &translatedNf);
+
+    memset(&fs, 0, sizeof(fs));
+    f_mount(DRV_NAND, &fs);
+    openPath[0] = 0;
+
+    res = format ? FR_NO_FILESYSTEM : f_opendir(&dir, "0:");
+    if (res == FR_NO_FILESYSTEM) {
+
+        res = f_mkfs(DRV_NAND, 0, 512);
+    }
+    if (res != FR_OK) {
+
+        printf("-E- Mount failed (%d)\n\r", res);
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Recovers from a simulated power cut: powers the device on again
+ * and remounts the volume, as a reset would.
+ *
+ * \return 1 if a power cut has been handled; otherwise 0.
+ */
+static unsigned char CheckPowerCut(void)
+{
+    if (!SimNandFlash_IsPowerOff()) {
+
+        return 0;
+    }
+
+    host.powerCuts++;
+    SimNandFlash_PowerOn();
+    if (Mount(0)) {
+
+        printf("-E- Volume lost after power cut %u\n\r", host.powerCuts);
+        exit(2);
+    }
+    SimNandFlash_SetPowerCut(powerCutPeriod);
+
+    return 1;
+}
+
+/**
+ * \brief Opens a file, closing the previous one if different.
+ *
+ * \param path  Path of the file.
+ * \param mode  FatFs open mode.
+ * \return FatFs result.
+ */
+static FRESULT OpenFile(const char *path, BYTE mode)
+{
+    FRESULT res;
+
+    if (openPath[0] && !strcmp(openPath, path)) {
+
+        return FR_OK;
+    }
+    if (openPath[0]) {
+
+        f_close(&file);
+        openPath[0] = 0;
+    }
+    res = f_open(&file, path, mode);
+    if (res == FR_OK) {
+
+        strncpy(openPath, path, sizeof(openPath) - 1);
+    }
+
+    return res;
+}
+
+/**
+ * \brief Closes the open file, if any.
+ */
+static void CloseFile(void)
+{
+    if (openPath[0]) {
+
+        f_close(&file);
+        openPath[0] = 0;
+    }
+}
+
+/**
+ * \brief Executes one operation of the workload.
+ *
+ * \param op  Operation: 'w', 'r', 'd' or 's'.
+ * \param path  Path of the file.
+ * \param offset  Offset in the file.
+ * \param size  Number of bytes.
+ */
+static void Execute(char op, const char *path, unsigned int offset, unsigned int size)
+{
+    FRESULT res = FR_OK;
+    UINT count;
+
+    host.operations++;
+    if (size > MAX_TRANSFER) {
+
+        size = MAX_TRANSFER;
+    }
+
+    switch (op) {
+
+    case 'w':
+        res = OpenFile(path, FA_OPEN_ALWAYS | FA_READ | FA_WRITE);
+        if (res == FR_OK) {
+
+            res = f_lseek(&file, offset);
+        }
+        if (res == FR_OK) {
+
+            FillPattern(pattern, path, offset, size);
+            res = f_write(&file, pattern, size, &count);
+            host.bytesWritten += count;
+        }
+        break;
+
+    case 'r':
+        res = OpenFile(path, FA_OPEN_ALWAYS | FA_READ | FA_WRITE);
+        if ((res == FR_OK) && (offset < file.fsize)) {
+
+            res = f_lseek(&file, offset);
+            if (res == FR_OK) {
+
+                res = f_read(&file, buffer, size, &count);
+                host.bytesRead += count;
+                FillPattern(pattern, path, offset, count);
+                if ((res == FR_OK) && memcmp(buffer, pattern, count)) {
+
+                    host.mismatches++;
+                }
+            }
+        }
+        break;
+
+    case 'd':
+        CloseFile();
+        res = f_unlink(path);
+        if (res == FR_NO_FILE) {
+
+            res = FR_OK;
+        }
+        break;
+
+    case 's':
+        if (openPath[0]) {
+
+            res = f_sync(&file);
+        }
+        if (res == FR_OK) {
+
+            res = disk_ioctl(DRV_NAND, CTRL_SYNC, 0) ? FR_DISK_ERR : FR_OK;
+        }
+        break;
+    }
+
+    if (res != FR_OK) {
+
+        if (!CheckPowerCut()) {
+
+            host.errors++;
+            CloseFile();
+        }
+    }
+}
+
+/**
+ * \brief Replays a trace file.
+ *
+ * \param name  Path of the trace file.
+ * \return 0 if successful; otherwise 1.
+ */
+static unsigned char ReplayTrace(const char *name)
+{
+    FILE *trace = fopen(name, "r");
+    char line[256];
+    char command[16];
+    char path[64];
+    unsigned int offset;
+    unsigned int size;
+    int n;
+
+    if (!trace) {
+
+        printf("-E- Cannot open %s\n\r", name);
+        return 1;
+    }
+
+    while (fgets(line, sizeof(line), trace)) {
+
+        if ((line[0] == '#') || (line[0] == '\n') || (line[0] == '\r')) {
+
+            continue;
+        }
+        offset = size = 0;
+        n = sscanf(line, "%15s %63s %u %u", command, path, &offset, &size);
+        if ((n == 4) && !strcmp(command, "write")) {
+
+            Execute('w', path, offset, size);
+        }
+        else if ((n == 4) && !strcmp(command, "read")) {
+
+            Execute('r', path, offset, size);
+        }
+        else if ((n >= 2) && !strcmp(command, "delete")) {
+
+            Execute('d', path, 0, 0);
+        }
+        else if ((n >= 1) && !strcmp(command, "sync")) {
+
+            Execute('s', "", 0, 0);
+        }
+        else {
+
+            printf("-W- Ignored: %s", line);
+        }
+    }
+    fclose(trace);
+    CloseFile();
+
+    return 0;
+}
+
+/**
+ * \brief Synthetic data logger: records appended to a few log files, an
+ * index file rewritten in place and synced periodically, and the oldest log
+ * deleted when the volume is three quarters full.
+ *
+ * \param numRecords  Number of records to write.
+ */
+static void RunLogger(unsigned int numRecords)
+{
+    unsigned int sizes[SYNTH_NUMFILES];
+    unsigned int generation[SYNTH_NUMFILES];
+    char path[32];
+    char index[] = "0:index.bin";
+    unsigned long long capacity;
+    unsigned int used = 0;
+    unsigned int i;
+    unsigned int f;
+
+    capacity = (unsigned long long) medias[DRV_NAND].size * medias[DRV_NAND].blockSize;
+    memset(sizes, 0, sizeof(sizes));
+    memset(generation, 0, sizeof(generation));
+
+    for (i=0; i < numRecords; i++) {
+
+        f = i % SYNTH_NUMFILES;
+        sprintf(path, "0:log%u_%u.dat", f, generation[f]);
+        Execute('w', path, sizes[f], SYNTH_RECORDSIZE);
+        sizes[f] += SYNTH_RECORDSIZE;
+        used += SYNTH_RECORDSIZE;
+
+        if ((i % SYNTH_INDEXPERIOD) == SYNTH_INDEXPERIOD - 1) {
+
+            Execute('w', index, 0, SYNTH_INDEXSIZE);
+            Execute('s', "", 0, 0);
+            Execute('r', path, sizes[f] - SYNTH_RECORDSIZE, SYNTH_RECORDSIZE);
+        }
+
+        if ((unsigned long long) used * 4 > capacity * 3) {
+
+            Execute('d', path, 0, 0);
+            used -= sizes[f];
+            sizes[f] = 0;
+            generation[f]++;
+        }
+    }
+    CloseFile();
+}
+
+/**
+ * \brief Returns the BCH spare scheme for a page size and a strength.
+ *
+ * \param pageSize  Size of the data area of a page.
+ * \param strength  Number of bit errors corrected per 512 bytes (4 or 8).
+ * \return the scheme, or 0 if there is none.
+ */
+static const struct NandSpareScheme * GetBchScheme(
+    unsigned short pageSize,
+    unsigned char strength)
+{
+    switch ((pageSize << 4) | strength) {
+
+    case (512 << 4) | 4:  return &nandSpareScheme512Bch4;
+    case (2048 << 4) | 4: return &nandSpareScheme2048Bch4;
+    case (2048 << 4) | 8: return &nandSpareScheme2048Bch8;
+    case (4096 << 4) | 4: return &nandSpareScheme4096Bch4;
+    case (4096 << 4) | 8: return &nandSpareScheme4096Bch8;
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Raw streaming: erases, programs and reads back whole blocks, and
+ * prints the throughput of each phase.
+ *
+ * \param numBlocks  Number of blocks, from block 1.
+ * \return 0 if successful; otherwise 1.
+ */
+static unsigned char RunRawStream(unsigned short numBlocks)
+{
+    const struct SimNandFlashStats *stats = SimNandFlash_GetStats();
+    static const Pin pinNone;
+    struct RawNandFlash raw;
+    unsigned short numPages;
+    unsigned int blockSize;
+    unsigned char *data;
+    unsigned char *check;
+    unsigned long long times[3];
+    unsigned short block;
+    unsigned int i;
+    unsigned char error = 0;
+
+    if (RawNandFlash_Initialize(&raw, 0, 0, 0, 0, pinNone, pinNone)) {
+
+        return 1;
+    }
+    numPages = NandFlashModel_GetBlockSizeInPages(&raw.model);
+    blockSize = numPages * NandFlashModel_GetPageDataSize(&raw.model);
+    data = (unsigned char *) malloc(blockSize);
+    check = (unsigned char *) malloc(blockSize);
+    if (!data || !check) {
+
+        return 1;
+    }
+    for (i=0; i < blockSize; i++) {
+
+        data[i] = (unsigned char) (i * 7 + (i >> 9));
+    }
+
+    SimNandFlash_ResetStats();
+    for (block=1; (block <= numBlocks) && !error; block++) {
+
+        error = RawNandFlash_EraseBlock(&raw, block);
+    }
+    times[0] = stats->time;
+    for (block=1; (block <= numBlocks) && !error; block++) {
+
+        error = RawNandFlash_WritePages(&raw, block, 0, numPages, data, 0);
+    }
+    times[1] = stats->time - times[0];
+    for (block=1; (block <= numBlocks) && !error; block++) {
+
+        error = RawNandFlash_ReadPages(&raw, block, 0, numPages, check, 0);
+        if (!error && memcmp(data, check, blockSize)) {
+
+            printf("-E- Block %u read back differs\n\r", block);
+            error = 1;
+        }
+    }
+    times[2] = stats->time - times[0] - times[1];
+
+    printf("Dies                %u, blocks of %u pages (%u KB)\n\r",
+           raw.numDies, numPages, blockSize / 1024);
+    printf("Erase               %.3f ms per block\n\r", times[0] / 1e6 / numBlocks);
+    printf("Program             %.2f MB/s\n\r",
+           (double) blockSize * numBlocks / 1048576.0 / (times[1] / 1e9));
+    printf("Read                %.2f MB/s\n\r",
+           (double) blockSize * numBlocks / 1048576.0 / (times[2] / 1e9));
+    free(data);
+    free(check);
+
+    return error ? 1 : 0;
+}
+
+/**
+ * \brief Prints the benchmark results.
+ */
+static void PrintResults(void)
+{
+    const struct SimNandFlashStats *stats = SimNandFlash_GetStats();
+    unsigned short firstBlock = 0;
+    unsigned short numBlocks = numManagedBlocks;
+    unsigned int count, minCount = ~0u, maxCount = 0;
+    unsigned long long totalCount = 0;
+    unsigned short i;
+    double seconds = stats->time / 1e9;
+
+    for (i=0; i < numBlocks; i++) {
+
+        count = SimNandFlash_GetEraseCount(firstBlock + i);
+        totalCount += count;
+        minCount = (count < minCount) ? count : minCount;
+        maxCount = (count > maxCount) ? count : maxCount;
+    }
+
+    printf("Operations          %u (%u errors, %u read mismatches, %u power cuts)\n\r",
+           host.operations, host.errors, host.mismatches, host.powerCuts);
+    printf("Host written        %llu bytes\n\r", host.bytesWritten);
+    printf("Host read           %llu bytes\n\r", host.bytesRead);
+    printf("NAND programmed     %llu bytes (%u pages, %u copy-back)\n\r",
+           stats->bytesProgrammed, stats->programs, stats->copies);
+    printf("NAND read           %llu bytes (%u pages)\n\r", stats->bytesRead, stats->reads);
+    printf("NAND erases         %u\n\r", stats->erases);
+    if (host.bytesWritten) {
+
+        printf("Write amplification %.2f\n\r",
+               (double) stats->bytesProgrammed / host.bytesWritten);
+    }
+    printf("Erase count         min %u / avg %.2f / max %u over %u blocks\n\r",
+           minCount, numBlocks ? (double) totalCount / numBlocks : 0.0,
+           maxCount, numBlocks);
+    printf("Bit flips           %u (%s ECC)\n\r", stats->bitFlips,
+           model ? "BCH" : "Hamming");
+    printf("ECC                 %u pages corrected, %u uncorrectable\n\r",
+           nandStats.eccCorrected, nandStats.eccFailures);
+    printf("Device failures     %u\n\r", stats->failures);
+    printf("Simulated time      %.3f s\n\r", seconds);
+    if (seconds > 0) {
+
+        printf("Throughput          write %.1f KB/s, read %.1f KB/s (host bytes / device time)\n\r",
+               host.bytesWritten / 1024.0 / seconds, host.bytesRead / 1024.0 / seconds);
+    }
+}
+
+/**
+ * \brief Prints the usage.
+ */
+static void Usage(void)
+{
+    printf("usage: nandbench [options] [trace]\n"
+           "  -i <id>    chip ID, hexadecimal (default 0x1580F12C)\n"
+           "  -m <n>     number of managed blocks (default all, up to %u)\n"
+           "  -n <n>     synthetic workload records (default 4000)\n"
+           "  -b <n>     factory bad blocks\n"
+           "  -f <ppm>   bit flip rate per page read\n"
+           "  -F <n>     up to <n> bits flipped by one read (default 1)\n"
+           "  -x <n>     BCH ECC correcting <n> bits per 512 bytes (4 or 8)\n"
+           "  -p <ppm>   program failure rate\n"
+           "  -e <ppm>   erase failure rate\n"
+           "  -w <n>     erase cycles before a block wears out\n"
+           "  -c <n>     power cut every <n> program/erase operations\n"
+           "  -s <seed>  pseudo-random seed\n"
+           "  -d <n>     dies striped on separate chip enables (1, 2 or 4)\n"
+           "  -r <n>     raw streaming over <n> blocks instead of FatFs\n",
+           NandCommon_MAXNUMBLOCKS);
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief nandbench entry point.
+ */
+int main(int argc, char **argv)
+{
+    struct SimNandFlashConfig config;
+    const char *traceName = 0;
+    unsigned int numRecords = 4000;
+    unsigned char bchStrength = 0;
+    unsigned char numDies = 1;
+    unsigned short rawBlocks = 0;
+    unsigned short deviceBlocks;
+    int i;
+
+    SimNandFlash_GetDefaultConfig(&config);
+    for (i=1; i < argc; i++) {
+
+        if ((argv[i][0] != '-') || !argv[i][1]) {
+
+            traceName = argv[i];
+            continue;
+        }
+        if (argv[i][1] == 'h' || (i + 1 >= argc)) {
+
+            Usage();
+            return (argv[i][1] == 'h') ? 0 : 1;
+        }
+        switch (argv[i++][1]) {
+
+        case 'i': config.chipId = strtoul(argv[i], 0, 16); break;
+        case 'm': numManagedBlocks = atoi(argv[i]); break;
+        case 'n': numRecords = atoi(argv[i]); break;
+        case 'b': config.numBadBlocks = atoi(argv[i]); break;
+        case 'f': config.bitFlipPpm = atoi(argv[i]); break;
+        case 'F': config.maxBitFlips = atoi(argv[i]); break;
+        case 'x': bchStrength = atoi(argv[i]); break;
+        case 'p': config.programFailPpm = atoi(argv[i]); break;
+        case 'e': config.eraseFailPpm = atoi(argv[i]); break;
+        case 'w': config.wearLimit = atoi(argv[i]); break;
+        case 'c': powerCutPeriod = atoi(argv[i]); break;
+        case 's': config.seed = strtoul(argv[i], 0, 0); break;
+        case 'd': numDies = atoi(argv[i]); break;
+        case 'r': rawBlocks = atoi(argv[i]); break;
+        default: Usage(); return 1;
+        }
+    }
+
+    SimNandFlash_Configure(&config);
+
+    /* Whole device by default, within the limits of the translation layer*/
+    if (!numManagedBlocks || bchStrength) {
+
+        struct RawNandFlash raw;
+        static const Pin pinNone;
+
+        if (RawNandFlash_Initialize(&raw, 0, 0, 0, 0, pinNone, pinNone)) {
+
+            return 1;
+        }
+        deviceBlocks = NandFlashModel_GetDeviceSizeInBlocks(&raw.model);
+        if (!numManagedBlocks) {
+
+            numManagedBlocks = (deviceBlocks < NandCommon_MAXNUMBLOCKS)
+                               ? deviceBlocks : NandCommon_MAXNUMBLOCKS;
+        }
+
+        /* Same model with the BCH spare scheme*/
+        if (bchStrength) {
+
+            bchModel = raw.model;
+            bchModel.scheme = GetBchScheme(NandFlashModel_GetPageDataSize(&bchModel),
+                                           bchStrength);
+            if (!bchModel.scheme) {
+
+                printf("-E- No %u-bit BCH scheme for this page size\n\r", bchStrength);
+                return 1;
+            }
+            model = &bchModel;
+        }
+    }
+
+    /* The probed model is the one of a die*/
+    if (numDies > 1) {
+
+        static const Pin pinDies[RawNandFlash_MAXDIES - 1];
+
+        if (RawNandFlash_ConfigureDies(pinDies, numDies)) {
+
+            return 1;
+        }
+    }
+
+    if (rawBlocks) {
+
+        return RunRawStream(rawBlocks);
+    }
+
+    if (Mount(1)) {
+
+        return 1;
+    }
+    SimNandFlash_ResetStats();
+    SimNandFlash_SetPowerCut(powerCutPeriod);
+
+    if (traceName) {
+
+        if (ReplayTrace(traceName)) {
+
+            return 1;
+        }
+    }
+    else {
+
+        RunLogger(numRecords);
+    }
+    Execute('s', "", 0, 0);
+
+    PrintResults();
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Software BCH code over GF(2^13), correcting up to Bch_MAXSTRENGTH bit
+ * errors in each 512-byte sector of a page. It is the alternative to the
+ * 1-bit Hamming code of hamming.c for the NandFlash devices which require a
+ * stronger ECC, selected through the eccStrength field of a NandSpareScheme.
+ *
+ * The code of a sector takes Bch_ECCBYTES(strength) bytes. An erased sector
+ * (all bytes 0xFF) has an erased code (all bytes 0xFF).
+ */
+
+#ifndef BCH_H
+#define BCH_H
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Size of the sectors protected by one code, in bytes.*/
+#define Bch_SECTORSIZE              512
+
+/** Maximum number of bit errors corrected in one sector.*/
+#define Bch_MAXSTRENGTH             8
+
+/** Size of the code of one sector, in bytes, for a given strength.*/
+#define Bch_ECCBYTES(strength)      ((13 * (strength) + 7) / 8)
+
+/**
+ *  These are the possible errors when trying to verify a block of data encoded
+ *  using a BCH code:
+ *
+ *  \section Errors
+ *   - Bch_ERROR_CORRECTED
+ *   - Bch_ERROR_UNCORRECTABLE
+ */
+
+/** Bit errors have been found and corrected.*/
+#define Bch_ERROR_CORRECTED         1
+
+/** More bit errors than the strength of the code, the data is unchanged.*/
+#define Bch_ERROR_UNCORRECTABLE     2
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern void Bch_Compute512x(
+    const unsigned char *data,
+    unsigned int size,
+    unsigned char strength,
+    unsigned char *code);
+
+extern unsigned char Bch_Verify512x(
+    unsigned char *data,
+    unsigned int size,
+    unsigned char strength,
+    const unsigned char *code);
+
+#endif /*#ifndef BCH_H*/
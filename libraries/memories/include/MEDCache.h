@@ -0,0 +1,121 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2008, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+//------------------------------------------------------------------------------
+/// \unit
+///
+/// !Purpose
+///
+/// Write-back sector cache stacked on another Media.
+///
+/// !Usage
+///
+/// -# Initialize the backing media (MEDSdcard, MEDNandFlash ...).
+/// -# Call MEDCache_Initialize() with a MEDCache instance and a buffer of
+///    MEDCACHE_LINES blocks, the cached media then replaces the backing one
+///    (e.g. in the medias[] array shared by FatFs and the USB MSD LUNs).
+/// -# Call MED_Flush() (FatFs does it through CTRL_SYNC) to write the dirty
+///    sectors back.
+//------------------------------------------------------------------------------
+
+#ifndef MEDCACHE_H
+#define MEDCACHE_H
+
+//------------------------------------------------------------------------------
+//         Headers
+//------------------------------------------------------------------------------
+
+#include <include/Media.h>
+
+//------------------------------------------------------------------------------
+//         Definitions
+//------------------------------------------------------------------------------
+
+/// Number of sets of the cache.
+#ifndef MEDCACHE_SETS
+#define MEDCACHE_SETS           8
+#endif
+
+/// Number of ways (lines per set) of the cache.
+#ifndef MEDCACHE_WAYS
+#define MEDCACHE_WAYS           4
+#endif
+
+/// Number of cache lines, each line holds one block of the backing media.
+#define MEDCACHE_LINES          (MEDCACHE_SETS * MEDCACHE_WAYS)
+
+/// Accesses of at least this number of blocks bypass the cache
+/// (sequential streams, e.g. USB MSD transfers).
+#ifndef MEDCACHE_BYPASS_LENGTH
+#define MEDCACHE_BYPASS_LENGTH  8
+#endif
+
+//------------------------------------------------------------------------------
+//         Types
+//------------------------------------------------------------------------------
+
+/// Cache line information.
+typedef struct _MEDCacheLine {
+
+    /// Cached block address.
+    uint32_t block;
+    /// Last access time, for LRU replacement.
+    uint32_t age;
+    /// Block data is valid.
+    uint8_t  valid;
+    /// Block data is modified and not written back yet.
+    uint8_t  dirty;
+    uint16_t reserved;
+} MEDCacheLine;
+
+/// Cache instance.
+typedef struct _MEDCache {
+
+    /// Backing media.
+    Media        *pMedia;
+    /// Line data, MEDCACHE_LINES blocks.
+    uint8_t      *pBuffer;
+    /// Access counter.
+    uint32_t     tick;
+    /// Lines, MEDCACHE_WAYS consecutive lines per set.
+    MEDCacheLine lines[MEDCACHE_LINES];
+} MEDCache;
+
+//------------------------------------------------------------------------------
+//      Exported functions
+//------------------------------------------------------------------------------
+
+extern uint8_t MEDCache_Initialize(Media    *media,
+                                   MEDCache *pCache,
+                                   Media    *pBacking,
+                                   uint8_t  *pBuffer);
+
+extern uint8_t MEDCache_Invalidate(Media *media);
+
+#endif //#ifndef MEDCACHE_H
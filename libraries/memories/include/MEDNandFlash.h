@@ -40,16 +40,39 @@
 //         Definitions
 //------------------------------------------------------------------------------
 
+/// Number of pages in the write-combining buffer. Partially written pages
+/// stay buffered until the buffer is full or the media is flushed, so that
+/// interleaved writes (FAT and data) do not program the same page again and
+/// again. Each buffered page uses a NandCommon_MAXPAGEDATASIZE bytes block of
+/// the page pool.
+#ifndef MEDNANDFLASH_WRITEPAGES
+#define MEDNANDFLASH_WRITEPAGES     4
+#endif
+
+/// Number of pages of the driver own page pool; 0 to only draw the pages from
+/// the pool given to MEDNandFlash_SetBufferPool().
+#ifndef MEDNANDFLASH_POOLPAGES
+#define MEDNANDFLASH_POOLPAGES      MEDNANDFLASH_WRITEPAGES
+#endif
+
+/// Granularity of the dirty masks of the buffered pages, in bytes.
+#define MEDNANDFLASH_SECTORSIZE     512
+
 //------------------------------------------------------------------------------
 //         Forward declarations
 //------------------------------------------------------------------------------
 
 struct TranslatedNandFlash;
+struct _MemPool;
 
 //------------------------------------------------------------------------------
 //         Exported functions
 //------------------------------------------------------------------------------
 
+extern unsigned char MEDNandFlash_SetBufferPool(struct _MemPool *pool);
+
+extern void MEDNandFlash_SetWriteBack(unsigned char enable);
+
 extern void MEDNandFlash_Initialize(
     Media *media,
     struct TranslatedNandFlash *tnf);
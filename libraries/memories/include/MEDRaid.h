@@ -0,0 +1,165 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+//------------------------------------------------------------------------------
+/// \unit
+///
+/// !Purpose
+///
+/// Composite media striping (RAID0) or mirroring (RAID1) blocks over several
+/// other Medias, e.g. an SD card and the NandFlash, or two SD cards on the
+/// HSMCI and the SPI.
+///
+/// !Usage
+///
+/// -# Initialize the member medias (MEDSdcard, MEDNandFlash ...), they must
+///    have the same block size.
+/// -# Call MEDRaid_Initialize() with a MEDRaid instance, the members, the
+///    mode and the stripe unit in blocks. The composite media then replaces
+///    the members (e.g. in the medias[] array shared by FatFs and the USB
+///    MSD LUNs).
+///
+/// A request is cut at the stripe unit boundaries into chunks, which are
+/// given to the members with MED_Read() / MED_Write() and a completion
+/// callback, so that the members work at the same time when they are
+/// asynchronous:
+/// - MEDRAID_STRIPE: stripe s is on member s % numMembers, the size is
+///   numMembers times the one of the smallest member.
+/// - MEDRAID_MIRROR: all the members are written. Each member reads the next
+///   chunk not read yet when it is done with the previous one, so the faster
+///   member reads more. A member failing an access is not used any more
+///   (MEDRaid_GetFailed()), a chunk it could not read is read from another
+///   one; the media fails once no member is left. Copying the data back to a
+///   replaced member before MEDRaid_Restore() is up to the application.
+///
+/// With a callback, MED_Read() / MED_Write() return once the chunks are
+/// started and the callback is invoked when all the members are done,
+/// MED_Handler() having to be called meanwhile (it calls the handlers of the
+/// members). Without a callback, they return once the request is over.
+//------------------------------------------------------------------------------
+
+#ifndef MEDRAID_H
+#define MEDRAID_H
+
+//------------------------------------------------------------------------------
+//         Headers
+//------------------------------------------------------------------------------
+
+#include <include/Media.h>
+
+//------------------------------------------------------------------------------
+//         Definitions
+//------------------------------------------------------------------------------
+
+/// Maximum number of members of a composite media.
+#ifndef MEDRAID_MAX_MEMBERS
+#define MEDRAID_MAX_MEMBERS     4
+#endif
+
+/// Blocks striped over the members.
+#define MEDRAID_STRIPE          0
+/// Blocks mirrored on all the members.
+#define MEDRAID_MIRROR          1
+
+//------------------------------------------------------------------------------
+//         Types
+//------------------------------------------------------------------------------
+
+struct _MEDRaid;
+
+/// Member media and its chunk in progress.
+typedef struct _MEDRaidMember {
+
+    /// Member media.
+    Media           *pMedia;
+    /// Composite media instance.
+    struct _MEDRaid *pRaid;
+    /// Next chunk of the member (stripe and mirror write).
+    uint32_t        next;
+    /// Chunk held by the member.
+    uint32_t        chunk;
+    /// The chunk is to be started (by another member if this one failed).
+    uint8_t         pending;
+    /// The chunk is in progress.
+    uint8_t         busy;
+    /// Set by the completion callback, and the chunk status.
+    volatile uint8_t completed;
+    volatile uint8_t status;
+    /// The member failed, it is not used any more (mirror).
+    uint8_t         failed;
+    uint8_t         reserved[3];
+} MEDRaidMember;
+
+/// Composite media instance.
+typedef struct _MEDRaid {
+
+    /// Members.
+    MEDRaidMember members[MEDRAID_MAX_MEMBERS];
+    /// Composite media.
+    Media         *media;
+    /// Stripe unit, in blocks.
+    uint32_t      unit;
+    /// Number of members.
+    uint8_t       numMembers;
+    /// MEDRAID_STRIPE or MEDRAID_MIRROR.
+    uint8_t       mode;
+    /// Request in progress is a write.
+    uint8_t       isWrite;
+    /// Request in progress failed.
+    uint8_t       error;
+    /// First stripe, number of chunks and next shared chunk (mirror read)
+    /// of the request in progress.
+    uint32_t      firstStripe;
+    uint32_t      numChunks;
+    uint32_t      nextChunk;
+    /// Set while the members are serviced, and when they have to be
+    /// serviced again.
+    volatile uint8_t pumping;
+    volatile uint8_t repump;
+    /// Status of the last request.
+    uint8_t       status;
+    uint8_t       reserved;
+} MEDRaid;
+
+//------------------------------------------------------------------------------
+//      Exported functions
+//------------------------------------------------------------------------------
+
+extern uint8_t MEDRaid_Initialize(Media    *media,
+                                  MEDRaid  *pRaid,
+                                  Media    **pMembers,
+                                  uint8_t  numMembers,
+                                  uint8_t  mode,
+                                  uint32_t unit);
+
+extern uint8_t MEDRaid_GetFailed(Media *media);
+
+extern void MEDRaid_Restore(Media *media, uint8_t member);
+
+#endif //#ifndef MEDRAID_H
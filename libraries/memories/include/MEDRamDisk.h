@@ -27,6 +27,29 @@
  * ----------------------------------------------------------------------------
  */
 
+//------------------------------------------------------------------------------
+/// \unit
+///
+/// !Purpose
+///
+/// RAM disk media, over the internal SRAM or the external PSRAM on the SMC.
+///
+/// !Usage
+///
+/// -# MEDRamDisk_Initialize() maps the disk onto a memory area, whose
+///    address and size are given in blocks. The media is mapped both ways,
+///    so that the USB mass storage moves the data straight between the
+///    endpoint FIFO and the disk memory, without going through the LUN
+///    buffer. On the SAM3S-EK, a PSRAM disk takes its area from
+///    BOARD_PsramAlloc() after BOARD_ConfigurePSRAM().
+/// -# MEDRamDisk_InitializeCompressed() keeps the blocks LZ4-compressed in a
+///    pool, for scratch volumes larger than the memory: the disk size is
+///    free, the pool only holds what has been written. All-zero blocks take
+///    no space and MED_IOCTL_DISCARD gives back the space of a range. Once
+///    the pool is full, the writes fail. The media is not mapped, each
+///    block being decompressed by MED_Read().
+//------------------------------------------------------------------------------
+
 #ifndef MEDRAMDISK_H
 #define MEDRAMDISK_H
 
@@ -36,6 +59,51 @@
 
 #include <include/Media.h>
 
+//------------------------------------------------------------------------------
+//      Definitions
+//------------------------------------------------------------------------------
+
+/// Size of the pool granules of a compressed RAM disk, in bytes
+#ifndef MEDRAMDISK_GRANULE_SIZE
+#define MEDRAMDISK_GRANULE_SIZE     64
+#endif
+
+/// Entries of the compressor hash table (log2)
+#ifndef MEDRAMDISK_LZ_HASH_BITS
+#define MEDRAMDISK_LZ_HASH_BITS     9
+#endif
+
+/// No granule
+#define MEDRAMDISK_NO_GRANULE       0xFFFF
+
+//------------------------------------------------------------------------------
+//      Types
+//------------------------------------------------------------------------------
+
+/// State of a compressed RAM disk. The tables are carved out of the pool:
+/// the blocks are stored as chains of granules.
+typedef struct {
+
+    /// First granule of each disk block
+    unsigned short *blocks;
+    /// Stored length of each block: 0 for a zero block, blockSize when stored
+    /// uncompressed
+    unsigned short *lengths;
+    /// Next granule of each granule, in a block chain or in the free list
+    unsigned short *next;
+    /// One block work buffer
+    unsigned char  *scratch;
+    /// Granule data
+    unsigned char  *granules;
+    /// Number of granules
+    unsigned int   numGranules;
+    /// Number of free granules
+    unsigned int   freeGranules;
+    /// First free granule
+    unsigned short freeList;
+
+} MEDRamDiskLz;
+
 //------------------------------------------------------------------------------
 //      Exported functions
 //------------------------------------------------------------------------------
@@ -45,4 +113,13 @@ extern unsigned char MEDRamDisk_Initialize(Media *media,
                                            unsigned int baseAddress,
                                            unsigned int size);
 
+extern unsigned char MEDRamDisk_InitializeCompressed(Media *media,
+                                                     MEDRamDiskLz *lz,
+                                                     unsigned int blockSize,
+                                                     void *pool,
+                                                     unsigned int poolSize,
+                                                     unsigned int size);
+
+extern unsigned int MEDRamDisk_GetPoolFree(const MEDRamDiskLz *lz);
+
 #endif //#ifndef MEDRAMDISK_H
@@ -45,8 +45,22 @@
 #define NandBlockStatus_FREE            0xE
 #define NandBlockStatus_LIVE            0xC
 #define NandBlockStatus_DIRTY           0x8
+#define NandBlockStatus_CHECKPOINT      0xA
 #define NandBlockStatus_BAD             0x0
 
+/** Number of blocks at the start of the managed area in which the checkpoint
+    blocks are searched at mount */
+#define NandCheckpoint_AREA             4
+/** Number of checkpoint blocks, used in turn */
+#define NandCheckpoint_NUMBLOCKS        2
+
+/** No clean checkpoint describes the device*/
+#define NandCheckpoint_NONE             0
+/** The last checkpoint record describes the device*/
+#define NandCheckpoint_CLEAN            1
+/** The device has been modified since the last checkpoint record*/
+#define NandCheckpoint_OPEN             2
+
 /** Erase dirty blocks only*/
 #define NandEraseDIRTY                  0
 /** Erase all data, calculate count*/
@@ -63,12 +77,54 @@ struct NandBlockStatus {
              eraseCount:28;
 };
 
+/** Checkpoint of the block statuses (and of upper layer data), so that a
+    cleanly unmounted device is mounted without scanning all its blocks */
+struct NandCheckpoint {
+
+    /** Checkpoint blocks, -1 if not available */
+    int16_t blocks[NandCheckpoint_NUMBLOCKS];
+    /** Index of the block being written in blocks[] */
+    uint8_t current;
+    /** NandCheckpoint_xxx */
+    uint8_t state;
+    /** Next page to program in the current block */
+    uint16_t page;
+    /** Sequence number of the last record */
+    uint32_t sequence;
+    /** Clean record loaded at mount (block index, page, upper layer data) */
+    int16_t loadBlock;
+    uint16_t loadPage;
+    uint32_t loadTag;
+    uint32_t loadExtraSize;
+};
+
+/** Index of the block statuses: number of blocks of each status, and
+    min-heaps (by erase count) of the FREE blocks, stored from the start of
+    heap[], and of the LIVE blocks, stored from its end */
+struct NandBlockIndex {
+
+    /** Number of blocks of each status */
+    uint16_t counts[16];
+    /** Number of FREE and LIVE blocks in the heaps */
+    uint16_t heapSizes[2];
+    /** Heap entries (block numbers) */
+    uint16_t heap[NandCommon_MAXNUMBLOCKS];
+    /** Position of each FREE or LIVE block in its heap */
+    uint16_t positions[NandCommon_MAXNUMBLOCKS];
+    /** Bitmap of the DIRTY blocks, updated through the bit-banding */
+    uint32_t dirtyBlocks[BITMAP_WORDS(NandCommon_MAXNUMBLOCKS)];
+};
+
 struct ManagedNandFlash {
 
     struct EccNandFlash ecc;
     struct NandBlockStatus blockStatuses[NandCommon_MAXNUMBLOCKS];
     uint16_t baseBlock;
     uint16_t sizeInBlocks;
+    struct NandCheckpoint checkpoint;
+    struct NandBlockIndex index;
+    /** Block erased in the background, -1 if none */
+    int32_t erasingBlock;
 };
 
 /*----------------------------------------------------------------------------
@@ -98,6 +154,10 @@ extern uint8_t ManagedNandFlash_EraseBlock(
     struct ManagedNandFlash *managed,
     uint16_t block);
 
+extern uint8_t ManagedNandFlash_RestoreBlock(
+    struct ManagedNandFlash *managed,
+    uint16_t block);
+
 extern uint8_t ManagedNandFlash_ReadPage(
     const struct ManagedNandFlash *managed,
     uint16_t block,
@@ -127,6 +187,13 @@ extern uint8_t ManagedNandFlash_CopyBlock(
 extern uint8_t ManagedNandFlash_EraseDirtyBlocks(
     struct ManagedNandFlash *managed);
 
+extern uint8_t ManagedNandFlash_EraseDirtyBlocksStep(
+    struct ManagedNandFlash *managed,
+    uint16_t maxBlocks);
+
+extern uint8_t ManagedNandFlash_StartEraseDirtyBlock(
+    struct ManagedNandFlash *managed);
+
 extern uint8_t ManagedNandFlash_FindYoungestBlock(
     const struct ManagedNandFlash *managed,
     uint8_t status,
@@ -136,6 +203,21 @@ extern uint16_t ManagedNandFlash_CountBlocks(
     const struct ManagedNandFlash *managed,
     uint8_t status);
 
+extern uint8_t ManagedNandFlash_SaveCheckpoint(
+    struct ManagedNandFlash *managed,
+    uint32_t tag,
+    const void *extra,
+    uint32_t extraSize);
+
+extern uint8_t ManagedNandFlash_LoadCheckpoint(
+    const struct ManagedNandFlash *managed,
+    uint32_t *tag,
+    void *extra,
+    uint32_t extraSize);
+
+extern uint8_t ManagedNandFlash_InvalidateCheckpoint(
+    struct ManagedNandFlash *managed);
+
 extern uint16_t ManagedNandFlash_GetDeviceSizeInBlocks(
     const struct ManagedNandFlash *managed);
 
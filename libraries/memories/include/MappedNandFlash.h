@@ -36,10 +36,40 @@
 
 #include "ManagedNandFlash.h"
 
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of logical blocks whose mapping can change between two journal
+    records. Beyond, the whole mapping is saved in a new block. */
+#ifndef MAPPEDNANDFLASH_JOURNALDELTAS
+#define MAPPEDNANDFLASH_JOURNALDELTAS       32
+#endif
+
 /*----------------------------------------------------------------------------
  *        Type
  *----------------------------------------------------------------------------*/
 
+/** Mapping journal: the pages of the logical mapping block following the
+    mapping hold records of the mapping changes (and of upper layer data),
+    replayed on top of the mapping at mount */
+struct MappedNandFlashJournal {
+
+    /** Next page to program in the logical mapping block */
+    unsigned short page;
+    /** Sequence number of the last record */
+    unsigned short sequence;
+    /** Upper layer data of the last record holding some (page, offset in
+        the record, size), size is 0 if none */
+    unsigned short extraPage;
+    unsigned short extraOffset;
+    unsigned int extraSize;
+    /** Logical blocks remapped since the last record, or
+        MAPPEDNANDFLASH_JOURNALDELTAS + 1 if they do not fit in a record */
+    unsigned short numDeltas;
+    unsigned short deltas[MAPPEDNANDFLASH_JOURNALDELTAS];
+};
+
 struct MappedNandFlash {
 
     struct ManagedNandFlash managed;
@@ -47,6 +77,7 @@ struct MappedNandFlash {
     signed short logicalMappingBlock;
     unsigned char mappingModified;
     unsigned char reserved;
+    struct MappedNandFlashJournal journal;
 };
 
 /*----------------------------------------------------------------------------
@@ -83,6 +114,11 @@ extern unsigned char MappedNandFlash_Map(
     unsigned short logicalBlock,
     unsigned short physicalBlock);
 
+extern unsigned char MappedNandFlash_Remap(
+    struct MappedNandFlash *mapped,
+    unsigned short logicalBlock,
+    unsigned short physicalBlock);
+
 extern unsigned char MappedNandFlash_Unmap(
     struct MappedNandFlash *mapped,
     unsigned short logicalBlock);
@@ -95,9 +131,29 @@ extern signed short MappedNandFlash_PhysicalToLogical(
     const struct MappedNandFlash *mapped,
     unsigned short physicalBlock);
 
+extern unsigned char MappedNandFlash_ReleaseUnmappedBlocks(
+    struct MappedNandFlash *mapped,
+    const signed short *keptBlocks,
+    unsigned char numKept);
+
 extern unsigned char MappedNandFlash_SaveLogicalMapping(
     struct MappedNandFlash *mapped,
-    unsigned short physicalBlock);
+    unsigned short physicalBlock,
+    const void *extra,
+    unsigned int extraSize);
+
+extern unsigned char MappedNandFlash_AppendJournal(
+    struct MappedNandFlash *mapped,
+    const void *extra,
+    unsigned int extraSize);
+
+extern unsigned char MappedNandFlash_ReadJournalExtra(
+    const struct MappedNandFlash *mapped,
+    void *extra,
+    unsigned int extraSize);
+
+extern unsigned char MappedNandFlash_SaveCheckpoint(
+    struct MappedNandFlash *mapped);
 
 extern unsigned char MappedNandFlash_EraseAll(
     struct MappedNandFlash *mapped,
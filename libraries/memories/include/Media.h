@@ -43,6 +43,36 @@
  *  -# Initialize peripheral interface driver & device driver.
  *  -# Initialize specific media interface and link to this initialized driver.
  *
+ *  A media directly addressable by the core (internal flash, SRAM or PSRAM on
+ *  the SMC) sets mappedRD, and MED_Map() then gives the memory address of a
+ *  range instead of copying it with MED_Read(): a file system, the USB mass
+ *  storage or jpeg_mem_src() can read the data in place.
+ *
+ *  The handler of a media starts the requests its interrupt could not start,
+ *  and does its background work. MED_HandleAll() calls the handlers from the
+ *  main loop; after MED_SetDeferredHandler(1), a media interrupt needing its
+ *  handler calls MED_Notify(), which posts the handler to the work queue
+ *  (workq.h), so that the completions no longer wait for the main loop.
+ *  MED_HandleAll() is then only needed for the background work (NandFlash
+ *  flush and garbage collection).
+ *
+ *  MED_StatsAttach() gives a media a MEDStats block, in which MED_Read(),
+ *  MED_Write() and MED_Flush() count the operations, the bytes, the
+ *  requests in flight, the busy time and the latencies (histograms with
+ *  power-of-two buckets in microseconds), timed with the DWT cycle counter.
+ *  The asynchronous requests are timed until their callback. The statistics
+ *  are read with MED_IOCTL_STATS and the counters of the nandflash layers with
+ *  MED_IOCTL_NANDSTATS; the media_bench example prints both. A media without
+ *  statistics costs one list lookup per request.
+ *
+ *  A media moving the data with a DMA (PDC) transfers straight from or to
+ *  the buffer given to MED_Read() and MED_Write() when the buffer has the
+ *  alignment it reports with MED_IOCTL_ALIGN (see MED_GetAlignment()); a
+ *  misaligned buffer costs a bounce copy or a slower byte-wide transfer.
+ *  Buffers declared MED_ALIGNED or taken from MED_AllocBuffer() suit every
+ *  media, so that large FatFs reads go from the medium to the user buffer
+ *  without intermediate copy.
+ *
  */
 
 #ifndef _MEDIA_
@@ -69,6 +99,36 @@
 #define MED_STATE_READY         0x00     /* Media is ready for access */
 #define MED_STATE_BUSY          0x01     /* Media is busy */
 
+/**
+ *  \brief Media ioctl codes (see MED_Ioctl())
+ */
+#define MED_IOCTL_SYNC          0x01     /* Write the cached data to the medium, buff unused */
+#define MED_IOCTL_DISCARD       0x02     /* Data of a range no longer used, buff is a MEDDiscard */
+#define MED_IOCTL_MAP           0x03     /* Memory address of a mapped range, buff is a MEDMap */
+#define MED_IOCTL_STATS         0x04     /* Copy of the statistics, buff is a MEDStats */
+#define MED_IOCTL_NANDSTATS     0x05     /* Counters of the nandflash layers, buff is a struct NandStats */
+#define MED_IOCTL_ALIGN         0x06     /* Buffer alignment of the direct transfers, buff is a uint32_t */
+
+/**
+ *  \brief Largest alignment reported by MED_IOCTL_ALIGN, and attribute giving
+ *  it to a buffer
+ */
+#define MED_ALIGN_MAX           4
+
+#if defined ( __ICCARM__ )
+#define MED_ALIGNED             _Pragma("data_alignment=4")
+#else
+#define MED_ALIGNED             __attribute__ ((aligned (MED_ALIGN_MAX)))
+#endif
+
+/**
+ *  \brief Statistics: number of latency buckets, bucket n counting the
+ *  latencies of 2^n to 2^(n+1)-1 microseconds (the last one is open), and
+ *  number of requests in flight timed at once
+ */
+#define MED_STATS_BUCKETS       16
+#define MED_STATS_PENDING       4
+
 /*------------------------------------------------------------------------------
 //      Types
  *------------------------------------------------------------------------------*/
@@ -105,6 +165,72 @@ typedef struct
     void* argument ;           /* < Callback argument */
 } MEDTransfer ;
 
+/**
+ *  \brief  Range given to MED_IOCTL_DISCARD, in media blocks
+ */
+typedef struct
+{
+    uint32_t address ;         /* < First block of the range */
+    uint32_t length ;          /* < Number of blocks */
+} MEDDiscard ;
+
+/**
+ *  \brief  Range given to MED_IOCTL_MAP, in media blocks, and its address
+ */
+typedef struct
+{
+    uint32_t address ;         /* < First block of the range */
+    uint32_t length ;          /* < Number of blocks */
+    void* data ;               /* < Memory address of the first block, set by the media */
+} MEDMap ;
+
+/**
+ *  \brief  Statistics of one kind of operation
+ */
+typedef struct
+{
+    uint32_t count ;           /* < Operations started */
+    uint32_t errors ;          /* < Operations refused or failed */
+    uint64_t bytes ;           /* < Bytes requested */
+    uint32_t timed ;           /* < Operations in the latency figures */
+    uint32_t maxLatency ;      /* < Longest latency, in microseconds */
+    uint64_t totalLatency ;    /* < Sum of the latencies, in microseconds */
+    uint32_t histogram[MED_STATS_BUCKETS] ; /* < Latencies by power of two */
+} MEDOpStats ;
+
+/**
+ *  \brief  Request in flight, timed until its completion
+ */
+typedef struct
+{
+    struct _MEDStats* pStats ; /* < Owner, 0 when free */
+    MEDOpStats* pOp ;          /* < Kind of operation */
+    MediaCallback callback ;   /* < Callback of the caller */
+    void* argument ;           /* < Argument of the caller */
+    uint32_t start ;           /* < Cycle counter at the start */
+} MEDStatsRequest ;
+
+/**
+ *  \brief  Statistics of a media, see MED_StatsAttach()
+ */
+typedef struct _MEDStats
+{
+    MEDOpStats read ;          /* < MED_Read() */
+    MEDOpStats write ;         /* < MED_Write() */
+    MEDOpStats flush ;         /* < MED_Flush() */
+    uint32_t depth ;           /* < Requests in flight */
+    uint32_t maxDepth ;        /* < Most requests in flight */
+    uint32_t tracked ;         /* < Requests timed, done or in flight */
+    uint64_t depthSum ;        /* < Requests in flight seen by each tracked request, itself included */
+    uint64_t busyCycles ;      /* < Time with requests in flight */
+    uint64_t elapsedCycles ;   /* < Time since the reset, up to the last event */
+    uint32_t lastTime ;        /* < Cycle counter at the last event */
+    uint32_t cyclesPerUs ;     /* < Cycle counter frequency in MHz */
+    MEDStatsRequest requests[MED_STATS_PENDING] ;
+    Media* pMedia ;            /* < Media of the statistics */
+    struct _MEDStats* pNext ;  /* < Next attached statistics */
+} MEDStats ;
+
 /**
  *  \brief  Media object
  *  \see    MEDTransfer
@@ -117,6 +243,7 @@ struct _Media
   Media_lock     lock;         /* < lock method if possible */
   Media_unlock   unlock;       /* < unlock method if possible */
   Media_flush    flush;        /* < Flush method */
+  Media_ioctl    ioctl;        /* < Control method (MED_IOCTL_xxx) if possible */
   Media_handler  handler;      /* < Interrupt handler */
 
   uint32_t   blockSize;    /* < Block size in bytes (1, 512, 1K, 2K ...) */
@@ -131,7 +258,8 @@ struct _Media
     removable:1;  /* < Removable/Fixed media? */
 
   uint8_t  state;        /* < Status of media */
-  uint16_t reserved ;
+  volatile uint8_t notified; /* < Handler posted to the work queue */
+  uint8_t  reserved ;
 } ;
 
 /*  Available medias. */
@@ -151,11 +279,27 @@ extern uint32_t MED_Read( Media* pMedia, uint32_t address, void* data, uint32_t
 extern uint32_t MED_Lock( Media* pMedia, uint32_t start, uint32_t end, uint32_t *pActualStart, uint32_t *pActualEnd ) ;
 extern uint32_t MED_Unlock( Media* pMedia, uint32_t start, uint32_t end, uint32_t *pActualStart, uint32_t *pActualEnd ) ;
 extern uint32_t MED_Flush( Media* pMedia ) ;
+extern uint32_t MED_Ioctl( Media* pMedia, uint8_t ctrl, void* buff ) ;
+extern uint32_t MED_Map( Media* pMedia, uint32_t address, uint32_t length, void** pData ) ;
+extern uint32_t MED_GetAlignment( Media* pMedia ) ;
+extern uint32_t MED_IsAligned( Media* pMedia, const void* pBuffer ) ;
+extern void* MED_AllocBuffer( uint32_t dwSize, uint32_t dwFlags ) ;
+extern void MED_FreeBuffer( void* pBuffer ) ;
 extern void MED_Handler( Media* pMedia ) ;
 extern void MED_DeInit( Media* pMedia ) ;
 extern uint32_t MED_IsInitialized( Media* pMedia ) ;
 
 extern void MED_HandleAll( Media *medias, uint8_t numMedias ) ;
 
+extern void MED_SetDeferredHandler( uint8_t bDefer ) ;
+
+extern void MED_Notify( Media* pMedia ) ;
+
+extern void MED_StatsAttach( Media* pMedia, MEDStats* pStats, uint32_t dwMck ) ;
+
+extern void MED_StatsDetach( Media* pMedia ) ;
+
+extern void MED_StatsReset( Media* pMedia ) ;
+
 #endif /* _MEDIA_ */
 
@@ -63,7 +63,7 @@
 #define NandCommon_MAXPAGESPARESIZE         128 //64
 
 /** Maximum number of ecc bytes stored in the spare for one single page.*/
-#define NandCommon_MAXSPAREECCBYTES         48 //24
+#define NandCommon_MAXSPAREECCBYTES         104 //48
 
 /** Maximum number of extra free bytes inside the spare area of a page.*/
 #define NandCommon_MAXSPAREEXTRABYTES       78 //38
@@ -126,5 +126,42 @@
 /** HW Ecc Not compatible with the Nand Model*/
 #define NandCommon_ERROR_ECC_NOT_COMPATIBLE 15
 
+/** The device has not been mounted from a clean checkpoint*/
+#define NandCommon_ERROR_NOCHECKPOINT       16
+
+/** The mapping journal has no room left for the record*/
+#define NandCommon_ERROR_JOURNALFULL        17
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Counters of the nandflash layers since the reset, read with the
+ * MED_IOCTL_NANDSTATS control code of a MEDNandFlash media.*/
+struct NandStats {
+
+    /** Pages read by EccNandFlash_ReadPage*/
+    unsigned int pageReads;
+    /** Pages written by EccNandFlash_WritePage*/
+    unsigned int pageWrites;
+    /** Pages read with bit errors corrected by the ECC*/
+    unsigned int eccCorrected;
+    /** Pages read with bit errors the ECC could not correct*/
+    unsigned int eccFailures;
+    /** Blocks erased by the ManagedNandFlash layer*/
+    unsigned int blockErases;
+    /** Pages copied by ManagedNandFlash_CopyPage*/
+    unsigned int pageCopies;
+    /** Blocks copied by ManagedNandFlash_CopyBlock*/
+    unsigned int blockCopies;
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported variables
+ *----------------------------------------------------------------------------*/
+
+/** Counters of the nandflash layers, defined in EccNandFlash.c*/
+extern struct NandStats nandStats;
+
 #endif /*#ifndef NANDCOMMON_H */
 
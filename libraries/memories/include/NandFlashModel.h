@@ -46,6 +46,22 @@
  *      - NandFlashModel_GetDataBusWidth
  *      - NandFlashModel_UsesSmallBlocksRead
  *      - NandFlashModel_UsesSmallBlocksWrite
+ *      - NandFlashModel_SupportsCacheProgram
+ *      - NandFlashModel_SupportsCacheRead
+ *      - NandFlashModel_SupportsTwoPlanes
+ *
+ * -# Translate addresses with the geometry shifts cached in the model by
+ *    NandFlashModel_Find or NandFlashModel_UpdateShifts, instead of dividing:
+ *      - NandFlashModel_GetPageShift
+ *      - NandFlashModel_GetBlockShift
+ *    The page and block sizes being powers of two, page = address >> pageShift
+ *    and offset = address & (pageSize - 1). The getters of the page and block
+ *    sizes are inline and read the cached values.
+ *
+ * A board with one known NandFlash part can fix the geometry at compile time by
+ * defining NandFlashModel_PAGESHIFT and NandFlashModel_BLOCKSHIFT (e.g. 11 and 6
+ * for 2 KB pages in 128 KB blocks): the getters then fold to constants, and a
+ * detected part of another geometry is rejected.
  */
 
 #ifndef NANDFLASHMODEL_H
@@ -65,6 +81,9 @@ struct NandSpareScheme;
   * - NandFlashModel_DATABUS8
   * - NandFlashModel_DATABUS16
   * - NandFlashModel_COPYBACK
+  * - NandFlashModel_CACHEPROGRAM
+  * - NandFlashModel_CACHEREAD
+  * - NandFlashModel_TWOPLANES
 */
 
 /** Indicates the Nand uses an 8-bit databus. */
@@ -76,6 +95,23 @@ struct NandSpareScheme;
 /** The Nand supports the copy-back function (internal page-to-page copy).*/
 #define NandFlashModel_COPYBACK     (1 << 1)
 
+/** The Nand supports the cache program command (0x15).*/
+#define NandFlashModel_CACHEPROGRAM (1 << 2)
+
+/** The Nand supports the sequential cache read commands (0x31/0x3F).*/
+#define NandFlashModel_CACHEREAD    (1 << 3)
+
+/** The Nand has two planes (selected by the block number LSB) which can be
+    programmed at the same time.*/
+#define NandFlashModel_TWOPLANES    (1 << 4)
+
+/* Fixed geometry: both NandFlashModel_PAGESHIFT (log2 of the page data size)
+   and NandFlashModel_BLOCKSHIFT (log2 of the number of pages in a block) are
+   defined by the board, or none. */
+#if defined(NandFlashModel_PAGESHIFT) != defined(NandFlashModel_BLOCKSHIFT)
+#error "NandFlashModel_PAGESHIFT and NandFlashModel_BLOCKSHIFT go together"
+#endif
+
 
 /*----------------------------------------------------------------------------
  *        Types
@@ -96,6 +132,10 @@ struct NandFlashModel {
     unsigned short blockSizeInKBytes;
     /** Spare area placement scheme*/
     const struct NandSpareScheme *scheme;
+    /** log2 of pageSizeInBytes (NandFlashModel_UpdateShifts).*/
+    unsigned char pageShift;
+    /** log2 of the number of pages in a block (NandFlashModel_UpdateShifts).*/
+    unsigned char blockShift;
 };
 
 /*----------------------------------------------------------------------------
@@ -107,6 +147,9 @@ extern unsigned char NandFlashModel_Find(
     unsigned int id,
     struct NandFlashModel *model);
 
+extern unsigned char NandFlashModel_UpdateShifts(
+    struct NandFlashModel *model);
+
 extern unsigned char NandFlashModel_TranslateAccess(
     const struct NandFlashModel *model,
     unsigned int address,
@@ -133,26 +176,94 @@ extern unsigned long long NandFlashModel_GetDeviceSizeInBytes(
 extern unsigned int NandFlashModel_GetDeviceSizeInMBytes(
     const struct NandFlashModel *model);
 
-extern unsigned short NandFlashModel_GetBlockSizeInPages(
+extern unsigned char NandFlashModel_GetPageSpareSize(
     const struct NandFlashModel *model);
 
-extern unsigned int NandFlashModel_GetBlockSizeInBytes(
+extern unsigned char NandFlashModel_GetDataBusWidth(
     const struct NandFlashModel *model);
 
-extern unsigned short NandFlashModel_GetPageDataSize(
+extern unsigned char NandFlashModel_HasSmallBlocks(
     const struct NandFlashModel *model);
 
-extern unsigned char NandFlashModel_GetPageSpareSize(
+extern unsigned char NandFlashModel_SupportsCopyBack(
     const struct NandFlashModel *model);
 
-extern unsigned char NandFlashModel_GetDataBusWidth(
+extern unsigned char NandFlashModel_SupportsCacheProgram(
     const struct NandFlashModel *model);
 
-extern unsigned char NandFlashModel_HasSmallBlocks(
+extern unsigned char NandFlashModel_SupportsCacheRead(
     const struct NandFlashModel *model);
 
-extern unsigned char NandFlashModel_SupportsCopyBack(
+extern unsigned char NandFlashModel_SupportsTwoPlanes(
     const struct NandFlashModel *model);
 
+/*----------------------------------------------------------------------------
+ *        Inline functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Returns log2 of the size of the data area of a page.
+ *
+ * \param model  Pointer to a NandFlashModel instance.
+ */
+static inline unsigned char NandFlashModel_GetPageShift(
+    const struct NandFlashModel *model)
+{
+#if defined(NandFlashModel_PAGESHIFT)
+    return NandFlashModel_PAGESHIFT;
+#else
+    return model->pageShift;
+#endif
+}
+
+/**
+ * \brief Returns log2 of the number of pages in one single block.
+ *
+ * \param model  Pointer to a NandFlashModel instance.
+ */
+static inline unsigned char NandFlashModel_GetBlockShift(
+    const struct NandFlashModel *model)
+{
+#if defined(NandFlashModel_BLOCKSHIFT)
+    return NandFlashModel_BLOCKSHIFT;
+#else
+    return model->blockShift;
+#endif
+}
+
+/**
+ * \brief Returns the number of pages in one single block of a device.
+ *
+ * \param model  Pointer to a NandFlashModel instance.
+ */
+static inline unsigned short NandFlashModel_GetBlockSizeInPages(
+    const struct NandFlashModel *model)
+{
+    return 1 << NandFlashModel_GetBlockShift(model);
+}
+
+/**
+ * \brief Returns the size in bytes of one single block of a device. This does not
+ * take into account the spare zones size.
+ *
+ * \param model  Pointer to a NandFlashModel instance.
+ */
+static inline unsigned int NandFlashModel_GetBlockSizeInBytes(
+    const struct NandFlashModel *model)
+{
+    return 1 << (NandFlashModel_GetPageShift(model) + NandFlashModel_GetBlockShift(model));
+}
+
+/**
+ * \brief  Returns the size of the data area of a page in bytes.
+ *
+ * \param model  Pointer to a NandFlashModel instance.
+ */
+static inline unsigned short NandFlashModel_GetPageDataSize(
+    const struct NandFlashModel *model)
+{
+    return 1 << NandFlashModel_GetPageShift(model);
+}
+
 #endif /*#ifndef NANDFLASHMODEL_H*/
 
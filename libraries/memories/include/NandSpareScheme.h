@@ -48,6 +48,9 @@ struct NandSpareScheme {
     unsigned char eccBytesPositions[NandCommon_MAXSPAREECCBYTES];
     unsigned char numExtraBytes;
     unsigned char extraBytesPositions[NandCommon_MAXSPAREEXTRABYTES];
+    /** 0 for a 1-bit Hamming code per 256 bytes (hamming.c), otherwise the
+        number of bit errors corrected per 512 bytes by a BCH code (Bch.c).*/
+    unsigned char eccStrength;
 };
 
 /*----------------------------------------------------------------------------
@@ -57,6 +60,11 @@ extern const struct NandSpareScheme nandSpareScheme256;
 extern const struct NandSpareScheme nandSpareScheme512;
 extern const struct NandSpareScheme nandSpareScheme2048;
 extern const struct NandSpareScheme nandSpareScheme4096;
+extern const struct NandSpareScheme nandSpareScheme512Bch4;
+extern const struct NandSpareScheme nandSpareScheme2048Bch4;
+extern const struct NandSpareScheme nandSpareScheme2048Bch8;
+extern const struct NandSpareScheme nandSpareScheme4096Bch4;
+extern const struct NandSpareScheme nandSpareScheme4096Bch8;
 
 /*----------------------------------------------------------------------------
  *        Exported function
@@ -96,5 +104,11 @@ extern void NandSpareScheme_WriteExtra(
     unsigned char size,
     unsigned char offset);
 
+extern void NandSpareScheme_GetInfoRange(
+    const struct NandSpareScheme *scheme,
+    unsigned char extraSize,
+    unsigned char *start,
+    unsigned char *size);
+
 #endif /*#ifndef NANDSPARESCHEME_H*/
 
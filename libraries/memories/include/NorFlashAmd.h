@@ -48,7 +48,10 @@
  *      Word at a time using static function amd_Program(). Programming
  *      larger amounts of data must be done in one Word at a time by
  *      giving a Program command, waiting for the command to complete,
- *      giving the next Program command and so on.
+ *      giving the next Program command and so on. When the CFI
+ *      reports a write buffer, up to NORFLASH_MAXBUFFERWORDS words are
+ *      programmed by each command sequence instead, using static function
+ *      amd_ProgramBuffer().
  * -# erase a block within the flash using AMD_EraseSector().
  *    - Flash erase is performed on a block basis. An entire block is
  *      erased each time an erase command sequence is given.
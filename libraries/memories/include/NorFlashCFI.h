@@ -64,6 +64,9 @@
 /** Indicates the NorFlash uses an 64-bit address bus. */
 #define FLASH_CHIP_WIDTH_64BITS 0x08
 
+/** Maximum number of words programmed by one write-buffer command sequence. */
+#define NORFLASH_MAXBUFFERWORDS 32
+
 /*----------------------------------------------------------------------------
  *        Types
  *----------------------------------------------------------------------------*/
@@ -159,6 +162,10 @@ typedef struct _NorFlashInfo
     uint8_t deviceChipWidth;
     /** Indicate the decive CFI is compatible */
     uint8_t cfiCompatible;
+    /** Asynchronous page read size in bytes, 0 if page mode is not supported. */
+    uint8_t pageReadSize;
+    /** Write buffer size in bytes, 0 if buffered programming is not used. */
+    uint16_t writeBufferSize;
     /** Norflash Common Flash Interface information. */
     NorFlashCFI  cfiDescription;
 } NorFlashInfo ;
@@ -228,5 +235,9 @@ extern uint8_t NorFlash_GetDataBusWidth( NorFlashInfo *pNorFlashInfo ) ;
 
 extern uint32_t NorFlash_GetDeviceSizeInBytes( NorFlashInfo *pNorFlashInfo ) ;
 
+extern uint16_t NorFlash_GetWriteBufferSize( NorFlashInfo *pNorFlashInfo ) ;
+
+extern uint8_t NorFlash_GetPageReadSize( NorFlashInfo *pNorFlashInfo ) ;
+
 #endif /* #ifndef _NORFLASHCFI_ */
 
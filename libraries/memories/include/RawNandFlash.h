@@ -36,6 +36,18 @@
 #include <stdint.h>
 
 #include "NandFlashModel.h"
+#include "Media.h"
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Maximum number of identical dies (chip selects) striped in one device.*/
+#define RawNandFlash_MAXDIES    4
+
+/** log2 of a number of dies (1, 2 or 4): the blocks of the dies are
+    concatenated, so the dies must be a power of two.*/
+#define RawNandFlash_DIESHIFT(numDies)  ((numDies) >> 1)
+
 /*----------------------------------------------------------------------------
  *        Types
  *----------------------------------------------------------------------------*/
@@ -56,12 +68,20 @@ struct RawNandFlash {
     Pin pinChipEnable;
     /** Pin used to monitor the ready/busy signal from the NandFlash.*/
     Pin pinReadyBusy;
+    /** Number of dies striped in each block, 1 for a single device.*/
+    unsigned char numDies;
+    /** Chip enable pins of the dies 1 to numDies - 1.*/
+    Pin pinDieChipEnables[RawNandFlash_MAXDIES - 1];
 };
 
 
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
+extern unsigned char RawNandFlash_ConfigureDies(
+    const Pin *pinChipEnables,
+    unsigned char numDies);
+
 extern unsigned char RawNandFlash_Initialize(
     struct RawNandFlash *raw,
     const struct NandFlashModel *model,
@@ -79,6 +99,23 @@ extern unsigned char RawNandFlash_EraseBlock(
     const struct RawNandFlash *raw,
     unsigned short block);
 
+extern void RawNandFlash_ConfigureReadyInterrupt(
+    const struct RawNandFlash *raw);
+
+extern void RawNandFlash_SetReadyNotify(
+    void (*notify)(void *argument),
+    void *argument);
+
+extern unsigned char RawNandFlash_StartEraseBlock(
+    const struct RawNandFlash *raw,
+    unsigned short block,
+    MediaCallback callback,
+    void *argument);
+
+extern unsigned char RawNandFlash_Poll(const struct RawNandFlash *raw);
+
+extern void RawNandFlash_Finish(const struct RawNandFlash *raw);
+
 extern unsigned char RawNandFlash_ReadPage(
     const struct RawNandFlash *raw,
     unsigned short block,
@@ -86,6 +123,20 @@ extern unsigned char RawNandFlash_ReadPage(
     void *data,
     void *spare);
 
+extern unsigned char RawNandFlash_ReadSpare(
+    const struct RawNandFlash *raw,
+    unsigned short block,
+    unsigned short page,
+    unsigned char offset,
+    void *buffer,
+    unsigned char size);
+
+extern unsigned char RawNandFlash_ReadBadBlockMarkers(
+    const struct RawNandFlash *raw,
+    unsigned short firstBlock,
+    unsigned short numBlocks,
+    unsigned char *bitmap);
+
 extern unsigned char RawNandFlash_WritePage(
     const struct RawNandFlash *raw,
     unsigned short block,
@@ -93,6 +144,29 @@ extern unsigned char RawNandFlash_WritePage(
     void *data,
     void *spare);
 
+extern unsigned char RawNandFlash_ReadPages(
+    const struct RawNandFlash *raw,
+    unsigned short block,
+    unsigned short page,
+    unsigned short numPages,
+    void *data,
+    void *spare);
+
+extern unsigned char RawNandFlash_WritePages(
+    const struct RawNandFlash *raw,
+    unsigned short block,
+    unsigned short page,
+    unsigned short numPages,
+    void *data,
+    void *spare);
+
+extern unsigned char RawNandFlash_WritePageTwoPlanes(
+    const struct RawNandFlash *raw,
+    unsigned short block,
+    unsigned short page,
+    void *data,
+    void *spare);
+
 extern unsigned char RawNandFlash_CopyPage(
     const struct RawNandFlash *raw,
     unsigned short sourceBlock,
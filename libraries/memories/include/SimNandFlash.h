@@ -0,0 +1,121 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Simulated NandFlash device for host builds (NAND_SIMULATOR defined). The
+ * simulator implements the RawNandFlash interface over host memory, so that
+ * the upper layers (EccNandFlash to TranslatedNandFlash, MEDNandFlash and
+ * FatFs) run unchanged. The geometry is taken from NandFlashModelList by the
+ * configured chip ID. Factory bad blocks, transient bit flips, program/erase
+ * failures, wear-out, power cuts and the operation latencies are modeled.
+ *
+ */
+
+#ifndef SIMNANDFLASH_H
+#define SIMNANDFLASH_H
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Simulated device configuration (probabilities in parts per million).*/
+struct SimNandFlashConfig {
+
+    /** Identifiers returned by RawNandFlash_ReadId().*/
+    unsigned int chipId;
+    /** Seed of the pseudo-random generator (must not be 0).*/
+    unsigned int seed;
+    /** Number of factory bad blocks (block 0 is always good).*/
+    unsigned short numBadBlocks;
+    /** Probability that a page read returns flipped bits.*/
+    unsigned int bitFlipPpm;
+    /** Maximum number of bits flipped by one read (1 to max), 0 for 1.*/
+    unsigned char maxBitFlips;
+    /** Probability that a page program fails.*/
+    unsigned int programFailPpm;
+    /** Probability that a block erase fails.*/
+    unsigned int eraseFailPpm;
+    /** Number of erase cycles after which a block fails, 0 for no limit.*/
+    unsigned int wearLimit;
+    /** Array to page register time (tR) in ns.*/
+    unsigned int readTime;
+    /** Page program time (tPROG) in ns.*/
+    unsigned int programTime;
+    /** Block erase time (tBERS) in ns.*/
+    unsigned int eraseTime;
+    /** Bus transfer time of one byte in ns.*/
+    unsigned int byteTime;
+};
+
+/** Simulated device counters.*/
+struct SimNandFlashStats {
+
+    /** Page reads (spare reads included).*/
+    unsigned int reads;
+    /** Page programs.*/
+    unsigned int programs;
+    /** Block erases.*/
+    unsigned int erases;
+    /** Internal page copies (copy-back).*/
+    unsigned int copies;
+    /** Bits flipped in the returned data.*/
+    unsigned int bitFlips;
+    /** Failed program and erase operations.*/
+    unsigned int failures;
+    /** Bytes transferred from the device.*/
+    unsigned long long bytesRead;
+    /** Bytes programmed in the array (copy-back included).*/
+    unsigned long long bytesProgrammed;
+    /** Simulated device time in ns.*/
+    unsigned long long time;
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern void SimNandFlash_GetDefaultConfig(struct SimNandFlashConfig *config);
+
+extern void SimNandFlash_Configure(const struct SimNandFlashConfig *config);
+
+extern void SimNandFlash_SetPowerCut(unsigned int numOperations);
+
+extern unsigned char SimNandFlash_IsPowerOff(void);
+
+extern void SimNandFlash_PowerOn(void);
+
+extern const struct SimNandFlashStats * SimNandFlash_GetStats(void);
+
+extern void SimNandFlash_ResetStats(void);
+
+extern unsigned int SimNandFlash_GetEraseCount(unsigned short block);
+
+#endif /*#ifndef SIMNANDFLASH_H*/
@@ -36,15 +36,51 @@
 
 #include "MappedNandFlash.h"
 
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of logical blocks which can be open for writing at the same time.
+    Each open block is backed by a physical log block. */
+#ifndef TRANSLATEDNANDFLASH_WRITEBLOCKS
+#define TRANSLATEDNANDFLASH_WRITEBLOCKS     4
+#endif
+
+/** Number of FREE blocks below which TranslatedNandFlash_CollectGarbage()
+    erases and compacts blocks. */
+#ifndef TRANSLATEDNANDFLASH_GCWATERMARK
+#define TRANSLATEDNANDFLASH_GCWATERMARK     (TRANSLATEDNANDFLASH_WRITEBLOCKS + 2)
+#endif
+
 /*----------------------------------------------------------------------------
  *        Type
  *----------------------------------------------------------------------------*/
+
+/** Logical block open for writing: its pages are appended to a log block and
+    merged back into a data block when the log is full or evicted. */
+struct TranslatedWriteBlock {
+
+    /** Logical block being written, -1 if the entry is unused */
+    signed short logicalBlock;
+    /** Physical log block */
+    signed short physicalBlock;
+    /** Next page to program in the log block */
+    unsigned short nextPage;
+    unsigned short reserved;
+    /** Last access, for LRU eviction */
+    unsigned int lastUse;
+    /** Logical pages held by the log */
+    unsigned char pageLogged[NandCommon_MAXNUMPAGESPERBLOCK / 8];
+    /** Log page holding each logged page */
+    unsigned char pageMap[NandCommon_MAXNUMPAGESPERBLOCK];
+};
+
 struct TranslatedNandFlash {
 
     struct MappedNandFlash mapped;
-    signed short currentLogicalBlock;
-    signed short previousPhysicalBlock;
-    unsigned char currentBlockPageStatuses[NandCommon_MAXNUMPAGESPERBLOCK / 8];
+    struct TranslatedWriteBlock writeBlocks[TRANSLATEDNANDFLASH_WRITEBLOCKS];
+    unsigned int writeTick;
+    unsigned char writeBlocksModified;
 };
 
 /*----------------------------------------------------------------------------
@@ -79,6 +115,14 @@ extern unsigned char TranslatedNandFlash_WritePage(
 extern unsigned char TranslatedNandFlash_Flush(
     struct TranslatedNandFlash *translated);
 
+extern unsigned char TranslatedNandFlash_DiscardBlock(
+    struct TranslatedNandFlash *translated,
+    unsigned short block);
+
+extern unsigned char TranslatedNandFlash_CollectGarbage(
+    struct TranslatedNandFlash *translated,
+    unsigned char maxSteps);
+
 extern unsigned char TranslatedNandFlash_EraseAll(
     struct TranslatedNandFlash *translated,
     unsigned char level);
@@ -77,7 +77,7 @@
 //         Headers
 //------------------------------------------------------------------------------
 
-//#include "chip.h"
+#include "chip.h"
 
 //------------------------------------------------------------------------------
 //         Macros
@@ -104,6 +104,8 @@
 #define AT26_ERROR_PROGRAM          3
 /// There was an SPI communication error.
 #define AT26_ERROR_SPI              4
+/// The range is not aligned on the smallest erase size of the device.
+#define AT26_ERROR_ALIGNMENT        5
 
 /// Device ready/busy status bit.
 #define AT26_STATUS_RDYBSY          (1 << 0)
@@ -223,7 +225,10 @@ typedef struct _At26 {
 	const At26Desc *pDesc;
     /// Command buffer.
 	unsigned int pCmdBuffer[2];
-
+    /// Write enable command queued ahead of program and erase commands.
+    SpidCmd writeEnable;
+    /// Write enable command buffer.
+    unsigned char writeEnableCmd;
 } At26;
 
 //------------------------------------------------------------------------------
@@ -242,6 +247,14 @@ extern unsigned char AT26_SendCommand(
     SpidCallback callback,
 	void *pArgument);
 
+extern unsigned char AT26_SendWriteCommand(
+	At26 *pAt26,
+	unsigned char cmd,
+	unsigned char cmdSize,
+	unsigned char *pData,
+	unsigned int dataSize,
+	unsigned int address);
+
 extern unsigned char AT26_IsBusy(At26 *pAt26);
 
 extern const At26Desc * AT26_FindDevice(
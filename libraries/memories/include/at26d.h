@@ -63,6 +63,8 @@ extern unsigned char AT26D_EraseChip(At26 *pAt26);
 
 extern unsigned char AT26D_EraseBlock(At26 *pAt26, unsigned int address);
 
+extern unsigned char AT26D_EraseRange(At26 *pAt26, unsigned int address, unsigned int size);
+
 extern unsigned char AT26D_Write(
     At26 *pAt26,
     unsigned char *pData,
@@ -75,5 +77,11 @@ extern unsigned char AT26D_Read(
     unsigned int size,
     unsigned int address);    
 
+extern unsigned char AT26D_ReadFast(
+    At26 *pAt26,
+    unsigned char *pData,
+    unsigned int size,
+    unsigned int address);
+
 #endif // #ifndef AT26D_H
 
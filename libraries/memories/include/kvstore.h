@@ -0,0 +1,150 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*------------------------------------------------------------------------------
+ *  \file
+ *  \section Purpose
+ *
+ *  Key/value store kept as an append-only log in two flash sectors, for
+ *  configuration and calibration data.
+ *
+ *  \section Usage
+ *
+ *  Each KVS_Set() appends one small record (a 4-byte header and the value)
+ *  after the previous ones, on erased flash, so an update costs one small
+ *  program and no erase. The latest record of a key wins, and KVS_Delete()
+ *  appends an empty one. KVS_Initialize() scans the log once and rebuilds a
+ *  RAM hash index of the latest record of each key, so KVS_Get() reads the
+ *  value directly.
+ *
+ *  When the sector is full, the live records are copied to the other sector,
+ *  whose header is programmed last, so that a reset during the compaction
+ *  keeps the previous sector in use. A record cut by a reset is detected by
+ *  its check byte and ignored.
+ *
+ *  The flash is reached through a KVSFlash backend: KVS_InitializeEefc() uses
+ *  reserved pages of the internal flash, KVS_InitializeAt26() two blocks of an
+ *  AT26 serial flash and KVS_InitializeAt45() two blocks of an AT45
+ *  DataFlash.
+ *------------------------------------------------------------------------------*/
+
+#ifndef _KVSTORE_
+#define _KVSTORE_
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Number of index slots, a power of 2; it must exceed the number of keys */
+#ifndef KVS_INDEX_SIZE
+#define KVS_INDEX_SIZE      64
+#endif
+
+/** Largest value size in bytes, at most 255 */
+#ifndef KVS_MAX_VALUE_SIZE
+#define KVS_MAX_VALUE_SIZE  128
+#endif
+
+/** Return codes */
+#define KVS_OK              0
+#define KVS_ERROR_NOTFOUND  1   /**< No value for the key */
+#define KVS_ERROR_PARAM     2   /**< Reserved key or value too large */
+#define KVS_ERROR_FULL      3   /**< No room left in the sector or the index */
+#define KVS_ERROR_FLASH     4   /**< Flash program or erase error */
+
+/** Reserved key, marks the erased flash and the free index slots */
+#define KVS_KEY_NONE        0xFFFF
+
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+/** Flash backend. Program is only given erased bytes, and returns 0 if successful */
+typedef struct _KVSFlash
+{
+    uint32_t (*Read)( void* pContext, uint32_t dwAddress, void* pvData, uint32_t dwSize ) ;
+    uint32_t (*Program)( void* pContext, uint32_t dwAddress, const void* pvData, uint32_t dwSize ) ;
+    uint32_t (*EraseSector)( void* pContext, uint32_t dwAddress ) ;
+    void* pContext ;
+    /** Address of the first of the two sectors */
+    uint32_t dwBase ;
+    /** Sector size in bytes, a multiple of 4 and at most 256 KB */
+    uint32_t dwSectorSize ;
+} KVSFlash ;
+
+/** Store instance */
+typedef struct _KVStore
+{
+    KVSFlash flash ;
+    /** Sector in use, 0 or 1 */
+    uint32_t dwActive ;
+    /** Sequence number of the sector in use */
+    uint32_t dwSequence ;
+    /** Offset of the free space in the sector */
+    uint32_t dwWrite ;
+    /** Keys indexed, KVS_KEY_NONE for a free slot */
+    uint16_t awKeys[KVS_INDEX_SIZE] ;
+    /** Offset of the latest record of each key, in words */
+    uint16_t awOffsets[KVS_INDEX_SIZE] ;
+    /** Number of keys indexed */
+    uint32_t dwCount ;
+} KVStore ;
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+extern uint32_t KVS_Initialize( KVStore* pStore, const KVSFlash* pFlash ) ;
+
+extern uint32_t KVS_InitializeEefc( KVStore* pStore, uint32_t dwAddress, uint32_t dwSectorSize ) ;
+
+struct _At26 ;
+extern uint32_t KVS_InitializeAt26( KVStore* pStore, struct _At26* pAt26, uint32_t dwAddress ) ;
+
+struct _Dataflash ;
+extern uint32_t KVS_InitializeAt45( KVStore* pStore, struct _Dataflash* pAt45, uint32_t dwAddress ) ;
+
+extern uint32_t KVS_Get( KVStore* pStore, uint16_t wKey, void* pvValue, uint32_t dwSize, uint32_t* pdwLength ) ;
+
+extern uint32_t KVS_Set( KVStore* pStore, uint16_t wKey, const void* pvValue, uint32_t dwLength ) ;
+
+extern uint32_t KVS_Delete( KVStore* pStore, uint16_t wKey ) ;
+
+extern uint32_t KVS_Compact( KVStore* pStore ) ;
+
+extern uint32_t KVS_GetFreeSize( const KVStore* pStore ) ;
+
+#endif /* #ifndef _KVSTORE_ */
+
@@ -40,6 +40,8 @@
  *  \section Usage
  *  - General Card Support
  *    -# SD_Init(): Run the SDcard initialization sequence
+ *    -# SD_InitStart(), SD_InitPoll(): Run the same sequence without waiting
+ *       for the card power up, to interleave it with other initializations.
  *    -# SD_GetCardType() : Return SD/MMC reported card type.
  *  - SD/MMC Memory Card Operations
  *    -# SD_ReadBlock() : Read one block of data
@@ -53,11 +55,28 @@
  *    -# SD_GetNumberBlocks() : Return SD/MMC card reported number of blocks.
  *    -# SD_GetBlockSize() : Return SD/MMC card reported block size.
  *    -# SD_GetTotalSizeKB() : Return size of SD/MMC card in KBytes.
+ *    -# SD_Erase() : Erase blocks with the erase commands.
+ *    -# SD_GetEraseBlocks() : Return SD/MMC card erase granularity in blocks.
+ *    -# SD_GetAuBlocks() : Return SD card allocation unit size in blocks.
+ *  - MMC/eMMC Card Operations
+ *    -# MMC_SelectPartition() : Select the user area or a boot partition for
+ *                               the following accesses.
+ *    -# MMC_GetBootPartitionBlocks() : Return the size of a boot partition.
  *  - SDIO Card Operations
  *    -# SDIO_ReadDirect() : Read bytes from registers.
  *    -# SDIO_WriteDirect() : Write one byte to register.
  *    -# SDIO_ReadBytes() : Read 1 ~ 512 bytes from card.
  *    -# SDIO_WriteBytes() : Write 1 ~ 512 bytes to card.
+ *    -# SDIO_SetBlockSize() : Set the block size of a function.
+ *    -# SDIO_ReadBlocks() : Read 1 ~ 511 blocks from card (block mode).
+ *    -# SDIO_WriteBlocks() : Write 1 ~ 511 blocks to card (block mode).
+ *  - SDIO Function Drivers
+ *    -# SDIO_RegisterFunction() : Enable a function, its block size and its
+ *                                 interrupt handler.
+ *    -# SDIO_UnregisterFunction() : Disable a function.
+ *    -# SDIO_ServiceIrq() : Invoke the handlers of the pending functions
+ *                           after the card interrupt (DAT1), to call from
+ *                           the main loop.
  */
 
 #ifndef SDMMC_H
@@ -368,6 +387,12 @@
 #define SD_EXTCSD_HS_TIMING_ENABLE             (0x1UL)
 #define SD_EXTCSD_HS_TIMING_DISABLE            (0x0UL)
 
+// Card type
+#define SD_EXTCSD_CARD_TYPE_HS_26              (0x1UL) // High-speed at 26MHz
+#define SD_EXTCSD_CARD_TYPE_HS_52              (0x2UL) // High-speed at 52MHz
+#define SD_EXTCSD_CARD_TYPE_DDR_52_1_8V        (0x4UL) // Dual data rate at 52MHz, 1.8V or 3V I/O
+#define SD_EXTCSD_CARD_TYPE_DDR_52_1_2V        (0x8UL) // Dual data rate at 52MHz, 1.2V I/O
+
 // Boot config
 #define SD_EXTCSD_BOOT_PARTITION_ACCESS        (0x7UL) // boot partition access
 #define SD_EXTCSD_BOOT_PART_NO_ACCESS          (0x0UL)
@@ -449,6 +474,9 @@
 //         Types
 //------------------------------------------------------------------------------
 
+/** SDIO function interrupt handler, invoked by SDIO_ServiceIrq(). */
+typedef void (*SdioIrqHandler)(SdCard *pSd, uint8_t functionNum, void *pArg);
+
 //------------------------------------------------------------------------------
 //         Global functions
 //------------------------------------------------------------------------------
@@ -456,6 +484,11 @@
 extern uint8_t SD_Init(SdCard *pSd,
                        void   *pSdDriver);
 
+extern uint8_t SD_InitStart(SdCard *pSd,
+                            void   *pSdDriver);
+
+extern uint8_t SD_InitPoll(SdCard *pSd);
+
 extern uint8_t SD_GetCardType(SdCard * pSd);
 
 extern uint32_t SD_GetNumberBlocks(SdCard * pSd);
@@ -464,6 +497,10 @@ extern uint32_t SD_GetBlockSize(SdCard * pSd);
 
 extern uint32_t SD_GetTotalSizeKB(SdCard * pSd);
 
+extern uint32_t SD_GetEraseBlocks(SdCard * pSd);
+
+extern uint32_t SD_GetAuBlocks(SdCard * pSd);
+
 extern uint8_t SD_Read(SdCard        *pSd,
                        uint32_t      address,
                        void          *pData,
@@ -478,6 +515,19 @@ extern uint8_t SD_Write(SdCard        *pSd,
                         SdmmcCallback pCallback,
                         void          *pArgs);
 
+extern uint8_t SD_StreamOpen(SdCard   *pSd,
+                             uint32_t address,
+                             uint32_t preErase,
+                             uint8_t  isRead);
+
+extern uint8_t SD_StreamAppend(SdCard        *pSd,
+                               void          *pData,
+                               uint16_t      length,
+                               SdmmcCallback pCallback,
+                               void          *pArgs);
+
+extern uint8_t SD_StreamClose(SdCard *pSd);
+
 extern uint8_t SD_ReadBlock(
     SdCard *pSd,
     uint32_t address,
@@ -500,6 +550,17 @@ extern uint8_t SD_WriteBlocks(
     uint16_t nbBlocks,
     uint8_t *pData);
 
+extern uint8_t SD_Erase(
+    SdCard *pSd,
+    uint32_t address,
+    uint32_t nbBlocks);
+
+extern uint8_t MMC_SelectPartition(
+    SdCard *pSd,
+    uint8_t partition);
+
+extern uint32_t MMC_GetBootPartitionBlocks(SdCard * pSd);
+
 extern uint8_t SDIO_ReadDirect(
     SdCard * pSd,
     uint8_t functionNum,
@@ -533,6 +594,42 @@ extern uint8_t SDIO_WriteBytes(
     SdmmcCallback fCallback,
     void * pArg);
 
+extern uint8_t SDIO_SetBlockSize(
+    SdCard * pSd,
+    uint8_t functionNum,
+    uint16_t blockSize);
+
+extern uint8_t SDIO_ReadBlocks(
+    SdCard * pSd,
+    uint8_t functionNum,
+    uint32_t address,
+    uint8_t isFixedAddress,
+    uint8_t * pData,
+    uint16_t nbBlocks,
+    SdmmcCallback fCallback,
+    void * pArg);
+
+extern uint8_t SDIO_WriteBlocks(
+    SdCard * pSd,
+    uint8_t functionNum,
+    uint32_t address,
+    uint8_t isFixedAddress,
+    uint8_t * pData,
+    uint16_t nbBlocks,
+    SdmmcCallback fCallback,
+    void * pArg);
+
+extern uint8_t SDIO_RegisterFunction(
+    SdCard * pSd,
+    uint8_t functionNum,
+    uint16_t blockSize,
+    SdioIrqHandler fHandler,
+    void * pArg);
+
+extern uint8_t SDIO_UnregisterFunction(SdCard * pSd, uint8_t functionNum);
+
+extern uint8_t SDIO_ServiceIrq(SdCard * pSd);
+
 extern void SDIO_DisplayCardInformation(SdCard *pSd);
 
 extern void SD_DisplayRegisterCID(SdCard *pSd);
@@ -43,6 +43,7 @@
  * - SdmmcSetBusWidth()
  * - SdmmcEnableHsMode()
  * - SdmmcSetSpeed()
+ * - SdmmcEnableSdioIrq()
  *
  * \section sdmmc_cmd_fun SD/MMC command functions
  *
@@ -61,6 +62,9 @@
  *   - SdmmcCmd18() : Read multiple blocks
  *   - SdmmcCmd24() : Write single block
  *   - SdmmcCmd25() : Write multiple blocks
+ *   - SdmmcEraseStart() : Set the first block to erase (SD CMD32, MMC CMD35)
+ *   - SdmmcEraseEnd() : Set the last block to erase (SD CMD33, MMC CMD36)
+ *   - SdmmcCmd38() : Erase the selected blocks
  *   - SdmmcCmd55() : App command, should be sent before application specific
  *                    command
  *   - SdmmcRead() : Write data without any command
@@ -73,6 +77,7 @@
  *   - SdCmd8() : Sends SD Memory Card interface condition, which includes host supply voltage
  *                information and asks the card whether card supports voltage
  *   - SdAcmd6() : Defines the data bus width
+ *   - SdAcmd23() : Sets the number of blocks to pre-erase before writing.
  *   - SdAcmd41() : Asks to all cards to send their operations conditions.
  *   - SdAcmd51() : Sends SD Card Configuration Register (SCR).
  * - Functions for MMC card
@@ -80,6 +85,7 @@
  *   - MmcCmd3() : Set a new relative address to MMC card.
  *   - MmcCmd6() : MMC Switch.
  *   - MmcCmd8() : Sends MMC EXT_CSD.
+ *   - MmcCmd23() : Sets the block count of the next multiple block transfer.
  */
 
 #ifndef SDMMC_CMD_H
@@ -211,6 +217,9 @@
 /** SD/MMC end-of-transfer callback function. */
 typedef void (*SdmmcCallback)(uint8_t status, void *pArg);
 
+/** SDIO card interrupt callback function, invoked in interrupt context. */
+typedef void (*SdmmcIrqCallback)(void *pArg);
+
 /**
  * SD/MMC enumeration data buffers.
  */
@@ -340,6 +349,8 @@ typedef struct _SdCard
     uint32_t preBlock;
     /** Previous access block number for SDIO. */
     uint32_t preSdioBlock;
+    /** SDIO block size of the functions 0 to 7, 0 until set */
+    uint16_t ioBlockSize[8];
 
     /** SD card current access speed. */
     uint32_t accSpeed;
@@ -353,6 +364,8 @@ typedef struct _SdCard
     uint8_t cardSlot;
     /** Card State */
     uint8_t state;
+    /** Identification flags, between SD_InitStart() and SD_InitPoll() */
+    uint8_t identFlags;
 } SdCard;
 
 
@@ -510,7 +523,9 @@ extern uint8_t MmcCmd1(SdCard * pSd,uint32_t * pOCR,SdmmcCallback fCallback);
 extern uint8_t MmcCmd3(SdCard * pSd, uint16_t cardAddr,SdmmcCallback fCallback);
 extern uint8_t MmcCmd6(SdCard * pSd, const void * pSwitchArg, uint32_t * pResp,SdmmcCallback fCallback);
 extern uint8_t MmcCmd8(SdCard * pSd,uint8_t * pEXT,SdmmcCallback fCallback);
+extern uint8_t MmcCmd23(SdCard * pSd, uint16_t nbBlocks, uint32_t * pStatus,SdmmcCallback fCallback);
 extern uint8_t SdAcmd13(SdCard * pSd,uint32_t * pSdSTAT,SdmmcCallback fCallback);
+extern uint8_t SdAcmd23(SdCard * pSd, uint32_t nbBlocks, uint32_t * pStatus,SdmmcCallback fCallback);
 extern uint8_t SdAcmd41(SdCard * pSd,uint32_t * pIo,SdmmcCallback fCallback);
 extern uint8_t SdAcmd51(SdCard * pSd,uint32_t * pSCR,SdmmcCallback fCallback);
 extern uint8_t SdAcmd6(SdCard * pSd, uint32_t arg, uint32_t * pStatus,SdmmcCallback fCallback);
@@ -539,7 +554,11 @@ extern uint8_t SdmmcCmd25(SdCard * pSd, uint16_t blockSize,uint16_t nbBlock,uint
 extern uint8_t SdmmcCmd55(SdCard * pSd, uint16_t cardAddr,SdmmcCallback fCallback);
 extern uint8_t SdmmcCmd7(SdCard * pSd, uint16_t cardAddr, SdmmcCallback fCallback);
 extern uint8_t SdmmcCmd9(SdCard * pSd, uint16_t cardAddr, uint32_t * pCSD,SdmmcCallback fCallback);
+extern uint8_t SdmmcCmd38(SdCard * pSd, uint32_t * pStatus,SdmmcCallback fCallback);
+extern uint8_t SdmmcEraseStart(SdCard * pSd, uint32_t address, uint32_t * pStatus,SdmmcCallback fCallback);
+extern uint8_t SdmmcEraseEnd(SdCard * pSd, uint32_t address, uint32_t * pStatus,SdmmcCallback fCallback);
 extern uint8_t SdmmcEnableHsMode(SdCard *pSd, uint8_t enable);
+extern uint8_t SdmmcEnableSdioIrq(SdCard *pSd, SdmmcIrqCallback fCallback, void *pArg);
 extern uint32_t SdmmcGetProperty(SdCard *pSd, uint32_t property, void * pExtData);
 extern uint8_t SdmmcPowerOn(SdCard * pSd,SdmmcCallback fCallback);
 extern uint8_t SdmmcRead(SdCard * pSd, uint16_t blockSize, uint16_t nbBlock, uint8_t * pData, SdmmcCallback fCallback,void * pArg);
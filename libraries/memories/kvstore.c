@@ -0,0 +1,710 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*------------------------------------------------------------------------------
+ *  \file
+ *
+ *  Implementation of the append-only flash key/value store.
+ *
+ *  Each sector starts with a KVSSectorHeader, followed by the records. A
+ *  record is a KVSRecordHeader and the value, padded to a multiple of 4 bytes.
+ *  The erased flash reads as the KVS_KEY_NONE key, which ends the log.
+ *------------------------------------------------------------------------------*/
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include "memories.h"
+#include "include/at26.h"
+#include "include/at26d.h"
+#include "include/kvstore.h"
+
+#include <string.h>
+
+/*------------------------------------------------------------------------------
+ *         Local definitions
+ *------------------------------------------------------------------------------*/
+
+/** Sector header magic, "KVS1" */
+#define KVS_MAGIC           0x3153564B
+
+/** Size of a record holding a value of the given length */
+#define KVS_RECORD_SIZE( length )  (sizeof( KVSRecordHeader ) + (((length) + 3) & ~3u))
+
+/** Bytes copied at once by the compaction */
+#define KVS_COPY_SIZE       32
+
+/*------------------------------------------------------------------------------
+ *         Local types
+ *------------------------------------------------------------------------------*/
+
+/** Sector header, programmed once the sector content is complete */
+typedef struct _KVSSectorHeader
+{
+    uint32_t dwMagic ;
+    uint32_t dwSequence ;
+} KVSSectorHeader ;
+
+/** Record header, a length of 0 deletes the key */
+typedef struct _KVSRecordHeader
+{
+    uint16_t wKey ;
+    uint8_t ucLength ;
+    uint8_t ucCheck ;
+} KVSRecordHeader ;
+
+/*------------------------------------------------------------------------------
+ *         Local functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * \brief Returns the address of a sector.
+ */
+static uint32_t _SectorAddress( const KVStore* pStore, uint32_t dwSector )
+{
+    return pStore->flash.dwBase + dwSector * pStore->flash.dwSectorSize ;
+}
+
+/**
+ * \brief Computes the check byte of a record, over its key, length and value.
+ */
+static uint8_t _Check( uint16_t wKey, const uint8_t* pucValue, uint32_t dwLength )
+{
+    uint32_t dwCheck = 0x5A ^ (wKey & 0xFF) ^ (wKey >> 8) ^ dwLength ;
+    uint32_t i ;
+
+    for ( i=0 ; i < dwLength ; i++ )
+    {
+        /* Rotate, so that swapped bytes change the check too */
+        dwCheck = ((dwCheck << 1) | (dwCheck >> 7)) & 0xFF ;
+        dwCheck ^= pucValue[i] ;
+    }
+
+    return (uint8_t)dwCheck ;
+}
+
+/**
+ * \brief Returns the index slot of a key, or the free slot where it would go,
+ * KVS_INDEX_SIZE if the index is full.
+ */
+static uint32_t _Lookup( const KVStore* pStore, uint16_t wKey )
+{
+    uint32_t dwSlot = ((uint32_t)wKey * 40503u >> 4) & (KVS_INDEX_SIZE - 1) ;
+    uint32_t i ;
+
+    for ( i=0 ; i < KVS_INDEX_SIZE ; i++ )
+    {
+        if ( (pStore->awKeys[dwSlot] == wKey) || (pStore->awKeys[dwSlot] == KVS_KEY_NONE) )
+        {
+            return dwSlot ;
+        }
+        dwSlot = (dwSlot + 1) & (KVS_INDEX_SIZE - 1) ;
+    }
+
+    return KVS_INDEX_SIZE ;
+}
+
+/**
+ * \brief Records the latest record of a key in the index.
+ *
+ * \return KVS_OK, KVS_ERROR_FULL if the key is new and the index full.
+ */
+static uint32_t _Index( KVStore* pStore, uint16_t wKey, uint32_t dwOffset )
+{
+    uint32_t dwSlot = _Lookup( pStore, wKey ) ;
+
+    /* Keep a free slot, so that the lookups of unknown keys end */
+    if ( (dwSlot == KVS_INDEX_SIZE)
+      || ((pStore->awKeys[dwSlot] == KVS_KEY_NONE) && (pStore->dwCount == KVS_INDEX_SIZE - 1)) )
+    {
+        return KVS_ERROR_FULL ;
+    }
+
+    if ( pStore->awKeys[dwSlot] == KVS_KEY_NONE )
+    {
+        pStore->awKeys[dwSlot] = wKey ;
+        pStore->dwCount++ ;
+    }
+    pStore->awOffsets[dwSlot] = (uint16_t)(dwOffset / 4) ;
+
+    return KVS_OK ;
+}
+
+/**
+ * \brief Reads and checks a record of the active sector.
+ *
+ * \param pucValue  Value buffer of KVS_MAX_VALUE_SIZE bytes.
+ * \return 1 if the record is valid, 0 otherwise.
+ */
+static uint32_t _ReadRecord( const KVStore* pStore, uint32_t dwOffset, KVSRecordHeader* pHeader, uint8_t* pucValue )
+{
+    uint32_t dwAddress = _SectorAddress( pStore, pStore->dwActive ) + dwOffset ;
+
+    if ( pStore->flash.Read( pStore->flash.pContext, dwAddress, pHeader, sizeof( KVSRecordHeader ) ) )
+    {
+        return 0 ;
+    }
+
+    if ( (pHeader->wKey == KVS_KEY_NONE) || (pHeader->ucLength > KVS_MAX_VALUE_SIZE)
+      || (dwOffset + KVS_RECORD_SIZE( pHeader->ucLength ) > pStore->flash.dwSectorSize) )
+    {
+        return 0 ;
+    }
+
+    if ( pStore->flash.Read( pStore->flash.pContext, dwAddress + sizeof( KVSRecordHeader ), pucValue, pHeader->ucLength ) )
+    {
+        return 0 ;
+    }
+
+    return ( _Check( pHeader->wKey, pucValue, pHeader->ucLength ) == pHeader->ucCheck ) ? 1 : 0 ;
+}
+
+/**
+ * \brief Scans the log of the active sector and rebuilds the index.
+ */
+static void _Scan( KVStore* pStore )
+{
+    uint8_t aucValue[KVS_MAX_VALUE_SIZE] ;
+    KVSRecordHeader header ;
+    uint32_t dwOffset = sizeof( KVSSectorHeader ) ;
+
+    memset( pStore->awKeys, 0xFF, sizeof( pStore->awKeys ) ) ;
+    pStore->dwCount = 0 ;
+
+    while ( dwOffset + sizeof( KVSRecordHeader ) <= pStore->flash.dwSectorSize )
+    {
+        if ( _ReadRecord( pStore, dwOffset, &header, aucValue ) )
+        {
+            _Index( pStore, header.wKey, dwOffset ) ;
+        }
+        else
+        {
+            if ( header.wKey == KVS_KEY_NONE )
+            {
+                /* Erased flash, unless the header itself was cut */
+                if ( *(uint32_t*)&header == 0xFFFFFFFF )
+                {
+                    break ;
+                }
+
+                dwOffset = pStore->flash.dwSectorSize ;
+                break ;
+            }
+
+            if ( dwOffset + KVS_RECORD_SIZE( header.ucLength ) > pStore->flash.dwSectorSize )
+            {
+                /* Unusable header: leave the rest to the next compaction */
+                dwOffset = pStore->flash.dwSectorSize ;
+                break ;
+            }
+            /* Record cut by a reset, skipped */
+        }
+
+        dwOffset += KVS_RECORD_SIZE( header.ucLength ) ;
+    }
+
+    pStore->dwWrite = dwOffset ;
+}
+
+/**
+ * \brief Erases a sector and programs its header, the sector becoming the
+ * active one.
+ */
+static uint32_t _Format( KVStore* pStore, uint32_t dwSector, uint32_t dwSequence )
+{
+    KVSSectorHeader header ;
+    uint32_t dwAddress = _SectorAddress( pStore, dwSector ) ;
+
+    header.dwMagic = KVS_MAGIC ;
+    header.dwSequence = dwSequence ;
+
+    if ( pStore->flash.EraseSector( pStore->flash.pContext, dwAddress )
+      || pStore->flash.Program( pStore->flash.pContext, dwAddress, &header, sizeof( header ) ) )
+    {
+        return KVS_ERROR_FLASH ;
+    }
+
+    pStore->dwActive = dwSector ;
+    pStore->dwSequence = dwSequence ;
+    pStore->dwWrite = sizeof( KVSSectorHeader ) ;
+    memset( pStore->awKeys, 0xFF, sizeof( pStore->awKeys ) ) ;
+    pStore->dwCount = 0 ;
+
+    return KVS_OK ;
+}
+
+/**
+ * \brief Appends a record to the active sector, compacting it when full.
+ */
+static uint32_t _Append( KVStore* pStore, uint16_t wKey, const void* pvValue, uint32_t dwLength )
+{
+    uint32_t adwRecord[KVS_RECORD_SIZE( KVS_MAX_VALUE_SIZE ) / 4] ;
+    KVSRecordHeader* pHeader = (KVSRecordHeader*)adwRecord ;
+    uint32_t dwSize = KVS_RECORD_SIZE( dwLength ) ;
+    uint32_t dwSlot ;
+    uint32_t dwError ;
+
+    /* A new key needs an index slot, checked before writing anything */
+    dwSlot = _Lookup( pStore, wKey ) ;
+    if ( (dwSlot == KVS_INDEX_SIZE)
+      || ((pStore->awKeys[dwSlot] == KVS_KEY_NONE) && (pStore->dwCount == KVS_INDEX_SIZE - 1)) )
+    {
+        return KVS_ERROR_FULL ;
+    }
+
+    if ( pStore->dwWrite + dwSize > pStore->flash.dwSectorSize )
+    {
+        dwError = KVS_Compact( pStore ) ;
+        if ( dwError != KVS_OK )
+        {
+            return dwError ;
+        }
+
+        if ( pStore->dwWrite + dwSize > pStore->flash.dwSectorSize )
+        {
+            return KVS_ERROR_FULL ;
+        }
+    }
+
+    /* Header and value in one program, so that a cut record fails its check */
+    memset( adwRecord, 0xFF, dwSize ) ;
+    pHeader->wKey = wKey ;
+    pHeader->ucLength = (uint8_t)dwLength ;
+    pHeader->ucCheck = _Check( wKey, (const uint8_t*)pvValue, dwLength ) ;
+    memcpy( pHeader + 1, pvValue, dwLength ) ;
+
+    dwError = pStore->flash.Program( pStore->flash.pContext, _SectorAddress( pStore, pStore->dwActive ) + pStore->dwWrite,
+                                     adwRecord, dwSize ) ;
+    if ( dwError )
+    {
+        /* Never program these bytes again */
+        pStore->dwWrite += dwSize ;
+        return KVS_ERROR_FLASH ;
+    }
+
+    _Index( pStore, wKey, pStore->dwWrite ) ;
+    pStore->dwWrite += dwSize ;
+
+    return KVS_OK ;
+}
+
+/*------------------------------------------------------------------------------
+ *         Backends
+ *------------------------------------------------------------------------------*/
+
+/** Pages of an AT45 erase block, the AT45 sector of a store */
+#define KVS_AT45_BLOCK_PAGES    8
+
+/**
+ * \brief Reads the internal flash.
+ */
+static uint32_t _EefcRead( void* pContext, uint32_t dwAddress, void* pvData, uint32_t dwSize )
+{
+    memcpy( pvData, (const void*)dwAddress, dwSize ) ;
+
+    return 0 ;
+}
+
+/**
+ * \brief Programs erased internal flash bytes.
+ */
+static uint32_t _EefcProgram( void* pContext, uint32_t dwAddress, const void* pvData, uint32_t dwSize )
+{
+    return FLASHD_WriteNoErase( dwAddress, pvData, dwSize ) ;
+}
+
+/**
+ * \brief Erases a sector of internal flash pages.
+ */
+static uint32_t _EefcEraseSector( void* pContext, uint32_t dwAddress )
+{
+    return FLASHD_ErasePages( dwAddress, (uint32_t)pContext ) ;
+}
+
+/**
+ * \brief Reads the AT26 serial flash.
+ */
+static uint32_t _At26Read( void* pContext, uint32_t dwAddress, void* pvData, uint32_t dwSize )
+{
+    return AT26D_Read( (At26*)pContext, (unsigned char*)pvData, dwSize, dwAddress ) ;
+}
+
+/**
+ * \brief Programs erased AT26 bytes.
+ */
+static uint32_t _At26Program( void* pContext, uint32_t dwAddress, const void* pvData, uint32_t dwSize )
+{
+    return AT26D_Write( (At26*)pContext, (unsigned char*)pvData, dwSize, dwAddress ) ;
+}
+
+/**
+ * \brief Erases an AT26 block.
+ */
+static uint32_t _At26EraseSector( void* pContext, uint32_t dwAddress )
+{
+    return AT26D_EraseBlock( (At26*)pContext, dwAddress ) ;
+}
+
+/**
+ * \brief Reads the AT45 DataFlash.
+ */
+static uint32_t _At45Read( void* pContext, uint32_t dwAddress, void* pvData, uint32_t dwSize )
+{
+    AT45D_Read( (At45*)pContext, (uint8_t*)pvData, dwSize, dwAddress ) ;
+
+    return 0 ;
+}
+
+/**
+ * \brief Programs erased AT45 bytes: each page is loaded into a SRAM buffer,
+ * patched with the new bytes and programmed back without the built-in erase.
+ */
+static uint32_t _At45Program( void* pContext, uint32_t dwAddress, const void* pvData, uint32_t dwSize )
+{
+    At45* pAt45 = (At45*)pContext ;
+    const uint8_t* pucData = (const uint8_t*)pvData ;
+    uint32_t dwPageSize = AT45_PageSize( pAt45 ) ;
+    uint32_t dwOffset ;
+    uint32_t dwChunk ;
+
+    while ( dwSize )
+    {
+        dwOffset = dwAddress % dwPageSize ;
+        dwChunk = min( dwPageSize - dwOffset, dwSize ) ;
+
+        AT45D_LoadBuffer( pAt45, 0, dwAddress - dwOffset ) ;
+        AT45D_WriteBuffer( pAt45, 0, pucData, dwChunk, dwOffset ) ;
+        AT45D_ProgramBuffer( pAt45, 0, dwAddress - dwOffset, 0 ) ;
+        AT45D_WaitReady( pAt45 ) ;
+
+        pucData += dwChunk ;
+        dwAddress += dwChunk ;
+        dwSize -= dwChunk ;
+    }
+
+    return 0 ;
+}
+
+/**
+ * \brief Erases an AT45 block.
+ */
+static uint32_t _At45EraseSector( void* pContext, uint32_t dwAddress )
+{
+    AT45D_EraseBlock( (At45*)pContext, dwAddress ) ;
+
+    return 0 ;
+}
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * \brief Mounts a store, or formats it when none of its sectors holds one.
+ *
+ * \param pStore  Store instance.
+ * \param pFlash  Flash backend, copied in the instance.
+ * \return KVS_OK or KVS_ERROR_FLASH.
+ */
+extern uint32_t KVS_Initialize( KVStore* pStore, const KVSFlash* pFlash )
+{
+    KVSSectorHeader aHeaders[2] ;
+    uint32_t adwValid[2] ;
+    uint32_t dwSector ;
+
+    pStore->flash = *pFlash ;
+
+    for ( dwSector=0 ; dwSector < 2 ; dwSector++ )
+    {
+        adwValid[dwSector] = ( (pFlash->Read( pFlash->pContext, _SectorAddress( pStore, dwSector ), &aHeaders[dwSector], sizeof( KVSSectorHeader ) ) == 0)
+                              && (aHeaders[dwSector].dwMagic == KVS_MAGIC) ) ? 1 : 0 ;
+    }
+
+    if ( !adwValid[0] && !adwValid[1] )
+    {
+        TRACE_INFO( "KVS: formatting\n\r" ) ;
+        return _Format( pStore, 0, 1 ) ;
+    }
+
+    /* Both valid after a compaction: the newer one wins */
+    if ( adwValid[0] && adwValid[1] )
+    {
+        dwSector = ( (int32_t)(aHeaders[1].dwSequence - aHeaders[0].dwSequence) > 0 ) ? 1 : 0 ;
+    }
+    else
+    {
+        dwSector = adwValid[1] ;
+    }
+
+    pStore->dwActive = dwSector ;
+    pStore->dwSequence = aHeaders[dwSector].dwSequence ;
+    _Scan( pStore ) ;
+
+    TRACE_DEBUG( "KVS: sector %u, %u keys, %u bytes free\n\r", (unsigned int)dwSector,
+                 (unsigned int)pStore->dwCount, (unsigned int)KVS_GetFreeSize( pStore ) ) ;
+
+    return KVS_OK ;
+}
+
+/**
+ * \brief Mounts a store over two sectors of reserved internal flash pages.
+ *
+ * The pages must be unlocked, and be left out of the application image.
+ *
+ * \param pStore  Store instance.
+ * \param dwAddress  Address of the first sector, on a page boundary.
+ * \param dwSectorSize  Size of each sector, a multiple of IFLASH_PAGE_SIZE.
+ * \return KVS_OK or KVS_ERROR_FLASH.
+ */
+extern uint32_t KVS_InitializeEefc( KVStore* pStore, uint32_t dwAddress, uint32_t dwSectorSize )
+{
+    KVSFlash flash ;
+
+    flash.Read = _EefcRead ;
+    flash.Program = _EefcProgram ;
+    flash.EraseSector = _EefcEraseSector ;
+    flash.pContext = (void*)dwSectorSize ;
+    flash.dwBase = dwAddress ;
+    flash.dwSectorSize = dwSectorSize ;
+
+    return KVS_Initialize( pStore, &flash ) ;
+}
+
+/**
+ * \brief Mounts a store over two erase blocks of an AT26 serial flash.
+ *
+ * \param pStore  Store instance.
+ * \param pAt26  Configured and unprotected AT26 driver.
+ * \param dwAddress  Address of the first block, on a block boundary.
+ * \return KVS_OK or KVS_ERROR_FLASH.
+ */
+extern uint32_t KVS_InitializeAt26( KVStore* pStore, struct _At26* pAt26, uint32_t dwAddress )
+{
+    KVSFlash flash ;
+
+    flash.Read = _At26Read ;
+    flash.Program = _At26Program ;
+    flash.EraseSector = _At26EraseSector ;
+    flash.pContext = pAt26 ;
+    flash.dwBase = dwAddress ;
+    flash.dwSectorSize = AT26_BlockSize( pAt26 ) ;
+
+    return KVS_Initialize( pStore, &flash ) ;
+}
+
+/**
+ * \brief Mounts a store over two erase blocks of an AT45 DataFlash.
+ *
+ * A block is 8 pages. A record is programmed into its page without erase,
+ * the page content being kept through the SRAM buffer 1.
+ *
+ * \param pStore  Store instance.
+ * \param pAt45  Configured AT45 driver.
+ * \param dwAddress  Address of the first block, on a block boundary.
+ * \return KVS_OK or KVS_ERROR_FLASH.
+ */
+extern uint32_t KVS_InitializeAt45( KVStore* pStore, struct _Dataflash* pAt45, uint32_t dwAddress )
+{
+    KVSFlash flash ;
+
+    flash.Read = _At45Read ;
+    flash.Program = _At45Program ;
+    flash.EraseSector = _At45EraseSector ;
+    flash.pContext = pAt45 ;
+    flash.dwBase = dwAddress ;
+    flash.dwSectorSize = KVS_AT45_BLOCK_PAGES * AT45_PageSize( pAt45 ) ;
+
+    return KVS_Initialize( pStore, &flash ) ;
+}
+
+/**
+ * \brief Reads the value of a key.
+ *
+ * \param pStore  Store instance.
+ * \param wKey  Key.
+ * \param pvValue  Value buffer.
+ * \param dwSize  Size of the buffer; a longer value is truncated.
+ * \param pdwLength  Length of the stored value (optional).
+ * \return KVS_OK or KVS_ERROR_NOTFOUND.
+ */
+extern uint32_t KVS_Get( KVStore* pStore, uint16_t wKey, void* pvValue, uint32_t dwSize, uint32_t* pdwLength )
+{
+    uint8_t aucValue[KVS_MAX_VALUE_SIZE] ;
+    KVSRecordHeader header ;
+    uint32_t dwSlot = _Lookup( pStore, wKey ) ;
+
+    if ( (wKey == KVS_KEY_NONE) || (dwSlot == KVS_INDEX_SIZE) || (pStore->awKeys[dwSlot] != wKey) )
+    {
+        return KVS_ERROR_NOTFOUND ;
+    }
+
+    if ( !_ReadRecord( pStore, pStore->awOffsets[dwSlot] * 4, &header, aucValue ) || (header.ucLength == 0) )
+    {
+        return KVS_ERROR_NOTFOUND ;
+    }
+
+    memcpy( pvValue, aucValue, min( dwSize, header.ucLength ) ) ;
+    if ( pdwLength != NULL )
+    {
+        *pdwLength = header.ucLength ;
+    }
+
+    return KVS_OK ;
+}
+
+/**
+ * \brief Sets the value of a key, appending a record unless the value is
+ * unchanged.
+ *
+ * \param pStore  Store instance.
+ * \param wKey  Key, other than KVS_KEY_NONE.
+ * \param pvValue  Value.
+ * \param dwLength  Value length, 1 to KVS_MAX_VALUE_SIZE bytes.
+ * \return KVS_OK, KVS_ERROR_PARAM, KVS_ERROR_FULL or KVS_ERROR_FLASH.
+ */
+extern uint32_t KVS_Set( KVStore* pStore, uint16_t wKey, const void* pvValue, uint32_t dwLength )
+{
+    uint8_t aucValue[KVS_MAX_VALUE_SIZE] ;
+    uint32_t dwStored ;
+
+    if ( (wKey == KVS_KEY_NONE) || (dwLength == 0) || (dwLength > KVS_MAX_VALUE_SIZE) )
+    {
+        return KVS_ERROR_PARAM ;
+    }
+
+    if ( (KVS_Get( pStore, wKey, aucValue, sizeof( aucValue ), &dwStored ) == KVS_OK)
+      && (dwStored == dwLength) && (memcmp( aucValue, pvValue, dwLength ) == 0) )
+    {
+        return KVS_OK ;
+    }
+
+    return _Append( pStore, wKey, pvValue, dwLength ) ;
+}
+
+/**
+ * \brief Deletes a key.
+ *
+ * \param pStore  Store instance.
+ * \param wKey  Key.
+ * \return KVS_OK, KVS_ERROR_NOTFOUND, KVS_ERROR_FULL or KVS_ERROR_FLASH.
+ */
+extern uint32_t KVS_Delete( KVStore* pStore, uint16_t wKey )
+{
+    uint8_t ucValue ;
+
+    if ( KVS_Get( pStore, wKey, &ucValue, 1, NULL ) != KVS_OK )
+    {
+        return KVS_ERROR_NOTFOUND ;
+    }
+
+    return _Append( pStore, wKey, NULL, 0 ) ;
+}
+
+/**
+ * \brief Copies the live records to the other sector, which becomes the
+ * active one.
+ *
+ * The header of the new sector is programmed last: until then, a reset keeps
+ * the current sector in use.
+ *
+ * \param pStore  Store instance.
+ * \return KVS_OK or KVS_ERROR_FLASH.
+ */
+extern uint32_t KVS_Compact( KVStore* pStore )
+{
+    uint32_t adwBuffer[KVS_COPY_SIZE/4] ;
+    KVSSectorHeader header ;
+    KVSRecordHeader record ;
+    uint32_t dwSource = _SectorAddress( pStore, pStore->dwActive ) ;
+    uint32_t dwTarget = 1 - pStore->dwActive ;
+    uint32_t dwAddress = _SectorAddress( pStore, dwTarget ) ;
+    uint32_t dwWrite = sizeof( KVSSectorHeader ) ;
+    uint32_t dwSlot ;
+    uint32_t dwSize ;
+    uint32_t dwCopied ;
+    uint32_t dwChunk ;
+
+    if ( pStore->flash.EraseSector( pStore->flash.pContext, dwAddress ) )
+    {
+        return KVS_ERROR_FLASH ;
+    }
+
+    for ( dwSlot=0 ; dwSlot < KVS_INDEX_SIZE ; dwSlot++ )
+    {
+        if ( pStore->awKeys[dwSlot] == KVS_KEY_NONE )
+        {
+            continue ;
+        }
+
+        /* Deleted keys are dropped */
+        if ( pStore->flash.Read( pStore->flash.pContext, dwSource + pStore->awOffsets[dwSlot] * 4, &record, sizeof( record ) )
+          || (record.ucLength == 0) )
+        {
+            continue ;
+        }
+
+        dwSize = KVS_RECORD_SIZE( record.ucLength ) ;
+        for ( dwCopied=0 ; dwCopied < dwSize ; dwCopied += dwChunk )
+        {
+            dwChunk = min( dwSize - dwCopied, KVS_COPY_SIZE ) ;
+            if ( pStore->flash.Read( pStore->flash.pContext, dwSource + pStore->awOffsets[dwSlot] * 4 + dwCopied, adwBuffer, dwChunk )
+              || pStore->flash.Program( pStore->flash.pContext, dwAddress + dwWrite + dwCopied, adwBuffer, dwChunk ) )
+            {
+                return KVS_ERROR_FLASH ;
+            }
+        }
+        dwWrite += dwSize ;
+    }
+
+    header.dwMagic = KVS_MAGIC ;
+    header.dwSequence = pStore->dwSequence + 1 ;
+    if ( pStore->flash.Program( pStore->flash.pContext, dwAddress, &header, sizeof( header ) ) )
+    {
+        return KVS_ERROR_FLASH ;
+    }
+
+    TRACE_DEBUG( "KVS: compacted %u to %u bytes\n\r", (unsigned int)pStore->dwWrite, (unsigned int)dwWrite ) ;
+
+    pStore->dwActive = dwTarget ;
+    pStore->dwSequence = header.dwSequence ;
+    _Scan( pStore ) ;
+
+    return KVS_OK ;
+}
+
+/**
+ * \brief Returns the bytes left in the active sector, the largest record
+ * taking KVS_MAX_VALUE_SIZE+4 bytes.
+ */
+extern uint32_t KVS_GetFreeSize( const KVStore* pStore )
+{
+    return pStore->flash.dwSectorSize - pStore->dwWrite ;
+}
+
@@ -42,15 +42,19 @@
  *----------------------------------------------------------------------------*/
 #include "board.h"
 
-//#include "include/at26.h"
-//#include "include/at26d.h"
+#include "include/at26.h"
+#include "include/at26d.h"
+#include "include/Bch.h"
 #include "include/EccNandFlash.h"
+#include "include/kvstore.h"
+#include "include/MEDCache.h"
 #include "include/ManagedNandFlash.h"
 #include "include/MappedNandFlash.h"
 #include "include/MEDDdram.h"
 #include "include/MEDFlash.h"
 #include "include/Media.h"
 #include "include/MEDNandFlash.h"
+#include "include/MEDRaid.h"
 #include "include/MEDRamDisk.h"
 #include "include/MEDSdcard.h"
 #include "include/MEDSdmmc.h"
@@ -68,6 +72,7 @@
 #include "include/sdio.h"
 #include "include/sdmmc.h"
 #include "include/sdmmc_cmd.h"
+#include "include/SimNandFlash.h"
 #include "include/SkipBlockNandFlash.h"
 #include "include/TranslatedNandFlash.h"
 
@@ -0,0 +1,524 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Binary BCH code of length 8191 over GF(2^13), shortened to one 512-byte
+ * sector plus 13 check bits per corrected error.
+ *
+ * -# Bch_Compute512x computes the code of each sector of a buffer. The
+ *      remainder of the division by the generator polynomial is updated one
+ *      byte at a time, with a 256-entry table of the remainders of the
+ *      byte values (the LFSR advanced by 8 bits).
+ * -# Bch_Verify512x recomputes the remainder of each sector and compares it
+ *      with the stored code: the sectors without error, the common case,
+ *      cost one encoding and no GF(2^13) arithmetic. Otherwise the
+ *      syndromes of the remainder give the error locator polynomial
+ *      (Berlekamp-Massey), whose roots (Chien search) are the erroneous bits.
+ *
+ * The tables are computed on first use for the requested strength (4.5KB
+ * of RAM), the multiplications of the decoder are done without log tables.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "memories.h"
+
+#include <string.h>
+#include <assert.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Degree of the field, and length of the full code in bits.*/
+#define GF_M            13
+#define GF_N            ((1 << GF_M) - 1)
+
+/** Primitive polynomial of GF(2^13): x^13 + x^4 + x^3 + x + 1.*/
+#define GF_POLY         0x201B
+
+/** Words of the largest remainder (13 * Bch_MAXSTRENGTH bits).*/
+#define REMWORDS        ((GF_M * Bch_MAXSTRENGTH + 31) / 32)
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static struct {
+
+    /** Strength of the tables, 0 until they are computed.*/
+    unsigned char strength;
+    /** Number of check bits (degree of the generator polynomial).*/
+    unsigned short numBits;
+    /** Number of remainder words.*/
+    unsigned char numWords;
+    /** Remainders of the byte values times x^numBits, MSB aligned.*/
+    unsigned int remainders[256][REMWORDS];
+    /** Code of an erased sector XOR the code of its remainder.*/
+    unsigned char erasedCode[Bch_ECCBYTES(Bch_MAXSTRENGTH)];
+    /** Reductions of the bits 13 to 20 of a product, for MulAlpha.*/
+    unsigned short reduce[256];
+} bch;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Multiplies two elements of GF(2^13).
+ */
+static unsigned short GfMul(unsigned short a, unsigned short b)
+{
+    unsigned short product = 0;
+
+    while (b) {
+
+        if (b & 1) {
+
+            product ^= a;
+        }
+        b >>= 1;
+        a <<= 1;
+        if (a & (1 << GF_M)) {
+
+            a ^= GF_POLY;
+        }
+    }
+
+    return product;
+}
+
+/**
+ * \brief Raises an element of GF(2^13) to a power.
+ */
+static unsigned short GfPow(unsigned short a, unsigned int exponent)
+{
+    unsigned short result = 1;
+
+    exponent %= GF_N;
+    while (exponent) {
+
+        if (exponent & 1) {
+
+            result = GfMul(result, a);
+        }
+        a = GfMul(a, a);
+        exponent >>= 1;
+    }
+
+    return result;
+}
+
+/**
+ * \brief Multiplies an element of GF(2^13) by alpha^power, with one table
+ * lookup per 8 powers.
+ */
+static unsigned short MulAlpha(unsigned short a, unsigned char power)
+{
+    unsigned int shifted;
+    unsigned char step;
+
+    while (power) {
+
+        step = (power > 8) ? 8 : power;
+        shifted = (unsigned int) a << step;
+        a = (shifted & GF_N) ^ bch.reduce[shifted >> GF_M];
+        power -= step;
+    }
+
+    return a;
+}
+
+/**
+ * \brief Computes the generator polynomial and the tables for a strength.
+ *
+ * \param strength  Number of bit errors corrected per sector.
+ */
+static void BuildTables(unsigned char strength)
+{
+    unsigned short generator[GF_M * Bch_MAXSTRENGTH + 1];
+    unsigned int low[REMWORDS];
+    unsigned int remainder[REMWORDS];
+    unsigned short degree = 0;
+    unsigned short root;
+    unsigned int exponent;
+    unsigned int value;
+    unsigned int i, j, k;
+    unsigned char erased[Bch_SECTORSIZE];
+
+    assert( (strength > 0) && (strength <= Bch_MAXSTRENGTH) ) ;
+
+    /* Reductions of x^13 to x^20*/
+    for (i=0; i < 256; i++) {
+
+        value = i << GF_M;
+        for (j=GF_M + 7; j >= GF_M; j--) {
+
+            if (value & (1 << j)) {
+
+                value ^= GF_POLY << (j - GF_M);
+            }
+        }
+        bch.reduce[i] = value;
+    }
+
+    /* Generator polynomial: product of (x - alpha^e) over the conjugates of
+       alpha, alpha^3, ..., alpha^(2t-1)*/
+    generator[0] = 1;
+    for (i=1; i < 2 * (unsigned int) strength; i += 2) {
+
+        exponent = i;
+        for (j=0; j < GF_M; j++) {
+
+            root = GfPow(2, exponent);
+            generator[degree + 1] = generator[degree];
+            for (k=degree; k > 0; k--) {
+
+                generator[k] = generator[k - 1] ^ GfMul(generator[k], root);
+            }
+            generator[0] = GfMul(generator[0], root);
+            degree++;
+            exponent = (exponent * 2) % GF_N;
+        }
+    }
+    bch.strength = strength;
+    bch.numBits = degree;
+    bch.numWords = (degree + 31) / 32;
+
+    /* Coefficients of degree (numBits - 1) to 0, MSB aligned*/
+    memset(low, 0, sizeof(low));
+    for (k=0; k < degree; k++) {
+
+        assert( generator[k] <= 1 ) ;
+        if (generator[k]) {
+
+            j = degree - 1 - k;
+            low[j / 32] |= 1u << (31 - (j % 32));
+        }
+    }
+
+    /* Advance the LFSR by 8 bits for each byte value*/
+    for (i=0; i < 256; i++) {
+
+        memset(remainder, 0, sizeof(remainder));
+        for (j=0; j < 8; j++) {
+
+            value = (remainder[0] >> 31) ^ ((i >> (7 - j)) & 1);
+            for (k=0; k < REMWORDS - 1; k++) {
+
+                remainder[k] = (remainder[k] << 1) | (remainder[k + 1] >> 31);
+            }
+            remainder[REMWORDS - 1] <<= 1;
+            if (value) {
+
+                for (k=0; k < REMWORDS; k++) {
+
+                    remainder[k] ^= low[k];
+                }
+            }
+        }
+        memcpy(bch.remainders[i], remainder, sizeof(remainder));
+    }
+
+    /* The code of an erased sector is all 0xFF*/
+    memset(bch.erasedCode, 0, sizeof(bch.erasedCode));
+    memset(erased, 0xFF, sizeof(erased));
+    Bch_Compute512x(erased, Bch_SECTORSIZE, strength, bch.erasedCode);
+    for (i=0; i < sizeof(bch.erasedCode); i++) {
+
+        bch.erasedCode[i] ^= 0xFF;
+    }
+}
+
+/**
+ * \brief Computes the remainder of a sector times x^numBits divided by the
+ * generator polynomial.
+ *
+ * \param data  Sector data.
+ * \param remainder  Remainder, MSB aligned.
+ */
+static void ComputeRemainder(const unsigned char *data, unsigned int *remainder)
+{
+    const unsigned int *entry;
+    unsigned int i;
+
+    memset(remainder, 0, REMWORDS * sizeof(unsigned int));
+    if (bch.numWords <= 2) {
+
+        for (i=0; i < Bch_SECTORSIZE; i++) {
+
+            entry = bch.remainders[(remainder[0] >> 24) ^ data[i]];
+            remainder[0] = ((remainder[0] << 8) | (remainder[1] >> 24)) ^ entry[0];
+            remainder[1] = (remainder[1] << 8) ^ entry[1];
+        }
+    }
+    else {
+
+        for (i=0; i < Bch_SECTORSIZE; i++) {
+
+            entry = bch.remainders[(remainder[0] >> 24) ^ data[i]];
+            remainder[0] = ((remainder[0] << 8) | (remainder[1] >> 24)) ^ entry[0];
+            remainder[1] = ((remainder[1] << 8) | (remainder[2] >> 24)) ^ entry[1];
+            remainder[2] = ((remainder[2] << 8) | (remainder[3] >> 24)) ^ entry[2];
+            remainder[3] = (remainder[3] << 8) ^ entry[3];
+        }
+    }
+}
+
+/**
+ * \brief Finds and corrects the bit errors of a sector.
+ *
+ * \param data  Sector data.
+ * \param difference  Computed code XOR stored code (the remainder of the
+ * received codeword).
+ * \return the number of corrected bits; or -1 if they cannot be corrected.
+ */
+static signed int Correct(unsigned char *data, const unsigned char *difference)
+{
+    unsigned char t = bch.strength;
+    unsigned short syndromes[2 * Bch_MAXSTRENGTH + 1];
+    unsigned short locator[2 * Bch_MAXSTRENGTH + 1];
+    unsigned short previous[2 * Bch_MAXSTRENGTH + 1];
+    unsigned short saved[2 * Bch_MAXSTRENGTH + 1];
+    unsigned short terms[Bch_MAXSTRENGTH + 1];
+    unsigned int positions[Bch_MAXSTRENGTH];
+    unsigned int length = Bch_SECTORSIZE * 8 + bch.numBits;
+    unsigned short discrepancy, scale, lastDiscrepancy = 1;
+    unsigned short sum;
+    unsigned int numErrors = 0, shift = 1;
+    unsigned int i, j, bit, position;
+
+    /* Odd syndromes: remainder evaluated at alpha^j (Horner), even ones are
+       squares*/
+    for (j=1; j <= 2 * (unsigned int) t; j += 2) {
+
+        sum = 0;
+        for (i=0; i < bch.numBits; i++) {
+
+            bit = (difference[i / 8] >> (7 - (i % 8))) & 1;
+            sum = MulAlpha(sum, j) ^ bit;
+        }
+        syndromes[j] = sum;
+        syndromes[j + 1] = 0;
+    }
+    for (j=2; j <= 2 * (unsigned int) t; j += 2) {
+
+        syndromes[j] = GfMul(syndromes[j / 2], syndromes[j / 2]);
+    }
+
+    /* Berlekamp-Massey*/
+    memset(locator, 0, sizeof(locator));
+    memset(previous, 0, sizeof(previous));
+    locator[0] = 1;
+    previous[0] = 1;
+    for (i=0; i < 2 * (unsigned int) t; i++) {
+
+        discrepancy = syndromes[i + 1];
+        for (j=1; j <= numErrors; j++) {
+
+            discrepancy ^= GfMul(locator[j], syndromes[i + 1 - j]);
+        }
+        if (!discrepancy) {
+
+            shift++;
+            continue;
+        }
+        scale = GfMul(discrepancy, GfPow(lastDiscrepancy, GF_N - 1));
+        memcpy(saved, locator, sizeof(saved));
+        for (j=shift; j <= 2 * (unsigned int) t; j++) {
+
+            locator[j] ^= GfMul(scale, previous[j - shift]);
+        }
+        if (2 * numErrors <= i) {
+
+            numErrors = i + 1 - numErrors;
+            memcpy(previous, saved, sizeof(previous));
+            lastDiscrepancy = discrepancy;
+            shift = 1;
+        }
+        else {
+
+            shift++;
+        }
+    }
+    if (numErrors > t) {
+
+        return -1;
+    }
+
+    /* Chien search: the error positions p are the roots alpha^-p, tried
+       from the first data bit (degree length - 1) down to the last check bit*/
+    for (j=0; j <= numErrors; j++) {
+
+        terms[j] = GfMul(locator[j], GfPow(2, j * (GF_N - (length - 1))));
+    }
+    i = 0;
+    for (position=length; position-- > 0;) {
+
+        sum = 0;
+        for (j=0; j <= numErrors; j++) {
+
+            sum ^= terms[j];
+        }
+        if (!sum) {
+
+            positions[i++] = position;
+            if (i == numErrors) {
+
+                break;
+            }
+        }
+        for (j=1; j <= numErrors; j++) {
+
+            terms[j] = MulAlpha(terms[j], j);
+        }
+    }
+    if (i != numErrors) {
+
+        return -1;
+    }
+
+    /* Errors in the check bits do not need a correction*/
+    for (i=0; i < numErrors; i++) {
+
+        if (positions[i] >= bch.numBits) {
+
+            bit = length - 1 - positions[i];
+            data[bit / 8] ^= 1 << (7 - (bit % 8));
+        }
+    }
+
+    return numErrors;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Computes the BCH code of each 512-byte sector of a buffer.
+ *
+ * \param data  Data buffer.
+ * \param size  Size of the buffer, a multiple of 512 bytes.
+ * \param strength  Number of bit errors corrected per sector
+ *                  (1 to Bch_MAXSTRENGTH).
+ * \param code  Buffer where the codes are stored, Bch_ECCBYTES(strength)
+ *              bytes per sector.
+ */
+void Bch_Compute512x(
+    const unsigned char *data,
+    unsigned int size,
+    unsigned char strength,
+    unsigned char *code)
+{
+    unsigned int remainder[REMWORDS];
+    unsigned char numBytes = Bch_ECCBYTES(strength);
+    unsigned char i;
+
+    assert( (size % Bch_SECTORSIZE) == 0 ) ;
+    if (bch.strength != strength) {
+
+        BuildTables(strength);
+    }
+
+    while (size > 0) {
+
+        ComputeRemainder(data, remainder);
+        for (i=0; i < numBytes; i++) {
+
+            code[i] = (remainder[i / 4] >> (24 - 8 * (i % 4))) ^ bch.erasedCode[i];
+        }
+        data += Bch_SECTORSIZE;
+        code += numBytes;
+        size -= Bch_SECTORSIZE;
+    }
+}
+
+/**
+ * \brief Verifies and corrects each 512-byte sector of a buffer using the
+ * codes computed by Bch_Compute512x.
+ *
+ * \param data  Data buffer, corrected in place.
+ * \param size  Size of the buffer, a multiple of 512 bytes.
+ * \param strength  Number of bit errors corrected per sector.
+ * \param code  Stored codes, Bch_ECCBYTES(strength) bytes per sector.
+ * \return 0 if the data is correct, Bch_ERROR_CORRECTED if bit errors have
+ * been corrected, or Bch_ERROR_UNCORRECTABLE.
+ */
+unsigned char Bch_Verify512x(
+    unsigned char *data,
+    unsigned int size,
+    unsigned char strength,
+    const unsigned char *code)
+{
+    unsigned char computed[Bch_ECCBYTES(Bch_MAXSTRENGTH)];
+    unsigned char numBytes = Bch_ECCBYTES(strength);
+    unsigned char padding = (numBytes * 8) - (13 * strength);
+    unsigned char result = 0;
+    unsigned char different;
+    signed int numErrors;
+    unsigned char i;
+
+    while (size > 0) {
+
+        /* Early out on the sectors without error*/
+        Bch_Compute512x(data, Bch_SECTORSIZE, strength, computed);
+        for (i=0; i < numBytes; i++) {
+
+            computed[i] ^= code[i];
+        }
+        computed[numBytes - 1] &= 0xFF << padding;
+        different = 0;
+        for (i=0; i < numBytes; i++) {
+
+            different |= computed[i];
+        }
+
+        if (different) {
+
+            numErrors = Correct(data, computed);
+            if (numErrors < 0) {
+
+                TRACE_DEBUG("Bch_Verify512x: uncorrectable sector\n\r");
+                return Bch_ERROR_UNCORRECTABLE;
+            }
+            TRACE_DEBUG("Bch_Verify512x: %d bit(s) corrected\n\r", numErrors);
+            result = Bch_ERROR_CORRECTED;
+        }
+        data += Bch_SECTORSIZE;
+        code += numBytes;
+        size -= Bch_SECTORSIZE;
+    }
+
+    return result;
+}
@@ -41,6 +41,9 @@
  * -# EccNandFlash_ReadPage is uese to read a Nandflash page with ecc check, the function
  *      will read out data and spare first, then it calculates ecc with data and then compare with
  *      the readout ecc, and feedback the ecc check result to dl driver.
+ *
+ * The software ECC is a 1-bit Hamming code per 256 bytes (hamming.c), or a BCH code per 512
+ * bytes (Bch.c) when the eccStrength of the spare scheme of the model is not 0.
  */
 
 /*----------------------------------------------------------------------------
@@ -65,6 +68,13 @@
 #define MODEL(ecc)  ((struct NandFlashModel *) ecc)
 #define RAW(ecc)    ((struct RawNandFlash *) ecc)
 
+/*----------------------------------------------------------------------------
+ *        Exported variables
+ *----------------------------------------------------------------------------*/
+
+/** Counters of the nandflash layers*/
+struct NandStats nandStats;
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -97,7 +107,27 @@ unsigned char EccNandFlash_Initialize(
                                  dataAddress,
                                  pinChipEnable,
                                  pinReadyBusy);
-#if defined(HARDWARE_ECC)
+#if !defined(HARDWARE_ECC)
+    if (!rc && NandFlashModel_GetScheme(MODEL(ecc))->eccStrength) {
+
+        const struct NandSpareScheme *scheme = NandFlashModel_GetScheme(MODEL(ecc));
+        unsigned short pageDataSize = NandFlashModel_GetPageDataSize(MODEL(ecc));
+
+        if ((scheme->eccStrength > Bch_MAXSTRENGTH)
+            || (pageDataSize % Bch_SECTORSIZE)
+            || (scheme->numEccBytes < (pageDataSize / Bch_SECTORSIZE)
+                                      * Bch_ECCBYTES(scheme->eccStrength))) {
+
+            TRACE_ERROR("EccNandFlash_Initialize: Spare scheme not compatible with BCH ECC\n\r");
+            return NandCommon_ERROR_ECC_NOT_COMPATIBLE;
+        }
+    }
+#else
+    if (NandFlashModel_GetScheme(MODEL(ecc))->eccStrength) {
+
+        TRACE_ERROR("EccNandFlash_Initialize: BCH ECC not supported by the controller\n\r");
+        return NandCommon_ERROR_ECC_NOT_COMPATIBLE;
+    }
     {   unsigned int ecc_page;
         switch(NandFlashModel_GetPageDataSize(MODEL(ecc))) {
         case  512: ecc_page = AT91C_HSMC4_PAGESIZE_528_Bytes;  break;
@@ -128,7 +158,7 @@ unsigned char EccNandFlash_Initialize(
  * \return 0 if the data has been read and is valid; otherwise returns either
  * NandCommon_ERROR_CORRUPTEDDATA or ...
  */
-unsigned char EccNandFlash_ReadPage(
+static unsigned char ReadPage(
     const struct EccNandFlash *ecc,
     unsigned short block,
     unsigned short page,
@@ -139,7 +169,9 @@ unsigned char EccNandFlash_ReadPage(
     unsigned char error;
 #ifndef HARDWARE_ECC
     unsigned char tmpData[NandCommon_MAXPAGEDATASIZE];
-    unsigned char hamming[NandCommon_MAXSPAREECCBYTES];
+    unsigned char *pData = data ? (unsigned char *) data : tmpData;
+    unsigned char code[NandCommon_MAXSPAREECCBYTES];
+    const struct NandSpareScheme *scheme = NandFlashModel_GetScheme(MODEL(ecc));
 #else
     unsigned char hsiaoInSpare[NandCommon_MAXSPAREECCBYTES];
     unsigned char hsiao[NandCommon_MAXSPAREECCBYTES];
@@ -150,8 +182,9 @@ unsigned char EccNandFlash_ReadPage(
 
     TRACE_DEBUG("EccNandFlash_ReadPage(B#%d:P#%d)\n\r", block, page);
 #ifndef HARDWARE_ECC
-    /* Start by reading the spare and the data */
-    error = RawNandFlash_ReadPage(RAW(ecc), block, page, tmpData, tmpSpare);
+    /* Start by reading the spare and the data, the data straight into the
+       final buffer where it is corrected */
+    error = RawNandFlash_ReadPage(RAW(ecc), block, page, pData, tmpSpare);
     if (error) {
 
         TRACE_ERROR("EccNandFlash_ReadPage: Failed to read page\n\r");
@@ -159,8 +192,21 @@ unsigned char EccNandFlash_ReadPage(
     }
 
     /* Retrieve ECC information from page and verify the data */
-    NandSpareScheme_ReadEcc(NandFlashModel_GetScheme(MODEL(ecc)), tmpSpare, hamming);
-    error = Hamming_Verify256x(tmpData, pageDataSize, hamming);
+    NandSpareScheme_ReadEcc(scheme, tmpSpare, code);
+    if (scheme->eccStrength) {
+
+        error = Bch_Verify512x(pData, pageDataSize, scheme->eccStrength, code);
+        if (error == Bch_ERROR_CORRECTED) {
+
+            TRACE_DEBUG("EccNandFlash_ReadPage: B%d.P%d corrected\n\r", block, page);
+            nandStats.eccCorrected++;
+            error = 0;
+        }
+    }
+    else {
+
+        error = Hamming_Verify256x(pData, pageDataSize, code);
+    }
 #else
     error = RawNandFlash_ReadPage(RAW(ecc), block, page, (unsigned char*)data, tmpSpare);
     if (error) {
@@ -179,18 +225,19 @@ unsigned char EccNandFlash_ReadPage(
                               hsiao,
                               NandFlashModel_GetDataBusWidth(MODEL(ecc)));
 #endif
-    if (error && (error != Hamming_ERROR_SINGLEBIT)) {
+    if (error == Hamming_ERROR_SINGLEBIT) {
+
+        nandStats.eccCorrected++;
+    }
+    else if (error) {
 
         TRACE_ERROR("EccNandFlash_ReadPage: at B%d.P%d Unrecoverable data\n\r",
                     block, page);
+        nandStats.eccFailures++;
         return NandCommon_ERROR_CORRUPTEDDATA;
     }
 #ifndef HARDWARE_ECC
-    /* Copy data and/or spare into final buffers */
-    if (data) {
-
-        memcpy(data, tmpData, pageDataSize);
-    }
+    /* Copy spare into final buffer */
     if (spare) {
 
         memcpy(spare, tmpSpare, pageSpareSize);
@@ -204,6 +251,34 @@ unsigned char EccNandFlash_ReadPage(
     return 0;
 }
 
+/**
+ * \brief  Reads and verifies a page with ReadPage(), under the
+ * PROF_ID_NAND_READPAGE probe.
+ * \param ecc  Pointer to an EccNandFlash instance.
+ * \param block  Number of block to read from.
+ * \param page  Number of page to read inside given block.
+ * \param data  Data area buffer.
+ * \param spare  Spare area buffer.
+ * \return 0 if the data has been read and is valid; otherwise returns either
+ * NandCommon_ERROR_CORRUPTEDDATA or ...
+ */
+unsigned char EccNandFlash_ReadPage(
+    const struct EccNandFlash *ecc,
+    unsigned short block,
+    unsigned short page,
+    void *data,
+    void *spare)
+{
+    unsigned char error;
+
+    PROF_Enter(PROF_ID_NAND_READPAGE);
+    nandStats.pageReads++;
+    error = ReadPage(ecc, block, page, data, spare);
+    PROF_Exit(PROF_ID_NAND_READPAGE);
+
+    return error;
+}
+
 /**
  * \brief  Writes the data and/or spare area of a nandflash page, after calculating an
  * ECC for the data area and storing it in the spare. If no data buffer is
@@ -229,7 +304,8 @@ unsigned char EccNandFlash_WritePage(
     unsigned short pageDataSize = NandFlashModel_GetPageDataSize(MODEL(ecc));
     unsigned short pageSpareSize = NandFlashModel_GetPageSpareSize(MODEL(ecc));
 #ifndef HARDWARE_ECC
-    unsigned char hamming[NandCommon_MAXSPAREECCBYTES];
+    unsigned char code[NandCommon_MAXSPAREECCBYTES];
+    const struct NandSpareScheme *scheme = NandFlashModel_GetScheme(MODEL(ecc));
 #else
     unsigned char hsiao[NandCommon_MAXSPAREECCBYTES];
 #endif
@@ -237,14 +313,20 @@ unsigned char EccNandFlash_WritePage(
     assert( (data != NULL) || (spare != NULL) ) ;
 //    TRACE_DEBUG(  "EccNandFlash_WritePage: At least one area must be written\n\r" ) ;
     TRACE_DEBUG("EccNandFlash_WritePage(B#%d:P#%d)\n\r", block, page);
+    nandStats.pageWrites++;
 #ifndef HARDWARE_ECC
     /* Compute ECC on the new data, if provided */
-    /* If not provided, hamming code set to 0xFFFF.. to keep existing bytes */
-    memset(hamming, 0xFF, NandCommon_MAXSPAREECCBYTES);
-    if (data) {
+    /* If not provided, code set to 0xFFFF.. to keep existing bytes */
+    memset(code, 0xFF, NandCommon_MAXSPAREECCBYTES);
+    if (data && scheme->eccStrength) {
+
+        /* Compute BCH code on data */
+        Bch_Compute512x(data, pageDataSize, scheme->eccStrength, code);
+    }
+    else if (data) {
 
         /* Compute hamming code on data */
-        Hamming_Compute256x(data, pageDataSize, hamming);
+        Hamming_Compute256x(data, pageDataSize, code);
     }
 
     /* Store code in spare buffer (if no buffer provided, use a temp. one) */
@@ -253,7 +335,7 @@ unsigned char EccNandFlash_WritePage(
         spare = tmpSpare;
         memset(spare, 0xFF, pageSpareSize);
     }
-    NandSpareScheme_WriteEcc(NandFlashModel_GetScheme(MODEL(ecc)), spare, hamming);
+    NandSpareScheme_WriteEcc(scheme, spare, code);
 
     /* Perform write operation */
     error = RawNandFlash_WritePage(RAW(ecc), block, page, data, spare);
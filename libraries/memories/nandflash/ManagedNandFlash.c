@@ -55,12 +55,67 @@
 #define BADBLOCK        255
 #define GOODBLOCK       254
 
+/** Heaps of the block index*/
+#define HEAP_FREE       0
+#define HEAP_LIVE       1
+#define HEAP_NONE       0xFF
+
+/** Index in heap[] of the given heap entry (the LIVE heap grows downwards)*/
+#define HEAPSLOT(managed, h, i) \
+    ((h) == HEAP_FREE ? (i) : (managed)->sizeInBlocks - 1 - (i))
+/** Block stored in the given heap entry*/
+#define HEAPBLOCK(managed, h, i) \
+    ((managed)->index.heap[HEAPSLOT(managed, h, i)])
+/** Erase count of the block stored in the given heap entry*/
+#define HEAPKEY(managed, h, i) \
+    ((managed)->blockStatuses[HEAPBLOCK(managed, h, i)].eraseCount)
+
+/** Marker at the start of a checkpoint record ("NCKP")*/
+#define CHECKPOINTMAGIC 0x504B434E
+
+/** Header of a checkpoint record. A clean record is followed by the block
+    statuses and the upper layer data, an open record only marks the device
+    as modified. */
+struct CheckpointHeader {
+
+    uint32_t magic;
+    uint32_t sequence;
+    uint16_t state;
+    uint16_t numBlocks;
+    uint32_t tag;
+    uint32_t extraSize;
+    uint32_t crc;
+};
+
 /*----------------------------------------------------------------------------
  *        Local functions
  *----------------------------------------------------------------------------*/
 
 /**
- * \brief  Check if the device is virgin.
+ * \brief  Reads the bad block marker and the block status of a block: only
+ * these bytes of the first page spare area are read, the others are set to
+ * 0xFF.
+ *
+ * \param managed  Pointer to a ManagedNandFlash instance.
+ * \param block  Raw block to read.
+ * \param spare  Pointer to allocated spare area (must be assigned)
+ * \return 0 if successful; otherwise returns a NandCommon_ERROR_xx code.
+ */
+static uint8_t ReadBlockInfo( const struct ManagedNandFlash *managed, uint16_t block, uint8_t* spare )
+{
+    uint8_t start, size ;
+
+    NandSpareScheme_GetInfoRange( NandFlashModel_GetScheme( MODEL( managed ) ),
+                                  sizeof( struct NandBlockStatus ), &start, &size ) ;
+    memset( spare, 0xFF, NandCommon_MAXPAGESPARESIZE ) ;
+
+    return RawNandFlash_ReadSpare( RAW( managed ), block, 0, start, &spare[start], size ) ;
+}
+
+/**
+ * \brief  Check if the device is virgin. The first blocks of the managed area
+ * are checked, as one of the checkpoint blocks may have been left erased by a
+ * power loss.
  *
  * \param managed  Pointer to a ManagedNandFlash instance.
  * \param spare    Pointer to allocated spare area (must be assigned)
@@ -73,34 +128,41 @@ static uint8_t IsDeviceVirgin( const struct ManagedNandFlash *managed, uint8_t*
     const struct NandSpareScheme *scheme =
                             NandFlashModel_GetScheme(MODEL(managed));
     uint16_t baseBlock = managed->baseBlock;
+    uint16_t block;
     uint8_t badBlockMarker;
 
     uint8_t error;
 
     assert( spare ) ; /* "ManagedNandFlash_IsDeviceVirgin: spare\n\r" */
 
-    /* Read spare area of page #0. */
-    error = RawNandFlash_ReadPage(RAW(managed), baseBlock, 0, 0, spare);
-    assert( !error ) ; /* "ManagedNandFlash_IsDeviceVirgin: Failed to read page #0\n\r" */
+    for ( block=0 ; (block < NandCheckpoint_AREA) && (block < managed->sizeInBlocks) ; block++ )
+    {
+        /* Read spare area of page #0. */
+        error = ReadBlockInfo(managed, baseBlock + block, spare);
+        assert( !error ) ; /* "ManagedNandFlash_IsDeviceVirgin: Failed to read page #0\n\r" */
 
-    /* Retrieve bad block marker and block status from spare area*/
-    NandSpareScheme_ReadBadBlockMarker(scheme, spare, &badBlockMarker);
-    NandSpareScheme_ReadExtra(scheme, spare, &blockStatus, 4, 0);
+        /* Retrieve bad block marker and block status from spare area*/
+        NandSpareScheme_ReadBadBlockMarker(scheme, spare, &badBlockMarker);
+        NandSpareScheme_ReadExtra(scheme, spare, &blockStatus, 4, 0);
 
-    /* Check if block is marked as bad*/
-    if ( badBlockMarker != 0xFF )
-    {
-        /* Device is not virgin, since page #0 is guaranteed to be good*/
-        return 0 ;
-    }
-    /* If device is not virgin, then block status will be set to either
-       FREE, DIRTY or LIVE */
-    else
-    {
-        if ( blockStatus.status != NandBlockStatus_DEFAULT )
+        /* Check if block is marked as bad*/
+        if ( badBlockMarker != 0xFF )
         {
-            /* Device is not virgin */
-            return 0 ;
+            /* Device is not virgin, since page #0 is guaranteed to be good*/
+            if ( block == 0 )
+            {
+                return 0 ;
+            }
+        }
+        /* If device is not virgin, then block status will be set to either
+           FREE, DIRTY, LIVE or CHECKPOINT */
+        else
+        {
+            if ( blockStatus.status != NandBlockStatus_DEFAULT )
+            {
+                /* Device is not virgin */
+                return 0 ;
+            }
         }
     }
 
@@ -180,6 +242,672 @@ static uint8_t WriteBlockStatus( const struct ManagedNandFlash *managed, uint16_
     return RawNandFlash_WritePage( RAW( managed ), block, 0, 0, spare ) ;
 }
 
+/**
+ * \brief  Returns the heap of the block index holding the blocks with the
+ * given status.
+ *
+ * \param status  Block status.
+ * \return HEAP_FREE, HEAP_LIVE or HEAP_NONE.
+ */
+static uint8_t GetHeap( uint8_t status )
+{
+    if ( status == NandBlockStatus_FREE )
+    {
+        return HEAP_FREE ;
+    }
+    if ( status == NandBlockStatus_LIVE )
+    {
+        return HEAP_LIVE ;
+    }
+
+    return HEAP_NONE ;
+}
+
+/**
+ * \brief  Swaps two entries of a heap.
+ *
+ * \param managed  Pointer to a ManagedNandFlash instance.
+ * \param h  Heap (HEAP_FREE or HEAP_LIVE).
+ * \param i  First entry.
+ * \param j  Second entry.
+ */
+static void HeapSwap( struct ManagedNandFlash *managed, uint8_t h, uint16_t i, uint16_t j )
+{
+    uint16_t block = HEAPBLOCK( managed, h, i ) ;
+
+    HEAPBLOCK( managed, h, i ) = HEAPBLOCK( managed, h, j ) ;
+    HEAPBLOCK( managed, h, j ) = block ;
+    managed->index.positions[HEAPBLOCK( managed, h, i )] = i ;
+    managed->index.positions[block] = j ;
+}
+
+/**
+ * \brief  Restores the heap order of an entry, moving it up or down.
+ *
+ * \param managed  Pointer to a ManagedNandFlash instance.
+ * \param h  Heap (HEAP_FREE or HEAP_LIVE).
+ * \param i  Entry to move.
+ */
+static void HeapFix( struct ManagedNandFlash *managed, uint8_t h, uint16_t i )
+{
+    uint16_t size = managed->index.heapSizes[h] ;
+    uint16_t parent, child ;
+
+    /* Move up*/
+    while ( i > 0 )
+    {
+        parent = (i - 1) / 2 ;
+        if ( HEAPKEY( managed, h, parent ) <= HEAPKEY( managed, h, i ) )
+        {
+            break ;
+        }
+        HeapSwap( managed, h, i, parent ) ;
+        i = parent ;
+    }
+
+    /* Move down*/
+    while ( (child = 2 * i + 1) < size )
+    {
+        if ( (child + 1 < size) && (HEAPKEY( managed, h, child + 1 ) < HEAPKEY( managed, h, child )) )
+        {
+            child++ ;
+        }
+        if ( HEAPKEY( managed, h, i ) <= HEAPKEY( managed, h, child ) )
+        {
+            break ;
+        }
+        HeapSwap( managed, h, i, child ) ;
+        i = child ;
+    }
+}
+
+/**
+ * \brief  Adds a block to the index.
+ *
+ * \param managed  Pointer to a ManagedNandFlash instance.
+ * \param block  Block to add, with its current status.
+ */
+static void IndexBlock( struct ManagedNandFlash *managed, uint16_t block )
+{
+    uint8_t status = managed->blockStatuses[block].status ;
+    uint8_t h = GetHeap( status ) ;
+    uint16_t i ;
+
+    managed->index.counts[status]++ ;
+    if ( status == NandBlockStatus_DIRTY )
+    {
+        BITMAP_Set( managed->index.dirtyBlocks, block ) ;
+    }
+    if ( h != HEAP_NONE )
+    {
+        i = managed->index.heapSizes[h]++ ;
+        HEAPBLOCK( managed, h, i ) = block ;
+        managed->index.positions[block] = i ;
+        HeapFix( managed, h, i ) ;
+    }
+}
+
+/**
+ * \brief  Removes a block from the index.
+ *
+ * \param managed  Pointer to a ManagedNandFlash instance.
+ * \param block  Block to remove, with its current status.
+ */
+static void UnindexBlock( struct ManagedNandFlash *managed, uint16_t block )
+{
+    uint8_t status = managed->blockStatuses[block].status ;
+    uint8_t h = GetHeap( status ) ;
+    uint16_t i, last ;
+
+    managed->index.counts[status]-- ;
+    if ( status == NandBlockStatus_DIRTY )
+    {
+        BITMAP_Clear( managed->index.dirtyBlocks, block ) ;
+    }
+    if ( h != HEAP_NONE )
+    {
+        i = managed->index.positions[block] ;
+        last = --managed->index.heapSizes[h] ;
+        if ( i != last )
+        {
+            HeapSwap( managed, h, i, last ) ;
+            HeapFix( managed, h, i ) ;
+        }
+    }
+}
+
+/**
+ * \brief  Rebuilds the block index from the block statuses.
+ *
+ * \param managed  Pointer to a ManagedNandFlash instance.
+ */
+static void BuildIndex( struct ManagedNandFlash *managed )
+{
+    uint16_t block ;
+
+    memset( &(managed->index), 0, sizeof( managed->index ) ) ;
+    for ( block=0 ; block < managed->sizeInBlocks ; block++ )
+    {
+        IndexBlock( managed, block ) ;
+    }
+}
+
+/**
+ * \brief  Changes the status of a block in RAM, keeping the index up to date.
+ * The erase count of a block must not be changed while it is FREE or LIVE.
+ *
+ * \param managed  Pointer to a ManagedNandFlash instance.
+ * \param block  Block to change.
+ * \param status  New block status.
+ */
+static void SetBlockStatus( struct ManagedNandFlash *managed, uint16_t block, uint8_t status )
+{
+    UnindexBlock( managed, block ) ;
+    managed->blockStatuses[block].status = status ;
+    IndexBlock( managed, block ) ;
+}
+
+/**
+ * \brief  Updates a CRC-32 with the given data.
+ *
+ * \param crc  Current CRC value (0xFFFFFFFF to start).
+ * \param pData  Pointer to the data.
+ * \param size  Number of data bytes.
+ * \return the updated CRC value.
+ */
+static uint32_t Crc32( uint32_t crc, const uint8_t *pData, uint32_t size )
+{
+    uint32_t i ;
+
+    while ( size-- )
+    {
+        crc ^= *pData++ ;
+        for ( i=0 ; i < 8 ; i++ )
+        {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1)) ;
+        }
+    }
+
+    return crc ;
+}
+
+/**
+ * \brief  Returns the number of pages of a checkpoint record.
+ *
+ * \param managed  Pointer to a ManagedNandFlash instance.
+ * \param state  Record state (NandCheckpoint_CLEAN or NandCheckpoint_OPEN).
+ * \param extraSize  Size of the upper layer data.
+ * \return the number of pages.
+ */
+static uint32_t GetCheckpointPages( const struct ManagedNandFlash *managed, uint8_t state, uint32_t extraSize )
+{
+    uint8_t pageShift = NandFlashModel_GetPageShift( MODEL( managed ) ) ;
+    uint32_t size = sizeof( struct CheckpointHeader ) ;
+
+    if ( state == NandCheckpoint_CLEAN )
+    {
+        size += managed->sizeInBlocks * sizeof( struct NandBlockStatus ) + extraSize ;
+    }
+
+    return (size + (1 << pageShift) - 1) >> pageShift ;
+}
+
+/**
+ * \brief  Forgets the checkpoint blocks.
+ *
+ * \param managed  Pointer to a ManagedNandFlash instance.
+ */
+static void ResetCheckpoint( struct ManagedNandFlash *managed )
+{
+    uint32_t i ;
+
+    for ( i=0 ; i < NandCheckpoint_NUMBLOCKS ; i++ )
+    {
+        managed->checkpoint.blocks[i] = -1 ;
+    }
+    managed->checkpoint.current = 0 ;
+    managed->checkpoint.state = NandCheckpoint_NONE ;
+    managed->checkpoint.page = 0 ;
+    managed->checkpoint.sequence = 0 ;
+    managed->checkpoint.loadBlock = -1 ;
+}
+
+/**
+ * \brief  Turns FREE or DIRTY blocks at the start of the managed area into
+ * checkpoint blocks, until NandCheckpoint_NUMBLOCKS blocks are available.
+ *
+ * \param managed  Pointer to a ManagedNandFlash instance.
+ * \return 0 if successful; otherwise returns a NandCommon_ERROR_xx code.
+ */
+static uint8_t ClaimCheckpointBlocks( struct ManagedNandFlash *managed )
+{
+    struct NandCheckpoint *checkpoint = &(managed->checkpoint) ;
+    uint8_t spare[NandCommon_MAXPAGESPARESIZE] ;
+    uint16_t block ;
+    uint32_t i ;
+    uint8_t error ;
+
+    for ( i=0 ; i < NandCheckpoint_NUMBLOCKS ; i++ )
+    {
+        if ( checkpoint->blocks[i] != -1 )
+        {
+            continue ;
+        }
+
+        /* Look for a block which can be used*/
+        for ( block=0 ; (block < NandCheckpoint_AREA) && (block < managed->sizeInBlocks) ; block++ )
+        {
+            if ( (managed->blockStatuses[block].status == NandBlockStatus_FREE)
+              || (managed->blockStatuses[block].status == NandBlockStatus_DIRTY) )
+            {
+                break ;
+            }
+        }
+        if ( (block >= NandCheckpoint_AREA) || (block >= managed->sizeInBlocks) )
+        {
+            break ;
+        }
+
+        TRACE_INFO( "ClaimCheckpointBlocks: use block #%d\n\r", block ) ;
+        if ( managed->blockStatuses[block].status == NandBlockStatus_DIRTY )
+        {
+            error = RawNandFlash_EraseBlock( RAW( managed ), managed->baseBlock + block ) ;
+            if ( error )
+            {
+                return error ;
+            }
+            managed->blockStatuses[block].eraseCount++ ;
+            nandStats.blockErases++ ;
+        }
+        SetBlockStatus( managed, block, NandBlockStatus_CHECKPOINT ) ;
+        error = WriteBlockStatus( managed, managed->baseBlock + block, &(managed->blockStatuses[block]), spare ) ;
+        if ( error )
+        {
+            return error ;
+        }
+
+        checkpoint->blocks[i] = block ;
+        if ( checkpoint->blocks[checkpoint->current] == -1 )
+        {
+            checkpoint->current = i ;
+            checkpoint->page = 0 ;
+        }
+    }
+
+    return 0 ;
+}
+
+/**
+ * \brief  Erases the next checkpoint block (the oldest one) and starts writing
+ * the records in it.
+ *
+ * \param managed  Pointer to a ManagedNandFlash instance.
+ * \return 0 if successful; otherwise returns a NandCommon_ERROR_xx code.
+ */
+static uint8_t SwitchCheckpointBlock( struct ManagedNandFlash *managed )
+{
+    struct NandCheckpoint *checkpoint = &(managed->checkpoint) ;
+    uint8_t spare[NandCommon_MAXPAGESPARESIZE] ;
+    uint8_t next = checkpoint->current ;
+    uint16_t block ;
+    uint32_t i ;
+    uint8_t error ;
+
+    for ( i=1 ; i <= NandCheckpoint_NUMBLOCKS ; i++ )
+    {
+        next = (checkpoint->current + i) % NandCheckpoint_NUMBLOCKS ;
+        if ( checkpoint->blocks[next] != -1 )
+        {
+            break ;
+        }
+    }
+    block = checkpoint->blocks[next] ;
+    TRACE_DEBUG( "SwitchCheckpointBlock(%d)\n\r", block ) ;
+
+    if ( checkpoint->loadBlock == block )
+    {
+        checkpoint->loadBlock = -1 ;
+    }
+    error = RawNandFlash_EraseBlock( RAW( managed ), managed->baseBlock + block ) ;
+    if ( error )
+    {
+        TRACE_ERROR( "SwitchCheckpointBlock: Cannot erase block #%d\n\r", block ) ;
+        SetBlockStatus( managed, block, NandBlockStatus_BAD ) ;
+        checkpoint->blocks[next] = -1 ;
+        return error ;
+    }
+    managed->blockStatuses[block].eraseCount++ ;
+    nandStats.blockErases++ ;
+    error = WriteBlockStatus( managed, managed->baseBlock + block, &(managed->blockStatuses[block]), spare ) ;
+    if ( error )
+    {
+        return error ;
+    }
+
+    checkpoint->current = next ;
+    checkpoint->page = 0 ;
+
+    return 0 ;
+}
+
+/**
+ * \brief  Appends a record to the current checkpoint block, switching to the
+ * next block if it does not fit.
+ *
+ * \param managed  Pointer to a ManagedNandFlash instance.
+ * \param state  Record state (NandCheckpoint_CLEAN or NandCheckpoint_OPEN).
+ * \param tag  Upper layer value.
+ * \param extra  Upper layer data, saved in a clean record.
+ * \param extraSize  Size of the upper layer data.
+ * \return 0 if successful; otherwise returns a NandCommon_ERROR_xx code.
+ */
+static uint8_t WriteCheckpointRecord( struct ManagedNandFlash *managed, uint8_t state, uint32_t tag, const void *extra, uint32_t extraSize )
+{
+    struct NandCheckpoint *checkpoint = &(managed->checkpoint) ;
+    uint8_t data[NandCommon_MAXPAGEDATASIZE] ;
+    uint16_t pageDataSize = NandFlashModel_GetPageDataSize( MODEL( managed ) ) ;
+    uint16_t numPages = NandFlashModel_GetBlockSizeInPages( MODEL( managed ) ) ;
+    struct CheckpointHeader header ;
+    const uint8_t *segments[3] ;
+    uint32_t sizes[3] ;
+    const uint8_t *pSource ;
+    uint32_t remaining, offset, copySize, i ;
+    uint16_t block ;
+    uint16_t page ;
+    uint8_t error ;
+
+    if ( state != NandCheckpoint_CLEAN )
+    {
+        extraSize = 0 ;
+    }
+    if ( GetCheckpointPages( managed, state, extraSize ) > numPages )
+    {
+        TRACE_ERROR( "WriteCheckpointRecord: Record does not fit in a block\n\r" ) ;
+        return NandCommon_ERROR_OUTOFBOUNDS ;
+    }
+
+    /* Switch block first, as this updates the block statuses*/
+    if ( checkpoint->page + GetCheckpointPages( managed, state, extraSize ) > numPages )
+    {
+        error = SwitchCheckpointBlock( managed ) ;
+        if ( error )
+        {
+            return error ;
+        }
+    }
+    block = managed->baseBlock + checkpoint->blocks[checkpoint->current] ;
+
+    header.magic = CHECKPOINTMAGIC ;
+    header.sequence = checkpoint->sequence + 1 ;
+    header.state = state ;
+    header.numBlocks = managed->sizeInBlocks ;
+    header.tag = tag ;
+    header.extraSize = extraSize ;
+    header.crc = 0xFFFFFFFF ;
+    segments[0] = (const uint8_t *) &header ;
+    sizes[0] = sizeof( header ) ;
+    segments[1] = (const uint8_t *) managed->blockStatuses ;
+    sizes[1] = 0 ;
+    segments[2] = (const uint8_t *) extra ;
+    sizes[2] = extraSize ;
+    if ( state == NandCheckpoint_CLEAN )
+    {
+        sizes[1] = managed->sizeInBlocks * sizeof( struct NandBlockStatus ) ;
+        header.crc = Crc32( header.crc, segments[1], sizes[1] ) ;
+        header.crc = Crc32( header.crc, segments[2], sizes[2] ) ;
+    }
+
+    /* Write the segments one page after the other*/
+    page = checkpoint->page ;
+    offset = 0 ;
+    memset( data, 0xFF, pageDataSize ) ;
+    for ( i=0 ; i < 3 ; i++ )
+    {
+        pSource = segments[i] ;
+        remaining = sizes[i] ;
+        while ( remaining > 0 )
+        {
+            copySize = min( remaining, pageDataSize - offset ) ;
+            memcpy( &data[offset], pSource, copySize ) ;
+            pSource += copySize ;
+            remaining -= copySize ;
+            offset += copySize ;
+
+            if ( offset == pageDataSize )
+            {
+                error = EccNandFlash_WritePage( ECC( managed ), block, page, data, 0 ) ;
+                if ( error )
+                {
+                    TRACE_ERROR( "WriteCheckpointRecord: Failed to write page #%d\n\r", page ) ;
+                    checkpoint->page = numPages ;
+                    return error ;
+                }
+                page++ ;
+                offset = 0 ;
+                memset( data, 0xFF, pageDataSize ) ;
+            }
+        }
+    }
+    if ( offset > 0 )
+    {
+        error = EccNandFlash_WritePage( ECC( managed ), block, page, data, 0 ) ;
+        if ( error )
+        {
+            TRACE_ERROR( "WriteCheckpointRecord: Failed to write page #%d\n\r", page ) ;
+            checkpoint->page = numPages ;
+            return error ;
+        }
+        page++ ;
+    }
+
+    checkpoint->page = page ;
+    checkpoint->sequence = header.sequence ;
+
+    return 0 ;
+}
+
+/**
+ * \brief  Reads part of a checkpoint record.
+ *
+ * \param managed  Pointer to a ManagedNandFlash instance.
+ * \param block  Raw block holding the record.
+ * \param page  First page of the record.
+ * \param offset  Offset of the data to read in the record.
+ * \param buffer  Data buffer, can be 0.
+ * \param size  Number of bytes to read.
+ * \param pCrc  Pointer to a CRC updated with the data, can be 0.
+ * \return 0 if successful; otherwise returns a NandCommon_ERROR_xx code.
+ */
+static uint8_t ReadCheckpointData( const struct ManagedNandFlash *managed, uint16_t block, uint16_t page,
+                                   uint32_t offset, uint8_t *buffer, uint32_t size, uint32_t *pCrc )
+{
+    uint8_t data[NandCommon_MAXPAGEDATASIZE] ;
+    uint16_t pageDataSize = NandFlashModel_GetPageDataSize( MODEL( managed ) ) ;
+    uint32_t copySize ;
+    uint8_t error ;
+
+    page += offset >> NandFlashModel_GetPageShift( MODEL( managed ) ) ;
+    offset &= pageDataSize - 1 ;
+    while ( size > 0 )
+    {
+        error = EccNandFlash_ReadPage( ECC( managed ), block, page, data, 0 ) ;
+        if ( error )
+        {
+            return error ;
+        }
+
+        copySize = min( size, pageDataSize - offset ) ;
+        if ( buffer )
+        {
+            memcpy( buffer, &data[offset], copySize ) ;
+            buffer += copySize ;
+        }
+        if ( pCrc )
+        {
+            *pCrc = Crc32( *pCrc, &data[offset], copySize ) ;
+        }
+        size -= copySize ;
+        offset = 0 ;
+        page++ ;
+    }
+
+    return 0 ;
+}
+
+/**
+ * \brief  Looks for the checkpoint blocks and their latest record. If it is a
+ * clean record, the block statuses are loaded from it.
+ *
+ * \param managed  Pointer to a ManagedNandFlash instance.
+ * \param spare  Pointer to allocated spare area (must be assigned)
+ * \return 1 if the block statuses have been loaded; otherwise returns 0 and a
+ * full scan of the device is needed.
+ */
+static uint8_t MountCheckpoint( struct ManagedNandFlash *managed, uint8_t *spare )
+{
+    struct NandCheckpoint *checkpoint = &(managed->checkpoint) ;
+    const struct NandSpareScheme *scheme = NandFlashModel_GetScheme( MODEL( managed ) ) ;
+    uint16_t pageDataSize = NandFlashModel_GetPageDataSize( MODEL( managed ) ) ;
+    uint16_t pageSpareSize = NandFlashModel_GetPageSpareSize( MODEL( managed ) ) ;
+    uint16_t numPages = NandFlashModel_GetBlockSizeInPages( MODEL( managed ) ) ;
+    uint8_t data[NandCommon_MAXPAGEDATASIZE] ;
+    struct CheckpointHeader header, latest ;
+    struct NandBlockStatus blockStatus ;
+    uint16_t ends[NandCheckpoint_NUMBLOCKS] ;
+    uint16_t latestPage = 0 ;
+    uint8_t latestIndex = 0 ;
+    uint8_t found = 0 ;
+    uint8_t badBlockMarker ;
+    uint32_t numRecordPages ;
+    uint32_t crc ;
+    uint16_t block, page ;
+    uint32_t i, n ;
+
+    ResetCheckpoint( managed ) ;
+    memset( &latest, 0, sizeof( latest ) ) ;
+
+    /* Find the checkpoint blocks*/
+    n = 0 ;
+    for ( block=0 ; (block < NandCheckpoint_AREA) && (block < managed->sizeInBlocks) && (n < NandCheckpoint_NUMBLOCKS) ; block++ )
+    {
+        if ( ReadBlockInfo( managed, managed->baseBlock + block, spare ) )
+        {
+            continue ;
+        }
+        NandSpareScheme_ReadBadBlockMarker( scheme, spare, &badBlockMarker ) ;
+        NandSpareScheme_ReadExtra( scheme, spare, &blockStatus, 4, 0 ) ;
+        if ( (badBlockMarker == 0xFF) && (blockStatus.status == NandBlockStatus_CHECKPOINT) )
+        {
+            checkpoint->blocks[n++] = block ;
+        }
+    }
+
+    /* Find the latest record*/
+    for ( i=0 ; i < n ; i++ )
+    {
+        page = 0 ;
+        while ( page < numPages )
+        {
+            if ( EccNandFlash_ReadPage( ECC( managed ), managed->baseBlock + checkpoint->blocks[i], page, data, 0 ) )
+            {
+                break ;
+            }
+            memcpy( &header, data, sizeof( header ) ) ;
+            if ( (header.magic != CHECKPOINTMAGIC) || (header.numBlocks != managed->sizeInBlocks) )
+            {
+                break ;
+            }
+            numRecordPages = GetCheckpointPages( managed, header.state, header.extraSize ) ;
+            if ( page + numRecordPages > numPages )
+            {
+                break ;
+            }
+            if ( !found || (header.sequence > latest.sequence) )
+            {
+                found = 1 ;
+                latest = header ;
+                latestIndex = i ;
+                latestPage = page ;
+            }
+            page += numRecordPages ;
+        }
+        ends[i] = page ;
+    }
+
+    /* No record: contents are unknown, start with an erased block*/
+    if ( !found )
+    {
+        checkpoint->page = numPages ;
+        return 0 ;
+    }
+
+    checkpoint->sequence = latest.sequence ;
+    checkpoint->current = latestIndex ;
+    checkpoint->page = ends[latestIndex] ;
+    block = managed->baseBlock + checkpoint->blocks[latestIndex] ;
+
+    if ( latest.state != NandCheckpoint_CLEAN )
+    {
+        TRACE_INFO( "MountCheckpoint: Device not cleanly unmounted\n\r" ) ;
+        checkpoint->page = numPages ;
+        return 0 ;
+    }
+
+    /* Check that nothing has been programmed after the record, like an
+       interrupted 'open' record */
+    if ( checkpoint->page < numPages )
+    {
+        if ( RawNandFlash_ReadPage( RAW( managed ), block, checkpoint->page, data, spare ) )
+        {
+            checkpoint->page = numPages ;
+            return 0 ;
+        }
+        for ( i=0 ; i < pageDataSize ; i++ )
+        {
+            if ( data[i] != 0xFF )
+            {
+                break ;
+            }
+        }
+        for ( n=0 ; (i == pageDataSize) && (n < pageSpareSize) ; n++ )
+        {
+            if ( spare[n] != 0xFF )
+            {
+                break ;
+            }
+        }
+        if ( (i != pageDataSize) || (n != pageSpareSize) )
+        {
+            TRACE_INFO( "MountCheckpoint: Interrupted record\n\r" ) ;
+            checkpoint->page = numPages ;
+            return 0 ;
+        }
+    }
+
+    /* Load the block statuses, and check the CRC of the whole record*/
+    crc = 0xFFFFFFFF ;
+    if ( ReadCheckpointData( managed, block, latestPage, sizeof( header ),
+                             (uint8_t *) managed->blockStatuses,
+                             managed->sizeInBlocks * sizeof( struct NandBlockStatus ), &crc )
+      || ReadCheckpointData( managed, block, latestPage,
+                             sizeof( header ) + managed->sizeInBlocks * sizeof( struct NandBlockStatus ),
+                             0, latest.extraSize, &crc )
+      || (crc != latest.crc) )
+    {
+        TRACE_WARNING( "MountCheckpoint: Corrupted record\n\r" ) ;
+        checkpoint->page = numPages ;
+        return 0 ;
+    }
+
+    checkpoint->state = NandCheckpoint_CLEAN ;
+    checkpoint->loadBlock = checkpoint->blocks[latestIndex] ;
+    checkpoint->loadPage = latestPage ;
+    checkpoint->loadTag = latest.tag ;
+    checkpoint->loadExtraSize = latest.extraSize ;
+
+    return 1 ;
+}
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -259,6 +987,8 @@ uint8_t ManagedNandFlash_Initialize(
 
     managed->baseBlock = baseBlock;
     managed->sizeInBlocks = sizeInBlocks;
+    managed->erasingBlock = -1;
+    ResetCheckpoint(managed);
 
     /* Initialize block statuses */
     /* First, check if device is virgin*/
@@ -303,21 +1033,34 @@ uint8_t ManagedNandFlash_Initialize(
                 return error;
             }
         }
+        BuildIndex(managed);
+
+        /* Reserve the checkpoint blocks */
+        error = ClaimCheckpointBlocks(managed);
+        if (error) {
+
+            TRACE_ERROR("ManagedNandFlash_Initialize: Checkpoint blocks\n\r");
+            return error;
+        }
+    }
+    /* Cleanly unmounted device, the statuses are in the last checkpoint */
+    else if (MountCheckpoint(managed, spare)) {
+
+        TRACE_INFO("Managed, statuses loaded from checkpoint #%u\n\r",
+                   (unsigned int) managed->checkpoint.sequence);
+        BuildIndex(managed);
     }
     else {
 
         TRACE_INFO("Managed, retrieving information ...\n\r");
 
-        /* Retrieve block statuses from their first page spare area
-          (find maximum and minimum wear at the same time) */
-        minEraseCount = 0xFFFFFFFF;
-        maxEraseCount = 0;
+        /* Retrieve block statuses from their first page spare area */
         for ( block=0 ; block < sizeInBlocks; block++ )
         {
             phyBlock = baseBlock + block;
 
             /* Read spare of first page */
-            error = RawNandFlash_ReadPage(RAW(managed), phyBlock, 0, 0, spare);
+            error = ReadBlockInfo(managed, phyBlock, spare);
             if ( error )
             {
 
@@ -340,7 +1083,10 @@ uint8_t ManagedNandFlash_Initialize(
             {
                 if ( blockStatus.status == NandBlockStatus_DEFAULT )
                 {
-                    assert( 0 ) ; /* "Block #%d(%d) is not managed\n\r", block, phyBlock */
+                    /* Erase interrupted by a power loss: erase it again before use */
+                    TRACE_WARNING("Block #%d(%d) is not managed, marked dirty\n\r", block, phyBlock);
+                    managed->blockStatuses[block].status = NandBlockStatus_DIRTY;
+                    managed->blockStatuses[block].eraseCount = 0;
                 }
                 /* Otherwise block status is accurate */
                 else
@@ -350,16 +1096,6 @@ uint8_t ManagedNandFlash_Initialize(
                                 blockStatus.status, blockStatus.eraseCount);
                     managed->blockStatuses[block] = blockStatus;
 
-                    /* Check for min/max erase counts */
-                    if ( blockStatus.eraseCount < minEraseCount )
-                    {
-                        minEraseCount = blockStatus.eraseCount;
-                    }
-                    if ( blockStatus.eraseCount > maxEraseCount )
-                    {
-                        maxEraseCount = blockStatus.eraseCount;
-                    }
-
                     /* Clean block*/
                     /*Release LIVE blocks */
                     /*
@@ -376,48 +1112,31 @@ uint8_t ManagedNandFlash_Initialize(
             }
         }
 
-        /* Display erase count information*/
-        TRACE_ERROR_WP("|--------|------------|--------|--------|--------|\n\r");
-        TRACE_ERROR_WP("|  Wear  |   Count    |  Free  |  Live  | Dirty  |\n\r");
-        TRACE_ERROR_WP("|--------|------------|--------|--------|--------|\n\r");
-
-        for ( eraseCount=minEraseCount ; eraseCount <= maxEraseCount ; eraseCount++ )
-        {
-            uint32_t count = 0 ;
-            uint32_t live = 0 ;
-            uint32_t dirty = 0 ;
-            uint32_t free = 0 ;
-
-            for ( block=0 ; block < sizeInBlocks ; block++ )
-            {
-                if ( (managed->blockStatuses[block].eraseCount == eraseCount) && (managed->blockStatuses[block].status != NandBlockStatus_BAD) )
-                {
-                    count++ ;
+        BuildIndex(managed);
 
-                    switch ( managed->blockStatuses[block].status )
-                    {
-                        case NandBlockStatus_LIVE:
-                            live++ ;
-                        break ;
+        /* Display erase count information*/
+        minEraseCount = 0xFFFFFFFF;
+        maxEraseCount = 0;
+        for (block=0; block < sizeInBlocks; block++) {
 
-                        case NandBlockStatus_DIRTY:
-                            dirty++ ;
-                        break ;
+            if (managed->blockStatuses[block].status != NandBlockStatus_BAD) {
 
-                        case NandBlockStatus_FREE:
-                            free++ ;
-                        break ;
-                    }
-                }
-            }
-
-            if ( count > 0 )
-            {
-                TRACE_ERROR_WP( "|  %4d  |  %8d  |  %4d  |  %4d  |  %4d  |\n\r",
-                          eraseCount, count, free, live, dirty);
+                eraseCount = managed->blockStatuses[block].eraseCount;
+                if (eraseCount < minEraseCount) minEraseCount = eraseCount;
+                if (eraseCount > maxEraseCount) maxEraseCount = eraseCount;
             }
         }
-        TRACE_ERROR_WP("|--------|------------|--------|--------|--------|\n\r");
+        TRACE_INFO_WP("|---------------|--------|--------|--------|--------|\n\r");
+        TRACE_INFO_WP("|     Wear      |  Free  |  Live  | Dirty  |  Bad   |\n\r");
+        TRACE_INFO_WP("|---------------|--------|--------|--------|--------|\n\r");
+        TRACE_INFO_WP("| %5u - %5u |  %4d  |  %4d  |  %4d  |  %4d  |\n\r",
+                      (unsigned int) minEraseCount,
+                      (unsigned int) maxEraseCount,
+                      managed->index.counts[NandBlockStatus_FREE],
+                      managed->index.counts[NandBlockStatus_LIVE],
+                      managed->index.counts[NandBlockStatus_DIRTY],
+                      managed->index.counts[NandBlockStatus_BAD]);
+        TRACE_INFO_WP("|---------------|--------|--------|--------|--------|\n\r");
     }
 
     return 0;
@@ -437,6 +1156,7 @@ uint8_t ManagedNandFlash_AllocateBlock(
     uint16_t block)
 {
     uint8_t spare[NandCommon_MAXPAGESPARESIZE];
+    uint8_t error;
     TRACE_INFO("ManagedNandFlash_AllocateBlock(%d)\n\r", block);
 
     /* Check that block is FREE*/
@@ -445,9 +1165,14 @@ uint8_t ManagedNandFlash_AllocateBlock(
         TRACE_ERROR("ManagedNandFlash_AllocateBlock: Block must be FREE\n\r");
         return NandCommon_ERROR_WRONGSTATUS;
     }
+    error = ManagedNandFlash_InvalidateCheckpoint(managed);
+    if (error) {
+
+        return error;
+    }
 
     /* Change block status to LIVE*/
-    managed->blockStatuses[block].status = NandBlockStatus_LIVE;
+    SetBlockStatus(managed, block, NandBlockStatus_LIVE);
     return WriteBlockStatus(managed,
                             managed->baseBlock + block,
                             &(managed->blockStatuses[block]),
@@ -468,6 +1193,7 @@ uint8_t ManagedNandFlash_ReleaseBlock(
     uint16_t block)
 {
     uint8_t spare[NandCommon_MAXPAGESPARESIZE];
+    uint8_t error;
     TRACE_INFO("ManagedNandFlash_ReleaseBlock(%d)\n\r", block);
 
     /* Check that block is LIVE*/
@@ -476,9 +1202,14 @@ uint8_t ManagedNandFlash_ReleaseBlock(
         TRACE_ERROR("ManagedNandFlash_ReleaseBlock: Block must be LIVE\n\r");
         return NandCommon_ERROR_WRONGSTATUS;
     }
+    error = ManagedNandFlash_InvalidateCheckpoint(managed);
+    if (error) {
+
+        return error;
+    }
 
     /* Change block status to DIRTY*/
-    managed->blockStatuses[block].status = NandBlockStatus_DIRTY;
+    SetBlockStatus(managed, block, NandBlockStatus_DIRTY);
     return WriteBlockStatus(managed,
                             managed->baseBlock + block,
                             &(managed->blockStatuses[block]),
@@ -502,12 +1233,20 @@ uint8_t ManagedNandFlash_EraseBlock(
     uint8_t error;
     TRACE_INFO("ManagedNandFlash_EraseBlock(%d)\n\r", block);
 
+    /* A background erase may complete (and free the block) first*/
+    RawNandFlash_Finish(RAW(managed));
+
     /* Check block status*/
     if (managed->blockStatuses[block].status != NandBlockStatus_DIRTY) {
 
         TRACE_ERROR("ManagedNandFlash_EraseBlock: Block must be DIRTY\n\r");
         return NandCommon_ERROR_WRONGSTATUS;
     }
+    error = ManagedNandFlash_InvalidateCheckpoint(managed);
+    if (error) {
+
+        return error;
+    }
 
     /* Erase block*/
     error = RawNandFlash_EraseBlock(RAW(managed), phyBlock);
@@ -517,14 +1256,39 @@ uint8_t ManagedNandFlash_EraseBlock(
     }
 
     /* Update block status*/
-    managed->blockStatuses[block].status = NandBlockStatus_FREE;
     managed->blockStatuses[block].eraseCount++;
+    nandStats.blockErases++;
+    SetBlockStatus(managed, block, NandBlockStatus_FREE);
     return WriteBlockStatus(managed,
                             phyBlock,
                             &(managed->blockStatuses[block]),
                             spare);
 }
 
+/**
+ * \brief Marks a DIRTY block as LIVE again, in RAM only, when the mapping
+ * found at mount shows it still holds valid data (its release has not been
+ * committed).
+ *
+ * \param managed  Pointer to a ManagedNandFlash instance.
+ * \param block  Block to restore, in managed area.
+ * \return 0 if successful; otherwise returns NandCommon_ERROR_WRONGSTATUS if
+ * the block is not DIRTY.
+ */
+uint8_t ManagedNandFlash_RestoreBlock(
+    struct ManagedNandFlash *managed,
+    uint16_t block)
+{
+    if (managed->blockStatuses[block].status != NandBlockStatus_DIRTY) {
+
+        TRACE_ERROR("ManagedNandFlash_RestoreBlock: Block must be DIRTY\n\r");
+        return NandCommon_ERROR_WRONGSTATUS;
+    }
+
+    SetBlockStatus(managed, block, NandBlockStatus_LIVE);
+    return 0;
+}
+
 /**
  * \brief  Reads the data and/or the spare area of a page on a managed nandflash. If
  * the data pointer is not 0, then the block MUST be LIVE.
@@ -613,6 +1377,7 @@ uint8_t ManagedNandFlash_CopyPage(
     uint8_t error;
 
     assert( (sourcePage & 1) == (destPage & 1) ) ; /* "ManagedNandFlash_CopyPage: source & dest pages must have the same parity\n\r" */
+    nandStats.pageCopies++;
 
     TRACE_INFO("ManagedNandFlash_CopyPage(B#%d:P#%d -> B#%d:P#%d)\n\r",
               sourceBlock, sourcePage, destBlock, destPage);
@@ -698,6 +1463,7 @@ uint8_t ManagedNandFlash_CopyBlock(
     assert( sourceBlock != destBlock ) ; /* "ManagedNandFlash_CopyBlock: Source block must be different from dest. block\n\r" */
 
     TRACE_INFO( "ManagedNandFlash_CopyBlock(B#%d->B#%d)\n\r", sourceBlock, destBlock ) ;
+    nandStats.blockCopies++ ;
 
     /* Copy all pages*/
     for ( page=0 ; page < numPages ; page++ )
@@ -722,26 +1488,105 @@ uint8_t ManagedNandFlash_CopyBlock(
  */
 uint8_t ManagedNandFlash_EraseDirtyBlocks( struct ManagedNandFlash *managed )
 {
-    uint32_t i ;
+    /* Erase all dirty blocks*/
+    return ManagedNandFlash_EraseDirtyBlocksStep( managed, managed->sizeInBlocks ) ;
+}
+
+/**
+ * \brief Erases at most the given number of DIRTY blocks, so that the erase
+ * time can be spread over several calls.
+ * \param managed  Pointer to a ManagedNandFlash instance.
+ * \param maxBlocks  Maximum number of blocks to erase.
+ * \return 0 if successful; otherwise, returns a NandCommon_ERROR code.
+ */
+uint8_t ManagedNandFlash_EraseDirtyBlocksStep( struct ManagedNandFlash *managed, uint16_t maxBlocks )
+{
+    uint32_t i = 0 ;
     uint8_t error ;
 
-    /* Erase all dirty blocks*/
-    for ( i=0 ; i < managed->sizeInBlocks ; i++ )
+    /* The dirty bitmap skips the other blocks a word at a time */
+    while ( maxBlocks > 0 )
     {
-        if ( managed->blockStatuses[i].status == NandBlockStatus_DIRTY )
+        i = BITMAP_FindFirst( managed->index.dirtyBlocks, i, managed->sizeInBlocks ) ;
+        if ( i == BITMAP_NONE )
         {
-            error = ManagedNandFlash_EraseBlock( managed, i ) ;
+            break ;
+        }
 
-            if ( error )
-            {
-                return error ;
-            }
+        error = ManagedNandFlash_EraseBlock( managed, i ) ;
+        if ( error )
+        {
+            return error ;
         }
+        maxBlocks-- ;
+        i++ ;
     }
 
     return 0 ;
 }
 
+/**
+ * \brief Completion of a background erase: the block becomes FREE, or is
+ * erased again synchronously (with retries) if the erase has failed.
+ * \param argument  Pointer to the ManagedNandFlash instance.
+ * \param status  MED_STATUS_SUCCESS or MED_STATUS_ERROR.
+ */
+static void EraseDirtyBlockCallback( void *argument, uint8_t status, uint32_t transferred, uint32_t remaining )
+{
+    struct ManagedNandFlash *managed = (struct ManagedNandFlash *) argument ;
+    uint16_t block = (uint16_t) managed->erasingBlock ;
+    uint8_t spare[NandCommon_MAXPAGESPARESIZE] ;
+
+    managed->erasingBlock = -1 ;
+    if ( status != MED_STATUS_SUCCESS )
+    {
+        TRACE_WARNING( "ManagedNandFlash: Background erase of block %d failed\n\r", block ) ;
+        ManagedNandFlash_EraseBlock( managed, block ) ;
+
+        return ;
+    }
+
+    managed->blockStatuses[block].eraseCount++ ;
+    nandStats.blockErases++ ;
+    SetBlockStatus( managed, block, NandBlockStatus_FREE ) ;
+    WriteBlockStatus( managed, managed->baseBlock + block, &(managed->blockStatuses[block]), spare ) ;
+}
+
+/**
+ * \brief Starts erasing one DIRTY block in the background and returns while
+ * the device is busy; the block becomes FREE when the erase completes
+ * (see RawNandFlash_Poll). Does nothing if an operation is already running.
+ * \param managed  Pointer to a ManagedNandFlash instance.
+ * \return 0 if successful or if there is nothing to do; otherwise, returns a
+ * NandCommon_ERROR code.
+ */
+uint8_t ManagedNandFlash_StartEraseDirtyBlock( struct ManagedNandFlash *managed )
+{
+    uint32_t i ;
+    uint8_t error ;
+
+    if ( RawNandFlash_Poll( RAW( managed ) ) || (managed->index.counts[NandBlockStatus_DIRTY] == 0) )
+    {
+        return 0 ;
+    }
+
+    i = BITMAP_FindFirst( managed->index.dirtyBlocks, 0, managed->sizeInBlocks ) ;
+    if ( i == BITMAP_NONE )
+    {
+        return 0 ;
+    }
+
+    error = ManagedNandFlash_InvalidateCheckpoint( managed ) ;
+    if ( error )
+    {
+        return error ;
+    }
+
+    managed->erasingBlock = i ;
+
+    return RawNandFlash_StartEraseBlock( RAW( managed ), managed->baseBlock + i, EraseDirtyBlockCallback, managed ) ;
+}
+
 /**
  * \brief Looks for the youngest block having the desired status among the blocks
  * of a managed nandflash. If a block is found, its index is stored inside
@@ -753,29 +1598,42 @@ uint8_t ManagedNandFlash_EraseDirtyBlocks( struct ManagedNandFlash *managed )
  */
 uint8_t ManagedNandFlash_FindYoungestBlock( const struct ManagedNandFlash *managed, uint8_t status, uint16_t *block )
 {
+    uint8_t h = GetHeap( status ) ;
     uint8_t found = 0;
     uint16_t bestBlock = 0;
     uint32_t i;
 
-    /* Go through the block array*/
-    for ( i=0 ; i < managed->sizeInBlocks ; i++ )
+    /* FREE and LIVE blocks: the youngest one is at the top of the heap*/
+    if ( h != HEAP_NONE )
     {
-        /* Check status*/
-        if ( managed->blockStatuses[i].status == status )
+        if ( managed->index.heapSizes[h] > 0 )
         {
-            /* If no block was found, i becomes the best block*/
-            if ( !found )
-            {
-                found = 1;
-                bestBlock = i;
-            }
-            /* Compare the erase counts otherwise*/
-            else
+            found = 1 ;
+            bestBlock = HEAPBLOCK( managed, h, 0 ) ;
+        }
+    }
+    /* Go through the block array otherwise*/
+    else
+    {
+        for ( i=0 ; i < managed->sizeInBlocks ; i++ )
+        {
+            /* Check status*/
+            if ( managed->blockStatuses[i].status == status )
             {
-                if ( managed->blockStatuses[i].eraseCount < managed->blockStatuses[bestBlock].eraseCount )
+                /* If no block was found, i becomes the best block*/
+                if ( !found )
                 {
+                    found = 1;
                     bestBlock = i;
                 }
+                /* Compare the erase counts otherwise*/
+                else
+                {
+                    if ( managed->blockStatuses[i].eraseCount < managed->blockStatuses[bestBlock].eraseCount )
+                    {
+                        bestBlock = i;
+                    }
+                }
             }
         }
     }
@@ -806,19 +1664,105 @@ uint16_t ManagedNandFlash_CountBlocks(
     const struct ManagedNandFlash *managed,
     uint8_t status)
 {
-    uint32_t i;
-    uint16_t count = 0;
+    return managed->index.counts[status & 0xF];
+}
+
+/**
+ * \brief Saves a clean checkpoint record with the block statuses and the given
+ * upper layer data, so that the next mount does not need to scan the device.
+ * The checkpoint blocks are reserved first if needed; if there are none, no
+ * checkpoint is saved.
+ *
+ * \param managed  Pointer to a ManagedNandFlash instance.
+ * \param tag  Upper layer value.
+ * \param extra  Upper layer data, can be 0.
+ * \param extraSize  Size of the upper layer data.
+ * \return 0 if successful; otherwise returns a NandCommon_ERROR code.
+ */
+uint8_t ManagedNandFlash_SaveCheckpoint(
+    struct ManagedNandFlash *managed,
+    uint32_t tag,
+    const void *extra,
+    uint32_t extraSize)
+{
+    uint8_t error;
 
-    /* Examine each block*/
-    for (i=0; i < managed->sizeInBlocks; i++) {
+    TRACE_INFO("ManagedNandFlash_SaveCheckpoint()\n\r");
 
-        if (managed->blockStatuses[i].status == status) {
+    error = ClaimCheckpointBlocks(managed);
+    if (error) {
 
-            count++;
-        }
+        return error;
     }
+    if (managed->checkpoint.blocks[managed->checkpoint.current] == -1) {
 
-    return count;
+        TRACE_DEBUG("ManagedNandFlash_SaveCheckpoint: No checkpoint block\n\r");
+        return 0;
+    }
+
+    error = WriteCheckpointRecord(managed, NandCheckpoint_CLEAN, tag, extra, extraSize);
+    if (error) {
+
+        return error;
+    }
+    managed->checkpoint.state = NandCheckpoint_CLEAN;
+
+    return 0;
+}
+
+/**
+ * \brief Reads the upper layer data of the checkpoint the device has been
+ * mounted from.
+ *
+ * \param managed  Pointer to a ManagedNandFlash instance.
+ * \param tag  Pointer to the upper layer value variable.
+ * \param extra  Upper layer data buffer.
+ * \param extraSize  Size of the upper layer data.
+ * \return 0 if successful; otherwise returns NandCommon_ERROR_NOCHECKPOINT if
+ * the device has not been mounted from a checkpoint holding such data, or a
+ * NandCommon_ERROR code.
+ */
+uint8_t ManagedNandFlash_LoadCheckpoint(
+    const struct ManagedNandFlash *managed,
+    uint32_t *tag,
+    void *extra,
+    uint32_t extraSize)
+{
+    const struct NandCheckpoint *checkpoint = &(managed->checkpoint);
+
+    if ((checkpoint->loadBlock == -1)
+        || (checkpoint->loadExtraSize != extraSize)) {
+
+        return NandCommon_ERROR_NOCHECKPOINT;
+    }
+
+    *tag = checkpoint->loadTag;
+    return ReadCheckpointData(managed,
+                              managed->baseBlock + checkpoint->loadBlock,
+                              checkpoint->loadPage,
+                              sizeof(struct CheckpointHeader)
+                              + managed->sizeInBlocks * sizeof(struct NandBlockStatus),
+                              (uint8_t *) extra, extraSize, 0);
+}
+
+/**
+ * \brief Marks the device as modified since the last clean checkpoint, so
+ * that the next mount scans the device unless a new checkpoint is saved.
+ * Called before any block status change.
+ *
+ * \param managed  Pointer to a ManagedNandFlash instance.
+ * \return 0 if successful; otherwise returns a NandCommon_ERROR code.
+ */
+uint8_t ManagedNandFlash_InvalidateCheckpoint(
+    struct ManagedNandFlash *managed)
+{
+    if (managed->checkpoint.state != NandCheckpoint_CLEAN) {
+
+        return 0;
+    }
+
+    managed->checkpoint.state = NandCheckpoint_OPEN;
+    return WriteCheckpointRecord(managed, NandCheckpoint_OPEN, 0, 0, 0);
 }
 
 /**
@@ -848,6 +1792,8 @@ uint8_t ManagedNandFlash_EraseAll(struct ManagedNandFlash *managed,
     uint8_t error = 0;
 
     if (level == NandEraseFULL) {
+        /* Checkpoint blocks are erased as well*/
+        ResetCheckpoint(managed);
         for (i=0; i < managed->sizeInBlocks; i++) {
             error = RawNandFlash_EraseBlock(RAW(managed),
                                             managed->baseBlock + i);
@@ -859,11 +1805,16 @@ uint8_t ManagedNandFlash_EraseAll(struct ManagedNandFlash *managed,
                 managed->blockStatuses[i].status     = NandBlockStatus_BAD;
                 continue;
             }
+            nandStats.blockErases++;
             managed->blockStatuses[i].status     = NandBlockStatus_FREE;
         }
+        BuildIndex(managed);
     }
     else if (level == NandEraseDATA) {
         for (i=0; i < managed->sizeInBlocks; i++) {
+            if (managed->blockStatuses[i].status == NandBlockStatus_CHECKPOINT) {
+                continue;
+            }
             error = ManagedNandFlash_EraseBlock(managed, i);
             if (error) {
                 TRACE_WARNING("Managed_DataErase: %d(%d)\n\r",
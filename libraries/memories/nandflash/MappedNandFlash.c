@@ -62,14 +62,305 @@
 /** Logical block mapping pattern */
 #define PATTERN(i)      ((i << 1) & 0x73)
 
+/** Marker at the start of a mapping journal record */
+#define JOURNALMAGIC    0x4C4E4A4D
+
+/** Header of a mapping journal record, followed by the deltas and by the
+    upper layer data */
+struct JournalHeader {
+
+    unsigned int magic;
+    unsigned short sequence;
+    unsigned short numDeltas;
+    unsigned int extraSize;
+    /** CRC-32 of the deltas and of the upper layer data */
+    unsigned int crc;
+};
+
+/** New mapping of a logical block */
+struct JournalDelta {
+
+    unsigned short logicalBlock;
+    signed short physicalBlock;
+};
+
 /*----------------------------------------------------------------------------
  *        Local functions
  *----------------------------------------------------------------------------*/
 
+/**
+ * \brief  Updates a CRC-32 with the given data.
+ *
+ * \param crc  Current CRC value (0xFFFFFFFF to start).
+ * \param pData  Pointer to the data.
+ * \param size  Number of data bytes.
+ * \return the updated CRC value.
+ */
+static unsigned int Crc32(unsigned int crc, const unsigned char *pData, unsigned int size)
+{
+    unsigned int i;
+
+    while (size--) {
+
+        crc ^= *pData++;
+        for (i=0; i < 8; i++) {
+
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+
+    return crc;
+}
+
+/**
+ * \brief  Returns the first page of the mapping journal in the logical mapping
+ * block, following the pattern page and the mapping.
+ *
+ * \param mapped  Pointer to a MappedNandFlash instance.
+ * \return the page number.
+ */
+static unsigned short GetJournalFirstPage(const struct MappedNandFlash *mapped)
+{
+    unsigned char pageShift = NandFlashModel_GetPageShift(MODEL(mapped));
+
+    return 1 + ((sizeof(mapped->logicalMapping) + (1 << pageShift) - 1) >> pageShift);
+}
+
+/**
+ * \brief  Starts an empty mapping journal at the given page. The sequence
+ * numbers go on from the previous journal, so that the latest of two mapping
+ * blocks left by a power loss can be told apart.
+ *
+ * \param mapped  Pointer to a MappedNandFlash instance.
+ * \param page  Next page to program in the logical mapping block.
+ */
+static void ResetJournal(struct MappedNandFlash *mapped, unsigned short page)
+{
+    mapped->journal.page = page;
+    mapped->journal.extraSize = 0;
+    mapped->journal.numDeltas = 0;
+}
+
+/**
+ * \brief  Remembers that the mapping of a logical block has changed, so that
+ * the next journal record saves it.
+ *
+ * \param mapped  Pointer to a MappedNandFlash instance.
+ * \param logicalBlock  Logical block number.
+ */
+static void JournalChange(struct MappedNandFlash *mapped, unsigned short logicalBlock)
+{
+    struct MappedNandFlashJournal *journal = &(mapped->journal);
+    unsigned short i;
+
+    /* Already too many changes for a record*/
+    if (journal->numDeltas > MAPPEDNANDFLASH_JOURNALDELTAS) {
+
+        return;
+    }
+    for (i=0; i < journal->numDeltas; i++) {
+
+        if (journal->deltas[i] == logicalBlock) {
+
+            return;
+        }
+    }
+    if (journal->numDeltas < MAPPEDNANDFLASH_JOURNALDELTAS) {
+
+        journal->deltas[journal->numDeltas] = logicalBlock;
+    }
+    journal->numDeltas++;
+}
+
+/**
+ * \brief  Reads part of a mapping journal record.
+ *
+ * \param mapped  Pointer to a MappedNandFlash instance.
+ * \param page  First page of the record.
+ * \param offset  Offset of the data to read in the record.
+ * \param buffer  Data buffer, can be 0.
+ * \param size  Number of bytes to read.
+ * \param pCrc  Pointer to a CRC updated with the data, can be 0.
+ * \return 0 if successful; otherwise returns a NandCommon_ERROR_xxx code.
+ */
+static unsigned char ReadJournalData(
+    const struct MappedNandFlash *mapped,
+    unsigned short page,
+    unsigned int offset,
+    unsigned char *buffer,
+    unsigned int size,
+    unsigned int *pCrc)
+{
+    unsigned char data[NandCommon_MAXPAGEDATASIZE];
+    unsigned short pageDataSize = NandFlashModel_GetPageDataSize(MODEL(mapped));
+    unsigned int copySize;
+    unsigned char error;
+
+    page += offset >> NandFlashModel_GetPageShift(MODEL(mapped));
+    offset &= pageDataSize - 1;
+    while (size > 0) {
+
+        error = ManagedNandFlash_ReadPage(MANAGED(mapped),
+                                          mapped->logicalMappingBlock,
+                                          page,
+                                          data,
+                                          0);
+        if (error) {
+
+            return error;
+        }
+
+        copySize = min(size, pageDataSize - offset);
+        if (buffer) {
+
+            memcpy(buffer, &data[offset], copySize);
+            buffer += copySize;
+        }
+        if (pCrc) {
+
+            *pCrc = Crc32(*pCrc, &data[offset], copySize);
+        }
+        size -= copySize;
+        offset = 0;
+        page++;
+    }
+
+    return 0;
+}
+
+/**
+ * \brief  Applies the records of the mapping journal to the logical mapping
+ * loaded from the logical mapping block (or from the checkpoint), and finds
+ * the end of the journal. A record torn by a power loss ends the journal,
+ * which is then closed: the next save rewrites the whole mapping.
+ *
+ * \param mapped  Pointer to a MappedNandFlash instance.
+ */
+static void ReplayJournal(struct MappedNandFlash *mapped)
+{
+    struct MappedNandFlashJournal *journal = &(mapped->journal);
+    unsigned char data[NandCommon_MAXPAGEDATASIZE];
+    struct JournalHeader header;
+    struct JournalDelta deltas[MAPPEDNANDFLASH_JOURNALDELTAS];
+    unsigned short pageDataSize = NandFlashModel_GetPageDataSize(MODEL(mapped));
+    unsigned short numPages = NandFlashModel_GetBlockSizeInPages(MODEL(mapped));
+    unsigned short numBlocks = ManagedNandFlash_GetDeviceSizeInBlocks(MANAGED(mapped));
+    unsigned short page;
+    unsigned int deltasSize;
+    unsigned int crc;
+    unsigned int i;
+
+    page = GetJournalFirstPage(mapped);
+    ResetJournal(mapped, page);
+    while (page < numPages) {
+
+        if (ManagedNandFlash_ReadPage(MANAGED(mapped),
+                                      mapped->logicalMappingBlock,
+                                      page,
+                                      data,
+                                      0)) {
+
+            break;
+        }
+        memcpy(&header, data, sizeof(header));
+
+        /* An erased page ends the journal*/
+        if (header.magic != JOURNALMAGIC) {
+
+            for (i=0; (i < pageDataSize) && (data[i] == 0xFF); i++);
+            if (i == pageDataSize) {
+
+                journal->page = page;
+                return;
+            }
+            break;
+        }
+
+        /* Check the record, the first one goes on from the previous journal*/
+        if (((page != GetJournalFirstPage(mapped))
+             && (header.sequence != (unsigned short) (journal->sequence + 1)))
+            || (header.numDeltas > MAPPEDNANDFLASH_JOURNALDELTAS)
+            || (header.extraSize > (unsigned int) numPages * pageDataSize)) {
+
+            break;
+        }
+        deltasSize = header.numDeltas * sizeof(struct JournalDelta);
+        crc = 0xFFFFFFFF;
+        if (ReadJournalData(mapped, page, sizeof(header),
+                            (unsigned char *) deltas, deltasSize, &crc)
+            || ReadJournalData(mapped, page, sizeof(header) + deltasSize,
+                               0, header.extraSize, &crc)
+            || (crc != header.crc)) {
+
+            break;
+        }
+
+        /* Apply the changes*/
+        for (i=0; i < header.numDeltas; i++) {
+
+            if ((deltas[i].logicalBlock < numBlocks)
+                && (deltas[i].physicalBlock >= -1)
+                && (deltas[i].physicalBlock < numBlocks)) {
+
+                mapped->logicalMapping[deltas[i].logicalBlock] =
+                    deltas[i].physicalBlock;
+            }
+        }
+        if (header.extraSize > 0) {
+
+            journal->extraPage = page;
+            journal->extraOffset = sizeof(header) + deltasSize;
+            journal->extraSize = header.extraSize;
+        }
+        journal->sequence = header.sequence;
+        page += (sizeof(header) + deltasSize + header.extraSize + pageDataSize - 1)
+                >> NandFlashModel_GetPageShift(MODEL(mapped));
+    }
+
+    if (page < numPages) {
+
+        TRACE_WARNING("ReplayJournal: Journal ends at page #%d\n\r", page);
+    }
+    journal->page = numPages;
+}
+
+/**
+ * \brief  Reads the sequence number of the first mapping journal record of a
+ * logical mapping block.
+ *
+ * \param mapped  Pointer to a MappedNandFlash instance.
+ * \param block  Logical mapping block number.
+ * \param pSequence  Pointer to the sequence number variable.
+ * \return 1 if the block holds a journal record; otherwise returns 0.
+ */
+static unsigned char ReadFirstSequence(
+    const struct MappedNandFlash *mapped,
+    unsigned short block,
+    unsigned short *pSequence)
+{
+    unsigned char data[NandCommon_MAXPAGEDATASIZE];
+    struct JournalHeader header;
+
+    if (ManagedNandFlash_ReadPage(MANAGED(mapped), block,
+                                  GetJournalFirstPage(mapped), data, 0)) {
+
+        return 0;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != JOURNALMAGIC) {
+
+        return 0;
+    }
+    *pSequence = header.sequence;
+
+    return 1;
+}
+
 /**
  * \brief  Scans a mapped nandflash to find an existing logical block mapping. If a
  * block contains the mapping, its index is stored in the provided variable (if
- * pointer is not 0).
+ * pointer is not 0). A power loss before the previous mapping block is
+ * released leaves two of them: the one with the latest journal is used.
  *
  * \param mapped  Pointer to a MappedNandFlash instance.
  * \param logicalMappingBlock  Pointer to a variable for storing the block number.
@@ -82,6 +373,11 @@ static unsigned char FindLogicalMappingBlock(
 {
     unsigned short block;
     unsigned char found;
+    signed short foundBlock = -1;
+    unsigned char foundHasSequence = 0;
+    unsigned short foundSequence = 0;
+    unsigned short sequence = 0;
+    unsigned char hasSequence;
     unsigned short numBlocks = ManagedNandFlash_GetDeviceSizeInBlocks(MANAGED(mapped));
     unsigned short pageDataSize = NandFlashModel_GetPageDataSize(MODEL(mapped));
     unsigned char error;
@@ -91,9 +387,8 @@ static unsigned char FindLogicalMappingBlock(
     TRACE_INFO("FindLogicalMappingBlock()~%d\n\r", numBlocks);
 
     /* Search each LIVE block */
-    found = 0;
     block = 0;
-    while (!found && (block < numBlocks)) {
+    while (block < numBlocks) {
 
         /* Check that block is LIVE*/
         if (MANAGED(mapped)->blockStatuses[block].status == NandBlockStatus_LIVE) {
@@ -115,18 +410,27 @@ static unsigned char FindLogicalMappingBlock(
                     i++;
                 }
 
-                /* If this is the mapping, stop looking*/
+                /* If this is a mapping, keep the latest one*/
                 if (found) {
 
-                    TRACE_WARNING_WP("-I- Logical mapping in block #%d\n\r",
-                                     block);
-                    if (logicalMappingBlock) {
+                    TRACE_INFO("Mapping pattern in block #%d\n\r", block);
+                    hasSequence = ReadFirstSequence(mapped, block, &sequence);
+                    if ((foundBlock == -1)
+                        || (hasSequence
+                            && (!foundHasSequence
+                                || ((signed short) (sequence - foundSequence) > 0)))) {
 
-                        *logicalMappingBlock = block;
+                        foundBlock = block;
+                        foundHasSequence = hasSequence;
+                        foundSequence = sequence;
                     }
-                    return 0;
                 }
             }
+            /* A page #0 torn by a power loss is not a mapping pattern*/
+            else if (error == NandCommon_ERROR_CORRUPTEDDATA) {
+
+                TRACE_WARNING("FindLogicalMappingBlock: Skip block #%d\n\r", block);
+            }
             else if (error != NandCommon_ERROR_WRONGSTATUS) {
 
                 TRACE_ERROR(
@@ -139,6 +443,16 @@ static unsigned char FindLogicalMappingBlock(
         block++;
     }
 
+    if (foundBlock != -1) {
+
+        TRACE_WARNING_WP("-I- Logical mapping in block #%d\n\r", foundBlock);
+        if (logicalMappingBlock) {
+
+            *logicalMappingBlock = foundBlock;
+        }
+        return 0;
+    }
+
     TRACE_WARNING("No logical mapping found in device\n\r");
     return NandCommon_ERROR_NOMAPPING;
 }
@@ -204,7 +518,12 @@ static unsigned char LoadLogicalMapping(
     /* Store mapping block index*/
     mapped->logicalMappingBlock = physicalBlock;
 
-    /* Power-loss recovery*/
+    /* Apply the changes saved since*/
+    ReplayJournal(mapped);
+
+    /* Power-loss recovery. Unmapped LIVE blocks may be used by the upper
+       layer (e.g. log blocks), MappedNandFlash_ReleaseUnmappedBlocks()
+       releases the other ones*/
     for (i=0; i < numBlocks; i++) {
 
         /* Check that this is not the logical mapping block*/
@@ -213,31 +532,19 @@ static unsigned char LoadLogicalMapping(
             status = mapped->managed.blockStatuses[i].status;
             logicalBlock = MappedNandFlash_PhysicalToLogical(mapped, i);
 
-            /* Block is LIVE*/
-            if (status == NandBlockStatus_LIVE) {
-
-                /* Block is not mapped -> release it*/
-                if (logicalBlock == -1) {
-
-                    TRACE_WARNING_WP("-I- Release unmapped LIVE #%d\n\r",
-                                     i);
-                    ManagedNandFlash_ReleaseBlock(MANAGED(mapped), i);
-                }
-            }
             /* Block is DIRTY*/
-            else if (status == NandBlockStatus_DIRTY) {
+            if (status == NandBlockStatus_DIRTY) {
 
                 /* Block is mapped -> fake it as live*/
                 if (logicalBlock != -1) {
 
                     TRACE_WARNING_WP("-I- Mark mapped DIRTY #%d -> LIVE\n\r",
                                      i);
-                    mapped->managed.blockStatuses[i].status =
-                                                    NandBlockStatus_LIVE;
+                    ManagedNandFlash_RestoreBlock(MANAGED(mapped), i);
                 }
             }
             /* Block is FREE or BAD*/
-            else {
+            else if (status != NandBlockStatus_LIVE) {
 
                 /* Block is mapped -> remove it from mapping*/
                 if (logicalBlock != -1) {
@@ -286,6 +593,7 @@ unsigned char MappedNandFlash_Initialize(
     unsigned short numBlocks;
     unsigned short block;
     signed short logicalMappingBlock = 0;
+    unsigned int tag;
 
     TRACE_INFO("MappedNandFlash_Initialize()\n\r");
 
@@ -304,8 +612,28 @@ unsigned char MappedNandFlash_Initialize(
         return error;
     }
 
-    /* Scan to find logical mapping*/
+    /* Cleanly unmounted device, get the mapping from the checkpoint */
     mapped->mappingModified = 0;
+    mapped->journal.sequence = 0;
+    ResetJournal(mapped, 0);
+    numBlocks = ManagedNandFlash_GetDeviceSizeInBlocks(MANAGED(mapped));
+    if (!ManagedNandFlash_LoadCheckpoint(MANAGED(mapped),
+                                         &tag,
+                                         mapped->logicalMapping,
+                                         numBlocks * sizeof(signed short))) {
+
+        mapped->logicalMappingBlock = (signed short) tag;
+        TRACE_INFO("Mapping loaded from checkpoint\n\r");
+
+        /* Find the end of the journal (the records are already applied)*/
+        if (mapped->logicalMappingBlock != -1) {
+
+            ReplayJournal(mapped);
+        }
+        return 0;
+    }
+
+    /* Scan to find logical mapping*/
     error = FindLogicalMappingBlock(mapped, &logicalMappingBlock);
     if (!error) {
 
@@ -317,7 +645,6 @@ unsigned char MappedNandFlash_Initialize(
 
         /* Start with no block mapped*/
         mapped->logicalMappingBlock = -1;
-        numBlocks = ManagedNandFlash_GetDeviceSizeInBlocks(MANAGED(mapped));
         for (block=0; block < numBlocks; block++) {
 
             mapped->logicalMapping[block] = -1;
@@ -453,6 +780,63 @@ unsigned char MappedNandFlash_Map(
     /* Set mapping*/
     mapped->logicalMapping[logicalBlock] = physicalBlock;
     mapped->mappingModified = 1;
+    JournalChange(mapped, logicalBlock);
+
+    return 0;
+}
+
+/**
+ * \brief  Maps a logical block number to a physical block which is already LIVE
+ * (e.g. a block written before being mapped), and releases the previous block
+ * being replaced (if any).
+ * \param mapped  Pointer to a MappedNandFlash instance.
+ * \param logicalBlock  Logical block number to map.
+ * \param physicalBlock  LIVE physical block to map to the logical one.
+ * \return  0 if successful; otherwise returns NandCommon_ERROR_WRONGSTATUS if
+ * the physical block is not LIVE, or a NandCommon_ERROR_xxx code.
+ */
+unsigned char MappedNandFlash_Remap(
+    struct MappedNandFlash *mapped,
+    unsigned short logicalBlock,
+    unsigned short physicalBlock)
+{
+    unsigned char error;
+    signed short oldPhysicalBlock;
+
+    TRACE_INFO("MappedNandFlash_Remap(LB#%d -> PB#%d)\n\r",
+               logicalBlock, physicalBlock);
+    assert( logicalBlock < ManagedNandFlash_GetDeviceSizeInBlocks(MANAGED(mapped)) ) ; /* "MappedNandFlash_Remap: logicalBlock out-of-range\n\r" */
+    assert( physicalBlock < ManagedNandFlash_GetDeviceSizeInBlocks(MANAGED(mapped)) ) ; /* "MappedNandFlash_Remap: physicalBlock out-of-range\n\r" */
+
+    /* Check that block is LIVE*/
+    if (mapped->managed.blockStatuses[physicalBlock].status != NandBlockStatus_LIVE)
+    {
+        TRACE_ERROR("MappedNandFlash_Remap: Block must be LIVE\n\r");
+        return NandCommon_ERROR_WRONGSTATUS;
+    }
+
+    /* The mapping may change without any block status change*/
+    error = ManagedNandFlash_InvalidateCheckpoint(MANAGED(mapped));
+    if ( error )
+    {
+        return error;
+    }
+
+    /* Release currently mapped block (if any)*/
+    oldPhysicalBlock = mapped->logicalMapping[logicalBlock];
+    if ((oldPhysicalBlock != -1) && (oldPhysicalBlock != physicalBlock))
+    {
+        error = ManagedNandFlash_ReleaseBlock(MANAGED(mapped), oldPhysicalBlock);
+        if ( error )
+        {
+            return error;
+        }
+    }
+
+    /* Set mapping*/
+    mapped->logicalMapping[logicalBlock] = physicalBlock;
+    mapped->mappingModified = 1;
+    JournalChange(mapped, logicalBlock);
 
     return 0;
 }
@@ -482,8 +866,17 @@ unsigned char MappedNandFlash_Unmap(
             return error;
         }
     }
+    else {
+
+        error = ManagedNandFlash_InvalidateCheckpoint(MANAGED(mapped));
+        if (error) {
+
+            return error;
+        }
+    }
     mapped->logicalMapping[logicalBlock] = -1;
     mapped->mappingModified = 1;
+    JournalChange(mapped, logicalBlock);
 
     return 0;
 }
@@ -533,18 +926,89 @@ signed short MappedNandFlash_PhysicalToLogical(
     return -1;
 }
 
+/**
+ * \brief  Releases the LIVE blocks which are neither mapped, nor the logical
+ * mapping block, nor in the given list of blocks still used by the upper
+ * layer. Such blocks are left by a power loss between their allocation and
+ * the save of the mapping; must be called once at mount, after the upper
+ * layer has restored its own blocks.
+ *
+ * \param mapped  Pointer to a MappedNandFlash instance.
+ * \param keptBlocks  Physical blocks to keep, -1 entries are ignored.
+ * \param numKept  Number of entries in keptBlocks.
+ * \return  0 if successful; otherwise, returns a NandCommon_ERROR code.
+ */
+unsigned char MappedNandFlash_ReleaseUnmappedBlocks(
+    struct MappedNandFlash *mapped,
+    const signed short *keptBlocks,
+    unsigned char numKept)
+{
+    unsigned char used[(NandCommon_MAXNUMBLOCKS + 7) / 8];
+    unsigned short numBlocks =
+                    ManagedNandFlash_GetDeviceSizeInBlocks(MANAGED(mapped));
+    signed short block;
+    unsigned char error;
+    unsigned short i;
+
+    /* Flag the blocks in use*/
+    memset(used, 0, sizeof(used));
+    for (i=0; i < numBlocks; i++) {
+
+        block = mapped->logicalMapping[i];
+        if (block != -1) {
+
+            used[block / 8] |= 1 << (block % 8);
+        }
+    }
+    for (i=0; i < numKept; i++) {
+
+        block = keptBlocks[i];
+        if ((block >= 0) && (block < numBlocks)) {
+
+            used[block / 8] |= 1 << (block % 8);
+        }
+    }
+    if (mapped->logicalMappingBlock != -1) {
+
+        used[mapped->logicalMappingBlock / 8] |= 1 << (mapped->logicalMappingBlock % 8);
+    }
+
+    for (i=0; i < numBlocks; i++) {
+
+        if ((mapped->managed.blockStatuses[i].status == NandBlockStatus_LIVE)
+            && !((used[i / 8] >> (i % 8)) & 1)) {
+
+            TRACE_WARNING_WP("-I- Release unmapped LIVE #%d\n\r", i);
+            error = ManagedNandFlash_ReleaseBlock(MANAGED(mapped), i);
+            if (error) {
+
+                return error;
+            }
+        }
+    }
+
+    return 0;
+}
+
 /**
  * \brief  Saves the logical mapping on a FREE, unmapped physical block. Allocates the
  * new block, releases the previous one (if any) and save the mapping.
+ * The first record of the new mapping journal holds the given upper layer
+ * data, and is written before the pattern marking the block: a power loss can
+ * not leave a mapping without it.
  *
  * \param mapped  Pointer to a MappedNandFlash instance.
  * \param physicalBlock  Physical block number.
+ * \param extra  Upper layer data, can be 0.
+ * \param extraSize  Size of the upper layer data.
  * \return  0 if successful; otherwise, returns NandCommon_ERROR_WRONGSTATUS
  * if the block is not LIVE, or a NandCommon_ERROR code.
  */
 unsigned char MappedNandFlash_SaveLogicalMapping(
     struct MappedNandFlash *mapped,
-    unsigned short physicalBlock)
+    unsigned short physicalBlock,
+    const void *extra,
+    unsigned int extraSize)
 {
     unsigned char error;
     unsigned char data[NandCommon_MAXPAGEDATASIZE];
@@ -604,6 +1068,16 @@ unsigned char MappedNandFlash_SaveLogicalMapping(
         currentPage++;
     }
 
+    /* The journal starts after the mapping*/
+    ResetJournal(mapped, currentPage);
+    error = MappedNandFlash_AppendJournal(mapped, extra, extraSize);
+    if (error) {
+
+        TRACE_ERROR(
+            "MappedNandFlash_SaveLogicalMapping: Failed to write journal\n\r");
+        return error;
+    }
+
     /* Mark page #0 of block with a distinguishible pattern, so the mapping can
        be retrieved at startup*/
     for (i=0; i < pageDataSize; i++) {
@@ -641,6 +1115,188 @@ unsigned char MappedNandFlash_SaveLogicalMapping(
     return 0;
 }
 
+/**
+ * \brief  Appends a record to the mapping journal of the logical mapping
+ * block, with the logical blocks remapped since the previous record and the
+ * given upper layer data. Much cheaper than saving the whole mapping in a new
+ * block, which the caller must do when the journal is full.
+ *
+ * \param mapped  Pointer to a MappedNandFlash instance.
+ * \param extra  Upper layer data, can be 0.
+ * \param extraSize  Size of the upper layer data.
+ * \return  0 if successful; otherwise returns NandCommon_ERROR_JOURNALFULL if
+ * there is no room left for the record, NandCommon_ERROR_NOMAPPING if no
+ * mapping has been saved yet, or another NandCommon_ERROR code.
+ */
+unsigned char MappedNandFlash_AppendJournal(
+    struct MappedNandFlash *mapped,
+    const void *extra,
+    unsigned int extraSize)
+{
+    struct MappedNandFlashJournal *journal = &(mapped->journal);
+    unsigned char data[NandCommon_MAXPAGEDATASIZE];
+    unsigned short pageDataSize = NandFlashModel_GetPageDataSize(MODEL(mapped));
+    unsigned short numPages = NandFlashModel_GetBlockSizeInPages(MODEL(mapped));
+    struct JournalHeader header;
+    struct JournalDelta deltas[MAPPEDNANDFLASH_JOURNALDELTAS];
+    const unsigned char *segments[3];
+    unsigned int sizes[3];
+    const unsigned char *pSource;
+    unsigned int remaining, offset, copySize, i;
+    unsigned short page;
+    unsigned char error = 0;
+
+    TRACE_INFO("MappedNandFlash_AppendJournal(%d)\n\r", journal->numDeltas);
+
+    if (mapped->logicalMappingBlock == -1) {
+
+        return NandCommon_ERROR_NOMAPPING;
+    }
+    if ((journal->numDeltas > MAPPEDNANDFLASH_JOURNALDELTAS)
+        || (journal->page + ((sizeof(header)
+                              + journal->numDeltas * sizeof(struct JournalDelta)
+                              + extraSize + pageDataSize - 1)
+                             >> NandFlashModel_GetPageShift(MODEL(mapped)))
+            > numPages)) {
+
+        return NandCommon_ERROR_JOURNALFULL;
+    }
+
+    /* Current mapping of the changed blocks*/
+    for (i=0; i < journal->numDeltas; i++) {
+
+        deltas[i].logicalBlock = journal->deltas[i];
+        deltas[i].physicalBlock = mapped->logicalMapping[journal->deltas[i]];
+    }
+
+    header.magic = JOURNALMAGIC;
+    header.sequence = journal->sequence + 1;
+    header.numDeltas = journal->numDeltas;
+    header.extraSize = extraSize;
+    segments[0] = (const unsigned char *) &header;
+    sizes[0] = sizeof(header);
+    segments[1] = (const unsigned char *) deltas;
+    sizes[1] = journal->numDeltas * sizeof(struct JournalDelta);
+    segments[2] = (const unsigned char *) extra;
+    sizes[2] = extraSize;
+    header.crc = Crc32(0xFFFFFFFF, segments[1], sizes[1]);
+    header.crc = Crc32(header.crc, segments[2], sizes[2]);
+
+    /* Write the segments one page after the other*/
+    page = journal->page;
+    offset = 0;
+    memset(data, 0xFF, pageDataSize);
+    for (i=0; (i < 3) && !error; i++) {
+
+        pSource = segments[i];
+        remaining = sizes[i];
+        while (remaining > 0) {
+
+            copySize = min(remaining, pageDataSize - offset);
+            memcpy(&data[offset], pSource, copySize);
+            pSource += copySize;
+            remaining -= copySize;
+            offset += copySize;
+
+            if (offset == pageDataSize) {
+
+                error = ManagedNandFlash_WritePage(MANAGED(mapped),
+                                                   mapped->logicalMappingBlock,
+                                                   page,
+                                                   data,
+                                                   0);
+                if (error) {
+
+                    break;
+                }
+                page++;
+                offset = 0;
+                memset(data, 0xFF, pageDataSize);
+            }
+        }
+    }
+    if (!error && (offset > 0)) {
+
+        error = ManagedNandFlash_WritePage(MANAGED(mapped),
+                                           mapped->logicalMappingBlock,
+                                           page,
+                                           data,
+                                           0);
+        page++;
+    }
+    if (error) {
+
+        /* The journal can not be trusted beyond this page*/
+        TRACE_ERROR("MappedNandFlash_AppendJournal: Failed to write page #%d\n\r", page);
+        journal->page = numPages;
+        return error;
+    }
+
+    if (extraSize > 0) {
+
+        journal->extraPage = journal->page;
+        journal->extraOffset = sizeof(header) + sizes[1];
+        journal->extraSize = extraSize;
+    }
+    journal->page = page;
+    journal->sequence = header.sequence;
+    journal->numDeltas = 0;
+    mapped->mappingModified = 0;
+
+    return 0;
+}
+
+/**
+ * \brief  Reads the upper layer data of the last mapping journal record
+ * holding some.
+ *
+ * \param mapped  Pointer to a MappedNandFlash instance.
+ * \param extra  Upper layer data buffer.
+ * \param extraSize  Size of the upper layer data.
+ * \return  0 if successful; otherwise returns NandCommon_ERROR_NOMAPPING if
+ * the journal holds no such data (or of another size), or another
+ * NandCommon_ERROR code.
+ */
+unsigned char MappedNandFlash_ReadJournalExtra(
+    const struct MappedNandFlash *mapped,
+    void *extra,
+    unsigned int extraSize)
+{
+    if ((mapped->logicalMappingBlock == -1)
+        || (mapped->journal.extraSize == 0)
+        || (mapped->journal.extraSize != extraSize)) {
+
+        return NandCommon_ERROR_NOMAPPING;
+    }
+
+    return ReadJournalData(mapped,
+                           mapped->journal.extraPage,
+                           mapped->journal.extraOffset,
+                           (unsigned char *) extra,
+                           extraSize,
+                           0);
+}
+
+/**
+ * \brief  Saves a checkpoint of the block statuses and of the logical mapping,
+ * so that the next mount does not need to scan the device. Must be called
+ * after the last change until the device is unmounted.
+ *
+ * \param mapped  Pointer to a MappedNandFlash instance.
+ * \return  0 if successful; otherwise, returns a NandCommon_ERROR code.
+ */
+unsigned char MappedNandFlash_SaveCheckpoint(struct MappedNandFlash *mapped)
+{
+    TRACE_INFO("MappedNandFlash_SaveCheckpoint()\n\r");
+
+    return ManagedNandFlash_SaveCheckpoint(
+               MANAGED(mapped),
+               (unsigned short) mapped->logicalMappingBlock,
+               mapped->logicalMapping,
+               ManagedNandFlash_GetDeviceSizeInBlocks(MANAGED(mapped))
+               * sizeof(signed short));
+}
+
 /**
  * \brief  Erase all blocks in the mapped area of nand flash.
  *
@@ -658,6 +1314,8 @@ unsigned char MappedNandFlash_EraseAll(
     if (level > NandEraseDIRTY) {
         mapped->logicalMappingBlock = -1;
         mapped->mappingModified = 0;
+        mapped->journal.sequence = 0;
+        ResetJournal(mapped, 0);
         for (block=0;
              block < ManagedNandFlash_GetDeviceSizeInBlocks(MANAGED(mapped));
              block++) {
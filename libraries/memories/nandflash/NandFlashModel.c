@@ -38,58 +38,6 @@
 
 #include <string.h>
 
-/*----------------------------------------------------------------------------
- *        Local funtion
- *----------------------------------------------------------------------------*/
-/**
- * \brief  Get the power of input, given a certain result, i.e. input^(power) = result.
- *
- * \param result  a certain output we want to calculate.
- * \param input  the input of the power.
- * \return the value of "power" if succesfully find the power.
- */
-#if defined(OP_BOOTSTRAP_on)
-unsigned int CALPOW(unsigned int result, unsigned int input)
-{
-	unsigned int i=0;
-
-	while(i<32)
-	{
-		if(result == (input << i))
-			return i;
-		i++;
-	}
-
-	return 0;
-}
-#endif
-
-/**
- * \brief  Get the interger part of input, given a certain result, i.e.  return = result / input.
- *
- * \param result  a certain output we want to calculate.
- * \param input  the input of the division.
- * \return the value of interger part of the result/input.
- */
-#if defined(OP_BOOTSTRAP_on)
-unsigned int CALINT(unsigned int result, unsigned int input)
-{
-	unsigned int i=0;
-	unsigned int tmpInput=0;
-
-    while(1)
-    {
-    	tmpInput +=input;
-  		i++;
-	    if(tmpInput == result)
-	      return i;
-	    else if (tmpInput > result)
-	      return (i-1);
-    }
-
-}
-#endif
-
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -154,6 +102,10 @@ unsigned char NandFlashModel_Find(
                     model->blockSizeInKBytes = (64) << ((id4 & 0x30) >>4);
 					#endif
                 }
+                if (NandFlashModel_UpdateShifts(model)) {
+
+                    return NandCommon_ERROR_UNKNOWNMODEL;
+                }
                 #if defined(CHIP_NAND_CTRL)
                     switch(model->pageSizeInBytes) {
                         case 1024: pageSize = AT91C_HSMC4_PAGESIZE_1056_Bytes; break;
@@ -185,6 +137,49 @@ unsigned char NandFlashModel_Find(
     }
 }
 
+/**
+ * \brief Caches log2 of the page size and of the number of pages per block of a
+ * model, used by the address translations. To call again after changing
+ * pageSizeInBytes or blockSizeInKBytes.
+ *
+ * \param model  NandFlashModel instance to update.
+ * \return 0 if successful; otherwise returns NandCommon_ERROR_UNKNOWNMODEL if the
+ * sizes are not powers of two, or differ from the fixed geometry.
+ */
+unsigned char NandFlashModel_UpdateShifts(
+    struct NandFlashModel *model)
+{
+    unsigned int blockSize = model->blockSizeInKBytes * 1024;
+    unsigned char pageShift = 0, blockShift = 0;
+
+    while ((1U << pageShift) < model->pageSizeInBytes) {
+
+        pageShift++;
+    }
+    while ((1U << (pageShift + blockShift)) < blockSize) {
+
+        blockShift++;
+    }
+    if (((1U << pageShift) != model->pageSizeInBytes)
+        || ((1U << (pageShift + blockShift)) != blockSize)) {
+
+        TRACE_ERROR("NandFlashModel: Sizes are not powers of two.\n\r");
+        return NandCommon_ERROR_UNKNOWNMODEL;
+    }
+#if defined(NandFlashModel_PAGESHIFT)
+    if ((pageShift != NandFlashModel_PAGESHIFT)
+        || (blockShift != NandFlashModel_BLOCKSHIFT)) {
+
+        TRACE_ERROR("NandFlashModel: Geometry differs from the fixed one.\n\r");
+        return NandCommon_ERROR_UNKNOWNMODEL;
+    }
+#endif
+    model->pageShift = pageShift;
+    model->blockShift = blockShift;
+
+    return 0;
+}
+
 /**
  * \brief Translates address/size access of a NandFlashModel to block, page and offset values.
  *
@@ -214,24 +209,12 @@ unsigned char NandFlashModel_TranslateAccess(
     }
 	#endif
 
-    /* Get Nand info */
-    unsigned int blockSize = NandFlashModel_GetBlockSizeInBytes(model);
-    unsigned int pageSize = NandFlashModel_GetPageDataSize(model);
-
     /* Translate address*/
-    #if !defined(OP_BOOTSTRAP_on)
-    unsigned short tmpBlock = address / blockSize;
-    address -= tmpBlock * blockSize;
-    unsigned short tmpPage = address / pageSize;
-    address -= tmpPage * pageSize;
-    unsigned short tmpOffset = address;
-	#else
-	unsigned short tmpBlock = CALINT(address, blockSize);
-	address -= tmpBlock * blockSize;
-	unsigned short tmpPage = CALINT(address, pageSize);
-	address -= tmpPage * pageSize;
-	unsigned short tmpOffset= address;
-	#endif
+    unsigned char pageShift = NandFlashModel_GetPageShift(model);
+    unsigned char blockShift = NandFlashModel_GetBlockShift(model);
+    unsigned short tmpBlock = address >> (pageShift + blockShift);
+    unsigned short tmpPage = (address >> pageShift) & ((1 << blockShift) - 1);
+    unsigned short tmpOffset = address & ((1 << pageShift) - 1);
 
     /* Save results */
     if (block) {
@@ -281,13 +264,9 @@ unsigned char NandFlashModel_GetDeviceId(
 unsigned short NandFlashModel_GetDeviceSizeInBlocks(
    const struct NandFlashModel *model)
 {
-	#if !defined(OP_BOOTSTRAP_on)
-    return ((1024) / model->blockSizeInKBytes) * model->deviceSizeInMegaBytes;
-	#else
-	unsigned int pow;
-	pow = CALPOW((1024 * model->deviceSizeInMegaBytes), model->blockSizeInKBytes);
-	return (0x1 << pow);
-	#endif
+    /* Size in kB divided by the block size in kB (at least 1 kB)*/
+    return ((unsigned int) model->deviceSizeInMegaBytes << 10)
+           >> (NandFlashModel_GetPageShift(model) + NandFlashModel_GetBlockShift(model) - 10);
 }
 
 /**
@@ -298,8 +277,8 @@ unsigned short NandFlashModel_GetDeviceSizeInBlocks(
 unsigned int NandFlashModel_GetDeviceSizeInPages(
    const struct NandFlashModel *model)
 {
-    return (unsigned int) NandFlashModel_GetDeviceSizeInBlocks(model) //* 8 // HACK
-           * NandFlashModel_GetBlockSizeInPages(model);
+    return (unsigned int) model->deviceSizeInMegaBytes
+           << (20 - NandFlashModel_GetPageShift(model));
 }
 
 /**
@@ -327,88 +306,83 @@ unsigned int NandFlashModel_GetDeviceSizeInMBytes(
 }
 
 /**
- * \brief Returns the number of pages in one single block of a device.
+ * \brief  Returns the size of the spare area of a page in bytes.
  *
  * \param model  Pointer to a NandFlashModel instance.
  */
-unsigned short NandFlashModel_GetBlockSizeInPages(
+unsigned char NandFlashModel_GetPageSpareSize(
    const struct NandFlashModel *model)
 {
-    #if !defined(OP_BOOTSTRAP_on)
-    return model->blockSizeInKBytes * 1024 / model->pageSizeInBytes;
-	#else
-	unsigned int pow;
-	pow = CALPOW((model->blockSizeInKBytes * 1024), model->pageSizeInBytes);
-	return (0x1 << pow);
-	#endif
+    return (model->pageSizeInBytes>>5); /* Spare size is 16/512 of data size */
 }
 
 /**
- * \brief Returns the size in bytes of one single block of a device. This does not
- * take into account the spare zones size.
+ * \brief  Returns the number of bits used by the data bus of a NandFlash device.
  *
  * \param model  Pointer to a NandFlashModel instance.
  */
-unsigned int NandFlashModel_GetBlockSizeInBytes(
+unsigned char NandFlashModel_GetDataBusWidth(
    const struct NandFlashModel *model)
 {
-    return (model->blockSizeInKBytes *1024);
+    return (model->options&NandFlashModel_DATABUS16)? 16: 8;
 }
 
 /**
- * \brief  Returns the size of the data area of a page in bytes.
- * take into account the spare zones size.
+ * \brief  Check if the given NandFlash model uses the "small blocks/pages"
  *
  * \param model  Pointer to a NandFlashModel instance.
+ * \return 1 if the model uses the "small blocks/pages"; otherwise return 0.
  */
-unsigned short NandFlashModel_GetPageDataSize(
+unsigned char NandFlashModel_HasSmallBlocks(
    const struct NandFlashModel *model)
 {
-    return model->pageSizeInBytes;
+    return (model->pageSizeInBytes <= 512 )? 1: 0;
 }
 
 /**
- * \brief  Returns the size of the spare area of a page in bytes.
+ * \brief  Check if if the device supports the copy-back operation.
  *
  * \param model  Pointer to a NandFlashModel instance.
+ * \return 1 if the model supports the copy-back operation; otherwise return 0.
  */
-unsigned char NandFlashModel_GetPageSpareSize(
-   const struct NandFlashModel *model)
+unsigned char NandFlashModel_SupportsCopyBack(
+    const struct NandFlashModel *model)
 {
-    return (model->pageSizeInBytes>>5); /* Spare size is 16/512 of data size */
+    return ((model->options & NandFlashModel_COPYBACK) != 0);
 }
 
 /**
- * \brief  Returns the number of bits used by the data bus of a NandFlash device.
+ * \brief  Check if the device supports the cache program operation.
  *
  * \param model  Pointer to a NandFlashModel instance.
+ * \return 1 if the model supports the cache program operation; otherwise return 0.
  */
-unsigned char NandFlashModel_GetDataBusWidth(
-   const struct NandFlashModel *model)
+unsigned char NandFlashModel_SupportsCacheProgram(
+    const struct NandFlashModel *model)
 {
-    return (model->options&NandFlashModel_DATABUS16)? 16: 8;
+    return ((model->options & NandFlashModel_CACHEPROGRAM) != 0);
 }
 
 /**
- * \brief  Check if the given NandFlash model uses the "small blocks/pages"
+ * \brief  Check if the device supports the sequential cache read operation.
  *
  * \param model  Pointer to a NandFlashModel instance.
- * \return 1 if the model uses the "small blocks/pages"; otherwise return 0.
+ * \return 1 if the model supports the cache read operation; otherwise return 0.
  */
-unsigned char NandFlashModel_HasSmallBlocks(
-   const struct NandFlashModel *model)
+unsigned char NandFlashModel_SupportsCacheRead(
+    const struct NandFlashModel *model)
 {
-    return (model->pageSizeInBytes <= 512 )? 1: 0;
+    return ((model->options & NandFlashModel_CACHEREAD) != 0);
 }
 
 /**
- * \brief  Check if if the device supports the copy-back operation.
+ * \brief  Check if the device supports the two-plane program operation.
  *
  * \param model  Pointer to a NandFlashModel instance.
- * \return 1 if the model supports the copy-back operation; otherwise return 0.
+ * \return 1 if the model supports two-plane programs; otherwise return 0.
  */
-unsigned char NandFlashModel_SupportsCopyBack(
+unsigned char NandFlashModel_SupportsTwoPlanes(
     const struct NandFlashModel *model)
 {
-    return ((model->options & NandFlashModel_COPYBACK) != 0);
+    return ((model->options & NandFlashModel_TWOPLANES) != 0);
 }
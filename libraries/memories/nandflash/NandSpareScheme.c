@@ -44,6 +44,8 @@
  *      spare scheme.
  * -# NandSpareScheme_WriteExtra is used to write extra bytes to spare area using the provided
  *      spare scheme.
+ * -# NandSpareScheme_GetInfoRange is used to know which spare bytes must be read to get
+ *      the bad block marker and the first extra bytes.
  */
 
 /*----------------------------------------------------------------------------
@@ -69,7 +71,9 @@ const struct NandSpareScheme nandSpareScheme256 = {
     /* 4 extra bytes*/
     4,
     /* Extra bytes positions*/
-    {3, 4, 6, 7}
+    {3, 4, 6, 7},
+    /* Hamming ECC*/
+    0
 };
 
 /** Spare area placement scheme for 512 byte pages.*/
@@ -84,7 +88,9 @@ const struct NandSpareScheme nandSpareScheme512 = {
     /* 8 extra bytes*/
     8,
     /* Extra bytes positions*/
-    {8, 9, 10, 11, 12, 13, 14, 15}
+    {8, 9, 10, 11, 12, 13, 14, 15},
+    /* Hamming ECC*/
+    0
 };
 
 /** Spare area placement scheme for 2048 byte pages.*/
@@ -101,7 +107,9 @@ const struct NandSpareScheme nandSpareScheme2048 = {
     38,
     /* Extra bytes positions*/
     { 2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
-     21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39}
+     21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39},
+    /* Hamming ECC*/
+    0
 };
 
 /** Spare area placement scheme for 4096 byte pages.*/
@@ -123,7 +131,111 @@ const struct NandSpareScheme nandSpareScheme4096 = {
      21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39,
      40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58,
      59, 60, 61, 62, 63, 64, 65, 66, 67, 68, 69, 70, 71, 72, 73, 74, 75, 76, 77,
-     78, 79}
+     78, 79},
+    /* Hamming ECC*/
+    0
+};
+
+/** Spare area placement scheme for 512 byte pages with a 4-bit BCH ECC.*/
+const struct NandSpareScheme nandSpareScheme512Bch4 = {
+
+    /* Bad block marker is at position #5*/
+    5,
+    /* 7 ecc bytes*/
+    7,
+    /* Ecc bytes positions*/
+    {0, 1, 2, 3, 4, 6, 7},
+    /* 8 extra bytes*/
+    8,
+    /* Extra bytes positions*/
+    {8, 9, 10, 11, 12, 13, 14, 15},
+    /* BCH ECC, 4 bits per 512 bytes*/
+    4
+};
+
+/** Spare area placement scheme for 2048 byte pages with a 4-bit BCH ECC.*/
+const struct NandSpareScheme nandSpareScheme2048Bch4 = {
+
+    /* Bad block marker is at position #0*/
+    0,
+    /* 28 ecc bytes*/
+    28,
+    /* Ecc bytes positions*/
+    {36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54,
+     55, 56, 57, 58, 59, 60, 61, 62, 63},
+    /* 34 extra bytes*/
+    34,
+    /* Extra bytes positions*/
+    { 2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
+     21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35},
+    /* BCH ECC, 4 bits per 512 bytes*/
+    4
+};
+
+/** Spare area placement scheme for 2048 byte pages with an 8-bit BCH ECC.*/
+const struct NandSpareScheme nandSpareScheme2048Bch8 = {
+
+    /* Bad block marker is at position #0*/
+    0,
+    /* 52 ecc bytes*/
+    52,
+    /* Ecc bytes positions*/
+    {12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30,
+     31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49,
+     50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63},
+    /* 10 extra bytes*/
+    10,
+    /* Extra bytes positions*/
+    { 2,  3,  4,  5,  6,  7,  8,  9, 10, 11},
+    /* BCH ECC, 8 bits per 512 bytes*/
+    8
+};
+
+/** Spare area placement scheme for 4096 byte pages with a 4-bit BCH ECC.*/
+const struct NandSpareScheme nandSpareScheme4096Bch4 = {
+
+    /* Bad block marker is at position #0*/
+    0,
+    /* 56 ecc bytes*/
+    56,
+    /* Ecc bytes positions*/
+    { 72,  73,  74,  75,  76,  77,  78,  79,  80,  81,  82,  83,  84,  85,  86,
+      87,  88,  89,  90,  91,  92,  93,  94,  95,  96,  97,  98,  99, 100, 101,
+     102, 103, 104, 105, 106, 107, 108, 109, 110, 111, 112, 113, 114, 115, 116,
+     117, 118, 119, 120, 121, 122, 123, 124, 125, 126, 127},
+    /* 70 extra bytes*/
+    70,
+    /* Extra bytes positions*/
+    { 2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
+     21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39,
+     40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58,
+     59, 60, 61, 62, 63, 64, 65, 66, 67, 68, 69, 70, 71},
+    /* BCH ECC, 4 bits per 512 bytes*/
+    4
+};
+
+/** Spare area placement scheme for 4096 byte pages with an 8-bit BCH ECC.*/
+const struct NandSpareScheme nandSpareScheme4096Bch8 = {
+
+    /* Bad block marker is at position #0*/
+    0,
+    /* 104 ecc bytes*/
+    104,
+    /* Ecc bytes positions*/
+    { 24,  25,  26,  27,  28,  29,  30,  31,  32,  33,  34,  35,  36,  37,  38,
+      39,  40,  41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  51,  52,  53,
+      54,  55,  56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,
+      69,  70,  71,  72,  73,  74,  75,  76,  77,  78,  79,  80,  81,  82,  83,
+      84,  85,  86,  87,  88,  89,  90,  91,  92,  93,  94,  95,  96,  97,  98,
+      99, 100, 101, 102, 103, 104, 105, 106, 107, 108, 109, 110, 111, 112, 113,
+     114, 115, 116, 117, 118, 119, 120, 121, 122, 123, 124, 125, 126, 127},
+    /* 22 extra bytes*/
+    22,
+    /* Extra bytes positions*/
+    { 2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
+     21, 22, 23},
+    /* BCH ECC, 8 bits per 512 bytes*/
+    8
 };
 
 
@@ -247,3 +359,40 @@ void NandSpareScheme_WriteExtra(
     }
 }
 
+/**
+ * \brief Returns the range of spare bytes holding the bad block marker and
+ * the first extra bytes, so that only these bytes are read from the device.
+ * The range is aligned on 16-bit words.
+ *
+ * \param scheme Pointer to a NandSpareScheme instance.
+ * \param extraSize  Number of extra bytes needed.
+ * \param start  Pointer to the first byte index variable.
+ * \param size  Pointer to the number of bytes variable.
+ */
+void NandSpareScheme_GetInfoRange(
+    const struct NandSpareScheme *scheme,
+    unsigned char extraSize,
+    unsigned char *start,
+    unsigned char *size)
+{
+    unsigned char first = scheme->badBlockMarkerPosition;
+    unsigned char last = scheme->badBlockMarkerPosition;
+    unsigned int i;
+
+    assert( extraSize <= scheme->numExtraBytes ) ; /* "NandSpareScheme_GetInfoRange: Too many bytes\n\r" */
+
+    for (i=0; i < extraSize; i++) {
+
+        if (scheme->extraBytesPositions[i] < first) {
+
+            first = scheme->extraBytesPositions[i];
+        }
+        if (scheme->extraBytesPositions[i] > last) {
+
+            last = scheme->extraBytesPositions[i];
+        }
+    }
+
+    *start = first & ~1;
+    *size = ((last | 1) + 1) - *start;
+}
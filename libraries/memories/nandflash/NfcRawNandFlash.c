@@ -45,7 +45,7 @@
 #include <assert.h>
 #include <string.h>
 
-#if defined(CHIP_NAND_CTRL)
+#if defined(CHIP_NAND_CTRL) && !defined(NAND_SIMULATOR)
 
 /*----------------------------------------------------------------------------
  *        Internal definitions
@@ -515,6 +515,25 @@ static unsigned char CopyPage(
  *         Exported functions
  *----------------------------------------------------------------------------*/
 
+/**
+ * \brief Sets the dies striped by the devices initialized next. The NFC drives
+ * a single die.
+ *
+ * \param pinChipEnables  Chip enable pins of the dies 1 to numDies - 1.
+ * \param numDies  Number of dies, must be 1.
+ * \return 0 if successful; otherwise returns NandCommon_ERROR_UNKNOWNMODEL.
+ */
+unsigned char RawNandFlash_ConfigureDies(const Pin *pinChipEnables, unsigned char numDies)
+{
+    if (numDies != 1) {
+
+        TRACE_ERROR("RawNandFlash_ConfigureDies: %d dies not supported by the NFC.\n\r", numDies);
+        return NandCommon_ERROR_UNKNOWNMODEL;
+    }
+
+    return 0;
+}
+
 /**
  * \brief Initializes a RawNandFlash instance based on the given model and physical interface.
  *
@@ -544,6 +563,7 @@ unsigned char RawNandFlash_Initialize(
     raw->dataAddress = dataAddress;
     raw->pinChipEnable = pinChipEnable;
     raw->pinReadyBusy = pinReadyBusy;
+    raw->numDies = 1;
 
     /* Reset*/
     RawNandFlash_Reset(raw);
@@ -566,6 +586,10 @@ unsigned char RawNandFlash_Initialize(
 
         /* Copy provided model*/
         raw->model = *model;
+        if (NandFlashModel_UpdateShifts(&(raw->model))) {
+
+            return NandCommon_ERROR_UNKNOWNMODEL;
+        }
     }
 
     return 0;
@@ -778,6 +802,271 @@ unsigned char RawNandFlash_WritePage(
     return NandCommon_ERROR_BADBLOCK;
 }
 
+/**
+ * \brief Ready/busy interrupt, not used: the NFC reports the end of the
+ * operations through its own status register.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ */
+void RawNandFlash_ConfigureReadyInterrupt(const struct RawNandFlash *raw)
+{
+    (void)raw;
+}
+
+/**
+ * \brief Not used: the NFC operations, erases included, are blocking.
+ *
+ * \param notify  Function called at the end of the operation.
+ * \param argument  Argument of the function.
+ */
+void RawNandFlash_SetReadyNotify(void (*notify)(void *argument), void *argument)
+{
+    (void)notify;
+    (void)argument;
+}
+
+/**
+ * \brief Erases a block and invokes the callback. The NFC operations are
+ * blocking, the callback is invoked before the function returns.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param block  Number of the physical block to erase.
+ * \param callback  Completion callback, can be 0.
+ * \param argument  Callback argument.
+ * \return 0 if the erase has been started.
+ */
+unsigned char RawNandFlash_StartEraseBlock(
+    const struct RawNandFlash *raw,
+    unsigned short block,
+    MediaCallback callback,
+    void *argument)
+{
+    unsigned char status = MED_STATUS_SUCCESS;
+
+    if (EraseBlock(raw, block)) {
+
+        status = MED_STATUS_ERROR;
+    }
+    if (callback) {
+
+        callback(argument, status, (status == MED_STATUS_SUCCESS), (status != MED_STATUS_SUCCESS));
+    }
+
+    return 0;
+}
+
+/**
+ * \brief No operation runs in the background with the NFC.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \return 0.
+ */
+unsigned char RawNandFlash_Poll(const struct RawNandFlash *raw)
+{
+    (void)raw;
+    return 0;
+}
+
+/**
+ * \brief No operation runs in the background with the NFC.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ */
+void RawNandFlash_Finish(const struct RawNandFlash *raw)
+{
+    (void)raw;
+}
+
+/**
+ * \brief Reads some bytes of the spare area of a page,. The
+ * NFC transfers the whole spare area through its internal SRAM.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param block  Number of the physical block to read.
+ * \param page  Number of the page to read inside the given block.
+ * \param offset  Index of the first spare byte to read (even on 16-bit devices).
+ * \param buffer  Buffer where the bytes will be stored.
+ * \param size  Number of bytes to read (even on 16-bit devices).
+ * \return 0 if successful; otherwise returns an error code.
+ */
+unsigned char RawNandFlash_ReadSpare(
+    const struct RawNandFlash *raw,
+    unsigned short block,
+    unsigned short page,
+    unsigned char offset,
+    void *buffer,
+    unsigned char size)
+{
+    unsigned char spare[NandCommon_MAXPAGESPARESIZE];
+    unsigned char error;
+
+    error = RawNandFlash_ReadPage(raw, block, page, 0, spare);
+    if (!error) {
+
+        memcpy(buffer, &spare[offset], size);
+    }
+
+    return error;
+}
+
+/**
+ * \brief Reads the bad block markers (in the spare area of the first two
+ * pages) of consecutive blocks, and sets the bits of the bad ones in a bitmap.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param firstBlock  Number of the first physical block to check.
+ * \param numBlocks  Number of blocks to check.
+ * \param bitmap  Bitmap of (numBlocks + 7) / 8 bytes, bit (i % 8) of byte
+ * (i / 8) is set if block firstBlock + i is bad.
+ * \return 0 if successful; otherwise returns an error code.
+ */
+unsigned char RawNandFlash_ReadBadBlockMarkers(
+    const struct RawNandFlash *raw,
+    unsigned short firstBlock,
+    unsigned short numBlocks,
+    unsigned char *bitmap)
+{
+    const struct NandSpareScheme *scheme = NandFlashModel_GetScheme(MODEL(raw));
+    unsigned char offset = scheme->badBlockMarkerPosition & ~1;
+    unsigned char markers[2];
+    unsigned char error;
+    unsigned short i;
+    unsigned short page;
+
+    TRACE_DEBUG("RawNandFlash_ReadBadBlockMarkers(B#%d+%d)\r\n", firstBlock, numBlocks);
+
+    memset(bitmap, 0, (numBlocks + 7) / 8);
+    for (i=0; i < numBlocks; i++) {
+
+        for (page=0; page < 2; page++) {
+
+            error = RawNandFlash_ReadSpare(raw, firstBlock + i, page, offset, markers, 2);
+            if (error) {
+
+                return error;
+            }
+            if (markers[scheme->badBlockMarkerPosition & 1] != 0xFF) {
+
+                bitmap[i / 8] |= 1 << (i % 8);
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Reads consecutive pages of a block into the provided buffers. The
+ * NFC transfers whole pages through its internal SRAM, so the pages are read
+ * one after the other.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param block  Number of the physical block to read.
+ * \param page  Number of the first page to read inside the given block.
+ * \param numPages  Number of pages to read (in the same block).
+ * \param data  Buffer where the data areas will be read, one after the other.
+ * \param spare  Buffer where the spare areas will be read, can be 0.
+ * \return 0 if successful; otherwise returns an error code.
+ */
+unsigned char RawNandFlash_ReadPages(
+    const struct RawNandFlash *raw,
+    unsigned short block,
+    unsigned short page,
+    unsigned short numPages,
+    void *data,
+    void *spare)
+{
+    unsigned char *pData = (unsigned char *) data;
+    unsigned char *pSpare = (unsigned char *) spare;
+    unsigned char error;
+    unsigned short i;
+
+    for (i=0; i < numPages; i++) {
+
+        error = RawNandFlash_ReadPage(raw, block, page + i, pData, pSpare);
+        if (error) {
+
+            return error;
+        }
+        pData += NandFlashModel_GetPageDataSize(MODEL(raw));
+        if (pSpare) {
+            pSpare += NandFlashModel_GetPageSpareSize(MODEL(raw));
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Programs consecutive pages of a block, one after the other.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param block  Number of the physical block to write.
+ * \param page  Number of the first page to write inside the given block.
+ * \param numPages  Number of pages to write (in the same block).
+ * \param data  Buffer containing the data areas, one after the other.
+ * \param spare  Buffer containing the spare areas, can be 0.
+ * \return 0 if successful; otherwise returns NandCommon_ERROR_CANNOTWRITE.
+ */
+unsigned char RawNandFlash_WritePages(
+    const struct RawNandFlash *raw,
+    unsigned short block,
+    unsigned short page,
+    unsigned short numPages,
+    void *data,
+    void *spare)
+{
+    unsigned char *pData = (unsigned char *) data;
+    unsigned char *pSpare = (unsigned char *) spare;
+    unsigned short i;
+
+    for (i=0; i < numPages; i++) {
+
+        if (WritePage(raw, block, page + i, pData, pSpare)) {
+
+            return NandCommon_ERROR_CANNOTWRITE;
+        }
+        pData += NandFlashModel_GetPageDataSize(MODEL(raw));
+        if (pSpare) {
+            pSpare += NandFlashModel_GetPageSpareSize(MODEL(raw));
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Programs the same page in the two blocks of a plane pair (block and
+ * block + 1), one after the other.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param block  Number of the even physical block (plane 0).
+ * \param page  Number of the page to write inside the blocks.
+ * \param data  Buffer containing the two data areas, one after the other.
+ * \param spare  Buffer containing the two spare areas, can be 0.
+ * \return 0 if successful; otherwise returns NandCommon_ERROR_CANNOTWRITE.
+ */
+unsigned char RawNandFlash_WritePageTwoPlanes(
+    const struct RawNandFlash *raw,
+    unsigned short block,
+    unsigned short page,
+    void *data,
+    void *spare)
+{
+    unsigned char *pSpare = (unsigned char *) spare;
+
+    if (WritePage(raw, block, page, data, spare)
+        || WritePage(raw, block + 1, page,
+                     (unsigned char *) data + NandFlashModel_GetPageDataSize(MODEL(raw)),
+                     pSpare ? pSpare + NandFlashModel_GetPageSpareSize(MODEL(raw)) : 0)) {
+
+        return NandCommon_ERROR_CANNOTWRITE;
+    }
+
+    return 0;
+}
+
 /**
  * \brief Copy the data in a page of the NandFlash device to an other page on that same chip.
  *
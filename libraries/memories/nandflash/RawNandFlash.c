@@ -35,7 +35,17 @@
  * operate NAND Flash interface.The RawNandFlash layer code implement procedures to program
  * basic NAND Flash operations. It takes care of issuing the correct sequences of write/read
  * operations for each command. All functions in the layer are blocked i.e. they wait for
- * the completion of an operation. RawNandFlash layer access NAND Flash device by SMC.
+ * the completion of an operation, except RawNandFlash_StartEraseBlock which returns while
+ * the device is busy: its completion is reported from RawNandFlash_Poll, or before the next
+ * operation starts. RawNandFlash layer access NAND Flash device by SMC.
+ *
+ * Several identical dies on different chip selects (RawNandFlash_ConfigureDies) are seen as
+ * one device with the same number of blocks, each block being made of the blocks of the same
+ * number on all the dies: page p is page p / numDies of die p % numDies. A block erase erases
+ * the dies at the same time, and consecutive pages read or written by RawNandFlash_ReadPages
+ * and RawNandFlash_WritePages are interleaved: the next page is transferred to (or from) a die
+ * while the others are busy. The status register of the dies is polled, so that they can share
+ * the ready/busy signal.
  *
  */
 
@@ -48,13 +58,15 @@
 #include <string.h>
 #include <assert.h>
 
-#if !defined(CHIP_NAND_CTRL)
+#if !defined(CHIP_NAND_CTRL) && !defined(NAND_SIMULATOR)
 /*----------------------------------------------------------------------------
  *        Internal definitions
  *----------------------------------------------------------------------------*/
 
 /** Nand flash chip status codes*/
 #define STATUS_READY                    (1 << 6)
+#define STATUS_ARRAY_READY              (1 << 5)
+#define STATUS_ERROR_PREVIOUS           (1 << 1)
 #define STATUS_ERROR                    (1 << 0)
 
 /** Nand flash commands*/
@@ -74,6 +86,11 @@
 #define COMMAND_ERASE_2                 0xD0
 #define COMMAND_STATUS                  0x70
 #define COMMAND_RESET                   0xFF
+#define COMMAND_READ_PARAMETER          0xEC
+#define COMMAND_CACHE_READ              0x31
+#define COMMAND_CACHE_READ_END          0x3F
+#define COMMAND_CACHE_WRITE             0x15
+#define COMMAND_PLANE_WRITE             0x11
 
 
 /** Nand flash commands (small blocks)*/
@@ -84,8 +101,18 @@
  *        Internal Macros
  *----------------------------------------------------------------------------*/
 
-#define ENABLE_CE(raw)        PIO_Clear(&(raw->pinChipEnable))
-#define DISABLE_CE(raw)       PIO_Set(&(raw->pinChipEnable))
+/** The SMC is held while the chip enable is asserted (see bus.h)*/
+#define SELECT_CE(raw)        {BUS_Acquire(BUS_SMC); PIO_Clear(&(raw->pinChipEnable));}
+#define DISABLE_CE(raw)       {PIO_Set(&(raw->pinChipEnable)); BUS_Release(BUS_SMC);}
+/** Operations start once the background operation, if any, is over*/
+#define ENABLE_CE(raw)        {FinishPending(raw); SELECT_CE(raw);}
+
+/** Waits for an interrupt while the device is busy, when the ready/busy
+    interrupt is enabled (can be redefined, e.g. to block on an RTOS
+    semaphore given by the interrupt)*/
+#ifndef RAWNANDFLASH_WAIT
+#define RAWNANDFLASH_WAIT()   __WFI()
+#endif
 
 #define WRITE_COMMAND(raw, command) \
     {*((volatile unsigned char *) raw->commandAddress) = (unsigned char) command;}
@@ -114,10 +141,68 @@
 /** Number of tries for copying a block*/
 #define NUMCOPYTRIES            2
 
+/** ONFI parameter page fields*/
+#define ONFI_SIGNATURE          0x49464E4F
+#define ONFI_FEATURES           6
+#define ONFI_OPTIONALCOMMANDS   8
+#define ONFI_PLANEBITS          114
+#define ONFI_FEATURE_PLANES     (1 << 3)
+#define ONFI_COMMAND_CACHEWRITE (1 << 0)
+#define ONFI_COMMAND_CACHEREAD  (1 << 1)
+
+/*----------------------------------------------------------------------------
+ *        Internal variables
+ *----------------------------------------------------------------------------*/
+
+/** Operation running in the background (a single device is driven)*/
+static struct {
+
+    /** Device, 0 if no operation is running*/
+    const struct RawNandFlash *raw;
+    /** Completion callback*/
+    MediaCallback callback;
+    void *argument;
+    /** Block being erased*/
+    unsigned short block;
+    /** Set by the ready/busy interrupt*/
+    volatile unsigned char ready;
+    /** Ready/busy interrupt enabled*/
+    unsigned char interrupt;
+    /** Called by the ready/busy interrupt at the end of the operation*/
+    void (*notify)(void *argument);
+    void *notifyArgument;
+} pending;
+
+/** Dies of the devices initialized next (RawNandFlash_ConfigureDies)*/
+static struct {
+
+    unsigned char numDies;
+    Pin pinChipEnables[RawNandFlash_MAXDIES - 1];
+} dieConfig;
+
 /*----------------------------------------------------------------------------
  *        Internal functions
  *----------------------------------------------------------------------------*/
 
+static void FinishPending(const struct RawNandFlash *raw);
+
+/**
+ * \brief Ready/busy pin interrupt handler, wakes up the waiting code.
+ *
+ * \param pPin  Ready/busy pin.
+ */
+static void ReadyBusyHandler(const Pin *pPin)
+{
+    if (PIO_Get(pPin)) {
+
+        pending.ready = 1;
+        if (pending.raw && pending.notify) {
+
+            pending.notify(pending.notifyArgument);
+        }
+    }
+}
+
 /**
  * \brief Sends the column address to the NandFlash chip.
  *
@@ -182,7 +267,11 @@ static void WriteRowAddress(
 static void WaitReady(const struct RawNandFlash *raw)
 {
     if (raw->pinReadyBusy.mask) {
-        while (!PIO_Get(&(raw->pinReadyBusy)));
+        while (!PIO_Get(&(raw->pinReadyBusy))) {
+            if (pending.interrupt) {
+                RAWNANDFLASH_WAIT();
+            }
+        }
     }
     else {
         WRITE_COMMAND(raw, COMMAND_STATUS);
@@ -277,6 +366,277 @@ static void ReadData(
     }
 }
 
+/**
+ * \brief Fills a single device view of one die of a multi-die device: its
+ * chip enable and the geometry of one die, without ready/busy pin.
+ *
+ * \param raw  Pointer to a RawNandFlash instance with several dies.
+ * \param die  Number of the die.
+ * \param dieRaw  RawNandFlash instance to fill.
+ */
+static void GetDie(
+    const struct RawNandFlash *raw,
+    unsigned char die,
+    struct RawNandFlash *dieRaw)
+{
+    *dieRaw = *raw;
+    dieRaw->numDies = 1;
+    dieRaw->model.deviceSizeInMegaBytes /= raw->numDies;
+    dieRaw->model.blockSizeInKBytes /= raw->numDies;
+    dieRaw->model.blockShift -= RawNandFlash_DIESHIFT(raw->numDies);
+    dieRaw->pinReadyBusy.mask = 0;
+    if (die > 0) {
+
+        dieRaw->pinChipEnable = raw->pinDieChipEnables[die - 1];
+    }
+}
+
+/**
+ * \brief Completes the background operation, then fills the view of the die
+ * holding a page of a multi-die device.
+ *
+ * \param raw  Pointer to a RawNandFlash instance with several dies.
+ * \param page  Number of the page inside its block.
+ * \param dieRaw  RawNandFlash instance to fill.
+ * \return the number of the page inside the block of the die.
+ */
+static unsigned short SelectDie(
+    const struct RawNandFlash *raw,
+    unsigned short page,
+    struct RawNandFlash *dieRaw)
+{
+    FinishPending(raw);
+    GetDie(raw, page % raw->numDies, dieRaw);
+
+    return page / raw->numDies;
+}
+
+/**
+ * \brief Starts erasing a block on every die of a multi-die device.
+ *
+ * \param raw  Pointer to a RawNandFlash instance with several dies.
+ * \param block  Number of the block to erase.
+ */
+static void StartDiesErase(const struct RawNandFlash *raw, unsigned short block)
+{
+    struct RawNandFlash die;
+    const struct RawNandFlash *dieRaw = &die;
+    unsigned char i;
+
+    for (i=0; i < raw->numDies; i++) {
+
+        GetDie(raw, i, &die);
+        SELECT_CE(dieRaw);
+        WRITE_COMMAND(dieRaw, COMMAND_ERASE_1);
+        WriteRowAddress(dieRaw, block * NandFlashModel_GetBlockSizeInPages(MODEL(dieRaw)));
+        WRITE_COMMAND(dieRaw, COMMAND_ERASE_2);
+        DISABLE_CE(dieRaw);
+    }
+}
+
+/**
+ * \brief Waits for the end of the operations of all the dies of a multi-die
+ * device, and checks their status.
+ *
+ * \param raw  Pointer to a RawNandFlash instance with several dies.
+ * \return 1 if the operations are successful; otherwise 0.
+ */
+static unsigned char AreDiesComplete(const struct RawNandFlash *raw)
+{
+    struct RawNandFlash die;
+    const struct RawNandFlash *dieRaw = &die;
+    unsigned char complete = 1;
+    unsigned char i;
+
+    for (i=0; i < raw->numDies; i++) {
+
+        GetDie(raw, i, &die);
+        SELECT_CE(dieRaw);
+        WaitReady(dieRaw);
+        if (!IsOperationComplete(dieRaw)) {
+
+            complete = 0;
+        }
+        DISABLE_CE(dieRaw);
+    }
+
+    return complete;
+}
+
+/**
+ * \brief Tells if all the dies of a multi-die device are ready.
+ *
+ * \param raw  Pointer to a RawNandFlash instance with several dies.
+ * \return 1 if the dies are ready; otherwise 0.
+ */
+static unsigned char AreDiesReady(const struct RawNandFlash *raw)
+{
+    struct RawNandFlash die;
+    const struct RawNandFlash *dieRaw = &die;
+    unsigned char ready = 1;
+    unsigned char i;
+
+    for (i=0; (i < raw->numDies) && ready; i++) {
+
+        GetDie(raw, i, &die);
+        SELECT_CE(dieRaw);
+        WRITE_COMMAND(dieRaw, COMMAND_STATUS);
+        ready = ((READ_DATA8(dieRaw) & STATUS_READY) == STATUS_READY);
+        DISABLE_CE(dieRaw);
+    }
+
+    return ready;
+}
+
+/**
+ * \brief Completes the background operation: checks its status and invokes
+ * its callback.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ */
+static void CompletePending(const struct RawNandFlash *raw)
+{
+    MediaCallback callback = pending.callback;
+    void *argument = pending.argument;
+    unsigned char status = MED_STATUS_SUCCESS;
+    unsigned char complete;
+
+    if (raw->numDies > 1) {
+
+        complete = AreDiesComplete(raw);
+    }
+    else {
+
+        SELECT_CE(raw);
+        complete = IsOperationComplete(raw);
+        DISABLE_CE(raw);
+    }
+    if (!complete) {
+
+        TRACE_ERROR("RawNandFlash: Could not erase block %d.\n\r", pending.block);
+        status = MED_STATUS_ERROR;
+    }
+
+    /* Callback may start the next operation*/
+    pending.raw = 0;
+    if (callback) {
+
+        callback(argument, status, (status == MED_STATUS_SUCCESS), (status != MED_STATUS_SUCCESS));
+    }
+}
+
+/**
+ * \brief Waits for the end of the background operation, if any.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ */
+static void FinishPending(const struct RawNandFlash *raw)
+{
+    if (pending.raw != raw) {
+
+        return;
+    }
+
+    /* The dies of a multi-die device are waited for by CompletePending*/
+    if (raw->numDies <= 1) {
+
+        SELECT_CE(raw);
+        WaitReady(raw);
+        DISABLE_CE(raw);
+    }
+    CompletePending(raw);
+}
+
+/**
+ * \brief Reads the status register once the array operations are over.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \return the status register.
+ */
+static unsigned char ReadArrayStatus(const struct RawNandFlash *raw)
+{
+    unsigned char status;
+
+    WRITE_COMMAND(raw, COMMAND_STATUS);
+    do {
+        status = READ_DATA8(raw);
+    } while ((status & STATUS_ARRAY_READY) != STATUS_ARRAY_READY);
+
+    return status;
+}
+
+/**
+ * \brief Reads the ONFI parameter page of the device, if any, and adds the
+ * cache and two-plane options it reports to the model.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ */
+static void ReadOnfiOptions(struct RawNandFlash *raw)
+{
+    unsigned char parameters[ONFI_PLANEBITS + 1];
+    unsigned int signature;
+
+    /* Parameter page is read with 8-bit data cycles*/
+    if (NandFlashModel_GetDataBusWidth(MODEL(raw)) == 16) {
+
+        return;
+    }
+
+    ENABLE_CE(raw);
+    WRITE_COMMAND(raw, COMMAND_READ_PARAMETER);
+    WRITE_ADDRESS(raw, 0);
+    WaitReady(raw);
+    WRITE_COMMAND(raw, COMMAND_READ_1);
+    ReadData(raw, parameters, sizeof(parameters));
+    DISABLE_CE(raw);
+
+    memcpy(&signature, parameters, 4);
+    if (signature != ONFI_SIGNATURE) {
+
+        return;
+    }
+
+    if (parameters[ONFI_OPTIONALCOMMANDS] & ONFI_COMMAND_CACHEWRITE) {
+
+        raw->model.options |= NandFlashModel_CACHEPROGRAM;
+    }
+    if (parameters[ONFI_OPTIONALCOMMANDS] & ONFI_COMMAND_CACHEREAD) {
+
+        raw->model.options |= NandFlashModel_CACHEREAD;
+    }
+    if ((parameters[ONFI_FEATURES] & ONFI_FEATURE_PLANES)
+        && ((parameters[ONFI_PLANEBITS] & 0xF) == 1)) {
+
+        raw->model.options |= NandFlashModel_TWOPLANES;
+    }
+    TRACE_INFO("ONFI device, options 0x%02X\n\r", raw->model.options);
+}
+
+/**
+ * \brief Sends the data and spare areas of a page being programmed.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param data  Buffer containing the data area.
+ * \param spare  Buffer containing the spare area, can be 0.
+ */
+static void WritePageAreas(
+    const struct RawNandFlash *raw,
+    unsigned char *data,
+    unsigned char *spare)
+{
+    unsigned short dummyByte;
+
+    WriteData(raw, data, NandFlashModel_GetPageDataSize(MODEL(raw)));
+    if (spare) {
+
+        WriteData(raw, spare, NandFlashModel_GetPageSpareSize(MODEL(raw)));
+    }
+    else {
+        /* Same ECC parity workaround as WritePage()*/
+        ReadData(raw, (unsigned char *) (&dummyByte), 2);
+    }
+}
+
 /**
  * \brief Erases the specified block of the device.
  *
@@ -293,6 +653,19 @@ static unsigned char EraseBlock(
 
     TRACE_DEBUG("EraseBlock(%d)\r\n", block);
 
+    /* Same block on all the dies at the same time*/
+    if (raw->numDies > 1) {
+
+        FinishPending(raw);
+        StartDiesErase(raw, block);
+        if (!AreDiesComplete(raw)) {
+
+            TRACE_ERROR("EraseBlock: Could not erase block %d.\n\r", block);
+            error = NandCommon_ERROR_CANNOTERASE;
+        }
+        return error;
+    }
+
     /* Calculate address used for erase */
     rowAddress = block * NandFlashModel_GetBlockSizeInPages(MODEL(raw));
 
@@ -342,6 +715,14 @@ static unsigned char WritePage(
     unsigned int rowAddress;
 
     TRACE_DEBUG("WritePage(B#%d:P#%d)\r\n", block, page);
+    if (raw->numDies > 1) {
+
+        struct RawNandFlash dieRaw;
+
+        page = SelectDie(raw, page, &dieRaw);
+        return WritePage(&dieRaw, block, page, data, spare);
+    }
+
     /* Calculate physical address of the page*/
     rowAddress = block * NandFlashModel_GetBlockSizeInPages(MODEL(raw)) + page;
 
@@ -428,8 +809,20 @@ static unsigned char CopyPage(
     TRACE_DEBUG("CopyPage(B#%d:P#%d -> B#%d:P#%d)\n\r",
               sourceBlock, sourcePage, destBlock, destPage);
 
+    /* Copy-back inside a die, when both pages of the die have the same parity*/
+    if ((raw->numDies > 1)
+        && ((sourcePage % raw->numDies) == (destPage % raw->numDies))
+        && (((sourcePage / raw->numDies) & 1) == ((destPage / raw->numDies) & 1))) {
+
+        struct RawNandFlash dieRaw;
+
+        sourcePage = SelectDie(raw, sourcePage, &dieRaw);
+        return CopyPage(&dieRaw, sourceBlock, sourcePage,
+                        destBlock, destPage / raw->numDies);
+    }
+
     /* Use the copy-back facility if available*/
-    if (NandFlashModel_SupportsCopyBack(MODEL(raw))) {
+    if (NandFlashModel_SupportsCopyBack(MODEL(raw)) && (raw->numDies <= 1)) {
 
         /* Start operation*/
         ENABLE_CE(raw);
@@ -477,113 +870,406 @@ static unsigned char CopyPage(
     return error;
 }
 
-/*----------------------------------------------------------------------------
- *        Exported functions
- *----------------------------------------------------------------------------*/
-
 /**
- * \brief Initializes a RawNandFlash instance based on the given model and physical interface.
+ * \brief Adds the dies configured by RawNandFlash_ConfigureDies to a device
+ * initialized on its first die, and scales its geometry.
  *
- * \param raw  Pointer to a RawNandFlash instance.
- * \param model  Pointer to the underlying nand chip model. Can be 0.
- * \param commandAddress  Address at which commands are sent.
- * \param addressAddress  Address at which addresses are sent.
- * \param dataAddress  Address at which data is sent.
- * \param pinChipEnable  Pin controlling the CE signal of the NandFlash.
- * \param pinReadyBusy  Pin used to monitor the ready/busy signal of the Nand.
+ * \param raw  Pointer to a RawNandFlash instance initialized on one die.
  * \return 0 if successful; otherwise returns NandCommon_ERROR_UNKNOWNMODEL.
  */
-unsigned char RawNandFlash_Initialize(
-    struct RawNandFlash *raw,
-    const struct NandFlashModel *model,
-    unsigned int commandAddress,
-    unsigned int addressAddress,
-    unsigned int dataAddress,
-    const Pin pinChipEnable,
-    const Pin pinReadyBusy)
+static unsigned char AddDies(struct RawNandFlash *raw)
 {
-    TRACE_DEBUG("RawNandFlash_Initialize()\r\n");
+    struct RawNandFlash dieRaw;
+    unsigned int chipId = RawNandFlash_ReadId(raw);
+    unsigned char numDies = dieConfig.numDies;
+    unsigned char i;
 
-    /* Initialize fields*/
-    raw->commandAddress = commandAddress;
-    raw->addressAddress = addressAddress;
-    raw->dataAddress = dataAddress;
-    raw->pinChipEnable = pinChipEnable;
-    raw->pinReadyBusy = pinReadyBusy;
+    if (NandFlashModel_GetBlockSizeInPages(MODEL(raw)) * numDies
+        > NandCommon_MAXNUMPAGESPERBLOCK) {
 
-    /* Reset*/
-    RawNandFlash_Reset(raw);
+        TRACE_ERROR("RawNandFlash_Initialize: Blocks of %d dies are too large.\n\r", numDies);
+        return NandCommon_ERROR_UNKNOWNMODEL;
+    }
 
-    /* If model is not provided, autodetect it*/
-    if (!model) {
+    raw->numDies = numDies;
+    for (i=1; i < numDies; i++) {
 
-        TRACE_DEBUG("No model provided, trying autodetection ...\n\r");
-        if (NandFlashModel_Find(nandFlashModelList,
-                                NandFlashModelList_SIZE,
-                                RawNandFlash_ReadId(raw),
-                                &(raw->model))) {
+        raw->pinDieChipEnables[i - 1] = dieConfig.pinChipEnables[i - 1];
+    }
+    raw->model.deviceSizeInMegaBytes *= numDies;
+    raw->model.blockSizeInKBytes *= numDies;
+    raw->model.blockShift += RawNandFlash_DIESHIFT(numDies);
 
-            TRACE_ERROR(
-                      "RawNandFlash_Initialize: Could not autodetect chip.\n\r");
+    /* All the dies must be the same chip*/
+    for (i=1; i < numDies; i++) {
+
+        GetDie(raw, i, &dieRaw);
+        RawNandFlash_Reset(&dieRaw);
+        if (RawNandFlash_ReadId(&dieRaw) != chipId) {
+
+            TRACE_ERROR("RawNandFlash_Initialize: Die %d is not the same chip.\n\r", i);
             return NandCommon_ERROR_UNKNOWNMODEL;
         }
     }
-    else {
-
-        /* Copy provided model*/
-        raw->model = *model;
-    }
 
+    TRACE_INFO("RawNandFlash: %d dies, %dMB, blocks of %dkB\n\r", numDies,
+               raw->model.deviceSizeInMegaBytes, raw->model.blockSizeInKBytes);
     return 0;
 }
 
 /**
- * \brief Resets a NandFlash device.
+ * \brief Starts loading a page of a large block die in its data register.
  *
- * \param raw  Pointer to a RawNandFlash instance.
+ * \param dieRaw  Pointer to the RawNandFlash instance of a die.
+ * \param rowAddress  Row address of the page in the die.
  */
-void RawNandFlash_Reset(const struct RawNandFlash *raw)
+static void StartPageRead(const struct RawNandFlash *dieRaw, unsigned int rowAddress)
 {
-    TRACE_DEBUG("RawNandFlash_Reset()\n\r");
-
-    ENABLE_CE(raw);
-    WRITE_COMMAND(raw, COMMAND_RESET);
-    /*WRITE_COMMAND16(raw, COMMAND_RESET);*/
-    WaitReady(raw);
-    DISABLE_CE(raw);
+    SELECT_CE(dieRaw);
+    WRITE_COMMAND(dieRaw, COMMAND_READ_1);
+    WriteColumnAddress(dieRaw, 0);
+    WriteRowAddress(dieRaw, rowAddress);
+    WRITE_COMMAND(dieRaw, COMMAND_READ_2);
+    DISABLE_CE(dieRaw);
 }
 
 /**
- * \brief Reads and returns the identifiers of a NandFlash chip.
+ * \brief Reads consecutive pages of a block of a large block multi-die device:
+ * the dies load their next page while the pages of the other dies are
+ * transferred.
  *
- * \param raw  Pointer to a RawNandFlash instance.
- * \return id1|(id2<<8)|(id3<<16)|(id4<<24)
+ * \param raw  Pointer to a RawNandFlash instance with several dies.
+ * \param block  Number of the physical block to read.
+ * \param page  Number of the first page to read inside the given block.
+ * \param numPages  Number of pages to read (in the same block).
+ * \param data  Buffer where the data areas will be read, one after the other.
+ * \param spare  Buffer where the spare areas will be read, can be 0.
  */
-unsigned int RawNandFlash_ReadId(const struct RawNandFlash *raw)
+static void ReadPagesInterleaved(
+    const struct RawNandFlash *raw,
+    unsigned short block,
+    unsigned short page,
+    unsigned short numPages,
+    unsigned char *data,
+    unsigned char *spare)
 {
-    unsigned int chipId;
+    struct RawNandFlash dies[RawNandFlash_MAXDIES];
+    const struct RawNandFlash *dieRaw;
+    unsigned char numDies = raw->numDies;
+    unsigned int pageDataSize = NandFlashModel_GetPageDataSize(MODEL(raw));
+    unsigned int pageSpareSize = NandFlashModel_GetPageSpareSize(MODEL(raw));
+    unsigned int firstRow = block * (NandFlashModel_GetBlockSizeInPages(MODEL(raw)) / numDies);
+    unsigned short i;
 
-    TRACE_DEBUG("RawNandFlash_ReadId()\n\r");
+    FinishPending(raw);
+    for (i=0; i < numDies; i++) {
 
-    ENABLE_CE(raw);
-    /*WRITE_COMMAND16(raw, COMMAND_READID);*/
-    WRITE_COMMAND(raw, COMMAND_READID);
-    WRITE_ADDRESS(raw, 0);
-    chipId  = READ_DATA8(raw);
-    chipId |= READ_DATA8(raw) << 8;
-    chipId |= READ_DATA8(raw) << 16;
-    chipId |= READ_DATA8(raw) << 24;
-    DISABLE_CE(raw);
+        GetDie(raw, i, &dies[i]);
+    }
 
-    return chipId;
-}
+    /* Each die loads its first page*/
+    for (i=0; (i < numPages) && (i < numDies); i++) {
+
+        StartPageRead(&dies[(page + i) % numDies], firstRow + (page + i) / numDies);
+    }
+
+    for (i=0; i < numPages; i++) {
+
+        dieRaw = &dies[(page + i) % numDies];
+        SELECT_CE(dieRaw);
+        WaitReady(dieRaw);
+        WRITE_COMMAND(dieRaw, COMMAND_READ_1);
+        ReadData(dieRaw, data, pageDataSize);
+        data += pageDataSize;
+        if (spare) {
+
+            ReadData(dieRaw, spare, pageSpareSize);
+            spare += pageSpareSize;
+        }
+        DISABLE_CE(dieRaw);
+
+        /* The die loads its next page while the others are read*/
+        if (i + numDies < numPages) {
 
+            StartPageRead(dieRaw, firstRow + (page + i + numDies) / numDies);
+        }
+    }
+}
 
 /**
- * \brief Erases the specified block of the device, retrying several time if it fails.
+ * \brief Waits for the end of the page program of a die, and checks it.
  *
- * \param raw  Pointer to a RawNandFlash instance.
- * \param block  Number of the physical block to erase.
+ * \param dieRaw  Pointer to the RawNandFlash instance of a die.
+ * \return 1 if the program is successful; otherwise 0.
+ */
+static unsigned char EndDieProgram(const struct RawNandFlash *dieRaw)
+{
+    unsigned char complete;
+
+    SELECT_CE(dieRaw);
+    WaitReady(dieRaw);
+    complete = IsOperationComplete(dieRaw);
+    DISABLE_CE(dieRaw);
+
+    return complete;
+}
+
+/**
+ * \brief Programs consecutive pages of a block of a large block multi-die
+ * device: a page is transferred to a die while the others are programming.
+ *
+ * \param raw  Pointer to a RawNandFlash instance with several dies.
+ * \param block  Number of the physical block to write.
+ * \param page  Number of the first page to write inside the given block.
+ * \param numPages  Number of pages to write (in the same block).
+ * \param data  Buffer containing the data areas, one after the other.
+ * \param spare  Buffer containing the spare areas, can be 0.
+ * \return 0 if successful; otherwise returns NandCommon_ERROR_CANNOTWRITE.
+ */
+static unsigned char WritePagesInterleaved(
+    const struct RawNandFlash *raw,
+    unsigned short block,
+    unsigned short page,
+    unsigned short numPages,
+    unsigned char *data,
+    unsigned char *spare)
+{
+    struct RawNandFlash dies[RawNandFlash_MAXDIES];
+    unsigned char busy[RawNandFlash_MAXDIES];
+    const struct RawNandFlash *dieRaw;
+    unsigned char numDies = raw->numDies;
+    unsigned int pageDataSize = NandFlashModel_GetPageDataSize(MODEL(raw));
+    unsigned int pageSpareSize = NandFlashModel_GetPageSpareSize(MODEL(raw));
+    unsigned int firstRow = block * (NandFlashModel_GetBlockSizeInPages(MODEL(raw)) / numDies);
+    unsigned char error = 0;
+    unsigned char die;
+    unsigned short i;
+
+    FinishPending(raw);
+    for (die=0; die < numDies; die++) {
+
+        GetDie(raw, die, &dies[die]);
+        busy[die] = 0;
+    }
+
+    for (i=0; (i < numPages) && !error; i++) {
+
+        die = (page + i) % numDies;
+        dieRaw = &dies[die];
+
+        /* Previous page of the die*/
+        if (busy[die]) {
+
+            busy[die] = 0;
+            if (!EndDieProgram(dieRaw)) {
+
+                error = NandCommon_ERROR_CANNOTWRITE;
+                break;
+            }
+        }
+
+        SELECT_CE(dieRaw);
+        WRITE_COMMAND(dieRaw, COMMAND_WRITE_1);
+        WriteColumnAddress(dieRaw, 0);
+        WriteRowAddress(dieRaw, firstRow + (page + i) / numDies);
+        WritePageAreas(dieRaw, data, spare);
+        WRITE_COMMAND(dieRaw, COMMAND_WRITE_2);
+        DISABLE_CE(dieRaw);
+        busy[die] = 1;
+
+        data += pageDataSize;
+        if (spare) {
+            spare += pageSpareSize;
+        }
+    }
+
+    /* Programs in progress*/
+    for (die=0; die < numDies; die++) {
+
+        if (busy[die] && !EndDieProgram(&dies[die])) {
+
+            error = NandCommon_ERROR_CANNOTWRITE;
+        }
+    }
+
+    if (error) {
+
+        TRACE_ERROR("RawNandFlash_WritePages: Failed in B#%d:P#%d+%d\n\r",
+                    block, page, numPages);
+    }
+    return error;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Sets the dies striped by the devices initialized next: the device
+ * given to RawNandFlash_Initialize is die 0, the others are identical chips
+ * sharing its bus on other chip enables.
+ *
+ * \param pinChipEnables  Chip enable pins of the dies 1 to numDies - 1.
+ * \param numDies  Number of dies: 1 for a single device, 2 or 4 (not with a
+ * fixed geometry, NandFlashModel_BLOCKSHIFT).
+ * \return 0 if successful; otherwise returns NandCommon_ERROR_UNKNOWNMODEL.
+ */
+unsigned char RawNandFlash_ConfigureDies(const Pin *pinChipEnables, unsigned char numDies)
+{
+    unsigned char i;
+
+    if ((numDies == 0) || (numDies > RawNandFlash_MAXDIES) || (numDies & (numDies - 1))
+#if defined(NandFlashModel_BLOCKSHIFT)
+        || (numDies > 1)
+#endif
+        ) {
+
+        TRACE_ERROR("RawNandFlash_ConfigureDies: %d dies not supported.\n\r", numDies);
+        return NandCommon_ERROR_UNKNOWNMODEL;
+    }
+
+    for (i=1; i < numDies; i++) {
+
+        dieConfig.pinChipEnables[i - 1] = pinChipEnables[i - 1];
+        PIO_Configure(&(dieConfig.pinChipEnables[i - 1]), 1);
+    }
+    dieConfig.numDies = numDies;
+
+    return 0;
+}
+
+/**
+ * \brief Initializes a RawNandFlash instance based on the given model and physical interface.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param model  Pointer to the underlying nand chip model. Can be 0.
+ * \param commandAddress  Address at which commands are sent.
+ * \param addressAddress  Address at which addresses are sent.
+ * \param dataAddress  Address at which data is sent.
+ * \param pinChipEnable  Pin controlling the CE signal of the NandFlash.
+ * \param pinReadyBusy  Pin used to monitor the ready/busy signal of the Nand.
+ * \return 0 if successful; otherwise returns NandCommon_ERROR_UNKNOWNMODEL.
+ */
+unsigned char RawNandFlash_Initialize(
+    struct RawNandFlash *raw,
+    const struct NandFlashModel *model,
+    unsigned int commandAddress,
+    unsigned int addressAddress,
+    unsigned int dataAddress,
+    const Pin pinChipEnable,
+    const Pin pinReadyBusy)
+{
+    TRACE_DEBUG("RawNandFlash_Initialize()\r\n");
+
+    /* Initialize fields*/
+    raw->commandAddress = commandAddress;
+    raw->addressAddress = addressAddress;
+    raw->dataAddress = dataAddress;
+    raw->pinChipEnable = pinChipEnable;
+    raw->pinReadyBusy = pinReadyBusy;
+    raw->numDies = 1;
+
+    /* Reset*/
+    RawNandFlash_Reset(raw);
+
+    /* If model is not provided, autodetect it*/
+    if (!model) {
+
+        TRACE_DEBUG("No model provided, trying autodetection ...\n\r");
+        if (NandFlashModel_Find(nandFlashModelList,
+                                NandFlashModelList_SIZE,
+                                RawNandFlash_ReadId(raw),
+                                &(raw->model))) {
+
+            TRACE_ERROR(
+                      "RawNandFlash_Initialize: Could not autodetect chip.\n\r");
+            return NandCommon_ERROR_UNKNOWNMODEL;
+        }
+    }
+    else {
+
+        /* Copy provided model*/
+        raw->model = *model;
+        if (NandFlashModel_UpdateShifts(&(raw->model))) {
+
+            return NandCommon_ERROR_UNKNOWNMODEL;
+        }
+    }
+
+    /* Large block devices may report cache and plane operations*/
+    if (!NandFlashModel_HasSmallBlocks(MODEL(raw))) {
+
+        ReadOnfiOptions(raw);
+    }
+
+    if (dieConfig.numDies > 1) {
+
+        return AddDies(raw);
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Resets a NandFlash device.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ */
+void RawNandFlash_Reset(const struct RawNandFlash *raw)
+{
+    TRACE_DEBUG("RawNandFlash_Reset()\n\r");
+
+    if (raw->numDies > 1) {
+
+        struct RawNandFlash dieRaw;
+        unsigned char i;
+
+        for (i=0; i < raw->numDies; i++) {
+
+            GetDie(raw, i, &dieRaw);
+            RawNandFlash_Reset(&dieRaw);
+        }
+        return;
+    }
+
+    ENABLE_CE(raw);
+    WRITE_COMMAND(raw, COMMAND_RESET);
+    /*WRITE_COMMAND16(raw, COMMAND_RESET);*/
+    WaitReady(raw);
+    DISABLE_CE(raw);
+}
+
+/**
+ * \brief Reads and returns the identifiers of a NandFlash chip.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \return id1|(id2<<8)|(id3<<16)|(id4<<24)
+ */
+unsigned int RawNandFlash_ReadId(const struct RawNandFlash *raw)
+{
+    unsigned int chipId;
+
+    TRACE_DEBUG("RawNandFlash_ReadId()\n\r");
+
+    ENABLE_CE(raw);
+    /*WRITE_COMMAND16(raw, COMMAND_READID);*/
+    WRITE_COMMAND(raw, COMMAND_READID);
+    WRITE_ADDRESS(raw, 0);
+    chipId  = READ_DATA8(raw);
+    chipId |= READ_DATA8(raw) << 8;
+    chipId |= READ_DATA8(raw) << 16;
+    chipId |= READ_DATA8(raw) << 24;
+    DISABLE_CE(raw);
+
+    return chipId;
+}
+
+
+/**
+ * \brief Erases the specified block of the device, retrying several time if it fails.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param block  Number of the physical block to erase.
  * \return 0 if successful; otherwise returns NandCommon_ERROR_UNKNOWNMODEL.
  */
 unsigned char RawNandFlash_EraseBlock(
@@ -612,6 +1298,136 @@ unsigned char RawNandFlash_EraseBlock(
 	#endif
 }
 
+/**
+ * \brief Enables the ready/busy pin interrupt, so that the waits for the
+ * device sleep (RAWNANDFLASH_WAIT) instead of polling, and the background
+ * operations complete as soon as possible. PIO interrupts must have been
+ * initialized (PIO_InitializeInterrupts).
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ */
+void RawNandFlash_ConfigureReadyInterrupt(const struct RawNandFlash *raw)
+{
+    if (!raw->pinReadyBusy.mask) {
+
+        return;
+    }
+
+    PIO_ConfigureIt(&(raw->pinReadyBusy), ReadyBusyHandler);
+    PIO_EnableIt(&(raw->pinReadyBusy));
+    pending.interrupt = 1;
+}
+
+/**
+ * \brief Sets the function called by the ready/busy pin interrupt when the
+ * background operation is over, e.g. to have the media handler complete it
+ * (MED_Notify) instead of waiting for the next RawNandFlash_Poll.
+ *
+ * \param notify  Function called from the interrupt, 0 for none.
+ * \param argument  Argument of the function.
+ */
+void RawNandFlash_SetReadyNotify(void (*notify)(void *argument), void *argument)
+{
+    pending.notify = 0;
+    pending.notifyArgument = argument;
+    pending.notify = notify;
+}
+
+/**
+ * \brief Starts erasing a block, and returns without waiting for the end of
+ * the erase. The callback is invoked with MED_STATUS_SUCCESS or
+ * MED_STATUS_ERROR from RawNandFlash_Poll, or from the next operation on
+ * the device. The block is not retried on failure.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param block  Number of the physical block to erase.
+ * \param callback  Completion callback, can be 0.
+ * \param argument  Callback argument.
+ * \return 0 if the erase has been started.
+ */
+unsigned char RawNandFlash_StartEraseBlock(
+    const struct RawNandFlash *raw,
+    unsigned short block,
+    MediaCallback callback,
+    void *argument)
+{
+    TRACE_DEBUG("RawNandFlash_StartEraseBlock(B#%d)\n\r", block);
+
+    if (raw->numDies > 1) {
+
+        FinishPending(raw);
+        pending.ready = 0;
+        StartDiesErase(raw, block);
+    }
+    else {
+
+        ENABLE_CE(raw);
+        pending.ready = 0;
+        WRITE_COMMAND(raw, COMMAND_ERASE_1);
+        WriteRowAddress(raw, block * NandFlashModel_GetBlockSizeInPages(MODEL(raw)));
+        WRITE_COMMAND(raw, COMMAND_ERASE_2);
+        DISABLE_CE(raw);
+    }
+
+    pending.raw = raw;
+    pending.callback = callback;
+    pending.argument = argument;
+    pending.block = block;
+
+    return 0;
+}
+
+/**
+ * \brief Checks the background operation, and completes it if the device is
+ * ready. To be called from the idle loop or the media handler.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \return 1 if an operation is still running; otherwise 0.
+ */
+unsigned char RawNandFlash_Poll(const struct RawNandFlash *raw)
+{
+    unsigned char ready;
+
+    if (pending.raw != raw) {
+
+        return 0;
+    }
+
+    if (raw->numDies > 1) {
+
+        ready = AreDiesReady(raw);
+    }
+    else if (raw->pinReadyBusy.mask) {
+
+        ready = pending.ready || PIO_Get(&(raw->pinReadyBusy));
+    }
+    else {
+
+        SELECT_CE(raw);
+        WRITE_COMMAND(raw, COMMAND_STATUS);
+        ready = ((READ_DATA8(raw) & STATUS_READY) == STATUS_READY);
+        DISABLE_CE(raw);
+    }
+    if (!ready) {
+
+        return 1;
+    }
+
+    CompletePending(raw);
+    return 0;
+}
+
+/**
+ * \brief Waits for the end of the background operation, if any, and
+ * completes it.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ */
+void RawNandFlash_Finish(const struct RawNandFlash *raw)
+{
+    FinishPending(raw);
+}
+
 /**
  * \brief Reads the data and/or the spare areas of a page of a NandFlash into the  provided buffers.
  *
@@ -639,6 +1455,14 @@ unsigned char RawNandFlash_ReadPage(
     assert( data || spare ) ; /* "RawNandFlash_ReadPage: At least one area must be read\n\r" */
     TRACE_DEBUG("RawNandFlash_ReadPage(B#%d:P#%d)\r\n", block, page);
 
+    if (raw->numDies > 1) {
+
+        struct RawNandFlash dieRaw;
+
+        page = SelectDie(raw, page, &dieRaw);
+        return RawNandFlash_ReadPage(&dieRaw, block, page, data, spare);
+    }
+
     /* Calculate actual address of the page*/
     rowAddress = block * NandFlashModel_GetBlockSizeInPages(MODEL(raw)) + page;
 
@@ -697,6 +1521,115 @@ unsigned char RawNandFlash_ReadPage(
     return 0;
 }
 
+/**
+ * \brief Reads some bytes of the spare area of a page, using column
+ * addressing so that only these bytes are transferred.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param block  Number of the physical block to read.
+ * \param page  Number of the page to read inside the given block.
+ * \param offset  Index of the first spare byte to read (even on 16-bit devices).
+ * \param buffer  Buffer where the bytes will be stored.
+ * \param size  Number of bytes to read (even on 16-bit devices).
+ * \return 0 if successful; otherwise returns an error code.
+ */
+unsigned char RawNandFlash_ReadSpare(
+    const struct RawNandFlash *raw,
+    unsigned short block,
+    unsigned short page,
+    unsigned char offset,
+    void *buffer,
+    unsigned char size)
+{
+    unsigned int colAddress = NandFlashModel_GetPageDataSize(MODEL(raw)) + offset;
+    unsigned int rowAddress;
+
+    assert( offset + size <= NandFlashModel_GetPageSpareSize(MODEL(raw)) ) ;
+    TRACE_DEBUG("RawNandFlash_ReadSpare(B#%d:P#%d:%d+%d)\r\n", block, page, offset, size);
+
+    if (raw->numDies > 1) {
+
+        struct RawNandFlash dieRaw;
+
+        page = SelectDie(raw, page, &dieRaw);
+        return RawNandFlash_ReadSpare(&dieRaw, block, page, offset, buffer, size);
+    }
+
+    rowAddress = block * NandFlashModel_GetBlockSizeInPages(MODEL(raw)) + page;
+
+    ENABLE_CE(raw);
+
+    if (NandFlashModel_HasSmallBlocks(MODEL(raw))) {
+
+        WRITE_COMMAND(raw, COMMAND_READ_C);
+        WriteColumnAddress(raw, colAddress);
+        WriteRowAddress(raw, rowAddress);
+    }
+    else {
+
+        WRITE_COMMAND(raw, COMMAND_READ_1);
+        WriteColumnAddress(raw, colAddress);
+        WriteRowAddress(raw, rowAddress);
+        WRITE_COMMAND(raw, COMMAND_READ_2);
+    }
+    WaitReady(raw);
+
+    WRITE_COMMAND(raw, COMMAND_READ_1);
+    ReadData(raw, (unsigned char *) buffer, size);
+
+    DISABLE_CE(raw);
+
+    return 0;
+}
+
+/**
+ * \brief Reads the bad block markers (in the spare area of the first two
+ * pages of each die) of consecutive blocks, and sets the bits of the bad ones
+ * in a bitmap.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param firstBlock  Number of the first physical block to check.
+ * \param numBlocks  Number of blocks to check.
+ * \param bitmap  Bitmap of (numBlocks + 7) / 8 bytes, bit (i % 8) of byte
+ * (i / 8) is set if block firstBlock + i is bad.
+ * \return 0 if successful; otherwise returns an error code.
+ */
+unsigned char RawNandFlash_ReadBadBlockMarkers(
+    const struct RawNandFlash *raw,
+    unsigned short firstBlock,
+    unsigned short numBlocks,
+    unsigned char *bitmap)
+{
+    const struct NandSpareScheme *scheme = NandFlashModel_GetScheme(MODEL(raw));
+    unsigned char offset = scheme->badBlockMarkerPosition & ~1;
+    unsigned char markers[2];
+    unsigned char error;
+    unsigned short i;
+    unsigned short page;
+
+    TRACE_DEBUG("RawNandFlash_ReadBadBlockMarkers(B#%d+%d)\r\n", firstBlock, numBlocks);
+
+    memset(bitmap, 0, (numBlocks + 7) / 8);
+    for (i=0; i < numBlocks; i++) {
+
+        for (page=0; page < 2 * raw->numDies; page++) {
+
+            error = RawNandFlash_ReadSpare(raw, firstBlock + i, page, offset, markers, 2);
+            if (error) {
+
+                return error;
+            }
+            if (markers[scheme->badBlockMarkerPosition & 1] != 0xFF) {
+
+                bitmap[i / 8] |= 1 << (i % 8);
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
+
 /**
  * \brief Writes the data and/or the spare areas of a page of a NandFlash into the  provided buffers.
  *
@@ -732,6 +1665,277 @@ unsigned char RawNandFlash_WritePage(
     return NandCommon_ERROR_BADBLOCK;
 }
 
+/**
+ * \brief Reads consecutive pages of a block into the provided buffers. The
+ * sequential cache read is used when supported, so that the next page is
+ * loaded while the current one is transferred.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param block  Number of the physical block to read.
+ * \param page  Number of the first page to read inside the given block.
+ * \param numPages  Number of pages to read (in the same block).
+ * \param data  Buffer where the data areas will be read, one after the other.
+ * \param spare  Buffer where the spare areas will be read, can be 0.
+ * \return 0 if successful; otherwise returns an error code.
+ */
+unsigned char RawNandFlash_ReadPages(
+    const struct RawNandFlash *raw,
+    unsigned short block,
+    unsigned short page,
+    unsigned short numPages,
+    void *data,
+    void *spare)
+{
+    unsigned int pageDataSize = NandFlashModel_GetPageDataSize(MODEL(raw));
+    unsigned int pageSpareSize = NandFlashModel_GetPageSpareSize(MODEL(raw));
+    unsigned char *pData = (unsigned char *) data;
+    unsigned char *pSpare = (unsigned char *) spare;
+    unsigned int rowAddress;
+    unsigned short i;
+
+    assert( data ) ; /* "RawNandFlash_ReadPages: Data area must be read\n\r" */
+    assert( page + numPages <= NandFlashModel_GetBlockSizeInPages(MODEL(raw)) ) ;
+    TRACE_DEBUG("RawNandFlash_ReadPages(B#%d:P#%d+%d)\r\n", block, page, numPages);
+
+    if ((raw->numDies > 1) && (numPages > 1) && !NandFlashModel_HasSmallBlocks(MODEL(raw))) {
+
+        ReadPagesInterleaved(raw, block, page, numPages, pData, pSpare);
+        return 0;
+    }
+
+    /* Page by page*/
+    if ((numPages < 2) || (raw->numDies > 1) || !NandFlashModel_SupportsCacheRead(MODEL(raw))) {
+
+        for (i=0; i < numPages; i++) {
+
+            RawNandFlash_ReadPage(raw, block, page + i, pData, pSpare);
+            pData += pageDataSize;
+            if (pSpare) {
+                pSpare += pageSpareSize;
+            }
+        }
+        return 0;
+    }
+
+    rowAddress = block * NandFlashModel_GetBlockSizeInPages(MODEL(raw)) + page;
+
+    /* Load the first page*/
+    ENABLE_CE(raw);
+    WRITE_COMMAND(raw, COMMAND_READ_1);
+    WriteColumnAddress(raw, 0);
+    WriteRowAddress(raw, rowAddress);
+    WRITE_COMMAND(raw, COMMAND_READ_2);
+    WaitReady(raw);
+
+    /* Move each page to the cache register while loading the next one*/
+    for (i=0; i < numPages; i++) {
+
+        WRITE_COMMAND(raw, (i < numPages - 1) ? COMMAND_CACHE_READ
+                                              : COMMAND_CACHE_READ_END);
+        WaitReady(raw);
+        WRITE_COMMAND(raw, COMMAND_READ_1);
+        ReadData(raw, pData, pageDataSize);
+        pData += pageDataSize;
+        if (pSpare) {
+
+            ReadData(raw, pSpare, pageSpareSize);
+            pSpare += pageSpareSize;
+        }
+    }
+
+    DISABLE_CE(raw);
+
+    return 0;
+}
+
+/**
+ * \brief Programs consecutive pages of a block. The cache program is used
+ * when supported, so that the next page is transferred while the current one
+ * is programmed. Pages are not retried, since a page can not be programmed
+ * twice.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param block  Number of the physical block to write.
+ * \param page  Number of the first page to write inside the given block.
+ * \param numPages  Number of pages to write (in the same block).
+ * \param data  Buffer containing the data areas, one after the other.
+ * \param spare  Buffer containing the spare areas, can be 0.
+ * \return 0 if successful; otherwise returns NandCommon_ERROR_CANNOTWRITE.
+ */
+unsigned char RawNandFlash_WritePages(
+    const struct RawNandFlash *raw,
+    unsigned short block,
+    unsigned short page,
+    unsigned short numPages,
+    void *data,
+    void *spare)
+{
+    unsigned int pageDataSize = NandFlashModel_GetPageDataSize(MODEL(raw));
+    unsigned int pageSpareSize = NandFlashModel_GetPageSpareSize(MODEL(raw));
+    unsigned char *pData = (unsigned char *) data;
+    unsigned char *pSpare = (unsigned char *) spare;
+    unsigned char error = 0;
+    unsigned char status;
+    unsigned int rowAddress;
+    unsigned short i;
+
+    assert( data ) ; /* "RawNandFlash_WritePages: Data area must be written\n\r" */
+    assert( page + numPages <= NandFlashModel_GetBlockSizeInPages(MODEL(raw)) ) ;
+    TRACE_DEBUG("RawNandFlash_WritePages(B#%d:P#%d+%d)\r\n", block, page, numPages);
+
+    if ((raw->numDies > 1) && (numPages > 1) && !NandFlashModel_HasSmallBlocks(MODEL(raw))) {
+
+        return WritePagesInterleaved(raw, block, page, numPages, pData, pSpare);
+    }
+
+    /* Page by page*/
+    if ((numPages < 2) || (raw->numDies > 1) || !NandFlashModel_SupportsCacheProgram(MODEL(raw))) {
+
+        for (i=0; i < numPages; i++) {
+
+            if (WritePage(raw, block, page + i, pData, pSpare)) {
+
+                return NandCommon_ERROR_CANNOTWRITE;
+            }
+            pData += pageDataSize;
+            if (pSpare) {
+                pSpare += pageSpareSize;
+            }
+        }
+        return 0;
+    }
+
+    rowAddress = block * NandFlashModel_GetBlockSizeInPages(MODEL(raw)) + page;
+
+    ENABLE_CE(raw);
+    for (i=0; (i < numPages) && !error; i++) {
+
+        WRITE_COMMAND(raw, COMMAND_WRITE_1);
+        WriteColumnAddress(raw, 0);
+        WriteRowAddress(raw, rowAddress + i);
+        WritePageAreas(raw, pData, pSpare);
+        pData += pageDataSize;
+        if (pSpare) {
+            pSpare += pageSpareSize;
+        }
+
+        /* Cache register is free as soon as the page is moved to the data
+           register, the previous page program result is then available*/
+        if (i < numPages - 1) {
+
+            WRITE_COMMAND(raw, COMMAND_CACHE_WRITE);
+            WaitReady(raw);
+            WRITE_COMMAND(raw, COMMAND_STATUS);
+            status = READ_DATA8(raw);
+            if ((i > 0) && (status & STATUS_ERROR_PREVIOUS)) {
+
+                error = NandCommon_ERROR_CANNOTWRITE;
+            }
+        }
+        else {
+
+            WRITE_COMMAND(raw, COMMAND_WRITE_2);
+            WaitReady(raw);
+            status = ReadArrayStatus(raw);
+            if (status & (STATUS_ERROR | STATUS_ERROR_PREVIOUS)) {
+
+                error = NandCommon_ERROR_CANNOTWRITE;
+            }
+        }
+    }
+    if (error && (i < numPages)) {
+
+        /* Wait for the programs in progress*/
+        ReadArrayStatus(raw);
+    }
+    DISABLE_CE(raw);
+
+    if (error) {
+
+        TRACE_ERROR("RawNandFlash_WritePages: Failed at B#%d:P#%d\n\r",
+                    block, page + i - 1);
+    }
+    return error;
+}
+
+/**
+ * \brief Programs the same page in the two blocks of a plane pair (block and
+ * block + 1) at the same time when the device has two planes, otherwise one
+ * after the other.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param block  Number of the even physical block (plane 0).
+ * \param page  Number of the page to write inside the blocks.
+ * \param data  Buffer containing the two data areas, one after the other.
+ * \param spare  Buffer containing the two spare areas, can be 0.
+ * \return 0 if successful; otherwise returns NandCommon_ERROR_CANNOTWRITE.
+ */
+unsigned char RawNandFlash_WritePageTwoPlanes(
+    const struct RawNandFlash *raw,
+    unsigned short block,
+    unsigned short page,
+    void *data,
+    void *spare)
+{
+    unsigned int pageDataSize = NandFlashModel_GetPageDataSize(MODEL(raw));
+    unsigned int pageSpareSize = NandFlashModel_GetPageSpareSize(MODEL(raw));
+    unsigned short numPages = NandFlashModel_GetBlockSizeInPages(MODEL(raw));
+    unsigned char *pData = (unsigned char *) data;
+    unsigned char *pSpare = (unsigned char *) spare;
+    unsigned char error = 0;
+
+    assert( data ) ; /* "RawNandFlash_WritePageTwoPlanes: Data area must be written\n\r" */
+    assert( (block & 1) == 0 ) ;
+    TRACE_DEBUG("RawNandFlash_WritePageTwoPlanes(B#%d+1:P#%d)\r\n", block, page);
+
+    if (raw->numDies > 1) {
+
+        struct RawNandFlash dieRaw;
+
+        page = SelectDie(raw, page, &dieRaw);
+        return RawNandFlash_WritePageTwoPlanes(&dieRaw, block, page, data, spare);
+    }
+
+    if (!NandFlashModel_SupportsTwoPlanes(MODEL(raw))) {
+
+        if (WritePage(raw, block, page, pData, pSpare)
+            || WritePage(raw, block + 1, page, pData + pageDataSize,
+                         pSpare ? pSpare + pageSpareSize : 0)) {
+
+            return NandCommon_ERROR_CANNOTWRITE;
+        }
+        return 0;
+    }
+
+    ENABLE_CE(raw);
+
+    /* Load plane 0*/
+    WRITE_COMMAND(raw, COMMAND_WRITE_1);
+    WriteColumnAddress(raw, 0);
+    WriteRowAddress(raw, block * numPages + page);
+    WritePageAreas(raw, pData, pSpare);
+    WRITE_COMMAND(raw, COMMAND_PLANE_WRITE);
+    WaitReady(raw);
+
+    /* Load plane 1 and program both*/
+    WRITE_COMMAND(raw, COMMAND_WRITE_1);
+    WriteColumnAddress(raw, 0);
+    WriteRowAddress(raw, (block + 1) * numPages + page);
+    WritePageAreas(raw, pData + pageDataSize, pSpare ? pSpare + pageSpareSize : 0);
+    WRITE_COMMAND(raw, COMMAND_WRITE_2);
+    WaitReady(raw);
+
+    if (!IsOperationComplete(raw)) {
+
+        TRACE_ERROR("RawNandFlash_WritePageTwoPlanes: Failed at B#%d:P#%d\n\r",
+                    block, page);
+        error = NandCommon_ERROR_CANNOTWRITE;
+    }
+    DISABLE_CE(raw);
+
+    return error;
+}
+
 /**
  * \brief Copy the data in a page of the NandFlash device to an other page on that same chip.
  *
@@ -0,0 +1,1257 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Simulated NandFlash device implementing the RawNandFlash interface over
+ * host memory, compiled instead of RawNandFlash.c when NAND_SIMULATOR is
+ * defined. Blocks are allocated on their first program and freed when erased,
+ * so that large devices only use the memory of their written blocks.
+ * Programming ANDs the new bytes into the page, as on the real array.
+ *
+ * All operations are blocking. RawNandFlash_StartEraseBlock erases at once
+ * and reports the completion from RawNandFlash_Poll, RawNandFlash_Finish or
+ * the next operation, as the hardware layer does.
+ *
+ * The simulated time of each operation is accumulated in the statistics:
+ * array time (tR, tPROG, tBERS) plus the bus transfer time of the bytes.
+ * Copy-back and cache operations are not overlapped with the transfers.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "memories.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#if defined(NAND_SIMULATOR)
+/*----------------------------------------------------------------------------
+ *        Internal definitions
+ *----------------------------------------------------------------------------*/
+
+/** Default device: 128MB, 2KB pages, 128KB blocks (device ID 0xF1)*/
+#define DEFAULT_CHIPID                  0x1580F12C
+
+/** Block flags*/
+#define BLOCK_FACTORYBAD                (1 << 0)
+
+/** Number of tries for erasing a block*/
+#define NUMERASETRIES           2
+/** Number of tries for writing a block*/
+#define NUMWRITETRIES           2
+/** Number of tries for copying a block*/
+#define NUMCOPYTRIES            2
+
+/** Internal cast macros*/
+#define MODEL(raw)  ((struct NandFlashModel *) raw)
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Simulated device*/
+static struct {
+
+    /** Configuration.*/
+    struct SimNandFlashConfig config;
+    /** Counters.*/
+    struct SimNandFlashStats stats;
+    /** Number of blocks.*/
+    unsigned short numBlocks;
+    /** Number of pages per block.*/
+    unsigned short numPages;
+    /** Size of the data area of a page.*/
+    unsigned short dataSize;
+    /** Size of the spare area of a page.*/
+    unsigned short spareSize;
+    /** Contents of the blocks, 0 when erased.*/
+    unsigned char **blocks;
+    /** Erase count of the blocks.*/
+    unsigned int *eraseCounts;
+    /** Flags of the blocks.*/
+    unsigned char *flags;
+    /** Pseudo-random generator state.*/
+    unsigned int random;
+    /** Program/erase operations before the power cut, 0 if none.*/
+    unsigned int powerCut;
+    /** Set once the power has been cut.*/
+    unsigned char powerOff;
+    /** Set once SimNandFlash_Configure has been called.*/
+    unsigned char configured;
+    /** Number of dies of the devices initialized next.*/
+    unsigned char numDies;
+} sim;
+
+/** Background erase, completed by RawNandFlash_Poll or the next operation*/
+static struct {
+
+    const struct RawNandFlash *raw;
+    MediaCallback callback;
+    void *argument;
+    unsigned char status;
+} pending;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Returns the next value of the pseudo-random generator (xorshift32).
+ */
+static unsigned int Random(void)
+{
+    sim.random ^= sim.random << 13;
+    sim.random ^= sim.random >> 17;
+    sim.random ^= sim.random << 5;
+
+    return sim.random;
+}
+
+/**
+ * \brief Draws an event of the given probability.
+ *
+ * \param ppm  Probability in parts per million.
+ * \return 1 if the event occurs; otherwise 0.
+ */
+static unsigned char Chance(unsigned int ppm)
+{
+    return (ppm && ((Random() % 1000000) < ppm));
+}
+
+/**
+ * \brief Frees the contents of the simulated device.
+ */
+static void ReleaseDevice(void)
+{
+    unsigned short i;
+
+    if (sim.blocks) {
+
+        for (i=0; i < sim.numBlocks; i++) {
+
+            free(sim.blocks[i]);
+        }
+    }
+    free(sim.blocks);
+    free(sim.eraseCounts);
+    free(sim.flags);
+    sim.blocks = 0;
+    sim.eraseCounts = 0;
+    sim.flags = 0;
+    sim.numBlocks = 0;
+    pending.raw = 0;
+}
+
+/**
+ * \brief Returns the contents of a block, allocating an erased one if needed.
+ *
+ * \param block  Number of the block.
+ * \return pointer to the (data + spare) areas of the pages of the block.
+ */
+static unsigned char * GetBlock(unsigned short block)
+{
+    unsigned int size = sim.numPages * (sim.dataSize + sim.spareSize);
+
+    if (!sim.blocks[block]) {
+
+        sim.blocks[block] = (unsigned char *) malloc(size);
+        assert( sim.blocks[block] ) ;
+        memset(sim.blocks[block], 0xFF, size);
+    }
+
+    return sim.blocks[block];
+}
+
+/**
+ * \brief Creates the simulated device for the geometry of the model, unless
+ * it already exists (the contents survive a new initialization, e.g. after
+ * a power cut), and marks the factory bad blocks.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ */
+static void CreateDevice(const struct RawNandFlash *raw)
+{
+    const struct NandSpareScheme *scheme = NandFlashModel_GetScheme(MODEL(raw));
+    unsigned short numBlocks = NandFlashModel_GetDeviceSizeInBlocks(MODEL(raw));
+    unsigned short numPages = NandFlashModel_GetBlockSizeInPages(MODEL(raw));
+    unsigned short dataSize = NandFlashModel_GetPageDataSize(MODEL(raw));
+    unsigned short spareSize = NandFlashModel_GetPageSpareSize(MODEL(raw));
+    unsigned short numBad;
+    unsigned short block;
+
+    if (sim.blocks
+        && (sim.numBlocks == numBlocks) && (sim.numPages == numPages)
+        && (sim.dataSize == dataSize) && (sim.spareSize == spareSize)) {
+
+        return;
+    }
+
+    ReleaseDevice();
+    sim.numBlocks = numBlocks;
+    sim.numPages = numPages;
+    sim.dataSize = dataSize;
+    sim.spareSize = spareSize;
+    sim.blocks = (unsigned char **) calloc(numBlocks, sizeof(unsigned char *));
+    sim.eraseCounts = (unsigned int *) calloc(numBlocks, sizeof(unsigned int));
+    sim.flags = (unsigned char *) calloc(numBlocks, 1);
+    assert( sim.blocks && sim.eraseCounts && sim.flags ) ;
+
+    /* Factory bad blocks are marked in the spare area of their first page*/
+    numBad = sim.config.numBadBlocks;
+    if (numBad >= numBlocks) {
+
+        numBad = numBlocks - 1;
+    }
+    while (numBad > 0) {
+
+        block = 1 + (Random() % (numBlocks - 1));
+        if (sim.flags[block] & BLOCK_FACTORYBAD) {
+
+            continue;
+        }
+        sim.flags[block] |= BLOCK_FACTORYBAD;
+        GetBlock(block)[dataSize + scheme->badBlockMarkerPosition] = 0;
+        numBad--;
+    }
+    TRACE_INFO("SimNandFlash: %d blocks of %d pages of %d+%d bytes\n\r",
+               numBlocks, numPages, dataSize, spareSize);
+}
+
+/**
+ * \brief Counts a program or erase operation towards the power cut.
+ *
+ * \return 1 if the power is cut during this operation; otherwise 0.
+ */
+static unsigned char CutPower(void)
+{
+    if (sim.powerCut && (--sim.powerCut == 0)) {
+
+        TRACE_INFO("SimNandFlash: power cut\n\r");
+        sim.powerOff = 1;
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Tells if a block can no longer be programmed or erased.
+ *
+ * \param block  Number of the block.
+ */
+static unsigned char IsWornOut(unsigned short block)
+{
+    return ((sim.flags[block] & BLOCK_FACTORYBAD)
+            || (sim.config.wearLimit
+                && (sim.eraseCounts[block] > sim.config.wearLimit)));
+}
+
+/**
+ * \brief Reads bytes of a page, adding the array and the transfer times.
+ *
+ * \param block  Number of the block.
+ * \param page  Number of the page inside the block.
+ * \param offset  Offset of the first byte in the page (data then spare).
+ * \param buffer  Buffer where the bytes are stored.
+ * \param size  Number of bytes to read.
+ * \return 0 if successful; otherwise returns NandCommon_ERROR_CANNOTREAD.
+ */
+static unsigned char ReadArea(
+    unsigned short block,
+    unsigned short page,
+    unsigned int offset,
+    unsigned char *buffer,
+    unsigned int size)
+{
+    unsigned int pageSize = sim.dataSize + sim.spareSize;
+
+    if (sim.powerOff || (block >= sim.numBlocks) || (page >= sim.numPages)) {
+
+        return NandCommon_ERROR_CANNOTREAD;
+    }
+
+    if (sim.blocks[block]) {
+
+        memcpy(buffer, sim.blocks[block] + page * pageSize + offset, size);
+    }
+    else {
+
+        memset(buffer, 0xFF, size);
+    }
+
+    sim.stats.reads++;
+    sim.stats.bytesRead += size;
+    sim.stats.time += sim.config.readTime + size * sim.config.byteTime;
+
+    return 0;
+}
+
+/**
+ * \brief Flips 1 to maxBitFlips bits of the data read from a page, at the
+ * configured rate.
+ *
+ * \param data  Data area read.
+ */
+static void FlipBits(unsigned char *data)
+{
+    unsigned int numFlips = 1;
+    unsigned int bit;
+
+    if (Chance(sim.config.bitFlipPpm)) {
+
+        if (sim.config.maxBitFlips > 1) {
+
+            numFlips += Random() % sim.config.maxBitFlips;
+        }
+        while (numFlips-- > 0) {
+
+            bit = Random() % (sim.dataSize * 8);
+            data[bit / 8] ^= 1 << (bit % 8);
+            sim.stats.bitFlips++;
+        }
+    }
+}
+
+/**
+ * \brief Programs a page: the bytes are ANDed into the array. A power cut
+ * programs the first half of the data area only.
+ *
+ * \param block  Number of the block.
+ * \param page  Number of the page inside the block.
+ * \param data  Data area to program.
+ * \param spare  Spare area to program, can be 0.
+ * \param transfer  Adds the bus transfer time when set (0 for copy-back).
+ * \return 0 if successful; otherwise returns NandCommon_ERROR_CANNOTWRITE.
+ */
+static unsigned char ProgramPage(
+    unsigned short block,
+    unsigned short page,
+    const unsigned char *data,
+    const unsigned char *spare,
+    unsigned char transfer)
+{
+    unsigned int pageSize = sim.dataSize + sim.spareSize;
+    unsigned int size = sim.dataSize + (spare ? sim.spareSize : 0);
+    unsigned char *pPage;
+    unsigned char cut;
+    unsigned int i;
+
+    if (sim.powerOff || (block >= sim.numBlocks) || (page >= sim.numPages)) {
+
+        return NandCommon_ERROR_CANNOTWRITE;
+    }
+
+    sim.stats.programs++;
+    sim.stats.bytesProgrammed += size;
+    sim.stats.time += sim.config.programTime + (transfer ? size * sim.config.byteTime : 0);
+
+    if (IsWornOut(block)) {
+
+        sim.stats.failures++;
+        return NandCommon_ERROR_CANNOTWRITE;
+    }
+
+    cut = CutPower();
+    pPage = GetBlock(block) + page * pageSize;
+    for (i=0; i < (cut ? (sim.dataSize / 2) : sim.dataSize); i++) {
+
+        pPage[i] &= data[i];
+    }
+    if (cut) {
+
+        return NandCommon_ERROR_CANNOTWRITE;
+    }
+    if (spare) {
+
+        for (i=0; i < sim.spareSize; i++) {
+
+            pPage[sim.dataSize + i] &= spare[i];
+        }
+    }
+
+    /* A failed program leaves a corrupted byte in the page*/
+    if (Chance(sim.config.programFailPpm)) {
+
+        pPage[Random() % sim.dataSize] &= (unsigned char) Random();
+        sim.stats.failures++;
+        TRACE_DEBUG("SimNandFlash: program failure B#%d:P#%d\n\r", block, page);
+        return NandCommon_ERROR_CANNOTWRITE;
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Erases a block. A power cut erases the first half of its pages only.
+ *
+ * \param block  Number of the block.
+ * \return 0 if successful; otherwise returns NandCommon_ERROR_CANNOTERASE.
+ */
+static unsigned char EraseArray(unsigned short block)
+{
+    unsigned int pageSize = sim.dataSize + sim.spareSize;
+
+    if (sim.powerOff || (block >= sim.numBlocks)) {
+
+        return NandCommon_ERROR_CANNOTERASE;
+    }
+
+    sim.stats.erases++;
+    sim.stats.time += sim.config.eraseTime;
+    sim.eraseCounts[block]++;
+
+    if (IsWornOut(block) || Chance(sim.config.eraseFailPpm)) {
+
+        sim.stats.failures++;
+        TRACE_DEBUG("SimNandFlash: erase failure B#%d\n\r", block);
+        return NandCommon_ERROR_CANNOTERASE;
+    }
+
+    if (CutPower()) {
+
+        memset(GetBlock(block), 0xFF, (sim.numPages / 2) * pageSize);
+        return NandCommon_ERROR_CANNOTERASE;
+    }
+
+    free(sim.blocks[block]);
+    sim.blocks[block] = 0;
+
+    return 0;
+}
+
+/**
+ * \brief Returns the time taken by consecutive page reads or programs of a
+ * block striped on several dies: the bus transfers a page of a die while the
+ * other dies load or program theirs.
+ *
+ * \param numDies  Number of dies.
+ * \param page  Number of the first page inside the block.
+ * \param numPages  Number of pages.
+ * \param size  Number of bytes transferred per page.
+ * \param program  1 for programs, 0 for reads.
+ * \return the time in ns.
+ */
+static unsigned long long GetInterleavedTime(
+    unsigned char numDies,
+    unsigned short page,
+    unsigned short numPages,
+    unsigned int size,
+    unsigned char program)
+{
+    unsigned long long dieFree[RawNandFlash_MAXDIES];
+    unsigned long long bus = 0;
+    unsigned int transfer = size * sim.config.byteTime;
+    unsigned char die;
+    unsigned short i;
+
+    for (die=0; die < numDies; die++) {
+
+        dieFree[die] = program ? 0 : sim.config.readTime;
+    }
+    for (i=0; i < numPages; i++) {
+
+        die = (page + i) % numDies;
+        if (dieFree[die] > bus) {
+
+            bus = dieFree[die];
+        }
+        bus += transfer;
+        dieFree[die] = bus + (program ? sim.config.programTime : sim.config.readTime);
+    }
+    if (program) {
+
+        for (die=0; die < numDies; die++) {
+
+            if (dieFree[die] > bus) {
+
+                bus = dieFree[die];
+            }
+        }
+    }
+
+    return bus;
+}
+
+/**
+ * \brief Completes the background erase, if any, and invokes its callback.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ */
+static void FinishPending(const struct RawNandFlash *raw)
+{
+    MediaCallback callback = pending.callback;
+    void *argument = pending.argument;
+    unsigned char status = pending.status;
+
+    if (pending.raw != raw) {
+
+        return;
+    }
+
+    /* Callback may start the next operation*/
+    pending.raw = 0;
+    if (callback) {
+
+        callback(argument, status, (status == MED_STATUS_SUCCESS), (status != MED_STATUS_SUCCESS));
+    }
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Fills a configuration with the default values: 128MB device without
+ * bad blocks nor failures, typical SLC timings and a 20MB/s bus.
+ *
+ * \param config  Configuration to fill.
+ */
+void SimNandFlash_GetDefaultConfig(struct SimNandFlashConfig *config)
+{
+    memset(config, 0, sizeof(*config));
+    config->chipId = DEFAULT_CHIPID;
+    config->seed = 1;
+    config->readTime = 25000;
+    config->programTime = 250000;
+    config->eraseTime = 2000000;
+    config->byteTime = 50;
+}
+
+/**
+ * \brief Configures the simulated device. The contents are discarded: the
+ * next RawNandFlash_Initialize creates a blank device (factory bad blocks
+ * only).
+ *
+ * \param config  Configuration, 0 for the default one.
+ */
+void SimNandFlash_Configure(const struct SimNandFlashConfig *config)
+{
+    ReleaseDevice();
+    if (config) {
+
+        sim.config = *config;
+    }
+    else {
+
+        SimNandFlash_GetDefaultConfig(&sim.config);
+    }
+    sim.random = sim.config.seed ? sim.config.seed : 1;
+    sim.powerCut = 0;
+    sim.powerOff = 0;
+    sim.configured = 1;
+    SimNandFlash_ResetStats();
+}
+
+/**
+ * \brief Sets the number of dies striped by the devices initialized next:
+ * the geometry is multiplied, erases take the time of one die and
+ * RawNandFlash_ReadPages / RawNandFlash_WritePages overlap the dies.
+ *
+ * \param pinChipEnables  Chip enable pins of the dies 1 to numDies - 1 (unused).
+ * \param numDies  Number of dies: 1 for a single device, 2 or 4.
+ * \return 0 if successful; otherwise returns NandCommon_ERROR_UNKNOWNMODEL.
+ */
+unsigned char RawNandFlash_ConfigureDies(const Pin *pinChipEnables, unsigned char numDies)
+{
+    if ((numDies == 0) || (numDies > RawNandFlash_MAXDIES) || (numDies & (numDies - 1))
+#if defined(NandFlashModel_BLOCKSHIFT)
+        || (numDies > 1)
+#endif
+        ) {
+
+        TRACE_ERROR("RawNandFlash_ConfigureDies: %d dies not supported.\n\r", numDies);
+        return NandCommon_ERROR_UNKNOWNMODEL;
+    }
+    sim.numDies = numDies;
+
+    return 0;
+}
+
+/**
+ * \brief Cuts the power during the numOperations-th next program or erase
+ * operation. The operation is left incomplete and all the following ones
+ * fail until SimNandFlash_PowerOn is called.
+ *
+ * \param numOperations  Number of operations, 0 to cancel the power cut.
+ */
+void SimNandFlash_SetPowerCut(unsigned int numOperations)
+{
+    sim.powerCut = numOperations;
+}
+
+/**
+ * \brief Tells if the power has been cut.
+ */
+unsigned char SimNandFlash_IsPowerOff(void)
+{
+    return sim.powerOff;
+}
+
+/**
+ * \brief Restores the power after a power cut; the background operation is
+ * lost. The upper layers must be initialized again.
+ */
+void SimNandFlash_PowerOn(void)
+{
+    sim.powerOff = 0;
+    sim.powerCut = 0;
+    pending.raw = 0;
+}
+
+/**
+ * \brief Returns the counters of the simulated device.
+ */
+const struct SimNandFlashStats * SimNandFlash_GetStats(void)
+{
+    return &sim.stats;
+}
+
+/**
+ * \brief Clears the counters of the simulated device.
+ */
+void SimNandFlash_ResetStats(void)
+{
+    memset(&sim.stats, 0, sizeof(sim.stats));
+}
+
+/**
+ * \brief Returns the number of times a block has been erased.
+ *
+ * \param block  Number of the block.
+ */
+unsigned int SimNandFlash_GetEraseCount(unsigned short block)
+{
+    if (!sim.eraseCounts || (block >= sim.numBlocks)) {
+
+        return 0;
+    }
+
+    return sim.eraseCounts[block];
+}
+
+/**
+ * \brief Initializes the simulated device (the bus addresses and pins are
+ * stored but not used).
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param model  Pointer to the underlying nand chip model. Can be 0.
+ * \param commandAddress  Address at which commands are sent.
+ * \param addressAddress  Address at which addresses are sent.
+ * \param dataAddress  Address at which data is sent.
+ * \param pinChipEnable  Pin controlling the CE signal of the NandFlash.
+ * \param pinReadyBusy  Pin used to monitor the ready/busy signal of the Nand.
+ * \return 0 if successful; otherwise returns NandCommon_ERROR_UNKNOWNMODEL.
+ */
+unsigned char RawNandFlash_Initialize(
+    struct RawNandFlash *raw,
+    const struct NandFlashModel *model,
+    unsigned int commandAddress,
+    unsigned int addressAddress,
+    unsigned int dataAddress,
+    const Pin pinChipEnable,
+    const Pin pinReadyBusy)
+{
+    TRACE_DEBUG("RawNandFlash_Initialize()\r\n");
+
+    if (!sim.configured) {
+
+        SimNandFlash_Configure(0);
+    }
+
+    raw->commandAddress = commandAddress;
+    raw->addressAddress = addressAddress;
+    raw->dataAddress = dataAddress;
+    raw->pinChipEnable = pinChipEnable;
+    raw->pinReadyBusy = pinReadyBusy;
+    raw->numDies = 1;
+
+    RawNandFlash_Reset(raw);
+
+    /* If model is not provided, autodetect it*/
+    if (!model) {
+
+        if (NandFlashModel_Find(nandFlashModelList,
+                                NandFlashModelList_SIZE,
+                                RawNandFlash_ReadId(raw),
+                                &(raw->model))) {
+
+            TRACE_ERROR(
+                      "RawNandFlash_Initialize: Could not autodetect chip.\n\r");
+            return NandCommon_ERROR_UNKNOWNMODEL;
+        }
+    }
+    else {
+
+        raw->model = *model;
+        if (NandFlashModel_UpdateShifts(&(raw->model))) {
+
+            return NandCommon_ERROR_UNKNOWNMODEL;
+        }
+    }
+
+    if (sim.numDies > 1) {
+
+        if (NandFlashModel_GetBlockSizeInPages(MODEL(raw)) * sim.numDies
+            > NandCommon_MAXNUMPAGESPERBLOCK) {
+
+            TRACE_ERROR("RawNandFlash_Initialize: Blocks of %d dies are too large.\n\r",
+                        sim.numDies);
+            return NandCommon_ERROR_UNKNOWNMODEL;
+        }
+        raw->numDies = sim.numDies;
+        raw->model.deviceSizeInMegaBytes *= sim.numDies;
+        raw->model.blockSizeInKBytes *= sim.numDies;
+        raw->model.blockShift += RawNandFlash_DIESHIFT(sim.numDies);
+    }
+
+    CreateDevice(raw);
+
+    return 0;
+}
+
+/**
+ * \brief Resets a NandFlash device.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ */
+void RawNandFlash_Reset(const struct RawNandFlash *raw)
+{
+    FinishPending(raw);
+}
+
+/**
+ * \brief Reads and returns the identifiers of a NandFlash chip.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \return id1|(id2<<8)|(id3<<16)|(id4<<24)
+ */
+unsigned int RawNandFlash_ReadId(const struct RawNandFlash *raw)
+{
+    FinishPending(raw);
+
+    return sim.config.chipId;
+}
+
+/**
+ * \brief Erases the specified block of the device, retrying several time if it fails.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param block  Number of the physical block to erase.
+ * \return 0 if successful; otherwise returns NandCommon_ERROR_BADBLOCK.
+ */
+unsigned char RawNandFlash_EraseBlock(
+    const struct RawNandFlash *raw,
+    unsigned short block)
+{
+    unsigned char numTries = NUMERASETRIES;
+
+    TRACE_DEBUG("RawNandFlash_EraseBlock(B#%d)\n\r", block);
+
+    FinishPending(raw);
+    while (numTries > 0) {
+
+        if (!EraseArray(block)) {
+
+            return 0;
+        }
+        numTries--;
+    }
+
+    TRACE_ERROR("RawNandFlash_EraseBlock: Failed to erase %d after %d tries\n\r",
+                block, NUMERASETRIES);
+    return NandCommon_ERROR_BADBLOCK;
+}
+
+/**
+ * \brief Does nothing: the simulated device has no ready/busy signal.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ */
+void RawNandFlash_ConfigureReadyInterrupt(const struct RawNandFlash *raw)
+{
+    (void) raw;
+}
+
+/**
+ * \brief Does nothing: the background erase completes from RawNandFlash_Poll
+ * or the next operation.
+ *
+ * \param notify  Function called at the end of the operation.
+ * \param argument  Argument of the function.
+ */
+void RawNandFlash_SetReadyNotify(void (*notify)(void *argument), void *argument)
+{
+    (void) notify;
+    (void) argument;
+}
+
+/**
+ * \brief Erases a block; the callback is invoked with MED_STATUS_SUCCESS or
+ * MED_STATUS_ERROR from RawNandFlash_Poll, or from the next operation on
+ * the device. The block is not retried on failure.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param block  Number of the physical block to erase.
+ * \param callback  Completion callback, can be 0.
+ * \param argument  Callback argument.
+ * \return 0 if the erase has been started.
+ */
+unsigned char RawNandFlash_StartEraseBlock(
+    const struct RawNandFlash *raw,
+    unsigned short block,
+    MediaCallback callback,
+    void *argument)
+{
+    TRACE_DEBUG("RawNandFlash_StartEraseBlock(B#%d)\n\r", block);
+
+    FinishPending(raw);
+    pending.status = EraseArray(block) ? MED_STATUS_ERROR : MED_STATUS_SUCCESS;
+    pending.raw = raw;
+    pending.callback = callback;
+    pending.argument = argument;
+
+    return 0;
+}
+
+/**
+ * \brief Completes the background operation, if any.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \return 0 (the simulated operations are over when started).
+ */
+unsigned char RawNandFlash_Poll(const struct RawNandFlash *raw)
+{
+    FinishPending(raw);
+
+    return 0;
+}
+
+/**
+ * \brief Completes the background operation, if any.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ */
+void RawNandFlash_Finish(const struct RawNandFlash *raw)
+{
+    FinishPending(raw);
+}
+
+/**
+ * \brief Reads the data and/or the spare areas of a page of a NandFlash into the  provided buffers.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param block  Number of the physical block to read.
+ * \param page  Number of the page to read inside the given block.
+ * \param data  Buffer where the data area will be read.
+ * \param spare  Buffer where the spare area will be read.
+ * \return 0 if successful; otherwise returns NandCommon_ERROR_CANNOTREAD.
+ * \note If one of the buffer pointer is 0, the corresponding area is not read.
+ */
+unsigned char RawNandFlash_ReadPage(
+    const struct RawNandFlash *raw,
+    unsigned short block,
+    unsigned short page,
+    void *data,
+    void *spare)
+{
+    unsigned char error;
+
+    assert( data || spare ) ; /* "RawNandFlash_ReadPage: At least one area must be read\n\r" */
+    TRACE_DEBUG("RawNandFlash_ReadPage(B#%d:P#%d)\r\n", block, page);
+
+    FinishPending(raw);
+    if (data) {
+
+        error = ReadArea(block, page, 0, (unsigned char *) data, sim.dataSize);
+        if (error) {
+
+            return error;
+        }
+        FlipBits((unsigned char *) data);
+        if (spare) {
+
+            /* Same array read, only the transfer time is added*/
+            sim.stats.reads--;
+            sim.stats.time -= sim.config.readTime;
+        }
+    }
+    if (spare) {
+
+        return ReadArea(block, page, sim.dataSize, (unsigned char *) spare, sim.spareSize);
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Reads some bytes of the spare area of a page.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param block  Number of the physical block to read.
+ * \param page  Number of the page to read inside the given block.
+ * \param offset  Index of the first spare byte to read.
+ * \param buffer  Buffer where the bytes will be stored.
+ * \param size  Number of bytes to read.
+ * \return 0 if successful; otherwise returns NandCommon_ERROR_CANNOTREAD.
+ */
+unsigned char RawNandFlash_ReadSpare(
+    const struct RawNandFlash *raw,
+    unsigned short block,
+    unsigned short page,
+    unsigned char offset,
+    void *buffer,
+    unsigned char size)
+{
+    assert( offset + size <= NandFlashModel_GetPageSpareSize(MODEL(raw)) ) ;
+    TRACE_DEBUG("RawNandFlash_ReadSpare(B#%d:P#%d:%d+%d)\r\n", block, page, offset, size);
+
+    FinishPending(raw);
+
+    return ReadArea(block, page, sim.dataSize + offset, (unsigned char *) buffer, size);
+}
+
+/**
+ * \brief Reads the bad block markers (in the spare area of the first two
+ * pages) of consecutive blocks, and sets the bits of the bad ones in a bitmap.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param firstBlock  Number of the first physical block to check.
+ * \param numBlocks  Number of blocks to check.
+ * \param bitmap  Bitmap of (numBlocks + 7) / 8 bytes, bit (i % 8) of byte
+ * (i / 8) is set if block firstBlock + i is bad.
+ * \return 0 if successful; otherwise returns an error code.
+ */
+unsigned char RawNandFlash_ReadBadBlockMarkers(
+    const struct RawNandFlash *raw,
+    unsigned short firstBlock,
+    unsigned short numBlocks,
+    unsigned char *bitmap)
+{
+    const struct NandSpareScheme *scheme = NandFlashModel_GetScheme(MODEL(raw));
+    unsigned char marker;
+    unsigned char error;
+    unsigned short i;
+    unsigned short page;
+
+    TRACE_DEBUG("RawNandFlash_ReadBadBlockMarkers(B#%d+%d)\r\n", firstBlock, numBlocks);
+
+    memset(bitmap, 0, (numBlocks + 7) / 8);
+    for (i=0; i < numBlocks; i++) {
+
+        for (page=0; page < 2 * raw->numDies; page++) {
+
+            error = RawNandFlash_ReadSpare(raw, firstBlock + i, page,
+                                           scheme->badBlockMarkerPosition, &marker, 1);
+            if (error) {
+
+                return error;
+            }
+            if (marker != 0xFF) {
+
+                bitmap[i / 8] |= 1 << (i % 8);
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Writes the data and/or the spare area of a page on a NandFlash chip.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param block  Number of the block where the page to write resides.
+ * \param page  Number of the page to write inside the given block.
+ * \param data  Buffer containing the data area.
+ * \param spare  Buffer containing the spare area, can be 0.
+ * \return 0 if successful; otherwise returns NandCommon_ERROR_BADBLOCK.
+ */
+unsigned char RawNandFlash_WritePage(
+    const struct RawNandFlash *raw,
+    unsigned short block,
+    unsigned short page,
+    void *data,
+    void *spare)
+{
+    unsigned char numTries = NUMWRITETRIES;
+    unsigned char blank[NandCommon_MAXPAGEDATASIZE];
+
+    TRACE_DEBUG("RawNandFlash_WritePage(B#%d:P#%d)\r\n", block, page);
+
+    FinishPending(raw);
+    if (!data) {
+
+        memset(blank, 0xFF, sim.dataSize);
+        data = blank;
+    }
+    while (numTries > 0) {
+
+        if (!ProgramPage(block, page, (unsigned char *) data, (unsigned char *) spare, 1)) {
+
+            return 0;
+        }
+        numTries--;
+    }
+
+    TRACE_ERROR("RawNandFlash_WritePage: Failed to write page after %d tries\n\r", NUMWRITETRIES);
+    return NandCommon_ERROR_BADBLOCK;
+}
+
+/**
+ * \brief Reads consecutive pages of a block into the provided buffers.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param block  Number of the physical block to read.
+ * \param page  Number of the first page to read inside the given block.
+ * \param numPages  Number of pages to read (in the same block).
+ * \param data  Buffer where the data areas will be read, one after the other.
+ * \param spare  Buffer where the spare areas will be read, can be 0.
+ * \return 0 if successful; otherwise returns an error code.
+ */
+unsigned char RawNandFlash_ReadPages(
+    const struct RawNandFlash *raw,
+    unsigned short block,
+    unsigned short page,
+    unsigned short numPages,
+    void *data,
+    void *spare)
+{
+    unsigned char *pData = (unsigned char *) data;
+    unsigned char *pSpare = (unsigned char *) spare;
+    unsigned long long start;
+    unsigned char error;
+    unsigned short i;
+
+    assert( data ) ; /* "RawNandFlash_ReadPages: Data area must be read\n\r" */
+    assert( page + numPages <= NandFlashModel_GetBlockSizeInPages(MODEL(raw)) ) ;
+    TRACE_DEBUG("RawNandFlash_ReadPages(B#%d:P#%d+%d)\r\n", block, page, numPages);
+
+    FinishPending(raw);
+    start = sim.stats.time;
+
+    for (i=0; i < numPages; i++) {
+
+        error = RawNandFlash_ReadPage(raw, block, page + i, pData, pSpare);
+        if (error) {
+
+            return error;
+        }
+        pData += sim.dataSize;
+        if (pSpare) {
+
+            pSpare += sim.spareSize;
+        }
+    }
+
+    /* The dies load their pages while the bus transfers the others*/
+    if (raw->numDies > 1) {
+
+        sim.stats.time = start + GetInterleavedTime(raw->numDies, page, numPages,
+                                                    sim.dataSize + (spare ? sim.spareSize : 0), 0);
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Programs consecutive pages of a block. Pages are not retried.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param block  Number of the physical block to write.
+ * \param page  Number of the first page to write inside the given block.
+ * \param numPages  Number of pages to write (in the same block).
+ * \param data  Buffer containing the data areas, one after the other.
+ * \param spare  Buffer containing the spare areas, can be 0.
+ * \return 0 if successful; otherwise returns NandCommon_ERROR_CANNOTWRITE.
+ */
+unsigned char RawNandFlash_WritePages(
+    const struct RawNandFlash *raw,
+    unsigned short block,
+    unsigned short page,
+    unsigned short numPages,
+    void *data,
+    void *spare)
+{
+    unsigned char *pData = (unsigned char *) data;
+    unsigned char *pSpare = (unsigned char *) spare;
+    unsigned long long start;
+    unsigned short i;
+
+    assert( data ) ; /* "RawNandFlash_WritePages: Data area must be written\n\r" */
+    assert( page + numPages <= NandFlashModel_GetBlockSizeInPages(MODEL(raw)) ) ;
+    TRACE_DEBUG("RawNandFlash_WritePages(B#%d:P#%d+%d)\r\n", block, page, numPages);
+
+    FinishPending(raw);
+    start = sim.stats.time;
+    for (i=0; i < numPages; i++) {
+
+        if (ProgramPage(block, page + i, pData, pSpare, 1)) {
+
+            TRACE_ERROR("RawNandFlash_WritePages: Failed at B#%d:P#%d\n\r",
+                        block, page + i);
+            return NandCommon_ERROR_CANNOTWRITE;
+        }
+        pData += sim.dataSize;
+        if (pSpare) {
+
+            pSpare += sim.spareSize;
+        }
+    }
+
+    /* A page is transferred to a die while the others are programming*/
+    if (raw->numDies > 1) {
+
+        sim.stats.time = start + GetInterleavedTime(raw->numDies, page, numPages,
+                                                    sim.dataSize + (spare ? sim.spareSize : 0), 1);
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Programs the same page in the two blocks of a plane pair (block and
+ * block + 1).
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param block  Number of the even physical block (plane 0).
+ * \param page  Number of the page to write inside the blocks.
+ * \param data  Buffer containing the two data areas, one after the other.
+ * \param spare  Buffer containing the two spare areas, can be 0.
+ * \return 0 if successful; otherwise returns NandCommon_ERROR_CANNOTWRITE.
+ */
+unsigned char RawNandFlash_WritePageTwoPlanes(
+    const struct RawNandFlash *raw,
+    unsigned short block,
+    unsigned short page,
+    void *data,
+    void *spare)
+{
+    unsigned char *pData = (unsigned char *) data;
+    unsigned char *pSpare = (unsigned char *) spare;
+
+    assert( data ) ; /* "RawNandFlash_WritePageTwoPlanes: Data area must be written\n\r" */
+    assert( (block & 1) == 0 ) ;
+    TRACE_DEBUG("RawNandFlash_WritePageTwoPlanes(B#%d+1:P#%d)\r\n", block, page);
+
+    FinishPending(raw);
+    if (ProgramPage(block, page, pData, pSpare, 1)
+        || ProgramPage(block + 1, page, pData + sim.dataSize,
+                       pSpare ? pSpare + sim.spareSize : 0, 1)) {
+
+        TRACE_ERROR("RawNandFlash_WritePageTwoPlanes: Failed at B#%d:P#%d\n\r",
+                    block, page);
+        return NandCommon_ERROR_CANNOTWRITE;
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Copies the data and spare areas of a page into another page
+ * (copy-back: no bus transfer).
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param sourceBlock  Source block number.
+ * \param sourcePage  Number of the source page inside the source block.
+ * \param destBlock  Destination block number.
+ * \param destPage  Number of the destination page inside the dest block.
+ * \return 0 if successful; otherwise returns an NandCommon_ERROR_BADBLOCK.
+ */
+unsigned char RawNandFlash_CopyPage(
+    const struct RawNandFlash *raw,
+    unsigned short sourceBlock,
+    unsigned short sourcePage,
+    unsigned short destBlock,
+    unsigned short destPage)
+{
+    unsigned char page[NandCommon_MAXPAGEDATASIZE + NandCommon_MAXPAGESPARESIZE];
+    unsigned char numTries = NUMCOPYTRIES;
+
+    TRACE_DEBUG("RawNandFlash_CopyPage(B#%d:P#%d -> B#%d:P#%d)\n\r",
+                sourceBlock, sourcePage, destBlock, destPage);
+
+    FinishPending(raw);
+    while (numTries > 0) {
+
+        if (!ReadArea(sourceBlock, sourcePage, 0, page, sim.dataSize + sim.spareSize)) {
+
+            /* Only the array times count*/
+            sim.stats.reads--;
+            sim.stats.bytesRead -= sim.dataSize + sim.spareSize;
+            sim.stats.time -= (sim.dataSize + sim.spareSize) * sim.config.byteTime;
+            sim.stats.copies++;
+            if (!ProgramPage(destBlock, destPage, page, page + sim.dataSize, 0)) {
+
+                return 0;
+            }
+        }
+        numTries--;
+    }
+
+    TRACE_ERROR("RawNandFlash_CopyPage: Failed to copy page after %d tries\n\r", NUMCOPYTRIES);
+    return NandCommon_ERROR_BADBLOCK;
+}
+
+/**
+ * \brief Copies the data from a whole block to another block on a nandflash.
+ *
+ * \param raw  Pointer to a RawNandFlash instance.
+ * \param sourceBlock  Source block number.
+ * \param destBlock  Destination block number.
+ * \return 0 if successful; otherwise returns an NandCommon_ERROR_BADBLOCK.
+ */
+unsigned char RawNandFlash_CopyBlock(
+    const struct RawNandFlash *raw,
+    unsigned short sourceBlock,
+    unsigned short destBlock)
+{
+    unsigned short i;
+
+    TRACE_DEBUG("RawNandFlash_CopyBlock(B#%d->B#%d)\n\r", sourceBlock, destBlock);
+
+    for (i=0; i < sim.numPages; i++) {
+
+        if (RawNandFlash_CopyPage(raw, sourceBlock, i, destBlock, i)) {
+
+            TRACE_ERROR( "RawNandFlash_CopyBlock: Failed to copy page %u\n\r", i ) ;
+            return NandCommon_ERROR_BADBLOCK;
+        }
+    }
+
+    return 0;
+}
+
+#endif /* NAND_SIMULATOR */
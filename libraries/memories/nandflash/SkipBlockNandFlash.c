@@ -76,39 +76,18 @@ unsigned char SkipBlockNandFlash_CheckBlock(
     unsigned short block)
 {
 	#if !defined (OP_BOOTSTRAP_on)
-    unsigned char spare[NandCommon_MAXPAGESPARESIZE];
     unsigned char error;
-    unsigned char badBlockMarker;
-    const struct NandSpareScheme *scheme;
-
-
-    /* Retrieve model scheme */
-    scheme = NandFlashModel_GetScheme(MODEL(skipBlock));
-
-    /* Read spare area of first page of block */
-    error = RawNandFlash_ReadPage(RAW(skipBlock), block, 0, 0, spare);
-    if (error) {
-
-        TRACE_ERROR("CheckBlock: Cannot read page #0 of block #%d\n\r", block);
-        return error;
-    }
-
-    NandSpareScheme_ReadBadBlockMarker(scheme, spare, &badBlockMarker);
-    if (badBlockMarker != 0xFF) {
-
-        return BADBLOCK;
-    }
+    unsigned char bitmap;
 
-    /* Read spare area of second page of block */
-    error = RawNandFlash_ReadPage(RAW(skipBlock), block, 1, 0, spare);
+    /* Read the bad block markers of the first two pages of block */
+    error = RawNandFlash_ReadBadBlockMarkers(RAW(skipBlock), block, 1, &bitmap);
     if (error) {
 
-        TRACE_ERROR("CheckBlock: Cannot read page #1 of block #%d\n\r", block);
+        TRACE_ERROR("CheckBlock: Cannot read block #%d\n\r", block);
         return error;
     }
 
-    NandSpareScheme_ReadBadBlockMarker(scheme, spare, &badBlockMarker);
-    if (badBlockMarker != 0xFF) {
+    if (bitmap) {
 
         return BADBLOCK;
     }
@@ -140,8 +119,11 @@ unsigned char SkipBlockNandFlash_Initialize(
 {
     unsigned char error;
 	#if !defined(OP_BOOTSTRAP_on)
+    unsigned char bitmap[32];
     unsigned int numBlocks;
     unsigned int block;
+    unsigned int count;
+    unsigned int i;
 	#endif
 
     TRACE_DEBUG("SkipBlockNandFlash_Initialize()\n\r");
@@ -177,22 +159,23 @@ unsigned char SkipBlockNandFlash_Initialize(
     /* Initialize block statuses */
     TRACE_DEBUG("Retrieving bad block information ...\n\r");
 
-    /* Retrieve block status from their first page spare area */
-    for (block = 0; block < numBlocks; block++) {
+    /* Retrieve the bad block markers, by groups of blocks */
+    for (block = 0; block < numBlocks; block += count) {
 
-        /* Read spare of first page */
-        error = SkipBlockNandFlash_CheckBlock(skipBlock, block);
+        count = min(numBlocks - block, sizeof(bitmap) * 8);
+        error = RawNandFlash_ReadBadBlockMarkers(RAW(skipBlock), block, count, bitmap);
+        if (error) {
 
-        if (error != GOODBLOCK) {
+            TRACE_ERROR(
+            "SkipBlockNandFlash_Initialize: Cannot retrieve info from block #%u\n\r", block);
+            continue;
+        }
 
-            if (error == BADBLOCK) {
+        for (i = 0; i < count; i++) {
 
-                TRACE_DEBUG("Block #%d is bad\n\r", block);
-            }
-            else {
+            if (bitmap[i / 8] & (1 << (i % 8))) {
 
-                TRACE_ERROR(
-                "SkipBlockNandFlash_Initialize: Cannot retrieve info from block #%u\n\r", block);
+                TRACE_DEBUG("Block #%d is bad\n\r", block + i);
             }
         }
     }
@@ -62,6 +62,29 @@
 /*----------------------------------------------------------------------------
  *        Local functions
  *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Returns the number of logical blocks currently open for writing.
+ *
+ * \param translated  Pointer to a TranslatedNandFlash instance.
+ * \return the number of used write blocks.
+ */
+static unsigned char CountWriteBlocks(
+    const struct TranslatedNandFlash *translated)
+{
+    unsigned char i, count = 0;
+
+    for (i=0; i < TRANSLATEDNANDFLASH_WRITEBLOCKS; i++) {
+
+        if (translated->writeBlocks[i].logicalBlock != -1) {
+
+            count++;
+        }
+    }
+
+    return count;
+}
+
 /**
  * \brief Check is there are enough free block could be allocated.
  *
@@ -75,9 +98,11 @@ static unsigned char BlockCanBeAllocated(
 {
     unsigned short count;
 
-    /* Count number of free and dirty blocks (unallocated blocks)*/
+    /* Count number of free and dirty blocks (unallocated blocks), log blocks
+       are given back by merges so they are counted as well */
     count = ManagedNandFlash_CountBlocks(MANAGED(translated), NandBlockStatus_DIRTY)
-            + ManagedNandFlash_CountBlocks(MANAGED(translated), NandBlockStatus_FREE);
+            + ManagedNandFlash_CountBlocks(MANAGED(translated), NandBlockStatus_FREE)
+            + CountWriteBlocks(translated);
 
     /* Check that count is greater than minimum number of unallocated blocks*/
     if (count > MINNUMUNALLOCATEDBLOCKS) {
@@ -91,98 +116,331 @@ static unsigned char BlockCanBeAllocated(
 }
 
 /**
- * \brief Check the given page inside the currently written block is clean or not.
+ * \brief Check if the given page of a write block is held by its log.
+ *
+ * \param writeBlock  Pointer to a TranslatedWriteBlock instance.
+ * \param page  Page number inside the logical block.
+ * \return 1 if the page has been written in the log block; otherwise returns 0.
+ */
+static unsigned char PageIsLogged(
+    const struct TranslatedWriteBlock *writeBlock,
+    unsigned short page)
+{
+    return (writeBlock->pageLogged[page / 8] >> (page % 8)) & 1;
+}
+
+/**
+ * \brief Returns the write block opened for the given logical block.
  *
  * \param translated  Pointer to a TranslatedNandFlash instance.
- * \param page  Page number.
- * \return 1 if the given page inside the currently written block is clean (has
- * not been written yet); otherwise returns 0.
+ * \param block  Logical block number.
+ * \return a pointer to the write block, or 0 if the block is not open.
  */
-static unsigned char PageIsClean(
+static struct TranslatedWriteBlock * FindWriteBlock(
     const struct TranslatedNandFlash *translated,
-    unsigned short page)
+    unsigned short block)
 {
-    assert( page < NandFlashModel_GetBlockSizeInPages(MODEL(translated)) ) ; /* "PageIsClean: Page out-of-bounds\n\r" */
+    unsigned char i;
+
+    for (i=0; i < TRANSLATEDNANDFLASH_WRITEBLOCKS; i++) {
+
+        if (translated->writeBlocks[i].logicalBlock == block) {
+
+            return (struct TranslatedWriteBlock *) &(translated->writeBlocks[i]);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Saves the changes of the logical mapping and of the write blocks as
+ * a record of the mapping journal, then saves the checkpoint used to mount
+ * the device without scanning it. Only saves the checkpoint if the mapping
+ * and the write blocks are unchanged.
+ *
+ * \param translated  Pointer to a TranslatedNandFlash instance.
+ * \return 0 if successful; otherwise returns NandCommon_ERROR_JOURNALFULL if
+ * the whole mapping must be saved in a new block, or a NandCommon_ERROR code.
+ */
+static unsigned char AppendJournal(struct TranslatedNandFlash *translated)
+{
+    unsigned char error;
+
+    if (MAPPED(translated)->mappingModified || translated->writeBlocksModified) {
+
+        error = MappedNandFlash_AppendJournal(MAPPED(translated),
+                                              translated->writeBlocks,
+                                              sizeof(translated->writeBlocks));
+        if (error) {
+
+            return error;
+        }
+        translated->writeBlocksModified = 0;
+    }
+    /* Statuses may have changed (e.g. erased dirty blocks)*/
+    else if (MANAGED(translated)->checkpoint.state == NandCheckpoint_CLEAN) {
+
+        return 0;
+    }
 
-    return ((translated->currentBlockPageStatuses[page / 8] >> (page % 8)) & 1) == 0;
+    return MappedNandFlash_SaveCheckpoint(MAPPED(translated));
 }
 
 /**
- * \brief Marks the given page as being dirty (i.e. written).
+ * \brief Saves the logical mapping in the given FREE block, together with the
+ * write blocks (first record of the mapping journal) so that the logs survive
+ * a reset without being merged. Then saves the checkpoint used to mount the
+ * device without scanning it.
  *
  * \param translated  Pointer to a TranslatedNandFlash instance.
- * \param page  Page number.
+ * \param physicalBlock  Physical block number.
+ * \return 0 if successful; otherwise returns a NandCommon_ERROR code.
  */
-static void MarkPageDirty(
+static unsigned char SaveCheckpoint(
     struct TranslatedNandFlash *translated,
+    unsigned short physicalBlock)
+{
+    unsigned char error;
+
+    /* Always start a new mapping block, even if only the logs changed*/
+    MAPPED(translated)->mappingModified = 1;
+    error = MappedNandFlash_SaveLogicalMapping(MAPPED(translated),
+                                               physicalBlock,
+                                               translated->writeBlocks,
+                                               sizeof(translated->writeBlocks));
+    if (error) {
+
+        TRACE_ERROR("SaveCheckpoint: Failed to save the mapping\n\r");
+        return error;
+    }
+    translated->writeBlocksModified = 0;
+
+    /* Last, so that the checkpoint describes everything saved before*/
+    return MappedNandFlash_SaveCheckpoint(MAPPED(translated));
+}
+
+/**
+ * \brief Check if a page is erased, i.e. its data and spare areas only hold
+ * 0xFF, without going through the ECC.
+ *
+ * \param translated  Pointer to a TranslatedNandFlash instance.
+ * \param block  Physical block number.
+ * \param page  Number of the page inside the block.
+ * \return 1 if the page is erased; otherwise returns 0.
+ */
+static unsigned char PageIsErased(
+    const struct TranslatedNandFlash *translated,
+    unsigned short block,
     unsigned short page)
 {
-    assert( page < NandFlashModel_GetBlockSizeInPages(MODEL(translated)) ) ; /* "PageIsClean: Page out-of-bounds\n\r" */
+    unsigned char data[NandCommon_MAXPAGEDATASIZE];
+    unsigned char spare[NandCommon_MAXPAGESPARESIZE];
+    unsigned short pageDataSize = NandFlashModel_GetPageDataSize(MODEL(translated));
+    unsigned short pageSpareSize = NandFlashModel_GetPageSpareSize(MODEL(translated));
+    unsigned short i;
+
+    if (RawNandFlash_ReadPage(RAW(translated),
+                              MANAGED(translated)->baseBlock + block,
+                              page, data, spare)) {
 
-    translated->currentBlockPageStatuses[page / 8] |= 1 << (page % 8);
+        return 0;
+    }
+    for (i=0; i < pageDataSize; i++) {
+
+        if (data[i] != 0xFF) {
+
+            return 0;
+        }
+    }
+    for (i=0; i < pageSpareSize; i++) {
+
+        if (spare[i] != 0xFF) {
+
+            return 0;
+        }
+    }
+
+    return 1;
 }
 
 /**
- * \brief Marks all pages as being clean.
+ * \brief Restores the write blocks saved in the mapping journal. Only the
+ * logs still LIVE are kept: a DIRTY log has been merged or discarded after
+ * the record. Pages programmed after the record (possibly torn by a power
+ * loss) are not in its page map, so the log resumes at its first erased page
+ * and they are never read. Last, the unmapped LIVE blocks which are not logs
+ * are released, and the DIRTY blocks are erased if no FREE block is left.
  *
  * \param translated  Pointer to a TranslatedNandFlash instance.
+ * \return 0 if successful; otherwise returns a NandCommon_ERROR code.
  */
-static void MarkAllPagesClean( struct TranslatedNandFlash *translated )
+static unsigned char LoadCheckpoint(struct TranslatedNandFlash *translated)
 {
-    memset( translated->currentBlockPageStatuses, 0, sizeof( translated->currentBlockPageStatuses ) ) ;
+    unsigned short numPages = NandFlashModel_GetBlockSizeInPages(MODEL(translated));
+    unsigned short numBlocks = ManagedNandFlash_GetDeviceSizeInBlocks(MANAGED(translated));
+    signed short logBlocks[TRANSLATEDNANDFLASH_WRITEBLOCKS];
+    struct TranslatedWriteBlock *writeBlock;
+    unsigned char error = NandCommon_ERROR_NOMAPPING;
+    unsigned short block;
+    unsigned char i;
+
+    /* Read the write blocks of the last record holding them*/
+    if (MAPPED(translated)->logicalMappingBlock != -1) {
+
+        error = MappedNandFlash_ReadJournalExtra(MAPPED(translated),
+                                                 translated->writeBlocks,
+                                                 sizeof(translated->writeBlocks));
+        if (error && (error != NandCommon_ERROR_NOMAPPING)) {
+
+            TRACE_WARNING("LoadCheckpoint: Failed to read the write blocks\n\r");
+        }
+    }
+
+    /* Check each write block against the block statuses*/
+    for (i=0; i < TRANSLATEDNANDFLASH_WRITEBLOCKS; i++) {
+
+        writeBlock = &(translated->writeBlocks[i]);
+        logBlocks[i] = -1;
+        if (error) {
+
+            writeBlock->logicalBlock = -1;
+            continue;
+        }
+        if (writeBlock->logicalBlock == -1) {
+
+            continue;
+        }
+        if ((writeBlock->logicalBlock >= numBlocks)
+            || (writeBlock->physicalBlock < 0)
+            || (writeBlock->physicalBlock >= numBlocks)
+            || (writeBlock->nextPage > numPages)) {
+
+            writeBlock->logicalBlock = -1;
+            continue;
+        }
+        logBlocks[i] = writeBlock->physicalBlock;
+        if ((MANAGED(translated)->blockStatuses[writeBlock->physicalBlock].status
+             != NandBlockStatus_LIVE)
+            || (MappedNandFlash_PhysicalToLogical(MAPPED(translated),
+                                                  writeBlock->physicalBlock) != -1)) {
+
+            TRACE_WARNING_WP("-I- Drop log #%d of LB#%d\n\r",
+                             writeBlock->physicalBlock, writeBlock->logicalBlock);
+            writeBlock->logicalBlock = -1;
+            /* Record it before the block is erased and used again*/
+            translated->writeBlocksModified = 1;
+            continue;
+        }
+
+        /* Skip the pages programmed since the record*/
+        while ((writeBlock->nextPage < numPages)
+               && !PageIsErased(translated, writeBlock->physicalBlock,
+                                writeBlock->nextPage)) {
+
+            writeBlock->nextPage++;
+        }
+        writeBlock->lastUse = 0;
+    }
+
+    error = MappedNandFlash_ReleaseUnmappedBlocks(MAPPED(translated), logBlocks,
+                                                  TRANSLATEDNANDFLASH_WRITEBLOCKS);
+    if (error) {
+
+        return error;
+    }
+
+    /* No FREE block is left to save the mapping in (e.g. power loss while it
+       was saved in the last one): erase the DIRTY blocks right away, neither
+       the saved mapping nor the saved logs use them (but the dropped logs)*/
+    if (ManagedNandFlash_CountBlocks(MANAGED(translated), NandBlockStatus_FREE) == 0) {
+
+        for (block=0; block < numBlocks; block++) {
+
+            if (MANAGED(translated)->blockStatuses[block].status != NandBlockStatus_DIRTY) {
+
+                continue;
+            }
+            for (i=0; (i < TRANSLATEDNANDFLASH_WRITEBLOCKS) && (logBlocks[i] != block); i++);
+            if (i == TRANSLATEDNANDFLASH_WRITEBLOCKS) {
+
+                error = ManagedNandFlash_EraseBlock(MANAGED(translated), block);
+                if (error) {
+
+                    return error;
+                }
+            }
+        }
+    }
+
+    return 0;
 }
 
 /**
- * \brief  Allocates the best-fitting physical block for the given logical block.
+ * \brief  Finds the best-fitting FREE physical block for the next allocation.
+ * Cleans up the dirty blocks if needed and keeps the wear even between the
+ * FREE and LIVE blocks.
  *
  * \param translated  Pointer to a TranslatedNandFlash instance.
- * \param block  Logical block number.
+ * \param freeBlock  Pointer to the block number variable.
  * \return 0 if successful; otherwise returns NandCommon_ERROR_NOBLOCKFOUND if
  * there are no more free blocks, or a NandCommon_ERROR code.
  */
-static unsigned char AllocateBlock(
+static unsigned char FindFreeBlock(
     struct TranslatedNandFlash *translated,
-    unsigned short block)
+    unsigned short *freeBlock)
 {
-    unsigned short freeBlock, liveBlock;
+    unsigned short liveBlock;
+    signed short logicalBlock;
     unsigned char error;
     signed int eraseDifference;
 
     TRACE_DEBUG("Allocating a new block\n\r");
 
-    /* Find youngest free block and youngest live block*/
-    if (ManagedNandFlash_FindYoungestBlock(MANAGED(translated),
-                                           NandBlockStatus_FREE,
-                                           &freeBlock)) {
-
-        TRACE_ERROR("AllocateBlock: Could not find a free block\n\r");
-        return NandCommon_ERROR_NOBLOCKFOUND;
-    }
-
-    /* If this is the last free block, save the logical mapping in it and clean dirty blocks */
+    /* If this is the last free block (or none is left), save the logical
+       mapping and clean dirty blocks (if there are some, otherwise this would
+       loop forever) */
     TRACE_DEBUG("Number of FREE blocks: %d\n\r",
               ManagedNandFlash_CountBlocks(MANAGED(translated), NandBlockStatus_FREE));
-    if (ManagedNandFlash_CountBlocks(MANAGED(translated),
-                                     NandBlockStatus_FREE) == 1) {
+    if ((ManagedNandFlash_CountBlocks(MANAGED(translated),
+                                      NandBlockStatus_FREE) <= 1)
+        && (ManagedNandFlash_CountBlocks(MANAGED(translated),
+                                         NandBlockStatus_DIRTY) > 0)) {
 
         /* Save mapping and clean dirty blocks*/
         TRACE_DEBUG("Last FREE block, cleaning up ...\n\r");
 
-        error = MappedNandFlash_SaveLogicalMapping(MAPPED(translated), freeBlock);
+        error = AppendJournal(translated);
+        if (error
+            && !ManagedNandFlash_FindYoungestBlock(MANAGED(translated),
+                                                   NandBlockStatus_FREE,
+                                                   freeBlock))
+        {
+            error = SaveCheckpoint(translated, *freeBlock);
+        }
         if (error)
         {
-            TRACE_ERROR("AllocateBlock: Failed to save mapping\n\r");
+            TRACE_ERROR("FindFreeBlock: Failed to save mapping\n\r");
             return error;
         }
         error = ManagedNandFlash_EraseDirtyBlocks(MANAGED(translated));
         if (error)
         {
-            TRACE_ERROR("AllocatedBlock: Failed to erase dirty blocks\n\r");
+            TRACE_ERROR("FindFreeBlock: Failed to erase dirty blocks\n\r");
             return error;
         }
 
-        /* Allocate new block*/
-        return AllocateBlock(translated, block);
+        /* Find a new block*/
+        return FindFreeBlock(translated, freeBlock);
+    }
+
+    /* Find youngest free block and youngest live block*/
+    if (ManagedNandFlash_FindYoungestBlock(MANAGED(translated),
+                                           NandBlockStatus_FREE,
+                                           freeBlock)) {
+
+        TRACE_ERROR("FindFreeBlock: Could not find a free block\n\r");
+        return NandCommon_ERROR_NOBLOCKFOUND;
     }
 
     /* Find youngest LIVE block to check the erase count difference*/
@@ -191,33 +449,250 @@ static unsigned char AllocateBlock(
                                             &liveBlock))
     {
         /* Calculate erase count difference*/
-        TRACE_DEBUG("Free block erase count = %d\n\r", MANAGED(translated)->blockStatuses[freeBlock].eraseCount);
+        TRACE_DEBUG("Free block erase count = %d\n\r", MANAGED(translated)->blockStatuses[*freeBlock].eraseCount);
         TRACE_DEBUG("Live block erase count = %d\n\r", MANAGED(translated)->blockStatuses[liveBlock].eraseCount);
-        eraseDifference = absv(MANAGED(translated)->blockStatuses[freeBlock].eraseCount
+        eraseDifference = absv(MANAGED(translated)->blockStatuses[*freeBlock].eraseCount
                               - MANAGED(translated)->blockStatuses[liveBlock].eraseCount);
 
-        /* Check if it is too big*/
-        if (eraseDifference > MAXERASEDIFFERENCE)
+        /* Check if it is too big, only data blocks can be moved*/
+        logicalBlock = MappedNandFlash_PhysicalToLogical(MAPPED(translated), liveBlock);
+        if ((eraseDifference > MAXERASEDIFFERENCE) && (logicalBlock != -1))
         {
             TRACE_WARNING("Erase difference too big, switching blocks\n\r");
             MappedNandFlash_Map(
                 MAPPED(translated),
-                MappedNandFlash_PhysicalToLogical(
-                    MAPPED(translated),
-                    liveBlock),
-                freeBlock);
+                logicalBlock,
+                *freeBlock);
             ManagedNandFlash_CopyBlock(MANAGED(translated),
                                        liveBlock,
-                                       freeBlock);
+                                       *freeBlock);
+
+            /* Find a new block*/
+            return FindFreeBlock(translated, freeBlock);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * \brief  Copies a page between two blocks. Pages of different parity can not
+ * use the hardware copyback and are read then written back.
+ *
+ * \param translated  Pointer to a TranslatedNandFlash instance.
+ * \param sourceBlock  Source block number.
+ * \param sourcePage  Number of source page inside the source block.
+ * \param destBlock  Destination block number.
+ * \param destPage  Number of destination page inside the dest block.
+ * \return 0 if successful; otherwise returns a NandCommon_ERROR code.
+ */
+static unsigned char CopyPage(
+    const struct TranslatedNandFlash *translated,
+    unsigned short sourceBlock,
+    unsigned short sourcePage,
+    unsigned short destBlock,
+    unsigned short destPage)
+{
+    unsigned char data[NandCommon_MAXPAGEDATASIZE];
+    unsigned char error;
+
+    if ((sourcePage & 1) == (destPage & 1)) {
+
+        return ManagedNandFlash_CopyPage(MANAGED(translated),
+                                         sourceBlock, sourcePage,
+                                         destBlock, destPage);
+    }
+
+    error = ManagedNandFlash_ReadPage(MANAGED(translated),
+                                      sourceBlock, sourcePage, data, 0);
+    if (error) {
+
+        return error;
+    }
+
+    return ManagedNandFlash_WritePage(MANAGED(translated),
+                                      destBlock, destPage, data, 0);
+}
 
-            /* Allocate a new block*/
-            return AllocateBlock(translated, block);
+/**
+ * \brief  Merges the log of a write block back into a data block and closes
+ * the write block. A log written in place becomes the data block once its
+ * missing pages are copied from the previous data block; otherwise a new data
+ * block receives the latest copy of every page.
+ *
+ * \param translated  Pointer to a TranslatedNandFlash instance.
+ * \param writeBlock  Pointer to the write block to merge.
+ * \return 0 if successful; otherwise returns a NandCommon_ERROR code.
+ */
+static unsigned char MergeWriteBlock(
+    struct TranslatedNandFlash *translated,
+    struct TranslatedWriteBlock *writeBlock)
+{
+    unsigned short numPages = NandFlashModel_GetBlockSizeInPages(MODEL(translated));
+    unsigned short logicalBlock = writeBlock->logicalBlock;
+    unsigned short logBlock = writeBlock->physicalBlock;
+    unsigned short dataBlock;
+    signed short previousBlock;
+    unsigned char inPlace = 1;
+    unsigned char error;
+    unsigned short i;
+
+    TRACE_INFO("MergeWriteBlock(PB#%d -> LB#%d)\n\r", logBlock, logicalBlock);
+
+    /* Check if the log holds pages #0 - #nextPage at their own position*/
+    for (i=0; i < writeBlock->nextPage; i++) {
+
+        if (!PageIsLogged(writeBlock, i) || (writeBlock->pageMap[i] != i)) {
+
+            inPlace = 0;
+            break;
         }
     }
 
-    /* Map block*/
-    TRACE_DEBUG("Allocating PB#%d for LB#%d\n\r", freeBlock, block);
-    MappedNandFlash_Map(MAPPED(translated), block, freeBlock);
+    if (inPlace) {
+
+        /* Copy missing pages from the data block into the log block*/
+        previousBlock = MappedNandFlash_LogicalToPhysical(MAPPED(translated), logicalBlock);
+        if (previousBlock != -1) {
+
+            for (i=writeBlock->nextPage; i < numPages; i++) {
+
+                error = ManagedNandFlash_CopyPage(MANAGED(translated),
+                                                  previousBlock, i,
+                                                  logBlock, i);
+                if (error) {
+
+                    TRACE_ERROR("MergeWriteBlock: copy page #%d\n\r", i);
+                    return error;
+                }
+            }
+        }
+
+        /* Log block becomes the data block*/
+        error = MappedNandFlash_Remap(MAPPED(translated), logicalBlock, logBlock);
+        if (error) {
+
+            return error;
+        }
+    }
+    else {
+
+        /* Allocate the new data block (the previous one stays readable
+           until released blocks get erased)*/
+        error = FindFreeBlock(translated, &dataBlock);
+        if (error) {
+
+            return error;
+        }
+        previousBlock = MappedNandFlash_LogicalToPhysical(MAPPED(translated), logicalBlock);
+        TRACE_DEBUG("Allocating PB#%d for LB#%d\n\r", dataBlock, logicalBlock);
+        error = MappedNandFlash_Map(MAPPED(translated), logicalBlock, dataBlock);
+        if (error) {
+
+            return error;
+        }
+
+        /* Copy the latest version of each page*/
+        for (i=0; i < numPages; i++) {
+
+            error = 0;
+            if (PageIsLogged(writeBlock, i)) {
+
+                error = CopyPage(translated, logBlock, writeBlock->pageMap[i],
+                                 dataBlock, i);
+            }
+            else if (previousBlock != -1) {
+
+                error = CopyPage(translated, previousBlock, i, dataBlock, i);
+            }
+            if (error) {
+
+                TRACE_ERROR("MergeWriteBlock: copy page #%d\n\r", i);
+                return error;
+            }
+        }
+
+        /* Save the new data block before releasing the log, as a DIRTY log
+           is dropped at mount*/
+        writeBlock->logicalBlock = -1;
+        translated->writeBlocksModified = 1;
+        error = TranslatedNandFlash_SaveLogicalMapping(translated);
+        if (error) {
+
+            return error;
+        }
+
+        /* Log block is not needed anymore*/
+        return ManagedNandFlash_ReleaseBlock(MANAGED(translated), logBlock);
+    }
+
+    writeBlock->logicalBlock = -1;
+    translated->writeBlocksModified = 1;
+
+    return 0;
+}
+
+/**
+ * \brief  Opens a logical block for writing. A log block is allocated for it,
+ * evicting the least recently written block if all write blocks are used.
+ *
+ * \param translated  Pointer to a TranslatedNandFlash instance.
+ * \param block  Logical block number.
+ * \param pWriteBlock  Pointer to the write block pointer variable.
+ * \return 0 if successful; otherwise returns a NandCommon_ERROR code.
+ */
+static unsigned char OpenWriteBlock(
+    struct TranslatedNandFlash *translated,
+    unsigned short block,
+    struct TranslatedWriteBlock **pWriteBlock)
+{
+    struct TranslatedWriteBlock *writeBlock = 0;
+    unsigned short logBlock;
+    unsigned char error;
+    unsigned char i;
+
+    /* Use an unused entry or the least recently written one*/
+    for (i=0; i < TRANSLATEDNANDFLASH_WRITEBLOCKS; i++) {
+
+        if (translated->writeBlocks[i].logicalBlock == -1) {
+
+            writeBlock = &(translated->writeBlocks[i]);
+            break;
+        }
+        if (!writeBlock || (translated->writeBlocks[i].lastUse < writeBlock->lastUse)) {
+
+            writeBlock = &(translated->writeBlocks[i]);
+        }
+    }
+    if (writeBlock->logicalBlock != -1) {
+
+        TRACE_DEBUG("Evicting LB#%d\n\r", writeBlock->logicalBlock);
+        error = MergeWriteBlock(translated, writeBlock);
+        if (error) {
+
+            return error;
+        }
+    }
+
+    /* Allocate the log block*/
+    error = FindFreeBlock(translated, &logBlock);
+    if (error) {
+
+        return error;
+    }
+    error = ManagedNandFlash_AllocateBlock(MANAGED(translated), logBlock);
+    if (error) {
+
+        return error;
+    }
+
+    TRACE_DEBUG("Log PB#%d for LB#%d\n\r", logBlock, block);
+    writeBlock->logicalBlock = block;
+    writeBlock->physicalBlock = logBlock;
+    writeBlock->nextPage = 0;
+    memset(writeBlock->pageLogged, 0, sizeof(writeBlock->pageLogged));
+    translated->writeBlocksModified = 1;
+    *pWriteBlock = writeBlock;
 
     return 0;
 }
@@ -251,20 +726,33 @@ unsigned char TranslatedNandFlash_Initialize(
     unsigned short baseBlock,
     unsigned short sizeInBlocks)
 {
-    translated->currentLogicalBlock = -1;
-    translated->previousPhysicalBlock = -1;
-    MarkAllPagesClean(translated);
+    unsigned char error;
+    unsigned char i;
+
+    for (i=0; i < TRANSLATEDNANDFLASH_WRITEBLOCKS; i++) {
+
+        translated->writeBlocks[i].logicalBlock = -1;
+    }
+    translated->writeTick = 0;
+    translated->writeBlocksModified = 0;
 
     /* Initialize MappedNandFlash*/
-    return MappedNandFlash_Initialize(MAPPED(translated),
-                                      model,
-                                      commandAddress,
-                                      addressAddress,
-                                      dataAddress,
-                                      pinChipEnable,
-                                      pinReadyBusy,
-                                      baseBlock,
-                                      sizeInBlocks);
+    error = MappedNandFlash_Initialize(MAPPED(translated),
+                                       model,
+                                       commandAddress,
+                                       addressAddress,
+                                       dataAddress,
+                                       pinChipEnable,
+                                       pinReadyBusy,
+                                       baseBlock,
+                                       sizeInBlocks);
+    if (error) {
+
+        return error;
+    }
+
+    /* Retrieve the logs saved with the mapping*/
+    return LoadCheckpoint(translated);
 }
 
 /**
@@ -282,19 +770,19 @@ unsigned char TranslatedNandFlash_Initialize(
 unsigned char TranslatedNandFlash_ReadPage( const struct TranslatedNandFlash *translated, unsigned short block,
                                             unsigned short page, void *data, void *spare )
 {
+    const struct TranslatedWriteBlock *writeBlock;
     unsigned char error ;
 
     TRACE_INFO("TranslatedNandFlash_ReadPage(B#%d:P#%d)\n\r", block, page);
 
-    /* If the page to read is in the current block, there is a previous physical
-       block and the page is clean -> read the page in the old block since the
-       new one does not contain meaningful data*/
-    if ( (block == translated->currentLogicalBlock) && (translated->previousPhysicalBlock != -1)
-         && (PageIsClean(translated, page)) )
+    /* If the page has been written in the log of the block, read its latest
+       version from the log block*/
+    writeBlock = FindWriteBlock( translated, block ) ;
+    if ( writeBlock && PageIsLogged( writeBlock, page ) )
     {
-        TRACE_DEBUG("Reading page from current block\n\r");
-        return ManagedNandFlash_ReadPage( MANAGED( translated ), translated->previousPhysicalBlock,
-                                          page, data, spare ) ;
+        TRACE_DEBUG("Reading page from log block\n\r");
+        return ManagedNandFlash_ReadPage( MANAGED( translated ), writeBlock->physicalBlock,
+                                          writeBlock->pageMap[page], data, spare ) ;
     }
     else
     {
@@ -306,8 +794,8 @@ unsigned char TranslatedNandFlash_ReadPage( const struct TranslatedNandFlash *tr
         {
             assert( !spare ) ; /* "Cannot read the spare information of an unmapped block\n\r" */
 
-            /* Check if a block can be allocated*/
-            if ( BlockCanBeAllocated( translated ) )
+            /* Check if a block can be allocated (or already is, as a log)*/
+            if ( writeBlock || BlockCanBeAllocated( translated ) )
             {
                 /* Return 0xFF in buffers with no error*/
                 TRACE_DEBUG("Block #%d is not mapped but can be allocated, filling buffer with 0xFF\n\r", block);
@@ -341,7 +829,9 @@ unsigned char TranslatedNandFlash_ReadPage( const struct TranslatedNandFlash *tr
 
 /**
  * \brief  Writes the data and/or spare area of a page on a translated nandflash.
- * Allocates block has needed to keep the wear even between all blocks.
+ * The page is appended to the log block of the logical block, so rewriting a
+ * page costs a single page program. The log is merged back into a data block
+ * (allocated to keep the wear even between all blocks) once it is full.
  *
  * \param translated  Pointer to a TranslatedNandFlash instance.
  * \param block  Logical block number.
@@ -353,133 +843,216 @@ unsigned char TranslatedNandFlash_ReadPage( const struct TranslatedNandFlash *tr
 unsigned char TranslatedNandFlash_WritePage( struct TranslatedNandFlash *translated, unsigned short block,
                                              unsigned short page, void *data, void *spare )
 {
-    unsigned char allocate = 1;
+    struct TranslatedWriteBlock *writeBlock;
     unsigned char error;
 
     TRACE_INFO("TranslatedNandFlash_WritePage(B#%d:P#%d)\n\r", block, page);
+    assert( page < NandFlashModel_GetBlockSizeInPages(MODEL(translated)) ) ; /* "TranslatedNandFlash_WritePage: Page out-of-bounds\n\r" */
+
+    writeBlock = FindWriteBlock(translated, block);
 
-    /* A new block must be allocated unless:*/
-    /* 1. the block is not mapped and there are no more blocks to allocate*/
-    if (MappedNandFlash_LogicalToPhysical(MAPPED(translated), block) == -1)
+    /* Block is neither mapped nor open, check if it can be allocated*/
+    if (!writeBlock
+        && (MappedNandFlash_LogicalToPhysical(MAPPED(translated), block) == -1)
+        && !BlockCanBeAllocated(translated))
     {
-        /* Block is not mapped, check if it can be*/
-        if (!BlockCanBeAllocated(translated))
-        {
-            TRACE_ERROR("TranslatedNandFlash_WritePage: Not enough free blocks\n\r");
-            return NandCommon_ERROR_NOMOREBLOCKS;
-        }
-        TRACE_DEBUG("Allocate because block not mapped\n\r");
+        TRACE_ERROR("TranslatedNandFlash_WritePage: Not enough free blocks\n\r");
+        return NandCommon_ERROR_NOMOREBLOCKS;
     }
-    /* or 2. the block to write is the current one and the page to write is clean*/
-    else
+
+    /* Merge the log if it is full*/
+    if (writeBlock
+        && (writeBlock->nextPage >= NandFlashModel_GetBlockSizeInPages(MODEL(translated))))
     {
-        if (translated->currentLogicalBlock == block)
-        {
-            if (PageIsClean(translated, page))
-            {
-                TRACE_DEBUG("NO allocate because write in current block\n\r");
-                allocate = 0;
-            }
-            else
-            {
-                TRACE_DEBUG("Allocate because page DIRTY in current block\n\r");
-            }
-        }
-        else
+        TRACE_DEBUG("Merge because log of LB#%d is full\n\r", block);
+        error = MergeWriteBlock(translated, writeBlock);
+        if (error)
         {
-            TRACE_DEBUG("Allocate because block is mapped and different from current block\n\r");
+            return error;
         }
+        writeBlock = 0;
     }
 
-    /* Allocate block if needed*/
-    if ( allocate )
+    /* Open the block for writing if needed*/
+    if (!writeBlock)
     {
-        /* Flush current block write (if any) and then allocate block*/
-        error = TranslatedNandFlash_Flush(translated);
+        error = OpenWriteBlock(translated, block, &writeBlock);
         if (error)
         {
             return error;
         }
-        translated->previousPhysicalBlock = MappedNandFlash_LogicalToPhysical( MAPPED(translated), block ) ;
-        TRACE_DEBUG("Previous physical block is now #%d\n\r", translated->previousPhysicalBlock ) ;
-        error = AllocateBlock( translated, block ) ;
-        if ( error )
-        {
-            return error;
-        }
-
-        /* Block becomes the current block with all pages clean*/
-        translated->currentLogicalBlock = block;
-        MarkAllPagesClean(translated);
     }
 
-    /* Start writing page*/
-    error = MappedNandFlash_WritePage(MAPPED(translated),
-                                      block,
-                                      page,
-                                      data,
-                                      spare);
+    /* Append page to the log*/
+    error = ManagedNandFlash_WritePage(MANAGED(translated),
+                                       writeBlock->physicalBlock,
+                                       writeBlock->nextPage,
+                                       data,
+                                       spare);
     if ( error )
     {
         return error;
     }
 
-    /* If write went through, mark page as written*/
-    MarkPageDirty(translated, page);
+    /* If write went through, the log holds the page*/
+    writeBlock->pageMap[page] = writeBlock->nextPage;
+    writeBlock->pageLogged[page / 8] |= 1 << (page % 8);
+    writeBlock->nextPage++;
+    writeBlock->lastUse = ++translated->writeTick;
+    translated->writeBlocksModified = 1;
 
     return 0;
 }
 
 /**
- * \brief  Terminates the current write operation by copying all the missing pages from
- * the previous physical block.
+ * \brief  Terminates the current write operations by merging the logs of all
+ * the open blocks back into data blocks.
  *
  * \param translated  Pointer to a TranslatedNandFlash instance.
  * \return 0 if successful; otherwise returns error code
  */
 unsigned char TranslatedNandFlash_Flush(struct TranslatedNandFlash *translated)
 {
-    unsigned int i;
     unsigned char error;
-    unsigned int currentPhysicalBlock;
-
-    /* Check if there is a current block and a previous block*/
-    if ((translated->currentLogicalBlock == -1)
-        || (translated->previousPhysicalBlock == -1))
-    {
-        return 0;
-    }
+    unsigned char i;
 
-    TRACE_INFO("TranslatedNandFlash_Flush(PB#%d -> LB#%d)\n\r",
-              translated->previousPhysicalBlock, translated->currentLogicalBlock);
+    TRACE_INFO("TranslatedNandFlash_Flush()\n\r");
 
-    /* Copy missing pages in the current block*/
-    currentPhysicalBlock = MappedNandFlash_LogicalToPhysical(
-                                MAPPED(translated),
-                                translated->currentLogicalBlock);
-
-    for (i=0; i < NandFlashModel_GetBlockSizeInPages(MODEL(translated)); i++)
+    for (i=0; i < TRANSLATEDNANDFLASH_WRITEBLOCKS; i++)
     {
-        if (PageIsClean(translated, i))
+        if (translated->writeBlocks[i].logicalBlock != -1)
         {
-            TRACE_DEBUG("Copying back page #%d of block #%d\n\r", i, translated->previousPhysicalBlock);
-
-            /* Copy page*/
-            error = ManagedNandFlash_CopyPage(MANAGED(translated),
-                                              translated->previousPhysicalBlock,
-                                              i,
-                                              currentPhysicalBlock,
-                                              i);
+            error = MergeWriteBlock(translated, &(translated->writeBlocks[i]));
             if (error)
             {
-                TRACE_ERROR("FinishCurrentWrite: copy page #%d\n\r", i);
+                TRACE_ERROR("TranslatedNandFlash_Flush: merge LB#%d\n\r",
+                            translated->writeBlocks[i].logicalBlock);
                 return error;
             }
         }
     }
 
-    translated->currentLogicalBlock = -1;
-    translated->previousPhysicalBlock = -1;
+    return 0;
+}
+
+/**
+ * \brief  Drops the content of a logical block no longer used by the host
+ * (UNMAP/TRIM): its data block and its log, if any, are released and get
+ * erased by the garbage collection instead of being copied by the next merges.
+ * The block then reads as erased (0xFF) until it is written again.
+ *
+ * \param translated  Pointer to a TranslatedNandFlash instance.
+ * \param block  Logical block number.
+ * \return 0 if successful; otherwise returns a NandCommon_ERROR code.
+ */
+unsigned char TranslatedNandFlash_DiscardBlock(
+    struct TranslatedNandFlash *translated,
+    unsigned short block)
+{
+    struct TranslatedWriteBlock *writeBlock;
+    unsigned char error;
+
+    TRACE_INFO("TranslatedNandFlash_DiscardBlock(LB#%d)\n\r", block);
+
+    /* Close the log without merging it*/
+    writeBlock = FindWriteBlock(translated, block);
+    if (writeBlock) {
+
+        error = ManagedNandFlash_ReleaseBlock(MANAGED(translated),
+                                              writeBlock->physicalBlock);
+        if (error) {
+
+            return error;
+        }
+        writeBlock->logicalBlock = -1;
+        translated->writeBlocksModified = 1;
+    }
+
+    /* Release the data block*/
+    if (MappedNandFlash_LogicalToPhysical(MAPPED(translated), block) != -1) {
+
+        return MappedNandFlash_Unmap(MAPPED(translated), block);
+    }
+
+    return 0;
+}
+
+/**
+ * \brief  Performs a bounded amount of garbage collection while the number of
+ * FREE blocks is below TRANSLATEDNANDFLASH_GCWATERMARK, so that writes seldom
+ * have to erase blocks themselves. Each step saves the mapping (the last saved
+ * one may still use the blocks released since), starts erasing one DIRTY block
+ * in the background, or merges the least recently written log when there is
+ * nothing left to erase. Returns while a background erase is running, the
+ * next call completes it (RawNandFlash_Poll).
+ * Meant to be called when the device is idle, from the task doing the other
+ * accesses or under the same lock.
+ *
+ * \param translated  Pointer to a TranslatedNandFlash instance.
+ * \param maxSteps  Maximum number of steps.
+ * \return 0 if successful; otherwise returns a NandCommon_ERROR code.
+ */
+unsigned char TranslatedNandFlash_CollectGarbage(
+    struct TranslatedNandFlash *translated,
+    unsigned char maxSteps)
+{
+    struct TranslatedWriteBlock *writeBlock;
+    unsigned char error;
+    unsigned char i;
+
+    while ((maxSteps > 0)
+           && (ManagedNandFlash_CountBlocks(MANAGED(translated),
+                                            NandBlockStatus_FREE)
+               < TRANSLATEDNANDFLASH_GCWATERMARK)) {
+
+        /* Device still busy with the previous erase*/
+        if (RawNandFlash_Poll(RAW(translated))) {
+
+            return 0;
+        }
+
+        maxSteps--;
+        if (ManagedNandFlash_CountBlocks(MANAGED(translated),
+                                         NandBlockStatus_DIRTY) > 0) {
+
+            if (MAPPED(translated)->mappingModified
+                || translated->writeBlocksModified) {
+
+                error = TranslatedNandFlash_SaveLogicalMapping(translated);
+            }
+            else {
+
+                error = ManagedNandFlash_StartEraseDirtyBlock(MANAGED(translated));
+            }
+        }
+        else {
+
+            /* Compact the least recently written log*/
+            writeBlock = 0;
+            for (i=0; i < TRANSLATEDNANDFLASH_WRITEBLOCKS; i++) {
+
+                if ((translated->writeBlocks[i].logicalBlock != -1)
+                    && (!writeBlock
+                        || (translated->writeBlocks[i].lastUse < writeBlock->lastUse))) {
+
+                    writeBlock = &(translated->writeBlocks[i]);
+                }
+            }
+            if (!writeBlock) {
+
+                /* Nothing left to collect*/
+                return 0;
+            }
+            TRACE_DEBUG("CollectGarbage: merge LB#%d\n\r", writeBlock->logicalBlock);
+            error = MergeWriteBlock(translated, writeBlock);
+        }
+        if (error) {
+
+            TRACE_ERROR("TranslatedNandFlash_CollectGarbage: %d\n\r", error);
+            return error;
+        }
+    }
+
     return 0;
 }
 
@@ -494,19 +1067,24 @@ unsigned char TranslatedNandFlash_EraseAll(
     struct TranslatedNandFlash *translated,
     unsigned char level)
 {
+    unsigned char i;
+
     MappedNandFlash_EraseAll(MAPPED(translated), level);
 
     if (level > NandEraseDIRTY)
     {
-        translated->currentLogicalBlock = -1;
-        translated->previousPhysicalBlock = -1;
-        MarkAllPagesClean(translated);
+        for (i=0; i < TRANSLATEDNANDFLASH_WRITEBLOCKS; i++)
+        {
+            translated->writeBlocks[i].logicalBlock = -1;
+        }
+        translated->writeBlocksModified = 0;
     }
     return 0;
 }
 
 /**
- * \brief  Allocates a free block to save the current logical mapping on it.
+ * \brief  Allocates a free block to save the current logical mapping on it,
+ * together with the logs of the open blocks (which are therefore not merged).
  *
  * \param translated  Pointer to a TranslatedNandFlash instance.
  * \return 0 if successful; otherwise returns a NandCommon_ERROR code.
@@ -519,7 +1097,20 @@ unsigned char TranslatedNandFlash_SaveLogicalMapping(
 
     TRACE_INFO("TranslatedNandFlash_SaveLogicalMapping()\n\r");
 
-    /* Save logical mapping in the youngest free block*/
+    /* Nothing to do if nothing changed since the last checkpoint*/
+    if (!MAPPED(translated)->mappingModified && !translated->writeBlocksModified
+        && (MANAGED(translated)->checkpoint.state == NandCheckpoint_CLEAN))
+    {
+        return 0;
+    }
+
+    /* Append the changes to the mapping journal when there is room left*/
+    if (!AppendJournal(translated))
+    {
+        return 0;
+    }
+
+    /* Otherwise save the whole logical mapping in the youngest free block*/
     /* Find the youngest block*/
     error = ManagedNandFlash_FindYoungestBlock(MANAGED(translated),
                                                NandBlockStatus_FREE,
@@ -530,22 +1121,8 @@ unsigned char TranslatedNandFlash_SaveLogicalMapping(
         return error;
     }
 
-    /* Check if this is the last free block, in which case dirty blocks are wiped
-       prior to saving the mapping */
-    if (ManagedNandFlash_CountBlocks(MANAGED(translated),
-                                     NandBlockStatus_FREE) == 1)
-    {
-        TranslatedNandFlash_Flush(translated);
-        error = ManagedNandFlash_EraseDirtyBlocks(MANAGED(translated));
-        if (error)
-        {
-            TRACE_ERROR("TranNF_Flush: Could not erase dirty blocks\n\r");
-            return error;
-        }
-    }
-
     /* Save the mapping*/
-    error = MappedNandFlash_SaveLogicalMapping(MAPPED(translated), freeBlock);
+    error = SaveCheckpoint(translated, freeBlock);
     if (error)
     {
         TRACE_ERROR("TranNF_Flush: Failed to save mapping in #%d\n\r", freeBlock);
@@ -50,6 +50,8 @@
 #define AMD_CMD_ERASE_SECTOR  0x0030
 #define AMD_CMD_PROGRAM       0x00A0
 #define AMD_CMD_UNLOCK_BYPASS 0x0020
+#define AMD_CMD_WRITE_BUFFER  0x0025
+#define AMD_CMD_PROGRAM_BUFFER 0x0029
 
 /** Command offset for vendor command set CMD_SET_AMD */
 #define AMD_OFFSET_UNLOCK_1   0x05555
@@ -66,6 +68,7 @@
 #define AMD_POLLING_DQ6       0x60
 #define AMD_POLLING_DQ5       0x20
 #define AMD_POLLING_DQ3       0x08
+#define AMD_POLLING_DQ1       0x02
 
 /*----------------------------------------------------------------------------
  *        Local functions
@@ -195,6 +198,81 @@ static uint8_t amd_Program( NorFlashInfo *pNorFlashInfo, uint32_t address, uint3
     return 0;
 }
 
+/**
+ * \brief It implements a write to buffer program command: up to the write
+ * buffer size of data, inside one write buffer page, is programmed by one
+ * command sequence. Returns 0 if the operation was successful; otherwise
+ * returns an error code.
+ *
+ * \param pNorFlashInfo  Pointer to an NorFlashInfo instance.
+ * \param address Start address offset to be wrote.
+ * \param buffer Buffer where the data is stored.
+ * \param numWords Number of words to write.
+ */
+static uint8_t amd_ProgramBuffer( NorFlashInfo *pNorFlashInfo, uint32_t address, uint8_t *buffer, uint32_t numWords )
+{
+    uint32_t pollingData;
+    uint32_t lastData = 0;
+    uint32_t busAddress;
+    uint32_t sectorAddress;
+    uint8_t busWidth;
+    uint8_t wordSize;
+    uint32_t i;
+
+    busWidth = NorFlash_GetDataBusWidth(pNorFlashInfo);
+    wordSize = busWidth / 8;
+    sectorAddress = NorFlash_GetAddressInChip(pNorFlashInfo, address);
+
+    /* The write buffer command sequence is initiated by writing two unlock write cycles, */
+    WriteCommand(busWidth,
+                 NorFlash_GetByteAddressInChip(pNorFlashInfo, AMD_OFFSET_UNLOCK_1),
+                 AMD_CMD_UNLOCK_1);
+    WriteCommand(busWidth,
+                 NorFlash_GetByteAddressInChip(pNorFlashInfo, AMD_OFFSET_UNLOCK_2),
+                 AMD_CMD_UNLOCK_2);
+    /* followed by the write to buffer command and the word count minus one, at the sector address. */
+    WriteCommand(busWidth, sectorAddress, AMD_CMD_WRITE_BUFFER);
+    WriteCommand(busWidth, sectorAddress, numWords - 1);
+
+    /* The data are loaded in the buffer, */
+    busAddress = sectorAddress;
+    for (i = 0; i < numWords; i++)
+    {
+        WriteRawData(busWidth, busAddress, buffer);
+        buffer += wordSize;
+        busAddress += wordSize;
+    }
+    /* then the program buffer to flash command starts the programming. */
+    WriteCommand(busWidth, sectorAddress, AMD_CMD_PROGRAM_BUFFER);
+
+    /* Data polling on the last loaded address */
+    busAddress -= wordSize;
+    memcpy(&lastData, buffer - wordSize, wordSize);
+    do
+    {
+        ReadRawData(busWidth, busAddress, (uint8_t *)&pollingData);
+        /* Check if the chip program algorithm is completed. */
+        if ((pollingData & AMD_POLLING_DQ7) == (lastData & AMD_POLLING_DQ7))
+        {
+            /* Program operation successful. Device in read mode. */
+            return 0;
+        }
+    }
+    while ((pollingData & (AMD_POLLING_DQ5 | AMD_POLLING_DQ1)) == 0);
+
+    /* I/O should be rechecked. */
+    ReadRawData(busWidth, busAddress, (uint8_t *)&pollingData);
+    if ((pollingData & AMD_POLLING_DQ7) == (lastData & AMD_POLLING_DQ7))
+    {
+        return 0;
+    }
+
+    /* Program operation not successful or buffer aborted, write reset command. */
+    amd_Reset(pNorFlashInfo, 0);
+
+    return NorCommon_ERROR_CANNOTWRITE;
+}
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -385,8 +463,33 @@ uint8_t AMD_Write_Data( NorFlashInfo *pNorFlashInfo, uint32_t address, uint8_t *
 {
     uint32_t i;
     uint8_t busWidth;
+    uint32_t bufferSize;
+    uint32_t numBytes;
     busWidth = pNorFlashInfo->deviceChipWidth;
 
+    /* Program through the write buffer, one buffer page at a time */
+    bufferSize = NorFlash_GetWriteBufferSize(pNorFlashInfo);
+    if (bufferSize > 0)
+    {
+        size = (size + busWidth - 1) & ~(uint32_t)(busWidth - 1);
+        while (size > 0)
+        {
+            numBytes = bufferSize - (address % bufferSize);
+            if (numBytes > size)
+            {
+                numBytes = size;
+            }
+            if (amd_ProgramBuffer(pNorFlashInfo, address, buffer, numBytes / busWidth))
+            {
+                return NorCommon_ERROR_CANNOTWRITE;
+            }
+            address += numBytes;
+            buffer += numBytes;
+            size -= numBytes;
+        }
+        return 0;
+    }
+
     if (busWidth == FLASH_CHIP_WIDTH_8BITS )
     {
         for(i=0; i < size; i++)
@@ -124,22 +124,38 @@ uint8_t NORFLASH_ReadData( NorFlash *pNorFlash, uint32_t address, uint8_t *buffe
     busWidth = NorFlash_GetDataBusWidth(&(pNorFlash->norFlashInfo));
     busAddress = NorFlash_GetAddressInChip(&(pNorFlash->norFlashInfo), address);
 
+    /* Consecutive word reads, so that the accesses inside a page are fast */
+    /* when the page mode is enabled (see NorFlash_GetPageReadSize()). */
     if ((busWidth / 8 ) == FLASH_CHIP_WIDTH_16BITS )
     {
+        volatile uint16_t *pData16 = (volatile uint16_t *) busAddress;
+        uint16_t *buffer16 = (uint16_t *) buffer;
+
         size = (size + 1) >> 1;
+        for(i = 0; i < size; i++)
+        {
+            buffer16[i] = pData16[i];
+        }
     }
-
-    if ((busWidth/8) == FLASH_CHIP_WIDTH_32BITS )
+    else if ((busWidth/8) == FLASH_CHIP_WIDTH_32BITS )
     {
+        volatile uint32_t *pData32 = (volatile uint32_t *) busAddress;
+        uint32_t *buffer32 = (uint32_t *) buffer;
+
         size = (size + 3) >> 2;
+        for(i = 0; i < size; i++)
+        {
+            buffer32[i] = pData32[i];
+        }
     }
-
-    for(i = 0; i < size; i++)
+    else
     {
-        ReadRawData(busWidth, busAddress, buffer);
-        buffer+= (busWidth / 8);
-        busAddress+= (busWidth / 8);
+        volatile uint8_t *pData8 = (volatile uint8_t *) busAddress;
 
+        for(i = 0; i < size; i++)
+        {
+            buffer[i] = pData8[i];
+        }
     }
 
     return 0;
@@ -41,6 +41,15 @@
 
 #define DUMP_CFI
 
+/** Primary extended query table offsets (in words). */
+#define CFI_AMD_PAGE_MODE          0x0C
+#define CFI_INTEL_FEATURES         0x05
+
+/** Intel optional feature: page-mode reads permitted. */
+#define CFI_INTEL_FEATURE_PAGEREAD 0x80
+/** Intel page-mode reads are at least 4 words. */
+#define CFI_INTEL_PAGE_WORDS       4
+
 /*----------------------------------------------------------------------------
  *        Local functions
  *----------------------------------------------------------------------------*/
@@ -113,6 +122,81 @@ static void NorFlash_CFI_DumpConfiguration( NorFlashCFI *pNorFlashCFI )
     }
 }
 
+/**
+ * \brief Reads a byte of the CFI query tables.
+ *
+ * \param pNorFlashInfo  Pointer to a NorFlashInfo instance.
+ * \param offset  Offset of the byte in the tables (in words).
+ */
+static uint8_t NorFlash_CFI_ReadByte( NorFlashInfo *pNorFlashInfo, uint32_t offset )
+{
+    uint8_t data ;
+
+    WriteCommand(8, NorFlash_GetByteAddressInChip(pNorFlashInfo, CFI_QUERY_ADDRESS), CFI_QUERY_COMMAND);
+    ReadRawData(8, NorFlash_GetByteAddressInChip(pNorFlashInfo, offset), &data);
+
+    return data ;
+}
+
+/**
+ * \brief Fills the write buffer and page read sizes of a device, from its CFI
+ * geometry and primary extended query table.
+ *
+ * \param pNorFlashInfo  Pointer to a NorFlashInfo instance.
+ */
+static void NorFlash_CFI_DetectFeatures( NorFlashInfo *pNorFlashInfo )
+{
+    uint16_t primaryAddr = pNorFlashInfo->cfiDescription.norFlashCfiQueryInfo.primaryAddr ;
+    uint16_t primaryCode = pNorFlashInfo->cfiDescription.norFlashCfiQueryInfo.primaryCode ;
+    uint16_t numMultiWrite = pNorFlashInfo->cfiDescription.norFlashCfiDeviceGeometry.numMultiWrite ;
+    uint32_t size ;
+    uint8_t pageMode ;
+
+    /* Write buffer of 2^n bytes, limited to NORFLASH_MAXBUFFERWORDS words */
+    pNorFlashInfo->writeBufferSize = 0 ;
+    if ( (numMultiWrite > 0) && (numMultiWrite < 16) )
+    {
+        size = (uint32_t) 1 << numMultiWrite ;
+        if ( size > NORFLASH_MAXBUFFERWORDS * pNorFlashInfo->deviceChipWidth )
+        {
+            size = NORFLASH_MAXBUFFERWORDS * pNorFlashInfo->deviceChipWidth ;
+        }
+        if ( size > pNorFlashInfo->deviceChipWidth )
+        {
+            pNorFlashInfo->writeBufferSize = size ;
+        }
+    }
+
+    /* Page-mode reads, after checking the "PRI" signature of the table */
+    pNorFlashInfo->pageReadSize = 0 ;
+    if ( (primaryAddr == 0)
+      || (NorFlash_CFI_ReadByte( pNorFlashInfo, primaryAddr ) != 'P')
+      || (NorFlash_CFI_ReadByte( pNorFlashInfo, primaryAddr + 1 ) != 'R')
+      || (NorFlash_CFI_ReadByte( pNorFlashInfo, primaryAddr + 2 ) != 'I') )
+    {
+        return ;
+    }
+    if ( primaryCode == CMD_SET_AMD )
+    {
+        /* 1: 4 words, 2: 8 words, 3: 16 words */
+        pageMode = NorFlash_CFI_ReadByte( pNorFlashInfo, primaryAddr + CFI_AMD_PAGE_MODE ) ;
+        if ( (pageMode > 0) && (pageMode < 4) )
+        {
+            pNorFlashInfo->pageReadSize = (2 << pageMode) * pNorFlashInfo->deviceChipWidth ;
+        }
+    }
+    else
+    {
+        if ( NorFlash_CFI_ReadByte( pNorFlashInfo, primaryAddr + CFI_INTEL_FEATURES ) & CFI_INTEL_FEATURE_PAGEREAD )
+        {
+            pNorFlashInfo->pageReadSize = CFI_INTEL_PAGE_WORDS * pNorFlashInfo->deviceChipWidth ;
+        }
+    }
+
+    TRACE_INFO( "NorFlash: write buffer %d bytes, page read %d bytes\n\r",
+                pNorFlashInfo->writeBufferSize, pNorFlashInfo->pageReadSize ) ;
+}
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -352,6 +436,29 @@ uint32_t NorFlash_GetDeviceSizeInBytes( NorFlashInfo *pNorFlashInfo )
     return ((uint32_t) 2 << ((pNorFlashInfo->cfiDescription.norFlashCfiDeviceGeometry.deviceSize) - 1));
 }
 
+/**
+ * \brief Returns the size in bytes of the write buffer used to program the
+ * device, or 0 if it is programmed one word at a time.
+ *
+ * \param pNorFlashInfo  Pointer to a NorFlashInfo instance.
+ */
+uint16_t NorFlash_GetWriteBufferSize( NorFlashInfo *pNorFlashInfo )
+{
+    return pNorFlashInfo->writeBufferSize ;
+}
+
+/**
+ * \brief Returns the size in bytes of the asynchronous read pages of the
+ * device, or 0 if it does not support page-mode reads. The SMC page mode can
+ * be enabled accordingly.
+ *
+ * \param pNorFlashInfo  Pointer to a NorFlashInfo instance.
+ */
+uint8_t NorFlash_GetPageReadSize( NorFlashInfo *pNorFlashInfo )
+{
+    return pNorFlashInfo->pageReadSize ;
+}
+
 /**
  * \brief Looks for query struct in Norflash common flash interface.
  * If found, the model variable is filled with the correct values.
@@ -366,9 +473,11 @@ uint8_t NorFlash_CFI_Detect( NorFlash *pNorFlash, uint8_t hardwareBusWidth )
 
     pNorFlash->norFlashInfo.cfiCompatible = 0;
     pNorFlash->norFlashInfo.deviceChipWidth = hardwareBusWidth;
+    pNorFlash->norFlashInfo.pageReadSize = 0;
+    pNorFlash->norFlashInfo.writeBufferSize = 0;
     address = CFI_QUERY_OFFSET;
 
-    for ( i = 0; i< sizeof( NorFlashInfo) ; i++)
+    for ( i = 0; i< sizeof( NorFlashCFI) ; i++)
     {
         WriteCommand(8, NorFlash_GetByteAddressInChip(&(pNorFlash->norFlashInfo), CFI_QUERY_ADDRESS), CFI_QUERY_COMMAND);
         ReadRawData(8, NorFlash_GetByteAddressInChip(&(pNorFlash->norFlashInfo), address), pCfi);
@@ -402,6 +511,8 @@ uint8_t NorFlash_CFI_Detect( NorFlash *pNorFlash, uint8_t hardwareBusWidth )
         return NorCommon_ERROR_UNKNOWNMODEL;
     }
 
+    NorFlash_CFI_DetectFeatures( &(pNorFlash->norFlashInfo) ) ;
+
     pNorFlash->norFlashInfo.cfiCompatible = 1;
     NORFLASH_Reset(pNorFlash, 0);
 
@@ -51,6 +51,8 @@
 #define INTEL_CMD_BLOCK_UNLOCK     0x00D0
 #define INTEL_CMD_BLOCK_LOCKDOWN   0x002F
 #define INTEL_CMD_PROGRAM_WORD     0x0010
+#define INTEL_CMD_WRITE_BUFFER     0x00E8
+#define INTEL_CMD_BUFFER_CONFIRM   0x00D0
 #define INTEL_CMD_RESET            0x00FF
 
 /** Intel norflash status resgister */
@@ -253,6 +255,71 @@ static uint8_t intel_Program( NorFlashInfo *pNorFlashInfo, uint32_t address, uin
     return 0;
 }
 
+/**
+ * \brief It implement a buffered program command: up to the write buffer size
+ * of data, inside one write buffer page, is programmed by one command
+ * sequence. Returns 0 if the operation was successful; otherwise returns an
+ * error code.
+ *
+ * \param pNorFlashInfo  Pointer to an struct NorFlashInfo instance.
+ * \param address Start address offset to be wrote.
+ * \param buffer Buffer where the data is stored.
+ * \param numWords Number of words to write.
+ */
+static uint8_t intel_ProgramBuffer( NorFlashInfo *pNorFlashInfo, uint32_t address, uint8_t *buffer, uint32_t numWords )
+{
+    uint32_t status;
+    uint32_t busAddress;
+    uint32_t blockAddress;
+    uint8_t busWidth;
+    uint8_t wordSize;
+    uint32_t i;
+
+    busWidth = NorFlash_GetDataBusWidth(pNorFlashInfo);
+    wordSize = busWidth / 8;
+     /* Issue Read Array Command - just in case that the flash is not in Read Array mode */
+    intel_Reset(pNorFlashInfo, address);
+    intel_ClearStatus(pNorFlashInfo);
+
+    /* The Buffered Program Setup command is written until the write buffer is available. */
+    blockAddress = NorFlash_GetAddressInChip(pNorFlashInfo, address);
+    do
+    {
+        WriteCommand(busWidth, blockAddress, INTEL_CMD_WRITE_BUFFER);
+        ReadRawData(busWidth, blockAddress, (uint8_t*)&status);
+    } while ((status & INTEL_STATUS_DWS) != INTEL_STATUS_DWS);
+
+    /* It is followed by the word count minus one, the data, and the confirm command. */
+    WriteCommand(busWidth, blockAddress, numWords - 1);
+    busAddress = blockAddress;
+    for (i = 0; i < numWords; i++)
+    {
+        WriteRawData(busWidth, busAddress, buffer);
+        buffer += wordSize;
+        busAddress += wordSize;
+    }
+    WriteCommand(busWidth, blockAddress, INTEL_CMD_BUFFER_CONFIRM);
+
+    /* Status register polling */
+    do
+    {
+        status = intel_ReadStatus(pNorFlashInfo, address);
+    } while ((status & INTEL_STATUS_DWS) != INTEL_STATUS_DWS);
+
+    /* check VPP, program and block lock errors. */
+    if (status & (INTEL_STATUS_VPPS | INTEL_STATUS_PS | INTEL_STATUS_BLS))
+    {
+        intel_ClearStatus(pNorFlashInfo);
+        intel_Reset(pNorFlashInfo, address);
+        return NorCommon_ERROR_CANNOTWRITE;
+    }
+
+    intel_ClearStatus(pNorFlashInfo);
+    intel_Reset(pNorFlashInfo, address);
+
+    return 0;
+}
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -407,9 +474,34 @@ uint8_t INTEL_Write_Data( NorFlashInfo *pNorFlashInfo, uint32_t address, uint8_t
 {
     uint32_t i;
     uint8_t busWidth;
+    uint32_t bufferSize;
+    uint32_t numBytes;
 
     busWidth = pNorFlashInfo->deviceChipWidth ;
 
+    /* Program through the write buffer, one buffer page at a time */
+    bufferSize = NorFlash_GetWriteBufferSize( pNorFlashInfo ) ;
+    if ( bufferSize > 0 )
+    {
+        size = (size + busWidth - 1) & ~(uint32_t)(busWidth - 1) ;
+        while ( size > 0 )
+        {
+            numBytes = bufferSize - (address % bufferSize) ;
+            if ( numBytes > size )
+            {
+                numBytes = size ;
+            }
+            if ( intel_ProgramBuffer( pNorFlashInfo, address, buffer, numBytes / busWidth ) )
+            {
+                return NorCommon_ERROR_CANNOTWRITE ;
+            }
+            address += numBytes ;
+            buffer += numBytes ;
+            size -= numBytes ;
+        }
+        return 0 ;
+    }
+
     if (busWidth == FLASH_CHIP_WIDTH_8BITS )
     {
         for(i=0; i < size; i++)
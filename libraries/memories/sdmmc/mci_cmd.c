@@ -1476,6 +1476,40 @@ uint8_t SdAcmd6(SdCard *pSd,
     return SendMciCommand(pSd, fCallback);
 }
 
+/**
+ * Sets the number of write blocks to be pre-erased before writing, to make
+ * a following multiple block write (CMD25) faster.
+ * The pre-erase count is reset by the card once the write command completes.
+ * Should be invoked after SdmmcCmd55().
+ * \param pSd      Pointer to a SD card driver instance.
+ * \param nbBlocks Number of blocks to pre-erase (23 bits).
+ * \param pStatus  Pointer to buffer for command response as status.
+ * \param fCallback Pointer to optional callback invoked on command end.
+ *                  NULL:    Function return until command finished.
+ *                  Pointer: Return immediately and invoke callback at end.
+ *                  Callback argument is fixed to a pointer to SdCard instance.
+ * \return the command transfer result (see SendMciCommand).
+ */
+uint8_t SdAcmd23(SdCard *pSd,
+                 uint32_t nbBlocks,
+                 uint32_t *pStatus,
+                 SdmmcCallback fCallback)
+{
+    MciCmd *pCommand = &(mciCmd);
+
+    TRACE_DEBUG( "Acmd23()\n\r" ) ;
+    ResetMciCommand(pCommand);
+
+    /* Fill command information */
+    pCommand->cmd = SD_SET_WR_BLK_ERASE_COUNT;
+    pCommand->arg = nbBlocks & 0x7FFFFF;
+    pCommand->resType = 1;
+    pCommand->pResp = pStatus;
+
+    /* Send command */
+    return SendMciCommand(pSd, fCallback);
+}
+
 /**
  * The SD Status contains status bits that are related to the SD memory Card
  * proprietary features and may be used for future application-specific usage.
@@ -55,6 +55,13 @@
 /** Return word(32-bit) count from byte count */
 #define toWCOUNT(byteCnt)  (((byteCnt)&0x3) ? (((byteCnt)/4)+1) : ((byteCnt)/4))
 
+/** Largest PDC counter value (RCR/RNCR, TCR/TNCR are 16-bit) */
+#define PDC_MAX_COUNT      0xFFFF
+/** 1 when a data command runs the PDC in word mode: whole words in a word
+    aligned buffer, otherwise HSMCI_MR_FBYTE forces byte transfers */
+#define isWordXfr(pCmd)    ((((pCmd)->blockSize & 0x3) == 0) \
+                            && (((uint32_t)(pCmd)->pData & 0x3) == 0))
+
 
 /** Bit mask for status register errors. */
 #define STATUS_ERRORS ((uint32_t)(HSMCI_SR_UNRE  \
@@ -298,6 +305,36 @@
 /** Cmd27, adtc, R1 */
 #define SDMMC_PROGRAM_CSD           (27| HSMCI_CMDR_RSPTYP_48_BIT )
 
+/*------------------------------------------------
+ * Class 5 commands: Erase commands
+ *------------------------------------------------*/
+
+/** Cmd32, SD, ac, R1 */
+#define SD_ERASE_WR_BLK_START       (32| HSMCI_CMDR_SPCMD_STD \
+                                       | HSMCI_CMDR_RSPTYP_48_BIT \
+                                       | HSMCI_CMDR_TRCMD_NO_DATA \
+                                       | HSMCI_CMDR_MAXLAT)
+/** Cmd33, SD, ac, R1 */
+#define SD_ERASE_WR_BLK_END         (33| HSMCI_CMDR_SPCMD_STD \
+                                       | HSMCI_CMDR_RSPTYP_48_BIT \
+                                       | HSMCI_CMDR_TRCMD_NO_DATA \
+                                       | HSMCI_CMDR_MAXLAT)
+/** Cmd35, MMC, ac, R1 */
+#define MMC_ERASE_GROUP_START       (35| HSMCI_CMDR_SPCMD_STD \
+                                       | HSMCI_CMDR_RSPTYP_48_BIT \
+                                       | HSMCI_CMDR_TRCMD_NO_DATA \
+                                       | HSMCI_CMDR_MAXLAT)
+/** Cmd36, MMC, ac, R1 */
+#define MMC_ERASE_GROUP_END         (36| HSMCI_CMDR_SPCMD_STD \
+                                       | HSMCI_CMDR_RSPTYP_48_BIT \
+                                       | HSMCI_CMDR_TRCMD_NO_DATA \
+                                       | HSMCI_CMDR_MAXLAT)
+/** Cmd38, ac, R1b */
+#define SDMMC_ERASE                 (38| HSMCI_CMDR_SPCMD_STD \
+                                       | HSMCI_CMDR_RSPTYP_R1B \
+                                       | HSMCI_CMDR_TRCMD_NO_DATA \
+                                       | HSMCI_CMDR_MAXLAT)
+
 /*------------------------------------------------
  * Class 8 commands: Application specific commands
  *------------------------------------------------*/
@@ -419,6 +456,10 @@ MciTransfer hsmciXfr;
 
 static MciCmd mciCmd;
 
+/** SDIO interrupt callback, NULL when the SDIO interrupt is off */
+static SdmmcIrqCallback sdioIrqCallback = NULL;
+static void *sdioIrqArg;
+
 
 /*---------------------------------------------------------------------------
  *         Internal functions
@@ -1215,6 +1256,40 @@ uint8_t SdmmcCmd18(SdCard *pSd,
     return error;
 }
 
+/**
+ * Defines the number of blocks of the following multiple block read or
+ * write command (CMD18 or CMD25), which then ends without STOP_TRANSMISSION.
+ * MMC only (version 3.1 or later).
+ * \param pSd  Pointer to a SD card driver instance.
+ * \param nbBlocks  Number of blocks of the next transfer.
+ * \param pStatus   Pointer to the response buffer as status.
+ * \param fCallback Pointer to optional callback invoked on command end.
+ *                  NULL:    Function return until command finished.
+ *                  Pointer: Return immediately and invoke callback at end.
+ *                  Callback argument is fixed to a pointer to SdCard instance.
+ */
+uint8_t MmcCmd23(SdCard *pSd,
+                 uint16_t nbBlocks,
+                 uint32_t *pStatus,
+                 SdmmcCallback fCallback)
+{
+    MciCmd *pCommand = &(mciCmd);
+    uint8_t error;
+
+    TRACE_DEBUG("Cmd23()\n\r");
+    ResetMciCommand(pCommand);
+
+    /* Fill command information */
+    pCommand->cmd = MMC_SET_BLOCK_COUNT;
+    pCommand->arg = nbBlocks;
+    pCommand->resType = 1;
+    pCommand->pResp = pStatus;
+
+    /* Send command */
+    error = SendMciCommand(pSd, fCallback);
+    return error;
+}
+
 /**
  * Write single block command
  * \param pSd  Pointer to a SD card driver instance.
@@ -1304,6 +1379,107 @@ uint8_t SdmmcCmd25(SdCard *pSd,
     return error;
 }
 
+/**
+ * Sets the address of the first block to be erased (CMD32 for SD cards,
+ * CMD35 for MMC cards).
+ * \param pSd  Pointer to a SD card driver instance.
+ * \param address   Address of the first block (byte or block address,
+ *                  depending on the card capacity).
+ * \param pStatus   Pointer to the response buffer as status.
+ * \param fCallback Pointer to optional callback invoked on command end.
+ *                  NULL:    Function return until command finished.
+ *                  Pointer: Return immediately and invoke callback at end.
+ *                  Callback argument is fixed to a pointer to SdCard instance.
+ */
+uint8_t SdmmcEraseStart(SdCard *pSd,
+                        uint32_t address,
+                        uint32_t *pStatus,
+                        SdmmcCallback fCallback)
+{
+    MciCmd *pCommand = &(mciCmd);
+    uint8_t error;
+
+    TRACE_DEBUG("EraseStart()\n\r");
+    ResetMciCommand(pCommand);
+
+    /* Fill command information */
+    pCommand->cmd = (pSd->cardType & CARD_TYPE_bmSDMMC) == CARD_TYPE_bmMMC ?
+                        MMC_ERASE_GROUP_START : SD_ERASE_WR_BLK_START;
+    pCommand->arg = address;
+    pCommand->resType = 1;
+    pCommand->pResp = pStatus;
+
+    /* Send command */
+    error = SendMciCommand(pSd, fCallback);
+    return error;
+}
+
+/**
+ * Sets the address of the last block to be erased (CMD33 for SD cards,
+ * CMD36 for MMC cards).
+ * \param pSd  Pointer to a SD card driver instance.
+ * \param address   Address of the last block (byte or block address,
+ *                  depending on the card capacity).
+ * \param pStatus   Pointer to the response buffer as status.
+ * \param fCallback Pointer to optional callback invoked on command end.
+ *                  NULL:    Function return until command finished.
+ *                  Pointer: Return immediately and invoke callback at end.
+ *                  Callback argument is fixed to a pointer to SdCard instance.
+ */
+uint8_t SdmmcEraseEnd(SdCard *pSd,
+                      uint32_t address,
+                      uint32_t *pStatus,
+                      SdmmcCallback fCallback)
+{
+    MciCmd *pCommand = &(mciCmd);
+    uint8_t error;
+
+    TRACE_DEBUG("EraseEnd()\n\r");
+    ResetMciCommand(pCommand);
+
+    /* Fill command information */
+    pCommand->cmd = (pSd->cardType & CARD_TYPE_bmSDMMC) == CARD_TYPE_bmMMC ?
+                        MMC_ERASE_GROUP_END : SD_ERASE_WR_BLK_END;
+    pCommand->arg = address;
+    pCommand->resType = 1;
+    pCommand->pResp = pStatus;
+
+    /* Send command */
+    error = SendMciCommand(pSd, fCallback);
+    return error;
+}
+
+/**
+ * Erase command (CMD38), erases the blocks selected by SdmmcEraseStart() and
+ * SdmmcEraseEnd(). The command ends when the card releases the busy signal.
+ * \param pSd  Pointer to a SD card driver instance.
+ * \param pStatus   Pointer to the response buffer as status.
+ * \param fCallback Pointer to optional callback invoked on command end.
+ *                  NULL:    Function return until command finished.
+ *                  Pointer: Return immediately and invoke callback at end.
+ *                  Callback argument is fixed to a pointer to SdCard instance.
+ */
+uint8_t SdmmcCmd38(SdCard *pSd,
+                   uint32_t *pStatus,
+                   SdmmcCallback fCallback)
+{
+    MciCmd *pCommand = &(mciCmd);
+    uint8_t error;
+
+    TRACE_DEBUG("Cmd38()\n\r");
+    ResetMciCommand(pCommand);
+
+    /* Fill command information */
+    pCommand->cmd = SDMMC_ERASE;
+    pCommand->resType = 1;
+    pCommand->busyCheck = 1;
+    pCommand->pResp = pStatus;
+
+    /* Send command */
+    error = SendMciCommand(pSd, fCallback);
+    return error;
+}
+
 /**
  * SDIO IO_RW_DIRECT command, response R5.
  * \return the command transfer result (see SendMciCommand).
@@ -1378,16 +1554,24 @@ uint8_t SdioCmd53(SdCard *pSd,
         pCommand->cmd |= HSMCI_CMDR_TRDIR;
         pCommand->tranType = MCI_START_READ;
     }
-    /* Block/Byte mode */
+    /* Block/Byte mode: size blocks of the function block size, or one
+       block of size bytes, so that the PDC moves words when it can */
     if (pCmdArg->blockMode) {
         pCommand->cmd |= HSMCI_CMDR_TRTYP_BLOCK
                        | HSMCI_CMDR_TRCMD_START_DATA;
-        pCommand->blockSize = SDMMC_BLOCK_SIZE;
+        pCommand->blockSize = pSd->ioBlockSize[pCmdArg->functionNum];
+        pCommand->nbBlock = size;
+        if (pCommand->blockSize == 0) {
+            TRACE_ERROR("Cmd53: FN%u block size not set\n\r",
+                        pCmdArg->functionNum);
+            return SDMMC_ERROR_PARAM;
+        }
     }
     else {
         pCommand->cmd |= HSMCI_CMDR_TRTYP_BYTE
                        | HSMCI_CMDR_TRCMD_START_DATA;
-        pCommand->blockSize = 1;
+        pCommand->blockSize = size;
+        pCommand->nbBlock = 1;
     }
     #if 1
     pCommand->arg = *pArgResp;
@@ -1402,7 +1586,6 @@ uint8_t SdioCmd53(SdCard *pSd,
     pCommand->resType = 5;
     pCommand->pResp = pArgResp;
     pCommand->pData = pData;
-    pCommand->nbBlock = size;
     /* Callback and its arguments */
     pCommand->callback = fCallback;
     pCommand->pArg     = pArg;
@@ -1479,6 +1662,40 @@ uint8_t SdAcmd6(SdCard *pSd,
     return SendMciCommand(pSd, fCallback);
 }
 
+/**
+ * Sets the number of write blocks to be pre-erased before writing, to make
+ * a following multiple block write (CMD25) faster.
+ * The pre-erase count is reset by the card once the write command completes.
+ * Should be invoked after SdmmcCmd55().
+ * \param pSd      Pointer to a SD card driver instance.
+ * \param nbBlocks Number of blocks to pre-erase (23 bits).
+ * \param pStatus  Pointer to buffer for command response as status.
+ * \param fCallback Pointer to optional callback invoked on command end.
+ *                  NULL:    Function return until command finished.
+ *                  Pointer: Return immediately and invoke callback at end.
+ *                  Callback argument is fixed to a pointer to SdCard instance.
+ * \return the command transfer result (see SendMciCommand).
+ */
+uint8_t SdAcmd23(SdCard *pSd,
+                 uint32_t nbBlocks,
+                 uint32_t *pStatus,
+                 SdmmcCallback fCallback)
+{
+    MciCmd *pCommand = &(mciCmd);
+
+    TRACE_DEBUG( "Acmd23()\n\r" ) ;
+    ResetMciCommand(pCommand);
+
+    /* Fill command information */
+    pCommand->cmd = SD_SET_WR_BLK_ERASE_COUNT;
+    pCommand->arg = nbBlocks & 0x7FFFFF;
+    pCommand->resType = 1;
+    pCommand->pResp = pStatus;
+
+    /* Send command */
+    return SendMciCommand(pSd, fCallback);
+}
+
 /**
  * The SD Status contains status bits that are related to the SD memory Card
  * proprietary features and may be used for future application-specific usage.
@@ -1738,6 +1955,37 @@ uint32_t SdmmcSetSpeed(SdCard * pSd,uint32_t clock)
     return MCI_SetSpeed(pSd->pSdDriver, clock, BOARD_MCK);
 }
 
+/**
+ * Setup HW to detect the SDIO card interrupt (DAT1, slot A).
+ * The callback is invoked from Sdmmc_Handler() and the detection is masked
+ * until this function is called again, once the card has been served.
+ * The MCI peripheral clock is kept on while the detection is enabled.
+ * \param pSd       Pointer to SdCard instance.
+ * \param fCallback Interrupt callback, NULL to stop the detection.
+ * \param pArg      Callback argument.
+ */
+uint8_t SdmmcEnableSdioIrq(SdCard * pSd, SdmmcIrqCallback fCallback, void * pArg)
+{
+    Mcid *pMci = (Mcid*)pSd->pSdDriver;
+    Hsmci *pMciHw = pMci->pMciHw;
+
+    if (fCallback) {
+        sdioIrqArg = pArg;
+        if (sdioIrqCallback == NULL)
+        {
+            PMC_AcquirePeripheral(pMci->mciId);
+        }
+        sdioIrqCallback = fCallback;
+        pMciHw->HSMCI_IER = HSMCI_IER_SDIOIRQA;
+    }
+    else if (sdioIrqCallback) {
+        pMciHw->HSMCI_IDR = HSMCI_IDR_SDIOIRQA;
+        sdioIrqCallback = NULL;
+        PMC_ReleasePeripheral(pMci->mciId);
+    }
+    return 0;
+}
+
 /**
  * Starts a MCI  transfer. This is a non blocking function. It will return
  * as soon as the transfer is started.
@@ -1750,12 +1998,21 @@ uint8_t Sdmmc_SendCommand(Mcid*pMci, MciCmd *pCommand)
 {
     Hsmci* pMciHw = pMci->pMciHw;
     uint32_t mciIer = 0, mciMr;
-    uint32_t transSize;
+    uint32_t transSize, firstSize, unitSize;
 
     assert(pMci);
     assert(pMciHw);
     assert(pCommand);
 
+    /* The PDC moves the data in a buffer and its next buffer, of up to
+       PDC_MAX_COUNT words (or bytes) each */
+    unitSize = isWordXfr(pCommand) ? 4 : 1;
+    if (pCommand->nbBlock * pCommand->blockSize > 2 * PDC_MAX_COUNT * unitSize)
+    {
+        TRACE_ERROR("MCICmd: %u blocks exceed the PDC\n\r", pCommand->nbBlock);
+        return SDMMC_ERROR_PARAM;
+    }
+
     /* Try to acquire the MCI semaphore */
     if (pMci->semaphore == 0)
     {
@@ -1767,8 +2024,8 @@ uint8_t Sdmmc_SendCommand(Mcid*pMci, MciCmd *pCommand)
     pMci->pCommand = pCommand;
     pCommand->state = SDMMC_CMD_PENDING;
 
-    /* Enable the MCI peripheral clock */
-    PMC_EnablePeripheral(pMci->mciId);
+    /* Clock the MCI until the command completes */
+    PMC_AcquirePeripheral(pMci->mciId);
 
 #if 1
     /* Wait for NOTBUSY (DATA bus IDLE) */
@@ -1833,6 +2090,9 @@ uint8_t Sdmmc_SendCommand(Mcid*pMci, MciCmd *pCommand)
         if (pCommand->nbBlock == 0)
         {
             TRACE_ERROR("MCICmd: At least one block required\n\r");
+            PMC_ReleasePeripheral(pMci->mciId);
+            pMci->pCommand = NULL;
+            pMci->semaphore++;
             return SDMMC_ERROR_PARAM;
         }
 
@@ -1840,14 +2100,24 @@ uint8_t Sdmmc_SendCommand(Mcid*pMci, MciCmd *pCommand)
         if (   pCommand->tranType == MCI_START_WRITE
             || pCommand->tranType == MCI_START_READ)
         {
-            /* Set number of blocks */
-            pMciHw->HSMCI_BLKR = (pCommand->blockSize << 16)
-                               | (pCommand->nbBlock   <<  0);
+            /* Set number of blocks, or the byte count of a SDIO byte
+               transfer (0 for 512 bytes) */
+            if ((pCommand->cmd & HSMCI_CMDR_TRTYP_Msk) == HSMCI_CMDR_TRTYP_BYTE)
+            {
+                pMciHw->HSMCI_BLKR = (pCommand->blockSize << 16)
+                                   | (pCommand->blockSize & 0x1FF);
+            }
+            else
+            {
+                pMciHw->HSMCI_BLKR = (pCommand->blockSize << 16)
+                                   | (pCommand->nbBlock   <<  0);
+            }
         }
 
-        /* Force byte transfer */
+        /* Word transfers by default, so that each PDC access moves a full
+           FIFO word; force byte transfer for odd sizes or buffers */
         transSize = (pCommand->nbBlock * pCommand->blockSize);
-        if (pCommand->blockSize & 0x3)
+        if (unitSize == 1)
         {
             mciMr |= HSMCI_MR_FBYTE;
         }
@@ -1855,6 +2125,8 @@ uint8_t Sdmmc_SendCommand(Mcid*pMci, MciCmd *pCommand)
         {
             transSize = toWCOUNT(transSize);
         }
+        /* Beyond one PDC buffer, the next buffer takes the remainder */
+        firstSize = (transSize > PDC_MAX_COUNT) ? PDC_MAX_COUNT : transSize;
 
         /* Set block size & enable PDC */
         pMciHw->HSMCI_MR = mciMr | HSMCI_MR_WRPROOF
@@ -1867,8 +2139,9 @@ uint8_t Sdmmc_SendCommand(Mcid*pMci, MciCmd *pCommand)
             || pCommand->tranType == MCI_WRITE )
         {
             pMciHw->HSMCI_TPR = (uint32_t)pCommand->pData;
-            pMciHw->HSMCI_TCR = transSize;
-            pMciHw->HSMCI_TNCR = 0;
+            pMciHw->HSMCI_TCR = firstSize;
+            pMciHw->HSMCI_TNPR = (uint32_t)&pCommand->pData[firstSize * unitSize];
+            pMciHw->HSMCI_TNCR = transSize - firstSize;
 
             if (pCommand->tranType == MCI_START_WRITE)
             {
@@ -1883,8 +2156,9 @@ uint8_t Sdmmc_SendCommand(Mcid*pMci, MciCmd *pCommand)
         else
         {
             pMciHw->HSMCI_RPR = (uint32_t)pCommand->pData;
-            pMciHw->HSMCI_RCR = transSize;
-            pMciHw->HSMCI_RNCR = 0;
+            pMciHw->HSMCI_RCR = firstSize;
+            pMciHw->HSMCI_RNPR = (uint32_t)&pCommand->pData[firstSize * unitSize];
+            pMciHw->HSMCI_RNCR = transSize - firstSize;
             pMciHw->HSMCI_PTCR = HSMCI_PTCR_RXTEN;
             if (pCommand->tranType == MCI_START_READ)
             {
@@ -1950,13 +2224,30 @@ void Sdmmc_Handler(Mcid*pMci)
 
     assert(pMci);
     assert(pMciHw);
-    assert(pCommand);
 
     /* Read the status register */
     SR = pMciHw->HSMCI_SR;
     mask = pMciHw->HSMCI_IMR;
     maskedSR = SR & mask;
 
+    /* SDIO card interrupt, masked until the card is served */
+    if (maskedSR & HSMCI_SR_SDIOIRQA)
+    {
+        pMciHw->HSMCI_IDR = HSMCI_IDR_SDIOIRQA;
+        if (sdioIrqCallback)
+        {
+            sdioIrqCallback(sdioIrqArg);
+        }
+    }
+    mask &= ~(uint32_t)HSMCI_IMR_SDIOIRQA;
+    maskedSR &= ~(uint32_t)HSMCI_SR_SDIOIRQA;
+
+    /* No command in progress */
+    if (pMci->semaphore || pCommand == NULL)
+    {
+        return;
+    }
+
     //TRACE_INFO_WP("i%dS %x\n\r", (pCommand->cmd & HSMCI_CMDR_CMDNB_Msk), SR);
     //TRACE_INFO_WP("i%dM %x\n\r", (pCommand->cmd & HSMCI_CMDR_CMDNB_Msk), maskedSR);
 
@@ -2134,16 +2425,22 @@ void Sdmmc_Handler(Mcid*pMci)
         else
         {
             MCI_Reset(pMci, 1);
+            /* The reset cleared the SDIO interrupt detection */
+            if (sdioIrqCallback)
+            {
+                MCI_Enable(pMciHw);
+                pMciHw->HSMCI_IER = HSMCI_IER_SDIOIRQA;
+            }
         }
 
         /* Disable PDC */
         pMciHw->HSMCI_PTCR = HSMCI_PTCR_RXTDIS | HSMCI_PTCR_TXTDIS;
 
-        /* Disable interrupts */
-        pMciHw->HSMCI_IDR = pMciHw->HSMCI_IMR;
+        /* Disable interrupts, but the SDIO one */
+        pMciHw->HSMCI_IDR = pMciHw->HSMCI_IMR & ~(uint32_t)HSMCI_IMR_SDIOIRQA;
 
-        /* Disable peripheral */
-        PMC_DisablePeripheral(pMci->mciId);
+        /* Release the clock, still taken while the SDIO interrupt is detected */
+        PMC_ReleasePeripheral(pMci->mciId);
 
         /* Release the semaphore */
         pMci->semaphore++;
@@ -63,6 +63,11 @@
 #define SD_STATE_WR_RDY   0x21
 #define SD_STATE_WR_BSY   0x22
 #define SD_STATE_BOOT     0x30
+#define SD_STATE_IDENT    0x40
+
+/** Identification flags kept between SD_InitStart() and SD_InitPoll() */
+#define SD_IDENT_F8       (1 << 0)
+#define SD_IDENT_IO       (1 << 1)
 /**     @}*/
 
 /** \addtogroup sdmmc_status_bm SD/MMC Status register constants
@@ -153,6 +158,18 @@
                             /*| STATUS_STATE*/ \
                             /*| STATUS_READY_FOR_DATA*/ \
                             | STATUS_SWITCH_ERROR ))
+
+#define STATUS_ERASE ((uint32_t)( STATUS_ADDR_OUT_OR_RANGE \
+                        | STATUS_ERASE_SEQ_ERROR \
+                        | STATUS_ERASE_PARAM \
+                        | STATUS_WP_VIOLATION \
+                        | STATUS_WP_ERASE_SKIP \
+                        | STATUS_CARD_IS_LOCKED \
+                        | STATUS_COM_CRC_ERROR \
+                        | STATUS_ILLEGAL_COMMAND \
+                        | STATUS_CC_ERROR \
+                        | STATUS_ERROR \
+                        | STATUS_ERASE_RESET ))
 /**     @}*/
 
 /** \addtogroup sdio_status_bm SDIO Status definitions
@@ -232,6 +249,17 @@
 #define SD_ACMD41_SUPPORT       ((uint32_t)1 << 2)
 #define SD_ACMD51_SUPPORT       ((uint32_t)1 << 3)
 #define SD_CMD16_SUPPORT        ((uint32_t)1 << 8)
+#define MMC_CMD23_SUPPORT       ((uint32_t)1 << 9)
+
+/** Blocks streamed to measure the read throughput at init */
+#define SDMMC_TUNE_NB_BLOCKS        32
+/** Lowest 4-bit clock tried before the fallback goes to 1-bit mode */
+#define SDMMC_TUNE_MIN_4BIT_SPEED   12000000
+/** Lowest clock tried by the fallback */
+#define SDMMC_TUNE_MIN_SPEED        400000
+
+/** SDIO polls of I/O Ready while a function is enabled */
+#define SDIO_IOR_RETRY              1000
 
 /*----------------------------------------------------------------------------
  *         Macros
@@ -276,12 +304,22 @@
 
 /** Check if MMC card support HS mode (4.0 or later) */
 #define MMC_IsHsModeSupported(pSd)  \
-    (MMC_IsCSDVer1_2(pSd)&&(SD_EXTCSD_CARD_TYPE(pSd)&0x2))
+    (MMC_IsCSDVer1_2(pSd)&&(SD_EXTCSD_CARD_TYPE(pSd) \
+        &(SD_EXTCSD_CARD_TYPE_HS_26|SD_EXTCSD_CARD_TYPE_HS_52)))
 
 /*----------------------------------------------------------------------------
  *         Local variables
  *----------------------------------------------------------------------------*/
 
+/** SDIO function drivers, by function number */
+static struct {
+    SdioIrqHandler fHandler;
+    void *pArg;
+} sdioFunctions[8];
+
+/** Set by the SDIO interrupt, cleared by SDIO_ServiceIrq() */
+static volatile uint8_t sdioIrqPending = 0;
+
 /** SD/MMC transfer rate unit codes (10K) list */
 static const uint32_t sdmmcTransUnits[7] = {
     10, 100, 1000, 10000,
@@ -497,6 +535,27 @@ static inline uint8_t Cmd25(SdCard *pSd,
                       pStatus, NULL);
 }
 
+/**
+ * Sets the block count of the next multiple block transfer (MMC).
+ * The support flag is cleared if the card rejects the command.
+ * \param pSd      Pointer to a SD card driver instance.
+ * \param nbBlocks Number of blocks of the next transfer.
+ */
+static uint8_t Cmd23(SdCard *pSd, uint16_t nbBlocks)
+{
+    uint32_t status = 0;
+    uint8_t error;
+
+    error = MmcCmd23(pSd, nbBlocks, &status, NULL);
+    if (!error && (status & STATUS_STOP & ~(STATUS_STATE | STATUS_READY_FOR_DATA)))
+        error = SDMMC_ERROR;
+    if (error) {
+        TRACE_ERROR("Cmd23(%u): %d, st %x\n\r", nbBlocks, error, status);
+        pSd->optCmdBitMap &= ~MMC_CMD23_SUPPORT;
+    }
+    return error;
+}
+
 static inline uint8_t Cmd52(SdCard *pSd,
                             uint8_t wrFlag,
                             uint8_t funcNb,
@@ -576,7 +635,56 @@ static uint8_t Acmd13(SdCard *pSd, uint32_t *pSdSTAT)
 }
 
 /**
- * Asks to all cards to send their operations conditions.
+ * Sets the number of blocks to pre-erase before the next multiple block
+ * write. Only for SD cards.
+ * \param pSd      Pointer to a SD card driver instance.
+ * \param nbBlocks Number of blocks that will be written.
+ * \return the command transfer result (see SendCommand).
+ */
+static uint8_t Acmd23(SdCard *pSd, uint32_t nbBlocks)
+{
+    uint8_t error;
+    error = SdmmcCmd55(pSd, CARD_ADDR(pSd), NULL);
+    if (error) {
+        TRACE_ERROR("Acmd23.cmd55:%d\n\r", error);
+        return error;
+    }
+    return SdAcmd23(pSd, nbBlocks, NULL, NULL);
+}
+
+/**
+ * Asks to all cards to send their operations conditions, once.
+ * Returns the command transfer result (see SendCommand), or SDMMC_ERROR_BUSY
+ * while the card power up is not finished.
+ * \param pSd  Pointer to a SD card driver instance.
+ * \param hcs  Shall be true if Host support High capacity.
+ * \param pCCS  Set the pointed flag to 1 if hcs != 0 and SD OCR CCS flag is set.
+ */
+static uint8_t Acmd41Poll(SdCard *pSd, uint8_t hcs, uint8_t *pCCS)
+{
+    uint8_t error;
+    uint32_t arg;
+    error = SdmmcCmd55(pSd, 0, NULL);
+    if (error) {
+        TRACE_ERROR("Acmd41.cmd55:%d\n\r", error);
+        return error;
+    }
+    arg = SDMMC_HOST_VOLTAGE_RANGE;
+    if (hcs) arg |= OCR_SD_CCS;
+    error = SdAcmd41(pSd, &arg, NULL);
+    if (error) {
+        TRACE_ERROR("Acmd41.cmd41:%d\n\r", error);
+        return error;
+    }
+    *pCCS = ((arg & OCR_SD_CCS)!=0);
+    if ((arg & OCR_POWER_UP_BUSY) != OCR_POWER_UP_BUSY)
+        return SDMMC_ERROR_BUSY;
+    return 0;
+}
+
+/**
+ * Asks to all cards to send their operations conditions, until the card
+ * power up is finished.
  * Returns the command transfer result (see SendCommand).
  * \param pSd  Pointer to a SD card driver instance.
  * \param hcs  Shall be true if Host support High capacity.
@@ -585,23 +693,10 @@ static uint8_t Acmd13(SdCard *pSd, uint32_t *pSdSTAT)
 static uint8_t Acmd41(SdCard *pSd, uint8_t hcs, uint8_t *pCCS)
 {
     uint8_t error;
-    uint32_t arg;
     do {
-        error = SdmmcCmd55(pSd, 0, NULL);
-        if (error) {
-            TRACE_ERROR("Acmd41.cmd55:%d\n\r", error);
-            return error;
-        }
-        arg = SDMMC_HOST_VOLTAGE_RANGE;
-        if (hcs) arg |= OCR_SD_CCS;
-        error = SdAcmd41(pSd, &arg, NULL);
-        if (error) {
-            TRACE_ERROR("Acmd41.cmd41:%d\n\r", error);
-            return error;
-        }
-        *pCCS = ((arg & OCR_SD_CCS)!=0);
-    } while ((arg & OCR_POWER_UP_BUSY) != OCR_POWER_UP_BUSY);
-    return 0;
+        error = Acmd41Poll(pSd, hcs, pCCS);
+    } while (error == SDMMC_ERROR_BUSY);
+    return error;
 }
 
 /**
@@ -762,12 +857,15 @@ static uint8_t PerformSingleTransfer(SdCard *pSd,
  * \param nbBlocks Number of blocks to be transfer, 0 for infinite transfer.
  * \param pData    Data buffer whose size is at least the block size.
  * \param isRead   1 for read data and 0 for write data.
+ * \param blockCount Number of blocks announced with CMD23 just before the
+ *                   transfer command, 0 for an open-ended transfer.
  */
 static uint8_t MoveToTransferState(SdCard *pSd,
                                    uint32_t address,
                                    uint16_t nbBlocks,
                                    uint8_t *pData,
-                                   uint8_t isRead)
+                                   uint8_t isRead,
+                                   uint16_t blockCount)
 {
     uint32_t status;
     uint8_t error;
@@ -811,6 +909,12 @@ static uint8_t MoveToTransferState(SdCard *pSd,
 
         assert( (status & STATUS_STATE) == STATUS_TRAN ) ; /* "SD Card can't be configured in transfer state 0x%X\n\r", (status & STATUS_STATE)>>9 */
 
+        /* Pre-defined transfer */
+        if (blockCount) {
+            error = Cmd23(pSd, blockCount);
+            if (error) return error;
+        }
+
         /* Move to Receiving data state */
         error = Cmd18(pSd, nbBlocks, pData, SD_ADDRESS(pSd,address), &status);
 
@@ -840,6 +944,13 @@ static uint8_t MoveToTransferState(SdCard *pSd,
         }
 
         while ((status & STATUS_READY_FOR_DATA) == 0);
+
+        /* Pre-defined transfer */
+        if (blockCount) {
+            error = Cmd23(pSd, blockCount);
+            if (error) return error;
+        }
+
         /* Move to Sending data state */
         error = Cmd25(pSd,
                       nbBlocks,
@@ -862,6 +973,45 @@ static uint8_t MoveToTransferState(SdCard *pSd,
     return error;
 }
 
+/**
+ * Perform a pre-defined multiple block transfer: the block count is given
+ * with CMD23 before CMD18/CMD25, so that the card goes back to transfer state
+ * by itself at the end of the data, without STOP_TRANSMISSION.
+ * \param pSd      Pointer to a SD card driver instance.
+ * \param address  Address of the first block to transfer.
+ * \param pData    Data buffer whose size is at least nbBlocks blocks.
+ * \param nbBlocks Number of blocks to transfer.
+ * \param isRead   1 for read data and 0 for write data.
+ * \param pCallback Pointer to callback function invoked when done.
+ *                  0 to start a blocked transfer.
+ * \param pArgs     Pointer to callback function arguments.
+ */
+static uint8_t PerformPredefinedTransfer(SdCard *pSd,
+                                         uint32_t address,
+                                         uint8_t *pData,
+                                         uint16_t nbBlocks,
+                                         uint8_t isRead,
+                                         SdmmcCallback pCallback,
+                                         void *pArgs)
+{
+    uint8_t error;
+
+    error = MoveToTransferState(pSd, address, 0, 0, isRead, nbBlocks);
+    pSd->state = SD_STATE_READY;
+    pSd->preBlock = 0xFFFFFFFF;
+    if (error) {
+        TRACE_ERROR("PredefTx(%u,%u): %d\n\r", address, nbBlocks, error);
+        return error;
+    }
+    if (isRead)
+        error = SdmmcRead(pSd, BLOCK_SIZE(pSd), nbBlocks, pData,
+                          pCallback, pArgs);
+    else
+        error = SdmmcWrite(pSd, BLOCK_SIZE(pSd), nbBlocks, pData,
+                           pCallback, pArgs);
+    return error;
+}
+
 /**
  * Switch card state between STBY and TRAN (or CMD and TRAN)
  * \param pSd       Pointer to a SD card driver instance.
@@ -1075,6 +1225,11 @@ static uint8_t SdMmcEnableHighSpeed(SdCard *pSd)
             return SDMMC_ERROR_NOT_SUPPORT;
         }
         TRACE_WARNING("MMC HS Enabled\n\r");
+        /* HSMCI samples on one clock edge only */
+        if (SD_EXTCSD_CARD_TYPE(pSd) & (SD_EXTCSD_CARD_TYPE_DDR_52_1_8V
+                                        | SD_EXTCSD_CARD_TYPE_DDR_52_1_2V)) {
+            TRACE_INFO("MMC DDR not supported by Host\n\r");
+        }
     }
     /* SD (+IO) */
     else {
@@ -1225,17 +1380,18 @@ static uint8_t SdMmcDesideBuswidth(SdCard *pSd)
 }
 
 /**
- * \brief Run the SD/MMC/SDIO Mode initialization sequence.
- * This function runs the initialization procedure and the identification
- * process. Then it leaves the card in ready state. The following procedure must
- * check the card type and continue to put the card into tran(for memory card)
- * or cmd(for io card) state for data exchange.
+ * \brief Start the SD/MMC/SDIO Mode identification, up to the memory power up.
+ * It resets the card and checks the supplied voltage and the SDIO functions.
  * \param pSd  Pointer to a SD card driver instance.
+ * \param pF8  Set to 1 if the card answered CMD8.
+ * \param pIo  Set to 1 if the card has SDIO functions.
+ * \param pMp  Set to 1 if the card has a memory to power up.
  * \return 0 if successful; otherwise returns an \ref sdmmc_rc "SD_ERROR code".
  */
-static uint8_t SdMmcIdentify(SdCard *pSd)
+static uint8_t SdMmcIdentifyStart(SdCard *pSd,
+                                  uint8_t *pF8, uint8_t *pIo, uint8_t *pMp)
 {
-    uint8_t mem = 0, io = 0, f8 = 0, mp = 1, ccs = 0;
+    uint8_t io = 0, f8 = 0, mp = 1;
     uint32_t status;
     uint8_t error;
     /* Reset HC to default HS and BusMode */
@@ -1301,34 +1457,55 @@ static uint8_t SdMmcIdentify(SdCard *pSd)
         /* IO only ?*/
         mp = ((status & OCR_SDIO_MP) > 0);
     }
-    /* Has memory: SD/MMC/COMBO */
-    if (mp) {
-        /* Try SD memory initialize */
-        error = Acmd41(pSd, f8, &ccs);
-        if (error) {
-            unsigned int cmd1Retries = 10000;
-            TRACE_DEBUG("SdMmcIdentify.Acmd41: %u, try MMC\n\r", error);
-            /* Try MMC initialize */
-            error = SwReset(pSd, 10);
-            if (error) {
-                TRACE_ERROR("SdMmcIdentify.Mmc.SwReset: %u\n\r", error);
-                return SDMMC_ERROR;
-            }
-            ccs = 1;
-            do { error = Cmd1(pSd, &ccs); }while(error && cmd1Retries -- > 0);
-            if (error) {
-                TRACE_ERROR("SdMmcIdentify.Cmd1: %u\n\r", error);
-                return SDMMC_ERROR;
-            }
-            else if (ccs) pSd->cardType = CARD_MMCHD;
-            else          pSd->cardType = CARD_MMC;
-            /* MMC card identification OK */
-            TRACE_INFO("MMC Card\n\r");
-            return 0;
-        }
-        else if (ccs) { TRACE_INFO("SDHC MEM\n\r");}
-        else          { TRACE_INFO("SD MEM\n\r");}
-        mem = 1;
+
+    *pF8 = f8;
+    *pIo = io;
+    *pMp = mp;
+    return 0;
+}
+
+/**
+ * \brief Run the MMC identification, once the card did not answer ACMD41.
+ * \param pSd  Pointer to a SD card driver instance.
+ * \return 0 if successful; otherwise returns an \ref sdmmc_rc "SD_ERROR code".
+ */
+static uint8_t MmcIdentify(SdCard *pSd)
+{
+    unsigned int cmd1Retries = 10000;
+    uint8_t ccs;
+    uint8_t error;
+    /* Try MMC initialize */
+    error = SwReset(pSd, 10);
+    if (error) {
+        TRACE_ERROR("SdMmcIdentify.Mmc.SwReset: %u\n\r", error);
+        return SDMMC_ERROR;
+    }
+    ccs = 1;
+    do { error = Cmd1(pSd, &ccs); }while(error && cmd1Retries -- > 0);
+    if (error) {
+        TRACE_ERROR("SdMmcIdentify.Cmd1: %u\n\r", error);
+        return SDMMC_ERROR;
+    }
+    else if (ccs) pSd->cardType = CARD_MMCHD;
+    else          pSd->cardType = CARD_MMC;
+    /* MMC card identification OK */
+    TRACE_INFO("MMC Card\n\r");
+    return 0;
+}
+
+/**
+ * \brief End the SD/MMC/SDIO Mode identification: set the card type.
+ * \param pSd  Pointer to a SD card driver instance.
+ * \param mem  1 if the SD memory is powered up.
+ * \param io   1 if the card has SDIO functions.
+ * \param ccs  1 if the SD memory is high capacity.
+ * \return 0 if successful; otherwise returns an \ref sdmmc_rc "SD_ERROR code".
+ */
+static uint8_t SdMmcIdentifyEnd(SdCard *pSd, uint8_t mem, uint8_t io, uint8_t ccs)
+{
+    if (mem) {
+        if (ccs) { TRACE_INFO("SDHC MEM\n\r");}
+        else     { TRACE_INFO("SD MEM\n\r");}
     }
     /* SD(IO) + MEM ? */
     if (!mem) {
@@ -1348,6 +1525,37 @@ static uint8_t SdMmcIdentify(SdCard *pSd)
     return 0;
 }
 
+/**
+ * \brief Run the SD/MMC/SDIO Mode initialization sequence.
+ * This function runs the initialization procedure and the identification
+ * process. Then it leaves the card in ready state. The following procedure must
+ * check the card type and continue to put the card into tran(for memory card)
+ * or cmd(for io card) state for data exchange.
+ * \param pSd  Pointer to a SD card driver instance.
+ * \return 0 if successful; otherwise returns an \ref sdmmc_rc "SD_ERROR code".
+ */
+static uint8_t SdMmcIdentify(SdCard *pSd)
+{
+    uint8_t mem = 0, io, f8, mp, ccs = 0;
+    uint8_t error;
+
+    error = SdMmcIdentifyStart(pSd, &f8, &io, &mp);
+    if (error) return error;
+
+    /* Has memory: SD/MMC/COMBO */
+    if (mp) {
+        /* Try SD memory initialize */
+        error = Acmd41(pSd, f8, &ccs);
+        if (error) {
+            TRACE_DEBUG("SdMmcIdentify.Acmd41: %u, try MMC\n\r", error);
+            return MmcIdentify(pSd);
+        }
+        mem = 1;
+    }
+
+    return SdMmcIdentifyEnd(pSd, mem, io, ccs);
+}
+
 /**
  * \brief Run the SD/MMC/SDIO enumeration sequence.
  * This function runs after the initialization and identification procedure. It
@@ -1456,14 +1664,180 @@ static uint8_t SdMmcEnum(SdCard *pSd)
         return SDMMC_ERROR;
     }
 
-    /* In HS mode transfer speed *2 */
-    if (hsExec) pSd->transSpeed *= 2;
+    /* In HS mode transfer speed *2, MMC HS clock given by EXT_CSD */
+    if (hsExec) {
+        if ((pSd->cardType & CARD_TYPE_bmSDMMC) == CARD_TYPE_bmMMC)
+            pSd->transSpeed =
+                (SD_EXTCSD_CARD_TYPE(pSd) & SD_EXTCSD_CARD_TYPE_HS_52) ?
+                    52000000 : 26000000;
+        else
+            pSd->transSpeed *= 2;
+    }
 
     /* Update card information since status changed */
     if (bwExec || hsExec) SdMmcUpdateInformation(pSd, hsExec, 1);
     return 0;
 }
 
+/**
+ * \brief Leave the High-Speed timing, on the card then on the host.
+ * \param pSd Pointer to SdCard instance.
+ */
+static uint8_t SdMmcDisableHighSpeed(SdCard *pSd)
+{
+    uint8_t  error = 0;
+    uint32_t status;
+
+    SdmmcEnableHsMode(pSd, 0);
+
+    if ((pSd->cardType & CARD_TYPE_bmSDMMC) == CARD_TYPE_bmMMC) {
+        MmcCmd6Arg cmd6Arg = {
+            0x3,
+            SD_EXTCSD_HS_TIMING_INDEX,
+            SD_EXTCSD_HS_TIMING_DISABLE,
+            0};
+        error = MmcCmd6(pSd, &cmd6Arg, &status, NULL);
+    }
+    else if ((pSd->cardType & CARD_TYPE_bmSDMMC) == CARD_TYPE_bmSD) {
+        /* Back to the default access mode */
+        SdCmd6Arg cmd6Arg = {
+            0, 0, 0xF, 0xF, 0xF, 0xF, 0, 1
+        };
+        uint32_t switchStatus[512/32];
+        error = SdCmd6(pSd, &cmd6Arg, switchStatus, &status, NULL);
+    }
+    if (error) {
+        TRACE_ERROR("SdMmcDisableHS.Cmd6: %u\n\r", error);
+    }
+    return error;
+}
+
+/**
+ * \brief Go back to the 1-bit bus, on the card then on the host.
+ * \param pSd Pointer to SdCard instance.
+ */
+static uint8_t SdMmcFallbackBuswidth(SdCard *pSd)
+{
+    uint8_t  error;
+    uint32_t status;
+
+    if ((pSd->cardType & CARD_TYPE_bmSDMMC) == CARD_TYPE_bmMMC) {
+        MmcCmd6Arg cmd6Arg = {
+            0x1, SD_EXTCSD_BUS_WIDTH_INDEX, SD_EXTCSD_BUS_WIDTH_1BIT, 0
+        };
+        error = MmcCmd6(pSd, &cmd6Arg, &status, NULL);
+    }
+    else {
+        error = Acmd6(pSd, SDMMC_BUS_1_BIT);
+    }
+    if (error) {
+        TRACE_ERROR("SdMmcFallbackBuswidth: %u\n\r", error);
+    }
+
+    pSd->busMode = SDMMC_BUS_1_BIT;
+    SdmmcSetBusWidth(pSd, SDMMC_BUS_1_BIT);
+    return error;
+}
+
+/**
+ * \brief Measure the block read throughput: stream SDMMC_TUNE_NB_BLOCKS
+ * blocks from the card start as SD_Read() does, on the DWT cycle counter.
+ * \param pSd    Pointer to SdCard instance.
+ * \param pBlock Buffer of one block.
+ * \return Throughput in KB/s, 0 if the read failed.
+ */
+static uint32_t SdMmcMeasureRead(SdCard *pSd, uint8_t *pBlock)
+{
+    uint32_t start, cycles, status;
+    uint32_t i;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+
+    start = DWT_CYCCNT;
+    if (MoveToTransferState(pSd, 0, 0, 0, 1, 0)) {
+        return 0;
+    }
+    for (i = 0; i < SDMMC_TUNE_NB_BLOCKS; i ++) {
+        SdmmcRead(pSd, BLOCK_SIZE(pSd), 1, pBlock, NULL, NULL);
+    }
+    cycles = DWT_CYCCNT - start;
+
+    Cmd12(pSd, &status);
+    pSd->preBlock = 0xFFFFFFFF;
+
+    if (cycles == 0) {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)SDMMC_TUNE_NB_BLOCKS * BLOCK_SIZE(pSd)
+                       * BOARD_MCK) / ((uint64_t)cycles * 1024));
+}
+
+/**
+ * \brief Select the memory card clock and check the data path.
+ * The clock is set to the TRAN_SPEED negotiated by SdMmcEnum(), then the
+ * first block is read. On error (data CRC, timeout), the mode is lowered
+ * step by step and the block read again: High-Speed timing off (half
+ * clock), half clock while above SDMMC_TUNE_MIN_4BIT_SPEED, 1-bit bus, then
+ * half clock down to SDMMC_TUNE_MIN_SPEED. The final mode and the measured
+ * read throughput are reported.
+ * \param pSd Pointer to SdCard instance.
+ * \return 0 if successful; otherwise returns an \ref sdmmc_rc "error code".
+ */
+static uint8_t SdMmcTuneSpeed(SdCard *pSd)
+{
+    uint32_t block[SDMMC_BLOCK_SIZE / 4];
+    uint32_t clock;
+    uint8_t  hs, error;
+
+    /* Query the host HS mode */
+    hs = SdmmcEnableHsMode(pSd, 0xFF);
+    clock = SdmmcSetSpeed(pSd, pSd->transSpeed);
+
+    for (;;) {
+        error = PerformSingleTransfer(pSd, 0, (uint8_t*)block, 1);
+        if (error == 0 || error == SDMMC_ERROR_NOT_INITIALIZED) {
+            break;
+        }
+        TRACE_WARNING("SD/MMC read error %u at %uK\n\r", error, clock/1000);
+
+        if (hs) {
+            hs = 0;
+            pSd->transSpeed /= 2;
+            clock = SdmmcSetSpeed(pSd, pSd->transSpeed);
+            SdMmcDisableHighSpeed(pSd);
+        }
+        else if (pSd->busMode != SDMMC_BUS_1_BIT
+                 && pSd->transSpeed / 2 >= SDMMC_TUNE_MIN_4BIT_SPEED) {
+            pSd->transSpeed /= 2;
+            clock = SdmmcSetSpeed(pSd, pSd->transSpeed);
+        }
+        else if (pSd->busMode != SDMMC_BUS_1_BIT) {
+            SdMmcFallbackBuswidth(pSd);
+        }
+        else if (pSd->transSpeed / 2 >= SDMMC_TUNE_MIN_SPEED) {
+            pSd->transSpeed /= 2;
+            clock = SdmmcSetSpeed(pSd, pSd->transSpeed);
+        }
+        else {
+            break;
+        }
+    }
+    pSd->accSpeed = clock;
+    if (error) {
+        TRACE_ERROR("SdMmcTuneSpeed: %u\n\r", error);
+        return error;
+    }
+
+    TRACE_WARNING_WP("-I- Set SD/MMC clock to %dK, %d-bit%s, read %u KB/s\n\r",
+                     clock/1000,
+                     (pSd->busMode == SDMMC_BUS_8_BIT) ? 8 :
+                        ((pSd->busMode == SDMMC_BUS_4_BIT) ? 4 : 1),
+                     hs ? " HS" : "",
+                     SdMmcMeasureRead(pSd, (uint8_t*)block));
+    return 0;
+}
+
 /*----------------------------------------------------------------------------
  *         Global functions
  *----------------------------------------------------------------------------*/
@@ -1472,6 +1846,9 @@ static uint8_t SdMmcEnum(SdCard *pSd)
  * Read Blocks of data in a buffer pointed by pData. The buffer size must be at
  * least 512 byte long. This function checks the SD card status register and
  * address the card if required before sending the read command.
+ * MMC cards supporting SET_BLOCK_COUNT (CMD23) get a pre-defined transfer of
+ * length blocks; the other cards keep an open-ended transfer, continued by
+ * the next call at the following address.
  * \return 0 if successful; otherwise returns an \ref sdmmc_rc "error code".
  * \param pSd      Pointer to a SD card driver instance.
  * \param address  Address of the block to read.
@@ -1494,10 +1871,17 @@ uint8_t SD_Read(SdCard        *pSd,
     assert( pSd != NULL ) ;
     assert( pData != NULL ) ;
 
+    if (pSd->optCmdBitMap & MMC_CMD23_SUPPORT) {
+        /* Block count known in advance, no STOP_TRANSMISSION needed */
+        error = PerformPredefinedTransfer(pSd, address, pData, length, 1,
+                                          pCallback, pArgs);
+        TRACE_DEBUG("SDrd(%u,%u):%u\n\r", address, length, error);
+        return error;
+    }
     if (   pSd->state != SD_STATE_READ
         || pSd->preBlock + 1 != address ) {
         /* Start infinite block reading */
-        error = MoveToTransferState(pSd, address, 0, 0, 1);
+        error = MoveToTransferState(pSd, address, 0, 0, 1, 0);
     }
     else    error = 0;
     if (!error) {
@@ -1508,13 +1892,14 @@ uint8_t SD_Read(SdCard        *pSd,
     }
     TRACE_DEBUG("SDrd(%u,%u):%u\n\r", address, length, error);
 
-    return 0;
+    return error;
 }
 
 /**
  * Write Blocks of data in a buffer pointed by pData. The buffer size must be at
  * least 512 byte long. This function checks the SD card status register and
  * address the card if required before sending the read command.
+ * As with SD_Read(), MMC cards supporting CMD23 get a pre-defined transfer.
  * \return 0 if successful; otherwise returns an \ref sdmmc_rc "error code".
  * \param pSd      Pointer to a SD card driver instance.
  * \param address  Address of the block to read.
@@ -1536,10 +1921,17 @@ uint8_t SD_Write(SdCard        *pSd,
 
     assert( pSd != NULL ) ;
 
+    if (pSd->optCmdBitMap & MMC_CMD23_SUPPORT) {
+        /* Block count known in advance, no STOP_TRANSMISSION needed */
+        error = PerformPredefinedTransfer(pSd, address, pData, length, 0,
+                                          pCallback, pArgs);
+        TRACE_DEBUG("SDwr(%u,%u):%u\n\r", address, length, error);
+        return error;
+    }
     if (   pSd->state != SD_STATE_WRITE
         || pSd->preBlock + 1 != address ) {
         /* Start infinite block writing */
-        error = MoveToTransferState(pSd, address, 0, 0, 0);
+        error = MoveToTransferState(pSd, address, 0, 0, 0, 0);
     }
     if (!error) {
         pSd->state = SD_STATE_WRITE;
@@ -1549,27 +1941,170 @@ uint8_t SD_Write(SdCard        *pSd,
     }
     TRACE_DEBUG("SDwr(%u,%u):%u\n\r", address, length, error);
 
-    return 0;
+    return error;
 }
 
 /**
- * Read 1 Block of data in a buffer pointed by pData. The buffer size must be
- * one block size. This function checks the SD card status register and
- * address the card if required before sending the read command.
+ * Opens a streaming session: one open-ended multiple block command is
+ * started at the given address and kept open across SD_StreamAppend() calls,
+ * so that sequential accesses cost no command round trip nor card busy wait.
+ * STOP_TRANSMISSION (CMD12) is only sent by SD_StreamClose(), or when a new
+ * session (or a SD_Read()/SD_Write() at a discontiguous address) is started.
  * \return 0 if successful; otherwise returns an \ref sdmmc_rc "error code".
- * \param pSd  Pointer to a SD card driver instance.
- * \param address  Address of the block to read.
- * \param pData    Data buffer whose size is at least the block size.
+ * \param pSd      Pointer to a SD card driver instance.
+ * \param address  Address of the first block to transfer.
+ * \param preErase For write sessions on SD cards, expected number of
+ *                 blocks to be written, pre-erased with ACMD23 before the
+ *                 first write. 0 to disable.
+ * \param isRead   1 for a read session and 0 for a write session.
  */
-uint8_t SD_ReadBlock( SdCard *pSd, uint32_t address, uint8_t *pData )
+uint8_t SD_StreamOpen(SdCard   *pSd,
+                      uint32_t address,
+                      uint32_t preErase,
+                      uint8_t  isRead)
 {
-    assert( pSd != NULL ) ;
-    assert( pData != NULL ) ;
+    uint8_t error;
 
-    TRACE_DEBUG("RdBlk(%d)\n\r", address);
+    assert( pSd != NULL ) ;
 
-    return PerformSingleTransfer(pSd, address, pData, 1);
-}
+    /* Still in the same session, nothing to send */
+    if (   pSd->state == (isRead ? SD_STATE_READ : SD_STATE_WRITE)
+        && pSd->preBlock + 1 == address
+        && !preErase ) {
+
+        return 0;
+    }
+
+    /* ACMD23 must directly precede CMD25, close previous session first */
+    if (   !isRead && preErase
+        && (pSd->cardType & CARD_TYPE_bmSDMMC) == CARD_TYPE_bmSD) {
+
+        error = SD_StreamClose(pSd);
+        if (!error) error = Acmd23(pSd, preErase);
+        if (error) {
+            TRACE_ERROR("SD_StreamOpen.Acmd23: %d\n\r", error);
+            return error;
+        }
+    }
+
+    /* Start infinite block transfer */
+    error = MoveToTransferState(pSd, address, 0, 0, isRead, 0);
+    if (error) {
+        pSd->state = SD_STATE_READY;
+        pSd->preBlock = 0xFFFFFFFF;
+        return error;
+    }
+    pSd->state = isRead ? SD_STATE_READ : SD_STATE_WRITE;
+    pSd->preBlock = address - 1;
+    TRACE_DEBUG("SDso(%u,%u,%u)\n\r", address, preErase, isRead);
+
+    return 0;
+}
+
+/**
+ * Transfers the next blocks of the session opened by SD_StreamOpen(), in
+ * the direction of the session, without sending any command.
+ * \return 0 if successful; otherwise returns an \ref sdmmc_rc "error code".
+ * \param pSd      Pointer to a SD card driver instance.
+ * \param pData    Data buffer whose size is at least length blocks.
+ * \param length   Number of blocks to be transferred.
+ * \param pCallback Pointer to callback function that invoked when done.
+ *                  0 to start a blocked transfer.
+ * \param pArgs     Pointer to callback function arguments.
+ */
+uint8_t SD_StreamAppend(SdCard        *pSd,
+                        void          *pData,
+                        uint16_t      length,
+                        SdmmcCallback pCallback,
+                        void          *pArgs)
+{
+    uint8_t error;
+
+    assert( pSd != NULL ) ;
+    assert( pData != NULL ) ;
+
+    if (pSd->state == SD_STATE_READ) {
+        error = SdmmcRead(pSd, BLOCK_SIZE(pSd), length, pData,
+                          pCallback, pArgs);
+    }
+    else if (pSd->state == SD_STATE_WRITE) {
+        error = SdmmcWrite(pSd, BLOCK_SIZE(pSd), length, pData,
+                           pCallback, pArgs);
+    }
+    else {
+        TRACE_ERROR("SD_StreamAppend: no session\n\r");
+        return SDMMC_ERROR_NOT_INITIALIZED;
+    }
+    if (!error) pSd->preBlock += length;
+    TRACE_DEBUG("SDsa(%u):%u\n\r", length, error);
+
+    return error;
+}
+
+/**
+ * Closes the current streaming session: sends STOP_TRANSMISSION and, after
+ * a write, waits until the card has programmed the data.
+ * Does nothing if no session is open.
+ * \return 0 if successful; otherwise returns an \ref sdmmc_rc "error code".
+ * \param pSd      Pointer to a SD card driver instance.
+ */
+uint8_t SD_StreamClose(SdCard *pSd)
+{
+    uint32_t status;
+    uint8_t error = 0;
+    uint8_t isWrite;
+
+    assert( pSd != NULL ) ;
+
+    if (   (pSd->state != SD_STATE_READ)
+        && (pSd->state != SD_STATE_WRITE)) {
+
+        return 0;
+    }
+    isWrite = (pSd->state == SD_STATE_WRITE);
+
+    error = Cmd12(pSd, &status);
+    pSd->state = SD_STATE_READY;
+    pSd->preBlock = 0xFFFFFFFF;
+    if (error) {
+        TRACE_ERROR("SD_StreamClose.Cmd12: %d\n\r", error);
+        return error;
+    }
+
+    /* Wait end of programming */
+    while (isWrite) {
+        error = Cmd13(pSd, &status);
+        if (error) {
+            TRACE_ERROR("SD_StreamClose.Cmd13: %d\n\r", error);
+            return error;
+        }
+        if (   (status & STATUS_READY_FOR_DATA)
+            && (status & STATUS_STATE) == STATUS_TRAN) {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Read 1 Block of data in a buffer pointed by pData. The buffer size must be
+ * one block size. This function checks the SD card status register and
+ * address the card if required before sending the read command.
+ * \return 0 if successful; otherwise returns an \ref sdmmc_rc "error code".
+ * \param pSd  Pointer to a SD card driver instance.
+ * \param address  Address of the block to read.
+ * \param pData    Data buffer whose size is at least the block size.
+ */
+uint8_t SD_ReadBlock( SdCard *pSd, uint32_t address, uint8_t *pData )
+{
+    assert( pSd != NULL ) ;
+    assert( pData != NULL ) ;
+
+    TRACE_DEBUG("RdBlk(%d)\n\r", address);
+
+    return PerformSingleTransfer(pSd, address, pData, 1);
+}
 
 /**
  * Write 1 Block of data pointed by pData. The buffer size must be
@@ -1616,6 +2151,10 @@ uint8_t SD_ReadBlocks(SdCard *pSd,
     assert( nbBlocks != NULL ) ;
 
     TRACE_DEBUG("RdBlks(%d,%d)\n\r", address, nbBlocks);
+    if (nbBlocks > 1 && (pSd->optCmdBitMap & MMC_CMD23_SUPPORT)) {
+        return PerformPredefinedTransfer(pSd, address, pData, nbBlocks, 1,
+                                         NULL, NULL);
+    }
     while(nbBlocks --) {
         error = PerformSingleTransfer(pSd, address, pData, 1);
         if (error)
@@ -1650,6 +2189,10 @@ uint8_t SD_WriteBlocks(SdCard *pSd,
     assert( nbBlocks != NULL ) ;
 
     TRACE_DEBUG("WrBlks(%d,%d)\n\r", address, nbBlocks);
+    if (nbBlocks > 1 && (pSd->optCmdBitMap & MMC_CMD23_SUPPORT)) {
+        return PerformPredefinedTransfer(pSd, address, pB, nbBlocks, 0,
+                                         NULL, NULL);
+    }
 
     while(nbBlocks --) {
         error = PerformSingleTransfer(pSd, address, pB, 0);
@@ -1662,17 +2205,131 @@ uint8_t SD_WriteBlocks(SdCard *pSd,
 }
 
 /**
- * Run the SDcard initialization sequence. This function runs the
- * initialisation procedure and the identification process, then it sets the
- * SD card in transfer state to set the block length and the bus width.
+ * Erase the blocks start to end (included) of a card in transfer state.
+ * \param pSd    Pointer to a SD card driver instance.
+ * \param start  First block to erase.
+ * \param end    Last block to erase.
+ */
+static uint8_t SdMmcEraseRange(SdCard *pSd, uint32_t start, uint32_t end)
+{
+    uint32_t status = 0;
+    uint8_t error;
+
+    error = SdmmcEraseStart(pSd, SD_ADDRESS(pSd, start), &status, NULL);
+    if (!error && (status & STATUS_ERASE) == 0)
+        error = SdmmcEraseEnd(pSd, SD_ADDRESS(pSd, end), &status, NULL);
+    if (!error && (status & STATUS_ERASE) == 0)
+        error = SdmmcCmd38(pSd, &status, NULL);
+    if (error) {
+        TRACE_ERROR("Erase(%u,%u): %d\n\r", start, end, error);
+        return error;
+    }
+    if (status & STATUS_ERASE) {
+        TRACE_ERROR("Erase.stat: %x\n\r", status & STATUS_ERASE);
+        return SDMMC_ERROR;
+    }
+    return 0;
+}
+
+/**
+ * Erase a range of blocks with the erase commands (SD CMD32/CMD33, MMC
+ * CMD35/CMD36, then CMD38) instead of writing them. The range must be
+ * aligned on the erase granularity of the card (see SD_GetEraseBlocks()).
+ * When the SD Status is known, the range is cut on the allocation unit
+ * boundaries, ERASE_SIZE AUs per erase command, so that each command
+ * completes within the ERASE_TIMEOUT of the card.
+ * The erased blocks read as 0 or 1 depending on the SCR DATA_STAT_AFTER_ERASE.
+ * \return 0 if successful; otherwise returns an \ref sdmmc_rc "error code".
+ * \param pSd      Pointer to a SD card driver instance.
+ * \param address  Address of the first block to erase.
+ * \param nbBlocks Number of blocks to erase.
+ */
+uint8_t SD_Erase(SdCard *pSd,
+                 uint32_t address,
+                 uint32_t nbBlocks)
+{
+    uint32_t status;
+    uint32_t unit;
+    uint32_t chunk;
+    uint32_t end;
+    uint8_t error = 0;
+
+    assert( pSd != NULL ) ;
+
+    if ((pSd->cardType & CARD_TYPE_bmSDMMC) == CARD_TYPE_bmUNKNOWN)
+        return SDMMC_ERROR_NOT_SUPPORT;
+
+    unit = SD_GetEraseBlocks(pSd);
+    if (   (address % unit) || (nbBlocks % unit)
+        || (address + nbBlocks < address)
+        || (address + nbBlocks > pSd->blockNr) ) {
+        TRACE_ERROR("Erase(%u,%u): unit %u\n\r", address, nbBlocks, unit);
+        return SDMMC_ERROR_PARAM;
+    }
+
+    TRACE_DEBUG("Erase(%d,%d)\n\r", address, nbBlocks);
+
+    /* Erase groups of AUs, or the whole range at once */
+    chunk = 0;
+    if (   (pSd->cardType & CARD_TYPE_bmSDMMC) == CARD_TYPE_bmSD
+        && (pSd->optCmdBitMap & SD_ACMD13_SUPPORT) ) {
+        chunk = SD_GetAuBlocks(pSd);
+        if (SD_STAT_ERASE_SIZE(pSd))
+            chunk *= SD_STAT_ERASE_SIZE(pSd);
+    }
+
+    /* Stop the open multiple block access */
+    if(    (pSd->state == SD_STATE_READ)
+        || (pSd->state == SD_STATE_WRITE)) {
+        error = Cmd12(pSd, &status);
+        if (error) {
+            TRACE_ERROR("Erase.Cmd12: st%x, er%d\n\r", pSd->state, error);
+        }
+        pSd->state = SD_STATE_READY;
+        pSd->preBlock = 0xFFFFFFFF;
+    }
+
+    while (nbBlocks) {
+
+        /* Wait for card to be back in transfer state */
+        do {
+            error = Cmd13(pSd, &status);
+            if (error) {
+                TRACE_ERROR("Erase.Cmd13: %d\n\r", error);
+                return error;
+            }
+            if(  ((status & STATUS_STATE) == STATUS_IDLE)
+               ||((status & STATUS_STATE) == STATUS_READY)
+               ||((status & STATUS_STATE) == STATUS_IDENT)) {
+                TRACE_ERROR("Erase.mode\n\r");
+                return SDMMC_ERROR_NOT_INITIALIZED;
+            }
+        } while (   ((status & STATUS_READY_FOR_DATA) == 0)
+                 || ((status & STATUS_STATE) != STATUS_TRAN) );
+
+        if (chunk && chunk - (address % chunk) < nbBlocks)
+            end = address + chunk - (address % chunk);
+        else
+            end = address + nbBlocks;
+
+        error = SdMmcEraseRange(pSd, address, end - 1);
+        if (error)
+            break;
+        nbBlocks -= end - address;
+        address = end;
+    }
+    return error;
+}
+
+/**
+ * Resets the SdCard structure and powers the card on.
  * \return 0 if successful; otherwise returns an \ref sdmmc_rc "error code".
  * \param pSd  Pointer to a SD card driver instance.
  * \param pSdDriver  Pointer to SD driver already initialized.
  */
-uint8_t SD_Init(SdCard *pSd, void *pSdDriver)
+static uint8_t SdInitStart(SdCard *pSd, void *pSdDriver)
 {
     uint8_t  error;
-    uint32_t clock;
     uint32_t i;
 
     /* Initialize SdCard structure */
@@ -1691,11 +2348,13 @@ uint8_t SD_Init(SdCard *pSd, void *pSdDriver)
     pSd->busMode     = 0;
     pSd->cardSlot    = 0;
     pSd->state       = SD_STATE_INIT;
+    pSd->identFlags  = 0;
 
     /* Clear CID, CSD, EXT_CSD data */
     for (i = 0; i < 4; i ++)     pSd->cid[i] = 0;
     for (i = 0; i < 4; i ++)     pSd->csd[i] = 0;
     for (i = 0; i < 512/4; i ++) pSd->extData[i] = 0;
+    for (i = 0; i < 8; i ++)     pSd->ioBlockSize[i] = 0;
 
     /* Set low speed for device identification (LS device max speed) */
     SdmmcSetSpeed(pSd, 400000);
@@ -1710,17 +2369,20 @@ uint8_t SD_Init(SdCard *pSd, void *pSdDriver)
         TRACE_ERROR("SD_Init.PowON:%d\n\r", error);
         return error;
     }
+    return 0;
+}
+
+/**
+ * Ends the SDcard initialization, once the card is identified: enumeration,
+ * block length, card size and transfer speed.
+ * \return 0 if successful; otherwise returns an \ref sdmmc_rc "error code".
+ * \param pSd  Pointer to a SD card driver instance.
+ */
+static uint8_t SdInitEnd(SdCard *pSd)
+{
+    uint8_t  error;
+    uint32_t clock;
 
-    /* After power-on or CMD0, all cards?
-     * CMD lines are in input mode, waiting for start bit of the next command.
-     * The cards are initialized with a default relative card address
-     * (RCA=0x0000) and with a default driver stage register setting
-     * (lowest speed, highest driving current capability). */
-    error = SdMmcIdentify(pSd);
-    if (error) {
-        TRACE_ERROR("SD_Init.Identify: %u\n\r", error);
-        return error;
-    }
     error = SdMmcEnum(pSd);
     if (error) {
         TRACE_ERROR("SD_Init.Enum: %u\n\r", error);
@@ -1748,6 +2410,12 @@ uint8_t SD_Init(SdCard *pSd, void *pSdDriver)
         }
     }
 
+    /* SET_BLOCK_COUNT is mandatory from MMC 3.1 on */
+    if (   (pSd->cardType & CARD_TYPE_bmSDMMC) != CARD_TYPE_bmMMC
+        || SD_CSD_SPEC_VERS(pSd) < 3) {
+        pSd->optCmdBitMap &= ~MMC_CMD23_SUPPORT;
+    }
+
     /* Reset status for R/W */
     pSd->state = SD_STATE_READY;
 
@@ -1776,13 +2444,122 @@ uint8_t SD_Init(SdCard *pSd, void *pSdDriver)
     if (pSd->cardType == CARD_UNKNOWN) {
         return SDMMC_ERROR_NOT_INITIALIZED;
     }
-    /* Automatically select the max clock */
+    /* Automatically select the max clock, lowered for memory cards until
+       the data path works */
+    if (pSd->cardType & CARD_TYPE_bmSDMMC) {
+        return SdMmcTuneSpeed(pSd);
+    }
     clock = SdmmcSetSpeed(pSd, pSd->transSpeed);
     TRACE_WARNING_WP("-I- Set SD/MMC clock to %dK\n\r", clock/1000);
     pSd->accSpeed = clock;
     return 0;
 }
 
+/**
+ * Run the SDcard initialization sequence. This function runs the
+ * initialisation procedure and the identification process, then it sets the
+ * SD card in transfer state to set the block length and the bus width.
+ * The fastest mode of the card is negotiated (4-bit bus, High-Speed timing,
+ * TRAN_SPEED clock) and lowered until a block is read without error; the
+ * mode and the block read throughput are reported on the console.
+ * \return 0 if successful; otherwise returns an \ref sdmmc_rc "error code".
+ * \param pSd  Pointer to a SD card driver instance.
+ * \param pSdDriver  Pointer to SD driver already initialized.
+ */
+uint8_t SD_Init(SdCard *pSd, void *pSdDriver)
+{
+    uint8_t error;
+
+    error = SdInitStart(pSd, pSdDriver);
+    if (error) return error;
+
+    /* After power-on or CMD0, all cards?
+     * CMD lines are in input mode, waiting for start bit of the next command.
+     * The cards are initialized with a default relative card address
+     * (RCA=0x0000) and with a default driver stage register setting
+     * (lowest speed, highest driving current capability). */
+    error = SdMmcIdentify(pSd);
+    if (error) {
+        TRACE_ERROR("SD_Init.Identify: %u\n\r", error);
+        return error;
+    }
+    return SdInitEnd(pSd);
+}
+
+/**
+ * Starts the SDcard initialization sequence of SD_Init(), without waiting
+ * for the end of the memory power up: SD_InitPoll() is then called, every
+ * ms or so, until it no longer returns SDMMC_ERROR_BUSY. Other
+ * initializations can run meanwhile, the card power up may last up to 1s.
+ * \return SDMMC_ERROR_BUSY if SD_InitPoll() is needed, 0 if the card is
+ * initialized (SDIO only card); otherwise returns an
+ * \ref sdmmc_rc "error code".
+ * \param pSd  Pointer to a SD card driver instance.
+ * \param pSdDriver  Pointer to SD driver already initialized.
+ */
+uint8_t SD_InitStart(SdCard *pSd, void *pSdDriver)
+{
+    uint8_t error;
+    uint8_t f8, io, mp;
+
+    error = SdInitStart(pSd, pSdDriver);
+    if (error) return error;
+
+    error = SdMmcIdentifyStart(pSd, &f8, &io, &mp);
+    if (!error && !mp) {
+        error = SdMmcIdentifyEnd(pSd, 0, io, 0);
+    }
+    if (error) {
+        TRACE_ERROR("SD_Init.Identify: %u\n\r", error);
+        return error;
+    }
+    if (!mp) {
+        return SdInitEnd(pSd);
+    }
+
+    pSd->identFlags = (f8 ? SD_IDENT_F8 : 0) | (io ? SD_IDENT_IO : 0);
+    pSd->state = SD_STATE_IDENT;
+    return SDMMC_ERROR_BUSY;
+}
+
+/**
+ * Polls the card power up started by SD_InitStart(), and ends the
+ * initialization sequence once the card is powered up.
+ * \return SDMMC_ERROR_BUSY while the card powers up, 0 if the card is
+ * initialized; otherwise returns an \ref sdmmc_rc "error code".
+ * \param pSd  Pointer to a SD card driver instance.
+ */
+uint8_t SD_InitPoll(SdCard *pSd)
+{
+    uint8_t error;
+    uint8_t ccs = 0;
+
+    assert( pSd != NULL ) ;
+
+    if (pSd->state != SD_STATE_IDENT) {
+        return SDMMC_ERROR_NOT_INITIALIZED;
+    }
+
+    error = Acmd41Poll(pSd, (pSd->identFlags & SD_IDENT_F8) != 0, &ccs);
+    if (error == SDMMC_ERROR_BUSY) {
+        return error;
+    }
+    pSd->state = SD_STATE_INIT;
+
+    if (error) {
+        TRACE_DEBUG("SdMmcIdentify.Acmd41: %u, try MMC\n\r", error);
+        error = MmcIdentify(pSd);
+    }
+    else {
+        error = SdMmcIdentifyEnd(pSd, 1, (pSd->identFlags & SD_IDENT_IO) != 0, ccs);
+    }
+    if (error) {
+        TRACE_ERROR("SD_Init.Identify: %u\n\r", error);
+        return error;
+    }
+    return SdInitEnd(pSd);
+}
+
 /**
  * Return type of the card.
  * \param pSd Pointer to SdCard instance.
@@ -1837,6 +2614,120 @@ uint32_t SD_GetNumberBlocks( SdCard *pSd )
     return pSd->blockNr ;
 }
 
+/**
+ * Return the erase granularity of the SD/MMC card, in blocks: one block when
+ * the SD card erases single blocks (CSD ERASE_BLK_EN), else the SD erase
+ * sector or the MMC erase group.
+ * \param pSd Pointer to SdCard instance.
+ */
+uint32_t SD_GetEraseBlocks(SdCard *pSd)
+{
+    assert( pSd != NULL ) ;
+
+    if ((pSd->cardType & CARD_TYPE_bmSDMMC) == CARD_TYPE_bmMMC)
+        return (MMC_CSD_ERASE_GRP_SIZE(pSd) + 1)
+                * (SD_CSD_ERASE_GRP_MULT(pSd) + 1);
+    if (SD_CSD_ERASE_BLK_EN(pSd))
+        return 1;
+    return SD_CSD_SECTOR_SIZE(pSd) + 1;
+}
+
+/**
+ * Return the allocation unit (AU) size of the SD card, in blocks, from the
+ * SD Status. Writes filling whole AUs are the fastest ones. Without SD Status
+ * the erase granularity is returned (see SD_GetEraseBlocks()).
+ * \param pSd Pointer to SdCard instance.
+ */
+uint32_t SD_GetAuBlocks(SdCard *pSd)
+{
+    uint32_t auSize;
+
+    assert( pSd != NULL ) ;
+
+    if (   (pSd->cardType & CARD_TYPE_bmSDMMC) == CARD_TYPE_bmSD
+        && (pSd->optCmdBitMap & SD_ACMD13_SUPPORT) ) {
+        auSize = SD_STAT_AU_SIZE(pSd);
+        if (auSize >= SD_STAT_AU_SIZE_16K && auSize <= SD_STAT_AU_SIZE_4M)
+            return (16 * 1024 / SDMMC_BLOCK_SIZE) << (auSize - 1);
+    }
+    return SD_GetEraseBlocks(pSd);
+}
+
+/**
+ * Select the MMC area used by the following accesses: the user area or one
+ * of the two boot partitions (EXT_CSD PARTITION_CONFIG). The boot enable and
+ * boot acknowledge settings are kept. While a boot partition is selected,
+ * block addresses are relative to it and range up to
+ * MMC_GetBootPartitionBlocks().
+ * \return 0 if successful; otherwise returns an \ref sdmmc_rc "error code".
+ * \param pSd       Pointer to SdCard instance.
+ * \param partition SD_EXTCSD_BOOT_PART_NO_ACCESS for the user area,
+ *                  SD_EXTCSD_BOOT_PART_RW_PART1 or SD_EXTCSD_BOOT_PART_RW_PART2.
+ */
+uint8_t MMC_SelectPartition(SdCard *pSd, uint8_t partition)
+{
+    MmcCmd6Arg cmd6Arg = {0x3, SD_EXTCSD_BOOT_CONFIG_INDEX, 0, 0};
+    uint32_t status;
+    uint8_t error;
+
+    assert( pSd != NULL ) ;
+
+    if (   (pSd->cardType & CARD_TYPE_bmSDMMC) != CARD_TYPE_bmMMC
+        || !MMC_IsVer4(pSd)
+        || (partition != SD_EXTCSD_BOOT_PART_NO_ACCESS
+            && MMC_GetBootPartitionBlocks(pSd) == 0)) {
+        return SDMMC_ERROR_NOT_SUPPORT;
+    }
+    if (partition > SD_EXTCSD_BOOT_PART_RW_PART2)
+        return SDMMC_ERROR_PARAM;
+
+    /* The switch is only accepted in transfer state */
+    error = SD_StreamClose(pSd);
+    if (error)
+        return error;
+
+    cmd6Arg.value = (SD_EXTCSD_BOOT_CONFIG(pSd)
+                        & ~SD_EXTCSD_BOOT_PARTITION_ACCESS) | partition;
+    error = MmcCmd6(pSd, &cmd6Arg, &status, NULL);
+    if (error) {
+        TRACE_ERROR("MMC_SelectPartition.Cmd6: %u\n\r", error);
+        return SDMMC_ERROR;
+    }
+
+    /* Wait end of the switch, then check it */
+    do {
+        error = Cmd13(pSd, &status);
+        if (error) {
+            TRACE_ERROR("MMC_SelectPartition.Cmd13: %u\n\r", error);
+            return error;
+        }
+    } while (   ((status & STATUS_READY_FOR_DATA) == 0)
+             || ((status & STATUS_STATE) != STATUS_TRAN) );
+    if (status & STATUS_MMC_SWITCH) {
+        TRACE_ERROR("MMC_SelectPartition: %x\n\r", status);
+        return SDMMC_ERROR;
+    }
+
+    MMC_EXTCSD(pSd)[SD_EXTCSD_BOOT_CONFIG_INDEX] = cmd6Arg.value;
+    return 0;
+}
+
+/**
+ * Return the size of each of the two MMC boot partitions, in blocks
+ * (EXT_CSD BOOT_SIZE_MULT, 128KB units), 0 if the card has none.
+ * \param pSd Pointer to SdCard instance.
+ */
+uint32_t MMC_GetBootPartitionBlocks(SdCard *pSd)
+{
+    assert( pSd != NULL ) ;
+
+    if (   (pSd->cardType & CARD_TYPE_bmSDMMC) != CARD_TYPE_bmMMC
+        || !MMC_IsVer4(pSd)) {
+        return 0;
+    }
+    return SD_EXTCSD_BOOT_SIZE_MULTI(pSd) * (128 * 1024 / SDMMC_BLOCK_SIZE);
+}
+
 /**
  * Read one or more bytes from SDIO card, using RW_DIRECT command.
  * \param pSd         Pointer to SdCard instance.
@@ -2016,6 +2907,296 @@ uint8_t SDIO_WriteBytes(SdCard *pSd,
 
 
 
+/**
+ * Set the block size of a SDIO function, used by its block mode transfers.
+ * \param pSd         Pointer to SdCard instance.
+ * \param functionNum Function number, SDIO_CIA for the common area.
+ * \param blockSize   Block size in bytes (1 ~ 2048).
+ * \return 0 if successful; otherwise returns an \ref sdmmc_rc "error code".
+ */
+uint8_t SDIO_SetBlockSize(SdCard *pSd,
+                          uint8_t functionNum,
+                          uint16_t blockSize)
+{
+    uint8_t error;
+
+    assert( pSd != NULL ) ;
+
+    if (functionNum > SDIO_FN7 || blockSize == 0 || blockSize > 2048)
+        return SDMMC_ERROR_PARAM;
+
+    error = SDIO_WriteDirect(pSd, SDIO_CIA,
+                             SDIO_FBR_ADDR(functionNum, SDIO_FBR_BLK_SIZ),
+                             blockSize & 0xFF);
+    if (!error) {
+        error = SDIO_WriteDirect(pSd, SDIO_CIA,
+                                 SDIO_FBR_ADDR(functionNum, SDIO_FBR_BLK_SIZ) + 1,
+                                 blockSize >> 8);
+    }
+    if (error) {
+        TRACE_ERROR("SDIO_SetBlkSize(%u): %u\n\r", functionNum, error);
+        return error;
+    }
+    pSd->ioBlockSize[functionNum] = blockSize;
+    return 0;
+}
+
+/**
+ * Read blocks from SDIO card, using RW_EXTENDED command in block mode.
+ * The data moves by PDC in one multi-block transfer, the block size is set
+ * with SDIO_SetBlockSize().
+ * \param pSd            Pointer to SdCard instance.
+ * \param functionNum    Function number.
+ * \param address        First byte address of data in SDIO card.
+ * \param isFixedAddress During transfer the data address is never increased.
+ * \param pData          Pointer to data buffer, word aligned for word
+ *                       transfers.
+ * \param nbBlocks       Number of blocks to read (1 ~ 511).
+ * \param fCallback      Callback function invoked when transfer finished.
+ * \param pArg           Pointer to callback argument.
+ * \return 0 if successful; otherwise returns an \ref sdmmc_rc "error code".
+ */
+uint8_t SDIO_ReadBlocks(SdCard *pSd,
+                        uint8_t functionNum,
+                        uint32_t address,
+                        uint8_t isFixedAddress,
+                        uint8_t *pData,
+                        uint16_t nbBlocks,
+                        SdmmcCallback fCallback,
+                        void* pArg)
+{
+    uint8_t  error;
+    uint32_t status;
+
+    assert( pSd != NULL ) ;
+
+    if (pSd->cardType & CARD_TYPE_bmSDIO) {
+        if (nbBlocks == 0 || nbBlocks > 511) return SDMMC_ERROR_PARAM;
+        error = Cmd53(pSd,
+                      0, functionNum, 1, !isFixedAddress,
+                      address, pData, nbBlocks,
+                      &status,
+                      fCallback, pArg);
+        if (error) {
+            TRACE_ERROR("IO_RdBlocks.Cmd53: %u\n\r", error);
+            return error;
+        }
+        else if (status & STATUS_SDIO_R5) {
+            TRACE_ERROR("RD_EXT_BLK st %x\n\r", status);
+            return SDMMC_ERROR;
+        }
+    }
+    else {
+        return SDMMC_ERROR_NOT_SUPPORT;
+    }
+    return 0;
+}
+
+/**
+ * Write blocks to SDIO card, using RW_EXTENDED command in block mode.
+ * The data moves by PDC in one multi-block transfer, the block size is set
+ * with SDIO_SetBlockSize().
+ * \param pSd            Pointer to SdCard instance.
+ * \param functionNum    Function number.
+ * \param address        First byte address of data in SDIO card.
+ * \param isFixedAddress During transfer the data address is never increased.
+ * \param pData          Pointer to data buffer, word aligned for word
+ *                       transfers.
+ * \param nbBlocks       Number of blocks to write (1 ~ 511).
+ * \param fCallback      Callback function invoked when transfer finished.
+ * \param pArg           Pointer to callback argument.
+ * \return 0 if successful; otherwise returns an \ref sdmmc_rc "error code".
+ */
+uint8_t SDIO_WriteBlocks(SdCard *pSd,
+                         uint8_t functionNum,
+                         uint32_t address,
+                         uint8_t isFixedAddress,
+                         uint8_t *pData,
+                         uint16_t nbBlocks,
+                         SdmmcCallback fCallback,
+                         void* pArg)
+{
+    uint8_t  error;
+    uint32_t status;
+
+    assert( pSd != NULL ) ;
+
+    if (pSd->cardType & CARD_TYPE_bmSDIO) {
+        if (nbBlocks == 0 || nbBlocks > 511) return SDMMC_ERROR_PARAM;
+        error = Cmd53(pSd,
+                      1, functionNum, 1, !isFixedAddress,
+                      address, pData, nbBlocks,
+                      &status,
+                      fCallback, pArg);
+        if (error) {
+            TRACE_ERROR("IO_WrBlocks.Cmd53: %u\n\r", error);
+            return error;
+        }
+        else if (status & STATUS_SDIO_R5) {
+            TRACE_ERROR("WR_EXT_BLK st %x\n\r", status);
+            return SDMMC_ERROR;
+        }
+    }
+    else {
+        return SDMMC_ERROR_NOT_SUPPORT;
+    }
+    return 0;
+}
+
+/**
+ * SDIO interrupt detected on DAT1 (interrupt context): leave the card
+ * access to SDIO_ServiceIrq().
+ */
+static void SdioIrqDetected(void *pArg)
+{
+    sdioIrqPending = 1;
+}
+
+/**
+ * Register the driver of a SDIO function: enable the function, set its
+ * block size and, with an interrupt handler, enable its interrupt on the
+ * card and the SDIO interrupt detection of the host.
+ * \param pSd         Pointer to SdCard instance.
+ * \param functionNum Function number (1 ~ 7).
+ * \param blockSize   Block size of the function, 0 to keep the current one.
+ * \param fHandler    Interrupt handler of the function, or NULL.
+ * \param pArg        Handler argument.
+ * \return 0 if successful; otherwise returns an \ref sdmmc_rc "error code".
+ */
+uint8_t SDIO_RegisterFunction(SdCard *pSd,
+                              uint8_t functionNum,
+                              uint16_t blockSize,
+                              SdioIrqHandler fHandler,
+                              void *pArg)
+{
+    uint8_t  error;
+    uint8_t  reg;
+    uint32_t retry;
+
+    assert( pSd != NULL ) ;
+
+    if (functionNum < SDIO_FN1 || functionNum > SDIO_FN7)
+        return SDMMC_ERROR_PARAM;
+    if ((pSd->cardType & CARD_TYPE_bmSDIO) == 0)
+        return SDMMC_ERROR_NOT_SUPPORT;
+
+    /* Enable the function and wait until it is ready */
+    error = SDIO_ReadDirect(pSd, SDIO_CIA, SDIO_IOE_REG, &reg, 1);
+    if (!error) {
+        error = SDIO_WriteDirect(pSd, SDIO_CIA, SDIO_IOE_REG,
+                                 reg | (1 << functionNum));
+    }
+    for (retry = 0; !error && retry < SDIO_IOR_RETRY; retry ++) {
+        error = SDIO_ReadDirect(pSd, SDIO_CIA, SDIO_IOR_REG, &reg, 1);
+        if (reg & (1 << functionNum)) break;
+    }
+    if (error) return error;
+    if (retry == SDIO_IOR_RETRY) {
+        TRACE_ERROR("SDIO_RegFunc: FN%u not ready\n\r", functionNum);
+        return SDMMC_ERROR_BUSY;
+    }
+
+    if (blockSize) {
+        error = SDIO_SetBlockSize(pSd, functionNum, blockSize);
+        if (error) return error;
+    }
+
+    sdioFunctions[functionNum].pArg = pArg;
+    sdioFunctions[functionNum].fHandler = fHandler;
+    if (fHandler) {
+        /* Function and master interrupt enable */
+        error = SDIO_ReadDirect(pSd, SDIO_CIA, SDIO_IEN_REG, &reg, 1);
+        if (!error) {
+            error = SDIO_WriteDirect(pSd, SDIO_CIA, SDIO_IEN_REG,
+                                     reg | SDIO_IENM | (1 << functionNum));
+        }
+        if (error) {
+            sdioFunctions[functionNum].fHandler = NULL;
+            return error;
+        }
+        SdmmcEnableSdioIrq(pSd, SdioIrqDetected, pSd);
+    }
+    return 0;
+}
+
+/**
+ * Unregister the driver of a SDIO function: disable its interrupt and the
+ * function. The host interrupt detection stops with the last handler.
+ * \param pSd         Pointer to SdCard instance.
+ * \param functionNum Function number (1 ~ 7).
+ * \return 0 if successful; otherwise returns an \ref sdmmc_rc "error code".
+ */
+uint8_t SDIO_UnregisterFunction(SdCard *pSd, uint8_t functionNum)
+{
+    uint8_t error;
+    uint8_t reg;
+    uint8_t i;
+
+    assert( pSd != NULL ) ;
+
+    if (functionNum < SDIO_FN1 || functionNum > SDIO_FN7)
+        return SDMMC_ERROR_PARAM;
+
+    sdioFunctions[functionNum].fHandler = NULL;
+    for (i = SDIO_FN1; i <= SDIO_FN7; i ++) {
+        if (sdioFunctions[i].fHandler) break;
+    }
+    if (i > SDIO_FN7) {
+        SdmmcEnableSdioIrq(pSd, NULL, NULL);
+        sdioIrqPending = 0;
+    }
+
+    error = SDIO_ReadDirect(pSd, SDIO_CIA, SDIO_IEN_REG, &reg, 1);
+    if (!error) {
+        reg &= ~(1 << functionNum);
+        /* No function interrupt left, clear the master enable */
+        if ((reg & SDIO_IEN) == 0) reg = 0;
+        error = SDIO_WriteDirect(pSd, SDIO_CIA, SDIO_IEN_REG, reg);
+    }
+    if (!error) {
+        error = SDIO_ReadDirect(pSd, SDIO_CIA, SDIO_IOE_REG, &reg, 1);
+    }
+    if (!error) {
+        error = SDIO_WriteDirect(pSd, SDIO_CIA, SDIO_IOE_REG,
+                                 reg & ~(1 << functionNum));
+    }
+    pSd->ioBlockSize[functionNum] = 0;
+    return error;
+}
+
+/**
+ * Serve the SDIO interrupts, out of interrupt context (main loop or task):
+ * when the card interrupt has been detected, read the pending functions,
+ * invoke their handlers, then re-arm the detection. The handlers may access
+ * the card and shall clear their interrupt source.
+ * \param pSd Pointer to SdCard instance.
+ * \return 0 if successful; otherwise returns an \ref sdmmc_rc "error code".
+ */
+uint8_t SDIO_ServiceIrq(SdCard *pSd)
+{
+    uint8_t error;
+    uint8_t pending = 0;
+    uint8_t i;
+
+    assert( pSd != NULL ) ;
+
+    if (sdioIrqPending == 0) return 0;
+    sdioIrqPending = 0;
+
+    error = SDIO_ReadDirect(pSd, SDIO_CIA, SDIO_INT_REG, &pending, 1);
+    if (!error) {
+        for (i = SDIO_FN1; i <= SDIO_FN7; i ++) {
+            if ((pending & (1 << i)) && sdioFunctions[i].fHandler) {
+                sdioFunctions[i].fHandler(pSd, i, sdioFunctions[i].pArg);
+            }
+        }
+    }
+
+    /* The card keeps DAT1 low while an interrupt source is pending */
+    SdmmcEnableSdioIrq(pSd, SdioIrqDetected, pSd);
+    return error;
+}
+
 /**
  * Display SDIO card informations (CIS, tuple ...)
  * \param pSd Pointer to SdCard instance.
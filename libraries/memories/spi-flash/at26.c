@@ -122,6 +122,17 @@ void AT26_Configure(At26 *pAt26, Spid *pSpid, unsigned char cs)
     pCommand->callback = 0;
     pCommand->pArgument = 0;
     pCommand->spiCs = cs;    
+
+    // Initialize the write enable command
+    pAt26->writeEnableCmd = AT26_WRITE_ENABLE;
+    pCommand = &(pAt26->writeEnable);
+    pCommand->pCmd = &(pAt26->writeEnableCmd);
+    pCommand->cmdSize = 1;
+    pCommand->pData = 0;
+    pCommand->dataSize = 0;
+    pCommand->callback = 0;
+    pCommand->pArgument = 0;
+    pCommand->spiCs = cs;
 }
 
 //------------------------------------------------------------------------------
@@ -196,6 +207,62 @@ unsigned char AT26_SendCommand(
      return 0;
 }
 
+//------------------------------------------------------------------------------
+/// Sends a program or erase command to the serial flash, preceded by the write
+/// enable command it needs. Both commands are put in the SPI driver queue at
+/// once, so the second one starts as soon as the first one completes, without
+/// software turnaround. As AT26_SendCommand(), this function does not block;
+/// the end of the command is signaled by AT26_IsBusy().
+/// Return 0 if successful; otherwise, returns AT26_ERROR_BUSY if the AT26
+/// driver is currently executing a command, or AT26_ERROR_SPI if the command
+/// cannot be sent because of a SPI error.
+/// \param pAt26  Pointer to an At26 driver instance.
+/// \param cmd  Command byte.
+/// \param cmdSize  Size of command (command byte + address bytes + dummy bytes).
+/// \param pData Data buffer.
+/// \param dataSize  Number of bytes to send.
+/// \param address  Address to transmit.
+//------------------------------------------------------------------------------
+unsigned char AT26_SendWriteCommand(
+    At26 *pAt26,
+    unsigned char cmd,
+    unsigned char cmdSize,
+    unsigned char *pData,
+    unsigned int dataSize,
+    unsigned int address)
+{
+    SpidCmd *pCommand;
+
+    assert(pAt26 != NULL);
+    // Check if the SPI driver is available
+    if (AT26_IsBusy(pAt26)) {
+
+        return AT26_ERROR_BUSY;
+    }
+
+    // Store command and address in command buffer
+    pAt26->pCmdBuffer[0] = (cmd & 0x000000FF)
+                           | ((address & 0x0000FF) << 24)
+                           | ((address & 0x00FF00) << 8)
+                           | ((address & 0xFF0000) >> 8);
+    // Update the SPI transfer descriptor
+    pCommand = &(pAt26->command);
+    pCommand->cmdSize = cmdSize;
+    pCommand->pData = pData;
+    pCommand->dataSize = dataSize;
+    pCommand->callback = 0;
+    pCommand->pArgument = 0;
+
+    // Queue the write enable then the command
+    if (SPID_QueueCommand(pAt26->pSpid, &(pAt26->writeEnable))
+        || SPID_QueueCommand(pAt26->pSpid, pCommand)) {
+
+        return AT26_ERROR_SPI;
+    }
+
+    return 0;
+}
+
 //------------------------------------------------------------------------------
 /// Tries to detect a serial firmware flash device given its JEDEC identifier.
 /// The JEDEC id can be retrieved by sending the correct command to the device.
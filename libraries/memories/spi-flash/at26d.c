@@ -37,6 +37,20 @@
 #include <math.h>
 #include <assert.h>
 
+//------------------------------------------------------------------------------
+//         Local definitions
+//------------------------------------------------------------------------------
+
+/// Largest data transfer of one command, the PDC counters being 16-bit.
+#define AT26D_MAX_TRANSFER          0xFFFF
+
+/// JEDEC manufacturer codes, in the low byte of the JEDEC ID.
+#define AT26D_JEDEC_ATMEL           0x1F
+#define AT26D_JEDEC_ST              0x20
+
+/// Maximum number of erase sizes supported by a device.
+#define AT26D_MAX_ERASE_TYPES       3
+
 //------------------------------------------------------------------------------
 //         Local functions
 //------------------------------------------------------------------------------
@@ -94,24 +108,71 @@ static void AT26D_WriteStatus(At26 *pAt26, unsigned char status)
 
 
 //------------------------------------------------------------------------------
-//         Global functions
+/// Polls the status register until the device is ready, and returns the last
+/// status read, so that the result of the operation can be checked without an
+/// additional status read.
+/// \param pAt26  Pointer to an AT26 driver instance.
 //------------------------------------------------------------------------------
+static unsigned char AT26D_WaitStatus(At26 *pAt26)
+{
+    unsigned char status;
+
+    assert(pAt26 != NULL);
+
+    // Read status register and check busy bit
+    do {
+
+        status = AT26D_ReadStatus(pAt26);
+    }
+    while ((status & AT26_STATUS_RDYBSY) != AT26_STATUS_RDYBSY_READY);
+
+    return status;
+}
 
 //------------------------------------------------------------------------------
-/// Waits for the serial flash device to become ready to accept new commands.
+/// Lists the erase sizes of the device, in increasing order, with their command
+/// codes, and returns their number. The 4K sector erase is available on all the
+/// recognized parts but the ST ones, the 32K block erase on the Atmel parts
+/// with 64K blocks; the block erase of the device descriptor is always there.
 /// \param pAt26  Pointer to an AT26 driver instance.
+/// \param pSizes  Erase sizes in bytes.
+/// \param pCmds  Erase command codes.
 //------------------------------------------------------------------------------
-void AT26D_WaitReady(At26 *pAt26)
+static unsigned int AT26D_GetEraseTypes(
+    At26 *pAt26,
+    unsigned int *pSizes,
+    unsigned char *pCmds)
 {
-    unsigned char ready = 0;
+    unsigned int manufacturer = pAt26->pDesc->jedecId & 0xFF;
+    unsigned int count = 0;
 
-    assert(pAt26 != NULL);
+    if ((manufacturer != AT26D_JEDEC_ST) && (AT26_BlockSize(pAt26) > 4 * 1024)) {
 
-    // Read status register and check busy bit
-    while (!ready) {
+        pSizes[count] = 4 * 1024;
+        pCmds[count++] = AT26_BLOCK_ERASE_4K;
+    }
+    if ((manufacturer == AT26D_JEDEC_ATMEL) && (AT26_BlockSize(pAt26) > 32 * 1024)) {
 
-        ready = ((AT26D_ReadStatus(pAt26) & AT26_STATUS_RDYBSY) == AT26_STATUS_RDYBSY_READY);
+        pSizes[count] = 32 * 1024;
+        pCmds[count++] = AT26_BLOCK_ERASE_32K;
     }
+    pSizes[count] = AT26_BlockSize(pAt26);
+    pCmds[count++] = AT26_BlockEraseCmd(pAt26);
+
+    return count;
+}
+
+//------------------------------------------------------------------------------
+//         Global functions
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+/// Waits for the serial flash device to become ready to accept new commands.
+/// \param pAt26  Pointer to an AT26 driver instance.
+//------------------------------------------------------------------------------
+void AT26D_WaitReady(At26 *pAt26)
+{
+    AT26D_WaitStatus(pAt26);
 }
 
 //------------------------------------------------------------------------------
@@ -216,11 +277,8 @@ unsigned char AT26D_EraseChip(At26 *pAt26)
         return AT26_ERROR_PROTECTED;
     }
     
-    // Enable critical write operation
-    AT26D_EnableWrite(pAt26);
-    
-    // Erase the chip
-    error = AT26_SendCommand(pAt26, AT26_CHIP_ERASE_2, 1, 0, 0, 0, 0, 0);
+    // Enable critical write operation and erase the chip
+    error = AT26_SendWriteCommand(pAt26, AT26_CHIP_ERASE_2, 1, 0, 0, 0);
     assert(!error); //, "-F- AT26_ChipErase: Could not issue command.\n\r");
     // Wait for transfer to finish
     AT26D_Wait(pAt26);
@@ -255,11 +313,8 @@ unsigned char AT26D_EraseBlock(At26 *pAt26, unsigned int address)
         return AT26_ERROR_PROTECTED;
     }
 
-    // Enable critical write operation
-      AT26D_EnableWrite(pAt26);
-
-    // Start the block erase command
-    error = AT26_SendCommand(pAt26, AT26_BlockEraseCmd(pAt26), 4, 0, 0, address, 0, 0);
+    // Enable critical write operation and start the block erase command
+    error = AT26_SendWriteCommand(pAt26, AT26_BlockEraseCmd(pAt26), 4, 0, 0, address);
     assert(!error); //, "-F- AT26_EraseBlock: Could not issue command.\n\r");
     // Wait for transfer to finish
     AT26D_Wait(pAt26);
@@ -269,6 +324,75 @@ unsigned char AT26D_EraseBlock(At26 *pAt26, unsigned int address)
     return 0;
 }
 
+//------------------------------------------------------------------------------
+/// Erases a range of the serial flash with the fewest erase operations: each
+/// step uses the largest erase size of the device (see AT26D_GetEraseTypes())
+/// aligned on the current address and fitting in the rest of the range, and a
+/// range covering the whole device uses the chip erase.
+/// Returns 0 if successful; otherwise returns AT26_ERROR_ALIGNMENT if the range
+/// is not aligned on the smallest erase size, AT26_ERROR_PROTECTED if the
+/// device is protected or AT26_ERROR_BUSY if it is busy executing a command.
+/// \param pAt26  Pointer to an AT26 driver instance.
+/// \param address  Start address of the range.
+/// \param size  Size of the range in bytes.
+//------------------------------------------------------------------------------
+unsigned char AT26D_EraseRange(At26 *pAt26, unsigned int address, unsigned int size)
+{
+    unsigned int sizes[AT26D_MAX_ERASE_TYPES];
+    unsigned char cmds[AT26D_MAX_ERASE_TYPES];
+    unsigned int count;
+    unsigned int i;
+    unsigned char status;
+    unsigned char error;
+
+    assert(pAt26 != NULL);
+
+    count = AT26D_GetEraseTypes(pAt26, sizes, cmds);
+    if (((address % sizes[0]) != 0) || ((size % sizes[0]) != 0)) {
+
+        TRACE_ERROR("AT26D_EraseRange : Range not aligned\n\r");
+        return AT26_ERROR_ALIGNMENT;
+    }
+
+    if ((address == 0) && (size >= AT26_Size(pAt26))) {
+
+        return AT26D_EraseChip(pAt26);
+    }
+
+    // Check that the flash is ready and unprotected
+    status = AT26D_ReadStatus(pAt26);
+    if ((status & AT26_STATUS_RDYBSY) != AT26_STATUS_RDYBSY_READY) {
+        TRACE_ERROR("AT26D_EraseRange : Flash busy\n\r");
+        return AT26_ERROR_BUSY;
+    }
+    else if ((status & AT26_STATUS_SWP) != AT26_STATUS_SWP_PROTNONE) {
+        TRACE_ERROR("AT26D_EraseRange : Flash protected\n\r");
+        return AT26_ERROR_PROTECTED;
+    }
+
+    while (size > 0) {
+
+        // Largest erase aligned on the address and fitting in the range
+        i = count - 1;
+        while ((i > 0) && (((address % sizes[i]) != 0) || (size < sizes[i]))) {
+
+            i--;
+        }
+
+        error = AT26_SendWriteCommand(pAt26, cmds[i], 4, 0, 0, address);
+        assert(!error); //, "-F- AT26_EraseRange: Could not issue command.\n\r");
+        // Wait for transfer to finish
+        AT26D_Wait(pAt26);
+        // Poll the Serial flash status register until the operation is achieved
+        AT26D_WaitReady(pAt26);
+
+        address += sizes[i];
+        size -= sizes[i];
+    }
+
+    return 0;
+}
+
 //------------------------------------------------------------------------------
 /// Writes data at the specified address on the serial firmware dataflash. The
 /// page(s) to program must have been erased prior to writing. This function
@@ -302,20 +426,16 @@ unsigned char AT26D_Write(
         // Compute number of bytes to program in page
         writeSize = min(size, pageSize - (address % pageSize));
 
-        // Enable critical write operation
-        AT26D_EnableWrite(pAt26);
-     
-         // Program page
-          error = AT26_SendCommand(pAt26, AT26_BYTE_PAGE_PROGRAM, 4,
-                           pData, writeSize, address, 0, 0);
+        // Enable critical write operation and program page, the write
+        // enable and the page program being queued together
+        error = AT26_SendWriteCommand(pAt26, AT26_BYTE_PAGE_PROGRAM, 4,
+                                      pData, writeSize, address);
         assert(!error); //, "-F- AT26_WritePage: Failed to issue command.\n\r");
         // Wait for transfer to finish
         AT26D_Wait(pAt26);
-        // Poll the Serial flash status register until the operation is achieved
-        AT26D_WaitReady(pAt26);
-
-        // Make sure that write was without error
-        status = AT26D_ReadStatus(pAt26);
+        // Poll the Serial flash status register until the operation is
+        // achieved, and make sure that write was without error
+        status = AT26D_WaitStatus(pAt26);
         if ((status & AT26_STATUS_EPE) == AT26_STATUS_EPE_ERROR) {
 
             return AT26_ERROR_PROGRAM;
@@ -341,13 +461,59 @@ unsigned char AT26D_Read(
     unsigned int size,
     unsigned int address)
 {
-    unsigned char error;
-    
-     // Start a read operation
-      error = AT26_SendCommand(pAt26, AT26_READ_ARRAY_LF, 4, pData, size, address, 0, 0);
-    assert(!error); //, "-F- AT26_Read: Could not issue command.\n\r");
-    // Wait for transfer to finish
-    AT26D_Wait(pAt26);
-    
+    unsigned int readSize;
+    unsigned char error = 0;
+
+    while (size > 0) {
+
+        readSize = min(size, AT26D_MAX_TRANSFER);
+
+        // Start a read operation
+        error = AT26_SendCommand(pAt26, AT26_READ_ARRAY_LF, 4, pData, readSize, address, 0, 0);
+        assert(!error); //, "-F- AT26_Read: Could not issue command.\n\r");
+        // Wait for transfer to finish
+        AT26D_Wait(pAt26);
+
+        pData += readSize;
+        size -= readSize;
+        address += readSize;
+    }
+
+    return error;
+}
+
+//------------------------------------------------------------------------------
+/// Reads data from the specified address on the serial flash with the read
+/// array command followed by a dummy byte, which runs at the full SPI clock
+/// rate of the device while AT26D_Read() is limited to the low frequency one.
+/// \param pAt26  Pointer to an AT26 driver instance.
+/// \param pData  Data buffer.
+/// \param size  Number of bytes to read.
+/// \param address  Read address.
+//------------------------------------------------------------------------------
+unsigned char AT26D_ReadFast(
+    At26 *pAt26,
+    unsigned char *pData,
+    unsigned int size,
+    unsigned int address)
+{
+    unsigned int readSize;
+    unsigned char error = 0;
+
+    while (size > 0) {
+
+        readSize = min(size, AT26D_MAX_TRANSFER);
+
+        // Command, address and dummy byte
+        error = AT26_SendCommand(pAt26, AT26_READ_ARRAY, 5, pData, readSize, address, 0, 0);
+        assert(!error); //, "-F- AT26_ReadFast: Could not issue command.\n\r");
+        // Wait for transfer to finish
+        AT26D_Wait(pAt26);
+
+        pData += readSize;
+        size -= readSize;
+        address += readSize;
+    }
+
     return error;
 }
@@ -154,6 +154,16 @@ extern OS_TCID     CoCreateTmr(U8 tmrType, U32 tmrCnt, U32 tmrReload, vFUNCPtr f
 /* Implement in file "kernelHeap.c"*/
 extern void*       CoKmalloc(U32 size);
 extern void        CoKfree(void* memBuf);
+#if CFG_KHEAP_TLSF_EN > 0
+struct _TlsfStats;
+extern void        CoGetKheapStats(struct _TlsfStats* pStats);
+#endif
+
+
+/* Implement in file "serviceReq.c"*/
+#if CFG_MAX_SERVICE_REQUEST > 0
+extern void        CoGetServiceReqStats(U32* pOverflow,U32* pPeak);
+#endif
 
 
 /* Implement in file "mm.c"        */
@@ -50,15 +50,23 @@ systick frequency (Hz).
 #define CFG_SYSTICK_FREQ        (100) 		
 
 /*!< 
-max systerm api call num in ISR.	                         
+max systerm api call num in ISR,pending at once before they are responded.
+Must be 0 (no isr_ post functions) or a power of two.
 */
-#define CFG_MAX_SERVICE_REQUEST (3) 
+#define CFG_MAX_SERVICE_REQUEST (16) 
+
+/*!< 
+Enable(1) or disable(0) bitmap schedule.
+If enable(1),the READY tasks are kept in one list per priority and the highest
+ready priority is found with CLZ, in a time independent of the task number.
+*/
+#define CFG_BITMAP_SCHEDULE_EN  (1)
 
 /*!< 
 Enable(1) or disable(0) order list schedule.
 If disable(0),CoOS use Binary-Scheduling Algorithm. 
 */
-#if (CFG_MAX_USER_TASKS) <15
+#if (CFG_BITMAP_SCHEDULE_EN > 0) || ((CFG_MAX_USER_TASKS) <15)
 #define CFG_ORDER_LIST_SCHEDULE_EN  (1)
 #else 
 #define CFG_ORDER_LIST_SCHEDULE_EN  (0)
@@ -124,6 +132,23 @@ Enable(1) or disable(0) stack overflow checkout .
 */		
 #define CFG_STK_CHECKOUT_EN     (1)		
 
+/*!< 
+Enable(1) or disable(0) MPU stack guard (Cortex-M3,needs stack checkout).
+If enable(1),a 32 byte no access MPU region is set at the bottom of the stack
+of the task switched in,instead of checking the stack at each switch.The first
+access past the stack faults at once,and MemManage_Handler() reports the task
+to CoStkOverflowHook(),which may record it with WDT_SupervisorFault().
+*/
+#define CFG_STK_GUARD_EN        (0)
+
+/*!< 
+Enable(1) or disable(0) task profiler.
+If enable(1),the CPU time and the number of switches of each task are counted
+by libraries/rtos/taskprof,and with stack checkout the unused stack is painted
+to measure its margin.TASKPROF_Initialize() must be called before CoInitOS().
+*/
+#define CFG_TASK_PROFILE_EN     (0)
+
 
 
 /*---------------------- Memory Management Config ----------------------------*/
@@ -154,6 +179,17 @@ Kernel heap size(word).
 #define KHEAP_SIZE              (50)			
 #endif   
 
+/*!< 
+Enable(1) or disable(0) the TLSF kernel heap.
+If enable(1),CoKmalloc() and CoKfree() run in constant time with the TLSF
+allocator of libraries/rtos/tlsf (add tlsf.c to the project),and 
+CoGetKheapStats() gives the heap usage.If disable(0),the heap is a first-fit
+list.
+*/
+#if CFG_KHEAP_EN >0
+#define CFG_KHEAP_TLSF_EN       (1)
+#endif
+
 
 		
 /*---------------------- Time Management Config -----------------------------*/
@@ -164,6 +200,13 @@ Enable(1) or disable(0) TimeDelay() API.
 #define CFG_TIME_DELAY_EN       (1)	
 #endif
 
+/*!< 
+Number of slots of the timing wheels of the delayed tasks and of the timers
+(power of 2). A delay or a timer is inserted and removed in constant time, and
+a tick only visits the delays and timers of its slot.
+*/
+#define CFG_TICK_WHEEL_SIZE     (32)
+
 
 /*---------------------- Timer Management Config ----------------------------*/
 /*!< 
@@ -172,10 +215,10 @@ Enable(1) or disable(0) timer management.
 #define CFG_TMR_EN              (1)		
 
 /*!< 
-Specify max number timer.(must be less than 32)      
+Specify max number timer.(must be less than 255)      
 */	
 #if CFG_TMR_EN >0
-#define CFG_MAX_TMR             (2)			
+#define CFG_MAX_TMR             (32)			
 #endif
 
 
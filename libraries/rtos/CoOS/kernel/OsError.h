@@ -42,11 +42,21 @@
 #endif
 
 #if CFG_TMR_EN > 0
-    #if CFG_MAX_TMR > 32
-    #error " OsConfig.h, CFG_MAX_TMR must be <= 32! "
+    #if CFG_MAX_TMR > 254
+    #error " OsConfig.h, CFG_MAX_TMR must be <= 254! "
     #endif
 #endif
 
+#if CFG_STK_GUARD_EN > 0
+    #if (CFG_STK_CHECKOUT_EN == 0) || (CFG_CHIP_TYPE != 1)
+    #error " OsConfig.h, CFG_STK_GUARD_EN needs CFG_STK_CHECKOUT_EN and a Cortex-M3! "
+    #endif
+#endif
+
+#if (CFG_TICK_WHEEL_SIZE & (CFG_TICK_WHEEL_SIZE - 1)) != 0
+    #error " OsConfig.h, CFG_TICK_WHEEL_SIZE must be a power of 2! "
+#endif
+
 
 #if CFG_MM_EN > 0
     #if CFG_MAX_MM > 32
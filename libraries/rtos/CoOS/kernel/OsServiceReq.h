@@ -26,19 +26,31 @@
 #define   FLAG_REQ      (U8)0x3
 #define   QUEUE_REQ     (U8)0x4
 
+#if (CFG_MAX_SERVICE_REQUEST & (CFG_MAX_SERVICE_REQUEST - 1)) != 0
+#error "CFG_MAX_SERVICE_REQUEST must be a power of two"
+#endif
+#define   SRQ_MASK      (CFG_MAX_SERVICE_REQUEST - 1)
+
 
 typedef struct ServiceReqCell
 {
-    U8      type;
-    U8      id;
-    void*   arg;
+    U8          type;
+    U8          id;
+    volatile U8 ready;                  /*!< Cell filled,not yet responded    */
+    void*       arg;
 }SQC,*P_SQC;
 
+/*!< 
+Ring of requests posted by ISRs: ISRs claim cells at tail,RespondSRQ() 
+releases them at head.Both counters run free and are masked on access.
+*/
 typedef struct ServiceReqQueue
 {
-    U8    cnt;
-    U8    head;    
-    SQC   cell[CFG_MAX_SERVICE_REQUEST];
+    volatile U32  tail;                 /*!< Next cell claimed by an ISR      */
+    volatile U32  head;                 /*!< Next cell to respond             */
+    volatile U32  overflow;             /*!< Requests lost on a full ring     */
+    volatile U32  peak;                 /*!< Most requests pending at once    */
+    SQC           cell[CFG_MAX_SERVICE_REQUEST];
 }SRQ,*P_SRQ;
 
 
@@ -42,6 +42,9 @@ typedef  struct TCB
     U8          prio;                   /*!< Task priority.                   */
     U8          state;                  /*!< TaSk status.                     */
     OS_TID      taskID;                 /*!< Task ID.                         */
+#if CFG_BITMAP_SCHEDULE_EN > 0
+    U8          rdyPrio;                /*!< Priority list of a READY task.   */
+#endif
 
 #if CFG_MUTEX_EN > 0
     OS_MutexID  mutexID;                /*!< Mutex ID.                        */
@@ -77,6 +80,7 @@ typedef  struct TCB
 
 #if CFG_TASK_WAITTING_EN >0
     U32         delayTick;              /*!< The number of ticks which delay. */
+    U32         delayExpire;            /*!< The tick when the delay expires. */
 #endif    
     struct TCB  *TCBnext;               /*!< The pointer to next TCB.         */
     struct TCB  *TCBprev;               /*!< The pointer to prev TCB.         */
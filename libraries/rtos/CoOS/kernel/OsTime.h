@@ -17,8 +17,11 @@
 #ifndef _TIME_H
 #define _TIME_H
 
+#define  TICK_WHEEL_MASK  (CFG_TICK_WHEEL_SIZE - 1) /*!< Slot of a tick.    */
+
 /*---------------------------- Variable declare ------------------------------*/
-extern P_OSTCB  DlyList;            /*!< A pointer to ther delay list.        */
+extern P_OSTCB  DlyWheel[];         /*!< Slots of the delay wheel.            */
+extern U32      DlyDoneTick;        /*!< Last tick whose delays are disposed. */
 
 /*---------------------------- Function declare ------------------------------*/
 extern void  TimeDispose(void);     /*!< Time dispose function.               */
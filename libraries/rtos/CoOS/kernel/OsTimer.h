@@ -32,7 +32,9 @@ typedef struct tmrCtrl                  /* Timer Control Block Define.        */
     OS_TCID          tmrID;             /*!< Timer ID.                        */
     U8               tmrType;           /*!< Timer Type.                      */
     U8               tmrState;          /*!< Timer State.                     */
+    BOOL             tmrLinked;         /*!< Timer is in the timer wheel.     */
     U32              tmrCnt;            /*!< Timer Counter.                   */
+    U32              tmrExpire;         /*!< Tick when the timer expires.     */
     U32              tmrReload;         /*!< Timer Reload Counter Value.      */	
     vFUNCPtr         tmrCallBack; /*!< Call-back Function When Timer overrun. */	
     struct tmrCtrl*  tmrNext;       /*!< Point to Next Timer Control Block.   */
@@ -41,8 +43,9 @@ typedef struct tmrCtrl                  /* Timer Control Block Define.        */
 }TmrCtrl,*P_TmrCtrl;
 
 /*---------------------------- Variable declare ------------------------------*/
-extern P_TmrCtrl  TmrList;              /*!< A pointer to the timer list.     */ 
-extern U32        TmrIDVessel;
+extern P_TmrCtrl  TmrWheel[];           /*!< Slots of the timer wheel.        */ 
+extern U32        TmrDoneTick;          /*!< Last tick whose timers are done. */
+extern U32        TmrIDVessel[];
 /*---------------------------- Function declare ------------------------------*/
 extern void  TmrDispose(void);          /*!< Timer counter function.          */
 extern void  isr_TmrDispose(void);
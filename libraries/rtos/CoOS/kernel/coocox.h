@@ -34,6 +34,9 @@
 #endif
 
 #if CFG_KHEAP_EN > 0
+	#if CFG_KHEAP_TLSF_EN > 0
+		#include "../../tlsf/tlsf.h"
+	#endif
 	#include "OsKernelHeap.h"
 #endif
 
@@ -57,4 +60,8 @@
 	#include "OsFlag.h"
 #endif
 
+#if CFG_TASK_PROFILE_EN > 0
+	#include "../../taskprof/taskprof.h"
+#endif
+
 #endif    /* _COOCOX_H    */  
@@ -214,6 +214,13 @@ void CoStartOS(void)
     TCBNext     = TCBRunning;           /* Set next scheduled task as running task */
     TCBRunning->state = TASK_RUNNING;   /* Set running task status to RUNNING   */
     RemoveFromTCBRdyList(TCBRunning);   /* Remove running task from READY list  */
+#if CFG_STK_GUARD_EN >0
+    SetStkGuard(TCBRunning->stack);     /* Guard the stack of the first task    */
+    InitStkGuard();
+#endif
+#if CFG_TASK_PROFILE_EN >0
+    TASKPROF_SwitchTo(TCBRunning);      /* Start profiling the first task       */
+#endif
     OsSchedUnlock();					/* Enable Schedule,call task schedule   */
 }
 
@@ -19,6 +19,118 @@
 
 
 #if CFG_KHEAP_EN >0
+#if CFG_KHEAP_TLSF_EN >0
+/*---------------------------- Variable Define -------------------------------*/
+U32     KernelHeap[KHEAP_SIZE] = {0};   /*!< Kernel heap                      */
+Tlsf    KheapTlsf;                      /*!< TLSF control of kernel heap      */
+KHeap   Kheap   = {0};                  /*!< Kernel heap control              */
+
+
+/**
+ *******************************************************************************
+ * @brief      Create kernel heap	 
+ * @param[in]  None
+ * @param[out] None
+ * @retval     None			 
+ *
+ * @par Description
+ * @details    This function is called to create kernel heap,as one TLSF pool.
+ *******************************************************************************
+ */
+void CoCreateKheap(void)
+{
+    Kheap.startAddr  = (U32)(KernelHeap); /* Initialize kernel heap control   */
+    Kheap.endAddr    = (U32)(KernelHeap) + KHEAP_SIZE*4;
+    TLSF_Initialize(&KheapTlsf,KernelHeap,KHEAP_SIZE*4);
+}
+
+
+/**
+ *******************************************************************************
+ * @brief      Allocation size bytes of memory block from kernel heap.
+ * @param[in]  size     Length of menory block.	
+ * @param[out] None
+ * @retval     NULL     Allocate fail.
+ * @retval     others   Pointer to memory block.		 
+ *
+ * @par Description
+ * @details    This function is called to allocation size bytes of memory block,
+ *             in a time which does not depend on the heap fragmentation.
+ *******************************************************************************
+ */
+void* CoKmalloc(U32 size)
+{
+    void* memAddr;
+    
+#if CFG_PAR_CHECKOUT_EN >0              /* Check validity of parameter        */
+    if( size == 0 )
+    {
+        return NULL;
+    }
+#endif
+
+    OsSchedLock();                      /* Lock schedule                      */
+    memAddr = TLSF_Alloc(&KheapTlsf,size);
+    OsSchedUnlock();                    /* Unlock schedule                    */
+    return memAddr;
+}
+
+
+/**
+ *******************************************************************************
+ * @brief      Release memory block to kernel heap.  
+ * @param[in]  memBuf    Pointer to memory block.
+ * @param[out] None
+ * @retval     None  		 
+ *
+ * @par Description
+ * @details    This function is called to release memory block,merging it with
+ *             the free blocks next to it.
+ *******************************************************************************
+ */
+void CoKfree(void* memBuf)
+{
+#if CFG_PAR_CHECKOUT_EN >0              /* Check validity of parameter        */
+    if(memBuf == NULL)
+    {
+        return;
+    }
+    if((U32)(memBuf) < Kheap.startAddr)
+    {
+        return;
+    }
+    if((U32)(memBuf) >= Kheap.endAddr)
+    {
+        return;
+    }
+#endif
+
+    OsSchedLock();                      /* Lock schedule                      */
+    TLSF_Free(&KheapTlsf,memBuf);
+    OsSchedUnlock();                    /* Unlock schedule                    */
+}
+
+
+/**
+ *******************************************************************************
+ * @brief      Get usage statistics of kernel heap.  
+ * @param[in]  None
+ * @param[out] pStats    Size,used bytes,peak,largest free block,block counts
+ *                       and failed allocations of kernel heap.
+ * @retval     None  		 
+ *
+ * @par Description
+ * @details    This function is called to get usage statistics of kernel heap.
+ *******************************************************************************
+ */
+void CoGetKheapStats(TlsfStats* pStats)
+{
+    OsSchedLock();                      /* Lock schedule                      */
+    TLSF_GetStats(&KheapTlsf,pStats);
+    OsSchedUnlock();                    /* Unlock schedule                    */
+}
+
+#else
 /*---------------------------- Variable Define -------------------------------*/
 U32     KernelHeap[KHEAP_SIZE] = {0};   /*!< Kernel heap                      */
 P_FMB   FMBlist = NULL;                 /*!< Free memory block list           */
@@ -406,4 +518,5 @@ static P_FMB GetPreFMB(P_UMB usedMB)
     return (P_FMB)(preUMB->preMB);      /* Yes,return previous MB             */
 }
 
+#endif    /* CFG_KHEAP_TLSF_EN */
 #endif
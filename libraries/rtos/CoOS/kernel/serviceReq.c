@@ -22,7 +22,7 @@
 
 #if CFG_MAX_SERVICE_REQUEST > 0
 /*---------------------------- Variable Define -------------------------------*/
-SRQ   ServiceReq = {0,0};             /*!< ISR server request queue         */		     
+SRQ   ServiceReq = {0,0,0,0};         /*!< ISR server request queue         */		     
 #endif       
 BOOL  IsrReq   = FALSE;
 #if (CFG_TASK_WAITTING_EN > 0)
@@ -41,39 +41,109 @@ BOOL  TimerReq = FALSE;                 /*!< Timer dispose request            */
  * @param[in]  arg      Service request argument. 
  * @param[out] None 
  * 	 
- * @retval     FALSE    Successfully insert into service request queue. 
- * @retval     TRUE     Failure to insert into service request queue.  
+ * @retval     TRUE     Successfully insert into service request queue. 
+ * @retval     FALSE    Failure to insert into service request queue.  
  *
  * @par Description		 
  * @details    This function be called to insert a requst into service request	
  *             queue.
- * @note 
+ * @note       On Cortex-M3 the tail cell is claimed with LDREX/STREX,so that
+ *             nested ISRs never mask interrupts.The cell is only responded
+ *             once it is marked ready.
  *******************************************************************************
  */
 #if (CFG_MAX_SERVICE_REQUEST > 0)
 BOOL InsertInSRQ(U8 type,U8 id,void* arg)
 {
     P_SQC   pcell;
-	U8 cnt;
-	U8 heed;
+    U32     tail;
+    U32     cnt;
+#if CFG_CHIP_TYPE == 1
+    do                                  /* Claim the tail cell                */
+    {
+        tail = OsLDREX(&ServiceReq.tail);
+        cnt  = tail - ServiceReq.head;
+        if(cnt >= CFG_MAX_SERVICE_REQUEST)
+        {
+            OsCLREX();
+            do                          /* Count the lost request             */
+            {
+                cnt = OsLDREX(&ServiceReq.overflow);
+            }while(OsSTREX(cnt + 1,&ServiceReq.overflow) != 0);
+
+            return FALSE;               /* Error return                       */
+        }
+    }while(OsSTREX(tail + 1,&ServiceReq.tail) != 0);
+
+    cnt++;
+    do                                  /* Raise the high-water mark          */
+    {
+        if(OsLDREX(&ServiceReq.peak) >= cnt)
+        {
+            OsCLREX();
+            break;
+        }
+    }while(OsSTREX(cnt,&ServiceReq.peak) != 0);
+
+    pcell = &ServiceReq.cell[tail & SRQ_MASK];
+    pcell->type = type;                 /* Save service request type,         */
+    pcell->id   = id;                   /* event id                           */
+    pcell->arg  = arg;                  /* and parameter                      */
+    OsDMB();                            /* Publish the cell before ready      */
+    pcell->ready = 1;
+#else
     IRQ_DISABLE_SAVE();
-    if (ServiceReq.cnt >= CFG_MAX_SERVICE_REQUEST)
+    tail = ServiceReq.tail;
+    cnt  = tail - ServiceReq.head;
+    if(cnt >= CFG_MAX_SERVICE_REQUEST)
     {
+        ServiceReq.overflow++;
         IRQ_ENABLE_RESTORE ();
 
         return FALSE;                   /* Error return                       */
     }
-	cnt = Inc8(&ServiceReq.cnt);
-	heed = ServiceReq.head;
-    IsrReq = TRUE;
-    pcell = &ServiceReq.cell[((cnt+heed)%CFG_MAX_SERVICE_REQUEST)];/*the tail */
-    pcell->type = type;                 /* Save service request type,         */
-    pcell->id   = id;                   /* event id                           */
-    pcell->arg  = arg;                  /* and parameter                      */
+    ServiceReq.tail = tail + 1;
+    if(cnt + 1 > ServiceReq.peak)
+    {
+        ServiceReq.peak = cnt + 1;
+    }
+    pcell = &ServiceReq.cell[tail & SRQ_MASK];
+    pcell->type  = type;                /* Save service request type,         */
+    pcell->id    = id;                  /* event id                           */
+    pcell->arg   = arg;                 /* and parameter                      */
+    pcell->ready = 1;
     IRQ_ENABLE_RESTORE ();
+#endif
+    IsrReq = TRUE;
 
     return TRUE;                        /* Return OK                          */
 }
+
+
+/**
+ *******************************************************************************
+ * @brief      Get statistics of service request queue.	 
+ * @param[in]  None
+ * @param[out] pOverflow  Requests lost because the queue was full.
+ * @param[out] pPeak      Most requests pending in the queue at once.
+ * @retval     None  
+ *
+ * @par Description		 
+ * @details    This function is called to size CFG_MAX_SERVICE_REQUEST:a 
+ *             non-zero pOverflow means isr_ calls returned E_SEV_REQ_FULL.
+ *******************************************************************************
+ */
+void CoGetServiceReqStats(U32* pOverflow,U32* pPeak)
+{
+    if(pOverflow != NULL)
+    {
+        *pOverflow = ServiceReq.overflow;
+    }
+    if(pPeak != NULL)
+    {
+        *pPeak = ServiceReq.peak;
+    }
+}
 #endif
 
 
@@ -88,15 +158,17 @@ BOOL InsertInSRQ(U8 type,U8 id,void* arg)
  * @par Description		 
  * @details    This function be called to respond the request in the service  
  *             request queue.
- * @note 
+ * @note       Only called with scheduler locked,so it is the sole consumer:
+ *             all ready cells are drained in one pass without masking 
+ *             interrupts.
  *******************************************************************************
  */
 void RespondSRQ(void)
 {
 
 #if CFG_MAX_SERVICE_REQUEST > 0
-    SQC cell;
-
+    SQC   cell;
+    P_SQC pcell;
 #endif
 
 #if (CFG_TASK_WAITTING_EN > 0)
@@ -116,14 +188,18 @@ void RespondSRQ(void)
 
 #if CFG_MAX_SERVICE_REQUEST > 0
 
-    while (ServiceReq.cnt != 0)
+    for(;;)
     {
-        IRQ_DISABLE_SAVE ();            /* need to protect the following      */
-        cell = ServiceReq.cell[ServiceReq.head];  /* extract one cell         */
-        ServiceReq.head = (ServiceReq.head + 1) % /* move head (pop)          */
-                     CFG_MAX_SERVICE_REQUEST;
-        ServiceReq.cnt--;
-        IRQ_ENABLE_RESTORE ();          /* now use the cell copy              */
+        pcell = &ServiceReq.cell[ServiceReq.head & SRQ_MASK];
+        if(pcell->ready == 0)           /* Empty,or claimed but not filled    */
+        {
+            break;
+        }
+        OsDMB();                        /* Read the cell after ready          */
+        cell = *pcell;                  /* extract one cell                   */
+        pcell->ready = 0;
+        OsDMB();                        /* Release the cell before head moves */
+        ServiceReq.head++;              /* move head (pop)                    */
 
         switch(cell.type)               /* Judge service request type         */
         {
@@ -152,13 +228,26 @@ void RespondSRQ(void)
         }
     }
 #endif
-    IRQ_DISABLE_SAVE ();                /* need to protect the following      */
-
-    if (ServiceReq.cnt == 0)            /* another item in the queue already? */
+    IsrReq = FALSE;
+    OsDMB();                            /* Clear before checking for more     */
+#if CFG_MAX_SERVICE_REQUEST > 0
+    if(ServiceReq.head != ServiceReq.tail)  /* another item in the queue?     */
     {
-        IsrReq = FALSE;                 /* queue still empty here             */
+        IsrReq = TRUE;                  /* respond it at next unlock          */
     }
-    IRQ_ENABLE_RESTORE ();              /* now it is done and return          */
+#endif
+#if (CFG_TASK_WAITTING_EN > 0)
+    if(TimeReq == TRUE)
+    {
+        IsrReq = TRUE;
+    }
+#endif
+#if CFG_TMR_EN  > 0
+    if(TimerReq == TRUE)
+    {
+        IsrReq = TRUE;
+    }
+#endif
 }
 
 #endif
@@ -39,6 +39,17 @@ OS_TID   RdyTaskPri[CFG_MAX_USER_TASKS+SYS_TASK_NUM] = {0};
 U32      RdyTaskPriInfo[(CFG_MAX_USER_TASKS+SYS_TASK_NUM+31)/32];
 #endif
 
+#if CFG_BITMAP_SCHEDULE_EN >0
+#define  RDY_MAP_WORDS   ((CFG_LOWEST_PRIO+32)/32)
+
+/*!< Head of the READY list of each priority,its TCBprev points to its tail. */
+static P_OSTCB RdyPrioList[CFG_LOWEST_PRIO+1];
+/*!< Bit (31-prio%32) of word prio/32 is set when the priority has READY task.*/
+static U32     RdyPrioMap[RDY_MAP_WORDS];
+/*!< Bit (31-i) is set when RdyPrioMap[i] is not 0.                          */
+static U32     RdyGrpMap;
+#endif
+
 
 /**
  *******************************************************************************
@@ -60,6 +71,17 @@ void CreateTCBList(void)
 #if CFG_ORDER_LIST_SCHEDULE_EN ==0
 	PriNum = 0;
 #endif
+#if CFG_BITMAP_SCHEDULE_EN >0
+	for(i=0;i<=CFG_LOWEST_PRIO;i++)
+	{
+		RdyPrioList[i] = NULL;
+	}
+	for(i=0;i<RDY_MAP_WORDS;i++)
+	{
+		RdyPrioMap[i] = 0;
+	}
+	RdyGrpMap = 0;
+#endif
 
 	ptcb1 = &TCBTbl[0];	                /* Build the free TCB list            */
     ptcb2 = &TCBTbl[1];  
@@ -354,6 +376,162 @@ void DeleteTaskPri(U8 pri)
 #endif
 
 
+#if CFG_BITMAP_SCHEDULE_EN >0
+
+#ifndef OsCLZ
+/**
+ *******************************************************************************
+ * @brief      Count leading zeros	  
+ * @param[in]  value          A non-zero word	 
+ * @param[out] None
+ * @retval     Number of zero bits above the highest bit set.	 
+ *					
+ * @par Description
+ * @details    This function is used by the bitmap scheduler on cores without
+ *             the CLZ instruction.
+ *******************************************************************************
+ */
+static U8 OsCLZ(U32 value)
+{
+	U8 cnt = 0;
+	while((value & 0x80000000) == 0)
+	{
+		value <<= 1;
+		cnt++;
+	}
+	return cnt;
+}
+#endif
+
+
+/**
+ *******************************************************************************
+ * @brief      Get the highest priority having READY task	  
+ * @param[in]  None	 
+ * @param[out] None
+ * @retval     Head of the READY list of that priority,NULL if no task ready.
+ *					
+ * @par Description
+ * @details    This function is called in bitmap schedule to find the next
+ *             task to run with two CLZ,whatever the number of tasks.
+ *******************************************************************************
+ */
+static P_OSTCB GetHighestRdyTask(void)
+{
+	U8 grp;
+	if(RdyGrpMap == 0)
+	{
+		return NULL;
+	}
+	grp = OsCLZ(RdyGrpMap);
+	return RdyPrioList[grp*32 + OsCLZ(RdyPrioMap[grp])];
+}
+
+
+/**
+ *******************************************************************************
+ * @brief      Append a task to the READY list of its priority	  
+ * @param[in]  tcbInsert      A pointer to task will be inserted.	 
+ * @param[out] None
+ * @retval     None
+ *					
+ * @par Description
+ * @details    This function is called in bitmap schedule to insert a task
+ *             after the READY tasks of the same priority,and to update 
+ *             TCBRdy if the task has a higher priority.
+ *******************************************************************************
+ */
+static void InsertToRdyPrioList(P_OSTCB tcbInsert)
+{
+	U8      prio;
+	P_OSTCB pHead;
+	
+	prio  = tcbInsert->prio;
+	pHead = RdyPrioList[prio];
+	tcbInsert->rdyPrio = prio;
+	tcbInsert->TCBnext = NULL;
+	if(pHead == NULL)                   /* First READY task of the priority   */
+	{
+		tcbInsert->TCBprev = tcbInsert;
+		RdyPrioList[prio]  = tcbInsert;
+		RdyPrioMap[prio/32] |= 0x80000000 >> (prio%32);
+		RdyGrpMap           |= 0x80000000 >> (prio/32);
+	}
+	else                                /* Append to the tail                 */
+	{
+		tcbInsert->TCBprev       = pHead->TCBprev;
+		pHead->TCBprev->TCBnext  = tcbInsert;
+		pHead->TCBprev           = tcbInsert;
+	}
+	
+	if((TCBRdy == NULL) || (prio < TCBRdy->rdyPrio))
+	{
+		TaskSchedReq = TRUE;
+		TCBRdy       = tcbInsert;
+	}
+}
+
+
+/**
+ *******************************************************************************
+ * @brief      Remove a task from the READY list of its priority	  
+ * @param[in]  ptcb           A pointer to task which be removed.	 
+ * @param[out] None
+ * @retval     None
+ *					
+ * @par Description
+ * @details    This function is called in bitmap schedule to remove a task
+ *             from the list it was inserted in,even if its priority changed
+ *             since,and to update TCBRdy.
+ *******************************************************************************
+ */
+static void RemoveFromRdyPrioList(P_OSTCB ptcb)
+{
+	U8      prio;
+	P_OSTCB pHead;
+	
+	prio  = ptcb->rdyPrio;
+	pHead = RdyPrioList[prio];
+	if(ptcb == pHead)                   /* Is head of the list?               */
+	{
+		RdyPrioList[prio] = ptcb->TCBnext;
+		if(ptcb->TCBnext != NULL)
+		{
+			ptcb->TCBnext->TCBprev = ptcb->TCBprev;
+		}
+		else                            /* No more READY task of the priority */
+		{
+			RdyPrioMap[prio/32] &= ~(0x80000000 >> (prio%32));
+			if(RdyPrioMap[prio/32] == 0)
+			{
+				RdyGrpMap &= ~(0x80000000 >> (prio/32));
+			}
+		}
+	}
+	else
+	{
+		ptcb->TCBprev->TCBnext = ptcb->TCBnext;
+		if(ptcb->TCBnext != NULL)
+		{
+			ptcb->TCBnext->TCBprev = ptcb->TCBprev;
+		}
+		else                            /* Tail removed                       */
+		{
+			pHead->TCBprev = ptcb->TCBprev;
+		}
+	}
+	ptcb->TCBnext = NULL;
+	ptcb->TCBprev = NULL;
+	
+	if(TCBRdy == ptcb)
+	{
+		TCBRdy = GetHighestRdyTask();
+	}
+}
+
+#endif
+
+
 /**
  *******************************************************************************
  * @brief      Insert a task to the ready list	   
@@ -367,7 +545,10 @@ void DeleteTaskPri(U8 pri)
  */
 void InsertToTCBRdyList(P_OSTCB tcbInsert)
 {
-    P_OSTCB ptcbNext,ptcb;
+    P_OSTCB ptcb;
+#if CFG_BITMAP_SCHEDULE_EN ==0
+    P_OSTCB ptcbNext;
+#endif
     U8  prio;
 #if CFG_ORDER_LIST_SCHEDULE_EN ==0
 	U8  seqNum;
@@ -396,7 +577,10 @@ void InsertToTCBRdyList(P_OSTCB tcbInsert)
 #endif
 
 
-#if CFG_ORDER_LIST_SCHEDULE_EN ==0
+#if CFG_BITMAP_SCHEDULE_EN >0
+	InsertToRdyPrioList(tcbInsert);
+
+#elif CFG_ORDER_LIST_SCHEDULE_EN ==0
 	GetPriSeqNum(prio,&seqNum);
 	if(GetPrioSeqNumStatus(seqNum) == TRUE)
 	{
@@ -490,7 +674,10 @@ void InsertToTCBRdyList(P_OSTCB tcbInsert)
  */
 void RemoveFromTCBRdyList(P_OSTCB ptcb)
 {
+#if CFG_BITMAP_SCHEDULE_EN >0
+	RemoveFromRdyPrioList(ptcb);
 
+#else
 #if CFG_ORDER_LIST_SCHEDULE_EN ==0
 	U8 prio;
 	U8 seqNum;
@@ -551,6 +738,7 @@ void RemoveFromTCBRdyList(P_OSTCB ptcb)
 			SetPrioSeqNumStatus(seqNum, 0);
 		}
 #endif
+#endif
 }
 
 
@@ -761,13 +949,18 @@ void Schedule(void)
 #endif
     
   
-#if CFG_STK_CHECKOUT_EN > 0                       /* Is stack overflow?       */
+#if CFG_STK_GUARD_EN > 0
+    SetStkGuard(TCBNext->stack);                  /* Guard stack switched in  */
+#elif CFG_STK_CHECKOUT_EN > 0                     /* Is stack overflow?       */
     if((pCurTcb->stkPtr < pCurTcb->stack)||(*(U32*)(pCurTcb->stack) != MAGIC_WORD))       
     {									
         CoStkOverflowHook(pCurTcb->taskID);       /* Yes,call handler         */		
     }   
 #endif
  	
+#if CFG_TASK_PROFILE_EN > 0
+    TASKPROF_SwitchTo(TCBNext);                   /* Charge time to pCurTcb   */
+#endif
     SwitchContext();                              /* Call task context switch */
 }
 
@@ -824,6 +1017,9 @@ OS_TID CreateTask(FUNCPtr task,void *argv,U32 parameter,OS_STK *stk)
     OS_STK* stkTopPtr;
     P_OSTCB ptcb;
     U8      prio;
+#if (CFG_TASK_PROFILE_EN >0) && (CFG_STK_CHECKOUT_EN >0)
+    OS_STK* stkPaint;
+#endif
 #if CFG_ROBIN_EN >0	
     U16     timeSlice;
 #endif
@@ -876,6 +1072,19 @@ OS_TID CreateTask(FUNCPtr task,void *argv,U32 parameter,OS_STK *stk)
     *(U32*)(ptcb->stack) = MAGIC_WORD;
 #endif	
 
+#if CFG_TASK_PROFILE_EN >0
+#if CFG_STK_CHECKOUT_EN >0
+    /* Paint the unused stack to measure its high-water mark                  */
+    for(stkPaint = ptcb->stack+1; stkPaint < stkTopPtr; stkPaint++)
+    {
+        *(U32*)stkPaint = MAGIC_WORD;
+    }
+    TASKPROF_AddTask(ptcb,NULL,ptcb->taskID,(U32*)ptcb->stack,sktSz,MAGIC_WORD);
+#else
+    TASKPROF_AddTask(ptcb,NULL,ptcb->taskID,NULL,0,0);
+#endif
+#endif
+
 #if CFG_TASK_WAITTING_EN >0
     ptcb->delayTick	= INVALID_VALUE;	
 #endif		 
@@ -1027,6 +1236,10 @@ StatusType CoDelTask(OS_TID taskID)
     ptcb->state   = TASK_DORMANT;       /* Release TCB                        */
 	TaskSchedReq  = TRUE;	
 
+#if CFG_TASK_PROFILE_EN >0
+	TASKPROF_RemoveTask(ptcb);
+#endif
+
 #if CFG_ORDER_LIST_SCHEDULE_EN ==0
 	DeleteTaskPri(ptcb->prio);	
 #endif	
@@ -21,7 +21,8 @@
 #if CFG_TASK_WAITTING_EN > 0
 
 /*---------------------------- Variable Define -------------------------------*/
-P_OSTCB DlyList   = NULL;               /*!< Header pointer to the DELAY list.*/
+P_OSTCB DlyWheel[CFG_TICK_WHEEL_SIZE] = {NULL}; /*!< Slots of the DELAY wheel.*/
+U32     DlyDoneTick = 0;        /*!< Last tick whose expired delays are done. */
 
 
 /**
@@ -34,63 +35,30 @@ P_OSTCB DlyList   = NULL;               /*!< Header pointer to the DELAY list.*/
  * @retval     None.	 	 
  *
  * @par Description
- * @details    This function is called to insert task into DELAY list.
+ * @details    This function is called to insert task into DELAY list. The
+ *             DELAY list is a timing wheel: the task is put at the head of 
+ *             the slot of its expiry tick, whatever the number of delayed 
+ *             tasks.
  *******************************************************************************
  */
 void InsertDelayList(P_OSTCB ptcb,U32 ticks)
 {
-    S32 deltaTicks;
-    P_OSTCB dlyNext;
+    P_OSTCB* pslot;
     
     if(ticks == 0)                      /* Is delay tick == 0?                */
         return;                         /* Yes,do nothing,return              */
-    if(DlyList == NULL)                 /* Is no item in DELAY list?          */
+    
+    ptcb->delayTick   = ticks;
+    ptcb->delayExpire = (U32)OSTickCnt + ticks;
+    pslot = &DlyWheel[ptcb->delayExpire & TICK_WHEEL_MASK];
+    
+    ptcb->TCBprev = NULL;               /* Insert at the head of the slot     */
+    ptcb->TCBnext = *pslot;
+    if(*pslot != NULL)
     {
-        ptcb->delayTick = ticks;        /* Yes,set this as first item         */
-        DlyList         = ptcb;
-    }
-    else
-    {	
-        /* No,find correct place ,and insert the task */
-        dlyNext    = DlyList; 
-        deltaTicks = ticks;             /* Get task delay ticks               */
-        
-        /* Find correct place */
-        while(dlyNext != NULL)
-        {		
-            /* Get delta ticks with previous item */ 
-            deltaTicks -= dlyNext->delayTick;  
-            if(deltaTicks < 0)          /* Is delta ticks<0?                  */
-            {	  
-                /* Yes,get correct place */
-                if(dlyNext->TCBprev != NULL)   /* Is head item of DELAY list? */
-                {							   
-                    dlyNext->TCBprev->TCBnext = ptcb;   /* No,insert into     */ 
-                    ptcb->TCBprev             = dlyNext->TCBprev;
-                    ptcb->TCBnext             = dlyNext;
-                    dlyNext->TCBprev          = ptcb;
-                }
-                else                    /* Yes,set task as first item         */
-                {							   
-                    ptcb->TCBnext    = DlyList;
-                    DlyList->TCBprev = ptcb;
-                    DlyList          = ptcb;
-                }
-                ptcb->delayTick           = ptcb->TCBnext->delayTick+deltaTicks;
-                ptcb->TCBnext->delayTick -= ptcb->delayTick; 
-                break;
-            }
-            /* Is last item in DELAY list? */
-            else if((deltaTicks >= 0) && (dlyNext->TCBnext == NULL) )
-            {								   
-                ptcb->TCBprev    = dlyNext; /* Yes,insert into                */
-                dlyNext->TCBnext = ptcb;	
-                ptcb->delayTick  = deltaTicks;
-                break;
-            }
-            dlyNext = dlyNext->TCBnext; /* Get the next item in DELAY list    */
-        }
+        (*pslot)->TCBprev = ptcb;
     }
+    *pslot = ptcb;
 
     ptcb->state  = TASK_WAITING;        /* Set task status as TASK_WAITING    */
     TaskSchedReq = TRUE;
@@ -110,34 +78,20 @@ void InsertDelayList(P_OSTCB ptcb,U32 ticks)
  */
 void RemoveDelayList(P_OSTCB ptcb)
 {
-    
-    /* Is there only one item in the DELAY list?   */
-    if((ptcb->TCBprev == NULL) && ( ptcb->TCBnext == NULL))
+    if(ptcb->TCBprev == NULL)           /* Is the first item of its slot?     */
     {
-        DlyList = NULL;	                /* Yes,set DELAY list as NULL         */
-    }
-    else if(ptcb->TCBprev == NULL)      /* Is the first item in DELAY list?   */
-    {   
-	    /* Yes,remove task from the DELAY list,and reset the list             */
-        DlyList	                  = ptcb->TCBnext;
-        ptcb->TCBnext->delayTick += ptcb->delayTick;
-        ptcb->TCBnext->TCBprev    = NULL;	
-        ptcb->TCBnext             = NULL;
-        
+        DlyWheel[ptcb->delayExpire & TICK_WHEEL_MASK] = ptcb->TCBnext;
     }
-    else if(ptcb->TCBnext == NULL)      /* Is the last item in DELAY list?    */
-    {									
-        ptcb->TCBprev->TCBnext = NULL;  /* Yes,remove task form DELAY list    */
-        ptcb->TCBprev          = NULL;	
+    else
+    {
+        ptcb->TCBprev->TCBnext = ptcb->TCBnext;
     }
-    else                                /* No, remove task from DELAY list    */
-    {									
-        ptcb->TCBprev->TCBnext    = ptcb->TCBnext;	
-        ptcb->TCBnext->TCBprev    = ptcb->TCBprev;	
-        ptcb->TCBnext->delayTick += ptcb->delayTick;
-        ptcb->TCBnext     	      = NULL;
-        ptcb->TCBprev             = NULL;
+    if(ptcb->TCBnext != NULL)
+    {
+        ptcb->TCBnext->TCBprev = ptcb->TCBprev;
     }
+    ptcb->TCBnext   = NULL;
+    ptcb->TCBprev   = NULL;
     ptcb->delayTick = INVALID_VALUE;  /* Set task delay tick value as invalid */		
 }
 
@@ -308,40 +262,51 @@ StatusType  CoTimeDelay(U8 hour,U8 minute,U8 sec,U16 millsec)
  * @retval     None 
  *
  * @par Description
- * @details    This function is called to dispose time delay of all task.  
+ * @details    This function is called to dispose time delay of all task. It 
+ *             visits the slots of the ticks elapsed since the last call, at 
+ *             most the whole wheel once if it was deferred for long, and 
+ *             only wakes up the tasks of these slots whose delay expired.
  *******************************************************************************
  */
 void TimeDispose(void)
 {  
-    P_OSTCB	dlyList;
+    U32     now = (U32)OSTickCnt;
+    U32     ticks;
+    P_OSTCB ptcb;
+    P_OSTCB pnext;
     
-    dlyList = DlyList;                  /* Get first item of DELAY list       */
-    while((dlyList != NULL) && (dlyList->delayTick == 0) )
-    {	
+    ticks = now - DlyDoneTick;          /* Get number of ticks to dispose     */
+    if(ticks > CFG_TICK_WHEEL_SIZE)
+    {
+        ticks = CFG_TICK_WHEEL_SIZE;
+    }
+    DlyDoneTick = now;
     
+    while(ticks-- > 0)
+    {
+        ptcb = DlyWheel[(now - ticks) & TICK_WHEEL_MASK];
+        while(ptcb != NULL)
+        {
+            pnext = ptcb->TCBnext;
+            if((S32)(ptcb->delayExpire - now) <= 0) /* Is delay expired?      */
+            {
 #if CFG_EVENT_EN > 0
-        if(dlyList->eventID != INVALID_ID) /* Is task in event waiting list?  */
-        {								   
-            RemoveEventWaittingList(dlyList); /* Yes,remove task from list    */	
-        }
+                if(ptcb->eventID != INVALID_ID) /* Is task in event waiting list?  */
+                {								   
+                    RemoveEventWaittingList(ptcb); /* Yes,remove task from list    */	
+                }
 #endif
 
 #if CFG_FLAG_EN  > 0
-        if(dlyList->pnode != NULL)          /* Is task in flag waiting list?  */
-        {
-            RemoveLinkNode(dlyList->pnode); /* Yes,remove task from list      */	
-        }
+                if(ptcb->pnode != NULL)          /* Is task in flag waiting list?  */
+                {
+                    RemoveLinkNode(ptcb->pnode); /* Yes,remove task from list      */	
+                }
 #endif
-        dlyList->delayTick = INVALID_VALUE; /* Set delay tick value as invalid*/
-        DlyList = dlyList->TCBnext; /* Get next item as the head of DELAY list*/
-        dlyList->TCBnext   = NULL;		   
-
-		InsertToTCBRdyList(dlyList);        /* Insert task into READY list    */
-        
-        dlyList = DlyList;                /* Get the first item of DELAY list */
-        if(dlyList != NULL)                 /* Is DELAY list as NULL?         */
-        {
-            dlyList->TCBprev = NULL;        /* No,initialize the first item   */
+                RemoveDelayList(ptcb);      /* Remove task from its slot      */
+                InsertToTCBRdyList(ptcb);   /* Insert task into READY list    */
+            }
+            ptcb = pnext;
         }
     }
 }
@@ -356,11 +321,21 @@ void TimeDispose(void)
  *
  * @par Description
  * @details    This function is called in systick interrupt to dispose time delay   
- *             of all task.
+ *             of all task. Only the slot of the current tick is checked, 
+ *             unless previous ticks are still to be disposed.
  *******************************************************************************
  */
 void isr_TimeDispose(void)
 {
+    U32 now = (U32)OSTickCnt;
+    
+    /* Nothing expiring now and no tick left behind?                          */
+    if((DlyWheel[now & TICK_WHEEL_MASK] == NULL) && (DlyDoneTick == now - 1))
+    {
+        DlyDoneTick = now;
+        return;
+    }
+    
     if(OSSchedLock > 1)                 /* Is schedule lock?                  */
     {
         IsrReq = TRUE;
@@ -372,5 +347,4 @@ void isr_TimeDispose(void)
     }
 }
 
-
 #endif
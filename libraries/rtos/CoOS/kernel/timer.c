@@ -22,8 +22,11 @@
 #if CFG_TMR_EN > 0
 
 TmrCtrl    TmrTbl[CFG_MAX_TMR]= {{0}};/*!< Table which save timer control block.*/
-P_TmrCtrl  TmrList     = NULL;      /*!< The header of the TmrCtrl list.      */
-U32        TmrIDVessel = 0;         /*!< Timer ID container.                  */
+P_TmrCtrl  TmrWheel[CFG_TICK_WHEEL_SIZE] = {NULL}; /*!< Slots of timer wheel. */
+U32        TmrDoneTick = 0;         /*!< Last tick whose timers are disposed. */
+U32        TmrIDVessel[(CFG_MAX_TMR + 31) / 32] = {0}; /*!< Timer ID container. */
+
+#define TMR_ID_USED(id)   (TmrIDVessel[(id) >> 5] & (1 << ((id) & 31)))
 
 
 /**
@@ -31,72 +34,36 @@ U32        TmrIDVessel = 0;         /*!< Timer ID container.                  */
  * @brief      Insert a timer into the timer list	   
  * @param[in]  tmrID    Specify timer ID which insertted.		 
  * @param[out] None  
- * @retval     E_INVALID_ID  Timer ID passed was invalid,insert fail.
- * @retval     E_OK          Insert successful.			 
+ * @retval     None
  *
  * @par Description
  * @details    This function is called to insert a timer into the timer list.  
+ *             The timer list is a timing wheel: the timer is put at the head
+ *             of the slot of its expiry tick, whatever the number of timers.
  *******************************************************************************
  */
 static void InsertTmrList(OS_TCID tmrID)
 {
-    P_TmrCtrl pTmr;
-    S32 deltaTicks;
-    U32 tmrCnt;
-    tmrCnt = TmrTbl[tmrID].tmrCnt;      /* Get timer time                     */
+    P_TmrCtrl  pTmr;
+    P_TmrCtrl* pslot;
     
-    if(tmrCnt == 0)                     /* Is timer time==0?                  */
+    pTmr = &TmrTbl[tmrID];
+    if(pTmr->tmrCnt == 0)               /* Is timer time==0?                  */
     {
         return;                         /* Do nothing,return                  */
     }
     
     OsSchedLock();                      /* Lock schedule                      */
-    if(TmrList == NULL)                 /* Is no item in timer list?          */
+    pTmr->tmrExpire = (U32)OSTickCnt + pTmr->tmrCnt;
+    pslot = &TmrWheel[pTmr->tmrExpire & TICK_WHEEL_MASK];
+    pTmr->tmrPrev = NULL;               /* Insert at the head of the slot     */
+    pTmr->tmrNext = *pslot;
+    if(*pslot != NULL)
     {
-        TmrList = &TmrTbl[tmrID];       /* Yes,set this as first item         */
-    }
-    else                  /* No,find correct place ,and insert inserted timer */
-    {								    
-      	pTmr       = TmrList; 
-      	deltaTicks = tmrCnt;            /* Get timer tick                     */
-      	
-      	/* find correct place */
-      	while(pTmr != NULL)
-      	{				    
-            deltaTicks -= pTmr->tmrCnt; /* Get ticks with previous item       */
-            if(deltaTicks < 0)          /* Is delta ticks<0?                  */  
-            {	
-                /* Yes,get correct place */
-                if(pTmr->tmrPrev!= NULL)/* Is head item of timer list?        */
-                {	
-                    /* No,insert into */
-                    pTmr->tmrPrev->tmrNext = &TmrTbl[tmrID]; 
-                    TmrTbl[tmrID].tmrPrev  = pTmr->tmrPrev;
-                    TmrTbl[tmrID].tmrNext  = pTmr;
-                    pTmr->tmrPrev          = &TmrTbl[tmrID];
-                }
-                else                    /* Yes,set task as first item         */ 	
-                {
-                    TmrTbl[tmrID].tmrNext = TmrList;
-                    TmrList->tmrPrev      = &TmrTbl[tmrID];
-                    TmrList               = &TmrTbl[tmrID];
-                }
-                TmrTbl[tmrID].tmrCnt            = TmrTbl[tmrID].tmrNext->tmrCnt+deltaTicks;
-                TmrTbl[tmrID].tmrNext->tmrCnt  -= TmrTbl[tmrID].tmrCnt; 
-                break;	
-            }
-            /* Is last item in list? */									
-            else if((deltaTicks >= 0) && (pTmr->tmrNext == NULL))
-            {	
-                /* Yes,insert into */
-                TmrTbl[tmrID].tmrPrev = pTmr;
-                pTmr->tmrNext         = &TmrTbl[tmrID];	
-                TmrTbl[tmrID].tmrCnt  = deltaTicks;
-                break;	
-            }
-            pTmr = pTmr->tmrNext;       /* Get the next item in timer list    */	
-      	}
+        (*pslot)->tmrPrev = pTmr;
     }
+    *pslot = pTmr;
+    pTmr->tmrLinked = TRUE;
     OsSchedUnlock();                    /* Unlock schedule                    */
 }
 
@@ -119,32 +86,23 @@ static void RemoveTmrList(OS_TCID tmrID)
     pTmr = &TmrTbl[tmrID];
     
     OsSchedLock();                      /* Lock schedule                      */
-    
-    /* Is there only one item in timer list?                                  */
-    if((pTmr->tmrPrev == NULL) && (pTmr->tmrNext == NULL))
-    {		
-        TmrList = NULL;                 /* Yes,set timer list as NULL         */ 	
-    }
-    else if(pTmr->tmrPrev == NULL)      /* Is the first item in timer list?   */
-    {   /* Yes,remove timer from list,and reset timer list                    */
-        TmrList  = pTmr->tmrNext;
-        TmrList->tmrPrev = NULL;
-        pTmr->tmrNext->tmrCnt += pTmr->tmrCnt;
-        pTmr->tmrNext    = NULL;  
-    }
-    else if(pTmr->tmrNext == NULL)      /* Is the last item in timer list?    */
-    {
-        /* Yes,remove timer form list */
-        pTmr->tmrPrev->tmrNext = NULL;	
-        pTmr->tmrPrev = NULL;
-    }
-    else                                /* No, remove timer from list         */
+    if(pTmr->tmrLinked == TRUE)         /* Is timer in the wheel?             */
     {
-        pTmr->tmrPrev->tmrNext  =  pTmr->tmrNext;
-        pTmr->tmrNext->tmrPrev  =  pTmr->tmrPrev;
-        pTmr->tmrNext->tmrCnt  += pTmr->tmrCnt;
-        pTmr->tmrNext = NULL;
-        pTmr->tmrPrev = NULL;
+        if(pTmr->tmrPrev == NULL)       /* Is the first item of its slot?     */
+        {
+            TmrWheel[pTmr->tmrExpire & TICK_WHEEL_MASK] = pTmr->tmrNext;
+        }
+        else
+        {
+            pTmr->tmrPrev->tmrNext = pTmr->tmrNext;
+        }
+        if(pTmr->tmrNext != NULL)
+        {
+            pTmr->tmrNext->tmrPrev = pTmr->tmrPrev;
+        }
+        pTmr->tmrNext   = NULL;
+        pTmr->tmrPrev   = NULL;
+        pTmr->tmrLinked = FALSE;
     }
     OsSchedUnlock();                    /* Unlock schedule                    */
 }
@@ -181,9 +139,9 @@ OS_TCID CoCreateTmr(U8 tmrType, U32 tmrCnt, U32 tmrReload, vFUNCPtr func)
     OsSchedLock();                        /* Lock schedule                    */
     for(i = 0; i < CFG_MAX_TMR; i++)
     {
-        if((TmrIDVessel & (1 << i)) == 0) /* Is free timer ID?                */
+        if(TMR_ID_USED(i) == 0)           /* Is free timer ID?                */
         {
-            TmrIDVessel |= (1<<i);        /* Yes,assign ID to this timer      */
+            TmrIDVessel[i >> 5] |= (1 << (i & 31)); /* Yes,assign ID to this timer */
             OsSchedUnlock();              /* Unlock schedule                  */
             TmrTbl[i].tmrID     = i;      /* Initialize timer as user set     */
             TmrTbl[i].tmrType   = tmrType;	
@@ -193,6 +151,7 @@ OS_TCID CoCreateTmr(U8 tmrType, U32 tmrCnt, U32 tmrReload, vFUNCPtr func)
             TmrTbl[i].tmrCallBack = func;
             TmrTbl[i].tmrPrev   = NULL;
             TmrTbl[i].tmrNext   = NULL;
+            TmrTbl[i].tmrLinked = FALSE;
             return i;                     /* Return timer ID                  */
         }
     }
@@ -220,7 +179,7 @@ StatusType CoStartTmr(OS_TCID tmrID)
     {
         return E_INVALID_ID;
     }
-    if( (TmrIDVessel & (1<<tmrID)) == 0)
+    if( TMR_ID_USED(tmrID) == 0)
     {
         return E_INVALID_ID;
     }
@@ -258,7 +217,7 @@ StatusType CoStopTmr(OS_TCID tmrID)
     {
         return E_INVALID_ID;
     }
-    if((TmrIDVessel & (1<<tmrID)) == 0)
+    if(TMR_ID_USED(tmrID) == 0)
     {
         return E_INVALID_ID;
     }
@@ -296,7 +255,7 @@ StatusType CoDelTmr(OS_TCID tmrID)
     {
         return E_INVALID_ID;
     }
-    if( (TmrIDVessel & (1<<tmrID)) == 0)
+    if( TMR_ID_USED(tmrID) == 0)
     {
         return E_INVALID_ID;
     }
@@ -306,7 +265,8 @@ StatusType CoDelTmr(OS_TCID tmrID)
     {
         RemoveTmrList(tmrID);         /* Yes,remove this timer from timer list*/
     }
-    TmrIDVessel &=~(1<<tmrID);        /* Release resource that this timer hold*/
+    TmrTbl[tmrID].tmrState = TMR_STATE_STOPPED;
+    TmrIDVessel[tmrID >> 5] &= ~(1 << (tmrID & 31)); /* Release resource that this timer hold*/
     return E_OK;                      /* Return OK                            */
 }
 
@@ -331,13 +291,19 @@ U32 CoGetCurTmrCnt(OS_TCID tmrID,StatusType* perr)
         *perr = E_INVALID_ID;
         return 0;
     }
-    if((TmrIDVessel & (1<<tmrID)) == 0)
+    if(TMR_ID_USED(tmrID) == 0)
     {
         *perr = E_INVALID_ID;
         return 0;
     }
 #endif
     *perr = E_OK;
+    if(TmrTbl[tmrID].tmrLinked == TRUE) /* Is timer counting?                 */
+    {
+        /* Yes,return ticks left before it expires */
+        return (U32)((S32)(TmrTbl[tmrID].tmrExpire - (U32)OSTickCnt) > 0 ?
+                     TmrTbl[tmrID].tmrExpire - (U32)OSTickCnt : 0);
+    }
     return TmrTbl[tmrID].tmrCnt;        /* Return timer counter               */
 }
 
@@ -363,7 +329,7 @@ StatusType CoSetTmrCnt(OS_TCID tmrID,U32 tmrCnt,U32 tmrReload)
     {
         return E_INVALID_ID;
     }
-    if( (TmrIDVessel & (1<<tmrID)) == 0)
+    if( TMR_ID_USED(tmrID) == 0)
     {
         return E_INVALID_ID;
     }
@@ -380,6 +346,28 @@ StatusType CoSetTmrCnt(OS_TCID tmrID,U32 tmrCnt,U32 tmrReload)
 }
 
 
+/**
+ *******************************************************************************
+ * @brief      Find an expired timer in a slot	   
+ * @param[in]  slot     Slot of the timer wheel.
+ * @param[in]  now      Current tick.
+ * @param[out] None	 
+ * @retval     The first expired timer of the slot, NULL if none.	 
+ *******************************************************************************
+ */
+static P_TmrCtrl FindExpiredTmr(U32 slot,U32 now)
+{
+    P_TmrCtrl pTmr;
+    
+    pTmr = TmrWheel[slot];
+    while((pTmr != NULL) && ((S32)(pTmr->tmrExpire - now) > 0))
+    {
+        pTmr = pTmr->tmrNext;
+    }
+    return pTmr;
+}
+
+
 /**
  *******************************************************************************
  * @brief      Timer counter dispose	   
@@ -388,34 +376,46 @@ StatusType CoSetTmrCnt(OS_TCID tmrID,U32 tmrCnt,U32 tmrReload)
  * @retval     None	 
  *
  * @par Description
- * @details    This function is called to dispose timer counter.
+ * @details    This function is called to dispose timer counter. It visits 
+ *             the slots of the ticks elapsed since the last call, at most the 
+ *             whole wheel once, and only runs the timers of these slots which
+ *             expired. As a callback may stop or delete any timer, the slot is
+ *             searched again after each one.
  *******************************************************************************
  */
 void TmrDispose(void)
 {
-    P_TmrCtrl	pTmr;
+    U32       now = (U32)OSTickCnt;
+    U32       ticks;
+    U32       slot;
+    P_TmrCtrl pTmr;
     
-    pTmr = TmrList;                     /* Get first item of timer list       */
-    while((pTmr != NULL) && (pTmr->tmrCnt == 0) )
-    {	
-        if(pTmr->tmrType == TMR_TYPE_ONE_SHOT)    /* Is a One-shot timer?     */
+    ticks = now - TmrDoneTick;          /* Get number of ticks to dispose     */
+    if(ticks > CFG_TICK_WHEEL_SIZE)
+    {
+        ticks = CFG_TICK_WHEEL_SIZE;
+    }
+    TmrDoneTick = now;
+    
+    while(ticks-- > 0)
+    {
+        slot = (now - ticks) & TICK_WHEEL_MASK;
+        while((pTmr = FindExpiredTmr(slot,now)) != NULL)
         {
-            /* Yes,remove this timer from timer list                          */
+            /* Remove this timer from timer list                              */
             RemoveTmrList(pTmr->tmrID);
-            
-            /* Set timer status as TMR_STATE_STOPPED                          */
-            pTmr->tmrState = TMR_STATE_STOPPED;
-            (pTmr->tmrCallBack)();          /* Call timer callback function   */
-        }
-        else if(pTmr->tmrType == TMR_TYPE_PERIODIC)   /* Is a periodic timer? */
-        {
-            /* Yes,remove this timer from timer list                          */
-            RemoveTmrList(pTmr->tmrID); 
-            pTmr->tmrCnt = pTmr->tmrReload;   /* Reset timer tick             */
-            InsertTmrList(pTmr->tmrID);       /* Insert timer into timer list */
-            (pTmr->tmrCallBack)();            /* Call timer callback function */
+            if(pTmr->tmrType == TMR_TYPE_PERIODIC)    /* Is a periodic timer? */
+            {
+                pTmr->tmrCnt = pTmr->tmrReload;   /* Reset timer tick         */
+                InsertTmrList(pTmr->tmrID);       /* Insert timer into list   */
+            }
+            else                                  /* One-shot timer           */
+            {
+                /* Set timer status as TMR_STATE_STOPPED                      */
+                pTmr->tmrState = TMR_STATE_STOPPED;
+            }
+            (pTmr->tmrCallBack)();                /* Call timer callback      */
         }
-        pTmr = TmrList;	                      /* Get first item of timer list */
     }
 }
 
@@ -428,11 +428,22 @@ void TmrDispose(void)
  * @retval     None	 
  *
  * @par Description
- * @details    This function is called to dispose timer counter.
+ * @details    This function is called to dispose timer counter. Only the slot
+ *             of the current tick is checked, unless previous ticks are still
+ *             to be disposed.
  *******************************************************************************
  */
 void isr_TmrDispose(void)
 {
+    U32 now = (U32)OSTickCnt;
+    
+    /* Nothing expiring now and no tick left behind?                          */
+    if((TmrWheel[now & TICK_WHEEL_MASK] == NULL) && (TmrDoneTick == now - 1))
+    {
+        TmrDoneTick = now;
+        return;
+    }
+    
     if(OSSchedLock > 1)                 /* Is schedule lock?                  */
     {
         IsrReq = TRUE;
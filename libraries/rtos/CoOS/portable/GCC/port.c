@@ -33,7 +33,7 @@ extern void   IRQ_ENABLE_RESTORE(void);
 extern void   IRQ_DISABLE_SAVE(void);
 extern void   SetEnvironment(OS_STK *pstk) __attribute__ ((naked)); 	
 extern void   SwitchContext(void)          __attribute__ ((naked));
-extern void   PendSV_Handler(void)         __attribute__ ((naked));
+extern void   PendSV_Handler(void)         __attribute__ ((naked)) OS_RAMFUNC;
 
 
 /**
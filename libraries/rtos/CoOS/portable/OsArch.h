@@ -35,6 +35,87 @@
 #define InitInt()       NVIC_SYS_PRI2 |=  0xFF000000;\
                         NVIC_SYS_PRI3 |=  0xFFFF0000
 
+#if CFG_STK_GUARD_EN > 0
+#define NVIC_SYS_HCSR   (*((volatile U32 *)0xE000ED24))
+#define NVIC_MMFSR      (*((volatile U8  *)0xE000ED28))
+#define NVIC_MMFAR      (*((volatile U32 *)0xE000ED34))
+#define MPU_CTRL        (*((volatile U32 *)0xE000ED94))
+#define MPU_RNR         (*((volatile U32 *)0xE000ED98))
+#define MPU_RBAR        (*((volatile U32 *)0xE000ED9C))
+#define MPU_RASR        (*((volatile U32 *)0xE000EDA0))
+
+/*!< The guard is the highest priority MPU region,so that it overrides the
+     default memory map of the privileged tasks.                              */
+#define STK_GUARD_REGION  (7)
+#define STK_GUARD_SIZE    (32)
+#define STK_GUARD_BASE(stk) (((U32)(stk)+STK_GUARD_SIZE-1) & ~(U32)(STK_GUARD_SIZE-1))
+
+/*!< Enable MemManage fault and MPU,with default memory map as background.    */
+#define InitStkGuard()  NVIC_SYS_HCSR |= 0x00010000;\
+                        MPU_CTRL       = 0x00000005
+
+/*!< Move the guard to the bottom of a stack: 32 bytes,no access,never exec. */
+#define SetStkGuard(stk) MPU_RBAR = STK_GUARD_BASE(stk) | 0x10 | STK_GUARD_REGION;\
+                         MPU_RASR = 0x10000009
+#endif
+
+/*!< Places the tick and context switch handlers in SRAM (.ramfunc).         */
+#if defined ( __CC_ARM )
+#define OS_RAMFUNC
+#elif defined ( __ICCARM__ )
+#define OS_RAMFUNC      __ramfunc
+#else
+#define OS_RAMFUNC      __attribute__ ((section (".ramfunc"), noinline, long_call))
+#endif
+
+/*!< Count leading zeros of a non-zero word (CLZ instruction of Cortex-M3).   */
+#if CFG_CHIP_TYPE == 1
+#if defined ( __CC_ARM )
+#define OsCLZ(x)        __clz(x)
+#elif defined ( __ICCARM__ )
+#include <intrinsics.h>
+#define OsCLZ(x)        __CLZ(x)
+#else
+#define OsCLZ(x)        __builtin_clz(x)
+#endif
+
+/*!< Exclusive access to a word (LDREX/STREX of Cortex-M3).                  */
+#if defined ( __CC_ARM )
+#define OsLDREX(p)      __ldrex(p)
+#define OsSTREX(v,p)    __strex(v,p)
+#define OsCLREX()       __clrex()
+#elif defined ( __ICCARM__ )
+#define OsLDREX(p)      __LDREX((unsigned long*)(p))
+#define OsSTREX(v,p)    __STREX(v,(unsigned long*)(p))
+#define OsCLREX()       __CLREX()
+#else
+static inline U32 OsLDREX(volatile U32* p)
+{
+    U32 v;
+    __asm volatile ("ldrex %0,[%1]" : "=r" (v) : "r" (p) : "memory");
+    return v;
+}
+static inline U32 OsSTREX(U32 v,volatile U32* p)
+{
+    U32 fail;
+    __asm volatile ("strex %0,%1,[%2]" : "=&r" (fail) : "r" (v), "r" (p)
+                    : "memory");
+    return fail;
+}
+#define OsCLREX()       __asm volatile ("clrex" ::: "memory")
+#endif
+#endif
+
+/*!< Data memory barrier,also a compiler barrier.                            */
+#if defined ( __CC_ARM )
+#define OsDMB()         __dmb(0xF)
+#elif defined ( __ICCARM__ )
+#include <intrinsics.h>
+#define OsDMB()         __DMB()
+#else
+#define OsDMB()         __asm volatile ("dmb" ::: "memory")
+#endif
+
 
 /*---------------------------- Variable declare ------------------------------*/
 extern U64      OSTickCnt;          /*!< Counter for current system ticks.    */									
@@ -3,7 +3,8 @@
  * @file      arch.c
  * @version   V1.13
  * @date      2010.04.26
- * @brief     This file provides InitTaskContext() and SysTick_Handler().
+ * @brief     This file provides InitTaskContext(),SysTick_Handler() and 
+ *            MemManage_Handler().
  *******************************************************************************
  * @copy
  *	WRITE COPY INFORMATION USE CAPITAL LETTER
@@ -59,39 +60,66 @@ extern void SysTick_Handler(void) ;
  * @note       CoOS may schedule when exiting this ISR.
  *******************************************************************************
  */
-void SysTick_Handler(void)
+OS_RAMFUNC void SysTick_Handler(void)
 {
     OSSchedLock++;                  /* Lock scheduler.                        */
     OSTickCnt++;                    /* Increment systerm time.                */
 #if CFG_TASK_WAITTING_EN >0
-    if(DlyList != NULL)             /* Have task in delay list?               */
+    isr_TimeDispose();              /* Dispose the delays expiring now.       */
+#endif
+
+#if CFG_TMR_EN > 0	
+    isr_TmrDispose();               /* Dispose the timers expiring now.       */
+#endif
+	TaskSchedReq = TRUE;
+    OsSchedUnlock();
+}
+
+
+#if CFG_STK_GUARD_EN >0
+extern void MemManage_Handler(void) ;
+
+/**
+ *******************************************************************************
+ * @brief      Memory management fault handler.			
+ * @param[in]  None	
+ * @param[out] None  	
+ * @retval     None
+ *		
+ * @par Description
+ * @details    This is memory management fault handler.A data access within the
+ *             stack guard of the running task,or an exception frame pushed over
+ *             it,is reported to CoStkOverflowHook().
+ *******************************************************************************
+ */
+void MemManage_Handler(void)
+{
+    U32 guard;
+    U32 addr;
+    U8  status;
+    
+    status = NVIC_MMFSR;
+    MPU_RNR = STK_GUARD_REGION;         /* Get guard of running task          */
+    guard  = MPU_RBAR & ~(U32)(STK_GUARD_SIZE-1);
+    
+    if(status & 0x80)                   /* Is fault address valid?            */
     {
-        if(DlyList->delayTick > 1)  /* Delay time > 1?                        */
+        addr = NVIC_MMFAR;
+        if((addr >= guard) && (addr < guard+STK_GUARD_SIZE))
         {
-			DlyList->delayTick--;   /* Decrease delay time of the list head.  */
+            CoStkOverflowHook(TCBRunning->taskID);
         }
-		else
-		{
-			DlyList->delayTick = 0;
-			isr_TimeDispose();       /* Call hander for delay time list        */
-		}
     }
-#endif
-
-#if CFG_TMR_EN > 0	
-    if(TmrList != NULL)             /* Have timer in working?                 */
+    else if(status & 0x10)              /* Is exception frame not pushed?     */
     {
-        if(TmrList->tmrCnt > 1)     /* Timer time > 1?                        */
+        __asm volatile (" MRS %0,PSP \n" : "=r" (addr));
+        if((addr < guard+STK_GUARD_SIZE) && (addr+32 > guard))
         {
-			TmrList->tmrCnt--;      /* Decrease timer time of the list head.  */
+            CoStkOverflowHook(TCBRunning->taskID);
         }
-		else
-		{
-			TmrList->tmrCnt = 0;
-			isr_TmrDispose();         /* Call hander for timer list             */
-		}
-    }	
-#endif
-	TaskSchedReq = TRUE;
-    OsSchedUnlock();
+    }
+    for(;;)                             /* Other MPU violation                */
+    {
+    }
 }
+#endif
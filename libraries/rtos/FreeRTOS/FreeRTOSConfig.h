@@ -75,6 +75,12 @@
 #define configTICK_RATE_HZ                         ( ( portTickType ) 1000 )
 #define configMINIMAL_STACK_SIZE                   ( ( unsigned short ) 70 )
 //#define configTOTAL_HEAP_SIZE                      ( ( size_t ) ( 0x2C00-600 ) )
+/* heap_4.c: size classes kept in fast bins, and heap placed in the PSRAM */
+//#define configHEAP_FAST_BIN_COUNT                  8
+//#define configHEAP_BASE_ADDRESS                    0x61000000
+/* heap_tlsf.c: constant time TLSF allocator of libraries/rtos/tlsf, with the
+same configHEAP_BASE_ADDRESS option; TLSF_FL_MAX_LOG2 (compiler option) must
+cover configTOTAL_HEAP_SIZE */
 #define configMAX_TASK_NAME_LEN                    ( 16 )
 #define configUSE_TRACE_FACILITY                   1
 #define configUSE_16_BIT_TICKS                     0
@@ -82,10 +88,49 @@
 #define configUSE_CO_ROUTINES                      0
 #define configUSE_MUTEXES                          1
 #define configUSE_RECURSIVE_MUTEXES                0
-#define configCHECK_FOR_STACK_OVERFLOW             2
+
+/* MPU stack guard, ARM_CM3_MPU port only: a no access MPU region at the
+bottom of the stack of the running task, programmed at each context switch,
+faults on the first access past the stack.  The MemManage handler of the port,
+vPortMemManageHandler(), reports the task with configSTACK_GUARD_FAULT(), here
+through the watchdog supervisor post-mortem record and a reset.  The stack
+checks at each context switch are then not needed. */
+#define configUSE_MPU_STACK_GUARD                  0
+
+#if ( configUSE_MPU_STACK_GUARD == 1 )
+	#define configCHECK_FOR_STACK_OVERFLOW         0
+	#ifndef __IAR_SYSTEMS_ASM__
+		#include "wdt.h"
+	#endif
+	#define configSTACK_GUARD_FAULT( xTask, ulAddress )   WDT_SupervisorFault( ( uint32_t ) ( xTask ) & 0xFFFF, ( ulAddress ) )
+	#define vPortMemManageHandler                      MemManage_Handler
+#else
+	#define configCHECK_FOR_STACK_OVERFLOW         2
+#endif
 
 #define configGENERATE_RUN_TIME_STATS              0
 
+/* Tickless idle: stop the tick and sleep in the idle task when no task is due
+to run for at least configEXPECTED_IDLE_TIME_BEFORE_SLEEP ticks.  The SAM3S
+low power layer is drivers/Source/tickless_idle.c, it uses the RTT. */
+#define configUSE_TICKLESS_IDLE                    1
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP      2
+
+/* Task profiler: CPU time, switch count and stack margin of each task, sent
+by TASKPROF_Dump() and decoded by libraries/rtos/taskprof/taskprof.py.  The
+application calls TASKPROF_Initialize() before creating its tasks. */
+#define configUSE_TASK_PROFILER                    0
+
+#if ( configUSE_TASK_PROFILER == 1 )
+	#ifndef __IAR_SYSTEMS_ASM__
+		#include "../taskprof/taskprof.h"
+	#endif
+	#define traceTASK_CREATE( pxNewTCB )   TASKPROF_AddTask( ( pxNewTCB ), ( const char * ) ( pxNewTCB )->pcTaskName, uxTaskNumber - 1, \
+	                                                         ( const uint32_t * ) ( pxNewTCB )->pxStack, usStackDepth, 0xa5a5a5a5UL )
+	#define traceTASK_DELETE( pxTCB )      TASKPROF_RemoveTask( ( pxTCB ) )
+	#define traceTASK_SWITCHED_IN()        TASKPROF_SwitchTo( pxCurrentTCB )
+#endif
+
 #define configMAX_PRIORITIES                       ( ( unsigned portBASE_TYPE ) 5 )
 #define configMAX_CO_ROUTINE_PRIORITIES            ( 2 )
 #define configQUEUE_REGISTRY_SIZE                  10
@@ -181,9 +181,10 @@ typedef portBASE_TYPE (*pdTASK_HOOK_CODE)( void * );
 	#define INCLUDE_xTaskGetSchedulerState 0
 #endif
 
-#if ( configUSE_MUTEXES == 1 )
+#if ( configUSE_MUTEXES == 1 ) || ( configUSE_MPU_STACK_GUARD == 1 )
 	/* xTaskGetCurrentTaskHandle is used by the priority inheritance mechanism
-	within the mutex implementation so must be available if mutexes are used. */
+	within the mutex implementation so must be available if mutexes are used.
+	The MPU stack guard reports the task which hit its guard with it. */
 	#undef INCLUDE_xTaskGetCurrentTaskHandle
 	#define INCLUDE_xTaskGetCurrentTaskHandle 1
 #else
@@ -258,6 +259,10 @@ typedef portBASE_TYPE (*pdTASK_HOOK_CODE)( void * );
 	#define configCHECK_FOR_STACK_OVERFLOW 0
 #endif
 
+#ifndef configUSE_MPU_STACK_GUARD
+	#define configUSE_MPU_STACK_GUARD 0
+#endif
+
 /* The following event macros are embedded in the kernel API calls. */
 
 #ifndef traceQUEUE_CREATE	
@@ -416,5 +421,21 @@ typedef portBASE_TYPE (*pdTASK_HOOK_CODE)( void * );
 	#define vPortFreeAligned( pvBlockToFree ) vPortFree( pvBlockToFree )
 #endif
 
+#ifndef configUSE_TICKLESS_IDLE
+	#define configUSE_TICKLESS_IDLE 0
+#endif
+
+#ifndef configEXPECTED_IDLE_TIME_BEFORE_SLEEP
+	#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP 2
+#endif
+
+#if configEXPECTED_IDLE_TIME_BEFORE_SLEEP < 2
+	#error configEXPECTED_IDLE_TIME_BEFORE_SLEEP must not be less than 2
+#endif
+
+#ifndef portSUPPRESS_TICKS_AND_SLEEP
+	#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime )
+#endif
+
 #endif /* INC_FREERTOS_H */
 
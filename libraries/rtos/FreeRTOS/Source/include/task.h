@@ -1145,6 +1145,31 @@ portBASE_TYPE xTaskCallApplicationTaskHook( xTaskHandle xTask, void *pvParameter
  */
 void vTaskIncrementTick( void ) PRIVILEGED_FUNCTION;
 
+/*
+ * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS AN
+ * INTERFACE WHICH IS FOR THE EXCLUSIVE USE OF THE SCHEDULER.
+ *
+ * THIS FUNCTION MUST BE CALLED WITH THE SCHEDULER SUSPENDED.
+ *
+ * Only available when configUSE_TICKLESS_IDLE is 1.  Called by the portable
+ * layer from portSUPPRESS_TICKS_AND_SLEEP() to correct the tick count for
+ * the xTicksToJump ticks during which the tick interrupt was stopped.
+ */
+void vTaskStepTick( portTickType xTicksToJump ) PRIVILEGED_FUNCTION;
+
+/*
+ * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS AN
+ * INTERFACE WHICH IS FOR THE EXCLUSIVE USE OF THE SCHEDULER.
+ *
+ * THIS FUNCTION MUST BE CALLED WITH INTERRUPTS DISABLED.
+ *
+ * Only available when configUSE_TICKLESS_IDLE is 1.  Called by the portable
+ * layer from portSUPPRESS_TICKS_AND_SLEEP() just before sleeping, returns
+ * pdFALSE when an interrupt readied a task in the meantime, in which case
+ * the processor must not sleep.
+ */
+portBASE_TYPE xTaskConfirmSleepModeStatus( void ) PRIVILEGED_FUNCTION;
+
 /*
  * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS AN
  * INTERFACE WHICH IS FOR THE EXCLUSIVE USE OF THE SCHEDULER.
@@ -69,18 +69,27 @@ FreeRTOS.org versions prior to V4.4.0 did not include this definition. */
 /* Constants required to manipulate the NVIC. */
 #define portNVIC_SYSTICK_CTRL		( ( volatile unsigned long *) 0xe000e010 )
 #define portNVIC_SYSTICK_LOAD		( ( volatile unsigned long *) 0xe000e014 )
+#define portNVIC_SYSTICK_CURRENT	( ( volatile unsigned long *) 0xe000e018 )
 #define portNVIC_INT_CTRL			( ( volatile unsigned long *) 0xe000ed04 )
 #define portNVIC_SYSPRI2			( ( volatile unsigned long *) 0xe000ed20 )
 #define portNVIC_SYSTICK_CLK		0x00000004
 #define portNVIC_SYSTICK_INT		0x00000002
 #define portNVIC_SYSTICK_ENABLE		0x00000001
 #define portNVIC_PENDSVSET			0x10000000
+#define portNVIC_PENDSTSET			0x04000000
 #define portNVIC_PENDSV_PRI			( ( ( unsigned long ) configKERNEL_INTERRUPT_PRIORITY ) << 16 )
 #define portNVIC_SYSTICK_PRI		( ( ( unsigned long ) configKERNEL_INTERRUPT_PRIORITY ) << 24 )
 
 /* Constants required to set up the initial stack. */
 #define portINITIAL_XPSR			( 0x01000000 )
 
+/* Constants required by the tickless idle.  The sleep length is handled in
+microseconds, the longest sleep is kept well within an unsigned long. */
+#define portSYSTICK_RELOAD			( ( configCPU_CLOCK_HZ / configTICK_RATE_HZ ) - 1UL )
+#define portCYCLES_PER_US			( configCPU_CLOCK_HZ / 1000000UL )
+#define portUS_PER_TICK				( 1000000UL / configTICK_RATE_HZ )
+#define portMAX_TICKLESS_TICKS		( ( portTickType ) ( 0x7fffffffUL / portUS_PER_TICK ) )
+
 /* The priority used by the kernel is assigned to a variable to make access
 from inline assembler easier. */
 const unsigned long ulKernelPriority = configKERNEL_INTERRUPT_PRIORITY;
@@ -94,6 +103,17 @@ static unsigned portBASE_TYPE uxCriticalNesting = 0xaaaaaaaa;
  */
 static void prvSetupTimerInterrupt( void );
 
+/*
+ * Low power layer of the tickless idle, provided by the chip support (see
+ * drivers/Source/tickless_idle.c for the SAM3S).  Sleeps for at most ulSleepUs
+ * microseconds, less when an interrupt wakes the processor up, and returns
+ * the time actually slept, measured with a timer that keeps running in the
+ * low power modes.  Called with interrupts disabled.
+ */
+#if configUSE_TICKLESS_IDLE == 1
+	extern unsigned long ulPortLowPowerSleep( unsigned long ulSleepUs );
+#endif
+
 /*
  * Exception handlers.
  */
@@ -267,6 +287,66 @@ unsigned long ulDummy;
 }
 /*-----------------------------------------------------------*/
 
+#if configUSE_TICKLESS_IDLE == 1
+
+/*
+ * Called by the idle task, with the scheduler suspended, when no task is due
+ * to run for xExpectedIdleTime ticks.  SysTick is stopped and the low power
+ * layer sleeps until the next wake time or an earlier interrupt.  The tick
+ * count is then corrected by the time actually slept, and SysTick restarts
+ * with a first period shortened by the part of a tick already elapsed, so that
+ * the following ticks keep their phase.
+ */
+void vPortSuppressTicksAndSleep( portTickType xExpectedIdleTime )
+{
+unsigned long ulElapsedUs, ulSleptUs;
+portTickType xCompleteTicks;
+
+	if( xExpectedIdleTime > portMAX_TICKLESS_TICKS )
+	{
+		xExpectedIdleTime = portMAX_TICKLESS_TICKS;
+	}
+
+	/* Interrupts still wake the processor up, they are served once the tick
+	has been restarted. */
+	__asm volatile( "cpsid i" );
+
+	*(portNVIC_SYSTICK_CTRL) = portNVIC_SYSTICK_CLK | portNVIC_SYSTICK_INT;
+
+	/* Do not sleep if a tick is pending or if a task was readied since the
+	idle time was computed, just let SysTick go on. */
+	if( ( ( *(portNVIC_INT_CTRL) & portNVIC_PENDSTSET ) != 0 ) || ( xTaskConfirmSleepModeStatus() == pdFALSE ) )
+	{
+		*(portNVIC_SYSTICK_CTRL) = portNVIC_SYSTICK_CLK | portNVIC_SYSTICK_INT | portNVIC_SYSTICK_ENABLE;
+		__asm volatile( "cpsie i" );
+		return;
+	}
+
+	/* Part of the current tick period already elapsed. */
+	ulElapsedUs = ( portSYSTICK_RELOAD - *(portNVIC_SYSTICK_CURRENT) ) / portCYCLES_PER_US;
+
+	ulSleptUs = ulPortLowPowerSleep( ( ( unsigned long ) xExpectedIdleTime * portUS_PER_TICK ) - ulElapsedUs ) + ulElapsedUs;
+
+	xCompleteTicks = ( portTickType ) ( ulSleptUs / portUS_PER_TICK );
+
+	/* Restart SysTick for the rest of the current period, the normal reload
+	value is taken at the end of that period. */
+	*(portNVIC_SYSTICK_LOAD) = ( ( portUS_PER_TICK - ( ulSleptUs % portUS_PER_TICK ) ) * portCYCLES_PER_US ) - 1UL;
+	*(portNVIC_SYSTICK_CURRENT) = 0;
+	*(portNVIC_SYSTICK_CTRL) = portNVIC_SYSTICK_CLK | portNVIC_SYSTICK_INT | portNVIC_SYSTICK_ENABLE;
+	*(portNVIC_SYSTICK_LOAD) = portSYSTICK_RELOAD;
+
+	if( xCompleteTicks > ( portTickType ) 0 )
+	{
+		vTaskStepTick( xCompleteTicks );
+	}
+
+	__asm volatile( "cpsie i" );
+}
+
+#endif /* configUSE_TICKLESS_IDLE */
+/*-----------------------------------------------------------*/
+
 /*
  * Setup the systick timer to generate the tick interrupts at the required
  * frequency.
@@ -274,7 +354,7 @@ unsigned long ulDummy;
 void prvSetupTimerInterrupt( void )
 {
 	/* Configure SysTick to interrupt at the requested rate. */
-	*(portNVIC_SYSTICK_LOAD) = ( configCPU_CLOCK_HZ / configTICK_RATE_HZ ) - 1UL;
+	*(portNVIC_SYSTICK_LOAD) = portSYSTICK_RELOAD;
 	*(portNVIC_SYSTICK_CTRL) = portNVIC_SYSTICK_CLK | portNVIC_SYSTICK_INT | portNVIC_SYSTICK_ENABLE;
 }
 /*-----------------------------------------------------------*/
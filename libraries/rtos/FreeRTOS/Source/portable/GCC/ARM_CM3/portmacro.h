@@ -102,6 +102,12 @@ extern void vPortYieldFromISR( void );
 #define portEND_SWITCHING_ISR( xSwitchRequired ) if( xSwitchRequired ) vPortYieldFromISR()
 /*-----------------------------------------------------------*/
 
+/* Tickless idle, used when configUSE_TICKLESS_IDLE is 1. */
+extern void vPortSuppressTicksAndSleep( portTickType xExpectedIdleTime );
+
+#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) vPortSuppressTicksAndSleep( xExpectedIdleTime )
+/*-----------------------------------------------------------*/
+
 
 /* Critical section management. */
 
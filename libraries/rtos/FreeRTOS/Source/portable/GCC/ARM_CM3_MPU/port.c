@@ -74,9 +74,14 @@ task.h is included from an application file. */
 #define portNVIC_SYSPRI1						( ( volatile unsigned long * ) 0xe000ed1c )
 #define portNVIC_SYS_CTRL_STATE					( ( volatile unsigned long * ) 0xe000ed24 )
 #define portNVIC_MEM_FAULT_ENABLE				( 1UL << 16UL )
+#define portNVIC_MMFSR							( ( volatile unsigned char * ) 0xe000ed28 )
+#define portNVIC_MMFAR							( ( volatile unsigned long * ) 0xe000ed34 )
+#define portMMFSR_MMARVALID						( 0x80UL )
+#define portMMFSR_MSTKERR						( 0x10UL )
 
 /* Constants required to access and manipulate the MPU. */
 #define portMPU_TYPE							( ( volatile unsigned long * ) 0xe000ed90 )
+#define portMPU_REGION_NUMBER					( ( volatile unsigned long * ) 0xe000ed98 )
 #define portMPU_REGION_BASE_ADDRESS				( ( volatile unsigned long * ) 0xe000ed9C )
 #define portMPU_REGION_ATTRIBUTE				( ( volatile unsigned long * ) 0xe000edA0 )
 #define portMPU_CTRL							( ( volatile unsigned long * ) 0xe000ed94 )
@@ -105,6 +110,13 @@ task.h is included from an application file. */
 /* Offsets in the stack to the parameters when inside the SVC handler. */
 #define portOFFSET_TO_PC						( 6 )
 
+/* Called with the task and the faulting address when a task hits its stack
+guard. */
+#if( configUSE_MPU_STACK_GUARD == 1 ) && !defined( configSTACK_GUARD_FAULT )
+	#define configSTACK_GUARD_FAULT( xTask, ulAddress )	vApplicationStackOverflowHook( ( xTaskHandle * ) ( xTask ), NULL )
+	extern void vApplicationStackOverflowHook( xTaskHandle *pxTask, signed char *pcTaskName );
+#endif
+
 /* Set the privilege level to user mode if xRunningPrivileged is false. */
 #define portRESET_PRIVILEGE( xRunningPrivileged ) if( xRunningPrivileged != pdTRUE ) __asm volatile ( " mrs r0, control \n orr r0, #1 \n msr control, r0" :::"r0" )
 
@@ -143,6 +155,9 @@ static portBASE_TYPE prvRaisePrivilege( void ) __attribute__(( naked ));
 void xPortPendSVHandler( void ) __attribute__ (( naked )) PRIVILEGED_FUNCTION;
 void xPortSysTickHandler( void )  __attribute__ ((optimize("3"))) PRIVILEGED_FUNCTION;
 void vPortSVCHandler( void ) __attribute__ (( naked )) PRIVILEGED_FUNCTION;
+#if( configUSE_MPU_STACK_GUARD == 1 )
+	void vPortMemManageHandler( void ) PRIVILEGED_FUNCTION;
+#endif
 
 /*
  * Starts the scheduler by restoring the context of the first task to run.
@@ -641,9 +656,69 @@ unsigned long ul;
 			lIndex++;
 		}
 	}
+
+	#if( configUSE_MPU_STACK_GUARD == 1 )
+	{
+		/* Define the no access region at the bottom of the stack, on the
+		first guard aligned address within the stack.  Like the stack region it
+		is only set up when the task is created. */
+		if( usStackDepth > 0 )
+		{
+			ul = portTOTAL_NUM_REGIONS - 1;
+
+			xMPUSettings->xRegion[ ul ].ulRegionBaseAddress =
+					( ( ( unsigned long ) pxBottomOfStack + portSTACK_GUARD_SIZE - 1UL ) & ~( portSTACK_GUARD_SIZE - 1UL ) ) |
+					( portMPU_REGION_VALID ) |
+					( portSTACK_GUARD_REGION );
+
+			xMPUSettings->xRegion[ ul ].ulRegionAttribute =
+					( portMPU_REGION_EXECUTE_NEVER ) | /* No access, privileged or not. */
+					( prvGetMPURegionSizeSetting( portSTACK_GUARD_SIZE ) ) |
+					( portMPU_REGION_ENABLE );
+		}
+	}
+	#endif
 }
 /*-----------------------------------------------------------*/
 
+#if( configUSE_MPU_STACK_GUARD == 1 )
+
+	void vPortMemManageHandler( void )
+	{
+	unsigned long ulStatus, ulGuard, ulAddress = 0;
+	portBASE_TYPE xOverflow = pdFALSE;
+
+		ulStatus = *portNVIC_MMFSR;
+
+		/* The guard of the running task is in the MPU. */
+		*portMPU_REGION_NUMBER = portSTACK_GUARD_REGION;
+		ulGuard = *portMPU_REGION_BASE_ADDRESS & ~( portSTACK_GUARD_SIZE - 1UL );
+
+		if( ( ulStatus & portMMFSR_MMARVALID ) != 0 )
+		{
+			/* A data access within the guard. */
+			ulAddress = *portNVIC_MMFAR;
+			xOverflow = ( ulAddress >= ulGuard ) && ( ulAddress < ulGuard + portSTACK_GUARD_SIZE );
+		}
+		else if( ( ulStatus & portMMFSR_MSTKERR ) != 0 )
+		{
+			/* The 8 word exception frame, pushed at psp, overlaps the guard. */
+			__asm volatile ( "	mrs %0, psp		\n" : "=r" ( ulAddress ) );
+			xOverflow = ( ulAddress < ulGuard + portSTACK_GUARD_SIZE ) && ( ulAddress + 32UL > ulGuard );
+		}
+
+		if( xOverflow != pdFALSE )
+		{
+			configSTACK_GUARD_FAULT( xTaskGetCurrentTaskHandle(), ulAddress );
+		}
+
+		/* Another MPU violation, or the hook returned. */
+		for( ;; );
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
 signed portBASE_TYPE MPU_xTaskGenericCreate( pdTASK_CODE pvTaskCode, const signed char * const pcName, unsigned short usStackDepth, void *pvParameters, unsigned portBASE_TYPE uxPriority, xTaskHandle *pxCreatedTask, portSTACK_TYPE *puxStackBuffer, const xMemoryRegion * const xRegions )
 {
 signed portBASE_TYPE xReturn;
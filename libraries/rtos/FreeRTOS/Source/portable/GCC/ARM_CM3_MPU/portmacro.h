@@ -104,9 +104,20 @@ extern "C" {
 #define portGENERAL_PERIPHERALS_REGION		( 3UL )
 #define portSTACK_REGION					( 4UL )
 #define portFIRST_CONFIGURABLE_REGION	    ( 5UL )
-#define portLAST_CONFIGURABLE_REGION		( 7UL )
-#define portNUM_CONFIGURABLE_REGIONS		( ( portLAST_CONFIGURABLE_REGION - portFIRST_CONFIGURABLE_REGION ) + 1 )
-#define portTOTAL_NUM_REGIONS				( portNUM_CONFIGURABLE_REGIONS + 1 ) /* Plus one to make space for the stack region. */
+#if( configUSE_MPU_STACK_GUARD == 1 )
+	/* The guard takes the last region, which has the highest priority, so
+	that it overrides the stack and RAM regions, and the privileged default
+	memory map. */
+	#define portLAST_CONFIGURABLE_REGION	( 6UL )
+	#define portSTACK_GUARD_REGION			( 7UL )
+	#define portSTACK_GUARD_SIZE			( 32UL )
+	#define portNUM_CONFIGURABLE_REGIONS	( ( portLAST_CONFIGURABLE_REGION - portFIRST_CONFIGURABLE_REGION ) + 1 )
+	#define portTOTAL_NUM_REGIONS			( portNUM_CONFIGURABLE_REGIONS + 2 ) /* Plus the stack and the stack guard regions. */
+#else
+	#define portLAST_CONFIGURABLE_REGION	( 7UL )
+	#define portNUM_CONFIGURABLE_REGIONS	( ( portLAST_CONFIGURABLE_REGION - portFIRST_CONFIGURABLE_REGION ) + 1 )
+	#define portTOTAL_NUM_REGIONS			( portNUM_CONFIGURABLE_REGIONS + 1 ) /* Plus one to make space for the stack region. */
+#endif
 
 #define portSWITCH_TO_USER_MODE() __asm volatile ( " mrs r0, control \n orr r0, #1 \n msr control, r0 " :::"r0" )
 
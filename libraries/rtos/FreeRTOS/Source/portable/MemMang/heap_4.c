@@ -0,0 +1,485 @@
+/*
+    FreeRTOS V6.0.5 - Copyright (C) 2010 Real Time Engineers Ltd.
+
+    ***************************************************************************
+    *                                                                         *
+    * If you are:                                                             *
+    *                                                                         *
+    *    + New to FreeRTOS,                                                   *
+    *    + Wanting to learn FreeRTOS or multitasking in general quickly       *
+    *    + Looking for basic training,                                        *
+    *    + Wanting to improve your FreeRTOS skills and productivity           *
+    *                                                                         *
+    * then take a look at the FreeRTOS eBook                                  *
+    *                                                                         *
+    *        "Using the FreeRTOS Real Time Kernel - a Practical Guide"        *
+    *                  http://www.FreeRTOS.org/Documentation                  *
+    *                                                                         *
+    * A pdf reference manual is also available.  Both are usually delivered   *
+    * to your inbox within 20 minutes to two hours when purchased between 8am *
+    * and 8pm GMT (although please allow up to 24 hours in case of            *
+    * exceptional circumstances).  Thank you for your support!                *
+    *                                                                         *
+    ***************************************************************************
+
+    This file is part of the FreeRTOS distribution.
+
+    FreeRTOS is free software; you can redistribute it and/or modify it under
+    the terms of the GNU General Public License (version 2) as published by the
+    Free Software Foundation AND MODIFIED BY the FreeRTOS exception.
+    ***NOTE*** The exception to the GPL is included to allow you to distribute
+    a combined work that includes FreeRTOS without being obliged to provide the
+    source code for proprietary components outside of the FreeRTOS kernel.
+    FreeRTOS is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+    more details. You should have received a copy of the GNU General Public 
+    License and the FreeRTOS license exception along with FreeRTOS; if not it 
+    can be viewed here: http://www.freertos.org/a00114.html and also obtained 
+    by writing to Richard Barry, contact details for whom are available on the
+    FreeRTOS WEB site.
+
+    1 tab == 4 spaces!
+
+    http://www.FreeRTOS.org - Documentation, latest information, license and
+    contact details.
+
+    http://www.SafeRTOS.com - A version that is certified for use in safety
+    critical systems.
+
+    http://www.OpenRTOS.com - Commercial support, development, porting,
+    licensing and training services.
+*/
+
+/*
+ * A sample implementation of pvPortMalloc() and vPortFree() that combines
+ * adjacent free blocks, so that a long running application creating and
+ * deleting buffers of various sizes does not end up with a fragmented heap.
+ *
+ * The free blocks are kept in a single list ordered by address: a block being
+ * freed is merged with the free blocks just before and just after it, and an
+ * allocation takes the first block large enough.  Small blocks, up to
+ * configHEAP_FAST_BIN_COUNT size classes, are not merged when freed but kept
+ * in one list per exact size (the fast bins), so that allocating and freeing
+ * them is done in constant time.  The fast bins are given back to the address
+ * ordered list, and merged, when an allocation cannot be satisfied otherwise.
+ *
+ * By default the heap is a static array of configTOTAL_HEAP_SIZE bytes.  When
+ * configHEAP_BASE_ADDRESS is defined in FreeRTOSConfig.h the heap is the
+ * configTOTAL_HEAP_SIZE bytes at that address instead, for instance the
+ * external PSRAM of the SAM3S-EK at 0x61000000.  The memory must then be
+ * usable before the first allocation, that is BOARD_ConfigurePSRAM( SMC ) must
+ * be called before any task, queue or semaphore is created.
+ *
+ * xPortGetFreeHeapSize(), xPortGetMinimumEverFreeHeapSize() and
+ * xPortGetLargestFreeBlockSize() report the heap usage.
+ *
+ * See heap_1.c, heap_2.c and heap_3.c for alternative implementations, and the
+ * memory management pages of http://www.FreeRTOS.org for more information.
+ */
+#include <stdlib.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+/* Number of fast bins, 0 to merge every freed block.  Bin n holds the free
+blocks of exactly heapMINIMUM_BLOCK_SIZE + ( n * portBYTE_ALIGNMENT ) bytes,
+header included. */
+#ifndef configHEAP_FAST_BIN_COUNT
+	#define configHEAP_FAST_BIN_COUNT	8
+#endif
+
+#ifdef configHEAP_BASE_ADDRESS
+
+	/* The heap is provided by the application, aligned on portBYTE_ALIGNMENT. */
+	#define heapADDRESS		( ( unsigned char * ) ( configHEAP_BASE_ADDRESS ) )
+
+#else
+
+	/* Allocate the memory for the heap.  The struct is used to force byte
+	alignment without using any non-portable code. */
+	static union xRTOS_HEAP
+	{
+		#if portBYTE_ALIGNMENT == 8
+			volatile portDOUBLE dDummy;
+		#else
+			volatile unsigned long ulDummy;
+		#endif
+		unsigned char ucHeap[ configTOTAL_HEAP_SIZE ];
+	} xHeap;
+
+	#define heapADDRESS		( xHeap.ucHeap )
+
+#endif
+
+/* Define the linked list structure.  This is used to link free blocks in order
+of their address. */
+typedef struct A_BLOCK_LINK
+{
+	struct A_BLOCK_LINK *pxNextFreeBlock;	/*<< The next free block in the list. */
+	size_t xBlockSize;						/*<< The size of the block, header included. */
+} xBlockLink;
+
+#define heapSTRUCT_SIZE			( ( sizeof( xBlockLink ) + portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK ) )
+#define heapMINIMUM_BLOCK_SIZE	( ( size_t ) ( heapSTRUCT_SIZE * 2 ) )
+#define heapTOTAL_SIZE			( ( size_t ) configTOTAL_HEAP_SIZE & ~( ( size_t ) portBYTE_ALIGNMENT_MASK ) )
+
+/* The top bit of xBlockSize is set while the block is allocated. */
+#define heapALLOCATED_BIT		( ( size_t ) 1 << ( ( sizeof( size_t ) * 8 ) - 1 ) )
+
+/* Largest block size kept in the fast bins, and bin of a block size. */
+#define heapFAST_BIN_MAX_SIZE	( heapMINIMUM_BLOCK_SIZE + ( ( size_t ) ( configHEAP_FAST_BIN_COUNT - 1 ) * portBYTE_ALIGNMENT ) )
+#define heapFAST_BIN_INDEX( xSize )	( ( ( xSize ) - heapMINIMUM_BLOCK_SIZE ) / portBYTE_ALIGNMENT )
+
+/* Start of the list of free blocks, ordered by address and ended by NULL. */
+static xBlockLink xStart;
+
+#if configHEAP_FAST_BIN_COUNT > 0
+
+	/* Free small blocks, one list per size. */
+	static xBlockLink *pxFastBins[ configHEAP_FAST_BIN_COUNT ];
+
+#endif
+
+/* Keeps track of the number of free bytes remaining, fast bins included, and
+of its lowest value. */
+static size_t xFreeBytesRemaining = heapTOTAL_SIZE;
+static size_t xMinimumEverFreeBytesRemaining = heapTOTAL_SIZE;
+
+static portBASE_TYPE xHeapHasBeenInitialised = pdFALSE;
+
+/*
+ * Create the single free block covering the whole heap.
+ */
+static void prvHeapInit( void );
+
+/*
+ * Insert a block into the list of free blocks, merging it with the free blocks
+ * it is contiguous with.
+ */
+static void prvInsertBlockIntoFreeList( xBlockLink *pxBlockToInsert );
+
+/*
+ * Take the first free block of at least xWantedSize bytes out of the list,
+ * splitting off what is not needed.  Returns NULL when there is none.
+ */
+static xBlockLink *prvAllocateFromFreeList( size_t xWantedSize );
+
+/*
+ * Give the blocks of the fast bins back to the list of free blocks.  Returns
+ * pdFALSE if the fast bins were empty.
+ */
+#if configHEAP_FAST_BIN_COUNT > 0
+	static portBASE_TYPE prvFlushFastBins( void );
+#endif
+
+/*-----------------------------------------------------------*/
+
+void *pvPortMalloc( size_t xWantedSize )
+{
+xBlockLink *pxBlock = NULL;
+void *pvReturn = NULL;
+
+	vTaskSuspendAll();
+	{
+		/* If this is the first call to malloc then the heap will require
+		initialisation to setup the list of free blocks. */
+		if( xHeapHasBeenInitialised == pdFALSE )
+		{
+			prvHeapInit();
+			xHeapHasBeenInitialised = pdTRUE;
+		}
+
+		if( ( xWantedSize > 0 ) && ( xWantedSize < heapTOTAL_SIZE ) )
+		{
+			/* The wanted size is increased so it can contain a xBlockLink
+			structure in addition to the requested amount of bytes, and so
+			that blocks are always aligned to the required number of bytes. */
+			xWantedSize += heapSTRUCT_SIZE;
+			if( xWantedSize & portBYTE_ALIGNMENT_MASK )
+			{
+				xWantedSize += ( portBYTE_ALIGNMENT - ( xWantedSize & portBYTE_ALIGNMENT_MASK ) );
+			}
+
+			if( xWantedSize < heapMINIMUM_BLOCK_SIZE )
+			{
+				xWantedSize = heapMINIMUM_BLOCK_SIZE;
+			}
+
+			#if configHEAP_FAST_BIN_COUNT > 0
+			{
+				/* A free block of the exact size is at hand. */
+				if( xWantedSize <= heapFAST_BIN_MAX_SIZE )
+				{
+					pxBlock = pxFastBins[ heapFAST_BIN_INDEX( xWantedSize ) ];
+					if( pxBlock != NULL )
+					{
+						pxFastBins[ heapFAST_BIN_INDEX( xWantedSize ) ] = pxBlock->pxNextFreeBlock;
+					}
+				}
+			}
+			#endif
+
+			if( pxBlock == NULL )
+			{
+				pxBlock = prvAllocateFromFreeList( xWantedSize );
+
+				#if configHEAP_FAST_BIN_COUNT > 0
+				{
+					/* Merge the small free blocks and try again. */
+					if( ( pxBlock == NULL ) && ( prvFlushFastBins() != pdFALSE ) )
+					{
+						pxBlock = prvAllocateFromFreeList( xWantedSize );
+					}
+				}
+				#endif
+			}
+
+			if( pxBlock != NULL )
+			{
+				xFreeBytesRemaining -= pxBlock->xBlockSize;
+				if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+				{
+					xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+				}
+
+				pxBlock->xBlockSize |= heapALLOCATED_BIT;
+				pxBlock->pxNextFreeBlock = NULL;
+
+				/* Return the memory space - jumping over the xBlockLink
+				structure at its start. */
+				pvReturn = ( void * ) ( ( ( unsigned char * ) pxBlock ) + heapSTRUCT_SIZE );
+			}
+		}
+	}
+	xTaskResumeAll();
+
+	#if( configUSE_MALLOC_FAILED_HOOK == 1 )
+	{
+		if( pvReturn == NULL )
+		{
+			extern void vApplicationMallocFailedHook( void );
+			vApplicationMallocFailedHook();
+		}
+	}
+	#endif
+
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void *pv )
+{
+xBlockLink *pxLink;
+
+	if( pv )
+	{
+		/* The memory being freed will have an xBlockLink structure immediately
+		before it.  This casting is to keep the compiler from issuing
+		warnings. */
+		pxLink = ( void * ) ( ( ( unsigned char * ) pv ) - heapSTRUCT_SIZE );
+
+		vTaskSuspendAll();
+		{
+			/* A block freed twice is ignored. */
+			if( ( pxLink->xBlockSize & heapALLOCATED_BIT ) != 0 )
+			{
+				pxLink->xBlockSize &= ~heapALLOCATED_BIT;
+				xFreeBytesRemaining += pxLink->xBlockSize;
+
+				#if configHEAP_FAST_BIN_COUNT > 0
+					if( pxLink->xBlockSize <= heapFAST_BIN_MAX_SIZE )
+					{
+						pxLink->pxNextFreeBlock = pxFastBins[ heapFAST_BIN_INDEX( pxLink->xBlockSize ) ];
+						pxFastBins[ heapFAST_BIN_INDEX( pxLink->xBlockSize ) ] = pxLink;
+					}
+					else
+				#endif
+					{
+						prvInsertBlockIntoFreeList( pxLink );
+					}
+			}
+		}
+		xTaskResumeAll();
+	}
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+	return xFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+	return xMinimumEverFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetLargestFreeBlockSize( void )
+{
+xBlockLink *pxBlock;
+size_t xLargest = 0;
+
+	vTaskSuspendAll();
+	{
+		if( xHeapHasBeenInitialised == pdFALSE )
+		{
+			xLargest = heapTOTAL_SIZE;
+		}
+
+		for( pxBlock = xStart.pxNextFreeBlock; pxBlock != NULL; pxBlock = pxBlock->pxNextFreeBlock )
+		{
+			if( pxBlock->xBlockSize > xLargest )
+			{
+				xLargest = pxBlock->xBlockSize;
+			}
+		}
+
+		#if configHEAP_FAST_BIN_COUNT > 0
+		{
+		unsigned portBASE_TYPE uxBin;
+
+			for( uxBin = 0; uxBin < configHEAP_FAST_BIN_COUNT; uxBin++ )
+			{
+				if( ( pxFastBins[ uxBin ] != NULL ) && ( pxFastBins[ uxBin ]->xBlockSize > xLargest ) )
+				{
+					xLargest = pxFastBins[ uxBin ]->xBlockSize;
+				}
+			}
+		}
+		#endif
+	}
+	xTaskResumeAll();
+
+	/* Report the largest allocation that can be satisfied. */
+	return ( xLargest > heapSTRUCT_SIZE ) ? ( xLargest - heapSTRUCT_SIZE ) : 0;
+}
+/*-----------------------------------------------------------*/
+
+void vPortInitialiseBlocks( void )
+{
+	/* This just exists to keep the linker quiet. */
+}
+/*-----------------------------------------------------------*/
+
+static void prvHeapInit( void )
+{
+xBlockLink *pxFirstFreeBlock;
+
+	/* To start with there is a single free block that is sized to take up the
+	entire heap space.  The void cast is used to prevent compiler warnings. */
+	pxFirstFreeBlock = ( void * ) heapADDRESS;
+	pxFirstFreeBlock->xBlockSize = heapTOTAL_SIZE;
+	pxFirstFreeBlock->pxNextFreeBlock = NULL;
+
+	xStart.pxNextFreeBlock = pxFirstFreeBlock;
+	xStart.xBlockSize = ( size_t ) 0;
+}
+/*-----------------------------------------------------------*/
+
+static void prvInsertBlockIntoFreeList( xBlockLink *pxBlockToInsert )
+{
+xBlockLink *pxIterator;
+
+	/* Iterate through the list until the last free block placed before the
+	block being inserted. */
+	for( pxIterator = &xStart; ( pxIterator->pxNextFreeBlock != NULL ) && ( pxIterator->pxNextFreeBlock < pxBlockToInsert ); pxIterator = pxIterator->pxNextFreeBlock )
+	{
+		/* There is nothing to do here - just iterate to the correct position. */
+	}
+
+	/* Merge with the next free block if it starts where the inserted block
+	ends. */
+	if( ( pxIterator->pxNextFreeBlock != NULL ) && ( ( ( unsigned char * ) pxBlockToInsert ) + pxBlockToInsert->xBlockSize == ( unsigned char * ) pxIterator->pxNextFreeBlock ) )
+	{
+		pxBlockToInsert->xBlockSize += pxIterator->pxNextFreeBlock->xBlockSize;
+		pxBlockToInsert->pxNextFreeBlock = pxIterator->pxNextFreeBlock->pxNextFreeBlock;
+	}
+	else
+	{
+		pxBlockToInsert->pxNextFreeBlock = pxIterator->pxNextFreeBlock;
+	}
+
+	/* Merge with the previous free block if it ends where the inserted block
+	starts.  xStart is not part of the heap. */
+	if( ( pxIterator != &xStart ) && ( ( ( unsigned char * ) pxIterator ) + pxIterator->xBlockSize == ( unsigned char * ) pxBlockToInsert ) )
+	{
+		pxIterator->xBlockSize += pxBlockToInsert->xBlockSize;
+		pxIterator->pxNextFreeBlock = pxBlockToInsert->pxNextFreeBlock;
+	}
+	else
+	{
+		pxIterator->pxNextFreeBlock = pxBlockToInsert;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static xBlockLink *prvAllocateFromFreeList( size_t xWantedSize )
+{
+xBlockLink *pxBlock, *pxPreviousBlock, *pxNewBlockLink;
+
+	/* Traverse the list from the start (lowest address) block until one of
+	adequate size is found. */
+	pxPreviousBlock = &xStart;
+	pxBlock = xStart.pxNextFreeBlock;
+	while( ( pxBlock != NULL ) && ( pxBlock->xBlockSize < xWantedSize ) )
+	{
+		pxPreviousBlock = pxBlock;
+		pxBlock = pxBlock->pxNextFreeBlock;
+	}
+
+	if( pxBlock != NULL )
+	{
+		/* If the block is larger than required it can be split into two, the
+		end of the block taking its place in the list. */
+		if( ( pxBlock->xBlockSize - xWantedSize ) >= heapMINIMUM_BLOCK_SIZE )
+		{
+			pxNewBlockLink = ( void * ) ( ( ( unsigned char * ) pxBlock ) + xWantedSize );
+			pxNewBlockLink->xBlockSize = pxBlock->xBlockSize - xWantedSize;
+			pxNewBlockLink->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
+			pxPreviousBlock->pxNextFreeBlock = pxNewBlockLink;
+			pxBlock->xBlockSize = xWantedSize;
+		}
+		else
+		{
+			pxPreviousBlock->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
+		}
+	}
+
+	return pxBlock;
+}
+/*-----------------------------------------------------------*/
+
+#if configHEAP_FAST_BIN_COUNT > 0
+
+	static portBASE_TYPE prvFlushFastBins( void )
+	{
+	unsigned portBASE_TYPE uxBin;
+	xBlockLink *pxBlock;
+	portBASE_TYPE xFlushed = pdFALSE;
+
+		for( uxBin = 0; uxBin < configHEAP_FAST_BIN_COUNT; uxBin++ )
+		{
+			while( pxFastBins[ uxBin ] != NULL )
+			{
+				pxBlock = pxFastBins[ uxBin ];
+				pxFastBins[ uxBin ] = pxBlock->pxNextFreeBlock;
+				prvInsertBlockIntoFreeList( pxBlock );
+				xFlushed = pdTRUE;
+			}
+		}
+
+		return xFlushed;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
@@ -0,0 +1,204 @@
+/*
+    FreeRTOS V6.0.5 - Copyright (C) 2010 Real Time Engineers Ltd.
+
+    ***************************************************************************
+    *                                                                         *
+    * If you are:                                                             *
+    *                                                                         *
+    *    + New to FreeRTOS,                                                   *
+    *    + Wanting to learn FreeRTOS or multitasking in general quickly       *
+    *    + Looking for basic training,                                        *
+    *    + Wanting to improve your FreeRTOS skills and productivity           *
+    *                                                                         *
+    * then take a look at the FreeRTOS eBook                                  *
+    *                                                                         *
+    *        "Using the FreeRTOS Real Time Kernel - a Practical Guide"        *
+    *                  http://www.FreeRTOS.org/Documentation                  *
+    *                                                                         *
+    * A pdf reference manual is also available.  Both are usually delivered   *
+    * to your inbox within 20 minutes to two hours when purchased between 8am *
+    * and 8pm GMT (although please allow up to 24 hours in case of            *
+    * exceptional circumstances).  Thank you for your support!                *
+    *                                                                         *
+    ***************************************************************************
+
+    This file is part of the FreeRTOS distribution.
+
+    FreeRTOS is free software; you can redistribute it and/or modify it under
+    the terms of the GNU General Public License (version 2) as published by the
+    Free Software Foundation AND MODIFIED BY the FreeRTOS exception.
+    ***NOTE*** The exception to the GPL is included to allow you to distribute
+    a combined work that includes FreeRTOS without being obliged to provide the
+    source code for proprietary components outside of the FreeRTOS kernel.
+    FreeRTOS is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+    more details. You should have received a copy of the GNU General Public 
+    License and the FreeRTOS license exception along with FreeRTOS; if not it 
+    can be viewed here: http://www.freertos.org/a00114.html and also obtained 
+    by writing to Richard Barry, contact details for whom are available on the
+    FreeRTOS WEB site.
+
+    1 tab == 4 spaces!
+
+    http://www.FreeRTOS.org - Documentation, latest information, license and
+    contact details.
+
+    http://www.SafeRTOS.com - A version that is certified for use in safety
+    critical systems.
+
+    http://www.OpenRTOS.com - Commercial support, development, porting,
+    licensing and training services.
+*/
+
+/*
+ * A sample implementation of pvPortMalloc() and vPortFree() with the TLSF
+ * (two-level segregated fit) allocator of libraries/rtos/tlsf, which must be
+ * added to the project.  Both functions run in constant time, whatever the
+ * number and the sizes of the blocks, so that the tasks allocating at run
+ * time keep a deterministic latency, and the memory lost to fragmentation
+ * stays bounded.  Freed blocks are merged with their free neighbours.
+ *
+ * By default the heap is a static array of configTOTAL_HEAP_SIZE bytes.  When
+ * configHEAP_BASE_ADDRESS is defined in FreeRTOSConfig.h the heap is the
+ * configTOTAL_HEAP_SIZE bytes at that address instead, as with heap_4.c; set
+ * TLSF_FL_MAX_LOG2 so that the largest block covers the heap.
+ *
+ * xPortGetFreeHeapSize(), xPortGetMinimumEverFreeHeapSize() and
+ * xPortGetLargestFreeBlockSize() report the heap usage.
+ *
+ * See heap_1.c, heap_2.c, heap_3.c and heap_4.c for alternative
+ * implementations, and the memory management pages of
+ * http://www.FreeRTOS.org for more information.
+ */
+#include <stdlib.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "../../../../tlsf/tlsf.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#ifdef configHEAP_BASE_ADDRESS
+
+	/* The heap is provided by the application. */
+	#define heapADDRESS		( ( unsigned char * ) ( configHEAP_BASE_ADDRESS ) )
+
+#else
+
+	/* Allocate the memory for the heap.  The struct is used to force byte
+	alignment without using any non-portable code. */
+	static union xRTOS_HEAP
+	{
+		volatile portDOUBLE dDummy;
+		unsigned char ucHeap[ configTOTAL_HEAP_SIZE ];
+	} xHeap;
+
+	#define heapADDRESS		( xHeap.ucHeap )
+
+#endif
+
+/* Control structure of the heap: free lists and statistics. */
+static Tlsf xTlsf;
+
+static portBASE_TYPE xHeapHasBeenInitialised = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+void *pvPortMalloc( size_t xWantedSize )
+{
+void *pvReturn;
+
+	vTaskSuspendAll();
+	{
+		/* If this is the first call to malloc then the heap will require
+		initialisation to setup the free lists. */
+		if( xHeapHasBeenInitialised == pdFALSE )
+		{
+			TLSF_Initialize( &xTlsf, heapADDRESS, configTOTAL_HEAP_SIZE );
+			xHeapHasBeenInitialised = pdTRUE;
+		}
+
+		pvReturn = TLSF_Alloc( &xTlsf, xWantedSize );
+	}
+	xTaskResumeAll();
+
+	#if( configUSE_MALLOC_FAILED_HOOK == 1 )
+	{
+		if( pvReturn == NULL )
+		{
+			extern void vApplicationMallocFailedHook( void );
+			vApplicationMallocFailedHook();
+		}
+	}
+	#endif
+
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void *pv )
+{
+	if( pv )
+	{
+		vTaskSuspendAll();
+		{
+			TLSF_Free( &xTlsf, pv );
+		}
+		xTaskResumeAll();
+	}
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+	if( xHeapHasBeenInitialised == pdFALSE )
+	{
+		return configTOTAL_HEAP_SIZE;
+	}
+
+	return xTlsf.stats.dwSize - xTlsf.stats.dwUsed;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+	if( xHeapHasBeenInitialised == pdFALSE )
+	{
+		return configTOTAL_HEAP_SIZE;
+	}
+
+	return xTlsf.stats.dwSize - xTlsf.stats.dwMaxUsed;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetLargestFreeBlockSize( void )
+{
+TlsfStats xStats;
+
+	vTaskSuspendAll();
+	{
+		if( xHeapHasBeenInitialised == pdFALSE )
+		{
+			TLSF_Initialize( &xTlsf, heapADDRESS, configTOTAL_HEAP_SIZE );
+			xHeapHasBeenInitialised = pdTRUE;
+		}
+
+		TLSF_GetStats( &xTlsf, &xStats );
+	}
+	xTaskResumeAll();
+
+	return xStats.dwLargestFree;
+}
+/*-----------------------------------------------------------*/
+
+void vPortInitialiseBlocks( void )
+{
+	/* This just exists to keep the linker quiet. */
+}
+/*-----------------------------------------------------------*/
@@ -374,6 +374,19 @@ static tskTCB *prvAllocateTCBAndStack( unsigned short usStackDepth, portSTACK_TY
 
 #endif
 
+/*
+ * Used by the tickless idle.  prvGetTicksToNextWake() returns the number of
+ * ticks until the next blocked task is due to wake, or until the tick count
+ * overflows, at least one.  prvGetExpectedIdleTime() returns the same value
+ * when only the idle task can run, otherwise zero.
+ */
+#if ( configUSE_TICKLESS_IDLE == 1 )
+
+	static portTickType prvGetTicksToNextWake( void ) PRIVILEGED_FUNCTION;
+	static portTickType prvGetExpectedIdleTime( void ) PRIVILEGED_FUNCTION;
+
+#endif
+
 
 /*lint +e956 */
 
@@ -1409,6 +1422,58 @@ void vTaskIncrementTick( void )
 }
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_TICKLESS_IDLE == 1 )
+
+	void vTaskStepTick( portTickType xTicksToJump )
+	{
+	portTickType xTicksToWake, xJump;
+
+		/* Called by the portable layer, with the scheduler suspended, after
+		the tick interrupt was stopped for xTicksToJump ticks.  The tick count
+		jumps up to one tick before the next wake time, which cannot wake any
+		task or overflow.  The remaining ticks, normally just one, are left as
+		missed ticks that xTaskResumeAll() processes as real ticks. */
+		xTicksToWake = prvGetTicksToNextWake();
+		if( xTicksToJump > xTicksToWake )
+		{
+			xJump = xTicksToWake - ( portTickType ) 1;
+		}
+		else
+		{
+			xJump = xTicksToJump - ( portTickType ) 1;
+		}
+
+		xTickCount += xJump;
+		uxMissedTicks += ( unsigned portBASE_TYPE ) ( xTicksToJump - xJump );
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TICKLESS_IDLE == 1 )
+
+	portBASE_TYPE xTaskConfirmSleepModeStatus( void )
+	{
+	portBASE_TYPE xReturn = pdTRUE;
+
+		/* Called by the portable layer with interrupts disabled, just before
+		the processor is put to sleep.  An interrupt may have readied a task
+		or requested a yield since the idle time was computed. */
+		if( listCURRENT_LIST_LENGTH( &xPendingReadyList ) != ( unsigned portBASE_TYPE ) 0 )
+		{
+			xReturn = pdFALSE;
+		}
+		else if( xMissedYield != pdFALSE )
+		{
+			xReturn = pdFALSE;
+		}
+
+		return xReturn;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
 #if ( ( INCLUDE_vTaskCleanUpResources == 1 ) && ( INCLUDE_vTaskSuspend == 1 ) )
 
 	void vTaskCleanUpResources( void )
@@ -1826,6 +1891,33 @@ static portTASK_FUNCTION( prvIdleTask, pvParameters )
 			vApplicationIdleHook();
 		}
 		#endif
+
+		#if ( configUSE_TICKLESS_IDLE == 1 )
+		{
+		portTickType xExpectedIdleTime;
+
+			/* When no task is due to run for a while, stop the tick interrupt
+			and let the portable layer sleep until the next wake time.  The
+			first test avoids suspending the scheduler on every loop, the
+			second one is the one that counts, done with the scheduler
+			suspended so that the delayed lists cannot change. */
+			xExpectedIdleTime = prvGetExpectedIdleTime();
+
+			if( xExpectedIdleTime >= configEXPECTED_IDLE_TIME_BEFORE_SLEEP )
+			{
+				vTaskSuspendAll();
+				{
+					xExpectedIdleTime = prvGetExpectedIdleTime();
+
+					if( xExpectedIdleTime >= configEXPECTED_IDLE_TIME_BEFORE_SLEEP )
+					{
+						portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime );
+					}
+				}
+				xTaskResumeAll();
+			}
+		}
+		#endif
 	}
 } /*lint !e715 pvParameters is not accessed but all task functions require the same prototype. */
 
@@ -1959,6 +2051,64 @@ unsigned portBASE_TYPE uxPriority;
 }
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_TICKLESS_IDLE == 1 )
+
+	static portTickType prvGetTicksToNextWake( void )
+	{
+	tskTCB *pxTCB;
+	portTickType xTicks;
+
+		pxTCB = ( tskTCB * ) listGET_OWNER_OF_HEAD_ENTRY( pxDelayedTaskList );
+
+		if( pxTCB != NULL )
+		{
+			/* The delayed list is sorted by wake time. */
+			xTicks = listGET_LIST_ITEM_VALUE( &( pxTCB->xGenericListItem ) ) - xTickCount;
+		}
+		else
+		{
+			/* Only tasks blocked beyond the next overflow, if any.  Wake at
+			the overflow so that the delayed lists are swapped. */
+			xTicks = portMAX_DELAY - xTickCount;
+		}
+
+		if( xTicks == ( portTickType ) 0 )
+		{
+			xTicks = ( portTickType ) 1;
+		}
+
+		return xTicks;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TICKLESS_IDLE == 1 )
+
+	static portTickType prvGetExpectedIdleTime( void )
+	{
+	unsigned portBASE_TYPE uxPriority;
+
+		/* A task other than the idle task is ready to run. */
+		for( uxPriority = uxTopReadyPriority; uxPriority > tskIDLE_PRIORITY; uxPriority-- )
+		{
+			if( !listLIST_IS_EMPTY( &( pxReadyTasksLists[ uxPriority ] ) ) )
+			{
+				return ( portTickType ) 0;
+			}
+		}
+
+		if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ tskIDLE_PRIORITY ] ) ) > ( unsigned portBASE_TYPE ) 1 )
+		{
+			return ( portTickType ) 0;
+		}
+
+		return prvGetTicksToNextWake();
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
 static void prvCheckTasksWaitingTermination( void )
 {
 	#if ( INCLUDE_vTaskDelete == 1 )
@@ -0,0 +1,64 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * FreeRTOS binding of the asynchronous requests: the pEvent of an
+ * AsyncRequest is a semaphore, given when the request is complete, so that
+ * a task blocks on it instead of polling ASYNC_IsRequestFinished().
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "board.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Gives the semaphore bound to a completed request. Replaces the
+ * default ASYNC_SignalEvent() of libchip; the requests must complete from
+ * an interrupt whose priority allows FreeRTOS API calls.
+ * \param pEvent  xSemaphoreHandle of the request.
+ */
+extern void ASYNC_SignalEvent( void* pEvent )
+{
+    signed portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE ;
+
+    xSemaphoreGiveFromISR( (xSemaphoreHandle)pEvent, &xHigherPriorityTaskWoken ) ;
+
+    /* Switch to the waiting task at the end of the interrupt */
+    portEND_SWITCHING_ISR( xHigherPriorityTaskWoken ) ;
+}
@@ -0,0 +1,274 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \addtogroup bufq_module FreeRTOS buffer queues
+ * A buffer queue passes buffers from one task or interrupt (the producer) to
+ * another one (the consumer) without copying them: the queue only carries
+ * the buffer address and size, and the ownership of the buffer goes with
+ * them. The buffers come from a MemPool shared by both ends.
+ *
+ * \section Usage
+ * <ul>
+ * <li> Initializes the queue with BUFQ_Initialize(), giving the storage of
+ *    its slots and the pool of the buffers.</li>
+ * <li> The producer takes a buffer with BUFQ_Alloc(), fills it, and hands it
+ *    over with BUFQ_Post(); it does not touch the buffer afterwards. If the
+ *    queue is full, the buffer is still owned by the producer.</li>
+ * <li> The consumer gets the buffers in order with BUFQ_Receive(), which may
+ *    block, and gives each one back to the pool with BUFQ_Release() once it
+ *    is done with it.</li>
+ * </ul>
+ * There is a single producer and a single consumer per queue, so that the
+ * ring indices have a single writer and need no critical section. The
+ * producer may be an interrupt handler of a priority allowing FreeRTOS API
+ * calls; the semaphore waking up the consumer is only given when the
+ * consumer is blocked on it, so that a post does not enter the kernel while
+ * the consumer keeps up. Unlike xQueueSend(), nothing is copied, whatever
+ * the buffer size.
+ *
+ * Related files :\n
+ * \ref buffer_queue.c\n
+ * \ref buffer_queue.h.\n
+*/
+/*@{*/
+/*@}*/
+
+
+/**
+ * \file
+ *
+ * Implementation of the FreeRTOS buffer queues.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "buffer_queue.h"
+
+#include "task.h"
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Atomically replaces a word shared by the producer and the consumer,
+ * using the Cortex-M3 exclusive accesses; returns the previous value.
+ */
+static uint32_t _Exchange( volatile uint32_t* pulWord, uint32_t ulValue )
+{
+    uint32_t ulOld ;
+
+    do
+    {
+        ulOld = __LDREXW( (uint32_t*)pulWord ) ;
+    } while ( __STREXW( ulValue, (uint32_t*)pulWord ) != 0 ) ;
+    __DMB() ;
+
+    return ulOld ;
+}
+
+/**
+ * \brief Returns the slot following dwIndex.
+ */
+static uint32_t _NextSlot( BufQueue *pQueue, uint32_t dwIndex )
+{
+    return (dwIndex+1 == pQueue->dwCount) ? 0 : dwIndex+1 ;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initializes an empty buffer queue.
+ * \param pQueue  Pointer to a BufQueue instance.
+ * \param pSlots  Storage of the slots.
+ * \param dwCount  Number of slots, at least 2; dwCount-1 buffers can be queued.
+ * \param pPool  Pool the buffers of the queue come from.
+ * \return 0 if successful; 1 if the semaphore could not be created.
+ */
+extern uint32_t BUFQ_Initialize( BufQueue *pQueue, BufQueueSlot *pSlots, uint32_t dwCount, MemPool *pPool )
+{
+    pQueue->pSlots = pSlots ;
+    pQueue->dwCount = dwCount ;
+    pQueue->dwHead = 0 ;
+    pQueue->dwTail = 0 ;
+    pQueue->ulWaiting = 0 ;
+    pQueue->pPool = pPool ;
+
+    vSemaphoreCreateBinary( pQueue->xSignal ) ;
+    if ( pQueue->xSignal == NULL )
+    {
+        return 1 ;
+    }
+    /* Created given: take it so that it only counts posts */
+    xSemaphoreTake( pQueue->xSignal, 0 ) ;
+
+    return 0 ;
+}
+
+/**
+ * \brief Takes an empty buffer out of the pool of the queue; returns 0 if the
+ * pool is exhausted. Can be called from an interrupt handler.
+ * \param pQueue  Pointer to a BufQueue instance.
+ */
+extern void* BUFQ_Alloc( BufQueue *pQueue )
+{
+    return MEMPOOL_Alloc( pQueue->pPool ) ;
+}
+
+/**
+ * \brief Gives a received buffer back to the pool of the queue. Can be called
+ * from an interrupt handler.
+ * \param pQueue  Pointer to a BufQueue instance.
+ * \param pBuffer  Buffer returned by BUFQ_Receive() or BUFQ_Alloc().
+ */
+extern void BUFQ_Release( BufQueue *pQueue, void *pBuffer )
+{
+    MEMPOOL_Free( pQueue->pPool, pBuffer ) ;
+}
+
+/**
+ * \brief Hands a buffer over to the consumer; called by the producer only,
+ * from a task or from an interrupt handler.
+ * \param pQueue  Pointer to a BufQueue instance.
+ * \param pBuffer  Buffer to pass, owned by the consumer once posted.
+ * \param dwSize  Number of valid bytes in the buffer.
+ * \return 0 if the buffer has been queued; 1 if the queue is full, the
+ * buffer then being still owned by the producer.
+ */
+extern uint32_t BUFQ_Post( BufQueue *pQueue, void *pBuffer, uint32_t dwSize )
+{
+    uint32_t dwHead = pQueue->dwHead ;
+    uint32_t dwNext = _NextSlot( pQueue, dwHead ) ;
+    signed portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE ;
+
+    if ( dwNext == pQueue->dwTail )
+    {
+        return 1 ;
+    }
+
+    pQueue->pSlots[dwHead].pBuffer = pBuffer ;
+    pQueue->pSlots[dwHead].dwSize = dwSize ;
+    /* The slot is written before it is published */
+    __DMB() ;
+    pQueue->dwHead = dwNext ;
+
+    /* Wake up the consumer only if it is blocked */
+    if ( _Exchange( &pQueue->ulWaiting, 0 ) != 0 )
+    {
+        if ( (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) != 0 )
+        {
+            xSemaphoreGiveFromISR( pQueue->xSignal, &xHigherPriorityTaskWoken ) ;
+            portEND_SWITCHING_ISR( xHigherPriorityTaskWoken ) ;
+        }
+        else
+        {
+            xSemaphoreGive( pQueue->xSignal ) ;
+        }
+    }
+
+    return 0 ;
+}
+
+/**
+ * \brief Takes the oldest buffer of the queue; called by the consumer only.
+ * The consumer owns the buffer and releases it with BUFQ_Release().
+ * \param pQueue  Pointer to a BufQueue instance.
+ * \param pdwSize  Receives the number of valid bytes of the buffer; may be 0.
+ * \param xTicksToWait  Maximum time to block while the queue is empty; must
+ * be 0 if the consumer is an interrupt handler.
+ * \return Pointer to the buffer, or 0 if none was posted in time.
+ */
+extern void* BUFQ_Receive( BufQueue *pQueue, uint32_t *pdwSize, portTickType xTicksToWait )
+{
+    uint32_t dwTail ;
+    void* pBuffer ;
+    portTickType xStart = (xTicksToWait != 0) ? xTaskGetTickCount() : 0 ;
+    portTickType xRemaining ;
+
+    for ( ; ; )
+    {
+        dwTail = pQueue->dwTail ;
+        if ( dwTail != pQueue->dwHead )
+        {
+            /* The slot is read once published */
+            __DMB() ;
+            pBuffer = pQueue->pSlots[dwTail].pBuffer ;
+            if ( pdwSize )
+            {
+                *pdwSize = pQueue->pSlots[dwTail].dwSize ;
+            }
+            __DMB() ;
+            pQueue->dwTail = _NextSlot( pQueue, dwTail ) ;
+
+            return pBuffer ;
+        }
+
+        if ( xTicksToWait == 0 )
+        {
+            return 0 ;
+        }
+        else if ( xTicksToWait == portMAX_DELAY )
+        {
+            xRemaining = portMAX_DELAY ;
+        }
+        else
+        {
+            xRemaining = xTaskGetTickCount() - xStart ;
+            if ( xRemaining >= xTicksToWait )
+            {
+                return 0 ;
+            }
+            xRemaining = xTicksToWait - xRemaining ;
+        }
+
+        /* Announce the wait, then check again for a post made in between */
+        _Exchange( &pQueue->ulWaiting, 1 ) ;
+        if ( pQueue->dwTail == pQueue->dwHead )
+        {
+            xSemaphoreTake( pQueue->xSignal, xRemaining ) ;
+        }
+        _Exchange( &pQueue->ulWaiting, 0 ) ;
+    }
+}
+
+/**
+ * \brief Returns the number of buffers posted and not received yet.
+ * \param pQueue  Pointer to a BufQueue instance.
+ */
+extern uint32_t BUFQ_GetPending( BufQueue *pQueue )
+{
+    uint32_t dwHead = pQueue->dwHead ;
+    uint32_t dwTail = pQueue->dwTail ;
+
+    return (dwHead >= dwTail) ? (dwHead-dwTail) : (pQueue->dwCount+dwHead-dwTail) ;
+}
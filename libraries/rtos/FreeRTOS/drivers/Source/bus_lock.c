@@ -0,0 +1,268 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Implementation of the FreeRTOS bus locks.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "bus_lock.h"
+
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Locks connected to the libchip bus hooks. */
+static BusLock *_apBusLocks[BUS_NUM] ;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Bus hook acquiring the lock connected to a bus.
+ */
+static void _BusAcquire( uint32_t dwBus )
+{
+    BusLock *pLock = _apBusLocks[dwBus] ;
+
+    if ( pLock != NULL )
+    {
+        BUSLOCK_Take( pLock, portMAX_DELAY ) ;
+    }
+}
+
+/**
+ * \brief Bus hook releasing the lock connected to a bus.
+ */
+static void _BusRelease( uint32_t dwBus )
+{
+    BusLock *pLock = _apBusLocks[dwBus] ;
+
+    if ( pLock != NULL )
+    {
+        BUSLOCK_Give( pLock ) ;
+    }
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initializes a bus lock, free, with cleared statistics.
+ * \param pLock  Pointer to a BusLock instance.
+ * \param xHoldLimit  Hold time budget in ticks, 0 for none.
+ * \return 0 if successful; 1 if the mutex could not be created.
+ */
+extern uint32_t BUSLOCK_Initialize( BusLock *pLock, portTickType xHoldLimit )
+{
+    memset( pLock, 0, sizeof( BusLock ) ) ;
+    pLock->xHoldLimit = xHoldLimit ;
+
+    pLock->xMutex = xSemaphoreCreateMutex() ;
+    if ( pLock->xMutex == NULL )
+    {
+        return 1 ;
+    }
+
+    return 0 ;
+}
+
+/**
+ * \brief Takes a bus lock; a task already owning the lock takes it again at
+ * once. While the calling task waits, the owner inherits its priority.
+ * \param pLock  Pointer to a BusLock instance.
+ * \param xTicksToWait  Maximum time to wait, portMAX_DELAY to wait forever.
+ * \return 0 if successful; 1 on timeout.
+ */
+extern uint32_t BUSLOCK_Take( BusLock *pLock, portTickType xTicksToWait )
+{
+    xTaskHandle xSelf = xTaskGetCurrentTaskHandle() ;
+    portTickType xStart ;
+    portTickType xWait = 0 ;
+    uint32_t ulContended = 0 ;
+
+    if ( pLock->xOwner == xSelf )
+    {
+        pLock->ulNesting++ ;
+
+        return 0 ;
+    }
+
+    if ( xSemaphoreTake( pLock->xMutex, 0 ) != pdTRUE )
+    {
+        ulContended = 1 ;
+        xStart = xTaskGetTickCount() ;
+
+        taskENTER_CRITICAL() ;
+        pLock->ulWaiting++ ;
+        pLock->stats.ulContended++ ;
+        taskEXIT_CRITICAL() ;
+
+        if ( (xTicksToWait == 0) || (xSemaphoreTake( pLock->xMutex, xTicksToWait ) != pdTRUE) )
+        {
+            taskENTER_CRITICAL() ;
+            pLock->ulWaiting-- ;
+            pLock->stats.ulTimeouts++ ;
+            taskEXIT_CRITICAL() ;
+
+            return 1 ;
+        }
+
+        taskENTER_CRITICAL() ;
+        pLock->ulWaiting-- ;
+        taskEXIT_CRITICAL() ;
+
+        xWait = xTaskGetTickCount() - xStart ;
+    }
+
+    /* Owner from here on: the statistics below are not shared */
+    pLock->xOwner = xSelf ;
+    pLock->ulNesting = 1 ;
+    pLock->xTaken = xTaskGetTickCount() ;
+    pLock->stats.ulTakes++ ;
+    if ( ulContended )
+    {
+        pLock->stats.xTotalWait += xWait ;
+        if ( xWait > pLock->stats.xMaxWait )
+        {
+            pLock->stats.xMaxWait = xWait ;
+        }
+    }
+
+    return 0 ;
+}
+
+/**
+ * \brief Gives a bus lock back; the lock is released by the outermost give
+ * of its owner, and the owner gets its own priority back.
+ * \param pLock  Pointer to a BusLock instance owned by the calling task.
+ */
+extern void BUSLOCK_Give( BusLock *pLock )
+{
+    portTickType xHold ;
+
+    if ( pLock->xOwner != xTaskGetCurrentTaskHandle() )
+    {
+        return ;
+    }
+
+    if ( --pLock->ulNesting != 0 )
+    {
+        return ;
+    }
+
+    xHold = xTaskGetTickCount() - pLock->xTaken ;
+    if ( xHold > pLock->stats.xMaxHold )
+    {
+        pLock->stats.xMaxHold = xHold ;
+    }
+    if ( (pLock->xHoldLimit != 0) && (xHold > pLock->xHoldLimit) )
+    {
+        pLock->stats.ulOverruns++ ;
+    }
+
+    pLock->xOwner = NULL ;
+    xSemaphoreGive( pLock->xMutex ) ;
+}
+
+/**
+ * \brief Lets the waiting tasks take a bus lock held beyond its hold limit:
+ * the lock is given back and taken again. To be called by the owner at a
+ * point where the bus state allows another driver in, outside of nested
+ * takes.
+ * \param pLock  Pointer to a BusLock instance owned by the calling task.
+ * \return 1 if the lock was given to the waiting tasks; otherwise 0.
+ */
+extern uint32_t BUSLOCK_Yield( BusLock *pLock )
+{
+    if ( (pLock->xOwner != xTaskGetCurrentTaskHandle()) || (pLock->ulNesting != 1) )
+    {
+        return 0 ;
+    }
+
+    if ( (pLock->ulWaiting == 0) || (pLock->xHoldLimit == 0)
+      || (xTaskGetTickCount() - pLock->xTaken <= pLock->xHoldLimit) )
+    {
+        return 0 ;
+    }
+
+    /* A higher priority waiter runs at once; an equal one at the next switch */
+    BUSLOCK_Give( pLock ) ;
+    taskYIELD() ;
+    BUSLOCK_Take( pLock, portMAX_DELAY ) ;
+
+    return 1 ;
+}
+
+/**
+ * \brief Copies the contention statistics of a bus lock.
+ * \param pLock  Pointer to a BusLock instance.
+ * \param pStats  Receives the statistics.
+ */
+extern void BUSLOCK_GetStats( BusLock *pLock, BusLockStats *pStats )
+{
+    taskENTER_CRITICAL() ;
+    memcpy( pStats, &pLock->stats, sizeof( BusLockStats ) ) ;
+    taskEXIT_CRITICAL() ;
+}
+
+/**
+ * \brief Clears the contention statistics of a bus lock.
+ * \param pLock  Pointer to a BusLock instance.
+ */
+extern void BUSLOCK_ResetStats( BusLock *pLock )
+{
+    taskENTER_CRITICAL() ;
+    memset( &pLock->stats, 0, sizeof( BusLockStats ) ) ;
+    taskEXIT_CRITICAL() ;
+}
+
+/**
+ * \brief Arbitrates a libchip bus (bus.h) with a bus lock. Shall be called
+ * while the bus is not in use.
+ * \param ulBus  BUS_SMC or BUS_SPI.
+ * \param pLock  Pointer to an initialized BusLock instance, or NULL to stop
+ * arbitrating the bus.
+ */
+extern void BUSLOCK_ConnectBus( uint32_t ulBus, BusLock *pLock )
+{
+    assert( ulBus < BUS_NUM ) ;
+
+    _apBusLocks[ulBus] = pLock ;
+    BUS_SetArbiter( _BusAcquire, _BusRelease ) ;
+}
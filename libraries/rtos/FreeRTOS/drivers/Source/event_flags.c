@@ -0,0 +1,232 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Implementation of the FreeRTOS event flags.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "event_flags.h"
+
+#include "task.h"
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Event flags receiving the I/O events. */
+static EventFlags *_pIoFlags = NULL ;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Atomically replaces the bits by ( bits & ulKeep ) | ulSet; returns
+ * the previous bits.
+ */
+static uint32_t _Update( volatile uint32_t* pulBits, uint32_t ulKeep, uint32_t ulSet )
+{
+    uint32_t ulOld ;
+
+    do
+    {
+        ulOld = __LDREXW( (uint32_t*)pulBits ) ;
+    } while ( __STREXW( (ulOld & ulKeep) | ulSet, (uint32_t*)pulBits ) != 0 ) ;
+    __DMB() ;
+
+    return ulOld ;
+}
+
+/**
+ * \brief Checks the wait condition and clears the bits waited for if asked,
+ * atomically.
+ * \return The bits when the condition is met, otherwise 0.
+ */
+static uint32_t _Check( EventFlags *pFlags, uint32_t ulBits, uint32_t ulWaitAll, uint32_t ulClear )
+{
+    uint32_t ulOld ;
+    uint32_t ulMatch ;
+
+    do
+    {
+        ulOld = __LDREXW( (uint32_t*)&pFlags->ulBits ) ;
+        ulMatch = ulOld & ulBits ;
+        if ( (ulMatch == 0) || (ulWaitAll && (ulMatch != ulBits)) )
+        {
+            __CLREX() ;
+
+            return 0 ;
+        }
+    } while ( __STREXW( ulClear ? (ulOld & ~ulBits) : ulOld, (uint32_t*)&pFlags->ulBits ) != 0 ) ;
+    __DMB() ;
+
+    return ulOld ;
+}
+
+/**
+ * \brief I/O event sink setting the raised bits in the connected flags.
+ */
+static void _IoEventSink( uint32_t dwEvents )
+{
+    if ( _pIoFlags != NULL )
+    {
+        EVF_Set( _pIoFlags, dwEvents ) ;
+    }
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initializes event flags with all the bits cleared.
+ * \param pFlags  Pointer to an EventFlags instance.
+ * \return 0 if successful; 1 if the semaphore could not be created.
+ */
+extern uint32_t EVF_Initialize( EventFlags *pFlags )
+{
+    pFlags->ulBits = 0 ;
+
+    vSemaphoreCreateBinary( pFlags->xSignal ) ;
+    if ( pFlags->xSignal == NULL )
+    {
+        return 1 ;
+    }
+    /* The binary semaphore is created given */
+    xSemaphoreTake( pFlags->xSignal, 0 ) ;
+
+    return 0 ;
+}
+
+/**
+ * \brief Sets bits and wakes the waiting task up; can be called from a task
+ * or from an interrupt handler.
+ * \param pFlags  Pointer to an EventFlags instance.
+ * \param ulBits  Bits to set.
+ */
+extern void EVF_Set( EventFlags *pFlags, uint32_t ulBits )
+{
+    portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE ;
+
+    _Update( &pFlags->ulBits, 0xFFFFFFFF, ulBits ) ;
+
+    if ( (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) != 0 )
+    {
+        xSemaphoreGiveFromISR( pFlags->xSignal, &xHigherPriorityTaskWoken ) ;
+        portEND_SWITCHING_ISR( xHigherPriorityTaskWoken ) ;
+    }
+    else
+    {
+        xSemaphoreGive( pFlags->xSignal ) ;
+    }
+}
+
+/**
+ * \brief Clears bits.
+ * \param pFlags  Pointer to an EventFlags instance.
+ * \param ulBits  Bits to clear.
+ */
+extern void EVF_Clear( EventFlags *pFlags, uint32_t ulBits )
+{
+    _Update( &pFlags->ulBits, ~ulBits, 0 ) ;
+}
+
+/**
+ * \brief Returns the bits currently set.
+ * \param pFlags  Pointer to an EventFlags instance.
+ */
+extern uint32_t EVF_Get( EventFlags *pFlags )
+{
+    return pFlags->ulBits ;
+}
+
+/**
+ * \brief Waits until any or all of the given bits are set.
+ * \param pFlags  Pointer to an EventFlags instance.
+ * \param ulBits  Bits waited for.
+ * \param ulWaitAll  1 to wait for all the bits, 0 for any of them.
+ * \param ulClear  1 to clear the bits waited for when the wait ends.
+ * \param xTicksToWait  Maximum time to block; 0 to only check the bits.
+ * \return The bits set when the wait ended, before they are cleared; 0 on
+ * timeout.
+ */
+extern uint32_t EVF_Wait( EventFlags *pFlags, uint32_t ulBits, uint32_t ulWaitAll, uint32_t ulClear, portTickType xTicksToWait )
+{
+    uint32_t ulSet ;
+    portTickType xStart = (xTicksToWait != 0) ? xTaskGetTickCount() : 0 ;
+    portTickType xRemaining ;
+
+    for ( ; ; )
+    {
+        ulSet = _Check( pFlags, ulBits, ulWaitAll, ulClear ) ;
+        if ( ulSet != 0 )
+        {
+            return ulSet ;
+        }
+
+        if ( xTicksToWait == 0 )
+        {
+            return 0 ;
+        }
+        else if ( xTicksToWait == portMAX_DELAY )
+        {
+            xRemaining = portMAX_DELAY ;
+        }
+        else
+        {
+            xRemaining = xTaskGetTickCount() - xStart ;
+            if ( xRemaining >= xTicksToWait )
+            {
+                return 0 ;
+            }
+            xRemaining = xTicksToWait - xRemaining ;
+        }
+
+        /* A set made since the check has given the semaphore */
+        xSemaphoreTake( pFlags->xSignal, xRemaining ) ;
+    }
+}
+
+/**
+ * \brief Routes the I/O events raised by the drivers to event flags; the
+ * IOEVT_ bits are set in the flags.
+ * \param pFlags  Pointer to an initialized EventFlags instance, or NULL to
+ * stop routing.
+ */
+extern void EVF_ConnectIoEvents( EventFlags *pFlags )
+{
+    _pIoFlags = pFlags ;
+    IOEVT_SetSink( (pFlags != NULL) ? _IoEventSink : 0 ) ;
+}
@@ -27,54 +27,37 @@
  * ----------------------------------------------------------------------------
  */
 
-/** \addtogroup spi_pdc_module SPI PDC driver
- *  \ingroup spi_at25_module
- * The Spi driver is a low level spi driver which performs SPI device Initializes,
- * spi transfer and receive. It can be used by upper SPI driver such as AT25/26
- * driver and AT45 driver.
+/** \addtogroup spim_module FreeRTOS SPI master driver
+ * The SPI master driver shares the SPI between the tasks accessing the
+ * devices connected to it (touch screen controller, serial flash, ...).
  *
  * \section Usage
  * <ul>
- * <li> Initializes a SPI instance and the corresponding SPI hardware,
- *    Configure SPI in Master Mode using SPID_Configure().</li>
- * <li> Configures the SPI characteristics (such as Clock Polarity, Phase,
- *    transfers delay and Baud Rate) for the device corresponding to the
- *    chip select using SPID_ConfigureCS().</li>
- * <li> Starts a SPI master transfer using SPID_SendCommand().
- *    The transfer is performed using the PDC channels. </li>
- *    <li> It enable the SPI clock.</li>
- *    <li> Set the corresponding peripheral chip select.</li>
- *    <li> Initialize the two SPI PDC buffers.</li>
- *       <li> Initialize SPI_TPR and SPI_TCR with SPI command data and size
- *         to send command data first.</li>
- *       <li> Initialize SPI_RPR and SPI_RCR with SPI command data and size
- *         as dummy value.</li>
- *       <li> Initialize SPI_TNPR and SPI_TNCR with rest of the data to be
- *        transfered.(if the data specified in cmd structure)</li>
- *       <li> Initialize SPI_RNPR and SPI_RNCR with rest of the data to be
- *         received.(if the data specified in cmd structure)</li>
- *    <li> Initialize the callback function if specified.</li>
- *    <li> Enable transmitter and receiver.</li>
- *    <li> Example for sending a command to the dataflash through the SPI.</li>
- * \code
- *      /// Build command to be sent.
- *      ...
- *      // Send Command and data through the SPI
- *      if (SPID_SendCommand(pAt25->pSpid, pCommand)) {
- *          return AT25_ERROR_SPI;
- *      }
- * \endcode
- * <li> The SPI_Handler() must be called by the SPI Interrupt Service Routine
- *    with the corresponding Spi instance. It is invokes to check for pending
- *    interrupts. </li>
- *    <li> Example for initializing SPI interrupt handler in upper application.</li>
- * \code
- *        AIC_ConfigureIT(AT91C_ID_SPI, 0, SPI_Handler);
- * \endcode
+ * <li> Initializes the SPI in master mode using SPIM_Initialize(), and calls
+ *    SPIM_Handler() from the SPI interrupt (SPI_IrqHandler()).</li>
+ * <li> Configures the timings and the priority class of each device using
+ *    SPIM_ConfigureCS(). Devices sampled periodically (touch screen) use
+ *    SPIM_PRIORITY_HIGH, serial flashes SPIM_PRIORITY_BULK.</li>
+ * <li> Prepares a SpimCmd with SPIM_InitCommand() (it creates the semaphore
+ *    the waiting task blocks on), then:
+ *    <ul>
+ *    <li> SPIM_Transfer() executes it and blocks the calling task until its
+ *       end, or</li>
+ *    <li> SPIM_Submit() queues it and returns; SPIM_Wait() waits for its
+ *       end, the optional callback being invoked from the interrupt.</li>
+ *    </ul></li>
  * </ul>
+ * Each chip select has its own queue of commands. The transfers are made by
+ * the PDC in chunks of SPIM_CHUNK_SIZE bytes (the chip select is kept
+ * asserted between them, SPI_CSR_CSAAT); between two chunks, the interrupt
+ * gives the SPI to the highest priority class having a command queued, if
+ * the running command is SPIM_FLAG_PREEMPTIBLE. Otherwise a command runs to
+ * its end, so that serial flashes, which abort a command when their chip
+ * select rises, should split long reads into several commands.
+ *
  * Related files :\n
- * \ref spi_master.c\n
- * \ref spi_master.h.\n
+ * \ref spim_driver.c\n
+ * \ref spim_driver.h.\n
 */
 /*@{*/
 /*@}*/
@@ -83,30 +66,39 @@
 /**
  * \file
  *
- * Implementation of SPI PDC driver.
+ * Implementation of the FreeRTOS SPI master driver.
  *
  */
 
 /*----------------------------------------------------------------------------
  *        Headers
  *----------------------------------------------------------------------------*/
-#include "board.h"
-#include "FreeRTOS.h"
-#include "semphr.h"
+#include "spim_driver.h"
+
+#include <assert.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** NPCS pins configured by the driver (the other ones by the application). */
+#ifndef SPIM_CS_PINS
+#define SPIM_CS_PINS    {PIN_SPI_NPCS0_PA11}
+#endif
 
 /*----------------------------------------------------------------------------
  *        Internal structures
  *----------------------------------------------------------------------------*/
+
 /**
- * \brief Spi Status object updated by the AT25_SpiCallback once an SPI operation
- *     is achieved.
+ * \brief Queue of the commands of a chip select.
  */
-typedef struct _SpimRwData
+typedef struct _SpimQueue
 {
-	xSemaphoreHandle spiSemaphore; /**< Semaphore to protect the SPI periph */
-	xSemaphoreHandle txvSemaphore; /**< Semaphore used for synchronous commands */
-    volatile ESpimStatus txvStatus; /**< SPI transfer status */
-} SpimRwData;
+    SpimCmd *pHead ;      /**< Command running or next to run */
+    SpimCmd *pTail ;      /**< Last queued command */
+    uint8_t ucPriority ;  /**< SPIM_PRIORITY_xxx class */
+} SpimQueue ;
 
 /**
  * \brief Spi Driver associated with an Hw Spi peripheral
@@ -114,322 +106,425 @@ typedef struct _SpimRwData
 typedef struct _Spim {
     Spi   *pSpi;        /**< Pointer to SPI Hw peripheral */
     IRQn_Type spiId;   /**< Spi peripheral ID */
-    Pin  spiPins[3];   /**< Spi spck, miso, mosi pin description */
-    Pin  csPins[4];    /**< Spi NPCS pin descriptiom */
-    SpimRwData *pData; /**< Pointer to Spim R/W data */
+    SpimQueue queues[SPIM_NUM_CS]; /**< Command queue of each chip select */
+    SpimCmd *pCurrent; /**< Command being transferred, 0 if idle */
+    uint8_t ucLastCs;  /**< Chip select of the last chunk */
 } Spim;
 
-/* Local variables specific to the sam3n architecture */
-SpimRwData sam3nSpimRwData;
+/* Local variables specific to the sam3s architecture */
+static Spim sam3sSpim = { SPI, SPI_IRQn } ;
+
+static const Pin spiPins[] = {PINS_SPI} ;
+static const Pin csPins[] = SPIM_CS_PINS ;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Returns the next command to transfer: the head of the queue of the
+ * highest priority class, the chip selects of a class being served in turn.
+ * Returns 0 if no command is queued.
+ *
+ * \param pSpim  Pointer to the Spim instance.
+ */
+static SpimCmd* _SelectCommand( Spim *pSpim )
+{
+    SpimCmd *pSelected = 0 ;
+    uint8_t ucBestPriority = SPIM_NUM_PRIORITIES ;
+    uint8_t ucCS ;
+    uint8_t i ;
+
+    for ( i = 1 ; i <= SPIM_NUM_CS ; i++ )
+    {
+        ucCS = (pSpim->ucLastCs + i) % SPIM_NUM_CS ;
+        if ( pSpim->queues[ucCS].pHead && (pSpim->queues[ucCS].ucPriority < ucBestPriority) )
+        {
+            pSelected = pSpim->queues[ucCS].pHead ;
+            ucBestPriority = pSpim->queues[ucCS].ucPriority ;
+        }
+    }
+
+    return pSelected ;
+}
 
-const Spim sam3nSpim = {
-  SPI, SPI_IRQn,
-  {PINS_SPI},
-  {PIN_SPI_NPCS0_SDCARD, PIN_SPI_NPCS1_ZIGBEE, PIN_SPI_NPCS2_LCD, PIN_SPI_NPCS3_AT25},
-  &sam3nSpimRwData
-};
+/**
+ * \brief Starts the transfer of the next chunk of a command: the command bytes
+ * and the first data bytes, or the following data bytes.
+ *
+ * \param pSpim  Pointer to the Spim instance.
+ * \param pCommand  Command to transfer.
+ */
+static void _StartChunk( Spim *pSpim, SpimCmd *pCommand )
+{
+    Spi *pSpi = pSpim->pSpi ;
+    uint8_t *pCmd = 0 ;
+    uint32_t dwCmdSize = 0 ;
+    uint32_t dwSize ;
+
+    /* A chip select change releases the previous device */
+    if ( (pSpim->pCurrent == 0) || (pCommand->cs != pSpim->ucLastCs) )
+    {
+        SPI_Disable( pSpi ) ;
+        pSpi->SPI_MR = (pSpi->SPI_MR | SPI_MR_PCS_Msk) & ~((1 << pCommand->cs) << 16) ;
+        SPI_Enable( pSpi ) ;
+    }
+    pSpim->pCurrent = pCommand ;
+    pSpim->ucLastCs = pCommand->cs ;
+
+    /* The command bytes are sent with the first chunk of data */
+    if ( pCommand->status != SPIM_BUSY )
+    {
+        pCommand->status = SPIM_BUSY ;
+        pCmd = pCommand->pCmd ;
+        dwCmdSize = pCommand->cmdSize ;
+    }
+    dwSize = pCommand->dataSize - pCommand->offset ;
+    if ( dwSize > SPIM_CHUNK_SIZE )
+    {
+        dwSize = SPIM_CHUNK_SIZE ;
+    }
+
+    SPI_PdcSetRx( pSpi, pCmd, dwCmdSize, &(pCommand->pData[pCommand->offset]), dwSize ) ;
+    SPI_PdcSetTx( pSpi, pCmd, dwCmdSize, &(pCommand->pData[pCommand->offset]), dwSize ) ;
+    pCommand->offset += dwSize ;
+
+    SPI_PdcEnableRx( pSpi ) ;
+    SPI_PdcEnableTx( pSpi ) ;
+    SPI_EnableIt( pSpi, SPI_IER_RXBUFF ) ;
+}
 
 /*----------------------------------------------------------------------------
  *        SPI Handler functions
  *----------------------------------------------------------------------------*/
 /**
  * \brief The SPI_Handler must be called by the SPI Interrupt Service Routine with the
- * corresponding Spi instance.
+ * corresponding Spi instance. At the end of each chunk, it starts the next
+ * one, or completes the command and wakes up the task waiting for it.
  *
  */
 extern void SPIM_Handler( void )
 {
-    static signed portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+    signed portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
     /* pSpim shall be initialized with the instance which corresponds */
     /* to the Spi Hw interface */
-    const Spim *pSpim = &sam3nSpim;
+    Spim *pSpim = &sam3sSpim;
     Spi *pSpi   = pSpim->pSpi;
-    SpimRwData  *pSpimRwData = pSpim->pData;
+    SpimCmd *pCommand = pSpim->pCurrent ;
+    SpimCmd *pNext ;
+    SpimQueue *pQueue ;
     uint32_t    dwSpiReg;
 
-    /* Disable interrupts */
-    dwSpiReg = SPI_GetItMask(pSpi);
-    SPI_DisableIt( pSpi, dwSpiReg) ;
-
-    pSpimRwData->txvStatus = SPIM_OK;
-
     /* Check status */
     dwSpiReg = SPI_GetStatus(pSpi);
-    if (dwSpiReg & SPI_SR_OVRES) {
-       pSpimRwData->txvStatus = SPIM_ERROR_OVERRUN;
+    if ( !pCommand || !(dwSpiReg & SPI_SR_RXBUFF) )
+    {
+        return ;
     }
+
+    SPI_DisableIt( pSpi, SPI_IDR_RXBUFF ) ;
+    SPI_PdcDisableRx( pSpi ) ;
+    SPI_PdcDisableTx( pSpi ) ;
+
     if (dwSpiReg & (SPI_SR_MODF | SPI_SR_UNDES)) {
-    	pSpimRwData->txvStatus = SPIM_ERROR;
+        pCommand->offset = pCommand->dataSize ;
+        pCommand->status = SPIM_ERROR ;
     }
-    /* Release the semaphore to notify the end of transfer */
-    xSemaphoreGiveFromISR( pSpimRwData->txvSemaphore, &xHigherPriorityTaskWoken );
-    
-    /* We may want to switch to the SPIM task, if this message has made
-    it the highest priority task that is ready to execute. */
-    portEND_SWITCHING_ISR( xHigherPriorityTaskWoken );
 
+    /* Chunks left: continue, unless a higher class is waiting */
+    pQueue = &(pSpim->queues[pCommand->cs]) ;
+    if ( pCommand->offset < pCommand->dataSize )
+    {
+        pNext = pCommand ;
+        if ( pCommand->flags & SPIM_FLAG_PREEMPTIBLE )
+        {
+            pNext = _SelectCommand( pSpim ) ;
+            if ( pSpim->queues[pNext->cs].ucPriority >= pQueue->ucPriority )
+            {
+                pNext = pCommand ;
+            }
+        }
+        _StartChunk( pSpim, pNext ) ;
+
+        return ;
+    }
 
+    /* Command complete: remove it from its queue */
+    pQueue->pHead = pCommand->pNext ;
+    if ( pQueue->pHead == 0 )
+    {
+        pQueue->pTail = 0 ;
+    }
+    if ( pCommand->status == SPIM_BUSY )
+    {
+        pCommand->status = SPIM_OK ;
+    }
+
+    /* Start the next command, or release the chip select */
+    pNext = _SelectCommand( pSpim ) ;
+    if ( pNext )
+    {
+        /* A new command on the same chip select needs a rising edge too */
+        if ( pNext->cs == pCommand->cs )
+        {
+            SPI_Disable( pSpi ) ;
+            SPI_Enable( pSpi ) ;
+        }
+        _StartChunk( pSpim, pNext ) ;
+    }
+    else
+    {
+        pSpim->pCurrent = 0 ;
+        SPI_Disable( pSpi ) ;
+        PMC_DisablePeripheral( pSpim->spiId ) ;
+    }
+
+    /* Notify the end of transfer */
+    if ( pCommand->callback )
+    {
+        pCommand->callback( pCommand ) ;
+    }
+    if ( pCommand->doneSemaphore )
+    {
+        xSemaphoreGiveFromISR( pCommand->doneSemaphore, &xHigherPriorityTaskWoken );
+    }
+
+    /* We may want to switch to the waiting task, if this message has made
+    it the highest priority task that is ready to execute. */
+    portEND_SWITCHING_ISR( xHigherPriorityTaskWoken );
 }
 
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
 /**
- * \brief Initializes an AT25 driver instance with the given SPI driver and chip
- * select value. This function is invoked by the application.
+ * \brief Initializes the SPI master driver and the corresponding SPI hardware.
+ * This function is invoked by the application.
  * \param pSpi  Pointer to an Spi hw peripheral.
  */
 extern ESpimStatus SPIM_Initialize( Spi* pSpi )
 {
     /* pSpim shall be initialized with the instance which corresponds */
     /* to the Spi Hw interface */
-    const Spim *pSpim = &sam3nSpim;
-	SpimRwData *pSpimRwData = pSpim->pData;
+    Spim *pSpim = &sam3sSpim;
+    uint8_t i ;
 
     /* Sanity checks */
     assert(pSpim->pSpi == pSpi);
-    assert(pSpimRwData);
 
-    /* Enable clock on SPI */
-    PMC_EnablePeripheral( pSpim->spiId ) ;
-
-    /* Configure the SPIin master mode */
-    SPI_Configure( pSpi, SPI_MR_MSTR | SPI_MR_MODFDIS | SPI_MR_PCS);
+    for ( i = 0 ; i < SPIM_NUM_CS ; i++ )
+    {
+        pSpim->queues[i].pHead = 0 ;
+        pSpim->queues[i].pTail = 0 ;
+        pSpim->queues[i].ucPriority = SPIM_PRIORITY_NORMAL ;
+    }
+    pSpim->pCurrent = 0 ;
+    pSpim->ucLastCs = 0 ;
 
-    /* Disable clock on SPI */
+    /* Configure the SPI in master mode, clock enabled during the transfers only */
+    SPI_Configure( pSpi, pSpim->spiId, SPI_MR_MSTR | SPI_MR_MODFDIS | SPI_MR_PCS_Msk );
     PMC_DisablePeripheral( pSpim->spiId ) ;
 
-    /* Initialize semaphore */
-    vSemaphoreCreateBinary( pSpimRwData->spiSemaphore );
-    if( pSpimRwData->spiSemaphore == NULL )
-    	return SPIM_ERROR;
-    vSemaphoreCreateBinary( pSpimRwData->txvSemaphore );
-    if( pSpimRwData->txvSemaphore == NULL )
-    	return SPIM_ERROR;
-
     /* Configure PIO for SPCK, MOSI and MISO */
-    PIO_Configure(pSpim->spiPins, PIO_LISTSIZE(pSpim->spiPins));
+    PIO_Configure(spiPins, PIO_LISTSIZE(spiPins));
 
-    /* Configure the interrupt with the according priority */
-    NVIC_SetPriority( pSpim->spiId, configMAX_SYSCALL_INTERRUPT_PRIORITY + 16 ) ;
+    /* Configure the interrupt with a priority allowing FreeRTOS API calls */
+    NVIC_SetPriority( pSpim->spiId, (configMAX_SYSCALL_INTERRUPT_PRIORITY >> (8 - __NVIC_PRIO_BITS)) + 1 ) ;
     NVIC_EnableIRQ( pSpim->spiId ) ;
 
     return SPIM_OK;
-
 }
 
 /**
- * \brief Select the slave device. This function shall lock the semaphore
- * to prevent from concurrent acces on another slave device connected to
- * the same SPI HW.
+ * \brief Configures the SPI timings and the priority class for the device
+ * corresponding to the cs.
  *
  * \param pSpi  Pointer to an Spi hw peripheral.
- * \param dwCS      Chip Select
- *
- * \return SPIM_OK = 0 if successful; otherwise, returns SPIM error code.
-  */
-extern ESpimStatus SPIM_LockCS(
-	    Spi *pSpi,
-	    uint8_t ucCS)
+ * \param ucCS  number corresponding to the SPI chip select.
+ * \param dwCSR  SPI_CSR value to setup.
+ * \param ucPriority  SPIM_PRIORITY_xxx class of the device.
+ */
+extern void SPIM_ConfigureCS( Spi* pSpi, uint8_t ucCS, uint32_t dwCSR, uint8_t ucPriority )
 {
     /* pSpim shall be initialized with the instance which corresponds */
     /* to the Spi Hw interface */
-    const Spim *pSpim = &sam3nSpim;
-	SpimRwData *pSpimRwData = pSpim->pData;
+    Spim *pSpim = &sam3sSpim;
 
     /* Sanity checks */
     assert(pSpim->pSpi == pSpi);
-    assert(ucCS < 4);
-    assert(pSpimRwData);
-
-    /* This is the place to test a semaphore as upper layer tasks can do
-	 * concurrent access to the SPI hw */
-    if( xSemaphoreTake( pSpimRwData->spiSemaphore, portMAX_DELAY ) != pdTRUE )
-        return SPIM_BUSY;
+    assert(ucCS < SPIM_NUM_CS); /* Check correct initialization */
+    assert(ucPriority < SPIM_NUM_PRIORITIES);
 
-    /* Enable the SPI clock */
-    PMC_EnablePeripheral( pSpim->spiId ) ;
+    /* Chip select shall not rise between the chunks of a command */
+    dwCSR |= SPI_CSR_CSAAT;
 
-    /* Enable the SPI peripheral */
-    SPI_Enable(pSpi);
+    /* Configure PIO for NPCS */
+    if ( ucCS < PIO_LISTSIZE( csPins ) )
+    {
+        PIO_Configure(&(csPins[ucCS]), 1);
+    }
 
-    /* Select the corresponding chip select */
-    SPI_EnableCs(pSpi, ucCS);
+    /* Configure SPI timings for the corresponding device */
+    PMC_EnablePeripheral( pSpim->spiId ) ;
+    SPI_ConfigureNPCS( pSpi, ucCS, dwCSR ) ;
+    if ( pSpim->pCurrent == 0 )
+    {
+        PMC_DisablePeripheral( pSpim->spiId ) ;
+    }
 
-    return SPIM_OK;
+    pSpim->queues[ucCS].ucPriority = ucPriority ;
 }
 
 /**
- * \brief Select the slave device. This function shall lock the semaphore
- * to prevent from concurrent acces on another slave device connected to
- * the same SPI HW.
+ * \brief Initializes a command: creates the semaphore given when it is
+ * complete. The other fields are set by the caller.
  *
- * \param pSpi  Pointer to an Spi hw peripheral.
+ * \param pCommand  Pointer to the SpimCmd to initialize.
  *
-*/
-extern void SPIM_ReleaseCS(
-	    Spi *pSpi)
+ * \return SPIM_OK = 0 if successful; otherwise, returns SPIM_ERROR.
+ */
+extern ESpimStatus SPIM_InitCommand( SpimCmd *pCommand )
 {
-    /* pSpim shall be initialized with the instance which corresponds */
-    /* to the Spi Hw interface */
-    const Spim *pSpim = &sam3nSpim;
-	SpimRwData *pSpimRwData = pSpim->pData;
-
-    /* Sanity checks */
-    assert(pSpim->pSpi == pSpi);
-
-    /* The following instruction set all NPCS: all transfer are supposed */
-    /* to be achieved */
-    SPI_Disable(pSpi);;
-
-    /* Disable the SPI clock */
-    PMC_DisablePeripheral( pSpim->spiId ) ;
+    pCommand->flags = 0 ;
+    pCommand->callback = 0 ;
+    pCommand->status = SPIM_OK ;
+    pCommand->pNext = 0 ;
+
+    vSemaphoreCreateBinary( pCommand->doneSemaphore );
+    if ( pCommand->doneSemaphore == NULL )
+    {
+        return SPIM_ERROR ;
+    }
+    /* Taken until the command is complete */
+    xSemaphoreTake( pCommand->doneSemaphore, 0 ) ;
 
-    /* This is the place to release a semaphore so upper layer tasks can do
-	* concurrent access to the SPI hw */
-    xSemaphoreGive( pSpimRwData->spiSemaphore );
+    return SPIM_OK ;
 }
 
 /**
- * \brief Configures the SPI timings for the device corresponding to the cs.
+ * \brief Queues a command on the queue of its chip select and returns; the
+ * transfer is started at once if the SPI is idle. The command must not be
+ * modified until it is complete.
  *
  * \param pSpi  Pointer to an Spi hw peripheral.
- * \param ucCS  number corresponding to the SPI chip select.
- * \param dwCSR  SPI_CSR value to setup.
+ * \param pCommand  Pointer to the SpimCmd command to execute.
+ *
+ * \return SPIM_OK = 0 if successful; otherwise, returns SPIM_BUSY if the
+ * command is already queued.
  */
-extern void SPIM_ConfigureCS( Spi* pSpi, uint8_t ucCS, uint32_t dwCSR )
+extern ESpimStatus SPIM_Submit( Spi *pSpi, SpimCmd *pCommand )
 {
     /* pSpim shall be initialized with the instance which corresponds */
     /* to the Spi Hw interface */
-    const Spim *pSpim = &sam3nSpim;
+    Spim *pSpim = &sam3sSpim;
+    SpimQueue *pQueue ;
 
     /* Sanity checks */
     assert(pSpim->pSpi == pSpi);
-    assert(ucCS < 4); /* Check correct initialization */
+    assert(pCommand->cs < SPIM_NUM_CS);
 
-    /* Chip select shall not rise after each transfer */
-    /* It will rise only after RealeaseCS() is invoked */
-    dwCSR |= SPI_CSR_CSAAT;
+    if ( pCommand->status == SPIM_BUSY )
+    {
+        return SPIM_BUSY ;
+    }
 
-    /* Configure PIO for NPCS */
-    PIO_Configure(&(pSpim->csPins[ucCS]), 1);
+    /* Waits while another task holds the SPI for a sequence */
+    BUS_Acquire( BUS_SPI ) ;
 
-    /* Configure SPI timings for the corresponding device */
-    SPI_ConfigureNPCS( pSpi, ucCS, dwCSR ) ;
+    pCommand->offset = 0 ;
+    pCommand->pNext = 0 ;
+    pQueue = &(pSpim->queues[pCommand->cs]) ;
+
+    /* The queues are shared with the SPI interrupt */
+    taskENTER_CRITICAL() ;
 
+    if ( pQueue->pTail )
+    {
+        pQueue->pTail->pNext = pCommand ;
+    }
+    else
+    {
+        pQueue->pHead = pCommand ;
+    }
+    pQueue->pTail = pCommand ;
+
+    if ( pSpim->pCurrent == 0 )
+    {
+        PMC_EnablePeripheral( pSpim->spiId ) ;
+        _StartChunk( pSpim, _SelectCommand( pSpim ) ) ;
+    }
+
+    taskEXIT_CRITICAL() ;
+
+    BUS_Release( BUS_SPI ) ;
+
+    return SPIM_OK ;
 }
 
 /**
- * \brief Sends a character through the SPI. The command is made up
- * of two parts: the first is used to transmit the command byte and optionally,
- * address and dummy bytes. The second part is the data to send or receive.
- * This function does not block: it returns as soon as the transfer has been
- * started. An optional callback can be invoked to notify the end of transfer.
+ * \brief Blocks the calling task until a submitted command is complete.
  *
- * \param pSpi  Pointer to an Spi hw peripheral.
- * \param pwData  Pointer to the SpimCmd command to execute.
+ * \param pCommand  Pointer to the SpimCmd command.
+ * \param xTicksToWait  Maximum time to wait, portMAX_DELAY to wait forever.
  *
- * \return SPIM_SUCCESS = 0 if successful; otherwise, returns SPIM error code.
+ * \return The command status; SPIM_BUSY if it is not complete.
  */
-extern ESpimStatus SPIM_TransferData(
-    Spi *pSpi,
-    uint16_t wOutData,
-    uint16_t *pwInData)
+extern ESpimStatus SPIM_Wait( SpimCmd *pCommand, portTickType xTicksToWait )
 {
-    /* pSpim shall be initialized with the instance which corresponds */
-    /* to the Spi Hw interface */
-    const Spim *pSpim = &sam3nSpim;
-    SpimRwData  *pSpimRwData = pSpim->pData;
+    assert(pCommand->doneSemaphore);
 
-    /* Sanity checks */
-    assert(pSpim->pSpi == pSpi);
-
-    /* Use a semaphore as an event  */
-    if( xSemaphoreTake( pSpimRwData->txvSemaphore, portMAX_DELAY ) != pdTRUE )
-        return SPIM_ERROR;
-
-    /* Output a data */
-    SPI_Write( pSpi, 0, wOutData );
+    if ( xSemaphoreTake( pCommand->doneSemaphore, xTicksToWait ) != pdTRUE )
+    {
+        return SPIM_BUSY ;
+    }
 
-    /* Enable buffer complete interrupt*/
-    SPI_EnableIt( pSpi, SPI_IER_RDRF );
+    return pCommand->status ;
+}
 
-    /* Poll the end of transfer waiting that ISR releases the semaphore  */
-     if( xSemaphoreTake( pSpimRwData->txvSemaphore, portMAX_DELAY ) != pdPASS )
-         return SPIM_ERROR;
-     xSemaphoreGive( pSpimRwData->txvSemaphore );
+/**
+ * \brief Executes a command, blocking the calling task until it is complete.
+ * Other tasks run meanwhile.
+ *
+ * \param pSpi  Pointer to an Spi hw peripheral.
+ * \param pCommand  Pointer to the SpimCmd command to execute.
+ *
+ * \return SPIM_OK = 0 if successful; otherwise, returns SPIM error code.
+ */
+extern ESpimStatus SPIM_Transfer( Spi *pSpi, SpimCmd *pCommand )
+{
+    ESpimStatus status ;
 
-    /* Return the data received */
-    if (pwInData) {
-    	*pwInData = SPI_Read( pSpi );
+    status = SPIM_Submit( pSpi, pCommand ) ;
+    if ( status != SPIM_OK )
+    {
+        return status ;
     }
-    /* TODO: handle transfer status */
-    return (pSpimRwData->txvStatus);
+
+    return SPIM_Wait( pCommand, portMAX_DELAY ) ;
 }
 
 /**
- * \brief Starts a SPI master transfer.
+ * \brief Holds the SPI for a sequence of commands of the calling task: the
+ * other tasks cannot queue commands until SPIM_Unlock(). The commands queued
+ * before keep their turn. Calls may be nested.
  *
  * \param pSpi  Pointer to an Spi hw peripheral.
- * \param pOutBuffer Pointer to the buffer to send.
- * \param pInBuffer Pointer memory buffer to store data received
- * \param bufferSize Buffer size
- * \return SPIM_OK if the transfer has been started successfully; otherwise returns
- * SPIM_BUSY is the driver is in use, or SPIM_ERROR if the command is not
- * valid.
  */
-extern ESpimStatus SPIM_TransferBuffer(
-		Spi *pSpi,
-		const uint16_t *pOutBuffer,
-		uint16_t *pInBuffer,
-                uint16_t wBufferSize)
+extern void SPIM_Lock( Spi *pSpi )
 {
-    /* pSpim shall be initialized with the instance which corresponds */
-    /* to the Spi Hw interface */
-    const Spim *pSpim = &sam3nSpim;
-    SpimRwData  *pSpimRwData = pSpim->pData;
+    assert(sam3sSpim.pSpi == pSpi);
 
-    /* Sanity checks */
-    assert(pSpim->pSpi == pSpi);
-
-    /* Use a semaphore as an event  */
-    if( xSemaphoreTake( pSpimRwData->txvSemaphore, portMAX_DELAY ) != pdTRUE )
-        return SPIM_ERROR;
-
-    /* Disable transmitter and receiver*/
-    SPI_PdcDisableRx( pSpi ) ;
-    SPI_PdcDisableTx( pSpi ) ;
+    BUS_Acquire( BUS_SPI ) ;
+}
 
-    /* Initialize the two SPI PDC buffer and enable transmitter or receiver*/
-    SPI_WriteBuffer( pSpi, pOutBuffer,  wBufferSize ) ;
-    if (pInBuffer) {
-        SPI_ReadBuffer ( pSpi, pInBuffer, wBufferSize ) ;
-        SPI_PdcEnableRx( pSpi ) ;
-        SPI_EnableIt( pSpi, SPI_IER_RXBUFF ) ;
-    }
-    else {
-        SPI_EnableIt( pSpi, SPI_IER_TXBUFE ) ;
-    }
-    SPI_PdcEnableTx( pSpi ) ;
+/**
+ * \brief Ends a sequence started by SPIM_Lock().
+ *
+ * \param pSpi  Pointer to an Spi hw peripheral.
+ */
+extern void SPIM_Unlock( Spi *pSpi )
+{
+    assert(sam3sSpim.pSpi == pSpi);
 
-    /* Poll the end of transfer waiting that ISR releases the semaphore  */
-     if( xSemaphoreTake( pSpimRwData->txvSemaphore, portMAX_DELAY ) != pdTRUE )
-         return SPIM_ERROR;
-     
-     /* Some data may still be pending in the TDR and in the shift register */
-     if (pInBuffer == NULL) {
-        SPI_EnableIt( pSpi, SPI_IER_TXEMPTY ) ;
-         if( xSemaphoreTake( pSpimRwData->txvSemaphore, portMAX_DELAY ) != pdTRUE )
-             return SPIM_ERROR;
-     }
-     xSemaphoreGive( pSpimRwData->txvSemaphore );
-
-    /* If no receive buffer have been allocated then all values have been accululated */
-    /* in the same register so getting OVERRUN error is normal */
-    if ((pSpimRwData->txvStatus == SPIM_ERROR_OVERRUN) && (pInBuffer == NULL)) {
-        pSpimRwData->txvStatus = SPIM_OK;
-    }
-    /* TODO: handle transfer status */
-    return (pSpimRwData->txvStatus);
+    BUS_Release( BUS_SPI ) ;
 }
-
@@ -0,0 +1,317 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * SAM3S low power layer of the FreeRTOS tickless idle, see tickless_idle.h.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "tickless_idle.h"
+
+#if ( configUSE_TICKLESS_IDLE == 1 )
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** RTT counting frequency, TICKLESS_RTT_PRESCALER must be a power of two. */
+#define RTT_HZ                  (32768u / TICKLESS_RTT_PRESCALER)
+
+/** Shortest sleep, in RTT periods, the alarm must be ahead of the counter. */
+#define RTT_MIN_PERIODS         2
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** RTT configured for the tickless idle. */
+static uint32_t _dwRttStarted = 0 ;
+
+/** Number of TICKLESS_LockWaitMode() calls not yet released. */
+static volatile uint32_t _dwWaitModeLocks = 0 ;
+
+/** Working clock saved before the wait mode. */
+static uint32_t _dwMorBackup ;
+static uint32_t _dwPllarBackup ;
+static uint32_t _dwPllbrBackup ;
+static uint32_t _dwMckrBackup ;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Converts microseconds into RTT periods, rounded down.
+ */
+static uint32_t _UsToRtt( uint32_t dwUs )
+{
+    return (dwUs / 1000000u) * RTT_HZ + ((dwUs % 1000000u) * (RTT_HZ / 64u)) / (1000000u / 64u) ;
+}
+
+/**
+ * \brief Converts RTT periods into microseconds, rounded down.
+ */
+static uint32_t _RttToUs( uint32_t dwPeriods )
+{
+    return (dwPeriods / RTT_HZ) * 1000000u + ((dwPeriods % RTT_HZ) * (1000000u / 64u)) / (RTT_HZ / 64u) ;
+}
+
+/**
+ * \brief Reads the RTT counter. The counter runs on the slow clock, it is
+ * read until two reads match.
+ */
+static uint32_t _GetRttTime( void )
+{
+    uint32_t dwTime ;
+
+    do
+    {
+        dwTime = RTT_GetTime( RTT ) ;
+    } while ( dwTime != RTT_GetTime( RTT ) ) ;
+
+    return dwTime ;
+}
+
+/**
+ * \brief Saves the working clock and moves the master clock to the 4 MHz
+ * fast RC oscillator, the crystal and the PLLs being stopped. The working
+ * clock may be the slow clock, e.g. in USB suspend.
+ */
+static void _SwitchToFastRC( void )
+{
+    _dwMorBackup = PMC->CKGR_MOR ;
+    _dwPllarBackup = PMC->CKGR_PLLAR ;
+    _dwPllbrBackup = PMC->CKGR_PLLBR ;
+    _dwMckrBackup = PMC->PMC_MCKR ;
+
+    /* Main clock running, even when the working clock is the slow clock */
+    if ( !(_dwMorBackup & CKGR_MOR_MOSCSEL) && !(_dwMorBackup & CKGR_MOR_MOSCRCEN) )
+    {
+        PMC->CKGR_MOR = CKGR_MOR_KEY(0x37) | (_dwMorBackup & CKGR_MOR_MOSCXTST_Msk) | CKGR_MOR_MOSCRCEN ;
+        while ( !(PMC->PMC_SR & PMC_SR_MOSCRCS) ) ;
+    }
+
+    /* Master clock on the main clock, still the crystal */
+    PMC->PMC_MCKR = (PMC->PMC_MCKR & (uint32_t)~PMC_MCKR_CSS_Msk) | PMC_MCKR_CSS_MAIN_CLK ;
+    while ( !(PMC->PMC_SR & PMC_SR_MCKRDY) ) ;
+    PMC->PMC_MCKR = (PMC->PMC_MCKR & (uint32_t)~PMC_MCKR_PRES_Msk) | PMC_MCKR_PRES_CLK ;
+    while ( !(PMC->PMC_SR & PMC_SR_MCKRDY) ) ;
+
+    /* Main clock on the fast RC oscillator */
+    PMC->CKGR_MOR = CKGR_MOR_KEY(0x37) | (_dwMorBackup & CKGR_MOR_MOSCXTST_Msk) | CKGR_MOR_MOSCSEL | CKGR_MOR_MOSCXTEN | CKGR_MOR_MOSCRCEN ;
+    while ( !(PMC->PMC_SR & PMC_SR_MOSCRCS) ) ;
+    PMC->CKGR_MOR = CKGR_MOR_KEY(0x37) | (_dwMorBackup & CKGR_MOR_MOSCXTST_Msk) | CKGR_MOR_MOSCXTEN | CKGR_MOR_MOSCRCEN ;
+    while ( !(PMC->PMC_SR & PMC_SR_MOSCSELS) ) ;
+
+    /* Stop the PLLs and the crystal */
+    PMC->CKGR_PLLAR = CKGR_PLLAR_STUCKTO1 ;
+    PMC->CKGR_PLLBR = 0 ;
+    PMC->CKGR_MOR = CKGR_MOR_KEY(0x37) | CKGR_MOR_MOSCRCEN ;
+}
+
+/**
+ * \brief Restores the working clock saved by _SwitchToFastRC().
+ */
+static void _RestoreWorkingClock( void )
+{
+    /* Restart the crystal and select it as main clock, if it was */
+    if ( _dwMorBackup & CKGR_MOR_MOSCSEL )
+    {
+        PMC->CKGR_MOR = CKGR_MOR_KEY(0x37) | (_dwMorBackup & CKGR_MOR_MOSCXTST_Msk) | CKGR_MOR_MOSCRCEN | CKGR_MOR_MOSCXTEN ;
+        while ( !(PMC->PMC_SR & PMC_SR_MOSCXTS) ) ;
+        PMC->CKGR_MOR = CKGR_MOR_KEY(0x37) | (_dwMorBackup & CKGR_MOR_MOSCXTST_Msk) | CKGR_MOR_MOSCRCEN | CKGR_MOR_MOSCXTEN | CKGR_MOR_MOSCSEL ;
+        while ( !(PMC->PMC_SR & PMC_SR_MOSCSELS) ) ;
+    }
+
+    /* Restart the PLLs */
+    if ( (_dwPllarBackup & CKGR_PLLAR_MULA_Msk) != 0 )
+    {
+        PMC->CKGR_PLLAR = _dwPllarBackup ;
+        while ( !(PMC->PMC_SR & PMC_SR_LOCKA) ) ;
+    }
+
+    if ( (_dwPllbrBackup & CKGR_PLLBR_MULB_Msk) != 0 )
+    {
+        PMC->CKGR_PLLBR = _dwPllbrBackup ;
+        while ( !(PMC->PMC_SR & PMC_SR_LOCKB) ) ;
+    }
+
+    /* Prescaler first, then the clock source */
+    PMC->PMC_MCKR = (_dwMckrBackup & (uint32_t)~PMC_MCKR_CSS_Msk) | PMC_MCKR_CSS_MAIN_CLK ;
+    while ( !(PMC->PMC_SR & PMC_SR_MCKRDY) ) ;
+    PMC->PMC_MCKR = _dwMckrBackup ;
+    while ( !(PMC->PMC_SR & PMC_SR_MCKRDY) ) ;
+
+    /* Oscillators stopped by the application stay stopped */
+    PMC->CKGR_MOR = CKGR_MOR_KEY(0x37) | (_dwMorBackup & (uint32_t)~CKGR_MOR_KEY_Msk) ;
+}
+
+/**
+ * \brief Enters the sleep mode, any enabled interrupt wakes the processor up.
+ */
+static void _EnterSleepMode( void )
+{
+    PMC->PMC_FSMR &= (uint32_t)~PMC_FSMR_LPM ;
+    SCB->SCR &= (uint32_t)~SCB_SCR_SLEEPDEEP_Msk ;
+    __DSB() ;
+    __WFI() ;
+}
+
+/**
+ * \brief Enters the wait mode, the RTT alarm or an enabled fast startup input
+ * wakes the processor up. The master clock must be on the fast RC oscillator.
+ */
+static void _EnterWaitMode( void )
+{
+    uint32_t i ;
+
+    PMC->PMC_FSMR |= PMC_FSMR_RTTAL | PMC_FSMR_LPM ;
+    SCB->SCR &= (uint32_t)~SCB_SCR_SLEEPDEEP_Msk ;
+    __DSB() ;
+    __WFE() ;
+
+    /* Waiting for MOSCRCEN bit is cleared is strongly recommended
+     * to ensure that the core will not execute undesired instructions
+     */
+    for ( i = 0 ; i < 500 ; i++ )
+    {
+        __NOP() ;
+    }
+    while ( !(PMC->CKGR_MOR & CKGR_MOR_MOSCRCEN) ) ;
+
+    PMC->PMC_FSMR &= (uint32_t)~(PMC_FSMR_RTTAL | PMC_FSMR_LPM) ;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief RTT interrupt handler: the alarm only wakes the processor up.
+ */
+extern void RTT_IrqHandler( void )
+{
+    RTT_GetStatus( RTT ) ;
+    RTT->RTT_MR &= (uint32_t)~RTT_MR_ALMIEN ;
+}
+
+/**
+ * \brief Sleeps for at most ulSleepUs microseconds, called by the port with
+ * interrupts disabled.
+ * \param ulSleepUs  Time until the next wake time.
+ * \return Time actually slept, in microseconds.
+ */
+extern unsigned long ulPortLowPowerSleep( unsigned long ulSleepUs )
+{
+    uint32_t dwPeriods ;
+    uint32_t dwStart ;
+    uint32_t dwWait ;
+
+    if ( !_dwRttStarted )
+    {
+        RTT_SetPrescaler( RTT, TICKLESS_RTT_PRESCALER ) ;
+        NVIC_ClearPendingIRQ( RTT_IRQn ) ;
+        NVIC_EnableIRQ( RTT_IRQn ) ;
+        _dwRttStarted = 1 ;
+    }
+
+    /* Wait mode when long enough and allowed, woken up early enough to have
+       the clocks back on time */
+    dwWait = (TICKLESS_WAIT_MODE && (_dwWaitModeLocks == 0) && (ulSleepUs >= TICKLESS_WAIT_MIN_US)) ;
+    if ( dwWait )
+    {
+        ulSleepUs -= TICKLESS_WAIT_WAKEUP_US ;
+    }
+
+    dwPeriods = _UsToRtt( ulSleepUs ) ;
+    if ( dwPeriods < RTT_MIN_PERIODS )
+    {
+        return 0 ;
+    }
+
+    /* The clock is switched before the alarm is set: an alarm already past
+       when the wait mode is entered would not wake the processor up */
+    if ( dwWait )
+    {
+        _SwitchToFastRC() ;
+    }
+
+    dwStart = _GetRttTime() ;
+    RTT_SetAlarm( RTT, dwStart + dwPeriods ) ;
+    RTT_GetStatus( RTT ) ;
+    RTT_EnableIT( RTT, RTT_MR_ALMIEN ) ;
+
+    if ( dwWait )
+    {
+        if ( _GetRttTime() - dwStart < dwPeriods - 1 )
+        {
+            _EnterWaitMode() ;
+        }
+        _RestoreWorkingClock() ;
+    }
+    else
+    {
+        _EnterSleepMode() ;
+    }
+
+    RTT->RTT_MR &= (uint32_t)~RTT_MR_ALMIEN ;
+
+    return _RttToUs( _GetRttTime() - dwStart ) ;
+}
+
+/**
+ * \brief Forbids the wait mode, for instance while a transfer needs the
+ * peripheral clocks. Calls may be nested.
+ */
+extern void TICKLESS_LockWaitMode( void )
+{
+    taskENTER_CRITICAL() ;
+    _dwWaitModeLocks++ ;
+    taskEXIT_CRITICAL() ;
+}
+
+/**
+ * \brief Releases a TICKLESS_LockWaitMode() call.
+ */
+extern void TICKLESS_UnlockWaitMode( void )
+{
+    taskENTER_CRITICAL() ;
+    if ( _dwWaitModeLocks > 0 )
+    {
+        _dwWaitModeLocks-- ;
+    }
+    taskEXIT_CRITICAL() ;
+}
+
+#endif /* configUSE_TICKLESS_IDLE */
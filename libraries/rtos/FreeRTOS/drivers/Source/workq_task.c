@@ -0,0 +1,112 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * FreeRTOS worker of the deferred interrupt work queue.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "workq_task.h"
+
+#include "semphr.h"
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Given when an item is posted to the empty queue. */
+static xSemaphoreHandle _xWorkSignal = NULL ;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Wakes up the worker task, from an interrupt handler or a task.
+ */
+static void _WORKQ_Kick( void )
+{
+    portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE ;
+
+    if ( (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) != 0 )
+    {
+        xSemaphoreGiveFromISR( _xWorkSignal, &xHigherPriorityTaskWoken ) ;
+        portEND_SWITCHING_ISR( xHigherPriorityTaskWoken ) ;
+    }
+    else
+    {
+        xSemaphoreGive( _xWorkSignal ) ;
+    }
+}
+
+/**
+ * \brief Worker task: runs the posted items each time it is woken up.
+ */
+static void _WORKQ_Task( void *pvParameters )
+{
+    for ( ; ; )
+    {
+        xSemaphoreTake( _xWorkSignal, portMAX_DELAY ) ;
+        WORKQ_Run() ;
+    }
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initializes the work queue and creates its worker task.
+ *
+ * \param uxPriority  Priority of the worker task.
+ * \param usStackDepth  Stack of the worker task, in words; it must fit the
+ *                      deepest work item (USB requests when the USB interrupt
+ *                      is deferred).
+ *
+ * \return pdPASS if the task is created, otherwise an error code.
+ */
+extern portBASE_TYPE WORKQ_StartTask( unsigned portBASE_TYPE uxPriority, unsigned short usStackDepth )
+{
+    vSemaphoreCreateBinary( _xWorkSignal ) ;
+    if ( _xWorkSignal == NULL )
+    {
+        return errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY ;
+    }
+    /* The binary semaphore is created given */
+    xSemaphoreTake( _xWorkSignal, 0 ) ;
+
+    WORKQ_Initialize( _WORKQ_Kick ) ;
+
+    return xTaskCreate( _WORKQ_Task, ( signed char * ) "WorkQ", usStackDepth, NULL, uxPriority, NULL ) ;
+}
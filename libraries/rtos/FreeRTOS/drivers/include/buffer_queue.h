@@ -0,0 +1,100 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Interface of the FreeRTOS buffer queues: zero-copy message passing by
+ * buffer ownership transfer.
+ *
+ */
+
+#ifndef _BUFFER_QUEUE_
+#define _BUFFER_QUEUE_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "board.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Message of a buffer queue: a buffer and the number of valid bytes.
+ */
+typedef struct _BufQueueSlot
+{
+    void *pBuffer ;
+    uint32_t dwSize ;
+} BufQueueSlot ;
+
+/**
+ * \brief Single-producer, single-consumer queue of buffers. The producer
+ * only writes dwHead, the consumer only writes dwTail; ulWaiting is the only
+ * word written by both, with LDREX/STREX.
+ */
+typedef struct _BufQueue
+{
+    /** Ring of messages, dwCount slots. */
+    BufQueueSlot *pSlots ;
+    /** Number of slots; the queue holds dwCount-1 messages. */
+    uint32_t dwCount ;
+    /** Next slot written by the producer. */
+    volatile uint32_t dwHead ;
+    /** Next slot read by the consumer. */
+    volatile uint32_t dwTail ;
+    /** Set by the consumer before it blocks on xSignal. */
+    volatile uint32_t ulWaiting ;
+    /** Given by the producer to wake up a blocked consumer. */
+    xSemaphoreHandle xSignal ;
+    /** Pool the buffers come from. */
+    MemPool *pPool ;
+} BufQueue ;
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern uint32_t BUFQ_Initialize( BufQueue *pQueue, BufQueueSlot *pSlots, uint32_t dwCount, MemPool *pPool ) ;
+
+extern void* BUFQ_Alloc( BufQueue *pQueue ) ;
+
+extern void BUFQ_Release( BufQueue *pQueue, void *pBuffer ) ;
+
+extern uint32_t BUFQ_Post( BufQueue *pQueue, void *pBuffer, uint32_t dwSize ) ;
+
+extern void* BUFQ_Receive( BufQueue *pQueue, uint32_t *pdwSize, portTickType xTicksToWait ) ;
+
+extern uint32_t BUFQ_GetPending( BufQueue *pQueue ) ;
+
+#endif /* #ifndef _BUFFER_QUEUE_ */
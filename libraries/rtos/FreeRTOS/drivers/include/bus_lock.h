@@ -0,0 +1,127 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Interface of the FreeRTOS bus locks: a mutex per shared bus (SMC, SPI)
+ * with priority inheritance, hold time limit and contention statistics.
+ *
+ * The lock is a FreeRTOS mutex, so a low priority task holding a bus runs at
+ * the priority of the highest task waiting for it until it gives the bus
+ * back. The lock can be taken again by its owner (nested takes), as the
+ * drivers acquire the bus both in their public functions and in their
+ * register accesses.
+ *
+ * The hold limit is a budget, not a preemption: the drivers release the bus
+ * between their sequences, and a task holding a bus for a long sequence of
+ * its own calls BUSLOCK_Yield() at safe points to let the waiting tasks in
+ * once the limit is exceeded. The holds exceeding the limit are counted.
+ *
+ * BUSLOCK_ConnectBus() makes the libchip bus hooks (bus.h) use a lock, so
+ * that the NAND flash, LCD and SPI master drivers are arbitrated:
+ * \code
+ * static BusLock smcLock ;
+ *
+ * BUSLOCK_Initialize( &smcLock, 5 / portTICK_RATE_MS ) ;
+ * BUSLOCK_ConnectBus( BUS_SMC, &smcLock ) ;
+ * \endcode
+ *
+ * The locks are used by tasks only, never from an interrupt handler.
+ *
+ */
+
+#ifndef _BUS_LOCK_
+#define _BUS_LOCK_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "board.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Contention statistics of a bus lock, in ticks for the times. */
+typedef struct _BusLockStats
+{
+    /** Outermost takes. */
+    uint32_t ulTakes ;
+    /** Takes which found the lock held by another task. */
+    uint32_t ulContended ;
+    /** Takes which timed out. */
+    uint32_t ulTimeouts ;
+    /** Holds longer than the hold limit. */
+    uint32_t ulOverruns ;
+    /** Sum and maximum of the contended waits. */
+    portTickType xTotalWait ;
+    portTickType xMaxWait ;
+    /** Longest hold. */
+    portTickType xMaxHold ;
+} BusLockStats ;
+
+/** Bus lock. */
+typedef struct _BusLock
+{
+    xSemaphoreHandle xMutex ;
+    /** Owning task and its nested takes. */
+    volatile xTaskHandle xOwner ;
+    uint32_t ulNesting ;
+    /** Tasks blocked on the mutex. */
+    volatile uint32_t ulWaiting ;
+    /** Hold time limit, 0 for none. */
+    portTickType xHoldLimit ;
+    /** Tick of the outermost take. */
+    portTickType xTaken ;
+    BusLockStats stats ;
+} BusLock ;
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern uint32_t BUSLOCK_Initialize( BusLock *pLock, portTickType xHoldLimit ) ;
+
+extern uint32_t BUSLOCK_Take( BusLock *pLock, portTickType xTicksToWait ) ;
+
+extern void BUSLOCK_Give( BusLock *pLock ) ;
+
+extern uint32_t BUSLOCK_Yield( BusLock *pLock ) ;
+
+extern void BUSLOCK_GetStats( BusLock *pLock, BusLockStats *pStats ) ;
+
+extern void BUSLOCK_ResetStats( BusLock *pLock ) ;
+
+extern void BUSLOCK_ConnectBus( uint32_t ulBus, BusLock *pLock ) ;
+
+#endif /* #ifndef _BUS_LOCK_ */
@@ -0,0 +1,86 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Interface of the FreeRTOS event flags: a task waits for any or all of a set
+ * of bits, set by other tasks or by interrupt handlers.
+ *
+ * EVF_ConnectIoEvents() makes the I/O events raised by the drivers (see
+ * ioevent.h) set the same bits in an EventFlags, so that a task can wait at
+ * once for the USB state, the console and its transfer completions.
+ *
+ * An EventFlags has a single waiting task; the bits can be set by any number
+ * of tasks and handlers. The handlers must have a priority allowing FreeRTOS
+ * API calls (configMAX_SYSCALL_INTERRUPT_PRIORITY or lower).
+ *
+ */
+
+#ifndef _EVENT_FLAGS_
+#define _EVENT_FLAGS_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "board.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Event flags. The bits are updated with LDREX/STREX, the semaphore
+ * wakes the waiting task up when bits are set.
+ */
+typedef struct _EventFlags
+{
+    volatile uint32_t ulBits ;
+    xSemaphoreHandle xSignal ;
+} EventFlags ;
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern uint32_t EVF_Initialize( EventFlags *pFlags ) ;
+
+extern void EVF_Set( EventFlags *pFlags, uint32_t ulBits ) ;
+
+extern void EVF_Clear( EventFlags *pFlags, uint32_t ulBits ) ;
+
+extern uint32_t EVF_Get( EventFlags *pFlags ) ;
+
+extern uint32_t EVF_Wait( EventFlags *pFlags, uint32_t ulBits, uint32_t ulWaitAll, uint32_t ulClear, portTickType xTicksToWait ) ;
+
+extern void EVF_ConnectIoEvents( EventFlags *pFlags ) ;
+
+#endif /* #ifndef _EVENT_FLAGS_ */
@@ -0,0 +1,149 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Interface of the FreeRTOS SPI master driver.
+ *
+ * The commands are queued with the SPI bus acquired (BUS_SPI, see bus.h).
+ * A task running a sequence of commands which must not be interleaved with
+ * the commands of other tasks, e.g. a serial flash write-enable, program and
+ * status polling, holds the bus between SPIM_Lock() and SPIM_Unlock(); when
+ * the bus is arbitrated by a bus lock (bus_lock.h), the other tasks block in
+ * SPIM_Submit() meanwhile and lend their priority to the holder.
+ *
+ */
+
+#ifndef _SPIM_DRIVER_
+#define _SPIM_DRIVER_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "board.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of chip selects of the SPI. */
+#define SPIM_NUM_CS             4
+
+/** Priority classes of the chip selects: between two chunks, the SPI is
+    given to the highest class (lowest value) having a command queued. */
+#define SPIM_PRIORITY_HIGH      0
+#define SPIM_PRIORITY_NORMAL    1
+#define SPIM_PRIORITY_BULK      2
+#define SPIM_NUM_PRIORITIES     3
+
+/** Bytes transferred between two scheduling points. */
+#ifndef SPIM_CHUNK_SIZE
+#define SPIM_CHUNK_SIZE         512
+#endif
+
+/** The command may be suspended between two chunks for a command of a
+    higher class: its chip select is released and the remaining data is
+    transferred later, without the command bytes. */
+#define SPIM_FLAG_PREEMPTIBLE   (1 << 0)
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** SPI master status codes. */
+typedef enum _ESpimStatus
+{
+    SPIM_OK = 0,
+    SPIM_BUSY,
+    SPIM_ERROR,
+    SPIM_ERROR_OVERRUN
+} ESpimStatus ;
+
+struct _SpimCmd ;
+
+/** Command complete callback, invoked from the interrupt. */
+typedef void (*SpimCallback)( struct _SpimCmd *pCommand ) ;
+
+/**
+ * \brief SPI master command: the command bytes are sent first, then the
+ * data. The data received is stored in place of the data sent.
+ */
+typedef struct _SpimCmd
+{
+    /** Pointer to the command bytes. */
+    uint8_t *pCmd ;
+    /** Number of command bytes. */
+    uint8_t cmdSize ;
+    /** Chip select of the device. */
+    uint8_t cs ;
+    /** SPIM_FLAG_xxx flags. */
+    uint8_t flags ;
+    /** Pointer to the data sent and received. */
+    uint8_t *pData ;
+    /** Number of data bytes. */
+    uint32_t dataSize ;
+    /** Optional callback. */
+    SpimCallback callback ;
+    /** Given when the command is complete (see SPIM_InitCommand()). */
+    xSemaphoreHandle doneSemaphore ;
+    /** Command status, SPIM_BUSY until the command is complete. */
+    volatile ESpimStatus status ;
+    /** Bytes transferred (managed by the driver). */
+    uint32_t offset ;
+    /** Next command queued for the same chip select (managed by the driver). */
+    struct _SpimCmd *pNext ;
+} SpimCmd ;
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern void SPIM_Handler( void ) ;
+
+extern ESpimStatus SPIM_Initialize( Spi* pSpi ) ;
+
+extern void SPIM_ConfigureCS( Spi* pSpi, uint8_t ucCS, uint32_t dwCSR, uint8_t ucPriority ) ;
+
+extern ESpimStatus SPIM_InitCommand( SpimCmd *pCommand ) ;
+
+extern ESpimStatus SPIM_Submit( Spi *pSpi, SpimCmd *pCommand ) ;
+
+extern ESpimStatus SPIM_Wait( SpimCmd *pCommand, portTickType xTicksToWait ) ;
+
+extern ESpimStatus SPIM_Transfer( Spi *pSpi, SpimCmd *pCommand ) ;
+
+extern void SPIM_Lock( Spi *pSpi ) ;
+
+extern void SPIM_Unlock( Spi *pSpi ) ;
+
+#endif /* #ifndef _SPIM_DRIVER_ */
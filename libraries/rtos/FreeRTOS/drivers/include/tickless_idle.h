@@ -0,0 +1,107 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Interface of the SAM3S low power layer of the FreeRTOS tickless idle.
+ *
+ * When configUSE_TICKLESS_IDLE is 1, the idle task stops SysTick whenever no
+ * task is due to run for a while and calls ulPortLowPowerSleep(). The RTT,
+ * clocked by the slow clock, is programmed to wake the processor up at the
+ * next wake time and measures the time actually slept, from which the port
+ * corrects the tick count. The RTT belongs to the tickless idle and must not
+ * be used by the application.
+ *
+ * Short idle periods use the sleep mode, where any enabled interrupt wakes
+ * the processor up. Long ones use the wait mode: the master clock is moved to
+ * the fast RC oscillator, the crystal and the PLLs are stopped, and only the
+ * RTT alarm and the fast startup inputs enabled in PMC_FSMR wake the
+ * processor up. The wake-up is programmed early by the crystal and PLL
+ * restart time, so that tasks still run on time. The peripheral clocks stop
+ * in wait mode: a driver with a transfer in progress must hold
+ * TICKLESS_LockWaitMode() until it is done.
+ *
+ * The tick accuracy over a sleep is the one of the slow clock, use the 32 kHz
+ * crystal (selected by LowLevelInit()).
+ *
+ * A USB device suspended in USBD_SUSPEND_SLOWCLOCK mode (see
+ * USBD_HAL_SetSuspendPowerMode()) runs from the slow clock and leaves the
+ * wait mode on bus activity. Its tasks should block until the next
+ * IOEVT_USB_STATE event (EVF_ConnectIoEvents()), so that the idle task moves
+ * it to wait mode for the time of the suspend. Since SysTick then counts slow
+ * clock cycles, the tick drifts while tasks run in suspend: only the time
+ * spent in wait mode is measured with the RTT.
+ */
+
+#ifndef _TICKLESS_IDLE_
+#define _TICKLESS_IDLE_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "board.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** RTT prescaler: 32768 Hz / 4 gives 122 us resolution and a 6 days range. */
+#ifndef TICKLESS_RTT_PRESCALER
+#define TICKLESS_RTT_PRESCALER      4
+#endif
+
+/** Use the wait mode for long idle periods (0: sleep mode only). */
+#ifndef TICKLESS_WAIT_MODE
+#define TICKLESS_WAIT_MODE          1
+#endif
+
+/** Shortest idle period, in microseconds, spent in wait mode. */
+#ifndef TICKLESS_WAIT_MIN_US
+#define TICKLESS_WAIT_MIN_US        20000
+#endif
+
+/** Time needed to restart the crystal and the PLLs after the wait mode. */
+#ifndef TICKLESS_WAIT_WAKEUP_US
+#define TICKLESS_WAIT_WAKEUP_US     5000
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern unsigned long ulPortLowPowerSleep( unsigned long ulSleepUs ) ;
+
+extern void TICKLESS_LockWaitMode( void ) ;
+
+extern void TICKLESS_UnlockWaitMode( void ) ;
+
+#endif /* #ifndef _TICKLESS_IDLE_ */
@@ -0,0 +1,496 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \addtogroup taskprof_module Task profiler
+ * The task profiler gives, for each task of FreeRTOS or CoOS, the CPU time
+ * it used, the number of times it was switched in and the stack margin it
+ * kept, on production units and without a debugger.
+ *
+ * \section Usage
+ * <ul>
+ * <li> Enable the RTOS glue: configUSE_TASK_PROFILER in FreeRTOSConfig.h, or
+ *    CFG_TASK_PROFILE_EN in the CoOS OsConfig.h.</li>
+ * <li> Call TASKPROF_Initialize() before creating the tasks; it starts the
+ *    TC channel of the time base (TASKPROF_TC).</li>
+ * <li> Call TASKPROF_Dump() periodically or on a console command, giving it
+ *    a function writing bytes to the UART console or to the CDC serial port.
+ *    TASKPROF_Reset() starts a new measurement window.</li>
+ * <li> Decode the frames on the host with taskprof.py.</li>
+ * </ul>
+ * The accounting runs with the interrupts masked for a lookup in the task
+ * table per context switch. The time spent in the interrupt handlers is
+ * charged to the task they interrupted.
+ *
+ * Related files :\n
+ * \ref taskprof.c\n
+ * \ref taskprof.h.\n
+*/
+/*@{*/
+/*@}*/
+
+
+/**
+ * \file
+ *
+ * Implementation of the task profiler.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "board.h"
+#include "taskprof.h"
+
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+
+/** Statistics of a task. */
+typedef struct _TaskProfEntry
+{
+    /** RTOS task, NULL for a free entry. */
+    const void* pTask ;
+    /** Lowest word of the stack, NULL when unknown. */
+    const uint32_t* pdwStack ;
+    uint32_t dwStackWords ;
+    /** Value the unused stack words are painted with. */
+    uint32_t dwFill ;
+    uint32_t dwId ;
+    /** Time spent running since the last reset. */
+    uint32_t dwTime ;
+    /** Times switched in since the last reset. */
+    uint32_t dwSwitches ;
+    char acName[TASKPROF_NAME_SIZE] ;
+} TaskProfEntry ;
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Registered tasks. */
+static TaskProfEntry _aTasks[TASKPROF_MAX_TASKS] ;
+
+/** Running task, NULL when it is not registered. */
+static TaskProfEntry* _pCurrent = NULL ;
+
+/** Time the running task was switched in. */
+static uint32_t _dwSwitchTime ;
+
+/** Time of the last reset. */
+static uint32_t _dwResetTime ;
+
+/** Switches to tasks missing from the table since the last reset. */
+static uint32_t _dwMissed ;
+
+/** High half of the time base, counted by the overflow interrupt. */
+static volatile uint32_t _dwTimeHigh ;
+
+/** Dump frame, built before being written. */
+static uint8_t _aFrame[TASKPROF_HEADER_SIZE+TASKPROF_MAX_TASKS*TASKPROF_RECORD_SIZE+2] ;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Finds the entry of a task.
+ *
+ * \param pTask  RTOS task, NULL to find a free entry.
+ *
+ * \return Pointer to the entry, or NULL if not found.
+ */
+static TaskProfEntry* _FindTask( const void* pTask )
+{
+    uint32_t i ;
+
+    for ( i=0 ; i < TASKPROF_MAX_TASKS ; i++ )
+    {
+        if ( _aTasks[i].pTask == pTask )
+        {
+            return &_aTasks[i] ;
+        }
+    }
+
+    return NULL ;
+}
+
+/**
+ * \brief Charges the time elapsed since the last switch to the running task.
+ * Must be called with the interrupts masked.
+ *
+ * \return Current time.
+ */
+static uint32_t _ChargeCurrent( void )
+{
+    uint32_t dwNow = TASKPROF_GetTime() ;
+
+    if ( _pCurrent != NULL )
+    {
+        _pCurrent->dwTime += dwNow - _dwSwitchTime ;
+    }
+    _dwSwitchTime = dwNow ;
+
+    return dwNow ;
+}
+
+/**
+ * \brief Counts the painted words at the bottom of a stack.
+ */
+static uint32_t _GetStackUnused( const uint32_t* pdwStack, uint32_t dwWords, uint32_t dwFill )
+{
+    uint32_t dwUnused = 0 ;
+
+    if ( pdwStack == NULL )
+    {
+        return TASKPROF_STACK_UNKNOWN ;
+    }
+
+    while ( (dwUnused < dwWords) && (pdwStack[dwUnused] == dwFill) )
+    {
+        dwUnused++ ;
+    }
+
+    return (dwUnused < TASKPROF_STACK_UNKNOWN) ? dwUnused : TASKPROF_STACK_UNKNOWN-1 ;
+}
+
+static void _Put16( uint8_t* pBuffer, uint32_t dwValue )
+{
+    pBuffer[0] = (uint8_t)dwValue ;
+    pBuffer[1] = (uint8_t)(dwValue >> 8) ;
+}
+
+static void _Put32( uint8_t* pBuffer, uint32_t dwValue )
+{
+    _Put16( pBuffer, dwValue ) ;
+    _Put16( pBuffer+2, dwValue >> 16 ) ;
+}
+
+/**
+ * \brief Computes the CRC-16/CCITT of a buffer.
+ */
+static uint32_t _Crc16( const uint8_t* pData, uint32_t dwSize )
+{
+    uint32_t dwCrc = 0xFFFF ;
+    uint32_t i ;
+
+    while ( dwSize-- )
+    {
+        dwCrc ^= (uint32_t)(*pData++) << 8 ;
+        for ( i=0 ; i < 8 ; i++ )
+        {
+            dwCrc = (dwCrc & 0x8000) ? ((dwCrc << 1) ^ 0x1021) : (dwCrc << 1) ;
+        }
+    }
+
+    return dwCrc & 0xFFFF ;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Overflow interrupt of the time base.
+ */
+extern void TASKPROF_TC_HANDLER( void )
+{
+    if ( (TASKPROF_TC->TC_CHANNEL[TASKPROF_TC_CHANNEL].TC_SR & TC_SR_COVFS) == TC_SR_COVFS )
+    {
+        _dwTimeHigh++ ;
+    }
+}
+
+/**
+ * \brief Clears the task table and starts the time base.
+ *
+ * To be called before the first task is created.
+ */
+extern void TASKPROF_Initialize( void )
+{
+    memset( _aTasks, 0, sizeof( _aTasks ) ) ;
+    _pCurrent = NULL ;
+    _dwMissed = 0 ;
+    _dwTimeHigh = 0 ;
+
+    /* Free-running 16-bit counter at MCK/2, overflow interrupt counting the high half */
+    PMC_EnablePeripheral( TASKPROF_TC_ID ) ;
+    TC_Configure( TASKPROF_TC, TASKPROF_TC_CHANNEL, TC_CMR_TCCLKS_TIMER_CLOCK1 ) ;
+    TASKPROF_TC->TC_CHANNEL[TASKPROF_TC_CHANNEL].TC_IER = TC_IER_COVFS ;
+
+    NVIC_ClearPendingIRQ( TASKPROF_TC_IRQn ) ;
+    NVIC_SetPriority( TASKPROF_TC_IRQn, TASKPROF_TC_PRIORITY ) ;
+    NVIC_EnableIRQ( TASKPROF_TC_IRQn ) ;
+
+    TC_Start( TASKPROF_TC, TASKPROF_TC_CHANNEL ) ;
+
+    _dwSwitchTime = TASKPROF_GetTime() ;
+    _dwResetTime = _dwSwitchTime ;
+}
+
+/**
+ * \brief Returns the time base, counting at MCK/2 and wrapping on 32 bits.
+ *
+ * The time stays monotonic when called with the overflow interrupt masked,
+ * e.g. from the kernel critical sections: an overflow still pending is
+ * detected on the NVIC and accounted for.
+ */
+extern uint32_t TASKPROF_GetTime( void )
+{
+    uint32_t dwHigh ;
+    uint32_t dwLow ;
+    uint32_t dwPending ;
+
+    do
+    {
+        dwHigh = _dwTimeHigh ;
+        dwLow = TASKPROF_TC->TC_CHANNEL[TASKPROF_TC_CHANNEL].TC_CV & TC_CV_CV_Msk ;
+        dwPending = NVIC_GetPendingIRQ( TASKPROF_TC_IRQn ) ;
+    } while ( dwHigh != _dwTimeHigh ) ;
+
+    /* An overflow pending since the counter was read gives a high counter value */
+    if ( dwPending && (dwLow < 0x8000) )
+    {
+        dwHigh++ ;
+    }
+
+    return (dwHigh << 16) | dwLow ;
+}
+
+/**
+ * \brief Registers a task, called by the RTOS glue when a task is created.
+ *
+ * \param pTask  RTOS task, as given to TASKPROF_SwitchTo().
+ * \param pcName  Task name, cut to TASKPROF_NAME_SIZE characters.
+ * \param dwId  Task identifier reported in the dumps.
+ * \param pdwStack  Lowest word of the task stack, NULL if unknown.
+ * \param dwStackWords  Size of the stack in words.
+ * \param dwFill  Value the RTOS paints the unused stack with.
+ *
+ * \return 1 if the task is registered, 0 if the table is full.
+ */
+extern uint32_t TASKPROF_AddTask( const void* pTask, const char* pcName, uint32_t dwId,
+                                  const uint32_t* pdwStack, uint32_t dwStackWords, uint32_t dwFill )
+{
+    TaskProfEntry* pEntry ;
+    uint32_t primask ;
+
+    if ( pTask == NULL )
+    {
+        return 0 ;
+    }
+
+    primask = __get_PRIMASK() ;
+    __disable_irq() ;
+
+    /* A task handle may be reused once the task is deleted */
+    pEntry = _FindTask( pTask ) ;
+    if ( pEntry == NULL )
+    {
+        pEntry = _FindTask( NULL ) ;
+    }
+
+    if ( pEntry != NULL )
+    {
+        memset( pEntry, 0, sizeof( TaskProfEntry ) ) ;
+        pEntry->pTask = pTask ;
+        pEntry->pdwStack = pdwStack ;
+        pEntry->dwStackWords = dwStackWords ;
+        pEntry->dwFill = dwFill ;
+        pEntry->dwId = dwId ;
+        if ( pcName != NULL )
+        {
+            strncpy( pEntry->acName, pcName, TASKPROF_NAME_SIZE ) ;
+        }
+    }
+
+    __set_PRIMASK( primask ) ;
+
+    return (pEntry != NULL) ? 1 : 0 ;
+}
+
+/**
+ * \brief Unregisters a task, called by the RTOS glue when a task is deleted.
+ */
+extern void TASKPROF_RemoveTask( const void* pTask )
+{
+    TaskProfEntry* pEntry ;
+    uint32_t primask ;
+
+    if ( pTask == NULL )
+    {
+        return ;
+    }
+
+    primask = __get_PRIMASK() ;
+    __disable_irq() ;
+
+    pEntry = _FindTask( pTask ) ;
+    if ( pEntry != NULL )
+    {
+        if ( pEntry == _pCurrent )
+        {
+            _ChargeCurrent() ;
+            _pCurrent = NULL ;
+        }
+        pEntry->pTask = NULL ;
+    }
+
+    __set_PRIMASK( primask ) ;
+}
+
+/**
+ * \brief Reports a context switch, called by the RTOS glue with the task
+ * about to run.
+ *
+ * The time since the previous switch is charged to the task switched out.
+ * Switching to the running task again is not counted.
+ */
+extern void TASKPROF_SwitchTo( const void* pTask )
+{
+    TaskProfEntry* pEntry ;
+    uint32_t primask ;
+
+    primask = __get_PRIMASK() ;
+    __disable_irq() ;
+
+    if ( (_pCurrent == NULL) || (_pCurrent->pTask != pTask) )
+    {
+        _ChargeCurrent() ;
+
+        pEntry = _FindTask( pTask ) ;
+        if ( pEntry != NULL )
+        {
+            pEntry->dwSwitches++ ;
+        }
+        else
+        {
+            _dwMissed++ ;
+        }
+        _pCurrent = pEntry ;
+    }
+
+    __set_PRIMASK( primask ) ;
+}
+
+/**
+ * \brief Clears the time and switch counters of all the tasks, starting a
+ * new measurement window. The stack margins are not reset.
+ */
+extern void TASKPROF_Reset( void )
+{
+    uint32_t primask ;
+    uint32_t i ;
+
+    primask = __get_PRIMASK() ;
+    __disable_irq() ;
+
+    _dwResetTime = _ChargeCurrent() ;
+    _dwMissed = 0 ;
+    for ( i=0 ; i < TASKPROF_MAX_TASKS ; i++ )
+    {
+        _aTasks[i].dwTime = 0 ;
+        _aTasks[i].dwSwitches = 0 ;
+    }
+
+    __set_PRIMASK( primask ) ;
+}
+
+/**
+ * \brief Sends the statistics of all the registered tasks in a binary frame,
+ * whose layout is given in taskprof.h.
+ *
+ * The interrupts are only masked while each record is copied; the stacks are
+ * scanned and the frame written with the interrupts enabled. Not reentrant.
+ *
+ * \param fWrite  Function writing the frame bytes.
+ *
+ * \return Size of the frame in bytes.
+ */
+extern uint32_t TASKPROF_Dump( TaskProfWrite fWrite )
+{
+    TaskProfEntry entry ;
+    uint8_t* pRecord = _aFrame+TASKPROF_HEADER_SIZE ;
+    uint32_t dwCount = 0 ;
+    uint32_t dwNow ;
+    uint32_t dwReset ;
+    uint32_t dwMissed ;
+    uint32_t dwSize ;
+    uint32_t primask ;
+    uint32_t i ;
+
+    primask = __get_PRIMASK() ;
+    __disable_irq() ;
+    dwNow = _ChargeCurrent() ;
+    dwReset = _dwResetTime ;
+    dwMissed = _dwMissed ;
+    __set_PRIMASK( primask ) ;
+
+    for ( i=0 ; i < TASKPROF_MAX_TASKS ; i++ )
+    {
+        primask = __get_PRIMASK() ;
+        __disable_irq() ;
+        memcpy( &entry, &_aTasks[i], sizeof( TaskProfEntry ) ) ;
+        __set_PRIMASK( primask ) ;
+
+        if ( entry.pTask == NULL )
+        {
+            continue ;
+        }
+
+        memcpy( pRecord, entry.acName, TASKPROF_NAME_SIZE ) ;
+        _Put32( pRecord+12, entry.dwTime ) ;
+        _Put32( pRecord+16, entry.dwSwitches ) ;
+        _Put16( pRecord+20, (entry.dwStackWords < 0xFFFF) ? entry.dwStackWords : 0xFFFF ) ;
+        _Put16( pRecord+22, _GetStackUnused( entry.pdwStack, entry.dwStackWords, entry.dwFill ) ) ;
+        _Put32( pRecord+24, entry.dwId ) ;
+
+        pRecord += TASKPROF_RECORD_SIZE ;
+        dwCount++ ;
+    }
+
+    memcpy( _aFrame, "TPRF", 4 ) ;
+    _aFrame[4] = TASKPROF_VERSION ;
+    _aFrame[5] = (uint8_t)dwCount ;
+    _Put16( _aFrame+6, TASKPROF_RECORD_SIZE ) ;
+    _Put32( _aFrame+8, BOARD_MCK/2 ) ;
+    _Put32( _aFrame+12, dwNow ) ;
+    _Put32( _aFrame+16, dwReset ) ;
+    _Put32( _aFrame+20, dwMissed ) ;
+
+    dwSize = TASKPROF_HEADER_SIZE+dwCount*TASKPROF_RECORD_SIZE ;
+    _Put16( _aFrame+dwSize, _Crc16( _aFrame, dwSize ) ) ;
+    dwSize += 2 ;
+
+    fWrite( _aFrame, dwSize ) ;
+
+    return dwSize ;
+}
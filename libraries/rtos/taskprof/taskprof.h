@@ -0,0 +1,143 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Interface of the task profiler, shared by FreeRTOS and CoOS.
+ *
+ * The profiler charges the time between two context switches to the task
+ * switched out, counts the switches of each task, and measures the unused
+ * part of the painted task stacks. The time base is a free-running TC
+ * channel at MCK/2, extended to 32 bits by its overflow interrupt, so the
+ * figures are in units of two master clock cycles.
+ *
+ * TASKPROF_Dump() sends a snapshot of the statistics in a compact binary
+ * frame through any byte writer (UART console, CDC serial). The frame starts
+ * with the "TPRF" signature, so that it can be found in a console log, and
+ * ends with a CRC-16; libraries/rtos/taskprof/taskprof.py decodes it on the
+ * host. The frame layout, all fields little-endian:
+ * \code
+ * Header, 24 bytes:
+ *   0  char[4]   "TPRF"
+ *   4  uint8_t   format version (TASKPROF_VERSION)
+ *   5  uint8_t   number of task records
+ *   6  uint16_t  size of a task record (TASKPROF_RECORD_SIZE)
+ *   8  uint32_t  time base frequency in Hz
+ *  12  uint32_t  time of the dump
+ *  16  uint32_t  time of the last TASKPROF_Reset()
+ *  20  uint32_t  switches to tasks missing from the task table
+ * Task record, 28 bytes:
+ *   0  char[12]  task name, zero padded
+ *  12  uint32_t  time spent running since the last TASKPROF_Reset()
+ *  16  uint32_t  times switched in since the last TASKPROF_Reset()
+ *  20  uint16_t  stack size in words
+ *  22  uint16_t  stack words never used, 0xFFFF when unknown
+ *  24  uint32_t  task identifier (RTOS task handle or id)
+ * Trailer:
+ *   0  uint16_t  CRC-16/CCITT (0x1021, initial 0xFFFF) of header and records
+ * \endcode
+ *
+ * The RTOS glue registers the tasks with TASKPROF_AddTask() and reports each
+ * switch with TASKPROF_SwitchTo(): set configUSE_TASK_PROFILER in
+ * FreeRTOSConfig.h, or CFG_TASK_PROFILE_EN in the CoOS OsConfig.h. The
+ * application calls TASKPROF_Initialize() before creating its tasks.
+ *
+ */
+
+#ifndef _TASKPROF_
+#define _TASKPROF_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definition
+ *----------------------------------------------------------------------------*/
+
+/** Maximum number of profiled tasks, idle task included. */
+#ifndef TASKPROF_MAX_TASKS
+#define TASKPROF_MAX_TASKS      16
+#endif
+
+/** TC channel of the time base, and its interrupt. */
+#ifndef TASKPROF_TC
+#define TASKPROF_TC             TC0
+#define TASKPROF_TC_CHANNEL     2
+#define TASKPROF_TC_ID          ID_TC2
+#define TASKPROF_TC_IRQn        TC2_IRQn
+#define TASKPROF_TC_HANDLER     TC2_IrqHandler
+#endif
+
+/** Priority of the time base interrupt, see TASKPROF_GetTime(). */
+#ifndef TASKPROF_TC_PRIORITY
+#define TASKPROF_TC_PRIORITY    0
+#endif
+
+/** Version of the binary frame. */
+#define TASKPROF_VERSION        1
+/** Size of the task names in the binary frame. */
+#define TASKPROF_NAME_SIZE      12
+/** Size of the frame header. */
+#define TASKPROF_HEADER_SIZE    24
+/** Size of a task record. */
+#define TASKPROF_RECORD_SIZE    28
+
+/** Unknown number of unused stack words. */
+#define TASKPROF_STACK_UNKNOWN  0xFFFF
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Byte writer used to send a dump, e.g. a loop over UART_PutChar(). */
+typedef void (*TaskProfWrite)( const uint8_t* pData, uint32_t dwSize ) ;
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern void TASKPROF_Initialize( void ) ;
+
+extern uint32_t TASKPROF_GetTime( void ) ;
+
+extern uint32_t TASKPROF_AddTask( const void* pTask, const char* pcName, uint32_t dwId,
+                                  const uint32_t* pdwStack, uint32_t dwStackWords, uint32_t dwFill ) ;
+
+extern void TASKPROF_RemoveTask( const void* pTask ) ;
+
+extern void TASKPROF_SwitchTo( const void* pTask ) ;
+
+extern void TASKPROF_Reset( void ) ;
+
+extern uint32_t TASKPROF_Dump( TaskProfWrite fWrite ) ;
+
+#endif /* #ifndef _TASKPROF_ */
@@ -0,0 +1,152 @@
+#!/usr/bin/env python
+# ----------------------------------------------------------------------------
+#         ATMEL Microcontroller Software Support
+# ----------------------------------------------------------------------------
+# Copyright (c) 2010, Atmel Corporation
+#
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# - Redistributions of source code must retain the above copyright notice,
+# this list of conditions and the disclaimer below.
+#
+# Atmel's name may not be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+# IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+# DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+# OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+# EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+# ----------------------------------------------------------------------------
+
+"""Decodes the task profiler frames sent by TASKPROF_Dump().
+
+The frames are searched in a capture file or read live from a serial port
+(UART console or CDC serial, needs pyserial); text around them is ignored.
+
+    taskprof.py capture.bin
+    taskprof.py --port /dev/ttyACM0 --baud 115200
+"""
+
+import struct
+import sys
+
+SIGNATURE = b'TPRF'
+HEADER = struct.Struct('<4sBBHIIII')
+RECORD = struct.Struct('<12sIIHHI')
+STACK_UNKNOWN = 0xFFFF
+
+
+def crc16(data):
+    """CRC-16/CCITT, polynomial 0x1021, initial value 0xFFFF."""
+    crc = 0xFFFF
+    for byte in bytearray(data):
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def parse(buf):
+    """Returns (frames, rest): the frames decoded from buf, and the bytes
+    kept for the next call since they may start an incomplete frame."""
+    frames = []
+    while True:
+        start = buf.find(SIGNATURE)
+        if start < 0:
+            return frames, buf[-(len(SIGNATURE) - 1):]
+        buf = buf[start:]
+        if len(buf) < HEADER.size:
+            return frames, buf
+        (_, version, count, record_size, freq, now, reset,
+         missed) = HEADER.unpack_from(buf)
+        if version != 1 or record_size != RECORD.size:
+            buf = buf[1:]
+            continue
+        size = HEADER.size + count * record_size
+        if len(buf) < size + 2:
+            return frames, buf
+        (crc,) = struct.unpack_from('<H', buf, size)
+        if crc != crc16(buf[:size]):
+            buf = buf[1:]
+            continue
+        tasks = []
+        for i in range(count):
+            (name, time, switches, stack_size, stack_unused,
+             task_id) = RECORD.unpack_from(buf, HEADER.size + i * record_size)
+            name = name.split(b'\0')[0].decode('ascii', 'replace')
+            tasks.append({'name': name or 'task %d' % task_id,
+                          'id': task_id,
+                          'time': time,
+                          'switches': switches,
+                          'stack_size': stack_size,
+                          'stack_unused': stack_unused})
+        frames.append({'freq': freq,
+                       'window': (now - reset) & 0xFFFFFFFF,
+                       'missed': missed,
+                       'tasks': tasks})
+        buf = buf[size + 2:]
+
+
+def show(frame, out=sys.stdout):
+    """Prints a frame as a table."""
+    freq = frame['freq']
+    window = frame['window'] or 1
+    out.write('window %.3f s, %d switches to unknown tasks\n'
+              % (float(window) / freq, frame['missed']))
+    out.write('%-12s %5s %7s %12s %10s %13s\n'
+              % ('task', 'id', 'cpu %', 'time (us)', 'switches', 'stack used'))
+    for task in sorted(frame['tasks'], key=lambda t: -t['time']):
+        if task['stack_unused'] == STACK_UNKNOWN:
+            stack = '?/%d' % task['stack_size']
+        else:
+            stack = '%d/%d' % (task['stack_size'] - task['stack_unused'],
+                               task['stack_size'])
+        out.write('%-12s %5d %7.2f %12d %10d %13s\n'
+                  % (task['name'], task['id'],
+                     100.0 * task['time'] / window,
+                     task['time'] * 1000000 // freq,
+                     task['switches'], stack))
+    out.write('\n')
+
+
+def main(argv):
+    import optparse
+    parser = optparse.OptionParser(usage='%prog [options] [capture file]')
+    parser.add_option('-p', '--port', help='serial port to read live')
+    parser.add_option('-b', '--baud', type='int', default=115200,
+                      help='serial port baud rate [%default]')
+    (options, args) = parser.parse_args(argv[1:])
+
+    if options.port:
+        import serial
+        stream = serial.Serial(options.port, options.baud, timeout=0.5)
+    elif len(args) == 1:
+        stream = open(args[0], 'rb')
+    else:
+        parser.error('give a capture file or a serial port')
+
+    rest = b''
+    while True:
+        data = stream.read(1024)
+        if not data:
+            if not options.port:
+                break
+            continue
+        frames, rest = parse(rest + data)
+        for frame in frames:
+            show(frame)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,456 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \addtogroup tlsf_module TLSF allocator
+ * The TLSF allocator gives and takes back buffers of any size in a bounded
+ * time, so that the tasks allocating at run time keep a deterministic
+ * latency, and with a bounded fragmentation.
+ *
+ * \section Usage
+ * <ul>
+ * <li> Set TLSF_FL_MAX_LOG2 to cover the largest pool, and TLSF_SL_LOG2 to
+ *    trade the size of the Tlsf structure for less fragmentation.</li>
+ * <li> Give the pool to TLSF_Initialize().</li>
+ * <li> Take buffers with TLSF_Alloc() and give them back with TLSF_Free(),
+ *    with the scheduler locked or the interrupts masked.</li>
+ * <li> Watch the usage with TLSF_GetStats().</li>
+ * </ul>
+ * An allocation rounds the size up to the next class, so that any block of
+ * the first list it looks in is large enough: it may miss a fitting block
+ * of the class of the exact size, and fail with up to 1/TLSF_SL_COUNT of
+ * the pool still free in that class.
+ *
+ * Related files :\n
+ * \ref tlsf.c\n
+ * \ref tlsf.h.\n
+*/
+/*@{*/
+/*@}*/
+
+
+/**
+ * \file
+ *
+ * Implementation of the TLSF allocator.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "tlsf.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+#if (TLSF_SL_LOG2 < 1) || (TLSF_SL_LOG2 > 5)
+#error "TLSF_SL_LOG2 must be 1 to 5"
+#endif
+
+#if (TLSF_FL_MAX_LOG2 <= TLSF_FL_SHIFT) || (TLSF_FL_MAX_LOG2 > 31)
+#error "TLSF_FL_MAX_LOG2 must be above TLSF_SL_LOG2 + 3, and at most 31"
+#endif
+
+/** Size of a block header: the free list links are in the buffer */
+#define TLSF_HEADER_SIZE        offsetof(TlsfBlock, pNextFree)
+
+/** Flag of dwSize: the block is free */
+#define TLSF_BLOCK_FREE         1u
+#define TLSF_SIZE_MASK          (~(TLSF_ALIGN - 1))
+
+/** Smallest buffer, room for the free list links */
+#define TLSF_MIN_SIZE           (sizeof(TlsfBlock) - TLSF_HEADER_SIZE)
+/** Largest buffer: the rounded up sizes shall still map to a class */
+#define TLSF_MAX_SIZE           ((1u << TLSF_FL_MAX_LOG2) - TLSF_ALIGN)
+
+/** Size of the buffer of a block, and block following it in memory */
+#define _BlockSize(pBlock)      ((pBlock)->dwSize & TLSF_SIZE_MASK)
+#define _BlockNext(pBlock)      ((TlsfBlock*)((uint8_t*)(pBlock) + TLSF_HEADER_SIZE + _BlockSize(pBlock)))
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Returns the index of the most significant bit set of a non zero word.
+ */
+static inline uint32_t _Msb( uint32_t dwValue )
+{
+#if defined(__GNUC__)
+    return 31 - __builtin_clz( dwValue ) ;
+#else
+    uint32_t dwBit = 0 ;
+
+    if ( dwValue & 0xFFFF0000 ) { dwValue >>= 16 ; dwBit += 16 ; }
+    if ( dwValue & 0x0000FF00 ) { dwValue >>= 8 ;  dwBit += 8 ; }
+    if ( dwValue & 0x000000F0 ) { dwValue >>= 4 ;  dwBit += 4 ; }
+    if ( dwValue & 0x0000000C ) { dwValue >>= 2 ;  dwBit += 2 ; }
+    if ( dwValue & 0x00000002 ) { dwBit += 1 ; }
+
+    return dwBit ;
+#endif
+}
+
+/**
+ * \brief Returns the index of the least significant bit set of a non zero word.
+ */
+static inline uint32_t _Lsb( uint32_t dwValue )
+{
+    return _Msb( dwValue & (0 - dwValue) ) ;
+}
+
+/**
+ * \brief Gives the list of the blocks of a size.
+ *
+ * \param dwSize  Buffer size, aligned, at most TLSF_MAX_SIZE.
+ * \param pdwFl   First level class.
+ * \param pdwSl   Second level class.
+ */
+static inline void _Mapping( uint32_t dwSize, uint32_t* pdwFl, uint32_t* pdwSl )
+{
+    uint32_t dwMsb ;
+
+    if ( dwSize < TLSF_SMALL_SIZE )
+    {
+        *pdwFl = 0 ;
+        *pdwSl = dwSize >> TLSF_ALIGN_LOG2 ;
+    }
+    else
+    {
+        dwMsb = _Msb( dwSize ) ;
+        *pdwFl = dwMsb - TLSF_FL_SHIFT + 1 ;
+        *pdwSl = (dwSize >> (dwMsb - TLSF_SL_LOG2)) ^ TLSF_SL_COUNT ;
+    }
+}
+
+/**
+ * \brief Links a free block at the head of the list of its size.
+ */
+static void _Insert( Tlsf* pTlsf, TlsfBlock* pBlock )
+{
+    uint32_t dwFl, dwSl ;
+    TlsfBlock* pHead ;
+
+    _Mapping( _BlockSize( pBlock ), &dwFl, &dwSl ) ;
+    pHead = pTlsf->apFree[dwFl][dwSl] ;
+
+    pBlock->dwSize |= TLSF_BLOCK_FREE ;
+    pBlock->pPrevFree = NULL ;
+    pBlock->pNextFree = pHead ;
+    if ( pHead != NULL )
+    {
+        pHead->pPrevFree = pBlock ;
+    }
+    pTlsf->apFree[dwFl][dwSl] = pBlock ;
+
+    pTlsf->dwFlBitmap |= 1u << dwFl ;
+    pTlsf->adwSlBitmap[dwFl] |= 1u << dwSl ;
+    pTlsf->stats.dwFreeBlocks++ ;
+}
+
+/**
+ * \brief Unlinks a free block from the list of its size.
+ */
+static void _Remove( Tlsf* pTlsf, TlsfBlock* pBlock )
+{
+    uint32_t dwFl, dwSl ;
+
+    _Mapping( _BlockSize( pBlock ), &dwFl, &dwSl ) ;
+
+    if ( pBlock->pNextFree != NULL )
+    {
+        pBlock->pNextFree->pPrevFree = pBlock->pPrevFree ;
+    }
+    if ( pBlock->pPrevFree != NULL )
+    {
+        pBlock->pPrevFree->pNextFree = pBlock->pNextFree ;
+    }
+    else
+    {
+        pTlsf->apFree[dwFl][dwSl] = pBlock->pNextFree ;
+        if ( pBlock->pNextFree == NULL )
+        {
+            pTlsf->adwSlBitmap[dwFl] &= ~(1u << dwSl) ;
+            if ( pTlsf->adwSlBitmap[dwFl] == 0 )
+            {
+                pTlsf->dwFlBitmap &= ~(1u << dwFl) ;
+            }
+        }
+    }
+
+    pBlock->dwSize &= ~TLSF_BLOCK_FREE ;
+    pTlsf->stats.dwFreeBlocks-- ;
+}
+
+/**
+ * \brief Finds a free block of at least a size, without unlinking it.
+ *
+ * The size is rounded up to the next class, so that the first block of any
+ * list at or above that class fits.
+ *
+ * \return The block, or NULL if there is none.
+ */
+static TlsfBlock* _Find( Tlsf* pTlsf, uint32_t dwSize )
+{
+    uint32_t dwFl, dwSl, dwMap ;
+
+    if ( dwSize >= TLSF_SMALL_SIZE )
+    {
+        dwSize += (1u << (_Msb( dwSize ) - TLSF_SL_LOG2)) - 1 ;
+    }
+    _Mapping( dwSize, &dwFl, &dwSl ) ;
+    if ( dwFl >= TLSF_FL_COUNT )
+    {
+        return NULL ;
+    }
+
+    /* A list of the same first level, or the first list of a higher one */
+    dwMap = pTlsf->adwSlBitmap[dwFl] & (~0u << dwSl) ;
+    if ( dwMap == 0 )
+    {
+        dwMap = pTlsf->dwFlBitmap & (~0u << (dwFl + 1)) ;
+        if ( dwMap == 0 )
+        {
+            return NULL ;
+        }
+        dwFl = _Lsb( dwMap ) ;
+        dwMap = pTlsf->adwSlBitmap[dwFl] ;
+    }
+    dwSl = _Lsb( dwMap ) ;
+
+    return pTlsf->apFree[dwFl][dwSl] ;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initializes a pool.
+ *
+ * The pool is aligned on TLSF_ALIGN, and cut to the largest block
+ * (2^TLSF_FL_MAX_LOG2 bytes) if larger. The Tlsf structure is not part of
+ * the pool.
+ *
+ * \param pTlsf   Control structure.
+ * \param pPool   Start of the memory given to the allocator.
+ * \param dwSize  Size of that memory, in bytes.
+ *
+ * \return Bytes of the pool, headers included, 0 if it is too small.
+ */
+extern uint32_t TLSF_Initialize( Tlsf* pTlsf, void* pPool, uint32_t dwSize )
+{
+    uintptr_t dwStart, dwEnd ;
+    TlsfBlock* pBlock ;
+    TlsfBlock* pSentinel ;
+
+    memset( pTlsf, 0, sizeof( Tlsf ) ) ;
+
+    dwStart = ((uintptr_t)pPool + TLSF_ALIGN - 1) & ~(uintptr_t)(TLSF_ALIGN - 1) ;
+    dwEnd = ((uintptr_t)pPool + dwSize) & ~(uintptr_t)(TLSF_ALIGN - 1) ;
+    if ( (dwEnd <= dwStart) || (dwEnd - dwStart < 2*TLSF_HEADER_SIZE + TLSF_MIN_SIZE) )
+    {
+        return 0 ;
+    }
+    if ( dwEnd - dwStart > 2*TLSF_HEADER_SIZE + TLSF_MAX_SIZE )
+    {
+        dwEnd = dwStart + 2*TLSF_HEADER_SIZE + TLSF_MAX_SIZE ;
+    }
+
+    /* One free block, and an empty allocated block which ends the pool, so
+       that every block has a next one */
+    pBlock = (TlsfBlock*)dwStart ;
+    pBlock->pPrevPhys = NULL ;
+    pBlock->dwSize = dwEnd - dwStart - 2*TLSF_HEADER_SIZE ;
+
+    pSentinel = _BlockNext( pBlock ) ;
+    pSentinel->pPrevPhys = pBlock ;
+    pSentinel->dwSize = 0 ;
+
+    _Insert( pTlsf, pBlock ) ;
+
+    pTlsf->stats.dwSize = dwEnd - dwStart ;
+    pTlsf->stats.dwUsed = TLSF_HEADER_SIZE ;
+    pTlsf->stats.dwMaxUsed = TLSF_HEADER_SIZE ;
+
+    return pTlsf->stats.dwSize ;
+}
+
+/**
+ * \brief Allocates a buffer.
+ *
+ * \param pTlsf   Initialized pool.
+ * \param dwSize  Size of the buffer, in bytes.
+ *
+ * \return The buffer, aligned on TLSF_ALIGN, or NULL if dwSize is 0 or there
+ * is no room.
+ */
+extern void* TLSF_Alloc( Tlsf* pTlsf, uint32_t dwSize )
+{
+    TlsfBlock* pBlock ;
+    TlsfBlock* pRest ;
+    uint32_t dwFree ;
+
+    if ( (dwSize == 0) || (dwSize > TLSF_MAX_SIZE) )
+    {
+        pTlsf->stats.dwFailures++ ;
+        return NULL ;
+    }
+
+    dwSize = (dwSize + TLSF_ALIGN - 1) & TLSF_SIZE_MASK ;
+    if ( dwSize < TLSF_MIN_SIZE )
+    {
+        dwSize = TLSF_MIN_SIZE ;
+    }
+
+    pBlock = _Find( pTlsf, dwSize ) ;
+    if ( pBlock == NULL )
+    {
+        pTlsf->stats.dwFailures++ ;
+        return NULL ;
+    }
+    _Remove( pTlsf, pBlock ) ;
+
+    /* Give the end of the block back when it can hold a block of its own */
+    dwFree = _BlockSize( pBlock ) - dwSize ;
+    if ( dwFree >= TLSF_HEADER_SIZE + TLSF_MIN_SIZE )
+    {
+        pBlock->dwSize = dwSize ;
+        pRest = _BlockNext( pBlock ) ;
+        pRest->pPrevPhys = pBlock ;
+        pRest->dwSize = dwFree - TLSF_HEADER_SIZE ;
+        _BlockNext( pRest )->pPrevPhys = pRest ;
+        _Insert( pTlsf, pRest ) ;
+    }
+
+    pTlsf->stats.dwUsed += TLSF_HEADER_SIZE + _BlockSize( pBlock ) ;
+    if ( pTlsf->stats.dwUsed > pTlsf->stats.dwMaxUsed )
+    {
+        pTlsf->stats.dwMaxUsed = pTlsf->stats.dwUsed ;
+    }
+    pTlsf->stats.dwUsedBlocks++ ;
+
+    return (uint8_t*)pBlock + TLSF_HEADER_SIZE ;
+}
+
+/**
+ * \brief Frees a buffer given by TLSF_Alloc(), merging it with its free
+ * neighbours. NULL is ignored, and so is a buffer freed twice as long as
+ * it was not merged since.
+ *
+ * \param pTlsf    Pool of the buffer.
+ * \param pBuffer  Buffer to free.
+ */
+extern void TLSF_Free( Tlsf* pTlsf, void* pBuffer )
+{
+    TlsfBlock* pBlock ;
+    TlsfBlock* pNeighbour ;
+
+    if ( pBuffer == NULL )
+    {
+        return ;
+    }
+
+    pBlock = (TlsfBlock*)((uint8_t*)pBuffer - TLSF_HEADER_SIZE) ;
+    /* Freed twice */
+    if ( pBlock->dwSize & TLSF_BLOCK_FREE )
+    {
+        return ;
+    }
+
+    pTlsf->stats.dwUsed -= TLSF_HEADER_SIZE + _BlockSize( pBlock ) ;
+    pTlsf->stats.dwUsedBlocks-- ;
+
+    pNeighbour = pBlock->pPrevPhys ;
+    if ( (pNeighbour != NULL) && (pNeighbour->dwSize & TLSF_BLOCK_FREE) )
+    {
+        _Remove( pTlsf, pNeighbour ) ;
+        pNeighbour->dwSize += TLSF_HEADER_SIZE + _BlockSize( pBlock ) ;
+        pBlock = pNeighbour ;
+    }
+
+    pNeighbour = _BlockNext( pBlock ) ;
+    if ( pNeighbour->dwSize & TLSF_BLOCK_FREE )
+    {
+        _Remove( pTlsf, pNeighbour ) ;
+        pBlock->dwSize += TLSF_HEADER_SIZE + _BlockSize( pNeighbour ) ;
+    }
+
+    _BlockNext( pBlock )->pPrevPhys = pBlock ;
+    _Insert( pTlsf, pBlock ) ;
+}
+
+/**
+ * \brief Returns the usable size of a buffer given by TLSF_Alloc(), which
+ * may be larger than the size asked for.
+ */
+extern uint32_t TLSF_GetSize( const void* pBuffer )
+{
+    const TlsfBlock* pBlock ;
+
+    pBlock = (const TlsfBlock*)((const uint8_t*)pBuffer - TLSF_HEADER_SIZE) ;
+
+    return _BlockSize( pBlock ) ;
+}
+
+/**
+ * \brief Gives the usage statistics of a pool.
+ *
+ * TLSF_Alloc() rounds a size up to the next class before looking for a
+ * list, so the largest buffer sure to be allocated is the bottom of the
+ * highest non empty class, which may be less than the largest free block.
+ *
+ * \param pTlsf   Pool.
+ * \param pStats  Filled with the statistics.
+ */
+extern void TLSF_GetStats( Tlsf* pTlsf, TlsfStats* pStats )
+{
+    uint32_t dwFl, dwSl ;
+
+    pTlsf->stats.dwLargestFree = 0 ;
+    if ( pTlsf->dwFlBitmap != 0 )
+    {
+        dwFl = _Msb( pTlsf->dwFlBitmap ) ;
+        dwSl = _Msb( pTlsf->adwSlBitmap[dwFl] ) ;
+        if ( dwFl == 0 )
+        {
+            pTlsf->stats.dwLargestFree = dwSl << TLSF_ALIGN_LOG2 ;
+        }
+        else
+        {
+            pTlsf->stats.dwLargestFree = (TLSF_SL_COUNT | dwSl) << (dwFl + TLSF_FL_SHIFT - 1 - TLSF_SL_LOG2) ;
+        }
+    }
+
+    memcpy( pStats, &pTlsf->stats, sizeof( TlsfStats ) ) ;
+}
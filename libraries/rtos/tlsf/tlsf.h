@@ -0,0 +1,148 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Interface of the TLSF (two-level segregated fit) allocator, shared by the
+ * CoOS kernel heap (kernelHeap.c) and the FreeRTOS heap_tlsf.c.
+ *
+ * The free blocks are kept in one list per size class. The first level
+ * splits the sizes in powers of two, the second level splits each power of
+ * two in TLSF_SL_COUNT linear classes, and a bitmap per level tells which
+ * lists are not empty. An allocation finds a list whose blocks are all large
+ * enough with two bit scans, takes its first block and splits off what is
+ * not needed; a free merges the block with its free neighbours in memory.
+ * Both are done in constant time, whatever the number of blocks, and since
+ * the blocks of a class differ by less than 1/TLSF_SL_COUNT of their size,
+ * the memory lost to fragmentation stays bounded.
+ *
+ * Each block has a two word header, and the buffers are aligned on 8 bytes.
+ * The functions do not lock: the caller serializes the calls on a Tlsf
+ * (scheduler lock, critical section).
+ *
+ */
+
+#ifndef _TLSF_
+#define _TLSF_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definition
+ *----------------------------------------------------------------------------*/
+
+/** Log2 of the number of second level classes per power of two (1 to 5). */
+#ifndef TLSF_SL_LOG2
+#define TLSF_SL_LOG2            3
+#endif
+
+/** Log2 of the largest block, 64 KB by default; 20 for a 1 MB PSRAM pool. */
+#ifndef TLSF_FL_MAX_LOG2
+#define TLSF_FL_MAX_LOG2        16
+#endif
+
+/** Alignment of the blocks and of the buffers. */
+#define TLSF_ALIGN_LOG2         3
+#define TLSF_ALIGN              (1u << TLSF_ALIGN_LOG2)
+
+/** Number of second level classes. */
+#define TLSF_SL_COUNT           (1u << TLSF_SL_LOG2)
+/** The sizes below TLSF_SMALL_SIZE all go to the first list of first level 0. */
+#define TLSF_FL_SHIFT           (TLSF_SL_LOG2 + TLSF_ALIGN_LOG2)
+#define TLSF_SMALL_SIZE         (1u << TLSF_FL_SHIFT)
+/** Number of first level classes. */
+#define TLSF_FL_COUNT           (TLSF_FL_MAX_LOG2 - TLSF_FL_SHIFT + 1)
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** \brief Header of a block. The free list links sit in the free blocks. */
+typedef struct _TlsfBlock
+{
+    /** Block just before in memory, NULL for the first one */
+    struct _TlsfBlock* pPrevPhys ;
+    /** Size of the buffer, header excluded, and TLSF_BLOCK_FREE */
+    uint32_t dwSize ;
+    /** Free list links, valid while the block is free */
+    struct _TlsfBlock* pNextFree ;
+    struct _TlsfBlock* pPrevFree ;
+} TlsfBlock ;
+
+/** \brief Usage statistics of a pool. */
+typedef struct _TlsfStats
+{
+    /** Size of the pool, in bytes */
+    uint32_t dwSize ;
+    /** Bytes allocated, block headers included */
+    uint32_t dwUsed ;
+    /** Highest dwUsed */
+    uint32_t dwMaxUsed ;
+    /** Largest buffer that TLSF_Alloc() is sure to give, which is the
+        largest free block rounded down to its class */
+    uint32_t dwLargestFree ;
+    /** Number of allocated and free blocks */
+    uint32_t dwUsedBlocks ;
+    uint32_t dwFreeBlocks ;
+    /** Number of allocations which failed */
+    uint32_t dwFailures ;
+} TlsfStats ;
+
+/** \brief Control structure of a pool. */
+typedef struct _Tlsf
+{
+    /** Bit n set when a list of first level n is not empty */
+    uint32_t dwFlBitmap ;
+    /** Bit n set when list n of the first level is not empty */
+    uint32_t adwSlBitmap[TLSF_FL_COUNT] ;
+    /** Free lists */
+    TlsfBlock* apFree[TLSF_FL_COUNT][TLSF_SL_COUNT] ;
+    /** Statistics, dwLargestFree computed by TLSF_GetStats() */
+    TlsfStats stats ;
+} Tlsf ;
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern uint32_t TLSF_Initialize( Tlsf* pTlsf, void* pPool, uint32_t dwSize ) ;
+
+extern void* TLSF_Alloc( Tlsf* pTlsf, uint32_t dwSize ) ;
+
+extern void TLSF_Free( Tlsf* pTlsf, void* pBuffer ) ;
+
+extern uint32_t TLSF_GetSize( const void* pBuffer ) ;
+
+extern void TLSF_GetStats( Tlsf* pTlsf, TlsfStats* pStats ) ;
+
+#endif /* #ifndef _TLSF_ */
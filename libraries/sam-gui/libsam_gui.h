@@ -13,18 +13,26 @@
 #include "source/disp/disp_backend.h"
 #include "source/disp/backends/HX8347/backend_HX8347.h"
 #include "source/disp/backends/ILI9325/backend_ILI9325.h"
+#include "source/disp/backends/TILE/backend_TILE.h"
 #include "source/file/file_fs.h"
+#include "source/file/file_thumbcache.h"
+#include "source/file/file_jpeg.h"
+#include "source/file/file_pack.h"
 #include "source/porting/sam_gui_porting.h"
+#include "source/wgt/core/wgt_core_timer.h"
 #include "source/wgt/core/wgt_core.h"
 #include "source/wgt/core/wgt_core_behaviour.h"
 #include "source/wgt/core/wgt_core_message.h"
 //#include "source/wgt/core/wgt_core_pointer.h"
 #include "source/wgt/core/wgt_core_screen.h"
-//#include "source/wgt/core/wgt_core_timer.h"
+#include "source/wgt/core/wgt_core_sprite.h"
+#include "source/wgt/core/wgt_core_blend.h"
+#include "source/wgt/core/wgt_core_gradient.h"
 #include "source/wgt/core/wgt_core_widget.h"
 #include "source/wgt/core/wgt_core_frontend.h"
 #include "source/wgt/widgets/wgt_widget_button.h"
 #include "source/wgt/widgets/wgt_widget_page.h"
 #include "source/wgt/widgets/wgt_widget_static.h"
+#include "source/wgt/widgets/wgt_widget_textarea.h"
 
 #endif // _SAM_GUI_
@@ -2,6 +2,10 @@
 
 #include <stdlib.h>
 
+/**
+ * Color dwIndex of dwNumber going linearly from *pclrBegin (index 0) to
+ * *pclrEnd (index dwNumber-1), per channel.
+ */
 extern int COLOR_GetGradientValue( SGUIColor* pclrBegin, SGUIColor* pclrEnd,
                                    uint32_t dwNumber, uint32_t dwIndex, SGUIColor* pclrResult )
 {
@@ -12,12 +16,23 @@ extern int COLOR_GetGradientValue( SGUIColor* pclrBegin, SGUIColor* pclrEnd,
     }
 
     // Check parameters consistency
-    if ( dwNumber == 0 )
+    if ( (dwNumber == 0) || (dwIndex >= dwNumber) )
     {
-        return SAMGUI_E_BAD_POINTER ;
+        return SAMGUI_E_BAD_PARAMETER ;
     }
 
     // Process gradient
+    if ( dwNumber == 1 )
+    {
+        pclrResult->u.dwRGBA=pclrBegin->u.dwRGBA ;
+
+        return SAMGUI_E_OK ;
+    }
+
+    pclrResult->u.RGBA.ucR=pclrBegin->u.RGBA.ucR+((int32_t)pclrEnd->u.RGBA.ucR-(int32_t)pclrBegin->u.RGBA.ucR)*(int32_t)dwIndex/(int32_t)(dwNumber-1) ;
+    pclrResult->u.RGBA.ucG=pclrBegin->u.RGBA.ucG+((int32_t)pclrEnd->u.RGBA.ucG-(int32_t)pclrBegin->u.RGBA.ucG)*(int32_t)dwIndex/(int32_t)(dwNumber-1) ;
+    pclrResult->u.RGBA.ucB=pclrBegin->u.RGBA.ucB+((int32_t)pclrEnd->u.RGBA.ucB-(int32_t)pclrBegin->u.RGBA.ucB)*(int32_t)dwIndex/(int32_t)(dwNumber-1) ;
+    pclrResult->u.RGBA.ucA=pclrBegin->u.RGBA.ucA+((int32_t)pclrEnd->u.RGBA.ucA-(int32_t)pclrBegin->u.RGBA.ucA)*(int32_t)dwIndex/(int32_t)(dwNumber-1) ;
 
     return SAMGUI_E_OK ;
 }
@@ -8,6 +8,7 @@
 #define SAMGUI_ERRORS_DISP_BASE                  0x2000L
 #define SAMGUI_ERRORS_WGT_BASE                   0x3000L
 #define SAMGUI_ERRORS_WM_BASE                    0x4000L
+#define SAMGUI_ERRORS_FILE_BASE                  0x5000L
 
 
 /*
@@ -43,4 +44,16 @@
  * WM layer errors
  */
 
+/*
+ * FILE layer errors
+ */
+#define SAMGUI_E_FILE_READ                       SAMGUI_ERRORS_FILE_BASE
+#define SAMGUI_E_FILE_WRITE                      SAMGUI_ERRORS_FILE_BASE+1
+#define SAMGUI_E_THUMB_NOT_READY                 SAMGUI_ERRORS_FILE_BASE+2
+#define SAMGUI_E_THUMB_IDLE                      SAMGUI_ERRORS_FILE_BASE+3
+#define SAMGUI_E_PACK_FORMAT                     SAMGUI_ERRORS_FILE_BASE+4
+#define SAMGUI_E_PACK_INDEX                      SAMGUI_ERRORS_FILE_BASE+5
+#define SAMGUI_E_JPEG_PENDING                    SAMGUI_ERRORS_FILE_BASE+6
+#define SAMGUI_E_JPEG_DECODE                     SAMGUI_ERRORS_FILE_BASE+7
+
 #endif // _SAM_GUI_ERRORS_
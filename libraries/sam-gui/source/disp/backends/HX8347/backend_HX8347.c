@@ -29,42 +29,55 @@
 
 /**
  * \file
- *
  * \section Purpose
- *
- *  HX8347 driver
+ *   Implementation of HX8347 driver.
  *
  * \section Usage
+ * The HX8347 LCD Controller can be accessed through the \ref SDISPBackend DISP Backend interface.
  *
- *  Explanation on the usage of the code made available through the header file.
+ * The controller sits on a 16-bit SMC bus, one RGB565 pixel per GRAM access.
+ * Every run of pixels is written through a GRAM window set once (R02h..R09h),
+ * the address wrapping to the next row, so fills and blits are a single burst
+ * of data writes. Shapes are decomposed into such runs by the span rasterizer
+ * shared with the ILI9325 backend (lcd_raster.h).
  */
-//------------------------------------------------------------------------------
-//         Headers
-//------------------------------------------------------------------------------
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
 #include "board.h"
 #include "libsam_gui.h"
 
 #include <stdio.h>
 
-//------------------------------------------------------------------------------
-//         Types
-//------------------------------------------------------------------------------
-typedef volatile unsigned short REG16;
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+typedef volatile uint16_t vHalfWord ;
+
+/*----------------------------------------------------------------------------
+ *        Macros
+ *----------------------------------------------------------------------------*/
 
-//------------------------------------------------------------------------------
-//         Definitions
-//------------------------------------------------------------------------------
 /** LCD index register address */
-#define HX8347_IR(baseAddr) (*((REG16 *)(baseAddr)))
+#define HX8347_IR (*((vHalfWord *)(BOARD_LCD_BASE)))
 /** LCD status register address */
-#define HX8347_SR(baseAddr) (*((REG16 *)(baseAddr)))
+#define HX8347_SR (*((vHalfWord *)(BOARD_LCD_BASE)))
 /** LCD data address */
-#define HX8347_D(baseAddr)  (*((REG16 *)((unsigned int)(baseAddr) + BOARD_LCD_RS)))
+#define HX8347_D  (*((vHalfWord *)((uint32_t)(BOARD_LCD_BASE) + BOARD_LCD_RS)))
 
-/** HX8347 ID code */
+/** Convert 24-bits color to the RGB565 GRAM format */
+#define HX8347_RGB565( dwColor ) ((uint16_t)((((dwColor) >> 8) & 0xF800) | (((dwColor) >> 5) & 0x07E0) | (((dwColor) >> 3) & 0x001F)))
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/* HX8347 ID code */
 #define HX8347_HIMAXID_CODE    0x47
 
-/** HX8347 LCD Registers */
+/* HX8347 LCD Registers */
 #define HX8347_R00H        0x00
 #define HX8347_R01H        0x01
 #define HX8347_R02H        0x02
@@ -149,262 +162,931 @@ typedef volatile unsigned short REG16;
 #define HX8347_R94H        0x94
 #define HX8347_R95H        0x95
 
-//------------------------------------------------------------------------------
-//         External functions
-//------------------------------------------------------------------------------
-// External delay 1 ms function
-extern void DelayMS(unsigned int ms);
-#define Delay(ms) DelayMS(ms)
-
-//------------------------------------------------------------------------------
-//         Global functions
-//------------------------------------------------------------------------------
-
-//------------------------------------------------------------------------------
-/// Write data to LCD Register.
-/// \param pLcdBase   LCD base address.
-/// \param reg        Register address.
-/// \param data       Data to be written.
-//------------------------------------------------------------------------------
-static void _HX8347_WriteReg(void *pLcdBase, unsigned char reg, unsigned short data)
+/*----------------------------------------------------------------------------
+ *        Statics
+ *----------------------------------------------------------------------------*/
+
+/** static buffer for file operations, one file system sector */
+static uint8_t _DBE_HX8347_aucFileData[512] ;
+
+/** decoded BMP row, as wide as the largest screen dimension */
+static uint32_t _DBE_HX8347_adwRowData[(BOARD_LCD_HEIGHT*3+3)/4] ;
+
+/** BMP file decoder */
+static BMPStream _DBE_HX8347_sBMPStream ;
+
+/** clipping rectangle (inclusive), drawing outside of it is discarded */
+static uint32_t _DBE_HX8347_dwClipX1=0 ;
+static uint32_t _DBE_HX8347_dwClipY1=0 ;
+static uint32_t _DBE_HX8347_dwClipX2=BOARD_LCD_WIDTH-1 ;
+static uint32_t _DBE_HX8347_dwClipY2=BOARD_LCD_HEIGHT-1 ;
+
+/**
+ * \brief Write data to LCD Register.
+ *
+ * \param ucReg   Register address.
+ * \param wData  Data to be written.
+ */
+static void _DBE_HX8347_WriteReg( uint8_t ucReg, uint16_t wData )
+{
+    HX8347_IR=ucReg ;
+    HX8347_D=wData ;
+}
+
+/**
+ * \brief Read data from LCD Register.
+ *
+ * \param ucReg   Register address.
+ *
+ * \return      Readed data.
+ */
+static uint16_t _DBE_HX8347_ReadReg( uint8_t ucReg )
+{
+    HX8347_IR=ucReg ;
+
+    return HX8347_D ;
+}
+
+/**
+ * \brief Prepare to access GRAM data.
+ */
+static inline void _DBE_HX8347_RAMAccess_Prepare( void )
+{
+    HX8347_IR=HX8347_R22H ;
+}
+
+/**
+ * \brief Read one pixel of the GRAM, after a dummy read.
+ *
+ * \note The GRAM being RGB565, the low color bits are lost.
+ */
+static void _DBE_HX8347_ReadRAM( SGUIColor* pclrResult )
 {
-    HX8347_IR(pLcdBase) = reg;
-    HX8347_D(pLcdBase)  = data;
+    uint16_t wValue ;
+
+    wValue=HX8347_D ; // dummy read
+    wValue=HX8347_D ;
+
+    pclrResult->u.dwRGBA=((wValue & 0xF800) << 8) | ((wValue & 0x07E0) << 5) | ((wValue & 0x001F) << 3) ;
 }
 
-//------------------------------------------------------------------------------
-/// Read data from LCD Register.
-/// \param pLcdBase   LCD base address.
-/// \param reg        Register address.
-/// \return data      Data to be read.
-//------------------------------------------------------------------------------
-static unsigned short _HX8347_ReadReg(void *pLcdBase, unsigned char reg)
+/**
+ * \brief Set the GRAM window, the GRAM address starts at its upper left corner
+ * and wraps to the next row at its right edge.
+ *
+ * \param dwX1  X-coordinate of upper-left corner.
+ * \param dwY1  Y-coordinate of upper-left corner.
+ * \param dwX2  X-coordinate of bottom-right corner (inclusive).
+ * \param dwY2  Y-coordinate of bottom-right corner (inclusive).
+ */
+static void _DBE_HX8347_SetWindow( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2 )
 {
-    HX8347_IR(pLcdBase) = reg;
-    return HX8347_D(pLcdBase);
+    _DBE_HX8347_WriteReg( HX8347_R02H, (dwX1 >> 8) & 0xff ) ; // column start high
+    _DBE_HX8347_WriteReg( HX8347_R03H, dwX1 & 0xff ) ;        // column start low
+    _DBE_HX8347_WriteReg( HX8347_R04H, (dwX2 >> 8) & 0xff ) ; // column end high
+    _DBE_HX8347_WriteReg( HX8347_R05H, dwX2 & 0xff ) ;        // column end low
+    _DBE_HX8347_WriteReg( HX8347_R06H, (dwY1 >> 8) & 0xff ) ; // row start high
+    _DBE_HX8347_WriteReg( HX8347_R07H, dwY1 & 0xff ) ;        // row start low
+    _DBE_HX8347_WriteReg( HX8347_R08H, (dwY2 >> 8) & 0xff ) ; // row end high
+    _DBE_HX8347_WriteReg( HX8347_R09H, dwY2 & 0xff ) ;        // row end low
 }
 
-//------------------------------------------------------------------------------
-/// Read LCD status Register.
-/// \param pLcdBase   LCD base address.
-/// \param reg        Register address.
-/// \return data      Status Data.
-//------------------------------------------------------------------------------
-static unsigned short _HX8347_ReadStatus(void *pLcdBase)
+/**
+ * \brief Turn on the LCD.
+ */
+static void _DBE_HX8347_LCD_On( void )
 {
-    return HX8347_SR(pLcdBase);
+    _DBE_HX8347_WriteReg( HX8347_R90H, 0x7F ) ; // SAP=0111 1111
+    _DBE_HX8347_WriteReg( HX8347_R26H, 0x04 ) ; // GON=0, DTE=0, D=01
+    SAMGUI_TaskDelay( 100 ) ;
+    _DBE_HX8347_WriteReg( HX8347_R26H, 0x24 ) ; // GON=1, DTE=0, D=01
+    _DBE_HX8347_WriteReg( HX8347_R26H, 0x2C ) ; // GON=1, DTE=0, D=11
+    SAMGUI_TaskDelay( 100 ) ;
+    _DBE_HX8347_WriteReg( HX8347_R26H, 0x3C ) ; // GON=1, DTE=1, D=11
 }
 
-//------------------------------------------------------------------------------
-/// Prepare to write GRAM data.
-/// \param pLcdBase   LCD base address.
-//------------------------------------------------------------------------------
-static void _HX8347_WriteRAM_Prepare(void *pLcdBase)
+/**
+ * \brief Turn off the LCD.
+ */
+static void _DBE_HX8347_LCD_Off( void )
 {
-    HX8347_IR(pLcdBase) = HX8347_R22H;
+    _DBE_HX8347_WriteReg( HX8347_R90H, 0x00 ) ; // SAP=0000 0000
+    _DBE_HX8347_WriteReg( HX8347_R26H, 0x00 ) ; // GON=0, DTE=0, D=00
 }
 
-//------------------------------------------------------------------------------
-/// Write data to LCD GRAM.
-/// \param pLcdBase   LCD base address.
-/// \param color      16-bits RGB color.
-//------------------------------------------------------------------------------
-static void _HX8347_WriteRAM(void *pLcdBase, unsigned short color)
+static uint32_t _DBE_HX8347_Reset( void )
 {
-    // Write 16-bit GRAM Reg
-    HX8347_D(pLcdBase) = color;
+    return SAMGUI_E_OK ;
 }
 
-//------------------------------------------------------------------------------
-/// Prepare to read GRAM data.
-/// \param pLcdBase   LCD base address.
-//------------------------------------------------------------------------------
-static void _HX8347_ReadRAM_Prepare(void *pLcdBase)
+/**
+ * \brief Set the backlight of the LCD.
+ *
+ * \param dwLevel Backlight brightness level [1..16], 1 means maximum brightness.
+ */
+static void _DBE_HX8347_SetBacklight( uint32_t dwLevel )
 {
-    HX8347_IR(pLcdBase) = HX8347_R22H;
+    uint32_t i ;
+    const Pin pPins[]={ BOARD_BACKLIGHT_PIN } ;
+
+    // Ensure valid level
+    if ( dwLevel < 1 )
+    {
+        dwLevel=1 ;
+    }
+    else
+    {
+        if ( dwLevel > 16 )
+        {
+            dwLevel=16 ;
+        }
+    }
+
+    // Switch off backlight
+    PIO_Clear( pPins ) ;
+    SAMGUI_TaskDelay( 2 ) ;
+
+    // Set new backlight level
+    for ( i=17 ; i > dwLevel ; i-- )
+    {
+        PIO_Clear( pPins ) ;
+        PIO_Clear( pPins ) ;
+        PIO_Clear( pPins ) ;
+
+        PIO_Set( pPins ) ;
+        PIO_Set( pPins ) ;
+        PIO_Set( pPins ) ;
+    }
 }
 
-//------------------------------------------------------------------------------
-/// Read GRAM data.
-/// \param pLcdBase   LCD base address.
-/// \return           16-bits RGB color.
-//------------------------------------------------------------------------------
-static unsigned short _HX8347_ReadRAM(void *pLcdBase)
+/**
+ * \brief Set the clipping rectangle, limited to the screen.
+ */
+static uint32_t _DBE_HX8347_SetClipRect( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2 )
 {
-    // Read 16-bit GRAM Reg
-    return HX8347_D(pLcdBase);
+    _DBE_HX8347_dwClipX1=(dwX1 < BOARD_LCD_WIDTH)?dwX1:BOARD_LCD_WIDTH-1 ;
+    _DBE_HX8347_dwClipY1=(dwY1 < BOARD_LCD_HEIGHT)?dwY1:BOARD_LCD_HEIGHT-1 ;
+    _DBE_HX8347_dwClipX2=(dwX2 < BOARD_LCD_WIDTH)?dwX2:BOARD_LCD_WIDTH-1 ;
+    _DBE_HX8347_dwClipY2=(dwY2 < BOARD_LCD_HEIGHT)?dwY2:BOARD_LCD_HEIGHT-1 ;
+
+    return SAMGUI_E_OK ;
 }
 
-//------------------------------------------------------------------------------
-/// Initialize the LCD controller.
-/// \param pLcdBase   LCD base address.
-//------------------------------------------------------------------------------
-static void _HX8347_Initialize(void *pLcdBase)
+/**
+ * \brief Intersect a box with the clipping rectangle.
+ *
+ * \return 0 if nothing of the box remains visible.
+ */
+static uint32_t _DBE_HX8347_ClipBox( uint32_t* pdwX1, uint32_t* pdwY1, uint32_t* pdwX2, uint32_t* pdwY2 )
 {
-    unsigned short chipid;
+    if ( *pdwX1 < _DBE_HX8347_dwClipX1 ) *pdwX1=_DBE_HX8347_dwClipX1 ;
+    if ( *pdwY1 < _DBE_HX8347_dwClipY1 ) *pdwY1=_DBE_HX8347_dwClipY1 ;
+    if ( *pdwX2 > _DBE_HX8347_dwClipX2 ) *pdwX2=_DBE_HX8347_dwClipX2 ;
+    if ( *pdwY2 > _DBE_HX8347_dwClipY2 ) *pdwY2=_DBE_HX8347_dwClipY2 ;
 
-    // Check HX8347 chipid
-    chipid = _HX8347_ReadReg(pLcdBase, HX8347_R67H);
-    if(chipid != HX8347_HIMAXID_CODE) {
+    return (*pdwX1 <= *pdwX2) && (*pdwY1 <= *pdwY2) ;
+}
 
-        printf("Read HX8347 chip ID error, skip initialization.\r\n");
-        return ;
+/**
+ * \brief Initialize the LCD controller.
+ */
+static uint32_t _DBE_HX8347_Initialize( void )
+{
+    const Pin pPins[]={ BOARD_LCD_PINS, BOARD_BACKLIGHT_PIN } ;
+    Smc *pSmc=SMC ;
+    uint16_t wChipID ;
+
+    // Enable pins
+    PIO_Configure( pPins, PIO_LISTSIZE( pPins ) ) ;
+
+    // Enable peripheral clock
+    PMC_EnablePeripheral( ID_SMC ) ;
+
+    // EBI SMC Configuration, 16-bit bus
+    pSmc->SMC_CS_NUMBER[1].SMC_SETUP = SMC_SETUP_NWE_SETUP(2)
+                                     | SMC_SETUP_NCS_WR_SETUP(2)
+                                     | SMC_SETUP_NRD_SETUP(2)
+                                     | SMC_SETUP_NCS_RD_SETUP(2) ;
+
+    pSmc->SMC_CS_NUMBER[1].SMC_PULSE = SMC_PULSE_NWE_PULSE(4)
+                                     | SMC_PULSE_NCS_WR_PULSE(4)
+                                     | SMC_PULSE_NRD_PULSE(10)
+                                     | SMC_PULSE_NCS_RD_PULSE(10) ;
+
+    pSmc->SMC_CS_NUMBER[1].SMC_CYCLE = SMC_CYCLE_NWE_CYCLE(7)
+                                     | SMC_CYCLE_NRD_CYCLE(20) ;
+
+    pSmc->SMC_CS_NUMBER[1].SMC_MODE = SMC_MODE_READ_MODE
+                                    | SMC_MODE_WRITE_MODE
+                                    | SMC_MODE_DBW_16_BIT ;
+
+    // Check HX8347 chipid
+    wChipID=_DBE_HX8347_ReadReg( HX8347_R67H ) ;
+    if ( wChipID != HX8347_HIMAXID_CODE )
+    {
+        printf( "Read HX8347 chip ID (%x) error, skip initialization.\r\n", wChipID ) ;
+        return SAMGUI_E_WRONG_COMPONENT ;
     }
 
     // Start internal OSC
-    _HX8347_WriteReg(pLcdBase, HX8347_R19H, 0x49); // OSCADJ=10 0000, OSD_EN=1 //60Hz
-    _HX8347_WriteReg(pLcdBase, HX8347_R93H, 0x0C); // RADJ=1100
+    _DBE_HX8347_WriteReg( HX8347_R19H, 0x49 ) ; // OSCADJ=10 0000, OSD_EN=1 //60Hz
+    _DBE_HX8347_WriteReg( HX8347_R93H, 0x0C ) ; // RADJ=1100
 
     // Power on flow
-    _HX8347_WriteReg(pLcdBase, HX8347_R44H, 0x4D); // VCM=100 1101
-    _HX8347_WriteReg(pLcdBase, HX8347_R45H, 0x11); // VDV=1 0001
-    _HX8347_WriteReg(pLcdBase, HX8347_R20H, 0x40); // BT=0100
-    _HX8347_WriteReg(pLcdBase, HX8347_R1DH, 0x07); // VC1=111
-    _HX8347_WriteReg(pLcdBase, HX8347_R1EH, 0x00); // VC3=000
-    _HX8347_WriteReg(pLcdBase, HX8347_R1FH, 0x04); // VRH=0100
+    _DBE_HX8347_WriteReg( HX8347_R44H, 0x4D ) ; // VCM=100 1101
+    _DBE_HX8347_WriteReg( HX8347_R45H, 0x11 ) ; // VDV=1 0001
+    _DBE_HX8347_WriteReg( HX8347_R20H, 0x40 ) ; // BT=0100
+    _DBE_HX8347_WriteReg( HX8347_R1DH, 0x07 ) ; // VC1=111
+    _DBE_HX8347_WriteReg( HX8347_R1EH, 0x00 ) ; // VC3=000
+    _DBE_HX8347_WriteReg( HX8347_R1FH, 0x04 ) ; // VRH=0100
 
-    _HX8347_WriteReg(pLcdBase, HX8347_R1CH, 0x04); // AP=100
-    _HX8347_WriteReg(pLcdBase, HX8347_R1BH, 0x10); // GASENB=0, PON=1, DK=0, XDK=0, DDVDH_TRI=0, STB=0
-    Delay(50);
+    _DBE_HX8347_WriteReg( HX8347_R1CH, 0x04 ) ; // AP=100
+    _DBE_HX8347_WriteReg( HX8347_R1BH, 0x10 ) ; // GASENB=0, PON=1, DK=0, XDK=0, DDVDH_TRI=0, STB=0
+    SAMGUI_TaskDelay( 50 ) ;
 
-    _HX8347_WriteReg(pLcdBase, HX8347_R43H, 0x80); // Set VCOMG=1
-    Delay(50);
+    _DBE_HX8347_WriteReg( HX8347_R43H, 0x80 ) ; // Set VCOMG=1
+    SAMGUI_TaskDelay( 50 ) ;
 
     // Gamma for CMO 2.8
-    _HX8347_WriteReg(pLcdBase, HX8347_R46H, 0x95);
-    _HX8347_WriteReg(pLcdBase, HX8347_R47H, 0x51);
-    _HX8347_WriteReg(pLcdBase, HX8347_R48H, 0x00);
-    _HX8347_WriteReg(pLcdBase, HX8347_R49H, 0x36);
-    _HX8347_WriteReg(pLcdBase, HX8347_R4AH, 0x11);
-    _HX8347_WriteReg(pLcdBase, HX8347_R4BH, 0x66);
-    _HX8347_WriteReg(pLcdBase, HX8347_R4CH, 0x14);
-    _HX8347_WriteReg(pLcdBase, HX8347_R4DH, 0x77);
-    _HX8347_WriteReg(pLcdBase, HX8347_R4EH, 0x13);
-    _HX8347_WriteReg(pLcdBase, HX8347_R4FH, 0x4C);
-    _HX8347_WriteReg(pLcdBase, HX8347_R50H, 0x46);
-    _HX8347_WriteReg(pLcdBase, HX8347_R51H, 0x46);
+    _DBE_HX8347_WriteReg( HX8347_R46H, 0x95 ) ;
+    _DBE_HX8347_WriteReg( HX8347_R47H, 0x51 ) ;
+    _DBE_HX8347_WriteReg( HX8347_R48H, 0x00 ) ;
+    _DBE_HX8347_WriteReg( HX8347_R49H, 0x36 ) ;
+    _DBE_HX8347_WriteReg( HX8347_R4AH, 0x11 ) ;
+    _DBE_HX8347_WriteReg( HX8347_R4BH, 0x66 ) ;
+    _DBE_HX8347_WriteReg( HX8347_R4CH, 0x14 ) ;
+    _DBE_HX8347_WriteReg( HX8347_R4DH, 0x77 ) ;
+    _DBE_HX8347_WriteReg( HX8347_R4EH, 0x13 ) ;
+    _DBE_HX8347_WriteReg( HX8347_R4FH, 0x4C ) ;
+    _DBE_HX8347_WriteReg( HX8347_R50H, 0x46 ) ;
+    _DBE_HX8347_WriteReg( HX8347_R51H, 0x46 ) ;
 
     //240x320 window setting
-    _HX8347_WriteReg(pLcdBase, HX8347_R02H, 0x00); // Column address start2
-    _HX8347_WriteReg(pLcdBase, HX8347_R03H, 0x00); // Column address start1
-    _HX8347_WriteReg(pLcdBase, HX8347_R04H, 0x00); // Column address end2
-    _HX8347_WriteReg(pLcdBase, HX8347_R05H, 0xEF); // Column address end1
-    _HX8347_WriteReg(pLcdBase, HX8347_R06H, 0x00); // Row address start2
-    _HX8347_WriteReg(pLcdBase, HX8347_R07H, 0x00); // Row address start1
-    _HX8347_WriteReg(pLcdBase, HX8347_R08H, 0x01); // Row address end2
-    _HX8347_WriteReg(pLcdBase, HX8347_R09H, 0x3F); // Row address end1
+    _DBE_HX8347_WriteReg( HX8347_R02H, 0x00 ) ; // Column address start2
+    _DBE_HX8347_WriteReg( HX8347_R03H, 0x00 ) ; // Column address start1
+    _DBE_HX8347_WriteReg( HX8347_R04H, 0x00 ) ; // Column address end2
+    _DBE_HX8347_WriteReg( HX8347_R05H, 0xEF ) ; // Column address end1
+    _DBE_HX8347_WriteReg( HX8347_R06H, 0x00 ) ; // Row address start2
+    _DBE_HX8347_WriteReg( HX8347_R07H, 0x00 ) ; // Row address start1
+    _DBE_HX8347_WriteReg( HX8347_R08H, 0x01 ) ; // Row address end2
+    _DBE_HX8347_WriteReg( HX8347_R09H, 0x3F ) ; // Row address end1
 
     // Display Setting
-    _HX8347_WriteReg(pLcdBase, HX8347_R01H, 0x06); // IDMON=0, INVON=1, NORON=1, PTLON=0
-    _HX8347_WriteReg(pLcdBase, HX8347_R16H, 0xC8); // MY=1, MX=1, MV=0, BGR=1
-    _HX8347_WriteReg(pLcdBase, HX8347_R23H, 0x95); // N_DC=1001 0101
-    _HX8347_WriteReg(pLcdBase, HX8347_R24H, 0x95); // P_DC=1001 0101
-    _HX8347_WriteReg(pLcdBase, HX8347_R25H, 0xFF); // I_DC=1111 1111
-    _HX8347_WriteReg(pLcdBase, HX8347_R27H, 0x06); // N_BP=0000 0110
-    _HX8347_WriteReg(pLcdBase, HX8347_R28H, 0x06); // N_FP=0000 0110
-    _HX8347_WriteReg(pLcdBase, HX8347_R29H, 0x06); // P_BP=0000 0110
-    _HX8347_WriteReg(pLcdBase, HX8347_R2AH, 0x06); // P_FP=0000 0110
-    _HX8347_WriteReg(pLcdBase, HX8347_R2CH, 0x06); // I_BP=0000 0110
-    _HX8347_WriteReg(pLcdBase, HX8347_R2DH, 0x06); // I_FP=0000 0110
-    _HX8347_WriteReg(pLcdBase, HX8347_R3AH, 0x01); // N_RTN=0000, N_NW=001
-    _HX8347_WriteReg(pLcdBase, HX8347_R3BH, 0x01); // P_RTN=0000, P_NW=001
-    _HX8347_WriteReg(pLcdBase, HX8347_R3CH, 0xF0); // I_RTN=1111, I_NW=000
-    _HX8347_WriteReg(pLcdBase, HX8347_R3DH, 0x00); // DIV=00
-    _HX8347_WriteReg(pLcdBase, HX8347_R3EH, 0x38); // SON=38h
-    _HX8347_WriteReg(pLcdBase, HX8347_R40H, 0x0F); // GDON=0Fh
-    _HX8347_WriteReg(pLcdBase, HX8347_R41H, 0xF0); // GDOF=F0h
+    _DBE_HX8347_WriteReg( HX8347_R01H, 0x06 ) ; // IDMON=0, INVON=1, NORON=1, PTLON=0
+    _DBE_HX8347_WriteReg( HX8347_R16H, 0xC8 ) ; // MY=1, MX=1, MV=0, BGR=1
+    _DBE_HX8347_WriteReg( HX8347_R23H, 0x95 ) ; // N_DC=1001 0101
+    _DBE_HX8347_WriteReg( HX8347_R24H, 0x95 ) ; // P_DC=1001 0101
+    _DBE_HX8347_WriteReg( HX8347_R25H, 0xFF ) ; // I_DC=1111 1111
+    _DBE_HX8347_WriteReg( HX8347_R27H, 0x06 ) ; // N_BP=0000 0110
+    _DBE_HX8347_WriteReg( HX8347_R28H, 0x06 ) ; // N_FP=0000 0110
+    _DBE_HX8347_WriteReg( HX8347_R29H, 0x06 ) ; // P_BP=0000 0110
+    _DBE_HX8347_WriteReg( HX8347_R2AH, 0x06 ) ; // P_FP=0000 0110
+    _DBE_HX8347_WriteReg( HX8347_R2CH, 0x06 ) ; // I_BP=0000 0110
+    _DBE_HX8347_WriteReg( HX8347_R2DH, 0x06 ) ; // I_FP=0000 0110
+    _DBE_HX8347_WriteReg( HX8347_R3AH, 0x01 ) ; // N_RTN=0000, N_NW=001
+    _DBE_HX8347_WriteReg( HX8347_R3BH, 0x01 ) ; // P_RTN=0000, P_NW=001
+    _DBE_HX8347_WriteReg( HX8347_R3CH, 0xF0 ) ; // I_RTN=1111, I_NW=000
+    _DBE_HX8347_WriteReg( HX8347_R3DH, 0x00 ) ; // DIV=00
+    _DBE_HX8347_WriteReg( HX8347_R3EH, 0x38 ) ; // SON=38h
+    _DBE_HX8347_WriteReg( HX8347_R40H, 0x0F ) ; // GDON=0Fh
+    _DBE_HX8347_WriteReg( HX8347_R41H, 0xF0 ) ; // GDOF=F0h
+
+    return SAMGUI_E_OK ;
+}
+
+static uint32_t _DBE_HX8347_GetPixel( uint32_t dwX, uint32_t dwY, SGUIColor* pclrResult )
+{
+    if ( pclrResult == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    _DBE_HX8347_SetWindow( dwX, dwY, BOARD_LCD_WIDTH-1, BOARD_LCD_HEIGHT-1 ) ;
+    _DBE_HX8347_RAMAccess_Prepare() ;
+    _DBE_HX8347_ReadRAM( pclrResult ) ;
+
+    return SAMGUI_E_OK ;
+}
+
+static uint32_t _DBE_HX8347_DrawPixel( uint32_t dwX, uint32_t dwY, SGUIColor* pclrIn )
+{
+    if ( (dwX < _DBE_HX8347_dwClipX1) || (dwX > _DBE_HX8347_dwClipX2) ||
+         (dwY < _DBE_HX8347_dwClipY1) || (dwY > _DBE_HX8347_dwClipY2) )
+    {
+        return SAMGUI_E_OK ;
+    }
+
+    // The start address is enough, the window end only matters for bursts
+    _DBE_HX8347_WriteReg( HX8347_R02H, (dwX >> 8) & 0xff ) ;
+    _DBE_HX8347_WriteReg( HX8347_R03H, dwX & 0xff ) ;
+    _DBE_HX8347_WriteReg( HX8347_R06H, (dwY >> 8) & 0xff ) ;
+    _DBE_HX8347_WriteReg( HX8347_R07H, dwY & 0xff ) ;
+    _DBE_HX8347_RAMAccess_Prepare() ;
+    HX8347_D=HX8347_RGB565( pclrIn->u.dwRGBA ) ;
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * \brief Box filler of the span rasterizer: clips the box and writes it as one
+ * GRAM burst.
+ *
+ * \param pContext  SGUIColor of the box.
+ */
+static void _DBE_HX8347_FillBox( void* pContext, int32_t iX, int32_t iY, uint32_t dwWidth, uint32_t dwHeight )
+{
+    SGUIColor* pclrIn=(SGUIColor*)pContext ;
+    uint32_t dwX1 ;
+    uint32_t dwY1 ;
+    uint32_t dwX2 ;
+    uint32_t dwY2 ;
+    uint32_t dw ;
+    uint16_t wColor ;
+
+    if ( (iX+(int32_t)dwWidth <= 0) || (iY+(int32_t)dwHeight <= 0) )
+    {
+        return ;
+    }
+
+    dwX1=(iX < 0)?0:iX ;
+    dwY1=(iY < 0)?0:iY ;
+    dwX2=iX+dwWidth-1 ;
+    dwY2=iY+dwHeight-1 ;
+
+    if ( !_DBE_HX8347_ClipBox( &dwX1, &dwY1, &dwX2, &dwY2 ) )
+    {
+        return ;
+    }
+
+    wColor=HX8347_RGB565( pclrIn->u.dwRGBA ) ;
+
+    _DBE_HX8347_SetWindow( dwX1, dwY1, dwX2, dwY2 ) ;
+    _DBE_HX8347_RAMAccess_Prepare() ;
+
+    // Unrolled by 4, the loop would otherwise cost as much as the bus writes
+    dw=(dwX2-dwX1+1)*(dwY2-dwY1+1) ;
+    for ( ; dw >= 4 ; dw-=4 )
+    {
+        HX8347_D=wColor ;
+        HX8347_D=wColor ;
+        HX8347_D=wColor ;
+        HX8347_D=wColor ;
+    }
+    for ( ; dw > 0 ; dw-- )
+    {
+        HX8347_D=wColor ;
+    }
 }
 
-//------------------------------------------------------------------------------
-/// Turn on the LCD.
-/// \param pLcdBase   LCD base address.
-//------------------------------------------------------------------------------
-static void _HX8347_On( void *pLcdBase )
+static uint32_t _DBE_HX8347_DrawLine( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2, SGUIColor* pclrIn )
 {
-    // Display ON Setting
-    _HX8347_WriteReg(pLcdBase, HX8347_R90H, 0x7F); // SAP=0111 1111
-    _HX8347_WriteReg(pLcdBase, HX8347_R26H, 0x04); // GON=0, DTE=0, D=01
-    Delay(100);
-    _HX8347_WriteReg(pLcdBase, HX8347_R26H, 0x24); // GON=1, DTE=0, D=01
-    _HX8347_WriteReg(pLcdBase, HX8347_R26H, 0x2C); // GON=1, DTE=0, D=11
-    Delay(100);
-    _HX8347_WriteReg(pLcdBase, HX8347_R26H, 0x3C); // GON=1, DTE=1, D=11
+    if ( pclrIn == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    LCDR_Line( dwX1, dwY1, dwX2, dwY2, _DBE_HX8347_FillBox, pclrIn ) ;
+
+    return SAMGUI_E_OK ;
 }
 
-//------------------------------------------------------------------------------
-/// Turn off the LCD.
-/// \param pLcdBase   LCD base address.
-//------------------------------------------------------------------------------
-static void _HX8347_Off( void *pLcdBase )
+static uint32_t _DBE_HX8347_DrawCircle( uint32_t dwX, uint32_t dwY, uint32_t dwRadius, SGUIColor* pclrBorder )
 {
-    _HX8347_WriteReg(pLcdBase, HX8347_R90H, 0x00); // SAP=0000 0000
-    _HX8347_WriteReg(pLcdBase, HX8347_R26H, 0x00); // GON=0, DTE=0, D=00
+    if ( pclrBorder == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( dwRadius < 2 )
+    {
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+
+    LCDR_Circle( dwX, dwY, dwRadius, _DBE_HX8347_FillBox, pclrBorder ) ;
+
+    return SAMGUI_E_OK ;
 }
 
-//------------------------------------------------------------------------------
-/// Set cursor of LCD srceen.
-/// \param pLcdBase   LCD base address.
-/// \param x          X-coordinate of upper-left corner on LCD.
-/// \param y          Y-coordinate of upper-left corner on LCD.
-//------------------------------------------------------------------------------
-static void _HX8347_SetCursor(void *pLcdBase, unsigned short x, unsigned short y)
+static uint32_t _DBE_HX8347_DrawFilledCircle( uint32_t dwX, uint32_t dwY, uint32_t dwRadius, SGUIColor* pclrBorder, SGUIColor* pclrInside )
 {
-    unsigned char x1, x2, y1, y2;
-
-    x1 = x & 0xff;
-    x2 = (x & 0xff00) >>8;
-    y1 = y & 0xff;
-    y2 = (y & 0xff00) >>8;
-    _HX8347_WriteReg(pLcdBase, HX8347_R02H, x2); // column high
-    _HX8347_WriteReg(pLcdBase, HX8347_R03H, x1); // column low
-    _HX8347_WriteReg(pLcdBase, HX8347_R06H, y2); // row high
-    _HX8347_WriteReg(pLcdBase, HX8347_R07H, y1); // row low
+    if ( dwRadius < 2 )
+    {
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+
+    if ( pclrInside != NULL )
+    {
+        LCDR_FilledCircle( dwX, dwY, dwRadius, _DBE_HX8347_FillBox, pclrInside ) ;
+    }
+
+    if ( pclrBorder != NULL )
+    {
+        _DBE_HX8347_DrawCircle( dwX, dwY, dwRadius, pclrBorder ) ;
+    }
+
+    return SAMGUI_E_OK ;
 }
 
-//------------------------------------------------------------------------------
-/// Set the window size user can access.
-/// \param pLcdBase   LCD base address.
-/// \param x_start    X-coordinate of upper-left corner on LCD.
-/// \param y_start    Y-coordinate of upper-left corner on LCD.
-/// \param x_end      X-coordinate of bottom-right corner on LCD.
-/// \param y_end      Y-coordinate of bottom-right corner on LCD.
-//------------------------------------------------------------------------------
-static void _HX8347_SetWindow(void *pLcdBase,unsigned short x_start, unsigned short y_start,unsigned short x_end, unsigned short y_end)
+static uint32_t _DBE_HX8347_DrawRectangle( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2, SGUIColor* pclrFrame )
 {
-    unsigned char x1, x2, y1, y2;
-
-        x1 = x_start & 0xff;
-        x2 = (x_start & 0xff00) >>8;
-        y1 = y_start & 0xff;
-        y2 = (y_start & 0xff00) >>8;
-        _HX8347_WriteReg(pLcdBase, 0x02, x2); // column high
-        _HX8347_WriteReg(pLcdBase, 0x03, x1); // column low
-        _HX8347_WriteReg(pLcdBase, 0x06, y2); // row high
-        _HX8347_WriteReg(pLcdBase, 0x07, y1); // row low
-
-        x1 = x_end & 0xff;
-        x2 = (x_end & 0xff00) >>8;
-        y1 = y_end & 0xff;
-        y2 = (y_end & 0xff00) >>8;
-        _HX8347_WriteReg(pLcdBase, 0x04, x2); // column high
-        _HX8347_WriteReg(pLcdBase, 0x05, x1); // column low
-        _HX8347_WriteReg(pLcdBase, 0x08, y2); // row high
-        _HX8347_WriteReg(pLcdBase, 0x09, y1); // row low
+    if ( pclrFrame == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    LCDR_Rectangle( dwX1, dwY1, dwX2, dwY2, _DBE_HX8347_FillBox, pclrFrame ) ;
+
+    return SAMGUI_E_OK ;
 }
 
+static uint32_t _DBE_HX8347_DrawFilledRectangle( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2, SGUIColor* pclrFrame, SGUIColor* pclrInside )
+{
+    uint32_t dw ;
+
+    if ( pclrInside == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    // Check coordonates
+    if ( dwX1 > dwX2 )
+    {
+        dw=dwX1 ;
+        dwX1=dwX2 ;
+        dwX2=dw ;
+    }
+
+    if ( dwY1 > dwY2 )
+    {
+        dw=dwY1 ;
+        dwY1=dwY2 ;
+        dwY2=dw ;
+    }
+
+    _DBE_HX8347_FillBox( pclrInside, dwX1, dwY1, dwX2-dwX1+1, dwY2-dwY1+1 ) ;
+
+    if ( pclrFrame != NULL )
+    {
+        LCDR_Rectangle( dwX1, dwY1, dwX2, dwY2, _DBE_HX8347_FillBox, pclrFrame ) ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * \brief Mark a bitmap which could not be drawn with a red crossed box.
+ */
+static void _DBE_HX8347_DrawBadBitmap( uint32_t dwX, uint32_t dwY, uint32_t dwWidth, uint32_t dwHeight )
+{
+    SGUIColor clr={ .u.dwRGBA=0xff0000 } ;
+
+    _DBE_HX8347_DrawFilledRectangle( dwX, dwY, dwX+dwWidth-1, dwY+dwHeight-1, NULL, &clr ) ;
+    clr.u.dwRGBA=0x000000 ;
+    _DBE_HX8347_DrawLine( dwX, dwY, dwX+dwWidth-1, dwY+dwHeight-1, &clr ) ;
+    _DBE_HX8347_DrawLine( dwX, dwY+dwHeight-1, dwX+dwWidth-1, dwY, &clr ) ;
+}
+
+/**
+ * \brief Write a run of 3 bytes per pixel to the GRAM, converted to RGB565.
+ *
+ * \param pucPixel  first pixel.
+ * \param dwCount  number of pixels.
+ * \param ucBGR  1 if the bytes are in B, G, R order (BMP rows), 0 for R, G, B.
+ */
+static void _DBE_HX8347_WriteRun24( const uint8_t* pucPixel, uint32_t dwCount, uint8_t ucBGR )
+{
+    if ( ucBGR )
+    {
+        for ( ; dwCount != 0 ; dwCount--, pucPixel+=3 )
+        {
+            HX8347_D=((pucPixel[2] & 0xF8) << 8) | ((pucPixel[1] & 0xFC) << 3) | (pucPixel[0] >> 3) ;
+        }
+    }
+    else
+    {
+        for ( ; dwCount != 0 ; dwCount--, pucPixel+=3 )
+        {
+            HX8347_D=((pucPixel[0] & 0xF8) << 8) | ((pucPixel[1] & 0xFC) << 3) | (pucPixel[2] >> 3) ;
+        }
+    }
+}
+
+/**
+ * \brief Draw a 24-bit BMP image in memory, limited to the clipping rectangle.
+ * Rows are sent top first from their bottom-up storage, in one GRAM burst.
+ */
+static uint32_t _DBE_HX8347_DrawBitmapBMP( uint32_t dwX, uint32_t dwY, uint32_t dwWidth, uint32_t dwHeight, uint8_t* pucData )
+{
+    BMPHeader* pHeader=(BMPHeader*)pucData ;
+    uint8_t* pucImage ;
+    uint32_t dwScanLineBytes ;
+    uint32_t dwRow ;
+    uint32_t dwCX1 ;
+    uint32_t dwCY1 ;
+    uint32_t dwCX2 ;
+    uint32_t dwCY2 ;
+
+    dwScanLineBytes=((pHeader->width*pHeader->bits+31)/32)*4 ;
+
+    // Check that parameters match
+    if ( (pHeader->compression != 0) || (pHeader->bits != 24) || (pHeader->width != dwWidth) || (pHeader->height != dwHeight) )
+    {
+        printf( "BMP_Decode: File format not supported\n\r" ) ;
+        _DBE_HX8347_DrawBadBitmap( dwX, dwY, dwWidth, dwHeight ) ;
+
+        return 2 ;
+    }
+
+    pucImage=pucData+pHeader->offset ;
+
+    dwCX1=dwX ;
+    dwCY1=dwY ;
+    dwCX2=dwX+dwWidth-1 ;
+    dwCY2=dwY+dwHeight-1 ;
+    if ( !_DBE_HX8347_ClipBox( &dwCX1, &dwCY1, &dwCX2, &dwCY2 ) )
+    {
+        return SAMGUI_E_OK ;
+    }
+
+    _DBE_HX8347_SetWindow( dwCX1, dwCY1, dwCX2, dwCY2 ) ;
+    _DBE_HX8347_RAMAccess_Prepare() ;
+
+    for ( dwRow=dwCY1-dwY ; dwRow <= dwCY2-dwY ; dwRow++ )
+    {
+        _DBE_HX8347_WriteRun24( pucImage+((dwHeight-dwRow-1)*dwScanLineBytes)+(dwCX1-dwX)*3, dwCX2-dwCX1+1, 1 ) ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * \brief Read function of the BMP file decoder.
+ *
+ * \param pContext  Opened FatFs file.
+ */
+static uint32_t _DBE_HX8347_FileRead( void* pContext, uint8_t* pBuffer, uint32_t dwSize )
+{
+    uint32_t dwLength=0 ;
+
+    if ( f_read( (FIL*)pContext, pBuffer, dwSize, &dwLength ) != FR_OK )
+    {
+        return 0 ;
+    }
+
+    return dwLength ;
+}
+
+/**
+ * \brief Draw a BMP file, decoded one row at a time while it is read.
+ *
+ * Top-down files are sent in one GRAM burst. Bottom-up files get a one row
+ * window per row, the GRAM address only incrementing. Only the part inside
+ * the clipping rectangle is sent.
+ */
+static uint32_t _DBE_HX8347_DrawBitmapBMPFile( uint32_t dwX, uint32_t dwY, uint32_t dwWidth, uint32_t dwHeight, uint8_t* pucData )
+{
+    FIL fp ;
+    BMPStream* pStream=&_DBE_HX8347_sBMPStream ;
+    uint8_t* pucRow=(uint8_t*)_DBE_HX8347_adwRowData ;
+    uint32_t dwCX1 ;
+    uint32_t dwCY1 ;
+    uint32_t dwCX2 ;
+    uint32_t dwCY2 ;
+    uint32_t dwRowY ;
+
+    if ( f_open( &fp, (const char*)pucData, FA_OPEN_EXISTING|FA_READ ) != FR_OK )
+    {
+        printf( "failed to open %s\r\n", (const char*)pucData ) ;
+        _DBE_HX8347_DrawBadBitmap( dwX, dwY, dwWidth, dwHeight ) ;
+
+        return SAMGUI_E_FILE_OPEN ;
+    }
+
+    if ( (BMP_StreamOpen( pStream, _DBE_HX8347_FileRead, &fp, _DBE_HX8347_aucFileData, sizeof( _DBE_HX8347_aucFileData ), BMP_ORDER_RGB ) != 0) ||
+         (pStream->header.width*3 > sizeof( _DBE_HX8347_adwRowData )) )
+    {
+        printf( "failed to read\r\n" ) ;
+        f_close( &fp ) ;
+
+        return SAMGUI_E_OK ;
+    }
+
+    // Visible part of the image
+    if ( dwWidth > pStream->header.width )
+    {
+        dwWidth=pStream->header.width ;
+    }
+
+    if ( dwHeight > pStream->dwHeight )
+    {
+        dwHeight=pStream->dwHeight ;
+    }
+
+    dwCX1=dwX ;
+    dwCY1=dwY ;
+    dwCX2=dwX+dwWidth-1 ;
+    dwCY2=dwY+dwHeight-1 ;
+
+    if ( (dwWidth != 0) && (dwHeight != 0) && _DBE_HX8347_ClipBox( &dwCX1, &dwCY1, &dwCX2, &dwCY2 ) )
+    {
+        if ( pStream->ucTopDown )
+        {
+            _DBE_HX8347_SetWindow( dwCX1, dwCY1, dwCX2, dwCY2 ) ;
+            _DBE_HX8347_RAMAccess_Prepare() ;
+        }
+
+        while ( BMP_StreamReadRow( pStream, pucRow, &dwRowY ) == 0 )
+        {
+            if ( (dwY+dwRowY < dwCY1) || (dwY+dwRowY > dwCY2) )
+            {
+                // Stop once the last visible row has been sent
+                if ( (pStream->ucTopDown) ? (dwY+dwRowY > dwCY2) : (dwY+dwRowY < dwCY1) )
+                {
+                    break ;
+                }
+                continue ;
+            }
+
+            if ( !pStream->ucTopDown )
+            {
+                _DBE_HX8347_SetWindow( dwCX1, dwY+dwRowY, dwCX2, dwY+dwRowY ) ;
+                _DBE_HX8347_RAMAccess_Prepare() ;
+            }
+
+            _DBE_HX8347_WriteRun24( pucRow+(dwCX1-dwX)*3, dwCX2-dwCX1+1, 0 ) ;
+        }
+    }
+
+    f_close( &fp ) ;
+
+    return SAMGUI_E_OK ;
+}
+
+static uint32_t _DBE_HX8347_DrawBitmap( uint32_t dwX, uint32_t dwY, uint32_t dwWidth, uint32_t dwHeight, uint8_t* pucData )
+{
+    uint32_t dwRow ;
+    uint32_t dwCX1 ;
+    uint32_t dwCY1 ;
+    uint32_t dwCX2 ;
+    uint32_t dwCY2 ;
+
+    // Nothing to draw outside of the clipping rectangle
+    if ( (dwWidth == 0) || (dwHeight == 0) ||
+         (dwX > _DBE_HX8347_dwClipX2) || (dwX+dwWidth <= _DBE_HX8347_dwClipX1) ||
+         (dwY > _DBE_HX8347_dwClipY2) || (dwY+dwHeight <= _DBE_HX8347_dwClipY1) )
+    {
+        return SAMGUI_E_OK ;
+    }
+
+    // Check if bitmap is Microsoft BMP
+    if ( (pucData[0] == 'B') && (pucData[1] == 'M') )
+    {
+        return _DBE_HX8347_DrawBitmapBMP( dwX, dwY, dwWidth, dwHeight, pucData ) ;
+    }
+
+    if ( pucData[0] == '/' )
+    {
+        return _DBE_HX8347_DrawBitmapBMPFile( dwX, dwY, dwWidth, dwHeight, pucData ) ;
+    }
+
+    // Draw raw RGB bitmap, limited to the clipping rectangle, in one GRAM burst
+    dwCX1=dwX ;
+    dwCY1=dwY ;
+    dwCX2=dwX+dwWidth-1 ;
+    dwCY2=dwY+dwHeight-1 ;
+    _DBE_HX8347_ClipBox( &dwCX1, &dwCY1, &dwCX2, &dwCY2 ) ;
+
+    _DBE_HX8347_SetWindow( dwCX1, dwCY1, dwCX2, dwCY2 ) ;
+    _DBE_HX8347_RAMAccess_Prepare() ;
+
+    for ( dwRow=dwCY1 ; dwRow <= dwCY2 ; dwRow++ )
+    {
+        _DBE_HX8347_WriteRun24( pucData+(((dwRow-dwY)*dwWidth)+(dwCX1-dwX))*3, dwCX2-dwCX1+1, 0 ) ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * \brief Draw a rectangle of pixels already in the GRAM format
+ * (DISP_PIXEL_FORMAT_RGB565_2B), limited to the clipping rectangle.
+ */
+static uint32_t _DBE_HX8347_DrawNative( uint32_t dwX, uint32_t dwY, uint32_t dwWidth, uint32_t dwHeight, const uint8_t* pucPixels )
+{
+    const uint8_t* pucLine ;
+    uint32_t dwCX1 ;
+    uint32_t dwCY1 ;
+    uint32_t dwCX2 ;
+    uint32_t dwCY2 ;
+    uint32_t dwRow ;
+    uint32_t dw ;
+
+    if ( (dwWidth == 0) || (dwHeight == 0) )
+    {
+        return SAMGUI_E_OK ;
+    }
+
+    dwCX1=dwX ;
+    dwCY1=dwY ;
+    dwCX2=dwX+dwWidth-1 ;
+    dwCY2=dwY+dwHeight-1 ;
+    if ( !_DBE_HX8347_ClipBox( &dwCX1, &dwCY1, &dwCX2, &dwCY2 ) )
+    {
+        return SAMGUI_E_OK ;
+    }
+
+    _DBE_HX8347_SetWindow( dwCX1, dwCY1, dwCX2, dwCY2 ) ;
+    _DBE_HX8347_RAMAccess_Prepare() ;
+
+    // One GRAM burst, the window wraps the rows
+    for ( dwRow=dwCY1 ; dwRow <= dwCY2 ; dwRow++ )
+    {
+        pucLine=pucPixels+(((dwRow-dwY)*dwWidth)+(dwCX1-dwX))*2 ;
+
+        if ( ((uint32_t)pucLine & 0x1) == 0 )
+        {
+            const uint16_t* pwLine=(const uint16_t*)pucLine ;
+
+            for ( dw=dwCX2-dwCX1+1 ; dw != 0 ; dw-- )
+            {
+                HX8347_D=*pwLine++ ;
+            }
+        }
+        else
+        {
+            for ( dw=dwCX2-dwCX1+1 ; dw != 0 ; dw--, pucLine+=2 )
+            {
+                HX8347_D=pucLine[0] | (pucLine[1] << 8) ;
+            }
+        }
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * \brief Draw a character, each glyph column being written through a one
+ * pixel wide window with one GRAM burst per run of set pixels. The glyphs
+ * (0x20 to 0x7F) hold one 16-bit column per pixel of the font width, top row
+ * in the most significant bit, as aucFont10x14.
+ */
+static uint32_t _DBE_HX8347_DrawChar( uint32_t dwX, uint32_t dwY, uint8_t ucChar, SGUIColor* pclrText, SGUIFont* pFont, uint32_t dwSize )
+{
+    const uint8_t* pucGlyph ;
+    uint32_t dwCol ;
+    uint32_t dwRow ;
+    uint32_t dwStart ;
+    uint32_t dwEnd ;
+    uint32_t dwBits ;
+    uint16_t wColor ;
+
+    if ( (dwX > _DBE_HX8347_dwClipX2) || (dwX+pFont->dwWidth <= _DBE_HX8347_dwClipX1) ||
+         (dwY > _DBE_HX8347_dwClipY2) || (dwY+pFont->dwHeight <= _DBE_HX8347_dwClipY1) ||
+         (ucChar < 0x20) || (ucChar > 0x7F) )
+    {
+        return SAMGUI_E_OK ;
+    }
+
+    wColor=HX8347_RGB565( pclrText->u.dwRGBA ) ;
+    pucGlyph=(const uint8_t*)pFont->pvData+(ucChar - 0x20)*pFont->dwWidth*2 ;
+
+    for ( dwCol=0 ; dwCol < pFont->dwWidth ; dwCol++ )
+    {
+        if ( (dwX+dwCol < _DBE_HX8347_dwClipX1) || (dwX+dwCol > _DBE_HX8347_dwClipX2) )
+        {
+            continue ;
+        }
+
+        // rows 0..7 in bits 15..8, rows 8..15 in bits 7..0
+        dwBits=(pucGlyph[dwCol * 2] << 8) | pucGlyph[dwCol * 2 + 1] ;
+
+        for ( dwRow=0 ; (dwRow < pFont->dwHeight) && (dwBits != 0) ; )
+        {
+            if ( ((dwBits >> (15 - dwRow)) & 0x1) == 0 )
+            {
+                dwRow++ ;
+                continue ;
+            }
+
+            for ( dwStart=dwRow ; (dwRow < pFont->dwHeight) && ((dwBits >> (15 - dwRow)) & 0x1) ; dwRow++ ) ;
+
+            // Clip the run vertically
+            dwEnd=dwY+dwRow-1 ;
+            dwStart+=dwY ;
+            if ( dwStart < _DBE_HX8347_dwClipY1 ) dwStart=_DBE_HX8347_dwClipY1 ;
+            if ( dwEnd > _DBE_HX8347_dwClipY2 ) dwEnd=_DBE_HX8347_dwClipY2 ;
+            if ( dwStart > dwEnd )
+            {
+                continue ;
+            }
+
+            _DBE_HX8347_SetWindow( dwX+dwCol, dwStart, dwX+dwCol, dwEnd ) ;
+            _DBE_HX8347_RAMAccess_Prepare() ;
+            for ( ; dwStart <= dwEnd ; dwStart++ )
+            {
+                HX8347_D=wColor ;
+            }
+        }
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+static uint32_t _DBE_HX8347_DrawText( uint32_t dwX, uint32_t dwY, char* pszText, SGUIColor* pclrText, SGUIFont* pFont, uint32_t dwSize )
+{
+    uint32_t dwXOrg=dwX ;
+
+    if ( (pszText == NULL) || (pclrText == NULL) || (pFont == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    while ( *pszText != 0 )
+    {
+        if ( *pszText == '\n' )
+        {
+            dwY+=pFont->dwHeight+2 ;
+            dwX=dwXOrg ;
+        }
+        else
+        {
+            _DBE_HX8347_DrawChar( dwX, dwY, *pszText, pclrText, pFont, dwSize ) ;
+            dwX+=pFont->dwWidth+2 ;
+        }
+        pszText++ ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+static uint32_t _DBE_HX8347_IOCtl( uint32_t dwCommand, uint32_t* pdwValue, uint32_t* pdwValueLength )
+{
+    switch ( dwCommand )
+    {
+        case DISP_BACKEND_IOCTL_POWER_ON :
+            _DBE_HX8347_LCD_On() ;
+        break ;
+
+        case DISP_BACKEND_IOCTL_POWER_OFF :
+            _DBE_HX8347_LCD_Off() ;
+        break ;
+
+        case DISP_BACKEND_IOCTL_SET_BACKLIGHT :
+            _DBE_HX8347_SetBacklight( (uint32_t)pdwValue ) ;
+        break ;
+
+        case DISP_BACKEND_IOCTL_SET_MODE_PORTRAIT :
+        case DISP_BACKEND_IOCTL_SET_MODE_LANDSCAPE :
+        break ;
+
+        case DISP_BACKEND_IOCTL_FLUSH :
+            // Drawing goes straight to the GRAM
+        break ;
+
+        case DISP_BACKEND_IOCTL_SET_SCROLL_AREA :
+        case DISP_BACKEND_IOCTL_SET_SCROLL_OFFSET :
+            // No hardware scrolling, callers redraw instead
+        return SAMGUI_E_WRONG_COMPONENT ;
+
+        case DISP_BACKEND_IOCTL_GET_PIXEL_FORMAT :
+            if ( pdwValue == NULL )
+            {
+                return SAMGUI_E_BAD_POINTER ;
+            }
+            *pdwValue=DISP_PIXEL_FORMAT_RGB565_2B ;
+        break ;
+
+        default :
+            printf( "_DBE_HX8347_IOCtl - Bad IOCtl index (%x)\r\n", dwCommand ) ;
+        break ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported interface
+ *----------------------------------------------------------------------------*/
 SDISPBackend sDISP_Backend_HX8347=
 {
-    .sData={ 0 },
-
-//    .Reset=_DBE_HX8347_Reset,
-//    .Initialize=_DBE_HX8347_Initialize,
-//    .GetPixel=_DBE_HX8347_GetPixel,
-//    .SetPixel=_DBE_HX8347_SetPixel,
-//    .DrawLine=_DBE_HX8347_DrawLine,
-//    .DrawCircle=_DBE_HX8347_DrawCircle,
-//    .DrawFilledCircle=_DBE_HX8347_DrawFilledCircle,
-//    .DrawRectangle=_DBE_HX8347_DrawRectangle,
-//    .DrawFilledRectangle=_DBE_HX8347_DrawFilledRectangle,
-//    .DrawBitmap=_DBE_HX8347_DrawBitmap,
-//    .IOCtl=_DBE_HX8347_IOCtl
+    .sData=
+    {
+        .dwID=DISP_BACKEND_HX8347,
+    },
+
+    .Reset=_DBE_HX8347_Reset,
+    .Initialize=_DBE_HX8347_Initialize,
+    .GetPixel=_DBE_HX8347_GetPixel,
+    .DrawPixel=_DBE_HX8347_DrawPixel,
+    .DrawLine=_DBE_HX8347_DrawLine,
+    .DrawCircle=_DBE_HX8347_DrawCircle,
+    .DrawFilledCircle=_DBE_HX8347_DrawFilledCircle,
+    .DrawRectangle=_DBE_HX8347_DrawRectangle,
+    .DrawFilledRectangle=_DBE_HX8347_DrawFilledRectangle,
+    .DrawBitmap=_DBE_HX8347_DrawBitmap,
+    .DrawText=_DBE_HX8347_DrawText,
+    .Fill=NULL,
+    .IOCtl=_DBE_HX8347_IOCtl,
+    .SetClipRect=_DBE_HX8347_SetClipRect,
+    .DrawNative=_DBE_HX8347_DrawNative
 } ;
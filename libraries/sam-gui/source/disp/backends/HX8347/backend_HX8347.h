@@ -32,22 +32,13 @@
 ///
 /// !!!Purpose
 ///
-/// Definition of methods for HX8347 driver.
+/// HX8347 display backend.
 ///
 /// !!!Usage
 ///
-/// -# LCD_WriteReg
-/// -# LCD_ReadReg
-/// -# LCD_ReadStatus
-/// -# LCD_DumpReg
-/// -# LCD_WriteRAM_Prepare
-/// -# LCD_WriteRAM
-/// -# LCD_ReadRAM_Prepare
-/// -# LCD_ReadRAM
-/// -# LCD_Initialize
-/// -# LCD_SetCursor
-/// -# LCD_On
-/// -# LCD_Off
+/// -# Register sDISP_Backend_HX8347 with DISP_AddBackend
+/// -# Draw through the SDISPBackend methods, DrawNative takes
+///    DISP_PIXEL_FORMAT_RGB565_2B pixels
 //------------------------------------------------------------------------------
 
 #ifndef HX8347_H
@@ -70,20 +61,6 @@
 //         Global functions
 //------------------------------------------------------------------------------
 
-//void LCD_WriteReg(void *pLcdBase, unsigned char reg, unsigned short data);
-//unsigned short LCD_ReadReg(void *pLcdBase, unsigned char reg);
-//unsigned short LCD_ReadStatus(void *pLcdBase);
-//void LCD_DumpReg(void *pLcdBase, unsigned char startAddr, unsigned char endAddr);
-//void LCD_WriteRAM_Prepare(void *pLcdBase);
-//void LCD_WriteRAM(void *pLcdBase, unsigned short color);
-//void LCD_ReadRAM_Prepare(void *pLcdBase);
-//unsigned short LCD_ReadRAM(void *pLcdBase);
-//void LCD_Initialize(void *pLcdBase);
-//void LCD_SetCursor(void *pLcdBase, unsigned short x, unsigned short y);
-//void LCD_On(void *pLcdBase);
-//void LCD_Off(void *pLcdBase);
-//void LCD_SetWindow(void *pLcdBase,unsigned short x_start, unsigned short y_start,unsigned short x_end, unsigned short y_end);
-
 extern SDISPBackend sDISP_Backend_HX8347 ;
 
 #endif //#ifndef HX8347_H
@@ -200,8 +200,27 @@ typedef volatile uint8_t vByte ;
  *        Statics
  *----------------------------------------------------------------------------*/
 
-/** static buffer for file operations */
-static uint8_t _DBE_ILI9325_aucFileData[1024*2] ;
+/** static buffer for file operations, one file system sector */
+static uint8_t _DBE_ILI9325_aucFileData[512] ;
+
+/** decoded BMP row, as wide as the largest screen dimension */
+static uint32_t _DBE_ILI9325_adwRowData[(ILI9325_HEIGTH*3+3)/4] ;
+
+/** BMP file decoder */
+static BMPStream _DBE_ILI9325_sBMPStream ;
+
+/** clipping rectangle (inclusive), drawing outside of it is discarded */
+static uint32_t _DBE_ILI9325_dwClipX1=0 ;
+static uint32_t _DBE_ILI9325_dwClipY1=0 ;
+static uint32_t _DBE_ILI9325_dwClipX2=BOARD_LCD_WIDTH-1 ;
+static uint32_t _DBE_ILI9325_dwClipY2=BOARD_LCD_HEIGHT-1 ;
+
+/** Hardware scroll area: first panel row and number of rows, full screen means base image scrolling */
+static uint32_t _DBE_ILI9325_dwScrollY=0 ;
+static uint32_t _DBE_ILI9325_dwScrollHeight=BOARD_LCD_HEIGHT ;
+
+/** Display Control 1 value used when the LCD is on, depends on base/partial image display */
+static uint16_t _DBE_ILI9325_wDispCtrl1=0x133 ;
 
 /**
  * \brief Write data to LCD Register.
@@ -318,7 +337,7 @@ static inline void _DBE_ILI9325_SetCursor( uint16_t wX, uint16_t wY )
  */
 static inline void _DBE_ILI9325_LCD_On( void )
 {
-    _DBE_ILI9325_WriteReg( TS_INS_DISP_CTRL1, 0x133 ) ;
+    _DBE_ILI9325_WriteReg( TS_INS_DISP_CTRL1, _DBE_ILI9325_wDispCtrl1 ) ;
 }
 
 /**
@@ -376,6 +395,80 @@ static void _DBE_ILI9325_SetBacklight( uint32_t dwLevel )
     }
 }
 
+/**
+ * \brief Scroll the hardware scroll area, no GRAM is rewritten.
+ *
+ * Panel row dwScrollY+k shows GRAM row dwScrollY+((k+dwOffset) mod dwScrollHeight).
+ * A full screen area uses the base image vertical scroll (R61h VLE, R6Ah).
+ * A band uses the two partial images as a ring: image 1 shows the rows from
+ * the offset to the end of the band, image 2 the rows wrapped to the top of
+ * the band. The base image is off in that mode, the rows outside the band are
+ * not displayed.
+ *
+ * \param dwOffset offset in rows, 0 to dwScrollHeight-1.
+ */
+static void _DBE_ILI9325_SetScrollOffset( uint32_t dwOffset )
+{
+    uint32_t dwY=_DBE_ILI9325_dwScrollY ;
+    uint32_t dwHeight=_DBE_ILI9325_dwScrollHeight ;
+
+    dwOffset%=dwHeight ;
+
+    if ( dwHeight == BOARD_LCD_HEIGHT )
+    {
+        _DBE_ILI9325_wDispCtrl1=0x133 ;
+        _DBE_ILI9325_WriteReg( TS_INS_GATE_SCAN_CTRL2, 0x0003 ) ; /* REV, VLE */
+        _DBE_ILI9325_WriteReg( TS_INS_GATE_SCAN_CTRL3, (uint16_t)dwOffset ) ;
+    }
+    else
+    {
+        _DBE_ILI9325_WriteReg( TS_INS_PART_IMG1_DISP_POS, (uint16_t)dwY ) ;
+        _DBE_ILI9325_WriteReg( TS_INS_PART_IMG1_START_AD, (uint16_t)(dwY+dwOffset) ) ;
+        _DBE_ILI9325_WriteReg( TS_INS_PART_IMG1_END_AD, (uint16_t)(dwY+dwHeight-1) ) ;
+
+        if ( dwOffset == 0 )
+        {
+            _DBE_ILI9325_wDispCtrl1=0x1033 ; /* PTDE0 */
+        }
+        else
+        {
+            _DBE_ILI9325_WriteReg( TS_INS_PART_IMG2_DISP_POS, (uint16_t)(dwY+dwHeight-dwOffset) ) ;
+            _DBE_ILI9325_WriteReg( TS_INS_PART_IMG2_START_AD, (uint16_t)dwY ) ;
+            _DBE_ILI9325_WriteReg( TS_INS_PART_IMG2_END_AD, (uint16_t)(dwY+dwOffset-1) ) ;
+            _DBE_ILI9325_wDispCtrl1=0x3033 ; /* PTDE1, PTDE0 */
+        }
+    }
+
+    _DBE_ILI9325_LCD_On() ;
+}
+
+/**
+ * \brief Set the hardware scroll area and reset its offset.
+ *
+ * \param dwY first panel row of the area.
+ * \param dwHeight number of rows, BOARD_LCD_HEIGHT with dwY=0 scrolls the whole screen.
+ */
+static uint32_t _DBE_ILI9325_SetScrollArea( uint32_t dwY, uint32_t dwHeight )
+{
+    if ( (dwHeight == 0) || (dwY+dwHeight > BOARD_LCD_HEIGHT) )
+    {
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+
+    _DBE_ILI9325_dwScrollY=dwY ;
+    _DBE_ILI9325_dwScrollHeight=dwHeight ;
+
+    if ( dwHeight != BOARD_LCD_HEIGHT )
+    {
+        /* Back to a fixed base image, it is not displayed anyway */
+        _DBE_ILI9325_WriteReg( TS_INS_GATE_SCAN_CTRL2, 0x0001 ) ;
+        _DBE_ILI9325_WriteReg( TS_INS_GATE_SCAN_CTRL3, 0x0000 ) ;
+    }
+    _DBE_ILI9325_SetScrollOffset( 0 ) ;
+
+    return SAMGUI_E_OK ;
+}
+
 static void _DBE_ILI9325_SetOrientation( uint32_t dwOrientation )
 {
 //DISP_BACKEND_IOCTL_SET_MODE_PORTRAIT
@@ -407,6 +500,34 @@ static void _DBE_ILI9325_SetWindow( uint32_t dwX, uint32_t dwY, uint32_t dwWidth
    _DBE_ILI9325_WriteReg( TS_INS_VER_END_AD, (uint16_t)dwY+dwHeight-1 ) ;
 }
 
+/**
+ * \brief Set the clipping rectangle, limited to the screen.
+ */
+static uint32_t _DBE_ILI9325_SetClipRect( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2 )
+{
+    _DBE_ILI9325_dwClipX1=(dwX1 < BOARD_LCD_WIDTH)?dwX1:BOARD_LCD_WIDTH-1 ;
+    _DBE_ILI9325_dwClipY1=(dwY1 < BOARD_LCD_HEIGHT)?dwY1:BOARD_LCD_HEIGHT-1 ;
+    _DBE_ILI9325_dwClipX2=(dwX2 < BOARD_LCD_WIDTH)?dwX2:BOARD_LCD_WIDTH-1 ;
+    _DBE_ILI9325_dwClipY2=(dwY2 < BOARD_LCD_HEIGHT)?dwY2:BOARD_LCD_HEIGHT-1 ;
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * \brief Intersect a box with the clipping rectangle.
+ *
+ * \return 0 if nothing of the box remains visible.
+ */
+static uint32_t _DBE_ILI9325_ClipBox( uint32_t* pdwX1, uint32_t* pdwY1, uint32_t* pdwX2, uint32_t* pdwY2 )
+{
+    if ( *pdwX1 < _DBE_ILI9325_dwClipX1 ) *pdwX1=_DBE_ILI9325_dwClipX1 ;
+    if ( *pdwY1 < _DBE_ILI9325_dwClipY1 ) *pdwY1=_DBE_ILI9325_dwClipY1 ;
+    if ( *pdwX2 > _DBE_ILI9325_dwClipX2 ) *pdwX2=_DBE_ILI9325_dwClipX2 ;
+    if ( *pdwY2 > _DBE_ILI9325_dwClipY2 ) *pdwY2=_DBE_ILI9325_dwClipY2 ;
+
+    return (*pdwX1 <= *pdwX2) && (*pdwY1 <= *pdwY2) ;
+}
+
 /**
  * \brief Initialize the LCD controller.
  */
@@ -578,6 +699,12 @@ static uint32_t _DBE_ILI9325_DrawPixel( uint32_t dwX, uint32_t dwY, SGUIColor* p
         dwY=BOARD_LCD_HEIGHT-1 ;
     }
 
+    if ( (dwX < _DBE_ILI9325_dwClipX1) || (dwX > _DBE_ILI9325_dwClipX2) ||
+         (dwY < _DBE_ILI9325_dwClipY1) || (dwY > _DBE_ILI9325_dwClipY2) )
+    {
+        return SAMGUI_E_OK ;
+    }
+
     _DBE_ILI9325_SetCursor( dwX, dwY ) ;
     _DBE_ILI9325_RAMAccess_Prepare() ;
 #ifdef ILI9325_RGB_MODE
@@ -596,140 +723,86 @@ static uint32_t _DBE_ILI9325_DrawPixel( uint32_t dwX, uint32_t dwY, SGUIColor* p
     return SAMGUI_E_OK ;
 }
 
-static uint32_t _DBE_ILI9325_DrawLineBresenham( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2, SGUIColor* pclrIn )
+/**
+ * \brief Box filler of the span rasterizer: clips the box and writes it as one
+ * GRAM burst.
+ *
+ * \param pContext  SGUIColor of the box.
+ */
+static void _DBE_ILI9325_FillBox( void* pContext, int32_t iX, int32_t iY, uint32_t dwWidth, uint32_t dwHeight )
 {
-    int dx, dy ;
-    int i ;
-    int xinc, yinc, cumul ;
-    int x, y ;
-
-    x = dwX1 ;
-    y = dwY1 ;
-    dx = dwX2 - dwX1 ;
-    dy = dwY2 - dwY1 ;
-
-    xinc = ( dx > 0 ) ? 1 : -1 ;
-    yinc = ( dy > 0 ) ? 1 : -1 ;
-    dx = ( dx > 0 ) ? dx : -dx ;
-    dy = ( dy > 0 ) ? dy : -dy ;
-
-    _DBE_ILI9325_DrawPixel( x, y, pclrIn ) ;
+    SGUIColor* pclrIn=(SGUIColor*)pContext ;
+    uint32_t dwX1 ;
+    uint32_t dwY1 ;
+    uint32_t dwX2 ;
+    uint32_t dwY2 ;
+    uint32_t dw ;
+    uint8_t ucC1 ;
+    uint8_t ucC2 ;
+    uint8_t ucC3 ;
 
-    if ( dx > dy )
+    if ( (iX+(int32_t)dwWidth <= 0) || (iY+(int32_t)dwHeight <= 0) )
     {
-      cumul = dx / 2 ;
-      for ( i = 1 ; i <= dx ; i++ )
-      {
-        x += xinc ;
-        cumul += dy ;
-
-        if ( cumul >= dx )
-        {
-          cumul -= dx ;
-          y += yinc ;
-        }
-        _DBE_ILI9325_DrawPixel( x, y, pclrIn ) ;
-      }
+        return ;
     }
-    else
-    {
-        cumul = dy / 2 ;
-        for ( i = 1 ; i <= dy ; i++ )
-        {
-            y += yinc ;
-            cumul += dx ;
 
-            if ( cumul >= dy )
-            {
-                cumul -= dy ;
-                x += xinc ;
-            }
+    dwX1=(iX < 0)?0:iX ;
+    dwY1=(iY < 0)?0:iY ;
+    dwX2=iX+dwWidth-1 ;
+    dwY2=iY+dwHeight-1 ;
 
-            _DBE_ILI9325_DrawPixel( x, y, pclrIn ) ;
-        }
+    if ( !_DBE_ILI9325_ClipBox( &dwX1, &dwY1, &dwX2, &dwY2 ) )
+    {
+        return ;
     }
 
-    return SAMGUI_E_OK ;
-}
-
-static uint32_t _DBE_ILI9325_DrawLine( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2, SGUIColor* pclrIn )
-{
-    uint32_t dw=0 ;
+#ifdef ILI9325_BGR_MODE
+    ucC1=pclrIn->u.dwRGBA & 0xff ;
+    ucC2=(pclrIn->u.dwRGBA >> 8) & 0xff ;
+    ucC3=(pclrIn->u.dwRGBA >> 16) & 0xff ;
+#endif // ILI9325_BGR_MODE
 
-    if ( dwX1 >= BOARD_LCD_WIDTH )
-    {
-        dwX1=BOARD_LCD_WIDTH-1 ;
-    }
+#ifdef ILI9325_RGB_MODE
+    ucC1=(pclrIn->u.dwRGBA >> 16) & 0xff ;
+    ucC2=(pclrIn->u.dwRGBA >> 8) & 0xff ;
+    ucC3=pclrIn->u.dwRGBA & 0xff ;
+#endif // ILI9325_RGB_MODE
 
-    if ( dwX2 >= BOARD_LCD_WIDTH )
+    // A single line needs no window, GRAM address increments along it
+    if ( dwY1 != dwY2 )
     {
-        dwX2=BOARD_LCD_WIDTH-1 ;
+        _DBE_ILI9325_SetWindow( dwX1, dwY1, dwX2-dwX1+1, dwY2-dwY1+1 ) ;
     }
+    _DBE_ILI9325_SetCursor( dwX1, dwY1 ) ;
+    _DBE_ILI9325_RAMAccess_Prepare() ;
 
-    if ( dwY1 >= BOARD_LCD_HEIGHT )
+    for ( dw=(dwX2-dwX1+1)*(dwY2-dwY1+1) ; dw > 0 ; dw-- )
     {
-        dwY1=BOARD_LCD_HEIGHT-1 ;
+        ILI9325_D=ucC1 ;
+        ILI9325_D=ucC2 ;
+        ILI9325_D=ucC3 ;
     }
 
-    if ( dwY2 >= BOARD_LCD_HEIGHT )
+    if ( dwY1 != dwY2 )
     {
-        dwY2=BOARD_LCD_HEIGHT-1 ;
+        _DBE_ILI9325_SetWindow( 0, 0, BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT ) ;
     }
+}
 
-    _DBE_ILI9325_SetCursor( dwX1, dwY1 ) ;
-
-    // Horizontal line
-    if ( dwY1 == dwY2 )
+static uint32_t _DBE_ILI9325_DrawLine( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2, SGUIColor* pclrIn )
+{
+    if ( pclrIn == NULL )
     {
-        _DBE_ILI9325_RAMAccess_Prepare() ;
-
-        if ( dwX1 > dwX2 )
-        {
-            dw=dwX1 ;
-            dwX1=dwX2 ;
-            dwX2=dw ;
-        }
-
-        for ( dw=dwX1 ; dw <= dwX2 ; dw++ )
-        {
-            _DBE_ILI9325_WriteRAM( /*_DBE_ILI9325_Color666*/( pclrIn->u.dwRGBA ) ) ;
-        }
+        return SAMGUI_E_BAD_POINTER ;
     }
-    else
-    {
-        // Vertical line
-        if ( dwX1 == dwX2 )
-        {
-            if ( dwY1 > dwY2 )
-            {
-                dw=dwY1 ;
-                dwY1=dwY2 ;
-                dwY2=dw ;
-            }
 
-            for ( dw=dwY1 ; dw <= dwY2 ; dw++ )
-            {
-                _DBE_ILI9325_RAMAccess_Prepare() ;
-                _DBE_ILI9325_WriteRAM( /*_DBE_ILI9325_Color666*/( pclrIn->u.dwRGBA ) ) ;
-                _DBE_ILI9325_SetCursor( dwX1, dw ) ;
-            }
-        }
-        else // Bresenham
-        {
-            return _DBE_ILI9325_DrawLineBresenham( dwX1, dwY1, dwX2, dwY2, pclrIn ) ;
-        }
-    }
+    LCDR_Line( dwX1, dwY1, dwX2, dwY2, _DBE_ILI9325_FillBox, pclrIn ) ;
 
     return SAMGUI_E_OK ;
 }
 
-#if 1
 static uint32_t _DBE_ILI9325_DrawCircle( uint32_t dwX, uint32_t dwY, uint32_t dwRadius, SGUIColor* pclrBorder )
 {
-    signed int d ; // Decision Variable
-    uint32_t dwCurX ; // Current X Value
-    uint32_t dwCurY ; // Current Y Value
-
     if ( pclrBorder == NULL )
     {
         return SAMGUI_E_BAD_POINTER ;
@@ -740,113 +813,21 @@ static uint32_t _DBE_ILI9325_DrawCircle( uint32_t dwX, uint32_t dwY, uint32_t dw
         return SAMGUI_E_BAD_PARAMETER ;
     }
 
-    d = 3 - (dwRadius << 1) ;
-    dwCurX = 0 ;
-    dwCurY = dwRadius ;
-
-    while ( dwCurX <= dwCurY )
-    {
-        _DBE_ILI9325_DrawPixel( dwX + dwCurX, dwY + dwCurY, pclrBorder ) ;
-        _DBE_ILI9325_DrawPixel( dwX + dwCurX, dwY - dwCurY, pclrBorder ) ;
-        _DBE_ILI9325_DrawPixel( dwX - dwCurX, dwY + dwCurY, pclrBorder ) ;
-        _DBE_ILI9325_DrawPixel( dwX - dwCurX, dwY - dwCurY, pclrBorder ) ;
-        _DBE_ILI9325_DrawPixel( dwX + dwCurY, dwY + dwCurX, pclrBorder ) ;
-        _DBE_ILI9325_DrawPixel( dwX + dwCurY, dwY - dwCurX, pclrBorder ) ;
-        _DBE_ILI9325_DrawPixel( dwX - dwCurY, dwY + dwCurX, pclrBorder ) ;
-        _DBE_ILI9325_DrawPixel( dwX - dwCurY, dwY - dwCurX, pclrBorder ) ;
-
-        if ( d < 0 )
-        {
-            d += (dwCurX << 2) + 6 ;
-        }
-        else
-        {
-            d += ((dwCurX - dwCurY) << 2) + 10;
-            dwCurY-- ;
-        }
-
-        dwCurX++ ;
-    }
+    LCDR_Circle( dwX, dwY, dwRadius, _DBE_ILI9325_FillBox, pclrBorder ) ;
 
     return SAMGUI_E_OK ;
 }
-#else
-static void _DBE_ILI9325_Plot4points( uint32_t dwX, uint32_t dwY, int iX, int iY, SGUIColor* pclrBorder )
-{
-  _DBE_ILI9325_DrawPixel( dwX+iX, dwY+iY, pclrBorder ) ;
-  if ( iX != 0 ) _DBE_ILI9325_DrawPixel( dwX-iX, dwY+iY, pclrBorder ) ;
-  if ( iY != 0 ) _DBE_ILI9325_DrawPixel( dwX+iX, dwY-iY, pclrBorder ) ;
-  if ( iX != 0 && iY != 0 ) _DBE_ILI9325_DrawPixel( dwX-iX, dwY-iY, pclrBorder ) ;
-}
-
-static void _DBE_ILI9325_Plot8points( uint32_t dwX, uint32_t dwY, int x, int iY, SGUIColor* pclrBorder )
-{
-  _DBE_ILI9325_Plot4points( dwX, dwY, iX, iY, pclrBorder ) ;
-  if ( iX != iY ) _DBE_ILI9325_Plot4points( dwX, dwY, iY, iX, pclrBorder ) ;
-}
-
-static uint32_t _DBE_ILI9325_DrawCircle( uint32_t dwX, uint32_t dwY, uint32_t dwRadius, SGUIColor* pclrBorder )
-{
-  int iError=-dwRadius ;
-  int iX=dwRadius ;
-  int iY=0 ;
-
-  while ( iX >= iY )
-  {
-    plot8points( dwX, dwY, iX, iY, pclrBorder ) ;
-
-    iError+=iY ;
-    ++iY ;
-    iError+=iY ;
-
-    if ( iError >= 0 )
-    {
-      --iX ;
-      iError-=iX ;
-      iError-=iX ;
-    }
-  }
-}
-#endif
 
 static uint32_t _DBE_ILI9325_DrawFilledCircle( uint32_t dwX, uint32_t dwY, uint32_t dwRadius, SGUIColor* pclrBorder, SGUIColor* pclrInside )
 {
-    signed int d ; // Decision Variable
-    uint32_t dwCurX ; // Current X Value
-    uint32_t dwCurY ; // Current Y Value
-
-//    if ( pclrBorder == NULL )
-//    {
-//        return SAMGUI_E_BAD_POINTER ;
-//    }
-
     if ( dwRadius < 2 )
     {
         return SAMGUI_E_BAD_PARAMETER ;
     }
 
-    d = 3 - (dwRadius << 1) ;
-    dwCurX = 0 ;
-    dwCurY = dwRadius ;
-
-    while ( dwCurX <= dwCurY )
+    if ( pclrInside != NULL )
     {
-        _DBE_ILI9325_DrawLine( dwX-dwCurX, dwY-dwCurY, dwX+dwCurX, dwY-dwCurY, pclrInside ) ;
-        _DBE_ILI9325_DrawLine( dwX-dwCurX, dwY+dwCurY, dwX+dwCurX, dwY+dwCurY, pclrInside ) ;
-        _DBE_ILI9325_DrawLine( dwX-dwCurY, dwY-dwCurX, dwX+dwCurY, dwY-dwCurX, pclrInside ) ;
-        _DBE_ILI9325_DrawLine( dwX-dwCurY, dwY+dwCurX, dwX+dwCurY, dwY+dwCurX, pclrInside ) ;
-
-        if ( d < 0 )
-        {
-            d += (dwCurX << 2) + 6 ;
-        }
-        else
-        {
-            d += ((dwCurX - dwCurY) << 2) + 10;
-            dwCurY-- ;
-        }
-
-        dwCurX++ ;
+        LCDR_FilledCircle( dwX, dwY, dwRadius, _DBE_ILI9325_FillBox, pclrInside ) ;
     }
 
     if ( pclrBorder != NULL )
@@ -859,28 +840,12 @@ static uint32_t _DBE_ILI9325_DrawFilledCircle( uint32_t dwX, uint32_t dwY, uint3
 
 static uint32_t _DBE_ILI9325_DrawRectangle( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2, SGUIColor* pclrFrame )
 {
-    uint32_t dw ;
-
-    // Check coordonates
-    if ( dwX1 > dwX2 )
+    if ( pclrFrame == NULL )
     {
-        dw=dwX1 ;
-        dwX1=dwX2 ;
-        dwX2=dw ;
-    }
-
-    if ( dwY1 > dwY2 )
-    {
-        dw=dwY1 ;
-        dwY1=dwY2 ;
-        dwY2=dw ;
+        return SAMGUI_E_BAD_POINTER ;
     }
 
-    _DBE_ILI9325_DrawLine( dwX1, dwY1, dwX2, dwY1, pclrFrame ) ;
-    _DBE_ILI9325_DrawLine( dwX1, dwY2, dwX2, dwY2, pclrFrame ) ;
-
-    _DBE_ILI9325_DrawLine( dwX1, dwY1, dwX1, dwY2, pclrFrame ) ;
-    _DBE_ILI9325_DrawLine( dwX2, dwY1, dwX2, dwY2, pclrFrame ) ;
+    LCDR_Rectangle( dwX1, dwY1, dwX2, dwY2, _DBE_ILI9325_FillBox, pclrFrame ) ;
 
     return SAMGUI_E_OK ;
 }
@@ -888,7 +853,11 @@ static uint32_t _DBE_ILI9325_DrawRectangle( uint32_t dwX1, uint32_t dwY1, uint32
 static uint32_t _DBE_ILI9325_DrawFilledRectangle( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2, SGUIColor* pclrFrame, SGUIColor* pclrInside )
 {
     uint32_t dw ;
-    uint32_t dwLength ;
+
+    if ( pclrInside == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
 
     // Check coordonates
     if ( dwX1 > dwX2 )
@@ -905,28 +874,7 @@ static uint32_t _DBE_ILI9325_DrawFilledRectangle( uint32_t dwX1, uint32_t dwY1,
         dwY2=dw ;
     }
 
-    _DBE_ILI9325_SetCursor( dwX1, dwY1 ) ;
-    _DBE_ILI9325_SetWindow( dwX1, dwY1, dwX2-dwX1+1, dwY2-dwY1+1 ) ;
-    _DBE_ILI9325_RAMAccess_Prepare() ;
-
-    dwLength=(dwX2-dwX1+1)*(dwY2-dwY1+1) ;
-    for ( dw=0 ; dw < dwLength ; dw++ )
-    {
-//            _DBE_ILI9325_WriteRAM( pclrInside->u.dwRGBA ) ;
-#ifdef ILI9325_BGR_MODE
-        ILI9325_D=(pclrInside->u.dwRGBA & 0xff) ;
-        ILI9325_D=((pclrInside->u.dwRGBA >> 8) & 0xff) ;
-        ILI9325_D=((pclrInside->u.dwRGBA >> 16) & 0xff) ;
-#endif // ILI9325_BGR_MODE
-
-#ifdef ILI9325_RGB_MODE
-        ILI9325_D=((pclrInside->u.dwRGBA >> 16) & 0xff) ;
-        ILI9325_D=((pclrInside->u.dwRGBA >> 8) & 0xff) ;
-        ILI9325_D=(pclrInside->u.dwRGBA & 0xff) ;
-#endif // ILI9325_RGB_MODE
-    }
-
-    _DBE_ILI9325_SetWindow( 0, 0, BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT ) ;
+    _DBE_ILI9325_FillBox( pclrInside, dwX1, dwY1, dwX2-dwX1+1, dwY2-dwY1+1 ) ;
 
     return SAMGUI_E_OK ;
 }
@@ -947,6 +895,10 @@ static uint32_t _DBE_ILI9325_DrawBitmapBMP( uint32_t dwX, uint32_t dwY, uint32_t
     uint8_t* pucLine ;
     uint32_t dwScanLineBits ;
     uint32_t dwScanLineBytes ;
+    uint32_t dwCX1 ;
+    uint32_t dwCY1 ;
+    uint32_t dwCX2 ;
+    uint32_t dwCY2 ;
     SGUIColor clr={ .u.dwRGBA=0xff0000 } ;
 
     // Read header information
@@ -985,17 +937,27 @@ static uint32_t _DBE_ILI9325_DrawBitmapBMP( uint32_t dwX, uint32_t dwY, uint32_t
     {
         case 24:
 //            _DBE_ILI9325_WriteReg(ILI9325_R03H, _DBE_ILI9325_ReadReg( ILI9325_R03H )~(1<<12) ); /* set GRAM write direction and BGR=1. */
-            _DBE_ILI9325_SetCursor( dwX, dwY ) ;
-            _DBE_ILI9325_SetWindow( dwX, dwY, dwWidth, dwHeight ) ;
+            // Only send the part inside the clipping rectangle
+            dwCX1=dwX ;
+            dwCY1=dwY ;
+            dwCX2=dwX+dwMinWidth-1 ;
+            dwCY2=dwY+dwMinHeight-1 ;
+            if ( !_DBE_ILI9325_ClipBox( &dwCX1, &dwCY1, &dwCX2, &dwCY2 ) )
+            {
+                break ;
+            }
+
+            _DBE_ILI9325_SetCursor( dwCX1, dwCY1 ) ;
+            _DBE_ILI9325_SetWindow( dwCX1, dwCY1, dwCX2-dwCX1+1, dwCY2-dwCY1+1 ) ;
             _DBE_ILI9325_RAMAccess_Prepare() ;
 
             // Send image data to ILI9325 (swapping red & blue)
-            for ( dwRow=0 ; dwRow < dwMinHeight ; dwRow++ )
+            for ( dwRow=dwCY1-dwY ; dwRow <= dwCY2-dwY ; dwRow++ )
             {
-                pucLine=pucImage+((dwHeight-dwRow-1)*dwScanLineBytes) ;
+                pucLine=pucImage+((dwHeight-dwRow-1)*dwScanLineBytes)+(dwCX1-dwX)*3 ;
 //                printf( "_DBE_ILI9325_DrawBitmapBMP - Line %u/%u\n\r", dwRow, ((dwHeight-dwRow-1)*(dwWidth*3)) ) ;
 
-                for ( dwCol=0 ; dwCol < dwMinWidth ; dwCol++ )
+                for ( dwCol=dwCX1 ; dwCol <= dwCX2 ; dwCol++ )
                 {
     #ifdef ILI9325_BGR_MODE
                     ILI9325_D=(*pucLine/*<<2*/)++ ;
@@ -1060,204 +1022,49 @@ static uint32_t _DBE_ILI9325_DrawBitmapBMP( uint32_t dwX, uint32_t dwY, uint32_t
     return SAMGUI_E_OK ;
 }
 
-static uint32_t _DBE_ILI9325_DrawBitmapBMPFile( uint32_t dwX, uint32_t dwY, uint32_t dwWidth, uint32_t dwHeight, uint8_t* pucData )
+/**
+ * \brief Read function of the BMP file decoder.
+ *
+ * \param pContext  Opened FatFs file.
+ */
+static uint32_t _DBE_ILI9325_FileRead( void* pContext, uint8_t* pBuffer, uint32_t dwSize )
 {
-    uint32_t dwMin ;
-    FIL fp ;
-    SBMPHeader sHeader ;
-    uint32_t dwLineLength ;
-    uint32_t dwLength ;
-    uint32_t dwTemp ;
-    uint32_t dwIndex ;
-    uint32_t dw ;
-    uint8_t* pucLineData ;
+    uint32_t dwLength=0 ;
 
-    // Read first 256 bytes to obtain header
-    if ( f_open( &fp, (const char*)pucData, FA_OPEN_EXISTING|FA_READ ) == FR_OK )
+    if ( f_read( (FIL*)pContext, pBuffer, dwSize, &dwLength ) != FR_OK )
     {
-        if ( f_read( &fp, &sHeader, sizeof( sHeader ), &dwLength ) == FR_OK )
-        {
-//            printf( "read %c%c\r\n", (char)(sHeader.wType&0xff), (char)(sHeader.wType>>8) ) ;
-//            printf( " -> .dwCompression = %u\n\r", sHeader.dwCompression ) ;
-//            printf( " -> .dwWidth = %u\n\r", sHeader.dwWidth ) ;
-//            printf( " -> .dwHeight = %u\n\r", sHeader.dwHeight ) ;
-//            printf( " -> .wBits = %u\n\r", sHeader.wBits ) ;
-//            printf( " -> .dwOffset %u\r\n", sHeader.dwOffset ) ;
-//            printf( " -> .dwColours %u\r\n", sHeader.dwColours ) ;
-//            printf( " -> .dw %u\r\n", sHeader.dwColours*4+54 ) ;
-
-            dwLineLength=(((sHeader.dwWidth*sHeader.wBits)+31)/32)*4 ;
-
-            switch ( sHeader.wBits )
-            {
-                case 24:
-                    // if header is Windows BMP 24bpp, alloc line size bytes on HEAP
-                    // Move file pointer to begin of BMP data
-//                    f_lseek( &fp, sHeader.dwOffset ) ;
-
-//                    dwX2=dwX ;
-//                    dwY+=sHeader.height ;
-
-                    /* set GRAM write direction and BGR=1. */
-                    _DBE_ILI9325_WriteReg( TS_INS_ENTRY_MOD, 0xc010 ) ;
-                    /* Set window */
-                    _DBE_ILI9325_SetWindow( dwX, dwY, dwWidth, dwHeight ) ;
-//                _DBE_ILI9325_SetCursor( dwX, dwY ) ; //+dwHeight-1 ) ;
-                    _DBE_ILI9325_SetCursor( dwX, dwY+dwHeight-1 ) ;
-
-
-    ////                dwX2=_DBE_ILI9325_ReadReg( ILI9325_R03H ) ;
-    //////                dwX2|=(1<<5) ; // I/D1=1
-    ////                dwX2&=~(1<<3) ; // I/D1=0
-    //////                dwX2&=~(1<<3) ; // AM=0
-    //////                dwX2|=(1<<3) ; // AM=1
-    ////                _DBE_ILI9325_WriteReg( ILI9325_R03H, (uint16_t)dwX2 ) ;
-
-                    ILI9325_IR=0 ;
-                    ILI9325_IR=TS_INS_RW_GRAM ;
-
-                    // Read buffer and write it on backend
-                    dwIndex=0 ;
-                    do
-                    {
-                        if ( f_read( &fp, _DBE_ILI9325_aucFileData, sizeof( _DBE_ILI9325_aucFileData ), &dwLength ) == FR_OK )
-                        {
-//                            printf( "Read %u bytes\r\n", dwLength ) ;
-                            // Get Min value from read length and buffer length
-//                            dwMin=(dwLength < sizeof( _DBE_ILI9325_aucFileData ) )?dwLength:sizeof( _DBE_ILI9325_aucFileData ) ;
-
-//                            printf( "writing %u bytes\r\n", dwMin ) ;
-                            // Draw whole buffer data to backend
-                            dwMin=dwWidth*3 ;
-                            if ( dwLineLength != dwMin )
-                            {
-                                for ( dwTemp=0 ; dwTemp < dwLength ; dwTemp++, dwIndex++ )
-                                {
-                                    if ( (dwIndex >= dwMin) && (dwIndex < dwLineLength) )
-                                    {
-                                    }
-                                    else
-                                    {
-                                        if ( dwIndex == dwLineLength )
-                                        {
-                                            dwIndex=0 ;
-                                        }
-                                        ILI9325_D=_DBE_ILI9325_aucFileData[dwTemp] ;
-                                    }
-                                }
-                            }
-                            else
-                            {
-                                for ( dwTemp=0 ; dwTemp < dwLength ; dwTemp++ )
-                                {
-                                    ILI9325_D=_DBE_ILI9325_aucFileData[dwTemp] ;
-                                }
-                            }
-                        }
-                    } while ( dwLength == sizeof( _DBE_ILI9325_aucFileData ) ) ;
-
-#if defined ILI9325_RGB_MODE
-                    _DBE_ILI9325_SetRGBMode() ;
-#endif // defined ILI9325_RGB_MODE
-#if defined ILI9325_BGR_MODE
-                    _DBE_ILI9325_SetBGRMode() ;
-#endif // defined ILI9325_BGR_MODE
-                    // Restore whole window
-                    _DBE_ILI9325_SetWindow( 0, 0, BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT ) ;
-                break ;
+        return 0 ;
+    }
 
-                case 8:
-                    // Move file pointer to begin of BMP data
-//                    f_lseek( &fp, 54 ) ;
-
-                    // Get LUT
-                    if ( f_read( &fp, _DBE_ILI9325_aucFileData, sHeader.dwColours<<2, &dwLength ) == FR_OK )
-                    {
-//                        printf( "Read %u bytes\r\n", dwLength ) ;
-                    }
-
-//                    f_lseek( &fp, sHeader.dwOffset ) ;
-
-                    /* set GRAM write direction and BGR=1. */
-                    _DBE_ILI9325_WriteReg( TS_INS_ENTRY_MOD, 0xc010 ) ;
-                    /* Set window */
-                    _DBE_ILI9325_SetWindow( dwX, dwY, dwWidth, dwHeight ) ;
-                    /* Set cursor */
-                    _DBE_ILI9325_SetCursor( dwX, dwY+dwHeight-1 ) ;
-                    ILI9325_IR=0 ;
-                    ILI9325_IR=TS_INS_RW_GRAM ;
-
-                    // Read buffer and write it on backend
-                    dwIndex=0 ;
-                    pucLineData=_DBE_ILI9325_aucFileData+1024/*(sHeader.dwColours<<2)*/ ;
-                    do
-                    {
-                        if ( f_read( &fp, pucLineData, sizeof( _DBE_ILI9325_aucFileData )-1024/*sHeader.dwColours<<2*/, &dwLength ) == FR_OK )
-                        {
-                            // Draw whole buffer data to backend
-                            dwMin=dwWidth/**3*/ ;
-                            if ( dwLineLength != dwMin )
-                            {
-                                for ( dwTemp=0 ; dwTemp < dwLength ; dwTemp++, dwIndex++ )
-                                {
-                                    if ( (dwIndex >= dwMin) && (dwIndex < dwLineLength) )
-                                    {
-                                    }
-                                    else
-                                    {
-                                        if ( dwIndex == dwLineLength )
-                                        {
-                                            dwIndex=0 ;
-                                        }
-                                        /* Get value */
-                                        dw=pucLineData[dwTemp]<<2 ;
-                                        /* Draw pixel */
-                                        ILI9325_D=_DBE_ILI9325_aucFileData[dw] ;
-                                        ILI9325_D=_DBE_ILI9325_aucFileData[dw+1] ;
-                                        ILI9325_D=_DBE_ILI9325_aucFileData[dw+2] ;
-                                    }
-                                }
-                            }
-                            else
-                            {
-                                for ( dwTemp=0 ; dwTemp < dwLength ; dwTemp++ )
-                                {
-                                    /* Get value */
-                                    dw=pucLineData[dwTemp]<<2 ;
-                                    /* Draw pixel */
-                                    ILI9325_D=_DBE_ILI9325_aucFileData[dw] ;
-                                    ILI9325_D=_DBE_ILI9325_aucFileData[dw+1] ;
-                                    ILI9325_D=_DBE_ILI9325_aucFileData[dw+2] ;
-                                }
-                            }
-                        }
-                    } while ( dwLength == sizeof( _DBE_ILI9325_aucFileData )-1024/*(sHeader.dwColours<<2)*/ ) ;
+    return dwLength ;
+}
 
+/**
+ * \brief Draw a BMP file, decoded one row at a time while it is read.
+ *
+ * Bottom-up files are sent in file order, the GRAM vertical address being
+ * decremented. Only the part inside the clipping rectangle is sent.
+ */
+static uint32_t _DBE_ILI9325_DrawBitmapBMPFile( uint32_t dwX, uint32_t dwY, uint32_t dwWidth, uint32_t dwHeight, uint8_t* pucData )
+{
+    FIL fp ;
+    BMPStream* pStream=&_DBE_ILI9325_sBMPStream ;
+    uint8_t* pucRow=(uint8_t*)_DBE_ILI9325_adwRowData ;
+    uint8_t* pucPixel ;
+    uint32_t dwCX1 ;
+    uint32_t dwCY1 ;
+    uint32_t dwCX2 ;
+    uint32_t dwCY2 ;
+    uint32_t dwRowY ;
+    uint32_t dwCol ;
 #if defined ILI9325_RGB_MODE
-                    _DBE_ILI9325_SetRGBMode() ;
+    uint8_t ucOrder=BMP_ORDER_RGB ;
 #endif // defined ILI9325_RGB_MODE
 #if defined ILI9325_BGR_MODE
-                    _DBE_ILI9325_SetBGRMode() ;
+    uint8_t ucOrder=BMP_ORDER_BGR ;
 #endif // defined ILI9325_BGR_MODE
-                    // Restore whole window
-                    _DBE_ILI9325_SetWindow( 0, 0, BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT ) ;
-                break ;
 
-                default:
-                    printf( "failed to read\r\n" ) ;
-                break ;
-            }
-        }
-        else // failed read
-        {
-            printf( "failed to read\r\n" ) ;
-        }
-
-        f_close( &fp ) ;
-
-        return SAMGUI_E_OK ;
-    }
-    else
+    if ( f_open( &fp, (const char*)pucData, FA_OPEN_EXISTING|FA_READ ) != FR_OK )
     {
         SGUIColor clr={ .u.dwRGBA=0xff0000 } ;
 
@@ -1268,19 +1075,114 @@ static uint32_t _DBE_ILI9325_DrawBitmapBMPFile( uint32_t dwX, uint32_t dwY, uint
 
         _DBE_ILI9325_DrawLine( dwX, dwY, dwX+dwWidth-1, dwY+dwHeight-1, &clr ) ;
         _DBE_ILI9325_DrawLine( dwX, dwY+dwHeight-1, dwX+dwWidth-1, dwY, &clr ) ;
+
+        return SAMGUI_E_FILE_OPEN ;
+    }
+
+    if ( (BMP_StreamOpen( pStream, _DBE_ILI9325_FileRead, &fp, _DBE_ILI9325_aucFileData, sizeof( _DBE_ILI9325_aucFileData ), ucOrder ) != 0) ||
+         (pStream->header.width*3 > sizeof( _DBE_ILI9325_adwRowData )) )
+    {
+        printf( "failed to read\r\n" ) ;
+        f_close( &fp ) ;
+
+        return SAMGUI_E_OK ;
+    }
+
+    // Visible part of the image
+    if ( dwWidth > pStream->header.width )
+    {
+        dwWidth=pStream->header.width ;
+    }
+
+    if ( dwHeight > pStream->dwHeight )
+    {
+        dwHeight=pStream->dwHeight ;
+    }
+
+    dwCX1=dwX ;
+    dwCY1=dwY ;
+    dwCX2=dwX+dwWidth-1 ;
+    dwCY2=dwY+dwHeight-1 ;
+
+    if ( (dwWidth != 0) && (dwHeight != 0) && _DBE_ILI9325_ClipBox( &dwCX1, &dwCY1, &dwCX2, &dwCY2 ) )
+    {
+        _DBE_ILI9325_SetWindow( dwCX1, dwCY1, dwCX2-dwCX1+1, dwCY2-dwCY1+1 ) ;
+
+        if ( pStream->ucTopDown )
+        {
+            _DBE_ILI9325_SetCursor( dwCX1, dwCY1 ) ;
+        }
+        else
+        {
+            /* set GRAM write direction with vertical address decrement. */
+#if defined ILI9325_RGB_MODE
+            _DBE_ILI9325_WriteReg( TS_INS_ENTRY_MOD, 0xd010 ) ;
+#endif // defined ILI9325_RGB_MODE
+#if defined ILI9325_BGR_MODE
+            _DBE_ILI9325_WriteReg( TS_INS_ENTRY_MOD, 0xc010 ) ;
+#endif // defined ILI9325_BGR_MODE
+            _DBE_ILI9325_SetCursor( dwCX1, dwCY2 ) ;
+        }
+        _DBE_ILI9325_RAMAccess_Prepare() ;
+
+        while ( BMP_StreamReadRow( pStream, pucRow, &dwRowY ) == 0 )
+        {
+            if ( (dwY+dwRowY < dwCY1) || (dwY+dwRowY > dwCY2) )
+            {
+                // Stop once the last visible row has been sent
+                if ( (pStream->ucTopDown) ? (dwY+dwRowY > dwCY2) : (dwY+dwRowY < dwCY1) )
+                {
+                    break ;
+                }
+                continue ;
+            }
+
+            pucPixel=pucRow+(dwCX1-dwX)*3 ;
+            for ( dwCol=dwCX1 ; dwCol <= dwCX2 ; dwCol++ )
+            {
+                ILI9325_D=*pucPixel++ ;
+                ILI9325_D=*pucPixel++ ;
+                ILI9325_D=*pucPixel++ ;
+            }
+        }
+
+#if defined ILI9325_RGB_MODE
+        _DBE_ILI9325_SetRGBMode() ;
+#endif // defined ILI9325_RGB_MODE
+#if defined ILI9325_BGR_MODE
+        _DBE_ILI9325_SetBGRMode() ;
+#endif // defined ILI9325_BGR_MODE
+        // Restore whole window
+        _DBE_ILI9325_SetWindow( 0, 0, BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT ) ;
     }
 
-    return SAMGUI_E_FILE_OPEN ;
+    f_close( &fp ) ;
+
+    return SAMGUI_E_OK ;
 }
 
 static uint32_t _DBE_ILI9325_DrawBitmap( uint32_t dwX, uint32_t dwY, uint32_t dwWidth, uint32_t dwHeight, uint8_t* pucData )
 {
     uint32_t dwCol ;
-//#ifdef ILI9325_BGR_MODE
-//    uint8_t ucB ;
-//    uint8_t ucG ;
-//    uint8_t ucR ;
-//#endif // ILI9325_BGR_MODE
+    uint32_t dwRow ;
+    uint32_t dwCX1 ;
+    uint32_t dwCY1 ;
+    uint32_t dwCX2 ;
+    uint32_t dwCY2 ;
+    uint8_t* pucLine ;
+#ifdef ILI9325_BGR_MODE
+    uint8_t ucB ;
+    uint8_t ucG ;
+    uint8_t ucR ;
+#endif // ILI9325_BGR_MODE
+
+    // Nothing to draw outside of the clipping rectangle
+    if ( (dwWidth == 0) || (dwHeight == 0) ||
+         (dwX > _DBE_ILI9325_dwClipX2) || (dwX+dwWidth <= _DBE_ILI9325_dwClipX1) ||
+         (dwY > _DBE_ILI9325_dwClipY2) || (dwY+dwHeight <= _DBE_ILI9325_dwClipY1) )
+    {
+        return SAMGUI_E_OK ;
+    }
 
     // Check if bitmap is Microsoft BMP
     if ( (pucData[0] == 'B') && (pucData[1] == 'M') )
@@ -1293,9 +1195,15 @@ static uint32_t _DBE_ILI9325_DrawBitmap( uint32_t dwX, uint32_t dwY, uint32_t dw
         return _DBE_ILI9325_DrawBitmapBMPFile( dwX, dwY, dwWidth, dwHeight, pucData ) ;
     }
 
-    // Draw raw RGB bitmap
-    _DBE_ILI9325_SetWindow( dwX, dwY, dwWidth, dwHeight ) ;
-    _DBE_ILI9325_SetCursor( dwX, dwY ) ;
+    // Draw raw RGB bitmap, limited to the clipping rectangle
+    dwCX1=dwX ;
+    dwCY1=dwY ;
+    dwCX2=dwX+dwWidth-1 ;
+    dwCY2=dwY+dwHeight-1 ;
+    _DBE_ILI9325_ClipBox( &dwCX1, &dwCY1, &dwCX2, &dwCY2 ) ;
+
+    _DBE_ILI9325_SetWindow( dwCX1, dwCY1, dwCX2-dwCX1+1, dwCY2-dwCY1+1 ) ;
+    _DBE_ILI9325_SetCursor( dwCX1, dwCY1 ) ;
 
     ILI9325_IR=0 ;
     ILI9325_IR=TS_INS_RW_GRAM ;
@@ -1308,22 +1216,27 @@ static uint32_t _DBE_ILI9325_DrawBitmap( uint32_t dwX, uint32_t dwY, uint32_t dw
 //    _DBE_ILI9325_SetBGRMode() ;
 #endif // ILI9325_RGB_MODE
 
-    for ( dwCol=0 ; dwCol < dwWidth*dwHeight ; dwCol++ )
+    for ( dwRow=dwCY1 ; dwRow <= dwCY2 ; dwRow++ )
     {
+        pucLine=pucData+(((dwRow-dwY)*dwWidth)+(dwCX1-dwX))*3 ;
+
+        for ( dwCol=dwCX1 ; dwCol <= dwCX2 ; dwCol++ )
+        {
 #ifdef ILI9325_BGR_MODE
-        ucB=((*pucData++)/*<<2*/) ;
-        ucG=((*pucData++)/*<<2*/) ;
-        ucR=((*pucData++)/*<<2*/) ;
-        ILI9325_D=ucR/*<<2*/ ;
-        ILI9325_D=ucG/*<<2*/ ;
-        ILI9325_D=ucB/*<<2*/ ;
+            ucB=((*pucLine++)/*<<2*/) ;
+            ucG=((*pucLine++)/*<<2*/) ;
+            ucR=((*pucLine++)/*<<2*/) ;
+            ILI9325_D=ucR/*<<2*/ ;
+            ILI9325_D=ucG/*<<2*/ ;
+            ILI9325_D=ucB/*<<2*/ ;
 #endif // ILI9325_BGR_MODE
 
 #ifdef ILI9325_RGB_MODE
-        ILI9325_D = ((*pucData++)/*<<2*/) ;
-        ILI9325_D = ((*pucData++)/*<<2*/) ;
-        ILI9325_D = ((*pucData++)/*<<2*/) ;
+            ILI9325_D = ((*pucLine++)/*<<2*/) ;
+            ILI9325_D = ((*pucLine++)/*<<2*/) ;
+            ILI9325_D = ((*pucLine++)/*<<2*/) ;
 #endif // ILI9325_RGB_MODE
+        }
     }
 
 #ifdef ILI9325_BGR_MODE
@@ -1334,37 +1247,151 @@ static uint32_t _DBE_ILI9325_DrawBitmap( uint32_t dwX, uint32_t dwY, uint32_t dw
 //    _DBE_ILI9325_SetRGBMode() ;
 #endif // ILI9325_RGB_MODE
 
-    _DBE_ILI9325_SetWindow( dwX, dwY, BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT ) ;
+    _DBE_ILI9325_SetWindow( 0, 0, BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT ) ;
 
     return SAMGUI_E_OK ;
 }
 
-static uint32_t _DBE_ILI9325_DrawChar( uint32_t dwX, uint32_t dwY, uint8_t ucChar, SGUIColor* pclrText, SGUIFont* pFont, uint32_t dwSize )
+/**
+ * \brief Draw a rectangle of pixels already in the GRAM format
+ * (DISP_PIXEL_FORMAT_RGB666_3B), limited to the clipping rectangle.
+ */
+static uint32_t _DBE_ILI9325_DrawNative( uint32_t dwX, uint32_t dwY, uint32_t dwWidth, uint32_t dwHeight, const uint8_t* pucPixels )
 {
+    const uint8_t* pucLine ;
+    uint32_t dwCX1 ;
+    uint32_t dwCY1 ;
+    uint32_t dwCX2 ;
+    uint32_t dwCY2 ;
     uint32_t dwRow ;
+    uint32_t dwBytes ;
+    uint32_t dw ;
+
+    if ( (dwWidth == 0) || (dwHeight == 0) )
+    {
+        return SAMGUI_E_OK ;
+    }
+
+    dwCX1=dwX ;
+    dwCY1=dwY ;
+    dwCX2=dwX+dwWidth-1 ;
+    dwCY2=dwY+dwHeight-1 ;
+    if ( !_DBE_ILI9325_ClipBox( &dwCX1, &dwCY1, &dwCX2, &dwCY2 ) )
+    {
+        return SAMGUI_E_OK ;
+    }
+
+    _DBE_ILI9325_SetWindow( dwCX1, dwCY1, dwCX2-dwCX1+1, dwCY2-dwCY1+1 ) ;
+    _DBE_ILI9325_SetCursor( dwCX1, dwCY1 ) ;
+    _DBE_ILI9325_RAMAccess_Prepare() ;
+
+    // One GRAM burst, the window wraps the rows
+    dwBytes=(dwCX2-dwCX1+1)*3 ;
+    for ( dwRow=dwCY1 ; dwRow <= dwCY2 ; dwRow++ )
+    {
+        pucLine=pucPixels+(((dwRow-dwY)*dwWidth)+(dwCX1-dwX))*3 ;
+
+        for ( dw=dwBytes ; dw != 0 ; dw-- )
+        {
+            ILI9325_D=*pucLine++ ;
+        }
+    }
+
+    _DBE_ILI9325_SetWindow( 0, 0, BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT ) ;
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * \brief Draw a character, each glyph column being written through a one
+ * pixel wide window with one GRAM burst per run of set pixels. The glyphs
+ * (0x20 to 0x7F) hold one 16-bit column per pixel of the font width, top row
+ * in the most significant bit, as aucFont10x14.
+ */
+static uint32_t _DBE_ILI9325_DrawChar( uint32_t dwX, uint32_t dwY, uint8_t ucChar, SGUIColor* pclrText, SGUIFont* pFont, uint32_t dwSize )
+{
+    const uint8_t* pucGlyph ;
     uint32_t dwCol ;
+    uint32_t dwRow ;
+    uint32_t dwStart ;
+    uint32_t dwEnd ;
+    uint32_t dwBits ;
+    uint8_t ucC1 ;
+    uint8_t ucC2 ;
+    uint8_t ucC3 ;
 
 //    assert( (ucChar >= 0x20) && (ucChar <= 0x7F) ) ;
 
-    for ( dwCol=0 ; dwCol < 10 ; dwCol++ )
+    if ( (dwX > _DBE_ILI9325_dwClipX2) || (dwX+pFont->dwWidth <= _DBE_ILI9325_dwClipX1) ||
+         (dwY > _DBE_ILI9325_dwClipY2) || (dwY+pFont->dwHeight <= _DBE_ILI9325_dwClipY1) ||
+         (ucChar < 0x20) || (ucChar > 0x7F) )
+    {
+        return SAMGUI_E_OK ;
+    }
+
+#ifdef ILI9325_RGB_MODE
+    ucC1=(pclrText->u.dwRGBA >> 16) & 0xff ;
+    ucC2=(pclrText->u.dwRGBA >> 8) & 0xff ;
+    ucC3=pclrText->u.dwRGBA & 0xff ;
+#endif // ILI9325_RGB_MODE
+
+#ifdef ILI9325_BGR_MODE
+    ucC1=pclrText->u.dwRGBA & 0xff ;
+    ucC2=(pclrText->u.dwRGBA >> 8) & 0xff ;
+    ucC3=(pclrText->u.dwRGBA >> 16) & 0xff ;
+#endif // ILI9325_BGR_MODE
+
+    pucGlyph=(const uint8_t*)pFont->pvData+(ucChar - 0x20)*pFont->dwWidth*2 ;
+
+    for ( dwCol=0 ; dwCol < pFont->dwWidth ; dwCol++ )
     {
-        for ( dwRow=0 ; dwRow < 8 ; dwRow++ )
+        if ( (dwX+dwCol < _DBE_ILI9325_dwClipX1) || (dwX+dwCol > _DBE_ILI9325_dwClipX2) )
         {
-            if ( (aucFont10x14[((ucChar - 0x20) * 20) + dwCol * 2] >> (7 - dwRow)) & 0x1)
-            {
-                _DBE_ILI9325_DrawPixel( dwX+dwCol, dwY+dwRow, pclrText ) ;
-            }
+            continue ;
+        }
+
+        // rows 0..7 in bits 15..8, rows 8..15 in bits 7..0
+        dwBits=(pucGlyph[dwCol * 2] << 8) | pucGlyph[dwCol * 2 + 1] ;
+        if ( dwBits == 0 )
+        {
+            continue ;
         }
 
-        for ( dwRow=0 ; dwRow < 6 ; dwRow++ )
+        _DBE_ILI9325_SetWindow( dwX+dwCol, dwY, 1, pFont->dwHeight ) ;
+
+        for ( dwRow=0 ; dwRow < pFont->dwHeight ; )
         {
-            if ( (aucFont10x14[((ucChar - 0x20) * 20) + dwCol * 2 + 1] >> (7 - dwRow)) & 0x1)
+            if ( ((dwBits >> (15 - dwRow)) & 0x1) == 0 )
+            {
+                dwRow++ ;
+                continue ;
+            }
+
+            for ( dwStart=dwRow ; (dwRow < pFont->dwHeight) && ((dwBits >> (15 - dwRow)) & 0x1) ; dwRow++ ) ;
+
+            // Clip the run vertically
+            dwEnd=dwY+dwRow-1 ;
+            dwStart+=dwY ;
+            if ( dwStart < _DBE_ILI9325_dwClipY1 ) dwStart=_DBE_ILI9325_dwClipY1 ;
+            if ( dwEnd > _DBE_ILI9325_dwClipY2 ) dwEnd=_DBE_ILI9325_dwClipY2 ;
+            if ( dwStart > dwEnd )
             {
-                _DBE_ILI9325_DrawPixel( dwX+dwCol, dwY+dwRow+8, pclrText ) ;
+                continue ;
+            }
+
+            _DBE_ILI9325_SetCursor( dwX+dwCol, dwStart ) ;
+            _DBE_ILI9325_RAMAccess_Prepare() ;
+            for ( ; dwStart <= dwEnd ; dwStart++ )
+            {
+                ILI9325_D=ucC1 ;
+                ILI9325_D=ucC2 ;
+                ILI9325_D=ucC3 ;
             }
         }
     }
 
+    _DBE_ILI9325_SetWindow( 0, 0, BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT ) ;
+
     return SAMGUI_E_OK ;
 }
 
@@ -1405,6 +1432,17 @@ static uint32_t _DBE_ILI9325_IOCtl( uint32_t dwCommand, uint32_t* pdwValue, uint
 
     switch ( dwCommand )
     {
+        case DISP_BACKEND_IOCTL_SET_SCROLL_AREA :
+            if ( (pdwValue == NULL) || (pdwValueLength == NULL) || (*pdwValueLength != 2*sizeof( uint32_t )) )
+            {
+                return SAMGUI_E_BAD_PARAMETER ;
+            }
+        return _DBE_ILI9325_SetScrollArea( pdwValue[0], pdwValue[1] ) ;
+
+        case DISP_BACKEND_IOCTL_SET_SCROLL_OFFSET :
+            _DBE_ILI9325_SetScrollOffset( (uint32_t)pdwValue ) ;
+        break ;
+
         case DISP_BACKEND_IOCTL_POWER_ON :
             _DBE_ILI9325_LCD_On() ;
         break ;
@@ -1425,6 +1463,18 @@ static uint32_t _DBE_ILI9325_IOCtl( uint32_t dwCommand, uint32_t* pdwValue, uint
             _DBE_ILI9325_SetOrientation( DISP_BACKEND_IOCTL_SET_MODE_LANDSCAPE ) ;
         break ;
 
+        case DISP_BACKEND_IOCTL_FLUSH :
+            // Drawing goes straight to the GRAM
+        break ;
+
+        case DISP_BACKEND_IOCTL_GET_PIXEL_FORMAT :
+            if ( pdwValue == NULL )
+            {
+                return SAMGUI_E_BAD_POINTER ;
+            }
+            *pdwValue=DISP_PIXEL_FORMAT_RGB666_3B ;
+        break ;
+
         default :
             printf( "_DBE_ILI9325_IOCtl - Bad IOCtl index (%x)\r\n", dwCommand ) ;
         break ;
@@ -1455,5 +1505,7 @@ SDISPBackend sDISP_Backend_ILI9325=
     .DrawBitmap=_DBE_ILI9325_DrawBitmap,
     .DrawText=_DBE_ILI9325_DrawText,
     .Fill=NULL,
-    .IOCtl=_DBE_ILI9325_IOCtl
+    .IOCtl=_DBE_ILI9325_IOCtl,
+    .SetClipRect=_DBE_ILI9325_SetClipRect,
+    .DrawNative=_DBE_ILI9325_DrawNative
 } ;
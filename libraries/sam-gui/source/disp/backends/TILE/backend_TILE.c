@@ -0,0 +1,723 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ * \section Purpose
+ *   Tiled off-screen rendering backend.
+ *
+ * \section Usage
+ * The drawing primitives are recorded in a display list. On DBE_TILE_Flush()
+ * (DISP_BACKEND_IOCTL_FLUSH, clipping change or full list) every area painted
+ * by an opaque primitive (filled rectangle, raw bitmap) is rendered strip by
+ * strip in a RAM buffer through the frame buffer driver, each strip holding as
+ * many lines of the area as the buffer allows, then written to the panel in
+ * one windowed burst. Pixels hidden by a later primitive are never sent.
+ *
+ * The buffer can be in SRAM or in an external PSRAM on the SMC. Bitmaps and
+ * texts are referenced, not copied: they must stay valid until the flush.
+ * Primitives outside of any opaque area, BMP images and files and native
+ * pixels (DrawNative) are drawn directly by the target backend.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+#include "board.h"
+#include "libsam_gui.h"
+
+#include <stdio.h>
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+typedef enum _DBE_TILE_Command
+{
+    DBE_TILE_CMD_PIXEL,
+    DBE_TILE_CMD_LINE,
+    DBE_TILE_CMD_CIRCLE,
+    DBE_TILE_CMD_FILLED_CIRCLE,
+    DBE_TILE_CMD_RECTANGLE,
+    DBE_TILE_CMD_FILLED_RECTANGLE,
+    DBE_TILE_CMD_BITMAP,
+    DBE_TILE_CMD_TEXT
+} DBE_TILE_Command ;
+
+typedef struct _SDBETileCommand
+{
+    DBE_TILE_Command dwType ;
+    uint32_t adwParam[4] ; // primitive parameters
+    SWGTRect sBox ; // screen area covered by the primitive
+    uint32_t dwColor ; // border, line or text color
+    uint32_t dwColorInside ; // fill color
+    uint32_t dwHasColor ; // 0 when the border color was not given
+    const void* pvData ; // bitmap or text
+    SGUIFont* pFont ;
+} SDBETileCommand ;
+
+/*----------------------------------------------------------------------------
+ *        Statics
+ *----------------------------------------------------------------------------*/
+
+static SDISPBackend* _DBE_TILE_pTarget=NULL ;
+static LcdColor_t* _DBE_TILE_pBuffer=NULL ;
+static uint32_t _DBE_TILE_dwPixels=0 ;
+static DBE_TILE_FlushCallback _DBE_TILE_Flush=NULL ;
+
+static SDBETileCommand _DBE_TILE_asCommands[DBE_TILE_MAX_COMMANDS] ;
+static uint32_t _DBE_TILE_dwCommands=0 ;
+
+static SWGTRect _DBE_TILE_sClip={ 0, 0, BOARD_LCD_WIDTH-1, BOARD_LCD_HEIGHT-1 } ;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _DBE_TILE_Contains( const SWGTRect* pOuter, const SWGTRect* pInner )
+{
+    return (pInner->dwX1 >= pOuter->dwX1) && (pInner->dwX2 <= pOuter->dwX2) &&
+           (pInner->dwY1 >= pOuter->dwY1) && (pInner->dwY2 <= pOuter->dwY2) ;
+}
+
+static uint32_t _DBE_TILE_Intersects( const SWGTRect* pRect1, const SWGTRect* pRect2 )
+{
+    return (pRect1->dwX1 <= pRect2->dwX2) && (pRect2->dwX1 <= pRect1->dwX2) &&
+           (pRect1->dwY1 <= pRect2->dwY2) && (pRect2->dwY1 <= pRect1->dwY2) ;
+}
+
+static uint32_t _DBE_TILE_IsOpaque( const SDBETileCommand* pCmd )
+{
+    return (pCmd->dwType == DBE_TILE_CMD_FILLED_RECTANGLE) || (pCmd->dwType == DBE_TILE_CMD_BITMAP) ;
+}
+
+/**
+ * \brief Get a new display list entry covering a box, the box being limited to
+ * the screen and to the clipping rectangle.
+ *
+ * \return NULL if the box is not visible.
+ */
+static SDBETileCommand* _DBE_TILE_Record( DBE_TILE_Command dwType, int32_t iX1, int32_t iY1, int32_t iX2, int32_t iY2 )
+{
+    SDBETileCommand* pCmd ;
+    int32_t i ;
+
+    if ( iX1 > iX2 ) { i=iX1 ; iX1=iX2 ; iX2=i ; }
+    if ( iY1 > iY2 ) { i=iY1 ; iY1=iY2 ; iY2=i ; }
+
+    if ( iX1 < (int32_t)_DBE_TILE_sClip.dwX1 ) iX1=_DBE_TILE_sClip.dwX1 ;
+    if ( iY1 < (int32_t)_DBE_TILE_sClip.dwY1 ) iY1=_DBE_TILE_sClip.dwY1 ;
+    if ( iX2 > (int32_t)_DBE_TILE_sClip.dwX2 ) iX2=_DBE_TILE_sClip.dwX2 ;
+    if ( iY2 > (int32_t)_DBE_TILE_sClip.dwY2 ) iY2=_DBE_TILE_sClip.dwY2 ;
+
+    if ( (iX1 > iX2) || (iY1 > iY2) )
+    {
+        return NULL ;
+    }
+
+    if ( _DBE_TILE_dwCommands == DBE_TILE_MAX_COMMANDS )
+    {
+        DBE_TILE_Flush() ;
+    }
+
+    pCmd=&_DBE_TILE_asCommands[_DBE_TILE_dwCommands++] ;
+    pCmd->dwType=dwType ;
+    pCmd->sBox.dwX1=iX1 ;
+    pCmd->sBox.dwY1=iY1 ;
+    pCmd->sBox.dwX2=iX2 ;
+    pCmd->sBox.dwY2=iY2 ;
+    pCmd->dwHasColor=1 ;
+    pCmd->pvData=NULL ;
+    pCmd->pFont=NULL ;
+
+    return pCmd ;
+}
+
+/**
+ * \brief Draw a text with the frame buffer driver, or with the target backend.
+ */
+static void _DBE_TILE_RenderText( const SDBETileCommand* pCmd, SDISPBackend* pBE )
+{
+    const char* pszText=(const char*)pCmd->pvData ;
+    uint32_t dwX=pCmd->adwParam[0] ;
+    uint32_t dwY=pCmd->adwParam[1] ;
+    uint32_t dwCol ;
+    uint32_t dwRow ;
+    uint32_t dwBits ;
+    const uint8_t* pucGlyph ;
+    SGUIColor clr={ .u.dwRGBA=pCmd->dwColor } ;
+
+    if ( pBE != NULL )
+    {
+        pBE->DrawText( dwX, dwY, (char*)pszText, &clr, pCmd->pFont, pCmd->adwParam[2] ) ;
+        return ;
+    }
+
+    FB_SetColor( pCmd->dwColor ) ;
+    for ( ; *pszText != 0 ; pszText++ )
+    {
+        if ( *pszText == '\n' )
+        {
+            dwY+=pCmd->pFont->dwHeight+2 ;
+            dwX=pCmd->adwParam[0] ;
+            continue ;
+        }
+
+        // Same glyph layout as the panel backends: one 16-bit column per pixel
+        if ( ((uint8_t)*pszText >= 0x20) && ((uint8_t)*pszText <= 0x7F) )
+        {
+            pucGlyph=(const uint8_t*)pCmd->pFont->pvData+(*pszText - 0x20)*pCmd->pFont->dwWidth*2 ;
+            for ( dwCol=0 ; dwCol < pCmd->pFont->dwWidth ; dwCol++ )
+            {
+                dwBits=(pucGlyph[dwCol * 2] << 8) | pucGlyph[dwCol * 2 + 1] ;
+                for ( dwRow=0 ; dwRow < pCmd->pFont->dwHeight ; dwRow++ )
+                {
+                    if ( (dwBits >> (15 - dwRow)) & 0x1 )
+                    {
+                        FB_DrawPixel( dwX+dwCol, dwY+dwRow ) ;
+                    }
+                }
+            }
+        }
+        dwX+=pCmd->pFont->dwWidth+2 ;
+    }
+}
+
+/**
+ * \brief Render a display list entry in the current frame buffer.
+ */
+static void _DBE_TILE_Render( const SDBETileCommand* pCmd )
+{
+    const uint32_t* pdw=pCmd->adwParam ;
+
+    FB_SetColor( pCmd->dwColor ) ;
+
+    switch ( pCmd->dwType )
+    {
+        case DBE_TILE_CMD_PIXEL :
+            FB_DrawPixel( pdw[0], pdw[1] ) ;
+        break ;
+
+        case DBE_TILE_CMD_LINE :
+            FB_DrawLine( pdw[0], pdw[1], pdw[2], pdw[3] ) ;
+        break ;
+
+        case DBE_TILE_CMD_CIRCLE :
+            FB_DrawCircle( pdw[0], pdw[1], pdw[2] ) ;
+        break ;
+
+        case DBE_TILE_CMD_FILLED_CIRCLE :
+            FB_SetColor( pCmd->dwColorInside ) ;
+            FB_DrawFilledCircle( pdw[0], pdw[1], pdw[2] ) ;
+            if ( pCmd->dwHasColor )
+            {
+                FB_SetColor( pCmd->dwColor ) ;
+                FB_DrawCircle( pdw[0], pdw[1], pdw[2] ) ;
+            }
+        break ;
+
+        case DBE_TILE_CMD_RECTANGLE :
+            FB_DrawRectangle( pdw[0], pdw[1], pdw[2], pdw[3] ) ;
+        break ;
+
+        case DBE_TILE_CMD_FILLED_RECTANGLE :
+            FB_SetColor( pCmd->dwColorInside ) ;
+            FB_DrawFilledRectangle( pdw[0], pdw[1], pdw[2], pdw[3] ) ;
+            if ( pCmd->dwHasColor )
+            {
+                FB_SetColor( pCmd->dwColor ) ;
+                FB_DrawRectangle( pdw[0], pdw[1], pdw[2], pdw[3] ) ;
+            }
+        break ;
+
+        case DBE_TILE_CMD_BITMAP :
+            FB_DrawImage( pdw[0], pdw[1], pdw[2], pdw[3], (const uint8_t*)pCmd->pvData ) ;
+        break ;
+
+        case DBE_TILE_CMD_TEXT :
+            _DBE_TILE_RenderText( pCmd, NULL ) ;
+        break ;
+    }
+}
+
+/**
+ * \brief Draw a display list entry with the target backend.
+ */
+static void _DBE_TILE_RenderDirect( const SDBETileCommand* pCmd )
+{
+    const uint32_t* pdw=pCmd->adwParam ;
+    SGUIColor clr={ .u.dwRGBA=pCmd->dwColor } ;
+    SGUIColor clrInside={ .u.dwRGBA=pCmd->dwColorInside } ;
+
+    switch ( pCmd->dwType )
+    {
+        case DBE_TILE_CMD_PIXEL :
+            _DBE_TILE_pTarget->DrawPixel( pdw[0], pdw[1], &clr ) ;
+        break ;
+
+        case DBE_TILE_CMD_LINE :
+            _DBE_TILE_pTarget->DrawLine( pdw[0], pdw[1], pdw[2], pdw[3], &clr ) ;
+        break ;
+
+        case DBE_TILE_CMD_CIRCLE :
+            _DBE_TILE_pTarget->DrawCircle( pdw[0], pdw[1], pdw[2], &clr ) ;
+        break ;
+
+        case DBE_TILE_CMD_FILLED_CIRCLE :
+            _DBE_TILE_pTarget->DrawFilledCircle( pdw[0], pdw[1], pdw[2], pCmd->dwHasColor ? &clr : NULL, &clrInside ) ;
+        break ;
+
+        case DBE_TILE_CMD_RECTANGLE :
+            _DBE_TILE_pTarget->DrawRectangle( pdw[0], pdw[1], pdw[2], pdw[3], &clr ) ;
+        break ;
+
+        case DBE_TILE_CMD_TEXT :
+            _DBE_TILE_RenderText( pCmd, _DBE_TILE_pTarget ) ;
+        break ;
+
+        default :
+            // Opaque primitives are always rendered in tiles
+        break ;
+    }
+}
+
+/**
+ * \brief Render an area with the display list entries starting at dwFirst, strip
+ * by strip, and send each strip to the panel.
+ */
+static void _DBE_TILE_RenderArea( const SWGTRect* pArea, uint32_t dwFirst )
+{
+    SWGTRect sStrip ;
+    uint32_t dwWidth ;
+    uint32_t dwLines ;
+    uint32_t dw ;
+
+    dwWidth=pArea->dwX2-pArea->dwX1+1 ;
+    dwLines=_DBE_TILE_dwPixels/dwWidth ;
+
+    sStrip.dwX1=pArea->dwX1 ;
+    sStrip.dwX2=pArea->dwX2 ;
+    for ( sStrip.dwY1=pArea->dwY1 ; sStrip.dwY1 <= pArea->dwY2 ; sStrip.dwY1+=dwLines )
+    {
+        sStrip.dwY2=sStrip.dwY1+dwLines-1 ;
+        if ( sStrip.dwY2 > pArea->dwY2 )
+        {
+            sStrip.dwY2=pArea->dwY2 ;
+        }
+
+        FB_SetFrameBuffer( _DBE_TILE_pBuffer, dwWidth, sStrip.dwY2-sStrip.dwY1+1 ) ;
+        FB_SetOrigin( sStrip.dwX1, sStrip.dwY1 ) ;
+
+        for ( dw=dwFirst ; dw < _DBE_TILE_dwCommands ; dw++ )
+        {
+            if ( _DBE_TILE_Intersects( &_DBE_TILE_asCommands[dw].sBox, &sStrip ) )
+            {
+                _DBE_TILE_Render( &_DBE_TILE_asCommands[dw] ) ;
+            }
+        }
+
+        _DBE_TILE_Flush( sStrip.dwX1, sStrip.dwY1, sStrip.dwX2, sStrip.dwY2, _DBE_TILE_pBuffer ) ;
+    }
+}
+
+/*----------------------------------------------------------------------------
+ *        Backend interface
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _DBE_TILE_Reset( void )
+{
+    _DBE_TILE_dwCommands=0 ;
+
+    return _DBE_TILE_pTarget->Reset() ;
+}
+
+static uint32_t _DBE_TILE_Initialize( void )
+{
+    _DBE_TILE_dwCommands=0 ;
+
+    return _DBE_TILE_pTarget->Initialize() ;
+}
+
+static uint32_t _DBE_TILE_GetPixel( uint32_t dwX, uint32_t dwY, SGUIColor* pclrResult )
+{
+    DBE_TILE_Flush() ;
+
+    return _DBE_TILE_pTarget->GetPixel( dwX, dwY, pclrResult ) ;
+}
+
+static uint32_t _DBE_TILE_DrawPixel( uint32_t dwX, uint32_t dwY, SGUIColor* pclrIn )
+{
+    SDBETileCommand* pCmd ;
+
+    pCmd=_DBE_TILE_Record( DBE_TILE_CMD_PIXEL, dwX, dwY, dwX, dwY ) ;
+    if ( pCmd != NULL )
+    {
+        pCmd->adwParam[0]=dwX ;
+        pCmd->adwParam[1]=dwY ;
+        pCmd->dwColor=pclrIn->u.dwRGBA ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+static uint32_t _DBE_TILE_DrawLine( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2, SGUIColor* pclrIn )
+{
+    SDBETileCommand* pCmd ;
+
+    pCmd=_DBE_TILE_Record( DBE_TILE_CMD_LINE, dwX1, dwY1, dwX2, dwY2 ) ;
+    if ( pCmd != NULL )
+    {
+        pCmd->adwParam[0]=dwX1 ;
+        pCmd->adwParam[1]=dwY1 ;
+        pCmd->adwParam[2]=dwX2 ;
+        pCmd->adwParam[3]=dwY2 ;
+        pCmd->dwColor=pclrIn->u.dwRGBA ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+static uint32_t _DBE_TILE_DrawCircle( uint32_t dwX, uint32_t dwY, uint32_t dwRadius, SGUIColor* pclrBorder )
+{
+    SDBETileCommand* pCmd ;
+
+    if ( pclrBorder == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    pCmd=_DBE_TILE_Record( DBE_TILE_CMD_CIRCLE, (int32_t)(dwX-dwRadius), (int32_t)(dwY-dwRadius), dwX+dwRadius, dwY+dwRadius ) ;
+    if ( pCmd != NULL )
+    {
+        pCmd->adwParam[0]=dwX ;
+        pCmd->adwParam[1]=dwY ;
+        pCmd->adwParam[2]=dwRadius ;
+        pCmd->dwColor=pclrBorder->u.dwRGBA ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+static uint32_t _DBE_TILE_DrawFilledCircle( uint32_t dwX, uint32_t dwY, uint32_t dwRadius, SGUIColor* pclrBorder, SGUIColor* pclrInside )
+{
+    SDBETileCommand* pCmd ;
+
+    if ( pclrInside == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    pCmd=_DBE_TILE_Record( DBE_TILE_CMD_FILLED_CIRCLE, (int32_t)(dwX-dwRadius), (int32_t)(dwY-dwRadius), dwX+dwRadius, dwY+dwRadius ) ;
+    if ( pCmd != NULL )
+    {
+        pCmd->adwParam[0]=dwX ;
+        pCmd->adwParam[1]=dwY ;
+        pCmd->adwParam[2]=dwRadius ;
+        pCmd->dwColorInside=pclrInside->u.dwRGBA ;
+        pCmd->dwHasColor=(pclrBorder != NULL) ;
+        pCmd->dwColor=(pclrBorder != NULL)?pclrBorder->u.dwRGBA:0 ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+static uint32_t _DBE_TILE_DrawRectangle( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2, SGUIColor* pclrFrame )
+{
+    SDBETileCommand* pCmd ;
+
+    pCmd=_DBE_TILE_Record( DBE_TILE_CMD_RECTANGLE, dwX1, dwY1, dwX2, dwY2 ) ;
+    if ( pCmd != NULL )
+    {
+        pCmd->adwParam[0]=dwX1 ;
+        pCmd->adwParam[1]=dwY1 ;
+        pCmd->adwParam[2]=dwX2 ;
+        pCmd->adwParam[3]=dwY2 ;
+        pCmd->dwColor=pclrFrame->u.dwRGBA ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+static uint32_t _DBE_TILE_DrawFilledRectangle( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2, SGUIColor* pclrFrame, SGUIColor* pclrInside )
+{
+    SDBETileCommand* pCmd ;
+
+    if ( pclrInside == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    pCmd=_DBE_TILE_Record( DBE_TILE_CMD_FILLED_RECTANGLE, dwX1, dwY1, dwX2, dwY2 ) ;
+    if ( pCmd != NULL )
+    {
+        pCmd->adwParam[0]=dwX1 ;
+        pCmd->adwParam[1]=dwY1 ;
+        pCmd->adwParam[2]=dwX2 ;
+        pCmd->adwParam[3]=dwY2 ;
+        pCmd->dwColorInside=pclrInside->u.dwRGBA ;
+        pCmd->dwHasColor=(pclrFrame != NULL) ;
+        pCmd->dwColor=(pclrFrame != NULL)?pclrFrame->u.dwRGBA:0 ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+static uint32_t _DBE_TILE_DrawBitmap( uint32_t dwX, uint32_t dwY, uint32_t dwWidth, uint32_t dwHeight, uint8_t* pucData )
+{
+    SDBETileCommand* pCmd ;
+
+    // BMP images and files are decoded by the target backend
+    if ( ((pucData[0] == 'B') && (pucData[1] == 'M')) || (pucData[0] == '/') )
+    {
+        DBE_TILE_Flush() ;
+
+        return _DBE_TILE_pTarget->DrawBitmap( dwX, dwY, dwWidth, dwHeight, pucData ) ;
+    }
+
+    if ( (dwWidth == 0) || (dwHeight == 0) )
+    {
+        return SAMGUI_E_OK ;
+    }
+
+    pCmd=_DBE_TILE_Record( DBE_TILE_CMD_BITMAP, dwX, dwY, dwX+dwWidth-1, dwY+dwHeight-1 ) ;
+    if ( pCmd != NULL )
+    {
+        pCmd->adwParam[0]=dwX ;
+        pCmd->adwParam[1]=dwY ;
+        pCmd->adwParam[2]=dwWidth ;
+        pCmd->adwParam[3]=dwHeight ;
+        pCmd->pvData=pucData ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+static uint32_t _DBE_TILE_DrawText( uint32_t dwX, uint32_t dwY, char* pszText, SGUIColor* pclrText, SGUIFont* pFont, uint32_t dwSize )
+{
+    SDBETileCommand* pCmd ;
+    uint32_t dwColumns=0 ;
+    uint32_t dwMaxColumns=0 ;
+    uint32_t dwLines=1 ;
+    char* psz ;
+
+    if ( (pszText == NULL) || (pclrText == NULL) || (pFont == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    // Text extent
+    for ( psz=pszText ; *psz != 0 ; psz++ )
+    {
+        if ( *psz == '\n' )
+        {
+            dwLines++ ;
+            dwColumns=0 ;
+        }
+        else
+        {
+            dwColumns++ ;
+            if ( dwColumns > dwMaxColumns )
+            {
+                dwMaxColumns=dwColumns ;
+            }
+        }
+    }
+
+    if ( dwMaxColumns == 0 )
+    {
+        return SAMGUI_E_OK ;
+    }
+
+    pCmd=_DBE_TILE_Record( DBE_TILE_CMD_TEXT, dwX, dwY, dwX+dwMaxColumns*(pFont->dwWidth+2)-1, dwY+dwLines*(pFont->dwHeight+2)-1 ) ;
+    if ( pCmd != NULL )
+    {
+        pCmd->adwParam[0]=dwX ;
+        pCmd->adwParam[1]=dwY ;
+        pCmd->adwParam[2]=dwSize ;
+        pCmd->dwColor=pclrText->u.dwRGBA ;
+        pCmd->pvData=pszText ;
+        pCmd->pFont=pFont ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * \brief Native pixels are written by the target backend, after the display
+ * list.
+ */
+static uint32_t _DBE_TILE_DrawNative( uint32_t dwX, uint32_t dwY, uint32_t dwWidth, uint32_t dwHeight, const uint8_t* pucPixels )
+{
+    if ( _DBE_TILE_pTarget->DrawNative == NULL )
+    {
+        return SAMGUI_E_WRONG_COMPONENT ;
+    }
+
+    DBE_TILE_Flush() ;
+
+    return _DBE_TILE_pTarget->DrawNative( dwX, dwY, dwWidth, dwHeight, pucPixels ) ;
+}
+
+static uint32_t _DBE_TILE_SetClipRect( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2 )
+{
+    // A clipping change ends the current display list
+    DBE_TILE_Flush() ;
+
+    _DBE_TILE_sClip.dwX1=(dwX1 < BOARD_LCD_WIDTH)?dwX1:BOARD_LCD_WIDTH-1 ;
+    _DBE_TILE_sClip.dwY1=(dwY1 < BOARD_LCD_HEIGHT)?dwY1:BOARD_LCD_HEIGHT-1 ;
+    _DBE_TILE_sClip.dwX2=(dwX2 < BOARD_LCD_WIDTH)?dwX2:BOARD_LCD_WIDTH-1 ;
+    _DBE_TILE_sClip.dwY2=(dwY2 < BOARD_LCD_HEIGHT)?dwY2:BOARD_LCD_HEIGHT-1 ;
+
+    if ( _DBE_TILE_pTarget->SetClipRect != NULL )
+    {
+        _DBE_TILE_pTarget->SetClipRect( dwX1, dwY1, dwX2, dwY2 ) ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+static uint32_t _DBE_TILE_IOCtl( uint32_t dwCommand, uint32_t* pdwValue, uint32_t* pdwValueLength )
+{
+    DBE_TILE_Flush() ;
+
+    if ( (dwCommand == DISP_BACKEND_IOCTL_FLUSH) || (_DBE_TILE_pTarget->IOCtl == NULL) )
+    {
+        return SAMGUI_E_OK ;
+    }
+
+    return _DBE_TILE_pTarget->IOCtl( dwCommand, pdwValue, pdwValueLength ) ;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Configure the tiled backend.
+ *
+ * \param pTarget   Panel backend, used for the primitives not rendered in tiles.
+ * \param pBuffer   Render buffer, at least one screen line.
+ * \param dwPixels  Render buffer size, in pixels.
+ * \param Flush     Windowed write to the panel, LCD_DrawPicture() if NULL.
+ */
+extern uint32_t DBE_TILE_Initialize( SDISPBackend* pTarget, LcdColor_t* pBuffer, uint32_t dwPixels, DBE_TILE_FlushCallback Flush )
+{
+    if ( (pTarget == NULL) || (pBuffer == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( dwPixels < BOARD_LCD_WIDTH )
+    {
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+
+    _DBE_TILE_pTarget=pTarget ;
+    _DBE_TILE_pBuffer=pBuffer ;
+    _DBE_TILE_dwPixels=dwPixels ;
+    _DBE_TILE_Flush=(Flush != NULL)?Flush:LCD_DrawPicture ;
+    _DBE_TILE_dwCommands=0 ;
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * \brief Render the display list and write it to the panel.
+ */
+extern uint32_t DBE_TILE_Flush( void )
+{
+    SDBETileCommand* pCmd ;
+    uint32_t dw ;
+    uint32_t dwOther ;
+    uint32_t dwCovered ;
+
+    for ( dw=0 ; dw < _DBE_TILE_dwCommands ; dw++ )
+    {
+        pCmd=&_DBE_TILE_asCommands[dw] ;
+
+        // Already rendered with an earlier opaque area?
+        dwCovered=0 ;
+        for ( dwOther=0 ; (dwOther < dw) && !dwCovered ; dwOther++ )
+        {
+            dwCovered=_DBE_TILE_IsOpaque( &_DBE_TILE_asCommands[dwOther] ) &&
+                      _DBE_TILE_Contains( &_DBE_TILE_asCommands[dwOther].sBox, &pCmd->sBox ) ;
+        }
+        if ( dwCovered )
+        {
+            continue ;
+        }
+
+        if ( !_DBE_TILE_IsOpaque( pCmd ) )
+        {
+            _DBE_TILE_RenderDirect( pCmd ) ;
+            continue ;
+        }
+
+        // Hidden by a later opaque area?
+        for ( dwOther=dw+1 ; (dwOther < _DBE_TILE_dwCommands) && !dwCovered ; dwOther++ )
+        {
+            dwCovered=_DBE_TILE_IsOpaque( &_DBE_TILE_asCommands[dwOther] ) &&
+                      _DBE_TILE_Contains( &_DBE_TILE_asCommands[dwOther].sBox, &pCmd->sBox ) ;
+        }
+        if ( !dwCovered )
+        {
+            _DBE_TILE_RenderArea( &pCmd->sBox, dw ) ;
+        }
+    }
+    _DBE_TILE_dwCommands=0 ;
+
+    return SAMGUI_E_OK ;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported interface
+ *----------------------------------------------------------------------------*/
+SDISPBackend sDISP_Backend_TILE=
+{
+    .sData=
+    {
+        .dwID=DISP_BACKEND_TILE,
+    },
+
+    .Reset=_DBE_TILE_Reset,
+    .Initialize=_DBE_TILE_Initialize,
+    .GetPixel=_DBE_TILE_GetPixel,
+    .DrawPixel=_DBE_TILE_DrawPixel,
+    .DrawLine=_DBE_TILE_DrawLine,
+    .DrawCircle=_DBE_TILE_DrawCircle,
+    .DrawFilledCircle=_DBE_TILE_DrawFilledCircle,
+    .DrawRectangle=_DBE_TILE_DrawRectangle,
+    .DrawFilledRectangle=_DBE_TILE_DrawFilledRectangle,
+    .DrawBitmap=_DBE_TILE_DrawBitmap,
+    .DrawText=_DBE_TILE_DrawText,
+    .Fill=NULL,
+    .IOCtl=_DBE_TILE_IOCtl,
+    .SetClipRect=_DBE_TILE_SetClipRect,
+    .DrawNative=_DBE_TILE_DrawNative
+} ;
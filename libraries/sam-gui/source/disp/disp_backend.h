@@ -57,6 +57,8 @@ typedef struct _SDISPBackend
     uint32_t (*DrawText)( uint32_t dwX, uint32_t dwY, char* pszText, SGUIColor* pclrText, SGUIFont* pFont, uint32_t dwSize ) ;
     uint32_t (*Fill)( uint32_t dwX, uint32_t dwY, SGUIColor* pclrIn ) ;
     uint32_t (*IOCtl)( uint32_t dwCommand, uint32_t* pdwValue, uint32_t* pdwValueLength ) ;
+    uint32_t (*SetClipRect)( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2 ) ; // Optional, drawing outside is discarded
+    uint32_t (*DrawNative)( uint32_t dwX, uint32_t dwY, uint32_t dwWidth, uint32_t dwHeight, const uint8_t* pucPixels ) ; // Optional, rows of pixels in the panel format (DISP_BACKEND_IOCTL_GET_PIXEL_FORMAT), clipped
 } SDISPBackend ;
 
 #define DISP_BACKEND_IOCTL_POWER_ON              0x01L
@@ -64,11 +66,20 @@ typedef struct _SDISPBackend
 #define DISP_BACKEND_IOCTL_SET_BACKLIGHT         0x03L
 #define DISP_BACKEND_IOCTL_SET_MODE_PORTRAIT     0x04L
 #define DISP_BACKEND_IOCTL_SET_MODE_LANDSCAPE    0x05L
+#define DISP_BACKEND_IOCTL_FLUSH                 0x06L
+#define DISP_BACKEND_IOCTL_SET_SCROLL_AREA       0x07L // pdwValue: { first row, number of rows }, hardware scrolled band
+#define DISP_BACKEND_IOCTL_SET_SCROLL_OFFSET     0x08L // pdwValue: offset in rows within the scroll area, 0 to height-1
+#define DISP_BACKEND_IOCTL_GET_PIXEL_FORMAT      0x09L // pdwValue: receives the DISP_PIXEL_FORMAT_xxx of DrawNative
+
+#define DISP_PIXEL_FORMAT_NONE                   0x00L // no DrawNative
+#define DISP_PIXEL_FORMAT_RGB666_3B              0x01L // 3 bytes per pixel in GRAM write order (R, G, B), 6 upper bits used
+#define DISP_PIXEL_FORMAT_RGB565_2B              0x02L // 2 bytes per pixel, little endian RGB565 halfwords
 
 typedef enum _DISP_eBackend
 {
     DISP_BACKEND_HX8347,
     DISP_BACKEND_ILI9325,
+    DISP_BACKEND_TILE,
     DISP_BACKEND_MAX
 } DISP_eBackend ;
 
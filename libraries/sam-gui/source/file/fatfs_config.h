@@ -106,6 +106,20 @@
 /* To enable fast seek feature, set _USE_FASTSEEK to 1. */
 
 
+#define	_USE_EXPAND	0		/* 0:Disable or 1:Enable */
+/* To enable f_expand function, set _USE_EXPAND to 1 and set _FS_READONLY to 0. */
+
+
+#define	_FS_NOFSINFO	0	/* 0 to 3 */
+/* bit0=1: Do not trust the FSInfo free cluster count, bit1=1: Do not trust
+/  the FSInfo next free cluster hint. See ffconf.h. */
+
+
+#define	_USE_CHKFREE	1	/* 0:Disable or 1:Enable */
+/* To enable f_chkfree function, set _USE_CHKFREE to 1 and set _FS_READONLY
+/  to 0. */
+
+
 
 /*---------------------------------------------------------------------------/
 / Locale and Namespace Configurations
@@ -144,7 +158,7 @@
 */
 
 
-#define	_USE_LFN	2		/* 0 to 3 */
+#define	_USE_LFN	1		/* 0 to 3 */
 #define	_MAX_LFN	255		/* Maximum LFN length to handle (12 to 255) */
 /* The _USE_LFN option switches the LFN support.
 /
@@ -232,6 +246,11 @@
    per volume. */
 
 
+#define	_FS_DIRCACHE	8	/* 0:Disable or >=1:Enable */
+/* To enable the name lookup cache, set _FS_DIRCACHE to >= 1. The value defines
+/  number of looked up names remembered per volume. See ffconf.h. */
+
+
 #include "fat/fatfs/src/diskio.h"
 #include "fat/fatfs/src/ff.h"
 
@@ -0,0 +1,442 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#include "libsam_gui.h"
+
+#include <string.h>
+
+#include "jerror.h"
+
+/**
+ * \addtogroup SAMGUI
+ * @{
+ *   \addtogroup SAMGUI_FILE
+ *   @{
+ *     \addtogroup SAMGUI_FILE_JPEG FILE Incremental JPEG
+ *     @{
+ *
+ * \brief JPEG files decoded and painted a few MCU rows at a time.
+ */
+
+/**
+ * Source manager methods. The input buffer is loaded by the step, between two
+ * libjpeg calls: when libjpeg has used it up, fill_input_buffer suspends the
+ * decoder, which backs up to its last restart point and returns.
+ */
+static void _FILE_Jpeg_SourceInit( j_decompress_ptr cinfo )
+{
+}
+
+static boolean _FILE_Jpeg_SourceFill( j_decompress_ptr cinfo )
+{
+    SFILEJpeg* pJpeg=((SFILEJpegSource*)cinfo->src)->pJpeg ;
+
+    if ( !pJpeg->dwEof )
+    {
+        return FALSE ;
+    }
+
+    // Insert a fake EOI marker, as jdatasrc.c does
+    WARNMS( cinfo, JWRN_JPEG_EOF ) ;
+    pJpeg->aucInput[0]=(JOCTET)0xFF ;
+    pJpeg->aucInput[1]=(JOCTET)JPEG_EOI ;
+    pJpeg->source.pub.next_input_byte=pJpeg->aucInput ;
+    pJpeg->source.pub.bytes_in_buffer=2 ;
+
+    return TRUE ;
+}
+
+/**
+ * Skips data in the buffer, the rest is recorded and skipped in the file by
+ * the next load, as a suspending source may not read here
+ */
+static void _FILE_Jpeg_SourceSkip( j_decompress_ptr cinfo, long lBytes )
+{
+    SFILEJpeg* pJpeg=((SFILEJpegSource*)cinfo->src)->pJpeg ;
+    struct jpeg_source_mgr* pSrc=cinfo->src ;
+
+    if ( lBytes <= 0 )
+    {
+        return ;
+    }
+
+    if ( (size_t)lBytes > pSrc->bytes_in_buffer )
+    {
+        pJpeg->dwSkip+=(uint32_t)lBytes-pSrc->bytes_in_buffer ;
+        lBytes=(long)pSrc->bytes_in_buffer ;
+    }
+
+    pSrc->next_input_byte+=(size_t)lBytes ;
+    pSrc->bytes_in_buffer-=(size_t)lBytes ;
+}
+
+static void _FILE_Jpeg_SourceTerm( j_decompress_ptr cinfo )
+{
+}
+
+/**
+ * Error manager exit method, printing the message and aborting the image
+ */
+static void _FILE_Jpeg_ErrorExit( j_common_ptr cinfo )
+{
+    SFILEJpegError* pError=(SFILEJpegError*)cinfo->err ;
+
+    (*cinfo->err->output_message)( cinfo ) ;
+    longjmp( pError->jmpBuffer, 1 ) ;
+}
+
+/**
+ * Moves the bytes not used by libjpeg yet to the start of the input buffer and
+ * fills the rest from the file. A short read marks the end of the file.
+ *
+ * \return 0 if the buffer is full of unused bytes, which happens only with a
+ * marker longer than the buffer.
+ */
+static uint32_t _FILE_Jpeg_Load( SFILEJpeg* pJpeg )
+{
+    struct jpeg_source_mgr* pSrc=&pJpeg->source.pub ;
+    size_t dwKept=pSrc->bytes_in_buffer ;
+    UINT uLength=0 ;
+
+    if ( dwKept == sizeof( pJpeg->aucInput ) )
+    {
+        return 0 ;
+    }
+
+    if ( (dwKept != 0) && (pSrc->next_input_byte != pJpeg->aucInput) )
+    {
+        memmove( pJpeg->aucInput, pSrc->next_input_byte, dwKept ) ;
+    }
+
+    if ( pJpeg->dwSkip != 0 )
+    {
+        // FatFs stops a read-only seek at the end of the file
+        if ( f_lseek( &pJpeg->file, pJpeg->file.fptr+pJpeg->dwSkip ) != FR_OK )
+        {
+            pJpeg->dwEof=1 ;
+        }
+        pJpeg->dwSkip=0 ;
+    }
+
+    if ( !pJpeg->dwEof )
+    {
+        if ( f_read( &pJpeg->file, &pJpeg->aucInput[dwKept], sizeof( pJpeg->aucInput )-dwKept, &uLength ) != FR_OK )
+        {
+            uLength=0 ;
+        }
+        if ( uLength < sizeof( pJpeg->aucInput )-dwKept )
+        {
+            pJpeg->dwEof=1 ;
+        }
+    }
+
+    pSrc->next_input_byte=pJpeg->aucInput ;
+    pSrc->bytes_in_buffer=dwKept+uLength ;
+
+    return 1 ;
+}
+
+/**
+ * Chooses the output format and the scaling, once the header is read
+ */
+static void _FILE_Jpeg_SetParameters( SFILEJpeg* pJpeg )
+{
+    j_decompress_ptr cinfo=&pJpeg->cinfo ;
+    uint32_t dwDenom=pJpeg->dwScaleDenom ;
+
+    if ( dwDenom == 0 )
+    {
+        for ( dwDenom=1 ; (dwDenom < 8) && ((cinfo->image_width+dwDenom-1)/dwDenom > FILE_JPEG_MAX_WIDTH) ; dwDenom*=2 )
+        {
+        }
+    }
+
+    cinfo->out_color_space=JCS_RGB ;
+    cinfo->scale_num=1 ;
+    cinfo->scale_denom=dwDenom ;
+    cinfo->do_fancy_upsampling=FALSE ;
+    cinfo->dct_method=JDCT_IFAST ;
+}
+
+/**
+ * Paints the decoded rows waiting in the row buffer, in the raw RGB format of
+ * DrawBitmap
+ */
+static void _FILE_Jpeg_Draw( SFILEJpeg* pJpeg )
+{
+    j_decompress_ptr cinfo=&pJpeg->cinfo ;
+
+    if ( pJpeg->dwRows == 0 )
+    {
+        return ;
+    }
+
+    // The first pixel must never read as a "BM" or "/" bitmap signature; the
+    // panel only keeps 6 bits per component
+    pJpeg->aucRows[0]&=0xfc ;
+
+    pJpeg->pBE->DrawBitmap( pJpeg->dwX, pJpeg->dwY+cinfo->output_scanline-pJpeg->dwRows,
+                            cinfo->output_width, pJpeg->dwRows, pJpeg->aucRows ) ;
+    pJpeg->dwRows=0 ;
+}
+
+/**
+ * Releases the decoder and the file, and posts the notification
+ */
+static uint32_t _FILE_Jpeg_End( SFILEJpeg* pJpeg, uint32_t dwResult )
+{
+    jpeg_destroy_decompress( &pJpeg->cinfo ) ;
+    f_close( &pJpeg->file ) ;
+
+    pJpeg->dwState=(dwResult == SAMGUI_E_OK) ? FILE_JPEG_DONE : FILE_JPEG_FAILED ;
+    pJpeg->dwResult=dwResult ;
+
+    if ( pJpeg->dwNotifyMsg != 0 )
+    {
+        WGT_PostMessage( pJpeg->dwNotifyMsg, dwResult, (uint32_t)pJpeg ) ;
+    }
+
+    return dwResult ;
+}
+
+/**
+ * Opens a JPEG file to be painted with its top left corner at dwX, dwY.
+ * Nothing is decoded before the first FILE_Jpeg_Step().
+ *
+ * \param dwScaleDenom  Scaling 1/1, 1/2, 1/4 or 1/8, 0 for the largest one
+ *                      fitting FILE_JPEG_MAX_WIDTH.
+ * \param dwNotifyMsg   WGT message posted when the image is done or has
+ *                      failed, with the result and the SFILEJpeg, 0 for none.
+ */
+extern uint32_t FILE_Jpeg_Open( SFILEJpeg* pJpeg, SDISPBackend* pBE, const char* pszPath, uint32_t dwX, uint32_t dwY, uint32_t dwScaleDenom, uint32_t dwNotifyMsg )
+{
+    if ( (pJpeg == NULL) || (pBE == NULL) || (pszPath == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( (dwScaleDenom != 0) && (dwScaleDenom != 1) && (dwScaleDenom != 2) && (dwScaleDenom != 4) && (dwScaleDenom != 8) )
+    {
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+
+    memset( pJpeg, 0, sizeof( SFILEJpeg ) ) ;
+    if ( f_open( &pJpeg->file, pszPath, FA_OPEN_EXISTING|FA_READ ) != FR_OK )
+    {
+        return SAMGUI_E_FILE_OPEN ;
+    }
+
+    pJpeg->pBE=pBE ;
+    pJpeg->dwX=dwX ;
+    pJpeg->dwY=dwY ;
+    pJpeg->dwScaleDenom=dwScaleDenom ;
+    pJpeg->dwNotifyMsg=dwNotifyMsg ;
+
+    pJpeg->cinfo.err=jpeg_std_error( &pJpeg->error.pub ) ;
+    pJpeg->error.pub.error_exit=_FILE_Jpeg_ErrorExit ;
+    if ( setjmp( pJpeg->error.jmpBuffer ) )
+    {
+        // No memory for the decoder
+        jpeg_destroy_decompress( &pJpeg->cinfo ) ;
+        f_close( &pJpeg->file ) ;
+        pJpeg->dwState=FILE_JPEG_CLOSED ;
+
+        return SAMGUI_E_NOT_ENOUGH_MEMORY ;
+    }
+    jpeg_create_decompress( &pJpeg->cinfo ) ;
+
+    pJpeg->source.pub.init_source=_FILE_Jpeg_SourceInit ;
+    pJpeg->source.pub.fill_input_buffer=_FILE_Jpeg_SourceFill ;
+    pJpeg->source.pub.skip_input_data=_FILE_Jpeg_SourceSkip ;
+    pJpeg->source.pub.resync_to_restart=jpeg_resync_to_restart ;
+    pJpeg->source.pub.term_source=_FILE_Jpeg_SourceTerm ;
+    pJpeg->source.pub.next_input_byte=pJpeg->aucInput ;
+    pJpeg->source.pub.bytes_in_buffer=0 ;
+    pJpeg->source.pJpeg=pJpeg ;
+    pJpeg->cinfo.src=&pJpeg->source.pub ;
+
+    pJpeg->dwState=FILE_JPEG_HEADER ;
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Decodes and paints at most dwMcuRows MCU rows, reading the file at most
+ * FILE_JPEG_LOADS_PER_STEP times. The header and the start of the decode are
+ * spread over the steps the same way.
+ *
+ * \return SAMGUI_E_JPEG_PENDING while the image is not complete, SAMGUI_E_OK
+ * once it is painted, SAMGUI_E_JPEG_DECODE for a corrupted or unsupported
+ * file.
+ */
+extern uint32_t FILE_Jpeg_Step( SFILEJpeg* pJpeg, uint32_t dwMcuRows )
+{
+    j_decompress_ptr cinfo ;
+    JSAMPROW pRow ;
+    uint32_t dwLoads=0 ;
+    uint32_t dwLines=0 ;
+    uint32_t dwBudget ;
+
+    if ( pJpeg == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    switch ( pJpeg->dwState )
+    {
+        case FILE_JPEG_CLOSED :
+            return SAMGUI_E_BAD_PARAMETER ;
+
+        case FILE_JPEG_DONE :
+        case FILE_JPEG_FAILED :
+            return pJpeg->dwResult ;
+    }
+
+    cinfo=&pJpeg->cinfo ;
+    if ( setjmp( pJpeg->error.jmpBuffer ) )
+    {
+        return _FILE_Jpeg_End( pJpeg, SAMGUI_E_JPEG_DECODE ) ;
+    }
+
+    for ( ; ; )
+    {
+        // Let the decoder go as far as the loaded data allows
+        switch ( pJpeg->dwState )
+        {
+            case FILE_JPEG_HEADER :
+                if ( jpeg_read_header( cinfo, TRUE ) == JPEG_SUSPENDED )
+                {
+                    break ;
+                }
+                _FILE_Jpeg_SetParameters( pJpeg ) ;
+                pJpeg->dwState=FILE_JPEG_START ;
+                continue ;
+
+            case FILE_JPEG_START :
+                if ( !jpeg_start_decompress( cinfo ) )
+                {
+                    break ;
+                }
+                if ( (cinfo->output_width > FILE_JPEG_MAX_WIDTH) || (cinfo->output_components != 3) )
+                {
+                    ERREXIT( cinfo, JERR_WIDTH_OVERFLOW ) ;
+                }
+                pJpeg->dwState=FILE_JPEG_ROWS ;
+                continue ;
+
+            case FILE_JPEG_ROWS :
+                // Output rows of one MCU row, after scaling
+                dwBudget=dwMcuRows*cinfo->max_v_samp_factor*cinfo->min_DCT_v_scaled_size ;
+                while ( (dwLines < dwBudget) && (cinfo->output_scanline < cinfo->output_height) )
+                {
+                    pRow=&pJpeg->aucRows[pJpeg->dwRows*cinfo->output_width*3] ;
+                    if ( jpeg_read_scanlines( cinfo, &pRow, 1 ) == 0 )
+                    {
+                        break ;
+                    }
+                    dwLines++ ;
+
+                    if ( ++pJpeg->dwRows == FILE_JPEG_DRAW_ROWS )
+                    {
+                        _FILE_Jpeg_Draw( pJpeg ) ;
+                    }
+                }
+
+                if ( cinfo->output_scanline < cinfo->output_height )
+                {
+                    if ( dwLines < dwBudget )
+                    {
+                        break ;
+                    }
+                    _FILE_Jpeg_Draw( pJpeg ) ;
+
+                    return SAMGUI_E_JPEG_PENDING ;
+                }
+                _FILE_Jpeg_Draw( pJpeg ) ;
+                pJpeg->dwState=FILE_JPEG_FINISH ;
+                continue ;
+
+            default :
+                if ( !jpeg_finish_decompress( cinfo ) )
+                {
+                    break ;
+                }
+
+                return _FILE_Jpeg_End( pJpeg, SAMGUI_E_OK ) ;
+        }
+
+        // Suspended on an empty buffer, load more unless the step is over
+        if ( dwLoads == FILE_JPEG_LOADS_PER_STEP )
+        {
+            _FILE_Jpeg_Draw( pJpeg ) ;
+
+            return SAMGUI_E_JPEG_PENDING ;
+        }
+        dwLoads++ ;
+
+        if ( !_FILE_Jpeg_Load( pJpeg ) )
+        {
+            ERREXIT( cinfo, JERR_BUFFER_SIZE ) ;
+        }
+    }
+}
+
+/**
+ * Background work of the GUI task (WGT_SetBackgroundWork()), one step of
+ * FILE_JPEG_STEP_MCU_ROWS MCU rows per call
+ */
+extern uint32_t FILE_Jpeg_Work( void* pvJpeg )
+{
+    return (FILE_Jpeg_Step( (SFILEJpeg*)pvJpeg, FILE_JPEG_STEP_MCU_ROWS ) == SAMGUI_E_JPEG_PENDING) ;
+}
+
+/**
+ * Stops the decode if it is not complete, and closes the file. The rows
+ * painted are left on the screen.
+ */
+extern uint32_t FILE_Jpeg_Close( SFILEJpeg* pJpeg )
+{
+    if ( pJpeg == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( (pJpeg->dwState != FILE_JPEG_CLOSED) && (pJpeg->dwState != FILE_JPEG_DONE) && (pJpeg->dwState != FILE_JPEG_FAILED) )
+    {
+        jpeg_destroy_decompress( &pJpeg->cinfo ) ;
+        f_close( &pJpeg->file ) ;
+    }
+    pJpeg->dwState=FILE_JPEG_CLOSED ;
+
+    return SAMGUI_E_OK ;
+}
+
+/** @}
+ * @}
+ * @} */
@@ -0,0 +1,156 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef _SAMGUI_FILE_JPEG_
+#define _SAMGUI_FILE_JPEG_
+
+#include "source/porting/sam_gui_porting.h"
+#include "source/file/file_fs.h"
+#include "source/disp/disp_backend.h"
+
+#include <stdio.h>
+#include <setjmp.h>
+
+#include "jpeglib.h"
+
+/**
+ * \addtogroup SAMGUI
+ * @{
+ *   \addtogroup SAMGUI_FILE FILE
+ *   @{
+ *     \addtogroup SAMGUI_FILE_JPEG FILE Incremental JPEG
+ *     @{
+ *
+ * \brief JPEG files decoded and painted a few MCU rows at a time.
+ *
+ * FILE_Jpeg_Open() opens a JPEG file of the FAT volume, and each call to
+ * FILE_Jpeg_Step() decodes at most a given number of MCU rows and paints them
+ * at their place on the screen, so the image appears from the top while the
+ * GUI keeps handling its messages. Set FILE_Jpeg_Work() as the background
+ * work of the GUI task with WGT_SetBackgroundWork(): the message loop then
+ * runs one step of FILE_JPEG_STEP_MCU_ROWS rows between two messages.
+ *
+ * The decoder uses a suspending libjpeg source: the file is read by the step,
+ * FILE_JPEG_INPUT_SIZE bytes at most FILE_JPEG_LOADS_PER_STEP times, and
+ * libjpeg returns when the buffer is empty instead of blocking in a read, to
+ * resume on the next step. The markers, and the whole input of a progressive
+ * image read by jpeg_start_decompress() when libjpeg is built with
+ * D_PROGRESSIVE_SUPPORTED, are thus also spread over several steps.
+ *
+ * Images wider than FILE_JPEG_MAX_WIDTH are reduced with the libjpeg 1/2, 1/4
+ * or 1/8 scaling; the rows below the screen are clipped by the backend.
+ * Other tasks using the volume at the same time need FatFs built with
+ * _FS_REENTRANT.
+ */
+
+/* Widest decoded row, after scaling */
+#ifndef FILE_JPEG_MAX_WIDTH
+#  define FILE_JPEG_MAX_WIDTH          320
+#endif
+
+/* Input buffer, larger than the longest marker of the file (DHT, DQT) */
+#ifndef FILE_JPEG_INPUT_SIZE
+#  define FILE_JPEG_INPUT_SIZE         2048
+#endif
+
+/* File reads per step at most */
+#ifndef FILE_JPEG_LOADS_PER_STEP
+#  define FILE_JPEG_LOADS_PER_STEP     2
+#endif
+
+/* MCU rows decoded per step by FILE_Jpeg_Work() */
+#ifndef FILE_JPEG_STEP_MCU_ROWS
+#  define FILE_JPEG_STEP_MCU_ROWS      1
+#endif
+
+/* Decoded rows sent to the backend per DrawBitmap call */
+#define FILE_JPEG_DRAW_ROWS            4
+
+typedef enum _eFILEJpeg_State
+{
+    FILE_JPEG_CLOSED,     // 0, no file
+    FILE_JPEG_HEADER,     // reading the header
+    FILE_JPEG_START,      // jpeg_start_decompress() not done
+    FILE_JPEG_ROWS,       // decoding and painting the rows
+    FILE_JPEG_FINISH,     // jpeg_finish_decompress() not done
+    FILE_JPEG_DONE,
+    FILE_JPEG_FAILED
+} eFILEJpeg_State ;
+
+/**
+ * libjpeg suspending source manager over the file
+ */
+typedef struct _SFILEJpegSource
+{
+    struct jpeg_source_mgr pub ;
+    struct _SFILEJpeg* pJpeg ;
+} SFILEJpegSource ;
+
+/**
+ * libjpeg error manager returning to the step
+ */
+typedef struct _SFILEJpegError
+{
+    struct jpeg_error_mgr pub ;
+    jmp_buf jmpBuffer ;
+} SFILEJpegError ;
+
+typedef struct _SFILEJpeg
+{
+    struct jpeg_decompress_struct cinfo ;
+    SFILEJpegSource source ;
+    SFILEJpegError error ;
+    FIL file ;
+
+    SDISPBackend* pBE ;
+    uint32_t dwX ;               /* top left corner on the screen */
+    uint32_t dwY ;
+    uint32_t dwScaleDenom ;      /* 1, 2, 4 or 8, 0 to fit FILE_JPEG_MAX_WIDTH */
+    uint32_t dwNotifyMsg ;       /* message posted when the image is done, 0 for none */
+    uint32_t dwState ;
+    uint32_t dwResult ;          /* SAMGUI_E_OK or the failure of the decode */
+
+    uint32_t dwSkip ;            /* bytes skipped by libjpeg beyond the buffer */
+    uint32_t dwEof ;             /* 1 once the whole file is read */
+    uint32_t dwRows ;            /* decoded rows waiting in aucRows */
+
+    uint8_t aucInput[FILE_JPEG_INPUT_SIZE] ;
+    uint8_t aucRows[FILE_JPEG_MAX_WIDTH*3*FILE_JPEG_DRAW_ROWS] ;
+} SFILEJpeg ;
+
+extern uint32_t FILE_Jpeg_Open( SFILEJpeg* pJpeg, SDISPBackend* pBE, const char* pszPath, uint32_t dwX, uint32_t dwY, uint32_t dwScaleDenom, uint32_t dwNotifyMsg ) ;
+extern uint32_t FILE_Jpeg_Step( SFILEJpeg* pJpeg, uint32_t dwMcuRows ) ;
+extern uint32_t FILE_Jpeg_Work( void* pvJpeg ) ;
+extern uint32_t FILE_Jpeg_Close( SFILEJpeg* pJpeg ) ;
+
+/** @}
+ * @}
+ * @} */
+
+#endif // _SAMGUI_FILE_JPEG_
@@ -0,0 +1,552 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#include "libsam_gui.h"
+
+#include <string.h>
+
+/**
+ * \addtogroup SAMGUI
+ * @{
+ *   \addtogroup SAMGUI_FILE
+ *   @{
+ *     \addtogroup SAMGUI_FILE_PACK FILE Asset Pack
+ *     @{
+ *
+ * \brief Indexed asset packs, bitmaps drawn in the panel pixel format.
+ */
+
+/**
+ * Read function of the packs opened with FILE_Pack_OpenFile()
+ */
+static uint32_t _FILE_Pack_ReadFile( void* pvContext, uint32_t dwOffset, uint8_t* pucBuffer, uint32_t dwSize )
+{
+    SFILEPack* pPack=(SFILEPack*)pvContext ;
+    UINT uLength ;
+
+    if ( (f_lseek( &pPack->file, dwOffset ) != FR_OK) ||
+         (f_read( &pPack->file, pucBuffer, dwSize, &uLength ) != FR_OK) || (uLength != dwSize) )
+    {
+        return SAMGUI_E_FILE_READ ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Copies dwSize bytes of the pack at dwOffset. Small reads of a pack not
+ * memory mapped go through the read window, so that the RLE spans of a
+ * bitmap cost one source read per window.
+ */
+static uint32_t _FILE_Pack_Read( SFILEPack* pPack, uint32_t dwOffset, uint8_t* pucBuffer, uint32_t dwSize )
+{
+    uint32_t dwLength ;
+    uint32_t dwResult ;
+
+    if ( (dwOffset > pPack->dwSize) || (dwSize > pPack->dwSize-dwOffset) )
+    {
+        return SAMGUI_E_PACK_FORMAT ;
+    }
+
+    if ( pPack->pucBase != NULL )
+    {
+        memcpy( pucBuffer, pPack->pucBase+dwOffset, dwSize ) ;
+
+        return SAMGUI_E_OK ;
+    }
+
+    while ( dwSize != 0 )
+    {
+        if ( (dwOffset < pPack->dwWindowOffset) || (dwOffset >= pPack->dwWindowOffset+pPack->dwWindowLength) )
+        {
+            // Large reads bypass the window
+            if ( dwSize >= FILE_PACK_WINDOW_SIZE )
+            {
+                return pPack->Read( pPack->pvContext, dwOffset, pucBuffer, dwSize ) ;
+            }
+
+            dwLength=pPack->dwSize-dwOffset ;
+            if ( dwLength > FILE_PACK_WINDOW_SIZE )
+            {
+                dwLength=FILE_PACK_WINDOW_SIZE ;
+            }
+
+            pPack->dwWindowLength=0 ;
+            dwResult=pPack->Read( pPack->pvContext, dwOffset, pPack->aucWindow, dwLength ) ;
+            if ( dwResult != SAMGUI_E_OK )
+            {
+                return dwResult ;
+            }
+            pPack->dwWindowOffset=dwOffset ;
+            pPack->dwWindowLength=dwLength ;
+        }
+
+        dwLength=pPack->dwWindowOffset+pPack->dwWindowLength-dwOffset ;
+        if ( dwLength > dwSize )
+        {
+            dwLength=dwSize ;
+        }
+
+        memcpy( pucBuffer, pPack->aucWindow+(dwOffset-pPack->dwWindowOffset), dwLength ) ;
+        pucBuffer+=dwLength ;
+        dwOffset+=dwLength ;
+        dwSize-=dwLength ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Checks the pack header, once the source is set
+ */
+static uint32_t _FILE_Pack_Load( SFILEPack* pPack )
+{
+    SFILEPackHeader header ;
+    uint32_t dwResult ;
+
+    pPack->dwSize=sizeof( SFILEPackHeader ) ;
+    pPack->dwWindowLength=0 ;
+
+    dwResult=_FILE_Pack_Read( pPack, 0, (uint8_t*)&header, sizeof( header ) ) ;
+    if ( dwResult != SAMGUI_E_OK )
+    {
+        return dwResult ;
+    }
+
+    if ( (header.dwMagic != FILE_PACK_MAGIC) ||
+         (header.dwSize < sizeof( SFILEPackHeader )+header.wEntries*sizeof( SFILEPackEntry )) )
+    {
+        return SAMGUI_E_PACK_FORMAT ;
+    }
+
+    pPack->dwEntries=header.wEntries ;
+    pPack->dwPixelFormat=header.wPixelFormat ;
+    pPack->dwSize=header.dwSize ;
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Sends a span of pixels of one row to the backend, in its native format
+ * when it has one, else as a raw bitmap. As the row buffer is reused, a
+ * backend deferring the raw bitmaps is flushed at once.
+ */
+static uint32_t _FILE_Pack_DrawSpan( SFILEPack* pPack, SDISPBackend* pBE, uint32_t dwNative,
+                                     uint32_t dwX, uint32_t dwY, uint32_t dwWidth, uint32_t dwHeight, const uint8_t* pucPixels )
+{
+    uint32_t dwResult ;
+
+    if ( dwNative )
+    {
+        return pBE->DrawNative( dwX, dwY, dwWidth, dwHeight, pucPixels ) ;
+    }
+
+    // The packer keeps the 2 lower bits clear, the first pixel never looks like a BMP or a path
+    dwResult=pBE->DrawBitmap( dwX, dwY, dwWidth, dwHeight, (void*)pucPixels ) ;
+    if ( (dwResult == SAMGUI_E_OK) && (pBE->IOCtl != NULL) )
+    {
+        pBE->IOCtl( DISP_BACKEND_IOCTL_FLUSH, NULL, NULL ) ;
+    }
+
+    return dwResult ;
+}
+
+/**
+ * Opens a pack mapped in memory, usually linked in the internal flash. The
+ * bitmaps and fonts are used in place.
+ */
+extern uint32_t FILE_Pack_OpenMemory( SFILEPack* pPack, const void* pvPack )
+{
+    if ( (pPack == NULL) || (pvPack == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    memset( pPack, 0, sizeof( SFILEPack ) ) ;
+    pPack->pucBase=(const uint8_t*)pvPack ;
+
+    return _FILE_Pack_Load( pPack ) ;
+}
+
+/**
+ * Opens a pack read through a function, for a serial flash or any other
+ * storage. Read is given pvContext back.
+ */
+extern uint32_t FILE_Pack_Open( SFILEPack* pPack, FILE_PackRead Read, void* pvContext )
+{
+    if ( (pPack == NULL) || (Read == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    memset( pPack, 0, sizeof( SFILEPack ) ) ;
+    pPack->Read=Read ;
+    pPack->pvContext=pvContext ;
+
+    return _FILE_Pack_Load( pPack ) ;
+}
+
+/**
+ * Opens a pack stored in a FatFs file, kept open until FILE_Pack_Close()
+ */
+extern uint32_t FILE_Pack_OpenFile( SFILEPack* pPack, const char* pszPath )
+{
+    uint32_t dwResult ;
+
+    if ( (pPack == NULL) || (pszPath == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    memset( pPack, 0, sizeof( SFILEPack ) ) ;
+
+    if ( f_open( &pPack->file, pszPath, FA_OPEN_EXISTING|FA_READ ) != FR_OK )
+    {
+        return SAMGUI_E_FILE_OPEN ;
+    }
+    pPack->dwFile=1 ;
+    pPack->Read=_FILE_Pack_ReadFile ;
+    pPack->pvContext=pPack ;
+
+    dwResult=_FILE_Pack_Load( pPack ) ;
+    if ( dwResult != SAMGUI_E_OK )
+    {
+        FILE_Pack_Close( pPack ) ;
+    }
+
+    return dwResult ;
+}
+
+/**
+ * Closes a pack, the fonts read from it remain usable
+ */
+extern uint32_t FILE_Pack_Close( SFILEPack* pPack )
+{
+    if ( pPack == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( pPack->dwFile )
+    {
+        f_close( &pPack->file ) ;
+        pPack->dwFile=0 ;
+    }
+
+    pPack->dwEntries=0 ;
+    pPack->dwWindowLength=0 ;
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Reads the index entry of an asset, checking it lies within the pack
+ */
+extern uint32_t FILE_Pack_GetEntry( SFILEPack* pPack, uint32_t dwIndex, SFILEPackEntry* pEntry )
+{
+    uint32_t dwResult ;
+
+    if ( (pPack == NULL) || (pEntry == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( dwIndex >= pPack->dwEntries )
+    {
+        return SAMGUI_E_PACK_INDEX ;
+    }
+
+    dwResult=_FILE_Pack_Read( pPack, sizeof( SFILEPackHeader )+dwIndex*sizeof( SFILEPackEntry ), (uint8_t*)pEntry, sizeof( SFILEPackEntry ) ) ;
+    if ( dwResult != SAMGUI_E_OK )
+    {
+        return dwResult ;
+    }
+
+    if ( (pEntry->dwOffset > pPack->dwSize) || (pEntry->dwLength > pPack->dwSize-pEntry->dwOffset) )
+    {
+        return SAMGUI_E_PACK_FORMAT ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Draws a bitmap of the pack with its top left corner at (dwX, dwY).
+ *
+ * A raw bitmap mapped in memory is written in one DrawNative call. The others
+ * are decoded one row at a time in the row buffer, each opaque span of a row
+ * being written with one call; the transparent pixels of the icons are not
+ * written at all.
+ */
+extern uint32_t FILE_Pack_DrawBitmap( SFILEPack* pPack, SDISPBackend* pBE, uint32_t dwIndex, uint32_t dwX, uint32_t dwY )
+{
+    SFILEPackEntry entry ;
+    uint32_t dwNative=0 ;
+    uint32_t dwFormat=DISP_PIXEL_FORMAT_NONE ;
+    uint32_t dwLength=sizeof( dwFormat ) ;
+    uint32_t dwOffset ;
+    uint32_t dwEnd ;
+    uint32_t dwRow ;
+    uint32_t dwRows ;
+    uint32_t dwCol ;
+    uint32_t dwStart ;
+    uint32_t dwCount ;
+    uint8_t ucCode ;
+    uint8_t* puc ;
+    uint32_t dwResult ;
+
+    if ( (pPack == NULL) || (pBE == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    dwResult=FILE_Pack_GetEntry( pPack, dwIndex, &entry ) ;
+    if ( dwResult != SAMGUI_E_OK )
+    {
+        return dwResult ;
+    }
+
+    if ( entry.ucType != FILE_PACK_TYPE_BITMAP )
+    {
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+
+    if ( (entry.wWidth > FILE_PACK_MAX_WIDTH) || (pPack->dwPixelFormat != DISP_PIXEL_FORMAT_RGB666_3B) )
+    {
+        return SAMGUI_E_PACK_FORMAT ;
+    }
+
+    // Native drawing when the backend takes the pixel format of the pack
+    if ( (pBE->DrawNative != NULL) && (pBE->IOCtl != NULL) &&
+         (pBE->IOCtl( DISP_BACKEND_IOCTL_GET_PIXEL_FORMAT, &dwFormat, &dwLength ) == SAMGUI_E_OK) &&
+         (dwFormat == pPack->dwPixelFormat) )
+    {
+        dwNative=1 ;
+    }
+    else
+    {
+        if ( pBE->DrawBitmap == NULL )
+        {
+            return SAMGUI_E_WRONG_COMPONENT ;
+        }
+    }
+
+    if ( (entry.wWidth == 0) || (entry.wHeight == 0) )
+    {
+        return SAMGUI_E_OK ;
+    }
+
+    dwOffset=entry.dwOffset ;
+    dwEnd=entry.dwOffset+entry.dwLength ;
+
+    if ( (entry.ucFlags & FILE_PACK_FLAG_RLE) == 0 )
+    {
+        if ( entry.dwLength != entry.wWidth*entry.wHeight*3 )
+        {
+            return SAMGUI_E_PACK_FORMAT ;
+        }
+
+        if ( dwNative && (pPack->pucBase != NULL) )
+        {
+            return pBE->DrawNative( dwX, dwY, entry.wWidth, entry.wHeight, pPack->pucBase+dwOffset ) ;
+        }
+
+        // As many rows as the row buffer holds
+        for ( dwRow=0 ; dwRow < entry.wHeight ; dwRow+=dwRows )
+        {
+            dwRows=sizeof( pPack->aucRow )/(entry.wWidth*3) ;
+            if ( dwRows > entry.wHeight-dwRow )
+            {
+                dwRows=entry.wHeight-dwRow ;
+            }
+
+            dwResult=_FILE_Pack_Read( pPack, dwOffset, pPack->aucRow, dwRows*entry.wWidth*3 ) ;
+            if ( dwResult == SAMGUI_E_OK )
+            {
+                dwResult=_FILE_Pack_DrawSpan( pPack, pBE, dwNative, dwX, dwY+dwRow, entry.wWidth, dwRows, pPack->aucRow ) ;
+            }
+            if ( dwResult != SAMGUI_E_OK )
+            {
+                return dwResult ;
+            }
+            dwOffset+=dwRows*entry.wWidth*3 ;
+        }
+
+        return SAMGUI_E_OK ;
+    }
+
+    for ( dwRow=0 ; dwRow < entry.wHeight ; dwRow++ )
+    {
+        dwStart=0 ;
+
+        for ( dwCol=0 ; dwCol < entry.wWidth ; dwCol+=dwCount )
+        {
+            if ( dwOffset >= dwEnd )
+            {
+                return SAMGUI_E_PACK_FORMAT ;
+            }
+
+            dwResult=_FILE_Pack_Read( pPack, dwOffset++, &ucCode, 1 ) ;
+            if ( dwResult != SAMGUI_E_OK )
+            {
+                return dwResult ;
+            }
+
+            // Spans never cross the end of a row
+            dwCount=(ucCode & FILE_PACK_SPAN_COUNT_MASK)+1 ;
+            if ( dwCol+dwCount > entry.wWidth )
+            {
+                return SAMGUI_E_PACK_FORMAT ;
+            }
+
+            puc=&pPack->aucRow[dwCol*3] ;
+
+            switch ( ucCode & ~FILE_PACK_SPAN_COUNT_MASK )
+            {
+                case FILE_PACK_SPAN_LITERAL :
+                    if ( dwCount*3 > dwEnd-dwOffset )
+                    {
+                        return SAMGUI_E_PACK_FORMAT ;
+                    }
+                    dwResult=_FILE_Pack_Read( pPack, dwOffset, puc, dwCount*3 ) ;
+                    dwOffset+=dwCount*3 ;
+                break ;
+
+                case FILE_PACK_SPAN_RUN :
+                    if ( 3 > dwEnd-dwOffset )
+                    {
+                        return SAMGUI_E_PACK_FORMAT ;
+                    }
+                    dwResult=_FILE_Pack_Read( pPack, dwOffset, puc, 3 ) ;
+                    dwOffset+=3 ;
+
+                    for ( dwLength=3 ; dwLength < dwCount*3 ; dwLength++ )
+                    {
+                        puc[dwLength]=puc[dwLength-3] ;
+                    }
+                break ;
+
+                case FILE_PACK_SPAN_SKIP :
+                    // Write the opaque pixels before the transparent ones
+                    if ( dwCol > dwStart )
+                    {
+                        dwResult=_FILE_Pack_DrawSpan( pPack, pBE, dwNative, dwX+dwStart, dwY+dwRow, dwCol-dwStart, 1, &pPack->aucRow[dwStart*3] ) ;
+                    }
+                    dwStart=dwCol+dwCount ;
+                break ;
+
+                default :
+                    return SAMGUI_E_PACK_FORMAT ;
+            }
+
+            if ( dwResult != SAMGUI_E_OK )
+            {
+                return dwResult ;
+            }
+        }
+
+        if ( entry.wWidth > dwStart )
+        {
+            dwResult=_FILE_Pack_DrawSpan( pPack, pBE, dwNative, dwX+dwStart, dwY+dwRow, entry.wWidth-dwStart, 1, &pPack->aucRow[dwStart*3] ) ;
+            if ( dwResult != SAMGUI_E_OK )
+            {
+                return dwResult ;
+            }
+        }
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Fills a font with the glyphs of a pack entry. The glyphs of a memory
+ * mapped pack are used in place and pucBuffer may be NULL, else they are
+ * read into pucBuffer, which must then last as long as the font.
+ */
+extern uint32_t FILE_Pack_GetFont( SFILEPack* pPack, uint32_t dwIndex, SGUIFont* pFont, uint8_t* pucBuffer, uint32_t dwBufferSize )
+{
+    SFILEPackEntry entry ;
+    uint32_t dwResult ;
+
+    if ( (pPack == NULL) || (pFont == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    dwResult=FILE_Pack_GetEntry( pPack, dwIndex, &entry ) ;
+    if ( dwResult != SAMGUI_E_OK )
+    {
+        return dwResult ;
+    }
+
+    if ( entry.ucType != FILE_PACK_TYPE_FONT )
+    {
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+
+    // 96 glyphs of one 16-bit column per pixel
+    if ( (entry.wHeight > 16) || (entry.dwLength != 96*entry.wWidth*2) )
+    {
+        return SAMGUI_E_PACK_FORMAT ;
+    }
+
+    if ( pPack->pucBase != NULL )
+    {
+        pFont->pvData=(void*)(pPack->pucBase+entry.dwOffset) ;
+    }
+    else
+    {
+        if ( pucBuffer == NULL )
+        {
+            return SAMGUI_E_BAD_POINTER ;
+        }
+
+        if ( dwBufferSize < entry.dwLength )
+        {
+            return SAMGUI_E_BAD_PARAMETER ;
+        }
+
+        dwResult=_FILE_Pack_Read( pPack, entry.dwOffset, pucBuffer, entry.dwLength ) ;
+        if ( dwResult != SAMGUI_E_OK )
+        {
+            return dwResult ;
+        }
+        pFont->pvData=pucBuffer ;
+    }
+
+    pFont->dwType=WGT_FONT_TYPE_BITMAP ;
+    pFont->dwWidth=entry.wWidth ;
+    pFont->dwHeight=entry.wHeight ;
+
+    return SAMGUI_E_OK ;
+}
+
+/** @}
+ * @}
+ * @} */
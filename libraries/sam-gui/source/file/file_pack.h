@@ -0,0 +1,149 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef _SAMGUI_FILE_PACK_
+#define _SAMGUI_FILE_PACK_
+
+#include "source/file/file_fs.h"
+#include "source/disp/disp_backend.h"
+
+/**
+ * \addtogroup SAMGUI
+ * @{
+ *   \addtogroup SAMGUI_FILE FILE
+ *   @{
+ *     \addtogroup SAMGUI_FILE_PACK FILE Asset Pack
+ *     @{
+ *
+ * \brief Bitmaps, icons and fonts prepared offline in one indexed pack.
+ *
+ * file_pack.py converts the images and fonts of an application into one
+ * pack, with the indices of the assets in a generated header. The bitmaps
+ * are stored in the pixel format of the panel (DISP_PIXEL_FORMAT_xxx), raw
+ * or as RLE spans: literal pixels, runs of one pixel and, for the icons,
+ * transparent pixels. They are written with the backend DrawNative method,
+ * without any color conversion; a memory mapped raw bitmap goes to the panel
+ * in one call. The fonts hold the glyphs 0x20 to 0x7F in the layout of
+ * aucFont10x14, one 16-bit column per pixel.
+ *
+ * An asset is found from its index by reading its index entry, without any
+ * directory or name lookup. The pack is read in place from the internal
+ * flash (FILE_Pack_OpenMemory()), from a FatFs file (FILE_Pack_OpenFile())
+ * or through a read function, for a serial flash (FILE_Pack_Open()).
+ *
+ * A pack is not shared between tasks.
+ */
+
+/* Widest bitmap drawn */
+#ifndef FILE_PACK_MAX_WIDTH
+#  define FILE_PACK_MAX_WIDTH            320
+#endif
+
+/* Read window of the packs which are not memory mapped, in bytes */
+#ifndef FILE_PACK_WINDOW_SIZE
+#  define FILE_PACK_WINDOW_SIZE          256
+#endif
+
+#define FILE_PACK_MAGIC                  0x31504753UL // "SGP1"
+
+#define FILE_PACK_TYPE_BITMAP            0x01
+#define FILE_PACK_TYPE_FONT              0x02
+
+#define FILE_PACK_FLAG_RLE               0x01 // RLE spans, one row after the other
+#define FILE_PACK_FLAG_TRANSPARENT       0x02 // RLE spans with transparent pixels
+
+/* RLE span: 2-bit code and pixel count-1 (1 to 64 pixels), within a row */
+#define FILE_PACK_SPAN_LITERAL           0x00 // followed by count pixels
+#define FILE_PACK_SPAN_RUN               0x40 // followed by one pixel, repeated
+#define FILE_PACK_SPAN_SKIP              0x80 // transparent pixels
+#define FILE_PACK_SPAN_COUNT_MASK        0x3F
+
+/**
+ * Pack header, followed by the index
+ */
+typedef struct _SFILEPackHeader
+{
+    uint32_t dwMagic ;
+    uint16_t wEntries ;
+    uint16_t wPixelFormat ;      /* DISP_PIXEL_FORMAT_xxx of the bitmaps */
+    uint32_t dwSize ;            /* whole pack, in bytes */
+    uint32_t dwReserved ;
+} SFILEPackHeader ;
+
+/**
+ * Index entry, as stored in the pack
+ */
+typedef struct _SFILEPackEntry
+{
+    uint8_t ucType ;             /* FILE_PACK_TYPE_xxx */
+    uint8_t ucFlags ;            /* FILE_PACK_FLAG_xxx */
+    uint16_t wReserved ;
+    uint16_t wWidth ;            /* bitmap size, or font cell size */
+    uint16_t wHeight ;
+    uint32_t dwOffset ;          /* asset data, from the pack start */
+    uint32_t dwLength ;
+} SFILEPackEntry ;
+
+/** Reads dwSize bytes of the pack at dwOffset, returns SAMGUI_E_OK or an error */
+typedef uint32_t (*FILE_PackRead)( void* pvContext, uint32_t dwOffset, uint8_t* pucBuffer, uint32_t dwSize ) ;
+
+typedef struct _SFILEPack
+{
+    const uint8_t* pucBase ;     /* memory mapped pack, NULL when read through Read */
+    FILE_PackRead Read ;
+    void* pvContext ;
+    FIL file ;                   /* FILE_Pack_OpenFile() */
+    uint32_t dwFile ;            /* 1 when file is open */
+
+    uint32_t dwEntries ;
+    uint32_t dwPixelFormat ;
+    uint32_t dwSize ;
+
+    /* Read window */
+    uint32_t dwWindowOffset ;
+    uint32_t dwWindowLength ;
+    uint8_t aucWindow[FILE_PACK_WINDOW_SIZE] ;
+
+    /* One row of pixels */
+    uint8_t aucRow[FILE_PACK_MAX_WIDTH*3] ;
+} SFILEPack ;
+
+extern uint32_t FILE_Pack_OpenMemory( SFILEPack* pPack, const void* pvPack ) ;
+extern uint32_t FILE_Pack_OpenFile( SFILEPack* pPack, const char* pszPath ) ;
+extern uint32_t FILE_Pack_Open( SFILEPack* pPack, FILE_PackRead Read, void* pvContext ) ;
+extern uint32_t FILE_Pack_Close( SFILEPack* pPack ) ;
+extern uint32_t FILE_Pack_GetEntry( SFILEPack* pPack, uint32_t dwIndex, SFILEPackEntry* pEntry ) ;
+extern uint32_t FILE_Pack_DrawBitmap( SFILEPack* pPack, SDISPBackend* pBE, uint32_t dwIndex, uint32_t dwX, uint32_t dwY ) ;
+extern uint32_t FILE_Pack_GetFont( SFILEPack* pPack, uint32_t dwIndex, SGUIFont* pFont, uint8_t* pucBuffer, uint32_t dwBufferSize ) ;
+
+/** @}
+ * @}
+ * @} */
+
+#endif // _SAMGUI_FILE_PACK_
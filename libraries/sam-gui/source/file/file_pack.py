@@ -0,0 +1,271 @@
+#!/usr/bin/env python
+# ----------------------------------------------------------------------------
+#         ATMEL Microcontroller Software Support
+# ----------------------------------------------------------------------------
+# Copyright (c) 2009, Atmel Corporation
+#
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# - Redistributions of source code must retain the above copyright notice,
+# this list of conditions and the disclaimer below.
+#
+# Atmel's name may not be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+# IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+# DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+# OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+# EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+# ----------------------------------------------------------------------------
+
+"""Builds a sam-gui asset pack (file_pack.h) from images and fonts, with a
+header giving the index of each asset. Needs Pillow.
+
+    file_pack.py [-o assets.bin] [-H assets.h] [-c assets.c] [--rle] asset...
+
+Each asset is given as kind:name=file, the name giving the index define:
+
+    bitmap:LOGO=logo.png       opaque bitmap
+    icon:PLAY=play.png         bitmap whose transparent pixels are not drawn
+    font:BIG=DejaVuSans.ttf:12x16
+                               glyphs 0x20 to 0x7F in cells of 12x16 pixels
+
+The pixels are stored in the GRAM format of the ILI9325 (3 bytes R, G, B, 6
+upper bits). With --rle, the bitmaps are stored as RLE spans when that makes
+them smaller; the icons always are. The -c output holds the pack as a C
+array, to link it in the internal flash and open it with
+FILE_Pack_OpenMemory().
+"""
+
+import os
+import struct
+import sys
+
+PACK_MAGIC = 0x31504753                   # "SGP1"
+PIXEL_FORMAT_RGB666_3B = 0x01
+HEADER = struct.Struct('<IHHII')
+ENTRY = struct.Struct('<BBHHHII')
+
+TYPE_BITMAP = 0x01
+TYPE_FONT = 0x02
+FLAG_RLE = 0x01
+FLAG_TRANSPARENT = 0x02
+
+SPAN_LITERAL = 0x00
+SPAN_RUN = 0x40
+SPAN_SKIP = 0x80
+SPAN_MAX = 64
+
+MAX_WIDTH = 320                           # FILE_PACK_MAX_WIDTH
+FONT_FIRST = 0x20
+FONT_COUNT = 96
+
+
+def native(rgb):
+    """One pixel in the panel format; the 2 lower bits are kept clear, so
+    that a raw bitmap never starts like a BMP file or a path."""
+    return bytes((rgb[0] & 0xFC, rgb[1] & 0xFC, rgb[2] & 0xFC))
+
+
+def encode_row(pixels):
+    """RLE spans of one row, pixels being native pixels or None when
+    transparent. Runs of 2 identical pixels already save a byte."""
+    out = bytearray()
+    literal = []
+
+    def flush_literal():
+        while literal:
+            chunk = literal[:SPAN_MAX]
+            del literal[:SPAN_MAX]
+            out.append(SPAN_LITERAL | (len(chunk) - 1))
+            for pixel in chunk:
+                out.extend(pixel)
+
+    i = 0
+    while i < len(pixels):
+        j = i + 1
+        while j < len(pixels) and j - i < SPAN_MAX and pixels[j] == pixels[i]:
+            j += 1
+        if pixels[i] is None:
+            flush_literal()
+            out.append(SPAN_SKIP | (j - i - 1))
+        elif j - i >= 2:
+            flush_literal()
+            out.append(SPAN_RUN | (j - i - 1))
+            out.extend(pixels[i])
+        else:
+            literal.append(pixels[i])
+        i = j
+    flush_literal()
+    return bytes(out)
+
+
+def load_bitmap(path, transparent, rle):
+    from PIL import Image
+    image = Image.open(path).convert('RGBA')
+    width, height = image.size
+    if width > MAX_WIDTH or height > 0xFFFF:
+        raise ValueError('%s: %dx%d is too large' % (path, width, height))
+
+    data = image.load()
+    rows = []
+    for y in range(height):
+        row = []
+        for x in range(width):
+            pixel = data[x, y]
+            if transparent and pixel[3] < 128:
+                row.append(None)
+            else:
+                row.append(native(pixel))
+        rows.append(row)
+
+    if transparent:
+        return (FLAG_RLE | FLAG_TRANSPARENT, width, height,
+                b''.join(encode_row(row) for row in rows))
+
+    raw = b''.join(b''.join(row) for row in rows)
+    if rle:
+        spans = b''.join(encode_row(row) for row in rows)
+        if len(spans) < len(raw):
+            return (FLAG_RLE, width, height, spans)
+    return (0, width, height, raw)
+
+
+def load_font(path, cell):
+    """Glyphs in the layout of aucFont10x14: one 16-bit column per pixel,
+    most significant byte first, top row in the most significant bit."""
+    from PIL import Image, ImageDraw, ImageFont
+    width, height = [int(v) for v in cell.lower().split('x')]
+    if width < 1 or height < 1 or height > 16:
+        raise ValueError('%s: cell %s, height must be 1 to 16' % (path, cell))
+
+    font = ImageFont.truetype(path, height)
+    out = bytearray()
+    for code in range(FONT_FIRST, FONT_FIRST + FONT_COUNT):
+        glyph = Image.new('L', (width, height), 0)
+        ImageDraw.Draw(glyph).text((0, 0), chr(code), fill=255, font=font)
+        data = glyph.load()
+        for x in range(width):
+            bits = 0
+            for y in range(height):
+                if data[x, y] >= 128:
+                    bits |= 0x8000 >> y
+            out.extend(struct.pack('>H', bits))
+    return (0, width, height, bytes(out))
+
+
+def build(assets):
+    """Pack of (kind, name, type, flags, width, height, data) assets, each
+    asset data being aligned on 4 bytes."""
+    offset = HEADER.size + ENTRY.size * len(assets)
+    index = bytearray()
+    body = bytearray()
+    for (kind, name, type_, flags, width, height, data) in assets:
+        pad = -(offset + len(body)) % 4
+        body.extend(b'\0' * pad)
+        index.extend(ENTRY.pack(type_, flags, 0, width, height,
+                                offset + len(body), len(data)))
+        body.extend(data)
+    size = offset + len(body)
+    return HEADER.pack(PACK_MAGIC, len(assets), PIXEL_FORMAT_RGB666_3B,
+                       size, 0) + bytes(index) + bytes(body)
+
+
+def guard(path):
+    return '_' + ''.join(c if c.isalnum() else '_'
+                         for c in os.path.basename(path)).upper() + '_'
+
+
+def write_header(path, assets, prefix):
+    with open(path, 'w') as f:
+        f.write('/* Generated by file_pack.py, do not edit */\n\n')
+        f.write('#ifndef %s\n#define %s\n\n' % (guard(path), guard(path)))
+        for i, asset in enumerate(assets):
+            f.write('#define %-32s %d // %s %dx%d\n'
+                    % (prefix + asset[1], i, asset[0], asset[4], asset[5]))
+        f.write('\n#endif // %s\n' % guard(path))
+
+
+def write_source(path, pack, symbol):
+    with open(path, 'w') as f:
+        f.write('/* Generated by file_pack.py, do not edit */\n\n')
+        f.write('#include <stdint.h>\n\n')
+        f.write('const uint8_t %s[%d]=\n{\n' % (symbol, len(pack)))
+        for i in range(0, len(pack), 16):
+            f.write('    ' + ', '.join('0x%02X' % b for b in pack[i:i + 16])
+                    + ',\n')
+        f.write('} ;\n')
+
+
+def parse_asset(text, rle):
+    kind, sep, rest = text.partition(':')
+    name, sep2, spec = rest.partition('=')
+    if not sep or not sep2 or not name:
+        raise ValueError('%s: expected kind:name=file' % text)
+    if kind == 'bitmap' or kind == 'icon':
+        return (kind, name, TYPE_BITMAP) + load_bitmap(spec, kind == 'icon',
+                                                       rle)
+    if kind == 'font':
+        path, sep, cell = spec.rpartition(':')
+        if not sep:
+            raise ValueError('%s: expected font:name=file:WxH' % text)
+        return (kind, name, TYPE_FONT) + load_font(path, cell)
+    raise ValueError('%s: unknown kind %s' % (text, kind))
+
+
+def main(argv):
+    import optparse
+    parser = optparse.OptionParser(
+        usage='%prog [options] kind:name=file...')
+    parser.add_option('-o', '--output', default='assets.bin',
+                      help='pack file [%default]')
+    parser.add_option('-H', '--header', default=None,
+                      help='header with the asset indices')
+    parser.add_option('-c', '--c-source', default=None,
+                      help='C file holding the pack as an array')
+    parser.add_option('-s', '--symbol', default='aucAssetPack',
+                      help='array name in the C file [%default]')
+    parser.add_option('-p', '--prefix', default='PACK_',
+                      help='prefix of the index defines [%default]')
+    parser.add_option('-r', '--rle', action='store_true', default=False,
+                      help='store the bitmaps as RLE spans when smaller')
+    (options, args) = parser.parse_args(argv[1:])
+
+    if not args:
+        parser.error('give at least one asset')
+    if len(args) > 0xFFFF:
+        parser.error('too many assets')
+
+    try:
+        assets = [parse_asset(arg, options.rle) for arg in args]
+    except (IOError, ValueError) as e:
+        sys.stderr.write('file_pack.py: %s\n' % e)
+        return 1
+
+    pack = build(assets)
+    with open(options.output, 'wb') as f:
+        f.write(pack)
+    if options.header:
+        write_header(options.header, assets, options.prefix)
+    if options.c_source:
+        write_source(options.c_source, pack, options.symbol)
+
+    for (kind, name, type_, flags, width, height, data) in assets:
+        print('%-8s %-24s %4dx%-4d %7d bytes%s'
+              % (kind, name, width, height, len(data),
+                 ' rle' if flags & FLAG_RLE else ''))
+    print('%s: %d assets, %d bytes' % (options.output, len(assets), len(pack)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
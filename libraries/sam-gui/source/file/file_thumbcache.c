@@ -0,0 +1,775 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#include "libsam_gui.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <setjmp.h>
+
+#include "jpeglib.h"
+#include "jerror.h"
+
+/**
+ * \addtogroup SAMGUI
+ * @{
+ *   \addtogroup SAMGUI_FILE
+ *   @{
+ *     \addtogroup SAMGUI_FILE_THUMBCACHE FILE Thumbnail Cache
+ *     @{
+ *
+ * \brief JPEG thumbnails generated in the background and cached on FatFs.
+ */
+
+#define FILE_THUMBCACHE_MAGIC            0x31484354UL // "TCH1"
+
+/* Delay between two checks for work of the background task, in ms */
+#define FILE_THUMBCACHE_IDLE_DELAY       100
+
+/* Longest path of a scanned file, directory and separator included */
+#define FILE_THUMBCACHE_PATH_LENGTH      (64+FILE_THUMBCACHE_NAME_LENGTH)
+
+/**
+ * Cache file header, followed by the index and by the slots
+ */
+typedef struct _SFILEThumbHeader
+{
+    uint32_t dwMagic ;
+    uint16_t wWidth ;
+    uint16_t wHeight ;
+    uint16_t wEntries ;
+    uint16_t wEntrySize ;
+} SFILEThumbHeader ;
+
+#define FILE_THUMBCACHE_INDEX_OFFSET     sizeof( SFILEThumbHeader )
+#define FILE_THUMBCACHE_SLOT_SIZE        (FILE_THUMBCACHE_WIDTH*FILE_THUMBCACHE_HEIGHT*2)
+#define FILE_THUMBCACHE_SLOT_OFFSET( i ) (FILE_THUMBCACHE_INDEX_OFFSET+FILE_THUMBCACHE_MAX_ENTRIES*sizeof( SFILEThumbEntry )+(i)*FILE_THUMBCACHE_SLOT_SIZE)
+
+/**
+ * libjpeg source manager reading the scanned file
+ */
+typedef struct _SFILEThumbSource
+{
+    struct jpeg_source_mgr pub ;
+    SFILEThumbCache* pCache ;
+} SFILEThumbSource ;
+
+/**
+ * libjpeg error manager returning to the generator
+ */
+typedef struct _SFILEThumbError
+{
+    struct jpeg_error_mgr pub ;
+    jmp_buf jmpBuffer ;
+} SFILEThumbError ;
+
+static void _FILE_ThumbCache_Lock( SFILEThumbCache* pCache )
+{
+#if SAM_PORTING != SAM_PORTING_NONE
+    SAMGUI_SemaphoreTake( pCache->hMutex, SAMGUI_WAIT_FOREVER ) ;
+#endif // SAM_PORTING != SAM_PORTING_NONE
+}
+
+static void _FILE_ThumbCache_Unlock( SFILEThumbCache* pCache )
+{
+#if SAM_PORTING != SAM_PORTING_NONE
+    SAMGUI_SemaphoreRelease( pCache->hMutex ) ;
+#endif // SAM_PORTING != SAM_PORTING_NONE
+}
+
+/**
+ * Reads or writes a block of the cache file, the lock being held
+ */
+static uint32_t _FILE_ThumbCache_Read( SFILEThumbCache* pCache, uint32_t dwOffset, void* pvData, uint32_t dwSize )
+{
+    UINT uLength ;
+
+    if ( (f_lseek( &pCache->file, dwOffset ) != FR_OK) ||
+         (f_read( &pCache->file, pvData, dwSize, &uLength ) != FR_OK) || (uLength != dwSize) )
+    {
+        return SAMGUI_E_FILE_READ ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+static uint32_t _FILE_ThumbCache_Write( SFILEThumbCache* pCache, uint32_t dwOffset, const void* pvData, uint32_t dwSize )
+{
+    UINT uLength ;
+
+    if ( (f_lseek( &pCache->file, dwOffset ) != FR_OK) ||
+         (f_write( &pCache->file, pvData, dwSize, &uLength ) != FR_OK) || (uLength != dwSize) )
+    {
+        return SAMGUI_E_FILE_WRITE ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Writes one index entry, or the whole index for dwIndex equal to
+ * FILE_THUMBCACHE_MAX_ENTRIES, and commits the file
+ */
+static uint32_t _FILE_ThumbCache_WriteIndex( SFILEThumbCache* pCache, uint32_t dwIndex )
+{
+    uint32_t dwResult ;
+
+    if ( dwIndex < FILE_THUMBCACHE_MAX_ENTRIES )
+    {
+        dwResult=_FILE_ThumbCache_Write( pCache, FILE_THUMBCACHE_INDEX_OFFSET+dwIndex*sizeof( SFILEThumbEntry ),
+                                         &pCache->aEntries[dwIndex], sizeof( SFILEThumbEntry ) ) ;
+    }
+    else
+    {
+        dwResult=_FILE_ThumbCache_Write( pCache, FILE_THUMBCACHE_INDEX_OFFSET, pCache->aEntries, sizeof( pCache->aEntries ) ) ;
+    }
+
+    if ( (dwResult == SAMGUI_E_OK) && (f_sync( &pCache->file ) != FR_OK) )
+    {
+        dwResult=SAMGUI_E_FILE_WRITE ;
+    }
+
+    return dwResult ;
+}
+
+/**
+ * Finds the entry of a file name, FILE_THUMBCACHE_MAX_ENTRIES if there is none
+ */
+static uint32_t _FILE_ThumbCache_Find( SFILEThumbCache* pCache, const char* pszName )
+{
+    uint32_t dw ;
+
+    for ( dw=0 ; dw < FILE_THUMBCACHE_MAX_ENTRIES ; dw++ )
+    {
+        if ( (pCache->aEntries[dw].dwState != FILE_THUMB_FREE) && (strcmp( pCache->aEntries[dw].szName, pszName ) == 0) )
+        {
+            break ;
+        }
+    }
+
+    return dw ;
+}
+
+/**
+ * Checks whether a file name has the .jpg or .jpeg extension
+ */
+static uint32_t _FILE_ThumbCache_IsJpegFile( const char* pszName )
+{
+    const char* pszExt=strrchr( pszName, '.' ) ;
+    char szExt[6] ;
+    uint32_t dw ;
+
+    if ( (pszExt == NULL) || (strlen( pszExt ) >= sizeof( szExt )) )
+    {
+        return 0 ;
+    }
+
+    for ( dw=0 ; pszExt[dw] != 0 ; dw++ )
+    {
+        szExt[dw]=(char)toupper( (int)pszExt[dw] ) ;
+    }
+    szExt[dw]=0 ;
+
+    return (strcmp( szExt, ".JPG" ) == 0) || (strcmp( szExt, ".JPEG" ) == 0) ;
+}
+
+/**
+ * Compares the directory with the index: entries of removed files are freed,
+ * new and modified files get a pending entry. The whole index is written back.
+ */
+static uint32_t _FILE_ThumbCache_Scan( SFILEThumbCache* pCache )
+{
+    FILINFO fno ;
+    DIR dir ;
+    char* pszName ;
+    SFILEThumbEntry* pEntry ;
+    uint32_t dwIndex ;
+    uint32_t dwResult ;
+#if _USE_LFN
+    static char lfn[_MAX_LFN * (_DF1S ? 2 : 1) + 1] ;
+    fno.lfname=lfn ;
+    fno.lfsize=sizeof( lfn ) ;
+#endif
+
+    memset( pCache->adwSeen, 0, sizeof( pCache->adwSeen ) ) ;
+
+    _FILE_ThumbCache_Lock( pCache ) ;
+
+    if ( f_opendir( &dir, pCache->pszDirectory ) != FR_OK )
+    {
+        _FILE_ThumbCache_Unlock( pCache ) ;
+        return SAMGUI_E_FILE_OPEN ;
+    }
+
+    while ( (f_readdir( &dir, &fno ) == FR_OK) && (fno.fname[0] != 0) )
+    {
+#if _USE_LFN
+        pszName=*fno.lfname ? fno.lfname : fno.fname ;
+#else
+        pszName=fno.fname ;
+#endif
+        if ( (fno.fattrib & AM_DIR) || !_FILE_ThumbCache_IsJpegFile( pszName ) || (strlen( pszName ) >= FILE_THUMBCACHE_NAME_LENGTH) )
+        {
+            continue ;
+        }
+
+        dwIndex=_FILE_ThumbCache_Find( pCache, pszName ) ;
+        if ( dwIndex == FILE_THUMBCACHE_MAX_ENTRIES )
+        {
+            // New file, take a free slot if any is left
+            for ( dwIndex=0 ; dwIndex < FILE_THUMBCACHE_MAX_ENTRIES ; dwIndex++ )
+            {
+                if ( pCache->aEntries[dwIndex].dwState == FILE_THUMB_FREE )
+                {
+                    break ;
+                }
+            }
+
+            if ( dwIndex == FILE_THUMBCACHE_MAX_ENTRIES )
+            {
+                continue ;
+            }
+
+            pEntry=&pCache->aEntries[dwIndex] ;
+            memset( pEntry, 0, sizeof( SFILEThumbEntry ) ) ;
+            strcpy( pEntry->szName, pszName ) ;
+            pEntry->dwState=FILE_THUMB_PENDING ;
+        }
+
+        // Modified file, its slot is generated again
+        pEntry=&pCache->aEntries[dwIndex] ;
+        if ( (pEntry->dwSize != fno.fsize) || (pEntry->wDate != fno.fdate) || (pEntry->wTime != fno.ftime) )
+        {
+            pEntry->dwSize=fno.fsize ;
+            pEntry->wDate=fno.fdate ;
+            pEntry->wTime=fno.ftime ;
+            pEntry->dwState=FILE_THUMB_PENDING ;
+        }
+
+        pCache->adwSeen[dwIndex/32] |= 1UL << (dwIndex%32) ;
+    }
+
+    // Free the entries of the files which are gone, and count the pending ones
+    pCache->dwPending=0 ;
+    for ( dwIndex=0 ; dwIndex < FILE_THUMBCACHE_MAX_ENTRIES ; dwIndex++ )
+    {
+        if ( !(pCache->adwSeen[dwIndex/32] & (1UL << (dwIndex%32))) )
+        {
+            memset( &pCache->aEntries[dwIndex], 0, sizeof( SFILEThumbEntry ) ) ;
+        }
+        else if ( pCache->aEntries[dwIndex].dwState == FILE_THUMB_PENDING )
+        {
+            pCache->dwPending++ ;
+        }
+    }
+
+    dwResult=_FILE_ThumbCache_WriteIndex( pCache, FILE_THUMBCACHE_MAX_ENTRIES ) ;
+
+    _FILE_ThumbCache_Unlock( pCache ) ;
+
+    return dwResult ;
+}
+
+/**
+ * Source manager methods, reading the scanned file 512 bytes at a time
+ */
+static void _FILE_ThumbCache_SourceInit( j_decompress_ptr cinfo )
+{
+}
+
+static boolean _FILE_ThumbCache_SourceFill( j_decompress_ptr cinfo )
+{
+    SFILEThumbSource* pSource=(SFILEThumbSource*)cinfo->src ;
+    SFILEThumbCache* pCache=pSource->pCache ;
+    UINT uLength=0 ;
+
+    _FILE_ThumbCache_Lock( pCache ) ;
+    if ( f_read( &pCache->source, pCache->aucInput, sizeof( pCache->aucInput ), &uLength ) != FR_OK )
+    {
+        uLength=0 ;
+    }
+    _FILE_ThumbCache_Unlock( pCache ) ;
+
+    if ( uLength == 0 )
+    {
+        // Insert a fake EOI marker, as jdatasrc.c does
+        WARNMS( cinfo, JWRN_JPEG_EOF ) ;
+        pCache->aucInput[0]=(JOCTET)0xFF ;
+        pCache->aucInput[1]=(JOCTET)JPEG_EOI ;
+        uLength=2 ;
+    }
+
+    pSource->pub.next_input_byte=pCache->aucInput ;
+    pSource->pub.bytes_in_buffer=uLength ;
+
+    return TRUE ;
+}
+
+static void _FILE_ThumbCache_SourceSkip( j_decompress_ptr cinfo, long lBytes )
+{
+    struct jpeg_source_mgr* pSrc=cinfo->src ;
+
+    if ( lBytes <= 0 )
+    {
+        return ;
+    }
+
+    while ( lBytes > (long)pSrc->bytes_in_buffer )
+    {
+        lBytes-=(long)pSrc->bytes_in_buffer ;
+        (void)(*pSrc->fill_input_buffer)( cinfo ) ;
+    }
+
+    pSrc->next_input_byte+=(size_t)lBytes ;
+    pSrc->bytes_in_buffer-=(size_t)lBytes ;
+}
+
+static void _FILE_ThumbCache_SourceTerm( j_decompress_ptr cinfo )
+{
+}
+
+/**
+ * Error manager exit method, printing the message and aborting the thumbnail
+ */
+static void _FILE_ThumbCache_ErrorExit( j_common_ptr cinfo )
+{
+    SFILEThumbError* pError=(SFILEThumbError*)cinfo->err ;
+
+    (*cinfo->err->output_message)( cinfo ) ;
+    longjmp( pError->jmpBuffer, 1 ) ;
+}
+
+/**
+ * Decodes a JPEG file at 1/8 scale and writes its RGB565 thumbnail in the slot
+ * of its entry, one row at a time. Every n-th pixel of every n-th row is kept,
+ * n being the smallest step fitting the 1/8 image in the slot.
+ */
+static uint32_t _FILE_ThumbCache_Generate( SFILEThumbCache* pCache, uint32_t dwIndex )
+{
+    struct jpeg_decompress_struct cinfo ;
+    SFILEThumbSource source ;
+    SFILEThumbError error ;
+    SFILEThumbEntry* pEntry=&pCache->aEntries[dwIndex] ;
+    char szPath[FILE_THUMBCACHE_PATH_LENGTH] ;
+    JSAMPROW pRow=pCache->aucDecodedRow ;
+    uint8_t* pucPixel ;
+    uint32_t dwStep ;
+    uint32_t dwWidth ;
+    uint32_t dwHeight ;
+    uint32_t dwCol ;
+    uint32_t dwLine ;
+    uint32_t dwResult ;
+
+    if ( strlen( pCache->pszDirectory )+1+strlen( pEntry->szName ) >= sizeof( szPath ) )
+    {
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+    if ( pCache->pszDirectory[0] == 0 )
+    {
+        strcpy( szPath, pEntry->szName ) ;
+    }
+    else
+    {
+        sprintf( szPath, "%s/%s", pCache->pszDirectory, pEntry->szName ) ;
+    }
+
+    _FILE_ThumbCache_Lock( pCache ) ;
+    dwResult=f_open( &pCache->source, szPath, FA_OPEN_EXISTING|FA_READ ) ;
+    _FILE_ThumbCache_Unlock( pCache ) ;
+
+    if ( dwResult != FR_OK )
+    {
+        return SAMGUI_E_FILE_OPEN ;
+    }
+
+    cinfo.err=jpeg_std_error( &error.pub ) ;
+    error.pub.error_exit=_FILE_ThumbCache_ErrorExit ;
+    if ( setjmp( error.jmpBuffer ) )
+    {
+        jpeg_destroy_decompress( &cinfo ) ;
+        _FILE_ThumbCache_Lock( pCache ) ;
+        f_close( &pCache->source ) ;
+        _FILE_ThumbCache_Unlock( pCache ) ;
+
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+
+    jpeg_create_decompress( &cinfo ) ;
+
+    source.pub.init_source=_FILE_ThumbCache_SourceInit ;
+    source.pub.fill_input_buffer=_FILE_ThumbCache_SourceFill ;
+    source.pub.skip_input_data=_FILE_ThumbCache_SourceSkip ;
+    source.pub.resync_to_restart=jpeg_resync_to_restart ;
+    source.pub.term_source=_FILE_ThumbCache_SourceTerm ;
+    source.pub.bytes_in_buffer=0 ;
+    source.pub.next_input_byte=NULL ;
+    source.pCache=pCache ;
+    cinfo.src=&source.pub ;
+
+    jpeg_read_header( &cinfo, TRUE ) ;
+    cinfo.out_color_space=JCS_RGB ;
+    cinfo.scale_num=1 ;
+    cinfo.scale_denom=8 ;
+    cinfo.do_fancy_upsampling=FALSE ;
+    cinfo.dct_method=JDCT_IFAST ;
+    jpeg_start_decompress( &cinfo ) ;
+
+    if ( (cinfo.output_width > FILE_THUMBCACHE_MAX_DECODE_WIDTH) || (cinfo.output_components != 3) )
+    {
+        ERREXIT( &cinfo, JERR_WIDTH_OVERFLOW ) ;
+    }
+
+    dwStep=(cinfo.output_width+FILE_THUMBCACHE_WIDTH-1)/FILE_THUMBCACHE_WIDTH ;
+    if ( dwStep < (cinfo.output_height+FILE_THUMBCACHE_HEIGHT-1)/FILE_THUMBCACHE_HEIGHT )
+    {
+        dwStep=(cinfo.output_height+FILE_THUMBCACHE_HEIGHT-1)/FILE_THUMBCACHE_HEIGHT ;
+    }
+    dwWidth=(cinfo.output_width+dwStep-1)/dwStep ;
+    dwHeight=(cinfo.output_height+dwStep-1)/dwStep ;
+
+    for ( dwLine=0 ; dwLine < dwHeight ; dwLine++ )
+    {
+        // Skip the rows between two kept rows
+        do
+        {
+            jpeg_read_scanlines( &cinfo, &pRow, 1 ) ;
+        } while ( (cinfo.output_scanline-1)%dwStep != 0 ) ;
+
+        for ( dwCol=0, pucPixel=pCache->aucDecodedRow ; dwCol < dwWidth ; dwCol++, pucPixel+=dwStep*3 )
+        {
+            pCache->awThumbRow[dwCol]=(uint16_t)(((pucPixel[0] & 0xf8) << 8) | ((pucPixel[1] & 0xfc) << 3) | (pucPixel[2] >> 3)) ;
+        }
+
+        _FILE_ThumbCache_Lock( pCache ) ;
+        dwResult=_FILE_ThumbCache_Write( pCache, FILE_THUMBCACHE_SLOT_OFFSET( dwIndex )+dwLine*dwWidth*2, pCache->awThumbRow, dwWidth*2 ) ;
+        _FILE_ThumbCache_Unlock( pCache ) ;
+
+        if ( dwResult != SAMGUI_E_OK )
+        {
+            break ;
+        }
+    }
+
+    // The remaining rows are not needed
+    jpeg_abort_decompress( &cinfo ) ;
+    jpeg_destroy_decompress( &cinfo ) ;
+
+    _FILE_ThumbCache_Lock( pCache ) ;
+    f_close( &pCache->source ) ;
+    if ( dwResult == SAMGUI_E_OK )
+    {
+        pEntry->wWidth=(uint16_t)dwWidth ;
+        pEntry->wHeight=(uint16_t)dwHeight ;
+        pEntry->dwState=FILE_THUMB_READY ;
+        dwResult=_FILE_ThumbCache_WriteIndex( pCache, dwIndex ) ;
+    }
+    _FILE_ThumbCache_Unlock( pCache ) ;
+
+    return dwResult ;
+}
+
+/**
+ * Opens the cache of a directory, creating the cache file or starting it over
+ * when it does not match the configured layout, and requests a first scan.
+ *
+ * \param pszDirectory  Scanned directory, "" or STR_ROOT_DIRECTORY for the root.
+ * \param pszCacheFile  Cache file path, it should not have a .jpg extension.
+ * \param dwNotifyMsg   WGT message posted when a thumbnail is ready, with the
+ *                      entry index and the cache, 0 for none.
+ */
+extern uint32_t FILE_ThumbCache_Open( SFILEThumbCache* pCache, const char* pszDirectory, const char* pszCacheFile, uint32_t dwNotifyMsg )
+{
+    SFILEThumbHeader header ;
+    uint32_t dwIndex ;
+    uint32_t dwResult ;
+
+    if ( (pCache == NULL) || (pszDirectory == NULL) || (pszCacheFile == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    memset( pCache, 0, sizeof( SFILEThumbCache ) ) ;
+    pCache->pszDirectory=pszDirectory ;
+    pCache->pszCacheFile=pszCacheFile ;
+    pCache->dwNotifyMsg=dwNotifyMsg ;
+
+#if SAM_PORTING != SAM_PORTING_NONE
+    pCache->hMutex=SAMGUI_SemaphoreCreate() ;
+    if ( pCache->hMutex == NULL )
+    {
+        return SAMGUI_E_OS_SEM_CREATE_FAILED ;
+    }
+#endif // SAM_PORTING != SAM_PORTING_NONE
+
+    if ( f_open( &pCache->file, pszCacheFile, FA_OPEN_ALWAYS|FA_READ|FA_WRITE ) != FR_OK )
+    {
+        return SAMGUI_E_FILE_OPEN ;
+    }
+
+    // Check that the index was written with the same layout
+    if ( (_FILE_ThumbCache_Read( pCache, 0, &header, sizeof( header ) ) != SAMGUI_E_OK) ||
+         (header.dwMagic != FILE_THUMBCACHE_MAGIC) ||
+         (header.wWidth != FILE_THUMBCACHE_WIDTH) || (header.wHeight != FILE_THUMBCACHE_HEIGHT) ||
+         (header.wEntries != FILE_THUMBCACHE_MAX_ENTRIES) || (header.wEntrySize != sizeof( SFILEThumbEntry )) ||
+         (_FILE_ThumbCache_Read( pCache, FILE_THUMBCACHE_INDEX_OFFSET, pCache->aEntries, sizeof( pCache->aEntries ) ) != SAMGUI_E_OK) )
+    {
+        memset( pCache->aEntries, 0, sizeof( pCache->aEntries ) ) ;
+
+        header.dwMagic=FILE_THUMBCACHE_MAGIC ;
+        header.wWidth=FILE_THUMBCACHE_WIDTH ;
+        header.wHeight=FILE_THUMBCACHE_HEIGHT ;
+        header.wEntries=FILE_THUMBCACHE_MAX_ENTRIES ;
+        header.wEntrySize=sizeof( SFILEThumbEntry ) ;
+
+        if ( (f_lseek( &pCache->file, 0 ) != FR_OK) || (f_truncate( &pCache->file ) != FR_OK) )
+        {
+            f_close( &pCache->file ) ;
+            return SAMGUI_E_FILE_WRITE ;
+        }
+
+        dwResult=_FILE_ThumbCache_Write( pCache, 0, &header, sizeof( header ) ) ;
+        if ( dwResult == SAMGUI_E_OK )
+        {
+            dwResult=_FILE_ThumbCache_WriteIndex( pCache, FILE_THUMBCACHE_MAX_ENTRIES ) ;
+        }
+
+        if ( dwResult != SAMGUI_E_OK )
+        {
+            f_close( &pCache->file ) ;
+            return dwResult ;
+        }
+    }
+
+    for ( dwIndex=0 ; dwIndex < FILE_THUMBCACHE_MAX_ENTRIES ; dwIndex++ )
+    {
+        // A thumbnail interrupted by a reset is generated again
+        if ( pCache->aEntries[dwIndex].dwState == FILE_THUMB_PENDING )
+        {
+            pCache->dwPending++ ;
+        }
+    }
+
+    pCache->dwRefresh=1 ;
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Closes the cache file, the background task must not use the cache anymore
+ */
+extern uint32_t FILE_ThumbCache_Close( SFILEThumbCache* pCache )
+{
+    if ( pCache == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    _FILE_ThumbCache_Lock( pCache ) ;
+    f_close( &pCache->file ) ;
+    _FILE_ThumbCache_Unlock( pCache ) ;
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Requests a directory scan, to be called when files may have been added,
+ * modified or removed. The scan is done by the next FILE_ThumbCache_Process().
+ */
+extern uint32_t FILE_ThumbCache_Refresh( SFILEThumbCache* pCache )
+{
+    if ( pCache == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    pCache->dwRefresh=1 ;
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Does one step of background work: the requested directory scan, or else the
+ * generation of one pending thumbnail.
+ *
+ * \return SAMGUI_E_OK after a step, SAMGUI_E_THUMB_IDLE when there is nothing
+ * to do, or the error of a failed scan.
+ */
+extern uint32_t FILE_ThumbCache_Process( SFILEThumbCache* pCache )
+{
+    uint32_t dwIndex ;
+
+    if ( pCache == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( pCache->dwRefresh )
+    {
+        pCache->dwRefresh=0 ;
+
+        return _FILE_ThumbCache_Scan( pCache ) ;
+    }
+
+    if ( pCache->dwPending == 0 )
+    {
+        return SAMGUI_E_THUMB_IDLE ;
+    }
+
+    for ( dwIndex=0 ; dwIndex < FILE_THUMBCACHE_MAX_ENTRIES ; dwIndex++ )
+    {
+        if ( pCache->aEntries[dwIndex].dwState == FILE_THUMB_PENDING )
+        {
+            break ;
+        }
+    }
+
+    pCache->dwPending-- ;
+    if ( dwIndex == FILE_THUMBCACHE_MAX_ENTRIES )
+    {
+        pCache->dwPending=0 ;
+
+        return SAMGUI_E_THUMB_IDLE ;
+    }
+
+    if ( _FILE_ThumbCache_Generate( pCache, dwIndex ) == SAMGUI_E_OK )
+    {
+        if ( pCache->dwNotifyMsg != 0 )
+        {
+            WGT_PostMessage( pCache->dwNotifyMsg, dwIndex, (uint32_t)pCache ) ;
+        }
+    }
+    else
+    {
+        // Not retried until the file changes
+        _FILE_ThumbCache_Lock( pCache ) ;
+        pCache->aEntries[dwIndex].dwState=FILE_THUMB_FAILED ;
+        _FILE_ThumbCache_WriteIndex( pCache, dwIndex ) ;
+        _FILE_ThumbCache_Unlock( pCache ) ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+#if SAM_PORTING != SAM_PORTING_NONE
+/**
+ * Background task body, pvParam being the cache. It should run at a lower
+ * priority than the GUI task.
+ */
+extern void FILE_ThumbCache_Task( void* pvParam )
+{
+    SFILEThumbCache* pCache=(SFILEThumbCache*)pvParam ;
+
+    for ( ; ; )
+    {
+        if ( FILE_ThumbCache_Process( pCache ) != SAMGUI_E_OK )
+        {
+            SAMGUI_TaskDelay( FILE_THUMBCACHE_IDLE_DELAY ) ;
+        }
+    }
+}
+#endif // SAM_PORTING != SAM_PORTING_NONE
+
+/**
+ * Draws the thumbnail of a file centered in the FILE_THUMBCACHE_WIDTH x
+ * FILE_THUMBCACHE_HEIGHT cell at dwX, dwY, FILE_THUMBCACHE_DRAW_ROWS rows per
+ * backend call. The cell around the thumbnail is not painted.
+ *
+ * \return SAMGUI_E_THUMB_NOT_READY if the thumbnail is not generated yet or
+ * the file cannot be decoded.
+ */
+extern uint32_t FILE_ThumbCache_Draw( SFILEThumbCache* pCache, SDISPBackend* pBE, const char* pszName, uint32_t dwX, uint32_t dwY )
+{
+    uint16_t* pwPixel ;
+    uint8_t* pucPixel ;
+    uint32_t dwIndex ;
+    uint32_t dwWidth ;
+    uint32_t dwHeight ;
+    uint32_t dwRow ;
+    uint32_t dwRows ;
+    uint32_t dw ;
+    uint32_t dwResult=SAMGUI_E_OK ;
+
+    if ( (pCache == NULL) || (pBE == NULL) || (pszName == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    _FILE_ThumbCache_Lock( pCache ) ;
+    dwIndex=_FILE_ThumbCache_Find( pCache, pszName ) ;
+    if ( (dwIndex == FILE_THUMBCACHE_MAX_ENTRIES) || (pCache->aEntries[dwIndex].dwState != FILE_THUMB_READY) )
+    {
+        _FILE_ThumbCache_Unlock( pCache ) ;
+        return SAMGUI_E_THUMB_NOT_READY ;
+    }
+    dwWidth=pCache->aEntries[dwIndex].wWidth ;
+    dwHeight=pCache->aEntries[dwIndex].wHeight ;
+    _FILE_ThumbCache_Unlock( pCache ) ;
+
+    dwX+=(FILE_THUMBCACHE_WIDTH-dwWidth)/2 ;
+    dwY+=(FILE_THUMBCACHE_HEIGHT-dwHeight)/2 ;
+
+    for ( dwRow=0 ; dwRow < dwHeight ; dwRow+=dwRows )
+    {
+        dwRows=dwHeight-dwRow ;
+        if ( dwRows > FILE_THUMBCACHE_DRAW_ROWS )
+        {
+            dwRows=FILE_THUMBCACHE_DRAW_ROWS ;
+        }
+
+        _FILE_ThumbCache_Lock( pCache ) ;
+        dwResult=_FILE_ThumbCache_Read( pCache, FILE_THUMBCACHE_SLOT_OFFSET( dwIndex )+dwRow*dwWidth*2, pCache->awDrawRows, dwRows*dwWidth*2 ) ;
+        _FILE_ThumbCache_Unlock( pCache ) ;
+
+        if ( dwResult != SAMGUI_E_OK )
+        {
+            break ;
+        }
+
+        // Expand to the raw RGB format of DrawBitmap. The low bits are left
+        // cleared, the panel only keeps 6 bits per component, and a first
+        // pixel can then never read as a "BM" or "/" bitmap signature.
+        pwPixel=pCache->awDrawRows ;
+        pucPixel=pCache->aucDrawRows ;
+        for ( dw=0 ; dw < dwRows*dwWidth ; dw++, pwPixel++ )
+        {
+            *pucPixel++=(uint8_t)((*pwPixel >> 8) & 0xf8) ;
+            *pucPixel++=(uint8_t)((*pwPixel >> 3) & 0xfc) ;
+            *pucPixel++=(uint8_t)(*pwPixel << 3) ;
+        }
+
+        pBE->DrawBitmap( dwX, dwY+dwRow, dwWidth, dwRows, pCache->aucDrawRows ) ;
+    }
+
+    return dwResult ;
+}
+
+/** @}
+ * @}
+ * @} */
@@ -0,0 +1,151 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef _SAMGUI_FILE_THUMBCACHE_
+#define _SAMGUI_FILE_THUMBCACHE_
+
+#include "source/porting/sam_gui_porting.h"
+#include "source/file/file_fs.h"
+#include "source/disp/disp_backend.h"
+
+/**
+ * \addtogroup SAMGUI
+ * @{
+ *   \addtogroup SAMGUI_FILE FILE
+ *   @{
+ *     \addtogroup SAMGUI_FILE_THUMBCACHE FILE Thumbnail Cache
+ *     @{
+ *
+ * \brief Cache of JPEG thumbnails kept in a file of the FAT volume.
+ *
+ * The thumbnails of the JPEG files of one directory are decoded once with the
+ * libjpeg 1/8 scaling, reduced to fit FILE_THUMBCACHE_WIDTH x
+ * FILE_THUMBCACHE_HEIGHT and stored as RGB565 in the cache file. The file
+ * starts with an index of FILE_THUMBCACHE_MAX_ENTRIES entries keyed by file
+ * name, size and date, followed by one fixed size slot per entry, so that a
+ * changed file only rewrites its own slot.
+ *
+ * FILE_ThumbCache_Refresh() asks for a directory scan; FILE_ThumbCache_Process()
+ * then compares the directory with the index, frees the entries of removed
+ * files and schedules the new and modified ones, and generates one thumbnail
+ * per call. It is meant for a low priority task (FILE_ThumbCache_Task()) or,
+ * without RTOS, for the idle time of the main loop. The GUI task draws the
+ * ready thumbnails with FILE_ThumbCache_Draw(), the others return
+ * SAMGUI_E_THUMB_NOT_READY and can be drawn when the notification message
+ * arrives.
+ *
+ * With an RTOS, the cache serializes its own FatFs calls with a mutex. Other
+ * tasks using the volume at the same time need FatFs built with _FS_REENTRANT.
+ */
+
+#ifndef FILE_THUMBCACHE_WIDTH
+#  define FILE_THUMBCACHE_WIDTH          80
+#endif
+
+#ifndef FILE_THUMBCACHE_HEIGHT
+#  define FILE_THUMBCACHE_HEIGHT         60
+#endif
+
+#ifndef FILE_THUMBCACHE_MAX_ENTRIES
+#  define FILE_THUMBCACHE_MAX_ENTRIES    64
+#endif
+
+/* Widest 1/8 scaled image accepted, 5120 pixels wide files */
+#ifndef FILE_THUMBCACHE_MAX_DECODE_WIDTH
+#  define FILE_THUMBCACHE_MAX_DECODE_WIDTH  640
+#endif
+
+/* Longest file name, longer names are not cached */
+#define FILE_THUMBCACHE_NAME_LENGTH      32
+
+/* Thumbnail rows sent to the backend per DrawBitmap call */
+#define FILE_THUMBCACHE_DRAW_ROWS        8
+
+typedef enum _eFILEThumb_State
+{
+    FILE_THUMB_FREE,      // 0, slot unused
+    FILE_THUMB_PENDING,   // file scanned, thumbnail to generate
+    FILE_THUMB_READY,
+    FILE_THUMB_FAILED     // not decodable, retried once the file changes
+} eFILEThumb_State ;
+
+/**
+ * Index entry, as stored in the cache file
+ */
+typedef struct _SFILEThumbEntry
+{
+    char szName[FILE_THUMBCACHE_NAME_LENGTH] ;
+    uint32_t dwSize ;
+    uint16_t wDate ;
+    uint16_t wTime ;
+    uint16_t wWidth ;
+    uint16_t wHeight ;
+    uint32_t dwState ;
+} SFILEThumbEntry ;
+
+typedef struct _SFILEThumbCache
+{
+    const char* pszDirectory ;
+    const char* pszCacheFile ;
+    FIL file ;
+
+#if SAM_PORTING != SAM_PORTING_NONE
+    SAMGUI_SemaphoreHandle hMutex ;
+#endif // SAM_PORTING != SAM_PORTING_NONE
+
+    uint32_t dwNotifyMsg ;       /* message posted when a thumbnail is ready, 0 for none */
+    uint32_t dwRefresh ;         /* 1 when a directory scan is requested */
+    uint32_t dwPending ;         /* thumbnails left to generate */
+
+    SFILEThumbEntry aEntries[FILE_THUMBCACHE_MAX_ENTRIES] ;
+    uint32_t adwSeen[(FILE_THUMBCACHE_MAX_ENTRIES+31)/32] ;
+
+    /* Generator buffers, background task */
+    FIL source ;
+    uint8_t aucInput[512] ;
+    uint8_t aucDecodedRow[FILE_THUMBCACHE_MAX_DECODE_WIDTH*3] ;
+    uint16_t awThumbRow[FILE_THUMBCACHE_WIDTH] ;
+
+    /* Blitter buffers, GUI task */
+    uint16_t awDrawRows[FILE_THUMBCACHE_WIDTH*FILE_THUMBCACHE_DRAW_ROWS] ;
+    uint8_t aucDrawRows[FILE_THUMBCACHE_WIDTH*FILE_THUMBCACHE_DRAW_ROWS*3] ;
+} SFILEThumbCache ;
+
+extern uint32_t FILE_ThumbCache_Open( SFILEThumbCache* pCache, const char* pszDirectory, const char* pszCacheFile, uint32_t dwNotifyMsg ) ;
+extern uint32_t FILE_ThumbCache_Close( SFILEThumbCache* pCache ) ;
+extern uint32_t FILE_ThumbCache_Refresh( SFILEThumbCache* pCache ) ;
+extern uint32_t FILE_ThumbCache_Process( SFILEThumbCache* pCache ) ;
+extern void FILE_ThumbCache_Task( void* pvParam ) ;
+extern uint32_t FILE_ThumbCache_Draw( SFILEThumbCache* pCache, SDISPBackend* pBE, const char* pszName, uint32_t dwX, uint32_t dwY ) ;
+
+/** @}
+ * @}
+ * @} */
+
+#endif // _SAMGUI_FILE_THUMBCACHE_
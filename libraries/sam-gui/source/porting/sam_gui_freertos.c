@@ -7,6 +7,11 @@ extern void SAMGUI_TaskDelay( uint32_t dwDelayMs )
     vTaskDelay( dwDelayMs/portTICK_RATE_MS ) ;
 }
 
+extern uint32_t SAMGUI_GetTickCount( void )
+{
+    return xTaskGetTickCount()*portTICK_RATE_MS ;
+}
+
 extern int SAMGUI_TaskCreate( SAMGUI_fnTask fnTask, const uint8_t* pucName, uint8_t* pucStack, uint32_t dwStackSize,
                               uint32_t dwPriority, void* pvParameters, SAMGUI_TaskHandle* pHandle )
 {
@@ -27,6 +27,7 @@
 #  define SAMGUI_TaskHandle uint32_t
 #  define SAMGUI_QueueHandle uint32_t
 #  define SAMGUI_SemaphoreHandle uint32_t
+#  define SAMGUI_WAIT_FOREVER 0xffffffffUL
 #endif // SAM_PORTING == SAM_PORTING_NONE
 
 /**
@@ -38,6 +39,7 @@
 #  define SAMGUI_TaskHandle xTaskHandle
 #  define SAMGUI_QueueHandle xQueueHandle
 #  define SAMGUI_SemaphoreHandle xSemaphoreHandle
+#  define SAMGUI_WAIT_FOREVER portMAX_DELAY
 #endif // SAM_PORTING == SAM_PORTING_FREERTOS
 
 // Tasks functions
@@ -48,12 +50,15 @@ extern int SAMGUI_TaskCreate( SAMGUI_fnTask fnTask, const uint8_t* pucName, uint
 extern void SAMGUI_TaskDelete( SAMGUI_TaskHandle Handle ) ;
 extern void SAMGUI_TaskDelay( uint32_t dwDelayMs ) ;
 
+// Time functions, milliseconds since scheduler start, wrapping around
+extern uint32_t SAMGUI_GetTickCount( void ) ;
+
 // Memory functions
 extern void* SAMGUI_Malloc( uint32_t dwSize ) ;
 extern void SAMGUI_Free( void *pv ) ;
 
 
-// Message queue functions
+// Message queue functions, a dwDelay of SAMGUI_WAIT_FOREVER blocks until a message arrives
 extern SAMGUI_QueueHandle SAMGUI_QueueCreate( uint32_t dwMsgNumber, uint32_t dwMsgSize ) ;
 
 extern uint32_t SAMGUI_QueueReceive( SAMGUI_QueueHandle hQueue, void* pMsg, uint32_t dwDelay ) ;
@@ -50,36 +50,73 @@ NO_INIT SAMGUI_TaskHandle hGUITask ;
 
 /**
  * Core SAM-GUI task handling Message Queue and Message dispatching.
+ *
+ * The task blocks on the queue until a message arrives or the next timer
+ * expires, and does not run at all while idle without running timers. While
+ * a background work is set, the queue is polled and one step of the work runs
+ * after each message, so the messages wait at most one step. Messages posted
+ * from ISR handlers are got from their own ring after each wake, only those
+ * pending at that time so that a drag cannot hold off the timers.
  */
 static void _WGT_TaskMessageLoop( void* pParameter )
 {
     SWGTCoreData* pData=(SWGTCoreData*)pParameter ;
     SWGTCoreMessage xMessage ;
+    uint32_t (*pfnWork)( void* pvArg ) ;
+    void* pvWorkArg ;
+    uint32_t dwDelay ;
+    uint32_t dwCount ;
 
     WGT_Start() ;
 
     for ( ; ; )
     {
-        // Wait for a widget message
+        // Post expired timers, then wait for a widget message or the next deadline
+        WGT_Timer_Process() ;
 
-//        if ( SAMGUI_QueueReceive( pData->hMessagesQueue, &xMessage, portMAX_DELAY ) != SAMGUI_E_OK )
-        if ( SAMGUI_QueueReceive( pData->hMessagesQueue, &xMessage, g_WGT_CoreData.dwTimerDelay ) == SAMGUI_E_OK )
+        if ( (pData->pfnWork != NULL) || (WGT_GetPendingMessagesISR() != 0) )
+        {
+            dwDelay=0 ;
+        }
+        else
         {
+            dwDelay=WGT_Timer_GetNextDelay() ;
+        }
+
+        if ( SAMGUI_QueueReceive( pData->hMessagesQueue, &xMessage, dwDelay ) == SAMGUI_E_OK )
+        {
+            if ( xMessage.dwID == WGT_MSG_TIMER )
+            {
+                WGT_Timer_Acknowledge( (SWGTTimer*)xMessage.dwParam2 ) ;
+            }
+
+            if ( (xMessage.dwID != WGT_MSG_ISR_PENDING) && (g_WGT_CoreData.pCurrentScreen != NULL) )
+            {
+                PreProcessMessage_Default( g_WGT_CoreData.pCurrentScreen, &xMessage ) ;
+            }
+        }
+
+        for ( dwCount=WGT_GetPendingMessagesISR() ; dwCount != 0 ; dwCount-- )
+        {
+            if ( WGT_GetMessageISR( &xMessage ) != SAMGUI_E_OK )
+            {
+                break ;
+            }
+
             if ( g_WGT_CoreData.pCurrentScreen != NULL )
             {
                 PreProcessMessage_Default( g_WGT_CoreData.pCurrentScreen, &xMessage ) ;
             }
         }
-//        else // delay, send timer
-//        {
-//            if ( g_WGT_CoreData.pCurrentScreen != NULL )
-//            {
-//                xMessage.dwID=WGT_MSG_TIMER ;
-//                if ( g_WGT_CoreData.pCurrentScreen->ProcessMessage( g_WGT_CoreData.pCurrentScreen, &xMessage ) == SAMGUI_E_OK )
-//                {
-//                }
-//            }
-//        }
+
+        // The message handler may have replaced or cancelled the work
+        pfnWork=pData->pfnWork ;
+        pvWorkArg=pData->pvWorkArg ;
+        if ( (pfnWork != NULL) && (pfnWork( pvWorkArg ) == 0) &&
+             (pData->pfnWork == pfnWork) && (pData->pvWorkArg == pvWorkArg) )
+        {
+            pData->pfnWork=NULL ;
+        }
     }
 }
 
@@ -90,8 +127,11 @@ extern uint32_t WGT_Initialize( void )
 {
     uint32_t dwError ;
 
-    /* Set Timer Delay to 1s. */
-    g_WGT_CoreData.dwTimerDelay=1000 ;
+    /* No core timer until WGT_SetTimerPeriod() is called. */
+    g_WGT_CoreData.dwTimerDelay=0 ;
+    g_WGT_CoreData.sTimer.dwState=WGT_TIMER_DISABLED ;
+    WGT_Timer_Initialize() ;
+    g_WGT_CoreData.pfnWork=NULL ;
 
 	/* Create the queue used by the Messages task. */
 	g_WGT_CoreData.hMessagesQueue=SAMGUI_QueueCreate( WGT_CORE_MSG_QUEUE_SIZE, sizeof( SWGTCoreMessage ) ) ;
@@ -137,7 +177,10 @@ extern uint32_t WGT_Start( void )
 }
 
 /**
- * Allow to set the delay between WM_TIMER messages.
+ * Allow to set the delay between WM_TIMER messages of the core timer, 0 stops
+ * it. To be called from the GUI task.
+ *
+ * \return the previous delay.
  */
 extern uint32_t WGT_SetTimerPeriod( uint32_t dwDelay )
 {
@@ -146,6 +189,13 @@ extern uint32_t WGT_SetTimerPeriod( uint32_t dwDelay )
     dw=g_WGT_CoreData.dwTimerDelay ;
     g_WGT_CoreData.dwTimerDelay=dwDelay ;
 
+    WGT_Timer_Stop( &g_WGT_CoreData.sTimer ) ;
+    if ( dwDelay != 0 )
+    {
+        WGT_Timer_Create( &g_WGT_CoreData.sTimer, WGT_CORE_TIMER_ID, dwDelay ) ;
+        WGT_Timer_Start( &g_WGT_CoreData.sTimer ) ;
+    }
+
     return dw ;
 }
 
@@ -157,6 +207,20 @@ extern uint32_t WGT_GetTimerPeriod( void )
     return g_WGT_CoreData.dwTimerDelay ;
 }
 
+/**
+ * Sets the background work of the GUI task, replacing the current one; NULL
+ * cancels it. The work function does one bounded step per call, between two
+ * messages, and returns non-zero while there is more to do. To be called from
+ * the GUI task.
+ */
+extern uint32_t WGT_SetBackgroundWork( uint32_t (*pfnWork)( void* pvArg ), void* pvArg )
+{
+    g_WGT_CoreData.pvWorkArg=pvArg ;
+    g_WGT_CoreData.pfnWork=pfnWork ;
+
+    return SAMGUI_E_OK ;
+}
+
 /**
  * Allow to set the current screen.
  */
@@ -187,6 +251,9 @@ extern uint32_t WGT_SetCurrentScreen( SWGTScreen* pScreen )
     while ( SAMGUI_QueueReceive( g_WGT_CoreData.hMessagesQueue, &xMessage, 0 ) == SAMGUI_E_OK )
     {
     }
+    while ( WGT_GetMessageISR( &xMessage ) == SAMGUI_E_OK )
+    {
+    }
 
     g_WGT_CoreData.pCurrentScreen=pScreen ;
 
@@ -51,7 +51,14 @@ typedef struct _SWGTCoreData
     SDISPBackend* pBE ;
 
     SWGTScreen* pCurrentScreen ;
+
+    // Core timer set by WGT_SetTimerPeriod(), 0 when disabled
     uint32_t dwTimerDelay ;
+    SWGTTimer sTimer ;
+
+    // Background work set by WGT_SetBackgroundWork(), NULL when none
+    uint32_t (*pfnWork)( void* pvArg ) ;
+    void* pvWorkArg ;
 } SWGTCoreData ;
 
 /**
@@ -62,9 +69,14 @@ extern SWGTCoreData g_WGT_CoreData ;
 extern uint32_t WGT_Initialize( void ) ;
 extern uint32_t WGT_Start( void ) ;
 
+// Core timer ID, in dwParam1 of its WGT_MSG_TIMER messages
+#define WGT_CORE_TIMER_ID          0
+
 extern uint32_t WGT_SetTimerPeriod( uint32_t dwDelay ) ;
 extern uint32_t WGT_GetTimerPeriod( void ) ;
 
+extern uint32_t WGT_SetBackgroundWork( uint32_t (*pfnWork)( void* pvArg ), void* pvArg ) ;
+
 extern uint32_t WGT_SetCurrentScreen( SWGTScreen* pScreen ) ;
 
 /** @}
@@ -130,6 +130,8 @@ extern uint32_t PreProcessMessage_Default( struct _SWGTScreen* pScreen, SWGTCore
             {
                 g_WGT_CoreData.pCurrentScreen->HkAfterPaint( g_WGT_CoreData.pCurrentScreen ) ;
             }
+
+            WGT_Screen_EndPaint( g_WGT_CoreData.pCurrentScreen ) ;
         break ;
     }
 
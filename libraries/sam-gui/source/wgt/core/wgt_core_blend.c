@@ -0,0 +1,648 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#include "board.h"
+
+#include "libsam_gui.h"
+
+#include <string.h>
+
+/**
+ * \addtogroup SAMGUI
+ * @{
+ *   \addtogroup SAMGUI_WGT
+ *   @{
+ *     \addtogroup SAMGUI_WGT_CORE
+ *     @{
+ *       \addtogroup SAMGUI_WGT_CORE_BLEND WGT Core Blending
+ *       @{
+ */
+
+// Fields of a pair of RGB565 pixels with room above each one for the alpha product:
+// B0, R0, G1 in place, and G0, B1, R1 once shifted right by 5
+#define WGT_BLEND_MASK_LOW         0x07E0F81FUL
+#define WGT_BLEND_MASK_HIGH        0x07C0F83FUL
+
+// Layer the flush function works for
+static SWGTBlendLayer* _WGT_Blend_pLayer=NULL ;
+
+static inline uint32_t _WGT_Blend_To565( LcdColor_t dwColor )
+{
+    return ((dwColor >> 8) & 0xF800) | ((dwColor >> 5) & 0x07E0) | ((dwColor >> 3) & 0x001F) ;
+}
+
+static inline LcdColor_t _WGT_Blend_From565( uint32_t dwPixel )
+{
+    return ((dwPixel & 0xF800) << 8) | ((dwPixel & 0x07E0) << 5) | ((dwPixel & 0x001F) << 3) ;
+}
+
+static inline uint32_t _WGT_Blend_Stride( const SWGTBlendRegion* pRegion )
+{
+    return (pRegion->sArea.dwX2-pRegion->sArea.dwX1+2)/2 ;
+}
+
+/**
+ * Screen box of a tile, cut to the region
+ */
+static void _WGT_Blend_GetTileBox( const SWGTBlendRegion* pRegion, uint32_t dwTX, uint32_t dwTY, SWGTRect* pBox )
+{
+    pBox->dwX1=pRegion->sArea.dwX1+dwTX*WGT_BLEND_TILE ;
+    pBox->dwY1=pRegion->sArea.dwY1+dwTY*WGT_BLEND_TILE ;
+    pBox->dwX2=pBox->dwX1+WGT_BLEND_TILE-1 ;
+    pBox->dwY2=pBox->dwY1+WGT_BLEND_TILE-1 ;
+
+    if ( pBox->dwX2 > pRegion->sArea.dwX2 )
+    {
+        pBox->dwX2=pRegion->sArea.dwX2 ;
+    }
+
+    if ( pBox->dwY2 > pRegion->sArea.dwY2 )
+    {
+        pBox->dwY2=pRegion->sArea.dwY2 ;
+    }
+}
+
+/**
+ * Returns 1 when all the rows of a tile are in the shadow
+ */
+static uint32_t _WGT_Blend_IsTileCaptured( const SWGTBlendRegion* pRegion, uint32_t dwTX, uint32_t dwTY )
+{
+    SWGTRect sBox ;
+    uint32_t dwMask ;
+
+    _WGT_Blend_GetTileBox( pRegion, dwTX, dwTY, &sBox ) ;
+    dwMask=(1UL << (sBox.dwY2-sBox.dwY1+1))-1 ;
+
+    return (pRegion->pwCaptured[dwTY*pRegion->dwTilesX+dwTX] & dwMask) == dwMask ;
+}
+
+/**
+ * Intersects a box with the area of a region
+ *
+ * \return 0 if they do not intersect
+ */
+static uint32_t _WGT_Blend_Clip( const SWGTBlendRegion* pRegion, SWGTRect* pBox )
+{
+    if ( pBox->dwX1 < pRegion->sArea.dwX1 ) pBox->dwX1=pRegion->sArea.dwX1 ;
+    if ( pBox->dwY1 < pRegion->sArea.dwY1 ) pBox->dwY1=pRegion->sArea.dwY1 ;
+    if ( pBox->dwX2 > pRegion->sArea.dwX2 ) pBox->dwX2=pRegion->sArea.dwX2 ;
+    if ( pBox->dwY2 > pRegion->sArea.dwY2 ) pBox->dwY2=pRegion->sArea.dwY2 ;
+
+    return (pBox->dwX1 <= pBox->dwX2) && (pBox->dwY1 <= pBox->dwY2) ;
+}
+
+/**
+ * Stores the pixels dwX1 to dwX2 of a row in the shadow. The row of the
+ * tiles it covers from side to side is marked as captured.
+ */
+static void _WGT_Blend_CaptureRow( SWGTBlendRegion* pRegion, uint32_t dwY, uint32_t dwX1, uint32_t dwX2, const LcdColor_t* pPixels )
+{
+    uint16_t* pwShadow ;
+    uint32_t dwRow ;
+    uint32_t dwTX ;
+    uint32_t dwTileX1 ;
+    uint32_t dwTileX2 ;
+    uint32_t dwX ;
+
+    dwRow=dwY-pRegion->sArea.dwY1 ;
+    pwShadow=(uint16_t*)(pRegion->pdwShadow+dwRow*_WGT_Blend_Stride( pRegion ))+(dwX1-pRegion->sArea.dwX1) ;
+
+    for ( dwX=dwX1 ; dwX <= dwX2 ; dwX++ )
+    {
+        *pwShadow++=(uint16_t)_WGT_Blend_To565( *pPixels++ ) ;
+    }
+
+    for ( dwTX=(dwX1-pRegion->sArea.dwX1)/WGT_BLEND_TILE ; dwTX <= (dwX2-pRegion->sArea.dwX1)/WGT_BLEND_TILE ; dwTX++ )
+    {
+        dwTileX1=pRegion->sArea.dwX1+dwTX*WGT_BLEND_TILE ;
+        dwTileX2=dwTileX1+WGT_BLEND_TILE-1 ;
+        if ( dwTileX2 > pRegion->sArea.dwX2 )
+        {
+            dwTileX2=pRegion->sArea.dwX2 ;
+        }
+
+        if ( (dwX1 <= dwTileX1) && (dwX2 >= dwTileX2) )
+        {
+            pRegion->pwCaptured[(dwRow/WGT_BLEND_TILE)*pRegion->dwTilesX+dwTX]|=1 << (dwRow%WGT_BLEND_TILE) ;
+        }
+    }
+}
+
+/**
+ * Writes the pixels dwX1 to dwX2 of a row of the shadow, blended with the
+ * tint, to pPixels. A pair of pixels takes two multiplications, each field
+ * being weighted by alpha in the room left free above it by the masks.
+ */
+static void _WGT_Blend_ComposeRow( const SWGTBlendRegion* pRegion, uint32_t dwAlpha, uint32_t dwY, uint32_t dwX1, uint32_t dwX2,
+                                   LcdColor_t* pPixels )
+{
+    const uint32_t* pdwShadow ;
+    uint32_t dwTint ;
+    uint32_t dwTintLow ;
+    uint32_t dwTintHigh ;
+    uint32_t dwInverse ;
+    uint32_t dwPair ;
+    uint32_t dwX ;
+    uint32_t dwEnd ;
+
+    dwTint=_WGT_Blend_To565( pRegion->dwTint ) ;
+    dwTint|=dwTint << 16 ;
+    dwTintLow=(dwTint & WGT_BLEND_MASK_LOW)*dwAlpha ;
+    dwTintHigh=((dwTint >> 5) & WGT_BLEND_MASK_HIGH)*dwAlpha ;
+    dwInverse=WGT_BLEND_ALPHA_MAX-dwAlpha ;
+
+    dwX=dwX1-pRegion->sArea.dwX1 ;
+    dwEnd=dwX2-pRegion->sArea.dwX1 ;
+    pdwShadow=pRegion->pdwShadow+(dwY-pRegion->sArea.dwY1)*_WGT_Blend_Stride( pRegion )+dwX/2 ;
+
+    while ( dwX <= dwEnd )
+    {
+        dwPair=*pdwShadow++ ;
+
+        if ( dwAlpha != 0 )
+        {
+            dwPair=(((((dwPair & WGT_BLEND_MASK_LOW)*dwInverse)+dwTintLow) >> 5) & WGT_BLEND_MASK_LOW) |
+                   ((((((dwPair >> 5) & WGT_BLEND_MASK_HIGH)*dwInverse)+dwTintHigh) >> 5) & WGT_BLEND_MASK_HIGH) << 5 ;
+        }
+
+        if ( (dwX & 1) == 0 )
+        {
+            *pPixels++=_WGT_Blend_From565( dwPair & 0xFFFF ) ;
+            dwX++ ;
+        }
+
+        if ( dwX <= dwEnd )
+        {
+            *pPixels++=_WGT_Blend_From565( dwPair >> 16 ) ;
+            dwX++ ;
+        }
+    }
+}
+
+/**
+ * Composites a box of a region in the tile buffer, strip by strip, each strip
+ * being sent to the panel in one burst. Without dwShow, the shadow is sent as
+ * it is, putting the screen back.
+ */
+static void _WGT_BlendLayer_ComposeBox( SWGTBlendLayer* pLayer, SWGTBlendRegion* pRegion, const SWGTRect* pBox, uint32_t dwShow )
+{
+    SWGTRect sStrip ;
+    uint32_t dwWidth ;
+    uint32_t dwLines ;
+    uint32_t dwY ;
+
+    dwWidth=pBox->dwX2-pBox->dwX1+1 ;
+    dwLines=pLayer->dwTilePixels/dwWidth ;
+
+    sStrip.dwX1=pBox->dwX1 ;
+    sStrip.dwX2=pBox->dwX2 ;
+    for ( sStrip.dwY1=pBox->dwY1 ; sStrip.dwY1 <= pBox->dwY2 ; sStrip.dwY1+=dwLines )
+    {
+        sStrip.dwY2=sStrip.dwY1+dwLines-1 ;
+        if ( sStrip.dwY2 > pBox->dwY2 )
+        {
+            sStrip.dwY2=pBox->dwY2 ;
+        }
+
+        for ( dwY=sStrip.dwY1 ; dwY <= sStrip.dwY2 ; dwY++ )
+        {
+            _WGT_Blend_ComposeRow( pRegion, dwShow ? pRegion->dwAlpha : 0, dwY, sStrip.dwX1, sStrip.dwX2,
+                                   pLayer->pTile+(dwY-sStrip.dwY1)*dwWidth ) ;
+        }
+        pLayer->dwBlended+=dwWidth*(sStrip.dwY2-sStrip.dwY1+1) ;
+
+        if ( dwShow && (pRegion->Render != NULL) )
+        {
+            FB_SetFrameBuffer( pLayer->pTile, dwWidth, sStrip.dwY2-sStrip.dwY1+1 ) ;
+            FB_SetOrigin( sStrip.dwX1, sStrip.dwY1 ) ;
+            pRegion->Render( pRegion ) ;
+        }
+
+        pLayer->Flush( sStrip.dwX1, sStrip.dwY1, sStrip.dwX2, sStrip.dwY2, pLayer->pTile ) ;
+    }
+}
+
+/**
+ * Composites the tiles of a region which are dirty, or all of them with
+ * dwAll, provided they are captured. Adjacent tiles of a tile row go out as
+ * one box.
+ */
+static void _WGT_BlendLayer_ComposeTiles( SWGTBlendLayer* pLayer, SWGTBlendRegion* pRegion, uint32_t dwAll, uint32_t dwShow )
+{
+    SWGTRect sBox ;
+    SWGTRect sLast ;
+    uint32_t dwTX ;
+    uint32_t dwTY ;
+    uint32_t dwFirst ;
+    uint8_t* pucDirty ;
+
+    for ( dwTY=0 ; dwTY < pRegion->dwTilesY ; dwTY++ )
+    {
+        pucDirty=pRegion->pucDirty+dwTY*pRegion->dwTilesX ;
+
+        for ( dwTX=0 ; dwTX < pRegion->dwTilesX ; )
+        {
+            if ( !(dwAll || pucDirty[dwTX]) || !_WGT_Blend_IsTileCaptured( pRegion, dwTX, dwTY ) )
+            {
+                dwTX++ ;
+                continue ;
+            }
+
+            for ( dwFirst=dwTX ; (dwTX < pRegion->dwTilesX) && (dwAll || pucDirty[dwTX]) && _WGT_Blend_IsTileCaptured( pRegion, dwTX, dwTY ) ; dwTX++ )
+            {
+                pucDirty[dwTX]=0 ;
+            }
+
+            _WGT_Blend_GetTileBox( pRegion, dwFirst, dwTY, &sBox ) ;
+            _WGT_Blend_GetTileBox( pRegion, dwTX-1, dwTY, &sLast ) ;
+            sBox.dwX2=sLast.dwX2 ;
+
+            _WGT_BlendLayer_ComposeBox( pLayer, pRegion, &sBox, dwShow ) ;
+        }
+    }
+}
+
+/**
+ * Marks the tiles of a region within a box as to be composited, or as
+ * composited when dwDirty is 0 (only the tiles wholly within the box then).
+ */
+static void _WGT_Blend_MarkTiles( SWGTBlendRegion* pRegion, const SWGTRect* pBox, uint8_t ucDirty )
+{
+    SWGTRect sTile ;
+    uint32_t dwTX ;
+    uint32_t dwTY ;
+
+    for ( dwTY=(pBox->dwY1-pRegion->sArea.dwY1)/WGT_BLEND_TILE ; dwTY <= (pBox->dwY2-pRegion->sArea.dwY1)/WGT_BLEND_TILE ; dwTY++ )
+    {
+        for ( dwTX=(pBox->dwX1-pRegion->sArea.dwX1)/WGT_BLEND_TILE ; dwTX <= (pBox->dwX2-pRegion->sArea.dwX1)/WGT_BLEND_TILE ; dwTX++ )
+        {
+            if ( ucDirty == 0 )
+            {
+                _WGT_Blend_GetTileBox( pRegion, dwTX, dwTY, &sTile ) ;
+                if ( (sTile.dwX1 < pBox->dwX1) || (sTile.dwX2 > pBox->dwX2) || (sTile.dwY1 < pBox->dwY1) || (sTile.dwY2 > pBox->dwY2) )
+                {
+                    continue ;
+                }
+            }
+
+            pRegion->pucDirty[dwTY*pRegion->dwTilesX+dwTX]=ucDirty ;
+        }
+    }
+}
+
+/**
+ * Initializes the blend layer. The tile buffer must hold at least one line
+ * of the widest region, Flush writes a box of pixels to the panel (as for
+ * DBE_TILE_Initialize()). There is one layer, WGT_BlendLayer_Flush() working
+ * for the last one initialized.
+ */
+extern uint32_t WGT_BlendLayer_Initialize( SWGTBlendLayer* pLayer, LcdColor_t* pTile, uint32_t dwTilePixels, DBE_TILE_FlushCallback Flush )
+{
+    if ( (pLayer == NULL) || (pTile == NULL) || (Flush == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( dwTilePixels == 0 )
+    {
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+
+    memset( pLayer, 0, sizeof( SWGTBlendLayer ) ) ;
+    pLayer->pTile=pTile ;
+    pLayer->dwTilePixels=dwTilePixels ;
+    pLayer->Flush=Flush ;
+
+    _WGT_Blend_pLayer=pLayer ;
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Adds a region to the layer, hidden. Its shadow is captured from then on,
+ * so the screen under it must be painted after.
+ */
+extern uint32_t WGT_BlendLayer_Add( SWGTBlendLayer* pLayer, SWGTBlendRegion* pRegion )
+{
+    SWGTBlendRegion* pOther ;
+
+    if ( (pLayer == NULL) || (pRegion == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( pRegion->sArea.dwX2-pRegion->sArea.dwX1+1 > pLayer->dwTilePixels )
+    {
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+
+    for ( pOther=pLayer->pRegions ; pOther != NULL ; pOther=pOther->pNext )
+    {
+        if ( pOther == pRegion )
+        {
+            return SAMGUI_E_OK ;
+        }
+    }
+
+    pRegion->pNext=pLayer->pRegions ;
+    pLayer->pRegions=pRegion ;
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Removes a region from the layer. When it was shown, the screen under it is
+ * put back from the shadow.
+ */
+extern uint32_t WGT_BlendLayer_Remove( SWGTBlendLayer* pLayer, SWGTBlendRegion* pRegion )
+{
+    SWGTBlendRegion** ppRegion ;
+
+    if ( (pLayer == NULL) || (pRegion == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    for ( ppRegion=&pLayer->pRegions ; *ppRegion != NULL ; ppRegion=&(*ppRegion)->pNext )
+    {
+        if ( *ppRegion == pRegion )
+        {
+            *ppRegion=pRegion->pNext ;
+            pRegion->pNext=NULL ;
+
+            if ( pRegion->dwVisible )
+            {
+                pRegion->dwVisible=0 ;
+                _WGT_BlendLayer_ComposeTiles( pLayer, pRegion, 1, 0 ) ;
+            }
+
+            return SAMGUI_E_OK ;
+        }
+    }
+
+    return SAMGUI_E_BAD_PARAMETER ;
+}
+
+/**
+ * Sends the dirty tiles of every region, composited from the shadow
+ */
+extern uint32_t WGT_BlendLayer_Update( SWGTBlendLayer* pLayer )
+{
+    SWGTBlendRegion* pRegion ;
+
+    if ( pLayer == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    for ( pRegion=pLayer->pRegions ; pRegion != NULL ; pRegion=pRegion->pNext )
+    {
+        _WGT_BlendLayer_ComposeTiles( pLayer, pRegion, 0, pRegion->dwVisible ) ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Flush function to give to the TILE backend or to a sprite layer. The part
+ * of the strip over each region is captured in its shadow, and when the
+ * region is shown, replaced in pBuffer by the blended pixels and the overlay
+ * content, before the strip is written by the flush function of the layer.
+ * pBuffer is modified: its owner renders it again for every strip.
+ */
+extern uint32_t WGT_BlendLayer_Flush( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2, const LcdColor_t* pBuffer )
+{
+    SWGTBlendLayer* pLayer=_WGT_Blend_pLayer ;
+    SWGTBlendRegion* pRegion ;
+    LcdColor_t* pStrip=(LcdColor_t*)pBuffer ;
+    SWGTRect sBox ;
+    uint32_t dwWidth ;
+    uint32_t dwY ;
+
+    if ( (pLayer == NULL) || (pBuffer == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    dwWidth=dwX2-dwX1+1 ;
+
+    for ( pRegion=pLayer->pRegions ; pRegion != NULL ; pRegion=pRegion->pNext )
+    {
+        sBox.dwX1=dwX1 ;
+        sBox.dwY1=dwY1 ;
+        sBox.dwX2=dwX2 ;
+        sBox.dwY2=dwY2 ;
+        if ( !_WGT_Blend_Clip( pRegion, &sBox ) )
+        {
+            continue ;
+        }
+
+        for ( dwY=sBox.dwY1 ; dwY <= sBox.dwY2 ; dwY++ )
+        {
+            _WGT_Blend_CaptureRow( pRegion, dwY, sBox.dwX1, sBox.dwX2, pStrip+(dwY-dwY1)*dwWidth+(sBox.dwX1-dwX1) ) ;
+        }
+        pLayer->dwCaptured+=(sBox.dwX2-sBox.dwX1+1)*(sBox.dwY2-sBox.dwY1+1) ;
+
+        if ( pRegion->dwVisible )
+        {
+            for ( dwY=sBox.dwY1 ; dwY <= sBox.dwY2 ; dwY++ )
+            {
+                _WGT_Blend_ComposeRow( pRegion, pRegion->dwAlpha, dwY, sBox.dwX1, sBox.dwX2, pStrip+(dwY-dwY1)*dwWidth+(sBox.dwX1-dwX1) ) ;
+            }
+            pLayer->dwBlended+=(sBox.dwX2-sBox.dwX1+1)*(sBox.dwY2-sBox.dwY1+1) ;
+
+            if ( pRegion->Render != NULL )
+            {
+                FB_SetFrameBuffer( pStrip, dwWidth, dwY2-dwY1+1 ) ;
+                FB_SetOrigin( dwX1, dwY1 ) ;
+                pRegion->Render( pRegion ) ;
+            }
+        }
+
+        // The tiles wholly in the strip are up to date on the panel
+        _WGT_Blend_MarkTiles( pRegion, &sBox, 0 ) ;
+    }
+
+    return pLayer->Flush( dwX1, dwY1, dwX2, dwY2, pBuffer ) ;
+}
+
+/**
+ * Initializes a region over the screen area (dwX1, dwY1)-(dwX2, dwY2).
+ * pdwShadow holds WGT_BLEND_SHADOW_WORDS() words, pwCaptured and pucDirty
+ * WGT_BLEND_TILES() entries each, for the size of the area.
+ */
+extern uint32_t WGT_BlendRegion_Initialize( SWGTBlendRegion* pRegion, uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2,
+                                            uint32_t* pdwShadow, uint16_t* pwCaptured, uint8_t* pucDirty )
+{
+    if ( (pRegion == NULL) || (pdwShadow == NULL) || (pwCaptured == NULL) || (pucDirty == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( (dwX1 > dwX2) || (dwY1 > dwY2) || (dwX2 >= BOARD_LCD_WIDTH) || (dwY2 >= BOARD_LCD_HEIGHT) )
+    {
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+
+    memset( pRegion, 0, sizeof( SWGTBlendRegion ) ) ;
+    pRegion->sArea.dwX1=dwX1 ;
+    pRegion->sArea.dwY1=dwY1 ;
+    pRegion->sArea.dwX2=dwX2 ;
+    pRegion->sArea.dwY2=dwY2 ;
+    pRegion->pdwShadow=pdwShadow ;
+    pRegion->pwCaptured=pwCaptured ;
+    pRegion->pucDirty=pucDirty ;
+    pRegion->dwTilesX=(dwX2-dwX1+WGT_BLEND_TILE)/WGT_BLEND_TILE ;
+    pRegion->dwTilesY=(dwY2-dwY1+WGT_BLEND_TILE)/WGT_BLEND_TILE ;
+
+    memset( pwCaptured, 0, pRegion->dwTilesX*pRegion->dwTilesY*sizeof( uint16_t ) ) ;
+    memset( pucDirty, 0, pRegion->dwTilesX*pRegion->dwTilesY ) ;
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Shows or hides the overlay, at the next WGT_BlendLayer_Update()
+ */
+extern uint32_t WGT_BlendRegion_Show( SWGTBlendRegion* pRegion, uint32_t dwShow )
+{
+    if ( pRegion == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    dwShow=(dwShow != 0) ;
+    if ( dwShow != pRegion->dwVisible )
+    {
+        pRegion->dwVisible=dwShow ;
+        _WGT_Blend_MarkTiles( pRegion, &pRegion->sArea, 1 ) ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Sets the tint of the overlay, dwAlpha from 0 to WGT_BLEND_ALPHA_MAX
+ */
+extern uint32_t WGT_BlendRegion_SetTint( SWGTBlendRegion* pRegion, uint32_t dwTint, uint32_t dwAlpha )
+{
+    if ( pRegion == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( dwAlpha > WGT_BLEND_ALPHA_MAX )
+    {
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+
+    pRegion->dwTint=dwTint & 0x00FFFFFF ;
+    pRegion->dwAlpha=dwAlpha ;
+
+    if ( pRegion->dwVisible )
+    {
+        _WGT_Blend_MarkTiles( pRegion, &pRegion->sArea, 1 ) ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Stores known pixels of the screen under the overlay in the shadow, as an
+ * image drawn there by the application. pPixels holds the rows of the box
+ * (dwX1, dwY1)-(dwX2, dwY2), of which the part within the region is kept.
+ * The panel is not written, the tiles concerned are marked when shown.
+ */
+extern uint32_t WGT_BlendRegion_Capture( SWGTBlendRegion* pRegion, uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2,
+                                         const LcdColor_t* pPixels )
+{
+    SWGTRect sBox ;
+    uint32_t dwY ;
+
+    if ( (pRegion == NULL) || (pPixels == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( (dwX1 > dwX2) || (dwY1 > dwY2) )
+    {
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+
+    sBox.dwX1=dwX1 ;
+    sBox.dwY1=dwY1 ;
+    sBox.dwX2=dwX2 ;
+    sBox.dwY2=dwY2 ;
+    if ( !_WGT_Blend_Clip( pRegion, &sBox ) )
+    {
+        return SAMGUI_E_OK ;
+    }
+
+    for ( dwY=sBox.dwY1 ; dwY <= sBox.dwY2 ; dwY++ )
+    {
+        _WGT_Blend_CaptureRow( pRegion, dwY, sBox.dwX1, sBox.dwX2, pPixels+(dwY-dwY1)*(dwX2-dwX1+1)+(sBox.dwX1-dwX1) ) ;
+    }
+
+    if ( pRegion->dwVisible )
+    {
+        _WGT_Blend_MarkTiles( pRegion, &sBox, 1 ) ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Has the tiles of a box of the region composited again at the next
+ * WGT_BlendLayer_Update(), after a change of what Render draws there
+ */
+extern uint32_t WGT_BlendRegion_Invalidate( SWGTBlendRegion* pRegion, uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2 )
+{
+    SWGTRect sBox ;
+
+    if ( pRegion == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    sBox.dwX1=dwX1 ;
+    sBox.dwY1=dwY1 ;
+    sBox.dwX2=dwX2 ;
+    sBox.dwY2=dwY2 ;
+    if ( (dwX1 <= dwX2) && (dwY1 <= dwY2) && _WGT_Blend_Clip( pRegion, &sBox ) )
+    {
+        _WGT_Blend_MarkTiles( pRegion, &sBox, 1 ) ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+/** @}
+ * @}
+ * @}
+ * @} */
@@ -0,0 +1,141 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef _SAMGUI_WIDGET_CORE_BLEND_
+#define _SAMGUI_WIDGET_CORE_BLEND_
+
+#include "board.h"
+#include "source/disp/disp_backend.h"
+#include "source/disp/backends/TILE/backend_TILE.h"
+#include "source/wgt/core/wgt_core_screen.h"
+
+/**
+ * \addtogroup SAMGUI
+ * @{
+ *   \addtogroup SAMGUI_WGT
+ *   @{
+ *     \addtogroup SAMGUI_WGT_CORE
+ *     @{
+ *       \addtogroup SAMGUI_WGT_CORE_BLEND WGT Core Blending
+ *       @{
+ *
+ * \brief Translucent overlays blended over a RAM shadow of the screen.
+ *
+ * A blend region keeps a shadow of the opaque pixels under a translucent
+ * overlay, in RGB565, two pixels per word, in SRAM or PSRAM. The panel is
+ * never read back: the shadow is captured from the strips going to the panel
+ * through WGT_BlendLayer_Flush(), given as flush function to the TILE backend
+ * (or to a sprite layer), or given by the application with
+ * WGT_BlendRegion_Capture(). On the way out, the part of a strip under a shown
+ * overlay is replaced by the shadow blended with the overlay tint, then the
+ * overlay Render function draws its opaque content (texts, icons) over it.
+ *
+ * A region is captured as soon as it is added to the layer, shown or not.
+ * WGT_BlendRegion_Show(), WGT_BlendRegion_SetTint() and
+ * WGT_BlendRegion_Invalidate() only mark tiles, which WGT_BlendLayer_Update()
+ * composites from the shadow and sends to the panel.
+ *
+ * The shadow is kept per tile of WGT_BLEND_TILE x WGT_BLEND_TILE pixels. A
+ * tile can be composited on its own once all its rows have been captured, so
+ * changing the tint or the content of an overlay only sends its tiles, from
+ * the shadow, without repainting the widgets under it.
+ *
+ * Blending is done in fixed point, alpha from 0 (shadow only) to
+ * WGT_BLEND_ALPHA_MAX (tint only), on two pixels at once. Regions must not
+ * overlap. Everything runs in the GUI task.
+ */
+
+// Side of the shadow tiles, in pixels
+#define WGT_BLEND_TILE             16
+
+// Opaque tint
+#define WGT_BLEND_ALPHA_MAX        32
+
+// Words of the shadow of a dwWidth x dwHeight region
+#define WGT_BLEND_SHADOW_WORDS( dwWidth, dwHeight )    ((((dwWidth)+1)/2)*(dwHeight))
+// Tile row masks of a dwWidth x dwHeight region
+#define WGT_BLEND_TILES( dwWidth, dwHeight )           ((((dwWidth)+WGT_BLEND_TILE-1)/WGT_BLEND_TILE)*(((dwHeight)+WGT_BLEND_TILE-1)/WGT_BLEND_TILE))
+
+typedef struct _SWGTBlendRegion
+{
+    SWGTRect sArea ;
+
+    // Shadow, rows of (width+1)/2 words, even pixel in the lower halfword
+    uint32_t* pdwShadow ;
+    // Per tile, rows captured (bit n for row n of the tile) and tiles to composite
+    uint16_t* pwCaptured ;
+    uint8_t* pucDirty ;
+    uint32_t dwTilesX ;
+    uint32_t dwTilesY ;
+
+    // Tint in LcdColor_t, and its alpha
+    uint32_t dwTint ;
+    uint32_t dwAlpha ;
+    // Draws the opaque content of the overlay with the FB_xxx functions, in screen coordinates within the area, NULL if none
+    void (*Render)( struct _SWGTBlendRegion* pRegion ) ;
+    void* pvContext ;
+
+    uint32_t dwVisible ;
+
+    struct _SWGTBlendRegion* pNext ;
+} SWGTBlendRegion ;
+
+typedef struct _SWGTBlendLayer
+{
+    LcdColor_t* pTile ;
+    uint32_t dwTilePixels ;
+    DBE_TILE_FlushCallback Flush ;
+
+    SWGTBlendRegion* pRegions ;
+
+    // Pixels captured from the strips, and pixels blended
+    uint32_t dwCaptured ;
+    uint32_t dwBlended ;
+} SWGTBlendLayer ;
+
+extern uint32_t WGT_BlendLayer_Initialize( SWGTBlendLayer* pLayer, LcdColor_t* pTile, uint32_t dwTilePixels, DBE_TILE_FlushCallback Flush ) ;
+extern uint32_t WGT_BlendLayer_Add( SWGTBlendLayer* pLayer, SWGTBlendRegion* pRegion ) ;
+extern uint32_t WGT_BlendLayer_Remove( SWGTBlendLayer* pLayer, SWGTBlendRegion* pRegion ) ;
+extern uint32_t WGT_BlendLayer_Update( SWGTBlendLayer* pLayer ) ;
+extern uint32_t WGT_BlendLayer_Flush( uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2, const LcdColor_t* pBuffer ) ;
+
+extern uint32_t WGT_BlendRegion_Initialize( SWGTBlendRegion* pRegion, uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2,
+                                            uint32_t* pdwShadow, uint16_t* pwCaptured, uint8_t* pucDirty ) ;
+extern uint32_t WGT_BlendRegion_Show( SWGTBlendRegion* pRegion, uint32_t dwShow ) ;
+extern uint32_t WGT_BlendRegion_SetTint( SWGTBlendRegion* pRegion, uint32_t dwTint, uint32_t dwAlpha ) ;
+extern uint32_t WGT_BlendRegion_Capture( SWGTBlendRegion* pRegion, uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2,
+                                         const LcdColor_t* pPixels ) ;
+extern uint32_t WGT_BlendRegion_Invalidate( SWGTBlendRegion* pRegion, uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2 ) ;
+
+/** @}
+ * @}
+ * @}
+ * @} */
+
+#endif // _SAMGUI_WIDGET_CORE_BLEND_
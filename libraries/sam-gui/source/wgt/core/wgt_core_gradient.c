@@ -0,0 +1,276 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#include "libsam_gui.h"
+
+#include <string.h>
+
+/**
+ * \addtogroup SAMGUI
+ * @{
+ *   \addtogroup SAMGUI_WGT
+ *   @{
+ *     \addtogroup SAMGUI_WGT_CORE
+ *     @{
+ *       \addtogroup SAMGUI_WGT_CORE_GRADIENT WGT Core Gradients
+ *       @{
+ */
+
+/**
+ * Bytes per LUT entry, native pixels or RGBA words.
+ */
+static uint32_t _WGT_Gradient_EntrySize( uint32_t dwNative, uint32_t dwFormat )
+{
+    if ( dwNative )
+    {
+        return (dwFormat == DISP_PIXEL_FORMAT_RGB565_2B) ? 2 : 3 ;
+    }
+
+    return sizeof( uint32_t ) ;
+}
+
+/**
+ * Truncates a color to the panel depth, RGB666 when unknown.
+ */
+static void _WGT_Gradient_Truncate( SGUIColor* pclr, uint32_t dwFormat )
+{
+    if ( dwFormat == DISP_PIXEL_FORMAT_RGB565_2B )
+    {
+        pclr->u.RGBA.ucR&=0xf8 ;
+        pclr->u.RGBA.ucG&=0xfc ;
+        pclr->u.RGBA.ucB&=0xf8 ;
+    }
+    else
+    {
+        pclr->u.RGBA.ucR&=0xfc ;
+        pclr->u.RGBA.ucG&=0xfc ;
+        pclr->u.RGBA.ucB&=0xfc ;
+    }
+    pclr->u.RGBA.ucA=0 ;
+}
+
+/**
+ * Computes the LUT for dwSteps rows or columns, reusing the current one when
+ * it has been built for the same size and format.
+ */
+static uint32_t _WGT_Gradient_Build( SWGTGradient* pGradient, uint32_t dwSteps, uint32_t dwFormat, uint32_t dwNative )
+{
+    SGUIColor clrBegin ;
+    SGUIColor clrEnd ;
+    SGUIColor clr ;
+    uint32_t dwEntry ;
+    uint32_t dw ;
+    uint8_t* puc ;
+    uint16_t w ;
+
+    if ( (pGradient->pucLUT != NULL) && (pGradient->dwSteps == dwSteps) &&
+         (pGradient->dwFormat == dwFormat) && (pGradient->dwNative == dwNative) )
+    {
+        return SAMGUI_E_OK ;
+    }
+
+    WGT_Gradient_Free( pGradient ) ;
+
+    dwEntry=_WGT_Gradient_EntrySize( dwNative, dwFormat ) ;
+    pGradient->pucLUT=SAMGUI_Malloc( dwSteps*dwEntry ) ;
+    if ( pGradient->pucLUT == NULL )
+    {
+        return SAMGUI_E_NOT_ENOUGH_MEMORY ;
+    }
+
+    clrBegin.u.dwRGBA=pGradient->dwBegin ;
+    clrEnd.u.dwRGBA=pGradient->dwEnd ;
+
+    for ( dw=0, puc=pGradient->pucLUT ; dw < dwSteps ; dw++, puc+=dwEntry )
+    {
+        COLOR_GetGradientValue( &clrBegin, &clrEnd, dwSteps, dw, &clr ) ;
+        _WGT_Gradient_Truncate( &clr, dwFormat ) ;
+
+        if ( !dwNative )
+        {
+            memcpy( puc, &clr.u.dwRGBA, sizeof( uint32_t ) ) ;
+        }
+        else
+        {
+            if ( dwFormat == DISP_PIXEL_FORMAT_RGB565_2B )
+            {
+                w=((clr.u.RGBA.ucR >> 3) << 11) | ((clr.u.RGBA.ucG >> 2) << 5) | (clr.u.RGBA.ucB >> 3) ;
+                puc[0]=w & 0xff ;
+                puc[1]=w >> 8 ;
+            }
+            else
+            {
+                puc[0]=clr.u.RGBA.ucR ;
+                puc[1]=clr.u.RGBA.ucG ;
+                puc[2]=clr.u.RGBA.ucB ;
+            }
+        }
+    }
+
+    pGradient->dwSteps=dwSteps ;
+    pGradient->dwFormat=dwFormat ;
+    pGradient->dwNative=dwNative ;
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Sets the colors and direction of a gradient, the LUT being dropped only
+ * when they change.
+ */
+extern uint32_t WGT_Gradient_Set( SWGTGradient* pGradient, uint32_t dwBegin, uint32_t dwEnd, uint32_t dwDirection )
+{
+    if ( pGradient == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( dwDirection > WGT_GRADIENT_HORIZONTAL )
+    {
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+
+    if ( (pGradient->dwBegin != dwBegin) || (pGradient->dwEnd != dwEnd) || (pGradient->dwDirection != dwDirection) )
+    {
+        WGT_Gradient_Free( pGradient ) ;
+
+        pGradient->dwBegin=dwBegin ;
+        pGradient->dwEnd=dwEnd ;
+        pGradient->dwDirection=dwDirection ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Fills the dwWidth x dwHeight rectangle at (dwX, dwY) with the gradient,
+ * building its LUT first if the size or the panel format changed.
+ */
+extern uint32_t WGT_Gradient_Draw( SWGTGradient* pGradient, SDISPBackend* pBE, uint32_t dwX, uint32_t dwY, uint32_t dwWidth, uint32_t dwHeight )
+{
+    uint32_t dwFormat=DISP_PIXEL_FORMAT_NONE ;
+    uint32_t dwLength=sizeof( dwFormat ) ;
+    uint32_t dwNative=0 ;
+    uint32_t dwSteps ;
+    uint32_t dwStart ;
+    uint32_t dw ;
+    uint32_t* pdwLUT ;
+    SGUIColor clr ;
+    uint32_t dwResult ;
+
+    if ( (pGradient == NULL) || (pBE == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( (pGradient->dwDirection == WGT_GRADIENT_NONE) || (pBE->DrawFilledRectangle == NULL) )
+    {
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+
+    if ( (dwWidth == 0) || (dwHeight == 0) )
+    {
+        return SAMGUI_E_OK ;
+    }
+
+    if ( pBE->IOCtl != NULL )
+    {
+        pBE->IOCtl( DISP_BACKEND_IOCTL_GET_PIXEL_FORMAT, &dwFormat, &dwLength ) ;
+    }
+
+    // Only a horizontal gradient has rows of different colors to write natively
+    if ( pGradient->dwDirection == WGT_GRADIENT_VERTICAL )
+    {
+        dwSteps=dwHeight ;
+    }
+    else
+    {
+        dwSteps=dwWidth ;
+        dwNative=(pBE->DrawNative != NULL) && (dwFormat != DISP_PIXEL_FORMAT_NONE) ;
+    }
+
+    dwResult=_WGT_Gradient_Build( pGradient, dwSteps, dwFormat, dwNative ) ;
+    if ( dwResult != SAMGUI_E_OK )
+    {
+        return dwResult ;
+    }
+
+    if ( dwNative )
+    {
+        for ( dw=0 ; dw < dwHeight ; dw++ )
+        {
+            dwResult=pBE->DrawNative( dwX, dwY+dw, dwWidth, 1, pGradient->pucLUT ) ;
+            if ( dwResult != SAMGUI_E_OK )
+            {
+                return dwResult ;
+            }
+        }
+
+        return SAMGUI_E_OK ;
+    }
+
+    // One filled rectangle per run of rows or columns of the same color
+    pdwLUT=(uint32_t*)pGradient->pucLUT ;
+    for ( dwStart=0 ; dwStart < dwSteps ; dwStart=dw )
+    {
+        for ( dw=dwStart+1 ; (dw < dwSteps) && (pdwLUT[dw] == pdwLUT[dwStart]) ; dw++ )
+        {
+        }
+
+        clr.u.dwRGBA=pdwLUT[dwStart] ;
+        if ( pGradient->dwDirection == WGT_GRADIENT_VERTICAL )
+        {
+            pBE->DrawFilledRectangle( dwX, dwY+dwStart, dwX+dwWidth-1, dwY+dw-1, NULL, &clr ) ;
+        }
+        else
+        {
+            pBE->DrawFilledRectangle( dwX+dwStart, dwY, dwX+dw-1, dwY+dwHeight-1, NULL, &clr ) ;
+        }
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Releases the LUT of a gradient, which is rebuilt by the next draw.
+ */
+extern void WGT_Gradient_Free( SWGTGradient* pGradient )
+{
+    if ( (pGradient != NULL) && (pGradient->pucLUT != NULL) )
+    {
+        SAMGUI_Free( pGradient->pucLUT ) ;
+        pGradient->pucLUT=NULL ;
+        pGradient->dwSteps=0 ;
+    }
+}
+
+/** @}
+ * @}
+ * @}
+ * @} */
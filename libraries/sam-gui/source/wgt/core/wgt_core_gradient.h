@@ -0,0 +1,90 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef _SAMGUI_WIDGET_CORE_GRADIENT_
+#define _SAMGUI_WIDGET_CORE_GRADIENT_
+
+#include "source/disp/disp_backend.h"
+
+/**
+ * \addtogroup SAMGUI
+ * @{
+ *   \addtogroup SAMGUI_WGT
+ *   @{
+ *     \addtogroup SAMGUI_WGT_CORE
+ *     @{
+ *       \addtogroup SAMGUI_WGT_CORE_GRADIENT WGT Core Gradients
+ *       @{
+ *
+ * \brief Gradient fills drawn from a precomputed line.
+ *
+ * The colors of a gradient are computed once into a LUT, one entry per row
+ * (vertical) or per column (horizontal), and kept until the size, the colors
+ * or the panel pixel format change. A repaint then costs no color math:
+ *  - vertical: each run of rows of the same panel color is one filled
+ *    rectangle, a single windowed burst in the backend;
+ *  - horizontal: the LUT is the row in the panel format, written with
+ *    DrawNative() once per row, or as filled rectangles of the runs of
+ *    columns of the same color when the backend has no DrawNative().
+ * Colors are truncated to the panel depth when building the LUT, so that the
+ * runs are as long as the panel allows.
+ */
+
+typedef enum _WGT_GradientDirection
+{
+    WGT_GRADIENT_NONE,            // flat background
+    WGT_GRADIENT_VERTICAL,        // top to bottom
+    WGT_GRADIENT_HORIZONTAL       // left to right
+} WGT_GradientDirection ;
+
+typedef struct _SWGTGradient
+{
+    uint32_t dwDirection ;
+    // Colors in SGUIColor RGBA
+    uint32_t dwBegin ;
+    uint32_t dwEnd ;
+
+    // What the LUT was built for, dwSteps is 0 when there is no LUT
+    uint32_t dwSteps ;
+    uint32_t dwFormat ;
+    uint32_t dwNative ;
+    // dwSteps pixels in the panel format when dwNative, else RGBA words
+    uint8_t* pucLUT ;
+} SWGTGradient ;
+
+extern uint32_t WGT_Gradient_Set( SWGTGradient* pGradient, uint32_t dwBegin, uint32_t dwEnd, uint32_t dwDirection ) ;
+extern uint32_t WGT_Gradient_Draw( SWGTGradient* pGradient, SDISPBackend* pBE, uint32_t dwX, uint32_t dwY, uint32_t dwWidth, uint32_t dwHeight ) ;
+extern void WGT_Gradient_Free( SWGTGradient* pGradient ) ;
+
+/** @}
+ * @}
+ * @}
+ * @} */
+
+#endif // _SAMGUI_WIDGET_CORE_GRADIENT_
@@ -44,6 +44,43 @@
  * \brief WGT Messages definitions.
  */
 
+// Messages posted from ISR handlers, power of two
+#define WGT_CORE_ISR_RING_SIZE    16
+
+#define WGT_CORE_ISR_NO_SLOT      0xffffffffUL
+
+/* Single producer (ISR) single consumer (GUI task) ring, free running
+ * indexes. gs_dwISRReading is the slot the task is copying, the ISR never
+ * merges into it. */
+static volatile SWGTCoreMessage gs_asISRRing[WGT_CORE_ISR_RING_SIZE] ;
+static volatile uint32_t gs_dwISRHead=0 ;
+static volatile uint32_t gs_dwISRTail=0 ;
+static volatile uint32_t gs_dwISRReading=WGT_CORE_ISR_NO_SLOT ;
+
+/**
+ * Tell whether a new message supersedes the pending one: pointer moves of the
+ * same kind, or the same timer.
+ */
+static uint32_t _WGT_IsSuperseded( volatile SWGTCoreMessage* pMsg, uint32_t dwMsgID, uint32_t dwParam1 )
+{
+    if ( pMsg->dwID != dwMsgID )
+    {
+        return 0 ;
+    }
+
+    switch ( dwMsgID )
+    {
+        case WGT_MSG_POINTER_RAW :
+        case WGT_MSG_POINTER :
+            return 1 ;
+
+        case WGT_MSG_TIMER :
+            return (pMsg->dwParam1 == dwParam1) ;
+    }
+
+    return 0 ;
+}
+
 /**
  * Send a message from a task
  */
@@ -90,17 +127,93 @@ extern uint32_t WGT_SendMessageISR( uint32_t dwMsgID, uint32_t dwParam1, uint32_
 
 /**
  * Post a message from an ISR Handler
+ *
+ * The message goes to a lock-free ring rather than to the task queue. A
+ * pointer move or timer message still pending at the end of the ring is
+ * updated in place, latest position wins, so a drag leaves at most one move
+ * between two other messages whatever the sampling rate. The task queue only
+ * gets a WGT_MSG_ISR_PENDING when the ring was empty, to wake the GUI task.
+ * All callers must run at the same interrupt priority, as the ring has a
+ * single producer.
  */
 extern uint32_t WGT_PostMessageISR( uint32_t dwMsgID, uint32_t dwParam1, uint32_t dwParam2 )
 {
     SWGTCoreMessage sMsg ;
+    volatile SWGTCoreMessage* pSlot ;
+    uint32_t dwHead=gs_dwISRHead ;
+    uint32_t dwTail=gs_dwISRTail ;
 
-    sMsg.dwID=dwMsgID ;
-    sMsg.dwParam1=dwParam1 ;
-    sMsg.dwParam2=dwParam2 ;
+    if ( dwHead != dwTail )
+    {
+        pSlot=&gs_asISRRing[(dwHead-1) & (WGT_CORE_ISR_RING_SIZE-1)] ;
 
-    /* Post message */
-    return SAMGUI_QueueSendToBackFromISR( g_WGT_CoreData.hMessagesQueue, &sMsg ) ;
+        if ( ((dwHead-1) != gs_dwISRReading) && _WGT_IsSuperseded( pSlot, dwMsgID, dwParam1 ) )
+        {
+            pSlot->dwParam1=dwParam1 ;
+            pSlot->dwParam2=dwParam2 ;
+
+            return SAMGUI_E_OK ;
+        }
+    }
+
+    if ( (dwHead - dwTail) >= WGT_CORE_ISR_RING_SIZE )
+    {
+        return SAMGUI_E_MSQUEUE ;
+    }
+
+    pSlot=&gs_asISRRing[dwHead & (WGT_CORE_ISR_RING_SIZE-1)] ;
+    pSlot->dwID=dwMsgID ;
+    pSlot->dwParam1=dwParam1 ;
+    pSlot->dwParam2=dwParam2 ;
+    gs_dwISRHead=dwHead+1 ;
+
+    if ( dwHead == dwTail )
+    {
+        sMsg.dwID=WGT_MSG_ISR_PENDING ;
+        sMsg.dwParam1=0 ;
+        sMsg.dwParam2=0 ;
+
+        /* A full queue wakes the task anyway */
+        SAMGUI_QueueSendToBackFromISR( g_WGT_CoreData.hMessagesQueue, &sMsg ) ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Get the oldest message posted from an ISR Handler, from the GUI task only.
+ * Returns SAMGUI_E_MSQUEUE when none is pending.
+ */
+extern uint32_t WGT_GetMessageISR( SWGTCoreMessage* pMsg )
+{
+    volatile SWGTCoreMessage* pSlot ;
+    uint32_t dwTail=gs_dwISRTail ;
+
+    if ( dwTail == gs_dwISRHead )
+    {
+        return SAMGUI_E_MSQUEUE ;
+    }
+
+    /* Claim the slot before copying it, the ISR then appends rather than merge */
+    gs_dwISRReading=dwTail ;
+
+    pSlot=&gs_asISRRing[dwTail & (WGT_CORE_ISR_RING_SIZE-1)] ;
+    pMsg->dwID=pSlot->dwID ;
+    pMsg->dwParam1=pSlot->dwParam1 ;
+    pMsg->dwParam2=pSlot->dwParam2 ;
+
+    gs_dwISRTail=dwTail+1 ;
+    gs_dwISRReading=WGT_CORE_ISR_NO_SLOT ;
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Return the number of messages posted from ISR Handlers not yet got.
+ */
+extern uint32_t WGT_GetPendingMessagesISR( void )
+{
+    return gs_dwISRHead - gs_dwISRTail ;
 }
 
 /** @}
@@ -63,6 +63,7 @@ typedef enum _WGT_Message
     WGT_MSG_USER3,
     WGT_MSG_USER4,
     WGT_MSG_USER5,
+    WGT_MSG_ISR_PENDING,          // wakes the GUI task, see WGT_PostMessageISR()
     WGT_MSG_MAX
 } WGT_Message ;
 
@@ -91,6 +92,8 @@ extern uint32_t WGT_SendMessage( uint32_t dwMsgID, uint32_t dwParam1, uint32_t d
 extern uint32_t WGT_PostMessage( uint32_t dwMsgID, uint32_t dwParam1, uint32_t dwParam2 ) ;
 extern uint32_t WGT_SendMessageISR( uint32_t dwMsgID, uint32_t dwParam1, uint32_t dwParam2 ) ;
 extern uint32_t WGT_PostMessageISR( uint32_t dwMsgID, uint32_t dwParam1, uint32_t dwParam2 ) ;
+extern uint32_t WGT_GetMessageISR( SWGTCoreMessage* pMsg ) ;
+extern uint32_t WGT_GetPendingMessagesISR( void ) ;
 
 /** @}
  * @}
@@ -46,6 +46,102 @@
  * \brief WGT Screens.
  */
 
+/**
+ * Sets the backend clipping rectangle, if the backend supports it
+ */
+static void _WGT_Screen_SetClip( const SWGTRect* pRect )
+{
+    if ( g_WGT_CoreData.pBE->SetClipRect != NULL )
+    {
+        g_WGT_CoreData.pBE->SetClipRect( pRect->dwX1, pRect->dwY1, pRect->dwX2, pRect->dwY2 ) ;
+    }
+}
+
+static uint32_t _WGT_Rect_Area( const SWGTRect* pRect )
+{
+    return (pRect->dwX2-pRect->dwX1+1)*(pRect->dwY2-pRect->dwY1+1) ;
+}
+
+static void _WGT_Rect_Union( SWGTRect* pResult, const SWGTRect* pRect1, const SWGTRect* pRect2 )
+{
+    pResult->dwX1=(pRect1->dwX1 < pRect2->dwX1)?pRect1->dwX1:pRect2->dwX1 ;
+    pResult->dwY1=(pRect1->dwY1 < pRect2->dwY1)?pRect1->dwY1:pRect2->dwY1 ;
+    pResult->dwX2=(pRect1->dwX2 > pRect2->dwX2)?pRect1->dwX2:pRect2->dwX2 ;
+    pResult->dwY2=(pRect1->dwY2 > pRect2->dwY2)?pRect1->dwY2:pRect2->dwY2 ;
+}
+
+static uint32_t _WGT_Rect_Intersects( const SWGTRect* pRect, const SWGT_Widget* pWidget )
+{
+    return (pWidget->dwX <= pRect->dwX2) && (pWidget->dwX+pWidget->dwWidth > pRect->dwX1) &&
+           (pWidget->dwY <= pRect->dwY2) && (pWidget->dwY+pWidget->dwHeight > pRect->dwY1) ;
+}
+
+#if WGT_USE_HIT_GRID
+/* Size in pixels of a hit-test grid cell */
+#define WGT_HIT_CELL_WIDTH   ((BOARD_LCD_WIDTH+WGT_HIT_GRID_COLS-1)/WGT_HIT_GRID_COLS)
+#define WGT_HIT_CELL_HEIGHT  ((BOARD_LCD_HEIGHT+WGT_HIT_GRID_ROWS-1)/WGT_HIT_GRID_ROWS)
+
+/**
+ * Sets or clears the bit of a widget in the hit-test grid cells it covers
+ */
+static void _WGT_Screen_GridUpdate( SWGTScreen* pScreen, uint32_t dwIndex, uint32_t dwSet )
+{
+    SWGT_Widget* pWidget=pScreen->apWidgets[dwIndex] ;
+    uint32_t dwCol1, dwCol2 ;
+    uint32_t dwRow1, dwRow2 ;
+    uint32_t dwCol, dwRow ;
+
+    // Only buttons are returned by WGT_Screen_GetPointedWidget
+    if ( (pWidget->dwType != WGT_TYPE_BUTTON) || (pWidget->dwWidth == 0) || (pWidget->dwHeight == 0) )
+    {
+        return ;
+    }
+
+    dwCol1=pWidget->dwX/WGT_HIT_CELL_WIDTH ;
+    dwRow1=pWidget->dwY/WGT_HIT_CELL_HEIGHT ;
+    dwCol2=(pWidget->dwX+pWidget->dwWidth-1)/WGT_HIT_CELL_WIDTH ;
+    dwRow2=(pWidget->dwY+pWidget->dwHeight-1)/WGT_HIT_CELL_HEIGHT ;
+
+    if ( dwCol1 >= WGT_HIT_GRID_COLS ) dwCol1=WGT_HIT_GRID_COLS-1 ;
+    if ( dwRow1 >= WGT_HIT_GRID_ROWS ) dwRow1=WGT_HIT_GRID_ROWS-1 ;
+    if ( dwCol2 >= WGT_HIT_GRID_COLS ) dwCol2=WGT_HIT_GRID_COLS-1 ;
+    if ( dwRow2 >= WGT_HIT_GRID_ROWS ) dwRow2=WGT_HIT_GRID_ROWS-1 ;
+
+    for ( dwRow=dwRow1 ; dwRow <= dwRow2 ; dwRow++ )
+    {
+        for ( dwCol=dwCol1 ; dwCol <= dwCol2 ; dwCol++ )
+        {
+            if ( dwSet )
+            {
+                pScreen->adwHitGrid[dwRow][dwCol]|=(1UL << dwIndex) ;
+            }
+            else
+            {
+                pScreen->adwHitGrid[dwRow][dwCol]&=~(1UL << dwIndex) ;
+            }
+        }
+    }
+}
+#endif // WGT_USE_HIT_GRID
+
+/**
+ * Erases the screen background inside a region
+ */
+static void _WGT_Screen_EraseRect( SWGTScreen* pScreen, const SWGTRect* pRect )
+{
+    if ( pScreen->pucBmpBackground == NULL )
+    {
+        SGUIColor clr={ .u.dwRGBA=pScreen->dwClrBackground } ;
+
+        g_WGT_CoreData.pBE->DrawFilledRectangle( pRect->dwX1, pRect->dwY1, pRect->dwX2, pRect->dwY2, NULL, &clr ) ;
+    }
+    else
+    {
+        // The backend clipping keeps the bitmap inside the region
+        g_WGT_CoreData.pBE->DrawBitmap( 0, 0, BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT, pScreen->pucBmpBackground ) ;
+    }
+}
+
 /**
  * Initializes a screen
  */
@@ -55,6 +151,10 @@ extern uint32_t WGT_Screen_Initialize( SWGTScreen* pScreen, uint32_t dwClrBackgr
     pScreen->dwWidgets=0 ;
     pScreen->pWidgetOld=NULL ;
     pScreen->pWidgetCurrent=NULL ;
+    pScreen->dwDirtyRects=0 ;
+#if WGT_USE_HIT_GRID
+    memset( pScreen->adwHitGrid, 0, sizeof( pScreen->adwHitGrid ) ) ;
+#endif // WGT_USE_HIT_GRID
 
     pScreen->dwClrBackground=dwClrBackground ;
     pScreen->pucBmpBackground=pucBmpBackground ;
@@ -81,6 +181,9 @@ extern uint32_t WGT_Screen_Exit( SWGTScreen* pScreen )
     pScreen->dwWidgets=0 ;
     pScreen->pWidgetOld=NULL ;
     pScreen->pWidgetCurrent=NULL ;
+#if WGT_USE_HIT_GRID
+    memset( pScreen->adwHitGrid, 0, sizeof( pScreen->adwHitGrid ) ) ;
+#endif // WGT_USE_HIT_GRID
 
     return SAMGUI_E_OK ;
 }
@@ -103,28 +206,85 @@ extern uint32_t WGT_Screen_AddWidget( SWGTScreen* pScreen, SWGT_Widget* pWidget
 
     pScreen->apWidgets[pScreen->dwWidgets]=pWidget ;
     pWidget->dwID=pScreen->dwWidgets ;
+#if WGT_USE_HIT_GRID
+    _WGT_Screen_GridUpdate( pScreen, pScreen->dwWidgets, 1 ) ;
+#endif // WGT_USE_HIT_GRID
 
     pScreen->dwWidgets++ ;
 
     return SAMGUI_E_OK ;
 }
 
+/**
+ * Moves and/or resizes a widget of a screen, keeping the hit-test index
+ * up to date. Both the old and new areas are invalidated.
+ */
+extern uint32_t WGT_Screen_MoveWidget( SWGTScreen* pScreen, SWGT_Widget* pWidget, uint32_t dwX, uint32_t dwY, uint32_t dwWidth, uint32_t dwHeight )
+{
+    if ( (pScreen == NULL) || (pWidget == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( (pWidget->dwID >= pScreen->dwWidgets) || (pScreen->apWidgets[pWidget->dwID] != pWidget) )
+    {
+        return SAMGUI_E_INVALID_WIDGET ;
+    }
+
+    WGT_Screen_InvalidateWidget( pScreen, pWidget ) ;
+#if WGT_USE_HIT_GRID
+    _WGT_Screen_GridUpdate( pScreen, pWidget->dwID, 0 ) ;
+#endif // WGT_USE_HIT_GRID
+
+    pWidget->dwX=dwX ;
+    pWidget->dwY=dwY ;
+    pWidget->dwWidth=dwWidth ;
+    pWidget->dwHeight=dwHeight ;
+
+#if WGT_USE_HIT_GRID
+    _WGT_Screen_GridUpdate( pScreen, pWidget->dwID, 1 ) ;
+#endif // WGT_USE_HIT_GRID
+    WGT_Screen_InvalidateWidget( pScreen, pWidget ) ;
+
+    return SAMGUI_E_OK ;
+}
+
 /**
  * Returns the pointed widget from a screen
  */
 extern uint32_t WGT_Screen_GetPointedWidget( SWGTScreen* pScreen, uint32_t dwX, uint32_t dwY, SWGT_Widget** ppWidget )
 {
     uint32_t dw ;
+#if WGT_USE_HIT_GRID
+    uint32_t dwCol ;
+    uint32_t dwRow ;
+    uint32_t dwMask ;
+#endif // WGT_USE_HIT_GRID
 
     if ( pScreen == NULL )
     {
         return SAMGUI_E_BAD_POINTER ;
     }
 
+#if WGT_USE_HIT_GRID
+    // Only test the widgets covering the pointed grid cell, in list order
+    dwCol=dwX/WGT_HIT_CELL_WIDTH ;
+    dwRow=dwY/WGT_HIT_CELL_HEIGHT ;
+    if ( (dwCol >= WGT_HIT_GRID_COLS) || (dwRow >= WGT_HIT_GRID_ROWS) )
+    {
+        return SAMGUI_E_NO_SELECTED_WIDGET ;
+    }
+
+    for ( dw=0, dwMask=pScreen->adwHitGrid[dwRow][dwCol] ; dwMask != 0 ; dw++, dwMask>>=1 )
+    {
+        if ( (dwMask & 1) && pScreen->apWidgets[dw] )
+        {
+#else
     for ( dw=0 ; dw < pScreen->dwWidgets ; dw++ )
     {
         if ( pScreen->apWidgets[dw] )
         {
+#endif // WGT_USE_HIT_GRID
             // Check bounding box
             if ( (dwX >= pScreen->apWidgets[dw]->dwX) && (dwX < pScreen->apWidgets[dw]->dwX+pScreen->apWidgets[dw]->dwWidth) &&
                  (dwY >= pScreen->apWidgets[dw]->dwY) && (dwY < pScreen->apWidgets[dw]->dwY+pScreen->apWidgets[dw]->dwHeight) )
@@ -252,38 +412,180 @@ extern uint32_t WGT_Screen_SetSelectedWidget( SWGTScreen* pScreen, SWGT_Widget*
 //}
 
 /**
- * Default screen callback for WGT_MSG_PAINT
+ * Marks a screen region for repaint. Regions are merged with the pending ones
+ * when the union does not cover more pixels than the separate regions, and the
+ * first invalidation of a frame posts the WGT_MSG_PAINT message.
+ * Must be called from the GUI task.
  */
-extern uint32_t WGT_Screen_OnPaint( SWGTScreen* pScreen )
+extern uint32_t WGT_Screen_InvalidateRect( SWGTScreen* pScreen, uint32_t dwX, uint32_t dwY, uint32_t dwWidth, uint32_t dwHeight )
 {
+    SWGTRect sRect ;
+    SWGTRect sUnion ;
     uint32_t dw ;
+    uint32_t dwBest ;
+    uint32_t dwGrowth ;
+    uint32_t dwBestGrowth ;
 
-    for ( dw=0 ; dw < pScreen->dwWidgets ; dw++ )
+    if ( pScreen == NULL )
     {
-        if ( pScreen->apWidgets[dw] )
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( (dwWidth == 0) || (dwHeight == 0) || (dwX >= BOARD_LCD_WIDTH) || (dwY >= BOARD_LCD_HEIGHT) )
+    {
+        return SAMGUI_E_OK ;
+    }
+
+    sRect.dwX1=dwX ;
+    sRect.dwY1=dwY ;
+    sRect.dwX2=(dwX+dwWidth > BOARD_LCD_WIDTH)?BOARD_LCD_WIDTH-1:dwX+dwWidth-1 ;
+    sRect.dwY2=(dwY+dwHeight > BOARD_LCD_HEIGHT)?BOARD_LCD_HEIGHT-1:dwY+dwHeight-1 ;
+
+    if ( pScreen->dwDirtyRects == 0 )
+    {
+        pScreen->asDirtyRects[0]=sRect ;
+        pScreen->dwDirtyRects=1 ;
+
+        if ( pScreen == g_WGT_CoreData.pCurrentScreen )
+        {
+            WGT_PostMessage( WGT_MSG_PAINT, 0, 0 ) ;
+        }
+
+        return SAMGUI_E_OK ;
+    }
+
+    // Absorb every pending region the new one overlaps or touches
+    for ( dw=0 ; dw < pScreen->dwDirtyRects ; )
+    {
+        _WGT_Rect_Union( &sUnion, &pScreen->asDirtyRects[dw], &sRect ) ;
+
+        if ( _WGT_Rect_Area( &sUnion ) <= _WGT_Rect_Area( &pScreen->asDirtyRects[dw] ) + _WGT_Rect_Area( &sRect ) )
+        {
+            sRect=sUnion ;
+            pScreen->dwDirtyRects-- ;
+            pScreen->asDirtyRects[dw]=pScreen->asDirtyRects[pScreen->dwDirtyRects] ;
+            dw=0 ;
+        }
+        else
         {
-            WGT_Draw( pScreen->apWidgets[dw], g_WGT_CoreData.pBE ) ;
+            dw++ ;
         }
     }
 
+    if ( pScreen->dwDirtyRects < WGT_MAX_DIRTY_RECTS )
+    {
+        pScreen->asDirtyRects[pScreen->dwDirtyRects++]=sRect ;
+
+        return SAMGUI_E_OK ;
+    }
+
+    // No free slot, merge with the region growing the least
+    dwBest=0 ;
+    dwBestGrowth=0xFFFFFFFF ;
+    for ( dw=0 ; dw < pScreen->dwDirtyRects ; dw++ )
+    {
+        _WGT_Rect_Union( &sUnion, &pScreen->asDirtyRects[dw], &sRect ) ;
+        dwGrowth=_WGT_Rect_Area( &sUnion )-_WGT_Rect_Area( &pScreen->asDirtyRects[dw] ) ;
+
+        if ( dwGrowth < dwBestGrowth )
+        {
+            dwBestGrowth=dwGrowth ;
+            dwBest=dw ;
+        }
+    }
+    _WGT_Rect_Union( &pScreen->asDirtyRects[dwBest], &pScreen->asDirtyRects[dwBest], &sRect ) ;
+
     return SAMGUI_E_OK ;
 }
 
 /**
- * Default screen callback for WGT_MSG_ERASE_BKGND
+ * Marks the area covered by a widget for repaint
  */
-extern uint32_t WGT_Screen_OnEraseBackground( SWGTScreen* pScreen )
+extern uint32_t WGT_Screen_InvalidateWidget( SWGTScreen* pScreen, SWGT_Widget* pWidget )
 {
-    if ( pScreen->pucBmpBackground == NULL )
+    if ( pWidget == NULL )
     {
-        SGUIColor clr={ .u.dwRGBA=pScreen->dwClrBackground } ;
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    return WGT_Screen_InvalidateRect( pScreen, pWidget->dwX, pWidget->dwY, pWidget->dwWidth, pWidget->dwHeight ) ;
+}
+
+/**
+ * Default screen callback for WGT_MSG_PAINT.
+ * Without pending dirty regions, all widgets are drawn. Otherwise each region
+ * background is erased and only the widgets crossing it are drawn, clipped to
+ * the region. The clipping is left to the bounding box of the regions for the
+ * screen OnPaint callback, WGT_Screen_EndPaint() restores it.
+ */
+extern uint32_t WGT_Screen_OnPaint( SWGTScreen* pScreen )
+{
+    uint32_t dw ;
+    uint32_t dwRect ;
+    SWGTRect sBounds ;
+
+    if ( pScreen->dwDirtyRects == 0 )
+    {
+        for ( dw=0 ; dw < pScreen->dwWidgets ; dw++ )
+        {
+            if ( pScreen->apWidgets[dw] )
+            {
+                WGT_Draw( pScreen->apWidgets[dw], g_WGT_CoreData.pBE ) ;
+            }
+        }
 
-        g_WGT_CoreData.pBE->DrawFilledRectangle( 0, 0, BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT, NULL, &clr ) ;
+        return SAMGUI_E_OK ;
     }
-    else
+
+    sBounds=pScreen->asDirtyRects[0] ;
+    for ( dwRect=0 ; dwRect < pScreen->dwDirtyRects ; dwRect++ )
     {
-        g_WGT_CoreData.pBE->DrawBitmap( 0, 0, BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT, pScreen->pucBmpBackground ) ;
+        _WGT_Screen_SetClip( &pScreen->asDirtyRects[dwRect] ) ;
+        _WGT_Screen_EraseRect( pScreen, &pScreen->asDirtyRects[dwRect] ) ;
+
+        for ( dw=0 ; dw < pScreen->dwWidgets ; dw++ )
+        {
+            if ( pScreen->apWidgets[dw] && _WGT_Rect_Intersects( &pScreen->asDirtyRects[dwRect], pScreen->apWidgets[dw] ) )
+            {
+                WGT_Draw( pScreen->apWidgets[dw], g_WGT_CoreData.pBE ) ;
+            }
+        }
+
+        _WGT_Rect_Union( &sBounds, &sBounds, &pScreen->asDirtyRects[dwRect] ) ;
     }
+    pScreen->dwDirtyRects=0 ;
+
+    _WGT_Screen_SetClip( &sBounds ) ;
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Ends a WGT_MSG_PAINT processing, flushes buffered backends and restores whole
+ * screen clipping
+ */
+extern uint32_t WGT_Screen_EndPaint( SWGTScreen* pScreen )
+{
+    SWGTRect sScreen={ 0, 0, BOARD_LCD_WIDTH-1, BOARD_LCD_HEIGHT-1 } ;
+
+    (void)pScreen ;
+    if ( g_WGT_CoreData.pBE->IOCtl != NULL )
+    {
+        g_WGT_CoreData.pBE->IOCtl( DISP_BACKEND_IOCTL_FLUSH, NULL, NULL ) ;
+    }
+    _WGT_Screen_SetClip( &sScreen ) ;
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Default screen callback for WGT_MSG_ERASE_BKGND
+ */
+extern uint32_t WGT_Screen_OnEraseBackground( SWGTScreen* pScreen )
+{
+    SWGTRect sScreen={ 0, 0, BOARD_LCD_WIDTH-1, BOARD_LCD_HEIGHT-1 } ;
+
+    _WGT_Screen_EraseRect( pScreen, &sScreen ) ;
 
     return SAMGUI_E_OK ;
 }
@@ -47,6 +47,28 @@
  */
 
 #define WGT_MAX_WIDGETS      16
+#define WGT_MAX_DIRTY_RECTS  4
+
+/* Hit-test grid: each cell holds a bit mask of the pointable widgets covering it.
+   Set WGT_USE_HIT_GRID to 0 to fall back on a linear search. */
+#ifndef WGT_USE_HIT_GRID
+#  define WGT_USE_HIT_GRID   1
+#endif
+#define WGT_HIT_GRID_COLS    4
+#define WGT_HIT_GRID_ROWS    5
+
+#if WGT_USE_HIT_GRID && (WGT_MAX_WIDGETS > 32)
+#  error WGT_MAX_WIDGETS must not exceed the 32 bits of a hit-test grid cell
+#endif
+
+/* Screen region, inclusive coordinates */
+typedef struct _SWGTRect
+{
+    uint32_t dwX1 ;
+    uint32_t dwY1 ;
+    uint32_t dwX2 ;
+    uint32_t dwY2 ;
+} SWGTRect ;
 
 typedef struct _SWGTScreen
 {
@@ -57,6 +79,11 @@ typedef struct _SWGTScreen
     uint8_t* pucBmpBackground ;                      /* screen background bitmap */
     SWGT_Widget* pWidgetOld ;                        /* previously selected widget */
     SWGT_Widget* pWidgetCurrent ;                    /* current selected widget */
+    SWGTRect asDirtyRects[WGT_MAX_DIRTY_RECTS] ;     /* regions to repaint on next WGT_MSG_PAINT */
+    uint32_t dwDirtyRects ;                          /* number of dirty regions, 0 means whole screen */
+#if WGT_USE_HIT_GRID
+    uint32_t adwHitGrid[WGT_HIT_GRID_ROWS][WGT_HIT_GRID_COLS] ; /* pointable widgets per cell, bit n for apWidgets[n] */
+#endif // WGT_USE_HIT_GRID
 
     /* Screen hooks */
     uint32_t (*HkBeforePaint)( struct _SWGTScreen* pScreen ) ;
@@ -82,6 +109,7 @@ extern uint32_t WGT_Screen_Exit( SWGTScreen* pScreen ) ;
 
 extern uint32_t WGT_Screen_AddWidget( SWGTScreen* pScreen, SWGT_Widget* pWidget ) ;
 extern uint32_t WGT_Screen_GetPointedWidget( SWGTScreen* pScreen, uint32_t dwX, uint32_t dwY, SWGT_Widget** ppWidget ) ;
+extern uint32_t WGT_Screen_MoveWidget( SWGTScreen* pScreen, SWGT_Widget* pWidget, uint32_t dwX, uint32_t dwY, uint32_t dwWidth, uint32_t dwHeight ) ;
 
 extern uint32_t WGT_Screen_GetSelectedWidget( SWGTScreen* pScreen, SWGT_Widget** ppWidget ) ;
 extern uint32_t WGT_Screen_SetSelectedWidget( SWGTScreen* pScreen, SWGT_Widget* pWidget ) ;
@@ -90,8 +118,12 @@ extern uint32_t WGT_Screen_SetSelectedWidget( SWGTScreen* pScreen, SWGT_Widget*
 
 //
 extern uint32_t WGT_Screen_OnPaint( SWGTScreen* pScreen ) ;
+extern uint32_t WGT_Screen_EndPaint( SWGTScreen* pScreen ) ;
 extern uint32_t WGT_Screen_OnEraseBackground( SWGTScreen* pScreen ) ;
 
+extern uint32_t WGT_Screen_InvalidateRect( SWGTScreen* pScreen, uint32_t dwX, uint32_t dwY, uint32_t dwWidth, uint32_t dwHeight ) ;
+extern uint32_t WGT_Screen_InvalidateWidget( SWGTScreen* pScreen, SWGT_Widget* pWidget ) ;
+
 #if 0
 extern uint32_t WGT_Screen_SendMessageID( SWGTScreen* pScreen, uint32_t dwID, uint32_t dwMsgID, uint32_t dwParam1, uint32_t dwParam2 ) ;
 extern uint32_t WGT_Screen_SendMessageHdl( SWGTScreen* pScreen, SWGT_Widget* pWidget, uint32_t dwMsgID, uint32_t dwParam1, uint32_t dwParam2 ) ;
@@ -0,0 +1,523 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#include "board.h"
+
+#include "libsam_gui.h"
+
+#include <string.h>
+
+/**
+ * \addtogroup SAMGUI
+ * @{
+ *   \addtogroup SAMGUI_WGT
+ *   @{
+ *     \addtogroup SAMGUI_WGT_CORE
+ *     @{
+ *       \addtogroup SAMGUI_WGT_CORE_SPRITES WGT Core Sprites
+ *       @{
+ */
+
+static void _WGT_Sprite_GetBox( const SWGTSprite* pSprite, SWGTRect* pBox )
+{
+    pBox->dwX1=pSprite->dwX ;
+    pBox->dwY1=pSprite->dwY ;
+    pBox->dwX2=pSprite->dwX+pSprite->dwWidth-1 ;
+    pBox->dwY2=pSprite->dwY+pSprite->dwHeight-1 ;
+}
+
+/**
+ * Copies the sprite pixels which are within the strip to the tile, the
+ * transparent ones being skipped.
+ */
+static void _WGT_Sprite_Blit( const SWGTSprite* pSprite, LcdColor_t* pTile, const SWGTRect* pStrip )
+{
+    const LcdColor_t* pFrame ;
+    const LcdColor_t* pSrc ;
+    LcdColor_t* pDst ;
+    uint32_t dwX1 ;
+    uint32_t dwY1 ;
+    uint32_t dwX2 ;
+    uint32_t dwY2 ;
+    uint32_t dwX ;
+    uint32_t dwY ;
+
+    dwX1=(pSprite->dwX > pStrip->dwX1) ? pSprite->dwX : pStrip->dwX1 ;
+    dwY1=(pSprite->dwY > pStrip->dwY1) ? pSprite->dwY : pStrip->dwY1 ;
+    dwX2=(pSprite->dwX+pSprite->dwWidth-1 < pStrip->dwX2) ? pSprite->dwX+pSprite->dwWidth-1 : pStrip->dwX2 ;
+    dwY2=(pSprite->dwY+pSprite->dwHeight-1 < pStrip->dwY2) ? pSprite->dwY+pSprite->dwHeight-1 : pStrip->dwY2 ;
+
+    if ( (dwX1 > dwX2) || (dwY1 > dwY2) )
+    {
+        return ;
+    }
+
+    pFrame=pSprite->pFrames+pSprite->dwFrame*pSprite->dwWidth*pSprite->dwHeight ;
+
+    for ( dwY=dwY1 ; dwY <= dwY2 ; dwY++ )
+    {
+        pSrc=pFrame+(dwY-pSprite->dwY)*pSprite->dwWidth+(dwX1-pSprite->dwX) ;
+        pDst=pTile+(dwY-pStrip->dwY1)*(pStrip->dwX2-pStrip->dwX1+1)+(dwX1-pStrip->dwX1) ;
+
+        for ( dwX=dwX1 ; dwX <= dwX2 ; dwX++, pSrc++, pDst++ )
+        {
+            if ( (*pSrc & WGT_SPRITE_TRANSPARENT) == 0 )
+            {
+                *pDst=*pSrc ;
+            }
+        }
+    }
+}
+
+/**
+ * Composites a box of a sprite area, strip by strip: saved background, then
+ * the sprite when shown, each strip being sent to the panel in one burst.
+ */
+static void _WGT_SpriteLayer_Compose( SWGTSpriteLayer* pLayer, SWGTSprite* pSprite, const SWGTRect* pBox )
+{
+    SWGTRect sStrip ;
+    SWGTRect sBox ;
+    uint32_t dwWidth ;
+    uint32_t dwAreaWidth ;
+    uint32_t dwLines ;
+    uint32_t dwY ;
+
+    dwWidth=pBox->dwX2-pBox->dwX1+1 ;
+    dwAreaWidth=pSprite->sArea.dwX2-pSprite->sArea.dwX1+1 ;
+    dwLines=pLayer->dwTilePixels/dwWidth ;
+
+    _WGT_Sprite_GetBox( pSprite, &sBox ) ;
+
+    sStrip.dwX1=pBox->dwX1 ;
+    sStrip.dwX2=pBox->dwX2 ;
+    for ( sStrip.dwY1=pBox->dwY1 ; sStrip.dwY1 <= pBox->dwY2 ; sStrip.dwY1+=dwLines )
+    {
+        sStrip.dwY2=sStrip.dwY1+dwLines-1 ;
+        if ( sStrip.dwY2 > pBox->dwY2 )
+        {
+            sStrip.dwY2=pBox->dwY2 ;
+        }
+
+        for ( dwY=sStrip.dwY1 ; dwY <= sStrip.dwY2 ; dwY++ )
+        {
+            memcpy( pLayer->pTile+(dwY-sStrip.dwY1)*dwWidth,
+                    pSprite->pBackground+(dwY-pSprite->sArea.dwY1)*dwAreaWidth+(sStrip.dwX1-pSprite->sArea.dwX1),
+                    dwWidth*sizeof( LcdColor_t ) ) ;
+        }
+
+        if ( pSprite->dwVisible &&
+             (sBox.dwX1 <= sStrip.dwX2) && (sStrip.dwX1 <= sBox.dwX2) &&
+             (sBox.dwY1 <= sStrip.dwY2) && (sStrip.dwY1 <= sBox.dwY2) )
+        {
+            if ( pSprite->Render != NULL )
+            {
+                FB_SetFrameBuffer( pLayer->pTile, dwWidth, sStrip.dwY2-sStrip.dwY1+1 ) ;
+                FB_SetOrigin( sStrip.dwX1, sStrip.dwY1 ) ;
+                pSprite->Render( pSprite ) ;
+            }
+            else
+            {
+                _WGT_Sprite_Blit( pSprite, pLayer->pTile, &sStrip ) ;
+            }
+        }
+
+        pLayer->Flush( sStrip.dwX1, sStrip.dwY1, sStrip.dwX2, sStrip.dwY2, pLayer->pTile ) ;
+    }
+}
+
+/**
+ * Redraws a changed sprite: the box drawn at the previous frame and the new
+ * one are sent together when they overlap, as one burst.
+ */
+static void _WGT_SpriteLayer_Redraw( SWGTSpriteLayer* pLayer, SWGTSprite* pSprite )
+{
+    SWGTRect sNew ;
+    SWGTRect sUnion ;
+
+    _WGT_Sprite_GetBox( pSprite, &sNew ) ;
+
+    if ( pSprite->sDrawn.dwX1 > pSprite->sDrawn.dwX2 )
+    {
+        // Nothing drawn yet
+        _WGT_SpriteLayer_Compose( pLayer, pSprite, &sNew ) ;
+    }
+    else
+    {
+        if ( (pSprite->sDrawn.dwX1 <= sNew.dwX2) && (sNew.dwX1 <= pSprite->sDrawn.dwX2) &&
+             (pSprite->sDrawn.dwY1 <= sNew.dwY2) && (sNew.dwY1 <= pSprite->sDrawn.dwY2) )
+        {
+            sUnion.dwX1=(sNew.dwX1 < pSprite->sDrawn.dwX1) ? sNew.dwX1 : pSprite->sDrawn.dwX1 ;
+            sUnion.dwY1=(sNew.dwY1 < pSprite->sDrawn.dwY1) ? sNew.dwY1 : pSprite->sDrawn.dwY1 ;
+            sUnion.dwX2=(sNew.dwX2 > pSprite->sDrawn.dwX2) ? sNew.dwX2 : pSprite->sDrawn.dwX2 ;
+            sUnion.dwY2=(sNew.dwY2 > pSprite->sDrawn.dwY2) ? sNew.dwY2 : pSprite->sDrawn.dwY2 ;
+            _WGT_SpriteLayer_Compose( pLayer, pSprite, &sUnion ) ;
+        }
+        else
+        {
+            _WGT_SpriteLayer_Compose( pLayer, pSprite, &pSprite->sDrawn ) ;
+            _WGT_SpriteLayer_Compose( pLayer, pSprite, &sNew ) ;
+        }
+    }
+
+    pSprite->sDrawn=sNew ;
+    pSprite->dwDirty=0 ;
+}
+
+/**
+ * Frame timer callback
+ */
+static void _WGT_SpriteLayer_OnTimer( SWGTTimer* pTimer )
+{
+    WGT_SpriteLayer_Update( (SWGTSpriteLayer*)pTimer ) ;
+}
+
+/**
+ * Initializes a sprite layer. The tile buffer must hold at least one line
+ * of the widest sprite area, Flush writes a box of pixels to the panel
+ * (as for DBE_TILE_Initialize()) and pBE is read to save the backgrounds.
+ */
+extern uint32_t WGT_SpriteLayer_Initialize( SWGTSpriteLayer* pLayer, SDISPBackend* pBE, LcdColor_t* pTile, uint32_t dwTilePixels,
+                                            DBE_TILE_FlushCallback Flush )
+{
+    if ( (pLayer == NULL) || (pBE == NULL) || (pTile == NULL) || (Flush == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( (dwTilePixels == 0) || (pBE->GetPixel == NULL) )
+    {
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+
+    memset( pLayer, 0, sizeof( SWGTSpriteLayer ) ) ;
+    pLayer->pBE=pBE ;
+    pLayer->pTile=pTile ;
+    pLayer->dwTilePixels=dwTilePixels ;
+    pLayer->Flush=Flush ;
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Starts the frames, one every dwFrameDelay ms (33 for 30 fps)
+ */
+extern uint32_t WGT_SpriteLayer_Start( SWGTSpriteLayer* pLayer, uint32_t dwFrameDelay )
+{
+    uint32_t dwResult ;
+
+    if ( pLayer == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    WGT_Timer_Stop( &pLayer->sTimer ) ;
+
+    dwResult=WGT_Timer_Create( &pLayer->sTimer, (uint32_t)pLayer, dwFrameDelay ) ;
+    if ( dwResult != SAMGUI_E_OK )
+    {
+        return dwResult ;
+    }
+    WGT_Timer_SetCallback( &pLayer->sTimer, _WGT_SpriteLayer_OnTimer ) ;
+
+    return WGT_Timer_Start( &pLayer->sTimer ) ;
+}
+
+/**
+ * Stops the frames, the sprites stay as last drawn
+ */
+extern uint32_t WGT_SpriteLayer_Stop( SWGTSpriteLayer* pLayer )
+{
+    if ( pLayer == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    return WGT_Timer_Stop( &pLayer->sTimer ) ;
+}
+
+/**
+ * Shows a sprite. Its area is read back from the panel as its background,
+ * so the screen must have been painted first.
+ */
+extern uint32_t WGT_SpriteLayer_Add( SWGTSpriteLayer* pLayer, SWGTSprite* pSprite )
+{
+    SGUIColor clr ;
+    LcdColor_t* pPixel ;
+    uint32_t dwX ;
+    uint32_t dwY ;
+
+    if ( (pLayer == NULL) || (pSprite == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( pSprite->sArea.dwX2-pSprite->sArea.dwX1+1 > pLayer->dwTilePixels )
+    {
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+
+    if ( pSprite->dwVisible )
+    {
+        return SAMGUI_E_OK ;
+    }
+
+    // Pending drawing reaches the panel before the read back
+    if ( pLayer->pBE->IOCtl != NULL )
+    {
+        pLayer->pBE->IOCtl( DISP_BACKEND_IOCTL_FLUSH, NULL, NULL ) ;
+    }
+
+    pPixel=pSprite->pBackground ;
+    for ( dwY=pSprite->sArea.dwY1 ; dwY <= pSprite->sArea.dwY2 ; dwY++ )
+    {
+        for ( dwX=pSprite->sArea.dwX1 ; dwX <= pSprite->sArea.dwX2 ; dwX++ )
+        {
+            clr.u.dwRGBA=0 ;
+            pLayer->pBE->GetPixel( dwX, dwY, &clr ) ;
+            *pPixel++=clr.u.dwRGBA & 0x00FFFFFF ;
+        }
+    }
+
+    pSprite->dwVisible=1 ;
+    pSprite->dwDirty=1 ;
+    pSprite->sDrawn.dwX1=1 ;
+    pSprite->sDrawn.dwX2=0 ;
+    pSprite->pNext=pLayer->pSprites ;
+    pLayer->pSprites=pSprite ;
+
+    _WGT_SpriteLayer_Redraw( pLayer, pSprite ) ;
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Hides a sprite, its background being put back
+ */
+extern uint32_t WGT_SpriteLayer_Remove( SWGTSpriteLayer* pLayer, SWGTSprite* pSprite )
+{
+    SWGTSprite** ppSprite ;
+
+    if ( (pLayer == NULL) || (pSprite == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    for ( ppSprite=&pLayer->pSprites ; *ppSprite != NULL ; ppSprite=&(*ppSprite)->pNext )
+    {
+        if ( *ppSprite == pSprite )
+        {
+            *ppSprite=pSprite->pNext ;
+            pSprite->pNext=NULL ;
+            pSprite->dwVisible=0 ;
+
+            if ( pSprite->sDrawn.dwX1 <= pSprite->sDrawn.dwX2 )
+            {
+                _WGT_SpriteLayer_Compose( pLayer, pSprite, &pSprite->sDrawn ) ;
+            }
+
+            return SAMGUI_E_OK ;
+        }
+    }
+
+    return SAMGUI_E_BAD_PARAMETER ;
+}
+
+/**
+ * Draws one frame: each sprite is animated, then redrawn if it changed.
+ * Called by the frame timer, or by the application when not started.
+ */
+extern uint32_t WGT_SpriteLayer_Update( SWGTSpriteLayer* pLayer )
+{
+    SWGTSprite* pSprite ;
+    uint32_t dwStart ;
+    uint32_t dwTicks ;
+
+    if ( pLayer == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    dwStart=SAMGUI_GetTickCount() ;
+
+    for ( pSprite=pLayer->pSprites ; pSprite != NULL ; pSprite=pSprite->pNext )
+    {
+        if ( pSprite->Animate != NULL )
+        {
+            pSprite->Animate( pSprite ) ;
+        }
+        else
+        {
+            if ( pSprite->dwFrames > 1 )
+            {
+                WGT_Sprite_SetFrame( pSprite, (pSprite->dwFrame+1)%pSprite->dwFrames ) ;
+            }
+        }
+
+        if ( pSprite->dwDirty )
+        {
+            _WGT_SpriteLayer_Redraw( pLayer, pSprite ) ;
+        }
+    }
+
+    dwTicks=SAMGUI_GetTickCount()-dwStart ;
+    if ( dwTicks > pLayer->dwFrameTicksMax )
+    {
+        pLayer->dwFrameTicksMax=dwTicks ;
+    }
+    pLayer->dwFrameCount++ ;
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Initializes a sprite of dwWidth x dwHeight pixels staying within the
+ * screen area (dwX1, dwY1)-(dwX2, dwY2), placed at its top left corner.
+ * pBackground holds one LcdColor_t per pixel of the area.
+ */
+extern uint32_t WGT_Sprite_Initialize( SWGTSprite* pSprite, uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2,
+                                       LcdColor_t* pBackground, uint32_t dwWidth, uint32_t dwHeight )
+{
+    if ( (pSprite == NULL) || (pBackground == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( (dwX1 > dwX2) || (dwY1 > dwY2) || (dwX2 >= BOARD_LCD_WIDTH) || (dwY2 >= BOARD_LCD_HEIGHT) ||
+         (dwWidth == 0) || (dwHeight == 0) || (dwWidth > dwX2-dwX1+1) || (dwHeight > dwY2-dwY1+1) )
+    {
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+
+    memset( pSprite, 0, sizeof( SWGTSprite ) ) ;
+    pSprite->sArea.dwX1=dwX1 ;
+    pSprite->sArea.dwY1=dwY1 ;
+    pSprite->sArea.dwX2=dwX2 ;
+    pSprite->sArea.dwY2=dwY2 ;
+    pSprite->pBackground=pBackground ;
+    pSprite->dwX=dwX1 ;
+    pSprite->dwY=dwY1 ;
+    pSprite->dwWidth=dwWidth ;
+    pSprite->dwHeight=dwHeight ;
+    pSprite->sDrawn.dwX1=1 ;
+    pSprite->sDrawn.dwX2=0 ;
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Sets the frames of a sprite, dwFrames images of dwWidth*dwHeight pixels
+ * one after the other, WGT_SPRITE_TRANSPARENT marking the transparent pixels
+ */
+extern uint32_t WGT_Sprite_SetFrames( SWGTSprite* pSprite, const LcdColor_t* pFrames, uint32_t dwFrames )
+{
+    if ( (pSprite == NULL) || (pFrames == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( dwFrames == 0 )
+    {
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+
+    pSprite->pFrames=pFrames ;
+    pSprite->dwFrames=dwFrames ;
+    pSprite->dwFrame=0 ;
+    pSprite->dwDirty=1 ;
+
+    return SAMGUI_E_OK ;
+}
+
+extern uint32_t WGT_Sprite_SetFrame( SWGTSprite* pSprite, uint32_t dwFrame )
+{
+    if ( pSprite == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( dwFrame >= pSprite->dwFrames )
+    {
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+
+    if ( dwFrame != pSprite->dwFrame )
+    {
+        pSprite->dwFrame=dwFrame ;
+        pSprite->dwDirty=1 ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Moves a sprite, which must stay within its area
+ */
+extern uint32_t WGT_Sprite_Move( SWGTSprite* pSprite, uint32_t dwX, uint32_t dwY )
+{
+    if ( pSprite == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( (dwX < pSprite->sArea.dwX1) || (dwX+pSprite->dwWidth-1 > pSprite->sArea.dwX2) ||
+         (dwY < pSprite->sArea.dwY1) || (dwY+pSprite->dwHeight-1 > pSprite->sArea.dwY2) )
+    {
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+
+    if ( (dwX != pSprite->dwX) || (dwY != pSprite->dwY) )
+    {
+        pSprite->dwX=dwX ;
+        pSprite->dwY=dwY ;
+        pSprite->dwDirty=1 ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Has a sprite drawn by Render redrawn at the next frame, after a change
+ * of what Render draws
+ */
+extern uint32_t WGT_Sprite_Invalidate( SWGTSprite* pSprite )
+{
+    if ( pSprite == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    pSprite->dwDirty=1 ;
+
+    return SAMGUI_E_OK ;
+}
+
+/** @}
+ * @}
+ * @}
+ * @} */
@@ -0,0 +1,136 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef _SAMGUI_WIDGET_CORE_SPRITE_
+#define _SAMGUI_WIDGET_CORE_SPRITE_
+
+#include "board.h"
+#include "source/disp/disp_backend.h"
+#include "source/disp/backends/TILE/backend_TILE.h"
+#include "source/wgt/core/wgt_core_timer.h"
+#include "source/wgt/core/wgt_core_screen.h"
+
+/**
+ * \addtogroup SAMGUI
+ * @{
+ *   \addtogroup SAMGUI_WGT
+ *   @{
+ *     \addtogroup SAMGUI_WGT_CORE
+ *     @{
+ *       \addtogroup SAMGUI_WGT_CORE_SPRITES WGT Core Sprites
+ *       @{
+ *
+ * \brief Animated elements drawn over the screen without repainting it.
+ *
+ * A sprite moves and changes within a fixed area of the screen, whose
+ * background is read back from the panel once, when the sprite is added to
+ * the layer. On each frame, every changed sprite is composited off-screen in
+ * the tile buffer over the saved background, then the changed box is sent to
+ * the panel in one windowed burst through the same flush function as the
+ * TILE backend. Neither the widgets nor the rest of the screen are redrawn.
+ *
+ * The frames are paced by a GUI timer calling the layer directly
+ * (WGT_Timer_SetCallback()), so a 30 fps animation costs a steady slice of
+ * the GUI task, reported in dwFrameTicksMax. Sprite areas must not overlap,
+ * and nothing else should be drawn in them while the sprites are shown.
+ * Everything runs in the GUI task.
+ */
+
+// Pixel value of the transparent pixels of the sprite frames
+#define WGT_SPRITE_TRANSPARENT     0xFF000000UL
+
+typedef struct _SWGTSprite
+{
+    // Area the sprite stays in, and its background, one LcdColor_t per pixel
+    SWGTRect sArea ;
+    LcdColor_t* pBackground ;
+
+    // Position of the top left corner and size
+    uint32_t dwX ;
+    uint32_t dwY ;
+    uint32_t dwWidth ;
+    uint32_t dwHeight ;
+
+    // Frames of dwWidth*dwHeight pixels, NULL when drawn by Render
+    const LcdColor_t* pFrames ;
+    uint32_t dwFrames ;
+    uint32_t dwFrame ;
+
+    // Draws the sprite with the FB_xxx functions, in screen coordinates
+    void (*Render)( struct _SWGTSprite* pSprite ) ;
+    // Moves or changes the sprite before each frame, NULL to loop the frames
+    void (*Animate)( struct _SWGTSprite* pSprite ) ;
+    void* pvContext ;
+
+    uint32_t dwVisible ;
+    uint32_t dwDirty ;
+    // Box drawn at the previous frame, to be erased
+    SWGTRect sDrawn ;
+
+    struct _SWGTSprite* pNext ;
+} SWGTSprite ;
+
+typedef struct _SWGTSpriteLayer
+{
+    // Frame timer, first member so that the layer is found back from it
+    SWGTTimer sTimer ;
+
+    SDISPBackend* pBE ;
+    LcdColor_t* pTile ;
+    uint32_t dwTilePixels ;
+    DBE_TILE_FlushCallback Flush ;
+
+    SWGTSprite* pSprites ;
+
+    // Frames drawn, and longest frame, in ms
+    uint32_t dwFrameCount ;
+    uint32_t dwFrameTicksMax ;
+} SWGTSpriteLayer ;
+
+extern uint32_t WGT_SpriteLayer_Initialize( SWGTSpriteLayer* pLayer, SDISPBackend* pBE, LcdColor_t* pTile, uint32_t dwTilePixels,
+                                            DBE_TILE_FlushCallback Flush ) ;
+extern uint32_t WGT_SpriteLayer_Start( SWGTSpriteLayer* pLayer, uint32_t dwFrameDelay ) ;
+extern uint32_t WGT_SpriteLayer_Stop( SWGTSpriteLayer* pLayer ) ;
+extern uint32_t WGT_SpriteLayer_Add( SWGTSpriteLayer* pLayer, SWGTSprite* pSprite ) ;
+extern uint32_t WGT_SpriteLayer_Remove( SWGTSpriteLayer* pLayer, SWGTSprite* pSprite ) ;
+extern uint32_t WGT_SpriteLayer_Update( SWGTSpriteLayer* pLayer ) ;
+
+extern uint32_t WGT_Sprite_Initialize( SWGTSprite* pSprite, uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2,
+                                       LcdColor_t* pBackground, uint32_t dwWidth, uint32_t dwHeight ) ;
+extern uint32_t WGT_Sprite_SetFrames( SWGTSprite* pSprite, const LcdColor_t* pFrames, uint32_t dwFrames ) ;
+extern uint32_t WGT_Sprite_SetFrame( SWGTSprite* pSprite, uint32_t dwFrame ) ;
+extern uint32_t WGT_Sprite_Move( SWGTSprite* pSprite, uint32_t dwX, uint32_t dwY ) ;
+extern uint32_t WGT_Sprite_Invalidate( SWGTSprite* pSprite ) ;
+
+/** @}
+ * @}
+ * @}
+ * @} */
+
+#endif // _SAMGUI_WIDGET_CORE_SPRITE_
@@ -13,35 +13,214 @@
  *       @{
  */
 
-static __no_init SWGTTimer* gs_apWGTTimers[WGT_TIMER_MAX] ;
+/** Running timers, ordered by deadline */
+static SWGTTimer* gs_pWGTTimers=NULL ;
+
+/**
+ * Insert a timer in the running list, after the timers with the same deadline.
+ */
+static void _WGT_Timer_Insert( SWGTTimer* pTimer )
+{
+    SWGTTimer** ppTimer=&gs_pWGTTimers ;
+
+    while ( (*ppTimer != NULL) && ((int32_t)((*ppTimer)->dwTimestamp - pTimer->dwTimestamp) <= 0) )
+    {
+        ppTimer=&(*ppTimer)->pNext ;
+    }
+
+    pTimer->pNext=*ppTimer ;
+    *ppTimer=pTimer ;
+}
+
+/**
+ * Remove a timer from the running list.
+ */
+static void _WGT_Timer_Remove( SWGTTimer* pTimer )
+{
+    SWGTTimer** ppTimer=&gs_pWGTTimers ;
+
+    while ( *ppTimer != NULL )
+    {
+        if ( *ppTimer == pTimer )
+        {
+            *ppTimer=pTimer->pNext ;
+            pTimer->pNext=NULL ;
+
+            return ;
+        }
+        ppTimer=&(*ppTimer)->pNext ;
+    }
+}
 
 extern uint32_t WGT_Timer_Create( SWGTTimer* pTimer, uint32_t dwID, uint32_t dwDelay )
 {
+    if ( pTimer == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( dwDelay == 0 )
+    {
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+
+    pTimer->dwState=WGT_TIMER_DISABLED ;
+    pTimer->dwID=dwID ;
+    pTimer->dwDelay=dwDelay ;
+    pTimer->dwTimestamp=0 ;
+    pTimer->pNext=NULL ;
+    pTimer->OnExpire=NULL ;
+    pTimer->dwPending=0 ;
+
     return SAMGUI_E_OK ;
 }
 
+/**
+ * Have a timer call OnExpire from WGT_Timer_Process() rather than post
+ * WGT_MSG_TIMER, NULL going back to the message. The call does not go
+ * through the message queue, so periodic work such as animation frames
+ * runs on time even with a busy queue.
+ */
+extern uint32_t WGT_Timer_SetCallback( SWGTTimer* pTimer, void (*OnExpire)( SWGTTimer* pTimer ) )
+{
+    if ( pTimer == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    pTimer->OnExpire=OnExpire ;
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Start a timer, or restart it if already running, first expiry in dwDelay ms.
+ */
 extern uint32_t WGT_Timer_Start( SWGTTimer* pTimer )
 {
+    if ( pTimer == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( pTimer->dwState == WGT_TIMER_ENABLED )
+    {
+        _WGT_Timer_Remove( pTimer ) ;
+    }
+
+    pTimer->dwTimestamp=SAMGUI_GetTickCount()+pTimer->dwDelay ;
+    pTimer->dwState=WGT_TIMER_ENABLED ;
+    _WGT_Timer_Insert( pTimer ) ;
+
     return SAMGUI_E_OK ;
 }
 
 extern uint32_t WGT_Timer_Stop( SWGTTimer* pTimer )
 {
+    if ( pTimer == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( pTimer->dwState == WGT_TIMER_ENABLED )
+    {
+        _WGT_Timer_Remove( pTimer ) ;
+        pTimer->dwState=WGT_TIMER_DISABLED ;
+    }
+    pTimer->dwPending=0 ;
+
     return SAMGUI_E_OK ;
 }
 
 extern uint32_t WGT_Timer_Initialize( void )
 {
-    memset( gs_apWGTTimers, 0, sizeof( gs_apWGTTimers ) ) ;
+    gs_pWGTTimers=NULL ;
 
     return SAMGUI_E_OK ;
 }
 
+/**
+ * Post WGT_MSG_TIMER, or call OnExpire, for every expired timer and schedule
+ * its next expiry. Only the head of the list needs to be looked at. A timer
+ * is rescheduled before its callback runs, which may thus stop or restart it.
+ * No message is posted while the previous one of the same timer is still
+ * queued, a busy GUI task thus gets one tick rather than a backlog of them.
+ */
 extern uint32_t WGT_Timer_Process( void )
 {
+    SWGTTimer* pTimer ;
+    uint32_t dwNow=SAMGUI_GetTickCount() ;
+
+    while ( (gs_pWGTTimers != NULL) && ((int32_t)(dwNow - gs_pWGTTimers->dwTimestamp) >= 0) )
+    {
+        pTimer=gs_pWGTTimers ;
+        gs_pWGTTimers=pTimer->pNext ;
+
+        // Keep the period, unless late by more than one period
+        pTimer->dwTimestamp+=pTimer->dwDelay ;
+        if ( (int32_t)(dwNow - pTimer->dwTimestamp) >= 0 )
+        {
+            pTimer->dwTimestamp=dwNow+pTimer->dwDelay ;
+        }
+        _WGT_Timer_Insert( pTimer ) ;
+
+        if ( pTimer->OnExpire != NULL )
+        {
+            pTimer->OnExpire( pTimer ) ;
+        }
+        else
+        {
+            if ( pTimer->dwPending == 0 )
+            {
+                if ( WGT_PostMessage( WGT_MSG_TIMER, pTimer->dwID, (uint32_t)pTimer ) == SAMGUI_E_OK )
+                {
+                    pTimer->dwPending=1 ;
+                }
+            }
+        }
+    }
+
     return SAMGUI_E_OK ;
 }
 
+/**
+ * Return the delay in ms until the next timer expiry, SAMGUI_WAIT_FOREVER if
+ * no timer is running.
+ */
+extern uint32_t WGT_Timer_GetNextDelay( void )
+{
+    int32_t iDelay ;
+
+    if ( gs_pWGTTimers == NULL )
+    {
+        return SAMGUI_WAIT_FOREVER ;
+    }
+
+    iDelay=(int32_t)(gs_pWGTTimers->dwTimestamp - SAMGUI_GetTickCount()) ;
+
+    return (iDelay > 0) ? (uint32_t)iDelay : 0 ;
+}
+
+/**
+ * Called by the GUI task when dispatching WGT_MSG_TIMER, so that the timer
+ * posts again. The running list is searched, as the timer of a queued message
+ * may have been stopped and freed since.
+ */
+extern void WGT_Timer_Acknowledge( SWGTTimer* pTimer )
+{
+    SWGTTimer* pRunning ;
+
+    for ( pRunning=gs_pWGTTimers ; pRunning != NULL ; pRunning=pRunning->pNext )
+    {
+        if ( pRunning == pTimer )
+        {
+            pTimer->dwPending=0 ;
+
+            return ;
+        }
+    }
+}
+
 /** @}
  * @}
  * @}
@@ -43,21 +43,31 @@
  *       @{
  */
 
-// Max available timers
-#define WGT_TIMER_MAX             4
-
 typedef enum _eWGTTimer_State
 {
     WGT_TIMER_DISABLED, // 0
     WGT_TIMER_ENABLED
 } eWGTTimer_State ;
 
+/**
+ * Periodic timer, posting WGT_MSG_TIMER (dwParam1=dwID, dwParam2=timer) every
+ * dwDelay ms while enabled, or calling OnExpire from the GUI task instead when
+ * set (WGT_Timer_SetCallback()). Running timers are kept in a list ordered by
+ * deadline, they must only be started and stopped from the GUI task.
+ */
 typedef struct _SWGTTimer
 {
     uint32_t dwState ;
     uint32_t dwID ;
     uint32_t dwDelay ;
+    // Tick count of the next expiry
     uint32_t dwTimestamp ;
+    // Next running timer, by deadline
+    struct _SWGTTimer* pNext ;
+    // Called on expiry in place of the message, NULL by default
+    void (*OnExpire)( struct _SWGTTimer* pTimer ) ;
+    // WGT_MSG_TIMER posted and not yet dispatched
+    uint32_t dwPending ;
 } SWGTTimer ;
 
 // ------------------------------------------------------------------------------------------------
@@ -66,9 +76,12 @@ typedef struct _SWGTTimer
 extern uint32_t WGT_Timer_Create( SWGTTimer* pTimer, uint32_t dwID, uint32_t dwDelay ) ;
 extern uint32_t WGT_Timer_Start( SWGTTimer* pTimer ) ;
 extern uint32_t WGT_Timer_Stop( SWGTTimer* pTimer ) ;
+extern uint32_t WGT_Timer_SetCallback( SWGTTimer* pTimer, void (*OnExpire)( SWGTTimer* pTimer ) ) ;
 
 extern uint32_t WGT_Timer_Initialize( void ) ;
 extern uint32_t WGT_Timer_Process( void ) ;
+extern uint32_t WGT_Timer_GetNextDelay( void ) ;
+extern void WGT_Timer_Acknowledge( SWGTTimer* pTimer ) ;
 
 /** @}
  * @}
@@ -77,6 +77,7 @@ extern void WGT_DestroyWidget( SWGT_Widget* pWidget )
 {
     if ( pWidget != NULL )
     {
+        WGT_Gradient_Free( &pWidget->sGradient ) ;
         SAMGUI_Free( pWidget ) ;
     }
 }
@@ -96,6 +97,21 @@ extern uint32_t WGT_SetBkgndColor( SWGT_Widget* pWidget, uint32_t dwColor )
     return SAMGUI_E_OK ;
 }
 
+/**
+ * Sets a widget gradient background, WGT_GRADIENT_NONE going back to the
+ * background color. The gradient is computed on the first draw and again
+ * only once the colors or the widget size change.
+ */
+extern uint32_t WGT_SetBkgndGradient( SWGT_Widget* pWidget, uint32_t dwColorBegin, uint32_t dwColorEnd, uint32_t dwDirection )
+{
+    if ( pWidget == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    return WGT_Gradient_Set( &pWidget->sGradient, dwColorBegin, dwColorEnd, dwDirection ) ;
+}
+
 /**
  * Sets a widget text color
  */
@@ -158,6 +174,11 @@ extern uint32_t WGT_Draw( SWGT_Widget* pWidget, SDISPBackend* pBE )
     {
         pBE->DrawBitmap( pWidget->dwX, pWidget->dwY, pWidget->dwWidth, pWidget->dwHeight, pWidget->pvBitmap ) ;
     }
+    // else if gradient, draw it from its precomputed colors
+    else if ( pWidget->sGradient.dwDirection != WGT_GRADIENT_NONE )
+    {
+        WGT_Gradient_Draw( &pWidget->sGradient, pBE, pWidget->dwX, pWidget->dwY, pWidget->dwWidth, pWidget->dwHeight ) ;
+    }
     // else if colors, draw background color filled rectangle
     else
     {
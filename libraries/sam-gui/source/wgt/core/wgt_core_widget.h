@@ -31,6 +31,7 @@
 #define _SAMGUI_WGT_CORE_WIDGET_
 
 #include "libsam_gui.h"
+#include "source/wgt/core/wgt_core_gradient.h"
 
 /**
  * \addtogroup SAMGUI
@@ -87,6 +88,8 @@ typedef struct _SWGT_Widget
     uint32_t dwHeight ;
     uint32_t dwClrText ;
     uint32_t dwClrBackground ;
+    // Gradient background, in place of dwClrBackground when set
+    SWGTGradient sGradient ;
 
     WGT_Style dwStyle ;
 
@@ -105,6 +108,7 @@ extern SWGT_Widget* WGT_CreateWidget( WGT_Type eType, uint32_t dwX, uint32_t dwY
 extern void WGT_DestroyWidget( SWGT_Widget* pWidget ) ;
 
 extern uint32_t WGT_SetBkgndColor( SWGT_Widget* pWidget, uint32_t dwColor ) ;
+extern uint32_t WGT_SetBkgndGradient( SWGT_Widget* pWidget, uint32_t dwColorBegin, uint32_t dwColorEnd, uint32_t dwDirection ) ;
 extern uint32_t WGT_SetTextColor( SWGT_Widget* pWidget, uint32_t dwColor ) ;
 extern uint32_t WGT_SetText( SWGT_Widget* pWidget, char* pszText ) ;
 extern uint32_t WGT_SetBitmap( SWGT_Widget* pWidget, uint8_t* pucBitmap ) ;
@@ -75,7 +75,7 @@
  *         Touchscreen driver parameters
  * ----------------------------------------------------------------------------
 */
-#define NB_SAMPLES       3 /**< Number of succesive measurements required to get an accurate pen position */
+#define NB_SAMPLES       5 /**< Number of conversions per axis acquired in one chained transfer, their median is the pen position */
 #define SAMPLING_PERIOD 10 /**< Sampling period (in ms) when pen is pressed to detect pen mouvements */
 
 /** Binary flag to check if the screen has been calibrated. Calibration calculus
@@ -86,47 +86,77 @@ uint8_t gTsCalibrated = 0;
 
 static Ads7843CalibParameters gs_ADS7843CalibParameters;
 
+/** Reciprocals (Q16) of the calibration slopes, computed once per calibration */
+static int32_t gs_lADS7843InvSlopeX ;
+static int32_t gs_lADS7843InvSlopeY ;
+
+/** IIR filter state of the pen position */
+static int32_t gs_alADS7843Filter[2] ;
+
 /** Pins used by Interrupt Signal for Touch Screen Controller */
 static const Pin _WFE_ADS7843_pinPenIRQ=PIN_TSC_IRQ ;
 
 /** Touch screen semaphore used to resume touch screen task when pen is pressed */
 static xSemaphoreHandle gTsSemaphore = NULL ;
 
+/**
+  * \brief Computes the reciprocals of the calibration slopes, so that the
+  * calibration function needs no division per measurement.
+*/
+static void _WFE_ADS7843_UpdateCalibration( void )
+{
+    gs_lADS7843InvSlopeX=0 ;
+    gs_lADS7843InvSlopeY=0 ;
+
+    if ( gs_ADS7843CalibParameters.lSlopeX != 0 )
+    {
+        gs_lADS7843InvSlopeX=(int32_t)((1024L << 16) / gs_ADS7843CalibParameters.lSlopeX) ;
+    }
+
+    if ( gs_ADS7843CalibParameters.lSlopeY != 0 )
+    {
+        gs_lADS7843InvSlopeY=(int32_t)((1024L << 16) / gs_ADS7843CalibParameters.lSlopeY) ;
+    }
+}
+
 /**
   * \brief Returns Touchscreen pen position
-  * Performs several (NB_SAMPLES succesive measurements and do a mean. Then
-  * calibration function is applied according to the calibration parameters.
+  * Acquires NB_SAMPLES conversions per axis in one chained transfer and keeps
+  * their median, which is then smoothed by an IIR filter. Then calibration
+  * function is applied according to the calibration parameters.
+  *
+  * \param bReset 1 for the first measurement of a contact, restarts the filter
 */
-static void _WFE_ADS7843_GetPenPosition( uint32_t *pdwX, uint32_t *pdwY )
+static void _WFE_ADS7843_GetPenPosition( uint32_t *pdwX, uint32_t *pdwY, uint8_t bReset )
 {
-    uint32_t i ;
-    uint32_t dwX ; /* Measured coordinates */
-    uint32_t dwY ; /* Measured coordinates */
+    uint16_t awX[NB_SAMPLES] ; /* Measured coordinates */
+    uint16_t awY[NB_SAMPLES] ; /* Measured coordinates */
+    uint32_t adwData[2] ;
+    uint32_t dwCount ;
     uint32_t dwTrueX ; /* Filtered coordinates */
     uint32_t dwTrueY ; /* Filtered coordinates */
 
-
-    /* Do several successive measurements and process a mean */
-    dwTrueX = 0 ;
-    dwTrueY = 0 ;
-    for ( i = 0; i < NB_SAMPLES; ++i )
+    /* One chained acquisition, the median rejects the noise spikes */
+    dwCount=ADS7843_ReadSamples( awX, awY, NB_SAMPLES ) ;
+    if ( dwCount == 0 )
     {
-        ADS7843_GetPosition( &dwX, &dwY ) ;
-        dwTrueX += dwX;
-        dwTrueY += dwY;
+        /* Conversion timeout, keep the previous position */
+        return ;
     }
-    dwTrueX /= NB_SAMPLES;
-    dwTrueY /= NB_SAMPLES;
+    adwData[0]=TSDCom_Median( awX, dwCount ) ;
+    adwData[1]=TSDCom_Median( awY, dwCount ) ;
+    TSDCom_FilterMeasurement( gs_alADS7843Filter, adwData, bReset ) ;
+
+    dwTrueX=adwData[0] ;
+    dwTrueY=adwData[1] ;
 
     /* If calibration has been done, apply calibration function */
     if ( gTsCalibrated )
     {
         dwTrueX = gs_ADS7843CalibParameters.dwPointX
-                - ((int32_t)(gs_ADS7843CalibParameters.dwMeasureX - (int32_t)dwTrueX) * 1024)
-                / gs_ADS7843CalibParameters.lSlopeX ;
+                - (int32_t)(((int64_t)((int32_t)gs_ADS7843CalibParameters.dwMeasureX - (int32_t)dwTrueX) * gs_lADS7843InvSlopeX + 0x8000) >> 16) ;
         dwTrueY =  gs_ADS7843CalibParameters.dwPointY
-                - ((int32_t)(gs_ADS7843CalibParameters.dwMeasureY - (int32_t)dwTrueY) * 1024)
-                / gs_ADS7843CalibParameters.lSlopeY ;
+                - (int32_t)(((int64_t)((int32_t)gs_ADS7843CalibParameters.dwMeasureY - (int32_t)dwTrueY) * gs_lADS7843InvSlopeY + 0x8000) >> 16) ;
 
         if ((int32_t)dwTrueX < 0 ) /* Is pPoint[0] negative ? */
             dwTrueX = 0;
@@ -154,8 +184,8 @@ static void _WFE_ADS7843_GetPenPosition( uint32_t *pdwX, uint32_t *pdwY )
 static void _WFE_ADS7843_Task( void* pParameter )
 {
     uint8_t  isPenPressed;
-    uint32_t dwX, dwPrevX;
-    uint32_t dwY, dwPrevY;
+    uint32_t dwX=0, dwPrevX=0;
+    uint32_t dwY=0, dwPrevY=0;
 
     while ( 1 )
     {
@@ -172,18 +202,18 @@ static void _WFE_ADS7843_Task( void* pParameter )
         isPenPressed = 1 ;
 
         /* Perform a first measurement corresponding to the key pressed */
-        _WFE_ADS7843_GetPenPosition( &dwX, &dwY ) ;
+        _WFE_ADS7843_GetPenPosition( &dwX, &dwY, 1 ) ;
 
         /* If it is not calibrated send the raw value to the application */
         if ( !gTsCalibrated )
         {
-            WGT_SendMessageISR( WGT_MSG_POINTER_RAW, dwX, dwY ) ;
+            WGT_PostMessageISR( WGT_MSG_POINTER_RAW, dwX, dwY ) ;
             isPenPressed = 0 ;
         }
         else
         {
             /* Send the key pressed position */
-            WGT_SendMessageISR( WGT_MSG_POINTER_PRESSED, dwX, dwY) ;
+            WGT_PostMessageISR( WGT_MSG_POINTER_PRESSED, dwX, dwY) ;
             dwPrevX = dwX ;
             dwPrevY = dwY ;
         }
@@ -194,12 +224,12 @@ static void _WFE_ADS7843_Task( void* pParameter )
             vTaskDelay( SAMPLING_PERIOD/portTICK_RATE_MS ) ;
 
             /* Perform measurements at SAMPLING_RATE */
-            _WFE_ADS7843_GetPenPosition( &dwX, &dwY ) ;
+            _WFE_ADS7843_GetPenPosition( &dwX, &dwY, 0 ) ;
 
             /* If the touch has been released exit the loop and post release message */
             if ( PIO_Get( &_WFE_ADS7843_pinPenIRQ ) == 1 )
             {
-                WGT_SendMessageISR( WGT_MSG_POINTER_RELEASED, dwPrevX, dwPrevY ) ;
+                WGT_PostMessageISR( WGT_MSG_POINTER_RELEASED, dwPrevX, dwPrevY ) ;
                 isPenPressed = 0 ;
             }
             /* Else send the pen position if this one is different from the previous one */
@@ -207,7 +237,7 @@ static void _WFE_ADS7843_Task( void* pParameter )
             {
                 if ( (dwX != dwPrevX) || (dwY != dwPrevY) )
                 {
-                    WGT_SendMessageISR( WGT_MSG_POINTER, dwX, dwY ) ;
+                    WGT_PostMessageISR( WGT_MSG_POINTER, dwX, dwY ) ;
                     dwPrevX = dwX ;
                     dwPrevY = dwY ;
                 }
@@ -262,6 +292,7 @@ static uint32_t _WFE_ADS7843_Initialize( void )
     gs_ADS7843CalibParameters.dwMeasureY = g_demo_parameters.sCalibration.dwMeasureY;
     gs_ADS7843CalibParameters.lSlopeX = g_demo_parameters.sCalibration.lSlopeX;
     gs_ADS7843CalibParameters.lSlopeY = g_demo_parameters.sCalibration.lSlopeY;
+    _WFE_ADS7843_UpdateCalibration() ;
 
     /* Check if we already have calibration data */
     if ( gs_ADS7843CalibParameters.dwPointX )
@@ -293,6 +324,7 @@ static uint32_t _WFE_ADS7843_IOCtl( uint32_t dwCommand, uint32_t* pdwValue, uint
             if ( (pdwValueLength != NULL) && (*pdwValueLength == sizeof( Ads7843CalibParameters )) )
             {
                 memcpy( &gs_ADS7843CalibParameters, pdwValue, sizeof( Ads7843CalibParameters ) ) ;
+                _WFE_ADS7843_UpdateCalibration() ;
                 if ( gs_ADS7843CalibParameters.lSlopeX != 0 )
                 {
                     gTsCalibrated=1 ;
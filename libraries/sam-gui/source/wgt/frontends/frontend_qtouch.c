@@ -27,17 +27,176 @@
  * ----------------------------------------------------------------------------
  */
 
+#include "board.h"
+#include "libsam_gui.h"
+#include "libqtouch.h"
+
+/* RTOS operations */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <stdio.h>
+
 /**
  * \addtogroup SAMGUI_WGT_CORE_FRONTEND WGT Core Frontend
  * @{
  *   \addtogroup SAMGUI_WGT_frontend_QTouch SAM-GUI WGT QTouch Frontend
  *   @{
+ * The QTouch driver posts messages to the Widget message queue:
+ * <ul>
+ * <li>WGT_MSG_KEY_PRESSED / WGT_MSG_KEY_RELEASED: key sensors 0 to 4 went in or
+ * out of detect, reported as WGT_KEY_K1 to WGT_KEY_K5.</li>
+ * <li>WGT_MSG_KEY_PRESSED with WGT_KEY_S1: the slider (first rotor/slider,
+ * sensor 5) was touched or moved, the second parameter is its position.</li>
+ * <li>WGT_MSG_KEY_RELEASED with WGT_KEY_S1: the slider was released.</li>
+ * </ul>
+ * \n
+ *
+ * A low priority task runs the measurements, rerunning the burst at once while
+ * the library asks for it. While a sensor is in detect or the library is
+ * resolving a state, the sensors are scanned every QTOUCH_ACTIVE_PERIOD ms;
+ * after QTOUCH_IDLE_SCANS scans without activity, every QTOUCH_IDLE_PERIOD ms,
+ * leaving the CPU in tickless idle between scans. Messages are only posted
+ * when a state or position changes.
+ *
+ * The sensors are board specific: the application enables them
+ * (qt_enable_key(), qt_enable_slider()), calls qt_init_sensing() and fills
+ * qt_config_data before the frontend is initialized.
+*/
+
+/*
+ * ----------------------------------------------------------------------------
+ *         QTouch driver parameters
+ * ----------------------------------------------------------------------------
+*/
+#define QTOUCH_ACTIVE_PERIOD   25 /**< Scan period (in ms) while touched */
+#define QTOUCH_IDLE_PERIOD    100 /**< Scan period (in ms) when untouched */
+#define QTOUCH_IDLE_SCANS      20 /**< Scans without activity before slowing down */
+#define QTOUCH_KEYS             5 /**< Key sensors, then the slider sensor */
+
+/** Library flags keeping the fast scan rate */
+#define QTOUCH_ACTIVITY (QTLIB_IN_DETECT | QTLIB_RESOLVE_CAL | QTLIB_RESOLVE_FILTERIN | QTLIB_RESOLVE_DI | QTLIB_RESOLVE_POS_RECAL)
+
+/** measurement data of the library */
+extern qt_touch_lib_measure_data_t qt_measure_data ;
+
+/** Read by the library for its drift and timeout computations */
+uint16_t qt_measurement_period_msec = QTOUCH_ACTIVE_PERIOD ;
+
+/**
+ * \brief Returns the detect state of a sensor
  */
+static uint32_t _WFE_QTouch_GetSensorState( uint32_t dwSensor )
+{
+    return (qt_measure_data.qt_touch_status.sensor_states[dwSensor/8] >> (dwSensor%8)) & 1 ;
+}
 
-#include "libsam_gui.h"
+/**
+ * \brief Posts the changes of the key and slider states since the previous scan
+ */
+static void _WFE_QTouch_PostChanges( uint32_t* pdwKeys, uint32_t* pdwPosition )
+{
+    uint32_t dwKeys=0 ;
+    uint32_t dwChanged ;
+    uint32_t dwPosition ;
+    uint32_t dw ;
+
+    for ( dw=0 ; dw <= QTOUCH_KEYS ; dw++ )
+    {
+        dwKeys|=_WFE_QTouch_GetSensorState( dw ) << dw ;
+    }
+
+    dwChanged=dwKeys ^ *pdwKeys ;
+    for ( dw=0 ; dw < QTOUCH_KEYS ; dw++ )
+    {
+        if ( dwChanged & (1 << dw) )
+        {
+            WGT_PostMessage( (dwKeys & (1 << dw)) ? WGT_MSG_KEY_PRESSED : WGT_MSG_KEY_RELEASED, WGT_KEY_K1+dw, 0 ) ;
+        }
+    }
+
+#if (QT_MAX_NUM_ROTORS_SLIDERS > 0u)
+    dwPosition=qt_measure_data.qt_touch_status.rotor_slider_values[0] ;
+    if ( dwKeys & (1 << QTOUCH_KEYS) )
+    {
+        if ( (dwChanged & (1 << QTOUCH_KEYS)) || (dwPosition != *pdwPosition) )
+        {
+            WGT_PostMessage( WGT_MSG_KEY_PRESSED, WGT_KEY_S1, dwPosition ) ;
+            *pdwPosition=dwPosition ;
+        }
+    }
+    else
+    {
+        if ( dwChanged & (1 << QTOUCH_KEYS) )
+        {
+            WGT_PostMessage( WGT_MSG_KEY_RELEASED, WGT_KEY_S1, *pdwPosition ) ;
+        }
+    }
+#else
+    (void)dwPosition ;
+#endif /* QT_MAX_NUM_ROTORS_SLIDERS */
+
+    *pdwKeys=dwKeys ;
+}
+
+/**
+  * \brief QTouch scanning task
+  *
+  * Measures the sensors at the active or idle period and reports the changes.
+  * qt_measure_sensors() gets the time elapsed since the start of the task, so
+  * that the library timings stay right whatever the period.
+*/
+static void _WFE_QTouch_Task( void* pParameter )
+{
+    portTickType xStart=xTaskGetTickCount() ;
+    uint32_t dwPeriod=QTOUCH_ACTIVE_PERIOD ;
+    uint32_t dwIdleScans=0 ;
+    uint32_t dwKeys=0 ;
+    uint32_t dwPosition=0 ;
+    uint16_t wStatus ;
+
+    while ( 1 )
+    {
+        /* Burst again until the library has resolved the measurement */
+        do
+        {
+            wStatus=qt_measure_sensors( (uint16_t)((xTaskGetTickCount()-xStart)*portTICK_RATE_MS) ) ;
+        } while ( wStatus & QTLIB_BURST_AGAIN ) ;
+
+        if ( wStatus & (QTLIB_STATUS_CHANGE | QTLIB_ROTOR_SLIDER_POS_CHANGE) )
+        {
+            _WFE_QTouch_PostChanges( &dwKeys, &dwPosition ) ;
+        }
+
+        /* Adapt the scan rate to the touch activity */
+        if ( wStatus & QTOUCH_ACTIVITY )
+        {
+            dwIdleScans=0 ;
+            dwPeriod=QTOUCH_ACTIVE_PERIOD ;
+        }
+        else
+        {
+            if ( ++dwIdleScans >= QTOUCH_IDLE_SCANS )
+            {
+                dwPeriod=QTOUCH_IDLE_PERIOD ;
+            }
+        }
+        qt_measurement_period_msec=(uint16_t)dwPeriod ;
+
+        vTaskDelay( dwPeriod/portTICK_RATE_MS ) ;
+    }
+}
 
 static uint32_t _WFE_QTouch_Initialize( void )
 {
+    /* Create the QTouch driver task, below the GUI tasks */
+    if ( xTaskCreate( _WFE_QTouch_Task, "WGT_QT", 256, NULL, tskIDLE_PRIORITY+1, NULL ) != pdPASS )
+    {
+        printf( "Failed to create WGT_QT task\r\n" ) ;
+
+        return SAMGUI_E_OS_TASK_CREATE_FAILED ;
+    }
+
     return SAMGUI_E_OK ;
 }
 
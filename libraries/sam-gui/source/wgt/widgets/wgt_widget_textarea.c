@@ -0,0 +1,223 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#include "libsam_gui.h"
+#include "board.h"
+
+#include <string.h>
+
+/**
+ * \addtogroup SAMGUI
+ * @{
+ *   \addtogroup SAMGUI_WGT
+ *   @{
+ *     \addtogroup SAMGUI_WGT_WIDGETS_TEXTAREA WGT Text Area Widget
+ *     @{
+ *
+ * \brief Scrolling text area using the display hardware scroll.
+ */
+
+/**
+ * Sets the hardware scroll offset matching the top line slot
+ */
+static void _WGT_TextArea_Scroll( SWGTTextArea* pTextArea )
+{
+    if ( pTextArea->dwHardware )
+    {
+        pTextArea->pBE->IOCtl( DISP_BACKEND_IOCTL_SET_SCROLL_OFFSET, (uint32_t*)(pTextArea->dwTop*pTextArea->dwLineHeight), NULL ) ;
+    }
+}
+
+/**
+ * Erases a line slot and draws a text in it, the text is cut at the first
+ * new line or at the area width
+ */
+static void _WGT_TextArea_DrawLine( SWGTTextArea* pTextArea, uint32_t dwSlot, const char* pszText )
+{
+    char szLine[WGT_TEXTAREA_MAX_COLUMNS+1] ;
+    uint32_t dwLength ;
+    uint32_t dwY ;
+    SGUIColor clr ;
+
+    for ( dwLength=0 ; (dwLength < pTextArea->dwColumns) && (pszText[dwLength] != 0) && (pszText[dwLength] != '\n') ; dwLength++ )
+    {
+        szLine[dwLength]=pszText[dwLength] ;
+    }
+    szLine[dwLength]=0 ;
+
+    dwY=pTextArea->dwY+dwSlot*pTextArea->dwLineHeight ;
+
+    clr.u.dwRGBA=pTextArea->dwClrBackground ;
+    pTextArea->pBE->DrawFilledRectangle( 0, dwY, BOARD_LCD_WIDTH-1, dwY+pTextArea->dwLineHeight-1, NULL, &clr ) ;
+
+    if ( dwLength != 0 )
+    {
+        clr.u.dwRGBA=pTextArea->dwClrText ;
+        pTextArea->pBE->DrawText( 0, dwY+1, szLine, &clr, pTextArea->pFont, 0 ) ;
+    }
+}
+
+/**
+ * Initializes a text area over the panel rows dwY to dwY+dwHeight-1, the height
+ * is rounded down to whole text lines
+ */
+extern uint32_t WGT_TextArea_Initialize( SWGTTextArea* pTextArea, SDISPBackend* pBE, uint32_t dwY, uint32_t dwHeight,
+                                         SGUIFont* pFont, uint32_t dwClrText, uint32_t dwClrBackground )
+{
+    uint32_t adwArea[2] ;
+    uint32_t dwLength=sizeof( adwArea ) ;
+
+    if ( (pTextArea == NULL) || (pBE == NULL) || (pFont == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( dwY+dwHeight > BOARD_LCD_HEIGHT )
+    {
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+
+    memset( pTextArea, 0, sizeof( SWGTTextArea ) ) ;
+    pTextArea->pBE=pBE ;
+    pTextArea->pFont=pFont ;
+    pTextArea->dwY=dwY ;
+    pTextArea->dwLineHeight=pFont->dwHeight+2 ;
+    pTextArea->dwLines=dwHeight/pTextArea->dwLineHeight ;
+    pTextArea->dwColumns=BOARD_LCD_WIDTH/(pFont->dwWidth+2) ;
+    pTextArea->dwClrText=dwClrText ;
+    pTextArea->dwClrBackground=dwClrBackground ;
+
+    if ( pTextArea->dwLines == 0 )
+    {
+        return SAMGUI_E_BAD_PARAMETER ;
+    }
+
+    if ( pTextArea->dwColumns > WGT_TEXTAREA_MAX_COLUMNS )
+    {
+        pTextArea->dwColumns=WGT_TEXTAREA_MAX_COLUMNS ;
+    }
+
+    // Ask the backend for a hardware scroll area of whole lines
+    if ( pBE->IOCtl != NULL )
+    {
+        adwArea[0]=dwY ;
+        adwArea[1]=pTextArea->dwLines*pTextArea->dwLineHeight ;
+
+        if ( pBE->IOCtl( DISP_BACKEND_IOCTL_SET_SCROLL_AREA, adwArea, &dwLength ) == SAMGUI_E_OK )
+        {
+            pTextArea->dwHardware=1 ;
+        }
+    }
+
+    return WGT_TextArea_Clear( pTextArea ) ;
+}
+
+/**
+ * Gives the whole screen back to the base image, not scrolled
+ */
+extern uint32_t WGT_TextArea_Exit( SWGTTextArea* pTextArea )
+{
+    uint32_t adwArea[2]={ 0, BOARD_LCD_HEIGHT } ;
+    uint32_t dwLength=sizeof( adwArea ) ;
+
+    if ( pTextArea == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( pTextArea->dwHardware )
+    {
+        pTextArea->pBE->IOCtl( DISP_BACKEND_IOCTL_SET_SCROLL_AREA, adwArea, &dwLength ) ;
+        pTextArea->dwHardware=0 ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Erases all the lines of a text area
+ */
+extern uint32_t WGT_TextArea_Clear( SWGTTextArea* pTextArea )
+{
+    SGUIColor clr ;
+
+    if ( pTextArea == NULL )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    clr.u.dwRGBA=pTextArea->dwClrBackground ;
+    pTextArea->pBE->DrawFilledRectangle( 0, pTextArea->dwY, BOARD_LCD_WIDTH-1, pTextArea->dwY+pTextArea->dwLines*pTextArea->dwLineHeight-1, NULL, &clr ) ;
+
+    pTextArea->dwCount=0 ;
+    pTextArea->dwTop=0 ;
+    _WGT_TextArea_Scroll( pTextArea ) ;
+
+    return SAMGUI_E_OK ;
+}
+
+/**
+ * Appends a line at the bottom of a text area. Once the area is full, the
+ * oldest line slot is redrawn with the new text and becomes the bottom line
+ * by moving the scroll offset, the other lines are not redrawn.
+ */
+extern uint32_t WGT_TextArea_AppendLine( SWGTTextArea* pTextArea, const char* pszText )
+{
+    uint32_t dwSlot ;
+    uint32_t dwScroll=0 ;
+
+    if ( (pTextArea == NULL) || (pszText == NULL) )
+    {
+        return SAMGUI_E_BAD_POINTER ;
+    }
+
+    if ( pTextArea->dwCount < pTextArea->dwLines )
+    {
+        dwSlot=pTextArea->dwCount++ ;
+    }
+    else
+    {
+        dwSlot=pTextArea->dwTop ;
+        pTextArea->dwTop=(pTextArea->dwTop+1)%pTextArea->dwLines ;
+        dwScroll=1 ;
+    }
+
+    _WGT_TextArea_DrawLine( pTextArea, dwSlot, pszText ) ;
+
+    if ( dwScroll )
+    {
+        _WGT_TextArea_Scroll( pTextArea ) ;
+    }
+
+    return SAMGUI_E_OK ;
+}
+
+/** @}
+ * @}
+ * @} */
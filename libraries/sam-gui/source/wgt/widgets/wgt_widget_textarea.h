@@ -0,0 +1,84 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2009, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef _SAMGUI_WIDGET_TEXTAREA_
+#define _SAMGUI_WIDGET_TEXTAREA_
+
+#include "source/disp/disp_backend.h"
+
+/**
+ * \addtogroup SAMGUI
+ * @{
+ *   \addtogroup SAMGUI_WGT
+ *   @{
+ *     \addtogroup SAMGUI_WGT_WIDGETS_TEXTAREA WGT Text Area Widget
+ *     @{
+ *
+ * \brief Scrolling text area for log and terminal screens.
+ *
+ * The text area is a band of full panel rows holding whole text lines. When
+ * the band is full, appending a line overwrites the oldest line in GRAM and
+ * moves the hardware scroll offset by one line (DISP_BACKEND_IOCTL_SET_SCROLL_AREA
+ * and DISP_BACKEND_IOCTL_SET_SCROLL_OFFSET), so each new line costs one line
+ * render. As the GRAM rows no longer match the panel rows, no other widget
+ * should be drawn inside the band. With a backend unable to scroll, new lines
+ * wrap back to the top of the band.
+ */
+
+#define WGT_TEXTAREA_MAX_COLUMNS  32
+
+typedef struct _SWGTTextArea
+{
+    SDISPBackend* pBE ;
+    SGUIFont* pFont ;
+
+    uint32_t dwY ;               /* first panel row of the band */
+    uint32_t dwLineHeight ;      /* rows per text line */
+    uint32_t dwLines ;           /* text lines in the band */
+    uint32_t dwColumns ;         /* characters per text line */
+
+    uint32_t dwCount ;           /* lines written, at most dwLines */
+    uint32_t dwTop ;             /* line slot displayed at the top of the band */
+    uint32_t dwHardware ;        /* 1 when the backend scrolls the band */
+
+    uint32_t dwClrText ;
+    uint32_t dwClrBackground ;
+} SWGTTextArea ;
+
+extern uint32_t WGT_TextArea_Initialize( SWGTTextArea* pTextArea, SDISPBackend* pBE, uint32_t dwY, uint32_t dwHeight,
+                                         SGUIFont* pFont, uint32_t dwClrText, uint32_t dwClrBackground ) ;
+extern uint32_t WGT_TextArea_Exit( SWGTTextArea* pTextArea ) ;
+extern uint32_t WGT_TextArea_Clear( SWGTTextArea* pTextArea ) ;
+extern uint32_t WGT_TextArea_AppendLine( SWGTTextArea* pTextArea, const char* pszText ) ;
+
+/** @}
+ * @}
+ * @} */
+
+#endif // _SAMGUI_WIDGET_TEXTAREA_
@@ -3,7 +3,7 @@
 CROSS_COMPILE = arm-none-eabi-
 
 # Compilation tools
-AR = $(CROSS_COMPILE)ar
+AR = $(CROSS_COMPILE)$(ARCHIVER)
 CC = $(CROSS_COMPILE)gcc
 AS = $(CROSS_COMPILE)as
 LD = $(CROSS_COMPILE)ld
@@ -12,6 +12,10 @@ OBJCOPY = $(CROSS_COMPILE)objcopy
 
 # Flags
 
+# Long calls and archiver, replaced by perf.mk
+LONG_CALLS ?= -mlong-calls
+ARCHIVER ?= ar
+
 CFLAGS += -Wall -Wchar-subscripts -Wcomment -Wformat=2 -Wimplicit-int
 CFLAGS += -Werror-implicit-function-declaration -Wmain -Wparentheses
 CFLAGS += -Wsequence-point -Wreturn-type -Wswitch -Wtrigraphs -Wunused
@@ -26,7 +30,7 @@ CFLAGS += -Wcast-align
 #CFLAGS += -Wmissing-noreturn
 #CFLAGS += -Wconversion
 
-CFLAGS += --param max-inline-insns-single=500 -mcpu=cortex-m3 -mthumb -mlong-calls -ffunction-sections
+CFLAGS += --param max-inline-insns-single=500 -mcpu=cortex-m3 -mthumb $(LONG_CALLS) -ffunction-sections
 CFLAGS += $(OPTIMIZATION) $(INCLUDES) -D$(CHIP) -DTRACE_LEVEL=$(TRACE_LEVEL)
 
 # To reduce application size use only integer printf function.
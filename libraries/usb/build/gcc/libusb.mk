@@ -28,7 +28,7 @@
 
 # Makefile for compiling libusb
 .SUFFIXES: .o .a .c .s
-SUB_MAKEFILES=debug.mk gcc.mk iar.mk mdk.mk release.mk win.mk linux.mk
+SUB_MAKEFILES=debug.mk gcc.mk iar.mk mdk.mk perf.mk release.mk win.mk linux.mk
 
 #-------------------------------------------------------------------------------
 # User-modifiable options
@@ -78,6 +78,7 @@ vpath %.c $(PROJECT_BASE_PATH)/common/massstorage
 vpath %.c $(PROJECT_BASE_PATH)/device/audio-speaker
 vpath %.c $(PROJECT_BASE_PATH)/device/audio-speakerphone
 vpath %.c $(PROJECT_BASE_PATH)/device/ccid
+vpath %.c $(PROJECT_BASE_PATH)/device/cdc-ncm
 vpath %.c $(PROJECT_BASE_PATH)/device/cdc-serial
 vpath %.c $(PROJECT_BASE_PATH)/device/composite
 vpath %.c $(PROJECT_BASE_PATH)/device/core
@@ -85,6 +86,7 @@ vpath %.c $(PROJECT_BASE_PATH)/device/hid-keyboard
 vpath %.c $(PROJECT_BASE_PATH)/device/hid-mouse
 vpath %.c $(PROJECT_BASE_PATH)/device/hid-transfer
 vpath %.c $(PROJECT_BASE_PATH)/device/massstorage
+vpath %.c $(PROJECT_BASE_PATH)/device/vendor
 vpath %.s $(PROJECT_BASE_PATH)/source
 
 VPATH += $(PROJECT_BASE_PATH)/common/audio
@@ -95,6 +97,7 @@ VPATH += $(PROJECT_BASE_PATH)/common/massstorage
 VPATH += $(PROJECT_BASE_PATH)/device/audio-speaker
 VPATH += $(PROJECT_BASE_PATH)/device/audio-speakerphone
 VPATH += $(PROJECT_BASE_PATH)/device/ccid
+VPATH += $(PROJECT_BASE_PATH)/device/cdc-ncm
 VPATH += $(PROJECT_BASE_PATH)/device/cdc-serial
 VPATH += $(PROJECT_BASE_PATH)/device/composite
 VPATH += $(PROJECT_BASE_PATH)/device/core
@@ -102,6 +105,7 @@ VPATH += $(PROJECT_BASE_PATH)/device/hid-keyboard
 VPATH += $(PROJECT_BASE_PATH)/device/hid-mouse
 VPATH += $(PROJECT_BASE_PATH)/device/hid-transfer
 VPATH += $(PROJECT_BASE_PATH)/device/massstorage
+VPATH += $(PROJECT_BASE_PATH)/device/vendor
 
 INCLUDES = -I$(PROJECT_BASE_PATH)
 INCLUDES += -I$(PROJECT_BASE_PATH)/include
@@ -115,8 +119,12 @@ INCLUDES += -I$(PROJECT_BASE_PATH)/../usb/include/ccid
 ifdef DEBUG
 include debug.mk
 else
+ifdef PERF
+include perf.mk
+else
 include release.mk
 endif
+endif
 
 #-------------------------------------------------------------------------------
 # Tools
@@ -129,9 +137,14 @@ ifdef DEBUG
 OUTPUT_OBJ=debug
 OUTPUT_LIB=$(LIBNAME)_$(SERIE)_$(TOOLCHAIN)_dbg.a
 else
+ifdef PERF
+OUTPUT_OBJ=perf
+OUTPUT_LIB=$(LIBNAME)_$(SERIE)_$(TOOLCHAIN)_perf.a
+else
 OUTPUT_OBJ=release
 OUTPUT_LIB=$(LIBNAME)_$(SERIE)_$(TOOLCHAIN)_rel.a
 endif
+endif
 
 OUTPUT_PATH=$(OUTPUT_OBJ)_$(BOARD)
 
@@ -146,6 +159,7 @@ C_SRC+=$(wildcard $(PROJECT_BASE_PATH)/common/massstorage/*.c)
 C_SRC+=$(wildcard $(PROJECT_BASE_PATH)/device/audio-speaker/*.c)
 C_SRC+=$(wildcard $(PROJECT_BASE_PATH)/device/audio-speakerphone/*.c)
 #C_SRC+=$(wildcard $(PROJECT_BASE_PATH)/device/ccid/*.c)
+C_SRC+=$(wildcard $(PROJECT_BASE_PATH)/device/cdc-ncm/*.c)
 C_SRC+=$(wildcard $(PROJECT_BASE_PATH)/device/cdc-serial/*.c)
 C_SRC+=$(wildcard $(PROJECT_BASE_PATH)/device/composite/*.c)
 C_SRC+=$(wildcard $(PROJECT_BASE_PATH)/device/core/*.c)
@@ -153,6 +167,7 @@ C_SRC+=$(wildcard $(PROJECT_BASE_PATH)/device/hid-keyboard/*.c)
 C_SRC+=$(wildcard $(PROJECT_BASE_PATH)/device/hid-mouse/*.c)
 C_SRC+=$(wildcard $(PROJECT_BASE_PATH)/device/hid-transfer/*.c)
 C_SRC+=$(wildcard $(PROJECT_BASE_PATH)/device/massstorage/*.c)
+C_SRC+=$(wildcard $(PROJECT_BASE_PATH)/device/vendor/*.c)
 
 C_OBJ_TEMP=$(patsubst %.c, %.o, $(notdir $(C_SRC)))
 
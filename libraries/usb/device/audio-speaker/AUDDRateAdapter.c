@@ -0,0 +1,350 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file
+ * \addtogroup usbd_audio_speaker
+ *@{
+ */
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include <AUDDRateAdapter.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Number of history frames kept between packets. */
+#define HISTORY         (AUDDRateAdapter_TAPS - 1)
+/** Position of the first input frame for the resampler. */
+#define BYPASS_POS      ((HISTORY - AUDDRateAdapter_TAPS / 2 + 1) << 16)
+
+/** Proportional gain of the feedback controller (shift). */
+#define FB_KP_SHIFT     5
+/** Integral gain of the feedback controller (shift). */
+#define FB_KI_SHIFT     10
+/** Feedback range around the nominal value (shift). */
+#define FB_RANGE_SHIFT  7
+
+/** Resampler step correction per frame of fill level error (Q16). */
+#define STEP_KFILL      4
+/** Resampler step range around 1 (Q16). */
+#define STEP_RANGE      512
+/** Measured drift range in ppm. */
+#define DRIFT_RANGE     100000
+
+/*------------------------------------------------------------------------------
+ *         Internal variables
+ *------------------------------------------------------------------------------*/
+
+/**
+ * Kaiser windowed sinc interpolator (beta 5), Q15. Row p gives the taps for
+ * an output sample p/32 of a frame after the fourth tap; the extra row
+ * allows the linear interpolation between phases.
+ */
+static const int16_t firPhases[AUDDRateAdapter_PHASES + 1]
+                              [AUDDRateAdapter_TAPS] = {
+    {     0,      0,      0,  32767,      0,      0,      0,      0},
+    {   -75,    273,   -853,  32719,    924,   -293,     82,    -10},
+    {  -142,    524,  -1633,  32555,   1918,   -604,    172,    -23},
+    {  -201,    753,  -2337,  32276,   2977,   -931,    267,    -37},
+    {  -253,    957,  -2966,  31887,   4098,  -1271,    369,    -54},
+    {  -296,   1137,  -3519,  31388,   5275,  -1621,    475,    -72},
+    {  -332,   1293,  -3996,  30783,   6505,  -1978,    585,    -93},
+    {  -359,   1423,  -4398,  30076,   7780,  -2338,    698,   -115},
+    {  -380,   1529,  -4726,  29274,   9094,  -2698,    812,   -138},
+    {  -394,   1610,  -4982,  28381,  10442,  -3053,    926,   -163},
+    {  -401,   1669,  -5170,  27403,  11815,  -3399,   1039,   -189},
+    {  -402,   1705,  -5291,  26346,  13207,  -3732,   1149,   -215},
+    {  -398,   1719,  -5349,  25220,  14609,  -4047,   1254,   -241},
+    {  -389,   1714,  -5348,  24030,  16014,  -4340,   1353,   -267},
+    {  -376,   1690,  -5292,  22785,  17413,  -4604,   1444,   -293},
+    {  -359,   1650,  -5185,  21492,  18798,  -4837,   1525,   -317},
+    {  -339,   1594,  -5032,  20160,  20161,  -5032,   1594,   -339},
+    {  -317,   1525,  -4837,  18798,  21492,  -5185,   1650,   -359},
+    {  -293,   1444,  -4604,  17413,  22785,  -5292,   1690,   -376},
+    {  -267,   1353,  -4340,  16014,  24030,  -5348,   1714,   -389},
+    {  -241,   1254,  -4047,  14609,  25220,  -5349,   1719,   -398},
+    {  -215,   1149,  -3732,  13207,  26346,  -5291,   1705,   -402},
+    {  -189,   1039,  -3399,  11815,  27403,  -5170,   1669,   -401},
+    {  -163,    926,  -3053,  10442,  28381,  -4982,   1610,   -394},
+    {  -138,    812,  -2698,   9094,  29274,  -4726,   1529,   -380},
+    {  -115,    698,  -2338,   7780,  30076,  -4398,   1423,   -359},
+    {   -93,    585,  -1978,   6505,  30783,  -3996,   1293,   -332},
+    {   -72,    475,  -1621,   5275,  31388,  -3519,   1137,   -296},
+    {   -54,    369,  -1271,   4098,  31887,  -2966,    957,   -253},
+    {   -37,    267,   -931,   2977,  32276,  -2337,    753,   -201},
+    {   -23,    172,   -604,   1918,  32555,  -1633,    524,   -142},
+    {   -10,     82,   -293,    924,  32719,   -853,    273,    -75},
+    {     0,      0,      0,      0,  32767,      0,      0,      0}
+};
+
+/** History and input frames of the packet being resampled. */
+static int16_t line[(HISTORY + AUDDRateAdapter_MAXFRAMES)
+                    * AUDDRateAdapter_MAXCHANNELS];
+
+/*------------------------------------------------------------------------------
+ *         Internal functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * Clamps a value around a center.
+ */
+static int32_t AUDDRateAdapter_Clamp(int32_t lValue,
+                                     int32_t lCenter,
+                                     int32_t lRange)
+{
+    if (lValue > lCenter + lRange) return lCenter + lRange;
+    if (lValue < lCenter - lRange) return lCenter - lRange;
+    return lValue;
+}
+
+/**
+ * Resamples the frames of the line buffer, from the current position.
+ * \param pRa    Pointer to AUDDRateAdapter instance.
+ * \param dwTotal Number of frames in the line buffer.
+ * \param pOut   Output buffer.
+ * \return Number of frames written.
+ */
+static uint32_t AUDDRateAdapter_Resample(AUDDRateAdapter *pRa,
+                                         uint32_t dwTotal,
+                                         int16_t *pOut)
+{
+    uint8_t bCh = pRa->bNumChannels;
+    uint32_t dwPos = pRa->dwPos;
+    uint32_t dwOut = 0;
+    int32_t  lTaps[AUDDRateAdapter_TAPS];
+    const int16_t *pX;
+    const int16_t *pC0, *pC1;
+    int32_t  lFrac, lAcc;
+    uint32_t i, c;
+
+    while ((dwPos >> 16) + AUDDRateAdapter_TAPS <= dwTotal) {
+
+        pX  = &line[(dwPos >> 16) * bCh];
+        pC0 = firPhases[(dwPos & 0xFFFF) >> 11];
+        pC1 = pC0 + AUDDRateAdapter_TAPS;
+        lFrac = dwPos & 0x7FF;
+
+        /* Interpolate the taps between the two nearest phases */
+        for (i = 0; i < AUDDRateAdapter_TAPS; i ++)
+            lTaps[i] = pC0[i] + (((pC1[i] - pC0[i]) * lFrac) >> 11);
+
+        for (c = 0; c < bCh; c ++) {
+            lAcc = 1 << 14;
+            for (i = 0; i < AUDDRateAdapter_TAPS; i ++)
+                lAcc += lTaps[i] * pX[i * bCh + c];
+            lAcc >>= 15;
+            if (lAcc >  32767) lAcc =  32767;
+            if (lAcc < -32768) lAcc = -32768;
+            *pOut++ = (int16_t)lAcc;
+        }
+
+        dwPos += pRa->dwStep;
+        dwOut ++;
+    }
+
+    pRa->dwPos = dwPos;
+    return dwOut;
+}
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * Initializes a rate adapter.
+ * \param pRa          Pointer to AUDDRateAdapter instance.
+ * \param dwNominal    Local playback rate, 10.14 samples per frame
+ *                     (see AUDDSpeakerDriver_FEEDBACK).
+ * \param bNumChannels Number of interleaved channels.
+ * \param dwTarget     Fill level to keep, in frames.
+ * \param dwThreshold  Drift in ppm above which the resampler is engaged.
+ */
+void AUDDRateAdapter_Initialize(AUDDRateAdapter *pRa,
+                                uint32_t dwNominal,
+                                uint8_t bNumChannels,
+                                uint32_t dwTarget,
+                                uint32_t dwThreshold)
+{
+    if (bNumChannels > AUDDRateAdapter_MAXCHANNELS)
+        bNumChannels = AUDDRateAdapter_MAXCHANNELS;
+
+    pRa->dwNominal    = dwNominal;
+    pRa->bNumChannels = bNumChannels;
+    pRa->dwTarget     = dwTarget;
+    pRa->dwThreshold  = dwThreshold;
+    AUDDRateAdapter_Reset(pRa);
+}
+
+/**
+ * Restarts the feedback control and the drift measure, to be invoked when
+ * the playback starts.
+ * \param pRa Pointer to AUDDRateAdapter instance.
+ */
+void AUDDRateAdapter_Reset(AUDDRateAdapter *pRa)
+{
+    pRa->dwFeedback  = pRa->dwNominal;
+    pRa->lIntegral   = 0;
+    pRa->lDrift      = 0;
+    pRa->dwPackets   = 0;
+    pRa->dwReceived  = 0;
+    pRa->dwProduced  = 0;
+    pRa->dwFillStart = 0;
+    pRa->dwStep      = 1 << 16;
+    pRa->dwPos       = BYPASS_POS;
+    pRa->bEngaged    = 0;
+    memset(pRa->sHistory, 0, sizeof(pRa->sHistory));
+}
+
+/**
+ * Processes a packet of frames received from the host. The frames are
+ * resampled when the resampler is engaged, and copied otherwise.
+ * \param pRa      Pointer to AUDDRateAdapter instance.
+ * \param pIn      Interleaved input samples.
+ * \param dwFrames Number of input frames (<= AUDDRateAdapter_MAXFRAMES).
+ * \param pOut     Output buffer, of AUDDRateAdapter_OUTFRAMES(dwFrames)
+ *                 frames, distinct from the input buffer.
+ * \return Number of frames written to the output buffer.
+ */
+uint32_t AUDDRateAdapter_Process(AUDDRateAdapter *pRa,
+                                 const int16_t *pIn,
+                                 uint32_t dwFrames,
+                                 int16_t *pOut)
+{
+    uint8_t  bCh = pRa->bNumChannels;
+    uint32_t dwTotal;
+    uint32_t dwStart;
+    uint32_t dwOut;
+
+    if (dwFrames > AUDDRateAdapter_MAXFRAMES)
+        dwFrames = AUDDRateAdapter_MAXFRAMES;
+    dwTotal = HISTORY + dwFrames;
+
+    memcpy(line, pRa->sHistory, HISTORY * bCh * sizeof(int16_t));
+    memcpy(&line[HISTORY * bCh], pIn, dwFrames * bCh * sizeof(int16_t));
+
+    if (pRa->bEngaged) {
+
+        dwOut = AUDDRateAdapter_Resample(pRa, dwTotal, pOut);
+        pRa->dwPos -= dwFrames << 16;
+    }
+    else {
+
+        /* Copy the frames from the last resampled one, the first
+           packet after the resampler is disengaged catches up with
+           the frames still in its delay line */
+        dwStart = (pRa->dwPos >> 16) + AUDDRateAdapter_TAPS / 2 - 1;
+        dwOut = dwTotal - dwStart;
+        memcpy(pOut, &line[dwStart * bCh], dwOut * bCh * sizeof(int16_t));
+        pRa->dwPos = BYPASS_POS;
+    }
+
+    memcpy(pRa->sHistory, &line[dwFrames * bCh],
+           HISTORY * bCh * sizeof(int16_t));
+    pRa->dwProduced += dwOut;
+
+    return dwOut;
+}
+
+/**
+ * Updates the feedback value and the drift measure after a packet has been
+ * queued for playback.
+ * \param pRa        Pointer to AUDDRateAdapter instance.
+ * \param dwReceived Number of frames received in the packet.
+ * \param dwFill     Number of frames waiting for playback, packet included.
+ * \return Feedback value for the host, 10.14 samples per frame.
+ */
+uint32_t AUDDRateAdapter_Update(AUDDRateAdapter *pRa,
+                                uint32_t dwReceived,
+                                uint32_t dwFill)
+{
+    int32_t lError = (int32_t)pRa->dwTarget - (int32_t)dwFill;
+    int32_t lRange = pRa->dwNominal >> FB_RANGE_SHIFT;
+    int32_t lStep;
+    uint32_t dwConsumed;
+
+    /* PI control of the fill level */
+    pRa->lIntegral = AUDDRateAdapter_Clamp(
+                        pRa->lIntegral + ((lError << 14) >> FB_KI_SHIFT),
+                        0, lRange);
+    pRa->dwFeedback = AUDDRateAdapter_Clamp(
+                        (int32_t)pRa->dwNominal + pRa->lIntegral
+                            + ((lError << 14) >> FB_KP_SHIFT),
+                        pRa->dwNominal, lRange);
+
+    /* Host rate against local rate, between two updates */
+    if (pRa->dwPackets)
+        pRa->dwReceived += dwReceived;
+    if (pRa->dwPackets ++ >= AUDDRateAdapter_WINDOW) {
+
+        dwConsumed = pRa->dwProduced + pRa->dwFillStart - dwFill;
+        if (dwConsumed) {
+            pRa->lDrift = AUDDRateAdapter_Clamp(
+                            (int32_t)(((int64_t)pRa->dwReceived
+                                       - (int64_t)dwConsumed) * 1000000
+                                      / dwConsumed),
+                            0, DRIFT_RANGE);
+        }
+        if (!pRa->bEngaged
+            && (uint32_t)abs(pRa->lDrift) > pRa->dwThreshold) {
+            pRa->bEngaged = 1;
+        }
+        else if (pRa->bEngaged
+                 && (uint32_t)abs(pRa->lDrift) < pRa->dwThreshold / 2) {
+            pRa->bEngaged = 0;
+        }
+        pRa->dwPackets  = 1;
+    }
+    /* Reference of the next measure */
+    if (pRa->dwPackets == 1) {
+        pRa->dwFillStart = dwFill;
+        pRa->dwReceived  = 0;
+        pRa->dwProduced  = 0;
+    }
+
+    /* Resampler ratio: measured drift, corrected by the fill level */
+    if (pRa->bEngaged) {
+        lStep = (1 << 16) + (pRa->lDrift * 4295 >> 16)
+              - lError * STEP_KFILL;
+        pRa->dwStep = AUDDRateAdapter_Clamp(lStep, 1 << 16, STEP_RANGE);
+    }
+    else {
+        pRa->dwStep = 1 << 16;
+    }
+
+    return pRa->dwFeedback;
+}
+
+/**@}*/
@@ -62,6 +62,10 @@ typedef struct _AUDDSpeakerDriver {
     AUDDStream  speaker;
     /** Array for storing the current setting of each interface */
     uint8_t     bAltInterfaces[AUDDSpeakerDriver_NUMINTERFACES];
+    /** Feedback value sent to the host, 10.14 samples per frame */
+    uint32_t    dwFeedback;
+    /** Buffer of the feedback packet being sent */
+    uint8_t     bFeedback[AUDDSpeakerDriver_FEEDBACKSIZE];
 } AUDDSpeakerDriver;
 
 /*----------------------------------------------------------------------------
@@ -79,6 +83,47 @@ static AUDDSpeakerDriver auddSpeakerDriver;
  *         Internal functions
  *----------------------------------------------------------------------------*/
 
+static void AUDDSpeaker_FeedbackSent(void *pArg,
+                                     uint8_t status,
+                                     uint32_t transferred,
+                                     uint32_t remaining);
+
+/**
+ * Loads the current feedback value on the feedback endpoint. The transfer
+ * completes when the host polls the endpoint and is then loaded again, so
+ * that the host always reads the latest value.
+ */
+static void AUDDSpeaker_SendFeedback(void)
+{
+    AUDDSpeakerDriver *pAudd = &auddSpeakerDriver;
+    AUDDStream *pAuds = &pAudd->speaker;
+    uint32_t dwFeedback = pAudd->dwFeedback;
+
+    pAudd->bFeedback[0] = dwFeedback & 0xFF;
+    pAudd->bFeedback[1] = (dwFeedback >> 8) & 0xFF;
+    pAudd->bFeedback[2] = (dwFeedback >> 16) & 0xFF;
+    USBD_Write(pAuds->bEndpointFb,
+               pAudd->bFeedback, AUDDSpeakerDriver_FEEDBACKSIZE,
+               (TransferCallback)AUDDSpeaker_FeedbackSent, 0);
+}
+
+/**
+ * Callback invoked when the host has read the feedback value.
+ * \param pArg      Unused.
+ * \param status    Transfer status.
+ * \param transferred Number of bytes transferred.
+ * \param remaining   Number of bytes not transferred.
+ */
+static void AUDDSpeaker_FeedbackSent(void *pArg,
+                                     uint8_t status,
+                                     uint32_t transferred,
+                                     uint32_t remaining)
+{
+    /* Stop when the stream is closed */
+    if (status == USBD_STATUS_SUCCESS)
+        AUDDSpeaker_SendFeedback();
+}
+
 /**
  * Callback triggerred after the mute or volume status of the channel has been
  * changed.
@@ -169,6 +214,12 @@ void AUDDSpeakerDriver_InterfaceSettingChangedHandler(uint8_t interface,
     if (setting == 0) {
         AUDDSpeakerPhone_CloseStream(pAudf, interface);
     }
+    /* Asynchronous stream started: provide the rate feedback */
+    else if (interface == pSpeakerd->speaker.bAsInterface
+             && pSpeakerd->speaker.bEndpointFb
+             && pSpeakerd->dwFeedback) {
+        AUDDSpeaker_SendFeedback();
+    }
 
     if (AUDDSpeakerDriver_StreamSettingChanged)
         AUDDSpeakerDriver_StreamSettingChanged(setting);
@@ -231,4 +282,16 @@ uint8_t AUDDSpeakerDriver_Read(void *buffer,
                      callback, argument);
 }
 
+/**
+ * Sets the rate feedback value returned to the host on the feedback endpoint
+ * of an asynchronous stream, as the number of samples per frame in 10.14
+ * format. The value is sent with the next poll of the host; a null value
+ * keeps the feedback endpoint off when the stream starts.
+ * \param dwFeedback Samples per frame, 10.14 fixed point.
+ */
+void AUDDSpeakerDriver_SetFeedback(uint32_t dwFeedback)
+{
+    auddSpeakerDriver.dwFeedback = dwFeedback;
+}
+
 /**@}*/
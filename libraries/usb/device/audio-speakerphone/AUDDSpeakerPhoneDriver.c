@@ -414,6 +414,41 @@ uint8_t AUDDSpeakerPhoneDriver_Read(void *buffer,
                      argument);
 }
 
+/**
+ * Initialize Frame List for receiving audio data in place.
+ * Once set up, AUDDSpeakerPhoneDriver_Read() only queues its buffer, the
+ * callback is invoked with USBD_STATUS_PARTIAL_DONE each time a queued buffer
+ * has been filled with one packet, in queuing order. The buffer belongs to
+ * the application until it is queued again.
+ *
+ * \param pListInit Pointer to the allocated list for audio read.
+ * \param listSize  Circular list size.
+ * \param callback  Optional callback function for transfer.
+ * \param argument  Optional callback argument.
+ * \return USBD_STATUS_SUCCESS if setup successfully; otherwise an error code.
+ */
+uint8_t AUDDSpeakerPhoneDriver_SetupRead(void * pListInit,
+                                         uint16_t listSize,
+                                         TransferCallback callback,
+                                         void * argument)
+{
+    AUDDSpeakerPhoneDriver *pAudd = &auddSpeakerPhoneDriver;
+    uint8_t error;
+
+    if (pAudd->speaker.bEpNum == 0)
+        return USBRC_STATE_ERR;
+
+    error = USBD_HAL_SetupMblTransfer(pAudd->speaker.bEpNum,
+                                      pListInit,
+                                      listSize,
+                                      0);
+    if (error)  return error;
+    error = USBD_HAL_SetTransferCallback(
+                                    pAudd->speaker.bEpNum,
+                                    callback, argument);
+    return error;
+}
+
 /**
  * Initialize Frame List for sending audio data.
  *
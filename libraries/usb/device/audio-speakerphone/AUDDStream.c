@@ -61,6 +61,8 @@ typedef struct _AUDDParseData {
     AUDDSpeakerPhone * pAudf;
     /** Pointer to found interface descriptor */
     USBInterfaceDescriptor * pIfDesc;
+    /** Speaker OUT endpoint announces a feedback endpoint */
+    uint8_t bSpeakerSync;
     
 } AUDDParseData;
 
@@ -136,7 +138,14 @@ static uint32_t AUDDSpeakerPhone_Parse(USBGenericDescriptor *pDesc,
         /* Find Streaming Interface & Endpoints */
         if (pDesc->bDescriptorType == USBGenericDescriptor_ENDPOINT
             && (pEp->bmAttributes & 0x3) == USBEndpointDescriptor_ISOCHRONOUS) {
+            /* IN endpoint with a refresh rate: feedback of the OUT stream */
             if (pEp->bEndpointAddress & 0x80
+                && pEp->bLength >= sizeof(AUDEndpointDescriptor)
+                && ((AUDEndpointDescriptor*)pEp)->bRefresh
+                && pSpeaker) {
+                pSpeaker->bEndpointFb = pEp->bEndpointAddress & 0x7F;
+            }
+            else if (pEp->bEndpointAddress & 0x80
                 && pMic) {
                 pMic->bEndpointIn = pEp->bEndpointAddress & 0x7F;
                 pMic->bAsInterface = pArg->pIfDesc->bInterfaceNumber;
@@ -145,6 +154,9 @@ static uint32_t AUDDSpeakerPhone_Parse(USBGenericDescriptor *pDesc,
             }
             else if (pSpeaker) {
                 pSpeaker->bEndpointOut = pEp->bEndpointAddress;
+                if (pEp->bLength >= sizeof(AUDEndpointDescriptor)
+                    && ((AUDEndpointDescriptor*)pEp)->bSyncAddress)
+                    pArg->bSpeakerSync = 1;
                 pSpeaker->bAsInterface = pArg->pIfDesc->bInterfaceNumber;
                 /* Fixed FU */
                 pSpeaker->bFeatureUnitOut = AUDD_ID_SpeakerFU;
@@ -156,7 +168,8 @@ static uint32_t AUDDSpeakerPhone_Parse(USBGenericDescriptor *pDesc,
         if (pSpeaker->bAcInterface != 0xFF
             && pSpeaker->bAsInterface != 0xFF
             && pSpeaker->bFeatureUnitOut != 0xFF
-            && pSpeaker->bEndpointOut != 0) {
+            && pSpeaker->bEndpointOut != 0
+            && (pSpeaker->bEndpointFb != 0 || !pArg->bSpeakerSync)) {
             bSpeakerDone = 1;
         }
     }
@@ -359,6 +372,7 @@ void AUDDStream_Initialize(AUDDStream *pAuds,
     pAuds->bAsInterface    = 0xFF;
     pAuds->bEndpointOut    = 0;
     pAuds->bEndpointIn     = 0;
+    pAuds->bEndpointFb     = 0;
 
     pAuds->bNumChannels   = numChannels;
     pAuds->bmMute         = 0;
@@ -473,6 +487,43 @@ uint32_t AUDDStream_Read(
                      fCallback, pArg);
 }
 
+/**
+ * Initialize Frame List for receiving audio data in place.
+ * Once set up, AUDDStream_Read() only queues its buffer: each packet is
+ * received into the next queued buffer and the callback is invoked with
+ * USBD_STATUS_PARTIAL_DONE as each buffer is filled, in queuing order.
+ * The filled buffer can then be played where it is (e.g., by PDC) before
+ * being queued again.
+ * \param pAuds     Pointer to AUDDStream instance.
+ * \param pListInit Pointer to the allocated list for audio read.
+ * \param listSize  Circular list size.
+ * \param callback  Optional callback function for transfer.
+ * \param argument  Optional callback argument.
+ * \return USBD_STATUS_SUCCESS if setup successfully; otherwise an error code.
+ */
+uint32_t AUDDStream_SetupRead(
+    AUDDStream *pAuds,
+    void * pListInit,
+    uint16_t listSize,
+    TransferCallback callback,
+    void * argument)
+{
+    uint32_t error;
+
+    if (pAuds->bEndpointOut == 0)
+        return USBRC_STATE_ERR;
+
+    error = USBD_HAL_SetupMblTransfer(pAuds->bEndpointOut,
+                                      pListInit,
+                                      listSize,
+                                      0);
+    if (error)  return error;
+
+    error = USBD_HAL_SetTransferCallback(pAuds->bEndpointOut,
+                                         callback, argument);
+    return error;
+}
+
 /**
  * Initialize Frame List for sending audio data.
  * \param pAuds     Pointer to AUDDStream instance.
@@ -544,6 +595,9 @@ uint32_t AUDDStream_Close(AUDDStream *pStream)
     if (pStream->bEndpointOut) {
         bmEPs |= 1 << pStream->bEndpointOut;
     }
+    if (pStream->bEndpointFb) {
+        bmEPs |= 1 << pStream->bEndpointFb;
+    }
     USBD_HAL_ResetEPs(bmEPs, USBRC_CANCELED, 1);
 
     return USBRC_SUCCESS;
@@ -577,6 +631,7 @@ void AUDDSpeakerPhone_InitializeStream(
     pAuds->bAsInterface    = 0xFF;
     pAuds->bEndpointOut    = 0;
     pAuds->bEndpointIn     = 0;
+    pAuds->bEndpointFb     = 0;
 
     pAuds->bNumChannels   = numChannels;
     pAuds->bmMute         = 0;
@@ -619,6 +674,7 @@ USBGenericDescriptor *AUDDSpeakerPhone_ParseInterfaces(
 
     data.pAudf = pAudf;
     data.pIfDesc = 0;
+    data.bSpeakerSync = 0;
 
     return USBGenericDescriptor_Parse(pDescriptors,
                                       dwLength,
@@ -626,6 +682,35 @@ USBGenericDescriptor *AUDDSpeakerPhone_ParseInterfaces(
                                       (void*)&data);
 }
 
+/**
+ * Set USB Audio streaming information for AUDDStream instance from a
+ * function map resolved with the descriptors, instead of parsing them.
+ * \param pAudf Pointer to AUDDSpeakerPhone instance.
+ * \param pMap  Pointer to the function map of the audio function.
+ */
+void AUDDSpeakerPhone_MapInterfaces(
+    AUDDSpeakerPhone *pAudf,
+    const USBDFunctionMap *pMap)
+{
+    AUDDStream *pSpeaker = pAudf->pSpeaker;
+    AUDDStream *pMic     = pAudf->pMicrophone;
+    uint8_t bAsInterface = pMap->bInterface + 1;
+
+    if (pSpeaker && pMap->bEpOut) {
+        pSpeaker->bAcInterface    = pMap->bInterface;
+        pSpeaker->bAsInterface    = bAsInterface ++;
+        pSpeaker->bEndpointOut    = pMap->bEpOut;
+        pSpeaker->bEndpointFb     = pMap->bEpAux;
+        pSpeaker->bFeatureUnitOut = AUDD_ID_SpeakerFU;
+    }
+    if (pMic && pMap->bEpIn) {
+        pMic->bAcInterface   = pMap->bInterface;
+        pMic->bAsInterface   = bAsInterface;
+        pMic->bEndpointIn    = pMap->bEpIn;
+        pMic->bFeatureUnitIn = AUDD_ID_MicrophoneFU;
+    }
+}
+
 /**
  * Close the stream. All pending transfers are canceled.
  * \param pAudf        Pointer to AUDDSpeakerPhone instance.
@@ -636,7 +721,10 @@ uint32_t AUDDSpeakerPhone_CloseStream(
     uint32_t bInterface)
 {
     if (pAudf->pSpeaker->bAsInterface == bInterface) {
-        USBD_HAL_ResetEPs(1 << pAudf->pSpeaker->bEndpointOut,
+        uint32_t bmEPs = 1 << pAudf->pSpeaker->bEndpointOut;
+        if (pAudf->pSpeaker->bEndpointFb)
+            bmEPs |= 1 << pAudf->pSpeaker->bEndpointFb;
+        USBD_HAL_ResetEPs(bmEPs,
                           USBRC_CANCELED,
                           1);
     }
@@ -706,6 +794,42 @@ uint32_t AUDDSpeakerPhone_Read(
                      fCallback, pArg);
 }
 
+/**
+ * Initialize Frame List for receiving audio data in place (as speaker).
+ * See AUDDStream_SetupRead().
+ * \param pAudf     Pointer to AUDDSpeakerPhone instance.
+ * \param pListInit Pointer to the allocated list for audio read.
+ * \param listSize  Circular list size.
+ * \param callback  Optional callback function for transfer.
+ * \param argument  Optional callback argument.
+ * \return USBD_STATUS_SUCCESS if setup successfully; otherwise an error code.
+ */
+uint32_t AUDDSpeakerPhone_SetupRead(
+    AUDDSpeakerPhone *pAudf,
+    void * pListInit,
+    uint16_t listSize,
+    TransferCallback callback,
+    void * argument)
+{
+    uint32_t error;
+
+    if (pAudf->pSpeaker == 0)
+        return USBRC_PARAM_ERR;
+    if (pAudf->pSpeaker->bEndpointOut == 0)
+        return USBRC_STATE_ERR;
+
+    error = USBD_HAL_SetupMblTransfer(pAudf->pSpeaker->bEndpointOut,
+                                      pListInit,
+                                      listSize,
+                                      0);
+    if (error)  return error;
+
+    error = USBD_HAL_SetTransferCallback(
+                                    pAudf->pSpeaker->bEndpointOut,
+                                    callback, argument);
+    return error;
+}
+
 /**
  * Initialize Frame List for sending audio data.
  * \param pAudf     Pointer to AUDDSpeakerPhone instance.
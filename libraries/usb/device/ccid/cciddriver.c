@@ -75,6 +75,23 @@
 
 #define MIN(a, b)       ((a < b) ? a : b)
 
+/** Size of the Bulk-OUT and Bulk-IN message headers. */
+#define CCID_HEADER_SIZE      10
+
+/** Response data returned in one RDR_to_PC_DataBlock of a chained response. */
+#define CCID_RSP_BLOCK        256
+
+/** T=0 INS of the ENVELOPE command, carrying a chained command APDU. */
+#define ISO_INS_ENVELOPE      0xC2
+/** T=0 INS of the GET RESPONSE command. */
+#define ISO_INS_GETRESPONSE   0xC0
+
+/** States of the XfrBlock ICC exchange */
+#define XFR_IDLE              0 /* No ICC exchange */
+#define XFR_COMMAND           1 /* TPDU of a command held in one message */
+#define XFR_ENVELOPE          2 /* ENVELOPE of a chained command block */
+#define XFR_GETRESPONSE       3 /* GET RESPONSE for the response data */
+
 /*------------------------------------------------------------------------------
  *         Types
  *------------------------------------------------------------------------------*/
@@ -116,6 +133,69 @@ typedef struct _CCIDDriverConfigurationDescriptors
  *         Types
  *------------------------------------------------------------------------------*/
 
+/**
+ * \brief XfrBlock exchange with the ICC.
+ *
+ * A command APDU held in one message is mapped to one T=0 TPDU. A command
+ * APDU chained over several messages is passed on to the ICC in ENVELOPE
+ * TPDUs as each block arrives, without being gathered. Response data is
+ * fetched with GET RESPONSE one block ahead of the host requests.
+ */
+typedef struct {
+
+    /** TPDU exchanged with the ICC */
+    Iso7816Tpdu    sTpdu;
+    /** XFR_xxx */
+    unsigned char  bState;
+    /** 1 for TPDU level exchanges (R-TPDU returned as is) */
+    unsigned char  bTpduLevel;
+    /** 1 once a TPDU has been sent again with the 6Cxx length */
+    unsigned char  bRetry;
+    /** 1 while a chained command APDU is being received */
+    unsigned char  bChaining;
+    /** 1 if the chained command APDU is an extended one */
+    unsigned char  bExtended;
+    /** 1 if the ICC rejected a block of the chained command APDU */
+    unsigned char  bAborted;
+    /** bError of the failed ICC exchange, 0 if none */
+    unsigned char  bError;
+    /** 1 once the ICC exchange has ended, set from the USART interrupt */
+    volatile unsigned char bDone;
+    /** 1 if the host waits for the first response block */
+    unsigned char  bOwed;
+    /** 1 if a response block is ready in abRsp */
+    unsigned char  bRspReady;
+    /** 1 if the ready block ends the response */
+    unsigned char  bRspLast;
+    /** 1 if a chained response is in progress */
+    unsigned char  bRspChain;
+    /** Lx of the last 61xx status */
+    unsigned char  bNext;
+    /** CLA of the command APDU */
+    unsigned char  bCla;
+    /** Status words which ended the exchange */
+    unsigned char  abSW[2];
+    /** Last two bytes of the chained command APDU (Le) */
+    unsigned char  abTail[2];
+    /** Block data not yet sent in ENVELOPE TPDUs */
+    unsigned char  *pChunk;
+    /** Number of such bytes */
+    unsigned short wChunk;
+    /** 1 if the block ends the chained command APDU */
+    unsigned char  bChunkLast;
+    /** Command APDU data length from the extended header */
+    unsigned long  dwNc;
+    /** Command APDU bytes received */
+    unsigned long  dwStreamed;
+    /** Response data bytes still accepted by the host (Ne) */
+    unsigned long  dwNe;
+    /** Bytes in abRsp */
+    unsigned short wRsp;
+    /** Response block being fetched from the ICC */
+    unsigned char  abRsp[ABDATA_SIZE];
+
+} CCIDXfr;
+
 /** \brief Driver structure for an CCID device */
 
 typedef struct {
@@ -124,8 +204,21 @@ typedef struct {
     USBDDriver             usbdDriver;
     /** CCID message */
     S_ccid_bulk_in_header  sCcidMessage;
-    /** CCID command */
-    S_ccid_bulk_out_header sCcidCommand;
+    /** CCID command buffers: the next command is received in one while the
+        other is still used by the ICC exchange */
+    S_ccid_bulk_out_header asCcidCommand[2];
+    /** CCID command being processed */
+    S_ccid_bulk_out_header *pCommand;
+    /** CCID command received while the slot was busy */
+    S_ccid_bulk_out_header * volatile pPending;
+    /** Index of the command buffer for the next read */
+    unsigned char          bCommandIn;
+    /** 1 while a command is being read */
+    volatile unsigned char bReading;
+    /** 1 while a command or its ICC exchange is processed */
+    volatile unsigned char bBusy;
+    /** XfrBlock exchange with the ICC */
+    CCIDXfr                sXfr;
     /** Interrupt message answer */
     unsigned char          BufferINT[4];
     /** Buffer data of message */
@@ -217,7 +310,7 @@ static const CCIDDriverConfigurationDescriptors configurationDescriptorsFS = {
         0,               /* dwSynchProtocols */
         0,               /* dwMechanical */
         /*0x00010042,    /* dwFeatures: Short APDU level exchanges */*/
-        CCID_FEATURES_AUTO_PCONF | CCID_FEATURES_AUTO_PNEGO | CCID_FEATURES_EXC_TPDU,
+        CCID_FEATURES_AUTO_PCONF | CCID_FEATURES_AUTO_PNEGO | CCID_FEATURES_EXC_APDU,
         0x0000010F,      /* dwMaxCCIDMessageLength: For extended APDU level the value shall be between 261 + 10 */
         0xFF,            /* bClassGetResponse: Echoes the class of the APDU */
         0xFF,            /* bClassEnvelope: Echoes the class of the APDU */
@@ -308,7 +401,7 @@ static const CCIDDriverConfigurationDescriptors configurationDescriptorsHS = {
         0,               /* dwSynchProtocols */
         0,               /* dwMechanical */
         /*0x00010042,    /* dwFeatures: Short APDU level exchanges */*/
-        CCID_FEATURES_AUTO_PCONF | CCID_FEATURES_AUTO_PNEGO | CCID_FEATURES_EXC_TPDU,
+        CCID_FEATURES_AUTO_PCONF | CCID_FEATURES_AUTO_PNEGO | CCID_FEATURES_EXC_APDU,
         0x0000010F,      /* dwMaxCCIDMessageLength: For extended APDU level the value shall be between 261 + 10 */
         0xFF,            /* bClassGetResponse: Echoes the class of the APDU */
         0xFF,            /* bClassEnvelope: Echoes the class of the APDU */
@@ -415,7 +508,7 @@ static const CCIDDriverConfigurationDescriptors sOtherSpeedConfigurationFS = {
         0,               /* dwSynchProtocols */
         0,               /* dwMechanical */
         /*0x00010042,    /* dwFeatures: Short APDU level exchanges */*/
-        CCID_FEATURES_AUTO_PCONF | CCID_FEATURES_AUTO_PNEGO | CCID_FEATURES_EXC_TPDU,
+        CCID_FEATURES_AUTO_PCONF | CCID_FEATURES_AUTO_PNEGO | CCID_FEATURES_EXC_APDU,
         0x0000010F,      /* dwMaxCCIDMessageLength: For extended APDU level the value shall be between 261 + 10 */
         0xFF,            /* bClassGetResponse: Echoes the class of the APDU */
         0xFF,            /* bClassEnvelope: Echoes the class of the APDU */
@@ -507,7 +600,7 @@ static const CCIDDriverConfigurationDescriptors sOtherSpeedConfigurationHS = {
         0,               /* dwSynchProtocols */
         0,               /* dwMechanical */
         /*0x00010042,      // dwFeatures: Short APDU level exchanges */
-        CCID_FEATURES_AUTO_PCONF | CCID_FEATURES_AUTO_PNEGO | CCID_FEATURES_EXC_TPDU,
+        CCID_FEATURES_AUTO_PCONF | CCID_FEATURES_AUTO_PNEGO | CCID_FEATURES_EXC_APDU,
         0x0000010F,      /* dwMaxCCIDMessageLength: For extended APDU level the value shall be between 261 + 10 */
         0xFF,            /* bClassGetResponse: Echoes the class of the APDU */
         0xFF,            /* bClassEnvelope: Echoes the class of the APDU */
@@ -660,6 +753,10 @@ const USBDDriverDescriptors ccidDriverDescriptors = {
  *      Internal functions
  *------------------------------------------------------------------------------*/
 
+static void vCCIDSendResponse( void );
+static void CCIDXfrReset( void );
+static void CCIDXfrCardDone( uint8_t bStatus, void *pArgument );
+
 /** 
  * Response Pipe, Bulk-IN Messages
  * Return the Slot Status to the host
@@ -925,16 +1022,16 @@ static void PCtoRDRIccPowerOn( void )
 
     if( CCID_FEATURES_AUTO_VOLT == (configurationDescriptorsFS.ccid.dwFeatures & CCID_FEATURES_AUTO_VOLT) ) {
 
-        /* bPowerSelect = ccidDriver.sCcidCommand.bSpecific_0; */
+        /* bPowerSelect = ccidDriver.pCommand->bSpecific_0; */
 
-        ccidDriver.sCcidCommand.bSpecific_0 = VOLTS_AUTO;
+        ccidDriver.pCommand->bSpecific_0 = VOLTS_AUTO;
     }
 
     ISO7816_cold_reset();
 
     /* for emulation only //JCB */
 
-    if ( ccidDriver.sCcidCommand.bSpecific_0 != VOLTS_5_0 ) {
+    if ( ccidDriver.pCommand->bSpecific_0 != VOLTS_5_0 ) {
 
         TRACE_ERROR("POWER_NOT_SUPPORTED\n\r");
     }
@@ -957,6 +1054,7 @@ static void PCtoRDRIccPowerOff( void )
 
     TRACE_DEBUG("PCtoRDRIccPowerOff\n\r");
 
+    CCIDXfrReset();
     ISO7816_IccPowerOff();
 
     /*JCB stub */
@@ -993,77 +1091,569 @@ static void PCtoRDRGetSlotStatus( void )
 }
 
 /**
- * Command Pipe, Bulk-OUT Messages
- * If the command header is valid, an APDU command is received and can be read
- * by the application
+ * Clears the XfrBlock exchange state, the ICC exchange being over.
  */
-static void PCtoRDRXfrBlock( void )
+static void CCIDXfrReset( void )
 {
-    unsigned char indexMessage = 0;
-    unsigned char i;
+    memset( &ccidDriver.sXfr, 0, sizeof(CCIDXfr) );
+}
 
-    /*TRACE_DEBUG("PCtoRDRXfrBlock\n\r"); */
+/**
+ * Sends a RDR_to_PC_DataBlock to the host.
+ * \param pData   Response data.
+ * \param wLength Response data length.
+ * \param bChain  bChainParameter of the message.
+ */
+static void CCIDXfrSendBlock( const unsigned char *pData,
+                              unsigned short wLength,
+                              unsigned char bChain )
+{
+    memcpy( ccidDriver.sCcidMessage.abData, pData, wLength );
+    ccidDriver.sCcidMessage.wLength = wLength;
+    ccidDriver.sCcidMessage.bSizeToSend = CCID_HEADER_SIZE;
+    RDRtoPCDatablock();
+    ccidDriver.sCcidMessage.bSpecific = bChain;
 
+    vCCIDSendResponse();
+}
 
-    i = 0;
+/**
+ * Sends a RDR_to_PC_DataBlock reporting a failed XfrBlock.
+ * \param bError Slot error (offset of the bad field, or error code).
+ */
+static void CCIDXfrSlotError( unsigned char bError )
+{
+    TRACE_DEBUG("XfrBlock error 0x%X\n\r", bError);
 
-    /* Check the block length */
+    ccidDriver.sCcidMessage.wLength = 0;
+    ccidDriver.sCcidMessage.bSizeToSend = CCID_HEADER_SIZE;
+    RDRtoPCDatablock();
+    ccidDriver.sCcidMessage.bStatus = ICC_CS_FAILED;
+    ccidDriver.sCcidMessage.bError  = bError;
 
-    if ( ccidDriver.sCcidCommand.wLength > (configurationDescriptorsFS.ccid.dwMaxCCIDMessageLength-10) ) {
+    vCCIDSendResponse();
+}
 
-        ccidDriver.sCcidMessage.bStatus = 1;
-        ccidDriver.sCcidMessage.bError  = 0;
+/**
+ * Starts a TPDU with the ICC, CCIDXfrCardDone() being invoked at its end.
+ * \param bState   XFR_xxx state of the exchange.
+ * \param pHeader  CLA INS P1 P2 P3 of the TPDU.
+ * \param bReceive 1 if P3 bytes are received from the ICC (0 means 256).
+ * \param pData    Data to send, or buffer for the received data.
+ */
+static void CCIDXfrStart( unsigned char bState,
+                          const unsigned char *pHeader,
+                          unsigned char bReceive,
+                          unsigned char *pData )
+{
+    CCIDXfr *pXfr = &ccidDriver.sXfr;
+    Iso7816Tpdu *pTpdu = &pXfr->sTpdu;
+
+    memcpy( pTpdu->abHeader, pHeader, 5 );
+    pTpdu->bReceive  = bReceive;
+    pTpdu->pData     = pData;
+    pTpdu->wLength   = pHeader[4];
+    if ( bReceive && (pHeader[4] == 0) ) {
+        pTpdu->wLength = 256;
     }
-    /* check bBWI */
+    pTpdu->fCallback = CCIDXfrCardDone;
+    pTpdu->pArgument = 0;
+    pXfr->bState = bState;
+    pXfr->bDone  = 0;
 
-    else if ( 0 != ccidDriver.sCcidCommand.bSpecific_0 ) {
+    ISO7816_XfrTPDU_T0_Start( pTpdu );
+}
 
-         TRACE_ERROR("Bad bBWI\n\r");
+/**
+ * Starts an ENVELOPE or GET RESPONSE TPDU.
+ * \param bState   XFR_ENVELOPE or XFR_GETRESPONSE.
+ * \param bCla     CLA from the class descriptor, 0xFF to echo the command one.
+ * \param bIns     INS of the TPDU.
+ * \param bP3      P3 of the TPDU.
+ * \param pData    Data to send, or buffer for the received data.
+ */
+static void CCIDXfrCommand( unsigned char bState,
+                            unsigned char bCla,
+                            unsigned char bIns,
+                            unsigned char bP3,
+                            unsigned char *pData )
+{
+    unsigned char abHeader[5];
+
+    abHeader[0] = (bCla == 0xFF) ? ccidDriver.sXfr.bCla : bCla;
+    abHeader[1] = bIns;
+    abHeader[2] = 0;
+    abHeader[3] = 0;
+    abHeader[4] = bP3;
+    CCIDXfrStart( bState, abHeader, (bState == XFR_GETRESPONSE), pData );
+}
+
+/**
+ * Fetches the next response data bytes announced by 61xx, as many as the
+ * host still accepts and the response block can hold.
+ */
+static void CCIDXfrGetResponse( void )
+{
+    CCIDXfr *pXfr = &ccidDriver.sXfr;
+    unsigned long dwLe = pXfr->bNext ? pXfr->bNext : 256;
+
+    dwLe = MIN( dwLe, pXfr->dwNe );
+    dwLe = MIN( dwLe, (unsigned long)(CCID_RSP_BLOCK - pXfr->wRsp) );
+    pXfr->bRetry = 0;
+    CCIDXfrCommand( XFR_GETRESPONSE,
+                    configurationDescriptorsFS.ccid.bClassGetResponse,
+                    ISO_INS_GETRESPONSE,
+                    (unsigned char)dwLe,
+                    &pXfr->abRsp[pXfr->wRsp] );
+}
+
+/**
+ * Sends the next part of the chained command block in an ENVELOPE TPDU.
+ */
+static void CCIDXfrEnvelope( void )
+{
+    CCIDXfr *pXfr = &ccidDriver.sXfr;
+    unsigned char bP3 = (unsigned char)MIN( pXfr->wChunk, 255 );
+    unsigned char *pData = pXfr->pChunk;
+
+    pXfr->pChunk += bP3;
+    pXfr->wChunk -= bP3;
+    CCIDXfrCommand( XFR_ENVELOPE,
+                    configurationDescriptorsFS.ccid.bClassEnvelope,
+                    ISO_INS_ENVELOPE,
+                    bP3,
+                    pData );
+}
+
+/**
+ * Completion of a TPDU with the ICC, invoked from the USART interrupt.
+ * Chains the next ENVELOPE, GET RESPONSE or 6Cxx retry TPDU, and sets bDone
+ * once nothing is left to exchange.
+ */
+static void CCIDXfrCardDone( uint8_t bStatus, void *pArgument )
+{
+    CCIDXfr *pXfr = &ccidDriver.sXfr;
+    Iso7816Tpdu *pTpdu = &pXfr->sTpdu;
+    unsigned char bSW1 = pTpdu->abSW[0];
+    unsigned char bSW2 = pTpdu->abSW[1];
+    unsigned char abHeader[5];
+
+    pArgument = pArgument;
+
+    if ( bStatus != ISO7816_STATUS_SUCCESS ) {
+
+        if ( bStatus == ISO7816_STATUS_TIMEOUT ) {
+            pXfr->bError = ICC_MUTE;
+        }
+        else if ( bStatus == ISO7816_STATUS_ABORTED ) {
+            pXfr->bError = CMD_ABORTED;
+        }
+        else {
+            pXfr->bError = XFR_PARITY_ERROR;
+        }
+        pXfr->bRspReady = 0;
+        pXfr->bState = XFR_IDLE;
+        pXfr->bDone = 1;
+        return;
+    }
+
+    if ( pTpdu->bReceive ) {
+        pXfr->wRsp += pTpdu->wTransferred;
+        pXfr->dwNe -= MIN( (unsigned long)pTpdu->wTransferred, pXfr->dwNe );
+    }
+
+    /* Intermediate ENVELOPE: go on until the ICC rejects a block */
+    if ( (pXfr->bState == XFR_ENVELOPE) && (pXfr->wChunk || !pXfr->bChunkLast) ) {
+
+        if ( (bSW1 != 0x90) || (bSW2 != 0x00) ) {
+            pXfr->bAborted = 1;
+            pXfr->abSW[0]  = bSW1;
+            pXfr->abSW[1]  = bSW2;
+        }
+        else if ( pXfr->wChunk ) {
+            CCIDXfrEnvelope();
+            return;
+        }
+        pXfr->bState = XFR_IDLE;
+        pXfr->bDone = 1;
+        return;
+    }
+
+    /* Wrong length: send the TPDU again with the length given by the ICC */
+    if ( (bSW1 == 0x6C) && pTpdu->bReceive && !pXfr->bRetry && !pXfr->bTpduLevel ) {
+
+        pXfr->bRetry = 1;
+        memcpy( abHeader, pTpdu->abHeader, 4 );
+        abHeader[4] = bSW2;
+        CCIDXfrStart( pXfr->bState, abHeader, 1, pTpdu->pData );
+        return;
+    }
+
+    /* Response data available: fetch it, if a block is left for it */
+    if ( (bSW1 == 0x61) && pXfr->dwNe && !pXfr->bTpduLevel ) {
+
+        pXfr->bNext = bSW2;
+        if ( pXfr->wRsp < CCID_RSP_BLOCK ) {
+
+            CCIDXfrGetResponse();
+            return;
+        }
+        pXfr->bRspLast = 0;
     }
     else {
 
-        /* APDU or TPDU */
+        pXfr->abRsp[pXfr->wRsp++] = bSW1;
+        pXfr->abRsp[pXfr->wRsp++] = bSW2;
+        pXfr->bRspLast = 1;
+    }
+    pXfr->bRspReady = 1;
+    pXfr->bState = XFR_IDLE;
+    pXfr->bDone = 1;
+}
 
-        switch(configurationDescriptorsFS.ccid.dwFeatures
-              & (CCID_FEATURES_EXC_TPDU|CCID_FEATURES_EXC_SAPDU|CCID_FEATURES_EXC_APDU)) {
+/**
+ * Sends the response block to the host, then fetches the next one from the
+ * ICC while the host reads this one.
+ * \return 1 if an ICC exchange has been started.
+ */
+static unsigned char CCIDXfrEmitBlock( void )
+{
+    CCIDXfr *pXfr = &ccidDriver.sXfr;
+    unsigned char bLast = pXfr->bRspLast;
+    unsigned char bChain;
 
-            case CCID_FEATURES_EXC_TPDU:
-                if (ccidDriver.ProtocolDataStructure[1] == PROTOCOL_TO) {
+    if ( bLast ) {
+        bChain = pXfr->bRspChain ? CCID_CHAIN_END : CCID_CHAIN_SINGLE;
+    }
+    else {
+        bChain = pXfr->bRspChain ? CCID_CHAIN_CONTINUE : CCID_CHAIN_BEGIN;
+    }
+    CCIDXfrSendBlock( pXfr->abRsp, pXfr->wRsp, bChain );
 
-                    /* Send commande APDU */
+    pXfr->bRspChain = !bLast;
+    pXfr->bRspReady = 0;
+    pXfr->wRsp = 0;
+    if ( !bLast ) {
 
-                    indexMessage = ISO7816_XfrBlockTPDU_T0( ccidDriver.sCcidCommand.APDU ,
-                                            ccidDriver.sCcidMessage.abData,
-                                            ccidDriver.sCcidCommand.wLength );
-                }
-                else {
-                    if (ccidDriver.ProtocolDataStructure[1] == PROTOCOL_T1) {
-                        TRACE_INFO("Not supported T=1\n\r");
-                    }
-                    else {
-                        TRACE_INFO("Not supported\n\r");
-                    }
-                }
-                break;
+        CCIDXfrGetResponse();
+        return 1;
+    }
+    return 0;
+}
 
-            case CCID_FEATURES_EXC_APDU:
-                TRACE_INFO("Not supported\n\r");
-                break;
+/**
+ * Answers the host once the ICC exchange has ended.
+ * \return 1 if an ICC exchange has been started.
+ */
+static unsigned char CCIDXfrComplete( void )
+{
+    CCIDXfr *pXfr = &ccidDriver.sXfr;
 
-            default:
-                break;
+    if ( !pXfr->bOwed ) {
+        return 0;
+    }
+    if ( pXfr->bError ) {
+
+        pXfr->bOwed = 0;
+        pXfr->bChaining = 0;
+        pXfr->bRspChain = 0;
+        CCIDXfrSlotError( pXfr->bError );
+        return 0;
+    }
+    if ( pXfr->bRspReady ) {
+
+        pXfr->bOwed = 0;
+        return CCIDXfrEmitBlock();
+    }
+    return 0;
+}
+
+/**
+ * XfrBlock at TPDU level: the message is a T=0 TPDU, the data and status
+ * words returned by the ICC are sent back as they are.
+ * \return 1 if an ICC exchange has been started.
+ */
+static unsigned char CCIDXfrTpdu( void )
+{
+    CCIDXfr *pXfr = &ccidDriver.sXfr;
+    unsigned char *pApdu = ccidDriver.pCommand->APDU;
+    unsigned long wLength = ccidDriver.pCommand->wLength;
+
+    if ( (wLength < 5) || ((wLength > 5) && (wLength != 5 + (unsigned long)pApdu[4])) ) {
+
+        CCIDXfrSlotError( 1 );
+        return 0;
+    }
+    CCIDXfrReset();
+    pXfr->bTpduLevel = 1;
+    pXfr->bOwed = 1;
+    pXfr->bCla = pApdu[0];
+    if ( wLength == 5 ) {
+        CCIDXfrStart( XFR_COMMAND, pApdu, 1, pXfr->abRsp );
+    }
+    else {
+        CCIDXfrStart( XFR_COMMAND, pApdu, 0, &pApdu[5] );
+    }
+    return 1;
+}
+
+/**
+ * XfrBlock at APDU level, command APDU held in one message (ISO 7816-3
+ * cases 1, 2S, 3S, 4S, 2E, and 3E, 4E with up to 255 data bytes).
+ * \return 1 if an ICC exchange has been started.
+ */
+static unsigned char CCIDXfrApdu( void )
+{
+    CCIDXfr *pXfr = &ccidDriver.sXfr;
+    unsigned char *pApdu = ccidDriver.pCommand->APDU;
+    unsigned long wLength = ccidDriver.pCommand->wLength;
+    unsigned long dwNc;
+    unsigned char abHeader[5];
+    unsigned char bReceive = 0;
+    unsigned char *pData = 0;
+
+    if ( wLength < 4 ) {
+
+        CCIDXfrSlotError( 1 );
+        return 0;
+    }
+    CCIDXfrReset();
+    pXfr->bCla = pApdu[0];
+    memcpy( abHeader, pApdu, 4 );
+    abHeader[4] = 0;
+
+    if ( wLength == 5 ) {
+        /* Case 2S */
+        abHeader[4] = pApdu[4];
+        pXfr->dwNe = pApdu[4] ? pApdu[4] : 256;
+        bReceive = 1;
+    }
+    else if ( (wLength > 5) && pApdu[4] ) {
+        /* Cases 3S, 4S */
+        dwNc = pApdu[4];
+        if ( wLength == 6 + dwNc ) {
+            pXfr->dwNe = pApdu[wLength-1] ? pApdu[wLength-1] : 256;
+        }
+        else if ( wLength != 5 + dwNc ) {
+            CCIDXfrSlotError( 1 );
+            return 0;
+        }
+        abHeader[4] = pApdu[4];
+        pData = &pApdu[5];
+    }
+    else if ( wLength == 7 ) {
+        /* Case 2E */
+        pXfr->dwNe = (pApdu[5] << 8) | pApdu[6];
+        if ( pXfr->dwNe == 0 ) {
+            pXfr->dwNe = 65536;
+        }
+        abHeader[4] = (pXfr->dwNe < 256) ? (unsigned char)pXfr->dwNe : 0;
+        bReceive = 1;
+    }
+    else if ( wLength > 7 ) {
+        /* Cases 3E, 4E */
+        dwNc = (pApdu[5] << 8) | pApdu[6];
+        if ( (dwNc == 0) || (dwNc > 255) ) {
+            CCIDXfrSlotError( 1 );
+            return 0;
+        }
+        if ( wLength == 9 + dwNc ) {
+            pXfr->dwNe = (pApdu[wLength-2] << 8) | pApdu[wLength-1];
+            if ( pXfr->dwNe == 0 ) {
+                pXfr->dwNe = 65536;
+            }
+        }
+        else if ( wLength != 7 + dwNc ) {
+            CCIDXfrSlotError( 1 );
+            return 0;
+        }
+        abHeader[4] = (unsigned char)dwNc;
+        pData = &pApdu[7];
+    }
+    else if ( wLength != 4 ) {
+        CCIDXfrSlotError( 1 );
+        return 0;
+    }
+
+    pXfr->bOwed = 1;
+    CCIDXfrStart( XFR_COMMAND, abHeader, bReceive, bReceive ? pXfr->abRsp : pData );
+    return 1;
+}
+
+/**
+ * XfrBlock at APDU level, block of a command APDU chained over several
+ * messages. The block is passed on to the ICC in ENVELOPE TPDUs and, but for
+ * the last one, acknowledged to the host at once so that the host sends the
+ * next block while the ICC receives this one.
+ * \param wLevel wLevelParameter of the message.
+ * \return 1 if an ICC exchange has been started.
+ */
+static unsigned char CCIDXfrChain( unsigned short wLevel )
+{
+    CCIDXfr *pXfr = &ccidDriver.sXfr;
+    unsigned char *pApdu = ccidDriver.pCommand->APDU;
+    unsigned long wLength = ccidDriver.pCommand->wLength;
+    unsigned long dwTotal;
+
+    if ( wLevel == CCID_LEVEL_BEGIN ) {
+
+        if ( wLength < 5 ) {
+
+            CCIDXfrSlotError( 1 );
+            return 0;
         }
+        CCIDXfrReset();
+        pXfr->bChaining = 1;
+        pXfr->bCla = pApdu[0];
+        pXfr->bExtended = (pApdu[4] == 0) && (wLength >= 7);
+        pXfr->dwNc = pXfr->bExtended ? ((pApdu[5] << 8) | pApdu[6]) : pApdu[4];
+    }
+    else if ( !pXfr->bChaining ) {
+
+        /* wLevelParameter out of sequence */
+        CCIDXfrSlotError( 8 );
+        return 0;
+    }
+
+    /* Keep the last two bytes, Le of the whole command APDU */
+    if ( wLength >= 2 ) {
+        pXfr->abTail[0] = pApdu[wLength-2];
+        pXfr->abTail[1] = pApdu[wLength-1];
+    }
+    else if ( wLength == 1 ) {
+        pXfr->abTail[0] = pXfr->abTail[1];
+        pXfr->abTail[1] = pApdu[0];
+    }
+    pXfr->dwStreamed += wLength;
+    pXfr->bChunkLast = (wLevel == CCID_LEVEL_END);
+
+    if ( pXfr->bChunkLast ) {
+
+        /* Ne from the Le field, if any, of the whole command APDU */
+        dwTotal = pXfr->dwStreamed;
+        pXfr->dwNe = 65536;
+        if ( !pXfr->bExtended ) {
+            if ( dwTotal == 5 + pXfr->dwNc ) {
+                pXfr->dwNe = 0;
+            }
+            else if ( dwTotal == 6 + pXfr->dwNc ) {
+                pXfr->dwNe = pXfr->abTail[1] ? pXfr->abTail[1] : 256;
+            }
+        }
+        else if ( dwTotal == 7 + pXfr->dwNc ) {
+            pXfr->dwNe = 0;
+        }
+        else if ( (dwTotal == 9 + pXfr->dwNc) || (dwTotal == 7) ) {
+            pXfr->dwNe = (pXfr->abTail[0] << 8) | pXfr->abTail[1];
+            if ( pXfr->dwNe == 0 ) {
+                pXfr->dwNe = 65536;
+            }
+        }
+        pXfr->bChaining = 0;
+        pXfr->bOwed = 1;
+    }
+
+    /* A block has been rejected: drop the others, report the status words */
+    if ( pXfr->bAborted ) {
+
+        if ( pXfr->bChunkLast ) {
+
+            pXfr->abRsp[0] = pXfr->abSW[0];
+            pXfr->abRsp[1] = pXfr->abSW[1];
+            pXfr->wRsp = 2;
+            pXfr->bRspLast = 1;
+            pXfr->bRspReady = 1;
+            return CCIDXfrComplete();
+        }
+        CCIDXfrSendBlock( 0, 0, CCID_CHAIN_COMMAND );
+        return 0;
+    }
+
+    pXfr->pChunk = pApdu;
+    pXfr->wChunk = (unsigned short)wLength;
+    CCIDXfrEnvelope();
+
+    if ( !pXfr->bChunkLast ) {
+        CCIDXfrSendBlock( 0, 0, CCID_CHAIN_COMMAND );
+    }
+    return 1;
+}
+
+/**
+ * Command Pipe, Bulk-OUT Messages
+ * If the command header is valid, the APDU or TPDU is exchanged with the ICC.
+ * The exchange goes on under the USART interrupt, the response being sent
+ * once it has ended.
+ * \return 1 if an ICC exchange has been started.
+ */
+static unsigned char PCtoRDRXfrBlock( void )
+{
+    unsigned short wLevel = ccidDriver.pCommand->bSpecific_1
+                          | (ccidDriver.pCommand->bSpecific_2 << 8);
+
+    /*TRACE_DEBUG("PCtoRDRXfrBlock\n\r"); */
+
+
+    /* Check the block length */
 
+    if ( ccidDriver.pCommand->wLength > (configurationDescriptorsFS.ccid.dwMaxCCIDMessageLength-10) ) {
+
+        CCIDXfrSlotError( 1 );
+        return 0;
+    }
+
+    /* check bBWI, only meaningful for T=1 */
+
+    if ( 0 != ccidDriver.pCommand->bSpecific_0 ) {
+
+         TRACE_ERROR("Bad bBWI\n\r");
+    }
+
+    if (ccidDriver.ProtocolDataStructure[1] != PROTOCOL_TO) {
+
+        TRACE_INFO("Not supported T=1\n\r");
+        CCIDXfrSlotError( ICC_PROTOCOL_NOT_SUPPORTED );
+        return 0;
     }
 
-    ccidDriver.sCcidMessage.wLength = indexMessage;
-    TRACE_DEBUG("USB: 0x%X, 0x%X, 0x%X, 0x%X, 0x%X\n\r", ccidDriver.sCcidMessage.abData[0],
-                                                                    ccidDriver.sCcidMessage.abData[1],
-                                                                    ccidDriver.sCcidMessage.abData[2],
-                                                                    ccidDriver.sCcidMessage.abData[3],
-                                                                    ccidDriver.sCcidMessage.abData[4] );
-     RDRtoPCDatablock();
+    /* APDU or TPDU */
+
+    switch(configurationDescriptorsFS.ccid.dwFeatures
+          & (CCID_FEATURES_EXC_TPDU|CCID_FEATURES_EXC_SAPDU|CCID_FEATURES_EXC_APDU)) {
+
+        case CCID_FEATURES_EXC_TPDU:
+            return CCIDXfrTpdu();
+
+        case CCID_FEATURES_EXC_APDU:
+            switch ( wLevel ) {
+
+                case CCID_LEVEL_SINGLE:
+                    return CCIDXfrApdu();
+
+                case CCID_LEVEL_BEGIN:
+                case CCID_LEVEL_CONTINUE:
+                case CCID_LEVEL_END:
+                    return CCIDXfrChain( wLevel );
 
+                case CCID_LEVEL_RESPONSE:
+                    /* Next block of a chained response */
+                    if ( ccidDriver.sXfr.bRspReady && ccidDriver.sXfr.bRspChain ) {
+                        return CCIDXfrEmitBlock();
+                    }
+                    CCIDXfrSlotError( ccidDriver.sXfr.bError ? ccidDriver.sXfr.bError : 8 );
+                    return 0;
+
+                default:
+                    CCIDXfrSlotError( 8 );
+                    return 0;
+            }
+
+        default:
+            /* Command not supported */
+            TRACE_INFO("Not supported\n\r");
+            CCIDXfrSlotError( 0 );
+            return 0;
+    }
 }
 
 /**
@@ -1115,7 +1705,7 @@ static void PCtoRDRSetParameters( void )
 {
     TRACE_DEBUG("PCtoRDRSetParameters\n\r");
 
-    ccidDriver.SlotStatus = ccidDriver.sCcidCommand.bSlot;
+    ccidDriver.SlotStatus = ccidDriver.pCommand->bSlot;
     ccidDriver.sCcidMessage.bStatus = ccidDriver.SlotStatus;
     /* Not all feature supported */
 
@@ -1139,7 +1729,7 @@ static void PCtoRDREscape( void )
 
     /* stub, return all value send */
 
-    RDRtoPCEscape( ccidDriver.sCcidCommand.wLength, ccidDriver.sCcidCommand.APDU);
+    RDRtoPCEscape( ccidDriver.pCommand->wLength, ccidDriver.pCommand->APDU);
 }
 
 /**
@@ -1150,7 +1740,7 @@ static void PCtoRDRICCClock( void )
 {
     TRACE_DEBUG("PCtoRDRICCClock\n\r");
 
-    if( 0 == ccidDriver.sCcidCommand.bSpecific_0 ) {
+    if( 0 == ccidDriver.pCommand->bSpecific_0 ) {
         /* restarts the clock */
 
         ISO7816_RestartClock();
@@ -1179,9 +1769,9 @@ static void PCtoRDRtoAPDU( void )
 
     if( configurationDescriptorsFS.ccid.dwFeatures == (CCID_FEATURES_EXC_SAPDU|CCID_FEATURES_EXC_APDU) ) {
 
-        bmChanges = ccidDriver.sCcidCommand.bSpecific_0;
-        bClassGetResponse = ccidDriver.sCcidCommand.bSpecific_1;
-        bClassEnvelope = ccidDriver.sCcidCommand.bSpecific_2;
+        bmChanges = ccidDriver.pCommand->bSpecific_0;
+        bClassGetResponse = ccidDriver.pCommand->bSpecific_1;
+        bClassEnvelope = ccidDriver.pCommand->bSpecific_2;
 
         ISO7816_toAPDU();
     }
@@ -1227,6 +1817,7 @@ static void PCtoRDRAbort( void )
 {
     TRACE_DEBUG("PCtoRDRAbort\n\r");
 
+    CCIDXfrReset();
     RDRtoPCSlotStatus();
 }
 
@@ -1242,15 +1833,15 @@ static void PCtoRDRSetDataRateAndClockFrequency( void )
 
     TRACE_DEBUG("PCtoRDRSetDatarateandClockFrequency\n\r");
 
-    dwClockFrequency = ccidDriver.sCcidCommand.APDU[0]
-                     + (ccidDriver.sCcidCommand.APDU[1]<<8)
-                     + (ccidDriver.sCcidCommand.APDU[2]<<16)
-                     + (ccidDriver.sCcidCommand.APDU[3]<<24);
+    dwClockFrequency = ccidDriver.pCommand->APDU[0]
+                     + (ccidDriver.pCommand->APDU[1]<<8)
+                     + (ccidDriver.pCommand->APDU[2]<<16)
+                     + (ccidDriver.pCommand->APDU[3]<<24);
 
-    dwDataRate = ccidDriver.sCcidCommand.APDU[4]
-               + (ccidDriver.sCcidCommand.APDU[5]<<8)
-               + (ccidDriver.sCcidCommand.APDU[6]<<16)
-               + (ccidDriver.sCcidCommand.APDU[7]<<24);
+    dwDataRate = ccidDriver.pCommand->APDU[4]
+               + (ccidDriver.pCommand->APDU[5]<<8)
+               + (ccidDriver.pCommand->APDU[6]<<16)
+               + (ccidDriver.pCommand->APDU[7]<<24);
 
     ISO7816_SetDataRateandClockFrequency( dwClockFrequency, dwDataRate );
 
@@ -1301,48 +1892,50 @@ static void vCCIDSendResponse( void )
 
 /**
  *  Description: CCID Command dispatcher
+ *  \return 1 if an ICC exchange goes on, the slot being busy until it ends.
  */
-static void CCIDCommandDispatcher( void )
+static unsigned char CCIDCommandDispatcher( void )
 {
     unsigned char MessageToSend = 0;
+    unsigned char bBusy = 0;
 
     /*TRACE_DEBUG("Command: 0x%X 0x%x 0x%X 0x%X 0x%X 0x%X 0x%X\n\r\n\r", */
 
-    /*               (unsigned int)ccidDriver.sCcidCommand.bMessageType, */
+    /*               (unsigned int)ccidDriver.pCommand->bMessageType, */
 
-    /*               (unsigned int)ccidDriver.sCcidCommand.wLength, */
+    /*               (unsigned int)ccidDriver.pCommand->wLength, */
 
-    /*               (unsigned int)ccidDriver.sCcidCommand.bSlot, */
+    /*               (unsigned int)ccidDriver.pCommand->bSlot, */
 
-    /*               (unsigned int)ccidDriver.sCcidCommand.bSeq, */
+    /*               (unsigned int)ccidDriver.pCommand->bSeq, */
 
-    /*               (unsigned int)ccidDriver.sCcidCommand.bSpecific_0, */
+    /*               (unsigned int)ccidDriver.pCommand->bSpecific_0, */
 
-    /*               (unsigned int)ccidDriver.sCcidCommand.bSpecific_1, */
+    /*               (unsigned int)ccidDriver.pCommand->bSpecific_1, */
 
-    /*               (unsigned int)ccidDriver.sCcidCommand.bSpecific_2); */
+    /*               (unsigned int)ccidDriver.pCommand->bSpecific_2); */
 
 
     /* Check the slot number */
 
-    if ( ccidDriver.sCcidCommand.bSlot > 0 ) {
+    if ( ccidDriver.pCommand->bSlot > 0 ) {
 
         TRACE_ERROR("BAD_SLOT_NUMBER\n\r");
     }
 
-    TRACE_DEBUG("typ=0x%X\n\r", ccidDriver.sCcidCommand.bMessageType);
+    TRACE_DEBUG("typ=0x%X\n\r", ccidDriver.pCommand->bMessageType);
 
     ccidDriver.sCcidMessage.bStatus = 0;
 
-    ccidDriver.sCcidMessage.bSeq  = ccidDriver.sCcidCommand.bSeq;
-    ccidDriver.sCcidMessage.bSlot = ccidDriver.sCcidCommand.bSlot;
+    ccidDriver.sCcidMessage.bSeq  = ccidDriver.pCommand->bSeq;
+    ccidDriver.sCcidMessage.bSlot = ccidDriver.pCommand->bSlot;
 
-    ccidDriver.sCcidMessage.bSizeToSend = sizeof(S_ccid_bulk_in_header)-(ABDATA_SIZE+1);
+    ccidDriver.sCcidMessage.bSizeToSend = CCID_HEADER_SIZE;
 
 
     /* Command dispatcher */
 
-    switch ( ccidDriver.sCcidCommand.bMessageType ) {
+    switch ( ccidDriver.pCommand->bMessageType ) {
 
         case PC_TO_RDR_ICCPOWERON:
             PCtoRDRIccPowerOn();
@@ -1360,8 +1953,7 @@ static void CCIDCommandDispatcher( void )
             break;
 
         case PC_TO_RDR_XFRBLOCK:
-            PCtoRDRXfrBlock();
-            MessageToSend = 1;
+            bBusy = PCtoRDRXfrBlock();
             break;
 
         case PC_TO_RDR_GETPARAMETERS:
@@ -1431,7 +2023,7 @@ static void CCIDCommandDispatcher( void )
             break;
 
         default:
-            TRACE_DEBUG("default: 0x%X\n\r", ccidDriver.sCcidCommand.bMessageType);
+            TRACE_DEBUG("default: 0x%X\n\r", ccidDriver.pCommand->bMessageType);
             vCCIDCommandNotSupported();
             MessageToSend = 1;
             break;
@@ -1441,6 +2033,74 @@ static void CCIDCommandDispatcher( void )
     if( MessageToSend == 1 ) {
         vCCIDSendResponse();
     }
+    return bBusy;
+}
+
+/**
+ * Dispatches the command received while the slot was busy, if any, and
+ * frees the slot once no ICC exchange goes on.
+ */
+static void CCIDReleaseSlot( void )
+{
+    S_ccid_bulk_out_header *pCommand;
+
+    while ( 1 ) {
+
+        __disable_irq();
+        pCommand = ccidDriver.pPending;
+        ccidDriver.pPending = 0;
+        if ( pCommand == 0 ) {
+            ccidDriver.bBusy = 0;
+        }
+        __enable_irq();
+
+        if ( pCommand == 0 ) {
+            return;
+        }
+        ccidDriver.pCommand = pCommand;
+        if ( CCIDCommandDispatcher() ) {
+            return;
+        }
+    }
+}
+
+/**
+ * Bulk-OUT command received: dispatches it, or keeps it for later if the
+ * slot is still busy with the previous command.
+ */
+static void CCIDCommandReceived( void *pArg,
+                                 unsigned char status,
+                                 unsigned int transferred,
+                                 unsigned int remaining )
+{
+    S_ccid_bulk_out_header *pCommand = &ccidDriver.asCcidCommand[ccidDriver.bCommandIn];
+    unsigned char bBusy;
+
+    pArg = pArg; transferred = transferred; remaining = remaining;
+
+    ccidDriver.bReading = 0;
+    if ( status != USBD_STATUS_SUCCESS ) {
+        return;
+    }
+    ccidDriver.bCommandIn ^= 1;
+
+    __disable_irq();
+    bBusy = ccidDriver.bBusy;
+    if ( bBusy ) {
+        ccidDriver.pPending = pCommand;
+    }
+    else {
+        ccidDriver.bBusy = 1;
+    }
+    __enable_irq();
+
+    if ( bBusy ) {
+        return;
+    }
+    ccidDriver.pCommand = pCommand;
+    if ( CCIDCommandDispatcher() == 0 ) {
+        CCIDReleaseSlot();
+    }
 }
 
 
@@ -1462,6 +2122,7 @@ static void CCID_RequestHandler(const USBGenericRequest *pRequest)
 
             case CCIDGenericRequest_ABORT:
                 TRACE_DEBUG("CCIDGenericRequest_ABORT\n\r");
+                ISO7816_XfrAbort();
                 break;
 
             case CCIDGenericRequest_GET_CLOCK_FREQUENCIES:
@@ -1522,21 +2183,31 @@ void USBDCallbacks_RequestReceived(const USBGenericRequest *request)
 
 
 /**
- * Handles SmartCart request
+ * Handles SmartCart request, to be called from the main loop: answers the
+ * host once the ICC exchange has ended, and reads the next command into the
+ * free command buffer. The next command is thus received while the ICC
+ * exchange of the previous one goes on.
  */
 void CCID_SmartCardRequest( void )
 {
-    unsigned char bStatus;
+    if ( ccidDriver.sXfr.bDone ) {
 
-    do {
-
-        bStatus = CCID_Read( (void*)&ccidDriver.sCcidCommand,
-                             sizeof(S_ccid_bulk_out_header),
-                             (TransferCallback)&CCIDCommandDispatcher,
-                             (void*)0 );
+        ccidDriver.sXfr.bDone = 0;
+        if ( CCIDXfrComplete() == 0 ) {
+            CCIDReleaseSlot();
+        }
     }
-    while (bStatus != USBD_STATUS_SUCCESS);
 
+    if ( ccidDriver.bReading || ccidDriver.pPending ) {
+        return;
+    }
+    ccidDriver.bReading = 1;
+    if ( CCID_Read( (void*)&ccidDriver.asCcidCommand[ccidDriver.bCommandIn],
+                    sizeof(S_ccid_bulk_out_header),
+                    (TransferCallback)CCIDCommandReceived,
+                    (void*)0 ) != USBD_STATUS_SUCCESS ) {
+        ccidDriver.bReading = 0;
+    }
 }
 
 /**
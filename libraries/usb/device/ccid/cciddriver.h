@@ -56,7 +56,7 @@
 /** for a TPDU T=1 block is 259 bytes, or */
 /** for a short APDU T=1 block is 261 bytes, or */
 /** for an extended APDU T=1 block is 65544 bytes. */
-#define ABDATA_SIZE 260
+#define ABDATA_SIZE 261
 
 /** define protocol T=0 */
 #define PROTOCOL_TO 0
@@ -99,6 +99,30 @@
 /** USB Wake up signaling supported on card insertion and removal */
 #define CCID_FEATURES_WAKEUP     0x00100000
 
+/** wLevelParameter of PC_to_RDR_XfrBlock, extended APDU level (6.1.4) */
+/** The command APDU begins and ends with this command */
+#define CCID_LEVEL_SINGLE        0x0000
+/** The command APDU begins with this command, and continue in the next */
+#define CCID_LEVEL_BEGIN         0x0001
+/** abData field continues a command APDU and ends the APDU command */
+#define CCID_LEVEL_END           0x0002
+/** abData field continues a command APDU and another block is to follow */
+#define CCID_LEVEL_CONTINUE      0x0003
+/** Empty abData field, continuation of response APDU is expected */
+#define CCID_LEVEL_RESPONSE      0x0010
+
+/** bChainParameter of RDR_to_PC_DataBlock, extended APDU level (6.2.1) */
+/** Response APDU begins and ends in this command */
+#define CCID_CHAIN_SINGLE        0x00
+/** Response APDU begins with this command and is to continue */
+#define CCID_CHAIN_BEGIN         0x01
+/** abData field continues the response APDU and ends the response APDU */
+#define CCID_CHAIN_END           0x02
+/** abData field continues the response APDU and another block is to follow */
+#define CCID_CHAIN_CONTINUE      0x03
+/** Empty abData field, continuation of the command APDU is expected */
+#define CCID_CHAIN_COMMAND       0x10
+
 /*------------------------------------------------------------------------------ 
 
  *         Types                                                                
@@ -126,7 +150,7 @@ typedef struct _S_ccid_bulk_in_header
    unsigned char bSpecific;
    /** Data block sent to the CCID. */
    unsigned char abData[ABDATA_SIZE];
-   unsigned char bSizeToSend;
+   unsigned short bSizeToSend;
 } __attribute__ ((packed)) S_ccid_bulk_in_header;
 
 /**
@@ -0,0 +1,981 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2008, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**\file
+ *  Implementation of the CDCDNcm class methods.
+ */
+
+/** \addtogroup usbd_cdc
+ *@{
+ */
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include "board.h"
+
+#include <CDCDNcm.h>
+#include <USBLib_Trace.h>
+#include <USBD_HAL.h>
+
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** OUT NTB buffer states */
+#define NTB_FREE        0
+#define NTB_READING     1
+#define NTB_FULL        2
+#define NTB_DRAINED     3
+
+/** Maximum number of chained NDPs walked in a received NTB */
+#define NTB_MAX_NDPS    4
+
+/** Notifications waiting to be sent */
+#define NOTIFY_SPEED        (1 << 0)
+#define NOTIFY_CONNECTION   (1 << 1)
+
+/** Rounds up an NTB offset to the datagram alignment (4 bytes) */
+#define NTB_ALIGN(x)    (((x) + 3) & ~3)
+
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+/** Parse data extention for descriptor parsing  */
+typedef struct _CDCDNcmParseData {
+    /** Pointer to CDCDNcm instance */
+    CDCDNcm * pNcm;
+    /** Pointer to found interface descriptor */
+    USBInterfaceDescriptor * pIfDesc;
+
+} CDCDNcmParseData;
+
+/*------------------------------------------------------------------------------
+ *         Internal variables
+ *------------------------------------------------------------------------------*/
+
+/** NTB parameters returned to GetNtbParameters */
+static const CDCNcmNtbParameters ntbParameters = {
+    sizeof(CDCNcmNtbParameters),
+    CDCNcmNtbFormat_16BIT,
+    CDCDNcm_NTB_IN_SIZE,
+    4, 0, 4,
+    0,
+    CDCDNcm_NTB_OUT_SIZE,
+    4, 0, 4,
+    0
+};
+
+/** Data stage of the class requests */
+static uint32_t adwRequestData[2];
+
+/*------------------------------------------------------------------------------
+ *         Internal functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * Parse descriptors: Interface, Bulk IN/OUT, Interrupt IN.
+ * \param desc Pointer to descriptor list.
+ * \param arg  Argument, pointer to CDCDNcmParseData instance.
+ */
+static uint32_t _Interfaces_Parse(USBGenericDescriptor *pDesc,
+                                  CDCDNcmParseData * pArg)
+{
+    CDCDNcm *pNcm = pArg->pNcm;
+
+    /* Not a valid descriptor */
+    if (pDesc->bLength == 0)
+        return USBRC_PARAM_ERR;
+
+    /* Find interface descriptor */
+    if (pDesc->bDescriptorType == USBGenericDescriptor_INTERFACE) {
+        USBInterfaceDescriptor *pIf = (USBInterfaceDescriptor*)pDesc;
+
+        /* Obtain interface from descriptor */
+        if (pNcm->bInterfaceNdx == 0xFF) {
+            /* First interface is the NCM communication one */
+            if (pIf->bInterfaceClass ==
+                    CDCCommunicationInterfaceDescriptor_CLASS
+                && pIf->bInterfaceSubClass == CDCNcm_SUBCLASS) {
+                pNcm->bInterfaceNdx = pIf->bInterfaceNumber;
+                pNcm->bNumInterface = 2;
+                pArg->pIfDesc = pIf;
+            }
+        }
+        else if (pNcm->bInterfaceNdx <= pIf->bInterfaceNumber
+            &&   pNcm->bInterfaceNdx + pNcm->bNumInterface
+                                       > pIf->bInterfaceNumber) {
+            pArg->pIfDesc = pIf;
+        }
+        else {
+            pArg->pIfDesc = 0;
+        }
+    }
+
+    /* Parse valid interfaces */
+    if (pArg->pIfDesc == 0)
+        return 0;
+
+    /* Find endpoint descriptors */
+    if (pDesc->bDescriptorType == USBGenericDescriptor_ENDPOINT) {
+        USBEndpointDescriptor *pEp = (USBEndpointDescriptor*)pDesc;
+        switch(pEp->bmAttributes & 0x3) {
+            case USBEndpointDescriptor_INTERRUPT:
+                if (pEp->bEndpointAddress & 0x80)
+                    pNcm->bIntInPIPE = pEp->bEndpointAddress & 0x7F;
+                break;
+            case USBEndpointDescriptor_BULK:
+                if (pEp->bEndpointAddress & 0x80) {
+                    pNcm->bBulkInPIPE = pEp->bEndpointAddress & 0x7F;
+                    pNcm->wMaxPacketIn =
+                        USBEndpointDescriptor_GetMaxPacketSize(pEp);
+                }
+                else
+                    pNcm->bBulkOutPIPE = pEp->bEndpointAddress;
+        }
+    }
+
+    if (    pNcm->bInterfaceNdx != 0xFF
+        &&  pNcm->bIntInPIPE != 0
+        &&  pNcm->bBulkInPIPE != 0
+        &&  pNcm->bBulkOutPIPE != 0)
+        return USBRC_FINISHED;
+
+    return 0;
+}
+
+/**
+ * Empties all the NTB buffers. The bulk endpoints must be idle.
+ * \param pNcm Pointer to CDCDNcm instance.
+ */
+static void _ResetBuffers(CDCDNcm *pNcm)
+{
+    uint8_t i;
+
+    for (i = 0; i < 2; i ++) {
+
+        pNcm->aOut[i].bState   = NTB_FREE;
+        pNcm->aOut[i].bPending = 0;
+        pNcm->aIn[i].bCount    = 0;
+        pNcm->aIn[i].wLength   = sizeof(CDCNcmNth16);
+    }
+    pNcm->bOutRead     = 0;
+    pNcm->bOutParse    = 0;
+    pNcm->bOutRelease  = 0;
+    pNcm->bInFill      = 0;
+    pNcm->bInBusy      = 0;
+    pNcm->bInAllocated = 0;
+}
+
+/**
+ * Sends the next waiting notification on the interrupt endpoint.
+ * \param pNcm Pointer to CDCDNcm instance.
+ */
+static void _NotifyNext(CDCDNcm *pNcm);
+
+/**
+ * Callback invoked when a notification has been sent.
+ * \param pNcm Pointer to CDCDNcm instance.
+ */
+static void _NotifyCallback(CDCDNcm *pNcm)
+{
+    pNcm->bNotifyBusy = 0;
+    _NotifyNext(pNcm);
+}
+
+static void _NotifyNext(CDCDNcm *pNcm)
+{
+    uint8_t *pNotification = pNcm->abNotification;
+    uint32_t dwLength = 8;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (pNcm->bIntInPIPE == 0 || pNcm->bNotifyBusy
+        || pNcm->bNotifyPending == 0) {
+
+        __set_PRIMASK(primask);
+        return;
+    }
+
+    pNotification[0] = 0xA1;
+    pNotification[3] = 0;
+    pNotification[4] = pNcm->bInterfaceNdx;
+    pNotification[5] = 0;
+    pNotification[7] = 0;
+    if (pNcm->bNotifyPending & NOTIFY_SPEED) {
+
+        pNcm->bNotifyPending &= ~NOTIFY_SPEED;
+        pNotification[1] = CDCNcmNotification_CONNECTIONSPEEDCHANGE;
+        pNotification[2] = 0;
+        pNotification[6] = 8;
+        /* Same downstream and upstream bit rates */
+        pNotification[8]  = pNotification[12] = pNcm->dwLinkSpeed;
+        pNotification[9]  = pNotification[13] = pNcm->dwLinkSpeed >> 8;
+        pNotification[10] = pNotification[14] = pNcm->dwLinkSpeed >> 16;
+        pNotification[11] = pNotification[15] = pNcm->dwLinkSpeed >> 24;
+        dwLength = 16;
+    }
+    else {
+
+        pNcm->bNotifyPending &= ~NOTIFY_CONNECTION;
+        pNotification[1] = CDCNcmNotification_NETWORKCONNECTION;
+        pNotification[2] = pNcm->bDataAlt;
+        pNotification[6] = 0;
+    }
+
+    pNcm->bNotifyBusy = 1;
+    if (USBD_Write(pNcm->bIntInPIPE, pNotification, dwLength,
+                   (TransferCallback)_NotifyCallback, pNcm)
+            != USBD_STATUS_SUCCESS) {
+
+        pNcm->bNotifyBusy = 0;
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * Callback invoked when an NTB has been received on the bulk OUT endpoint.
+ * \param pNcm         Pointer to CDCDNcm instance.
+ * \param status       Transfer status.
+ * \param transferred  Number of bytes received.
+ * \param remaining    Number of bytes not received.
+ */
+static void _ReadCallback(CDCDNcm *pNcm,
+                          uint8_t status,
+                          uint32_t transferred,
+                          uint32_t remaining);
+
+/**
+ * Arms the bulk OUT endpoint with the next OUT NTB buffer, if free.
+ * \param pNcm Pointer to CDCDNcm instance.
+ */
+static void _StartRead(CDCDNcm *pNcm)
+{
+    CDCDNcmOutNtb *pNtb;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    pNtb = &pNcm->aOut[pNcm->bOutRead];
+    if (pNcm->bDataAlt && pNtb->bState == NTB_FREE) {
+
+        pNtb->bState = NTB_READING;
+        if (USBD_Read(pNcm->bBulkOutPIPE,
+                      pNtb->adwData, CDCDNcm_NTB_OUT_SIZE,
+                      (TransferCallback)_ReadCallback, pNcm)
+                != USBD_STATUS_SUCCESS) {
+
+            pNtb->bState = NTB_FREE;
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * Moves the parser of a received NTB to a new NDP, 0 ending the NTB.
+ * \param pNtb  Pointer to the received NTB buffer.
+ * \param wNdp  Offset of the NDP.
+ */
+static void _EnterNdp(CDCDNcmOutNtb *pNtb, uint16_t wNdp)
+{
+    const CDCNcmNdp16 *pNdp = (const CDCNcmNdp16*)
+                                ((uint8_t*)pNtb->adwData + wNdp);
+
+    if (wNdp < sizeof(CDCNcmNth16) || (wNdp & 3)
+        || wNdp + sizeof(CDCNcmNdp16) + 4 > pNtb->wLength
+        || pNdp->dwSignature != CDCNcmNdp16_SIGNATURE
+        || pNdp->wLength < sizeof(CDCNcmNdp16) + 4
+        || wNdp + pNdp->wLength > pNtb->wLength
+        || pNtb->bNdps >= NTB_MAX_NDPS) {
+
+        pNtb->wNdp = 0;
+        return;
+    }
+
+    pNtb->bNdps ++;
+    pNtb->wNdp   = wNdp;
+    pNtb->wEntry = wNdp + 8;
+}
+
+/**
+ * Checks the NCM Transfer Header of a received NTB and points the buffer
+ * parser at its first NDP.
+ * \param pNtb        Pointer to the received NTB buffer.
+ * \param dwReceived  Number of bytes received.
+ * \return 1 if the NTB can be parsed, otherwise 0.
+ */
+static uint8_t _CheckNtb(CDCDNcmOutNtb *pNtb, uint32_t dwReceived)
+{
+    const CDCNcmNth16 *pNth = (const CDCNcmNth16*)pNtb->adwData;
+
+    if (dwReceived < sizeof(CDCNcmNth16)
+        || pNth->dwSignature != CDCNcmNth16_SIGNATURE
+        || pNth->wHeaderLength != sizeof(CDCNcmNth16)
+        || pNth->wBlockLength > dwReceived)
+        return 0;
+
+    pNtb->wLength = pNth->wBlockLength ? pNth->wBlockLength
+                                       : (uint16_t)dwReceived;
+    pNtb->bNdps   = 0;
+    _EnterNdp(pNtb, pNth->wNdpIndex);
+
+    return 1;
+}
+
+/**
+ * Finds the next datagram of a received NTB.
+ * \param pNtb       Pointer to the received NTB buffer.
+ * \param pwOffset   Pointer to the datagram offset in the NTB.
+ * \return Datagram length, 0 if the NTB holds no more datagram.
+ */
+static uint32_t _NextDatagram(CDCDNcmOutNtb *pNtb, uint16_t *pwOffset)
+{
+    uint8_t *pData = (uint8_t*)pNtb->adwData;
+    const CDCNcmNdp16 *pNdp;
+    uint16_t wIndex, wLength;
+
+    while (pNtb->wNdp) {
+
+        pNdp = (const CDCNcmNdp16*)(pData + pNtb->wNdp);
+        if (pNtb->wEntry + 4 > pNtb->wNdp + pNdp->wLength) {
+
+            _EnterNdp(pNtb, pNdp->wNextNdpIndex);
+            continue;
+        }
+
+        wIndex  = *(uint16_t*)(pData + pNtb->wEntry);
+        wLength = *(uint16_t*)(pData + pNtb->wEntry + 2);
+        pNtb->wEntry += 4;
+
+        /* Null pair: go on with the next NDP */
+        if (wIndex == 0 || wLength == 0) {
+
+            _EnterNdp(pNtb, pNdp->wNextNdpIndex);
+            continue;
+        }
+
+        /* Datagram outside the NTB: drop the rest of the NTB */
+        if (wIndex < sizeof(CDCNcmNth16)
+            || (uint32_t)wIndex + wLength > pNtb->wLength) {
+
+            pNtb->wNdp = 0;
+            break;
+        }
+
+        *pwOffset = wIndex;
+        return wLength;
+    }
+
+    return 0;
+}
+
+/**
+ * Frees the oldest OUT NTB buffers once all their datagrams are released,
+ * and re-arms the bulk OUT endpoint.
+ * \param pNcm Pointer to CDCDNcm instance.
+ */
+static void _CollectOut(CDCDNcm *pNcm)
+{
+    CDCDNcmOutNtb *pNtb = &pNcm->aOut[pNcm->bOutRelease];
+
+    while (pNtb->bState == NTB_DRAINED && pNtb->bPending == 0) {
+
+        pNtb->bState = NTB_FREE;
+        pNcm->bOutRelease ^= 1;
+        pNtb = &pNcm->aOut[pNcm->bOutRelease];
+    }
+    _StartRead(pNcm);
+}
+
+static void _ReadCallback(CDCDNcm *pNcm,
+                          uint8_t status,
+                          uint32_t transferred,
+                          uint32_t remaining)
+{
+    CDCDNcmOutNtb *pNtb = &pNcm->aOut[pNcm->bOutRead];
+
+    if (status != USBD_STATUS_SUCCESS) {
+
+        pNtb->bState = NTB_FREE;
+        return;
+    }
+
+    if (!_CheckNtb(pNtb, transferred)) {
+
+        TRACE_INFO_WP("BadNtb ");
+        pNcm->dwRxErrors ++;
+        pNtb->bState = NTB_FREE;
+        _StartRead(pNcm);
+        return;
+    }
+
+    pNcm->dwRxNtbs ++;
+    pNtb->bState = NTB_FULL;
+    pNcm->bOutRead ^= 1;
+    _StartRead(pNcm);
+
+    if (pNcm->fEventHandler)
+        pNcm->fEventHandler(CDCDNcmEvent_FRAMERECEIVED, transferred,
+                            pNcm->pArg);
+}
+
+/**
+ * Returns the room left for a datagram in an IN NTB buffer.
+ * \param pNcm Pointer to CDCDNcm instance.
+ * \param pNtb Pointer to the IN NTB buffer.
+ */
+static uint32_t _InRoom(const CDCDNcm *pNcm, const CDCDNcmInNtb *pNtb)
+{
+    uint32_t dwLimit = pNcm->dwNtbInMaxSize;
+    uint32_t dwUsed;
+
+    if (pNtb->bCount >= CDCDNcm_NTB_IN_DATAGRAMS)
+        return 0;
+
+    /* Datagram, NDP realignment, NDP header, new pair and null pair */
+    dwUsed = NTB_ALIGN(pNtb->wLength) + 3 + 8 + 4 * (pNtb->bCount + 2);
+
+    return (dwUsed < dwLimit) ? (dwLimit - dwUsed) : 0;
+}
+
+/**
+ * Callback invoked when an NTB has been sent on the bulk IN endpoint.
+ * \param pNcm         Pointer to CDCDNcm instance.
+ * \param status       Transfer status.
+ * \param transferred  Number of bytes sent.
+ * \param remaining    Number of bytes not sent.
+ */
+static void _WriteCallback(CDCDNcm *pNcm,
+                           uint8_t status,
+                           uint32_t transferred,
+                           uint32_t remaining);
+
+/**
+ * Completes the IN NTB being filled with its NDP and sends it, if the bulk
+ * IN endpoint is idle and no frame is being written in the NTB.
+ * \param pNcm Pointer to CDCDNcm instance.
+ */
+static void _SendNtb(CDCDNcm *pNcm)
+{
+    CDCDNcmInNtb *pNtb;
+    CDCNcmNth16  *pNth;
+    uint16_t     *pNdp;
+    uint32_t dwNdp, dwLength;
+    uint8_t i;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    pNtb = &pNcm->aIn[pNcm->bInFill];
+    if (!pNcm->bDataAlt || pNcm->bInBusy || pNcm->bInAllocated
+        || pNtb->bCount == 0) {
+
+        __set_PRIMASK(primask);
+        return;
+    }
+
+    /* NDP after the last datagram */
+    dwNdp = NTB_ALIGN(pNtb->wLength);
+    pNdp = (uint16_t*)((uint8_t*)pNtb->adwData + dwNdp);
+    *(uint32_t*)pNdp = CDCNcmNdp16_SIGNATURE;
+    pNdp[2] = 8 + 4 * (pNtb->bCount + 1);
+    pNdp[3] = 0;
+    for (i = 0; i < pNtb->bCount; i ++) {
+
+        pNdp[4 + 2 * i] = pNtb->awDatagram[i][0];
+        pNdp[5 + 2 * i] = pNtb->awDatagram[i][1];
+    }
+    pNdp[4 + 2 * i] = 0;
+    pNdp[5 + 2 * i] = 0;
+    dwLength = dwNdp + pNdp[2];
+
+    /* Pad one byte rather than ending the transfer with a ZLP */
+    if ((dwLength % pNcm->wMaxPacketIn) == 0
+        && dwLength < pNcm->dwNtbInMaxSize)
+        dwLength ++;
+
+    pNth = (CDCNcmNth16*)pNtb->adwData;
+    pNth->dwSignature   = CDCNcmNth16_SIGNATURE;
+    pNth->wHeaderLength = sizeof(CDCNcmNth16);
+    pNth->wSequence     = pNcm->wInSequence ++;
+    pNth->wBlockLength  = dwLength;
+    pNth->wNdpIndex     = dwNdp;
+
+    pNcm->bInBusy = 1;
+    pNcm->bInFill ^= 1;
+    pNcm->aIn[pNcm->bInFill].bCount  = 0;
+    pNcm->aIn[pNcm->bInFill].wLength = sizeof(CDCNcmNth16);
+
+    if (USBD_Write(pNcm->bBulkInPIPE, pNtb->adwData, dwLength,
+                   (TransferCallback)_WriteCallback, pNcm)
+            != USBD_STATUS_SUCCESS) {
+
+        pNcm->bInBusy = 0;
+    }
+    else
+        pNcm->dwTxFrames += pNtb->bCount;
+    __set_PRIMASK(primask);
+}
+
+static void _WriteCallback(CDCDNcm *pNcm,
+                           uint8_t status,
+                           uint32_t transferred,
+                           uint32_t remaining)
+{
+    pNcm->bInBusy = 0;
+    if (status != USBD_STATUS_SUCCESS)
+        return;
+
+    pNcm->dwTxNtbs ++;
+    _SendNtb(pNcm);
+
+    if (pNcm->fEventHandler)
+        pNcm->fEventHandler(CDCDNcmEvent_FRAMESENT, transferred,
+                            pNcm->pArg);
+}
+
+/**
+ * Callback invoked when the data of a SetNtbInputSize request has been
+ * received.
+ * \param pNcm Pointer to CDCDNcm instance.
+ */
+static void _SetNtbInputSizeCallback(CDCDNcm *pNcm)
+{
+    uint32_t dwSize = adwRequestData[0];
+
+    /* NCM 1.0 requires at least 2048 bytes */
+    if (dwSize < 2048) {
+
+        USBD_Stall(0);
+        return;
+    }
+
+    pNcm->dwNtbInMaxSize = (dwSize < CDCDNcm_NTB_IN_SIZE) ?
+                            dwSize : CDCDNcm_NTB_IN_SIZE;
+    USBD_Write(0, 0, 0, 0, 0);
+}
+
+/**
+ * Sends the data stage of a class request, cut to the host length.
+ * \param pData    Pointer to the data.
+ * \param dwLength Data length in bytes.
+ * \param request  Pointer to a USBGenericRequest instance.
+ */
+static void _WriteRequestData(const void *pData, uint32_t dwLength,
+                              const USBGenericRequest *request)
+{
+    if (dwLength > USBGenericRequest_GetLength(request))
+        dwLength = USBGenericRequest_GetLength(request);
+
+    USBD_Write(0, pData, dwLength, 0, 0);
+}
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * Initializes the USB Device CDC NCM function.
+ * \param pNcm  Pointer to CDCDNcm instance.
+ * \param pUsbd Pointer to USBDDriver instance.
+ * \param fEventHandler Pointer to event handler function.
+ * \param pArg  Argument of the event handler.
+ * \param firstInterface First interface index for the function
+ *                       (0xFF to parse from descriptors).
+ * \param numInterface   Number of interfaces for the function.
+ */
+void CDCDNcm_Initialize(CDCDNcm * pNcm,
+                        USBDDriver * pUsbd,
+                        CDCDNcmEventHandler fEventHandler,
+                        void * pArg,
+                        uint8_t firstInterface,uint8_t numInterface)
+{
+    TRACE_INFO("CDCDNcm_Initialize\n\r");
+
+    /* Initialize event handler */
+    pNcm->fEventHandler = fEventHandler;
+    pNcm->pArg = pArg;
+
+    /* Initialize USB Device Driver interface */
+    pNcm->pUsbd = pUsbd;
+    pNcm->bInterfaceNdx = firstInterface;
+    pNcm->bNumInterface = numInterface;
+    pNcm->bIntInPIPE    = 0;
+    pNcm->bBulkInPIPE   = 0;
+    pNcm->bBulkOutPIPE  = 0;
+    pNcm->wMaxPacketIn  = CDCDNcm_BULK_MAXPACKETSIZE_FS;
+
+    /* Initialize network attributes */
+    pNcm->bDataAlt       = 0;
+    pNcm->wPacketFilter  = 0;
+    pNcm->dwNtbInMaxSize = CDCDNcm_NTB_IN_SIZE;
+    pNcm->dwLinkSpeed    = 12000000;
+    pNcm->bNotifyPending = 0;
+    pNcm->bNotifyBusy    = 0;
+    pNcm->wInSequence    = 0;
+
+    pNcm->dwRxFrames = 0;
+    pNcm->dwRxNtbs   = 0;
+    pNcm->dwRxErrors = 0;
+    pNcm->dwTxFrames = 0;
+    pNcm->dwTxNtbs   = 0;
+
+    _ResetBuffers(pNcm);
+}
+
+/**
+ * Parse CDC NCM information for CDCDNcm instance.
+ * Accepted interfaces: NCM Communication Interface + Data Interface.
+ * \param pNcm         Pointer to CDCDNcm instance.
+ * \param pDescriptors Pointer to descriptor list.
+ * \param dwLength     Descriptor list size in bytes.
+ */
+USBGenericDescriptor *CDCDNcm_ParseInterfaces(
+    CDCDNcm *pNcm,
+    USBGenericDescriptor *pDescriptors,
+    uint32_t dwLength)
+{
+    CDCDNcmParseData parseData;
+
+    parseData.pNcm    = pNcm;
+    parseData.pIfDesc = 0;
+
+    return USBGenericDescriptor_Parse(
+                    pDescriptors, dwLength,
+                    (USBDescriptorParseFunction)_Interfaces_Parse,
+                    &parseData);
+}
+
+/**
+ * Sets the CDC NCM interfaces and endpoints from a function map resolved
+ * with the descriptors, instead of parsing them.
+ * \param pNcm Pointer to CDCDNcm instance.
+ * \param pMap Pointer to the function map of the network function.
+ */
+void CDCDNcm_MapInterfaces(CDCDNcm *pNcm,
+                           const USBDFunctionMap *pMap)
+{
+    pNcm->bInterfaceNdx = pMap->bInterface;
+    pNcm->bNumInterface = pMap->bNumInterfaces;
+    pNcm->bIntInPIPE    = pMap->bEpAux;
+    pNcm->bBulkInPIPE   = pMap->bEpIn;
+    pNcm->bBulkOutPIPE  = pMap->bEpOut;
+    pNcm->wMaxPacketIn  = pMap->wMaxPacketIn;
+}
+
+/**
+ * Handles CDC NCM SETUP requests. Should be called from a
+ * re-implementation of USBDCallbacks_RequestReceived() method.
+ * \param pNcm Pointer to CDCDNcm instance.
+ * \param request Pointer to a USBGenericRequest instance.
+ * \return USBRC_SUCCESS if request handled, otherwise error.
+ */
+uint32_t CDCDNcm_RequestHandler(
+    CDCDNcm *pNcm,
+    const USBGenericRequest *request)
+{
+    if (USBGenericRequest_GetType(request) != USBGenericRequest_CLASS)
+        return USBRC_PARAM_ERR;
+
+    TRACE_INFO_WP("Ncm ");
+
+    /* Validate interface */
+    if (request->wIndex >= pNcm->bInterfaceNdx &&
+        request->wIndex < pNcm->bInterfaceNdx + pNcm->bNumInterface) {
+    }
+    else {
+        return USBRC_PARAM_ERR;
+    }
+
+    /* Handle the request */
+    switch (USBGenericRequest_GetRequest(request)) {
+
+        case CDCNcmRequest_GETNTBPARAMETERS:
+
+            _WriteRequestData(&ntbParameters, sizeof(ntbParameters), request);
+            break;
+
+        case CDCNcmRequest_GETNTBFORMAT:
+
+            /* Only the 16-bit format is supported */
+            adwRequestData[0] = 0;
+            _WriteRequestData(adwRequestData, 2, request);
+            break;
+
+        case CDCNcmRequest_SETNTBFORMAT:
+
+            if (request->wValue != 0)
+                USBD_Stall(0);
+            else
+                USBD_Write(0, 0, 0, 0, 0);
+            break;
+
+        case CDCNcmRequest_GETNTBINPUTSIZE:
+
+            adwRequestData[0] = pNcm->dwNtbInMaxSize;
+            _WriteRequestData(adwRequestData, 4, request);
+            break;
+
+        case CDCNcmRequest_SETNTBINPUTSIZE:
+
+            if (USBGenericRequest_GetLength(request) < 4
+                || USBGenericRequest_GetLength(request) > 8) {
+
+                USBD_Stall(0);
+                break;
+            }
+            USBD_Read(0, adwRequestData,
+                      USBGenericRequest_GetLength(request),
+                      (TransferCallback)_SetNtbInputSizeCallback,
+                      (void*)pNcm);
+            break;
+
+        case CDCNcmRequest_GETMAXDATAGRAMSIZE:
+
+            adwRequestData[0] = CDCDNcm_MAX_DATAGRAM_SIZE;
+            _WriteRequestData(adwRequestData, 2, request);
+            break;
+
+        case CDCNcmRequest_SETETHERNETPACKETFILTER:
+
+            pNcm->wPacketFilter = request->wValue;
+            USBD_Write(0, 0, 0, 0, 0);
+            if (pNcm->fEventHandler)
+                pNcm->fEventHandler(CDCDNcmEvent_PACKETFILTER,
+                                    pNcm->wPacketFilter, pNcm->pArg);
+            break;
+
+        default:
+
+            return USBRC_PARAM_ERR;
+    }
+
+    return USBRC_SUCCESS;
+}
+
+/**
+ * Handles a change of the data interface alternate setting: setting 1
+ * starts the network link, setting 0 stops it and drops the queued frames.
+ * Should be called from a re-implementation of
+ * USBDDriverCallbacks_InterfaceSettingChanged(), and with setting 0 when the
+ * configuration changes.
+ * \param pNcm       Pointer to CDCDNcm instance.
+ * \param bInterface Interface number.
+ * \param bSetting   New alternate setting.
+ */
+void CDCDNcm_InterfaceSettingChanged(CDCDNcm *pNcm,
+                                     uint8_t bInterface, uint8_t bSetting)
+{
+    if (bInterface != pNcm->bInterfaceNdx + 1
+        || (bSetting != 0) == pNcm->bDataAlt)
+        return;
+
+    if (bSetting) {
+
+        TRACE_INFO_WP("NcmUp ");
+        _ResetBuffers(pNcm);
+        pNcm->wInSequence = 0;
+        pNcm->bDataAlt = 1;
+        _StartRead(pNcm);
+        pNcm->bNotifyPending = NOTIFY_SPEED | NOTIFY_CONNECTION;
+        _NotifyNext(pNcm);
+
+        if (pNcm->fEventHandler)
+            pNcm->fEventHandler(CDCDNcmEvent_CONNECTED, 0, pNcm->pArg);
+    }
+    else {
+
+        TRACE_INFO_WP("NcmDown ");
+        pNcm->bDataAlt = 0;
+        USBD_HAL_ResetEPs((1 << pNcm->bBulkInPIPE)
+                          | (1 << pNcm->bBulkOutPIPE),
+                          USBRC_CANCELED, 1);
+        _ResetBuffers(pNcm);
+        pNcm->bNotifyPending = NOTIFY_CONNECTION;
+        _NotifyNext(pNcm);
+
+        if (pNcm->fEventHandler)
+            pNcm->fEventHandler(CDCDNcmEvent_DISCONNECTED, 0, pNcm->pArg);
+    }
+}
+
+/**
+ * Sets the link speed reported to the host, and notifies the host of it
+ * when the link is up.
+ * \param pNcm    Pointer to CDCDNcm instance.
+ * \param dwSpeed Link speed in bits per second.
+ */
+void CDCDNcm_SetLinkSpeed(CDCDNcm *pNcm, uint32_t dwSpeed)
+{
+    pNcm->dwLinkSpeed = dwSpeed;
+    if (pNcm->bDataAlt) {
+
+        pNcm->bNotifyPending |= NOTIFY_SPEED;
+        _NotifyNext(pNcm);
+    }
+}
+
+/**
+ * Returns 1 when the host has started the network link.
+ * \param pNcm Pointer to CDCDNcm instance.
+ */
+uint8_t CDCDNcm_IsConnected(const CDCDNcm *pNcm)
+{
+    return pNcm->bDataAlt;
+}
+
+/**
+ * Takes the next frame received from the host. The frame stays in the NTB
+ * buffer until it is given back with CDCDNcm_ReleaseFrame(); several frames
+ * may be held, they are released in the order they were taken.
+ * \param pNcm    Pointer to CDCDNcm instance.
+ * \param ppFrame Pointer to the frame pointer to set.
+ * \return Frame length in bytes, 0 if no frame is waiting.
+ */
+uint32_t CDCDNcm_GetFrame(CDCDNcm *pNcm, uint8_t **ppFrame)
+{
+    CDCDNcmOutNtb *pNtb;
+    uint16_t wOffset;
+    uint32_t dwLength;
+
+    for (;;) {
+
+        pNtb = &pNcm->aOut[pNcm->bOutParse];
+        if (pNtb->bState != NTB_FULL)
+            return 0;
+
+        dwLength = _NextDatagram(pNtb, &wOffset);
+        if (dwLength) {
+
+            pNtb->bPending ++;
+            pNcm->dwRxFrames ++;
+            *ppFrame = (uint8_t*)pNtb->adwData + wOffset;
+            return dwLength;
+        }
+
+        /* NTB parsed, go on with the next one */
+        pNtb->bState = NTB_DRAINED;
+        pNcm->bOutParse ^= 1;
+        _CollectOut(pNcm);
+    }
+}
+
+/**
+ * Gives back the oldest frame taken with CDCDNcm_GetFrame(). An NTB buffer
+ * is re-armed for reception once all its frames are given back.
+ * \param pNcm Pointer to CDCDNcm instance.
+ */
+void CDCDNcm_ReleaseFrame(CDCDNcm *pNcm)
+{
+    CDCDNcmOutNtb *pNtb = &pNcm->aOut[pNcm->bOutRelease];
+
+    if (pNtb->bPending == 0)
+        return;
+
+    pNtb->bPending --;
+    _CollectOut(pNcm);
+}
+
+/**
+ * Reserves room for a frame to send in the NTB being filled. The frame is
+ * written in place, then queued with CDCDNcm_SendFrame() or dropped with
+ * CDCDNcm_CancelFrame(); only one frame can be reserved at a time.
+ * \param pNcm     Pointer to CDCDNcm instance.
+ * \param dwLength Maximum frame length in bytes.
+ * \return Pointer to the frame room, 0 if the link is down or no room is left
+ *         until the current NTB transfer ends.
+ */
+uint8_t * CDCDNcm_AllocFrame(CDCDNcm *pNcm, uint32_t dwLength)
+{
+    CDCDNcmInNtb *pNtb;
+    uint8_t *pFrame = 0;
+    uint32_t primask;
+
+    if (!pNcm->bDataAlt || pNcm->bInAllocated
+        || dwLength > CDCDNcm_MAX_DATAGRAM_SIZE)
+        return 0;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    pNtb = &pNcm->aIn[pNcm->bInFill];
+    if (_InRoom(pNcm, pNtb) < dwLength) {
+
+        /* Full NTB: send it if the endpoint is idle */
+        _SendNtb(pNcm);
+        pNtb = &pNcm->aIn[pNcm->bInFill];
+    }
+    if (_InRoom(pNcm, pNtb) >= dwLength) {
+
+        pNcm->bInAllocated = 1;
+        pFrame = (uint8_t*)pNtb->adwData + NTB_ALIGN(pNtb->wLength);
+    }
+    __set_PRIMASK(primask);
+
+    return pFrame;
+}
+
+/**
+ * Queues the frame written in the room given by CDCDNcm_AllocFrame(). The
+ * NTB is sent at once if the bulk IN endpoint is idle.
+ * \param pNcm     Pointer to CDCDNcm instance.
+ * \param dwLength Frame length in bytes, at most the reserved length.
+ */
+void CDCDNcm_SendFrame(CDCDNcm *pNcm, uint32_t dwLength)
+{
+    CDCDNcmInNtb *pNtb;
+    uint16_t wOffset;
+    uint32_t primask;
+
+    if (!pNcm->bInAllocated)
+        return;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    pNtb = &pNcm->aIn[pNcm->bInFill];
+    wOffset = NTB_ALIGN(pNtb->wLength);
+    pNtb->awDatagram[pNtb->bCount][0] = wOffset;
+    pNtb->awDatagram[pNtb->bCount][1] = dwLength;
+    pNtb->bCount ++;
+    pNtb->wLength = wOffset + dwLength;
+    pNcm->bInAllocated = 0;
+    _SendNtb(pNcm);
+    __set_PRIMASK(primask);
+}
+
+/**
+ * Drops the room reserved by CDCDNcm_AllocFrame().
+ * \param pNcm Pointer to CDCDNcm instance.
+ */
+void CDCDNcm_CancelFrame(CDCDNcm *pNcm)
+{
+    pNcm->bInAllocated = 0;
+    _SendNtb(pNcm);
+}
+
+/**@}*/
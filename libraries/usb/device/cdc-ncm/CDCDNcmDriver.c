@@ -0,0 +1,142 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2008, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**\file
+ *   Title: CDCDNcmDriver implementation
+ *
+ *   About: Purpose
+ *       Implementation of the CDCDNcmDriver class methods.
+ */
+
+/** \addtogroup usbd_cdc
+ *@{
+ */
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include "CDCDNcmDriver.h"
+
+#include <USBLib_Trace.h>
+#include <USBDDriver.h>
+#include <USBD_HAL.h>
+
+/*------------------------------------------------------------------------------
+ *         Internal variables
+ *------------------------------------------------------------------------------*/
+
+/** NCM function instance */
+static CDCDNcm cdcdNcm;
+
+/** Current alternate settings of the interfaces */
+static uint8_t bAltInterfaces[2];
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ *  Initializes the USB Device CDC NCM driver & USBD Driver.
+ *  \param  pDescriptors  Pointer to Descriptors list for CDC NCM Device.
+ *  \param  fEventHandler Pointer to network event handler function.
+ *  \param  pArg          Argument of the event handler.
+ */
+void CDCDNcmDriver_Initialize(const USBDDriverDescriptors *pDescriptors,
+                              CDCDNcmEventHandler fEventHandler,
+                              void *pArg)
+{
+    USBDDriver *pUsbd = USBD_GetDriver();
+
+    /* Initialize the standard driver, the data interface has two settings */
+    USBDDriver_Initialize(pUsbd,
+                          pDescriptors,
+                          bAltInterfaces);
+
+    CDCDNcm_Initialize(&cdcdNcm, pUsbd, fEventHandler, pArg,
+                       CDCDNcmDriver_CC_INTERFACE, 2);
+
+    /* Initialize the USB driver */
+    USBD_Init();
+}
+
+/**
+ * Invoked whenever the active configuration of device is changed by the
+ * host. The data interface goes back to its setting 0.
+ * \param cfgnum Configuration number.
+ */
+void CDCDNcmDriver_ConfigurationChangedHandler(uint8_t cfgnum)
+{
+    USBDDriver *pUsbd = USBD_GetDriver();
+    USBConfigurationDescriptor *pDesc;
+
+    bAltInterfaces[CDCDNcmDriver_DC_INTERFACE] = 0;
+    CDCDNcm_InterfaceSettingChanged(&cdcdNcm, CDCDNcmDriver_DC_INTERFACE, 0);
+
+    if (cfgnum) {
+        pDesc = USBDDriver_GetCfgDescriptors(pUsbd, cfgnum);
+        CDCDNcm_ParseInterfaces(&cdcdNcm,
+                                (USBGenericDescriptor *)pDesc,
+                                pDesc->wTotalLength);
+    }
+}
+
+/**
+ * Invoked whenever the host changes the alternate setting of an interface.
+ * \param interface Interface number.
+ * \param setting   New alternate setting.
+ */
+void CDCDNcmDriver_InterfaceSettingChangedHandler(uint8_t interface,
+                                                  uint8_t setting)
+{
+    CDCDNcm_InterfaceSettingChanged(&cdcdNcm, interface, setting);
+}
+
+/**
+ * Handles CDC NCM SETUP requests. Should be called from a
+ * re-implementation of USBDCallbacks_RequestReceived() method.
+ * \param request Pointer to a USBGenericRequest instance.
+ */
+void CDCDNcmDriver_RequestHandler(const USBGenericRequest *request)
+{
+    USBDDriver *pUsbd = USBD_GetDriver();
+    TRACE_INFO_WP("NewReq ");
+    if (CDCDNcm_RequestHandler(&cdcdNcm, request))
+        USBDDriver_RequestHandler(pUsbd, request);
+}
+
+/**
+ * Returns the NCM function instance, for the frame functions.
+ */
+CDCDNcm * CDCDNcmDriver_GetFunction(void)
+{
+    return &cdcdNcm;
+}
+
+/**@}*/
@@ -134,6 +134,17 @@ void CDCDSerial_ConfigureFunction(USBGenericDescriptor *pDescriptors,
                                    wLength);
 }
 
+/**
+ * Invoked whenever the device is changed by the host, for a composite
+ * device giving the function map instead of the descriptors.
+ * \pMap Pointer to the function map of the CDC serial function.
+ */
+void CDCDSerial_ConfigureFunctionMap(const USBDFunctionMap *pMap)
+{
+    CDCDSerialPort *pCdcd = &cdcdSerial;
+    CDCDSerialPort_MapInterfaces(pCdcd, pMap);
+}
+
 /**
  * Handles CDC-specific SETUP requests. Should be called from a
  * re-implementation of USBDCallbacks_RequestReceived() method.
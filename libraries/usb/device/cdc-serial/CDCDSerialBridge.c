@@ -0,0 +1,540 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2008, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**\file
+ * Zero-copy bridge between a CDC serial port function and an USART.
+ *
+ * A pool of buffers is shared by the USB bulk endpoints and the USART PDC
+ * channels; a buffer is handed from one to the other by ownership, never
+ * copied:
+ * - host to USART: free -> bulk OUT read -> USART PDC transmit -> free.
+ * - USART to host: free -> USART PDC receive -> bulk IN write -> free.
+ * The pool is the bridge own one, or one shared with other drivers (see
+ * CDCDSerialBridge_SetBufferPool()); the bridge holds no buffer once stopped.
+ *
+ * Both PDC channels use their current and next banks. A received buffer is
+ * sent to the host when it is full or when the USART receiver time-out
+ * expires. Flow control comes from the buffer ownership: when no buffer is
+ * free, the bulk OUT endpoint is not re-armed (the host is NAKed) and the
+ * USART receiver stops, an overrun then being reported in the serial state.
+ */
+
+/** \addtogroup usbd_cdc
+ *@{
+ */
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include "CDCDSerialBridge.h"
+
+#include <USBLib_Trace.h>
+#include <USBD.h>
+#include <CDCNotifications.h>
+
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+/** Bridge buffer */
+typedef struct _CDCDBridgeBuffer {
+    /** Next buffer in its queue */
+    struct _CDCDBridgeBuffer *pNext;
+    /** Number of valid bytes */
+    uint32_t dwSize;
+    /** Data */
+    uint8_t pData[CDCDBRIDGE_BUFFERSIZE];
+} CDCDBridgeBuffer;
+
+/** FIFO of buffers */
+typedef struct _CDCDBridgeQueue {
+    CDCDBridgeBuffer *pHead;
+    CDCDBridgeBuffer *pTail;
+} CDCDBridgeQueue;
+
+/** Bridge state */
+typedef struct _CDCDSerialBridge {
+    /** Serial port function */
+    CDCDSerialPort *pCdcd;
+    /** USART peripheral */
+    Usart *pUsart;
+    /** Receiver time-out in bit periods */
+    uint32_t dwRxTimeout;
+    /** Pool of the free buffers (see MEMPOOL) */
+    MemPool *pPool;
+    /** Buffers received from the host, waiting for the USART */
+    CDCDBridgeQueue txQueue;
+    /** Buffers received from the USART, waiting for the host */
+    CDCDBridgeQueue inQueue;
+    /** Buffers in the USART PDC transmit banks (current first) */
+    CDCDBridgeBuffer *pTxBanks[2];
+    /** Buffers in the USART PDC receive banks (current first) */
+    CDCDBridgeBuffer *pRxBanks[2];
+    /** Bulk OUT read in progress */
+    CDCDBridgeBuffer *pUsbRead;
+    /** Bulk IN write in progress */
+    CDCDBridgeBuffer *pUsbWrite;
+    /** Number of buffers in the transmit banks */
+    uint8_t bTxCount;
+    /** Number of buffers in the receive banks */
+    uint8_t bRxCount;
+    /** Bridge running */
+    uint8_t bStarted;
+} CDCDSerialBridge;
+
+/*------------------------------------------------------------------------------
+ *         Internal variables
+ *------------------------------------------------------------------------------*/
+
+/** Bridge instance */
+static CDCDSerialBridge cdcdBridge;
+
+#if CDCDBRIDGE_NUMBUFFERS > 0
+/** Storage of the bridge own buffer pool */
+static uint32_t bridgeStorage[MEMPOOL_STORAGE_WORDS(sizeof(CDCDBridgeBuffer),
+                                                    CDCDBRIDGE_NUMBUFFERS)];
+
+/** Bridge own buffer pool, used unless another one is given */
+static MemPool bridgePool;
+#endif
+
+/*------------------------------------------------------------------------------
+ *         Internal functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * Appends a buffer to a queue. Called with the interrupts disabled.
+ */
+static void BridgeQueue_Put(CDCDBridgeQueue *pQueue, CDCDBridgeBuffer *pBuffer)
+{
+    pBuffer->pNext = 0;
+    if (pQueue->pTail)
+        pQueue->pTail->pNext = pBuffer;
+    else
+        pQueue->pHead = pBuffer;
+    pQueue->pTail = pBuffer;
+}
+
+/**
+ * Removes the first buffer of a queue, 0 if empty. Called with the
+ * interrupts disabled.
+ */
+static CDCDBridgeBuffer *BridgeQueue_Get(CDCDBridgeQueue *pQueue)
+{
+    CDCDBridgeBuffer *pBuffer = pQueue->pHead;
+
+    if (pBuffer) {
+        pQueue->pHead = pBuffer->pNext;
+        if (pQueue->pHead == 0)
+            pQueue->pTail = 0;
+    }
+    return pBuffer;
+}
+
+static void BridgeUsbReadCallback(void *pArg, uint8_t bStatus,
+                                  uint32_t dwTransferred,
+                                  uint32_t dwRemaining);
+static void BridgeUsbWriteCallback(void *pArg, uint8_t bStatus,
+                                   uint32_t dwTransferred,
+                                   uint32_t dwRemaining);
+
+/**
+ * Arms the bulk OUT endpoint with a free buffer.
+ */
+static void BridgeStartUsbRead(CDCDSerialBridge *pBridge)
+{
+    CDCDBridgeBuffer *pBuffer;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (pBridge->bStarted && pBridge->pUsbRead == 0) {
+
+        pBuffer = (CDCDBridgeBuffer*)MEMPOOL_Alloc(pBridge->pPool);
+        if (pBuffer) {
+
+            pBridge->pUsbRead = pBuffer;
+            if (CDCDSerialPort_Read(pBridge->pCdcd,
+                                    pBuffer->pData, CDCDBRIDGE_BUFFERSIZE,
+                                    BridgeUsbReadCallback, pBuffer)
+                    != USBD_STATUS_SUCCESS) {
+
+                pBridge->pUsbRead = 0;
+                MEMPOOL_Free(pBridge->pPool, pBuffer);
+            }
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * Sends the first buffer received from the USART to the host.
+ */
+static void BridgeStartUsbWrite(CDCDSerialBridge *pBridge)
+{
+    CDCDBridgeBuffer *pBuffer;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (pBridge->bStarted && pBridge->pUsbWrite == 0) {
+
+        pBuffer = BridgeQueue_Get(&pBridge->inQueue);
+        if (pBuffer) {
+
+            pBridge->pUsbWrite = pBuffer;
+            if (CDCDSerialPort_Write(pBridge->pCdcd,
+                                     pBuffer->pData, pBuffer->dwSize,
+                                     BridgeUsbWriteCallback, pBuffer)
+                    != USBD_STATUS_SUCCESS) {
+
+                /* Not configured: the data is dropped */
+                pBridge->pUsbWrite = 0;
+                MEMPOOL_Free(pBridge->pPool, pBuffer);
+            }
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * Fills the free USART PDC transmit banks with the buffers received from
+ * the host.
+ */
+static void BridgeStartUsartTx(CDCDSerialBridge *pBridge)
+{
+    Usart *pUsart = pBridge->pUsart;
+    CDCDBridgeBuffer *pBuffer;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    while (pBridge->bStarted && pBridge->bTxCount < 2) {
+
+        pBuffer = BridgeQueue_Get(&pBridge->txQueue);
+        if (pBuffer == 0)
+            break;
+        USART_WriteBuffer(pUsart, pBuffer->pData, pBuffer->dwSize);
+        pBridge->pTxBanks[pBridge->bTxCount++] = pBuffer;
+    }
+    if (pBridge->bTxCount)
+        USART_EnableIt(pUsart, US_IER_ENDTX);
+    __set_PRIMASK(primask);
+}
+
+/**
+ * Fills the free USART PDC receive banks with free buffers.
+ */
+static void BridgeStartUsartRx(CDCDSerialBridge *pBridge)
+{
+    Usart *pUsart = pBridge->pUsart;
+    CDCDBridgeBuffer *pBuffer;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    while (pBridge->bStarted && pBridge->bRxCount < 2) {
+
+        pBuffer = (CDCDBridgeBuffer*)MEMPOOL_Alloc(pBridge->pPool);
+        if (pBuffer == 0)
+            break;
+
+        /* Restarting a stalled receiver: report the lost characters */
+        if (pBridge->bRxCount == 0 && (pUsart->US_CSR & US_CSR_OVRE)) {
+
+            pUsart->US_CR = US_CR_RSTSTA;
+            CDCDSerialPort_SetSerialState(pBridge->pCdcd,
+                CDCDSerialPort_GetSerialState(pBridge->pCdcd)
+                | CDCSerialState_OVERRUN);
+        }
+        USART_ReadBuffer(pUsart, pBuffer->pData, CDCDBRIDGE_BUFFERSIZE);
+        pBridge->pRxBanks[pBridge->bRxCount++] = pBuffer;
+    }
+    if (pBridge->bRxCount)
+        USART_EnableIt(pUsart, US_IER_ENDRX);
+    __set_PRIMASK(primask);
+}
+
+/**
+ * Hands a buffer received from the USART over to the bulk IN endpoint, and
+ * shifts the receive banks.
+ */
+static void BridgeRxBankDone(CDCDSerialBridge *pBridge, uint32_t dwSize)
+{
+    CDCDBridgeBuffer *pBuffer = pBridge->pRxBanks[0];
+
+    pBuffer->dwSize = dwSize;
+    pBridge->pRxBanks[0] = pBridge->pRxBanks[1];
+    pBridge->bRxCount--;
+    BridgeQueue_Put(&pBridge->inQueue, pBuffer);
+}
+
+/**
+ * Bulk OUT read complete: the buffer goes to the USART.
+ */
+static void BridgeUsbReadCallback(void *pArg, uint8_t bStatus,
+                                  uint32_t dwTransferred,
+                                  uint32_t dwRemaining)
+{
+    CDCDSerialBridge *pBridge = &cdcdBridge;
+    CDCDBridgeBuffer *pBuffer = (CDCDBridgeBuffer*)pArg;
+    uint32_t primask = __get_PRIMASK();
+
+    (void)dwRemaining;
+    __disable_irq();
+    pBridge->pUsbRead = 0;
+    if (bStatus == USBD_STATUS_SUCCESS && dwTransferred) {
+
+        pBuffer->dwSize = dwTransferred;
+        BridgeQueue_Put(&pBridge->txQueue, pBuffer);
+    }
+    else
+        MEMPOOL_Free(pBridge->pPool, pBuffer);
+    __set_PRIMASK(primask);
+
+    BridgeStartUsartTx(pBridge);
+    BridgeStartUsbRead(pBridge);
+}
+
+/**
+ * Bulk IN write complete: the buffer is free again.
+ */
+static void BridgeUsbWriteCallback(void *pArg, uint8_t bStatus,
+                                   uint32_t dwTransferred,
+                                   uint32_t dwRemaining)
+{
+    CDCDSerialBridge *pBridge = &cdcdBridge;
+    CDCDBridgeBuffer *pBuffer = (CDCDBridgeBuffer*)pArg;
+    uint32_t primask = __get_PRIMASK();
+
+    (void)bStatus; (void)dwTransferred; (void)dwRemaining;
+    __disable_irq();
+    pBridge->pUsbWrite = 0;
+    MEMPOOL_Free(pBridge->pPool, pBuffer);
+    __set_PRIMASK(primask);
+
+    BridgeStartUsbWrite(pBridge);
+    BridgeStartUsartRx(pBridge);
+    BridgeStartUsbRead(pBridge);
+}
+
+/**
+ * Gives the buffers of a queue back to the pool.
+ */
+static void BridgeQueue_Release(CDCDSerialBridge *pBridge,
+                                CDCDBridgeQueue *pQueue)
+{
+    CDCDBridgeBuffer *pBuffer;
+
+    while ((pBuffer = BridgeQueue_Get(pQueue)) != 0)
+        MEMPOOL_Free(pBridge->pPool, pBuffer);
+}
+
+/**
+ * Empties the queues and the banks of the bridge.
+ */
+static void BridgeReset(CDCDSerialBridge *pBridge)
+{
+    pBridge->bStarted = 0;
+    pBridge->txQueue.pHead = pBridge->txQueue.pTail = 0;
+    pBridge->inQueue.pHead = pBridge->inQueue.pTail = 0;
+    pBridge->pUsbRead = pBridge->pUsbWrite = 0;
+    pBridge->bTxCount = pBridge->bRxCount = 0;
+}
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * Makes the bridge draw its buffers from the given pool, e.g. a pool shared
+ * with functions which do not run at the same time. Must be called before
+ * CDCDSerialBridge_Initialize(). Returns 0 if successful, 1 if the blocks
+ * of the pool are smaller than CDCDBRIDGE_BLOCKSIZE.
+ * \param pPool  Pointer to an initialized MemPool instance.
+ */
+uint8_t CDCDSerialBridge_SetBufferPool(MemPool *pPool)
+{
+    if (MEMPOOL_GetBlockSize(pPool) < sizeof(CDCDBridgeBuffer)) {
+
+        TRACE_ERROR("CDCDSerialBridge_SetBufferPool: blocks too small\n\r");
+        return 1;
+    }
+    cdcdBridge.pPool = pPool;
+    return 0;
+}
+
+
+/**
+ * Initializes the bridge between a serial port function and an USART. The
+ * USART must be configured, its transmitter and receiver enabled, and its
+ * interrupt must call CDCDSerialBridge_UsartHandler().
+ * \param pCdcd        Pointer to the CDCDSerialPort instance.
+ * \param pUsart       Pointer to the USART peripheral.
+ * \param dwRxTimeout  Receiver time-out in bit periods, after which the
+ *                     data received is sent to the host.
+ */
+void CDCDSerialBridge_Initialize(
+    CDCDSerialPort *pCdcd, Usart *pUsart, uint32_t dwRxTimeout)
+{
+    CDCDSerialBridge *pBridge = &cdcdBridge;
+
+    TRACE_INFO("CDCDSerialBridge_Initialize\n\r");
+
+    pBridge->pCdcd = pCdcd;
+    pBridge->pUsart = pUsart;
+    pBridge->dwRxTimeout = dwRxTimeout;
+#if CDCDBRIDGE_NUMBUFFERS > 0
+    if (pBridge->pPool == 0) {
+
+        MEMPOOL_Initialize(&bridgePool, bridgeStorage,
+                           sizeof(CDCDBridgeBuffer), CDCDBRIDGE_NUMBUFFERS);
+        pBridge->pPool = &bridgePool;
+    }
+#endif
+    if (pBridge->pPool == 0)
+        TRACE_ERROR("CDCDSerialBridge_Initialize: no buffer pool\n\r");
+    BridgeReset(pBridge);
+}
+
+/**
+ * Starts the data flow, once the device is configured by the host.
+ */
+void CDCDSerialBridge_Start(void)
+{
+    CDCDSerialBridge *pBridge = &cdcdBridge;
+    Usart *pUsart = pBridge->pUsart;
+
+    pBridge->bStarted = 1;
+
+    /* The time-out counter starts with the next character received */
+    pUsart->US_RTOR = pBridge->dwRxTimeout;
+    pUsart->US_CR = US_CR_STTTO;
+    USART_EnableIt(pUsart, US_IER_TIMEOUT);
+
+    BridgeStartUsartRx(pBridge);
+    BridgeStartUsbRead(pBridge);
+}
+
+/**
+ * Stops the data flow (e.g. the device is deconfigured) and returns all
+ * the buffers to the pool; the pending bulk transfers must have been
+ * aborted by the USB stack.
+ */
+void CDCDSerialBridge_Stop(void)
+{
+    CDCDSerialBridge *pBridge = &cdcdBridge;
+    Usart *pUsart = pBridge->pUsart;
+    uint32_t primask = __get_PRIMASK();
+
+    USART_DisableIt(pUsart, US_IDR_ENDTX | US_IDR_ENDRX | US_IDR_TIMEOUT);
+    pUsart->US_PTCR = US_PTCR_RXTDIS | US_PTCR_TXTDIS;
+    pUsart->US_RCR = pUsart->US_RNCR = 0;
+    pUsart->US_TCR = pUsart->US_TNCR = 0;
+
+    __disable_irq();
+    BridgeQueue_Release(pBridge, &pBridge->txQueue);
+    BridgeQueue_Release(pBridge, &pBridge->inQueue);
+    while (pBridge->bTxCount)
+        MEMPOOL_Free(pBridge->pPool, pBridge->pTxBanks[--pBridge->bTxCount]);
+    while (pBridge->bRxCount)
+        MEMPOOL_Free(pBridge->pPool, pBridge->pRxBanks[--pBridge->bRxCount]);
+    MEMPOOL_Free(pBridge->pPool, pBridge->pUsbRead);
+    MEMPOOL_Free(pBridge->pPool, pBridge->pUsbWrite);
+    BridgeReset(pBridge);
+    __set_PRIMASK(primask);
+}
+
+/**
+ * USART interrupt handling of the bridge: recycles the transmitted
+ * buffers, and passes the received ones to the host when full or when the
+ * line is idle.
+ */
+void CDCDSerialBridge_UsartHandler(void)
+{
+    CDCDSerialBridge *pBridge = &cdcdBridge;
+    Usart *pUsart = pBridge->pUsart;
+    uint32_t dwStatus = pUsart->US_CSR & pUsart->US_IMR;
+    uint8_t bInFlight;
+    uint32_t dwSize;
+
+    /* Transmit banks done */
+    if (dwStatus & US_CSR_ENDTX) {
+
+        bInFlight = (pUsart->US_TCR != 0) + (pUsart->US_TNCR != 0);
+        while (pBridge->bTxCount > bInFlight) {
+
+            MEMPOOL_Free(pBridge->pPool, pBridge->pTxBanks[0]);
+            pBridge->pTxBanks[0] = pBridge->pTxBanks[1];
+            pBridge->bTxCount--;
+        }
+        if (pBridge->bTxCount == 0)
+            USART_DisableIt(pUsart, US_IDR_ENDTX);
+        BridgeStartUsartTx(pBridge);
+        BridgeStartUsbRead(pBridge);
+    }
+
+    /* Receive banks full */
+    if (dwStatus & US_CSR_ENDRX) {
+
+        bInFlight = (pUsart->US_RCR != 0) + (pUsart->US_RNCR != 0);
+        while (pBridge->bRxCount > bInFlight)
+            BridgeRxBankDone(pBridge, CDCDBRIDGE_BUFFERSIZE);
+        if (pBridge->bRxCount == 0)
+            USART_DisableIt(pUsart, US_IDR_ENDRX);
+    }
+
+    /* Line idle: hand the partial buffer over */
+    if (dwStatus & US_CSR_TIMEOUT) {
+
+        pUsart->US_CR = US_CR_STTTO;
+        if (pBridge->bRxCount) {
+
+            pUsart->US_PTCR = US_PTCR_RXTDIS;
+            dwSize = pUsart->US_RPR - (uint32_t)pBridge->pRxBanks[0]->pData;
+            if (dwSize > 0 && dwSize < CDCDBRIDGE_BUFFERSIZE) {
+
+                BridgeRxBankDone(pBridge, dwSize);
+                pUsart->US_RNCR = 0;
+                if (pBridge->bRxCount) {
+                    pUsart->US_RPR = (uint32_t)pBridge->pRxBanks[0]->pData;
+                    pUsart->US_RCR = CDCDBRIDGE_BUFFERSIZE;
+                }
+                else
+                    pUsart->US_RCR = 0;
+            }
+            pUsart->US_PTCR = US_PTCR_RXTEN;
+        }
+    }
+
+    if (dwStatus & (US_CSR_ENDRX | US_CSR_TIMEOUT)) {
+
+        BridgeStartUsartRx(pBridge);
+        BridgeStartUsbWrite(pBridge);
+    }
+}
+
+/**@}*/
@@ -287,6 +287,22 @@ USBGenericDescriptor *CDCDSerialPort_ParseInterfaces(
                     &parseData);
 }
 
+/**
+ * Sets the CDC Serial Port interfaces and endpoints from a function map
+ * resolved with the descriptors, instead of parsing them.
+ * \param pCdcd Pointer to CDCDSerialPort instance.
+ * \param pMap  Pointer to the function map of the port.
+ */
+void CDCDSerialPort_MapInterfaces(CDCDSerialPort *pCdcd,
+                                  const USBDFunctionMap *pMap)
+{
+    pCdcd->bInterfaceNdx = pMap->bInterface;
+    pCdcd->bNumInterface = pMap->bNumInterfaces;
+    pCdcd->bIntInPIPE    = pMap->bEpAux;
+    pCdcd->bBulkInPIPE   = pMap->bEpIn;
+    pCdcd->bBulkOutPIPE  = pMap->bEpOut;
+}
+
 
 /**
  * Handles CDC-specific SETUP requests. Should be called from a
@@ -140,6 +140,18 @@ void AUDDFunction_Configure(USBGenericDescriptor *pDescriptors,
     AUDDSpeakerPhone_ParseInterfaces(pDrv, pDescriptors, wLength);
 }
 
+/**
+ * Configure function with the function map of a composite device, instead
+ * of its descriptors. Usually invoked when device is configured.
+ * \pMap Pointer to the function map of the audio function.
+ */
+void AUDDFunction_ConfigureMap(const USBDFunctionMap *pMap)
+{
+    AUDDFunction *pAudf = &auddFunction;
+    AUDDSpeakerPhone *pDrv = &pAudf->drv;
+    AUDDSpeakerPhone_MapInterfaces(pDrv, pMap);
+}
+
 /**
  * Invoked whenever the active setting of an interface is changed by the
  * host. Changes the status of the third LED accordingly.
@@ -89,7 +89,13 @@ void CDCHIDDDriver_ConfigurationChangedHandler(uint8_t cfgnum)
 {
     USBDDriver *pUsbd = USBD_GetDriver();
     USBConfigurationDescriptor *pDesc;
-    if (cfgnum > 0) {
+    const USBDFunctionMap *pMaps = pUsbd->pDescriptors->pFunctionMaps;
+    if (cfgnum > 0 && pMaps) {
+        /* Function maps resolved with the descriptors */
+        CDCDSerial_ConfigureFunctionMap(&pMaps[0]);
+        HIDDKeyboard_ConfigureFunctionMap(&pMaps[1]);
+    }
+    else if (cfgnum > 0) {
         pDesc = USBDDriver_GetCfgDescriptors(pUsbd, cfgnum);
         /* CDC */
         CDCDSerial_ConfigureFunction((USBGenericDescriptor*)pDesc,
@@ -93,7 +93,13 @@ void CDCMSDDriver_ConfigurationChangedHandler(unsigned char cfgnum)
 {
     USBDDriver *pUsbd = USBD_GetDriver();
     USBConfigurationDescriptor *pDesc;
-    if (cfgnum > 0) {
+    const USBDFunctionMap *pMaps = pUsbd->pDescriptors->pFunctionMaps;
+    if (cfgnum > 0 && pMaps) {
+        /* Function maps resolved with the descriptors */
+        CDCDSerial_ConfigureFunctionMap(&pMaps[0]);
+        MSDFunction_ConfigureMap(&pMaps[1]);
+    }
+    else if (cfgnum > 0) {
         pDesc = USBDDriver_GetCfgDescriptors(pUsbd, cfgnum);
         /* CDC */
         CDCDSerial_ConfigureFunction((USBGenericDescriptor*)pDesc,
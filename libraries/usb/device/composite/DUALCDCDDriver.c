@@ -35,6 +35,7 @@
  *---------------------------------------------------------------------------*/
 
 /*  GENERAL */
+#include "board.h"
 #include <USBLib_Trace.h>
 
 /*  USB */
@@ -55,14 +56,52 @@
 /** Interface setting spaces (4 byte aligned) */
 #define NUM_INTERFACES  ((DUALCDCDDriverDescriptors_NUMINTERFACE+3)&0xFC)
 
+/** Streaming buffer states */
+#define STREAM_FREE     0   /**< Owned by the driver, not in use */
+#define STREAM_BUSY     1   /**< In a bulk transfer */
+#define STREAM_FULL     2   /**< Holds data for the application (OUT) or
+                                 for the host (IN) */
+
+/** USB frame number (1 ms period, 11 bits) */
+#define STREAM_FRAME()  (UDP->UDP_FRM_NUM & UDP_FRM_NUM_FRM_NUM_Msk)
+#define STREAM_FRAMES(start) ((STREAM_FRAME() - (start)) & UDP_FRM_NUM_FRM_NUM_Msk)
+
 /*---------------------------------------------------------------------------
  *         Types
  *---------------------------------------------------------------------------*/
 
+/** Streaming state of a port: two OUT and two IN buffers used in turn */
+typedef struct _DualCdcdStream {
+    /** OUT buffers, then IN buffers */
+    uint8_t *pBuffers[4];
+    /** Size of each buffer */
+    uint32_t dwBufferSize;
+    /** Number of valid bytes of each buffer */
+    uint32_t dwSize[4];
+    /** STREAM_xxx state of each buffer */
+    volatile uint8_t bState[4];
+    /** OUT buffer to arm next, to read next */
+    uint8_t bOutArm, bOutRead;
+    /** IN buffer to send next, to fill next */
+    uint8_t bInSend, bInFill;
+    /** Streaming enabled */
+    uint8_t bEnabled;
+    /** Stall in progress: OUT not armed, IN buffer refused */
+    uint8_t bOutStalled, bInStalled;
+    /** Frame numbers at the start of the stalls */
+    uint16_t wOutStallStart, wInStallStart;
+    /** Counters */
+    DualCdcdStreamStats stats;
+} DualCdcdStream;
+
 /** Dual-CDC-Serial device driver struct */
 typedef struct _DualCdcdSerialDriver {
     /** CDC Serial Port List */
     CDCDSerialPort cdcdSerialPort[NUM_PORTS];
+    /** Streaming state of the ports */
+    DualCdcdStream streams[NUM_PORTS];
+    /** Last port returned by DUALCDCDDriver_StreamGetReadyPort() */
+    uint8_t bLastReadyPort;
 } DualCdcdSerialDriver;
 
 /*---------------------------------------------------------------------------
@@ -76,6 +115,113 @@ DualCdcdSerialDriver dualcdcdDriver;
  *         Internal functions
  *---------------------------------------------------------------------------*/
 
+static void StreamArmOut(uint32_t port);
+static void StreamStartIn(uint32_t port);
+
+/**
+ * Bulk OUT transfer of a port complete: the buffer goes to the application
+ * and the other one is armed at once, so the ports never wait for each other.
+ */
+static void StreamOutCallback(void *pArg, uint8_t bStatus,
+                              uint32_t dwTransferred, uint32_t dwRemaining)
+{
+    uint32_t port = (uint32_t)pArg;
+    DualCdcdStream *pStream = &dualcdcdDriver.streams[port];
+    uint8_t b = pStream->bOutArm;
+
+    (void)dwRemaining;
+    if (bStatus == USBD_STATUS_SUCCESS && dwTransferred) {
+
+        pStream->dwSize[b] = dwTransferred;
+        pStream->bState[b] = STREAM_FULL;
+        pStream->stats.dwBytesOut += dwTransferred;
+        pStream->bOutArm = b ^ 1;
+    }
+    else
+        pStream->bState[b] = STREAM_FREE;
+
+    StreamArmOut(port);
+}
+
+/**
+ * Bulk IN transfer of a port complete: the buffer is free again.
+ */
+static void StreamInCallback(void *pArg, uint8_t bStatus,
+                             uint32_t dwTransferred, uint32_t dwRemaining)
+{
+    uint32_t port = (uint32_t)pArg;
+    DualCdcdStream *pStream = &dualcdcdDriver.streams[port];
+
+    (void)bStatus; (void)dwRemaining;
+    pStream->stats.dwBytesIn += dwTransferred;
+    pStream->bState[2 + pStream->bInSend] = STREAM_FREE;
+    pStream->bInSend ^= 1;
+
+    StreamStartIn(port);
+}
+
+/**
+ * Arms the bulk OUT endpoint of a port with its next free buffer; starts
+ * counting a stall when both buffers are full.
+ */
+static void StreamArmOut(uint32_t port)
+{
+    DualCdcdStream *pStream = &dualcdcdDriver.streams[port];
+    CDCDSerialPort *pCdcd = &dualcdcdDriver.cdcdSerialPort[port];
+    uint8_t b;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    b = pStream->bOutArm;
+    if (pStream->bEnabled
+        && pStream->bState[b ^ 1] != STREAM_BUSY
+        && pStream->bState[b] == STREAM_FREE) {
+
+        pStream->bState[b] = STREAM_BUSY;
+        if (CDCDSerialPort_Read(pCdcd, pStream->pBuffers[b],
+                                pStream->dwBufferSize,
+                                StreamOutCallback, (void*)port)
+                != USBD_STATUS_SUCCESS)
+            pStream->bState[b] = STREAM_FREE;
+        else if (pStream->bOutStalled) {
+            pStream->bOutStalled = 0;
+            pStream->stats.dwOutStallFrames +=
+                STREAM_FRAMES(pStream->wOutStallStart);
+        }
+    }
+    else if (pStream->bEnabled
+             && pStream->bState[b] == STREAM_FULL && !pStream->bOutStalled) {
+
+        pStream->bOutStalled = 1;
+        pStream->wOutStallStart = STREAM_FRAME();
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * Sends the next queued IN buffer of a port, if its endpoint is idle.
+ */
+static void StreamStartIn(uint32_t port)
+{
+    DualCdcdStream *pStream = &dualcdcdDriver.streams[port];
+    CDCDSerialPort *pCdcd = &dualcdcdDriver.cdcdSerialPort[port];
+    uint8_t b;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    b = 2 + pStream->bInSend;
+    if (pStream->bState[b] == STREAM_FULL) {
+
+        pStream->bState[b] = STREAM_BUSY;
+        if (CDCDSerialPort_Write(pCdcd, pStream->pBuffers[b],
+                                 pStream->dwSize[b],
+                                 StreamInCallback, (void*)port)
+                != USBD_STATUS_SUCCESS)
+            pStream->bState[b] = STREAM_FULL;
+    }
+    __set_PRIMASK(primask);
+}
+
 /*---------------------------------------------------------------------------
  *         Exported functions
  *---------------------------------------------------------------------------*/
@@ -122,20 +268,36 @@ void DUALCDCDDriver_ConfigurationChangeHandler(uint8_t cfgnum)
     USBDDriver *pUsbd = pCdcd->pUsbd;
     USBConfigurationDescriptor *pDesc;
     USBGenericDescriptor *pD;
+    const USBDFunctionMap *pMaps = pUsbd->pDescriptors->pFunctionMaps;
     uint32_t i, len;
 
     if (cfgnum > 0) {
 
+        /* Function maps resolved with the descriptors */
+        if (pMaps) {
+            for (i = 0; i < NUM_PORTS; i ++) {
+                CDCDSerialPort_MapInterfaces(&dualcdcdDriver.cdcdSerialPort[i],
+                                             &pMaps[i]);
+            }
+        }
         /* Parse endpoints for data & notification */
-        pDesc = USBDDriver_GetCfgDescriptors(pUsbd, cfgnum);
+        else {
+            pDesc = USBDDriver_GetCfgDescriptors(pUsbd, cfgnum);
+
+            pD = (USBGenericDescriptor *)pDesc;
+            len = pDesc->wTotalLength;
 
-        pD = (USBGenericDescriptor *)pDesc;
-        len = pDesc->wTotalLength;
+            for (i = 0; i < NUM_PORTS; i ++) {
+                pCdcd = &dualcdcdDriver.cdcdSerialPort[i];
+                pD = CDCDSerialPort_ParseInterfaces(pCdcd, pD, len);
+                len = pDesc->wTotalLength - ((uint32_t)pD - (uint32_t)pDesc);
+            }
+        }
 
+        /* Restart streaming */
         for (i = 0; i < NUM_PORTS; i ++) {
-            pCdcd = &dualcdcdDriver.cdcdSerialPort[i];
-            pD = CDCDSerialPort_ParseInterfaces(pCdcd, pD, len);
-            len = pDesc->wTotalLength - ((uint32_t)pD - (uint32_t)pDesc);
+            StreamArmOut(i);
+            StreamStartIn(i);
         }
     }
 }
@@ -190,5 +352,160 @@ CDCDSerialPort *DUALCDCDDriver_GetSerialPort(uint32_t port)
     return 0;
 }
 
+/**
+ * Enables the streaming mode of a port: the driver keeps two buffers in
+ * turn on each bulk endpoint, re-arming them from the transfer callbacks.
+ * The port must not be used with CDCDSerialPort_Read/Write any more.
+ * \param port         Port number.
+ * \param pBuffers     4 buffers of dwBufferSize bytes: 2 OUT, then 2 IN.
+ * \param dwBufferSize Size of a buffer (multiple of the endpoint size).
+ */
+void DUALCDCDDriver_StartStreaming(uint32_t port,
+                                   uint8_t *pBuffers,
+                                   uint32_t dwBufferSize)
+{
+    DualCdcdStream *pStream = &dualcdcdDriver.streams[port];
+    uint32_t i;
+
+    for (i = 0; i < 4; i ++) {
+        pStream->pBuffers[i] = &pBuffers[i * dwBufferSize];
+        pStream->dwSize[i] = 0;
+        pStream->bState[i] = STREAM_FREE;
+    }
+    pStream->dwBufferSize = dwBufferSize;
+    pStream->bOutArm = pStream->bOutRead = 0;
+    pStream->bInSend = pStream->bInFill = 0;
+    pStream->bOutStalled = pStream->bInStalled = 0;
+    pStream->stats.dwBytesOut = pStream->stats.dwBytesIn = 0;
+    pStream->stats.dwOutStallFrames = pStream->stats.dwInStallFrames = 0;
+    pStream->bEnabled = 1;
+
+    StreamArmOut(port);
+}
+
+/**
+ * Returns the next buffer received from the host on a port, in place.
+ * \param port    Port number.
+ * \param ppData  Set to the received data.
+ * \return Number of bytes received, 0 if no buffer is full.
+ */
+uint32_t DUALCDCDDriver_StreamRead(uint32_t port, uint8_t **ppData)
+{
+    DualCdcdStream *pStream = &dualcdcdDriver.streams[port];
+    uint8_t b = pStream->bOutRead;
+
+    if (pStream->bState[b] != STREAM_FULL)
+        return 0;
+
+    *ppData = pStream->pBuffers[b];
+    return pStream->dwSize[b];
+}
+
+/**
+ * Gives back the buffer returned by DUALCDCDDriver_StreamRead() to the
+ * bulk OUT endpoint.
+ * \param port    Port number.
+ */
+void DUALCDCDDriver_StreamReadDone(uint32_t port)
+{
+    DualCdcdStream *pStream = &dualcdcdDriver.streams[port];
+
+    pStream->bState[pStream->bOutRead] = STREAM_FREE;
+    pStream->bOutRead ^= 1;
+
+    StreamArmOut(port);
+}
+
+/**
+ * Returns the next free IN buffer of a port to fill, or 0 if both are still
+ * queued for the host (the stall time is counted until one is free).
+ * \param port    Port number.
+ */
+uint8_t* DUALCDCDDriver_StreamGetWriteBuffer(uint32_t port)
+{
+    DualCdcdStream *pStream = &dualcdcdDriver.streams[port];
+    uint8_t b = 2 + pStream->bInFill;
+
+    if (pStream->bState[b] != STREAM_FREE) {
+
+        if (!pStream->bInStalled) {
+            pStream->bInStalled = 1;
+            pStream->wInStallStart = STREAM_FRAME();
+        }
+        return 0;
+    }
+
+    if (pStream->bInStalled) {
+        pStream->bInStalled = 0;
+        pStream->stats.dwInStallFrames += STREAM_FRAMES(pStream->wInStallStart);
+    }
+    return pStream->pBuffers[b];
+}
+
+/**
+ * Queues the buffer returned by DUALCDCDDriver_StreamGetWriteBuffer() for
+ * the host.
+ * \param port    Port number.
+ * \param dwSize  Number of bytes to send.
+ * \return USBD_STATUS_SUCCESS, or USBD_STATUS_LOCKED if no buffer is free.
+ */
+uint32_t DUALCDCDDriver_StreamWrite(uint32_t port, uint32_t dwSize)
+{
+    DualCdcdStream *pStream = &dualcdcdDriver.streams[port];
+    uint8_t b = 2 + pStream->bInFill;
+
+    if (pStream->bState[b] != STREAM_FREE)
+        return USBD_STATUS_LOCKED;
+
+    pStream->dwSize[b] = dwSize;
+    pStream->bState[b] = STREAM_FULL;
+    pStream->bInFill ^= 1;
+
+    StreamStartIn(port);
+    return USBD_STATUS_SUCCESS;
+}
+
+/**
+ * Returns the next port having data from the host, the ports being served
+ * in turn so that a busy port does not starve the other; -1 if none.
+ */
+int32_t DUALCDCDDriver_StreamGetReadyPort(void)
+{
+    DualCdcdStream *pStream;
+    uint32_t i, port;
+
+    for (i = 1; i <= NUM_PORTS; i ++) {
+
+        port = (dualcdcdDriver.bLastReadyPort + i) % NUM_PORTS;
+        pStream = &dualcdcdDriver.streams[port];
+        if (pStream->bEnabled
+            && pStream->bState[pStream->bOutRead] == STREAM_FULL) {
+
+            dualcdcdDriver.bLastReadyPort = port;
+            return port;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Copies the throughput counters of a port.
+ * \param port    Port number.
+ * \param pStats  Pointer to the DualCdcdStreamStats to fill.
+ */
+void DUALCDCDDriver_GetStreamStats(uint32_t port, DualCdcdStreamStats *pStats)
+{
+    DualCdcdStream *pStream = &dualcdcdDriver.streams[port];
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    *pStats = pStream->stats;
+    if (pStream->bOutStalled)
+        pStats->dwOutStallFrames += STREAM_FRAMES(pStream->wOutStallStart);
+    if (pStream->bInStalled)
+        pStats->dwInStallFrames += STREAM_FRAMES(pStream->wInStallStart);
+    __set_PRIMASK(primask);
+}
+
 /**@}*/
 
@@ -92,7 +92,13 @@ void HIDAUDDDriver_ConfigurationChangedHandler(uint8_t cfgnum)
 {
     USBDDriver *pUsbd = USBD_GetDriver();
     USBConfigurationDescriptor *pDesc;
-    if (cfgnum > 0) {
+    const USBDFunctionMap *pMaps = pUsbd->pDescriptors->pFunctionMaps;
+    if (cfgnum > 0 && pMaps) {
+        /* Function maps resolved with the descriptors */
+        HIDDKeyboard_ConfigureFunctionMap(&pMaps[0]);
+        AUDDFunction_ConfigureMap(&pMaps[1]);
+    }
+    else if (cfgnum > 0) {
         pDesc = USBDDriver_GetCfgDescriptors(pUsbd, cfgnum);
         /* CDC */
         HIDDKeyboard_ConfigureFunction((USBGenericDescriptor*)pDesc,
@@ -99,7 +99,13 @@ void HIDMSDDriver_ConfigurationChangedHandler(uint8_t cfgnum)
 {
     USBDDriver *pUsbd = USBD_GetDriver();
     USBConfigurationDescriptor *pDesc;
-    if (cfgnum > 0) {
+    const USBDFunctionMap *pMaps = pUsbd->pDescriptors->pFunctionMaps;
+    if (cfgnum > 0 && pMaps) {
+        /* Function maps resolved with the descriptors */
+        HIDDKeyboard_ConfigureFunctionMap(&pMaps[0]);
+        MSDFunction_ConfigureMap(&pMaps[1]);
+    }
+    else if (cfgnum > 0) {
         pDesc = USBDDriver_GetCfgDescriptors(pUsbd, cfgnum);
         /* HID */
         HIDDKeyboard_ConfigureFunction((USBGenericDescriptor*)pDesc,
@@ -49,6 +49,8 @@
 
 //#include <USBLib_Trace.h>
 
+#include <string.h>
+
 /*---------------------------------------------------------------------------
  *      Definitions
  *---------------------------------------------------------------------------*/
@@ -62,10 +64,31 @@ static uint8_t deviceState;
 /** Indicates the previous device state */
 static uint8_t previousDeviceState;
 
+/** 1 when the USBD_STATS_VENDORCODE request is answered */
+static uint8_t statsOn = 0;
+/** Bus events counted since the last reset of the statistics */
+static uint32_t dwResets, dwSuspends, dwResumes;
+/** Statistics being sent for USBD_STATS_VENDORCODE */
+static USBDStats statsReply;
+
 /*---------------------------------------------------------------------------
  *      Internal Functions
  *---------------------------------------------------------------------------*/
 
+/**
+ * Sends the statistics for the USBD_STATS_VENDORCODE request.
+ * \param pRequest  Pointer to the request.
+ */
+static void USBD_StatsRequest(const USBGenericRequest *pRequest)
+{
+    uint32_t dwLength = USBGenericRequest_GetLength(pRequest);
+
+    USBD_GetStats(&statsReply, USBGenericRequest_GetValue(pRequest) == 1);
+    if (dwLength > sizeof(statsReply))
+        dwLength = sizeof(statsReply);
+    USBD_Write(0, &statsReply, dwLength, 0, 0);
+}
+
 /*---------------------------------------------------------------------------
  *      Exported functions
  *---------------------------------------------------------------------------*/
@@ -86,6 +109,8 @@ void USBD_SuspendHandler(void)
         /* Switch to the Suspended state */
         previousDeviceState = deviceState;
         deviceState = USBD_STATE_SUSPENDED;
+        dwSuspends ++;
+        IOEVT_Raise(IOEVT_USB_STATE);
 
         /* Suspend HW interface */
         USBD_HAL_Suspend();
@@ -107,6 +132,8 @@ void USBD_ResumeHandler(void)
         /* Active the device */
         USBD_HAL_Activate();
         deviceState = previousDeviceState;
+        dwResumes ++;
+        IOEVT_Raise(IOEVT_USB_STATE);
         if (deviceState >= USBD_STATE_DEFAULT) {
             /* Invoke the Resume callback */
             if (USBDCallbacks_Resumed)
@@ -124,6 +151,8 @@ void USBD_ResetHandler()
 {
     /* The device enters the Default state */
     deviceState = USBD_STATE_DEFAULT;
+    dwResets ++;
+    IOEVT_Raise(IOEVT_USB_STATE);
     /* Active the USB HW */
     USBD_HAL_Activate();
     /* Only EP0 enabled */
@@ -136,7 +165,9 @@ void USBD_ResetHandler()
 
 /**
  *  Handle the USB setup package received, should be invoked
- *  when an endpoint got a setup package as request.
+ *  when an endpoint got a setup package as request. The
+ *  USBD_STATS_VENDORCODE request is answered here once USBD_EnableStats()
+ *  was called, the others are forwarded to USBDCallbacks_RequestReceived().
  *  \param bEndpoint Endpoint number.
  *  \param pRequest  Pointer to content of request.
  */
@@ -147,6 +178,14 @@ void USBD_RequestHandler(uint8_t bEndpoint,
         TRACE_WARNING("EP%d request not supported, default EP only",
                       bEndpoint);
     }
+    else if (statsOn
+             && USBGenericRequest_GetType(pRequest) == USBGenericRequest_VENDOR
+             && USBGenericRequest_GetRecipient(pRequest) == USBGenericRequest_DEVICE
+             && USBGenericRequest_GetRequest(pRequest) == USBD_STATS_VENDORCODE
+             && USBGenericRequest_GetDirection(pRequest) == USBGenericRequest_IN) {
+
+        USBD_StatsRequest(pRequest);
+    }
     else if (USBDCallbacks_RequestReceived) {
         USBDCallbacks_RequestReceived(pRequest);
     }
@@ -220,6 +259,57 @@ uint8_t USBD_Read(uint8_t          bEndpoint,
     USBD_HAL_SetTransferCallback(bEndpoint, fCallback, pArgument);
     return USBD_HAL_Read(bEndpoint, pData, dLength);
 }
+/**
+ * Sends a scatter-gather list of buffers through a bulk or interrupt
+ * endpoint as one transfer. The callback is invoked once, when all the
+ * buffers have been sent.
+ *
+ * *The list and its buffers must be kept allocated until the transfer is
+ *  finished*.
+ * \param bEndpoint Endpoint number.
+ * \param pList Pointer to the buffer list (pBuffer and size filled).
+ * \param listSize Number of buffers in the list.
+ * \param fCallback Optional callback function to invoke when the transfer is
+ *        complete.
+ * \param pArgument Optional argument to the callback function.
+ * \return USBD_STATUS_SUCCESS if the transfer has been started;
+ *         otherwise, the corresponding error status code.
+ */
+uint8_t USBD_WriteList(uint8_t            bEndpoint,
+                       USBDTransferBuffer *pList,
+                       uint16_t           listSize,
+                       TransferCallback   fCallback,
+                       void               *pArgument)
+{
+    USBD_HAL_SetTransferCallback(bEndpoint, fCallback, pArgument);
+    return USBD_HAL_WriteList(bEndpoint, pList, listSize);
+}
+
+/**
+ * Reads incoming data on a bulk or interrupt endpoint into a scatter-gather
+ * list of buffers. The operation finishes either when all the buffers are
+ * full, or a short packet is received.
+ *
+ * *The list and its buffers must be kept allocated until the transfer is
+ *  finished*.
+ * \param bEndpoint Endpoint number.
+ * \param pList Pointer to the buffer list (pBuffer and size filled).
+ * \param listSize Number of buffers in the list.
+ * \param fCallback Optional end-of-transfer callback function.
+ * \param pArgument Optional argument to the callback function.
+ * \return USBD_STATUS_SUCCESS if the read operation has been started;
+ *         otherwise, the corresponding error code.
+ */
+uint8_t USBD_ReadList(uint8_t            bEndpoint,
+                      USBDTransferBuffer *pList,
+                      uint16_t           listSize,
+                      TransferCallback   fCallback,
+                      void               *pArgument)
+{
+    USBD_HAL_SetTransferCallback(bEndpoint, fCallback, pArgument);
+    return USBD_HAL_ReadList(bEndpoint, pList, listSize);
+}
+
 /**
  * Sets the HALT feature on the given endpoint (if not already in this state).
  * \param bEndpoint Endpoint number.
@@ -300,6 +390,7 @@ void USBD_SetConfiguration(uint8_t cfgnum)
         /* Reset all endpoints */
         USBD_HAL_ResetEPs(0xFFFFFFFF, USBD_STATUS_RESET, 0);
     }
+    IOEVT_Raise(IOEVT_USB_STATE);
 }
 
 /*---------------------------------------------------------------------------
@@ -341,6 +432,7 @@ void USBD_Disconnect(void)
     if (deviceState > USBD_STATE_POWERED) {
 
         deviceState = USBD_STATE_POWERED;
+        IOEVT_Raise(IOEVT_USB_STATE);
     }
 
     if (previousDeviceState > USBD_STATE_POWERED) {
@@ -377,4 +469,51 @@ uint8_t USBD_GetState(void)
     return deviceState;
 }
 
+/**
+ * Starts counting the traffic of each endpoint, the bus events and the
+ * time spent in the USB interrupt (USBD_HAL_EnableIrqStats()), and answers
+ * the USBD_STATS_VENDORCODE request with them, so that a host tool can
+ * read them while the device runs.
+ * \param bEnable  1 to clear the statistics and start, 0 to stop.
+ */
+void USBD_EnableStats(uint8_t bEnable)
+{
+    if (bEnable)
+        USBD_GetStats(0, 1);
+    USBD_HAL_EnableIrqStats(bEnable);
+    statsOn = bEnable;
+}
+
+/**
+ * Gets the statistics of the device.
+ * \param pStats  Filled with the statistics since the last reset, may be 0.
+ * \param bReset  1 to clear the statistics once read.
+ */
+void USBD_GetStats(USBDStats *pStats, uint8_t bReset)
+{
+    USBDIrqStats irqStats;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    USBD_HAL_GetIrqStats(&irqStats, bReset);
+    if (pStats) {
+
+        pStats->dwMck = BOARD_MCK;
+        pStats->dwResets = dwResets;
+        pStats->dwSuspends = dwSuspends;
+        pStats->dwResumes = dwResumes;
+        pStats->dwIrqCount = irqStats.dwCount;
+        pStats->dwIrqCycles = irqStats.dwCycles;
+        pStats->dwIrqMaxCycles = irqStats.dwMaxCycles;
+    }
+    USBD_HAL_GetEPStats(pStats ? pStats->aEndpoints : 0, bReset);
+    if (bReset) {
+
+        dwResets = 0;
+        dwSuspends = 0;
+        dwResumes = 0;
+    }
+    __set_PRIMASK(primask);
+}
+
 /**@}*/
@@ -0,0 +1,158 @@
+#!/usr/bin/env python
+# ----------------------------------------------------------------------------
+#         ATMEL Microcontroller Software Support
+# ----------------------------------------------------------------------------
+# Copyright (c) 2010, Atmel Corporation
+#
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# - Redistributions of source code must retain the above copyright notice,
+# this list of conditions and the disclaimer below.
+#
+# Atmel's name may not be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+# IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+# DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+# OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+# EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+# ----------------------------------------------------------------------------
+
+"""Reads the statistics of the USB device stack (USBD_EnableStats()) through
+the vendor request USBD_STATS_VENDORCODE, while the device runs: bytes,
+packets, starved FIFOs (OUT packets NAKed for want of a buffer, IN streams
+run dry), stalls and interrupt time of each endpoint, bus resets, suspends
+and resumes. Needs pyusb.
+
+    usbdstats.py --pid 6140              totals since the last reset
+    usbdstats.py --pid 6140 -i 1         figures of each second
+    usbdstats.py --pid 6140 --reset      totals, then clears them
+"""
+
+import struct
+import sys
+import time
+
+USBD_STATS_VENDORCODE = 0x5A
+USBD_STATS_ENDPOINTS = 8
+
+HEADER = struct.Struct('<7I')
+HEADER_FIELDS = ('mck', 'resets', 'suspends', 'resumes', 'irq_count',
+                 'irq_cycles', 'irq_max_cycles')
+ENDPOINT = struct.Struct('<6I')
+ENDPOINT_FIELDS = ('bytes', 'packets', 'starved', 'stalls', 'irq_count',
+                   'irq_cycles')
+SIZE = HEADER.size + USBD_STATS_ENDPOINTS * ENDPOINT.size
+
+# Counters which are not summed (the longest service and the clock)
+NOT_COUNTERS = ('mck', 'irq_max_cycles')
+
+
+def parse(data):
+    """Splits a USBDStats block into a dict and a list of endpoint dicts."""
+    data = bytes(bytearray(data))
+    if len(data) < SIZE:
+        raise ValueError('short statistics block (%d bytes)' % len(data))
+    stats = dict(zip(HEADER_FIELDS, HEADER.unpack_from(data, 0)))
+    endpoints = [dict(zip(ENDPOINT_FIELDS,
+                          ENDPOINT.unpack_from(data, HEADER.size
+                                               + i * ENDPOINT.size)))
+                 for i in range(USBD_STATS_ENDPOINTS)]
+    return stats, endpoints
+
+
+def delta(new, old):
+    """Figures of new since old, the 32-bit counters wrapping."""
+    return dict((k, v if k in NOT_COUNTERS else (v - old[k]) & 0xFFFFFFFF)
+                for k, v in new.items())
+
+
+def get_stats(dev, reset=False, vendorcode=USBD_STATS_VENDORCODE):
+    """Returns the device statistics, clearing them if reset."""
+    return parse(dev.ctrl_transfer(0xC0, vendorcode, 1 if reset else 0, 0,
+                                   SIZE))
+
+
+def show(stats, endpoints, elapsed=None, out=sys.stdout):
+    """Prints the statistics, as rates when elapsed (seconds) is given."""
+    mck = float(stats['mck'] or 1)
+    out.write('bus: %d resets, %d suspends, %d resumes; IRQ %d serviced, '
+              '%.1f ms, longest %.1f us'
+              % (stats['resets'], stats['suspends'], stats['resumes'],
+                 stats['irq_count'], 1e3 * stats['irq_cycles'] / mck,
+                 1e6 * stats['irq_max_cycles'] / mck))
+    if elapsed:
+        out.write(', %.1f %% of the CPU'
+                  % (100.0 * stats['irq_cycles'] / (elapsed * mck)))
+    out.write('\n')
+    out.write('%-3s %12s %10s %8s %7s %9s %10s\n'
+              % ('ep', 'KB/s' if elapsed else 'bytes', 'packets', 'starved',
+                 'stalls', 'irqs', 'irq(us)'))
+    for i, ep in enumerate(endpoints):
+        if not any(ep.values()):
+            continue
+        if elapsed:
+            moved = '%12.1f' % (ep['bytes'] / elapsed / 1e3)
+        else:
+            moved = '%12d' % ep['bytes']
+        out.write('%-3d %s %10d %8d %7d %9d %10.0f\n'
+                  % (i, moved, ep['packets'], ep['starved'], ep['stalls'],
+                     ep['irq_count'], 1e6 * ep['irq_cycles'] / mck))
+
+
+def main(argv):
+    import optparse
+    import usb.core
+    parser = optparse.OptionParser(usage='%prog --pid PID [options]')
+    parser.add_option('--vid', default='03eb', help='vendor ID [%default]')
+    parser.add_option('--pid', help='product ID, hexadecimal')
+    parser.add_option('-c', '--code', type='int',
+                      default=USBD_STATS_VENDORCODE,
+                      help='USBD_STATS_VENDORCODE of the firmware '
+                           '[%default]')
+    parser.add_option('-i', '--interval', type='float', default=0,
+                      help='print the figures of each interval, in seconds')
+    parser.add_option('-r', '--reset', action='store_true', default=False,
+                      help='clear the statistics once read')
+    (options, args) = parser.parse_args(argv[1:])
+    if options.pid is None or args:
+        parser.error('give the product ID with --pid')
+
+    dev = usb.core.find(idVendor=int(options.vid, 16),
+                        idProduct=int(options.pid, 16))
+    if dev is None:
+        raise SystemExit('device %s:%s not found' % (options.vid, options.pid))
+
+    if not options.interval:
+        show(*get_stats(dev, options.reset, options.code))
+        return 0
+
+    last, last_eps = get_stats(dev, False, options.code)
+    last_time = time.time()
+    try:
+        while True:
+            time.sleep(options.interval)
+            stats, eps = get_stats(dev, False, options.code)
+            now = time.time()
+            show(delta(stats, last),
+                 [delta(ep, old) for ep, old in zip(eps, last_eps)],
+                 now - last_time)
+            sys.stdout.write('\n')
+            sys.stdout.flush()
+            last, last_eps, last_time = stats, eps, now
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -261,6 +261,22 @@ void HIDDKeyboard_ConfigureFunction(USBGenericDescriptor *pDescriptors,
     HIDDFunction_StartPollingOutputs(pHidd);
 }
 
+/**
+ * Configure function with the function map of a composite device, instead
+ * of its descriptors, and start functionality.
+ * \param pMap Pointer to the function map of the keyboard function.
+ */
+void HIDDKeyboard_ConfigureFunctionMap(const USBDFunctionMap *pMap)
+{
+    HIDDKeyboard *pKbd = &hiddKeyboard;
+    HIDDFunction *pHidd = &pKbd->hidDrv;
+
+    HIDDFunction_MapInterface(pHidd, pMap);
+
+    /* Start receiving output reports */
+    HIDDFunction_StartPollingOutputs(pHidd);
+}
+
 /**
  * Handles HID-specific SETUP request sent by the host.
  * \param request Pointer to a USBGenericRequest instance.
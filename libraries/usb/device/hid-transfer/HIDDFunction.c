@@ -38,12 +38,16 @@
  *         Headers
  *------------------------------------------------------------------------------*/
 
+#include "board.h"
+
 #include <HIDDFunction.h>
 #include <USBDescriptors.h>
 #include <HIDDescriptors.h>
 
 #include <USBLib_Trace.h>
 
+#include <string.h>
+
 /*------------------------------------------------------------------------------
  *         Definitions
  *------------------------------------------------------------------------------*/
@@ -349,8 +353,11 @@ static uint32_t HIDDFunction_Parse(USBGenericDescriptor * pDesc,
         /* Parse endpoints */
         else if (pDesc->bDescriptorType == USBGenericDescriptor_ENDPOINT) {
             USBEndpointDescriptor *pEp = (USBEndpointDescriptor*)pDesc;
-            if (pEp->bEndpointAddress & 0x80)
+            if (pEp->bEndpointAddress & 0x80) {
                 pArg->pHidd->bPipeIN = pEp->bEndpointAddress & 0x7F;
+                pArg->pHidd->wInPacketSize =
+                    USBEndpointDescriptor_GetMaxPacketSize(pEp);
+            }
             else
                 pArg->pHidd->bPipeOUT = pEp->bEndpointAddress;
         }
@@ -442,6 +449,109 @@ static void HIDDFunction_ReportSent(HIDDFunction *pHidd,
               (void*)pHidd);
 }
 
+static void HIDDFunction_QueueSent(HIDDFunction *pHidd,
+                                   uint8_t status,
+                                   uint32_t transferred,
+                                   uint32_t remaining);
+
+/**
+ * Starts sending the oldest queued input reports if the IN pipe is idle.
+ * The reports up to the end of the ring go in one transfer when each fills
+ * a packet, one packet being sent per interval.
+ * Must be invoked with the interrupts disabled.
+ * \param pHidd  Pointer to HIDDFunction instance
+ */
+static void HIDDFunction_QueueStartInput(HIDDFunction *pHidd)
+{
+    HIDDReportQueue *pQ = pHidd->pInQueue;
+    uint16_t wCount;
+
+    if (pQ->wInTransfer || pQ->wHead == pQ->wTail)
+        return;
+
+    if (pQ->wTail > pQ->wHead)
+        wCount = pQ->wTail - pQ->wHead;
+    else
+        wCount = pQ->wNumSlots - pQ->wHead;
+    if (pQ->wReportSize != pHidd->wInPacketSize)
+        wCount = 1;
+
+    pQ->wInTransfer = wCount;
+    if (USBD_Write(pHidd->bPipeIN,
+                   &pQ->pBuffer[pQ->wHead * pQ->wReportSize],
+                   wCount * pQ->wReportSize,
+                   (TransferCallback)HIDDFunction_QueueSent,
+                   (void*)pHidd) != USBD_STATUS_SUCCESS) {
+        pQ->wInTransfer = 0;
+    }
+}
+
+/**
+ * Callback function when queued input reports sent to host
+ * \param pHidd  Pointer to HIDDFunction instance
+ * \param status Result status
+ * \param transferred Number of bytes transferred
+ * \param remaining Number of bytes that are not transferred yet
+ */
+static void HIDDFunction_QueueSent(HIDDFunction *pHidd,
+                                   uint8_t status,
+                                   uint32_t transferred,
+                                   uint32_t remaining)
+{
+    HIDDReportQueue *pQ = pHidd->pInQueue;
+
+    if (status != USBRC_SUCCESS) {
+
+        TRACE_ERROR("HIDDFun::QueueSent: %x\n\r", status);
+        pQ->wInTransfer = 0;
+        return;
+    }
+
+    /* Release the sent slots */
+    pQ->wHead = (pQ->wHead + pQ->wInTransfer) % pQ->wNumSlots;
+    pQ->wInTransfer = 0;
+
+    /* Keep the endpoint fed */
+    if (pQ->wHead == pQ->wTail)
+        pQ->dwUnderruns ++;
+    else
+        HIDDFunction_QueueStartInput(pHidd);
+}
+
+/**
+ * Callback function when an output report received in the queue
+ * \param pHidd  Pointer to HIDDFunction instance
+ * \param status Result status
+ * \param transferred Number of bytes transferred
+ * \param remaining Number of bytes that are not transferred yet
+ */
+static void HIDDFunction_QueueReceived(HIDDFunction *pHidd,
+                                       uint8_t status,
+                                       uint32_t transferred,
+                                       uint32_t remaining)
+{
+    HIDDReportQueue *pQ = pHidd->pOutQueue;
+    uint16_t wNext = (pQ->wTail + 1) % pQ->wNumSlots;
+
+    if (status != USBRC_SUCCESS) {
+
+        TRACE_ERROR("HIDDFun::QueueReceived: %x\n\r", status);
+        return;
+    }
+
+    /* Keep the report, or drop it when the ring is full */
+    if (wNext == pQ->wHead)
+        pQ->dwDropped ++;
+    else
+        pQ->wTail = wNext;
+
+    /* Re-arm at once in the free slot */
+    USBD_Read(pHidd->bPipeOUT,
+              &pQ->pBuffer[pQ->wTail * pQ->wReportSize],
+              pQ->wReportSize,
+              (TransferCallback)HIDDFunction_QueueReceived,
+              (void*)pHidd);
+}
 
 /*------------------------------------------------------------------------------
  *         Exported functions
@@ -483,6 +593,9 @@ void HIDDFunction_Initialize(HIDDFunction * pHidd,
     pHidd->bCurrInput = 0;
     pHidd->bCurrOutput = 0;
 
+    pHidd->wInPacketSize = 0;
+    pHidd->pInQueue = 0;
+    pHidd->pOutQueue = 0;
 }
 
 /**
@@ -508,6 +621,23 @@ USBGenericDescriptor *HIDDFunction_ParseInterface(HIDDFunction * pHidd,
                                       (void*)&data);
 }
 
+/**
+ * Sets the USB HID Function Interface from a function map resolved with the
+ * descriptors, instead of parsing them.
+ * \param pHidd Pointer to HIDDFunction instance.
+ * \param pMap  Pointer to the function map, pClassDescriptor being the HID
+ *              descriptor.
+ */
+void HIDDFunction_MapInterface(HIDDFunction * pHidd,
+                               const USBDFunctionMap * pMap)
+{
+    pHidd->bInterface     = pMap->bInterface;
+    pHidd->bPipeIN        = pMap->bEpIn;
+    pHidd->bPipeOUT       = pMap->bEpOut;
+    pHidd->wInPacketSize  = pMap->wMaxPacketIn;
+    pHidd->pHidDescriptor = (HIDDescriptor*)pMap->pClassDescriptor;
+}
+
 /**
  * Start polling interrupt OUT pipe
  * (output report, host to device) if there is.
@@ -515,6 +645,16 @@ USBGenericDescriptor *HIDDFunction_ParseInterface(HIDDFunction * pHidd,
  */
 uint32_t HIDDFunction_StartPollingOutputs(HIDDFunction * pHidd)
 {
+    HIDDReportQueue *pQ = pHidd->pOutQueue;
+
+    /* Receive in the output queue */
+    if (pQ)
+        return USBD_Read(pHidd->bPipeOUT,
+                         &pQ->pBuffer[pQ->wTail * pQ->wReportSize],
+                         pQ->wReportSize,
+                         (TransferCallback)HIDDFunction_QueueReceived,
+                         (void*)pHidd);
+
     /* No report, do nothing */
     if (pHidd->bOutputListSize == 0
         || pHidd->pOutputList == 0)
@@ -535,6 +675,17 @@ uint32_t HIDDFunction_StartPollingOutputs(HIDDFunction * pHidd)
  */
 uint32_t HIDDFunction_StartSendingInputs(HIDDFunction * pHidd)
 {
+    uint32_t primask;
+
+    /* Send from the input queue */
+    if (pHidd->pInQueue) {
+        primask = __get_PRIMASK();
+        __disable_irq();
+        HIDDFunction_QueueStartInput(pHidd);
+        __set_PRIMASK(primask);
+        return USBRC_SUCCESS;
+    }
+
     /* No report, do nothing */
     if (pHidd->bInputListSize == 0
         || pHidd->pInputList == 0)
@@ -691,5 +842,109 @@ void HIDDFunction_InitializeReport(HIDDReport* pReport,
     pReport->pArg = pArg;
 }
 
+/**
+ * Initialize a report queue.
+ * \param pQueue      Pointer to HIDDReportQueue instance.
+ * \param pBuffer     Buffer of wNumSlots reports.
+ * \param wReportSize Size of a report in bytes.
+ * \param wNumSlots   Number of report slots, holding wNumSlots-1 reports.
+ */
+void HIDDFunction_InitializeQueue(HIDDReportQueue * pQueue,
+                                  uint8_t * pBuffer,
+                                  uint16_t wReportSize,
+                                  uint16_t wNumSlots)
+{
+    pQueue->pBuffer = pBuffer;
+    pQueue->wReportSize = wReportSize;
+    pQueue->wNumSlots = wNumSlots;
+    pQueue->wHead = 0;
+    pQueue->wTail = 0;
+    pQueue->wInTransfer = 0;
+    pQueue->dwDropped = 0;
+    pQueue->dwUnderruns = 0;
+}
+
+/**
+ * Streams the reports through queues instead of the report lists.
+ * Must be invoked before the configuration, the output queue being polled
+ * by HIDDFunction_StartPollingOutputs().
+ * \param pHidd     Pointer to HIDDFunction instance.
+ * \param pInQueue  Input report queue, 0 to use the input list.
+ * \param pOutQueue Output report queue, 0 to use the output list.
+ */
+void HIDDFunction_SetQueues(HIDDFunction * pHidd,
+                            HIDDReportQueue * pInQueue,
+                            HIDDReportQueue * pOutQueue)
+{
+    pHidd->pInQueue = pInQueue;
+    pHidd->pOutQueue = pOutQueue;
+}
+
+/**
+ * Copies an input report at the end of the input queue and starts sending
+ * if the IN pipe is idle.
+ * \param pHidd   Pointer to HIDDFunction instance.
+ * \param pReport Report data, wReportSize bytes.
+ * \return USBRC_SUCCESS, USBRC_BUSY if the queue is full (report dropped)
+ *         or USBRC_PARAM_ERR if there is no input queue.
+ */
+uint32_t HIDDFunction_QueueInput(HIDDFunction * pHidd,
+                                 const void * pReport)
+{
+    HIDDReportQueue *pQ = pHidd->pInQueue;
+    uint16_t wNext;
+    uint32_t primask;
+
+    if (pQ == 0)
+        return USBRC_PARAM_ERR;
+
+    /* The slot at the tail is free, the IN pipe only reads up to the tail */
+    wNext = (pQ->wTail + 1) % pQ->wNumSlots;
+    if (wNext == pQ->wHead) {
+        pQ->dwDropped ++;
+        return USBRC_BUSY;
+    }
+    memcpy(&pQ->pBuffer[pQ->wTail * pQ->wReportSize],
+           pReport, pQ->wReportSize);
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    pQ->wTail = wNext;
+    if (USBD_GetState() >= USBD_STATE_CONFIGURED)
+        HIDDFunction_QueueStartInput(pHidd);
+    __set_PRIMASK(primask);
+
+    return USBRC_SUCCESS;
+}
+
+/**
+ * Copies the oldest output report of the output queue.
+ * \param pHidd   Pointer to HIDDFunction instance.
+ * \param pReport Buffer of wReportSize bytes, 0 to get the number of
+ *                queued reports only.
+ * \return Number of bytes copied (number of reports when pReport is 0).
+ */
+uint32_t HIDDFunction_DequeueOutput(HIDDFunction * pHidd,
+                                    void * pReport)
+{
+    HIDDReportQueue *pQ = pHidd->pOutQueue;
+    uint16_t wTail;
+
+    if (pQ == 0)
+        return 0;
+
+    wTail = pQ->wTail;
+    if (pReport == 0)
+        return (wTail + pQ->wNumSlots - pQ->wHead) % pQ->wNumSlots;
+    if (wTail == pQ->wHead)
+        return 0;
+
+    memcpy(pReport, &pQ->pBuffer[pQ->wHead * pQ->wReportSize],
+           pQ->wReportSize);
+    pQ->wHead = (pQ->wHead + 1) % pQ->wNumSlots;
+
+    return pQ->wReportSize;
+}
+
 /**@}*/
 
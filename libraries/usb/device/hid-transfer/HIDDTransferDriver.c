@@ -287,6 +287,10 @@ void HIDDTransferDriver_ConfigurationChangedHandler(uint8_t cfgnum)
 
         /* Start polling for Output Reports */
         HIDDFunction_StartPollingOutputs(pHidd);
+
+        /* Send the input reports queued before the configuration */
+        if (pHidd->pInQueue)
+            HIDDFunction_StartSendingInputs(pHidd);
     }
 }
 
@@ -463,6 +467,45 @@ uint8_t HIDDTransferDriver_Write(const void *pData,
                       fCallback, pArg);
 }
 
+/**
+ * Streams the reports through queues: the input reports written by
+ * HIDDTransferDriver_QueueWrite() are sent across frames and the output
+ * reports are received in a ring read by HIDDTransferDriver_QueueRead().
+ * The queue reports must be HIDDTransferDriver_REPORTSIZE bytes long.
+ * Must be invoked after HIDDTransferDriver_Initialize() and before the
+ * device is configured.
+ * \param pInQueue  Input report queue, 0 to write the reports directly.
+ * \param pOutQueue Output report queue, 0 to use HIDDTransferDriver_Read().
+ */
+void HIDDTransferDriver_SetQueues(HIDDReportQueue *pInQueue,
+                                  HIDDReportQueue *pOutQueue)
+{
+    HIDDFunction_SetQueues(&hiddTransferDriver.hidFunction,
+                           pInQueue, pOutQueue);
+}
+
+/**
+ * Queues an input report for the interrupt IN EP.
+ * \param pReport Report data, HIDDTransferDriver_REPORTSIZE bytes.
+ * \return USBRC_SUCCESS, or USBRC_BUSY if the queue is full and the report
+ *         is dropped.
+ */
+uint32_t HIDDTransferDriver_QueueWrite(const void *pReport)
+{
+    return HIDDFunction_QueueInput(&hiddTransferDriver.hidFunction, pReport);
+}
+
+/**
+ * Takes the oldest output report received on the interrupt OUT EP.
+ * \param pReport Buffer of HIDDTransferDriver_REPORTSIZE bytes, 0 to get
+ *                the number of queued reports only.
+ * \return Number of bytes read (reports queued when pReport is 0).
+ */
+uint32_t HIDDTransferDriver_QueueRead(void *pReport)
+{
+    return HIDDFunction_DequeueOutput(&hiddTransferDriver.hidFunction, pReport);
+}
+
 /**
  * Starts a remote wake-up sequence if the host has explicitely enabled it
  * by sending the appropriate SET_FEATURE request.
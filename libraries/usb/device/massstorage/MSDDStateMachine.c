@@ -418,6 +418,26 @@ static unsigned char MSDD_ProcessCommand(MSDDriver * pMsdDriver)
     return isCommandComplete;
 }
 
+/**
+ * Writes the cached blocks of all the LUNs back to their media.
+ * \param  pMsdDriver Pointer to a MSDDriver instance
+ * \param  maxRuns    Maximum number of runs to write per LUN, 0 for all
+ */
+void MSDD_DrainCaches(MSDDriver * pMsdDriver, uint32_t maxRuns)
+{
+    uint32_t i;
+
+    if (pMsdDriver->luns == 0) {
+
+        return;
+    }
+
+    for (i = 0; i <= pMsdDriver->maxLun; i ++) {
+
+        LUN_DrainCache(&(pMsdDriver->luns[i]), maxRuns);
+    }
+}
+
 /**
  * State machine for the MSD %device driver
  * \param  pMsdDriver Pointer to a MSDDriver instance
@@ -429,6 +449,17 @@ void MSDD_StateMachine(MSDDriver * pMsdDriver)
     MSCsw           *csw = &(commandState->csw);
     MSDTransfer     *transfer = &(commandState->transfer);
     unsigned char   status;
+    unsigned char   i;
+
+    /* Write the LUN caches back while the commands are processed, the LUN
+       functions wait for the media they access */
+    if (pMsdDriver->luns) {
+
+        for (i = 0; i <= pMsdDriver->maxLun; i ++) {
+
+            LUN_DrainCacheStep(&(pMsdDriver->luns[i]));
+        }
+    }
 
     /* Identify current driver state */
     switch (pMsdDriver->state) {
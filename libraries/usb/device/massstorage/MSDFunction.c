@@ -198,6 +198,25 @@ void MSDFunction_Configure(USBGenericDescriptor *pDescriptors,
     MSDFunction_Reset();
 }
 
+/**
+ * Invoked when the configuration of the device changes, for a composite
+ * device giving the function map instead of the descriptors.
+ * Pass endpoints and resets the mass storage function.
+ * \pMap Pointer to the function map of the mass storage function.
+ */
+void MSDFunction_ConfigureMap(const USBDFunctionMap *pMap)
+{
+    MSDDriver *pMsdDriver = &msdFunction;
+
+    TRACE_INFO_WP("MSDFunMap ");
+
+    pMsdDriver->interfaceNb = pMap->bInterface;
+    pMsdDriver->commandState.pipeIN  = pMap->bEpIn;
+    pMsdDriver->commandState.pipeOUT = pMap->bEpOut;
+
+    MSDFunction_Reset();
+}
+
 /**
  * Handler for incoming SETUP requests on default Control endpoint 0.
  *
@@ -298,11 +317,13 @@ uint32_t MSDFunction_RequestHandler(
 }
 
 /**
- * State machine for the MSD driver
+ * State machine for the MSD driver. While the device is suspended or not
+ * configured, the LUN write caches are written back to the media.
  */
 void MSDFunction_StateMachine(void)
 {
-    if (USBD_GetState() < USBD_STATE_CONFIGURED){}
+    if (USBD_GetState() < USBD_STATE_CONFIGURED)
+        MSDD_DrainCaches(&msdFunction, 0);
     else MSDD_StateMachine(&msdFunction);
 
 }
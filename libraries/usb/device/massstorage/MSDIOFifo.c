@@ -70,6 +70,42 @@ void MSDIOFifo_Init(MSDIOFifo *pFifo,
 
     pFifo->fullCnt = 0;
     pFifo->nullCnt = 0;
+
+#if  defined(MSDIO_READ10_CHUNK_SIZE) || defined(MSDIO_WRITE10_CHUNK_SIZE)
+    pFifo->mediaNdx = 0;
+    pFifo->mediaTotal = 0;
+    pFifo->chunkHead = 0;
+    pFifo->chunkCount = 0;
+#endif
+}
+
+#if  defined(MSDIO_READ10_CHUNK_SIZE) || defined(MSDIO_WRITE10_CHUNK_SIZE)
+/**
+ * \brief  Returns the chunk size to use with the FIFO so that the ring
+ *         buffer holds MSDIO_PIPELINE_DEPTH chunks: the media side can then
+ *         work on MSDIO_PIPELINE_DEPTH chunks while the USB side is still
+ *         busy with the previous ones.
+ *         The result is a multiple of the block size which divides the
+ *         buffer size, and at least one block.
+ * \param  pFifo    Pointer to the MSDIOFifo instance (blockSize set)
+ * \param  maxChunk Preferred (maximum) chunk size in bytes
+ */
+unsigned int MSDIOFifo_GetChunkSize(const MSDIOFifo *pFifo,
+                                    unsigned int maxChunk)
+{
+    unsigned int blockSize = pFifo->blockSize;
+    unsigned int chunk = maxChunk - (maxChunk % blockSize);
+
+    while (chunk > blockSize
+           && (   chunk * MSDIO_PIPELINE_DEPTH > pFifo->bufferSize
+               || (pFifo->bufferSize % chunk) != 0)) {
+
+        chunk -= blockSize;
+    }
+    if (chunk < blockSize) chunk = blockSize;
+
+    return chunk;
 }
+#endif
 
 /**@}*/
@@ -41,6 +41,8 @@
 #include <USBLib_Trace.h>
 #include <USBD.h>
 
+#include <string.h>
+
 /*------------------------------------------------------------------------------
  *         Constants
  *------------------------------------------------------------------------------*/
@@ -98,6 +100,447 @@ static SBCInquiryData inquiryData = {
      0, 0} /* Reserved */
 };
 
+/*------------------------------------------------------------------------------
+ *         Internal functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * \brief  Returns the cache slot holding a LUN block, or numBlocks if the
+ *         block is not cached. The slots being written are not searched.
+ * \param  cache        Pointer to a MSDLunCache instance
+ * \param  blockAddress LUN block address to look for
+ */
+static uint16_t LUN_FindCacheSlot(MSDLunCache *cache, uint32_t blockAddress)
+{
+    uint16_t i, slot;
+
+    for (i = cache->inFlight; i < cache->count; i ++) {
+
+        slot = (cache->head + i) % cache->numBlocks;
+        if (cache->pBlockAddress[slot] == blockAddress) {
+
+            return slot;
+        }
+    }
+
+    return cache->numBlocks;
+}
+
+/**
+ * \brief  Tells if a range of LUN blocks is partly in the cache.
+ * \param  cache        Pointer to a MSDLunCache instance
+ * \param  blockAddress First block address of the range
+ * \param  length       Number of blocks of the range
+ */
+static uint8_t LUN_CacheOverlaps(MSDLunCache *cache,
+                                 uint32_t    blockAddress,
+                                 uint32_t    length)
+{
+    uint16_t i;
+    uint32_t cached;
+
+    for (i = 0; i < cache->count; i ++) {
+
+        cached = cache->pBlockAddress[(cache->head + i) % cache->numBlocks];
+        if (cached != LUN_CACHE_FREE
+            && cached >= blockAddress && cached < blockAddress + length) {
+
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * \brief  Invoked when the media has written a cache run.
+ * \param  cache        Pointer to the MSDLunCache instance
+ * \param  status       Media operation result code
+ * \param  transferred  Number of bytes transferred
+ * \param  remaining    Number of bytes not transferred
+ */
+static void LUN_CacheRunCallback(MSDLunCache *cache,
+                                 uint8_t     status,
+                                 uint32_t    transferred,
+                                 uint32_t    remaining)
+{
+    cache->runStatus = status;
+    cache->runDone = 1;
+}
+
+/**
+ * \brief  Ends the cache run being written: once the media is done, the
+ *         slots of the run are released.
+ * \param  lun          Pointer to a MSDLun instance with a write cache
+ * \param  wait         1 to wait for the media, 0 to return at once
+ * \return USBD_STATUS_LOCKED while the run is not written, else the
+ *         operation result code
+ */
+static uint32_t LUN_EndCacheRun(MSDLun *lun, uint8_t wait)
+{
+    MSDLunCache *cache = lun->cache;
+
+    if (cache->inFlight == 0) {
+
+        return USBD_STATUS_SUCCESS;
+    }
+
+    while (!cache->runDone) {
+
+        if (!wait) {
+
+            return USBD_STATUS_LOCKED;
+        }
+        MED_Handler(lun->media);
+    }
+
+    /* Failed run is kept for a later retry */
+    if (cache->runStatus != MED_STATUS_SUCCESS) {
+
+        TRACE_WARNING("LUN_DrainCache: Cannot write media\n\r");
+        cache->inFlight = 0;
+        return USBD_STATUS_ABORTED;
+    }
+
+    cache->head = (cache->head + cache->inFlight) % cache->numBlocks;
+    cache->count -= cache->inFlight;
+    cache->inFlight = 0;
+    if (cache->count == 0) {
+
+        cache->head = 0;
+    }
+
+    return USBD_STATUS_SUCCESS;
+}
+
+/**
+ * \brief  Starts writing the oldest run of consecutive cached blocks to the
+ *         media, after the end of the previous run.
+ * \param  lun          Pointer to a MSDLun instance with a write cache
+ * \param  wait         1 to wait for the media and for the end of the
+ *                      write, 0 to return at once
+ * \return USBD_STATUS_LOCKED when the media is busy, else the operation
+ *         result code
+ */
+static uint32_t LUN_WriteCacheRun(MSDLun *lun, uint8_t wait)
+{
+    MSDLunCache *cache = lun->cache;
+    uint32_t blockBytes = lun->blockSize * lun->media->blockSize;
+    uint32_t blockAddress;
+    uint32_t status;
+    uint16_t n;
+
+    status = LUN_EndCacheRun(lun, wait);
+    if (status != USBD_STATUS_SUCCESS) {
+
+        return status;
+    }
+
+    /* Skip the dropped slots */
+    while (cache->count
+           && cache->pBlockAddress[cache->head] == LUN_CACHE_FREE) {
+
+        cache->head = (cache->head + 1) % cache->numBlocks;
+        cache->count --;
+    }
+    if (cache->count == 0) {
+
+        cache->head = 0;
+        return USBD_STATUS_SUCCESS;
+    }
+
+    /* The media may be shared with another LUN */
+    while (lun->media->state == MED_STATE_BUSY) {
+
+        if (!wait) {
+
+            return USBD_STATUS_LOCKED;
+        }
+        MED_Handler(lun->media);
+    }
+
+    /* Gather the following slots while the blocks are consecutive, up to
+       the end of the buffer */
+    blockAddress = cache->pBlockAddress[cache->head];
+    for (n = 1; n < cache->count && cache->head + n < cache->numBlocks; n ++) {
+
+        if (cache->pBlockAddress[cache->head + n] != blockAddress + n) {
+
+            break;
+        }
+    }
+
+    TRACE_INFO_WP("LUNDrain(%u,%u) ", blockAddress, n);
+
+    cache->inFlight = n;
+    cache->runDone = 0;
+    if (MED_Write(lun->media,
+                  lun->baseAddress + blockAddress * lun->blockSize,
+                  &cache->pBuffer[cache->head * blockBytes],
+                  n * lun->blockSize,
+                  (MediaCallback) LUN_CacheRunCallback,
+                  cache) != MED_STATUS_SUCCESS) {
+
+        TRACE_WARNING("LUN_DrainCache: Cannot write media\n\r");
+        cache->inFlight = 0;
+        return USBD_STATUS_ABORTED;
+    }
+
+    if (!wait) {
+
+        return USBD_STATUS_SUCCESS;
+    }
+
+    return LUN_EndCacheRun(lun, 1);
+}
+
+/**
+ * \brief  Waits until the media of a LUN can be accessed: the cache run of
+ *         the LUN, or any other operation on a shared media, is finished.
+ *         A failed run stays in the cache.
+ * \param  lun          Pointer to a MSDLun instance
+ */
+static void LUN_WaitMedia(MSDLun *lun)
+{
+    if (lun->cache) {
+
+        LUN_EndCacheRun(lun, 1);
+    }
+    while (lun->media->state == MED_STATE_BUSY) {
+
+        MED_Handler(lun->media);
+    }
+}
+
+/**
+ * \brief  Makes the media of a LUN available for a new operation.
+ * \param  lun          Pointer to a MSDLun instance
+ * \param  wait         1 to wait for the media, 0 to return at once
+ * \return USBD_STATUS_LOCKED while the cache run of the LUN is written, else
+ *         USBD_STATUS_SUCCESS
+ */
+static uint32_t LUN_GetMedia(MSDLun *lun, uint8_t wait)
+{
+    if (wait) {
+
+        LUN_WaitMedia(lun);
+    }
+    else if (lun->cache && LUN_EndCacheRun(lun, 0) == USBD_STATUS_LOCKED) {
+
+        return USBD_STATUS_LOCKED;
+    }
+
+    return USBD_STATUS_SUCCESS;
+}
+
+/**
+ * \brief  Copies blocks to the write cache of a LUN, the cache being drained
+ *         when it is full.
+ * \param  lun          Pointer to a MSDLun instance with a write cache
+ * \param  blockAddress First block address to write
+ * \param  data         Pointer to the data to write
+ * \param  length       Number of blocks to write
+ * \return Operation result code
+ */
+static uint32_t LUN_WriteCache(MSDLun   *lun,
+                               uint32_t blockAddress,
+                               uint8_t  *data,
+                               uint32_t length)
+{
+    MSDLunCache *cache = lun->cache;
+    uint32_t blockBytes = lun->blockSize * lun->media->blockSize;
+    uint16_t slot;
+
+    for (; length; length --, blockAddress ++, data += blockBytes) {
+
+        /* A cached block is updated in place */
+        slot = LUN_FindCacheSlot(cache, blockAddress);
+        if (slot == cache->numBlocks) {
+
+            if (cache->count == cache->numBlocks
+                && LUN_WriteCacheRun(lun, 1) != USBD_STATUS_SUCCESS) {
+
+                return USBD_STATUS_ABORTED;
+            }
+            slot = (cache->head + cache->count) % cache->numBlocks;
+            cache->pBlockAddress[slot] = blockAddress;
+            cache->count ++;
+        }
+
+        MEM_Copy(&cache->pBuffer[slot * blockBytes], data, blockBytes);
+    }
+
+    return USBD_STATUS_SUCCESS;
+}
+
+/**
+ * \brief  Starts writing data on a LUN, see LUN_Write() and LUN_QueueWrite().
+ * \param  lun          Pointer to a MSDLun instance
+ * \param  blockAddress First block address to write
+ * \param  data         Pointer to the data to write
+ * \param  length       Number of blocks to write
+ * \param  callback     Optional callback to invoke when the write finishes
+ * \param  argument     Optional callback argument.
+ * \param  wait         1 to wait for the media, 0 to return at once
+ * \return Operation result code
+ */
+static uint32_t LUN_StartWrite(MSDLun           *lun,
+                               uint32_t         blockAddress,
+                               void             *data,
+                               uint32_t         length,
+                               TransferCallback callback,
+                               void             *argument,
+                               uint8_t          wait)
+{
+    uint32_t  medBlk, medLen;
+    uint8_t status;
+
+    TRACE_INFO_WP("LUNWrite(%u) ", blockAddress);
+
+    /* Check that the data is not too big */
+    if ((length + blockAddress) * lun->blockSize > lun->size) {
+
+        TRACE_WARNING("LUN_Write: Data too big\n\r");
+        status = USBD_STATUS_ABORTED;
+    }
+    else if (lun->media == 0 || lun->status != LUN_READY) {
+
+        TRACE_WARNING("LUN_Write: Media not ready\n\r");
+        status = USBD_STATUS_ABORTED;
+    }
+    else if (lun->protected) {
+        TRACE_WARNING("LUN_Write: LUN is readonly\n\r");
+        status = USBD_STATUS_ABORTED;
+    }
+    else if (lun->cache) {
+
+        status = LUN_WriteCache(lun, blockAddress, (uint8_t *) data, length);
+        if (status == USBD_STATUS_SUCCESS && callback) {
+
+            callback(argument, MED_STATUS_SUCCESS, 0, 0);
+        }
+    }
+    else if (LUN_GetMedia(lun, wait) != USBD_STATUS_SUCCESS) {
+
+        status = USBD_STATUS_LOCKED;
+    }
+    else {
+
+        /* Compute write start address */
+        medBlk = lun->baseAddress + blockAddress * lun->blockSize;
+        medLen = length * lun->blockSize;
+
+        /* Start write operation */
+        status = MED_Write(lun->media,
+                           medBlk,
+                           data,
+                           medLen,
+                           (MediaCallback) callback,
+                           argument);
+
+        /* Check operation result code */
+        if (status == MED_STATUS_SUCCESS) {
+
+            status = USBD_STATUS_SUCCESS;
+        }
+        else if (status == MED_STATUS_BUSY && !wait) {
+
+            /* Request queue of the media is full */
+            MED_Handler(lun->media);
+            status = USBD_STATUS_LOCKED;
+        }
+        else {
+
+            TRACE_WARNING("LUN_Write: Cannot write media\n\r");
+            status = USBD_STATUS_ABORTED;
+        }
+    }
+
+    return status;
+}
+
+/**
+ * \brief  Starts reading data from a LUN, see LUN_Read() and LUN_QueueRead().
+ * \param  lun          Pointer to a MSDLun instance
+ * \param  blockAddress First block address to read
+ * \param  data         Pointer to a data buffer in which to store the data
+ * \param  length       Number of blocks to read
+ * \param  callback     Optional callback to invoke when the read finishes
+ * \param  argument     Optional callback argument.
+ * \param  wait         1 to wait for the media, 0 to return at once
+ * \return Operation result code
+ */
+static uint32_t LUN_StartRead(MSDLun           *lun,
+                              uint32_t         blockAddress,
+                              void             *data,
+                              uint32_t         length,
+                              TransferCallback callback,
+                              void             *argument,
+                              uint8_t          wait)
+{
+    uint32_t medBlk, medLen;
+    uint8_t status;
+
+    /* Check that the data is not too big */
+    if ((length + blockAddress) * lun->blockSize > lun->size) {
+
+        TRACE_WARNING("LUN_Read: Area: (%d + %d)*%d > %d\n\r",
+                      (int)length, (int)blockAddress, (int)lun->blockSize, (int)lun->size);
+        status = USBD_STATUS_ABORTED;
+    }
+    else if (lun->media == 0 || lun->status != LUN_READY) {
+
+        TRACE_WARNING("LUN_Read: Media not present\n\r");
+        status = USBD_STATUS_ABORTED;
+    }
+    else if (lun->cache
+             && LUN_CacheOverlaps(lun->cache, blockAddress, length)
+             && LUN_DrainCache(lun, 0) != USBD_STATUS_SUCCESS) {
+
+        TRACE_WARNING("LUN_Read: Cannot drain cache\n\r");
+        status = USBD_STATUS_ABORTED;
+    }
+    else if (LUN_GetMedia(lun, wait) != USBD_STATUS_SUCCESS) {
+
+        status = USBD_STATUS_LOCKED;
+    }
+    else {
+
+        TRACE_INFO_WP("LUNRead(%u) ", blockAddress);
+
+        /* Compute read start address */
+        medBlk = lun->baseAddress + (blockAddress * lun->blockSize);
+        medLen = length * lun->blockSize;
+
+        /* Start write operation */
+        status = MED_Read(lun->media,
+                          medBlk,
+                          data,
+                          medLen,
+                          (MediaCallback) callback,
+                          argument);
+
+        /* Check result code */
+        if (status == MED_STATUS_SUCCESS) {
+
+            status = USBD_STATUS_SUCCESS;
+        }
+        else if (status == MED_STATUS_BUSY && !wait) {
+
+            /* Request queue of the media is full */
+            MED_Handler(lun->media);
+            status = USBD_STATUS_LOCKED;
+        }
+        else {
+
+            TRACE_WARNING("LUN_Read: Cannot read media\n\r");
+            status = USBD_STATUS_ABORTED;
+        }
+    }
+
+    return status;
+}
+
 /*------------------------------------------------------------------------------
  *         Exported functions
  *------------------------------------------------------------------------------*/
@@ -166,7 +609,14 @@ void LUN_Init(MSDLun    *lun,
     STORE_DWORDB(0, lun->readCapacityData.pLogicalBlockAddress);
     STORE_DWORDB(0, lun->readCapacityData.pLogicalBlockLength);
 
-    /* Initialize LUN */
+    /* Initialize LUN, the write cache is kept but emptied */
+
+    if (lun->cache) {
+
+        lun->cache->head = 0;
+        lun->cache->count = 0;
+        lun->cache->inFlight = 0;
+    }
 
     lun->media = media;
     if (media == 0) {
@@ -234,7 +684,7 @@ void LUN_Init(MSDLun    *lun,
 }
 
 /**
- * \brief  Eject the media from a LUN
+ * \brief  Eject the media from a LUN, the write cache is drained first.
  * \param  lun          Pointer to the MSDLun instance to initialize
  * \return Operation result code
  */
@@ -248,6 +698,12 @@ uint32_t LUN_Eject(MSDLun *lun)
             return USBD_STATUS_LOCKED;
         }
 
+        /* Write the cached blocks back */
+        if (LUN_DrainCache(lun, 0) != USBD_STATUS_SUCCESS) {
+
+            return USBD_STATUS_ABORTED;
+        }
+
         /* Remove the link of the media */
         lun->media = 0;
     }
@@ -259,6 +715,8 @@ uint32_t LUN_Eject(MSDLun *lun)
 
 /**
  * \brief  Writes data on the a LUN starting at the specified block address.
+ *         With a write cache, the data is copied to the cache and the
+ *         callback is invoked before returning.
  * \param  lun          Pointer to a MSDLun instance
  * \param  blockAddress First block address to write
  * \param  data         Pointer to the data to write
@@ -274,116 +732,265 @@ uint32_t LUN_Write(MSDLun        *lun,
                         TransferCallback   callback,
                         void         *argument)
 {
-    uint32_t  medBlk, medLen;
-    uint8_t status;
+    return LUN_StartWrite(lun, blockAddress, data, length,
+                          callback, argument, 1);
+}
 
-    TRACE_INFO_WP("LUNWrite(%u) ", blockAddress);
+/**
+ * \brief  Same as LUN_Write(), but does not wait for the media: the write is
+ *         added to the requests already in flight when the media has a
+ *         request queue.
+ * \param  lun          Pointer to a MSDLun instance
+ * \param  blockAddress First block address to write
+ * \param  data         Pointer to the data to write
+ * \param  length       Number of blocks to write
+ * \param  callback     Optional callback to invoke when the write finishes
+ * \param  argument     Optional callback argument.
+ * \return USBD_STATUS_LOCKED when the media cannot take the request yet,
+ *         else the operation result code
+ */
+uint32_t LUN_QueueWrite(MSDLun           *lun,
+                        uint32_t         blockAddress,
+                        void             *data,
+                        uint32_t         length,
+                        TransferCallback callback,
+                        void             *argument)
+{
+    return LUN_StartWrite(lun, blockAddress, data, length,
+                          callback, argument, 0);
+}
 
-    /* Check that the data is not too big */
+/**
+ * \brief  Reads data from a LUN, starting at the specified block address.
+ * \param  lun          Pointer to a MSDLun instance
+ * \param  blockAddress First block address to read
+ * \param  data         Pointer to a data buffer in which to store the data
+ * \param  length       Number of blocks to read
+ * \param  callback     Optional callback to invoke when the read finishes
+ * \param  argument     Optional callback argument.
+ * \return Operation result code
+ */
+uint32_t LUN_Read(MSDLun        *lun,
+                       uint32_t blockAddress,
+                       void         *data,
+                       uint32_t length,
+                       TransferCallback   callback,
+                       void         *argument)
+{
+    return LUN_StartRead(lun, blockAddress, data, length,
+                         callback, argument, 1);
+}
+
+/**
+ * \brief  Same as LUN_Read(), but does not wait for the media: the read is
+ *         added to the requests already in flight when the media has a
+ *         request queue.
+ * \param  lun          Pointer to a MSDLun instance
+ * \param  blockAddress First block address to read
+ * \param  data         Pointer to a data buffer in which to store the data
+ * \param  length       Number of blocks to read
+ * \param  callback     Optional callback to invoke when the read finishes
+ * \param  argument     Optional callback argument.
+ * \return USBD_STATUS_LOCKED when the media cannot take the request yet,
+ *         else the operation result code
+ */
+uint32_t LUN_QueueRead(MSDLun           *lun,
+                       uint32_t         blockAddress,
+                       void             *data,
+                       uint32_t         length,
+                       TransferCallback callback,
+                       void             *argument)
+{
+    return LUN_StartRead(lun, blockAddress, data, length,
+                         callback, argument, 0);
+}
+
+/**
+ * \brief  Writes the data cached by the LUN and its media to the medium
+ *         (SYNCHRONIZE CACHE).
+ * \param  lun          Pointer to a MSDLun instance
+ * \return Operation result code
+ */
+uint32_t LUN_Flush(MSDLun *lun)
+{
+    if (lun->media == 0 || lun->status != LUN_READY) {
+
+        TRACE_WARNING("LUN_Flush: Media not present\n\r");
+        return USBD_STATUS_ABORTED;
+    }
+
+    if (LUN_DrainCache(lun, 0) != USBD_STATUS_SUCCESS) {
+
+        TRACE_WARNING("LUN_Flush: Cannot drain cache\n\r");
+        return USBD_STATUS_ABORTED;
+    }
+
+    LUN_WaitMedia(lun);
+
+    if (MED_Ioctl(lun->media, MED_IOCTL_SYNC, 0) != MED_STATUS_SUCCESS) {
+
+        TRACE_WARNING("LUN_Flush: Cannot flush media\n\r");
+        return USBD_STATUS_ABORTED;
+    }
+
+    return USBD_STATUS_SUCCESS;
+}
+
+/**
+ * \brief  Tells the media of a LUN that blocks are no longer used (UNMAP).
+ * \param  lun          Pointer to a MSDLun instance
+ * \param  blockAddress First block address to discard
+ * \param  length       Number of blocks to discard
+ * \return Operation result code
+ */
+uint32_t LUN_Discard(MSDLun   *lun,
+                     uint32_t blockAddress,
+                     uint32_t length)
+{
+    MEDDiscard range;
+    uint32_t   i;
+    uint16_t   slot;
+
+    /* Check that the range is inside the LUN */
     if ((length + blockAddress) * lun->blockSize > lun->size) {
 
-        TRACE_WARNING("LUN_Write: Data too big\n\r");
-        status = USBD_STATUS_ABORTED;
+        TRACE_WARNING("LUN_Discard: Range too big\n\r");
+        return USBD_STATUS_ABORTED;
     }
     else if (lun->media == 0 || lun->status != LUN_READY) {
 
-        TRACE_WARNING("LUN_Write: Media not ready\n\r");
-        status = USBD_STATUS_ABORTED;
+        TRACE_WARNING("LUN_Discard: Media not present\n\r");
+        return USBD_STATUS_ABORTED;
     }
     else if (lun->protected) {
-        TRACE_WARNING("LUN_Write: LUN is readonly\n\r");
-        status = USBD_STATUS_ABORTED;
+
+        TRACE_WARNING("LUN_Discard: LUN is readonly\n\r");
+        return USBD_STATUS_ABORTED;
     }
-    else {
 
-        /* Compute write start address */
-        medBlk = lun->baseAddress + blockAddress * lun->blockSize;
-        medLen = length * lun->blockSize;
+    TRACE_INFO_WP("LUNDiscard(%u) ", blockAddress);
 
-        /* Start write operation */
-        status = MED_Write(lun->media,
-                           medBlk,
-                           data,
-                           medLen,
-                           (MediaCallback) callback,
-                           argument);
+    /* The cached blocks of the range are dropped */
+    if (lun->cache) {
 
-        /* Check operation result code */
-        if (status == MED_STATUS_SUCCESS) {
+        for (i = 0; i < length; i ++) {
 
-            status = USBD_STATUS_SUCCESS;
+            slot = LUN_FindCacheSlot(lun->cache, blockAddress + i);
+            if (slot != lun->cache->numBlocks) {
+
+                lun->cache->pBlockAddress[slot] = LUN_CACHE_FREE;
+            }
         }
-        else {
+    }
 
-            TRACE_WARNING("LUN_Write: Cannot write media\n\r");
-            status = USBD_STATUS_ABORTED;
+    LUN_WaitMedia(lun);
+
+    range.address = lun->baseAddress + blockAddress * lun->blockSize;
+    range.length = length * lun->blockSize;
+    if (MED_Ioctl(lun->media, MED_IOCTL_DISCARD, &range) != MED_STATUS_SUCCESS) {
+
+        TRACE_WARNING("LUN_Discard: Cannot discard media\n\r");
+        return USBD_STATUS_ABORTED;
+    }
+
+    return USBD_STATUS_SUCCESS;
+}
+
+/**
+ * \brief  Gives a write-back cache to a LUN, or removes it. Once the cache is
+ *         set, LUN_Write acknowledges the blocks as soon as they are copied in
+ *         the cache. The cache is kept by LUN_Init.
+ * \param  lun            Pointer to a MSDLun instance
+ * \param  cache          Pointer to the MSDLunCache instance, 0 to write
+ *                        through again (the current cache is drained)
+ * \param  buffer         Cache buffer, numBlocks LUN blocks long (RAM or PSRAM)
+ * \param  blockAddresses Table of numBlocks block addresses
+ * \param  numBlocks      Number of LUN blocks the cache holds
+ * \return Operation result code
+ */
+uint32_t LUN_SetWriteCache(MSDLun      *lun,
+                           MSDLunCache *cache,
+                           uint8_t     *buffer,
+                           uint32_t    *blockAddresses,
+                           uint16_t    numBlocks)
+{
+    if (lun->cache && lun->media
+        && LUN_DrainCache(lun, 0) != USBD_STATUS_SUCCESS) {
+
+        return USBD_STATUS_ABORTED;
+    }
+
+    if (cache) {
+
+        if (buffer == 0 || blockAddresses == 0 || numBlocks == 0) {
+
+            return USBD_STATUS_INVALID_PARAMETER;
         }
+        cache->pBuffer = buffer;
+        cache->pBlockAddress = blockAddresses;
+        cache->numBlocks = numBlocks;
+        cache->head = 0;
+        cache->count = 0;
+        cache->inFlight = 0;
+        cache->runDone = 0;
     }
+    lun->cache = cache;
 
-    return status;
+    return USBD_STATUS_SUCCESS;
 }
 
 /**
- * \brief  Reads data from a LUN, starting at the specified block address.
+ * \brief  Writes the cached blocks of a LUN back to its media, one run of
+ *         consecutive blocks at a time, and waits for the end of the writes.
  * \param  lun          Pointer to a MSDLun instance
- * \param  blockAddress First block address to read
- * \param  data         Pointer to a data buffer in which to store the data
- * \param  length       Number of blocks to read
- * \param  callback     Optional callback to invoke when the read finishes
- * \param  argument     Optional callback argument.
+ * \param  maxRuns      Maximum number of runs to write, 0 for the whole cache
  * \return Operation result code
  */
-uint32_t LUN_Read(MSDLun        *lun,
-                       uint32_t blockAddress,
-                       void         *data,
-                       uint32_t length,
-                       TransferCallback   callback,
-                       void         *argument)
+uint32_t LUN_DrainCache(MSDLun *lun, uint32_t maxRuns)
 {
-    uint32_t medBlk, medLen;
-    uint8_t status;
+    uint32_t runs = 0;
 
-    /* Check that the data is not too big */
-    if ((length + blockAddress) * lun->blockSize > lun->size) {
+    if (lun->cache == 0 || lun->cache->count == 0) {
 
-        TRACE_WARNING("LUN_Read: Area: (%d + %d)*%d > %d\n\r",
-                      (int)length, (int)blockAddress, (int)lun->blockSize, (int)lun->size);
-        status = USBD_STATUS_ABORTED;
+        return USBD_STATUS_SUCCESS;
     }
-    else if (lun->media == 0 || lun->status != LUN_READY) {
+    if (lun->media == 0) {
 
-        TRACE_WARNING("LUN_Read: Media not present\n\r");
-        status = USBD_STATUS_ABORTED;
+        return USBD_STATUS_ABORTED;
     }
-    else {
 
-        TRACE_INFO_WP("LUNRead(%u) ", blockAddress);
+    while (lun->cache->count && (maxRuns == 0 || runs < maxRuns)) {
 
-        /* Compute read start address */
-        medBlk = lun->baseAddress + (blockAddress * lun->blockSize);
-        medLen = length * lun->blockSize;
+        if (LUN_WriteCacheRun(lun, 1) != USBD_STATUS_SUCCESS) {
 
-        /* Start write operation */
-        status = MED_Read(lun->media,
-                          medBlk,
-                          data,
-                          medLen,
-                          (MediaCallback) callback,
-                          argument);
+            return USBD_STATUS_ABORTED;
+        }
+        runs ++;
+    }
 
-        /* Check result code */
-        if (status == MED_STATUS_SUCCESS) {
+    return USBD_STATUS_SUCCESS;
+}
 
-            status = USBD_STATUS_SUCCESS;
-        }
-        else {
+/**
+ * \brief  Moves the write back of the cache of a LUN on without waiting:
+ *         the run written by the media is released and the next run is
+ *         started. To be invoked periodically.
+ * \param  lun          Pointer to a MSDLun instance
+ * \return USBD_STATUS_LOCKED while the media is busy, else the operation
+ *         result code
+ */
+uint32_t LUN_DrainCacheStep(MSDLun *lun)
+{
+    if (lun->cache == 0 || lun->cache->count == 0) {
 
-            TRACE_WARNING("LUN_Read: Cannot read media\n\r");
-            status = USBD_STATUS_ABORTED;
-        }
+        return USBD_STATUS_SUCCESS;
     }
+    if (lun->media == 0) {
 
-    return status;
+        return USBD_STATUS_ABORTED;
+    }
+
+    return LUN_WriteCacheRun(lun, 0);
 }
 
 /**@}*/
@@ -42,27 +42,30 @@
 
 #include "MSDIOFifo.h"
 
+/*------------------------------------------------------------------------------
+ *      Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Size of the UNMAP parameter list buffer: header and 8 block descriptors */
+#ifndef SBC_UNMAP_LIST_SIZE
+#define SBC_UNMAP_LIST_SIZE     (8 + 8 * sizeof(SBCUnmapBlockDescriptor))
+#endif
+
 /*------------------------------------------------------------------------------
  *      Global variables
  *------------------------------------------------------------------------------*/
 
+/** UNMAP parameter list received from the host */
+static unsigned char unmapList[SBC_UNMAP_LIST_SIZE];
+
 /*------------------------------------------------------------------------------
  *      Macros
  *------------------------------------------------------------------------------*/
 
 #ifdef MSDIO_READ10_CHUNK_SIZE
-/** READ10 - Read data from specific LUN to FIFO */
-#define SBC_READ_CHUNK(pLun, lba, pFifo, pCb, pArg) \
-    LUN_Read((pLun), (lba), \
-            &(pFifo)->pBuffer[(pFifo)->inputNdx], \
-             ((pFifo)->chunkSize/(pFifo)->blockSize), \
-             (TransferCallback)(pCb), (void*)pArg)
-/** READ10 - Transfer data from FIFO to USB */
+/** READ10 - Transfer all loaded chunks from FIFO to USB */
 #define SBC_TX_CHUNK(ep, pFifo, pCb, pArg) \
-    USBD_Write( (ep), \
-               &(pFifo)->pBuffer[(pFifo)->outputNdx], \
-                (pFifo)->chunkSize, \
-                (TransferCallback)(pCb), (void*)(pArg))
+    SBC_TxChunks((ep), (pFifo), (TransferCallback)(pCb), (void*)(pArg))
 #endif
 
 #ifdef MSDIO_WRITE10_CHUNK_SIZE
@@ -72,22 +75,65 @@
               &(pFifo)->pBuffer[(pFifo)->inputNdx], \
                (pFifo)->chunkSize, \
                (TransferCallback)(pCb), (void*)(pArg))
-/** WRITE10 - Write data from FIFO to LUN */
-#define SBC_WRITE_CHUNK(pLun, lba, pFifo, pCb, pArg) \
-    LUN_Write((pLun), (lba), \
-             &(pFifo)->pBuffer[(pFifo)->outputNdx], \
-              ((pFifo)->chunkSize/(pFifo)->blockSize), \
-              (TransferCallback)(pCb), (void*)(pArg))
 #endif
 
 
+/*------------------------------------------------------------------------------
+ *      Internal functions
+ *------------------------------------------------------------------------------*/
+
+#ifdef MSDIO_READ10_CHUNK_SIZE
 /**
- * \brief  Header for the mode pages data
+ * \brief  Sends all the chunks already loaded in the FIFO as one USB
+ *         transfer, using a two entries buffer list when the data wraps
+ *         around the end of the ring buffer.
+ * \param  bEp       USB IN endpoint.
+ * \param  pFifo     Pointer to the READ10 FIFO.
+ * \param  fCallback Transfer completion callback.
+ * \param  pArg      Callback argument.
+ * \return USBD_STATUS_SUCCESS if the transfer has been started.
+ */
+static unsigned char SBC_TxChunks(unsigned char    bEp,
+                                  MSDIOFifo        *pFifo,
+                                  TransferCallback fCallback,
+                                  void             *pArg)
+{
+    unsigned int size  = pFifo->inputTotal - pFifo->outputTotal;
+    unsigned int first = pFifo->bufferSize - pFifo->outputNdx;
+    unsigned short nb  = 1;
+
+    pFifo->outputSize = size;
+    pFifo->outputList[0].pBuffer = &pFifo->pBuffer[pFifo->outputNdx];
+    if (size > first) {
+
+        pFifo->outputList[0].size = first;
+        pFifo->outputList[1].pBuffer = pFifo->pBuffer;
+        pFifo->outputList[1].size = size - first;
+        nb = 2;
+    }
+    else {
+
+        pFifo->outputList[0].size = size;
+    }
+    return USBD_WriteList(bEp, pFifo->outputList, nb, fCallback, pArg);
+}
+#endif
+
+/**
+ * \brief  Mode pages data: header and caching page, the WCE bit is set by
+ *         SBC_ModeSense6() from the LUN cache mode
  * \see    SBCModeParameterHeader6
+ * \see    SBCCachingModePage
  */
-static const SBCModeParameterHeader6 modeParameterHeader6 = {
+static struct {
+
+    SBCModeParameterHeader6 header;
+    SBCCachingModePage      caching;
+
+} modeSenseData = {{
 
-    sizeof(SBCModeParameterHeader6) - 1,        /*! Length is 0x03 */
+    sizeof(SBCModeParameterHeader6)
+    + sizeof(SBCCachingModePage) - 1,           /*! Length is 0x17 */
 
     SBC_MEDIUM_TYPE_DIRECT_ACCESS_BLOCK_DEVICE, /*! Direct-access block device */
 
@@ -100,8 +146,13 @@ static const SBCModeParameterHeader6 modeParameterHeader6 = {
     0,                                          /*! not write-protected */
 
     0                                           /*! No block descriptor */
+    }, {
 
-};
+    SBC_PAGE_CACHING,                           /*! Caching mode page */
+    0,                                          /*! Page data format */
+    0,                                          /*! Parameters not saveable */
+    sizeof(SBCCachingModePage) - 2              /*! Length is 0x12 */
+}};
 
 /*------------------------------------------------------------------------------
  *      Internal functions
@@ -171,81 +222,309 @@ static unsigned char SBCLunCanBeWritten(MSDLun *lun)
     return canBeWritten;
 }
 
+#if  defined(MSDIO_READ10_CHUNK_SIZE) || defined(MSDIO_WRITE10_CHUNK_SIZE)
 /**
- * \brief  Performs a WRITE (10) command on the specified LUN.
- *
- *         The data to write is first received from the USB host and then
- *         actually written on the media.
- *         This function operates asynchronously and must be called multiple
- *         times to complete. A result code of MSDDriver_STATUS_INCOMPLETE
- *         indicates that at least another call of the method is necessary.
+ * \brief  Media callback of a chunk operation of READ10/WRITE10.
+ * \param  pChunk      Pointer to the chunk of the FIFO.
+ * \param  status      Media operation result code.
+ * \param  transferred Number of bytes transferred (unused).
+ * \param  remaining   Number of bytes not transferred (unused).
+ */
+static void SBC_ChunkCallback(MSDIOChunk    *pChunk,
+                              unsigned char status,
+                              unsigned int  transferred,
+                              unsigned int  remaining)
+{
+    pChunk->status = status;
+    pChunk->done = 1;
+}
+
+/**
+ * \brief  Returns the next free chunk of the FIFO, sized for the data left
+ *         to give to the media, and counts it as in flight.
+ * \param  pFifo    Pointer to the READ10/WRITE10 FIFO.
+ */
+static MSDIOChunk * SBC_AddChunk(MSDIOFifo *pFifo)
+{
+    MSDIOChunk *pChunk = &pFifo->chunks[(pFifo->chunkHead + pFifo->chunkCount)
+                                        % MSDIO_PIPELINE_DEPTH];
+
+    pChunk->size = pFifo->dataTotal - pFifo->mediaTotal;
+    if (pChunk->size > pFifo->chunkSize) {
+
+        pChunk->size = pFifo->chunkSize;
+    }
+    pChunk->done = 0;
+    pFifo->chunkCount ++;
+
+    return pChunk;
+}
+
+/**
+ * \brief  Waits for the end of the media operations still in flight, so
+ *         that the FIFO is not accessed once the command is over.
+ * \param  lun      Pointer to the LUN affected by the command
+ */
+static void SBC_WaitChunks(MSDLun *lun)
+{
+    MSDIOFifo *fifo = &lun->ioFifo;
+
+    while (fifo->chunkCount) {
+
+        if (fifo->chunks[fifo->chunkHead].done) {
+
+            fifo->chunkHead = (fifo->chunkHead + 1) % MSDIO_PIPELINE_DEPTH;
+            fifo->chunkCount --;
+        }
+        else {
+
+            MED_Handler(lun->media);
+        }
+    }
+}
+#endif
+
+#ifdef MSDIO_WRITE10_CHUNK_SIZE
+/**
+ * \brief  Media write task of a WRITE (10) command: starts the writes of the
+ *         received chunks, up to MSDIO_PIPELINE_DEPTH at a time, and releases
+ *         the written chunks in order.
  * \param  lun          Pointer to the LUN affected by the command
  * \param  commandState Current state of the command
- * \return Operation result code (SUCCESS, ERROR, INCOMPLETE or PARAMETER)
- * \see    MSDLun
- * \see    MSDCommandState
+ * \return Operation result code (ERROR or INCOMPLETE)
  */
-static unsigned char SBC_Write10(MSDLun          *lun,
-                                 MSDCommandState *commandState)
+static unsigned char SBC_Write10Store(MSDLun          *lun,
+                                      MSDCommandState *commandState)
 {
     unsigned char status;
-    unsigned char result = MSDD_STATUS_INCOMPLETE;
     SBCRead10 *command = (SBCRead10 *) commandState->cbw.pCommand;
-    MSDTransfer *transfer = &(commandState->transfer);
-    MSDTransfer *disktransfer = &(commandState->disktransfer);
     MSDIOFifo   *fifo = &lun->ioFifo;
+    MSDIOChunk  *pChunk;
 
-    /* Init command state */
-    if (commandState->state == 0) {
+    /* Start the writes of the received chunks */
 
-        commandState->state = SBC_STATE_WRITE;
+    while (fifo->chunkCount < MSDIO_PIPELINE_DEPTH
+           && fifo->mediaTotal < fifo->inputTotal
+           && fifo->mediaTotal < fifo->dataTotal) {
 
-        /* The command should not be proceeded if READONLY */
-        if (!SBCLunCanBeWritten(lun)) {
+        pChunk = SBC_AddChunk(fifo);
+        status = LUN_QueueWrite(lun,
+                                DWORDB(command->pLogicalBlockAddress),
+                                &fifo->pBuffer[fifo->mediaNdx],
+                                pChunk->size / fifo->blockSize,
+                                (TransferCallback) SBC_ChunkCallback,
+                                (void *) pChunk);
+        if (status == USBD_STATUS_LOCKED) {
 
-            return MSDD_STATUS_RW;
+            /* Media busy, retry on next poll */
+            fifo->chunkCount --;
+            break;
         }
-        else {
+        if (status != USBD_STATUS_SUCCESS) {
 
+            fifo->chunkCount --;
+            TRACE_WARNING(
+                "RBC_Write10: Failed to start write - ");
 
-            /* Initialize FIFO */
-            fifo->dataTotal = commandState->length;
-            fifo->blockSize = lun->blockSize * lun->media->blockSize;
-          #ifdef MSDIO_WRITE10_CHUNK_SIZE
-            if (   fifo->dataTotal >= 64 * 1024
-                && fifo->blockSize < MSDIO_WRITE10_CHUNK_SIZE)
-                fifo->chunkSize = MSDIO_WRITE10_CHUNK_SIZE;
-            else
-                fifo->chunkSize = fifo->blockSize;
-          #endif
-            fifo->fullCnt = 0;
-            fifo->nullCnt = 0;
+            if (!SBCLunCanBeWritten(lun)) {
 
-            /* Initialize FIFO output (Disk) */
-            fifo->outputNdx = 0;
-            fifo->outputTotal = 0;
-            fifo->outputState = MSDIO_IDLE;
-            transfer->semaphore = 0;
+                TRACE_WARNING("?\n\r");
+                SBC_UpdateSenseData(&(lun->requestSenseData),
+                                    SBC_SENSE_KEY_NOT_READY,
+                                    0,
+                                    0);
+            }
 
-            /* Initialize FIFO input (USB) */
-            fifo->inputNdx = 0;
-            fifo->inputTotal = 0;
-            fifo->inputState = MSDIO_START;
-            disktransfer->semaphore = 0;
+            fifo->outputState = MSDIO_ERROR;
+            return MSDD_STATUS_ERROR;
         }
 
+        TRACE_INFO_WP("dWr ");
+        STORE_DWORDB(DWORDB(command->pLogicalBlockAddress)
+                         + pChunk->size / fifo->blockSize,
+                     command->pLogicalBlockAddress);
+        MSDIOFifo_IncNdx(fifo->mediaNdx,
+                         fifo->chunkSize,
+                         fifo->bufferSize);
+        fifo->mediaTotal += pChunk->size;
     }
 
-    if (commandState->length == 0) {
+    /* Release the written chunks, oldest first */
 
-        /* Perform the callback! */
-        if (lun->dataMonitor) {
+    while (fifo->chunkCount && fifo->chunks[fifo->chunkHead].done) {
 
-            lun->dataMonitor(0, fifo->dataTotal, fifo->nullCnt, fifo->fullCnt);
+        pChunk = &fifo->chunks[fifo->chunkHead];
+        fifo->chunkHead = (fifo->chunkHead + 1) % MSDIO_PIPELINE_DEPTH;
+        fifo->chunkCount --;
+
+        if (pChunk->status != MED_STATUS_SUCCESS) {
+
+            TRACE_WARNING(
+                "RBC_Write10: Failed to write\n\r");
+            SBC_UpdateSenseData(&(lun->requestSenseData),
+                                SBC_SENSE_KEY_RECOVERED_ERROR,
+                                SBC_ASC_TOO_MUCH_WRITE_DATA,
+                                0);
+            fifo->outputState = MSDIO_ERROR;
+            return MSDD_STATUS_ERROR;
         }
-        return MSDD_STATUS_SUCCESS;
+
+        TRACE_INFO_WP("dNxt ");
+        MSDIOFifo_IncNdx(fifo->outputNdx,
+                         fifo->chunkSize,
+                         fifo->bufferSize);
+        fifo->outputTotal += pChunk->size;
+
+        /* - Buffer Null? */
+
+        if (fifo->chunkCount == 0
+            && fifo->outputTotal == fifo->inputTotal
+            && fifo->outputTotal < fifo->dataTotal) {
+
+            fifo->nullCnt ++;
+            TRACE_DEBUG_WP("dfNull%d ", fifo->outputNdx);
+        }
+    }
+
+    /* - All data done? */
+
+    if (fifo->outputTotal >= fifo->dataTotal) {
+
+        fifo->outputState = MSDIO_IDLE;
+        commandState->length = 0;
+        TRACE_INFO_WP("dDone ");
+    }
+    else {
+
+        fifo->outputState = fifo->chunkCount ? MSDIO_WAIT : MSDIO_IDLE;
+    }
+
+    return MSDD_STATUS_INCOMPLETE;
+}
+#endif
+
+#ifdef MSDIO_READ10_CHUNK_SIZE
+/**
+ * \brief  Media read task of a READ (10) command: starts the reads of the
+ *         next chunks while the FIFO has room, up to MSDIO_PIPELINE_DEPTH at
+ *         a time, and hands the read chunks to the USB side in order.
+ * \param  lun          Pointer to the LUN affected by the command
+ * \param  commandState Current state of the command
+ * \return Operation result code (ERROR or INCOMPLETE)
+ */
+static unsigned char SBC_Read10Load(MSDLun          *lun,
+                                    MSDCommandState *commandState)
+{
+    unsigned char status;
+    SBCRead10 *command = (SBCRead10 *) commandState->cbw.pCommand;
+    MSDIOFifo   *fifo = &lun->ioFifo;
+    MSDIOChunk  *pChunk;
+
+    /* Start the reads while the FIFO has room */
+
+    while (fifo->chunkCount < MSDIO_PIPELINE_DEPTH
+           && fifo->mediaTotal < fifo->dataTotal
+           && fifo->mediaTotal - fifo->outputTotal < fifo->bufferSize) {
+
+        pChunk = SBC_AddChunk(fifo);
+        status = LUN_QueueRead(lun,
+                               DWORDB(command->pLogicalBlockAddress),
+                               &fifo->pBuffer[fifo->mediaNdx],
+                               pChunk->size / fifo->blockSize,
+                               (TransferCallback) SBC_ChunkCallback,
+                               (void *) pChunk);
+        if (status == USBD_STATUS_LOCKED) {
+
+            /* Media busy, retry on next poll */
+            fifo->chunkCount --;
+            break;
+        }
+        if (status != USBD_STATUS_SUCCESS) {
+
+            fifo->chunkCount --;
+            TRACE_WARNING("RBC_Read10: Failed to start reading\n\r");
+
+            if (SBCLunIsReady(lun)) {
+
+                SBC_UpdateSenseData(&(lun->requestSenseData),
+                                    SBC_SENSE_KEY_NOT_READY,
+                                    SBC_ASC_LOGICAL_UNIT_NOT_READY,
+                                    0);
+            }
+
+            fifo->inputState = MSDIO_ERROR;
+            return MSDD_STATUS_ERROR;
+        }
+
+        TRACE_INFO_WP("dRd ");
+        STORE_DWORDB(DWORDB(command->pLogicalBlockAddress)
+                         + pChunk->size / fifo->blockSize,
+                     command->pLogicalBlockAddress);
+        MSDIOFifo_IncNdx(fifo->mediaNdx,
+                         fifo->chunkSize,
+                         fifo->bufferSize);
+        fifo->mediaTotal += pChunk->size;
     }
 
+    /* Hand the read chunks to the USB side, oldest first */
+
+    while (fifo->chunkCount && fifo->chunks[fifo->chunkHead].done) {
+
+        pChunk = &fifo->chunks[fifo->chunkHead];
+        fifo->chunkHead = (fifo->chunkHead + 1) % MSDIO_PIPELINE_DEPTH;
+        fifo->chunkCount --;
+
+        if (pChunk->status != MED_STATUS_SUCCESS) {
+
+            TRACE_WARNING(
+                "RBC_Read10: Failed to read media\n\r");
+            SBC_UpdateSenseData(&(lun->requestSenseData),
+                                SBC_SENSE_KEY_RECOVERED_ERROR,
+                                SBC_ASC_LOGICAL_BLOCK_ADDRESS_OUT_OF_RANGE,
+                                0);
+            fifo->inputState = MSDIO_ERROR;
+            return MSDD_STATUS_ERROR;
+        }
+
+        TRACE_INFO_WP("dOk ");
+        MSDIOFifo_IncNdx(fifo->inputNdx,
+                         fifo->chunkSize,
+                         fifo->bufferSize);
+        fifo->inputTotal += pChunk->size;
+
+        /* - Buffer full? */
+
+        if (fifo->inputTotal < fifo->dataTotal
+            && fifo->inputTotal - fifo->outputTotal >= fifo->bufferSize) {
+
+            TRACE_INFO_WP("dfFull%d ", (int)fifo->inputNdx);
+            fifo->fullCnt ++;
+        }
+    }
+
+    fifo->inputState = fifo->chunkCount ? MSDIO_WAIT : MSDIO_IDLE;
+
+    return MSDD_STATUS_INCOMPLETE;
+}
+#endif
+
+/**
+ * \brief  Runs the USB receive task and the media write task of a WRITE (10)
+ *         command once each.
+ * \param  lun          Pointer to the LUN affected by the command
+ * \param  commandState Current state of the command
+ * \return Operation result code (SUCCESS, ERROR or INCOMPLETE)
+ */
+static unsigned char SBC_Write10Tasks(MSDLun          *lun,
+                                      MSDCommandState *commandState)
+{
+    unsigned char status;
+    unsigned char result = MSDD_STATUS_INCOMPLETE;
+    SBCRead10 *command = (SBCRead10 *) commandState->cbw.pCommand;
+    MSDTransfer *transfer = &(commandState->transfer);
+    MSDTransfer *disktransfer = &(commandState->disktransfer);
+    MSDIOFifo   *fifo = &lun->ioFifo;
+
     /* USB receive task */
     switch(fifo->inputState) {
 
@@ -460,6 +739,13 @@ static unsigned char SBC_Write10(MSDLun          *lun,
 
     /* Disk write task */
 
+  #ifdef MSDIO_WRITE10_CHUNK_SIZE
+    if (!lun->media->mappedWR) {
+
+        return SBC_Write10Store(lun, commandState);
+    }
+  #endif
+
     switch(fifo->outputState) {
 
     /*------------------ */
@@ -487,17 +773,12 @@ static unsigned char SBC_Write10(MSDLun          *lun,
             status = LUN_STATUS_SUCCESS;
         }
         else {
-          #ifdef MSDIO_WRITE10_CHUNK_SIZE
-            status = SBC_WRITE_CHUNK(lun, DWORDB(command->pLogicalBlockAddress),
-                                     fifo, MSDDriver_Callback, disktransfer);
-          #else
             status = LUN_Write(lun,
                                DWORDB(command->pLogicalBlockAddress),
                                &fifo->pBuffer[fifo->outputNdx],
                                1,
                                (TransferCallback) MSDDriver_Callback,
                                (void *) disktransfer);
-          #endif
         }
 
         /* Check operation result code */
@@ -580,22 +861,12 @@ static unsigned char SBC_Write10(MSDLun          *lun,
 
                 /* Update output index */
 
-              #ifdef MSDIO_WRITE10_CHUNK_SIZE
-                STORE_DWORDB(DWORDB(command->pLogicalBlockAddress)
-                                 + fifo->chunkSize/fifo->blockSize,
-                             command->pLogicalBlockAddress);
-                MSDIOFifo_IncNdx(fifo->outputNdx,
-                                 fifo->chunkSize,
-                                 fifo->bufferSize);
-                fifo->outputTotal += fifo->chunkSize;
-              #else
                 STORE_DWORDB(DWORDB(command->pLogicalBlockAddress) + 1,
                              command->pLogicalBlockAddress);
                 MSDIOFifo_IncNdx(fifo->outputNdx,
                                  fifo->blockSize,
                                  fifo->bufferSize);
                 fifo->outputTotal += fifo->blockSize;
-              #endif
 
                 /* Start Next block */
 
@@ -639,9 +910,10 @@ static unsigned char SBC_Write10(MSDLun          *lun,
 }
 
 /**
- * \brief  Performs a READ (10) command on specified LUN.
+ * \brief  Performs a WRITE (10) command on the specified LUN.
  *
- *         The data is first read from the media and then sent to the USB host.
+ *         The data to write is first received from the USB host and then
+ *         actually written on the media.
  *         This function operates asynchronously and must be called multiple
  *         times to complete. A result code of MSDDriver_STATUS_INCOMPLETE
  *         indicates that at least another call of the method is necessary.
@@ -651,82 +923,132 @@ static unsigned char SBC_Write10(MSDLun          *lun,
  * \see    MSDLun
  * \see    MSDCommandState
  */
-static unsigned char SBC_Read10(MSDLun          *lun,
-                                MSDCommandState *commandState)
+static unsigned char SBC_Write10(MSDLun          *lun,
+                                 MSDCommandState *commandState)
 {
-    unsigned char status;
     unsigned char result = MSDD_STATUS_INCOMPLETE;
-    SBCRead10 *command = (SBCRead10 *) commandState->cbw.pCommand;
     MSDTransfer *transfer = &(commandState->transfer);
     MSDTransfer *disktransfer = &(commandState->disktransfer);
     MSDIOFifo   *fifo = &lun->ioFifo;
+    unsigned char lastInputState, lastOutputState;
+    unsigned int lastOutputTotal;
 
     /* Init command state */
-
     if (commandState->state == 0) {
 
-        commandState->state = SBC_STATE_READ;
+        commandState->state = SBC_STATE_WRITE;
 
-        if (!SBCLunIsReady(lun)) {
+        /* The command should not be proceeded if READONLY */
+        if (!SBCLunCanBeWritten(lun)) {
 
             return MSDD_STATUS_RW;
         }
         else {
 
-            /* Initialize FIFO */
 
+            /* Initialize FIFO */
             fifo->dataTotal = commandState->length;
             fifo->blockSize = lun->blockSize * lun->media->blockSize;
-          #ifdef MSDIO_READ10_CHUNK_SIZE
-            if (   fifo->dataTotal >= 64*1024
-                && fifo->blockSize < MSDIO_READ10_CHUNK_SIZE)
-                fifo->chunkSize = MSDIO_READ10_CHUNK_SIZE;
+          #ifdef MSDIO_WRITE10_CHUNK_SIZE
+            if (   fifo->dataTotal >= 64 * 1024
+                && fifo->blockSize < MSDIO_WRITE10_CHUNK_SIZE)
+                fifo->chunkSize = MSDIOFifo_GetChunkSize(fifo,
+                                                MSDIO_WRITE10_CHUNK_SIZE);
             else
                 fifo->chunkSize = fifo->blockSize;
           #endif
             fifo->fullCnt = 0;
             fifo->nullCnt = 0;
 
-          #ifdef MSDIO_FIFO_OFFSET
-            /* Enable offset if total size >= 2*bufferSize */
-
-            if (fifo->dataTotal / fifo->bufferSize >= 2)
-                fifo->bufferOffset = MSDIO_FIFO_OFFSET;
-            else
-                fifo->bufferOffset = 0;
-          #endif
-
-            /* Initialize FIFO output (USB) */
-
+            /* Initialize FIFO output (Disk) */
             fifo->outputNdx = 0;
             fifo->outputTotal = 0;
             fifo->outputState = MSDIO_IDLE;
             transfer->semaphore = 0;
 
-            /* Initialize FIFO input (Disk) */
-
+            /* Initialize FIFO input (USB) */
             fifo->inputNdx = 0;
             fifo->inputTotal = 0;
             fifo->inputState = MSDIO_START;
             disktransfer->semaphore = 0;
+
+          #ifdef MSDIO_WRITE10_CHUNK_SIZE
+            /* Initialize media operations */
+            fifo->mediaNdx = 0;
+            fifo->mediaTotal = 0;
+            fifo->chunkHead = 0;
+            fifo->chunkCount = 0;
+          #endif
         }
-    }
 
-    /* Check length */
+    }
 
     if (commandState->length == 0) {
 
         /* Perform the callback! */
-
         if (lun->dataMonitor) {
 
-            lun->dataMonitor(1, fifo->dataTotal, fifo->nullCnt, fifo->fullCnt);
+            lun->dataMonitor(0, fifo->dataTotal, fifo->nullCnt, fifo->fullCnt);
         }
         return MSDD_STATUS_SUCCESS;
     }
 
+    /* Run both tasks until none of them can progress, so that a finished
+       stage immediately restarts on the next chunk instead of waiting for
+       the next state machine poll */
+    do {
+
+        lastInputState = fifo->inputState;
+        lastOutputState = fifo->outputState;
+        lastOutputTotal = fifo->outputTotal;
+        result = SBC_Write10Tasks(lun, commandState);
+
+    } while (result == MSDD_STATUS_INCOMPLETE
+             && (   lastInputState != fifo->inputState
+                 || lastOutputState != fifo->outputState
+                 || lastOutputTotal != fifo->outputTotal));
+
+  #ifdef MSDIO_WRITE10_CHUNK_SIZE
+    if (result != MSDD_STATUS_INCOMPLETE) {
+
+        SBC_WaitChunks(lun);
+    }
+  #endif
+
+    return result;
+}
+
+/**
+ * \brief  Runs the media read task and the USB send task of a READ (10)
+ *         command once each.
+ * \param  lun          Pointer to the LUN affected by the command
+ * \param  commandState Current state of the command
+ * \return Operation result code (SUCCESS, ERROR or INCOMPLETE)
+ */
+static unsigned char SBC_Read10Tasks(MSDLun          *lun,
+                                     MSDCommandState *commandState)
+{
+    unsigned char status;
+    unsigned char result = MSDD_STATUS_INCOMPLETE;
+    SBCRead10 *command = (SBCRead10 *) commandState->cbw.pCommand;
+    MSDTransfer *transfer = &(commandState->transfer);
+    MSDTransfer *disktransfer = &(commandState->disktransfer);
+    MSDIOFifo   *fifo = &lun->ioFifo;
+    void *pMapped;
+
     /* Disk reading task */
 
+  #ifdef MSDIO_READ10_CHUNK_SIZE
+    if (!lun->media->mappedRD) {
+
+        result = SBC_Read10Load(lun, commandState);
+        if (result != MSDD_STATUS_INCOMPLETE) {
+
+            return result;
+        }
+    }
+    else
+  #endif
     switch(fifo->inputState) {
 
     /*------------------ */
@@ -756,17 +1078,12 @@ static unsigned char SBC_Read10(MSDLun          *lun,
             status = LUN_STATUS_SUCCESS;
         }
         else {
-          #ifdef MSDIO_READ10_CHUNK_SIZE
-            status = SBC_READ_CHUNK(lun, DWORDB(command->pLogicalBlockAddress),
-                                    fifo, MSDDriver_Callback, disktransfer);
-          #else
             status = LUN_Read(lun,
                               DWORDB(command->pLogicalBlockAddress),
                               &fifo->pBuffer[fifo->inputNdx],
                               1,
                               (TransferCallback) MSDDriver_Callback,
                               (void *)disktransfer);
-          #endif
         }
 
         /* Check operation result code */
@@ -841,23 +1158,9 @@ static unsigned char SBC_Read10(MSDLun          *lun,
 
                 fifo->inputState = MSDIO_IDLE;
                 fifo->inputTotal = fifo->dataTotal;
-            }
-            else {
-
-                /* Update block address */
-
-              #ifdef MSDIO_READ10_CHUNK_SIZE
-                STORE_DWORDB(DWORDB(command->pLogicalBlockAddress)
-                                 + fifo->chunkSize/fifo->blockSize,
-                             command->pLogicalBlockAddress);
-
-                /* Update input index */
-
-                MSDIOFifo_IncNdx(fifo->inputNdx,
-                                 fifo->chunkSize,
-                                 fifo->bufferSize);
-                fifo->inputTotal += fifo->chunkSize;
-              #else
+            }
+            else {
+
                 /* Update block address */
 
                 STORE_DWORDB(DWORDB(command->pLogicalBlockAddress) + 1,
@@ -869,7 +1172,6 @@ static unsigned char SBC_Read10(MSDLun          *lun,
                                  fifo->blockSize,
                                  fifo->bufferSize);
                 fifo->inputTotal += fifo->blockSize;
-              #endif
 
                 /* Start Next block */
 
@@ -949,32 +1251,31 @@ static unsigned char SBC_Read10(MSDLun          *lun,
 
         /* Send the block to the host */
         if (lun->media->mappedRD) {
+
+            /* Straight from the media memory, no copy */
+            if (MED_Map(lun->media,
+                        lun->baseAddress
+                          + DWORDB(command->pLogicalBlockAddress)
+                            * lun->blockSize,
+                        commandState->length / lun->media->blockSize,
+                        &pMapped) != MED_STATUS_SUCCESS) {
+
+                status = USBD_STATUS_ABORTED;
+            }
+            else {
           #if 1
-            status = USBD_Write(commandState->pipeIN,
-                                (void*)
-                                 ((lun->media->baseAddress
-                                    + (lun->baseAddress
-                                       + DWORDB(command->pLogicalBlockAddress)
-                                         * lun->blockSize
-                                      )
-                                   ) * lun->media->blockSize
-                                 ),
-                                commandState->length,
-                                (TransferCallback) MSDDriver_Callback,
-                                (void *) transfer);
+                status = USBD_Write(commandState->pipeIN,
+                                    pMapped,
+                                    commandState->length,
+                                    (TransferCallback) MSDDriver_Callback,
+                                    (void *) transfer);
           #else
-            status = MSDD_Write((void*)
-                                 ((lun->media->baseAddress
-                                    + (lun->baseAddress
-                                       + DWORDB(command->pLogicalBlockAddress)
-                                         * lun->blockSize
-                                      )
-                                   ) * lun->media->blockSize
-                                 ),
-                                commandState->length,
-                                (TransferCallback) MSDDriver_Callback,
-                                (void *) transfer);
+                status = MSDD_Write(pMapped,
+                                    commandState->length,
+                                    (TransferCallback) MSDDriver_Callback,
+                                    (void *) transfer);
           #endif
+            }
         }
         else {
           #ifdef MSDIO_READ10_CHUNK_SIZE
@@ -1066,10 +1367,11 @@ static unsigned char SBC_Read10(MSDLun          *lun,
                 /* Update output index */
 
               #ifdef MSDIO_READ10_CHUNK_SIZE
-                MSDIOFifo_IncNdx(fifo->outputNdx,
-                                 fifo->chunkSize,
-                                 fifo->bufferSize);
-                fifo->outputTotal += fifo->chunkSize;
+                /* Several chunks may have been sent at once */
+                fifo->outputNdx += fifo->outputSize;
+                if (fifo->outputNdx >= fifo->bufferSize)
+                    fifo->outputNdx -= fifo->bufferSize;
+                fifo->outputTotal += fifo->outputSize;
               #else
                 MSDIOFifo_IncNdx(fifo->outputNdx,
                                  fifo->blockSize,
@@ -1118,6 +1420,127 @@ static unsigned char SBC_Read10(MSDLun          *lun,
     return result;
 }
 
+/**
+ * \brief  Performs a READ (10) command on specified LUN.
+ *
+ *         The data is first read from the media and then sent to the USB host.
+ *         This function operates asynchronously and must be called multiple
+ *         times to complete. A result code of MSDDriver_STATUS_INCOMPLETE
+ *         indicates that at least another call of the method is necessary.
+ * \param  lun          Pointer to the LUN affected by the command
+ * \param  commandState Current state of the command
+ * \return Operation result code (SUCCESS, ERROR, INCOMPLETE or PARAMETER)
+ * \see    MSDLun
+ * \see    MSDCommandState
+ */
+static unsigned char SBC_Read10(MSDLun          *lun,
+                                MSDCommandState *commandState)
+{
+    unsigned char result = MSDD_STATUS_INCOMPLETE;
+    MSDTransfer *transfer = &(commandState->transfer);
+    MSDTransfer *disktransfer = &(commandState->disktransfer);
+    MSDIOFifo   *fifo = &lun->ioFifo;
+    unsigned char lastInputState, lastOutputState;
+    unsigned int lastInputTotal;
+
+    /* Init command state */
+
+    if (commandState->state == 0) {
+
+        commandState->state = SBC_STATE_READ;
+
+        if (!SBCLunIsReady(lun)) {
+
+            return MSDD_STATUS_RW;
+        }
+        else {
+
+            /* Initialize FIFO */
+
+            fifo->dataTotal = commandState->length;
+            fifo->blockSize = lun->blockSize * lun->media->blockSize;
+          #ifdef MSDIO_READ10_CHUNK_SIZE
+            if (   fifo->dataTotal >= 64*1024
+                && fifo->blockSize < MSDIO_READ10_CHUNK_SIZE)
+                fifo->chunkSize = MSDIOFifo_GetChunkSize(fifo,
+                                                MSDIO_READ10_CHUNK_SIZE);
+            else
+                fifo->chunkSize = fifo->blockSize;
+          #endif
+            fifo->fullCnt = 0;
+            fifo->nullCnt = 0;
+
+          #ifdef MSDIO_FIFO_OFFSET
+            /* Enable offset if total size >= 2*bufferSize */
+
+            if (fifo->dataTotal / fifo->bufferSize >= 2)
+                fifo->bufferOffset = MSDIO_FIFO_OFFSET;
+            else
+                fifo->bufferOffset = 0;
+          #endif
+
+            /* Initialize FIFO output (USB) */
+
+            fifo->outputNdx = 0;
+            fifo->outputTotal = 0;
+            fifo->outputState = MSDIO_IDLE;
+            transfer->semaphore = 0;
+
+            /* Initialize FIFO input (Disk) */
+
+            fifo->inputNdx = 0;
+            fifo->inputTotal = 0;
+            fifo->inputState = MSDIO_START;
+            disktransfer->semaphore = 0;
+
+          #ifdef MSDIO_READ10_CHUNK_SIZE
+            /* Initialize media operations */
+            fifo->mediaNdx = 0;
+            fifo->mediaTotal = 0;
+            fifo->chunkHead = 0;
+            fifo->chunkCount = 0;
+          #endif
+        }
+    }
+
+    /* Check length */
+
+    if (commandState->length == 0) {
+
+        /* Perform the callback! */
+
+        if (lun->dataMonitor) {
+
+            lun->dataMonitor(1, fifo->dataTotal, fifo->nullCnt, fifo->fullCnt);
+        }
+        return MSDD_STATUS_SUCCESS;
+    }
+
+    /* Run both tasks until none of them can progress, so that a finished
+       stage immediately restarts on the next chunk instead of waiting for
+       the next state machine poll */
+    do {
+
+        lastInputState = fifo->inputState;
+        lastOutputState = fifo->outputState;
+        lastInputTotal = fifo->inputTotal;
+        result = SBC_Read10Tasks(lun, commandState);
+
+    } while (result == MSDD_STATUS_INCOMPLETE
+             && (   lastInputState != fifo->inputState
+                 || lastOutputState != fifo->outputState
+                 || lastInputTotal != fifo->inputTotal));
+
+  #ifdef MSDIO_READ10_CHUNK_SIZE
+    if (result != MSDD_STATUS_INCOMPLETE) {
+
+        SBC_WaitChunks(lun);
+    }
+  #endif
+
+    return result;
+}
+
 /**
  * \brief  Performs a READ CAPACITY (10) command.
  *
@@ -1424,6 +1847,7 @@ static unsigned char SBC_ModeSense6(MSDLun *lun, MSDCommandState *commandState)
 {
     unsigned char      result = MSDD_STATUS_INCOMPLETE;
     unsigned char      status;
+    unsigned char      pageCode;
     MSDTransfer     *transfer = &(commandState->transfer);
 
     if (!SBCLunIsReady(lun)) {
@@ -1433,8 +1857,8 @@ static unsigned char SBC_ModeSense6(MSDLun *lun, MSDCommandState *commandState)
     }
 
     /* Check if mode page is supported */
-    if (((SBCCommand *) commandState->cbw.pCommand)->modeSense6.bPageCode
-        != SBC_PAGE_RETURN_ALL) {
+    pageCode = ((SBCCommand *) commandState->cbw.pCommand)->modeSense6.bPageCode;
+    if (pageCode != SBC_PAGE_RETURN_ALL && pageCode != SBC_PAGE_CACHING) {
 
         return MSDD_STATUS_PARAMETER;
     }
@@ -1442,6 +1866,8 @@ static unsigned char SBC_ModeSense6(MSDLun *lun, MSDCommandState *commandState)
     /* Initialize command state if needed */
     if (commandState->state == 0) {
 
+        /* Report the write-back cache of the LUN */
+        modeSenseData.caching.isWCE = (lun->cache != 0);
         commandState->state = SBC_STATE_WRITE;
     }
 
@@ -1454,12 +1880,12 @@ static unsigned char SBC_ModeSense6(MSDLun *lun, MSDCommandState *commandState)
         /* Start transfer */
       #if 1
         status = USBD_Write(commandState->pipeIN,
-                            (void *) &modeParameterHeader6,
+                            (void *) &modeSenseData,
                             commandState->length,
                             (TransferCallback) MSDDriver_Callback,
                             (void *) transfer);
       #else
-        status = MSDD_Write((void *) &modeParameterHeader6,
+        status = MSDD_Write((void *) &modeSenseData,
                             commandState->length,
                             (TransferCallback) MSDDriver_Callback,
                             (void *) transfer);
@@ -1513,7 +1939,155 @@ static unsigned char SBC_ModeSense6(MSDLun *lun, MSDCommandState *commandState)
 }
 
 /**
- * \brief  Performs a TEST UNIT READY COMMAND command.
+ * \brief  Performs a SYNCHRONIZE CACHE (10) command: the data cached by the
+ *         media is written to the medium. The whole cache is synchronized,
+ *         whatever the range.
+ * \param  lun          Pointer to the LUN affected by the command
+ * \return Operation result code (SUCCESS, ERROR, INCOMPLETE or PARAMETER)
+ * \see    MSDLun
+ */
+static unsigned char SBC_SynchronizeCache10(MSDLun *lun)
+{
+    if (!SBCLunIsReady(lun)) {
+
+        return MSDD_STATUS_RW;
+    }
+
+    if (LUN_Flush(lun) != USBD_STATUS_SUCCESS) {
+
+        SBC_UpdateSenseData(&(lun->requestSenseData),
+                            SBC_SENSE_KEY_MEDIUM_ERROR,
+                            0,
+                            0);
+        return MSDD_STATUS_ERROR;
+    }
+
+    return MSDD_STATUS_SUCCESS;
+}
+
+/**
+ * \brief  Performs an UNMAP command: the parameter list is received from the
+ *         host, then the media is told that the blocks of each range are no
+ *         longer used.
+ *
+ *         This function operates asynchronously and must be called multiple
+ *         times to complete. A result code of MSDDriver_STATUS_INCOMPLETE
+ *         indicates that at least another call of the method is necessary.
+ * \param  lun          Pointer to the LUN affected by the command
+ * \param  commandState Current state of the command
+ * \return Operation result code (SUCCESS, ERROR, INCOMPLETE or PARAMETER)
+ * \see    MSDLun
+ * \see    MSDCommandState
+ */
+static unsigned char SBC_Unmap(MSDLun          *lun,
+                               MSDCommandState *commandState)
+{
+    unsigned char result = MSDD_STATUS_INCOMPLETE;
+    unsigned char status;
+    MSDTransfer *transfer = &(commandState->transfer);
+    SBCUnmapBlockDescriptor *descriptor;
+    unsigned int size, numBlocks;
+
+    /* Init command state */
+    if (commandState->state == 0) {
+
+        if (!SBCLunCanBeWritten(lun)) {
+
+            return MSDD_STATUS_RW;
+        }
+        /* No parameter list, nothing to unmap */
+        if (commandState->length == 0) {
+
+            return MSDD_STATUS_SUCCESS;
+        }
+        if (commandState->length > sizeof(unmapList)) {
+
+            TRACE_WARNING("SBC_Unmap: List too long\n\r");
+            return MSDD_STATUS_PARAMETER;
+        }
+        commandState->state = SBC_STATE_READ;
+    }
+
+    switch (commandState->state) {
+    /*------------------ */
+    case SBC_STATE_READ:
+    /*------------------ */
+
+        /* Receive the parameter list */
+        status = USBD_Read(commandState->pipeOUT,
+                           unmapList,
+                           commandState->length,
+                           (TransferCallback) MSDDriver_Callback,
+                           (void *) transfer);
+        if (status != USBD_STATUS_SUCCESS) {
+
+            TRACE_WARNING("SBC_Unmap: Cannot receive the list\n\r");
+            result = MSDD_STATUS_ERROR;
+        }
+        else {
+
+            commandState->state = SBC_STATE_WAIT_READ;
+        }
+        break;
+
+    /*----------------------- */
+    case SBC_STATE_WAIT_READ:
+    /*----------------------- */
+
+        if (transfer->semaphore == 0) {
+
+            break;
+        }
+        transfer->semaphore--;
+        commandState->length -= transfer->transferred;
+        if (transfer->status != USBD_STATUS_SUCCESS) {
+
+            TRACE_WARNING("SBC_Unmap: List transfer failed\n\r");
+            result = MSDD_STATUS_ERROR;
+            break;
+        }
+
+        /* Block descriptor data length, bounded by the data received */
+        size = (transfer->transferred >= 8) ? WORDB((&unmapList[2])) : 0;
+        if (size > transfer->transferred - 8) {
+
+            size = transfer->transferred - 8;
+        }
+
+        result = MSDD_STATUS_SUCCESS;
+        for (descriptor = (SBCUnmapBlockDescriptor *) &unmapList[8];
+             size >= sizeof(SBCUnmapBlockDescriptor);
+             descriptor++, size -= sizeof(SBCUnmapBlockDescriptor)) {
+
+            numBlocks = DWORDB(descriptor->pNumberOfBlocks);
+            if (numBlocks == 0) {
+
+                continue;
+            }
+            TRACE_INFO_WP("Unmap(%u,%u) ",
+                          DWORDB((&descriptor->pLogicalBlockAddress[4])), numBlocks);
+            if (DWORDB(descriptor->pLogicalBlockAddress) != 0
+                || LUN_Discard(lun,
+                               DWORDB((&descriptor->pLogicalBlockAddress[4])),
+                               numBlocks) != USBD_STATUS_SUCCESS) {
+
+                SBC_UpdateSenseData(&(lun->requestSenseData),
+                                    SBC_SENSE_KEY_ILLEGAL_REQUEST,
+                                    SBC_ASC_LOGICAL_BLOCK_ADDRESS_OUT_OF_RANGE,
+                                    0);
+                result = MSDD_STATUS_ERROR;
+                break;
+            }
+        }
+        break;
+    }
+
+    return result;
+}
+
+/**
+ * \brief  Performs a TEST UNIT READY COMMAND command. The answer only comes
+ *         from the LUN status and the media state, the media is not accessed.
  * \param  lun          Pointer to the LUN affected by the command
  * \return Operation result code (SUCCESS, ERROR, INCOMPLETE or PARAMETER)
  * \see    MSDLun
@@ -1559,8 +2133,10 @@ static unsigned char SBC_TestUnitReady(MSDLun *lun)
         case MED_STATE_BUSY:
         /*------------------ */
 
+            /* The media is working for another command or LUN, or writing
+               the cache back: the LUN is ready, its commands will wait */
             TRACE_INFO_WP("Bsy ");
-            senseKey = SBC_SENSE_KEY_NOT_READY;
+            result = MSDD_STATUS_SUCCESS;
             break;
 
         /*------ */
@@ -1641,9 +2217,9 @@ unsigned char SBC_GetCommandInformation(void          *command,
 
         (*type) = MSDD_DEVICE_TO_HOST;
         if (sbcCommand->modeSense6.bAllocationLength >
-            sizeof(SBCModeParameterHeader6)) {
+            sizeof(modeSenseData)) {
 
-            *length = sizeof(SBCModeParameterHeader6);
+            *length = sizeof(modeSenseData);
         }
         else {
 
@@ -1705,6 +2281,43 @@ unsigned char SBC_GetCommandInformation(void          *command,
                      * lun->blockSize * lun->media->blockSize;
         break;
 
+    /*--------------- */
+
+    case SBC_READ_12:
+    /*--------------- */
+
+        (*type) = MSDD_DEVICE_TO_HOST;
+        (*length) = DWORDB(sbcCommand->read12.pTransferLength)
+                     * lun->blockSize * lun->media->blockSize;
+        break;
+
+    /*---------------- */
+
+    case SBC_WRITE_12:
+    /*---------------- */
+
+        (*type) = MSDD_HOST_TO_DEVICE;
+        (*length) = DWORDB(sbcCommand->write12.pTransferLength)
+                     * lun->blockSize * lun->media->blockSize;
+        break;
+
+    /*---------------------------- */
+
+    case SBC_SYNCHRONIZE_CACHE_10:
+    /*---------------------------- */
+
+        (*type) = MSDD_NO_TRANSFER;
+        break;
+
+    /*------------- */
+
+    case SBC_UNMAP:
+    /*------------- */
+
+        (*type) = MSDD_HOST_TO_DEVICE;
+        (*length) = WORDB(sbcCommand->unmap.pParameterListLength);
+        break;
+
     /*----------------- */
 
     case SBC_VERIFY_10:
@@ -1767,6 +2380,45 @@ unsigned char SBC_ProcessCommand(MSDLun               *lun,
         result = SBC_Write10(lun, commandState);
         break;
 
+    /*--------------- */
+    case SBC_READ_12:
+    /*--------------- */
+
+        TRACE_DEBUG_WP("Read(12) ");
+
+        /* The LBA is at the same place as in READ (10), the length is
+           given by SBC_GetCommandInformation() */
+
+        result = SBC_Read10(lun, commandState);
+        break;
+
+    /*---------------- */
+    case SBC_WRITE_12:
+    /*---------------- */
+
+        TRACE_DEBUG_WP("Write(12) ");
+
+        result = SBC_Write10(lun, commandState);
+        break;
+
+    /*---------------------------- */
+    case SBC_SYNCHRONIZE_CACHE_10:
+    /*---------------------------- */
+
+        TRACE_INFO_WP("SyncCache(10) ");
+
+        result = SBC_SynchronizeCache10(lun);
+        break;
+
+    /*------------- */
+    case SBC_UNMAP:
+    /*------------- */
+
+        TRACE_INFO_WP("Unmap ");
+
+        result = SBC_Unmap(lun, commandState);
+        break;
+
     /*--------------------- */
     case SBC_READ_CAPACITY_10:
     /*--------------------- */
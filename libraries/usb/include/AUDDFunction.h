@@ -88,6 +88,7 @@ extern void AUDDFunction_Initialize(
     USBDDriver *pUsbd, uint8_t bInterface);
 extern void AUDDFunction_Configure(
     USBGenericDescriptor * pDescriptors, uint16_t wLength);
+extern void AUDDFunction_ConfigureMap(const USBDFunctionMap * pMap);
 extern void AUDDFunction_InterfaceSettingChangedHandler(
     uint8_t interface,uint8_t setting);
 extern uint32_t AUDDFunction_RequestHandler(const USBGenericRequest * request);
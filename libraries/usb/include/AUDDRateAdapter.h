@@ -0,0 +1,155 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2010, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * \section Purpose
+ *
+ *   Rate adaptation of an asynchronous USB audio OUT stream, whose samples
+ *   are played with the local clock.
+ *
+ * \section Usage
+ *
+ *   -# Initialize the adapter with AUDDRateAdapter_Initialize, giving the
+ *      local playback rate as a feedback value (10.14 samples per frame).
+ *   -# Pass every packet received from the host through
+ *      AUDDRateAdapter_Process before queuing it for playback.
+ *   -# Once the packet is queued, give the buffer fill level to
+ *      AUDDRateAdapter_Update and send the returned value to the host with
+ *      AUDDSpeakerDriver_SetFeedback.
+ *
+ *   The feedback value follows the fill level with a PI controller, which is
+ *   enough as long as the host honours the feedback. The drift between the
+ *   host and local rates is measured over AUDDRateAdapter_WINDOW packets;
+ *   when it exceeds the threshold (the host ignores the feedback), the
+ *   packets go through a polyphase FIR resampler until it falls back below
+ *   half the threshold. Otherwise the packets are copied unchanged.
+ *
+ *   Samples are 16-bit interleaved; a frame holds one sample per channel
+ *   and the fill level is counted in frames.
+ */
+
+#ifndef AUDDRATEADAPTER_H
+#define AUDDRATEADAPTER_H
+
+/** \addtogroup usbd_audio_speaker
+ *@{
+ */
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Maximum number of interleaved channels. */
+#define AUDDRateAdapter_MAXCHANNELS     2
+/** Maximum number of frames processed at once. */
+#define AUDDRateAdapter_MAXFRAMES       64
+/** Number of taps of each resampler phase. */
+#define AUDDRateAdapter_TAPS            8
+/** Number of resampler phases (interpolated linearly in between). */
+#define AUDDRateAdapter_PHASES          32
+/** Number of packets (USB frames) of a drift measure. */
+#define AUDDRateAdapter_WINDOW          1024
+
+/** Size in frames of an output buffer for a given input frame count. */
+#define AUDDRateAdapter_OUTFRAMES(n)    ((n) + AUDDRateAdapter_TAPS)
+
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+/**
+ * \typedef AUDDRateAdapter
+ * \brief Feedback controller and resampler state of an audio OUT stream.
+ */
+typedef struct _AUDDRateAdapter {
+    /** Local playback rate, 10.14 samples per frame */
+    uint32_t dwNominal;
+    /** Feedback value for the host, 10.14 samples per frame */
+    uint32_t dwFeedback;
+    /** Integral term of the controller, 10.14 */
+    int32_t  lIntegral;
+    /** Target fill level in frames */
+    uint32_t dwTarget;
+    /** Drift in ppm engaging the resampler */
+    uint32_t dwThreshold;
+    /** Last measured drift of the host rate, ppm */
+    int32_t  lDrift;
+    /** Packets of the current measure */
+    uint32_t dwPackets;
+    /** Frames received in the current measure */
+    uint32_t dwReceived;
+    /** Frames produced in the current measure */
+    uint32_t dwProduced;
+    /** Fill level at the start of the current measure */
+    uint32_t dwFillStart;
+    /** Resampler step, input frames per output frame in Q16 */
+    uint32_t dwStep;
+    /** Resampler position in the history and input, Q16 */
+    uint32_t dwPos;
+    /** Number of interleaved channels */
+    uint8_t  bNumChannels;
+    /** Resampler engaged */
+    uint8_t  bEngaged;
+    /** Last input samples */
+    int16_t  sHistory[(AUDDRateAdapter_TAPS - 1)
+                      * AUDDRateAdapter_MAXCHANNELS];
+} AUDDRateAdapter;
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+extern void AUDDRateAdapter_Initialize(AUDDRateAdapter *pRa,
+                                       uint32_t dwNominal,
+                                       uint8_t bNumChannels,
+                                       uint32_t dwTarget,
+                                       uint32_t dwThreshold);
+
+extern void AUDDRateAdapter_Reset(AUDDRateAdapter *pRa);
+
+extern uint32_t AUDDRateAdapter_Process(AUDDRateAdapter *pRa,
+                                        const int16_t *pIn,
+                                        uint32_t dwFrames,
+                                        int16_t *pOut);
+
+extern uint32_t AUDDRateAdapter_Update(AUDDRateAdapter *pRa,
+                                       uint32_t dwReceived,
+                                       uint32_t dwFill);
+
+/**@}*/
+
+#endif /*#ifndef AUDDRATEADAPTER_H*/
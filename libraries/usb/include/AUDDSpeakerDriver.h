@@ -39,6 +39,8 @@
  *   -# Enable and setup USB related pins (see pio & board.h).
  *   -# Configure the USB Audio Speaker driver using AUDDSpeakerDriver_Initialize
  *   -# To get %audio stream frames from host, use AUDDSpeakerDriver_Read
+ *   -# With an asynchronous stream (feedback endpoint in the descriptors),
+ *      give the playback rate to the host with AUDDSpeakerDriver_SetFeedback
  */
 
 #ifndef AUDDSPEAKERDRIVER_H
@@ -93,6 +95,20 @@
 #define AUDDSpeakerDriver_NUMCHANNELS       2
 /**     @}*/
 
+/** \addtogroup usbd_audio_speaker_fb USB Device Audio Speaker Feedback
+ *      @{
+ * This page lists the definitions for the explicit feedback of an
+ * asynchronous speaker stream (full speed, 10.14 samples per frame).
+ * - \ref AUDDSpeakerDriver_FEEDBACKSIZE
+ * - \ref AUDDSpeakerDriver_FEEDBACK
+ */
+/** Size in bytes of a feedback packet. */
+#define AUDDSpeakerDriver_FEEDBACKSIZE      3
+/** Feedback value for a sample rate in Hz. */
+#define AUDDSpeakerDriver_FEEDBACK(rate)    ((((rate) / 1000) << 14) \
+                                            | ((((rate) % 1000) << 14) / 1000))
+/**     @}*/
+
 /** \addtogroup usbd_audio_speaker_if USB Device Audio Speaker Interface IDs
  *      @{
  * This page lists the interface numbers for USB Audio Speaker device.
@@ -223,6 +239,38 @@ typedef struct _AUDDSpeakerDriverConfigurationDescriptors {
 
 } __attribute__ ((packed)) AUDDSpeakerDriverConfigurationDescriptors; /* GCC */
 
+/**
+ * \typedef AUDDSpeakerDriverAsyncConfigurationDescriptors
+ * \brief Holds a list of descriptors returned as part of the configuration of
+ *        a USB audio speaker device with an asynchronous stream, whose
+ *        rate is given back to the host on a feedback endpoint.
+ */
+typedef struct _AUDDSpeakerDriverAsyncConfigurationDescriptors {
+
+    /** Standard configuration. */
+    USBConfigurationDescriptor configuration;
+    /** Audio control interface. */
+    USBInterfaceDescriptor control;
+    /** Descriptors for the audio control interface. */
+    AUDDSpeakerDriverAudioControlDescriptors controlDescriptors;
+    /* - AUDIO OUT */
+    /** Streaming out interface descriptor (with no endpoint, required). */
+    USBInterfaceDescriptor streamingOutNoIsochronous;
+    /** Streaming out interface descriptor. */
+    USBInterfaceDescriptor streamingOut;
+    /** Audio class descriptor for the streaming out interface. */
+    AUDStreamingInterfaceDescriptor streamingOutClass;
+    /** Stream format descriptor. */
+    AUDFormatTypeOneDescriptor1 streamingOutFormatType;
+    /** Streaming out endpoint descriptor (asynchronous). */
+    AUDEndpointDescriptor streamingOutEndpoint;
+    /** Audio class descriptor for the streaming out endpoint. */
+    AUDDataEndpointDescriptor streamingOutDataEndpoint;
+    /** Streaming feedback endpoint descriptor. */
+    AUDEndpointDescriptor streamingFeedbackEndpoint;
+
+} __attribute__ ((packed)) AUDDSpeakerDriverAsyncConfigurationDescriptors; /* GCC */
+
 #ifdef __ICCARM__          /* IAR */
 #pragma pack()             /* IAR */
 #endif                     /* IAR */
@@ -246,6 +294,8 @@ extern uint8_t AUDDSpeakerDriver_Read(void *buffer,
                                       TransferCallback callback,
                                       void *argument);
 
+extern void AUDDSpeakerDriver_SetFeedback(uint32_t dwFeedback);
+
 extern void AUDDSpeakerDriver_MuteChanged(uint8_t channel,uint8_t muted);
 
 extern void AUDDSpeakerDriver_StreamSettingChanged(uint8_t newSetting);
@@ -129,6 +129,10 @@ extern USBGenericDescriptor* AUDDSpeakerPhone_ParseInterfaces(
     USBGenericDescriptor * pDescriptors,
     uint32_t dwLength);
 
+extern void AUDDSpeakerPhone_MapInterfaces(
+    AUDDSpeakerPhone * pAudf,
+    const USBDFunctionMap * pMap);
+
 extern uint32_t AUDDSpeakerPhone_RequestHandler(
     AUDDSpeakerPhone * pAudf,
     const USBGenericRequest * pRequest);
@@ -137,6 +141,11 @@ extern uint32_t AUDDSpeakerPhone_CloseStream(
     AUDDSpeakerPhone * pAudf,
     uint32_t bInterface);
 
+extern uint32_t AUDDSpeakerPhone_SetupRead(
+    AUDDSpeakerPhone * pAudf,
+    void * pListInit, uint16_t listSize,
+    TransferCallback callback,void * argument);
+
 extern uint32_t AUDDSpeakerPhone_SetupWrite(
     AUDDSpeakerPhone * pAudf,
     void * pListInit, void * pDmaInit, uint16_t listSize, uint16_t delaySize,
@@ -288,6 +288,11 @@ extern uint8_t AUDDSpeakerPhoneDriver_Read(void *buffer,
                                            TransferCallback callback,
                                            void *argument);
 
+extern uint8_t AUDDSpeakerPhoneDriver_SetupRead(void * pListInit,
+                                                uint16_t listSize,
+                                                TransferCallback callback,
+                                                void * argument);
+
 extern uint8_t AUDDSpeakerPhoneDriver_SetupWrite(void * pListInit,
                                                  void * pDmaInit,
                                                  uint16_t listSize,
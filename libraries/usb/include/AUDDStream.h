@@ -90,6 +90,8 @@ typedef struct _AUDDStream {
     uint8_t     bEndpointOut;
     /** Streaming IN  endpoint address */
     uint8_t     bEndpointIn;
+    /** Explicit feedback (IN) endpoint address for asynchronous OUT stream */
+    uint8_t     bEndpointFb;
     /** Number of channels (<=8) */
     uint8_t     bNumChannels;
     /** Mute control bits  (8b) */
@@ -133,6 +135,11 @@ extern uint32_t AUDDStream_Read(
     void * pData, uint32_t dwSize,
     TransferCallback fCallback,void * pArg);
 
+extern uint32_t AUDDStream_SetupRead(
+    AUDDStream * pAuds,
+    void * pListInit, uint16_t listSize,
+    TransferCallback callback,void * argument);
+
 extern uint32_t AUDDStream_SetupWrite(
     AUDDStream * pAuds,
     void * pListInit, void * pDmaInit, uint16_t listSize,
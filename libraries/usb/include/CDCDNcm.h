@@ -0,0 +1,421 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2008, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file
+ *  Definition of a class for implementing a USB device CDC Network Control
+ *  Model (NCM) function.
+ *
+ *  Ethernet frames are carried in NCM Transfer Blocks (NTB, 16-bit format
+ *  only), each holding several datagrams, so that a bulk transfer moves many
+ *  small frames. Frames are given to and taken from the IP stack inside the
+ *  NTB buffers, never copied:
+ *  - host to device: CDCDNcm_GetFrame() returns the next datagram of a
+ *    received NTB, CDCDNcm_ReleaseFrame() gives it back; the NTB buffer is
+ *    re-armed once all its datagrams are released.
+ *  - device to host: CDCDNcm_AllocFrame() returns room in the NTB being
+ *    filled, CDCDNcm_SendFrame() commits the frame. The NTB is sent at once
+ *    when the bulk IN endpoint is idle, otherwise the frames gather in it
+ *    until the current transfer ends.
+ */
+
+#ifndef _CDCDNCM_H_
+#define _CDCDNCM_H_
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+/* These headers were introduced in C99
+   by working group ISO/IEC JTC1/SC22/WG14. */
+#include <stdint.h>
+
+#include <USBRequests.h>
+#include <CDCDescriptors.h>
+#include <USBD.h>
+#include <USBDDriver.h>
+/** \addtogroup usbd_cdc
+ *@{
+ */
+
+/*------------------------------------------------------------------------------
+ *         Defines
+ *------------------------------------------------------------------------------*/
+
+/** \addtogroup usbd_cdc_ncm_desc USB Device NCM Descriptor Values
+ *      @{
+ */
+/** Communication interface subclass of the Network Control Model. */
+#define CDCNcm_SUBCLASS                                 0x0D
+/** Data interface protocol of the NCM Transfer Blocks. */
+#define CDCNcm_DATA_PROTOCOL_NTB                        0x01
+/** Ethernet Networking functional descriptor subtype. */
+#define CDCGenericDescriptor_ETHERNETNETWORKING         0x0F
+/** NCM functional descriptor subtype. */
+#define CDCGenericDescriptor_NCM                        0x1A
+/** NCM specification release number 1.00. */
+#define CDCNcm_NCM1_00                                  0x0100
+/** bmNetworkCapabilities: SetEthernetPacketFilter supported. */
+#define CDCNcmDescriptor_PACKETFILTER                   (1 << 0)
+/** bmNetworkCapabilities: Get/SetMaxDatagramSize supported. */
+#define CDCNcmDescriptor_MAXDATAGRAMSIZE                (1 << 3)
+/** Default interrupt endpoint max packet size (16 bytes). */
+#define CDCDNcm_INTERRUPT_MAXPACKETSIZE                 16
+/** Default interrupt endpoint polling rate of Full Speed (16ms). */
+#define CDCDNcm_INTERRUPT_INTERVAL_FS                   16
+/** Default bulk endpoints max packet size (64, for FS). */
+#define CDCDNcm_BULK_MAXPACKETSIZE_FS                   64
+/**     @}*/
+
+/** \addtogroup usbd_cdc_ncm_req USB Device NCM Requests
+ *      @{
+ */
+#define CDCNcmRequest_SETETHERNETPACKETFILTER           0x43
+#define CDCNcmRequest_GETNTBPARAMETERS                  0x80
+#define CDCNcmRequest_GETNTBFORMAT                      0x83
+#define CDCNcmRequest_SETNTBFORMAT                      0x84
+#define CDCNcmRequest_GETNTBINPUTSIZE                   0x85
+#define CDCNcmRequest_SETNTBINPUTSIZE                   0x86
+#define CDCNcmRequest_GETMAXDATAGRAMSIZE                0x87
+#define CDCNcmRequest_SETMAXDATAGRAMSIZE                0x88
+/**     @}*/
+
+/** \addtogroup usbd_cdc_ncm_notif USB Device NCM Notifications
+ *      @{
+ */
+#define CDCNcmNotification_NETWORKCONNECTION            0x00
+#define CDCNcmNotification_CONNECTIONSPEEDCHANGE        0x2A
+/**     @}*/
+
+/** \addtogroup usbd_cdc_ncm_ntb NCM Transfer Block Values
+ *      @{
+ */
+/** NTH16 signature "NCMH". */
+#define CDCNcmNth16_SIGNATURE                           0x484D434E
+/** NDP16 signature "NCM0", no CRC. */
+#define CDCNcmNdp16_SIGNATURE                           0x304D434E
+/** bmNtbFormatsSupported: 16-bit NTB. */
+#define CDCNcmNtbFormat_16BIT                           (1 << 0)
+/**     @}*/
+
+/** \addtogroup usbd_cdc_ncm_events USB Device NCM Events
+ *      @{
+ */
+/** The host selected the data alternate setting, the link is up */
+#define CDCDNcmEvent_CONNECTED                          0
+/** The host left the data alternate setting, the link is down */
+#define CDCDNcmEvent_DISCONNECTED                       1
+/** An NTB was received, frames are waiting for CDCDNcm_GetFrame() */
+#define CDCDNcmEvent_FRAMERECEIVED                      2
+/** An NTB was sent, room is free for CDCDNcm_AllocFrame() */
+#define CDCDNcmEvent_FRAMESENT                          3
+/** SetEthernetPacketFilter received, value is the new filter */
+#define CDCDNcmEvent_PACKETFILTER                       4
+/**     @}*/
+
+/** Size of each of the two OUT (host to device) NTB buffers in bytes. */
+#ifndef CDCDNcm_NTB_OUT_SIZE
+#define CDCDNcm_NTB_OUT_SIZE        2048
+#endif
+
+/** Size of each of the two IN (device to host) NTB buffers in bytes. */
+#ifndef CDCDNcm_NTB_IN_SIZE
+#define CDCDNcm_NTB_IN_SIZE         2048
+#endif
+
+/** Maximum number of datagrams gathered in an IN NTB. */
+#ifndef CDCDNcm_NTB_IN_DATAGRAMS
+#define CDCDNcm_NTB_IN_DATAGRAMS    16
+#endif
+
+/** Largest Ethernet frame, without CRC. */
+#define CDCDNcm_MAX_DATAGRAM_SIZE   1514
+
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+#ifdef __ICCARM__          /* IAR */
+#pragma pack(1)            /* IAR */
+#define __attribute__(...) /* IAR */
+#endif                     /* IAR */
+
+/**
+ * \typedef CDCEthernetNetworkingDescriptor
+ * \brief Ethernet Networking functional descriptor.
+ */
+typedef struct _CDCEthernetNetworkingDescriptor {
+
+    /** Size of this descriptor in bytes (13). */
+    uint8_t bFunctionLength;
+    /** Descriptor type (CDCGenericDescriptor_INTERFACE). */
+    uint8_t bDescriptorType;
+    /** Descriptor subtype (CDCGenericDescriptor_ETHERNETNETWORKING). */
+    uint8_t bDescriptorSubtype;
+    /** Index of the string descriptor holding the MAC address. */
+    uint8_t iMACAddress;
+    /** Ethernet statistics supported. */
+    uint32_t bmEthernetStatistics;
+    /** Maximum segment size. */
+    uint16_t wMaxSegmentSize;
+    /** Number of multicast filters. */
+    uint16_t wNumberMCFilters;
+    /** Number of power filters. */
+    uint8_t bNumberPowerFilters;
+
+} __attribute__ ((packed)) CDCEthernetNetworkingDescriptor; /* GCC */
+
+/**
+ * \typedef CDCNcmDescriptor
+ * \brief NCM functional descriptor.
+ */
+typedef struct _CDCNcmDescriptor {
+
+    /** Size of this descriptor in bytes (6). */
+    uint8_t bFunctionLength;
+    /** Descriptor type (CDCGenericDescriptor_INTERFACE). */
+    uint8_t bDescriptorType;
+    /** Descriptor subtype (CDCGenericDescriptor_NCM). */
+    uint8_t bDescriptorSubtype;
+    /** NCM specification release number. */
+    uint16_t bcdNcmVersion;
+    /** Supported requests (CDCNcmDescriptor_ bits). */
+    uint8_t bmNetworkCapabilities;
+
+} __attribute__ ((packed)) CDCNcmDescriptor; /* GCC */
+
+/**
+ * \typedef CDCNcmNth16
+ * \brief 16-bit NCM Transfer Header.
+ */
+typedef struct _CDCNcmNth16 {
+
+    /** CDCNcmNth16_SIGNATURE. */
+    uint32_t dwSignature;
+    /** Size of this header in bytes (12). */
+    uint16_t wHeaderLength;
+    /** Sequence number of the NTB. */
+    uint16_t wSequence;
+    /** Size of the whole NTB in bytes. */
+    uint16_t wBlockLength;
+    /** Offset of the first NDP in the NTB. */
+    uint16_t wNdpIndex;
+
+} __attribute__ ((packed)) CDCNcmNth16; /* GCC */
+
+/**
+ * \typedef CDCNcmNdp16
+ * \brief 16-bit NCM Datagram Pointer table, followed by wDatagramIndex and
+ *        wDatagramLength pairs ended by a null pair.
+ */
+typedef struct _CDCNcmNdp16 {
+
+    /** CDCNcmNdp16_SIGNATURE. */
+    uint32_t dwSignature;
+    /** Size of the table in bytes, multiple of 4. */
+    uint16_t wLength;
+    /** Offset of the next NDP in the NTB, 0 if none. */
+    uint16_t wNextNdpIndex;
+    /** Datagram offset and length pairs. */
+    uint16_t awDatagram[2];
+
+} __attribute__ ((packed)) CDCNcmNdp16; /* GCC */
+
+/**
+ * \typedef CDCNcmNtbParameters
+ * \brief Data of the GetNtbParameters request.
+ */
+typedef struct _CDCNcmNtbParameters {
+
+    uint16_t wLength;
+    uint16_t bmNtbFormatsSupported;
+    uint32_t dwNtbInMaxSize;
+    uint16_t wNdpInDivisor;
+    uint16_t wNdpInPayloadRemainder;
+    uint16_t wNdpInAlignment;
+    uint16_t wReserved;
+    uint32_t dwNtbOutMaxSize;
+    uint16_t wNdpOutDivisor;
+    uint16_t wNdpOutPayloadRemainder;
+    uint16_t wNdpOutAlignment;
+    uint16_t wNtbOutMaxDatagrams;
+
+} __attribute__ ((packed)) CDCNcmNtbParameters; /* GCC */
+
+#ifdef __ICCARM__          /* IAR */
+#pragma pack()             /* IAR */
+#endif                     /* IAR */
+
+/** Callback function for NCM events */
+typedef void (*CDCDNcmEventHandler)(uint32_t dwEvent,
+                                    uint32_t dwParam,
+                                    void * pArguments);
+
+/** Received NTB buffer */
+typedef struct _CDCDNcmOutNtb {
+    /** NTB data */
+    uint32_t adwData[CDCDNcm_NTB_OUT_SIZE / 4];
+    /** Buffer state (free, reading, holding datagrams) */
+    volatile uint8_t bState;
+    /** Datagrams returned by CDCDNcm_GetFrame() and not released */
+    volatile uint8_t bPending;
+    /** Offset of the current NDP */
+    uint16_t wNdp;
+    /** Offset of the next datagram pair in the current NDP */
+    uint16_t wEntry;
+    /** Size of the received NTB */
+    uint16_t wLength;
+    /** Number of NDPs walked */
+    uint8_t bNdps;
+} CDCDNcmOutNtb;
+
+/** Transmitted NTB buffer */
+typedef struct _CDCDNcmInNtb {
+    /** NTB data */
+    uint32_t adwData[CDCDNcm_NTB_IN_SIZE / 4];
+    /** Offsets and lengths of the gathered datagrams */
+    uint16_t awDatagram[CDCDNcm_NTB_IN_DATAGRAMS][2];
+    /** Number of gathered datagrams */
+    uint8_t bCount;
+    /** Offset of the next datagram */
+    uint16_t wLength;
+} CDCDNcmInNtb;
+
+/**
+ * Struct for USB CDC NCM network function.
+ */
+typedef struct _CDCDNcm {
+    /** USB Driver for the %device */
+    USBDDriver *pUsbd;
+    /** Callback for network events */
+    CDCDNcmEventHandler fEventHandler;
+    /** Callback arguments */
+    void *pArg;
+    /** USB starting interface index */
+    uint8_t bInterfaceNdx;
+    /** USB number of interfaces */
+    uint8_t bNumInterface;
+    /** USB interrupt IN endpoint address */
+    uint8_t bIntInPIPE;
+    /** USB bulk IN endpoint address */
+    uint8_t bBulkInPIPE;
+    /** USB bulk OUT endpoint address */
+    uint8_t bBulkOutPIPE;
+    /** Alternate setting of the data interface (1: link up) */
+    volatile uint8_t bDataAlt;
+    /** Bulk IN endpoint max packet size */
+    uint16_t wMaxPacketIn;
+
+    /** Ethernet packet filter set by the host */
+    uint16_t wPacketFilter;
+    /** Largest IN NTB accepted by the host */
+    uint32_t dwNtbInMaxSize;
+    /** Link speed reported to the host, in bits per second */
+    uint32_t dwLinkSpeed;
+    /** Notification being sent */
+    uint8_t abNotification[16];
+    /** Notifications waiting for the interrupt endpoint */
+    volatile uint8_t bNotifyPending;
+    /** 1 while a notification is sent */
+    volatile uint8_t bNotifyBusy;
+
+    /** Received NTB buffers */
+    CDCDNcmOutNtb aOut[2];
+    /** OUT buffer the next read goes to */
+    volatile uint8_t bOutRead;
+    /** OUT buffer CDCDNcm_GetFrame() takes datagrams from */
+    volatile uint8_t bOutParse;
+    /** OUT buffer CDCDNcm_ReleaseFrame() releases datagrams of */
+    volatile uint8_t bOutRelease;
+
+    /** Transmitted NTB buffers */
+    CDCDNcmInNtb aIn[2];
+    /** IN buffer gathering frames */
+    volatile uint8_t bInFill;
+    /** 1 while the other IN buffer is written */
+    volatile uint8_t bInBusy;
+    /** 1 between CDCDNcm_AllocFrame() and CDCDNcm_SendFrame() */
+    volatile uint8_t bInAllocated;
+    /** Sequence number of the next IN NTB */
+    uint16_t wInSequence;
+
+    /** Received datagrams */
+    uint32_t dwRxFrames;
+    /** Received NTBs */
+    uint32_t dwRxNtbs;
+    /** Dropped malformed NTBs */
+    uint32_t dwRxErrors;
+    /** Transmitted datagrams */
+    uint32_t dwTxFrames;
+    /** Transmitted NTBs */
+    uint32_t dwTxNtbs;
+} CDCDNcm;
+
+/*------------------------------------------------------------------------------
+ *         Functions
+ *------------------------------------------------------------------------------*/
+
+extern void CDCDNcm_Initialize(CDCDNcm *pNcm,
+                               USBDDriver *pUsbd,
+                               CDCDNcmEventHandler fCallback,
+                               void *pArg,
+                               uint8_t firstInterface,
+                               uint8_t numInterface);
+
+extern USBGenericDescriptor * CDCDNcm_ParseInterfaces(
+    CDCDNcm * pNcm,
+    USBGenericDescriptor * pDescriptors, uint32_t dwLength);
+
+extern void CDCDNcm_MapInterfaces(
+    CDCDNcm * pNcm,
+    const USBDFunctionMap * pMap);
+
+extern uint32_t CDCDNcm_RequestHandler(
+    CDCDNcm *pNcm,
+    const USBGenericRequest *pRequest);
+
+extern void CDCDNcm_InterfaceSettingChanged(
+    CDCDNcm *pNcm,
+    uint8_t bInterface, uint8_t bSetting);
+
+extern void CDCDNcm_SetLinkSpeed(CDCDNcm *pNcm, uint32_t dwSpeed);
+
+extern uint8_t CDCDNcm_IsConnected(const CDCDNcm *pNcm);
+
+extern uint32_t CDCDNcm_GetFrame(CDCDNcm *pNcm, uint8_t **ppFrame);
+
+extern void CDCDNcm_ReleaseFrame(CDCDNcm *pNcm);
+
+extern uint8_t * CDCDNcm_AllocFrame(CDCDNcm *pNcm, uint32_t dwLength);
+
+extern void CDCDNcm_SendFrame(CDCDNcm *pNcm, uint32_t dwLength);
+
+extern void CDCDNcm_CancelFrame(CDCDNcm *pNcm);
+
+/**@}*/
+#endif /* #ifndef _CDCDNCM_H_ */
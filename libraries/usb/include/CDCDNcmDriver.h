@@ -0,0 +1,151 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2008, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * \section Purpose
+ *
+ * Definition of a class for implementing a USB device CDC NCM network
+ * driver.
+ *
+ * \section Usage
+ *
+ * -# Re-implement the USBDCallbacks_RequestReceived method to pass
+ *    received requests to CDCDNcmDriver_RequestHandler.
+ * -# Re-implement USBDDriverCallbacks_ConfigurationChanged and
+ *    USBDDriverCallbacks_InterfaceSettingChanged to call
+ *    CDCDNcmDriver_ConfigurationChangedHandler and
+ *    CDCDNcmDriver_InterfaceSettingChangedHandler.
+ * -# Initialize the CDC NCM and USB drivers using CDCDNcmDriver_Initialize.
+ * -# Logically connect the device to the host using USBD_Connect.
+ * -# Exchange Ethernet frames with the CDCDNcm frame functions on the
+ *    instance given by CDCDNcmDriver_GetFunction.
+ */
+
+#ifndef CDCDNCMDRIVER_H
+#define CDCDNCMDRIVER_H
+
+/** \addtogroup usbd_cdc
+ *@{
+ */
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+/* These headers were introduced in C99
+   by working group ISO/IEC JTC1/SC22/WG14. */
+#include <stdint.h>
+
+#include <USBRequests.h>
+#include <CDCDescriptors.h>
+
+#include <CDCDNcm.h>
+
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** \addtogroup usbd_cdc_ncm_if USB Device CDC NCM Interface IDs
+ *      @{
+ */
+/** Communication Class Interface ID */
+#define CDCDNcmDriver_CC_INTERFACE              0
+/** Data Class Interface ID */
+#define CDCDNcmDriver_DC_INTERFACE              1
+/**     @}*/
+
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+#ifdef __ICCARM__          /* IAR */
+#pragma pack(1)            /* IAR */
+#define __attribute__(...) /* IAR */
+#endif                     /* IAR */
+
+/**
+ * \typedef CDCDNcmDriverConfigurationDescriptors
+ * \brief Configuration descriptor list for a device implementing a
+ *        CDC NCM driver.
+ */
+typedef struct _CDCDNcmDriverConfigurationDescriptors {
+
+    /** Standard configuration descriptor. */
+    USBConfigurationDescriptor configuration;
+    /** Communication interface descriptor. */
+    USBInterfaceDescriptor  communication;
+    /** CDC header functional descriptor. */
+    CDCHeaderDescriptor header;
+    /** CDC union functional descriptor (with one slave interface). */
+    CDCUnionDescriptor union1;
+    /** Ethernet networking functional descriptor. */
+    CDCEthernetNetworkingDescriptor ethernet;
+    /** NCM functional descriptor. */
+    CDCNcmDescriptor ncm;
+    /** Notification endpoint descriptor. */
+    USBEndpointDescriptor notification;
+    /** Data interface descriptor, setting 0 without endpoints. */
+    USBInterfaceDescriptor dataIdle;
+    /** Data interface descriptor, setting 1 with the bulk endpoints. */
+    USBInterfaceDescriptor data;
+    /** Data OUT endpoint descriptor. */
+    USBEndpointDescriptor dataOut;
+    /** Data IN endpoint descriptor. */
+    USBEndpointDescriptor dataIn;
+
+} __attribute__ ((packed)) CDCDNcmDriverConfigurationDescriptors;
+
+#ifdef __ICCARM__          /* IAR */
+#pragma pack()             /* IAR */
+#endif                     /* IAR */
+
+/*------------------------------------------------------------------------------
+ *      Exported functions
+ *------------------------------------------------------------------------------*/
+
+extern void CDCDNcmDriver_Initialize(
+    const USBDDriverDescriptors *pDescriptors,
+    CDCDNcmEventHandler fEventHandler,
+    void *pArg);
+
+extern void CDCDNcmDriver_ConfigurationChangedHandler(uint8_t cfgnum);
+
+extern void CDCDNcmDriver_InterfaceSettingChangedHandler(
+    uint8_t interface, uint8_t setting);
+
+extern void CDCDNcmDriver_RequestHandler(
+    const USBGenericRequest *request);
+
+extern CDCDNcm * CDCDNcmDriver_GetFunction(void);
+
+/**@}*/
+
+#endif /*#ifndef CDCDNCMDRIVER_H*/
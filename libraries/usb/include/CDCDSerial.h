@@ -74,6 +74,8 @@ extern uint32_t CDCDSerial_RequestHandler(
 extern void CDCDSerial_ConfigureFunction(
     USBGenericDescriptor * pDescriptors, uint16_t wLength);
 
+extern void CDCDSerial_ConfigureFunctionMap(const USBDFunctionMap * pMap);
+
 extern uint32_t CDCDSerial_Write(
     void *data,
     uint32_t size,
@@ -0,0 +1,88 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2008, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Zero-copy bridge between a CDC serial port function and an USART.
+ */
+
+#ifndef CDCDSERIALBRIDGE_H
+#define CDCDSERIALBRIDGE_H
+
+/** \addtogroup usbd_cdc
+ *@{
+ */
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include "board.h"
+
+#include <stdint.h>
+
+#include <CDCDSerialPort.h>
+
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Number of buffers of the bridge own pool, shared by both directions; 0 to
+ *  only draw them from the pool given to CDCDSerialBridge_SetBufferPool(). */
+#ifndef CDCDBRIDGE_NUMBUFFERS
+#define CDCDBRIDGE_NUMBUFFERS   8
+#endif
+
+/** Size of a buffer in bytes (multiple of the bulk endpoint size). */
+#ifndef CDCDBRIDGE_BUFFERSIZE
+#define CDCDBRIDGE_BUFFERSIZE   512
+#endif
+
+/** Minimum block size of a pool given to CDCDSerialBridge_SetBufferPool(). */
+#define CDCDBRIDGE_BLOCKSIZE    (CDCDBRIDGE_BUFFERSIZE + 8)
+
+/*------------------------------------------------------------------------------
+ *      Exported functions
+ *------------------------------------------------------------------------------*/
+
+extern uint8_t CDCDSerialBridge_SetBufferPool(MemPool *pPool);
+
+extern void CDCDSerialBridge_Initialize(
+    CDCDSerialPort *pCdcd, Usart *pUsart, uint32_t dwRxTimeout);
+
+extern void CDCDSerialBridge_Start(void);
+
+extern void CDCDSerialBridge_Stop(void);
+
+extern void CDCDSerialBridge_UsartHandler(void);
+
+/**@}*/
+
+#endif /*#ifndef CDCDSERIALBRIDGE_H*/
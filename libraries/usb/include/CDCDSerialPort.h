@@ -135,6 +135,10 @@ extern USBGenericDescriptor * CDCDSerialPort_ParseInterfaces(
     CDCDSerialPort * pCdcd,
     USBGenericDescriptor * pDescriptors, uint32_t dwLength);
 
+extern void CDCDSerialPort_MapInterfaces(
+    CDCDSerialPort * pCdcd,
+    const USBDFunctionMap * pMap);
+
 extern uint32_t CDCDSerialPort_RequestHandler(
     CDCDSerialPort *pCdcd,
     const USBGenericRequest *pRequest);
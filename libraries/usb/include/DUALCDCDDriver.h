@@ -138,6 +138,22 @@ typedef struct _DualCdcDriverConfigurationDescriptors {
 #pragma pack()             /* IAR */
 #endif                     /* IAR */
 
+/**
+ * \typedef DualCdcdStreamStats
+ * \brief Throughput counters of a port in streaming mode. The stall times
+ *        are counted in USB frames (ms).
+ */
+typedef struct _DualCdcdStreamStats {
+    /** Bytes received from the host (bulk OUT) */
+    uint32_t dwBytesOut;
+    /** Bytes sent to the host (bulk IN) */
+    uint32_t dwBytesIn;
+    /** Frames the bulk OUT endpoint was not armed, both buffers being full */
+    uint32_t dwOutStallFrames;
+    /** Frames the application had no free buffer to send */
+    uint32_t dwInStallFrames;
+} DualCdcdStreamStats;
+
 /*---------------------------------------------------------------------------
  *         Exported functions
  *---------------------------------------------------------------------------*/
@@ -152,6 +168,24 @@ extern void DUALCDCDDriver_RequestHandler(const USBGenericRequest *request);
 
 extern CDCDSerialPort* DUALCDCDDriver_GetSerialPort(uint32_t port);
 
+/* - Streaming mode */
+extern void DUALCDCDDriver_StartStreaming(uint32_t port,
+                                          uint8_t *pBuffers,
+                                          uint32_t dwBufferSize);
+
+extern uint32_t DUALCDCDDriver_StreamRead(uint32_t port, uint8_t **ppData);
+
+extern void DUALCDCDDriver_StreamReadDone(uint32_t port);
+
+extern uint8_t* DUALCDCDDriver_StreamGetWriteBuffer(uint32_t port);
+
+extern uint32_t DUALCDCDDriver_StreamWrite(uint32_t port, uint32_t dwSize);
+
+extern int32_t DUALCDCDDriver_StreamGetReadyPort(void);
+
+extern void DUALCDCDDriver_GetStreamStats(uint32_t port,
+                                          DualCdcdStreamStats *pStats);
+
 /**@}*/
 #endif /* #ifndef DUALCDCDDRIVER_H */
 
@@ -40,6 +40,13 @@
  *              GET_REPORT/SET_REPORT,
  *              SET_PROTOCOL/GET_PROTOCOL;
  *   - stall  : SET_DESCRIPTOR.
+ *
+ * For streaming, report queues can replace the report lists
+ * (HIDDFunction_SetQueues()). The application enqueues input reports in a ring
+ * and the interrupt IN endpoint is fed from the ring across frames, several
+ * reports per transfer when a report fills an endpoint packet. Output reports
+ * are received in another ring, the interrupt OUT endpoint being re-armed
+ * immediately. Reports that do not fit in a ring are dropped and counted.
  */
 
 #ifndef _HIDDFUNCTION_H_
@@ -130,6 +137,29 @@ typedef struct _HIDDReport {
     uint8_t bData[1];
 } HIDDReport;
 
+/**
+ * Ring of fixed size reports for streaming. One slot is always kept free, so
+ * a ring of N slots holds N-1 reports.
+ */
+typedef struct _HIDDReportQueue {
+    /** Report slots, wNumSlots * wReportSize bytes */
+    uint8_t *pBuffer;
+    /** Report size in bytes */
+    uint16_t wReportSize;
+    /** Number of report slots */
+    uint16_t wNumSlots;
+    /** Oldest report */
+    volatile uint16_t wHead;
+    /** Next free slot */
+    volatile uint16_t wTail;
+    /** Number of reports in the transfer in progress */
+    volatile uint16_t wInTransfer;
+    /** Reports dropped because the ring was full */
+    volatile uint32_t dwDropped;
+    /** Input only: times the IN endpoint ran out of reports */
+    volatile uint32_t dwUnderruns;
+} HIDDReportQueue;
+
 /**
  * Struct for an HID general function.
  * Supports Input/Output reports. No feature report support.
@@ -163,6 +193,13 @@ typedef struct _HIDDFunction {
     uint8_t bOutputListSize;
     /** Current output report */
     uint8_t bCurrOutput;
+
+    /** Max packet size of the interrupt IN EP */
+    uint16_t wInPacketSize;
+    /** Input report queue, replaces the input list */
+    HIDDReportQueue *pInQueue;
+    /** Output report queue, replaces the output list */
+    HIDDReportQueue *pOutQueue;
 } HIDDFunction;
 
 /*----------------------------------------------------------------------------
@@ -181,6 +218,10 @@ extern USBGenericDescriptor* HIDDFunction_ParseInterface(
     USBGenericDescriptor * pDescriptors,
     uint32_t dwLength);
 
+extern void HIDDFunction_MapInterface(
+    HIDDFunction * pHidd,
+    const USBDFunctionMap * pMap);
+
 extern uint32_t HIDDFunction_RequestHandler(
     HIDDFunction * pHidd,
     const USBGenericRequest * request);
@@ -205,6 +246,25 @@ extern void HIDDFunction_InitializeReport(
     uint8_t bID,
     HIDDReportEventCallback fCallback, void* pArg);
 
+extern void HIDDFunction_InitializeQueue(
+    HIDDReportQueue * pQueue,
+    uint8_t * pBuffer,
+    uint16_t wReportSize,
+    uint16_t wNumSlots);
+
+extern void HIDDFunction_SetQueues(
+    HIDDFunction * pHidd,
+    HIDDReportQueue * pInQueue,
+    HIDDReportQueue * pOutQueue);
+
+extern uint32_t HIDDFunction_QueueInput(
+    HIDDFunction * pHidd,
+    const void * pReport);
+
+extern uint32_t HIDDFunction_DequeueOutput(
+    HIDDFunction * pHidd,
+    void * pReport);
+
 /**@}*/
 #endif /* #define _HIDDFUNCTION_H_ */
 
@@ -175,6 +175,8 @@ extern void HIDDKeyboard_Initialize(USBDDriver * pUsbd,uint8_t bInterfaceNb);
 
 extern void HIDDKeyboard_ConfigureFunction( USBGenericDescriptor * pDescriptors, uint16_t wLength);
 
+extern void HIDDKeyboard_ConfigureFunctionMap( const USBDFunctionMap * pMap);
+
 extern uint32_t HIDDKeyboard_RequestHandler( const USBGenericRequest *request);
 
 extern uint32_t HIDDKeyboard_ChangeKeys(
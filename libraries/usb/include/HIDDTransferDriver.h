@@ -45,6 +45,10 @@
  *-# Call the HIDDTransferDriver_Write method when sendint data to host.
  *-# Call the HIDDTransferRead, HIDDTransferReadReport when checking and getting
  *   received data from host.
+ *-# For high rate streaming, give report queues with
+ *   HIDDTransferDriver_SetQueues, then use HIDDTransferDriver_QueueWrite and
+ *   HIDDTransferDriver_QueueRead instead. The drop and underrun counters are
+ *   kept in the HIDDReportQueue instances.
  */
 
 #ifndef HIDDKEYBOARDDRIVER_H
@@ -65,6 +69,7 @@
 
 #include <USBD.h>
 #include <USBDDriver.h>
+#include <HIDDFunction.h>
 
 /*------------------------------------------------------------------------------
  *         Definitions
@@ -133,6 +138,13 @@ extern uint8_t HIDDTransferDriver_Write(const void *pData,
                                         void *pArg);
 
 
+extern void HIDDTransferDriver_SetQueues(HIDDReportQueue *pInQueue,
+                                         HIDDReportQueue *pOutQueue);
+
+extern uint32_t HIDDTransferDriver_QueueWrite(const void *pReport);
+
+extern uint32_t HIDDTransferDriver_QueueRead(void *pReport);
+
 extern void HIDDTransferDriver_RemoteWakeUp(void);
 
 /**@}*/
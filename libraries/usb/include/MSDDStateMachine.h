@@ -250,6 +250,8 @@ static inline void MSDDriver_Callback(MSDTransfer *transfer,
 
 extern void MSDD_StateMachine(MSDDriver * pMsdDriver);
 
+extern void MSDD_DrainCaches(MSDDriver * pMsdDriver, uint32_t maxRuns);
+
 /**@}*/
 
 #endif /* #define MSDDSTATEMACHINE_H */
@@ -66,6 +66,8 @@ extern uint32_t MSDFunction_RequestHandler(
 extern void MSDFunction_Configure(
     USBGenericDescriptor * pDescriptors, uint16_t wLength);
 
+extern void MSDFunction_ConfigureMap(const USBDFunctionMap * pMap);
+
 extern void MSDFunction_StateMachine(void);
 
 /**@}*/
@@ -39,6 +39,8 @@
  *         Headers
  *------------------------------------------------------------------------------*/
 
+#include "USBD.h"
+
 /*------------------------------------------------------------------------------
  *         Definitions
  *------------------------------------------------------------------------------*/
@@ -70,10 +72,32 @@
 #define MSDIO_WRITE10_CHUNK_SIZE    (4*512)
 #endif
 
+/** Number of media operations READ10/WRITE10 keep in flight, one per chunk
+ *  of the FIFO ring buffer. The chunk size is reduced so that the buffer
+ *  always holds at least this many chunks: a media with a request queue
+ *  (MEDSdasync) then works on the next chunks while the USB transfer of
+ *  another is on-going. A media without queue takes one at a time. */
+#ifndef MSDIO_PIPELINE_DEPTH
+#define MSDIO_PIPELINE_DEPTH        2
+#endif
+
 /*------------------------------------------------------------------------------
  *         Types
  *------------------------------------------------------------------------------*/
 
+#if  defined(MSDIO_READ10_CHUNK_SIZE) || defined(MSDIO_WRITE10_CHUNK_SIZE)
+/** \brief Media operation on one chunk of the FIFO */
+typedef struct _MSDIOChunk {
+
+    /** Size of the chunk data in bytes */
+    unsigned int           size;
+    /** Set by the media callback when the operation is done */
+    volatile unsigned char done;
+    /** Result code of the media operation */
+    unsigned char          status;
+} MSDIOChunk;
+#endif
+
 /** \brief FIFO buffer for READ/WRITE (disk) operation of a mass storage device */
 typedef struct _MSDIOFifo {
 
@@ -102,6 +126,25 @@ typedef struct _MSDIOFifo {
     /** The size of one chunk */
     /** (1 block, or several blocks for large amount data R/W) */
     unsigned int    chunkSize;
+#endif
+#ifdef MSDIO_READ10_CHUNK_SIZE
+    /** Size of the data sent by the on-going output transfer (READ10) */
+    unsigned int    outputSize;
+    /** Buffer list of the output transfer, the data may wrap the ring */
+    USBDTransferBuffer outputList[2];
+#endif
+#if  defined(MSDIO_READ10_CHUNK_SIZE) || defined(MSDIO_WRITE10_CHUNK_SIZE)
+    /** The index of the data given to the media (READ10: read ahead of
+        inputNdx, WRITE10: written ahead of outputNdx) */
+    unsigned int    mediaNdx;
+    /** The total size of the data given to the media */
+    unsigned int    mediaTotal;
+    /** Media operations in flight, oldest first */
+    MSDIOChunk      chunks[MSDIO_PIPELINE_DEPTH];
+    /** Index of the oldest operation in chunks */
+    unsigned char   chunkHead;
+    /** Number of operations in flight */
+    unsigned char   chunkCount;
 #endif
     /** State of input & output */
     unsigned char   inputState;
@@ -138,6 +181,11 @@ typedef struct _MSDIOFifo {
 extern void MSDIOFifo_Init(MSDIOFifo *pFifo,
                            void * pBuffer, unsigned short bufferSize);
 
+#if  defined(MSDIO_READ10_CHUNK_SIZE) || defined(MSDIO_WRITE10_CHUNK_SIZE)
+extern unsigned int MSDIOFifo_GetChunkSize(const MSDIOFifo *pFifo,
+                                           unsigned int maxChunk);
+#endif
+
 /**@}*/
 
 #endif /* _MSDIOFIFO_H */
@@ -39,7 +39,15 @@
  * -# Initlalize the LUN with LUN_Init, and link to the initialized Media.
  * -# To read data from the LUN linked media, uses LUN_Read.
  * -# To write data to the LUN linked media, uses LUN_Write.
+ * -# To keep several operations in flight on a media with a request queue,
+ *    uses LUN_QueueRead and LUN_QueueWrite, which return USBD_STATUS_LOCKED
+ *    instead of waiting for the media.
  * -# To unlink the media, uses LUN_Eject.
+ * -# To acknowledge the writes once they are cached in RAM, gives the LUN a
+ *    write cache with LUN_SetWriteCache. The cache is written back to the
+ *    media by LUN_DrainCacheStep (the MSD driver calls it for every LUN
+ *    while the commands are processed), LUN_DrainCache (when the device is
+ *    suspended), LUN_Flush and LUN_Eject.
  */
 
 #ifndef MSDLUN_H
@@ -75,6 +83,9 @@
 #define LUN_EJECTED                 0x01
 /** Media of LUN is changed */
 #define LUN_CHANGED                 0x10
+/** Cache slot holding no data */
+#define LUN_CACHE_FREE              0xFFFFFFFF
+
 /** LUN Not Ready to Ready transition */
 #define LUN_TRANS_READY             LUN_CHANGED
 /** Media of LUN is ready */
@@ -100,6 +111,28 @@ typedef void(*MSDLunDataMonitorFunction)(uint8_t  flowDirection,
  *      Structures
  *------------------------------------------------------------------------------*/
 
+/** \brief Write-back cache of a LUN, the slots are used as a ring */
+typedef struct {
+
+    /** Cached data, one LUN block per slot. */
+    uint8_t               *pBuffer;
+    /** LUN block address of each slot (LUN_CACHE_FREE when dropped). */
+    uint32_t              *pBlockAddress;
+    /** Number of slots. */
+    uint16_t              numBlocks;
+    /** Oldest slot. */
+    uint16_t              head;
+    /** Number of slots in use. */
+    uint16_t              count;
+    /** Number of slots being written, from head. */
+    uint16_t              inFlight;
+    /** Set when the media has written the slots. */
+    volatile uint8_t      runDone;
+    /** Media result code of the write. */
+    uint8_t               runStatus;
+
+} MSDLunCache;
+
 /** \brief LUN structure */
 typedef struct {
 
@@ -135,6 +168,8 @@ typedef struct {
     SBCRequestSenseData   requestSenseData;
     /** Data for the ReadCapacity command. */
     SBCReadCapacity10Data readCapacityData;
+    /** Write-back cache, 0 to write through. */
+    MSDLunCache           *cache;
 
 } MSDLun;
 
@@ -170,6 +205,36 @@ extern uint32_t LUN_Read(MSDLun             *lun,
                       TransferCallback   callback,
                       void               *argument);
 
+extern uint32_t LUN_QueueWrite(MSDLun           *lun,
+                               uint32_t         blockAddress,
+                               void             *data,
+                               uint32_t         length,
+                               TransferCallback callback,
+                               void             *argument);
+
+extern uint32_t LUN_QueueRead(MSDLun           *lun,
+                              uint32_t         blockAddress,
+                              void             *data,
+                              uint32_t         length,
+                              TransferCallback callback,
+                              void             *argument);
+
+extern uint32_t LUN_Flush(MSDLun *lun);
+
+extern uint32_t LUN_Discard(MSDLun   *lun,
+                            uint32_t blockAddress,
+                            uint32_t length);
+
+extern uint32_t LUN_SetWriteCache(MSDLun      *lun,
+                                  MSDLunCache *cache,
+                                  uint8_t     *buffer,
+                                  uint32_t    *blockAddresses,
+                                  uint16_t    numBlocks);
+
+extern uint32_t LUN_DrainCache(MSDLun *lun, uint32_t maxRuns);
+
+extern uint32_t LUN_DrainCacheStep(MSDLun *lun);
+
 /**@}*/
 
 #endif /*#ifndef MSDLUN_H */
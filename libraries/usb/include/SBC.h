@@ -74,6 +74,12 @@
  * - SBC_MODE_SENSE_6
  * - SBC_VERIFY_10
  * - SBC_READ_FORMAT_CAPACITIES
+ *
+ * \section Optional Codes for the media caches
+ * - SBC_READ_12
+ * - SBC_WRITE_12
+ * - SBC_SYNCHRONIZE_CACHE_10
+ * - SBC_UNMAP
  */
 
 /** Request information regarding parameters of the target and Logical Unit. */
@@ -98,6 +104,15 @@
 #define SBC_VERIFY_10                                   0x2F
 /** Request a list of the possible capacities that can be formatted on medium */
 #define SBC_READ_FORMAT_CAPACITIES                      0x23
+/** Request the transfer data to the host, 32-bit transfer length. */
+#define SBC_READ_12                                     0xA8
+/** Request that the device write the data transferred by the host, 32-bit
+    transfer length. */
+#define SBC_WRITE_12                                    0xAA
+/** Request that the cached data of a range be written to the medium. */
+#define SBC_SYNCHRONIZE_CACHE_10                        0x35
+/** Request that the device release the blocks of a list of ranges. */
+#define SBC_UNMAP                                       0x42
 /**      @}*/
 
 /** \addtogroup usbd_sbc_periph_quali SBC Periph. Qualifiers
@@ -305,6 +320,7 @@
 /** \brief  Supported mode pages */
 /** \see    sbc3r06.pdf - Section 6.3.1 - Table 115 */
 #define SBC_PAGE_READ_WRITE_ERROR_RECOVERY            0x01
+#define SBC_PAGE_CACHING                              0x08
 #define SBC_PAGE_INFORMATIONAL_EXCEPTIONS_CONTROL     0x1C
 #define SBC_PAGE_RETURN_ALL                           0x3F
 #define SBC_PAGE_VENDOR_SPECIFIC                      0x00
@@ -537,6 +553,101 @@ typedef struct _SBCWrite10 {
 
 } SBCWrite10;
 
+/**
+ * \typedef SBCRead12
+ * \brief  Data structure for the READ (12) command
+ * \see    sbc3r07.pdf - Section 5.8 - Table 36
+ */
+typedef struct _SBCRead12 {
+
+    unsigned char bOperationCode;          /*!< 0xA8 : SBC_READ_12 */
+    unsigned char bObsolete1:1,            /*!< Obsolete bit */
+                  isFUA_NV:1,              /*!< Cache control bit */
+                  bReserved1:1,            /*!< Reserved bit */
+                  isFUA:1,                 /*!< Cache control bit */
+                  isDPO:1,                 /*!< Cache control bit */
+                  bRdProtect:3;            /*!< Protection information to send */
+    unsigned char pLogicalBlockAddress[4]; /*!< Index of first block to read */
+    unsigned char pTransferLength[4];      /*!< Number of blocks to transmit */
+    unsigned char bGroupNumber:5,          /*!< Information grouping */
+                  bReserved2:3;            /*!< Reserved bits */
+    unsigned char bControl;                /*!< 0x00 */
+
+} __attribute__ ((packed)) SBCRead12; /* GCC */
+
+/**
+ * \typedef SBCWrite12
+ * \brief  Structure for the WRITE (12) command
+ * \see    sbc3r07.pdf - Section 5.27 - Table 72
+ */
+typedef struct _SBCWrite12 {
+
+    unsigned char bOperationCode;          /*!< 0xAA : SBC_WRITE_12 */
+    unsigned char bObsolete1:1,            /*!< Obsolete bit */
+                  isFUA_NV:1,              /*!< Cache control bit */
+                  bReserved1:1,            /*!< Reserved bit */
+                  isFUA:1,                 /*!< Cache control bit */
+                  isDPO:1,                 /*!< Cache control bit */
+                  bWrProtect:3;            /*!< Protection information to send */
+    unsigned char pLogicalBlockAddress[4]; /*!< First block to write */
+    unsigned char pTransferLength[4];      /*!< Number of blocks to write */
+    unsigned char bGroupNumber:5,          /*!< Information grouping */
+                  bReserved2:3;            /*!< Reserved bits */
+    unsigned char bControl;                /*!< 0x00 */
+
+} __attribute__ ((packed)) SBCWrite12; /* GCC */
+
+/**
+ * \typedef SBCSynchronizeCache10
+ * \brief  Structure for the SYNCHRONIZE CACHE (10) command
+ * \see    sbc3r07.pdf - Section 5.18 - Table 58
+ */
+typedef struct _SBCSynchronizeCache10 {
+
+    unsigned char bOperationCode;          /*!< 0x35 : SBC_SYNCHRONIZE_CACHE_10 */
+    unsigned char bObsolete1:1,            /*!< Obsolete bit */
+                  isImmed:1,               /*!< Return before the cache is written */
+                  isSyncNV:1,              /*!< Non-volatile cache only */
+                  bReserved1:5;            /*!< Reserved bits */
+    unsigned char pLogicalBlockAddress[4]; /*!< First block to synchronize */
+    unsigned char bGroupNumber:5,          /*!< Information grouping */
+                  bReserved2:3;            /*!< Reserved bits */
+    unsigned char pNumberOfBlocks[2];      /*!< Number of blocks, 0 for all */
+    unsigned char bControl;                /*!< 0x00 */
+
+} __attribute__ ((packed)) SBCSynchronizeCache10; /* GCC */
+
+/**
+ * \typedef SBCUnmap
+ * \brief  Structure for the UNMAP command
+ * \see    sbc3r20.pdf - Section 5.26 - Table 101
+ */
+typedef struct _SBCUnmap {
+
+    unsigned char bOperationCode;          /*!< 0x42 : SBC_UNMAP */
+    unsigned char isAnchor:1,              /*!< Anchor the blocks */
+                  bReserved1:7;            /*!< Reserved bits */
+    unsigned char pReserved2[4];           /*!< Reserved bytes */
+    unsigned char bGroupNumber:5,          /*!< Information grouping */
+                  bReserved3:3;            /*!< Reserved bits */
+    unsigned char pParameterListLength[2]; /*!< Size of the parameter list */
+    unsigned char bControl;                /*!< 0x00 */
+
+} __attribute__ ((packed)) SBCUnmap; /* GCC */
+
+/**
+ * \typedef SBCUnmapBlockDescriptor
+ * \brief  Range of the UNMAP parameter list, following the 8-byte header
+ * \see    sbc3r20.pdf - Section 5.26.2 - Table 103
+ */
+typedef struct _SBCUnmapBlockDescriptor {
+
+    unsigned char pLogicalBlockAddress[8]; /*!< First block to unmap */
+    unsigned char pNumberOfBlocks[4];      /*!< Number of blocks */
+    unsigned char pReserved[4];            /*!< Reserved bytes */
+
+} __attribute__ ((packed)) SBCUnmapBlockDescriptor; /* GCC */
+
 /**
  * \typedef SBCMediumRemoval
  * \brief  Structure for the PREVENT/ALLOW MEDIUM REMOVAL command
@@ -642,6 +753,44 @@ typedef struct _SBCReadWriteErrorRecovery {
 
 } __attribute__ ((packed)) SBCReadWriteErrorRecovery; /* GCC */
 
+/**
+ * \typedef SBCCachingModePage
+ * \brief  Caching mode page
+ * \see    sbc3r07.pdf - Section 6.3.3 - Table 113
+ */
+typedef struct _SBCCachingModePage {
+
+    unsigned char bPageCode:6,               /*!< 0x08 : SBC_PAGE_CACHING */
+                  isSPF:1,                   /*!< Page or subpage data format */
+                  isPS:1;                    /*!< Parameters saveable ? */
+    unsigned char bPageLength;               /*!< Length of page data (0x12) */
+    unsigned char isRCD:1,                   /*!< Read cache disable bit */
+                  isMF:1,                    /*!< Multiplication factor bit */
+                  isWCE:1,                   /*!< Write cache enable bit */
+                  isSIZE:1,                  /*!< Size enable bit */
+                  isDISC:1,                  /*!< Discontinuity bit */
+                  isCAP:1,                   /*!< Caching analysis permitted bit */
+                  isABPF:1,                  /*!< Abort prefetch bit */
+                  isIC:1;                    /*!< Initiator control bit */
+    unsigned char bWriteRetentionPriority:4, /*!< Write retention priority */
+                  bReadRetentionPriority:4;  /*!< Demand read retention priority */
+    unsigned char pDisablePrefetchLength[2]; /*!< Disable prefetch transfer length */
+    unsigned char pMinimumPrefetch[2];       /*!< Minimum prefetch */
+    unsigned char pMaximumPrefetch[2];       /*!< Maximum prefetch */
+    unsigned char pMaximumPrefetchCeiling[2];/*!< Maximum prefetch ceiling */
+    unsigned char isNVDIS:1,                 /*!< Non-volatile cache disable bit */
+                  bReserved1:2,              /*!< Reserved bits */
+                  bVendorSpecific:2,         /*!< Vendor specific bits */
+                  isDRA:1,                   /*!< Disable read-ahead bit */
+                  isLBCSS:1,                 /*!< Logical block cache segment size bit */
+                  isFSW:1;                   /*!< Force sequential write bit */
+    unsigned char bNumberOfCacheSegments;    /*!< Number of cache segments */
+    unsigned char pCacheSegmentSize[2];      /*!< Cache segment size */
+    unsigned char bReserved2;                /*!< Reserved byte */
+    unsigned char pObsolete1[3];             /*!< Obsolete bytes */
+
+} __attribute__ ((packed)) SBCCachingModePage; /* GCC */
+
 /**
  * \typedef SBCCommand
  * \brief  Generic structure for holding information about SBC commands
@@ -653,6 +802,10 @@ typedef struct _SBCReadWriteErrorRecovery {
  * \see    SBCWrite10
  * \see    SBCMediumRemoval
  * \see    SBCModeSense6
+ * \see    SBCRead12
+ * \see    SBCWrite12
+ * \see    SBCSynchronizeCache10
+ * \see    SBCUnmap
  */
 typedef union _SBCCommand {
 
@@ -665,6 +818,10 @@ typedef union _SBCCommand {
     SBCWrite10        write10;        /*!< WRITE (10) command */
     SBCMediumRemoval  mediumRemoval;  /*!< PREVENT/ALLOW MEDIUM REMOVAL command */
     SBCModeSense6     modeSense6;     /*!< MODE SENSE (6) command */
+    SBCRead12         read12;         /*!< READ (12) command */
+    SBCWrite12        write12;        /*!< WRITE (12) command */
+    SBCSynchronizeCache10 synchronizeCache10; /*!< SYNCHRONIZE CACHE (10) command */
+    SBCUnmap          unmap;          /*!< UNMAP command */
 
 } SBCCommand;
 
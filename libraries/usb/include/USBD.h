@@ -141,6 +141,16 @@
 #define USBD_STATE_CONFIGURED           5
 /**  @}*/
 
+/** Number of endpoints in USBDStats */
+#define USBD_STATS_ENDPOINTS            8
+
+/** Vendor request (device recipient, IN) answered with the USBDStats block
+    once USBD_EnableStats() was called; wValue 1 clears the counters once
+    read. */
+#ifndef USBD_STATS_VENDORCODE
+#define USBD_STATS_VENDORCODE           0x5A
+#endif
+
 /*----------------------------------------------------------------------------
  *         Types
  *----------------------------------------------------------------------------*/
@@ -208,6 +218,48 @@ typedef void (*TransferCallback)(void *pArg,
 typedef void (*MblTransferCallback)(void *pArg,
                                     uint8_t status);
 
+/**
+ * Counters of one endpoint, see USBD_GetStats().
+ */
+typedef struct _USBDEPStats {
+    /** Bytes moved through the FIFO */
+    uint32_t dwBytes;
+    /** Packets sent or received */
+    uint32_t dwPackets;
+    /** OUT packets held in the FIFO (NAKed) for want of a buffer, IN
+        streams run dry */
+    uint32_t dwStarved;
+    /** STALL handshakes sent, CRC errors on isochronous endpoints */
+    uint32_t dwStalls;
+    /** Interrupts serviced */
+    uint32_t dwIrqCount;
+    /** Core clock cycles spent servicing them */
+    uint32_t dwIrqCycles;
+} USBDEPStats;
+
+/**
+ * Device statistics returned by USBD_GetStats() and by the
+ * USBD_STATS_VENDORCODE request, little endian words.
+ */
+typedef struct _USBDStats {
+    /** Core clock frequency, to convert the cycles */
+    uint32_t dwMck;
+    /** Bus resets */
+    uint32_t dwResets;
+    /** Suspends */
+    uint32_t dwSuspends;
+    /** Resumes */
+    uint32_t dwResumes;
+    /** Interrupts serviced */
+    uint32_t dwIrqCount;
+    /** Core clock cycles spent servicing them */
+    uint32_t dwIrqCycles;
+    /** Longest service, in core clock cycles */
+    uint32_t dwIrqMaxCycles;
+    /** Counters of each endpoint */
+    USBDEPStats aEndpoints[USBD_STATS_ENDPOINTS];
+} USBDStats;
+
 /**@}*/
 
 /*------------------------------------------------------------------------------
@@ -238,6 +290,20 @@ extern uint8_t USBD_Read(
     TransferCallback fCallback,
     void *pArg);
 
+extern uint8_t USBD_WriteList(
+    uint8_t bEndpoint,
+    USBDTransferBuffer *pList,
+    uint16_t listSize,
+    TransferCallback fCallback,
+    void *pArg);
+
+extern uint8_t USBD_ReadList(
+    uint8_t bEndpoint,
+    USBDTransferBuffer *pList,
+    uint16_t listSize,
+    TransferCallback fCallback,
+    void *pArg);
+
 extern uint8_t USBD_Stall(uint8_t bEndpoint);
 
 extern void USBD_Halt(uint8_t bEndpoint);
@@ -260,6 +326,10 @@ extern uint8_t USBD_IsHighSpeed(void);
 
 extern void USBD_Test(uint8_t bIndex);
 
+extern void USBD_EnableStats(uint8_t bEnable);
+
+extern void USBD_GetStats(USBDStats *pStats, uint8_t bReset);
+
 extern void USBD_SuspendHandler(void);
 extern void USBD_ResumeHandler(void);
 extern void USBD_ResetHandler(void);
@@ -69,6 +69,41 @@
  *         Types
  *------------------------------------------------------------------------------*/
 
+/**
+ * \typedef USBDFunctionMap
+ * \brief Interfaces and endpoints of one function of a composite device.
+ *
+ *        The map is a constant written next to the configuration descriptors,
+ *        with the same interface and endpoint defines, so that the function
+ *        is configured without parsing the descriptors on each
+ *        SET_CONFIGURATION. Interface and endpoint numbers are the same for
+ *        all speeds.
+ *
+ *        For an audio function, bInterface is the AudioControl interface and
+ *        the streaming interfaces follow it: first the speaker one if bEpOut
+ *        is set, then the microphone one if bEpIn is set.
+ */
+typedef struct _USBDFunctionMap {
+
+    /** First interface of the function */
+    uint8_t bInterface;
+    /** Number of interfaces of the function */
+    uint8_t bNumInterfaces;
+    /** Data IN endpoint number (bulk, interrupt or isochronous), 0 if none */
+    uint8_t bEpIn;
+    /** Data OUT endpoint number, 0 if none */
+    uint8_t bEpOut;
+    /** Interrupt IN notification endpoint (CDC) or isochronous feedback
+        endpoint (audio) number, 0 if none */
+    uint8_t bEpAux;
+    /** Maximum packet size of the data IN endpoint */
+    uint16_t wMaxPacketIn;
+    /** Class-specific descriptor used by the function requests (HID
+        descriptor), 0 if none */
+    const USBGenericDescriptor *pClassDescriptor;
+
+} USBDFunctionMap;
+
 /**
  * \typedef USBDDriverDescriptors
  * \brief List of all descriptors used by a USB device driver. Each descriptor
@@ -98,6 +133,10 @@ typedef struct _USBDDriverDescriptors {
     const uint8_t **pStrings;
     /** Number of string descriptors in list */
     uint8_t numStrings;
+    /** Optional function maps of a composite device, one per function in
+        the order of the functions in the configuration. 0 to parse the
+        configuration descriptors instead. */
+    const USBDFunctionMap *pFunctionMaps;
 
 } USBDDriverDescriptors;
 
@@ -56,6 +56,12 @@
  *        Consts
  *----------------------------------------------------------------------------*/
 
+/** Suspended device keeps the working clock */
+#define USBD_SUSPEND_RUN        0
+/** Suspended device runs from the slow clock, see
+    USBD_HAL_SetSuspendPowerMode() */
+#define USBD_SUSPEND_SLOWCLOCK  1
+
 /*----------------------------------------------------------------------------
  *        Macros
  *----------------------------------------------------------------------------*/
@@ -67,6 +73,16 @@
  *        Types
  *----------------------------------------------------------------------------*/
 
+/** Time spent servicing the USB device interrupt, see USBD_HAL_GetIrqStats() */
+typedef struct _USBDIrqStats {
+    /** Number of interrupts serviced */
+    uint32_t dwCount;
+    /** Core clock cycles spent servicing them */
+    uint32_t dwCycles;
+    /** Longest service, in core clock cycles */
+    uint32_t dwMaxCycles;
+} USBDIrqStats;
+
 /*----------------------------------------------------------------------------
  *        Exported functoins
  *----------------------------------------------------------------------------*/
@@ -94,14 +110,34 @@ extern uint8_t USBD_HAL_SetupMblTransfer(uint8_t bEndpoint,
                                          USBDTransferBuffer * pMbList,
                                          uint16_t mblSize,
                                          uint16_t startOffset);
+extern uint8_t USBD_HAL_StreamStart(uint8_t bEndpoint,
+                                    USBDTransferBuffer * pRing,
+                                    uint16_t ringSize,
+                                    MblTransferCallback fCallback,
+                                    void * pArgument);
+extern uint8_t USBD_HAL_StreamFeed(uint8_t bEndpoint,
+                                   const void * pData,
+                                   uint32_t dLength);
+extern void USBD_HAL_StreamStop(uint8_t bEndpoint);
 extern uint8_t USBD_HAL_Write(uint8_t bEndpoint,
                               const void * pData,
                               uint32_t dLength);
 extern uint8_t USBD_HAL_Read(uint8_t bEndpoint,
                              void * pData,
                              uint32_t dLength);
+extern uint8_t USBD_HAL_WriteList(uint8_t bEndpoint,
+                                  USBDTransferBuffer * pList,
+                                  uint16_t listSize);
+extern uint8_t USBD_HAL_ReadList(uint8_t bEndpoint,
+                                 USBDTransferBuffer * pList,
+                                 uint16_t listSize);
 extern uint8_t USBD_HAL_Stall(uint8_t bEP);
 extern uint8_t USBD_HAL_Halt(uint8_t bEndpoint,uint8_t ctl);
+extern void USBD_HAL_SetDeferredIrq(uint8_t bDefer);
+extern void USBD_HAL_SetSuspendPowerMode(uint8_t bMode);
+extern void USBD_HAL_EnableIrqStats(uint8_t bEnable);
+extern void USBD_HAL_GetIrqStats(USBDIrqStats *pStats, uint8_t bReset);
+extern void USBD_HAL_GetEPStats(USBDEPStats *pStats, uint8_t bReset);
 /**@}*/
 
 #endif // #define USBD_HAL_H
@@ -199,6 +199,25 @@
 #define USBEndpointDescriptor_INTERRUPT     3
 /**         @}*/
 
+/** \addtogroup usb_ep_iso USB Isochronous Endpoint attributes
+ *          @{
+ *  This section lists the synchronization and usage types of isochronous
+ *  endpoints, to be combined with \ref USBEndpointDescriptor_ISOCHRONOUS.
+ *  - \ref USBEndpointDescriptor_ASYNCHRONOUS
+ *  - \ref USBEndpointDescriptor_ADAPTIVE
+ *  - \ref USBEndpointDescriptor_SYNCHRONOUS
+ *  - \ref USBEndpointDescriptor_FEEDBACK
+ */
+/**  Asynchronous endpoint. */
+#define USBEndpointDescriptor_ASYNCHRONOUS  (1 << 2)
+/**  Adaptive endpoint. */
+#define USBEndpointDescriptor_ADAPTIVE      (2 << 2)
+/**  Synchronous endpoint. */
+#define USBEndpointDescriptor_SYNCHRONOUS   (3 << 2)
+/**  Feedback endpoint. */
+#define USBEndpointDescriptor_FEEDBACK      (1 << 4)
+/**         @}*/
+
 /** \addtogroup usb_ep_size USB Endpoint maximun sizes
  *          @{
  *  This section lists definitions of USB endpoint maximun sizes.
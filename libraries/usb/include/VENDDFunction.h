@@ -0,0 +1,215 @@
+/* ----------------------------------------------------------------------------
+ *         ATMEL Microcontroller Software Support
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2008, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file
+ *  Definition of a class for implementing a USB device vendor-specific
+ *  bulk function: a raw pipe in each direction, without class protocol.
+ *
+ *  The function answers the Microsoft OS descriptor requests (string 0xEE,
+ *  extended compat ID and extended properties), so that Windows binds the
+ *  WinUSB driver to it without an INF file; libusb then opens it on all the
+ *  hosts.
+ *
+ *  The bulk IN endpoint is run in the HAL streaming mode: the buffers given
+ *  to VENDDFunction_Write() are packed back-to-back in both FIFO banks, a
+ *  short packet only ending the data when the writer underruns. The bulk
+ *  OUT endpoint is kept armed with the buffers given to
+ *  VENDDFunction_Read(), the next one being started from the completion of
+ *  the previous one while the second FIFO bank holds the incoming packet.
+ */
+
+#ifndef _VENDDFUNCTION_H_
+#define _VENDDFUNCTION_H_
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+/* These headers were introduced in C99
+   by working group ISO/IEC JTC1/SC22/WG14. */
+#include <stdint.h>
+
+#include <USBRequests.h>
+#include <USBD.h>
+#include <USBDDriver.h>
+/** \addtogroup usbd_vendor
+ *@{
+ */
+
+/*------------------------------------------------------------------------------
+ *         Defines
+ *------------------------------------------------------------------------------*/
+
+/** \addtogroup usbd_vendor_desc USB Device Vendor Function Descriptor Values
+ *      @{
+ */
+/** Vendor specific interface class */
+#define VENDDFunction_CLASS                     0xFF
+/** Index of the Microsoft OS string descriptor */
+#define VENDDFunction_MSOS_STRINGINDEX          0xEE
+/** wIndex of the extended compat ID OS feature descriptor request */
+#define VENDDFunction_MSOS_COMPATID             0x0004
+/** wIndex of the extended properties OS feature descriptor request */
+#define VENDDFunction_MSOS_PROPERTIES           0x0005
+/**     @}*/
+
+/** Vendor request code returned in the Microsoft OS string descriptor */
+#ifndef VENDDFunction_MSOS_VENDORCODE
+#define VENDDFunction_MSOS_VENDORCODE           0x20
+#endif
+
+/** Number of buffers queued at most on the bulk IN stream */
+#ifndef VENDDFunction_IN_BUFFERS
+#define VENDDFunction_IN_BUFFERS                4
+#endif
+
+/** Number of buffers queued at most on the bulk OUT endpoint */
+#ifndef VENDDFunction_OUT_BUFFERS
+#define VENDDFunction_OUT_BUFFERS               4
+#endif
+
+/** Size of the Microsoft OS string descriptor */
+#define VENDDFunction_MSOS_STRINGSIZE           18
+/** Size of the extended compat ID descriptor (one function section) */
+#define VENDDFunction_MSOS_COMPATIDSIZE         40
+/** Size of the extended properties descriptor (DeviceInterfaceGUID) */
+#define VENDDFunction_MSOS_PROPERTIESSIZE       142
+
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+/**
+ * Callback invoked when a buffer given to VENDDFunction_Write() or
+ * VENDDFunction_Read() is done with, from the USB interrupt.
+ * \param pArg     Callback argument.
+ * \param pBuffer  Pointer to the buffer.
+ * \param dwLength Bytes sent or received, 0 if the transfer was aborted.
+ */
+typedef void (*VENDDFunctionCallback)(void *pArg,
+                                      uint8_t *pBuffer,
+                                      uint32_t dwLength);
+
+/** Buffer queued on a bulk endpoint */
+typedef struct _VENDDBuffer {
+    /** Pointer to the data */
+    uint8_t *pData;
+    /** Size of the data */
+    uint32_t dwSize;
+} VENDDBuffer;
+
+/**
+ * Struct for USB device vendor-specific bulk function.
+ */
+typedef struct _VENDDFunction {
+    /** USB Driver for the %device */
+    USBDDriver *pUsbd;
+    /** Interface number */
+    uint8_t bInterfaceNdx;
+    /** USB bulk IN endpoint address */
+    uint8_t bBulkInPIPE;
+    /** USB bulk OUT endpoint address */
+    uint8_t bBulkOutPIPE;
+    /** 1 once VENDDFunction_Start() has been called */
+    volatile uint8_t bStarted;
+
+    /** Completion callback of the IN buffers */
+    VENDDFunctionCallback fInDone;
+    /** Argument of fInDone */
+    void *pInArg;
+    /** Ring of the IN stream, used by the HAL */
+    USBDTransferBuffer aInRing[VENDDFunction_IN_BUFFERS];
+    /** IN buffers queued, in order */
+    VENDDBuffer aIn[VENDDFunction_IN_BUFFERS];
+    /** Oldest queued IN buffer */
+    volatile uint8_t bInHead;
+    /** Number of queued IN buffers */
+    volatile uint8_t bInCount;
+
+    /** Completion callback of the OUT buffers */
+    VENDDFunctionCallback fOutDone;
+    /** Argument of fOutDone */
+    void *pOutArg;
+    /** OUT buffers queued, in order, the first one being read */
+    VENDDBuffer aOut[VENDDFunction_OUT_BUFFERS];
+    /** Oldest queued OUT buffer */
+    volatile uint8_t bOutHead;
+    /** Number of queued OUT buffers */
+    volatile uint8_t bOutCount;
+
+    /** Bytes sent on the bulk IN endpoint */
+    uint32_t dwInBytes;
+    /** Bytes received on the bulk OUT endpoint */
+    uint32_t dwOutBytes;
+
+    /** Extended compat ID descriptor */
+    uint8_t abCompatId[VENDDFunction_MSOS_COMPATIDSIZE];
+    /** Extended properties descriptor, unused without an interface GUID */
+    uint8_t abProperties[VENDDFunction_MSOS_PROPERTIESSIZE];
+    /** 1 when abProperties holds a DeviceInterfaceGUID */
+    uint8_t bProperties;
+} VENDDFunction;
+
+/*------------------------------------------------------------------------------
+ *         Functions
+ *------------------------------------------------------------------------------*/
+
+extern void VENDDFunction_Initialize(VENDDFunction *pVendd,
+                                     USBDDriver *pUsbd,
+                                     uint8_t bInterface,
+                                     const char *pInterfaceGuid);
+
+extern USBGenericDescriptor * VENDDFunction_ParseInterfaces(
+    VENDDFunction *pVendd,
+    USBGenericDescriptor *pDescriptors, uint32_t dwLength);
+
+extern void VENDDFunction_MapInterfaces(
+    VENDDFunction *pVendd,
+    const USBDFunctionMap *pMap);
+
+extern uint32_t VENDDFunction_RequestHandler(
+    VENDDFunction *pVendd,
+    const USBGenericRequest *pRequest);
+
+extern uint8_t VENDDFunction_Start(VENDDFunction *pVendd,
+                                   VENDDFunctionCallback fInDone,
+                                   void *pInArg,
+                                   VENDDFunctionCallback fOutDone,
+                                   void *pOutArg);
+
+extern void VENDDFunction_Stop(VENDDFunction *pVendd);
+
+extern uint8_t VENDDFunction_Write(VENDDFunction *pVendd,
+                                   void *pData, uint32_t dwSize);
+
+extern uint8_t VENDDFunction_Read(VENDDFunction *pVendd,
+                                  void *pData, uint32_t dwSize);
+
+/**@}*/
+#endif /* #ifndef _VENDDFUNCTION_H_ */